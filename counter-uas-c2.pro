@@ -10,6 +10,9 @@ QT       += core gui widgets network sql multimedia multimediawidgets concurrent
 # Qt 5.15.2 specific modules
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+# QOpenGLWidget and the GL helpers moved to their own modules in Qt 6
+greaterThan(QT_MAJOR_VERSION, 5): QT += opengl openglwidgets
+
 # Optional modules (uncomment if available)
 # QT += positioning location
 
@@ -26,6 +29,21 @@ CONFIG += warn_on
 # any Qt feature that has been marked deprecated
 DEFINES += QT_DEPRECATED_WARNINGS
 
+# CUAS_TRACE_SCOPE hot-path tracing; build with CONFIG+=no_tracing to compile it out
+!no_tracing: DEFINES += COUNTERUAS_TRACING
+
+# Optional MessageProtocol compression codecs beyond zlib, found by pkg-config
+unix:packagesExist(liblz4) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += liblz4
+    DEFINES += HAS_LZ4
+}
+unix:packagesExist(libzstd) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libzstd
+    DEFINES += HAS_ZSTD
+}
+
 # Windows specific settings - create GUI application (not console)
 win32 {
     CONFIG += windows
@@ -42,14 +60,57 @@ SOURCES += \
     src/core/Track.cpp \
     src/core/TrackManager.cpp \
     src/core/ThreatAssessor.cpp \
-    src/core/EngagementManager.cpp
+    src/core/EngagementManager.cpp \
+    src/core/TrackSpatialIndex.cpp \
+    src/core/TrackSnapshot.cpp \
+    src/core/TrackTable.cpp \
+    src/core/TrackChangeSet.cpp \
+    src/core/TrackChangeThrottle.cpp \
+    src/core/FusionEngine.cpp \
+    src/core/ThreatRuleProgram.cpp \
+    src/core/DefendedAssetIndex.cpp \
+    src/core/ThreatPriorityQueue.cpp \
+    src/core/ClosestApproach.cpp \
+    src/core/ThreatAlertStore.cpp \
+    src/core/TentativeTrackPool.cpp \
+    src/core/DetectionMerger.cpp \
+    src/core/WeaponTargetAssigner.cpp \
+    src/core/SnapshotStore.cpp \
+    src/core/InterceptSolver.cpp \
+    src/core/ShardedTrackManager.cpp \
+    src/core/TrackToTrackFusion.cpp \
+    src/core/TrackStateHistory.cpp \
+    src/core/TrackFeatureBank.cpp \
+    src/core/TrackClassifier.cpp \
+    src/core/CoverageService.cpp \
+    src/core/GeofenceIndex.cpp \
+    src/core/TrackSlab.cpp \
+    src/core/SensorResourceManager.cpp \
+    src/core/TrackGroupIndex.cpp \
+    src/core/MhtAssociator.cpp \
+    src/core/ReplicatedAlertLog.cpp
 
 # Sensor module sources
 SOURCES += \
     src/sensors/SensorInterface.cpp \
     src/sensors/RadarSensor.cpp \
     src/sensors/RFDetector.cpp \
-    src/sensors/CameraSystem.cpp
+    src/sensors/CameraSystem.cpp \
+    src/sensors/RadarFrameParser.cpp \
+    src/sensors/ClutterMap.cpp \
+    src/sensors/RFSignatureLibrary.cpp \
+    src/sensors/RFBearingFuser.cpp \
+    src/sensors/SensorTelemetry.cpp \
+    src/sensors/RadarVideoRing.cpp \
+    src/sensors/RadarVideoSource.cpp \
+    src/sensors/RFSerialFramer.cpp \
+    src/sensors/AdsbDecoder.cpp \
+    src/sensors/CooperativeTargetTable.cpp \
+    src/sensors/CooperativeReceiver.cpp \
+    src/sensors/SensorClock.cpp \
+    src/sensors/AsterixDecoder.cpp \
+    src/sensors/AsterixSensor.cpp \
+    src/sensors/CameraModel.cpp
 
 # Video module sources
 SOURCES += \
@@ -63,19 +124,63 @@ SOURCES += \
     src/video/VideoOverlayRenderer.cpp \
     src/video/VideoRecorder.cpp \
     src/video/PTZController.cpp \
-    src/video/CameraSlewController.cpp
+    src/video/CameraSlewController.cpp \
+    src/video/VideoDecoderBackend.cpp \
+    src/video/MatroskaWriter.cpp \
+    src/video/VideoEncoderBackend.cpp \
+    src/video/PacketRingBuffer.cpp \
+    src/video/VideoFrameDistributor.cpp \
+    src/video/MatroskaReader.cpp \
+    src/video/GigETransport.cpp \
+    src/video/RtpStream.cpp \
+    src/video/RtpDepacketizer.cpp \
+    src/video/RtspClient.cpp \
+    src/video/SlewControlLoop.cpp \
+    src/video/CameraScheduler.cpp \
+    src/video/VisualDetector.cpp \
+    src/video/CorrelationTracker.cpp \
+    src/video/RoiTrackingStage.cpp \
+    src/video/SimulatedSceneRenderer.cpp \
+    src/video/VideoService.cpp \
+    src/video/VideoServiceClient.cpp \
+    src/video/RemoteVideoSource.cpp \
+    src/video/PTZCommandScheduler.cpp \
+    src/video/OnvifPtzClient.cpp \
+    src/video/MotionKernels.cpp \
+    src/video/MotionDetector.cpp \
+    src/video/MotionCueStage.cpp \
+    src/video/ThermalProcessor.cpp \
+    src/video/RtpPacketizer.cpp \
+    src/video/VideoRestreamer.cpp \
+    src/video/RecordingStorage.cpp \
+    src/video/KlvEncoder.cpp \
+    src/video/CameraDetectionFuser.cpp \
+    src/video/CaptureService.cpp \
+    src/video/TrackVideoIndex.cpp
 
 # Effector module sources
 SOURCES += \
     src/effectors/EffectorInterface.cpp \
     src/effectors/RFJammer.cpp \
     src/effectors/KineticInterceptor.cpp \
-    src/effectors/DirectedEnergySystem.cpp
+    src/effectors/DirectedEnergySystem.cpp \
+    src/effectors/SpectrumPlanner.cpp
 
 # Network module sources
 SOURCES += \
     src/network/NetworkManager.cpp \
-    src/network/MessageProtocol.cpp
+    src/network/MessageProtocol.cpp \
+    src/network/FrameReader.cpp \
+    src/network/TrackPictureSync.cpp \
+    src/network/MulticastPublisher.cpp \
+    src/network/MulticastSubscriber.cpp \
+    src/network/MetricsExporter.cpp \
+    src/network/SharedMemoryPublisher.cpp \
+    src/network/SharedMemorySubscriber.cpp \
+    src/network/WebViewerFeed.cpp \
+    src/network/LinkCipher.cpp \
+    src/network/CoreClient.cpp \
+    src/network/AlertSync.cpp
 
 # UI module sources
 SOURCES += \
@@ -92,13 +197,36 @@ SOURCES += \
     src/ui/CameraStatusPanel.cpp \
     src/ui/EffectorControlPanel.cpp \
     src/ui/AlertQueue.cpp \
-    src/ui/EngagementDialog.cpp
+    src/ui/EngagementDialog.cpp \
+    src/ui/VideoGLView.cpp \
+    src/ui/TrackGLView.cpp \
+    src/ui/MapTileLoader.cpp \
+    src/ui/MapTileStore.cpp \
+    src/ui/TrackTableModel.cpp \
+    src/ui/UIFrameScheduler.cpp \
+    src/ui/LatencyPanel.cpp \
+    src/ui/VideoTexture.cpp \
+    src/ui/VideoWallView.cpp \
+    src/ui/GeofenceOverlay.cpp \
+    src/ui/TrackLayerRenderer.cpp \
+    src/ui/AlertQueueModel.cpp \
+    src/ui/MemoryPanel.cpp
 
 # Config module sources
 SOURCES += \
     src/config/ConfigManager.cpp \
     src/config/CameraConfig.cpp \
-    src/config/DatabaseManager.cpp
+    src/config/DatabaseManager.cpp \
+    src/config/TrackHistoryWriter.cpp \
+    src/config/TrackArchive.cpp \
+    src/config/TrackReplayer.cpp \
+    src/config/DetectionLog.cpp \
+    src/config/EventJournal.cpp \
+    src/config/MappedFileUtils.cpp \
+    src/config/CheckpointFile.cpp \
+    src/config/FusionCheckpointer.cpp \
+    src/config/RetentionPurger.cpp \
+    src/config/DatabaseReadPool.cpp
 
 # Utils module sources
 SOURCES += \
@@ -106,7 +234,41 @@ SOURCES += \
     src/utils/TimeUtils.cpp \
     src/utils/FrameBuffer.cpp \
     src/utils/Logger.cpp \
-    src/utils/KalmanFilter.cpp
+    src/utils/KalmanFilter.cpp \
+    src/utils/AssignmentSolver.cpp \
+    src/utils/KalmanFilterBank.cpp \
+    src/utils/ImmFilterBank.cpp \
+    src/utils/ConnectionPool.cpp \
+    src/utils/FramePool.cpp \
+    src/utils/VideoFrame.cpp \
+    src/utils/FrameRing.cpp \
+    src/utils/LabelDeclutter.cpp \
+    src/utils/Clock.cpp \
+    src/utils/TimerWheel.cpp \
+    src/utils/Trace.cpp \
+    src/utils/LatencyHistogram.cpp \
+    src/utils/PipelineLatency.cpp \
+    src/utils/MetricsRegistry.cpp \
+    src/utils/LocalTangentPlane.cpp \
+    src/utils/ScreenPickIndex.cpp \
+    src/utils/DatagramReceiver.cpp \
+    src/utils/TerrainModel.cpp \
+    src/utils/CoverageRaster.cpp \
+    src/utils/DemTileStore.cpp \
+    src/utils/TaskScheduler.cpp \
+    src/utils/TimerService.cpp \
+    src/utils/ThreadPlacement.cpp \
+    src/utils/MemoryGovernor.cpp \
+    src/utils/OverloadController.cpp \
+    src/utils/EngagementEnvelope.cpp \
+    src/utils/ChaCha20Poly1305.cpp \
+    src/utils/JsonWriter.cpp \
+    src/utils/JsonReader.cpp \
+    src/utils/LogStore.cpp \
+    src/utils/MemoryAccounting.cpp \
+    src/utils/RawCapture.cpp \
+    src/utils/StatusBoard.cpp \
+    src/utils/FlightRecorder.cpp
 
 # Simulator module sources
 SOURCES += \
@@ -114,7 +276,12 @@ SOURCES += \
     src/simulators/TrackSimulator.cpp \
     src/simulators/VideoSimulator.cpp \
     src/simulators/EffectorSimulator.cpp \
-    src/simulators/SystemSimulationManager.cpp
+    src/simulators/SystemSimulationManager.cpp \
+    src/simulators/ReplayEngine.cpp \
+    src/simulators/TargetSwarm.cpp \
+    src/simulators/RaidScript.cpp \
+    src/simulators/RawCaptureReplayer.cpp \
+    src/simulators/InterceptorFlights.cpp
 
 # Dialog sources
 SOURCES += \
@@ -129,14 +296,59 @@ HEADERS += \
     src/core/Track.h \
     src/core/TrackManager.h \
     src/core/ThreatAssessor.h \
-    src/core/EngagementManager.h
+    src/core/EngagementManager.h \
+    src/core/TrackSpatialIndex.h \
+    src/core/TrackSnapshot.h \
+    src/core/TrackTable.h \
+    src/core/TrackHandle.h \
+    src/core/TrackChangeSet.h \
+    src/core/TrackChangeThrottle.h \
+    src/core/FusionEngine.h \
+    src/core/ThreatRuleProgram.h \
+    src/core/DefendedAssetIndex.h \
+    src/core/ThreatPriorityQueue.h \
+    src/core/ClosestApproach.h \
+    src/core/ThreatAlertStore.h \
+    src/core/TentativeTrackPool.h \
+    src/core/DetectionMerger.h \
+    src/core/WeaponTargetAssigner.h \
+    src/core/SnapshotStore.h \
+    src/core/InterceptSolver.h \
+    src/core/ShardedTrackManager.h \
+    src/core/TrackToTrackFusion.h \
+    src/core/TrackStateHistory.h \
+    src/core/TrackFeatureBank.h \
+    src/core/TrackClassifier.h \
+    src/core/CoverageService.h \
+    src/core/GeofenceIndex.h \
+    src/core/TrackSlab.h \
+    src/core/SensorResourceManager.h \
+    src/core/FusionPolicy.h \
+    src/core/TrackGroupIndex.h \
+    src/core/MhtAssociator.h \
+    src/core/ReplicatedAlertLog.h
 
 # Sensor module headers
 HEADERS += \
     src/sensors/SensorInterface.h \
     src/sensors/RadarSensor.h \
     src/sensors/RFDetector.h \
-    src/sensors/CameraSystem.h
+    src/sensors/CameraSystem.h \
+    src/sensors/RadarFrameParser.h \
+    src/sensors/ClutterMap.h \
+    src/sensors/RFSignatureLibrary.h \
+    src/sensors/RFBearingFuser.h \
+    src/sensors/SensorTelemetry.h \
+    src/sensors/RadarVideoRing.h \
+    src/sensors/RadarVideoSource.h \
+    src/sensors/RFSerialFramer.h \
+    src/sensors/AdsbDecoder.h \
+    src/sensors/CooperativeTargetTable.h \
+    src/sensors/CooperativeReceiver.h \
+    src/sensors/SensorClock.h \
+    src/sensors/AsterixDecoder.h \
+    src/sensors/AsterixSensor.h \
+    src/sensors/CameraModel.h
 
 # Video module headers
 HEADERS += \
@@ -150,19 +362,63 @@ HEADERS += \
     src/video/VideoOverlayRenderer.h \
     src/video/VideoRecorder.h \
     src/video/PTZController.h \
-    src/video/CameraSlewController.h
+    src/video/CameraSlewController.h \
+    src/video/VideoDecoderBackend.h \
+    src/video/MatroskaWriter.h \
+    src/video/VideoEncoderBackend.h \
+    src/video/PacketRingBuffer.h \
+    src/video/VideoFrameDistributor.h \
+    src/video/MatroskaReader.h \
+    src/video/GigETransport.h \
+    src/video/RtpStream.h \
+    src/video/RtpDepacketizer.h \
+    src/video/RtspClient.h \
+    src/video/SlewControlLoop.h \
+    src/video/CameraScheduler.h \
+    src/video/VisualDetector.h \
+    src/video/CorrelationTracker.h \
+    src/video/RoiTrackingStage.h \
+    src/video/SimulatedSceneRenderer.h \
+    src/video/VideoService.h \
+    src/video/VideoServiceClient.h \
+    src/video/RemoteVideoSource.h \
+    src/video/PTZCommandScheduler.h \
+    src/video/OnvifPtzClient.h \
+    src/video/MotionKernels.h \
+    src/video/MotionDetector.h \
+    src/video/MotionCueStage.h \
+    src/video/ThermalProcessor.h \
+    src/video/RtpPacketizer.h \
+    src/video/VideoRestreamer.h \
+    src/video/RecordingStorage.h \
+    src/video/KlvEncoder.h \
+    src/video/CameraDetectionFuser.h \
+    src/video/CaptureService.h \
+    src/video/TrackVideoIndex.h
 
 # Effector module headers
 HEADERS += \
     src/effectors/EffectorInterface.h \
     src/effectors/RFJammer.h \
     src/effectors/KineticInterceptor.h \
-    src/effectors/DirectedEnergySystem.h
+    src/effectors/DirectedEnergySystem.h \
+    src/effectors/SpectrumPlanner.h
 
 # Network module headers
 HEADERS += \
     src/network/NetworkManager.h \
-    src/network/MessageProtocol.h
+    src/network/MessageProtocol.h \
+    src/network/FrameReader.h \
+    src/network/TrackPictureSync.h \
+    src/network/MulticastPublisher.h \
+    src/network/MulticastSubscriber.h \
+    src/network/MetricsExporter.h \
+    src/network/SharedMemoryPublisher.h \
+    src/network/SharedMemorySubscriber.h \
+    src/network/WebViewerFeed.h \
+    src/network/LinkCipher.h \
+    src/network/CoreClient.h \
+    src/network/AlertSync.h
 
 # UI module headers
 HEADERS += \
@@ -179,13 +435,36 @@ HEADERS += \
     src/ui/CameraStatusPanel.h \
     src/ui/EffectorControlPanel.h \
     src/ui/AlertQueue.h \
-    src/ui/EngagementDialog.h
+    src/ui/EngagementDialog.h \
+    src/ui/VideoGLView.h \
+    src/ui/TrackGLView.h \
+    src/ui/MapTileLoader.h \
+    src/ui/MapTileStore.h \
+    src/ui/TrackTableModel.h \
+    src/ui/UIFrameScheduler.h \
+    src/ui/LatencyPanel.h \
+    src/ui/VideoTexture.h \
+    src/ui/VideoWallView.h \
+    src/ui/GeofenceOverlay.h \
+    src/ui/TrackLayerRenderer.h \
+    src/ui/AlertQueueModel.h \
+    src/ui/MemoryPanel.h
 
 # Config module headers
 HEADERS += \
     src/config/ConfigManager.h \
     src/config/CameraConfig.h \
-    src/config/DatabaseManager.h
+    src/config/DatabaseManager.h \
+    src/config/TrackHistoryWriter.h \
+    src/config/TrackArchive.h \
+    src/config/TrackReplayer.h \
+    src/config/DetectionLog.h \
+    src/config/EventJournal.h \
+    src/config/MappedFileUtils.h \
+    src/config/CheckpointFile.h \
+    src/config/FusionCheckpointer.h \
+    src/config/RetentionPurger.h \
+    src/config/DatabaseReadPool.h
 
 # Utils module headers
 HEADERS += \
@@ -193,7 +472,47 @@ HEADERS += \
     src/utils/TimeUtils.h \
     src/utils/FrameBuffer.h \
     src/utils/Logger.h \
-    src/utils/KalmanFilter.h
+    src/utils/KalmanFilter.h \
+    src/utils/AssignmentSolver.h \
+    src/utils/RingBuffer.h \
+    src/utils/KalmanFilterBank.h \
+    src/utils/ImmFilterBank.h \
+    src/utils/BoundedQueue.h \
+    src/utils/LatencyStats.h \
+    src/utils/ConnectionPool.h \
+    src/utils/FramePool.h \
+    src/utils/VideoFrame.h \
+    src/utils/SpscRing.h \
+    src/utils/FrameRing.h \
+    src/utils/LabelDeclutter.h \
+    src/utils/Clock.h \
+    src/utils/FastRandom.h \
+    src/utils/TimerWheel.h \
+    src/utils/IntervalTree.h \
+    src/utils/Trace.h \
+    src/utils/LatencyHistogram.h \
+    src/utils/PipelineLatency.h \
+    src/utils/MetricsRegistry.h \
+    src/utils/LocalTangentPlane.h \
+    src/utils/ScreenPickIndex.h \
+    src/utils/DatagramReceiver.h \
+    src/utils/TerrainModel.h \
+    src/utils/CoverageRaster.h \
+    src/utils/DemTileStore.h \
+    src/utils/TaskScheduler.h \
+    src/utils/TimerService.h \
+    src/utils/ThreadPlacement.h \
+    src/utils/MemoryGovernor.h \
+    src/utils/OverloadController.h \
+    src/utils/EngagementEnvelope.h \
+    src/utils/ChaCha20Poly1305.h \
+    src/utils/JsonWriter.h \
+    src/utils/JsonReader.h \
+    src/utils/LogStore.h \
+    src/utils/MemoryAccounting.h \
+    src/utils/RawCapture.h \
+    src/utils/StatusBoard.h \
+    src/utils/FlightRecorder.h
 
 # Simulator module headers
 HEADERS += \
@@ -201,7 +520,12 @@ HEADERS += \
     src/simulators/TrackSimulator.h \
     src/simulators/VideoSimulator.h \
     src/simulators/EffectorSimulator.h \
-    src/simulators/SystemSimulationManager.h
+    src/simulators/SystemSimulationManager.h \
+    src/simulators/ReplayEngine.h \
+    src/simulators/TargetSwarm.h \
+    src/simulators/RaidScript.h \
+    src/simulators/RawCaptureReplayer.h \
+    src/simulators/InterceptorFlights.h
 
 # Dialog headers
 HEADERS += \
@@ -0,0 +1,242 @@
+/**
+ * Counter-UAS C2 core
+ *
+ * Runs sensors, fusion, threat assessment and engagement without a GUI and
+ * serves the track picture to any number of consoles:
+ *
+ *   CounterUAS_Core --scenario swarm.json
+ *   CounterUAS_Core --shm-key site-core --multicast 239.255.42.7:47007
+ *
+ * A console on this host follows it when its core/sharedMemoryKey setting
+ * names the --shm-key; remote consoles set core/multicastGroup and
+ * core/multicastPort to the group. Consoles then show the core's tracks
+ * and run no fusion of their own.
+ *
+ * Site cores of a federation uplink to a regional aggregator, which runs
+ * no sensors and sends the fused regional picture back down:
+ *
+ *   CounterUAS_Core --node-id SITE-3 --uplink region-1:47103
+ *   CounterUAS_Core --aggregator --site site-1:47101 --site site-2:47102 ...
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include "core/CoreService.h"
+#include "core/EngagementManager.h"
+#include "core/RegionalAggregator.h"
+#include "core/TrackManager.h"
+#include "simulators/SensorSimulator.h"
+#include "simulators/SystemSimulationManager.h"
+#include "utils/Logger.h"
+
+using namespace CounterUAS;
+
+namespace {
+
+// host:port into a link; UDP links bind the same port they send to
+bool parseLink(const QString& value, const QString& prefix, bool tcp, ConnectionConfig& link) {
+    const int colon = value.lastIndexOf(':');
+    const int port = colon > 0 ? value.mid(colon + 1).toInt() : 0;
+    if (port <= 0) return false;
+    link.connectionId = prefix + value;
+    link.name = value;
+    link.host = value.left(colon);
+    link.port = port;
+    link.useTcp = tcp;
+    return true;
+}
+
+int runAggregator(QCoreApplication& app, const QCommandLineParser& parser, QTextStream& err) {
+    RegionalAggregatorConfig config;
+    if (parser.isSet("node-id")) config.nodeId = parser.value("node-id");
+    if (parser.isSet("cell-m")) {
+        config.sharding.tileSizeM = qMax(100.0, parser.value("cell-m").toDouble());
+    }
+    if (parser.isSet("shards")) config.sharding.shardCount = qMax(0, parser.value("shards").toInt());
+    if (parser.isSet("regional-ms")) {
+        config.regionalIntervalMs = qMax(100, parser.value("regional-ms").toInt());
+    }
+    if (parser.isSet("keyframe-ms")) {
+        config.keyframeIntervalMs = qMax(100, parser.value("keyframe-ms").toInt());
+    }
+    if (parser.isSet("bandwidth")) {
+        config.syncBandwidthLimit = qMax(0, parser.value("bandwidth").toInt());
+    }
+    if (parser.isSet("multicast")) {
+        const QStringList parts = parser.value("multicast").split(':');
+        config.multicast = true;
+        config.multicastGroup.group = QHostAddress(parts.first());
+        if (parts.size() > 1) config.multicastGroup.port = static_cast<quint16>(parts.last().toUInt());
+        if (config.multicastGroup.group.isNull()) {
+            err << "Not a multicast group: " << parser.value("multicast") << "\n";
+            return 1;
+        }
+    }
+    for (const QString& site : parser.values("site")) {
+        ConnectionConfig link;
+        if (!parseLink(site, "site-", false, link)) {
+            err << "Sites are host:port, not " << site << "\n";
+            return 1;
+        }
+        config.sites.append(link);
+    }
+    if (config.sites.isEmpty()) {
+        err << "An aggregator needs at least one --site\n";
+        return 1;
+    }
+
+    RegionalAggregator aggregator;
+    if (!aggregator.start(config)) {
+        err << "Aggregator failed to start: " << aggregator.errorString() << "\n";
+        return 1;
+    }
+
+    // Per-site lag at a glance; the gauges have it per site
+    QTimer status;
+    QObject::connect(&status, &QTimer::timeout, &aggregator, [&aggregator]() {
+        const RegionalAggregator::Statistics stats = aggregator.statistics();
+        int synced = 0;
+        int stale = 0;
+        for (const RegionalAggregator::SiteStatus& site : aggregator.sites()) {
+            if (site.synced) ++synced;
+            if (site.stale) ++stale;
+        }
+        Logger::instance().info("RegionalAggregator",
+            QString("%1 sites synced, %2 stale, max lag %3 ms; %4 fused, %5 regional tracks")
+                .arg(synced).arg(stale).arg(stats.maxSiteLagMs)
+                .arg(stats.fusedTracks).arg(stats.regionalTracks));
+    });
+    status.start(10000);
+
+    const int result = app.exec();
+    aggregator.stop();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("CounterUAS_Core");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless fusion, threat and engagement core for Counter-UAS C2 consoles.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption({"node-id", "Node id the picture is published under.", "id", "CORE"});
+    parser.addOption({"shm-key", "Shared-memory key local consoles attach to; empty for none.", "key",
+                      SharedMemoryConfig().key});
+    parser.addOption({"multicast", "Sync the picture to remote consoles on this group.", "group:port"});
+    parser.addOption({"peer", "Also sync the picture to this node over TCP; may repeat.", "host:port"});
+    parser.addOption({"uplink", "Sync the picture to a regional aggregator over UDP, the same port at both ends; may repeat.",
+                      "host:port"});
+    parser.addOption({"keyframe-ms", "Sync keyframe interval.", "ms"});
+    parser.addOption({"bandwidth", "Sync bandwidth limit, bytes per second.", "bytes"});
+    parser.addOption({"scenario", "Simulation scenario to run instead of the default.", "file"});
+    parser.addOption({"geofences", "Geofences for the threat rules.", "file"});
+    parser.addOption({"threaded", "Run fusion and sensor I/O on worker threads."});
+    parser.addOption({"capture", "Capture the raw bytes every link reads into this directory.", "dir"});
+    parser.addOption({"aggregator", "Fuse the --site cores' pictures into a regional one instead of running sensors."});
+    parser.addOption({"site", "Site core to aggregate, over UDP, the same port at both ends; may repeat.", "host:port"});
+    parser.addOption({"cell-m", "Aggregator: region cell edge, metres.", "m"});
+    parser.addOption({"shards", "Aggregator: fusion shards, 0 for one per core.", "n"});
+    parser.addOption({"regional-ms", "Aggregator: period of the regional picture sent down.", "ms"});
+    parser.process(app);
+
+    Logger::instance().setLogToConsole(true);
+    QTextStream err(stderr);
+    if (parser.isSet("aggregator")) {
+        return runAggregator(app, parser, err);
+    }
+
+    CoreServiceConfig config;
+    config.nodeId = parser.value("node-id");
+    config.sharedMemory.key = parser.value("shm-key");
+    config.fusion.threaded = parser.isSet("threaded");
+    config.captureDirectory = parser.value("capture");
+    if (parser.isSet("keyframe-ms")) {
+        config.keyframeIntervalMs = qMax(100, parser.value("keyframe-ms").toInt());
+    }
+    if (parser.isSet("bandwidth")) {
+        config.syncBandwidthLimit = qMax(0, parser.value("bandwidth").toInt());
+    }
+    if (parser.isSet("multicast")) {
+        const QStringList parts = parser.value("multicast").split(':');
+        config.multicast = true;
+        config.multicastGroup.group = QHostAddress(parts.first());
+        if (parts.size() > 1) config.multicastGroup.port = static_cast<quint16>(parts.last().toUInt());
+        if (config.multicastGroup.group.isNull()) {
+            err << "Not a multicast group: " << parser.value("multicast") << "\n";
+            return 1;
+        }
+    }
+    for (const QString& peer : parser.values("peer")) {
+        ConnectionConfig connection;
+        if (!parseLink(peer, "peer-", true, connection)) {
+            err << "Peers are host:port, not " << peer << "\n";
+            return 1;
+        }
+        config.peers.append(connection);
+    }
+    for (const QString& uplink : parser.values("uplink")) {
+        ConnectionConfig connection;
+        if (!parseLink(uplink, "uplink-", false, connection)) {
+            err << "Uplinks are host:port, not " << uplink << "\n";
+            return 1;
+        }
+        config.peers.append(connection);
+    }
+    if (parser.isSet("geofences")) {
+        QFile file(parser.value("geofences"));
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "Cannot read geofences from " << file.fileName() << "\n";
+            return 1;
+        }
+        for (const QJsonValue& item : QJsonDocument::fromJson(file.readAll()).object()["geofences"].toArray()) {
+            config.geofences.append(GeofenceZone::fromJson(item.toObject()));
+        }
+    }
+
+    // Sensors and effectors, simulated, wired to the core before it starts
+    CoreService service;
+    SystemSimulationManager simulation;
+    simulation.setTrackManager(service.trackManager());
+    simulation.setThreatAssessor(service.threatAssessor());
+    simulation.setEngagementManager(service.engagementManager());
+    if (parser.isSet("scenario")) {
+        simulation.loadScenario(parser.value("scenario"));
+    }
+    simulation.createFullSimulationEnvironment();
+    if (SensorSimulator* sensors = simulation.sensorSimulator()) {
+        sensors->setFusionEngine(service.fusionEngine());
+    }
+
+    // The installation the consoles defend, at the scenario's base
+    DefendedAsset base;
+    base.id = "BASE-01";
+    base.name = "Main Installation";
+    base.position = simulation.basePosition();
+    base.criticalRadiusM = 500.0;
+    base.warningRadiusM = 1500.0;
+    base.priorityLevel = 5;
+    config.defendedAssets.append(base);
+
+    if (!service.start(config)) {
+        err << "Core failed to start: " << service.errorString() << "\n";
+        return 1;
+    }
+    simulation.start();
+
+    const int result = app.exec();
+    simulation.stop();
+    service.stop();
+    return result;
+}
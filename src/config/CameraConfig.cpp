@@ -82,12 +82,21 @@ CameraDefinition CameraConfig::fromJson(const QJsonObject& json) {
     cam.cameraId = json["cameraId"].toString();
     cam.name = json["name"].toString();
     cam.streamUrl = json["streamUrl"].toString();
+    for (const QJsonValue& value : json["profiles"].toArray()) {
+        const QJsonObject p = value.toObject();
+        StreamProfile profile;
+        profile.name = p["name"].toString();
+        profile.streamUrl = p["streamUrl"].toString();
+        profile.resolution = QSize(p["width"].toInt(), p["height"].toInt());
+        cam.profiles.append(profile);
+    }
     cam.sourceType = json["sourceType"].toString("RTSP");
     cam.position = GeoPosition::fromJson(json["position"].toObject());
     cam.hasPTZ = json["hasPTZ"].toBool();
     cam.ptzProtocol = json["ptzProtocol"].toString();
     cam.ptzAddress = json["ptzAddress"].toString();
     cam.ptzPort = json["ptzPort"].toInt(80);
+    cam.metadata = json["metadata"].toObject().toVariantMap();
     return cam;
 }
 
@@ -96,12 +105,27 @@ QJsonObject CameraConfig::toJson(const CameraDefinition& camera) {
     json["cameraId"] = camera.cameraId;
     json["name"] = camera.name;
     json["streamUrl"] = camera.streamUrl;
+    if (!camera.profiles.isEmpty()) {
+        QJsonArray profiles;
+        for (const StreamProfile& profile : camera.profiles) {
+            QJsonObject p;
+            p["name"] = profile.name;
+            p["streamUrl"] = profile.streamUrl;
+            p["width"] = profile.resolution.width();
+            p["height"] = profile.resolution.height();
+            profiles.append(p);
+        }
+        json["profiles"] = profiles;
+    }
     json["sourceType"] = camera.sourceType;
     json["position"] = camera.position.toJson();
     json["hasPTZ"] = camera.hasPTZ;
     json["ptzProtocol"] = camera.ptzProtocol;
     json["ptzAddress"] = camera.ptzAddress;
     json["ptzPort"] = camera.ptzPort;
+    if (!camera.metadata.isEmpty()) {
+        json["metadata"] = QJsonObject::fromVariantMap(camera.metadata);
+    }
     return json;
 }
 
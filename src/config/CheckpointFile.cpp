@@ -0,0 +1,222 @@
+#include "config/CheckpointFile.h"
+#include "config/MappedFileUtils.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 CHECKPOINT_MAGIC = 0x4B435543;   // "CUCK"
+constexpr quint32 CHECKPOINT_VERSION = 1;
+constexpr qint64 FILE_HEADER_BYTES = 4096;         // One page, so a flip touches one page
+constexpr qint64 RECORD_HEADER_BYTES = 32;
+constexpr qint64 MIN_REGION_BYTES = 64 * 1024;
+
+// File header, little-endian:
+//   0 u32 magic   4 u32 version   8 u64 region bytes
+//  16 u32 active region           20 u32 reserved
+//  24 u64 generation of region 0  32 u64 generation of region 1
+//
+// Record, little-endian:
+//   0 u32 record bytes (multiple of 8)   4 u32 CRC-32 of bytes 8..end
+//   8 u64 generation                    16 u64 key
+//  24 u32 payload bytes                 28 u32 reserved
+//  32 payload, zero padded
+
+// Length of the valid record at offset, 0 at the end of the valid data
+qint64 validRecordAt(const uchar* base, qint64 size, qint64 offset, quint64 generation) {
+    if (offset + RECORD_HEADER_BYTES > size) return 0;
+    const uchar* p = base + offset;
+    const qint64 bytes = qFromLittleEndian<quint32>(p);
+    if (bytes < RECORD_HEADER_BYTES || bytes % 8 != 0 || offset + bytes > size) return 0;
+    if (qFromLittleEndian<quint64>(p + 8) != generation) return 0;
+    if (RECORD_HEADER_BYTES + qFromLittleEndian<quint32>(p + 24) > bytes) return 0;
+    if (MappedFileUtils::crc32(p + 8, bytes - 8) != qFromLittleEndian<quint32>(p + 4)) return 0;
+    return bytes;
+}
+
+} // namespace
+
+CheckpointFile::CheckpointFile(qint64 regionBytes)
+    : m_regionBytes(qMax(MIN_REGION_BYTES, MappedFileUtils::align8(regionBytes)))
+{
+}
+
+CheckpointFile::~CheckpointFile() {
+    close();
+}
+
+bool CheckpointFile::open(const QString& path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    // Adopt an existing file's geometry if its header is sound
+    bool valid = false;
+    const qint64 size = m_file.size();
+    if (size >= FILE_HEADER_BYTES) {
+        uchar header[40];
+        if (m_file.read(reinterpret_cast<char*>(header), sizeof(header)) == sizeof(header) &&
+            qFromLittleEndian<quint32>(header) == CHECKPOINT_MAGIC &&
+            qFromLittleEndian<quint32>(header + 4) == CHECKPOINT_VERSION &&
+            qFromLittleEndian<quint32>(header + 16) < 2) {
+            const qint64 regionBytes = static_cast<qint64>(qFromLittleEndian<quint64>(header + 8));
+            if (regionBytes >= MIN_REGION_BYTES && regionBytes % 8 == 0 &&
+                size == FILE_HEADER_BYTES + 2 * regionBytes) {
+                m_regionBytes = regionBytes;
+                valid = true;
+            }
+        }
+    }
+    if (!valid && (!m_file.resize(0) || !m_file.resize(FILE_HEADER_BYTES + 2 * m_regionBytes))) {
+        m_error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_data = m_file.map(0, FILE_HEADER_BYTES + 2 * m_regionBytes);
+    if (!m_data) {
+        m_error = "Cannot map " + path + ": " + m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    if (!valid && !initialize()) return false;
+
+    m_active = static_cast<int>(qFromLittleEndian<quint32>(m_data + 16));
+    m_generation = qFromLittleEndian<quint64>(m_data + 24 + 8 * m_active);
+
+    // Appends resume after the last valid record
+    const uchar* base = region(m_active);
+    m_writeOffset = 0;
+    while (const qint64 bytes = validRecordAt(base, m_regionBytes, m_writeOffset, m_generation)) {
+        m_writeOffset += bytes;
+    }
+    m_syncedOffset = m_writeOffset;
+    m_error.clear();
+    return true;
+}
+
+void CheckpointFile::close() {
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    if (m_file.isOpen()) m_file.close();
+    m_writeOffset = 0;
+    m_syncedOffset = 0;
+}
+
+bool CheckpointFile::initialize() {
+    std::memset(m_data, 0, FILE_HEADER_BYTES);
+    qToLittleEndian<quint32>(CHECKPOINT_MAGIC, m_data);
+    qToLittleEndian<quint32>(CHECKPOINT_VERSION, m_data + 4);
+    qToLittleEndian<quint64>(static_cast<quint64>(m_regionBytes), m_data + 8);
+    qToLittleEndian<quint64>(1, m_data + 24);
+    writeHeader(0);
+    MappedFileUtils::flushFile(m_file.handle());
+    return true;
+}
+
+qint64 CheckpointFile::regionOffset(int index) const {
+    return FILE_HEADER_BYTES + index * m_regionBytes;
+}
+
+uchar* CheckpointFile::region(int index) const {
+    return m_data + regionOffset(index);
+}
+
+void CheckpointFile::writeHeader(int active) {
+    qToLittleEndian<quint32>(static_cast<quint32>(active), m_data + 16);
+    MappedFileUtils::flushMapped(m_data, 0, FILE_HEADER_BYTES, m_file.handle());
+}
+
+QHash<quint64, QByteArray> CheckpointFile::load() const {
+    QHash<quint64, QByteArray> records;
+    if (!m_data) return records;
+
+    const uchar* base = region(m_active);
+    qint64 offset = 0;
+    while (const qint64 bytes = validRecordAt(base, m_regionBytes, offset, m_generation)) {
+        const uchar* p = base + offset;
+        const quint64 key = qFromLittleEndian<quint64>(p + 16);
+        const int payloadBytes = static_cast<int>(qFromLittleEndian<quint32>(p + 24));
+        if (payloadBytes == 0) {
+            records.remove(key);
+        } else {
+            records.insert(key, QByteArray(reinterpret_cast<const char*>(p + RECORD_HEADER_BYTES),
+                                           payloadBytes));
+        }
+        offset += bytes;
+    }
+    return records;
+}
+
+qint64 CheckpointFile::writeRecord(uchar* base, qint64 offset, quint64 generation,
+                                   quint64 key, const QByteArray& payload) const {
+    const qint64 bytes = MappedFileUtils::align8(RECORD_HEADER_BYTES + payload.size());
+    if (offset + bytes > m_regionBytes) return 0;
+
+    uchar* p = base + offset;
+    qToLittleEndian<quint64>(generation, p + 8);
+    qToLittleEndian<quint64>(key, p + 16);
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), p + 24);
+    qToLittleEndian<quint32>(0, p + 28);
+    std::memcpy(p + RECORD_HEADER_BYTES, payload.constData(), static_cast<size_t>(payload.size()));
+    std::memset(p + RECORD_HEADER_BYTES + payload.size(), 0,
+                static_cast<size_t>(bytes - RECORD_HEADER_BYTES - payload.size()));
+    qToLittleEndian<quint32>(MappedFileUtils::crc32(p + 8, bytes - 8), p + 4);
+    // The length last: until it lands, the record reads as torn
+    qToLittleEndian<quint32>(static_cast<quint32>(bytes), p);
+    return bytes;
+}
+
+bool CheckpointFile::append(quint64 key, const QByteArray& payload) {
+    if (!m_data) return false;
+    const qint64 bytes = writeRecord(region(m_active), m_writeOffset, m_generation, key, payload);
+    if (bytes == 0) return false;
+    m_writeOffset += bytes;
+    return true;
+}
+
+bool CheckpointFile::compact(const QHash<quint64, QByteArray>& records) {
+    if (!m_data) return false;
+
+    const int target = 1 - m_active;
+    const quint64 generation = m_generation + 1;
+    uchar* base = region(target);
+    qint64 offset = 0;
+    for (auto it = records.constBegin(); it != records.constEnd(); ++it) {
+        if (it.value().isEmpty()) continue;
+        const qint64 bytes = writeRecord(base, offset, generation, it.key(), it.value());
+        if (bytes == 0) {
+            m_error = "Checkpoint does not fit in a region";
+            return false;
+        }
+        offset += bytes;
+    }
+
+    // The new region is on disk before the header points at it
+    MappedFileUtils::flushMapped(m_data, regionOffset(target), regionOffset(target) + offset,
+                                 m_file.handle());
+    qToLittleEndian<quint64>(generation, m_data + 24 + 8 * target);
+    writeHeader(target);
+
+    m_active = target;
+    m_generation = generation;
+    m_writeOffset = offset;
+    m_syncedOffset = offset;
+    return true;
+}
+
+void CheckpointFile::sync() {
+    if (!m_data) return;
+    const qint64 start = regionOffset(m_active);
+    MappedFileUtils::flushMapped(m_data, start + m_syncedOffset, start + m_writeOffset, m_file.handle());
+    m_syncedOffset = m_writeOffset;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,77 @@
+#ifndef CHECKPOINTFILE_H
+#define CHECKPOINTFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+namespace CounterUAS {
+
+/**
+ * @brief Crash-safe store of keyed records in one memory-mapped file
+ *
+ * A header page is followed by two equal regions, one active. Updates
+ * append to the active region and the newest record of a key wins, an
+ * empty one deleting it. Each record carries its region's generation and a
+ * CRC-32, and its length word is written last, so load() stops at the
+ * first torn or stale record and a crash mid-append loses only that
+ * record. When the active region fills, compact() writes the live records
+ * to the other one under the next generation and only then flips the
+ * header to it; a crash before the flip leaves the old region in force.
+ *
+ * Records live in the page cache as soon as they are copied in, which is
+ * enough to survive the process; sync() is for surviving the machine.
+ * Not thread-safe.
+ */
+class CheckpointFile {
+public:
+    static constexpr qint64 DEFAULT_REGION_BYTES = 16 * 1024 * 1024;
+
+    explicit CheckpointFile(qint64 regionBytes = DEFAULT_REGION_BYTES);
+    ~CheckpointFile();
+
+    CheckpointFile(const CheckpointFile&) = delete;
+    CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+    // Maps the file, creating it if absent or unreadable. An existing
+    // file keeps the region size it was created with.
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+    QString errorString() const { return m_error; }
+
+    // Newest record of every live key in the active region
+    QHash<quint64, QByteArray> load() const;
+
+    // False when the record does not fit in what is left of the region
+    bool append(quint64 key, const QByteArray& payload);
+    // Replaces the contents with these records; false if they do not fit
+    bool compact(const QHash<quint64, QByteArray>& records);
+    void sync();
+
+    qint64 regionBytes() const { return m_regionBytes; }
+    qint64 usedBytes() const { return m_writeOffset; }
+    quint64 generation() const { return m_generation; }
+
+private:
+    qint64 regionOffset(int index) const;   // From the start of the file
+    uchar* region(int index) const;
+    qint64 writeRecord(uchar* base, qint64 offset, quint64 generation,
+                       quint64 key, const QByteArray& payload) const;
+    bool initialize();
+    void writeHeader(int active);
+
+    QFile m_file;
+    uchar* m_data = nullptr;
+    qint64 m_regionBytes;
+    int m_active = 0;
+    quint64 m_generation = 0;
+    qint64 m_writeOffset = 0;       // In the active region
+    qint64 m_syncedOffset = 0;
+    QString m_error;
+};
+
+} // namespace CounterUAS
+
+#endif // CHECKPOINTFILE_H
@@ -3,6 +3,7 @@
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <iterator>
 
 namespace CounterUAS {
 
@@ -31,8 +32,10 @@ bool ConfigManager::loadConfig(const QString& path) {
         return false;
     }
     
+    QMutexLocker locker(&m_mutex);
     m_config = doc.object();
     m_configPath = path;
+    publishLocked(locker);
     
     Logger::instance().info("ConfigManager", "Loaded config: " + path);
     emit configLoaded();
@@ -48,7 +51,9 @@ bool ConfigManager::saveConfig(const QString& path) {
         return false;
     }
     
+    QMutexLocker locker(&m_mutex);
     QJsonDocument doc(m_config);
+    locker.unlock();
     file.write(doc.toJson(QJsonDocument::Indented));
     file.close();
     
@@ -57,6 +62,7 @@ bool ConfigManager::saveConfig(const QString& path) {
 }
 
 bool ConfigManager::loadDefaults() {
+    QMutexLocker locker(&m_mutex);
     m_config = QJsonObject();
     
     // System defaults
@@ -64,6 +70,7 @@ bool ConfigManager::loadDefaults() {
     system["updateRateHz"] = 10;
     system["logLevel"] = "INFO";
     system["logPath"] = "logs/";
+    system["asyncLogging"] = true;
     m_config["system"] = system;
     
     // Track manager defaults
@@ -72,15 +79,46 @@ bool ConfigManager::loadDefaults() {
     trackManager["coastingTimeoutMs"] = 5000;
     trackManager["dropTimeoutMs"] = 15000;
     trackManager["enableKalmanFilter"] = true;
+    trackManager["tieredRates"] = false;
+    trackManager["priorityRateHz"] = 25;
+    trackManager["backgroundRateHz"] = 1;
     m_config["trackManager"] = trackManager;
     
+    // Sensor-to-track pipeline defaults
+    QJsonObject fusion;
+    fusion["threaded"] = false;
+    fusion["queueCapacity"] = 256;
+    m_config["fusion"] = fusion;
+    
     // Threat assessor defaults
     QJsonObject threatAssessor;
     threatAssessor["assessmentIntervalMs"] = 500;
     threatAssessor["highThreatThreshold"] = 4;
     threatAssessor["autoSlewToHighestThreat"] = true;
+    threatAssessor["tieredRates"] = false;
+    threatAssessor["priorityAssessmentHz"] = 20;
+    threatAssessor["backgroundAssessmentHz"] = 1.0;
+    threatAssessor["priorityRangeM"] = 1000.0;
+    threatAssessor["priorityImpactSec"] = 60.0;
+    threatAssessor["backgroundRangeM"] = 3000.0;
     m_config["threatAssessor"] = threatAssessor;
     
+    // Radar dwell and RF/camera cue tasking from the threat queue
+    QJsonObject sensorTasking;
+    sensorTasking["enabled"] = true;
+    sensorTasking["planIntervalMs"] = 500;
+    sensorTasking["maxRequests"] = 8;
+    sensorTasking["minThreatLevel"] = 3;
+    sensorTasking["radarDwells"] = 2;
+    sensorTasking["radarRevisitMs"] = 500;
+    sensorTasking["radarCommandsPerSec"] = 4.0;
+    sensorTasking["rfCueHalfWidthDeg"] = 10.0;
+    sensorTasking["rfCueMs"] = 2000;
+    sensorTasking["rfCommandsPerSec"] = 1.0;
+    sensorTasking["cueCameras"] = false;
+    sensorTasking["cameraCommandsPerSec"] = 0.5;
+    m_config["sensorTasking"] = sensorTasking;
+    
     // Video defaults
     QJsonObject video;
     video["defaultFps"] = 30;
@@ -96,46 +134,206 @@ bool ConfigManager::loadDefaults() {
     map["defaultZoom"] = 15;
     m_config["map"] = map;
     
+    // Database defaults
+    QJsonObject database;
+    database["trackHistoryHz"] = 10;
+    database["historyFlushMs"] = 200;
+    database["historyQueueCapacity"] = 16384;
+    database["trackArchivePartitionMin"] = 10;
+    database["journalCommitMs"] = 20;
+    database["readConnections"] = 2;
+    m_config["database"] = database;
+    
+    // Metrics defaults: Prometheus scrape endpoint, off unless deployed
+    QJsonObject metrics;
+    metrics["enabled"] = false;
+    metrics["port"] = 9464;
+    metrics["bindAddress"] = "0.0.0.0";
+    m_config["metrics"] = metrics;
+    
+    // Thread placement by role: cpus as "2-3,6", empty for any core no
+    // isolated role holds; realtimePriority is SCHED_FIFO 1-99, 0 for none
+    QJsonObject threads;
+    const auto threadRole = [](bool isolated) {
+        QJsonObject role;
+        role["cpus"] = "";
+        role["isolated"] = isolated;
+        role["realtimePriority"] = 0;
+        role["deadlineMs"] = 0.0;
+        return role;
+    };
+    threads["fusion"] = threadRole(true);
+    threads["sensorIo"] = threadRole(false);
+    threads["ptzControl"] = threadRole(true);
+    threads["videoDecode"] = threadRole(false);
+    threads["render"] = threadRole(false);
+    m_config["threads"] = threads;
+    
+    // Memory governor: ceilingMb 0 takes the cgroup limit or physical memory
+    QJsonObject memory;
+    memory["ceilingMb"] = 0;
+    memory["highWaterPercent"] = 85;
+    memory["lowWaterPercent"] = 75;
+    memory["criticalPercent"] = 95;
+    memory["pollMs"] = 1000;
+    memory["logEntriesElevated"] = 2000;
+    memory["logEntriesCritical"] = 200;
+    m_config["memory"] = memory;
+    
+    // Overload control: one load-shedding level per decision window
+    QJsonObject overload;
+    overload["enabled"] = true;
+    overload["windowMs"] = 1000;
+    overload["highUtilization"] = 0.9;
+    overload["lowUtilization"] = 0.6;
+    overload["overrunShare"] = 0.1;
+    overload["escalateWindows"] = 2;
+    overload["recoverWindows"] = 5;
+    overload["secondaryVideoFps"] = 5.0;
+    overload["lowThreatStride"] = 4;
+    overload["coarseDisplayHz"] = 15;
+    m_config["overload"] = overload;
+    
+    publishLocked(locker);
+    emit configLoaded();
     return true;
 }
 
 QVariant ConfigManager::value(const QString& key, const QVariant& defaultValue) const {
-    QStringList parts = key.split('/');
-    QJsonObject current = m_config;
-    
-    for (int i = 0; i < parts.size() - 1; ++i) {
-        if (!current.contains(parts[i])) return defaultValue;
-        current = current[parts[i]].toObject();
-    }
-    
-    if (!current.contains(parts.last())) return defaultValue;
-    return current[parts.last()].toVariant();
+    const std::shared_ptr<const FlatConfig> flat = std::atomic_load(&m_flat);
+    if (!flat) return defaultValue;
+    auto it = flat->constFind(key);
+    return it != flat->constEnd() ? it.value() : defaultValue;
 }
 
 void ConfigManager::setValue(const QString& key, const QVariant& value) {
-    QStringList parts = key.split('/');
-    
-    // Navigate/create path
-    QJsonObject* current = &m_config;
-    for (int i = 0; i < parts.size() - 1; ++i) {
-        if (!current->contains(parts[i])) {
-            current->insert(parts[i], QJsonObject());
-        }
-        QJsonObject child = (*current)[parts[i]].toObject();
-        // This is simplified - in production, need proper nested update
-    }
-    
-    (*current)[parts.last()] = QJsonValue::fromVariant(value);
-    emit configChanged(key);
+    QMutexLocker locker(&m_mutex);
+    if (!insertPath(m_config, key.split('/'), 0, QJsonValue::fromVariant(value))) return;
+    publishLocked(locker);
 }
 
 QJsonObject ConfigManager::section(const QString& name) const {
+    QMutexLocker locker(&m_mutex);
     return m_config.value(name).toObject();
 }
 
 void ConfigManager::setSection(const QString& name, const QJsonObject& section) {
+    QMutexLocker locker(&m_mutex);
     m_config[name] = section;
-    emit configChanged(name);
+    publishLocked(locker);
+}
+
+int ConfigManager::subscribe(const QString& prefix, QObject* context, ChangeCallback callback) {
+    QMutexLocker locker(&m_mutex);
+    Subscription subscription;
+    subscription.id = m_nextSubscriptionId++;
+    subscription.prefix = prefix;
+    subscription.context = context;
+    subscription.callback = std::move(callback);
+    m_subscriptions.append(subscription);
+    return subscription.id;
+}
+
+void ConfigManager::unsubscribe(int subscriptionId) {
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_subscriptions.size(); ++i) {
+        if (m_subscriptions[i].id == subscriptionId) {
+            m_subscriptions.remove(i);
+            return;
+        }
+    }
+}
+
+void ConfigManager::registerCell(const QString& path, const std::shared_ptr<ConfigCellBase>& cell) {
+    QMutexLocker locker(&m_mutex);
+    cell->assign(m_flat ? m_flat->value(path) : QVariant());
+    m_cells[path].append(cell);
+}
+
+void ConfigManager::publishLocked(QMutexLocker& locker) {
+    auto flat = std::make_shared<FlatConfig>();
+    flatten(m_config, QString(), *flat);
+    const std::shared_ptr<const FlatConfig> previous = m_flat;
+    std::atomic_store(&m_flat, std::shared_ptr<const FlatConfig>(flat));
+    
+    // Cells whose keys are gone are dropped along the way
+    for (auto it = m_cells.begin(); it != m_cells.end();) {
+        const QVariant value = flat->value(it.key());
+        QVector<std::weak_ptr<ConfigCellBase>>& cells = it.value();
+        for (int i = cells.size() - 1; i >= 0; --i) {
+            if (auto cell = cells[i].lock()) {
+                cell->assign(value);
+            } else {
+                cells.remove(i);
+            }
+        }
+        it = cells.isEmpty() ? m_cells.erase(it) : std::next(it);
+    }
+    
+    // Leaf keys that were added, removed or changed
+    QStringList changed;
+    const FlatConfig empty;
+    const FlatConfig& before = previous ? *previous : empty;
+    for (auto it = flat->constBegin(); it != flat->constEnd(); ++it) {
+        if (it.value().userType() == QMetaType::QVariantMap) continue;
+        auto old = before.constFind(it.key());
+        if (old == before.constEnd() || old.value() != it.value()) changed.append(it.key());
+    }
+    for (auto it = before.constBegin(); it != before.constEnd(); ++it) {
+        if (it.value().userType() != QMetaType::QVariantMap && !flat->contains(it.key())) {
+            changed.append(it.key());
+        }
+    }
+    
+    QVector<QPair<Subscription, QStringList>> notify;
+    for (int i = m_subscriptions.size() - 1; i >= 0; --i) {
+        const Subscription& subscription = m_subscriptions[i];
+        if (!subscription.context) {
+            m_subscriptions.remove(i);
+            continue;
+        }
+        QStringList keys;
+        for (const QString& key : changed) {
+            if (subscription.prefix.isEmpty() || key == subscription.prefix ||
+                key.startsWith(subscription.prefix + '/')) {
+                keys.append(key);
+            }
+        }
+        if (!keys.isEmpty()) notify.append(qMakePair(subscription, keys));
+    }
+    locker.unlock();
+    
+    for (const auto& entry : notify) {
+        QObject* context = entry.first.context.data();
+        if (!context) continue;
+        const ChangeCallback callback = entry.first.callback;
+        const QStringList keys = entry.second;
+        QMetaObject::invokeMethod(context, [callback, keys]() { callback(keys); }, Qt::AutoConnection);
+    }
+}
+
+void ConfigManager::flatten(const QJsonObject& object, const QString& prefix, FlatConfig& out) {
+    for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+        const QString path = prefix.isEmpty() ? it.key() : prefix + '/' + it.key();
+        out.insert(path, it.value().toVariant());
+        if (it.value().isObject()) {
+            flatten(it.value().toObject(), path, out);
+        }
+    }
+}
+
+bool ConfigManager::insertPath(QJsonObject& object, const QStringList& parts, int index, const QJsonValue& value) {
+    const QString& part = parts[index];
+    if (part.isEmpty()) return false;
+    if (index == parts.size() - 1) {
+        object[part] = value;
+        return true;
+    }
+    // QJsonObject children are values, so the path is rebuilt on the way out
+    QJsonObject child = object.value(part).toObject();
+    if (!insertPath(child, parts, index + 1, value)) return false;
+    object[part] = child;
+    return true;
 }
 
 } // namespace CounterUAS
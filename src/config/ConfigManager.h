@@ -2,40 +2,154 @@
 #define CONFIGMANAGER_H
 
 #include <QObject>
+#include <QHash>
 #include <QJsonObject>
+#include <QMutex>
+#include <QPointer>
+#include <QStringList>
 #include <QVariant>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
 
 namespace CounterUAS {
 
+/**
+ * @brief Resolved value behind a ConfigKey, updated in place on reload
+ */
+class ConfigCellBase {
+public:
+    virtual ~ConfigCellBase() = default;
+    // An invalid value puts the key's default back
+    virtual void assign(const QVariant& value) = 0;
+};
+
+template<typename T, bool Scalar = std::is_arithmetic<T>::value>
+class ConfigCell;
+
+// Numbers and flags are a plain atomic
+template<typename T>
+class ConfigCell<T, true> : public ConfigCellBase {
+public:
+    explicit ConfigCell(T defaultValue) : m_default(defaultValue), m_value(defaultValue) {}
+    void assign(const QVariant& value) override {
+        m_value.store(value.isValid() && value.canConvert<T>() ? value.value<T>() : m_default,
+                      std::memory_order_relaxed);
+    }
+    T get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    const T m_default;
+    std::atomic<T> m_value;
+};
+
+// Anything else is swapped whole, so a reader never sees half an update
+template<typename T>
+class ConfigCell<T, false> : public ConfigCellBase {
+public:
+    explicit ConfigCell(const T& defaultValue)
+        : m_default(defaultValue), m_value(std::make_shared<const T>(defaultValue)) {}
+    void assign(const QVariant& value) override {
+        std::atomic_store(&m_value, std::make_shared<const T>(
+            value.isValid() && value.canConvert<T>() ? value.value<T>() : m_default));
+    }
+    T get() const { return *std::atomic_load(&m_value); }
+
+private:
+    const T m_default;
+    std::shared_ptr<const T> m_value;
+};
+
+/**
+ * @brief Typed handle to one config path, resolved once
+ *
+ * get() is a single atomic load from any thread; the manager updates the
+ * value in place whenever the config is loaded or changed, so a handle
+ * taken at startup always reads the current value.
+ */
+template<typename T>
+class ConfigKey {
+public:
+    ConfigKey() = default;
+    ConfigKey(std::shared_ptr<ConfigCell<T>> cell, const QString& path)
+        : m_cell(std::move(cell)), m_path(path) {}
+
+    T get() const { return m_cell ? m_cell->get() : T(); }
+    operator T() const { return get(); }
+    QString path() const { return m_path; }
+    bool isValid() const { return m_cell != nullptr; }
+
+private:
+    std::shared_ptr<ConfigCell<T>> m_cell;
+    QString m_path;
+};
+
 class ConfigManager : public QObject {
     Q_OBJECT
-    
+
 public:
     static ConfigManager& instance();
-    
+
     bool loadConfig(const QString& path);
     bool saveConfig(const QString& path);
     bool loadDefaults();
-    
+
+    // One hash lookup in the flattened config; safe from any thread
     QVariant value(const QString& key, const QVariant& defaultValue = QVariant()) const;
     void setValue(const QString& key, const QVariant& value);
-    
+
+    // Pre-resolved, typed access for code that reads config repeatedly
+    template<typename T>
+    ConfigKey<T> key(const QString& path, const T& defaultValue = T()) {
+        auto cell = std::make_shared<ConfigCell<T>>(defaultValue);
+        registerCell(path, cell);
+        return ConfigKey<T>(cell, path);
+    }
+
+    // Calls back on context's thread with the leaf keys that changed under
+    // prefix ("" for all of them), once per load or change; dropped with
+    // the context. Returns an id for unsubscribe()
+    using ChangeCallback = std::function<void(const QStringList& keys)>;
+    int subscribe(const QString& prefix, QObject* context, ChangeCallback callback);
+    void unsubscribe(int subscriptionId);
+
     QJsonObject section(const QString& name) const;
     void setSection(const QString& name, const QJsonObject& section);
-    
+
     QString configPath() const { return m_configPath; }
-    
+
 signals:
-    void configChanged(const QString& key);
     void configLoaded();
-    
+
 private:
     ConfigManager();
     ConfigManager(const ConfigManager&) = delete;
     ConfigManager& operator=(const ConfigManager&) = delete;
-    
+
+    using FlatConfig = QHash<QString, QVariant>;
+    struct Subscription {
+        int id;
+        QString prefix;
+        QPointer<QObject> context;
+        ChangeCallback callback;
+    };
+
+    void registerCell(const QString& path, const std::shared_ptr<ConfigCellBase>& cell);
+    // Flattens m_config, updates every cell and notifies the subscribers
+    // of what changed; call with m_mutex held, it is released on return
+    void publishLocked(QMutexLocker& locker);
+    static void flatten(const QJsonObject& object, const QString& prefix, FlatConfig& out);
+    static bool insertPath(QJsonObject& object, const QStringList& parts, int index, const QJsonValue& value);
+
+    mutable QMutex m_mutex;             // m_config, the cells and subscriptions
     QJsonObject m_config;
     QString m_configPath;
+    std::shared_ptr<const FlatConfig> m_flat;
+    QHash<QString, QVector<std::weak_ptr<ConfigCellBase>>> m_cells;
+    QVector<Subscription> m_subscriptions;
+    int m_nextSubscriptionId = 1;
 };
 
 } // namespace CounterUAS
@@ -1,18 +1,126 @@
 #include "config/DatabaseManager.h"
+#include "config/ConfigManager.h"
 #include "utils/Logger.h"
 #include <QSqlError>
 #include <QDir>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 
 namespace CounterUAS {
 
+namespace {
+
+QVector<TrackHistorySample> selectTrackSamples(const QSqlDatabase& db, qint64 startMs, qint64 endMs) {
+    QVector<TrackHistorySample> samples;
+    QSqlQuery query(db);
+    query.prepare(R"(
+        SELECT track_id, timestamp, latitude, longitude, altitude FROM tracks
+        WHERE timestamp BETWEEN ? AND ? ORDER BY timestamp
+    )");
+    query.addBindValue(startMs);
+    query.addBindValue(endMs);
+    
+    if (!query.exec()) {
+        Logger::instance().warning("DatabaseManager", "Failed to load track history: " + query.lastError().text());
+        return samples;
+    }
+    while (query.next()) {
+        TrackHistorySample sample;
+        sample.trackId = query.value(0).toString();
+        sample.timestamp = query.value(1).toLongLong();
+        sample.position.latitude = query.value(2).toDouble();
+        sample.position.longitude = query.value(3).toDouble();
+        sample.position.altitude = query.value(4).toDouble();
+        samples.append(sample);
+    }
+    return samples;
+}
+
+QList<EngagementRecord> selectEngagements(const QSqlDatabase& db, qint64 startMs, qint64 endMs) {
+    QList<EngagementRecord> records;
+    QSqlQuery query(db);
+    query.prepare(R"(
+        SELECT engagement_id, track_id, effector_id, operator_id, start_time, completion_time,
+               state, bda_result, notes
+        FROM engagements WHERE start_time BETWEEN ? AND ? ORDER BY start_time
+    )");
+    query.addBindValue(startMs);
+    query.addBindValue(endMs);
+    
+    if (!query.exec()) {
+        Logger::instance().warning("DatabaseManager", "Failed to load engagements: " + query.lastError().text());
+        return records;
+    }
+    while (query.next()) {
+        EngagementRecord record;
+        record.engagementId = query.value(0).toString();
+        record.trackId = query.value(1).toString();
+        record.effectorId = query.value(2).toString();
+        record.operatorId = query.value(3).toString();
+        record.startTime = QDateTime::fromMSecsSinceEpoch(query.value(4).toLongLong());
+        record.completionTime = QDateTime::fromMSecsSinceEpoch(query.value(5).toLongLong());
+        record.state = static_cast<EngagementState>(query.value(6).toInt());
+        record.bdaResult = static_cast<BDAResult>(query.value(7).toInt());
+        record.notes = query.value(8).toString();
+        records.append(record);
+    }
+    return records;
+}
+
+// Empty when the query was canceled, e.g. by close()
+QVector<VideoSighting> selectVideoSightings(const QSqlDatabase& db, const QString& trackId,
+                                            qint64 startMs, qint64 endMs) {
+    QVector<VideoSighting> sightings;
+    QSqlQuery query(db);
+    query.prepare(R"(
+        SELECT camera_id, start_time, end_time, clip_id, path, byte_offset, offset_time
+        FROM video_sightings
+        WHERE track_id = ? AND start_time BETWEEN ? AND ? AND end_time >= ?
+        ORDER BY start_time
+    )");
+    query.addBindValue(trackId);
+    query.addBindValue(startMs - DatabaseManager::MAX_SIGHTING_MS);
+    query.addBindValue(endMs);
+    query.addBindValue(startMs);
+    
+    if (!query.exec()) {
+        Logger::instance().warning("DatabaseManager", "Failed to load video sightings: " + query.lastError().text());
+        return sightings;
+    }
+    while (query.next()) {
+        VideoSighting sighting;
+        sighting.trackId = trackId;
+        sighting.cameraId = query.value(0).toString();
+        sighting.startMs = query.value(1).toLongLong();
+        sighting.endMs = query.value(2).toLongLong();
+        sighting.clipId = query.value(3).toString();
+        sighting.path = query.value(4).toString();
+        sighting.byteOffset = query.value(5).toLongLong();
+        sighting.offsetTimeMs = query.value(6).toLongLong();
+        sightings.append(sighting);
+    }
+    return sightings;
+}
+
+template <typename T>
+T resultOf(QFuture<T> future) {
+    future.waitForFinished();
+    return future.resultCount() > 0 ? future.result() : T();
+}
+
+} // namespace
+
 DatabaseManager& DatabaseManager::instance() {
     static DatabaseManager instance;
     return instance;
 }
 
-DatabaseManager::DatabaseManager() {}
+DatabaseManager::DatabaseManager()
+    : m_historyWriter(new TrackHistoryWriter)
+    , m_purger(new RetentionPurger)
+    , m_readPool(new DatabaseReadPool)
+{}
 
 DatabaseManager::~DatabaseManager() {
     close();
@@ -37,15 +145,114 @@ bool DatabaseManager::initialize(const QString& path) {
         return false;
     }
     
+    // WAL lets the history writer commit without blocking readers, and with
+    // synchronous=NORMAL a commit does not wait for the disk
+    QSqlQuery pragma;
+    if (!pragma.exec("PRAGMA journal_mode=WAL")) {
+        Logger::instance().warning("DatabaseManager", "WAL journaling unavailable: " + pragma.lastError().text());
+    }
+    pragma.exec("PRAGMA synchronous=NORMAL");
+    
     if (!createTables()) {
         return false;
     }
     
+    TrackHistoryWriterConfig writerConfig;
+    writerConfig.flushIntervalMs = ConfigManager::instance().value("database/historyFlushMs", 200).toInt();
+    writerConfig.queueCapacity = ConfigManager::instance().value("database/historyQueueCapacity", 16384).toInt();
+    
+    if (m_fileStoresAsync) {
+        m_fileStores.wait();
+    } else {
+        openFileStores(path);
+    }
+    
+    // An empty path leaves replay reading the tracks table
+    const QString archivePath = trackArchivePath(path);
+    if (!archivePath.isEmpty()) {
+        writerConfig.archive.directory = archivePath;
+        writerConfig.archive.partitionMs =
+            ConfigManager::instance().value("database/trackArchivePartitionMin", 10).toLongLong() * 60000;
+    }
+    m_historyWriter->setConfig(writerConfig);
+    m_historyWriter->start(path);
+    
+    RetentionPurgeConfig purgeConfig;
+    purgeConfig.batchRows = ConfigManager::instance().value("database/purgeBatchRows", 500).toInt();
+    purgeConfig.pauseMs = ConfigManager::instance().value("database/purgePauseMs", 50).toInt();
+    m_purger->setConfig(purgeConfig);
+    m_purger->start(path);
+    
+    // Opened after the schema, read-only; each reader thread with its own archive reader
+    DatabaseReadPoolConfig readConfig;
+    readConfig.connections = ConfigManager::instance().value("database/readConnections", 2).toInt();
+    if (m_archiveReader) {
+        readConfig.archiveDirectory = m_archiveReader->directory();
+    }
+    m_readPool->setConfig(readConfig);
+    m_readPool->start(path);
+    
     Logger::instance().info("DatabaseManager", "Database initialized: " + path);
     return true;
 }
 
+void DatabaseManager::openFileStoresAsync(const QString& path) {
+    if (m_fileStoresAsync) return;
+    m_fileStoresAsync = true;
+    m_fileStores.add([this, path]() { openFileStores(path); });
+    m_fileStores.run();
+}
+
+QString DatabaseManager::trackArchivePath(const QString& path) const {
+    return ConfigManager::instance().value("database/trackArchivePath",
+                                           QFileInfo(path).absolutePath() + "/track-archive").toString();
+}
+
+void DatabaseManager::openFileStores(const QString& path) {
+    const QString dir = QFileInfo(path).absolutePath();
+    
+    const QString archivePath = trackArchivePath(path);
+    if (!archivePath.isEmpty()) {
+        m_archiveReader.reset(new TrackArchiveReader(archivePath));
+    }
+    
+    m_detectionLogPath = ConfigManager::instance().value("database/detectionLogPath",
+                                                         dir + "/detection-log").toString();
+    if (!m_detectionLogPath.isEmpty()) {
+        m_detectionRecorder.reset(new DetectionRecorder(m_detectionLogPath));
+        m_detectionRecorder->start();
+    }
+    
+    // Recovering the journal's tail is the slow part of startup on a big journal
+    const QString journalPath = ConfigManager::instance().value("database/journalPath",
+                                                                dir + "/journal").toString();
+    if (!journalPath.isEmpty()) {
+        m_journal.reset(new EventJournal(journalPath, EventJournal::DEFAULT_SEGMENT_BYTES,
+            ConfigManager::instance().value("database/journalCommitMs",
+                                            EventJournal::DEFAULT_COMMIT_INTERVAL_MS).toInt()));
+        if (!m_journal->open()) {
+            m_journal.reset();
+        }
+    }
+}
+
 void DatabaseManager::close() {
+    if (m_fileStoresAsync) {
+        m_fileStores.wait();
+    }
+    // Before the writer: queries in flight may be flushing it
+    m_readPool->stop();
+    m_purger->stop();
+    m_historyWriter->stop();
+    m_archiveReader.reset();
+    // Kept until destruction: fusion may still be tapping scans into it,
+    // and signal handlers appending to the journal
+    if (m_detectionRecorder) {
+        m_detectionRecorder->stop();
+    }
+    if (m_journal) {
+        m_journal->close();
+    }
     if (m_db.isOpen()) {
         m_db.close();
     }
@@ -128,9 +335,32 @@ bool DatabaseManager::createTables() {
         return false;
     }
     
-    // Create indices
+    // Video sightings table: track intervals into recorded segments
+    if (!query.exec(R"(
+        CREATE TABLE IF NOT EXISTS video_sightings (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            track_id TEXT NOT NULL,
+            camera_id TEXT NOT NULL,
+            start_time INTEGER NOT NULL,
+            end_time INTEGER NOT NULL,
+            clip_id TEXT NOT NULL,
+            path TEXT,
+            byte_offset INTEGER,
+            offset_time INTEGER
+        )
+    )")) {
+        Logger::instance().error("DatabaseManager", "Failed to create video_sightings table: " + query.lastError().text());
+        return false;
+    }
+    
+    // Create indices; every time-range query and the retention purge go through one
     query.exec("CREATE INDEX IF NOT EXISTS idx_tracks_timestamp ON tracks(timestamp)");
     query.exec("CREATE INDEX IF NOT EXISTS idx_engagements_time ON engagements(start_time)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_engagements_completion ON engagements(completion_time)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_operator_actions_timestamp ON operator_actions(timestamp)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_video_clips_time ON video_clips(start_time)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_video_sightings_track ON video_sightings(track_id, start_time)");
+    query.exec("CREATE INDEX IF NOT EXISTS idx_video_sightings_clip ON video_sightings(clip_id)");
     
     return true;
 }
@@ -140,24 +370,24 @@ void DatabaseManager::saveTrack(const Track& track) {
 }
 
 void DatabaseManager::saveTrackHistory(const QString& trackId, const GeoPosition& pos, qint64 timestamp) {
-    if (!isOpen()) return;
-    
-    QSqlQuery query;
-    query.prepare(R"(
-        INSERT OR REPLACE INTO tracks (track_id, timestamp, latitude, longitude, altitude)
-        VALUES (?, ?, ?, ?, ?)
-    )");
-    query.addBindValue(trackId);
-    query.addBindValue(timestamp);
-    query.addBindValue(pos.latitude);
-    query.addBindValue(pos.longitude);
-    query.addBindValue(pos.altitude);
-    
-    if (!query.exec()) {
-        Logger::instance().warning("DatabaseManager", "Failed to save track: " + query.lastError().text());
+    m_historyWriter->enqueue(trackId, timestamp, pos);
+}
+
+void DatabaseManager::saveTrackPicture(const TrackPicture& picture) {
+    for (const TrackSnapshot& track : picture.tracks) {
+        if (track.state == TrackState::Dropped) continue;
+        m_historyWriter->enqueue(track.trackId, picture.timestampMs, track.position);
     }
 }
 
+void DatabaseManager::flushTrackHistory() {
+    m_historyWriter->flush();
+}
+
+TrackHistoryWriterStats DatabaseManager::trackHistoryStats() const {
+    return m_historyWriter->stats();
+}
+
 void DatabaseManager::saveEngagement(const EngagementRecord& record) {
     if (!isOpen()) return;
     
@@ -183,6 +413,15 @@ void DatabaseManager::saveEngagement(const EngagementRecord& record) {
 }
 
 void DatabaseManager::logOperatorAction(const QString& operatorId, const QString& action, const QVariantMap& details) {
+    const QByteArray detailsJson = QJsonDocument(QJsonObject::fromVariantMap(details)).toJson(QJsonDocument::Compact);
+    if (m_journal) {
+        JournalEvent event;
+        event.type = JournalEventType::OperatorAction;
+        event.subjectId = action;
+        event.actorId = operatorId;
+        event.text = QString::fromUtf8(detailsJson);
+        m_journal->append(event);
+    }
     if (!isOpen()) return;
     
     QSqlQuery query;
@@ -193,7 +432,7 @@ void DatabaseManager::logOperatorAction(const QString& operatorId, const QString
     query.addBindValue(QDateTime::currentMSecsSinceEpoch());
     query.addBindValue(operatorId);
     query.addBindValue(action);
-    query.addBindValue(QJsonDocument(QJsonObject::fromVariantMap(details)).toJson(QJsonDocument::Compact));
+    query.addBindValue(detailsJson);
     
     query.exec();
 }
@@ -203,43 +442,169 @@ void DatabaseManager::saveVideoClipMetadata(const QString& clipId, const QString
     
     QSqlQuery query;
     query.prepare(R"(
-        INSERT OR REPLACE INTO video_clips (clip_id, path, metadata)
-        VALUES (?, ?, ?)
+        INSERT OR REPLACE INTO video_clips (clip_id, path, start_time, duration, camera_id, metadata)
+        VALUES (?, ?, ?, ?, ?, ?)
     )");
     query.addBindValue(clipId);
     query.addBindValue(path);
+    query.addBindValue(metadata.value("startTime"));
+    query.addBindValue(metadata.value("duration"));
+    query.addBindValue(metadata.value("cameraId"));
     query.addBindValue(QJsonDocument(QJsonObject::fromVariantMap(metadata)).toJson(QJsonDocument::Compact));
     
     query.exec();
 }
 
-void DatabaseManager::cleanup(int retentionDays) {
+void DatabaseManager::removeVideoClipMetadata(const QString& clipId) {
     if (!isOpen()) return;
     
-    qint64 cutoffTime = QDateTime::currentMSecsSinceEpoch() - (retentionDays * 86400000LL);
-    
     QSqlQuery query;
-    query.prepare("DELETE FROM tracks WHERE timestamp < ?");
-    query.addBindValue(cutoffTime);
+    query.prepare("DELETE FROM video_clips WHERE clip_id = ?");
+    query.addBindValue(clipId);
     query.exec();
     
-    query.prepare("DELETE FROM operator_actions WHERE timestamp < ?");
-    query.addBindValue(cutoffTime);
+    // The video is gone, and with it what pointed into it
+    query.prepare("DELETE FROM video_sightings WHERE clip_id = ?");
+    query.addBindValue(clipId);
     query.exec();
+}
+
+void DatabaseManager::saveVideoSightings(const QVector<VideoSighting>& sightings) {
+    if (!isOpen() || sightings.isEmpty()) return;
+    
+    m_db.transaction();
+    QSqlQuery query;
+    query.prepare(R"(
+        INSERT INTO video_sightings
+        (track_id, camera_id, start_time, end_time, clip_id, path, byte_offset, offset_time)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+    )");
+    for (const VideoSighting& sighting : sightings) {
+        query.addBindValue(sighting.trackId);
+        query.addBindValue(sighting.cameraId);
+        query.addBindValue(sighting.startMs);
+        query.addBindValue(sighting.endMs);
+        query.addBindValue(sighting.clipId);
+        query.addBindValue(sighting.path);
+        query.addBindValue(sighting.byteOffset);
+        query.addBindValue(sighting.offsetTimeMs);
+        if (!query.exec()) {
+            Logger::instance().warning("DatabaseManager", "Failed to save video sighting: " + query.lastError().text());
+        }
+    }
+    m_db.commit();
+}
+
+QVector<VideoSighting> DatabaseManager::loadVideoSightings(const QString& trackId, qint64 startMs, qint64 endMs) {
+    return resultOf(loadVideoSightingsAsync(trackId, startMs, endMs));
+}
+
+QFuture<QVector<VideoSighting>> DatabaseManager::loadVideoSightingsAsync(const QString& trackId,
+                                                                         qint64 startMs, qint64 endMs) {
+    return m_readPool->run([trackId, startMs, endMs](DatabaseReader& reader) {
+        return selectVideoSightings(reader.db, trackId, startMs, endMs);
+    });
+}
+
+void DatabaseManager::cleanup(int retentionDays) {
+    if (!isOpen()) return;
+    
+    qint64 cutoffTime = QDateTime::currentMSecsSinceEpoch() - (retentionDays * 86400000LL);
+    
+    // Deleting weeks of history in one statement would hold the write lock
+    // for as long, stalling the history writer behind it
+    m_purger->purgeBefore(cutoffTime);
     
-    Logger::instance().info("DatabaseManager", QString("Cleaned up records older than %1 days").arg(retentionDays));
+    if (m_archiveReader) {
+        m_archiveReader->removeBefore(cutoffTime);
+    }
+    if (!m_detectionLogPath.isEmpty()) {
+        DetectionLogReader(m_detectionLogPath).removeBefore(cutoffTime);
+    }
+    
+    Logger::instance().info("DatabaseManager", QString("Purging records older than %1 days").arg(retentionDays));
+}
+
+RetentionPurgeStats DatabaseManager::retentionPurgeStats() const {
+    return m_purger->stats();
 }
 
 QList<Track*> DatabaseManager::loadTrackHistory(const QDateTime& start, const QDateTime& end) {
-    Q_UNUSED(start)
-    Q_UNUSED(end)
-    return QList<Track*>();
+    const QVector<TrackHistorySample> samples =
+        loadTrackSamples(start.toMSecsSinceEpoch(), end.toMSecsSinceEpoch());
+    
+    QHash<QString, int> sampleCounts;
+    for (const TrackHistorySample& sample : samples) {
+        ++sampleCounts[sample.trackId];
+    }
+    
+    QHash<QString, Track*> tracks;
+    QHash<QString, GeoPosition> lastPositions;
+    QList<Track*> result;
+    for (const TrackHistorySample& sample : samples) {
+        Track*& track = tracks[sample.trackId];
+        if (!track) {
+            track = new Track(sample.trackId);
+            track->setHistoryCapacity(sampleCounts.value(sample.trackId));
+            result.append(track);
+        }
+        track->addPositionHistory(sample.position, sample.timestamp);
+        lastPositions[sample.trackId] = sample.position;
+    }
+    for (Track* track : result) {
+        track->setPosition(lastPositions.value(track->trackId()));
+    }
+    return result;
+}
+
+QVector<TrackHistorySample> DatabaseManager::loadTrackSamples(qint64 startMs, qint64 endMs) {
+    if (!isOpen()) return QVector<TrackHistorySample>();
+    return resultOf(loadTrackSamplesAsync(startMs, endMs));
+}
+
+QFuture<QVector<TrackHistorySample>> DatabaseManager::loadTrackSamplesAsync(qint64 startMs, qint64 endMs) {
+    TrackHistoryWriter* writer = m_historyWriter.get();
+    return m_readPool->run([writer, startMs, endMs](DatabaseReader& reader) {
+        // Everything queued by the time the query runs is in the window
+        writer->flush();
+        if (reader.archive) {
+            return reader.archive->load(startMs, endMs);
+        }
+        return selectTrackSamples(reader.db, startMs, endMs);
+    });
+}
+
+qint64 DatabaseManager::readTrackSamples(qint64 startMs, qint64 endMs, const TrackArchiveReader::Visitor& visit) {
+    if (!isOpen()) return 0;
+    if (!m_archiveReader) {
+        const QVector<TrackHistorySample> samples = loadTrackSamples(startMs, endMs);
+        for (const TrackHistorySample& sample : samples) {
+            visit(sample);
+        }
+        return samples.size();
+    }
+    
+    flushTrackHistory();
+    return m_archiveReader->read(startMs, endMs, visit);
+}
+
+void DatabaseManager::recordDetectionScan(const QVector<SensorDetection>& detections) {
+    if (m_detectionRecorder) {
+        m_detectionRecorder->record(QDateTime::currentMSecsSinceEpoch(), detections);
+    }
 }
 
 QList<EngagementRecord> DatabaseManager::loadEngagements(const QDateTime& start, const QDateTime& end) {
-    Q_UNUSED(start)
-    Q_UNUSED(end)
-    return QList<EngagementRecord>();
+    if (!isOpen()) return QList<EngagementRecord>();
+    return resultOf(loadEngagementsAsync(start, end));
+}
+
+QFuture<QList<EngagementRecord>> DatabaseManager::loadEngagementsAsync(const QDateTime& start, const QDateTime& end) {
+    const qint64 startMs = start.toMSecsSinceEpoch();
+    const qint64 endMs = end.toMSecsSinceEpoch();
+    return m_readPool->run([startMs, endMs](DatabaseReader& reader) {
+        return selectEngagements(reader.db, startMs, endMs);
+    });
 }
 
 } // namespace CounterUAS
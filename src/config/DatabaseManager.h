@@ -1,11 +1,21 @@
 #ifndef DATABASEMANAGER_H
 #define DATABASEMANAGER_H
 
+#include <QFuture>
 #include <QObject>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <memory>
 #include "core/Track.h"
+#include "core/TrackSnapshot.h"
 #include "core/EngagementManager.h"
+#include "config/DatabaseReadPool.h"
+#include "config/DetectionLog.h"
+#include "config/EventJournal.h"
+#include "config/RetentionPurger.h"
+#include "config/TrackArchive.h"
+#include "config/TrackHistoryWriter.h"
+#include "utils/TaskScheduler.h"
 
 namespace CounterUAS {
 
@@ -16,26 +26,75 @@ public:
     static DatabaseManager& instance();
     
     bool initialize(const QString& path);
+    // Opens the file-backed stores (track archive, detection log, journal)
+    // on a worker thread, so they come up while the UI is being built;
+    // initialize() with the same path waits for them. The SQL connection
+    // the writes go through belongs to the thread that calls initialize();
+    // reads run on the read pool's connections
+    void openFileStoresAsync(const QString& path);
     void close();
     bool isOpen() const;
     
-    // Track history
+    // Track history. Positions are queued to the history writer thread and
+    // committed in batches; loadTrackSamples() sees everything queued before it.
+    // With the track archive enabled, reads come from it rather than SQL
     void saveTrack(const Track& track);
     void saveTrackHistory(const QString& trackId, const GeoPosition& pos, qint64 timestamp);
+    void saveTrackPicture(const TrackPicture& picture);
+    void flushTrackHistory();
+    TrackHistoryWriterStats trackHistoryStats() const;
+    // One unparented Track per recorded track, its history the window; the
+    // caller owns them
     QList<Track*> loadTrackHistory(const QDateTime& start, const QDateTime& end);
+    // Positions in [startMs, endMs], oldest first, to replay alongside a
+    // recording (FileVideoSource::replayTimeChanged gives its wall clock)
+    QVector<TrackHistorySample> loadTrackSamples(qint64 startMs, qint64 endMs);
+    // Same window without collecting it; returns the samples visited
+    qint64 readTrackSamples(qint64 startMs, qint64 endMs, const TrackArchiveReader::Visitor& visit);
+    bool hasTrackArchive() const { return m_archiveReader != nullptr; }
+    // On a read pool thread; the caller's thread never waits on SQLite or the writer
+    QFuture<QVector<TrackHistorySample>> loadTrackSamplesAsync(qint64 startMs, qint64 endMs);
+    
+    // Sensor scans as submitted to fusion, for ReplayEngine. Any thread;
+    // a no-op with the detection log disabled
+    void recordDetectionScan(const QVector<SensorDetection>& detections);
+    QString detectionLogPath() const { return m_detectionLogPath; }
     
     // Engagements
     void saveEngagement(const EngagementRecord& record);
     QList<EngagementRecord> loadEngagements(const QDateTime& start, const QDateTime& end);
+    QFuture<QList<EngagementRecord>> loadEngagementsAsync(const QDateTime& start, const QDateTime& end);
+    
+    // Read-only connections for queries of any thread, e.g. after-action
+    // reports; the load functions above go through it too
+    DatabaseReadPool* readPool() const { return m_readPool.get(); }
+    DatabaseReadPoolStats readPoolStats() const { return m_readPool->stats(); }
     
-    // Operator actions
+    // Binary audit journal of engagement, alert and track events; null
+    // when disabled. Appends from any thread
+    EventJournal* journal() const { return m_journal.get(); }
+    
+    // Operator actions, journalled as well
     void logOperatorAction(const QString& operatorId, const QString& action, const QVariantMap& details);
     
-    // Video clips
+    // Video clips; cameraId, startTime and duration in the metadata fill their columns
     void saveVideoClipMetadata(const QString& clipId, const QString& path, const QVariantMap& metadata);
+    // Also removes the clip's sightings
+    void removeVideoClipMetadata(const QString& clipId);
+    
+    // Where cameras recorded each track, from TrackVideoIndex; in one
+    // transaction. Sightings are at most MAX_SIGHTING_MS long, so those
+    // meeting a window are found by a range on their start alone
+    static constexpr qint64 MAX_SIGHTING_MS = 10 * 60 * 1000;
+    void saveVideoSightings(const QVector<VideoSighting>& sightings);
+    // Of the track, meeting [startMs, endMs], oldest first
+    QVector<VideoSighting> loadVideoSightings(const QString& trackId, qint64 startMs, qint64 endMs);
+    QFuture<QVector<VideoSighting>> loadVideoSightingsAsync(const QString& trackId, qint64 startMs, qint64 endMs);
     
-    // Cleanup
+    // Cleanup. Records are purged in small batches on the purge thread,
+    // so this returns at once; retentionPurgeStats() shows the progress
     void cleanup(int retentionDays);
+    RetentionPurgeStats retentionPurgeStats() const;
     
 signals:
     void databaseError(const QString& error);
@@ -47,9 +106,20 @@ private:
     DatabaseManager& operator=(const DatabaseManager&) = delete;
     
     bool createTables();
+    void openFileStores(const QString& path);
+    QString trackArchivePath(const QString& path) const;
     
     QSqlDatabase m_db;
     QString m_dbPath;
+    std::unique_ptr<TrackHistoryWriter> m_historyWriter;
+    std::unique_ptr<RetentionPurger> m_purger;
+    std::unique_ptr<DatabaseReadPool> m_readPool;
+    std::unique_ptr<TrackArchiveReader> m_archiveReader;
+    std::unique_ptr<DetectionRecorder> m_detectionRecorder;
+    std::unique_ptr<EventJournal> m_journal;
+    QString m_detectionLogPath;
+    TaskGraph m_fileStores{TaskPriority::Background};
+    bool m_fileStoresAsync = false;
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,149 @@
+#include "config/DatabaseReadPool.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <memory>
+
+namespace CounterUAS {
+
+DatabaseReadPool::DatabaseReadPool(const DatabaseReadPoolConfig& config)
+{
+    setConfig(config);
+}
+
+DatabaseReadPool::~DatabaseReadPool() {
+    stop();
+}
+
+void DatabaseReadPool::setConfig(const DatabaseReadPoolConfig& config) {
+    const bool running = isRunning();
+    if (running) stop();
+    m_config = config;
+    m_config.connections = qMax(1, m_config.connections);
+    if (running) start(m_databasePath);
+}
+
+bool DatabaseReadPool::start(const QString& databasePath) {
+    if (isRunning()) return true;
+    m_databasePath = databasePath;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+        m_accepting = true;
+    }
+
+    for (int i = 0; i < m_config.connections; ++i) {
+        const QString connectionName = QString("db-read-%1-%2")
+                                           .arg(reinterpret_cast<quintptr>(this), 0, 16).arg(i);
+        QThread* thread = QThread::create([this, connectionName]() { readerLoop(connectionName); });
+        thread->setObjectName(QString("DatabaseReader-%1").arg(i));
+        thread->start();
+        m_threads.append(thread);
+    }
+    return true;
+}
+
+void DatabaseReadPool::stop() {
+    if (!isRunning()) return;
+    QQueue<QueuedJob> abandoned;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_accepting = false;
+        abandoned.swap(m_queue);
+    }
+    m_wake.wakeAll();
+    for (const QueuedJob& queued : qAsConst(abandoned)) {
+        queued.job(nullptr);
+        m_queriesCanceled.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    for (QThread* thread : qAsConst(m_threads)) {
+        thread->wait();
+        delete thread;
+    }
+    m_threads.clear();
+}
+
+void DatabaseReadPool::submit(Job job) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_accepting) {
+            m_queue.enqueue(QueuedJob{std::move(job), TimeUtils::monotonicNs()});
+            locker.unlock();
+            m_wake.wakeOne();
+            return;
+        }
+    }
+    job(nullptr);
+    m_queriesCanceled.fetch_add(1, std::memory_order_relaxed);
+}
+
+DatabaseReadPoolStats DatabaseReadPool::stats() const {
+    DatabaseReadPoolStats stats;
+    {
+        QMutexLocker locker(&m_mutex);
+        stats.queueDepth = m_queue.size();
+        stats.queueWait = m_queueWait;
+        stats.queryDuration = m_queryDuration;
+    }
+    stats.queriesRun = m_queriesRun.load();
+    stats.queriesCanceled = m_queriesCanceled.load();
+    stats.connectionsOpen = m_connectionsOpen.load();
+    return stats;
+}
+
+void DatabaseReadPool::readerLoop(const QString& connectionName) {
+    {
+        DatabaseReader reader;
+        reader.db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        reader.db.setDatabaseName(m_databasePath);
+        // Never writes, so never takes the write lock; the timeout covers a checkpoint
+        reader.db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=2000");
+        if (reader.db.open()) {
+            m_connectionsOpen.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            Logger::instance().error("DatabaseReadPool", "Failed to open database: " + reader.db.lastError().text());
+        }
+        std::unique_ptr<TrackArchiveReader> archive;
+        if (!m_config.archiveDirectory.isEmpty()) {
+            archive.reset(new TrackArchiveReader(m_config.archiveDirectory));
+            reader.archive = archive.get();
+        }
+
+        forever {
+            QueuedJob queued;
+            {
+                QMutexLocker locker(&m_mutex);
+                while (!m_stopping && m_queue.isEmpty()) {
+                    m_wake.wait(&m_mutex);
+                }
+                if (m_stopping) break;
+                queued = m_queue.dequeue();
+            }
+
+            const qint64 startNs = TimeUtils::monotonicNs();
+            const bool ran = queued.job(&reader);
+            const qint64 endNs = TimeUtils::monotonicNs();
+            if (ran) {
+                m_queriesRun.fetch_add(1, std::memory_order_relaxed);
+                QMutexLocker locker(&m_mutex);
+                m_queueWait.record((startNs - queued.queuedNs) / 1000);
+                m_queryDuration.record((endNs - startNs) / 1000);
+            } else {
+                m_queriesCanceled.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        archive.reset();
+        if (reader.db.isOpen()) {
+            reader.db.close();
+            m_connectionsOpen.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+} // namespace CounterUAS
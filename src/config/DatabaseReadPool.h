@@ -0,0 +1,141 @@
+#ifndef DATABASEREADPOOL_H
+#define DATABASEREADPOOL_H
+
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMutex>
+#include <QQueue>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include "config/TrackArchive.h"
+#include "utils/LatencyStats.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief Size of the read pool and what each reader opens
+ */
+struct DatabaseReadPoolConfig {
+    int connections = 2;            // Reader threads, each with its own connection
+    QString archiveDirectory;       // Track archive; no archive reader when empty
+};
+
+/**
+ * @brief Read pool counters, safe to read from any thread
+ */
+struct DatabaseReadPoolStats {
+    quint64 queriesRun = 0;
+    quint64 queriesCanceled = 0;    // Canceled while queued, or queued at stop()
+    int connectionsOpen = 0;
+    int queueDepth = 0;
+    LatencyStats queueWait;         // Submitted to started, microseconds
+    LatencyStats queryDuration;     // One query, microseconds
+};
+
+/**
+ * @brief What a query runs against: its reader thread's own handles
+ */
+struct DatabaseReader {
+    QSqlDatabase db;                        // Read-only; open unless the open failed
+    TrackArchiveReader* archive = nullptr;  // Null without an archive directory
+};
+
+/**
+ * @brief Read-only queries on threads and connections of their own
+ *
+ * Each of the pool's reader threads opens the database read-only
+ * and keeps the connection, and a TrackArchiveReader if configured, for
+ * its lifetime; a QSqlDatabase and an archive reader may only be used on
+ * the thread that made them. With the database in WAL mode the readers
+ * see the last commit and neither block nor are blocked by the writers,
+ * so a replay or report query of minutes of history leaves the GUI and
+ * the history writer alone.
+ *
+ * run() queues a query and returns its QFuture at once; watch it with a
+ * QFutureWatcher, or wait on result() off the GUI thread. A query canceled
+ * before a reader takes it never runs; one queued at stop(), or submitted
+ * while the pool is stopped, finishes canceled without a result. Queries
+ * must not wait on other queries of the same pool.
+ */
+class DatabaseReadPool {
+public:
+    explicit DatabaseReadPool(const DatabaseReadPoolConfig& config = DatabaseReadPoolConfig());
+    ~DatabaseReadPool();
+
+    DatabaseReadPool(const DatabaseReadPool&) = delete;
+    DatabaseReadPool& operator=(const DatabaseReadPool&) = delete;
+
+    // Stopped while it changes
+    void setConfig(const DatabaseReadPoolConfig& config);
+    DatabaseReadPoolConfig config() const { return m_config; }
+
+    bool start(const QString& databasePath);
+    // Cancels what is queued, waits out the queries running
+    void stop();
+    bool isRunning() const { return !m_threads.isEmpty(); }
+
+    // Any thread; query(DatabaseReader&) runs on a reader thread
+    template <typename Query>
+    auto run(Query query) -> QFuture<std::invoke_result_t<Query, DatabaseReader&>>;
+
+    DatabaseReadPoolStats stats() const;
+
+private:
+    // Null reader: abandoned unrun. True when the query ran
+    using Job = std::function<bool(DatabaseReader* reader)>;
+    struct QueuedJob {
+        Job job;
+        qint64 queuedNs = 0;
+    };
+
+    void submit(Job job);
+    void readerLoop(const QString& connectionName);
+
+    DatabaseReadPoolConfig m_config;
+    QString m_databasePath;
+    QVector<QThread*> m_threads;
+
+    mutable QMutex m_mutex;             // Guards the queue, the flags and the latency stats
+    QWaitCondition m_wake;
+    QQueue<QueuedJob> m_queue;
+    bool m_stopping = false;
+    bool m_accepting = false;
+    LatencyStats m_queueWait;
+    LatencyStats m_queryDuration;
+
+    std::atomic<quint64> m_queriesRun{0};
+    std::atomic<quint64> m_queriesCanceled{0};
+    std::atomic<int> m_connectionsOpen{0};
+};
+
+template <typename Query>
+auto DatabaseReadPool::run(Query query) -> QFuture<std::invoke_result_t<Query, DatabaseReader&>> {
+    using Result = std::invoke_result_t<Query, DatabaseReader&>;
+    static_assert(!std::is_void<Result>::value, "Read queries return what they read");
+
+    QFutureInterface<Result> promise;
+    promise.reportStarted();
+    QFuture<Result> future = promise.future();
+    submit([promise, query](DatabaseReader* reader) mutable {
+        const bool ran = reader && !promise.isCanceled();
+        if (ran) {
+            promise.reportResult(query(*reader));
+        } else {
+            promise.reportCanceled();
+        }
+        promise.reportFinished();
+        return ran;
+    });
+    return future;
+}
+
+} // namespace CounterUAS
+
+#endif // DATABASEREADPOOL_H
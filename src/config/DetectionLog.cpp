@@ -0,0 +1,366 @@
+#include "config/DetectionLog.h"
+#include "utils/Logger.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QtEndian>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 LOG_MAGIC = 0x4C445543;       // "CUDL"
+constexpr quint32 LOG_VERSION = 2;                 // 1 kept sensor fields in the metadata map
+constexpr int LOG_HEADER_BYTES = 24;            // magic, version, start, duration
+constexpr quint32 MAX_RECORD_BYTES = 64 * 1024 * 1024;
+constexpr int WRITER_INTERVAL_MS = 200;
+
+QString partitionPath(const QString& directory, qint64 startMs) {
+    return QDir(directory).filePath(QString("detections-%1.cdl").arg(startMs));
+}
+
+void writeInfo(QDataStream& stream, const SensorDetection& d) {
+    const SensorDetectionInfo& info = d.info;
+    switch (d.sourceType) {
+        case DetectionSource::Radar:
+            stream << info.radar.trackNumber << info.radar.rangeM
+                   << info.radar.azimuthDeg << info.radar.elevationDeg;
+            break;
+        case DetectionSource::RFDetector:
+            stream.writeRawData(info.rf.protocol, sizeof(info.rf.protocol));
+            stream << info.rf.frequencyMHz << info.rf.signalStrengthDbm
+                   << info.rf.azimuthDeg << info.rf.elevationDeg << info.rf.bearingSigmaDeg
+                   << info.rf.sensorLatitude << info.rf.sensorLongitude << info.rf.sensorAltitude
+                   << info.rf.sensorCount << info.rf.residualM;
+            break;
+        case DetectionSource::Camera:
+            stream << info.camera.x << info.camera.y << info.camera.width << info.camera.height
+                   << info.camera.frameNumber;
+            stream.writeRawData(info.camera.objectClass, sizeof(info.camera.objectClass));
+            break;
+        case DetectionSource::Cooperative:
+            stream.writeRawData(info.cooperative.id, sizeof(info.cooperative.id));
+            stream.writeRawData(info.cooperative.callsign, sizeof(info.cooperative.callsign));
+            stream << info.cooperative.classification << info.cooperative.adsb;
+            break;
+        case DetectionSource::Combined:
+            stream.writeRawData(info.combined.trackId, sizeof(info.combined.trackId));
+            stream << info.combined.classification << info.combined.threatLevel
+                   << info.combined.classificationConfidence;
+            break;
+        default:
+            break;
+    }
+}
+
+void readInfo(QDataStream& stream, SensorDetection& d) {
+    SensorDetectionInfo& info = d.info;
+    switch (d.sourceType) {
+        case DetectionSource::Radar:
+            stream >> info.radar.trackNumber >> info.radar.rangeM
+                   >> info.radar.azimuthDeg >> info.radar.elevationDeg;
+            break;
+        case DetectionSource::RFDetector:
+            stream.readRawData(info.rf.protocol, sizeof(info.rf.protocol));
+            stream >> info.rf.frequencyMHz >> info.rf.signalStrengthDbm
+                   >> info.rf.azimuthDeg >> info.rf.elevationDeg >> info.rf.bearingSigmaDeg
+                   >> info.rf.sensorLatitude >> info.rf.sensorLongitude >> info.rf.sensorAltitude
+                   >> info.rf.sensorCount >> info.rf.residualM;
+            info.rf.protocol[sizeof(info.rf.protocol) - 1] = '\0';
+            break;
+        case DetectionSource::Camera:
+            stream >> info.camera.x >> info.camera.y >> info.camera.width >> info.camera.height
+                   >> info.camera.frameNumber;
+            stream.readRawData(info.camera.objectClass, sizeof(info.camera.objectClass));
+            info.camera.objectClass[sizeof(info.camera.objectClass) - 1] = '\0';
+            break;
+        case DetectionSource::Cooperative:
+            stream.readRawData(info.cooperative.id, sizeof(info.cooperative.id));
+            stream.readRawData(info.cooperative.callsign, sizeof(info.cooperative.callsign));
+            stream >> info.cooperative.classification >> info.cooperative.adsb;
+            info.cooperative.id[sizeof(info.cooperative.id) - 1] = '\0';
+            info.cooperative.callsign[sizeof(info.cooperative.callsign) - 1] = '\0';
+            break;
+        case DetectionSource::Combined:
+            stream.readRawData(info.combined.trackId, sizeof(info.combined.trackId));
+            stream >> info.combined.classification >> info.combined.threatLevel
+                   >> info.combined.classificationConfidence;
+            info.combined.trackId[sizeof(info.combined.trackId) - 1] = '\0';
+            break;
+        default:
+            break;
+    }
+}
+
+// Version 1 logs: the fields the sensors kept in the map, moved to info
+void liftMetadata(SensorDetection& d) {
+    QVariantMap& meta = d.metadata;
+    SensorDetectionInfo& info = d.info;
+    switch (d.sourceType) {
+        case DetectionSource::Radar:
+            info.radar.trackNumber = meta.take("trackNumber").toUInt();
+            info.radar.rangeM = meta.take("rangeM").toFloat();
+            info.radar.azimuthDeg = meta.take("azimuthDeg").toFloat();
+            info.radar.elevationDeg = meta.take("elevationDeg").toFloat();
+            break;
+        case DetectionSource::RFDetector:
+            setFixedString(info.rf.protocol, meta.take("protocol").toString());
+            info.rf.frequencyMHz = meta.take("frequencyMHz").toFloat();
+            info.rf.signalStrengthDbm = meta.take("signalStrengthDbm").toFloat();
+            info.rf.azimuthDeg = meta.take("azimuthDeg").toFloat();
+            info.rf.elevationDeg = meta.take("elevationDeg").toFloat();
+            info.rf.bearingSigmaDeg = meta.take("bearingSigmaDeg").toFloat();
+            info.rf.sensorLatitude = meta.take("sensorLatitude").toDouble();
+            info.rf.sensorLongitude = meta.take("sensorLongitude").toDouble();
+            info.rf.sensorAltitude = meta.take("sensorAltitude").toFloat();
+            info.rf.sensorCount = static_cast<quint16>(meta.take("rfSensorCount").toUInt());
+            info.rf.residualM = meta.take("triangulationResidualM").toFloat();
+            break;
+        case DetectionSource::Camera:
+            setFixedString(info.camera.objectClass, meta.take("objectClass").toString());
+            info.camera.frameNumber = meta.take("frameNumber").toLongLong();
+            info.camera.x = meta.take("bboxX").toFloat();
+            info.camera.y = meta.take("bboxY").toFloat();
+            info.camera.width = meta.take("bboxW").toFloat();
+            info.camera.height = meta.take("bboxH").toFloat();
+            break;
+        case DetectionSource::Cooperative:
+            setFixedString(info.cooperative.id, meta.take("cooperativeId").toString());
+            setFixedString(info.cooperative.callsign, meta.take("callsign").toString());
+            info.cooperative.classification = static_cast<qint8>(meta.take("cooperativeClass").toInt());
+            info.cooperative.adsb = meta.take("cooperativeType").toString() == QLatin1String("ADS-B");
+            break;
+        default:
+            break;
+    }
+}
+
+QByteArray encodeScan(const RecordedScan& scan) {
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << scan.receivedMs << static_cast<quint32>(scan.detections.size());
+    for (const SensorDetection& d : scan.detections) {
+        stream << d.sensorId << d.timestamp << static_cast<qint32>(d.sourceType)
+               << d.position.latitude << d.position.longitude << d.position.altitude
+               << d.velocity.north << d.velocity.east << d.velocity.down
+               << d.signalStrength << d.confidence << d.metadata;
+        writeInfo(stream, d);
+    }
+    return payload;
+}
+
+bool decodeScan(const QByteArray& payload, quint32 version, RecordedScan& scan) {
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_15);
+    quint32 count = 0;
+    stream >> scan.receivedMs >> count;
+    if (stream.status() != QDataStream::Ok) return false;
+
+    scan.detections.clear();
+    scan.detections.reserve(static_cast<int>(qMin<quint32>(count, 4096)));
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        SensorDetection d;
+        qint32 source = 0;
+        stream >> d.sensorId >> d.timestamp >> source
+               >> d.position.latitude >> d.position.longitude >> d.position.altitude
+               >> d.velocity.north >> d.velocity.east >> d.velocity.down
+               >> d.signalStrength >> d.confidence >> d.metadata;
+        d.sourceType = static_cast<DetectionSource>(source);
+        if (version >= 2) {
+            readInfo(stream, d);
+        } else {
+            liftMetadata(d);
+        }
+        scan.detections.append(d);
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+qint64 floorToPartition(qint64 ms, qint64 partitionMs) {
+    qint64 q = ms / partitionMs;
+    if (ms % partitionMs != 0 && ms < 0) --q;
+    return q * partitionMs;
+}
+
+} // namespace
+
+DetectionRecorder::DetectionRecorder(const QString& directory, int queueCapacity, qint64 partitionMs)
+    : m_directory(directory)
+    , m_partitionMs(qMax<qint64>(1000, partitionMs))
+    , m_queue(static_cast<std::size_t>(qMax(16, queueCapacity)))
+{
+    QDir().mkpath(m_directory);
+}
+
+DetectionRecorder::~DetectionRecorder() {
+    stop();
+}
+
+void DetectionRecorder::start() {
+    if (m_thread) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+    }
+    m_thread = QThread::create([this]() { writerLoop(); });
+    m_thread->setObjectName("DetectionRecorder");
+    m_thread->start();
+    m_accepting.store(true, std::memory_order_release);
+}
+
+void DetectionRecorder::stop() {
+    if (!m_thread) return;
+    m_accepting.store(false, std::memory_order_release);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+bool DetectionRecorder::record(qint64 receivedMs, const QVector<SensorDetection>& detections) {
+    if (!m_accepting.load(std::memory_order_acquire) || detections.isEmpty()) return false;
+
+    RecordedScan scan;
+    scan.receivedMs = receivedMs;
+    scan.detections = detections;
+    if (!m_queue.tryPush(std::move(scan))) {
+        m_scansDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void DetectionRecorder::writerLoop() {
+    std::unique_ptr<QFile> file;
+    qint64 fileStartMs = 0;
+
+    forever {
+        bool stopping;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_stopping) {
+                m_wake.wait(&m_mutex, WRITER_INTERVAL_MS);
+            }
+            stopping = m_stopping;
+        }
+
+        RecordedScan scan;
+        while (m_queue.tryPop(scan)) {
+            const qint64 startMs = floorToPartition(scan.receivedMs, m_partitionMs);
+            if (!file || startMs != fileStartMs) {
+                file.reset(new QFile(partitionPath(m_directory, startMs)));
+                fileStartMs = startMs;
+                if (!file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+                    Logger::instance().error("DetectionRecorder", "Failed to open " + file->fileName() +
+                                             ": " + file->errorString());
+                    file.reset();
+                    m_scansDropped.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (file->size() == 0) {
+                    uchar header[LOG_HEADER_BYTES];
+                    qToLittleEndian<quint32>(LOG_MAGIC, header);
+                    qToLittleEndian<quint32>(LOG_VERSION, header + 4);
+                    qToLittleEndian<qint64>(startMs, header + 8);
+                    qToLittleEndian<qint64>(m_partitionMs, header + 16);
+                    file->write(reinterpret_cast<const char*>(header), LOG_HEADER_BYTES);
+                }
+            }
+
+            const QByteArray payload = encodeScan(scan);
+            uchar length[4];
+            qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), length);
+            file->write(reinterpret_cast<const char*>(length), 4);
+            file->write(payload);
+            m_scansRecorded.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (file) {
+            file->flush();
+        }
+        if (stopping) break;
+    }
+}
+
+DetectionLogReader::DetectionLogReader(const QString& directory)
+    : m_directory(directory)
+{}
+
+qint64 DetectionLogReader::read(qint64 startMs, qint64 endMs, const Visitor& visit) const {
+    qint64 visited = 0;
+    const QMap<qint64, QString> files = partitions();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        if (it.key() > endMs) break;
+
+        QFile file(it.value());
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QByteArray header = file.read(LOG_HEADER_BYTES);
+        if (header.size() < LOG_HEADER_BYTES) continue;
+        const uchar* h = reinterpret_cast<const uchar*>(header.constData());
+        const quint32 version = qFromLittleEndian<quint32>(h + 4);
+        if (qFromLittleEndian<quint32>(h) != LOG_MAGIC || version < 1 || version > LOG_VERSION) {
+            Logger::instance().warning("DetectionLog", "Not a detection log: " + it.value());
+            continue;
+        }
+        const qint64 durationMs = qFromLittleEndian<qint64>(h + 16);
+        if (it.key() + durationMs <= startMs) continue;
+
+        RecordedScan scan;
+        forever {
+            const QByteArray length = file.read(4);
+            if (length.size() < 4) break;
+            const quint32 bytes = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(length.constData()));
+            if (bytes > MAX_RECORD_BYTES) break;
+            const QByteArray payload = file.read(bytes);
+            if (payload.size() < static_cast<int>(bytes)) break;    // Torn by a crash
+            if (!decodeScan(payload, version, scan)) continue;
+            if (scan.receivedMs < startMs || scan.receivedMs > endMs) continue;
+            visit(scan);
+            ++visited;
+        }
+    }
+    return visited;
+}
+
+QVector<RecordedScan> DetectionLogReader::load(qint64 startMs, qint64 endMs) const {
+    QVector<RecordedScan> scans;
+    read(startMs, endMs, [&scans](const RecordedScan& scan) { scans.append(scan); });
+    return scans;
+}
+
+int DetectionLogReader::removeBefore(qint64 cutoffMs) const {
+    int removed = 0;
+    const QMap<qint64, QString> files = partitions();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        QFile file(it.value());
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QByteArray header = file.read(LOG_HEADER_BYTES);
+        file.close();
+        if (header.size() < LOG_HEADER_BYTES) continue;
+        const qint64 durationMs = qFromLittleEndian<qint64>(reinterpret_cast<const uchar*>(header.constData()) + 16);
+        if (it.key() + durationMs <= cutoffMs && QFile::remove(it.value())) {
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+QMap<qint64, QString> DetectionLogReader::partitions() const {
+    QMap<qint64, QString> files;
+    const QDir dir(m_directory);
+    const QStringList names = dir.entryList(QStringList() << "detections-*.cdl", QDir::Files);
+    for (const QString& name : names) {
+        bool ok = false;
+        const qint64 startMs = QFileInfo(name).completeBaseName().mid(11).toLongLong(&ok);
+        if (ok) files.insert(startMs, dir.filePath(name));
+    }
+    return files;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,95 @@
+#ifndef DETECTIONLOG_H
+#define DETECTIONLOG_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "sensors/SensorInterface.h"
+#include "utils/BoundedQueue.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief One scan as it reached the fusion pipeline
+ */
+struct RecordedScan {
+    qint64 receivedMs = 0;      // When it was submitted; detections keep their own timestamps
+    QVector<SensorDetection> detections;
+};
+
+/**
+ * @brief Records the sensor scans submitted to fusion, for replay
+ *
+ * record() is lock-free and safe from any sensor thread; a writer thread
+ * of its own appends the scans to detections-<startMs>.cdl, one file per
+ * partitionMs of receive time. Each record is a length-prefixed
+ * QDataStream of the scan, so a record torn by a crash is skipped on read.
+ */
+class DetectionRecorder {
+public:
+    static constexpr qint64 DEFAULT_PARTITION_MS = 600000;
+
+    explicit DetectionRecorder(const QString& directory, int queueCapacity = 4096,
+                               qint64 partitionMs = DEFAULT_PARTITION_MS);
+    ~DetectionRecorder();
+
+    DetectionRecorder(const DetectionRecorder&) = delete;
+    DetectionRecorder& operator=(const DetectionRecorder&) = delete;
+
+    void start();
+    // Writes what is queued first
+    void stop();
+
+    // Any thread; false when the queue is full
+    bool record(qint64 receivedMs, const QVector<SensorDetection>& detections);
+
+    quint64 scansRecorded() const { return m_scansRecorded.load(); }
+    quint64 scansDropped() const { return m_scansDropped.load(); }
+
+private:
+    void writerLoop();
+
+    QString m_directory;
+    qint64 m_partitionMs;
+    BoundedQueue<RecordedScan> m_queue;
+    QThread* m_thread = nullptr;
+    QMutex m_mutex;                     // Guards m_stopping for the wait
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+    std::atomic<bool> m_accepting{false};
+    std::atomic<quint64> m_scansRecorded{0};
+    std::atomic<quint64> m_scansDropped{0};
+};
+
+/**
+ * @brief Reads recorded scans back, in the order they were received
+ */
+class DetectionLogReader {
+public:
+    using Visitor = std::function<void(const RecordedScan&)>;
+
+    explicit DetectionLogReader(const QString& directory);
+
+    // Scans received in [startMs, endMs]; returns how many were visited
+    qint64 read(qint64 startMs, qint64 endMs, const Visitor& visit) const;
+    QVector<RecordedScan> load(qint64 startMs, qint64 endMs) const;
+
+    // Deletes partitions that end at or before cutoffMs; returns how many
+    int removeBefore(qint64 cutoffMs) const;
+
+private:
+    QMap<qint64, QString> partitions() const;   // Start time to path
+
+    QString m_directory;
+};
+
+} // namespace CounterUAS
+
+#endif // DETECTIONLOG_H
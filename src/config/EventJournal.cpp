@@ -0,0 +1,467 @@
+#include "config/EventJournal.h"
+#include "config/MappedFileUtils.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <QtEndian>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 JOURNAL_MAGIC = 0x4A455543;   // "CUEJ"
+constexpr quint32 JOURNAL_VERSION = 1;
+constexpr qint64 SEGMENT_HEADER_BYTES = 32;     // magic, version, first sequence, created, reserved
+constexpr qint64 RECORD_HEADER_BYTES = 64;      // Fixed fields; the four strings follow
+constexpr int STRING_FIELDS = 4;
+constexpr int MAX_ID_CHARS = 256;
+constexpr int MAX_TEXT_CHARS = 8192;
+
+// Record layout, little-endian:
+//   0 u32 record bytes (multiple of 8)    4 u32 CRC-32 of bytes 8..end
+//   8 u64 sequence                        16 i64 timestamp ms
+//  24 u16 type   26 u16 reserved          28 i32 code
+//  32 i32 previous code  36 u32 reserved  40 f64 latitude
+//  48 f64 longitude                       56 f64 altitude
+//  64 subject, track, actor, text: u16 byte length + UTF-8 each, zero padded
+
+QString segmentPath(const QString& directory, quint64 firstSequence) {
+    return QDir(directory).filePath(QString("journal-%1.cej").arg(firstSequence, 20, 10, QChar('0')));
+}
+
+void writeDouble(double value, uchar* out) {
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint64>(bits, out);
+}
+
+double readDouble(const uchar* in) {
+    const quint64 bits = qFromLittleEndian<quint64>(in);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Length of the valid record at offset, 0 at the end of the valid data
+qint64 validRecordAt(const uchar* data, qint64 size, qint64 offset, quint64 expectedSequence) {
+    if (offset + RECORD_HEADER_BYTES > size) return 0;
+    const qint64 bytes = qFromLittleEndian<quint32>(data + offset);
+    if (bytes < RECORD_HEADER_BYTES || bytes % 8 != 0 || offset + bytes > size) return 0;
+    if (MappedFileUtils::crc32(data + offset + 8, bytes - 8) != qFromLittleEndian<quint32>(data + offset + 4)) return 0;
+    if (expectedSequence != 0 && qFromLittleEndian<quint64>(data + offset + 8) != expectedSequence) return 0;
+    return bytes;
+}
+
+bool decodeRecord(const uchar* p, qint64 bytes, JournalEvent& event) {
+    event.sequence = qFromLittleEndian<quint64>(p + 8);
+    event.timestampMs = qFromLittleEndian<qint64>(p + 16);
+    event.type = static_cast<JournalEventType>(qFromLittleEndian<quint16>(p + 24));
+    event.code = qFromLittleEndian<qint32>(p + 28);
+    event.previousCode = qFromLittleEndian<qint32>(p + 32);
+    event.position.latitude = readDouble(p + 40);
+    event.position.longitude = readDouble(p + 48);
+    event.position.altitude = readDouble(p + 56);
+
+    QString* fields[STRING_FIELDS] = {&event.subjectId, &event.trackId, &event.actorId, &event.text};
+    qint64 offset = RECORD_HEADER_BYTES;
+    for (QString* field : fields) {
+        if (offset + 2 > bytes) return false;
+        const quint16 length = qFromLittleEndian<quint16>(p + offset);
+        offset += 2;
+        if (offset + length > bytes) return false;
+        *field = QString::fromUtf8(reinterpret_cast<const char*>(p + offset), length);
+        offset += length;
+    }
+    return true;
+}
+
+QString csvField(const QString& value) {
+    if (!value.contains(',') && !value.contains('"') && !value.contains('\n')) return value;
+    QString quoted = value;
+    quoted.replace('"', "\"\"");
+    return '"' + quoted + '"';
+}
+
+} // namespace
+
+QString JournalEvent::typeName(JournalEventType type) {
+    switch (type) {
+        case JournalEventType::EngagementState: return "EngagementState";
+        case JournalEventType::Authorization: return "Authorization";
+        case JournalEventType::EngagementResult: return "EngagementResult";
+        case JournalEventType::Alert: return "Alert";
+        case JournalEventType::AlertAcknowledged: return "AlertAcknowledged";
+        case JournalEventType::TrackCreated: return "TrackCreated";
+        case JournalEventType::TrackDropped: return "TrackDropped";
+        case JournalEventType::TrackClassified: return "TrackClassified";
+        case JournalEventType::OperatorAction: return "OperatorAction";
+    }
+    return QString("Type%1").arg(static_cast<int>(type));
+}
+
+struct EventJournal::Segment {
+    QFile file;
+    uchar* data = nullptr;
+    qint64 size = 0;
+
+    ~Segment() {
+        if (data) file.unmap(data);
+    }
+};
+
+EventJournal::EventJournal(const QString& directory, qint64 segmentBytes, int commitIntervalMs)
+    : m_directory(directory)
+    , m_segmentBytes(qMax<qint64>(64 * 1024, MappedFileUtils::align8(segmentBytes)))
+    , m_commitIntervalMs(qMax(1, commitIntervalMs))
+{}
+
+EventJournal::~EventJournal() {
+    close();
+}
+
+bool EventJournal::open() {
+    QMutexLocker locker(&m_mutex);
+    if (m_segment) return true;
+    QDir().mkpath(m_directory);
+
+    const QMap<quint64, QString> existing = EventJournalReader(m_directory).segmentsByFirstSequence();
+    if (existing.isEmpty()) {
+        if (!openSegment(1)) return false;
+    } else {
+        // Find where the newest segment's valid records end
+        auto segment = std::make_shared<Segment>();
+        segment->file.setFileName(existing.last());
+        const quint64 firstSequence = existing.lastKey();
+        bool valid = segment->file.open(QIODevice::ReadWrite);
+        if (valid) {
+            segment->size = segment->file.size();
+            segment->data = segment->size >= SEGMENT_HEADER_BYTES ? segment->file.map(0, segment->size) : nullptr;
+            valid = segment->data &&
+                    qFromLittleEndian<quint32>(segment->data) == JOURNAL_MAGIC &&
+                    qFromLittleEndian<quint32>(segment->data + 4) == JOURNAL_VERSION;
+        }
+
+        if (!valid) {
+            Logger::instance().warning("EventJournal", "Unreadable journal segment set aside: " + existing.last());
+            segment.reset();
+            QFile::rename(existing.last(), existing.last() + ".corrupt");
+            m_lastSequence.store(firstSequence - 1);
+            if (!openSegment(firstSequence)) return false;
+        } else {
+            qint64 offset = SEGMENT_HEADER_BYTES;
+            quint64 sequence = firstSequence;
+            while (qint64 bytes = validRecordAt(segment->data, segment->size, offset, sequence)) {
+                offset += bytes;
+                ++sequence;
+            }
+            if (offset + 4 <= segment->size && qFromLittleEndian<quint32>(segment->data + offset) != 0) {
+                // Torn by a crash or power loss: clear it so no stale bytes
+                // follow the next record
+                Logger::instance().warning("EventJournal", QString("Discarding torn record after sequence %1")
+                                           .arg(sequence - 1));
+                std::memset(segment->data + offset, 0, static_cast<size_t>(segment->size - offset));
+                MappedFileUtils::flushMapped(segment->data, offset, segment->size, segment->file.handle());
+            }
+            m_lastSequence.store(sequence - 1);
+            m_segment = segment;
+            m_writeOffset = offset;
+            m_syncedOffset = offset;
+        }
+    }
+    m_durableSequence.store(m_lastSequence.load());
+    locker.unlock();
+
+    {
+        QMutexLocker commitLocker(&m_commitMutex);
+        m_stopping = false;
+    }
+    m_thread = QThread::create([this]() { commitLoop(); });
+    m_thread->setObjectName("EventJournal");
+    m_thread->start();
+
+    Logger::instance().info("EventJournal", QString("Journal open at sequence %1 in %2")
+                            .arg(m_lastSequence.load()).arg(m_directory));
+    return true;
+}
+
+void EventJournal::close() {
+    if (m_thread) {
+        {
+            QMutexLocker locker(&m_commitMutex);
+            m_stopping = true;
+        }
+        m_commitWake.wakeAll();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    syncPending();
+    QMutexLocker locker(&m_mutex);
+    m_segment.reset();
+}
+
+bool EventJournal::isOpen() const {
+    QMutexLocker locker(&m_mutex);
+    return m_segment != nullptr;
+}
+
+quint64 EventJournal::append(const JournalEvent& event) {
+    // Everything but the copy into the mapping happens outside the lock
+    const QByteArray strings[STRING_FIELDS] = {
+        event.subjectId.left(MAX_ID_CHARS).toUtf8(),
+        event.trackId.left(MAX_ID_CHARS).toUtf8(),
+        event.actorId.left(MAX_ID_CHARS).toUtf8(),
+        event.text.left(MAX_TEXT_CHARS).toUtf8()
+    };
+    qint64 bytes = RECORD_HEADER_BYTES;
+    for (const QByteArray& s : strings) {
+        bytes += 2 + s.size();
+    }
+    bytes = MappedFileUtils::align8(bytes);
+    const qint64 timestampMs = event.timestampMs != 0 ? event.timestampMs : QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_segment) return 0;
+    if (m_writeOffset + bytes > m_segment->size) {
+        rollSegment();
+        if (!m_segment || m_writeOffset + bytes > m_segment->size) return 0;
+    }
+
+    const quint64 sequence = m_lastSequence.load(std::memory_order_relaxed) + 1;
+    uchar* p = m_segment->data + m_writeOffset;     // Zero filled, padding included
+    qToLittleEndian<quint64>(sequence, p + 8);
+    qToLittleEndian<qint64>(timestampMs, p + 16);
+    qToLittleEndian<quint16>(static_cast<quint16>(event.type), p + 24);
+    qToLittleEndian<qint32>(event.code, p + 28);
+    qToLittleEndian<qint32>(event.previousCode, p + 32);
+    writeDouble(event.position.latitude, p + 40);
+    writeDouble(event.position.longitude, p + 48);
+    writeDouble(event.position.altitude, p + 56);
+    qint64 offset = RECORD_HEADER_BYTES;
+    for (const QByteArray& s : strings) {
+        qToLittleEndian<quint16>(static_cast<quint16>(s.size()), p + offset);
+        std::memcpy(p + offset + 2, s.constData(), static_cast<size_t>(s.size()));
+        offset += 2 + s.size();
+    }
+    qToLittleEndian<quint32>(MappedFileUtils::crc32(p + 8, bytes - 8), p + 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(bytes), p);
+
+    m_writeOffset += bytes;
+    m_lastSequence.store(sequence, std::memory_order_release);
+    return sequence;
+}
+
+bool EventJournal::waitDurable(quint64 sequence, int timeoutMs) {
+    if (m_durableSequence.load() >= sequence) return true;
+    if (!m_thread) {
+        syncPending();
+        return m_durableSequence.load() >= sequence;
+    }
+
+    QDeadlineTimer deadline(timeoutMs);
+    QMutexLocker locker(&m_commitMutex);
+    m_commitWake.wakeAll();     // Commit now rather than at the interval
+    while (m_durableSequence.load() < sequence) {
+        if (!m_durableChanged.wait(&m_commitMutex, deadline)) break;
+    }
+    return m_durableSequence.load() >= sequence;
+}
+
+void EventJournal::commit() {
+    syncPending();
+}
+
+bool EventJournal::openSegment(quint64 firstSequence) {
+    auto segment = std::make_shared<Segment>();
+    segment->file.setFileName(segmentPath(m_directory, firstSequence));
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Truncate) ||
+        !segment->file.resize(m_segmentBytes)) {
+        Logger::instance().error("EventJournal", "Cannot create " + segment->file.fileName() + ": " +
+                                 segment->file.errorString());
+        return false;
+    }
+    segment->size = m_segmentBytes;
+    segment->data = segment->file.map(0, segment->size);
+    if (!segment->data) {
+        Logger::instance().error("EventJournal", "Cannot map " + segment->file.fileName());
+        return false;
+    }
+
+    qToLittleEndian<quint32>(JOURNAL_MAGIC, segment->data);
+    qToLittleEndian<quint32>(JOURNAL_VERSION, segment->data + 4);
+    qToLittleEndian<quint64>(firstSequence, segment->data + 8);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), segment->data + 16);
+    MappedFileUtils::flushMapped(segment->data, 0, SEGMENT_HEADER_BYTES, segment->file.handle());
+    MappedFileUtils::flushFile(segment->file.handle());
+
+    m_segment = segment;
+    m_writeOffset = SEGMENT_HEADER_BYTES;
+    m_syncedOffset = SEGMENT_HEADER_BYTES;
+    return true;
+}
+
+void EventJournal::rollSegment() {
+    // The old segment is made durable here, so the commit thread only ever
+    // has the current one to look after
+    MappedFileUtils::flushMapped(m_segment->data, m_syncedOffset, m_writeOffset, m_segment->file.handle());
+    const quint64 last = m_lastSequence.load();
+    {
+        QMutexLocker commitLocker(&m_commitMutex);
+        if (last > m_durableSequence.load()) m_durableSequence.store(last);
+    }
+    m_durableChanged.wakeAll();
+
+    m_segment.reset();
+    openSegment(last + 1);
+}
+
+void EventJournal::syncPending() {
+    std::shared_ptr<Segment> segment;
+    qint64 from = 0;
+    qint64 to = 0;
+    quint64 sequence = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_segment) return;
+        segment = m_segment;
+        from = m_syncedOffset;
+        to = m_writeOffset;
+        sequence = m_lastSequence.load();
+    }
+    if (sequence <= m_durableSequence.load() && from == to) return;
+
+    MappedFileUtils::flushMapped(segment->data, from, to, segment->file.handle());
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_segment == segment) {
+            m_syncedOffset = qMax(m_syncedOffset, to);
+        }
+    }
+    {
+        QMutexLocker commitLocker(&m_commitMutex);
+        if (sequence > m_durableSequence.load()) m_durableSequence.store(sequence);
+    }
+    m_durableChanged.wakeAll();
+}
+
+void EventJournal::commitLoop() {
+    forever {
+        bool stopping;
+        {
+            QMutexLocker locker(&m_commitMutex);
+            if (!m_stopping) {
+                m_commitWake.wait(&m_commitMutex, m_commitIntervalMs);
+            }
+            stopping = m_stopping;
+        }
+        syncPending();
+        if (stopping) break;
+    }
+}
+
+EventJournalReader::EventJournalReader(const QString& directory)
+    : m_directory(directory)
+{}
+
+qint64 EventJournalReader::read(qint64 startMs, qint64 endMs, const Visitor& visit) const {
+    qint64 visited = 0;
+    const QMap<quint64, QString> files = segmentsByFirstSequence();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        QFile file(it.value());
+        if (!file.open(QIODevice::ReadOnly) || file.size() < SEGMENT_HEADER_BYTES) continue;
+        const qint64 size = file.size();
+        const uchar* data = file.map(0, size);
+        if (!data) continue;
+        if (qFromLittleEndian<quint32>(data) != JOURNAL_MAGIC ||
+            qFromLittleEndian<quint32>(data + 4) != JOURNAL_VERSION) {
+            file.unmap(const_cast<uchar*>(data));
+            continue;
+        }
+
+        qint64 offset = SEGMENT_HEADER_BYTES;
+        quint64 sequence = it.key();
+        JournalEvent event;
+        while (qint64 bytes = validRecordAt(data, size, offset, sequence)) {
+            if (decodeRecord(data + offset, bytes, event) &&
+                event.timestampMs >= startMs && event.timestampMs <= endMs) {
+                visit(event);
+                ++visited;
+            }
+            offset += bytes;
+            ++sequence;
+        }
+        file.unmap(const_cast<uchar*>(data));
+    }
+    return visited;
+}
+
+qint64 EventJournalReader::exportRange(const QString& path, qint64 startMs, qint64 endMs) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        Logger::instance().error("EventJournal", "Cannot write " + path + ": " + file.errorString());
+        return -1;
+    }
+    QTextStream out(&file);
+
+    const bool csv = QFileInfo(path).suffix().compare("csv", Qt::CaseInsensitive) == 0;
+    qint64 written = 0;
+    if (csv) {
+        out << "sequence,timestamp,type,subject_id,track_id,actor_id,code,previous_code,"
+               "latitude,longitude,altitude,text\n";
+        written = read(startMs, endMs, [&out](const JournalEvent& e) {
+            out << e.sequence << ','
+                << QDateTime::fromMSecsSinceEpoch(e.timestampMs, Qt::UTC).toString(Qt::ISODateWithMs) << ','
+                << JournalEvent::typeName(e.type) << ','
+                << csvField(e.subjectId) << ',' << csvField(e.trackId) << ',' << csvField(e.actorId) << ','
+                << e.code << ',' << e.previousCode << ','
+                << QString::number(e.position.latitude, 'f', 7) << ','
+                << QString::number(e.position.longitude, 'f', 7) << ','
+                << QString::number(e.position.altitude, 'f', 2) << ','
+                << csvField(e.text) << '\n';
+        });
+    } else {
+        out << "[\n";
+        bool first = true;
+        written = read(startMs, endMs, [&out, &first](const JournalEvent& e) {
+            QJsonObject json;
+            json["sequence"] = static_cast<qint64>(e.sequence);
+            json["timestamp"] = QDateTime::fromMSecsSinceEpoch(e.timestampMs, Qt::UTC).toString(Qt::ISODateWithMs);
+            json["type"] = JournalEvent::typeName(e.type);
+            json["subjectId"] = e.subjectId;
+            json["trackId"] = e.trackId;
+            json["actorId"] = e.actorId;
+            json["code"] = e.code;
+            json["previousCode"] = e.previousCode;
+            json["latitude"] = e.position.latitude;
+            json["longitude"] = e.position.longitude;
+            json["altitude"] = e.position.altitude;
+            json["text"] = e.text;
+            out << (first ? "" : ",\n") << QJsonDocument(json).toJson(QJsonDocument::Compact);
+            first = false;
+        });
+        out << "\n]\n";
+    }
+    return written;
+}
+
+QMap<quint64, QString> EventJournalReader::segmentsByFirstSequence() const {
+    QMap<quint64, QString> files;
+    const QDir dir(m_directory);
+    const QStringList names = dir.entryList(QStringList() << "journal-*.cej", QDir::Files);
+    for (const QString& name : names) {
+        bool ok = false;
+        const quint64 firstSequence = QFileInfo(name).completeBaseName().mid(8).toULongLong(&ok);
+        if (ok) files.insert(firstSequence, dir.filePath(name));
+    }
+    return files;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,141 @@
+#ifndef EVENTJOURNAL_H
+#define EVENTJOURNAL_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "core/Track.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief Kinds of audit event; values are on disk, never renumber
+ */
+enum class JournalEventType : quint16 {
+    EngagementState = 1,    // code: new EngagementState, previousCode: old one
+    Authorization = 2,      // code: 1 granted, 0 denied, -1 timed out
+    EngagementResult = 3,   // code: BDAResult
+    Alert = 4,              // code: threat level
+    AlertAcknowledged = 5,
+    TrackCreated = 6,
+    TrackDropped = 7,
+    TrackClassified = 8,    // code: new TrackClassification
+    OperatorAction = 9
+};
+
+/**
+ * @brief One audit record; every type uses the same fields
+ */
+struct JournalEvent {
+    JournalEventType type = JournalEventType::OperatorAction;
+    quint64 sequence = 0;       // Assigned by the journal, gap-free
+    qint64 timestampMs = 0;     // Stamped by append() when 0
+    QString subjectId;          // Engagement, alert or track id
+    QString trackId;
+    QString actorId;            // Operator, effector or rule
+    qint32 code = 0;
+    qint32 previousCode = 0;
+    GeoPosition position;
+    QString text;               // Reason, message, action details
+
+    static QString typeName(JournalEventType type);
+};
+
+/**
+ * @brief Append-only, memory-mapped binary audit journal
+ *
+ * Records are encoded straight into a preallocated, mapped segment file
+ * (journal-<firstSequence>.cej), so append() is a memcpy under an
+ * uncontended mutex and never waits on the disk. A commit thread flushes
+ * the dirty range of the mapping every commitIntervalMs, one sync for
+ * everything appended since the last; waitDurable() blocks a caller that
+ * needs its record on disk. The mapping is shared with the page cache, so
+ * a process crash loses nothing; a power loss loses at most the last
+ * commit interval. Every record carries a CRC, and a torn tail is found
+ * and overwritten when the journal is reopened.
+ */
+class EventJournal {
+public:
+    static constexpr qint64 DEFAULT_SEGMENT_BYTES = 16 * 1024 * 1024;
+    static constexpr int DEFAULT_COMMIT_INTERVAL_MS = 20;
+
+    explicit EventJournal(const QString& directory, qint64 segmentBytes = DEFAULT_SEGMENT_BYTES,
+                          int commitIntervalMs = DEFAULT_COMMIT_INTERVAL_MS);
+    ~EventJournal();
+
+    EventJournal(const EventJournal&) = delete;
+    EventJournal& operator=(const EventJournal&) = delete;
+
+    // Recovers the end of the newest segment and starts the commit thread
+    bool open();
+    // Commits and unmaps; append() fails afterwards
+    void close();
+    bool isOpen() const;
+
+    // Any thread; returns the sequence given to the event, 0 on failure
+    quint64 append(const JournalEvent& event);
+    // Blocks until sequence is on disk or timeoutMs passes
+    bool waitDurable(quint64 sequence, int timeoutMs = 1000);
+    void commit();
+
+    quint64 lastSequence() const { return m_lastSequence.load(); }
+    quint64 durableSequence() const { return m_durableSequence.load(); }
+    QString directory() const { return m_directory; }
+
+private:
+    struct Segment;
+
+    bool openSegment(quint64 firstSequence);
+    void rollSegment();
+    void syncPending();
+    void commitLoop();
+
+    QString m_directory;
+    qint64 m_segmentBytes;
+    int m_commitIntervalMs;
+
+    mutable QMutex m_mutex;             // The segment and write offset
+    std::shared_ptr<Segment> m_segment;
+    qint64 m_writeOffset = 0;
+    qint64 m_syncedOffset = 0;          // Of m_segment, flushed to disk
+    std::atomic<quint64> m_lastSequence{0};
+    std::atomic<quint64> m_durableSequence{0};
+
+    QThread* m_thread = nullptr;
+    QMutex m_commitMutex;               // m_stopping and the durable wait
+    QWaitCondition m_commitWake;
+    QWaitCondition m_durableChanged;
+    bool m_stopping = false;
+};
+
+/**
+ * @brief Reads journal segments back, oldest first, and exports them
+ */
+class EventJournalReader {
+public:
+    using Visitor = std::function<void(const JournalEvent&)>;
+
+    explicit EventJournalReader(const QString& directory);
+
+    // Events stamped in [startMs, endMs]; returns how many were visited
+    qint64 read(qint64 startMs, qint64 endMs, const Visitor& visit) const;
+
+    // CSV for a .csv path, else a JSON array; returns the
+    // events written, -1 if the file cannot be written
+    qint64 exportRange(const QString& path, qint64 startMs, qint64 endMs) const;
+
+    QMap<quint64, QString> segmentsByFirstSequence() const;   // To path
+
+private:
+    QString m_directory;
+};
+
+} // namespace CounterUAS
+
+#endif // EVENTJOURNAL_H
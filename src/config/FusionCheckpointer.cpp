@@ -0,0 +1,354 @@
+#include "config/FusionCheckpointer.h"
+#include "config/CheckpointFile.h"
+#include "core/EngagementManager.h"
+#include "core/ThreatAssessor.h"
+#include "core/TrackManager.h"
+#include "utils/Clock.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QDataStream>
+#include <QThread>
+#include <QTimer>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint8 RECORD_VERSION = 1;
+
+// Keys: the manager state, the alerts, the engagements, then one per track
+constexpr quint64 KEY_STATE = 0;
+constexpr quint64 KEY_ALERTS = 1;
+constexpr quint64 KEY_ENGAGEMENTS = 2;
+constexpr quint64 TRACK_KEY_BASE = quint64(1) << 32;
+
+quint64 trackKey(TrackHandle handle) {
+    return TRACK_KEY_BASE | handle;
+}
+
+void setupStream(QDataStream& stream) {
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+}
+
+QByteArray encodeAlerts(const QList<ThreatAlert>& alerts) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    setupStream(out);
+    out << RECORD_VERSION << quint32(alerts.size());
+    for (const ThreatAlert& a : alerts) {
+        out << a.alertId << a.trackId << a.ruleId << a.message << qint32(a.threatLevel)
+            << a.timestamp << a.acknowledged << a.acknowledgedBy << a.acknowledgedTime;
+    }
+    return data;
+}
+
+bool decodeAlerts(const QByteArray& data, QList<ThreatAlert>& alerts) {
+    QDataStream in(data);
+    setupStream(in);
+    quint8 version = 0;
+    quint32 count = 0;
+    in >> version >> count;
+    if (version != RECORD_VERSION) return false;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ThreatAlert a;
+        qint32 level = 0;
+        in >> a.alertId >> a.trackId >> a.ruleId >> a.message >> level
+           >> a.timestamp >> a.acknowledged >> a.acknowledgedBy >> a.acknowledgedTime;
+        a.threatLevel = level;
+        alerts.append(a);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+QByteArray encodeEngagements(const QList<EngagementRecord>& records) {
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    setupStream(out);
+    out << RECORD_VERSION << quint32(records.size());
+    for (const EngagementRecord& r : records) {
+        out << r.engagementId << r.trackId << r.effectorId << r.effectorType << r.operatorId
+            << r.startTime << r.authorizationTime << r.executionTime << r.completionTime
+            << quint8(r.state) << quint8(r.bdaResult)
+            << r.targetPosition.latitude << r.targetPosition.longitude << r.targetPosition.altitude
+            << r.targetDistance << qint32(r.threatLevel) << r.snapshotId << r.notes;
+    }
+    return data;
+}
+
+bool decodeEngagements(const QByteArray& data, QList<EngagementRecord>& records) {
+    QDataStream in(data);
+    setupStream(in);
+    quint8 version = 0;
+    quint32 count = 0;
+    in >> version >> count;
+    if (version != RECORD_VERSION) return false;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        EngagementRecord r;
+        quint8 state = 0, bda = 0;
+        qint32 level = 0;
+        in >> r.engagementId >> r.trackId >> r.effectorId >> r.effectorType >> r.operatorId
+           >> r.startTime >> r.authorizationTime >> r.executionTime >> r.completionTime
+           >> state >> bda
+           >> r.targetPosition.latitude >> r.targetPosition.longitude >> r.targetPosition.altitude
+           >> r.targetDistance >> level >> r.snapshotId >> r.notes;
+        r.state = static_cast<EngagementState>(state);
+        r.bdaResult = static_cast<BDAResult>(bda);
+        r.threatLevel = level;
+        records.append(r);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+FusionCheckpointer::FusionCheckpointer(TrackManager* trackManager, ThreatAssessor* threatAssessor,
+                                       EngagementManager* engagementManager, QObject* parent)
+    : QObject(parent)
+    , m_trackManager(trackManager)
+    , m_threatAssessor(threatAssessor)
+    , m_engagementManager(engagementManager)
+{
+    connect(m_trackManager, &TrackManager::tracksChanged, this, &FusionCheckpointer::onTracksChanged);
+    if (m_threatAssessor) {
+        auto markAlerts = [this]() { m_alertsDirty = true; };
+        connect(m_threatAssessor, &ThreatAssessor::newAlert, this, markAlerts);
+        connect(m_threatAssessor, &ThreatAssessor::alertAcknowledged, this, markAlerts);
+        connect(m_threatAssessor, &ThreatAssessor::alertEvicted, this, markAlerts);
+        connect(m_threatAssessor, &ThreatAssessor::alertsCleared, this, markAlerts);
+    }
+}
+
+FusionCheckpointer::~FusionCheckpointer() {
+    stop();
+}
+
+void FusionCheckpointer::setConfig(const FusionCheckpointConfig& config) {
+    m_config = config;
+    m_config.intervalMs = qMax(50, config.intervalMs);
+}
+
+FusionCheckpointer::RestoreResult FusionCheckpointer::restore() {
+    RestoreResult result;
+    if (m_thread || m_config.path.isEmpty()) return result;
+
+    const qint64 startNs = TimeUtils::monotonicNs();
+    CheckpointFile file(m_config.regionBytes);
+    if (!file.open(m_config.path)) {
+        m_error = file.errorString();
+        Logger::instance().warning("FusionCheckpointer", "Cannot open checkpoint: " + m_error);
+        return result;
+    }
+    const QHash<quint64, QByteArray> records = file.load();
+    file.close();
+    if (!records.contains(KEY_STATE)) return result;
+
+    const QByteArray header = records.value(KEY_STATE);
+    QDataStream in(header);
+    setupStream(in);
+    quint8 version = 0;
+    qint64 savedAtMs = 0;
+    QByteArray state;
+    in >> version >> savedAtMs >> state;
+    if (version != RECORD_VERSION || in.status() != QDataStream::Ok) return result;
+
+    result.ageMs = m_trackManager->clock()->nowMs() - savedAtMs;
+    if (result.ageMs < 0 || result.ageMs > m_config.maxRestoreAgeMs) {
+        Logger::instance().info("FusionCheckpointer",
+            QString("Checkpoint is %1 old, starting cold").arg(TimeUtils::formatDuration(result.ageMs)));
+        return result;
+    }
+
+    QVector<QByteArray> tracks;
+    tracks.reserve(records.size());
+    for (auto it = records.constBegin(); it != records.constEnd(); ++it) {
+        if (it.key() >= TRACK_KEY_BASE) tracks.append(it.value());
+    }
+    result.tracks = m_trackManager->restoreCheckpoint(state, tracks);
+    if (result.tracks < 0) {
+        result.tracks = 0;
+        Logger::instance().warning("FusionCheckpointer", "Checkpoint not restored into a live picture");
+        return result;
+    }
+    result.restored = true;
+
+    QList<ThreatAlert> alerts;
+    if (m_threatAssessor && records.contains(KEY_ALERTS) &&
+        decodeAlerts(records.value(KEY_ALERTS), alerts)) {
+        m_threatAssessor->restoreAlerts(alerts);
+        result.alerts = alerts.size();
+    }
+    QList<EngagementRecord> engagements;
+    if (m_engagementManager && records.contains(KEY_ENGAGEMENTS) &&
+        decodeEngagements(records.value(KEY_ENGAGEMENTS), engagements)) {
+        m_engagementManager->restoreInterruptedEngagements(engagements);
+        result.engagements = engagements.size();
+    }
+
+    result.elapsedUs = (TimeUtils::monotonicNs() - startNs) / 1000;
+    Logger::instance().info("FusionCheckpointer",
+        QString("Restored %1 tracks, %2 alerts from a checkpoint %3 old in %4 us; "
+                "%5 interrupted engagements recorded as aborted")
+            .arg(result.tracks).arg(result.alerts).arg(TimeUtils::formatDuration(result.ageMs))
+            .arg(result.elapsedUs).arg(result.engagements));
+    return result;
+}
+
+bool FusionCheckpointer::start() {
+    if (m_thread) return true;
+    if (m_config.path.isEmpty()) return false;
+
+    m_file.reset(new CheckpointFile(m_config.regionBytes));
+    if (!m_file->open(m_config.path)) {
+        m_error = m_file->errorString();
+        Logger::instance().error("FusionCheckpointer", "Cannot open " + m_config.path + ": " + m_error);
+        m_file.reset();
+        return false;
+    }
+    m_records.clear();
+    m_fullPending = true;
+    m_alertsDirty = true;
+    m_lastEngagements.clear();
+    m_dirtyTracks.clear();
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("FusionCheckpoint");
+    m_context = new QObject;
+    m_context->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread->start();
+
+    m_timer = new QTimer(this);
+    m_timer->setInterval(m_config.intervalMs);
+    connect(m_timer, &QTimer::timeout, this, &FusionCheckpointer::checkpointNow);
+    m_timer->start();
+
+    m_error.clear();
+    Logger::instance().info("FusionCheckpointer",
+        QString("Checkpointing to %1 every %2 ms").arg(m_config.path).arg(m_config.intervalMs));
+    return true;
+}
+
+void FusionCheckpointer::stop() {
+    if (!m_thread) return;
+
+    checkpointNow();
+    delete m_timer;
+    m_timer = nullptr;
+
+    // Pending batches are written before the thread quits
+    QMetaObject::invokeMethod(m_context, [this]() { m_file->sync(); }, Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_context = nullptr;
+    m_file.reset();
+    m_records.clear();
+}
+
+void FusionCheckpointer::onTracksChanged(const TrackChangeSet& changes) {
+    for (TrackHandle handle : changes.handles) {
+        m_dirtyTracks.insert(handle);
+    }
+}
+
+void FusionCheckpointer::checkpointNow() {
+    if (!m_thread) return;
+
+    const qint64 startNs = TimeUtils::monotonicNs();
+    Batch batch;
+    batch.full = m_fullPending;
+
+    QVector<QPair<TrackHandle, QByteArray>> tracks;
+    if (batch.full) {
+        m_trackManager->checkpointTracks(nullptr, tracks);
+    } else if (!m_dirtyTracks.isEmpty()) {
+        const QVector<TrackHandle> handles(m_dirtyTracks.constBegin(), m_dirtyTracks.constEnd());
+        m_trackManager->checkpointTracks(&handles, tracks);
+    }
+    m_dirtyTracks.clear();
+    batch.records.reserve(tracks.size() + 3);
+    for (const auto& track : tracks) {
+        batch.records.append(qMakePair(trackKey(track.first), track.second));
+    }
+
+    if (m_threatAssessor && (m_alertsDirty || batch.full)) {
+        batch.records.append(qMakePair(KEY_ALERTS, encodeAlerts(m_threatAssessor->alerts())));
+        m_alertsDirty = false;
+    }
+    if (m_engagementManager) {
+        // A handful of records; cheaper to compare than to track every transition
+        const QByteArray engagements = encodeEngagements(m_engagementManager->inFlightEngagements());
+        if (batch.full || engagements != m_lastEngagements) {
+            batch.records.append(qMakePair(KEY_ENGAGEMENTS, engagements));
+            m_lastEngagements = engagements;
+        }
+    }
+
+    // The state record last: a torn batch restores with the previous one
+    QByteArray state;
+    QDataStream out(&state, QIODevice::WriteOnly);
+    setupStream(out);
+    out << RECORD_VERSION << m_trackManager->clock()->nowMs() << m_trackManager->checkpointState();
+    batch.records.append(qMakePair(KEY_STATE, state));
+    m_fullPending = false;
+
+    m_lastEncodeUs.store((TimeUtils::monotonicNs() - startNs) / 1000, std::memory_order_relaxed);
+    QMetaObject::invokeMethod(m_context, [this, batch]() { write(batch); });
+}
+
+void FusionCheckpointer::write(const Batch& batch) {
+    if (batch.full) m_records.clear();
+    for (const auto& record : batch.records) {
+        if (record.second.isEmpty()) {
+            m_records.remove(record.first);
+        } else {
+            m_records.insert(record.first, record.second);
+        }
+    }
+
+    bool appended = !batch.full;
+    quint64 bytes = 0;
+    if (appended) {
+        for (const auto& record : batch.records) {
+            if (!m_file->append(record.first, record.second)) {
+                appended = false;
+                break;
+            }
+            bytes += record.second.size();
+        }
+    }
+    if (!appended) {
+        // A fresh picture, or the region is full: rewrite the live records
+        if (!m_file->compact(m_records)) {
+            m_failures.fetch_add(1, std::memory_order_relaxed);
+            Logger::instance().error("FusionCheckpointer", m_file->errorString());
+            return;
+        }
+        m_compactions.fetch_add(1, std::memory_order_relaxed);
+        bytes = 0;
+        for (auto it = m_records.constBegin(); it != m_records.constEnd(); ++it) {
+            bytes += it.value().size();
+        }
+    }
+    if (m_config.syncToDisk) m_file->sync();
+
+    m_checkpoints.fetch_add(1, std::memory_order_relaxed);
+    m_recordsWritten.fetch_add(appended ? batch.records.size() : m_records.size(),
+                               std::memory_order_relaxed);
+    m_bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+FusionCheckpointer::Statistics FusionCheckpointer::statistics() const {
+    Statistics stats;
+    stats.checkpoints = m_checkpoints.load(std::memory_order_relaxed);
+    stats.recordsWritten = m_recordsWritten.load(std::memory_order_relaxed);
+    stats.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+    stats.compactions = m_compactions.load(std::memory_order_relaxed);
+    stats.failures = m_failures.load(std::memory_order_relaxed);
+    stats.lastEncodeUs = m_lastEncodeUs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,128 @@
+#ifndef FUSIONCHECKPOINTER_H
+#define FUSIONCHECKPOINTER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "core/TrackChangeSet.h"
+
+class QThread;
+class QTimer;
+
+namespace CounterUAS {
+
+class CheckpointFile;
+class EngagementManager;
+class ThreatAssessor;
+class TrackManager;
+
+/**
+ * @brief Checkpoint file location and cadence
+ */
+struct FusionCheckpointConfig {
+    QString path;                       // Empty disables checkpointing
+    int intervalMs = 1000;              // Worst-case state lost to a crash
+    qint64 regionBytes = 16 * 1024 * 1024;
+    qint64 maxRestoreAgeMs = 300000;    // Older checkpoints start cold
+    bool syncToDisk = false;            // Also survive power loss, at an msync per interval
+};
+
+/**
+ * @brief Periodic binary checkpoint of the fusion state, for a warm restart
+ *
+ * Saves what a restart would otherwise rebuild over many scans: every
+ * live track with its history and filter slot, the tentatives and id
+ * sequence (TrackManager::checkpointTracks(), checkpointState()), the
+ * threat alerts and the engagements in flight. Only the tracks changed
+ * since the last interval are encoded, on the owner thread under the
+ * manager's read lock; the bytes go to a writer thread that appends them
+ * to a CheckpointFile and compacts it from its own copy of the live
+ * records when the active region fills.
+ *
+ * restore() runs once at startup, before start() and before any sensor
+ * feeds the manager. It rebuilds the managers from the file, aged by the
+ * time since the last checkpoint, so the picture is populated before the
+ * first scan comes in.
+ */
+class FusionCheckpointer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FusionCheckpointer(TrackManager* trackManager,
+                                ThreatAssessor* threatAssessor = nullptr,
+                                EngagementManager* engagementManager = nullptr,
+                                QObject* parent = nullptr);
+    ~FusionCheckpointer() override;
+
+    void setConfig(const FusionCheckpointConfig& config);   // Applied on the next start()
+    FusionCheckpointConfig config() const { return m_config; }
+
+    struct RestoreResult {
+        bool restored = false;
+        int tracks = 0;
+        int alerts = 0;
+        int engagements = 0;        // Recorded as aborted
+        qint64 ageMs = 0;           // Of the checkpoint when restored
+        qint64 elapsedUs = 0;
+    };
+    RestoreResult restore();
+
+    bool start();
+    void stop();                    // Writes a last checkpoint first
+    bool isRunning() const { return m_thread != nullptr; }
+    QString errorString() const { return m_error; }
+
+    void checkpointNow();
+
+    struct Statistics {
+        quint64 checkpoints = 0;
+        quint64 recordsWritten = 0;
+        quint64 bytesWritten = 0;
+        quint64 compactions = 0;
+        quint64 failures = 0;       // Checkpoints that did not fit the file
+        qint64 lastEncodeUs = 0;    // Owner thread time of the last checkpoint
+    };
+    Statistics statistics() const;
+
+private:
+    struct Batch {
+        QVector<QPair<quint64, QByteArray>> records;   // Empty data deletes the key
+        bool full = false;          // Replaces every record
+    };
+
+    void onTracksChanged(const TrackChangeSet& changes);
+    void write(const Batch& batch);     // Writer thread
+
+    TrackManager* m_trackManager;
+    ThreatAssessor* m_threatAssessor;
+    EngagementManager* m_engagementManager;
+    FusionCheckpointConfig m_config;
+    QString m_error;
+
+    QTimer* m_timer = nullptr;
+    QSet<TrackHandle> m_dirtyTracks;
+    bool m_alertsDirty = true;
+    bool m_fullPending = true;
+    QByteArray m_lastEngagements;
+
+    QThread* m_thread = nullptr;
+    QObject* m_context = nullptr;               // Lives on m_thread
+    std::unique_ptr<CheckpointFile> m_file;     // Writer thread once started
+    QHash<quint64, QByteArray> m_records;       // Writer thread: the file's live records
+
+    std::atomic<quint64> m_checkpoints{0};
+    std::atomic<quint64> m_recordsWritten{0};
+    std::atomic<quint64> m_bytesWritten{0};
+    std::atomic<quint64> m_compactions{0};
+    std::atomic<quint64> m_failures{0};
+    std::atomic<qint64> m_lastEncodeUs{0};
+};
+
+} // namespace CounterUAS
+
+#endif // FUSIONCHECKPOINTER_H
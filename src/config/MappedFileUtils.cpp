@@ -0,0 +1,56 @@
+#include "config/MappedFileUtils.h"
+#include <array>
+
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace CounterUAS {
+
+quint32 MappedFileUtils::crc32(const uchar* data, qint64 length) {
+    static const auto table = []() {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (qint64 i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void MappedFileUtils::flushMapped(uchar* base, qint64 from, qint64 to, int fileHandle) {
+    if (to <= from) return;
+#ifdef Q_OS_WIN
+    FlushViewOfFile(base + from, static_cast<SIZE_T>(to - from));
+    FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(fileHandle)));
+#else
+    Q_UNUSED(fileHandle)
+    static const qint64 page = sysconf(_SC_PAGESIZE);
+    const qint64 start = from - from % page;
+    msync(base + start, static_cast<size_t>(to - start), MS_SYNC);
+#endif
+}
+
+void MappedFileUtils::flushFile(int fileHandle) {
+#ifdef Q_OS_WIN
+    FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(fileHandle)));
+#else
+    fsync(fileHandle);
+#endif
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,26 @@
+#ifndef MAPPEDFILEUTILS_H
+#define MAPPEDFILEUTILS_H
+
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Checksums and durability for the memory-mapped stores
+ */
+class MappedFileUtils {
+public:
+    // CRC-32 (IEEE 802.3) of the bytes
+    static quint32 crc32(const uchar* data, qint64 length);
+
+    static qint64 align8(qint64 bytes) { return (bytes + 7) & ~qint64(7); }
+
+    // Flushes [from, to) of a mapping to disk
+    static void flushMapped(uchar* base, qint64 from, qint64 to, int fileHandle);
+    // File size and metadata, after resizing a mapped file
+    static void flushFile(int fileHandle);
+};
+
+} // namespace CounterUAS
+
+#endif // MAPPEDFILEUTILS_H
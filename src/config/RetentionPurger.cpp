@@ -0,0 +1,231 @@
+#include "config/RetentionPurger.h"
+#include "core/EngagementManager.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QVector>
+#include <vector>
+
+namespace CounterUAS {
+
+namespace {
+
+struct PurgeTable {
+    const char* name;
+    QString expired;                // Rows past the cutoff, by an indexed column
+};
+
+// In DatabaseManager's schema; each condition leads with an indexed column
+QVector<PurgeTable> purgeTables() {
+    return {
+        {"tracks", "timestamp < :cutoff"},
+        {"operator_actions", "timestamp < :cutoff"},
+        // Only engagements that have ended; an open one keeps its record
+        {"engagements", QString("completion_time < :cutoff AND state >= %1")
+                            .arg(static_cast<int>(EngagementState::Completed))},
+    };
+}
+
+} // namespace
+
+RetentionPurger::RetentionPurger(const RetentionPurgeConfig& config)
+{
+    setConfig(config);
+}
+
+RetentionPurger::~RetentionPurger() {
+    stop();
+}
+
+void RetentionPurger::setConfig(const RetentionPurgeConfig& config) {
+    QMutexLocker locker(&m_mutex);
+    m_config = config;
+    m_config.batchRows = qMax(1, m_config.batchRows);
+    m_config.pauseMs = qMax(0, m_config.pauseMs);
+}
+
+RetentionPurgeConfig RetentionPurger::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+bool RetentionPurger::start(const QString& databasePath) {
+    if (m_thread) return true;
+    m_databasePath = databasePath;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+    }
+
+    const QString connectionName = QString("retention-purge-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    m_thread = QThread::create([this, connectionName]() { purgeLoop(connectionName); });
+    m_thread->setObjectName("RetentionPurger");
+    m_thread->start(QThread::LowPriority);
+    return true;
+}
+
+void RetentionPurger::stop() {
+    if (!m_thread) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    QMutexLocker locker(&m_mutex);
+    m_busy = false;
+    m_idle.wakeAll();
+}
+
+void RetentionPurger::purgeBefore(qint64 cutoffMs) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (cutoffMs <= m_requestedMs) return;
+        m_requestedMs = cutoffMs;
+    }
+    m_wake.wakeAll();
+}
+
+bool RetentionPurger::waitIdle(int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    QMutexLocker locker(&m_mutex);
+    while (m_thread && !m_stopping && (m_busy || m_purgedMs < m_requestedMs)) {
+        if (timeoutMs < 0) {
+            m_idle.wait(&m_mutex);
+            continue;
+        }
+        const qint64 left = timeoutMs - timer.elapsed();
+        if (left <= 0 || !m_idle.wait(&m_mutex, static_cast<unsigned long>(left))) {
+            return !m_busy && m_purgedMs >= m_requestedMs;
+        }
+    }
+    return !m_busy && m_purgedMs >= m_requestedMs;
+}
+
+RetentionPurgeStats RetentionPurger::stats() const {
+    RetentionPurgeStats stats;
+    {
+        QMutexLocker locker(&m_mutex);
+        stats.purgedBeforeMs = m_purgedMs;
+        stats.busy = m_busy;
+        stats.batchDuration = m_batchDuration;
+    }
+    stats.rowsDeleted = m_rowsDeleted.load();
+    stats.batches = m_batches.load();
+    stats.passes = m_passes.load();
+    stats.errors = m_errors.load();
+    return stats;
+}
+
+bool RetentionPurger::pause(int ms) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_stopping && ms > 0) {
+        m_wake.wait(&m_mutex, static_cast<unsigned long>(ms));
+    }
+    return !m_stopping;
+}
+
+void RetentionPurger::purgeLoop(const QString& connectionName) {
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(m_databasePath);
+        // Writers hold the lock for a commit at a time; wait those out
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=2000");
+        const bool open = db.open();
+        if (!open) {
+            Logger::instance().error("RetentionPurger", "Failed to open database: " + db.lastError().text());
+        }
+
+        const QVector<PurgeTable> tables = purgeTables();
+        std::vector<QSqlQuery> deletes;
+        if (open) {
+            QSqlQuery pragma(db);
+            pragma.exec("PRAGMA synchronous=NORMAL");
+            for (const PurgeTable& table : tables) {
+                // Bounded by rowid, through the time index, so a batch is
+                // a short range scan however large the table
+                deletes.emplace_back(db);
+                deletes.back().prepare(QString("DELETE FROM %1 WHERE rowid IN "
+                                               "(SELECT rowid FROM %1 WHERE %2 LIMIT :rows)")
+                                           .arg(table.name, table.expired));
+            }
+        }
+
+        forever {
+            qint64 cutoffMs;
+            {
+                QMutexLocker locker(&m_mutex);
+                while (!m_stopping && m_requestedMs <= m_purgedMs) {
+                    m_busy = false;
+                    m_idle.wakeAll();
+                    m_wake.wait(&m_mutex);
+                }
+                if (m_stopping) break;
+                cutoffMs = m_requestedMs;
+                m_busy = true;
+            }
+
+            quint64 rows = 0;
+            bool running = true;
+            for (size_t i = 0; running && i < deletes.size(); ++i) {
+                forever {
+                    const RetentionPurgeConfig config = this->config();
+                    QSqlQuery& query = deletes[i];
+                    query.bindValue(":cutoff", cutoffMs);
+                    query.bindValue(":rows", config.batchRows);
+
+                    const qint64 startNs = TimeUtils::monotonicNs();
+                    if (!query.exec()) {
+                        m_errors.fetch_add(1, std::memory_order_relaxed);
+                        Logger::instance().warning("RetentionPurger",
+                            QString("Purge of %1 failed: %2").arg(tables.at(int(i)).name, query.lastError().text()));
+                        break;
+                    }
+                    const int deleted = qMax(0, query.numRowsAffected());
+                    {
+                        QMutexLocker locker(&m_mutex);
+                        m_batchDuration.record((TimeUtils::monotonicNs() - startNs) / 1000);
+                    }
+                    m_batches.fetch_add(1, std::memory_order_relaxed);
+                    m_rowsDeleted.fetch_add(deleted, std::memory_order_relaxed);
+                    rows += deleted;
+
+                    if (deleted < config.batchRows) break;
+                    if (!pause(config.pauseMs)) {
+                        running = false;
+                        break;
+                    }
+                }
+            }
+            if (!running) break;
+
+            // A failed pass is not retried until a later cutoff comes
+            m_passes.fetch_add(1, std::memory_order_relaxed);
+            {
+                QMutexLocker locker(&m_mutex);
+                m_purgedMs = cutoffMs;
+            }
+            if (rows > 0) {
+                Logger::instance().info("RetentionPurger",
+                    QString("Purged %1 rows older than %2")
+                        .arg(rows).arg(QDateTime::fromMSecsSinceEpoch(cutoffMs, Qt::UTC).toString(Qt::ISODate)));
+            }
+        }
+
+        for (QSqlQuery& query : deletes) query.finish();
+        deletes.clear();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,96 @@
+#ifndef RETENTIONPURGER_H
+#define RETENTIONPURGER_H
+
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include "utils/LatencyStats.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief Pacing of the retention purge
+ */
+struct RetentionPurgeConfig {
+    int batchRows = 500;            // Rows deleted per transaction
+    int pauseMs = 50;               // Between batches, so writers get the lock
+};
+
+/**
+ * @brief Purge counters, safe to read from any thread
+ */
+struct RetentionPurgeStats {
+    quint64 rowsDeleted = 0;
+    quint64 batches = 0;
+    quint64 passes = 0;             // Cutoffs worked through
+    quint64 errors = 0;             // Batches that failed, ending their pass
+    qint64 purgedBeforeMs = 0;      // Cutoff of the last finished pass
+    bool busy = false;
+    LatencyStats batchDuration;     // One DELETE, microseconds
+};
+
+/**
+ * @brief Deletes rows past retention from a thread and connection of its own
+ *
+ * purgeBefore() only records the cutoff. The purge thread then deletes the
+ * rows older than it from each time-keyed table, oldest first, batchRows
+ * at a time through the table's time index, each batch its own short
+ * transaction with pauseMs between them. SQLite holds the write lock for
+ * one batch rather than for the whole backlog, so the history writer and
+ * the GUI connection interleave their commits with the purge instead of
+ * stalling behind it. A newer cutoff given mid-pass is taken up when the
+ * pass ends.
+ */
+class RetentionPurger {
+public:
+    explicit RetentionPurger(const RetentionPurgeConfig& config = RetentionPurgeConfig());
+    ~RetentionPurger();
+
+    RetentionPurger(const RetentionPurger&) = delete;
+    RetentionPurger& operator=(const RetentionPurger&) = delete;
+
+    // Taken up by the next batch
+    void setConfig(const RetentionPurgeConfig& config);
+    RetentionPurgeConfig config() const;
+
+    bool start(const QString& databasePath);
+    // Abandons a pass in progress between batches
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+
+    // Any thread; returns at once. An older cutoff than one already given is ignored
+    void purgeBefore(qint64 cutoffMs);
+    // True once every cutoff given is purged, false on timing out
+    bool waitIdle(int timeoutMs = -1);
+
+    RetentionPurgeStats stats() const;
+
+private:
+    void purgeLoop(const QString& connectionName);
+    bool pause(int ms);
+
+    QString m_databasePath;
+    QThread* m_thread = nullptr;
+
+    mutable QMutex m_mutex;             // Guards everything below but the counters
+    QWaitCondition m_wake;
+    QWaitCondition m_idle;
+    RetentionPurgeConfig m_config;
+    bool m_stopping = false;
+    bool m_busy = false;
+    qint64 m_requestedMs = 0;
+    qint64 m_purgedMs = 0;
+    LatencyStats m_batchDuration;
+
+    std::atomic<quint64> m_rowsDeleted{0};
+    std::atomic<quint64> m_batches{0};
+    std::atomic<quint64> m_passes{0};
+    std::atomic<quint64> m_errors{0};
+};
+
+} // namespace CounterUAS
+
+#endif // RETENTIONPURGER_H
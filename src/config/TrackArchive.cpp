@@ -0,0 +1,517 @@
+#include "config/TrackArchive.h"
+#include "utils/Logger.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 DATA_MAGIC = 0x41545543;      // "CUTA"
+constexpr quint32 INDEX_MAGIC = 0x49545543;     // "CUTI"
+constexpr quint32 FORMAT_VERSION = 1;
+constexpr int DATA_HEADER_BYTES = 8;            // magic, version
+constexpr int INDEX_HEADER_BYTES = 24;          // magic, version, start, duration
+constexpr int INDEX_ENTRY_BYTES = 40;           // first, last, offset, bytes, samples, tracks, reserved
+
+enum Column { TrackColumn, TimeColumn, LatitudeColumn, LongitudeColumn, AltitudeColumn, ColumnCount };
+
+constexpr double DEGREE_SCALE = 1e7;
+constexpr double ALTITUDE_SCALE = 100.0;
+
+template <typename T>
+void appendLE(QByteArray& out, T value) {
+    uchar bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    out.append(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+template <typename T>
+T readLE(const uchar* p) {
+    return qFromLittleEndian<T>(p);
+}
+
+quint64 zigzag(qint64 value) {
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+qint64 unzigzag(quint64 value) {
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+void appendVarint(QByteArray& out, quint64 value) {
+    char bytes[10];
+    int n = 0;
+    while (value >= 0x80) {
+        bytes[n++] = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    bytes[n++] = static_cast<char>(value);
+    out.append(bytes, n);
+}
+
+// False when the varint runs past end
+bool readVarint(const uchar*& p, const uchar* end, quint64& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uchar byte = *p++;
+        value |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+qint64 floorDiv(qint64 value, qint64 divisor) {
+    qint64 q = value / divisor;
+    if ((value % divisor != 0) && ((value < 0) != (divisor < 0))) --q;
+    return q;
+}
+
+QString partitionBaseName(qint64 startMs) {
+    return QString("tracks-%1").arg(startMs);
+}
+
+} // namespace
+
+/**
+ * @brief The block being filled, encoded as samples arrive
+ */
+struct TrackArchiveWriter::Block {
+    struct TrackState {
+        qint64 latitude = 0;
+        qint64 longitude = 0;
+        qint64 altitude = 0;
+    };
+
+    QHash<QString, int> trackIndex;
+    QVector<QString> trackIds;
+    QVector<TrackState> last;           // Per track, quantised
+    QByteArray columns[ColumnCount];
+    qint64 baseMs = 0;
+    qint64 firstMs = 0;
+    qint64 lastMs = 0;
+    qint64 previousMs = 0;
+    int samples = 0;
+
+    void clear() {
+        trackIndex.clear();
+        trackIds.clear();
+        last.clear();
+        for (QByteArray& column : columns) column.clear();
+        samples = 0;
+    }
+};
+
+TrackArchiveWriter::TrackArchiveWriter(const TrackArchiveConfig& config)
+    : m_config(config)
+    , m_block(new Block)
+{
+    m_config.partitionMs = qMax<qint64>(1000, m_config.partitionMs);
+    m_config.blockMs = qMax(1, m_config.blockMs);
+    m_config.blockSamples = qMax(1, m_config.blockSamples);
+    QDir().mkpath(m_config.directory);
+}
+
+TrackArchiveWriter::~TrackArchiveWriter() {
+    seal();
+    closePartition();
+}
+
+bool TrackArchiveWriter::append(const QString& trackId, qint64 timestamp, const GeoPosition& position) {
+    const qint64 partitionStart = floorDiv(timestamp, m_config.partitionMs) * m_config.partitionMs;
+    if (!m_data || partitionStart != m_partitionStartMs) {
+        seal();
+        if (!openPartition(partitionStart)) return false;
+    }
+
+    Block& block = *m_block;
+    if (block.samples >= m_config.blockSamples ||
+        (block.samples > 0 && timestamp - block.firstMs >= m_config.blockMs)) {
+        if (!seal()) return false;
+    }
+
+    if (block.samples == 0) {
+        block.baseMs = timestamp;
+        block.firstMs = timestamp;
+        block.lastMs = timestamp;
+        block.previousMs = timestamp;
+    }
+
+    int track = block.trackIndex.value(trackId, -1);
+    if (track < 0) {
+        track = block.trackIds.size();
+        block.trackIndex.insert(trackId, track);
+        block.trackIds.append(trackId);
+        block.last.append(Block::TrackState());
+    }
+
+    const qint64 latitude = std::llround(position.latitude * DEGREE_SCALE);
+    const qint64 longitude = std::llround(position.longitude * DEGREE_SCALE);
+    const qint64 altitude = std::llround(position.altitude * ALTITUDE_SCALE);
+    Block::TrackState& last = block.last[track];
+
+    appendVarint(block.columns[TrackColumn], static_cast<quint64>(track));
+    appendVarint(block.columns[TimeColumn], zigzag(timestamp - block.previousMs));
+    appendVarint(block.columns[LatitudeColumn], zigzag(latitude - last.latitude));
+    appendVarint(block.columns[LongitudeColumn], zigzag(longitude - last.longitude));
+    appendVarint(block.columns[AltitudeColumn], zigzag(altitude - last.altitude));
+
+    last.latitude = latitude;
+    last.longitude = longitude;
+    last.altitude = altitude;
+    block.previousMs = timestamp;
+    block.firstMs = qMin(block.firstMs, timestamp);
+    block.lastMs = qMax(block.lastMs, timestamp);
+    ++block.samples;
+    return true;
+}
+
+bool TrackArchiveWriter::seal() {
+    Block& block = *m_block;
+    if (block.samples == 0 || !m_data) return true;
+
+    QByteArray payload;
+    int columnBytes = 0;
+    for (const QByteArray& column : block.columns) columnBytes += column.size();
+    payload.reserve(32 + block.trackIds.size() * 12 + columnBytes);
+
+    appendLE<quint32>(payload, static_cast<quint32>(block.samples));
+    appendLE<quint32>(payload, static_cast<quint32>(block.trackIds.size()));
+    for (const QString& trackId : block.trackIds) {
+        const QByteArray utf8 = trackId.toUtf8().left(0xFFFF);
+        appendLE<quint16>(payload, static_cast<quint16>(utf8.size()));
+        payload.append(utf8);
+    }
+    appendLE<qint64>(payload, block.baseMs);
+    for (const QByteArray& column : block.columns) {
+        appendLE<quint32>(payload, static_cast<quint32>(column.size()));
+    }
+    for (const QByteArray& column : block.columns) {
+        payload.append(column);
+    }
+
+    const qint64 offset = m_data->size();
+    const bool written = m_data->write(payload) == payload.size() && m_data->flush();
+
+    QByteArray entry;
+    if (written) {
+        entry.reserve(INDEX_ENTRY_BYTES);
+        appendLE<qint64>(entry, block.firstMs);
+        appendLE<qint64>(entry, block.lastMs);
+        appendLE<qint64>(entry, offset);
+        appendLE<quint32>(entry, static_cast<quint32>(payload.size()));
+        appendLE<quint32>(entry, static_cast<quint32>(block.samples));
+        appendLE<quint32>(entry, static_cast<quint32>(block.trackIds.size()));
+        appendLE<quint32>(entry, 0);
+    }
+    // The data is on file before the entry that points at it
+    const bool indexed = written && m_index->write(entry) == entry.size() && m_index->flush();
+
+    if (!indexed) {
+        Logger::instance().warning("TrackArchive",
+            QString("Failed to write %1 samples to %2: %3")
+                .arg(block.samples).arg(m_data->fileName())
+                .arg(written ? m_index->errorString() : m_data->errorString()));
+        block.clear();
+        return false;
+    }
+
+    ++m_blocksWritten;
+    m_bytesWritten += payload.size() + entry.size();
+    block.clear();
+    return true;
+}
+
+bool TrackArchiveWriter::openPartition(qint64 startMs) {
+    closePartition();
+
+    const QString base = QDir(m_config.directory).filePath(partitionBaseName(startMs));
+    std::unique_ptr<QFile> data(new QFile(base + ".cta"));
+    std::unique_ptr<QFile> index(new QFile(base + ".cti"));
+    if (!data->open(QIODevice::WriteOnly | QIODevice::Append) ||
+        !index->open(QIODevice::WriteOnly | QIODevice::Append)) {
+        Logger::instance().error("TrackArchive", "Failed to open partition " + base + ": " +
+                                 (data->isOpen() ? index->errorString() : data->errorString()));
+        return false;
+    }
+
+    if (data->size() == 0) {
+        QByteArray header;
+        appendLE<quint32>(header, DATA_MAGIC);
+        appendLE<quint32>(header, FORMAT_VERSION);
+        data->write(header);
+    }
+    if (index->size() == 0) {
+        QByteArray header;
+        appendLE<quint32>(header, INDEX_MAGIC);
+        appendLE<quint32>(header, FORMAT_VERSION);
+        appendLE<qint64>(header, startMs);
+        appendLE<qint64>(header, m_config.partitionMs);
+        index->write(header);
+    } else {
+        // A torn entry from a crash would misalign every later one
+        const qint64 tail = (index->size() - INDEX_HEADER_BYTES) % INDEX_ENTRY_BYTES;
+        if (tail != 0) index->resize(index->size() - tail);
+    }
+
+    m_data = std::move(data);
+    m_index = std::move(index);
+    m_partitionStartMs = startMs;
+    return true;
+}
+
+void TrackArchiveWriter::closePartition() {
+    m_data.reset();
+    m_index.reset();
+}
+
+TrackArchiveReader::TrackArchiveReader(const QString& directory)
+    : m_directory(directory)
+{}
+
+TrackArchiveReader::~TrackArchiveReader() {
+    close();
+}
+
+template <typename Fn>
+void TrackArchiveReader::forEachBlock(qint64 startMs, qint64 endMs, Fn&& fn) {
+    refreshPartitions();
+
+    for (const auto& shared : m_partitions) {
+        Partition& partition = *shared;
+        if (partition.startMs > endMs) break;
+        // The first refresh reads the header, and with it the duration
+        if (partition.durationMs == 0 && !refreshIndex(partition)) continue;
+        if (partition.startMs + partition.durationMs <= startMs) continue;
+        if (!refreshIndex(partition)) continue;
+
+        for (const IndexEntry& entry : partition.entries) {
+            if (entry.lastMs < startMs || entry.firstMs > endMs) continue;
+            if (!ensureMapped(partition, entry.offset + entry.bytes)) break;
+            fn(partition.map + entry.offset, entry);
+        }
+    }
+}
+
+qint64 TrackArchiveReader::read(qint64 startMs, qint64 endMs, const Visitor& visit) {
+    qint64 visited = 0;
+    forEachBlock(startMs, endMs, [&](const uchar* block, const IndexEntry& entry) {
+        visited += decodeBlock(block, entry.bytes, startMs, endMs, visit);
+    });
+    return visited;
+}
+
+QVector<TrackHistorySample> TrackArchiveReader::load(qint64 startMs, qint64 endMs) {
+    QVector<TrackHistorySample> samples;
+    qint64 expected = 0;
+    QVector<std::pair<const uchar*, IndexEntry>> blocks;
+    forEachBlock(startMs, endMs, [&](const uchar* block, const IndexEntry& entry) {
+        blocks.append(std::make_pair(block, entry));
+        expected += entry.samples;
+    });
+    samples.reserve(static_cast<int>(qMin<qint64>(expected, std::numeric_limits<int>::max())));
+
+    const Visitor append = [&samples](const TrackHistorySample& sample) { samples.append(sample); };
+    for (const auto& block : blocks) {
+        decodeBlock(block.first, block.second.bytes, startMs, endMs, append);
+    }
+
+    // Blocks are in time order unless a late batch reopened a partition
+    const auto byTime = [](const TrackHistorySample& a, const TrackHistorySample& b) {
+        return a.timestamp < b.timestamp;
+    };
+    if (!std::is_sorted(samples.begin(), samples.end(), byTime)) {
+        std::stable_sort(samples.begin(), samples.end(), byTime);
+    }
+    return samples;
+}
+
+int TrackArchiveReader::removeBefore(qint64 cutoffMs) {
+    refreshPartitions();
+
+    int removed = 0;
+    for (auto it = m_partitions.begin(); it != m_partitions.end();) {
+        Partition& partition = **it;
+        if (partition.startMs + partition.durationMs > cutoffMs) {
+            ++it;
+            continue;
+        }
+        unmap(partition);
+        QFile::remove(partition.dataPath);
+        QFile::remove(partition.indexPath);
+        ++removed;
+        it = m_partitions.erase(it);
+    }
+    return removed;
+}
+
+void TrackArchiveReader::close() {
+    for (const auto& partition : m_partitions) {
+        unmap(*partition);
+    }
+    m_partitions.clear();
+}
+
+void TrackArchiveReader::refreshPartitions() {
+    const QStringList names = QDir(m_directory).entryList(QStringList() << "tracks-*.cti", QDir::Files);
+    for (const QString& name : names) {
+        bool ok = false;
+        const qint64 startMs = QFileInfo(name).completeBaseName().mid(7).toLongLong(&ok);
+        if (!ok || m_partitions.contains(startMs)) continue;
+
+        auto partition = std::make_shared<Partition>();
+        partition->startMs = startMs;
+        partition->indexPath = QDir(m_directory).filePath(name);
+        partition->dataPath = QDir(m_directory).filePath(partitionBaseName(startMs) + ".cta");
+        m_partitions.insert(startMs, partition);
+    }
+}
+
+bool TrackArchiveReader::refreshIndex(Partition& partition) {
+    QFile file(partition.indexPath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    if (partition.indexBytesRead == 0) {
+        const QByteArray header = file.read(INDEX_HEADER_BYTES);
+        if (header.size() < INDEX_HEADER_BYTES) return false;
+        const uchar* p = reinterpret_cast<const uchar*>(header.constData());
+        if (readLE<quint32>(p) != INDEX_MAGIC || readLE<quint32>(p + 4) != FORMAT_VERSION) {
+            Logger::instance().warning("TrackArchive", "Not a track archive index: " + partition.indexPath);
+            return false;
+        }
+        partition.durationMs = readLE<qint64>(p + 16);
+        partition.indexBytesRead = INDEX_HEADER_BYTES;
+    }
+
+    // Only whole entries; a writer may be part-way through the next one
+    const qint64 available = (file.size() - partition.indexBytesRead) / INDEX_ENTRY_BYTES * INDEX_ENTRY_BYTES;
+    if (available <= 0) return true;
+    file.seek(partition.indexBytesRead);
+    const QByteArray bytes = file.read(available);
+    const uchar* p = reinterpret_cast<const uchar*>(bytes.constData());
+    for (int offset = 0; offset + INDEX_ENTRY_BYTES <= bytes.size(); offset += INDEX_ENTRY_BYTES) {
+        IndexEntry entry;
+        entry.firstMs = readLE<qint64>(p + offset);
+        entry.lastMs = readLE<qint64>(p + offset + 8);
+        entry.offset = readLE<qint64>(p + offset + 16);
+        entry.bytes = readLE<quint32>(p + offset + 24);
+        entry.samples = readLE<quint32>(p + offset + 28);
+        partition.entries.append(entry);
+    }
+    partition.indexBytesRead += bytes.size() / INDEX_ENTRY_BYTES * INDEX_ENTRY_BYTES;
+    return true;
+}
+
+bool TrackArchiveReader::ensureMapped(Partition& partition, qint64 size) {
+    if (partition.map && partition.mapSize >= size) return true;
+    unmap(partition);
+
+    std::unique_ptr<QFile> data(new QFile(partition.dataPath));
+    if (!data->open(QIODevice::ReadOnly)) return false;
+    const qint64 fileSize = data->size();
+    if (fileSize < size || fileSize < DATA_HEADER_BYTES) return false;
+
+    const uchar* map = data->map(0, fileSize);
+    if (!map) {
+        Logger::instance().warning("TrackArchive", "Failed to map " + partition.dataPath + ": " + data->errorString());
+        return false;
+    }
+    if (readLE<quint32>(map) != DATA_MAGIC || readLE<quint32>(map + 4) != FORMAT_VERSION) {
+        Logger::instance().warning("TrackArchive", "Not a track archive: " + partition.dataPath);
+        data->unmap(const_cast<uchar*>(map));
+        return false;
+    }
+
+    partition.data = std::move(data);
+    partition.map = map;
+    partition.mapSize = fileSize;
+    return true;
+}
+
+void TrackArchiveReader::unmap(Partition& partition) {
+    if (partition.data && partition.map) {
+        partition.data->unmap(const_cast<uchar*>(partition.map));
+    }
+    partition.map = nullptr;
+    partition.mapSize = 0;
+    partition.data.reset();
+}
+
+qint64 TrackArchiveReader::decodeBlock(const uchar* block, quint32 bytes, qint64 startMs, qint64 endMs,
+                                       const Visitor& visit) const {
+    const uchar* p = block;
+    const uchar* const end = block + bytes;
+    if (end - p < 8) return 0;
+
+    const quint32 sampleCount = readLE<quint32>(p);
+    const quint32 trackCount = readLE<quint32>(p + 4);
+    p += 8;
+
+    QVector<QString> trackIds;
+    trackIds.reserve(static_cast<int>(qMin<quint32>(trackCount, bytes / 2)));
+    for (quint32 i = 0; i < trackCount; ++i) {
+        if (end - p < 2) return 0;
+        const quint16 length = readLE<quint16>(p);
+        p += 2;
+        if (end - p < length) return 0;
+        trackIds.append(QString::fromUtf8(reinterpret_cast<const char*>(p), length));
+        p += length;
+    }
+
+    if (end - p < 8 + 4 * ColumnCount) return 0;
+    const qint64 baseMs = readLE<qint64>(p);
+    p += 8;
+    const uchar* column[ColumnCount];
+    const uchar* columnEnd[ColumnCount];
+    const uchar* next = p + 4 * ColumnCount;
+    for (int c = 0; c < ColumnCount; ++c) {
+        const quint32 length = readLE<quint32>(p + 4 * c);
+        if (static_cast<quint64>(end - next) < length) return 0;
+        column[c] = next;
+        columnEnd[c] = next + length;
+        next += length;
+    }
+
+    struct Position { qint64 latitude = 0, longitude = 0, altitude = 0; };
+    QVector<Position> last(trackIds.size());
+
+    qint64 visited = 0;
+    qint64 timeMs = baseMs;
+    TrackHistorySample sample;
+    for (quint32 i = 0; i < sampleCount; ++i) {
+        quint64 track, time, latitude, longitude, altitude;
+        if (!readVarint(column[TrackColumn], columnEnd[TrackColumn], track) ||
+            !readVarint(column[TimeColumn], columnEnd[TimeColumn], time) ||
+            !readVarint(column[LatitudeColumn], columnEnd[LatitudeColumn], latitude) ||
+            !readVarint(column[LongitudeColumn], columnEnd[LongitudeColumn], longitude) ||
+            !readVarint(column[AltitudeColumn], columnEnd[AltitudeColumn], altitude) ||
+            track >= static_cast<quint64>(trackIds.size())) {
+            Logger::instance().warning("TrackArchive", "Truncated block; decoded samples kept");
+            break;
+        }
+
+        // Every sample is decoded; the deltas chain through the ones skipped
+        Position& position = last[static_cast<int>(track)];
+        timeMs += unzigzag(time);
+        position.latitude += unzigzag(latitude);
+        position.longitude += unzigzag(longitude);
+        position.altitude += unzigzag(altitude);
+        if (timeMs < startMs || timeMs > endMs) continue;
+
+        sample.trackId = trackIds[static_cast<int>(track)];
+        sample.timestamp = timeMs;
+        sample.position.latitude = position.latitude / DEGREE_SCALE;
+        sample.position.longitude = position.longitude / DEGREE_SCALE;
+        sample.position.altitude = position.altitude / ALTITUDE_SCALE;
+        visit(sample);
+        ++visited;
+    }
+    return visited;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,144 @@
+#ifndef TRACKARCHIVE_H
+#define TRACKARCHIVE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include "core/Track.h"
+
+class QFile;
+
+namespace CounterUAS {
+
+/**
+ * @brief Where the track archive lives and how it is cut up
+ */
+struct TrackArchiveConfig {
+    QString directory;              // Empty disables the archive
+    qint64 partitionMs = 600000;    // One pair of files per 10 minutes
+    int blockMs = 5000;             // Longest span of one block
+    int blockSamples = 32768;       // Most samples in one block
+};
+
+/**
+ * @brief Appends track positions to a time-partitioned, columnar archive
+ *
+ * Each partition covers partitionMs of recorded time in two files:
+ * tracks-<startMs>.cta holds the blocks and tracks-<startMs>.cti indexes
+ * them by first and last timestamp. A block stores its samples as five
+ * columns (track, time, latitude, longitude, altitude). Time is a delta
+ * from the previous sample in the block and each coordinate a delta from
+ * the same track's previous sample, written as zigzag varints, so a track
+ * moving a few metres per sample costs a few bytes per column. Positions
+ * are kept to 1e-7 degrees and 1 cm.
+ *
+ * A block's index entry is appended only after the block itself, so
+ * readers never see a block that is still being written. Not thread-safe;
+ * the track history writer owns one on its thread.
+ */
+class TrackArchiveWriter {
+public:
+    explicit TrackArchiveWriter(const TrackArchiveConfig& config);
+    ~TrackArchiveWriter();
+
+    TrackArchiveWriter(const TrackArchiveWriter&) = delete;
+    TrackArchiveWriter& operator=(const TrackArchiveWriter&) = delete;
+
+    // Samples are filed by their own timestamp, so a late one reopens the
+    // partition it belongs to
+    bool append(const QString& trackId, qint64 timestamp, const GeoPosition& position);
+
+    // Writes the open block however small; readers see everything appended so far
+    bool seal();
+
+    quint64 blocksWritten() const { return m_blocksWritten; }
+    quint64 bytesWritten() const { return m_bytesWritten; }
+
+private:
+    struct Block;
+
+    bool openPartition(qint64 startMs);
+    void closePartition();
+
+    TrackArchiveConfig m_config;
+    qint64 m_partitionStartMs = 0;
+    std::unique_ptr<QFile> m_data;
+    std::unique_ptr<QFile> m_index;
+    std::unique_ptr<Block> m_block;
+    quint64 m_blocksWritten = 0;
+    quint64 m_bytesWritten = 0;
+};
+
+/**
+ * @brief Reads time windows out of the track archive
+ *
+ * Partitions are memory-mapped and only the blocks whose time range
+ * overlaps the window are decoded, straight from the mapping. New blocks
+ * appended by a writer in the meantime are picked up on the next read.
+ * Not thread-safe; use one reader per thread.
+ */
+class TrackArchiveReader {
+public:
+    using Visitor = std::function<void(const TrackHistorySample&)>;
+
+    explicit TrackArchiveReader(const QString& directory);
+    ~TrackArchiveReader();
+
+    TrackArchiveReader(const TrackArchiveReader&) = delete;
+    TrackArchiveReader& operator=(const TrackArchiveReader&) = delete;
+
+    QString directory() const { return m_directory; }
+
+    // Samples in [startMs, endMs] block by block, in the order written;
+    // returns how many were visited
+    qint64 read(qint64 startMs, qint64 endMs, const Visitor& visit);
+
+    // The same samples, oldest first
+    QVector<TrackHistorySample> load(qint64 startMs, qint64 endMs);
+
+    // Deletes partitions that end at or before cutoffMs; returns how many
+    int removeBefore(qint64 cutoffMs);
+
+    // Unmaps every partition, e.g. before the files are moved
+    void close();
+
+private:
+    struct IndexEntry {
+        qint64 firstMs = 0;
+        qint64 lastMs = 0;
+        qint64 offset = 0;
+        quint32 bytes = 0;
+        quint32 samples = 0;
+    };
+
+    struct Partition {
+        qint64 startMs = 0;
+        qint64 durationMs = 0;
+        QString dataPath;
+        QString indexPath;
+        QVector<IndexEntry> entries;
+        qint64 indexBytesRead = 0;
+        std::unique_ptr<QFile> data;
+        const uchar* map = nullptr;
+        qint64 mapSize = 0;
+    };
+
+    void refreshPartitions();
+    bool refreshIndex(Partition& partition);
+    bool ensureMapped(Partition& partition, qint64 size);
+    void unmap(Partition& partition);
+    qint64 decodeBlock(const uchar* block, quint32 bytes, qint64 startMs, qint64 endMs,
+                       const Visitor& visit) const;
+    template <typename Fn> void forEachBlock(qint64 startMs, qint64 endMs, Fn&& fn);
+
+    QString m_directory;
+    QMap<qint64, std::shared_ptr<Partition>> m_partitions;   // By start time
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKARCHIVE_H
@@ -0,0 +1,280 @@
+#include "config/TrackHistoryWriter.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+
+namespace CounterUAS {
+
+namespace {
+
+// SQLite's default host parameter limit is 999; five per row
+constexpr int MAX_ROWS_PER_INSERT = 999 / 5;
+
+} // namespace
+
+TrackHistoryWriter::TrackHistoryWriter(const TrackHistoryWriterConfig& config)
+{
+    setConfig(config);
+}
+
+TrackHistoryWriter::~TrackHistoryWriter() {
+    stop();
+}
+
+void TrackHistoryWriter::setConfig(const TrackHistoryWriterConfig& config) {
+    const QString path = m_databasePath;
+    const bool wasRunning = isRunning();
+    stop();
+
+    m_config = config;
+    m_config.flushIntervalMs = qMax(1, m_config.flushIntervalMs);
+    m_config.queueCapacity = qMax(16, m_config.queueCapacity);
+    m_config.rowsPerInsert = qBound(1, m_config.rowsPerInsert, MAX_ROWS_PER_INSERT);
+    m_queue.reset(new BoundedQueue<Sample>(m_config.queueCapacity));
+
+    if (wasRunning) {
+        start(path);
+    }
+}
+
+bool TrackHistoryWriter::start(const QString& databasePath) {
+    if (m_thread) return true;
+    m_databasePath = databasePath;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+        m_flushRequested = false;
+    }
+
+    const QString connectionName = QString("track-history-%1").arg(reinterpret_cast<quintptr>(this), 0, 16);
+    m_thread = QThread::create([this, connectionName]() { writerLoop(connectionName); });
+    m_thread->setObjectName("TrackHistoryWriter");
+    m_thread->start();
+    m_accepting.store(true, std::memory_order_release);
+    return true;
+}
+
+void TrackHistoryWriter::stop() {
+    if (!m_thread) return;
+    m_accepting.store(false, std::memory_order_release);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+bool TrackHistoryWriter::enqueue(const QString& trackId, qint64 timestamp, const GeoPosition& position) {
+    if (!m_accepting.load(std::memory_order_acquire)) return false;
+
+    Sample sample;
+    sample.trackId = trackId;
+    sample.timestamp = timestamp;
+    sample.position = position;
+    sample.queuedNs = TimeUtils::monotonicNs();
+    if (!m_queue->tryPush(std::move(sample))) {
+        m_samplesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_samplesQueued.fetch_add(1, std::memory_order_relaxed);
+
+    // A wake-up lost to a race only means waiting out the interval
+    if (m_queue->sizeApprox() >= m_queue->capacity() / 2) {
+        m_wake.wakeOne();
+    }
+    return true;
+}
+
+void TrackHistoryWriter::flush() {
+    if (!m_thread) return;
+
+    // Any pass beginning after this point drains what is queued now
+    QMutexLocker locker(&m_mutex);
+    const quint64 target = m_passesStarted + 1;
+    m_flushRequested = true;
+    m_wake.wakeAll();
+    while (m_passesDone < target) {
+        m_flushed.wait(&m_mutex);
+    }
+}
+
+TrackHistoryWriterStats TrackHistoryWriter::stats() const {
+    TrackHistoryWriterStats stats;
+    {
+        QMutexLocker locker(&m_mutex);
+        stats.writeLatency = m_writeLatency;
+        stats.flushDuration = m_flushDuration;
+    }
+    stats.samplesQueued = m_samplesQueued.load();
+    stats.samplesWritten = m_samplesWritten.load();
+    stats.samplesDropped = m_samplesDropped.load();
+    stats.transactions = m_transactions.load();
+    stats.writeErrors = m_writeErrors.load();
+    stats.samplesArchived = m_samplesArchived.load();
+    stats.archiveBlocks = m_archiveBlocks.load();
+    stats.queueDepth = static_cast<int>(m_queue->sizeApprox());
+    stats.queueCapacity = static_cast<int>(m_queue->capacity());
+    return stats;
+}
+
+void TrackHistoryWriter::writerLoop(const QString& connectionName) {
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(m_databasePath);
+        // The GUI thread's connection writes too; wait out its locks
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=2000");
+        const bool open = db.open();
+        if (!open) {
+            Logger::instance().error("TrackHistoryWriter", "Failed to open database: " + db.lastError().text());
+        }
+
+        QSqlQuery pragma(db);
+        QSqlQuery multiRow(db);
+        QSqlQuery singleRow(db);
+        if (open) {
+            pragma.exec("PRAGMA synchronous=NORMAL");
+            multiRow.prepare(insertSql(m_config.rowsPerInsert));
+            singleRow.prepare(insertSql(1));
+        }
+
+        std::unique_ptr<TrackArchiveWriter> archive;
+        if (!m_config.archive.directory.isEmpty()) {
+            archive.reset(new TrackArchiveWriter(m_config.archive));
+        }
+
+        QVector<Sample> batch;
+        batch.reserve(m_config.rowsPerInsert * 4);
+        forever {
+            bool stopping;
+            bool flushRequested;
+            {
+                QMutexLocker locker(&m_mutex);
+                if (!m_stopping && !m_flushRequested) {
+                    m_wake.wait(&m_mutex, static_cast<unsigned long>(m_config.flushIntervalMs));
+                }
+                stopping = m_stopping;
+                flushRequested = m_flushRequested;
+                m_flushRequested = false;
+                ++m_passesStarted;
+            }
+
+            Sample sample;
+            while (m_queue->tryPop(sample)) {
+                batch.append(std::move(sample));
+            }
+            if (!batch.isEmpty()) {
+                if (!open || !writeBatch(db, multiRow, singleRow, batch)) {
+                    m_samplesDropped.fetch_add(batch.size(), std::memory_order_relaxed);
+                }
+                if (archive) {
+                    archiveBatch(*archive, batch);
+                }
+                batch.clear();
+            }
+            if (archive && (flushRequested || stopping)) {
+                archive->seal();
+                m_archiveBlocks.store(archive->blocksWritten(), std::memory_order_relaxed);
+            }
+
+            {
+                QMutexLocker locker(&m_mutex);
+                ++m_passesDone;
+            }
+            m_flushed.wakeAll();
+            if (stopping) break;
+        }
+
+        pragma.finish();
+        multiRow.finish();
+        singleRow.finish();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+bool TrackHistoryWriter::writeBatch(QSqlDatabase& db, QSqlQuery& multiRow, QSqlQuery& singleRow,
+                                    const QVector<Sample>& batch) {
+    const qint64 startNs = TimeUtils::monotonicNs();
+
+    const int rows = m_config.rowsPerInsert;
+    bool ok = db.transaction();
+    int i = 0;
+    for (; ok && i + rows <= batch.size(); i += rows) {
+        for (int row = 0; row < rows; ++row) {
+            bindSample(multiRow, row, batch[i + row]);
+        }
+        ok = multiRow.exec();
+    }
+    for (; ok && i < batch.size(); ++i) {
+        bindSample(singleRow, 0, batch[i]);
+        ok = singleRow.exec();
+    }
+
+    if (ok) {
+        ok = db.commit();
+    }
+    if (!ok) {
+        QString error = db.lastError().text();
+        if (multiRow.lastError().isValid()) error = multiRow.lastError().text();
+        if (singleRow.lastError().isValid()) error = singleRow.lastError().text();
+        db.rollback();
+        m_writeErrors.fetch_add(1, std::memory_order_relaxed);
+        Logger::instance().warning("TrackHistoryWriter",
+            QString("Failed to write %1 track samples: %2").arg(batch.size()).arg(error));
+        return false;
+    }
+
+    const qint64 endNs = TimeUtils::monotonicNs();
+    m_samplesWritten.fetch_add(batch.size(), std::memory_order_relaxed);
+    m_transactions.fetch_add(1, std::memory_order_relaxed);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_flushDuration.record((endNs - startNs) / 1000);
+        // The oldest sample waited longest
+        m_writeLatency.record((endNs - batch.first().queuedNs) / 1000);
+    }
+    return true;
+}
+
+void TrackHistoryWriter::archiveBatch(TrackArchiveWriter& archive, QVector<Sample>& batch) {
+    // Producers interleave; blocks stay in time order when the batch is
+    std::stable_sort(batch.begin(), batch.end(), [](const Sample& a, const Sample& b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    quint64 archived = 0;
+    for (const Sample& sample : batch) {
+        if (archive.append(sample.trackId, sample.timestamp, sample.position)) ++archived;
+    }
+    m_samplesArchived.fetch_add(archived, std::memory_order_relaxed);
+    m_archiveBlocks.store(archive.blocksWritten(), std::memory_order_relaxed);
+}
+
+void TrackHistoryWriter::bindSample(QSqlQuery& query, int row, const Sample& sample) {
+    const int base = row * 5;
+    query.bindValue(base, sample.trackId);
+    query.bindValue(base + 1, sample.timestamp);
+    query.bindValue(base + 2, sample.position.latitude);
+    query.bindValue(base + 3, sample.position.longitude);
+    query.bindValue(base + 4, sample.position.altitude);
+}
+
+QString TrackHistoryWriter::insertSql(int rows) {
+    QStringList values;
+    values.reserve(rows);
+    for (int i = 0; i < rows; ++i) {
+        values.append("(?, ?, ?, ?, ?)");
+    }
+    return "INSERT OR REPLACE INTO tracks (track_id, timestamp, latitude, longitude, altitude) VALUES "
+           + values.join(", ");
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,131 @@
+#ifndef TRACKHISTORYWRITER_H
+#define TRACKHISTORYWRITER_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include "core/Track.h"
+#include "config/TrackArchive.h"
+#include "utils/BoundedQueue.h"
+#include "utils/LatencyStats.h"
+
+class QThread;
+class QSqlDatabase;
+class QSqlQuery;
+
+namespace CounterUAS {
+
+/**
+ * @brief Batching and queue limits of the track history writer
+ */
+struct TrackHistoryWriterConfig {
+    int flushIntervalMs = 200;      // Longest a sample waits before its transaction
+    int queueCapacity = 16384;      // Samples waiting; further ones are dropped
+    int rowsPerInsert = 64;         // Rows bound into one multi-row INSERT
+    TrackArchiveConfig archive;     // Also appended to when a directory is set
+};
+
+/**
+ * @brief Writer counters, safe to read from any thread
+ */
+struct TrackHistoryWriterStats {
+    quint64 samplesQueued = 0;
+    quint64 samplesWritten = 0;
+    quint64 samplesDropped = 0;     // Queue full when they arrived
+    quint64 transactions = 0;
+    quint64 writeErrors = 0;        // Transactions rolled back
+    quint64 samplesArchived = 0;
+    quint64 archiveBlocks = 0;
+    int queueDepth = 0;
+    int queueCapacity = 0;
+    LatencyStats writeLatency;      // Queued to committed, microseconds
+    LatencyStats flushDuration;     // One transaction, microseconds
+};
+
+/**
+ * @brief Writes track positions to the tracks table from a thread of its own
+ *
+ * enqueue() is lock-free and never touches SQLite, so any thread may
+ * record the whole track picture each cycle. The writer thread wakes every
+ * flushIntervalMs, or sooner when the queue is half full, takes everything
+ * queued and writes it in one transaction through multi-row INSERTs of
+ * rowsPerInsert rows, prepared once per connection. Its own connection
+ * runs with synchronous=NORMAL; with the database in WAL mode a commit
+ * is an append to the log rather than a sync of the whole file, and
+ * readers on other connections are not blocked by it.
+ *
+ * With an archive directory configured, every batch is also appended to
+ * the columnar track archive (see TrackArchiveWriter), whose open block is
+ * sealed by flush() and stop().
+ */
+class TrackHistoryWriter {
+public:
+    explicit TrackHistoryWriter(const TrackHistoryWriterConfig& config = TrackHistoryWriterConfig());
+    ~TrackHistoryWriter();
+
+    TrackHistoryWriter(const TrackHistoryWriter&) = delete;
+    TrackHistoryWriter& operator=(const TrackHistoryWriter&) = delete;
+
+    // Stopped while it changes
+    void setConfig(const TrackHistoryWriterConfig& config);
+    TrackHistoryWriterConfig config() const { return m_config; }
+
+    bool start(const QString& databasePath);
+    // Writes what is queued, then closes the connection
+    void stop();
+    bool isRunning() const { return m_accepting.load(std::memory_order_acquire); }
+
+    // Any thread; false when the queue is full or the writer is not running
+    bool enqueue(const QString& trackId, qint64 timestamp, const GeoPosition& position);
+
+    // Returns once everything queued before the call is committed, and
+    // readable from the archive
+    void flush();
+
+    TrackHistoryWriterStats stats() const;
+
+private:
+    struct Sample {
+        QString trackId;
+        qint64 timestamp = 0;
+        GeoPosition position;
+        qint64 queuedNs = 0;
+    };
+
+    void writerLoop(const QString& connectionName);
+    bool writeBatch(QSqlDatabase& db, QSqlQuery& multiRow, QSqlQuery& singleRow, const QVector<Sample>& batch);
+    void archiveBatch(TrackArchiveWriter& archive, QVector<Sample>& batch);
+    static void bindSample(QSqlQuery& query, int row, const Sample& sample);
+    static QString insertSql(int rows);
+
+    TrackHistoryWriterConfig m_config;
+    QString m_databasePath;
+    QThread* m_thread = nullptr;
+    std::unique_ptr<BoundedQueue<Sample>> m_queue;
+
+    mutable QMutex m_mutex;             // Guards the wake-up state and the latency stats
+    QWaitCondition m_wake;
+    QWaitCondition m_flushed;
+    bool m_stopping = false;
+    bool m_flushRequested = false;
+    quint64 m_passesStarted = 0;        // Writer passes that have begun draining
+    quint64 m_passesDone = 0;
+    LatencyStats m_writeLatency;
+    LatencyStats m_flushDuration;
+
+    std::atomic<bool> m_accepting{false};
+    std::atomic<quint64> m_samplesQueued{0};
+    std::atomic<quint64> m_samplesWritten{0};
+    std::atomic<quint64> m_samplesDropped{0};
+    std::atomic<quint64> m_transactions{0};
+    std::atomic<quint64> m_writeErrors{0};
+    std::atomic<quint64> m_samplesArchived{0};
+    std::atomic<quint64> m_archiveBlocks{0};
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKHISTORYWRITER_H
@@ -0,0 +1,176 @@
+#include "config/TrackReplayer.h"
+#include "config/DatabaseManager.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+#include <QTimer>
+
+namespace CounterUAS {
+
+TrackReplayer::TrackReplayer(TrackManager* trackManager, QObject* parent)
+    : QObject(parent)
+    , m_trackManager(trackManager)
+    , m_timer(new QTimer(this))
+    , m_fetchWatcher(new QFutureWatcher<QVector<TrackHistorySample>>(this))
+{
+    m_timer->setInterval(1000 / TICK_HZ);
+    connect(m_timer, &QTimer::timeout, this, &TrackReplayer::tick);
+    connect(m_fetchWatcher, &QFutureWatcherBase::finished, this, &TrackReplayer::onFetched);
+}
+
+TrackReplayer::~TrackReplayer() {
+    stop();
+}
+
+bool TrackReplayer::start(qint64 startMs, qint64 endMs) {
+    if (!m_trackManager || endMs <= startMs) return false;
+    if (!DatabaseManager::instance().isOpen()) {
+        Logger::instance().warning("TrackReplayer", "No track history database");
+        return false;
+    }
+
+    m_startMs = startMs;
+    m_endMs = endMs;
+    m_following = false;
+    m_paused = false;
+    if (!m_active) {
+        m_trackManager->setReplayMode(true);
+        m_active = true;
+        emit activeChanged(true);
+    }
+
+    Logger::instance().info("TrackReplayer", QString("Replaying tracks %1 to %2")
+        .arg(QDateTime::fromMSecsSinceEpoch(startMs).toString(Qt::ISODate))
+        .arg(QDateTime::fromMSecsSinceEpoch(endMs).toString(Qt::ISODate)));
+    seek(startMs);
+    return true;
+}
+
+void TrackReplayer::stop() {
+    if (!m_active) return;
+    m_timer->stop();
+    cancelFetch();
+    m_buffer.clear();
+    m_bufferPos = 0;
+    m_active = false;
+    if (m_trackManager) {
+        m_trackManager->setReplayMode(false);
+    }
+    emit activeChanged(false);
+}
+
+void TrackReplayer::setRate(double rate) {
+    restartClock(m_currentMs);
+    m_rate = qBound(0.1, rate, 64.0);
+}
+
+void TrackReplayer::setPaused(bool paused) {
+    if (m_paused == paused) return;
+    m_paused = paused;
+    restartClock(m_currentMs);
+}
+
+void TrackReplayer::seek(qint64 utcMs) {
+    if (!m_active) return;
+    utcMs = qBound(m_startMs, utcMs, m_endMs);
+
+    // Whatever was alive at utcMs was last seen within the drop timeout
+    m_trackManager->clearAllTracks();
+    cancelFetch();
+    m_buffer.clear();
+    m_bufferPos = 0;
+    const qint64 lookbackMs = m_trackManager->config().dropTimeoutMs;
+    m_fetchedUntilMs = qMax(m_startMs, utcMs - lookbackMs) - 1;
+    m_currentMs = m_fetchedUntilMs;
+
+    advanceTo(utcMs);
+    restartClock(utcMs);
+    if (!m_following) {
+        m_timer->start();   // Stopped if the end was reached
+    }
+}
+
+void TrackReplayer::followClock(qint64 utcMs) {
+    if (!m_active) return;
+    m_following = true;
+    if (utcMs < m_currentMs) {
+        seek(utcMs);
+    } else {
+        advanceTo(qMin(utcMs, m_endMs));
+    }
+}
+
+void TrackReplayer::tick() {
+    if (!m_active || m_following || m_paused) return;
+    advanceTo(qMin(clockMs(), m_endMs));
+}
+
+qint64 TrackReplayer::clockMs() const {
+    if (m_paused || !m_wallClock.isValid()) return m_clockBaseMs;
+    return m_clockBaseMs + static_cast<qint64>(m_wallClock.elapsed() * m_rate);
+}
+
+void TrackReplayer::restartClock(qint64 fromMs) {
+    m_clockBaseMs = fromMs;
+    m_wallClock.restart();
+}
+
+void TrackReplayer::advanceTo(qint64 timeMs) {
+    m_targetMs = timeMs;
+    fetch(timeMs + CHUNK_MS / 2);
+    if (timeMs <= m_currentMs && m_bufferPos >= m_buffer.size()) return;
+
+    // No further than what has been read
+    const qint64 untilMs = qMin(timeMs, m_fetchedUntilMs);
+    QVector<TrackHistorySample> due;
+    while (m_bufferPos < m_buffer.size() && m_buffer[m_bufferPos].timestamp <= untilMs) {
+        due.append(m_buffer[m_bufferPos++]);
+    }
+    m_currentMs = qMax(m_currentMs, untilMs);
+    m_trackManager->applyReplaySamples(due, m_currentMs);
+    emit timeChanged(m_currentMs);
+
+    if (m_currentMs >= m_endMs && m_bufferPos >= m_buffer.size()) {
+        m_timer->stop();
+        emit finished();
+    }
+}
+
+void TrackReplayer::fetch(qint64 untilMs) {
+    if (m_fetching || m_fetchedUntilMs >= untilMs || m_fetchedUntilMs >= m_endMs) return;
+
+    const qint64 from = m_fetchedUntilMs + 1;
+    m_fetchingUntilMs = qMin(m_endMs, qMax(untilMs, m_fetchedUntilMs + CHUNK_MS));
+    m_fetching = true;
+    m_fetchWatcher->setFuture(DatabaseManager::instance().loadTrackSamplesAsync(from, m_fetchingUntilMs));
+}
+
+void TrackReplayer::cancelFetch() {
+    if (!m_fetching) return;
+    // A new setFuture() discards the old read's finished signal
+    m_fetchWatcher->cancel();
+    m_fetching = false;
+}
+
+void TrackReplayer::onFetched() {
+    if (!m_fetching) return;
+    m_fetching = false;
+
+    // Drop what has been applied before appending
+    if (m_bufferPos > 0) {
+        m_buffer.remove(0, m_bufferPos);
+        m_bufferPos = 0;
+    }
+    // Canceled by the database closing: the window reads as empty
+    const QFuture<QVector<TrackHistorySample>> future = m_fetchWatcher->future();
+    if (future.resultCount() > 0) {
+        m_buffer += future.result();
+    }
+    m_fetchedUntilMs = m_fetchingUntilMs;
+
+    if (m_active) {
+        advanceTo(m_targetMs);
+    }
+}
+
+} // namespace CounterUAS
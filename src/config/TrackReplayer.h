@@ -0,0 +1,99 @@
+#ifndef TRACKREPLAYER_H
+#define TRACKREPLAYER_H
+
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+#include "core/Track.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+class TrackManager;
+
+/**
+ * @brief Plays recorded track history back through the track manager
+ *
+ * Puts the manager in replay mode and feeds it the recorded positions
+ * due on the replay clock, read from DatabaseManager a chunk at a time so
+ * an hour-long window never has to be held whole. Chunks are read on the
+ * database's read pool, the next one requested half a chunk before it is
+ * due; should the clock outrun a read, replay holds at the last sample
+ * read and catches up when it arrives. The clock runs at rate
+ * times real time, or follows a recording's clock through followClock(),
+ * e.g. FileVideoSource::replayTimeChanged, so tracks stay in step with the
+ * video. A seek starts dropTimeoutMs early, so every track alive at the
+ * seek time is on the picture straight away.
+ */
+class TrackReplayer : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr qint64 CHUNK_MS = 10000;   // Read ahead per fetch
+    static constexpr int TICK_HZ = 10;
+
+    explicit TrackReplayer(TrackManager* trackManager, QObject* parent = nullptr);
+    ~TrackReplayer() override;
+
+    // Enters replay mode at startMs
+    bool start(qint64 startMs, qint64 endMs);
+    // Back to live tracks
+    void stop();
+    bool isActive() const { return m_active; }
+
+    void setRate(double rate);
+    double rate() const { return m_rate; }
+    void setPaused(bool paused);
+    bool isPaused() const { return m_paused; }
+
+    void seek(qint64 utcMs);
+    qint64 currentTimeMs() const { return m_currentMs; }
+    qint64 startTimeMs() const { return m_startMs; }
+    qint64 endTimeMs() const { return m_endMs; }
+
+public slots:
+    // Drives the replay clock from outside; the internal clock stops
+    void followClock(qint64 utcMs);
+
+signals:
+    void timeChanged(qint64 utcMs);
+    void finished();
+    void activeChanged(bool active);
+
+private slots:
+    void tick();
+    void onFetched();
+
+private:
+    qint64 clockMs() const;
+    void restartClock(qint64 fromMs);
+    void advanceTo(qint64 timeMs);
+    void fetch(qint64 untilMs);
+    void cancelFetch();
+
+    TrackManager* m_trackManager;
+    QTimer* m_timer;
+    QElapsedTimer m_wallClock;
+    qint64 m_clockBaseMs = 0;           // Replay time when m_wallClock restarted
+    double m_rate = 1.0;
+    bool m_paused = false;
+    bool m_following = false;
+    bool m_active = false;
+
+    qint64 m_startMs = 0;
+    qint64 m_endMs = 0;
+    qint64 m_currentMs = 0;
+    qint64 m_targetMs = 0;              // Last time asked for; ahead of m_currentMs while a read is due
+    qint64 m_fetchedUntilMs = 0;        // Samples up to here are in m_buffer
+    QFutureWatcher<QVector<TrackHistorySample>>* m_fetchWatcher;
+    qint64 m_fetchingUntilMs = 0;
+    bool m_fetching = false;
+    QVector<TrackHistorySample> m_buffer;
+    int m_bufferPos = 0;                // First sample not yet applied
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKREPLAYER_H
@@ -0,0 +1,114 @@
+#include "core/ClosestApproach.h"
+#include "core/DefendedAssetIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr double NEVER = std::numeric_limits<double>::infinity();
+constexpr double MIN_SPEED_SQ = 1e-6;  // Below 1 mm/s the track is treated as stationary
+
+} // namespace
+
+void ClosestApproachKernel::setAssets(const DefendedAssetIndex& assets) {
+    const int n = assets.size();
+    m_assetLat.resize(n);
+    m_assetLon.resize(n);
+    m_assetMetersPerDegLon.resize(n);
+    m_assetCriticalSq.resize(n);
+    for (int a = 0; a < n; ++a) {
+        const DefendedAssetIndex::Entry& entry = assets.entry(a);
+        m_assetLat[a] = entry.latitude;
+        m_assetLon[a] = entry.longitude;
+        m_assetMetersPerDegLon[a] = entry.metersPerDegLon;
+        m_assetCriticalSq[a] = entry.criticalRadiusSq;
+    }
+}
+
+void ClosestApproachKernel::compute(const QVector<const TrackSnapshot*>& tracks,
+                                    QVector<ClosestApproach>& results) {
+    const int n = tracks.size();
+    m_lat.resize(n);
+    m_lon.resize(n);
+    m_velEast.resize(n);
+    m_velNorth.resize(n);
+    for (int i = 0; i < n; ++i) {
+        const TrackSnapshot& track = *tracks[i];
+        m_lat[i] = track.position.latitude;
+        m_lon[i] = track.position.longitude;
+        m_velEast[i] = track.velocity.east;
+        m_velNorth[i] = track.velocity.north;
+    }
+
+    results.resize(n);
+    compute(n, m_lat.constData(), m_lon.constData(), m_velEast.constData(),
+            m_velNorth.constData(), results.data());
+}
+
+void ClosestApproachKernel::compute(int count, const double* latitude, const double* longitude,
+                                    const double* velocityEast, const double* velocityNorth,
+                                    ClosestApproach* results) {
+    if (count <= 0) return;
+
+    m_bestImpact.fill(NEVER, count);
+    m_bestCpaSq.fill(NEVER, count);
+    m_bestTcpa.fill(0.0, count);
+    m_bestAsset.fill(-1, count);
+    double* bestImpact = m_bestImpact.data();
+    double* bestCpaSq = m_bestCpaSq.data();
+    double* bestTcpa = m_bestTcpa.data();
+    int* bestAsset = m_bestAsset.data();
+
+    for (int a = 0; a < m_assetLat.size(); ++a) {
+        const double assetLat = m_assetLat[a];
+        const double assetLon = m_assetLon[a];
+        const double kEast = m_assetMetersPerDegLon[a];
+        const double kNorth = DefendedAssetIndex::METERS_PER_DEG_LAT;
+        const double radiusSq = m_assetCriticalSq[a];
+
+        for (int i = 0; i < count; ++i) {
+            // Track relative to the asset
+            const double px = (longitude[i] - assetLon) * kEast;
+            const double py = (latitude[i] - assetLat) * kNorth;
+            const double vx = velocityEast[i];
+            const double vy = velocityNorth[i];
+
+            const double pp = px * px + py * py;
+            const double pv = px * vx + py * vy;
+            const double vv = vx * vx + vy * vy;
+            const bool moving = vv > MIN_SPEED_SQ;
+            const double invVv = 1.0 / std::max(vv, MIN_SPEED_SQ);
+
+            const double tcpa = moving ? std::max(0.0, -pv * invVv) : 0.0;
+            const double cx = px + vx * tcpa;
+            const double cy = py + vy * tcpa;
+            const double cpaSq = cx * cx + cy * cy;
+
+            // Entry root of |p + v t|^2 = r^2, only while closing
+            const double disc = pv * pv - vv * (pp - radiusSq);
+            const double entry = (-pv - std::sqrt(std::max(disc, 0.0))) * invVv;
+            const double impact = pp <= radiusSq ? 0.0
+                                : (moving && pv < 0.0 && disc >= 0.0 ? entry : NEVER);
+
+            const bool better = impact < bestImpact[i] ||
+                                (impact == bestImpact[i] && cpaSq < bestCpaSq[i]);
+            bestImpact[i] = better ? impact : bestImpact[i];
+            bestCpaSq[i] = better ? cpaSq : bestCpaSq[i];
+            bestTcpa[i] = better ? tcpa : bestTcpa[i];
+            bestAsset[i] = better ? a : bestAsset[i];
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        ClosestApproach& result = results[i];
+        result.asset = bestAsset[i];
+        result.cpaDistanceM = bestAsset[i] >= 0 ? std::sqrt(bestCpaSq[i])
+                                                : std::numeric_limits<double>::max();
+        result.timeToCpaSec = bestTcpa[i];
+        result.timeToImpactSec = bestImpact[i] == NEVER ? -1.0 : bestImpact[i];
+    }
+}
+
+} // namespace CounterUAS
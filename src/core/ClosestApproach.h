@@ -0,0 +1,67 @@
+#ifndef CLOSESTAPPROACH_H
+#define CLOSESTAPPROACH_H
+
+#include <QVector>
+#include <limits>
+#include "core/TrackSnapshot.h"
+
+namespace CounterUAS {
+
+class DefendedAssetIndex;
+
+/**
+ * @brief Predicted closest approach of one track to the defended assets
+ */
+struct ClosestApproach {
+    int asset = -1;                                            // Index into the asset list
+    double cpaDistanceM = std::numeric_limits<double>::max();  // Ground range at CPA
+    double timeToCpaSec = 0.0;                                 // 0 when already receding
+    double timeToImpactSec = -1;  // Until inside the critical radius: 0 if already in, -1 if never
+};
+
+/**
+ * @brief Batch CPA / time-to-impact under constant horizontal velocity
+ *
+ * For every track against every asset, in the asset's tangent plane:
+ * time to CPA is -(p.v)/|v|^2 clamped at zero, and time to impact is the
+ * first root of |p + v t| = criticalRadius. Each track reports the asset it
+ * will reach first, or, if it reaches none, the one it passes closest to.
+ *
+ * Tracks are copied into structure-of-arrays scratch and the asset loop is
+ * outermost, so the inner loop is branch-free arithmetic over contiguous
+ * doubles that the compiler vectorizes for whatever SIMD width the build
+ * targets. Scratch is reused between calls; not thread-safe.
+ */
+class ClosestApproachKernel {
+public:
+    void setAssets(const DefendedAssetIndex& assets);
+    int assetCount() const { return m_assetLat.size(); }
+
+    // results is resized to tracks.size()
+    void compute(const QVector<const TrackSnapshot*>& tracks, QVector<ClosestApproach>& results);
+
+    // Raw entry point over caller-owned arrays; velocity in m/s east and north
+    void compute(int count, const double* latitude, const double* longitude,
+                 const double* velocityEast, const double* velocityNorth,
+                 ClosestApproach* results);
+
+private:
+    QVector<double> m_assetLat;
+    QVector<double> m_assetLon;
+    QVector<double> m_assetMetersPerDegLon;
+    QVector<double> m_assetCriticalSq;
+
+    // Scratch columns
+    QVector<double> m_lat;
+    QVector<double> m_lon;
+    QVector<double> m_velEast;
+    QVector<double> m_velNorth;
+    QVector<double> m_bestImpact;
+    QVector<double> m_bestCpaSq;
+    QVector<double> m_bestTcpa;
+    QVector<int> m_bestAsset;
+};
+
+} // namespace CounterUAS
+
+#endif // CLOSESTAPPROACH_H
@@ -0,0 +1,130 @@
+#include "core/CoreService.h"
+#include "core/EngagementManager.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include "utils/RawCapture.h"
+
+namespace CounterUAS {
+
+CoreService::CoreService(QObject* parent)
+    : QObject(parent)
+    , m_trackManager(new TrackManager)
+    , m_fusionEngine(new FusionEngine(m_trackManager, this))
+    , m_threatAssessor(new ThreatAssessor(m_trackManager, this))
+    , m_engagementManager(new EngagementManager(m_trackManager, this))
+    , m_network(new NetworkManager(this))
+    , m_sync(new TrackPictureSync(m_network, this))
+    , m_alertSync(new AlertSync(m_network, this))
+{
+    m_engagementManager->setThreatAssessor(m_threatAssessor);
+}
+
+CoreService::~CoreService() {
+    stop();
+    // Back on this thread, and deleted after everything that points at it
+    m_trackManager->setParent(this);
+}
+
+bool CoreService::start(const CoreServiceConfig& config) {
+    stop();
+    m_config = config;
+    m_error.clear();
+
+    for (const DefendedAsset& asset : m_config.defendedAssets) {
+        m_threatAssessor->removeDefendedAsset(asset.id);   // Not twice after a restart
+        m_threatAssessor->addDefendedAsset(asset);
+    }
+    if (!m_config.geofences.isEmpty()) {
+        m_threatAssessor->setGeofences(m_config.geofences);
+    }
+
+    // Video stays with the video service; the segment carries the picture
+    // and the sync frames
+    m_network->setNodeId(m_config.nodeId);
+    if (!m_config.sharedMemory.key.isEmpty()) {
+        SharedMemoryConfig shm = m_config.sharedMemory;
+        shm.videoSlots = 0;
+        shm.maxVideoFrameBytes = 0;
+        if (!m_network->startSharedMemoryPublisher(shm)) {
+            m_error = m_network->sharedMemoryPublisher()->errorString();
+            return false;
+        }
+        m_network->sharedMemoryPublisher()->setTrackManager(m_trackManager);
+    }
+    if (m_config.multicast && !m_network->startMulticastPublisher(m_config.multicastGroup)) {
+        m_error = "Cannot publish to multicast group " + m_config.multicastGroup.group.toString();
+        m_network->stopSharedMemoryPublisher();
+        return false;
+    }
+    if (!m_config.captureDirectory.isEmpty()) {
+        RawCaptureConfig capture;
+        capture.directory = m_config.captureDirectory;
+        m_capture = std::make_shared<RawCaptureRecorder>(capture);
+        m_capture->start();
+        m_network->setCapture(m_capture);
+    }
+    for (const ConnectionConfig& peer : m_config.peers) {
+        m_network->connectTo(m_network->addConnection(peer));
+    }
+
+    m_sync->setNodeId(m_config.nodeId);
+    m_sync->setKeyframeInterval(m_config.keyframeIntervalMs);
+    m_sync->setBandwidthLimit(m_config.syncBandwidthLimit);
+    m_sync->setTrackManager(m_trackManager);
+    m_alertSync->setNodeId(m_config.nodeId);
+    m_alertSync->attach(m_threatAssessor);
+
+    m_fusionEngine->setConfig(m_config.fusion);
+    m_trackManager->start();
+    m_threatAssessor->start();
+    m_fusionEngine->start();
+    m_running = true;
+
+    Logger::instance().info("CoreService", QString("Core %1 running: shared memory %2, multicast %3, %4 peers")
+                            .arg(m_config.nodeId,
+                                 m_config.sharedMemory.key.isEmpty() ? QStringLiteral("off") : m_config.sharedMemory.key,
+                                 m_config.multicast ? m_config.multicastGroup.group.toString() : QStringLiteral("off"))
+                            .arg(m_config.peers.size()));
+    return true;
+}
+
+void CoreService::stop() {
+    if (!m_running) return;
+    m_running = false;
+
+    m_fusionEngine->stop();
+    m_threatAssessor->stop();
+    m_trackManager->stop();
+
+    m_sync->setTrackManager(nullptr);
+    m_alertSync->attach(nullptr);
+    m_network->disconnectAll();
+    for (const QString& id : m_network->connectionIds()) {
+        m_network->removeConnection(id);
+    }
+    m_network->stopMulticastPublisher();
+    if (SharedMemoryPublisher* publisher = m_network->sharedMemoryPublisher()) {
+        publisher->setTrackManager(nullptr);
+    }
+    m_network->stopSharedMemoryPublisher();
+    if (m_capture) {
+        // The I/O thread lets go of it when it gets there; what is queued is written now
+        m_network->setCapture(nullptr);
+        m_capture->stop();
+        m_capture.reset();
+    }
+}
+
+CoreService::Statistics CoreService::statistics() const {
+    Statistics stats;
+    stats.tracks = m_trackManager->trackCount();
+    if (SharedMemoryPublisher* publisher = m_network->sharedMemoryPublisher()) {
+        stats.sharedMemory = publisher->stats();
+    }
+    stats.sync = m_sync->stats();
+    stats.alertSync = m_alertSync->stats();
+    stats.network = m_network->totalBandwidth();
+    return stats;
+}
+
+} // namespace CounterUAS
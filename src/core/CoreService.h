@@ -0,0 +1,99 @@
+#ifndef CORESERVICE_H
+#define CORESERVICE_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "core/FusionEngine.h"
+#include "core/ThreatAssessor.h"
+#include "network/AlertSync.h"
+#include "network/MulticastPublisher.h"
+#include "network/NetworkManager.h"
+#include "network/SharedMemoryPublisher.h"
+#include "network/TrackPictureSync.h"
+
+namespace CounterUAS {
+
+class EngagementManager;
+class RawCaptureRecorder;
+class TrackManager;
+
+/**
+ * @brief Settings of the headless C2 core
+ */
+struct CoreServiceConfig {
+    QString nodeId = QStringLiteral("CORE");    // The picture's node id on the sync stream
+    SharedMemoryConfig sharedMemory;            // Local consoles; an empty key publishes none
+    bool multicast = false;                     // Remote consoles join the group
+    MulticastConfig multicastGroup;
+    QVector<ConnectionConfig> peers;            // Other nodes the picture is synced to
+    int keyframeIntervalMs = 2000;              // Latest a console that joins waits for one
+    int syncBandwidthLimit = 0;                 // Bytes per second of sync, 0 for no limit
+    FusionEngineConfig fusion;
+    QVector<DefendedAsset> defendedAssets;
+    QList<GeofenceZone> geofences;
+    QString captureDirectory;                   // Raw bytes the links read; empty captures none
+};
+
+/**
+ * @brief Fusion, threat assessment and engagement without a GUI
+ *
+ * Runs in its own process (CounterUAS_Core), so rendering never delays a
+ * track cycle and any number of consoles share one fusion. The service
+ * owns the TrackManager, FusionEngine, ThreatAssessor and EngagementManager
+ * that a MainWindow would otherwise build for itself; sensors and effectors
+ * are wired to them before start(), as the simulators are by c2core.cpp.
+ *
+ * Every track cycle's picture goes out twice. Consoles on this host read
+ * it straight from the shared-memory segment; remote ones follow the
+ * TrackPictureSync keyframes and deltas, broadcast to the multicast group
+ * and the peers (and into the segment's message ring too). A CoreClient
+ * attaches a console to either. Alerts and acknowledgements are shared
+ * with the peers through AlertSync, under the node id.
+ */
+class CoreService : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CoreService(QObject* parent = nullptr);
+    ~CoreService() override;
+
+    bool start(const CoreServiceConfig& config);
+    void stop();
+    bool isRunning() const { return m_running; }
+    QString errorString() const { return m_error; }
+
+    TrackManager* trackManager() const { return m_trackManager; }
+    FusionEngine* fusionEngine() const { return m_fusionEngine; }
+    ThreatAssessor* threatAssessor() const { return m_threatAssessor; }
+    EngagementManager* engagementManager() const { return m_engagementManager; }
+    NetworkManager* network() const { return m_network; }
+    TrackPictureSync* pictureSync() const { return m_sync; }
+    AlertSync* alertSync() const { return m_alertSync; }
+
+    struct Statistics {
+        int tracks = 0;
+        SharedMemoryPublisher::Stats sharedMemory;
+        TrackPictureSync::Stats sync;
+        AlertSync::Stats alertSync;
+        NetworkManager::BandwidthStats network;
+    };
+    Statistics statistics() const;
+
+private:
+    CoreServiceConfig m_config;
+    TrackManager* m_trackManager;       // Unparented while fusion may own its thread
+    FusionEngine* m_fusionEngine;
+    ThreatAssessor* m_threatAssessor;
+    EngagementManager* m_engagementManager;
+    NetworkManager* m_network;
+    TrackPictureSync* m_sync;
+    AlertSync* m_alertSync;
+    std::shared_ptr<RawCaptureRecorder> m_capture;
+    bool m_running = false;
+    QString m_error;
+};
+
+} // namespace CounterUAS
+
+#endif // CORESERVICE_H
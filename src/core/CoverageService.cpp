@@ -0,0 +1,219 @@
+#include "core/CoverageService.h"
+#include "effectors/EffectorInterface.h"
+#include "sensors/CameraSystem.h"
+#include "sensors/RadarSensor.h"
+#include "utils/Logger.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QThread>
+
+namespace CounterUAS {
+
+CoverageService::CoverageService(QObject* parent)
+    : QObject(parent)
+    , m_terrain(std::make_shared<TerrainModel>())
+{
+    // Background work; leave most of the machine to the live pipeline
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+CoverageService::~CoverageService() {
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void CoverageService::setConfig(const CoverageServiceConfig& config) {
+    QMutexLocker locker(&m_mutex);
+    m_config = config;
+    m_rasters.clear();
+    for (const CoverageSite& site : qAsConst(m_sites)) scheduleBuildLocked(site);
+}
+
+CoverageServiceConfig CoverageService::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+void CoverageService::setTerrain(const TerrainModelPtr& terrain) {
+    QMutexLocker locker(&m_mutex);
+    m_terrain = terrain ? terrain : std::make_shared<TerrainModel>();
+    m_rasters.clear();
+    for (const CoverageSite& site : qAsConst(m_sites)) scheduleBuildLocked(site);
+}
+
+TerrainModelPtr CoverageService::terrain() const {
+    QMutexLocker locker(&m_mutex);
+    return m_terrain;
+}
+
+void CoverageService::setSite(const CoverageSite& site) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_sites.find(site.siteId);
+    if (it != m_sites.end() && *it == site) return;
+
+    m_sites.insert(site.siteId, site);
+    m_rasters.remove(site.siteId);
+    scheduleBuildLocked(site);
+}
+
+void CoverageService::removeSite(const QString& siteId) {
+    QPointer<EffectorInterface> effector;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_sites.remove(siteId);
+        m_rasters.remove(siteId);
+        m_generations.remove(siteId);       // A build in flight is discarded
+        effector = m_effectors.take(siteId);
+    }
+    if (effector) effector->setCoverage(nullptr);
+}
+
+QList<CoverageSite> CoverageService::sites() const {
+    QMutexLocker locker(&m_mutex);
+    return m_sites.values();
+}
+
+void CoverageService::addSensor(const SensorInterface* sensor) {
+    if (sensor) setSite(siteFor(*sensor));
+}
+
+void CoverageService::addEffector(EffectorInterface* effector) {
+    if (!effector) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_effectors.insert(effector->effectorId(), effector);
+    }
+    setSite(siteFor(*effector));
+    // An unchanged site already has its raster
+    effector->setCoverage(raster(effector->effectorId()));
+}
+
+CoverageSite CoverageService::siteFor(const SensorInterface& sensor) {
+    CoverageSite site;
+    site.siteId = sensor.sensorId();
+    site.position = sensor.position();
+    site.maxRangeM = sensor.maxRange();
+    site.fieldOfViewDeg = qBound(0.0, sensor.fieldOfView(), 360.0);
+    if (qobject_cast<const CameraSystem*>(&sensor)) {
+        site.fieldOfViewDeg = 360.0;
+    } else if (auto* radar = qobject_cast<const RadarSensor*>(&sensor)) {
+        const RadarConfig config = radar->config();
+        site.headingDeg = (config.minAzimuthDeg + config.maxAzimuthDeg) / 2.0;
+    }
+    return site;
+}
+
+CoverageSite CoverageService::siteFor(const EffectorInterface& effector) {
+    CoverageSite site;
+    site.siteId = effector.effectorId();
+    site.position = effector.position();
+    site.minRangeM = effector.minRange();
+    site.maxRangeM = effector.maxRange();
+    return site;
+}
+
+CoverageRasterPtr CoverageService::raster(const QString& siteId) const {
+    QMutexLocker locker(&m_mutex);
+    return m_rasters.value(siteId);
+}
+
+bool CoverageService::canSee(const QString& siteId, const GeoPosition& target) const {
+    const CoverageRasterPtr coverage = raster(siteId);
+    return coverage && coverage->canSee(target);
+}
+
+bool CoverageService::waitForBuilds(int timeoutMs) {
+    return m_pool.waitForDone(timeoutMs);
+}
+
+CoverageServiceStats CoverageService::stats() const {
+    CoverageServiceStats stats;
+    stats.built = m_built.load();
+    stats.loaded = m_loaded.load();
+    stats.cacheWriteFailures = m_cacheWriteFailures.load();
+    stats.pending = m_pending.load();
+    return stats;
+}
+
+void CoverageService::scheduleBuildLocked(const CoverageSite& site) {
+    const quint64 generation = ++m_nextGeneration;
+    m_generations.insert(site.siteId, generation);
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+
+    const TerrainModelPtr terrain = m_terrain;
+    const CoverageServiceConfig config = m_config;
+    m_pool.start([this, site, terrain, config, generation]() {
+        buildSite(site, terrain, config, generation);
+    });
+}
+
+void CoverageService::buildSite(const CoverageSite& site, const TerrainModelPtr& terrain,
+                                const CoverageServiceConfig& config, quint64 generation) {
+    const quint64 key = CoverageRaster::keyFor(site, *terrain, config.raster);
+    const QString path = config.diskCache ? cachePath(config, site.siteId, key) : QString();
+
+    CoverageRasterPtr raster = path.isEmpty() ? nullptr : CoverageRaster::load(path, site, key);
+    if (raster) {
+        m_loaded.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        raster = CoverageRaster::build(site, *terrain, config.raster);
+        m_built.fetch_add(1, std::memory_order_relaxed);
+        if (!path.isEmpty()) {
+            QDir dir = QFileInfo(path).dir();
+            if (!dir.mkpath(".") || !raster->save(path)) {
+                m_cacheWriteFailures.fetch_add(1, std::memory_order_relaxed);
+                Logger::instance().warning("CoverageService", "Could not cache coverage at " + path);
+            } else {
+                // Rasters of the site's earlier geometry or terrain
+                const QString name = QFileInfo(path).fileName();
+                const QString pattern = name.section('-', 0, 0) + "-????????????????.cov";
+                for (const QString& entry : dir.entryList({pattern}, QDir::Files)) {
+                    if (entry != name) dir.remove(entry);
+                }
+            }
+        }
+    }
+
+    bool current = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        // Superseded by a newer build of the site, or the site is gone
+        current = m_generations.value(site.siteId) == generation;
+        if (current) m_rasters.insert(site.siteId, raster);
+    }
+    m_pending.fetch_sub(1, std::memory_order_relaxed);
+    if (current) {
+        const QString siteId = site.siteId;
+        QMetaObject::invokeMethod(this, [this, siteId]() { deliver(siteId); }, Qt::QueuedConnection);
+    }
+}
+
+void CoverageService::deliver(const QString& siteId) {
+    CoverageRasterPtr coverage;
+    QPointer<EffectorInterface> effector;
+    {
+        QMutexLocker locker(&m_mutex);
+        coverage = m_rasters.value(siteId);
+        effector = m_effectors.value(siteId);
+    }
+    if (!coverage) return;
+    if (effector) effector->setCoverage(coverage);
+    emit coverageReady(siteId);
+}
+
+QString CoverageService::cachePath(const CoverageServiceConfig& config, const QString& siteId, quint64 key) {
+    QString directory = config.cacheDirectory;
+    if (directory.isEmpty()) {
+        directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/coverage";
+    }
+    // No '-' survives, so the key is everything after the first
+    QString name = siteId;
+    name.replace(QRegularExpression("[^A-Za-z0-9_.]"), "_");
+    return QString("%1/%2-%3.cov").arg(directory, name).arg(key, 16, 16, QLatin1Char('0'));
+}
+
+} // namespace CounterUAS
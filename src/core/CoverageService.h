@@ -0,0 +1,116 @@
+#ifndef COVERAGESERVICE_H
+#define COVERAGESERVICE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <atomic>
+#include "utils/CoverageRaster.h"
+#include "utils/TerrainModel.h"
+
+namespace CounterUAS {
+
+class SensorInterface;
+class EffectorInterface;
+
+/**
+ * @brief Raster resolution and where built rasters are kept
+ */
+struct CoverageServiceConfig {
+    CoverageRasterConfig raster;
+    QString cacheDirectory;         // Empty: the user cache location's "coverage"
+    bool diskCache = true;
+};
+
+/**
+ * @brief Build and cache counters
+ */
+struct CoverageServiceStats {
+    quint64 built = 0;              // Rasters computed from the terrain
+    quint64 loaded = 0;             // Rasters read from the disk cache
+    quint64 cacheWriteFailures = 0;
+    int pending = 0;                // Builds queued or running
+};
+
+/**
+ * @brief Line-of-sight coverage of every sensor and effector
+ *
+ * Each site gets a CoverageRaster over the terrain, built on the service's
+ * own thread pool so startup is not held up by it, and written to a disk
+ * cache keyed by the site's geometry, the raster resolution and the
+ * terrain's fingerprint; a later start with the same site and terrain
+ * reads it back instead of walking the terrain again. Until a site's
+ * raster is in, raster() is null and callers fall back to their range
+ * checks.
+ *
+ * Hot paths take the raster once with raster() and call canSee() on it,
+ * a few multiplies and one array read per point. Effectors added with
+ * addEffector() are also handed their raster as it arrives, for
+ * EffectorInterface::canEngage(). Lookups are safe from any thread; the
+ * rest is for the service's own thread.
+ */
+class CoverageService : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CoverageService(QObject* parent = nullptr);
+    ~CoverageService() override;
+
+    // Either rebuilds every site
+    void setConfig(const CoverageServiceConfig& config);
+    CoverageServiceConfig config() const;
+    void setTerrain(const TerrainModelPtr& terrain);
+    TerrainModelPtr terrain() const;
+
+    // A new or changed site is built in the background; an identical one
+    // keeps its raster
+    void setSite(const CoverageSite& site);
+    void removeSite(const QString& siteId);
+    QList<CoverageSite> sites() const;
+
+    // Sites from the device's position(), maxRange() and fieldOfView();
+    // cameras pan, so they cover all round
+    void addSensor(const SensorInterface* sensor);
+    void addEffector(EffectorInterface* effector);
+    static CoverageSite siteFor(const SensorInterface& sensor);
+    static CoverageSite siteFor(const EffectorInterface& effector);
+
+    CoverageRasterPtr raster(const QString& siteId) const;  // Null until built
+    // False until the site's raster is built
+    bool canSee(const QString& siteId, const GeoPosition& target) const;
+
+    // True once no build is queued or running
+    bool waitForBuilds(int timeoutMs = -1);
+    CoverageServiceStats stats() const;
+
+signals:
+    void coverageReady(const QString& siteId);
+
+private:
+    void scheduleBuildLocked(const CoverageSite& site);
+    void buildSite(const CoverageSite& site, const TerrainModelPtr& terrain,
+                   const CoverageServiceConfig& config, quint64 generation);
+    void deliver(const QString& siteId);
+    static QString cachePath(const CoverageServiceConfig& config, const QString& siteId, quint64 key);
+
+    mutable QMutex m_mutex;                     // Guards everything below but the pool and counters
+    CoverageServiceConfig m_config;
+    TerrainModelPtr m_terrain;
+    QHash<QString, CoverageSite> m_sites;
+    QHash<QString, CoverageRasterPtr> m_rasters;
+    QHash<QString, quint64> m_generations;      // Of each site's newest build
+    quint64 m_nextGeneration = 0;
+    QHash<QString, QPointer<EffectorInterface>> m_effectors;
+
+    QThreadPool m_pool;
+    std::atomic<quint64> m_built{0};
+    std::atomic<quint64> m_loaded{0};
+    std::atomic<quint64> m_cacheWriteFailures{0};
+    std::atomic<int> m_pending{0};
+};
+
+} // namespace CounterUAS
+
+#endif // COVERAGESERVICE_H
@@ -0,0 +1,217 @@
+#include "core/DefendedAssetIndex.h"
+#include "core/ThreatAssessor.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+// Sort-Tile-Recursive order: slabs along east, each slab sorted by north
+template<typename T, typename EastFn, typename NorthFn>
+void strOrder(QVector<T>& items, EastFn east, NorthFn north) {
+    const int n = items.size();
+    const int leaves = (n + DefendedAssetIndex::NODE_CAPACITY - 1) / DefendedAssetIndex::NODE_CAPACITY;
+    const int slabs = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(leaves)))));
+    const int slabSize = slabs * DefendedAssetIndex::NODE_CAPACITY;
+
+    std::sort(items.begin(), items.end(),
+              [&east](const T& a, const T& b) { return east(a) < east(b); });
+    for (int start = 0; start < n; start += slabSize) {
+        auto first = items.begin() + start;
+        auto last = items.begin() + std::min(n, start + slabSize);
+        std::sort(first, last, [&north](const T& a, const T& b) { return north(a) < north(b); });
+    }
+}
+
+double metersPerDegLon(double latitude) {
+    return DefendedAssetIndex::METERS_PER_DEG_LAT * std::cos(qDegreesToRadians(latitude));
+}
+
+double boxDistanceSq(double v, double lo, double hi) {
+    const double d = v < lo ? lo - v : (v > hi ? v - hi : 0.0);
+    return d * d;
+}
+
+} // namespace
+
+void DefendedAssetIndex::rebuild(const QList<DefendedAsset>& assets) {
+    clear();
+    if (assets.isEmpty()) return;
+
+    // Shared frame centred on the assets, used only to search the tree
+    for (const DefendedAsset& asset : assets) {
+        m_originLat += asset.position.latitude;
+        m_originLon += asset.position.longitude;
+    }
+    m_originLat /= assets.size();
+    m_originLon /= assets.size();
+    m_originMetersPerDegLon = metersPerDegLon(m_originLat);
+
+    m_entries.reserve(assets.size());
+    for (const DefendedAsset& asset : assets) {
+        Entry entry;
+        entry.latitude = asset.position.latitude;
+        entry.longitude = asset.position.longitude;
+        entry.metersPerDegLon = metersPerDegLon(asset.position.latitude);
+        entry.criticalRadiusM = asset.criticalRadiusM;
+        entry.warningRadiusM = asset.warningRadiusM;
+        entry.criticalRadiusSq = asset.criticalRadiusM * asset.criticalRadiusM;
+        entry.warningRadiusSq = asset.warningRadiusM * asset.warningRadiusM;
+        entry.outerRadiusSq = 4.0 * entry.warningRadiusSq;
+        entry.east = (asset.position.longitude - m_originLon) * m_originMetersPerDegLon;
+        entry.north = (asset.position.latitude - m_originLat) * METERS_PER_DEG_LAT;
+        m_entries.append(entry);
+    }
+
+    if (m_entries.size() >= TREE_THRESHOLD) {
+        buildTree();
+    }
+}
+
+void DefendedAssetIndex::clear() {
+    m_entries.clear();
+    m_nodes.clear();
+    m_leafItems.clear();
+    m_root = -1;
+    m_originLat = 0.0;
+    m_originLon = 0.0;
+    m_originMetersPerDegLon = 0.0;
+}
+
+double DefendedAssetIndex::distanceSqTo(int asset, const GeoPosition& pos) const {
+    // In the asset's own tangent plane
+    const Entry& a = m_entries[asset];
+    const double de = (pos.longitude - a.longitude) * a.metersPerDegLon;
+    const double dn = (pos.latitude - a.latitude) * METERS_PER_DEG_LAT;
+    return de * de + dn * dn;
+}
+
+DefendedAssetFix DefendedAssetIndex::nearest(const GeoPosition& pos, const VelocityVector* vel) const {
+    DefendedAssetFix fix;
+    if (m_entries.isEmpty()) return fix;
+
+    if (m_root >= 0) {
+        const double e = (pos.longitude - m_originLon) * m_originMetersPerDegLon;
+        const double n = (pos.latitude - m_originLat) * METERS_PER_DEG_LAT;
+        double bestSq = std::numeric_limits<double>::max();
+        searchTree(m_root, e, n, fix.asset, bestSq);
+        fix.distanceSqM2 = distanceSqTo(fix.asset, pos);
+    } else {
+        for (int i = 0; i < m_entries.size(); ++i) {
+            const double dSq = distanceSqTo(i, pos);
+            if (dSq < fix.distanceSqM2) {
+                fix.distanceSqM2 = dSq;
+                fix.asset = i;
+            }
+        }
+    }
+    fix.distanceM = std::sqrt(fix.distanceSqM2);
+
+    if (vel) {
+        const Entry& a = m_entries[fix.asset];
+        const double toEast = (a.longitude - pos.longitude) * a.metersPerDegLon;
+        const double toNorth = (a.latitude - pos.latitude) * METERS_PER_DEG_LAT;
+        double bearing = qRadiansToDegrees(std::atan2(toEast, toNorth));
+        if (bearing < 0) bearing += 360.0;
+
+        fix.headingOffsetDeg = std::abs(vel->heading() - bearing);
+        if (fix.headingOffsetDeg > 180.0) {
+            fix.headingOffsetDeg = 360.0 - fix.headingOffsetDeg;
+        }
+    }
+    return fix;
+}
+
+void DefendedAssetIndex::buildTree() {
+    // Leaves over STR-ordered assets
+    m_leafItems.resize(m_entries.size());
+    for (int i = 0; i < m_entries.size(); ++i) m_leafItems[i] = i;
+    strOrder(m_leafItems,
+             [this](int i) { return m_entries[i].east; },
+             [this](int i) { return m_entries[i].north; });
+
+    QVector<Node> level;
+    for (int first = 0; first < m_leafItems.size(); first += NODE_CAPACITY) {
+        Node leaf;
+        leaf.first = first;
+        leaf.count = std::min(NODE_CAPACITY, m_leafItems.size() - first);
+        leaf.leaf = true;
+        leaf.minE = leaf.minN = std::numeric_limits<double>::max();
+        leaf.maxE = leaf.maxN = -std::numeric_limits<double>::max();
+        for (int k = first; k < first + leaf.count; ++k) {
+            const Entry& a = m_entries[m_leafItems[k]];
+            leaf.minE = std::min(leaf.minE, a.east);   leaf.maxE = std::max(leaf.maxE, a.east);
+            leaf.minN = std::min(leaf.minN, a.north);  leaf.maxN = std::max(leaf.maxN, a.north);
+        }
+        level.append(leaf);
+    }
+
+    // Pack each level's nodes into parents until one root remains
+    auto centreE = [](const Node& node) { return node.minE + node.maxE; };
+    auto centreN = [](const Node& node) { return node.minN + node.maxN; };
+    while (level.size() > 1) {
+        strOrder(level, centreE, centreN);
+        const int base = m_nodes.size();
+        m_nodes += level;
+
+        QVector<Node> parents;
+        for (int first = 0; first < level.size(); first += NODE_CAPACITY) {
+            Node parent;
+            parent.first = base + first;
+            parent.count = std::min(NODE_CAPACITY, level.size() - first);
+            parent.leaf = false;
+            parent.minE = parent.minN = std::numeric_limits<double>::max();
+            parent.maxE = parent.maxN = -std::numeric_limits<double>::max();
+            for (int k = first; k < first + parent.count; ++k) {
+                const Node& child = level[k];
+                parent.minE = std::min(parent.minE, child.minE); parent.maxE = std::max(parent.maxE, child.maxE);
+                parent.minN = std::min(parent.minN, child.minN); parent.maxN = std::max(parent.maxN, child.maxN);
+            }
+            parents.append(parent);
+        }
+        level = parents;
+    }
+
+    m_nodes.append(level.first());
+    m_root = m_nodes.size() - 1;
+}
+
+void DefendedAssetIndex::searchTree(int nodeIndex, double e, double n, int& bestAsset, double& bestSq) const {
+    const Node& node = m_nodes[nodeIndex];
+    const double boxSq = boxDistanceSq(e, node.minE, node.maxE) +
+                         boxDistanceSq(n, node.minN, node.maxN);
+    if (boxSq >= bestSq) return;
+
+    if (node.leaf) {
+        for (int k = node.first; k < node.first + node.count; ++k) {
+            const Entry& a = m_entries[m_leafItems[k]];
+            const double de = e - a.east;
+            const double dn = n - a.north;
+            const double dSq = de * de + dn * dn;
+            if (dSq < bestSq) {
+                bestSq = dSq;
+                bestAsset = m_leafItems[k];
+            }
+        }
+        return;
+    }
+
+    // Nearer children first so the bound tightens early
+    int order[NODE_CAPACITY];
+    double childSq[NODE_CAPACITY];
+    for (int k = 0; k < node.count; ++k) {
+        const Node& child = m_nodes[node.first + k];
+        order[k] = k;
+        childSq[k] = boxDistanceSq(e, child.minE, child.maxE) +
+                     boxDistanceSq(n, child.minN, child.maxN);
+    }
+    std::sort(order, order + node.count, [&childSq](int a, int b) { return childSq[a] < childSq[b]; });
+    for (int k = 0; k < node.count; ++k) {
+        if (childSq[order[k]] >= bestSq) break;
+        searchTree(node.first + order[k], e, n, bestAsset, bestSq);
+    }
+}
+
+} // namespace CounterUAS
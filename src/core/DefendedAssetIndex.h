@@ -0,0 +1,93 @@
+#ifndef DEFENDEDASSETINDEX_H
+#define DEFENDEDASSETINDEX_H
+
+#include <QList>
+#include <QVector>
+#include <limits>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+struct DefendedAsset;
+
+/**
+ * @brief Nearest defended asset of one position
+ */
+struct DefendedAssetFix {
+    int asset = -1;                                          // Index into the asset list
+    double distanceSqM2 = std::numeric_limits<double>::max();
+    double distanceM = std::numeric_limits<double>::max();   // Ground range
+    double headingOffsetDeg = -1;                            // |heading - bearing to asset|, 0-180
+};
+
+/**
+ * @brief Defended assets in local tangent planes, for cheap proximity queries
+ *
+ * Every asset carries its own east/north frame (metres per degree at the
+ * asset) and its radii squared, so the ground range from a track is a small
+ * vector op instead of a haversine. Beyond TREE_THRESHOLD assets a
+ * static R-tree over a shared frame centred on the assets narrows the search;
+ * the winner's range is then taken in its own frame. The tangent-plane
+ * approximation is well inside sensor accuracy at counter-UAS ranges.
+ *
+ * Rebuilt on asset changes; queries are const and allocation-free.
+ */
+class DefendedAssetIndex {
+public:
+    static constexpr int TREE_THRESHOLD = 32;
+    static constexpr int NODE_CAPACITY = 8;
+    
+    // EARTH_RADIUS_M * pi / 180: the sphere Track::distanceTo() uses, so radii mean the same thing
+    static constexpr double METERS_PER_DEG_LAT = 111194.92664455873;
+
+    struct Entry {
+        double latitude = 0.0;
+        double longitude = 0.0;
+        double metersPerDegLon = 0.0;  // At the asset's latitude
+        double criticalRadiusM = 0.0;
+        double warningRadiusM = 0.0;
+        double criticalRadiusSq = 0.0;
+        double warningRadiusSq = 0.0;
+        double outerRadiusSq = 0.0;    // Twice the warning radius
+        double east = 0.0;             // Position in the shared index frame
+        double north = 0.0;
+    };
+
+    void rebuild(const QList<DefendedAsset>& assets);
+    void clear();
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int size() const { return m_entries.size(); }
+    const Entry& entry(int asset) const { return m_entries[asset]; }
+    bool hasTree() const { return m_root >= 0; }
+
+    // Nearest asset with heading offset; heading is skipped when vel is null
+    DefendedAssetFix nearest(const GeoPosition& pos, const VelocityVector* vel = nullptr) const;
+    double nearestDistance(const GeoPosition& pos) const { return nearest(pos).distanceM; }
+
+private:
+    struct Node {
+        double minE, minN;
+        double maxE, maxN;
+        int first;   // Into m_leafItems (leaf) or m_nodes (inner)
+        int count;
+        bool leaf;
+    };
+
+    double distanceSqTo(int asset, const GeoPosition& pos) const;
+    void buildTree();
+    void searchTree(int node, double e, double n, int& bestAsset, double& bestSq) const;
+
+    QVector<Entry> m_entries;
+    double m_originLat = 0.0;
+    double m_originLon = 0.0;
+    double m_originMetersPerDegLon = 0.0;
+
+    QVector<Node> m_nodes;
+    QVector<int> m_leafItems;
+    int m_root = -1;
+};
+
+} // namespace CounterUAS
+
+#endif // DEFENDEDASSETINDEX_H
@@ -0,0 +1,77 @@
+#include "core/DetectionMerger.h"
+#include <QHash>
+#include <algorithm>
+
+namespace CounterUAS {
+
+DetectionMerger::DetectionMerger(int windowMs, int laneCapacity)
+    : m_windowMs(qMax(0, windowMs))
+{
+    for (auto& lane : m_lanes) {
+        lane.reset(new BoundedQueue<SensorDetection>(qMax(2, laneCapacity)));
+    }
+}
+
+bool DetectionMerger::push(const SensorDetection& detection) {
+    BoundedQueue<SensorDetection>& lane = *m_lanes[qHash(detection.sensorId) % LANE_COUNT];
+    if (!lane.tryPush(detection)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_pushed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+QVector<SensorDetection> DetectionMerger::release(qint64 nowMs, bool flushAll) {
+    intake(nowMs);
+
+    const qint64 watermark = nowMs - m_windowMs;
+    QVector<SensorDetection> out;
+    while (!m_heap.empty() && (flushAll || m_heap.front().keyMs <= watermark)) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), Later());
+        out.append(std::move(m_heap.back().detection));
+        m_heap.pop_back();
+    }
+    m_releasedToMs = qMax(m_releasedToMs, flushAll ? m_newestKeyMs : watermark);
+    m_released += out.size();
+    return out;
+}
+
+DetectionMerger::Stats DetectionMerger::stats() const {
+    Stats stats;
+    stats.pushed = m_pushed.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.released = m_released;
+    stats.reordered = m_reordered;
+    stats.late = m_late;
+    stats.retimed = m_retimed;
+    stats.buffered = buffered();
+    return stats;
+}
+
+void DetectionMerger::intake(qint64 nowMs) {
+    SensorDetection detection;
+    for (auto& lane : m_lanes) {
+        while (lane->tryPop(detection)) {
+            qint64 key = detection.timestamp;
+            if (key <= 0 || key > nowMs + m_windowMs) {
+                key = nowMs;
+                ++m_retimed;
+            }
+
+            if (key <= m_releasedToMs) {
+                // Its window has gone; release next rather than hold it forever
+                ++m_late;
+                key = m_releasedToMs;
+            } else if (key < m_newestKeyMs) {
+                ++m_reordered;
+            }
+            m_newestKeyMs = qMax(m_newestKeyMs, key);
+
+            m_heap.push_back(Held{key, m_nextSequence++, std::move(detection)});
+            std::push_heap(m_heap.begin(), m_heap.end(), Later());
+        }
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,88 @@
+#ifndef DETECTIONMERGER_H
+#define DETECTIONMERGER_H
+
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "sensors/SensorInterface.h"
+#include "utils/BoundedQueue.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Time-ordered merge of detections from many sensors
+ *
+ * Producers push from any thread into per-sensor lanes (lock-free bounded
+ * queues; a sensor hashes to a fixed lane, so no registration is needed).
+ * A single consumer periodically calls release(), which drains every lane
+ * into a reorder heap and hands back, in timestamp order, every detection
+ * older than the latency window. A detection that arrives after its window
+ * has already been released is counted late and released at once: holding
+ * it longer cannot put it back in order.
+ *
+ * Timestamps are epoch milliseconds. A detection without one, or stamped
+ * more than a window ahead of the consumer's clock, is ordered by its
+ * arrival instead so a skewed sensor clock cannot stall the merge.
+ */
+class DetectionMerger {
+public:
+    static constexpr int LANE_COUNT = 16;
+
+    DetectionMerger(int windowMs, int laneCapacity);
+
+    int windowMs() const { return m_windowMs; }
+
+    // Thread-safe; false if the sensor's lane is full
+    bool push(const SensorDetection& detection);
+
+    // Consumer only. Detections stamped at or before nowMs - windowMs (all
+    // of them, with flushAll), oldest first.
+    QVector<SensorDetection> release(qint64 nowMs, bool flushAll = false);
+    int buffered() const { return static_cast<int>(m_heap.size()); }
+
+    struct Stats {
+        quint64 pushed = 0;
+        quint64 dropped = 0;      // Lane full
+        quint64 released = 0;
+        quint64 reordered = 0;    // Arrived behind a newer detection and was put back in order
+        quint64 late = 0;         // Arrived after its window; released out of order
+        quint64 retimed = 0;      // Ordered by arrival: no timestamp or clock ahead
+        int buffered = 0;
+    };
+    Stats stats() const;        // Consumer side fields are exact only on the consumer thread
+
+private:
+    struct Held {
+        qint64 keyMs;
+        quint64 sequence;        // Arrival order breaks timestamp ties
+        SensorDetection detection;
+    };
+    struct Later {
+        bool operator()(const Held& a, const Held& b) const {
+            return a.keyMs != b.keyMs ? a.keyMs > b.keyMs : a.sequence > b.sequence;
+        }
+    };
+
+    void intake(qint64 nowMs);
+
+    int m_windowMs;
+    std::unique_ptr<BoundedQueue<SensorDetection>> m_lanes[LANE_COUNT];
+    std::atomic<quint64> m_pushed{0};
+    std::atomic<quint64> m_dropped{0};
+
+    // Consumer state
+    std::vector<Held> m_heap;    // Min-heap on (keyMs, sequence)
+    quint64 m_nextSequence = 0;
+    qint64 m_newestKeyMs = 0;    // Newest timestamp taken in
+    qint64 m_releasedToMs = 0;   // Everything at or before this has been released
+    quint64 m_released = 0;
+    quint64 m_reordered = 0;
+    quint64 m_late = 0;
+    quint64 m_retimed = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // DETECTIONMERGER_H
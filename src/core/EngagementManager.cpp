@@ -1,9 +1,18 @@
 #include "core/EngagementManager.h"
 #include "core/TrackManager.h"
+#include "core/ThreatAssessor.h"
 #include "effectors/EffectorInterface.h"
+#include "effectors/KineticInterceptor.h"
+#include "effectors/RFJammer.h"
+#include "utils/Clock.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/JsonWriter.h"
 #include "utils/Logger.h"
+#include "utils/MemoryGovernor.h"
+#include "utils/MetricsRegistry.h"
 #include <QJsonObject>
 #include <QBuffer>
+#include <QMap>
 
 namespace CounterUAS {
 
@@ -24,25 +33,77 @@ QJsonObject EngagementRecord::toJson() const {
     obj["targetPosition"] = targetPosition.toJson();
     obj["targetDistance"] = targetDistance;
     obj["threatLevel"] = threatLevel;
+    obj["snapshotId"] = snapshotId;
     obj["notes"] = notes;
     obj["wasAborted"] = wasAborted;
     obj["abortReason"] = abortReason;
     return obj;
 }
 
+void EngagementRecord::writeJson(JsonWriter& writer) const {
+    writer.beginObject();
+    writer.key("engagementId");
+    writer.writeString(engagementId);
+    writer.key("trackId");
+    writer.writeString(trackId);
+    writer.key("effectorId");
+    writer.writeString(effectorId);
+    writer.key("effectorType");
+    writer.writeString(effectorType);
+    writer.key("operatorId");
+    writer.writeString(operatorId);
+    writer.key("startTime");
+    writer.writeDateTime(startTime);
+    writer.key("authorizationTime");
+    writer.writeDateTime(authorizationTime);
+    writer.key("executionTime");
+    writer.writeDateTime(executionTime);
+    writer.key("completionTime");
+    writer.writeDateTime(completionTime);
+    writer.key("state");
+    writer.writeInt(static_cast<int>(state));
+    writer.key("bdaResult");
+    writer.writeInt(static_cast<int>(bdaResult));
+    writer.key("targetPosition");
+    targetPosition.writeJson(writer);
+    writer.key("targetDistance");
+    writer.writeDouble(targetDistance);
+    writer.key("threatLevel");
+    writer.writeInt(threatLevel);
+    writer.key("snapshotId");
+    writer.writeString(snapshotId);
+    writer.key("notes");
+    writer.writeString(notes);
+    writer.key("wasAborted");
+    writer.writeBool(wasAborted);
+    writer.key("abortReason");
+    writer.writeString(abortReason);
+    writer.endObject();
+}
+
 EngagementManager::EngagementManager(TrackManager* trackManager, QObject* parent)
     : QObject(parent)
     , m_trackManager(trackManager)
-    , m_authorizationTimer(new QTimer(this))
-    , m_completionCheckTimer(new QTimer(this))
+    , m_wheelTimer(new QTimer(this))
 {
-    m_authorizationTimer->setSingleShot(true);
-    connect(m_authorizationTimer, &QTimer::timeout,
-            this, &EngagementManager::onAuthorizationTimeout);
+    m_wheelTimer->setInterval(m_timers.tickMs());
+    connect(m_wheelTimer, &QTimer::timeout,
+            this, &EngagementManager::onTimerTick);
+    
+    setEngagementSlots(DEFAULT_ENGAGEMENT_SLOTS);
     
-    m_completionCheckTimer->setInterval(100);
-    connect(m_completionCheckTimer, &QTimer::timeout,
-            this, &EngagementManager::checkEngagementCompletion);
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    const QString help = "Engagements finished, by outcome";
+    m_completedMetric = registry.counter("cuas_engagements_total", help, {{"outcome", "completed"}});
+    m_abortedMetric = registry.counter("cuas_engagements_total", help, {{"outcome", "aborted"}});
+    m_failedMetric = registry.counter("cuas_engagements_total", help, {{"outcome", "failed"}});
+    m_durationMetric = registry.histogram("cuas_engagement_duration_seconds",
+                                          "Engagement start to completion");
+    
+    // Snapshot thumbnails are recut from the JPEGs under memory pressure
+    m_memoryConsumer = MemoryGovernor::instance().registerConsumer(this, "engagement.snapshots", MemoryShedOrder::Thumbnails, 0,
+        [this]() { return m_snapshots.memoryBytes(); },
+        [this](MemoryPressure pressure) { m_snapshots.setKeepThumbnails(pressure == MemoryPressure::Normal); });
     
     if (m_trackManager) {
         connect(m_trackManager, &TrackManager::trackDropped,
@@ -51,41 +112,55 @@ EngagementManager::EngagementManager(TrackManager* trackManager, QObject* parent
 }
 
 EngagementManager::~EngagementManager() {
-    m_authorizationTimer->stop();
-    m_completionCheckTimer->stop();
+    MemoryGovernor::instance().unregisterConsumer(m_memoryConsumer);
+    m_wheelTimer->stop();
 }
 
 void EngagementManager::registerEffector(EffectorInterface* effector) {
-    if (!effector || m_effectors.contains(effector)) return;
+    if (!effector || m_effectorById.contains(effector->effectorId())) return;
     
     m_effectors.append(effector);
-    connect(effector, &EffectorInterface::statusChanged,
-            this, [this, effector]() {
-                onEffectorStatusChanged(effector->effectorId());
-            });
+    m_effectorById.insert(effector->effectorId(), effector);
+    connect(effector, &EffectorInterface::telemetry,
+            this, &EngagementManager::onEffectorEvent);
     
     Logger::instance().info("EngagementManager",
                            "Registered effector: " + effector->effectorId());
+    
+    if (m_spectrumPlanning && qobject_cast<RFJammer*>(effector)) {
+        updateSpectrumPlan();
+    }
 }
 
 void EngagementManager::unregisterEffector(const QString& effectorId) {
-    for (int i = 0; i < m_effectors.size(); ++i) {
-        if (m_effectors[i]->effectorId() == effectorId) {
-            m_effectors.removeAt(i);
-            Logger::instance().info("EngagementManager",
-                                   "Unregistered effector: " + effectorId);
-            return;
+    EffectorInterface* eff = m_effectorById.value(effectorId);
+    if (!eff) return;
+    
+    // Its callbacks go with it; engagements on it fail below as effector lost
+    if (effectorId == m_selectedEffectorId) {
+        cancelCompletion(effectorId, m_completionCallback);
+    }
+    for (EngagementSlot& s : m_slots) {
+        if (s.used && s.record.effectorId == effectorId) {
+            cancelCompletion(effectorId, s.completionCallback);
         }
     }
+    disconnect(eff, nullptr, this, nullptr);
+    
+    const bool jammer = qobject_cast<RFJammer*>(eff) != nullptr;
+    m_effectors.removeOne(eff);
+    m_effectorById.remove(effectorId);
+    Logger::instance().info("EngagementManager",
+                           "Unregistered effector: " + effectorId);
+    
+    onEffectorStatusChanged(effectorId);
+    if (m_spectrumPlanning && jammer) {
+        updateSpectrumPlan();
+    }
 }
 
 EffectorInterface* EngagementManager::effector(const QString& effectorId) const {
-    for (auto* e : m_effectors) {
-        if (e->effectorId() == effectorId) {
-            return e;
-        }
-    }
-    return nullptr;
+    return m_effectorById.value(effectorId);
 }
 
 EffectorInterface* EngagementManager::recommendedEffector(const QString& trackId) const {
@@ -110,6 +185,685 @@ EffectorInterface* EngagementManager::recommendedEffector(const QString& trackId
     return best;
 }
 
+void EngagementManager::setThreatAssessor(ThreatAssessor* assessor) {
+    if (m_threatAssessor) {
+        disconnect(m_threatAssessor, nullptr, this, nullptr);
+    }
+    m_threatAssessor = assessor;
+    if (m_threatAssessor) {
+        connect(m_threatAssessor, &ThreatAssessor::assessmentComplete, this, [this]() {
+            if (m_batchAssignment) {
+                updateAssignments();
+            }
+        });
+    }
+}
+
+void EngagementManager::setBatchAssignmentEnabled(bool enable) {
+    if (m_batchAssignment == enable) return;
+    m_batchAssignment = enable;
+    if (enable) {
+        updateAssignments();
+    }
+}
+
+void EngagementManager::setSpectrumPlanningEnabled(bool enable) {
+    if (m_spectrumPlanning == enable) return;
+    m_spectrumPlanning = enable;
+    if (enable) {
+        updateSpectrumPlan();
+    } else {
+        // Back to each jammer's configured frequencies
+        for (auto* eff : qAsConst(m_effectors)) {
+            if (auto* jammer = qobject_cast<RFJammer*>(eff)) {
+                jammer->setChannelPlan({});
+            }
+        }
+    }
+}
+
+void EngagementManager::reportEmission(const JamEmission& emission) {
+    JamEmission seen = emission;
+    seen.lastSeenMs = clock()->nowMs();
+    m_spectrum.updateEmission(seen);
+    
+    if (!m_spectrumExpiryTimer) {
+        m_spectrumExpiryTimer = scheduleTimer(EMISSION_TIMEOUT_MS,
+                                              timerKey(TimerKind::SpectrumExpiry, 0));
+    }
+    if (m_spectrumPlanning) {
+        updateSpectrumPlan();
+    }
+}
+
+void EngagementManager::removeEmission(const QString& emissionId) {
+    if (m_spectrum.removeEmission(emissionId) && m_spectrumPlanning) {
+        updateSpectrumPlan();
+    }
+}
+
+QVector<JammerPlan> EngagementManager::updateSpectrumPlan() {
+    QVector<JammerSpectrum> spectra;
+    QHash<QString, RFJammer*> jammers;
+    for (auto* eff : qAsConst(m_effectors)) {
+        auto* jammer = qobject_cast<RFJammer*>(eff);
+        if (!jammer) continue;
+        
+        const RFJammerConfig config = jammer->config();
+        JammerSpectrum spectrum;
+        spectrum.jammerId = jammer->effectorId();
+        spectrum.minFrequencyMHz = config.minFrequencyMHz;
+        spectrum.maxFrequencyMHz = config.maxFrequencyMHz;
+        spectrum.channels = jammer->maxJamChannels();
+        spectrum.channelBandwidthMHz = config.channelBandwidthMHz;
+        spectra.append(spectrum);
+        jammers.insert(spectrum.jammerId, jammer);
+    }
+    m_spectrum.setJammers(spectra);
+    
+    const quint64 solvedBefore = m_spectrum.stats().jammersSolved;
+    const QVector<JammerPlan> plans = m_spectrum.plan();
+    
+    // A jammer already on its plan is not retuned
+    for (const JammerPlan& plan : plans) {
+        if (RFJammer* jammer = jammers.value(plan.jammerId)) {
+            jammer->setChannelPlan(plan.centersMHz());
+        }
+    }
+    if (m_spectrum.stats().jammersSolved != solvedBefore) {
+        emit spectrumPlanUpdated(plans);
+    }
+    return plans;
+}
+
+QVector<WeaponAssignment> EngagementManager::updateAssignments() {
+    QVector<AssignmentEffector> effectors;
+    effectors.reserve(m_effectors.size());
+    for (auto* eff : qAsConst(m_effectors)) {
+        AssignmentEffector e;
+        e.effectorId = eff->effectorId();
+        e.effectorType = eff->effectorType();
+        e.position = eff->position();
+        e.minRange = eff->minRange();
+        e.maxRange = eff->maxRange();
+        e.effectiveness = eff->effectiveness();
+        const CoverageRasterPtr coverage = eff->coverage();
+        if (coverage && coverage->isFor(e.position)) e.coverage = coverage;
+        e.envelope = eff->envelope();
+        if (auto* kinetic = qobject_cast<KineticInterceptor*>(eff)) {
+            e.hasKinematics = true;
+            e.kinematics = kinetic->kinematics();
+        }
+        // The single-track workflow holds its effector from authorization on
+        e.ready = eff->isReady() &&
+                  (m_currentEngagementId.isEmpty() || e.effectorId != m_selectedEffectorId);
+        effectors.append(e);
+    }
+    
+    QVector<TrackSnapshot> tracks;
+    if (m_threatAssessor) {
+        tracks = m_threatAssessor->threatQueueSnapshot();
+    } else if (m_trackManager) {
+        tracks = m_trackManager->snapshot()->tracks;
+    }
+    
+    const QHash<QString, QString> committed = m_assigner.committed();
+    QVector<AssignmentThreat> threats;
+    threats.reserve(tracks.size());
+    for (const TrackSnapshot& track : qAsConst(tracks)) {
+        if (track.state == TrackState::Dropped) continue;
+        // Engaged through the single-track workflow
+        if (track.engaged && !committed.contains(track.trackId)) continue;
+        
+        AssignmentThreat threat;
+        threat.trackId = track.trackId;
+        threat.position = track.position;
+        threat.velocity = track.velocity;
+        threat.classification = track.classification;
+        threat.threatLevel = track.threatLevel;
+        threat.trackQuality = track.trackQuality;
+        threat.groupId = track.groupId;
+        threat.groupSize = qMax(1, track.groupSize);
+        if (m_threatAssessor) {
+            threat.timeToImpactSec = m_threatAssessor->closestApproach(track.trackId).timeToImpactSec;
+        }
+        threats.append(threat);
+    }
+    
+    m_assigner.syncEffectors(effectors);
+    m_assigner.syncThreats(threats);
+    const QVector<WeaponAssignment> plan = m_assigner.solve();
+    
+    emit assignmentsUpdated(plan);
+    return plan;
+}
+
+void EngagementManager::setEngagementSlots(int slots) {
+    slots = qMax(1, slots);
+    if (slots == m_slots.size()) return;
+    
+    // Only grows while engagements are in flight
+    if (slots < m_slots.size() && !m_slotByEngagement.isEmpty()) {
+        Logger::instance().warning("EngagementManager",
+                                  "Cannot shrink the slot table with engagements in flight");
+        return;
+    }
+    
+    const bool idle = m_slotByEngagement.isEmpty();
+    const int first = idle ? 0 : m_slots.size();
+    m_slots.resize(slots);
+    
+    // Lowest free slot last, so it is the next taken
+    QVector<int> added;
+    for (int i = slots - 1; i >= first; --i) {
+        added.append(i);
+    }
+    m_freeSlots = idle ? added : added + m_freeSlots;
+}
+
+QStringList EngagementManager::requestBatchAuthorization(const QVector<WeaponAssignment>& assignments) {
+    // Group by ROE: same classification against the same kind of effector
+    QMap<QString, QVector<int>> groups;
+    for (const WeaponAssignment& assignment : assignments) {
+        if (assignment.committed) continue;
+        const int slot = createSlot(assignment);
+        if (slot < 0) continue;
+        
+        const EngagementSlot& s = m_slots[slot];
+        const QString group = QString("%1/%2")
+                                  .arg(Track::classificationToString(s.request.classification))
+                                  .arg(s.record.effectorType);
+        groups[group].append(slot);
+    }
+    
+    QStringList batchIds;
+    const QDateTime now = clock()->nowUtc();
+    for (auto it = groups.constBegin(); it != groups.constEnd(); ++it) {
+        BatchAuthorizationRequest batch;
+        batch.batchId = QString("BAT-%1").arg(m_nextBatchNumber, 6, 10, QChar('0'));
+        batch.roeGroup = it.key();
+        batch.requestTime = now;
+        batch.timeoutSeconds = m_authTimeoutSeconds;
+        for (int slot : it.value()) {
+            EngagementSlot& s = m_slots[slot];
+            s.batchId = batch.batchId;
+            s.request.requestTime = now;
+            s.request.timeoutSeconds = m_authTimeoutSeconds;
+            batch.engagementIds.append(s.record.engagementId);
+            batch.requests.append(s.request);
+            transitionSlot(slot, EngagementState::AwaitingAuthorization);
+        }
+        
+        m_batches.insert(batch.batchId, batch);
+        m_batchTimers.insert(batch.batchId,
+                             scheduleTimer(m_authTimeoutSeconds * 1000LL,
+                                           timerKey(TimerKind::BatchTimeout, m_nextBatchNumber)));
+        m_nextBatchNumber++;
+        batchIds.append(batch.batchId);
+        
+        Logger::instance().info("EngagementManager",
+                               QString("Authorization requested for batch %1: %2 engagements, %3")
+                                   .arg(batch.batchId)
+                                   .arg(batch.engagementIds.size())
+                                   .arg(batch.roeGroup));
+        
+        emit batchAuthorizationRequested(batch);
+    }
+    
+    if (m_batchAssignment && !batchIds.isEmpty()) {
+        updateAssignments();
+    }
+    return batchIds;
+}
+
+void EngagementManager::authorizeBatch(const QString& batchId, const QString& operatorId) {
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) {
+        Logger::instance().warning("EngagementManager", "No pending batch " + batchId);
+        return;
+    }
+    const QStringList engagementIds = it->engagementIds;
+    m_batches.erase(it);
+    TimerWheel::TimerId timer = m_batchTimers.take(batchId);
+    cancelTimer(timer);
+    
+    Logger::instance().info("EngagementManager",
+                           QString("Batch %1 authorized by %2").arg(batchId).arg(operatorId));
+    
+    for (const QString& engagementId : engagementIds) {
+        const int slot = slotOf(engagementId);
+        if (slot < 0 || m_slots[slot].record.state != EngagementState::AwaitingAuthorization) continue;
+        authorizeSlot(slot, operatorId);
+        executeSlot(slot);
+    }
+}
+
+void EngagementManager::denyBatch(const QString& batchId, const QString& reason) {
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) return;
+    const QStringList engagementIds = it->engagementIds;
+    m_batches.erase(it);
+    TimerWheel::TimerId timer = m_batchTimers.take(batchId);
+    cancelTimer(timer);
+    
+    for (const QString& engagementId : engagementIds) {
+        const int slot = slotOf(engagementId);
+        if (slot < 0) continue;
+        m_slots[slot].record.notes = "Denied: " + reason;
+        finishSlot(slot, EngagementState::Aborted);
+    }
+    
+    Logger::instance().info("EngagementManager",
+                           QString("Batch %1 denied: %2").arg(batchId).arg(reason));
+    
+    emit authorizationDenied(reason);
+}
+
+void EngagementManager::onBatchTimeout(const QString& batchId) {
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) return;
+    const QStringList engagementIds = it->engagementIds;
+    m_batches.erase(it);
+    m_batchTimers.remove(batchId);
+    
+    Logger::instance().warning("EngagementManager", "Authorization timeout for batch " + batchId);
+    
+    for (const QString& engagementId : engagementIds) {
+        const int slot = slotOf(engagementId);
+        if (slot >= 0) {
+            finishSlot(slot, EngagementState::Aborted);
+        }
+    }
+    
+    emit batchAuthorizationTimeout(batchId);
+}
+
+QStringList EngagementManager::engageAssignments(const QString& operatorId) {
+    QStringList started;
+    const QVector<WeaponAssignment> plan = m_assigner.lastPlan();
+    for (const WeaponAssignment& assignment : plan) {
+        if (assignment.committed) continue;
+        const QString engagementId = engageAssignment(assignment, operatorId);
+        if (!engagementId.isEmpty()) {
+            started.append(engagementId);
+        }
+    }
+    
+    if (m_batchAssignment && !started.isEmpty()) {
+        updateAssignments();
+    }
+    return started;
+}
+
+QString EngagementManager::engageAssignment(const WeaponAssignment& assignment,
+                                            const QString& operatorId) {
+    const int slot = createSlot(assignment);
+    if (slot < 0) return QString();
+    
+    const QString engagementId = m_slots[slot].record.engagementId;
+    authorizeSlot(slot, operatorId);
+    executeSlot(slot);
+    return m_slots[slot].used && m_slots[slot].record.engagementId == engagementId
+        ? engagementId : QString();
+}
+
+void EngagementManager::abortEngagement(const QString& engagementId, const QString& reason) {
+    if (engagementId == m_currentEngagementId) {
+        abort(reason);
+        return;
+    }
+    
+    const int slot = slotOf(engagementId);
+    if (slot < 0) return;
+    
+    EngagementSlot& s = m_slots[slot];
+    EffectorInterface* eff = s.record.state == EngagementState::Engaging
+        ? effector(s.record.effectorId) : nullptr;
+    s.record.wasAborted = true;
+    s.record.abortReason = reason;
+    finishSlot(slot, EngagementState::Aborted);
+    
+    // Once the slot is gone, so the effector's completion does not complete it
+    if (eff) {
+        eff->disengage();
+    }
+    
+    Logger::instance().info("EngagementManager",
+                           QString("Engagement %1 aborted: %2")
+                               .arg(engagementId)
+                               .arg(reason));
+    
+    emit engagementAborted(engagementId, reason);
+}
+
+QList<EngagementRecord> EngagementManager::activeEngagements() const {
+    QList<EngagementRecord> records;
+    for (const EngagementSlot& s : m_slots) {
+        if (s.used) {
+            records.append(s.record);
+        }
+    }
+    return records;
+}
+
+QList<EngagementRecord> EngagementManager::inFlightEngagements() const {
+    QList<EngagementRecord> records = activeEngagements();
+    switch (m_currentState) {
+    case EngagementState::Idle:
+    case EngagementState::Completed:
+    case EngagementState::Aborted:
+    case EngagementState::Failed:
+        break;
+    default:
+        if (!m_currentEngagementId.isEmpty()) records.append(m_currentRecord);
+        break;
+    }
+    return records;
+}
+
+void EngagementManager::restoreInterruptedEngagements(const QList<EngagementRecord>& records) {
+    for (EngagementRecord record : records) {
+        // New ids continue after the restored ones
+        const int number = record.engagementId.section('-', -1).toInt();
+        m_nextEngagementNumber = qMax(m_nextEngagementNumber, number + 1);
+        
+        record.state = EngagementState::Aborted;
+        record.wasAborted = true;
+        record.abortReason = "C2 restarted during engagement";
+        record.completionTime = clock()->nowUtc();
+        updateStatistics(record);
+        m_history.append(record);
+        
+        if (record.executionTime.isValid()) {
+            if (Track* track = m_trackManager->track(record.trackId)) {
+                track->setEngaged(false);
+            }
+        }
+        Logger::instance().warning("EngagementManager",
+            QString("Engagement %1 on %2 was interrupted by a restart")
+                .arg(record.engagementId, record.trackId));
+        emit engagementAborted(record.engagementId, record.abortReason);
+    }
+}
+
+EngagementState EngagementManager::engagementState(const QString& engagementId) const {
+    if (!engagementId.isEmpty() && engagementId == m_currentEngagementId) {
+        return m_currentState;
+    }
+    const int slot = slotOf(engagementId);
+    if (slot >= 0) {
+        return m_slots[slot].record.state;
+    }
+    for (const auto& record : m_history) {
+        if (record.engagementId == engagementId) {
+            return record.state;
+        }
+    }
+    return EngagementState::Idle;
+}
+
+const Clock* EngagementManager::clock() const {
+    if (m_clock) return m_clock;
+    return m_trackManager ? m_trackManager->clock() : Clock::system();
+}
+
+int EngagementManager::createSlot(const WeaponAssignment& assignment) {
+    if (!m_trackManager) return -1;
+    
+    Track* track = m_trackManager->track(assignment.trackId);
+    EffectorInterface* eff = effector(assignment.effectorId);
+    if (!track || !eff || !eff->isReady() || track->isEngaged() ||
+        m_assigner.committed().contains(assignment.trackId)) {
+        Logger::instance().warning("EngagementManager",
+                                  QString("Cannot engage %1 with %2")
+                                      .arg(assignment.trackId)
+                                      .arg(assignment.effectorId));
+        return -1;
+    }
+    if (m_freeSlots.isEmpty()) {
+        Logger::instance().warning("EngagementManager",
+                                  QString("All %1 engagement slots in use").arg(m_slots.size()));
+        return -1;
+    }
+    
+    const int slot = m_freeSlots.takeLast();
+    EngagementSlot& s = m_slots[slot];
+    s.generation++;
+    s.used = true;
+    s.batchId.clear();
+    s.completionCallback = 0;
+    
+    s.record = EngagementRecord();
+    s.record.engagementId = generateEngagementId();
+    s.record.trackId = assignment.trackId;
+    s.record.effectorId = assignment.effectorId;
+    s.record.effectorType = eff->effectorType();
+    s.record.startTime = clock()->nowUtc();
+    s.record.targetPosition = track->position();
+    s.record.targetDistance = CoordinateUtils::haversineDistance(eff->position(), track->position());
+    s.record.threatLevel = track->threatLevel();
+    s.record.notes = QString("Batch assignment, score %1, Pk %2")
+                         .arg(assignment.score, 0, 'f', 2)
+                         .arg(assignment.pk, 0, 'f', 2);
+    
+    s.request = AuthorizationRequest();
+    s.request.engagementId = s.record.engagementId;
+    s.request.trackId = assignment.trackId;
+    s.request.effectorId = assignment.effectorId;
+    s.request.effectorType = s.record.effectorType;
+    s.request.targetPosition = track->position();
+    s.request.distance = s.record.targetDistance;
+    s.request.threatLevel = track->threatLevel();
+    s.request.classification = track->classification();
+    s.request.recommendationReason = QString("Assigned %1 at Pk %2, in envelope in %3 s")
+                                         .arg(assignment.effectorId)
+                                         .arg(assignment.pk, 0, 'f', 2)
+                                         .arg(assignment.timeToInterceptSec, 0, 'f', 0);
+    if (m_threatAssessor) {
+        s.request.timeToImpactSec =
+            m_threatAssessor->closestApproach(assignment.trackId).timeToImpactSec;
+    }
+    
+    m_slotByEngagement.insert(s.record.engagementId, slot);
+    m_assigner.commit(assignment.trackId, assignment.effectorId);
+    return slot;
+}
+
+int EngagementManager::slotOf(const QString& engagementId) const {
+    return m_slotByEngagement.value(engagementId, -1);
+}
+
+void EngagementManager::transitionSlot(int slot, EngagementState newState) {
+    EngagementRecord& record = m_slots[slot].record;
+    if (record.state != newState) {
+        record.state = newState;
+        emit engagementStateChanged(record.engagementId, newState);
+    }
+}
+
+void EngagementManager::authorizeSlot(int slot, const QString& operatorId) {
+    EngagementRecord& record = m_slots[slot].record;
+    record.operatorId = operatorId;
+    record.authorizationTime = clock()->nowUtc();
+    transitionSlot(slot, EngagementState::Authorized);
+}
+
+void EngagementManager::executeSlot(int slot) {
+    EngagementSlot& s = m_slots[slot];
+    const QString engagementId = s.record.engagementId;
+    EffectorInterface* eff = effector(s.record.effectorId);
+    Track* track = m_trackManager->track(s.record.trackId);
+    
+    if (!eff || !track || !eff->isReady()) {
+        finishSlot(slot, EngagementState::Failed);
+        emit engagementFailed(engagementId, !eff || !track ? "Effector or track unavailable"
+                                                           : "Effector not ready");
+        return;
+    }
+    
+    s.record.executionTime = clock()->nowUtc();
+    track->setEngaged(true);
+    if (!engageTrack(eff, track)) {
+        finishSlot(slot, EngagementState::Failed);
+        emit engagementFailed(engagementId, "Effector engagement failed");
+        return;
+    }
+    
+    // engage() may have re-entered through statusChanged; the slot is still ours
+    transitionSlot(slot, EngagementState::Engaging);
+    const quint32 generation = s.generation;
+    s.completionCallback = eff->addCompletionCallback(this, [this, slot, generation](bool) {
+        if (slot >= m_slots.size()) return;
+        EngagementSlot& done = m_slots[slot];
+        if (!done.used || done.generation != generation) return;
+        done.completionCallback = 0;
+        completeSlot(slot);
+    });
+    
+    Logger::instance().info("EngagementManager",
+                           QString("Engagement %1 executing: %2 on %3")
+                               .arg(engagementId)
+                               .arg(s.record.effectorId)
+                               .arg(s.record.trackId));
+    
+    emit engagementStarted(engagementId);
+}
+
+void EngagementManager::checkSlotCompletion(int slot) {
+    EngagementSlot& s = m_slots[slot];
+    if (!s.used || s.record.state != EngagementState::Engaging) return;
+    
+    const QString engagementId = s.record.engagementId;
+    EffectorInterface* eff = effector(s.record.effectorId);
+    if (!eff) {
+        finishSlot(slot, EngagementState::Failed);
+        emit engagementFailed(engagementId, "Effector lost");
+        return;
+    }
+    if (!eff->isEngaged()) {
+        completeSlot(slot);
+    }
+}
+
+void EngagementManager::completeSlot(int slot) {
+    EngagementSlot& s = m_slots[slot];
+    if (!s.used || s.record.state != EngagementState::Engaging) return;
+    
+    const QString engagementId = s.record.engagementId;
+    s.record.completionTime = clock()->nowUtc();
+    Track* track = m_trackManager->track(s.record.trackId);
+    if ((!track || track->state() == TrackState::Dropped) &&
+        s.record.bdaResult == BDAResult::Unknown) {
+        s.record.bdaResult = BDAResult::AssessmentPending;
+    }
+    const BDAResult result = s.record.bdaResult;
+    finishSlot(slot, EngagementState::Completed);
+    
+    Logger::instance().info("EngagementManager",
+                           QString("Engagement %1 completed").arg(engagementId));
+    
+    emit engagementCompleted(engagementId, result);
+}
+
+void EngagementManager::finishSlot(int slot, EngagementState finalState) {
+    EngagementSlot& s = m_slots[slot];
+    if (!s.used) return;
+    
+    transitionSlot(slot, finalState);
+    cancelCompletion(s.record.effectorId, s.completionCallback);
+    
+    updateStatistics(s.record);
+    m_history.append(s.record);
+    
+    // Only an executed engagement marked the track
+    if (s.record.executionTime.isValid()) {
+        if (Track* track = m_trackManager->track(s.record.trackId)) {
+            track->setEngaged(false);
+        }
+    }
+    m_assigner.release(s.record.trackId);
+    m_slotByEngagement.remove(s.record.engagementId);
+    
+    // Aborted on its own while its batch waits
+    auto batch = m_batches.find(s.batchId);
+    if (batch != m_batches.end()) {
+        const int index = batch->engagementIds.indexOf(s.record.engagementId);
+        if (index >= 0) {
+            batch->engagementIds.removeAt(index);
+            batch->requests.removeAt(index);
+        }
+        if (batch->engagementIds.isEmpty()) {
+            TimerWheel::TimerId timer = m_batchTimers.take(s.batchId);
+            cancelTimer(timer);
+            m_batches.erase(batch);
+        }
+    }
+    
+    s.used = false;
+    s.record = EngagementRecord();
+    s.request = AuthorizationRequest();
+    m_freeSlots.append(slot);
+}
+
+quint64 EngagementManager::timerKey(TimerKind kind, quint32 index, quint32 generation) {
+    // kind:8 | generation:24 | index:32
+    return (static_cast<quint64>(kind) << 56) |
+           (static_cast<quint64>(generation & 0xFFFFFF) << 32) |
+           index;
+}
+
+TimerWheel::TimerId EngagementManager::scheduleTimer(qint64 delayMs, quint64 key) {
+    const TimerWheel::TimerId id = m_timers.schedule(clock()->nowMs() + delayMs, key);
+    if (!m_wheelTimer->isActive()) {
+        m_wheelTimer->start();
+    }
+    return id;
+}
+
+void EngagementManager::cancelTimer(TimerWheel::TimerId& id) {
+    if (id) {
+        m_timers.cancel(id);
+        id = 0;
+    }
+}
+
+void EngagementManager::onTimerTick() {
+    QVector<quint64> expired;
+    m_timers.advance(clock()->nowMs(), expired);
+    for (quint64 key : qAsConst(expired)) {
+        dispatchTimer(key);
+    }
+    if (m_timers.pendingCount() == 0) {
+        m_wheelTimer->stop();
+    }
+}
+
+void EngagementManager::dispatchTimer(quint64 key) {
+    const auto kind = static_cast<TimerKind>(key >> 56);
+    const quint32 index = static_cast<quint32>(key & 0xFFFFFFFF);
+    
+    switch (kind) {
+        case TimerKind::CurrentAuthorization:
+            m_authorizationTimer = 0;
+            onAuthorizationTimeout();
+            break;
+            
+        case TimerKind::BatchTimeout:
+            onBatchTimeout(QString("BAT-%1").arg(index, 6, 10, QChar('0')));
+            break;
+            
+        case TimerKind::SpectrumExpiry:
+            m_spectrumExpiryTimer = 0;
+            if (m_spectrum.expire(clock()->nowMs() - EMISSION_TIMEOUT_MS) > 0 && m_spectrumPlanning) {
+                updateSpectrumPlan();
+            }
+            if (m_spectrum.emissionCount() > 0) {
+                m_spectrumExpiryTimer = scheduleTimer(EMISSION_TIMEOUT_MS / 5, key);
+            }
+            break;
+    }
+}
+
 void EngagementManager::selectTrack(const QString& trackId) {
     if (!m_trackManager) return;
     
@@ -201,13 +955,19 @@ void EngagementManager::requestAuthorization() {
                                                 .arg(eff->effectorId())
                                                 .arg(track->classificationString())
                                                 .arg(track->threatLevel());
+    if (m_threatAssessor) {
+        m_currentAuthRequest.timeToImpactSec =
+            m_threatAssessor->closestApproach(m_selectedTrackId).timeToImpactSec;
+    }
     m_currentAuthRequest.requestTime = QDateTime::currentDateTimeUtc();
     m_currentAuthRequest.timeoutSeconds = m_authTimeoutSeconds;
     
     transitionTo(EngagementState::AwaitingAuthorization);
     
     // Start authorization timeout
-    m_authorizationTimer->start(m_authTimeoutSeconds * 1000);
+    cancelTimer(m_authorizationTimer);
+    m_authorizationTimer = scheduleTimer(m_authTimeoutSeconds * 1000LL,
+                                         timerKey(TimerKind::CurrentAuthorization, 0));
     
     Logger::instance().info("EngagementManager",
                            QString("Authorization requested for engagement %1")
@@ -223,7 +983,7 @@ void EngagementManager::authorize(const QString& operatorId) {
         return;
     }
     
-    m_authorizationTimer->stop();
+    cancelTimer(m_authorizationTimer);
     
     m_currentRecord.operatorId = operatorId;
     m_currentRecord.authorizationTime = QDateTime::currentDateTimeUtc();
@@ -241,7 +1001,7 @@ void EngagementManager::authorize(const QString& operatorId) {
 void EngagementManager::deny(const QString& reason) {
     if (m_currentState != EngagementState::AwaitingAuthorization) return;
     
-    m_authorizationTimer->stop();
+    cancelTimer(m_authorizationTimer);
     
     m_currentRecord.notes = "Denied: " + reason;
     
@@ -284,11 +1044,17 @@ void EngagementManager::execute() {
     m_currentRecord.executionTime = QDateTime::currentDateTimeUtc();
     track->setEngaged(true);
     
-    bool success = eff->engage(track->position());
+    bool success = engageTrack(eff, track);
     
     if (success) {
         transitionTo(EngagementState::Engaging);
-        m_completionCheckTimer->start();
+        cancelCompletion(m_selectedEffectorId, m_completionCallback);
+        const QString engagementId = m_currentEngagementId;
+        m_completionCallback = eff->addCompletionCallback(this, [this, engagementId](bool) {
+            if (engagementId != m_currentEngagementId) return;
+            m_completionCallback = 0;
+            completeEngagement();
+        });
         
         Logger::instance().info("EngagementManager",
                                QString("Engagement %1 executing")
@@ -310,16 +1076,11 @@ void EngagementManager::abort(const QString& reason) {
         return;
     }
     
-    m_authorizationTimer->stop();
-    m_completionCheckTimer->stop();
+    cancelTimer(m_authorizationTimer);
     
-    // Disengage effector if currently engaging
-    if (m_currentState == EngagementState::Engaging) {
-        EffectorInterface* eff = effector(m_selectedEffectorId);
-        if (eff) {
-            eff->disengage();
-        }
-    }
+    EffectorInterface* eff = m_currentState == EngagementState::Engaging
+        ? effector(m_selectedEffectorId) : nullptr;
+    const QString engagementId = m_currentEngagementId;
     
     m_currentRecord.wasAborted = true;
     m_currentRecord.abortReason = reason;
@@ -327,12 +1088,17 @@ void EngagementManager::abort(const QString& reason) {
     transitionTo(EngagementState::Aborted);
     finalizeEngagement(EngagementState::Aborted);
     
+    // Disengage once aborted, so the effector's completion does not complete it
+    if (eff) {
+        eff->disengage();
+    }
+    
     Logger::instance().info("EngagementManager",
                            QString("Engagement %1 aborted: %2")
-                               .arg(m_currentEngagementId)
+                               .arg(engagementId)
                                .arg(reason));
     
-    emit engagementAborted(m_currentEngagementId, reason);
+    emit engagementAborted(engagementId, reason);
 }
 
 void EngagementManager::setBDAResult(BDAResult result) {
@@ -347,8 +1113,11 @@ void EngagementManager::addNote(const QString& note) {
 }
 
 void EngagementManager::setVideoSnapshot(const QImage& snapshot) {
-    m_currentRecord.videoSnapshot = snapshot;
-    m_currentAuthRequest.videoThumbnail = snapshot.scaled(160, 120, Qt::KeepAspectRatio);
+    // Stored before the old one is released, in case it is the same frame
+    const QString snapshotId = m_snapshots.store(snapshot);
+    m_snapshots.release(m_currentRecord.snapshotId);
+    m_currentRecord.snapshotId = snapshotId;
+    m_currentAuthRequest.snapshotId = snapshotId;
 }
 
 EngagementRecord* EngagementManager::currentEngagement() {
@@ -356,7 +1125,17 @@ EngagementRecord* EngagementManager::currentEngagement() {
     return &m_currentRecord;
 }
 
+QList<EngagementRecord> EngagementManager::engagementHistory(int offset, int limit) const {
+    offset = qMax(0, offset);
+    if (limit <= 0 || offset >= m_history.size()) return {};
+    return m_history.mid(offset, limit);
+}
+
 EngagementRecord* EngagementManager::engagement(const QString& engagementId) {
+    const int slot = slotOf(engagementId);
+    if (slot >= 0) {
+        return &m_slots[slot].record;
+    }
     for (auto& record : m_history) {
         if (record.engagementId == engagementId) {
             return &record;
@@ -365,16 +1144,51 @@ EngagementRecord* EngagementManager::engagement(const QString& engagementId) {
     return nullptr;
 }
 
+void EngagementManager::onEffectorEvent(const EffectorEvent& event) {
+    emit effectorEvent(event);
+    
+    // Completion itself comes through the callbacks
+    if (event.type == EffectorEventType::StatusChanged) {
+        onEffectorStatusChanged(event.effectorId);
+    }
+}
+
 void EngagementManager::onEffectorStatusChanged(const QString& effectorId) {
+    // Offline or faulted mid-engagement, without completing it
     if (effectorId == m_selectedEffectorId) {
-        EffectorInterface* eff = effector(effectorId);
-        if (eff && !eff->isReady() && m_currentState == EngagementState::Engaging) {
-            checkEngagementCompletion();
+        checkEngagementCompletion();
+    }
+    
+    for (int i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].used && m_slots[i].record.effectorId == effectorId) {
+            checkSlotCompletion(i);
         }
     }
+    
+    // A freed or lost effector changes the plan
+    if (m_batchAssignment) {
+        updateAssignments();
+    }
 }
 
 void EngagementManager::onTrackDropped(const QString& trackId) {
+    for (int i = 0; i < m_slots.size(); ++i) {
+        EngagementSlot& s = m_slots[i];
+        if (!s.used || s.record.trackId != trackId) continue;
+        if (s.record.state == EngagementState::Engaging) {
+            // Possible success; completes when the effector finishes its cycle
+            if (s.record.bdaResult == BDAResult::Unknown) {
+                s.record.bdaResult = BDAResult::AssessmentPending;
+            }
+        } else {
+            const QString engagementId = s.record.engagementId;
+            s.record.wasAborted = true;
+            s.record.abortReason = "Target track dropped";
+            finishSlot(i, EngagementState::Aborted);
+            emit engagementAborted(engagementId, "Target track dropped");
+        }
+    }
+    
     if (trackId == m_selectedTrackId) {
         if (m_currentState == EngagementState::Engaging) {
             // Track dropped while engaging - possible success
@@ -401,10 +1215,7 @@ void EngagementManager::onAuthorizationTimeout() {
 }
 
 void EngagementManager::checkEngagementCompletion() {
-    if (m_currentState != EngagementState::Engaging) {
-        m_completionCheckTimer->stop();
-        return;
-    }
+    if (m_currentState != EngagementState::Engaging) return;
     
     EffectorInterface* eff = effector(m_selectedEffectorId);
     if (!eff) {
@@ -416,26 +1227,41 @@ void EngagementManager::checkEngagementCompletion() {
     
     // Check if effector has completed its cycle
     if (!eff->isEngaged()) {
-        m_completionCheckTimer->stop();
-        
-        transitionTo(EngagementState::Completed);
-        m_currentRecord.completionTime = QDateTime::currentDateTimeUtc();
-        
-        // Check track status for BDA
-        Track* track = m_trackManager->track(m_selectedTrackId);
-        if (!track || track->state() == TrackState::Dropped) {
-            if (m_currentRecord.bdaResult == BDAResult::Unknown) {
-                m_currentRecord.bdaResult = BDAResult::AssessmentPending;
-            }
+        completeEngagement();
+    }
+}
+
+void EngagementManager::completeEngagement() {
+    if (m_currentState != EngagementState::Engaging) return;
+    
+    transitionTo(EngagementState::Completed);
+    m_currentRecord.completionTime = QDateTime::currentDateTimeUtc();
+    
+    // Check track status for BDA
+    Track* track = m_trackManager->track(m_selectedTrackId);
+    if (!track || track->state() == TrackState::Dropped) {
+        if (m_currentRecord.bdaResult == BDAResult::Unknown) {
+            m_currentRecord.bdaResult = BDAResult::AssessmentPending;
         }
-        
-        finalizeEngagement(EngagementState::Completed);
-        
-        Logger::instance().info("EngagementManager",
-                               QString("Engagement %1 completed")
-                                   .arg(m_currentEngagementId));
-        
-        emit engagementCompleted(m_currentEngagementId, m_currentRecord.bdaResult);
+    }
+    
+    // finalizeEngagement() clears the id
+    const QString engagementId = m_currentEngagementId;
+    finalizeEngagement(EngagementState::Completed);
+    
+    Logger::instance().info("EngagementManager",
+                           QString("Engagement %1 completed")
+                               .arg(engagementId));
+    
+    emit engagementCompleted(engagementId, m_currentRecord.bdaResult);
+}
+
+void EngagementManager::cancelCompletion(const QString& effectorId, quint64& callbackId) {
+    if (callbackId) {
+        if (EffectorInterface* eff = effector(effectorId)) {
+            eff->removeCompletionCallback(callbackId);
+        }
+        callbackId = 0;
     }
 }
 
@@ -460,6 +1286,14 @@ void EngagementManager::recommendEffector() {
         Track* track = m_trackManager->track(m_selectedTrackId);
         QString reason = QString("Recommended based on target range and %1 capability")
                              .arg(best->effectorType());
+        if (m_threatAssessor) {
+            const ClosestApproach approach = m_threatAssessor->closestApproach(m_selectedTrackId);
+            if (approach.timeToImpactSec >= 0) {
+                reason += QString("; predicted inside %1 in %2 s")
+                              .arg(m_threatAssessor->defendedAssets().value(approach.asset).id)
+                              .arg(approach.timeToImpactSec, 0, 'f', 0);
+            }
+        }
         
         transitionTo(EngagementState::EffectorRecommended);
         emit effectorRecommended(best->effectorId(), reason);
@@ -472,6 +1306,7 @@ void EngagementManager::createEngagementRecord() {
     Track* track = m_trackManager->track(m_selectedTrackId);
     EffectorInterface* eff = effector(m_selectedEffectorId);
     
+    m_snapshots.release(m_currentRecord.snapshotId);
     m_currentRecord = EngagementRecord();
     m_currentRecord.engagementId = m_currentEngagementId;
     m_currentRecord.trackId = m_selectedTrackId;
@@ -490,42 +1325,65 @@ void EngagementManager::createEngagementRecord() {
 
 void EngagementManager::finalizeEngagement(EngagementState finalState) {
     m_currentRecord.state = finalState;
+    cancelCompletion(m_selectedEffectorId, m_completionCallback);
+    
+    updateStatistics(m_currentRecord);
+    
+    // Add to history; its snapshot reference goes with it
+    m_history.append(m_currentRecord);
+    m_currentRecord.snapshotId.clear();
+    m_currentAuthRequest.snapshotId.clear();
     
-    // Update statistics
+    // Clear current engagement state
+    Track* track = m_trackManager->track(m_selectedTrackId);
+    if (track) {
+        track->setEngaged(false);
+    }
+    
+    m_selectedTrackId.clear();
+    m_selectedEffectorId.clear();
+    m_currentEngagementId.clear();
+}
+
+void EngagementManager::updateStatistics(const EngagementRecord& record) {
     m_stats.totalEngagements++;
-    switch (finalState) {
+    switch (record.state) {
         case EngagementState::Completed:
             m_stats.successfulEngagements++;
+            m_completedMetric->add();
             break;
         case EngagementState::Aborted:
             m_stats.abortedEngagements++;
+            m_abortedMetric->add();
             break;
         case EngagementState::Failed:
             m_stats.failedEngagements++;
+            m_failedMetric->add();
             break;
         default:
             break;
     }
     
     // Calculate average engagement time
-    if (m_currentRecord.completionTime.isValid()) {
-        qint64 duration = m_currentRecord.startTime.msecsTo(m_currentRecord.completionTime);
+    if (record.completionTime.isValid()) {
+        qint64 duration = record.startTime.msecsTo(record.completionTime);
         double total = m_stats.avgEngagementTimeMs * (m_stats.totalEngagements - 1) + duration;
         m_stats.avgEngagementTimeMs = total / m_stats.totalEngagements;
+        m_durationMetric->record(duration * 1000);
     }
-    
-    // Add to history
-    m_history.append(m_currentRecord);
-    
-    // Clear current engagement state
-    Track* track = m_trackManager->track(m_selectedTrackId);
-    if (track) {
-        track->setEngaged(false);
+}
+
+bool EngagementManager::engageTrack(EffectorInterface* eff, Track* track) {
+    // Interceptors lead the target; everything else points at it
+    if (auto* kinetic = qobject_cast<KineticInterceptor*>(eff)) {
+        const InterceptSolution intercept = kinetic->solveIntercept(
+            InterceptSolver::target(track->trackId(), track->position(), track->velocity(),
+                                    track->trackQuality()));
+        if (intercept.feasible) {
+            return kinetic->engageIntercept(intercept);
+        }
     }
-    
-    m_selectedTrackId.clear();
-    m_selectedEffectorId.clear();
-    m_currentEngagementId.clear();
+    return eff->engage(track->position());
 }
 
 double EngagementManager::calculateEffectorScore(EffectorInterface* effector, Track* track) {
@@ -536,23 +1394,15 @@ double EngagementManager::calculateEffectorScore(EffectorInterface* effector, Tr
     // Check if effector is ready
     if (!effector->isReady()) return 0.0;
     
-    // Check range
-    double distance = track->distanceTo(GeoPosition()); // TODO: use base position
-    double maxRange = effector->maxRange();
-    double minRange = effector->minRange();
-    
-    if (distance < minRange || distance > maxRange) {
-        return 0.0;  // Out of range
+    // Envelope lookup: Pk from the effector's position, 0 where it cannot engage
+    const EnvelopeCell cell = effector->envelope()->at(track->position());
+    if (!cell.feasible()) {
+        return 0.0;
     }
     
-    // Range score (prefer middle of engagement envelope)
-    double rangeCenter = (maxRange + minRange) / 2.0;
-    double rangeDiff = std::abs(distance - rangeCenter);
-    double rangeScore = 1.0 - (rangeDiff / (maxRange - minRange));
-    score += rangeScore * 0.4;
-    
-    // Effectiveness score
-    score += effector->effectiveness() * 0.3;
+    // Pk, then a little for a quick effect
+    score += cell.pk * 0.6;
+    score += 0.1 / (1.0 + cell.timeToEffectSec / 10.0);
     
     // Availability score (is it loaded/charged?)
     score += (effector->isReady() ? 0.2 : 0.0);
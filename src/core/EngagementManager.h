@@ -4,8 +4,14 @@
 #include <QObject>
 #include <QTimer>
 #include <QList>
+#include <QHash>
 #include <QImage>
 #include "core/Track.h"
+#include "core/SnapshotStore.h"
+#include "core/WeaponTargetAssigner.h"
+#include "effectors/EffectorInterface.h"
+#include "effectors/SpectrumPlanner.h"
+#include "utils/TimerWheel.h"
 
 // QStateMachine is optional - not used directly in the header
 // Include in implementation if needed
@@ -13,7 +19,11 @@
 namespace CounterUAS {
 
 class TrackManager;
-class EffectorInterface;
+class ThreatAssessor;
+class Clock;
+class JsonWriter;
+class MetricCounter;
+class LatencyHistogram;
 
 /**
  * @brief Engagement state enum
@@ -64,13 +74,14 @@ struct EngagementRecord {
     double targetDistance = 0.0;
     int threatLevel = 0;
     
-    QImage videoSnapshot;
+    QString snapshotId;                 // In the manager's SnapshotStore
     QString notes;
     
     bool wasAborted = false;
     QString abortReason;
     
     QJsonObject toJson() const;
+    void writeJson(JsonWriter& writer) const;      // toJson's document, without the tree
 };
 
 /**
@@ -86,9 +97,26 @@ struct AuthorizationRequest {
     double distance = 0.0;
     int threatLevel = 0;
     TrackClassification classification;
+    double timeToImpactSec = -1;        // From the threat assessor, -1 if unknown or not closing
     
     QString recommendationReason;
-    QImage videoThumbnail;
+    QString snapshotId;                 // Thumbnail from the manager's SnapshotStore
+    
+    QDateTime requestTime;
+    int timeoutSeconds = 60;
+};
+
+/**
+ * @brief One authorization covering several engagements under the same ROE
+ *
+ * Engagements are grouped by target classification and effector type, so
+ * the operator approves, say, every RF jamming of pending tracks at once.
+ */
+struct BatchAuthorizationRequest {
+    QString batchId;
+    QString roeGroup;                   // "<classification>/<effector type>"
+    QStringList engagementIds;
+    QVector<AuthorizationRequest> requests;
     
     QDateTime requestTime;
     int timeoutSeconds = 60;
@@ -96,6 +124,28 @@ struct AuthorizationRequest {
 
 /**
  * @brief Engagement workflow manager
+ *
+ * Runs one operator-driven engagement through the state machine (select
+ * track, recommend effector, authorize, execute): the "current" one.
+ * Alongside it, batch assignment pairs every hostile track with the
+ * effectors at once through WeaponTargetAssigner, re-solving whenever the
+ * threat assessor finishes a cycle or an effector changes state.
+ *
+ * Engagements started from the plan each run their own state machine in
+ * a slot of a fixed table, AwaitingAuthorization through Engaging to a
+ * final state, after which the slot is recycled and the record moves to
+ * the history. requestBatchAuthorization() groups them by ROE into batch
+ * requests; engageAssignments() is for a plan the operator has already
+ * authorized. Every authorization and batch timeout is an entry in one
+ * TimerWheel driven by a single QTimer that runs only while something is
+ * pending. Nothing is polled: an engagement completes from its effector's
+ * completion callback, and a fault or shutdown mid-engagement arrives on
+ * the effector's telemetry, which is passed on as effectorEvent().
+ *
+ * With spectrum planning on, RF emissions reported by the detectors are
+ * kept in a SpectrumPlanner and every registered RFJammer is retuned to
+ * the channel plan that covers the most of them; emissions not reported
+ * again within EMISSION_TIMEOUT_MS drop out of the plan.
  */
 class EngagementManager : public QObject {
     Q_OBJECT
@@ -109,7 +159,7 @@ public:
     // Effector registration
     void registerEffector(EffectorInterface* effector);
     void unregisterEffector(const QString& effectorId);
-    QList<EffectorInterface*> effectors() const { return m_effectors; }
+    QList<EffectorInterface*> effectors() const { return m_effectors; }     // In registration order
     EffectorInterface* effector(const QString& effectorId) const;
     EffectorInterface* recommendedEffector(const QString& trackId) const;
     
@@ -138,13 +188,60 @@ public:
     EngagementRecord* currentEngagement();
     AuthorizationRequest currentAuthRequest() const { return m_currentAuthRequest; }
     
-    // History
-    QList<EngagementRecord> engagementHistory() const { return m_history; }
+    // History, oldest first; a page at a time
+    int historySize() const { return m_history.size(); }
+    QList<EngagementRecord> engagementHistory(int offset, int limit) const;
     EngagementRecord* engagement(const QString& engagementId);
     
+    // Snapshots referenced by records and authorization requests
+    SnapshotStore* snapshots() { return &m_snapshots; }
+    const SnapshotStore* snapshots() const { return &m_snapshots; }
+    
     // Configuration
     void setAuthorizationTimeout(int seconds) { m_authTimeoutSeconds = seconds; }
     void setAutoRecommendEffector(bool enable) { m_autoRecommend = enable; }
+    void setThreatAssessor(ThreatAssessor* assessor);
+    
+    // Batch weapon-target assignment
+    void setBatchAssignmentEnabled(bool enable);
+    bool batchAssignmentEnabled() const { return m_batchAssignment; }
+    void setAssignmentRules(const AssignmentRules& rules) { m_assigner.setRules(rules); }
+    AssignmentRules assignmentRules() const { return m_assigner.rules(); }
+    QVector<WeaponAssignment> updateAssignments();
+    QVector<WeaponAssignment> currentAssignments() const { return m_assigner.lastPlan(); }
+    WeaponTargetAssigner::Stats assignmentStats() const { return m_assigner.stats(); }
+    
+    // Concurrent engagements, each in its own slot
+    void setEngagementSlots(int slots);
+    int engagementSlots() const { return m_slots.size(); }
+    QStringList requestBatchAuthorization(const QVector<WeaponAssignment>& assignments);
+    void authorizeBatch(const QString& batchId, const QString& operatorId);
+    void denyBatch(const QString& batchId, const QString& reason);
+    QList<BatchAuthorizationRequest> pendingBatches() const { return m_batches.values(); }
+    // Authorized by the caller: straight to execution
+    QStringList engageAssignments(const QString& operatorId);
+    QString engageAssignment(const WeaponAssignment& assignment, const QString& operatorId);
+    void abortEngagement(const QString& engagementId, const QString& reason);
+    QList<EngagementRecord> activeEngagements() const;
+    // The slots' engagements plus the operator's current one while unfinished
+    QList<EngagementRecord> inFlightEngagements() const;
+    // Engagements in flight when a previous run stopped (from a checkpoint).
+    // They are recorded as aborted and never resumed: only the effector
+    // knows whether it fired, and the operator re-engages on fresh state.
+    void restoreInterruptedEngagements(const QList<EngagementRecord>& records);
+    EngagementState engagementState(const QString& engagementId) const;
+    
+    // RF jamming channel plan across the registered jammers
+    void setSpectrumPlanningEnabled(bool enable);
+    bool spectrumPlanningEnabled() const { return m_spectrumPlanning; }
+    void reportEmission(const JamEmission& emission);
+    void removeEmission(const QString& emissionId);
+    QVector<JammerPlan> updateSpectrumPlan();
+    const SpectrumPlanner& spectrumPlanner() const { return m_spectrum; }
+    
+    // Timeouts run on this clock; the track manager's unless set
+    void setClock(const Clock* clock) { m_clock = clock; }
+    const Clock* clock() const;
     
     // Statistics
     struct Statistics {
@@ -171,14 +268,22 @@ signals:
     void engagementAborted(const QString& engagementId, const QString& reason);
     void engagementFailed(const QString& engagementId, const QString& reason);
     void switchVideoFeed(const QString& cameraId);
+    void assignmentsUpdated(const QVector<WeaponAssignment>& plan);
+    void engagementStateChanged(const QString& engagementId, EngagementState state);
+    void batchAuthorizationRequested(const BatchAuthorizationRequest& request);
+    void batchAuthorizationTimeout(const QString& batchId);
+    void spectrumPlanUpdated(const QVector<JammerPlan>& plans);
+    // Telemetry from every registered effector, as it happens
+    void effectorEvent(const EffectorEvent& event);
     
 public slots:
     void onEffectorStatusChanged(const QString& effectorId);
     void onTrackDropped(const QString& trackId);
     
 private slots:
+    void onEffectorEvent(const EffectorEvent& event);
     void onAuthorizationTimeout();
-    void checkEngagementCompletion();
+    void onTimerTick();
     
 private:
     void transitionTo(EngagementState newState);
@@ -186,10 +291,52 @@ private:
     void recommendEffector();
     void createEngagementRecord();
     void finalizeEngagement(EngagementState finalState);
+    // Completes once the effector is no longer engaged, fails if it is gone
+    void checkEngagementCompletion();
+    void completeEngagement();
+    // Completion callbacks registered on effectors, cancelled like timers
+    void cancelCompletion(const QString& effectorId, quint64& callbackId);
     double calculateEffectorScore(EffectorInterface* effector, Track* track);
+    bool engageTrack(EffectorInterface* effector, Track* track);
+    void updateStatistics(const EngagementRecord& record);
+    
+    static constexpr int DEFAULT_ENGAGEMENT_SLOTS = 64;
+    static constexpr qint64 EMISSION_TIMEOUT_MS = 5000;
+    
+    // Timer wheel keys: what fired, and for which slot or batch
+    enum class TimerKind : quint64 {
+        CurrentAuthorization = 1,
+        BatchTimeout,
+        SpectrumExpiry
+    };
+    static quint64 timerKey(TimerKind kind, quint32 index, quint32 generation = 0);
+    TimerWheel::TimerId scheduleTimer(qint64 delayMs, quint64 key);
+    void cancelTimer(TimerWheel::TimerId& id);
+    void dispatchTimer(quint64 key);
+    
+    // Slot table
+    struct EngagementSlot {
+        EngagementRecord record;
+        AuthorizationRequest request;
+        QString batchId;
+        quint64 completionCallback = 0;
+        quint32 generation = 0;         // Bumped on reuse; stale callbacks don't match
+        bool used = false;
+    };
+    int createSlot(const WeaponAssignment& assignment);
+    int slotOf(const QString& engagementId) const;
+    void transitionSlot(int slot, EngagementState newState);
+    void authorizeSlot(int slot, const QString& operatorId);
+    void executeSlot(int slot);
+    void checkSlotCompletion(int slot);
+    void completeSlot(int slot);
+    void finishSlot(int slot, EngagementState finalState);
+    void onBatchTimeout(const QString& batchId);
     
     TrackManager* m_trackManager;
+    ThreatAssessor* m_threatAssessor = nullptr;
     QList<EffectorInterface*> m_effectors;
+    QHash<QString, EffectorInterface*> m_effectorById;
     
     EngagementState m_currentState = EngagementState::Idle;
     QString m_currentEngagementId;
@@ -199,19 +346,49 @@ private:
     EngagementRecord m_currentRecord;
     AuthorizationRequest m_currentAuthRequest;
     QList<EngagementRecord> m_history;
+    SnapshotStore m_snapshots;
+    quint64 m_memoryConsumer = 0;       // MemoryGovernor id for the snapshots
     
-    QTimer* m_authorizationTimer;
-    QTimer* m_completionCheckTimer;
+    // One timer for every timeout
+    const Clock* m_clock = nullptr;
+    TimerWheel m_timers;
+    QTimer* m_wheelTimer;
+    TimerWheel::TimerId m_authorizationTimer = 0;
+    quint64 m_completionCallback = 0;
     int m_authTimeoutSeconds = 60;
     bool m_autoRecommend = true;
     
     Statistics m_stats;
     int m_nextEngagementNumber = 1;
+    
+    // Fleet monitoring series by outcome, registered once in the constructor
+    MetricCounter* m_completedMetric = nullptr;
+    MetricCounter* m_abortedMetric = nullptr;
+    MetricCounter* m_failedMetric = nullptr;
+    LatencyHistogram* m_durationMetric = nullptr;
+    
+    // Batch assignment; concurrent engagements move to m_history when done
+    WeaponTargetAssigner m_assigner;
+    bool m_batchAssignment = false;
+    QVector<EngagementSlot> m_slots;
+    QVector<int> m_freeSlots;
+    QHash<QString, int> m_slotByEngagement;
+    QHash<QString, BatchAuthorizationRequest> m_batches;
+    QHash<QString, TimerWheel::TimerId> m_batchTimers;
+    int m_nextBatchNumber = 1;
+    
+    // Spectrum planning
+    SpectrumPlanner m_spectrum;
+    bool m_spectrumPlanning = false;
+    TimerWheel::TimerId m_spectrumExpiryTimer = 0;
 };
 
 } // namespace CounterUAS
 
 Q_DECLARE_METATYPE(CounterUAS::EngagementState)
 Q_DECLARE_METATYPE(CounterUAS::BDAResult)
+Q_DECLARE_METATYPE(CounterUAS::WeaponAssignment)
+Q_DECLARE_METATYPE(CounterUAS::BatchAuthorizationRequest)
+Q_DECLARE_METATYPE(CounterUAS::JammerPlan)
 
 #endif // ENGAGEMENTMANAGER_H
@@ -0,0 +1,266 @@
+#include "core/FusionEngine.h"
+#include "core/DetectionMerger.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+
+namespace CounterUAS {
+
+FusionEngine::FusionEngine(TrackManager* trackManager, QObject* parent)
+    : QObject(parent)
+    , m_trackManager(trackManager)
+    , m_drainContext(new QObject)
+    , m_mergeTimer(new QTimer(m_drainContext))
+{
+    m_queue.reset(new BoundedQueue<QueuedScan>(m_config.queueCapacity));
+    connect(m_mergeTimer, &QTimer::timeout, m_drainContext, [this]() { releaseMerged(false); });
+}
+
+FusionEngine::~FusionEngine() {
+    stop();
+    delete m_drainContext;
+}
+
+void FusionEngine::setConfig(const FusionEngineConfig& config) {
+    m_config = config;
+    if (!m_running) {
+        m_queue.reset(new BoundedQueue<QueuedScan>(qMax(2, m_config.queueCapacity)));
+    }
+}
+
+void FusionEngine::start() {
+    if (m_running || !m_trackManager) return;
+
+    m_threaded = m_config.threaded;
+    if (m_threaded && (m_trackManager->parent() ||
+                       m_trackManager->thread() != QThread::currentThread())) {
+        // QObject::moveToThread() cannot move an object away from its parent
+        Logger::instance().warning("FusionEngine",
+            "TrackManager must be unparented and owned by this thread to run threaded; "
+            "fusing on the calling thread");
+        m_threaded = false;
+    }
+
+    if (m_threaded) {
+        m_fusionThread = new QThread(this);
+        m_fusionThread->setObjectName("FusionThread");
+        m_ioThread = new QThread(this);
+        m_ioThread->setObjectName("SensorIoThread");
+        ThreadPlacement::instance().assign(m_fusionThread, ThreadRole::Fusion);
+        ThreadPlacement::instance().assign(m_ioThread, ThreadRole::SensorIO);
+
+        m_trackManager->moveToThread(m_fusionThread);
+        m_drainContext->moveToThread(m_fusionThread);
+
+        for (const auto& sensor : m_sensors) {
+            if (!sensor) continue;
+            if (sensor->parent() || sensor->thread() != QThread::currentThread()) {
+                Logger::instance().warning("FusionEngine",
+                    "Sensor " + sensor->sensorId() + " is parented; its I/O stays on its own thread");
+                continue;
+            }
+            sensor->moveToThread(m_ioThread);
+            m_movedSensors.append(sensor);
+        }
+
+        m_fusionThread->start();
+        m_ioThread->start();
+    }
+
+    if (m_config.reorderWindowMs > 0) {
+        m_merger.reset(new DetectionMerger(m_config.reorderWindowMs, m_config.laneCapacity));
+        const int interval = qMax(5, m_config.reorderWindowMs / 4);
+        // The timer lives with the drain context and must start on its thread
+        QMetaObject::invokeMethod(m_mergeTimer, [this, interval]() { m_mergeTimer->start(interval); },
+                                  m_threaded ? Qt::BlockingQueuedConnection : Qt::DirectConnection);
+    }
+
+    m_running = true;
+    Logger::instance().info("FusionEngine", m_threaded
+        ? QString("Started threaded, queue capacity %1 scans").arg(static_cast<int>(m_queue->capacity()))
+        : QString("Started on the calling thread"));
+}
+
+void FusionEngine::stop() {
+    if (!m_running) return;
+
+    if (m_threaded) {
+        QThread* home = thread();
+
+        for (const auto& sensor : m_movedSensors) {
+            if (!sensor) continue;
+            SensorInterface* s = sensor.data();
+            QMetaObject::invokeMethod(s, [s, home]() { s->moveToThread(home); },
+                                      Qt::BlockingQueuedConnection);
+        }
+        m_movedSensors.clear();
+
+        // Fuse whatever is still queued, then hand the manager back
+        QMetaObject::invokeMethod(m_drainContext, [this, home]() {
+            m_mergeTimer->stop();
+            releaseMerged(true);
+            drain(-1);
+            m_trackManager->moveToThread(home);
+            m_drainContext->moveToThread(home);
+        }, Qt::BlockingQueuedConnection);
+
+        m_ioThread->quit();
+        m_fusionThread->quit();
+        m_ioThread->wait();
+        m_fusionThread->wait();
+        delete m_ioThread;
+        delete m_fusionThread;
+        m_ioThread = nullptr;
+        m_fusionThread = nullptr;
+    } else {
+        m_mergeTimer->stop();
+        releaseMerged(true);
+    }
+    m_merger.reset();
+
+    m_running = false;
+    m_threaded = false;
+    m_drainScheduled.store(false);
+    Logger::instance().info("FusionEngine", "Stopped");
+}
+
+void FusionEngine::attachSensor(SensorInterface* sensor) {
+    if (!sensor || m_sensors.contains(sensor)) return;
+
+    m_sensors.append(sensor);
+    // Direct: submit() runs on the sensor's thread and only touches the queue
+    connect(sensor, &SensorInterface::detection, m_drainContext,
+            [this](const SensorDetection& detection) { submit(detection); },
+            Qt::DirectConnection);
+    connect(sensor, &SensorInterface::detectionBatch, m_drainContext,
+            [this](const QVector<SensorDetection>& detections) { submitBatch(detections); },
+            Qt::DirectConnection);
+}
+
+void FusionEngine::detachSensor(SensorInterface* sensor) {
+    if (!sensor) return;
+    m_sensors.removeAll(sensor);
+    QObject::disconnect(sensor, &SensorInterface::detection, m_drainContext, nullptr);
+    QObject::disconnect(sensor, &SensorInterface::detectionBatch, m_drainContext, nullptr);
+}
+
+bool FusionEngine::submit(const SensorDetection& detection) {
+    return submitBatch(QVector<SensorDetection>{detection});
+}
+
+bool FusionEngine::submitBatch(const QVector<SensorDetection>& detections) {
+    if (detections.isEmpty() || !m_trackManager) return true;
+    if (m_scanTap) {
+        m_scanTap(detections);
+    }
+
+    if (m_merger) {
+        // The merge timer fuses these once they are older than the window
+        bool accepted = true;
+        for (const SensorDetection& detection : detections) {
+            accepted = m_merger->push(detection) && accepted;
+        }
+        if (!accepted) {
+            emit scanDropped(detections.first().sensorId);
+        }
+        return accepted;
+    }
+
+    if (!m_threaded) {
+        m_trackManager->processDetectionBatch(detections);
+        QMutexLocker locker(&m_statsMutex);
+        ++m_scansProcessed;
+        return true;
+    }
+
+    QueuedScan scan;
+    scan.detections = detections;
+    scan.enqueuedNs = TimeUtils::monotonicNs();
+    if (!m_queue->tryPush(std::move(scan))) {
+        m_scansDropped.fetch_add(1, std::memory_order_relaxed);
+        emit scanDropped(detections.first().sensorId);
+        return false;
+    }
+
+    m_scansEnqueued.fetch_add(1, std::memory_order_relaxed);
+    scheduleDrain();
+    return true;
+}
+
+FusionEngine::Statistics FusionEngine::statistics() const {
+    Statistics stats;
+    stats.scansEnqueued = m_scansEnqueued.load(std::memory_order_relaxed);
+    stats.scansDropped = m_scansDropped.load(std::memory_order_relaxed);
+    stats.queueDepth = static_cast<int>(m_queue->sizeApprox());
+    {
+        QMutexLocker locker(&m_statsMutex);
+        stats.scansProcessed = m_scansProcessed;
+        stats.queueLatency = m_queueLatency;
+        stats.detectionsReordered = m_detectionsReordered;
+        stats.detectionsLate = m_detectionsLate;
+        stats.detectionsBuffered = m_detectionsBuffered;
+        stats.detectionsDropped = m_detectionsDropped;
+    }
+    if (m_trackManager) {
+        stats.ingestToUpdate = m_trackManager->statistics().ingestToUpdate;
+    }
+    return stats;
+}
+
+void FusionEngine::scheduleDrain() {
+    // One queued drain at a time, however many producers are pushing
+    if (m_drainScheduled.exchange(true, std::memory_order_acq_rel)) return;
+
+    const int maxScans = m_config.maxScansPerDrain;
+    QMetaObject::invokeMethod(m_drainContext, [this, maxScans]() { drain(maxScans); },
+                              Qt::QueuedConnection);
+}
+
+void FusionEngine::drain(int maxScans) {
+    // Cleared before popping so a push racing with the last pop reschedules
+    m_drainScheduled.store(false, std::memory_order_release);
+
+    QueuedScan scan;
+    int processed = 0;
+    while ((maxScans < 0 || processed < maxScans) && m_queue->tryPop(scan)) {
+        const qint64 waitedUs = (TimeUtils::monotonicNs() - scan.enqueuedNs) / 1000;
+        m_trackManager->processDetectionBatch(scan.detections);
+        ++processed;
+
+        QMutexLocker locker(&m_statsMutex);
+        m_queueLatency.record(waitedUs);
+        ++m_scansProcessed;
+    }
+
+    // Leave the rest for the next event loop pass so track cycles still run
+    if (m_queue->sizeApprox() > 0) {
+        scheduleDrain();
+    }
+}
+
+void FusionEngine::releaseMerged(bool flushAll) {
+    if (!m_merger) return;
+
+    const QVector<SensorDetection> batch =
+        m_merger->release(m_trackManager->clock()->nowMs(), flushAll);
+    if (!batch.isEmpty()) {
+        m_trackManager->processDetectionBatch(batch);
+    }
+
+    const DetectionMerger::Stats mergeStats = m_merger->stats();
+    QMutexLocker locker(&m_statsMutex);
+    if (!batch.isEmpty()) {
+        ++m_scansProcessed;
+    }
+    m_detectionsReordered = mergeStats.reordered;
+    m_detectionsLate = mergeStats.late;
+    m_detectionsBuffered = mergeStats.buffered;
+    m_detectionsDropped = mergeStats.dropped;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,151 @@
+#ifndef FUSIONENGINE_H
+#define FUSIONENGINE_H
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "sensors/SensorInterface.h"
+#include "utils/BoundedQueue.h"
+#include "utils/LatencyStats.h"
+
+class QThread;
+class QTimer;
+
+namespace CounterUAS {
+
+class TrackManager;
+class DetectionMerger;
+
+/**
+ * @brief Configuration for the sensor-to-track pipeline
+ */
+struct FusionEngineConfig {
+    bool threaded = false;     // Run fusion and sensor I/O on worker threads
+    int queueCapacity = 256;   // Scans buffered between sensor I/O and fusion
+    int maxScansPerDrain = 32; // Scans fused before yielding to the event loop
+    // Hold detections this long and fuse them in timestamp order rather than
+    // arrival order; 0 disables the merge
+    int reorderWindowMs = 0;
+    int laneCapacity = 1024;   // Detections buffered per merge lane
+};
+
+/**
+ * @brief Pipeline from sensor reads to the TrackManager
+ *
+ * Sensors and simulators hand whole scans to submitBatch() from whatever
+ * thread they run on. In threaded mode the scans cross a bounded lock-free
+ * queue to a dedicated fusion thread that owns the TrackManager (and with
+ * it the track cycle timer), and unparented sensors attached before start()
+ * are moved to a separate I/O thread so their socket reads never wait on
+ * the GUI. A full queue drops the newest scan rather than blocking the
+ * reader. Consumers on the GUI thread should read TrackManager::snapshot().
+ *
+ * Without threading, submitted scans are fused immediately on the calling
+ * thread, exactly as calling processDetectionBatch() directly.
+ *
+ * With a reorder window the scan queue is bypassed: detections go into a
+ * DetectionMerger and a timer on the TrackManager's thread fuses, every
+ * quarter window, one batch of everything older than the window in
+ * timestamp order. Sensors with different latencies then update tracks in
+ * the order the measurements were taken, at the cost of the window's delay.
+ */
+class FusionEngine : public QObject {
+    Q_OBJECT
+
+public:
+    explicit FusionEngine(TrackManager* trackManager, QObject* parent = nullptr);
+    ~FusionEngine() override;
+
+    // Configuration (applied on the next start())
+    void setConfig(const FusionEngineConfig& config);
+    FusionEngineConfig config() const { return m_config; }
+
+    // Lifecycle
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; }
+    bool isThreaded() const { return m_threaded; }  // Effective mode while running
+
+    // Sensor detections are forwarded to submit() on the sensor's thread
+    void attachSensor(SensorInterface* sensor);
+    void detachSensor(SensorInterface* sensor);
+
+    // Thread-safe ingest; false if the scan was dropped on a full queue
+    bool submit(const SensorDetection& detection);
+    bool submitBatch(const QVector<SensorDetection>& detections);
+    
+    // Sees every submitted scan, on the submitting thread, before fusion;
+    // e.g. to record sensor input for replay. Set before start(); must be
+    // thread-safe when sensors run on several threads.
+    using ScanTap = std::function<void(const QVector<SensorDetection>&)>;
+    void setScanTap(ScanTap tap) { m_scanTap = std::move(tap); }
+
+    // Statistics
+    struct Statistics {
+        quint64 scansEnqueued = 0;
+        quint64 scansDropped = 0;      // Queue full
+        quint64 scansProcessed = 0;
+        int queueDepth = 0;
+        LatencyStats queueLatency;     // Enqueue to start of fusion
+        LatencyStats ingestToUpdate;   // Socket read to track update (TrackManager)
+        // Reorder window only
+        quint64 detectionsReordered = 0;
+        quint64 detectionsLate = 0;    // Arrived after their window was fused
+        quint64 detectionsDropped = 0; // Merge lane full
+        int detectionsBuffered = 0;
+    };
+    Statistics statistics() const;
+
+signals:
+    void scanDropped(const QString& sensorId);
+
+private:
+    struct QueuedScan {
+        QVector<SensorDetection> detections;
+        qint64 enqueuedNs = 0;
+    };
+
+    void scheduleDrain();
+    void drain(int maxScans);  // Runs on the TrackManager's thread
+    void releaseMerged(bool flushAll);  // Likewise
+
+    TrackManager* m_trackManager;
+    FusionEngineConfig m_config;
+    bool m_running = false;
+    bool m_threaded = false;
+
+    std::unique_ptr<BoundedQueue<QueuedScan>> m_queue;
+    std::unique_ptr<DetectionMerger> m_merger;   // Set while running with a reorder window
+    ScanTap m_scanTap;
+    std::atomic<bool> m_drainScheduled{false};
+    std::atomic<quint64> m_scansEnqueued{0};
+    std::atomic<quint64> m_scansDropped{0};
+
+    // Target for queued drains; lives with the TrackManager and is deleted
+    // with the engine so no drain can outlive it
+    QObject* m_drainContext;
+    QTimer* m_mergeTimer;   // Child of m_drainContext
+    QThread* m_fusionThread = nullptr;
+    QThread* m_ioThread = nullptr;
+
+    QList<QPointer<SensorInterface>> m_sensors;
+    QList<QPointer<SensorInterface>> m_movedSensors;  // Moved to m_ioThread by start()
+
+    mutable QMutex m_statsMutex;
+    quint64 m_scansProcessed = 0;
+    LatencyStats m_queueLatency;
+    quint64 m_detectionsReordered = 0;
+    quint64 m_detectionsLate = 0;
+    quint64 m_detectionsDropped = 0;
+    int m_detectionsBuffered = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // FUSIONENGINE_H
@@ -0,0 +1,177 @@
+#ifndef FUSIONPOLICY_H
+#define FUSIONPOLICY_H
+
+#include <QtMath>
+#include "core/Track.h"
+#include "core/TrackFeatureBank.h"
+#include "core/TrackTable.h"
+#include "sensors/SensorInterface.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief How TrackManager gates and fuses one kind of detection
+ *
+ * A fusion policy is a struct of compile-time traits and static functions,
+ * never instantiated for state:
+ *
+ *  - the measurement model TrackTable::scoreCandidates() is instantiated
+ *    with (MEASURES_VELOCITY, LINE_OF_SIGHT, RANGE_WEIGHT; see
+ *    PositionVelocityModel), and lineOfSight(), the unit bearing an
+ *    angle-only plot was placed along;
+ *  - apply(), what a correlated plot of the source writes into its track
+ *    beyond position, after the filter update;
+ *  - defaults for what the source's plain onSensorData() plots leave out.
+ *
+ * visitFusionPolicy() is the only runtime switch on DetectionSource: the
+ * batch path turns each plot's source into its policy type once, and
+ * everything past that, down to the scoring kernel, is compiled for it. A
+ * new sensor type is a policy here and a case in visitFusionPolicy().
+ */
+
+// Full position and range rate; RCS in signalStrength
+struct RadarFusionPolicy : PositionVelocityModel {
+    static constexpr double DEFAULT_QUALITY = 0.8;
+
+    static EnuVector lineOfSight(const SensorDetection&) { return EnuVector(); }
+
+    static void apply(Track& track, TrackFeatureBank& features, const SensorDetection& detection) {
+        track.setVelocity(detection.velocity);
+        track.setTrackQuality(qMax(track.trackQuality(), detection.confidence));
+        features.observeRcs(track.tableRow(), detection.signalStrength);  // RCS, m^2
+    }
+};
+
+// Bearing only: a direction-finding plot sits on its bearing at a range
+// guessed from signal strength, so its miss along the bearing counts for a
+// quarter. RFBearingFuser's fixes leave the bearing unset and gate as points.
+struct RFFusionPolicy {
+    static constexpr bool MEASURES_VELOCITY = false;
+    static constexpr bool LINE_OF_SIGHT = true;
+    static constexpr double RANGE_WEIGHT = 0.25;
+    static constexpr double DEFAULT_SIGNAL = 0.5;
+    static constexpr double HOSTILE_SIGNAL = 0.7;     // Stronger marks a Pending track Hostile
+    static constexpr double HOSTILE_CONFIDENCE = 0.6;
+
+    static EnuVector lineOfSight(const SensorDetection& detection) {
+        const RFEmissionInfo& rf = detection.info.rf;
+        if (!(rf.bearingSigmaDeg > 0.0f)) return EnuVector();
+        const double azimuth = qDegreesToRadians(double(rf.azimuthDeg));
+        const double elevation = qDegreesToRadians(double(rf.elevationDeg));
+        EnuVector bearing;
+        bearing.east = std::cos(elevation) * std::sin(azimuth);
+        bearing.north = std::cos(elevation) * std::cos(azimuth);
+        bearing.up = std::sin(elevation);
+        return bearing;
+    }
+
+    static void apply(Track& track, TrackFeatureBank& features, const SensorDetection& detection) {
+        features.observeRf(track.tableRow(), detection.info.rf.protocol);
+        // RF detection increases confidence it's a drone
+        if (detection.signalStrength > HOSTILE_SIGNAL &&
+            track.classification() == TrackClassification::Pending) {
+            track.setClassification(TrackClassification::Hostile);
+            track.setClassificationConfidence(HOSTILE_CONFIDENCE);
+        }
+    }
+};
+
+// Angles and a box; the position is an estimate and there is no velocity.
+// The detection does not carry the camera's pose, so it gates as a point.
+struct CameraFusionPolicy {
+    static constexpr bool MEASURES_VELOCITY = false;
+    static constexpr bool LINE_OF_SIGHT = false;
+    static constexpr double RANGE_WEIGHT = 1.0;
+
+    static EnuVector lineOfSight(const SensorDetection&) { return EnuVector(); }
+
+    static void apply(Track& track, TrackFeatureBank&, const SensorDetection& detection) {
+        BoundingBox box;
+        box.x = static_cast<int>(detection.info.camera.x);
+        box.y = static_cast<int>(detection.info.camera.y);
+        box.width = static_cast<int>(detection.info.camera.width);
+        box.height = static_cast<int>(detection.info.camera.height);
+        box.cameraId = detection.sensorId;
+        box.timestamp = detection.timestamp;
+        if (box.isValid()) {
+            track.setBoundingBox(box);
+        }
+        track.setAssociatedCameraId(detection.sensorId);
+        track.setVisuallyTracked(true);
+    }
+};
+
+// The target broadcasts its own state and identity; only an operator's
+// classification outranks it
+struct CooperativeFusionPolicy : PositionVelocityModel {
+    static EnuVector lineOfSight(const SensorDetection&) { return EnuVector(); }
+
+    static void apply(Track& track, TrackFeatureBank&, const SensorDetection& detection) {
+        track.setVelocity(detection.velocity);
+        track.setTrackQuality(qMax(track.trackQuality(), detection.confidence));
+        if (track.classificationConfidence() < 1.0) {
+            track.setClassification(static_cast<TrackClassification>(
+                detection.info.cooperative.classification));
+            track.setClassificationConfidence(detection.confidence);
+        }
+    }
+};
+
+// Another C2 node's fused track. Its classification is taken when at least
+// as firm as the track's, short of an operator's; a less firm report can
+// only raise the threat level, so no site's warning is lost.
+struct CombinedFusionPolicy : PositionVelocityModel {
+    static EnuVector lineOfSight(const SensorDetection&) { return EnuVector(); }
+
+    static void apply(Track& track, TrackFeatureBank&, const SensorDetection& detection) {
+        const CombinedTrackInfo& info = detection.info.combined;
+        track.setVelocity(detection.velocity);
+        track.setTrackQuality(qMax(track.trackQuality(), detection.confidence));
+        if (track.classificationConfidence() < 1.0 &&
+            info.classificationConfidence >= track.classificationConfidence()) {
+            track.setClassification(static_cast<TrackClassification>(info.classification));
+            track.setClassificationConfidence(info.classificationConfidence);
+            track.setThreatLevel(info.threatLevel);
+        } else if (info.threatLevel > track.threatLevel()) {
+            track.setThreatLevel(info.threatLevel);
+        }
+    }
+};
+
+// Manual plots: gated as radar is, nothing beyond position
+struct DefaultFusionPolicy : PositionVelocityModel {
+    static EnuVector lineOfSight(const SensorDetection&) { return EnuVector(); }
+
+    static void apply(Track&, TrackFeatureBank&, const SensorDetection&) {}
+};
+
+/**
+ * @brief Calls visit with a default-constructed policy for source
+ */
+template <typename Visitor>
+inline void visitFusionPolicy(DetectionSource source, Visitor&& visit) {
+    switch (source) {
+        case DetectionSource::Radar:
+            visit(RadarFusionPolicy());
+            break;
+        case DetectionSource::RFDetector:
+            visit(RFFusionPolicy());
+            break;
+        case DetectionSource::Camera:
+            visit(CameraFusionPolicy());
+            break;
+        case DetectionSource::Cooperative:
+            visit(CooperativeFusionPolicy());
+            break;
+        case DetectionSource::Combined:
+            visit(CombinedFusionPolicy());
+            break;
+        default:
+            visit(DefaultFusionPolicy());
+            break;
+    }
+}
+
+} // namespace CounterUAS
+
+#endif // FUSIONPOLICY_H
@@ -0,0 +1,277 @@
+#include "core/GeofenceIndex.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+// Sort-Tile-Recursive order: slabs along east, each slab sorted by north
+template<typename T, typename EastFn, typename NorthFn>
+void strOrder(T* first, T* last, EastFn east, NorthFn north) {
+    const int n = int(last - first);
+    const int leaves = (n + GeofenceIndex::NODE_CAPACITY - 1) / GeofenceIndex::NODE_CAPACITY;
+    const int slabs = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(leaves)))));
+    const int slabSize = slabs * GeofenceIndex::NODE_CAPACITY;
+
+    std::sort(first, last, [&east](const T& a, const T& b) { return east(a) < east(b); });
+    for (int start = 0; start < n; start += slabSize) {
+        std::sort(first + start, first + std::min(n, start + slabSize),
+                  [&north](const T& a, const T& b) { return north(a) < north(b); });
+    }
+}
+
+double boxDistanceSq(double v, double lo, double hi) {
+    const double d = v < lo ? lo - v : (v > hi ? v - hi : 0.0);
+    return d * d;
+}
+
+} // namespace
+
+QJsonObject GeofenceZone::toJson() const {
+    QJsonObject obj;
+    obj["id"] = id;
+    obj["name"] = name;
+    obj["type"] = static_cast<int>(type);
+    QJsonArray boundary;
+    for (const GeoPosition& vertex : vertices) boundary.append(vertex.toJson());
+    obj["vertices"] = boundary;
+    obj["floorM"] = floorM;
+    obj["ceilingM"] = ceilingM;
+    return obj;
+}
+
+GeofenceZone GeofenceZone::fromJson(const QJsonObject& json) {
+    GeofenceZone zone;
+    zone.id = json["id"].toString();
+    zone.name = json["name"].toString();
+    zone.type = static_cast<GeofenceType>(json["type"].toInt());
+    for (const QJsonValue& vertex : json["vertices"].toArray()) {
+        zone.vertices.append(GeoPosition::fromJson(vertex.toObject()));
+    }
+    zone.floorM = json["floorM"].toDouble(0.0);
+    zone.ceilingM = json["ceilingM"].toDouble(-1);
+    return zone;
+}
+
+void GeofenceIndex::rebuild(const QList<GeofenceZone>& zones) {
+    clear();
+    if (zones.isEmpty()) return;
+
+    // One plane at the mean vertex; zones span a site, not a continent
+    GeoPosition origin;
+    int vertexCount = 0;
+    for (const GeofenceZone& zone : zones) {
+        for (const GeoPosition& vertex : zone.vertices) {
+            origin.latitude += vertex.latitude;
+            origin.longitude += vertex.longitude;
+            ++vertexCount;
+        }
+    }
+    if (vertexCount > 0) {
+        origin.latitude /= vertexCount;
+        origin.longitude /= vertexCount;
+    }
+    origin.altitude = 0.0;
+    m_frame.setOrigin(origin);
+
+    m_zones.reserve(zones.size());
+    for (const GeofenceZone& source : zones) {
+        Zone zone;
+        zone.id = source.id;
+        zone.floorM = source.floorM;
+        if (source.ceilingM >= 0) zone.ceilingM = source.ceilingM;
+
+        const int count = source.vertices.size();
+        if (count >= 3) {
+            const int firstEdge = m_edges.size();
+            for (int i = 0; i < count; ++i) {
+                const EnuVector a = m_frame.toEnuLinear(source.vertices[i]);
+                const EnuVector b = m_frame.toEnuLinear(source.vertices[(i + 1) % count]);
+                Edge edge;
+                edge.east = a.east;
+                edge.north = a.north;
+                edge.dEast = b.east - a.east;
+                edge.dNorth = b.north - a.north;
+                const double lengthSq = edge.dEast * edge.dEast + edge.dNorth * edge.dNorth;
+                edge.invLengthSq = lengthSq > 0.0 ? 1.0 / lengthSq : 0.0;
+                m_edges.append(edge);
+            }
+            zone.root = buildTree(firstEdge, count);
+        }
+        m_zones.append(zone);
+    }
+}
+
+void GeofenceIndex::clear() {
+    m_zones.clear();
+    m_edges.clear();
+    m_leafEdges.clear();
+    m_nodes.clear();
+    m_frame = LocalTangentPlane();
+}
+
+int GeofenceIndex::indexOf(const QString& zoneId) const {
+    for (int i = 0; i < m_zones.size(); ++i) {
+        if (m_zones[i].id == zoneId) return i;
+    }
+    return -1;
+}
+
+int GeofenceIndex::buildTree(int firstEdge, int edgeCount) {
+    // Leaves over the zone's STR-ordered edges, by edge midpoint
+    const int firstItem = m_leafEdges.size();
+    for (int i = 0; i < edgeCount; ++i) m_leafEdges.append(firstEdge + i);
+    strOrder(m_leafEdges.data() + firstItem, m_leafEdges.data() + firstItem + edgeCount,
+             [this](int i) { return 2.0 * m_edges[i].east + m_edges[i].dEast; },
+             [this](int i) { return 2.0 * m_edges[i].north + m_edges[i].dNorth; });
+
+    QVector<Node> level;
+    for (int first = firstItem; first < firstItem + edgeCount; first += NODE_CAPACITY) {
+        Node leaf;
+        leaf.first = first;
+        leaf.count = std::min(NODE_CAPACITY, firstItem + edgeCount - first);
+        leaf.leaf = true;
+        leaf.minE = leaf.minN = std::numeric_limits<double>::max();
+        leaf.maxE = leaf.maxN = -std::numeric_limits<double>::max();
+        for (int k = first; k < first + leaf.count; ++k) {
+            const Edge& edge = m_edges[m_leafEdges[k]];
+            const double endE = edge.east + edge.dEast;
+            const double endN = edge.north + edge.dNorth;
+            leaf.minE = std::min({leaf.minE, edge.east, endE});
+            leaf.maxE = std::max({leaf.maxE, edge.east, endE});
+            leaf.minN = std::min({leaf.minN, edge.north, endN});
+            leaf.maxN = std::max({leaf.maxN, edge.north, endN});
+        }
+        level.append(leaf);
+    }
+
+    // Pack each level's nodes into parents until one root remains
+    auto centreE = [](const Node& node) { return node.minE + node.maxE; };
+    auto centreN = [](const Node& node) { return node.minN + node.maxN; };
+    while (level.size() > 1) {
+        strOrder(level.data(), level.data() + level.size(), centreE, centreN);
+        const int base = m_nodes.size();
+        m_nodes += level;
+
+        QVector<Node> parents;
+        for (int first = 0; first < level.size(); first += NODE_CAPACITY) {
+            Node parent;
+            parent.first = base + first;
+            parent.count = std::min(NODE_CAPACITY, level.size() - first);
+            parent.leaf = false;
+            parent.minE = parent.minN = std::numeric_limits<double>::max();
+            parent.maxE = parent.maxN = -std::numeric_limits<double>::max();
+            for (int k = first; k < first + parent.count; ++k) {
+                const Node& child = level[k];
+                parent.minE = std::min(parent.minE, child.minE); parent.maxE = std::max(parent.maxE, child.maxE);
+                parent.minN = std::min(parent.minN, child.minN); parent.maxN = std::max(parent.maxN, child.maxN);
+            }
+            parents.append(parent);
+        }
+        level = parents;
+    }
+
+    m_nodes.append(level.first());
+    return m_nodes.size() - 1;
+}
+
+bool GeofenceIndex::insideTree(int root, double e, double n) const {
+    // Crossings of the ray from the point toward +east; only nodes that
+    // span the point's north and reach east of it can hold one
+    bool inside = false;
+    int stack[64];
+    int depth = 0;
+    stack[depth++] = root;
+    while (depth > 0) {
+        const Node& node = m_nodes[stack[--depth]];
+        if (n < node.minN || n > node.maxN || e > node.maxE) continue;
+        if (!node.leaf) {
+            for (int k = 0; k < node.count; ++k) stack[depth++] = node.first + k;
+            continue;
+        }
+        for (int k = node.first; k < node.first + node.count; ++k) {
+            const Edge& edge = m_edges[m_leafEdges[k]];
+            const double endN = edge.north + edge.dNorth;
+            if ((edge.north > n) == (endN > n)) continue;
+            const double crossE = edge.east + (n - edge.north) * edge.dEast / edge.dNorth;
+            if (crossE > e) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+double GeofenceIndex::edgeDistanceSq(const Edge& edge, double e, double n) {
+    const double t = std::min(1.0, std::max(0.0, ((e - edge.east) * edge.dEast +
+                                                  (n - edge.north) * edge.dNorth) * edge.invLengthSq));
+    const double de = edge.east + t * edge.dEast - e;
+    const double dn = edge.north + t * edge.dNorth - n;
+    return de * de + dn * dn;
+}
+
+void GeofenceIndex::nearestEdge(int nodeIndex, double e, double n, double& bestSq) const {
+    const Node& node = m_nodes[nodeIndex];
+    if (node.leaf) {
+        for (int k = node.first; k < node.first + node.count; ++k) {
+            bestSq = std::min(bestSq, edgeDistanceSq(m_edges[m_leafEdges[k]], e, n));
+        }
+        return;
+    }
+
+    // Nearer children first so the bound tightens early
+    int order[NODE_CAPACITY];
+    double childSq[NODE_CAPACITY];
+    for (int k = 0; k < node.count; ++k) {
+        const Node& child = m_nodes[node.first + k];
+        order[k] = k;
+        childSq[k] = boxDistanceSq(e, child.minE, child.maxE) +
+                     boxDistanceSq(n, child.minN, child.maxN);
+    }
+    std::sort(order, order + node.count, [&childSq](int a, int b) { return childSq[a] < childSq[b]; });
+    for (int k = 0; k < node.count; ++k) {
+        if (childSq[order[k]] >= bestSq) break;
+        nearestEdge(node.first + order[k], e, n, bestSq);
+    }
+}
+
+bool GeofenceIndex::contains(int zone, const GeoPosition& pos) const {
+    const Zone& z = m_zones[zone];
+    if (z.root < 0 || !inBand(z, pos.altitude)) return false;
+    const EnuVector p = m_frame.toEnuLinear(pos);
+    return insideTree(z.root, p.east, p.north);
+}
+
+double GeofenceIndex::signedDistanceM(int zone, const GeoPosition& pos, double limitM) const {
+    constexpr double INF = std::numeric_limits<double>::infinity();
+    const Zone& z = m_zones[zone];
+    if (z.root < 0 || !inBand(z, pos.altitude)) return INF;
+
+    const EnuVector p = m_frame.toEnuLinear(pos);
+    const Node& root = m_nodes[z.root];
+    const double limitSq = limitM * limitM;
+    const double boxSq = boxDistanceSq(p.east, root.minE, root.maxE) +
+                         boxDistanceSq(p.north, root.minN, root.maxN);
+    if (boxSq >= limitSq) return INF;   // Outside the zone's box, and far from it
+
+    const bool inside = insideTree(z.root, p.east, p.north);
+    double bestSq = limitSq;
+    nearestEdge(z.root, p.east, p.north, bestSq);
+    if (bestSq >= limitSq) return inside ? -INF : INF;
+    const double distance = std::sqrt(bestSq);
+    return inside ? -distance : distance;
+}
+
+void GeofenceIndex::zonesContaining(const GeoPosition& pos, QVector<int>& zones) const {
+    zones.clear();
+    if (m_zones.isEmpty()) return;
+    const EnuVector p = m_frame.toEnuLinear(pos);
+    for (int i = 0; i < m_zones.size(); ++i) {
+        const Zone& z = m_zones[i];
+        if (z.root >= 0 && inBand(z, pos.altitude) && insideTree(z.root, p.east, p.north)) {
+            zones.append(i);
+        }
+    }
+}
+
+} // namespace CounterUAS
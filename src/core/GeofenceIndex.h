@@ -0,0 +1,110 @@
+#ifndef GEOFENCEINDEX_H
+#define GEOFENCEINDEX_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <limits>
+#include "core/Track.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+enum class GeofenceType {
+    Restricted,
+    NoFly,
+    Corridor        // Where tracks are expected; rules usually test outside it
+};
+
+/**
+ * @brief Restricted zone, no-fly area or corridor as a ground polygon
+ */
+struct GeofenceZone {
+    QString id;
+    QString name;
+    GeofenceType type = GeofenceType::Restricted;
+    QVector<GeoPosition> vertices;      // Boundary in order, either winding, not closed
+    double floorM = 0.0;                // Altitude band the zone covers, as track altitudes
+    double ceilingM = -1;               // -1 means unlimited
+
+    QJsonObject toJson() const;
+    static GeofenceZone fromJson(const QJsonObject& json);
+};
+
+/**
+ * @brief Geofence polygons in one tangent plane, for point-in-polygon and
+ * boundary distance queries
+ *
+ * Every edge is stored once as a start point, a direction and its inverse
+ * squared length, and each zone's edges sit under their own static R-tree
+ * (STR-packed, like DefendedAssetIndex). Containment walks only the
+ * nodes whose north span holds the point and that reach east of it,
+ * counting crossings of an eastward ray; boundary distance is a
+ * branch-and-bound nearest-edge search that can stop at a caller's limit.
+ * A zone of hundreds of vertices costs a few node visits per query.
+ *
+ * Rebuilt on zone changes; queries are const and allocation-free.
+ */
+class GeofenceIndex {
+public:
+    static constexpr int NODE_CAPACITY = 8;
+
+    void rebuild(const QList<GeofenceZone>& zones);
+    void clear();
+
+    bool isEmpty() const { return m_zones.isEmpty(); }
+    int size() const { return m_zones.size(); }
+    int indexOf(const QString& zoneId) const;   // -1 if unknown
+    // The plane every zone is kept in
+    const LocalTangentPlane& frame() const { return m_frame; }
+
+    // Inside the polygon and its height band
+    bool contains(int zone, const GeoPosition& pos) const;
+    // Ground range to the zone's boundary, negative inside. Points outside
+    // the height band are +infinity; points further than limitM from the
+    // boundary are +infinity or -infinity, whichever side they are on.
+    double signedDistanceM(int zone, const GeoPosition& pos,
+                           double limitM = std::numeric_limits<double>::infinity()) const;
+    void zonesContaining(const GeoPosition& pos, QVector<int>& zones) const;
+
+private:
+    struct Edge {
+        double east, north;             // Start vertex
+        double dEast, dNorth;           // To the end vertex
+        double invLengthSq;             // 0 for a degenerate edge
+    };
+
+    struct Node {
+        double minE, minN;
+        double maxE, maxN;
+        int first;   // Into m_leafEdges (leaf) or m_nodes (inner)
+        int count;
+        bool leaf;
+    };
+
+    struct Zone {
+        QString id;
+        double floorM = 0.0;
+        double ceilingM = std::numeric_limits<double>::infinity();
+        int root = -1;                  // Into m_nodes; -1 for fewer than three vertices
+    };
+
+    bool inBand(const Zone& zone, double altitude) const {
+        return altitude >= zone.floorM && altitude <= zone.ceilingM;
+    }
+    int buildTree(int firstEdge, int edgeCount);
+    bool insideTree(int root, double e, double n) const;
+    void nearestEdge(int node, double e, double n, double& bestSq) const;
+    static double edgeDistanceSq(const Edge& edge, double e, double n);
+
+    LocalTangentPlane m_frame;
+    QVector<Zone> m_zones;
+    QVector<Edge> m_edges;
+    QVector<int> m_leafEdges;
+    QVector<Node> m_nodes;
+};
+
+} // namespace CounterUAS
+
+#endif // GEOFENCEINDEX_H
@@ -0,0 +1,181 @@
+#include "core/InterceptSolver.h"
+#include "utils/CoordinateUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+// A union of disjoint, ascending closed intervals; a quadratic constraint
+// leaves at most two, an intersection of such never more than a few
+struct Intervals {
+    static constexpr int MAX = 4;
+    double lo[MAX];
+    double hi[MAX];
+    int count = 0;
+
+    void add(double a, double b) {
+        if (a <= b && count < MAX) {
+            lo[count] = a;
+            hi[count] = b;
+            count++;
+        }
+    }
+};
+
+// Where a t^2 + b t + c <= 0 within [from, to]
+Intervals solveBelow(double a, double b, double c, double from, double to) {
+    Intervals out;
+    const double scale = std::abs(a) + std::abs(b) + std::abs(c);
+    if (std::abs(a) <= 1e-12 * scale) {
+        if (std::abs(b) <= 1e-12 * scale) {
+            if (c <= 0.0) out.add(from, to);
+        } else if (b > 0.0) {
+            out.add(from, std::min(to, -c / b));
+        } else {
+            out.add(std::max(from, -c / b), to);
+        }
+        return out;
+    }
+
+    const double disc = b * b - 4.0 * a * c;
+    if (disc < 0.0) {
+        if (a < 0.0) out.add(from, to);
+        return out;
+    }
+
+    // Stable roots, r1 <= r2
+    const double q = -0.5 * (b + std::copysign(std::sqrt(disc), b));
+    double r1 = q / a;
+    double r2 = q != 0.0 ? c / q : r1;
+    if (r1 > r2) std::swap(r1, r2);
+
+    if (a > 0.0) {
+        out.add(std::max(from, r1), std::min(to, r2));
+    } else {
+        out.add(from, std::min(to, r1));
+        out.add(std::max(from, r2), to);
+    }
+    return out;
+}
+
+Intervals intersect(const Intervals& x, const Intervals& y) {
+    Intervals out;
+    for (int i = 0; i < x.count; ++i) {
+        for (int j = 0; j < y.count; ++j) {
+            out.add(std::max(x.lo[i], y.lo[j]), std::min(x.hi[i], y.hi[j]));
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+bool InterceptorKinematics::operator==(const InterceptorKinematics& o) const {
+    return launchDelaySec == o.launchDelaySec &&
+           speedMps == o.speedMps &&
+           maxFlightTimeSec == o.maxFlightTimeSec &&
+           minRangeM == o.minRangeM &&
+           maxRangeM == o.maxRangeM &&
+           maxAltitudeM == o.maxAltitudeM &&
+           maxWaitSec == o.maxWaitSec &&
+           seekerBasketM == o.seekerBasketM &&
+           baseProbability == o.baseProbability;
+}
+
+InterceptSolver::InterceptSolver(const InterceptorKinematics& kinematics, const GeoPosition& launcher)
+    : m_kinematics(kinematics)
+    , m_launcher(launcher)
+{
+}
+
+InterceptTarget InterceptSolver::target(const QString& trackId, const GeoPosition& position,
+                                        const VelocityVector& velocity, double trackQuality) {
+    const double doubt = 1.0 - std::clamp(trackQuality, 0.0, 1.0);
+    InterceptTarget target;
+    target.trackId = trackId;
+    target.position = position;
+    target.velocity = velocity;
+    target.positionSigmaM = 5.0 + 45.0 * doubt;
+    target.velocitySigmaMps = 1.0 + 9.0 * doubt;
+    return target;
+}
+
+InterceptSolution InterceptSolver::solve(const InterceptTarget& target) const {
+    InterceptSolution solution;
+    solution.trackId = target.trackId;
+
+    const InterceptorKinematics& k = m_kinematics;
+    const double s = k.speedMps;
+    const double d = std::max(0.0, k.launchDelaySec);
+    if (s <= 0.0 || k.maxFlightTimeSec <= 0.0) return solution;
+
+    // Local tangent plane at the launcher, up positive
+    const double metersLon = CoordinateUtils::degToMeterLon(m_launcher.latitude);
+    const double px = (target.position.longitude - m_launcher.longitude) * metersLon;
+    const double py = (target.position.latitude - m_launcher.latitude) * CoordinateUtils::DEG_TO_M_LAT;
+    const double pz = target.position.altitude - m_launcher.altitude;
+    const double vx = target.velocity.east;
+    const double vy = target.velocity.north;
+    const double vz = -target.velocity.down;
+
+    const double pp = px * px + py * py + pz * pz;
+    const double pv = px * vx + py * vy + pz * vz;
+    const double vv = vx * vx + vy * vy + vz * vz;
+    const double from = d;
+    const double to = d + std::max(0.0, k.maxWaitSec) + k.maxFlightTimeSec;
+
+    // Reachable: |p + v t| <= s (t - d)
+    Intervals window = solveBelow(vv - s * s, 2.0 * (pv + s * s * d), pp - s * s * d * d, from, to);
+    // Within maximum range and flight time
+    const double reach = std::min(k.maxRangeM, s * k.maxFlightTimeSec);
+    window = intersect(window, solveBelow(vv, 2.0 * pv, pp - reach * reach, from, to));
+    // Beyond minimum range
+    window = intersect(window, solveBelow(-vv, -2.0 * pv, k.minRangeM * k.minRangeM - pp, from, to));
+    // Under the ceiling
+    window = intersect(window, solveBelow(0.0, vz, pz - k.maxAltitudeM, from, to));
+    if (window.count == 0) return solution;
+
+    double t = window.lo[0];
+    for (int i = 1; i < window.count; ++i) {
+        t = std::min(t, window.lo[i]);
+    }
+
+    const double ix = px + vx * t;
+    const double iy = py + vy * t;
+    const double iz = pz + vz * t;
+    const double range = std::sqrt(ix * ix + iy * iy + iz * iz);
+    const double flight = range / s;
+
+    solution.feasible = true;
+    solution.timeToInterceptSec = t;
+    solution.timeOfFlightSec = flight;
+    solution.launchInSec = std::max(d, t - flight);
+    solution.interceptRangeM = range;
+    solution.interceptPoint = GeoPosition{m_launcher.latitude + iy / CoordinateUtils::DEG_TO_M_LAT,
+                                          m_launcher.longitude + (metersLon > 0.0 ? ix / metersLon : 0.0),
+                                          m_launcher.altitude + iz};
+
+    // Prediction error at the meeting against the seeker basket
+    const double sigmaV = target.velocitySigmaMps * t;
+    const double sigma2 = target.positionSigmaM * target.positionSigmaM + sigmaV * sigmaV;
+    const double acquisition = sigma2 > 0.0
+        ? 1.0 - std::exp(-k.seekerBasketM * k.seekerBasketM / (2.0 * sigma2))
+        : 1.0;
+    const double spent = flight / k.maxFlightTimeSec;
+    const double energy = 1.0 - 0.5 * spent * spent;
+    solution.pk = std::clamp(k.baseProbability * acquisition * energy, 0.0, 1.0);
+    return solution;
+}
+
+QVector<InterceptSolution> InterceptSolver::solve(const QVector<InterceptTarget>& targets) const {
+    QVector<InterceptSolution> solutions;
+    solutions.reserve(targets.size());
+    for (const InterceptTarget& target : targets) {
+        solutions.append(solve(target));
+    }
+    return solutions;
+}
+
+} // namespace CounterUAS
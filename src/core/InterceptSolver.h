@@ -0,0 +1,95 @@
+#ifndef INTERCEPTSOLVER_H
+#define INTERCEPTSOLVER_H
+
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief What an interceptor can do once commanded
+ */
+struct InterceptorKinematics {
+    double launchDelaySec = 2.5;        // Command to leaving the rail
+    double speedMps = 100.0;            // Average fly-out speed
+    double maxFlightTimeSec = 10.0;
+    double minRangeM = 100.0;
+    double maxRangeM = 1500.0;
+    double maxAltitudeM = 500.0;        // Above the launcher
+    double maxWaitSec = 60.0;           // Longest wait for the target to come into reach
+    double seekerBasketM = 50.0;        // Prediction error the seeker still corrects
+    double baseProbability = 0.85;      // Pk against a perfectly predicted target
+
+    bool operator==(const InterceptorKinematics& o) const;
+    bool operator!=(const InterceptorKinematics& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief A track's Kalman state as the solver needs it
+ */
+struct InterceptTarget {
+    QString trackId;
+    GeoPosition position;
+    VelocityVector velocity;
+    double positionSigmaM = 10.0;
+    double velocitySigmaMps = 2.0;
+};
+
+/**
+ * @brief Where and when an interceptor meets a target
+ */
+struct InterceptSolution {
+    QString trackId;
+    bool feasible = false;
+    double launchInSec = 0.0;           // From now; later than the launch delay if it must wait
+    double timeOfFlightSec = 0.0;
+    double timeToInterceptSec = 0.0;    // From now to the meeting
+    double interceptRangeM = 0.0;       // Slant range from the launcher
+    GeoPosition interceptPoint;
+    double pk = 0.0;
+};
+
+/**
+ * @brief Lead-pursuit intercept geometry against constant-velocity targets
+ *
+ * In the local tangent plane at the launcher the target is at p + v t
+ * and an interceptor commanded now can be anywhere within s (t - d) of
+ * the launcher from t = d on. Each envelope limit (reach, maximum range
+ * or flight time, minimum range, ceiling) is a quadratic or linear
+ * inequality in t, so the earliest intercept is the first point their
+ * intersection of intervals admits: closed form, no iteration, a few
+ * dozen flops per target. If the target is out of reach now but coming
+ * in, the launch simply waits.
+ *
+ * Pk is the base probability, times the chance the prediction error at
+ * the meeting (position sigma grown by velocity sigma over the time to
+ * intercept) falls within the seeker basket, times an energy term that
+ * falls off towards the end of the fly-out.
+ */
+class InterceptSolver {
+public:
+    explicit InterceptSolver(const InterceptorKinematics& kinematics = InterceptorKinematics(),
+                             const GeoPosition& launcher = GeoPosition());
+
+    void setKinematics(const InterceptorKinematics& kinematics) { m_kinematics = kinematics; }
+    InterceptorKinematics kinematics() const { return m_kinematics; }
+    void setLauncher(const GeoPosition& launcher) { m_launcher = launcher; }
+    GeoPosition launcher() const { return m_launcher; }
+
+    InterceptSolution solve(const InterceptTarget& target) const;
+    // One solution per target, in order
+    QVector<InterceptSolution> solve(const QVector<InterceptTarget>& targets) const;
+
+    // Kalman uncertainty from a track quality in [0, 1]
+    static InterceptTarget target(const QString& trackId, const GeoPosition& position,
+                                  const VelocityVector& velocity, double trackQuality);
+
+private:
+    InterceptorKinematics m_kinematics;
+    GeoPosition m_launcher;
+};
+
+} // namespace CounterUAS
+
+#endif // INTERCEPTSOLVER_H
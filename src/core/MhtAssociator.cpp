@@ -0,0 +1,416 @@
+#include "core/MhtAssociator.h"
+#include "utils/AssignmentSolver.h"
+#include "utils/TaskScheduler.h"
+#include "utils/TimeUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr double GATE_CHI2 = 11.34;        // 3 degrees of freedom, 99 %
+constexpr double LOG_2PI = 1.8378770664093453;
+constexpr int MAX_CLUSTER_TRACKS = 32;     // Larger clusters go straight to GNN
+constexpr int REALISE_STEPS = 1000;        // Leaf choices tried per ranked assignment
+constexpr qint64 MISS = -1;
+
+int findRoot(QVector<int>& parent, int node) {
+    while (parent[node] != node) {
+        parent[node] = parent[parent[node]];
+        node = parent[node];
+    }
+    return node;
+}
+
+void predict(MhtKinematics& k, qint64 timeMs, double q) {
+    const double dt = qMax<qint64>(0, timeMs - k.timeMs) / 1000.0;
+    for (int a = 0; a < 3; ++a) {
+        k.position[a] += k.velocity[a] * dt;
+        k.positionVariance[a] += 2.0 * dt * k.crossCovariance[a] + dt * dt * k.velocityVariance[a] +
+                                 q * dt * dt * dt / 3.0;
+        k.crossCovariance[a] += dt * k.velocityVariance[a] + q * dt * dt / 2.0;
+        k.velocityVariance[a] += q * dt;
+    }
+    k.timeMs = qMax(k.timeMs, timeMs);
+}
+
+// Fuses z into k and returns the measurement's log likelihood, or false
+// when it is outside the gate
+bool update(MhtKinematics& k, const double* z, double r, double& logLikelihood) {
+    double d2 = 0.0;
+    double logDet = 0.0;
+    double s[3];
+    for (int a = 0; a < 3; ++a) {
+        s[a] = k.positionVariance[a] + r;
+        const double y = z[a] - k.position[a];
+        d2 += y * y / s[a];
+        logDet += std::log(s[a]);
+    }
+    if (d2 > GATE_CHI2) return false;
+    for (int a = 0; a < 3; ++a) {
+        const double y = z[a] - k.position[a];
+        const double kp = k.positionVariance[a] / s[a];
+        const double kv = k.crossCovariance[a] / s[a];
+        k.position[a] += kp * y;
+        k.velocity[a] += kv * y;
+        k.velocityVariance[a] -= kv * k.crossCovariance[a];
+        k.positionVariance[a] *= 1.0 - kp;
+        k.crossCovariance[a] *= 1.0 - kp;
+    }
+    logLikelihood = -1.5 * LOG_2PI - 0.5 * logDet - 0.5 * d2;
+    return true;
+}
+
+} // namespace
+
+int MhtAssociator::branchCount() const {
+    int count = 0;
+    for (const Tree& tree : m_trees) {
+        count += tree.leaves.size();
+    }
+    return count;
+}
+
+void MhtAssociator::associate(const QVector<MhtPlot>& plots, const QVector<MhtTrack>& tracks,
+                              const QVector<QVector<QPair<int, double>>>& gated, MhtScanResult& result) {
+    const qint64 startNs = TimeUtils::monotonicNs();
+    const qint64 deadlineNs = m_config.budgetUs > 0 ? startNs + qint64(m_config.budgetUs) * 1000 : 0;
+    const qint64 scanBase = m_nextPlotId;
+    m_nextPlotId += plots.size();
+
+    result.plotTrack.fill(-1, plots.size());
+    result.decisions.fill(MhtDecision(), tracks.size());
+    result.clusters = 0;
+    result.hypotheses = 0;
+    result.revisions = 0;
+    result.fallbacks = 0;
+
+    // Tracks are nodes [0, tracks), plots follow them
+    const int trackCount = tracks.size();
+    QVector<int> parent(trackCount + plots.size());
+    for (int i = 0; i < parent.size(); ++i) parent[i] = i;
+    for (int p = 0; p < gated.size() && p < plots.size(); ++p) {
+        for (const QPair<int, double>& edge : gated[p]) {
+            const int a = findRoot(parent, edge.first);
+            const int b = findRoot(parent, trackCount + p);
+            if (a != b) parent[a] = b;
+        }
+    }
+    // Tracks whose open scans share a plot are solved together, or both
+    // could keep it
+    QHash<qint64, int> trackOfPlot;
+    for (int t = 0; t < trackCount; ++t) {
+        auto tree = m_trees.constFind(tracks[t].handle);
+        if (tree == m_trees.constEnd()) continue;
+        for (const Branch& leaf : tree.value().leaves) {
+            for (qint64 id : leaf.plots) {
+                if (id == MISS) continue;
+                auto other = trackOfPlot.constFind(id);
+                if (other == trackOfPlot.constEnd()) {
+                    trackOfPlot.insert(id, t);
+                    continue;
+                }
+                const int a = findRoot(parent, other.value());
+                const int b = findRoot(parent, t);
+                if (a != b) parent[a] = b;
+            }
+        }
+    }
+
+    // Every track gets its tree before any is pointed at, as an insert can
+    // move the others
+    for (const MhtTrack& track : tracks) {
+        m_trees[track.handle];
+    }
+
+    // A plot that gated nothing starts a track; so does a cluster without tracks
+    QVector<Cluster> clusters;
+    QHash<int, int> clusterOfRoot;
+    for (int node = 0; node < parent.size(); ++node) {
+        if (node >= trackCount && gated.value(node - trackCount).isEmpty()) continue;
+        const int root = findRoot(parent, node);
+        auto it = clusterOfRoot.find(root);
+        if (it == clusterOfRoot.end()) {
+            it = clusterOfRoot.insert(root, clusters.size());
+            clusters.append(Cluster());
+        }
+        Cluster& cluster = clusters[it.value()];
+        if (node < trackCount) {
+            cluster.tracks.append(node);
+            cluster.trees.append(&m_trees[tracks[node].handle]);
+        } else {
+            cluster.plots.append(node - trackCount);
+        }
+    }
+    result.clusters = clusters.size();
+
+    // Biggest first, so the budget goes to the contended clusters and the
+    // stragglers are the cheap ones
+    std::sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.tracks.size() * a.plots.size() > b.tracks.size() * b.plots.size();
+    });
+    auto solveChunk = [&](int chunk, int chunkCount) {
+        for (int c = chunk; c < clusters.size(); c += chunkCount) {
+            Cluster& cluster = clusters[c];
+            const bool late = deadlineNs > 0 && c > 0 && TimeUtils::monotonicNs() > deadlineNs;
+            if (late || cluster.tracks.size() > MAX_CLUSTER_TRACKS) {
+                solveNearest(cluster, gated, result);
+            } else {
+                solveCluster(cluster, plots, tracks, gated, scanBase, deadlineNs, result);
+            }
+        }
+    };
+    const int chunkCount = qBound(1, clusters.size(), TaskScheduler::instance().workerCount());
+    if (chunkCount > 1) {
+        TaskGraph graph(TaskPriority::Realtime);
+        for (int chunk = 1; chunk < chunkCount; ++chunk) {
+            graph.add([&solveChunk, chunk, chunkCount]() { solveChunk(chunk, chunkCount); });
+        }
+        graph.run();
+        solveChunk(0, chunkCount);
+        graph.wait();
+    } else {
+        solveChunk(0, 1);
+    }
+
+    for (const Cluster& cluster : qAsConst(clusters)) {
+        result.hypotheses += cluster.hypotheses;
+        result.revisions += cluster.revisions;
+        if (cluster.fallback) result.fallbacks++;
+    }
+    // Settled trees go once nothing points at them
+    for (const MhtTrack& track : tracks) {
+        auto tree = m_trees.find(track.handle);
+        if (tree != m_trees.end() && tree.value().leaves.isEmpty()) m_trees.erase(tree);
+    }
+}
+
+void MhtAssociator::solveCluster(Cluster& cluster, const QVector<MhtPlot>& plots,
+                                 const QVector<MhtTrack>& tracks,
+                                 const QVector<QVector<QPair<int, double>>>& gated, qint64 scanBase,
+                                 qint64 deadlineNs, MhtScanResult& result) const {
+    const int rows = cluster.tracks.size();
+    const int plotCols = cluster.plots.size();
+    const int cols = plotCols + rows;   // Then a miss column per track
+    const double r = m_config.measurementSigmaM * m_config.measurementSigmaM;
+    const double pd = qBound(0.01, m_config.detectionProbability, 0.99);
+    const double hitBase = std::log(pd) - std::log(qMax(1.0e-30, m_config.falseAlarmDensity));
+    const double missScore = std::log(1.0 - pd);
+
+    QHash<int, int> rowOfTrack;
+    for (int i = 0; i < rows; ++i) rowOfTrack.insert(cluster.tracks[i], i);
+    QVector<QVector<int>> gatedCols(rows);
+    for (int col = 0; col < plotCols; ++col) {
+        for (const QPair<int, double>& edge : gated[cluster.plots[col]]) {
+            gatedCols[rowOfTrack.value(edge.first)].append(col);
+        }
+    }
+
+    // Grow every leaf. A cell, a track's plot or its miss, gets a child
+    // from each of the track's leaves, best first
+    QVector<Branch> children;
+    QVector<int> parentOf;              // Leaf of its track's tree each child grew from
+    QVector<QVector<int>> cells(rows * cols);
+    for (int i = 0; i < rows; ++i) {
+        Tree& tree = *cluster.trees[i];
+        if (tree.leaves.isEmpty()) {
+            Branch seed;
+            seed.state = tracks[cluster.tracks[i]].kinematics;
+            tree.leaves.append(seed);
+            tree.applied.clear();
+        }
+        auto offer = [&](int col, int leaf, Branch&& branch) {
+            QVector<int>& cell = cells[i * cols + col];
+            auto at = std::lower_bound(cell.begin(), cell.end(), branch.score,
+                                       [&children](int c, double score) { return children[c].score > score; });
+            cell.insert(at, children.size());
+            children.append(std::move(branch));
+            parentOf.append(leaf);
+        };
+        for (int leaf = 0; leaf < tree.leaves.size(); ++leaf) {
+            const Branch& parent = tree.leaves[leaf];
+            for (int col : qAsConst(gatedCols[i])) {
+                const MhtPlot& plot = plots[cluster.plots[col]];
+                Branch hit;
+                hit.state = parent.state;
+                predict(hit.state, plot.timeMs, m_config.processNoise);
+                const double z[3] = {plot.position.east, plot.position.north, plot.position.up};
+                double logLikelihood = 0.0;
+                if (!update(hit.state, z, r, logLikelihood)) continue;
+                hit.plots = parent.plots;
+                hit.plots.append(scanBase + cluster.plots[col]);
+                hit.score = parent.score + hitBase + logLikelihood;
+                offer(col, leaf, std::move(hit));
+            }
+            Branch miss;
+            miss.state = parent.state;
+            miss.plots = parent.plots;
+            miss.plots.append(MISS);
+            miss.score = parent.score + missScore;
+            offer(plotCols + i, leaf, std::move(miss));
+        }
+    }
+
+    // Cost is each row's best score less the cell's best, which ranks
+    // assignments the same as their summed scores
+    QVector<double> cost(rows * cols, AssignmentSolver::FORBIDDEN_COST);
+    for (int i = 0; i < rows; ++i) {
+        double top = -1.0e300;
+        for (int col = 0; col < cols; ++col) {
+            const QVector<int>& cell = cells[i * cols + col];
+            if (!cell.isEmpty()) top = qMax(top, children[cell.first()].score);
+        }
+        for (int col = 0; col < cols; ++col) {
+            const QVector<int>& cell = cells[i * cols + col];
+            if (!cell.isEmpty()) cost[i * cols + col] = top - children[cell.first()].score;
+        }
+    }
+
+    // The assignment keeps this scan's plots apart. Each ranked one is
+    // realised with the best choice of leaf per cell that keeps the open
+    // scans' plots apart too, or rejected when there is none.
+    struct Hypothesis {
+        QVector<int> children;      // Per track
+        double score = 0.0;
+    };
+    QVector<Hypothesis> hypotheses;
+    QVector<int> choice(rows);
+    QVector<double> remaining(rows + 1);
+    QVector<qint64> taken;
+    Hypothesis found;
+    int steps = 0;
+    auto search = [&](auto& self, const QVector<int>& assignment, int i, double score) -> void {
+        if (++steps > REALISE_STEPS || score + remaining[i] <= found.score) return;
+        if (i == rows) {
+            found.children = choice;
+            found.score = score;
+            return;
+        }
+        for (int c : cells[i * cols + assignment[i]]) {
+            const Branch& branch = children[c];
+            bool clash = false;
+            for (int s = 0; s + 1 < branch.plots.size() && !clash; ++s) {
+                clash = branch.plots[s] != MISS && taken.contains(branch.plots[s]);
+            }
+            if (clash) continue;
+            const int mark = taken.size();
+            for (int s = 0; s + 1 < branch.plots.size(); ++s) taken.append(branch.plots[s]);
+            choice[i] = c;
+            self(self, assignment, i + 1, score + branch.score);
+            taken.resize(mark);
+        }
+    };
+    auto realise = [&](const QVector<int>& assignment) {
+        remaining[rows] = 0.0;
+        for (int i = rows - 1; i >= 0; --i) {
+            remaining[i] = remaining[i + 1] + children[cells[i * cols + assignment[i]].first()].score;
+        }
+        found.children.clear();
+        found.score = -1.0e300;
+        steps = 0;
+        taken.clear();
+        search(search, assignment, 0, 0.0);
+        if (found.children.isEmpty()) return false;
+        hypotheses.append(found);
+        return true;
+    };
+    AssignmentSolver::solveKBest(cost, rows, cols, qMax(1, m_config.maxHypotheses), realise, deadlineNs);
+    if (hypotheses.isEmpty()) {
+        solveNearest(cluster, gated, result);
+        return;
+    }
+    std::stable_sort(hypotheses.begin(), hypotheses.end(),
+                     [](const Hypothesis& a, const Hypothesis& b) { return a.score > b.score; });
+    while (hypotheses.size() > 1 && hypotheses.last().score < hypotheses.first().score - m_config.pruneLogRatio) {
+        hypotheses.removeLast();
+    }
+    cluster.hypotheses = hypotheses.size();
+
+    for (int i = 0; i < rows; ++i) {
+        Tree& tree = *cluster.trees[i];
+        MhtDecision& decision = result.decisions[cluster.tracks[i]];
+
+        // The children some kept hypothesis uses are the new leaves, the
+        // best hypothesis's first
+        QVector<int> kept;
+        for (const Hypothesis& hypothesis : qAsConst(hypotheses)) {
+            if (!kept.contains(hypothesis.children[i])) kept.append(hypothesis.children[i]);
+        }
+        const MhtKinematics before = tree.leaves[parentOf[kept.first()]].state;
+        tree.leaves.clear();
+        const double top = children[kept.first()].score;
+        for (int c : qAsConst(kept)) {
+            Branch& branch = children[c];
+            branch.score -= top;
+            tree.leaves.append(std::move(branch));
+        }
+
+        // The filter follows the best; it is revised when that now differs
+        // from what it took in an earlier scan
+        const Branch& best = tree.leaves.first();
+        const qint64 newest = best.plots.last();
+        if (newest != MISS) {
+            decision.plot = static_cast<int>(newest - scanBase);
+            result.plotTrack[decision.plot] = cluster.tracks[i];
+        }
+        if (best.plots.mid(0, best.plots.size() - 1) != tree.applied) {
+            decision.revised = true;
+            decision.state = before;
+            cluster.revisions++;
+            tree.applied = best.plots;
+        } else {
+            tree.applied.append(newest);
+        }
+
+        // N-scan pruning: the oldest open scan is decided as the best has it
+        if (best.plots.size() > qMax(1, m_config.scanDepth)) {
+            const qint64 root = best.plots.first();
+            for (int leaf = tree.leaves.size() - 1; leaf >= 0; --leaf) {
+                if (tree.leaves[leaf].plots.first() != root) {
+                    tree.leaves.remove(leaf);
+                } else {
+                    tree.leaves[leaf].plots.removeFirst();
+                }
+            }
+            tree.applied.removeFirst();
+        }
+
+        // Nothing left in contention: the filter carries on alone
+        if (tree.leaves.size() == 1 && tree.leaves.first().plots == tree.applied) {
+            tree.leaves.clear();
+            tree.applied.clear();
+        }
+    }
+}
+
+void MhtAssociator::solveNearest(Cluster& cluster, const QVector<QVector<QPair<int, double>>>& gated,
+                                 MhtScanResult& result) const {
+    const int rows = cluster.plots.size();
+    const int cols = cluster.tracks.size();
+    QHash<int, int> colOfTrack;
+    for (int col = 0; col < cols; ++col) colOfTrack.insert(cluster.tracks[col], col);
+    QVector<double> cost(rows * cols, AssignmentSolver::FORBIDDEN_COST);
+    for (int row = 0; row < rows; ++row) {
+        for (const QPair<int, double>& edge : gated[cluster.plots[row]]) {
+            cost[row * cols + colOfTrack.value(edge.first)] = edge.second;
+        }
+    }
+    const QVector<int> assignment = AssignmentSolver::solve(cost, rows, cols);
+    for (int row = 0; row < rows; ++row) {
+        if (assignment[row] < 0) continue;
+        const int track = cluster.tracks[assignment[row]];
+        result.plotTrack[cluster.plots[row]] = track;
+        result.decisions[track].plot = cluster.plots[row];
+    }
+
+    // Hypotheses are dropped, not left to go stale
+    for (Tree* tree : qAsConst(cluster.trees)) {
+        tree->leaves.clear();
+        tree->applied.clear();
+    }
+    cluster.fallback = true;
+    cluster.hypotheses = 1;
+}
+
+} // namespace CounterUAS
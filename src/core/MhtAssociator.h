@@ -0,0 +1,160 @@
+#ifndef MHTASSOCIATOR_H
+#define MHTASSOCIATOR_H
+
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <QtGlobal>
+#include "core/TrackHandle.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief How TrackManager::processDetectionBatch associates a scan
+ */
+enum class AssociationMode : quint8 {
+    Gnn = 0,    // Global nearest neighbour, decided scan by scan
+    Mht         // Track-oriented multiple hypotheses; see MhtAssociator
+};
+
+/**
+ * @brief Limits and sensor model of MhtAssociator
+ */
+struct MhtConfig {
+    int scanDepth = 3;                  // N of N-scan pruning: scans a decision stays open
+    int maxHypotheses = 8;              // Global hypotheses kept per cluster, the k of k-best
+    int budgetUs = 2000;                // Per scan; clusters started later fall back to GNN. 0: none
+    double detectionProbability = 0.9;
+    double falseAlarmDensity = 1.0e-7;  // Clutter plots per cubic metre
+    double processNoise = 1.0;          // White acceleration PSD of the hypothesis filters
+    double measurementSigmaM = 10.0;
+    double pruneLogRatio = 6.9;         // Hypotheses 1000 times less likely than the best are dropped
+};
+
+/**
+ * @brief Constant-velocity estimate of one hypothesis, per ENU axis
+ *
+ * Axes are filtered independently; each keeps its 2x2 position/velocity
+ * covariance.
+ */
+struct MhtKinematics {
+    double position[3] = {0.0, 0.0, 0.0};
+    double velocity[3] = {0.0, 0.0, 0.0};
+    double positionVariance[3] = {0.0, 0.0, 0.0};
+    double crossCovariance[3] = {0.0, 0.0, 0.0};
+    double velocityVariance[3] = {0.0, 0.0, 0.0};
+    qint64 timeMs = 0;
+};
+
+/**
+ * @brief A track as its filter has it, for MhtAssociator::associate
+ */
+struct MhtTrack {
+    TrackHandle handle = INVALID_TRACK_HANDLE;
+    MhtKinematics kinematics;
+};
+
+struct MhtPlot {
+    EnuVector position;
+    qint64 timeMs = 0;
+};
+
+/**
+ * @brief What a track's filter should do with the scan
+ */
+struct MhtDecision {
+    int plot = -1;              // Plot to update with; -1 for none
+    bool revised = false;       // An earlier scan's plot changed: take state, then plot
+    MhtKinematics state;        // When revised: the branch as of the previous scan
+};
+
+struct MhtScanResult {
+    QVector<int> plotTrack;             // Per plot: track index, or -1 to initiate
+    QVector<MhtDecision> decisions;     // Per track
+    int clusters = 0;
+    int hypotheses = 0;                 // Global hypotheses kept, over all clusters
+    int revisions = 0;
+    int fallbacks = 0;                  // Clusters decided by GNN on the budget
+};
+
+/**
+ * @brief Track-oriented multiple hypothesis association
+ *
+ * Each ambiguous track keeps a tree of hypotheses (leaves) over its last
+ * scanDepth scans: the plot, or the miss, each branch took per scan, with
+ * its own constant-velocity estimate and log likelihood ratio score. A
+ * scan is split into clusters of tracks and plots linked by the coarse
+ * gate; every leaf of a cluster's trees grows a child per plot in its fine
+ * gate plus a miss child, and Murty's k-best assignment over the children
+ * picks the maxHypotheses best global hypotheses that use each plot once,
+ * across the open scans as well as this one. Leaves no kept hypothesis
+ * uses are dropped. Once a tree is scanDepth + 1 scans deep, its oldest
+ * scan is decided as the best hypothesis has it (N-scan pruning).
+ *
+ * Each scan the track's filter follows the best hypothesis. When that
+ * moves to a branch that took other plots in earlier scans, the decision
+ * is revised and carries the branch's estimate before this scan, for the
+ * filter to restore ahead of its update. A tree that is down to the one
+ * branch its filter followed is let go and reseeded from the filter when
+ * the track is contended again, so only contended tracks carry trees.
+ *
+ * Clusters are solved in parallel on the TaskScheduler. A cluster that
+ * starts once the scan's budgetUs is spent, or is too large for k-best, is
+ * solved by global nearest neighbour on the coarse costs instead and its
+ * trees are collapsed onto the filter. Not thread-safe; TrackManager
+ * calls it under its lock.
+ */
+class MhtAssociator {
+public:
+    MhtAssociator() = default;
+
+    void setConfig(const MhtConfig& config) { m_config = config; }
+    const MhtConfig& config() const { return m_config; }
+
+    // gated[plot] lists (track index, coarse cost) pairs, as for
+    // AssignmentSolver::solveClustered; tracks are the columns
+    void associate(const QVector<MhtPlot>& plots, const QVector<MhtTrack>& tracks,
+                   const QVector<QVector<QPair<int, double>>>& gated, MhtScanResult& result);
+
+    // Drops a track's hypotheses: it was released, or its filter was moved
+    // by a plot outside a scan
+    void forget(TrackHandle handle) { m_trees.remove(handle); }
+    void clear() { m_trees.clear(); }
+
+    int openTracks() const { return m_trees.size(); }
+    int branchCount() const;
+
+private:
+    struct Branch {
+        QVector<qint64> plots;      // Plot ids of the open scans, oldest first; -1 a miss
+        MhtKinematics state;
+        double score = 0.0;         // Log likelihood ratio, relative to the tree's best
+    };
+    struct Tree {
+        QVector<Branch> leaves;
+        QVector<qint64> applied;    // Plot ids the filter took over those scans
+    };
+    struct Cluster {
+        QVector<int> tracks;
+        QVector<int> plots;
+        QVector<Tree*> trees;       // Of tracks, looked up before the parallel phase
+        int hypotheses = 0;
+        int revisions = 0;
+        bool fallback = false;
+    };
+
+    void solveCluster(Cluster& cluster, const QVector<MhtPlot>& plots, const QVector<MhtTrack>& tracks,
+                      const QVector<QVector<QPair<int, double>>>& gated, qint64 scanBase,
+                      qint64 deadlineNs, MhtScanResult& result) const;
+    void solveNearest(Cluster& cluster, const QVector<QVector<QPair<int, double>>>& gated,
+                      MhtScanResult& result) const;
+
+    MhtConfig m_config;
+    QHash<TrackHandle, Tree> m_trees;
+    qint64 m_nextPlotId = 0;         // Plot ids are unique for the associator's lifetime
+};
+
+} // namespace CounterUAS
+
+#endif // MHTASSOCIATOR_H
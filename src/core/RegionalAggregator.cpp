@@ -0,0 +1,286 @@
+#include "core/RegionalAggregator.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/TimeUtils.h"
+#include <QDateTime>
+#include <algorithm>
+
+namespace CounterUAS {
+
+namespace {
+
+// A coasting site track is the site's prediction, not a sighting
+bool isReportable(const TrackSnapshot& track) {
+    return track.state == TrackState::Initiated || track.state == TrackState::Active;
+}
+
+SensorDetection toPlot(const QString& sensorId, const TrackSnapshot& track, qint64 timestampMs) {
+    SensorDetection plot;
+    plot.sensorId = sensorId;
+    plot.position = track.position;
+    plot.velocity = track.velocity;
+    plot.confidence = track.trackQuality;
+    plot.timestamp = timestampMs;
+    plot.sourceType = DetectionSource::Combined;
+    CombinedTrackInfo& info = plot.info.combined;
+    setFixedString(info.trackId, track.trackId);
+    info.classification = static_cast<qint8>(track.classification);
+    info.threatLevel = static_cast<quint8>(qBound(0, track.threatLevel, 255));
+    info.classificationConfidence = static_cast<float>(track.classificationConfidence);
+    plot.ingestMonoNs = TimeUtils::monotonicNs();
+    return plot;
+}
+
+QString sensorIdOf(const RegionalAggregator::SiteStatus& status) {
+    return QStringLiteral("site:") + (status.nodeId.isEmpty() ? status.connectionId : status.nodeId);
+}
+
+} // namespace
+
+RegionalAggregator::RegionalAggregator(QObject* parent)
+    : QObject(parent)
+    , m_network(new NetworkManager(this))
+    , m_sync(new TrackPictureSync(m_network, this))
+    , m_sharding(new ShardedTrackManager(this))
+    , m_regional(new TrackManager(this))
+    , m_regionalTimer(new QTimer(this))
+    , m_regionalTracksMetric(MetricsRegistry::instance().gauge(
+          "cuas_region_tracks", "Tracks in the regional picture published down"))
+{
+    m_regional->setObjectName("RegionalPicture");
+    m_regional->setMirrorMode(true);
+
+    connect(m_sync, &TrackPictureSync::remoteTrackUpdated,
+            this, &RegionalAggregator::onRemoteTrackUpdated);
+    connect(m_sync, &TrackPictureSync::remoteTrackDropped,
+            this, &RegionalAggregator::onRemoteTrackDropped);
+    connect(m_sync, &TrackPictureSync::remotePictureApplied,
+            this, &RegionalAggregator::onRemotePictureApplied);
+    connect(m_regionalTimer, &QTimer::timeout, this, &RegionalAggregator::publishRegional);
+}
+
+RegionalAggregator::~RegionalAggregator() {
+    stop();
+}
+
+bool RegionalAggregator::start(const RegionalAggregatorConfig& config) {
+    stop();
+    m_config = config;
+    m_error.clear();
+
+    m_network->setNodeId(m_config.nodeId);
+    if (m_config.multicast && !m_network->startMulticastPublisher(m_config.multicastGroup)) {
+        m_error = "Cannot publish to multicast group " + m_config.multicastGroup.group.toString();
+        return false;
+    }
+
+    m_sharding->setConfig(m_config.sharding);
+    m_startedMs = QDateTime::currentMSecsSinceEpoch();
+    for (const ConnectionConfig& site : m_config.sites) {
+        const QString connectionId = m_network->addConnection(site);
+        addSite(connectionId);
+        m_network->connectTo(connectionId);
+    }
+
+    // The regional picture goes down the same links the sites came up
+    m_sync->setNodeId(m_config.nodeId);
+    m_sync->setKeyframeInterval(m_config.keyframeIntervalMs);
+    m_sync->setBandwidthLimit(m_config.syncBandwidthLimit);
+    m_sync->setTrackManager(m_regional);
+
+    m_sharding->start();
+    m_regional->start();
+    m_regionalTimer->start(qMax(100, m_config.regionalIntervalMs));
+    m_running = true;
+
+    Logger::instance().info("RegionalAggregator", QString("Region %1 running: %2 sites, %3 shards, %4 m cells")
+                            .arg(m_config.nodeId).arg(m_config.sites.size())
+                            .arg(m_sharding->shardCount()).arg(m_config.sharding.tileSizeM));
+    return true;
+}
+
+void RegionalAggregator::stop() {
+    if (!m_running) return;
+    m_running = false;
+
+    m_regionalTimer->stop();
+    m_sync->setTrackManager(nullptr);
+    m_network->disconnectAll();
+    for (const QString& id : m_network->connectionIds()) {
+        m_network->removeConnection(id);
+    }
+    m_network->stopMulticastPublisher();
+    m_sharding->stop();
+    m_regional->stop();
+    m_sites.clear();
+}
+
+RegionalAggregator::Site& RegionalAggregator::addSite(const QString& connectionId) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    const MetricLabels labels{{"site", connectionId}};
+    Site& site = m_sites[connectionId];
+    site.status = SiteStatus();
+    site.status.connectionId = connectionId;
+    site.reportedMs.clear();
+    site.pending.clear();
+    site.lagMetric = registry.gauge("cuas_region_site_lag_ms",
+                                    "Age of a site's newest picture frame on arrival", labels);
+    site.tracksMetric = registry.gauge("cuas_region_site_tracks", "Tracks a site reports", labels);
+    return site;
+}
+
+void RegionalAggregator::onRemoteTrackUpdated(const QString& connectionId, const TrackSnapshot& track) {
+    auto it = m_sites.find(connectionId);
+    if (it == m_sites.end()) return;     // Not a site link
+    it->pending.append(track);
+}
+
+void RegionalAggregator::onRemoteTrackDropped(const QString& connectionId, const QString& trackId) {
+    auto it = m_sites.find(connectionId);
+    if (it == m_sites.end()) return;
+    // The regional track coasts and drops on its own once no site reports it
+    it->reportedMs.remove(trackId);
+    it->status.tracks = it->reportedMs.size();
+}
+
+void RegionalAggregator::onRemotePictureApplied(const QString& connectionId, qint64 timestampMs) {
+    auto it = m_sites.find(connectionId);
+    if (it == m_sites.end()) return;
+    Site& site = *it;
+    SiteStatus& status = site.status;
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+
+    status.nodeId = m_sync->remoteNodeId(connectionId);
+    status.synced = true;
+    status.frames++;
+    status.lastFrameMs = timestampMs;
+    status.lastReceiveMs = nowMs;
+    status.lagMs = nowMs - timestampMs;
+    if (status.stale) {
+        status.stale = false;
+        Logger::instance().info("RegionalAggregator", QString("Site %1 reporting again").arg(sensorIdOf(status)));
+    }
+
+    QVector<SensorDetection> plots;
+    plots.reserve(site.pending.size());
+    const QString sensorId = sensorIdOf(status);
+    for (const TrackSnapshot& track : qAsConst(site.pending)) {
+        site.reportedMs.insert(track.trackId, nowMs);
+        if (isReportable(track)) plots.append(toPlot(sensorId, track, timestampMs));
+    }
+    site.pending.clear();
+    status.tracks = site.reportedMs.size();
+    status.plots += plots.size();
+    site.lagMetric->set(status.lagMs);
+    site.tracksMetric->set(status.tracks);
+    submit(plots);
+}
+
+void RegionalAggregator::submit(const QVector<SensorDetection>& plots) {
+    if (plots.isEmpty()) return;
+    m_plotsSubmitted += plots.size();
+    if (!m_sharding->submitBatch(plots)) ++m_batchesDropped;
+}
+
+void RegionalAggregator::refreshSites(qint64 nowMs) {
+    const qint64 unchangedSinceMs = nowMs - m_config.regionalIntervalMs;
+    QVector<SensorDetection> plots;
+
+    for (auto it = m_sites.begin(); it != m_sites.end(); ++it) {
+        Site& site = *it;
+        SiteStatus& status = site.status;
+        status.synced = m_sync->isSynced(it.key());
+
+        const qint64 silentMs = nowMs - qMax(status.lastReceiveMs, m_startedMs);
+        if (silentMs > m_config.siteStaleMs && !status.stale) {
+            status.stale = true;
+            Logger::instance().warning("RegionalAggregator",
+                QString("Site %1 silent for %2 ms").arg(sensorIdOf(status)).arg(silentMs));
+            emit siteStale(it.key(), silentMs);
+        }
+        if (!status.synced || status.stale) continue;
+
+        // The site's clock now, from its newest frame
+        const qint64 siteNowMs = status.lastFrameMs + (nowMs - status.lastReceiveMs);
+        const QString sensorId = sensorIdOf(status);
+        plots.clear();
+        for (const TrackSnapshot& track : m_sync->remoteTracks(it.key())) {
+            if (site.reportedMs.value(track.trackId) > unchangedSinceMs || !isReportable(track)) continue;
+            site.reportedMs.insert(track.trackId, nowMs);
+            plots.append(toPlot(sensorId, track, siteNowMs));
+        }
+        status.plots += plots.size();
+        m_plotsRefreshed += plots.size();
+        submit(plots);
+    }
+}
+
+void RegionalAggregator::publishRegional() {
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    refreshSites(nowMs);
+
+    const TrackPicturePtr fused = m_sharding->snapshot();
+    QVector<const TrackSnapshot*> kept;
+    kept.reserve(fused->tracks.size());
+    for (const TrackSnapshot& track : fused->tracks) {
+        if (track.state != TrackState::Dropped && track.trackQuality >= m_config.minRegionalQuality) {
+            kept.append(&track);
+        }
+    }
+    const int limit = qMax(0, m_config.maxRegionalTracks);
+    if (kept.size() > limit) {
+        std::nth_element(kept.begin(), kept.begin() + limit, kept.end(),
+                         [](const TrackSnapshot* a, const TrackSnapshot* b) {
+            if (a->threatLevel != b->threatLevel) return a->threatLevel > b->threatLevel;
+            return a->trackQuality > b->trackQuality;
+        });
+        kept.resize(limit);
+    }
+
+    auto picture = std::make_shared<TrackPicture>();
+    picture->sequence = fused->sequence;
+    picture->timestampMs = fused->timestampMs > 0 ? fused->timestampMs : nowMs;
+    picture->newestIngestNs = fused->newestIngestNs;
+    picture->newestReceiveLagUs = fused->newestReceiveLagUs;
+    picture->tracks.reserve(kept.size());
+    picture->indexById.reserve(kept.size());
+    picture->indexByHandle.reserve(kept.size());
+    for (const TrackSnapshot* track : qAsConst(kept)) {
+        picture->indexById.insert(track->trackId, picture->tracks.size());
+        picture->indexByHandle.insert(track->handle, picture->tracks.size());
+        picture->tracks.append(*track);
+    }
+
+    m_regionalTracksMetric->set(picture->tracks.size());
+    m_regional->applyMirrorPicture(TrackPicturePtr(std::move(picture)));
+}
+
+QVector<RegionalAggregator::SiteStatus> RegionalAggregator::sites() const {
+    QVector<SiteStatus> sites;
+    sites.reserve(m_sites.size());
+    for (const Site& site : m_sites) {
+        sites.append(site.status);
+    }
+    std::sort(sites.begin(), sites.end(), [](const SiteStatus& a, const SiteStatus& b) {
+        return a.connectionId < b.connectionId;
+    });
+    return sites;
+}
+
+RegionalAggregator::Statistics RegionalAggregator::statistics() const {
+    Statistics stats;
+    stats.regionalTracks = m_regional->trackCount();
+    stats.fusedTracks = m_sharding->trackCount();
+    stats.plotsSubmitted = m_plotsSubmitted;
+    stats.plotsRefreshed = m_plotsRefreshed;
+    stats.batchesDropped = m_batchesDropped;
+    for (const Site& site : m_sites) {
+        stats.maxSiteLagMs = qMax(stats.maxSiteLagMs, site.status.lagMs);
+    }
+    stats.sharding = m_sharding->statistics();
+    stats.sync = m_sync->stats();
+    return stats;
+}
+
+} // namespace CounterUAS
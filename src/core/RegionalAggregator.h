@@ -0,0 +1,142 @@
+#ifndef REGIONALAGGREGATOR_H
+#define REGIONALAGGREGATOR_H
+
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include "core/ShardedTrackManager.h"
+#include "network/MulticastPublisher.h"
+#include "network/NetworkManager.h"
+#include "network/TrackPictureSync.h"
+
+namespace CounterUAS {
+
+class MetricGauge;
+
+/**
+ * @brief Configuration of a regional aggregator
+ */
+struct RegionalAggregatorConfig {
+    QString nodeId = QStringLiteral("REGION");  // The regional picture's node id
+    QVector<ConnectionConfig> sites;            // One link per site core; UDP, as sites uplink
+    ShardedTrackManagerConfig sharding;         // tileSizeM is the region cell
+    bool multicast = false;                     // Regional consoles join the group
+    MulticastConfig multicastGroup;
+    int regionalIntervalMs = 1000;              // Period of the picture published down
+    double minRegionalQuality = 0.3;            // Tracks below it stay out of that picture
+    int maxRegionalTracks = 500;                // Beyond it, the least threatening stay out
+    int keyframeIntervalMs = 5000;
+    int syncBandwidthLimit = 0;                 // Bytes per second down, 0 for no limit
+    int siteStaleMs = 5000;                     // A site silent this long is reported stale
+};
+
+/**
+ * @brief Fuses many sites' pictures into one regional picture
+ *
+ * The aggregator tier of a federation: each site core uplinks its picture
+ * through TrackPictureSync as it would to any peer, and the aggregator
+ * keeps a mirror per site. Every frame a site's mirror applies becomes one
+ * batch of Combined plots, one per track updated, stamped with the frame's
+ * time and submitted to a ShardedTrackManager whose tiles are the region
+ * cells. Association and filtering run on the shards' fusion threads, so
+ * ingest scales with the cores; a target two sites both see is one
+ * regional track, and the sharding's duplicate sweep joins the copies a
+ * cell edge splits. Site tracks the deltas leave unchanged are reported
+ * again every regional interval, so a hovering target does not coast.
+ *
+ * Every regional interval the merged picture, decimated to the tracks of
+ * at least minRegionalQuality and the maxRegionalTracks most threatening,
+ * is mirrored into a TrackManager whose picture is synced back down every
+ * site link and, optionally, to a multicast group for regional consoles.
+ *
+ * Each site's lag, the age of its newest frame on arrival by the sender's
+ * stamp, is kept per site with its track count and gaps, exported as the
+ * cuas_region_site_* gauges labelled by site, and logged for stale sites.
+ * Lag measured across hosts includes their clock offset.
+ */
+class RegionalAggregator : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RegionalAggregator(QObject* parent = nullptr);
+    ~RegionalAggregator() override;
+
+    bool start(const RegionalAggregatorConfig& config);
+    void stop();
+    bool isRunning() const { return m_running; }
+    QString errorString() const { return m_error; }
+
+    ShardedTrackManager* sharding() const { return m_sharding; }
+    TrackManager* regionalPicture() const { return m_regional; }
+    NetworkManager* network() const { return m_network; }
+    TrackPictureSync* pictureSync() const { return m_sync; }
+
+    struct SiteStatus {
+        QString connectionId;
+        QString nodeId;             // As the site publishes; empty until its first frame
+        bool synced = false;
+        int tracks = 0;
+        qint64 frames = 0;
+        qint64 plots = 0;
+        qint64 lastFrameMs = 0;     // Sender's stamp of the newest frame
+        qint64 lastReceiveMs = 0;
+        qint64 lagMs = -1;          // Of that frame, -1 before one
+        bool stale = false;         // Silent for siteStaleMs
+    };
+    QVector<SiteStatus> sites() const;
+
+    struct Statistics {
+        int regionalTracks = 0;
+        int fusedTracks = 0;        // In the sharded picture, undecimated
+        qint64 plotsSubmitted = 0;
+        qint64 plotsRefreshed = 0;  // Unchanged site tracks reported again
+        qint64 batchesDropped = 0;  // A shard's fusion queue was full
+        qint64 maxSiteLagMs = -1;
+        ShardedTrackManager::Statistics sharding;
+        TrackPictureSync::Stats sync;
+    };
+    Statistics statistics() const;
+
+signals:
+    void siteStale(const QString& connectionId, qint64 silentMs);
+
+private slots:
+    void onRemoteTrackUpdated(const QString& connectionId, const TrackSnapshot& track);
+    void onRemoteTrackDropped(const QString& connectionId, const QString& trackId);
+    void onRemotePictureApplied(const QString& connectionId, qint64 timestampMs);
+    void publishRegional();
+
+private:
+    struct Site {
+        SiteStatus status;
+        QVector<TrackSnapshot> pending;         // Updated by the frame being applied
+        QHash<QString, qint64> reportedMs;      // Site track -> when last submitted or updated
+        MetricGauge* lagMetric = nullptr;
+        MetricGauge* tracksMetric = nullptr;
+    };
+
+    Site& addSite(const QString& connectionId);
+    void submit(const QVector<SensorDetection>& plots);
+    void refreshSites(qint64 nowMs);
+
+    RegionalAggregatorConfig m_config;
+    NetworkManager* m_network;
+    TrackPictureSync* m_sync;
+    ShardedTrackManager* m_sharding;
+    TrackManager* m_regional;
+    QTimer* m_regionalTimer;
+    bool m_running = false;
+    QString m_error;
+
+    QHash<QString, Site> m_sites;            // By connection id
+    qint64 m_startedMs = 0;
+    qint64 m_plotsSubmitted = 0;
+    qint64 m_plotsRefreshed = 0;
+    qint64 m_batchesDropped = 0;
+    MetricGauge* m_regionalTracksMetric;
+};
+
+} // namespace CounterUAS
+
+#endif // REGIONALAGGREGATOR_H
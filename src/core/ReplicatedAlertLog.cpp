@@ -0,0 +1,213 @@
+#include "core/ReplicatedAlertLog.h"
+
+namespace CounterUAS {
+
+ReplicatedAlertLog::ReplicatedAlertLog(const QString& origin, int capacity, int logOps)
+    : m_origin(origin)
+    , m_capacity(qMax(1, capacity))
+    , m_logOps(qMax(1, logOps))
+{
+}
+
+void ReplicatedAlertLog::setCapacity(int capacity) {
+    m_capacity = qMax(1, capacity);
+    evictBeyondCapacity();
+}
+
+QString ReplicatedAlertLog::keyFor(const ThreatAlert& alert) {
+    const QString subject = alert.groupId != 0 ? ThreatAlertStore::groupSubject(alert.groupId) : alert.trackId;
+    return subject + QLatin1Char('\n') + alert.ruleId;
+}
+
+AlertOp ReplicatedAlertLog::raise(const ThreatAlert& alert, QVector<AlertChange>* changes) {
+    if (m_alerts.contains(alert.alertId)) return AlertOp();
+
+    AlertOp op;
+    op.kind = AlertOp::Kind::Raise;
+    op.origin = m_origin;
+    op.sequence = m_origins.value(m_origin).applied + 1;
+    op.alert = alert;
+    op.alert.acknowledged = false;
+    op.alert.acknowledgedBy.clear();
+    op.alert.acknowledgedTime = QDateTime();
+    append(op);
+    mergeOp(op, changes, false);
+    return op;
+}
+
+AlertOp ReplicatedAlertLog::acknowledge(const QString& alertId, const QString& operatorId,
+                                        const QDateTime& time, QVector<AlertChange>* changes) {
+    auto it = m_alerts.constFind(alertId);
+    if (it == m_alerts.constEnd() || it->alert.acknowledged) return AlertOp();
+
+    AlertOp op;
+    op.kind = AlertOp::Kind::Acknowledge;
+    op.origin = m_origin;
+    op.sequence = m_origins.value(m_origin).applied + 1;
+    op.alert.alertId = alertId;
+    op.alert.trackId = it->alert.trackId;
+    op.alert.groupId = it->alert.groupId;
+    op.alert.ruleId = it->alert.ruleId;
+    op.alert.threatLevel = it->alert.threatLevel;
+    op.alert.acknowledged = true;
+    op.alert.acknowledgedBy = operatorId;
+    op.alert.acknowledgedTime = time;
+    append(op);
+    mergeOp(op, changes, false);
+    return op;
+}
+
+ReplicatedAlertLog::ApplyResult ReplicatedAlertLog::apply(const AlertOp& op, QVector<AlertChange>* changes) {
+    if (op.isNull() || op.origin.isEmpty() || op.origin == m_origin) return ApplyResult::Duplicate;
+
+    const quint64 applied = m_origins[op.origin].applied;
+    if (op.sequence <= applied) return ApplyResult::Duplicate;
+    if (op.sequence != applied + 1) return ApplyResult::Gap;
+
+    append(op);
+    mergeOp(op, changes, true);
+    return ApplyResult::Applied;
+}
+
+AlertVersionVector ReplicatedAlertLog::versions() const {
+    AlertVersionVector versions;
+    versions.reserve(m_origins.size());
+    for (auto it = m_origins.constBegin(); it != m_origins.constEnd(); ++it) {
+        if (it->applied > 0) versions.insert(it.key(), it->applied);
+    }
+    return versions;
+}
+
+bool ReplicatedAlertLog::opsSince(const AlertVersionVector& since, QVector<AlertOp>& ops) const {
+    bool complete = true;
+    for (auto it = m_origins.constBegin(); it != m_origins.constEnd(); ++it) {
+        const quint64 have = since.value(it.key());
+        if (have >= it->applied) continue;
+
+        const quint64 first = it->applied - static_cast<quint64>(it->ops.size()) + 1;
+        if (have + 1 < first) {
+            complete = false;
+            continue;
+        }
+        for (const AlertOp& op : it->ops) {
+            if (op.sequence > have) ops.append(op);
+        }
+    }
+    return complete;
+}
+
+QVector<AlertOp> ReplicatedAlertLog::state() const {
+    QVector<AlertOp> state;
+    state.reserve(m_alerts.size() + m_ackArrival.size());
+    for (const QString& alertId : m_arrival) {
+        state.append(m_alerts.value(alertId).raise);
+    }
+    for (const QVector<AlertOp>& records : m_acks) {
+        state += records;
+    }
+    return state;
+}
+
+void ReplicatedAlertLog::merge(const QVector<AlertOp>& state, const AlertVersionVector& versions,
+                               QVector<AlertChange>* changes) {
+    for (const AlertOp& op : state) {
+        if (!op.isNull()) mergeOp(op, changes, true);
+    }
+
+    // The ops behind these versions are not held here, only their effect
+    for (auto it = versions.constBegin(); it != versions.constEnd(); ++it) {
+        OriginLog& log = m_origins[it.key()];
+        if (it.value() <= log.applied) continue;
+        log.applied = it.value();
+        log.ops.clear();
+    }
+}
+
+const ThreatAlert* ReplicatedAlertLog::find(const QString& alertId) const {
+    auto it = m_alerts.constFind(alertId);
+    return it != m_alerts.constEnd() ? &it->alert : nullptr;
+}
+
+void ReplicatedAlertLog::append(const AlertOp& op) {
+    OriginLog& log = m_origins[op.origin];
+    log.applied = op.sequence;
+    log.ops.enqueue(op);
+    while (log.ops.size() > m_logOps) {
+        log.ops.dequeue();
+    }
+}
+
+void ReplicatedAlertLog::mergeOp(const AlertOp& op, QVector<AlertChange>* changes, bool reportRaise) {
+    if (op.kind == AlertOp::Kind::Raise) {
+        if (m_alerts.contains(op.alert.alertId)) return;
+
+        Entry entry;
+        entry.raise = op;
+        entry.alert = op.alert;
+        const bool acknowledged = deriveAcknowledgement(entry);
+        m_alerts.insert(op.alert.alertId, entry);
+        m_arrival.enqueue(op.alert.alertId);
+        if (changes && reportRaise) {
+            changes->append({AlertChange::Kind::Raised, entry.alert});
+        } else if (changes && acknowledged) {
+            changes->append({AlertChange::Kind::Acknowledged, entry.alert});
+        }
+        evictBeyondCapacity();
+        return;
+    }
+
+    const QString key = keyFor(op.alert);
+    QVector<AlertOp>& records = m_acks[key];
+    for (const AlertOp& record : records) {
+        if (record.origin == op.origin && record.sequence == op.sequence) return;
+    }
+    records.append(op);
+    m_ackArrival.enqueue(key);
+
+    for (Entry& entry : m_alerts) {
+        if (keyFor(entry.alert) != key) continue;
+        if (deriveAcknowledgement(entry) && changes) {
+            changes->append({AlertChange::Kind::Acknowledged, entry.alert});
+        }
+    }
+
+    while (m_ackArrival.size() > 2 * m_capacity) {
+        auto oldest = m_acks.find(m_ackArrival.dequeue());
+        if (oldest == m_acks.end()) continue;
+        oldest->removeFirst();
+        if (oldest->isEmpty()) m_acks.erase(oldest);
+    }
+}
+
+bool ReplicatedAlertLog::deriveAcknowledgement(Entry& entry) const {
+    auto records = m_acks.constFind(keyFor(entry.alert));
+    if (records == m_acks.constEnd()) return false;
+
+    // The earliest covering record wins, whatever order they came in
+    const AlertOp* earliest = nullptr;
+    for (const AlertOp& record : *records) {
+        const QDateTime& time = record.alert.acknowledgedTime;
+        if (record.alert.alertId != entry.alert.alertId && time < entry.alert.timestamp) continue;
+        if (!earliest || time < earliest->alert.acknowledgedTime ||
+            (time == earliest->alert.acknowledgedTime &&
+             (record.origin < earliest->origin ||
+              (record.origin == earliest->origin && record.sequence < earliest->sequence)))) {
+            earliest = &record;
+        }
+    }
+    if (!earliest) return false;
+
+    const bool newly = !entry.alert.acknowledged;
+    entry.alert.acknowledged = true;
+    entry.alert.acknowledgedBy = earliest->alert.acknowledgedBy;
+    entry.alert.acknowledgedTime = earliest->alert.acknowledgedTime;
+    return newly;
+}
+
+void ReplicatedAlertLog::evictBeyondCapacity() {
+    while (m_alerts.size() > m_capacity && !m_arrival.isEmpty()) {
+        m_alerts.remove(m_arrival.dequeue());
+    }
+}
+
+} // namespace CounterUAS
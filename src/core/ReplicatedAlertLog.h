@@ -0,0 +1,135 @@
+#ifndef REPLICATEDALERTLOG_H
+#define REPLICATEDALERTLOG_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QQueue>
+#include <QString>
+#include <QVector>
+#include "core/ThreatAlertStore.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief One change to the replicated alert state, as its origin made it
+ */
+struct AlertOp {
+    enum class Kind : quint8 { Raise = 1, Acknowledge = 2 };
+
+    Kind kind = Kind::Raise;
+    QString origin;             // The node's incarnation that made it
+    quint64 sequence = 0;       // Per origin, from 1 without gaps; 0 for no op
+    // Raise: the whole alert, unacknowledged. Acknowledge: alertId, the
+    // subject and rule (trackId, groupId, ruleId), acknowledgedBy and
+    // acknowledgedTime.
+    ThreatAlert alert;
+
+    bool isNull() const { return sequence == 0; }
+};
+
+/**
+ * @brief An alert the log's merge raised or acknowledged, as it now stands
+ */
+struct AlertChange {
+    enum class Kind : quint8 { Raised, Acknowledged };
+
+    Kind kind = Kind::Raised;
+    ThreatAlert alert;
+};
+
+// Highest sequence applied, per origin
+using AlertVersionVector = QHash<QString, quint64>;
+
+/**
+ * @brief Alerts and acknowledgements as state that merges in any order
+ *
+ * Every change is an AlertOp keyed by (origin, sequence). Each origin's ops
+ * are applied in sequence, so a version vector says exactly what a node
+ * has, and two nodes exchange only the ops the other lacks.
+ *
+ * The state is two grow-only sets: alerts by id, and acknowledgement
+ * records by (origin, sequence). An acknowledgement of an alert at time T
+ * covers every alert for the same subject and rule raised by T, so when
+ * two consoles raise the same threat and one operator acknowledges it,
+ * both copies clear everywhere. An alert's derived acknowledgement is the
+ * earliest record covering it, by time and then origin, which does not
+ * depend on the order records arrived in. Nodes that have applied the same
+ * ops hold the same state.
+ *
+ * Alerts beyond the capacity are forgotten oldest first, and each origin
+ * keeps its last logOps ops for peers catching up; a peer further behind
+ * than that merges the whole state instead. Not thread-safe.
+ */
+class ReplicatedAlertLog {
+public:
+    enum class ApplyResult : quint8 {
+        Applied,
+        Duplicate,      // Already applied, or this node's own op
+        Gap             // Ops before it are missing; nothing applied
+    };
+
+    explicit ReplicatedAlertLog(const QString& origin = QString(), int capacity = 500, int logOps = 1024);
+
+    // Unique per node and per run, so a restarted node's sequence starts
+    // afresh; set before the first local op
+    void setOrigin(const QString& origin) { m_origin = origin; }
+    QString origin() const { return m_origin; }
+
+    void setCapacity(int capacity);
+    int capacity() const { return m_capacity; }
+    int size() const { return m_alerts.size(); }
+
+    // This node's own changes. The op returned is null when there is nothing
+    // to replicate: an alert already known, an acknowledgement of an alert
+    // not held or already acknowledged.
+    AlertOp raise(const ThreatAlert& alert, QVector<AlertChange>* changes = nullptr);
+    AlertOp acknowledge(const QString& alertId, const QString& operatorId, const QDateTime& time,
+                        QVector<AlertChange>* changes = nullptr);
+
+    // A peer's op, in its origin's sequence
+    ApplyResult apply(const AlertOp& op, QVector<AlertChange>* changes = nullptr);
+
+    AlertVersionVector versions() const;
+    // Ops the holder of since lacks, per origin in sequence. False when some
+    // of them are no longer kept; the peer needs state() instead.
+    bool opsSince(const AlertVersionVector& since, QVector<AlertOp>& ops) const;
+
+    // The alerts held and every acknowledgement record, for merge() on a
+    // peer too far behind for opsSince()
+    QVector<AlertOp> state() const;
+    void merge(const QVector<AlertOp>& state, const AlertVersionVector& versions,
+               QVector<AlertChange>* changes = nullptr);
+
+    const ThreatAlert* find(const QString& alertId) const;
+
+private:
+    struct OriginLog {
+        quint64 applied = 0;
+        QQueue<AlertOp> ops;            // The newest, ending at applied
+    };
+
+    struct Entry {
+        AlertOp raise;                  // As raised, kept for state()
+        ThreatAlert alert;              // With the derived acknowledgement
+    };
+
+    static QString keyFor(const ThreatAlert& alert);
+    void append(const AlertOp& op);
+    void mergeOp(const AlertOp& op, QVector<AlertChange>* changes, bool reportRaise);
+    bool deriveAcknowledgement(Entry& entry) const;
+    void evictBeyondCapacity();
+
+    QString m_origin;
+    int m_capacity;
+    int m_logOps;
+
+    QHash<QString, OriginLog> m_origins;
+    QHash<QString, Entry> m_alerts;
+    QQueue<QString> m_arrival;          // Alert ids, oldest first
+    QHash<QString, QVector<AlertOp>> m_acks;   // (subject, rule) -> acknowledgements
+    QQueue<QString> m_ackArrival;       // Their keys, oldest first; twice the capacity kept
+};
+
+} // namespace CounterUAS
+
+#endif // REPLICATEDALERTLOG_H
@@ -0,0 +1,306 @@
+#include "core/SensorResourceManager.h"
+#include "core/ThreatAssessor.h"
+#include "core/TrackSnapshot.h"
+#include "sensors/CameraSystem.h"
+#include "sensors/RFDetector.h"
+#include "sensors/RadarSensor.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/MetricsRegistry.h"
+#include <QDateTime>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+SensorResourceManager::SensorResourceManager(QObject* parent)
+    : QObject(parent)
+    , m_planTimer(this, [this]() { planCycle(); })
+{
+    qRegisterMetaType<SensorTask>("SensorTask");
+    m_rateLimitedCounter = MetricsRegistry::instance().counter(
+        "cuas_sensor_commands_deferred_total", "Sensor commands held back by the sensor's rate limit");
+}
+
+SensorResourceManager::~SensorResourceManager() {
+    m_planTimer.stop();
+}
+
+void SensorResourceManager::setConfig(const SensorResourceConfig& config) {
+    m_config = config;
+    m_config.radarDwells = qMax(1, m_config.radarDwells);
+    for (auto it = m_resources.begin(); it != m_resources.end(); ++it) {
+        configure(it.value());
+    }
+    m_planTimer.setInterval(qMax(50, m_config.planIntervalMs));
+}
+
+void SensorResourceManager::addSensor(SensorInterface* sensor) {
+    if (!sensor) return;
+
+    Resource resource;
+    resource.sensor = sensor;
+    if (qobject_cast<RadarSensor*>(sensor)) {
+        resource.type = SensorTaskType::RadarDwell;
+    } else if (qobject_cast<RFDetector*>(sensor)) {
+        resource.type = SensorTaskType::RFCue;
+    } else if (auto* camera = qobject_cast<CameraSystem*>(sensor)) {
+        if (!m_config.cueCameras || !camera->config().hasPTZ) return;
+        resource.type = SensorTaskType::CameraCue;
+    } else {
+        return;
+    }
+    configure(resource);
+    resource.tokens = qMax(1.0, resource.commandsPerSec);
+    resource.commands = MetricsRegistry::instance().counter(
+        "cuas_sensor_commands_total", "Dwell and cue commands sent to sensors",
+        {{"sensor", sensor->sensorId()}, {"type", taskTypeKey(resource.type)}});
+    m_resources.insert(sensor->sensorId(), resource);
+}
+
+void SensorResourceManager::removeSensor(const QString& sensorId) {
+    m_resources.remove(sensorId);
+}
+
+QStringList SensorResourceManager::sensorIds() const {
+    return m_resources.keys();
+}
+
+void SensorResourceManager::configure(Resource& resource) const {
+    switch (resource.type) {
+    case SensorTaskType::RadarDwell:
+        resource.channels = m_config.radarDwells;
+        resource.commandsPerSec = m_config.radarCommandsPerSec;
+        break;
+    case SensorTaskType::RFCue:
+        resource.channels = 1;
+        resource.commandsPerSec = m_config.rfCommandsPerSec;
+        break;
+    case SensorTaskType::CameraCue:
+        resource.channels = 1;
+        resource.commandsPerSec = m_config.cameraCommandsPerSec;
+        break;
+    }
+    resource.tokens = qMin(resource.tokens, qMax(1.0, resource.commandsPerSec));
+}
+
+void SensorResourceManager::start() {
+    m_planTimer.setInterval(qMax(50, m_config.planIntervalMs));
+    m_planTimer.start();
+}
+
+void SensorResourceManager::stop() {
+    m_planTimer.stop();
+}
+
+void SensorResourceManager::planCycle() {
+    if (!m_threatAssessor || m_resources.isEmpty()) return;
+
+    QVector<SensorRequest> requests;
+    for (const TrackSnapshot& track : m_threatAssessor->topThreats(m_config.maxRequests)) {
+        if (track.threatLevel < m_config.minThreatLevel) continue;
+        SensorRequest request;
+        request.handle = track.handle;
+        request.trackId = track.trackId;
+        request.position = track.position;
+        request.threatLevel = track.threatLevel;
+        request.timeToImpactSec = m_threatAssessor->closestApproach(track.trackId).timeToImpactSec;
+        request.hasRF = track.hasRFDetection;
+        request.visuallyTracked = track.visuallyTracked;
+        requests.append(request);
+    }
+    plan(requests, QDateTime::currentMSecsSinceEpoch());
+}
+
+QVector<SensorTask> SensorResourceManager::plan(QVector<SensorRequest> requests, qint64 nowMs) {
+    m_stats.plans++;
+    for (SensorRequest& request : requests) {
+        request.priority = priorityOf(request);
+    }
+    std::stable_sort(requests.begin(), requests.end(), [](const SensorRequest& a, const SensorRequest& b) {
+        return a.priority > b.priority;
+    });
+
+    QVector<SensorTask> issued;
+    for (auto it = m_resources.begin(); it != m_resources.end();) {
+        Resource& resource = it.value();
+        if (!resource.sensor) {
+            it = m_resources.erase(it);
+            continue;
+        }
+
+        const double burst = qMax(1.0, resource.commandsPerSec);
+        if (resource.refilledMs > 0) {
+            const double elapsedSec = qMax<qint64>(0, nowMs - resource.refilledMs) / 1000.0;
+            resource.tokens = qMin(burst, resource.tokens + elapsedSec * resource.commandsPerSec);
+        }
+        resource.refilledMs = nowMs;
+
+        // A camera stays on its track until its tracker has had time to lock on
+        if (resource.type == SensorTaskType::CameraCue && !resource.tasks.isEmpty() &&
+            nowMs - resource.tasks.first().issuedMs < m_config.cameraHoldMs) {
+            ++it;
+            continue;
+        }
+
+        const auto heldFor = [&resource](TrackHandle handle) -> const SensorTask* {
+            for (const SensorTask& task : resource.tasks) {
+                if (task.handle == handle) return &task;
+            }
+            return nullptr;
+        };
+
+        struct Candidate {
+            const SensorRequest* request;
+            double score;
+        };
+        QVector<Candidate> candidates;
+        for (const SensorRequest& request : requests) {
+            const bool held = heldFor(request.handle) != nullptr;
+            if (!canServe(resource, request, held)) continue;
+            candidates.append({&request, request.priority + (held ? m_config.stickiness : 0.0)});
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.score > b.score;
+        });
+        if (candidates.size() > resource.channels) candidates.resize(resource.channels);
+
+        // Held tasks that lost, still what the sensor is doing until replaced
+        QVector<SensorTask> displaced;
+        for (const SensorTask& task : resource.tasks) {
+            const bool won = std::any_of(candidates.cbegin(), candidates.cend(), [&task](const Candidate& c) {
+                return c.request->handle == task.handle;
+            });
+            if (!won) displaced.append(task);
+        }
+
+        QVector<SensorTask> tasks;
+        for (const Candidate& candidate : candidates) {
+            const SensorTask* held = heldFor(candidate.request->handle);
+            if (!needsCommand(resource, held, nowMs)) {
+                tasks.append(*held);
+                continue;
+            }
+            if (resource.tokens < 1.0) {
+                m_stats.rateLimited++;
+                m_rateLimitedCounter->add();
+                if (held) {
+                    tasks.append(*held);
+                } else if (!displaced.isEmpty()) {
+                    tasks.append(displaced.takeFirst());
+                }
+                continue;
+            }
+            resource.tokens -= 1.0;
+            const SensorTask task = makeTask(resource, *candidate.request, nowMs);
+            send(resource, task);
+            tasks.append(task);
+            issued.append(task);
+        }
+        resource.tasks = tasks;
+        ++it;
+    }
+
+    m_stats.commands += issued.size();
+    for (const SensorTask& task : issued) {
+        emit taskIssued(task);
+    }
+    return issued;
+}
+
+QVector<SensorTask> SensorResourceManager::activeTasks(const QString& sensorId) const {
+    return m_resources.value(sensorId).tasks;
+}
+
+double SensorResourceManager::priorityOf(const SensorRequest& request) const {
+    double priority = request.threatLevel;
+    if (request.timeToImpactSec >= 0 && m_config.impactTimeSec > 0) {
+        priority += qMax(0.0, 1.0 - request.timeToImpactSec / m_config.impactTimeSec);
+    }
+    return priority;
+}
+
+bool SensorResourceManager::canServe(const Resource& resource, const SensorRequest& request, bool held) const {
+    if (request.handle == INVALID_TRACK_HANDLE || !request.position.isValid()) return false;
+    if (resource.type == SensorTaskType::RFCue && request.hasRF) return false;
+    // Seen on camera: by this one if it holds the track, so it keeps it
+    if (resource.type == SensorTaskType::CameraCue && request.visuallyTracked && !held) return false;
+    const double rangeM = CoordinateUtils::haversineDistance(resource.sensor->position(), request.position);
+    return rangeM <= resource.sensor->maxRange();
+}
+
+bool SensorResourceManager::needsCommand(const Resource& resource, const SensorTask* held, qint64 nowMs) const {
+    if (!held) return true;
+    switch (resource.type) {
+    case SensorTaskType::RadarDwell:
+        return nowMs - held->issuedMs >= m_config.radarRevisitMs;
+    case SensorTaskType::RFCue:
+        // Renewed a plan ahead of lapsing, so the sector never goes uncued
+        return nowMs - held->issuedMs >= m_config.rfCueMs - m_config.planIntervalMs;
+    case SensorTaskType::CameraCue:
+        return false;
+    }
+    return true;
+}
+
+SensorTask SensorResourceManager::makeTask(const Resource& resource, const SensorRequest& request,
+                                           qint64 nowMs) const {
+    const GeoPosition origin = resource.sensor->position();
+    SensorTask task;
+    task.sensorId = resource.sensor->sensorId();
+    task.type = resource.type;
+    task.handle = request.handle;
+    task.trackId = request.trackId;
+    task.target = request.position;
+    task.bearingDeg = CoordinateUtils::bearing(origin, request.position);
+    task.rangeM = CoordinateUtils::haversineDistance(origin, request.position);
+    task.elevationDeg = qRadiansToDegrees(std::atan2(request.position.altitude - origin.altitude,
+                                                     qMax(1.0, task.rangeM)));
+    task.priority = request.priority;
+    task.issuedMs = nowMs;
+    return task;
+}
+
+void SensorResourceManager::send(const Resource& resource, const SensorTask& task) {
+    switch (resource.type) {
+    case SensorTaskType::RadarDwell:
+        if (auto* radar = qobject_cast<RadarSensor*>(resource.sensor.data())) {
+            RadarDwellRequest dwell;
+            dwell.trackNumber = task.handle;
+            dwell.azimuthDeg = static_cast<float>(task.bearingDeg);
+            dwell.elevationDeg = static_cast<float>(task.elevationDeg);
+            dwell.rangeM = static_cast<float>(task.rangeM);
+            dwell.dwellMs = static_cast<quint16>(qBound(1, m_config.radarDwellMs, 65535));
+            dwell.revisitMs = static_cast<quint16>(qBound(1, m_config.radarRevisitMs, 65535));
+            dwell.priority = static_cast<quint8>(qBound(1, qRound(task.priority), 5));
+            radar->requestDwell(dwell);
+        }
+        break;
+    case SensorTaskType::RFCue:
+        if (auto* detector = qobject_cast<RFDetector*>(resource.sensor.data())) {
+            RFCue cue;
+            cue.bearingDeg = task.bearingDeg;
+            cue.halfWidthDeg = m_config.rfCueHalfWidthDeg;
+            cue.untilMs = task.issuedMs + m_config.rfCueMs;
+            detector->setCue(cue);
+        }
+        break;
+    case SensorTaskType::CameraCue:
+        if (auto* camera = qobject_cast<CameraSystem*>(resource.sensor.data())) {
+            camera->slewToPosition(task.target);
+        }
+        break;
+    }
+    resource.commands->add();
+}
+
+const char* SensorResourceManager::taskTypeKey(SensorTaskType type) {
+    switch (type) {
+    case SensorTaskType::RadarDwell: return "radarDwell";
+    case SensorTaskType::RFCue: return "rfCue";
+    case SensorTaskType::CameraCue: return "cameraCue";
+    default: return "";
+    }
+}
+
+} // namespace CounterUAS
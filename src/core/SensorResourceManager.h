@@ -0,0 +1,178 @@
+#ifndef SENSORRESOURCEMANAGER_H
+#define SENSORRESOURCEMANAGER_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+#include "core/TrackHandle.h"
+#include "utils/TimerService.h"
+
+namespace CounterUAS {
+
+class SensorInterface;
+class ThreatAssessor;
+class MetricCounter;
+
+/**
+ * @brief What a sensor can be tasked to do
+ */
+enum class SensorTaskType : quint8 {
+    RadarDwell = 0,     // Track-while-scan dwell on the target
+    RFCue,              // Cued search on the target's bearing
+    CameraCue           // Slew onto the target
+};
+
+/**
+ * @brief A track some sensor should spend time on
+ */
+struct SensorRequest {
+    TrackHandle handle = INVALID_TRACK_HANDLE;
+    QString trackId;
+    GeoPosition position;
+    int threatLevel = 1;
+    double timeToImpactSec = -1;    // -1 if not closing
+    bool hasRF = false;             // Already heard; an RF cue adds nothing
+    bool visuallyTracked = false;   // Already held by a camera
+    double priority = 0.0;          // Filled in by the manager
+};
+
+/**
+ * @brief One command the manager sent a sensor
+ */
+struct SensorTask {
+    QString sensorId;
+    SensorTaskType type = SensorTaskType::RadarDwell;
+    TrackHandle handle = INVALID_TRACK_HANDLE;
+    QString trackId;
+    GeoPosition target;
+    double bearingDeg = 0.0;        // From the sensor
+    double elevationDeg = 0.0;
+    double rangeM = 0.0;
+    double priority = 0.0;
+    qint64 issuedMs = 0;
+};
+
+/**
+ * @brief Which tracks are worth sensor time and how often sensors may be commanded
+ */
+struct SensorResourceConfig {
+    int planIntervalMs = 500;
+    int maxRequests = 8;            // Top threats considered each plan
+    int minThreatLevel = 3;
+    double impactTimeSec = 30.0;    // Time to impact that adds one to the priority
+    double stickiness = 0.5;        // Priority bonus for the track a sensor already has
+    int radarDwells = 2;            // Dwells a radar holds at once
+    int radarDwellMs = 50;
+    int radarRevisitMs = 500;
+    double radarCommandsPerSec = 4.0;
+    double rfCueHalfWidthDeg = 10.0;
+    int rfCueMs = 2000;             // Cue lifetime; renewed while the track stays on top
+    double rfCommandsPerSec = 1.0;
+    bool cueCameras = true;         // Off to leave PTZ cameras to CameraSlewController
+    int cameraHoldMs = 3000;        // A camera keeps a track at least this long
+    double cameraCommandsPerSec = 0.5;
+};
+
+/**
+ * @brief Radar dwell and RF/camera cue tasking from the threat queue
+ *
+ * Each plan takes the top maxRequests tracks from the threat assessor's
+ * queue at or above minThreatLevel and gives them a priority: the threat
+ * level, plus up to one more as time to impact falls toward zero from
+ * impactTimeSec. Every sensor then takes the highest priority requests
+ * it can serve: in range, for RF not already heard, and for cameras not
+ * already seen unless it is the camera's own track. A radar holds radarDwells and the others one, and the track a
+ * sensor has gains stickiness, so near ties do not swap it back and
+ * forth.
+ *
+ * Commands go out under a token bucket per sensor, at most its
+ * commands-per-second rate and bursts of one second's worth. A task kept
+ * from one plan to the next is only re-sent when it is due for renewal:
+ * a radar dwell after radarRevisitMs, an RF cue before it lapses. A
+ * camera slews once per change of track and then keeps it for
+ * cameraHoldMs, so its own tracker has time to lock on. A winner with no
+ * token left waits for the next plan, the sensor keeping its last task
+ * meanwhile.
+ *
+ * Radars get RadarSensor::requestDwell(), RF detectors RFDetector::setCue()
+ * and cameras CameraSystem::slewToPosition(). Sensors are held by
+ * QPointer and forgotten once destroyed. Runs on the thread it lives on,
+ * which must be the sensors' thread.
+ */
+class SensorResourceManager : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SensorResourceManager(QObject* parent = nullptr);
+    ~SensorResourceManager() override;
+
+    void setConfig(const SensorResourceConfig& config);
+    SensorResourceConfig config() const { return m_config; }
+
+    void setThreatAssessor(ThreatAssessor* assessor) { m_threatAssessor = assessor; }
+
+    // Radars, RF detectors and cameras; other sensors are ignored
+    void addSensor(SensorInterface* sensor);
+    void removeSensor(const QString& sensorId);
+    QStringList sensorIds() const;
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_planTimer.isActive(); }
+
+    // One plan from the threat assessor's queue; start() runs it every planIntervalMs
+    void planCycle();
+    // One plan from the given requests, at nowMs; returns the commands sent
+    QVector<SensorTask> plan(QVector<SensorRequest> requests, qint64 nowMs);
+
+    // What each sensor was last commanded to do, still held
+    QVector<SensorTask> activeTasks(const QString& sensorId) const;
+
+    struct Stats {
+        quint64 plans = 0;
+        quint64 commands = 0;
+        quint64 rateLimited = 0;    // Winners held back for want of a token
+    };
+    Stats stats() const { return m_stats; }
+
+    static const char* taskTypeKey(SensorTaskType type);
+
+signals:
+    void taskIssued(const SensorTask& task);
+
+private:
+    struct Resource {
+        QPointer<SensorInterface> sensor;
+        SensorTaskType type = SensorTaskType::RadarDwell;
+        int channels = 1;
+        double commandsPerSec = 1.0;
+        double tokens = 1.0;
+        qint64 refilledMs = 0;
+        QVector<SensorTask> tasks;
+        MetricCounter* commands = nullptr;
+    };
+
+    double priorityOf(const SensorRequest& request) const;
+    bool canServe(const Resource& resource, const SensorRequest& request, bool held) const;
+    // Due for a command: a new track, or the held task up for renewal
+    bool needsCommand(const Resource& resource, const SensorTask* held, qint64 nowMs) const;
+    SensorTask makeTask(const Resource& resource, const SensorRequest& request, qint64 nowMs) const;
+    void send(const Resource& resource, const SensorTask& task);
+    void configure(Resource& resource) const;
+
+    SensorResourceConfig m_config;
+    ThreatAssessor* m_threatAssessor = nullptr;
+    QHash<QString, Resource> m_resources;
+    ServiceTimer m_planTimer;
+    Stats m_stats;
+    MetricCounter* m_rateLimitedCounter = nullptr;
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::SensorTask)
+
+#endif // SENSORRESOURCEMANAGER_H
@@ -0,0 +1,362 @@
+#include "core/ShardedTrackManager.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/Logger.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <cmath>
+
+namespace CounterUAS {
+
+ShardedTrackManager::ShardedTrackManager(QObject* parent)
+    : QObject(parent)
+    , m_handoffTimer(new QTimer(this))
+{
+    connect(m_handoffTimer, &QTimer::timeout, this, [this]() { rebalance(); });
+    buildShards();
+}
+
+ShardedTrackManager::~ShardedTrackManager() {
+    stop();
+    destroyShards();
+}
+
+void ShardedTrackManager::setConfig(const ShardedTrackManagerConfig& config) {
+    if (m_running) {
+        Logger::instance().warning("ShardedTrackManager", "Configuration applies only while stopped");
+        return;
+    }
+    m_config = config;
+    destroyShards();
+    buildShards();
+}
+
+void ShardedTrackManager::buildShards() {
+    m_grid.setOrigin(m_config.origin);
+
+    const int count = m_config.shardCount > 0 ? m_config.shardCount
+                                              : qMax(1, QThread::idealThreadCount());
+    FusionEngineConfig fusion = m_config.fusion;
+    fusion.threaded = true;
+
+    m_shards.resize(count);
+    for (int i = 0; i < count; ++i) {
+        Shard& shard = m_shards[i];
+        shard.manager = new TrackManager;
+        shard.manager->setObjectName(QString("TrackShard%1").arg(i));
+        shard.manager->setConfig(m_config.tracks);
+        // Shard i allocates handles i+1, i+1+N, ...
+        shard.manager->setHandleSequence(static_cast<TrackHandle>(i + 1), count);
+        shard.engine = new FusionEngine(shard.manager, this);
+        shard.engine->setConfig(fusion);
+    }
+
+    auto picture = std::make_shared<Picture>();
+    picture->merged = std::make_shared<const TrackPicture>();
+    picture->sequences.fill(0, count);
+    picture->index.setCellSize(m_config.tracks.correlationDistanceM);
+    std::atomic_store(&m_picture, std::shared_ptr<const Picture>(std::move(picture)));
+}
+
+void ShardedTrackManager::destroyShards() {
+    for (Shard& shard : m_shards) {
+        delete shard.engine;
+        delete shard.manager;
+    }
+    m_shards.clear();
+}
+
+void ShardedTrackManager::start() {
+    if (m_running) return;
+
+    for (Shard& shard : m_shards) {
+        shard.engine->start();
+        shard.manager->start();
+    }
+    m_handoffTimer->start(qMax(10, m_config.handoffIntervalMs));
+    m_running = true;
+    Logger::instance().info("ShardedTrackManager",
+                            QString("Started %1 shards, %2 m tiles")
+                                .arg(m_shards.size()).arg(m_config.tileSizeM));
+}
+
+void ShardedTrackManager::stop() {
+    if (!m_running) return;
+
+    m_handoffTimer->stop();
+    for (Shard& shard : m_shards) {
+        shard.manager->stop();
+        shard.engine->stop();
+    }
+    m_running = false;
+    Logger::instance().info("ShardedTrackManager", "Stopped");
+}
+
+void ShardedTrackManager::tileOf(const GeoPosition& pos, int& tx, int& ty) const {
+    const EnuVector enu = m_grid.toEnuLinear(pos);
+    const double tile = qMax(1.0, m_config.tileSizeM);
+    tx = static_cast<int>(std::floor(enu.east / tile));
+    ty = static_cast<int>(std::floor(enu.north / tile));
+}
+
+int ShardedTrackManager::tileOwner(const GeoPosition& pos) const {
+    int tx = 0;
+    int ty = 0;
+    tileOf(pos, tx, ty);
+    // Spatial hash: neighbouring tiles land on different shards
+    const quint32 hash = (static_cast<quint32>(tx) * 73856093u) ^ (static_cast<quint32>(ty) * 19349663u);
+    return static_cast<int>(hash % static_cast<quint32>(qMax(1, m_shards.size())));
+}
+
+bool ShardedTrackManager::insideTile(const GeoPosition& pos, double marginM) const {
+    const EnuVector enu = m_grid.toEnuLinear(pos);
+    const double tile = qMax(1.0, m_config.tileSizeM);
+    const double fx = enu.east - std::floor(enu.east / tile) * tile;
+    const double fy = enu.north - std::floor(enu.north / tile) * tile;
+    return qMin(qMin(fx, tile - fx), qMin(fy, tile - fy)) >= marginM;
+}
+
+bool ShardedTrackManager::submit(const SensorDetection& detection) {
+    return submitBatch(QVector<SensorDetection>{detection});
+}
+
+bool ShardedTrackManager::submitBatch(const QVector<SensorDetection>& detections) {
+    if (detections.isEmpty() || m_shards.isEmpty()) return true;
+
+    // One sub-batch per shard, reused per submitting thread
+    thread_local QVector<QVector<SensorDetection>> parts;
+    parts.resize(m_shards.size());
+    for (auto& part : parts) {
+        part.clear();
+    }
+
+    quint64 followed = 0;
+    bool accepted = true;
+    {
+        QReadLocker locker(&m_routeLock);
+        const PicturePtr picture = refreshPicture();
+        for (const SensorDetection& detection : detections) {
+            int shard = routeLocked(*picture, detection);
+            if (shard >= 0) {
+                ++followed;
+            } else {
+                shard = tileOwner(detection.position);
+            }
+            parts[shard].append(detection);
+        }
+
+        for (int i = 0; i < parts.size(); ++i) {
+            if (!parts[i].isEmpty()) {
+                accepted = m_shards[i].engine->submitBatch(parts[i]) && accepted;
+            }
+        }
+    }
+
+    m_detectionsRouted.fetch_add(detections.size(), std::memory_order_relaxed);
+    m_detectionsToTrackShard.fetch_add(followed, std::memory_order_relaxed);
+    return accepted;
+}
+
+int ShardedTrackManager::routeLocked(const Picture& picture, const SensorDetection& detection) const {
+    thread_local QVector<TrackHandle> candidates;
+    const double radius = m_config.tracks.correlationDistanceM;
+    picture.index.query(detection.position, radius, candidates);
+
+    int shard = -1;
+    double best = radius;
+    for (TrackHandle handle : candidates) {
+        const TrackSnapshot* t = picture.merged->find(handle);
+        if (!t) continue;
+        const double d = CoordinateUtils::haversineDistance(detection.position, t->position);
+        if (d <= best) {
+            best = d;
+            shard = picture.shardOf.value(handle, -1);
+        }
+    }
+    return shard;
+}
+
+TrackPicturePtr ShardedTrackManager::snapshot() const {
+    return refreshPicture()->merged;
+}
+
+ShardedTrackManager::PicturePtr ShardedTrackManager::refreshPicture() const {
+    const int count = m_shards.size();
+    QVector<TrackPicturePtr> pictures(count);
+
+    auto isCurrent = [&](const Picture& picture) {
+        bool current = picture.sequences.size() == count;
+        for (int i = 0; i < count; ++i) {
+            pictures[i] = m_shards[i].manager->snapshot();
+            current = current && picture.sequences[i] == pictures[i]->sequence;
+        }
+        return current;
+    };
+
+    PicturePtr existing = std::atomic_load(&m_picture);
+    if (isCurrent(*existing)) return existing;
+
+    QMutexLocker locker(&m_pictureMutex);
+    existing = std::atomic_load(&m_picture);
+    if (isCurrent(*existing)) return existing;  // Another thread rebuilt it
+
+    auto picture = std::make_shared<Picture>();
+    auto merged = std::make_shared<TrackPicture>();
+    int total = 0;
+    for (const TrackPicturePtr& p : pictures) {
+        total += p->tracks.size();
+    }
+    merged->tracks.reserve(total);
+    merged->indexById.reserve(total);
+    merged->indexByHandle.reserve(total);
+    picture->shardOf.reserve(total);
+    picture->sequences.resize(count);
+    picture->index.setCellSize(m_config.tracks.correlationDistanceM);
+
+    for (int i = 0; i < count; ++i) {
+        const TrackPicture& p = *pictures[i];
+        picture->sequences[i] = p.sequence;
+        merged->sequence += p.sequence;
+        merged->timestampMs = qMax(merged->timestampMs, p.timestampMs);
+        if (p.newestIngestNs > merged->newestIngestNs) {
+            merged->newestIngestNs = p.newestIngestNs;
+            merged->newestReceiveLagUs = p.newestReceiveLagUs;
+        }
+
+        for (const TrackSnapshot& t : p.tracks) {
+            // Mid hand-off both shards may still show the track; the new
+            // owner's copy is the newer one
+            auto seen = merged->indexByHandle.constFind(t.handle);
+            if (seen != merged->indexByHandle.constEnd()) {
+                TrackSnapshot& kept = merged->tracks[seen.value()];
+                if (t.lastUpdateMs > kept.lastUpdateMs) {
+                    kept = t;
+                    picture->shardOf.insert(t.handle, i);
+                    picture->index.insert(t.handle, t.position);
+                }
+                continue;
+            }
+            merged->indexById.insert(t.trackId, merged->tracks.size());
+            merged->indexByHandle.insert(t.handle, merged->tracks.size());
+            merged->tracks.append(t);
+            picture->shardOf.insert(t.handle, i);
+            picture->index.insert(t.handle, t.position);
+        }
+    }
+
+    picture->merged = std::move(merged);
+    PicturePtr published(std::move(picture));
+    std::atomic_store(&m_picture, published);
+    return published;
+}
+
+int ShardedTrackManager::rebalance() {
+    if (m_shards.size() < 2) return 0;
+
+    struct Move {
+        QString trackId;
+        int from;
+        int to;
+    };
+    QVector<Move> moves;
+    quint64 gathered = 0;
+    {
+        // No plot is routed while tracks change shard
+        QWriteLocker locker(&m_routeLock);
+        const PicturePtr picture = refreshPicture();
+        std::shared_ptr<Picture> patched;
+
+        auto shardOf = [&](TrackHandle handle) {
+            return (patched ? patched->shardOf : picture->shardOf).value(handle, -1);
+        };
+        auto moveTrack = [&](const TrackSnapshot& t, int from, int to) {
+            TrackManager* source = m_shards[from].manager;
+            TrackManager* destination = m_shards[to].manager;
+            if (destination->trackCount() >= m_config.tracks.maxTracks) {
+                m_handoffsFailed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            TrackSnapshot state;
+            if (!source->extractTrack(t.handle, &state)) return false;  // Dropped meanwhile
+            if (!destination->adoptTrack(state)) {
+                source->adoptTrack(state);
+                m_handoffsFailed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // Route to the new owner until the shards next publish
+            if (!patched) patched = std::make_shared<Picture>(*picture);
+            patched->shardOf.insert(t.handle, to);
+            moves.append(Move{t.trackId, from, to});
+            return true;
+        };
+
+        for (const TrackSnapshot& t : picture->merged->tracks) {
+            const int from = shardOf(t.handle);
+            if (from < 0 || !insideTile(t.position, m_config.handoffMarginM)) continue;
+            const int to = tileOwner(t.position);
+            if (to != from) moveTrack(t, from, to);
+        }
+
+        // Two tracks of one target on different shards, as when plots from
+        // two sites first land either side of a tile edge, never meet in a
+        // shard's merge pass. One joins the other's shard, which judges them.
+        if (m_config.tracks.autoMerge) {
+            thread_local QVector<TrackHandle> candidates;
+            const double gate = m_config.tracks.correlationDistanceM;
+            const double gateMps = m_config.tracks.correlationVelocityMps;
+            for (const TrackSnapshot& t : picture->merged->tracks) {
+                const int from = shardOf(t.handle);
+                if (from < 0) continue;
+                picture->index.query(t.position, gate, candidates);
+                for (TrackHandle handle : candidates) {
+                    const TrackSnapshot* other = picture->merged->find(handle);
+                    const int to = shardOf(handle);
+                    if (!other || to < 0 || to == from) continue;
+                    if (CoordinateUtils::haversineDistance(t.position, other->position) > gate) continue;
+                    const double dn = t.velocity.north - other->velocity.north;
+                    const double de = t.velocity.east - other->velocity.east;
+                    const double dd = t.velocity.down - other->velocity.down;
+                    if (dn * dn + de * de + dd * dd > gateMps * gateMps) continue;
+
+                    // The one off its tile's owner moves, else the newer;
+                    // the other is left for its own turn
+                    const bool strays = tileOwner(t.position) != from;
+                    const bool otherStrays = tileOwner(other->position) != to;
+                    if (strays == otherStrays ? t.handle < handle : !strays) continue;
+                    if (moveTrack(t, from, to)) ++gathered;
+                    break;
+                }
+            }
+        }
+
+        if (patched) {
+            QMutexLocker pictureLocker(&m_pictureMutex);
+            std::atomic_store(&m_picture, std::shared_ptr<const Picture>(std::move(patched)));
+        }
+    }
+
+    m_handoffs.fetch_add(moves.size() - gathered, std::memory_order_relaxed);
+    m_duplicatesGathered.fetch_add(gathered, std::memory_order_relaxed);
+    for (const Move& move : moves) {
+        emit trackHandedOff(move.trackId, move.from, move.to);
+    }
+    return moves.size();
+}
+
+ShardedTrackManager::Statistics ShardedTrackManager::statistics() const {
+    Statistics stats;
+    stats.detectionsRouted = m_detectionsRouted.load(std::memory_order_relaxed);
+    stats.detectionsToTrackShard = m_detectionsToTrackShard.load(std::memory_order_relaxed);
+    stats.handoffs = m_handoffs.load(std::memory_order_relaxed);
+    stats.handoffsFailed = m_handoffsFailed.load(std::memory_order_relaxed);
+    stats.duplicatesGathered = m_duplicatesGathered.load(std::memory_order_relaxed);
+    stats.tracksPerShard.reserve(m_shards.size());
+    for (const Shard& shard : m_shards) {
+        stats.tracksPerShard.append(shard.manager->trackCount());
+    }
+    return stats;
+}
+
+} // namespace CounterUAS
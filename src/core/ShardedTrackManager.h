@@ -0,0 +1,150 @@
+#ifndef SHARDEDTRACKMANAGER_H
+#define SHARDEDTRACKMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "core/FusionEngine.h"
+#include "core/TrackManager.h"
+#include "core/TrackSnapshot.h"
+#include "core/TrackSpatialIndex.h"
+#include "utils/LocalTangentPlane.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+/**
+ * @brief Configuration for a spatially sharded track picture
+ */
+struct ShardedTrackManagerConfig {
+    int shardCount = 0;             // 0 uses QThread::idealThreadCount()
+    double tileSizeM = 5000.0;      // Edge of one square ownership tile
+    double handoffMarginM = 200.0;  // Depth into a foreign tile before a track moves
+    int handoffIntervalMs = 1000;   // Period of the hand-off sweep
+    GeoPosition origin;             // Tile grid anchor, normally the site
+    TrackManagerConfig tracks;      // Per shard; maxTracks is a per-shard limit
+    FusionEngineConfig fusion;      // Per shard; always threaded
+};
+
+/**
+ * @brief Wide-area track picture split over several TrackManagers
+ *
+ * The ground is cut into square tiles on a grid about the site, and each
+ * tile is owned by one of N shards, scattered by a hash so that a dense
+ * area still spreads over every core. Each shard is an ordinary
+ * TrackManager with its own lock, fused on its own thread by its own
+ * FusionEngine, so cycles and correlation on different shards never
+ * contend.
+ *
+ * submitBatch() routes every plot to the shard holding the nearest track
+ * within correlation distance, or to the owner of the plot's tile when no
+ * track is near, and forwards one sub-batch per shard. A periodic sweep
+ * hands off tracks that have moved more than handoffMarginM into a tile
+ * owned by another shard; the track keeps its ID and handle, which are
+ * unique across shards. The margin keeps a target flying along a tile edge
+ * from bouncing between shards. With the tracks' autoMerge on, the sweep
+ * also moves a track within correlation distance and velocity of one on
+ * another shard onto that shard, so the shard's own merge pass can judge
+ * the pair; a target seen from both sides of a tile edge is not left as
+ * two tracks.
+ *
+ * snapshot() merges the shards' pictures into one; it is rebuilt only when
+ * a shard has published since, and is safe to call from any thread.
+ * Consumers should not hold Track pointers from shard(), which become
+ * invalid when their track is handed off.
+ */
+class ShardedTrackManager : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ShardedTrackManager(QObject* parent = nullptr);
+    ~ShardedTrackManager() override;
+
+    // Configuration; rebuilds the shards, dropping their tracks, when stopped
+    void setConfig(const ShardedTrackManagerConfig& config);
+    ShardedTrackManagerConfig config() const { return m_config; }
+
+    // Lifecycle
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    int shardCount() const { return m_shards.size(); }
+    TrackManager* shard(int index) const { return m_shards.value(index).manager; }
+    int tileOwner(const GeoPosition& pos) const;
+
+    // Thread-safe ingest; false if any shard dropped its part of the scan
+    bool submit(const SensorDetection& detection);
+    bool submitBatch(const QVector<SensorDetection>& detections);
+
+    // Merged picture of every shard; never null
+    TrackPicturePtr snapshot() const;
+    int trackCount() const { return snapshot()->tracks.size(); }
+
+    // One hand-off sweep now; returns the number of tracks moved, counting
+    // those gathered beside a duplicate
+    int rebalance();
+
+    struct Statistics {
+        quint64 detectionsRouted = 0;
+        quint64 detectionsToTrackShard = 0;  // Followed a nearby track across tiles
+        quint64 handoffs = 0;
+        quint64 handoffsFailed = 0;          // Destination refused (full)
+        quint64 duplicatesGathered = 0;      // Moved beside a likely duplicate on another shard
+        QVector<int> tracksPerShard;
+    };
+    Statistics statistics() const;
+
+signals:
+    void trackHandedOff(const QString& trackId, int fromShard, int toShard);
+
+private:
+    struct Shard {
+        TrackManager* manager = nullptr;   // Unparented, so its engine can move it
+        FusionEngine* engine = nullptr;
+    };
+
+    // Merged picture plus the routing tables derived from it
+    struct Picture {
+        TrackPicturePtr merged;
+        QVector<quint64> sequences;        // Per shard, of the pictures merged
+        QHash<TrackHandle, int> shardOf;
+        TrackSpatialIndex index;
+    };
+    using PicturePtr = std::shared_ptr<const Picture>;
+
+    void buildShards();
+    void destroyShards();
+    PicturePtr refreshPicture() const;
+    int routeLocked(const Picture& picture, const SensorDetection& detection) const;
+    bool insideTile(const GeoPosition& pos, double marginM) const;
+    void tileOf(const GeoPosition& pos, int& tx, int& ty) const;
+
+    ShardedTrackManagerConfig m_config;
+    QVector<Shard> m_shards;
+    LocalTangentPlane m_grid;              // Linear is enough: tiles only need to be consistent
+    QTimer* m_handoffTimer;
+    bool m_running = false;
+
+    // Routing reads, hand-off writes: no plot is routed to a track's old
+    // shard while it moves
+    mutable QReadWriteLock m_routeLock;
+    mutable QMutex m_pictureMutex;         // Serializes rebuilds of m_picture
+    mutable std::shared_ptr<const Picture> m_picture;  // atomic_store/atomic_load
+
+    std::atomic<quint64> m_detectionsRouted{0};
+    std::atomic<quint64> m_detectionsToTrackShard{0};
+    std::atomic<quint64> m_handoffs{0};
+    std::atomic<quint64> m_handoffsFailed{0};
+    std::atomic<quint64> m_duplicatesGathered{0};
+};
+
+} // namespace CounterUAS
+
+#endif // SHARDEDTRACKMANAGER_H
@@ -0,0 +1,182 @@
+#include "core/SnapshotStore.h"
+#include "utils/TaskScheduler.h"
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+namespace CounterUAS {
+
+SnapshotStore::SnapshotStore(int jpegQuality)
+    : m_quality(qBound(1, jpegQuality, 100))
+{
+}
+
+SnapshotStore::~SnapshotStore() {
+    waitForEncoding();
+}
+
+QString SnapshotStore::contentId(const QImage& image) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint32 header[3] = { image.width(), image.height(), static_cast<qint32>(image.format()) };
+    hash.addData(reinterpret_cast<const char*>(header), sizeof(header));
+
+    // Row by row: padding past the pixels is not content
+    const int rowBytes = (image.width() * image.depth() + 7) / 8;
+    for (int y = 0; y < image.height(); ++y) {
+        hash.addData(reinterpret_cast<const char*>(image.constScanLine(y)), rowBytes);
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString SnapshotStore::store(const QImage& image) {
+    if (image.isNull()) return QString();
+
+    const QString id = contentId(image);
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(id);
+        if (it != m_entries.end()) {
+            it->refs++;
+            return id;
+        }
+
+        Entry entry;
+        entry.pending = image;          // Shared, not copied
+        entry.refs = 1;
+        m_entries.insert(id, entry);
+        m_pendingBytes += image.sizeInBytes();
+        m_encoding++;
+    }
+
+    TaskScheduler::instance().submit([this, id, image]() { encode(id, image); }, TaskPriority::Background);
+    return id;
+}
+
+void SnapshotStore::encode(const QString& id, const QImage& image) {
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", m_quality);
+
+    const QImage thumbnail = image.scaled(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT,
+                                          Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(id);
+    if (it != m_entries.end() && !it->pending.isNull()) {
+        m_pendingBytes -= it->pending.sizeInBytes();
+        it->jpeg = jpeg;
+        it->pending = QImage();
+        m_encodedBytes += jpeg.size();
+        if (m_keepThumbnails) {
+            it->thumbnail = thumbnail;
+            m_thumbnailBytes += thumbnail.sizeInBytes();
+        }
+    }
+    m_encoding--;
+    m_encoded.wakeAll();
+}
+
+void SnapshotStore::retain(const QString& id) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(id);
+    if (it != m_entries.end()) {
+        it->refs++;
+    }
+}
+
+void SnapshotStore::release(const QString& id) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) return;
+    if (--it->refs <= 0) {
+        m_encodedBytes -= it->jpeg.size();
+        m_thumbnailBytes -= it->thumbnail.sizeInBytes();
+        m_pendingBytes -= it->pending.sizeInBytes();
+        m_entries.erase(it);
+    }
+}
+
+bool SnapshotStore::contains(const QString& id) const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(id);
+}
+
+int SnapshotStore::count() const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+qint64 SnapshotStore::encodedBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_encodedBytes;
+}
+
+qint64 SnapshotStore::memoryBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_encodedBytes + m_thumbnailBytes + m_pendingBytes;
+}
+
+void SnapshotStore::setKeepThumbnails(bool keep) {
+    QMutexLocker locker(&m_mutex);
+    m_keepThumbnails = keep;
+    if (keep) return;
+    for (Entry& entry : m_entries) {
+        entry.thumbnail = QImage();
+    }
+    m_thumbnailBytes = 0;
+}
+
+QImage SnapshotStore::image(const QString& id) const {
+    QByteArray jpeg;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(id);
+        if (it == m_entries.constEnd()) return QImage();
+        if (!it->pending.isNull()) return it->pending;
+        jpeg = it->jpeg;
+    }
+
+    // Decoded outside the lock
+    return QImage::fromData(jpeg, "JPEG");
+}
+
+QImage SnapshotStore::thumbnail(const QString& id) const {
+    QImage pending;
+    QByteArray jpeg;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(id);
+        if (it == m_entries.constEnd()) return QImage();
+        if (!it->thumbnail.isNull()) return it->thumbnail;
+        pending = it->pending;
+        jpeg = it->jpeg;
+    }
+
+    // Not encoded yet, or shed: cut one now rather than wait or keep it
+    const QImage source = pending.isNull() ? QImage::fromData(jpeg, "JPEG") : pending;
+    return source.scaled(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, Qt::KeepAspectRatio);
+}
+
+QByteArray SnapshotStore::jpeg(const QString& id) const {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(id);
+    return it != m_entries.constEnd() ? it->jpeg : QByteArray();
+}
+
+void SnapshotStore::waitForEncoding() const {
+    QMutexLocker locker(&m_mutex);
+    while (m_encoding > 0) {
+        m_encoded.wait(&m_mutex);
+    }
+}
+
+void SnapshotStore::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_encodedBytes = 0;
+    m_thumbnailBytes = 0;
+    m_pendingBytes = 0;
+}
+
+} // namespace CounterUAS
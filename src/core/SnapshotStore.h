@@ -0,0 +1,81 @@
+#ifndef SNAPSHOTSTORE_H
+#define SNAPSHOTSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+namespace CounterUAS {
+
+/**
+ * @brief Engagement video snapshots, stored once and referenced by id
+ *
+ * A snapshot's id is the SHA-1 of its pixels, so the same frame stored
+ * twice is kept once and its reference count goes up. The frame is held
+ * as given until a pool thread has JPEG-encoded it and cut the thumbnail;
+ * from then on only the JPEG and the thumbnail stay in memory, and image()
+ * decodes on demand. Under memory pressure the thumbnails go too and are
+ * cut from the JPEG when asked for. Records and requests carry the id rather than pixels.
+ *
+ * Thread-safe.
+ */
+class SnapshotStore {
+public:
+    static constexpr int THUMBNAIL_WIDTH = 160;
+    static constexpr int THUMBNAIL_HEIGHT = 120;
+
+    explicit SnapshotStore(int jpegQuality = 85);
+    ~SnapshotStore();
+
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+    // Returns the id with a reference taken; empty for a null image
+    QString store(const QImage& image);
+    void retain(const QString& id);
+    void release(const QString& id);
+
+    bool contains(const QString& id) const;
+    int count() const;
+    qint64 encodedBytes() const;
+    qint64 memoryBytes() const;     // JPEGs, thumbnails and frames still encoding
+
+    // Without thumbnails kept, thumbnail() cuts one from the JPEG each call
+    void setKeepThumbnails(bool keep);
+
+    // Null for an unknown id
+    QImage image(const QString& id) const;
+    QImage thumbnail(const QString& id) const;
+    QByteArray jpeg(const QString& id) const;   // Empty until encoded
+
+    void waitForEncoding() const;
+    void clear();
+
+private:
+    struct Entry {
+        QImage pending;                 // Until encoded
+        QByteArray jpeg;
+        QImage thumbnail;
+        int refs = 0;
+    };
+
+    static QString contentId(const QImage& image);
+    void encode(const QString& id, const QImage& image);
+
+    int m_quality;
+    mutable QMutex m_mutex;
+    mutable QWaitCondition m_encoded;
+    QHash<QString, Entry> m_entries;
+    int m_encoding = 0;
+    qint64 m_encodedBytes = 0;
+    qint64 m_thumbnailBytes = 0;
+    qint64 m_pendingBytes = 0;
+    bool m_keepThumbnails = true;
+};
+
+} // namespace CounterUAS
+
+#endif // SNAPSHOTSTORE_H
@@ -0,0 +1,137 @@
+#include "core/TentativeTrackPool.h"
+#include "utils/CoordinateUtils.h"
+
+namespace CounterUAS {
+
+TentativeTrackPool::TentativeTrackPool() = default;
+
+void TentativeTrackPool::setRule(int requiredHits, int scans, int scanMs, int capacity,
+                                 double gateM) {
+    // hitSlots is a 64-bit window
+    m_scans = qBound(1, scans, 64);
+    m_requiredHits = qBound(1, requiredHits, m_scans);
+    m_scanMs = qMax(1, scanMs);
+    m_capacity = qMax(1, capacity);
+    m_gateM = qMax(1.0, gateM);
+    m_spatialIndex.setCellSize(m_gateM);
+}
+
+bool TentativeTrackPool::observe(const GeoPosition& position, const VelocityVector& velocity,
+                                 DetectionSource source, double quality,
+                                 qint64 nowMs, TentativeTrack& confirmed) {
+    int index = findNearest(position, nowMs);
+    if (index < 0) {
+        if (m_tracks.size() >= m_capacity) {
+            // Displace the oldest: it has the fewest opportunities left
+            int oldest = 0;
+            for (int i = 1; i < m_tracks.size(); ++i) {
+                if (m_tracks[i].firstMs < m_tracks[oldest].firstMs) oldest = i;
+            }
+            removeAt(oldest);
+            ++m_stats.evicted;
+        }
+
+        TentativeTrack track;
+        track.id = m_nextId++;
+        track.firstMs = nowMs;
+        index = m_tracks.size();
+        m_tracks.append(track);
+        m_indexOf.insert(track.id, index);
+        ++m_stats.opened;
+    }
+
+    TentativeTrack& track = m_tracks[index];
+    const quint64 slotBit = quint64(1) << slotFor(track, nowMs);
+    if (!(track.hitSlots & slotBit)) {
+        track.hitSlots |= slotBit;
+        ++track.hits;
+    }
+
+    track.position = position;
+    if (source == DetectionSource::Radar) {
+        track.velocity = velocity;
+    }
+    track.sourceMask |= 1u << static_cast<int>(source);
+    track.quality = qMax(track.quality, quality);
+    track.lastHitMs = nowMs;
+    m_spatialIndex.insert(track.id, position);
+
+    if (track.hits < m_requiredHits) return false;
+
+    confirmed = track;
+    removeAt(index);
+    ++m_stats.confirmed;
+    return true;
+}
+
+int TentativeTrackPool::expire(qint64 nowMs) {
+    int expired = 0;
+    for (int i = m_tracks.size() - 1; i >= 0; --i) {
+        if (nowMs - m_tracks[i].firstMs >= static_cast<qint64>(m_scans) * m_scanMs) {
+            removeAt(i);
+            ++expired;
+        }
+    }
+    m_stats.expired += expired;
+    return expired;
+}
+
+void TentativeTrackPool::clear() {
+    m_tracks.clear();
+    m_indexOf.clear();
+    m_spatialIndex.clear();
+}
+
+void TentativeTrackPool::restore(const QVector<TentativeTrack>& tracks) {
+    clear();
+    for (const TentativeTrack& track : tracks) {
+        if (m_tracks.size() >= m_capacity) break;
+        if (track.id == 0 || m_indexOf.contains(track.id)) continue;
+        m_indexOf.insert(track.id, m_tracks.size());
+        m_tracks.append(track);
+        m_spatialIndex.insert(track.id, track.position);
+        m_nextId = qMax(m_nextId, track.id + 1);
+    }
+}
+
+int TentativeTrackPool::slotFor(const TentativeTrack& track, qint64 nowMs) const {
+    return static_cast<int>(qBound<qint64>(0, (nowMs - track.firstMs) / m_scanMs, m_scans - 1));
+}
+
+int TentativeTrackPool::findNearest(const GeoPosition& position, qint64 nowMs) const {
+    int best = -1;
+    double bestDistance = m_gateM;
+
+    const QVector<TrackHandle> candidates = m_spatialIndex.query(position, m_gateM);
+    for (TrackHandle id : candidates) {
+        const int index = m_indexOf.value(id, -1);
+        if (index < 0) continue;
+
+        // Out of opportunities: expire() has not swept it yet, but it can no
+        // longer confirm, so the plot opens a fresh tentative instead
+        const TentativeTrack& track = m_tracks[index];
+        if (nowMs - track.firstMs >= static_cast<qint64>(m_scans) * m_scanMs) continue;
+
+        const double distance = CoordinateUtils::haversineDistance(track.position, position);
+        if (distance <= bestDistance) {
+            bestDistance = distance;
+            best = index;
+        }
+    }
+    return best;
+}
+
+void TentativeTrackPool::removeAt(int index) {
+    const quint32 id = m_tracks[index].id;
+    m_spatialIndex.remove(id);
+    m_indexOf.remove(id);
+
+    const int last = m_tracks.size() - 1;
+    if (index != last) {
+        m_tracks[index] = m_tracks[last];
+        m_indexOf[m_tracks[index].id] = index;
+    }
+    m_tracks.removeLast();
+}
+
+} // namespace CounterUAS
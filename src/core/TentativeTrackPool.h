@@ -0,0 +1,94 @@
+#ifndef TENTATIVETRACKPOOL_H
+#define TENTATIVETRACKPOOL_H
+
+#include <QHash>
+#include <QVector>
+#include "core/Track.h"
+#include "core/TrackSpatialIndex.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief A plot sequence waiting for M-of-N confirmation
+ *
+ * Plain data: no filter, no QObject, no signals. Opportunity i covers
+ * [firstMs + i * scanMs, firstMs + (i + 1) * scanMs) and hitSlots bit i is
+ * set once any plot lands in it, so a burst of plots in one scan counts once.
+ */
+struct TentativeTrack {
+    quint32 id = 0;
+    GeoPosition position;       // Last plot
+    VelocityVector velocity;    // Last plot that carried one
+    quint32 sourceMask = 0;     // Bit per DetectionSource
+    double quality = 0.0;       // Best plot confidence
+    qint64 firstMs = 0;
+    qint64 lastHitMs = 0;
+    quint64 hitSlots = 0;
+    int hits = 0;               // Set bits in hitSlots
+};
+
+/**
+ * @brief M-of-N track initiation ahead of TrackManager's full tracks
+ *
+ * Plots that no track claims are gated against the pool instead of
+ * becoming Track objects. A tentative that collects hits in M of its first
+ * N scan opportunities is confirmed and handed back for promotion. One that
+ * runs out of opportunities first is discarded without ever having cost a
+ * Track, a filter slot, a signal or a UI row. With M = 1 the pool is a
+ * pass-through and every plot confirms at once.
+ */
+class TentativeTrackPool {
+public:
+    TentativeTrackPool();
+
+    void setRule(int requiredHits, int scans, int scanMs, int capacity, double gateM);
+    int requiredHits() const { return m_requiredHits; }
+    int scans() const { return m_scans; }
+    bool isPassThrough() const { return m_requiredHits <= 1; }
+
+    // Gates the plot against the nearest open tentative within the gate, or
+    // opens a new one. Returns true, with the tentative removed from the
+    // pool and copied to confirmed, when this plot completes M hits.
+    bool observe(const GeoPosition& position, const VelocityVector& velocity,
+                 DetectionSource source, double quality, qint64 nowMs,
+                 TentativeTrack& confirmed);
+
+    // Discards tentatives whose N opportunities have all passed
+    int expire(qint64 nowMs);
+
+    int size() const { return m_tracks.size(); }
+    const QVector<TentativeTrack>& tentatives() const { return m_tracks; }
+    void clear();
+    // Replaces the pool with saved tentatives, keeping their ids; beyond
+    // capacity the rest are dropped
+    void restore(const QVector<TentativeTrack>& tracks);
+
+    struct Stats {
+        qint64 opened = 0;
+        qint64 confirmed = 0;
+        qint64 expired = 0;
+        qint64 evicted = 0;     // Displaced by a new plot while the pool was full
+    };
+    Stats stats() const { return m_stats; }
+
+private:
+    int slotFor(const TentativeTrack& track, qint64 nowMs) const;
+    int findNearest(const GeoPosition& position, qint64 nowMs) const;
+    void removeAt(int index);
+
+    int m_requiredHits = 1;
+    int m_scans = 1;
+    int m_scanMs = 1000;
+    int m_capacity = 2000;
+    double m_gateM = 100.0;
+
+    QVector<TentativeTrack> m_tracks;   // Unordered; removal swaps with the last
+    QHash<quint32, int> m_indexOf;
+    TrackSpatialIndex m_spatialIndex;   // Keyed by tentative id
+    quint32 m_nextId = 1;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // TENTATIVETRACKPOOL_H
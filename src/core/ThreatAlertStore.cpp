@@ -0,0 +1,227 @@
+#include "core/ThreatAlertStore.h"
+#include "utils/JsonWriter.h"
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+// ThreatAlert serialization
+QJsonObject ThreatAlert::toJson() const {
+    QJsonObject obj;
+    obj["alertId"] = alertId;
+    obj["trackId"] = trackId;
+    obj["ruleId"] = ruleId;
+    if (groupId != 0) {
+        obj["groupId"] = static_cast<qint64>(groupId);
+    }
+    obj["message"] = message;
+    obj["threatLevel"] = threatLevel;
+    obj["timestamp"] = timestamp.toString(Qt::ISODateWithMs);
+    obj["acknowledged"] = acknowledged;
+    obj["acknowledgedBy"] = acknowledgedBy;
+    if (acknowledgedTime.isValid()) {
+        obj["acknowledgedTime"] = acknowledgedTime.toString(Qt::ISODateWithMs);
+    }
+    return obj;
+}
+
+void ThreatAlert::writeJson(JsonWriter& writer) const {
+    writer.beginObject();
+    writer.key("alertId");
+    writer.writeString(alertId);
+    writer.key("trackId");
+    writer.writeString(trackId);
+    writer.key("ruleId");
+    writer.writeString(ruleId);
+    if (groupId != 0) {
+        writer.key("groupId");
+        writer.writeInt(groupId);
+    }
+    writer.key("message");
+    writer.writeString(message);
+    writer.key("threatLevel");
+    writer.writeInt(threatLevel);
+    writer.key("timestamp");
+    writer.writeDateTime(timestamp);
+    writer.key("acknowledged");
+    writer.writeBool(acknowledged);
+    writer.key("acknowledgedBy");
+    writer.writeString(acknowledgedBy);
+    if (acknowledgedTime.isValid()) {
+        writer.key("acknowledgedTime");
+        writer.writeDateTime(acknowledgedTime);
+    }
+    writer.endObject();
+}
+
+ThreatAlertStore::ThreatAlertStore(int capacity)
+    : m_slots(qMax(1, capacity))
+{
+}
+
+void ThreatAlertStore::setCapacity(int capacity, QStringList* evictedIds) {
+    capacity = qMax(1, capacity);
+    if (capacity == m_slots.size()) return;
+
+    QList<ThreatAlert> kept = all();
+    while (kept.size() > capacity) {
+        if (evictedIds) evictedIds->append(kept.first().alertId);
+        kept.removeFirst();
+    }
+
+    m_slots = QVector<Slot>(capacity);
+    m_head = 0;
+    m_count = 0;
+    m_slotById.clear();
+    m_latestByKey.clear();
+    m_unackedFirst = m_unackedLast = -1;
+    m_unackedCount = 0;
+    for (const ThreatAlert& alert : kept) {
+        insert(alert);
+    }
+}
+
+QString ThreatAlertStore::keyFor(const QString& subject, const QString& ruleId) {
+    return subject + QLatin1Char('\n') + ruleId;
+}
+
+QString ThreatAlertStore::keyFor(const ThreatAlert& alert) {
+    return keyFor(alert.groupId != 0 ? groupSubject(alert.groupId) : alert.trackId, alert.ruleId);
+}
+
+QString ThreatAlertStore::groupSubject(quint32 groupId) {
+    // Track ids never contain a colon
+    return QStringLiteral("group:") + QString::number(groupId);
+}
+
+void ThreatAlertStore::insert(const ThreatAlert& alert, QString* evictedId) {
+    if (m_count == m_slots.size()) {
+        evictOldest(evictedId);
+    }
+
+    const int slot = slotAt(m_count);
+    m_slots[slot] = Slot();
+    m_slots[slot].alert = alert;
+    ++m_count;
+
+    m_slotById.insert(alert.alertId, slot);
+    // A merged alert may be older than the newest one held for its key
+    const QString key = keyFor(alert);
+    auto latest = m_latestByKey.constFind(key);
+    if (latest == m_latestByKey.constEnd() || m_slots[latest.value()].alert.timestamp <= alert.timestamp) {
+        m_latestByKey.insert(key, slot);
+    }
+    if (!alert.acknowledged) {
+        linkUnacked(slot);
+    }
+}
+
+bool ThreatAlertStore::isSuppressed(const QString& subject, const QString& ruleId,
+                                    qint64 nowMs, qint64 windowMs) const {
+    auto it = m_latestByKey.constFind(keyFor(subject, ruleId));
+    if (it == m_latestByKey.constEnd()) return false;
+
+    const ThreatAlert& latest = m_slots[it.value()].alert;
+    return !latest.acknowledged && nowMs - latest.timestamp.toMSecsSinceEpoch() < windowMs;
+}
+
+const ThreatAlert* ThreatAlertStore::find(const QString& alertId) const {
+    auto it = m_slotById.constFind(alertId);
+    return it != m_slotById.constEnd() ? &m_slots[it.value()].alert : nullptr;
+}
+
+bool ThreatAlertStore::acknowledge(const QString& alertId, const QString& operatorId,
+                                   const QDateTime& time) {
+    auto it = m_slotById.constFind(alertId);
+    if (it == m_slotById.constEnd()) return false;
+
+    const int slot = it.value();
+    ThreatAlert& alert = m_slots[slot].alert;
+    if (alert.acknowledged) return false;
+
+    alert.acknowledged = true;
+    alert.acknowledgedBy = operatorId;
+    alert.acknowledgedTime = time;
+    unlinkUnacked(slot);
+    return true;
+}
+
+void ThreatAlertStore::clear() {
+    for (Slot& slot : m_slots) {
+        slot = Slot();
+    }
+    m_head = 0;
+    m_count = 0;
+    m_slotById.clear();
+    m_latestByKey.clear();
+    m_unackedFirst = m_unackedLast = -1;
+    m_unackedCount = 0;
+}
+
+QList<ThreatAlert> ThreatAlertStore::all() const {
+    QList<ThreatAlert> result;
+    result.reserve(m_count);
+    for (int i = 0; i < m_count; ++i) {
+        result.append(m_slots[slotAt(i)].alert);
+    }
+    return result;
+}
+
+QList<ThreatAlert> ThreatAlertStore::unacknowledged() const {
+    QList<ThreatAlert> result;
+    result.reserve(m_unackedCount);
+    for (int slot = m_unackedFirst; slot >= 0; slot = m_slots[slot].nextUnacked) {
+        result.append(m_slots[slot].alert);
+    }
+    return result;
+}
+
+void ThreatAlertStore::evictOldest(QString* evictedId) {
+    const int slot = m_head;
+    const ThreatAlert& oldest = m_slots[slot].alert;
+
+    if (!oldest.acknowledged) {
+        unlinkUnacked(slot);
+    }
+    m_slotById.remove(oldest.alertId);
+
+    const QString key = keyFor(oldest);
+    auto it = m_latestByKey.find(key);
+    if (it != m_latestByKey.end() && it.value() == slot) {
+        m_latestByKey.erase(it);
+    }
+
+    if (evictedId) *evictedId = oldest.alertId;
+    m_head = (m_head + 1) % m_slots.size();
+    --m_count;
+}
+
+void ThreatAlertStore::linkUnacked(int slot) {
+    Slot& s = m_slots[slot];
+    s.prevUnacked = m_unackedLast;
+    s.nextUnacked = -1;
+    if (m_unackedLast >= 0) {
+        m_slots[m_unackedLast].nextUnacked = slot;
+    } else {
+        m_unackedFirst = slot;
+    }
+    m_unackedLast = slot;
+    ++m_unackedCount;
+}
+
+void ThreatAlertStore::unlinkUnacked(int slot) {
+    Slot& s = m_slots[slot];
+    if (s.prevUnacked >= 0) {
+        m_slots[s.prevUnacked].nextUnacked = s.nextUnacked;
+    } else {
+        m_unackedFirst = s.nextUnacked;
+    }
+    if (s.nextUnacked >= 0) {
+        m_slots[s.nextUnacked].prevUnacked = s.prevUnacked;
+    } else {
+        m_unackedLast = s.prevUnacked;
+    }
+    s.prevUnacked = s.nextUnacked = -1;
+    --m_unackedCount;
+}
+
+} // namespace CounterUAS
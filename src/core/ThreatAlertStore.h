@@ -0,0 +1,102 @@
+#ifndef THREATALERTSTORE_H
+#define THREATALERTSTORE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace CounterUAS {
+
+class JsonWriter;
+
+/**
+ * @brief Threat alert structure
+ */
+struct ThreatAlert {
+    QString alertId;
+    QString trackId;
+    QString ruleId;
+    quint32 groupId = 0;        // Raised for the track's swarm group rather than the track
+    QString message;
+    int threatLevel;
+    QDateTime timestamp;
+    bool acknowledged = false;
+    QString acknowledgedBy;
+    QDateTime acknowledgedTime;
+
+    QJsonObject toJson() const;
+    void writeJson(JsonWriter& writer) const;      // toJson's document, without the tree
+};
+
+/**
+ * @brief Fixed-capacity ring of alerts with O(1) lookup and acknowledge
+ *
+ * When full, inserting evicts the oldest alert. An id-to-slot hash serves
+ * lookups and acknowledgement, and unacknowledged alerts are threaded on an
+ * intrusive list in arrival order, so the pending set never needs a scan of
+ * the whole ring. The newest alert per (subject, rule) is indexed for
+ * duplicate suppression, the subject being the track, or the group for an
+ * alert with a groupId. Not thread-safe.
+ */
+class ThreatAlertStore {
+public:
+    explicit ThreatAlertStore(int capacity = 100);
+
+    // Shrinking keeps the newest alerts; the ids dropped go to evictedIds
+    void setCapacity(int capacity, QStringList* evictedIds = nullptr);
+    int capacity() const { return m_slots.size(); }
+
+    int size() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+    int unacknowledgedCount() const { return m_unackedCount; }
+
+    // Appends, evicting the oldest alert when full; its id goes to evictedId
+    void insert(const ThreatAlert& alert, QString* evictedId = nullptr);
+
+    // True while the newest alert for (subject, ruleId) is unacknowledged
+    // and younger than windowMs; subject is a track id or groupSubject()
+    bool isSuppressed(const QString& subject, const QString& ruleId,
+                      qint64 nowMs, qint64 windowMs) const;
+    static QString groupSubject(quint32 groupId);
+
+    const ThreatAlert* find(const QString& alertId) const;
+    bool acknowledge(const QString& alertId, const QString& operatorId, const QDateTime& time);
+    void clear();
+
+    // Oldest first
+    QList<ThreatAlert> all() const;
+    QList<ThreatAlert> unacknowledged() const;
+
+private:
+    struct Slot {
+        ThreatAlert alert;
+        int prevUnacked = -1;
+        int nextUnacked = -1;
+    };
+
+    static QString keyFor(const QString& subject, const QString& ruleId);
+    static QString keyFor(const ThreatAlert& alert);
+    int slotAt(int offset) const { return (m_head + offset) % m_slots.size(); }
+    void evictOldest(QString* evictedId);
+    void linkUnacked(int slot);
+    void unlinkUnacked(int slot);
+
+    QVector<Slot> m_slots;
+    int m_head = 0;     // Oldest alert
+    int m_count = 0;
+
+    QHash<QString, int> m_slotById;
+    QHash<QString, int> m_latestByKey;   // (subject, rule) -> newest slot
+
+    int m_unackedFirst = -1;
+    int m_unackedLast = -1;
+    int m_unackedCount = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // THREATALERTSTORE_H
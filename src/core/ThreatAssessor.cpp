@@ -1,7 +1,17 @@
 #include "core/ThreatAssessor.h"
 #include "core/TrackManager.h"
+#include "core/TrackChangeThrottle.h"
 #include "utils/Logger.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/FlightRecorder.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/OverloadController.h"
+#include "utils/PipelineLatency.h"
+#include "utils/StatusBoard.h"
+#include "utils/TimeUtils.h"
+#include "utils/Trace.h"
 #include <algorithm>
+#include <iterator>
 #include <cmath>
 
 namespace CounterUAS {
@@ -42,8 +52,13 @@ QJsonObject ThreatRule::toJson() const {
     obj["maxVelocityMps"] = maxVelocityMps;
     obj["minHeadingToAssetDeg"] = minHeadingToAssetDeg;
     obj["maxHeadingToAssetDeg"] = maxHeadingToAssetDeg;
+    obj["maxTimeToImpactSec"] = maxTimeToImpactSec;
     obj["requiresVisualConfirmation"] = requiresVisualConfirmation;
     obj["requiresRFDetection"] = requiresRFDetection;
+    obj["zoneId"] = zoneId;
+    obj["requiresOutsideZone"] = requiresOutsideZone;
+    obj["zoneMarginM"] = zoneMarginM;
+    obj["minGroupSize"] = minGroupSize;
     obj["threatLevelIncrease"] = threatLevelIncrease;
     obj["setThreatLevel"] = setThreatLevel;
     obj["forceClassification"] = static_cast<int>(forceClassification);
@@ -64,8 +79,13 @@ ThreatRule ThreatRule::fromJson(const QJsonObject& json) {
     rule.maxVelocityMps = json["maxVelocityMps"].toDouble(-1);
     rule.minHeadingToAssetDeg = json["minHeadingToAssetDeg"].toDouble(-1);
     rule.maxHeadingToAssetDeg = json["maxHeadingToAssetDeg"].toDouble(-1);
+    rule.maxTimeToImpactSec = json["maxTimeToImpactSec"].toDouble(-1);
     rule.requiresVisualConfirmation = json["requiresVisualConfirmation"].toBool();
     rule.requiresRFDetection = json["requiresRFDetection"].toBool();
+    rule.zoneId = json["zoneId"].toString();
+    rule.requiresOutsideZone = json["requiresOutsideZone"].toBool();
+    rule.zoneMarginM = json["zoneMarginM"].toDouble();
+    rule.minGroupSize = json["minGroupSize"].toInt(-1);
     rule.threatLevelIncrease = json["threatLevelIncrease"].toInt();
     rule.setThreatLevel = json["setThreatLevel"].toInt(-1);
     rule.forceClassification = static_cast<TrackClassification>(json["forceClassification"].toInt());
@@ -74,38 +94,42 @@ ThreatRule ThreatRule::fromJson(const QJsonObject& json) {
     return rule;
 }
 
-// ThreatAlert serialization
-QJsonObject ThreatAlert::toJson() const {
-    QJsonObject obj;
-    obj["alertId"] = alertId;
-    obj["trackId"] = trackId;
-    obj["message"] = message;
-    obj["threatLevel"] = threatLevel;
-    obj["timestamp"] = timestamp.toString(Qt::ISODateWithMs);
-    obj["acknowledged"] = acknowledged;
-    obj["acknowledgedBy"] = acknowledgedBy;
-    if (acknowledgedTime.isValid()) {
-        obj["acknowledgedTime"] = acknowledgedTime.toString(Qt::ISODateWithMs);
-    }
-    return obj;
-}
-
 // ThreatAssessor implementation
 ThreatAssessor::ThreatAssessor(TrackManager* trackManager, QObject* parent)
     : QObject(parent)
     , m_trackManager(trackManager)
     , m_assessmentTimer(new QTimer(this))
+    , m_priorityTimer(new QTimer(this))
+    , m_alerts(m_config.alertQueueMaxSize)
+    , m_chunks(1)
 {
     connect(m_assessmentTimer, &QTimer::timeout, 
             this, &ThreatAssessor::performAssessmentCycle);
+    connect(m_priorityTimer, &QTimer::timeout,
+            this, &ThreatAssessor::performPriorityCycle);
     
     if (m_trackManager) {
         connect(m_trackManager, &TrackManager::trackCreated,
                 this, &ThreatAssessor::onTrackCreated);
-        connect(m_trackManager, &TrackManager::trackUpdated,
-                this, &ThreatAssessor::onTrackUpdated);
+        m_changeThrottle = new TrackChangeThrottle(m_trackManager, m_config.maxChangeRateHz, this);
+        connect(m_changeThrottle, &TrackChangeThrottle::tracksChanged,
+                this, &ThreatAssessor::onTracksChanged);
+        connect(m_trackManager, &TrackManager::trackHandleDropped,
+                this, &ThreatAssessor::onTrackDropped);
     }
     
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_exported.hostile = registry.gauge("cuas_threat_hostile_tracks", "Tracks classified hostile");
+    m_exported.pending = registry.gauge("cuas_threat_pending_tracks", "Tracks pending classification");
+    m_exported.highThreat = registry.gauge("cuas_threat_high_tracks", "Tracks at or above the high threat threshold");
+    m_exported.avgThreatLevel = registry.gauge("cuas_threat_level_average", "Mean threat level of live tracks");
+    m_exported.closestDistanceM = registry.gauge("cuas_threat_closest_distance_meters",
+                                                 "Closest track to a defended asset, -1 with none");
+    m_exported.unacknowledgedAlerts = registry.gauge("cuas_threat_alerts_unacknowledged",
+                                                     "Alerts awaiting operator acknowledgement");
+    m_exported.alerts = registry.counter("cuas_threat_alerts_total", "Threat alerts raised");
+    m_exported.cycleTime = registry.histogram("cuas_threat_cycle_seconds", "Threat assessment cycle time");
+    
     loadDefaultRules();
 }
 
@@ -114,10 +138,122 @@ ThreatAssessor::~ThreatAssessor() {
 }
 
 void ThreatAssessor::setConfig(const ThreatAssessorConfig& config) {
+    const bool wasTiered = m_config.tieredRates;
     m_config = config;
+    if (wasTiered && !m_config.tieredRates) resetTiers();
+    QStringList evicted;
+    m_alerts.setCapacity(m_config.alertQueueMaxSize, &evicted);
+    for (const QString& alertId : evicted) {
+        emit alertEvicted(alertId);
+    }
+    m_reassessAll = true;  // Thresholds and mode feed the incremental state
+    if (m_changeThrottle) {
+        m_changeThrottle->setMaxRateHz(m_config.maxChangeRateHz);
+    }
     if (m_running) {
         m_assessmentTimer->setInterval(m_config.assessmentIntervalMs);
     }
+    updatePriorityTimer();
+}
+
+void ThreatAssessor::setLowThreatStride(int stride) {
+    m_lowThreatStride = qMax(1, stride);
+}
+
+bool ThreatAssessor::isDeferred(const TrackSnapshot& track) const {
+    if (!m_inCycle) return false;
+    
+    int stride = 1;
+    if (m_config.tieredRates) {
+        switch (m_tiers.value(track.handle, TrackUpdateTier::Routine)) {
+            case TrackUpdateTier::Priority:
+                // The priority cycle has it
+                if (m_priorityTimer->isActive()) return true;
+                break;
+            case TrackUpdateTier::Background: {
+                const double cyclesPerSec = 1000.0 / qMax(1, m_config.assessmentIntervalMs);
+                stride = qMax(1, qRound(cyclesPerSec / qMax(0.01, m_config.backgroundAssessmentHz)));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    if (m_lowThreatStride > stride && track.threatLevel < m_config.highThreatThreshold &&
+        track.classification != TrackClassification::Hostile) {
+        stride = m_lowThreatStride;
+    }
+    if (stride <= 1) return false;
+    return (m_cycleIndex + track.handle) % quint64(stride) != 0;
+}
+
+TrackUpdateTier ThreatAssessor::tierFor(const TrackSnapshot& track, const ThreatRuleInput& input) const {
+    const TrackClassification classification = input.classification != TrackClassification::Unknown
+                                                   ? input.classification : track.classification;
+    const bool closing = input.timeToImpactSec >= 0;
+    if (input.threatLevel >= m_config.highThreatThreshold ||
+        classification == TrackClassification::Hostile ||
+        input.proximityM <= m_config.priorityRangeM ||
+        (closing && input.timeToImpactSec <= m_config.priorityImpactSec)) {
+        return TrackUpdateTier::Priority;
+    }
+    if (input.threatLevel <= 1 && classification != TrackClassification::Pending &&
+        input.proximityM >= m_config.backgroundRangeM && !closing) {
+        return TrackUpdateTier::Background;
+    }
+    return TrackUpdateTier::Routine;
+}
+
+void ThreatAssessor::noteTier(TrackHandle handle, TrackUpdateTier tier) {
+    auto it = m_tiers.find(handle);
+    const TrackUpdateTier previous = it != m_tiers.end() ? it.value() : TrackUpdateTier::Routine;
+    if (it != m_tiers.end() && previous == tier) return;
+    
+    m_tiers.insert(handle, tier);
+    if (tier == TrackUpdateTier::Priority) {
+        m_priorityTracks.insert(handle);
+    } else {
+        m_priorityTracks.remove(handle);
+    }
+    if (tier != previous) m_tierChanges.append(qMakePair(handle, tier));
+}
+
+void ThreatAssessor::publishTiers() {
+    if (m_tierChanges.isEmpty() || !m_trackManager) return;
+    m_trackManager->setUpdateTiers(m_tierChanges);
+    m_tierChanges.clear();
+}
+
+void ThreatAssessor::resetTiers() {
+    for (auto it = m_tiers.constBegin(); it != m_tiers.constEnd(); ++it) {
+        if (it.value() != TrackUpdateTier::Routine) {
+            m_tierChanges.append(qMakePair(it.key(), TrackUpdateTier::Routine));
+        }
+    }
+    m_tiers.clear();
+    m_priorityTracks.clear();
+    publishTiers();
+}
+
+void ThreatAssessor::updatePriorityTimer() {
+    if (m_running && m_config.tieredRates) {
+        m_priorityTimer->setInterval(1000 / qBound(1, m_config.priorityAssessmentHz, 1000));
+        if (!m_priorityTimer->isActive()) m_priorityTimer->start();
+    } else {
+        m_priorityTimer->stop();
+    }
+}
+
+const Clock* ThreatAssessor::clock() const {
+    if (m_clock) return m_clock;
+    return m_trackManager ? m_trackManager->clock() : Clock::system();
+}
+
+void ThreatAssessor::step() {
+    if (m_changeThrottle) {
+        m_changeThrottle->flush();
+    }
+    performAssessmentCycle();
 }
 
 void ThreatAssessor::start() {
@@ -126,6 +262,7 @@ void ThreatAssessor::start() {
     m_assessmentTimer->setInterval(m_config.assessmentIntervalMs);
     m_assessmentTimer->start();
     m_running = true;
+    updatePriorityTimer();
     
     Logger::instance().info("ThreatAssessor", "Started with interval: " +
                            QString::number(m_config.assessmentIntervalMs) + " ms");
@@ -136,57 +273,77 @@ void ThreatAssessor::stop() {
     
     m_assessmentTimer->stop();
     m_running = false;
+    updatePriorityTimer();
     
     Logger::instance().info("ThreatAssessor", "Stopped");
 }
 
 void ThreatAssessor::addDefendedAsset(const DefendedAsset& asset) {
     m_assets.append(asset);
+    rebuildAssetIndex();
     Logger::instance().info("ThreatAssessor", "Added defended asset: " + asset.name);
 }
 
 void ThreatAssessor::removeDefendedAsset(const QString& assetId) {
     m_assets.erase(std::remove_if(m_assets.begin(), m_assets.end(),
         [&assetId](const DefendedAsset& a) { return a.id == assetId; }), m_assets.end());
+    rebuildAssetIndex();
 }
 
 void ThreatAssessor::clearDefendedAssets() {
     m_assets.clear();
+    rebuildAssetIndex();
 }
 
 DefendedAsset* ThreatAssessor::nearestAsset(const GeoPosition& pos) {
-    if (m_assets.isEmpty()) return nullptr;
-    
-    Track tempTrack("temp");
-    tempTrack.setPosition(pos);
-    
-    DefendedAsset* nearest = nullptr;
-    double minDist = std::numeric_limits<double>::max();
-    
-    for (auto& asset : m_assets) {
-        double dist = tempTrack.distanceTo(asset.position);
-        if (dist < minDist) {
-            minDist = dist;
-            nearest = &asset;
-        }
+    const DefendedAssetFix fix = m_assetIndex.nearest(pos);
+    return fix.asset >= 0 ? &m_assets[fix.asset] : nullptr;
+}
+
+void ThreatAssessor::addGeofence(const GeofenceZone& zone) {
+    auto it = std::find_if(m_geofences.begin(), m_geofences.end(),
+        [&zone](const GeofenceZone& z) { return z.id == zone.id; });
+    if (it != m_geofences.end()) {
+        *it = zone;
+    } else {
+        m_geofences.append(zone);
     }
-    
-    return nearest;
+    rebuildGeofenceIndex();
+    Logger::instance().info("ThreatAssessor", "Added geofence: " + zone.name);
+}
+
+void ThreatAssessor::removeGeofence(const QString& zoneId) {
+    m_geofences.erase(std::remove_if(m_geofences.begin(), m_geofences.end(),
+        [&zoneId](const GeofenceZone& z) { return z.id == zoneId; }), m_geofences.end());
+    rebuildGeofenceIndex();
+}
+
+void ThreatAssessor::setGeofences(const QList<GeofenceZone>& zones) {
+    m_geofences = zones;
+    rebuildGeofenceIndex();
+}
+
+void ThreatAssessor::clearGeofences() {
+    m_geofences.clear();
+    rebuildGeofenceIndex();
 }
 
 void ThreatAssessor::addRule(const ThreatRule& rule) {
     m_rules.append(rule);
+    compileRules();
 }
 
 void ThreatAssessor::removeRule(const QString& ruleId) {
     m_rules.erase(std::remove_if(m_rules.begin(), m_rules.end(),
         [&ruleId](const ThreatRule& r) { return r.id == ruleId; }), m_rules.end());
+    compileRules();
 }
 
 void ThreatAssessor::setRuleEnabled(const QString& ruleId, bool enabled) {
     for (auto& rule : m_rules) {
         if (rule.id == ruleId) {
             rule.enabled = enabled;
+            compileRules();
             break;
         }
     }
@@ -194,6 +351,7 @@ void ThreatAssessor::setRuleEnabled(const QString& ruleId, bool enabled) {
 
 void ThreatAssessor::clearRules() {
     m_rules.clear();
+    compileRules();
 }
 
 void ThreatAssessor::loadDefaultRules() {
@@ -256,6 +414,16 @@ void ThreatAssessor::loadDefaultRules() {
     visualUnconfirmed.alertMessage = "Track %TRACK% requires visual confirmation";
     m_rules.append(visualUnconfirmed);
     
+    // Rule 6: Predicted to reach a critical radius soon
+    ThreatRule imminentImpact;
+    imminentImpact.id = "RULE-006";
+    imminentImpact.name = "Imminent Impact";
+    imminentImpact.description = "Track predicted inside a critical radius within 30 seconds";
+    imminentImpact.maxTimeToImpactSec = 30.0;
+    imminentImpact.threatLevelIncrease = 1;
+    m_rules.append(imminentImpact);
+    compileRules();
+    
     Logger::instance().info("ThreatAssessor", 
                            QString("Loaded %1 default rules").arg(m_rules.size()));
 }
@@ -266,136 +434,458 @@ void ThreatAssessor::assessTrack(const QString& trackId) {
     Track* track = m_trackManager->track(trackId);
     if (!track || track->state() == TrackState::Dropped) return;
     
-    int oldThreatLevel = track->threatLevel();
-    int newThreatLevel = calculateThreatLevel(track);
-    TrackClassification newClassification = track->classification();
+    // Read the live track so an explicit request sees changes not yet published
+    const TrackSnapshot snapshot = TrackSnapshot::fromTrack(*track);
+    assessTracks({&snapshot});
+}
+
+void ThreatAssessor::assessAllTracks() {
+    if (!m_trackManager) return;
     
-    applyRules(track, newThreatLevel, newClassification);
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    QVector<const TrackSnapshot*> tracks;
+    tracks.reserve(picture->tracks.size());
+    for (const TrackSnapshot& track : picture->tracks) {
+        if (track.state != TrackState::Dropped && !isDeferred(track)) {
+            tracks.append(&track);
+        }
+    }
+    assessTracks(tracks);
+    PipelineLatency::recordNewest(PipelineStage::ThreatAssessment, picture->newestIngestNs,
+                                  m_latencyIngestNs);
     
-    // Apply changes
-    if (newThreatLevel != oldThreatLevel) {
-        m_trackManager->setTrackThreatLevel(trackId, newThreatLevel);
-        emit threatLevelChanged(trackId, oldThreatLevel, newThreatLevel);
+    updateMetrics(*picture);
+    emit assessmentComplete();
+}
+
+void ThreatAssessor::assessTracks(const QVector<const TrackSnapshot*>& tracks) {
+    if (tracks.isEmpty()) return;
+    
+    // Scoring only reads, so chunks of a big cycle run side by side; what
+    // they produce is merged back here in track order
+    const int count = tracks.size();
+    const int chunkTracks = qMax(1, m_config.parallelChunkTracks);
+    const int chunkCount = m_config.parallelAssessment && count >= m_config.parallelMinTracks
+                               ? qBound(1, count / chunkTracks, TaskScheduler::instance().workerCount() * 4)
+                               : 1;
+    while (m_chunks.size() < chunkCount) {
+        m_chunks.append(AssessmentChunk());
+        m_chunks.last().approachKernel.setAssets(m_assetIndex);
+    }
+    for (int c = 0; c < chunkCount; ++c) {
+        const int first = static_cast<int>(qint64(count) * c / chunkCount);
+        const int last = static_cast<int>(qint64(count) * (c + 1) / chunkCount);
+        AssessmentChunk& chunk = m_chunks[c];
+        chunk.tracks.resize(last - first);
+        std::copy(tracks.constBegin() + first, tracks.constBegin() + last, chunk.tracks.begin());
+    }
+    
+    AssessmentChunk* chunks = m_chunks.data();
+    m_chunkGraph.clear();
+    for (int c = 1; c < chunkCount; ++c) {
+        AssessmentChunk* chunk = chunks + c;
+        m_chunkGraph.add([this, chunk]() { scoreChunk(*chunk); });
+    }
+    m_chunkGraph.run();
+    scoreChunk(chunks[0]);
+    m_chunkGraph.wait();
+    
+    for (int c = 0; c < chunkCount; ++c) {
+        const AssessmentChunk& chunk = chunks[c];
+        for (int i = 0; i < chunk.tracks.size(); ++i) {
+            const TrackSnapshot& track = *chunk.tracks[i];
+            m_closestApproach.insert(track.handle, chunk.approaches[i]);
+            if (m_config.tieredRates) {
+                noteTier(track.handle, tierFor(track, chunk.inputs[i]));
+            }
+            if (m_config.incrementalAssessment) {
+                m_assessedInputs.insert(track.handle, {track.position, track.velocity,
+                                                       track.classification, track.hasRFDetection,
+                                                       track.visuallyTracked});
+            }
+        }
+    }
+    publishTiers();
+    for (int c = 0; c < chunkCount; ++c) {
+        for (const ThreatRuleAlert& alert : chunks[c].alerts) {
+            generateAlert(*chunks[c].tracks[alert.input], m_rules[alert.rule]);
+        }
+    }
+    
+    if (m_config.parallelAssessment) {
+        applyAssessmentBatch(chunkCount);
+        return;
+    }
+    const AssessmentChunk& chunk = chunks[0];
+    for (int i = 0; i < chunk.tracks.size(); ++i) {
+        applyAssessment(*chunk.tracks[i], chunk.inputs[i].threatLevel, chunk.inputs[i].classification);
+    }
+}
+
+void ThreatAssessor::scoreChunk(AssessmentChunk& chunk) const {
+    chunk.approachKernel.compute(chunk.tracks, chunk.approaches);
+    
+    chunk.inputs.resize(chunk.tracks.size());
+    const int zoneSlots = m_program.zoneSlotCount();
+    chunk.zoneDistances.resize(chunk.tracks.size() * zoneSlots);
+    for (int i = 0; i < chunk.tracks.size(); ++i) {
+        const TrackSnapshot& track = *chunk.tracks[i];
+        const DefendedAssetFix fix = m_assetIndex.nearest(track.position, &track.velocity);
+        ThreatRuleInput& input = chunk.inputs[i];
+        input.proximityM = fix.distanceM;
+        input.speedMps = track.velocity.speed();
+        input.headingToAssetDeg = fix.headingOffsetDeg;
+        input.timeToImpactSec = chunk.approaches[i].timeToImpactSec;
+        input.hasRF = track.hasRFDetection;
+        input.hasVisual = track.visuallyTracked;
+        input.groupSize = track.groupSize;
+        input.threatLevel = calculateThreatLevel(track, fix);
+        input.classification = track.classification;
         
-        if (newThreatLevel >= m_config.highThreatThreshold) {
-            emit highThreatDetected(trackId);
-            
-            // Auto-slew camera to threat if enabled
-            if (m_config.autoSlewToHighestThreat && !track->isVisuallyTracked()) {
-                emit slewCameraRequest(QString(), track->position());
+        input.zoneDistancesM = nullptr;
+        if (zoneSlots > 0) {
+            double* distances = chunk.zoneDistances.data() + i * zoneSlots;
+            for (int s = 0; s < zoneSlots; ++s) {
+                distances[s] = m_geofenceIndex.signedDistanceM(m_program.zone(s), track.position,
+                                                               m_program.zoneLimitM(s));
             }
+            input.zoneDistancesM = distances;
         }
     }
     
-    if (newClassification != track->classification() &&
-        newClassification != TrackClassification::Unknown) {
-        m_trackManager->setTrackClassification(trackId, newClassification);
+    chunk.alerts.clear();
+    m_program.evaluate(chunk.inputs, &chunk.alerts);
+}
+
+void ThreatAssessor::applyAssessment(const TrackSnapshot& track, int newThreatLevel,
+                                     TrackClassification newClassification) {
+    int oldThreatLevel = track.threatLevel;
+    TrackClassification oldClassification = track.classification;
+    const bool classificationForced = newClassification != TrackClassification::Unknown;
+    
+    if (newThreatLevel == oldThreatLevel &&
+        (!classificationForced || newClassification == oldClassification)) {
+        return;
+    }
+    
+    // The snapshot can predate our own last write; compare against the live track
+    Track* live = m_trackManager->track(track.handle);
+    if (!live || live->state() == TrackState::Dropped) return;
+    oldThreatLevel = live->threatLevel();
+    oldClassification = live->classification();
+    
+    if (newThreatLevel != oldThreatLevel) {
+        m_trackManager->setTrackThreatLevel(track.trackId, newThreatLevel);
+        signalThreatLevel(track, oldThreatLevel, newThreatLevel);
+    }
+    
+    if (classificationForced && newClassification != oldClassification) {
+        m_trackManager->setTrackClassification(track.trackId, newClassification);
     }
 }
 
-void ThreatAssessor::assessAllTracks() {
-    if (!m_trackManager) return;
+void ThreatAssessor::applyAssessmentBatch(int chunkCount) {
+    m_updates.clear();
+    m_updateTracks.clear();
+    for (int c = 0; c < chunkCount; ++c) {
+        const AssessmentChunk& chunk = m_chunks[c];
+        for (int i = 0; i < chunk.tracks.size(); ++i) {
+            const TrackSnapshot& track = *chunk.tracks[i];
+            const ThreatRuleInput& input = chunk.inputs[i];
+            const bool classificationForced = input.classification != TrackClassification::Unknown;
+            if (input.threatLevel == track.threatLevel &&
+                (!classificationForced || input.classification == track.classification)) {
+                continue;
+            }
+            TrackThreatUpdate update;
+            update.handle = track.handle;
+            update.threatLevel = input.threatLevel;
+            update.classification = input.classification;
+            m_updates.append(update);
+            m_updateTracks.append(&track);
+        }
+    }
+    if (m_updates.isEmpty()) return;
     
-    QList<Track*> tracks = m_trackManager->allTracks();
-    for (Track* track : tracks) {
-        if (track->state() != TrackState::Dropped) {
-            assessTrack(track->trackId());
+    // One write lock for the lot; the live values come back for the signals
+    m_trackManager->applyThreatAssessments(m_updates);
+    for (int i = 0; i < m_updates.size(); ++i) {
+        const TrackThreatUpdate& update = m_updates[i];
+        if (update.applied && update.threatLevel != update.previousThreatLevel) {
+            signalThreatLevel(*m_updateTracks[i], update.previousThreatLevel, update.threatLevel);
         }
     }
+}
+
+void ThreatAssessor::signalThreatLevel(const TrackSnapshot& track, int oldThreatLevel, int newThreatLevel) {
+    emit threatLevelChanged(track.trackId, oldThreatLevel, newThreatLevel);
     
-    updateMetrics();
-    emit assessmentComplete();
+    if (newThreatLevel >= m_config.highThreatThreshold) {
+        emit highThreatDetected(track.trackId);
+        
+        // Auto-slew camera to threat if enabled
+        if (m_config.autoSlewToHighestThreat && !track.visuallyTracked) {
+            emit slewCameraRequest(QString(), track.position);
+        }
+    }
 }
 
 QList<Track*> ThreatAssessor::threatQueue() const {
-    if (!m_trackManager) return QList<Track*>();
-    
     QList<Track*> queue;
-    QList<Track*> allTracks = m_trackManager->allTracks();
+    if (!m_trackManager) return queue;
     
-    for (Track* t : allTracks) {
-        if (t->state() != TrackState::Dropped &&
-            (t->classification() == TrackClassification::Hostile ||
-             t->classification() == TrackClassification::Pending)) {
+    m_threatQueue.visitInOrder([this, &queue](const ThreatPriorityQueue::Entry& entry) {
+        if (Track* t = m_trackManager->track(entry.handle)) {
             queue.append(t);
         }
-    }
+        return false;
+    });
+    return queue;
+}
+
+QVector<TrackSnapshot> ThreatAssessor::threatQueueSnapshot() const {
+    QVector<TrackSnapshot> queue;
+    if (!m_trackManager) return queue;
     
-    // Sort by threat level (descending), then by distance to nearest asset
-    std::sort(queue.begin(), queue.end(), [this](Track* a, Track* b) {
-        if (a->threatLevel() != b->threatLevel()) {
-            return a->threatLevel() > b->threatLevel();
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    queue.reserve(m_threatQueue.size());
+    m_threatQueue.visitInOrder([&picture, &queue](const ThreatPriorityQueue::Entry& entry) {
+        if (const TrackSnapshot* t = picture->find(entry.handle)) {
+            queue.append(*t);
         }
-        // Equal threat level, sort by proximity
-        DefendedAsset* assetA = nullptr;
-        DefendedAsset* assetB = nullptr;
-        double distA = const_cast<ThreatAssessor*>(this)->calculateProximityToAssets(a, &assetA);
-        double distB = const_cast<ThreatAssessor*>(this)->calculateProximityToAssets(b, &assetB);
-        return distA < distB;
+        return false;
     });
-    
     return queue;
 }
 
-Track* ThreatAssessor::highestUnconfirmedThreat() const {
-    QList<Track*> queue = threatQueue();
-    for (Track* t : queue) {
-        if (!t->isVisuallyTracked()) {
-            return t;
+QVector<TrackSnapshot> ThreatAssessor::topThreats(int count) const {
+    QVector<TrackSnapshot> queue;
+    if (!m_trackManager || count <= 0) return queue;
+    
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    queue.reserve(qMin(count, m_threatQueue.size()));
+    m_threatQueue.visitInOrder([&picture, &queue, count](const ThreatPriorityQueue::Entry& entry) {
+        if (const TrackSnapshot* t = picture->find(entry.handle)) {
+            queue.append(*t);
         }
-    }
-    return nullptr;
+        return queue.size() >= count;
+    });
+    return queue;
 }
 
-QList<ThreatAlert> ThreatAssessor::unacknowledgedAlerts() const {
-    QList<ThreatAlert> result;
-    for (const auto& alert : m_alerts) {
-        if (!alert.acknowledged) {
-            result.append(alert);
-        }
-    }
+Track* ThreatAssessor::highestUnconfirmedThreat() const {
+    if (!m_trackManager) return nullptr;
+    
+    Track* result = nullptr;
+    m_threatQueue.visitInOrder([this, &result](const ThreatPriorityQueue::Entry& entry) {
+        if (entry.visuallyTracked) return false;
+        result = m_trackManager->track(entry.handle);
+        return result != nullptr;
+    });
     return result;
 }
 
+ClosestApproach ThreatAssessor::closestApproach(const QString& trackId) const {
+    if (!m_trackManager) return ClosestApproach();
+    return m_closestApproach.value(m_trackManager->handleOf(trackId));
+}
+
 void ThreatAssessor::acknowledgeAlert(const QString& alertId, const QString& operatorId) {
-    for (auto& alert : m_alerts) {
-        if (alert.alertId == alertId) {
-            alert.acknowledged = true;
-            alert.acknowledgedBy = operatorId;
-            alert.acknowledgedTime = QDateTime::currentDateTimeUtc();
-            emit alertAcknowledged(alertId);
-            break;
-        }
+    if (m_alerts.acknowledge(alertId, operatorId, clock()->nowUtc())) {
+        emit alertAcknowledged(alertId);
     }
 }
 
 void ThreatAssessor::clearAlerts() {
     m_alerts.clear();
+    emit alertsCleared();
+}
+
+void ThreatAssessor::restoreAlerts(const QList<ThreatAlert>& alerts) {
+    m_alerts.clear();
+    for (const ThreatAlert& alert : alerts) {
+        m_alerts.insert(alert);
+        continueAlertNumbering(alert.alertId);
+    }
+    emit alertsRestored();
+}
+
+void ThreatAssessor::setAlertIdPrefix(const QString& prefix) {
+    m_alertIdPrefix = prefix;
+    for (const ThreatAlert& alert : m_alerts.all()) {
+        continueAlertNumbering(alert.alertId);
+    }
+}
+
+bool ThreatAssessor::mergeAlert(const ThreatAlert& alert) {
+    if (m_alerts.find(alert.alertId)) return false;
+    
+    QString evictedId;
+    m_alerts.insert(alert, &evictedId);
+    // Ours from before a restart, handed back by a peer
+    continueAlertNumbering(alert.alertId);
+    if (!evictedId.isEmpty()) {
+        emit alertEvicted(evictedId);
+    }
+    emit newAlert(alert);
+    return true;
+}
+
+bool ThreatAssessor::mergeAcknowledgement(const QString& alertId, const QString& operatorId,
+                                          const QDateTime& time) {
+    if (!m_alerts.acknowledge(alertId, operatorId, time)) return false;
+    emit alertAcknowledged(alertId);
+    return true;
 }
 
 void ThreatAssessor::onTrackUpdated(const QString& trackId) {
     assessTrack(trackId);
 }
 
+void ThreatAssessor::onTracksUpdated(const QStringList& trackIds) {
+    for (const QString& trackId : trackIds) {
+        assessTrack(trackId);
+    }
+}
+
 void ThreatAssessor::onTrackCreated(const QString& trackId) {
     assessTrack(trackId);
 }
 
+void ThreatAssessor::onTracksChanged(const TrackChangeSet& changes) {
+    if (!m_trackManager) return;
+    
+    // Threat level and state changes are our own output or lifecycle
+    // bookkeeping; only inputs to the rules warrant a reassessment.
+    const quint32 inputs = TrackChangeKinematics | TrackChangeClassification |
+                           TrackChangeSources | TrackChangeVisual | TrackChangeGroup;
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    
+    // Everything the queue is keyed or filtered on
+    const quint32 queueInputs = TrackChangePosition | TrackChangeClassification |
+                                TrackChangeThreatLevel | TrackChangeState |
+                                TrackChangeVisual | TrackChangeCreated;
+    for (int i = 0; i < changes.size(); ++i) {
+        const quint32 fields = changes.fields[i];
+        const TrackSnapshot* track = picture->find(changes.handles[i]);
+        if ((fields & TrackChangeDropped) || !track) {
+            m_threatQueue.remove(changes.handles[i]);
+        } else if (fields & queueInputs) {
+            updateThreatQueue(*track);
+        }
+    }
+    
+    if (m_config.incrementalAssessment) {
+        // Defer evaluation to the cycle; keep the metrics current meanwhile
+        const quint32 metricInputs = inputs | TrackChangeThreatLevel | TrackChangeState;
+        for (int i = 0; i < changes.size(); ++i) {
+            const TrackHandle handle = changes.handles[i];
+            const quint32 fields = changes.fields[i];
+            const TrackSnapshot* track = picture->find(handle);
+            if ((fields & TrackChangeDropped) || !track || track->state == TrackState::Dropped) {
+                onTrackDropped(handle);
+                continue;
+            }
+            if (fields & metricInputs) updateMetricEntry(*track);
+            if (fields & inputs) m_dirtyTracks.insert(handle);
+        }
+        return;
+    }
+    
+    QVector<const TrackSnapshot*> tracks;
+    for (int i = 0; i < changes.size(); ++i) {
+        const quint32 fields = changes.fields[i];
+        if (!(fields & inputs) || (fields & TrackChangeDropped)) continue;
+        
+        const TrackSnapshot* track = picture->find(changes.handles[i]);
+        if (track && track->state != TrackState::Dropped) {
+            tracks.append(track);
+        }
+    }
+    assessTracks(tracks);
+}
+
+void ThreatAssessor::onTrackDropped(TrackHandle handle) {
+    m_threatQueue.remove(handle);
+    m_closestApproach.remove(handle);
+    m_dirtyTracks.remove(handle);
+    m_assessedInputs.remove(handle);
+    m_tiers.remove(handle);
+    m_priorityTracks.remove(handle);
+    removeMetricEntry(handle);
+}
+
 void ThreatAssessor::performAssessmentCycle() {
-    assessAllTracks();
-    m_metrics.lastAssessmentMs = QDateTime::currentMSecsSinceEpoch();
+    CUAS_TRACE_SCOPE("core", "ThreatAssessor::performAssessmentCycle");
+    const qint64 cycleStartNs = TimeUtils::monotonicNs();
+    if (m_config.learnedClassification) {
+        m_trackManager->classifyTracks();
+    }
+    m_inCycle = true;
+    if (m_config.incrementalAssessment) {
+        assessDirtyTracks();
+    } else {
+        assessAllTracks();
+    }
+    m_inCycle = false;
+    m_cycleIndex++;
+    m_metrics.lastAssessmentMs = clock()->nowMs();
+    
+    m_exported.hostile->set(m_metrics.hostileCount);
+    m_exported.pending->set(m_metrics.pendingCount);
+    m_exported.highThreat->set(m_metrics.highThreatCount);
+    m_exported.avgThreatLevel->set(m_metrics.avgThreatLevel);
+    m_exported.closestDistanceM->set(m_metrics.closestDistanceM);
+    m_exported.unacknowledgedAlerts->set(m_alerts.unacknowledgedCount());
+    const qint64 cycleUs = (TimeUtils::monotonicNs() - cycleStartNs) / 1000;
+    m_exported.cycleTime->record(cycleUs);
+    if (m_running) {
+        // Cycles a caller steps have no interval to keep
+        const qint64 budgetUs = qint64(m_config.assessmentIntervalMs) * 1000;
+        OverloadController::instance().reportStage(LoadStage::Assessment, cycleUs, budgetUs);
+        FlightRecorder::instance().reportCycle(FlightStage::Assessment, cycleUs, budgetUs);
+    }
+    
+    // The status bar's counts; a cycle that changes none of them wakes nothing
+    StatusBoard::instance().publish(STATUS_SOURCE, StatusKind::System, {
+        {"hostile", m_metrics.hostileCount},
+        {"pending", m_metrics.pendingCount},
+        {"highThreat", m_metrics.highThreatCount},
+        {"unacknowledgedAlerts", m_alerts.unacknowledgedCount()}
+    });
     emit metricsUpdated(m_metrics);
 }
 
-int ThreatAssessor::calculateThreatLevel(Track* track) {
-    if (m_assets.isEmpty()) {
-        return track->threatLevel();
+void ThreatAssessor::performPriorityCycle() {
+    CUAS_TRACE_SCOPE("core", "ThreatAssessor::performPriorityCycle");
+    if (!m_trackManager || m_priorityTracks.isEmpty()) return;
+    
+    // Nothing new since the last one; the picture only moves when tracks do
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    if (picture->sequence == m_prioritySequence) return;
+    m_prioritySequence = picture->sequence;
+    
+    QVector<const TrackSnapshot*> tracks;
+    tracks.reserve(m_priorityTracks.size());
+    for (TrackHandle handle : qAsConst(m_priorityTracks)) {
+        const TrackSnapshot* track = picture->find(handle);
+        if (track && track->state != TrackState::Dropped) {
+            tracks.append(track);
+            m_dirtyTracks.remove(handle);
+        }
+    }
+    assessTracks(tracks);
+}
+
+int ThreatAssessor::calculateThreatLevel(const TrackSnapshot& track, const DefendedAssetFix& fix) const {
+    if (fix.asset < 0) {
+        return track.threatLevel;
     }
     
     int level = 1;  // Base level
     
     // Factor 1: Classification
-    switch (track->classification()) {
+    switch (track.classification) {
         case TrackClassification::Hostile:
             level += 2;
             break;
@@ -408,183 +898,72 @@ int ThreatAssessor::calculateThreatLevel(Track* track) {
             break;
     }
     
-    // Factor 2: Proximity to defended assets
-    DefendedAsset* nearestAsset = nullptr;
-    double distance = calculateProximityToAssets(track, &nearestAsset);
+    // Factor 2: Proximity to the nearest defended asset
+    const DefendedAssetIndex::Entry& asset = m_assetIndex.entry(fix.asset);
+    if (fix.distanceSqM2 < asset.criticalRadiusSq) {
+        level += 3;
+    } else if (fix.distanceSqM2 < asset.warningRadiusSq) {
+        level += 2;
+    } else if (fix.distanceSqM2 < asset.outerRadiusSq) {
+        level += 1;
+    }
     
-    if (nearestAsset) {
-        if (distance < nearestAsset->criticalRadiusM) {
-            level += 3;
-        } else if (distance < nearestAsset->warningRadiusM) {
-            level += 2;
-        } else if (distance < nearestAsset->warningRadiusM * 2) {
-            level += 1;
-        }
-        
-        // Factor 3: Heading toward asset
-        if (isHeadingTowardAsset(track, *nearestAsset)) {
-            level += 1;
-        }
+    // Factor 3: Heading toward asset
+    if (fix.headingOffsetDeg < m_config.headingToleranceDeg) {
+        level += 1;
     }
     
     // Factor 4: Velocity
-    double speed = track->velocity().speed();
-    if (speed > 30.0) {
+    if (track.velocity.speed() > 30.0) {
         level += 1;
     }
     
     // Factor 5: Classification confidence
-    if (track->classificationConfidence() < 0.5) {
+    if (track.classificationConfidence < 0.5) {
         level = std::max(1, level - 1);  // Reduce if uncertain
     }
     
     return std::min(5, std::max(1, level));
 }
 
-void ThreatAssessor::applyRules(Track* track, int& threatLevel, 
-                                 TrackClassification& classification) {
-    DefendedAsset* nearestAsset = nullptr;
-    double proximity = calculateProximityToAssets(track, &nearestAsset);
-    double velocity = track->velocity().speed();
-    bool hasRF = track->hasSource(DetectionSource::RFDetector);
-    bool hasVisual = track->isVisuallyTracked();
-    
-    double headingToAsset = -1;
-    if (nearestAsset) {
-        double trackHeading = track->velocity().heading();
-        double bearingToAsset = track->bearingTo(nearestAsset->position);
-        headingToAsset = std::abs(trackHeading - bearingToAsset);
-        if (headingToAsset > 180.0) {
-            headingToAsset = 360.0 - headingToAsset;
-        }
-    }
-    
-    for (const ThreatRule& rule : m_rules) {
-        if (!rule.enabled) continue;
-        
-        bool ruleMatches = true;
-        
-        // Check proximity conditions
-        if (rule.minProximityM >= 0 && proximity < rule.minProximityM) {
-            ruleMatches = false;
-        }
-        if (rule.maxProximityM >= 0 && proximity > rule.maxProximityM) {
-            ruleMatches = false;
-        }
-        
-        // Check velocity conditions
-        if (rule.minVelocityMps >= 0 && velocity < rule.minVelocityMps) {
-            ruleMatches = false;
-        }
-        if (rule.maxVelocityMps >= 0 && velocity > rule.maxVelocityMps) {
-            ruleMatches = false;
-        }
-        
-        // Check heading conditions
-        if (rule.minHeadingToAssetDeg >= 0 && headingToAsset >= 0) {
-            if (headingToAsset < rule.minHeadingToAssetDeg ||
-                headingToAsset > rule.maxHeadingToAssetDeg) {
-                ruleMatches = false;
-            }
-        }
-        
-        // Check RF detection requirement
-        if (rule.requiresRFDetection && !hasRF) {
-            ruleMatches = false;
-        }
-        
-        // Check visual confirmation requirement
-        if (rule.requiresVisualConfirmation && !hasVisual) {
-            ruleMatches = false;
-        }
-        
-        if (ruleMatches) {
-            // Apply rule actions
-            if (rule.setThreatLevel >= 0) {
-                threatLevel = rule.setThreatLevel;
-            } else {
-                threatLevel += rule.threatLevelIncrease;
-            }
-            
-            if (rule.forceClassification != TrackClassification::Unknown) {
-                classification = rule.forceClassification;
-            }
-            
-            if (rule.generateAlert) {
-                generateAlert(track, rule);
-            }
-        }
-    }
-    
-    threatLevel = std::min(5, std::max(1, threatLevel));
-}
-
-double ThreatAssessor::calculateProximityToAssets(Track* track, DefendedAsset** nearestAsset) {
-    if (m_assets.isEmpty()) {
-        if (nearestAsset) *nearestAsset = nullptr;
-        return std::numeric_limits<double>::max();
-    }
-    
-    double minDist = std::numeric_limits<double>::max();
-    DefendedAsset* nearest = nullptr;
-    
-    for (auto& asset : m_assets) {
-        double dist = track->distanceTo(asset.position);
-        if (dist < minDist) {
-            minDist = dist;
-            nearest = &asset;
-        }
-    }
-    
-    if (nearestAsset) *nearestAsset = nearest;
-    return minDist;
-}
-
-bool ThreatAssessor::isHeadingTowardAsset(Track* track, const DefendedAsset& asset) {
-    double trackHeading = track->velocity().heading();
-    double bearingToAsset = track->bearingTo(asset.position);
-    
-    double diff = std::abs(trackHeading - bearingToAsset);
-    if (diff > 180.0) {
-        diff = 360.0 - diff;
-    }
-    
-    return diff < m_config.headingToleranceDeg;
+double ThreatAssessor::proximityToAssets(const GeoPosition& pos) const {
+    return m_assetIndex.nearestDistance(pos);
 }
 
-void ThreatAssessor::generateAlert(Track* track, const ThreatRule& rule) {
-    // Check for duplicate recent alerts
-    for (const auto& existing : m_alerts) {
-        if (existing.trackId == track->trackId() && 
-            !existing.acknowledged &&
-            existing.timestamp.secsTo(QDateTime::currentDateTimeUtc()) < 30) {
-            return;  // Don't spam alerts
-        }
+void ThreatAssessor::generateAlert(const TrackSnapshot& track, const ThreatRule& rule) {
+    // Don't spam: one open alert per track and rule within the window, and
+    // per group rather than per member for a group rule
+    const quint32 groupId = rule.minGroupSize > 0 ? track.groupId : 0;
+    const QDateTime now = clock()->nowUtc();
+    if (m_alerts.isSuppressed(groupId != 0 ? ThreatAlertStore::groupSubject(groupId) : track.trackId,
+                              rule.id, now.toMSecsSinceEpoch(),
+                              m_config.alertSuppressionSec * 1000LL)) {
+        return;
     }
     
     ThreatAlert alert;
     alert.alertId = generateAlertId();
-    alert.trackId = track->trackId();
+    alert.trackId = track.trackId;
+    alert.ruleId = rule.id;
+    alert.groupId = groupId;
     alert.message = rule.alertMessage;
-    alert.message.replace("%TRACK%", track->trackId());
-    alert.threatLevel = track->threatLevel();
-    alert.timestamp = QDateTime::currentDateTimeUtc();
+    alert.message.replace("%TRACK%", track.trackId);
+    alert.threatLevel = track.threatLevel;
+    alert.timestamp = now;
     
-    m_alerts.append(alert);
-    
-    // Trim alert queue if too large
-    while (m_alerts.size() > m_config.alertQueueMaxSize) {
-        m_alerts.removeFirst();
-    }
+    QString evictedId;
+    m_alerts.insert(alert, &evictedId);
+    m_exported.alerts->add();
     
     Logger::instance().warning("ThreatAssessor", 
                                QString("Alert: %1").arg(alert.message));
+    if (!evictedId.isEmpty()) {
+        emit alertEvicted(evictedId);
+    }
     emit newAlert(alert);
 }
 
-void ThreatAssessor::updateMetrics() {
-    if (!m_trackManager) return;
-    
+void ThreatAssessor::updateMetrics(const TrackPicture& picture) {
     m_metrics.hostileCount = 0;
     m_metrics.pendingCount = 0;
     m_metrics.highThreatCount = 0;
@@ -593,41 +972,222 @@ void ThreatAssessor::updateMetrics() {
     double closestDist = std::numeric_limits<double>::max();
     int highestThreat = 0;
     
-    QList<Track*> tracks = m_trackManager->allTracks();
-    for (Track* t : tracks) {
-        if (t->state() == TrackState::Dropped) continue;
+    for (const TrackSnapshot& t : picture.tracks) {
+        if (t.state == TrackState::Dropped) continue;
         
         trackCount++;
-        totalThreat += t->threatLevel();
+        totalThreat += t.threatLevel;
         
-        if (t->classification() == TrackClassification::Hostile) {
+        if (t.classification == TrackClassification::Hostile) {
             m_metrics.hostileCount++;
-        } else if (t->classification() == TrackClassification::Pending) {
+        } else if (t.classification == TrackClassification::Pending) {
             m_metrics.pendingCount++;
         }
         
-        if (t->threatLevel() >= m_config.highThreatThreshold) {
+        if (t.threatLevel >= m_config.highThreatThreshold) {
             m_metrics.highThreatCount++;
         }
         
-        if (t->threatLevel() > highestThreat) {
-            highestThreat = t->threatLevel();
-            m_metrics.highestThreatTrackId = t->trackId();
+        if (t.threatLevel > highestThreat) {
+            highestThreat = t.threatLevel;
+            m_metrics.highestThreatTrackId = t.trackId;
         }
         
-        DefendedAsset* asset = nullptr;
-        double dist = calculateProximityToAssets(t, &asset);
-        if (dist < closestDist) {
-            closestDist = dist;
-        }
+        closestDist = std::min(closestDist, proximityToAssets(t.position));
     }
     
     m_metrics.avgThreatLevel = trackCount > 0 ? totalThreat / trackCount : 0.0;
     m_metrics.closestDistanceM = closestDist < std::numeric_limits<double>::max() ? closestDist : -1;
 }
 
+void ThreatAssessor::compileRules() {
+    m_program.compile(m_rules, &m_geofenceIndex);
+    m_reassessAll = true;
+}
+
+void ThreatAssessor::rebuildGeofenceIndex() {
+    m_geofenceIndex.rebuild(m_geofences);
+    // Zone conditions hold indices into the index
+    compileRules();
+    emit geofencesChanged();
+}
+
+void ThreatAssessor::rebuildAssetIndex() {
+    m_assetIndex.rebuild(m_assets);
+    for (AssessmentChunk& chunk : m_chunks) {
+        chunk.approachKernel.setAssets(m_assetIndex);
+    }
+    m_reassessAll = true;
+    
+    // Every range in the queue was measured against the old assets
+    if (m_trackManager) {
+        rebuildThreatQueue(*m_trackManager->snapshot());
+    }
+}
+
+void ThreatAssessor::updateThreatQueue(const TrackSnapshot& track) {
+    if (track.state == TrackState::Dropped ||
+        (track.classification != TrackClassification::Hostile &&
+         track.classification != TrackClassification::Pending)) {
+        m_threatQueue.remove(track.handle);
+        return;
+    }
+    
+    ThreatPriorityQueue::Entry entry;
+    entry.handle = track.handle;
+    entry.threatLevel = track.threatLevel;
+    entry.rangeM = m_assetIndex.nearestDistance(track.position);
+    entry.visuallyTracked = track.visuallyTracked;
+    m_threatQueue.update(entry);
+}
+
+void ThreatAssessor::rebuildThreatQueue(const TrackPicture& picture) {
+    m_threatQueue.clear();
+    for (const TrackSnapshot& track : picture.tracks) {
+        updateThreatQueue(track);
+    }
+}
+
+void ThreatAssessor::assessDirtyTracks() {
+    if (!m_trackManager) return;
+    
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    if (m_reassessAll) {
+        // Rules, assets or config changed: every track and metric is stale
+        rebuildIncrementalState(*picture);
+    } else {
+        // Deferred tracks stay dirty for their own cycle
+        QVector<const TrackSnapshot*> tracks;
+        tracks.reserve(m_dirtyTracks.size());
+        for (auto it = m_dirtyTracks.begin(); it != m_dirtyTracks.end();) {
+            const TrackSnapshot* track = picture->find(*it);
+            if (track && track->state != TrackState::Dropped && isDeferred(*track)) {
+                ++it;
+                continue;
+            }
+            if (track && track->state != TrackState::Dropped && needsReassessment(*track)) {
+                tracks.append(track);
+            }
+            it = m_dirtyTracks.erase(it);
+        }
+        assessTracks(tracks);
+    }
+    PipelineLatency::recordNewest(PipelineStage::ThreatAssessment, picture->newestIngestNs,
+                                  m_latencyIngestNs);
+    
+    publishIncrementalMetrics();
+    emit assessmentComplete();
+}
+
+bool ThreatAssessor::needsReassessment(const TrackSnapshot& track) const {
+    auto it = m_assessedInputs.constFind(track.handle);
+    if (it == m_assessedInputs.constEnd()) return true;
+    
+    const AssessedInputs& last = it.value();
+    if (track.classification != last.classification ||
+        track.hasRFDetection != last.hasRF ||
+        track.visuallyTracked != last.visual) {
+        return true;
+    }
+    
+    const double dn = track.velocity.north - last.velocity.north;
+    const double de = track.velocity.east - last.velocity.east;
+    const double dd = track.velocity.down - last.velocity.down;
+    if (std::sqrt(dn * dn + de * de + dd * dd) > m_config.reassessVelocityMps) {
+        return true;
+    }
+    return CoordinateUtils::haversineDistance(track.position, last.position) > m_config.reassessDistanceM;
+}
+
+void ThreatAssessor::rebuildIncrementalState(const TrackPicture& picture) {
+    m_reassessAll = false;
+    m_dirtyTracks.clear();
+    m_assessedInputs.clear();
+    m_metricEntries.clear();
+    m_tracksByThreat.clear();
+    m_tracksByProximity.clear();
+    m_threatLevelSum = 0;
+    m_metrics.hostileCount = 0;
+    m_metrics.pendingCount = 0;
+    m_metrics.highThreatCount = 0;
+    
+    QVector<const TrackSnapshot*> tracks;
+    tracks.reserve(picture.tracks.size());
+    for (const TrackSnapshot& track : picture.tracks) {
+        if (track.state == TrackState::Dropped) continue;
+        tracks.append(&track);
+        updateMetricEntry(track);
+    }
+    // Level changes made here arrive back through the next change set
+    assessTracks(tracks);
+}
+
+void ThreatAssessor::updateMetricEntry(const TrackSnapshot& track) {
+    removeMetricEntry(track.handle);
+    
+    MetricEntry entry;
+    entry.trackId = track.trackId;
+    entry.threatLevel = track.threatLevel;
+    entry.classification = track.classification;
+    entry.proximityM = proximityToAssets(track.position);
+    
+    m_metricEntries.insert(track.handle, entry);
+    m_tracksByThreat.insert(entry.threatLevel, track.handle);
+    m_tracksByProximity.insert(entry.proximityM, track.handle);
+    applyMetricContribution(entry, 1);
+}
+
+void ThreatAssessor::removeMetricEntry(TrackHandle handle) {
+    auto it = m_metricEntries.find(handle);
+    if (it == m_metricEntries.end()) return;
+    
+    m_tracksByThreat.remove(it->threatLevel, handle);
+    m_tracksByProximity.remove(it->proximityM, handle);
+    applyMetricContribution(it.value(), -1);
+    m_metricEntries.erase(it);
+}
+
+void ThreatAssessor::applyMetricContribution(const MetricEntry& entry, int sign) {
+    m_threatLevelSum += sign * entry.threatLevel;
+    if (entry.classification == TrackClassification::Hostile) {
+        m_metrics.hostileCount += sign;
+    } else if (entry.classification == TrackClassification::Pending) {
+        m_metrics.pendingCount += sign;
+    }
+    if (entry.threatLevel >= m_config.highThreatThreshold) {
+        m_metrics.highThreatCount += sign;
+    }
+}
+
+void ThreatAssessor::publishIncrementalMetrics() {
+    const int trackCount = m_metricEntries.size();
+    m_metrics.avgThreatLevel = trackCount > 0 ? static_cast<double>(m_threatLevelSum) / trackCount : 0.0;
+    
+    m_metrics.highestThreatTrackId.clear();
+    if (!m_tracksByThreat.isEmpty()) {
+        auto highest = std::prev(m_tracksByThreat.constEnd());
+        m_metrics.highestThreatTrackId = m_metricEntries.value(highest.value()).trackId;
+    }
+    
+    m_metrics.closestDistanceM = -1;
+    if (!m_tracksByProximity.isEmpty() &&
+        m_tracksByProximity.firstKey() < std::numeric_limits<double>::max()) {
+        m_metrics.closestDistanceM = m_tracksByProximity.firstKey();
+    }
+}
+
 QString ThreatAssessor::generateAlertId() {
-    return QString("ALERT-%1").arg(m_nextAlertNumber++, 6, 10, QChar('0'));
+    const QString id = QString("ALERT-%1").arg(m_nextAlertNumber++, 6, 10, QChar('0'));
+    return m_alertIdPrefix.isEmpty() ? id : m_alertIdPrefix + QLatin1Char('-') + id;
+}
+
+void ThreatAssessor::continueAlertNumbering(const QString& alertId) {
+    // Only this node's ids; another node's numbers are its own
+    const QString stem = m_alertIdPrefix.isEmpty() ? QStringLiteral("ALERT-")
+                                                   : m_alertIdPrefix + QStringLiteral("-ALERT-");
+    if (!alertId.startsWith(stem)) return;
+    const int number = alertId.mid(stem.size()).toInt();
+    m_nextAlertNumber = qMax(m_nextAlertNumber, number + 1);
 }
 
 } // namespace CounterUAS
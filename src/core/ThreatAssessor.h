@@ -3,13 +3,31 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QMultiMap>
+#include <QSet>
+#include <QStringList>
 #include <QTimer>
 #include <QJsonObject>
 #include "core/Track.h"
+#include "core/TrackSnapshot.h"
+#include "core/TrackChangeSet.h"
+#include "core/TrackManager.h"
+#include "core/ThreatRuleProgram.h"
+#include "core/DefendedAssetIndex.h"
+#include "core/GeofenceIndex.h"
+#include "core/ThreatPriorityQueue.h"
+#include "core/ClosestApproach.h"
+#include "core/ThreatAlertStore.h"
+#include "utils/Clock.h"
+#include "utils/TaskScheduler.h"
 
 namespace CounterUAS {
 
-class TrackManager;
+class TrackChangeThrottle;
+class MetricCounter;
+class MetricGauge;
+class LatencyHistogram;
 
 /**
  * @brief Defended asset definition
@@ -42,8 +60,13 @@ struct ThreatRule {
     double maxVelocityMps = -1;
     double minHeadingToAssetDeg = -1;   // Heading toward defended asset
     double maxHeadingToAssetDeg = -1;
+    double maxTimeToImpactSec = -1;     // Predicted entry into an asset's critical radius
     bool requiresVisualConfirmation = false;
     bool requiresRFDetection = false;
+    QString zoneId;                     // Geofence the track must be in; empty means any
+    bool requiresOutsideZone = false;   // Must be outside it instead
+    double zoneMarginM = 0.0;           // Boundary offset, positive outward
+    int minGroupSize = -1;              // Track must fly in a swarm group this large; alerts once per group
     
     // Actions
     int threatLevelIncrease = 0;
@@ -56,31 +79,51 @@ struct ThreatRule {
     static ThreatRule fromJson(const QJsonObject& json);
 };
 
-/**
- * @brief Threat alert structure
- */
-struct ThreatAlert {
-    QString alertId;
-    QString trackId;
-    QString message;
-    int threatLevel;
-    QDateTime timestamp;
-    bool acknowledged = false;
-    QString acknowledgedBy;
-    QDateTime acknowledgedTime;
-    
-    QJsonObject toJson() const;
-};
-
 /**
  * @brief Threat assessment configuration
  */
 struct ThreatAssessorConfig {
     int assessmentIntervalMs = 500;
     int alertQueueMaxSize = 100;
+    int alertSuppressionSec = 30;        // Repeat window per (track, rule) while unacknowledged
     bool autoSlewToHighestThreat = true;
     int highThreatThreshold = 4;
     double headingToleranceDeg = 30.0;
+    int maxChangeRateHz = 5;             // Reassessment rate for changed tracks
+    
+    // Incremental mode: each cycle only re-evaluates tracks that changed since
+    // their last assessment by more than these thresholds (classification,
+    // RF and visual changes always count), and metrics are kept up to date
+    // from change sets instead of being recomputed.
+    bool incrementalAssessment = false;
+    double reassessDistanceM = 10.0;
+    double reassessVelocityMps = 2.0;    // Magnitude of the velocity vector change
+    
+    // Parallel mode: a cycle of at least parallelMinTracks is scored in
+    // chunks of about parallelChunkTracks on the shared TaskScheduler,
+    // and, whatever its size, its results go to the track manager in one
+    // applyThreatAssessments() batch rather than a write per track.
+    bool parallelAssessment = false;
+    int parallelMinTracks = 512;
+    int parallelChunkTracks = 256;
+    
+    // Learned classification: each cycle starts with
+    // TrackManager::classifyTracks(), so classificationConfidence comes
+    // from the track classifier rather than only from the RF rule
+    bool learnedClassification = false;
+    
+    // Tiered rates: each assessment sets the track's TrackUpdateTier.
+    // Priority tracks (at or above the high threat threshold, hostile,
+    // within priorityRangeM or predicted to arrive within
+    // priorityImpactSec) are assessed at priorityAssessmentHz on their own
+    // timer; background ones (threat level 1, not pending, beyond
+    // backgroundRangeM and not closing) at backgroundAssessmentHz
+    bool tieredRates = false;
+    int priorityAssessmentHz = 20;
+    double backgroundAssessmentHz = 1.0;
+    double priorityRangeM = 1000.0;
+    double priorityImpactSec = 60.0;
+    double backgroundRangeM = 3000.0;
 };
 
 /**
@@ -90,6 +133,9 @@ class ThreatAssessor : public QObject {
     Q_OBJECT
     
 public:
+    // StatusBoard source of the counts, StatusKind::System
+    static constexpr const char* STATUS_SOURCE = "threat";
+    
     explicit ThreatAssessor(TrackManager* trackManager, QObject* parent = nullptr);
     ~ThreatAssessor() override;
     
@@ -97,10 +143,23 @@ public:
     void setConfig(const ThreatAssessorConfig& config);
     ThreatAssessorConfig config() const { return m_config; }
     
+    // Load shedding: a scheduled cycle assesses tracks below the high
+    // threat threshold that are not hostile only one cycle in stride,
+    // spread across cycles by handle; 1 assesses every track every cycle
+    void setLowThreatStride(int stride);
+    int lowThreatStride() const { return m_lowThreatStride; }
+    
+    // Alert and metric times; null follows the track manager's clock
+    void setClock(const Clock* clock) { m_clock = clock; }
+    const Clock* clock() const;
+    
     // Lifecycle
     void start();
     void stop();
     bool isRunning() const { return m_running; }
+    // Delivers pending track changes and runs one assessment cycle now, for
+    // a caller driving assessment on its own clock while the timer is stopped
+    void step();
     
     // Defended assets
     void addDefendedAsset(const DefendedAsset& asset);
@@ -109,6 +168,14 @@ public:
     QList<DefendedAsset> defendedAssets() const { return m_assets; }
     DefendedAsset* nearestAsset(const GeoPosition& pos);
     
+    // Geofences the rules test; adding a zone replaces one with the same id
+    void addGeofence(const GeofenceZone& zone);
+    void removeGeofence(const QString& zoneId);
+    void setGeofences(const QList<GeofenceZone>& zones);
+    void clearGeofences();
+    QList<GeofenceZone> geofences() const { return m_geofences; }
+    const GeofenceIndex& geofenceIndex() const { return m_geofenceIndex; }
+    
     // Threat rules
     void addRule(const ThreatRule& rule);
     void removeRule(const QString& ruleId);
@@ -121,15 +188,35 @@ public:
     void assessTrack(const QString& trackId);
     void assessAllTracks();
     
-    // Threat queue
-    QList<Track*> threatQueue() const;  // Sorted by threat level
-    Track* highestUnconfirmedThreat() const;
+    // Threat queue, maintained from change sets: hostile and pending tracks
+    // by threat level, then range to the nearest asset
+    QList<Track*> threatQueue() const;
+    QVector<TrackSnapshot> threatQueueSnapshot() const;  // Same ordering, lock-free
+    QVector<TrackSnapshot> topThreats(int count) const;  // The first count of it, O(count log count)
+    Track* highestUnconfirmedThreat() const;             // O(1) unless the top is on camera
     
-    // Alert management
-    QList<ThreatAlert> alerts() const { return m_alerts; }
-    QList<ThreatAlert> unacknowledgedAlerts() const;
+    // CPA and time to impact from the track's last assessment
+    ClosestApproach closestApproach(const QString& trackId) const;
+    
+    // Alert management (bounded to alertQueueMaxSize, oldest evicted first)
+    QList<ThreatAlert> alerts() const { return m_alerts.all(); }
+    QList<ThreatAlert> unacknowledgedAlerts() const { return m_alerts.unacknowledged(); }
+    int unacknowledgedAlertCount() const { return m_alerts.unacknowledgedCount(); }
+    const ThreatAlert* alert(const QString& alertId) const { return m_alerts.find(alertId); }
     void acknowledgeAlert(const QString& alertId, const QString& operatorId);
     void clearAlerts();
+    // Alerts carried over from a checkpoint, oldest first. Replaces the
+    // current ones and continues the id sequence after them.
+    void restoreAlerts(const QList<ThreatAlert>& alerts);
+    
+    // Alert ids become <prefix>-ALERT-n, so nodes sharing alerts never reuse
+    // each other's; empty for the plain ALERT-n
+    void setAlertIdPrefix(const QString& prefix);
+    QString alertIdPrefix() const { return m_alertIdPrefix; }
+    // Another node's alert, or its acknowledgement of one; announced like a
+    // local one but not counted as raised here. False when already held.
+    bool mergeAlert(const ThreatAlert& alert);
+    bool mergeAcknowledgement(const QString& alertId, const QString& operatorId, const QDateTime& time);
     
     // Real-time metrics
     struct ThreatMetrics {
@@ -147,38 +234,148 @@ signals:
     void threatLevelChanged(const QString& trackId, int oldLevel, int newLevel);
     void newAlert(const ThreatAlert& alert);
     void alertAcknowledged(const QString& alertId);
+    void alertEvicted(const QString& alertId);
+    void alertsCleared();
+    void alertsRestored();              // The store was replaced by restoreAlerts(); re-read it
     void highThreatDetected(const QString& trackId);
     void metricsUpdated(const ThreatMetrics& metrics);
     void assessmentComplete();
+    void geofencesChanged();
     void slewCameraRequest(const QString& cameraId, const GeoPosition& pos);
     
 public slots:
     void onTrackUpdated(const QString& trackId);
+    void onTracksUpdated(const QStringList& trackIds);
     void onTrackCreated(const QString& trackId);
+    void onTracksChanged(const TrackChangeSet& changes);
+    void onTrackDropped(TrackHandle handle);
     
 private slots:
     void performAssessmentCycle();
+    void performPriorityCycle();
     
 private:
-    int calculateThreatLevel(Track* track);
-    void applyRules(Track* track, int& threatLevel, TrackClassification& classification);
-    double calculateProximityToAssets(Track* track, DefendedAsset** nearestAsset);
-    bool isHeadingTowardAsset(Track* track, const DefendedAsset& asset);
-    void generateAlert(Track* track, const ThreatRule& rule);
-    void updateMetrics();
+    // Batch assessment: base level, compiled rules, then the resulting writes
+    struct AssessmentChunk {
+        ClosestApproachKernel approachKernel;     // Assets from m_assetIndex
+        QVector<const TrackSnapshot*> tracks;
+        QVector<ClosestApproach> approaches;
+        QVector<ThreatRuleInput> inputs;
+        QVector<double> zoneDistances;            // Zone slots per input, back to back
+        QVector<ThreatRuleAlert> alerts;          // Inputs indexed within the chunk
+    };
+    void assessTracks(const QVector<const TrackSnapshot*>& tracks);
+    // Reads only the snapshots, assets and compiled rules; any thread
+    void scoreChunk(AssessmentChunk& chunk) const;
+    void applyAssessment(const TrackSnapshot& track, int newThreatLevel,
+                         TrackClassification newClassification);
+    void applyAssessmentBatch(int chunkCount);
+    void signalThreatLevel(const TrackSnapshot& track, int oldThreatLevel, int newThreatLevel);
+    int calculateThreatLevel(const TrackSnapshot& track, const DefendedAssetFix& fix) const;
+    double proximityToAssets(const GeoPosition& pos) const;
+    void generateAlert(const TrackSnapshot& track, const ThreatRule& rule);
+    void updateMetrics(const TrackPicture& picture);
     QString generateAlertId();
+    void continueAlertNumbering(const QString& alertId);
+    
+    // Rebuilt whenever m_rules, m_assets or m_geofences change
+    void compileRules();
+    void rebuildAssetIndex();
+    void rebuildGeofenceIndex();
+    
+    // Threat queue maintenance
+    void updateThreatQueue(const TrackSnapshot& track);
+    void rebuildThreatQueue(const TrackPicture& picture);
+    
+    // Incremental mode
+    struct AssessedInputs {
+        GeoPosition position;
+        VelocityVector velocity;
+        TrackClassification classification;
+        bool hasRF;
+        bool visual;
+    };
+    struct MetricEntry {
+        QString trackId;
+        int threatLevel;
+        TrackClassification classification;
+        double proximityM;
+    };
+    void assessDirtyTracks();
+    // Left for a later cycle by the low threat stride
+    bool isDeferred(const TrackSnapshot& track) const;
+    
+    // Tiered rates
+    TrackUpdateTier tierFor(const TrackSnapshot& track, const ThreatRuleInput& input) const;
+    void noteTier(TrackHandle handle, TrackUpdateTier tier);
+    void publishTiers();            // Changes noted since, to the track manager
+    void resetTiers();
+    void updatePriorityTimer();
+    bool needsReassessment(const TrackSnapshot& track) const;
+    void rebuildIncrementalState(const TrackPicture& picture);
+    void updateMetricEntry(const TrackSnapshot& track);
+    void removeMetricEntry(TrackHandle handle);
+    void applyMetricContribution(const MetricEntry& entry, int sign);
+    void publishIncrementalMetrics();
     
     TrackManager* m_trackManager;
     ThreatAssessorConfig m_config;
     QTimer* m_assessmentTimer;
+    QTimer* m_priorityTimer;          // Tiered rates: priority tracks' own cycle
+    TrackChangeThrottle* m_changeThrottle = nullptr;
+    const Clock* m_clock = nullptr;
     bool m_running = false;
+    int m_lowThreatStride = 1;
+    quint64 m_cycleIndex = 0;         // Scheduled cycles run, for the stride
+    bool m_inCycle = false;           // Manual assessments ignore the stride
+    
+    // Tiered rates; tracks missing from m_tiers are Routine
+    QHash<TrackHandle, TrackUpdateTier> m_tiers;
+    QSet<TrackHandle> m_priorityTracks;
+    QVector<QPair<TrackHandle, TrackUpdateTier>> m_tierChanges;
+    quint64 m_prioritySequence = 0;   // Picture the priority cycle last assessed
     
     QList<DefendedAsset> m_assets;
     QList<ThreatRule> m_rules;
-    QList<ThreatAlert> m_alerts;
+    QList<GeofenceZone> m_geofences;
+    ThreatAlertStore m_alerts;
+    
+    ThreatRuleProgram m_program;                  // Enabled m_rules, compiled
+    DefendedAssetIndex m_assetIndex;              // Parallel to m_assets
+    GeofenceIndex m_geofenceIndex;                // Parallel to m_geofences
+    ThreatPriorityQueue m_threatQueue;
+    QVector<AssessmentChunk> m_chunks;            // The first also serves serial cycles
+    TaskGraph m_chunkGraph{TaskPriority::Realtime};  // Parallel mode's chunks past the first
+    QVector<TrackThreatUpdate> m_updates;         // Parallel mode's batch, reused
+    QVector<const TrackSnapshot*> m_updateTracks; // Parallel to m_updates
+    QHash<TrackHandle, ClosestApproach> m_closestApproach;
+    qint64 m_latencyIngestNs = 0;     // Newest plot already counted in PipelineLatency
+    
+    // Incremental mode state, rebuilt from the picture when m_reassessAll is set
+    bool m_reassessAll = true;
+    QSet<TrackHandle> m_dirtyTracks;
+    QHash<TrackHandle, AssessedInputs> m_assessedInputs;
+    QHash<TrackHandle, MetricEntry> m_metricEntries;
+    QMultiMap<int, TrackHandle> m_tracksByThreat;
+    QMultiMap<double, TrackHandle> m_tracksByProximity;
+    qint64 m_threatLevelSum = 0;
     
     ThreatMetrics m_metrics;
     int m_nextAlertNumber = 1;
+    QString m_alertIdPrefix;
+    
+    // Fleet monitoring series, registered once in the constructor
+    struct ExportedMetrics {
+        MetricGauge* hostile = nullptr;
+        MetricGauge* pending = nullptr;
+        MetricGauge* highThreat = nullptr;
+        MetricGauge* avgThreatLevel = nullptr;
+        MetricGauge* closestDistanceM = nullptr;
+        MetricGauge* unacknowledgedAlerts = nullptr;
+        MetricCounter* alerts = nullptr;
+        LatencyHistogram* cycleTime = nullptr;
+    };
+    ExportedMetrics m_exported;
 };
 
 } // namespace CounterUAS
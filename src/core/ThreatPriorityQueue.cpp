@@ -0,0 +1,93 @@
+#include "core/ThreatPriorityQueue.h"
+
+namespace CounterUAS {
+
+bool ThreatPriorityQueue::higherPriority(const Entry& a, const Entry& b) {
+    if (a.threatLevel != b.threatLevel) {
+        return a.threatLevel > b.threatLevel;
+    }
+    return a.rangeM < b.rangeM;
+}
+
+void ThreatPriorityQueue::update(const Entry& entry) {
+    auto it = m_slots.constFind(entry.handle);
+    if (it == m_slots.constEnd()) {
+        m_heap.append(entry);
+        m_slots.insert(entry.handle, m_heap.size() - 1);
+        siftUp(m_heap.size() - 1);
+        return;
+    }
+
+    const int slot = it.value();
+    const bool raised = higherPriority(entry, m_heap[slot]);
+    m_heap[slot] = entry;
+    if (raised) {
+        siftUp(slot);
+    } else {
+        siftDown(slot);
+    }
+}
+
+void ThreatPriorityQueue::remove(TrackHandle handle) {
+    auto it = m_slots.find(handle);
+    if (it == m_slots.end()) return;
+
+    const int slot = it.value();
+    m_slots.erase(it);
+
+    const int last = m_heap.size() - 1;
+    if (slot == last) {
+        m_heap.removeLast();
+        return;
+    }
+
+    // Fill the hole with the last entry and restore the order around it
+    const Entry moved = m_heap[last];
+    m_heap.removeLast();
+    place(slot, moved);
+    siftUp(slot);
+    siftDown(m_slots.value(moved.handle));
+}
+
+void ThreatPriorityQueue::clear() {
+    m_heap.clear();
+    m_slots.clear();
+}
+
+QVector<ThreatPriorityQueue::Entry> ThreatPriorityQueue::ordered() const {
+    QVector<Entry> result = m_heap;
+    std::sort(result.begin(), result.end(), &ThreatPriorityQueue::higherPriority);
+    return result;
+}
+
+void ThreatPriorityQueue::place(int slot, const Entry& entry) {
+    m_heap[slot] = entry;
+    m_slots[entry.handle] = slot;
+}
+
+void ThreatPriorityQueue::siftUp(int slot) {
+    const Entry entry = m_heap[slot];
+    while (slot > 0) {
+        const int parent = (slot - 1) / 2;
+        if (!higherPriority(entry, m_heap[parent])) break;
+        place(slot, m_heap[parent]);
+        slot = parent;
+    }
+    place(slot, entry);
+}
+
+void ThreatPriorityQueue::siftDown(int slot) {
+    const Entry entry = m_heap[slot];
+    const int count = m_heap.size();
+    for (;;) {
+        int child = 2 * slot + 1;
+        if (child >= count) break;
+        if (child + 1 < count && higherPriority(m_heap[child + 1], m_heap[child])) ++child;
+        if (!higherPriority(m_heap[child], entry)) break;
+        place(slot, m_heap[child]);
+        slot = child;
+    }
+    place(slot, entry);
+}
+
+} // namespace CounterUAS
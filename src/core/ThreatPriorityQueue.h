@@ -0,0 +1,82 @@
+#ifndef THREATPRIORITYQUEUE_H
+#define THREATPRIORITYQUEUE_H
+
+#include <QHash>
+#include <QVector>
+#include <algorithm>
+#include "core/TrackHandle.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Indexed binary max-heap of tracks ordered by threat
+ *
+ * Higher threat level first, then shorter range to the nearest defended
+ * asset. A handle-to-slot index lets callers update or remove a track in
+ * O(log N) as its level or position changes, so the top of the queue is
+ * always available in O(1) instead of re-sorting every track on each read.
+ */
+class ThreatPriorityQueue {
+public:
+    struct Entry {
+        TrackHandle handle = INVALID_TRACK_HANDLE;
+        int threatLevel = 1;
+        double rangeM = 0.0;
+        bool visuallyTracked = false;
+    };
+
+    // Insert, or re-key an entry already present
+    void update(const Entry& entry);
+    void remove(TrackHandle handle);
+    void clear();
+
+    bool isEmpty() const { return m_heap.isEmpty(); }
+    int size() const { return m_heap.size(); }
+    bool contains(TrackHandle handle) const { return m_slots.contains(handle); }
+
+    // Highest-priority entry; the queue must not be empty
+    const Entry& top() const { return m_heap.first(); }
+
+    // Calls visit(entry) in priority order until it returns true. Costs
+    // O(k log k) for the k entries visited, so early exits stay cheap.
+    template<typename Visitor>
+    void visitInOrder(Visitor visit) const;
+
+    // Every entry in priority order
+    QVector<Entry> ordered() const;
+
+    static bool higherPriority(const Entry& a, const Entry& b);
+
+private:
+    void place(int slot, const Entry& entry);
+    void siftUp(int slot);
+    void siftDown(int slot);
+
+    QVector<Entry> m_heap;
+    QHash<TrackHandle, int> m_slots;
+};
+
+template<typename Visitor>
+void ThreatPriorityQueue::visitInOrder(Visitor visit) const {
+    if (m_heap.isEmpty()) return;
+
+    // Best-first walk of the heap: the frontier holds slots whose parents
+    // have been visited, itself kept as a heap on the same ordering.
+    auto lower = [this](int a, int b) { return higherPriority(m_heap[b], m_heap[a]); };
+    QVector<int> frontier;
+    frontier.append(0);
+    while (!frontier.isEmpty()) {
+        std::pop_heap(frontier.begin(), frontier.end(), lower);
+        const int slot = frontier.takeLast();
+        if (visit(m_heap[slot])) return;
+
+        for (int child = 2 * slot + 1; child <= 2 * slot + 2 && child < m_heap.size(); ++child) {
+            frontier.append(child);
+            std::push_heap(frontier.begin(), frontier.end(), lower);
+        }
+    }
+}
+
+} // namespace CounterUAS
+
+#endif // THREATPRIORITYQUEUE_H
@@ -0,0 +1,120 @@
+#include "core/ThreatRuleProgram.h"
+#include "core/ThreatAssessor.h"
+#include "core/GeofenceIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+void ThreatRuleProgram::compile(const QList<ThreatRule>& rules, const GeofenceIndex* zones) {
+    clear();
+
+    for (int i = 0; i < rules.size(); ++i) {
+        const ThreatRule& rule = rules[i];
+        if (!rule.enabled) continue;
+
+        // A rule with no action cannot change anything; leave it out
+        const bool hasAction = rule.setThreatLevel >= 0 || rule.threatLevelIncrease != 0 ||
+                               rule.forceClassification != TrackClassification::Unknown ||
+                               rule.generateAlert;
+        if (!hasAction) continue;
+
+        // Nothing to measure against; the rule could never be decided
+        const int zone = rule.zoneId.isEmpty() || !zones ? -1 : zones->indexOf(rule.zoneId);
+        if (!rule.zoneId.isEmpty() && zone < 0) continue;
+
+        CompiledRule compiled;
+        compiled.firstCondition = m_conditions.size();
+        compiled.setThreatLevel = rule.setThreatLevel;
+        compiled.threatLevelIncrease = rule.threatLevelIncrease;
+        compiled.forceClassification = rule.forceClassification;
+        compiled.generateAlert = rule.generateAlert;
+        compiled.sourceIndex = i;
+
+        if (rule.minProximityM >= 0) m_conditions.append({OpMinProximity, rule.minProximityM, 0.0});
+        if (rule.maxProximityM >= 0) m_conditions.append({OpMaxProximity, rule.maxProximityM, 0.0});
+        if (rule.minVelocityMps >= 0) m_conditions.append({OpMinSpeed, rule.minVelocityMps, 0.0});
+        if (rule.maxVelocityMps >= 0) m_conditions.append({OpMaxSpeed, rule.maxVelocityMps, 0.0});
+        if (rule.minHeadingToAssetDeg >= 0) {
+            m_conditions.append({OpHeadingWindow, rule.minHeadingToAssetDeg, rule.maxHeadingToAssetDeg});
+        }
+        if (rule.maxTimeToImpactSec >= 0) m_conditions.append({OpMaxTimeToImpact, rule.maxTimeToImpactSec, 0.0});
+        if (rule.requiresRFDetection) m_conditions.append({OpRequireRF, 0.0, 0.0});
+        if (rule.requiresVisualConfirmation) m_conditions.append({OpRequireVisual, 0.0, 0.0});
+        if (rule.minGroupSize > 0) m_conditions.append({OpMinGroupSize, double(rule.minGroupSize), 0.0});
+        if (zone >= 0) {
+            int slot = m_zoneSlots.indexOf(zone);
+            if (slot < 0) {
+                slot = m_zoneSlots.size();
+                m_zoneSlots.append(zone);
+                m_zoneLimits.append(0.0);
+            }
+            // Exact ranges past the margin are never needed, only the side
+            m_zoneLimits[slot] = std::max(m_zoneLimits[slot], std::abs(rule.zoneMarginM) + 1.0);
+            m_conditions.append({rule.requiresOutsideZone ? OpOutsideZone : OpInsideZone,
+                                 rule.zoneMarginM, 0.0, slot});
+        }
+
+        compiled.conditionCount = m_conditions.size() - compiled.firstCondition;
+        m_rules.append(compiled);
+    }
+}
+
+void ThreatRuleProgram::clear() {
+    m_conditions.clear();
+    m_rules.clear();
+    m_zoneSlots.clear();
+    m_zoneLimits.clear();
+}
+
+bool ThreatRuleProgram::test(const Condition& condition, const ThreatRuleInput& input) {
+    switch (condition.op) {
+        case OpMinProximity:  return input.proximityM >= condition.lo;
+        case OpMaxProximity:  return input.proximityM <= condition.lo;
+        case OpMinSpeed:      return input.speedMps >= condition.lo;
+        case OpMaxSpeed:      return input.speedMps <= condition.lo;
+        case OpHeadingWindow:
+            return input.headingToAssetDeg < 0 ||
+                   (input.headingToAssetDeg >= condition.lo && input.headingToAssetDeg <= condition.hi);
+        case OpMaxTimeToImpact:
+            return input.timeToImpactSec >= 0 && input.timeToImpactSec <= condition.lo;
+        case OpRequireRF:     return input.hasRF;
+        case OpRequireVisual: return input.hasVisual;
+        case OpMinGroupSize:  return input.groupSize >= condition.lo;
+        case OpInsideZone:    return input.zoneDistancesM[condition.slot] <= condition.lo;
+        case OpOutsideZone:   return input.zoneDistancesM[condition.slot] > condition.lo;
+    }
+    return false;
+}
+
+void ThreatRuleProgram::evaluate(QVector<ThreatRuleInput>& inputs,
+                                 QVector<ThreatRuleAlert>* alerts) const {
+    const Condition* conditions = m_conditions.constData();
+
+    for (int i = 0; i < inputs.size(); ++i) {
+        ThreatRuleInput& input = inputs[i];
+
+        for (const CompiledRule& rule : m_rules) {
+            const Condition* c = conditions + rule.firstCondition;
+            const Condition* end = c + rule.conditionCount;
+            while (c != end && test(*c, input)) ++c;
+            if (c != end) continue;
+
+            if (rule.setThreatLevel >= 0) {
+                input.threatLevel = rule.setThreatLevel;
+            } else {
+                input.threatLevel += rule.threatLevelIncrease;
+            }
+            if (rule.forceClassification != TrackClassification::Unknown) {
+                input.classification = rule.forceClassification;
+            }
+            if (rule.generateAlert && alerts) {
+                alerts->append({i, rule.sourceIndex});
+            }
+        }
+
+        input.threatLevel = std::min(5, std::max(1, input.threatLevel));
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,115 @@
+#ifndef THREATRULEPROGRAM_H
+#define THREATRULEPROGRAM_H
+
+#include <QList>
+#include <QVector>
+#include <limits>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+struct ThreatRule;
+class GeofenceIndex;
+
+/**
+ * @brief Per-track values the rule conditions test, and the rule outputs
+ */
+struct ThreatRuleInput {
+    double proximityM = std::numeric_limits<double>::max();
+    double speedMps = 0.0;
+    double headingToAssetDeg = -1;   // -1 when there is no asset
+    double timeToImpactSec = -1;     // -1 when not closing on any asset
+    bool hasRF = false;
+    bool hasVisual = false;
+    int groupSize = 0;               // Members of the track's swarm group, 0 in none
+    // Signed range to each zone slot's boundary, negative inside (see
+    // GeofenceIndex::signedDistanceM); null when the program has no slots
+    const double* zoneDistancesM = nullptr;
+
+    // In: level and classification before the rules. Out: after them.
+    int threatLevel = 1;
+    TrackClassification classification = TrackClassification::Unknown;
+};
+
+/**
+ * @brief A rule with generateAlert that matched one input
+ */
+struct ThreatRuleAlert {
+    int input;   // Index into the evaluated inputs
+    int rule;    // Index into the rule list the program was compiled from
+};
+
+/**
+ * @brief Enabled ThreatRules flattened into a predicate program
+ *
+ * compile() keeps only the conditions a rule actually sets (the -1 / false
+ * "any" values disappear) and stores them back to back, so evaluation is a
+ * linear walk over a few small arrays with no per-field branching on rule
+ * configuration. Rules are applied in list order, matching the interpreted
+ * semantics: setThreatLevel overrides, threatLevelIncrease accumulates,
+ * and the final level is clamped to 1-5.
+ *
+ * Zone conditions refer to a slot rather than a zone: each zone some rule
+ * tests gets one, with the furthest range from its boundary any of those
+ * rules cares about, so the caller measures each track against only those
+ * zones and only that far (zoneSlotCount(), zone(), zoneLimitM()). A rule
+ * naming a zone that is not in the index is left out.
+ */
+class ThreatRuleProgram {
+public:
+    void compile(const QList<ThreatRule>& rules, const GeofenceIndex* zones = nullptr);
+    void clear();
+
+    int ruleCount() const { return m_rules.size(); }
+    int conditionCount() const { return m_conditions.size(); }
+
+    int zoneSlotCount() const { return m_zoneSlots.size(); }
+    int zone(int slot) const { return m_zoneSlots[slot]; }         // Index in the GeofenceIndex
+    double zoneLimitM(int slot) const { return m_zoneLimits[slot]; }
+
+    // Runs the program over every input in place
+    void evaluate(QVector<ThreatRuleInput>& inputs, QVector<ThreatRuleAlert>* alerts) const;
+
+private:
+    enum Op : quint8 {
+        OpMinProximity,
+        OpMaxProximity,
+        OpMinSpeed,
+        OpMaxSpeed,
+        OpHeadingWindow,   // Only tested when the track has an asset
+        OpMaxTimeToImpact,
+        OpRequireRF,
+        OpRequireVisual,
+        OpMinGroupSize,
+        OpInsideZone,      // Within lo of the zone's boundary or inside it
+        OpOutsideZone      // Further than lo outside it
+    };
+
+    struct Condition {
+        Op op;
+        double lo;
+        double hi;
+        int slot = -1;     // Zone conditions only
+    };
+
+    struct CompiledRule {
+        int firstCondition;
+        int conditionCount;
+        int setThreatLevel;
+        int threatLevelIncrease;
+        TrackClassification forceClassification;
+        bool generateAlert;
+        int sourceIndex;
+    };
+
+    static bool test(const Condition& condition, const ThreatRuleInput& input);
+
+    QVector<Condition> m_conditions;
+    QVector<CompiledRule> m_rules;
+    QVector<int> m_zoneSlots;
+    QVector<double> m_zoneLimits;
+};
+
+} // namespace CounterUAS
+
+#endif // THREATRULEPROGRAM_H
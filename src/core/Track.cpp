@@ -1,4 +1,7 @@
 #include "core/Track.h"
+#include "core/TrackTable.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/JsonWriter.h"
 #include <QtMath>
 #include <QJsonArray>
 #include <QMutexLocker>
@@ -14,6 +17,17 @@ QJsonObject GeoPosition::toJson() const {
     return obj;
 }
 
+void GeoPosition::writeJson(JsonWriter& writer) const {
+    writer.beginObject();
+    writer.key("latitude");
+    writer.writeDouble(latitude);
+    writer.key("longitude");
+    writer.writeDouble(longitude);
+    writer.key("altitude");
+    writer.writeDouble(altitude);
+    writer.endObject();
+}
+
 GeoPosition GeoPosition::fromJson(const QJsonObject& json) {
     GeoPosition pos;
     pos.latitude = json["latitude"].toDouble();
@@ -45,6 +59,17 @@ QJsonObject VelocityVector::toJson() const {
     return obj;
 }
 
+void VelocityVector::writeJson(JsonWriter& writer) const {
+    writer.beginObject();
+    writer.key("north");
+    writer.writeDouble(north);
+    writer.key("east");
+    writer.writeDouble(east);
+    writer.key("down");
+    writer.writeDouble(down);
+    writer.endObject();
+}
+
 VelocityVector VelocityVector::fromJson(const QJsonObject& json) {
     VelocityVector vel;
     vel.north = json["north"].toDouble();
@@ -57,22 +82,27 @@ VelocityVector VelocityVector::fromJson(const QJsonObject& json) {
 Track::Track(const QString& id, QObject* parent)
     : QObject(parent)
     , m_trackId(id)
-    , m_createdTime(QDateTime::currentDateTimeUtc())
-    , m_lastUpdateTime(m_createdTime)
+    , m_createdMs(m_clock->nowMs())
+    , m_lastUpdateMs(m_createdMs)
+    , m_positionHistory(DEFAULT_HISTORY_CAPACITY)
 {
 }
 
 Track::Track(const Track& other)
     : QObject(other.parent())
     , m_trackId(other.m_trackId)
+    , m_handle(other.m_handle)
     , m_position(other.m_position)
     , m_velocity(other.m_velocity)
     , m_classification(other.m_classification)
     , m_state(other.m_state)
     , m_threatLevel(other.m_threatLevel)
     , m_detectionSources(other.m_detectionSources)
-    , m_createdTime(other.m_createdTime)
-    , m_lastUpdateTime(other.m_lastUpdateTime)
+    , m_clock(other.m_clock)
+    , m_createdMs(other.m_createdMs)
+    , m_lastUpdateMs(other.m_lastUpdateMs)
+    , m_lastIngestMonoNs(other.m_lastIngestMonoNs)
+    , m_receiveLagUs(other.m_receiveLagUs)
     , m_associatedCameraId(other.m_associatedCameraId)
     , m_visuallyTracked(other.m_visuallyTracked)
     , m_boundingBox(other.m_boundingBox)
@@ -80,6 +110,9 @@ Track::Track(const Track& other)
     , m_engaged(other.m_engaged)
     , m_trackQuality(other.m_trackQuality)
     , m_coastCount(other.m_coastCount)
+    , m_groupId(other.m_groupId)
+    , m_groupSize(other.m_groupSize)
+    , m_modeProbabilities(other.m_modeProbabilities)
     , m_positionHistory(other.m_positionHistory)
 {
 }
@@ -93,7 +126,8 @@ void Track::setPosition(const GeoPosition& pos) {
     {
         QMutexLocker locker(&m_mutex);
         m_position = pos;
-        m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+        if (m_table) m_table->setPosition(m_tableRow, pos);
+        markUpdated(TrackChangePosition);
     }
     emit positionChanged();
     emit updated();
@@ -127,7 +161,8 @@ void Track::setVelocity(const VelocityVector& vel) {
     {
         QMutexLocker locker(&m_mutex);
         m_velocity = vel;
-        m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+        if (m_table) m_table->setVelocity(m_tableRow, vel);
+        markUpdated(TrackChangeVelocity);
     }
     emit velocityChanged();
     emit updated();
@@ -136,14 +171,15 @@ void Track::setVelocity(const VelocityVector& vel) {
 void Track::setClassification(TrackClassification cls) {
     if (m_classification != cls) {
         m_classification = cls;
-        m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+        if (m_table) m_table->setClassification(m_tableRow, cls);
+        markUpdated(TrackChangeClassification);
         emit classificationChanged();
         emit updated();
     }
 }
 
-QString Track::classificationString() const {
-    switch (m_classification) {
+QString Track::classificationToString(TrackClassification cls) {
+    switch (cls) {
         case TrackClassification::Unknown: return "UNKNOWN";
         case TrackClassification::Friendly: return "FRIENDLY";
         case TrackClassification::Hostile: return "HOSTILE";
@@ -157,7 +193,8 @@ void Track::setThreatLevel(int level) {
     level = qBound(1, level, 5);
     if (m_threatLevel != level) {
         m_threatLevel = level;
-        m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+        if (m_table) m_table->setThreatLevel(m_tableRow, level);
+        markUpdated(TrackChangeThreatLevel);
         emit threatLevelChanged(level);
         emit updated();
     }
@@ -166,14 +203,16 @@ void Track::setThreatLevel(int level) {
 void Track::setState(TrackState state) {
     if (m_state != state) {
         m_state = state;
-        m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+        if (m_table) m_table->setState(m_tableRow, state);
+        markUpdated(state == TrackState::Dropped ? TrackChangeState | TrackChangeDropped
+                                                 : TrackChangeState);
         emit stateChanged(state);
         emit updated();
     }
 }
 
-QString Track::stateString() const {
-    switch (m_state) {
+QString Track::stateToString(TrackState state) {
+    switch (state) {
         case TrackState::Initiated: return "INITIATED";
         case TrackState::Active: return "ACTIVE";
         case TrackState::Coasting: return "COASTING";
@@ -185,11 +224,13 @@ QString Track::stateString() const {
 void Track::addDetectionSource(DetectionSource source) {
     if (!m_detectionSources.contains(source)) {
         m_detectionSources.append(source);
+        syncSourcesToTable();
     }
 }
 
 void Track::clearDetectionSources() {
     m_detectionSources.clear();
+    syncSourcesToTable();
 }
 
 bool Track::hasSource(DetectionSource source) const {
@@ -197,66 +238,122 @@ bool Track::hasSource(DetectionSource source) const {
 }
 
 qint64 Track::trackAge() const {
-    return m_createdTime.msecsTo(QDateTime::currentDateTimeUtc());
+    return trackAge(m_clock->nowMs());
 }
 
 qint64 Track::timeSinceUpdate() const {
-    return m_lastUpdateTime.msecsTo(QDateTime::currentDateTimeUtc());
+    return timeSinceUpdate(m_clock->nowMs());
+}
+
+void Track::setLastIngest(qint64 ingestMonoNs, qint64 receiveLagUs) {
+    m_lastIngestMonoNs = ingestMonoNs;
+    m_receiveLagUs = receiveLagUs;
 }
 
 void Track::setAssociatedCameraId(const QString& cameraId) {
     m_associatedCameraId = cameraId;
-    m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+    markUpdated(TrackChangeVisual);
     emit updated();
 }
 
 void Track::setVisuallyTracked(bool tracked) {
     m_visuallyTracked = tracked;
-    m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+    markUpdated(TrackChangeVisual);
     emit updated();
 }
 
 void Track::setBoundingBox(const BoundingBox& box) {
     m_boundingBox = box;
+    if (m_table) m_table->markDirty(m_tableRow, TrackChangeVisual);
     emit boundingBoxChanged();
 }
 
 void Track::setClassificationConfidence(double conf) {
     m_classificationConfidence = qBound(0.0, conf, 1.0);
-    m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+    markUpdated(TrackChangeClassification);
     emit updated();
 }
 
 void Track::setEngaged(bool engaged) {
     m_engaged = engaged;
-    m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+    markUpdated(TrackChangeEngagement);
     emit updated();
 }
 
 void Track::setTrackQuality(double quality) {
     m_trackQuality = qBound(0.0, quality, 1.0);
-    m_lastUpdateTime = QDateTime::currentDateTimeUtc();
+    if (m_table) m_table->setQuality(m_tableRow, m_trackQuality);
+    markUpdated(TrackChangeQuality);
+}
+
+void Track::setGroup(quint32 groupId, int groupSize) {
+    m_groupId = groupId;
+    m_groupSize = groupId != 0 ? groupSize : 0;
+}
+
+MotionModeProbabilities Track::modeProbabilities() const {
+    QMutexLocker locker(&m_mutex);
+    return m_modeProbabilities;
+}
+
+void Track::setModeProbabilities(const MotionModeProbabilities& modes) {
+    QMutexLocker locker(&m_mutex);
+    m_modeProbabilities = modes;
 }
 
 void Track::incrementCoastCount() {
     m_coastCount++;
+    if (m_table) m_table->setCoastCount(m_tableRow, m_coastCount);
 }
 
 void Track::resetCoastCount() {
     m_coastCount = 0;
+    if (m_table) m_table->setCoastCount(m_tableRow, 0);
 }
 
 void Track::addPositionHistory(const GeoPosition& pos, qint64 timestamp) {
     QMutexLocker locker(&m_mutex);
     m_positionHistory.append(qMakePair(pos, timestamp));
-    while (m_positionHistory.size() > MAX_HISTORY_SIZE) {
-        m_positionHistory.removeFirst();
-    }
 }
 
 QList<QPair<GeoPosition, qint64>> Track::positionHistory() const {
     QMutexLocker locker(&m_mutex);
-    return m_positionHistory;
+    QList<QPair<GeoPosition, qint64>> history;
+    history.reserve(m_positionHistory.size());
+    for (const auto& sample : m_positionHistory) {
+        history.append(sample);
+    }
+    return history;
+}
+
+void Track::recycle(const QString& id) {
+    QMutexLocker locker(&m_mutex);
+    m_table = nullptr;
+    m_tableRow = -1;
+    m_trackId = id;
+    m_handle = INVALID_TRACK_HANDLE;
+    m_position = GeoPosition();
+    m_velocity = VelocityVector();
+    m_classification = TrackClassification::Unknown;
+    m_state = TrackState::Initiated;
+    m_threatLevel = 1;
+    m_detectionSources.clear();
+    m_clock = Clock::system();
+    m_createdMs = m_clock->nowMs();
+    m_lastUpdateMs = m_createdMs;
+    m_lastIngestMonoNs = 0;
+    m_receiveLagUs = -1;
+    m_associatedCameraId.clear();
+    m_visuallyTracked = false;
+    m_boundingBox = BoundingBox();
+    m_classificationConfidence = 0.0;
+    m_engaged = false;
+    m_trackQuality = 1.0;
+    m_coastCount = 0;
+    m_groupId = 0;
+    m_groupSize = 0;
+    m_modeProbabilities = MotionModeProbabilities();
+    m_positionHistory.clear();
 }
 
 void Track::clearHistory() {
@@ -264,6 +361,16 @@ void Track::clearHistory() {
     m_positionHistory.clear();
 }
 
+void Track::setHistoryCapacity(int samples) {
+    QMutexLocker locker(&m_mutex);
+    m_positionHistory.setCapacity(qMax(1, samples));
+}
+
+int Track::historyCapacity() const {
+    QMutexLocker locker(&m_mutex);
+    return m_positionHistory.capacity();
+}
+
 QJsonObject Track::toJson() const {
     QMutexLocker locker(&m_mutex);
     
@@ -274,8 +381,8 @@ QJsonObject Track::toJson() const {
     obj["classification"] = static_cast<int>(m_classification);
     obj["state"] = static_cast<int>(m_state);
     obj["threatLevel"] = m_threatLevel;
-    obj["createdTime"] = m_createdTime.toString(Qt::ISODateWithMs);
-    obj["lastUpdateTime"] = m_lastUpdateTime.toString(Qt::ISODateWithMs);
+    obj["createdTime"] = createdTime().toString(Qt::ISODateWithMs);
+    obj["lastUpdateTime"] = lastUpdateTime().toString(Qt::ISODateWithMs);
     obj["associatedCameraId"] = m_associatedCameraId;
     obj["visuallyTracked"] = m_visuallyTracked;
     obj["classificationConfidence"] = m_classificationConfidence;
@@ -291,6 +398,46 @@ QJsonObject Track::toJson() const {
     return obj;
 }
 
+void Track::writeJson(JsonWriter& writer) const {
+    QMutexLocker locker(&m_mutex);
+    
+    writer.beginObject();
+    writer.key("trackId");
+    writer.writeString(m_trackId);
+    writer.key("position");
+    m_position.writeJson(writer);
+    writer.key("velocity");
+    m_velocity.writeJson(writer);
+    writer.key("classification");
+    writer.writeInt(static_cast<int>(m_classification));
+    writer.key("state");
+    writer.writeInt(static_cast<int>(m_state));
+    writer.key("threatLevel");
+    writer.writeInt(m_threatLevel);
+    writer.key("createdTime");
+    writer.writeDateTime(m_createdMs, Qt::UTC);
+    writer.key("lastUpdateTime");
+    writer.writeDateTime(m_lastUpdateMs, Qt::UTC);
+    writer.key("associatedCameraId");
+    writer.writeString(m_associatedCameraId);
+    writer.key("visuallyTracked");
+    writer.writeBool(m_visuallyTracked);
+    writer.key("classificationConfidence");
+    writer.writeDouble(m_classificationConfidence);
+    writer.key("engaged");
+    writer.writeBool(m_engaged);
+    writer.key("trackQuality");
+    writer.writeDouble(m_trackQuality);
+    
+    writer.key("detectionSources");
+    writer.beginArray();
+    for (auto source : m_detectionSources) {
+        writer.writeInt(static_cast<int>(source));
+    }
+    writer.endArray();
+    writer.endObject();
+}
+
 Track* Track::fromJson(const QJsonObject& json, QObject* parent) {
     Track* track = new Track(json["trackId"].toString(), parent);
     track->m_position = GeoPosition::fromJson(json["position"].toObject());
@@ -298,8 +445,10 @@ Track* Track::fromJson(const QJsonObject& json, QObject* parent) {
     track->m_classification = static_cast<TrackClassification>(json["classification"].toInt());
     track->m_state = static_cast<TrackState>(json["state"].toInt());
     track->m_threatLevel = json["threatLevel"].toInt();
-    track->m_createdTime = QDateTime::fromString(json["createdTime"].toString(), Qt::ISODateWithMs);
-    track->m_lastUpdateTime = QDateTime::fromString(json["lastUpdateTime"].toString(), Qt::ISODateWithMs);
+    const QDateTime created = QDateTime::fromString(json["createdTime"].toString(), Qt::ISODateWithMs);
+    const QDateTime lastUpdate = QDateTime::fromString(json["lastUpdateTime"].toString(), Qt::ISODateWithMs);
+    if (created.isValid()) track->m_createdMs = created.toMSecsSinceEpoch();
+    if (lastUpdate.isValid()) track->m_lastUpdateMs = lastUpdate.toMSecsSinceEpoch();
     track->m_associatedCameraId = json["associatedCameraId"].toString();
     track->m_visuallyTracked = json["visuallyTracked"].toBool();
     track->m_classificationConfidence = json["classificationConfidence"].toDouble();
@@ -315,25 +464,8 @@ Track* Track::fromJson(const QJsonObject& json, QObject* parent) {
 }
 
 double Track::distanceTo(const GeoPosition& pos) const {
-    QMutexLocker locker(&m_mutex);
-    
-    // Haversine formula
-    const double R = 6371000.0; // Earth radius in meters
-    
-    double lat1 = qDegreesToRadians(m_position.latitude);
-    double lat2 = qDegreesToRadians(pos.latitude);
-    double dLat = lat2 - lat1;
-    double dLon = qDegreesToRadians(pos.longitude - m_position.longitude);
-    
-    double a = std::sin(dLat/2) * std::sin(dLat/2) +
-               std::cos(lat1) * std::cos(lat2) *
-               std::sin(dLon/2) * std::sin(dLon/2);
-    double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1-a));
-    
-    double horizontalDist = R * c;
-    double verticalDist = pos.altitude - m_position.altitude;
-    
-    return std::sqrt(horizontalDist * horizontalDist + verticalDist * verticalDist);
+    // Copy out; the trigonometry needs no lock
+    return CoordinateUtils::haversineDistance(position(), pos);
 }
 
 double Track::distanceTo(const Track& other) const {
@@ -341,20 +473,7 @@ double Track::distanceTo(const Track& other) const {
 }
 
 double Track::bearingTo(const GeoPosition& pos) const {
-    QMutexLocker locker(&m_mutex);
-    
-    double lat1 = qDegreesToRadians(m_position.latitude);
-    double lat2 = qDegreesToRadians(pos.latitude);
-    double dLon = qDegreesToRadians(pos.longitude - m_position.longitude);
-    
-    double y = std::sin(dLon) * std::cos(lat2);
-    double x = std::cos(lat1) * std::sin(lat2) -
-               std::sin(lat1) * std::cos(lat2) * std::cos(dLon);
-    
-    double bearing = qRadiansToDegrees(std::atan2(y, x));
-    if (bearing < 0) bearing += 360.0;
-    
-    return bearing;
+    return CoordinateUtils::bearing(position(), pos);
 }
 
 void Track::updateFrom(const Track& other) {
@@ -376,12 +495,66 @@ void Track::updateFrom(const Track& other) {
         }
     }
     
-    m_lastUpdateTime = QDateTime::currentDateTimeUtc();
     m_coastCount = 0;
+    if (m_table) {
+        m_table->setPosition(m_tableRow, m_position);
+        m_table->setVelocity(m_tableRow, m_velocity);
+        m_table->setClassification(m_tableRow, m_classification);
+        m_table->setCoastCount(m_tableRow, 0);
+    }
+    syncSourcesToTable();
+    markUpdated(TrackChangeKinematics | TrackChangeClassification);
     
     emit positionChanged();
     emit velocityChanged();
     emit updated();
 }
 
+void Track::bindTable(TrackTable* table, int row) {
+    m_table = table;
+    m_tableRow = row;
+    if (m_table) m_table->load(m_tableRow, *this);
+}
+
+void Track::setClock(const Clock* clock) {
+    m_clock = clock ? clock : Clock::system();
+    m_createdMs = m_clock->nowMs();
+    m_lastUpdateMs = m_createdMs;
+    if (m_table) {
+        m_table->setLastUpdateMs(m_tableRow, m_lastUpdateMs);
+    }
+}
+
+void Track::restoreTimes(qint64 createdMs, qint64 lastUpdateMs) {
+    m_createdMs = createdMs;
+    m_lastUpdateMs = lastUpdateMs;
+    if (m_table) {
+        m_table->setLastUpdateMs(m_tableRow, m_lastUpdateMs);
+    }
+}
+
+void Track::unbindTable() {
+    m_table = nullptr;
+    m_tableRow = -1;
+}
+
+void Track::markUpdated(quint32 changedFields) {
+    m_lastUpdateMs = m_clock->nowMs();
+    if (m_table) {
+        m_table->setLastUpdateMs(m_tableRow, m_lastUpdateMs);
+        m_table->markDirty(m_tableRow, changedFields);
+    }
+}
+
+void Track::syncSourcesToTable() {
+    if (!m_table) return;
+    
+    quint32 mask = 0;
+    for (auto source : m_detectionSources) {
+        mask |= TrackTable::sourceBit(source);
+    }
+    m_table->setSourceMask(m_tableRow, mask);
+    m_table->markDirty(m_tableRow, TrackChangeSources);
+}
+
 } // namespace CounterUAS
@@ -8,9 +8,17 @@
 #include <QList>
 #include <QMutex>
 #include <QJsonObject>
+#include <atomic>
+#include "core/TrackHandle.h"
+#include "utils/Clock.h"
+#include "utils/RingBuffer.h"
 
 namespace CounterUAS {
 
+class TrackTable;
+class TrackSlab;
+class JsonWriter;
+
 /**
  * @brief Track classification enum
  */
@@ -40,7 +48,8 @@ enum class DetectionSource {
     RFDetector,
     Camera,
     Combined,
-    Manual
+    Manual,
+    Cooperative     // ADS-B or Remote ID; the target says who it is
 };
 
 /**
@@ -57,6 +66,7 @@ struct GeoPosition {
     }
     
     QJsonObject toJson() const;
+    void writeJson(JsonWriter& writer) const;      // toJson's document, without the tree
     static GeoPosition fromJson(const QJsonObject& json);
 };
 
@@ -73,9 +83,19 @@ struct VelocityVector {
     double climbRate() const;
     
     QJsonObject toJson() const;
+    void writeJson(JsonWriter& writer) const;
     static VelocityVector fromJson(const QJsonObject& json);
 };
 
+/**
+ * @brief IMM motion mode probabilities (CV-only unless IMM is enabled)
+ */
+struct MotionModeProbabilities {
+    double constantVelocity = 1.0;
+    double constantAcceleration = 0.0;
+    double coordinatedTurn = 0.0;
+};
+
 /**
  * @brief Bounding box for video overlay
  */
@@ -90,6 +110,29 @@ struct BoundingBox {
     bool isValid() const { return width > 0 && height > 0; }
 };
 
+/**
+ * @brief One recorded track position, for history and replay
+ */
+struct TrackHistorySample {
+    QString trackId;
+    qint64 timestamp = 0;       // ms since the epoch
+    GeoPosition position;
+};
+
+/**
+ * @brief An interval in which a camera recorded a track, and where to play it
+ */
+struct VideoSighting {
+    QString trackId;
+    QString cameraId;
+    qint64 startMs = 0;         // ms since the epoch
+    qint64 endMs = 0;
+    QString clipId;             // The segment, as in video_clips
+    QString path;
+    qint64 byteOffset = 0;      // Of the segment's keyframe cluster at or before startMs
+    qint64 offsetTimeMs = 0;    // That cluster's time
+};
+
 /**
  * @brief Track class representing a detected target
  */
@@ -106,6 +149,12 @@ public:
     
     // Unique identifier
     QString trackId() const { return m_trackId; }
+    TrackHandle handle() const { return m_handle; }
+    void setHandle(TrackHandle handle) { m_handle = handle; }  // Assigned by TrackManager
+    // Bumped each time a TrackManager recycles this object for another
+    // track; a pointer kept with the generation it was taken at is stale
+    // once they differ
+    quint32 generation() const { return m_generation.load(std::memory_order_acquire); }
     
     // Position management
     GeoPosition position() const;
@@ -119,7 +168,8 @@ public:
     // Classification
     TrackClassification classification() const { return m_classification; }
     void setClassification(TrackClassification cls);
-    QString classificationString() const;
+    QString classificationString() const { return classificationToString(m_classification); }
+    static QString classificationToString(TrackClassification cls);
     
     // Threat level (1-5)
     int threatLevel() const { return m_threatLevel; }
@@ -128,7 +178,8 @@ public:
     // Track state
     TrackState state() const { return m_state; }
     void setState(TrackState state);
-    QString stateString() const;
+    QString stateString() const { return stateToString(m_state); }
+    static QString stateToString(TrackState state);
     
     // Detection sources
     QList<DetectionSource> detectionSources() const { return m_detectionSources; }
@@ -137,10 +188,25 @@ public:
     bool hasSource(DetectionSource source) const;
     
     // Timestamps
-    QDateTime createdTime() const { return m_createdTime; }
-    QDateTime lastUpdateTime() const { return m_lastUpdateTime; }
+    // Clock milliseconds; the QDateTime forms are for display and serialization
+    qint64 createdMs() const { return m_createdMs; }
+    qint64 lastUpdateMs() const { return m_lastUpdateMs; }
+    QDateTime createdTime() const { return QDateTime::fromMSecsSinceEpoch(m_createdMs, Qt::UTC); }
+    QDateTime lastUpdateTime() const { return QDateTime::fromMSecsSinceEpoch(m_lastUpdateMs, Qt::UTC); }
     qint64 trackAge() const;  // milliseconds since creation
     qint64 timeSinceUpdate() const;  // milliseconds since last update
+    // Against a "now" the caller already read, e.g. once per cycle
+    qint64 trackAge(qint64 nowMs) const { return nowMs - m_createdMs; }
+    qint64 timeSinceUpdate(qint64 nowMs) const { return nowMs - m_lastUpdateMs; }
+    
+    // Newest fused plot: its socket read stamp (TimeUtils::monotonicNs(), 0 if
+    // unknown) and how old its measurement already was when read (-1 if unknown)
+    qint64 lastIngestMonoNs() const { return m_lastIngestMonoNs; }
+    qint64 receiveLagUs() const { return m_receiveLagUs; }
+    void setLastIngest(qint64 ingestMonoNs, qint64 receiveLagUs);
+    // Times carried over from a checkpoint; after the other setters, which
+    // stamp the update time
+    void restoreTimes(qint64 createdMs, qint64 lastUpdateMs);
     
     // Associated camera
     QString associatedCameraId() const { return m_associatedCameraId; }
@@ -166,18 +232,42 @@ public:
     double trackQuality() const { return m_trackQuality; }
     void setTrackQuality(double quality);
     
+    // Motion mode probabilities from the IMM tracker
+    MotionModeProbabilities modeProbabilities() const;
+    void setModeProbabilities(const MotionModeProbabilities& modes);
+    
+    // Swarm group, set by TrackManager's clustering. Not an update of the
+    // track: the manager marks TrackChangeGroup itself.
+    quint32 groupId() const { return m_groupId; }
+    int groupSize() const { return m_groupSize; }
+    void setGroup(quint32 groupId, int groupSize);
+    
     // Coasting counter
     int coastCount() const { return m_coastCount; }
     void incrementCoastCount();
     void resetCoastCount();
     
-    // History for smoothing
+    // History for smoothing (fixed-capacity, oldest samples are overwritten)
     void addPositionHistory(const GeoPosition& pos, qint64 timestamp);
     QList<QPair<GeoPosition, qint64>> positionHistory() const;
     void clearHistory();
+    void setHistoryCapacity(int samples);
+    int historyCapacity() const;
+    
+    // Zero-copy history walk, oldest first. The visitor runs under the track
+    // mutex and must not call back into this track.
+    template <typename Visitor>
+    void visitPositionHistory(Visitor&& visit) const {
+        QMutexLocker locker(&m_mutex);
+        for (const auto& sample : m_positionHistory) {
+            visit(sample.first, sample.second);
+        }
+    }
     
     // Serialization
     QJsonObject toJson() const;
+    // The same document as toJson, streamed with no QJsonObject per field
+    void writeJson(JsonWriter& writer) const;
     static Track* fromJson(const QJsonObject& json, QObject* parent = nullptr);
     
     // Distance calculations
@@ -188,6 +278,17 @@ public:
     // Update from another track (for fusion)
     void updateFrom(const Track& other);
     
+    // Storage binding. While bound, every setter also writes the hot fields
+    // into the given TrackTable row (owned by TrackManager).
+    void bindTable(TrackTable* table, int row);
+    void unbindTable();
+    int tableRow() const { return m_tableRow; }
+    
+    // Time source for ages and update stamps (the wall clock by default).
+    // Set before first use; restamps the creation and update times.
+    void setClock(const Clock* clock);
+    const Clock* clock() const { return m_clock; }
+    
 signals:
     void positionChanged();
     void velocityChanged();
@@ -198,9 +299,22 @@ signals:
     void updated();
     
 private:
+    friend class TrackSlab;
+    
+    void markUpdated(quint32 changedFields);
+    void syncSourcesToTable();
+    // Back to a new track's defaults under another id; for TrackSlab
+    void recycle(const QString& id);
+    
     mutable QMutex m_mutex;
     
+    TrackTable* m_table = nullptr;
+    int m_tableRow = -1;
+    
     QString m_trackId;
+    TrackHandle m_handle = INVALID_TRACK_HANDLE;
+    int m_slot = -1;                   // In the owning TrackSlab, -1 if none
+    std::atomic<quint32> m_generation{0};
     GeoPosition m_position;
     VelocityVector m_velocity;
     TrackClassification m_classification = TrackClassification::Unknown;
@@ -209,8 +323,11 @@ private:
     
     QList<DetectionSource> m_detectionSources;
     
-    QDateTime m_createdTime;
-    QDateTime m_lastUpdateTime;
+    const Clock* m_clock = Clock::system();
+    qint64 m_createdMs = 0;
+    qint64 m_lastUpdateMs = 0;
+    qint64 m_lastIngestMonoNs = 0;
+    qint64 m_receiveLagUs = -1;
     
     QString m_associatedCameraId;
     bool m_visuallyTracked = false;
@@ -220,9 +337,12 @@ private:
     bool m_engaged = false;
     double m_trackQuality = 1.0;
     int m_coastCount = 0;
+    quint32 m_groupId = 0;
+    int m_groupSize = 0;
+    MotionModeProbabilities m_modeProbabilities;
     
-    static constexpr int MAX_HISTORY_SIZE = 100;
-    QList<QPair<GeoPosition, qint64>> m_positionHistory;
+    static constexpr int DEFAULT_HISTORY_CAPACITY = 100;
+    RingBuffer<QPair<GeoPosition, qint64>> m_positionHistory;
 };
 
 } // namespace CounterUAS
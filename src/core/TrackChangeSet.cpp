@@ -0,0 +1,49 @@
+#include "core/TrackChangeSet.h"
+#include <QHash>
+
+namespace CounterUAS {
+
+void TrackChangeSet::clear() {
+    sequence = 0;
+    handles.clear();
+    fields.clear();
+}
+
+void TrackChangeSet::add(TrackHandle handle, quint32 changed) {
+    handles.append(handle);
+    fields.append(changed);
+}
+
+void TrackChangeSet::merge(const TrackChangeSet& newer) {
+    sequence = qMax(sequence, newer.sequence);
+    if (newer.isEmpty()) return;
+    if (isEmpty()) {
+        handles = newer.handles;
+        fields = newer.fields;
+        return;
+    }
+
+    QHash<TrackHandle, int> index;
+    index.reserve(handles.size());
+    for (int i = 0; i < handles.size(); ++i) {
+        index.insert(handles[i], i);
+    }
+
+    for (int i = 0; i < newer.handles.size(); ++i) {
+        auto it = index.constFind(newer.handles[i]);
+        if (it != index.constEnd()) {
+            fields[it.value()] |= newer.fields[i];
+        } else {
+            add(newer.handles[i], newer.fields[i]);
+        }
+    }
+}
+
+quint32 TrackChangeSet::fieldsFor(TrackHandle handle) const {
+    for (int i = 0; i < handles.size(); ++i) {
+        if (handles[i] == handle) return fields[i];
+    }
+    return TrackChangeNone;
+}
+
+} // namespace CounterUAS
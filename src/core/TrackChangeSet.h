@@ -0,0 +1,64 @@
+#ifndef TRACKCHANGESET_H
+#define TRACKCHANGESET_H
+
+#include <QMetaType>
+#include <QVector>
+#include <QtGlobal>
+#include "core/TrackHandle.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Per-field dirty bits recorded for a track between track cycles
+ */
+enum TrackChangeField : quint32 {
+    TrackChangeNone           = 0,
+    TrackChangePosition       = 1u << 0,
+    TrackChangeVelocity       = 1u << 1,
+    TrackChangeState          = 1u << 2,
+    TrackChangeClassification = 1u << 3,   // Class or classification confidence
+    TrackChangeThreatLevel    = 1u << 4,
+    TrackChangeSources        = 1u << 5,
+    TrackChangeQuality        = 1u << 6,
+    TrackChangeVisual         = 1u << 7,   // Camera association or bounding box
+    TrackChangeEngagement     = 1u << 8,
+    TrackChangeCreated        = 1u << 9,
+    TrackChangeDropped        = 1u << 10,
+    TrackChangeGroup          = 1u << 11,   // Swarm group joined, left or resized
+
+    TrackChangeKinematics     = TrackChangePosition | TrackChangeVelocity,
+    TrackChangeAll            = (1u << 12) - 1
+};
+
+/**
+ * @brief The tracks that changed since the previous change set, and how
+ *
+ * TrackManager publishes one change set per track cycle, alongside the
+ * snapshot it describes. handles and fields are parallel arrays and each
+ * handle appears at most once.
+ */
+struct TrackChangeSet {
+    quint64 sequence = 0;          // Snapshot sequence the changes are visible in
+    QVector<TrackHandle> handles;
+    QVector<quint32> fields;       // TrackChangeField bits, parallel to handles
+
+    bool isEmpty() const { return handles.isEmpty(); }
+    int size() const { return handles.size(); }
+    void clear();
+
+    // Caller guarantees the handle is not already present
+    void add(TrackHandle handle, quint32 changed);
+
+    // Fold a newer change set into this one, OR-ing the fields of handles
+    // present in both. The result carries the newer sequence.
+    void merge(const TrackChangeSet& newer);
+
+    // Linear scan; intended for callers that watch a handful of tracks
+    quint32 fieldsFor(TrackHandle handle) const;
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::TrackChangeSet)
+
+#endif // TRACKCHANGESET_H
@@ -0,0 +1,49 @@
+#include "core/TrackChangeThrottle.h"
+#include "core/TrackManager.h"
+#include <utility>
+
+namespace CounterUAS {
+
+TrackChangeThrottle::TrackChangeThrottle(TrackManager* manager, int maxRateHz, QObject* parent)
+    : QObject(parent)
+    , m_deliveryTimer(new QTimer(this))
+    , m_maxRateHz(qMax(0, maxRateHz))
+{
+    m_deliveryTimer->setSingleShot(true);
+    connect(m_deliveryTimer, &QTimer::timeout, this, &TrackChangeThrottle::flush);
+
+    if (manager) {
+        connect(manager, &TrackManager::tracksChanged,
+                this, &TrackChangeThrottle::onTracksChanged);
+    }
+}
+
+void TrackChangeThrottle::setMaxRateHz(int hz) {
+    m_maxRateHz = qMax(0, hz);
+    if (m_maxRateHz == 0 && hasPending()) {
+        flush();
+    }
+}
+
+void TrackChangeThrottle::flush() {
+    m_deliveryTimer->stop();
+    if (m_pending.isEmpty()) return;
+
+    TrackChangeSet changes = std::move(m_pending);
+    m_pending.clear();
+    m_sinceDelivery.start();
+    emit tracksChanged(changes);
+}
+
+void TrackChangeThrottle::onTracksChanged(const TrackChangeSet& changes) {
+    m_pending.merge(changes);
+
+    const int interval = intervalMs();
+    if (!m_sinceDelivery.isValid() || m_sinceDelivery.elapsed() >= interval) {
+        flush();
+    } else if (!m_deliveryTimer->isActive()) {
+        m_deliveryTimer->start(static_cast<int>(interval - m_sinceDelivery.elapsed()));
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,52 @@
+#ifndef TRACKCHANGETHROTTLE_H
+#define TRACKCHANGETHROTTLE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "core/TrackChangeSet.h"
+
+namespace CounterUAS {
+
+class TrackManager;
+
+/**
+ * @brief Rate-limited view of TrackManager::tracksChanged for one subscriber
+ *
+ * Change sets arriving faster than maxRateHz are merged and delivered as one
+ * when the interval has elapsed, so a subscriber sees every changed track
+ * and field exactly as often as it can use them. A rate of 0 forwards every
+ * change set as it arrives.
+ */
+class TrackChangeThrottle : public QObject {
+    Q_OBJECT
+
+public:
+    TrackChangeThrottle(TrackManager* manager, int maxRateHz, QObject* parent = nullptr);
+
+    void setMaxRateHz(int hz);
+    int maxRateHz() const { return m_maxRateHz; }
+
+    bool hasPending() const { return !m_pending.isEmpty(); }
+
+    // Deliver anything pending now, regardless of rate
+    void flush();
+
+signals:
+    void tracksChanged(const TrackChangeSet& changes);
+
+private slots:
+    void onTracksChanged(const TrackChangeSet& changes);
+
+private:
+    int intervalMs() const { return m_maxRateHz > 0 ? 1000 / m_maxRateHz : 0; }
+
+    TrackChangeSet m_pending;
+    QTimer* m_deliveryTimer;
+    QElapsedTimer m_sinceDelivery;
+    int m_maxRateHz;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKCHANGETHROTTLE_H
@@ -0,0 +1,153 @@
+#include "core/TrackClassifier.h"
+#include <QJsonArray>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+QVector<float> toFloats(const QJsonArray& array) {
+    QVector<float> values;
+    values.reserve(array.size());
+    for (const QJsonValue& value : array) {
+        values.append(float(value.toDouble()));
+    }
+    return values;
+}
+
+QJsonArray toArray(const float* values, int count) {
+    QJsonArray array;
+    for (int i = 0; i < count; ++i) {
+        array.append(double(values[i]));
+    }
+    return array;
+}
+
+} // namespace
+
+bool TrackClassifierModel::isValid() const {
+    const int hidden = hiddenUnits();
+    if (hidden <= 0 || featureMean.size() != TRACK_FEATURE_COUNT ||
+        featureScale.size() != TRACK_FEATURE_COUNT ||
+        hiddenWeights.size() != hidden * TRACK_FEATURE_COUNT || outputWeights.size() != hidden) {
+        return false;
+    }
+    for (float scale : featureScale) {
+        if (!(scale > 0.0f)) return false;
+    }
+    return true;
+}
+
+TrackClassifierModel TrackClassifierModel::prior() {
+    TrackClassifierModel model;
+    //                  speed  sd    turn  sd    climb sd    hover logRcs seen rf    link
+    model.featureMean  = {15.0f, 3.0f, 5.0f, 5.0f, 1.0f, 1.0f, 0.2f, -1.0f, 0.5f, 0.2f, 0.5f};
+    model.featureScale = {15.0f, 3.0f, 10.0f, 10.0f, 2.0f, 2.0f, 0.3f, 1.0f, 0.5f, 0.3f, 0.5f};
+    model.hiddenWeights = {
+        // RF from a UAS control link
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.5f,
+        // A radar return, and a small one
+        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.5f, 1.5f, 0.0f, 0.0f,
+        // Slow, hovering, turning: multirotor flight
+        -0.8f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+        // Faster than a small UAS flies
+        1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    };
+    model.hiddenBias = {0.0f, -0.5f, 0.0f, -1.0f};
+    model.outputWeights = {1.0f, 0.8f, 0.8f, -1.5f};
+    model.outputBias = -1.2f;
+    return model;
+}
+
+TrackClassifierModel TrackClassifierModel::fromJson(const QJsonObject& json, bool* ok) {
+    TrackClassifierModel model;
+    model.featureMean = toFloats(json["mean"].toArray());
+    model.featureScale = toFloats(json["scale"].toArray());
+    for (const QJsonValue& unit : json["hidden"].toArray()) {
+        model.hiddenWeights += toFloats(unit.toArray());
+    }
+    model.hiddenBias = toFloats(json["hiddenBias"].toArray());
+    model.outputWeights = toFloats(json["output"].toArray());
+    model.outputBias = float(json["outputBias"].toDouble());
+    if (ok) *ok = model.isValid();
+    return model;
+}
+
+QJsonObject TrackClassifierModel::toJson() const {
+    QJsonObject json;
+    json["mean"] = toArray(featureMean.constData(), featureMean.size());
+    json["scale"] = toArray(featureScale.constData(), featureScale.size());
+    QJsonArray hidden;
+    for (int h = 0; h < hiddenUnits(); ++h) {
+        hidden.append(toArray(hiddenWeights.constData() + h * TRACK_FEATURE_COUNT, TRACK_FEATURE_COUNT));
+    }
+    json["hidden"] = hidden;
+    json["hiddenBias"] = toArray(hiddenBias.constData(), hiddenBias.size());
+    json["output"] = toArray(outputWeights.constData(), outputWeights.size());
+    json["outputBias"] = double(outputBias);
+    return json;
+}
+
+TrackClassifier::TrackClassifier() {
+    setModel(TrackClassifierModel::prior());
+}
+
+bool TrackClassifier::setModel(const TrackClassifierModel& model) {
+    if (!model.isValid()) return false;
+
+    m_model = model;
+    const int hidden = model.hiddenUnits();
+    m_weights.resize(hidden * TRACK_FEATURE_COUNT);
+    m_bias.resize(hidden);
+    for (int h = 0; h < hidden; ++h) {
+        float bias = model.hiddenBias[h];
+        for (int f = 0; f < TRACK_FEATURE_COUNT; ++f) {
+            const float w = model.hiddenWeights[h * TRACK_FEATURE_COUNT + f] / model.featureScale[f];
+            m_weights[h * TRACK_FEATURE_COUNT + f] = w;
+            bias -= w * model.featureMean[f];
+        }
+        m_bias[h] = bias;
+    }
+    return true;
+}
+
+void TrackClassifier::predict(const float* features, int count, float* probabilities) {
+    if (count <= 0) return;
+    if (m_hidden.size() < count) {
+        m_hidden.resize(count);
+        m_logit.resize(count);
+    }
+
+    float* hidden = m_hidden.data();
+    float* logit = m_logit.data();
+    for (int i = 0; i < count; ++i) {
+        logit[i] = m_model.outputBias;
+    }
+
+    for (int h = 0; h < m_model.hiddenUnits(); ++h) {
+        const float* w = m_weights.constData() + h * TRACK_FEATURE_COUNT;
+        const float bias = m_bias[h];
+        for (int i = 0; i < count; ++i) {
+            hidden[i] = bias;
+        }
+        for (int f = 0; f < TRACK_FEATURE_COUNT; ++f) {
+            const float weight = w[f];
+            if (weight == 0.0f) continue;
+            const float* x = features + f * count;
+            for (int i = 0; i < count; ++i) {
+                hidden[i] += weight * x[i];
+            }
+        }
+        const float out = m_model.outputWeights[h];
+        for (int i = 0; i < count; ++i) {
+            logit[i] += out * std::max(hidden[i], 0.0f);
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        probabilities[i] = 1.0f / (1.0f + std::exp(-logit[i]));
+    }
+}
+
+} // namespace CounterUAS
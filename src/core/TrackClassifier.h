@@ -0,0 +1,71 @@
+#ifndef TRACKCLASSIFIER_H
+#define TRACKCLASSIFIER_H
+
+#include <QJsonObject>
+#include <QVector>
+#include "core/TrackFeatureBank.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Weights of a TrackClassifier: one ReLU hidden layer, a sigmoid out
+ *
+ * Inputs are the TrackFeature values, standardised as (x - mean) / scale.
+ * hiddenWeights holds a row of TRACK_FEATURE_COUNT per hidden unit.
+ */
+struct TrackClassifierModel {
+    QVector<float> featureMean;     // TRACK_FEATURE_COUNT each
+    QVector<float> featureScale;
+    QVector<float> hiddenWeights;   // hiddenUnits() * TRACK_FEATURE_COUNT
+    QVector<float> hiddenBias;
+    QVector<float> outputWeights;   // One per hidden unit
+    float outputBias = 0.0f;
+
+    int hiddenUnits() const { return hiddenBias.size(); }
+    bool isValid() const;
+
+    // Hand-set weights encoding the rules of thumb (small RCS, UAS control
+    // link, slow and hovering, not airliner fast) until a trained model is given
+    static TrackClassifierModel prior();
+
+    // {"mean": [...], "scale": [...], "hidden": [[...], ...], "hiddenBias": [...],
+    //  "output": [...], "outputBias": x}, features in TrackFeature order
+    static TrackClassifierModel fromJson(const QJsonObject& json, bool* ok = nullptr);
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief Batched small-UAS probability over TrackFeatureBank features
+ *
+ * predict() takes the feature-major block TrackFeatureBank::gather()
+ * writes and returns, per track, the probability that it is a small UAS.
+ * The standardisation is folded into the hidden weights when the model is
+ * set, and each layer is a loop over hidden units around a loop over
+ * tracks, so the inner loops are multiply-adds over contiguous floats the
+ * compiler vectorizes for the build's SIMD width. One call covers every
+ * track in a cycle; scratch is reused between calls. Not thread-safe.
+ */
+class TrackClassifier {
+public:
+    TrackClassifier();
+
+    // False, keeping the current model, if the model is malformed
+    bool setModel(const TrackClassifierModel& model);
+    const TrackClassifierModel& model() const { return m_model; }
+
+    // features as TrackFeatureBank::gather() leaves them; count outputs
+    void predict(const float* features, int count, float* probabilities);
+
+private:
+    TrackClassifierModel m_model;
+    QVector<float> m_weights;       // Folded: per hidden unit, weight / scale
+    QVector<float> m_bias;          // Folded: bias - sum(weight * mean / scale)
+
+    // Scratch, count floats each
+    QVector<float> m_hidden;
+    QVector<float> m_logit;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKCLASSIFIER_H
@@ -0,0 +1,146 @@
+#include "core/TrackFeatureBank.h"
+#include <QByteArray>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr double RAD_TO_DEG = 57.29577951308232;
+constexpr double NO_HEADING = std::numeric_limits<double>::quiet_NaN();
+
+} // namespace
+
+void TrackFeatureBank::ensureCapacity(int row) {
+    if (row < m_motionCount.size()) return;
+
+    const int size = row + 1;
+    m_motionCount.resize(size);
+    m_turnCount.resize(size);
+    m_hoverCount.resize(size);
+    m_rcsCount.resize(size);
+    m_rfCount.resize(size);
+    m_uasLinkCount.resize(size);
+    m_speed.resize(size);
+    m_turnRate.resize(size);
+    m_climbRate.resize(size);
+    m_logRcsSum.resize(size);
+    m_lastHeadingRad.resize(size);
+    m_lastMotionMs.resize(size);
+}
+
+void TrackFeatureBank::reset(int row) {
+    if (row < 0) return;
+    ensureCapacity(row);
+
+    m_motionCount[row] = 0;
+    m_turnCount[row] = 0;
+    m_hoverCount[row] = 0;
+    m_rcsCount[row] = 0;
+    m_rfCount[row] = 0;
+    m_uasLinkCount[row] = 0;
+    m_speed.reset(row);
+    m_turnRate.reset(row);
+    m_climbRate.reset(row);
+    m_logRcsSum[row] = 0.0;
+    m_lastHeadingRad[row] = NO_HEADING;
+    m_lastMotionMs[row] = 0;
+}
+
+void TrackFeatureBank::release(int row) {
+    // The next track in the row starts from reset(); nothing to free
+    if (row >= 0 && row < capacity()) reset(row);
+}
+
+void TrackFeatureBank::clear() {
+    m_motionCount.clear();
+    m_turnCount.clear();
+    m_hoverCount.clear();
+    m_rcsCount.clear();
+    m_rfCount.clear();
+    m_uasLinkCount.clear();
+    m_speed.resize(0);
+    m_turnRate.resize(0);
+    m_climbRate.resize(0);
+    m_logRcsSum.clear();
+    m_lastHeadingRad.clear();
+    m_lastMotionMs.clear();
+}
+
+void TrackFeatureBank::observeMotion(int row, qint64 timestampMs, const VelocityVector& velocity) {
+    if (row < 0) return;
+    ensureCapacity(row);
+
+    const double speed = std::hypot(velocity.north, velocity.east);
+    const quint32 count = ++m_motionCount[row];
+    m_speed.add(row, count, speed);
+    m_climbRate.add(row, count, std::abs(velocity.down));
+    if (speed < HOVER_SPEED_MPS) m_hoverCount[row]++;
+
+    // Turn rate between consecutive updates fast enough to hold a heading
+    if (speed < TURN_MIN_SPEED_MPS) {
+        m_lastHeadingRad[row] = NO_HEADING;
+    } else {
+        const double heading = std::atan2(velocity.east, velocity.north);
+        const qint64 gapMs = timestampMs - m_lastMotionMs[row];
+        if (!std::isnan(m_lastHeadingRad[row]) && gapMs > 0 && gapMs <= TURN_MAX_GAP_MS) {
+            const double turn = std::abs(std::remainder(heading - m_lastHeadingRad[row], 2.0 * M_PI));
+            m_turnRate.add(row, ++m_turnCount[row], turn * RAD_TO_DEG * 1000.0 / gapMs);
+        }
+        m_lastHeadingRad[row] = heading;
+    }
+    m_lastMotionMs[row] = timestampMs;
+}
+
+void TrackFeatureBank::observeRcs(int row, double rcsM2) {
+    if (row < 0 || rcsM2 <= 0.0) return;
+    ensureCapacity(row);
+
+    m_rcsCount[row]++;
+    m_logRcsSum[row] += std::log10(rcsM2);
+}
+
+void TrackFeatureBank::observeRf(int row, const char* protocol) {
+    if (row < 0) return;
+    ensureCapacity(row);
+
+    m_rfCount[row]++;
+    if (isUasLink(protocol)) m_uasLinkCount[row]++;
+}
+
+int TrackFeatureBank::observations(int row) const {
+    return row >= 0 && row < capacity() ? int(m_motionCount[row]) : 0;
+}
+
+void TrackFeatureBank::gather(const int* rows, int count, float* out) const {
+    for (int i = 0; i < count; ++i) {
+        const int row = rows[i];
+        const quint32 motion = m_motionCount[row];
+        const quint32 rcs = m_rcsCount[row];
+        const quint32 rf = m_rfCount[row];
+        const double updates = qMax<quint32>(1, motion);
+
+        out[FeatureMeanSpeed * count + i] = float(m_speed.mean[row]);
+        out[FeatureSpeedStdDev * count + i] = float(m_speed.stdDev(row, motion));
+        out[FeatureMeanTurnRate * count + i] = float(m_turnRate.mean[row]);
+        out[FeatureTurnRateStdDev * count + i] = float(m_turnRate.stdDev(row, m_turnCount[row]));
+        out[FeatureMeanClimbRate * count + i] = float(m_climbRate.mean[row]);
+        out[FeatureClimbRateStdDev * count + i] = float(m_climbRate.stdDev(row, motion));
+        out[FeatureHoverRatio * count + i] = float(m_hoverCount[row] / updates);
+        out[FeatureMeanLogRcs * count + i] = rcs > 0 ? float(m_logRcsSum[row] / rcs) : 0.0f;
+        out[FeatureRcsSeen * count + i] = rcs > 0 ? 1.0f : 0.0f;
+        out[FeatureRfRatio * count + i] = float(qMin(1.0, rf / updates));
+        out[FeatureUasLinkRatio * count + i] = rf > 0 ? float(double(m_uasLinkCount[row]) / rf) : 0.0f;
+    }
+}
+
+bool TrackFeatureBank::isUasLink(const char* protocol) {
+    // RFDetector's protocol table; the generic band detections match
+    // Wi-Fi and other ISM traffic as well
+    if (!protocol) return false;
+    return qstrncmp(protocol, "DJI", 3) == 0 ||
+           qstrncmp(protocol, "FrSky", 5) == 0 ||
+           qstrncmp(protocol, "Futaba", 6) == 0;
+}
+
+} // namespace CounterUAS
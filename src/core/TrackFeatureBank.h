@@ -0,0 +1,103 @@
+#ifndef TRACKFEATUREBANK_H
+#define TRACKFEATUREBANK_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <cmath>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Features a TrackFeatureBank row yields, in gather() order
+ */
+enum TrackFeature : int {
+    FeatureMeanSpeed = 0,       // Horizontal, m/s
+    FeatureSpeedStdDev,
+    FeatureMeanTurnRate,        // |deg/s|
+    FeatureTurnRateStdDev,
+    FeatureMeanClimbRate,       // |m/s|
+    FeatureClimbRateStdDev,
+    FeatureHoverRatio,          // Updates slower than HOVER_SPEED_MPS
+    FeatureMeanLogRcs,          // log10 m^2, 0 with no radar return
+    FeatureRcsSeen,             // 1 once radar has given an RCS
+    FeatureRfRatio,             // Updates with an RF detection
+    FeatureUasLinkRatio,        // RF detections naming a UAS control link
+    TRACK_FEATURE_COUNT
+};
+
+/**
+ * @brief Running kinematic, RCS and RF statistics per track
+ *
+ * Slots are TrackManager's TrackTable rows, like the filter banks. Every
+ * observe call is O(1): speed, turn rate and climb rate keep a Welford mean
+ * and variance, the rest are counts and sums, so a track's features cost
+ * the same after ten updates as after ten thousand and nothing is kept per
+ * sample. Columns are one array per statistic, and gather() writes the
+ * features of many rows feature-major for TrackClassifier's batched pass.
+ * Not thread-safe.
+ */
+class TrackFeatureBank {
+public:
+    static constexpr double HOVER_SPEED_MPS = 2.0;
+    static constexpr double TURN_MIN_SPEED_MPS = 1.0;   // Below this heading is noise
+    static constexpr qint64 TURN_MAX_GAP_MS = 5000;     // Longer gaps start the turn over
+
+    void reset(int row);
+    void release(int row);
+    void clear();
+    int capacity() const { return m_motionCount.size(); }
+
+    // One track update, at the velocity the track holds after it
+    void observeMotion(int row, qint64 timestampMs, const VelocityVector& velocity);
+    void observeRcs(int row, double rcsM2);
+    // protocol as the RF detector names it ("DJI_OcuSync", "Generic_2.4GHz", ...),
+    // NUL-terminated as SensorDetection's RF fields hold it
+    void observeRf(int row, const char* protocol);
+
+    int observations(int row) const;
+
+    // Row rows[i]'s feature f to out[f * count + i]; out holds
+    // TRACK_FEATURE_COUNT * count floats
+    void gather(const int* rows, int count, float* out) const;
+
+    // True for an RF protocol that only UAS control and video links use
+    static bool isUasLink(const char* protocol);
+
+private:
+    // Welford running mean and sum of squared deviations
+    struct RunningColumn {
+        QVector<double> mean;
+        QVector<double> m2;
+        void resize(int size) { mean.resize(size); m2.resize(size); }
+        void reset(int row) { mean[row] = 0.0; m2[row] = 0.0; }
+        void add(int row, quint32 count, double x) {
+            const double delta = x - mean[row];
+            mean[row] += delta / count;
+            m2[row] += delta * (x - mean[row]);
+        }
+        double stdDev(int row, quint32 count) const {
+            return count > 1 ? std::sqrt(m2[row] / (count - 1)) : 0.0;
+        }
+    };
+
+    void ensureCapacity(int row);
+
+    QVector<quint32> m_motionCount;
+    QVector<quint32> m_turnCount;
+    QVector<quint32> m_hoverCount;
+    QVector<quint32> m_rcsCount;
+    QVector<quint32> m_rfCount;
+    QVector<quint32> m_uasLinkCount;
+    RunningColumn m_speed;
+    RunningColumn m_turnRate;
+    RunningColumn m_climbRate;
+    QVector<double> m_logRcsSum;
+    QVector<double> m_lastHeadingRad;   // NaN until a fast enough update
+    QVector<qint64> m_lastMotionMs;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKFEATUREBANK_H
@@ -0,0 +1,309 @@
+#include "core/TrackGroupIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+TrackGroupIndex::TrackGroupIndex(const TrackGroupConfig& config)
+    : m_config(config)
+    , m_grid(config.linkDistanceM)
+{
+}
+
+void TrackGroupIndex::setConfig(const TrackGroupConfig& config) {
+    m_config = config;
+    m_grid.setCellSize(config.linkDistanceM);
+    for (auto it = m_members.constBegin(); it != m_members.constEnd(); ++it) {
+        m_pending.insert(it.key());
+    }
+    for (auto it = m_groups.constBegin(); it != m_groups.constEnd(); ++it) {
+        m_pendingGroups.insert(it.key());
+    }
+}
+
+void TrackGroupIndex::update(TrackHandle handle, const GeoPosition& position,
+                             const VelocityVector& velocity) {
+    if (!m_hasFrame) {
+        GeoPosition origin = position;
+        origin.altitude = 0.0;
+        m_frame.setOrigin(origin);
+        m_hasFrame = true;
+    }
+
+    const EnuVector enu = m_frame.toEnu(position);
+    auto it = m_members.find(handle);
+    if (it == m_members.end()) {
+        it = m_members.insert(handle, Member());
+        m_pending.insert(handle);
+    } else if (!m_pending.contains(handle)) {
+        const Member& member = it.value();
+        const double dn = velocity.north - member.clusteredVelocity.north;
+        const double de = velocity.east - member.clusteredVelocity.east;
+        const double dd = velocity.down - member.clusteredVelocity.down;
+        if (EnuVector::distance(enu, member.clusteredEnu) < m_config.moveToleranceM &&
+            dn * dn + de * de + dd * dd < m_config.moveToleranceMps * m_config.moveToleranceMps) {
+            if (member.group != 0) m_moved.insert(member.group);
+        } else {
+            // First real move since it was clustered: what it leaves may split
+            noteNeighbourhood(member);
+            m_pending.insert(handle);
+        }
+    }
+    it->position = position;
+    it->enu = enu;
+    it->velocity = velocity;
+    m_grid.insert(handle, position);
+}
+
+void TrackGroupIndex::remove(TrackHandle handle) {
+    auto it = m_members.find(handle);
+    if (it == m_members.end()) return;
+
+    if (!m_pending.contains(handle)) {
+        noteNeighbourhood(it.value());
+    }
+    m_pending.remove(handle);
+    m_grid.remove(handle);
+    m_members.erase(it);
+}
+
+void TrackGroupIndex::clear() {
+    m_grid.clear();
+    m_hasFrame = false;
+    m_members.clear();
+    m_groups.clear();
+    m_pending.clear();
+    m_pendingGroups.clear();
+    m_moved.clear();
+    m_neighbours.clear();
+    m_lastVisited = 0;
+}
+
+quint32 TrackGroupIndex::groupOf(TrackHandle handle) const {
+    auto it = m_members.constFind(handle);
+    return it != m_members.constEnd() ? it->group : 0;
+}
+
+const TrackGroup* TrackGroupIndex::group(quint32 groupId) const {
+    auto it = m_groups.constFind(groupId);
+    return it != m_groups.constEnd() ? &it.value() : nullptr;
+}
+
+void TrackGroupIndex::recluster(qint64 nowMs, Changes& changes) {
+    changes.changed.clear();
+    changes.dissolved.clear();
+    changes.left.clear();
+    m_lastVisited = 0;
+    if (m_pending.isEmpty() && m_pendingGroups.isEmpty()) {
+        refreshSummaries(nowMs);
+        return;
+    }
+
+    // Everything that moved, and every member of a group that may have
+    // lost one
+    QVector<TrackHandle> seeds;
+    seeds.reserve(m_pending.size());
+    for (TrackHandle handle : qAsConst(m_pending)) {
+        seeds.append(handle);
+    }
+    for (quint32 id : qAsConst(m_pendingGroups)) {
+        auto group = m_groups.constFind(id);
+        if (group == m_groups.constEnd()) continue;
+        for (TrackHandle handle : group->members) {
+            if (m_members.contains(handle)) seeds.append(handle);
+        }
+    }
+    m_pending.clear();
+    m_pendingGroups.clear();
+    m_neighbours.clear();
+
+    // Expand from each seed that is a core, or from a core next to it. A
+    // border track goes to the first group that reaches it; one no core
+    // reaches is in no group.
+    QHash<TrackHandle, int> partOf;
+    QVector<QVector<TrackHandle>> parts;
+    QVector<TrackHandle> queue;
+    for (TrackHandle seed : qAsConst(seeds)) {
+        if (partOf.contains(seed)) continue;
+        TrackHandle start = INVALID_TRACK_HANDLE;
+        if (isCore(seed)) {
+            start = seed;
+        } else {
+            const QVector<TrackHandle> around = neighboursOf(seed);
+            for (TrackHandle neighbour : around) {
+                if (!partOf.contains(neighbour) && isCore(neighbour)) {
+                    start = neighbour;
+                    break;
+                }
+            }
+        }
+        if (start == INVALID_TRACK_HANDLE) continue;
+
+        const int part = parts.size();
+        parts.append(QVector<TrackHandle>{start});
+        partOf.insert(start, part);
+        queue.clear();
+        queue.append(start);
+        for (int next = 0; next < queue.size(); ++next) {
+            const QVector<TrackHandle> around = neighboursOf(queue[next]);
+            for (TrackHandle neighbour : around) {
+                if (partOf.contains(neighbour)) continue;
+                partOf.insert(neighbour, part);
+                parts[part].append(neighbour);
+                if (isCore(neighbour)) queue.append(neighbour);
+            }
+        }
+    }
+
+    // The old groups this touches are rebuilt whole
+    QSet<TrackHandle> visited;
+    QSet<quint32> touched;
+    for (TrackHandle handle : qAsConst(seeds)) {
+        visited.insert(handle);
+    }
+    for (auto it = partOf.constBegin(); it != partOf.constEnd(); ++it) {
+        visited.insert(it.key());
+    }
+    for (TrackHandle handle : qAsConst(visited)) {
+        const quint32 old = m_members.value(handle).group;
+        if (old != 0) touched.insert(old);
+    }
+    QHash<quint32, qint64> formedMs;
+    for (quint32 id : qAsConst(touched)) {
+        auto group = m_groups.find(id);
+        if (group == m_groups.end()) continue;
+        formedMs.insert(id, group->formedMs);
+        for (TrackHandle handle : group->members) {
+            if (m_members.contains(handle)) visited.insert(handle);
+        }
+        m_groups.erase(group);
+    }
+    m_lastVisited = visited.size();
+
+    // Largest parts first, each keeping the old id most of its members had
+    QVector<int> order(parts.size());
+    for (int i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&parts](int a, int b) {
+        return parts[a].size() > parts[b].size();
+    });
+    QVector<quint32> partGroup(parts.size(), 0);
+    QSet<quint32> kept;
+    for (int part : qAsConst(order)) {
+        if (parts[part].size() < m_config.minMembers) continue;
+        QHash<quint32, int> votes;
+        for (TrackHandle handle : qAsConst(parts[part])) {
+            const quint32 old = m_members.value(handle).group;
+            if (old != 0 && !kept.contains(old)) votes[old]++;
+        }
+        quint32 id = 0;
+        int best = 0;
+        for (auto it = votes.constBegin(); it != votes.constEnd(); ++it) {
+            if (it.value() > best || (it.value() == best && it.key() < id)) {
+                id = it.key();
+                best = it.value();
+            }
+        }
+        if (id == 0) id = m_nextGroupId++;
+        kept.insert(id);
+        partGroup[part] = id;
+    }
+
+    for (TrackHandle handle : qAsConst(visited)) {
+        Member& member = m_members[handle];
+        auto part = partOf.constFind(handle);
+        const quint32 id = part != partOf.constEnd() ? partGroup[part.value()] : 0;
+        if (member.group != 0 && id == 0) changes.left.append(handle);
+        member.group = id;
+        member.clusteredEnu = member.enu;
+        member.clusteredVelocity = member.velocity;
+    }
+    for (int part = 0; part < parts.size(); ++part) {
+        if (partGroup[part] == 0) continue;
+        TrackGroup group;
+        group.groupId = partGroup[part];
+        group.members = parts[part];
+        group.formedMs = formedMs.value(group.groupId, nowMs);
+        group.updatedMs = nowMs;
+        summarize(group);
+        m_groups.insert(group.groupId, group);
+        changes.changed.append(group.groupId);
+    }
+    for (quint32 id : qAsConst(touched)) {
+        if (!kept.contains(id)) changes.dissolved.append(id);
+    }
+    refreshSummaries(nowMs);
+}
+
+const QVector<TrackHandle>& TrackGroupIndex::neighboursOf(TrackHandle handle) {
+    auto cached = m_neighbours.constFind(handle);
+    if (cached != m_neighbours.constEnd()) return cached.value();
+
+    QVector<TrackHandle>& neighbours = m_neighbours[handle];
+    auto self = m_members.constFind(handle);
+    if (self == m_members.constEnd()) return neighbours;
+
+    const double velocitySq = m_config.linkVelocityMps * m_config.linkVelocityMps;
+    m_grid.query(self->position, m_config.linkDistanceM, m_query);
+    for (TrackHandle candidate : qAsConst(m_query)) {
+        if (candidate == handle) continue;
+        auto other = m_members.constFind(candidate);
+        if (other == m_members.constEnd()) continue;
+        if (EnuVector::distance(self->enu, other->enu) > m_config.linkDistanceM) continue;
+        const double dn = self->velocity.north - other->velocity.north;
+        const double de = self->velocity.east - other->velocity.east;
+        const double dd = self->velocity.down - other->velocity.down;
+        if (dn * dn + de * de + dd * dd > velocitySq) continue;
+        neighbours.append(candidate);
+    }
+    return neighbours;
+}
+
+void TrackGroupIndex::noteNeighbourhood(const Member& member) {
+    if (member.group != 0) m_pendingGroups.insert(member.group);
+    m_grid.query(member.position, m_config.linkDistanceM, m_query);
+    for (TrackHandle handle : qAsConst(m_query)) {
+        const quint32 group = m_members.value(handle).group;
+        if (group != 0) m_pendingGroups.insert(group);
+    }
+}
+
+void TrackGroupIndex::refreshSummaries(qint64 nowMs) {
+    for (quint32 id : qAsConst(m_moved)) {
+        auto group = m_groups.find(id);
+        if (group == m_groups.end()) continue;
+        summarize(group.value());
+        group->updatedMs = nowMs;
+    }
+    m_moved.clear();
+}
+
+void TrackGroupIndex::summarize(TrackGroup& group) const {
+    EnuVector centre;
+    VelocityVector velocity;
+    for (TrackHandle handle : qAsConst(group.members)) {
+        const Member& member = m_members[handle];
+        centre.east += member.enu.east;
+        centre.north += member.enu.north;
+        centre.up += member.enu.up;
+        velocity.north += member.velocity.north;
+        velocity.east += member.velocity.east;
+        velocity.down += member.velocity.down;
+    }
+    const double n = group.members.size();
+    centre.east /= n;
+    centre.north /= n;
+    centre.up /= n;
+    velocity.north /= n;
+    velocity.east /= n;
+    velocity.down /= n;
+
+    double extent = 0.0;
+    for (TrackHandle handle : qAsConst(group.members)) {
+        extent = std::max(extent, EnuVector::distance(centre, m_members[handle].enu));
+    }
+    group.centroid = m_frame.toGeo(centre);
+    group.extentM = extent;
+    group.velocity = velocity;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,123 @@
+#ifndef TRACKGROUPINDEX_H
+#define TRACKGROUPINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "core/TrackSnapshot.h"
+#include "core/TrackSpatialIndex.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Neighbourhood and size limits of a TrackGroupIndex
+ */
+struct TrackGroupConfig {
+    double linkDistanceM = 150.0;   // Neighbours are closer than this...
+    double linkVelocityMps = 15.0;  // ...and moving within this of each other
+    int minNeighbours = 2;          // A core member has at least this many neighbours
+    int minMembers = 3;             // Smaller clusters are not groups
+    double moveToleranceM = 10.0;   // Smaller moves since a track was clustered...
+    double moveToleranceMps = 1.5;  // ...with velocity changes smaller than this keep its links
+};
+
+/**
+ * @brief Swarm groups over the tracks, re-clustered only where they changed
+ *
+ * DBSCAN over position and velocity: two tracks are neighbours when they
+ * are within linkDistanceM and their velocities within linkVelocityMps; a
+ * core track has at least minNeighbours of them, a group is the cores
+ * reachable from one another through neighbours plus the neighbours of
+ * those cores, and groups of fewer than minMembers are left out.
+ *
+ * Neighbours come from a grid of linkDistanceM cells, so finding them costs
+ * the local density, not the track count. update() and remove() only note
+ * what changed; recluster() then walks out from those tracks, from the
+ * members of the groups they were in and from the groups of what was near
+ * them before they moved, and rebuilds just the groups it reaches. Tracks
+ * far from any change are not touched, and a cycle in which nothing moved
+ * costs nothing. A track that has moved less than moveToleranceM (and
+ * changed velocity less than moveToleranceMps) since it was last clustered
+ * keeps its links; its group's centroid, extent and velocity are refreshed
+ * without walking anything, so a swarm flying in formation is not
+ * re-clustered every cycle.
+ *
+ * Not thread-safe; TrackManager owns one under its lock.
+ */
+class TrackGroupIndex {
+public:
+    explicit TrackGroupIndex(const TrackGroupConfig& config = TrackGroupConfig());
+
+    // A new configuration re-clusters every track on the next recluster()
+    void setConfig(const TrackGroupConfig& config);
+    TrackGroupConfig config() const { return m_config; }
+
+    // Insert or move
+    void update(TrackHandle handle, const GeoPosition& position, const VelocityVector& velocity);
+    void remove(TrackHandle handle);
+    void clear();
+
+    int trackCount() const { return m_members.size(); }
+    int groupCount() const { return m_groups.size(); }
+
+    /**
+     * @brief What one recluster() changed
+     */
+    struct Changes {
+        QVector<quint32> changed;     // Formed or rebuilt; members may be unchanged
+        QVector<quint32> dissolved;
+        QVector<TrackHandle> left;    // Still indexed, no longer in any group
+
+        bool isEmpty() const { return changed.isEmpty() && dissolved.isEmpty() && left.isEmpty(); }
+    };
+
+    // Re-clusters around everything updated or removed since the last call
+    void recluster(qint64 nowMs, Changes& changes);
+
+    quint32 groupOf(TrackHandle handle) const;    // 0 when in none
+    const TrackGroup* group(quint32 groupId) const;
+    const QHash<quint32, TrackGroup>& groups() const { return m_groups; }
+
+    // Tracks the last recluster() examined
+    int lastVisited() const { return m_lastVisited; }
+
+private:
+    struct Member {
+        GeoPosition position;
+        EnuVector enu;
+        VelocityVector velocity;
+        EnuVector clusteredEnu;          // Where the last recluster() saw it
+        VelocityVector clusteredVelocity;
+        quint32 group = 0;
+    };
+
+    const QVector<TrackHandle>& neighboursOf(TrackHandle handle);
+    bool isCore(TrackHandle handle) { return neighboursOf(handle).size() >= m_config.minNeighbours; }
+    // Groups of what is within reach of the track where it was last clustered
+    void noteNeighbourhood(const Member& member);
+    void summarize(TrackGroup& group) const;
+    void refreshSummaries(qint64 nowMs);
+
+    TrackGroupConfig m_config;
+    TrackSpatialIndex m_grid;
+    LocalTangentPlane m_frame;
+    bool m_hasFrame = false;
+    QHash<TrackHandle, Member> m_members;
+    QHash<quint32, TrackGroup> m_groups;
+    quint32 m_nextGroupId = 1;
+
+    // Since the last recluster()
+    QSet<TrackHandle> m_pending;
+    QSet<quint32> m_pendingGroups;
+    QSet<quint32> m_moved;             // Groups whose members moved within tolerance
+
+    // recluster() scratch, kept for its capacity
+    QHash<TrackHandle, QVector<TrackHandle>> m_neighbours;
+    QVector<TrackHandle> m_query;
+    int m_lastVisited = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKGROUPINDEX_H
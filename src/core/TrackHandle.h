@@ -0,0 +1,22 @@
+#ifndef TRACKHANDLE_H
+#define TRACKHANDLE_H
+
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Compact integer identity of a track
+ *
+ * Assigned by TrackManager when a track is created and never reused for the
+ * lifetime of the manager. The "TRK-nnnn" string id is derived from it and is
+ * kept for display and serialization only; lookups, hashing and signals on
+ * hot paths use the handle.
+ */
+using TrackHandle = quint32;
+
+constexpr TrackHandle INVALID_TRACK_HANDLE = 0;
+
+} // namespace CounterUAS
+
+#endif // TRACKHANDLE_H
@@ -1,35 +1,127 @@
 #include "core/TrackManager.h"
+#include "core/FusionPolicy.h"
 #include "utils/Logger.h"
+#include "utils/MemoryGovernor.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/AssignmentSolver.h"
+#include "utils/FlightRecorder.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/PipelineLatency.h"
+#include "utils/TaskScheduler.h"
+#include "utils/OverloadController.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
+#include "utils/Trace.h"
+#include "sensors/SensorInterface.h"
+#include <QDataStream>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QSet>
+#include <QThread>
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace CounterUAS {
 
+namespace {
+
+constexpr int CLASSIFY_MIN_OBSERVATIONS = 5;     // Updates before a track's statistics mean anything
+constexpr double CLASSIFY_MIN_CHANGE = 0.01;     // Smaller moves are not written, so not sent
+constexpr double MAX_LEARNED_CONFIDENCE = 0.99;  // 1 is kept for classifications set outright
+constexpr int GATING_CHUNK_PLOTS = 64;           // Fewest plots worth a scheduler task in a batch
+
+} // namespace
+
 TrackManager::TrackManager(QObject* parent)
     : QObject(parent)
+    , m_spatialIndex(m_config.correlationDistanceM)
     , m_updateTimer(new QTimer(this))
 {
+    qRegisterMetaType<TrackHandle>("TrackHandle");
+    qRegisterMetaType<QVector<TrackHandle>>("QVector<TrackHandle>");
+    qRegisterMetaType<TrackChangeSet>("TrackChangeSet");
+    qRegisterMetaType<QVector<TrackThreatUpdate>>("QVector<TrackThreatUpdate>");
+    
     connect(m_updateTimer, &QTimer::timeout, this, &TrackManager::processTrackCycle);
+    m_snapshot = std::make_shared<const TrackPicture>();
+    
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_metrics.activeTracks = registry.gauge("cuas_tracks_active", "Confirmed tracks not coasting");
+    m_metrics.coastingTracks = registry.gauge("cuas_tracks_coasting", "Tracks coasting without detections");
+    m_metrics.tentativeTracks = registry.gauge("cuas_tracks_tentative", "Unconfirmed plots awaiting initiation");
+    m_metrics.tracksCreated = registry.counter("cuas_tracks_created_total", "Tracks created");
+    m_metrics.tracksDropped = registry.counter("cuas_tracks_dropped_total", "Tracks dropped");
+    m_metrics.outOfSequence = registry.counter("cuas_track_oosm_updates_total",
+                                               "Late plots fused by filter replay");
+    m_metrics.tracksMerged = registry.counter("cuas_tracks_merged_total", "Duplicate tracks merged automatically");
+    m_metrics.cycleTime = registry.histogram("cuas_track_cycle_seconds", "Track manager update cycle time");
+    applyFilterConfig();
+    applyInitiationConfig();
+    applyGroupConfig();
+    applyAssociationConfig();
+    
+    // Under memory pressure tracks keep less position history, never less than merging compares
+    m_memoryConsumer = MemoryGovernor::instance().registerConsumer(this, "track.history",
+        MemoryShedOrder::TrackHistory, 0,
+        [this]() { return m_historyBytes.load(std::memory_order_relaxed); },
+        [this](MemoryPressure pressure) {
+            QWriteLocker locker(&m_lock);
+            m_historyShift = static_cast<int>(pressure);
+            const int capacity = historyCapacity();
+            for (Track* t : m_slab.live()) {
+                t->setHistoryCapacity(capacity);
+            }
+        });
 }
 
 TrackManager::~TrackManager() {
+    MemoryGovernor::instance().unregisterConsumer(m_memoryConsumer);
     stop();
     clearAllTracks();
 }
 
 void TrackManager::setConfig(const TrackManagerConfig& config) {
-    m_config = config;
+    {
+        QWriteLocker locker(&m_lock);
+        m_config = config;
+        m_spatialIndex.setCellSize(m_config.correlationDistanceM);
+        applyFilterConfig();
+        applyInitiationConfig();
+        applyGroupConfig();
+        applyAssociationConfig();
+        const int capacity = historyCapacity();
+        for (Track* t : m_slab.live()) {
+            t->setHistoryCapacity(capacity);
+        }
+    }
     if (m_running) {
-        m_updateTimer->setInterval(1000 / m_config.updateRateHz);
+        // The timer belongs to the manager's thread
+        const int intervalMs = cycleIntervalMs();
+        QMetaObject::invokeMethod(m_updateTimer, [this, intervalMs]() {
+            m_updateTimer->setInterval(intervalMs);
+        });
+    }
+}
+
+void TrackManager::setClock(const Clock* clock) {
+    QWriteLocker locker(&m_lock);
+    m_clock = clock ? clock : Clock::system();
+    for (Track* t : m_slab.live()) {
+        t->setClock(m_clock);
     }
 }
 
+void TrackManager::step() {
+    if (runOnOwnerThread([this]() { step(); })) return;
+    processTrackCycle();
+}
+
 void TrackManager::start() {
+    if (runOnOwnerThread([this]() { start(); })) return;
     if (m_running) return;
     
-    m_updateTimer->setInterval(1000 / m_config.updateRateHz);
+    m_updateTimer->setInterval(cycleIntervalMs());
     m_updateTimer->start();
     m_running = true;
     
@@ -39,6 +131,7 @@ void TrackManager::start() {
 }
 
 void TrackManager::stop() {
+    if (runOnOwnerThread([this]() { stop(); })) return;
     if (!m_running) return;
     
     m_updateTimer->stop();
@@ -55,7 +148,16 @@ int TrackManager::trackCount() const {
 
 QList<Track*> TrackManager::allTracks() const {
     QReadLocker locker(&m_lock);
-    return m_tracks.values();
+    return m_slab.live().toList();
+}
+
+void TrackManager::allTracks(QVector<Track*>& out) const {
+    QReadLocker locker(&m_lock);
+    out.clear();
+    out.reserve(m_tracks.size());
+    for (Track* t : m_slab.live()) {
+        out.append(t);
+    }
 }
 
 Track* TrackManager::track(const QString& trackId) const {
@@ -63,47 +165,72 @@ Track* TrackManager::track(const QString& trackId) const {
     return m_tracks.value(trackId, nullptr);
 }
 
+Track* TrackManager::track(TrackHandle handle) const {
+    QReadLocker locker(&m_lock);
+    return m_tracksByHandle.value(handle, nullptr);
+}
+
+TrackHandle TrackManager::handleOf(const QString& trackId) const {
+    QReadLocker locker(&m_lock);
+    Track* t = m_tracks.value(trackId, nullptr);
+    return t ? t->handle() : INVALID_TRACK_HANDLE;
+}
+
 QList<Track*> TrackManager::tracksByClassification(TrackClassification cls) const {
+    QVector<Track*> result;
+    tracksByClassification(cls, result);
+    return QList<Track*>(result.begin(), result.end());
+}
+
+QList<Track*> TrackManager::tracksByThreatLevel(int minLevel) const {
+    QVector<Track*> result;
+    tracksByThreatLevel(minLevel, result);
+    return QList<Track*>(result.begin(), result.end());
+}
+
+QList<Track*> TrackManager::tracksInRadius(const GeoPosition& center, double radiusM) const {
+    QVector<Track*> result;
+    tracksInRadius(center, radiusM, result);
+    return QList<Track*>(result.begin(), result.end());
+}
+
+void TrackManager::tracksByClassification(TrackClassification cls, QVector<Track*>& out) const {
     QReadLocker locker(&m_lock);
-    QList<Track*> result;
-    for (auto* t : m_tracks) {
-        if (t->classification() == cls && t->state() != TrackState::Dropped) {
-            result.append(t);
-        }
+    out.clear();
+    const QVector<int>& rows = m_table.rowsWithClassification(cls);
+    out.reserve(rows.size());
+    for (int row : rows) {
+        out.append(m_rowTracks[row]);
     }
-    return result;
 }
 
-QList<Track*> TrackManager::tracksByThreatLevel(int minLevel) const {
+void TrackManager::tracksByThreatLevel(int minLevel, QVector<Track*>& out) const {
     QReadLocker locker(&m_lock);
-    QList<Track*> result;
-    for (auto* t : m_tracks) {
-        if (t->threatLevel() >= minLevel && t->state() != TrackState::Dropped) {
-            result.append(t);
-        }
+    out.clear();
+    // Already highest level first
+    QVector<int>& rows = correlationScratch().rows;
+    rows.clear();
+    m_table.rowsByThreatLevel(minLevel, rows);
+    out.reserve(rows.size());
+    for (int row : rows) {
+        out.append(m_rowTracks[row]);
     }
-    // Sort by threat level descending
-    std::sort(result.begin(), result.end(), [](Track* a, Track* b) {
-        return a->threatLevel() > b->threatLevel();
-    });
-    return result;
 }
 
-QList<Track*> TrackManager::tracksInRadius(const GeoPosition& center, double radiusM) const {
+void TrackManager::tracksInRadius(const GeoPosition& center, double radiusM,
+                                  QVector<Track*>& out) const {
     QReadLocker locker(&m_lock);
-    QList<Track*> result;
-    
-    // Create temporary track for distance calculation
-    Track tempTrack("temp");
-    tempTrack.setPosition(center);
-    
-    for (auto* t : m_tracks) {
-        if (t->state() != TrackState::Dropped && 
-            tempTrack.distanceTo(t->position()) <= radiusM) {
-            result.append(t);
+    out.clear();
+    
+    QVector<TrackHandle>& candidates = correlationScratch().candidates;
+    m_spatialIndex.query(center, radiusM, candidates);
+    for (TrackHandle handle : candidates) {
+        Track* t = m_tracksByHandle.value(handle, nullptr);
+        if (t && t->state() != TrackState::Dropped &&
+            CoordinateUtils::haversineDistance(center, t->position()) <= radiusM) {
+            out.append(t);
         }
     }
-    return result;
 }
 
 QList<Track*> TrackManager::hostileTracks() const {
@@ -117,86 +244,265 @@ QList<Track*> TrackManager::pendingTracks() const {
 Track* TrackManager::highestThreatTrack() const {
     QReadLocker locker(&m_lock);
     Track* highest = nullptr;
-    int maxThreat = 0;
     
-    for (auto* t : m_tracks) {
-        if (t->state() != TrackState::Dropped && 
-            t->classification() == TrackClassification::Hostile &&
-            t->threatLevel() > maxThreat) {
-            maxThreat = t->threatLevel();
-            highest = t;
+    // Entries are re-keyed by the setters and each track cycle; skip any a
+    // direct Track write has invalidated since
+    m_hostileQueue.visitInOrder([this, &highest](const ThreatPriorityQueue::Entry& entry) {
+        Track* t = m_tracksByHandle.value(entry.handle, nullptr);
+        if (!t || t->state() == TrackState::Dropped ||
+            t->classification() != TrackClassification::Hostile) {
+            return false;
         }
-    }
+        highest = t;
+        return true;
+    });
     return highest;
 }
 
+GeoPosition TrackManager::predictedPosition(const QString& trackId, qint64 deltaMs) const {
+    QReadLocker locker(&m_lock);
+    
+    Track* t = m_tracks.value(trackId, nullptr);
+    if (!t) return GeoPosition();
+    
+    // The filter state is as of its own timestamp; extrapolate from there
+    const int row = t->tableRow();
+    const qint64 nowMs = m_clock->nowMs();
+    if (m_immBank.isActive(row)) {
+        qint64 ahead = nowMs + deltaMs - m_immBank.timestampMs(row);
+        return fromFilterFrame(m_immBank.predictedPosition(row, ahead));
+    }
+    if (m_filterBank.isActive(row)) {
+        qint64 ahead = nowMs + deltaMs - m_filterBank.timestampMs(row);
+        return fromFilterFrame(m_filterBank.predictedPosition(row, ahead));
+    }
+    return t->predictedPosition(deltaMs);
+}
+
+TrackManager::Statistics TrackManager::statistics() const {
+    QReadLocker locker(&m_lock);
+    Statistics stats = m_stats;
+    // Kept by the table's state setters, so current to the last write
+    stats.currentActiveCount = m_table.stateCount(TrackState::Initiated) +
+                               m_table.stateCount(TrackState::Active);
+    stats.currentCoastingCount = m_table.stateCount(TrackState::Coasting);
+    const TentativeTrackPool::Stats pool = m_tentatives.stats();
+    stats.currentTentativeCount = m_tentatives.size();
+    stats.totalTentativesConfirmed = pool.confirmed;
+    stats.totalTentativesExpired = pool.expired + pool.evicted;
+    stats.mhtOpenTracks = m_mht.openTracks();
+    return stats;
+}
+
+int TrackManager::tentativeCount() const {
+    QReadLocker locker(&m_lock);
+    return m_tentatives.size();
+}
+
+QVector<TentativeTrack> TrackManager::tentativeTracks() const {
+    QReadLocker locker(&m_lock);
+    return m_tentatives.tentatives();
+}
+
+TrackPicturePtr TrackManager::snapshot() const {
+    return std::atomic_load(&m_snapshot);
+}
+
 QString TrackManager::createTrack(const GeoPosition& pos, DetectionSource source) {
     QWriteLocker locker(&m_lock);
     
+    Track* created = createTrackLocked(pos, source);
+    if (!created) return QString();
+    
+    const QString trackId = created->trackId();
+    const TrackHandle handle = created->handle();
+    int count = m_tracks.size();
+    locker.unlock();
+    
+    CUAS_LOG_INFO("TrackManager", "Created track: " + trackId);
+    emit trackCreated(trackId);
+    emit trackHandleCreated(handle);
+    emit trackCountChanged(count);
+    
+    return trackId;
+}
+
+Track* TrackManager::createTrackLocked(const GeoPosition& pos, DetectionSource source) {
     if (m_tracks.size() >= m_config.maxTracks) {
         Logger::instance().warning("TrackManager", "Maximum track limit reached");
-        return QString();
+        return nullptr;
     }
     
-    QString trackId = generateTrackId();
-    Track* newTrack = new Track(trackId, this);
-    newTrack->setPosition(pos);
+    const TrackHandle handle = allocateHandle();
+    Track* newTrack = addTrackLocked(formatTrackId(handle), handle, pos);
     newTrack->addDetectionSource(source);
     newTrack->setState(TrackState::Initiated);
     newTrack->setClassification(TrackClassification::Pending);
     
+    // Start a filter in the bank slot matching the table row
+    const int row = newTrack->tableRow();
+    if (m_config.enableKalmanFilter && m_config.enableImmFilter) {
+        m_immBank.initialize(row, toFilterFrameLocked(pos), m_clock->nowMs());
+    } else if (m_config.enableKalmanFilter) {
+        m_filterBank.initialize(row, toFilterFrameLocked(pos),
+                                m_clock->nowMs(),
+                                m_config.kalmanMotionModel);
+    }
+    
+    m_stats.totalTracksCreated++;
+    
+    return newTrack;
+}
+
+Track* TrackManager::addTrackLocked(const QString& trackId, TrackHandle handle, const GeoPosition& pos) {
+    // Tracks live on the manager's thread whichever thread created them
+    Track* newTrack = m_slab.acquire(trackId);
+    newTrack->setClock(m_clock);
+    newTrack->moveToThread(thread());
+    newTrack->setHandle(handle);
+    
+    int row = m_table.allocate();
+    if (row >= m_rowTracks.size()) {
+        m_rowTracks.resize(row + 1);
+    }
+    m_rowTracks[row] = newTrack;
+    anchorFrameLocked(pos);
+    newTrack->bindTable(&m_table, row);
+    newTrack->setHistoryCapacity(historyCapacity());
+    m_features.reset(row);
+    
+    newTrack->setPosition(pos);
+    
     m_tracks.insert(trackId, newTrack);
+    m_tracksByHandle.insert(handle, newTrack);
+    m_spatialIndex.insert(handle, pos);
+    return newTrack;
+}
+
+Track* TrackManager::initiateTrackLocked(const SensorDetection& detection, qint64 nowMs) {
+    if (m_tentatives.isPassThrough()) {
+        return createTrackLocked(detection.position, detection.sourceType);
+    }
     
-    // Create Kalman filter for this track
-    if (m_config.enableKalmanFilter) {
-        auto filter = std::make_shared<KalmanFilter2D>();
-        filter->initialize(pos.latitude, pos.longitude);
-        m_kalmanFilters.insert(trackId, filter);
+    TentativeTrack confirmed;
+    if (!m_tentatives.observe(detection.position, detection.velocity, detection.sourceType,
+                              detection.confidence, nowMs, confirmed)) {
+        return nullptr;
     }
     
-    m_stats.totalTracksCreated++;
-    m_stats.currentActiveCount = m_tracks.size();
+    Track* t = createTrackLocked(confirmed.position, detection.sourceType);
+    if (!t) return nullptr;
+    
+    // Carry over what the tentative accumulated; M hits already make it active
+    for (int source = 0; source <= static_cast<int>(DetectionSource::Cooperative); ++source) {
+        if (confirmed.sourceMask & (1u << source)) {
+            t->addDetectionSource(static_cast<DetectionSource>(source));
+        }
+    }
+    if (confirmed.sourceMask & (1u << static_cast<int>(DetectionSource::Radar))) {
+        t->setVelocity(confirmed.velocity);
+    }
+    t->setTrackQuality(confirmed.quality);
+    t->setState(TrackState::Active);
+    return t;
+}
+
+QString TrackManager::initiateTrack(const SensorDetection& detection) {
+    QWriteLocker locker(&m_lock);
+    
+    Track* created = initiateTrackLocked(detection, m_clock->nowMs());
+    if (!created) return QString();
     
+    const QString trackId = created->trackId();
+    const TrackHandle handle = created->handle();
+    int count = m_tracks.size();
     locker.unlock();
     
-    Logger::instance().info("TrackManager", "Created track: " + trackId);
+    CUAS_LOG_INFO("TrackManager", "Created track: " + trackId);
     emit trackCreated(trackId);
-    emit trackCountChanged(m_tracks.size());
+    emit trackHandleCreated(handle);
+    emit trackCountChanged(count);
     
     return trackId;
 }
 
-void TrackManager::updateTrack(const QString& trackId, const GeoPosition& pos) {
+void TrackManager::updateTrack(const QString& trackId, const GeoPosition& pos, qint64 timestampMs) {
     QWriteLocker locker(&m_lock);
     
     Track* t = m_tracks.value(trackId);
     if (!t) return;
     
+    // A plot from outside a scan moves the filter off every open hypothesis
+    m_mht.forget(t->handle());
+    updateTrackLocked(t, pos, timestampMs > 0 ? measurementTime(timestampMs, m_clock->nowMs()) : 0);
+    const TrackHandle handle = t->handle();
+    
+    locker.unlock();
+    
+    emit trackUpdated(trackId);
+    emit trackHandleUpdated(handle);
+}
+
+void TrackManager::updateTrackLocked(Track* t, const GeoPosition& pos, qint64 measuredMs) {
     GeoPosition filteredPos = pos;
     
-    // Apply Kalman filter if enabled
-    if (m_config.enableKalmanFilter && m_kalmanFilters.contains(trackId)) {
-        auto it = m_kalmanFilters.find(trackId);
-        if (it != m_kalmanFilters.end()) {
-            it.value()->update(pos.latitude, pos.longitude);
-            filteredPos.latitude = it.value()->stateX();
-            filteredPos.longitude = it.value()->stateY();
+    // Apply Kalman filter if enabled (whichever bank the track started in)
+    const int row = t->tableRow();
+    const bool imm = m_config.enableKalmanFilter && m_immBank.isActive(row);
+    const bool single = m_config.enableKalmanFilter && m_filterBank.isActive(row);
+    if (imm || single) {
+        const qint64 nowMs = measuredMs > 0 ? measuredMs : m_clock->nowMs();
+        EnuVector vel;
+        if (imm) {
+            // IMM mixing is per cycle and cannot be replayed; late plots fuse on arrival
+            m_immBank.update(row, toFilterFrameLocked(pos), qMax(nowMs, m_immBank.timestampMs(row)));
+            filteredPos = fromFilterFrame(m_immBank.position(row));
+            vel = m_immBank.velocity(row);
+            
+            MotionModeProbabilities modes;
+            modes.constantVelocity = m_immBank.modeProbability(row, ImmFilterBank::ModeConstantVelocity);
+            modes.constantAcceleration = m_immBank.modeProbability(row, ImmFilterBank::ModeConstantAcceleration);
+            modes.coordinatedTurn = m_immBank.modeProbability(row, ImmFilterBank::ModeTurnLeft) +
+                                    m_immBank.modeProbability(row, ImmFilterBank::ModeTurnRight);
+            t->setModeProbabilities(modes);
+        } else {
+            switch (m_filterBank.update(row, toFilterFrameLocked(pos), nowMs)) {
+                case KalmanFilterBank::UpdateResult::Replayed:
+                    m_stats.outOfSequenceUpdates++;
+                    break;
+                case KalmanFilterBank::UpdateResult::TooOld:
+                    m_stats.outOfSequenceDiscarded++;
+                    break;
+                default:
+                    break;
+            }
+            filteredPos = fromFilterFrame(m_filterBank.position(row));
+            vel = m_filterBank.velocity(row);
+        }
+        
+        // Radar supplies measured velocity; otherwise use the estimate
+        if (!t->hasSource(DetectionSource::Radar)) {
+            VelocityVector estimate;
+            estimate.north = vel.north;
+            estimate.east = vel.east;
+            estimate.down = -vel.up;
+            t->setVelocity(estimate);
         }
     }
+    // Radar's measured velocity is set after this, so its tracks' features
+    // run one plot behind
+    m_features.observeMotion(row, measuredMs > 0 ? measuredMs : m_clock->nowMs(), t->velocity());
     
     t->setPosition(filteredPos);
-    t->addPositionHistory(filteredPos, QDateTime::currentMSecsSinceEpoch());
+    m_spatialIndex.insert(t->handle(), filteredPos);
+    t->addPositionHistory(filteredPos, m_clock->nowMs());
     t->resetCoastCount();
     
     if (t->state() == TrackState::Initiated || t->state() == TrackState::Coasting) {
         t->setState(TrackState::Active);
     }
     
-    m_stats.lastUpdateTimeMs = QDateTime::currentMSecsSinceEpoch();
-    
-    locker.unlock();
-    
-    emit trackUpdated(trackId);
+    m_stats.lastUpdateTimeMs = m_clock->nowMs();
 }
 
 void TrackManager::updateTrackVelocity(const QString& trackId, const VelocityVector& vel) {
@@ -206,10 +512,12 @@ void TrackManager::updateTrackVelocity(const QString& trackId, const VelocityVec
     if (!t) return;
     
     t->setVelocity(vel);
+    const TrackHandle handle = t->handle();
     
     locker.unlock();
     
     emit trackUpdated(trackId);
+    emit trackHandleUpdated(handle);
 }
 
 void TrackManager::setTrackClassification(const QString& trackId, TrackClassification cls, double confidence) {
@@ -220,6 +528,7 @@ void TrackManager::setTrackClassification(const QString& trackId, TrackClassific
     
     t->setClassification(cls);
     t->setClassificationConfidence(confidence);
+    updateHostileQueueLocked(t);
     
     locker.unlock();
     
@@ -234,6 +543,7 @@ void TrackManager::setTrackThreatLevel(const QString& trackId, int level) {
     
     int oldLevel = t->threatLevel();
     t->setThreatLevel(level);
+    updateHostileQueueLocked(t);
     
     locker.unlock();
     
@@ -244,6 +554,100 @@ void TrackManager::setTrackThreatLevel(const QString& trackId, int level) {
     }
 }
 
+void TrackManager::setUpdateTiers(const QVector<QPair<TrackHandle, TrackUpdateTier>>& tiers) {
+    QWriteLocker locker(&m_lock);
+    for (const auto& entry : tiers) {
+        Track* t = m_tracksByHandle.value(entry.first, nullptr);
+        if (t) m_table.setUpdateTier(t->tableRow(), entry.second);
+    }
+}
+
+TrackUpdateTier TrackManager::updateTier(TrackHandle handle) const {
+    QReadLocker locker(&m_lock);
+    Track* t = m_tracksByHandle.value(handle, nullptr);
+    return t ? m_table.updateTier(t->tableRow()) : TrackUpdateTier::Routine;
+}
+
+int TrackManager::applyThreatAssessments(QVector<TrackThreatUpdate>& updates) {
+    QVector<TrackThreatUpdate> applied;
+    {
+        QWriteLocker locker(&m_lock);
+        for (TrackThreatUpdate& update : updates) {
+            update.applied = false;
+            Track* t = m_tracksByHandle.value(update.handle);
+            if (!t || t->state() == TrackState::Dropped) continue;
+            
+            update.previousThreatLevel = t->threatLevel();
+            update.previousClassification = t->classification();
+            const bool reclassify = update.classification != TrackClassification::Unknown &&
+                                    update.classification != update.previousClassification;
+            if (qBound(1, update.threatLevel, 5) == update.previousThreatLevel && !reclassify) continue;
+            
+            t->setThreatLevel(update.threatLevel);
+            update.threatLevel = t->threatLevel();
+            if (reclassify) {
+                // As setTrackClassification() with its default confidence
+                t->setClassification(update.classification);
+                t->setClassificationConfidence(1.0);
+            }
+            updateHostileQueueLocked(t);
+            update.applied = true;
+            applied.append(update);
+        }
+    }
+    
+    if (!applied.isEmpty()) {
+        emit threatAssessmentsApplied(applied);
+    }
+    return applied.size();
+}
+
+int TrackManager::classifyTracks() {
+    CUAS_TRACE_SCOPE("core", "TrackManager::classifyTracks");
+    QWriteLocker locker(&m_lock);
+    
+    m_classifyRows.clear();
+    for (int row = 0; row < m_rowTracks.size(); ++row) {
+        const Track* t = m_rowTracks[row];
+        if (!t || t->state() == TrackState::Dropped) continue;
+        if (m_features.observations(row) < CLASSIFY_MIN_OBSERVATIONS) continue;
+        const TrackClassification cls = t->classification();
+        if (cls == TrackClassification::Friendly || cls == TrackClassification::Neutral ||
+            t->classificationConfidence() >= 1.0) {
+            continue;
+        }
+        m_classifyRows.append(row);
+    }
+    
+    const int count = m_classifyRows.size();
+    if (count == 0) return 0;
+    m_classifyFeatures.resize(count * TRACK_FEATURE_COUNT);
+    m_classifyProbabilities.resize(count);
+    m_features.gather(m_classifyRows.constData(), count, m_classifyFeatures.data());
+    m_classifier.predict(m_classifyFeatures.constData(), count, m_classifyProbabilities.data());
+    
+    // Written in place; the confidence goes out with the next change set
+    int changed = 0;
+    for (int i = 0; i < count; ++i) {
+        Track* t = m_rowTracks[m_classifyRows[i]];
+        const double confidence = qMin(MAX_LEARNED_CONFIDENCE, double(m_classifyProbabilities[i]));
+        if (std::abs(confidence - t->classificationConfidence()) < CLASSIFY_MIN_CHANGE) continue;
+        t->setClassificationConfidence(confidence);
+        ++changed;
+    }
+    return changed;
+}
+
+bool TrackManager::setClassifierModel(const TrackClassifierModel& model) {
+    QWriteLocker locker(&m_lock);
+    return m_classifier.setModel(model);
+}
+
+TrackClassifierModel TrackManager::classifierModel() const {
+    QReadLocker locker(&m_lock);
+    return m_classifier.model();
+}
+
 void TrackManager::setTrackBoundingBox(const QString& trackId, const BoundingBox& box) {
     QWriteLocker locker(&m_lock);
     
@@ -253,6 +657,13 @@ void TrackManager::setTrackBoundingBox(const QString& trackId, const BoundingBox
     t->setBoundingBox(box);
 }
 
+BoundingBox TrackManager::trackBoundingBox(const QString& trackId) const {
+    QReadLocker locker(&m_lock);
+    
+    Track* t = m_tracks.value(trackId);
+    return t ? t->boundingBox() : BoundingBox();
+}
+
 void TrackManager::associateCamera(const QString& trackId, const QString& cameraId) {
     QWriteLocker locker(&m_lock);
     
@@ -270,12 +681,17 @@ void TrackManager::dropTrack(const QString& trackId) {
     if (!t) return;
     
     t->setState(TrackState::Dropped);
+    const TrackHandle handle = t->handle();
+    m_spatialIndex.remove(handle);
+    m_groups.remove(handle);
+    m_hostileQueue.remove(handle);
     m_stats.totalTracksDropped++;
     
     locker.unlock();
     
-    Logger::instance().info("TrackManager", "Dropped track: " + trackId);
+    CUAS_LOG_INFO("TrackManager", "Dropped track: " + trackId);
     emit trackDropped(trackId);
+    emit trackHandleDropped(handle);
     emit trackStateChanged(trackId, TrackState::Dropped);
 }
 
@@ -299,8 +715,19 @@ void TrackManager::mergeTrack(const QString& sourceId, const QString& targetId)
     Track* source = m_tracks.value(sourceId);
     Track* target = m_tracks.value(targetId);
     
-    if (!source || !target) return;
+    if (!source || !target || source == target) return;
+    
+    const TrackHandle sourceHandle = source->handle();
+    mergeTrackLocked(source, target);
+    
+    locker.unlock();
     
+    CUAS_LOG_INFO("TrackManager", QString("Merged track %1 into %2").arg(sourceId, targetId));
+    emit trackDropped(sourceId);
+    emit trackHandleDropped(sourceHandle);
+}
+
+void TrackManager::mergeTrackLocked(Track* source, Track* target) {
     // Merge detection sources
     for (auto src : source->detectionSources()) {
         target->addDetectionSource(src);
@@ -308,29 +735,130 @@ void TrackManager::mergeTrack(const QString& sourceId, const QString& targetId)
     
     // Drop source track
     source->setState(TrackState::Dropped);
+    const TrackHandle sourceHandle = source->handle();
+    m_spatialIndex.remove(sourceHandle);
+    m_groups.remove(sourceHandle);
+    m_hostileQueue.remove(sourceHandle);
     m_stats.totalTracksDropped++;
     m_stats.correlationSuccessCount++;
+}
+
+void TrackManager::mergeDuplicatesLocked(qint64 nowMs, QVector<MergedTrack>& merged) {
+    const int rows = m_rowTracks.size();
+    if (rows == 0 || m_tracks.size() < 2) return;
+    
+    const qint64 deadlineNs = m_config.mergeBudgetUs > 0
+        ? TimeUtils::monotonicNs() + static_cast<qint64>(m_config.mergeBudgetUs) * 1000 : 0;
+    for (int visited = 0; visited < rows; ++visited) {
+        if (deadlineNs > 0 && TimeUtils::monotonicNs() > deadlineNs) {
+            m_stats.mergeBudgetExhausted++;
+            return;
+        }
+        if (m_mergeCursor >= rows) m_mergeCursor = 0;
+        const int row = m_mergeCursor++;
+        if (m_mergeCursor >= rows) {
+            m_mergeCursor = 0;
+            m_stats.mergeSweeps++;
+        }
+        
+        Track* a = m_table.isLive(row) ? m_rowTracks[row] : nullptr;
+        if (!a || a->state() == TrackState::Dropped) continue;
+        
+        m_spatialIndex.query(a->position(), m_config.mergeSearchRadiusM, m_mergeCandidates);
+        for (TrackHandle handle : qAsConst(m_mergeCandidates)) {
+            if (handle <= a->handle()) continue;  // Each pair once, from its older track
+            Track* b = m_tracksByHandle.value(handle, nullptr);
+            if (!b || b->state() == TrackState::Dropped) continue;
+            // Two engagements are for the operator to resolve
+            if (a->isEngaged() && b->isEngaged()) continue;
+            
+            m_stats.mergePairsTested++;
+            if (!sameObjectLocked(a, b, nowMs)) continue;
+            
+            auto rank = [](const Track* t) {
+                return (t->isEngaged() ? 2 : 0) + (t->classificationConfidence() >= 1.0 ? 1 : 0);
+            };
+            Track* target = rank(b) > rank(a) ? b : a;
+            Track* source = target == a ? b : a;
+            merged.append(MergedTrack{source->trackId(), source->handle(), target->trackId()});
+            mergeTrackLocked(source, target);
+            m_stats.autoMerges++;
+            if (source == a) break;
+        }
+    }
+}
+
+bool TrackManager::sameObjectLocked(Track* older, Track* newer, qint64 nowMs) {
+    const qint64 fromMs = nowMs - m_config.mergeWindowMs;
+    const LocalTangentPlane& frame = m_table.frame();
     
-    locker.unlock();
+    m_mergeSamples.clear();
+    older->visitPositionHistory([this, fromMs, &frame](const GeoPosition& pos, qint64 timestampMs) {
+        if (timestampMs >= fromMs) m_mergeSamples.append(MergeSample{timestampMs, frame.toEnu(pos)});
+    });
+    if (m_mergeSamples.size() < 2) return false;
+    
+    // One covariance for the window. Floored at the plot noise: history
+    // samples are filtered estimates, and sensor biases are in neither filter.
+    const double floorVar = m_config.kalmanMeasurementNoiseM * m_config.kalmanMeasurementNoiseM;
+    const PositionCovariance pa = positionCovarianceLocked(older->tableRow());
+    const PositionCovariance pb = positionCovarianceLocked(newer->tableRow());
+    const double see = qMax(pa.ee, floorVar) + qMax(pb.ee, floorVar);
+    const double snn = qMax(pa.nn, floorVar) + qMax(pb.nn, floorVar);
+    const double sen = pa.en + pb.en;
+    const double det = see * snn - sen * sen;
+    if (det <= 0.0) return false;
+    const double i11 = snn / det, i12 = -sen / det, i22 = see / det;
+    
+    // The older track interpolated at each of the newer one's samples
+    const QVector<MergeSample>& path = m_mergeSamples;
+    const qint64 firstMs = path.first().timestampMs;
+    const qint64 lastMs = path.last().timestampMs;
+    double sum = 0.0;
+    int samples = 0;
+    int k = 0;
+    newer->visitPositionHistory([&](const GeoPosition& pos, qint64 timestampMs) {
+        if (timestampMs < fromMs || timestampMs < firstMs || timestampMs > lastMs) return;
+        while (k + 2 < path.size() && path[k + 1].timestampMs < timestampMs) ++k;
+        const MergeSample& s0 = path[k];
+        const MergeSample& s1 = path[k + 1];
+        const qint64 spanMs = s1.timestampMs - s0.timestampMs;
+        const double f = spanMs > 0 ? double(timestampMs - s0.timestampMs) / spanMs : 0.0;
+        const EnuVector p = frame.toEnu(pos);
+        const double de = p.east - (s0.position.east + f * (s1.position.east - s0.position.east));
+        const double dn = p.north - (s0.position.north + f * (s1.position.north - s0.position.north));
+        sum += i11 * de * de + 2.0 * i12 * de * dn + i22 * dn * dn;
+        ++samples;
+    });
+    if (samples < m_config.mergeMinSamples) return false;
     
-    Logger::instance().info("TrackManager", 
-                           QString("Merged track %1 into %2").arg(sourceId, targetId));
-    emit trackDropped(sourceId);
+    // Wilson-Hilferty: chi-square on k dof is near k (1 - h + z sqrt(h))^3, h = 2 / 9k
+    const int dof = 2 * samples;
+    const double h = 2.0 / (9.0 * dof);
+    const double root = 1.0 - h + m_config.mergeGateZ * std::sqrt(h);
+    return sum <= dof * root * root * root;
 }
 
 void TrackManager::processRadarDetection(const GeoPosition& pos, const VelocityVector& vel,
                                          double quality, qint64 timestamp) {
-    Q_UNUSED(timestamp)
+    CUAS_TRACE_SCOPE("core", "TrackManager::processRadarDetection");
+    if (m_replayMode || m_mirrorMode) return;
     
-    Track* correlated = findCorrelatedTrack(pos, vel, DetectionSource::Radar);
+    SensorDetection det;
+    det.position = pos;
+    det.velocity = vel;
+    det.confidence = quality;
+    det.timestamp = timestamp;
+    det.sourceType = DetectionSource::Radar;
+    Track* correlated = findCorrelatedTrack<RadarFusionPolicy>(det);
     
     if (correlated) {
-        updateTrack(correlated->trackId(), pos);
+        updateTrack(correlated->trackId(), pos, timestamp);
         updateTrackVelocity(correlated->trackId(), vel);
         correlated->addDetectionSource(DetectionSource::Radar);
         correlated->setTrackQuality(qMax(correlated->trackQuality(), quality));
     } else {
-        QString newId = createTrack(pos, DetectionSource::Radar);
+        QString newId = initiateTrack(det);
         if (!newId.isEmpty()) {
             updateTrackVelocity(newId, vel);
         }
@@ -339,43 +867,85 @@ void TrackManager::processRadarDetection(const GeoPosition& pos, const VelocityV
 
 void TrackManager::processRFDetection(const GeoPosition& pos, double signalStrength,
                                       qint64 timestamp) {
-    Q_UNUSED(timestamp)
+    CUAS_TRACE_SCOPE("core", "TrackManager::processRFDetection");
+    if (m_replayMode || m_mirrorMode) return;
     
-    VelocityVector emptyVel;
-    Track* correlated = findCorrelatedTrack(pos, emptyVel, DetectionSource::RFDetector);
+    SensorDetection det;
+    det.position = pos;
+    det.signalStrength = signalStrength;
+    det.timestamp = timestamp;
+    det.sourceType = DetectionSource::RFDetector;
+    Track* correlated = findCorrelatedTrack<RFFusionPolicy>(det);
     
     if (correlated) {
-        updateTrack(correlated->trackId(), pos);
+        updateTrack(correlated->trackId(), pos, timestamp);
         correlated->addDetectionSource(DetectionSource::RFDetector);
         // RF detection increases confidence it's a drone
-        if (signalStrength > 0.7 && 
+        if (signalStrength > RFFusionPolicy::HOSTILE_SIGNAL && 
             correlated->classification() == TrackClassification::Pending) {
             setTrackClassification(correlated->trackId(), 
-                                   TrackClassification::Hostile, 0.6);
+                                   TrackClassification::Hostile, RFFusionPolicy::HOSTILE_CONFIDENCE);
         }
     } else {
-        createTrack(pos, DetectionSource::RFDetector);
+        initiateTrack(det);
     }
 }
 
 void TrackManager::processCameraDetection(const QString& cameraId, const BoundingBox& box,
                                           const GeoPosition& estimatedPos, qint64 timestamp) {
-    Q_UNUSED(timestamp)
-    
-    VelocityVector emptyVel;
-    Track* correlated = findCorrelatedTrack(estimatedPos, emptyVel, DetectionSource::Camera);
+    CUAS_TRACE_SCOPE("core", "TrackManager::processCameraDetection");
+    if (m_replayMode || m_mirrorMode) return;
+    
+    SensorDetection det;
+    det.position = estimatedPos;
+    det.sourceType = DetectionSource::Camera;
+    applyCameraDetection(findCorrelatedTrack<CameraFusionPolicy>(det),
+                         cameraId, box, estimatedPos, timestamp);
+}
+
+void TrackManager::processCameraDetection(const QVector<BoundingBox>& boxes,
+                                          const GeoPosition& estimatedPos, qint64 timestamp) {
+    CUAS_TRACE_SCOPE("core", "TrackManager::processCameraDetection");
+    if (m_replayMode || m_mirrorMode || boxes.isEmpty()) return;
+    
+    SensorDetection det;
+    det.position = estimatedPos;
+    det.sourceType = DetectionSource::Camera;
+    Track* correlated = findCorrelatedTrack<CameraFusionPolicy>(det);
+    int chosen = 0;
+    if (correlated) {
+        const QString following = correlated->associatedCameraId();
+        for (int i = 0; i < boxes.size(); ++i) {
+            if (boxes[i].cameraId == following) {
+                chosen = i;
+                break;
+            }
+        }
+    }
+    applyCameraDetection(correlated, boxes[chosen].cameraId, boxes[chosen], estimatedPos, timestamp);
+}
+
+void TrackManager::applyCameraDetection(Track* correlated, const QString& cameraId, const BoundingBox& box,
+                                        const GeoPosition& estimatedPos, qint64 timestamp) {
+    BoundingBox stamped = box;
+    if (stamped.timestamp == 0) stamped.timestamp = timestamp;
     
     if (correlated) {
-        correlated->setBoundingBox(box);
+        correlated->setBoundingBox(stamped);
         correlated->setAssociatedCameraId(cameraId);
         correlated->setVisuallyTracked(true);
         correlated->addDetectionSource(DetectionSource::Camera);
     } else {
-        QString newId = createTrack(estimatedPos, DetectionSource::Camera);
+        SensorDetection det;
+        det.sensorId = cameraId;
+        det.position = estimatedPos;
+        det.timestamp = timestamp;
+        det.sourceType = DetectionSource::Camera;
+        QString newId = initiateTrack(det);
         if (!newId.isEmpty()) {
             Track* t = track(newId);
             if (t) {
-                t->setBoundingBox(box);
+                t->setBoundingBox(stamped);
                 t->setAssociatedCameraId(cameraId);
                 t->setVisuallyTracked(true);
             }
@@ -383,203 +953,1595 @@ void TrackManager::processCameraDetection(const QString& cameraId, const Boundin
     }
 }
 
-void TrackManager::clearAllTracks() {
-    // First, collect all track IDs while holding the lock
-    QList<QString> trackIds;
-    {
-        QReadLocker locker(&m_lock);
-        trackIds = m_tracks.keys();
-    }
+void TrackManager::processDetectionBatch(const QVector<SensorDetection>& detections) {
+    CUAS_TRACE_SCOPE("core", "TrackManager::processDetectionBatch");
+    if (detections.isEmpty() || m_replayMode || m_mirrorMode) return;
     
-    // Emit trackDropped signals outside of write lock to allow connected slots
-    // to safely access track data before deletion
-    for (const QString& id : trackIds) {
-        emit trackDropped(id);
-    }
+    QVector<QPair<QString, TrackHandle>> created;
+    QStringList updated;
+    QVector<TrackHandle> updatedHandles;
+    QList<QPair<QString, TrackClassification>> reclassified;
+    int count = 0;
     
-    // Now acquire write lock and delete all tracks
     {
         QWriteLocker locker(&m_lock);
-        for (auto* t : m_tracks) {
-            delete t;
+        
+        // Gate every plot against the spatial index candidates, each with
+        // the kernel of its source's policy. Scoring only reads tracks, so
+        // under the write lock a big batch is split across the scheduler;
+        // each thread scores into its own scratch.
+        const qint64 nowMs = m_clock->nowMs();
+        QVector<QVector<QPair<Track*, double>>>& scored = m_batchScored;
+        scored.resize(detections.size());
+        QVector<QPair<Track*, double>>* scoredRows = scored.data();  // Detached once, before the threads
+        auto scoreRows = [this, &detections, scoredRows, nowMs](int first, int last) {
+            CorrelationScratch& scratch = correlationScratch();
+            for (int row = first; row < last; ++row) {
+                const SensorDetection& det = detections[row];
+                QVector<QPair<Track*, double>>& plot = scoredRows[row];
+                plot.clear();
+                visitFusionPolicy(det.sourceType, [&](auto policy) {
+                    scoreCandidatesLocked<decltype(policy)>(det, nowMs, scratch);
+                });
+                for (const CorrelationCandidate& candidate : scratch.scores) {
+                    if (candidate.score <= 0.5) continue;  // Same threshold as findCorrelatedTrack
+                    plot.append(qMakePair(scratch.tracks[candidate.index], 1.0 - candidate.score));
+                }
+            }
+        };
+        const int plots = detections.size();
+        const int chunkCount = m_config.parallelGatingMinPlots > 0 && plots >= m_config.parallelGatingMinPlots
+                                   ? qBound(1, plots / GATING_CHUNK_PLOTS, TaskScheduler::instance().workerCount())
+                                   : 1;
+        if (chunkCount > 1) {
+            TaskGraph graph(TaskPriority::Realtime);
+            for (int c = 1; c < chunkCount; ++c) {
+                const int first = static_cast<int>(qint64(plots) * c / chunkCount);
+                const int last = static_cast<int>(qint64(plots) * (c + 1) / chunkCount);
+                graph.add([&scoreRows, first, last]() { scoreRows(first, last); });
+            }
+            graph.run();
+            scoreRows(0, plots / chunkCount);
+            graph.wait();
+        } else {
+            scoreRows(0, plots);
         }
-        m_tracks.clear();
-        m_kalmanFilters.clear();
-    }
-    
-    emit trackCountChanged(0);
-}
-
-void TrackManager::pruneDroppedTracks() {
-    QWriteLocker locker(&m_lock);
-    
-    QList<QString> toRemove;
-    for (auto it = m_tracks.begin(); it != m_tracks.end(); ++it) {
-        if (it.value()->state() == TrackState::Dropped) {
-            toRemove.append(it.key());
+        
+        // Give each distinct track a column in the cost matrix, in plot
+        // order. The buffers are members, so a steady stream of scans keeps
+        // reusing them.
+        QVector<Track*>& columns = m_batchColumns;
+        QVector<QVector<QPair<int, double>>>& gated = m_batchGated;
+        columns.clear();
+        gated.resize(detections.size());
+        for (int row = m_columnOfRow.size(); row < m_table.capacity(); ++row) {
+            m_columnOfRow.append(-1);
         }
+        for (int row = 0; row < plots; ++row) {
+            QVector<QPair<int, double>>& plot = gated[row];
+            plot.clear();
+            for (const QPair<Track*, double>& candidate : scoredRows[row]) {
+                Track* t = candidate.first;
+                int& column = m_columnOfRow[t->tableRow()];
+                if (column < 0) {
+                    column = columns.size();
+                    columns.append(t);
+                }
+                plot.append(qMakePair(column, candidate.second));
+            }
+        }
+        for (Track* t : columns) {
+            m_columnOfRow[t->tableRow()] = -1;
+        }
+        
+        // Plots only compete inside their gating clusters, so solve those
+        // independently instead of one scan-sized matrix.
+        QVector<int> assignment(detections.size(), -1);
+        QVector<Track*> moved;
+        if (!columns.isEmpty() && m_config.associationMode == AssociationMode::Mht) {
+            associateMhtLocked(detections, nowMs, assignment, moved);
+        } else if (!columns.isEmpty()) {
+            assignment = AssignmentSolver::solveClustered(gated, columns.size());
+        }
+        
+        // A track can only be reported once per batch; new tracks are never
+        // columns, and each column is assigned at most one plot.
+        QSet<TrackHandle> reported;
+        
+        // Scans usually come from one sensor; look its telemetry up once
+        QString telemetryId;
+        std::shared_ptr<SensorTelemetry> telemetry;
+        
+        for (int row = 0; row < detections.size(); ++row) {
+            const SensorDetection& det = detections[row];
+            Track* t = assignment[row] >= 0 ? columns[assignment[row]] : nullptr;
+            
+            if (!t) {
+                t = initiateTrackLocked(det, nowMs);
+                if (!t) continue;  // Held for M-of-N confirmation, or at maxTracks
+                created.append(qMakePair(t->trackId(), t->handle()));
+            } else {
+                updateTrackLocked(t, det.position, measurementTime(det.timestamp, nowMs));
+                m_stats.correlationSuccessCount++;
+            }
+            
+            TrackClassification before = t->classification();
+            applyDetectionLocked(t, det);
+            if (det.ingestMonoNs > 0) {
+                const qint64 latencyUs = (TimeUtils::monotonicNs() - det.ingestMonoNs) / 1000;
+                m_stats.ingestToUpdate.record(latencyUs);
+                PipelineLatency::record(PipelineStage::Fusion, latencyUs);
+                // A plot stamped on this clock also dates the measurement against the read
+                qint64 receiveLagUs = -1;
+                if (det.timestamp > 0 && measurementTime(det.timestamp, nowMs) == det.timestamp) {
+                    receiveLagUs = qMax<qint64>(0, (nowMs - det.timestamp) * 1000 - latencyUs);
+                    PipelineLatency::record(PipelineStage::Receive, receiveLagUs);
+                }
+                t->setLastIngest(det.ingestMonoNs, receiveLagUs);
+                if (det.sensorId != telemetryId) {
+                    telemetryId = det.sensorId;
+                    telemetry = SensorTelemetry::find(telemetryId);
+                }
+                if (telemetry) {
+                    telemetry->recordDetectionLatencyUs(latencyUs);
+                }
+            }
+            if (t->classification() != before) {
+                reclassified.append(qMakePair(t->trackId(), t->classification()));
+            }
+            
+            if (!reported.contains(t->handle())) {
+                reported.insert(t->handle());
+                updated.append(t->trackId());
+                updatedHandles.append(t->handle());
+            }
+        }
+        for (Track* t : qAsConst(moved)) {
+            updated.append(t->trackId());
+            updatedHandles.append(t->handle());
+        }
+        
+        count = m_tracks.size();
     }
     
-    for (const QString& id : toRemove) {
-        delete m_tracks.take(id);
-        m_kalmanFilters.remove(id);
+    for (const auto& entry : created) {
+        CUAS_LOG_INFO("TrackManager", "Created track: " + entry.first);
+        emit trackCreated(entry.first);
+        emit trackHandleCreated(entry.second);
     }
-    
-    int newCount = m_tracks.size();
-    locker.unlock();
-    
-    if (!toRemove.isEmpty()) {
-        emit trackCountChanged(newCount);
+    if (!created.isEmpty()) {
+        emit trackCountChanged(count);
+    }
+    for (const auto& change : reclassified) {
+        emit trackClassificationChanged(change.first, change.second);
+    }
+    if (!updated.isEmpty()) {
+        emit tracksUpdated(updated);
+        emit trackHandlesUpdated(updatedHandles);
     }
 }
 
-void TrackManager::onSensorData(const GeoPosition& pos, const VelocityVector& vel,
-                                DetectionSource source, qint64 timestamp) {
-    switch (source) {
-        case DetectionSource::Radar:
-            processRadarDetection(pos, vel, 0.8, timestamp);
-            break;
-        case DetectionSource::RFDetector:
-            processRFDetection(pos, 0.5, timestamp);
-            break;
-        default:
-            break;
-    }
+void TrackManager::applyDetectionLocked(Track* t, const SensorDetection& detection) {
+    t->addDetectionSource(detection.sourceType);
+    visitFusionPolicy(detection.sourceType, [&](auto policy) {
+        decltype(policy)::apply(*t, m_features, detection);
+    });
 }
 
-void TrackManager::processTrackCycle() {
-    QWriteLocker locker(&m_lock);
-    
-    int coastingCount = 0;
-    QList<QString> toUpdate;
-    
-    for (auto* t : m_tracks) {
-        if (t->state() == TrackState::Dropped) continue;
-        
-        updateTrackState(t);
-        
-        if (t->state() == TrackState::Coasting) {
-            coastingCount++;
-        }
-        
-        toUpdate.append(t->trackId());
+void TrackManager::associateMhtLocked(const QVector<SensorDetection>& detections, qint64 nowMs,
+                                      QVector<int>& assignment, QVector<Track*>& moved) {
+    const QVector<Track*>& columns = m_batchColumns;
+    m_mhtPlots.resize(detections.size());
+    for (int row = 0; row < detections.size(); ++row) {
+        m_mhtPlots[row].position = toFilterFrameLocked(detections[row].position);
+        m_mhtPlots[row].timeMs = measurementTime(detections[row].timestamp, nowMs);
+    }
+    m_mhtTracks.resize(columns.size());
+    for (int column = 0; column < columns.size(); ++column) {
+        m_mhtTracks[column].handle = columns[column]->handle();
+        m_mhtTracks[column].kinematics = mhtKinematicsLocked(columns[column]);
     }
     
-    m_stats.currentCoastingCount = coastingCount;
-    m_stats.currentActiveCount = m_tracks.size() - coastingCount;
-    
-    locker.unlock();
-    
-    // Emit updates outside of lock
-    for (const QString& id : toUpdate) {
-        emit trackUpdated(id);
+    m_mht.associate(m_mhtPlots, m_mhtTracks, m_batchGated, m_mhtResult);
+    assignment = m_mhtResult.plotTrack;
+    for (int column = 0; column < columns.size(); ++column) {
+        const MhtDecision& decision = m_mhtResult.decisions[column];
+        if (!decision.revised) continue;
+        reviseTrackLocked(columns[column], decision.state);
+        if (decision.plot < 0) moved.append(columns[column]);
     }
+    m_stats.mhtClusters += m_mhtResult.clusters;
+    m_stats.mhtHypotheses += m_mhtResult.hypotheses;
+    m_stats.mhtRevisions += m_mhtResult.revisions;
+    m_stats.mhtBudgetFallbacks += m_mhtResult.fallbacks;
 }
 
-Track* TrackManager::findCorrelatedTrack(const GeoPosition& pos, const VelocityVector& vel,
-                                         DetectionSource source) {
-    QReadLocker locker(&m_lock);
-    
-    Track* bestMatch = nullptr;
-    double bestScore = 0.0;
-    
-    for (auto* t : m_tracks) {
-        if (t->state() == TrackState::Dropped) continue;
-        
-        double score = calculateCorrelationScore(t, pos, vel);
-        if (score > bestScore && score > 0.5) {  // Minimum correlation threshold
-            bestScore = score;
-            bestMatch = t;
+MhtKinematics TrackManager::mhtKinematicsLocked(const Track* track) const {
+    MhtKinematics k;
+    const int row = track->tableRow();
+    const bool imm = m_config.enableKalmanFilter && m_immBank.isActive(row);
+    if (!imm && !(m_config.enableKalmanFilter && m_filterBank.isActive(row))) {
+        // Unfiltered tracks sit on their last plot
+        const EnuVector p = m_table.frame().toEnu(track->position());
+        const VelocityVector v = track->velocity();
+        const double position[3] = {p.east, p.north, p.up};
+        const double velocity[3] = {v.east, v.north, -v.down};
+        for (int a = 0; a < 3; ++a) {
+            k.position[a] = position[a];
+            k.velocity[a] = velocity[a];
+            k.positionVariance[a] = m_config.kalmanMeasurementNoiseM * m_config.kalmanMeasurementNoiseM;
+            k.velocityVariance[a] = m_config.correlationVelocityMps * m_config.correlationVelocityMps;
         }
+        k.timeMs = m_clock->nowMs();
+        return k;
     }
     
-    return bestMatch;
+    // Filter state order is [e, ve, ae, n, vn, an, u, vu, au]
+    auto covariance = [&](int i, int j) {
+        return imm ? m_immBank.covariance(row, i, j) : m_filterBank.covariance(row, i, j);
+    };
+    const EnuVector p = imm ? m_immBank.position(row) : m_filterBank.position(row);
+    const EnuVector v = imm ? m_immBank.velocity(row) : m_filterBank.velocity(row);
+    const double position[3] = {p.east, p.north, p.up};
+    const double velocity[3] = {v.east, v.north, v.up};
+    for (int a = 0; a < 3; ++a) {
+        const int pi = a * 3;
+        k.position[a] = position[a];
+        k.velocity[a] = velocity[a];
+        k.positionVariance[a] = covariance(pi, pi);
+        k.crossCovariance[a] = covariance(pi, pi + 1);
+        k.velocityVariance[a] = covariance(pi + 1, pi + 1);
+    }
+    k.timeMs = imm ? m_immBank.timestampMs(row) : m_filterBank.timestampMs(row);
+    return k;
 }
 
-double TrackManager::calculateCorrelationScore(Track* track, const GeoPosition& pos,
-                                               const VelocityVector& vel) {
-    // Distance component
-    double distance = track->distanceTo(pos);
-    double distanceScore = 1.0;
-    if (distance > m_config.correlationDistanceM) {
-        distanceScore = 0.0;
-    } else {
-        distanceScore = 1.0 - (distance / m_config.correlationDistanceM);
-    }
-    
-    // Velocity component (if available)
-    double velocityScore = 1.0;
-    VelocityVector trackVel = track->velocity();
-    double velDiff = std::sqrt(
-        std::pow(trackVel.north - vel.north, 2) +
-        std::pow(trackVel.east - vel.east, 2) +
-        std::pow(trackVel.down - vel.down, 2)
-    );
-    if (velDiff > m_config.correlationVelocityMps) {
-        velocityScore = 0.5;  // Penalize but don't eliminate
+void TrackManager::reviseTrackLocked(Track* t, const MhtKinematics& state) {
+    // Position and velocity from the branch, uncorrelated with the rest;
+    // acceleration keeps its estimate
+    constexpr int DIM = KalmanFilterBank::STATE_DIM;
+    auto write = [&state](double* x, double* cov) {
+        for (int a = 0; a < 3; ++a) {
+            for (int i = a * 3; i < a * 3 + 2; ++i) {
+                for (int j = 0; j < DIM; ++j) {
+                    cov[i * DIM + j] = 0.0;
+                    cov[j * DIM + i] = 0.0;
+                }
+            }
+        }
+        for (int a = 0; a < 3; ++a) {
+            const int p = a * 3, v = p + 1;
+            x[p] = state.position[a];
+            x[v] = state.velocity[a];
+            cov[p * DIM + p] = state.positionVariance[a];
+            cov[p * DIM + v] = cov[v * DIM + p] = state.crossCovariance[a];
+            cov[v * DIM + v] = state.velocityVariance[a];
+        }
+    };
+    
+    const int row = t->tableRow();
+    EnuVector position, velocity;
+    if (m_config.enableKalmanFilter && m_immBank.isActive(row)) {
+        ImmFilterBank::SlotState slot = m_immBank.slotState(row);
+        for (int mode = 0; mode < ImmFilterBank::MODE_COUNT; ++mode) {
+            write(slot.state[mode], slot.cov[mode]);
+        }
+        slot.timestampMs = state.timeMs;
+        m_immBank.restoreSlot(row, slot);
+        position = m_immBank.position(row);
+        velocity = m_immBank.velocity(row);
+    } else if (m_config.enableKalmanFilter && m_filterBank.isActive(row)) {
+        KalmanFilterBank::SlotState slot = m_filterBank.slotState(row);
+        write(slot.state, slot.cov);
+        slot.timestampMs = state.timeMs;
+        m_filterBank.restoreSlot(row, slot);
+        position = m_filterBank.position(row);
+        velocity = m_filterBank.velocity(row);
     } else {
-        velocityScore = 1.0 - (velDiff / (2 * m_config.correlationVelocityMps));
+        return;  // Nothing to move: the next plot is the track
     }
     
-    // Time since update component (prefer recent tracks)
-    double timeScore = 1.0;
-    qint64 timeSince = track->timeSinceUpdate();
-    if (timeSince > m_config.coastingTimeoutMs) {
-        timeScore = 0.3;
-    } else {
-        timeScore = 1.0 - (static_cast<double>(timeSince) / m_config.coastingTimeoutMs * 0.5);
+    const GeoPosition filteredPos = fromFilterFrame(position);
+    t->setPosition(filteredPos);
+    m_spatialIndex.insert(t->handle(), filteredPos);
+    if (!t->hasSource(DetectionSource::Radar)) {
+        VelocityVector estimate;
+        estimate.north = velocity.north;
+        estimate.east = velocity.east;
+        estimate.down = -velocity.up;
+        t->setVelocity(estimate);
     }
-    
-    return distanceScore * 0.5 + velocityScore * 0.3 + timeScore * 0.2;
 }
 
-void TrackManager::updateTrackState(Track* track) {
-    qint64 timeSinceUpdate = track->timeSinceUpdate();
+void TrackManager::setReplayMode(bool replay) {
+    if (runOnOwnerThread([this, replay]() { setReplayMode(replay); })) return;
+    if (m_replayMode == replay) return;
     
-    if (track->state() == TrackState::Active) {
-        if (timeSinceUpdate > m_config.coastingTimeoutMs) {
+    // Set first, so no detection lands between the clear and the switch
+    m_replayMode = replay;
+    clearAllTracks();
+    {
+        QWriteLocker locker(&m_lock);
+        m_replayTimeMs = 0;
+    }
+    
+    Logger::instance().info("TrackManager", replay ? "Replay mode" : "Live mode");
+    emit replayModeChanged(replay);
+}
+
+void TrackManager::applyReplaySamples(const QVector<TrackHistorySample>& samples, qint64 replayTimeMs) {
+    if (runOnOwnerThread([this, samples, replayTimeMs]() { applyReplaySamples(samples, replayTimeMs); })) return;
+    if (!m_replayMode) return;
+    
+    QVector<QPair<QString, TrackHandle>> created;
+    int count = 0;
+    {
+        QWriteLocker locker(&m_lock);
+        m_replayTimeMs = replayTimeMs;
+        
+        for (const TrackHistorySample& sample : samples) {
+            Track* t = m_tracks.value(sample.trackId, nullptr);
+            if (!t) {
+                if (m_tracks.size() >= m_config.maxTracks) continue;
+                const TrackHandle handle = allocateHandle();
+                t = addTrackLocked(sample.trackId, handle, sample.position);
+                t->setClassification(TrackClassification::Pending);
+                created.append(qMakePair(sample.trackId, handle));
+                m_stats.totalTracksCreated++;
+            } else {
+                // Recorded positions are already filtered; velocity is
+                // their rate of change
+                const int row = t->tableRow();
+                const qint64 dtMs = sample.timestamp - m_table.lastUpdateMs(row);
+                if (dtMs > 0 && t->state() != TrackState::Dropped) {
+                    const EnuVector from = toFilterFrameLocked(t->position());
+                    const EnuVector to = toFilterFrameLocked(sample.position);
+                    VelocityVector vel;
+                    vel.north = (to.north - from.north) * 1000.0 / dtMs;
+                    vel.east = (to.east - from.east) * 1000.0 / dtMs;
+                    vel.down = -(to.up - from.up) * 1000.0 / dtMs;
+                    t->setVelocity(vel);
+                }
+                t->setPosition(sample.position);
+            }
+            
+            m_spatialIndex.insert(t->handle(), sample.position);
+            t->addPositionHistory(sample.position, sample.timestamp);
+            t->resetCoastCount();
+            if (t->state() != TrackState::Active) {
+                t->setState(TrackState::Active);
+            }
+            // Lifecycle ages the track from its recorded time
+            m_table.setLastUpdateMs(t->tableRow(), sample.timestamp);
+        }
+        m_stats.lastUpdateTimeMs = replayTimeMs;
+        count = m_tracks.size();
+    }
+    
+    for (const auto& entry : created) {
+        emit trackCreated(entry.first);
+        emit trackHandleCreated(entry.second);
+    }
+    if (!created.isEmpty()) {
+        emit trackCountChanged(count);
+    }
+}
+
+void TrackManager::setMirrorMode(bool mirror) {
+    if (runOnOwnerThread([this, mirror]() { setMirrorMode(mirror); })) return;
+    if (m_mirrorMode == mirror) return;
+    
+    // Set first, so no detection lands between the clear and the switch
+    m_mirrorMode = mirror;
+    clearAllTracks();
+    {
+        QWriteLocker locker(&m_lock);
+        m_replayTimeMs = 0;
+        m_mirrorCovariance.clear();
+    }
+    
+    Logger::instance().info("TrackManager", mirror ? "Mirror mode" : "Live mode");
+    emit mirrorModeChanged(mirror);
+}
+
+void TrackManager::applyMirrorPicture(const TrackPicturePtr& picture) {
+    if (!picture) return;
+    if (runOnOwnerThread([this, picture]() { applyMirrorPicture(picture); })) return;
+    if (!m_mirrorMode) return;
+    
+    MirrorEvents events;
+    int count = 0;
+    {
+        QWriteLocker locker(&m_lock);
+        m_replayTimeMs = picture->timestampMs;
+        for (const TrackSnapshot& track : picture->tracks) {
+            mirrorTrackLocked(track, events);
+        }
+    
+        // What the picture no longer has, its manager dropped
+        QVector<Track*> gone;
+        for (Track* t : m_slab.live()) {
+            if (!picture->find(t->trackId())) gone.append(t);
+        }
+        for (Track* t : qAsConst(gone)) {
+            dropMirrorTrackLocked(t, events);
+        }
+        m_stats.lastUpdateTimeMs = picture->timestampMs;
+        count = m_tracks.size();
+    }
+    emitMirrorEvents(events, count);
+}
+
+void TrackManager::applyMirrorTracks(const QVector<TrackSnapshot>& updated, const QStringList& dropped,
+                                     qint64 timeMs) {
+    if (runOnOwnerThread([this, updated, dropped, timeMs]() { applyMirrorTracks(updated, dropped, timeMs); })) return;
+    if (!m_mirrorMode) return;
+    
+    MirrorEvents events;
+    int count = 0;
+    {
+        QWriteLocker locker(&m_lock);
+        m_replayTimeMs = timeMs;
+        for (const QString& trackId : dropped) {
+            if (Track* t = m_tracks.value(trackId, nullptr)) dropMirrorTrackLocked(t, events);
+        }
+        for (const TrackSnapshot& track : updated) {
+            mirrorTrackLocked(track, events);
+        }
+        m_stats.lastUpdateTimeMs = timeMs;
+        count = m_tracks.size();
+    }
+    emitMirrorEvents(events, count);
+}
+
+void TrackManager::mirrorTrackLocked(const TrackSnapshot& state, MirrorEvents& events) {
+    Track* t = m_tracks.value(state.trackId, nullptr);
+    const bool created = !t;
+    if (created) {
+        if (m_tracks.size() >= m_config.maxTracks) return;
+        const TrackHandle handle = allocateHandle();
+        t = addTrackLocked(state.trackId, handle, state.position);
+        events.created.append(qMakePair(state.trackId, handle));
+        m_stats.totalTracksCreated++;
+    }
+    
+    // A whole picture repeats every track; only what moved is marked
+    // changed, so tracksChanged stays a delta. The setters stamp the wall
+    // clock, so the picture's time is put back after them.
+    const int row = t->tableRow();
+    const qint64 updatedMs = state.lastUpdateMs > 0 ? state.lastUpdateMs : m_replayTimeMs;
+    const qint64 previousMs = created ? 0 : t->lastUpdateMs();
+    if (updatedMs > previousMs) {
+        if (!created) {
+            t->setPosition(state.position);
+            m_spatialIndex.insert(t->handle(), state.position);
+        }
+        t->setVelocity(state.velocity);
+        t->addPositionHistory(state.position, updatedMs);
+        events.updatedIds.append(state.trackId);
+        events.updatedHandles.append(t->handle());
+    }
+    
+    if (t->classification() != state.classification) {
+        t->setClassification(state.classification);
+        events.classified.append(qMakePair(state.trackId, state.classification));
+    }
+    if (!qFuzzyCompare(t->classificationConfidence() + 1.0, state.classificationConfidence + 1.0)) {
+        t->setClassificationConfidence(state.classificationConfidence);
+    }
+    const int oldLevel = t->threatLevel();
+    if (oldLevel != state.threatLevel) {
+        t->setThreatLevel(state.threatLevel);
+        events.threatChanged.append(qMakePair(state.trackId, state.threatLevel));
+        if (state.threatLevel >= 4 && state.threatLevel > oldLevel) {
+            events.threatRaised.append(qMakePair(state.trackId, state.threatLevel));
+        }
+    }
+    if (!qFuzzyCompare(t->trackQuality() + 1.0, state.trackQuality + 1.0)) {
+        t->setTrackQuality(state.trackQuality);
+    }
+    if (t->isVisuallyTracked() != state.visuallyTracked) t->setVisuallyTracked(state.visuallyTracked);
+    if (t->associatedCameraId() != state.associatedCameraId) t->setAssociatedCameraId(state.associatedCameraId);
+    if (t->isEngaged() != state.engaged) t->setEngaged(state.engaged);
+    if (state.hasRFDetection) t->addDetectionSource(DetectionSource::RFDetector);
+    t->setLastIngest(state.ingestMonoNs, state.receiveLagUs);
+    if (t->state() != state.state) {
+        t->setState(state.state);
+        events.stateChanged.append(qMakePair(state.trackId, state.state));
+    }
+    t->restoreTimes(created ? updatedMs : t->createdMs(), qMax(previousMs, updatedMs));
+    
+    if (row >= m_mirrorCovariance.size()) m_mirrorCovariance.resize(row + 1);
+    m_mirrorCovariance[row] = state.covariance;
+    updateHostileQueueLocked(t);
+}
+
+void TrackManager::dropMirrorTrackLocked(Track* track, MirrorEvents& events) {
+    const TrackHandle handle = track->handle();
+    events.dropped.append(qMakePair(track->trackId(), handle));
+    m_tracks.remove(track->trackId());
+    m_tracksByHandle.remove(handle);
+    m_spatialIndex.remove(handle);
+    m_hostileQueue.remove(handle);
+    m_stats.totalTracksDropped++;
+    releaseTrackLocked(track);
+}
+
+void TrackManager::emitMirrorEvents(const MirrorEvents& events, int count) {
+    for (const auto& entry : events.created) {
+        emit trackCreated(entry.first);
+        emit trackHandleCreated(entry.second);
+    }
+    for (const auto& entry : events.classified) {
+        emit trackClassificationChanged(entry.first, entry.second);
+    }
+    for (const auto& entry : events.threatChanged) {
+        emit trackThreatLevelChanged(entry.first, entry.second);
+    }
+    for (const auto& entry : events.threatRaised) {
+        emit highThreatDetected(entry.first, entry.second);
+    }
+    for (const auto& entry : events.stateChanged) {
+        emit trackStateChanged(entry.first, entry.second);
+    }
+    if (!events.updatedIds.isEmpty()) {
+        emit tracksUpdated(events.updatedIds);
+        emit trackHandlesUpdated(events.updatedHandles);
+    }
+    for (const auto& entry : events.dropped) {
+        emit trackStateChanged(entry.first, TrackState::Dropped);
+        emit trackDropped(entry.first);
+        emit trackHandleDropped(entry.second);
+    }
+    if (!events.created.isEmpty() || !events.dropped.isEmpty()) {
+        emit trackCountChanged(count);
+    }
+}
+
+void TrackManager::clearAllTracks() {
+    if (runOnOwnerThread([this]() { clearAllTracks(); })) return;
+    
+    // First, collect all track IDs while holding the lock
+    QList<QPair<QString, TrackHandle>> dropped;
+    {
+        QReadLocker locker(&m_lock);
+        for (Track* t : m_slab.live()) {
+            dropped.append(qMakePair(t->trackId(), t->handle()));
+        }
+    }
+    
+    // Emit trackDropped signals outside of write lock to allow connected slots
+    // to safely access track data before it is recycled
+    for (const auto& entry : dropped) {
+        emit trackDropped(entry.first);
+        emit trackHandleDropped(entry.second);
+    }
+    
+    // Now acquire write lock and recycle all tracks
+    quint64 sequence = 0;
+    {
+        QWriteLocker locker(&m_lock);
+        m_slab.clear();
+        m_tracks.clear();
+        m_tracksByHandle.clear();
+        m_table.clear();
+        m_rowTracks.clear();
+        m_releasedChanges.clear();
+        m_filterBank.clear();
+        m_immBank.clear();
+        m_features.clear();
+        m_mht.clear();
+        m_hasFilterOrigin = false;
+        m_spatialIndex.clear();
+        m_groups.clear();
+        m_hostileQueue.clear();
+        m_tentatives.clear();
+        sequence = publishSnapshotLocked();
+    }
+    
+    emit trackCountChanged(0);
+    emit snapshotPublished(sequence);
+}
+
+void TrackManager::pruneDroppedTracks() {
+    if (runOnOwnerThread([this]() { pruneDroppedTracks(); })) return;
+    
+    QWriteLocker locker(&m_lock);
+    
+    QList<Track*> toRemove;
+    for (Track* t : m_slab.live()) {
+        if (t->state() == TrackState::Dropped) {
+            toRemove.append(t);
+        }
+    }
+    
+    for (Track* t : toRemove) {
+        m_tracks.remove(t->trackId());
+        m_tracksByHandle.remove(t->handle());
+        m_spatialIndex.remove(t->handle());
+        m_groups.remove(t->handle());
+        m_hostileQueue.remove(t->handle());
+        releaseTrackLocked(t);
+    }
+    
+    int newCount = m_tracks.size();
+    locker.unlock();
+    
+    if (!toRemove.isEmpty()) {
+        emit trackCountChanged(newCount);
+    }
+}
+
+void TrackManager::setHandleSequence(TrackHandle first, int stride) {
+    QWriteLocker locker(&m_lock);
+    m_nextTrackNumber = static_cast<int>(qMax<TrackHandle>(1, first));
+    m_handleStride = qMax(1, stride);
+}
+
+bool TrackManager::extractTrack(TrackHandle handle, TrackSnapshot* state) {
+    bool extracted = false;
+    if (runOnOwnerThread([&]() { extracted = extractTrack(handle, state); })) return extracted;
+    
+    QString trackId;
+    int count = 0;
+    {
+        QWriteLocker locker(&m_lock);
+        Track* t = m_tracksByHandle.value(handle, nullptr);
+        if (!t || t->state() == TrackState::Dropped) return false;
+        
+        if (state) *state = TrackSnapshot::fromTrack(*t);
+        trackId = t->trackId();
+        m_tracks.remove(trackId);
+        m_tracksByHandle.remove(handle);
+        m_spatialIndex.remove(handle);
+        m_groups.remove(handle);
+        m_hostileQueue.remove(handle);
+        releaseTrackLocked(t);
+        
+        count = m_tracks.size();
+    }
+    
+    emit trackDropped(trackId);
+    emit trackHandleDropped(handle);
+    emit trackCountChanged(count);
+    return true;
+}
+
+bool TrackManager::adoptTrack(const TrackSnapshot& state) {
+    bool adopted = false;
+    if (runOnOwnerThread([&]() { adopted = adoptTrack(state); })) return adopted;
+    
+    int count = 0;
+    {
+        QWriteLocker locker(&m_lock);
+        if (state.handle == INVALID_TRACK_HANDLE || m_tracks.size() >= m_config.maxTracks ||
+            m_tracks.contains(state.trackId) || m_tracksByHandle.contains(state.handle)) {
+            return false;
+        }
+        
+        Track* t = addTrackLocked(state.trackId, state.handle, state.position);
+        t->setVelocity(state.velocity);
+        t->setClassification(state.classification);
+        t->setClassificationConfidence(state.classificationConfidence);
+        t->setThreatLevel(state.threatLevel);
+        t->setTrackQuality(state.trackQuality);
+        t->setVisuallyTracked(state.visuallyTracked);
+        t->setEngaged(state.engaged);
+        t->setAssociatedCameraId(state.associatedCameraId);
+        if (state.hasRFDetection) {
+            t->addDetectionSource(DetectionSource::RFDetector);
+        }
+        t->setLastIngest(state.ingestMonoNs, state.receiveLagUs);
+        t->setState(state.state);
+        
+        // Lifecycle carries on from the last update the old owner fused
+        const int row = t->tableRow();
+        m_table.setLastUpdateMs(row, state.lastUpdateMs);
+        if (m_config.enableKalmanFilter && m_config.enableImmFilter) {
+            m_immBank.initialize(row, toFilterFrameLocked(state.position), state.lastUpdateMs);
+        } else if (m_config.enableKalmanFilter) {
+            m_filterBank.initialize(row, toFilterFrameLocked(state.position), state.lastUpdateMs,
+                                    m_config.kalmanMotionModel);
+        }
+        updateHostileQueueLocked(t);
+        
+        count = m_tracks.size();
+    }
+    
+    emit trackCreated(state.trackId);
+    emit trackHandleCreated(state.handle);
+    emit trackCountChanged(count);
+    return true;
+}
+
+namespace {
+
+constexpr quint8 CHECKPOINT_TRACK_VERSION = 1;
+constexpr quint8 CHECKPOINT_STATE_VERSION = 1;
+
+enum CheckpointFilter : quint8 {
+    CheckpointNoFilter = 0,
+    CheckpointKalman,
+    CheckpointImm
+};
+
+void setupCheckpointStream(QDataStream& stream) {
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+}
+
+void writePosition(QDataStream& out, const GeoPosition& pos) {
+    out << pos.latitude << pos.longitude << pos.altitude;
+}
+
+GeoPosition readPosition(QDataStream& in) {
+    GeoPosition pos;
+    in >> pos.latitude >> pos.longitude >> pos.altitude;
+    return pos;
+}
+
+template <typename T>
+void writeRaw(QDataStream& out, const T& value) {
+    out << quint32(sizeof(T));
+    out.writeRawData(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readRaw(QDataStream& in, T& value) {
+    quint32 size = 0;
+    in >> size;
+    if (size != sizeof(T)) return false;
+    return in.readRawData(reinterpret_cast<char*>(&value), sizeof(T)) == int(sizeof(T));
+}
+
+} // namespace
+
+void TrackManager::checkpointTracks(const QVector<TrackHandle>* handles,
+                                    QVector<QPair<TrackHandle, QByteArray>>& out) const {
+    QReadLocker locker(&m_lock);
+    out.clear();
+    if (!handles) {
+        out.reserve(m_tracksByHandle.size());
+        for (auto it = m_tracksByHandle.constBegin(); it != m_tracksByHandle.constEnd(); ++it) {
+            if (it.value()->state() == TrackState::Dropped) continue;
+            out.append(qMakePair(it.key(), encodeTrackLocked(it.value())));
+        }
+        return;
+    }
+    
+    out.reserve(handles->size());
+    for (TrackHandle handle : *handles) {
+        const Track* t = m_tracksByHandle.value(handle, nullptr);
+        const bool live = t && t->state() != TrackState::Dropped;
+        out.append(qMakePair(handle, live ? encodeTrackLocked(t) : QByteArray()));
+    }
+}
+
+QByteArray TrackManager::encodeTrackLocked(const Track* t) const {
+    QByteArray data;
+    data.reserve(1024);
+    QDataStream out(&data, QIODevice::WriteOnly);
+    setupCheckpointStream(out);
+    
+    const int row = t->tableRow();
+    out << CHECKPOINT_TRACK_VERSION << t->trackId() << quint32(t->handle());
+    writePosition(out, t->position());
+    const VelocityVector vel = t->velocity();
+    out << vel.north << vel.east << vel.down;
+    out << quint8(t->classification()) << t->classificationConfidence()
+        << quint8(t->state()) << qint32(t->threatLevel());
+    
+    const QList<DetectionSource> sources = t->detectionSources();
+    out << quint8(sources.size());
+    for (DetectionSource source : sources) {
+        out << quint8(source);
+    }
+    // The table holds the lifecycle's update time (adoptTrack may set it alone)
+    out << t->createdMs() << m_table.lastUpdateMs(row);
+    out << t->associatedCameraId() << t->isVisuallyTracked();
+    const BoundingBox box = t->boundingBox();
+    out << qint32(box.x) << qint32(box.y) << qint32(box.width) << qint32(box.height)
+        << box.cameraId << box.timestamp;
+    out << t->isEngaged() << t->trackQuality() << qint32(t->coastCount());
+    const MotionModeProbabilities modes = t->modeProbabilities();
+    out << modes.constantVelocity << modes.constantAcceleration << modes.coordinatedTurn;
+    
+    out << quint32(t->historyCapacity());
+    QVector<QPair<GeoPosition, qint64>> history;
+    t->visitPositionHistory([&history](const GeoPosition& pos, qint64 timestamp) {
+        history.append(qMakePair(pos, timestamp));
+    });
+    out << quint32(history.size());
+    for (const auto& sample : history) {
+        writePosition(out, sample.first);
+        out << sample.second;
+    }
+    
+    if (m_immBank.isActive(row)) {
+        out << quint8(CheckpointImm);
+        writeRaw(out, m_immBank.slotState(row));
+    } else if (m_filterBank.isActive(row)) {
+        out << quint8(CheckpointKalman);
+        writeRaw(out, m_filterBank.slotState(row));
+    } else {
+        out << quint8(CheckpointNoFilter);
+    }
+    return data;
+}
+
+QByteArray TrackManager::checkpointState() const {
+    QReadLocker locker(&m_lock);
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    setupCheckpointStream(out);
+    
+    out << CHECKPOINT_STATE_VERSION << qint32(m_nextTrackNumber) << qint32(m_handleStride);
+    out << m_hasFilterOrigin;
+    writePosition(out, m_table.frame().origin());
+    
+    const QVector<TentativeTrack>& tentatives = m_tentatives.tentatives();
+    out << quint32(tentatives.size());
+    for (const TentativeTrack& t : tentatives) {
+        out << t.id;
+        writePosition(out, t.position);
+        out << t.velocity.north << t.velocity.east << t.velocity.down;
+        out << t.sourceMask << t.quality << t.firstMs << t.lastHitMs << t.hitSlots << qint32(t.hits);
+    }
+    return data;
+}
+
+Track* TrackManager::decodeTrackLocked(const QByteArray& data, qint64 nowMs) {
+    QDataStream in(data);
+    setupCheckpointStream(in);
+    
+    quint8 version = 0;
+    QString trackId;
+    quint32 handle = 0;
+    in >> version >> trackId >> handle;
+    if (version != CHECKPOINT_TRACK_VERSION || handle == INVALID_TRACK_HANDLE) return nullptr;
+    
+    const GeoPosition position = readPosition(in);
+    VelocityVector vel;
+    in >> vel.north >> vel.east >> vel.down;
+    quint8 cls = 0, state = 0, sourceCount = 0;
+    double confidence = 0.0;
+    qint32 threat = 1;
+    in >> cls >> confidence >> state >> threat >> sourceCount;
+    QVector<DetectionSource> sources;
+    for (int i = 0; i < sourceCount; ++i) {
+        quint8 source = 0;
+        in >> source;
+        sources.append(static_cast<DetectionSource>(source));
+    }
+    qint64 createdMs = 0, lastUpdateMs = 0;
+    QString cameraId;
+    bool visual = false;
+    in >> createdMs >> lastUpdateMs >> cameraId >> visual;
+    BoundingBox box;
+    qint32 bx = 0, by = 0, bw = 0, bh = 0;
+    in >> bx >> by >> bw >> bh >> box.cameraId >> box.timestamp;
+    box.x = bx;
+    box.y = by;
+    box.width = bw;
+    box.height = bh;
+    bool engaged = false;
+    double quality = 1.0;
+    qint32 coastCount = 0;
+    MotionModeProbabilities modes;
+    in >> engaged >> quality >> coastCount;
+    in >> modes.constantVelocity >> modes.constantAcceleration >> modes.coordinatedTurn;
+    
+    quint32 historyCapacity = 0, historySize = 0;
+    in >> historyCapacity >> historySize;
+    if (in.status() != QDataStream::Ok || historySize > historyCapacity) return nullptr;
+    QVector<QPair<GeoPosition, qint64>> history;
+    history.reserve(static_cast<int>(qMin<quint32>(historySize, 100000)));
+    for (quint32 i = 0; i < historySize && in.status() == QDataStream::Ok; ++i) {
+        const GeoPosition pos = readPosition(in);
+        qint64 timestamp = 0;
+        in >> timestamp;
+        history.append(qMakePair(pos, timestamp));
+    }
+    
+    quint8 filter = CheckpointNoFilter;
+    in >> filter;
+    KalmanFilterBank::SlotState kalman;
+    ImmFilterBank::SlotState imm;
+    if ((filter == CheckpointKalman && !readRaw(in, kalman)) ||
+        (filter == CheckpointImm && !readRaw(in, imm)) || in.status() != QDataStream::Ok) {
+        return nullptr;
+    }
+    
+    // Too old to coast any longer: the track would drop on the first cycle
+    const qint64 ageMs = nowMs - lastUpdateMs;
+    if (ageMs > m_config.dropTimeoutMs || static_cast<TrackState>(state) == TrackState::Dropped) {
+        return nullptr;
+    }
+    if (m_tracks.size() >= m_config.maxTracks || m_tracks.contains(trackId) ||
+        m_tracksByHandle.contains(handle)) {
+        return nullptr;
+    }
+    
+    Track* t = addTrackLocked(trackId, handle, position);
+    t->setVelocity(vel);
+    t->setClassification(static_cast<TrackClassification>(cls));
+    t->setClassificationConfidence(confidence);
+    t->setThreatLevel(threat);
+    for (DetectionSource source : sources) {
+        t->addDetectionSource(source);
+    }
+    t->setAssociatedCameraId(cameraId);
+    t->setVisuallyTracked(visual);
+    t->setBoundingBox(box);
+    t->setEngaged(engaged);
+    t->setTrackQuality(quality);
+    t->setModeProbabilities(modes);
+    for (int i = 0; i < coastCount; ++i) {
+        t->incrementCoastCount();
+    }
+    for (const auto& sample : history) {
+        t->addPositionHistory(sample.first, sample.second);
+    }
+    TrackState restoredState = static_cast<TrackState>(state);
+    if (restoredState == TrackState::Active && ageMs > m_config.coastingTimeoutMs) {
+        restoredState = TrackState::Coasting;
+    }
+    t->setState(restoredState);
+    t->restoreTimes(createdMs, lastUpdateMs);
+    
+    // A filter of the configured kind resumes; otherwise start one at the
+    // last position, as adoptTrack() does
+    const int row = t->tableRow();
+    if (m_config.enableKalmanFilter && m_config.enableImmFilter) {
+        if (filter == CheckpointImm) {
+            m_immBank.restoreSlot(row, imm);
+        } else {
+            m_immBank.initialize(row, toFilterFrameLocked(position), lastUpdateMs);
+        }
+    } else if (m_config.enableKalmanFilter) {
+        if (filter == CheckpointKalman && kalman.model == m_config.kalmanMotionModel) {
+            m_filterBank.restoreSlot(row, kalman);
+        } else {
+            m_filterBank.initialize(row, toFilterFrameLocked(position), lastUpdateMs,
+                                    m_config.kalmanMotionModel);
+        }
+    }
+    updateHostileQueueLocked(t);
+    return t;
+}
+
+int TrackManager::restoreCheckpoint(const QByteArray& state, const QVector<QByteArray>& tracks) {
+    int restored = -1;
+    if (runOnOwnerThread([&]() { restored = restoreCheckpoint(state, tracks); })) return restored;
+    
+    QVector<QPair<QString, TrackHandle>> created;
+    int count = 0;
+    quint64 sequence = 0;
+    {
+        QWriteLocker locker(&m_lock);
+        if (!m_tracks.isEmpty()) return -1;
+        
+        QDataStream in(state);
+        setupCheckpointStream(in);
+        quint8 version = 0;
+        qint32 nextTrackNumber = 1, stride = 1;
+        bool hasOrigin = false;
+        in >> version >> nextTrackNumber >> stride >> hasOrigin;
+        const GeoPosition origin = readPosition(in);
+        quint32 tentativeCount = 0;
+        in >> tentativeCount;
+        if (version != CHECKPOINT_STATE_VERSION || in.status() != QDataStream::Ok) return -1;
+        
+        QVector<TentativeTrack> tentatives;
+        for (quint32 i = 0; i < tentativeCount && in.status() == QDataStream::Ok; ++i) {
+            TentativeTrack t;
+            qint32 hits = 0;
+            in >> t.id;
+            t.position = readPosition(in);
+            in >> t.velocity.north >> t.velocity.east >> t.velocity.down;
+            in >> t.sourceMask >> t.quality >> t.firstMs >> t.lastHitMs >> t.hitSlots >> hits;
+            t.hits = hits;
+            tentatives.append(t);
+        }
+        if (in.status() != QDataStream::Ok) return -1;
+        
+        // Saved filter states are in the saved frame
+        m_nextTrackNumber = qMax(m_nextTrackNumber, static_cast<int>(nextTrackNumber));
+        m_handleStride = qMax(1, static_cast<int>(stride));
+        if (hasOrigin) {
+            m_table.setFrameOrigin(origin);
+            m_hasFilterOrigin = true;
+        }
+        
+        const qint64 nowMs = m_clock->nowMs();
+        m_tentatives.restore(tentatives);
+        m_tentatives.expire(nowMs);
+        
+        for (const QByteArray& data : tracks) {
+            if (Track* t = decodeTrackLocked(data, nowMs)) {
+                created.append(qMakePair(t->trackId(), t->handle()));
+            }
+        }
+        
+        count = m_tracks.size();
+        m_stats.currentTentativeCount = m_tentatives.size();
+        sequence = publishSnapshotLocked();
+        restored = created.size();
+    }
+    
+    for (const auto& track : created) {
+        emit trackCreated(track.first);
+        emit trackHandleCreated(track.second);
+    }
+    emit trackCountChanged(count);
+    emit snapshotPublished(sequence);
+    return restored;
+}
+
+void TrackManager::onSensorData(const GeoPosition& pos, const VelocityVector& vel,
+                                DetectionSource source, qint64 timestamp) {
+    switch (source) {
+        case DetectionSource::Radar:
+            processRadarDetection(pos, vel, RadarFusionPolicy::DEFAULT_QUALITY, timestamp);
+            break;
+        case DetectionSource::RFDetector:
+            processRFDetection(pos, RFFusionPolicy::DEFAULT_SIGNAL, timestamp);
+            break;
+        default:
+            break;
+    }
+}
+
+void TrackManager::processTrackCycle() {
+    CUAS_TRACE_SCOPE("core", "TrackManager::processTrackCycle");
+    const qint64 cycleStartNs = TimeUtils::monotonicNs();
+    QWriteLocker locker(&m_lock);
+    
+    // A mirror runs on its picture's clock, as a replay does on its own
+    const bool replay = m_replayMode || m_mirrorMode;
+    const qint64 nowMs = replay ? m_replayTimeMs : m_clock->nowMs();
+    
+    // Tiered, the cycle runs at the priority rate and only some cycles
+    // do the routine work, so coasting still counts updateRateHz cycles
+    const bool tiered = m_config.tieredRates && !replay;
+    bool routine = true;
+    if (tiered) {
+        const int routineMs = 1000 / qMax(1, m_config.updateRateHz);
+        routine = nowMs + cycleIntervalMs() / 2 >= m_nextRoutineMs;
+        if (routine) {
+            m_nextRoutineMs += routineMs;
+            if (m_nextRoutineMs <= nowMs) m_nextRoutineMs = nowMs + routineMs;
+        }
+    }
+    
+    QVector<MergedTrack> merged;
+    if (routine) {
+        // Coast every filter forward to the cycle time in one pass. Replayed
+        // tracks have no filters and age on the replay clock.
+        if (!replay) {
+            if (m_config.enableKalmanFilter) {
+                m_filterBank.predictAll(nowMs);
+                m_immBank.predictAll(nowMs);
+            }
+            m_tentatives.expire(nowMs);
+        }
+        
+        // Decide every transition from the table columns first, then touch only
+        // the Track objects whose state actually changes. Mirrored tracks
+        // change state with the picture they copy.
+        m_transitions.clear();
+        if (!m_mirrorMode) {
+            m_table.lifecyclePass(nowMs,
+                                  m_config.coastingTimeoutMs,
+                                  m_config.dropTimeoutMs,
+                                  m_config.maxCoastCount,
+                                  m_transitions);
+        }
+        for (const LifecycleTransition& transition : m_transitions) {
+            applyLifecycleTransition(transition);
+        }
+        
+        // Duplicates left by plots that missed their track's gate. Replayed
+        // tracks were resolved when recorded.
+        if (!replay && m_config.autoMerge) {
+            mergeDuplicatesLocked(nowMs, merged);
+        }
+    }
+    
+    // Swarm groups around whatever moved, before the moves are reported;
+    // tiered, that is every cycle, since a priority track's dirty fields
+    // are taken every cycle
+    if (!replay && m_config.groupTracks) {
+        updateGroupsLocked(nowMs);
+    }
+    
+    // Only tracks with dirty fields are reported, once per cycle however
+    // many detections or setter calls touched them. Tiered, a track not
+    // due yet keeps its fields for a later cycle.
+    TrackChangeSet changes = std::move(m_releasedChanges);
+    m_releasedChanges.clear();
+    const int rows = m_rowTracks.size();
+    if (tiered) m_refreshRows.fill(0, rows);
+    for (int row = 0; row < rows; ++row) {
+        if (!m_table.isLive(row) || m_table.dirty(row) == TrackChangeNone) continue;
+        if (tiered && !refreshDueLocked(row, routine, nowMs)) continue;
+        quint32 fields = m_table.takeDirty(row);
+        changes.add(m_rowTracks[row]->handle(), fields);
+        if (tiered) m_refreshRows[row] = 1;
+        if (fields & (TrackChangeClassification | TrackChangeThreatLevel | TrackChangeState)) {
+            updateHostileQueueLocked(m_rowTracks[row]);
+        }
+    }
+    
+    // A cycle between routine ones with nothing due leaves the picture be
+    bool published = true;
+    quint64 sequence;
+    if (!tiered) {
+        sequence = publishSnapshotLocked();
+    } else {
+        bool rebuild = routine;
+        for (quint32 fields : qAsConst(changes.fields)) {
+            if (fields & (TrackChangeCreated | TrackChangeDropped | TrackChangeState)) rebuild = true;
+        }
+        published = rebuild || !changes.isEmpty();
+        sequence = published ? publishTieredSnapshotLocked(rebuild) : m_snapshotSequence;
+    }
+    changes.sequence = sequence;
+    exportMetricsLocked(cycleStartNs);
+    
+    locker.unlock();
+    
+    for (const MergedTrack& entry : merged) {
+        CUAS_LOG_INFO("TrackManager", QString("Merged duplicate track %1 into %2").arg(entry.sourceId, entry.targetId));
+        emit trackDropped(entry.sourceId);
+        emit trackHandleDropped(entry.sourceHandle);
+    }
+    if (published) {
+        emit snapshotPublished(sequence);
+    }
+    if (!changes.isEmpty()) {
+        emit tracksChanged(changes);
+    }
+}
+
+bool TrackManager::refreshDueLocked(int row, bool routine, qint64 nowMs) {
+    // What changes a track's standing goes out on the next cycle
+    const quint32 urgent = TrackChangeCreated | TrackChangeState | TrackChangeThreatLevel |
+                           TrackChangeClassification;
+    if (m_table.dirty(row) & urgent) return true;
+    
+    switch (m_table.updateTier(row)) {
+        case TrackUpdateTier::Priority:
+            return true;
+        case TrackUpdateTier::Background:
+            if (!routine || m_table.refreshDueMs(row) > nowMs) return false;
+            m_table.setRefreshDueMs(row, nowMs + 1000 / qMax(1, m_config.backgroundRateHz));
+            return true;
+        default:
+            return routine;
+    }
+}
+
+int TrackManager::cycleIntervalMs() const {
+    const int rateHz = m_config.tieredRates ? qMax(m_config.updateRateHz, m_config.priorityRateHz)
+                                            : m_config.updateRateHz;
+    return 1000 / qMax(1, rateHz);
+}
+
+void TrackManager::exportMetricsLocked(qint64 cycleStartNs) {
+    m_metrics.activeTracks->set(m_table.stateCount(TrackState::Initiated) +
+                                m_table.stateCount(TrackState::Active));
+    m_metrics.coastingTracks->set(m_table.stateCount(TrackState::Coasting));
+    m_metrics.tentativeTracks->set(m_tentatives.size());
+    m_metrics.tracksCreated->setTotal(m_stats.totalTracksCreated);
+    m_metrics.tracksDropped->setTotal(m_stats.totalTracksDropped);
+    m_metrics.outOfSequence->setTotal(m_stats.outOfSequenceUpdates);
+    m_metrics.tracksMerged->setTotal(m_stats.autoMerges);
+    const qint64 historyBytes = qint64(m_slab.size()) * historyCapacity() * qint64(sizeof(QPair<GeoPosition, qint64>));
+    m_historyBytes.store(historyBytes, std::memory_order_relaxed);
+    m_historyAccount.set(historyBytes);
+    const qint64 cycleUs = (TimeUtils::monotonicNs() - cycleStartNs) / 1000;
+    m_metrics.cycleTime->record(cycleUs);
+    if (!m_replayMode) {
+        const qint64 budgetUs = qint64(cycleIntervalMs()) * 1000;
+        ThreadPlacement::instance().reportCycle(ThreadRole::Fusion, cycleUs, budgetUs);
+        OverloadController::instance().reportStage(LoadStage::TrackCycle, cycleUs, budgetUs);
+        FlightRecorder::instance().reportCycle(FlightStage::TrackCycle, cycleUs, budgetUs);
+    }
+}
+
+quint64 TrackManager::publishSnapshotLocked() {
+    auto picture = std::make_shared<TrackPicture>();
+    picture->sequence = ++m_snapshotSequence;
+    picture->timestampMs = (m_replayMode || m_mirrorMode) ? m_replayTimeMs : m_clock->nowMs();
+    picture->tracks.reserve(m_tracks.size());
+    picture->indexById.reserve(m_tracks.size());
+    picture->indexByHandle.reserve(m_tracks.size());
+    
+    for (Track* t : m_slab.live()) {
+        if (t->state() == TrackState::Dropped) continue;
+        picture->indexById.insert(t->trackId(), picture->tracks.size());
+        picture->indexByHandle.insert(t->handle(), picture->tracks.size());
+        picture->tracks.append(TrackSnapshot::fromTrack(*t));
+        picture->tracks.last().covariance = positionCovarianceLocked(t->tableRow());
+        if (t->lastIngestMonoNs() > picture->newestIngestNs) {
+            picture->newestIngestNs = t->lastIngestMonoNs();
+            picture->newestReceiveLagUs = t->receiveLagUs();
+        }
+    }
+    fillGroupsLocked(*picture);
+    
+    std::atomic_store(&m_snapshot, std::shared_ptr<const TrackPicture>(std::move(picture)));
+    return m_snapshotSequence;
+}
+
+quint64 TrackManager::publishTieredSnapshotLocked(bool rebuild) {
+    // Only this thread stores m_snapshot, so it is read here without atomic_load
+    const std::shared_ptr<const TrackPicture> previous = m_snapshot;
+    std::shared_ptr<TrackPicture> picture;
+    
+    if (!rebuild) {
+        // Same tracks as the last picture; overwrite the entries reported
+        picture = std::make_shared<TrackPicture>(*previous);
+        for (int row = 0; row < m_refreshRows.size() && !rebuild; ++row) {
+            if (!m_refreshRows[row]) continue;
+            const Track* t = m_rowTracks[row];
+            auto it = picture->indexByHandle.constFind(t->handle());
+            if (it == picture->indexByHandle.constEnd()) {
+                rebuild = true;
+                break;
+            }
+            TrackSnapshot& entry = picture->tracks[it.value()];
+            entry = TrackSnapshot::fromTrack(*t);
+            entry.covariance = positionCovarianceLocked(row);
+            if (t->lastIngestMonoNs() > picture->newestIngestNs) {
+                picture->newestIngestNs = t->lastIngestMonoNs();
+                picture->newestReceiveLagUs = t->receiveLagUs();
+            }
+        }
+    }
+    
+    if (rebuild) {
+        picture = std::make_shared<TrackPicture>();
+        picture->tracks.reserve(m_tracks.size());
+        picture->indexById.reserve(m_tracks.size());
+        picture->indexByHandle.reserve(m_tracks.size());
+        for (Track* t : m_slab.live()) {
+            if (t->state() == TrackState::Dropped) continue;
+            const int row = t->tableRow();
+            const TrackSnapshot* kept = nullptr;
+            if (m_table.updateTier(row) == TrackUpdateTier::Background && !m_refreshRows.value(row)) {
+                kept = previous->find(t->handle());
+            }
+            picture->indexById.insert(t->trackId(), picture->tracks.size());
+            picture->indexByHandle.insert(t->handle(), picture->tracks.size());
+            if (kept) {
+                picture->tracks.append(*kept);
+                continue;
+            }
+            picture->tracks.append(TrackSnapshot::fromTrack(*t));
+            picture->tracks.last().covariance = positionCovarianceLocked(row);
+            if (t->lastIngestMonoNs() > picture->newestIngestNs) {
+                picture->newestIngestNs = t->lastIngestMonoNs();
+                picture->newestReceiveLagUs = t->receiveLagUs();
+            }
+        }
+    }
+    
+    fillGroupsLocked(*picture);
+    
+    picture->sequence = ++m_snapshotSequence;
+    picture->timestampMs = m_clock->nowMs();
+    std::atomic_store(&m_snapshot, std::shared_ptr<const TrackPicture>(std::move(picture)));
+    return m_snapshotSequence;
+}
+
+void TrackManager::fillGroupsLocked(TrackPicture& picture) const {
+    picture.groups.clear();
+    if (!m_config.groupTracks) return;
+    picture.groups.reserve(m_groups.groupCount());
+    for (const TrackGroup& group : m_groups.groups()) {
+        picture.groups.append(group);
+    }
+    std::sort(picture.groups.begin(), picture.groups.end(),
+              [](const TrackGroup& a, const TrackGroup& b) { return a.groupId < b.groupId; });
+}
+
+PositionCovariance TrackManager::positionCovarianceLocked(int row) const {
+    // Filter state order is [e, ve, ae, n, vn, an, u, vu, au]
+    constexpr int E = 0, N = 3, U = 6;
+    if (m_mirrorMode) {
+        return row < m_mirrorCovariance.size() ? m_mirrorCovariance[row] : PositionCovariance();
+    }
+    PositionCovariance cov;
+    if (m_config.enableKalmanFilter && m_immBank.isActive(row)) {
+        cov.ee = m_immBank.covariance(row, E, E);
+        cov.en = m_immBank.covariance(row, E, N);
+        cov.nn = m_immBank.covariance(row, N, N);
+        cov.uu = m_immBank.covariance(row, U, U);
+    } else if (m_config.enableKalmanFilter && m_filterBank.isActive(row)) {
+        cov.ee = m_filterBank.covariance(row, E, E);
+        cov.en = m_filterBank.covariance(row, E, N);
+        cov.nn = m_filterBank.covariance(row, N, N);
+        cov.uu = m_filterBank.covariance(row, U, U);
+    } else {
+        // Unfiltered tracks sit on their last plot
+        const double variance = m_config.kalmanMeasurementNoiseM * m_config.kalmanMeasurementNoiseM;
+        cov.ee = cov.nn = cov.uu = variance;
+    }
+    return cov;
+}
+
+template <typename Policy>
+Track* TrackManager::findCorrelatedTrack(const SensorDetection& detection) {
+    QReadLocker locker(&m_lock);
+    
+    Track* bestMatch = nullptr;
+    double bestScore = 0.0;
+    const qint64 nowMs = m_clock->nowMs();
+    
+    // Tracks beyond correlationDistanceM can never clear the threshold, so
+    // only the neighbouring grid cells need scoring.
+    CorrelationScratch& scratch = correlationScratch();
+    scoreCandidatesLocked<Policy>(detection, nowMs, scratch);
+    for (const CorrelationCandidate& candidate : scratch.scores) {
+        if (candidate.score > bestScore && candidate.score > 0.5) {  // Minimum correlation threshold
+            bestScore = candidate.score;
+            bestMatch = scratch.tracks[candidate.index];
+        }
+    }
+    
+    return bestMatch;
+}
+
+TrackManager::CorrelationScratch& TrackManager::correlationScratch() {
+    thread_local CorrelationScratch scratch;
+    return scratch;
+}
+
+template <typename Policy>
+void TrackManager::scoreCandidatesLocked(const SensorDetection& detection, qint64 nowMs,
+                                         CorrelationScratch& scratch) const {
+    scratch.tracks.clear();
+    scratch.rows.clear();
+    scratch.scores.clear();
+    
+    CorrelationGate gate;
+    gate.distanceM = m_config.correlationDistanceM;
+    gate.velocityMps = m_config.correlationVelocityMps;
+    gate.coastingTimeoutMs = m_config.coastingTimeoutMs;
+    double radiusM = gate.distanceM;
+    if constexpr (Policy::LINE_OF_SIGHT) {
+        // Along its bearing the plot can be 1 / RANGE_WEIGHT gates out
+        gate.lineOfSight = Policy::lineOfSight(detection);
+        if (gate.lineOfSight.range() > 0.0) radiusM /= Policy::RANGE_WEIGHT;
+    }
+    m_spatialIndex.query(detection.position, radiusM, scratch.candidates);
+    for (TrackHandle handle : scratch.candidates) {
+        Track* t = m_tracksByHandle.value(handle, nullptr);
+        if (!t) continue;
+        scratch.tracks.append(t);
+        scratch.rows.append(t->tableRow());
+    }
+    if (scratch.rows.isEmpty()) return;
+    
+    m_table.scoreCandidates<Policy>(scratch.rows.constData(), scratch.rows.size(),
+                                    m_table.frame().toEnu(detection.position), detection.velocity,
+                                    nowMs, gate, scratch.scores);
+}
+
+void TrackManager::applyLifecycleTransition(const LifecycleTransition& transition) {
+    Track* track = m_rowTracks.value(transition.row, nullptr);
+    if (!track) return;
+    
+    switch (transition.action) {
+        case LifecycleAction::StartCoasting:
             track->setState(TrackState::Coasting);
             track->incrementCoastCount();
             emit trackStateChanged(track->trackId(), TrackState::Coasting);
-        }
-    } else if (track->state() == TrackState::Coasting) {
-        if (timeSinceUpdate > m_config.dropTimeoutMs || 
-            track->coastCount() > m_config.maxCoastCount) {
+            break;
+        case LifecycleAction::ContinueCoast:
+            track->incrementCoastCount();
+            break;
+        case LifecycleAction::Drop:
             track->setState(TrackState::Dropped);
+            m_spatialIndex.remove(track->handle());
+            m_groups.remove(track->handle());
+            m_hostileQueue.remove(track->handle());
             m_stats.totalTracksDropped++;
             emit trackStateChanged(track->trackId(), TrackState::Dropped);
             emit trackDropped(track->trackId());
-        } else {
-            track->incrementCoastCount();
-        }
-    } else if (track->state() == TrackState::Initiated) {
-        // Auto-promote to active if we have updates
-        if (track->timeSinceUpdate() < m_config.coastingTimeoutMs) {
+            emit trackHandleDropped(track->handle());
+            break;
+        case LifecycleAction::Activate:
+            // Auto-promote to active if we have updates
             track->setState(TrackState::Active);
             emit trackStateChanged(track->trackId(), TrackState::Active);
-        }
+            break;
+        default:
+            break;
     }
 }
 
-void TrackManager::applyKalmanFilter(Track* track, const GeoPosition& measurement) {
-    if (!m_config.enableKalmanFilter) return;
+void TrackManager::releaseTrackLocked(Track* track) {
+    if (!track) return;
     
-    QString trackId = track->trackId();
-    if (!m_kalmanFilters.contains(trackId)) {
-        auto filter = std::make_shared<KalmanFilter2D>();
-        filter->initialize(measurement.latitude, measurement.longitude);
-        m_kalmanFilters.insert(trackId, filter);
+    int row = track->tableRow();
+    if (row >= 0 && row < m_rowTracks.size()) {
+        m_rowTracks[row] = nullptr;
+    }
+    if (m_table.isLive(row)) {
+        m_releasedChanges.add(track->handle(), m_table.takeDirty(row) | TrackChangeDropped);
+    }
+    m_table.release(row);
+    m_filterBank.release(row);
+    m_immBank.release(row);
+    m_features.release(row);
+    m_mht.forget(track->handle());
+    m_slab.release(track);
+}
+
+void TrackManager::applyFilterConfig() {
+    m_filterBank.setProcessNoise(m_config.kalmanMotionModel, m_config.kalmanProcessNoise);
+    m_filterBank.setMeasurementNoise(m_config.kalmanMeasurementNoiseM);
+    m_immBank.setProcessNoise(m_config.kalmanProcessNoise, m_config.kalmanProcessNoise * 0.5);
+    m_immBank.setMeasurementNoise(m_config.kalmanMeasurementNoiseM);
+    m_immBank.setTurnRate(m_config.immTurnRateDegPerSec);
+    m_immBank.setSwitchProbability(m_config.immSwitchProbability);
+    if (m_filterBank.historyDepth() != qMax(0, m_config.oosmHistoryDepth)) {
+        m_filterBank.setHistoryDepth(m_config.oosmHistoryDepth);
+    }
+}
+
+qint64 TrackManager::measurementTime(qint64 timestampMs, qint64 nowMs) const {
+    // Only trust plot stamps that look like this clock; a sensor on its own
+    // epoch would otherwise rewind every filter
+    if (timestampMs <= 0 || timestampMs > nowMs ||
+        nowMs - timestampMs > m_config.maxMeasurementLagMs) {
+        return nowMs;
+    }
+    return timestampMs;
+}
+
+void TrackManager::applyAssociationConfig() {
+    MhtConfig mht;
+    mht.scanDepth = qMax(1, m_config.mhtScanDepth);
+    mht.maxHypotheses = qMax(1, m_config.mhtMaxHypotheses);
+    mht.budgetUs = qMax(0, m_config.mhtBudgetUs);
+    mht.detectionProbability = m_config.mhtDetectionProbability;
+    mht.falseAlarmDensity = m_config.mhtFalseAlarmDensity;
+    mht.processNoise = m_config.kalmanProcessNoise;
+    mht.measurementSigmaM = m_config.kalmanMeasurementNoiseM;
+    m_mht.setConfig(mht);
+    if (m_config.associationMode != AssociationMode::Mht) {
+        m_mht.clear();  // Nothing follows them outside Mht
+    }
+}
+
+void TrackManager::applyInitiationConfig() {
+    m_tentatives.setRule(m_config.initiationHits, m_config.initiationScans,
+                         m_config.initiationScanMs, m_config.maxTentativeTracks,
+                         m_config.correlationDistanceM);
+}
+
+void TrackManager::applyGroupConfig() {
+    TrackGroupConfig group = m_groups.config();
+    if (group.linkDistanceM != m_config.groupLinkDistanceM ||
+        group.linkVelocityMps != m_config.groupLinkVelocityMps ||
+        group.minNeighbours != m_config.groupMinNeighbours ||
+        group.minMembers != m_config.groupMinMembers) {
+        group.linkDistanceM = m_config.groupLinkDistanceM;
+        group.linkVelocityMps = m_config.groupLinkVelocityMps;
+        group.minNeighbours = m_config.groupMinNeighbours;
+        group.minMembers = m_config.groupMinMembers;
+        m_groups.setConfig(group);
+    }
+    if (m_config.groupTracks) {
+        // Just switched on: what does not move would otherwise never join
+        if (m_groups.trackCount() == 0) {
+            for (Track* t : m_slab.live()) {
+                if (t->state() == TrackState::Dropped) continue;
+                const int row = t->tableRow();
+                m_groups.update(t->handle(), m_table.position(row), m_table.velocity(row));
+            }
+        }
         return;
     }
     
-    auto it = m_kalmanFilters.find(trackId);
-    if (it != m_kalmanFilters.end()) {
-        it.value()->update(measurement.latitude, measurement.longitude);
+    // Off: no track stays in a group the index no longer keeps
+    m_groups.clear();
+    for (Track* t : m_slab.live()) {
+        if (t->groupId() == 0) continue;
+        t->setGroup(0, 0);
+        m_table.markDirty(t->tableRow(), TrackChangeGroup);
+    }
+}
+
+void TrackManager::updateGroupsLocked(qint64 nowMs) {
+    const quint32 moved = TrackChangeKinematics | TrackChangeCreated;
+    const int rows = m_rowTracks.size();
+    for (int row = 0; row < rows; ++row) {
+        if (!m_table.isLive(row) || !(m_table.dirty(row) & moved)) continue;
+        if (m_table.state(row) == TrackState::Dropped) continue;
+        m_groups.update(m_rowTracks[row]->handle(), m_table.position(row), m_table.velocity(row));
     }
+    
+    m_groups.recluster(nowMs, m_groupChanges);
+    for (quint32 id : qAsConst(m_groupChanges.changed)) {
+        const TrackGroup* group = m_groups.group(id);
+        for (TrackHandle handle : group->members) {
+            Track* t = m_tracksByHandle.value(handle, nullptr);
+            if (!t || (t->groupId() == id && t->groupSize() == group->members.size())) continue;
+            t->setGroup(id, group->members.size());
+            m_table.markDirty(t->tableRow(), TrackChangeGroup);
+        }
+    }
+    for (TrackHandle handle : qAsConst(m_groupChanges.left)) {
+        Track* t = m_tracksByHandle.value(handle, nullptr);
+        if (!t || t->groupId() == 0) continue;
+        t->setGroup(0, 0);
+        m_table.markDirty(t->tableRow(), TrackChangeGroup);
+    }
+}
+
+void TrackManager::anchorFrameLocked(const GeoPosition& pos) {
+    if (m_hasFilterOrigin) return;
+    GeoPosition origin = pos;
+    origin.altitude = 0.0;
+    m_table.setFrameOrigin(origin);
+    m_hasFilterOrigin = true;
+}
+
+EnuVector TrackManager::toFilterFrameLocked(const GeoPosition& pos) {
+    anchorFrameLocked(pos);
+    return m_table.frame().toEnu(pos);
+}
+
+GeoPosition TrackManager::fromFilterFrame(const EnuVector& enu) const {
+    return m_table.frame().toGeo(enu);
+}
+
+int TrackManager::historyCapacity() const {
+    // History is sampled on every accepted update, which arrives no faster
+    // than the track cycle rate.
+    const qint64 rate = qMax(1, m_config.updateRateHz);
+    qint64 samples = static_cast<qint64>(m_config.historyRetentionMs) * rate / 1000;
+    if (m_historyShift > 0) {
+        // Shed under memory pressure, down to what a merge comparison needs
+        const qint64 mergeSamples = static_cast<qint64>(m_config.mergeWindowMs) * rate / 1000;
+        samples = qMin(samples, qMax(samples >> (m_historyShift * 2), mergeSamples));
+    }
+    return static_cast<int>(qBound<qint64>(1, samples, 100000));
+}
+
+void TrackManager::updateHostileQueueLocked(Track* track) {
+    if (track->state() == TrackState::Dropped ||
+        track->classification() != TrackClassification::Hostile) {
+        m_hostileQueue.remove(track->handle());
+        return;
+    }
+    
+    ThreatPriorityQueue::Entry entry;
+    entry.handle = track->handle();
+    entry.threatLevel = track->threatLevel();
+    m_hostileQueue.update(entry);
+}
+
+TrackHandle TrackManager::allocateHandle() {
+    const TrackHandle handle = static_cast<TrackHandle>(m_nextTrackNumber);
+    m_nextTrackNumber += m_handleStride;
+    return handle;
+}
+
+bool TrackManager::runOnOwnerThread(const std::function<void()>& fn) {
+    QThread* owner = thread();
+    if (owner == QThread::currentThread() || !owner->isRunning()) return false;
+    QMetaObject::invokeMethod(this, fn, Qt::BlockingQueuedConnection);
+    return true;
 }
 
-QString TrackManager::generateTrackId() {
-    return QString("TRK-%1").arg(m_nextTrackNumber++, 4, 10, QChar('0'));
+QString TrackManager::formatTrackId(TrackHandle handle) {
+    return QString("TRK-%1").arg(handle, 4, 10, QChar('0'));
 }
 
 } // namespace CounterUAS
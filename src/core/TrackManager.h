@@ -4,16 +4,41 @@
 #include <QObject>
 #include <QHash>
 #include <QList>
+#include <QVector>
+#include <QStringList>
 #include <QTimer>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <atomic>
+#include <functional>
 #include <memory>
 
 #include "core/Track.h"
-#include "utils/KalmanFilter.h"
+#include "core/TrackHandle.h"
+#include "core/TrackChangeSet.h"
+#include "core/TrackSpatialIndex.h"
+#include "core/TrackGroupIndex.h"
+#include "core/TentativeTrackPool.h"
+#include "core/ThreatPriorityQueue.h"
+#include "core/TrackTable.h"
+#include "core/TrackSlab.h"
+#include "core/TrackFeatureBank.h"
+#include "core/TrackClassifier.h"
+#include "core/MhtAssociator.h"
+#include "core/TrackSnapshot.h"
+#include "utils/KalmanFilterBank.h"
+#include "utils/ImmFilterBank.h"
+#include "utils/Clock.h"
+#include "utils/LatencyStats.h"
+#include "utils/MemoryAccounting.h"
 
 namespace CounterUAS {
 
+struct SensorDetection;
+class MetricCounter;
+class MetricGauge;
+class LatencyHistogram;
+
 /**
  * @brief Configuration for track management
  */
@@ -25,12 +50,75 @@ struct TrackManagerConfig {
     int dropTimeoutMs = 15000;           // Time before track is dropped
     int maxCoastCount = 10;              // Max coast cycles before drop
     bool enableKalmanFilter = true;      // Enable position smoothing
+    MotionModel kalmanMotionModel = MotionModel::ConstantVelocity;
+    double kalmanProcessNoise = 1.0;     // Process noise spectral density
+    double kalmanMeasurementNoiseM = 10.0; // Position measurement sigma
+    bool enableImmFilter = false;        // IMM (CV/CA/turn) instead of a single model
+    double immTurnRateDegPerSec = 15.0;  // Turn rate of the coordinated-turn modes
+    double immSwitchProbability = 0.05;  // Per-cycle chance of leaving a mode
+    int oosmHistoryDepth = 8;            // Filter updates kept to replay late plots; 0 fuses them on arrival
+    int maxMeasurementLagMs = 2000;      // Plot timestamps further off than this are taken as arrival time
     int maxTracks = 200;                 // Maximum concurrent tracks
+    int initiationHits = 1;              // M of M-of-N initiation; 1 creates tracks on the first plot
+    int initiationScans = 1;             // N opportunities to collect the M hits
+    int initiationScanMs = 1000;         // Length of one opportunity (sensor revisit time)
+    int maxTentativeTracks = 2000;       // Tentatives held before the oldest is displaced
     int historyRetentionMs = 60000;      // Position history retention
+    bool autoMerge = true;               // Merge tracks whose histories show one object
+    double mergeSearchRadiusM = 300.0;   // Around each track, for duplicate candidates
+    int mergeWindowMs = 10000;           // History compared for a candidate pair
+    int mergeMinSamples = 5;             // Overlapping samples before a pair is judged
+    double mergeGateZ = 2.326;           // Normal quantile of the chi-square gate (99 %)
+    int mergeBudgetUs = 500;             // Merge pass time per cycle; 0 sweeps every track
+    int parallelGatingMinPlots = 256;    // Batches this large gate their plots on the TaskScheduler; 0 never
+    
+    // How processDetectionBatch associates a scan. Mht keeps competing
+    // plot-to-track hypotheses open for mhtScanDepth scans and moves a
+    // track's filter onto another branch when a later scan overturns an
+    // earlier choice. Clusters still open when a scan has used mhtBudgetUs
+    // are associated as Gnn.
+    AssociationMode associationMode = AssociationMode::Gnn;
+    int mhtScanDepth = 3;
+    int mhtMaxHypotheses = 8;            // Global hypotheses kept per cluster
+    int mhtBudgetUs = 2000;              // Per scan; 0 unbounded
+    double mhtDetectionProbability = 0.9;
+    double mhtFalseAlarmDensity = 1e-7;  // Clutter plots per cubic metre
+    bool groupTracks = false;            // Cluster live tracks into swarm groups each routine cycle
+    double groupLinkDistanceM = 150.0;   // Group neighbours are closer than this...
+    double groupLinkVelocityMps = 15.0;  // ...and moving within this of each other
+    int groupMinNeighbours = 2;          // Neighbours that make a track a group core
+    int groupMinMembers = 3;             // Smaller clusters are not groups
+    
+    // Tiered rates: the cycle runs at priorityRateHz, and each track is
+    // refreshed in the picture and reported in tracksChanged at its
+    // TrackUpdateTier's rate. Lifecycle and prediction stay at
+    // updateRateHz; creation, drops and state, threat and class changes
+    // are reported on the next cycle whatever the tier.
+    bool tieredRates = false;
+    int priorityRateHz = 25;
+    int backgroundRateHz = 1;
+};
+
+/**
+ * @brief One track's assessed threat, for TrackManager::applyThreatAssessments()
+ */
+struct TrackThreatUpdate {
+    TrackHandle handle = INVALID_TRACK_HANDLE;
+    int threatLevel = 1;
+    TrackClassification classification = TrackClassification::Unknown;  // Unknown: left as is
+    
+    // Filled in by applyThreatAssessments()
+    bool applied = false;               // False: track gone, or nothing to change
+    int previousThreatLevel = 0;
+    TrackClassification previousClassification = TrackClassification::Unknown;
 };
 
 /**
  * @brief Track Manager Engine for multi-sensor track fusion and lifecycle management
+ *
+ * The manager may live on a worker thread (see FusionEngine). Lifecycle and
+ * configuration calls are marshalled to that thread; track data is guarded
+ * by m_lock, and consumers on other threads should prefer snapshot().
  */
 class TrackManager : public QObject {
     Q_OBJECT
@@ -45,29 +133,81 @@ public:
     void setConfig(const TrackManagerConfig& config);
     TrackManagerConfig config() const { return m_config; }
     
+    // Every timestamp the manager takes comes from clock (the wall clock
+    // by default). Set it while stopped, with no tracks, or existing
+    // tracks are restamped.
+    void setClock(const Clock* clock);
+    const Clock* clock() const { return m_clock; }
+    
     // Lifecycle
     void start();
     void stop();
     bool isRunning() const { return m_running; }
+    // One track cycle now, for a caller driving the manager on its own
+    // clock while the cycle timer is stopped
+    void step();
     
-    // Track access
+    // Track access. Track objects are recycled, never freed, while the
+    // manager lives: a pointer kept past its track's drop stays safe to read
+    // but may by then be another track, which Track::generation() tells.
     int trackCount() const;
     QList<Track*> allTracks() const;
+    void allTracks(QVector<Track*>& out) const;
     Track* track(const QString& trackId) const;
+    Track* track(TrackHandle handle) const;
+    TrackHandle handleOf(const QString& trackId) const;  // INVALID_TRACK_HANDLE if unknown
+    static QString formatTrackId(TrackHandle handle);
+    // Classification and threat level queries read the table's indexes and
+    // cost their result; tracksByThreatLevel() is highest level first
     QList<Track*> tracksByClassification(TrackClassification cls) const;
     QList<Track*> tracksByThreatLevel(int minLevel) const;
     QList<Track*> tracksInRadius(const GeoPosition& center, double radiusM) const;
+    // The same queries into a caller's buffer, cleared first, so a caller
+    // polling every cycle reuses its capacity instead of allocating
+    void tracksByClassification(TrackClassification cls, QVector<Track*>& out) const;
+    void tracksByThreatLevel(int minLevel, QVector<Track*>& out) const;
+    void tracksInRadius(const GeoPosition& center, double radiusM, QVector<Track*>& out) const;
     QList<Track*> hostileTracks() const;
     QList<Track*> pendingTracks() const;
     Track* highestThreatTrack() const;
     
-    // Track creation and update
+    // Filter-based extrapolation (CV/CA per config); falls back to the
+    // track's own velocity when filtering is disabled.
+    GeoPosition predictedPosition(const QString& trackId, qint64 deltaMs) const;
+    
+    // Lock-free read path: the picture published by the last track cycle.
+    // Never null; safe to call and hold from any thread.
+    TrackPicturePtr snapshot() const;
+    
+    // Uncorrelated plots held for M-of-N confirmation, not yet tracks
+    int tentativeCount() const;
+    QVector<TentativeTrack> tentativeTracks() const;
+    
+    // Track creation and update (createTrack bypasses M-of-N initiation)
     QString createTrack(const GeoPosition& pos, DetectionSource source);
-    void updateTrack(const QString& trackId, const GeoPosition& pos);
+    // timestampMs dates the measurement for the filter; 0 means now
+    void updateTrack(const QString& trackId, const GeoPosition& pos, qint64 timestampMs = 0);
     void updateTrackVelocity(const QString& trackId, const VelocityVector& vel);
     void setTrackClassification(const QString& trackId, TrackClassification cls, double confidence = 1.0);
     void setTrackThreatLevel(const QString& trackId, int level);
+    // Every update under one write lock, compared with the live track, and
+    // one threatAssessmentsApplied() for those that changed it in place of
+    // the per-track signals. Returns how many did
+    int applyThreatAssessments(QVector<TrackThreatUpdate>& updates);
+    // Tiered rates: the threat assessor's choice per track, Routine until set
+    void setUpdateTiers(const QVector<QPair<TrackHandle, TrackUpdateTier>>& tiers);
+    TrackUpdateTier updateTier(TrackHandle handle) const;
+    // Learned classification, for the threat assessor to run once a cycle:
+    // every live track with enough updates, other than Friendly, Neutral
+    // and those classified outright (confidence 1), takes the classifier's
+    // small-UAS probability from its running features as its
+    // classificationConfidence. One batched inference under one write
+    // lock; returns how many tracks' confidence moved
+    int classifyTracks();
+    bool setClassifierModel(const TrackClassifierModel& model);  // False if malformed
+    TrackClassifierModel classifierModel() const;
     void setTrackBoundingBox(const QString& trackId, const BoundingBox& box);
+    BoundingBox trackBoundingBox(const QString& trackId) const;
     void associateCamera(const QString& trackId, const QString& cameraId);
     
     // Manual track management
@@ -82,32 +222,124 @@ public:
                             qint64 timestamp);
     void processCameraDetection(const QString& cameraId, const BoundingBox& box,
                                 const GeoPosition& estimatedPos, qint64 timestamp);
+    // One object seen by several cameras, boxes most confident first and
+    // each with its cameraId. Correlated once; a track keeps the camera
+    // it is associated with while that camera is among them.
+    void processCameraDetection(const QVector<BoundingBox>& boxes,
+                                const GeoPosition& estimatedPos, qint64 timestamp);
+    
+    // One scan's worth of plots, associated jointly under a single write
+    // lock: by global nearest neighbour, or with associationMode Mht over
+    // the last few scans. Emits one tracksUpdated() for the whole batch.
+    void processDetectionBatch(const QVector<SensorDetection>& detections);
+    
+    // Replay: recorded positions stand in for sensor input, which is
+    // ignored, and coasting and dropping run on the replay clock. Switching
+    // either way clears every track.
+    void setReplayMode(bool replay);
+    bool isReplayMode() const { return m_replayMode; }
+    // Samples up to replayTimeMs, oldest first; a track ID not seen before
+    // creates a track of that ID
+    void applyReplaySamples(const QVector<TrackHistorySample>& samples, qint64 replayTimeMs);
+    
+    // Mirror: the tracks are a copy of another manager's, as a console
+    // shows the picture of the core it is attached to (see CoreClient).
+    // Sensor input is ignored and nothing ages or merges here; each track
+    // takes the fields it is given, and the picture's time. Switching
+    // either way clears every track. Not combined with replay.
+    void setMirrorMode(bool mirror);
+    bool isMirrorMode() const { return m_mirrorMode; }
+    // A whole picture: tracks missing from it are dropped
+    void applyMirrorPicture(const TrackPicturePtr& picture);
+    // Changes only, as a delta stream delivers them; timeMs is the picture time
+    void applyMirrorTracks(const QVector<TrackSnapshot>& updated, const QStringList& dropped,
+                           qint64 timeMs);
     
     // Batch operations
     void clearAllTracks();
     void pruneDroppedTracks();
     
+    // Track IDs are allocated first, first + stride, ... so that several
+    // managers sharing one picture (ShardedTrackManager) never collide. Set
+    // before the first track.
+    void setHandleSequence(TrackHandle first, int stride);
+    
+    // Ownership transfer between managers: extractTrack() removes a live
+    // track and returns its state, adoptTrack() recreates it under the same
+    // ID and handle with a filter restarted at its position. Neither counts
+    // as a track created or dropped in statistics(), but the membership
+    // signals (trackCreated/trackDropped and handle variants) are emitted.
+    bool extractTrack(TrackHandle handle, TrackSnapshot* state = nullptr);
+    bool adoptTrack(const TrackSnapshot& state);
+    
+    // Warm restart (see FusionCheckpointer). checkpointTracks() encodes each
+    // listed track with its history and filter slot, or every live track
+    // when handles is null; a listed handle that is no longer live comes
+    // back with empty data. checkpointState() holds the rest: the id
+    // sequence, the filter frame and the tentatives. Filter state is in host
+    // byte order, so a checkpoint restores on the machine that wrote it.
+    void checkpointTracks(const QVector<TrackHandle>* handles,
+                          QVector<QPair<TrackHandle, QByteArray>>& out) const;
+    QByteArray checkpointState() const;
+    // Rebuilds a checkpoint in an empty manager, aged to now: tracks past
+    // the drop timeout are left out, those past the coasting timeout coast,
+    // and filters resume from their saved state. Returns the tracks
+    // restored, or -1 if the manager has tracks or the state is unreadable.
+    int restoreCheckpoint(const QByteArray& state, const QVector<QByteArray>& tracks);
+    
     // Statistics
     struct Statistics {
         int totalTracksCreated = 0;
         int totalTracksDropped = 0;
-        int currentActiveCount = 0;
+        int currentActiveCount = 0;      // Initiated or Active
         int currentCoastingCount = 0;
         int correlationSuccessCount = 0;
+        int currentTentativeCount = 0;
+        qint64 totalTentativesConfirmed = 0;
+        qint64 totalTentativesExpired = 0;
         qint64 lastUpdateTimeMs = 0;
+        LatencyStats ingestToUpdate;  // Sensor read to track update, stamped plots only
+        qint64 outOfSequenceUpdates = 0;    // Late plots fused by filter replay
+        qint64 outOfSequenceDiscarded = 0;  // Late plots older than the filter history
+        qint64 autoMerges = 0;              // Duplicates merged by the merge pass
+        qint64 mergePairsTested = 0;
+        qint64 mergeSweeps = 0;             // Completed passes over every track
+        qint64 mergeBudgetExhausted = 0;    // Cycles whose pass stopped on mergeBudgetUs
+        qint64 mhtClusters = 0;             // Mht: clusters associated
+        qint64 mhtHypotheses = 0;           // Mht: global hypotheses kept, over all clusters
+        qint64 mhtRevisions = 0;            // Mht: filters moved onto another branch
+        qint64 mhtBudgetFallbacks = 0;      // Mht: clusters associated as Gnn on the budget
+        int mhtOpenTracks = 0;              // Mht: tracks carrying hypotheses now
     };
-    Statistics statistics() const { return m_stats; }
+    Statistics statistics() const;
     
 signals:
     void trackCreated(const QString& trackId);
     void trackUpdated(const QString& trackId);
+    void tracksUpdated(const QStringList& trackIds);
+    
+    // Handle-keyed counterparts, emitted alongside the string signals
+    void trackHandleCreated(TrackHandle handle);
+    void trackHandleUpdated(TrackHandle handle);
+    void trackHandlesUpdated(const QVector<TrackHandle>& handles);
+    void trackHandleDropped(TrackHandle handle);
+    
+    // One per track cycle: every track whose fields changed since the last
+    // cycle, visible in the snapshot with changes.sequence. Subscribers that
+    // want a lower rate should go through a TrackChangeThrottle.
+    void tracksChanged(const TrackChangeSet& changes);
+    
     void trackClassificationChanged(const QString& trackId, TrackClassification cls);
     void trackThreatLevelChanged(const QString& trackId, int level);
+    void threatAssessmentsApplied(const QVector<TrackThreatUpdate>& updates);  // Applied ones only
     void trackStateChanged(const QString& trackId, TrackState state);
     void trackDropped(const QString& trackId);
     void trackCountChanged(int count);
     void highThreatDetected(const QString& trackId, int level);
     void runningChanged(bool running);
+    void replayModeChanged(bool replay);
+    void mirrorModeChanged(bool mirror);
+    void snapshotPublished(quint64 sequence);
     
 public slots:
     void onSensorData(const GeoPosition& pos, const VelocityVector& vel,
@@ -117,29 +349,185 @@ private slots:
     void processTrackCycle();
     
 private:
-    // Track correlation
-    Track* findCorrelatedTrack(const GeoPosition& pos, const VelocityVector& vel,
-                                DetectionSource source);
-    double calculateCorrelationScore(Track* track, const GeoPosition& pos,
-                                     const VelocityVector& vel);
+    // Track correlation, with the gating of a FusionPolicy
+    template <typename Policy>
+    Track* findCorrelatedTrack(const SensorDetection& detection);
+    // Buffers reused from call to call so steady-state correlation does
+    // not allocate; one per thread, as findCorrelatedTrack only holds the
+    // read lock
+    struct CorrelationScratch {
+        QVector<TrackHandle> candidates;
+        QVector<Track*> tracks;
+        QVector<int> rows;
+        QVector<CorrelationCandidate> scores;   // index refers to tracks
+    };
+    static CorrelationScratch& correlationScratch();
+    
+    // Scores a plot against the spatial index candidates in one table pass,
+    // with the kernel instantiated for the policy's measurement model
+    template <typename Policy>
+    void scoreCandidatesLocked(const SensorDetection& detection, qint64 nowMs,
+                               CorrelationScratch& scratch) const;
+    
+    // Lock-held helpers shared by the per-detection and batch paths
+    Track* createTrackLocked(const GeoPosition& pos, DetectionSource source);
+    Track* addTrackLocked(const QString& trackId, TrackHandle handle, const GeoPosition& pos);
+    Track* initiateTrackLocked(const SensorDetection& detection, qint64 nowMs);  // Null while tentative
+    QString initiateTrack(const SensorDetection& detection);
+    void applyCameraDetection(Track* correlated, const QString& cameraId, const BoundingBox& box,
+                              const GeoPosition& estimatedPos, qint64 timestamp);
+    // measuredMs is the plot's sanitized timestamp; 0 means now
+    void updateTrackLocked(Track* track, const GeoPosition& pos, qint64 measuredMs = 0);
+    qint64 measurementTime(qint64 timestampMs, qint64 nowMs) const;
+    void applyDetectionLocked(Track* track, const SensorDetection& detection);
+    // Mht association of a batch's gated plots (see processDetectionBatch).
+    // Filters the best hypotheses now place on other branches are moved
+    // there first; those with no plot this scan are added to moved.
+    void associateMhtLocked(const QVector<SensorDetection>& detections, qint64 nowMs,
+                            QVector<int>& assignment, QVector<Track*>& moved);
+    MhtKinematics mhtKinematicsLocked(const Track* track) const;
+    void reviseTrackLocked(Track* track, const MhtKinematics& state);
+    
+    // Mirror mode: what applying a picture changed, signalled once unlocked
+    struct MirrorEvents {
+        QVector<QPair<QString, TrackHandle>> created;
+        QVector<QPair<QString, TrackHandle>> dropped;
+        QVector<QPair<QString, TrackClassification>> classified;
+        QVector<QPair<QString, int>> threatRaised;      // Level now >= 4, up from below it
+        QVector<QPair<QString, int>> threatChanged;
+        QVector<QPair<QString, TrackState>> stateChanged;
+        QStringList updatedIds;
+        QVector<TrackHandle> updatedHandles;
+    };
+    void mirrorTrackLocked(const TrackSnapshot& state, MirrorEvents& events);
+    void dropMirrorTrackLocked(Track* track, MirrorEvents& events);
+    void emitMirrorEvents(const MirrorEvents& events, int count);
+    
+    // Duplicate-track merging
+    struct MergedTrack {
+        QString sourceId;
+        TrackHandle sourceHandle;
+        QString targetId;
+    };
+    struct MergeSample {
+        qint64 timestampMs;
+        EnuVector position;
+    };
+    void mergeTrackLocked(Track* source, Track* target);
+    // The periodic merge pass (autoMerge), run by the track cycle. Tracks
+    // within mergeSearchRadiusM of each other are tested on their last
+    // mergeWindowMs of history: the other track is interpolated at each of
+    // the newer track's samples, and the summed squared horizontal
+    // Mahalanobis distances, under both tracks' covariances floored at the
+    // plot noise, must pass a chi-square gate on two degrees of freedom per
+    // sample. The engaged, then operator-classified, then older track
+    // survives. Sweeps the tracks round robin, resuming where the last
+    // cycle's budget ran out.
+    void mergeDuplicatesLocked(qint64 nowMs, QVector<MergedTrack>& merged);
+    bool sameObjectLocked(Track* older, Track* newer, qint64 nowMs);
     
     // Track lifecycle
-    void updateTrackState(Track* track);
-    void applyKalmanFilter(Track* track, const GeoPosition& measurement);
-    QString generateTrackId();
+    void applyLifecycleTransition(const LifecycleTransition& transition);
+    void releaseTrackLocked(Track* track);
+    void updateHostileQueueLocked(Track* track);
+    quint64 publishSnapshotLocked();
+    // Tiered rates: rebuilds the picture, or refreshes only m_refreshRows
+    // in a copy of the last one. Background rows not due keep their entry
+    quint64 publishTieredSnapshotLocked(bool rebuild);
+    int cycleIntervalMs() const;  // Of processTrackCycle, from updateRateHz or priorityRateHz
+    // Tiered rates: whether a row with dirty fields is reported this cycle
+    bool refreshDueLocked(int row, bool routine, qint64 nowMs);
+    PositionCovariance positionCovarianceLocked(int row) const;
+    QByteArray encodeTrackLocked(const Track* track) const;
+    Track* decodeTrackLocked(const QByteArray& data, qint64 nowMs);
+    void exportMetricsLocked(qint64 cycleStartNs);
+    int historyCapacity() const;  // Samples covering historyRetentionMs at updateRateHz
+    void applyFilterConfig();
+    void applyInitiationConfig();
+    void applyGroupConfig();
+    void applyAssociationConfig();
+    void updateGroupsLocked(qint64 nowMs);
+    void fillGroupsLocked(TrackPicture& picture) const;  // Sorted by id
+    void anchorFrameLocked(const GeoPosition& pos);  // First track fixes the ENU origin
+    EnuVector toFilterFrameLocked(const GeoPosition& pos);
+    GeoPosition fromFilterFrame(const EnuVector& enu) const;
+    TrackHandle allocateHandle();
+    bool runOnOwnerThread(const std::function<void()>& fn);  // false if already there
     
     mutable QReadWriteLock m_lock;
+    TrackSlab m_slab;                  // Owns every Track, live ones dense; guarded by m_lock
     QHash<QString, Track*> m_tracks;
-    QHash<QString, std::shared_ptr<KalmanFilter2D>> m_kalmanFilters;
+    QHash<TrackHandle, Track*> m_tracksByHandle;  // Same tracks, hot-path key
     
     TrackManagerConfig m_config;
+    TrackSpatialIndex m_spatialIndex;  // Live (non-dropped) tracks, guarded by m_lock
+    TrackGroupIndex m_groups;          // Swarm groups over the same tracks, guarded by m_lock
+    TrackGroupIndex::Changes m_groupChanges;
+    TentativeTrackPool m_tentatives;   // Unconfirmed plots, guarded by m_lock
+    ThreatPriorityQueue m_hostileQueue; // Live hostile tracks by threat level, guarded by m_lock
+    TrackTable m_table;                // Hot per-track columns, guarded by m_lock
+    QVector<Track*> m_rowTracks;       // Table row -> owning Track (null when free)
+    TrackChangeSet m_releasedChanges;  // Tracks pruned since the last cycle
+    
+    // Per-cycle and per-batch working storage, reused under the write lock
+    QVector<LifecycleTransition> m_transitions;
+    QVector<quint8> m_refreshRows;                      // Tiered rates: table rows reported this cycle
+    qint64 m_nextRoutineMs = 0;                         // Tiered rates: next updateRateHz cycle
+    QVector<Track*> m_batchColumns;                     // Cost matrix column -> track
+    QVector<QVector<QPair<int, double>>> m_batchGated;  // Per plot: (column, cost)
+    QVector<QVector<QPair<Track*, double>>> m_batchScored;  // Per plot: (track, cost), before columns
+    QVector<int> m_columnOfRow;                         // Table row -> column, -1 outside a batch
+    MhtAssociator m_mht;               // Hypotheses of contended tracks, guarded by m_lock
+    QVector<MhtPlot> m_mhtPlots;
+    QVector<MhtTrack> m_mhtTracks;
+    MhtScanResult m_mhtResult;
+    KalmanFilterBank m_filterBank;     // One slot per table row, guarded by m_lock
+    ImmFilterBank m_immBank;           // Same slots when enableImmFilter is set
+    TrackFeatureBank m_features;       // Classifier inputs, same slots
+    TrackClassifier m_classifier;
+    QVector<int> m_classifyRows;       // classifyTracks() scratch
+    QVector<float> m_classifyFeatures;
+    QVector<float> m_classifyProbabilities;
+    int m_mergeCursor = 0;             // Next table row for the merge pass
+    QVector<TrackHandle> m_mergeCandidates;  // Merge pass scratch
+    QVector<MergeSample> m_mergeSamples;
+    bool m_hasFilterOrigin = false;    // m_table's frame, shared by the filter banks
     QTimer* m_updateTimer;
     bool m_running = false;
+    const Clock* m_clock = Clock::system();
+    std::atomic<bool> m_replayMode{false};  // Read by the sensor entry points on any thread
+    qint64 m_replayTimeMs = 0;         // Guarded by m_lock; the picture time in mirror mode too
+    std::atomic<bool> m_mirrorMode{false};
+    QVector<PositionCovariance> m_mirrorCovariance;  // Mirror mode: per table row, as given
     
     Statistics m_stats;
     int m_nextTrackNumber = 1;
+    int m_handleStride = 1;
+    
+    // Fleet monitoring series, registered once in the constructor
+    struct Metrics {
+        MetricGauge* activeTracks = nullptr;
+        MetricGauge* coastingTracks = nullptr;
+        MetricGauge* tentativeTracks = nullptr;
+        MetricCounter* tracksCreated = nullptr;
+        MetricCounter* tracksDropped = nullptr;
+        MetricCounter* outOfSequence = nullptr;
+        MetricCounter* tracksMerged = nullptr;
+        LatencyHistogram* cycleTime = nullptr;
+    };
+    Metrics m_metrics;
+    quint64 m_memoryConsumer = 0;       // MemoryGovernor id for the position history
+    int m_historyShift = 0;             // Memory pressure level, quartering the history per step
+    std::atomic<qint64> m_historyBytes{0};
+    MemoryAccount m_historyAccount{MemoryTag::Tracks};     // The same, set with it
+    
+    // Swapped with std::atomic_store/atomic_load, never mutated in place
+    std::shared_ptr<const TrackPicture> m_snapshot;
+    quint64 m_snapshotSequence = 0;
 };
 
 } // namespace CounterUAS
 
+Q_DECLARE_METATYPE(CounterUAS::TrackThreatUpdate)
+
 #endif // TRACKMANAGER_H
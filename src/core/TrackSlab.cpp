@@ -0,0 +1,69 @@
+#include "core/TrackSlab.h"
+#include "utils/MemoryAccounting.h"
+#include <new>
+
+namespace CounterUAS {
+
+TrackSlab::~TrackSlab() {
+    for (Track* track : m_slots) {
+        track->~Track();
+    }
+    MemoryAccounting::released(MemoryTag::Tracks, qint64(m_chunks.size()) * CHUNK_BYTES, m_chunks.size());
+}
+
+Track* TrackSlab::acquire(const QString& trackId) {
+    if (m_freeSlots.isEmpty()) {
+        addChunk();
+    }
+    const int slot = m_freeSlots.takeLast();
+    Track* track = m_slots[slot];
+    track->recycle(trackId);
+    m_liveIndex[slot] = m_live.size();
+    m_live.append(track);
+    return track;
+}
+
+void TrackSlab::release(Track* track) {
+    const int slot = track->m_slot;
+    Q_ASSERT(slot >= 0 && slot < m_slots.size() && m_slots[slot] == track);
+    const int index = m_liveIndex[slot];
+    if (index < 0) return;
+
+    // Swap the last live track into the hole
+    Track* moved = m_live.last();
+    m_live[index] = moved;
+    m_liveIndex[moved->m_slot] = index;
+    m_live.removeLast();
+    m_liveIndex[slot] = -1;
+
+    track->disconnect();
+    track->unbindTable();
+    track->m_generation.fetch_add(1, std::memory_order_release);
+    m_freeSlots.append(slot);
+}
+
+void TrackSlab::clear() {
+    while (!m_live.isEmpty()) {
+        release(m_live.last());
+    }
+}
+
+void TrackSlab::addChunk() {
+    std::unique_ptr<Storage[]> chunk(new Storage[SLOTS_PER_CHUNK]);
+    const int first = m_slots.size();
+    m_slots.reserve(first + SLOTS_PER_CHUNK);
+    m_liveIndex.reserve(first + SLOTS_PER_CHUNK);
+    for (int i = 0; i < SLOTS_PER_CHUNK; ++i) {
+        Track* track = new (chunk[i].bytes) Track(QString());
+        track->m_slot = first + i;
+        m_slots.append(track);
+        m_liveIndex.append(-1);
+    }
+    for (int i = SLOTS_PER_CHUNK - 1; i >= 0; --i) {
+        m_freeSlots.append(first + i);
+    }
+    m_chunks.push_back(std::move(chunk));
+    MemoryAccounting::allocated(MemoryTag::Tracks, CHUNK_BYTES);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,67 @@
+#ifndef TRACKSLAB_H
+#define TRACKSLAB_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Recycled storage for the Track objects of one TrackManager
+ *
+ * Tracks are built in chunks of SLOTS_PER_CHUNK and are never deleted
+ * while the slab lives: a released track goes back on a free list and is
+ * handed out again, reset, for the next track, so clutter and swarm churn
+ * does not allocate or free QObjects. A Track* held past its track's drop
+ * therefore never dangles. Each reuse bumps the slot's generation, and a
+ * holder that noted Track::generation() when it took the pointer can tell
+ * the slot now carries another track.
+ *
+ * The live tracks are also kept in one dense array, in no particular
+ * order, for iteration. Slab tracks have no QObject parent; the slab
+ * destroys them. Owned and written by the TrackManager thread under its
+ * lock; not internally locked.
+ */
+class TrackSlab {
+public:
+    static constexpr int SLOTS_PER_CHUNK = 64;
+
+    TrackSlab() = default;
+    ~TrackSlab();
+    TrackSlab(const TrackSlab&) = delete;
+    TrackSlab& operator=(const TrackSlab&) = delete;
+
+    // A reset track with the given id, from the free list or a new chunk
+    Track* acquire(const QString& trackId);
+    // Back onto the free list: disconnects the track's signals, unbinds it
+    // from its table row and starts a new generation. The track must belong
+    // to this slab.
+    void release(Track* track);
+    // Releases every live track
+    void clear();
+
+    const QVector<Track*>& live() const { return m_live; }
+    int size() const { return m_live.size(); }
+    int capacity() const { return m_slots.size(); }
+
+private:
+    void addChunk();
+
+    struct alignas(Track) Storage {
+        unsigned char bytes[sizeof(Track)];
+    };
+    static constexpr qint64 CHUNK_BYTES = qint64(sizeof(Storage)) * SLOTS_PER_CHUNK;
+
+    std::vector<std::unique_ptr<Storage[]>> m_chunks;
+    QVector<Track*> m_slots;        // Slot -> its track, built once
+    QVector<int> m_liveIndex;       // Slot -> index in m_live, -1 when free
+    QVector<int> m_freeSlots;       // Popped from the back: the last released first
+    QVector<Track*> m_live;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKSLAB_H
@@ -0,0 +1,46 @@
+#include "core/TrackSnapshot.h"
+#include <QtMath>
+
+namespace CounterUAS {
+
+GeoPosition TrackSnapshot::predictedPosition(qint64 deltaMs) const {
+    double dt = deltaMs / 1000.0;
+    
+    // Same flat-earth extrapolation as Track::predictedPosition
+    const double metersPerDegreeLat = 111000.0;
+    double metersPerDegreeLon = 111000.0 * std::cos(qDegreesToRadians(position.latitude));
+    
+    GeoPosition predicted = position;
+    predicted.latitude += (velocity.north * dt) / metersPerDegreeLat;
+    predicted.longitude += (velocity.east * dt) / metersPerDegreeLon;
+    predicted.altitude -= velocity.down * dt;
+    
+    return predicted;
+}
+
+TrackSnapshot TrackSnapshot::fromTrack(const Track& track) {
+    TrackSnapshot snap;
+    snap.trackId = track.trackId();
+    snap.handle = track.handle();
+    snap.position = track.position();
+    snap.velocity = track.velocity();
+    snap.classification = track.classification();
+    snap.state = track.state();
+    snap.threatLevel = track.threatLevel();
+    snap.classificationConfidence = track.classificationConfidence();
+    snap.trackQuality = track.trackQuality();
+    snap.visuallyTracked = track.isVisuallyTracked();
+    snap.engaged = track.isEngaged();
+    snap.hasRFDetection = track.hasSource(DetectionSource::RFDetector);
+    snap.associatedCameraId = track.associatedCameraId();
+    const BoundingBox box = track.boundingBox();
+    if (box.isValid()) snap.boxTimestampMs = box.timestamp;
+    snap.lastUpdateMs = track.lastUpdateMs();
+    snap.ingestMonoNs = track.lastIngestMonoNs();
+    snap.receiveLagUs = track.receiveLagUs();
+    snap.groupId = track.groupId();
+    snap.groupSize = track.groupSize();
+    return snap;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,113 @@
+#ifndef TRACKSNAPSHOT_H
+#define TRACKSNAPSHOT_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Position error covariance of a track estimate, m^2
+ *
+ * The horizontal block in east/north and the vertical variance; the
+ * cross terms with altitude are left out. All zero when unknown.
+ */
+struct PositionCovariance {
+    double ee = 0.0;
+    double en = 0.0;
+    double nn = 0.0;
+    double uu = 0.0;
+
+    bool isValid() const { return ee > 0.0 && nn > 0.0 && ee * nn > en * en; }
+};
+
+/**
+ * @brief Immutable copy of the display-relevant state of one track
+ */
+struct TrackSnapshot {
+    QString trackId;
+    TrackHandle handle = INVALID_TRACK_HANDLE;
+    GeoPosition position;
+    VelocityVector velocity;
+    TrackClassification classification = TrackClassification::Unknown;
+    TrackState state = TrackState::Initiated;
+    int threatLevel = 1;
+    double classificationConfidence = 0.0;
+    double trackQuality = 0.0;
+    bool visuallyTracked = false;
+    bool engaged = false;
+    bool hasRFDetection = false;
+    QString associatedCameraId;
+    qint64 boxTimestampMs = 0;      // Of the last camera box, 0 if none
+    qint64 lastUpdateMs = 0;
+    qint64 ingestMonoNs = 0;        // Socket read of the newest fused plot, 0 if unknown
+    qint64 receiveLagUs = -1;       // Its measurement age at that read, -1 if unknown
+    PositionCovariance covariance;  // Filled by TrackManager from its filter
+    quint32 groupId = 0;            // TrackGroup the track moves in, 0 for none
+    int groupSize = 0;              // Its member count, 0 for none
+    
+    GeoPosition predictedPosition(qint64 deltaMs) const;
+    
+    static TrackSnapshot fromTrack(const Track& track);
+};
+
+/**
+ * @brief Tracks moving together, as TrackGroupIndex clusters them
+ *
+ * Ids are kept while the group persists: when one splits, the largest
+ * part keeps the id.
+ */
+struct TrackGroup {
+    quint32 groupId = 0;
+    QVector<TrackHandle> members;
+    GeoPosition centroid;
+    double extentM = 0.0;           // Farthest member from the centroid
+    VelocityVector velocity;        // Mean of the members'
+    qint64 formedMs = 0;
+    qint64 updatedMs = 0;           // Last time its membership or members moved
+};
+
+/**
+ * @brief Consistent picture of all tracks published once per track cycle
+ *
+ * A picture is never modified after it has been published, so readers on any
+ * thread may hold and iterate it without taking TrackManager or Track locks.
+ */
+struct TrackPicture {
+    quint64 sequence = 0;
+    qint64 timestampMs = 0;
+    // Newest plot in the picture, for latency accounting downstream
+    qint64 newestIngestNs = 0;
+    qint64 newestReceiveLagUs = -1;
+    QVector<TrackSnapshot> tracks;
+    QHash<QString, int> indexById;
+    QHash<TrackHandle, int> indexByHandle;
+    QVector<TrackGroup> groups;      // Empty unless TrackManager groups tracks
+    
+    const TrackSnapshot* find(const QString& trackId) const {
+        auto it = indexById.constFind(trackId);
+        return it != indexById.constEnd() ? &tracks[it.value()] : nullptr;
+    }
+    
+    const TrackSnapshot* find(TrackHandle handle) const {
+        auto it = indexByHandle.constFind(handle);
+        return it != indexByHandle.constEnd() ? &tracks[it.value()] : nullptr;
+    }
+    
+    // Linear; a picture holds a handful of groups
+    const TrackGroup* findGroup(quint32 groupId) const {
+        for (const TrackGroup& group : groups) {
+            if (group.groupId == groupId) return &group;
+        }
+        return nullptr;
+    }
+};
+
+using TrackPicturePtr = std::shared_ptr<const TrackPicture>;
+
+} // namespace CounterUAS
+
+#endif // TRACKSNAPSHOT_H
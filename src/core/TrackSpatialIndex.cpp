@@ -0,0 +1,121 @@
+#include "core/TrackSpatialIndex.h"
+#include "utils/CoordinateUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+TrackSpatialIndex::TrackSpatialIndex(double cellSizeM)
+    : m_cellSizeM(cellSizeM > 0.0 ? cellSizeM : 100.0)
+{
+}
+
+void TrackSpatialIndex::setCellSize(double cellSizeM) {
+    if (cellSizeM <= 0.0 || qFuzzyCompare(cellSizeM, m_cellSizeM)) return;
+
+    m_cellSizeM = cellSizeM;
+
+    // Rebucket everything under the new cell size
+    QHash<TrackHandle, Entry> entries = m_entries;
+    m_cells.clear();
+    m_entries.clear();
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        insert(it.key(), it.value().position);
+    }
+}
+
+void TrackSpatialIndex::insert(TrackHandle handle, const GeoPosition& pos) {
+    if (!m_hasOrigin) {
+        m_origin = pos;
+        m_origin.altitude = 0.0;
+        m_hasOrigin = true;
+    }
+
+    qint64 key = cellKeyFor(pos);
+
+    auto it = m_entries.find(handle);
+    if (it != m_entries.end()) {
+        it->position = pos;
+        if (it->cellKey == key) return;
+        detach(handle, it->cellKey);
+        it->cellKey = key;
+    } else {
+        Entry entry;
+        entry.cellKey = key;
+        entry.position = pos;
+        m_entries.insert(handle, entry);
+    }
+
+    m_cells[key].append(handle);
+}
+
+void TrackSpatialIndex::remove(TrackHandle handle) {
+    auto it = m_entries.find(handle);
+    if (it == m_entries.end()) return;
+
+    detach(handle, it->cellKey);
+    m_entries.erase(it);
+}
+
+void TrackSpatialIndex::clear() {
+    m_cells.clear();
+    m_entries.clear();
+    m_hasOrigin = false;
+}
+
+QVector<TrackHandle> TrackSpatialIndex::query(const GeoPosition& center, double radiusM) const {
+    QVector<TrackHandle> result;
+    query(center, radiusM, result);
+    return result;
+}
+
+void TrackSpatialIndex::query(const GeoPosition& center, double radiusM,
+                              QVector<TrackHandle>& result) const {
+    result.clear();
+    if (m_entries.isEmpty() || radiusM < 0.0) return;
+
+    QPointF local = CoordinateUtils::geoToLocal(center, m_origin);
+
+    // The east axis is scaled for the origin latitude; widen the search so
+    // the projection error away from the origin can't hide a neighbour.
+    double lonScale = CoordinateUtils::degToMeterLon(m_origin.latitude) /
+                      std::max(1.0, CoordinateUtils::degToMeterLon(center.latitude));
+    double radiusX = radiusM * std::max(1.0, lonScale);
+
+    int minX = static_cast<int>(std::floor((local.x() - radiusX) / m_cellSizeM));
+    int maxX = static_cast<int>(std::floor((local.x() + radiusX) / m_cellSizeM));
+    int minY = static_cast<int>(std::floor((local.y() - radiusM) / m_cellSizeM));
+    int maxY = static_cast<int>(std::floor((local.y() + radiusM) / m_cellSizeM));
+
+    for (int cx = minX; cx <= maxX; ++cx) {
+        for (int cy = minY; cy <= maxY; ++cy) {
+            auto cell = m_cells.constFind(packKey(cx, cy));
+            if (cell != m_cells.constEnd()) {
+                result += cell.value();
+            }
+        }
+    }
+}
+
+qint64 TrackSpatialIndex::cellKeyFor(const GeoPosition& pos) const {
+    QPointF local = CoordinateUtils::geoToLocal(pos, m_origin);
+    int cx = static_cast<int>(std::floor(local.x() / m_cellSizeM));
+    int cy = static_cast<int>(std::floor(local.y() / m_cellSizeM));
+    return packKey(cx, cy);
+}
+
+qint64 TrackSpatialIndex::packKey(int cx, int cy) {
+    return (static_cast<qint64>(cx) << 32) | static_cast<quint32>(cy);
+}
+
+void TrackSpatialIndex::detach(TrackHandle handle, qint64 cellKey) {
+    auto cell = m_cells.find(cellKey);
+    if (cell == m_cells.end()) return;
+
+    cell->removeOne(handle);
+    if (cell->isEmpty()) {
+        m_cells.erase(cell);
+    }
+}
+
+} // namespace CounterUAS
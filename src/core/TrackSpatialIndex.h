@@ -0,0 +1,61 @@
+#ifndef TRACKSPATIALINDEX_H
+#define TRACKSPATIALINDEX_H
+
+#include <QHash>
+#include <QVector>
+#include "core/Track.h"
+#include "core/TrackHandle.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Uniform grid index over track positions in local ENU meters
+ *
+ * Positions are projected onto a local tangent plane anchored at the first
+ * inserted position and bucketed into square cells. Queries return every
+ * handle stored in the cells overlapping the search circle, so callers must still
+ * apply an exact distance check to the candidates.
+ */
+class TrackSpatialIndex {
+public:
+    explicit TrackSpatialIndex(double cellSizeM = 100.0);
+
+    // Configuration (changing the cell size rebuckets existing entries)
+    void setCellSize(double cellSizeM);
+    double cellSize() const { return m_cellSizeM; }
+    GeoPosition origin() const { return m_origin; }
+
+    // Maintenance
+    void insert(TrackHandle handle, const GeoPosition& pos);  // Insert or move
+    void remove(TrackHandle handle);
+    void clear();
+
+    bool contains(TrackHandle handle) const { return m_entries.contains(handle); }
+    int size() const { return m_entries.size(); }
+
+    // Candidate handles within (at least) radiusM of center
+    QVector<TrackHandle> query(const GeoPosition& center, double radiusM) const;
+    // The same into a caller's buffer, which is cleared first and keeps its capacity
+    void query(const GeoPosition& center, double radiusM, QVector<TrackHandle>& out) const;
+
+private:
+    struct Entry {
+        qint64 cellKey = 0;
+        GeoPosition position;
+    };
+
+    qint64 cellKeyFor(const GeoPosition& pos) const;
+    static qint64 packKey(int cx, int cy);
+    void detach(TrackHandle handle, qint64 cellKey);
+
+    double m_cellSizeM;
+    GeoPosition m_origin;
+    bool m_hasOrigin = false;
+
+    QHash<qint64, QVector<TrackHandle>> m_cells;
+    QHash<TrackHandle, Entry> m_entries;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKSPATIALINDEX_H
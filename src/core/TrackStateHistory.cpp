@@ -0,0 +1,114 @@
+#include "core/TrackStateHistory.h"
+#include <QMutexLocker>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+double lerp(double a, double b, double t) {
+    return a + (b - a) * t;
+}
+
+// Between two states of one track, fraction t of the way from a
+TrackSnapshot interpolate(const TrackSnapshot& a, const TrackSnapshot& b, double t) {
+    TrackSnapshot state = t < 0.5 ? a : b;
+    state.position.latitude = lerp(a.position.latitude, b.position.latitude, t);
+    // The short way round the antimeridian
+    double longitude = a.position.longitude + std::remainder(b.position.longitude - a.position.longitude, 360.0) * t;
+    if (longitude > 180.0) longitude -= 360.0;
+    if (longitude < -180.0) longitude += 360.0;
+    state.position.longitude = longitude;
+    state.position.altitude = lerp(a.position.altitude, b.position.altitude, t);
+    state.velocity.north = lerp(a.velocity.north, b.velocity.north, t);
+    state.velocity.east = lerp(a.velocity.east, b.velocity.east, t);
+    state.velocity.down = lerp(a.velocity.down, b.velocity.down, t);
+    return state;
+}
+
+} // namespace
+
+TrackStateHistory::TrackStateHistory(int capacity)
+    : m_pictures(qMax(2, capacity))
+{
+}
+
+void TrackStateHistory::setCapacity(int pictures) {
+    QMutexLocker locker(&m_mutex);
+    m_pictures.setCapacity(qMax(2, pictures));
+}
+
+int TrackStateHistory::capacity() const {
+    QMutexLocker locker(&m_mutex);
+    return m_pictures.capacity();
+}
+
+void TrackStateHistory::record(const TrackPicturePtr& picture) {
+    if (!picture) return;
+    QMutexLocker locker(&m_mutex);
+    if (!m_pictures.isEmpty() && picture->timestampMs <= m_pictures.last()->timestampMs) return;
+    m_pictures.append(picture);
+}
+
+void TrackStateHistory::clear() {
+    QMutexLocker locker(&m_mutex);
+    // Releases the pictures rather than waiting for them to be overwritten
+    for (int i = 0; i < m_pictures.size(); ++i) m_pictures[i].reset();
+    m_pictures.clear();
+}
+
+bool TrackStateHistory::statesAt(qint64 timeMs, QVector<TrackSnapshot>& states) const {
+    states.clear();
+    TrackPicturePtr before;
+    TrackPicturePtr after;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pictures.isEmpty() || timeMs < m_pictures.first()->timestampMs) return false;
+
+        // The last picture at or before timeMs
+        int low = 0;
+        int high = m_pictures.size() - 1;
+        while (low < high) {
+            const int mid = (low + high + 1) / 2;
+            if (m_pictures.at(mid)->timestampMs <= timeMs) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        before = m_pictures.at(low);
+        if (low + 1 < m_pictures.size()) after = m_pictures.at(low + 1);
+    }
+
+    states.reserve(before->tracks.size());
+    const qint64 sinceBefore = timeMs - before->timestampMs;
+    const double t = after ? double(sinceBefore) / double(after->timestampMs - before->timestampMs) : 0.0;
+    for (const TrackSnapshot& track : before->tracks) {
+        const TrackSnapshot* next = after ? after->find(track.handle) : nullptr;
+        if (next) {
+            states.append(interpolate(track, *next, t));
+        } else {
+            // The newest picture, or a track gone by the next one
+            states.append(track);
+            states.last().position = track.predictedPosition(qMin(sinceBefore, MAX_EXTRAPOLATION_MS));
+        }
+    }
+    return true;
+}
+
+int TrackStateHistory::size() const {
+    QMutexLocker locker(&m_mutex);
+    return m_pictures.size();
+}
+
+qint64 TrackStateHistory::oldestMs() const {
+    QMutexLocker locker(&m_mutex);
+    return m_pictures.isEmpty() ? 0 : m_pictures.first()->timestampMs;
+}
+
+qint64 TrackStateHistory::newestMs() const {
+    QMutexLocker locker(&m_mutex);
+    return m_pictures.isEmpty() ? 0 : m_pictures.last()->timestampMs;
+}
+
+} // namespace CounterUAS
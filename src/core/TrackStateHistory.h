@@ -0,0 +1,55 @@
+#ifndef TRACKSTATEHISTORY_H
+#define TRACKSTATEHISTORY_H
+
+#include <QMutex>
+#include <QVector>
+#include "core/TrackSnapshot.h"
+#include "utils/RingBuffer.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Recent track pictures, for every track's state at a past time
+ *
+ * Keeps the last pictures TrackManager published, oldest first. Pictures
+ * are immutable and shared, so record() is a pointer copy and nothing here
+ * takes TrackManager's or a track's lock. statesAt() finds the pictures
+ * either side of a time by binary search and interpolates each track
+ * between the two, so a video frame captured a few hundred milliseconds
+ * ago can be drawn with the tracks where they were when it was taken.
+ * Past the newest picture the tracks are extrapolated, up to
+ * MAX_EXTRAPOLATION_MS.
+ *
+ * Safe from any thread; the lock covers only the ring, never the
+ * interpolation.
+ */
+class TrackStateHistory {
+public:
+    static constexpr int DEFAULT_CAPACITY = 64;            // A few seconds of track cycles
+    static constexpr qint64 MAX_EXTRAPOLATION_MS = 1000;
+
+    explicit TrackStateHistory(int capacity = DEFAULT_CAPACITY);
+
+    void setCapacity(int pictures);
+    int capacity() const;
+
+    // In publish order; one no newer than the last is ignored
+    void record(const TrackPicturePtr& picture);
+    void clear();
+
+    // A state per track alive at timeMs, by the picture at or before it.
+    // False before the oldest picture, when states is left empty
+    bool statesAt(qint64 timeMs, QVector<TrackSnapshot>& states) const;
+
+    int size() const;
+    qint64 oldestMs() const;    // 0 when empty
+    qint64 newestMs() const;
+
+private:
+    mutable QMutex m_mutex;
+    RingBuffer<TrackPicturePtr> m_pictures;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKSTATEHISTORY_H
@@ -0,0 +1,277 @@
+#include "core/TrackTable.h"
+
+namespace CounterUAS {
+
+int TrackTable::allocate() {
+    int row;
+    if (!m_freeRows.isEmpty()) {
+        row = m_freeRows.takeLast();
+    } else {
+        row = m_live.size();
+        m_lat.append(0.0);
+        m_lon.append(0.0);
+        m_alt.append(0.0);
+        m_east.append(0.0);
+        m_north.append(0.0);
+        m_up.append(0.0);
+        m_velN.append(0.0);
+        m_velE.append(0.0);
+        m_velD.append(0.0);
+        m_createdMs.append(0);
+        m_lastUpdateMs.append(0);
+        m_refreshDueMs.append(0);
+        m_quality.append(0.0f);
+        m_sourceMask.append(0);
+        m_dirty.append(0);
+        m_coastCount.append(0);
+        m_state.append(0);
+        m_classification.append(0);
+        m_threatLevel.append(0);
+        m_tier.append(0);
+        m_live.append(0);
+        m_classSlot.append(-1);
+        m_threatSlot.append(-1);
+    }
+
+    m_live[row] = 1;
+    m_dirty[row] = TrackChangeCreated;
+    m_tier[row] = static_cast<quint8>(TrackUpdateTier::Routine);
+    m_refreshDueMs[row] = 0;
+    m_liveCount++;
+
+    // Indexed as a fresh track until load() sets what it really is
+    m_state[row] = static_cast<quint8>(TrackState::Initiated);
+    m_classification[row] = static_cast<quint8>(TrackClassification::Unknown);
+    m_threatLevel[row] = 0;
+    m_stateCount[static_cast<int>(TrackState::Initiated)]++;
+    indexRow(row);
+    return row;
+}
+
+void TrackTable::release(int row) {
+    if (!isLive(row)) return;
+
+    unindexRow(row);
+    m_stateCount[m_state[row]]--;
+    m_live[row] = 0;
+    m_state[row] = static_cast<quint8>(TrackState::Dropped);
+    m_freeRows.append(row);
+    m_liveCount--;
+}
+
+void TrackTable::clear() {
+    m_lat.clear();
+    m_lon.clear();
+    m_alt.clear();
+    m_east.clear();
+    m_north.clear();
+    m_up.clear();
+    m_velN.clear();
+    m_velE.clear();
+    m_velD.clear();
+    m_createdMs.clear();
+    m_lastUpdateMs.clear();
+    m_refreshDueMs.clear();
+    m_quality.clear();
+    m_sourceMask.clear();
+    m_dirty.clear();
+    m_coastCount.clear();
+    m_state.clear();
+    m_classification.clear();
+    m_threatLevel.clear();
+    m_tier.clear();
+    m_live.clear();
+    m_freeRows.clear();
+    m_liveCount = 0;
+    for (QVector<int>& bucket : m_classRows) {
+        bucket.clear();
+    }
+    for (QVector<int>& bucket : m_threatRows) {
+        bucket.clear();
+    }
+    m_classSlot.clear();
+    m_threatSlot.clear();
+    m_stateCount.fill(0);
+}
+
+void TrackTable::setState(int row, TrackState state) {
+    const quint8 value = static_cast<quint8>(state);
+    const quint8 previous = m_state[row];
+    if (previous == value) return;
+    m_state[row] = value;
+    if (!m_live[row]) return;
+
+    m_stateCount[previous]--;
+    m_stateCount[value]++;
+    const quint8 dropped = static_cast<quint8>(TrackState::Dropped);
+    if (value == dropped) {
+        unindexRow(row);
+    } else if (previous == dropped) {
+        indexRow(row);
+    }
+}
+
+void TrackTable::setClassification(int row, TrackClassification cls) {
+    const quint8 value = static_cast<quint8>(cls);
+    if (m_classification[row] == value) return;
+    if (m_classSlot[row] < 0) {
+        m_classification[row] = value;
+        return;
+    }
+    unindexRow(row);
+    m_classification[row] = value;
+    indexRow(row);
+}
+
+void TrackTable::setThreatLevel(int row, int level) {
+    const qint8 value = static_cast<qint8>(level);
+    if (m_threatLevel[row] == value) return;
+    if (m_threatSlot[row] < 0) {
+        m_threatLevel[row] = value;
+        return;
+    }
+    unindexRow(row);
+    m_threatLevel[row] = value;
+    indexRow(row);
+}
+
+void TrackTable::rowsByThreatLevel(int minLevel, QVector<int>& out) const {
+    for (int bucket = THREAT_BUCKETS - 1; bucket >= qMax(0, minLevel); --bucket) {
+        out += m_threatRows[bucket];
+    }
+}
+
+void TrackTable::indexRow(int row) {
+    QVector<int>& byClass = m_classRows[m_classification[row]];
+    m_classSlot[row] = byClass.size();
+    byClass.append(row);
+    QVector<int>& byThreat = m_threatRows[threatBucket(m_threatLevel[row])];
+    m_threatSlot[row] = byThreat.size();
+    byThreat.append(row);
+}
+
+void TrackTable::unindexRow(int row) {
+    if (m_classSlot[row] < 0) return;
+
+    // The bucket's last row takes the leaving row's place
+    auto take = [row](QVector<int>& bucket, QVector<int>& slots) {
+        const int slot = slots[row];
+        const int last = bucket.last();
+        bucket[slot] = last;
+        slots[last] = slot;
+        bucket.removeLast();
+        slots[row] = -1;
+    };
+    take(m_classRows[m_classification[row]], m_classSlot);
+    take(m_threatRows[threatBucket(m_threatLevel[row])], m_threatSlot);
+}
+
+void TrackTable::load(int row, const Track& track) {
+    if (!isLive(row)) return;
+
+    setPosition(row, track.position());
+    setVelocity(row, track.velocity());
+    setState(row, track.state());
+    setClassification(row, track.classification());
+    setThreatLevel(row, track.threatLevel());
+    setCoastCount(row, track.coastCount());
+    setQuality(row, track.trackQuality());
+    m_createdMs[row] = track.createdMs();
+    m_lastUpdateMs[row] = track.lastUpdateMs();
+
+    quint32 mask = 0;
+    for (DetectionSource source : track.detectionSources()) {
+        mask |= sourceBit(source);
+    }
+    m_sourceMask[row] = mask;
+}
+
+void TrackTable::setFrameOrigin(const GeoPosition& origin) {
+    m_frame.setOrigin(origin);
+    m_frame.toEnu(m_lat.constData(), m_lon.constData(), m_alt.constData(),
+                  m_east.data(), m_north.data(), m_up.data(), m_lat.size());
+}
+
+void TrackTable::setPosition(int row, const GeoPosition& pos) {
+    m_lat[row] = pos.latitude;
+    m_lon[row] = pos.longitude;
+    m_alt[row] = pos.altitude;
+    const EnuVector enu = m_frame.toEnu(pos);
+    m_east[row] = enu.east;
+    m_north[row] = enu.north;
+    m_up[row] = enu.up;
+}
+
+void TrackTable::setVelocity(int row, const VelocityVector& vel) {
+    m_velN[row] = vel.north;
+    m_velE[row] = vel.east;
+    m_velD[row] = vel.down;
+}
+
+GeoPosition TrackTable::position(int row) const {
+    GeoPosition pos;
+    pos.latitude = m_lat[row];
+    pos.longitude = m_lon[row];
+    pos.altitude = m_alt[row];
+    return pos;
+}
+
+VelocityVector TrackTable::velocity(int row) const {
+    VelocityVector vel;
+    vel.north = m_velN[row];
+    vel.east = m_velE[row];
+    vel.down = m_velD[row];
+    return vel;
+}
+
+int TrackTable::lifecyclePass(qint64 nowMs, int coastingTimeoutMs, int dropTimeoutMs,
+                              int maxCoastCount, QVector<LifecycleTransition>& out) const {
+    const int rows = m_live.size();
+    const quint8* live = m_live.constData();
+    const quint8* state = m_state.constData();
+    const qint64* lastUpdate = m_lastUpdateMs.constData();
+    const quint16* coast = m_coastCount.constData();
+
+    const quint8 initiated = static_cast<quint8>(TrackState::Initiated);
+    const quint8 active = static_cast<quint8>(TrackState::Active);
+    const quint8 coasting = static_cast<quint8>(TrackState::Coasting);
+
+    int coastingCount = 0;
+
+    for (int row = 0; row < rows; ++row) {
+        if (!live[row]) continue;
+
+        const qint64 age = nowMs - lastUpdate[row];
+        const quint8 s = state[row];
+        LifecycleAction action = LifecycleAction::None;
+
+        if (s == active) {
+            if (age > coastingTimeoutMs) {
+                action = LifecycleAction::StartCoasting;
+                coastingCount++;
+            }
+        } else if (s == coasting) {
+            if (age > dropTimeoutMs || coast[row] > maxCoastCount) {
+                action = LifecycleAction::Drop;
+            } else {
+                action = LifecycleAction::ContinueCoast;
+                coastingCount++;
+            }
+        } else if (s == initiated) {
+            if (age < coastingTimeoutMs) {
+                action = LifecycleAction::Activate;
+            }
+        }
+
+        if (action != LifecycleAction::None) {
+            LifecycleTransition transition;
+            transition.row = row;
+            transition.action = action;
+            out.append(transition);
+        }
+    }
+
+    return coastingCount;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,290 @@
+#ifndef TRACKTABLE_H
+#define TRACKTABLE_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "core/Track.h"
+#include "core/TrackChangeSet.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Lifecycle action decided by TrackTable::lifecyclePass
+ */
+enum class LifecycleAction : quint8 {
+    None = 0,
+    Activate,        // Initiated -> Active
+    StartCoasting,   // Active -> Coasting
+    ContinueCoast,   // Coasting, one more coast cycle
+    Drop             // Coasting -> Dropped
+};
+
+/**
+ * @brief How often a track is refreshed and reassessed, set by ThreatAssessor
+ */
+enum class TrackUpdateTier : quint8 {
+    Priority = 0,    // Every cycle at priorityRateHz: high threat, hostile or about to arrive
+    Routine,         // At updateRateHz
+    Background       // At backgroundRateHz: low threat and far out
+};
+
+struct LifecycleTransition {
+    int row = -1;
+    LifecycleAction action = LifecycleAction::None;
+};
+
+/**
+ * @brief Gate and normalisation limits for TrackTable::scoreCandidates
+ */
+struct CorrelationGate {
+    double distanceM = 100.0;      // Plots further out are not scored
+    double velocityMps = 10.0;     // Velocity difference at which the velocity term bottoms out
+    int coastingTimeoutMs = 5000;  // Age at which the recency term drops to its floor
+    EnuVector lineOfSight;         // Unit bearing of an angle-only plot, zero when it has none
+};
+
+/**
+ * @brief Measurement model of a plot that measures position and velocity
+ *
+ * The default for TrackTable::scoreCandidates. A model is a set of
+ * compile-time traits: MEASURES_VELOCITY, false for plots that carry no
+ * velocity, scores the velocity term as agreeing instead of against a zero
+ * vector; LINE_OF_SIGHT weights the miss along CorrelationGate::lineOfSight
+ * by RANGE_WEIGHT, for plots whose range is a guess on an angle.
+ */
+struct PositionVelocityModel {
+    static constexpr bool MEASURES_VELOCITY = true;
+    static constexpr bool LINE_OF_SIGHT = false;
+    static constexpr double RANGE_WEIGHT = 1.0;
+};
+
+struct CorrelationCandidate {
+    int index = -1;                // Into the rows passed to scoreCandidates
+    double score = 0.0;
+};
+
+/**
+ * @brief Structure-of-arrays store for the hot per-track state
+ *
+ * Every live Track owned by TrackManager is bound to one row. Track setters
+ * write through to their row, so the columns are always current and the
+ * per-cycle lifecycle and correlation passes can walk contiguous arrays
+ * instead of chasing QObject pointers and taking per-track mutexes.
+ *
+ * Positions are also kept in the table's ENU frame, so correlation is
+ * subtract-and-hypot against the frame coordinates of the plot.
+ *
+ * The state, classification and threat level setters also keep secondary
+ * indexes over live rows that are not Dropped: a bucket of rows per
+ * classification and per threat level, each row knowing its place in its
+ * buckets so a change moves it in O(1), and a count of live rows per state.
+ * Queries by classification or threat level then cost their result, not a
+ * walk of the table.
+ *
+ * Rows are dense integers recycled through a free list. The table is owned
+ * and written by the TrackManager thread; it is not internally locked.
+ */
+class TrackTable {
+public:
+    TrackTable() = default;
+
+    // Row management
+    int allocate();
+    void release(int row);
+    void clear();
+
+    int capacity() const { return m_live.size(); }
+    int liveCount() const { return m_liveCount; }
+    bool isLive(int row) const { return row >= 0 && row < m_live.size() && m_live[row]; }
+
+    // Load the full state of a track into its row
+    void load(int row, const Track& track);
+
+    // Re-anchors the ENU columns; every row is converted again
+    void setFrameOrigin(const GeoPosition& origin);
+    const LocalTangentPlane& frame() const { return m_frame; }
+
+    // Column setters (called from Track write-through)
+    void setPosition(int row, const GeoPosition& pos);
+    void setVelocity(int row, const VelocityVector& vel);
+    void setState(int row, TrackState state);
+    void setClassification(int row, TrackClassification cls);
+    void setThreatLevel(int row, int level);
+    void setLastUpdateMs(int row, qint64 ms) { m_lastUpdateMs[row] = ms; }
+    void setCoastCount(int row, int count) { m_coastCount[row] = static_cast<quint16>(qBound(0, count, 0xFFFF)); }
+    void setQuality(int row, double quality) { m_quality[row] = static_cast<float>(quality); }
+    void setSourceMask(int row, quint32 mask) { m_sourceMask[row] = mask; }
+    void setUpdateTier(int row, TrackUpdateTier tier) { m_tier[row] = static_cast<quint8>(tier); }
+    void setRefreshDueMs(int row, qint64 ms) { m_refreshDueMs[row] = ms; }
+
+    // Dirty bits (TrackChangeField) accumulated since the last takeDirty()
+    void markDirty(int row, quint32 fields) { m_dirty[row] |= fields; }
+    quint32 dirty(int row) const { return m_dirty[row]; }
+    quint32 takeDirty(int row) { quint32 fields = m_dirty[row]; m_dirty[row] = 0; return fields; }
+
+    // Column readers
+    GeoPosition position(int row) const;
+    EnuVector enuPosition(int row) const { return EnuVector{m_east[row], m_north[row], m_up[row]}; }
+    VelocityVector velocity(int row) const;
+    TrackState state(int row) const { return static_cast<TrackState>(m_state[row]); }
+    TrackClassification classification(int row) const { return static_cast<TrackClassification>(m_classification[row]); }
+    int threatLevel(int row) const { return m_threatLevel[row]; }
+    qint64 createdMs(int row) const { return m_createdMs[row]; }
+    qint64 lastUpdateMs(int row) const { return m_lastUpdateMs[row]; }
+    int coastCount(int row) const { return m_coastCount[row]; }
+    double quality(int row) const { return m_quality[row]; }
+    quint32 sourceMask(int row) const { return m_sourceMask[row]; }
+    TrackUpdateTier updateTier(int row) const { return static_cast<TrackUpdateTier>(m_tier[row]); }
+    qint64 refreshDueMs(int row) const { return m_refreshDueMs[row]; }  // Background rows' next report
+
+    static quint32 sourceBit(DetectionSource source) { return 1u << static_cast<int>(source); }
+
+    // Secondary indexes, over live rows that are not Dropped. Bucket order
+    // is arbitrary; rowsByThreatLevel() appends highest level first.
+    const QVector<int>& rowsWithClassification(TrackClassification cls) const {
+        return m_classRows[static_cast<int>(cls)];
+    }
+    void rowsByThreatLevel(int minLevel, QVector<int>& out) const;
+    int stateCount(TrackState state) const { return m_stateCount[static_cast<int>(state)]; }  // Live rows
+
+    /**
+     * Single pass over the state/timestamp/coast columns applying the
+     * TrackManager lifecycle rules. Only rows that need an action are
+     * appended to @p out; the table itself is not modified.
+     * @return number of live rows currently Coasting (after the pass)
+     */
+    int lifecyclePass(qint64 nowMs, int coastingTimeoutMs, int dropTimeoutMs,
+                      int maxCoastCount, QVector<LifecycleTransition>& out) const;
+
+    /**
+     * Scores one plot, in the table's ENU frame, against @p count candidate
+     * rows. Each block of CORRELATION_BLOCK rows is gathered from the
+     * columns and gated on squared distance and state first; only the rows
+     * inside the gate are scored, in a branch-free loop over the gathered
+     * block. Appends every gated row with its score to @p out.
+     *
+     * Model is the plot's measurement model (see PositionVelocityModel);
+     * its traits are resolved at compile time, so each model gets a kernel
+     * of its own with nothing it does not measure in the loop.
+     */
+    template <typename Model = PositionVelocityModel>
+    void scoreCandidates(const int* rows, int count, const EnuVector& position,
+                         const VelocityVector& velocity, qint64 nowMs,
+                         const CorrelationGate& gate, QVector<CorrelationCandidate>& out) const;
+
+    static constexpr int CORRELATION_BLOCK = 16;
+
+private:
+    QVector<double> m_lat;
+    QVector<double> m_lon;
+    QVector<double> m_alt;
+    QVector<double> m_east;
+    QVector<double> m_north;
+    QVector<double> m_up;
+    QVector<double> m_velN;
+    QVector<double> m_velE;
+    QVector<double> m_velD;
+    QVector<qint64> m_createdMs;
+    QVector<qint64> m_lastUpdateMs;
+    QVector<qint64> m_refreshDueMs;
+    QVector<float> m_quality;
+    QVector<quint32> m_sourceMask;
+    QVector<quint32> m_dirty;
+    QVector<quint16> m_coastCount;
+    QVector<quint8> m_state;
+    QVector<quint8> m_classification;
+    QVector<qint8> m_threatLevel;
+    QVector<quint8> m_tier;
+    QVector<quint8> m_live;
+
+    QVector<int> m_freeRows;
+    int m_liveCount = 0;
+    LocalTangentPlane m_frame;
+
+    static constexpr int CLASSIFICATIONS = static_cast<int>(TrackClassification::Neutral) + 1;
+    static constexpr int THREAT_BUCKETS = 6;    // Levels 0-5; rows start at 0 until loaded
+    static constexpr int STATES = static_cast<int>(TrackState::Dropped) + 1;
+    static int threatBucket(int level) { return qBound(0, level, THREAT_BUCKETS - 1); }
+    void indexRow(int row);
+    void unindexRow(int row);
+
+    std::array<QVector<int>, CLASSIFICATIONS> m_classRows;
+    std::array<QVector<int>, THREAT_BUCKETS> m_threatRows;
+    QVector<int> m_classSlot;     // Row -> place in its class bucket, -1 when not indexed
+    QVector<int> m_threatSlot;    // Row -> place in its threat bucket
+    std::array<int, STATES> m_stateCount{};
+};
+
+template <typename Model>
+void TrackTable::scoreCandidates(const int* rows, int count, const EnuVector& position,
+                                 const VelocityVector& velocity, qint64 nowMs,
+                                 const CorrelationGate& gate, QVector<CorrelationCandidate>& out) const {
+    const double gateSquared = gate.distanceM * gate.distanceM;
+    const double distanceScale = 1.0 / gate.distanceM;
+    const double velocityScale = 1.0 / (2.0 * gate.velocityMps);
+    const double ageScale = 0.5 / gate.coastingTimeoutMs;
+    const double coastAge = gate.coastingTimeoutMs;
+    const double rangeDiscount = 1.0 - Model::RANGE_WEIGHT * Model::RANGE_WEIGHT;
+    const quint8 dropped = static_cast<quint8>(TrackState::Dropped);
+
+    for (int base = 0; base < count; base += CORRELATION_BLOCK) {
+        const int n = qMin(CORRELATION_BLOCK, count - base);
+
+        // Gather and gate; every lane is written and the kept count only
+        // advances for rows inside the gate
+        int index[CORRELATION_BLOCK];
+        double distanceSq[CORRELATION_BLOCK];
+        double velocitySq[CORRELATION_BLOCK];
+        double age[CORRELATION_BLOCK];
+        int kept = 0;
+        for (int i = 0; i < n; ++i) {
+            const int row = rows[base + i];
+            const double de = m_east[row] - position.east;
+            const double dn = m_north[row] - position.north;
+            const double du = m_up[row] - position.up;
+
+            index[kept] = base + i;
+            distanceSq[kept] = de * de + dn * dn + du * du;
+            if constexpr (Model::LINE_OF_SIGHT) {
+                // Only RANGE_WEIGHT of the miss along the bearing counts
+                const double along = de * gate.lineOfSight.east + dn * gate.lineOfSight.north +
+                                     du * gate.lineOfSight.up;
+                distanceSq[kept] -= rangeDiscount * along * along;
+            }
+            if constexpr (Model::MEASURES_VELOCITY) {
+                const double dvn = m_velN[row] - velocity.north;
+                const double dve = m_velE[row] - velocity.east;
+                const double dvd = m_velD[row] - velocity.down;
+                velocitySq[kept] = dvn * dvn + dve * dve + dvd * dvd;
+            } else {
+                velocitySq[kept] = 0.0;
+            }
+            age[kept] = static_cast<double>(nowMs - m_lastUpdateMs[row]);
+            kept += (distanceSq[kept] <= gateSquared) & (m_state[row] != dropped);
+        }
+
+        // Distance, velocity and recency terms, weighted 0.5/0.3/0.2. Inside
+        // the gate the distance term is never negative, and the velocity
+        // term floors at 0.5 where its ramp reaches it.
+        double score[CORRELATION_BLOCK];
+        for (int i = 0; i < kept; ++i) {
+            const double distanceScore = 1.0 - std::sqrt(std::max(distanceSq[i], 0.0)) * distanceScale;
+            const double velocityScore =
+                1.0 - std::min(std::sqrt(velocitySq[i]), gate.velocityMps) * velocityScale;
+            const double timeScore = age[i] > coastAge ? 0.3 : 1.0 - age[i] * ageScale;
+            score[i] = distanceScore * 0.5 + velocityScore * 0.3 + timeScore * 0.2;
+        }
+
+        for (int i = 0; i < kept; ++i) {
+            out.append(CorrelationCandidate{index[i], score[i]});
+        }
+    }
+}
+
+} // namespace CounterUAS
+
+#endif // TRACKTABLE_H
@@ -0,0 +1,370 @@
+#include "core/TrackToTrackFusion.h"
+#include "core/TrackManager.h"
+#include "core/TrackSpatialIndex.h"
+#include <QSet>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace CounterUAS {
+
+namespace {
+
+// Inverse of the horizontal block as [a b; b c]
+bool invertHorizontal(const PositionCovariance& p, double& a, double& b, double& c) {
+    const double det = p.ee * p.nn - p.en * p.en;
+    if (!(det > 0.0)) return false;
+    a = p.nn / det;
+    b = -p.en / det;
+    c = p.ee / det;
+    return true;
+}
+
+bool sameFusedState(const SystemTrack& a, const SystemTrack& b) {
+    const TrackSnapshot& x = a.fused;
+    const TrackSnapshot& y = b.fused;
+    return a.members == b.members &&
+           x.position.latitude == y.position.latitude &&
+           x.position.longitude == y.position.longitude &&
+           x.position.altitude == y.position.altitude &&
+           x.velocity.north == y.velocity.north && x.velocity.east == y.velocity.east &&
+           x.velocity.down == y.velocity.down &&
+           x.covariance.ee == y.covariance.ee && x.covariance.en == y.covariance.en &&
+           x.covariance.nn == y.covariance.nn && x.covariance.uu == y.covariance.uu &&
+           x.classification == y.classification && x.state == y.state &&
+           x.threatLevel == y.threatLevel && x.engaged == y.engaged;
+}
+
+} // namespace
+
+TrackToTrackFusion::TrackToTrackFusion(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<SystemTrack>("SystemTrack");
+}
+
+void TrackToTrackFusion::setTrackManager(TrackManager* trackManager) {
+    if (m_trackManager) {
+        QObject::disconnect(m_trackManager, nullptr, this, nullptr);
+    }
+    m_trackManager = trackManager;
+
+    if (m_trackManager) {
+        connect(m_trackManager, &TrackManager::snapshotPublished, this, [this]() {
+            if (m_trackManager) setLocalPicture(m_trackManager->snapshot());
+        });
+        setLocalPicture(m_trackManager->snapshot());
+    } else {
+        setLocalPicture(TrackPicturePtr());
+    }
+}
+
+void TrackToTrackFusion::setLocalPicture(const TrackPicturePtr& picture) {
+    m_local = picture;
+    scheduleFuse();
+}
+
+void TrackToTrackFusion::updateRemoteTrack(const QString& nodeId, const TrackSnapshot& track) {
+    m_remote[nodeId].insert(track.trackId, track);
+    scheduleFuse();
+}
+
+void TrackToTrackFusion::dropRemoteTrack(const QString& nodeId, const QString& trackId) {
+    auto node = m_remote.find(nodeId);
+    if (node == m_remote.end() || node->remove(trackId) == 0) return;
+    if (node->isEmpty()) m_remote.erase(node);
+    scheduleFuse();
+}
+
+void TrackToTrackFusion::dropRemoteNode(const QString& nodeId) {
+    if (m_remote.remove(nodeId) > 0) scheduleFuse();
+}
+
+void TrackToTrackFusion::scheduleFuse() {
+    if (m_fusePending) return;
+    m_fusePending = true;
+    QTimer::singleShot(0, this, [this]() {
+        if (m_fusePending) fuse();
+    });
+}
+
+QString TrackToTrackFusion::systemTrackIdFor(const QString& nodeId, const QString& trackId) const {
+    return m_systemIdByMember.value(nodeId + QLatin1Char('/') + trackId);
+}
+
+PositionCovariance TrackToTrackFusion::flooredCovariance(const PositionCovariance& cov) const {
+    const double floor = m_config.minSigmaM * m_config.minSigmaM;
+    if (!cov.isValid()) {
+        // Nothing usable sent: treat as a loose plot rather than a perfect one
+        PositionCovariance loose;
+        loose.ee = loose.nn = loose.uu = qMax(floor, 100.0);
+        return loose;
+    }
+    PositionCovariance floored = cov;
+    floored.ee = qMax(cov.ee, floor);
+    floored.nn = qMax(cov.nn, floor);
+    floored.uu = qMax(cov.uu, floor);
+    return floored;
+}
+
+double TrackToTrackFusion::mahalanobisSquared(const EnuVector& a, const PositionCovariance& pa,
+                                              const EnuVector& b, const PositionCovariance& pb) {
+    PositionCovariance sum;
+    sum.ee = pa.ee + pb.ee;
+    sum.en = pa.en + pb.en;
+    sum.nn = pa.nn + pb.nn;
+    double i11, i12, i22;
+    if (!invertHorizontal(sum, i11, i12, i22)) return std::numeric_limits<double>::infinity();
+
+    const double de = b.east - a.east;
+    const double dn = b.north - a.north;
+    return i11 * de * de + 2.0 * i12 * de * dn + i22 * dn * dn;
+}
+
+double TrackToTrackFusion::covarianceIntersection(const EnuVector& a, const PositionCovariance& pa,
+                                                  const EnuVector& b, const PositionCovariance& pb,
+                                                  EnuVector& fused, PositionCovariance& fusedCov) {
+    double a11, a12, a22, b11, b12, b22;
+    if (!invertHorizontal(pa, a11, a12, a22)) {
+        fused = b;
+        fusedCov = pb;
+        return 0.0;
+    }
+    if (!invertHorizontal(pb, b11, b12, b22)) {
+        fused = a;
+        fusedCov = pa;
+        return 1.0;
+    }
+
+    // The fused information is w A + (1 - w) B = B + w D. Its determinant
+    // is quadratic in w; the largest one is the smallest fused covariance.
+    const double d11 = a11 - b11, d12 = a12 - b12, d22 = a22 - b22;
+    const double c0 = b11 * b22 - b12 * b12;
+    const double c1 = b11 * d22 + b22 * d11 - 2.0 * b12 * d12;
+    const double c2 = d11 * d22 - d12 * d12;
+    auto det = [&](double w) { return c0 + w * (c1 + w * c2); };
+
+    double w = det(1.0) > det(0.0) ? 1.0 : 0.0;
+    if (c1 == 0.0 && c2 == 0.0) {
+        w = 0.5;   // Equal information: the plain average
+    } else if (c2 < 0.0) {
+        const double vertex = -c1 / (2.0 * c2);
+        if (vertex > 0.0 && vertex < 1.0 && det(vertex) > det(w)) w = vertex;
+    }
+
+    const double m11 = b11 + w * d11, m12 = b12 + w * d12, m22 = b22 + w * d22;
+    const double detM = m11 * m22 - m12 * m12;
+    PositionCovariance cov;
+    cov.ee = m22 / detM;
+    cov.en = -m12 / detM;
+    cov.nn = m11 / detM;
+
+    const double ye = w * (a11 * a.east + a12 * a.north) + (1.0 - w) * (b11 * b.east + b12 * b.north);
+    const double yn = w * (a12 * a.east + a22 * a.north) + (1.0 - w) * (b12 * b.east + b22 * b.north);
+    EnuVector x;
+    x.east = cov.ee * ye + cov.en * yn;
+    x.north = cov.en * ye + cov.nn * yn;
+
+    if (pa.uu > 0.0 && pb.uu > 0.0) {
+        const double information = w / pa.uu + (1.0 - w) / pb.uu;
+        cov.uu = 1.0 / information;
+        x.up = cov.uu * (w * a.up / pa.uu + (1.0 - w) * b.up / pb.uu);
+    } else {
+        cov.uu = qMax(pa.uu, pb.uu);
+        x.up = w * a.up + (1.0 - w) * b.up;
+    }
+
+    fused = x;
+    fusedCov = cov;
+    return w;
+}
+
+SystemTrack TrackToTrackFusion::fuseCluster(const QVector<Member>& members, const QVector<int>& indices,
+                                            const LocalTangentPlane& frame) const {
+    const Member& first = members[indices.first()];
+    EnuVector position = first.position;
+    PositionCovariance covariance = first.covariance;
+    VelocityVector velocity = first.track->velocity;
+
+    SystemTrack system;
+    system.systemTrackId = first.key;   // Indices come smallest key first
+    const TrackSnapshot* primary = first.track;
+    const TrackSnapshot* classified = first.track;
+    int threatLevel = first.track->threatLevel;
+    double quality = first.track->trackQuality;
+    qint64 lastUpdateMs = first.track->lastUpdateMs;
+    bool engaged = first.track->engaged;
+    bool visual = first.track->visuallyTracked;
+    bool rf = first.track->hasRFDetection;
+
+    for (int k = 0; k < indices.size(); ++k) {
+        const Member& m = members[indices[k]];
+        system.members.append(m.key);
+        if (m.nodeId == m_nodeId) {
+            system.localTrackId = m.track->trackId;
+            primary = m.track;
+        }
+        if (k == 0) continue;
+
+        const double w = covarianceIntersection(position, covariance, m.position, m.covariance,
+                                                position, covariance);
+        velocity.north = w * velocity.north + (1.0 - w) * m.track->velocity.north;
+        velocity.east = w * velocity.east + (1.0 - w) * m.track->velocity.east;
+        velocity.down = w * velocity.down + (1.0 - w) * m.track->velocity.down;
+
+        if (m.track->classificationConfidence > classified->classificationConfidence) {
+            classified = m.track;
+        }
+        threatLevel = qMax(threatLevel, m.track->threatLevel);
+        quality = qMax(quality, m.track->trackQuality);
+        lastUpdateMs = qMax(lastUpdateMs, m.track->lastUpdateMs);
+        engaged = engaged || m.track->engaged;
+        visual = visual || m.track->visuallyTracked;
+        rf = rf || m.track->hasRFDetection;
+    }
+
+    // Lifecycle and local bookkeeping follow our own track when there is one
+    system.fused = *primary;
+    system.fused.trackId = system.systemTrackId;
+    system.fused.handle = INVALID_TRACK_HANDLE;
+    system.fused.position = frame.toGeoLinear(position);
+    system.fused.velocity = velocity;
+    system.fused.covariance = covariance;
+    system.fused.classification = classified->classification;
+    system.fused.classificationConfidence = classified->classificationConfidence;
+    system.fused.threatLevel = threatLevel;
+    system.fused.trackQuality = quality;
+    system.fused.lastUpdateMs = lastUpdateMs;
+    system.fused.engaged = engaged;
+    system.fused.visuallyTracked = visual;
+    system.fused.hasRFDetection = rf;
+    return system;
+}
+
+void TrackToTrackFusion::fuse() {
+    m_fusePending = false;
+    ++m_stats.passes;
+
+    QVector<Member> members;
+    if (m_local) {
+        members.reserve(m_local->tracks.size());
+        for (const TrackSnapshot& track : m_local->tracks) {
+            if (track.state == TrackState::Dropped) continue;
+            members.append({m_nodeId + QLatin1Char('/') + track.trackId, m_nodeId, &track, {}, {}});
+        }
+    }
+    int remoteCount = 0;
+    for (auto node = m_remote.constBegin(); node != m_remote.constEnd(); ++node) {
+        // Our own id is an echo of our picture or a misconfigured peer;
+        // either would collide with the local members
+        if (node.key() == m_nodeId) continue;
+        for (const TrackSnapshot& track : node.value()) {
+            if (track.state == TrackState::Dropped) continue;
+            members.append({node.key() + QLatin1Char('/') + track.trackId, node.key(), &track, {}, {}});
+            ++remoteCount;
+        }
+    }
+
+    // Keyed order makes every node that holds the same tracks fold them alike
+    std::sort(members.begin(), members.end(), [](const Member& a, const Member& b) {
+        return a.key < b.key;
+    });
+
+    QHash<QString, SystemTrack> systemTracks;
+    QHash<QString, QString> systemIdByMember;
+
+    if (!members.isEmpty()) {
+        const LocalTangentPlane frame(members.first().track->position);
+        TrackSpatialIndex index(m_config.searchRadiusM);
+        for (int i = 0; i < members.size(); ++i) {
+            Member& m = members[i];
+            m.position = frame.toEnuLinear(m.track->position);
+            m.covariance = flooredCovariance(m.track->covariance);
+            index.insert(static_cast<TrackHandle>(i + 1), m.track->position);
+        }
+
+        struct Pair {
+            double distanceSq;
+            int i;
+            int j;
+        };
+        QVector<Pair> pairs;
+        QVector<TrackHandle> candidates;
+        for (int i = 0; i < members.size(); ++i) {
+            index.query(members[i].track->position, m_config.searchRadiusM, candidates);
+            for (TrackHandle handle : candidates) {
+                const int j = static_cast<int>(handle) - 1;
+                if (j <= i || members[j].nodeId == members[i].nodeId) continue;
+                const double d2 = mahalanobisSquared(members[i].position, members[i].covariance,
+                                                     members[j].position, members[j].covariance);
+                if (d2 <= m_config.gateChiSquare) pairs.append({d2, i, j});
+            }
+        }
+        std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) {
+            if (a.distanceSq != b.distanceSq) return a.distanceSq < b.distanceSq;
+            return a.i != b.i ? a.i < b.i : a.j < b.j;
+        });
+
+        // Closest pairs join first; each root holds the nodes of its cluster
+        QVector<int> parent(members.size());
+        std::iota(parent.begin(), parent.end(), 0);
+        QVector<QSet<QString>> nodes(members.size());
+        for (int i = 0; i < members.size(); ++i) {
+            nodes[i].insert(members[i].nodeId);
+        }
+        auto root = [&parent](int i) {
+            while (parent[i] != i) {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        };
+        for (const Pair& pair : qAsConst(pairs)) {
+            int a = root(pair.i);
+            int b = root(pair.j);
+            if (a == b || nodes[a].intersects(nodes[b])) continue;
+            if (nodes[a].size() < nodes[b].size()) std::swap(a, b);
+            parent[b] = a;
+            nodes[a].unite(nodes[b]);
+            nodes[b].clear();
+        }
+
+        // Members were sorted by key, so each cluster lists its smallest first
+        QHash<int, QVector<int>> clusters;
+        for (int i = 0; i < members.size(); ++i) {
+            clusters[root(i)].append(i);
+        }
+        for (const QVector<int>& cluster : qAsConst(clusters)) {
+            SystemTrack system = fuseCluster(members, cluster, frame);
+            for (const QString& key : qAsConst(system.members)) {
+                systemIdByMember.insert(key, system.systemTrackId);
+            }
+            systemTracks.insert(system.systemTrackId, system);
+        }
+    }
+
+    const QHash<QString, SystemTrack> previous = m_systemTracks;
+    m_systemTracks = systemTracks;
+    m_systemIdByMember = systemIdByMember;
+
+    m_stats.systemTracks = systemTracks.size();
+    m_stats.remoteTracks = remoteCount;
+    m_stats.multiSourceTracks = 0;
+    for (const SystemTrack& system : qAsConst(systemTracks)) {
+        if (system.isMultiSource()) ++m_stats.multiSourceTracks;
+    }
+
+    for (auto it = previous.constBegin(); it != previous.constEnd(); ++it) {
+        if (!systemTracks.contains(it.key())) emit systemTrackDropped(it.key());
+    }
+    for (const SystemTrack& system : qAsConst(systemTracks)) {
+        auto before = previous.constFind(system.systemTrackId);
+        if (before == previous.constEnd() || !sameFusedState(*before, system)) {
+            emit systemTrackUpdated(system);
+        }
+    }
+}
+
+} // namespace CounterUAS
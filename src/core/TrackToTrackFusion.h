@@ -0,0 +1,140 @@
+#ifndef TRACKTOTRACKFUSION_H
+#define TRACKTOTRACKFUSION_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include "core/TrackSnapshot.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+class TrackManager;
+
+/**
+ * @brief Association and fusion limits for track-to-track fusion
+ */
+struct TrackFusionConfig {
+    double gateChiSquare = 9.21;     // Horizontal Mahalanobis gate, 2 dof at 99 %
+    double searchRadiusM = 300.0;    // Spatial index query around each track
+    double minSigmaM = 1.0;          // Floor on a member's position sigma
+};
+
+/**
+ * @brief One object as seen by every C2 node that tracks it
+ */
+struct SystemTrack {
+    QString systemTrackId;
+    TrackSnapshot fused;        // trackId is the system track id
+    QStringList members;        // "node/track" of each contributing track, sorted
+    QString localTrackId;       // Empty when only remote nodes hold it
+
+    bool isMultiSource() const { return members.size() > 1; }
+};
+
+/**
+ * @brief System picture fused from this node's tracks and its peers'
+ *
+ * Inputs are the local TrackPicture and the remote tracks each peer
+ * publishes with their position covariance (TrackPictureSync::
+ * attachFusion()). A fusion pass projects every track onto one tangent
+ * plane, finds candidate pairs through a TrackSpatialIndex, and gates
+ * them on the Mahalanobis distance of the position difference under the
+ * summed covariances. Passing pairs join clusters closest first, and a
+ * cluster never takes two tracks from the same node, since a node
+ * already resolved its own tracks as distinct objects.
+ *
+ * Each cluster is fused by covariance intersection, folding its members
+ * in id order with the weight that minimises the fused determinant. The
+ * nodes' errors are correlated through shared sensors and common process
+ * noise we cannot observe, and CI stays consistent whatever that
+ * correlation is, where a Kalman-style combination would grow
+ * overconfident with every exchange.
+ *
+ * The system track id is the smallest member "node/track", so every node
+ * that sees the same members names the object the same way without
+ * negotiating. It changes only when the cluster gains a smaller member or
+ * loses its smallest, which is reported as a drop and a new track.
+ *
+ * Inputs schedule one fusion pass per event loop turn; fuse() runs one now.
+ */
+class TrackToTrackFusion : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TrackToTrackFusion(QObject* parent = nullptr);
+
+    void setConfig(const TrackFusionConfig& config) { m_config = config; }
+    TrackFusionConfig config() const { return m_config; }
+
+    void setNodeId(const QString& nodeId) { m_nodeId = nodeId; }
+    QString nodeId() const { return m_nodeId; }
+
+    // Follows the manager's published pictures; nullptr detaches
+    void setTrackManager(TrackManager* trackManager);
+
+    void setLocalPicture(const TrackPicturePtr& picture);
+    void updateRemoteTrack(const QString& nodeId, const TrackSnapshot& track);
+    void dropRemoteTrack(const QString& nodeId, const QString& trackId);
+    void dropRemoteNode(const QString& nodeId);
+
+    void fuse();
+
+    QList<SystemTrack> systemTracks() const { return m_systemTracks.values(); }
+    // System track a node's track is fused into, empty if none
+    QString systemTrackIdFor(const QString& nodeId, const QString& trackId) const;
+
+    // Fused estimate of (a, pa) and (b, pb) in the east/north plane, the
+    // vertical folded with the same weight. Returns the weight of a.
+    static double covarianceIntersection(const EnuVector& a, const PositionCovariance& pa,
+                                         const EnuVector& b, const PositionCovariance& pb,
+                                         EnuVector& fused, PositionCovariance& fusedCov);
+    // Squared horizontal Mahalanobis distance of b - a under pa + pb
+    static double mahalanobisSquared(const EnuVector& a, const PositionCovariance& pa,
+                                     const EnuVector& b, const PositionCovariance& pb);
+
+    struct Statistics {
+        quint64 passes = 0;
+        int systemTracks = 0;
+        int multiSourceTracks = 0;
+        int remoteTracks = 0;
+    };
+    Statistics statistics() const { return m_stats; }
+
+signals:
+    void systemTrackUpdated(const SystemTrack& track);
+    void systemTrackDropped(const QString& systemTrackId);
+
+private:
+    struct Member {
+        QString key;            // "node/track"
+        QString nodeId;
+        const TrackSnapshot* track;
+        EnuVector position;
+        PositionCovariance covariance;
+    };
+
+    void scheduleFuse();
+    SystemTrack fuseCluster(const QVector<Member>& members, const QVector<int>& indices,
+                            const LocalTangentPlane& frame) const;
+    PositionCovariance flooredCovariance(const PositionCovariance& cov) const;
+
+    TrackFusionConfig m_config;
+    QString m_nodeId = QStringLiteral("C2");
+    TrackManager* m_trackManager = nullptr;
+    bool m_fusePending = false;
+
+    TrackPicturePtr m_local;
+    QHash<QString, QHash<QString, TrackSnapshot>> m_remote;   // By node, then track id
+
+    QHash<QString, SystemTrack> m_systemTracks;
+    QHash<QString, QString> m_systemIdByMember;
+    Statistics m_stats;
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::SystemTrack)
+
+#endif // TRACKTOTRACKFUSION_H
@@ -0,0 +1,496 @@
+#include "core/WeaponTargetAssigner.h"
+#include "utils/AssignmentSolver.h"
+#include "utils/CoordinateUtils.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+bool AssignmentThreat::operator==(const AssignmentThreat& o) const {
+    return trackId == o.trackId &&
+           position.latitude == o.position.latitude &&
+           position.longitude == o.position.longitude &&
+           position.altitude == o.position.altitude &&
+           velocity.north == o.velocity.north &&
+           velocity.east == o.velocity.east &&
+           velocity.down == o.velocity.down &&
+           classification == o.classification &&
+           threatLevel == o.threatLevel &&
+           timeToImpactSec == o.timeToImpactSec &&
+           trackQuality == o.trackQuality &&
+           groupId == o.groupId &&
+           groupSize == o.groupSize;
+}
+
+bool AssignmentEffector::operator==(const AssignmentEffector& o) const {
+    return effectorId == o.effectorId &&
+           effectorType == o.effectorType &&
+           position.latitude == o.position.latitude &&
+           position.longitude == o.position.longitude &&
+           position.altitude == o.position.altitude &&
+           minRange == o.minRange &&
+           maxRange == o.maxRange &&
+           effectiveness == o.effectiveness &&
+           ready == o.ready &&
+           channels == o.channels &&
+           hasKinematics == o.hasKinematics &&
+           (!hasKinematics || kinematics == o.kinematics) &&
+           coverage == o.coverage &&
+           envelope == o.envelope;
+}
+
+void WeaponTargetAssigner::setRules(const AssignmentRules& rules) {
+    m_rules = rules;
+    m_allDirty = true;
+}
+
+void WeaponTargetAssigner::updateThreat(const AssignmentThreat& threat) {
+    auto it = m_threatIndex.constFind(threat.trackId);
+    if (it != m_threatIndex.constEnd()) {
+        const int row = it.value();
+        if (m_threats[row] != threat) {
+            m_threats[row] = threat;
+            m_dirtyRows.insert(row);
+        }
+        return;
+    }
+
+    const int row = m_threats.size();
+    m_threats.append(threat);
+    m_threatIndex.insert(threat.trackId, row);
+    m_scores.resize(m_threats.size() * m_effectors.size());
+    m_dirtyRows.insert(row);
+}
+
+void WeaponTargetAssigner::removeThreat(const QString& trackId) {
+    auto it = m_threatIndex.find(trackId);
+    if (it == m_threatIndex.end()) return;
+
+    // Swap the last row into the hole
+    const int row = it.value();
+    const int last = m_threats.size() - 1;
+    const int columns = m_effectors.size();
+    m_threatIndex.erase(it);
+    if (m_allDirty) {
+        // Stride is stale; everything is rescored anyway
+        m_threats.removeAt(row);
+        for (int i = row; i < m_threats.size(); ++i) {
+            m_threatIndex[m_threats[i].trackId] = i;
+        }
+        m_lastPairing.remove(trackId);
+        return;
+    }
+    if (row != last) {
+        m_threats[row] = m_threats[last];
+        m_threatIndex[m_threats[row].trackId] = row;
+        std::copy(m_scores.constBegin() + last * columns,
+                  m_scores.constBegin() + (last + 1) * columns,
+                  m_scores.begin() + row * columns);
+        if (m_dirtyRows.remove(last)) {
+            m_dirtyRows.insert(row);
+        } else {
+            m_dirtyRows.remove(row);
+        }
+    } else {
+        m_dirtyRows.remove(row);
+    }
+    m_threats.removeLast();
+    m_scores.resize(m_threats.size() * columns);
+    m_lastPairing.remove(trackId);
+}
+
+void WeaponTargetAssigner::syncThreats(const QVector<AssignmentThreat>& threats) {
+    QSet<QString> present;
+    present.reserve(threats.size());
+    for (const AssignmentThreat& threat : threats) {
+        present.insert(threat.trackId);
+        updateThreat(threat);
+    }
+
+    QStringList gone;
+    for (const AssignmentThreat& threat : qAsConst(m_threats)) {
+        if (!present.contains(threat.trackId)) {
+            gone.append(threat.trackId);
+        }
+    }
+    for (const QString& trackId : qAsConst(gone)) {
+        removeThreat(trackId);
+    }
+}
+
+void WeaponTargetAssigner::updateEffector(const AssignmentEffector& effector) {
+    auto it = m_effectorIndex.constFind(effector.effectorId);
+    if (it != m_effectorIndex.constEnd()) {
+        const int column = it.value();
+        if (m_effectors[column] != effector) {
+            m_effectors[column] = effector;
+            m_dirtyColumns.insert(column);
+        }
+        return;
+    }
+
+    // A new column changes the row stride
+    m_effectorIndex.insert(effector.effectorId, m_effectors.size());
+    m_effectors.append(effector);
+    m_allDirty = true;
+}
+
+void WeaponTargetAssigner::removeEffector(const QString& effectorId) {
+    auto it = m_effectorIndex.find(effectorId);
+    if (it == m_effectorIndex.end()) return;
+
+    m_effectors.removeAt(it.value());
+    m_effectorIndex.clear();
+    for (int i = 0; i < m_effectors.size(); ++i) {
+        m_effectorIndex.insert(m_effectors[i].effectorId, i);
+    }
+    m_allDirty = true;
+}
+
+void WeaponTargetAssigner::syncEffectors(const QVector<AssignmentEffector>& effectors) {
+    QSet<QString> present;
+    for (const AssignmentEffector& effector : effectors) {
+        present.insert(effector.effectorId);
+        updateEffector(effector);
+    }
+
+    QStringList gone;
+    for (const AssignmentEffector& effector : qAsConst(m_effectors)) {
+        if (!present.contains(effector.effectorId)) {
+            gone.append(effector.effectorId);
+        }
+    }
+    for (const QString& effectorId : qAsConst(gone)) {
+        removeEffector(effectorId);
+    }
+}
+
+void WeaponTargetAssigner::clear() {
+    m_threats.clear();
+    m_threatIndex.clear();
+    m_effectors.clear();
+    m_effectorIndex.clear();
+    m_scores.clear();
+    m_dirtyRows.clear();
+    m_dirtyColumns.clear();
+    m_allDirty = false;
+    m_committed.clear();
+    m_lastPairing.clear();
+    m_plan.clear();
+}
+
+void WeaponTargetAssigner::commit(const QString& trackId, const QString& effectorId) {
+    m_committed.insert(trackId, effectorId);
+    m_lastPairing.insert(trackId, effectorId);
+}
+
+void WeaponTargetAssigner::release(const QString& trackId) {
+    m_committed.remove(trackId);
+}
+
+double WeaponTargetAssigner::score(const QString& trackId, const QString& effectorId) const {
+    auto row = m_threatIndex.constFind(trackId);
+    auto column = m_effectorIndex.constFind(effectorId);
+    if (row == m_threatIndex.constEnd() || column == m_effectorIndex.constEnd()) return 0.0;
+    return scorePair(m_threats[row.value()], m_effectors[column.value()]).score;
+}
+
+WeaponTargetAssigner::PairScore WeaponTargetAssigner::scorePair(const AssignmentThreat& threat,
+                                                                const AssignmentEffector& effector) const {
+    PairScore result;
+    if (!effector.ready || effector.channels <= 0) return result;
+
+    // Rules of engagement
+    switch (threat.classification) {
+        case TrackClassification::Friendly:
+        case TrackClassification::Neutral:
+            return result;
+        case TrackClassification::Pending:
+        case TrackClassification::Unknown:
+            if (!m_rules.engageUnconfirmed ||
+                !m_rules.unconfirmedEffectorTypes.contains(effector.effectorType)) {
+                return result;
+            }
+            break;
+        case TrackClassification::Hostile:
+            break;
+    }
+    if (threat.threatLevel < m_rules.minThreatLevel) return result;
+
+    double pk = 0.0;
+    double wait = 0.0;
+    if (effector.hasKinematics) {
+        InterceptorKinematics kinematics = effector.kinematics;
+        kinematics.maxWaitSec = std::min(kinematics.maxWaitSec, m_rules.maxWaitSec);
+        const InterceptSolution intercept = InterceptSolver(kinematics, effector.position)
+            .solve(InterceptSolver::target(threat.trackId, threat.position, threat.velocity,
+                                           threat.trackQuality));
+        if (!intercept.feasible) return result;
+        if (effector.coverage && !effector.coverage->canSee(intercept.interceptPoint)) return result;
+        pk = intercept.pk;
+        wait = intercept.timeToInterceptSec;
+    } else if ((effector.coverage && !effector.coverage->canSee(threat.position)) ||
+               !scoreEnvelope(threat, effector, &pk, &wait)) {
+        return result;
+    }
+
+    double value = threat.threatLevel;
+    if (threat.timeToImpactSec >= 0) {
+        value *= 1.0 + m_rules.impactTimeSec / (m_rules.impactTimeSec + threat.timeToImpactSec);
+    }
+    if (threat.groupId != 0 && threat.groupSize > 1 &&
+        m_rules.areaEffectorTypes.contains(effector.effectorType)) {
+        value *= threat.groupSize;
+    }
+    const double urgency = 1.0 / (1.0 + wait / m_rules.urgencyTimeSec);
+
+    result.score = value * pk * urgency;
+    result.pk = pk;
+    result.timeToInterceptSec = wait;
+    return result;
+}
+
+bool WeaponTargetAssigner::scoreEnvelope(const AssignmentThreat& threat,
+                                         const AssignmentEffector& effector,
+                                         double* pk, double* wait) const {
+    // Local tangent plane at the effector
+    const double east = (threat.position.longitude - effector.position.longitude) *
+                        CoordinateUtils::degToMeterLon(effector.position.latitude);
+    const double north = (threat.position.latitude - effector.position.latitude) *
+                         CoordinateUtils::DEG_TO_M_LAT;
+    const double distance = std::hypot(east, north);
+    const double closing = distance > 0.0
+        ? -(east * threat.velocity.east + north * threat.velocity.north) / distance
+        : 0.0;
+
+    // Wait until the target is inside [minRange, maxRange]
+    *wait = 0.0;
+    if (distance > effector.maxRange) {
+        if (closing <= 0.0) return false;
+        *wait = (distance - effector.maxRange) / closing;
+    } else if (distance < effector.minRange) {
+        if (closing >= 0.0) return false;
+        *wait = (effector.minRange - distance) / -closing;
+    }
+    if (*wait > m_rules.maxWaitSec) return false;
+
+    // Pk and time to effect where the target enters the envelope, on the
+    // range limit it crosses
+    if (effector.envelope) {
+        EnuVector entry = effector.envelope->toLocal(threat.position);
+        entry.east += threat.velocity.east * *wait;
+        entry.north += threat.velocity.north * *wait;
+        entry.up -= threat.velocity.down * *wait;
+        const double entryRange = entry.groundRange();
+        const double clamped = std::clamp(entryRange, effector.minRange, effector.maxRange);
+        if (entryRange > 0.0 && clamped != entryRange) {
+            entry.east *= clamped / entryRange;
+            entry.north *= clamped / entryRange;
+        }
+        const EnvelopeCell cell = effector.envelope->at(entry);
+        if (!cell.feasible()) return false;
+        *pk = cell.pk;
+        *wait += cell.timeToEffectSec;
+        return true;
+    }
+
+    // Pk from effectiveness, best mid-envelope (rangeScore is 0.5 at the edges)
+    const double interceptRange = std::clamp(distance, effector.minRange, effector.maxRange);
+    const double span = effector.maxRange - effector.minRange;
+    const double rangeScore = span > 0.0
+        ? 1.0 - std::abs(interceptRange - (effector.maxRange + effector.minRange) / 2.0) / span
+        : 1.0;
+    *pk = effector.effectiveness * rangeScore;
+    return true;
+}
+
+void WeaponTargetAssigner::rescoreRow(int row) {
+    const int columns = m_effectors.size();
+    PairScore* out = m_scores.data() + row * columns;
+    for (int column = 0; column < columns; ++column) {
+        out[column] = scorePair(m_threats[row], m_effectors[column]);
+    }
+    m_stats.pairsScored += columns;
+}
+
+void WeaponTargetAssigner::rescoreColumn(int column) {
+    const int columns = m_effectors.size();
+    for (int row = 0; row < m_threats.size(); ++row) {
+        m_scores[row * columns + column] = scorePair(m_threats[row], m_effectors[column]);
+    }
+    m_stats.pairsScored += m_threats.size();
+}
+
+void WeaponTargetAssigner::rescoreAll() {
+    m_scores.resize(m_threats.size() * m_effectors.size());
+    for (int row = 0; row < m_threats.size(); ++row) {
+        rescoreRow(row);
+    }
+}
+
+QVector<WeaponAssignment> WeaponTargetAssigner::solve() {
+    QElapsedTimer timer;
+    timer.start();
+
+    const int columns = m_effectors.size();
+    if (m_allDirty) {
+        rescoreAll();
+        m_stats.lastRowsRescored = m_threats.size();
+    } else {
+        for (int column : qAsConst(m_dirtyColumns)) {
+            rescoreColumn(column);
+        }
+        for (int row : qAsConst(m_dirtyRows)) {
+            rescoreRow(row);
+        }
+        m_stats.lastRowsRescored = m_dirtyRows.size();
+    }
+    m_allDirty = false;
+    m_dirtyRows.clear();
+    m_dirtyColumns.clear();
+
+    m_plan.clear();
+
+    // Committed pairings hold their channel and track
+    QVector<int> freeChannels(columns);
+    for (int column = 0; column < columns; ++column) {
+        freeChannels[column] = std::max(0, m_effectors[column].channels);
+    }
+    for (auto it = m_committed.constBegin(); it != m_committed.constEnd(); ++it) {
+        WeaponAssignment assignment;
+        assignment.trackId = it.key();
+        assignment.effectorId = it.value();
+        assignment.committed = true;
+        auto column = m_effectorIndex.constFind(it.value());
+        auto row = m_threatIndex.constFind(it.key());
+        if (column != m_effectorIndex.constEnd()) {
+            freeChannels[column.value()]--;
+            if (row != m_threatIndex.constEnd()) {
+                // Scored as if the effector were free; it is busy with this one
+                AssignmentEffector effector = m_effectors[column.value()];
+                effector.ready = true;
+                const PairScore pair = scorePair(m_threats[row.value()], effector);
+                assignment.score = pair.score;
+                assignment.pk = pair.pk;
+                assignment.timeToInterceptSec = pair.timeToInterceptSec;
+            }
+        }
+        m_plan.append(assignment);
+    }
+
+    QVector<int> slotColumns;
+    for (int column = 0; column < columns; ++column) {
+        for (int channel = 0; channel < freeChannels[column]; ++channel) {
+            slotColumns.append(column);
+        }
+    }
+    QVector<int> candidateRows;
+    candidateRows.reserve(m_threats.size());
+    for (int row = 0; row < m_threats.size(); ++row) {
+        if (!m_committed.contains(m_threats[row].trackId)) {
+            candidateRows.append(row);
+        }
+    }
+
+    // Area effectors take a group through its lead alone, and none at all
+    // when one is already committed against it
+    QVector<bool> areaColumn(columns);
+    for (int column = 0; column < columns; ++column) {
+        areaColumn[column] = m_rules.areaEffectorTypes.contains(m_effectors[column].effectorType);
+    }
+    QSet<quint32> coveredGroups;
+    for (auto it = m_committed.constBegin(); it != m_committed.constEnd(); ++it) {
+        auto row = m_threatIndex.constFind(it.key());
+        auto column = m_effectorIndex.constFind(it.value());
+        if (row == m_threatIndex.constEnd() || column == m_effectorIndex.constEnd()) continue;
+        const quint32 group = m_threats[row.value()].groupId;
+        if (group != 0 && areaColumn[column.value()]) coveredGroups.insert(group);
+    }
+    QHash<quint32, int> groupLead;
+    for (int row : qAsConst(candidateRows)) {
+        const AssignmentThreat& threat = m_threats[row];
+        if (threat.groupId == 0) continue;
+        auto lead = groupLead.find(threat.groupId);
+        if (lead == groupLead.end()) {
+            groupLead.insert(threat.groupId, row);
+            continue;
+        }
+        const AssignmentThreat& current = m_threats[lead.value()];
+        if (threat.threatLevel > current.threatLevel ||
+            (threat.threatLevel == current.threatLevel && threat.trackId < current.trackId)) {
+            lead.value() = row;
+        }
+    }
+
+    QHash<QString, QString> pairing;
+    QVector<WeaponAssignment> solved;
+    if (!slotColumns.isEmpty() && !candidateRows.isEmpty()) {
+        // Rows of the cost matrix are the smaller side, which the solver
+        // handles without padding
+        const bool slotsAreRows = slotColumns.size() <= candidateRows.size();
+        const int rows = slotsAreRows ? slotColumns.size() : candidateRows.size();
+        const int cols = slotsAreRows ? candidateRows.size() : slotColumns.size();
+
+        // Cost is the negated score; infeasible pairs are forbidden
+        QVector<double> cost(rows * cols, AssignmentSolver::FORBIDDEN_COST);
+        for (int i = 0; i < slotColumns.size(); ++i) {
+            const int column = slotColumns[i];
+            for (int j = 0; j < candidateRows.size(); ++j) {
+                const int row = candidateRows[j];
+                double s = m_scores[row * columns + column].score;
+                if (s <= 0.0 || s < m_rules.minScore) continue;
+                const quint32 group = m_threats[row].groupId;
+                if (areaColumn[column] && group != 0 &&
+                    (coveredGroups.contains(group) || groupLead.value(group) != row)) {
+                    continue;
+                }
+                if (m_lastPairing.value(m_threats[row].trackId) == m_effectors[column].effectorId) {
+                    s *= 1.0 + m_rules.stickiness;
+                }
+                if (slotsAreRows) {
+                    cost[i * cols + j] = -s;
+                } else {
+                    cost[j * cols + i] = -s;
+                }
+            }
+        }
+
+        const QVector<int> match = AssignmentSolver::solve(cost, rows, cols);
+        for (int r = 0; r < rows; ++r) {
+            if (match[r] < 0) continue;
+            const int slot = slotsAreRows ? r : match[r];
+            const int candidate = slotsAreRows ? match[r] : r;
+            const int column = slotColumns[slot];
+            const int row = candidateRows[candidate];
+            const PairScore& pair = m_scores[row * columns + column];
+
+            WeaponAssignment assignment;
+            assignment.trackId = m_threats[row].trackId;
+            assignment.effectorId = m_effectors[column].effectorId;
+            assignment.score = pair.score;
+            assignment.pk = pair.pk;
+            assignment.timeToInterceptSec = pair.timeToInterceptSec;
+            solved.append(assignment);
+            pairing.insert(assignment.trackId, assignment.effectorId);
+        }
+    }
+
+    std::sort(solved.begin(), solved.end(),
+              [](const WeaponAssignment& a, const WeaponAssignment& b) {
+                  return a.score != b.score ? a.score > b.score : a.trackId < b.trackId;
+              });
+    m_plan += solved;
+
+    for (auto it = m_committed.constBegin(); it != m_committed.constEnd(); ++it) {
+        pairing.insert(it.key(), it.value());
+    }
+    m_lastPairing = pairing;
+
+    m_stats.solves++;
+    m_stats.lastSolveMs = timer.nsecsElapsed() / 1.0e6;
+
+    return m_plan;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,197 @@
+#ifndef WEAPONTARGETASSIGNER_H
+#define WEAPONTARGETASSIGNER_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "core/Track.h"
+#include "core/InterceptSolver.h"
+#include "utils/CoverageRaster.h"
+#include "utils/EngagementEnvelope.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief A track the assigner may pair with an effector
+ */
+struct AssignmentThreat {
+    QString trackId;
+    GeoPosition position;
+    VelocityVector velocity;
+    TrackClassification classification = TrackClassification::Unknown;
+    int threatLevel = 1;
+    double timeToImpactSec = -1;    // From the threat assessor, -1 if not closing
+    double trackQuality = 1.0;      // Sets the prediction uncertainty for intercepts
+    quint32 groupId = 0;            // Swarm group the track flies in, 0 for none
+    int groupSize = 1;              // Its members, which an area effector engages together
+
+    bool operator==(const AssignmentThreat& o) const;
+    bool operator!=(const AssignmentThreat& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief An effector as the assigner sees it
+ */
+struct AssignmentEffector {
+    QString effectorId;
+    QString effectorType;
+    GeoPosition position;
+    double minRange = 0.0;
+    double maxRange = 1000.0;
+    double effectiveness = 0.8;
+    bool ready = true;
+    int channels = 1;               // Targets it can engage at once
+    // Fly-out effectors: scored on the solved intercept, not the range now
+    bool hasKinematics = false;
+    InterceptorKinematics kinematics;
+    // Line of sight at its position; null takes every target in range as seen
+    CoverageRasterPtr coverage;
+    // Pk and time to effect at its position for effectors without
+    // kinematics; null scores the range envelope from effectiveness
+    EngagementEnvelopePtr envelope;
+
+    bool operator==(const AssignmentEffector& o) const;
+    bool operator!=(const AssignmentEffector& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Rules of engagement and scoring weights
+ */
+struct AssignmentRules {
+    int minThreatLevel = 3;
+    bool engageUnconfirmed = true;          // Pending/Unknown tracks, with the types below only
+    QStringList unconfirmedEffectorTypes{"RF_JAMMER"};
+    QStringList areaEffectorTypes{"RF_JAMMER"};  // One channel covers a whole swarm group
+    double maxWaitSec = 60.0;               // Longest wait for a target to enter the envelope
+    double urgencyTimeSec = 20.0;           // Time to intercept that halves the score
+    double impactTimeSec = 30.0;            // Time to impact that adds half the threat value again
+    double minScore = 0.01;
+    double stickiness = 0.1;                // Bonus for keeping last solve's pairing
+};
+
+/**
+ * @brief One effector-to-track pairing in a plan
+ */
+struct WeaponAssignment {
+    QString trackId;
+    QString effectorId;
+    double score = 0.0;                     // value x Pk x urgency
+    double pk = 0.0;
+    // Until the target is in the envelope, 0 if already, plus the time to
+    // effect there; until the solved intercept for effectors with kinematics
+    double timeToInterceptSec = 0.0;
+    bool committed = false;                 // Pinned by commit(), not re-solved
+};
+
+/**
+ * @brief Weapon-target assignment across all threats and effectors at once
+ *
+ * Each feasible (threat, effector) pair scores threat value (threat level,
+ * raised as time to impact shrinks) x probability of kill (effectiveness,
+ * best mid-envelope) x urgency (falling with the time until the target is
+ * in the envelope, from its closing speed, plus the effector's time to
+ * effect where it has an envelope). For effectors that fly out,
+ * InterceptSolver supplies both Pk and the time, from the lead intercept
+ * against the track's predicted motion. Where the effector has a coverage
+ * raster, a target it cannot see (at the intercept point, for fly-out
+ * effectors) is out of reach. ROE rules a pair out entirely:
+ * friendly and neutral tracks never, unconfirmed tracks only with
+ * non-kinetic types, below-threshold threats and busy effectors not at all.
+ *
+ * solve() then hands the negated scores to AssignmentSolver, each effector
+ * channel taking at most one track and each track at most one channel:
+ * as many pairings as feasible, and among those the highest total score.
+ * The smaller side is the rows, so n channels against m threats cost
+ * O(n^2 m). A pair kept from the last plan gets a small bonus so the plan
+ * does not flip between near-equal options.
+ *
+ * Scores are cached: updating or removing a threat rescores only its row,
+ * an effector only its column, so a cycle in which a few tracks moved
+ * costs a few rows plus the solve. Pairings being engaged are commit()ed
+ * and hold their effector channel and track out of the solve.
+ *
+ * An area effector (areaEffectorTypes) against a track in a swarm group
+ * engages the whole group: the pair is worth the group size times the
+ * track's value, and only the group's lead track (highest threat level)
+ * may take such a channel, so one jammer covers a swarm instead of each
+ * member drawing its own. Members stay open to point effectors, and a
+ * group already committed to an area effector takes no second one.
+ */
+class WeaponTargetAssigner {
+public:
+    void setRules(const AssignmentRules& rules);
+    AssignmentRules rules() const { return m_rules; }
+
+    // Threats: add or replace by trackId
+    void updateThreat(const AssignmentThreat& threat);
+    void removeThreat(const QString& trackId);
+    // Replaces the whole set, rescoring only threats that changed
+    void syncThreats(const QVector<AssignmentThreat>& threats);
+    int threatCount() const { return m_threats.size(); }
+
+    void updateEffector(const AssignmentEffector& effector);
+    void removeEffector(const QString& effectorId);
+    void syncEffectors(const QVector<AssignmentEffector>& effectors);
+    int effectorCount() const { return m_effectors.size(); }
+
+    void clear();
+
+    // Pins a pairing (one channel of the effector) until release()
+    void commit(const QString& trackId, const QString& effectorId);
+    void release(const QString& trackId);
+    QHash<QString, QString> committed() const { return m_committed; }
+
+    // Committed pairings first, then the solved ones by descending score
+    QVector<WeaponAssignment> solve();
+    QVector<WeaponAssignment> lastPlan() const { return m_plan; }
+
+    // Score of one pair as the solver sees it; 0 if ROE or geometry rule it out
+    double score(const QString& trackId, const QString& effectorId) const;
+
+    struct Stats {
+        quint64 solves = 0;
+        quint64 pairsScored = 0;
+        int lastRowsRescored = 0;
+        double lastSolveMs = 0.0;
+    };
+    Stats stats() const { return m_stats; }
+
+private:
+    struct PairScore {
+        double score = 0.0;
+        double pk = 0.0;
+        double timeToInterceptSec = 0.0;
+    };
+
+    PairScore scorePair(const AssignmentThreat& threat, const AssignmentEffector& effector) const;
+    // Envelope Pk and wait for effectors without kinematics; false if out of reach
+    bool scoreEnvelope(const AssignmentThreat& threat, const AssignmentEffector& effector,
+                       double* pk, double* wait) const;
+    void rescoreRow(int row);
+    void rescoreColumn(int column);
+    void rescoreAll();
+
+    AssignmentRules m_rules;
+
+    QVector<AssignmentThreat> m_threats;
+    QHash<QString, int> m_threatIndex;
+    QVector<AssignmentEffector> m_effectors;
+    QHash<QString, int> m_effectorIndex;
+
+    // m_scores[row * effectorCount + column]
+    QVector<PairScore> m_scores;
+    QSet<int> m_dirtyRows;
+    QSet<int> m_dirtyColumns;
+    bool m_allDirty = false;
+
+    QHash<QString, QString> m_committed;        // trackId -> effectorId
+    QHash<QString, QString> m_lastPairing;      // trackId -> effectorId, last solve
+    QVector<WeaponAssignment> m_plan;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // WEAPONTARGETASSIGNER_H
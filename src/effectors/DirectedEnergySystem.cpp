@@ -1,6 +1,8 @@
 #include "effectors/DirectedEnergySystem.h"
 #include "utils/Logger.h"
 #include <QDateTime>
+#include <QtMath>
+#include <cmath>
 
 namespace CounterUAS {
 
@@ -28,6 +30,20 @@ DirectedEnergySystem::~DirectedEnergySystem() {
 
 void DirectedEnergySystem::setConfig(const DESystemConfig& config) {
     m_config = config;
+    invalidateEnvelope();
+}
+
+EnvelopeCell DirectedEnergySystem::envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const {
+    EnvelopeCell cell = EffectorInterface::envelopeCell(rangeM, azimuthDeg, elevationDeg);
+    
+    // Irradiance falls with the square of slant range, so the dwell grows
+    // with it; past the longest engagement the beam cannot finish the job
+    const double slantM = rangeM / qMax(1e-3, std::cos(qDegreesToRadians(elevationDeg)));
+    const double referenceM = qMax(1.0, (m_config.minRangeM + m_config.maxRangeM) / 2.0);
+    const double dwellS = m_config.dwellTimeRequiredS * (slantM / referenceM) * (slantM / referenceM);
+    if (dwellS * 1000.0 > m_config.maxEngagementTimeMs) return EnvelopeCell();
+    cell.timeToEffectSec = static_cast<float>(dwellS);
+    return cell;
 }
 
 bool DirectedEnergySystem::engage(const GeoPosition& target) {
@@ -48,8 +64,8 @@ bool DirectedEnergySystem::engage(const GeoPosition& target) {
     // Start tracking
     startTracking();
     
-    // Set dwell timeout
-    int dwellMs = static_cast<int>(m_config.dwellTimeRequiredS * 1000);
+    // Set dwell timeout, longer the further the target
+    int dwellMs = static_cast<int>(envelope()->at(target).timeToEffectSec * 1000);
     m_dwellTimer->start(dwellMs);
     
     m_health.totalEngagements++;
@@ -61,7 +77,7 @@ bool DirectedEnergySystem::engage(const GeoPosition& target) {
                                .arg(distanceToTarget(target), 0, 'f', 0)
                                .arg(m_currentPowerKW, 0, 'f', 1));
     
-    emit engagementStarted(target);
+    notifyEngagementStarted(target);
     emit powerChanged(m_currentPowerKW);
     
     return true;
@@ -78,7 +94,7 @@ void DirectedEnergySystem::disengage() {
     
     Logger::instance().info("DirectedEnergySystem", m_effectorId + " disengaged");
     
-    emit engagementComplete(false);
+    notifyEngagementComplete(false);
     
     // Start cooldown
     setStatus(EffectorStatus::Cooldown);
@@ -106,7 +122,7 @@ void DirectedEnergySystem::onDwellComplete() {
     stopTracking();
     
     emit targetEffect();
-    emit engagementComplete(true);
+    notifyEngagementComplete(true);
     
     // Cooldown
     setStatus(EffectorStatus::Cooldown);
@@ -20,7 +20,7 @@ struct DESystemConfig {
     int maxEngagementTimeMs = 10000;
     int cooldownTimeMs = 15000;
     
-    double dwellTimeRequiredS = 2.0;  // Time on target for effect
+    double dwellTimeRequiredS = 2.0;  // Time on target for effect, mid-envelope
 };
 
 /**
@@ -56,6 +56,10 @@ signals:
     void trackingStatus(bool tracking, double dwellTime);
     void targetEffect();  // When target has been damaged
     
+protected:
+    // Dwell grows with slant range squared, from dwellTimeRequiredS mid-envelope
+    EnvelopeCell envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const override;
+    
 private slots:
     void onDwellComplete();
     void onCooldownComplete();
@@ -1,5 +1,10 @@
 #include "effectors/EffectorInterface.h"
+#include "utils/CoordinateUtils.h"
 #include "utils/Logger.h"
+#include "utils/StatusBoard.h"
+#include <QDateTime>
+#include <cmath>
+#include <utility>
 
 namespace CounterUAS {
 
@@ -8,14 +13,59 @@ EffectorInterface::EffectorInterface(const QString& effectorId, QObject* parent)
     , m_effectorId(effectorId)
     , m_displayName(effectorId)
 {
+    qRegisterMetaType<EffectorEvent>("EffectorEvent");
+    
     m_health.status = EffectorStatus::Offline;
 }
 
+EffectorInterface::~EffectorInterface() {
+    StatusBoard::instance().remove(m_effectorId, StatusKind::Effector);
+}
+
 bool EffectorInterface::canEngage(const GeoPosition& target) const {
     if (!isReady()) return false;
     
-    double dist = distanceToTarget(target);
-    return dist >= minRange() && dist <= maxRange();
+    if (!envelope()->at(target).feasible()) return false;
+    return !m_coverage || !m_coverage->isFor(m_position) || m_coverage->canSee(target);
+}
+
+quint64 EffectorInterface::addCompletionCallback(QObject* context, const CompletionCallback& callback) {
+    const quint64 id = m_nextCallbackId++;
+    m_completionCallbacks.insert(id, PendingCompletion{context, callback});
+    return id;
+}
+
+EngagementEnvelopePtr EffectorInterface::envelope() const {
+    if (!m_envelope || !m_envelope->isFor(m_position) ||
+        m_envelope->minRangeM() != minRange() || m_envelope->maxRangeM() != maxRange()) {
+        m_envelope = EngagementEnvelope::build(m_position, minRange(), maxRange(), m_limits,
+            [this](double rangeM, double azimuthDeg, double elevationDeg) {
+                return envelopeCell(rangeM, azimuthDeg, elevationDeg);
+            });
+    }
+    return m_envelope;
+}
+
+void EffectorInterface::setEngagementLimits(const EngagementLimits& limits) {
+    if (limits == m_limits) return;
+    m_limits = limits;
+    invalidateEnvelope();
+}
+
+EnvelopeCell EffectorInterface::envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const {
+    Q_UNUSED(azimuthDeg)
+    Q_UNUSED(elevationDeg)
+    EnvelopeCell cell;
+    cell.pk = static_cast<float>(effectiveness() * envelopeRangeScore(rangeM));
+    return cell;
+}
+
+double EffectorInterface::envelopeRangeScore(double rangeM) const {
+    const double lo = minRange();
+    const double hi = maxRange();
+    if (rangeM < lo || rangeM > hi) return 0.0;
+    const double span = hi - lo;
+    return span > 0.0 ? 1.0 - std::abs(rangeM - (hi + lo) / 2.0) / span : 1.0;
 }
 
 void EffectorInterface::initialize() {
@@ -59,6 +109,7 @@ void EffectorInterface::setStatus(EffectorStatus status) {
         m_health.status = status;
         emit statusChanged(status);
         emit healthUpdated(m_health);
+        publish(EffectorEventType::StatusChanged);
         
         if (wasReady != isReady()) {
             emit readyChanged(isReady());
@@ -75,13 +126,56 @@ void EffectorInterface::reportFault(const QString& message) {
     
     Logger::instance().error("Effector", m_effectorId + " fault: " + message);
     emit fault(message);
+    publish(EffectorEventType::Fault, false, message);
+}
+
+void EffectorInterface::notifyEngagementStarted(const GeoPosition& target) {
+    emit engagementStarted(target);
+    publish(EffectorEventType::EngagementStarted);
+}
+
+void EffectorInterface::notifyEngagementComplete(bool success) {
+    emit engagementComplete(success);
+    publish(EffectorEventType::EngagementComplete, success);
+    
+    // Taken first: a callback may register for the next engagement
+    const QMap<quint64, PendingCompletion> callbacks = std::exchange(m_completionCallbacks, {});
+    for (const PendingCompletion& pending : callbacks) {
+        if (pending.context) {
+            pending.callback(success);
+        }
+    }
+}
+
+void EffectorInterface::notifyHealth() {
+    emit healthUpdated(m_health);
+    publish(EffectorEventType::HealthUpdated);
+}
+
+void EffectorInterface::publish(EffectorEventType type, bool success, const QString& message) {
+    EffectorEvent event;
+    event.type = type;
+    event.effectorId = m_effectorId;
+    event.health = m_health;
+    event.success = success;
+    event.message = message;
+    event.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    emit telemetry(event);
+    
+    // Readiness to the percent shown, so that charging ticks below it change nothing
+    StatusBoard::instance().publish(m_effectorId, StatusKind::Effector, {
+        {"status", static_cast<int>(m_health.status)},
+        {"readiness", qRound(m_health.readiness * 100.0)},
+        {"remainingShots", m_health.remainingShots},
+        {"totalEngagements", m_health.totalEngagements},
+        {"lastEngagementMs", m_health.lastEngagementTime.isValid()
+                                 ? m_health.lastEngagementTime.toMSecsSinceEpoch() : qint64(0)},
+        {"fault", m_health.faultMessage}
+    });
 }
 
 double EffectorInterface::distanceToTarget(const GeoPosition& target) const {
-    // Simplified distance calculation
-    Track tempTrack("temp");
-    tempTrack.setPosition(m_position);
-    return tempTrack.distanceTo(target);
+    return CoordinateUtils::haversineDistance(m_position, target);
 }
 
 } // namespace CounterUAS
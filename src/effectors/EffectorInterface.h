@@ -1,10 +1,15 @@
 #ifndef EFFECTORINTERFACE_H
 #define EFFECTORINTERFACE_H
 
+#include <QMap>
 #include <QObject>
+#include <QPointer>
 #include <QString>
 #include <QTimer>
+#include <functional>
 #include "core/Track.h"
+#include "utils/CoverageRaster.h"
+#include "utils/EngagementEnvelope.h"
 
 namespace CounterUAS {
 
@@ -36,8 +41,36 @@ struct EffectorHealth {
     QDateTime lastMaintenanceTime;
 };
 
+/**
+ * @brief What an effector telemetry event reports
+ */
+enum class EffectorEventType {
+    StatusChanged = 0,
+    HealthUpdated,
+    EngagementStarted,
+    EngagementComplete,
+    Fault
+};
+
+/**
+ * @brief One push from an effector: its state as of the event, and what changed
+ */
+struct EffectorEvent {
+    EffectorEventType type = EffectorEventType::StatusChanged;
+    QString effectorId;
+    EffectorHealth health;              // Status, readiness and rounds after the event
+    bool success = false;               // EngagementComplete
+    QString message;                    // Fault
+    qint64 timestampMs = 0;
+};
+
 /**
  * @brief Abstract base class for effector interfaces
+ *
+ * Everything an effector reports goes out as it happens on telemetry(),
+ * alongside the individual signals, so a consumer never has to poll it;
+ * the same state goes onto the StatusBoard for the status displays.
+ * A completion callback runs once, when the engagement under way ends.
  */
 class EffectorInterface : public QObject {
     Q_OBJECT
@@ -48,7 +81,7 @@ class EffectorInterface : public QObject {
     
 public:
     explicit EffectorInterface(const QString& effectorId, QObject* parent = nullptr);
-    ~EffectorInterface() override = default;
+    ~EffectorInterface() override;
     
     // Identity
     QString effectorId() const { return m_effectorId; }
@@ -69,8 +102,27 @@ public:
     // Engagement
     virtual bool engage(const GeoPosition& target) = 0;
     virtual void disengage() = 0;
+    // In the engagement envelope, and in line of sight once a coverage raster is set
     virtual bool canEngage(const GeoPosition& target) const;
     
+    // Runs callback once, at the next engagementComplete, unless context is
+    // gone by then or the id is removed first
+    using CompletionCallback = std::function<void(bool success)>;
+    quint64 addCompletionCallback(QObject* context, const CompletionCallback& callback);
+    void removeCompletionCallback(quint64 id) { m_completionCallbacks.remove(id); }
+    
+    // Pk and time to effect by range, azimuth and elevation, from
+    // envelopeCell(). Built on first use after the position, the limits or
+    // the configuration change; call on the effector's thread, then share
+    EngagementEnvelopePtr envelope() const;
+    void setEngagementLimits(const EngagementLimits& limits);
+    EngagementLimits engagementLimits() const { return m_limits; }
+    
+    // Line of sight from CoverageService; ignored once the effector moves
+    // off the position it was built for
+    void setCoverage(const CoverageRasterPtr& coverage) { m_coverage = coverage; }
+    CoverageRasterPtr coverage() const { return m_coverage; }
+    
     // Range
     virtual double minRange() const { return 0.0; }
     virtual double maxRange() const { return 1000.0; }
@@ -91,23 +143,50 @@ signals:
     void engagementStarted(const GeoPosition& target);
     void engagementComplete(bool success);
     void fault(const QString& message);
+    void telemetry(const EffectorEvent& event);
     
 protected:
     void setStatus(EffectorStatus status);
     void reportFault(const QString& message);
+    // Emit the signal and its telemetry event; completion runs the callbacks
+    void notifyEngagementStarted(const GeoPosition& target);
+    void notifyEngagementComplete(bool success);
+    void notifyHealth();
     double distanceToTarget(const GeoPosition& target) const;
     
+    // The weapon model envelope() tabulates: effectiveness, best
+    // mid-envelope, with immediate effect. Range is ground range
+    virtual EnvelopeCell envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const;
+    // 1 mid-envelope, 0.5 at the range limits, 0 outside them
+    double envelopeRangeScore(double rangeM) const;
+    // Subclasses call it when a change moves their envelope
+    void invalidateEnvelope() { m_envelope.reset(); }
+    
     QString m_effectorId;
     QString m_displayName;
     GeoPosition m_position;
     EffectorHealth m_health;
     
     GeoPosition m_currentTarget;
+    CoverageRasterPtr m_coverage;
+    EngagementLimits m_limits;
+    mutable EngagementEnvelopePtr m_envelope;
     QTimer* m_engagementTimer = nullptr;
+    
+private:
+    void publish(EffectorEventType type, bool success = false, const QString& message = QString());
+    
+    struct PendingCompletion {
+        QPointer<QObject> context;
+        CompletionCallback callback;
+    };
+    QMap<quint64, PendingCompletion> m_completionCallbacks;     // In registration order
+    quint64 m_nextCallbackId = 1;
 };
 
 } // namespace CounterUAS
 
 Q_DECLARE_METATYPE(CounterUAS::EffectorStatus)
+Q_DECLARE_METATYPE(CounterUAS::EffectorEvent)
 
 #endif // EFFECTORINTERFACE_H
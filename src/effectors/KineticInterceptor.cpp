@@ -1,6 +1,8 @@
 #include "effectors/KineticInterceptor.h"
 #include "utils/Logger.h"
 #include <QRandomGenerator>
+#include <QtMath>
+#include <cmath>
 
 namespace CounterUAS {
 
@@ -33,6 +35,23 @@ void KineticInterceptor::setConfig(const KineticInterceptorConfig& config) {
     m_config = config;
     m_remainingRounds = config.magazineCapacity;
     m_health.remainingShots = m_remainingRounds;
+    invalidateEnvelope();
+}
+
+EnvelopeCell KineticInterceptor::envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const {
+    Q_UNUSED(azimuthDeg)
+    const double elevation = qDegreesToRadians(elevationDeg);
+    if (rangeM * std::tan(elevation) > m_config.maxAltitudeM) return EnvelopeCell();
+    
+    // As InterceptSolver scores a meeting with a target that holds still
+    const InterceptorKinematics k = kinematics();
+    const double flightS = rangeM / qMax(1e-3, std::cos(elevation)) / qMax(1e-3, k.speedMps);
+    if (k.speedMps <= 0.0 || flightS > k.maxFlightTimeSec) return EnvelopeCell();
+    const double spent = flightS / k.maxFlightTimeSec;
+    EnvelopeCell cell;
+    cell.pk = static_cast<float>(qBound(0.0, k.baseProbability * (1.0 - 0.5 * spent * spent), 1.0));
+    cell.timeToEffectSec = static_cast<float>(k.launchDelaySec + flightS);
+    return cell;
 }
 
 bool KineticInterceptor::engage(const GeoPosition& target) {
@@ -42,26 +61,68 @@ bool KineticInterceptor::engage(const GeoPosition& target) {
         return false;
     }
     
+    m_currentPk = m_config.interceptProbability;
+    m_plannedFlightMs = 0;
+    return startLaunch(target, ARMING_TIME_MS);
+}
+
+bool KineticInterceptor::engageIntercept(const InterceptSolution& solution) {
+    if (!isReady() || !solution.feasible) {
+        Logger::instance().warning("KineticInterceptor",
+                                  m_effectorId + " cannot engage - not ready or no intercept");
+        return false;
+    }
+    
+    // Arming stretches to hold the launch until the solution's launch time
+    const int armingMs = qMax(ARMING_TIME_MS,
+                              static_cast<int>(solution.launchInSec * 1000) - m_config.launchTimeMs);
+    m_currentPk = solution.pk;
+    m_plannedFlightMs = static_cast<int>(solution.timeOfFlightSec * 1000);
+    return startLaunch(solution.interceptPoint, armingMs);
+}
+
+InterceptorKinematics KineticInterceptor::kinematics() const {
+    InterceptorKinematics k;
+    k.launchDelaySec = (ARMING_TIME_MS + m_config.launchTimeMs) / 1000.0;
+    k.speedMps = m_config.flyoutSpeedMps;
+    k.maxFlightTimeSec = m_config.flightTimeMs / 1000.0;
+    k.minRangeM = m_config.minRangeM;
+    k.maxRangeM = m_config.maxRangeM;
+    k.maxAltitudeM = m_config.maxAltitudeM;
+    k.seekerBasketM = m_config.seekerBasketM;
+    k.baseProbability = m_config.interceptProbability;
+    return k;
+}
+
+InterceptSolution KineticInterceptor::solveIntercept(const InterceptTarget& target) const {
+    return InterceptSolver(kinematics(), m_position).solve(target);
+}
+
+QVector<InterceptSolution> KineticInterceptor::solveIntercepts(const QVector<InterceptTarget>& targets) const {
+    return InterceptSolver(kinematics(), m_position).solve(targets);
+}
+
+bool KineticInterceptor::startLaunch(const GeoPosition& aimPoint, int armingMs) {
     if (m_remainingRounds <= 0) {
         Logger::instance().warning("KineticInterceptor",
                                   m_effectorId + " cannot engage - no rounds remaining");
         return false;
     }
     
-    m_currentTarget = target;
+    m_currentTarget = aimPoint;
     
     // Start launch sequence
     setStatus(EffectorStatus::Engaged);
     transitionPhase(LaunchPhase::Arming);
     
-    m_armingTimer->start(500);  // Arming takes 500ms
+    m_armingTimer->start(armingMs);
     
     Logger::instance().info("KineticInterceptor",
                            QString("%1 engaging target at %2m range")
                                .arg(m_effectorId)
-                               .arg(distanceToTarget(target), 0, 'f', 0));
+                               .arg(distanceToTarget(aimPoint), 0, 'f', 0));
     
-    emit engagementStarted(target);
+    notifyEngagementStarted(aimPoint);
     
     return true;
 }
@@ -78,7 +139,7 @@ void KineticInterceptor::disengage() {
         Logger::instance().info("KineticInterceptor",
                                m_effectorId + " engagement aborted");
         
-        emit engagementComplete(false);
+        notifyEngagementComplete(false);
     } else {
         Logger::instance().warning("KineticInterceptor",
                                   m_effectorId + " cannot abort - interceptor already launched");
@@ -127,14 +188,16 @@ void KineticInterceptor::onLaunchComplete() {
     m_health.lastEngagementTime = QDateTime::currentDateTimeUtc();
     
     emit roundsFired(m_remainingRounds);
-    emit healthUpdated(m_health);
+    notifyHealth();
     
     transitionPhase(LaunchPhase::InFlight);
     
-    // Calculate flight time based on range
-    double range = distanceToTarget(m_currentTarget);
-    double avgSpeed = 100.0;  // m/s
-    int flightTime = static_cast<int>(range / avgSpeed * 1000);
+    // Flight time from the intercept solution, else from range
+    int flightTime = m_plannedFlightMs;
+    if (flightTime <= 0) {
+        double range = distanceToTarget(m_currentTarget);
+        flightTime = static_cast<int>(range / qMax(1.0, m_config.flyoutSpeedMps) * 1000);
+    }
     flightTime = qBound(1000, flightTime, m_config.flightTimeMs);
     
     m_flightTimer->start(flightTime);
@@ -170,7 +233,7 @@ void KineticInterceptor::onReloadComplete() {
                                .arg(m_remainingRounds));
     
     emit reloadComplete();
-    emit healthUpdated(m_health);
+    notifyHealth();
 }
 
 void KineticInterceptor::transitionPhase(LaunchPhase phase) {
@@ -186,7 +249,7 @@ void KineticInterceptor::sendLaunchCommand(const GeoPosition& target) {
 void KineticInterceptor::simulateIntercept() {
     // Simulate intercept probability
     double roll = QRandomGenerator::global()->generateDouble();
-    bool success = roll < m_config.interceptProbability;
+    bool success = roll < m_currentPk;
     
     transitionPhase(LaunchPhase::Complete);
     
@@ -196,7 +259,7 @@ void KineticInterceptor::simulateIntercept() {
                                .arg(success ? "SUCCESS" : "MISS"));
     
     emit interceptResult(success);
-    emit engagementComplete(success);
+    notifyEngagementComplete(success);
     
     // Return to ready state
     QTimer::singleShot(1000, this, [this]() {
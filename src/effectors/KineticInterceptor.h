@@ -2,6 +2,7 @@
 #define KINETICINTERCEPTOR_H
 
 #include "effectors/EffectorInterface.h"
+#include "core/InterceptSolver.h"
 
 namespace CounterUAS {
 
@@ -21,6 +22,9 @@ struct KineticInterceptorConfig {
     int flightTimeMs = 10000;  // Max flight time
     int reloadTimeMs = 30000;  // Time to reload one round
     
+    double flyoutSpeedMps = 100.0;  // Average, launch to intercept
+    double seekerBasketM = 50.0;    // Aim error the seeker still corrects
+    
     double interceptProbability = 0.85;
 };
 
@@ -49,6 +53,13 @@ public:
     double maxRange() const override { return m_config.maxRangeM; }
     double effectiveness() const override { return m_config.interceptProbability; }
     
+    // Intercept geometry from the track's state rather than its position now
+    InterceptorKinematics kinematics() const;
+    InterceptSolution solveIntercept(const InterceptTarget& target) const;
+    QVector<InterceptSolution> solveIntercepts(const QVector<InterceptTarget>& targets) const;
+    // Launches at the lead point, when the solution says, with its Pk
+    bool engageIntercept(const InterceptSolution& solution);
+    
     // Interceptor-specific
     int remainingRounds() const { return m_remainingRounds; }
     int magazineCapacity() const { return m_config.magazineCapacity; }
@@ -72,6 +83,10 @@ signals:
     void reloadComplete();
     void interceptResult(bool success);
     
+protected:
+    // Fly-out time and Pk against a stationary target, under the altitude ceiling
+    EnvelopeCell envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const override;
+    
 private slots:
     void onArmingComplete();
     void onLaunchComplete();
@@ -80,6 +95,9 @@ private slots:
     void onReloadComplete();
     
 private:
+    static constexpr int ARMING_TIME_MS = 500;
+    
+    bool startLaunch(const GeoPosition& aimPoint, int armingMs);
     void transitionPhase(LaunchPhase phase);
     void sendLaunchCommand(const GeoPosition& target);
     void simulateIntercept();
@@ -87,6 +105,8 @@ private:
     KineticInterceptorConfig m_config;
     int m_remainingRounds;
     LaunchPhase m_launchPhase = LaunchPhase::Idle;
+    double m_currentPk = 0.85;
+    int m_plannedFlightMs = 0;          // From the intercept solution, 0 if none
     
     QTimer* m_armingTimer;
     QTimer* m_launchTimer;
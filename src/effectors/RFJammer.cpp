@@ -31,6 +31,13 @@ RFJammer::~RFJammer() {
 
 void RFJammer::setConfig(const RFJammerConfig& config) {
     m_config = config;
+    invalidateEnvelope();
+}
+
+EnvelopeCell RFJammer::envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const {
+    EnvelopeCell cell = EffectorInterface::envelopeCell(rangeM, azimuthDeg, elevationDeg);
+    if (cell.feasible()) cell.timeToEffectSec = static_cast<float>(m_config.linkLossTimeS);
+    return cell;
 }
 
 bool RFJammer::engage(const GeoPosition& target) {
@@ -54,7 +61,8 @@ bool RFJammer::engage(const GeoPosition& target) {
     // Start jamming
     setStatus(EffectorStatus::Engaged);
     m_currentPowerW = m_config.defaultPowerW;
-    m_activeFrequencies = m_config.jamFrequenciesMHz;
+    m_activeFrequencies = m_plannedFrequencies.isEmpty() ? m_config.jamFrequenciesMHz
+                                                         : m_plannedFrequencies;
     m_engagementStartTime = QDateTime::currentMSecsSinceEpoch();
     
     sendJamCommand(true, m_activeFrequencies, m_currentPowerW);
@@ -69,9 +77,9 @@ bool RFJammer::engage(const GeoPosition& target) {
                                .arg(distanceToTarget(target), 0, 'f', 0)
                                .arg(m_currentPowerW, 0, 'f', 0));
     
-    emit engagementStarted(target);
+    notifyEngagementStarted(target);
     emit jamming(true, m_currentPowerW);
-    emit healthUpdated(m_health);
+    notifyHealth();
     
     return true;
 }
@@ -89,7 +97,7 @@ void RFJammer::disengage() {
     Logger::instance().info("RFJammer", m_effectorId + " disengaging");
     
     emit jamming(false, 0);
-    emit engagementComplete(true);
+    notifyEngagementComplete(true);
     
     // Start cooldown
     setStatus(EffectorStatus::Cooldown);
@@ -99,13 +107,31 @@ void RFJammer::disengage() {
 void RFJammer::setJamFrequencies(const QList<double>& frequenciesMHz) {
     m_config.jamFrequenciesMHz = frequenciesMHz;
     
-    if (isEngaged()) {
+    if (isEngaged() && m_plannedFrequencies.isEmpty()) {
         m_activeFrequencies = frequenciesMHz;
         sendJamCommand(true, m_activeFrequencies, m_currentPowerW);
         emit frequencyChanged(frequenciesMHz);
     }
 }
 
+void RFJammer::setChannelPlan(const QList<double>& centersMHz) {
+    if (centersMHz == m_plannedFrequencies) return;
+    m_plannedFrequencies = centersMHz;
+    
+    if (isEngaged()) {
+        m_activeFrequencies = m_plannedFrequencies.isEmpty() ? m_config.jamFrequenciesMHz
+                                                             : m_plannedFrequencies;
+        sendJamCommand(true, m_activeFrequencies, m_currentPowerW);
+        emit frequencyChanged(m_activeFrequencies);
+    }
+}
+
+int RFJammer::maxJamChannels() const {
+    if (m_config.minChannelPowerW <= 0.0) return qMax(0, m_config.maxChannels);
+    const int byPower = static_cast<int>(m_config.maxPowerW / m_config.minChannelPowerW);
+    return qBound(0, byPower, m_config.maxChannels);
+}
+
 void RFJammer::setPower(double watts) {
     watts = qBound(0.0, watts, m_config.maxPowerW);
     m_currentPowerW = watts;
@@ -22,6 +22,11 @@ struct RFJammerConfig {
     double maxPowerW = 100.0;
     double defaultPowerW = 50.0;
     
+    // Simultaneous carriers: at most maxChannels, each needing minChannelPowerW
+    int maxChannels = 4;
+    double channelBandwidthMHz = 40.0;
+    double minChannelPowerW = 10.0;
+    
     // Timing
     int engagementTimeMs = 30000;  // Default 30 seconds
     int cooldownTimeMs = 5000;
@@ -29,6 +34,8 @@ struct RFJammerConfig {
     // Range
     double effectiveRangeM = 2000.0;
     double minimumRangeM = 50.0;
+    
+    double linkLossTimeS = 3.0;    // Jamming on to the drone losing its link
 };
 
 /**
@@ -60,6 +67,11 @@ public:
     void setPower(double watts);
     void setEngagementTime(int ms);
     
+    // Planned carrier centres; when set they take the place of jamFrequenciesMHz
+    void setChannelPlan(const QList<double>& centersMHz);
+    QList<double> channelPlan() const { return m_plannedFrequencies; }
+    int maxJamChannels() const;
+    
     // Status
     double currentPowerW() const { return m_currentPowerW; }
     int remainingEngagementTimeMs() const;
@@ -69,6 +81,10 @@ signals:
     void jamming(bool active, double powerW);
     void frequencyChanged(const QList<double>& frequencies);
     
+protected:
+    // Link loss after linkLossTimeS, wherever the target is in range
+    EnvelopeCell envelopeCell(double rangeM, double azimuthDeg, double elevationDeg) const override;
+    
 private slots:
     void onEngagementTimeout();
     void onCooldownComplete();
@@ -88,6 +104,7 @@ private:
     
     double m_currentPowerW = 0.0;
     QList<double> m_activeFrequencies;
+    QList<double> m_plannedFrequencies;
     qint64 m_engagementStartTime = 0;
 };
 
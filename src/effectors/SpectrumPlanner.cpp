@@ -0,0 +1,272 @@
+#include "effectors/SpectrumPlanner.h"
+#include <QSet>
+#include <algorithm>
+
+namespace CounterUAS {
+
+namespace {
+constexpr double EPS = 1e-9;
+}
+
+bool JammerSpectrum::operator==(const JammerSpectrum& o) const {
+    return jammerId == o.jammerId &&
+           minFrequencyMHz == o.minFrequencyMHz &&
+           maxFrequencyMHz == o.maxFrequencyMHz &&
+           channels == o.channels &&
+           channelBandwidthMHz == o.channelBandwidthMHz;
+}
+
+QList<double> JammerPlan::centersMHz() const {
+    QList<double> centers;
+    for (const JamChannel& channel : channels) {
+        centers.append(channel.centerMHz);
+    }
+    return centers;
+}
+
+void SpectrumPlanner::updateEmission(const JamEmission& emission) {
+    auto it = m_emissionByName.find(emission.emissionId);
+    if (it != m_emissionByName.end()) {
+        Entry& entry = m_tree.value(*it);
+        if (entry.emission.centerMHz == emission.centerMHz &&
+            entry.emission.bandwidthMHz == emission.bandwidthMHz) {
+            // Same place in the spectrum: no re-index, and a new weight
+            // alone is the only thing that needs a new version
+            if (entry.emission.weight != emission.weight) {
+                entry.version = m_nextVersion++;
+            }
+            entry.emission = emission;
+            return;
+        }
+        m_tree.remove(*it);
+    }
+
+    Entry entry;
+    entry.emission = emission;
+    entry.version = m_nextVersion++;
+    m_emissionByName.insert(emission.emissionId,
+                            m_tree.insert(emission.lowMHz(), emission.highMHz(), entry));
+}
+
+bool SpectrumPlanner::removeEmission(const QString& emissionId) {
+    auto it = m_emissionByName.find(emissionId);
+    if (it == m_emissionByName.end()) return false;
+    m_tree.remove(*it);
+    m_emissionByName.erase(it);
+    return true;
+}
+
+int SpectrumPlanner::expire(qint64 cutoffMs) {
+    QStringList stale;
+    for (auto it = m_emissionByName.constBegin(); it != m_emissionByName.constEnd(); ++it) {
+        if (m_tree.value(it.value()).emission.lastSeenMs < cutoffMs) {
+            stale.append(it.key());
+        }
+    }
+    for (const QString& emissionId : qAsConst(stale)) {
+        removeEmission(emissionId);
+    }
+    return stale.size();
+}
+
+QVector<JamEmission> SpectrumPlanner::emissions() const {
+    QVector<JamEmission> out;
+    out.reserve(m_emissionByName.size());
+    for (Handle h : m_emissionByName) {
+        out.append(m_tree.value(h).emission);
+    }
+    return out;
+}
+
+void SpectrumPlanner::setJammers(const QVector<JammerSpectrum>& jammers) {
+    m_jammers = jammers;
+}
+
+void SpectrumPlanner::clear() {
+    m_tree.clear();
+    m_emissionByName.clear();
+    m_jammers.clear();
+    m_plannedJammers.clear();
+    m_inputs.clear();
+    m_plans.clear();
+    m_uncovered.clear();
+}
+
+QVector<JammerPlan> SpectrumPlanner::plan() {
+    m_stats.plans++;
+
+    QSet<Handle> covered;
+    QVector<Input> inputs;
+    QVector<JammerPlan> plans;
+    inputs.reserve(m_jammers.size());
+    plans.reserve(m_jammers.size());
+
+    for (int i = 0; i < m_jammers.size(); ++i) {
+        const JammerSpectrum& jammer = m_jammers[i];
+
+        // What is left in this jammer's band that one channel can span
+        Input input;
+        m_tree.forEachOverlapping(jammer.minFrequencyMHz, jammer.maxFrequencyMHz,
+                                  [&](Handle h, const Entry& entry) {
+            if (covered.contains(h)) return;
+            const JamEmission& e = entry.emission;
+            if (e.lowMHz() < jammer.minFrequencyMHz - EPS ||
+                e.highMHz() > jammer.maxFrequencyMHz + EPS ||
+                e.bandwidthMHz > jammer.channelBandwidthMHz + EPS) {
+                return;
+            }
+            input.handles.append(h);
+            input.versions.append(entry.version);
+        });
+
+        JammerPlan jammerPlan;
+        if (i < m_plannedJammers.size() && m_plannedJammers[i] == jammer && m_inputs[i] == input) {
+            jammerPlan = m_plans[i];
+            m_stats.jammersReused++;
+        } else {
+            jammerPlan = solve(jammer, input.handles);
+            m_stats.jammersSolved++;
+        }
+
+        for (Handle h : qAsConst(input.handles)) {
+            const JamEmission& e = m_tree.value(h).emission;
+            for (const JamChannel& channel : qAsConst(jammerPlan.channels)) {
+                if (channel.emissionIds.contains(e.emissionId)) {
+                    covered.insert(h);
+                    break;
+                }
+            }
+        }
+
+        inputs.append(input);
+        plans.append(jammerPlan);
+    }
+
+    m_plannedJammers = m_jammers;
+    m_inputs = inputs;
+    m_plans = plans;
+
+    m_uncovered.clear();
+    for (auto it = m_emissionByName.constBegin(); it != m_emissionByName.constEnd(); ++it) {
+        if (!covered.contains(it.value())) {
+            m_uncovered.append(it.key());
+        }
+    }
+    m_uncovered.sort();
+    return m_plans;
+}
+
+JammerPlan SpectrumPlanner::planFor(const QString& jammerId) const {
+    for (const JammerPlan& jammerPlan : m_plans) {
+        if (jammerPlan.jammerId == jammerId) return jammerPlan;
+    }
+    return JammerPlan();
+}
+
+JammerPlan SpectrumPlanner::solve(const JammerSpectrum& jammer,
+                                  const QVector<Handle>& candidates) const {
+    JammerPlan result;
+    result.jammerId = jammer.jammerId;
+
+    const double width = jammer.channelBandwidthMHz;
+    const int maxChannels = jammer.channels;
+    const int n = candidates.size();
+    if (n == 0 || maxChannels <= 0 || width <= 0.0) return result;
+
+    QVector<double> lo(n), hi(n), weight(n);
+    for (int i = 0; i < n; ++i) {
+        const JamEmission& e = m_tree.value(candidates[i]).emission;
+        lo[i] = e.lowMHz();
+        hi[i] = e.highMHz();
+        weight[i] = e.weight;
+    }
+
+    // Candidate channel starts: an emission's lower edge, kept inside the band
+    const double top = std::max(jammer.minFrequencyMHz, jammer.maxFrequencyMHz - width);
+    QVector<double> starts;
+    starts.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        starts.append(std::min(lo[i], top));
+    }
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+    const int m = starts.size();
+
+    auto covers = [&](double start, int i) {
+        return hi[i] - width <= start + EPS && start <= lo[i] + EPS;
+    };
+
+    // own[j]: weight under start j; shared[p][j], p < j: under both p and j
+    QVector<double> own(m, 0.0);
+    QVector<double> shared(m * m, 0.0);
+    for (int j = 0; j < m; ++j) {
+        for (int i = 0; i < n; ++i) {
+            if (covers(starts[j], i)) own[j] += weight[i];
+        }
+        for (int p = 0; p < j; ++p) {
+            double w = 0.0;
+            for (int i = 0; i < n; ++i) {
+                if (covers(starts[p], i) && covers(starts[j], i)) w += weight[i];
+            }
+            shared[p * m + j] = w;
+        }
+    }
+
+    // best[c][j]: most weight with c + 1 channels, the highest at start j
+    const int k = std::min(maxChannels, m);
+    QVector<double> best(k * m, 0.0);
+    QVector<int> from(k * m, -1);
+    for (int j = 0; j < m; ++j) {
+        best[j] = own[j];
+    }
+    for (int c = 1; c < k; ++c) {
+        for (int j = 0; j < m; ++j) {
+            double value = -1.0;
+            for (int p = 0; p < j; ++p) {
+                if (best[(c - 1) * m + p] < 0.0) continue;     // No such chain
+                const double candidate = best[(c - 1) * m + p] + own[j] - shared[p * m + j];
+                if (candidate > value + EPS) {
+                    value = candidate;
+                    from[c * m + j] = p;
+                }
+            }
+            best[c * m + j] = value;
+        }
+    }
+
+    // Fewest channels reaching the best weight
+    int bestC = 0;
+    int bestJ = 0;
+    for (int c = 0; c < k; ++c) {
+        for (int j = 0; j < m; ++j) {
+            if (best[c * m + j] > best[bestC * m + bestJ] + EPS) {
+                bestC = c;
+                bestJ = j;
+            }
+        }
+    }
+
+    QVector<double> chosen;
+    for (int c = bestC, j = bestJ; c >= 0 && j >= 0; j = from[c * m + j], --c) {
+        chosen.prepend(starts[j]);
+    }
+
+    QVector<bool> assigned(n, false);
+    for (double start : qAsConst(chosen)) {
+        JamChannel channel;
+        channel.lowMHz = start;
+        channel.highMHz = start + width;
+        channel.centerMHz = start + width / 2.0;
+        for (int i = 0; i < n; ++i) {
+            if (!assigned[i] && covers(start, i)) {
+                assigned[i] = true;
+                channel.emissionIds.append(m_tree.value(candidates[i]).emission.emissionId);
+                result.coveredWeight += weight[i];
+            }
+        }
+        result.channels.append(channel);
+    }
+    return result;
+}
+
+} // namespace CounterUAS
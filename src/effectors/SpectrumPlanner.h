@@ -0,0 +1,136 @@
+#ifndef SPECTRUMPLANNER_H
+#define SPECTRUMPLANNER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "utils/IntervalTree.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief An RF emission seen by the detectors, as the planner sees it
+ */
+struct JamEmission {
+    QString emissionId;                 // e.g. "DJI@2437"
+    double centerMHz = 0.0;
+    double bandwidthMHz = 1.0;
+    double weight = 1.0;                // Value of jamming it
+    qint64 lastSeenMs = 0;
+
+    double lowMHz() const { return centerMHz - bandwidthMHz / 2.0; }
+    double highMHz() const { return centerMHz + bandwidthMHz / 2.0; }
+};
+
+/**
+ * @brief What one jammer can put on the air at once
+ */
+struct JammerSpectrum {
+    QString jammerId;
+    double minFrequencyMHz = 2400.0;
+    double maxFrequencyMHz = 5800.0;
+    int channels = 4;                   // Simultaneous carriers the power budget allows
+    double channelBandwidthMHz = 40.0;
+
+    bool operator==(const JammerSpectrum& o) const;
+    bool operator!=(const JammerSpectrum& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief One jamming carrier and the emissions it covers
+ */
+struct JamChannel {
+    double centerMHz = 0.0;
+    double lowMHz = 0.0;
+    double highMHz = 0.0;
+    QStringList emissionIds;
+};
+
+struct JammerPlan {
+    QString jammerId;
+    QVector<JamChannel> channels;
+    double coveredWeight = 0.0;
+
+    QList<double> centersMHz() const;
+};
+
+/**
+ * @brief Jamming channel plan across jammers and simultaneous emitters
+ *
+ * An emission is covered when a channel spans all of it. Active emissions
+ * are indexed by frequency in an IntervalTree, so each jammer pulls only
+ * those in its band. For one jammer the plan is optimal: a channel can
+ * always slide up until its lower edge meets a covered emission's, so
+ * only those edges are candidate positions, and with equal-width
+ * channels taken in frequency order an emission two channels back that
+ * the new one also covers is covered by the one in between as well, so
+ * the gain of a channel depends only on its predecessor. That makes it a
+ * k-step DP over candidate positions, O(k m^2) for m emissions in band.
+ * Jammers are planned in turn, each on what earlier ones left uncovered.
+ *
+ * plan() is incremental: a jammer whose band, channels and remaining
+ * emissions are the same as last time keeps its plan unsolved.
+ * Not thread-safe.
+ */
+class SpectrumPlanner {
+public:
+    // Emissions: add or replace by emissionId
+    void updateEmission(const JamEmission& emission);
+    bool removeEmission(const QString& emissionId);
+    // Drops emissions last seen before cutoffMs; returns how many
+    int expire(qint64 cutoffMs);
+    int emissionCount() const { return m_emissionByName.size(); }
+    QVector<JamEmission> emissions() const;
+
+    // Planned in the order given
+    void setJammers(const QVector<JammerSpectrum>& jammers);
+    int jammerCount() const { return m_jammers.size(); }
+
+    void clear();
+
+    QVector<JammerPlan> plan();
+    QVector<JammerPlan> lastPlan() const { return m_plans; }
+    JammerPlan planFor(const QString& jammerId) const;
+    // Active emissions no channel covers, after the last plan()
+    QStringList uncovered() const { return m_uncovered; }
+
+    struct Stats {
+        quint64 plans = 0;
+        quint64 jammersSolved = 0;
+        quint64 jammersReused = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+private:
+    struct Entry {
+        JamEmission emission;
+        quint64 version = 0;            // Bumped on every change
+    };
+    using Handle = IntervalTree<Entry>::Handle;
+
+    // What a jammer's plan was solved from
+    struct Input {
+        QVector<Handle> handles;
+        QVector<quint64> versions;
+        bool operator==(const Input& o) const { return handles == o.handles && versions == o.versions; }
+    };
+
+    JammerPlan solve(const JammerSpectrum& jammer, const QVector<Handle>& candidates) const;
+
+    IntervalTree<Entry> m_tree;
+    QHash<QString, Handle> m_emissionByName;
+    quint64 m_nextVersion = 1;
+
+    QVector<JammerSpectrum> m_jammers;
+    QVector<JammerSpectrum> m_plannedJammers;
+    QVector<Input> m_inputs;
+    QVector<JammerPlan> m_plans;
+    QStringList m_uncovered;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // SPECTRUMPLANNER_H
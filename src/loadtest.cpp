@@ -0,0 +1,129 @@
+/**
+ * Counter-UAS C2 load test
+ * 
+ * Runs the fusion core headless, on a virtual clock, faster than real time,
+ * and prints throughput, per-stage latency percentiles, CPU per track and
+ * memory high-water marks for each scenario, and with --scorecard how well
+ * the tracks matched the simulator's truth (OSPA, GOSPA, ID switches,
+ * fragmentation, time to confirm):
+ * 
+ *   CounterUAS_LoadTest swarm-5000.json
+ *   CounterUAS_LoadTest --targets 1000,5000 --duration 300 --json report.json
+ *   CounterUAS_LoadTest --targets 500 --scorecard --score-interval 100
+ *   CounterUAS_LoadTest --convert raid.ndjson scenario.json
+ * 
+ * Scenario files take SimulationScenario's keys (name, basePosition,
+ * durationMinutes, maxTargets, threatSpawnRate) plus durationSec,
+ * initialTargets, scanRateHz, detectionProbability, clutterPerScan, seed,
+ * scorecard, scoreIntervalMs, scoreCutoffM and raidScript, a raid script
+ * (relative to the scenario file) to fly instead of spawning. --convert writes the raid script a SimulationScenario would
+ * spawn, so it can be edited and replayed exactly.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+#include "simulators/LoadHarness.h"
+#include "simulators/RaidScript.h"
+#include "utils/Logger.h"
+
+using namespace CounterUAS;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("CounterUAS_LoadTest");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Faster-than-real-time load test of track fusion, "
+                                     "threat assessment and engagement.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scenarios", "Load scenario JSON files.", "[scenario.json...]");
+    parser.addOption({"targets", "Built-in scenarios with these target counts, comma separated.", "list"});
+    parser.addOption({"duration", "Override every scenario's simulated seconds.", "sec"});
+    parser.addOption({"seed", "Override every scenario's seed.", "seed"});
+    parser.addOption({"scorecard", "Score every scenario's tracks against the simulator's truth."});
+    parser.addOption({"score-interval", "Simulated milliseconds between scorecard samples.", "ms"});
+    parser.addOption({"json", "Write the reports to <file> as a JSON array.", "file"});
+    parser.addOption({"convert", "Convert the scenario file to a raid script at <file> and exit.", "file"});
+    parser.process(app);
+
+    // Thousands of tracks come and go; keep the console for the report
+    Logger::instance().setLogLevel(LogLevel::Warning);
+    Logger::instance().setLogToConsole(true);
+
+    QTextStream err(stderr);
+    if (parser.isSet("convert")) {
+        if (parser.positionalArguments().size() != 1) {
+            err << "--convert takes exactly one scenario file\n";
+            return 1;
+        }
+        QString error;
+        if (!RaidScriptWriter::convertScenarioFile(parser.positionalArguments().first(),
+                                                   parser.value("convert"), &error)) {
+            err << "Conversion failed: " << error << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    QVector<LoadScenario> scenarios;
+    for (const QString& path : parser.positionalArguments()) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "Cannot read " << path << ": " << file.errorString() << "\n";
+            return 1;
+        }
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+        if (!doc.isObject()) {
+            err << path << ": " << parseError.errorString() << "\n";
+            return 1;
+        }
+        LoadScenario scenario = LoadScenario::fromJson(doc.object());
+        if (!scenario.raidScript.isEmpty()) {
+            scenario.raidScript = QFileInfo(path).dir().absoluteFilePath(scenario.raidScript);
+        }
+        scenarios.append(scenario);
+    }
+    for (const QString& count : parser.value("targets").split(',', Qt::SkipEmptyParts)) {
+        LoadScenario scenario;
+        scenario.maxTargets = count.trimmed().toInt();
+        scenario.name = QString("targets-%1").arg(scenario.maxTargets);
+        scenarios.append(scenario);
+    }
+    if (scenarios.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    QJsonArray reports;
+    QTextStream out(stdout);
+    for (LoadScenario& scenario : scenarios) {
+        if (parser.isSet("duration")) scenario.durationSec = parser.value("duration").toInt();
+        if (parser.isSet("seed")) scenario.seed = parser.value("seed").toUInt();
+        if (parser.isSet("scorecard")) scenario.scorecard = true;
+        if (parser.isSet("score-interval")) scenario.scoreIntervalMs = qMax(1, parser.value("score-interval").toInt());
+
+        const LoadReport report = LoadHarness(scenario).run();
+        out << report.toText() << "\n";
+        out.flush();
+        reports.append(report.toJson());
+    }
+
+    if (parser.isSet("json")) {
+        QFile file(parser.value("json"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "Cannot write " << file.fileName() << ": " << file.errorString() << "\n";
+            return 1;
+        }
+        file.write(QJsonDocument(reports).toJson());
+    }
+
+    return 0;
+}
@@ -14,18 +14,225 @@
  */
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QStyleFactory>
 #include <QSurfaceFormat>
+#include <QTextStream>
+#include <QTimer>
+#include <limits>
 #include "ui/MainWindow.h"
 #include "config/ConfigManager.h"
 #include "config/DatabaseManager.h"
+#include "config/EventJournal.h"
+#include "core/ThreatAssessor.h"
+#include "core/TrackManager.h"
+#include "network/MetricsExporter.h"
+#include "utils/FlightRecorder.h"
 #include "utils/Logger.h"
+#include "utils/MemoryGovernor.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/OverloadController.h"
+#include "utils/PipelineLatency.h"
+#include "utils/TaskScheduler.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
+#include "simulators/ReplayEngine.h"
 #include "simulators/TrackSimulator.h"
 
 using namespace CounterUAS;
 
+namespace {
+
+// ISO 8601 or milliseconds since the epoch
+qint64 parseReplayTime(const QString& text, qint64 fallback) {
+    if (text.isEmpty()) return fallback;
+    bool ok = false;
+    const qint64 ms = text.toLongLong(&ok);
+    if (ok) return ms;
+    const QDateTime time = QDateTime::fromString(text, Qt::ISODate);
+    return time.isValid() ? time.toMSecsSinceEpoch() : fallback;
+}
+
+// Hands the threads/<role> settings to ThreadPlacement, before the threads start
+void configureThreadPlacement() {
+    const ConfigManager& config = ConfigManager::instance();
+    for (int r = 0; r < THREAD_ROLES; ++r) {
+        const ThreadRole role = static_cast<ThreadRole>(r);
+        const QString prefix = QString("threads/%1/").arg(ThreadPlacement::roleKey(role));
+        ThreadRoleConfig placement;
+        placement.cpus = ThreadPlacement::parseCpuList(config.value(prefix + "cpus", QString()).toString());
+        placement.isolated = config.value(prefix + "isolated", false).toBool();
+        placement.realtimePriority = config.value(prefix + "realtimePriority", 0).toInt();
+        placement.deadlineUs = qRound(config.value(prefix + "deadlineMs", 0.0).toDouble() * 1000.0);
+        ThreadPlacement::instance().setConfig(role, placement);
+    }
+}
+
+// Hands the memory/ settings to MemoryGovernor and puts the log view under it
+void configureMemoryGovernor() {
+    const ConfigManager& config = ConfigManager::instance();
+    MemoryGovernorConfig governor;
+    governor.ceilingBytes = config.value("memory/ceilingMb", 0).toLongLong() * 1024 * 1024;
+    governor.highWaterPercent = config.value("memory/highWaterPercent", 85).toInt();
+    governor.lowWaterPercent = config.value("memory/lowWaterPercent", 75).toInt();
+    governor.criticalPercent = config.value("memory/criticalPercent", 95).toInt();
+    governor.pollMs = config.value("memory/pollMs", 1000).toInt();
+    MemoryGovernor::instance().setConfig(governor);
+    
+    // The log file keeps every entry; only the in-memory view is shortened
+    const int normalEntries = Logger::instance().maxLogEntries();
+    const int elevatedEntries = config.value("memory/logEntriesElevated", 2000).toInt();
+    const int criticalEntries = config.value("memory/logEntriesCritical", 200).toInt();
+    MemoryGovernor::instance().registerConsumer(&Logger::instance(), "logger.entries", MemoryShedOrder::LogView, 0,
+        []() { return Logger::instance().memoryBytes(); },
+        [=](MemoryPressure pressure) {
+            Logger::instance().setMaxLogEntries(pressure == MemoryPressure::Critical ? criticalEntries
+                                              : pressure == MemoryPressure::Elevated ? elevatedEntries
+                                                                                     : normalEntries);
+        });
+    MemoryGovernor::instance().start();
+}
+
+void configureOverloadController() {
+    const ConfigManager& config = ConfigManager::instance();
+    OverloadConfig overload;
+    overload.windowMs = config.value("overload/windowMs", 1000).toInt();
+    overload.highUtilization = config.value("overload/highUtilization", 0.9).toDouble();
+    overload.lowUtilization = config.value("overload/lowUtilization", 0.6).toDouble();
+    overload.overrunShare = config.value("overload/overrunShare", 0.1).toDouble();
+    overload.escalateWindows = config.value("overload/escalateWindows", 2).toInt();
+    overload.recoverWindows = config.value("overload/recoverWindows", 5).toInt();
+    OverloadController::instance().setConfig(overload);
+    if (config.value("overload/enabled", true).toBool()) {
+        OverloadController::instance().start();
+    }
+}
+
+// Hands the flightRecorder/ settings to FlightRecorder; on unless disabled
+void configureFlightRecorder() {
+    const ConfigManager& config = ConfigManager::instance();
+    FlightRecorderConfig recorder;
+    recorder.directory = config.value("flightRecorder/directory", QString()).toString();
+    recorder.windowMs = config.value("flightRecorder/windowMs", 5000).toInt();
+    recorder.overrunFactor = config.value("flightRecorder/overrunFactor", 1.5).toDouble();
+    recorder.cooldownMs = config.value("flightRecorder/cooldownMs", 60000).toInt();
+    recorder.maxCaptures = config.value("flightRecorder/maxCaptures", 20).toInt();
+    recorder.stageBudgetUs[static_cast<int>(FlightStage::Paint)] =
+        qRound(config.value("flightRecorder/paintBudgetMs", 50.0).toDouble() * 1000.0);
+    recorder.stageBudgetUs[static_cast<int>(FlightStage::FrameDelivery)] =
+        qRound(config.value("flightRecorder/frameDeliveryBudgetMs", 20.0).toDouble() * 1000.0);
+    FlightRecorder::instance().setConfig(recorder);
+    if (config.value("flightRecorder/enabled", true).toBool()) {
+        FlightRecorder::instance().start();
+    }
+}
+
+/**
+ * Replays a detection log through a fresh track manager and threat assessor
+ * as fast as possible, without a display, and prints the summary. Two builds
+ * given the same log print the same digest unless tracking changed.
+ */
+int runDetectionReplay(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("Counter-UAS C2");
+    
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"replay-detections", "Replay the detection log in <dir>.", "dir"});
+    parser.addOption({"replay-from", "Start of the window, ISO 8601 or epoch ms.", "time"});
+    parser.addOption({"replay-to", "End of the window, ISO 8601 or epoch ms.", "time"});
+    parser.addOption({"replay-output", "Write every replayed picture to <csv>.", "csv"});
+    parser.process(app);
+    
+    Logger::instance().setLogLevel(LogLevel::Info);
+    Logger::instance().setLogToConsole(true);
+    ConfigManager::instance().loadDefaults();
+    
+    TrackManager trackManager;
+    ThreatAssessor threatAssessor(&trackManager);
+    
+    // The defended asset MainWindow sets up, so proximity rules see the same site
+    DefendedAsset baseAsset;
+    baseAsset.id = "BASE-01";
+    baseAsset.name = "Main Installation";
+    baseAsset.position.latitude = 34.0522;
+    baseAsset.position.longitude = -118.2437;
+    baseAsset.position.altitude = 100.0;
+    baseAsset.criticalRadiusM = 500.0;
+    baseAsset.warningRadiusM = 1500.0;
+    baseAsset.priorityLevel = 5;
+    threatAssessor.addDefendedAsset(baseAsset);
+    
+    ReplayEngine engine(&trackManager, &threatAssessor);
+    const qint64 fromMs = parseReplayTime(parser.value("replay-from"), 0);
+    const qint64 toMs = parseReplayTime(parser.value("replay-to"), std::numeric_limits<qint64>::max());
+    if (engine.load(parser.value("replay-detections"), fromMs, toMs) == 0) {
+        Logger::instance().error("Main", "No detections to replay in " + parser.value("replay-detections"));
+        return 1;
+    }
+    engine.setOutputPath(parser.value("replay-output"));
+    
+    const ReplaySummary summary = engine.run();
+    QTextStream out(stdout);
+    out << "scans " << summary.scans << "\n"
+        << "detections " << summary.detections << "\n"
+        << "replay_ms " << (summary.endMs - summary.startMs) << "\n"
+        << "wall_ms " << summary.wallMs << "\n"
+        << "track_cycles " << summary.trackCycles << "\n"
+        << "assessment_cycles " << summary.assessmentCycles << "\n"
+        << "tracks_created " << summary.tracksCreated << "\n"
+        << "final_tracks " << summary.finalTrackCount << "\n"
+        << "alerts " << summary.alerts << "\n"
+        << "digest " << QString("%1").arg(summary.pictureDigest, 16, 16, QChar('0')) << "\n";
+    return 0;
+}
+
+/**
+ * Writes a range of the audit journal out as JSON or, for a .csv path, CSV.
+ */
+int runJournalExport(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("Counter-UAS C2");
+    
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"export-journal", "Export the audit journal to <file>, .json or .csv.", "file"});
+    parser.addOption({"journal-dir", "Journal directory.", "dir", "data/journal"});
+    parser.addOption({"journal-from", "Start of the range, ISO 8601 or epoch ms.", "time"});
+    parser.addOption({"journal-to", "End of the range, ISO 8601 or epoch ms.", "time"});
+    parser.process(app);
+    
+    Logger::instance().setLogToConsole(true);
+    const EventJournalReader reader(parser.value("journal-dir"));
+    const qint64 written = reader.exportRange(parser.value("export-journal"),
+        parseReplayTime(parser.value("journal-from"), 0),
+        parseReplayTime(parser.value("journal-to"), std::numeric_limits<qint64>::max()));
+    if (written < 0) return 1;
+    
+    QTextStream(stdout) << "events " << written << "\n";
+    return 0;
+}
+
+} // namespace
+
 int main(int argc, char *argv[])
 {
+    const qint64 startNs = TimeUtils::monotonicNs();
+    
+    // Headless replay needs no display
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--replay-detections") == 0) {
+            return runDetectionReplay(argc, argv);
+        }
+        if (qstrcmp(argv[i], "--export-journal") == 0) {
+            return runJournalExport(argc, argv);
+        }
+    }
+    
     // Set OpenGL format for video rendering
     QSurfaceFormat format;
     format.setDepthBufferSize(24);
@@ -65,30 +272,77 @@ int main(int argc, char *argv[])
     
     // Load configuration
     ConfigManager::instance().loadDefaults();
+    configureThreadPlacement();
+    configureMemoryGovernor();
+    configureOverloadController();
+    configureFlightRecorder();
+    ThreadPlacement::instance().enter(ThreadRole::Render);
     
-    // Initialize database
-    DatabaseManager::instance().initialize("data/counter_uas.db");
+    // Track and sensor threads hand entries to the log writer thread
+    Logger::instance().setAsync(ConfigManager::instance().value("system/asyncLogging", true).toBool());
     
-    // Create and show main window
+    // Journal recovery and the file stores open while the window is built
+    const QString databasePath = "data/counter_uas.db";
+    DatabaseManager::instance().openFileStoresAsync(databasePath);
+    
+    // Show the window shell first; everything else is brought up once
+    // the event loop has painted it
     MainWindow mainWindow;
+    mainWindow.setStartupTime(startNs);
     mainWindow.show();
     
     // Create track simulator for testing
     TrackSimulator simulator(mainWindow.trackManager());
-    simulator.start();
-    
-    // Start simulation automatically for demo
-    mainWindow.startSimulation();
+    QTimer historyTimer;
+    MetricsExporter metricsExporter;
     
-    Logger::instance().info("Main", "System initialized successfully");
+    QTimer::singleShot(0, &mainWindow, [&]() {
+        mainWindow.reportStartupMilestone("window shown");
+        
+        // Initialize database
+        DatabaseManager::instance().initialize(databasePath);
+        mainWindow.completeStartup();
+        
+        simulator.start();
+        
+        // Start simulation automatically for demo
+        mainWindow.startSimulation();
+        
+        // Record the track picture to the history database
+        const int historyHz = ConfigManager::instance().value("database/trackHistoryHz", 10).toInt();
+        if (historyHz > 0) {
+            TrackManager* trackManager = mainWindow.trackManager();
+            QObject::connect(&historyTimer, &QTimer::timeout, [trackManager]() {
+                // A replayed picture is already on record
+                if (trackManager->isReplayMode()) return;
+                DatabaseManager::instance().saveTrackPicture(*trackManager->snapshot());
+            });
+            historyTimer.start(1000 / historyHz);
+        }
+        
+        // Fleet monitoring scrape endpoint
+        ConfigManager& config = ConfigManager::instance();
+        if (config.value("metrics/enabled", false).toBool()) {
+            PipelineLatency::exportTo(MetricsRegistry::instance());
+            TaskScheduler::instance().exportTo(MetricsRegistry::instance());
+            metricsExporter.start(static_cast<quint16>(config.value("metrics/port", 9464).toInt()),
+                                  QHostAddress(config.value("metrics/bindAddress", "0.0.0.0").toString()));
+        }
+        
+        Logger::instance().info("Main", "System initialized successfully");
+    });
     
     int result = app.exec();
     
     // Cleanup
+    FlightRecorder::instance().stop();
     simulator.stop();
+    historyTimer.stop();
+    metricsExporter.stop();
     DatabaseManager::instance().close();
     
     Logger::instance().info("Main", "System shutdown complete");
+    Logger::instance().setAsync(false);
     
     return result;
 }
@@ -0,0 +1,517 @@
+#include "network/AlertSync.h"
+#include "core/ThreatAssessor.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+
+namespace CounterUAS {
+
+namespace {
+
+enum AlertSyncKind : quint8 {
+    KindOps = 1,        // Runs of one origin's ops in sequence
+    KindDigest = 2,     // The sender's version vector
+    KindState = 3       // Alerts and acknowledgements; versions in the last part
+};
+
+// Parts of a message stay well inside a UDP datagram
+constexpr int MAX_MESSAGE_BYTES = 8192;
+constexpr int DEFAULT_DIGEST_INTERVAL_MS = 5000;
+constexpr int ASK_INTERVAL_MS = 1000;
+
+void putVarint(QByteArray& out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+void putSigned(QByteArray& out, qint64 value) {
+    putVarint(out, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+
+void putString(QByteArray& out, const QString& value) {
+    const QByteArray utf8 = value.toUtf8();
+    putVarint(out, static_cast<quint64>(utf8.size()));
+    out.append(utf8);
+}
+
+struct SyncReader {
+    const char* pos;
+    const char* end;
+    bool ok = true;
+
+    quint64 varint() {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) break;
+            const quint8 byte = static_cast<quint8>(*pos++);
+            value |= static_cast<quint64>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    qint64 signedVarint() {
+        const quint64 raw = varint();
+        return static_cast<qint64>(raw >> 1) ^ -static_cast<qint64>(raw & 1);
+    }
+
+    quint8 byte() {
+        if (pos == end) {
+            ok = false;
+            return 0;
+        }
+        return static_cast<quint8>(*pos++);
+    }
+
+    QString string() {
+        const quint64 size = varint();
+        if (!ok || size > static_cast<quint64>(end - pos)) {
+            ok = false;
+            return QString();
+        }
+        QString value = QString::fromUtf8(pos, static_cast<int>(size));
+        pos += size;
+        return value;
+    }
+};
+
+void putTime(QByteArray& out, const QDateTime& time) {
+    putSigned(out, time.isValid() ? time.toMSecsSinceEpoch() : -1);
+}
+
+QDateTime readTime(SyncReader& reader) {
+    const qint64 ms = reader.signedVarint();
+    return ms >= 0 ? QDateTime::fromMSecsSinceEpoch(ms, Qt::UTC) : QDateTime();
+}
+
+// The op without its origin and sequence, which the container carries
+void putOp(QByteArray& out, const AlertOp& op) {
+    out.append(static_cast<char>(op.kind));
+    putString(out, op.alert.alertId);
+    putString(out, op.alert.trackId);
+    putVarint(out, op.alert.groupId);
+    putString(out, op.alert.ruleId);
+    if (op.kind == AlertOp::Kind::Raise) {
+        putString(out, op.alert.message);
+        putSigned(out, op.alert.threatLevel);
+        putTime(out, op.alert.timestamp);
+    } else {
+        putString(out, op.alert.acknowledgedBy);
+        putTime(out, op.alert.acknowledgedTime);
+    }
+}
+
+bool readOp(SyncReader& reader, AlertOp& op) {
+    const quint8 kind = reader.byte();
+    if (kind != static_cast<quint8>(AlertOp::Kind::Raise) &&
+        kind != static_cast<quint8>(AlertOp::Kind::Acknowledge)) {
+        return false;
+    }
+    op.kind = static_cast<AlertOp::Kind>(kind);
+    op.alert.alertId = reader.string();
+    op.alert.trackId = reader.string();
+    op.alert.groupId = static_cast<quint32>(reader.varint());
+    op.alert.ruleId = reader.string();
+    if (op.kind == AlertOp::Kind::Raise) {
+        op.alert.message = reader.string();
+        op.alert.threatLevel = static_cast<int>(reader.signedVarint());
+        op.alert.timestamp = readTime(reader);
+    } else {
+        op.alert.acknowledged = true;
+        op.alert.acknowledgedBy = reader.string();
+        op.alert.acknowledgedTime = readTime(reader);
+    }
+    return reader.ok && !op.alert.alertId.isEmpty();
+}
+
+void putVersions(QByteArray& out, const AlertVersionVector& versions) {
+    putVarint(out, static_cast<quint64>(versions.size()));
+    for (auto it = versions.constBegin(); it != versions.constEnd(); ++it) {
+        putString(out, it.key());
+        putVarint(out, it.value());
+    }
+}
+
+AlertVersionVector readVersions(SyncReader& reader) {
+    AlertVersionVector versions;
+    const quint64 count = reader.varint();
+    for (quint64 i = 0; i < count && reader.ok; ++i) {
+        const QString origin = reader.string();
+        const quint64 applied = reader.varint();
+        if (reader.ok) versions.insert(origin, applied);
+    }
+    return versions;
+}
+
+// Ops in messages of about MAX_MESSAGE_BYTES, each an origin's consecutive
+// ops sharing one header
+QVector<QByteArray> encodeOps(const QVector<AlertOp>& ops) {
+    QVector<QByteArray> messages;
+    int i = 0;
+    while (i < ops.size()) {
+        QByteArray runs;
+        quint64 runCount = 0;
+        while (i < ops.size() && runs.size() < MAX_MESSAGE_BYTES) {
+            const AlertOp& first = ops[i];
+            QByteArray bodies;
+            quint64 count = 0;
+            while (i < ops.size() && ops[i].origin == first.origin &&
+                   ops[i].sequence == first.sequence + count &&
+                   runs.size() + bodies.size() < MAX_MESSAGE_BYTES) {
+                putOp(bodies, ops[i]);
+                ++count;
+                ++i;
+            }
+            putString(runs, first.origin);
+            putVarint(runs, first.sequence);
+            putVarint(runs, count);
+            runs.append(bodies);
+            ++runCount;
+        }
+        QByteArray data;
+        data.append(static_cast<char>(KindOps));
+        putVarint(data, runCount);
+        data.append(runs);
+        messages.append(data);
+    }
+    return messages;
+}
+
+QByteArray payloadData(const Message& message) {
+    const QVariant data = message.payload.value("data");
+    // JSON-encoded frames carry the blob as base64
+    if (data.userType() == QMetaType::QString) {
+        return QByteArray::fromBase64(data.toString().toLatin1());
+    }
+    return data.toByteArray();
+}
+
+} // namespace
+
+AlertSync::AlertSync(NetworkManager* network, QObject* parent)
+    : QObject(parent)
+    , m_network(network)
+    , m_incarnation(QString::number(QDateTime::currentMSecsSinceEpoch(), 36))
+    , m_digestTimer(new QTimer(this))
+{
+    m_log.setOrigin(m_nodeId + QLatin1Char('@') + m_incarnation);
+    m_digestTimer->setInterval(DEFAULT_DIGEST_INTERVAL_MS);
+    connect(m_digestTimer, &QTimer::timeout, this, &AlertSync::broadcastDigest);
+
+    connect(m_network, &NetworkManager::messageReceived,
+            this, &AlertSync::onMessageReceived);
+    connect(m_network, &NetworkManager::connectionStatusChanged,
+            this, &AlertSync::onConnectionStatusChanged);
+}
+
+void AlertSync::setNodeId(const QString& nodeId) {
+    m_nodeId = nodeId;
+    // A new run of ops each start, so peers never take them for old ones
+    m_log.setOrigin(m_nodeId + QLatin1Char('@') + m_incarnation);
+}
+
+void AlertSync::attach(ThreatAssessor* assessor) {
+    if (m_assessor) {
+        QObject::disconnect(m_assessor, nullptr, this, nullptr);
+    }
+    m_assessor = assessor;
+    if (!m_assessor) {
+        m_digestTimer->stop();
+        return;
+    }
+
+    m_assessor->setAlertIdPrefix(m_nodeId);
+    m_log.setCapacity(qMax(m_log.capacity(), m_assessor->config().alertQueueMaxSize));
+    connect(m_assessor, &ThreatAssessor::newAlert, this, &AlertSync::onNewAlert);
+    connect(m_assessor, &ThreatAssessor::alertAcknowledged, this, &AlertSync::onAlertAcknowledged);
+    connect(m_assessor, &ThreatAssessor::alertsRestored, this, &AlertSync::onAlertsRestored);
+    seed();
+    m_digestTimer->start();
+}
+
+void AlertSync::setDigestInterval(int intervalMs) {
+    m_digestTimer->setInterval(qMax(100, intervalMs));
+}
+
+TypedMessage AlertSync::makeMessage(const QByteArray& data) const {
+    TypedMessage msg;
+    msg.timestamp = QDateTime::currentMSecsSinceEpoch();
+    msg.sourceId = m_nodeId;
+    msg.body = DynamicBody{MessageType::AlertSync, {{"data", data}}};
+    return msg;
+}
+
+void AlertSync::sendTo(const QString& connectionId, const QByteArray& data) {
+    if (connectionId.isEmpty()) {
+        m_network->broadcast(makeMessage(data));
+    } else {
+        m_network->send(connectionId, makeMessage(data));
+    }
+    m_stats.bytesSent += data.size();
+}
+
+void AlertSync::seed() {
+    // Alerts the assessor already holds, from a checkpoint or before attach()
+    QVector<AlertChange> changes;
+    for (const ThreatAlert& alert : m_assessor->alerts()) {
+        share(m_log.raise(alert, &changes));
+        if (alert.acknowledged) {
+            share(m_log.acknowledge(alert.alertId, alert.acknowledgedBy, alert.acknowledgedTime, &changes));
+        }
+    }
+    applyChanges(changes);
+}
+
+void AlertSync::onNewAlert(const ThreatAlert& alert) {
+    if (m_merging) return;
+    QVector<AlertChange> changes;
+    share(m_log.raise(alert, &changes));
+    applyChanges(changes);  // A peer's acknowledgement may already cover it
+}
+
+void AlertSync::onAlertAcknowledged(const QString& alertId) {
+    if (m_merging || !m_assessor) return;
+    const ThreatAlert* alert = m_assessor->alert(alertId);
+    if (!alert) return;
+
+    QVector<AlertChange> changes;
+    share(m_log.acknowledge(alertId, alert->acknowledgedBy, alert->acknowledgedTime, &changes));
+    applyChanges(changes);  // Other consoles' copies of the same threat
+}
+
+void AlertSync::onAlertsRestored() {
+    if (m_merging) return;
+    seed();
+}
+
+void AlertSync::share(const AlertOp& op) {
+    if (op.isNull()) return;
+    m_outgoing.append(op);
+    scheduleFlush();
+}
+
+void AlertSync::scheduleFlush() {
+    // Ops made in one event-loop turn go out together
+    if (m_flushPending) return;
+    m_flushPending = true;
+    QTimer::singleShot(0, this, &AlertSync::flush);
+}
+
+void AlertSync::flush() {
+    m_flushPending = false;
+
+    if (!m_outgoing.isEmpty()) {
+        for (const QByteArray& data : encodeOps(m_outgoing)) {
+            sendTo(QString(), data);
+        }
+        m_stats.opsSent += m_outgoing.size();
+        m_outgoing.clear();
+    }
+
+    if (m_relayed.isEmpty()) return;
+    for (const QString& connectionId : m_network->connectionIds()) {
+        QVector<AlertOp> ops;
+        for (const auto& relayed : m_relayed) {
+            if (relayed.first != connectionId) ops.append(relayed.second);
+        }
+        for (const QByteArray& data : encodeOps(ops)) {
+            sendTo(connectionId, data);
+        }
+        m_stats.opsSent += ops.size();
+    }
+    m_relayed.clear();
+}
+
+void AlertSync::applyChanges(const QVector<AlertChange>& changes) {
+    if (!m_assessor || changes.isEmpty()) return;
+    m_merging = true;
+    for (const AlertChange& change : changes) {
+        if (change.kind == AlertChange::Kind::Raised) {
+            m_assessor->mergeAlert(change.alert);
+        } else {
+            m_assessor->mergeAcknowledgement(change.alert.alertId, change.alert.acknowledgedBy,
+                                             change.alert.acknowledgedTime);
+        }
+    }
+    m_merging = false;
+}
+
+void AlertSync::broadcastDigest() {
+    if (m_network->connectionIds().isEmpty()) return;
+    sendDigest(QString());
+}
+
+void AlertSync::sendDigest(const QString& connectionId) {
+    QByteArray data;
+    data.append(static_cast<char>(KindDigest));
+    putVersions(data, m_log.versions());
+    sendTo(connectionId, data);
+    ++m_stats.digestsSent;
+}
+
+void AlertSync::askForOps(const QString& connectionId) {
+    Peer& peer = m_peers[connectionId];
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - peer.lastDigestMs < ASK_INTERVAL_MS) return;
+    peer.lastDigestMs = now;
+    sendDigest(connectionId);
+}
+
+void AlertSync::onConnectionStatusChanged(const QString& connectionId, ConnectionStatus status) {
+    if (status == ConnectionStatus::Connected) {
+        if (m_assessor) sendDigest(connectionId);  // Catch up both ways without waiting an interval
+    } else {
+        m_peers.remove(connectionId);
+    }
+}
+
+void AlertSync::onMessageReceived(const QString& connectionId, const Message& message) {
+    if (message.type != MessageType::AlertSync || !m_assessor) return;
+
+    const QByteArray data = payloadData(message);
+    bool ok = !data.isEmpty();
+    if (ok) {
+        switch (static_cast<quint8>(data.at(0))) {
+        case KindOps:
+            ok = applyOps(connectionId, data);
+            break;
+        case KindDigest: {
+            SyncReader reader{data.constData() + 1, data.constData() + data.size()};
+            const AlertVersionVector theirs = readVersions(reader);
+            ok = reader.ok;
+            if (ok) answerDigest(connectionId, theirs);
+            break;
+        }
+        case KindState:
+            ok = applyState(data);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+    }
+    if (!ok) {
+        Logger::instance().warning("AlertSync", "Malformed alert sync from " + connectionId);
+    }
+}
+
+bool AlertSync::applyOps(const QString& connectionId, const QByteArray& data) {
+    SyncReader reader{data.constData() + 1, data.constData() + data.size()};
+    QVector<AlertChange> changes;
+    bool gap = false;
+
+    const quint64 runs = reader.varint();
+    for (quint64 r = 0; r < runs && reader.ok; ++r) {
+        const QString origin = reader.string();
+        const quint64 first = reader.varint();
+        const quint64 count = reader.varint();
+        bool skip = false;
+        for (quint64 i = 0; i < count && reader.ok; ++i) {
+            AlertOp op;
+            op.origin = origin;
+            op.sequence = first + i;
+            if (!readOp(reader, op)) {
+                reader.ok = false;
+                break;
+            }
+            if (skip) continue;
+
+            switch (m_log.apply(op, &changes)) {
+            case ReplicatedAlertLog::ApplyResult::Applied:
+                ++m_stats.opsApplied;
+                if (m_relay) m_relayed.append(qMakePair(connectionId, op));
+                break;
+            case ReplicatedAlertLog::ApplyResult::Gap:
+                skip = true;    // The rest of the run follows the missing ops
+                gap = true;
+                break;
+            case ReplicatedAlertLog::ApplyResult::Duplicate:
+                break;
+            }
+        }
+    }
+    applyChanges(changes);
+    if (!m_relayed.isEmpty()) scheduleFlush();
+
+    if (gap) {
+        ++m_stats.gapsDetected;
+        askForOps(connectionId);
+    }
+    return reader.ok;
+}
+
+void AlertSync::answerDigest(const QString& connectionId, const AlertVersionVector& theirs) {
+    QVector<AlertOp> ops;
+    if (!m_log.opsSince(theirs, ops)) {
+        sendState(connectionId);
+    } else if (!ops.isEmpty()) {
+        for (const QByteArray& data : encodeOps(ops)) {
+            sendTo(connectionId, data);
+        }
+        m_stats.opsSent += ops.size();
+    }
+
+    // And the other way, when the peer has ops this node lacks
+    const AlertVersionVector ours = m_log.versions();
+    for (auto it = theirs.constBegin(); it != theirs.constEnd(); ++it) {
+        if (it.value() > ours.value(it.key())) {
+            askForOps(connectionId);
+            break;
+        }
+    }
+}
+
+void AlertSync::sendState(const QString& connectionId) {
+    Peer& peer = m_peers[connectionId];
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - peer.lastStateMs < ASK_INTERVAL_MS) return;
+    peer.lastStateMs = now;
+
+    // Versions go in the last part only, so a lost part never claims ops
+    // the peer does not have
+    const QVector<AlertOp> state = m_log.state();
+    int i = 0;
+    do {
+        QByteArray ops;
+        quint64 count = 0;
+        while (i < state.size() && ops.size() < MAX_MESSAGE_BYTES) {
+            putString(ops, state[i].origin);
+            putVarint(ops, state[i].sequence);
+            putOp(ops, state[i]);
+            ++count;
+            ++i;
+        }
+        QByteArray data;
+        data.append(static_cast<char>(KindState));
+        putVarint(data, count);
+        data.append(ops);
+        putVersions(data, i < state.size() ? AlertVersionVector() : m_log.versions());
+        sendTo(connectionId, data);
+    } while (i < state.size());
+    ++m_stats.statesSent;
+}
+
+bool AlertSync::applyState(const QByteArray& data) {
+    SyncReader reader{data.constData() + 1, data.constData() + data.size()};
+    QVector<AlertOp> state;
+    const quint64 count = reader.varint();
+    for (quint64 i = 0; i < count && reader.ok; ++i) {
+        AlertOp op;
+        op.origin = reader.string();
+        op.sequence = reader.varint();
+        if (!readOp(reader, op)) return false;
+        state.append(op);
+    }
+    const AlertVersionVector versions = readVersions(reader);
+    if (!reader.ok) return false;
+
+    QVector<AlertChange> changes;
+    m_log.merge(state, versions, &changes);
+    applyChanges(changes);
+    return true;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,120 @@
+#ifndef ALERTSYNC_H
+#define ALERTSYNC_H
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QTimer>
+#include <QVector>
+#include "core/ReplicatedAlertLog.h"
+#include "network/NetworkManager.h"
+
+namespace CounterUAS {
+
+class ThreatAssessor;
+
+/**
+ * @brief Alerts and their acknowledgements shared between C2 nodes
+ *
+ * Every alert the attached assessor raises and every acknowledgement an
+ * operator makes is an op in a ReplicatedAlertLog, and peers applying the
+ * ops end up with the same alerts, acknowledged the same way, whatever
+ * order they arrived in. What peers merge is handed to the assessor, so
+ * the alert queue, journal and checkpoints see it like a local alert, and
+ * the assessor's duplicate suppression then stops the other consoles
+ * raising the same threat again.
+ *
+ * Own ops are broadcast in one AlertSync message per event-loop turn,
+ * coded as varints with each origin's sequence sent once per run, so an
+ * acknowledgement is a few dozen bytes and reaches every peer before the
+ * next cycle. Nothing is resent on a timer: instead each node broadcasts
+ * its version vector, a digest of a few bytes per node, every digest
+ * interval and to each peer on connect. A peer holding ops the digest
+ * lacks answers with them, or with its whole state once its log no longer
+ * reaches back far enough. A node seeing a gap in an origin's sequence
+ * asks with its digest at once, no more than once a second per peer.
+ *
+ * With relaying on, ops from one peer are passed on to the others, for
+ * meshes where not every node links to every other; otherwise digests
+ * carry them across within one interval. Clearing alerts stays local.
+ */
+class AlertSync : public QObject {
+    Q_OBJECT
+
+public:
+    explicit AlertSync(NetworkManager* network, QObject* parent = nullptr);
+
+    // Prefixes this node's alert ids; set before attach()
+    void setNodeId(const QString& nodeId);
+    QString nodeId() const { return m_nodeId; }
+
+    // Shares the assessor's alerts and merges the peers' into it; nullptr
+    // stops sharing
+    void attach(ThreatAssessor* assessor);
+
+    void setDigestInterval(int intervalMs);
+    int digestInterval() const { return m_digestTimer->interval(); }
+
+    void setRelay(bool relay) { m_relay = relay; }
+    bool relay() const { return m_relay; }
+
+    const ReplicatedAlertLog& log() const { return m_log; }
+
+    struct Stats {
+        qint64 opsSent = 0;
+        qint64 opsApplied = 0;          // Peers' ops new to this node
+        qint64 digestsSent = 0;
+        qint64 statesSent = 0;
+        qint64 gapsDetected = 0;
+        qint64 bytesSent = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+private slots:
+    void onNewAlert(const ThreatAlert& alert);
+    void onAlertAcknowledged(const QString& alertId);
+    void onAlertsRestored();
+    void onMessageReceived(const QString& connectionId, const Message& message);
+    void onConnectionStatusChanged(const QString& connectionId, ConnectionStatus status);
+    void broadcastDigest();
+
+private:
+    struct Peer {
+        qint64 lastDigestMs = 0;        // Last asked, on a gap or when behind
+        qint64 lastStateMs = 0;
+    };
+
+    TypedMessage makeMessage(const QByteArray& data) const;
+    void sendTo(const QString& connectionId, const QByteArray& data);
+    void share(const AlertOp& op);
+    void scheduleFlush();
+    void flush();
+    void seed();
+    void applyChanges(const QVector<AlertChange>& changes);
+    void sendDigest(const QString& connectionId);
+    void askForOps(const QString& connectionId);
+    void answerDigest(const QString& connectionId, const AlertVersionVector& theirs);
+    void sendState(const QString& connectionId);
+    bool applyOps(const QString& connectionId, const QByteArray& data);
+    bool applyState(const QByteArray& data);
+
+    NetworkManager* m_network;
+    ThreatAssessor* m_assessor = nullptr;
+    QString m_nodeId = QStringLiteral("C2");
+    QString m_incarnation;
+    QTimer* m_digestTimer;
+    bool m_relay = false;
+
+    ReplicatedAlertLog m_log;
+    QVector<AlertOp> m_outgoing;                    // Own ops not yet broadcast
+    QVector<QPair<QString, AlertOp>> m_relayed;     // Peers' ops to pass on, by source
+    bool m_flushPending = false;
+    bool m_merging = false;         // The assessor's signals echo what was merged
+
+    QHash<QString, Peer> m_peers;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // ALERTSYNC_H
@@ -0,0 +1,134 @@
+#include "network/CoreClient.h"
+#include "network/NetworkManager.h"
+#include "network/SharedMemorySubscriber.h"
+#include "network/TrackPictureSync.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+#include <QTimer>
+
+namespace CounterUAS {
+
+CoreClient::CoreClient(QObject* parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    // Once the deltas of one sync message are in
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(0);
+    connect(m_flushTimer, &QTimer::timeout, this, &CoreClient::flushRemote);
+}
+
+CoreClient::~CoreClient() {
+    stop();
+}
+
+bool CoreClient::start(const CoreClientConfig& config) {
+    stop();
+    m_config = config;
+    m_error.clear();
+    if (!m_trackManager) {
+        m_error = QStringLiteral("No track manager");
+        return false;
+    }
+    if (m_config.sharedMemoryKey.isEmpty() && !m_config.multicast) {
+        m_error = QStringLiteral("No core to attach to");
+        return false;
+    }
+    m_trackManager->setMirrorMode(true);
+
+    if (!m_config.sharedMemoryKey.isEmpty()) {
+        SharedMemoryConfig shm;
+        shm.key = m_config.sharedMemoryKey;
+        shm.readVideo = false;
+        m_subscriber = new SharedMemorySubscriber(this);
+        connect(m_subscriber, &SharedMemorySubscriber::pictureUpdated, this, &CoreClient::onPicture);
+        connect(m_subscriber, &SharedMemorySubscriber::attachedChanged, this, &CoreClient::setAttached);
+        // Keeps trying while the core is not up yet
+        m_subscriber->start(shm);
+    } else {
+        m_network = new NetworkManager(this);
+        m_sync = new TrackPictureSync(m_network, this);
+        connect(m_sync, &TrackPictureSync::remoteTrackUpdated, this,
+                [this](const QString&, const TrackSnapshot& track) { onRemoteTrackUpdated(track); });
+        connect(m_sync, &TrackPictureSync::remoteTrackDropped, this,
+                [this](const QString&, const QString& trackId) { onRemoteTrackDropped(trackId); });
+        connect(m_sync, &TrackPictureSync::remotePictureResynced, this,
+                [this]() { setAttached(true); });
+        if (!m_network->joinMulticast(m_config.multicastGroup)) {
+            m_error = "Cannot join multicast group " + m_config.multicastGroup.group.toString();
+            stop();
+            return false;
+        }
+    }
+
+    m_running = true;
+    Logger::instance().info("CoreClient", "Following the core at " +
+                            (m_subscriber ? m_config.sharedMemoryKey : m_config.multicastGroup.group.toString()));
+    return true;
+}
+
+void CoreClient::stop() {
+    const bool following = m_subscriber || m_network;
+    m_flushTimer->stop();
+    m_updated.clear();
+    m_dropped.clear();
+    delete m_subscriber;
+    m_subscriber = nullptr;
+    delete m_sync;
+    m_sync = nullptr;
+    delete m_network;
+    m_network = nullptr;
+    setAttached(false);
+    if (following && m_trackManager) {
+        m_trackManager->setMirrorMode(false);
+    }
+    m_running = false;
+}
+
+void CoreClient::setAttached(bool attached) {
+    if (m_attached == attached) return;
+    m_attached = attached;
+    if (!attached && m_trackManager && m_trackManager->isMirrorMode()) {
+        // A picture nobody updates any more would look live
+        m_trackManager->clearAllTracks();
+        Logger::instance().warning("CoreClient", "Lost the core; picture cleared");
+    }
+    emit attachedChanged(attached);
+}
+
+void CoreClient::onPicture(const TrackPicturePtr& picture) {
+    m_trackManager->applyMirrorPicture(picture);
+    m_stats.picturesApplied++;
+}
+
+void CoreClient::onRemoteTrackUpdated(const TrackSnapshot& track) {
+    m_updated.insert(track.trackId, track);
+    m_dropped.removeAll(track.trackId);
+    m_flushTimer->start();
+}
+
+void CoreClient::onRemoteTrackDropped(const QString& trackId) {
+    m_updated.remove(trackId);
+    m_dropped.append(trackId);
+    m_flushTimer->start();
+}
+
+void CoreClient::flushRemote() {
+    if (m_updated.isEmpty() && m_dropped.isEmpty()) return;
+
+    // The stream carries no update times; the tracks are as of now
+    QVector<TrackSnapshot> updated;
+    updated.reserve(m_updated.size());
+    for (const TrackSnapshot& track : qAsConst(m_updated)) {
+        updated.append(track);
+    }
+    m_trackManager->applyMirrorTracks(updated, m_dropped, QDateTime::currentMSecsSinceEpoch());
+    m_stats.batchesApplied++;
+    m_stats.tracksUpdated += updated.size();
+    m_stats.tracksDropped += m_dropped.size();
+    m_updated.clear();
+    m_dropped.clear();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,89 @@
+#ifndef CORECLIENT_H
+#define CORECLIENT_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include "core/TrackSnapshot.h"
+#include "network/MulticastPublisher.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+class NetworkManager;
+class SharedMemorySubscriber;
+class TrackManager;
+class TrackPictureSync;
+
+/**
+ * @brief Where a console finds its core
+ */
+struct CoreClientConfig {
+    QString sharedMemoryKey;            // A core on this host; read from its segment
+    bool multicast = false;             // A remote core, by its delta picture sync
+    MulticastConfig multicastGroup;
+};
+
+/**
+ * @brief Attaches a console's TrackManager to a CounterUAS_Core
+ *
+ * The manager is put in mirror mode, so the console runs no fusion of its
+ * own and shows the core's tracks under the core's ids. Locally the whole
+ * picture is taken from the shared-memory segment every time it moves;
+ * remotely the TrackPictureSync stream is followed, and the tracks each
+ * burst of deltas touched are applied together. Losing a local core
+ * clears the picture rather than leave it frozen.
+ */
+class CoreClient : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CoreClient(QObject* parent = nullptr);
+    ~CoreClient() override;
+
+    // Must outlive the client; left in mirror mode until stop()
+    void setTrackManager(TrackManager* trackManager) { m_trackManager = trackManager; }
+
+    bool start(const CoreClientConfig& config);
+    void stop();
+    bool isRunning() const { return m_running; }
+    bool isAttached() const { return m_attached; }
+    QString errorString() const { return m_error; }
+
+    struct Stats {
+        qint64 picturesApplied = 0;     // Whole pictures from shared memory
+        qint64 batchesApplied = 0;      // Delta bursts from the sync stream
+        qint64 tracksUpdated = 0;
+        qint64 tracksDropped = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+signals:
+    void attachedChanged(bool attached);
+
+private:
+    void setAttached(bool attached);
+    void onPicture(const TrackPicturePtr& picture);
+    void onRemoteTrackUpdated(const TrackSnapshot& track);
+    void onRemoteTrackDropped(const QString& trackId);
+    void flushRemote();
+
+    CoreClientConfig m_config;
+    TrackManager* m_trackManager = nullptr;
+    SharedMemorySubscriber* m_subscriber = nullptr;
+    NetworkManager* m_network = nullptr;
+    TrackPictureSync* m_sync = nullptr;
+    QTimer* m_flushTimer;
+    QHash<QString, TrackSnapshot> m_updated;    // Since the last flush
+    QStringList m_dropped;
+    bool m_running = false;
+    bool m_attached = false;
+    QString m_error;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // CORECLIENT_H
@@ -0,0 +1,113 @@
+#include "network/FrameReader.h"
+#include <QtGlobal>
+#include <cstring>
+
+namespace CounterUAS {
+
+FrameReader::FrameReader(int initialCapacity) {
+    grow(qMax(initialCapacity, MessageProtocol::HEADER_SIZE));
+}
+
+char* FrameReader::writeRegion(int& available) {
+    if (m_size == m_ring.size()) {
+        grow(m_ring.size() * 2);
+    }
+    if (m_size == 0) {
+        m_head = 0;  // Empty: hand out the whole ring in one piece
+    }
+
+    const int tail = (m_head + m_size) & mask();
+    available = tail >= m_head ? m_ring.size() - tail : m_head - tail;
+    return m_ring.data() + tail;
+}
+
+void FrameReader::commit(int bytes) {
+    m_size += qBound(0, bytes, m_ring.size() - m_size);
+}
+
+void FrameReader::append(const char* data, int size) {
+    while (size > 0) {
+        int available = 0;
+        char* region = writeRegion(available);
+        const int chunk = qMin(available, size);
+        std::memcpy(region, data, chunk);
+        commit(chunk);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+bool FrameReader::next(FrameHeader& header, const char*& payload) {
+    char raw[MessageProtocol::HEADER_SIZE];
+    for (;;) {
+        if (m_size < MessageProtocol::HEADER_SIZE) return false;
+
+        copyOut(0, raw, MessageProtocol::HEADER_SIZE);
+        if (MessageProtocol::parseHeader(raw, MessageProtocol::HEADER_SIZE, header) > 0) break;
+
+        // Not a frame boundary; slide forward until one lines up
+        consume(1);
+        ++m_discarded;
+    }
+
+    const int frameSize = MessageProtocol::HEADER_SIZE + header.payloadSize;
+    if (m_size < frameSize) {
+        if (frameSize > m_ring.size()) {
+            grow(frameSize);  // Room for the whole frame before it arrives
+        }
+        return false;
+    }
+
+    const int start = (m_head + MessageProtocol::HEADER_SIZE) & mask();
+    if (start + header.payloadSize <= m_ring.size()) {
+        payload = m_ring.constData() + start;
+    } else {
+        if (m_scratch.size() < header.payloadSize) {
+            m_scratch.resize(header.payloadSize);
+            m_account.set(qint64(m_ring.size()) + m_scratch.size());
+        }
+        copyOut(MessageProtocol::HEADER_SIZE, m_scratch.data(), header.payloadSize);
+        payload = m_scratch.constData();
+    }
+
+    // The bytes stay put until the next write, so the payload outlives this
+    consume(frameSize);
+    return true;
+}
+
+void FrameReader::clear() {
+    m_head = 0;
+    m_size = 0;
+}
+
+void FrameReader::copyOut(int offset, char* dest, int count) const {
+    const int start = (m_head + offset) & mask();
+    const int first = qMin(count, m_ring.size() - start);
+    std::memcpy(dest, m_ring.constData() + start, first);
+    std::memcpy(dest + first, m_ring.constData(), count - first);
+}
+
+void FrameReader::consume(int count) {
+    m_head = (m_head + count) & mask();
+    m_size -= count;
+    if (m_size == 0) {
+        m_head = 0;
+    }
+}
+
+void FrameReader::grow(int minCapacity) {
+    int capacity = qMax(m_ring.size(), 1);
+    while (capacity < minCapacity) capacity *= 2;
+    if (capacity == m_ring.size()) return;
+
+    // Linearize into the new ring so the unread bytes start at zero
+    QByteArray ring(capacity, Qt::Uninitialized);
+    if (m_size > 0) {
+        copyOut(0, ring.data(), m_size);
+    }
+    m_ring = ring;
+    m_head = 0;
+    m_account.set(qint64(m_ring.size()) + m_scratch.size());
+}
+
+} // namespace CounterUAS
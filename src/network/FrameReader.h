@@ -0,0 +1,60 @@
+#ifndef FRAMEREADER_H
+#define FRAMEREADER_H
+
+#include <QByteArray>
+#include "network/MessageProtocol.h"
+#include "utils/MemoryAccounting.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Ring-buffered receive stream that splits out protocol frames
+ *
+ * Sockets read straight into the ring's free space, and next() parses the
+ * header in place and returns a pointer to the payload inside the ring, so
+ * consuming a frame is an index bump rather than a copy and a memmove. Only
+ * a payload that wraps past the end of the ring is linearized, into a
+ * scratch buffer that is reused. Memory is allocated only when the ring or
+ * scratch has to grow; steady traffic allocates nothing here.
+ *
+ * Bytes that cannot start a frame (bad magic or oversized length) are
+ * skipped one at a time until the stream resynchronizes, and counted.
+ */
+class FrameReader {
+public:
+    explicit FrameReader(int initialCapacity = 64 * 1024);
+
+    int size() const { return m_size; }
+    int capacity() const { return m_ring.size(); }
+    qint64 discardedBytes() const { return m_discarded; }
+
+    // Contiguous free space for a direct socket read, growing the ring when
+    // it is full; follow with commit() of the bytes actually written
+    char* writeRegion(int& available);
+    void commit(int bytes);
+
+    void append(const char* data, int size);
+
+    // Extracts the next complete frame. payload stays valid until the next
+    // write or next() call. Returns false when more data is needed.
+    bool next(FrameHeader& header, const char*& payload);
+
+    void clear();
+
+private:
+    int mask() const { return m_ring.size() - 1; }
+    void copyOut(int offset, char* dest, int count) const;
+    void consume(int count);
+    void grow(int minCapacity);
+
+    QByteArray m_ring;     // Power-of-two capacity
+    int m_head = 0;        // Oldest unread byte
+    int m_size = 0;
+    QByteArray m_scratch;  // Linearized copy of a wrapped payload
+    qint64 m_discarded = 0;
+    MemoryAccount m_account{MemoryTag::NetworkBuffers};   // Ring and scratch
+};
+
+} // namespace CounterUAS
+
+#endif // FRAMEREADER_H
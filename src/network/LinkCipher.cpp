@@ -0,0 +1,147 @@
+#include "network/LinkCipher.h"
+#include "utils/TimeUtils.h"
+#include <QCryptographicHash>
+#include <QMessageAuthenticationCode>
+#include <QPasswordDigestor>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int KEY_ITERATIONS = 20000;
+constexpr quint16 RECORD_TYPE = 0xFFFF;
+
+QByteArray hmacSha256(const QByteArray& key, const QByteArray& message) {
+    return QMessageAuthenticationCode::hash(message, key, QCryptographicHash::Sha256);
+}
+
+void writeHeader(quint32 record, int payloadSize, quint8* out) {
+    qToBigEndian<quint32>(MessageProtocol::SEALED_MAGIC, out);
+    qToBigEndian<quint16>(RECORD_TYPE, out + 4);
+    qToBigEndian<quint32>(record, out + 6);
+    qToBigEndian<qint64>(0, out + 10);
+    qToBigEndian<quint32>(static_cast<quint32>(payloadSize), out + 18);
+}
+
+} // namespace
+
+void EncryptionStats::add(const EncryptionStats& other) {
+    recordsSealed += other.recordsSealed;
+    bytesSealed += other.bytesSealed;
+    sealNs += other.sealNs;
+    recordsOpened += other.recordsOpened;
+    bytesOpened += other.bytesOpened;
+    openNs += other.openNs;
+    rejected += other.rejected;
+    unsealedDropped += other.unsealedDropped;
+}
+
+QByteArray LinkCipher::deriveLinkKey(const QString& username, const QString& password) {
+    return QPasswordDigestor::deriveKeyPbkdf2(QCryptographicHash::Sha256, password.toUtf8(),
+                                              QByteArray("CUAS link ") + username.toUtf8(),
+                                              KEY_ITERATIONS, ChaCha20Poly1305::KEY_SIZE);
+}
+
+void LinkCipher::setLinkKey(const QByteArray& key) {
+    m_linkKey = key;
+    endSession();
+}
+
+void LinkCipher::startSession() {
+    endSession();
+    m_localNonce.resize(SESSION_NONCE_SIZE);
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32*>(m_localNonce.data()),
+                                          SESSION_NONCE_SIZE / sizeof(quint32));
+}
+
+void LinkCipher::endSession() {
+    m_localNonce.clear();
+    m_keyed = false;
+    m_send = ChaCha20Poly1305();
+    m_receive = ChaCha20Poly1305();
+    m_sendRecord = 0;
+    m_receiveRecord = 0;
+}
+
+bool LinkCipher::acceptPeerNonce(const QByteArray& nonce) {
+    if (!isEnabled() || m_localNonce.isEmpty() || nonce.size() != SESSION_NONCE_SIZE) return false;
+    if (m_keyed) return true;
+
+    m_send.setKey(reinterpret_cast<const quint8*>(sessionKey(m_localNonce, nonce).constData()));
+    m_receive.setKey(reinterpret_cast<const quint8*>(sessionKey(nonce, m_localNonce).constData()));
+    m_keyed = true;
+    return true;
+}
+
+QByteArray LinkCipher::sessionKey(const QByteArray& senderNonce, const QByteArray& receiverNonce) const {
+    // HKDF-SHA256 (RFC 5869): the nonces salt the link key, one block expands it
+    const QByteArray prk = hmacSha256(senderNonce + receiverNonce, m_linkKey);
+    return hmacSha256(prk, QByteArray("CUAS link v1") + char(1));
+}
+
+void LinkCipher::recordNonce(quint32 record, quint8* nonce) {
+    std::memset(nonce, 0, 4);
+    qToBigEndian<quint64>(record, nonce + 4);
+}
+
+QByteArray LinkCipher::seal(const QByteArray& frames, EncryptionStats* stats) {
+    if (!m_keyed || isExhausted()) return QByteArray();
+    const qint64 startNs = TimeUtils::monotonicNs();
+
+    const int sealedSize = frames.size() + ChaCha20Poly1305::TAG_SIZE;
+    QByteArray record(MessageProtocol::HEADER_SIZE + sealedSize, Qt::Uninitialized);
+    quint8* out = reinterpret_cast<quint8*>(record.data());
+    writeHeader(m_sendRecord, sealedSize, out);
+    std::memcpy(out + MessageProtocol::HEADER_SIZE, frames.constData(), frames.size());
+
+    quint8 nonce[ChaCha20Poly1305::NONCE_SIZE];
+    recordNonce(m_sendRecord, nonce);
+    m_send.seal(nonce, out, MessageProtocol::HEADER_SIZE,
+                out + MessageProtocol::HEADER_SIZE, frames.size(),
+                out + MessageProtocol::HEADER_SIZE + frames.size());
+    ++m_sendRecord;
+
+    if (stats) {
+        stats->recordsSealed++;
+        stats->bytesSealed += frames.size();
+        stats->sealNs += TimeUtils::monotonicNs() - startNs;
+    }
+    return record;
+}
+
+bool LinkCipher::open(const FrameHeader& header, const char* payload, QByteArray& plain,
+                      EncryptionStats* stats) {
+    const int size = header.payloadSize - ChaCha20Poly1305::TAG_SIZE;
+    if (!m_keyed || !header.sealed || size < 0 || header.sequenceNumber != m_receiveRecord ||
+        static_cast<quint16>(header.type) != RECORD_TYPE || header.timestamp != 0) {
+        if (stats) stats->rejected++;
+        return false;
+    }
+    const qint64 startNs = TimeUtils::monotonicNs();
+
+    quint8 aad[MessageProtocol::HEADER_SIZE];
+    writeHeader(header.sequenceNumber, header.payloadSize, aad);
+    quint8 nonce[ChaCha20Poly1305::NONCE_SIZE];
+    recordNonce(header.sequenceNumber, nonce);
+
+    QByteArray opened(payload, size);
+    if (!m_receive.open(nonce, aad, sizeof(aad), reinterpret_cast<quint8*>(opened.data()), size,
+                        reinterpret_cast<const quint8*>(payload + size))) {
+        if (stats) stats->rejected++;
+        return false;
+    }
+    ++m_receiveRecord;
+    plain = opened;
+
+    if (stats) {
+        stats->recordsOpened++;
+        stats->bytesOpened += size;
+        stats->openNs += TimeUtils::monotonicNs() - startNs;
+    }
+    return true;
+}
+
+} // namespace CounterUAS
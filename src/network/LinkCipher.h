@@ -0,0 +1,90 @@
+#ifndef LINKCIPHER_H
+#define LINKCIPHER_H
+
+#include <QByteArray>
+#include <QString>
+#include "network/MessageProtocol.h"
+#include "utils/ChaCha20Poly1305.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Link encryption counters, per connection
+ */
+struct EncryptionStats {
+    qint64 recordsSealed = 0;
+    qint64 bytesSealed = 0;         // Frame bytes before sealing
+    qint64 sealNs = 0;
+    qint64 recordsOpened = 0;
+    qint64 bytesOpened = 0;
+    qint64 openNs = 0;
+    qint64 rejected = 0;            // Failed authentication, or out of sequence
+    qint64 unsealedDropped = 0;     // Clear frames on an encrypted link
+
+    void add(const EncryptionStats& other);
+};
+
+/**
+ * @brief ChaCha20-Poly1305 records over one TCP link
+ *
+ * Both ends hold the same link key, derived from the connection's
+ * credentials. Each link-up the ends swap a random nonce on the clear
+ * heartbeat and derive a key per direction from the pair with HKDF, so no
+ * session key is ever reused across connections even though the link key
+ * is.
+ *
+ * seal() wraps whatever frames a send pass wrote in one record, so the
+ * cost is one tag and one header per batch rather than per frame. The
+ * record is itself a frame (SEALED_MAGIC) whose sequenceNumber counts
+ * records from zero in each direction: it is the AEAD nonce, and open()
+ * takes only the next number in order, which rejects replayed, dropped
+ * and reordered records on the ordered TCP stream. The header is the
+ * additional data, so it cannot be altered either.
+ */
+class LinkCipher {
+public:
+    static constexpr int SESSION_NONCE_SIZE = 16;
+    static constexpr int MAX_RECORD_BYTES = 64 * 1024;          // Frames per record, before sealing
+    static constexpr int RECORD_OVERHEAD = MessageProtocol::HEADER_SIZE + ChaCha20Poly1305::TAG_SIZE;
+
+    // PBKDF2-SHA256 of the password, salted with the username
+    static QByteArray deriveLinkKey(const QString& username, const QString& password);
+
+    void setLinkKey(const QByteArray& key);
+    bool isEnabled() const { return !m_linkKey.isEmpty(); }
+
+    // A fresh local nonce; unkeyed until the peer's arrives
+    void startSession();
+    void endSession();
+    QByteArray localNonce() const { return m_localNonce; }
+
+    // Keys the session from the peer's nonce; later nonces in the same
+    // session are ignored. False when the nonce is malformed.
+    bool acceptPeerNonce(const QByteArray& nonce);
+    bool isKeyed() const { return m_keyed; }
+    // The send counter has run out; the link must be re-established
+    bool isExhausted() const { return m_sendRecord == UINT32_MAX; }
+
+    // One sealed record of frames; empty when not keyed or exhausted
+    QByteArray seal(const QByteArray& frames, EncryptionStats* stats = nullptr);
+    // Authenticates and decrypts a sealed record into plain. False, with
+    // plain unchanged, for a forged, replayed or out of order record.
+    bool open(const FrameHeader& header, const char* payload, QByteArray& plain,
+              EncryptionStats* stats = nullptr);
+
+private:
+    QByteArray sessionKey(const QByteArray& senderNonce, const QByteArray& receiverNonce) const;
+    static void recordNonce(quint32 record, quint8* nonce);
+
+    QByteArray m_linkKey;
+    QByteArray m_localNonce;
+    bool m_keyed = false;
+    ChaCha20Poly1305 m_send;
+    ChaCha20Poly1305 m_receive;
+    quint32 m_sendRecord = 0;
+    quint32 m_receiveRecord = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // LINKCIPHER_H
@@ -1,14 +1,75 @@
 #include "network/MessageProtocol.h"
+#include "utils/JsonReader.h"
+#include "utils/JsonWriter.h"
 #include <QDataStream>
 #include <QIODevice>
-#include <QJsonDocument>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#ifdef HAS_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAS_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
 
 namespace CounterUAS {
 
-quint32 MessageProtocol::s_sequenceCounter = 0;
+std::atomic<quint32> MessageProtocol::s_sequenceCounter{0};
+
+/**
+ * @brief Codec contexts and dictionaries, reused from frame to frame
+ */
+struct MessageProtocol::Codecs {
+    QByteArray scratch;             // The last decompressed payload
+
+#ifdef HAS_ZSTD
+    struct Dictionary {
+        QByteArray content;
+        ZSTD_DDict* decoder = nullptr;
+        QHash<int, ZSTD_CDict*> encoders;   // By level, made on first use
+    };
+    ZSTD_CCtx* compressor = nullptr;
+    ZSTD_DCtx* decompressor = nullptr;
+    QHash<quint32, Dictionary> dictionaries;
 
-MessageProtocol::MessageProtocol() {}
+    ~Codecs() {
+        for (Dictionary& dictionary : dictionaries) {
+            ZSTD_freeDDict(dictionary.decoder);
+            for (ZSTD_CDict* encoder : qAsConst(dictionary.encoders)) {
+                ZSTD_freeCDict(encoder);
+            }
+        }
+        ZSTD_freeCCtx(compressor);
+        ZSTD_freeDCtx(decompressor);
+    }
+#endif
+};
+
+void CompressionStats::add(const CompressionStats& other) {
+    framesCompressed += other.framesCompressed;
+    bytesIn += other.bytesIn;
+    bytesOut += other.bytesOut;
+    compressNs += other.compressNs;
+    framesDecompressed += other.framesDecompressed;
+    decompressNs += other.decompressNs;
+}
+
+MessageProtocol::MessageProtocol()
+    : m_codecs(new Codecs)
+{
+}
+
+MessageProtocol::~MessageProtocol() = default;
 
 QJsonObject Message::toJson() const {
     QJsonObject obj;
@@ -16,7 +77,13 @@ QJsonObject Message::toJson() const {
     obj["sequenceNumber"] = static_cast<qint64>(sequenceNumber);
     obj["timestamp"] = timestamp;
     obj["sourceId"] = sourceId;
-    obj["payload"] = QJsonObject::fromVariantMap(payload);
+    QJsonObject payloadJson = QJsonObject::fromVariantMap(payload);
+    for (auto it = payload.constBegin(); it != payload.constEnd(); ++it) {
+        if (it.value().userType() == QMetaType::QByteArray) {
+            payloadJson[it.key()] = QString::fromLatin1(it.value().toByteArray().toBase64());
+        }
+    }
+    obj["payload"] = payloadJson;
     return obj;
 }
 
@@ -30,74 +97,918 @@ Message Message::fromJson(const QJsonObject& json) {
     return msg;
 }
 
-QByteArray MessageProtocol::serialize(const Message& message) const {
+void Message::writeJson(JsonWriter& writer) const {
+    writer.beginObject();
+    writer.key("type");
+    writer.writeInt(static_cast<int>(type));
+    writer.key("sequenceNumber");
+    writer.writeInt(sequenceNumber);
+    writer.key("timestamp");
+    writer.writeInt(timestamp);
+    writer.key("sourceId");
+    writer.writeString(sourceId);
+    writer.key("payload");
+    writer.beginObject();
+    for (auto it = payload.constBegin(); it != payload.constEnd(); ++it) {
+        writer.key(it.key());
+        if (it.value().userType() == QMetaType::QByteArray) {
+            writer.writeString(QString::fromLatin1(it.value().toByteArray().toBase64()));
+        } else {
+            writer.writeVariant(it.value());
+        }
+    }
+    writer.endObject();
+    writer.endObject();
+}
+
+bool Message::readJson(JsonReader& reader, Message& message) {
+    message = Message();
+    if (!reader.beginObject()) return false;
+    while (reader.nextKey()) {
+        if (reader.keyIs("type") || reader.keyIs("sequenceNumber") || reader.keyIs("timestamp")) {
+            // As QJsonValue's conversions: anything but a number reads as 0
+            double number = 0.0;
+            if (reader.peek() == JsonReader::Type::Number) reader.readDouble(number);
+            else reader.skipValue();
+            
+            if (reader.keyIs("type")) {
+                const bool integral = std::floor(number) == number && std::abs(number) <= 65535.0;
+                message.type = static_cast<MessageType>(integral ? static_cast<int>(number) : 0);
+            } else if (reader.keyIs("sequenceNumber")) {
+                message.sequenceNumber = static_cast<quint32>(number);
+            } else {
+                message.timestamp = static_cast<qint64>(number);
+            }
+        } else if (reader.keyIs("sourceId") && reader.peek() == JsonReader::Type::String) {
+            reader.readString(message.sourceId);
+        } else if (reader.keyIs("payload") && reader.peek() == JsonReader::Type::Object) {
+            message.payload.clear();    // A repeated key's last object wins, as in QJsonObject
+            reader.readVariantMap(message.payload);
+        } else {
+            reader.skipValue();
+        }
+    }
+    return reader.ok();
+}
+
+namespace {
+
+// A typed body's fields into the map form, under the schema keys
+struct PayloadWriter {
+    QVariantMap& payload;
+
+    void operator()(const DynamicBody& body) const {
+        payload = body.payload;
+    }
+    void operator()(const TrackUpdateBody& body) const {
+        payload["trackId"] = body.trackId;
+        payload["latitude"] = body.latitude;
+        payload["longitude"] = body.longitude;
+        payload["altitude"] = body.altitude;
+        payload["velocityNorth"] = body.velocityNorth;
+        payload["velocityEast"] = body.velocityEast;
+        payload["velocityDown"] = body.velocityDown;
+        payload["classification"] = body.classification;
+        payload["state"] = body.state;
+        payload["threatLevel"] = body.threatLevel;
+        payload["classificationConfidence"] = body.classificationConfidence;
+        payload["trackQuality"] = body.trackQuality;
+        payload["visuallyTracked"] = body.visuallyTracked;
+        payload["engaged"] = body.engaged;
+        payload["associatedCameraId"] = body.associatedCameraId;
+        payload["lastUpdateTime"] = body.lastUpdateTime;
+    }
+    void operator()(const SensorDetectionBody& body) const {
+        payload["latitude"] = body.latitude;
+        payload["longitude"] = body.longitude;
+        payload["altitude"] = body.altitude;
+        payload["velocityNorth"] = body.velocityNorth;
+        payload["velocityEast"] = body.velocityEast;
+        payload["velocityDown"] = body.velocityDown;
+        payload["signalStrength"] = body.signalStrength;
+        payload["confidence"] = body.confidence;
+        payload["sourceType"] = body.sourceType;
+        payload["detectionTime"] = body.detectionTime;
+        payload["trackId"] = body.trackId;
+    }
+    void operator()(const EffectorStatusBody& body) const {
+        payload["effectorId"] = body.effectorId;
+        payload["status"] = body.status;
+        payload["readiness"] = body.readiness;
+        payload["remainingShots"] = body.remainingShots;
+        payload["totalEngagements"] = body.totalEngagements;
+        payload["faultMessage"] = body.faultMessage;
+    }
+    void operator()(const EffectorCommandBody& body) const {
+        payload = body.params;
+        payload["effectorId"] = body.effectorId;
+        payload["command"] = body.command;
+    }
+    void operator()(const AlertBody& body) const {
+        payload["alertId"] = body.alertId;
+        payload["level"] = body.level;
+        payload["message"] = body.message;
+    }
+    void operator()(const TrackSyncBody& body) const {
+        payload["data"] = body.data;
+    }
+};
+
+} // namespace
+
+Message TypedMessage::toMessage() const {
+    Message msg;
+    msg.type = type();
+    msg.sequenceNumber = sequenceNumber;
+    msg.timestamp = timestamp;
+    msg.sourceId = sourceId;
+    std::visit(PayloadWriter{msg.payload}, body);
+    return msg;
+}
+
+TypedMessage TypedMessage::fromMessage(const Message& message) {
+    TypedMessage typed;
+    typed.sequenceNumber = message.sequenceNumber;
+    typed.timestamp = message.timestamp;
+    typed.sourceId = message.sourceId;
+    typed.body = DynamicBody{message.type, message.payload};
+    return typed;
+}
+
+namespace {
+
+enum class FieldType : quint8 { Double, Float, Int32, Int64, Bool, String, Bytes };
+
+struct FieldSpec {
+    const char* key;
+    FieldType type;
+};
+
+struct Schema {
+    QVector<QString> keys;
+    QVector<FieldType> types;
+};
+
+constexpr quint32 EXTRAS_BIT = 0x80000000u;
+constexpr int MAX_SCHEMA_FIELDS = 31;
+
+// Field order is the wire order; changing a schema changes the protocol
+const FieldSpec TRACK_UPDATE_FIELDS[] = {
+    {"trackId", FieldType::String},
+    {"latitude", FieldType::Double},
+    {"longitude", FieldType::Double},
+    {"altitude", FieldType::Float},
+    {"velocityNorth", FieldType::Float},
+    {"velocityEast", FieldType::Float},
+    {"velocityDown", FieldType::Float},
+    {"classification", FieldType::Int32},
+    {"state", FieldType::Int32},
+    {"threatLevel", FieldType::Int32},
+    {"classificationConfidence", FieldType::Float},
+    {"trackQuality", FieldType::Float},
+    {"visuallyTracked", FieldType::Bool},
+    {"engaged", FieldType::Bool},
+    {"associatedCameraId", FieldType::String},
+    {"lastUpdateTime", FieldType::Int64},
+};
+
+const FieldSpec SENSOR_DETECTION_FIELDS[] = {
+    {"latitude", FieldType::Double},
+    {"longitude", FieldType::Double},
+    {"altitude", FieldType::Float},
+    {"velocityNorth", FieldType::Float},
+    {"velocityEast", FieldType::Float},
+    {"velocityDown", FieldType::Float},
+    {"signalStrength", FieldType::Float},
+    {"confidence", FieldType::Float},
+    {"sourceType", FieldType::Int32},
+    {"detectionTime", FieldType::Int64},
+    {"trackId", FieldType::String},
+};
+
+const FieldSpec HEARTBEAT_FIELDS[] = {
+    {"encodings", FieldType::Int32},
+    {"uptimeMs", FieldType::Int64},
+    {"status", FieldType::Int32},
+    // Pipeline stage latencies, PipelineLatency::stageKey() prefixes
+    {"receiveP50Us", FieldType::Int64},
+    {"receiveP99Us", FieldType::Int64},
+    {"receiveMaxUs", FieldType::Int64},
+    {"parseP50Us", FieldType::Int64},
+    {"parseP99Us", FieldType::Int64},
+    {"parseMaxUs", FieldType::Int64},
+    {"fusionP50Us", FieldType::Int64},
+    {"fusionP99Us", FieldType::Int64},
+    {"fusionMaxUs", FieldType::Int64},
+    {"threatP50Us", FieldType::Int64},
+    {"threatP99Us", FieldType::Int64},
+    {"threatMaxUs", FieldType::Int64},
+    {"displayP50Us", FieldType::Int64},
+    {"displayP99Us", FieldType::Int64},
+    {"displayMaxUs", FieldType::Int64},
+    {"publishP50Us", FieldType::Int64},
+    {"publishP99Us", FieldType::Int64},
+    {"publishMaxUs", FieldType::Int64},
+    {"endToEndP50Us", FieldType::Int64},
+    {"endToEndP99Us", FieldType::Int64},
+    {"endToEndMaxUs", FieldType::Int64},
+};
+
+// Track picture and alert sync frames carry their own coding
+const FieldSpec TRACK_SYNC_FIELDS[] = {
+    {"data", FieldType::Bytes},
+};
+
+const FieldSpec EFFECTOR_STATUS_FIELDS[] = {
+    {"effectorId", FieldType::String},
+    {"status", FieldType::Int32},
+    {"readiness", FieldType::Float},
+    {"remainingShots", FieldType::Int32},
+    {"totalEngagements", FieldType::Int32},
+    {"faultMessage", FieldType::String},
+};
+
+template<int N>
+Schema makeSchema(const FieldSpec (&fields)[N]) {
+    static_assert(N <= MAX_SCHEMA_FIELDS, "presence mask holds 31 fields");
+    Schema schema;
+    for (const FieldSpec& field : fields) {
+        schema.keys.append(QString::fromLatin1(field.key));
+        schema.types.append(field.type);
+    }
+    return schema;
+}
+
+const Schema* schemaFor(MessageType type) {
+    static const QHash<quint16, Schema> schemas = {
+        {static_cast<quint16>(MessageType::TrackUpdate), makeSchema(TRACK_UPDATE_FIELDS)},
+        {static_cast<quint16>(MessageType::SensorDetection), makeSchema(SENSOR_DETECTION_FIELDS)},
+        {static_cast<quint16>(MessageType::Heartbeat), makeSchema(HEARTBEAT_FIELDS)},
+        {static_cast<quint16>(MessageType::EffectorStatus), makeSchema(EFFECTOR_STATUS_FIELDS)},
+        {static_cast<quint16>(MessageType::TrackKeyframe), makeSchema(TRACK_SYNC_FIELDS)},
+        {static_cast<quint16>(MessageType::TrackDelta), makeSchema(TRACK_SYNC_FIELDS)},
+        {static_cast<quint16>(MessageType::AlertSync), makeSchema(TRACK_SYNC_FIELDS)},
+    };
+    auto it = schemas.constFind(static_cast<quint16>(type));
+    return it != schemas.constEnd() ? &it.value() : nullptr;
+}
+
+template<typename To, typename From>
+To bitCast(From value) {
+    static_assert(sizeof(To) == sizeof(From), "size mismatch");
+    To result;
+    std::memcpy(&result, &value, sizeof(To));
+    return result;
+}
+
+template<typename T>
+void put(QByteArray& out, T value) {
+    uchar bytes[sizeof(T)];
+    qToBigEndian(value, bytes);
+    out.append(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+void putString(QByteArray& out, const QString& value) {
+    const QByteArray utf8 = value.toUtf8().left(0xFFFF);
+    put<quint16>(out, static_cast<quint16>(utf8.size()));
+    out.append(utf8);
+}
+
+void putHeader(QByteArray& out, quint32 magic, MessageType type, quint32 sequenceNumber,
+               qint64 timestamp, int payloadSize) {
+    put<quint32>(out, magic);
+    put<quint16>(out, static_cast<quint16>(type));
+    put<quint32>(out, sequenceNumber);
+    put<qint64>(out, timestamp);
+    put<quint32>(out, static_cast<quint32>(payloadSize));
+}
+
+// A typed body's fields in schema order, each setting its presence bit.
+// Every field is sent; the body's types already fit the wire's.
+struct FieldWriter {
+    QByteArray& out;
+    quint32 mask = 0;
+    int field = 0;
+
+    void present() { mask |= 1u << field++; }
+    void f64(double value) { present(); put<quint64>(out, bitCast<quint64>(value)); }
+    void f32(double value) { present(); put<quint32>(out, bitCast<quint32>(static_cast<float>(value))); }
+    void i32(qint32 value) { present(); put<qint32>(out, value); }
+    void i64(qint64 value) { present(); put<qint64>(out, value); }
+    void boolean(bool value) { present(); out.append(value ? '\1' : '\0'); }
+    void string(const QString& value) { present(); putString(out, value); }
+    void bytes(const QByteArray& value) {
+        present();
+        put<quint32>(out, static_cast<quint32>(value.size()));
+        out.append(value);
+    }
+
+    // Against TRACK_UPDATE_FIELDS and the rest above; the order is the protocol
+    void operator()(const TrackUpdateBody& body) {
+        string(body.trackId);
+        f64(body.latitude);
+        f64(body.longitude);
+        f32(body.altitude);
+        f32(body.velocityNorth);
+        f32(body.velocityEast);
+        f32(body.velocityDown);
+        i32(body.classification);
+        i32(body.state);
+        i32(body.threatLevel);
+        f32(body.classificationConfidence);
+        f32(body.trackQuality);
+        boolean(body.visuallyTracked);
+        boolean(body.engaged);
+        string(body.associatedCameraId);
+        i64(body.lastUpdateTime);
+    }
+    void operator()(const SensorDetectionBody& body) {
+        f64(body.latitude);
+        f64(body.longitude);
+        f32(body.altitude);
+        f32(body.velocityNorth);
+        f32(body.velocityEast);
+        f32(body.velocityDown);
+        f32(body.signalStrength);
+        f32(body.confidence);
+        i32(body.sourceType);
+        i64(body.detectionTime);
+        string(body.trackId);
+    }
+    void operator()(const EffectorStatusBody& body) {
+        string(body.effectorId);
+        i32(body.status);
+        f32(body.readiness);
+        i32(body.remainingShots);
+        i32(body.totalEngagements);
+        string(body.faultMessage);
+    }
+    void operator()(const TrackSyncBody& body) {
+        bytes(body.data);
+    }
+    // No schema; serialize() never gets here with these
+    void operator()(const DynamicBody&) {}
+    void operator()(const EffectorCommandBody&) {}
+    void operator()(const AlertBody&) {}
+};
+
+struct Reader {
+    const char* pos;
+    const char* end;
+    bool ok = true;
+
+    bool has(int bytes) {
+        ok = ok && bytes >= 0 && end - pos >= bytes;
+        return ok;
+    }
+
+    template<typename T>
+    T take() {
+        if (!has(sizeof(T))) return T();
+        T value = qFromBigEndian<T>(reinterpret_cast<const uchar*>(pos));
+        pos += sizeof(T);
+        return value;
+    }
+
+    QString takeString() {
+        const int size = take<quint16>();
+        if (!has(size)) return QString();
+        QString value = QString::fromUtf8(pos, size);
+        pos += size;
+        return value;
+    }
+
+    QByteArray takeBytes() {
+        const int size = static_cast<int>(take<quint32>());
+        if (!has(size)) return QByteArray();
+        QByteArray value(pos, size);
+        pos += size;
+        return value;
+    }
+};
+
+bool isNumeric(int typeId) {
+    switch (typeId) {
+    case QMetaType::Double: case QMetaType::Float:
+    case QMetaType::Int: case QMetaType::UInt:
+    case QMetaType::LongLong: case QMetaType::ULongLong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Integers decoded from JSON arrive as doubles; accept them only when exact
+bool toInteger(const QVariant& value, qint64 min, qint64 max, qint64& result) {
+    const int typeId = value.userType();
+    if (!isNumeric(typeId)) return false;
+    if (typeId == QMetaType::Double || typeId == QMetaType::Float) {
+        const double d = value.toDouble();
+        if (!(d >= static_cast<double>(min) && d < static_cast<double>(max) + 1.0) ||
+            d != std::floor(d)) {
+            return false;
+        }
+        result = static_cast<qint64>(d);
+        return true;
+    }
+    if (typeId == QMetaType::ULongLong && value.toULongLong() > static_cast<quint64>(max)) {
+        return false;
+    }
+    result = value.toLongLong();
+    return result >= min && result <= max;
+}
+
+// Appends the field when the value fits its wire type; false leaves it for the extras map
+bool encodeField(QByteArray& out, FieldType type, const QVariant& value) {
+    qint64 integer = 0;
+    switch (type) {
+    case FieldType::Double:
+        if (!isNumeric(value.userType())) return false;
+        put<quint64>(out, bitCast<quint64>(value.toDouble()));
+        return true;
+    case FieldType::Float:
+        if (!isNumeric(value.userType())) return false;
+        put<quint32>(out, bitCast<quint32>(value.toFloat()));
+        return true;
+    case FieldType::Int32:
+        if (!toInteger(value, std::numeric_limits<qint32>::min(),
+                       std::numeric_limits<qint32>::max(), integer)) return false;
+        put<qint32>(out, static_cast<qint32>(integer));
+        return true;
+    case FieldType::Int64:
+        if (!toInteger(value, std::numeric_limits<qint64>::min(),
+                       std::numeric_limits<qint64>::max(), integer)) return false;
+        put<qint64>(out, integer);
+        return true;
+    case FieldType::Bool:
+        if (value.userType() != QMetaType::Bool) return false;
+        out.append(value.toBool() ? '\1' : '\0');
+        return true;
+    case FieldType::String:
+        if (value.userType() != QMetaType::QString || value.toString().toUtf8().size() > 0xFFFF) {
+            return false;
+        }
+        putString(out, value.toString());
+        return true;
+    case FieldType::Bytes:
+        if (value.userType() != QMetaType::QByteArray) return false;
+        put<quint32>(out, static_cast<quint32>(value.toByteArray().size()));
+        out.append(value.toByteArray());
+        return true;
+    }
+    return false;
+}
+
+QVariant decodeField(Reader& reader, FieldType type) {
+    switch (type) {
+    case FieldType::Double:
+        return bitCast<double>(reader.take<quint64>());
+    case FieldType::Float:
+        return static_cast<double>(bitCast<float>(reader.take<quint32>()));
+    case FieldType::Int32:
+        return reader.take<qint32>();
+    case FieldType::Int64:
+        return reader.take<qint64>();
+    case FieldType::Bool:
+        return reader.take<quint8>() != 0;
+    case FieldType::String:
+        return reader.takeString();
+    case FieldType::Bytes:
+        return reader.takeBytes();
+    }
+    return QVariant();
+}
+
+} // namespace
+
+bool MessageProtocol::hasBinarySchema(MessageType type) {
+    return schemaFor(type) != nullptr;
+}
+
+void MessageProtocol::appendBinary(QByteArray& out, const Message& message) {
+    const Schema& schema = *schemaFor(message.type);
+
+    // Fields go straight into out behind a mask patched in at the end
+    out.reserve(out.size() + 2 + message.sourceId.size() + 4 + 16 * schema.keys.size());
+    putString(out, message.sourceId);
+    const int maskAt = out.size();
+    put<quint32>(out, 0);
+
+    quint32 mask = 0;
+    int matched = 0;
+    for (int i = 0; i < schema.keys.size(); ++i) {
+        auto it = message.payload.constFind(schema.keys[i]);
+        if (it == message.payload.constEnd()) continue;
+        if (encodeField(out, schema.types[i], it.value())) {
+            mask |= 1u << i;
+            ++matched;
+        }
+    }
+
+    if (matched < message.payload.size()) {
+        QVariantMap extras;
+        for (auto it = message.payload.constBegin(); it != message.payload.constEnd(); ++it) {
+            const int field = schema.keys.indexOf(it.key());
+            if (field < 0 || !(mask & (1u << field))) {
+                extras.insert(it.key(), it.value());
+            }
+        }
+        mask |= EXTRAS_BIT;
+
+        QByteArray packed;
+        QDataStream stream(&packed, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_15);
+        stream << extras;
+        put<quint32>(out, static_cast<quint32>(packed.size()));
+        out.append(packed);
+    }
+    qToBigEndian(mask, reinterpret_cast<uchar*>(out.data() + maskAt));
+}
+
+void MessageProtocol::appendBinary(QByteArray& out, const TypedMessage& message) {
+    out.reserve(out.size() + 2 + message.sourceId.size() + 4 + 16 * MAX_SCHEMA_FIELDS);
+    putString(out, message.sourceId);
+    const int maskAt = out.size();
+    put<quint32>(out, 0);
+
+    FieldWriter writer{out};
+    std::visit(writer, message.body);
+    qToBigEndian(writer.mask, reinterpret_cast<uchar*>(out.data() + maskAt));
+}
+
+bool MessageProtocol::decodeBinary(const char* payload, int size, Message& message) {
+    const Schema* schema = schemaFor(message.type);
+    if (!schema) return false;
+
+    Reader reader{payload, payload + size};
+    message.sourceId = reader.takeString();
+    const quint32 mask = reader.take<quint32>();
+    if (!reader.ok || (mask & ~EXTRAS_BIT) >> schema->keys.size()) {
+        return false;  // Truncated, or fields this end does not know
+    }
+
+    message.payload.clear();
+    for (int i = 0; i < schema->keys.size(); ++i) {
+        if (mask & (1u << i)) {
+            message.payload.insert(schema->keys[i], decodeField(reader, schema->types[i]));
+        }
+    }
+
+    if (mask & EXTRAS_BIT) {
+        const int extrasSize = static_cast<int>(reader.take<quint32>());
+        if (!reader.has(extrasSize)) return false;
+
+        QVariantMap extras;
+        QDataStream stream(QByteArray::fromRawData(reader.pos, extrasSize));
+        stream.setVersion(QDataStream::Qt_5_15);
+        stream >> extras;
+        if (stream.status() != QDataStream::Ok) return false;
+        reader.pos += extrasSize;
+
+        for (auto it = extras.constBegin(); it != extras.constEnd(); ++it) {
+            message.payload.insert(it.key(), it.value());
+        }
+    }
+    return reader.ok;
+}
+
+QByteArray MessageProtocol::serialize(const Message& message, WireEncoding encoding) const {
+    const bool binary = encoding == WireEncoding::Binary && hasBinarySchema(message.type);
+
+    // Encoded in place after the header, its length patched afterwards
     QByteArray data;
-    QDataStream stream(&data, QIODevice::WriteOnly);
-    stream.setByteOrder(QDataStream::BigEndian);
+    putHeader(data, binary ? MAGIC_BINARY : MAGIC, message.type, message.sequenceNumber, message.timestamp, 0);
+    if (binary) {
+        appendBinary(data, message);
+    } else {
+        JsonWriter writer(&data);
+        message.writeJson(writer);
+    }
+    qToBigEndian(static_cast<quint32>(data.size() - HEADER_SIZE),
+                 reinterpret_cast<uchar*>(data.data() + HEADER_SIZE - 4));
+    return finishFrame(data);
+}
+
+QByteArray MessageProtocol::serialize(const TypedMessage& message, WireEncoding encoding) const {
+    const MessageType type = message.type();
+    if (encoding != WireEncoding::Binary || !hasBinarySchema(type) || message.as<DynamicBody>()) {
+        return serialize(message.toMessage(), encoding);
+    }
     
-    // Serialize payload to JSON
-    QJsonDocument doc(message.toJson());
-    QByteArray payload = doc.toJson(QJsonDocument::Compact);
+    QByteArray data;
+    putHeader(data, MAGIC_BINARY, type, message.sequenceNumber, message.timestamp, 0);
+    appendBinary(data, message);
+    qToBigEndian(static_cast<quint32>(data.size() - HEADER_SIZE),
+                 reinterpret_cast<uchar*>(data.data() + HEADER_SIZE - 4));
+    return finishFrame(data);
+}
+
+QByteArray MessageProtocol::finishFrame(QByteArray frame) const {
+    return m_compression.codec == CompressionCodec::None ? frame : compressFrame(frame, m_compression);
+}
+
+int MessageProtocol::supportedCodecs() {
+    int codecs = 1 << static_cast<int>(CompressionCodec::Zlib);
+#ifdef HAS_LZ4
+    codecs |= 1 << static_cast<int>(CompressionCodec::Lz4);
+#endif
+#ifdef HAS_ZSTD
+    codecs |= 1 << static_cast<int>(CompressionCodec::Zstd);
+#endif
+    return codecs;
+}
+
+bool MessageProtocol::isCodecSupported(CompressionCodec codec) {
+    return codec != CompressionCodec::None && (supportedCodecs() & (1 << static_cast<int>(codec)));
+}
+
+QByteArray MessageProtocol::compressFrame(const QByteArray& frame, const CompressionOptions& options,
+                                          CompressionStats* stats) const {
+    if (frame.size() < HEADER_SIZE || !isCodecSupported(options.codec)) return frame;
+    const quint32 magic = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(frame.constData()));
+    if (magic != MAGIC && magic != MAGIC_BINARY) return frame;   // Already compressed
+    const int inputSize = frame.size() - HEADER_SIZE;
+    if (inputSize < options.minPayloadBytes) return frame;
     
-    // Compress if enabled
-    if (m_compression && payload.size() > 256) {
-        payload = qCompress(payload);
+    QElapsedTimer timer;
+    timer.start();
+    const char* input = frame.constData() + HEADER_SIZE;
+    QByteArray out(frame.constData(), HEADER_SIZE);
+    out.append(static_cast<char>(options.codec));
+    out.append(3, '\0');
+    put<quint32>(out, 0);                   // Dictionary id, set below if one is used
+    put<quint32>(out, static_cast<quint32>(inputSize));
+    
+    bool ok = false;
+    switch (options.codec) {
+    case CompressionCodec::Zlib: {
+        // qCompress's own 4-byte length prefix stays on, for qUncompress
+        const QByteArray packed = qCompress(reinterpret_cast<const uchar*>(input), inputSize,
+                                            options.level > 0 ? options.level : -1);
+        out.append(packed);
+        ok = !packed.isEmpty();
+        break;
+    }
+    case CompressionCodec::Lz4: {
+#ifdef HAS_LZ4
+        const int prefixEnd = out.size();
+        out.resize(prefixEnd + LZ4_compressBound(inputSize));
+        const int packed = LZ4_compress_default(input, out.data() + prefixEnd, inputSize,
+                                                out.size() - prefixEnd);
+        out.resize(prefixEnd + qMax(packed, 0));
+        ok = packed > 0;
+#endif
+        break;
     }
+    case CompressionCodec::Zstd: {
+#ifdef HAS_ZSTD
+        Codecs& codecs = *m_codecs;
+        auto dictionary = codecs.dictionaries.find(options.dictionaryId);
+        if (options.dictionaryId != 0 && dictionary == codecs.dictionaries.end()) break;   // Send plain
+        if (!codecs.compressor) codecs.compressor = ZSTD_createCCtx();
+        const int level = options.level != 0 ? options.level : ZSTD_CLEVEL_DEFAULT;
+        const int prefixEnd = out.size();
+        out.resize(prefixEnd + static_cast<int>(ZSTD_compressBound(static_cast<size_t>(inputSize))));
+        size_t packed = 0;
+        if (options.dictionaryId != 0) {
+            ZSTD_CDict*& encoder = dictionary->encoders[level];
+            if (!encoder) {
+                encoder = ZSTD_createCDict(dictionary->content.constData(),
+                                           static_cast<size_t>(dictionary->content.size()), level);
+            }
+            packed = ZSTD_compress_usingCDict(codecs.compressor, out.data() + prefixEnd,
+                                              static_cast<size_t>(out.size() - prefixEnd),
+                                              input, static_cast<size_t>(inputSize), encoder);
+            qToBigEndian<quint32>(options.dictionaryId,
+                                  reinterpret_cast<uchar*>(out.data() + HEADER_SIZE + 4));
+        } else {
+            packed = ZSTD_compressCCtx(codecs.compressor, out.data() + prefixEnd,
+                                       static_cast<size_t>(out.size() - prefixEnd),
+                                       input, static_cast<size_t>(inputSize), level);
+        }
+        ok = !ZSTD_isError(packed);
+        out.resize(prefixEnd + (ok ? static_cast<int>(packed) : 0));
+#endif
+        break;
+    }
+    case CompressionCodec::None:
+        break;
+    }
+    if (!ok || out.size() >= frame.size()) return frame;
     
-    // Write header
-    stream << MAGIC;
-    stream << static_cast<quint16>(message.type);
-    stream << message.sequenceNumber;
-    stream << message.timestamp;
-    stream << static_cast<quint32>(payload.size());
+    qToBigEndian<quint32>(magic == MAGIC_BINARY ? MAGIC_COMPRESSED_BINARY : MAGIC_COMPRESSED,
+                          reinterpret_cast<uchar*>(out.data()));
+    qToBigEndian<quint32>(static_cast<quint32>(out.size() - HEADER_SIZE),
+                          reinterpret_cast<uchar*>(out.data() + HEADER_SIZE - 4));
+    if (stats) {
+        stats->framesCompressed++;
+        stats->bytesIn += inputSize;
+        stats->bytesOut += out.size() - HEADER_SIZE;
+        stats->compressNs += timer.nsecsElapsed();
+    }
+    return out;
+}
+
+bool MessageProtocol::decompress(const char* payload, int size, CompressionStats* stats) const {
+    if (size < COMPRESSION_PREFIX_SIZE) return false;
     
-    data.append(payload);
+    QElapsedTimer timer;
+    timer.start();
+    Reader reader{payload, payload + COMPRESSION_PREFIX_SIZE};
+    const CompressionCodec codec = static_cast<CompressionCodec>(reader.take<quint8>());
+    reader.pos += 3;
+    const quint32 dictionaryId = reader.take<quint32>();
+    const quint32 originalSize = reader.take<quint32>();
+    if (originalSize > static_cast<quint32>(MAX_PAYLOAD_SIZE)) return false;
     
-    return data;
+    const char* input = payload + COMPRESSION_PREFIX_SIZE;
+    const int inputSize = size - COMPRESSION_PREFIX_SIZE;
+    QByteArray& out = m_codecs->scratch;
+    bool ok = false;
+    switch (codec) {
+    case CompressionCodec::Zlib:
+        out = qUncompress(reinterpret_cast<const uchar*>(input), inputSize);
+        ok = out.size() == static_cast<int>(originalSize);
+        break;
+    case CompressionCodec::Lz4:
+#ifdef HAS_LZ4
+        out.resize(static_cast<int>(originalSize));
+        ok = LZ4_decompress_safe(input, out.data(), inputSize, out.size()) ==
+             static_cast<int>(originalSize);
+#endif
+        break;
+    case CompressionCodec::Zstd: {
+#ifdef HAS_ZSTD
+        Codecs& codecs = *m_codecs;
+        if (!codecs.decompressor) codecs.decompressor = ZSTD_createDCtx();
+        out.resize(static_cast<int>(originalSize));
+        size_t unpacked = 0;
+        if (dictionaryId == 0) {
+            unpacked = ZSTD_decompressDCtx(codecs.decompressor, out.data(), originalSize,
+                                           input, static_cast<size_t>(inputSize));
+        } else {
+            auto dictionary = codecs.dictionaries.constFind(dictionaryId);
+            if (dictionary == codecs.dictionaries.constEnd()) return false;
+            unpacked = ZSTD_decompress_usingDDict(codecs.decompressor, out.data(), originalSize,
+                                                  input, static_cast<size_t>(inputSize),
+                                                  dictionary->decoder);
+        }
+        ok = !ZSTD_isError(unpacked) && unpacked == originalSize;
+#else
+        Q_UNUSED(dictionaryId)
+#endif
+        break;
+    }
+    case CompressionCodec::None:
+        break;
+    }
+    if (ok && stats) {
+        stats->framesDecompressed++;
+        stats->decompressNs += timer.nsecsElapsed();
+    }
+    return ok;
 }
 
-int MessageProtocol::deserialize(const QByteArray& data, Message& message) const {
-    if (data.size() < HEADER_SIZE) {
-        return 0;  // Need more data
+quint32 MessageProtocol::addDictionary(const QByteArray& dictionary) {
+#ifdef HAS_ZSTD
+    if (dictionary.isEmpty()) return 0;
+    quint32 id = ZDICT_getDictID(dictionary.constData(), static_cast<size_t>(dictionary.size()));
+    if (id == 0) {
+        // Raw content dictionary: FNV-1a, the same on every node
+        id = 2166136261u;
+        for (char c : dictionary) {
+            id = (id ^ static_cast<quint8>(c)) * 16777619u;
+        }
+        id = qMax<quint32>(id, 1);
+    }
+    Codecs::Dictionary& entry = m_codecs->dictionaries[id];
+    if (entry.decoder) return id;   // Already loaded
+    entry.content = dictionary;
+    entry.decoder = ZSTD_createDDict(dictionary.constData(), static_cast<size_t>(dictionary.size()));
+    return id;
+#else
+    Q_UNUSED(dictionary)
+    return 0;
+#endif
+}
+
+QVector<quint32> MessageProtocol::dictionaryIds() const {
+    QVector<quint32> ids;
+#ifdef HAS_ZSTD
+    for (auto it = m_codecs->dictionaries.constBegin(); it != m_codecs->dictionaries.constEnd(); ++it) {
+        ids.append(it.key());
+    }
+    std::sort(ids.begin(), ids.end());
+#endif
+    return ids;
+}
+
+QByteArray MessageProtocol::trainDictionary(const QVector<QByteArray>& frames, int maxBytes) {
+#ifdef HAS_ZSTD
+    // Headers differ in every frame and teach the dictionary nothing
+    QByteArray samples;
+    std::vector<size_t> sizes;
+    for (const QByteArray& frame : frames) {
+        if (frame.size() <= HEADER_SIZE) continue;
+        samples.append(frame.constData() + HEADER_SIZE, frame.size() - HEADER_SIZE);
+        sizes.push_back(static_cast<size_t>(frame.size() - HEADER_SIZE));
     }
+    if (sizes.empty()) return QByteArray();
     
-    QDataStream stream(data);
-    stream.setByteOrder(QDataStream::BigEndian);
+    QByteArray dictionary(maxBytes, Qt::Uninitialized);
+    const size_t trained = ZDICT_trainFromBuffer(dictionary.data(), static_cast<size_t>(maxBytes),
+                                                 samples.constData(), sizes.data(),
+                                                 static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(trained)) return QByteArray();
+    dictionary.resize(static_cast<int>(trained));
+    return dictionary;
+#else
+    Q_UNUSED(frames)
+    Q_UNUSED(maxBytes)
+    return QByteArray();
+#endif
+}
+
+int MessageProtocol::parseHeader(const char* data, int size, FrameHeader& header) {
+    if (size < HEADER_SIZE) {
+        return 0;  // Need more data
+    }
     
-    quint32 magic;
-    stream >> magic;
+    Reader reader{data, data + HEADER_SIZE};
+    const quint32 magic = reader.take<quint32>();
     
-    if (magic != MAGIC) {
+    if (magic != MAGIC && magic != MAGIC_BINARY &&
+        magic != MAGIC_COMPRESSED && magic != MAGIC_COMPRESSED_BINARY && magic != SEALED_MAGIC) {
         return -1;  // Invalid magic
     }
     
-    quint16 type;
-    quint32 seq;
-    qint64 timestamp;
-    quint32 payloadSize;
+    header.type = static_cast<MessageType>(reader.take<quint16>());
+    header.sequenceNumber = reader.take<quint32>();
+    header.timestamp = reader.take<qint64>();
+    const quint32 payloadSize = reader.take<quint32>();
     
-    stream >> type >> seq >> timestamp >> payloadSize;
+    if (payloadSize > static_cast<quint32>(MAX_PAYLOAD_SIZE)) {
+        return -1;
+    }
+    header.payloadSize = static_cast<int>(payloadSize);
+    header.encoding = magic == MAGIC_BINARY || magic == MAGIC_COMPRESSED_BINARY
+                          ? WireEncoding::Binary : WireEncoding::Json;
+    header.compressed = magic == MAGIC_COMPRESSED || magic == MAGIC_COMPRESSED_BINARY;
+    header.sealed = magic == SEALED_MAGIC;
+    return HEADER_SIZE;
+}
+
+bool MessageProtocol::decodePayload(const FrameHeader& header, const char* payload,
+                                    Message& message, CompressionStats* stats) const {
+    if (header.sealed) return false;   // Opened by the link's LinkCipher, not here
     
-    if (data.size() < HEADER_SIZE + static_cast<int>(payloadSize)) {
-        return 0;  // Need more data
+    int payloadSize = header.payloadSize;
+    if (header.compressed) {
+        if (!decompress(payload, payloadSize, stats)) return false;   // Corrupt, or no such codec
+        payload = m_codecs->scratch.constData();
+        payloadSize = m_codecs->scratch.size();
     }
     
-    QByteArray payload = data.mid(HEADER_SIZE, payloadSize);
+    if (header.encoding == WireEncoding::Binary) {
+        message = Message();
+        message.type = header.type;
+        message.sequenceNumber = header.sequenceNumber;
+        message.timestamp = header.timestamp;
+        return decodeBinary(payload, payloadSize, message);  // Malformed or unknown schema
+    }
     
-    // Decompress if needed
-    if (payload.size() > 0 && static_cast<quint8>(payload[0]) == 0x78) {
-        payload = qUncompress(payload);
+    JsonReader reader(payload, payloadSize);
+    if (!Message::readJson(reader, message) || !reader.atEnd()) {
+        return false;  // Invalid JSON
+    }
+    return true;
+}
+
+int MessageProtocol::deserialize(const QByteArray& data, Message& message,
+                                 WireEncoding* encoding) const {
+    FrameHeader header;
+    const int parsed = parseHeader(data.constData(), data.size(), header);
+    if (parsed <= 0) {
+        return parsed;
     }
     
-    // Parse JSON
-    QJsonDocument doc = QJsonDocument::fromJson(payload);
-    if (doc.isNull()) {
-        return -1;  // Invalid JSON
+    if (data.size() < HEADER_SIZE + header.payloadSize) {
+        return 0;  // Need more data
     }
     
-    message = Message::fromJson(doc.object());
+    if (!decodePayload(header, data.constData() + HEADER_SIZE, message)) {
+        return -1;
+    }
     
-    return HEADER_SIZE + payloadSize;
+    if (encoding) {
+        *encoding = header.encoding;
+    }
+    return HEADER_SIZE + header.payloadSize;
+}
+
+void MessageProtocol::stamp(quint32& sequenceNumber, qint64& timestamp) {
+    sequenceNumber = ++s_sequenceCounter;
+    timestamp = QDateTime::currentMSecsSinceEpoch();
 }
 
 Message MessageProtocol::createHeartbeat(const QString& sourceId) {
@@ -109,6 +1020,12 @@ Message MessageProtocol::createHeartbeat(const QString& sourceId) {
     return msg;
 }
 
+Message MessageProtocol::createHeartbeat(const QString& sourceId, int supportedEncodings) {
+    Message msg = createHeartbeat(sourceId);
+    msg.payload["encodings"] = supportedEncodings;
+    return msg;
+}
+
 Message MessageProtocol::createTrackUpdate(const QString& trackId, const QVariantMap& data) {
     Message msg;
     msg.type = MessageType::TrackUpdate;
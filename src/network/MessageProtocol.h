@@ -5,9 +5,17 @@
 #include <QVariantMap>
 #include <QString>
 #include <QJsonObject>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <variant>
 
 namespace CounterUAS {
 
+class JsonReader;
+class JsonWriter;
+
 /**
  * @brief Message types
  */
@@ -19,6 +27,9 @@ enum class MessageType : quint16 {
     TrackCreate = 0x0101,
     TrackDelete = 0x0102,
     TrackClassify = 0x0103,
+    TrackKeyframe = 0x0104,
+    TrackDelta = 0x0105,
+    TrackResyncRequest = 0x0106,
     
     // Sensor messages
     SensorStatus = 0x0200,
@@ -34,11 +45,13 @@ enum class MessageType : quint16 {
     VideoFrame = 0x0400,
     VideoConfig = 0x0401,
     PTZCommand = 0x0402,
+    VideoStatus = 0x0403,      // Video service replies and events
     
     // System messages
     Alert = 0x0500,
     Config = 0x0501,
     Log = 0x0502,
+    AlertSync = 0x0503,        // AlertSync ops, digests and state
     
     // Command messages
     EngagementRequest = 0x0600,
@@ -48,6 +61,58 @@ enum class MessageType : quint16 {
     Unknown = 0xFFFF
 };
 
+/**
+ * @brief Frame payload encoding
+ *
+ * Json is self-describing and readable on the wire; Binary packs the fields
+ * of the hot message types against a fixed per-type schema. Peers advertise
+ * the encodings they accept as a bitmask in the heartbeat "encodings" field.
+ */
+enum class WireEncoding : quint8 {
+    Json = 0x01,
+    Binary = 0x02
+};
+
+/**
+ * @brief Payload compression codec, carried in a compressed frame
+ *
+ * Zlib is always available. Lz4 (low latency, modest ratio) and Zstd
+ * (best ratio, optionally with a trained dictionary) are built in when the
+ * libraries are found (HAS_LZ4, HAS_ZSTD). Peers advertise the codecs they
+ * decode as a bitmask of (1 << codec) in the heartbeat "codecs" field.
+ */
+enum class CompressionCodec : quint8 {
+    None = 0,
+    Zlib = 1,
+    Lz4 = 2,
+    Zstd = 3
+};
+
+/**
+ * @brief How a sender compresses frames
+ */
+struct CompressionOptions {
+    CompressionCodec codec = CompressionCodec::None;
+    int level = 0;                 // Zlib and Zstd; 0 is the codec's default
+    int minPayloadBytes = 256;     // Smaller payloads go out as they are
+    quint32 dictionaryId = 0;      // Zstd only, from MessageProtocol::addDictionary()
+};
+
+/**
+ * @brief Compression effect and cost on one link
+ */
+struct CompressionStats {
+    qint64 framesCompressed = 0;
+    qint64 bytesIn = 0;             // Payload bytes before compression
+    qint64 bytesOut = 0;            // And after
+    qint64 compressNs = 0;
+    qint64 framesDecompressed = 0;
+    qint64 decompressNs = 0;
+
+    double ratio() const { return bytesOut > 0 ? double(bytesIn) / bytesOut : 1.0; }
+    void add(const CompressionStats& other);
+};
+
 /**
  * @brief Message structure
  */
@@ -60,18 +125,216 @@ struct Message {
     
     QJsonObject toJson() const;
     static Message fromJson(const QJsonObject& json);
+    
+    // The same document streamed, with no QJsonObject in between; readJson
+    // reads it as fromJson would, false on malformed JSON
+    void writeJson(JsonWriter& writer) const;
+    static bool readJson(JsonReader& reader, Message& message);
+};
+
+/**
+ * @brief Typed payloads of the message types sent in-process
+ *
+ * A TypedMessage carries one of these where Message carries a map: it is
+ * built without a string key or a QVariant per field, queued and routed as
+ * it is, and, for the types with a binary schema, written into the frame
+ * straight from its fields. The JSON encoding, and a receiver, see the map
+ * toMessage() gives, whose keys are the field names here. Real fields the
+ * schema sends single precision are doubles until they are written.
+ */
+struct TrackUpdateBody {
+    QString trackId;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double altitude = 0.0;
+    double velocityNorth = 0.0;
+    double velocityEast = 0.0;
+    double velocityDown = 0.0;
+    qint32 classification = 0;
+    qint32 state = 0;
+    qint32 threatLevel = 1;
+    double classificationConfidence = 0.0;
+    double trackQuality = 0.0;
+    bool visuallyTracked = false;
+    bool engaged = false;
+    QString associatedCameraId;
+    qint64 lastUpdateTime = 0;
+
+    static MessageType messageType() { return MessageType::TrackUpdate; }
+};
+
+// The sensor is the message's sourceId
+struct SensorDetectionBody {
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double altitude = 0.0;
+    double velocityNorth = 0.0;
+    double velocityEast = 0.0;
+    double velocityDown = 0.0;
+    double signalStrength = 0.0;
+    double confidence = 0.0;
+    qint32 sourceType = 0;
+    qint64 detectionTime = 0;
+    QString trackId;
+
+    static MessageType messageType() { return MessageType::SensorDetection; }
+};
+
+struct EffectorStatusBody {
+    QString effectorId;
+    qint32 status = 0;
+    double readiness = 0.0;
+    qint32 remainingShots = 0;
+    qint32 totalEngagements = 0;
+    QString faultMessage;
+
+    static MessageType messageType() { return MessageType::EffectorStatus; }
+};
+
+// Command arguments vary by effector type, so they stay a map
+struct EffectorCommandBody {
+    QString effectorId;
+    QString command;
+    QVariantMap params;
+
+    static MessageType messageType() { return MessageType::EffectorCommand; }
+};
+
+struct AlertBody {
+    QString alertId;
+    qint32 level = 0;
+    QString message;
+
+    static MessageType messageType() { return MessageType::Alert; }
+};
+
+// A TrackPictureSync keyframe or delta, already coded
+struct TrackSyncBody {
+    bool keyframe = false;
+    QByteArray data;
+
+    MessageType messageType() const { return keyframe ? MessageType::TrackKeyframe : MessageType::TrackDelta; }
+};
+
+// Any type, as a map: heartbeats, plugins and other dynamic payloads
+struct DynamicBody {
+    MessageType type = MessageType::Unknown;
+    QVariantMap payload;
+
+    MessageType messageType() const { return type; }
+};
+
+using MessageBody = std::variant<DynamicBody, TrackUpdateBody, SensorDetectionBody, EffectorStatusBody,
+                                 EffectorCommandBody, AlertBody, TrackSyncBody>;
+
+/**
+ * @brief Message with a typed body, sent as Message is
+ */
+struct TypedMessage {
+    quint32 sequenceNumber = 0;
+    qint64 timestamp = 0;
+    QString sourceId;
+    MessageBody body;
+
+    MessageType type() const {
+        return std::visit([](const auto& b) { return b.messageType(); }, body);
+    }
+    template <typename Body>
+    const Body* as() const { return std::get_if<Body>(&body); }
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor) const { return std::visit(std::forward<Visitor>(visitor), body); }
+
+    // The map form, as a receiver decodes it
+    Message toMessage() const;
+    // Wrapped as a DynamicBody; the payload is shared, not copied
+    static TypedMessage fromMessage(const Message& message);
+};
+
+/**
+ * @brief Fixed frame header, parsed in place from the receive buffer
+ */
+struct FrameHeader {
+    MessageType type = MessageType::Unknown;
+    quint32 sequenceNumber = 0;
+    qint64 timestamp = 0;
+    int payloadSize = 0;
+    WireEncoding encoding = WireEncoding::Json;
+    bool compressed = false;       // Payload is a codec prefix and the compressed encoding
+    bool sealed = false;           // Payload is a LinkCipher record of whole frames
 };
 
 /**
  * @brief Message protocol for serialization/deserialization
+ *
+ * Every frame is a 22-byte big-endian header followed by the payload. The
+ * header magic tells the receiver how the payload is encoded, so JSON and
+ * binary frames can be mixed on one stream.
+ *
+ * A binary payload is the source id, a presence mask with one bit per schema
+ * field, the present fields in schema order, and, when bit 31 is set, a
+ * QDataStream-encoded map of any keys the schema does not cover. Float fields
+ * carry single precision. Types without a schema are always sent as JSON,
+ * where QByteArray payload values travel as base64 strings.
+ *
+ * A compressed frame has its own magic per encoding, and its payload is a
+ * 12-byte prefix (codec, reserved, dictionary id, uncompressed size)
+ * followed by the codec's output of the uncompressed payload. The header
+ * stays readable, so FrameReader splits compressed frames like any other.
+ * Codec contexts and the decompression buffer are reused between frames,
+ * so one instance must not compress or decode on two threads at once.
+ *
+ * A sealed frame (SEALED_MAGIC) is a LinkCipher record: its payload is
+ * whole frames, encrypted and authenticated together. parseHeader()
+ * recognises it so a stream stays in step; decodePayload() refuses it.
  */
 class MessageProtocol {
 public:
     MessageProtocol();
+    ~MessageProtocol();
+    MessageProtocol(const MessageProtocol&) = delete;
+    MessageProtocol& operator=(const MessageProtocol&) = delete;
+    
+    // Serialization; Binary falls back to JSON for types without a schema.
+    // Compressed with the compression() options when they name a codec.
+    QByteArray serialize(const Message& message, WireEncoding encoding = WireEncoding::Json) const;
+    // The same frame, written from the body's fields when the type has a
+    // binary schema; JSON, and a DynamicBody, go through toMessage()
+    QByteArray serialize(const TypedMessage& message, WireEncoding encoding = WireEncoding::Json) const;
+    // Returns bytes consumed, 0 if the frame is incomplete, -1 if it is invalid
+    int deserialize(const QByteArray& data, Message& message,
+                    WireEncoding* encoding = nullptr) const;
+    
+    // Two-step decode for callers that own the buffer: parseHeader needs
+    // HEADER_SIZE bytes and returns HEADER_SIZE, 0 if short, -1 if invalid;
+    // decodePayload reads header.payloadSize bytes without copying them
+    // unless they are compressed
+    static int parseHeader(const char* data, int size, FrameHeader& header);
+    bool decodePayload(const FrameHeader& header, const char* payload, Message& message,
+                       CompressionStats* stats = nullptr) const;
     
-    // Serialization
-    QByteArray serialize(const Message& message) const;
-    int deserialize(const QByteArray& data, Message& message) const;
+    // The compressed form of a serialized frame, or the frame itself when
+    // it is already compressed, below minPayloadBytes, does not shrink, or
+    // the codec or dictionary is not available here
+    QByteArray compressFrame(const QByteArray& frame, const CompressionOptions& options,
+                             CompressionStats* stats = nullptr) const;
+    
+    // Codecs built into this binary, as a (1 << codec) mask
+    static int supportedCodecs();
+    static bool isCodecSupported(CompressionCodec codec);
+    
+    // Zstd dictionaries, for the short repetitive frames of the track
+    // picture. Both ends add the same dictionary; the id is the one zstd
+    // stored in it, or a hash of the content for a raw dictionary. Returns
+    // 0 if zstd is not available.
+    quint32 addDictionary(const QByteArray& dictionary);
+    QVector<quint32> dictionaryIds() const;
+    // Trains a dictionary on sample frames' payloads, empty on failure
+    static QByteArray trainDictionary(const QVector<QByteArray>& frames, int maxBytes = 16 * 1024);
+    
+    static constexpr int HEADER_SIZE = 22;  // magic(4) + type(2) + seq(4) + timestamp(8) + length(4)
+    static constexpr int MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+    
+    static bool hasBinarySchema(MessageType type);
     
     // Convenience methods
     static Message createHeartbeat(const QString& sourceId);
@@ -80,19 +343,49 @@ public:
     static Message createEffectorCommand(const QString& effectorId, const QString& command, 
                                           const QVariantMap& params);
     static Message createAlert(const QString& alertId, int level, const QString& message);
+    // Typed: the body in place, sequence and time stamped as the map helpers do
+    template <typename Body>
+    static TypedMessage createMessage(Body body, const QString& sourceId = QString());
+    
+    // Heartbeat advertising the encodings this end accepts
+    static Message createHeartbeat(const QString& sourceId, int supportedEncodings);
     
     // Protocol settings
-    void setCompression(bool enable) { m_compression = enable; }
-    bool compression() const { return m_compression; }
+    void setCompression(const CompressionOptions& options) { m_compression = options; }
+    CompressionOptions compression() const { return m_compression; }
+    
+    static constexpr int COMPRESSION_PREFIX_SIZE = 12;
+    static constexpr quint32 SEALED_MAGIC = 0x43554158;  // "CUAX", a LinkCipher record
     
 private:
-    static quint32 s_sequenceCounter;
-    bool m_compression = false;
+    struct Codecs;
+    
+    static void appendBinary(QByteArray& out, const Message& message);
+    static void appendBinary(QByteArray& out, const TypedMessage& message);
+    QByteArray finishFrame(QByteArray frame) const;
+    static void stamp(quint32& sequenceNumber, qint64& timestamp);
+    static bool decodeBinary(const char* payload, int size, Message& message);
+    bool decompress(const char* payload, int size, CompressionStats* stats) const;
     
-    static constexpr quint32 MAGIC = 0x43554153;  // "CUAS"
-    static constexpr int HEADER_SIZE = 20;  // magic(4) + type(2) + seq(4) + timestamp(8) + length(4) - 2
+    static std::atomic<quint32> s_sequenceCounter;   // The create helpers' run, shared by every thread
+    CompressionOptions m_compression;
+    std::unique_ptr<Codecs> m_codecs;
+    
+    static constexpr quint32 MAGIC = 0x43554153;         // "CUAS", JSON payload
+    static constexpr quint32 MAGIC_BINARY = 0x43554142;  // "CUAB", schema payload
+    static constexpr quint32 MAGIC_COMPRESSED = 0x4355415A;         // "CUAZ", compressed JSON
+    static constexpr quint32 MAGIC_COMPRESSED_BINARY = 0x43554159;  // "CUAY", compressed schema
 };
 
+template <typename Body>
+TypedMessage MessageProtocol::createMessage(Body body, const QString& sourceId) {
+    TypedMessage message;
+    stamp(message.sequenceNumber, message.timestamp);
+    message.sourceId = sourceId;
+    message.body = std::move(body);
+    return message;
+}
+
 } // namespace CounterUAS
 
 #endif // MESSAGEPROTOCOL_H
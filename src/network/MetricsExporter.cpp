@@ -0,0 +1,130 @@
+#include "network/MetricsExporter.h"
+#include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <memory>
+
+namespace CounterUAS {
+
+namespace {
+
+QByteArray httpResponse(const char* status, const QByteArray& contentType, const QByteArray& body,
+                        bool includeBody) {
+    QByteArray out;
+    out.reserve(128 + body.size());
+    out.append("HTTP/1.1 ").append(status).append("\r\n");
+    out.append("Content-Type: ").append(contentType).append("\r\n");
+    out.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+    out.append("Connection: close\r\n\r\n");
+    if (includeBody) out.append(body);
+    return out;
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(MetricsRegistry* registry, QObject* parent)
+    : QObject(parent)
+    , m_registry(registry ? registry : &MetricsRegistry::instance())
+{
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(quint16 port, const QHostAddress& address) {
+    if (m_thread) return true;
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("MetricsExporter");
+    m_context = new QObject;
+    m_context->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread->start();
+
+    bool listening = false;
+    QMetaObject::invokeMethod(m_context, [this, port, address, &listening]() {
+        QTcpServer* server = new QTcpServer(m_context);
+        if (!server->listen(address, port)) {
+            m_error = server->errorString();
+            delete server;
+            return;
+        }
+        m_port = server->serverPort();
+        connect(server, &QTcpServer::newConnection, m_context, [this, server]() {
+            while (server->hasPendingConnections()) {
+                serve(server->nextPendingConnection());
+            }
+        });
+        listening = true;
+    }, Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        Logger::instance().error("MetricsExporter",
+                                 QString("Cannot listen on port %1: %2").arg(port).arg(m_error));
+        stop();
+        return false;
+    }
+    m_error.clear();
+    Logger::instance().info("MetricsExporter", QString("Serving /metrics on port %1").arg(m_port));
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!m_thread) return;
+
+    // The server and any open connections go with the context
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_context = nullptr;
+    m_port = 0;
+}
+
+void MetricsExporter::serve(QTcpSocket* socket) {
+    auto request = std::make_shared<QByteArray>();
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    QTimer::singleShot(REQUEST_TIMEOUT_MS, socket, [socket]() { socket->abort(); });
+
+    connect(socket, &QTcpSocket::readyRead, socket, [this, socket, request]() {
+        request->append(socket->readAll());
+        const bool complete = request->contains("\r\n\r\n") || request->contains("\n\n");
+        if (!complete && request->size() < MAX_REQUEST_BYTES) return;
+
+        socket->write(complete ? respond(*request)
+                               : httpResponse("431 Request Header Fields Too Large",
+                                              "text/plain", QByteArray(), true));
+        socket->disconnectFromHost();
+        disconnect(socket, &QTcpSocket::readyRead, socket, nullptr);
+    });
+}
+
+QByteArray MetricsExporter::respond(const QByteArray& request) {
+    // Request line: METHOD SP target SP version
+    const int lineEnd = request.indexOf('\n');
+    const QList<QByteArray> parts = request.left(lineEnd).trimmed().split(' ');
+    if (parts.size() < 2) {
+        return httpResponse("400 Bad Request", "text/plain", QByteArray(), true);
+    }
+    const QByteArray& method = parts[0];
+    QByteArray path = parts[1];
+    const int query = path.indexOf('?');
+    if (query >= 0) path.truncate(query);
+
+    if (method != "GET" && method != "HEAD") {
+        return httpResponse("405 Method Not Allowed", "text/plain", QByteArray(), true);
+    }
+    if (path != "/metrics") {
+        return httpResponse("404 Not Found", "text/plain", "Metrics are at /metrics\n", method == "GET");
+    }
+
+    m_requests.fetch_add(1, std::memory_order_relaxed);
+    return httpResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                        m_registry->toPrometheusText(), method == "GET");
+}
+
+} // namespace CounterUAS
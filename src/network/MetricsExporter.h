@@ -0,0 +1,57 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QString>
+#include <atomic>
+
+class QThread;
+class QTcpSocket;
+
+namespace CounterUAS {
+
+class MetricsRegistry;
+
+/**
+ * @brief HTTP endpoint serving a MetricsRegistry for Prometheus to scrape
+ *
+ * GET /metrics answers with the registry in the Prometheus text format;
+ * every other path is 404. The server and its connections live on their own
+ * thread, so a scrape never waits for the GUI or the track cycle, and it
+ * reads only the registry's atomics. One request per connection.
+ */
+class MetricsExporter : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int REQUEST_TIMEOUT_MS = 5000;   // Idle connections are dropped
+    static constexpr int MAX_REQUEST_BYTES = 8192;
+
+    explicit MetricsExporter(MetricsRegistry* registry = nullptr, QObject* parent = nullptr);
+    ~MetricsExporter() override;
+
+    // Port 0 binds any free port; port() then tells which
+    bool start(quint16 port, const QHostAddress& address = QHostAddress::Any);
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+    quint16 port() const { return m_port; }
+    QString errorString() const { return m_error; }
+
+    quint64 requestsServed() const { return m_requests.load(std::memory_order_relaxed); }
+
+private:
+    void serve(QTcpSocket* socket);
+    QByteArray respond(const QByteArray& request);
+
+    MetricsRegistry* m_registry;
+    QThread* m_thread = nullptr;
+    QObject* m_context = nullptr;   // Lives on m_thread, parents the server
+    quint16 m_port = 0;
+    QString m_error;
+    std::atomic<quint64> m_requests{0};
+};
+
+} // namespace CounterUAS
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,159 @@
+#include "network/MulticastPublisher.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+#include <QNetworkInterface>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QtEndian>
+
+namespace CounterUAS {
+
+MulticastPublisher::MulticastPublisher(QObject* parent)
+    : QObject(parent)
+    , m_socket(new QUdpSocket(this))
+{
+    connect(m_socket, &QUdpSocket::readyRead, this, &MulticastPublisher::onReadyRead);
+}
+
+MulticastPublisher::~MulticastPublisher() {
+    stop();
+}
+
+bool MulticastPublisher::start(const MulticastConfig& config) {
+    stop();
+    m_config = config;
+    m_config.maxDatagramSize = qMax(config.maxDatagramSize,
+                                    MulticastWire::DATA_HEADER_SIZE + MessageProtocol::HEADER_SIZE);
+
+    // Ephemeral port: receivers send NACKs back to wherever data came from
+    if (!m_socket->bind(QHostAddress::AnyIPv4, 0)) {
+        Logger::instance().error("MulticastPublisher",
+                                "Failed to bind: " + m_socket->errorString());
+        return false;
+    }
+    m_socket->setSocketOption(QAbstractSocket::MulticastTtlOption, m_config.ttl);
+    m_socket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, m_config.loopback ? 1 : 0);
+    if (!m_config.interfaceName.isEmpty()) {
+        m_socket->setMulticastInterface(QNetworkInterface::interfaceFromName(m_config.interfaceName));
+    }
+
+    m_session = QRandomGenerator::global()->generate();
+    m_sequence = 0;
+    m_history = QVector<HistoryEntry>(qMax(1, m_config.historySize));
+    m_pending.clear();
+    m_pendingFrames = 0;
+    m_active = true;
+
+    Logger::instance().info("MulticastPublisher",
+        QString("Publishing to %1:%2").arg(m_config.group.toString()).arg(m_config.port));
+    return true;
+}
+
+void MulticastPublisher::stop() {
+    if (!m_active) return;
+    flush();
+    m_socket->close();
+    m_history.clear();
+    m_active = false;
+}
+
+void MulticastPublisher::publish(const QByteArray& frame) {
+    if (!m_active || frame.isEmpty()) return;
+
+    // Close the current datagram if this frame would push it past the limit
+    if (m_pendingFrames > 0 && m_pending.size() + frame.size() > m_config.maxDatagramSize) {
+        sendPending();
+    }
+    if (m_pendingFrames == 0) {
+        beginDatagram();
+    }
+    m_pending.append(frame);
+    ++m_pendingFrames;
+
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, this, &MulticastPublisher::flush);
+    }
+}
+
+void MulticastPublisher::flush() {
+    m_flushScheduled = false;
+    if (m_pendingFrames > 0) {
+        sendPending();
+    }
+}
+
+void MulticastPublisher::beginDatagram() {
+    m_pending.resize(MulticastWire::DATA_HEADER_SIZE);
+    uchar* header = reinterpret_cast<uchar*>(m_pending.data());
+    qToBigEndian<quint32>(MulticastWire::DATA_MAGIC, header);
+    qToBigEndian<quint32>(m_session, header + 4);
+    qToBigEndian<quint32>(++m_sequence, header + 8);
+}
+
+void MulticastPublisher::sendPending() {
+    uchar* header = reinterpret_cast<uchar*>(m_pending.data());
+    qToBigEndian<quint16>(static_cast<quint16>(m_pendingFrames), header + 12);
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_socket->writeDatagram(m_pending, m_config.group, m_config.port);
+    ++m_stats.datagramsSent;
+    m_stats.framesSent += m_pendingFrames;
+    m_stats.bytesSent += m_pending.size();
+
+    HistoryEntry& entry = m_history[m_sequence % m_history.size()];
+    entry.sequence = m_sequence;
+    entry.datagram = m_pending;
+    entry.lastSentMs = now;
+
+    m_pending = QByteArray();  // The history keeps the bytes; start a fresh buffer
+    m_pending.reserve(m_config.maxDatagramSize);
+    m_pendingFrames = 0;
+}
+
+void MulticastPublisher::onReadyRead() {
+    while (m_socket->hasPendingDatagrams()) {
+        const int pending = static_cast<int>(qMax<qint64>(m_socket->pendingDatagramSize(), 0));
+        if (m_readBuffer.size() < pending) {
+            m_readBuffer.resize(pending);
+        }
+        const qint64 bytesRead = m_socket->readDatagram(m_readBuffer.data(), pending);
+        if (bytesRead > 0) {
+            handleNack(m_readBuffer.constData(), static_cast<int>(bytesRead));
+        }
+    }
+}
+
+void MulticastPublisher::handleNack(const char* data, int size) {
+    if (size < MulticastWire::NACK_HEADER_SIZE) return;
+    const uchar* bytes = reinterpret_cast<const uchar*>(data);
+    if (qFromBigEndian<quint32>(bytes) != MulticastWire::NACK_MAGIC ||
+        qFromBigEndian<quint32>(bytes + 4) != m_session) {
+        return;  // Stray traffic, or a NACK for a previous session
+    }
+
+    const int ranges = qMin<int>(qFromBigEndian<quint16>(bytes + 8), MulticastWire::MAX_NACK_RANGES);
+    if (size < MulticastWire::NACK_HEADER_SIZE + ranges * MulticastWire::NACK_RANGE_SIZE) return;
+    ++m_stats.nacksReceived;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const uchar* range = bytes + MulticastWire::NACK_HEADER_SIZE;
+    for (int r = 0; r < ranges; ++r, range += MulticastWire::NACK_RANGE_SIZE) {
+        const quint32 first = qFromBigEndian<quint32>(range);
+        const int count = qMin<int>(qFromBigEndian<quint16>(range + 4), m_history.size());
+
+        for (int i = 0; i < count; ++i) {
+            const quint32 sequence = first + static_cast<quint32>(i);
+            HistoryEntry& entry = m_history[sequence % m_history.size()];
+            if (entry.sequence != sequence || entry.datagram.isEmpty()) continue;  // Aged out
+            if (now - entry.lastSentMs < REPAIR_HOLDOFF_MS) continue;  // Just repaired
+
+            m_socket->writeDatagram(entry.datagram, m_config.group, m_config.port);
+            entry.lastSentMs = now;
+            ++m_stats.repairsSent;
+            m_stats.bytesSent += entry.datagram.size();
+        }
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,113 @@
+#ifndef MULTICASTPUBLISHER_H
+#define MULTICASTPUBLISHER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QUdpSocket>
+#include <QVector>
+#include "network/MessageProtocol.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Multicast group settings shared by publisher and subscriber
+ */
+struct MulticastConfig {
+    QHostAddress group = QHostAddress(QStringLiteral("239.255.42.1"));
+    quint16 port = 47001;
+    int ttl = 1;                    // Hops; 1 keeps it on the local segment
+    int maxDatagramSize = 1400;     // Stays under a 1500-byte Ethernet MTU
+    int historySize = 2048;         // Datagrams kept for repair
+    QString interfaceName;          // Empty: the system default
+    bool loopback = false;
+    WireEncoding wireEncoding = WireEncoding::Binary;
+};
+
+/**
+ * @brief Datagram framing for the multicast stream
+ *
+ * Data: magic(4) session(4) sequence(4) frameCount(2), then protocol
+ * frames back to back. NACK, unicast to the publisher: magic(4)
+ * session(4) rangeCount(2), then first(4) count(2) per range.
+ */
+namespace MulticastWire {
+constexpr quint32 DATA_MAGIC = 0x4355414D;  // "CUAM"
+constexpr quint32 NACK_MAGIC = 0x4355414E;  // "CUAN"
+constexpr int DATA_HEADER_SIZE = 14;
+constexpr int NACK_HEADER_SIZE = 10;
+constexpr int NACK_RANGE_SIZE = 6;
+constexpr int MAX_NACK_RANGES = 64;
+}
+
+/**
+ * @brief Sends protocol frames to a multicast group once for all consoles
+ *
+ * publish() queues an already serialized frame. Queued frames are packed
+ * into as few datagrams as fit under maxDatagramSize and sent when control
+ * returns to the event loop, so everything published in one track cycle
+ * goes out together. A frame larger than one datagram travels alone.
+ *
+ * Every datagram carries a sequence number and stays in a history ring.
+ * A receiver that sees a gap NACKs the missing ranges, and the publisher
+ * multicasts them again, each datagram at most once per holdoff no matter
+ * how many receivers asked.
+ */
+class MulticastPublisher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MulticastPublisher(QObject* parent = nullptr);
+    ~MulticastPublisher() override;
+
+    bool start(const MulticastConfig& config);
+    void stop();
+    bool isActive() const { return m_active; }
+    const MulticastConfig& config() const { return m_config; }
+
+    void publish(const QByteArray& frame);
+    void flush();
+
+    struct Stats {
+        qint64 datagramsSent = 0;
+        qint64 framesSent = 0;
+        qint64 bytesSent = 0;
+        qint64 nacksReceived = 0;
+        qint64 repairsSent = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+private slots:
+    void onReadyRead();
+
+private:
+    struct HistoryEntry {
+        quint32 sequence = 0;
+        QByteArray datagram;
+        qint64 lastSentMs = 0;
+    };
+
+    void beginDatagram();
+    void sendPending();
+    void handleNack(const char* data, int size);
+
+    static constexpr int REPAIR_HOLDOFF_MS = 20;
+
+    MulticastConfig m_config;
+    QUdpSocket* m_socket;
+    bool m_active = false;
+    quint32 m_session = 0;
+    quint32 m_sequence = 0;
+
+    QByteArray m_pending;       // Datagram being packed
+    int m_pendingFrames = 0;
+    bool m_flushScheduled = false;
+
+    QVector<HistoryEntry> m_history;  // Indexed by sequence % size
+    QByteArray m_readBuffer;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // MULTICASTPUBLISHER_H
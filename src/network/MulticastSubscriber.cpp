@@ -0,0 +1,223 @@
+#include "network/MulticastSubscriber.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+#include <QNetworkInterface>
+#include <QtEndian>
+
+namespace CounterUAS {
+
+MulticastSubscriber::MulticastSubscriber(QObject* parent)
+    : QObject(parent)
+    , m_socket(new QUdpSocket(this))
+    , m_repairTimer(new QTimer(this))
+{
+    m_repairTimer->setInterval(NACK_INTERVAL_MS);
+    connect(m_socket, &QUdpSocket::readyRead, this, &MulticastSubscriber::onReadyRead);
+    connect(m_repairTimer, &QTimer::timeout, this, &MulticastSubscriber::onRepairTimer);
+}
+
+MulticastSubscriber::~MulticastSubscriber() {
+    leave();
+}
+
+bool MulticastSubscriber::join(const MulticastConfig& config) {
+    leave();
+    m_config = config;
+
+    if (!m_socket->bind(QHostAddress::AnyIPv4, m_config.port,
+                        QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        Logger::instance().error("MulticastSubscriber",
+                                "Failed to bind: " + m_socket->errorString());
+        return false;
+    }
+
+    const bool joined = m_config.interfaceName.isEmpty()
+        ? m_socket->joinMulticastGroup(m_config.group)
+        : m_socket->joinMulticastGroup(m_config.group,
+                                       QNetworkInterface::interfaceFromName(m_config.interfaceName));
+    if (!joined) {
+        Logger::instance().error("MulticastSubscriber",
+                                "Failed to join " + m_config.group.toString() + ": " +
+                                m_socket->errorString());
+        m_socket->close();
+        return false;
+    }
+
+    m_haveSession = false;
+    m_joined = true;
+    Logger::instance().info("MulticastSubscriber",
+        QString("Joined %1:%2").arg(m_config.group.toString()).arg(m_config.port));
+    return true;
+}
+
+void MulticastSubscriber::leave() {
+    if (!m_joined) return;
+    m_socket->leaveMulticastGroup(m_config.group);
+    m_socket->close();
+    m_repairTimer->stop();
+    m_reorder.clear();
+    m_haveSession = false;
+    m_joined = false;
+}
+
+void MulticastSubscriber::onReadyRead() {
+    while (m_joined && m_socket->hasPendingDatagrams()) {
+        const int pending = static_cast<int>(qMax<qint64>(m_socket->pendingDatagramSize(), 0));
+        if (m_readBuffer.size() < pending) {
+            m_readBuffer.resize(pending);
+        }
+
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        const qint64 bytesRead = m_socket->readDatagram(m_readBuffer.data(), pending,
+                                                        &sender, &senderPort);
+        if (bytesRead > 0) {
+            handleDatagram(m_readBuffer.constData(), static_cast<int>(bytesRead), sender, senderPort);
+        }
+    }
+}
+
+void MulticastSubscriber::handleDatagram(const char* data, int size, const QHostAddress& sender,
+                                         quint16 senderPort) {
+    if (size < MulticastWire::DATA_HEADER_SIZE) return;
+    const uchar* bytes = reinterpret_cast<const uchar*>(data);
+    if (qFromBigEndian<quint32>(bytes) != MulticastWire::DATA_MAGIC) return;
+
+    const quint32 session = qFromBigEndian<quint32>(bytes + 4);
+    const quint32 sequence = qFromBigEndian<quint32>(bytes + 8);
+
+    if (!m_haveSession || session != m_session) {
+        // First datagram, or the publisher restarted: pick the stream up here
+        m_haveSession = true;
+        m_session = session;
+        m_expected = sequence;
+        m_reorder.clear();
+        m_repairTimer->stop();
+    }
+    m_publisher = sender;
+    m_publisherPort = senderPort;
+
+    const quint64 extended = m_expected +
+        static_cast<qint64>(static_cast<qint32>(sequence - static_cast<quint32>(m_expected)));
+    if (extended < m_expected || m_reorder.contains(extended)) {
+        ++m_stats.duplicates;  // Already delivered, or a second repair
+        return;
+    }
+    ++m_stats.datagramsReceived;
+
+    if (extended == m_expected) {
+        if (hasGap()) ++m_stats.repaired;
+        ++m_expected;
+        deliver(data + MulticastWire::DATA_HEADER_SIZE, size - MulticastWire::DATA_HEADER_SIZE);
+        drainInOrder();
+        return;
+    }
+
+    // Ahead of a gap: hold it and ask for what is missing
+    const bool newGap = !hasGap();
+    m_reorder.insert(extended, QByteArray(data, size));
+    if (newGap) {
+        m_gapSinceMs = QDateTime::currentMSecsSinceEpoch();
+        m_repairTimer->start();
+        sendNack();
+    }
+    if (m_reorder.size() > MAX_REORDER) {
+        skipGap();
+    }
+}
+
+void MulticastSubscriber::drainInOrder() {
+    while (m_joined && !m_reorder.isEmpty() && m_reorder.firstKey() == m_expected) {
+        const QByteArray datagram = m_reorder.take(m_expected);
+        ++m_expected;
+        deliver(datagram.constData() + MulticastWire::DATA_HEADER_SIZE,
+                datagram.size() - MulticastWire::DATA_HEADER_SIZE);
+    }
+
+    if (m_reorder.isEmpty()) {
+        m_repairTimer->stop();
+    } else {
+        m_gapSinceMs = QDateTime::currentMSecsSinceEpoch();  // Progress; time the new head gap
+    }
+}
+
+void MulticastSubscriber::deliver(const char* data, int size) {
+    int offset = 0;
+    while (offset < size) {
+        FrameHeader header;
+        if (MessageProtocol::parseHeader(data + offset, size - offset, header) <= 0 ||
+            MessageProtocol::HEADER_SIZE + header.payloadSize > size - offset) {
+            ++m_stats.malformedFrames;
+            return;  // Frames never span datagrams, so the rest is unreadable
+        }
+
+        Message msg;
+        if (m_protocol.decodePayload(header, data + offset + MessageProtocol::HEADER_SIZE, msg)) {
+            emit messageReceived(msg);
+        } else {
+            ++m_stats.malformedFrames;
+        }
+        offset += MessageProtocol::HEADER_SIZE + header.payloadSize;
+    }
+}
+
+void MulticastSubscriber::onRepairTimer() {
+    if (!hasGap()) {
+        m_repairTimer->stop();
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - m_gapSinceMs >= m_repairTimeoutMs) {
+        skipGap();
+    } else if (now - m_lastNackMs >= NACK_INTERVAL_MS) {
+        sendNack();
+    }
+}
+
+void MulticastSubscriber::skipGap() {
+    if (!hasGap()) return;
+
+    const quint64 resume = m_reorder.firstKey();
+    const int lost = static_cast<int>(resume - m_expected);
+    m_stats.lost += lost;
+    Logger::instance().warning("MulticastSubscriber",
+        QString("Gave up on %1 datagram(s) from %2").arg(lost).arg(static_cast<quint32>(m_expected)));
+    emit sequenceLost(static_cast<quint32>(m_expected), lost);
+
+    m_expected = resume;
+    drainInOrder();
+}
+
+void MulticastSubscriber::sendNack() {
+    if (!hasGap() || m_publisherPort == 0) return;
+
+    QByteArray nack(MulticastWire::NACK_HEADER_SIZE, Qt::Uninitialized);
+    uchar* header = reinterpret_cast<uchar*>(nack.data());
+    qToBigEndian<quint32>(MulticastWire::NACK_MAGIC, header);
+    qToBigEndian<quint32>(m_session, header + 4);
+
+    // Missing runs are the holes between m_expected and the datagrams held
+    int ranges = 0;
+    quint64 cursor = m_expected;
+    for (auto it = m_reorder.constBegin();
+         it != m_reorder.constEnd() && ranges < MulticastWire::MAX_NACK_RANGES; ++it) {
+        while (cursor < it.key() && ranges < MulticastWire::MAX_NACK_RANGES) {
+            const quint16 count = static_cast<quint16>(qMin<quint64>(it.key() - cursor, 0xFFFF));
+            uchar range[MulticastWire::NACK_RANGE_SIZE];
+            qToBigEndian<quint32>(static_cast<quint32>(cursor), range);
+            qToBigEndian<quint16>(count, range + 4);
+            nack.append(reinterpret_cast<const char*>(range), MulticastWire::NACK_RANGE_SIZE);
+            cursor += count;
+            ++ranges;
+        }
+        cursor = it.key() + 1;
+    }
+    qToBigEndian<quint16>(static_cast<quint16>(ranges), reinterpret_cast<uchar*>(nack.data()) + 8);
+
+    m_socket->writeDatagram(nack, m_publisher, m_publisherPort);
+    m_lastNackMs = QDateTime::currentMSecsSinceEpoch();
+    ++m_stats.nacksSent;
+}
+
+} // namespace CounterUAS
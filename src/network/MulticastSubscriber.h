@@ -0,0 +1,91 @@
+#ifndef MULTICASTSUBSCRIBER_H
+#define MULTICASTSUBSCRIBER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QMap>
+#include <QTimer>
+#include <QUdpSocket>
+#include "network/MessageProtocol.h"
+#include "network/MulticastPublisher.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Receives a multicast stream in order, repairing gaps by NACK
+ *
+ * Datagrams that arrive ahead of a gap are held in a reorder buffer while
+ * the missing ranges are NACKed to the publisher, and are retried every
+ * NACK interval. When the oldest gap outlives the repair timeout, or the
+ * buffer fills, the gap is given up, reported through sequenceLost(), and
+ * delivery resumes from the next datagram held. Frames are decoded in
+ * place from each datagram.
+ */
+class MulticastSubscriber : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MulticastSubscriber(QObject* parent = nullptr);
+    ~MulticastSubscriber() override;
+
+    bool join(const MulticastConfig& config);
+    void leave();
+    bool isJoined() const { return m_joined; }
+
+    void setRepairTimeout(int timeoutMs) { m_repairTimeoutMs = qMax(0, timeoutMs); }
+
+    struct Stats {
+        qint64 datagramsReceived = 0;
+        qint64 duplicates = 0;
+        qint64 nacksSent = 0;
+        qint64 repaired = 0;      // Gapped datagrams that arrived in time
+        qint64 lost = 0;          // Datagrams given up on
+        qint64 malformedFrames = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+signals:
+    void messageReceived(const Message& message);
+    void sequenceLost(quint32 firstSequence, int count);
+
+private slots:
+    void onReadyRead();
+    void onRepairTimer();
+
+private:
+    void handleDatagram(const char* data, int size, const QHostAddress& sender, quint16 senderPort);
+    void deliver(const char* data, int size);
+    void drainInOrder();
+    void sendNack();
+    void skipGap();
+    bool hasGap() const { return !m_reorder.isEmpty(); }
+
+    static constexpr int NACK_INTERVAL_MS = 20;
+    static constexpr int MAX_REORDER = 1024;
+
+    MulticastConfig m_config;
+    QUdpSocket* m_socket;
+    QTimer* m_repairTimer;
+    MessageProtocol m_protocol;
+    bool m_joined = false;
+    int m_repairTimeoutMs = 500;
+
+    // Stream position for the current publisher session
+    bool m_haveSession = false;
+    quint32 m_session = 0;
+    quint64 m_expected = 0;     // Sequence extended past 32-bit wrap
+    QHostAddress m_publisher;
+    quint16 m_publisherPort = 0;
+
+    QMap<quint64, QByteArray> m_reorder;   // Held ahead of a gap, by extended sequence
+    qint64 m_gapSinceMs = 0;
+    qint64 m_lastNackMs = 0;
+
+    QByteArray m_readBuffer;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // MULTICASTSUBSCRIBER_H
@@ -1,53 +1,389 @@
 #include "network/NetworkManager.h"
+#include "network/MulticastSubscriber.h"
+#include "network/SharedMemorySubscriber.h"
 #include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/PipelineLatency.h"
+#include "utils/RawCapture.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
 #include <QDateTime>
+#include <QThread>
 
 namespace CounterUAS {
 
+namespace {
+
+// Frames whose value lapses: a late one is worth less than none
+bool isDroppable(MessageType type) {
+    switch (type) {
+    case MessageType::TrackUpdate:
+    case MessageType::SensorDetection:
+    case MessageType::SensorStatus:
+    case MessageType::EffectorStatus:
+    case MessageType::Heartbeat:
+    case MessageType::VideoFrame:
+    case MessageType::Log:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// A field of a message sent in map form
+QString payloadString(const TypedMessage& message, const char* key) {
+    const DynamicBody* dynamic = message.as<DynamicBody>();
+    return dynamic ? dynamic->payload.value(QLatin1String(key)).toString() : QString();
+}
+
+// A queued frame with the same key is replaced rather than followed
+QString supersedeKey(const TypedMessage& message) {
+    switch (message.type()) {
+    case MessageType::TrackUpdate: {
+        const TrackUpdateBody* update = message.as<TrackUpdateBody>();
+        return QStringLiteral("track:") + (update ? update->trackId : payloadString(message, "trackId"));
+    }
+    case MessageType::EffectorStatus: {
+        const EffectorStatusBody* status = message.as<EffectorStatusBody>();
+        return QStringLiteral("effector:") + (status ? status->effectorId : payloadString(message, "effectorId"));
+    }
+    case MessageType::SensorStatus:
+        return QStringLiteral("sensor:") + message.sourceId;
+    case MessageType::Heartbeat:
+        return QStringLiteral("heartbeat");
+    default:
+        return QString();
+    }
+}
+
+} // namespace
+
 NetworkManager::NetworkManager(QObject* parent)
     : QObject(parent)
-    , m_reconnectTimer(new QTimer(this))
-    , m_bandwidthTimer(new QTimer(this))
+    , m_ioThread(new QThread(this))
+    , m_ioContext(new QObject)
+    , m_bandwidthTimer(m_ioContext, [this]() { updateBandwidth(); })
+    , m_heartbeatTimer(m_ioContext, [this]() { sendHeartbeats(); })
+    , m_events(EVENT_QUEUE_CAPACITY)
+    , m_outbound(SEND_QUEUE_CAPACITY)
 {
-    m_reconnectTimer->setInterval(5000);
-    connect(m_reconnectTimer, &QTimer::timeout, this, &NetworkManager::attemptReconnect);
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_connectedMetric = registry.gauge("cuas_network_connections", "Connections in the Connected state");
+    m_bytesSentMetric = registry.counter("cuas_network_sent_bytes_total", "Bytes written to peers");
+    m_bytesReceivedMetric = registry.counter("cuas_network_received_bytes_total", "Bytes read from peers");
+    m_rateMetric = registry.gauge("cuas_network_rate_bytes_per_second", "Combined link throughput");
+    m_udpDroppedMetric = registry.counter("cuas_network_udp_dropped_datagrams_total",
+                                          "Datagrams the kernel dropped on UDP receive sockets");
+    const char* laneNames[] = {"critical", "normal", "bulk"};
+    static_assert(sizeof(laneNames) / sizeof(laneNames[0]) == static_cast<int>(SendLane::Count),
+                  "one name per send lane");
+    for (int l = 0; l < static_cast<int>(SendLane::Count); ++l) {
+        const MetricLabels lane = {{"lane", laneNames[l]}};
+        m_laneMetrics[l].queued = registry.gauge("cuas_network_queued_frames", "Frames waiting to send", lane);
+        m_laneMetrics[l].sent = registry.counter("cuas_network_sent_frames_total", "Frames sent", lane);
+        m_laneMetrics[l].dropped = registry.counter("cuas_network_dropped_frames_total",
+                                                    "Frames dropped as stale, over limit or on disconnect",
+                                                    lane);
+    }
     
-    m_bandwidthTimer->setInterval(1000);
-    connect(m_bandwidthTimer, &QTimer::timeout, this, &NetworkManager::updateBandwidth);
-    m_bandwidthTimer->start();
+    m_ioThread->setObjectName("NetworkIoThread");
+    m_ioContext->moveToThread(m_ioThread);
+    ThreadPlacement::instance().assign(m_ioThread, ThreadRole::SensorIO);
+    m_ioThread->start();
+    
+    m_bandwidthTimer.start(1000);
+    m_heartbeatTimer.start(m_heartbeatIntervalMs);
 }
 
 NetworkManager::~NetworkManager() {
-    disconnectAll();
+    m_bandwidthTimer.stop();
+    m_heartbeatTimer.stop();
+    // Sockets go on the thread they live on, unsent frames with them
+    QMetaObject::invokeMethod(m_ioContext, [this]() {
+        for (const QString& id : m_connections.keys()) {
+            closeConnection(id);
+        }
+    }, Qt::BlockingQueuedConnection);
+    m_ioThread->quit();
+    m_ioThread->wait();
+    delete m_ioContext;
+    
+    stopMulticastPublisher();
+    leaveMulticast();
+    stopSharedMemoryPublisher();
 }
 
 QString NetworkManager::addConnection(const ConnectionConfig& config) {
+    {
+        QMutexLocker locker(&m_viewMutex);
+        m_views.insert(config.connectionId, ConnectionView());
+    }
+    QMetaObject::invokeMethod(m_ioContext, [this, config]() { openConnection(config); },
+                              Qt::QueuedConnection);
+    return config.connectionId;
+}
+
+void NetworkManager::removeConnection(const QString& connectionId) {
+    {
+        QMutexLocker locker(&m_viewMutex);
+        if (!m_views.remove(connectionId)) return;
+    }
+    QMetaObject::invokeMethod(m_ioContext, [this, connectionId]() { closeConnection(connectionId); },
+                              Qt::QueuedConnection);
+}
+
+void NetworkManager::connectTo(const QString& connectionId) {
+    QMetaObject::invokeMethod(m_ioContext, [this, connectionId]() { openLink(connectionId); },
+                              Qt::QueuedConnection);
+}
+
+void NetworkManager::disconnect(const QString& connectionId) {
+    QMetaObject::invokeMethod(m_ioContext, [this, connectionId]() { closeLink(connectionId); },
+                              Qt::QueuedConnection);
+}
+
+void NetworkManager::disconnectAll() {
+    for (const QString& id : connectionIds()) {
+        disconnect(id);
+    }
+}
+
+ConnectionStatus NetworkManager::connectionStatus(const QString& connectionId) const {
+    QMutexLocker locker(&m_viewMutex);
+    auto it = m_views.constFind(connectionId);
+    return it != m_views.constEnd() ? it->status : ConnectionStatus::Disconnected;
+}
+
+QList<QString> NetworkManager::connectionIds() const {
+    QMutexLocker locker(&m_viewMutex);
+    return m_views.keys();
+}
+
+bool NetworkManager::isConnected(const QString& connectionId) const {
+    return connectionStatus(connectionId) == ConnectionStatus::Connected;
+}
+
+WireEncoding NetworkManager::sendEncoding(const QString& connectionId) const {
+    QMutexLocker locker(&m_viewMutex);
+    auto it = m_views.constFind(connectionId);
+    return it != m_views.constEnd() ? it->sendEncoding : WireEncoding::Json;
+}
+
+void NetworkManager::setNodeId(const QString& nodeId) {
+    QMetaObject::invokeMethod(m_ioContext, [this, nodeId]() { m_nodeId = nodeId; },
+                              Qt::QueuedConnection);
+}
+
+void NetworkManager::setCapture(const std::shared_ptr<RawCaptureRecorder>& recorder) {
+    QMetaObject::invokeMethod(m_ioContext, [this, recorder]() {
+        m_capture = recorder;
+        for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
+            openCaptureChannel(it.value());
+        }
+    }, Qt::QueuedConnection);
+}
+
+void NetworkManager::replayRaw(const QString& connectionId, const QByteArray& data) {
+    QMetaObject::invokeMethod(m_ioContext, [this, connectionId, data]() {
+        auto it = m_connections.find(connectionId);
+        if (it == m_connections.end() || it->status == ConnectionStatus::Connected) return;
+        it->reader.append(data.constData(), data.size());
+        processFrames(connectionId);
+    }, Qt::QueuedConnection);
+}
+
+void NetworkManager::openCaptureChannel(Connection& conn) {
+    conn.captureChannel = m_capture
+        ? m_capture->openChannel("network:" + conn.config.connectionId,
+                                 conn.config.useTcp ? RawCaptureKind::Stream : RawCaptureKind::Datagram)
+        : -1;
+}
+
+void NetworkManager::send(const QString& connectionId, const Message& message) {
+    send(connectionId, TypedMessage::fromMessage(message));
+}
+
+void NetworkManager::send(const QString& connectionId, const TypedMessage& message) {
+    OutboundMessage item;
+    item.connectionId = connectionId;
+    item.message = message;
+    pushOutbound(std::move(item));
+}
+
+void NetworkManager::broadcast(const Message& message) {
+    broadcast(TypedMessage::fromMessage(message));
+}
+
+void NetworkManager::broadcast(const TypedMessage& message) {
+    // The publishers are this thread's; the connections get it on the I/O thread
+    const bool multicast = m_multicastPublisher && m_multicastPublisher->isActive();
+    QByteArray binary;
+    if (multicast) {
+        const WireEncoding encoding = m_multicastPublisher->config().wireEncoding;
+        const QByteArray frame = m_publishProtocol.serialize(message, encoding);
+        m_multicastPublisher->publish(frame);
+        if (encoding == WireEncoding::Binary) {
+            binary = frame;
+        }
+    }
+    if (m_sharedMemoryPublisher && m_sharedMemoryPublisher->isActive()) {
+        if (binary.isEmpty()) {
+            binary = m_publishProtocol.serialize(message, WireEncoding::Binary);
+        }
+        m_sharedMemoryPublisher->publish(binary);
+    }
+    
+    OutboundMessage item;
+    item.message = message;
+    item.skipMulticastMembers = multicast;
+    pushOutbound(std::move(item));
+}
+
+void NetworkManager::pushOutbound(OutboundMessage item) {
+    // Full only when the I/O thread is a whole queue behind; it never waits on this one
+    while (!m_outbound.tryPush(item)) {
+        QThread::yieldCurrentThread();
+    }
+    if (!m_drainScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(m_ioContext, [this]() { drainOutbound(); }, Qt::QueuedConnection);
+    }
+}
+
+void NetworkManager::drainOutbound() {
+    m_drainScheduled.store(false);
+    OutboundMessage item;
+    while (m_outbound.tryPop(item)) {
+        if (item.connectionId.isEmpty()) {
+            broadcastNow(item.message, item.skipMulticastMembers);
+        } else {
+            sendNow(item.connectionId, item.message);
+        }
+    }
+}
+
+void NetworkManager::postEvent(NetworkEvent event) {
+    if (!m_events.tryPush(event)) {
+        if (event.kind == NetworkEvent::Received) {
+            // Dropped like a late datagram rather than stalling every link
+            m_receivedDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // State must not be lost; it may overtake messages still in the ring
+        QMetaObject::invokeMethod(this, [this, event]() { emitEvent(event); }, Qt::QueuedConnection);
+        return;
+    }
+    if (!m_deliverScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() { deliverEvents(); }, Qt::QueuedConnection);
+    }
+}
+
+void NetworkManager::deliverEvents() {
+    m_deliverScheduled.store(false);
+    NetworkEvent event;
+    while (m_events.tryPop(event)) {
+        emitEvent(event);
+    }
+}
+
+void NetworkManager::emitEvent(const NetworkEvent& event) {
+    switch (event.kind) {
+    case NetworkEvent::Received: {
+        // Nothing more from a connection once it is removed here
+        bool known;
+        {
+            QMutexLocker locker(&m_viewMutex);
+            known = m_views.contains(event.connectionId);
+        }
+        if (known) emit messageReceived(event.connectionId, event.message);
+        break;
+    }
+    case NetworkEvent::Status:
+        emit connectionStatusChanged(event.connectionId, event.status);
+        break;
+    case NetworkEvent::Error:
+        emit connectionError(event.connectionId, event.error);
+        break;
+    case NetworkEvent::Encoding:
+        emit wireEncodingChanged(event.connectionId, event.encoding);
+        break;
+    case NetworkEvent::Bandwidth:
+        emit bandwidthUpdated(totalBandwidth());
+        break;
+    }
+}
+
+void NetworkManager::openConnection(const ConnectionConfig& config) {
     Connection conn;
     conn.config = config;
     conn.status = ConnectionStatus::Disconnected;
     
-    if (config.useTcp) {
-        conn.tcpSocket = new QTcpSocket(this);
-        connect(conn.tcpSocket, &QTcpSocket::connected, this, &NetworkManager::onTcpConnected);
-        connect(conn.tcpSocket, &QTcpSocket::disconnected, this, &NetworkManager::onTcpDisconnected);
-        connect(conn.tcpSocket, &QTcpSocket::readyRead, this, &NetworkManager::onTcpReadyRead);
-        connect(conn.tcpSocket, &QTcpSocket::errorOccurred, this, &NetworkManager::onTcpError);
+    const QString connectionId = config.connectionId;
+    if (!config.sharedMemoryKey.isEmpty()) {
+        conn.sharedMemory = new SharedMemorySubscriber(m_ioContext);
+        SharedMemorySubscriber* subscriber = conn.sharedMemory;
+        connect(subscriber, &SharedMemorySubscriber::messageReceived,
+                m_ioContext, [this, connectionId](const Message& message) {
+            NetworkEvent event;
+            event.connectionId = connectionId;
+            event.message = message;
+            postEvent(std::move(event));
+        });
+        connect(subscriber, &SharedMemorySubscriber::attachedChanged,
+                m_ioContext, [this, connectionId, subscriber](bool attached) {
+            // Not while disconnect() stops it
+            if (!subscriber->isRunning()) return;
+            setConnectionStatus(connectionId, attached ? ConnectionStatus::Connected
+                                                       : ConnectionStatus::Reconnecting);
+        });
+    } else if (config.useTcp) {
+        conn.tcpSocket = new QTcpSocket(m_ioContext);
+        QTcpSocket* socket = conn.tcpSocket;
+        connect(socket, &QTcpSocket::connected, m_ioContext,
+                [this, connectionId]() { onTcpConnected(connectionId); });
+        connect(socket, &QTcpSocket::disconnected, m_ioContext,
+                [this, connectionId]() { onTcpDisconnected(connectionId); });
+        connect(socket, &QTcpSocket::readyRead, m_ioContext,
+                [this, connectionId]() { onTcpReadyRead(connectionId); });
+        connect(socket, &QTcpSocket::bytesWritten, m_ioContext,
+                [this, connectionId]() { onTcpBytesWritten(connectionId); });
+        connect(socket, &QTcpSocket::errorOccurred, m_ioContext,
+                [this, connectionId]() { onTcpError(connectionId); });
+        
+        BackoffPolicy policy;
+        policy.maxDelayMs = qMax(policy.initialDelayMs, config.reconnectIntervalMs);
+        policy.connectTimeoutMs = config.timeoutMs;
+        policy.autoRetry = config.autoReconnect;
+        conn.link = new ManagedConnection(conn.tcpSocket, policy);
+        conn.link->setTarget(config.host, static_cast<quint16>(config.port));
+        
+        connect(conn.link, &ManagedConnection::retryScheduled, m_ioContext, [this, connectionId]() {
+            setConnectionStatus(connectionId, ConnectionStatus::Reconnecting);
+        });
+        
+        if (config.encrypt) {
+            conn.cipher.setLinkKey(LinkCipher::deriveLinkKey(config.username, config.password));
+        }
     } else {
-        conn.udpSocket = new QUdpSocket(this);
-        connect(conn.udpSocket, &QUdpSocket::readyRead, this, &NetworkManager::onUdpReadyRead);
+        conn.udpSocket = new QUdpSocket(m_ioContext);
+        conn.udpReceiver = new DatagramReceiver(m_ioContext);
+        connect(conn.udpReceiver, &DatagramReceiver::batchReady,
+                m_ioContext, [this, connectionId](const DatagramBatchPtr& batch) { onUdpBatch(connectionId, batch); });
+    }
+    if (config.encrypt && !conn.cipher.isEnabled()) {
+        Logger::instance().warning("NetworkManager",
+                                  "Link encryption is TCP only; not encrypted: " + config.name);
     }
     
+    openCaptureChannel(conn);
     m_connections[config.connectionId] = conn;
     
     Logger::instance().info("NetworkManager", "Added connection: " + config.name);
-    
-    return config.connectionId;
 }
 
-void NetworkManager::removeConnection(const QString& connectionId) {
+void NetworkManager::closeConnection(const QString& connectionId) {
     if (!m_connections.contains(connectionId)) return;
     
-    disconnect(connectionId);
+    closeLink(connectionId);
     
     Connection& conn = m_connections[connectionId];
     if (conn.tcpSocket) {
@@ -56,13 +392,19 @@ void NetworkManager::removeConnection(const QString& connectionId) {
     if (conn.udpSocket) {
         delete conn.udpSocket;
     }
+    if (conn.udpReceiver) {
+        delete conn.udpReceiver;
+    }
+    if (conn.sharedMemory) {
+        delete conn.sharedMemory;
+    }
     
     m_connections.remove(connectionId);
     
     Logger::instance().info("NetworkManager", "Removed connection: " + connectionId);
 }
 
-void NetworkManager::connectTo(const QString& connectionId) {
+void NetworkManager::openLink(const QString& connectionId) {
     if (!m_connections.contains(connectionId)) return;
     
     Connection& conn = m_connections[connectionId];
@@ -71,70 +413,314 @@ void NetworkManager::connectTo(const QString& connectionId) {
     
     setConnectionStatus(connectionId, ConnectionStatus::Connecting);
     
-    if (conn.tcpSocket) {
-        conn.tcpSocket->setProperty("connectionId", connectionId);
-        conn.tcpSocket->connectToHost(conn.config.host, conn.config.port);
-    } else if (conn.udpSocket) {
-        conn.udpSocket->setProperty("connectionId", connectionId);
-        if (conn.udpSocket->bind(QHostAddress::Any, conn.config.port)) {
+    if (conn.link) {
+        conn.link->open();
+    } else if (conn.sharedMemory) {
+        // Connected once a publisher is there to attach to; until then it keeps trying
+        SharedMemoryConfig config;
+        config.key = conn.config.sharedMemoryKey;
+        config.retryIntervalMs = qMin(config.retryIntervalMs, conn.config.reconnectIntervalMs);
+        conn.sharedMemory->start(config);
+    } else if (conn.udpReceiver) {
+        // Whole frames per datagram, up to the largest UDP payload
+        DatagramReceiverConfig udp;
+        udp.address = QHostAddress::Any;
+        udp.port = static_cast<quint16>(conn.config.port);
+        udp.maxDatagramBytes = 65536;
+        udp.batchSize = 16;
+        udp.poolBatches = 4;
+        conn.kernelDrops = 0;
+        if (conn.udpReceiver->start(udp)) {
             setConnectionStatus(connectionId, ConnectionStatus::Connected);
+            advertiseEncodings(connectionId);
         } else {
             setConnectionStatus(connectionId, ConnectionStatus::Error);
-            emit connectionError(connectionId, "Failed to bind UDP socket");
+            NetworkEvent event;
+            event.kind = NetworkEvent::Error;
+            event.connectionId = connectionId;
+            event.error = "Failed to bind UDP socket";
+            postEvent(std::move(event));
         }
     }
 }
 
-void NetworkManager::disconnect(const QString& connectionId) {
+void NetworkManager::closeLink(const QString& connectionId) {
     if (!m_connections.contains(connectionId)) return;
     
     Connection& conn = m_connections[connectionId];
     
-    if (conn.tcpSocket && conn.tcpSocket->state() != QAbstractSocket::UnconnectedState) {
-        conn.tcpSocket->disconnectFromHost();
+    if (conn.link) {
+        conn.link->close();
     }
     if (conn.udpSocket) {
         conn.udpSocket->close();
     }
+    if (conn.udpReceiver) {
+        conn.udpReceiver->stop();
+    }
+    if (conn.sharedMemory) {
+        conn.sharedMemory->stop();
+    }
     
     setConnectionStatus(connectionId, ConnectionStatus::Disconnected);
 }
 
-void NetworkManager::disconnectAll() {
-    for (const QString& id : m_connections.keys()) {
-        disconnect(id);
+void NetworkManager::sendNow(const QString& connectionId, const TypedMessage& message) {
+    if (!m_connections.contains(connectionId)) return;
+    
+    Connection& conn = m_connections[connectionId];
+    
+    if (conn.status != ConnectionStatus::Connected) {
+        Logger::instance().warning("NetworkManager",
+                                  "Cannot send - not connected: " + connectionId);
+        return;
     }
+    if (conn.sharedMemory) {
+        Logger::instance().warning("NetworkManager",
+                                  "Cannot send - receive-only shared memory: " + connectionId);
+        return;
+    }
+    
+    enqueueFrame(conn, message, m_protocol.compressFrame(m_protocol.serialize(message, conn.sendEncoding),
+                                                         sendCompression(conn), &conn.bandwidth.compression));
+    pumpSendQueues(conn);
 }
 
-ConnectionStatus NetworkManager::connectionStatus(const QString& connectionId) const {
-    if (!m_connections.contains(connectionId)) {
-        return ConnectionStatus::Disconnected;
+void NetworkManager::broadcastNow(const TypedMessage& message, bool skipMulticastMembers) {
+    // Serialized at most once per encoding, however many peers share it
+    QByteArray frames[2];
+    
+    // And compressed at most once per encoding, codec and dictionary
+    QHash<quint64, QByteArray> compressed;
+    for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
+        Connection& conn = it.value();
+        if (conn.status != ConnectionStatus::Connected) continue;
+        if (skipMulticastMembers && conn.config.multicastMember) continue;
+        if (conn.sharedMemory) continue;
+        
+        const int encodingIndex = conn.sendEncoding == WireEncoding::Binary ? 1 : 0;
+        QByteArray& frame = frames[encodingIndex];
+        if (frame.isEmpty()) {
+            frame = m_protocol.serialize(message, conn.sendEncoding);
+        }
+        
+        const CompressionOptions options = sendCompression(conn);
+        if (options.codec == CompressionCodec::None) {
+            enqueueFrame(conn, message, frame);
+        } else {
+            const quint64 key = quint64(encodingIndex) << 48 | quint64(options.codec) << 40 |
+                                quint64(qBound(0, options.level + 128, 255)) << 32 | options.dictionaryId;
+            auto cached = compressed.constFind(key);
+            if (cached == compressed.constEnd()) {
+                cached = compressed.insert(key, m_protocol.compressFrame(frame, options,
+                                                                         &conn.bandwidth.compression));
+            } else if (cached->size() != frame.size()) {
+                // Shared with an earlier peer: the saving counts here too, the CPU does not
+                conn.bandwidth.compression.framesCompressed++;
+                conn.bandwidth.compression.bytesIn += frame.size() - MessageProtocol::HEADER_SIZE;
+                conn.bandwidth.compression.bytesOut += cached->size() - MessageProtocol::HEADER_SIZE;
+            }
+            enqueueFrame(conn, message, cached.value());
+        }
+        pumpSendQueues(conn);
     }
-    return m_connections[connectionId].status;
 }
 
-QList<QString> NetworkManager::connectionIds() const {
-    return m_connections.keys();
+quint32 NetworkManager::addCompressionDictionary(const QByteArray& dictionary) {
+    // Codec contexts are the I/O thread's; this is set-up, so waiting is fine
+    quint32 id = 0;
+    QMetaObject::invokeMethod(m_ioContext, [this, &id, dictionary]() { id = m_protocol.addDictionary(dictionary); },
+                              Qt::BlockingQueuedConnection);
+    return id;
 }
 
-bool NetworkManager::isConnected(const QString& connectionId) const {
-    return connectionStatus(connectionId) == ConnectionStatus::Connected;
+CompressionOptions NetworkManager::sendCompression(const Connection& conn) const {
+    CompressionOptions options = conn.config.compression;
+    if (options.codec == CompressionCodec::None ||
+        !(conn.peerCodecs & (1 << static_cast<int>(options.codec)))) {
+        options.codec = CompressionCodec::None;
+    } else if (options.dictionaryId != 0 && !conn.peerDictionaries.contains(options.dictionaryId)) {
+        options.dictionaryId = 0;
+    }
+    return options;
 }
 
-void NetworkManager::send(const QString& connectionId, const Message& message) {
-    if (!m_connections.contains(connectionId)) return;
+SendLane NetworkManager::laneFor(MessageType type) {
+    switch (type) {
+    case MessageType::EngagementRequest:
+    case MessageType::EngagementAuthorize:
+    case MessageType::EngagementAbort:
+    case MessageType::EffectorCommand:
+    case MessageType::Alert:
+    case MessageType::AlertSync:
+        return SendLane::Critical;
+    case MessageType::Log:
+    case MessageType::Config:
+    case MessageType::SensorConfig:
+    case MessageType::VideoConfig:
+    case MessageType::VideoFrame:
+        return SendLane::Bulk;
+    default:
+        return SendLane::Normal;
+    }
+}
+
+void NetworkManager::enqueueFrame(Connection& conn, const TypedMessage& message, const QByteArray& data) {
+    const MessageType type = message.type();
+    const int laneIndex = static_cast<int>(laneFor(type));
+    SendQueue& lane = conn.lanes[laneIndex];
+    LaneStats& stats = conn.bandwidth.lanes[laneIndex];
+    const qint64 now = TimeUtils::monotonicNs();
     
-    Connection& conn = m_connections[connectionId];
+    QueuedFrame item;
+    item.frame = data;
+    item.enqueuedNs = now;
+    item.updatedNs = now;
+    item.key = supersedeKey(message);
+    item.droppable = isDroppable(type);
     
-    if (conn.status != ConnectionStatus::Connected) {
-        Logger::instance().warning("NetworkManager",
-                                  "Cannot send - not connected: " + connectionId);
-        return;
+    if (!item.key.isEmpty()) {
+        auto it = lane.keyed.constFind(item.key);
+        if (it != lane.keyed.constEnd()) {
+            // Newer state takes the older frame's place in line
+            QueuedFrame& queued = lane.frames[it.value()];
+            queued.frame = item.frame;
+            queued.updatedNs = now;
+            ++stats.superseded;
+            return;
+        }
     }
     
-    QByteArray data = m_protocol.serialize(message);
+    if (laneIndex != static_cast<int>(SendLane::Critical) &&
+        lane.size() >= conn.config.maxQueuedPerLane) {
+        takeFront(lane);
+        ++stats.dropped;
+    }
     
-    if (conn.tcpSocket) {
+    lane.frames.append(item);
+    if (!item.key.isEmpty()) {
+        lane.keyed.insert(item.key, lane.frames.size() - 1);
+    }
+    stats.queued = lane.size();
+}
+
+void NetworkManager::pumpSendQueues(Connection& conn) {
+    // Nothing but the clear heartbeat until the session is keyed
+    if (conn.cipher.isEnabled() && !conn.cipher.isKeyed()) return;
+    
+    const qint64 now = TimeUtils::monotonicNs();
+    const qint64 staleNs = static_cast<qint64>(conn.config.staleAfterMs) * 1000000;
+    bool backpressured = false;
+    
+    for (int l = 0; l < static_cast<int>(SendLane::Count) && !backpressured; ++l) {
+        SendQueue& lane = conn.lanes[l];
+        LaneStats& stats = conn.bandwidth.lanes[l];
+        
+        while (!lane.isEmpty()) {
+            // Critical ignores the watermark; the rest wait for bytesWritten
+            if (l != static_cast<int>(SendLane::Critical) && conn.tcpSocket &&
+                conn.tcpSocket->bytesToWrite() > conn.config.sendHighWatermark) {
+                backpressured = true;
+                break;
+            }
+            
+            const QueuedFrame item = takeFront(lane);
+            if (item.droppable && now - item.updatedNs > staleNs) {
+                ++stats.dropped;
+                continue;
+            }
+            writeFrame(conn, item.frame);
+            ++stats.sent;
+            stats.queueLatency.record((now - item.enqueuedNs) / 1000);
+        }
+    }
+    flushSealed(conn);
+    
+    for (int l = 0; l < static_cast<int>(SendLane::Count); ++l) {
+        conn.bandwidth.lanes[l].queued = conn.lanes[l].size();
+    }
+}
+
+void NetworkManager::discardSendQueues(Connection& conn) {
+    for (int l = 0; l < static_cast<int>(SendLane::Count); ++l) {
+        conn.bandwidth.lanes[l].dropped += conn.lanes[l].size();
+        conn.bandwidth.lanes[l].queued = 0;
+        conn.lanes[l] = SendQueue();
+    }
+}
+
+NetworkManager::QueuedFrame NetworkManager::takeFront(SendQueue& queue) {
+    QueuedFrame item = queue.frames[queue.head];
+    if (!item.key.isEmpty()) {
+        queue.keyed.remove(item.key);
+    }
+    ++queue.head;
+    
+    if (queue.head == queue.frames.size()) {
+        queue.frames.clear();
+        queue.head = 0;
+    } else if (queue.head >= 64 && queue.head * 2 >= queue.frames.size()) {
+        // Compact once the consumed prefix dominates; keyed indices shift with it
+        queue.frames.remove(0, queue.head);
+        for (auto it = queue.keyed.begin(); it != queue.keyed.end(); ++it) {
+            it.value() -= queue.head;
+        }
+        queue.head = 0;
+    }
+    return item;
+}
+
+bool NetworkManager::startMulticastPublisher(const MulticastConfig& config) {
+    if (!m_multicastPublisher) {
+        m_multicastPublisher = new MulticastPublisher(this);
+    }
+    return m_multicastPublisher->start(config);
+}
+
+void NetworkManager::stopMulticastPublisher() {
+    if (m_multicastPublisher) {
+        m_multicastPublisher->stop();
+    }
+}
+
+bool NetworkManager::joinMulticast(const MulticastConfig& config) {
+    if (!m_multicastSubscriber) {
+        m_multicastSubscriber = new MulticastSubscriber(this);
+        connect(m_multicastSubscriber, &MulticastSubscriber::messageReceived,
+                this, [this](const Message& message) {
+            emit messageReceived(multicastConnectionId(), message);
+        });
+    }
+    return m_multicastSubscriber->join(config);
+}
+
+void NetworkManager::leaveMulticast() {
+    if (m_multicastSubscriber) {
+        m_multicastSubscriber->leave();
+    }
+}
+
+bool NetworkManager::startSharedMemoryPublisher(const SharedMemoryConfig& config) {
+    if (!m_sharedMemoryPublisher) {
+        m_sharedMemoryPublisher = new SharedMemoryPublisher(this);
+    }
+    return m_sharedMemoryPublisher->start(config);
+}
+
+void NetworkManager::stopSharedMemoryPublisher() {
+    if (m_sharedMemoryPublisher) {
+        m_sharedMemoryPublisher->stop();
+    }
+}
+
+void NetworkManager::writeFrame(Connection& conn, const QByteArray& data) {
+    if (conn.cipher.isKeyed()) {
+        // Sealed with the rest of the pass by flushSealed()
+        if (conn.sealBatch.size() + data.size() > LinkCipher::MAX_RECORD_BYTES) {
+            flushSealed(conn);
+        }
+        conn.sealBatch.append(data);
+    } else if (conn.tcpSocket) {
         conn.tcpSocket->write(data);
         conn.bandwidth.bytesSent += data.size();
     } else if (conn.udpSocket) {
@@ -143,55 +729,167 @@ void NetworkManager::send(const QString& connectionId, const Message& message) {
     }
 }
 
-void NetworkManager::broadcast(const Message& message) {
-    for (const QString& id : m_connections.keys()) {
-        if (isConnected(id)) {
-            send(id, message);
+void NetworkManager::flushSealed(Connection& conn) {
+    if (conn.sealBatch.isEmpty() || !conn.tcpSocket) return;
+    
+    const QByteArray record = conn.cipher.seal(conn.sealBatch, &conn.bandwidth.encryption);
+    conn.sealBatch.clear();
+    if (record.isEmpty()) {
+        // Record numbers are the nonces; a new session starts them over
+        Logger::instance().warning("NetworkManager",
+                                  "Link record counter exhausted, reconnecting: " + conn.config.name);
+        conn.tcpSocket->abort();
+        return;
+    }
+    conn.tcpSocket->write(record);
+    conn.bandwidth.bytesSent += record.size();
+}
+
+void NetworkManager::advertiseEncodings(const QString& id) {
+    auto it = m_connections.find(id);
+    if (it == m_connections.end()) return;
+    
+    // Always JSON so any peer can read it
+    writeFrame(it.value(), m_protocol.serialize(heartbeat(it.value()), WireEncoding::Json));
+}
+
+Message NetworkManager::heartbeat(Connection& conn) const {
+    int encodings = static_cast<int>(WireEncoding::Json);
+    if (conn.config.wireEncoding == WireEncoding::Binary) {
+        encodings |= static_cast<int>(WireEncoding::Binary);
+    }
+    
+    Message message = MessageProtocol::createHeartbeat(m_nodeId, encodings);
+    message.sequenceNumber = ++conn.heartbeatSequence;
+    message.payload["codecs"] = MessageProtocol::supportedCodecs();
+    if (conn.cipher.isEnabled()) {
+        message.payload["linkNonce"] = QString::fromLatin1(conn.cipher.localNonce().toBase64());
+    }
+    const QVector<quint32> dictionaries = m_protocol.dictionaryIds();
+    if (!dictionaries.isEmpty()) {
+        QVariantList ids;
+        for (quint32 id : dictionaries) {
+            ids.append(static_cast<qint64>(id));
         }
+        message.payload["dictionaries"] = ids;
+    }
+    for (int i = 0; i < PipelineLatency::STAGE_COUNT; ++i) {
+        const PipelineStage stage = static_cast<PipelineStage>(i);
+        const LatencyHistogramSnapshot latency = PipelineLatency::snapshot(stage);
+        if (latency.count == 0) continue;
+        const QString key = QString::fromLatin1(PipelineLatency::stageKey(stage));
+        message.payload[key + "P50Us"] = latency.percentileUs(0.50);
+        message.payload[key + "P99Us"] = latency.percentileUs(0.99);
+        message.payload[key + "MaxUs"] = latency.maxUs;
     }
+    return message;
 }
 
-NetworkManager::BandwidthStats NetworkManager::bandwidth(const QString& connectionId) const {
-    if (!m_connections.contains(connectionId)) {
-        return BandwidthStats();
+void NetworkManager::setHeartbeatIntervalMs(int intervalMs) {
+    m_heartbeatIntervalMs = qMax(0, intervalMs);
+    if (m_heartbeatIntervalMs > 0) {
+        m_heartbeatTimer.start(m_heartbeatIntervalMs);
+    } else {
+        m_heartbeatTimer.stop();
+    }
+}
+
+void NetworkManager::sendHeartbeats() {
+    // Queued, so a newer heartbeat replaces one still waiting behind a backlog
+    for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
+        Connection& conn = it.value();
+        if (conn.status != ConnectionStatus::Connected || conn.sharedMemory) continue;
+        if (conn.cipher.isEnabled() && !conn.cipher.isKeyed()) {
+            // The peer may have missed the first; there is no queue to wait in yet
+            advertiseEncodings(it.key());
+            continue;
+        }
+        const TypedMessage message = TypedMessage::fromMessage(heartbeat(conn));
+        enqueueFrame(conn, message, m_protocol.serialize(message, WireEncoding::Json));
+        pumpSendQueues(conn);
+    }
+}
+
+void NetworkManager::setSendEncoding(const QString& id, WireEncoding encoding) {
+    auto it = m_connections.find(id);
+    if (it == m_connections.end() || it->sendEncoding == encoding) return;
+    
+    it->sendEncoding = encoding;
+    Logger::instance().info("NetworkManager",
+                           QString("%1 wire encoding: %2").arg(it->config.name,
+                               encoding == WireEncoding::Binary ? "binary" : "json"));
+    {
+        QMutexLocker locker(&m_viewMutex);
+        auto view = m_views.find(id);
+        if (view != m_views.end()) view->sendEncoding = encoding;
     }
-    return m_connections[connectionId].bandwidth;
+    NetworkEvent event;
+    event.kind = NetworkEvent::Encoding;
+    event.connectionId = id;
+    event.encoding = encoding;
+    postEvent(std::move(event));
+}
+
+NetworkManager::BandwidthStats NetworkManager::bandwidth(const QString& connectionId) const {
+    QMutexLocker locker(&m_viewMutex);
+    auto it = m_views.constFind(connectionId);
+    return it != m_views.constEnd() ? it->bandwidth : BandwidthStats();
 }
 
 NetworkManager::BandwidthStats NetworkManager::totalBandwidth() const {
+    QMutexLocker locker(&m_viewMutex);
+    return m_totalView;
+}
+
+NetworkManager::BandwidthStats NetworkManager::collectBandwidth() const {
     BandwidthStats total;
+    total.receivedDropped = m_receivedDropped.load(std::memory_order_relaxed);
     for (const Connection& conn : m_connections) {
         total.bytesSent += conn.bandwidth.bytesSent;
         total.bytesReceived += conn.bandwidth.bytesReceived;
         total.sendRateBps += conn.bandwidth.sendRateBps;
         total.receiveRateBps += conn.bandwidth.receiveRateBps;
+        total.compression.add(conn.bandwidth.compression);
+        total.encryption.add(conn.bandwidth.encryption);
+        total.datagramsDropped += conn.bandwidth.datagramsDropped;
+        
+        for (int l = 0; l < static_cast<int>(SendLane::Count); ++l) {
+            const LaneStats& lane = conn.bandwidth.lanes[l];
+            LaneStats& sum = total.lanes[l];
+            sum.queued += lane.queued;
+            sum.sent += lane.sent;
+            sum.superseded += lane.superseded;
+            sum.dropped += lane.dropped;
+            
+            // Pooled latency: weighted mean, worst case across connections
+            const quint64 count = sum.queueLatency.count + lane.queueLatency.count;
+            if (count > 0) {
+                sum.queueLatency.meanUs = (sum.queueLatency.meanUs * sum.queueLatency.count +
+                                           lane.queueLatency.meanUs * lane.queueLatency.count) / count;
+            }
+            sum.queueLatency.count = count;
+            sum.queueLatency.maxUs = qMax(sum.queueLatency.maxUs, lane.queueLatency.maxUs);
+            sum.queueLatency.lastUs = qMax(sum.queueLatency.lastUs, lane.queueLatency.lastUs);
+        }
     }
     return total;
 }
 
-void NetworkManager::onTcpConnected() {
-    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket) return;
-    
-    QString connectionId = socket->property("connectionId").toString();
+void NetworkManager::onTcpConnected(const QString& connectionId) {
     setConnectionStatus(connectionId, ConnectionStatus::Connected);
-    
-    Logger::instance().info("NetworkManager",
-                           "Connected: " + m_connections[connectionId].config.name);
+    auto it = m_connections.find(connectionId);
+    if (it == m_connections.end()) return;
+    if (it->cipher.isEnabled()) {
+        it->cipher.startSession();
+    }
+    Logger::instance().info("NetworkManager", "Connected: " + it->config.name);
+    advertiseEncodings(connectionId);
 }
 
-void NetworkManager::onTcpDisconnected() {
-    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket) return;
-    
-    QString connectionId = socket->property("connectionId").toString();
-    
-    if (m_connections.contains(connectionId) &&
-        m_connections[connectionId].config.autoReconnect) {
+void NetworkManager::onTcpDisconnected(const QString& connectionId) {
+    auto it = m_connections.find(connectionId);
+    if (it != m_connections.end() && it->config.autoReconnect && it->link->isWanted()) {
         setConnectionStatus(connectionId, ConnectionStatus::Reconnecting);
-        if (!m_reconnectTimer->isActive()) {
-            m_reconnectTimer->start();
-        }
     } else {
         setConnectionStatus(connectionId, ConnectionStatus::Disconnected);
     }
@@ -199,64 +897,62 @@ void NetworkManager::onTcpDisconnected() {
     Logger::instance().info("NetworkManager", "Disconnected: " + connectionId);
 }
 
-void NetworkManager::onTcpReadyRead() {
-    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket) return;
-    
-    QString connectionId = socket->property("connectionId").toString();
-    QByteArray data = socket->readAll();
+void NetworkManager::onTcpReadyRead(const QString& connectionId) {
+    auto it = m_connections.find(connectionId);
+    if (it == m_connections.end() || !it->tcpSocket) return;
     
-    if (m_connections.contains(connectionId)) {
-        m_connections[connectionId].bandwidth.bytesReceived += data.size();
+    // Read straight into the frame ring, no intermediate buffer
+    Connection& conn = it.value();
+    QTcpSocket* socket = conn.tcpSocket;
+    while (socket->bytesAvailable() > 0) {
+        int available = 0;
+        char* region = conn.reader.writeRegion(available);
+        const qint64 bytesRead = socket->read(region, available);
+        if (bytesRead <= 0) break;
+        if (m_capture) m_capture->record(conn.captureChannel, region, static_cast<int>(bytesRead));
+        conn.reader.commit(static_cast<int>(bytesRead));
+        conn.bandwidth.bytesReceived += bytesRead;
     }
     
-    processReceivedData(connectionId, data);
+    processFrames(connectionId);
 }
 
-void NetworkManager::onTcpError(QAbstractSocket::SocketError error) {
-    Q_UNUSED(error)
-    
-    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
-    if (!socket) return;
-    
-    QString connectionId = socket->property("connectionId").toString();
-    setConnectionStatus(connectionId, ConnectionStatus::Error);
-    
-    emit connectionError(connectionId, socket->errorString());
+void NetworkManager::onTcpBytesWritten(const QString& connectionId) {
+    auto it = m_connections.find(connectionId);
+    if (it != m_connections.end() && it->status == ConnectionStatus::Connected) {
+        pumpSendQueues(it.value());
+    }
 }
 
-void NetworkManager::onUdpReadyRead() {
-    QUdpSocket* socket = qobject_cast<QUdpSocket*>(sender());
-    if (!socket) return;
+void NetworkManager::onTcpError(const QString& connectionId) {
+    auto it = m_connections.find(connectionId);
+    if (it == m_connections.end() || !it->tcpSocket) return;
+    const QString error = it->tcpSocket->errorString();
     
-    QString connectionId = socket->property("connectionId").toString();
+    setConnectionStatus(connectionId, ConnectionStatus::Error);
     
-    while (socket->hasPendingDatagrams()) {
-        QByteArray data;
-        data.resize(socket->pendingDatagramSize());
-        socket->readDatagram(data.data(), data.size());
-        
-        if (m_connections.contains(connectionId)) {
-            m_connections[connectionId].bandwidth.bytesReceived += data.size();
-        }
-        
-        processReceivedData(connectionId, data);
-    }
+    NetworkEvent event;
+    event.kind = NetworkEvent::Error;
+    event.connectionId = connectionId;
+    event.error = error;
+    postEvent(std::move(event));
 }
 
-void NetworkManager::attemptReconnect() {
-    bool anyReconnecting = false;
+void NetworkManager::onUdpBatch(const QString& id, const DatagramBatchPtr& batch) {
+    auto it = m_connections.find(id);
+    if (it == m_connections.end()) return;
     
-    for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
-        if (it.value().status == ConnectionStatus::Reconnecting) {
-            anyReconnecting = true;
-            connectTo(it.key());
-        }
+    if (batch->kernelDrops() > it->kernelDrops) {
+        it->bandwidth.datagramsDropped += static_cast<qint64>(batch->kernelDrops() - it->kernelDrops);
+        it->kernelDrops = batch->kernelDrops();
     }
-    
-    if (!anyReconnecting) {
-        m_reconnectTimer->stop();
+    for (int i = 0; i < batch->count(); ++i) {
+        it->bandwidth.bytesReceived += batch->size(i);
+        if (m_capture) m_capture->record(it->captureChannel, batch->data(i), batch->size(i), batch->receivedNs());
+        it->reader.append(batch->data(i), batch->size(i));
     }
+    // The whole batch's frames in one pass
+    processFrames(id);
 }
 
 void NetworkManager::updateBandwidth() {
@@ -279,7 +975,37 @@ void NetworkManager::updateBandwidth() {
         conn.bytesAtLastCheck = conn.bandwidth.bytesSent + conn.bandwidth.bytesReceived;
     }
     
-    emit bandwidthUpdated(totalBandwidth());
+    const BandwidthStats total = collectBandwidth();
+    exportMetrics(total);
+    {
+        QMutexLocker locker(&m_viewMutex);
+        for (auto it = m_connections.constBegin(); it != m_connections.constEnd(); ++it) {
+            auto view = m_views.find(it.key());
+            if (view != m_views.end()) view->bandwidth = it->bandwidth;
+        }
+        m_totalView = total;
+    }
+    NetworkEvent event;
+    event.kind = NetworkEvent::Bandwidth;
+    postEvent(std::move(event));
+}
+
+void NetworkManager::exportMetrics(const BandwidthStats& total) {
+    int connected = 0;
+    for (const Connection& conn : m_connections) {
+        if (conn.status == ConnectionStatus::Connected) connected++;
+    }
+    m_connectedMetric->set(connected);
+    // Totals cover current connections; removing one reads as a counter reset
+    m_bytesSentMetric->setTotal(total.bytesSent);
+    m_bytesReceivedMetric->setTotal(total.bytesReceived);
+    m_rateMetric->set(total.sendRateBps + total.receiveRateBps);
+    m_udpDroppedMetric->setTotal(total.datagramsDropped);
+    for (int l = 0; l < static_cast<int>(SendLane::Count); ++l) {
+        m_laneMetrics[l].queued->set(total.lanes[l].queued);
+        m_laneMetrics[l].sent->setTotal(total.lanes[l].sent);
+        m_laneMetrics[l].dropped->setTotal(total.lanes[l].dropped);
+    }
 }
 
 void NetworkManager::setConnectionStatus(const QString& id, ConnectionStatus status) {
@@ -287,28 +1013,137 @@ void NetworkManager::setConnectionStatus(const QString& id, ConnectionStatus sta
     
     if (m_connections[id].status != status) {
         m_connections[id].status = status;
-        emit connectionStatusChanged(id, status);
+        if (status != ConnectionStatus::Connected) {
+            // Renegotiate on the next link; the peer may have changed
+            m_connections[id].sendEncoding = WireEncoding::Json;
+            m_connections[id].peerCodecs = 0;
+            m_connections[id].peerDictionaries.clear();
+            m_connections[id].cipher.endSession();
+            m_connections[id].sealBatch.clear();
+            m_connections[id].reader.clear();
+            discardSendQueues(m_connections[id]);
+        }
+        {
+            QMutexLocker locker(&m_viewMutex);
+            auto view = m_views.find(id);
+            if (view != m_views.end()) {
+                view->status = status;
+                view->sendEncoding = m_connections[id].sendEncoding;
+            }
+        }
+        NetworkEvent event;
+        event.kind = NetworkEvent::Status;
+        event.connectionId = id;
+        event.status = status;
+        postEvent(std::move(event));
     }
 }
 
-void NetworkManager::processReceivedData(const QString& id, const QByteArray& data) {
-    if (!m_connections.contains(id)) return;
-    
-    Connection& conn = m_connections[id];
-    conn.buffer.append(data);
+void NetworkManager::processFrames(const QString& id) {
+    // Handlers run on the owner's thread; only this thread adds or removes connections
+    auto it = m_connections.find(id);
+    if (it == m_connections.end()) return;
+    Connection& conn = it.value();
     
-    // Try to parse complete messages
     while (true) {
-        Message msg;
-        int bytesConsumed = m_protocol.deserialize(conn.buffer, msg);
-        
-        if (bytesConsumed > 0) {
-            conn.buffer.remove(0, bytesConsumed);
-            emit messageReceived(id, msg);
-        } else {
+        FrameHeader header;
+        const char* payload = nullptr;
+        if (!conn.reader.next(header, payload)) {
+            if (conn.reader.discardedBytes() > conn.discardedReported) {
+                Logger::instance().warning("NetworkManager",
+                    QString("%1: skipped %2 bytes of unframed data")
+                        .arg(conn.config.name)
+                        .arg(conn.reader.discardedBytes() - conn.discardedReported));
+                conn.discardedReported = conn.reader.discardedBytes();
+            }
             break;
         }
+        
+        if (!header.sealed) {
+            // Only the handshake heartbeat travels in the clear on an encrypted link
+            if (conn.cipher.isEnabled() &&
+                (conn.cipher.isKeyed() || header.type != MessageType::Heartbeat)) {
+                conn.bandwidth.encryption.unsealedDropped++;
+                continue;
+            }
+            deliverFrame(conn, id, header, payload);
+            continue;
+        }
+        
+        QByteArray plain;
+        if (!conn.cipher.open(header, payload, plain, &conn.bandwidth.encryption)) {
+            // Out of step from here on; a new session resynchronizes
+            Logger::instance().warning("NetworkManager",
+                QString("%1: rejected link record %2, reconnecting")
+                    .arg(conn.config.name).arg(header.sequenceNumber));
+            conn.reader.clear();
+            if (conn.tcpSocket) {
+                conn.tcpSocket->abort();
+            }
+            return;
+        }
+        
+        int offset = 0;
+        while (offset < plain.size()) {
+            FrameHeader inner;
+            if (MessageProtocol::parseHeader(plain.constData() + offset, plain.size() - offset, inner) <= 0 ||
+                inner.sealed || plain.size() - offset - MessageProtocol::HEADER_SIZE < inner.payloadSize) {
+                Logger::instance().warning("NetworkManager",
+                    QString("%1: dropped malformed link record %2")
+                        .arg(conn.config.name).arg(header.sequenceNumber));
+                break;
+            }
+            deliverFrame(conn, id, inner, plain.constData() + offset + MessageProtocol::HEADER_SIZE);
+            offset += MessageProtocol::HEADER_SIZE + inner.payloadSize;
+        }
+    }
+}
+
+void NetworkManager::deliverFrame(Connection& conn, const QString& id, const FrameHeader& header,
+                                  const char* payload) {
+    // The payload is a view into the ring; decoding is the only copy
+    Message msg;
+    if (!m_protocol.decodePayload(header, payload, msg, &conn.bandwidth.compression)) {
+        Logger::instance().warning("NetworkManager",
+            QString("%1: dropped malformed frame type 0x%2")
+                .arg(conn.config.name)
+                .arg(static_cast<quint16>(header.type), 4, 16, QChar('0')));
+        return;
+    }
+    
+    // Codecs the peer decodes, before anything more is sent
+    if (msg.type == MessageType::Heartbeat && msg.payload.contains("codecs")) {
+        conn.peerCodecs = msg.payload.value("codecs").toInt();
+        conn.peerDictionaries.clear();
+        for (const QVariant& dictionaryId : msg.payload.value("dictionaries").toList()) {
+            conn.peerDictionaries.append(static_cast<quint32>(dictionaryId.toLongLong()));
+        }
+    }
+    
+    // A binary frame, or a heartbeat advertising binary, means the peer reads it too
+    bool peerBinary = header.encoding == WireEncoding::Binary;
+    if (msg.type == MessageType::Heartbeat && msg.payload.contains("encodings")) {
+        peerBinary = msg.payload.value("encodings").toInt() &
+                     static_cast<int>(WireEncoding::Binary);
+    }
+    if (conn.config.wireEncoding == WireEncoding::Binary &&
+        (peerBinary || msg.type == MessageType::Heartbeat)) {
+        setSendEncoding(id, peerBinary ? WireEncoding::Binary : WireEncoding::Json);
     }
+    
+    // The peer's session nonce keys the link; what queued meanwhile goes out sealed
+    if (msg.type == MessageType::Heartbeat && conn.cipher.isEnabled() && !conn.cipher.isKeyed()) {
+        const QByteArray nonce = QByteArray::fromBase64(msg.payload.value("linkNonce").toString().toLatin1());
+        if (conn.cipher.acceptPeerNonce(nonce)) {
+            Logger::instance().info("NetworkManager", "Link encrypted: " + conn.config.name);
+            pumpSendQueues(conn);
+        }
+    }
+    
+    NetworkEvent event;
+    event.connectionId = id;
+    event.message = std::move(msg);
+    postEvent(std::move(event));
 }
 
 } // namespace CounterUAS
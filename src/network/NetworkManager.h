@@ -3,13 +3,31 @@
 
 #include <QObject>
 #include <QHash>
+#include <QMutex>
 #include <QTcpSocket>
 #include <QUdpSocket>
-#include <QTimer>
+#include <atomic>
+#include <memory>
+#include "network/FrameReader.h"
+#include "network/LinkCipher.h"
 #include "network/MessageProtocol.h"
+#include "network/MulticastPublisher.h"
+#include "network/SharedMemoryPublisher.h"
+#include "utils/BoundedQueue.h"
+#include "utils/ConnectionPool.h"
+#include "utils/DatagramReceiver.h"
+#include "utils/LatencyStats.h"
+#include "utils/SpscRing.h"
+#include "utils/TimerService.h"
+
+class QThread;
 
 namespace CounterUAS {
 
+class MetricCounter;
+class MetricGauge;
+class RawCaptureRecorder;
+
 /**
  * @brief Connection status
  */
@@ -21,6 +39,16 @@ enum class ConnectionStatus {
     Error
 };
 
+/**
+ * @brief Send priority class; lower lanes always drain first
+ */
+enum class SendLane {
+    Critical = 0,   // Engagement control, alerts, effector commands
+    Normal,         // Track picture, detections, status
+    Bulk,           // Logs, config, video
+    Count
+};
+
 /**
  * @brief Connection definition
  */
@@ -31,15 +59,48 @@ struct ConnectionConfig {
     int port;
     bool useTcp = true;
     bool autoReconnect = true;
-    int reconnectIntervalMs = 5000;
-    int timeoutMs = 3000;
+    int reconnectIntervalMs = 5000;   // Ceiling of the reconnect backoff
+    int timeoutMs = 3000;             // Per-attempt connect timeout
     QString username;
     QString password;
+    WireEncoding wireEncoding = WireEncoding::Binary;  // Preferred; Json keeps frames readable
+    bool multicastMember = false;  // Peer gets broadcasts from the multicast group instead
+    int sendHighWatermark = 256 * 1024;  // Socket backlog above which only Critical is written
+    int staleAfterMs = 1000;             // Droppable frames older than this are not sent
+    int maxQueuedPerLane = 4096;
+    // Frames sent and broadcast are compressed once the peer advertises the
+    // codec; a dictionary the peer lacks falls back to plain zstd. Lz4 suits
+    // LAN links where latency counts, zstd with a trained dictionary the
+    // thin satellite ones.
+    CompressionOptions compression;
+    // Non-empty: receive from the SharedMemoryPublisher of that key on this
+    // host instead of a socket. Such a connection only receives.
+    QString sharedMemoryKey;
+    // TCP only: every frame after the heartbeat handshake travels in
+    // LinkCipher records keyed from username and password, which the peer
+    // must share. Clear frames from the peer are then dropped.
+    bool encrypt = false;
 };
 
 /**
  * @brief Network manager for all communications
+ *
+ * The connections' sockets live on an I/O thread of the manager's own,
+ * which reads, frames and decodes on arrival and serializes, compresses
+ * and writes what is sent, so a busy GUI thread never holds up a link.
+ * The public interface belongs to the thread that created the manager,
+ * and so do its signals: the I/O thread hands decoded messages and status
+ * changes back through a lock-free ring, in the order they happened, and
+ * send() and broadcast() reach it through a lock-free queue any thread may
+ * push to. Status, encoding and bandwidth queries read a copy the I/O
+ * thread keeps current.
+ *
+ * The multicast publisher and subscriber and the shared-memory publisher
+ * stay on the owner's thread, as they were.
  */
+class MulticastSubscriber;
+class SharedMemorySubscriber;
+
 class NetworkManager : public QObject {
     Q_OBJECT
     
@@ -58,55 +119,237 @@ public:
     ConnectionStatus connectionStatus(const QString& connectionId) const;
     QList<QString> connectionIds() const;
     bool isConnected(const QString& connectionId) const;
+    WireEncoding sendEncoding(const QString& connectionId) const;
+    
+    // Source id on the heartbeat sent when a link comes up and every
+    // heartbeat interval after; it carries the encodings, codecs and
+    // dictionaries this end reads, and PipelineLatency
+    void setNodeId(const QString& nodeId);
+    static constexpr int HEARTBEAT_INTERVAL_MS = 1000;
+    void setHeartbeatIntervalMs(int intervalMs);  // 0 sends only on link up
+    int heartbeatIntervalMs() const { return m_heartbeatIntervalMs; }
     
-    // Send
+    // Send. A TypedMessage is queued as it is and serialized from its
+    // fields on the I/O thread; a Message goes as a DynamicBody.
     void send(const QString& connectionId, const Message& message);
+    void send(const QString& connectionId, const TypedMessage& message);
+    // Once to the multicast group when publishing, then to each connection
+    // that is not a multicast member
     void broadcast(const Message& message);
+    void broadcast(const TypedMessage& message);
+    
+    // Zstd dictionary for ConnectionConfig::compression, advertised to peers
+    // on the heartbeat; returns its id, or 0 without zstd
+    quint32 addCompressionDictionary(const QByteArray& dictionary);
+    
+    // Frames are queued per connection in the message type's lane
+    static SendLane laneFor(MessageType type);
+    
+    // Tees the bytes every connection reads into the recorder, on channel
+    // "network:<connectionId>"; null stops it
+    void setCapture(const std::shared_ptr<RawCaptureRecorder>& recorder);
+    // Captured bytes of a connection's, framed and delivered as if read.
+    // Taken only while it is not connected, so they cannot land mid-frame
+    // of a live stream; an encrypted link's need the key it was read with
+    void replayRaw(const QString& connectionId, const QByteArray& data);
+    
+    // Multicast distribution
+    bool startMulticastPublisher(const MulticastConfig& config);
+    void stopMulticastPublisher();
+    MulticastPublisher* multicastPublisher() const { return m_multicastPublisher; }
+    
+    // Received messages arrive on messageReceived under multicastConnectionId()
+    bool joinMulticast(const MulticastConfig& config);
+    void leaveMulticast();
+    static QString multicastConnectionId() { return QStringLiteral("multicast"); }
+    
+    // Same-host distribution: broadcasts go into the segment as binary
+    // frames, and the publisher is there to attach a TrackManager and video
+    bool startSharedMemoryPublisher(const SharedMemoryConfig& config);
+    void stopSharedMemoryPublisher();
+    SharedMemoryPublisher* sharedMemoryPublisher() const { return m_sharedMemoryPublisher; }
     
     // Bandwidth monitoring
+    struct LaneStats {
+        int queued = 0;
+        qint64 sent = 0;
+        qint64 superseded = 0;  // Replaced in the queue by a newer frame for the same key
+        qint64 dropped = 0;     // Stale, over the queue limit, or discarded on disconnect
+        LatencyStats queueLatency;
+    };
     struct BandwidthStats {
         qint64 bytesSent = 0;
         qint64 bytesReceived = 0;
         double sendRateBps = 0.0;
         double receiveRateBps = 0.0;
+        LaneStats lanes[static_cast<int>(SendLane::Count)];
+        CompressionStats compression;   // Frames this end compressed and decompressed
+        EncryptionStats encryption;     // Records this end sealed and opened
+        qint64 datagramsDropped = 0;    // UDP datagrams the kernel dropped on the receive socket
+        qint64 receivedDropped = 0;     // Decoded messages the owner's thread fell too far behind for
     };
+    // As of the last bandwidthUpdated(), once a second
     BandwidthStats bandwidth(const QString& connectionId) const;
     BandwidthStats totalBandwidth() const;
     
+    static constexpr int EVENT_QUEUE_CAPACITY = 16384;   // I/O thread to owner
+    static constexpr int SEND_QUEUE_CAPACITY = 16384;    // Senders to the I/O thread
+    
 signals:
     void connectionStatusChanged(const QString& connectionId, ConnectionStatus status);
     void messageReceived(const QString& connectionId, const Message& message);
     void connectionError(const QString& connectionId, const QString& error);
+    void wireEncodingChanged(const QString& connectionId, WireEncoding encoding);
     void bandwidthUpdated(const BandwidthStats& stats);
     
-private slots:
-    void onTcpConnected();
-    void onTcpDisconnected();
-    void onTcpReadyRead();
-    void onTcpError(QAbstractSocket::SocketError error);
-    void onUdpReadyRead();
-    void attemptReconnect();
-    void updateBandwidth();
-    
 private:
+    // What the I/O thread hands the owner's thread, in order
+    struct NetworkEvent {
+        enum Kind { Received, Status, Error, Encoding, Bandwidth };
+        Kind kind = Received;
+        QString connectionId;
+        Message message;
+        ConnectionStatus status = ConnectionStatus::Disconnected;
+        WireEncoding encoding = WireEncoding::Json;
+        QString error;
+    };
+    
+    // A send() or broadcast() on its way to the I/O thread
+    struct OutboundMessage {
+        QString connectionId;          // Empty for a broadcast
+        TypedMessage message;
+        bool skipMulticastMembers = false;
+    };
+    
+    // The owner's copy of a connection's state
+    struct ConnectionView {
+        ConnectionStatus status = ConnectionStatus::Disconnected;
+        WireEncoding sendEncoding = WireEncoding::Json;
+        BandwidthStats bandwidth;
+    };
+    
+    struct QueuedFrame {
+        QByteArray frame;
+        qint64 enqueuedNs = 0;   // Queue latency counts from here
+        qint64 updatedNs = 0;    // Staleness counts from the last supersede
+        QString key;
+        bool droppable = false;
+    };
+    
+    // FIFO with in-place replacement of keyed frames
+    struct SendQueue {
+        QVector<QueuedFrame> frames;
+        int head = 0;
+        QHash<QString, int> keyed;   // Supersede key -> index in frames
+        
+        int size() const { return frames.size() - head; }
+        bool isEmpty() const { return head == frames.size(); }
+    };
+    
     struct Connection {
         ConnectionConfig config;
         QTcpSocket* tcpSocket = nullptr;
-        QUdpSocket* udpSocket = nullptr;
+        ManagedConnection* link = nullptr;   // Drives tcpSocket's connects and retries
+        QUdpSocket* udpSocket = nullptr;         // Sends only
+        DatagramReceiver* udpReceiver = nullptr; // Receives, batched off this thread
+        quint64 kernelDrops = 0;                 // Last DatagramBatch::kernelDrops()
+        int captureChannel = -1;
+        SharedMemorySubscriber* sharedMemory = nullptr;
         ConnectionStatus status = ConnectionStatus::Disconnected;
-        QByteArray buffer;
+        FrameReader reader;
+        qint64 discardedReported = 0;
+        WireEncoding sendEncoding = WireEncoding::Json;  // Until the peer advertises binary
+        int peerCodecs = 0;                  // From the peer's heartbeat; none until then
+        QVector<quint32> peerDictionaries;
+        quint32 heartbeatSequence = 0;       // This end's heartbeats on this link
+        LinkCipher cipher;
+        QByteArray sealBatch;                // Frames of this send pass, sealed together
+        SendQueue lanes[static_cast<int>(SendLane::Count)];
         BandwidthStats bandwidth;
         qint64 lastBandwidthCheck = 0;
         qint64 bytesAtLastCheck = 0;
     };
     
+    // Owner's thread
+    void pushOutbound(OutboundMessage item);
+    void deliverEvents();
+    void emitEvent(const NetworkEvent& event);
+    
+    // I/O thread
+    void postEvent(NetworkEvent event);
+    void drainOutbound();
+    void openConnection(const ConnectionConfig& config);
+    void openCaptureChannel(Connection& conn);
+    void closeConnection(const QString& connectionId);
+    void openLink(const QString& connectionId);
+    void closeLink(const QString& connectionId);
+    void sendNow(const QString& connectionId, const TypedMessage& message);
+    void broadcastNow(const TypedMessage& message, bool skipMulticastMembers);
+    void onTcpConnected(const QString& id);
+    void onTcpDisconnected(const QString& id);
+    void onTcpReadyRead(const QString& id);
+    void onTcpBytesWritten(const QString& id);
+    void onTcpError(const QString& id);
+    void updateBandwidth();
+    void sendHeartbeats();
     void setConnectionStatus(const QString& id, ConnectionStatus status);
-    void processReceivedData(const QString& id, const QByteArray& data);
+    void onUdpBatch(const QString& id, const DatagramBatchPtr& batch);
+    void processFrames(const QString& id);
+    void deliverFrame(Connection& conn, const QString& id, const FrameHeader& header, const char* payload);
+    void writeFrame(Connection& conn, const QByteArray& data);
+    void flushSealed(Connection& conn);
+    void enqueueFrame(Connection& conn, const TypedMessage& message, const QByteArray& data);
+    void pumpSendQueues(Connection& conn);
+    void discardSendQueues(Connection& conn);
+    static QueuedFrame takeFront(SendQueue& queue);
+    void advertiseEncodings(const QString& id);
+    Message heartbeat(Connection& conn) const;
+    BandwidthStats collectBandwidth() const;
+    void exportMetrics(const BandwidthStats& total);
+    void setSendEncoding(const QString& id, WireEncoding encoding);
+    CompressionOptions sendCompression(const Connection& conn) const;
     
+    QThread* m_ioThread;
+    QObject* m_ioContext;                    // Lives on m_ioThread; sockets and timers are its
+    
+    // I/O thread only
     QHash<QString, Connection> m_connections;
-    QTimer* m_reconnectTimer;
-    QTimer* m_bandwidthTimer;
     MessageProtocol m_protocol;
+    std::shared_ptr<RawCaptureRecorder> m_capture;
+    QString m_nodeId = QStringLiteral("C2");
+    
+    ServiceTimer m_bandwidthTimer;
+    ServiceTimer m_heartbeatTimer;
+    int m_heartbeatIntervalMs = HEARTBEAT_INTERVAL_MS;
+    
+    SpscRing<NetworkEvent> m_events;
+    std::atomic<bool> m_deliverScheduled{false};
+    std::atomic<qint64> m_receivedDropped{0};
+    BoundedQueue<OutboundMessage> m_outbound;
+    std::atomic<bool> m_drainScheduled{false};
+    
+    mutable QMutex m_viewMutex;
+    QHash<QString, ConnectionView> m_views;
+    BandwidthStats m_totalView;
+    
+    // Owner's thread; serializes for the multicast and shared-memory publishers
+    MessageProtocol m_publishProtocol;
+    MulticastPublisher* m_multicastPublisher = nullptr;
+    MulticastSubscriber* m_multicastSubscriber = nullptr;
+    SharedMemoryPublisher* m_sharedMemoryPublisher = nullptr;
+    
+    // Fleet monitoring series, refreshed with the bandwidth every second
+    struct LaneMetrics {
+        MetricGauge* queued = nullptr;
+        MetricCounter* sent = nullptr;
+        MetricCounter* dropped = nullptr;
+    };
+    MetricGauge* m_connectedMetric = nullptr;
+    MetricCounter* m_bytesSentMetric = nullptr;
+    MetricCounter* m_bytesReceivedMetric = nullptr;
+    MetricGauge* m_rateMetric = nullptr;
+    MetricCounter* m_udpDroppedMetric = nullptr;
+    LaneMetrics m_laneMetrics[static_cast<int>(SendLane::Count)];
 };
 
 } // namespace CounterUAS
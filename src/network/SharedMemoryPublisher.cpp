@@ -0,0 +1,265 @@
+#include "network/SharedMemoryPublisher.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include <QRandomGenerator>
+#include <cstring>
+#include <limits>
+#include <new>
+
+namespace CounterUAS {
+
+using namespace SharedMemoryWire;
+
+namespace {
+
+void beginWrite(std::atomic<quint64>& seqlock) {
+    seqlock.store(seqlock.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void endWrite(std::atomic<quint64>& seqlock) {
+    seqlock.store(seqlock.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void copyId(char* out, int capacity, const QString& id) {
+    const QByteArray utf8 = id.toUtf8();
+    std::memcpy(out, utf8.constData(), qMin(int(utf8.size()), capacity - 1));
+}
+
+int videoFrameBytes(const VideoFrame& frame) {
+    int bytes = 0;
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        bytes += frame.planeSize(plane).height() * frame.bytesPerLine(plane);
+    }
+    return bytes;
+}
+
+} // namespace
+
+SharedMemoryPublisher::SharedMemoryPublisher(QObject* parent)
+    : QObject(parent)
+{
+}
+
+SharedMemoryPublisher::~SharedMemoryPublisher() {
+    stop();
+}
+
+bool SharedMemoryPublisher::start(const SharedMemoryConfig& config) {
+    stop();
+    m_config = config;
+    m_config.ringBytes = qMax(64 * 1024, config.ringBytes) & ~7;
+    m_config.trackCapacity = qMax(1, config.trackCapacity);
+    m_config.videoSlots = qMax(0, config.videoSlots);
+    m_config.maxVideoFrameBytes = qMax(0, config.maxVideoFrameBytes);
+
+    const quint64 ringOffset = HEADER_BYTES;
+    const quint64 pictureOffset = align64(ringOffset + quint64(m_config.ringBytes));
+    const quint64 videoOffset = align64(pictureOffset + sizeof(PictureHeader) +
+                                        quint64(m_config.trackCapacity) * sizeof(TrackRecord));
+    const quint64 slotBytes = align64(VIDEO_SLOT_HEADER_BYTES + quint64(m_config.maxVideoFrameBytes));
+    const quint64 totalBytes = videoOffset + quint64(m_config.videoSlots) * slotBytes;
+    if (totalBytes > quint64(std::numeric_limits<int>::max())) {
+        m_error = QStringLiteral("Segment too large");
+        return false;
+    }
+
+    m_memory.setKey(m_config.key);
+    if (!m_memory.create(static_cast<int>(totalBytes))) {
+        if (m_memory.error() == QSharedMemory::AlreadyExists && m_memory.attach()) {
+            // Left by a publisher that crashed: the last detach removes it.
+            // If another publisher is live this detach leaves it be, and
+            // the create below fails again.
+            m_memory.detach();
+        }
+        if (!m_memory.create(static_cast<int>(totalBytes))) {
+            m_error = m_memory.errorString();
+            Logger::instance().error("SharedMemoryPublisher",
+                                    "Failed to create " + m_config.key + ": " + m_error);
+            return false;
+        }
+    }
+
+    // Only the headers need clearing; readers ignore what they do not cover
+    char* base = static_cast<char*>(m_memory.data());
+    std::memset(base, 0, HEADER_BYTES);
+    new (base + pictureOffset) PictureHeader();
+    for (int slot = 0; slot < m_config.videoSlots; ++slot) {
+        new (base + videoOffset + slot * slotBytes) VideoSlot();
+    }
+
+    m_header = new (base) SegmentHeader();
+    m_header->magic = MAGIC;
+    m_header->version = VERSION;
+    m_header->session = QRandomGenerator::global()->generate64();
+    m_header->totalBytes = totalBytes;
+    m_header->ringOffset = ringOffset;
+    m_header->ringBytes = quint64(m_config.ringBytes);
+    m_header->pictureOffset = pictureOffset;
+    m_header->trackCapacity = quint32(m_config.trackCapacity);
+    m_header->trackRecordBytes = sizeof(TrackRecord);
+    m_header->videoOffset = videoOffset;
+    m_header->videoSlots = quint32(m_config.videoSlots);
+    m_header->videoSlotBytes = quint32(slotBytes);
+    m_header->ringReserve.store(0, std::memory_order_relaxed);
+    m_header->ringWritten.store(0, std::memory_order_relaxed);
+    m_header->videoFrames.store(0, std::memory_order_relaxed);
+    m_header->state.store(STATE_LIVE, std::memory_order_release);
+
+    m_error.clear();
+    Logger::instance().info("SharedMemoryPublisher",
+        QString("Publishing to shared memory %1 (%2 MiB)").arg(m_config.key).arg(totalBytes >> 20));
+
+    if (m_trackManager) {
+        publishPicture(m_trackManager->snapshot());
+    }
+    return true;
+}
+
+void SharedMemoryPublisher::stop() {
+    if (!m_header) return;
+    // Attached readers let go and wait for the next segment
+    m_header->state.store(STATE_CLOSED, std::memory_order_release);
+    m_header = nullptr;
+    m_memory.detach();
+}
+
+void SharedMemoryPublisher::setTrackManager(TrackManager* trackManager) {
+    if (m_trackManager) {
+        QObject::disconnect(m_trackManager, nullptr, this, nullptr);
+    }
+    m_trackManager = trackManager;
+
+    if (m_trackManager) {
+        connect(m_trackManager, &TrackManager::snapshotPublished, this, [this]() {
+            if (m_trackManager) publishPicture(m_trackManager->snapshot());
+        });
+        publishPicture(m_trackManager->snapshot());
+    }
+}
+
+void SharedMemoryPublisher::publish(const QByteArray& frame) {
+    if (!m_header || frame.isEmpty()) return;
+
+    const quint64 ringBytes = m_header->ringBytes;
+    const quint64 frameBytes = quint64(frame.size());
+    if (frameBytes > ringBytes / 2 - RECORD_HEADER_BYTES) {
+        ++m_stats.framesOversize;
+        return;
+    }
+
+    const quint64 recordBytes = RECORD_HEADER_BYTES + ((frameBytes + 7) & ~quint64(7));
+    const quint64 position = m_header->ringWritten.load(std::memory_order_relaxed);
+    const quint64 offset = position % ringBytes;
+    // Records never straddle the ring end; both are multiples of 8
+    const quint64 skip = ringBytes - offset < recordBytes ? ringBytes - offset : 0;
+    const quint64 end = position + skip + recordBytes;
+
+    m_header->ringReserve.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char* ring = segment() + m_header->ringOffset;
+    if (skip > 0) {
+        std::memcpy(ring + offset, &WRAP_MARKER, sizeof(quint32));
+    }
+    char* record = ring + (offset + skip) % ringBytes;
+    const quint32 lengthWord[2] = {quint32(frameBytes), 0};
+    std::memcpy(record, lengthWord, sizeof(lengthWord));
+    std::memcpy(record + RECORD_HEADER_BYTES, frame.constData(), frameBytes);
+
+    m_header->ringWritten.store(end, std::memory_order_release);
+    ++m_stats.framesPublished;
+    m_stats.bytesPublished += frame.size();
+}
+
+void SharedMemoryPublisher::publishPicture(const TrackPicturePtr& picture) {
+    if (!m_header || !picture) return;
+
+    auto* header = reinterpret_cast<PictureHeader*>(segment() + m_header->pictureOffset);
+    auto* records = reinterpret_cast<TrackRecord*>(header + 1);
+    const int count = qMin(int(picture->tracks.size()), int(m_header->trackCapacity));
+
+    beginWrite(header->seqlock);
+    header->sequence = picture->sequence;
+    header->timestampMs = picture->timestampMs;
+    header->newestIngestNs = picture->newestIngestNs;
+    header->newestReceiveLagUs = picture->newestReceiveLagUs;
+    header->count = quint32(count);
+    header->omitted = quint32(picture->tracks.size() - count);
+    for (int i = 0; i < count; ++i) {
+        const TrackSnapshot& track = picture->tracks[i];
+        TrackRecord& record = records[i];
+        std::memset(&record, 0, sizeof(record));
+        copyId(record.trackId, ID_BYTES, track.trackId);
+        copyId(record.cameraId, ID_BYTES, track.associatedCameraId);
+        record.handle = track.handle;
+        record.classification = static_cast<qint32>(track.classification);
+        record.state = static_cast<qint32>(track.state);
+        record.threatLevel = track.threatLevel;
+        record.latitude = track.position.latitude;
+        record.longitude = track.position.longitude;
+        record.altitude = track.position.altitude;
+        record.velocityNorth = track.velocity.north;
+        record.velocityEast = track.velocity.east;
+        record.velocityDown = track.velocity.down;
+        record.covariance[0] = track.covariance.ee;
+        record.covariance[1] = track.covariance.en;
+        record.covariance[2] = track.covariance.nn;
+        record.covariance[3] = track.covariance.uu;
+        record.classificationConfidence = track.classificationConfidence;
+        record.trackQuality = track.trackQuality;
+        record.lastUpdateMs = track.lastUpdateMs;
+        record.ingestMonoNs = track.ingestMonoNs;
+        record.receiveLagUs = track.receiveLagUs;
+        record.flags = (track.visuallyTracked ? TRACK_VISUAL : 0) |
+                       (track.engaged ? TRACK_ENGAGED : 0) |
+                       (track.hasRFDetection ? TRACK_RF : 0);
+    }
+    endWrite(header->seqlock);
+
+    ++m_stats.picturesPublished;
+    m_stats.tracksOmitted += picture->tracks.size() - count;
+}
+
+void SharedMemoryPublisher::publishVideoFrame(const QString& cameraId, const VideoFrame& frame,
+                                              qint64 timestampMs) {
+    if (!m_header || m_header->videoSlots == 0 || frame.isNull()) return;
+
+    const int bytes = videoFrameBytes(frame);
+    if (bytes > m_config.maxVideoFrameBytes) {
+        ++m_stats.videoFramesOversize;
+        return;
+    }
+
+    const quint64 number = m_header->videoFrames.load(std::memory_order_relaxed) + 1;
+    char* slotBase = segment() + m_header->videoOffset +
+                     ((number - 1) % m_header->videoSlots) * m_header->videoSlotBytes;
+    auto* slot = reinterpret_cast<VideoSlot*>(slotBase);
+    char* pixels = slotBase + VIDEO_SLOT_HEADER_BYTES;
+
+    beginWrite(slot->seqlock);
+    slot->frameNumber = number;
+    slot->timestampMs = timestampMs;
+    std::memset(slot->cameraId, 0, CAMERA_ID_BYTES);
+    copyId(slot->cameraId, CAMERA_ID_BYTES, cameraId);
+    slot->format = static_cast<qint32>(frame.pixelFormat());
+    slot->width = frame.width();
+    slot->height = frame.height();
+    slot->planeCount = frame.planeCount();
+    int offset = 0;
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        // Each plane's rows are contiguous at its own stride
+        const int planeBytes = frame.planeSize(plane).height() * frame.bytesPerLine(plane);
+        std::memcpy(pixels + offset, frame.constBits(plane), planeBytes);
+        slot->planeOffset[plane] = offset;
+        slot->bytesPerLine[plane] = frame.bytesPerLine(plane);
+        offset += planeBytes;
+    }
+    slot->bytes = bytes;
+    endWrite(slot->seqlock);
+
+    m_header->videoFrames.store(number, std::memory_order_release);
+    ++m_stats.videoFramesPublished;
+}
+
+} // namespace CounterUAS
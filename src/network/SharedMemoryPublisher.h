@@ -0,0 +1,205 @@
+#ifndef SHAREDMEMORYPUBLISHER_H
+#define SHAREDMEMORYPUBLISHER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QSharedMemory>
+#include <QString>
+#include <atomic>
+#include "core/TrackSnapshot.h"
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+class TrackManager;
+
+/**
+ * @brief Shared-memory segment settings shared by publisher and subscriber
+ *
+ * The sizes are the publisher's; a subscriber takes the layout from the
+ * segment it attaches to.
+ */
+struct SharedMemoryConfig {
+    QString key = QStringLiteral("counteruas-c2");
+    int ringBytes = 4 * 1024 * 1024;        // Message ring; a frame over half of it is dropped
+    int trackCapacity = 2048;               // Tracks past this are left out of the picture
+    int videoSlots = 8;                     // Frames kept in the video ring, all cameras
+    int maxVideoFrameBytes = 1920 * 1080 * 4;
+    int pollIntervalMs = 5;                 // Subscriber poll of the segment
+    int retryIntervalMs = 1000;             // Subscriber attach retry while no publisher
+    bool readVideo = true;                  // Subscriber copies out video frames
+};
+
+/**
+ * @brief Layout of the shared segment
+ *
+ * A 4 KiB header, then the message ring, the track picture and the video
+ * slots, each 64-byte aligned. Everything is in host byte order, since
+ * both ends run on one machine. The publisher is the only writer; any
+ * number of subscribers read without writing a byte, so one that stalls
+ * or dies never holds anyone up.
+ *
+ * The message ring holds protocol frames back to back, each behind an
+ * 8-byte length word and padded to 8 bytes; a WRAP_MARKER length sends
+ * readers back to the ring start. The publisher moves ringReserve past a
+ * record before writing it and ringWritten after, so a reader that copied
+ * a record and then finds ringReserve more than a ring ahead of it knows
+ * the copy was overwritten.
+ *
+ * The picture and each video slot sit behind a seqlock: odd while the
+ * publisher writes, advanced by two per write. A reader copies, then
+ * keeps the copy only if the count was even and has not moved.
+ */
+namespace SharedMemoryWire {
+constexpr quint32 MAGIC = 0x48535543;          // "CUSH"
+constexpr quint32 VERSION = 1;
+constexpr quint32 STATE_LIVE = 1;
+constexpr quint32 STATE_CLOSED = 2;            // Publisher stopped; attach again
+constexpr quint32 WRAP_MARKER = 0xFFFFFFFF;
+constexpr int HEADER_BYTES = 4096;
+constexpr int RECORD_HEADER_BYTES = 8;
+constexpr int ID_BYTES = 40;                   // UTF-8, NUL padded; longer ids are cut
+constexpr int CAMERA_ID_BYTES = 64;
+
+static_assert(std::atomic<quint64>::is_always_lock_free,
+              "shared-memory counters must be lock free to be shared between processes");
+
+struct SegmentHeader {
+    quint32 magic;
+    quint32 version;
+    std::atomic<quint32> state;
+    quint32 reserved;
+    quint64 session;                    // New for every start(); readers resync on change
+    quint64 totalBytes;
+
+    quint64 ringOffset;
+    quint64 ringBytes;
+    quint64 pictureOffset;
+    quint32 trackCapacity;
+    quint32 trackRecordBytes;
+    quint64 videoOffset;
+    quint32 videoSlots;
+    quint32 videoSlotBytes;             // Slot header and pixels
+
+    alignas(64) std::atomic<quint64> ringReserve;
+    std::atomic<quint64> ringWritten;   // Bytes ever written; the record end at % ringBytes
+    std::atomic<quint64> videoFrames;   // Frames ever written; frame n is in slot (n - 1) % videoSlots
+};
+
+struct PictureHeader {
+    std::atomic<quint64> seqlock;
+    quint64 sequence;
+    qint64 timestampMs;
+    qint64 newestIngestNs;
+    qint64 newestReceiveLagUs;
+    quint32 count;
+    quint32 omitted;                    // Tracks over trackCapacity
+};
+
+struct TrackRecord {
+    char trackId[ID_BYTES];
+    char cameraId[ID_BYTES];
+    quint32 handle;
+    qint32 classification;
+    qint32 state;
+    qint32 threatLevel;
+    double latitude;
+    double longitude;
+    double altitude;
+    double velocityNorth;
+    double velocityEast;
+    double velocityDown;
+    double covariance[4];               // ee, en, nn, uu
+    double classificationConfidence;
+    double trackQuality;
+    qint64 lastUpdateMs;
+    qint64 ingestMonoNs;
+    qint64 receiveLagUs;
+    quint32 flags;
+    quint32 reserved;
+};
+
+constexpr quint32 TRACK_VISUAL = 1;
+constexpr quint32 TRACK_ENGAGED = 2;
+constexpr quint32 TRACK_RF = 4;
+
+struct VideoSlot {
+    std::atomic<quint64> seqlock;
+    quint64 frameNumber;
+    qint64 timestampMs;
+    char cameraId[CAMERA_ID_BYTES];
+    qint32 format;                      // VideoPixelFormat
+    qint32 width;
+    qint32 height;
+    qint32 planeCount;
+    qint32 planeOffset[3];              // Into the pixels after the slot header
+    qint32 bytesPerLine[3];
+    qint32 bytes;
+};
+
+constexpr int VIDEO_SLOT_HEADER_BYTES = 192;
+static_assert(sizeof(VideoSlot) <= VIDEO_SLOT_HEADER_BYTES, "video slot header outgrew its space");
+static_assert(sizeof(SegmentHeader) <= HEADER_BYTES, "segment header outgrew its page");
+
+inline quint64 align64(quint64 value) { return (value + 63) & ~quint64(63); }
+}
+
+/**
+ * @brief Publishes messages, the track picture and video to processes on this host
+ *
+ * The co-located counterpart of MulticastPublisher: a recorder, a video
+ * process or local analytics attach with a SharedMemorySubscriber and
+ * read straight out of the segment. publish() copies a serialized frame
+ * into the message ring, publishPicture() the picture's tracks as fixed
+ * records a reader uses without parsing, publishVideoFrame() the planes
+ * of a frame into the next video slot. None of them makes a syscall or
+ * waits for a reader; readers that fall a ring behind lose the oldest
+ * entries and count them.
+ *
+ * Not thread safe: publish from the thread that owns the publisher.
+ */
+class SharedMemoryPublisher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SharedMemoryPublisher(QObject* parent = nullptr);
+    ~SharedMemoryPublisher() override;
+
+    bool start(const SharedMemoryConfig& config);
+    void stop();
+    bool isActive() const { return m_header != nullptr; }
+    const SharedMemoryConfig& config() const { return m_config; }
+    QString errorString() const { return m_error; }
+
+    // Publishes every picture the manager does; nullptr detaches
+    void setTrackManager(TrackManager* trackManager);
+
+    void publish(const QByteArray& frame);
+    void publishPicture(const TrackPicturePtr& picture);
+    void publishVideoFrame(const QString& cameraId, const VideoFrame& frame, qint64 timestampMs);
+
+    struct Stats {
+        qint64 framesPublished = 0;
+        qint64 bytesPublished = 0;
+        qint64 framesOversize = 0;      // Over half the ring
+        qint64 picturesPublished = 0;
+        qint64 tracksOmitted = 0;       // Over trackCapacity, summed over pictures
+        qint64 videoFramesPublished = 0;
+        qint64 videoFramesOversize = 0; // Over maxVideoFrameBytes
+    };
+    Stats stats() const { return m_stats; }
+
+private:
+    char* segment() const { return reinterpret_cast<char*>(m_header); }
+
+    SharedMemoryConfig m_config;
+    QSharedMemory m_memory;
+    SharedMemoryWire::SegmentHeader* m_header = nullptr;
+    TrackManager* m_trackManager = nullptr;
+    QString m_error;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // SHAREDMEMORYPUBLISHER_H
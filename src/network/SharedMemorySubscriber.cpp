@@ -0,0 +1,293 @@
+#include "network/SharedMemorySubscriber.h"
+#include "utils/Logger.h"
+#include <cstring>
+#include <memory>
+
+namespace CounterUAS {
+
+using namespace SharedMemoryWire;
+
+namespace {
+
+QString idFrom(const char* data, int capacity) {
+    return QString::fromUtf8(data, static_cast<int>(qstrnlen(data, capacity)));
+}
+
+TrackSnapshot snapshotFrom(const TrackRecord& record) {
+    TrackSnapshot track;
+    track.trackId = idFrom(record.trackId, ID_BYTES);
+    track.associatedCameraId = idFrom(record.cameraId, ID_BYTES);
+    track.handle = record.handle;
+    track.classification = static_cast<TrackClassification>(record.classification);
+    track.state = static_cast<TrackState>(record.state);
+    track.threatLevel = record.threatLevel;
+    track.position.latitude = record.latitude;
+    track.position.longitude = record.longitude;
+    track.position.altitude = record.altitude;
+    track.velocity.north = record.velocityNorth;
+    track.velocity.east = record.velocityEast;
+    track.velocity.down = record.velocityDown;
+    track.covariance.ee = record.covariance[0];
+    track.covariance.en = record.covariance[1];
+    track.covariance.nn = record.covariance[2];
+    track.covariance.uu = record.covariance[3];
+    track.classificationConfidence = record.classificationConfidence;
+    track.trackQuality = record.trackQuality;
+    track.lastUpdateMs = record.lastUpdateMs;
+    track.ingestMonoNs = record.ingestMonoNs;
+    track.receiveLagUs = record.receiveLagUs;
+    track.visuallyTracked = record.flags & TRACK_VISUAL;
+    track.engaged = record.flags & TRACK_ENGAGED;
+    track.hasRFDetection = record.flags & TRACK_RF;
+    return track;
+}
+
+} // namespace
+
+SharedMemorySubscriber::SharedMemorySubscriber(QObject* parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &SharedMemorySubscriber::poll);
+}
+
+SharedMemorySubscriber::~SharedMemorySubscriber() {
+    stop();
+}
+
+bool SharedMemorySubscriber::start(const SharedMemoryConfig& config) {
+    stop();
+    m_config = config;
+    m_memory.setKey(m_config.key);
+    m_timer->start(qMax(1, m_config.pollIntervalMs));
+    return attach();
+}
+
+void SharedMemorySubscriber::stop() {
+    m_timer->stop();
+    detach();
+}
+
+bool SharedMemorySubscriber::attach() {
+    m_sinceAttempt.start();
+    if (!m_memory.attach(QSharedMemory::ReadOnly)) return false;
+
+    const auto* header = static_cast<const SegmentHeader*>(m_memory.constData());
+    const quint64 size = quint64(m_memory.size());
+    const bool valid = size >= quint64(HEADER_BYTES) &&
+        header->state.load(std::memory_order_acquire) == STATE_LIVE &&
+        header->magic == MAGIC && header->version == VERSION &&
+        header->totalBytes <= size &&
+        header->ringOffset + header->ringBytes <= header->pictureOffset &&
+        header->ringBytes % 8 == 0 && header->ringBytes > 0 &&
+        header->trackRecordBytes == sizeof(TrackRecord) &&
+        header->pictureOffset + sizeof(PictureHeader) +
+            quint64(header->trackCapacity) * sizeof(TrackRecord) <= header->videoOffset &&
+        header->videoOffset + quint64(header->videoSlots) * header->videoSlotBytes <= header->totalBytes;
+    if (!valid) {
+        // Closed, half set up, or another build's layout
+        m_memory.detach();
+        return false;
+    }
+
+    m_header = header;
+    m_session = header->session;
+    m_ringCursor = header->ringWritten.load(std::memory_order_acquire);
+    m_videoCursor = header->videoFrames.load(std::memory_order_acquire);
+    m_pictureSeqlock = 0;
+    Logger::instance().info("SharedMemorySubscriber", "Attached to shared memory " + m_config.key);
+    emit attachedChanged(true);
+    if (m_header) readPicture();
+    return m_header != nullptr;
+}
+
+void SharedMemorySubscriber::detach() {
+    if (!m_header) return;
+    m_header = nullptr;
+    m_memory.detach();
+    emit attachedChanged(false);
+}
+
+void SharedMemorySubscriber::poll() {
+    if (!m_header) {
+        if (m_sinceAttempt.isValid() && m_sinceAttempt.elapsed() < m_config.retryIntervalMs) return;
+        if (!attach()) return;
+    }
+
+    if (m_header->state.load(std::memory_order_acquire) != STATE_LIVE ||
+        m_header->session != m_session) {
+        Logger::instance().info("SharedMemorySubscriber", "Publisher stopped: " + m_config.key);
+        detach();
+        return;
+    }
+
+    // Signal handlers may stop() us between the stages
+    readMessages();
+    if (m_header) readPicture();
+    if (m_header && m_config.readVideo) readVideo();
+}
+
+void SharedMemorySubscriber::readMessages() {
+    const quint64 ringBytes = m_header->ringBytes;
+    const char* ring = static_cast<const char*>(m_memory.constData()) + m_header->ringOffset;
+
+    const quint64 written = m_header->ringWritten.load(std::memory_order_acquire);
+    while (m_header && m_ringCursor < written) {
+        if (written - m_ringCursor > ringBytes) {
+            ++m_stats.overruns;
+            m_ringCursor = written;
+            emit overrun();
+            return;
+        }
+
+        const quint64 offset = m_ringCursor % ringBytes;
+        quint32 length = 0;
+        std::memcpy(&length, ring + offset, sizeof(length));
+        quint64 next;
+        if (length == WRAP_MARKER) {
+            next = m_ringCursor + (ringBytes - offset);
+        } else {
+            if (length > ringBytes / 2) length = 0;   // Torn; the reserve check below catches it
+            m_record.resize(static_cast<int>(length));
+            std::memcpy(m_record.data(), ring + offset + RECORD_HEADER_BYTES, length);
+            next = m_ringCursor + RECORD_HEADER_BYTES + ((quint64(length) + 7) & ~quint64(7));
+        }
+
+        // Everything copied above is good only if no write has reached it since
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->ringReserve.load(std::memory_order_relaxed) - m_ringCursor > ringBytes) {
+            ++m_stats.overruns;
+            m_ringCursor = m_header->ringWritten.load(std::memory_order_acquire);
+            emit overrun();
+            return;
+        }
+        m_ringCursor = next;
+        if (length == WRAP_MARKER) continue;
+
+        FrameHeader header;
+        Message msg;
+        if (MessageProtocol::parseHeader(m_record.constData(), m_record.size(), header) > 0 &&
+            MessageProtocol::HEADER_SIZE + header.payloadSize <= m_record.size() &&
+            m_protocol.decodePayload(header, m_record.constData() + MessageProtocol::HEADER_SIZE, msg)) {
+            ++m_stats.messagesReceived;
+            m_stats.bytesReceived += m_record.size();
+            emit messageReceived(msg);
+        } else {
+            ++m_stats.malformedFrames;
+        }
+    }
+}
+
+void SharedMemorySubscriber::readPicture() {
+    const char* base = static_cast<const char*>(m_memory.constData()) + m_header->pictureOffset;
+    const auto* header = reinterpret_cast<const PictureHeader*>(base);
+    const auto* records = reinterpret_cast<const TrackRecord*>(header + 1);
+
+    QVector<TrackRecord> copy;
+    PictureHeader fields;
+    for (int attempt = 0; attempt < MAX_PICTURE_ATTEMPTS; ++attempt) {
+        const quint64 before = header->seqlock.load(std::memory_order_acquire);
+        if (before == m_pictureSeqlock) return;          // Unchanged since the last copy
+        if (before & 1) {
+            ++m_stats.pictureRetries;
+            continue;
+        }
+
+        fields.sequence = header->sequence;
+        fields.timestampMs = header->timestampMs;
+        fields.newestIngestNs = header->newestIngestNs;
+        fields.newestReceiveLagUs = header->newestReceiveLagUs;
+        const quint32 count = qMin(header->count, m_header->trackCapacity);
+        copy.resize(static_cast<int>(count));
+        std::memcpy(copy.data(), records, count * sizeof(TrackRecord));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->seqlock.load(std::memory_order_relaxed) != before) {
+            ++m_stats.pictureRetries;
+            continue;
+        }
+
+        // Consistent: the rest happens off the segment
+        auto picture = std::make_shared<TrackPicture>();
+        picture->sequence = fields.sequence;
+        picture->timestampMs = fields.timestampMs;
+        picture->newestIngestNs = fields.newestIngestNs;
+        picture->newestReceiveLagUs = fields.newestReceiveLagUs;
+        picture->tracks.reserve(copy.size());
+        for (const TrackRecord& record : copy) {
+            picture->tracks.append(snapshotFrom(record));
+            const TrackSnapshot& track = picture->tracks.last();
+            const int index = picture->tracks.size() - 1;
+            picture->indexById.insert(track.trackId, index);
+            picture->indexByHandle.insert(track.handle, index);
+        }
+
+        m_pictureSeqlock = before;
+        m_picture = picture;
+        ++m_stats.picturesRead;
+        emit pictureUpdated(m_picture);
+        return;
+    }
+    // Still being written; the next poll tries again
+}
+
+void SharedMemorySubscriber::readVideo() {
+    const quint64 slots = m_header->videoSlots;
+    if (slots == 0) return;
+
+    const quint64 written = m_header->videoFrames.load(std::memory_order_acquire);
+    if (written - m_videoCursor > slots) {
+        m_stats.videoFramesLost += written - m_videoCursor - slots;
+        m_videoCursor = written - slots;
+    }
+
+    const char* video = static_cast<const char*>(m_memory.constData()) + m_header->videoOffset;
+    const quint64 maxBytes = m_header->videoSlotBytes - VIDEO_SLOT_HEADER_BYTES;
+    while (m_header && m_videoCursor < written) {
+        const quint64 number = ++m_videoCursor;
+        const char* slotBase = video + ((number - 1) % slots) * m_header->videoSlotBytes;
+        const auto* slot = reinterpret_cast<const VideoSlot*>(slotBase);
+
+        const quint64 before = slot->seqlock.load(std::memory_order_acquire);
+        if ((before & 1) || slot->frameNumber != number) {
+            ++m_stats.videoFramesLost;
+            continue;
+        }
+
+        // Read each field once: a torn slot must not steer the copy out of it
+        const VideoPixelFormat format = static_cast<VideoPixelFormat>(slot->format);
+        const QSize size(slot->width, slot->height);
+        const qint64 timestampMs = slot->timestampMs;
+        const QString cameraId = idFrom(slot->cameraId, CAMERA_ID_BYTES);
+        const qint64 bytes = slot->bytes;
+        const int planeCount = VideoFrame::planeCount(format);
+        bool valid = planeCount > 0 && planeCount == slot->planeCount && planeCount <= 3 &&
+                     size.width() > 0 && size.height() > 0 &&
+                     bytes >= 0 && quint64(bytes) <= maxBytes;
+        const uchar* planes[3] = {};
+        int strides[3] = {};
+        for (int plane = 0; valid && plane < planeCount; ++plane) {
+            const qint64 offset = slot->planeOffset[plane];
+            strides[plane] = slot->bytesPerLine[plane];
+            const qint64 rows = plane == 0 ? size.height() : (size.height() + 1) / 2;
+            valid = offset >= 0 && strides[plane] >= (plane == 0 ? size.width() : 1) &&
+                    offset + rows * strides[plane] <= bytes;
+            planes[plane] = reinterpret_cast<const uchar*>(slotBase + VIDEO_SLOT_HEADER_BYTES) + offset;
+        }
+        VideoFrame frame;
+        if (valid) {
+            frame = VideoFrame::fromPlanes(format, size, planes, strides, &m_framePool);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->seqlock.load(std::memory_order_relaxed) != before || frame.isNull()) {
+            ++m_stats.videoFramesLost;
+            continue;
+        }
+        ++m_stats.videoFramesReceived;
+        emit videoFrameReceived(cameraId, frame, timestampMs);
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,94 @@
+#ifndef SHAREDMEMORYSUBSCRIBER_H
+#define SHAREDMEMORYSUBSCRIBER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QSharedMemory>
+#include <QTimer>
+#include "network/MessageProtocol.h"
+#include "network/SharedMemoryPublisher.h"
+#include "utils/FramePool.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Reads a co-located SharedMemoryPublisher's segment
+ *
+ * start() attaches read-only and polls every pollIntervalMs; while no
+ * publisher is up it tries again every retryIntervalMs, and it lets go of
+ * a segment whose publisher stopped. Each poll delivers the frames added
+ * to the message ring since the last one, takes a new copy of the track
+ * picture when its sequence moved, and copies out the video frames that
+ * arrived. A poll makes no syscall.
+ *
+ * A subscriber starts at the newest message, like one that joins a
+ * multicast group. One that falls more than a ring behind skips to the
+ * newest and reports the gap through overrun().
+ */
+class SharedMemorySubscriber : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SharedMemorySubscriber(QObject* parent = nullptr);
+    ~SharedMemorySubscriber() override;
+
+    // True when a publisher was there to attach to
+    bool start(const SharedMemoryConfig& config);
+    void stop();
+    bool isRunning() const { return m_timer->isActive(); }
+    bool isAttached() const { return m_header != nullptr; }
+
+    // The newest picture read; empty before the first
+    TrackPicturePtr picture() const { return m_picture; }
+
+    void poll();
+
+    struct Stats {
+        qint64 messagesReceived = 0;
+        qint64 bytesReceived = 0;
+        qint64 malformedFrames = 0;
+        qint64 overruns = 0;            // Times the ring lapped this reader
+        qint64 picturesRead = 0;
+        qint64 pictureRetries = 0;      // Copies torn by a concurrent write
+        qint64 videoFramesReceived = 0;
+        qint64 videoFramesLost = 0;     // Overwritten before this reader got to them
+    };
+    Stats stats() const { return m_stats; }
+
+signals:
+    void attachedChanged(bool attached);
+    void messageReceived(const Message& message);
+    void pictureUpdated(const TrackPicturePtr& picture);
+    void videoFrameReceived(const QString& cameraId, const VideoFrame& frame, qint64 timestampMs);
+    void overrun();
+
+private:
+    bool attach();
+    void detach();
+    void readMessages();
+    void readPicture();
+    void readVideo();
+
+    static constexpr int MAX_PICTURE_ATTEMPTS = 4;
+
+    SharedMemoryConfig m_config;
+    QSharedMemory m_memory;
+    QTimer* m_timer;
+    QElapsedTimer m_sinceAttempt;
+    MessageProtocol m_protocol;
+    FramePool m_framePool;
+    const SharedMemoryWire::SegmentHeader* m_header = nullptr;
+
+    quint64 m_session = 0;
+    quint64 m_ringCursor = 0;
+    quint64 m_pictureSeqlock = 0;       // Of the copy in m_picture
+    quint64 m_videoCursor = 0;
+    QByteArray m_record;                // Reused for every message copy
+    TrackPicturePtr m_picture;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // SHAREDMEMORYSUBSCRIBER_H
@@ -0,0 +1,718 @@
+#include "network/TrackPictureSync.h"
+#include "core/TrackManager.h"
+#include "core/TrackToTrackFusion.h"
+#include "utils/Logger.h"
+#include "utils/PipelineLatency.h"
+#include "utils/TimeUtils.h"
+#include <QDateTime>
+#include <QStringList>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+// Field groups present in a delta record
+enum SyncGroup : quint32 {
+    GroupPosition = 0x001,       // latitude, longitude, altitude
+    GroupVelocity = 0x002,       // north, east, down
+    GroupClassification = 0x004, // classification, confidence
+    GroupState = 0x008,
+    GroupThreatLevel = 0x010,
+    GroupQuality = 0x020,
+    GroupFlags = 0x040,
+    GroupCreated = 0x080,        // track id string follows the mask
+    GroupDropped = 0x100,
+    GroupCovariance = 0x200,     // sigma east, north, up, correlation
+    AllGroups = 0x27F
+};
+
+constexpr double POSITION_SCALE = 1e7;   // 1e-7 deg
+constexpr double ALTITUDE_SCALE = 10.0;  // 0.1 m
+constexpr double VELOCITY_SCALE = 100.0; // 0.01 m/s
+constexpr double SIGMA_SCALE = 10.0;     // 0.1 m
+constexpr double CORRELATION_SCALE = 127.0;
+// Covariance is resent only on a change the fusion on the far side would
+// notice, not on every few centimetres of filter settling
+constexpr double SIGMA_RESEND_RATIO = 0.1;
+constexpr int CORRELATION_RESEND_STEP = 13;
+constexpr int RESYNC_REQUEST_INTERVAL_MS = 1000;
+
+qint32 quantize(double value, double scale) {
+    const double q = std::round(value * scale);
+    return static_cast<qint32>(qBound(-2147483647.0, q, 2147483647.0));
+}
+
+quint8 quantizeUnit(double value) {
+    return static_cast<quint8>(std::lround(qBound(0.0, value, 1.0) * 255.0));
+}
+
+void putVarint(QByteArray& out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+void putSigned(QByteArray& out, qint64 value) {
+    putVarint(out, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+
+void putString(QByteArray& out, const QString& value) {
+    const QByteArray utf8 = value.toUtf8();
+    putVarint(out, static_cast<quint64>(utf8.size()));
+    out.append(utf8);
+}
+
+struct SyncReader {
+    const char* pos;
+    const char* end;
+    bool ok = true;
+
+    quint64 varint() {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) break;
+            const quint8 byte = static_cast<quint8>(*pos++);
+            value |= static_cast<quint64>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    qint64 signedVarint() {
+        const quint64 raw = varint();
+        return static_cast<qint64>(raw >> 1) ^ -static_cast<qint64>(raw & 1);
+    }
+
+    quint8 byte() {
+        if (pos == end) {
+            ok = false;
+            return 0;
+        }
+        return static_cast<quint8>(*pos++);
+    }
+
+    QString string() {
+        const quint64 size = varint();
+        if (!ok || size > static_cast<quint64>(end - pos)) {
+            ok = false;
+            return QString();
+        }
+        QString value = QString::fromUtf8(pos, static_cast<int>(size));
+        pos += size;
+        return value;
+    }
+};
+
+quint32 changedGroups(const SyncTrackState& a, const SyncTrackState& b) {
+    quint32 groups = 0;
+    if (a.latitude != b.latitude || a.longitude != b.longitude || a.altitude != b.altitude) {
+        groups |= GroupPosition;
+    }
+    if (a.velocityNorth != b.velocityNorth || a.velocityEast != b.velocityEast ||
+        a.velocityDown != b.velocityDown) {
+        groups |= GroupVelocity;
+    }
+    if (a.classification != b.classification || a.confidence != b.confidence) {
+        groups |= GroupClassification;
+    }
+    if (a.state != b.state) groups |= GroupState;
+    if (a.threatLevel != b.threatLevel) groups |= GroupThreatLevel;
+    if (a.quality != b.quality) groups |= GroupQuality;
+    if (a.flags != b.flags) groups |= GroupFlags;
+    auto sigmaMoved = [](qint32 now, qint32 sent) {
+        return std::abs(now - sent) > qMax(1.0, SIGMA_RESEND_RATIO * sent);
+    };
+    if (sigmaMoved(a.sigmaEast, b.sigmaEast) || sigmaMoved(a.sigmaNorth, b.sigmaNorth) ||
+        sigmaMoved(a.sigmaUp, b.sigmaUp) ||
+        std::abs(a.correlation - b.correlation) >= CORRELATION_RESEND_STEP) {
+        groups |= GroupCovariance;
+    }
+    return groups;
+}
+
+// Numeric groups are coded relative to base; a zero base gives absolute values
+void writeGroups(QByteArray& out, quint32 groups, const SyncTrackState& state,
+                 const SyncTrackState& base) {
+    if (groups & GroupPosition) {
+        putSigned(out, qint64(state.latitude) - base.latitude);
+        putSigned(out, qint64(state.longitude) - base.longitude);
+        putSigned(out, qint64(state.altitude) - base.altitude);
+    }
+    if (groups & GroupVelocity) {
+        putSigned(out, qint64(state.velocityNorth) - base.velocityNorth);
+        putSigned(out, qint64(state.velocityEast) - base.velocityEast);
+        putSigned(out, qint64(state.velocityDown) - base.velocityDown);
+    }
+    if (groups & GroupClassification) {
+        out.append(static_cast<char>(state.classification));
+        out.append(static_cast<char>(state.confidence));
+    }
+    if (groups & GroupState) out.append(static_cast<char>(state.state));
+    if (groups & GroupThreatLevel) out.append(static_cast<char>(state.threatLevel));
+    if (groups & GroupQuality) out.append(static_cast<char>(state.quality));
+    if (groups & GroupFlags) out.append(static_cast<char>(state.flags));
+    if (groups & GroupCovariance) {
+        putSigned(out, qint64(state.sigmaEast) - base.sigmaEast);
+        putSigned(out, qint64(state.sigmaNorth) - base.sigmaNorth);
+        putSigned(out, qint64(state.sigmaUp) - base.sigmaUp);
+        out.append(static_cast<char>(state.correlation));
+    }
+}
+
+// Reads the groups as coded: numeric fields are deltas, the rest absolute
+void readGroups(SyncReader& reader, quint32 groups, SyncTrackState& coded) {
+    if (groups & GroupPosition) {
+        coded.latitude = static_cast<qint32>(reader.signedVarint());
+        coded.longitude = static_cast<qint32>(reader.signedVarint());
+        coded.altitude = static_cast<qint32>(reader.signedVarint());
+    }
+    if (groups & GroupVelocity) {
+        coded.velocityNorth = static_cast<qint32>(reader.signedVarint());
+        coded.velocityEast = static_cast<qint32>(reader.signedVarint());
+        coded.velocityDown = static_cast<qint32>(reader.signedVarint());
+    }
+    if (groups & GroupClassification) {
+        coded.classification = reader.byte();
+        coded.confidence = reader.byte();
+    }
+    if (groups & GroupState) coded.state = reader.byte();
+    if (groups & GroupThreatLevel) coded.threatLevel = reader.byte();
+    if (groups & GroupQuality) coded.quality = reader.byte();
+    if (groups & GroupFlags) coded.flags = reader.byte();
+    if (groups & GroupCovariance) {
+        coded.sigmaEast = static_cast<qint32>(reader.signedVarint());
+        coded.sigmaNorth = static_cast<qint32>(reader.signedVarint());
+        coded.sigmaUp = static_cast<qint32>(reader.signedVarint());
+        coded.correlation = static_cast<qint8>(reader.byte());
+    }
+}
+
+// Deltas wrap modulo 2^32, matching the truncation in readGroups
+void addWrapped(qint32& value, qint32 delta) {
+    value = static_cast<qint32>(static_cast<quint32>(value) + static_cast<quint32>(delta));
+}
+
+void applyGroups(SyncTrackState& state, quint32 groups, const SyncTrackState& coded) {
+    if (groups & GroupPosition) {
+        addWrapped(state.latitude, coded.latitude);
+        addWrapped(state.longitude, coded.longitude);
+        addWrapped(state.altitude, coded.altitude);
+    }
+    if (groups & GroupVelocity) {
+        addWrapped(state.velocityNorth, coded.velocityNorth);
+        addWrapped(state.velocityEast, coded.velocityEast);
+        addWrapped(state.velocityDown, coded.velocityDown);
+    }
+    if (groups & GroupClassification) {
+        state.classification = coded.classification;
+        state.confidence = coded.confidence;
+    }
+    if (groups & GroupState) state.state = coded.state;
+    if (groups & GroupThreatLevel) state.threatLevel = coded.threatLevel;
+    if (groups & GroupQuality) state.quality = coded.quality;
+    if (groups & GroupFlags) state.flags = coded.flags;
+    if (groups & GroupCovariance) {
+        addWrapped(state.sigmaEast, coded.sigmaEast);
+        addWrapped(state.sigmaNorth, coded.sigmaNorth);
+        addWrapped(state.sigmaUp, coded.sigmaUp);
+        state.correlation = coded.correlation;
+    }
+}
+
+QByteArray payloadData(const Message& message) {
+    const QVariant data = message.payload.value("data");
+    // JSON-encoded frames carry the blob as base64
+    if (data.userType() == QMetaType::QString) {
+        return QByteArray::fromBase64(data.toString().toLatin1());
+    }
+    return data.toByteArray();
+}
+
+} // namespace
+
+SyncTrackState SyncTrackState::fromSnapshot(const TrackSnapshot& track) {
+    SyncTrackState s;
+    s.latitude = quantize(track.position.latitude, POSITION_SCALE);
+    s.longitude = quantize(track.position.longitude, POSITION_SCALE);
+    s.altitude = quantize(track.position.altitude, ALTITUDE_SCALE);
+    s.velocityNorth = quantize(track.velocity.north, VELOCITY_SCALE);
+    s.velocityEast = quantize(track.velocity.east, VELOCITY_SCALE);
+    s.velocityDown = quantize(track.velocity.down, VELOCITY_SCALE);
+    s.classification = static_cast<quint8>(track.classification);
+    s.state = static_cast<quint8>(track.state);
+    s.threatLevel = static_cast<quint8>(qBound(0, track.threatLevel, 255));
+    s.confidence = quantizeUnit(track.classificationConfidence);
+    s.quality = quantizeUnit(track.trackQuality);
+    s.flags = (track.visuallyTracked ? 0x01 : 0) | (track.engaged ? 0x02 : 0);
+    const PositionCovariance& cov = track.covariance;
+    if (cov.isValid()) {
+        s.sigmaEast = quantize(std::sqrt(cov.ee), SIGMA_SCALE);
+        s.sigmaNorth = quantize(std::sqrt(cov.nn), SIGMA_SCALE);
+        s.sigmaUp = quantize(std::sqrt(qMax(0.0, cov.uu)), SIGMA_SCALE);
+        s.correlation = static_cast<qint8>(
+            std::lround(qBound(-1.0, cov.en / std::sqrt(cov.ee * cov.nn), 1.0) * CORRELATION_SCALE));
+    }
+    return s;
+}
+
+TrackSnapshot SyncTrackState::toSnapshot(const QString& trackId) const {
+    TrackSnapshot track;
+    track.trackId = trackId;
+    track.position.latitude = latitude / POSITION_SCALE;
+    track.position.longitude = longitude / POSITION_SCALE;
+    track.position.altitude = altitude / ALTITUDE_SCALE;
+    track.velocity.north = velocityNorth / VELOCITY_SCALE;
+    track.velocity.east = velocityEast / VELOCITY_SCALE;
+    track.velocity.down = velocityDown / VELOCITY_SCALE;
+    track.classification = static_cast<TrackClassification>(classification);
+    track.state = static_cast<TrackState>(state);
+    track.threatLevel = threatLevel;
+    track.classificationConfidence = confidence / 255.0;
+    track.trackQuality = quality / 255.0;
+    track.visuallyTracked = flags & 0x01;
+    track.engaged = flags & 0x02;
+    const double sigmaE = sigmaEast / SIGMA_SCALE;
+    const double sigmaN = sigmaNorth / SIGMA_SCALE;
+    const double sigmaU = sigmaUp / SIGMA_SCALE;
+    track.covariance.ee = sigmaE * sigmaE;
+    track.covariance.nn = sigmaN * sigmaN;
+    track.covariance.uu = sigmaU * sigmaU;
+    track.covariance.en = correlation / CORRELATION_SCALE * sigmaE * sigmaN;
+    return track;
+}
+
+TrackPictureSync::TrackPictureSync(NetworkManager* network, QObject* parent)
+    : QObject(parent)
+    , m_network(network)
+    , m_keyframeTimer(new QTimer(this))
+{
+    m_keyframeTimer->setInterval(5000);
+    connect(m_keyframeTimer, &QTimer::timeout, this, &TrackPictureSync::sendKeyframe);
+
+    connect(m_network, &NetworkManager::messageReceived,
+            this, &TrackPictureSync::onMessageReceived);
+    connect(m_network, &NetworkManager::connectionStatusChanged,
+            this, &TrackPictureSync::onConnectionStatusChanged);
+}
+
+void TrackPictureSync::setTrackManager(TrackManager* trackManager) {
+    if (m_trackManager) {
+        QObject::disconnect(m_trackManager, nullptr, this, nullptr);
+    }
+    m_trackManager = trackManager;
+    m_sent.clear();
+
+    if (m_trackManager) {
+        connect(m_trackManager, &TrackManager::tracksChanged,
+                this, &TrackPictureSync::onTracksChanged);
+        m_keyframePending = true;
+        m_keyframeTimer->start();
+    } else {
+        m_keyframeTimer->stop();
+    }
+}
+
+void TrackPictureSync::setKeyframeInterval(int intervalMs) {
+    m_keyframeTimer->setInterval(qMax(100, intervalMs));
+}
+
+void TrackPictureSync::setBandwidthLimit(int bytesPerSecond) {
+    m_bandwidthLimit = qMax(0, bytesPerSecond);
+    m_budgetBytes = m_bandwidthLimit;
+    m_budgetRefillMs = TimeUtils::monotonicNs() / 1000000;
+}
+
+void TrackPictureSync::refillBudget() {
+    if (m_bandwidthLimit <= 0) return;
+    const qint64 nowMs = TimeUtils::monotonicNs() / 1000000;
+    m_budgetBytes = qMin<double>(m_bandwidthLimit,
+                                 m_budgetBytes + m_bandwidthLimit * (nowMs - m_budgetRefillMs) / 1000.0);
+    m_budgetRefillMs = nowMs;
+}
+
+void TrackPictureSync::chargeBudget(int bytes) {
+    // May go negative after a keyframe; deltas then wait for it to refill
+    if (m_bandwidthLimit > 0) m_budgetBytes -= bytes;
+}
+
+QList<TrackSnapshot> TrackPictureSync::remoteTracks(const QString& connectionId) const {
+    QList<TrackSnapshot> result;
+    auto it = m_mirrors.constFind(connectionId);
+    if (it == m_mirrors.constEnd()) return result;
+
+    result.reserve(it->tracks.size());
+    for (const RemoteTrack& track : it->tracks) {
+        result.append(track.state.toSnapshot(track.trackId));
+    }
+    return result;
+}
+
+bool TrackPictureSync::isSynced(const QString& connectionId) const {
+    auto it = m_mirrors.constFind(connectionId);
+    return it != m_mirrors.constEnd() && it->synced;
+}
+
+QString TrackPictureSync::remoteNodeId(const QString& connectionId) const {
+    auto it = m_mirrors.constFind(connectionId);
+    return it != m_mirrors.constEnd() ? it->nodeId : QString();
+}
+
+void TrackPictureSync::attachFusion(TrackToTrackFusion* fusion) {
+    fusion->setNodeId(m_nodeId);
+    // Peers that never named themselves are told apart by connection
+    auto nodeOf = [this](const QString& connectionId) {
+        const QString nodeId = remoteNodeId(connectionId);
+        return nodeId.isEmpty() ? connectionId : nodeId;
+    };
+    connect(this, &TrackPictureSync::remoteTrackUpdated, fusion,
+            [fusion, nodeOf](const QString& connectionId, const TrackSnapshot& track) {
+        fusion->updateRemoteTrack(nodeOf(connectionId), track);
+    });
+    connect(this, &TrackPictureSync::remoteTrackDropped, fusion,
+            [fusion, nodeOf](const QString& connectionId, const QString& trackId) {
+        fusion->dropRemoteTrack(nodeOf(connectionId), trackId);
+    });
+}
+
+TypedMessage TrackPictureSync::makeMessage(MessageType type, const QByteArray& data) {
+    TypedMessage msg;
+    msg.sequenceNumber = ++m_sequence;  // Own run, so receivers can spot gaps
+    msg.timestamp = QDateTime::currentMSecsSinceEpoch();
+    msg.sourceId = m_nodeId;
+    msg.body = TrackSyncBody{type == MessageType::TrackKeyframe, data};
+    return msg;
+}
+
+void TrackPictureSync::scheduleKeyframe() {
+    if (!m_trackManager || m_keyframePending) return;
+    m_keyframePending = true;
+    QTimer::singleShot(0, this, [this]() {
+        if (m_keyframePending) sendKeyframe();
+    });
+}
+
+void TrackPictureSync::sendKeyframe() {
+    if (!m_trackManager) return;
+    m_keyframePending = false;
+
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    QHash<TrackHandle, SentTrack> sent;
+    sent.reserve(picture->tracks.size());
+
+    QByteArray body;
+    body.reserve(24 * picture->tracks.size());
+    int count = 0;
+    for (const TrackSnapshot& track : picture->tracks) {
+        if (track.state == TrackState::Dropped) continue;
+
+        SentTrack entry;
+        auto previous = m_sent.constFind(track.handle);
+        entry.wireId = previous != m_sent.constEnd() ? previous->wireId : m_nextWireId++;
+        entry.state = SyncTrackState::fromSnapshot(track);
+
+        putVarint(body, entry.wireId);
+        putString(body, track.trackId);
+        writeGroups(body, AllGroups, entry.state, SyncTrackState());
+        sent.insert(track.handle, entry);
+        ++count;
+    }
+    m_sent.swap(sent);
+    m_deferred.clear();  // The keyframe carries their latest state
+
+    QByteArray data;
+    putVarint(data, static_cast<quint64>(count));
+    data.append(body);
+
+    refillBudget();
+    m_network->broadcast(makeMessage(MessageType::TrackKeyframe, data));
+    ++m_stats.keyframesSent;
+    m_stats.bytesSent += data.size();
+    chargeBudget(data.size());
+    PipelineLatency::recordNewest(PipelineStage::Publish, picture->newestIngestNs, m_latencyIngestNs);
+    m_keyframeTimer->start();  // Next periodic keyframe counts from this one
+}
+
+void TrackPictureSync::onTracksChanged(const TrackChangeSet& changes) {
+    if (!m_trackManager) return;
+    if (m_keyframePending) {
+        sendKeyframe();  // Covers this cycle's changes too
+        return;
+    }
+
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    QByteArray body;
+    int count = 0;
+
+    // This cycle's changes plus whatever the budget held back last time
+    QVector<TrackHandle> pending = changes.handles;
+    if (!m_deferred.isEmpty()) {
+        for (TrackHandle handle : changes.handles) {
+            m_deferred.remove(handle);
+        }
+        for (TrackHandle handle : qAsConst(m_deferred)) {
+            pending.append(handle);
+        }
+        m_deferred.clear();
+    }
+
+    struct Update {
+        TrackHandle handle;
+        int threatLevel;
+        SyncTrackState state;
+    };
+    QVector<Update> updates;
+
+    for (TrackHandle handle : qAsConst(pending)) {
+        const TrackSnapshot* track = picture->find(handle);
+        auto sent = m_sent.find(handle);
+
+        if (!track || track->state == TrackState::Dropped) {
+            if (sent != m_sent.end()) {
+                putVarint(body, sent->wireId);
+                putVarint(body, GroupDropped);
+                m_sent.erase(sent);
+                ++count;
+            }
+            continue;
+        }
+
+        const SyncTrackState state = SyncTrackState::fromSnapshot(*track);
+        if (sent == m_sent.end()) {
+            SentTrack entry;
+            entry.wireId = m_nextWireId++;
+            entry.state = state;
+            m_sent.insert(handle, entry);
+
+            putVarint(body, entry.wireId);
+            putVarint(body, AllGroups | GroupCreated);
+            putString(body, track->trackId);
+            writeGroups(body, AllGroups, state, SyncTrackState());
+            ++count;
+            continue;
+        }
+        updates.append({handle, track->threatLevel, state});
+    }
+
+    refillBudget();
+    if (m_bandwidthLimit > 0) {
+        std::stable_sort(updates.begin(), updates.end(), [](const Update& a, const Update& b) {
+            return a.threatLevel > b.threatLevel;
+        });
+    }
+
+    QByteArray record;
+    for (int i = 0; i < updates.size(); ++i) {
+        const Update& update = updates[i];
+        SentTrack& sent = m_sent[update.handle];
+
+        // Value diff on the sync grid: sub-quantum jitter sends nothing
+        const quint32 groups = changedGroups(update.state, sent.state);
+        if (groups == 0) continue;
+
+        record.clear();
+        putVarint(record, sent.wireId);
+        putVarint(record, groups);
+        writeGroups(record, groups, update.state, sent.state);
+        if (m_bandwidthLimit > 0 && body.size() + record.size() > m_budgetBytes) {
+            // Out of budget: the rest are diffed again next cycle
+            for (int j = i; j < updates.size(); ++j) {
+                m_deferred.insert(updates[j].handle);
+            }
+            m_stats.updatesDeferred += updates.size() - i;
+            break;
+        }
+        body.append(record);
+        sent.state = update.state;
+        ++count;
+    }
+
+    if (count == 0) return;
+
+    QByteArray data;
+    putVarint(data, static_cast<quint64>(count));
+    data.append(body);
+
+    m_network->broadcast(makeMessage(MessageType::TrackDelta, data));
+    ++m_stats.deltasSent;
+    m_stats.bytesSent += data.size();
+    chargeBudget(data.size());
+    PipelineLatency::recordNewest(PipelineStage::Publish, picture->newestIngestNs, m_latencyIngestNs);
+}
+
+void TrackPictureSync::onMessageReceived(const QString& connectionId, const Message& message) {
+    switch (message.type) {
+    case MessageType::TrackResyncRequest:
+        scheduleKeyframe();
+        return;
+    case MessageType::TrackKeyframe:
+    case MessageType::TrackDelta:
+        break;
+    default:
+        return;
+    }
+
+    Mirror& mirror = m_mirrors[connectionId];
+    mirror.nodeId = message.sourceId;
+    const QByteArray data = payloadData(message);
+
+    if (message.type == MessageType::TrackKeyframe) {
+        if (applyKeyframe(connectionId, mirror, data)) {
+            mirror.synced = true;
+            mirror.expectedSequence = message.sequenceNumber + 1;
+            emit remotePictureResynced(connectionId);
+            emit remotePictureApplied(connectionId, message.timestamp);
+        } else {
+            Logger::instance().warning("TrackPictureSync",
+                                      "Malformed keyframe from " + connectionId);
+        }
+        return;
+    }
+
+    if (mirror.synced && message.sequenceNumber != mirror.expectedSequence) {
+        ++m_stats.gapsDetected;
+        Logger::instance().warning("TrackPictureSync",
+            QString("Sequence gap from %1: expected %2, got %3")
+                .arg(connectionId).arg(mirror.expectedSequence).arg(message.sequenceNumber));
+        mirror.synced = false;
+    }
+    if (!mirror.synced) {
+        requestResync(connectionId, mirror);
+        return;
+    }
+
+    if (!applyDelta(connectionId, mirror, data)) {
+        Logger::instance().warning("TrackPictureSync", "Malformed delta from " + connectionId);
+        mirror.synced = false;
+        requestResync(connectionId, mirror);
+        return;
+    }
+    mirror.expectedSequence = message.sequenceNumber + 1;
+    emit remotePictureApplied(connectionId, message.timestamp);
+}
+
+void TrackPictureSync::onConnectionStatusChanged(const QString& connectionId,
+                                                 ConnectionStatus status) {
+    if (status == ConnectionStatus::Connected) {
+        scheduleKeyframe();  // Let the new peer sync without waiting a full interval
+    } else {
+        dropMirror(connectionId);
+    }
+}
+
+void TrackPictureSync::dropMirror(const QString& connectionId) {
+    auto it = m_mirrors.find(connectionId);
+    if (it == m_mirrors.end()) return;
+
+    // The mirror outlives the signals so receivers can still ask its node id
+    const QHash<quint32, RemoteTrack> tracks = it->tracks;
+    it->tracks.clear();
+    for (const RemoteTrack& track : tracks) {
+        emit remoteTrackDropped(connectionId, track.trackId);
+    }
+    m_mirrors.remove(connectionId);
+}
+
+bool TrackPictureSync::applyKeyframe(const QString& connectionId, Mirror& mirror,
+                                     const QByteArray& data) {
+    SyncReader reader{data.constData(), data.constData() + data.size()};
+    const quint64 count = reader.varint();
+
+    QHash<quint32, RemoteTrack> tracks;
+    for (quint64 i = 0; reader.ok && i < count; ++i) {
+        const quint32 wireId = static_cast<quint32>(reader.varint());
+        RemoteTrack track;
+        track.trackId = reader.string();
+        readGroups(reader, AllGroups, track.state);  // Absolute in a keyframe
+        tracks.insert(wireId, track);
+    }
+    if (!reader.ok) return false;
+
+    // Whatever the keyframe no longer lists is gone on the far side
+    QStringList dropped;
+    for (auto it = mirror.tracks.constBegin(); it != mirror.tracks.constEnd(); ++it) {
+        auto now = tracks.constFind(it.key());
+        if (now == tracks.constEnd() || now->trackId != it->trackId) {
+            dropped.append(it->trackId);
+        }
+    }
+    mirror.tracks = tracks;
+
+    for (const QString& trackId : dropped) {
+        emit remoteTrackDropped(connectionId, trackId);
+    }
+    for (const RemoteTrack& track : tracks) {
+        emit remoteTrackUpdated(connectionId, track.state.toSnapshot(track.trackId));
+    }
+    return true;
+}
+
+bool TrackPictureSync::applyDelta(const QString& connectionId, Mirror& mirror,
+                                  const QByteArray& data) {
+    struct Record {
+        quint32 wireId;
+        quint32 groups;
+        QString trackId;
+        SyncTrackState coded;
+    };
+
+    // Parse everything first so a truncated frame leaves the mirror untouched
+    SyncReader reader{data.constData(), data.constData() + data.size()};
+    const quint64 count = reader.varint();
+    QVector<Record> records;
+    records.reserve(static_cast<int>(qMin<quint64>(count, data.size())));
+
+    for (quint64 i = 0; reader.ok && i < count; ++i) {
+        Record record;
+        record.wireId = static_cast<quint32>(reader.varint());
+        record.groups = static_cast<quint32>(reader.varint());
+        if (record.groups & GroupCreated) {
+            record.trackId = reader.string();
+        } else if (!(record.groups & GroupDropped) && !mirror.tracks.contains(record.wireId)) {
+            return false;  // Delta for a track this mirror never saw
+        }
+        readGroups(reader, record.groups, record.coded);
+        records.append(record);
+    }
+    if (!reader.ok) return false;
+
+    for (const Record& record : records) {
+        if (record.groups & GroupDropped) {
+            auto it = mirror.tracks.find(record.wireId);
+            if (it == mirror.tracks.end()) continue;
+            const QString trackId = it->trackId;
+            mirror.tracks.erase(it);
+            emit remoteTrackDropped(connectionId, trackId);
+            continue;
+        }
+
+        auto it = mirror.tracks.find(record.wireId);
+        if (record.groups & GroupCreated) {
+            RemoteTrack track;
+            track.trackId = record.trackId;
+            it = mirror.tracks.insert(record.wireId, track);
+        }
+        applyGroups(it->state, record.groups, record.coded);
+        emit remoteTrackUpdated(connectionId, it->state.toSnapshot(it->trackId));
+    }
+    return true;
+}
+
+void TrackPictureSync::requestResync(const QString& connectionId, Mirror& mirror) {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - mirror.lastResyncRequestMs < RESYNC_REQUEST_INTERVAL_MS) return;
+    mirror.lastResyncRequestMs = now;
+
+    Message msg;
+    msg.type = MessageType::TrackResyncRequest;
+    msg.timestamp = now;
+    msg.sourceId = m_nodeId;
+    m_network->send(connectionId, msg);
+}
+
+} // namespace CounterUAS
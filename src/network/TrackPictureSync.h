@@ -0,0 +1,175 @@
+#ifndef TRACKPICTURESYNC_H
+#define TRACKPICTURESYNC_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QTimer>
+#include "core/TrackChangeSet.h"
+#include "core/TrackSnapshot.h"
+#include "network/NetworkManager.h"
+
+namespace CounterUAS {
+
+class TrackManager;
+class TrackToTrackFusion;
+
+/**
+ * @brief Track state on the sync grid
+ *
+ * Positions are held to 1e-7 deg (about 1 cm), altitude to 0.1 m, velocity
+ * to 0.01 m/s and confidence/quality to 1/255. The position covariance
+ * travels as standard deviations to 0.1 m and the east/north correlation
+ * to 1/127. Sender and receivers keep the same quantized values, so deltas
+ * never drift.
+ */
+struct SyncTrackState {
+    qint32 latitude = 0;
+    qint32 longitude = 0;
+    qint32 altitude = 0;
+    qint32 velocityNorth = 0;
+    qint32 velocityEast = 0;
+    qint32 velocityDown = 0;
+    quint8 classification = 0;
+    quint8 state = 0;
+    quint8 threatLevel = 0;
+    quint8 confidence = 0;
+    quint8 quality = 0;
+    quint8 flags = 0;   // bit 0 visually tracked, bit 1 engaged
+    qint32 sigmaEast = 0;
+    qint32 sigmaNorth = 0;
+    qint32 sigmaUp = 0;
+    qint8 correlation = 0;
+
+    static SyncTrackState fromSnapshot(const TrackSnapshot& track);
+    TrackSnapshot toSnapshot(const QString& trackId) const;
+};
+
+/**
+ * @brief Compact track picture stream between C2 nodes
+ *
+ * The publishing side broadcasts a TrackKeyframe carrying every track, and
+ * then one TrackDelta per track cycle carrying only the tracks, and within
+ * them only the field groups, whose quantized values changed. Ids are
+ * stream-local varints, with the track id string sent once on creation.
+ * Deltas code numeric fields as zigzag varints relative to the last value
+ * sent. A keyframe goes out every keyframe interval, and on request.
+ *
+ * Sync messages use their own sequenceNumber run. A receiver applies a
+ * delta only when its sequence follows the last frame applied. On a gap
+ * it discards deltas, sends TrackResyncRequest to that peer, and waits for
+ * the next keyframe. Each connection holds its own mirror of the remote
+ * picture.
+ *
+ * With a bandwidth limit, deltas draw on a token bucket holding one
+ * second of the limit. Creations and drops always go out; updates go in
+ * descending threat order until the budget is spent, and the held-back
+ * tracks are diffed again next cycle against what peers last received,
+ * so nothing is lost, only late. Keyframes are never held back but are
+ * charged to the bucket.
+ */
+class TrackPictureSync : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TrackPictureSync(NetworkManager* network, QObject* parent = nullptr);
+
+    // Publishes this node's picture; nullptr makes the node receive-only
+    void setTrackManager(TrackManager* trackManager);
+    void setNodeId(const QString& nodeId) { m_nodeId = nodeId; }
+
+    void setKeyframeInterval(int intervalMs);
+    int keyframeInterval() const { return m_keyframeTimer->interval(); }
+
+    // Bytes per second of picture traffic, 0 for no limit
+    void setBandwidthLimit(int bytesPerSecond);
+    int bandwidthLimit() const { return m_bandwidthLimit; }
+
+    // Feeds every peer's tracks to fusion under the node id it publishes as
+    void attachFusion(TrackToTrackFusion* fusion);
+
+    // Forces a keyframe on the next cycle
+    void requestKeyframe() { m_keyframePending = true; }
+
+    // Remote picture as last synced from a connection
+    QList<TrackSnapshot> remoteTracks(const QString& connectionId) const;
+    bool isSynced(const QString& connectionId) const;
+    // Node id the connection's picture is published under
+    QString remoteNodeId(const QString& connectionId) const;
+
+    struct Stats {
+        qint64 keyframesSent = 0;
+        qint64 deltasSent = 0;
+        qint64 bytesSent = 0;
+        qint64 gapsDetected = 0;
+        qint64 updatesDeferred = 0;     // Track updates held back by the bandwidth limit
+    };
+    Stats stats() const { return m_stats; }
+
+signals:
+    void remoteTrackUpdated(const QString& connectionId, const TrackSnapshot& track);
+    void remoteTrackDropped(const QString& connectionId, const QString& trackId);
+    void remotePictureResynced(const QString& connectionId);
+    // After the updates and drops of one keyframe or delta; timestampMs is
+    // the sender's stamp on it
+    void remotePictureApplied(const QString& connectionId, qint64 timestampMs);
+
+private slots:
+    void onTracksChanged(const TrackChangeSet& changes);
+    void onMessageReceived(const QString& connectionId, const Message& message);
+    void onConnectionStatusChanged(const QString& connectionId, ConnectionStatus status);
+    void sendKeyframe();
+
+private:
+    struct SentTrack {
+        quint32 wireId = 0;
+        SyncTrackState state;
+    };
+
+    struct RemoteTrack {
+        QString trackId;
+        SyncTrackState state;
+    };
+
+    struct Mirror {
+        bool synced = false;
+        QString nodeId;
+        quint32 expectedSequence = 0;
+        qint64 lastResyncRequestMs = 0;
+        QHash<quint32, RemoteTrack> tracks;
+    };
+
+    TypedMessage makeMessage(MessageType type, const QByteArray& data);
+    void scheduleKeyframe();
+    void dropMirror(const QString& connectionId);
+    bool applyKeyframe(const QString& connectionId, Mirror& mirror, const QByteArray& data);
+    bool applyDelta(const QString& connectionId, Mirror& mirror, const QByteArray& data);
+    void requestResync(const QString& connectionId, Mirror& mirror);
+    void refillBudget();
+    void chargeBudget(int bytes);
+
+    NetworkManager* m_network;
+    TrackManager* m_trackManager = nullptr;
+    QString m_nodeId = QStringLiteral("C2");
+    QTimer* m_keyframeTimer;
+
+    // Publisher state: what every peer has been told
+    QHash<TrackHandle, SentTrack> m_sent;
+    quint32 m_nextWireId = 1;
+    quint32 m_sequence = 0;
+    bool m_keyframePending = true;
+    qint64 m_latencyIngestNs = 0;   // Newest plot already counted in PipelineLatency
+
+    int m_bandwidthLimit = 0;
+    double m_budgetBytes = 0.0;
+    qint64 m_budgetRefillMs = 0;
+    QSet<TrackHandle> m_deferred;   // Updates the budget held back
+
+    QHash<QString, Mirror> m_mirrors;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKPICTURESYNC_H
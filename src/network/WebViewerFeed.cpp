@@ -0,0 +1,576 @@
+#include "network/WebViewerFeed.h"
+#include "network/TrackPictureSync.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr char WEBSOCKET_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// Opcodes and close codes, RFC 6455
+constexpr quint8 OP_CONTINUATION = 0x0;
+constexpr quint8 OP_TEXT = 0x1;
+constexpr quint8 OP_BINARY = 0x2;
+constexpr quint8 OP_CLOSE = 0x8;
+constexpr quint8 OP_PING = 0x9;
+constexpr quint8 OP_PONG = 0xA;
+constexpr quint16 CLOSE_NORMAL = 1000;
+constexpr quint16 CLOSE_PROTOCOL_ERROR = 1002;
+constexpr quint16 CLOSE_UNSUPPORTED_DATA = 1003;
+constexpr quint16 CLOSE_TOO_BIG = 1009;
+
+constexpr int POSITION_BYTES = 12;
+constexpr int VELOCITY_BYTES = 12;
+constexpr int STATUS_BYTES = 6;
+
+constexpr quint32 STATUS_FIELDS = TrackChangeState | TrackChangeClassification | TrackChangeThreatLevel |
+                                  TrackChangeQuality | TrackChangeVisual | TrackChangeEngagement;
+
+qint64 nowMs() {
+    return TimeUtils::monotonicNs() / 1000000;
+}
+
+quint16 groupsFor(quint32 fields) {
+    using namespace WebViewerWire;
+    quint16 groups = 0;
+    if (fields & TrackChangeCreated) groups |= GROUPS_FULL;
+    if (fields & TrackChangePosition) groups |= GROUP_POSITION;
+    if (fields & TrackChangeVelocity) groups |= GROUP_VELOCITY;
+    if (fields & STATUS_FIELDS) groups |= GROUP_STATUS;
+    if (fields & TrackChangeDropped) groups |= GROUP_REMOVED;
+    return groups;
+}
+
+template <typename T>
+void appendLittleEndian(QByteArray& out, T value) {
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(T));
+}
+
+QByteArray httpResponse(const char* status, const QByteArray& headers = QByteArray()) {
+    QByteArray out;
+    out.append("HTTP/1.1 ").append(status).append("\r\n");
+    out.append(headers);
+    out.append("Content-Length: 0\r\nConnection: close\r\n\r\n");
+    return out;
+}
+
+} // namespace
+
+bool WebViewerFeed::Viewport::contains(const GeoPosition& pos) const {
+    if (all) return true;
+    if (pos.latitude < south || pos.latitude > north) return false;
+    // A viewport across the antimeridian has west > east
+    return west <= east ? pos.longitude >= west && pos.longitude <= east
+                        : pos.longitude >= west || pos.longitude <= east;
+}
+
+WebViewerFeed::WebViewerFeed(QObject* parent)
+    : QObject(parent)
+{
+}
+
+WebViewerFeed::~WebViewerFeed() {
+    stop();
+}
+
+void WebViewerFeed::setConfig(const WebViewerConfig& config) {
+    const bool running = isRunning();
+    if (running) stop();
+    m_config = config;
+    m_config.maxRateHz = qBound(0.1, m_config.maxRateHz, 100.0);
+    if (running) start(m_requestedPort, m_address);
+}
+
+void WebViewerFeed::setTrackManager(TrackManager* trackManager) {
+    m_trackManager = trackManager;
+}
+
+bool WebViewerFeed::start(quint16 port, const QHostAddress& address) {
+    if (m_thread) return true;
+    if (!m_trackManager) {
+        m_error = "No track manager";
+        return false;
+    }
+    m_requestedPort = port;
+    m_address = address;
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("WebViewerFeed");
+    m_context = new QObject;
+    m_context->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread->start();
+
+    bool listening = false;
+    QMetaObject::invokeMethod(m_context, [this, port, address, &listening]() {
+        QTcpServer* server = new QTcpServer(m_context);
+        if (!server->listen(address, port)) {
+            m_error = server->errorString();
+            delete server;
+            return;
+        }
+        m_port = server->serverPort();
+        connect(server, &QTcpServer::newConnection, m_context, [this, server]() {
+            while (server->hasPendingConnections()) {
+                serve(server->nextPendingConnection());
+            }
+        });
+
+        // Queued from the manager's thread, which does nothing more for us
+        connect(m_trackManager, &TrackManager::tracksChanged, m_context,
+                [this](const TrackChangeSet& changes) { onTracksChanged(changes); });
+        QTimer* tick = new QTimer(m_context);
+        tick->setInterval(TICK_MS);
+        connect(tick, &QTimer::timeout, m_context, [this]() { onTick(); });
+        tick->start();
+        m_lastPingMs = nowMs();
+        listening = true;
+    }, Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        Logger::instance().error("WebViewerFeed",
+                                 QString("Cannot listen on port %1: %2").arg(port).arg(m_error));
+        stop();
+        return false;
+    }
+    m_error.clear();
+    Logger::instance().info("WebViewerFeed",
+                            QString("Track picture at ws://<host>:%1/%2").arg(m_port).arg(m_config.path));
+    return true;
+}
+
+void WebViewerFeed::stop() {
+    if (!m_thread) return;
+
+    // The server, timer and open connections go with the context
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_context = nullptr;
+    m_port = 0;
+
+    m_viewerLinks.clear();
+    m_picture.reset();
+    m_records.clear();
+    m_viewers = 0;
+}
+
+WebViewerStats WebViewerFeed::stats() const {
+    WebViewerStats s;
+    s.viewers = m_viewers.load(std::memory_order_relaxed);
+    s.keyframesSent = m_keyframesSent.load(std::memory_order_relaxed);
+    s.deltasSent = m_deltasSent.load(std::memory_order_relaxed);
+    s.bytesSent = m_bytesSent.load(std::memory_order_relaxed);
+    s.updatesDeferred = m_updatesDeferred.load(std::memory_order_relaxed);
+    s.viewersRejected = m_viewersRejected.load(std::memory_order_relaxed);
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// Server thread
+
+void WebViewerFeed::serve(QTcpSocket* socket) {
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    Viewer viewer;
+    viewer.socket = socket;
+    viewer.intervalMs = static_cast<int>(std::ceil(1000.0 / m_config.maxRateHz));
+    viewer.lastHeardMs = nowMs();
+    m_viewerLinks.insert(socket, viewer);
+
+    connect(socket, &QTcpSocket::readyRead, m_context, [this, socket]() { onReadyRead(socket); });
+    // Queued, so a viewer is never dropped while one of its frames is handled
+    connect(socket, &QTcpSocket::disconnected, m_context, [this, socket]() {
+        dropViewer(socket);
+        socket->deleteLater();
+    }, Qt::QueuedConnection);
+}
+
+void WebViewerFeed::dropViewer(QTcpSocket* socket) {
+    auto it = m_viewerLinks.find(socket);
+    if (it == m_viewerLinks.end()) return;
+    if (it->upgraded) m_viewers.fetch_sub(1, std::memory_order_relaxed);
+    m_viewerLinks.erase(it);
+}
+
+void WebViewerFeed::onReadyRead(QTcpSocket* socket) {
+    auto it = m_viewerLinks.find(socket);
+    if (it == m_viewerLinks.end()) return;
+    Viewer& viewer = *it;
+    if (viewer.closing) {
+        socket->readAll();
+        return;
+    }
+    viewer.input.append(socket->readAll());
+    viewer.lastHeardMs = nowMs();
+
+    if (!viewer.upgraded) {
+        const int end = viewer.input.indexOf("\r\n\r\n");
+        if (end < 0) {
+            if (viewer.input.size() > MAX_REQUEST_BYTES) {
+                m_viewersRejected.fetch_add(1, std::memory_order_relaxed);
+                socket->abort();
+            }
+            return;
+        }
+        const QByteArray request = viewer.input.left(end);
+        viewer.input.remove(0, end + 4);
+        if (!handshake(viewer, request)) return;
+    }
+    readFrames(viewer);
+}
+
+bool WebViewerFeed::handshake(Viewer& viewer, const QByteArray& request) {
+    const QList<QByteArray> lines = request.split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    QHash<QByteArray, QByteArray> headers;
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines[i].indexOf(':');
+        if (colon > 0) headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+    }
+
+    auto reject = [this, &viewer](const QByteArray& response) {
+        m_viewersRejected.fetch_add(1, std::memory_order_relaxed);
+        viewer.closing = true;
+        viewer.socket->write(response);
+        viewer.socket->disconnectFromHost();
+        return false;
+    };
+
+    if (requestLine.size() < 3 || requestLine[0] != "GET") {
+        return reject(httpResponse("405 Method Not Allowed"));
+    }
+    QString path = QString::fromUtf8(requestLine[1]);
+    const int query = path.indexOf('?');
+    if (query >= 0) path.truncate(query);
+    while (path.startsWith('/')) path.remove(0, 1);
+    while (path.endsWith('/')) path.chop(1);
+    if (path != m_config.path) {
+        return reject(httpResponse("404 Not Found"));
+    }
+
+    const QByteArray key = headers.value("sec-websocket-key");
+    if (!headers.value("upgrade").toLower().contains("websocket") ||
+        !headers.value("connection").toLower().contains("upgrade") ||
+        headers.value("sec-websocket-version") != "13" || key.isEmpty()) {
+        return reject(httpResponse("426 Upgrade Required", "Sec-WebSocket-Version: 13\r\n"));
+    }
+    if (m_viewers.load(std::memory_order_relaxed) >= m_config.maxViewers) {
+        return reject(httpResponse("503 Service Unavailable"));
+    }
+
+    const QByteArray accept = QCryptographicHash::hash(key + WEBSOCKET_GUID, QCryptographicHash::Sha1).toBase64();
+    QByteArray response("HTTP/1.1 101 Switching Protocols\r\n"
+                        "Upgrade: websocket\r\n"
+                        "Connection: Upgrade\r\n");
+    response.append("Sec-WebSocket-Accept: ").append(accept).append("\r\n\r\n");
+    viewer.socket->write(response);
+    viewer.upgraded = true;
+    m_viewers.fetch_add(1, std::memory_order_relaxed);
+
+    // The keyframe goes out at once
+    flush(viewer, nowMs());
+    return true;
+}
+
+bool WebViewerFeed::readFrames(Viewer& viewer) {
+    const QByteArray& in = viewer.input;
+    const char* data = in.constData();
+    int pos = 0;
+    while (!viewer.closing && in.size() - pos >= 2) {
+        const quint8 b0 = static_cast<quint8>(data[pos]);
+        const quint8 b1 = static_cast<quint8>(data[pos + 1]);
+        const bool fin = b0 & 0x80;
+        const quint8 opcode = b0 & 0x0f;
+        // No extensions are negotiated, and a viewer's frames are masked
+        if ((b0 & 0x70) || !(b1 & 0x80)) {
+            close(viewer, CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+
+        quint64 length = b1 & 0x7f;
+        int headerSize = 2;
+        if (length == 126) {
+            if (in.size() - pos < 4) break;
+            length = qFromBigEndian<quint16>(data + pos + 2);
+            headerSize = 4;
+        } else if (length == 127) {
+            if (in.size() - pos < 10) break;
+            length = qFromBigEndian<quint64>(data + pos + 2);
+            headerSize = 10;
+        }
+        const bool control = opcode & 0x08;
+        if (control && (!fin || length > 125)) {
+            close(viewer, CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+        if (length > static_cast<quint64>(MAX_MESSAGE_BYTES)) {
+            close(viewer, CLOSE_TOO_BIG);
+            return false;
+        }
+        if (in.size() - pos < headerSize + 4 + static_cast<int>(length)) break;
+
+        const char* mask = data + pos + headerSize;
+        QByteArray payload(mask + 4, static_cast<int>(length));
+        for (int i = 0; i < payload.size(); ++i) {
+            payload[i] = static_cast<char>(payload[i] ^ mask[i & 3]);
+        }
+        pos += headerSize + 4 + static_cast<int>(length);
+
+        switch (opcode) {
+            case OP_TEXT:
+            case OP_CONTINUATION:
+                if ((opcode == OP_TEXT) == viewer.fragmented) {
+                    close(viewer, CLOSE_PROTOCOL_ERROR);
+                    return false;
+                }
+                viewer.fragments.append(payload);
+                viewer.fragmented = !fin;
+                if (viewer.fragments.size() > MAX_MESSAGE_BYTES) {
+                    close(viewer, CLOSE_TOO_BIG);
+                    return false;
+                }
+                if (fin) {
+                    const QByteArray text = viewer.fragments;
+                    viewer.fragments.clear();
+                    onMessage(viewer, text);
+                }
+                break;
+            case OP_BINARY:
+                close(viewer, CLOSE_UNSUPPORTED_DATA);
+                return false;
+            case OP_CLOSE:
+                close(viewer, payload.size() >= 2 ? qFromBigEndian<quint16>(payload.constData())
+                                                  : CLOSE_NORMAL);
+                return false;
+            case OP_PING:
+                sendFrame(viewer, OP_PONG, payload);
+                break;
+            case OP_PONG:
+                break;
+            default:
+                close(viewer, CLOSE_PROTOCOL_ERROR);
+                return false;
+        }
+    }
+    viewer.input.remove(0, pos);
+    return !viewer.closing;
+}
+
+void WebViewerFeed::onMessage(Viewer& viewer, const QByteArray& text) {
+    const QJsonObject message = QJsonDocument::fromJson(text).object();
+    if (message.contains("viewport")) {
+        const QJsonValue value = message.value("viewport");
+        const QJsonArray bounds = value.toArray();
+        if (value.isNull()) {
+            viewer.viewport = Viewport();
+        } else if (bounds.size() == 4 && bounds[0].toDouble() <= bounds[2].toDouble()) {
+            viewer.viewport.all = false;
+            viewer.viewport.south = bounds[0].toDouble();
+            viewer.viewport.west = bounds[1].toDouble();
+            viewer.viewport.north = bounds[2].toDouble();
+            viewer.viewport.east = bounds[3].toDouble();
+        }
+        // Whatever it had is replaced
+        viewer.keyframeWanted = true;
+    }
+    const double rateHz = message.value("rateHz").toDouble();
+    if (rateHz > 0.0) {
+        viewer.intervalMs = static_cast<int>(std::ceil(1000.0 / qMin(rateHz, m_config.maxRateHz)));
+    }
+    flush(viewer, nowMs());
+}
+
+void WebViewerFeed::onTracksChanged(const TrackChangeSet& changes) {
+    if (m_viewerLinks.isEmpty()) return;
+
+    for (Viewer& viewer : m_viewerLinks) {
+        if (!viewer.upgraded || viewer.keyframeWanted) continue;
+        for (int i = 0; i < changes.size(); ++i) {
+            const quint16 groups = groupsFor(changes.fields[i]);
+            if (groups) viewer.pending[changes.handles[i]] |= groups;
+        }
+    }
+    const qint64 now = nowMs();
+    for (Viewer& viewer : m_viewerLinks) {
+        flush(viewer, now);
+    }
+}
+
+void WebViewerFeed::onTick() {
+    const qint64 now = nowMs();
+    const bool ping = now - m_lastPingMs >= m_config.pingIntervalMs;
+    if (ping) m_lastPingMs = now;
+
+    for (Viewer& viewer : m_viewerLinks) {
+        if (viewer.closing) continue;
+        if (ping) {
+            // Three pings unanswered, or a handshake that never came
+            const qint64 limitMs = viewer.upgraded ? 3LL * m_config.pingIntervalMs : m_config.pingIntervalMs;
+            if (now - viewer.lastHeardMs > limitMs) {
+                viewer.closing = true;
+                viewer.socket->abort();
+                continue;
+            }
+            if (viewer.upgraded) sendFrame(viewer, OP_PING, QByteArray());
+        }
+        flush(viewer, now);
+    }
+}
+
+void WebViewerFeed::flush(Viewer& viewer, qint64 nowMs) {
+    using namespace WebViewerWire;
+    if (!viewer.upgraded || viewer.closing) return;
+    if (!viewer.keyframeWanted && viewer.pending.isEmpty()) return;
+    if (viewer.lastSentMs >= 0 && nowMs - viewer.lastSentMs < viewer.intervalMs) return;
+    if (viewer.socket->bytesToWrite() > m_config.maxBacklogBytes) {
+        m_updatesDeferred.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    refreshPicture();
+    m_message.resize(HEADER_SIZE);
+    quint32 count = 0;
+    const bool keyframe = viewer.keyframeWanted;
+    if (keyframe) {
+        viewer.known.clear();
+        for (const TrackSnapshot& track : m_picture->tracks) {
+            if (!viewer.viewport.contains(track.position)) continue;
+            appendRecord(m_message, track.handle, GROUPS_FULL, &track);
+            viewer.known.insert(track.handle);
+            ++count;
+        }
+        viewer.keyframeWanted = false;
+    } else {
+        for (auto it = viewer.pending.constBegin(); it != viewer.pending.constEnd(); ++it) {
+            const TrackHandle handle = it.key();
+            const TrackSnapshot* track = m_picture->find(handle);
+            const bool inView = track && viewer.viewport.contains(track->position);
+            const bool known = viewer.known.contains(handle);
+            if (inView) {
+                // Entering the viewport counts as created
+                quint16 groups = known ? it.value() & (GROUP_POSITION | GROUP_VELOCITY | GROUP_STATUS)
+                                       : GROUPS_FULL;
+                if (!groups) continue;
+                if (!known) viewer.known.insert(handle);
+                appendRecord(m_message, handle, groups, track);
+            } else if (known) {
+                appendRecord(m_message, handle, GROUP_REMOVED, nullptr);
+                viewer.known.remove(handle);
+            } else {
+                continue;
+            }
+            ++count;
+        }
+    }
+    viewer.pending.clear();
+    if (!keyframe && count == 0) return;
+
+    char* header = m_message.data();
+    std::memset(header, 0, HEADER_SIZE);
+    header[0] = static_cast<char>(keyframe ? KEYFRAME : DELTA);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_picture->sequence), header + 4);
+    qToLittleEndian<quint32>(count, header + 8);
+    const double timestampMs = static_cast<double>(m_picture->timestampMs);
+    quint64 timestampBits;
+    std::memcpy(&timestampBits, &timestampMs, sizeof(timestampBits));
+    qToLittleEndian<quint64>(timestampBits, header + 12);
+
+    sendFrame(viewer, OP_BINARY, m_message);
+    viewer.lastSentMs = nowMs;
+    (keyframe ? m_keyframesSent : m_deltasSent).fetch_add(1, std::memory_order_relaxed);
+}
+
+void WebViewerFeed::sendFrame(Viewer& viewer, quint8 opcode, const QByteArray& payload) {
+    char header[10];
+    int headerSize = 2;
+    header[0] = static_cast<char>(0x80 | opcode);
+    if (payload.size() < 126) {
+        header[1] = static_cast<char>(payload.size());
+    } else if (payload.size() <= 0xffff) {
+        header[1] = 126;
+        qToBigEndian<quint16>(static_cast<quint16>(payload.size()), header + 2);
+        headerSize = 4;
+    } else {
+        header[1] = 127;
+        qToBigEndian<quint64>(static_cast<quint64>(payload.size()), header + 2);
+        headerSize = 10;
+    }
+    viewer.socket->write(header, headerSize);
+    viewer.socket->write(payload);
+    m_bytesSent.fetch_add(headerSize + payload.size(), std::memory_order_relaxed);
+}
+
+void WebViewerFeed::close(Viewer& viewer, quint16 code) {
+    char payload[2];
+    qToBigEndian<quint16>(code, payload);
+    sendFrame(viewer, OP_CLOSE, QByteArray(payload, sizeof(payload)));
+    viewer.closing = true;
+    viewer.socket->disconnectFromHost();
+}
+
+void WebViewerFeed::refreshPicture() {
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    if (m_picture && picture->sequence == m_picture->sequence) return;
+    m_picture = std::move(picture);
+    m_records.clear();
+}
+
+const QByteArray& WebViewerFeed::recordBody(const TrackSnapshot& track) {
+    auto it = m_records.find(track.handle);
+    if (it != m_records.end()) return *it;
+
+    // Every group, in wire order; records take the slices they name
+    const SyncTrackState s = SyncTrackState::fromSnapshot(track);
+    const QByteArray id = track.trackId.toUtf8().left(255);
+    QByteArray body;
+    body.reserve(1 + id.size() + POSITION_BYTES + VELOCITY_BYTES + STATUS_BYTES);
+    body.append(static_cast<char>(id.size()));
+    body.append(id);
+    appendLittleEndian<qint32>(body, s.latitude);
+    appendLittleEndian<qint32>(body, s.longitude);
+    appendLittleEndian<qint32>(body, s.altitude);
+    appendLittleEndian<qint32>(body, s.velocityNorth);
+    appendLittleEndian<qint32>(body, s.velocityEast);
+    appendLittleEndian<qint32>(body, s.velocityDown);
+    body.append(static_cast<char>(s.state));
+    body.append(static_cast<char>(s.classification));
+    body.append(static_cast<char>(s.confidence));
+    body.append(static_cast<char>(s.threatLevel));
+    body.append(static_cast<char>(s.quality));
+    body.append(static_cast<char>(s.flags));
+    return *m_records.insert(track.handle, body);
+}
+
+void WebViewerFeed::appendRecord(QByteArray& out, TrackHandle handle, quint16 groups, const TrackSnapshot* track) {
+    using namespace WebViewerWire;
+    appendLittleEndian<quint32>(out, handle);
+    appendLittleEndian<quint16>(out, groups);
+    if (!track) return;
+
+    const QByteArray& body = recordBody(*track);
+    const int idBytes = 1 + static_cast<quint8>(body.at(0));
+    const char* data = body.constData();
+    if (groups & GROUP_CREATED) out.append(data, idBytes);
+    if (groups & GROUP_POSITION) out.append(data + idBytes, POSITION_BYTES);
+    if (groups & GROUP_VELOCITY) out.append(data + idBytes + POSITION_BYTES, VELOCITY_BYTES);
+    if (groups & GROUP_STATUS) out.append(data + idBytes + POSITION_BYTES + VELOCITY_BYTES, STATUS_BYTES);
+}
+
+} // namespace CounterUAS
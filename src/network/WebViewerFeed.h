@@ -0,0 +1,186 @@
+#ifndef WEBVIEWERFEED_H
+#define WEBVIEWERFEED_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QSet>
+#include <QString>
+#include <atomic>
+#include "core/TrackChangeSet.h"
+#include "core/TrackSnapshot.h"
+
+class QThread;
+class QTcpSocket;
+
+namespace CounterUAS {
+
+class TrackManager;
+
+/**
+ * @brief Browser viewer feed configuration
+ */
+struct WebViewerConfig {
+    QString path = "tracks";            // ws://host:port/<path>
+    int maxViewers = 128;
+    double maxRateHz = 10.0;            // Ceiling on each viewer's updates; a viewer may ask for fewer
+    int maxBacklogBytes = 256 * 1024;   // Unsent bytes past which a viewer's updates wait and coalesce
+    int pingIntervalMs = 15000;         // Keep-alive; a viewer silent for three is dropped
+};
+
+/**
+ * @brief Viewer feed counters, safe to read from any thread
+ */
+struct WebViewerStats {
+    int viewers = 0;
+    quint64 keyframesSent = 0;
+    quint64 deltasSent = 0;
+    quint64 bytesSent = 0;
+    quint64 updatesDeferred = 0;        // Sends held back by a viewer's backlog
+    quint64 viewersRejected = 0;        // Bad handshakes and viewers past maxViewers
+};
+
+/**
+ * @brief Binary messages of the viewer feed, little endian for DataView
+ *
+ * Message: type(1) reserved(3) sequence(4) count(4) timestampMs(8, double),
+ * then count records. Record: handle(4) groups(2), then the groups it
+ * names, in bit order:
+ *   Created  id length(1), UTF-8 id
+ *   Position latitude, longitude (int32, 1e-7 deg), altitude (int32, 0.1 m)
+ *   Velocity north, east, down (int32, 0.01 m/s)
+ *   Status   state, classification, confidence (1/255), threat level,
+ *            quality (1/255), flags (bit 0 visually tracked, bit 1 engaged)
+ * A Removed record has no payload: the track dropped or left the viewport.
+ * A keyframe replaces the viewer's picture; every record in it is full.
+ *
+ * The viewer may send text messages of JSON: {"viewport": [south, west,
+ * north, east]} in degrees, or null for everything, and {"rateHz": n}.
+ */
+namespace WebViewerWire {
+constexpr quint8 KEYFRAME = 1;
+constexpr quint8 DELTA = 2;
+constexpr int HEADER_SIZE = 20;
+constexpr int RECORD_HEADER_SIZE = 6;
+constexpr quint16 GROUP_CREATED = 1u << 0;
+constexpr quint16 GROUP_POSITION = 1u << 1;
+constexpr quint16 GROUP_VELOCITY = 1u << 2;
+constexpr quint16 GROUP_STATUS = 1u << 3;
+constexpr quint16 GROUP_REMOVED = 1u << 15;
+constexpr quint16 GROUPS_FULL = GROUP_CREATED | GROUP_POSITION | GROUP_VELOCITY | GROUP_STATUS;
+}
+
+/**
+ * @brief WebSocket feed of the track picture for remote browser viewers
+ *
+ * Viewers open ws://host:port/<path> and get a keyframe of the current
+ * picture, then a delta per track cycle carrying only the tracks, and the
+ * field groups of them, that changed. Each viewer can narrow the feed to a
+ * viewport, and tracks entering it arrive in full while those leaving are
+ * removed; a new viewport gets a new keyframe.
+ *
+ * The track manager's thread only posts its per-cycle change set here.
+ * The server and its connections live on their own thread, like
+ * MetricsExporter's, and read the lock-free published picture. Each
+ * track's record is encoded once per picture and copied into every
+ * viewer's message, so a hundred viewers cost memory copies, not
+ * encodes. A viewer past its rate, or whose unsent backlog exceeds
+ * maxBacklogBytes, has its changes merged until it is due, so a slow link
+ * gets fewer, larger deltas rather than a growing queue.
+ */
+class WebViewerFeed : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_REQUEST_BYTES = 8192;
+    static constexpr int MAX_MESSAGE_BYTES = 4096;  // From a viewer
+    static constexpr int TICK_MS = 20;              // Rate-held viewers are retried this often
+
+    explicit WebViewerFeed(QObject* parent = nullptr);
+    ~WebViewerFeed() override;
+
+    // Before start(); a running feed restarts and viewers reconnect
+    void setConfig(const WebViewerConfig& config);
+    WebViewerConfig config() const { return m_config; }
+    void setTrackManager(TrackManager* trackManager);
+
+    // Port 0 binds any free port; port() then tells which
+    bool start(quint16 port, const QHostAddress& address = QHostAddress::Any);
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+    quint16 port() const { return m_port; }
+    QString errorString() const { return m_error; }
+
+    int viewerCount() const { return m_viewers.load(std::memory_order_relaxed); }
+    WebViewerStats stats() const;
+
+private:
+    struct Viewport {
+        bool all = true;
+        double south = 0.0, west = 0.0, north = 0.0, east = 0.0;
+        bool contains(const GeoPosition& pos) const;
+    };
+
+    struct Viewer {
+        QTcpSocket* socket = nullptr;
+        QByteArray input;
+        QByteArray fragments;           // Of a text message still arriving
+        bool fragmented = false;
+        bool upgraded = false;
+        bool closing = false;
+        Viewport viewport;
+        int intervalMs = 0;
+        qint64 lastSentMs = -1;
+        qint64 lastHeardMs = 0;
+        bool keyframeWanted = true;
+        QHash<TrackHandle, quint16> pending;    // Groups changed since the last send
+        QSet<TrackHandle> known;                // Tracks in the viewer's picture
+    };
+
+    // Server thread
+    void serve(QTcpSocket* socket);
+    void dropViewer(QTcpSocket* socket);
+    void onReadyRead(QTcpSocket* socket);
+    bool handshake(Viewer& viewer, const QByteArray& request);
+    bool readFrames(Viewer& viewer);
+    void onMessage(Viewer& viewer, const QByteArray& text);
+    void onTracksChanged(const TrackChangeSet& changes);
+    void onTick();
+    void flush(Viewer& viewer, qint64 nowMs);
+    void sendFrame(Viewer& viewer, quint8 opcode, const QByteArray& payload);
+    void close(Viewer& viewer, quint16 code);
+
+    // Records of the current picture, encoded once per picture
+    void refreshPicture();
+    const QByteArray& recordBody(const TrackSnapshot& track);
+    void appendRecord(QByteArray& out, TrackHandle handle, quint16 groups, const TrackSnapshot* track);
+
+    WebViewerConfig m_config;           // Fixed while the thread runs
+    TrackManager* m_trackManager = nullptr;
+
+    QThread* m_thread = nullptr;
+    QObject* m_context = nullptr;       // Lives on m_thread, parents the server, sockets and timer
+    quint16 m_port = 0;
+    quint16 m_requestedPort = 0;        // For a restart
+    QHostAddress m_address;
+    QString m_error;
+
+    // Server thread
+    QHash<QTcpSocket*, Viewer> m_viewerLinks;
+    TrackPicturePtr m_picture;
+    QHash<TrackHandle, QByteArray> m_records;   // For m_picture
+    QByteArray m_message;                       // Scratch
+    qint64 m_lastPingMs = 0;
+
+    std::atomic<int> m_viewers{0};
+    std::atomic<quint64> m_keyframesSent{0};
+    std::atomic<quint64> m_deltasSent{0};
+    std::atomic<quint64> m_bytesSent{0};
+    std::atomic<quint64> m_updatesDeferred{0};
+    std::atomic<quint64> m_viewersRejected{0};
+};
+
+} // namespace CounterUAS
+
+#endif // WEBVIEWERFEED_H
@@ -0,0 +1,326 @@
+#include "sensors/AdsbDecoder.h"
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint8 BEAST_ESCAPE = 0x1a;
+constexpr double FEET_TO_M = 0.3048;
+constexpr double KNOTS_TO_MPS = 0.514444;
+constexpr double FPM_TO_MPS = FEET_TO_M / 60.0;
+constexpr double CPR_SCALE = 131072.0;          // 2^17
+constexpr int SBS_MAX_FIELDS = 22;
+
+const char CALLSIGN_CHARSET[] =
+    "#ABCDEFGHIJKLMNOPQRSTUVWXYZ##### ###############0123456789######";
+
+struct Crc24Table {
+    quint32 entries[256];
+    Crc24Table() {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 crc = i << 16;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x800000) ? (crc << 1) ^ 0xFFF409 : crc << 1;
+            }
+            entries[i] = crc & 0xFFFFFF;
+        }
+    }
+};
+
+const Crc24Table& crc24Table() {
+    static const Crc24Table table;
+    return table;
+}
+
+// Beast message length for a frame type; 0 for none
+int beastMessageLength(quint8 type) {
+    switch (type) {
+    case '1': return 2;     // Mode A/C
+    case '2': return 7;     // Mode S short
+    case '3': return 14;    // Mode S long
+    case '4': return 14;    // Receiver status
+    default:  return 0;
+    }
+}
+
+quint64 fnv1a(const quint8* data, int size, quint64 hash = 0xcbf29ce484222325ULL) {
+    for (int i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Longitude zones at a latitude, NZ = 15
+int cprNL(double latitude) {
+    latitude = std::fabs(latitude);
+    if (latitude < 1e-9) return 59;
+    if (latitude > 87.0) return 1;
+    if (latitude == 87.0) return 2;
+    const double a = 1.0 - std::cos(M_PI / 30.0);
+    const double c = std::cos(qDegreesToRadians(latitude));
+    return static_cast<int>(std::floor(2.0 * M_PI / std::acos(1.0 - a / (c * c))));
+}
+
+double positiveMod(double x, double y) {
+    return x - y * std::floor(x / y);
+}
+
+bool parseDouble(const char* data, int size, double& value) {
+    if (size <= 0) return false;
+    bool ok = false;
+    value = QByteArray::fromRawData(data, size).toDouble(&ok);
+    return ok;
+}
+
+} // namespace
+
+void AdsbDecoder::appendBeast(const char* data, int size) {
+    if (m_beastPos > 0 && m_beastPos == m_beast.size()) {
+        m_beast.clear();
+        m_beastPos = 0;
+    }
+    // A stream that never frames must not grow without bound
+    if (m_beast.size() - m_beastPos + size > MAX_BUFFER_BYTES) {
+        m_discardedBytes += m_beast.size() - m_beastPos;
+        m_beast.clear();
+        m_beastPos = 0;
+    }
+    m_beast.append(data, size);
+}
+
+bool AdsbDecoder::nextBeast(const quint8*& message, int& length) {
+    const quint8* data = reinterpret_cast<const quint8*>(m_beast.constData());
+    const int size = m_beast.size();
+
+    while (m_beastPos < size) {
+        if (data[m_beastPos] != BEAST_ESCAPE) {
+            ++m_beastPos;
+            ++m_discardedBytes;
+            continue;
+        }
+        if (m_beastPos + 1 >= size) break;
+
+        const int messageLength = beastMessageLength(data[m_beastPos + 1]);
+        if (messageLength == 0) {
+            ++m_beastPos;
+            ++m_discardedBytes;
+            continue;
+        }
+
+        // Unescape timestamp, signal level and message
+        const int wanted = 7 + messageLength;
+        int got = 0;
+        int p = m_beastPos + 2;
+        bool broken = false;
+        while (got < wanted && p < size) {
+            if (data[p] == BEAST_ESCAPE) {
+                if (p + 1 >= size) break;
+                if (data[p + 1] != BEAST_ESCAPE) {
+                    broken = true;      // A new frame began inside this one
+                    break;
+                }
+                ++p;
+            }
+            m_frame[got++] = data[p++];
+        }
+        if (broken) {
+            m_discardedBytes += p - m_beastPos;
+            m_beastPos = p;
+            continue;
+        }
+        if (got < wanted) break;
+
+        const bool status = data[m_beastPos + 1] == '4';
+        m_beastPos = p;
+        if (status) continue;
+        message = m_frame + 7;
+        length = messageLength;
+        return true;
+    }
+
+    // Keep only the incomplete tail
+    if (m_beastPos > 0) {
+        m_beast.remove(0, m_beastPos);
+        m_beastPos = 0;
+    }
+    return false;
+}
+
+void AdsbDecoder::clear() {
+    m_beast.clear();
+    m_beastPos = 0;
+}
+
+quint32 AdsbDecoder::crc24(const quint8* data, int length) {
+    const Crc24Table& table = crc24Table();
+    quint32 crc = 0;
+    for (int i = 0; i < length; ++i) {
+        crc = ((crc << 8) ^ table.entries[((crc >> 16) ^ data[i]) & 0xFF]) & 0xFFFFFF;
+    }
+    return crc;
+}
+
+bool AdsbDecoder::decodeModeS(const quint8* message, int length, AdsbMessage& out) {
+    if (length != 14) return false;
+    const int df = message[0] >> 3;
+    if (df != 17 && df != 18) return false;
+    const quint32 parity = (quint32(message[11]) << 16) | (quint32(message[12]) << 8) | message[13];
+    if (crc24(message, 11) != parity) return false;
+
+    out = AdsbMessage();
+    out.icao = (quint32(message[1]) << 16) | (quint32(message[2]) << 8) | message[3];
+    out.payloadHash = fnv1a(message, length);
+
+    const quint8* me = message + 4;
+    const int typeCode = me[0] >> 3;
+
+    if (typeCode >= 1 && typeCode <= 4) {
+        quint64 chars = 0;
+        for (int i = 1; i <= 6; ++i) chars = (chars << 8) | me[i];
+        char callsign[8];
+        int used = 0;
+        for (int k = 0; k < 8; ++k) {
+            const char c = CALLSIGN_CHARSET[(chars >> (42 - 6 * k)) & 0x3F];
+            if (c != '#' && c != ' ') callsign[used++] = c;
+        }
+        out.callsign = QString::fromLatin1(callsign, used);
+        out.hasCallsign = used > 0;
+        return true;
+    }
+
+    if (typeCode >= 9 && typeCode <= 18) {
+        const int altitudeCode = (me[1] << 4) | (me[2] >> 4);
+        if (altitudeCode & 0x10) {
+            // 25 ft steps; Gillham-coded 100 ft altitudes are not decoded
+            const int n = ((altitudeCode & 0xFE0) >> 1) | (altitudeCode & 0x0F);
+            out.altitudeM = (n * 25 - 1000) * FEET_TO_M;
+            out.hasAltitude = true;
+        }
+        out.cprOdd = (me[2] >> 2) & 1;
+        out.cprLatitude = ((me[2] & 0x03) << 15) | (me[3] << 7) | (me[4] >> 1);
+        out.cprLongitude = ((me[4] & 0x01) << 16) | (me[5] << 8) | me[6];
+        out.hasCpr = true;
+        return true;
+    }
+
+    if (typeCode == 19) {
+        const int subtype = me[0] & 0x07;
+        if (subtype != 1 && subtype != 2) return true;   // Airspeed, not ground velocity
+
+        const bool west = (me[1] >> 2) & 1;
+        const int eastWest = ((me[1] & 0x03) << 8) | me[2];
+        const bool south = (me[3] >> 7) & 1;
+        const int northSouth = ((me[3] & 0x7F) << 3) | (me[4] >> 5);
+        const bool descending = (me[4] >> 3) & 1;
+        const int verticalRate = ((me[4] & 0x07) << 6) | (me[5] >> 2);
+        if (eastWest == 0 || northSouth == 0) return true;   // Not available
+
+        const double scale = (subtype == 2 ? 4.0 : 1.0) * KNOTS_TO_MPS;   // Supersonic in 4 kt steps
+        out.velocity.east = (eastWest - 1) * scale * (west ? -1.0 : 1.0);
+        out.velocity.north = (northSouth - 1) * scale * (south ? -1.0 : 1.0);
+        out.velocity.down = verticalRate > 0
+            ? (verticalRate - 1) * 64.0 * FPM_TO_MPS * (descending ? 1.0 : -1.0) : 0.0;
+        out.hasVelocity = true;
+        return true;
+    }
+
+    return true;
+}
+
+bool AdsbDecoder::decodeSbs(const char* line, int length, AdsbMessage& out) {
+    while (length > 0 && (line[length - 1] == '\r' || line[length - 1] == '\n')) --length;
+    if (length < 4 || std::memcmp(line, "MSG,", 4) != 0) return false;
+
+    int starts[SBS_MAX_FIELDS];
+    int sizes[SBS_MAX_FIELDS];
+    int fields = 0;
+    for (int start = 0; fields < SBS_MAX_FIELDS;) {
+        int end = start;
+        while (end < length && line[end] != ',') ++end;
+        starts[fields] = start;
+        sizes[fields] = end - start;
+        ++fields;
+        if (end >= length) break;
+        start = end + 1;
+    }
+    if (fields < 11 || sizes[1] != 1 || sizes[4] != 6) return false;
+    auto field = [&](int i) { return line + starts[i]; };
+    auto fieldSize = [&](int i) { return i < fields ? sizes[i] : 0; };
+
+    const char type = field(1)[0];
+    if (type < '1' || type > '4') return false;
+
+    bool ok = false;
+    const quint32 icao = QByteArray::fromRawData(field(4), 6).toUInt(&ok, 16);
+    if (!ok) return false;
+
+    out = AdsbMessage();
+    out.icao = icao;
+    // Transmission type, address and the reported values, but not the
+    // feed's own logging timestamps
+    const quint8* bytes = reinterpret_cast<const quint8*>(line);
+    out.payloadHash = fnv1a(bytes + starts[1], 1);
+    out.payloadHash = fnv1a(bytes + starts[4], 6, out.payloadHash);
+    out.payloadHash = fnv1a(bytes + starts[10], length - starts[10], out.payloadHash);
+
+    double value = 0.0;
+    if (type == '1') {
+        int used = fieldSize(10);
+        while (used > 0 && field(10)[used - 1] == ' ') --used;
+        out.callsign = QString::fromLatin1(field(10), used);
+        out.hasCallsign = used > 0;
+    }
+    if (parseDouble(field(11), fieldSize(11), value)) {
+        out.altitudeM = value * FEET_TO_M;
+        out.hasAltitude = true;
+    }
+    double latitude = 0.0, longitude = 0.0;
+    if (fields > 15 && parseDouble(field(14), fieldSize(14), latitude) &&
+        parseDouble(field(15), fieldSize(15), longitude)) {
+        out.latitude = latitude;
+        out.longitude = longitude;
+        out.hasPosition = true;
+    }
+    double speed = 0.0, track = 0.0;
+    if (fields > 13 && parseDouble(field(12), fieldSize(12), speed) &&
+        parseDouble(field(13), fieldSize(13), track)) {
+        const double mps = speed * KNOTS_TO_MPS;
+        out.velocity.north = mps * std::cos(qDegreesToRadians(track));
+        out.velocity.east = mps * std::sin(qDegreesToRadians(track));
+        if (fields > 16 && parseDouble(field(16), fieldSize(16), value)) {
+            out.velocity.down = -value * FPM_TO_MPS;
+        }
+        out.hasVelocity = true;
+    }
+    return true;
+}
+
+bool AdsbDecoder::decodeCprLocal(double referenceLatitude, double referenceLongitude, bool odd,
+                                 int cprLatitude, int cprLongitude,
+                                 double& latitude, double& longitude) {
+    const double dLat = 360.0 / (odd ? 59.0 : 60.0);
+    const double yz = cprLatitude / CPR_SCALE;
+    const double j = std::floor(referenceLatitude / dLat) +
+                     std::floor(0.5 + positiveMod(referenceLatitude, dLat) / dLat - yz);
+    const double lat = dLat * (j + yz);
+    if (lat > 90.0 || lat < -90.0) return false;
+
+    const int zones = qMax(cprNL(lat) - (odd ? 1 : 0), 1);
+    const double dLon = 360.0 / zones;
+    const double xz = cprLongitude / CPR_SCALE;
+    const double m = std::floor(referenceLongitude / dLon) +
+                     std::floor(0.5 + positiveMod(referenceLongitude, dLon) / dLon - xz);
+    double lon = dLon * (m + xz);
+    if (lon >= 180.0) lon -= 360.0;
+    if (lon < -180.0) lon += 360.0;
+
+    latitude = lat;
+    longitude = lon;
+    return true;
+}
+
+} // namespace CounterUAS
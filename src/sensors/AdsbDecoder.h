@@ -0,0 +1,87 @@
+#ifndef ADSBDECODER_H
+#define ADSBDECODER_H
+
+#include <QByteArray>
+#include <QString>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief What one ADS-B message says about its aircraft
+ *
+ * Each message carries one part of the state: an identification, a CPR
+ * encoded position with altitude, or a velocity. SBS lines carry the
+ * position already decoded.
+ */
+struct AdsbMessage {
+    quint32 icao = 0;
+    quint64 payloadHash = 0;            // Same for the same message off any receiver
+
+    bool hasCallsign = false;
+    QString callsign;
+
+    bool hasAltitude = false;
+    double altitudeM = 0.0;             // Barometric, above mean sea level
+
+    bool hasCpr = false;                // Beast airborne position
+    bool cprOdd = false;
+    int cprLatitude = 0;                // 17-bit fractions of a zone
+    int cprLongitude = 0;
+
+    bool hasPosition = false;           // SBS position, already decoded
+    double latitude = 0.0;
+    double longitude = 0.0;
+
+    bool hasVelocity = false;
+    VelocityVector velocity;            // Ground velocity, m/s
+};
+
+/**
+ * @brief ADS-B feeds from a 1090 MHz decoder such as dump1090 or readsb
+ *
+ * Beast binary (port 30005 by convention) is framed here: each frame is
+ * 0x1a, a type, a 48-bit timestamp, a signal level and the Mode S message,
+ * with any 0x1a in the frame doubled. Long frames of extended squitter
+ * (DF17/18) that pass the CRC-24 parity check are decoded for
+ * identification, airborne position and airborne ground velocity; other
+ * frames are skipped. SBS-1 BaseStation text (port 30003) is one decoded
+ * message per line.
+ *
+ * CPR positions are decoded locally against a reference within 180 NM,
+ * which is the aircraft's last position or else the receiver's, so a
+ * single frame gives a fix without waiting for an even and odd pair.
+ */
+class AdsbDecoder {
+public:
+    static constexpr int MAX_BUFFER_BYTES = 256 * 1024;
+
+    // Beast stream in any pieces; nextBeast() yields its Mode S messages
+    // (7 or 14 bytes) until the rest is incomplete
+    void appendBeast(const char* data, int size);
+    bool nextBeast(const quint8*& message, int& length);
+    void clear();
+    int bufferedBytes() const { return m_beast.size() - m_beastPos; }
+    qint64 discardedBytes() const { return m_discardedBytes; }
+
+    // False unless an extended squitter with good parity
+    static bool decodeModeS(const quint8* message, int length, AdsbMessage& out);
+    // False unless an identification, position or velocity MSG line
+    static bool decodeSbs(const char* line, int length, AdsbMessage& out);
+
+    static bool decodeCprLocal(double referenceLatitude, double referenceLongitude, bool odd,
+                               int cprLatitude, int cprLongitude,
+                               double& latitude, double& longitude);
+    // Over length bytes; a good DF17 message's first 11 give its last 3
+    static quint32 crc24(const quint8* data, int length);
+
+private:
+    QByteArray m_beast;
+    int m_beastPos = 0;
+    quint8 m_frame[7 + 14];             // Timestamp, signal, message; unescaped
+    qint64 m_discardedBytes = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // ADSBDECODER_H
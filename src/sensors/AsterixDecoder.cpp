@@ -0,0 +1,418 @@
+#include "sensors/AsterixDecoder.h"
+#include <QtMath>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr double METERS_PER_NM = 1852.0;
+constexpr double METERS_PER_FOOT = 0.3048;
+
+enum class Format : quint8 {
+    Spare,          // Not in the profile; a record that sets it cannot be framed
+    Fixed,
+    Extended,       // Parts of length octets until one ends with FX clear
+    Repetitive,     // REP octet, then REP times length octets
+    Explicit,       // LEN octet counting itself
+    Compound        // FX-extended presence octets, then the subfields present
+};
+
+struct ItemSpec {
+    quint16 item;
+    Format format;
+    quint8 length;
+    const ItemSpec* subfields;
+    quint8 subfieldCount;
+};
+
+constexpr quint16 ITEM_RE = 1000;   // Reserved expansion field
+constexpr quint16 ITEM_SP = 1001;   // Special purpose field
+
+constexpr ItemSpec fixed(quint16 item, quint8 length) { return {item, Format::Fixed, length, nullptr, 0}; }
+constexpr ItemSpec extended(quint16 item, quint8 part) { return {item, Format::Extended, part, nullptr, 0}; }
+constexpr ItemSpec repetitive(quint16 item, quint8 each) { return {item, Format::Repetitive, each, nullptr, 0}; }
+constexpr ItemSpec explicitItem(quint16 item) { return {item, Format::Explicit, 0, nullptr, 0}; }
+constexpr ItemSpec spare() { return {0, Format::Spare, 0, nullptr, 0}; }
+template <int N>
+constexpr ItemSpec compound(quint16 item, const ItemSpec (&subfields)[N]) {
+    return {item, Format::Compound, 0, subfields, static_cast<quint8>(N)};
+}
+
+// CAT-048 Monoradar Target Reports, edition 1.2x
+
+const ItemSpec I048_120[] = {           // Radial Doppler Speed
+    fixed(1, 2),                        // CAL
+    repetitive(2, 6)                    // RDS
+};
+
+const ItemSpec I048_130[] = {           // Radar Plot Characteristics
+    fixed(1, 1), fixed(2, 1), fixed(3, 1), fixed(4, 1),     // SRL SRR SAM PRL
+    fixed(5, 1), fixed(6, 1), fixed(7, 1)                   // PAM RPD APD
+};
+
+const ItemSpec UAP_048[] = {
+    fixed(10, 2), fixed(140, 3), extended(20, 1), fixed(40, 4),
+    fixed(70, 2), fixed(90, 2), compound(130, I048_130),
+    fixed(220, 3), fixed(240, 6), repetitive(250, 8), fixed(161, 2),
+    fixed(42, 4), fixed(200, 4), extended(170, 1),
+    fixed(210, 4), extended(30, 1), fixed(80, 2), fixed(100, 4),
+    fixed(110, 2), compound(120, I048_120), fixed(230, 2),
+    fixed(260, 7), fixed(55, 1), fixed(50, 2), fixed(65, 1),
+    fixed(60, 2), explicitItem(ITEM_SP), explicitItem(ITEM_RE)
+};
+
+// CAT-062 SDPS Track Messages, edition 1.1x
+
+const ItemSpec I062_110[] = {           // Mode 5 Data and Extended Mode 1 Code
+    fixed(1, 1), fixed(2, 4), fixed(3, 6), fixed(4, 2),     // SUM PMN POS GA
+    fixed(5, 2), fixed(6, 1), fixed(7, 1)                   // EM1 TOS XP
+};
+
+const ItemSpec I062_290[] = {           // System Track Update Ages
+    fixed(1, 1), fixed(2, 1), fixed(3, 1), fixed(4, 1),     // TRK PSR SSR MDS
+    fixed(5, 2), fixed(6, 1), fixed(7, 1),                  // ADS ES VDL
+    fixed(8, 1), fixed(9, 1), fixed(10, 1)                  // UAT LOP MLT
+};
+
+const ItemSpec I062_295[] = {           // Track Data Ages, one octet each
+    fixed(1, 1), fixed(2, 1), fixed(3, 1), fixed(4, 1), fixed(5, 1), fixed(6, 1), fixed(7, 1),
+    fixed(8, 1), fixed(9, 1), fixed(10, 1), fixed(11, 1), fixed(12, 1), fixed(13, 1), fixed(14, 1),
+    fixed(15, 1), fixed(16, 1), fixed(17, 1), fixed(18, 1), fixed(19, 1), fixed(20, 1), fixed(21, 1),
+    fixed(22, 1), fixed(23, 1), fixed(24, 1), fixed(25, 1), fixed(26, 1), fixed(27, 1), fixed(28, 1),
+    fixed(29, 1), fixed(30, 1), fixed(31, 1)
+};
+
+const ItemSpec I062_340[] = {           // Measured Information
+    fixed(1, 2), fixed(2, 4), fixed(3, 2), fixed(4, 2),     // SID POS HEI MDC
+    fixed(5, 2), fixed(6, 1)                                // MDA TYP
+};
+
+const ItemSpec I062_380[] = {           // Aircraft Derived Data
+    fixed(1, 3), fixed(2, 6), fixed(3, 2), fixed(4, 2),     // ADR ID MHG IAS
+    fixed(5, 2), fixed(6, 2), fixed(7, 2),                  // TAS SAL FSS
+    extended(8, 1), repetitive(9, 15), fixed(10, 2),        // TIS TID COM
+    fixed(11, 2), fixed(12, 7), fixed(13, 2), fixed(14, 2), // SAB ACS BVR GVR
+    fixed(15, 2), fixed(16, 2), fixed(17, 2), fixed(18, 2), // RAN TAR TAN GSP
+    fixed(19, 1), fixed(20, 8), fixed(21, 1),               // VUN MET EMC
+    fixed(22, 6), fixed(23, 2), fixed(24, 1), repetitive(25, 8),    // POS GAL PUN MB
+    fixed(26, 2), fixed(27, 2), fixed(28, 2)                // IAR MAC BPS
+};
+
+const ItemSpec I062_390[] = {           // Flight Plan Related Data
+    fixed(1, 2), fixed(2, 7), fixed(3, 4), fixed(4, 1),     // TAG CSN IFI FCT
+    fixed(5, 4), fixed(6, 1), fixed(7, 4),                  // TAC WTC DEP
+    fixed(8, 4), fixed(9, 3), fixed(10, 2), fixed(11, 2),   // DST RDS CFL CTL
+    repetitive(12, 4), fixed(13, 6), fixed(14, 1),          // TOD AST STS
+    fixed(15, 7), fixed(16, 7), fixed(17, 2), fixed(18, 7)  // STD STA PEM PEC
+};
+
+const ItemSpec I062_500[] = {           // Estimated Accuracies
+    fixed(1, 4), fixed(2, 2), fixed(3, 4), fixed(4, 1),     // APC COV APW AGA
+    fixed(5, 1), fixed(6, 2), fixed(7, 2),                  // ABA ATV AA
+    fixed(8, 1)                                             // ARC
+};
+
+const ItemSpec UAP_062[] = {
+    fixed(10, 2), spare(), fixed(15, 1), fixed(70, 3),
+    fixed(105, 8), fixed(100, 6), fixed(185, 4),
+    fixed(210, 2), fixed(60, 2), fixed(245, 7), compound(380, I062_380),
+    fixed(40, 2), extended(80, 1), compound(290, I062_290),
+    fixed(200, 1), compound(295, I062_295), fixed(136, 2), fixed(130, 2),
+    fixed(135, 2), fixed(220, 2), compound(390, I062_390),
+    extended(270, 1), fixed(300, 1), compound(110, I062_110), fixed(120, 2),
+    extended(510, 3), compound(500, I062_500), compound(340, I062_340),
+    spare(), spare(), spare(), spare(),
+    spare(), explicitItem(ITEM_RE), explicitItem(ITEM_SP)
+};
+
+template <int N>
+constexpr int count(const ItemSpec (&)[N]) { return N; }
+
+inline quint32 be16(const uchar* p) { return (quint32(p[0]) << 8) | p[1]; }
+inline quint32 be24(const uchar* p) { return (quint32(p[0]) << 16) | (quint32(p[1]) << 8) | p[2]; }
+inline quint32 be32(const uchar* p) { return (be16(p) << 16) | be16(p + 2); }
+// Two's complement of the low bits of value
+inline qint32 signExtend(quint32 value, int bits) {
+    const quint32 sign = 1u << (bits - 1);
+    value &= (sign << 1) - 1;
+    return static_cast<qint32>(value ^ sign) - static_cast<qint32>(sign);
+}
+
+int itemLength(const ItemSpec& spec, const uchar* p, int available);
+
+// Calls subfield(index, data, length) for each subfield present, in order;
+// returns the compound item's length, 0 when it cannot be framed
+template <typename Visit>
+int walkCompound(const ItemSpec& spec, const uchar* p, int available, Visit&& subfield) {
+    int primary = 0;
+    do {
+        if (primary >= available) return 0;
+    } while (p[primary++] & 1);
+
+    int at = primary;
+    for (int octet = 0; octet < primary; ++octet) {
+        for (int bit = 7; bit >= 1; --bit) {
+            if (!((p[octet] >> bit) & 1)) continue;
+            const int index = octet * 7 + (7 - bit);
+            if (index >= spec.subfieldCount) return 0;
+            const int length = itemLength(spec.subfields[index], p + at, available - at);
+            if (length <= 0) return 0;
+            subfield(index, p + at, length);
+            at += length;
+        }
+    }
+    return at;
+}
+
+int itemLength(const ItemSpec& spec, const uchar* p, int available) {
+    switch (spec.format) {
+    case Format::Fixed:
+        return spec.length <= available ? spec.length : 0;
+    case Format::Extended: {
+        int length = spec.length;
+        while (length <= available) {
+            if (!(p[length - 1] & 1)) return length;
+            length += spec.length;
+        }
+        return 0;
+    }
+    case Format::Repetitive: {
+        if (available < 1) return 0;
+        const int length = 1 + p[0] * spec.length;
+        return length <= available ? length : 0;
+    }
+    case Format::Explicit: {
+        if (available < 1) return 0;
+        const int length = p[0];
+        return length >= 1 && length <= available ? length : 0;
+    }
+    case Format::Compound:
+        return walkCompound(spec, p, available, [](int, const uchar*, int) {});
+    default:
+        return 0;
+    }
+}
+
+// Eight characters of six bits, ICAO alphabet
+void decodeCallsign(const uchar* p, char* out) {
+    const quint64 bits = (quint64(be24(p)) << 24) | be24(p + 3);
+    int end = 0;
+    for (int i = 0; i < 8; ++i) {
+        const int c = static_cast<int>((bits >> (42 - 6 * i)) & 0x3F);
+        char ch = ' ';
+        if (c >= 1 && c <= 26) {
+            ch = static_cast<char>('A' + c - 1);
+        } else if (c >= 48 && c <= 57) {
+            ch = static_cast<char>('0' + c - 48);
+        }
+        out[i] = ch;
+        if (ch != ' ') end = i + 1;
+    }
+    out[end] = '\0';
+}
+
+void decode048(quint16 item, const ItemSpec& spec, const uchar* p, int length, AsterixRecord& r) {
+    switch (item) {
+    case 10:
+        r.sac = p[0];
+        r.sic = p[1];
+        r.fields |= quint32(AsterixField::Source);
+        break;
+    case 140:
+        r.timeOfDaySec = be24(p) / 128.0;
+        r.fields |= quint32(AsterixField::TimeOfDay);
+        break;
+    case 20:
+        r.reportType = p[0] >> 5;
+        r.simulated = (p[0] & 0x10) != 0;
+        if (length > 1) r.testTarget = (p[1] & 0x80) != 0;
+        break;
+    case 40:
+        r.rangeM = be16(p) / 256.0 * METERS_PER_NM;
+        r.azimuthDeg = be16(p + 2) * (360.0 / 65536.0);
+        r.fields |= quint32(AsterixField::Polar);
+        break;
+    case 70:
+        r.mode3A = static_cast<quint16>(be16(p) & 0x0FFF);
+        r.fields |= quint32(AsterixField::Mode3A);
+        break;
+    case 90:
+        r.flightLevel = signExtend(be16(p), 14) / 4.0;
+        r.fields |= quint32(AsterixField::FlightLevel);
+        break;
+    case 130:
+        // Secondary amplitude if there is one, else primary
+        walkCompound(spec, p, length, [&r](int index, const uchar* sub, int) {
+            if (index == 2 || (index == 4 && !r.has(AsterixField::Amplitude))) {
+                r.amplitudeDbm = static_cast<qint8>(sub[0]);
+                r.fields |= quint32(AsterixField::Amplitude);
+            }
+        });
+        break;
+    case 220:
+        r.aircraftAddress = be24(p);
+        r.fields |= quint32(AsterixField::AircraftAddress);
+        break;
+    case 240:
+        decodeCallsign(p, r.callsign);
+        r.fields |= quint32(AsterixField::Callsign);
+        break;
+    case 161:
+        r.trackNumber = be16(p) & 0x0FFF;
+        r.fields |= quint32(AsterixField::TrackNumber);
+        break;
+    case 42:
+        r.xM = static_cast<qint16>(be16(p)) / 128.0 * METERS_PER_NM;
+        r.yM = static_cast<qint16>(be16(p + 2)) / 128.0 * METERS_PER_NM;
+        r.fields |= quint32(AsterixField::Cartesian);
+        break;
+    case 200: {
+        const double speedMps = be16(p) * (METERS_PER_NM / 16384.0);
+        const double headingRad = qDegreesToRadians(be16(p + 2) * (360.0 / 65536.0));
+        r.velocityEastMps = speedMps * std::sin(headingRad);
+        r.velocityNorthMps = speedMps * std::cos(headingRad);
+        r.fields |= quint32(AsterixField::Velocity);
+        break;
+    }
+    case 170:
+        r.tentative = (p[0] & 0x80) != 0;
+        break;
+    case 110:
+        r.heightM = signExtend(be16(p), 14) * 25.0 * METERS_PER_FOOT;
+        r.fields |= quint32(AsterixField::Height);
+        break;
+    case 120:
+        walkCompound(spec, p, length, [&r](int index, const uchar* sub, int) {
+            if (index == 0 && !(sub[0] & 0x80)) {   // D set: not valid
+                r.dopplerMps = signExtend(be16(sub), 10);
+                r.fields |= quint32(AsterixField::Doppler);
+            }
+        });
+        break;
+    default:
+        break;
+    }
+}
+
+void decode062(quint16 item, const ItemSpec& spec, const uchar* p, int length, AsterixRecord& r) {
+    switch (item) {
+    case 10:
+        r.sac = p[0];
+        r.sic = p[1];
+        r.fields |= quint32(AsterixField::Source);
+        break;
+    case 70:
+        r.timeOfDaySec = be24(p) / 128.0;
+        r.fields |= quint32(AsterixField::TimeOfDay);
+        break;
+    case 105:
+        r.latitude = static_cast<qint32>(be32(p)) * (180.0 / 33554432.0);
+        r.longitude = static_cast<qint32>(be32(p + 4)) * (180.0 / 33554432.0);
+        r.fields |= quint32(AsterixField::Wgs84);
+        break;
+    case 100:
+        r.xM = signExtend(be24(p), 24) * 0.5;
+        r.yM = signExtend(be24(p + 3), 24) * 0.5;
+        r.fields |= quint32(AsterixField::Cartesian);
+        break;
+    case 185:
+        r.velocityEastMps = static_cast<qint16>(be16(p)) * 0.25;
+        r.velocityNorthMps = static_cast<qint16>(be16(p + 2)) * 0.25;
+        r.fields |= quint32(AsterixField::Velocity);
+        break;
+    case 60:
+        r.mode3A = static_cast<quint16>(be16(p) & 0x0FFF);
+        r.fields |= quint32(AsterixField::Mode3A);
+        break;
+    case 245:
+        decodeCallsign(p + 1, r.callsign);
+        r.fields |= quint32(AsterixField::Callsign);
+        break;
+    case 380:
+        walkCompound(spec, p, length, [&r](int index, const uchar* sub, int) {
+            if (index == 0) {
+                r.aircraftAddress = be24(sub);
+                r.fields |= quint32(AsterixField::AircraftAddress);
+            } else if (index == 1 && !r.has(AsterixField::Callsign)) {
+                decodeCallsign(sub, r.callsign);
+                r.fields |= quint32(AsterixField::Callsign);
+            }
+        });
+        break;
+    case 40:
+        r.trackNumber = be16(p);
+        r.fields |= quint32(AsterixField::TrackNumber);
+        break;
+    case 80:
+        r.tentative = (p[0] & 0x02) != 0;
+        if (length > 1) r.simulated = (p[1] & 0x80) != 0;
+        break;
+    case 136:
+        r.flightLevel = static_cast<qint16>(be16(p)) / 4.0;
+        r.fields |= quint32(AsterixField::FlightLevel);
+        break;
+    case 135:
+        // Barometric, only when nothing measured it
+        if (!r.has(AsterixField::FlightLevel)) {
+            r.flightLevel = signExtend(be16(p), 15) / 4.0;
+            r.fields |= quint32(AsterixField::FlightLevel);
+        }
+        break;
+    case 130:
+        r.heightM = static_cast<qint16>(be16(p)) * 6.25 * METERS_PER_FOOT;
+        r.fields |= quint32(AsterixField::Height);
+        break;
+    case 220:
+        r.climbMps = static_cast<qint16>(be16(p)) * 6.25 * METERS_PER_FOOT / 60.0;
+        r.fields |= quint32(AsterixField::ClimbRate);
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace
+
+int AsterixDecoder::decodeRecord(quint8 category, const uchar* data, int length, AsterixRecord& record) const {
+    const ItemSpec* uap = nullptr;
+    int uapSize = 0;
+    void (*decodeItem)(quint16, const ItemSpec&, const uchar*, int, AsterixRecord&) = nullptr;
+    switch (category) {
+    case 48:
+        uap = UAP_048;
+        uapSize = count(UAP_048);
+        decodeItem = decode048;
+        break;
+    case 62:
+        uap = UAP_062;
+        uapSize = count(UAP_062);
+        decodeItem = decode062;
+        break;
+    default:
+        return 0;
+    }
+
+    // FSPEC, FX-extended; no profile here needs more than five octets
+    int fspec = 0;
+    do {
+        if (fspec >= length || fspec >= 8) return 0;
+    } while (data[fspec++] & 1);
+
+    int at = fspec;
+    for (int octet = 0; octet < fspec; ++octet) {
+        for (int bit = 7; bit >= 1; --bit) {
+            if (!((data[octet] >> bit) & 1)) continue;
+            const int frn = octet * 7 + (7 - bit);
+            if (frn >= uapSize) return 0;
+            const ItemSpec& spec = uap[frn];
+            const int itemBytes = itemLength(spec, data + at, length - at);
+            if (itemBytes <= 0) return 0;
+            decodeItem(spec.item, spec, data + at, itemBytes, record);
+            at += itemBytes;
+        }
+    }
+    return at;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,155 @@
+#ifndef ASTERIXDECODER_H
+#define ASTERIXDECODER_H
+
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Which of an AsterixRecord's fields a record carried
+ */
+enum class AsterixField : quint32 {
+    Source = 1u << 0,           // sac, sic
+    TimeOfDay = 1u << 1,
+    Polar = 1u << 2,            // rangeM, azimuthDeg, from the radar (048/040)
+    Wgs84 = 1u << 3,            // latitude, longitude (062/105)
+    Cartesian = 1u << 4,        // xM, yM, from the radar (048/042) or the system reference (062/100)
+    Velocity = 1u << 5,         // velocityEastMps, velocityNorthMps
+    FlightLevel = 1u << 6,
+    Height = 1u << 7,           // heightM: 3D radar height (048/110) or geometric altitude (062/130)
+    ClimbRate = 1u << 8,
+    Doppler = 1u << 9,
+    Amplitude = 1u << 10,
+    TrackNumber = 1u << 11,
+    Mode3A = 1u << 12,
+    AircraftAddress = 1u << 13,
+    Callsign = 1u << 14
+};
+
+/**
+ * @brief The fields of one CAT-048 target report or CAT-062 system track
+ * that the C2 uses, in SI units
+ *
+ * Plain data, so a decoder fills one on the stack per record.
+ */
+struct AsterixRecord {
+    quint8 category = 0;
+    quint8 sac = 0;
+    quint8 sic = 0;
+    quint8 reportType = 0;          // 048/020 TYP: 1 PSR, 2 SSR, 3 both, 4-7 Mode S
+    quint32 fields = 0;             // AsterixField bits
+    bool tentative = false;         // Track not yet confirmed
+    bool simulated = false;
+    bool testTarget = false;
+
+    double timeOfDaySec = 0.0;      // UTC since midnight
+    double rangeM = 0.0;            // Slant range
+    double azimuthDeg = 0.0;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double xM = 0.0;
+    double yM = 0.0;
+    double velocityEastMps = 0.0;
+    double velocityNorthMps = 0.0;
+    double flightLevel = 0.0;       // Hundreds of feet, pressure altitude
+    double heightM = 0.0;
+    double climbMps = 0.0;
+    double dopplerMps = 0.0;        // Radial, as the radar signs it
+    double amplitudeDbm = 0.0;
+    quint32 trackNumber = 0;
+    quint32 aircraftAddress = 0;
+    quint16 mode3A = 0;             // Four octal digits, three bits each
+    char callsign[9] = {};          // NUL-terminated, trailing spaces dropped
+
+    bool has(AsterixField field) const { return (fields & static_cast<quint32>(field)) != 0; }
+};
+
+/**
+ * @brief Decoder of ASTERIX CAT-048 and CAT-062 data blocks
+ *
+ * Each category's user application profile is a table of item formats
+ * indexed by field reference number: fixed, FX-extended, repetitive,
+ * explicit or compound, a compound item with a table of its own
+ * subfields. A record's FSPEC is walked bit by bit and every item present
+ * is sized from its table entry, so items the C2 does not use are stepped
+ * over without being decoded and a new edition's extra subfields cost
+ * nothing. The items that are used are decoded straight into an
+ * AsterixRecord.
+ *
+ * Nothing is allocated: decode() reads the datagram in place and hands
+ * each record to the sink on the stack. A record that runs past its block,
+ * or sets a field reference the profile leaves spare, ends the block,
+ * since nothing after it can be framed; other blocks in the datagram are
+ * still read. Blocks of other categories are skipped by their length.
+ *
+ * Not synchronised; one decoder per receiving thread.
+ */
+class AsterixDecoder {
+public:
+    struct Stats {
+        quint64 blocks = 0;
+        quint64 records = 0;
+        quint64 malformed = 0;          // Blocks or records that could not be framed
+        quint64 otherCategories = 0;    // Blocks skipped
+    };
+
+    static bool supports(quint8 category) { return category == 48 || category == 62; }
+
+    // Calls sink(const AsterixRecord&) for every record of the datagram's
+    // blocks of supported categories; returns how many there were
+    template <typename Sink>
+    int decode(const char* data, int length, Sink&& sink);
+
+    // One record of a block of the given category; returns its length, 0
+    // when it cannot be framed
+    int decodeRecord(quint8 category, const uchar* data, int length, AsterixRecord& record) const;
+
+    const Stats& stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+private:
+    Stats m_stats;
+};
+
+template <typename Sink>
+int AsterixDecoder::decode(const char* data, int length, Sink&& sink) {
+    const uchar* bytes = reinterpret_cast<const uchar*>(data);
+    int records = 0;
+    int offset = 0;
+    while (length - offset >= 3) {
+        const quint8 category = bytes[offset];
+        const int blockLength = (bytes[offset + 1] << 8) | bytes[offset + 2];
+        if (blockLength < 3 || blockLength > length - offset) {
+            ++m_stats.malformed;
+            break;
+        }
+        ++m_stats.blocks;
+        const int end = offset + blockLength;
+        if (!supports(category)) {
+            ++m_stats.otherCategories;
+            offset = end;
+            continue;
+        }
+
+        int at = offset + 3;
+        while (at < end) {
+            AsterixRecord record;
+            record.category = category;
+            const int used = decodeRecord(category, bytes + at, end - at, record);
+            if (used == 0) {
+                ++m_stats.malformed;
+                break;
+            }
+            at += used;
+            ++m_stats.records;
+            ++records;
+            sink(static_cast<const AsterixRecord&>(record));
+        }
+        offset = end;
+    }
+    return records;
+}
+
+} // namespace CounterUAS
+
+#endif // ASTERIXDECODER_H
@@ -0,0 +1,329 @@
+#include "sensors/AsterixSensor.h"
+#include "sensors/RadarSensor.h"
+#include "utils/Logger.h"
+#include "utils/TerrainModel.h"
+#include "utils/TimeUtils.h"
+#include <QtMath>
+#include <QDateTime>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr qint64 DAY_MS = 24 * 3600 * 1000;
+constexpr double FEET_TO_M = 0.3048;
+
+} // namespace
+
+AsterixSensor::AsterixSensor(const QString& sensorId, QObject* parent)
+    : SensorInterface(sensorId, parent)
+    , m_udpReceiver(new DatagramReceiver(this))
+{
+    QObject::connect(m_udpReceiver, &DatagramReceiver::batchReady,
+            this, &AsterixSensor::onUdpBatch);
+}
+
+AsterixSensor::~AsterixSensor() {
+    disconnect();
+}
+
+void AsterixSensor::setConfig(const AsterixSensorConfig& config) {
+    m_config = config;
+    if (m_config.useSystemReference) {
+        m_systemPlane.setOrigin(m_config.systemReference);
+    }
+    refreshSite(true);
+}
+
+void AsterixSensor::setTerrain(const TerrainModelPtr& terrain) {
+    m_geo.setTerrain(terrain);
+    refreshSite(true);
+}
+
+bool AsterixSensor::connect() {
+    if (isConnected()) return true;
+
+    setStatus(SensorStatus::Initializing);
+
+    DatagramReceiverConfig udp;
+    udp.address = QHostAddress(m_config.host);
+    udp.port = m_config.port;
+    udp.receiveBufferBytes = m_config.receiveBufferBytes;
+    udp.maxDatagramBytes = m_config.maxDatagramBytes;
+    if (!m_config.multicastGroup.isEmpty()) {
+        udp.multicastGroup = QHostAddress(m_config.multicastGroup);
+        udp.shareAddress = true;    // Other consumers of the group on this host
+        if (!m_config.multicastInterface.isEmpty()) {
+            udp.multicastInterface = QHostAddress(m_config.multicastInterface);
+        }
+    }
+    m_kernelDrops = 0;
+    if (!m_udpReceiver->start(udp)) {
+        reportError("Failed to bind UDP socket: " + m_udpReceiver->errorString());
+        return false;
+    }
+
+    Logger::instance().info("AsterixSensor",
+                           QString("%1 listening on UDP %2:%3%4")
+                               .arg(m_sensorId)
+                               .arg(m_config.host)
+                               .arg(m_config.port)
+                               .arg(m_config.multicastGroup.isEmpty()
+                                        ? QString()
+                                        : QString(" group %1").arg(m_config.multicastGroup)));
+
+    setStatus(SensorStatus::Online);
+    emit connectedChanged(true);
+    return true;
+}
+
+void AsterixSensor::disconnect() {
+    m_udpReceiver->stop();
+
+    setStatus(SensorStatus::Offline);
+    emit connectedChanged(false);
+}
+
+bool AsterixSensor::isConnected() const {
+    return m_udpReceiver->isRunning();
+}
+
+void AsterixSensor::processData() {
+    // Periodic processing - handled by receiver batches
+}
+
+void AsterixSensor::onUdpBatch(const DatagramBatchPtr& batch) {
+    // Drops the kernel counted on the socket become this sensor's dropped packets
+    if (batch->kernelDrops() > m_kernelDrops) {
+        m_telemetry->recordDropped(static_cast<int>(batch->kernelDrops() - m_kernelDrops));
+        m_kernelDrops = batch->kernelDrops();
+    }
+
+    m_telemetry->recordRead(batch->bytes());
+
+    const quint64 malformedBefore = m_decoder.stats().malformed;
+    for (int i = 0; i < batch->count(); ++i) {
+        captureRaw(batch->data(i), batch->size(i), batch->receivedNs());
+        const qint64 parseStartNs = TimeUtils::monotonicNs();
+        ingest(batch->data(i), batch->size(i), batch->receivedNs());
+        m_telemetry->recordParseNs(TimeUtils::monotonicNs() - parseStartNs);
+    }
+    m_telemetry->recordMessages(batch->count());
+    if (m_decoder.stats().malformed != malformedBefore) {
+        m_telemetry->recordDropped(static_cast<int>(m_decoder.stats().malformed - malformedBefore));
+    }
+
+    // One batch per receive, so fusion takes the burst in one submission
+    flush();
+}
+
+int AsterixSensor::ingest(const char* data, int size, qint64 receivedNs) {
+    if (receivedNs <= 0) {
+        receivedNs = TimeUtils::monotonicNs();
+    }
+    const qint64 receivedMs = QDateTime::currentMSecsSinceEpoch()
+                            - (TimeUtils::monotonicNs() - receivedNs) / 1000000;
+    refreshSite(false);
+
+    const int first = m_batch.size();
+    m_decoder.decode(data, size, [&](const AsterixRecord& record) {
+        if (!accepts(record)) {
+            ++m_filtered;
+            return;
+        }
+        SensorDetection detection;
+        if (!toDetection(record, receivedMs, detection)) {
+            ++m_unplaced;
+            return;
+        }
+        detection.ingestMonoNs = receivedNs;
+        m_batch.append(detection);
+    });
+
+    const int added = m_batch.size() - first;
+    if (added > 0) {
+        // recordDetection() for the lot, without a clock read per record
+        m_detections += added;
+        m_health.detectionCount += added;
+        m_health.lastDetectionTime = receivedMs;
+        m_telemetry->recordDetections(added);
+    }
+    return added;
+}
+
+void AsterixSensor::flush() {
+    if (m_batch.isEmpty()) return;
+
+    // Onto the ground under each target, with the batch's terrain in one pass
+    if (m_geo.terrain()) {
+        const int count = m_batch.size();
+        m_latitudes.resize(count);
+        m_longitudes.resize(count);
+        m_altitudes.resize(count);
+        for (int i = 0; i < count; ++i) {
+            const GeoPosition& position = m_batch[i].position;
+            m_latitudes[i] = position.latitude;
+            m_longitudes[i] = position.longitude;
+            m_altitudes[i] = position.altitude;
+        }
+        m_geo.toGroundLevel(m_latitudes.constData(), m_longitudes.constData(), m_altitudes.data(), count);
+        for (int i = 0; i < count; ++i) {
+            m_batch[i].position.altitude = m_altitudes[i];
+        }
+    }
+
+    correctTimestamps(m_batch.data(), m_batch.size());
+    emit detectionBatch(m_batch);
+    m_batch = QVector<SensorDetection>();
+}
+
+bool AsterixSensor::replayRaw(const QByteArray& data) {
+    if (isConnected()) return false;
+    
+    m_telemetry->recordRead(data.size());
+    ingest(data.constData(), data.size());
+    m_telemetry->recordMessages(1);
+    flush();
+    return true;
+}
+
+AsterixSensor::Stats AsterixSensor::stats() const {
+    Stats stats;
+    stats.decoder = m_decoder.stats();
+    stats.detections = m_detections;
+    stats.filtered = m_filtered;
+    stats.unplaced = m_unplaced;
+    return stats;
+}
+
+qint64 AsterixSensor::timeOfDayToEpochMs(double timeOfDaySec, qint64 nowMs) {
+    // Time of day wraps at midnight; take the day that puts it nearest now
+    const qint64 midnightMs = nowMs - nowMs % DAY_MS;
+    qint64 epochMs = midnightMs + std::llround(timeOfDaySec * 1000.0);
+    if (epochMs - nowMs > DAY_MS / 2) {
+        epochMs -= DAY_MS;
+    } else if (nowMs - epochMs > DAY_MS / 2) {
+        epochMs += DAY_MS;
+    }
+    return epochMs;
+}
+
+void AsterixSensor::refreshSite(bool force) {
+    if (!force && m_geo.hasSite(m_position)) return;
+    m_geo.setSite(m_position);
+    // The ground convert() measures from, so toGroundLevel() moves it to the target's
+    const TerrainModelPtr& terrain = m_geo.terrain();
+    m_siteGroundM = terrain ? terrain->elevationM(m_position.latitude, m_position.longitude)
+                            : m_config.groundElevationM;
+}
+
+bool AsterixSensor::accepts(const AsterixRecord& record) {
+    if (record.category == 48 && !m_config.acceptMonoradar) return false;
+    if (record.category == 62 && !m_config.acceptSystemTracks) return false;
+    if (!m_config.sources.isEmpty() &&
+        !m_config.sources.contains(static_cast<quint16>((record.sac << 8) | record.sic))) {
+        return false;
+    }
+    if (m_config.dropSimulated && (record.simulated || record.testTarget)) return false;
+    if (record.category == 48 && record.has(AsterixField::Polar) && record.rangeM > m_config.maxRangeM) {
+        return false;
+    }
+    return true;
+}
+
+bool AsterixSensor::toDetection(const AsterixRecord& record, qint64 receivedMs, SensorDetection& detection) {
+    const bool placed = record.category == 48 ? placeMonoradar(record, detection)
+                                              : placeSystemTrack(record, detection);
+    if (!placed) return false;
+
+    detection.sensorId = m_sensorId;
+    detection.sourceType = DetectionSource::Radar;
+    detection.confidence = record.tentative ? 0.6 : 0.9;
+    if (record.has(AsterixField::Amplitude)) {
+        detection.signalStrength = qBound(0.0, (record.amplitudeDbm + 100.0) / 100.0, 1.0);
+    }
+    detection.timestamp = record.has(AsterixField::TimeOfDay)
+                        ? timeOfDayToEpochMs(record.timeOfDaySec, receivedMs)
+                        : receivedMs;
+    detection.info.radar.trackNumber = record.trackNumber;
+    return true;
+}
+
+bool AsterixSensor::placeMonoradar(const AsterixRecord& record, SensorDetection& detection) {
+    // A report without a measured position (a track-only record) has nothing to place
+    if (!record.has(AsterixField::Polar) || record.reportType == 0 || record.rangeM <= 0.0) {
+        return false;
+    }
+
+    // Elevation up to the reported height; without one the plot is at the radar's height
+    double elevationDeg = 0.0;
+    double heightM = 0.0;
+    bool haveHeight = true;
+    if (record.has(AsterixField::Height)) {
+        heightM = record.heightM;
+    } else if (record.has(AsterixField::FlightLevel)) {
+        heightM = record.flightLevel * 100.0 * FEET_TO_M;
+    } else {
+        haveHeight = false;
+    }
+    if (haveHeight) {
+        const double riseM = heightM - m_siteGroundM - m_position.altitude;
+        elevationDeg = qRadiansToDegrees(std::asin(qBound(-1.0, riseM / record.rangeM, 1.0)));
+    }
+
+    RadarTrackReport report = {};
+    report.trackNumber = record.trackNumber;
+    report.rangeM = static_cast<float>(record.rangeM);
+    report.azimuthDeg = static_cast<float>(record.azimuthDeg);
+    report.elevationDeg = static_cast<float>(elevationDeg);
+    report.rangeRateMps = record.has(AsterixField::Doppler) ? static_cast<float>(record.dopplerMps) : 0.0f;
+    m_geo.convert(report, detection.position, detection.velocity);
+
+    // The radar's own track velocity over the plot's Doppler
+    if (record.has(AsterixField::Velocity)) {
+        detection.velocity.east = record.velocityEastMps;
+        detection.velocity.north = record.velocityNorthMps;
+        detection.velocity.down = 0.0;
+    }
+
+    detection.info.radar.rangeM = report.rangeM;
+    detection.info.radar.azimuthDeg = report.azimuthDeg;
+    detection.info.radar.elevationDeg = report.elevationDeg;
+    return true;
+}
+
+bool AsterixSensor::placeSystemTrack(const AsterixRecord& record, SensorDetection& detection) {
+    if (record.has(AsterixField::Wgs84)) {
+        detection.position.latitude = record.latitude;
+        detection.position.longitude = record.longitude;
+    } else if (record.has(AsterixField::Cartesian) && m_config.useSystemReference) {
+        EnuVector enu;
+        enu.east = record.xM;
+        enu.north = record.yM;
+        const GeoPosition position = m_systemPlane.toGeoLinear(enu);
+        detection.position.latitude = position.latitude;
+        detection.position.longitude = position.longitude;
+    } else {
+        return false;
+    }
+
+    // Above the site's ground until flush() moves it to the track's; a track
+    // without height stays on that ground
+    double heightM = m_siteGroundM;
+    if (record.has(AsterixField::Height)) {
+        heightM = record.heightM;
+    } else if (record.has(AsterixField::FlightLevel)) {
+        heightM = record.flightLevel * 100.0 * FEET_TO_M;
+    }
+    detection.position.altitude = heightM - m_siteGroundM;
+
+    if (record.has(AsterixField::Velocity)) {
+        detection.velocity.east = record.velocityEastMps;
+        detection.velocity.north = record.velocityNorthMps;
+        detection.velocity.down = record.has(AsterixField::ClimbRate) ? -record.climbMps : 0.0;
+    }
+    return true;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,134 @@
+#ifndef ASTERIXSENSOR_H
+#define ASTERIXSENSOR_H
+
+#include "sensors/SensorInterface.h"
+#include "sensors/AsterixDecoder.h"
+#include "sensors/RadarFrameParser.h"
+#include "utils/DatagramReceiver.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief ASTERIX feed configuration
+ */
+struct AsterixSensorConfig {
+    QString host = "0.0.0.0";             // Local address to bind
+    quint16 port = 8600;
+    QString multicastGroup;               // Joined when set
+    QString multicastInterface;           // Local IPv4 address to join on; empty for the default
+    int receiveBufferBytes = 8 * 1024 * 1024;
+    int maxDatagramBytes = 8192;          // Longer datagrams are dropped as truncated
+
+    bool acceptMonoradar = true;          // CAT-048 target reports, about this sensor's position
+    bool acceptSystemTracks = true;       // CAT-062 system tracks
+    QVector<quint16> sources;             // (SAC << 8) | SIC taken; empty takes every source
+    bool dropSimulated = true;            // Simulated and test targets
+    double maxRangeM = 100000.0;          // CAT-048 plots further out are dropped
+
+    // ASTERIX heights and flight levels are above sea level; GeoPosition
+    // altitudes are above the ground. Without terrain the ground is taken
+    // to be at this height everywhere
+    double groundElevationM = 0.0;
+    // CAT-062 tracks with a Cartesian position and no WGS-84 one are placed
+    // about the system reference when it is set, else dropped
+    bool useSystemReference = false;
+    GeoPosition systemReference;
+};
+
+/**
+ * @brief Radar sensor for ASTERIX CAT-048 plots and CAT-062 tracks over UDP
+ *
+ * Third-party radars and the regional air picture send ASTERIX over UDP,
+ * usually multicast, at high plot rates. Datagrams are read on the
+ * receiver's thread a batch at a time and decoded here in place by an
+ * AsterixDecoder, with no allocation per record. Each record that passes
+ * the filters becomes a Radar detection and everything decoded from one
+ * receive goes out as one detectionBatch, stamps corrected by the sensor's
+ * clock.
+ *
+ * A CAT-048 plot is polar about this sensor's position, which must be the
+ * radar's. Its elevation comes from the 3D height or, failing that, the
+ * flight level taken as height. A CAT-062 track carries its own WGS-84
+ * position. ASTERIX time of day is placed on the day nearest the receive
+ * time, so a midnight rollover lands on the right date.
+ */
+class AsterixSensor : public SensorInterface {
+    Q_OBJECT
+
+public:
+    explicit AsterixSensor(const QString& sensorId, QObject* parent = nullptr);
+    ~AsterixSensor() override;
+
+    // SensorInterface implementation
+    QString sensorType() const override { return "ASTERIX"; }
+    DetectionSource detectionSource() const override { return DetectionSource::Radar; }
+
+    bool connect() override;
+    void disconnect() override;
+    bool isConnected() const override;
+
+    double maxRange() const override { return m_config.maxRangeM; }
+    double fieldOfView() const override { return 360.0; }
+
+    void setConfig(const AsterixSensorConfig& config);
+    AsterixSensorConfig config() const { return m_config; }
+
+    // Ground under the plots, for altitudes above it
+    void setTerrain(const TerrainModelPtr& terrain);
+    TerrainModelPtr terrain() const { return m_geo.terrain(); }
+
+    // One datagram's detections onto the pending batch, and the batch out;
+    // public so recorded feeds can be played in. receivedNs is
+    // TimeUtils::monotonicNs() at the read, 0 for now
+    int ingest(const char* data, int size, qint64 receivedNs = 0);
+    void flush();
+
+    // A captured datagram, through ingest() and flush(); only while
+    // disconnected, so replay and a live feed do not interleave
+    bool replayRaw(const QByteArray& data) override;
+
+    struct Stats {
+        AsterixDecoder::Stats decoder;
+        quint64 detections = 0;
+        quint64 filtered = 0;       // Records of another source, simulated, out of range
+        quint64 unplaced = 0;       // Records without a position the sensor can use
+    };
+    // Sensor's thread
+    Stats stats() const;
+
+    // Epoch ms of an ASTERIX time of day, on the day nearest nowMs
+    static qint64 timeOfDayToEpochMs(double timeOfDaySec, qint64 nowMs);
+
+protected slots:
+    void processData() override;
+
+private slots:
+    void onUdpBatch(const DatagramBatchPtr& batch);
+
+private:
+    void refreshSite(bool force);
+    bool accepts(const AsterixRecord& record);
+    bool toDetection(const AsterixRecord& record, qint64 receivedMs, SensorDetection& detection);
+    bool placeMonoradar(const AsterixRecord& record, SensorDetection& detection);
+    bool placeSystemTrack(const AsterixRecord& record, SensorDetection& detection);
+
+    DatagramReceiver* m_udpReceiver;    // Reads on its own thread, decoded here a batch at a time
+    AsterixSensorConfig m_config;
+    AsterixDecoder m_decoder;
+    RadarGeoConverter m_geo;
+    LocalTangentPlane m_systemPlane;
+    double m_siteGroundM = 0.0;         // Ground under the sensor that altitudes are measured from
+    QVector<SensorDetection> m_batch;
+    QVector<double> m_latitudes;        // flush() terrain scratch
+    QVector<double> m_longitudes;
+    QVector<double> m_altitudes;
+    quint64 m_detections = 0;
+    quint64 m_filtered = 0;
+    quint64 m_unplaced = 0;
+    quint64 m_kernelDrops = 0;          // Last DatagramBatch::kernelDrops() counted
+};
+
+} // namespace CounterUAS
+
+#endif // ASTERIXSENSOR_H
@@ -0,0 +1,311 @@
+#include "sensors/CameraModel.h"
+#include <QtMath>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int UNDISTORT_ITERATIONS = 5;
+
+using Matrix = double[3][3];
+
+void multiply(const Matrix& a, const Matrix& b, Matrix& out) {
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            out[row][column] = a[row][0] * b[0][column] + a[row][1] * b[1][column] + a[row][2] * b[2][column];
+        }
+    }
+}
+
+void then(Matrix& rotation, const Matrix& next) {
+    Matrix product;
+    multiply(rotation, next, product);
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) rotation[row][column] = product[row][column];
+    }
+}
+
+// About up, clockwise seen from above: north turns towards east
+void aboutUp(Matrix& m, double degrees) {
+    const double s = std::sin(qDegreesToRadians(degrees));
+    const double c = std::cos(qDegreesToRadians(degrees));
+    const Matrix r = {{c, s, 0.0}, {-s, c, 0.0}, {0.0, 0.0, 1.0}};
+    then(m, r);
+}
+
+// About east: north turns up
+void aboutEast(Matrix& m, double degrees) {
+    const double s = std::sin(qDegreesToRadians(degrees));
+    const double c = std::cos(qDegreesToRadians(degrees));
+    const Matrix r = {{1.0, 0.0, 0.0}, {0.0, c, -s}, {0.0, s, c}};
+    then(m, r);
+}
+
+// About north, clockwise seen from behind: east turns down
+void aboutNorth(Matrix& m, double degrees) {
+    const double s = std::sin(qDegreesToRadians(degrees));
+    const double c = std::cos(qDegreesToRadians(degrees));
+    const Matrix r = {{c, 0.0, s}, {0.0, 1.0, 0.0}, {-s, 0.0, c}};
+    then(m, r);
+}
+
+} // namespace
+
+CameraModel::CameraModel() {
+    rebuild();
+}
+
+void CameraModel::setIntrinsics(const CameraIntrinsics& intrinsics) {
+    m_intrinsics = intrinsics;
+    m_intrinsics.pixelAspect = intrinsics.pixelAspect > 0.0 ? intrinsics.pixelAspect : 1.0;
+    rebuild();
+}
+
+void CameraModel::setMount(const CameraMount& mount) {
+    m_mount = mount;
+    m_plane.setOrigin(mount.position);
+    m_mountGroundM = m_terrain ? m_terrain->elevationM(mount.position.latitude, mount.position.longitude) : 0.0;
+    rebuild();
+}
+
+void CameraModel::setTerrain(const TerrainModelPtr& terrain) {
+    m_terrain = terrain;
+    m_mountGroundM = m_terrain ? m_terrain->elevationM(m_mount.position.latitude, m_mount.position.longitude) : 0.0;
+}
+
+void CameraModel::setImageSize(const QSize& size) {
+    if (size.isEmpty()) return;
+    m_imageSize = size;
+    rebuild();
+}
+
+void CameraModel::setPointing(double panDeg, double tiltDeg, double horizontalFovDeg) {
+    m_panDeg = panDeg;
+    m_tiltDeg = tiltDeg;
+    m_hfovDeg = qBound(0.01, horizontalFovDeg, 179.0);
+    rebuild();
+}
+
+void CameraModel::rebuild() {
+    // Base of the head, then the head's own axes
+    Matrix& r = m_rotation;
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) r[row][column] = row == column ? 1.0 : 0.0;
+    }
+    aboutUp(r, m_mount.headingDeg);
+    aboutEast(r, m_mount.pitchDeg);
+    aboutNorth(r, m_mount.rollDeg);
+    aboutUp(r, m_panDeg + m_mount.panOffsetDeg);
+    aboutEast(r, m_tiltDeg + m_mount.tiltOffsetDeg);
+
+    m_fx = m_imageSize.width() / 2.0 / std::tan(qDegreesToRadians(m_hfovDeg) / 2.0);
+    m_fy = m_fx * m_intrinsics.pixelAspect;
+    m_cx = m_intrinsics.principalX * m_imageSize.width();
+    m_cy = m_intrinsics.principalY * m_imageSize.height();
+}
+
+void CameraModel::distort(double& x, double& y) const {
+    const double r2 = x * x + y * y;
+    const double scale = 1.0 + r2 * (m_intrinsics.k1 + r2 * m_intrinsics.k2);
+    x *= scale;
+    y *= scale;
+}
+
+void CameraModel::undistort(double& x, double& y) const {
+    const double xd = x;
+    const double yd = y;
+    for (int i = 0; i < UNDISTORT_ITERATIONS; ++i) {
+        const double r2 = x * x + y * y;
+        const double scale = 1.0 + r2 * (m_intrinsics.k1 + r2 * m_intrinsics.k2);
+        x = xd / scale;
+        y = yd / scale;
+    }
+}
+
+EnuVector CameraModel::pixelRay(double x, double y) const {
+    EnuVector ray;
+    pixelRays(&x, &y, &ray, 1);
+    return ray;
+}
+
+void CameraModel::pixelRays(const double* x, const double* y, EnuVector* rays, int count) const {
+    const bool distorted = m_intrinsics.k1 != 0.0 || m_intrinsics.k2 != 0.0;
+    const Matrix& r = m_rotation;
+    for (int i = 0; i < count; ++i) {
+        double right = (x[i] - m_cx) / m_fx;
+        double down = (y[i] - m_cy) / m_fy;
+        if (distorted) undistort(right, down);
+        // Camera axes are the rotation's columns: right, forward, up
+        const double east = r[0][0] * right + r[0][1] - r[0][2] * down;
+        const double north = r[1][0] * right + r[1][1] - r[1][2] * down;
+        const double up = r[2][0] * right + r[2][1] - r[2][2] * down;
+        const double norm = 1.0 / std::sqrt(east * east + north * north + up * up);
+        rays[i].east = east * norm;
+        rays[i].north = north * norm;
+        rays[i].up = up * norm;
+    }
+}
+
+GeoPosition CameraModel::alongRay(const EnuVector& ray, double rangeM) const {
+    const EnuVector offset{ray.east * rangeM, ray.north * rangeM, ray.up * rangeM};
+    GeoPosition position = m_plane.toGeoLinear(offset);
+    if (m_terrain) {
+        // Above the ground under the point, not the mount's
+        position.altitude += m_mountGroundM - m_terrain->elevationM(position.latitude, position.longitude);
+    }
+    return position;
+}
+
+void CameraModel::marchToGround(const EnuVector* rays, int count, double* rangesM) const {
+    const double mountHeightM = m_mount.position.altitude;
+    if (!m_terrain) {
+        // Flat at the mount's ground: closed form
+        for (int i = 0; i < count; ++i) {
+            const double range = rays[i].up < 0.0 ? mountHeightM / -rays[i].up : -1.0;
+            rangesM[i] = range >= 0.0 && range <= m_maxRangeM ? range : -1.0;
+        }
+        return;
+    }
+
+    // Every ray still above the ground steps out together, one terrain batch a step
+    const double originMslM = m_mountGroundM + mountHeightM;
+    const double latPerM = 1.0 / m_plane.metersPerDegreeLatitude();
+    const double lonPerM = 1.0 / m_plane.metersPerDegreeLongitude();
+    const GeoPosition& origin = m_mount.position;
+    QVector<int> active(count);
+    QVector<double> above(count, mountHeightM);      // Height over the ground at the last step
+    QVector<double> latitudes(count);
+    QVector<double> longitudes(count);
+    QVector<double> ground(count);
+    for (int i = 0; i < count; ++i) {
+        active[i] = i;
+        rangesM[i] = -1.0;
+    }
+
+    int remaining = count;
+    double last = 0.0;
+    while (remaining > 0 && last < m_maxRangeM) {
+        const double range = qMin(m_maxRangeM, last + qMax(MIN_STEP_M, last * STEP_FRACTION));
+        for (int k = 0; k < remaining; ++k) {
+            const EnuVector& ray = rays[active[k]];
+            latitudes[k] = origin.latitude + ray.north * range * latPerM;
+            longitudes[k] = origin.longitude + ray.east * range * lonPerM;
+        }
+        m_terrain->elevationsM(latitudes.constData(), longitudes.constData(), ground.data(), remaining);
+
+        int kept = 0;
+        for (int k = 0; k < remaining; ++k) {
+            const int i = active[k];
+            const double height = originMslM + rays[i].up * range - ground[k];
+            if (height <= 0.0) {
+                // Between the two steps, where the height over the ground crosses zero
+                const double previous = qMax(0.0, above[i]);
+                rangesM[i] = last + (range - last) * previous / (previous - height);
+                continue;
+            }
+            above[i] = height;
+            active[kept++] = i;
+        }
+        remaining = kept;
+        last = range;
+    }
+}
+
+void CameraModel::locate(const EnuVector* rays, const double* knownRangesM, const double* assumedRangesM,
+                         CameraFix* fixes, int count) const {
+    if (count <= 0) return;
+    QVector<double> ground(count, -1.0);
+    // Only the rays without a range go to the terrain
+    QVector<EnuVector> unranged;
+    QVector<int> index;
+    for (int i = 0; i < count; ++i) {
+        if (!knownRangesM || knownRangesM[i] <= 0.0) {
+            unranged.append(rays[i]);
+            index.append(i);
+        }
+    }
+    if (!unranged.isEmpty()) {
+        QVector<double> ranges(unranged.size());
+        marchToGround(unranged.constData(), unranged.size(), ranges.data());
+        for (int k = 0; k < index.size(); ++k) ground[index[k]] = ranges[k];
+    }
+
+    for (int i = 0; i < count; ++i) {
+        CameraFix& fix = fixes[i];
+        fix.ray = rays[i];
+        if (knownRangesM && knownRangesM[i] > 0.0) {
+            fix.rangeM = knownRangesM[i];
+            fix.source = CameraFixSource::KnownRange;
+        } else if (ground[i] >= 0.0) {
+            fix.rangeM = ground[i];
+            fix.source = CameraFixSource::Terrain;
+        } else if (assumedRangesM && assumedRangesM[i] > 0.0) {
+            fix.rangeM = assumedRangesM[i];
+            fix.source = CameraFixSource::Assumed;
+        } else {
+            fix.rangeM = 0.0;
+            fix.source = CameraFixSource::None;
+            fix.position = m_mount.position;
+            continue;
+        }
+        fix.position = alongRay(rays[i], fix.rangeM);
+    }
+}
+
+void CameraModel::locate(const BoundingBox* boxes, const double* knownRangesM, double targetSpanM,
+                         CameraFix* fixes, int count) {
+    if (count <= 0) return;
+    m_x.resize(count);
+    m_y.resize(count);
+    m_rays.resize(count);
+    m_assumed.resize(count);
+    for (int i = 0; i < count; ++i) {
+        m_x[i] = boxes[i].x + boxes[i].width / 2.0;
+        m_y[i] = boxes[i].y + boxes[i].height / 2.0;
+        m_assumed[i] = rangeForWidth(boxes[i].width, targetSpanM);
+    }
+    pixelRays(m_x.constData(), m_y.constData(), m_rays.data(), count);
+    locate(m_rays.constData(), knownRangesM, m_assumed.constData(), fixes, count);
+}
+
+double CameraModel::rangeForWidth(double widthPx, double spanM) const {
+    if (widthPx <= 0.0 || spanM <= 0.0) return m_maxRangeM;
+    return qBound(1.0, spanM * m_fx / widthPx, m_maxRangeM);
+}
+
+bool CameraModel::projectEnu(const EnuVector& fromMount, QPointF& pixel) const {
+    // Into camera axes by the rotation's transpose
+    const Matrix& r = m_rotation;
+    const double right = r[0][0] * fromMount.east + r[1][0] * fromMount.north + r[2][0] * fromMount.up;
+    const double forward = r[0][1] * fromMount.east + r[1][1] * fromMount.north + r[2][1] * fromMount.up;
+    const double up = r[0][2] * fromMount.east + r[1][2] * fromMount.north + r[2][2] * fromMount.up;
+    if (forward <= 0.0) return false;
+
+    double x = right / forward;
+    double y = -up / forward;
+    if (m_intrinsics.k1 != 0.0 || m_intrinsics.k2 != 0.0) distort(x, y);
+    pixel = QPointF(m_cx + m_fx * x, m_cy + m_fy * y);
+    return true;
+}
+
+bool CameraModel::project(const GeoPosition& position, QPointF& pixel) const {
+    bool inFront = false;
+    project(&position, &pixel, &inFront, 1);
+    return inFront;
+}
+
+int CameraModel::project(const GeoPosition* positions, QPointF* pixels, bool* inFront, int count) const {
+    int visible = 0;
+    for (int i = 0; i < count; ++i) {
+        EnuVector enu = m_plane.toEnuLinear(positions[i]);
+        if (m_terrain) {
+            enu.up += m_terrain->elevationM(positions[i].latitude, positions[i].longitude) - m_mountGroundM;
+        }
+        inFront[i] = projectEnu(enu, pixels[i]);
+        if (inFront[i]) ++visible;
+    }
+    return visible;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,172 @@
+#ifndef CAMERAMODEL_H
+#define CAMERAMODEL_H
+
+#include <QPointF>
+#include <QSize>
+#include <QVector>
+#include "core/Track.h"
+#include "utils/LocalTangentPlane.h"
+#include "utils/TerrainModel.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Camera PTZ state
+ */
+struct CameraPTZState {
+    double pan = 0.0;        // degrees, 0 = north
+    double tilt = 0.0;       // degrees, 0 = horizon
+    double zoom = 1.0;       // 1.0 = no zoom
+    double hfov = 60.0;      // horizontal field of view at current zoom
+    double vfov = 45.0;      // vertical field of view at current zoom
+};
+
+/**
+ * @brief Lens calibration, independent of zoom and image size
+ */
+struct CameraIntrinsics {
+    double principalX = 0.5;    // Optical centre, as a fraction of the image width
+    double principalY = 0.5;    // And of its height, from the top
+    double pixelAspect = 1.0;   // Vertical over horizontal focal length
+    double k1 = 0.0;            // Radial distortion of normalised image coordinates
+    double k2 = 0.0;
+};
+
+/**
+ * @brief Where the pan-tilt head sits and how it is turned
+ */
+struct CameraMount {
+    GeoPosition position;       // Optical centre; altitude above the ground
+    double headingDeg = 0.0;    // Bearing of pan 0
+    double pitchDeg = 0.0;      // Of the head's base, nose up
+    double rollDeg = 0.0;       // Of the head's base, clockwise seen from behind
+    double panOffsetDeg = 0.0;  // Calibrated encoder zeros, added to the reported angles
+    double tiltOffsetDeg = 0.0;
+};
+
+/**
+ * @brief How a camera fix was ranged
+ */
+enum class CameraFixSource : quint8 {
+    None = 0,
+    KnownRange,     // Along the ray at a range given for it, e.g. a correlated track's
+    Terrain,        // Where the ray meets the ground
+    Assumed         // At the assumed range; direction only
+};
+
+/**
+ * @brief One detection placed along its ray
+ */
+struct CameraFix {
+    GeoPosition position;
+    EnuVector ray;              // Unit line of sight from the mount
+    double rangeM = 0.0;
+    CameraFixSource source = CameraFixSource::None;
+};
+
+/**
+ * @brief Calibrated pinhole camera on a pan-tilt head, pixels to geo rays and back
+ *
+ * The pose is the head's base (heading, pitch and roll of the mount)
+ * turned by pan about its vertical axis and then by tilt about the new
+ * horizontal one, with the calibrated encoder zeros added; setPointing()
+ * rebuilds the rotation once, so a ray or a projection is a 3x3 multiply.
+ * Focal lengths come from the horizontal field of view the head reports
+ * at its current zoom and the image width. Radial distortion (k1, k2) is
+ * applied on projection and removed, by fixed-point iteration, on the way
+ * to a ray.
+ *
+ * pixelRays() and locate() take every detection of a frame at once over
+ * parallel arrays: rays without a known range are marched out together
+ * and each step's ground comes from one TerrainModel::elevationsM() call
+ * for all of them, then the crossing is interpolated between the last two
+ * steps. Without terrain the ground is flat at the mount's. A ray that
+ * meets no ground within maxRangeM, as a drone against the sky does, is
+ * placed at the range the caller assumes for it.
+ *
+ * project() is the inverse, for overlays: a geo position to the pixel it
+ * lands on. Heights go onto the terrain, when one is set, so that both
+ * directions agree. Copyable; not thread-safe while being reconfigured.
+ */
+class CameraModel {
+public:
+    static constexpr double DEFAULT_MAX_RANGE_M = 5000.0;
+    static constexpr double MIN_STEP_M = 5.0;           // Terrain march, near the camera
+    static constexpr double STEP_FRACTION = 0.02;       // And a share of the range beyond
+
+    CameraModel();
+
+    void setIntrinsics(const CameraIntrinsics& intrinsics);
+    const CameraIntrinsics& intrinsics() const { return m_intrinsics; }
+    void setMount(const CameraMount& mount);
+    const CameraMount& mount() const { return m_mount; }
+    void setTerrain(const TerrainModelPtr& terrain);
+    const TerrainModelPtr& terrain() const { return m_terrain; }
+    // Pixel coordinates are in an image of this size
+    void setImageSize(const QSize& size);
+    QSize imageSize() const { return m_imageSize; }
+    void setMaxRangeM(double rangeM) { m_maxRangeM = qMax(1.0, rangeM); }
+    double maxRangeM() const { return m_maxRangeM; }
+
+    // Head angles as reported, and the field of view at its current zoom
+    void setPointing(double panDeg, double tiltDeg, double horizontalFovDeg);
+    void setPointing(const CameraPTZState& state) { setPointing(state.pan, state.tilt, state.hfov); }
+    double focalLengthPx() const { return m_fx; }
+
+    // Unit ENU line of sight through pixel (x, y), from the image's top left
+    EnuVector pixelRay(double x, double y) const;
+    void pixelRays(const double* x, const double* y, EnuVector* rays, int count) const;
+
+    // Per ray: at knownRangesM[i] when that is positive (null for none),
+    // else where it meets the ground, else at assumedRangesM[i]
+    void locate(const EnuVector* rays, const double* knownRangesM, const double* assumedRangesM,
+                CameraFix* fixes, int count) const;
+    // Box centres, one pass; the assumed range is what a target
+    // targetSpanM across would be at to fill the box's width
+    void locate(const BoundingBox* boxes, const double* knownRangesM, double targetSpanM,
+                CameraFix* fixes, int count);
+    // Range at which an object spanM across is widthPx wide
+    double rangeForWidth(double widthPx, double spanM) const;
+
+    // Pixel the position lands on; false behind the camera
+    bool project(const GeoPosition& position, QPointF& pixel) const;
+    bool projectEnu(const EnuVector& fromMount, QPointF& pixel) const;
+    // Positions to pixels over parallel arrays; returns how many are in front
+    int project(const GeoPosition* positions, QPointF* pixels, bool* inFront, int count) const;
+
+private:
+    void rebuild();
+    // Range along each ray to the ground, negative where it meets none by m_maxRangeM
+    void marchToGround(const EnuVector* rays, int count, double* rangesM) const;
+    void distort(double& x, double& y) const;
+    void undistort(double& x, double& y) const;
+    GeoPosition alongRay(const EnuVector& ray, double rangeM) const;
+
+    CameraIntrinsics m_intrinsics;
+    CameraMount m_mount;
+    TerrainModelPtr m_terrain;
+    LocalTangentPlane m_plane;          // About the mount
+    QSize m_imageSize = QSize(1920, 1080);
+    double m_maxRangeM = DEFAULT_MAX_RANGE_M;
+    double m_panDeg = 0.0;
+    double m_tiltDeg = 0.0;
+    double m_hfovDeg = 60.0;
+
+    // Derived by rebuild()
+    double m_rotation[3][3];            // Camera (right, forward, up) to ENU, by column
+    double m_fx = 1.0;
+    double m_fy = 1.0;
+    double m_cx = 0.0;
+    double m_cy = 0.0;
+    double m_mountGroundM = 0.0;        // Terrain under the mount, MSL
+
+    // locate() scratch
+    QVector<double> m_x;
+    QVector<double> m_y;
+    QVector<EnuVector> m_rays;
+    QVector<double> m_assumed;
+};
+
+} // namespace CounterUAS
+
+#endif // CAMERAMODEL_H
@@ -1,4 +1,6 @@
 #include "sensors/CameraSystem.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/LocalTangentPlane.h"
 #include "utils/Logger.h"
 #include <QtMath>
 
@@ -21,6 +23,24 @@ void CameraSystem::setConfig(const CameraSystemConfig& config) {
     m_ptzState = config.initialPTZ;
     m_position = config.mountPosition;
     m_name = config.cameraName;
+    
+    CameraMount mount = config.mountCalibration;
+    mount.position = config.mountPosition;
+    m_model.setIntrinsics(config.intrinsics);
+    m_model.setMount(mount);
+    m_model.setMaxRangeM(maxRange());
+    updateModel();
+}
+
+void CameraSystem::setTerrain(const TerrainModelPtr& terrain) {
+    m_model.setTerrain(terrain);
+}
+
+void CameraSystem::updateModel() {
+    if (!m_currentFrame.isNull()) {
+        m_model.setImageSize(m_currentFrame.size());
+    }
+    m_model.setPointing(m_ptzState);
 }
 
 bool CameraSystem::connect() {
@@ -142,11 +162,7 @@ void CameraSystem::slewToPosition(const GeoPosition& target) {
     m_targetPTZ.tilt = tilt;
     
     // Auto-zoom based on distance
-    double distance = 0.0;  // Calculate distance to target
-    // Simplified: set zoom based on approximate distance
-    Track tempTrack("temp");
-    tempTrack.setPosition(m_position);
-    distance = tempTrack.distanceTo(target);
+    const double distance = CoordinateUtils::haversineDistance(m_position, target);
     
     if (distance > 1500) {
         m_targetPTZ.zoom = m_config.zoomMax;
@@ -180,25 +196,59 @@ void CameraSystem::reportDetection(const CameraDetection& detection) {
     
     // Convert bounding box to estimated position
     GeoPosition estimatedPos = calculateTargetPosition(detection.boundingBox);
+    SensorDetection sensorDet = toSensorDetection(detection, estimatedPos);
+    
+    recordDetection();
+    
+    emit cameraDetection(detection);
+    emit this->detection(sensorDet);
+}
+
+void CameraSystem::reportDetections(const QVector<CameraDetection>& detections) {
+    QVector<CameraDetection> accepted;
+    accepted.reserve(detections.size());
+    for (const CameraDetection& detection : detections) {
+        if (detection.confidence >= m_config.detectionConfidenceThreshold) {
+            accepted.append(detection);
+        }
+    }
+    if (accepted.isEmpty()) return;
     
-    // Create sensor detection
+    // Normalised boxes into the model's pixels, then every ray at once
+    updateModel();
+    QVector<BoundingBox> boxes(accepted.size());
+    for (int i = 0; i < accepted.size(); ++i) {
+        boxes[i] = pixelBox(accepted[i].boundingBox);
+    }
+    QVector<CameraFix> fixes(accepted.size());
+    m_model.locate(boxes.constData(), nullptr, m_config.assumedTargetSpanM, fixes.data(), fixes.size());
+    
+    QVector<SensorDetection> batch;
+    batch.reserve(accepted.size());
+    for (int i = 0; i < accepted.size(); ++i) {
+        batch.append(toSensorDetection(accepted[i], fixes[i].position));
+        recordDetection();
+        emit cameraDetection(accepted[i]);
+    }
+    emit detectionBatch(batch);
+}
+
+SensorDetection CameraSystem::toSensorDetection(const CameraDetection& detection,
+                                                const GeoPosition& estimatedPos) const {
     SensorDetection sensorDet;
     sensorDet.sensorId = m_sensorId;
     sensorDet.position = estimatedPos;
     sensorDet.confidence = detection.confidence;
     sensorDet.timestamp = detection.timestamp;
     sensorDet.sourceType = DetectionSource::Camera;
-    sensorDet.metadata["objectClass"] = detection.objectClass;
-    sensorDet.metadata["frameNumber"] = static_cast<qint64>(detection.frameNumber);
-    sensorDet.metadata["bboxX"] = detection.boundingBox.x();
-    sensorDet.metadata["bboxY"] = detection.boundingBox.y();
-    sensorDet.metadata["bboxW"] = detection.boundingBox.width();
-    sensorDet.metadata["bboxH"] = detection.boundingBox.height();
-    
-    recordDetection();
-    
-    emit cameraDetection(detection);
-    emit this->detection(sensorDet);
+    CameraBoxInfo& camera = sensorDet.info.camera;
+    setFixedString(camera.objectClass, detection.objectClass);
+    camera.frameNumber = detection.frameNumber;
+    camera.x = detection.boundingBox.x();
+    camera.y = detection.boundingBox.y();
+    camera.width = detection.boundingBox.width();
+    camera.height = detection.boundingBox.height();
+    return sensorDet;
 }
 
 void CameraSystem::setRecording(bool recording) {
@@ -260,6 +310,7 @@ void CameraSystem::updateSlewProgress() {
         m_slewInProgress = false;
         m_slewComplete = true;
         m_slewTimer->stop();
+        updateModel();
         
         emit ptzChanged(m_ptzState);
         emit slewComplete(m_slewTarget);
@@ -287,64 +338,37 @@ void CameraSystem::updateSlewProgress() {
             m_ptzState.zoom = m_targetPTZ.zoom;
         }
         
+        updateModel();
         emit ptzChanged(m_ptzState);
     }
 }
 
 GeoPosition CameraSystem::calculateTargetPosition(const QRectF& bbox) {
-    // Estimate target position based on bounding box in image
-    // This is a simplified model assuming flat terrain
-    
-    double bboxCenterX = bbox.x() + bbox.width() / 2.0;
-    double bboxCenterY = bbox.y() + bbox.height() / 2.0;
-    
-    // Convert image coordinates to angles
-    double offsetX = (bboxCenterX - 0.5) * m_ptzState.hfov;
-    double offsetY = (0.5 - bboxCenterY) * m_ptzState.vfov;
-    
-    double targetPan = m_ptzState.pan + offsetX;
-    double targetTilt = m_ptzState.tilt + offsetY;
-    
-    // Estimate range based on bounding box size
-    // Assume typical drone size of 0.5m
-    double assumedTargetSize = 0.5;  // meters
-    double pixelSize = bbox.width();  // normalized
-    double angularSize = pixelSize * m_ptzState.hfov;
-    double estimatedRange = assumedTargetSize / (2.0 * std::tan(qDegreesToRadians(angularSize / 2.0)));
-    estimatedRange = qBound(50.0, estimatedRange, maxRange());
-    
-    // Convert to position
-    double azRad = qDegreesToRadians(targetPan);
-    double elRad = qDegreesToRadians(targetTilt);
-    
-    double horizontalRange = estimatedRange * std::cos(elRad);
-    double northOffset = horizontalRange * std::cos(azRad);
-    double eastOffset = horizontalRange * std::sin(azRad);
-    double altOffset = estimatedRange * std::sin(elRad);
-    
-    GeoPosition result;
-    result.latitude = m_position.latitude + (northOffset / 111000.0);
-    result.longitude = m_position.longitude + 
-                       (eastOffset / (111000.0 * std::cos(qDegreesToRadians(m_position.latitude))));
-    result.altitude = m_position.altitude + altOffset;
-    
-    return result;
+    // Along the box centre's ray to the ground, or to where a target of
+    // the assumed size would fill the box
+    updateModel();
+    const BoundingBox box = pixelBox(bbox);
+    CameraFix fix;
+    m_model.locate(&box, nullptr, m_config.assumedTargetSpanM, &fix, 1);
+    return fix.position;
+}
+
+BoundingBox CameraSystem::pixelBox(const QRectF& normalised) const {
+    const QSize image = m_model.imageSize();
+    BoundingBox box;
+    box.x = qRound(normalised.x() * image.width());
+    box.y = qRound(normalised.y() * image.height());
+    box.width = qMax(1, qRound(normalised.width() * image.width()));
+    box.height = qMax(1, qRound(normalised.height() * image.height()));
+    return box;
 }
 
 QPair<double, double> CameraSystem::calculatePanTilt(const GeoPosition& target) {
     // Calculate pan and tilt to point at target
     
-    double dLat = target.latitude - m_position.latitude;
-    double dLon = target.longitude - m_position.longitude;
-    double dAlt = target.altitude - m_position.altitude;
-    
-    double northOffset = dLat * 111000.0;
-    double eastOffset = dLon * 111000.0 * std::cos(qDegreesToRadians(m_position.latitude));
-    
-    double horizontalDist = std::sqrt(northOffset * northOffset + eastOffset * eastOffset);
-    
-    double pan = qRadiansToDegrees(std::atan2(eastOffset, northOffset));
-    double tilt = qRadiansToDegrees(std::atan2(dAlt, horizontalDist));
+    const EnuVector los = LocalTangentPlane(m_position).toEnu(target);
+    double pan = los.azimuthDeg();
+    double tilt = los.elevationDeg();
     
     // Normalize pan to camera range
     while (pan < m_config.panMin) pan += 360.0;
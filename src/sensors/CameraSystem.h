@@ -1,9 +1,11 @@
 #ifndef CAMERASYSTEM_H
 #define CAMERASYSTEM_H
 
+#include "sensors/CameraModel.h"
 #include "sensors/SensorInterface.h"
 #include <QImage>
 #include <QRectF>
+#include <QTimer>
 
 namespace CounterUAS {
 
@@ -20,17 +22,6 @@ struct CameraDetection {
     QImage thumbnail;
 };
 
-/**
- * @brief Camera PTZ state
- */
-struct CameraPTZState {
-    double pan = 0.0;        // degrees, 0 = north
-    double tilt = 0.0;       // degrees, 0 = horizon
-    double zoom = 1.0;       // 1.0 = no zoom
-    double hfov = 60.0;      // horizontal field of view at current zoom
-    double vfov = 45.0;      // vertical field of view at current zoom
-};
-
 /**
  * @brief Camera system configuration
  */
@@ -40,6 +31,9 @@ struct CameraSystemConfig {
     QString cameraName;
     GeoPosition mountPosition;
     CameraPTZState initialPTZ;
+    CameraIntrinsics intrinsics;
+    CameraMount mountCalibration;   // Heading, level and encoder zeros; position is mountPosition
+    double assumedTargetSpanM = 0.5;  // Ranges a box that meets no ground
     
     bool hasPTZ = false;
     double panMin = -180.0;
@@ -100,6 +94,13 @@ public:
     
     // Detection callback (for external detector integration)
     void reportDetection(const CameraDetection& detection);
+    // All of one frame's detections, located in one pass over the model
+    void reportDetections(const QVector<CameraDetection>& detections);
+    
+    // Ground for locating detections; flat at the mount's without one
+    void setTerrain(const TerrainModelPtr& terrain);
+    // Geometry at the current pointing, for overlays
+    const CameraModel& model() const { return m_model; }
     
     // Video recording notification
     bool isRecording() const { return m_recording; }
@@ -122,12 +123,16 @@ private slots:
     
 private:
     GeoPosition calculateTargetPosition(const QRectF& bbox);
+    void updateModel();
+    BoundingBox pixelBox(const QRectF& normalised) const;
+    SensorDetection toSensorDetection(const CameraDetection& detection, const GeoPosition& estimatedPos) const;
     QPair<double, double> calculatePanTilt(const GeoPosition& target);
     void executePTZCommand();
     
     CameraSystemConfig m_config;
     CameraPTZState m_ptzState;
     CameraPTZState m_targetPTZ;
+    CameraModel m_model;
     
     QImage m_currentFrame;
     qint64 m_frameNumber = 0;
@@ -144,4 +149,6 @@ private:
 
 } // namespace CounterUAS
 
+Q_DECLARE_METATYPE(CounterUAS::CameraDetection)
+
 #endif // CAMERASYSTEM_H
@@ -0,0 +1,96 @@
+#include "sensors/ClutterMap.h"
+#include <cmath>
+
+namespace CounterUAS {
+
+ClutterMap::ClutterMap(const ClutterMapConfig& config, double maxRangeM) {
+    configure(config, maxRangeM);
+}
+
+void ClutterMap::configure(const ClutterMapConfig& config, double maxRangeM) {
+    m_config = config;
+    m_config.cellRangeM = qMax(1.0, config.cellRangeM);
+    m_config.cellAzimuthDeg = qBound(0.1, config.cellAzimuthDeg, 360.0);
+    m_config.timeConstantS = qMax(0.1, config.timeConstantS);
+
+    m_rangeCells = qMax(1, static_cast<int>(std::ceil(qMax(0.0, maxRangeM) / m_config.cellRangeM)));
+    m_azimuthCells = qMax(1, static_cast<int>(std::ceil(360.0 / m_config.cellAzimuthDeg)));
+    clear();
+}
+
+bool ClutterMap::observe(double rangeM, double azimuthDeg, double elevationDeg, qint64 nowMs) {
+    if (!m_config.enabled || elevationDeg > m_config.maxElevationDeg) return false;
+
+    const int index = cellIndex(rangeM, azimuthDeg);
+    if (index < 0) return false;
+
+    if (m_originMs < 0) {
+        m_originMs = nowMs;
+    }
+    const quint32 now = relative(nowMs);
+
+    // Judge the plot on the history before it, so the first hits of a new
+    // return are never suppressed by themselves
+    Cell& cell = m_cells[index];
+    const double rate = decayed(cell, now);
+    const bool clutter = rate >= m_config.thresholdHitsPerS;
+
+    cell.rate = static_cast<float>(rate + 1.0 / m_config.timeConstantS);
+    cell.lastMs = now;
+
+    ++m_stats.plotsObserved;
+    if (clutter) {
+        ++m_stats.plotsSuppressed;
+    }
+    return clutter;
+}
+
+double ClutterMap::hitRate(double rangeM, double azimuthDeg, qint64 nowMs) const {
+    const int index = cellIndex(rangeM, azimuthDeg);
+    if (index < 0 || m_originMs < 0) return 0.0;
+    return decayed(m_cells[index], relative(nowMs));
+}
+
+int ClutterMap::clutterCellCount(qint64 nowMs) const {
+    if (m_originMs < 0) return 0;
+
+    const quint32 now = relative(nowMs);
+    int count = 0;
+    for (const Cell& cell : m_cells) {
+        if (cell.rate > 0.0f && decayed(cell, now) >= m_config.thresholdHitsPerS) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void ClutterMap::clear() {
+    m_cells = QVector<Cell>(m_rangeCells * m_azimuthCells);
+    m_originMs = -1;
+    m_stats = Stats();
+}
+
+int ClutterMap::cellIndex(double rangeM, double azimuthDeg) const {
+    if (!(rangeM >= 0.0) || !std::isfinite(azimuthDeg)) return -1;
+
+    const int rangeCell = static_cast<int>(rangeM / m_config.cellRangeM);
+    if (rangeCell >= m_rangeCells) return -1;
+
+    double azimuth = std::fmod(azimuthDeg, 360.0);
+    if (azimuth < 0.0) azimuth += 360.0;
+    const int azimuthCell = qMin(m_azimuthCells - 1,
+                                 static_cast<int>(azimuth / m_config.cellAzimuthDeg));
+    return rangeCell * m_azimuthCells + azimuthCell;
+}
+
+double ClutterMap::decayed(const Cell& cell, quint32 nowMs) const {
+    if (cell.rate <= 0.0f) return 0.0;
+    const double elapsedS = nowMs > cell.lastMs ? (nowMs - cell.lastMs) / 1000.0 : 0.0;
+    return cell.rate * std::exp(-elapsedS / m_config.timeConstantS);
+}
+
+quint32 ClutterMap::relative(qint64 nowMs) const {
+    return static_cast<quint32>(qBound<qint64>(0, nowMs - m_originMs, 0xFFFFFFFFLL));
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,78 @@
+#ifndef CLUTTERMAP_H
+#define CLUTTERMAP_H
+
+#include <QtGlobal>
+#include <QVector>
+
+namespace CounterUAS {
+
+/**
+ * @brief Clutter map configuration
+ */
+struct ClutterMapConfig {
+    bool enabled = true;
+    double cellRangeM = 50.0;
+    double cellAzimuthDeg = 2.0;
+    double timeConstantS = 60.0;      // Memory of the learned hit rate
+    double thresholdHitsPerS = 0.2;   // Cells at or above this rate are clutter
+    // Only plots at or below this elevation are learned or suppressed, so a
+    // drone hovering over persistent ground clutter is still reported
+    double maxElevationDeg = 5.0;
+};
+
+/**
+ * @brief Learned range-azimuth clutter map for one radar
+ *
+ * Each cell keeps an exponentially weighted hit rate in hits per second.
+ * Trees, buildings and roads return plots into the same cells scan after
+ * scan and climb past the threshold within seconds. A target passing
+ * through leaves a few hits that decay away. Decay is applied lazily when a
+ * cell is touched, so a plot costs O(1) and the grid is never swept. A
+ * cell is 8 bytes: the default 5 km radar at 50 m by 2 degrees is 144 KiB.
+ */
+class ClutterMap {
+public:
+    explicit ClutterMap(const ClutterMapConfig& config = ClutterMapConfig(),
+                        double maxRangeM = 5000.0);
+
+    void configure(const ClutterMapConfig& config, double maxRangeM);
+    ClutterMapConfig config() const { return m_config; }
+
+    // Learns the plot and returns true when it lies in a cell that was
+    // already clutter before this hit
+    bool observe(double rangeM, double azimuthDeg, double elevationDeg, qint64 nowMs);
+
+    double hitRate(double rangeM, double azimuthDeg, qint64 nowMs) const;
+    int clutterCellCount(qint64 nowMs) const;
+    void clear();
+
+    int rangeCells() const { return m_rangeCells; }
+    int azimuthCells() const { return m_azimuthCells; }
+
+    struct Stats {
+        qint64 plotsObserved = 0;
+        qint64 plotsSuppressed = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+private:
+    struct Cell {
+        float rate = 0.0f;      // Hits per second as of lastMs
+        quint32 lastMs = 0;     // Relative to m_originMs
+    };
+
+    int cellIndex(double rangeM, double azimuthDeg) const;
+    double decayed(const Cell& cell, quint32 nowMs) const;
+    quint32 relative(qint64 nowMs) const;
+
+    ClutterMapConfig m_config;
+    int m_rangeCells = 0;
+    int m_azimuthCells = 0;
+    QVector<Cell> m_cells;   // Range-major
+    qint64 m_originMs = -1;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // CLUTTERMAP_H
@@ -0,0 +1,396 @@
+#include "sensors/CooperativeReceiver.h"
+#include "utils/Clock.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtMath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int ADS_B_READ_CHUNK = 64 * 1024;
+constexpr int MAX_SBS_LINE = 1024;              // Longer is not SBS; dropped
+constexpr double COOPERATIVE_CONFIDENCE = 0.95;
+
+} // namespace
+
+CooperativeReceiver::CooperativeReceiver(const QString& sensorId, QObject* parent)
+    : SensorInterface(sensorId, parent)
+    , m_adsbSocket(new QTcpSocket(this))
+    , m_adsbConnection(new ManagedConnection(m_adsbSocket))
+    , m_remoteIdReceiver(new DatagramReceiver(this))
+    , m_clock(Clock::system())
+    , m_adsbRead(ADS_B_READ_CHUNK, Qt::Uninitialized)
+{
+    QObject::connect(m_adsbSocket, &QTcpSocket::connected, this, &CooperativeReceiver::onAdsbConnected);
+    QObject::connect(m_adsbSocket, &QTcpSocket::disconnected, this, &CooperativeReceiver::onAdsbDisconnected);
+    QObject::connect(m_adsbSocket, &QTcpSocket::readyRead, this, &CooperativeReceiver::onAdsbReadyRead);
+    QObject::connect(m_adsbSocket, &QAbstractSocket::errorOccurred, this, &CooperativeReceiver::onAdsbError);
+    QObject::connect(m_remoteIdReceiver, &DatagramReceiver::batchReady,
+                     this, &CooperativeReceiver::onRemoteIdBatch);
+
+    QObject::connect(m_adsbConnection, &ManagedConnection::retryScheduled, this,
+                     [this](int attempt, int delayMs) {
+        m_health.connectionRetries = attempt;
+        Logger::instance().info("CooperativeReceiver",
+                               QString("%1 reconnecting to ADS-B in %2 ms").arg(m_sensorId).arg(delayMs));
+    });
+    setConfig(m_config);
+}
+
+CooperativeReceiver::~CooperativeReceiver() {
+    disconnect();
+}
+
+void CooperativeReceiver::setConfig(const CooperativeReceiverConfig& config) {
+    m_config = config;
+
+    BackoffPolicy policy;
+    policy.maxDelayMs = qMax(policy.initialDelayMs, m_config.reconnectIntervalMs);
+    policy.connectTimeoutMs = m_config.timeoutMs;
+    m_adsbConnection->setPolicy(policy);
+    m_adsbConnection->setTarget(m_config.adsbHost, m_config.adsbPort);
+
+    m_friendlyIds.clear();
+    for (const QString& id : m_config.friendlyIds) {
+        m_friendlyIds.insert(id.trimmed().toUpper());
+    }
+    m_targets.reset(m_config.maxTargets);
+    m_adsb.clear();
+    m_sbsLine.clear();
+}
+
+void CooperativeReceiver::setClock(const Clock* clock) {
+    m_clock = clock ? clock : Clock::system();
+}
+
+bool CooperativeReceiver::connect() {
+    if (isConnected()) return true;
+
+    const bool adsb = !m_config.adsbHost.isEmpty();
+    const bool remoteId = m_config.remoteIdPort != 0;
+    if (!adsb && !remoteId) {
+        reportError("No ADS-B or Remote ID feed configured");
+        return false;
+    }
+
+    setStatus(SensorStatus::Initializing);
+
+    if (remoteId) {
+        DatagramReceiverConfig udp;
+        udp.address = QHostAddress(m_config.remoteIdHost);
+        udp.port = m_config.remoteIdPort;
+        udp.receiveBufferBytes = m_config.remoteIdReceiveBufferBytes;
+        m_kernelDrops = 0;
+        if (!m_remoteIdReceiver->start(udp)) {
+            reportError("Failed to bind Remote ID socket: " + m_remoteIdReceiver->errorString());
+            if (!adsb) return false;
+        } else {
+            Logger::instance().info("CooperativeReceiver",
+                                   QString("%1 listening for Remote ID on UDP %2:%3")
+                                       .arg(m_sensorId)
+                                       .arg(m_config.remoteIdHost)
+                                       .arg(m_config.remoteIdPort));
+            setStatus(SensorStatus::Online);
+            emit connectedChanged(true);
+        }
+    }
+
+    if (adsb) {
+        m_adsbConnection->open();
+    }
+    return true;
+}
+
+void CooperativeReceiver::disconnect() {
+    m_adsbConnection->close();
+    m_remoteIdReceiver->stop();
+
+    setStatus(SensorStatus::Offline);
+    emit connectedChanged(false);
+}
+
+bool CooperativeReceiver::isConnected() const {
+    return m_adsbSocket->state() == QAbstractSocket::ConnectedState || m_remoteIdReceiver->isRunning();
+}
+
+void CooperativeReceiver::processData() {
+    flushTargets();
+}
+
+void CooperativeReceiver::onAdsbConnected() {
+    setStatus(SensorStatus::Online);
+    m_health.connectionRetries = 0;
+    m_adsb.clear();
+    m_sbsLine.clear();
+
+    Logger::instance().info("CooperativeReceiver",
+                           QString("%1 connected to ADS-B %2:%3")
+                               .arg(m_sensorId)
+                               .arg(m_config.adsbHost)
+                               .arg(m_config.adsbPort));
+    emit connectedChanged(true);
+}
+
+void CooperativeReceiver::onAdsbDisconnected() {
+    // Remote ID alone still tags drones, but not aircraft
+    const bool remoteId = m_remoteIdReceiver->isRunning();
+    setStatus(remoteId ? SensorStatus::Degraded : SensorStatus::Offline);
+
+    Logger::instance().warning("CooperativeReceiver", m_sensorId + " ADS-B feed disconnected");
+    emit connectedChanged(remoteId);
+}
+
+void CooperativeReceiver::onAdsbReadyRead() {
+    const bool beast = m_config.adsbFormat == CooperativeReceiverConfig::AdsbFormat::Beast;
+    while (m_adsbSocket->bytesAvailable() > 0) {
+        const qint64 bytesRead = m_adsbSocket->read(m_adsbRead.data(), m_adsbRead.size());
+        if (bytesRead <= 0) break;
+        m_telemetry->recordRead(bytesRead);
+
+        const qint64 messagesBefore = m_stats.messages;
+        const qint64 parseStartNs = TimeUtils::monotonicNs();
+        if (beast) {
+            ingestBeast(m_adsbRead.constData(), static_cast<int>(bytesRead));
+        } else {
+            ingestSbs(m_adsbRead.constData(), static_cast<int>(bytesRead));
+        }
+        m_telemetry->recordParseNs(TimeUtils::monotonicNs() - parseStartNs);
+        m_telemetry->recordMessages(static_cast<int>(m_stats.messages - messagesBefore));
+    }
+    m_telemetry->setQueueDepth(beast ? m_adsb.bufferedBytes() : m_sbsLine.size());
+}
+
+void CooperativeReceiver::onAdsbError(QAbstractSocket::SocketError error) {
+    Q_UNUSED(error)
+    reportError("ADS-B socket error: " + m_adsbSocket->errorString());
+}
+
+void CooperativeReceiver::onRemoteIdBatch(const DatagramBatchPtr& batch) {
+    if (batch->kernelDrops() > m_kernelDrops) {
+        m_telemetry->recordDropped(static_cast<int>(batch->kernelDrops() - m_kernelDrops));
+        m_kernelDrops = batch->kernelDrops();
+    }
+    m_telemetry->recordRead(batch->bytes());
+
+    const qint64 parseStartNs = TimeUtils::monotonicNs();
+    for (int i = 0; i < batch->count(); ++i) {
+        ingestRemoteId(batch->data(i), batch->size(i));
+    }
+    m_telemetry->recordParseNs(TimeUtils::monotonicNs() - parseStartNs);
+    m_telemetry->recordMessages(batch->count());
+}
+
+void CooperativeReceiver::ingestBeast(const char* data, int size) {
+    m_adsb.appendBeast(data, size);
+    const qint64 nowMs = m_clock->nowMs();
+
+    const quint8* message = nullptr;
+    int length = 0;
+    AdsbMessage decoded;
+    while (m_adsb.nextBeast(message, length)) {
+        // Short Mode S and Mode A/C replies carry no ADS-B
+        if (!AdsbDecoder::decodeModeS(message, length, decoded)) {
+            ++m_stats.ignored;
+            continue;
+        }
+        ++m_stats.messages;
+        applyAdsb(decoded, nowMs);
+    }
+}
+
+void CooperativeReceiver::ingestSbs(const char* data, int size) {
+    m_sbsLine.append(data, size);
+    const qint64 nowMs = m_clock->nowMs();
+
+    AdsbMessage decoded;
+    int start = 0;
+    for (;;) {
+        const int end = m_sbsLine.indexOf('\n', start);
+        if (end < 0) break;
+        if (AdsbDecoder::decodeSbs(m_sbsLine.constData() + start, end - start, decoded)) {
+            ++m_stats.messages;
+            applyAdsb(decoded, nowMs);
+        } else {
+            ++m_stats.ignored;
+        }
+        start = end + 1;
+    }
+    m_sbsLine.remove(0, start);
+    if (m_sbsLine.size() > MAX_SBS_LINE) {
+        ++m_stats.ignored;
+        m_sbsLine.clear();
+    }
+}
+
+void CooperativeReceiver::ingestRemoteId(const char* data, int size) {
+    QJsonParseError error;
+    const QJsonObject json = QJsonDocument::fromJson(QByteArray::fromRawData(data, size), &error).object();
+    QString id = json.value("id").toString();
+    if (id.isEmpty()) id = json.value("serial").toString();
+    if (error.error != QJsonParseError::NoError || id.isEmpty() ||
+        !json.contains("lat") || !json.contains("lon")) {
+        ++m_stats.ignored;
+        return;
+    }
+    ++m_stats.messages;
+
+    const QByteArray serial = id.toUtf8();
+    const quint64 key = CooperativeTargetTable::serialKey(serial.constData(), serial.size());
+
+    // The reported state, not the bridge's own fields such as RSSI
+    const double state[] = {
+        json.value("lat").toDouble(), json.value("lon").toDouble(),
+        json.value("alt").toDouble(-1e9), json.value("height").toDouble(-1e9),
+        json.value("speed").toDouble(), json.value("track").toDouble(), json.value("vspeed").toDouble()
+    };
+    const quint64 payloadHash = CooperativeTargetTable::serialKey(
+        reinterpret_cast<const char*>(state), sizeof(state)) ^ key;
+
+    const qint64 nowMs = m_clock->nowMs();
+    bool created = false;
+    CooperativeTarget* target = noteMessage(key, payloadHash, nowMs, created);
+    if (!target) return;
+    if (created) identify(*target, CooperativeKind::RemoteId, id);
+
+    target->position.latitude = state[0];
+    target->position.longitude = state[1];
+    // Geodetic altitude is over the site like radar plots; height is over
+    // the take-off point, near enough to the site's ground
+    if (json.contains("alt")) {
+        target->position.altitude = state[2] - m_position.altitude;
+        target->hasAltitude = true;
+    } else if (json.contains("height")) {
+        target->position.altitude = state[3];
+        target->hasAltitude = true;
+    }
+    const double trackRad = qDegreesToRadians(state[5]);
+    target->velocity.north = state[4] * std::cos(trackRad);
+    target->velocity.east = state[4] * std::sin(trackRad);
+    target->velocity.down = -state[6];
+
+    if (target->dirty) ++m_stats.coalesced;
+    target->hasPosition = true;
+    target->positionMs = nowMs;
+    target->dirty = true;
+}
+
+CooperativeTarget* CooperativeReceiver::noteMessage(quint64 key, quint64 payloadHash, qint64 nowMs,
+                                                    bool& created) {
+    CooperativeTarget* target = m_targets.insert(key, &created);
+    if (!target) {
+        ++m_stats.tableFull;
+        return nullptr;
+    }
+    if (!target->notePayload(payloadHash, nowMs, m_config.duplicateWindowMs)) {
+        ++m_stats.duplicates;
+        return nullptr;
+    }
+    target->lastMessageMs = nowMs;
+    return target;
+}
+
+void CooperativeReceiver::identify(CooperativeTarget& target, CooperativeKind kind, const QString& id) {
+    target.kind = kind;
+    target.id = id;
+    target.classification = m_friendlyIds.contains(id.toUpper())
+        ? TrackClassification::Friendly : TrackClassification::Neutral;
+}
+
+void CooperativeReceiver::applyAdsb(const AdsbMessage& message, qint64 nowMs) {
+    bool created = false;
+    CooperativeTarget* target = noteMessage(CooperativeTargetTable::icaoKey(message.icao),
+                                            message.payloadHash, nowMs, created);
+    if (!target) return;
+    if (created) {
+        identify(*target, CooperativeKind::Adsb,
+                 QString("%1").arg(message.icao, 6, 16, QChar('0')).toUpper());
+    }
+
+    if (message.hasCallsign) {
+        target->callsign = message.callsign;
+    }
+
+    bool moved = false;
+    if (message.hasAltitude) {
+        // Barometric MSL, taken over the site like radar plot altitudes
+        target->position.altitude = message.altitudeM - m_position.altitude;
+        target->hasAltitude = true;
+    }
+    if (message.hasCpr) {
+        // Against the aircraft's last fix while it is fresh, else the site;
+        // both are well within the 180 NM a local decode allows
+        const bool fresh = target->hasPosition && nowMs - target->positionMs < m_config.targetTimeoutMs;
+        const GeoPosition& reference = fresh ? target->position : m_position;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        if (AdsbDecoder::decodeCprLocal(reference.latitude, reference.longitude, message.cprOdd,
+                                        message.cprLatitude, message.cprLongitude, latitude, longitude)) {
+            target->position.latitude = latitude;
+            target->position.longitude = longitude;
+            moved = true;
+        }
+    } else if (message.hasPosition) {
+        target->position.latitude = message.latitude;
+        target->position.longitude = message.longitude;
+        moved = true;
+    }
+    if (message.hasVelocity) {
+        target->velocity = message.velocity;
+    }
+
+    // Aircraft without a fix yet have nothing to forward
+    if (moved) {
+        target->hasPosition = true;
+        target->positionMs = nowMs;
+    }
+    if ((moved || message.hasVelocity) && target->hasPosition) {
+        if (target->dirty) ++m_stats.coalesced;
+        target->dirty = true;
+    }
+}
+
+int CooperativeReceiver::flushTargets() {
+    const qint64 nowMs = m_clock->nowMs();
+
+    m_targets.forEach([this, nowMs](CooperativeTarget& target) {
+        if (!target.dirty || nowMs - target.lastForwardMs < m_config.forwardIntervalMs) return;
+        // Kept up to date out of range, so it is known the moment it closes
+        if (CoordinateUtils::haversineDistance(m_position, target.position) > m_config.maxRangeM) return;
+
+        SensorDetection det;
+        det.sensorId = m_sensorId;
+        det.position = target.position;
+        det.velocity = target.velocity;
+        det.signalStrength = 1.0;
+        det.confidence = COOPERATIVE_CONFIDENCE;
+        det.timestamp = target.positionMs;
+        det.sourceType = DetectionSource::Cooperative;
+        // No ingest stamp: the hold-back to forwardIntervalMs is deliberate
+        // and would only swamp the ingest latency figures
+        setFixedString(det.info.cooperative.id, target.id);
+        setFixedString(det.info.cooperative.callsign, target.callsign);
+        det.info.cooperative.classification = static_cast<qint8>(target.classification);
+        det.info.cooperative.adsb = target.kind == CooperativeKind::Adsb;
+        m_batch.append(det);
+
+        target.dirty = false;
+        target.lastForwardMs = nowMs;
+        recordDetection();
+    });
+
+    m_stats.expired += m_targets.expire(nowMs - m_config.targetTimeoutMs);
+
+    const int forwarded = m_batch.size();
+    if (forwarded > 0) {
+        m_stats.forwarded += forwarded;
+        emit detectionBatch(m_batch);
+        m_batch = QVector<SensorDetection>();
+    }
+    return forwarded;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,146 @@
+#ifndef COOPERATIVERECEIVER_H
+#define COOPERATIVERECEIVER_H
+
+#include "sensors/SensorInterface.h"
+#include "sensors/AdsbDecoder.h"
+#include "sensors/CooperativeTargetTable.h"
+#include "utils/ConnectionPool.h"
+#include "utils/DatagramReceiver.h"
+#include <QSet>
+#include <QStringList>
+#include <QTcpSocket>
+
+namespace CounterUAS {
+
+class Clock;
+
+/**
+ * @brief Cooperative receiver configuration
+ */
+struct CooperativeReceiverConfig {
+    enum class AdsbFormat { Beast, Sbs };
+
+    // ADS-B from a 1090 MHz decoder over TCP; an empty host disables it
+    QString adsbHost;
+    quint16 adsbPort = 30005;
+    AdsbFormat adsbFormat = AdsbFormat::Beast;
+    int reconnectIntervalMs = 5000;   // Ceiling of the reconnect backoff
+    int timeoutMs = 3000;             // Per-attempt connect timeout
+
+    // Remote ID from a receiver bridge, one JSON message per datagram;
+    // port 0 disables it
+    QString remoteIdHost = "0.0.0.0";
+    quint16 remoteIdPort = 0;
+    int remoteIdReceiveBufferBytes = 1024 * 1024;
+
+    int maxTargets = 4096;
+    int targetTimeoutMs = 30000;      // Forgotten after this long unheard
+    int duplicateWindowMs = 500;      // Same payload within this counts once
+    int forwardIntervalMs = 1000;     // Per target, into the track picture
+    double maxRangeM = 20000.0;       // Targets further out are kept but not forwarded
+
+    // ICAO addresses (hex) and Remote ID serials of own aircraft; they are
+    // tagged Friendly, every other cooperative target Neutral
+    QStringList friendlyIds;
+};
+
+/**
+ * @brief ADS-B and Remote ID receiver, for tagging cooperative targets
+ *
+ * Aircraft and drones that broadcast who they are should not be weighed
+ * as threats. This sensor takes ADS-B from a Beast or SBS feed and Remote
+ * ID from a UDP bridge, and keeps one entry per ICAO address or serial in
+ * a CooperativeTargetTable. Thousands of messages a second are folded in
+ * there: a payload heard again within the duplicate window, as when
+ * several receivers share a feed, is dropped, and each message only
+ * updates its target's state.
+ *
+ * The track picture sees a target at most once per forwardIntervalMs, as
+ * a Cooperative detection carrying its id and class. Fusion correlates it
+ * with the radar or RF track at the same place, or starts one, and
+ * TrackManager tags that track Friendly or Neutral.
+ */
+class CooperativeReceiver : public SensorInterface {
+    Q_OBJECT
+
+public:
+    explicit CooperativeReceiver(const QString& sensorId, QObject* parent = nullptr);
+    ~CooperativeReceiver() override;
+
+    // SensorInterface implementation
+    QString sensorType() const override { return "COOPERATIVE"; }
+    DetectionSource detectionSource() const override { return DetectionSource::Cooperative; }
+
+    // Starts both feeds that are configured; ADS-B connects asynchronously
+    bool connect() override;
+    void disconnect() override;
+    bool isConnected() const override;
+
+    double maxRange() const override { return m_config.maxRangeM; }
+    double fieldOfView() const override { return 360.0; }
+
+    // Configuration; a new config forgets every target
+    void setConfig(const CooperativeReceiverConfig& config);
+    CooperativeReceiverConfig config() const { return m_config; }
+    // Time the targets are kept on; the system clock if null
+    void setClock(const Clock* clock);
+
+    // What the feeds read, in any pieces (Beast, SBS) or one message per
+    // call (Remote ID); public so recorded feeds can be played in
+    void ingestBeast(const char* data, int size);
+    void ingestSbs(const char* data, int size);
+    void ingestRemoteId(const char* data, int size);
+
+    // Emits the targets due an update as one batch, and forgets the silent
+    // ones; returns how many were forwarded. Runs on the update timer.
+    int flushTargets();
+
+    int targetCount() const { return m_targets.size(); }
+
+    struct Stats {
+        qint64 messages = 0;          // Decoded, duplicates included
+        qint64 ignored = 0;           // Frames without ADS-B, bad parity, unparsable
+        qint64 duplicates = 0;
+        qint64 coalesced = 0;         // Updates overtaken before they were forwarded
+        qint64 forwarded = 0;
+        qint64 tableFull = 0;         // Messages for new targets beyond maxTargets
+        qint64 expired = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+protected slots:
+    void processData() override;
+
+private slots:
+    void onAdsbConnected();
+    void onAdsbDisconnected();
+    void onAdsbReadyRead();
+    void onAdsbError(QAbstractSocket::SocketError error);
+    void onRemoteIdBatch(const DatagramBatchPtr& batch);
+
+private:
+    // Target for a message, or null if a duplicate or the table is full;
+    // a new target has no identity until identify()
+    CooperativeTarget* noteMessage(quint64 key, quint64 payloadHash, qint64 nowMs, bool& created);
+    void identify(CooperativeTarget& target, CooperativeKind kind, const QString& id);
+    void applyAdsb(const AdsbMessage& message, qint64 nowMs);
+
+    QTcpSocket* m_adsbSocket;
+    ManagedConnection* m_adsbConnection;
+    DatagramReceiver* m_remoteIdReceiver;   // Reads on its own thread, parsed here a batch at a time
+    CooperativeReceiverConfig m_config;
+    const Clock* m_clock;
+
+    AdsbDecoder m_adsb;
+    QByteArray m_sbsLine;                   // SBS text after the last complete line
+    QByteArray m_adsbRead;                  // Socket read buffer
+    CooperativeTargetTable m_targets;
+    QSet<QString> m_friendlyIds;            // Upper case
+    QVector<SensorDetection> m_batch;
+    Stats m_stats;
+    quint64 m_kernelDrops = 0;              // Last DatagramBatch::kernelDrops() counted
+};
+
+} // namespace CounterUAS
+
+#endif // COOPERATIVERECEIVER_H
@@ -0,0 +1,114 @@
+#include "sensors/CooperativeTargetTable.h"
+
+namespace CounterUAS {
+
+bool CooperativeTarget::notePayload(quint64 payloadHash, qint64 nowMs, qint64 windowMs) {
+    for (int i = 0; i < RECENT_PAYLOADS; ++i) {
+        if (recentPayloads[i] == payloadHash && nowMs - recentPayloadMs[i] < windowMs) {
+            return false;
+        }
+    }
+    recentPayloads[nextRecent] = payloadHash;
+    recentPayloadMs[nextRecent] = nowMs;
+    nextRecent = (nextRecent + 1) % RECENT_PAYLOADS;
+    return true;
+}
+
+CooperativeTargetTable::CooperativeTargetTable(int maxTargets) {
+    reset(maxTargets);
+}
+
+void CooperativeTargetTable::reset(int maxTargets) {
+    m_maxTargets = qMax(1, maxTargets);
+    int capacity = 16;
+    while (capacity < 2 * m_maxTargets) capacity *= 2;
+    m_slots = QVector<CooperativeTarget>(capacity);
+    m_mask = capacity - 1;
+    m_size = 0;
+}
+
+void CooperativeTargetTable::clear() {
+    for (CooperativeTarget& slot : m_slots) slot = CooperativeTarget();
+    m_size = 0;
+}
+
+int CooperativeTargetTable::home(quint64 key) const {
+    // splitmix64 finaliser; ICAO addresses arrive in blocks
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return static_cast<int>(key & quint64(m_mask));
+}
+
+int CooperativeTargetTable::slotOf(quint64 key) const {
+    for (int i = home(key);; i = (i + 1) & m_mask) {
+        const quint64 held = m_slots[i].key;
+        if (held == key) return i;
+        if (held == 0) return -1;
+    }
+}
+
+CooperativeTarget* CooperativeTargetTable::find(quint64 key) {
+    if (key == 0) return nullptr;
+    const int slot = slotOf(key);
+    return slot >= 0 ? &m_slots[slot] : nullptr;
+}
+
+CooperativeTarget* CooperativeTargetTable::insert(quint64 key, bool* created) {
+    if (created) *created = false;
+    if (key == 0) return nullptr;
+
+    int i = home(key);
+    for (; m_slots[i].key != 0; i = (i + 1) & m_mask) {
+        if (m_slots[i].key == key) return &m_slots[i];
+    }
+    if (m_size >= m_maxTargets) return nullptr;
+
+    m_slots[i] = CooperativeTarget();
+    m_slots[i].key = key;
+    ++m_size;
+    if (created) *created = true;
+    return &m_slots[i];
+}
+
+bool CooperativeTargetTable::remove(quint64 key) {
+    if (key == 0) return false;
+    int hole = slotOf(key);
+    if (hole < 0) return false;
+
+    // Pull back each later entry of the run that may sit in the hole
+    for (int j = (hole + 1) & m_mask; m_slots[j].key != 0; j = (j + 1) & m_mask) {
+        const int wanted = home(m_slots[j].key);
+        const bool fromAfterHole = hole <= j ? (wanted <= hole || wanted > j)
+                                             : (wanted <= hole && wanted > j);
+        if (fromAfterHole) {
+            m_slots[hole] = std::move(m_slots[j]);
+            hole = j;
+        }
+    }
+    m_slots[hole] = CooperativeTarget();
+    --m_size;
+    return true;
+}
+
+int CooperativeTargetTable::expire(qint64 cutoffMs) {
+    m_expired.clear();
+    for (const CooperativeTarget& slot : qAsConst(m_slots)) {
+        if (slot.key != 0 && slot.lastMessageMs < cutoffMs) m_expired.append(slot.key);
+    }
+    for (quint64 key : qAsConst(m_expired)) remove(key);
+    return m_expired.size();
+}
+
+quint64 CooperativeTargetTable::serialKey(const char* data, int size) {
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < size; ++i) {
+        hash ^= static_cast<quint8>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash | (quint64(1) << 63);
+}
+
+} // namespace CounterUAS
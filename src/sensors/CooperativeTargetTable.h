@@ -0,0 +1,104 @@
+#ifndef COOPERATIVETARGETTABLE_H
+#define COOPERATIVETARGETTABLE_H
+
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+enum class CooperativeKind {
+    Adsb,
+    RemoteId
+};
+
+/**
+ * @brief What a cooperative feed last said about one aircraft or drone
+ */
+struct CooperativeTarget {
+    static constexpr int RECENT_PAYLOADS = 4;
+
+    quint64 key = 0;                    // 0 marks an empty slot
+    CooperativeKind kind = CooperativeKind::Adsb;
+    QString id;                         // ICAO address in hex, or Remote ID serial
+    QString callsign;
+    TrackClassification classification = TrackClassification::Neutral;
+
+    GeoPosition position;
+    VelocityVector velocity;
+    bool hasPosition = false;
+    bool hasAltitude = false;
+    bool dirty = false;                 // Position or velocity changed since last forwarded
+
+    qint64 lastMessageMs = 0;
+    qint64 positionMs = 0;              // When position was last reported
+    qint64 lastForwardMs = 0;
+
+    // Payloads heard lately, so the same message through several
+    // receivers or feeds counts once
+    quint64 recentPayloads[RECENT_PAYLOADS] = {};
+    qint64 recentPayloadMs[RECENT_PAYLOADS] = {};
+    int nextRecent = 0;
+
+    // True, and the payload remembered, unless it was heard within windowMs
+    bool notePayload(quint64 payloadHash, qint64 nowMs, qint64 windowMs);
+};
+
+/**
+ * @brief Cooperative targets by ICAO address or Remote ID serial
+ *
+ * Open addressing with linear probing in one power-of-two array kept at
+ * most half full, and backward-shift deletion, so there are no tombstones
+ * and a lookup touches a slot or two of contiguous memory. A message finds
+ * its target without allocating; only a new target's id string is. The
+ * table refuses new targets beyond maxTargets rather than growing.
+ *
+ * Not thread-safe; one receiver owns it. Target pointers stay valid until
+ * the next insert or remove.
+ */
+class CooperativeTargetTable {
+public:
+    explicit CooperativeTargetTable(int maxTargets = 4096);
+
+    // Drops every target
+    void reset(int maxTargets);
+    void clear();
+
+    int size() const { return m_size; }
+    int maxTargets() const { return m_maxTargets; }
+    int capacity() const { return m_slots.size(); }
+
+    CooperativeTarget* find(quint64 key);
+    // The target for key, newly made (created set) if need be; null when
+    // the table already holds maxTargets
+    CooperativeTarget* insert(quint64 key, bool* created = nullptr);
+    bool remove(quint64 key);
+    // Removes targets not heard from since cutoffMs; returns how many
+    int expire(qint64 cutoffMs);
+
+    // Every held target, in slot order
+    template<typename Fn>
+    void forEach(Fn fn) {
+        for (CooperativeTarget& slot : m_slots) {
+            if (slot.key != 0) fn(slot);
+        }
+    }
+
+    static quint64 icaoKey(quint32 icao) { return (quint64(1) << 56) | (icao & 0xFFFFFF); }
+    // 64-bit FNV-1a, with the top bit set so it never meets an ICAO key
+    static quint64 serialKey(const char* data, int size);
+
+private:
+    int home(quint64 key) const;
+    int slotOf(quint64 key) const;      // -1 if absent
+
+    QVector<CooperativeTarget> m_slots;
+    QVector<quint64> m_expired;         // expire()'s scratch
+    int m_mask = 0;
+    int m_size = 0;
+    int m_maxTargets = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // COOPERATIVETARGETTABLE_H
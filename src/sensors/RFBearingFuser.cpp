@@ -0,0 +1,282 @@
+#include "sensors/RFBearingFuser.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/TimeUtils.h"
+#include <QTimer>
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+RFBearingFuser::RFBearingFuser(QObject* parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    QObject::connect(m_flushTimer, &QTimer::timeout, this, &RFBearingFuser::onFlushTimer);
+    setConfig(RFBearingFuserConfig());
+}
+
+RFBearingFuser::~RFBearingFuser() = default;
+
+void RFBearingFuser::setConfig(const RFBearingFuserConfig& config) {
+    m_config = config;
+    m_config.windowMs = qMax(1, config.windowMs);
+    m_config.frequencyBinMHz = qMax(0.001, config.frequencyBinMHz);
+    m_flushTimer->setInterval(qMax(10, m_config.windowMs / 4));
+}
+
+void RFBearingFuser::attachDetector(SensorInterface* detector) {
+    if (!detector) return;
+    QObject::connect(detector, &SensorInterface::detection,
+                     this, &RFBearingFuser::onDetection, Qt::UniqueConnection);
+    QObject::connect(detector, &SensorInterface::detectionBatch,
+                     this, &RFBearingFuser::onDetectionBatch, Qt::UniqueConnection);
+}
+
+void RFBearingFuser::detachDetector(SensorInterface* detector) {
+    if (!detector) return;
+    QObject::disconnect(detector, nullptr, this, nullptr);
+}
+
+void RFBearingFuser::addDetection(const SensorDetection& detection, qint64 nowMs) {
+    ++m_stats.detectionsIn;
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+
+    Bearing bearing;
+    if (!bearingOf(detection, bearing)) {
+        m_passThrough.append(detection);
+        ++m_stats.passedThrough;
+        return;
+    }
+
+    const RFEmissionInfo& rf = detection.info.rf;
+    const qint64 bin = static_cast<qint64>(std::floor(rf.frequencyMHz / m_config.frequencyBinMHz));
+    // Looked up without a copy of the protocol; a new bucket's key owns one
+    const BucketKey key = qMakePair(QByteArray::fromRawData(
+        rf.protocol, static_cast<int>(qstrnlen(rf.protocol, sizeof(rf.protocol)))), bin);
+
+    auto it = m_buckets.find(key);
+    if (it != m_buckets.end() && nowMs - it->openedMs >= m_config.windowMs) {
+        // The previous emission's window closed without a flush in between
+        close(*it, m_passThrough);
+        m_buckets.erase(it);
+        it = m_buckets.end();
+    }
+    if (it == m_buckets.end()) {
+        it = m_buckets.insert(qMakePair(QByteArray(key.first.constData(), key.first.size()), bin), Bucket());
+        it->openedMs = nowMs;
+    }
+
+    // A detector reporting twice within the window keeps only its latest bearing
+    for (int i = 0; i < it->detections.size(); ++i) {
+        if (it->detections[i].sensorId == detection.sensorId) {
+            it->detections[i] = detection;
+            it->bearings[i] = bearing;
+            return;
+        }
+    }
+    it->detections.append(detection);
+    it->bearings.append(bearing);
+}
+
+QVector<SensorDetection> RFBearingFuser::flush(qint64 nowMs, bool force) {
+    QVector<SensorDetection> out;
+    out.swap(m_passThrough);
+
+    for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+        if (force || nowMs - it->openedMs >= m_config.windowMs) {
+            close(*it, out);
+            it = m_buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return out;
+}
+
+bool RFBearingFuser::triangulate(const QVector<Bearing>& bearings, GeoPosition& fix,
+                                 double& residualM) const {
+    const int n = bearings.size();
+    if (n < 2) return false;
+
+    // Reject geometry where even the widest pair of bearings is near-parallel
+    double widest = 0.0;
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            widest = qMax(widest, std::fabs(std::sin(qDegreesToRadians(
+                bearings[i].azimuthDeg - bearings[j].azimuthDeg))));
+        }
+    }
+    if (widest < std::sin(qDegreesToRadians(m_config.minCrossingAngleDeg))) return false;
+
+    const GeoPosition origin = bearings[0].sensorPosition;
+    QVector<QPointF> sensors(n);
+    QVector<QPointF> directions(n);
+    for (int i = 0; i < n; ++i) {
+        sensors[i] = CoordinateUtils::geoToLocal(bearings[i].sensorPosition, origin);
+        const double az = qDegreesToRadians(bearings[i].azimuthDeg);
+        directions[i] = QPointF(std::sin(az), std::cos(az));  // East, north
+    }
+
+    // Minimise the weighted squared perpendicular miss of every bearing line.
+    // The first pass weights by angular accuracy alone; the second converts
+    // that to metres at the ranges the first pass found.
+    QPointF point;
+    QVector<double> ranges(n, 0.0);
+    for (int pass = 0; pass < 2; ++pass) {
+        double a11 = 0.0, a12 = 0.0, a22 = 0.0, b1 = 0.0, b2 = 0.0;
+        for (int i = 0; i < n; ++i) {
+            const double sigma = qDegreesToRadians(qMax(0.1, bearings[i].sigmaDeg));
+            const double spread = pass == 0 ? sigma : sigma * qMax(50.0, ranges[i]);
+            const double w = 1.0 / (spread * spread);
+            const double dx = directions[i].x();
+            const double dy = directions[i].y();
+            const double px = sensors[i].x();
+            const double py = sensors[i].y();
+            // w * (I - d d^T), applied to the sensor position for b
+            const double m11 = w * (1.0 - dx * dx);
+            const double m12 = -w * dx * dy;
+            const double m22 = w * (1.0 - dy * dy);
+            a11 += m11;
+            a12 += m12;
+            a22 += m22;
+            b1 += m11 * px + m12 * py;
+            b2 += m12 * px + m22 * py;
+        }
+
+        const double det = a11 * a22 - a12 * a12;
+        if (!(det > 1e-12 * (a11 + a22) * (a11 + a22))) return false;
+        point = QPointF((a22 * b1 - a12 * b2) / det, (a11 * b2 - a12 * b1) / det);
+
+        for (int i = 0; i < n; ++i) {
+            const QPointF offset = point - sensors[i];
+            ranges[i] = offset.x() * directions[i].x() + offset.y() * directions[i].y();
+        }
+    }
+
+    // Every sensor must be looking towards the fix, and at least one close enough
+    double nearest = HUGE_VAL;
+    for (int i = 0; i < n; ++i) {
+        if (ranges[i] <= 0.0) return false;
+        nearest = qMin(nearest, ranges[i]);
+    }
+    if (nearest > m_config.maxRangeM) return false;
+
+    double squaredMiss = 0.0;
+    double altitude = 0.0;
+    double altitudeWeight = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const QPointF offset = point - sensors[i];
+        const double miss = offset.x() * directions[i].y() - offset.y() * directions[i].x();
+        squaredMiss += miss * miss;
+
+        // Nearer sensors resolve elevation into height more precisely
+        const double horizontal = std::hypot(offset.x(), offset.y());
+        const double elevation = qDegreesToRadians(qBound(-10.0, bearings[i].elevationDeg, 80.0));
+        const double w = 1.0 / qMax(50.0, horizontal);
+        altitude += w * (bearings[i].sensorPosition.altitude + horizontal * std::tan(elevation));
+        altitudeWeight += w;
+    }
+    residualM = std::sqrt(squaredMiss / n);
+
+    fix = CoordinateUtils::localToGeo(point, origin);
+    fix.altitude = altitude / altitudeWeight;
+    return true;
+}
+
+void RFBearingFuser::onDetection(const SensorDetection& detection) {
+    const qint64 nowNs = detection.ingestMonoNs > 0 ? detection.ingestMonoNs
+                                                    : TimeUtils::monotonicNs();
+    addDetection(detection, nowNs / 1000000);
+}
+
+void RFBearingFuser::onDetectionBatch(const QVector<SensorDetection>& detections) {
+    for (const SensorDetection& detection : detections) {
+        onDetection(detection);
+    }
+}
+
+void RFBearingFuser::onFlushTimer() {
+    emitFlushed(TimeUtils::monotonicNs() / 1000000);
+    if (m_buckets.isEmpty() && m_passThrough.isEmpty()) {
+        m_flushTimer->stop();
+    }
+}
+
+bool RFBearingFuser::bearingOf(const SensorDetection& detection, Bearing& bearing) {
+    // RFDetector only publishes an accuracy when direction finding is on
+    const RFEmissionInfo& rf = detection.info.rf;
+    if (detection.sourceType != DetectionSource::RFDetector || !(rf.bearingSigmaDeg > 0.0f)) return false;
+
+    bearing.sensorPosition.latitude = rf.sensorLatitude;
+    bearing.sensorPosition.longitude = rf.sensorLongitude;
+    bearing.sensorPosition.altitude = rf.sensorAltitude;
+    bearing.azimuthDeg = rf.azimuthDeg;
+    bearing.elevationDeg = rf.elevationDeg;
+    bearing.sigmaDeg = rf.bearingSigmaDeg;
+    return true;
+}
+
+void RFBearingFuser::close(Bucket& bucket, QVector<SensorDetection>& out) {
+    int strongest = 0;
+    for (int i = 1; i < bucket.detections.size(); ++i) {
+        if (bucket.detections[i].signalStrength > bucket.detections[strongest].signalStrength) {
+            strongest = i;
+        }
+    }
+
+    GeoPosition fix;
+    double residualM = 0.0;
+    if (bucket.bearings.size() >= 2 && triangulate(bucket.bearings, fix, residualM)) {
+        const SensorDetection& best = bucket.detections[strongest];
+        SensorDetection fused;
+        fused.sensorId = m_config.fusedSensorId;
+        fused.position = fix;
+        fused.signalStrength = best.signalStrength;
+        fused.sourceType = DetectionSource::RFDetector;
+
+        double frequencySum = 0.0;
+        for (const SensorDetection& det : bucket.detections) {
+            frequencySum += det.info.rf.frequencyMHz;
+            fused.timestamp = qMax(fused.timestamp, det.timestamp);
+            if (det.ingestMonoNs > 0 &&
+                (fused.ingestMonoNs == 0 || det.ingestMonoNs < fused.ingestMonoNs)) {
+                fused.ingestMonoNs = det.ingestMonoNs;  // Latency from the first read
+            }
+        }
+
+        const int count = bucket.detections.size();
+        fused.confidence = qMin(0.95, 0.75 + 0.05 * count);
+        // The fix's own bearing fields stay unset: it is not for fusing again
+        RFEmissionInfo& rf = fused.info.rf;
+        std::memcpy(rf.protocol, best.info.rf.protocol, sizeof(rf.protocol));
+        rf.frequencyMHz = static_cast<float>(frequencySum / count);
+        rf.signalStrengthDbm = best.info.rf.signalStrengthDbm;
+        rf.sensorCount = static_cast<quint16>(count);
+        rf.residualM = static_cast<float>(residualM);
+        out.append(fused);
+
+        ++m_stats.fixes;
+        m_stats.bearingsFused += count;
+        return;
+    }
+
+    if (bucket.bearings.size() >= 2) {
+        ++m_stats.rejectedGeometry;
+    }
+    if (m_config.forwardUnfused && !bucket.detections.isEmpty()) {
+        out.append(bucket.detections[strongest]);
+        ++m_stats.passedThrough;
+    }
+}
+
+void RFBearingFuser::emitFlushed(qint64 nowMs) {
+    const QVector<SensorDetection> out = flush(nowMs);
+    if (!out.isEmpty()) {
+        emit detectionBatch(out);
+    }
+}
+
+} // namespace CounterUAS
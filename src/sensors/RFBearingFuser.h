@@ -0,0 +1,115 @@
+#ifndef RFBEARINGFUSER_H
+#define RFBEARINGFUSER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include "sensors/SensorInterface.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+/**
+ * @brief RF direction-finding fusion configuration
+ */
+struct RFBearingFuserConfig {
+    int windowMs = 250;                 // Bearings of one emission arrive within this
+    double frequencyBinMHz = 5.0;       // Bearings fuse when protocol and bin agree
+    double minCrossingAngleDeg = 10.0;  // Widest pair must cross at least this sharply
+    double maxRangeM = 5000.0;          // Fixes farther than this from every sensor are rejected
+    bool forwardUnfused = true;         // Pass the strongest single-sensor estimate on failure
+    QString fusedSensorId = "RF-DF";
+};
+
+/**
+ * @brief Triangulates bearings from several RFDetectors into single fixes
+ *
+ * Each RFDetector turns a bearing into a position by guessing range from
+ * signal strength, so four to six detectors report four to six scattered
+ * points for one emitter. The fuser buckets their detections by protocol and
+ * frequency bin over a short window, then intersects the bearings with a
+ * weighted least-squares fix in a local east-north plane. The result is one
+ * RFDetector detection per emission carrying the fix, the contributing
+ * sensor count and the residual. Buckets that cannot be fixed (one sensor,
+ * near-parallel bearings, fix behind a sensor) forward their strongest
+ * detection unchanged, so the rate into the TrackManager still drops.
+ *
+ * Attach detectors here instead of to the FusionEngine and connect
+ * detectionBatch() to FusionEngine::submitBatch().
+ */
+class RFBearingFuser : public QObject {
+    Q_OBJECT
+
+public:
+    struct Bearing {
+        GeoPosition sensorPosition;
+        double azimuthDeg = 0.0;
+        double elevationDeg = 0.0;
+        double sigmaDeg = 5.0;
+    };
+
+    explicit RFBearingFuser(QObject* parent = nullptr);
+    ~RFBearingFuser() override;
+
+    void setConfig(const RFBearingFuserConfig& config);
+    RFBearingFuserConfig config() const { return m_config; }
+
+    void attachDetector(SensorInterface* detector);
+    void detachDetector(SensorInterface* detector);
+
+    // Buckets one RFDetector detection. Detections without direction-finding
+    // fields (no bearingSigmaDeg) are passed through at the next flush.
+    void addDetection(const SensorDetection& detection, qint64 nowMs);
+
+    // Fixes every bucket whose window has closed (all, with force) and
+    // returns the resulting detections
+    QVector<SensorDetection> flush(qint64 nowMs, bool force = false);
+    int pendingBuckets() const { return m_buckets.size(); }
+
+    // Weighted least-squares intersection. False when the geometry is too
+    // weak to fix; residualM is the RMS miss distance of the bearings.
+    bool triangulate(const QVector<Bearing>& bearings, GeoPosition& fix,
+                     double& residualM) const;
+
+    struct Stats {
+        qint64 detectionsIn = 0;
+        qint64 fixes = 0;
+        qint64 bearingsFused = 0;
+        qint64 passedThrough = 0;
+        qint64 rejectedGeometry = 0;
+    };
+    Stats stats() const { return m_stats; }
+
+signals:
+    void detectionBatch(const QVector<SensorDetection>& detections);
+
+private slots:
+    void onDetection(const SensorDetection& detection);
+    void onDetectionBatch(const QVector<SensorDetection>& detections);
+    void onFlushTimer();
+
+private:
+    struct Bucket {
+        qint64 openedMs = 0;
+        QVector<SensorDetection> detections;   // Latest per sensor
+        QVector<Bearing> bearings;             // Parallel to detections
+    };
+
+    static bool bearingOf(const SensorDetection& detection, Bearing& bearing);
+    void close(Bucket& bucket, QVector<SensorDetection>& out);
+    void emitFlushed(qint64 nowMs);
+
+    RFBearingFuserConfig m_config;
+    using BucketKey = QPair<QByteArray, qint64>;   // Protocol and frequency bin
+    QHash<BucketKey, Bucket> m_buckets;
+    QVector<SensorDetection> m_passThrough;
+    QTimer* m_flushTimer;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // RFBEARINGFUSER_H
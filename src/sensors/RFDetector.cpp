@@ -1,29 +1,40 @@
 #include "sensors/RFDetector.h"
+#include "utils/LocalTangentPlane.h"
 #include "utils/Logger.h"
+#include "utils/RawCapture.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
 #include <QtMath>
 #include <QDataStream>
+#include <QDateTime>
+#include <QSerialPort>
+#include <QThread>
+#include <cmath>
+#include <cstring>
 
 namespace CounterUAS {
 
+bool RFCue::covers(double azimuthDeg, qint64 nowMs) const {
+    if (nowMs > untilMs) return false;
+    double offset = std::fmod(std::abs(azimuthDeg - bearingDeg), 360.0);
+    if (offset > 180.0) offset = 360.0 - offset;
+    return offset <= halfWidthDeg;
+}
+
 RFDetector::RFDetector(const QString& sensorId, QObject* parent)
     : SensorInterface(sensorId, parent)
-    , m_udpSocket(new QUdpSocket(this))
-    , m_serialPort(new QSerialPort(this))
+    , m_udpReceiver(new DatagramReceiver(this))
 {
-    QObject::connect(m_udpSocket, &QUdpSocket::readyRead, 
-            this, &RFDetector::onUdpReadyRead);
-    QObject::connect(m_serialPort, &QSerialPort::readyRead,
-            this, &RFDetector::onSerialReadyRead);
-    QObject::connect(m_serialPort, &QSerialPort::errorOccurred,
-            this, &RFDetector::onSerialError);
+    QObject::connect(m_udpReceiver, &DatagramReceiver::batchReady,
+            this, &RFDetector::onUdpBatch);
     
     // Add known drone protocols
     addKnownProtocol("DJI_OcuSync", QByteArray::fromHex("5aa5"));
     addKnownProtocol("DJI_Lightbridge", QByteArray::fromHex("55aa"));
     addKnownProtocol("FrSky", QByteArray::fromHex("7e"));
     addKnownProtocol("Futaba_FASST", QByteArray::fromHex("0f"));
-    addKnownProtocol("Generic_2.4GHz", QByteArray());
-    addKnownProtocol("Generic_5.8GHz", QByteArray());
+    addKnownProtocol("Generic_2.4GHz", QByteArray(), 2400.0, 2483.5);
+    addKnownProtocol("Generic_5.8GHz", QByteArray(), 5725.0, 5875.0);
 }
 
 RFDetector::~RFDetector() {
@@ -31,7 +42,11 @@ RFDetector::~RFDetector() {
 }
 
 void RFDetector::setConfig(const RFDetectorConfig& config) {
+    const bool newDatabase = config.signatureDatabasePath != m_config.signatureDatabasePath;
     m_config = config;
+    if (newDatabase && !m_config.signatureDatabasePath.isEmpty()) {
+        loadSignatureDatabase(m_config.signatureDatabasePath);
+    }
 }
 
 bool RFDetector::connect() {
@@ -40,8 +55,13 @@ bool RFDetector::connect() {
     setStatus(SensorStatus::Initializing);
     
     if (m_config.connectionType == RFDetectorConfig::ConnectionType::UDP) {
-        if (!m_udpSocket->bind(QHostAddress(m_config.udpHost), m_config.udpPort)) {
-            reportError("Failed to bind UDP socket: " + m_udpSocket->errorString());
+        DatagramReceiverConfig udp;
+        udp.address = QHostAddress(m_config.udpHost);
+        udp.port = m_config.udpPort;
+        udp.receiveBufferBytes = m_config.udpReceiveBufferBytes;
+        m_kernelDrops = 0;
+        if (!m_udpReceiver->start(udp)) {
+            reportError("Failed to bind UDP socket: " + m_udpReceiver->errorString());
             return false;
         }
         
@@ -51,14 +71,7 @@ bool RFDetector::connect() {
                                    .arg(m_config.udpHost)
                                    .arg(m_config.udpPort));
     } else {
-        m_serialPort->setPortName(m_config.serialPort);
-        m_serialPort->setBaudRate(m_config.baudRate);
-        m_serialPort->setDataBits(QSerialPort::Data8);
-        m_serialPort->setParity(QSerialPort::NoParity);
-        m_serialPort->setStopBits(QSerialPort::OneStop);
-        
-        if (!m_serialPort->open(QIODevice::ReadOnly)) {
-            reportError("Failed to open serial port: " + m_serialPort->errorString());
+        if (!openSerial()) {
             return false;
         }
         
@@ -75,13 +88,8 @@ bool RFDetector::connect() {
 }
 
 void RFDetector::disconnect() {
-    if (m_udpSocket->state() != QAbstractSocket::UnconnectedState) {
-        m_udpSocket->close();
-    }
-    
-    if (m_serialPort->isOpen()) {
-        m_serialPort->close();
-    }
+    m_udpReceiver->stop();
+    closeSerial();
     
     setStatus(SensorStatus::Offline);
     emit connectedChanged(false);
@@ -89,68 +97,243 @@ void RFDetector::disconnect() {
 
 bool RFDetector::isConnected() const {
     if (m_config.connectionType == RFDetectorConfig::ConnectionType::UDP) {
-        return m_udpSocket->state() == QAbstractSocket::BoundState;
+        return m_udpReceiver->isRunning();
     } else {
-        return m_serialPort->isOpen();
+        return m_serialOpen.load(std::memory_order_relaxed);
     }
 }
 
-void RFDetector::addKnownProtocol(const QString& name, const QByteArray& signature) {
-    m_knownProtocols[name] = signature;
+void RFDetector::addKnownProtocol(const QString& name, const QByteArray& signature,
+                                  double minFrequencyMHz, double maxFrequencyMHz) {
+    RFSignatureLibrary::Entry entry;
+    entry.name = name;
+    entry.signature = signature;
+    entry.minFrequencyMHz = static_cast<float>(minFrequencyMHz);
+    entry.maxFrequencyMHz = static_cast<float>(maxFrequencyMHz);
+    m_signatures.add(entry);
 }
 
-QString RFDetector::identifyProtocol(const QByteArray& signature) const {
-    for (auto it = m_knownProtocols.begin(); it != m_knownProtocols.end(); ++it) {
-        if (!it.value().isEmpty() && signature.startsWith(it.value())) {
-            return it.key();
-        }
+bool RFDetector::loadSignatureDatabase(const QString& path) {
+    QString error;
+    if (!m_signatures.loadFile(path, &error)) {
+        Logger::instance().warning("RFDetector",
+                                  QString("%1 keeps its current signatures; cannot load %2: %3")
+                                      .arg(m_sensorId, path, error));
+        return false;
     }
     
-    // Try to identify by frequency
-    return "Unknown";
+    Logger::instance().info("RFDetector",
+                           QString("%1 loaded %2 signatures from %3")
+                               .arg(m_sensorId).arg(m_signatures.size()).arg(path));
+    return true;
+}
+
+QString RFDetector::identifyProtocol(const QByteArray& signature, double frequencyMHz) const {
+    // Longest matching prefix, else a band-only entry for the frequency
+    const RFSignatureLibrary::Entry* entry = m_signatures.identify(signature, frequencyMHz);
+    return entry ? entry->name : QStringLiteral("Unknown");
 }
 
 void RFDetector::processData() {
     // Periodic processing - handled by socket callbacks
 }
 
-void RFDetector::onUdpReadyRead() {
-    while (m_udpSocket->hasPendingDatagrams()) {
-        QByteArray datagram;
-        datagram.resize(m_udpSocket->pendingDatagramSize());
-        
-        QHostAddress sender;
-        quint16 senderPort;
-        
-        m_udpSocket->readDatagram(datagram.data(), datagram.size(),
-                                  &sender, &senderPort);
-        
-        parseRFData(datagram);
+void RFDetector::onUdpBatch(const DatagramBatchPtr& batch) {
+    // Drops the kernel counted on the socket become this sensor's dropped packets
+    if (batch->kernelDrops() > m_kernelDrops) {
+        m_telemetry->recordDropped(static_cast<int>(batch->kernelDrops() - m_kernelDrops));
+        m_kernelDrops = batch->kernelDrops();
+    }
+    
+    m_readStampNs = batch->receivedNs();
+    m_telemetry->recordRead(batch->bytes());
+    
+    QVector<SensorDetection> detections;
+    detections.reserve(batch->count());
+    for (int i = 0; i < batch->count(); ++i) {
+        captureRaw(batch->data(i), batch->size(i), batch->receivedNs());
+        const qint64 parseStartNs = TimeUtils::monotonicNs();
+        parseRFData(QByteArray::fromRawData(batch->data(i), batch->size(i)), detections);
+        m_telemetry->recordParseNs(TimeUtils::monotonicNs() - parseStartNs);
+    }
+    m_telemetry->recordMessages(batch->count());
+    
+    // One batch per receive, so fusion takes the burst in one submission
+    if (!detections.isEmpty()) {
+        correctTimestamps(detections.data(), detections.size());
+        emit detectionBatch(detections);
     }
 }
 
-void RFDetector::onSerialReadyRead() {
-    m_buffer.append(m_serialPort->readAll());
-    
-    // Look for complete messages (assuming newline-delimited for simplicity)
-    while (m_buffer.contains('\n')) {
-        int idx = m_buffer.indexOf('\n');
-        QByteArray message = m_buffer.left(idx);
-        m_buffer.remove(0, idx + 1);
+bool RFDetector::openSerial() {
+    m_framer.setFraming(m_config.serialFraming);
+    m_framer.clear();
+    m_serialStalled.store(false);
+    
+    m_serialThread = new QThread(this);
+    m_serialThread->setObjectName("RFSerial");
+    m_serialContext = new QObject;
+    m_serialContext->moveToThread(m_serialThread);
+    QObject::connect(m_serialThread, &QThread::finished, m_serialContext, &QObject::deleteLater);
+    ThreadPlacement::instance().assign(m_serialThread, ThreadRole::SensorIO);
+    m_serialThread->start();
+    
+    QString error;
+    QMetaObject::invokeMethod(m_serialContext, [this, &error]() {
+        QSerialPort* port = new QSerialPort(m_serialContext);
+        port->setPortName(m_config.serialPort);
+        port->setBaudRate(m_config.baudRate);
+        port->setDataBits(QSerialPort::Data8);
+        port->setParity(QSerialPort::NoParity);
+        port->setStopBits(QSerialPort::OneStop);
+        // Bounded, so a stalled framer backs up into the driver instead of memory
+        port->setReadBufferSize(64 * 1024);
         
-        if (!message.isEmpty()) {
-            parseRFData(message);
+        if (!port->open(QIODevice::ReadOnly)) {
+            error = port->errorString();
+            delete port;
+            return;
         }
+        QObject::connect(port, &QSerialPort::readyRead, m_serialContext, [this]() { readSerial(); });
+        QObject::connect(port, &QSerialPort::errorOccurred, m_serialContext,
+                         [this, port](QSerialPort::SerialPortError code) {
+            if (code == QSerialPort::NoError) return;
+            const QString message = "Serial port error: " + port->errorString();
+            QMetaObject::invokeMethod(this, [this, message]() { reportError(message); },
+                                      Qt::QueuedConnection);
+        });
+        m_serialPort = port;
+        m_serialOpen.store(true);
+    }, Qt::BlockingQueuedConnection);
+    
+    if (!m_serialOpen.load()) {
+        closeSerial();
+        reportError("Failed to open serial port: " + error);
+        return false;
     }
+    return true;
+}
+
+void RFDetector::closeSerial() {
+    if (!m_serialThread) return;
+    
+    // The port goes with the context
+    m_serialThread->quit();
+    m_serialThread->wait();
+    delete m_serialThread;
+    m_serialThread = nullptr;
+    m_serialContext = nullptr;
+    m_serialPort = nullptr;
+    m_serialOpen.store(false);
+    m_serialStalled.store(false);
+    m_framer.clear();
+    m_telemetry->setQueueDepth(0);
 }
 
-void RFDetector::onSerialError(QSerialPort::SerialPortError error) {
-    if (error != QSerialPort::NoError) {
-        reportError("Serial port error: " + m_serialPort->errorString());
+void RFDetector::readSerial() {
+    qint64 total = 0;
+    for (;;) {
+        int available = 0;
+        char* region = m_framer.writeRegion(available);
+        if (available == 0) {
+            // Wait for drainSerial() to free space, unless it just did
+            m_serialStalled.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            region = m_framer.writeRegion(available);
+            if (available == 0) break;
+            m_serialStalled.store(false);
+        }
+        const qint64 bytesRead = m_serialPort->read(region, available);
+        if (bytesRead <= 0) break;
+        captureRaw(region, static_cast<int>(bytesRead));
+        m_framer.commit(static_cast<int>(bytesRead));
+        total += bytesRead;
     }
+    if (total == 0) return;
+    
+    m_serialReadNs.store(TimeUtils::monotonicNs(), std::memory_order_relaxed);
+    m_telemetry->recordRead(total);
+    
+    // One queued drain however many reads land before it runs
+    if (!m_drainPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, [this]() { drainSerial(); }, Qt::QueuedConnection);
+    }
+}
+
+void RFDetector::drainSerial() {
+    m_drainPending.store(false);
+    m_readStampNs = m_serialReadNs.load(std::memory_order_relaxed);
+    
+    QVector<SensorDetection> detections;
+    const char* message = nullptr;
+    int length = 0;
+    int messages = 0;
+    while (m_framer.next(message, length)) {
+        // The message is parsed where it lies in the ring
+        const qint64 parseStartNs = TimeUtils::monotonicNs();
+        parseRFData(QByteArray::fromRawData(message, length), detections);
+        m_telemetry->recordParseNs(TimeUtils::monotonicNs() - parseStartNs);
+        ++messages;
+    }
+    m_telemetry->recordMessages(messages);
+    m_telemetry->setQueueDepth(m_framer.size());
+    
+    // Everything framed is released now; a reader that found the ring full resumes
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_serialContext && m_serialStalled.exchange(false)) {
+        QMetaObject::invokeMethod(m_serialContext, [this]() { readSerial(); }, Qt::QueuedConnection);
+    }
+    
+    if (!detections.isEmpty()) {
+        correctTimestamps(detections.data(), detections.size());
+        emit detectionBatch(detections);
+    }
+}
+
+bool RFDetector::replayRaw(const QByteArray& data) {
+    if (isConnected()) return false;
+    
+    if (m_config.connectionType == RFDetectorConfig::ConnectionType::UDP) {
+        m_readStampNs = TimeUtils::monotonicNs();
+        m_telemetry->recordRead(data.size());
+        QVector<SensorDetection> detections;
+        parseRFData(data, detections);
+        m_telemetry->recordMessages(1);
+        if (!detections.isEmpty()) {
+            correctTimestamps(detections.data(), detections.size());
+            emit detectionBatch(detections);
+        }
+        return true;
+    }
+    
+    // No serial thread while closed, so the ring is filled and framed here
+    m_framer.setFraming(m_config.serialFraming);
+    m_serialReadNs.store(TimeUtils::monotonicNs(), std::memory_order_relaxed);
+    m_telemetry->recordRead(data.size());
+    int offset = 0;
+    while (offset < data.size()) {
+        int available = 0;
+        char* region = m_framer.writeRegion(available);
+        if (available == 0) {
+            drainSerial();
+            region = m_framer.writeRegion(available);
+            if (available == 0) break;  // A message longer than the ring
+        }
+        const int bytes = qMin(available, data.size() - offset);
+        memcpy(region, data.constData() + offset, bytes);
+        m_framer.commit(bytes);
+        offset += bytes;
+    }
+    drainSerial();
+    return true;
+}
+
+RawCaptureKind RFDetector::rawCaptureKind() const {
+    return m_config.connectionType == RFDetectorConfig::ConnectionType::UDP
+         ? RawCaptureKind::Datagram : RawCaptureKind::Stream;
 }
 
-void RFDetector::parseRFData(const QByteArray& data) {
+void RFDetector::parseRFData(const QByteArray& data, QVector<SensorDetection>& detections) {
     // Parse RF detection data
     // Expected format: binary structure or JSON
     
@@ -186,12 +369,16 @@ void RFDetector::parseRFData(const QByteArray& data) {
         return;
     }
     
-    if (rfDet.signalStrengthDbm < m_config.signalThresholdDbm) {
+    double thresholdDbm = m_config.signalThresholdDbm;
+    if (m_cue.untilMs > 0 && m_cue.covers(rfDet.azimuthDeg, QDateTime::currentMSecsSinceEpoch())) {
+        thresholdDbm -= m_config.cueReliefDb;
+    }
+    if (rfDet.signalStrengthDbm < thresholdDbm) {
         return;
     }
     
     // Identify protocol
-    rfDet.protocol = identifyProtocol(rfDet.signature);
+    rfDet.protocol = identifyProtocol(rfDet.signature, rfDet.frequencyMHz);
     
     // Estimate position
     GeoPosition estimatedPos = estimatePosition(rfDet);
@@ -204,15 +391,25 @@ void RFDetector::parseRFData(const QByteArray& data) {
     sensorDetection.confidence = m_config.enableDirectionFinding ? 0.7 : 0.4;
     sensorDetection.timestamp = rfDet.timestamp;
     sensorDetection.sourceType = DetectionSource::RFDetector;
-    sensorDetection.metadata["frequencyMHz"] = rfDet.frequencyMHz;
-    sensorDetection.metadata["signalStrengthDbm"] = rfDet.signalStrengthDbm;
-    sensorDetection.metadata["protocol"] = rfDet.protocol;
-    sensorDetection.metadata["azimuthDeg"] = rfDet.azimuthDeg;
+    sensorDetection.ingestMonoNs = m_readStampNs;
+    RFEmissionInfo& rf = sensorDetection.info.rf;
+    setFixedString(rf.protocol, rfDet.protocol);
+    rf.frequencyMHz = rfDet.frequencyMHz;
+    rf.signalStrengthDbm = rfDet.signalStrengthDbm;
+    rf.azimuthDeg = rfDet.azimuthDeg;
+    if (m_config.enableDirectionFinding) {
+        // Lets an RFBearingFuser triangulate against other detectors
+        rf.elevationDeg = rfDet.elevationDeg;
+        rf.bearingSigmaDeg = qMax(0.01, m_config.dfAccuracyDeg);
+        rf.sensorLatitude = m_position.latitude;
+        rf.sensorLongitude = m_position.longitude;
+        rf.sensorAltitude = m_position.altitude;
+    }
     
     recordDetection();
     
     emit rfDetection(rfDet);
-    emit detection(sensorDetection);
+    detections.append(sensorDetection);
 }
 
 GeoPosition RFDetector::estimatePosition(const RFDetection& detection) {
@@ -241,16 +438,12 @@ GeoPosition RFDetector::estimatePosition(const RFDetection& detection) {
     
     double horizontalRange = estimatedRangeM * std::cos(elRad);
     
-    double northOffset = horizontalRange * std::cos(azRad);
-    double eastOffset = horizontalRange * std::sin(azRad);
-    double altOffset = estimatedRangeM * std::sin(elRad);
-    
-    GeoPosition result;
-    result.latitude = m_position.latitude + (northOffset / 111000.0);
-    result.longitude = m_position.longitude + (eastOffset / (111000.0 * std::cos(qDegreesToRadians(m_position.latitude))));
-    result.altitude = m_position.altitude + altOffset;
+    EnuVector offset;
+    offset.east = horizontalRange * std::sin(azRad);
+    offset.north = horizontalRange * std::cos(azRad);
+    offset.up = estimatedRangeM * std::sin(elRad);
     
-    return result;
+    return LocalTangentPlane(m_position).toGeoLinear(offset);
 }
 
 } // namespace CounterUAS
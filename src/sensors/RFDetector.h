@@ -2,9 +2,14 @@
 #define RFDETECTOR_H
 
 #include "sensors/SensorInterface.h"
-#include <QUdpSocket>
-#include <QSerialPort>
+#include "sensors/RFSignatureLibrary.h"
+#include "sensors/RFSerialFramer.h"
+#include "utils/DatagramReceiver.h"
 #include <QHostAddress>
+#include <atomic>
+
+class QSerialPort;
+class QThread;
 
 namespace CounterUAS {
 
@@ -33,10 +38,12 @@ struct RFDetectorConfig {
     // UDP settings
     QString udpHost = "127.0.0.1";
     quint16 udpPort = 5002;
+    int udpReceiveBufferBytes = 4 * 1024 * 1024;   // Kernel socket buffer for bursts
     
     // Serial settings
     QString serialPort = "/dev/ttyUSB0";
     qint32 baudRate = 115200;
+    RFSerialFramer::Framing serialFraming = RFSerialFramer::Framing::Newline;
     
     // Detection parameters
     double minFrequencyMHz = 900.0;
@@ -48,6 +55,23 @@ struct RFDetectorConfig {
     // Antenna array position (for DF)
     double antennaSpacingM = 0.5;
     int antennaCount = 4;
+    
+    // Binary signature database replacing the built-in protocols; empty keeps them
+    QString signatureDatabasePath;
+    
+    // Detections on a cued bearing pass a threshold this much lower
+    double cueReliefDb = 10.0;
+};
+
+/**
+ * @brief A sector the detector is told to look harder in, see RFDetector::setCue()
+ */
+struct RFCue {
+    double bearingDeg = 0.0;        // From north, at the detector
+    double halfWidthDeg = 0.0;
+    qint64 untilMs = 0;             // Epoch ms; the cue lapses after it
+    
+    bool covers(double azimuthDeg, qint64 nowMs) const;
 };
 
 /**
@@ -76,8 +100,21 @@ public:
     RFDetectorConfig config() const { return m_config; }
     
     // Protocol database
-    void addKnownProtocol(const QString& name, const QByteArray& signature);
-    QString identifyProtocol(const QByteArray& signature) const;
+    void addKnownProtocol(const QString& name, const QByteArray& signature,
+                          double minFrequencyMHz = 0.0, double maxFrequencyMHz = 0.0);
+    bool loadSignatureDatabase(const QString& path);
+    const RFSignatureLibrary& signatureLibrary() const { return m_signatures; }
+    QString identifyProtocol(const QByteArray& signature, double frequencyMHz = 0.0) const;
+    
+    // Cued search: until the cue lapses, signals within its sector pass
+    // cueReliefDb under signalThresholdDbm. One cue at a time; a new one
+    // replaces it. Call on the detector's thread
+    void setCue(const RFCue& cue) { m_cue = cue; }
+    void clearCue() { m_cue = RFCue(); }
+    RFCue cue() const { return m_cue; }
+    
+    // Captured reads, only while disconnected: one framer cannot take two streams
+    bool replayRaw(const QByteArray& data) override;
     
 signals:
     void rfDetection(const RFDetection& detection);
@@ -86,21 +123,41 @@ signals:
 protected slots:
     void processData() override;
     
+protected:
+    // Set the config first: serial reads are a stream, UDP ones datagrams
+    RawCaptureKind rawCaptureKind() const override;
+    
 private slots:
-    void onUdpReadyRead();
-    void onSerialReadyRead();
-    void onSerialError(QSerialPort::SerialPortError error);
+    void onUdpBatch(const DatagramBatchPtr& batch);
     
 private:
-    void parseRFData(const QByteArray& data);
+    bool openSerial();
+    void closeSerial();
+    void readSerial();      // Serial thread: port into the framer
+    void drainSerial();     // Here: framer into parseRFData
+    
+    // Appends the detection, if the message holds one that passes the filters
+    void parseRFData(const QByteArray& data, QVector<SensorDetection>& detections);
     GeoPosition estimatePosition(const RFDetection& detection);
     
-    QUdpSocket* m_udpSocket;
-    QSerialPort* m_serialPort;
+    DatagramReceiver* m_udpReceiver;   // Reads on its own thread, parsed here a batch at a time
     RFDetectorConfig m_config;
     
-    QHash<QString, QByteArray> m_knownProtocols;
-    QByteArray m_buffer;
+    // The port is read on its own thread straight into the framer's ring;
+    // messages are framed and parsed here in place
+    QThread* m_serialThread = nullptr;
+    QObject* m_serialContext = nullptr;    // Lives on m_serialThread, parents the port
+    QSerialPort* m_serialPort = nullptr;   // Serial thread only
+    RFSerialFramer m_framer;
+    std::atomic<bool> m_serialOpen{false};
+    std::atomic<bool> m_drainPending{false};    // A drainSerial() is queued
+    std::atomic<bool> m_serialStalled{false};   // Ring full, reading waits on a drain
+    std::atomic<qint64> m_serialReadNs{0};      // Monotonic time of the latest read
+    
+    RFSignatureLibrary m_signatures;
+    RFCue m_cue;
+    qint64 m_readStampNs = 0;  // Monotonic time of the read being parsed
+    quint64 m_kernelDrops = 0;  // Last DatagramBatch::kernelDrops() counted
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,134 @@
+#include "sensors/RFSerialFramer.h"
+#include <QtGlobal>
+#include <cstring>
+
+namespace CounterUAS {
+
+RFSerialFramer::RFSerialFramer(int capacity) {
+    int size = 1;
+    while (size < qMax(capacity, 4 * MAX_MESSAGE_SIZE)) size *= 2;
+    m_ring = QByteArray(size, Qt::Uninitialized);
+    m_mask = size - 1;
+}
+
+void RFSerialFramer::clear() {
+    m_written.store(0, std::memory_order_relaxed);
+    m_released.store(0, std::memory_order_relaxed);
+    m_read = 0;
+    m_scanned = 0;
+    m_skipLine = false;
+}
+
+char* RFSerialFramer::writeRegion(int& available) {
+    const qint64 written = m_written.load(std::memory_order_relaxed);
+    const qint64 free = m_ring.size() - (written - m_released.load(std::memory_order_acquire));
+    const qint64 tail = written & m_mask;
+    available = static_cast<int>(qMin<qint64>(free, m_ring.size() - tail));
+    return m_ring.data() + tail;
+}
+
+void RFSerialFramer::commit(int bytes) {
+    if (bytes <= 0) return;
+    m_written.fetch_add(bytes, std::memory_order_release);
+}
+
+bool RFSerialFramer::next(const char*& message, int& length) {
+    // The message handed out last time is done with
+    m_released.store(m_read, std::memory_order_release);
+
+    const bool found = m_framing == Framing::Newline ? nextLine(message, length)
+                                                     : nextPrefixed(message, length);
+    if (!found) {
+        m_released.store(m_read, std::memory_order_release);
+    }
+    return found;
+}
+
+int RFSerialFramer::size() const {
+    return static_cast<int>(m_written.load(std::memory_order_acquire) -
+                            m_released.load(std::memory_order_acquire));
+}
+
+bool RFSerialFramer::nextLine(const char*& message, int& length) {
+    const qint64 capacity = m_ring.size();
+    for (;;) {
+        const qint64 available = m_written.load(std::memory_order_acquire) - m_read;
+
+        // Search only what arrived since the last call, a contiguous run at a time
+        qint64 newline = -1;
+        while (m_scanned < available) {
+            const qint64 start = (m_read + m_scanned) & m_mask;
+            const qint64 run = qMin(available - m_scanned, capacity - start);
+            const void* hit = std::memchr(m_ring.constData() + start, '\n', static_cast<size_t>(run));
+            if (hit) {
+                newline = m_scanned + (static_cast<const char*>(hit) - (m_ring.constData() + start));
+                break;
+            }
+            m_scanned += run;
+        }
+
+        if (newline < 0) {
+            if (m_skipLine || available > MAX_MESSAGE_SIZE) {
+                // No sane message is this long; drop it through its newline
+                m_discarded += available;
+                consume(available);
+                m_skipLine = true;
+            }
+            return false;
+        }
+
+        const bool skipped = m_skipLine;
+        m_skipLine = false;
+        if (skipped || newline == 0 || newline > MAX_MESSAGE_SIZE) {
+            if (skipped || newline > 0) m_discarded += newline + 1;
+            consume(newline + 1);
+            continue;
+        }
+
+        length = static_cast<int>(newline);
+        message = linear(0, length);
+        consume(newline + 1);
+        return true;
+    }
+}
+
+bool RFSerialFramer::nextPrefixed(const char*& message, int& length) {
+    for (;;) {
+        const qint64 available = m_written.load(std::memory_order_acquire) - m_read;
+        if (available < PREFIX_SIZE) return false;
+
+        const int size = static_cast<uchar>(at(2)) | (static_cast<uchar>(at(3)) << 8);
+        if (at(0) != SYNC_0 || at(1) != SYNC_1 || size == 0 || size > MAX_MESSAGE_SIZE) {
+            ++m_discarded;
+            consume(1);
+            continue;
+        }
+        if (available < PREFIX_SIZE + size) return false;
+
+        length = size;
+        message = linear(PREFIX_SIZE, size);
+        consume(PREFIX_SIZE + size);
+        return true;
+    }
+}
+
+const char* RFSerialFramer::linear(qint64 offset, int count) {
+    const qint64 start = (m_read + offset) & m_mask;
+    if (start + count <= m_ring.size()) {
+        return m_ring.constData() + start;
+    }
+    if (m_scratch.size() < count) {
+        m_scratch.resize(count);
+    }
+    const int first = static_cast<int>(m_ring.size() - start);
+    std::memcpy(m_scratch.data(), m_ring.constData() + start, first);
+    std::memcpy(m_scratch.data() + first, m_ring.constData(), count - first);
+    return m_scratch.constData();
+}
+
+void RFSerialFramer::consume(qint64 count) {
+    m_read += count;
+    m_scanned = qMax<qint64>(0, m_scanned - count);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,80 @@
+#ifndef RFSERIALFRAMER_H
+#define RFSERIALFRAMER_H
+
+#include <QByteArray>
+#include <atomic>
+
+namespace CounterUAS {
+
+/**
+ * @brief Incremental splitter for an RF detector's serial stream
+ *
+ * A fixed ring with one writer and one reader, which may be different
+ * threads: the serial thread reads straight into writeRegion() and
+ * commit()s, the detector's thread calls next(), which hands back a
+ * pointer into the ring. Only a message that wraps past the end of the
+ * ring is copied, into a reused scratch buffer. A message stays valid, and
+ * its bytes stay out of the writer's reach, until the next call to next().
+ *
+ * Newline framing ends each message at '\n' and skips empty ones; the
+ * scan resumes where the last one stopped, so a long line arriving in
+ * pieces is searched once. A line longer than MAX_MESSAGE_SIZE is
+ * discarded. LengthPrefixed framing is sync "RF", a little-endian u16
+ * length, then the message; a bad sync or a length of 0 or over
+ * MAX_MESSAGE_SIZE skips one byte, so the stream resynchronizes on the
+ * next sync.
+ */
+class RFSerialFramer {
+public:
+    enum class Framing { Newline, LengthPrefixed };
+
+    static constexpr int MAX_MESSAGE_SIZE = 16 * 1024;
+    static constexpr int PREFIX_SIZE = 4;
+    static constexpr char SYNC_0 = 'R';
+    static constexpr char SYNC_1 = 'F';
+
+    explicit RFSerialFramer(int capacity = 256 * 1024);
+
+    RFSerialFramer(const RFSerialFramer&) = delete;
+    RFSerialFramer& operator=(const RFSerialFramer&) = delete;
+
+    // Only while neither side is running
+    void setFraming(Framing framing) { m_framing = framing; }
+    Framing framing() const { return m_framing; }
+    void clear();
+
+    // Writer: contiguous free space, 0 bytes while the ring is full
+    char* writeRegion(int& available);
+    void commit(int bytes);
+
+    // Reader. Returns false when more data is needed.
+    bool next(const char*& message, int& length);
+    int size() const;      // Bytes buffered, the held message included
+    qint64 discardedBytes() const { return m_discarded; }
+
+private:
+    bool nextLine(const char*& message, int& length);
+    bool nextPrefixed(const char*& message, int& length);
+    const char* linear(qint64 offset, int count);
+    char at(qint64 offset) const { return m_ring.constData()[(m_read + offset) & m_mask]; }
+    void consume(qint64 count);
+
+    QByteArray m_ring;          // Power-of-two capacity
+    qint64 m_mask = 0;
+    Framing m_framing = Framing::Newline;
+
+    // Totals since clear(); each index is (total & m_mask)
+    std::atomic<qint64> m_written{0};   // Writer stores, reader loads
+    std::atomic<qint64> m_released{0};  // Reader stores, writer loads
+
+    // Reader only
+    qint64 m_read = 0;          // Start of the unframed data
+    qint64 m_scanned = 0;       // Bytes past m_read already searched for '\n'
+    bool m_skipLine = false;    // Dropping an overlong line through its '\n'
+    QByteArray m_scratch;
+    qint64 m_discarded = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // RFSERIALFRAMER_H
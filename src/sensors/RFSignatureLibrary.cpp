@@ -0,0 +1,201 @@
+#include "sensors/RFSignatureLibrary.h"
+#include <QDataStream>
+#include <QFile>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+RFSignatureLibrary::RFSignatureLibrary() {
+    clear();
+}
+
+void RFSignatureLibrary::add(const Entry& entry) {
+    if (entry.name.isEmpty()) return;
+
+    auto existing = m_byName.constFind(entry.name);
+    if (existing != m_byName.constEnd()) {
+        // Replacing is rare (reconfiguration), so re-index from scratch
+        m_entries[existing.value()] = entry;
+        rebuild();
+        return;
+    }
+
+    const int index = m_entries.size();
+    m_entries.append(entry);
+    m_byName.insert(entry.name, index);
+
+    if (entry.signature.isEmpty()) {
+        if (!entry.hasBand()) return;  // Nothing to identify it by
+        const int first = static_cast<int>(std::floor(entry.minFrequencyMHz / BUCKET_MHZ));
+        const int last = static_cast<int>(std::floor(entry.maxFrequencyMHz / BUCKET_MHZ));
+        for (int bucket = first; bucket <= last; ++bucket) {
+            m_bandBuckets[bucket].append(index);
+        }
+        return;
+    }
+
+    int node = 0;
+    for (char c : entry.signature) {
+        const quint8 byte = static_cast<quint8>(c);
+        const int next = child(node, byte);
+        node = next >= 0 ? next : addChild(node, byte);
+    }
+    m_nodes[node].entries.append(index);
+}
+
+void RFSignatureLibrary::clear() {
+    m_entries.clear();
+    m_byName.clear();
+    m_nodes.clear();
+    m_nodes.append(Node());
+    m_bandBuckets.clear();
+}
+
+const RFSignatureLibrary::Entry* RFSignatureLibrary::identify(const QByteArray& signature,
+                                                              double frequencyMHz) const {
+    // Walk as far as the signature goes; deeper matches are more specific
+    const Entry* best = nullptr;
+    int node = 0;
+    for (char c : signature) {
+        node = child(node, static_cast<quint8>(c));
+        if (node < 0) break;
+        if (!m_nodes[node].entries.isEmpty()) {
+            if (const Entry* match = bestOf(m_nodes[node].entries, frequencyMHz)) {
+                best = match;
+            }
+        }
+    }
+    if (best || frequencyMHz <= 0.0) return best;
+
+    auto bucket = m_bandBuckets.constFind(static_cast<int>(std::floor(frequencyMHz / BUCKET_MHZ)));
+    return bucket != m_bandBuckets.constEnd() ? bestOf(bucket.value(), frequencyMHz) : nullptr;
+}
+
+bool RFSignatureLibrary::load(const QByteArray& data, QString* error) {
+    auto fail = [error](const QString& message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    QDataStream stream(data);
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != DATABASE_MAGIC) {
+        return fail("Not an RF signature database");
+    }
+    if (version != DATABASE_VERSION) {
+        return fail(QString("Unsupported signature database version %1").arg(version));
+    }
+
+    // Parse everything before touching the live library
+    QVector<Entry> entries;
+    entries.reserve(static_cast<int>(qMin<quint32>(count, 65536)));
+    for (quint32 i = 0; i < count; ++i) {
+        quint8 nameLength = 0;
+        stream >> nameLength;
+        QByteArray name(nameLength, Qt::Uninitialized);
+        if (stream.readRawData(name.data(), nameLength) != nameLength) break;
+
+        quint8 signatureLength = 0;
+        stream >> signatureLength;
+        Entry entry;
+        entry.name = QString::fromUtf8(name);
+        entry.signature.resize(signatureLength);
+        if (stream.readRawData(entry.signature.data(), signatureLength) != signatureLength) break;
+
+        stream >> entry.minFrequencyMHz >> entry.maxFrequencyMHz;
+        if (stream.status() != QDataStream::Ok) break;
+        entries.append(entry);
+    }
+    if (static_cast<quint32>(entries.size()) != count) {
+        return fail(QString("Signature database truncated at entry %1 of %2")
+                        .arg(entries.size()).arg(count));
+    }
+
+    clear();
+    for (const Entry& entry : entries) {
+        add(entry);
+    }
+    return true;
+}
+
+bool RFSignatureLibrary::loadFile(const QString& path, QString* error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return load(file.readAll(), error);
+}
+
+QByteArray RFSignatureLibrary::save() const {
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream << DATABASE_MAGIC << DATABASE_VERSION << static_cast<quint32>(m_entries.size());
+    for (const Entry& entry : m_entries) {
+        const QByteArray name = entry.name.toUtf8().left(255);
+        const QByteArray signature = entry.signature.left(255);
+        stream << static_cast<quint8>(name.size());
+        stream.writeRawData(name.constData(), name.size());
+        stream << static_cast<quint8>(signature.size());
+        stream.writeRawData(signature.constData(), signature.size());
+        stream << entry.minFrequencyMHz << entry.maxFrequencyMHz;
+    }
+    return data;
+}
+
+int RFSignatureLibrary::child(int node, quint8 byte) const {
+    const QVector<Edge>& edges = m_nodes[node].edges;
+    auto it = std::lower_bound(edges.begin(), edges.end(), byte,
+                               [](const Edge& edge, quint8 b) { return edge.byte < b; });
+    return it != edges.end() && it->byte == byte ? it->node : -1;
+}
+
+int RFSignatureLibrary::addChild(int node, quint8 byte) {
+    const int created = m_nodes.size();
+    m_nodes.append(Node());
+
+    QVector<Edge>& edges = m_nodes[node].edges;
+    auto it = std::lower_bound(edges.begin(), edges.end(), byte,
+                               [](const Edge& edge, quint8 b) { return edge.byte < b; });
+    edges.insert(it, Edge{byte, created});
+    return created;
+}
+
+const RFSignatureLibrary::Entry* RFSignatureLibrary::bestOf(const QVector<int>& entries,
+                                                            double frequencyMHz) const {
+    // Among entries that fit the frequency, the narrowest band is the most specific
+    const Entry* best = nullptr;
+    double bestWidth = 0.0;
+    for (int index : entries) {
+        const Entry& entry = m_entries[index];
+        if (frequencyMHz > 0.0 && !entry.covers(frequencyMHz)) continue;
+
+        const double width = entry.hasBand() ? entry.maxFrequencyMHz - entry.minFrequencyMHz
+                                             : HUGE_VAL;
+        if (!best || width < bestWidth) {
+            best = &entry;
+            bestWidth = width;
+        }
+    }
+    return best;
+}
+
+void RFSignatureLibrary::rebuild() {
+    const QVector<Entry> entries = m_entries;
+    clear();
+    for (const Entry& entry : entries) {
+        add(entry);
+    }
+}
+
+} // namespace CounterUAS
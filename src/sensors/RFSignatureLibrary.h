@@ -0,0 +1,82 @@
+#ifndef RFSIGNATURELIBRARY_H
+#define RFSIGNATURELIBRARY_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace CounterUAS {
+
+/**
+ * @brief Drone control-link signatures indexed for per-detection lookup
+ *
+ * Signatures are byte prefixes held in a trie, so identifying a burst costs
+ * one step per signature byte whatever the size of the library, and the
+ * longest (most specific) matching prefix wins. An entry may be restricted
+ * to a frequency band. Entries without a signature identify by band alone,
+ * through a table of 10 MHz buckets, when no prefix matches.
+ *
+ * The binary database is big-endian: magic "CURF", u16 version (1), u32
+ * entry count, then per entry u8 name length, UTF-8 name, u8 signature
+ * length, signature bytes, and float32 band minimum and maximum in MHz
+ * (both zero for any band).
+ */
+class RFSignatureLibrary {
+public:
+    struct Entry {
+        QString name;
+        QByteArray signature;
+        float minFrequencyMHz = 0.0f;   // Both zero: any band
+        float maxFrequencyMHz = 0.0f;
+
+        bool hasBand() const { return maxFrequencyMHz > minFrequencyMHz; }
+        bool covers(double frequencyMHz) const {
+            return !hasBand() || (frequencyMHz >= minFrequencyMHz && frequencyMHz <= maxFrequencyMHz);
+        }
+    };
+
+    static constexpr quint32 DATABASE_MAGIC = 0x43555246;  // "CURF"
+    static constexpr quint16 DATABASE_VERSION = 1;
+
+    RFSignatureLibrary();
+
+    // Adds or replaces the entry called name
+    void add(const Entry& entry);
+    void clear();
+    int size() const { return m_byName.size(); }
+
+    // Best entry for the burst, or null. A frequency of zero or less skips
+    // band checks and the band-only fallback.
+    const Entry* identify(const QByteArray& signature, double frequencyMHz = 0.0) const;
+
+    bool load(const QByteArray& data, QString* error = nullptr);
+    bool loadFile(const QString& path, QString* error = nullptr);
+    QByteArray save() const;
+
+private:
+    struct Edge {
+        quint8 byte;
+        int node;
+    };
+    struct Node {
+        QVector<Edge> edges;   // Sorted by byte
+        QVector<int> entries;  // Entries whose signature ends here
+    };
+
+    int child(int node, quint8 byte) const;
+    int addChild(int node, quint8 byte);
+    const Entry* bestOf(const QVector<int>& entries, double frequencyMHz) const;
+    void rebuild();
+
+    static constexpr double BUCKET_MHZ = 10.0;
+
+    QVector<Entry> m_entries;          // Slot reused when a name is replaced
+    QHash<QString, int> m_byName;
+    QVector<Node> m_nodes;             // m_nodes[0] is the root
+    QHash<int, QVector<int>> m_bandBuckets;   // Band-only entries by 10 MHz bucket
+};
+
+} // namespace CounterUAS
+
+#endif // RFSIGNATURELIBRARY_H
@@ -0,0 +1,233 @@
+#include "sensors/RadarFrameParser.h"
+#include "sensors/RadarSensor.h"
+#include "utils/LocalTangentPlane.h"
+#include <QtEndian>
+#include <QtMath>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int SINE_STEPS = 3600;  // 0.1 degree
+
+const std::array<double, SINE_STEPS + 1>& sineTable() {
+    static const std::array<double, SINE_STEPS + 1> table = []() {
+        std::array<double, SINE_STEPS + 1> t{};
+        for (int i = 0; i <= SINE_STEPS; ++i) {
+            t[i] = std::sin(2.0 * M_PI * i / SINE_STEPS);
+        }
+        return t;
+    }();
+    return table;
+}
+
+double readDouble(const uchar* bytes) {
+    const quint64 bits = qFromBigEndian<quint64>(bytes);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+// RadarFrameParser
+
+RadarFrameParser::RadarFrameParser(int initialCapacity) {
+    grow(qMax(initialCapacity, HEADER_SIZE));
+}
+
+char* RadarFrameParser::writeRegion(int& available) {
+    if (m_size == m_ring.size()) {
+        grow(m_ring.size() * 2);
+    }
+    if (m_size == 0) {
+        m_head = 0;
+    }
+
+    const int tail = (m_head + m_size) & mask();
+    available = tail >= m_head ? m_ring.size() - tail : m_head - tail;
+    return m_ring.data() + tail;
+}
+
+void RadarFrameParser::commit(int bytes) {
+    m_size += qBound(0, bytes, m_ring.size() - m_size);
+}
+
+void RadarFrameParser::append(const char* data, int size) {
+    while (size > 0) {
+        int available = 0;
+        char* region = writeRegion(available);
+        const int chunk = qMin(available, size);
+        std::memcpy(region, data, chunk);
+        commit(chunk);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+bool RadarFrameParser::next(const char*& message, int& length) {
+    uchar raw[HEADER_SIZE];
+    for (;;) {
+        if (m_size < HEADER_SIZE) return false;
+
+        copyOut(0, reinterpret_cast<char*>(raw), HEADER_SIZE);
+        const quint32 messageSize = qFromBigEndian<quint32>(raw + 5);
+        if (qFromBigEndian<quint32>(raw) != HEADER_MAGIC || messageSize > MAX_MESSAGE_SIZE) {
+            consume(1);
+            ++m_discarded;
+            continue;
+        }
+
+        const int frameSize = HEADER_SIZE + static_cast<int>(messageSize);
+        if (m_size < frameSize) {
+            if (frameSize > m_ring.size()) {
+                grow(frameSize);
+            }
+            return false;
+        }
+
+        if (checksum(HEADER_SIZE, static_cast<int>(messageSize)) != qFromBigEndian<quint16>(raw + 9)) {
+            ++m_checksumFailures;
+            consume(1);
+            ++m_discarded;
+            continue;
+        }
+
+        length = static_cast<int>(messageSize);
+        message = linear(HEADER_SIZE, length);
+        consume(frameSize);
+        return true;
+    }
+}
+
+void RadarFrameParser::clear() {
+    m_head = 0;
+    m_size = 0;
+}
+
+void RadarFrameParser::decodeTrackReport(const char* record, RadarTrackReport& report) {
+    const uchar* bytes = reinterpret_cast<const uchar*>(record);
+    report.trackNumber = qFromBigEndian<quint32>(bytes);
+    report.rangeM = static_cast<float>(readDouble(bytes + 4));
+    report.azimuthDeg = static_cast<float>(readDouble(bytes + 12));
+    report.elevationDeg = static_cast<float>(readDouble(bytes + 20));
+    report.rangeRateMps = static_cast<float>(readDouble(bytes + 28));
+    report.azimuthRateDps = static_cast<float>(readDouble(bytes + 36));
+    report.elevationRateDps = static_cast<float>(readDouble(bytes + 44));
+    report.rcs = static_cast<float>(readDouble(bytes + 52));
+    report.quality = bytes[60];
+    report.timestamp = qFromBigEndian<quint64>(bytes + 61);
+}
+
+const char* RadarFrameParser::linear(int offset, int count) {
+    const int start = (m_head + offset) & mask();
+    if (start + count <= m_ring.size()) {
+        return m_ring.constData() + start;
+    }
+    if (m_scratch.size() < count) {
+        m_scratch.resize(count);
+    }
+    copyOut(offset, m_scratch.data(), count);
+    return m_scratch.constData();
+}
+
+quint16 RadarFrameParser::checksum(int offset, int count) const {
+    const int start = (m_head + offset) & mask();
+    const int first = qMin(count, m_ring.size() - start);
+    const uchar* ring = reinterpret_cast<const uchar*>(m_ring.constData());
+
+    quint32 sum = 0;
+    for (int i = 0; i < first; ++i) sum += ring[start + i];
+    for (int i = 0; i < count - first; ++i) sum += ring[i];
+    return static_cast<quint16>(sum);
+}
+
+void RadarFrameParser::copyOut(int offset, char* dest, int count) const {
+    const int start = (m_head + offset) & mask();
+    const int first = qMin(count, m_ring.size() - start);
+    std::memcpy(dest, m_ring.constData() + start, first);
+    std::memcpy(dest + first, m_ring.constData(), count - first);
+}
+
+void RadarFrameParser::consume(int count) {
+    m_head = (m_head + count) & mask();
+    m_size -= count;
+    if (m_size == 0) {
+        m_head = 0;
+    }
+}
+
+void RadarFrameParser::grow(int minCapacity) {
+    int capacity = qMax(m_ring.size(), 1);
+    while (capacity < minCapacity) capacity *= 2;
+    if (capacity == m_ring.size()) return;
+
+    QByteArray ring(capacity, Qt::Uninitialized);
+    if (m_size > 0) {
+        copyOut(0, ring.data(), m_size);
+    }
+    m_ring = ring;
+    m_head = 0;
+}
+
+// RadarGeoConverter
+
+void RadarGeoConverter::setSite(const GeoPosition& site) {
+    m_site = site;
+    const LocalTangentPlane frame(site);
+    m_latDegPerM = 1.0 / frame.metersPerDegreeLatitude();
+    m_lonDegPerM = 1.0 / frame.metersPerDegreeLongitude();
+    m_siteGroundM = m_terrain ? m_terrain->elevationM(site.latitude, site.longitude) : 0.0;
+}
+
+void RadarGeoConverter::setTerrain(const TerrainModelPtr& terrain) {
+    m_terrain = terrain;
+    setSite(m_site);
+}
+
+void RadarGeoConverter::toGroundLevel(const double* latitudes, const double* longitudes,
+                                      double* altitudes, int count) {
+    if (!m_terrain || count <= 0) return;
+    m_ground.resize(count);
+    m_terrain->elevationsM(latitudes, longitudes, m_ground.data(), count);
+    for (int i = 0; i < count; ++i) {
+        altitudes[i] += m_siteGroundM - m_ground[i];
+    }
+}
+
+void RadarGeoConverter::convert(const RadarTrackReport& report, GeoPosition& position,
+                                VelocityVector& velocity) const {
+    const double sinAz = sinDeg(report.azimuthDeg);
+    const double cosAz = cosDeg(report.azimuthDeg);
+    const double sinEl = sinDeg(report.elevationDeg);
+    const double cosEl = cosDeg(report.elevationDeg);
+
+    const double horizontalRange = report.rangeM * cosEl;
+    position.latitude = m_site.latitude + horizontalRange * cosAz * m_latDegPerM;
+    position.longitude = m_site.longitude + horizontalRange * sinAz * m_lonDegPerM;
+    position.altitude = m_site.altitude + report.rangeM * sinEl;
+
+    velocity.north = report.rangeRateMps * cosAz * cosEl;
+    velocity.east = report.rangeRateMps * sinAz * cosEl;
+    velocity.down = -report.rangeRateMps * sinEl;
+}
+
+double RadarGeoConverter::sinDeg(double degrees) {
+    if (!(std::abs(degrees) < 1.0e6)) {
+        return std::sin(qDegreesToRadians(degrees));  // Non-finite or far out of range
+    }
+
+    const double steps = degrees * (SINE_STEPS / 360.0);
+    const double whole = std::floor(steps);
+    const double fraction = steps - whole;
+    int index = static_cast<int>(whole) % SINE_STEPS;
+    if (index < 0) index += SINE_STEPS;
+
+    const auto& table = sineTable();
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+} // namespace CounterUAS
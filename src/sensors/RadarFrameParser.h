@@ -0,0 +1,116 @@
+#ifndef RADARFRAMEPARSER_H
+#define RADARFRAMEPARSER_H
+
+#include <QByteArray>
+#include <QVector>
+#include "core/Track.h"
+#include "utils/TerrainModel.h"
+
+namespace CounterUAS {
+
+struct RadarTrackReport;
+
+/**
+ * @brief Ring-buffered splitter for the radar's framed TCP stream
+ *
+ * A frame is magic(4) type(1) length(4) checksum(2) reserved(1), big-endian,
+ * followed by length message bytes whose 16-bit sum is the checksum. The
+ * socket reads straight into the ring and next() validates header and
+ * checksum in place, handing back a pointer into the ring; only a message
+ * that wraps past the end of the ring is copied, into a reused scratch
+ * buffer. Bad magic, an implausible length or a checksum mismatch skip one
+ * byte, so the stream resynchronizes on the next magic.
+ */
+class RadarFrameParser {
+public:
+    static constexpr quint32 HEADER_MAGIC = 0x52414452;  // "RADR"
+    static constexpr int HEADER_SIZE = 12;
+    static constexpr int MAX_MESSAGE_SIZE = 1 << 20;
+
+    // One track report record: trackNumber(u32), seven float fields carried
+    // as doubles (QDataStream's default precision), quality(u8), timestamp(u64).
+    // A TrackReport message may pack several records back to back.
+    static constexpr int TRACK_REPORT_SIZE = 4 + 7 * 8 + 1 + 8;
+
+    explicit RadarFrameParser(int initialCapacity = 64 * 1024);
+
+    int size() const { return m_size; }
+    qint64 discardedBytes() const { return m_discarded; }
+    qint64 checksumFailures() const { return m_checksumFailures; }
+
+    // Contiguous free space for a direct socket read; follow with commit()
+    char* writeRegion(int& available);
+    void commit(int bytes);
+    void append(const char* data, int size);
+
+    // Next validated message. It stays valid until the next write or next()
+    // call. Returns false when more data is needed.
+    bool next(const char*& message, int& length);
+
+    void clear();
+
+    static void decodeTrackReport(const char* record, RadarTrackReport& report);
+
+private:
+    int mask() const { return m_ring.size() - 1; }
+    const char* linear(int offset, int count);
+    quint16 checksum(int offset, int count) const;
+    void copyOut(int offset, char* dest, int count) const;
+    void consume(int count);
+    void grow(int minCapacity);
+
+    QByteArray m_ring;     // Power-of-two capacity
+    int m_head = 0;
+    int m_size = 0;
+    QByteArray m_scratch;
+    qint64 m_discarded = 0;
+    qint64 m_checksumFailures = 0;
+};
+
+/**
+ * @brief Radar polar to geographic conversion with constants per site
+ *
+ * The site's metres-to-degrees factors, including the cos(latitude) term,
+ * are computed once in setSite() instead of per report. Azimuth and
+ * elevation trig come from a shared 0.1 degree sine table with linear
+ * interpolation, good to under 4e-7 relative error: millimetres at the
+ * radar's maximum range.
+ *
+ * convert() gives altitudes above the ground under the radar. With a
+ * terrain model set, toGroundLevel() moves a batch of them onto the ground
+ * under each target, which is what GeoPosition altitudes are.
+ */
+class RadarGeoConverter {
+public:
+    RadarGeoConverter() { setSite(GeoPosition()); }
+
+    void setSite(const GeoPosition& site);
+    const GeoPosition& site() const { return m_site; }
+    bool hasSite(const GeoPosition& site) const {
+        return site.latitude == m_site.latitude && site.longitude == m_site.longitude &&
+               site.altitude == m_site.altitude;
+    }
+
+    void convert(const RadarTrackReport& report, GeoPosition& position,
+                 VelocityVector& velocity) const;
+
+    void setTerrain(const TerrainModelPtr& terrain);
+    const TerrainModelPtr& terrain() const { return m_terrain; }
+    // Altitudes from convert(), read and written in place
+    void toGroundLevel(const double* latitudes, const double* longitudes, double* altitudes, int count);
+
+    static double sinDeg(double degrees);
+    static double cosDeg(double degrees) { return sinDeg(degrees + 90.0); }
+
+private:
+    GeoPosition m_site;
+    double m_latDegPerM = 0.0;
+    double m_lonDegPerM = 0.0;
+    TerrainModelPtr m_terrain;
+    double m_siteGroundM = 0.0;     // Terrain elevation under the site
+    QVector<double> m_ground;           // toGroundLevel() scratch
+};
+
+} // namespace CounterUAS
+
+#endif // RADARFRAMEPARSER_H
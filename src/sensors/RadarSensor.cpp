@@ -1,31 +1,33 @@
 #include "sensors/RadarSensor.h"
 #include "utils/Logger.h"
 #include "utils/CoordinateUtils.h"
+#include "utils/LocalTangentPlane.h"
+#include "utils/RawCapture.h"
+#include "utils/TimeUtils.h"
+#include <QtEndian>
 #include <QtMath>
 
 namespace CounterUAS {
 
 // RadarTrackReport implementation
-GeoPosition RadarTrackReport::toGeoPosition(const GeoPosition& radarPos) const {
+GeoPosition RadarTrackReport::toGeoPosition(const GeoPosition& radarPos, const TerrainModel* terrain) const {
     // Convert radar spherical coordinates to geographic
     double azRad = qDegreesToRadians(azimuthDeg);
     double elRad = qDegreesToRadians(elevationDeg);
     
-    // Calculate horizontal range and altitude
+    // Offset in the radar's tangent plane
     double horizontalRange = rangeM * std::cos(elRad);
-    double altitude = rangeM * std::sin(elRad);
-    
-    // Calculate offset in meters
-    double northOffset = horizontalRange * std::cos(azRad);
-    double eastOffset = horizontalRange * std::sin(azRad);
-    
-    // Convert to lat/lon
-    GeoPosition result;
-    result.latitude = radarPos.latitude + (northOffset / 111000.0);
-    result.longitude = radarPos.longitude + (eastOffset / (111000.0 * std::cos(qDegreesToRadians(radarPos.latitude))));
-    result.altitude = radarPos.altitude + altitude;
-    
-    return result;
+    EnuVector offset;
+    offset.east = horizontalRange * std::sin(azRad);
+    offset.north = horizontalRange * std::cos(azRad);
+    offset.up = rangeM * std::sin(elRad);
+    
+    GeoPosition position = LocalTangentPlane(radarPos).toGeoLinear(offset);
+    if (terrain) {
+        position.altitude += terrain->elevationM(radarPos.latitude, radarPos.longitude) -
+                             terrain->elevationM(position.latitude, position.longitude);
+    }
+    return position;
 }
 
 VelocityVector RadarTrackReport::toVelocityVector(const GeoPosition& radarPos) const {
@@ -46,15 +48,20 @@ VelocityVector RadarTrackReport::toVelocityVector(const GeoPosition& radarPos) c
 RadarSensor::RadarSensor(const QString& sensorId, QObject* parent)
     : SensorInterface(sensorId, parent)
     , m_socket(new QTcpSocket(this))
-    , m_reconnectTimer(new QTimer(this))
+    , m_connection(new ManagedConnection(m_socket))
 {
     QObject::connect(m_socket, &QTcpSocket::connected, this, &RadarSensor::onConnected);
     QObject::connect(m_socket, &QTcpSocket::disconnected, this, &RadarSensor::onDisconnected);
     QObject::connect(m_socket, &QTcpSocket::readyRead, this, &RadarSensor::onReadyRead);
     QObject::connect(m_socket, &QAbstractSocket::errorOccurred, this, &RadarSensor::onError);
     
-    m_reconnectTimer->setSingleShot(true);
-    QObject::connect(m_reconnectTimer, &QTimer::timeout, this, &RadarSensor::attemptReconnect);
+    QObject::connect(m_connection, &ManagedConnection::retryScheduled, this,
+                     [this](int attempt, int delayMs) {
+        m_health.connectionRetries = attempt;
+        Logger::instance().info("RadarSensor",
+                               QString("%1 reconnecting in %2 ms").arg(m_sensorId).arg(delayMs));
+    });
+    setConfig(m_config);
 }
 
 RadarSensor::~RadarSensor() {
@@ -62,33 +69,30 @@ RadarSensor::~RadarSensor() {
 }
 
 void RadarSensor::setConfig(const RadarConfig& config) {
+    // Another unit has another clock
+    if (config.host != m_config.host || config.port != m_config.port) {
+        m_clock->reset();
+    }
     m_config = config;
+    
+    BackoffPolicy policy;
+    policy.maxDelayMs = qMax(policy.initialDelayMs, m_config.reconnectIntervalMs);
+    policy.connectTimeoutMs = m_config.timeoutMs;
+    m_connection->setPolicy(policy);
+    m_connection->setTarget(m_config.host, m_config.port);
+    m_clutterMap.configure(m_config.clutterMap, m_config.maxRangeM);
 }
 
 bool RadarSensor::connect() {
     if (isConnected()) return true;
     
     setStatus(SensorStatus::Initializing);
-    
-    m_socket->connectToHost(m_config.host, m_config.port);
-    
-    if (!m_socket->waitForConnected(m_config.timeoutMs)) {
-        reportError("Connection timeout: " + m_socket->errorString());
-        m_reconnectTimer->start(m_config.reconnectIntervalMs);
-        return false;
-    }
-    
+    m_connection->open();
     return true;
 }
 
 void RadarSensor::disconnect() {
-    m_reconnectTimer->stop();
-    if (m_socket->state() != QAbstractSocket::UnconnectedState) {
-        m_socket->disconnectFromHost();
-        if (m_socket->state() != QAbstractSocket::UnconnectedState) {
-            m_socket->waitForDisconnected(1000);
-        }
-    }
+    m_connection->close();
     setStatus(SensorStatus::Offline);
 }
 
@@ -103,7 +107,7 @@ void RadarSensor::sendCommand(RadarMessageType type, const QByteArray& data) {
     QDataStream stream(&message, QIODevice::WriteOnly);
     stream.setByteOrder(QDataStream::BigEndian);
     
-    stream << HEADER_MAGIC;
+    stream << RadarFrameParser::HEADER_MAGIC;
     stream << static_cast<quint8>(type);
     stream << static_cast<quint32>(data.size());
     
@@ -131,11 +135,27 @@ void RadarSensor::setOperationalMode(int mode) {
     sendCommand(RadarMessageType::Command, data);
 }
 
+void RadarSensor::requestDwell(const RadarDwellRequest& request) {
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::BigEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream << request.trackNumber << request.azimuthDeg << request.elevationDeg << request.rangeM
+           << request.dwellMs << request.revisitMs << request.priority;
+    sendCommand(RadarMessageType::DwellRequest, data);
+}
+
 void RadarSensor::processData() {
     // Request heartbeat to keep connection alive
-    if (isConnected()) {
-        sendCommand(RadarMessageType::Heartbeat);
+    if (!isConnected()) return;
+    
+    QByteArray data;
+    if (m_config.clockExchange) {
+        data.resize(sizeof(quint64));
+        qToBigEndian<quint64>(static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()),
+                              reinterpret_cast<uchar*>(data.data()));
     }
+    sendCommand(RadarMessageType::Heartbeat, data);
 }
 
 void RadarSensor::onConnected() {
@@ -160,93 +180,95 @@ void RadarSensor::onDisconnected() {
     Logger::instance().warning("RadarSensor", m_sensorId + " disconnected");
     
     emit connectedChanged(false);
-    
-    // Attempt reconnection if we were running
-    if (m_running) {
-        m_reconnectTimer->start(m_config.reconnectIntervalMs);
-    }
 }
 
 void RadarSensor::onReadyRead() {
-    m_buffer.append(m_socket->readAll());
+    m_readStampNs = TimeUtils::monotonicNs();
+    
+    // Read straight into the parser's ring, no intermediate buffer
+    while (m_socket->bytesAvailable() > 0) {
+        int available = 0;
+        char* region = m_parser.writeRegion(available);
+        const qint64 bytesRead = m_socket->read(region, available);
+        if (bytesRead <= 0) break;
+        captureRaw(region, static_cast<int>(bytesRead), m_readStampNs);
+        m_parser.commit(static_cast<int>(bytesRead));
+        m_telemetry->recordRead(bytesRead);
+    }
     
-    // Process complete messages
-    while (m_buffer.size() >= HEADER_SIZE) {
-        QDataStream stream(m_buffer);
-        stream.setByteOrder(QDataStream::BigEndian);
-        
-        quint32 magic;
-        stream >> magic;
-        
-        if (magic != HEADER_MAGIC) {
-            // Sync error - search for magic
-            int idx = m_buffer.indexOf(QByteArray::fromRawData(
-                reinterpret_cast<const char*>(&HEADER_MAGIC), 4));
-            if (idx > 0) {
-                m_buffer.remove(0, idx);
-                m_health.droppedPackets++;
-            } else {
-                m_buffer.clear();
-            }
-            continue;
-        }
-        
-        quint8 type;
-        quint32 length;
-        stream >> type >> length;
-        
-        if (m_buffer.size() < HEADER_SIZE + static_cast<int>(length)) {
-            break;  // Wait for more data
-        }
-        
-        // Extract message
-        QByteArray message = m_buffer.mid(HEADER_SIZE, length);
-        m_buffer.remove(0, HEADER_SIZE + length);
-        
-        parseMessage(message);
+    drainParser();
+}
+
+bool RadarSensor::replayRaw(const QByteArray& data) {
+    if (isConnected()) return false;
+    
+    m_readStampNs = TimeUtils::monotonicNs();
+    m_parser.append(data.constData(), data.size());
+    m_telemetry->recordRead(data.size());
+    m_replaying = true;
+    drainParser();
+    m_replaying = false;
+    return true;
+}
+
+RawCaptureKind RadarSensor::rawCaptureKind() const {
+    return RawCaptureKind::Stream;
+}
+
+void RadarSensor::drainParser() {
+    if (!m_geo.hasSite(m_position)) {
+        m_geo.setSite(m_position);
+    }
+    
+    const qint64 discardedBefore = m_parser.discardedBytes();
+    const char* message = nullptr;
+    int length = 0;
+    while (m_parser.next(message, length)) {
+        const qint64 parseStartNs = TimeUtils::monotonicNs();
+        parseMessage(message, length);
+        m_telemetry->recordParseNs(TimeUtils::monotonicNs() - parseStartNs);
+        m_telemetry->recordMessages();
+    }
+    if (m_parser.discardedBytes() != discardedBefore) {
+        m_telemetry->recordDropped();
+    }
+    m_telemetry->setQueueDepth(m_parser.size());
+    
+    // One batch per read, so fusion takes the whole scan in one submission
+    if (!m_batch.isEmpty()) {
+        correctTimestamps(m_batch.data(), m_batch.size());
+        emit detectionBatch(m_batch);
+        m_batch = QVector<SensorDetection>();
     }
 }
 
 void RadarSensor::onError(QAbstractSocket::SocketError error) {
     Q_UNUSED(error)
     reportError("Socket error: " + m_socket->errorString());
-    
-    m_health.connectionRetries++;
-    if (m_running) {
-        m_reconnectTimer->start(m_config.reconnectIntervalMs);
-    }
 }
 
-void RadarSensor::attemptReconnect() {
-    if (m_running && !isConnected()) {
-        Logger::instance().info("RadarSensor", 
-                               m_sensorId + " attempting reconnection...");
-        connect();
-    }
+RadarSensor::ParserStats RadarSensor::parserStats() const {
+    ParserStats stats;
+    stats.discardedBytes = m_parser.discardedBytes();
+    stats.checksumFailures = m_parser.checksumFailures();
+    return stats;
 }
 
-void RadarSensor::parseMessage(const QByteArray& data) {
-    if (data.isEmpty()) return;
-    
-    QDataStream stream(data);
-    stream.setByteOrder(QDataStream::BigEndian);
-    
-    quint8 type = data[0];
+void RadarSensor::parseMessage(const char* data, int length) {
+    if (length <= 0) return;
     
-    QByteArray payload = data.mid(1);
-    QDataStream payloadStream(payload);
-    payloadStream.setByteOrder(QDataStream::BigEndian);
+    const quint8 type = static_cast<quint8>(data[0]);
     
     switch (static_cast<RadarMessageType>(type)) {
         case RadarMessageType::TrackReport:
-            parseTrackReport(payloadStream);
+            parseTrackReports(data + 1, length - 1);
             break;
         case RadarMessageType::StatusReport:
-            parseStatusReport(payloadStream);
+            parseStatusReport(data + 1, length - 1);
             break;
         case RadarMessageType::Heartbeat:
         case RadarMessageType::Ack:
-            // Just acknowledge receipt
+            parseClockExchange(data + 1, length - 1);
             break;
         default:
             Logger::instance().warning("RadarSensor", 
@@ -256,51 +278,86 @@ void RadarSensor::parseMessage(const QByteArray& data) {
     }
 }
 
-void RadarSensor::parseTrackReport(QDataStream& stream) {
-    RadarTrackReport report;
-    
-    stream >> report.trackNumber;
-    stream >> report.rangeM;
-    stream >> report.azimuthDeg;
-    stream >> report.elevationDeg;
-    stream >> report.rangeRateMps;
-    stream >> report.azimuthRateDps;
-    stream >> report.elevationRateDps;
-    stream >> report.rcs;
-    stream >> report.quality;
-    stream >> report.timestamp;
-    
-    // Apply range filter
-    if (report.rangeM < m_config.minRangeM || report.rangeM > m_config.maxRangeM) {
-        return;
+void RadarSensor::parseTrackReports(const char* data, int length) {
+    const int count = length / RadarFrameParser::TRACK_REPORT_SIZE;
+    const qint64 nowMs = m_readStampNs / 1000000;
+    const int first = m_batch.size();
+    m_batch.reserve(m_batch.size() + count);
+    
+    for (int i = 0; i < count; ++i) {
+        RadarTrackReport report;
+        RadarFrameParser::decodeTrackReport(data + i * RadarFrameParser::TRACK_REPORT_SIZE, report);
+        
+        // Apply range filter
+        if (report.rangeM < m_config.minRangeM || report.rangeM > m_config.maxRangeM) {
+            continue;
+        }
+        
+        // Apply clutter filter
+        if (m_config.filterClutter && report.rcs < m_config.clutterThreshold) {
+            continue;
+        }
+        
+        // Drop plots in persistent clutter cells before they reach association
+        if (m_clutterMap.observe(report.rangeM, report.azimuthDeg, report.elevationDeg, nowMs)) {
+            continue;
+        }
+        
+        // Convert to detection
+        SensorDetection sensorDet;
+        sensorDet.sensorId = m_sensorId;
+        m_geo.convert(report, sensorDet.position, sensorDet.velocity);
+        sensorDet.signalStrength = report.rcs;
+        sensorDet.confidence = report.quality / 100.0;
+        sensorDet.timestamp = report.timestamp;
+        sensorDet.sourceType = DetectionSource::Radar;
+        sensorDet.ingestMonoNs = m_readStampNs;
+        sensorDet.info.radar.trackNumber = report.trackNumber;
+        sensorDet.info.radar.rangeM = report.rangeM;
+        sensorDet.info.radar.azimuthDeg = report.azimuthDeg;
+        sensorDet.info.radar.elevationDeg = report.elevationDeg;
+        
+        recordDetection();
+        
+        emit trackReportReceived(report);
+        m_batch.append(sensorDet);
     }
     
-    // Apply clutter filter
-    if (m_config.filterClutter && report.rcs < m_config.clutterThreshold) {
-        return;
+    // Onto the ground under each plot, with the message's terrain in one batch
+    const int added = m_batch.size() - first;
+    if (m_geo.terrain() && added > 0) {
+        m_latitudes.resize(added);
+        m_longitudes.resize(added);
+        m_altitudes.resize(added);
+        for (int i = 0; i < added; ++i) {
+            const GeoPosition& position = m_batch[first + i].position;
+            m_latitudes[i] = position.latitude;
+            m_longitudes[i] = position.longitude;
+            m_altitudes[i] = position.altitude;
+        }
+        m_geo.toGroundLevel(m_latitudes.constData(), m_longitudes.constData(), m_altitudes.data(), added);
+        for (int i = 0; i < added; ++i) {
+            m_batch[first + i].position.altitude = m_altitudes[i];
+        }
     }
-    
-    // Convert to detection
-    SensorDetection sensorDet;
-    sensorDet.sensorId = m_sensorId;
-    sensorDet.position = report.toGeoPosition(m_position);
-    sensorDet.velocity = report.toVelocityVector(m_position);
-    sensorDet.signalStrength = report.rcs;
-    sensorDet.confidence = report.quality / 100.0;
-    sensorDet.timestamp = report.timestamp;
-    sensorDet.sourceType = DetectionSource::Radar;
-    sensorDet.metadata["trackNumber"] = report.trackNumber;
-    sensorDet.metadata["rangeM"] = report.rangeM;
-    sensorDet.metadata["azimuthDeg"] = report.azimuthDeg;
-    sensorDet.metadata["elevationDeg"] = report.elevationDeg;
-    
-    recordDetection();
-    
-    emit trackReportReceived(report);
-    emit detection(sensorDet);
 }
 
-void RadarSensor::parseStatusReport(QDataStream& stream) {
+void RadarSensor::parseClockExchange(const char* data, int length) {
+    // A bare acknowledgement carries no times; a replayed one answers a send long past
+    if (length < 3 * static_cast<int>(sizeof(quint64)) || m_replaying) return;
+    
+    const uchar* bytes = reinterpret_cast<const uchar*>(data);
+    const qint64 sentMs = static_cast<qint64>(qFromBigEndian<quint64>(bytes));
+    const qint64 radarReceivedMs = static_cast<qint64>(qFromBigEndian<quint64>(bytes + 8));
+    const qint64 radarRepliedMs = static_cast<qint64>(qFromBigEndian<quint64>(bytes + 16));
+    const qint64 receivedMs = QDateTime::currentMSecsSinceEpoch()
+                            - (TimeUtils::monotonicNs() - m_readStampNs) / 1000000;
+    m_clock->observeExchange(sentMs, radarReceivedMs, radarRepliedMs, receivedMs);
+}
+
+void RadarSensor::parseStatusReport(const char* data, int length) {
+    QDataStream stream(QByteArray::fromRawData(data, length));
+    stream.setByteOrder(QDataStream::BigEndian);
     QByteArray status;
     stream >> status;
     emit statusReceived(status);
@@ -2,6 +2,9 @@
 #define RADARSENSOR_H
 
 #include "sensors/SensorInterface.h"
+#include "sensors/ClutterMap.h"
+#include "sensors/RadarFrameParser.h"
+#include "utils/ConnectionPool.h"
 #include <QTcpSocket>
 #include <QHostAddress>
 #include <QDataStream>
@@ -17,7 +20,8 @@ enum class RadarMessageType : quint8 {
     StatusReport = 0x03,
     Configuration = 0x04,
     Command = 0x05,
-    Ack = 0x06
+    Ack = 0x06,
+    DwellRequest = 0x07
 };
 
 /**
@@ -35,18 +39,32 @@ struct RadarTrackReport {
     quint8 quality;
     quint64 timestamp;
     
-    GeoPosition toGeoPosition(const GeoPosition& radarPos) const;
+    // Altitude above the ground under the target with terrain, else under the radar
+    GeoPosition toGeoPosition(const GeoPosition& radarPos, const TerrainModel* terrain = nullptr) const;
     VelocityVector toVelocityVector(const GeoPosition& radarPos) const;
 };
 
+/**
+ * @brief A track-while-scan dwell the radar is asked to schedule
+ */
+struct RadarDwellRequest {
+    quint32 trackNumber = 0;        // Ours, echoed in reports; 0 for none
+    float azimuthDeg = 0.0f;
+    float elevationDeg = 0.0f;
+    float rangeM = 0.0f;
+    quint16 dwellMs = 50;           // Beam time on the target
+    quint16 revisitMs = 500;        // Held this long; lapses unless requested again
+    quint8 priority = 1;            // 1-5, the radar's arbitration against its scan
+};
+
 /**
  * @brief Radar configuration
  */
 struct RadarConfig {
     QString host = "127.0.0.1";
     quint16 port = 5001;
-    int reconnectIntervalMs = 5000;
-    int timeoutMs = 3000;
+    int reconnectIntervalMs = 5000;   // Ceiling of the reconnect backoff
+    int timeoutMs = 3000;             // Per-attempt connect timeout
     double minRangeM = 50.0;
     double maxRangeM = 5000.0;
     double minAzimuthDeg = 0.0;
@@ -54,7 +72,11 @@ struct RadarConfig {
     double minElevationDeg = -10.0;
     double maxElevationDeg = 90.0;
     bool filterClutter = true;
-    double clutterThreshold = 0.1;
+    double clutterThreshold = 0.1;    // Minimum RCS when filterClutter is set
+    ClutterMapConfig clutterMap;      // Learned per-cell suppression
+    // Heartbeats carry their send time; a radar that echoes it with its own
+    // receive and reply times, three u64 ms, gives a two-way clock exchange
+    bool clockExchange = false;
 };
 
 /**
@@ -71,6 +93,7 @@ public:
     QString sensorType() const override { return "RADAR"; }
     DetectionSource detectionSource() const override { return DetectionSource::Radar; }
     
+    // Starts connecting and returns at once; connectedChanged() reports the outcome
     bool connect() override;
     void disconnect() override;
     bool isConnected() const override;
@@ -80,14 +103,30 @@ public:
         return m_config.maxAzimuthDeg - m_config.minAzimuthDeg; 
     }
     
-    // Configuration
+    // Configuration; a new config restarts clutter learning
     void setConfig(const RadarConfig& config);
     RadarConfig config() const { return m_config; }
+    const ClutterMap& clutterMap() const { return m_clutterMap; }
+    
+    // Ground under the radar and its targets, for AGL plot altitudes
+    void setTerrain(const TerrainModelPtr& terrain) { m_geo.setTerrain(terrain); }
+    TerrainModelPtr terrain() const { return m_geo.terrain(); }
     
     // Commands
     void sendCommand(RadarMessageType type, const QByteArray& data = QByteArray());
     void requestStatus();
     void setOperationalMode(int mode);
+    // Sent as DwellRequest; a radar without the capability ignores it
+    void requestDwell(const RadarDwellRequest& request);
+    
+    struct ParserStats {
+        qint64 discardedBytes = 0;
+        qint64 checksumFailures = 0;
+    };
+    ParserStats parserStats() const;
+    
+    // Captured stream bytes, only while disconnected: one framer cannot take two streams
+    bool replayRaw(const QByteArray& data) override;
     
 signals:
     void trackReportReceived(const RadarTrackReport& report);
@@ -96,25 +135,34 @@ signals:
 protected slots:
     void processData() override;
     
+protected:
+    RawCaptureKind rawCaptureKind() const override;
+    
 private slots:
     void onConnected();
     void onDisconnected();
     void onReadyRead();
     void onError(QAbstractSocket::SocketError error);
-    void attemptReconnect();
     
 private:
-    void parseMessage(const QByteArray& data);
-    void parseTrackReport(QDataStream& stream);
-    void parseStatusReport(QDataStream& stream);
+    void drainParser();
+    void parseMessage(const char* data, int length);
+    void parseTrackReports(const char* data, int length);
+    void parseClockExchange(const char* data, int length);
+    void parseStatusReport(const char* data, int length);
     
     QTcpSocket* m_socket;
     RadarConfig m_config;
-    QTimer* m_reconnectTimer;
-    QByteArray m_buffer;
-    
-    static constexpr quint32 HEADER_MAGIC = 0x52414452;  // "RADR"
-    static constexpr int HEADER_SIZE = 12;  // magic(4) + type(1) + length(4) + checksum(2) + reserved(1)
+    ManagedConnection* m_connection;
+    RadarFrameParser m_parser;
+    RadarGeoConverter m_geo;
+    ClutterMap m_clutterMap;
+    QVector<SensorDetection> m_batch;  // Detections decoded by the current read
+    QVector<double> m_latitudes;       // Of a read's plots, for the terrain
+    QVector<double> m_longitudes;
+    QVector<double> m_altitudes;
+    qint64 m_readStampNs = 0;  // Monotonic time of the read that completed the message
+    bool m_replaying = false;  // Draining replayRaw() bytes
 };
 
 } // namespace CounterUAS
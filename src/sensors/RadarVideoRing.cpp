@@ -0,0 +1,188 @@
+#include "sensors/RadarVideoRing.h"
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+float readFloat(const uchar* bytes) {
+    const quint32 bits = qFromBigEndian<quint32>(bytes);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void writeFloat(float value, uchar* bytes) {
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    qToBigEndian<quint32>(bits, bytes);
+}
+
+} // namespace
+
+// RadarSpokeCodec
+
+int RadarSpokeCodec::decode(const char* data, int size, RadarSpoke& spoke) {
+    if (size < HEADER_SIZE) return 0;
+    const uchar* bytes = reinterpret_cast<const uchar*>(data);
+    if (qFromBigEndian<quint32>(bytes) != MAGIC) return 0;
+
+    const int count = qFromBigEndian<quint16>(bytes + 10);
+    if (HEADER_SIZE + count > size) return 0;
+
+    spoke.sequence = qFromBigEndian<quint32>(bytes + 4);
+    spoke.azimuthDeg = qFromBigEndian<quint16>(bytes + 8) * (360.0 / 65536.0);
+    spoke.sampleCount = count;
+    spoke.rangeStartM = readFloat(bytes + 12);
+    spoke.rangeCellM = readFloat(bytes + 16);
+    spoke.timestampMs = static_cast<qint64>(qFromBigEndian<quint64>(bytes + 20));
+    spoke.samples = bytes + HEADER_SIZE;
+    if (!(spoke.rangeCellM > 0.0) || !std::isfinite(spoke.rangeStartM)) return 0;
+    return HEADER_SIZE + count;
+}
+
+void RadarSpokeCodec::encode(const RadarSpoke& spoke, QByteArray& out) {
+    const int count = qBound(0, spoke.sampleCount, 0xFFFF);
+    const int offset = out.size();
+    out.resize(offset + HEADER_SIZE + count);
+    uchar* bytes = reinterpret_cast<uchar*>(out.data() + offset);
+
+    double turns = std::fmod(spoke.azimuthDeg / 360.0, 1.0);
+    if (turns < 0.0) turns += 1.0;
+    qToBigEndian<quint32>(MAGIC, bytes);
+    qToBigEndian<quint32>(spoke.sequence, bytes + 4);
+    qToBigEndian<quint16>(static_cast<quint16>(std::lround(turns * 65536.0) & 0xFFFF), bytes + 8);
+    qToBigEndian<quint16>(static_cast<quint16>(count), bytes + 10);
+    writeFloat(static_cast<float>(spoke.rangeStartM), bytes + 12);
+    writeFloat(static_cast<float>(spoke.rangeCellM), bytes + 16);
+    qToBigEndian<quint64>(static_cast<quint64>(spoke.timestampMs), bytes + 20);
+    if (count > 0) {
+        std::memcpy(bytes + HEADER_SIZE, spoke.samples, count);
+    }
+}
+
+// RadarVideoRing
+
+RadarVideoRing::RadarVideoRing(int azimuthCount, int rangeBins, double maxRangeM)
+    : m_azimuthCount(qMax(16, azimuthCount))
+    , m_rangeBins(qMax(16, rangeBins))
+    , m_maxRangeM(qMax(1.0, maxRangeM))
+{
+    m_samples.fill('\0', m_azimuthCount * m_rangeBins);
+    m_rowTimeMs.fill(0, m_azimuthCount);
+    // Generation 1 is the blank picture, so a reader starting from 0 gets every row
+    m_rowGeneration.fill(1, m_azimuthCount);
+}
+
+void RadarVideoRing::resample(const RadarSpoke& spoke, quint8* row) const {
+    const double binM = m_maxRangeM / m_rangeBins;
+    const double perBin = binM / spoke.rangeCellM;   // Samples per bin
+    const double first = -spoke.rangeStartM / spoke.rangeCellM;
+
+    for (int bin = 0; bin < m_rangeBins; ++bin) {
+        // Samples whose cells overlap the bin's range
+        const double from = first + bin * perBin;
+        int lo = static_cast<int>(std::floor(from));
+        int hi = qMax(static_cast<int>(std::ceil(from + perBin)), lo + 1);
+        lo = qMax(lo, 0);
+        hi = qMin(hi, spoke.sampleCount);
+
+        quint8 peak = 0;
+        for (int i = lo; i < hi; ++i) {
+            peak = qMax(peak, spoke.samples[i]);
+        }
+        row[bin] = peak;
+    }
+}
+
+void RadarVideoRing::write(const RadarSpoke& spoke, qint64 receivedMs) {
+    if (!spoke.samples || spoke.sampleCount <= 0 || !(spoke.rangeCellM > 0.0)) return;
+
+    double turns = std::fmod(spoke.azimuthDeg / 360.0, 1.0);
+    if (turns < 0.0) turns += 1.0;
+    const int row = static_cast<int>(turns * m_azimuthCount) % m_azimuthCount;
+
+    // Resampled before taking the lock; one row per receiving thread
+    thread_local QByteArray resampled;
+    resampled.resize(m_rangeBins);
+    const quint8* scratch = reinterpret_cast<const quint8*>(resampled.constData());
+    resample(spoke, reinterpret_cast<quint8*>(resampled.data()));
+
+    QMutexLocker locker(&m_mutex);
+
+    // Rows the antenna passed since the previous spoke, when the gap is
+    // one spoke wide rather than spokes lost
+    int first = row;
+    if (m_lastRow >= 0) {
+        const int gap = (row - m_lastRow + m_azimuthCount) % m_azimuthCount;
+        if (gap > 1 && gap <= MAX_FILL_ROWS) {
+            first = (m_lastRow + 1) % m_azimuthCount;
+        }
+    }
+
+    ++m_generation;
+    for (int r = first;; r = (r + 1) % m_azimuthCount) {
+        std::memcpy(m_samples.data() + r * m_rangeBins, scratch, m_rangeBins);
+        m_rowTimeMs[r] = receivedMs;
+        m_rowGeneration[r] = m_generation;
+        if (r == row) break;
+    }
+
+    m_lastRow = row;
+    m_lastAzimuthDeg = turns * 360.0;
+    m_lastWriteMs = receivedMs;
+    ++m_spokes;
+}
+
+void RadarVideoRing::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_samples.fill('\0');
+    m_rowTimeMs.fill(0);
+    // Every row changes, back to blank
+    ++m_generation;
+    m_rowGeneration.fill(m_generation);
+    m_lastRow = -1;
+}
+
+bool RadarVideoRing::changesSince(quint64 since, Update& out) const {
+    out.rows.clear();
+    out.rowTimeMs.clear();
+    out.samples.clear();
+
+    QMutexLocker locker(&m_mutex);
+    out.generation = m_generation;
+    for (int r = 0; r < m_azimuthCount; ++r) {
+        if (m_rowGeneration[r] > since) {
+            out.rows.append(r);
+            out.rowTimeMs.append(m_rowTimeMs[r]);
+        }
+    }
+
+    out.samples.resize(out.rows.size() * m_rangeBins);
+    char* dest = out.samples.data();
+    for (int r : out.rows) {
+        std::memcpy(dest, m_samples.constData() + r * m_rangeBins, m_rangeBins);
+        dest += m_rangeBins;
+    }
+    return !out.rows.isEmpty();
+}
+
+double RadarVideoRing::lastAzimuthDeg() const {
+    QMutexLocker locker(&m_mutex);
+    return m_lastAzimuthDeg;
+}
+
+qint64 RadarVideoRing::lastWriteMs() const {
+    QMutexLocker locker(&m_mutex);
+    return m_lastWriteMs;
+}
+
+quint64 RadarVideoRing::spokesWritten() const {
+    QMutexLocker locker(&m_mutex);
+    return m_spokes;
+}
+
+} // namespace CounterUAS
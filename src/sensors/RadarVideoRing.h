@@ -0,0 +1,105 @@
+#ifndef RADARVIDEORING_H
+#define RADARVIDEORING_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QVector>
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief One radial of raw radar video: echo amplitude against range
+ */
+struct RadarSpoke {
+    quint32 sequence = 0;          // Gaps are spokes lost on the link
+    double azimuthDeg = 0.0;       // True bearing of the antenna
+    double rangeStartM = 0.0;      // Range of the first sample
+    double rangeCellM = 0.0;       // Range step between samples
+    qint64 timestampMs = 0;        // Radar time of the spoke
+    const quint8* samples = nullptr;   // Borrowed, e.g. from the datagram
+    int sampleCount = 0;
+};
+
+/**
+ * @brief Wire format of the radar's raw video export
+ *
+ * Each UDP datagram packs one or more spokes back to back, each a header
+ * magic(4) sequence(4) azimuth(2, 1/65536 of a turn) samples(2)
+ * rangeStart(4, float metres) rangeCell(4, float metres) timestamp(8, ms),
+ * big-endian, then one byte of amplitude per sample.
+ */
+class RadarSpokeCodec {
+public:
+    static constexpr quint32 MAGIC = 0x53504B31;  // "SPK1"
+    static constexpr int HEADER_SIZE = 28;
+
+    // Bytes of the spoke at data, 0 if there is no valid one; spoke.samples
+    // then points into data
+    static int decode(const char* data, int size, RadarSpoke& spoke);
+    static void encode(const RadarSpoke& spoke, QByteArray& out);  // Appends
+};
+
+/**
+ * @brief Latest spoke per azimuth, in the layout the display uploads
+ *
+ * A polar image of azimuthCount rows by rangeBins columns covering
+ * 0..maxRangeM, each row stamped with the time it was last written. The
+ * receiver resamples each spoke onto its row (the peak of the samples a
+ * bin covers, so small targets survive decimation) and fills the rows a
+ * fast-turning antenna skipped since the previous spoke. Readers ask for
+ * the rows written since the generation they last saw, so several
+ * displays can follow one ring, and a reader with a fresh GPU context
+ * starts again from generation 0.
+ *
+ * Writes and reads take one short lock each: a row copy on write, the
+ * changed rows on read. Resampling happens outside it.
+ */
+class RadarVideoRing {
+public:
+    static constexpr int MAX_FILL_ROWS = 16;   // Wider gaps are lost spokes, left stale
+
+    RadarVideoRing(int azimuthCount = 2048, int rangeBins = 1024, double maxRangeM = 10000.0);
+
+    int azimuthCount() const { return m_azimuthCount; }
+    int rangeBins() const { return m_rangeBins; }
+    double maxRangeM() const { return m_maxRangeM; }
+
+    void write(const RadarSpoke& spoke, qint64 receivedMs);
+    void clear();
+
+    // Rows written after generation since, ascending, with their samples
+    // packed in the same order
+    struct Update {
+        quint64 generation = 0;    // Pass back as since next time
+        QVector<int> rows;
+        QByteArray samples;
+        QVector<qint64> rowTimeMs;
+    };
+    bool changesSince(quint64 since, Update& out) const;
+
+    double lastAzimuthDeg() const;
+    qint64 lastWriteMs() const;
+    quint64 spokesWritten() const;
+
+private:
+    void resample(const RadarSpoke& spoke, quint8* row) const;
+
+    const int m_azimuthCount;
+    const int m_rangeBins;
+    const double m_maxRangeM;
+
+    mutable QMutex m_mutex;
+    QByteArray m_samples;              // Row-major, azimuthCount x rangeBins
+    QVector<qint64> m_rowTimeMs;
+    QVector<quint64> m_rowGeneration;
+    quint64 m_generation = 1;
+    int m_lastRow = -1;
+    double m_lastAzimuthDeg = 0.0;
+    qint64 m_lastWriteMs = 0;
+    quint64 m_spokes = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // RADARVIDEORING_H
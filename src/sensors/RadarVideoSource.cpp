@@ -0,0 +1,131 @@
+#include "sensors/RadarVideoSource.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
+#include <QDateTime>
+#include <QThread>
+#include <QUdpSocket>
+
+namespace CounterUAS {
+
+RadarVideoSource::RadarVideoSource(QObject* parent)
+    : QObject(parent)
+    , m_ring(std::make_shared<RadarVideoRing>(m_config.azimuthCount, m_config.rangeBins,
+                                              m_config.maxRangeM))
+{
+}
+
+RadarVideoSource::~RadarVideoSource() {
+    stop();
+}
+
+void RadarVideoSource::setConfig(const RadarVideoConfig& config) {
+    m_config = config;
+    if (!m_thread && (m_ring->azimuthCount() != qMax(16, config.azimuthCount) ||
+                      m_ring->rangeBins() != qMax(16, config.rangeBins) ||
+                      !qFuzzyCompare(m_ring->maxRangeM(), qMax(1.0, config.maxRangeM)))) {
+        m_ring = std::make_shared<RadarVideoRing>(config.azimuthCount, config.rangeBins, config.maxRangeM);
+    }
+}
+
+bool RadarVideoSource::start() {
+    if (m_thread) return true;
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("RadarVideo");
+    m_context = new QObject;
+    m_context->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    ThreadPlacement::instance().assign(m_thread, ThreadRole::SensorIO);
+    m_thread->start();
+    m_haveSequence = false;
+
+    bool bound = false;
+    QMetaObject::invokeMethod(m_context, [this, &bound]() {
+        QUdpSocket* socket = new QUdpSocket(m_context);
+        if (!socket->bind(m_config.address, m_config.port, QUdpSocket::ShareAddress)) {
+            m_error = socket->errorString();
+            delete socket;
+            return;
+        }
+        socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, m_config.receiveBufferBytes);
+        m_port = socket->localPort();
+        connect(socket, &QUdpSocket::readyRead, m_context, [this, socket]() { readPending(socket); });
+        bound = true;
+    }, Qt::BlockingQueuedConnection);
+
+    if (!bound) {
+        Logger::instance().error("RadarVideoSource",
+                                 QString("Cannot bind port %1: %2").arg(m_config.port).arg(m_error));
+        stop();
+        return false;
+    }
+    m_error.clear();
+    Logger::instance().info("RadarVideoSource", QString("Receiving spokes on port %1").arg(m_port));
+    return true;
+}
+
+void RadarVideoSource::stop() {
+    if (!m_thread) return;
+
+    // The socket goes with the context
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_context = nullptr;
+    m_port = 0;
+}
+
+void RadarVideoSource::readPending(QUdpSocket* socket) {
+    while (socket->hasPendingDatagrams()) {
+        const int pending = static_cast<int>(qMax<qint64>(socket->pendingDatagramSize(), 0));
+        if (m_datagram.size() < pending) {
+            m_datagram.resize(pending);
+        }
+        const qint64 bytesRead = socket->readDatagram(m_datagram.data(), pending);
+        if (bytesRead > 0) {
+            ingest(m_datagram.constData(), static_cast<int>(bytesRead));
+        }
+    }
+}
+
+void RadarVideoSource::ingest(const char* data, int size) {
+    const qint64 receivedMs = QDateTime::currentMSecsSinceEpoch();
+    m_datagrams.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    RadarSpoke spoke;
+    int offset = 0;
+    quint64 spokes = 0;
+    while (offset < size) {
+        const int consumed = RadarSpokeCodec::decode(data + offset, size - offset, spoke);
+        if (consumed == 0) {
+            m_malformed.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        offset += consumed;
+
+        if (m_haveSequence && spoke.sequence - m_lastSequence > 1 &&
+            spoke.sequence - m_lastSequence < 0x80000000u) {
+            m_spokesLost.fetch_add(spoke.sequence - m_lastSequence - 1, std::memory_order_relaxed);
+        }
+        m_lastSequence = spoke.sequence;
+        m_haveSequence = true;
+
+        m_ring->write(spoke, receivedMs);
+        ++spokes;
+    }
+    m_spokes.fetch_add(spokes, std::memory_order_relaxed);
+}
+
+RadarVideoSource::Statistics RadarVideoSource::statistics() const {
+    Statistics stats;
+    stats.datagrams = m_datagrams.load(std::memory_order_relaxed);
+    stats.bytes = m_bytes.load(std::memory_order_relaxed);
+    stats.spokes = m_spokes.load(std::memory_order_relaxed);
+    stats.malformed = m_malformed.load(std::memory_order_relaxed);
+    stats.spokesLost = m_spokesLost.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace CounterUAS
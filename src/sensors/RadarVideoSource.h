@@ -0,0 +1,96 @@
+#ifndef RADARVIDEOSOURCE_H
+#define RADARVIDEOSOURCE_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QString>
+#include <atomic>
+#include <memory>
+
+#include "core/Track.h"
+#include "sensors/RadarVideoRing.h"
+
+class QThread;
+class QUdpSocket;
+
+namespace CounterUAS {
+
+/**
+ * @brief Configuration for a raw radar video stream
+ */
+struct RadarVideoConfig {
+    QHostAddress address = QHostAddress::AnyIPv4;
+    quint16 port = 5600;
+    int azimuthCount = 2048;        // Ring rows; also the display texture height
+    int rangeBins = 1024;           // Ring columns over 0..maxRangeM
+    double maxRangeM = 10000.0;
+    int receiveBufferBytes = 8 * 1024 * 1024;   // Kernel socket buffer for bursts
+    GeoPosition site;               // Antenna position, centre of the video
+};
+
+/**
+ * @brief Raw spoke export from a radar, received over UDP into a RadarVideoRing
+ *
+ * Unlike the sensors this produces no detections: it is picture for the
+ * operator, drawn under the track symbology (see PPIDisplayWidget::
+ * setRadarVideo()). The socket lives on its own thread, so tens of MB/s
+ * of spokes never queue behind the GUI or fusion; each datagram is decoded
+ * in place and resampled straight into the ring.
+ */
+class RadarVideoSource : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RadarVideoSource(QObject* parent = nullptr);
+    ~RadarVideoSource() override;
+
+    // Applied on the next start(). A new ring geometry replaces the ring,
+    // so configure before handing ring() to a display.
+    void setConfig(const RadarVideoConfig& config);
+    RadarVideoConfig config() const { return m_config; }
+    GeoPosition site() const { return m_config.site; }
+
+    bool start();
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+    quint16 port() const { return m_port; }
+    QString errorString() const { return m_error; }
+
+    // Shared with the displays; outlives the source while they hold it
+    std::shared_ptr<RadarVideoRing> ring() const { return m_ring; }
+
+    // One datagram's spokes into the ring, as the receive thread does
+    void ingest(const char* data, int size);
+
+    struct Statistics {
+        quint64 datagrams = 0;
+        quint64 bytes = 0;
+        quint64 spokes = 0;
+        quint64 malformed = 0;      // Datagrams with trailing bytes that are no spoke
+        quint64 spokesLost = 0;     // Sequence gaps
+    };
+    Statistics statistics() const;
+
+private:
+    void readPending(QUdpSocket* socket);
+
+    RadarVideoConfig m_config;
+    std::shared_ptr<RadarVideoRing> m_ring;
+    QThread* m_thread = nullptr;
+    QObject* m_context = nullptr;   // Lives on m_thread, parents the socket
+    quint16 m_port = 0;
+    QString m_error;
+    QByteArray m_datagram;          // Receive thread only
+
+    bool m_haveSequence = false;    // Receive thread only
+    quint32 m_lastSequence = 0;
+    std::atomic<quint64> m_datagrams{0};
+    std::atomic<quint64> m_bytes{0};
+    std::atomic<quint64> m_spokes{0};
+    std::atomic<quint64> m_malformed{0};
+    std::atomic<quint64> m_spokesLost{0};
+};
+
+} // namespace CounterUAS
+
+#endif // RADARVIDEOSOURCE_H
@@ -0,0 +1,271 @@
+#include "sensors/SensorClock.h"
+#include "utils/MetricsRegistry.h"
+#include <QHash>
+#include <QReadWriteLock>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+QReadWriteLock& registryLock() {
+    static QReadWriteLock lock;
+    return lock;
+}
+
+QHash<QString, std::weak_ptr<SensorClock>>& registry() {
+    static QHash<QString, std::weak_ptr<SensorClock>> clocks;
+    return clocks;
+}
+
+} // namespace
+
+SensorClock::SensorClock(const QString& sensorId, const SensorClockConfig& config)
+    : m_sensorId(sensorId)
+    , m_config(config)
+    , m_window(qMax(2, config.windowIntervals))
+{
+    m_config.minFitIntervals = qBound(2, m_config.minFitIntervals, m_window.capacity());
+    auto empty = std::make_shared<SensorClockHealth>();
+    empty->sensorId = sensorId;
+    m_health = std::move(empty);
+}
+
+void SensorClock::observe(qint64 sensorMs, qint64 receivedMs) {
+    if (sensorMs <= 0 || receivedMs <= 0) return;
+    ++m_observations;
+    m_lastObservationMs = qMax(m_lastObservationMs, receivedMs);
+
+    // Delay only ever adds, so the least difference is nearest the offset
+    const double offsetMs = static_cast<double>(receivedMs - sensorMs);
+    if (!m_haveOneWay || offsetMs < m_oneWay.offsetMs) {
+        m_oneWay.sensorMs = sensorMs;
+        m_oneWay.offsetMs = offsetMs;
+        m_oneWay.roundTripMs = -1.0;
+        m_haveOneWay = true;
+    }
+}
+
+void SensorClock::observeExchange(qint64 t1Ms, qint64 t2Ms, qint64 t3Ms, qint64 t4Ms) {
+    if (t1Ms <= 0 || t2Ms <= 0 || t3Ms < t2Ms || t4Ms < t1Ms) return;
+    const double roundTripMs = static_cast<double>((t4Ms - t1Ms) - (t3Ms - t2Ms));
+    if (roundTripMs < 0.0) return;
+    ++m_observations;
+    m_lastObservationMs = qMax(m_lastObservationMs, t4Ms);
+
+    // The shortest round trip has the least room for an asymmetric path
+    if (!m_haveExchange || roundTripMs < m_exchange.roundTripMs) {
+        m_exchange.sensorMs = t2Ms + (t3Ms - t2Ms) / 2;
+        m_exchange.offsetMs = ((t1Ms - t2Ms) + (t4Ms - t3Ms)) / 2.0;
+        m_exchange.roundTripMs = roundTripMs;
+        m_haveExchange = true;
+    }
+}
+
+void SensorClock::update(qint64 nowMs) {
+    // Close the interval, restarting the window when the clock has jumped
+    if (m_haveOneWay || m_haveExchange) {
+        const Interval interval = m_haveExchange ? m_exchange : m_oneWay;
+        if (m_haveModel) {
+            const double predictedMs = m_fit.offsetMs + m_fit.slope * (interval.sensorMs - m_fitReferenceMs);
+            if (std::abs(interval.offsetMs - predictedMs) > m_config.stepThresholdMs) {
+                m_window.clear();
+                ++m_steps;
+                m_stepped = true;
+            }
+        }
+        m_window.append(interval);
+        m_haveOneWay = false;
+        m_haveExchange = false;
+    }
+
+    auto health = std::make_shared<SensorClockHealth>();
+    health->sensorId = m_sensorId;
+    health->observations = m_observations;
+    health->steps = m_steps;
+    health->lastObservationMs = m_lastObservationMs;
+
+    if (!m_window.isEmpty()) {
+        bool exchanges = false;
+        double roundTripMs = -1.0;
+        for (const Interval& interval : m_window) {
+            if (interval.roundTripMs < 0.0) continue;
+            exchanges = true;
+            roundTripMs = roundTripMs < 0.0 ? interval.roundTripMs : qMin(roundTripMs, interval.roundTripMs);
+        }
+
+        const qint64 referenceMs = m_window.last().sensorMs;
+        Fit fit = fitWindow(referenceMs, exchanges, true);
+        const bool driftRejected = std::abs(fit.slope) * 1e6 > m_config.maxDriftPpm;
+        if (driftRejected) {
+            fit = fitWindow(referenceMs, exchanges, false);
+        }
+        m_fit = fit;
+        m_fitReferenceMs = referenceMs;
+        m_haveModel = true;
+        publishModel(referenceMs, fit.offsetMs, fit.slope);
+
+        if (fit.intervals >= m_config.minFitIntervals) {
+            m_stepped = false;
+        }
+        if (nowMs - m_lastObservationMs > m_config.holdoverMs) {
+            health->state = SensorClockState::Holdover;
+        } else if (fit.intervals < m_config.minFitIntervals) {
+            health->state = m_stepped ? SensorClockState::Unstable : SensorClockState::Acquiring;
+        } else if (driftRejected || fit.jitterMs > m_config.lockJitterMs) {
+            health->state = SensorClockState::Unstable;
+        } else {
+            health->state = SensorClockState::Locked;
+        }
+        health->exchanges = exchanges;
+        health->offsetMs = fit.offsetMs;
+        health->driftPpm = fit.slope * 1e6;
+        health->jitterMs = fit.jitterMs;
+        health->roundTripMs = qMax(0.0, roundTripMs);
+        health->intervals = fit.intervals;
+    }
+
+    // A clock never fed, like one whose sensor's stamps are corrected upstream, stays out
+    if (m_observations > 0) {
+        exportMetrics(*health);
+    }
+    std::atomic_store(&m_health, SensorClockHealthPtr(std::move(health)));
+}
+
+void SensorClock::reset() {
+    m_haveOneWay = false;
+    m_haveExchange = false;
+    m_window.clear();
+    m_haveModel = false;
+    m_stepped = false;
+    m_fit = Fit();
+    publishModel(0, 0.0, 0.0);
+}
+
+qint64 SensorClock::correct(qint64 sensorMs) const {
+    if (sensorMs <= 0) return sensorMs;
+    quint32 before;
+    qint64 referenceMs;
+    double offsetMs;
+    double slope;
+    do {
+        before = m_modelSequence.load(std::memory_order_acquire);
+        referenceMs = m_modelReferenceMs.load(std::memory_order_relaxed);
+        offsetMs = m_modelOffsetMs.load(std::memory_order_relaxed);
+        slope = m_modelSlope.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((before & 1u) != 0 || before != m_modelSequence.load(std::memory_order_relaxed));
+
+    return sensorMs + std::llround(offsetMs + slope * static_cast<double>(sensorMs - referenceMs));
+}
+
+SensorClockHealthPtr SensorClock::health() const {
+    return std::atomic_load(&m_health);
+}
+
+SensorClock::Fit SensorClock::fitWindow(qint64 referenceMs, bool exchanges, bool withDrift) const {
+    // Least squares of offset on sensor time, about the newest interval
+    double sumX = 0.0;
+    double sumY = 0.0;
+    int n = 0;
+    for (const Interval& interval : m_window) {
+        if ((interval.roundTripMs >= 0.0) != exchanges) continue;
+        sumX += static_cast<double>(interval.sensorMs - referenceMs);
+        sumY += interval.offsetMs;
+        ++n;
+    }
+
+    Fit fit;
+    fit.intervals = n;
+    if (n == 0) return fit;
+    const double meanX = sumX / n;
+    const double meanY = sumY / n;
+
+    if (withDrift && n >= m_config.minFitIntervals) {
+        double sxx = 0.0;
+        double sxy = 0.0;
+        for (const Interval& interval : m_window) {
+            if ((interval.roundTripMs >= 0.0) != exchanges) continue;
+            const double dx = static_cast<double>(interval.sensorMs - referenceMs) - meanX;
+            sxx += dx * dx;
+            sxy += dx * (interval.offsetMs - meanY);
+        }
+        if (sxx > 0.0) {
+            fit.slope = sxy / sxx;
+        }
+    }
+    fit.offsetMs = meanY - fit.slope * meanX;
+
+    double sumSquares = 0.0;
+    for (const Interval& interval : m_window) {
+        if ((interval.roundTripMs >= 0.0) != exchanges) continue;
+        const double residual = interval.offsetMs
+                              - (fit.offsetMs + fit.slope * static_cast<double>(interval.sensorMs - referenceMs));
+        sumSquares += residual * residual;
+    }
+    fit.jitterMs = std::sqrt(sumSquares / n);
+    return fit;
+}
+
+void SensorClock::publishModel(qint64 referenceMs, double offsetMs, double slope) {
+    const quint32 sequence = m_modelSequence.load(std::memory_order_relaxed);
+    m_modelSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_modelReferenceMs.store(referenceMs, std::memory_order_relaxed);
+    m_modelOffsetMs.store(offsetMs, std::memory_order_relaxed);
+    m_modelSlope.store(slope, std::memory_order_relaxed);
+    m_modelSequence.store(sequence + 2, std::memory_order_release);
+}
+
+void SensorClock::exportMetrics(const SensorClockHealth& health) {
+    if (!m_offsetGauge) {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        const MetricLabels labels = {{"sensor", m_sensorId}};
+        m_offsetGauge = registry.gauge("cuas_sensor_clock_offset_ms", "Correction added to a sensor's stamps", labels);
+        m_driftGauge = registry.gauge("cuas_sensor_clock_drift_ppm", "Sensor clock rate error against C2", labels);
+        m_jitterGauge = registry.gauge("cuas_sensor_clock_jitter_ms", "Residual RMS of a sensor clock fit", labels);
+        m_stateGauge = registry.gauge("cuas_sensor_clock_state",
+                                      "0 unsynced, 1 acquiring, 2 locked, 3 unstable, 4 holdover", labels);
+    }
+    m_offsetGauge->set(health.offsetMs);
+    m_driftGauge->set(health.driftPpm);
+    m_jitterGauge->set(health.jitterMs);
+    m_stateGauge->set(static_cast<double>(health.state));
+}
+
+void SensorClock::registerClock(const std::shared_ptr<SensorClock>& clock) {
+    if (!clock) return;
+    QWriteLocker locker(&registryLock());
+    registry().insert(clock->sensorId(), clock);
+}
+
+void SensorClock::unregisterClock(const SensorClock* clock) {
+    if (!clock) return;
+    QWriteLocker locker(&registryLock());
+    // A newer sensor may have taken the id over; leave its entry alone
+    auto it = registry().find(clock->sensorId());
+    if (it != registry().end()) {
+        std::shared_ptr<SensorClock> current = it.value().lock();
+        if (!current || current.get() == clock) {
+            registry().erase(it);
+        }
+    }
+}
+
+std::shared_ptr<SensorClock> SensorClock::find(const QString& sensorId) {
+    QReadLocker locker(&registryLock());
+    return registry().value(sensorId).lock();
+}
+
+const char* SensorClock::stateName(SensorClockState state) {
+    switch (state) {
+    case SensorClockState::Unsynced: return "Unsynced";
+    case SensorClockState::Acquiring: return "Acquiring";
+    case SensorClockState::Locked: return "Locked";
+    case SensorClockState::Unstable: return "Unstable";
+    case SensorClockState::Holdover: return "Holdover";
+    default: return "";
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,163 @@
+#ifndef SENSORCLOCK_H
+#define SENSORCLOCK_H
+
+#include <QString>
+#include <atomic>
+#include <memory>
+
+#include "utils/RingBuffer.h"
+
+namespace CounterUAS {
+
+class MetricGauge;
+
+/**
+ * @brief How far a sensor's clock can be trusted
+ */
+enum class SensorClockState : quint8 {
+    Unsynced = 0,       // Nothing observed; stamps pass through
+    Acquiring,          // Offset only, too few intervals for drift
+    Locked,             // Offset and drift from a steady fit
+    Unstable,           // Residuals or drift out of bounds, or the clock stepped recently
+    Holdover            // No stamps for a while; the last fit carries on
+};
+
+/**
+ * @brief Bounds of a sensor clock fit
+ */
+struct SensorClockConfig {
+    int windowIntervals = 60;       // Update intervals the fit spans
+    int minFitIntervals = 4;        // Before drift is estimated
+    double stepThresholdMs = 250.0; // An interval this far off the fit restarts it
+    double lockJitterMs = 5.0;      // Residual RMS at or under which the clock is Locked
+    double maxDriftPpm = 1000.0;    // A steeper fit is taken as offset only
+    qint64 holdoverMs = 5000;       // Without stamps this long the clock is in Holdover
+};
+
+/**
+ * @brief A sensor clock's fit and how well it holds, as last published
+ */
+struct SensorClockHealth {
+    QString sensorId;
+    SensorClockState state = SensorClockState::Unsynced;
+    bool exchanges = false;         // Fit from two-way exchanges rather than receive times
+    double offsetMs = 0.0;          // Added to a current sensor stamp to give C2 time
+    double driftPpm = 0.0;          // Sensor clock rate against C2, positive when it runs slow
+    double jitterMs = 0.0;          // RMS of the intervals about the fit
+    double roundTripMs = 0.0;       // Least exchange round trip in the window, 0 without exchanges
+    int intervals = 0;              // In the fit
+    quint64 observations = 0;       // Over the clock's life
+    quint64 steps = 0;              // Fit restarts on a clock jump
+    qint64 lastObservationMs = 0;   // C2 time
+};
+
+using SensorClockHealthPtr = std::shared_ptr<const SensorClockHealth>;
+
+/**
+ * @brief Per-sensor clock offset and drift, and the correction of its stamps
+ *
+ * Sensors stamp what they measure with their own clocks, which neither
+ * agree with the C2 clock nor run at its rate. Each SensorInterface keeps
+ * one of these and moves every detection stamp onto C2 time at ingest, so
+ * the detection merger and out-of-sequence handling order measurements by
+ * when they were taken.
+ *
+ * Two kinds of evidence feed it, both from the sensor's thread. observe()
+ * takes a sensor stamp and the C2 time it was read at: their difference is
+ * the clock offset plus a transport delay that is never negative, so only
+ * the least difference of each update interval is kept, the lower envelope
+ * of the delays. observeExchange() takes a two-way exchange timed at both
+ * ends, NTP or PTP style, which gives the offset with the delay cancelled
+ * when the path is symmetric; once there are exchanges in the window the
+ * fit uses them alone. Receive times alone leave the corrected stamps late
+ * by the least transport delay, no worse than stamping on receipt.
+ *
+ * update(), on the sensor's health timer, closes the interval and fits a
+ * line through the window's intervals: its value now is the offset, its
+ * slope the drift. An interval far off the line is a clock step, a reboot
+ * or an NTP jump on the sensor, and restarts the window from it. The fit is
+ * published behind a sequence lock, so correct() from any thread is three
+ * relaxed loads and a multiply-add; the health snapshot is swapped in like
+ * SensorTelemetry's and exported to the MetricsRegistry.
+ *
+ * Clocks register under their sensor id for find().
+ */
+class SensorClock {
+public:
+    explicit SensorClock(const QString& sensorId, const SensorClockConfig& config = SensorClockConfig());
+
+    SensorClock(const SensorClock&) = delete;
+    SensorClock& operator=(const SensorClock&) = delete;
+
+    QString sensorId() const { return m_sensorId; }
+
+    // Sensor's thread. Stamps of 0 or less are ignored
+    void observe(qint64 sensorMs, qint64 receivedMs);
+    // t1 C2 send, t2 sensor receive, t3 sensor reply, t4 C2 receive
+    void observeExchange(qint64 t1Ms, qint64 t2Ms, qint64 t3Ms, qint64 t4Ms);
+    void update(qint64 nowMs);
+    // Forgets the fit, as for a new connection to a different unit
+    void reset();
+
+    // Any thread. Stamps of 0 or less, which mean none, are returned as given
+    qint64 correct(qint64 sensorMs) const;
+    SensorClockHealthPtr health() const;
+
+    // Registry keyed by sensor id; SensorInterface registers its own
+    static void registerClock(const std::shared_ptr<SensorClock>& clock);
+    static void unregisterClock(const SensorClock* clock);
+    static std::shared_ptr<SensorClock> find(const QString& sensorId);
+
+    static const char* stateName(SensorClockState state);
+
+private:
+    struct Interval {
+        qint64 sensorMs = 0;        // Sensor time the offset was seen at
+        double offsetMs = 0.0;      // C2 minus sensor
+        double roundTripMs = -1.0;  // Negative for a receive time
+    };
+
+    struct Fit {
+        double offsetMs = 0.0;      // At the reference
+        double slope = 0.0;         // Offset change per sensor ms
+        double jitterMs = 0.0;
+        int intervals = 0;
+    };
+
+    Fit fitWindow(qint64 referenceMs, bool exchanges, bool withDrift) const;
+    void publishModel(qint64 referenceMs, double offsetMs, double slope);
+    void exportMetrics(const SensorClockHealth& health);
+
+    QString m_sensorId;
+    SensorClockConfig m_config;
+
+    // Sensor's thread
+    Interval m_oneWay;              // Least delay of the open interval
+    Interval m_exchange;            // Shortest round trip of the open interval
+    bool m_haveOneWay = false;
+    bool m_haveExchange = false;
+    RingBuffer<Interval> m_window;
+    quint64 m_observations = 0;
+    quint64 m_steps = 0;
+    qint64 m_lastObservationMs = 0;
+    bool m_stepped = false;         // Until the restarted window can fit drift
+    bool m_haveModel = false;
+    Fit m_fit;
+    qint64 m_fitReferenceMs = 0;
+    MetricGauge* m_offsetGauge = nullptr;
+    MetricGauge* m_driftGauge = nullptr;
+    MetricGauge* m_jitterGauge = nullptr;
+    MetricGauge* m_stateGauge = nullptr;
+
+    // correct()'s model, under m_modelSequence: odd while it is written
+    std::atomic<quint32> m_modelSequence{0};
+    std::atomic<qint64> m_modelReferenceMs{0};
+    std::atomic<double> m_modelOffsetMs{0.0};
+    std::atomic<double> m_modelSlope{0.0};
+
+    SensorClockHealthPtr m_health;  // Swapped with std::atomic_store/atomic_load
+};
+
+} // namespace CounterUAS
+
+#endif // SENSORCLOCK_H
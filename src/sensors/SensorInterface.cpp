@@ -1,5 +1,9 @@
 #include "sensors/SensorInterface.h"
 #include "utils/Logger.h"
+#include "utils/RawCapture.h"
+#include "utils/StatusBoard.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
 
 namespace CounterUAS {
 
@@ -7,19 +11,57 @@ SensorInterface::SensorInterface(const QString& sensorId, QObject* parent)
     : QObject(parent)
     , m_sensorId(sensorId)
     , m_name(sensorId)
-    , m_updateTimer(new QTimer(this))
-    , m_healthTimer(new QTimer(this))
+    , m_telemetry(std::make_shared<SensorTelemetry>(sensorId))
+    , m_clock(std::make_shared<SensorClock>(sensorId))
+    , m_updateTimer(this, [this]() {
+        const qint64 startNs = TimeUtils::monotonicNs();
+        processData();
+        ThreadPlacement::instance().reportCycle(ThreadRole::SensorIO, (TimeUtils::monotonicNs() - startNs) / 1000,
+                                                1000000 / m_updateRateHz);
+    })
+    , m_healthTimer(this, [this]() { updateHealth(); })
 {
-    QObject::connect(m_updateTimer, &QTimer::timeout, this, &SensorInterface::processData);
-    QObject::connect(m_healthTimer, &QTimer::timeout, this, &SensorInterface::updateHealth);
-    
-    m_healthTimer->setInterval(1000);  // Health check every second
+    m_healthTimer.setInterval(1000);  // Health check every second
+    SensorTelemetry::registerTelemetry(m_telemetry);
+    SensorClock::registerClock(m_clock);
+}
+
+SensorInterface::~SensorInterface() {
+    SensorTelemetry::unregisterTelemetry(m_telemetry.get());
+    SensorClock::unregisterClock(m_clock.get());
+    StatusBoard::instance().remove(m_sensorId, StatusKind::Sensor);
+}
+
+const char* SensorInterface::statusName(SensorStatus status) {
+    switch (status) {
+    case SensorStatus::Unknown: return "Unknown";
+    case SensorStatus::Initializing: return "Initializing";
+    case SensorStatus::Online: return "Online";
+    case SensorStatus::Degraded: return "Degraded";
+    case SensorStatus::Offline: return "Offline";
+    case SensorStatus::Error: return "Error";
+    case SensorStatus::Maintenance: return "Maintenance";
+    default: return "";
+    }
+}
+
+void SensorInterface::setCapture(const std::shared_ptr<RawCaptureRecorder>& recorder) {
+    m_capture = recorder;
+    m_captureChannel = recorder ? recorder->openChannel(m_sensorId, rawCaptureKind()) : -1;
+}
+
+RawCaptureKind SensorInterface::rawCaptureKind() const {
+    return RawCaptureKind::Datagram;
+}
+
+void SensorInterface::recordCapture(const char* data, int size, qint64 receivedNs) {
+    m_capture->record(m_captureChannel, data, size, receivedNs);
 }
 
 void SensorInterface::setUpdateRate(int hz) {
     m_updateRateHz = qBound(1, hz, 100);
     if (m_running) {
-        m_updateTimer->setInterval(1000 / m_updateRateHz);
+        m_updateTimer.setInterval(1000 / m_updateRateHz);
     }
 }
 
@@ -33,12 +75,13 @@ void SensorInterface::start() {
         }
     }
     
-    m_updateTimer->setInterval(1000 / m_updateRateHz);
-    m_updateTimer->start();
-    m_healthTimer->start();
+    m_updateTimer.setInterval(1000 / m_updateRateHz);
+    m_updateTimer.start();
+    m_healthTimer.start();
     m_running = true;
     
-    setStatus(SensorStatus::Online);
+    // Network sensors connect asynchronously and go Online when the link is up
+    setStatus(isConnected() ? SensorStatus::Online : SensorStatus::Initializing);
     
     Logger::instance().info("Sensor", 
                            QString("%1 started at %2 Hz").arg(m_sensorId).arg(m_updateRateHz));
@@ -47,8 +90,8 @@ void SensorInterface::start() {
 void SensorInterface::stop() {
     if (!m_running) return;
     
-    m_updateTimer->stop();
-    m_healthTimer->stop();
+    m_updateTimer.stop();
+    m_healthTimer.stop();
     m_running = false;
     
     Logger::instance().info("Sensor", m_sensorId + " stopped");
@@ -59,6 +102,11 @@ void SensorInterface::setStatus(SensorStatus status) {
         m_health.status = status;
         emit statusChanged(status);
         emit healthUpdated(m_health);
+        
+        QVariantHash fields;
+        fields.insert("status", QString::fromLatin1(statusName(status)));
+        fields.insert("error", m_health.errorMessage);
+        StatusBoard::instance().publish(m_sensorId, StatusKind::Sensor, fields);
     }
 }
 
@@ -73,11 +121,43 @@ void SensorInterface::reportError(const QString& message) {
 void SensorInterface::recordDetection() {
     m_health.detectionCount++;
     m_health.lastDetectionTime = QDateTime::currentMSecsSinceEpoch();
+    m_telemetry->recordDetections();
+}
+
+void SensorInterface::correctTimestamps(SensorDetection* detections, int count) {
+    if (count <= 0) return;
+    
+    // The newest stamp of a read waited least for it
+    qint64 newestMs = 0;
+    for (int i = 0; i < count; ++i) {
+        newestMs = qMax(newestMs, detections[i].timestamp);
+    }
+    if (newestMs <= 0) return;
+    
+    qint64 receivedMs = QDateTime::currentMSecsSinceEpoch();
+    if (detections[0].ingestMonoNs > 0) {
+        receivedMs -= (TimeUtils::monotonicNs() - detections[0].ingestMonoNs) / 1000000;
+    }
+    m_clock->observe(newestMs, receivedMs);
+    
+    for (int i = 0; i < count; ++i) {
+        detections[i].timestamp = m_clock->correct(detections[i].timestamp);
+    }
 }
 
 void SensorInterface::updateHealth() {
     // Update signal quality based on detection rate
     qint64 now = QDateTime::currentMSecsSinceEpoch();
+    
+    m_telemetry->publish(now);
+    const SensorTelemetryPtr telemetry = m_telemetry->snapshot();
+    m_health.messagesPerSec = telemetry->latest.messagesPerSec;
+    m_health.bytesPerSec = telemetry->latest.bytesPerSec;
+    m_health.droppedPackets = static_cast<int>(telemetry->totalDropped);
+    m_clock->update(now);
+    const SensorClockHealthPtr clock = m_clock->health();
+    m_health.clockState = clock->state;
+    m_health.clockOffsetMs = clock->offsetMs;
     qint64 timeSinceDetection = now - m_health.lastDetectionTime;
     
     if (timeSinceDetection < 1000) {
@@ -100,6 +180,36 @@ void SensorInterface::updateHealth() {
     }
     
     emit healthUpdated(m_health);
+    publishStatus();
+}
+
+void SensorInterface::publishStatus() {
+    // Rounded as shown, so a steady sensor republishes nothing new
+    const auto shown = [](double value, double step) { return qRound(value / step) * step; };
+    const SensorTelemetryPtr telemetry = m_telemetry->snapshot();
+    const SensorTelemetrySample& sample = telemetry->latest;
+    const SensorClockHealthPtr clock = m_clock->health();
+    
+    QVariantHash fields;
+    fields.insert("status", QString::fromLatin1(statusName(m_health.status)));
+    fields.insert("error", m_health.errorMessage);
+    fields.insert("signalQuality", m_health.signalQuality);
+    fields.insert("detections", telemetry->totalDetections);
+    fields.insert("dropped", telemetry->totalDropped);
+    fields.insert("messagesPerSec", shown(sample.messagesPerSec, 0.1));
+    fields.insert("kBytesPerSec", shown(sample.bytesPerSec / 1024.0, 0.1));
+    fields.insert("parseP50Us", sample.parseP50Us);
+    fields.insert("parseP99Us", sample.parseP99Us);
+    fields.insert("queueDepth", sample.queueDepth);
+    fields.insert("latencyMeanUs", qRound(sample.latencyMeanUs));
+    fields.insert("latencyMaxUs", sample.latencyMaxUs);
+    fields.insert("clockState", QString::fromLatin1(SensorClock::stateName(clock->state)));
+    fields.insert("clockExchanges", clock->exchanges);
+    fields.insert("clockOffsetMs", shown(clock->offsetMs, 0.1));
+    fields.insert("clockDriftPpm", shown(clock->driftPpm, 0.1));
+    fields.insert("clockJitterMs", shown(clock->jitterMs, 0.1));
+    fields.insert("clockSteps", clock->steps);
+    StatusBoard::instance().publish(m_sensorId, StatusKind::Sensor, fields);
 }
 
 } // namespace CounterUAS
@@ -3,13 +3,22 @@
 
 #include <QObject>
 #include <QString>
-#include <QTimer>
 #include <QDateTime>
 #include <QVariant>
+#include <QVector>
+#include <cstring>
+#include <memory>
+#include <type_traits>
 #include "core/Track.h"
+#include "sensors/SensorClock.h"
+#include "sensors/SensorTelemetry.h"
+#include "utils/TimerService.h"
 
 namespace CounterUAS {
 
+class RawCaptureRecorder;
+enum class RawCaptureKind : quint8;
+
 /**
  * @brief Sensor status enum
  */
@@ -36,10 +45,108 @@ struct SensorHealth {
     double memoryUsage = 0.0;
     int droppedPackets = 0;
     int connectionRetries = 0;
+    double messagesPerSec = 0.0;   // From the latest telemetry sample
+    double bytesPerSec = 0.0;
+    SensorClockState clockState = SensorClockState::Unsynced;
+    double clockOffsetMs = 0.0;    // Added to the sensor's stamps
+};
+
+/**
+ * @brief Radar plot fields of a detection
+ */
+struct RadarPlotInfo {
+    quint32 trackNumber;        // The radar's own track, 0 for a raw plot
+    float rangeM;
+    float azimuthDeg;
+    float elevationDeg;
+};
+
+/**
+ * @brief RF emission fields of a detection
+ */
+struct RFEmissionInfo {
+    char protocol[24];          // NUL-terminated, as the detector's protocol table names it
+    float frequencyMHz;
+    float signalStrengthDbm;
+    float azimuthDeg;
+    float elevationDeg;
+    float bearingSigmaDeg;      // 0 without direction finding, and the sensor fields unset
+    float sensorAltitude;
+    double sensorLatitude;
+    double sensorLongitude;
+    quint16 sensorCount;        // Bearings behind an RFBearingFuser fix, 0 for one detector
+    float residualM;            // RMS miss of those bearings
+};
+
+/**
+ * @brief Camera fields of a detection
+ */
+struct CameraBoxInfo {
+    float x;                    // Normalized 0-1, as CameraDetection's box
+    float y;
+    float width;
+    float height;
+    qint64 frameNumber;
+    char objectClass[16];       // NUL-terminated, e.g. "drone"
+};
+
+/**
+ * @brief Cooperative broadcast fields of a detection
+ */
+struct CooperativeInfo {
+    char id[24];                // ICAO address or Remote ID serial, NUL-terminated
+    char callsign[16];          // Empty when none was broadcast
+    qint8 classification;       // TrackClassification
+    bool adsb;                  // Else Remote ID
+};
+
+/**
+ * @brief Fields of a Combined detection: a track another C2 node reported
+ */
+struct CombinedTrackInfo {
+    char trackId[24];           // The reporting node's track id, NUL-terminated
+    qint8 classification;       // TrackClassification
+    quint8 threatLevel;
+    float classificationConfidence;
+};
+
+/**
+ * @brief Per-source fields of a detection; the member its sourceType names
+ *
+ * Zeroed on construction and trivially copyable, so a detection's typed
+ * fields cost nothing to create or queue.
+ */
+union SensorDetectionInfo {
+    RadarPlotInfo radar;
+    RFEmissionInfo rf;
+    CameraBoxInfo camera;
+    CooperativeInfo cooperative;
+    CombinedTrackInfo combined;
+
+    SensorDetectionInfo() { std::memset(this, 0, sizeof(*this)); }
 };
+static_assert(std::is_trivially_copyable<SensorDetectionInfo>::value,
+              "Detections are copied through queues by value");
+
+// Into a fixed NUL-terminated field, truncated; Latin-1
+template <int N>
+inline void setFixedString(char (&field)[N], const QString& value) {
+    const int length = qMin(N - 1, value.size());
+    for (int i = 0; i < length; ++i) field[i] = value.at(i).toLatin1();
+    field[length] = '\0';
+}
+
+template <int N>
+inline QString fixedString(const char (&field)[N]) {
+    return QString::fromLatin1(field, static_cast<int>(qstrnlen(field, N)));
+}
 
 /**
  * @brief Sensor detection result
+ *
+ * Sensor-specific fields are in info, typed by sourceType; metadata is
+ * an extension for what they do not cover and is empty from the
+ * sensors in this tree.
  */
 struct SensorDetection {
     QString sensorId;
@@ -47,9 +154,11 @@ struct SensorDetection {
     VelocityVector velocity;
     double signalStrength = 0.0;
     double confidence = 0.0;
-    qint64 timestamp = 0;
+    qint64 timestamp = 0;        // Epoch ms on the C2 clock once the sensor's clock is corrected
     DetectionSource sourceType;
+    SensorDetectionInfo info;
     QVariantMap metadata;
+    qint64 ingestMonoNs = 0;     // TimeUtils::monotonicNs() at socket read, 0 if unknown
 };
 
 /**
@@ -64,7 +173,7 @@ class SensorInterface : public QObject {
     
 public:
     explicit SensorInterface(const QString& sensorId, QObject* parent = nullptr);
-    ~SensorInterface() override = default;
+    ~SensorInterface() override;
     
     // Identity
     QString sensorId() const { return m_sensorId; }
@@ -79,6 +188,15 @@ public:
     // Status
     SensorStatus status() const { return m_health.status; }
     SensorHealth health() const { return m_health; }
+    static const char* statusName(SensorStatus status);
+    
+    // Ingest instrumentation; the snapshot is safe to read from any thread
+    SensorTelemetry& telemetry() { return *m_telemetry; }
+    SensorTelemetryPtr telemetrySnapshot() const { return m_telemetry->snapshot(); }
+    
+    // Offset and drift of the sensor's clock against C2; correct() is safe from any thread
+    SensorClock& clock() { return *m_clock; }
+    const SensorClock& clock() const { return *m_clock; }
     
     // Configuration
     void setUpdateRate(int hz);
@@ -95,6 +213,12 @@ public:
     virtual void stop();
     bool isRunning() const { return m_running; }
     
+    // Tees every raw read into the recorder, null for none; set before start()
+    void setCapture(const std::shared_ptr<RawCaptureRecorder>& recorder);
+    // A captured read of this sensor's, handled as if it had just arrived;
+    // false when the sensor cannot take it in its current connection
+    virtual bool replayRaw(const QByteArray& data) { Q_UNUSED(data) return false; }
+    
     // Coverage
     virtual double maxRange() const { return 5000.0; }  // meters
     virtual double fieldOfView() const { return 360.0; } // degrees
@@ -102,6 +226,8 @@ public:
     
 signals:
     void detection(const SensorDetection& detection);
+    // Every detection decoded from one read; sensors emit either this or detection()
+    void detectionBatch(const QVector<SensorDetection>& detections);
     void statusChanged(SensorStatus status);
     void connectedChanged(bool connected);
     void healthUpdated(const SensorHealth& health);
@@ -115,16 +241,34 @@ protected:
     void setStatus(SensorStatus status);
     void reportError(const QString& message);
     void recordDetection();
+    // Observes the stamps of one read against its ingest time, then moves
+    // them onto C2 time; call before the detections go out
+    void correctTimestamps(SensorDetection* detections, int count);
+    // How the connection's reads are framed, for the capture channel
+    virtual RawCaptureKind rawCaptureKind() const;
+    // Any thread; receivedNs is TimeUtils::monotonicNs() at the read, 0 for now
+    void captureRaw(const char* data, int size, qint64 receivedNs = 0) {
+        if (m_capture) recordCapture(data, size, receivedNs);
+    }
     
     QString m_sensorId;
     QString m_name;
     GeoPosition m_position;
     SensorHealth m_health;
+    std::shared_ptr<SensorTelemetry> m_telemetry;
+    std::shared_ptr<SensorClock> m_clock;
+    std::shared_ptr<RawCaptureRecorder> m_capture;
+    int m_captureChannel = -1;
     
     int m_updateRateHz = 10;
-    QTimer* m_updateTimer;
-    QTimer* m_healthTimer;
+    ServiceTimer m_updateTimer;
+    ServiceTimer m_healthTimer;
     bool m_running = false;
+    
+private:
+    void recordCapture(const char* data, int size, qint64 receivedNs);
+    // Health, telemetry and clock to the StatusBoard, at display precision
+    void publishStatus();
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,166 @@
+#include "sensors/SensorTelemetry.h"
+#include "utils/PipelineLatency.h"
+#include <QHash>
+#include <QReadWriteLock>
+
+namespace CounterUAS {
+
+namespace {
+
+QReadWriteLock& registryLock() {
+    static QReadWriteLock lock;
+    return lock;
+}
+
+QHash<QString, std::weak_ptr<SensorTelemetry>>& registry() {
+    static QHash<QString, std::weak_ptr<SensorTelemetry>> telemetry;
+    return telemetry;
+}
+
+} // namespace
+
+SensorTelemetry::SensorTelemetry(const QString& sensorId)
+    : m_sensorId(sensorId)
+    , m_history(HISTORY_SECONDS)
+{
+    for (auto& bucket : m_parseHistogram) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    auto empty = std::make_shared<SensorTelemetrySnapshot>();
+    empty->sensorId = sensorId;
+    m_snapshot = std::move(empty);
+}
+
+void SensorTelemetry::recordParseNs(qint64 ns) {
+    // floor(log2(us)), clamped to the histogram
+    quint64 us = ns > 0 ? static_cast<quint64>(ns / 1000) : 0;
+    int bucket = 0;
+    while (us > 1 && bucket < PARSE_BUCKETS - 1) {
+        us >>= 1;
+        ++bucket;
+    }
+    m_parseHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    PipelineLatency::record(PipelineStage::Parse, ns / 1000);
+}
+
+void SensorTelemetry::recordDetectionLatencyUs(qint64 us) {
+    if (us < 0) us = 0;
+    m_latencySumUs.fetch_add(static_cast<quint64>(us), std::memory_order_relaxed);
+    m_latencyLastUs.store(us, std::memory_order_relaxed);
+    qint64 seen = m_latencyMaxUs.load(std::memory_order_relaxed);
+    while (us > seen &&
+           !m_latencyMaxUs.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {
+    }
+    // Counted last so a publish never sees a count without its sum
+    m_latencyCount.fetch_add(1, std::memory_order_release);
+}
+
+void SensorTelemetry::publish(qint64 nowMs) {
+    auto snap = std::make_shared<SensorTelemetrySnapshot>();
+    snap->sensorId = m_sensorId;
+
+    const quint64 latencyCount = m_latencyCount.load(std::memory_order_acquire);
+    const quint64 latencySumUs = m_latencySumUs.load(std::memory_order_relaxed);
+    const qint64 latencyMaxUs = m_latencyMaxUs.exchange(0, std::memory_order_relaxed);
+    snap->totalBytes = m_bytes.load(std::memory_order_relaxed);
+    snap->totalMessages = m_messages.load(std::memory_order_relaxed);
+    snap->totalDetections = m_detections.load(std::memory_order_relaxed);
+    snap->totalDropped = m_dropped.load(std::memory_order_relaxed);
+
+    quint64 interval[PARSE_BUCKETS];
+    for (int i = 0; i < PARSE_BUCKETS; ++i) {
+        snap->parseHistogram[i] = m_parseHistogram[i].load(std::memory_order_relaxed);
+        interval[i] = snap->parseHistogram[i] - m_lastHistogram[i];
+        m_lastHistogram[i] = snap->parseHistogram[i];
+    }
+
+    // The first publish has no interval to divide by; report counts as rates
+    const double seconds =
+        m_lastPublishMs > 0 && nowMs > m_lastPublishMs ? (nowMs - m_lastPublishMs) / 1000.0 : 1.0;
+
+    SensorTelemetrySample& sample = snap->latest;
+    sample.timestampMs = nowMs;
+    sample.bytesPerSec = (snap->totalBytes - m_lastBytes) / seconds;
+    sample.messagesPerSec = (snap->totalMessages - m_lastMessages) / seconds;
+    sample.detectionsPerSec = (snap->totalDetections - m_lastDetections) / seconds;
+    sample.dropped = snap->totalDropped - m_lastDropped;
+    sample.queueDepth = m_queueDepth.load(std::memory_order_relaxed);
+    sample.parseP50Us = percentileUs(interval, 0.50);
+    sample.parseP99Us = percentileUs(interval, 0.99);
+
+    const quint64 intervalLatencies = latencyCount - m_lastLatencyCount;
+    if (intervalLatencies > 0) {
+        sample.latencyMeanUs =
+            static_cast<double>(latencySumUs - m_lastLatencySumUs) / intervalLatencies;
+        sample.latencyMaxUs = latencyMaxUs;
+    }
+
+    m_lifetimeLatencyMaxUs = qMax(m_lifetimeLatencyMaxUs, latencyMaxUs);
+    snap->detectionToTrack.count = latencyCount;
+    snap->detectionToTrack.lastUs = m_latencyLastUs.load(std::memory_order_relaxed);
+    snap->detectionToTrack.maxUs = m_lifetimeLatencyMaxUs;
+    snap->detectionToTrack.meanUs =
+        latencyCount > 0 ? static_cast<double>(latencySumUs) / latencyCount : 0.0;
+
+    m_history.append(sample);
+    snap->history.reserve(m_history.size());
+    for (const SensorTelemetrySample& s : m_history) {
+        snap->history.append(s);
+    }
+
+    m_lastPublishMs = nowMs;
+    m_lastBytes = snap->totalBytes;
+    m_lastMessages = snap->totalMessages;
+    m_lastDetections = snap->totalDetections;
+    m_lastDropped = snap->totalDropped;
+    m_lastLatencyCount = latencyCount;
+    m_lastLatencySumUs = latencySumUs;
+
+    std::atomic_store(&m_snapshot, SensorTelemetryPtr(std::move(snap)));
+}
+
+SensorTelemetryPtr SensorTelemetry::snapshot() const {
+    return std::atomic_load(&m_snapshot);
+}
+
+qint64 SensorTelemetry::percentileUs(const quint64* histogram, double fraction) {
+    quint64 total = 0;
+    for (int i = 0; i < PARSE_BUCKETS; ++i) {
+        total += histogram[i];
+    }
+    if (total == 0) return 0;
+
+    const quint64 rank = qMax<quint64>(1, static_cast<quint64>(fraction * total + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i < PARSE_BUCKETS; ++i) {
+        seen += histogram[i];
+        if (seen >= rank) return qint64(1) << (i + 1);
+    }
+    return qint64(1) << PARSE_BUCKETS;
+}
+
+void SensorTelemetry::registerTelemetry(const std::shared_ptr<SensorTelemetry>& telemetry) {
+    if (!telemetry) return;
+    QWriteLocker locker(&registryLock());
+    registry().insert(telemetry->sensorId(), telemetry);
+}
+
+void SensorTelemetry::unregisterTelemetry(const SensorTelemetry* telemetry) {
+    if (!telemetry) return;
+    QWriteLocker locker(&registryLock());
+    // A newer sensor may have taken the id over; leave its entry alone
+    auto it = registry().find(telemetry->sensorId());
+    if (it != registry().end()) {
+        std::shared_ptr<SensorTelemetry> current = it.value().lock();
+        if (!current || current.get() == telemetry) {
+            registry().erase(it);
+        }
+    }
+}
+
+std::shared_ptr<SensorTelemetry> SensorTelemetry::find(const QString& sensorId) {
+    QReadLocker locker(&registryLock());
+    return registry().value(sensorId).lock();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,129 @@
+#ifndef SENSORTELEMETRY_H
+#define SENSORTELEMETRY_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "utils/LatencyStats.h"
+#include "utils/RingBuffer.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief One second of a sensor's ingest activity
+ */
+struct SensorTelemetrySample {
+    qint64 timestampMs = 0;        // End of the interval
+    double bytesPerSec = 0.0;
+    double messagesPerSec = 0.0;
+    double detectionsPerSec = 0.0;
+    quint64 dropped = 0;           // Messages dropped in the interval
+    int queueDepth = 0;            // Bytes awaiting parse when published
+    qint64 parseP50Us = 0;         // Bucket upper bounds, from the interval's histogram
+    qint64 parseP99Us = 0;
+    double latencyMeanUs = 0.0;    // Detection to track update
+    qint64 latencyMaxUs = 0;
+};
+
+/**
+ * @brief Immutable telemetry published once per health interval
+ */
+struct SensorTelemetrySnapshot {
+    static constexpr int PARSE_BUCKETS = 16;
+
+    QString sensorId;
+    quint64 totalBytes = 0;
+    quint64 totalMessages = 0;
+    quint64 totalDetections = 0;
+    quint64 totalDropped = 0;
+    // Bucket 0 holds parses under 2 us, bucket i [2^i, 2^(i+1)) us, the last
+    // everything slower
+    quint64 parseHistogram[PARSE_BUCKETS] = {};
+    LatencyStats detectionToTrack;
+    SensorTelemetrySample latest;
+    QVector<SensorTelemetrySample> history;   // Oldest first
+};
+
+using SensorTelemetryPtr = std::shared_ptr<const SensorTelemetrySnapshot>;
+
+/**
+ * @brief Per-sensor ingest instrumentation off the hot path
+ *
+ * The record calls are single relaxed atomic adds, safe from any thread:
+ * the sensor's I/O thread counts bytes, messages and parse time, and the
+ * TrackManager's thread reports detection-to-track latency. Once per health
+ * interval the sensor calls publish(), which turns the counter deltas into
+ * a per-second sample, appends it to a ring of the last minute and swaps in
+ * a new immutable snapshot. Readers such as SensorStatusPanel take that
+ * snapshot with one atomic load and never touch the counters.
+ *
+ * Every sensor registers its telemetry under its id, so components that
+ * only see SensorDetection can still find it with find().
+ */
+class SensorTelemetry {
+public:
+    static constexpr int PARSE_BUCKETS = SensorTelemetrySnapshot::PARSE_BUCKETS;
+    static constexpr int HISTORY_SECONDS = 60;
+
+    explicit SensorTelemetry(const QString& sensorId);
+
+    SensorTelemetry(const SensorTelemetry&) = delete;
+    SensorTelemetry& operator=(const SensorTelemetry&) = delete;
+
+    QString sensorId() const { return m_sensorId; }
+
+    // Hot path, any thread
+    void recordRead(qint64 bytes) { m_bytes.fetch_add(static_cast<quint64>(bytes), std::memory_order_relaxed); }
+    void recordMessages(int count = 1) { m_messages.fetch_add(count, std::memory_order_relaxed); }
+    void recordDetections(int count = 1) { m_detections.fetch_add(count, std::memory_order_relaxed); }
+    void recordDropped(int count = 1) { m_dropped.fetch_add(count, std::memory_order_relaxed); }
+    void setQueueDepth(int depth) { m_queueDepth.store(depth, std::memory_order_relaxed); }
+    void recordParseNs(qint64 ns);
+    void recordDetectionLatencyUs(qint64 us);
+
+    // Publisher: one thread at a time (the sensor's health timer)
+    void publish(qint64 nowMs);
+    SensorTelemetryPtr snapshot() const;
+
+    // Upper bound of the bucket holding the fraction-th parse
+    static qint64 percentileUs(const quint64* histogram, double fraction);
+
+    // Registry keyed by sensor id; SensorInterface registers its own
+    static void registerTelemetry(const std::shared_ptr<SensorTelemetry>& telemetry);
+    static void unregisterTelemetry(const SensorTelemetry* telemetry);
+    static std::shared_ptr<SensorTelemetry> find(const QString& sensorId);
+
+private:
+    QString m_sensorId;
+
+    std::atomic<quint64> m_bytes{0};
+    std::atomic<quint64> m_messages{0};
+    std::atomic<quint64> m_detections{0};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<int> m_queueDepth{0};
+    std::atomic<quint64> m_parseHistogram[PARSE_BUCKETS];
+    std::atomic<quint64> m_latencyCount{0};
+    std::atomic<quint64> m_latencySumUs{0};
+    std::atomic<qint64> m_latencyMaxUs{0};    // Since the last publish
+    std::atomic<qint64> m_latencyLastUs{0};
+
+    // Publisher state
+    qint64 m_lastPublishMs = 0;
+    quint64 m_lastBytes = 0;
+    quint64 m_lastMessages = 0;
+    quint64 m_lastDetections = 0;
+    quint64 m_lastDropped = 0;
+    quint64 m_lastHistogram[PARSE_BUCKETS] = {};
+    quint64 m_lastLatencyCount = 0;
+    quint64 m_lastLatencySumUs = 0;
+    qint64 m_lifetimeLatencyMaxUs = 0;
+    RingBuffer<SensorTelemetrySample> m_history;
+
+    SensorTelemetryPtr m_snapshot;   // Swapped with std::atomic_store/atomic_load
+};
+
+} // namespace CounterUAS
+
+#endif // SENSORTELEMETRY_H
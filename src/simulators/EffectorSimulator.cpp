@@ -8,6 +8,7 @@
 #include "effectors/RFJammer.h"
 #include "effectors/KineticInterceptor.h"
 #include "effectors/DirectedEnergySystem.h"
+#include "utils/CoordinateUtils.h"
 #include "utils/Logger.h"
 #include <QDateTime>
 #include <QtMath>
@@ -18,8 +19,14 @@ EffectorSimulator::EffectorSimulator(EngagementManager* manager, QObject* parent
     : QObject(parent)
     , m_engagementManager(manager)
     , m_updateTimer(new QTimer(this))
+    , m_seed(FastRandom::entropySeed())
 {
     connect(m_updateTimer, &QTimer::timeout, this, &EffectorSimulator::updateSimulation);
+    
+    m_flights.setRealistic(m_realisticMode);
+    m_flights.setFailureRate(m_failureRate);
+    m_flights.setWeatherFactor(m_weatherFactor);
+    restartClock(QDateTime::currentMSecsSinceEpoch());
 }
 
 EffectorSimulator::~EffectorSimulator() {
@@ -34,6 +41,8 @@ void EffectorSimulator::start() {
     if (m_running) return;
     
     m_running = true;
+    restartClock(QDateTime::currentMSecsSinceEpoch());
+    m_wallTimer.start();
     m_updateTimer->start(1000 / m_updateRateHz);
     
     Logger::instance().info("EffectorSimulator", "Simulation started");
@@ -57,6 +66,27 @@ void EffectorSimulator::setUpdateRate(int hz) {
     }
 }
 
+void EffectorSimulator::setSeed(quint64 seed) {
+    m_seed = seed;
+    restartClock(m_clock.nowMs());
+}
+
+void EffectorSimulator::restartClock(qint64 startMs) {
+    m_clock.setTime(startMs);
+    m_targetMs = startMs;
+    m_random.reseed(m_seed, EFFECT_STREAM);
+    m_flights.reset(m_seed, startMs);
+    for (KineticSimState& state : m_kineticStates) {
+        state.flightSerial = 0;
+    }
+}
+
+void EffectorSimulator::advance(qint64 ms) {
+    if (ms <= 0) return;
+    m_targetMs += ms;
+    advanceTo(static_cast<qint64>(m_targetMs));
+}
+
 void EffectorSimulator::registerRFJammer(RFJammer* jammer) {
     if (!jammer) return;
     
@@ -69,7 +99,7 @@ void EffectorSimulator::registerRFJammer(RFJammer* jammer) {
             m_rfJammerStates[id].active = active;
             m_rfJammerStates[id].currentPowerW = power;
             if (active) {
-                m_rfJammerStates[id].engagementStartTime = QDateTime::currentMSecsSinceEpoch();
+                m_rfJammerStates[id].engagementStartTime = m_clock.nowMs();
             }
         }
     });
@@ -93,6 +123,7 @@ void EffectorSimulator::registerKineticInterceptor(KineticInterceptor* intercept
         if (!m_kineticStates.contains(id)) return;
         
         auto& state = m_kineticStates[id];
+        const bool flying = m_flights.row(state.flightSerial) >= 0;
         switch (phase) {
             case KineticInterceptor::LaunchPhase::Idle:
                 state.phase = KineticSimState::Phase::Idle;
@@ -102,23 +133,31 @@ void EffectorSimulator::registerKineticInterceptor(KineticInterceptor* intercept
                 break;
             case KineticInterceptor::LaunchPhase::Launching:
                 state.phase = KineticSimState::Phase::Launching;
-                state.launchTime = QDateTime::currentMSecsSinceEpoch();
                 state.currentPosition = state.launcherPosition;
                 break;
             case KineticInterceptor::LaunchPhase::InFlight:
                 state.phase = KineticSimState::Phase::InFlight;
-                state.speed = 100.0;  // m/s
+                launchFlight(id);
                 break;
             case KineticInterceptor::LaunchPhase::Terminal:
-                state.phase = KineticSimState::Phase::Terminal;
-                break;
             case KineticInterceptor::LaunchPhase::Complete:
-                state.phase = KineticSimState::Phase::Complete;
+                // While its round is in the air the batch decides how that goes
+                if (flying) return;
+                state.phase = phase == KineticInterceptor::LaunchPhase::Terminal
+                            ? KineticSimState::Phase::Terminal : KineticSimState::Phase::Complete;
                 break;
         }
         emit kineticStateChanged(id, state);
     });
     
+    // Whoever commanded it, the round goes where the interceptor was aimed
+    connect(interceptor, &KineticInterceptor::engagementStarted,
+            this, [this, id](const GeoPosition& target) {
+        if (m_kineticStates.contains(id)) {
+            m_kineticStates[id].targetPosition = target;
+        }
+    });
+    
     connect(interceptor, &KineticInterceptor::roundsFired,
             this, [this, id](int remaining) {
         if (m_kineticStates.contains(id)) {
@@ -153,7 +192,7 @@ void EffectorSimulator::registerDirectedEnergy(DirectedEnergySystem* de) {
             m_deStates[id].tracking = tracking;
             m_deStates[id].dwellTimeS = dwellTime;
             if (tracking && m_deStates[id].trackingStartTime == 0) {
-                m_deStates[id].trackingStartTime = QDateTime::currentMSecsSinceEpoch();
+                m_deStates[id].trackingStartTime = m_clock.nowMs();
             }
         }
     });
@@ -208,12 +247,14 @@ void EffectorSimulator::simulateRFJamEngagement(const QString& jammerId, const G
     m_stats.rfJammerEngagements++;
 }
 
-void EffectorSimulator::simulateKineticLaunch(const QString& interceptorId, const GeoPosition& target) {
+void EffectorSimulator::simulateKineticLaunch(const QString& interceptorId, const GeoPosition& target,
+                                              const VelocityVector& targetVelocity) {
     auto* interceptor = m_kineticInterceptors.value(interceptorId);
     if (!interceptor) return;
     
     if (m_kineticStates.contains(interceptorId)) {
         m_kineticStates[interceptorId].targetPosition = target;
+        m_kineticStates[interceptorId].targetVelocity = targetVelocity;
     }
     
     interceptor->engage(target);
@@ -239,23 +280,34 @@ void EffectorSimulator::simulateDEEngagement(const QString& deId, const GeoPosit
 }
 
 void EffectorSimulator::updateSimulation() {
-    updateRFJammerSimulation();
-    updateKineticSimulation();
-    updateDESimulation();
+    // Wall time since the last tick, in whole steps; the rest carries over
+    m_targetMs += m_wallTimer.restart() * m_timeScale;
+    advanceTo(static_cast<qint64>(m_targetMs));
+}
+
+void EffectorSimulator::advanceTo(qint64 untilMs) {
+    QVector<InterceptorEvent> events;
+    while (m_clock.nowMs() + STEP_MS <= untilMs) {
+        m_clock.advance(STEP_MS);
+        stepRFJammers(STEP_S);
+        stepDirectedEnergy(STEP_S);
+        
+        m_flights.advanceTo(m_clock.nowMs(), events);
+        for (const InterceptorEvent& event : events) {
+            onFlightEvent(event);
+        }
+        events.clear();
+    }
+    publishStates();
 }
 
-void EffectorSimulator::updateRFJammerSimulation() {
-    double dt = 1.0 / m_updateRateHz;
+void EffectorSimulator::stepRFJammers(double dt) {
+    Q_UNUSED(dt)
+    const qint64 now = m_clock.nowMs();
     
     for (auto it = m_rfJammerStates.begin(); it != m_rfJammerStates.end(); ++it) {
-        const QString& id = it.key();
         RFJammerSimState& state = it.value();
-        auto* jammer = m_rfJammers.value(id);
-        
-        if (!jammer || !state.active) continue;
-        
-        // Update active frequencies from jammer
-        state.activeFrequencies = jammer->activeFrequencies();
+        if (!state.active || !m_rfJammers.value(it.key())) continue;
         
         // Calculate signal effectiveness based on power and distance
         double baseEffectiveness = state.currentPowerW / 100.0;  // Normalize to max power
@@ -263,149 +315,90 @@ void EffectorSimulator::updateRFJammerSimulation() {
         // Add weather and random factors if realistic mode
         if (m_realisticMode) {
             baseEffectiveness *= m_weatherFactor;
-            baseEffectiveness *= (0.9 + QRandomGenerator::global()->generateDouble() * 0.2);
-            
-            // Random interference spike
-            if (QRandomGenerator::global()->generateDouble() < 0.1) {
-                state.targetInterferenceLevel = qMin(100, state.targetInterferenceLevel + 
-                    QRandomGenerator::global()->bounded(10, 30));
-            }
+            baseEffectiveness *= m_random.uniform(0.9, 1.1);
         }
         
         // Update interference level (ramps up over time)
-        qint64 elapsed = QDateTime::currentMSecsSinceEpoch() - state.engagementStartTime;
+        qint64 elapsed = now - state.engagementStartTime;
         double rampFactor = qMin(1.0, elapsed / 5000.0);  // 5 second ramp
         state.targetInterferenceLevel = static_cast<int>(baseEffectiveness * 100 * rampFactor);
         
         // Check if link is disrupted (>70% interference)
         state.targetLinkDisrupted = state.targetInterferenceLevel > 70;
         state.signalEffectiveness = baseEffectiveness * rampFactor;
-        
-        emit rfJammerStateChanged(id, state);
-        
-        if (state.targetLinkDisrupted) {
-            emit targetEffectSimulated(id, "", state.signalEffectiveness);
-        }
-    }
-}
-
-void EffectorSimulator::updateKineticSimulation() {
-    double dt = 1.0 / m_updateRateHz;
-    
-    for (auto it = m_kineticStates.begin(); it != m_kineticStates.end(); ++it) {
-        const QString& id = it.key();
-        KineticSimState& state = it.value();
-        
-        if (state.phase == KineticSimState::Phase::InFlight) {
-            simulateInterceptorFlight(id, dt);
-        }
     }
 }
 
-void EffectorSimulator::simulateInterceptorFlight(const QString& id, double dt) {
-    if (!m_kineticStates.contains(id)) return;
-    
+void EffectorSimulator::launchFlight(const QString& id) {
     KineticSimState& state = m_kineticStates[id];
+    auto* interceptor = m_kineticInterceptors.value(id);
     
-    // Calculate direction to target
-    double dLat = state.targetPosition.latitude - state.currentPosition.latitude;
-    double dLon = state.targetPosition.longitude - state.currentPosition.longitude;
-    double dAlt = state.targetPosition.altitude - state.currentPosition.altitude;
-    
-    double northOffset = dLat * 111000.0;
-    double eastOffset = dLon * 111000.0 * std::cos(qDegreesToRadians(state.currentPosition.latitude));
-    
-    double horizontalDist = std::sqrt(northOffset * northOffset + eastOffset * eastOffset);
-    double totalDist = std::sqrt(horizontalDist * horizontalDist + dAlt * dAlt);
-    
-    state.distanceToTarget = totalDist;
-    
-    if (totalDist < 1.0) {
-        // Arrived at target
-        checkInterceptCompletion(id);
-        return;
-    }
-    
-    // Normalize direction
-    double invDist = 1.0 / totalDist;
-    state.velocity.north = northOffset * invDist * state.speed;
-    state.velocity.east = eastOffset * invDist * state.speed;
-    state.velocity.down = -dAlt * invDist * state.speed;
-    
-    // Update position
-    double move = state.speed * dt;
-    state.currentPosition.latitude += (state.velocity.north * dt) / 111000.0;
-    state.currentPosition.longitude += (state.velocity.east * dt) / 
-        (111000.0 * std::cos(qDegreesToRadians(state.currentPosition.latitude)));
-    state.currentPosition.altitude -= state.velocity.down * dt;
-    
-    // Add some noise in realistic mode
-    if (m_realisticMode) {
-        auto* gen = QRandomGenerator::global();
-        state.currentPosition.latitude += (gen->generateDouble() - 0.5) * 0.000001;
-        state.currentPosition.longitude += (gen->generateDouble() - 0.5) * 0.000001;
-    }
-    
-    emit interceptorInFlight(id, state.currentPosition, state.distanceToTarget);
-    emit kineticStateChanged(id, state);
-    
-    // Check if close enough for terminal phase
-    if (totalDist < 50.0 && state.phase != KineticSimState::Phase::Terminal) {
-        state.phase = KineticSimState::Phase::Terminal;
-        emit kineticStateChanged(id, state);
+    InterceptorLaunch launch;
+    launch.effectorId = id;
+    launch.launcher = interceptor ? interceptor->position() : state.launcherPosition;
+    launch.target = state.targetPosition;
+    launch.targetVelocity = state.targetVelocity;
+    if (interceptor) {
+        launch.speedMps = interceptor->config().flyoutSpeedMps;
+        launch.pk = interceptor->config().interceptProbability;
+        launch.maxFlightMs = interceptor->config().flightTimeMs;
     }
     
-    // Auto-complete when very close
-    if (totalDist < 5.0) {
-        checkInterceptCompletion(id);
-    }
+    state.flightSerial = m_flights.launch(launch);
+    state.launchTime = m_clock.nowMs();
+    state.currentPosition = launch.launcher;
+    state.speed = launch.speedMps;
+    state.interceptSuccess = false;
 }
 
-void EffectorSimulator::checkInterceptCompletion(const QString& id) {
-    if (!m_kineticStates.contains(id)) return;
-    
-    KineticSimState& state = m_kineticStates[id];
-    auto* interceptor = m_kineticInterceptors.value(id);
-    
-    // Calculate intercept probability
-    double prob = 0.85;  // Base probability
+void EffectorSimulator::onFlightEvent(const InterceptorEvent& event) {
+    auto it = m_kineticStates.find(event.effectorId);
+    const bool latest = it != m_kineticStates.end() && it->flightSerial == event.serial;
+    if (latest) {
+        KineticSimState& state = it.value();
+        state.currentPosition = event.position;
+        state.distanceToTarget = event.distanceM;
+    }
     
-    if (m_realisticMode) {
-        prob *= m_weatherFactor;
-        
-        // Random failure check
-        if (QRandomGenerator::global()->generateDouble() < m_failureRate) {
-            prob *= 0.5;
+    if (event.type == InterceptorEvent::Type::Terminal) {
+        if (latest) {
+            it->phase = KineticSimState::Phase::Terminal;
+            emit kineticStateChanged(event.effectorId, it.value());
         }
+        return;
     }
     
-    state.interceptSuccess = QRandomGenerator::global()->generateDouble() < prob;
-    state.phase = KineticSimState::Phase::Complete;
+    if (latest) {
+        it->phase = KineticSimState::Phase::Complete;
+        it->interceptSuccess = event.success;
+        emit kineticStateChanged(event.effectorId, it.value());
+    }
     
     SimulatedEngagementResult result;
-    result.effectorId = id;
+    result.effectorId = event.effectorId;
     result.effectorType = "KINETIC";
-    result.targetPosition = state.targetPosition;
-    result.success = state.interceptSuccess;
-    result.effectivenessAchieved = state.interceptSuccess ? 1.0 : 0.0;
-    result.resultDetails = state.interceptSuccess ? "Target intercepted" : "Intercept missed";
-    result.timestamp = QDateTime::currentMSecsSinceEpoch();
-    
-    if (state.interceptSuccess) {
+    result.targetPosition = event.target;
+    result.success = event.success;
+    result.effectivenessAchieved = event.success ? 1.0 : 0.0;
+    result.resultDetails = event.success ? "Target intercepted"
+                         : event.timedOut ? "Interceptor out of energy" : "Intercept missed";
+    result.timestamp = event.timeMs;
+    
+    if (event.success) {
         m_stats.successfulEngagements++;
     }
     
-    emit kineticStateChanged(id, state);
     emit engagementSimulated(result);
     
     Logger::instance().info("EffectorSimulator",
         QString("Kinetic intercept %1: %2")
-            .arg(id)
-            .arg(state.interceptSuccess ? "SUCCESS" : "MISS"));
+            .arg(event.effectorId)
+            .arg(event.success ? "SUCCESS" : "MISS"));
 }
 
-void EffectorSimulator::updateDESimulation() {
-    double dt = 1.0 / m_updateRateHz;
+void EffectorSimulator::stepDirectedEnergy(double dt) {
+    Q_UNUSED(dt)
+    const qint64 now = m_clock.nowMs();
     
     for (auto it = m_deStates.begin(); it != m_deStates.end(); ++it) {
         const QString& id = it.key();
@@ -417,7 +410,7 @@ void EffectorSimulator::updateDESimulation() {
         // Calculate tracking error
         if (m_realisticMode) {
             // Simulate tracking jitter
-            state.trackingError = QRandomGenerator::global()->generateDouble() * 2.0;  // 0-2 mrad
+            state.trackingError = m_random.uniform() * 2.0;  // 0-2 mrad
             
             // Weather affects tracking
             state.trackingError *= (2.0 - m_weatherFactor);
@@ -426,18 +419,15 @@ void EffectorSimulator::updateDESimulation() {
         }
         
         // Update dwell time
-        qint64 now = QDateTime::currentMSecsSinceEpoch();
         if (state.trackingStartTime > 0) {
             state.dwellTimeS = (now - state.trackingStartTime) / 1000.0;
         }
         
-        emit deStateChanged(id, state);
-        
         // Check if effect is achieved
         if (!state.effectAchieved && state.dwellTimeS >= state.requiredDwellS) {
             double effectProb = calculateDEEffect(de, state.targetPosition, state.dwellTimeS);
             
-            if (QRandomGenerator::global()->generateDouble() < effectProb) {
+            if (m_random.uniform() < effectProb) {
                 state.effectAchieved = true;
                 
                 SimulatedEngagementResult result;
@@ -461,13 +451,43 @@ void EffectorSimulator::updateDESimulation() {
     }
 }
 
+void EffectorSimulator::publishStates() {
+    for (auto it = m_rfJammerStates.begin(); it != m_rfJammerStates.end(); ++it) {
+        RFJammerSimState& state = it.value();
+        auto* jammer = m_rfJammers.value(it.key());
+        if (!jammer || !state.active) continue;
+        
+        state.activeFrequencies = jammer->activeFrequencies();
+        emit rfJammerStateChanged(it.key(), state);
+        if (state.targetLinkDisrupted) {
+            emit targetEffectSimulated(it.key(), "", state.signalEffectiveness);
+        }
+    }
+    
+    for (auto it = m_kineticStates.begin(); it != m_kineticStates.end(); ++it) {
+        KineticSimState& state = it.value();
+        const int row = m_flights.row(state.flightSerial);
+        if (row < 0) continue;
+        
+        state.currentPosition = m_flights.position(row);
+        state.velocity = m_flights.velocity(row);
+        state.distanceToTarget = m_flights.distanceM(row);
+        emit interceptorInFlight(it.key(), state.currentPosition, state.distanceToTarget);
+        emit kineticStateChanged(it.key(), state);
+    }
+    
+    for (auto it = m_deStates.begin(); it != m_deStates.end(); ++it) {
+        if (it->active && it->tracking && m_deSystems.value(it.key())) {
+            emit deStateChanged(it.key(), it.value());
+        }
+    }
+}
+
 double EffectorSimulator::calculateRFJamEffectiveness(RFJammer* jammer, const GeoPosition& target) {
     if (!jammer) return 0.0;
     
     // Calculate distance
-    Track temp("temp");
-    temp.setPosition(jammer->position());
-    double distance = temp.distanceTo(target);
+    double distance = CoordinateUtils::haversineDistance(jammer->position(), target);
     
     // Effectiveness drops with distance squared (inverse square law)
     double maxRange = jammer->maxRange();
@@ -504,9 +524,7 @@ double EffectorSimulator::calculateDEEffect(DirectedEnergySystem* de,
     if (!de) return 0.0;
     
     // Calculate distance
-    Track temp("temp");
-    temp.setPosition(de->position());
-    double distance = temp.distanceTo(target);
+    double distance = CoordinateUtils::haversineDistance(de->position(), target);
     
     // Effectiveness drops with distance
     double maxRange = de->maxRange();
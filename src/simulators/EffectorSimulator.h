@@ -13,11 +13,14 @@
 
 #include <QObject>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QList>
-#include <QRandomGenerator>
 #include "core/Track.h"
 #include "effectors/EffectorInterface.h"
+#include "simulators/InterceptorFlights.h"
+#include "utils/Clock.h"
+#include "utils/FastRandom.h"
 
 namespace CounterUAS {
 
@@ -63,12 +66,14 @@ struct KineticSimState {
     GeoPosition launcherPosition;
     GeoPosition currentPosition;
     GeoPosition targetPosition;
+    VelocityVector targetVelocity;
     VelocityVector velocity;
     double speed = 0.0;
     double distanceToTarget = 0.0;
-    qint64 launchTime = 0;
+    qint64 launchTime = 0;          // Simulation time
     int roundsRemaining = 10;
     bool interceptSuccess = false;
+    quint64 flightSerial = 0;       // The latest round's, in InterceptorFlights
 };
 
 /**
@@ -83,11 +88,27 @@ struct DESimState {
     GeoPosition targetPosition;
     double trackingError = 0.0;
     bool effectAchieved = false;
-    qint64 trackingStartTime = 0;
+    qint64 trackingStartTime = 0;   // Simulation time
 };
 
 /**
  * @brief Comprehensive effector simulator for all effector types
+ *
+ * Runs on a virtual clock in fixed steps of STEP_MS. While started, a
+ * timer advances it by the wall time since its last tick times the time
+ * scale; advance() moves it on directly, as fast as the CPU allows, for
+ * accelerated and headless runs. Every step integrates the jammers, the
+ * directed-energy systems and, in one InterceptorFlights batch, every
+ * interceptor in flight, so an engagement covers the same steps however
+ * fast it is run. The draws come from streams of the seed: with the same
+ * seed and the same engagements at the same simulation times, outcomes
+ * and their times are identical between real-time and accelerated runs.
+ * State signals go out once per advance; engagement results as they
+ * happen, stamped with simulation time.
+ *
+ * Launch timing is the effectors' own, on their timers: a round enters
+ * the batch when its interceptor reports it in flight, and from then on
+ * the batch decides its phase and its outcome.
  */
 class EffectorSimulator : public QObject {
     Q_OBJECT
@@ -104,17 +125,38 @@ public:
     void stop();
     bool isRunning() const { return m_running; }
     
+    // Timer ticks; the steps are STEP_MS whatever the rate
     void setUpdateRate(int hz);
     int updateRate() const { return m_updateRateHz; }
     
+    // Simulation time
+    static constexpr int STEP_MS = InterceptorFlights::STEP_MS;
+    // Simulation seconds per wall second while started
+    void setTimeScale(double scale) { m_timeScale = qBound(0.1, scale, 100.0); }
+    double timeScale() const { return m_timeScale; }
+    // Runs ms of simulation time now, whether or not started
+    void advance(qint64 ms);
+    const Clock* clock() const { return &m_clock; }
+    
+    // Same seed, same draws; restarts the simulation time and drops the
+    // rounds in flight. Each start() restarts it too
+    void setSeed(quint64 seed);
+    quint64 seed() const { return m_seed; }
+    
     // Simulation parameters
-    void setRealisticMode(bool enable) { m_realisticMode = enable; }
+    void setRealisticMode(bool enable) { m_realisticMode = enable; m_flights.setRealistic(enable); }
     bool realisticMode() const { return m_realisticMode; }
     
-    void setFailureRate(double rate) { m_failureRate = qBound(0.0, rate, 1.0); }
+    void setFailureRate(double rate) {
+        m_failureRate = qBound(0.0, rate, 1.0);
+        m_flights.setFailureRate(m_failureRate);
+    }
     double failureRate() const { return m_failureRate; }
     
-    void setWeatherFactor(double factor) { m_weatherFactor = qBound(0.0, factor, 1.0); }
+    void setWeatherFactor(double factor) {
+        m_weatherFactor = qBound(0.0, factor, 1.0);
+        m_flights.setWeatherFactor(m_weatherFactor);
+    }
     double weatherFactor() const { return m_weatherFactor; }
     
     // Effector registration (auto-creates simulation state)
@@ -132,7 +174,9 @@ public:
     
     // Manual engagement control (for testing)
     void simulateRFJamEngagement(const QString& jammerId, const GeoPosition& target);
-    void simulateKineticLaunch(const QString& interceptorId, const GeoPosition& target);
+    // A target velocity is flown on while the round is in the air
+    void simulateKineticLaunch(const QString& interceptorId, const GeoPosition& target,
+                               const VelocityVector& targetVelocity = VelocityVector());
     void simulateDEEngagement(const QString& deId, const GeoPosition& target);
     
     // Statistics
@@ -165,9 +209,17 @@ private slots:
     void onDEPowerChanged(double kw);
     
 private:
-    void updateRFJammerSimulation();
-    void updateKineticSimulation();
-    void updateDESimulation();
+    static constexpr double STEP_S = STEP_MS / 1000.0;
+    static constexpr quint64 EFFECT_STREAM = 0;    // Jammer and DE draws; flights have their own
+    
+    void restartClock(qint64 startMs);
+    void advanceTo(qint64 untilMs);
+    void stepRFJammers(double dt);
+    void stepDirectedEnergy(double dt);
+    void launchFlight(const QString& id);
+    void onFlightEvent(const InterceptorEvent& event);
+    // The state signals, once per advance
+    void publishStates();
     
     double calculateRFJamEffectiveness(RFJammer* jammer, const GeoPosition& target);
     double calculateInterceptProbability(KineticInterceptor* interceptor, 
@@ -177,15 +229,21 @@ private:
                             const GeoPosition& target,
                             double dwellTime);
     
-    void simulateInterceptorFlight(const QString& id, double dt);
-    void checkInterceptCompletion(const QString& id);
-    
     EngagementManager* m_engagementManager = nullptr;
     
     QTimer* m_updateTimer;
     int m_updateRateHz = 20;
     bool m_running = false;
     
+    // Simulation time
+    VirtualClock m_clock;
+    double m_timeScale = 1.0;
+    double m_targetMs = 0.0;       // Where the clock is being advanced to; steps trail it
+    QElapsedTimer m_wallTimer;     // Since the last tick
+    quint64 m_seed;
+    FastRandom m_random;           // EFFECT_STREAM of m_seed
+    InterceptorFlights m_flights;
+    
     // Simulation parameters
     bool m_realisticMode = true;
     double m_failureRate = 0.05;  // 5% random failure rate
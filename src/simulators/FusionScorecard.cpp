@@ -0,0 +1,205 @@
+#include "simulators/FusionScorecard.h"
+#include "utils/AssignmentSolver.h"
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+qint64 cellKey(qint64 x, qint64 y) {
+    return static_cast<qint64>((quint64(x) << 32) ^ quint64(quint32(y)));
+}
+
+} // namespace
+
+QJsonObject ScorecardReport::toJson() const {
+    QJsonObject obj;
+    obj["samples"] = samples;
+    obj["cutoffM"] = cutoffM;
+    obj["order"] = order;
+    obj["meanOspaM"] = meanOspaM;
+    obj["maxOspaM"] = maxOspaM;
+    obj["meanGospaM"] = meanGospaM;
+    obj["maxGospaM"] = maxGospaM;
+    obj["meanErrorM"] = meanErrorM;
+    obj["meanMissed"] = meanMissed;
+    obj["meanFalse"] = meanFalse;
+    obj["targets"] = targets;
+    obj["idSwitches"] = idSwitches;
+    obj["fragmentations"] = fragmentations;
+    obj["confirmedTargets"] = confirmedTargets;
+    obj["meanTimeToConfirmMs"] = meanTimeToConfirmMs;
+    obj["p50TimeToConfirmMs"] = p50TimeToConfirmMs;
+    obj["p90TimeToConfirmMs"] = p90TimeToConfirmMs;
+    obj["maxTimeToConfirmMs"] = maxTimeToConfirmMs;
+    return obj;
+}
+
+QString ScorecardReport::toText() const {
+    QString text;
+    QTextStream out(&text);
+    out << "quality     " << samples << " samples, c " << cutoffM << " m, p " << order << "\n"
+        << "  ospa      mean " << QString::number(meanOspaM, 'f', 2) << " m, max "
+        << QString::number(maxOspaM, 'f', 2) << " m\n"
+        << "  gospa     mean " << QString::number(meanGospaM, 'f', 2) << " m, max "
+        << QString::number(maxGospaM, 'f', 2) << " m; per sample "
+        << QString::number(meanMissed, 'f', 1) << " missed, "
+        << QString::number(meanFalse, 'f', 1) << " false, error "
+        << QString::number(meanErrorM, 'f', 2) << " m\n"
+        << "  identity  " << targets << " targets, " << idSwitches << " id switches, "
+        << fragmentations << " fragmentations\n"
+        << "  confirm   " << confirmedTargets << " confirmed, mean "
+        << QString::number(meanTimeToConfirmMs, 'f', 0) << " ms, p50 " << p50TimeToConfirmMs
+        << " ms, p90 " << p90TimeToConfirmMs << " ms, max " << maxTimeToConfirmMs << " ms\n";
+    return text;
+}
+
+FusionScorecard::FusionScorecard(const GeoPosition& origin, const ScorecardConfig& config)
+    : m_plane(origin)
+    , m_config(config)
+{
+    m_config.cutoffM = qMax(1e-3, m_config.cutoffM);
+    m_config.order = qMax(1.0, m_config.order);
+    m_cutoffP = std::pow(m_config.cutoffM, m_config.order);
+}
+
+void FusionScorecard::score(qint64 timeMs, const QVector<ScorecardTruth>& truth,
+                            const QVector<ScorecardTrack>& tracks) {
+    ++m_sample;
+    const double c = m_config.cutoffM;
+    const double p = m_config.order;
+
+    // Tracks bucketed on a ground grid of the cutoff, so a target only
+    // looks at the nine cells around it
+    m_trackEnu.resize(tracks.size());
+    for (QVector<int>& cell : m_grid) {
+        cell.clear();
+    }
+    for (int j = 0; j < tracks.size(); ++j) {
+        m_trackEnu[j] = m_plane.toEnuLinear(tracks[j].position);
+        m_grid[cellKey(qint64(std::floor(m_trackEnu[j].east / c)),
+                       qint64(std::floor(m_trackEnu[j].north / c)))].append(j);
+    }
+
+    m_truthEnu.resize(truth.size());
+    QVector<QVector<QPair<int, double>>> gated(truth.size());
+    for (int i = 0; i < truth.size(); ++i) {
+        const EnuVector& at = m_truthEnu[i] = m_plane.toEnuLinear(truth[i].position);
+        const qint64 cx = qint64(std::floor(at.east / c));
+        const qint64 cy = qint64(std::floor(at.north / c));
+        for (qint64 dx = -1; dx <= 1; ++dx) {
+            for (qint64 dy = -1; dy <= 1; ++dy) {
+                auto cell = m_grid.constFind(cellKey(cx + dx, cy + dy));
+                if (cell == m_grid.constEnd()) continue;
+                for (int j : *cell) {
+                    const double d = EnuVector::distance(at, m_trackEnu[j]);
+                    if (d < c) gated[i].append(qMakePair(j, std::pow(d, p)));
+                }
+            }
+        }
+    }
+    const QVector<int> assignment = AssignmentSolver::solveClustered(gated, tracks.size());
+
+    int assigned = 0;
+    double costSum = 0.0;
+    for (int i = 0; i < truth.size(); ++i) {
+        const int j = assignment[i];
+        History& history = m_histories[truth[i].serial];
+        if (history.lastSample == 0) {
+            history.firstSeenMs = timeMs;
+            ++m_targets;
+        }
+        history.lastSample = m_sample;
+
+        if (j < 0) {
+            history.tracked = false;
+            continue;
+        }
+        const double d = EnuVector::distance(m_truthEnu[i], m_trackEnu[j]);
+        ++assigned;
+        costSum += std::pow(d, p);
+        m_errorSum += d;
+
+        const ScorecardTrack& track = tracks[j];
+        if (!history.trackId.isEmpty()) {
+            if (track.trackId != history.trackId) ++m_idSwitches;
+            if (!history.tracked) ++m_fragmentations;
+        }
+        history.trackId = track.trackId;
+        history.tracked = true;
+        if (track.confirmed && !history.confirmed) {
+            history.confirmed = true;
+            m_timeToConfirmMs.append(timeMs - history.firstSeenMs);
+        }
+    }
+
+    // Targets no longer in the truth are done with
+    for (auto it = m_histories.begin(); it != m_histories.end();) {
+        if (it->lastSample != m_sample) {
+            it = m_histories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    const int m = truth.size();
+    const int n = tracks.size();
+    const int larger = qMax(m, n);
+    m_lastOspa = larger == 0 ? 0.0
+               : std::pow((costSum + m_cutoffP * (larger - assigned)) / larger, 1.0 / p);
+    m_lastGospa = std::pow(costSum + 0.5 * m_cutoffP * ((m - assigned) + (n - assigned)), 1.0 / p);
+
+    m_ospaSum += m_lastOspa;
+    m_ospaMax = qMax(m_ospaMax, m_lastOspa);
+    m_gospaSum += m_lastGospa;
+    m_gospaMax = qMax(m_gospaMax, m_lastGospa);
+    m_pairs += assigned;
+    m_missed += m - assigned;
+    m_false += n - assigned;
+}
+
+ScorecardReport FusionScorecard::report() const {
+    ScorecardReport report;
+    report.samples = static_cast<int>(m_sample);
+    report.cutoffM = m_config.cutoffM;
+    report.order = m_config.order;
+    report.targets = m_targets;
+    report.idSwitches = m_idSwitches;
+    report.fragmentations = m_fragmentations;
+    report.confirmedTargets = m_timeToConfirmMs.size();
+    report.maxOspaM = m_ospaMax;
+    report.maxGospaM = m_gospaMax;
+    if (m_sample > 0) {
+        report.meanOspaM = m_ospaSum / m_sample;
+        report.meanGospaM = m_gospaSum / m_sample;
+        report.meanMissed = double(m_missed) / m_sample;
+        report.meanFalse = double(m_false) / m_sample;
+    }
+    if (m_pairs > 0) {
+        report.meanErrorM = m_errorSum / m_pairs;
+    }
+
+    if (!m_timeToConfirmMs.isEmpty()) {
+        QVector<qint64> sorted = m_timeToConfirmMs;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (qint64 ms : sorted) {
+            sum += ms;
+        }
+        // Nearest rank
+        auto rank = [&sorted](double fraction) {
+            const int index = qBound(0, static_cast<int>(std::ceil(fraction * sorted.size())) - 1,
+                                     sorted.size() - 1);
+            return sorted[index];
+        };
+        report.meanTimeToConfirmMs = sum / sorted.size();
+        report.p50TimeToConfirmMs = rank(0.50);
+        report.p90TimeToConfirmMs = rank(0.90);
+        report.maxTimeToConfirmMs = sorted.last();
+    }
+    return report;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,132 @@
+#ifndef FUSIONSCORECARD_H
+#define FUSIONSCORECARD_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief How the scorecard weighs position error against a miss
+ */
+struct ScorecardConfig {
+    double cutoffM = 100.0;         // c: a track further than this from a target is no track of it
+    double order = 2.0;             // p
+};
+
+/**
+ * @brief One target as the simulator has it at the scoring time
+ */
+struct ScorecardTruth {
+    quint64 serial = 0;             // Stable for the target's life
+    GeoPosition position;
+};
+
+/**
+ * @brief One track estimate at the scoring time
+ */
+struct ScorecardTrack {
+    QString trackId;
+    GeoPosition position;           // Predicted to the truth's time
+    bool confirmed = false;         // Past initiation
+};
+
+/**
+ * @brief Tracking quality over a run, against simulator truth
+ */
+struct ScorecardReport {
+    int samples = 0;
+    double cutoffM = 0.0;
+    double order = 0.0;
+    double meanOspaM = 0.0;
+    double maxOspaM = 0.0;
+    double meanGospaM = 0.0;
+    double maxGospaM = 0.0;
+    double meanErrorM = 0.0;        // Of the targets a track was assigned to
+    double meanMissed = 0.0;        // Targets without a track, per sample
+    double meanFalse = 0.0;         // Tracks without a target, per sample
+    int targets = 0;                // Seen in any sample
+    int idSwitches = 0;             // A target's track replaced by another
+    int fragmentations = 0;         // A target tracked again after losing its track
+    int confirmedTargets = 0;       // Held by a confirmed track at some sample
+    double meanTimeToConfirmMs = 0.0;
+    qint64 p50TimeToConfirmMs = 0;
+    qint64 p90TimeToConfirmMs = 0;
+    qint64 maxTimeToConfirmMs = 0;
+
+    QJsonObject toJson() const;
+    QString toText() const;
+};
+
+/**
+ * @brief Scores tracker output against simulator truth, one sample at a time
+ *
+ * Each sample assigns tracks to targets optimally, with the assignment
+ * gated at the cutoff: target-track pairs closer than c are candidates and
+ * the assignment solver takes the cheapest set of them, summing d^p. From
+ * that one assignment come the sample's OSPA (the per-object mean, with
+ * the cardinality mismatch charged c each) and GOSPA (alpha 2, so a missed
+ * target or a false track costs c^p / 2 and stays out of the mean).
+ *
+ * Targets are followed across samples by serial. A target whose assigned
+ * track changes to another track is an ID switch; one that loses every
+ * track and later gets one back is a fragmentation. Time to confirm is from
+ * the first sample a target appears in to the first in which a confirmed
+ * track is assigned to it, so its resolution is the sampling interval.
+ * Targets are forgotten once they leave the truth.
+ */
+class FusionScorecard {
+public:
+    explicit FusionScorecard(const GeoPosition& origin, const ScorecardConfig& config = ScorecardConfig());
+
+    void score(qint64 timeMs, const QVector<ScorecardTruth>& truth, const QVector<ScorecardTrack>& tracks);
+
+    // Of the last sample
+    double lastOspaM() const { return m_lastOspa; }
+    double lastGospaM() const { return m_lastGospa; }
+
+    ScorecardReport report() const;
+
+private:
+    struct History {
+        qint64 firstSeenMs = 0;
+        bool confirmed = false;
+        bool tracked = false;       // At the last sample it was in
+        QString trackId;            // Last assigned, empty before the first
+        quint64 lastSample = 0;
+    };
+
+    LocalTangentPlane m_plane;
+    ScorecardConfig m_config;
+    double m_cutoffP;               // c^p
+
+    QHash<quint64, History> m_histories;
+    quint64 m_sample = 0;
+    double m_ospaSum = 0.0;
+    double m_ospaMax = 0.0;
+    double m_gospaSum = 0.0;
+    double m_gospaMax = 0.0;
+    double m_errorSum = 0.0;
+    qint64 m_pairs = 0;
+    qint64 m_missed = 0;
+    qint64 m_false = 0;
+    int m_targets = 0;
+    int m_idSwitches = 0;
+    int m_fragmentations = 0;
+    QVector<qint64> m_timeToConfirmMs;
+    double m_lastOspa = 0.0;
+    double m_lastGospa = 0.0;
+
+    // score()'s scratch
+    QVector<EnuVector> m_truthEnu;
+    QVector<EnuVector> m_trackEnu;
+    QHash<qint64, QVector<int>> m_grid;
+};
+
+} // namespace CounterUAS
+
+#endif // FUSIONSCORECARD_H
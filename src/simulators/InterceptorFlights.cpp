@@ -0,0 +1,239 @@
+#include "simulators/InterceptorFlights.h"
+#include "utils/CoordinateUtils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+InterceptorFlights::InterceptorFlights(quint64 seed, qint64 startMs) {
+    reset(seed, startMs);
+}
+
+void InterceptorFlights::reset(quint64 seed, qint64 startMs) {
+    m_seed = seed;
+    m_timeMs = startMs;
+    m_steps = 0;
+    m_nextSerial = 1;
+    m_done.fill(1, size());
+    compact();
+}
+
+quint64 InterceptorFlights::launch(const InterceptorLaunch& launch) {
+    if (isEmpty()) {
+        // Nothing to re-express; the frame follows the launchers
+        m_origin = launch.launcher;
+        m_metresPerDegLon = CoordinateUtils::degToMeterLon(m_origin.latitude);
+    }
+    const quint64 serial = m_nextSerial++;
+
+    m_serial.append(serial);
+    m_effectorId.append(launch.effectorId);
+    m_north.append((launch.launcher.latitude - m_origin.latitude) * CoordinateUtils::DEG_TO_M_LAT);
+    m_east.append((launch.launcher.longitude - m_origin.longitude) * m_metresPerDegLon);
+    m_altitude.append(launch.launcher.altitude);
+    m_velNorth.append(0.0);
+    m_velEast.append(0.0);
+    m_velDown.append(0.0);
+    m_targetNorth.append((launch.target.latitude - m_origin.latitude) * CoordinateUtils::DEG_TO_M_LAT);
+    m_targetEast.append((launch.target.longitude - m_origin.longitude) * m_metresPerDegLon);
+    m_targetAltitude.append(launch.target.altitude);
+    m_targetVelNorth.append(launch.targetVelocity.north);
+    m_targetVelEast.append(launch.targetVelocity.east);
+    m_targetVelDown.append(launch.targetVelocity.down);
+    m_speed.append(qMax(1.0, launch.speedMps));
+    m_pk.append(qBound(0.0, launch.pk, 1.0));
+    const double dn = m_targetNorth.last() - m_north.last();
+    const double de = m_targetEast.last() - m_east.last();
+    const double du = m_targetAltitude.last() - m_altitude.last();
+    m_distance.append(std::sqrt(dn * dn + de * de + du * du));
+    m_deadlineMs.append(m_timeMs + qMax(STEP_MS, launch.maxFlightMs));
+    m_terminal.append(0);
+    m_random.append(FastRandom(m_seed, FLIGHT_STREAM_BASE + serial));
+    return serial;
+}
+
+void InterceptorFlights::advanceTo(qint64 untilMs, QVector<InterceptorEvent>& events) {
+    while (m_timeMs + STEP_MS <= untilMs) {
+        m_timeMs += STEP_MS;
+        ++m_steps;
+        if (!isEmpty()) step(events);
+    }
+}
+
+void InterceptorFlights::step(QVector<InterceptorEvent>& events) {
+    const double dt = STEP_MS / 1000.0;
+    const int count = size();
+    m_done.fill(0, count);
+
+    // Targets on, then every interceptor straight at where its target now is
+    double* targetNorth = m_targetNorth.data();
+    double* targetEast = m_targetEast.data();
+    double* targetAltitude = m_targetAltitude.data();
+    const double* targetVelNorth = m_targetVelNorth.constData();
+    const double* targetVelEast = m_targetVelEast.constData();
+    const double* targetVelDown = m_targetVelDown.constData();
+    for (int i = 0; i < count; ++i) {
+        targetNorth[i] += targetVelNorth[i] * dt;
+        targetEast[i] += targetVelEast[i] * dt;
+        targetAltitude[i] -= targetVelDown[i] * dt;
+    }
+
+    double* north = m_north.data();
+    double* east = m_east.data();
+    double* altitude = m_altitude.data();
+    double* velNorth = m_velNorth.data();
+    double* velEast = m_velEast.data();
+    double* velDown = m_velDown.data();
+    double* distance = m_distance.data();
+    const double* speed = m_speed.constData();
+    const qint64* deadline = m_deadlineMs.constData();
+    quint8* done = m_done.data();
+    for (int i = 0; i < count; ++i) {
+        const double dn = targetNorth[i] - north[i];
+        const double de = targetEast[i] - east[i];
+        const double du = targetAltitude[i] - altitude[i];
+        const double range = std::sqrt(dn * dn + de * de + du * du);
+        const double move = speed[i] * dt;
+        if (range <= move + KILL_RADIUS_M) {
+            north[i] = targetNorth[i];
+            east[i] = targetEast[i];
+            altitude[i] = targetAltitude[i];
+            distance[i] = 0.0;
+            done[i] = 1;
+            continue;
+        }
+        const double perMetre = speed[i] / range;
+        velNorth[i] = dn * perMetre;
+        velEast[i] = de * perMetre;
+        velDown[i] = -du * perMetre;
+        north[i] += velNorth[i] * dt;
+        east[i] += velEast[i] * dt;
+        altitude[i] -= velDown[i] * dt;
+        distance[i] = range - move;
+        done[i] = m_timeMs >= deadline[i] ? 2 : 0;
+    }
+
+    // Each flight's own draws, in row order
+    for (int i = 0; i < count; ++i) {
+        FastRandom& random = m_random[i];
+        if (m_realistic && !done[i]) {
+            north[i] += random.uniform(-NOISE_M, NOISE_M);
+            east[i] += random.uniform(-NOISE_M, NOISE_M);
+        }
+
+        if (!m_terminal[i] && (done[i] == 1 || distance[i] < TERMINAL_RANGE_M)) {
+            m_terminal[i] = 1;
+            events.append(event(InterceptorEvent::Type::Terminal, i));
+        }
+        if (!done[i]) continue;
+
+        double probability = m_pk[i];
+        if (m_realistic) {
+            probability *= m_weatherFactor;
+            if (random.uniform() < m_failureRate) probability *= 0.5;
+        }
+        InterceptorEvent complete = event(InterceptorEvent::Type::Complete, i);
+        complete.timedOut = done[i] == 2;
+        complete.success = !complete.timedOut && random.uniform() < probability;
+        events.append(complete);
+    }
+    compact();
+}
+
+void InterceptorFlights::compact() {
+    const int count = size();
+    int out = 0;
+    for (int i = 0; i < count; ++i) {
+        if (m_done.value(i)) continue;
+        if (out != i) {
+            m_serial[out] = m_serial[i];
+            m_effectorId[out] = std::move(m_effectorId[i]);
+            m_north[out] = m_north[i];
+            m_east[out] = m_east[i];
+            m_altitude[out] = m_altitude[i];
+            m_velNorth[out] = m_velNorth[i];
+            m_velEast[out] = m_velEast[i];
+            m_velDown[out] = m_velDown[i];
+            m_targetNorth[out] = m_targetNorth[i];
+            m_targetEast[out] = m_targetEast[i];
+            m_targetAltitude[out] = m_targetAltitude[i];
+            m_targetVelNorth[out] = m_targetVelNorth[i];
+            m_targetVelEast[out] = m_targetVelEast[i];
+            m_targetVelDown[out] = m_targetVelDown[i];
+            m_speed[out] = m_speed[i];
+            m_pk[out] = m_pk[i];
+            m_distance[out] = m_distance[i];
+            m_deadlineMs[out] = m_deadlineMs[i];
+            m_terminal[out] = m_terminal[i];
+            m_random[out] = m_random[i];
+        }
+        ++out;
+    }
+    m_done.clear();
+    if (out == count) return;
+
+    m_serial.resize(out);
+    m_effectorId.resize(out);
+    m_north.resize(out);
+    m_east.resize(out);
+    m_altitude.resize(out);
+    m_velNorth.resize(out);
+    m_velEast.resize(out);
+    m_velDown.resize(out);
+    m_targetNorth.resize(out);
+    m_targetEast.resize(out);
+    m_targetAltitude.resize(out);
+    m_targetVelNorth.resize(out);
+    m_targetVelEast.resize(out);
+    m_targetVelDown.resize(out);
+    m_speed.resize(out);
+    m_pk.resize(out);
+    m_distance.resize(out);
+    m_deadlineMs.resize(out);
+    m_terminal.resize(out);
+    m_random.resize(out);
+}
+
+int InterceptorFlights::row(quint64 serial) const {
+    // Rows stay in launch order, so serials are ascending
+    const auto it = std::lower_bound(m_serial.constBegin(), m_serial.constEnd(), serial);
+    return it != m_serial.constEnd() && *it == serial ? static_cast<int>(it - m_serial.constBegin()) : -1;
+}
+
+GeoPosition InterceptorFlights::position(int row) const {
+    return toGeo(m_north[row], m_east[row], m_altitude[row]);
+}
+
+GeoPosition InterceptorFlights::target(int row) const {
+    return toGeo(m_targetNorth[row], m_targetEast[row], m_targetAltitude[row]);
+}
+
+VelocityVector InterceptorFlights::velocity(int row) const {
+    VelocityVector vel;
+    vel.north = m_velNorth[row];
+    vel.east = m_velEast[row];
+    vel.down = m_velDown[row];
+    return vel;
+}
+
+GeoPosition InterceptorFlights::toGeo(double north, double east, double altitude) const {
+    GeoPosition pos;
+    pos.latitude = m_origin.latitude + north / CoordinateUtils::DEG_TO_M_LAT;
+    pos.longitude = m_origin.longitude + east / m_metresPerDegLon;
+    pos.altitude = altitude;
+    return pos;
+}
+
+InterceptorEvent InterceptorFlights::event(InterceptorEvent::Type type, int row) const {
+    InterceptorEvent event;
+    event.type = type;
+    event.serial = m_serial[row];
+    event.effectorId = m_effectorId[row];
+    event.timeMs = m_timeMs;
+    event.position = position(row);
+    event.target = target(row);
+    event.distanceM = m_distance[row];
+    return event;
+}
+
+} // namespace CounterUAS
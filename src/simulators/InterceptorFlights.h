@@ -0,0 +1,144 @@
+#ifndef INTERCEPTORFLIGHTS_H
+#define INTERCEPTORFLIGHTS_H
+
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+#include "utils/FastRandom.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief One interceptor sent off by InterceptorFlights::launch()
+ */
+struct InterceptorLaunch {
+    QString effectorId;
+    GeoPosition launcher;
+    GeoPosition target;
+    VelocityVector targetVelocity;      // Flown on in a straight line
+    double speedMps = 100.0;
+    double pk = 0.85;                   // On reaching the target, before weather and failures
+    int maxFlightMs = 10000;            // Out of energy after this; a miss
+};
+
+/**
+ * @brief Something that happened to a flight during a step
+ */
+struct InterceptorEvent {
+    enum class Type : quint8 { Terminal, Complete };
+
+    Type type = Type::Complete;
+    quint64 serial = 0;
+    QString effectorId;
+    qint64 timeMs = 0;                  // Virtual time of the step
+    GeoPosition position;
+    GeoPosition target;
+    double distanceM = 0.0;
+    bool success = false;               // Complete
+    bool timedOut = false;              // Complete without reaching the target
+};
+
+/**
+ * @brief Structure-of-arrays interceptor fly-out on a fixed step
+ *
+ * Every interceptor in flight is a row, in metres north and east of the
+ * first launcher (the flat earth TargetSwarm uses), and each step of
+ * STEP_MS moves every target on its velocity and every interceptor
+ * straight at its target in one pass over the columns. An interceptor
+ * within KILL_RADIUS_M, or past its maximum flight time, completes on
+ * that step.
+ *
+ * Time is virtual and moves only in whole steps through advanceTo(), so
+ * a flight covers the same steps whether the caller advances it 50 ms at
+ * a time in real time or minutes at once in an accelerated run. Each
+ * launch draws its noise and its outcome from a stream of its own, made
+ * from the seed and the launch's serial: the same launches at the same
+ * virtual times give the same events, times and outcomes however the
+ * advances are cut and whatever else is in flight. Not thread-safe; it
+ * holds no Qt objects, so any one thread may own it.
+ */
+class InterceptorFlights {
+public:
+    static constexpr int STEP_MS = 10;
+    static constexpr double TERMINAL_RANGE_M = 50.0;
+    static constexpr double KILL_RADIUS_M = 5.0;
+    static constexpr double NOISE_M = 0.05;             // Horizontal, per step, when realistic
+
+    explicit InterceptorFlights(quint64 seed = 1, qint64 startMs = 0);
+
+    // Drops every flight and starts again at startMs
+    void reset(quint64 seed, qint64 startMs);
+    quint64 seed() const { return m_seed; }
+
+    void setRealistic(bool realistic) { m_realistic = realistic; }
+    void setWeatherFactor(double factor) { m_weatherFactor = qBound(0.0, factor, 1.0); }
+    void setFailureRate(double rate) { m_failureRate = qBound(0.0, rate, 1.0); }
+
+    // In flight from timeMs(); returns its serial
+    quint64 launch(const InterceptorLaunch& launch);
+
+    // Whole steps while the next ends by untilMs; events are appended in
+    // the order they happened
+    void advanceTo(qint64 untilMs, QVector<InterceptorEvent>& events);
+    qint64 timeMs() const { return m_timeMs; }
+    quint64 stepCount() const { return m_steps; }
+
+    int size() const { return m_serial.size(); }
+    bool isEmpty() const { return m_serial.isEmpty(); }
+
+    // Row access, as the last step left it; rows move as flights complete
+    int row(quint64 serial) const;
+    quint64 serial(int row) const { return m_serial[row]; }
+    QString effectorId(int row) const { return m_effectorId[row]; }
+    GeoPosition position(int row) const;
+    GeoPosition target(int row) const;
+    VelocityVector velocity(int row) const;
+    double distanceM(int row) const { return m_distance[row]; }
+    bool isTerminal(int row) const { return m_terminal[row] != 0; }
+
+private:
+    // Above the streams the effector simulator draws from itself
+    static constexpr quint64 FLIGHT_STREAM_BASE = quint64(1) << 32;
+
+    void step(QVector<InterceptorEvent>& events);
+    void compact();
+    GeoPosition toGeo(double north, double east, double altitude) const;
+    InterceptorEvent event(InterceptorEvent::Type type, int row) const;
+
+    quint64 m_seed = 1;
+    qint64 m_timeMs = 0;
+    quint64 m_steps = 0;
+    quint64 m_nextSerial = 1;
+    bool m_realistic = true;
+    double m_weatherFactor = 1.0;
+    double m_failureRate = 0.0;
+
+    GeoPosition m_origin;
+    double m_metresPerDegLon = 0.0;
+
+    QVector<quint64> m_serial;
+    QVector<QString> m_effectorId;
+    QVector<double> m_north;            // Metres from the origin
+    QVector<double> m_east;
+    QVector<double> m_altitude;
+    QVector<double> m_velNorth;
+    QVector<double> m_velEast;
+    QVector<double> m_velDown;
+    QVector<double> m_targetNorth;
+    QVector<double> m_targetEast;
+    QVector<double> m_targetAltitude;
+    QVector<double> m_targetVelNorth;
+    QVector<double> m_targetVelEast;
+    QVector<double> m_targetVelDown;
+    QVector<double> m_speed;
+    QVector<double> m_pk;
+    QVector<double> m_distance;
+    QVector<qint64> m_deadlineMs;
+    QVector<quint8> m_terminal;
+    QVector<FastRandom> m_random;       // One stream per launch
+    QVector<quint8> m_done;             // step() scratch: 1 arrived, 2 timed out
+};
+
+} // namespace CounterUAS
+
+#endif // INTERCEPTORFLIGHTS_H
@@ -0,0 +1,474 @@
+#include "simulators/LoadHarness.h"
+#include "simulators/TrackSimulator.h"
+#include "core/EngagementManager.h"
+#include "core/ThreatAssessor.h"
+#include "core/TrackManager.h"
+#include "effectors/KineticInterceptor.h"
+#include "effectors/RFJammer.h"
+#include "utils/Clock.h"
+#include "utils/FastRandom.h"
+#include "utils/TimeUtils.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+#if defined(Q_OS_WIN)
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+// Any fixed epoch will do; results must not depend on the day they ran
+constexpr qint64 START_MS = 1700000000000LL;
+
+// Ready at once; initialize() would wait on a wall-clock timer
+template<typename Effector>
+class ReadyEffector : public Effector {
+public:
+    using Effector::Effector;
+    void initialize() override { this->setStatus(EffectorStatus::Ready); }
+};
+
+qint64 elapsedUs(qint64 startNs) {
+    return (TimeUtils::monotonicNs() - startNs) / 1000;
+}
+
+#if defined(Q_OS_LINUX)
+// VmRSS or VmHWM from /proc/self/status, in bytes
+qint64 procStatusBytes(const char* field) {
+    QFile file("/proc/self/status");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return 0;
+    const QByteArray prefix = QByteArray(field) + ':';
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (line.startsWith(prefix)) {
+            return line.mid(prefix.size()).trimmed().split(' ').value(0).toLongLong() * 1024;
+        }
+    }
+    return 0;
+}
+#endif
+
+} // namespace
+
+QJsonObject LoadScenario::toJson() const {
+    QJsonObject obj;
+    obj["name"] = name;
+    obj["basePosition"] = basePosition.toJson();
+    obj["durationSec"] = durationSec;
+    obj["maxTargets"] = maxTargets;
+    obj["initialTargets"] = initialTargets;
+    obj["threatSpawnRate"] = threatSpawnRate;
+    obj["scanRateHz"] = scanRateHz;
+    obj["detectionProbability"] = detectionProbability;
+    obj["clutterPerScan"] = clutterPerScan;
+    obj["seed"] = static_cast<qint64>(seed);
+    if (!raidScript.isEmpty()) obj["raidScript"] = raidScript;
+    obj["scorecard"] = scorecard;
+    obj["scoreIntervalMs"] = scoreIntervalMs;
+    obj["scoreCutoffM"] = scoreCutoffM;
+    return obj;
+}
+
+LoadScenario LoadScenario::fromJson(const QJsonObject& obj) {
+    LoadScenario s;
+    s.name = obj["name"].toString(s.name);
+    if (obj.contains("basePosition")) {
+        s.basePosition = GeoPosition::fromJson(obj["basePosition"].toObject());
+    }
+    // A SimulationScenario file gives its length in minutes
+    s.durationSec = obj.contains("durationSec") ? obj["durationSec"].toInt(s.durationSec)
+                                                : obj["durationMinutes"].toInt(s.durationSec / 60) * 60;
+    s.maxTargets = obj["maxTargets"].toInt(s.maxTargets);
+    s.initialTargets = obj["initialTargets"].toInt(s.initialTargets);
+    s.threatSpawnRate = obj["threatSpawnRate"].toDouble(s.threatSpawnRate);
+    s.scanRateHz = qMax(1, obj["scanRateHz"].toInt(s.scanRateHz));
+    s.detectionProbability = qBound(0.0, obj["detectionProbability"].toDouble(s.detectionProbability), 1.0);
+    s.clutterPerScan = qMax(0, obj["clutterPerScan"].toInt(s.clutterPerScan));
+    if (obj.contains("seed")) {
+        s.seed = static_cast<quint32>(obj["seed"].toDouble());
+    }
+    s.raidScript = obj["raidScript"].toString();
+    s.scorecard = obj["scorecard"].toBool(s.scorecard);
+    s.scoreIntervalMs = qMax(1, obj["scoreIntervalMs"].toInt(s.scoreIntervalMs));
+    s.scoreCutoffM = qMax(1.0, obj["scoreCutoffM"].toDouble(s.scoreCutoffM));
+    return s;
+}
+
+StageLatency StageLatency::fromSamples(const QString& stage, QVector<qint64> samplesUs) {
+    StageLatency result;
+    result.stage = stage;
+    result.count = samplesUs.size();
+    if (samplesUs.isEmpty()) return result;
+
+    std::sort(samplesUs.begin(), samplesUs.end());
+    double sum = 0.0;
+    for (qint64 us : samplesUs) {
+        sum += us;
+    }
+    // Nearest rank
+    auto rank = [&samplesUs](double fraction) {
+        const int index = qBound(0, static_cast<int>(std::ceil(fraction * samplesUs.size())) - 1,
+                                 samplesUs.size() - 1);
+        return samplesUs[index];
+    };
+    result.meanUs = sum / samplesUs.size();
+    result.p50Us = rank(0.50);
+    result.p90Us = rank(0.90);
+    result.p99Us = rank(0.99);
+    result.maxUs = samplesUs.last();
+    return result;
+}
+
+QJsonObject LoadReport::toJson() const {
+    QJsonObject obj;
+    obj["scenario"] = scenario;
+    obj["simulatedMs"] = simulatedMs;
+    obj["wallMs"] = wallMs;
+    obj["speedup"] = speedup();
+    obj["scans"] = scans;
+    obj["detections"] = detections;
+    obj["detectionsPerSec"] = detectionsPerWallSec();
+    obj["trackCycles"] = trackCycles;
+    obj["assessmentCycles"] = assessmentCycles;
+    obj["engagementCycles"] = engagementCycles;
+    obj["tracksCreated"] = tracksCreated;
+    obj["peakTracks"] = peakTracks;
+    obj["finalTracks"] = finalTracks;
+    obj["alerts"] = alerts;
+    obj["peakResidentBytes"] = peakResidentBytes;
+    obj["startResidentBytes"] = startResidentBytes;
+    obj["endResidentBytes"] = endResidentBytes;
+    obj["trackCycleCpuUs"] = trackCycleCpuUs;
+    obj["cpuUsPerTrack"] = cpuUsPerTrack();
+    if (scored) obj["scorecard"] = scorecard.toJson();
+
+    QJsonArray stageArray;
+    for (const StageLatency& stage : stages) {
+        QJsonObject s;
+        s["stage"] = stage.stage;
+        s["count"] = stage.count;
+        s["meanUs"] = stage.meanUs;
+        s["p50Us"] = stage.p50Us;
+        s["p90Us"] = stage.p90Us;
+        s["p99Us"] = stage.p99Us;
+        s["maxUs"] = stage.maxUs;
+        stageArray.append(s);
+    }
+    obj["stages"] = stageArray;
+    return obj;
+}
+
+QString LoadReport::toText() const {
+    QString text;
+    QTextStream out(&text);
+    out << "scenario    " << scenario << "\n"
+        << "simulated   " << simulatedMs / 1000.0 << " s in " << wallMs / 1000.0 << " s wall ("
+        << QString::number(speedup(), 'f', 1) << "x real time)\n"
+        << "throughput  " << QString::number(detectionsPerWallSec(), 'f', 0) << " detections/s, "
+        << scans << " scans, " << detections << " detections\n"
+        << "tracks      " << tracksCreated << " created, peak " << peakTracks
+        << ", final " << finalTracks << ", " << alerts << " alerts\n"
+        << "memory      peak " << peakResidentBytes / (1024 * 1024) << " MiB, "
+        << startResidentBytes / (1024 * 1024) << " MiB before, "
+        << endResidentBytes / (1024 * 1024) << " MiB after\n"
+        << "cpu         " << QString::number(cpuUsPerTrack(), 'f', 2) << " us per track per cycle, "
+        << trackCycleCpuUs / 1000 << " ms over the track cycles\n";
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+        .arg("stage", -12).arg("count", 8).arg("mean us", 10).arg("p50 us", 9)
+        .arg("p90 us", 9).arg("p99 us", 9).arg("max us", 9);
+    for (const StageLatency& stage : stages) {
+        out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+            .arg(stage.stage, -12).arg(stage.count, 8).arg(stage.meanUs, 10, 'f', 1)
+            .arg(stage.p50Us, 9).arg(stage.p90Us, 9).arg(stage.p99Us, 9).arg(stage.maxUs, 9);
+    }
+    if (scored) {
+        out << scorecard.toText();
+    }
+    return text;
+}
+
+LoadHarness::LoadHarness(const LoadScenario& scenario)
+    : m_scenario(scenario)
+{
+}
+
+LoadReport LoadHarness::run() {
+    LoadReport report;
+    report.scenario = m_scenario.name;
+    report.startResidentBytes = residentBytes();
+
+    VirtualClock clock(START_MS);
+
+    TrackManager trackManager;
+    TrackManagerConfig trackConfig = trackManager.config();
+    // Room for every target and a track per clutter plot while it ages out
+    trackConfig.maxTracks = qMax(trackConfig.maxTracks,
+                                 m_scenario.maxTargets * 2 + m_scenario.clutterPerScan * 200);
+    trackConfig.maxTentativeTracks = qMax(trackConfig.maxTentativeTracks, trackConfig.maxTracks);
+    trackManager.setConfig(trackConfig);
+    trackManager.setClock(&clock);
+
+    ThreatAssessor threatAssessor(&trackManager);
+    ThreatAssessorConfig assessorConfig = threatAssessor.config();
+    // Changes reach the assessor as they are produced, not on a timer
+    assessorConfig.maxChangeRateHz = 0;
+    threatAssessor.setConfig(assessorConfig);
+    threatAssessor.setClock(&clock);
+
+    DefendedAsset baseAsset;
+    baseAsset.id = "BASE-01";
+    baseAsset.name = "Main Installation";
+    baseAsset.position = m_scenario.basePosition;
+    baseAsset.criticalRadiusM = 500.0;
+    baseAsset.warningRadiusM = 1500.0;
+    baseAsset.priorityLevel = 5;
+    threatAssessor.addDefendedAsset(baseAsset);
+
+    ReadyEffector<RFJammer> jammer("LOAD-JAMMER-001");
+    ReadyEffector<KineticInterceptor> interceptor("LOAD-KINETIC-001");
+    EngagementManager engagementManager(&trackManager);
+    engagementManager.setThreatAssessor(&threatAssessor);
+    for (EffectorInterface* effector : {static_cast<EffectorInterface*>(&jammer),
+                                        static_cast<EffectorInterface*>(&interceptor)}) {
+        effector->setPosition(m_scenario.basePosition);
+        effector->initialize();
+        engagementManager.registerEffector(effector);
+    }
+
+    QObject::connect(&trackManager, &TrackManager::trackCreated, &trackManager,
+                     [&report]() { ++report.tracksCreated; }, Qt::DirectConnection);
+    QObject::connect(&threatAssessor, &ThreatAssessor::newAlert, &threatAssessor,
+                     [&report]() { ++report.alerts; }, Qt::DirectConnection);
+
+    TrackSimulator simulator(&trackManager);
+    simulator.setClock(&clock);
+    simulator.setSeed(m_scenario.seed);
+    simulator.setBasePosition(m_scenario.basePosition);
+    simulator.setMaxTargets(m_scenario.maxTargets);
+    const bool scripted = !m_scenario.raidScript.isEmpty() && simulator.loadScript(m_scenario.raidScript);
+    const int initialTargets = scripted ? 0
+                             : m_scenario.initialTargets < 0 ? m_scenario.maxTargets
+                                                             : qMin(m_scenario.initialTargets, m_scenario.maxTargets);
+    for (int i = 0; i < initialTargets; ++i) {
+        simulator.spawnTarget();
+    }
+
+    // Detection misses and clutter draw from their own stream, so changing
+    // them leaves the targets' paths alone
+    FastRandom random(m_scenario.seed, 1);
+    const double coverageM = 3000.0;
+    const double metresPerDegLon = 111000.0 * std::cos(qDegreesToRadians(m_scenario.basePosition.latitude));
+
+    QVector<qint64> ingestUs;
+    QVector<qint64> cycleUs;
+    QVector<qint64> assessmentUs;
+    QVector<qint64> engagementUs;
+    QString topThreatId;
+
+    const qint64 scanMs = qMax(1, 1000 / m_scenario.scanRateHz);
+    const qint64 cycleMs = qMax(1, 1000 / qMax(1, trackConfig.updateRateHz));
+    const qint64 assessmentMs = qMax(1, assessorConfig.assessmentIntervalMs);
+    const qint64 endMs = START_MS + qint64(qMax(0, m_scenario.durationSec)) * 1000;
+    qint64 nextScanMs = START_MS + scanMs;
+    qint64 nextCycleMs = START_MS + cycleMs;
+    qint64 nextAssessmentMs = START_MS + assessmentMs;
+    double spawnCredit = 0.0;
+    qint64 sampledPeakBytes = report.startResidentBytes;
+    qint64 nextMemorySampleMs = START_MS;
+
+    ScorecardConfig scoreConfig;
+    scoreConfig.cutoffM = m_scenario.scoreCutoffM;
+    FusionScorecard scorecard(m_scenario.basePosition, scoreConfig);
+    QVector<TruthTarget> truth;
+    QVector<ScorecardTruth> scoredTruth;
+    QVector<ScorecardTrack> scoredTracks;
+    const qint64 scoreMs = qMax(1, m_scenario.scoreIntervalMs);
+    qint64 nextScoreMs = START_MS + scoreMs;
+    qint64 lastScanMs = START_MS;
+    qint64 scoringNs = 0;
+
+    const qint64 wallStartNs = TimeUtils::monotonicNs();
+    forever {
+        const qint64 nowMs = qMin(nextScanMs, qMin(nextCycleMs, nextAssessmentMs));
+        if (nowMs > endMs) break;
+        clock.setTime(nowMs);
+
+        // At equal times: scan, then cycle, then assessment, as in a replay
+        if (nowMs == nextScanMs) {
+            spawnCredit += scripted ? 0.0 : m_scenario.threatSpawnRate * scanMs / 1000.0;
+            while (spawnCredit >= 1.0 && simulator.targetCount() < m_scenario.maxTargets) {
+                simulator.spawnTarget();
+                spawnCredit -= 1.0;
+            }
+            spawnCredit = qMin(spawnCredit, 1.0);
+
+            QVector<SensorDetection> plots = simulator.advance(scanMs / 1000.0);
+            if (m_scenario.detectionProbability < 1.0) {
+                plots.erase(std::remove_if(plots.begin(), plots.end(), [&](const SensorDetection&) {
+                    return random.uniform() >= m_scenario.detectionProbability;
+                }), plots.end());
+            }
+            for (int i = 0; i < m_scenario.clutterPerScan; ++i) {
+                const double range = random.uniform() * coverageM;
+                const double bearing = qDegreesToRadians(random.uniform() * 360.0);
+                SensorDetection clutter;
+                clutter.sensorId = "SIM-RADAR";
+                clutter.sourceType = DetectionSource::Radar;
+                clutter.position.latitude = m_scenario.basePosition.latitude + range * std::cos(bearing) / 111000.0;
+                clutter.position.longitude = m_scenario.basePosition.longitude + range * std::sin(bearing) / metresPerDegLon;
+                clutter.position.altitude = m_scenario.basePosition.altitude + random.uniform() * 300.0;
+                clutter.confidence = 0.3;
+                clutter.timestamp = nowMs;
+                plots.append(clutter);
+            }
+
+            const qint64 startNs = TimeUtils::monotonicNs();
+            trackManager.processDetectionBatch(plots);
+            ingestUs.append(elapsedUs(startNs));
+            ++report.scans;
+            report.detections += plots.size();
+            lastScanMs = nowMs;
+            nextScanMs += scanMs;
+        } else if (nowMs == nextCycleMs) {
+            const qint64 startNs = TimeUtils::monotonicNs();
+            const qint64 startCpuUs = processCpuUs();
+            trackManager.step();
+            cycleUs.append(elapsedUs(startNs));
+            report.trackCycleCpuUs += processCpuUs() - startCpuUs;
+            ++report.trackCycles;
+            const int tracks = trackManager.trackCount();
+            report.trackCycleTracks += tracks;
+            report.peakTracks = qMax(report.peakTracks, tracks);
+            nextCycleMs += cycleMs;
+
+            if (m_scenario.scorecard && nowMs >= nextScoreMs) {
+                // Truth is as of the last scan; the tracks are predicted to it
+                const qint64 scoreStartNs = TimeUtils::monotonicNs();
+                simulator.truth(truth);
+                scoredTruth.resize(truth.size());
+                for (int i = 0; i < truth.size(); ++i) {
+                    scoredTruth[i].serial = truth[i].serial;
+                    scoredTruth[i].position = truth[i].position;
+                }
+                scoredTracks.clear();
+                const TrackPicturePtr picture = trackManager.snapshot();
+                for (const TrackSnapshot& track : picture->tracks) {
+                    if (track.state == TrackState::Dropped) continue;
+                    ScorecardTrack scored;
+                    scored.trackId = track.trackId;
+                    scored.position = track.predictedPosition(lastScanMs - track.lastUpdateMs);
+                    scored.confirmed = track.state != TrackState::Initiated;
+                    scoredTracks.append(scored);
+                }
+                scorecard.score(lastScanMs, scoredTruth, scoredTracks);
+                nextScoreMs += scoreMs;
+                scoringNs += TimeUtils::monotonicNs() - scoreStartNs;
+            }
+        } else {
+            qint64 startNs = TimeUtils::monotonicNs();
+            threatAssessor.step();
+            assessmentUs.append(elapsedUs(startNs));
+            ++report.assessmentCycles;
+            nextAssessmentMs += assessmentMs;
+
+            // The operator's next pick: select and recommend on a new top threat
+            const QVector<TrackSnapshot> top = threatAssessor.topThreats(1);
+            if (!top.isEmpty() && top.first().trackId != topThreatId) {
+                topThreatId = top.first().trackId;
+                startNs = TimeUtils::monotonicNs();
+                engagementManager.selectTrack(topThreatId);
+                engagementUs.append(elapsedUs(startNs));
+                ++report.engagementCycles;
+            }
+        }
+
+        if (nowMs >= nextMemorySampleMs) {
+            sampledPeakBytes = qMax(sampledPeakBytes, residentBytes());
+            nextMemorySampleMs += 1000;
+        }
+    }
+    // Scoring is the harness's work, not the pipeline's
+    report.wallMs = (TimeUtils::monotonicNs() - wallStartNs - scoringNs) / 1000000;
+    report.simulatedMs = clock.nowMs() - START_MS;
+    report.finalTracks = trackManager.trackCount();
+    report.endResidentBytes = residentBytes();
+    report.peakResidentBytes = qMax(peakResidentBytes(), qMax(sampledPeakBytes, report.endResidentBytes));
+
+    report.stages = {
+        StageLatency::fromSamples("ingest", ingestUs),
+        StageLatency::fromSamples("track-cycle", cycleUs),
+        StageLatency::fromSamples("assessment", assessmentUs),
+        StageLatency::fromSamples("engagement", engagementUs)
+    };
+    if (m_scenario.scorecard) {
+        report.scored = true;
+        report.scorecard = scorecard.report();
+    }
+    return report;
+}
+
+qint64 LoadHarness::residentBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.WorkingSetSize);
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    return procStatusBytes("VmRSS");
+#else
+    return 0;
+#endif
+}
+
+qint64 LoadHarness::processCpuUs() {
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+    // 100 ns units
+    const auto ticks = [](const FILETIME& t) {
+        return (qint64(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) / 10;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#else
+    return 0;
+#endif
+}
+
+qint64 LoadHarness::peakResidentBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#elif defined(Q_OS_LINUX)
+    return procStatusBytes("VmHWM");
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(Q_OS_MACOS)
+    return usage.ru_maxrss;             // Bytes here, KiB elsewhere
+#else
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,117 @@
+#ifndef LOADHARNESS_H
+#define LOADHARNESS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+#include "simulators/FusionScorecard.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief One load-test run; SimulationScenario's keys where they overlap
+ */
+struct LoadScenario {
+    QString name = "Load";
+    GeoPosition basePosition{34.0522, -118.2437, 100.0};
+    int durationSec = 120;              // Simulated time
+    int maxTargets = 1000;
+    int initialTargets = -1;            // Spawned before the first scan, -1 for maxTargets
+    double threatSpawnRate = 50.0;      // Targets per second while below maxTargets
+    int scanRateHz = 10;                // Radar scans per second
+    double detectionProbability = 0.95;
+    int clutterPerScan = 0;             // False plots scattered over the coverage
+    quint32 seed = 1;
+    QString raidScript;                 // Played instead of spawning when set
+    bool scorecard = false;             // Score the tracks against the simulator's truth
+    int scoreIntervalMs = 200;          // Simulated time between scorecard samples
+    double scoreCutoffM = 100.0;        // OSPA and GOSPA cutoff
+
+    QJsonObject toJson() const;
+    static LoadScenario fromJson(const QJsonObject& obj);
+};
+
+/**
+ * @brief Latency distribution of one pipeline stage, in microseconds
+ */
+struct StageLatency {
+    QString stage;
+    int count = 0;
+    double meanUs = 0.0;
+    qint64 p50Us = 0;
+    qint64 p90Us = 0;
+    qint64 p99Us = 0;
+    qint64 maxUs = 0;
+
+    static StageLatency fromSamples(const QString& stage, QVector<qint64> samplesUs);
+};
+
+/**
+ * @brief What a load-test run measured
+ */
+struct LoadReport {
+    QString scenario;
+    qint64 simulatedMs = 0;
+    qint64 wallMs = 0;
+    qint64 scans = 0;
+    qint64 detections = 0;
+    int trackCycles = 0;
+    int assessmentCycles = 0;
+    int engagementCycles = 0;
+    int tracksCreated = 0;
+    int peakTracks = 0;
+    int finalTracks = 0;
+    int alerts = 0;
+    QVector<StageLatency> stages;       // Ingest, track cycle, assessment, engagement
+    qint64 peakResidentBytes = 0;       // Process high-water mark
+    qint64 startResidentBytes = 0;      // Before the pipeline was built
+    qint64 endResidentBytes = 0;
+    qint64 trackCycleCpuUs = 0;         // Process CPU, every thread, over the track cycles
+    qint64 trackCycleTracks = 0;        // Tracks summed over the cycles
+    bool scored = false;
+    ScorecardReport scorecard;
+
+    // CPU a track costs per cycle, in microseconds
+    double cpuUsPerTrack() const { return trackCycleTracks > 0 ? double(trackCycleCpuUs) / trackCycleTracks : 0.0; }
+    double detectionsPerWallSec() const { return wallMs > 0 ? detections * 1000.0 / wallMs : 0.0; }
+    double speedup() const { return wallMs > 0 ? double(simulatedMs) / wallMs : 0.0; }
+    QJsonObject toJson() const;
+    QString toText() const;
+};
+
+/**
+ * @brief Headless, faster-than-real-time run of the fusion core
+ *
+ * Builds its own TrackManager, ThreatAssessor and EngagementManager on a
+ * VirtualClock, with a TrackSimulator producing the radar plots, and
+ * drives them the way ReplayEngine does: scans, track cycles and
+ * assessments in time order, no timers and no threads, as fast as the
+ * CPU allows. After each assessment the engagement manager is handed the
+ * top threat whenever it changes, which exercises effector recommendation.
+ * Each stage is timed on the wall clock per call, and the track cycles on
+ * the process CPU clock too, so CPU per track is reported beside the cycle
+ * percentiles. With the scorecard on, the tracks are scored against the
+ * simulator's truth after a track cycle every scoreIntervalMs, so an
+ * optimisation that speeds association or filtering up shows in the same
+ * run whether it cost quality. Scoring is not timed in any stage.
+ */
+class LoadHarness {
+public:
+    explicit LoadHarness(const LoadScenario& scenario);
+
+    LoadReport run();
+
+    // Resident set now and the process high-water mark; 0 where unknown
+    static qint64 residentBytes();
+    static qint64 peakResidentBytes();
+    // User and system time of every thread so far; 0 where unknown
+    static qint64 processCpuUs();
+
+private:
+    LoadScenario m_scenario;
+};
+
+} // namespace CounterUAS
+
+#endif // LOADHARNESS_H
@@ -0,0 +1,412 @@
+#include "simulators/RaidScript.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/FastRandom.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QtMath>
+#include <algorithm>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+const char* const FORMAT_NAME = "counter-uas-raid";
+
+void coordinates(const GeoPosition& pos, double out[3]) {
+    out[0] = pos.latitude;
+    out[1] = pos.longitude;
+    out[2] = pos.altitude;
+}
+
+} // namespace
+
+bool ScriptedTarget::isValid() const {
+    if (id.isEmpty() || waypoints.size() < 2) return false;
+    for (int i = 1; i < waypoints.size(); ++i) {
+        if (!(waypoints[i].timeSec > waypoints[i - 1].timeSec)) return false;
+    }
+    return true;
+}
+
+int ScriptedTarget::segmentAt(double timeSec) const {
+    auto it = std::upper_bound(waypoints.cbegin(), waypoints.cend(), timeSec,
+        [](double t, const RaidWaypoint& wp) { return t < wp.timeSec; });
+    const int next = static_cast<int>(it - waypoints.cbegin());
+    return qBound(0, next - 1, waypoints.size() - 2);
+}
+
+void ScriptedTarget::tangentAt(int index, double slope[3]) const {
+    const int before = qMax(0, index - 1);
+    const int after = qMin(waypoints.size() - 1, index + 1);
+    double a[3], b[3];
+    coordinates(waypoints[before].position, a);
+    coordinates(waypoints[after].position, b);
+    const double dt = waypoints[after].timeSec - waypoints[before].timeSec;
+    for (int k = 0; k < 3; ++k) {
+        slope[k] = (b[k] - a[k]) / dt;
+    }
+}
+
+GeoPosition ScriptedTarget::positionAt(double timeSec) const {
+    if (waypoints.isEmpty()) return GeoPosition();
+    if (waypoints.size() == 1 || timeSec <= startSec()) return waypoints.first().position;
+    if (timeSec >= endSec()) return waypoints.last().position;
+
+    const int i = segmentAt(timeSec);
+    const double h = waypoints[i + 1].timeSec - waypoints[i].timeSec;
+    const double s = (timeSec - waypoints[i].timeSec) / h;
+    const double s2 = s * s;
+    const double s3 = s2 * s;
+    const double h00 = 2 * s3 - 3 * s2 + 1;
+    const double h10 = s3 - 2 * s2 + s;
+    const double h01 = -2 * s3 + 3 * s2;
+    const double h11 = s3 - s2;
+
+    double p0[3], p1[3], m0[3], m1[3], p[3];
+    coordinates(waypoints[i].position, p0);
+    coordinates(waypoints[i + 1].position, p1);
+    tangentAt(i, m0);
+    tangentAt(i + 1, m1);
+    for (int k = 0; k < 3; ++k) {
+        p[k] = h00 * p0[k] + h10 * h * m0[k] + h01 * p1[k] + h11 * h * m1[k];
+    }
+    return GeoPosition{p[0], p[1], p[2]};
+}
+
+VelocityVector ScriptedTarget::velocityAt(double timeSec) const {
+    VelocityVector vel;
+    if (waypoints.size() < 2) return vel;
+
+    const double t = qBound(startSec(), timeSec, endSec());
+    const int i = segmentAt(t);
+    const double h = waypoints[i + 1].timeSec - waypoints[i].timeSec;
+    const double s = (t - waypoints[i].timeSec) / h;
+    const double s2 = s * s;
+    // Derivatives of the Hermite basis with respect to s
+    const double d00 = 6 * s2 - 6 * s;
+    const double d10 = 3 * s2 - 4 * s + 1;
+    const double d01 = -6 * s2 + 6 * s;
+    const double d11 = 3 * s2 - 2 * s;
+
+    double p0[3], p1[3], m0[3], m1[3], d[3];
+    coordinates(waypoints[i].position, p0);
+    coordinates(waypoints[i + 1].position, p1);
+    tangentAt(i, m0);
+    tangentAt(i + 1, m1);
+    for (int k = 0; k < 3; ++k) {
+        d[k] = (d00 * p0[k] + d01 * p1[k]) / h + d10 * m0[k] + d11 * m1[k];
+    }
+
+    const double latitude = positionAt(t).latitude;
+    vel.north = d[0] * CoordinateUtils::DEG_TO_M_LAT;
+    vel.east = d[1] * CoordinateUtils::degToMeterLon(latitude);
+    vel.down = -d[2];
+    return vel;
+}
+
+QJsonObject ScriptedTarget::toJson() const {
+    QJsonObject obj;
+    obj["id"] = id;
+    obj["classification"] = static_cast<int>(classification);
+    obj["rcs"] = rcs;
+    QJsonArray wp;
+    for (const RaidWaypoint& point : waypoints) {
+        wp.append(QJsonArray{point.timeSec, point.position.latitude,
+                             point.position.longitude, point.position.altitude});
+    }
+    obj["wp"] = wp;
+    return obj;
+}
+
+ScriptedTarget ScriptedTarget::fromJson(const QJsonObject& obj) {
+    ScriptedTarget target;
+    target.id = obj["id"].toString();
+    target.classification = static_cast<TrackClassification>(
+        obj["classification"].toInt(static_cast<int>(TrackClassification::Pending)));
+    target.rcs = obj["rcs"].toDouble(0.1);
+    const QJsonArray wp = obj["wp"].toArray();
+    target.waypoints.reserve(wp.size());
+    for (const QJsonValue& v : wp) {
+        const QJsonArray point = v.toArray();
+        if (point.size() < 4) continue;
+        RaidWaypoint waypoint;
+        waypoint.timeSec = point[0].toDouble();
+        waypoint.position = GeoPosition{point[1].toDouble(), point[2].toDouble(), point[3].toDouble()};
+        target.waypoints.append(waypoint);
+    }
+    return target;
+}
+
+QJsonObject RaidScriptHeader::toJson() const {
+    QJsonObject obj;
+    obj["format"] = FORMAT_NAME;
+    obj["version"] = RaidScriptWriter::VERSION;
+    obj["name"] = name;
+    obj["description"] = description;
+    obj["basePosition"] = basePosition.toJson();
+    obj["durationSec"] = durationSec;
+    obj["targetCount"] = targetCount;
+    return obj;
+}
+
+RaidScriptHeader RaidScriptHeader::fromJson(const QJsonObject& obj) {
+    RaidScriptHeader header;
+    header.name = obj["name"].toString("Raid");
+    header.description = obj["description"].toString();
+    header.basePosition = GeoPosition::fromJson(obj["basePosition"].toObject());
+    header.durationSec = obj["durationSec"].toDouble();
+    header.targetCount = obj["targetCount"].toInt();
+    return header;
+}
+
+bool RaidScriptWriter::open(const QString& path, const RaidScriptHeader& header) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_lastStartSec = -std::numeric_limits<double>::infinity();
+    m_written = 0;
+    m_error.clear();
+    m_file.write(QJsonDocument(header.toJson()).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    return true;
+}
+
+bool RaidScriptWriter::write(const ScriptedTarget& target) {
+    if (!m_file.isOpen()) {
+        m_error = "Raid script not open";
+        return false;
+    }
+    if (!target.isValid()) {
+        m_error = QString("Target '%1' needs an id and two or more waypoints in time order")
+                      .arg(target.id);
+        return false;
+    }
+    if (target.startSec() < m_lastStartSec) {
+        m_error = QString("Target '%1' starts before the one written before it").arg(target.id);
+        return false;
+    }
+    m_lastStartSec = target.startSec();
+    m_file.write(QJsonDocument(target.toJson()).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    m_written++;
+    return true;
+}
+
+bool RaidScriptWriter::close() {
+    if (!m_file.isOpen()) return m_error.isEmpty();
+    const bool flushed = m_file.flush();
+    if (!flushed) m_error = m_file.errorString();
+    m_file.close();
+    return flushed && m_error.isEmpty();
+}
+
+bool RaidScriptWriter::convertScenario(const QJsonObject& scenario, const QString& path,
+                                       QString* error) {
+    RaidScriptHeader header;
+    header.name = scenario["name"].toString("Default");
+    header.description = scenario["description"].toString();
+    header.basePosition = GeoPosition::fromJson(scenario["basePosition"].toObject());
+    if (!scenario.contains("basePosition")) {
+        header.basePosition = GeoPosition{34.0522, -118.2437, 100.0};
+    }
+    header.durationSec = scenario["durationMinutes"].toInt(10) * 60.0;
+
+    const GeoPosition base = header.basePosition;
+    const double metresPerDegLon = CoordinateUtils::degToMeterLon(base.latitude);
+    const int maxTargets = scenario["maxTargets"].toInt(10);
+    const double spawnRate = scenario["threatSpawnRate"].toDouble(0.2);
+    const double hostileProbability = scenario["hostileProbability"].toDouble(0.7);
+    const quint64 seed = scenario["seed"].toVariant().toULongLong();
+    FastRandom random(seed != 0 ? seed : 1);
+
+    QVector<ScriptedTarget> targets;
+
+    // Explicit targets fly straight for the whole scenario
+    const QJsonArray radarTargets = scenario["radarTargets"].toArray();
+    for (const QJsonValue& v : radarTargets) {
+        const QJsonObject obj = v.toObject();
+        ScriptedTarget target;
+        target.id = obj["id"].toString();
+        target.rcs = obj["rcs"].toDouble(0.1);
+        RaidWaypoint start;
+        start.position = GeoPosition{obj["latitude"].toDouble(), obj["longitude"].toDouble(),
+                                     obj["altitude"].toDouble()};
+        RaidWaypoint end;
+        end.timeSec = header.durationSec;
+        end.position = start.position;
+        end.position.latitude += obj["velocityNorth"].toDouble() * end.timeSec / CoordinateUtils::DEG_TO_M_LAT;
+        end.position.longitude += obj["velocityEast"].toDouble() * end.timeSec / metresPerDegLon;
+        end.position.altitude -= obj["velocityDown"].toDouble() * end.timeSec;
+        target.waypoints = {start, end};
+        targets.append(target);
+    }
+
+    // Spawned targets: the same spawn ring and speeds as TrackSimulator, on
+    // 10 s legs that turn back toward the base with some weave, until they
+    // reach it
+    const double legSec = 10.0;
+    QVector<double> flyingUntil;
+    int spawned = 0;
+    for (double t = 0.0; spawnRate > 0.0 && t < header.durationSec; t += 1.0 / spawnRate) {
+        flyingUntil.erase(std::remove_if(flyingUntil.begin(), flyingUntil.end(),
+                                         [t](double end) { return end <= t; }),
+                          flyingUntil.end());
+        if (flyingUntil.size() >= maxTargets) continue;
+
+        ScriptedTarget target;
+        target.id = QString("RAID-%1").arg(++spawned, 5, 10, QChar('0'));
+        target.rcs = 0.05 + random.uniform() * 0.15;
+        target.classification = random.uniform() < hostileProbability ? TrackClassification::Hostile
+                                                                      : TrackClassification::Pending;
+
+        const double bearingRad = qDegreesToRadians(random.uniform() * 360.0);
+        double range = 2000.0 + random.uniform() * 1000.0;
+        double north = range * std::cos(bearingRad);
+        double east = range * std::sin(bearingRad);
+        double altitude = base.altitude + 50.0 + random.uniform() * 250.0;
+        const double speed = 8.0 + random.uniform() * 12.0;
+        double time = t;
+
+        forever {
+            RaidWaypoint waypoint;
+            waypoint.timeSec = time;
+            waypoint.position = GeoPosition{base.latitude + north / CoordinateUtils::DEG_TO_M_LAT,
+                                            base.longitude + east / metresPerDegLon, altitude};
+            target.waypoints.append(waypoint);
+            if (range <= 100.0 || time >= header.durationSec) break;
+
+            const double heading = std::atan2(-east, -north) + qDegreesToRadians(random.uniform(-20.0, 20.0));
+            const double step = qMin(speed * legSec, range);
+            north += step * std::cos(heading);
+            east += step * std::sin(heading);
+            altitude = qMax(base.altitude + 20.0, altitude + random.uniform(-10.0, 10.0));
+            range = std::hypot(north, east);
+            time += step / speed;
+        }
+        flyingUntil.append(target.endSec());
+        targets.append(target);
+    }
+
+    std::stable_sort(targets.begin(), targets.end(),
+        [](const ScriptedTarget& a, const ScriptedTarget& b) { return a.startSec() < b.startSec(); });
+    header.targetCount = targets.size();
+
+    RaidScriptWriter writer;
+    bool ok = writer.open(path, header);
+    for (int i = 0; ok && i < targets.size(); ++i) {
+        ok = writer.write(targets[i]);
+    }
+    ok = writer.close() && ok;
+    if (!ok && error) *error = writer.errorString();
+    return ok;
+}
+
+bool RaidScriptWriter::convertScenarioFile(const QString& scenarioPath, const QString& path,
+                                           QString* error) {
+    QFile file(scenarioPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        if (error) *error = parseError.errorString();
+        return false;
+    }
+    return convertScenario(doc.object(), path, error);
+}
+
+bool RaidScriptReader::open(const QString& path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    const QJsonObject first = QJsonDocument::fromJson(m_file.readLine()).object();
+    if (first["format"].toString() != FORMAT_NAME) {
+        m_error = "Not a raid script";
+        m_file.close();
+        return false;
+    }
+    if (first["version"].toInt() > RaidScriptWriter::VERSION) {
+        m_error = QString("Raid script version %1 is newer than this build reads")
+                      .arg(first["version"].toInt());
+        m_file.close();
+        return false;
+    }
+    m_header = RaidScriptHeader::fromJson(first);
+    m_firstTargetOffset = m_file.pos();
+    m_lastStartSec = -std::numeric_limits<double>::infinity();
+    m_line = 1;
+    m_error.clear();
+    readNext();
+    return true;
+}
+
+void RaidScriptReader::close() {
+    m_file.close();
+    m_hasNext = false;
+    m_next = ScriptedTarget();
+}
+
+bool RaidScriptReader::rewind() {
+    if (!m_file.isOpen() || !m_file.seek(m_firstTargetOffset)) return false;
+    m_lastStartSec = -std::numeric_limits<double>::infinity();
+    m_line = 1;
+    m_error.clear();
+    readNext();
+    return true;
+}
+
+double RaidScriptReader::nextStartSec() const {
+    return m_hasNext ? m_next.startSec() : std::numeric_limits<double>::infinity();
+}
+
+int RaidScriptReader::readUntil(double timeSec, QVector<ScriptedTarget>& out) {
+    int count = 0;
+    while (m_hasNext && m_next.startSec() <= timeSec) {
+        out.append(std::move(m_next));
+        count++;
+        readNext();
+    }
+    return count;
+}
+
+void RaidScriptReader::readNext() {
+    m_hasNext = false;
+    while (!m_file.atEnd()) {
+        const QByteArray line = m_file.readLine().trimmed();
+        m_line++;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        ScriptedTarget target = ScriptedTarget::fromJson(QJsonDocument::fromJson(line).object());
+        if (!target.isValid()) {
+            m_error = QString("Line %1: not a valid target, skipped").arg(m_line);
+            continue;
+        }
+        // Out of order would stall playback behind it; stop rather than guess
+        if (target.startSec() < m_lastStartSec) {
+            m_error = QString("Line %1: target starts before the one above it").arg(m_line);
+            return;
+        }
+        m_lastStartSec = target.startSec();
+        m_next = std::move(target);
+        m_hasNext = true;
+        return;
+    }
+}
+
+bool RaidScriptReader::isRaidScript(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    return QJsonDocument::fromJson(file.readLine()).object()["format"].toString() == FORMAT_NAME;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,143 @@
+#ifndef RAIDSCRIPT_H
+#define RAIDSCRIPT_H
+
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief A point a scripted target passes through, and when
+ */
+struct RaidWaypoint {
+    double timeSec = 0.0;           // From the start of the script
+    GeoPosition position;
+};
+
+/**
+ * @brief One scripted target, flying a spline through its waypoints
+ *
+ * A cubic Hermite spline over time with Catmull-Rom tangents (the slope
+ * between the neighbouring waypoints), so the target is at each waypoint
+ * at its time and its velocity never jumps. Two waypoints make a straight
+ * line at constant speed. The target exists from its first waypoint's time
+ * to its last.
+ */
+struct ScriptedTarget {
+    QString id;
+    TrackClassification classification = TrackClassification::Pending;
+    double rcs = 0.1;
+    QVector<RaidWaypoint> waypoints;    // Strictly increasing times
+
+    bool isValid() const;
+    double startSec() const { return waypoints.isEmpty() ? 0.0 : waypoints.first().timeSec; }
+    double endSec() const { return waypoints.isEmpty() ? 0.0 : waypoints.last().timeSec; }
+
+    // Held at the first and last waypoints outside [startSec, endSec]
+    GeoPosition positionAt(double timeSec) const;
+    VelocityVector velocityAt(double timeSec) const;
+
+    QJsonObject toJson() const;
+    static ScriptedTarget fromJson(const QJsonObject& obj);
+
+private:
+    int segmentAt(double timeSec) const;
+    void tangentAt(int index, double slope[3]) const;
+};
+
+/**
+ * @brief First line of a raid script
+ */
+struct RaidScriptHeader {
+    QString name;
+    QString description;
+    GeoPosition basePosition;
+    double durationSec = 0.0;
+    int targetCount = 0;            // As written; 0 if not known up front
+
+    QJsonObject toJson() const;
+    static RaidScriptHeader fromJson(const QJsonObject& obj);
+};
+
+/**
+ * @brief Writes a raid script
+ *
+ * A raid script is line-delimited JSON: the header, then one target per
+ * line in order of start time, waypoints as [t, lat, lon, alt] arrays.
+ * That order is what lets RaidScriptReader stream it, so write() refuses
+ * a target that starts before the previous one.
+ */
+class RaidScriptWriter {
+public:
+    static constexpr int VERSION = 1;
+
+    bool open(const QString& path, const RaidScriptHeader& header);
+    bool write(const ScriptedTarget& target);
+    bool close();
+
+    int written() const { return m_written; }
+    QString errorString() const { return m_error; }
+
+    // Expands a SimulationScenario JSON into a raid script: its explicit
+    // radarTargets as straight lines, then targets spawned at
+    // threatSpawnRate up to maxTargets at once, each weaving toward the
+    // base. The same JSON (with the same seed) always gives the same script
+    static bool convertScenario(const QJsonObject& scenario, const QString& path,
+                                QString* error = nullptr);
+    static bool convertScenarioFile(const QString& scenarioPath, const QString& path,
+                                    QString* error = nullptr);
+
+private:
+    QFile m_file;
+    double m_lastStartSec = 0.0;
+    int m_written = 0;
+    QString m_error;
+};
+
+/**
+ * @brief Streams a raid script from disk in time order
+ *
+ * Holds only the header and the next unread target, so a script of any
+ * length or size plays back in constant memory; the caller keeps the
+ * targets that are flying and drops them after their endSec.
+ */
+class RaidScriptReader {
+public:
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    // Back to the first target
+    bool rewind();
+
+    RaidScriptHeader header() const { return m_header; }
+    bool atEnd() const { return !m_hasNext; }
+    // Start of the next unread target; infinity at the end
+    double nextStartSec() const;
+
+    // Appends every unread target that starts at or before timeSec; returns how many
+    int readUntil(double timeSec, QVector<ScriptedTarget>& out);
+
+    QString errorString() const { return m_error; }
+
+    // True if the file starts with a raid script header
+    static bool isRaidScript(const QString& path);
+
+private:
+    void readNext();
+
+    QFile m_file;
+    RaidScriptHeader m_header;
+    qint64 m_firstTargetOffset = 0;
+    double m_lastStartSec = 0.0;
+    ScriptedTarget m_next;
+    bool m_hasNext = false;
+    int m_line = 0;
+    QString m_error;
+};
+
+} // namespace CounterUAS
+
+#endif // RAIDSCRIPT_H
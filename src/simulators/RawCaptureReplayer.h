@@ -0,0 +1,85 @@
+#ifndef RAWCAPTUREREPLAYER_H
+#define RAWCAPTUREREPLAYER_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+#include <functional>
+#include "utils/RawCapture.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+/**
+ * @brief Plays a raw capture back into the live pipeline, paced at 1x to 100x
+ *
+ * Where ReplayEngine re-drives fusion from the detections the sensors made,
+ * this feeds the sensors' own inputs back through their parsers: each
+ * captured packet goes to the sink registered for its source, at its
+ * recorded time from the first packet divided by the time scale. Sinks
+ * normally call SensorInterface::replayRaw(), which takes the bytes only
+ * while that sensor is disconnected, so live and replayed reads of one
+ * source never share a framer. Packets of a source without a sink are
+ * counted and skipped.
+ *
+ * The replayed detections are stamped on arrival as live ones are; the
+ * sensors' clocks see the replay's pacing, not the capture's.
+ */
+class RawCaptureReplayer : public QObject {
+    Q_OBJECT
+
+public:
+    using Sink = std::function<void(const QByteArray&)>;
+
+    static constexpr double MIN_TIME_SCALE = 1.0;
+    static constexpr double MAX_TIME_SCALE = 100.0;
+
+    explicit RawCaptureReplayer(QObject* parent = nullptr);
+    ~RawCaptureReplayer() override;
+
+    // Called on the replayer's thread; a sink posts to its sensor's if that differs
+    void setSink(const QString& source, const Sink& sink);
+    void clearSinks() { m_sinks.clear(); }
+
+    // Packets read in [startMs, endMs] from a RawCaptureRecorder directory;
+    // returns how many were loaded
+    int load(const QString& directory, qint64 startMs, qint64 endMs);
+    void setPackets(const QVector<RawCapturePacket>& packets);
+    int packetCount() const { return m_packets.size(); }
+
+    // Clamped to [MIN_TIME_SCALE, MAX_TIME_SCALE]
+    void setTimeScale(double scale);
+    double timeScale() const { return m_timeScale; }
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_active; }
+
+    int packetsReplayed() const { return m_position; }
+    quint64 packetsUnrouted() const { return m_unrouted; }
+
+signals:
+    void progress(qint64 captureMs, int packetsReplayed);
+    void finished(int packetsReplayed);
+
+private slots:
+    void tick();
+
+private:
+    static constexpr int TICK_MS = 10;
+
+    QTimer* m_timer;
+    QVector<RawCapturePacket> m_packets;
+    QHash<QString, Sink> m_sinks;
+    double m_timeScale = MIN_TIME_SCALE;
+
+    bool m_active = false;
+    int m_position = 0;
+    quint64 m_unrouted = 0;
+    qint64 m_paceStartNs = 0;           // Wall time start() began pacing from
+};
+
+} // namespace CounterUAS
+
+#endif // RAWCAPTUREREPLAYER_H
@@ -0,0 +1,261 @@
+#include "simulators/ReplayEngine.h"
+#include "core/TrackManager.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QTimer>
+#include <algorithm>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint64 FNV_OFFSET = 14695981039346656037ULL;
+constexpr quint64 FNV_PRIME = 1099511628211ULL;
+
+void mix(quint64& hash, qint64 value) {
+    for (int i = 0; i < 8; ++i) {
+        hash ^= static_cast<quint64>(value >> (i * 8)) & 0xff;
+        hash *= FNV_PRIME;
+    }
+}
+
+// Quantised so the digest does not hang on the last bit of a double
+qint64 quantise(double value, double scale) {
+    return qRound64(value * scale);
+}
+
+} // namespace
+
+ReplayEngine::ReplayEngine(TrackManager* trackManager, ThreatAssessor* threatAssessor, QObject* parent)
+    : QObject(parent)
+    , m_trackManager(trackManager)
+    , m_threatAssessor(threatAssessor)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setInterval(TICK_MS);
+    connect(m_timer, &QTimer::timeout, this, &ReplayEngine::tick);
+}
+
+ReplayEngine::~ReplayEngine() {
+    stop();
+}
+
+int ReplayEngine::load(const QString& directory, qint64 startMs, qint64 endMs) {
+    setScans(DetectionLogReader(directory).load(startMs, endMs));
+    Logger::instance().info("ReplayEngine", QString("Loaded %1 scans from %2").arg(m_scans.size()).arg(directory));
+    return m_scans.size();
+}
+
+void ReplayEngine::setScans(const QVector<RecordedScan>& scans) {
+    if (m_active) return;
+    m_scans = scans;
+    // Scans from several sensor threads may be recorded slightly out of order
+    std::stable_sort(m_scans.begin(), m_scans.end(), [](const RecordedScan& a, const RecordedScan& b) {
+        return a.receivedMs < b.receivedMs;
+    });
+}
+
+ReplaySummary ReplayEngine::run() {
+    if (!begin()) return m_summary;
+    advanceTo(std::numeric_limits<qint64>::max());
+    finish();
+    return m_summary;
+}
+
+void ReplayEngine::start() {
+    if (m_active || !begin()) return;
+    m_paceStartNs = TimeUtils::monotonicNs();
+    m_timer->start();
+}
+
+void ReplayEngine::stop() {
+    if (!m_active) return;
+    finish();
+}
+
+void ReplayEngine::tick() {
+    if (!m_active) return;
+
+    qint64 untilMs = std::numeric_limits<qint64>::max();
+    if (m_timeScale > 0.0) {
+        const double elapsedMs = (TimeUtils::monotonicNs() - m_paceStartNs) / 1e6;
+        untilMs = m_summary.startMs + static_cast<qint64>(elapsedMs * m_timeScale);
+    }
+    if (!advanceTo(untilMs)) {
+        finish();
+        return;
+    }
+    emit progress(m_clock.nowMs(), m_scanPos);
+}
+
+bool ReplayEngine::begin() {
+    if (m_active || !m_trackManager || m_scans.isEmpty()) return false;
+
+    m_summary = ReplaySummary();
+    m_summary.startMs = m_scans.first().receivedMs;
+    m_summary.pictureDigest = FNV_OFFSET;
+    m_wallStartNs = TimeUtils::monotonicNs();
+
+    m_managerWasRunning = m_trackManager->isRunning();
+    m_trackManager->stop();
+    m_previousClock = m_trackManager->clock();
+    m_clock.setTime(m_summary.startMs);
+    m_trackManager->clearAllTracks();
+    m_trackManager->setClock(&m_clock);
+    m_previousManagerConfig = m_trackManager->config();
+    // A wall-clock budget would make merges depend on the machine
+    TrackManagerConfig managerConfig = m_previousManagerConfig;
+    managerConfig.mergeBudgetUs = 0;
+    m_trackManager->setConfig(managerConfig);
+    m_cycleMs = qMax(1, 1000 / qMax(1, m_trackManager->config().updateRateHz));
+
+    if (m_threatAssessor) {
+        m_assessorWasRunning = m_threatAssessor->isRunning();
+        m_threatAssessor->stop();
+        m_previousAssessorConfig = m_threatAssessor->config();
+        // Changes reach the assessor as they are produced, not on a timer
+        ThreatAssessorConfig config = m_previousAssessorConfig;
+        config.maxChangeRateHz = 0;
+        m_threatAssessor->setConfig(config);
+        m_threatAssessor->setClock(&m_clock);
+        m_threatAssessor->clearAlerts();
+        m_assessmentMs = qMax(1, config.assessmentIntervalMs);
+        m_connections.append(connect(m_threatAssessor, &ThreatAssessor::newAlert, this,
+                                     [this]() { ++m_summary.alerts; }, Qt::DirectConnection));
+    }
+    m_connections.append(connect(m_trackManager, &TrackManager::trackCreated, this,
+                                 [this]() { ++m_summary.tracksCreated; }, Qt::DirectConnection));
+
+    m_scanPos = 0;
+    m_nextCycleMs = m_summary.startMs + m_cycleMs;
+    m_nextAssessmentMs = m_summary.startMs + m_assessmentMs;
+    // One cycle after the last scan, so it reaches the picture
+    m_summary.endMs = m_scans.last().receivedMs + m_cycleMs;
+
+    if (!m_outputPath.isEmpty()) {
+        m_outputFile.reset(new QFile(m_outputPath));
+        if (m_outputFile->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            m_output.setDevice(m_outputFile.get());
+            m_output << "time_ms,track_id,latitude,longitude,altitude,state,classification,threat_level\n";
+        } else {
+            Logger::instance().warning("ReplayEngine", "Cannot write " + m_outputPath + ": " +
+                                       m_outputFile->errorString());
+            m_outputFile.reset();
+        }
+    }
+
+    m_active = true;
+    Logger::instance().info("ReplayEngine", QString("Replaying %1 scans over %2 s")
+        .arg(m_scans.size()).arg((m_summary.endMs - m_summary.startMs) / 1000.0, 0, 'f', 1));
+    return true;
+}
+
+bool ReplayEngine::advanceTo(qint64 untilMs) {
+    const qint64 noScan = std::numeric_limits<qint64>::max();
+    forever {
+        const qint64 scanMs = m_scanPos < m_scans.size() ? m_scans[m_scanPos].receivedMs : noScan;
+        qint64 nextMs = qMin(scanMs, m_nextCycleMs);
+        if (m_threatAssessor) {
+            nextMs = qMin(nextMs, m_nextAssessmentMs);
+        }
+        if (nextMs > m_summary.endMs) return false;
+        if (nextMs > untilMs) return true;
+
+        m_clock.setTime(nextMs);
+        if (scanMs == nextMs) {
+            const RecordedScan& scan = m_scans[m_scanPos++];
+            m_trackManager->processDetectionBatch(scan.detections);
+            ++m_summary.scans;
+            m_summary.detections += scan.detections.size();
+        } else if (m_nextCycleMs == nextMs) {
+            m_trackManager->step();
+            ++m_summary.trackCycles;
+            recordPicture();
+            m_nextCycleMs += m_cycleMs;
+        } else {
+            m_threatAssessor->step();
+            ++m_summary.assessmentCycles;
+            m_nextAssessmentMs += m_assessmentMs;
+        }
+    }
+}
+
+void ReplayEngine::recordPicture() {
+    const TrackPicturePtr picture = m_trackManager->snapshot();
+
+    // Handles follow creation order; ids and storage order are not stable
+    // from one manager to the next
+    QVector<const TrackSnapshot*> tracks;
+    tracks.reserve(picture->tracks.size());
+    for (const TrackSnapshot& track : picture->tracks) {
+        tracks.append(&track);
+    }
+    std::sort(tracks.begin(), tracks.end(), [](const TrackSnapshot* a, const TrackSnapshot* b) {
+        return a->handle < b->handle;
+    });
+
+    quint64& hash = m_summary.pictureDigest;
+    mix(hash, m_clock.nowMs() - m_summary.startMs);
+    mix(hash, tracks.size());
+    for (const TrackSnapshot* track : tracks) {
+        mix(hash, quantise(track->position.latitude, 1e7));
+        mix(hash, quantise(track->position.longitude, 1e7));
+        mix(hash, quantise(track->position.altitude, 100.0));
+        mix(hash, static_cast<int>(track->state));
+        mix(hash, static_cast<int>(track->classification));
+        mix(hash, track->threatLevel);
+
+        if (m_outputFile) {
+            m_output << m_clock.nowMs() << ',' << track->trackId << ','
+                     << QString::number(track->position.latitude, 'f', 7) << ','
+                     << QString::number(track->position.longitude, 'f', 7) << ','
+                     << QString::number(track->position.altitude, 'f', 2) << ','
+                     << static_cast<int>(track->state) << ','
+                     << static_cast<int>(track->classification) << ','
+                     << track->threatLevel << '\n';
+        }
+    }
+}
+
+void ReplayEngine::finish() {
+    m_timer->stop();
+    m_active = false;
+
+    for (const QMetaObject::Connection& connection : m_connections) {
+        disconnect(connection);
+    }
+    m_connections.clear();
+
+    m_summary.finalTrackCount = m_trackManager->trackCount();
+    m_summary.wallMs = (TimeUtils::monotonicNs() - m_wallStartNs) / 1000000;
+
+    if (m_outputFile) {
+        m_output.flush();
+        m_output.setDevice(nullptr);
+        m_outputFile.reset();
+    }
+
+    // The replayed tracks are stamped with replay time; the live clock
+    // would age them all out at once
+    m_trackManager->clearAllTracks();
+    m_trackManager->setClock(m_previousClock);
+    m_trackManager->setConfig(m_previousManagerConfig);
+    if (m_managerWasRunning) {
+        m_trackManager->start();
+    }
+    if (m_threatAssessor) {
+        m_threatAssessor->setClock(nullptr);
+        m_threatAssessor->setConfig(m_previousAssessorConfig);
+        if (m_assessorWasRunning) {
+            m_threatAssessor->start();
+        }
+    }
+
+    Logger::instance().info("ReplayEngine", QString("Replay done: %1 scans, %2 cycles in %3 ms, digest %4")
+        .arg(m_summary.scans).arg(m_summary.trackCycles).arg(m_summary.wallMs)
+        .arg(m_summary.pictureDigest, 16, 16, QChar('0')));
+    emit finished(m_summary);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,133 @@
+#ifndef REPLAYENGINE_H
+#define REPLAYENGINE_H
+
+#include <QObject>
+#include <QVector>
+#include <QTextStream>
+#include <QFile>
+#include <memory>
+#include "config/DetectionLog.h"
+#include "core/ThreatAssessor.h"
+#include "core/TrackManager.h"
+#include "utils/Clock.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+class TrackManager;
+
+/**
+ * @brief Outcome of one replay, comparable between builds
+ */
+struct ReplaySummary {
+    int scans = 0;
+    int detections = 0;
+    int trackCycles = 0;
+    int assessmentCycles = 0;
+    int tracksCreated = 0;
+    int finalTrackCount = 0;
+    int alerts = 0;
+    quint64 pictureDigest = 0;          // FNV-1a over every published picture
+    qint64 startMs = 0;                 // Replay time span
+    qint64 endMs = 0;
+    qint64 wallMs = 0;                  // Real time the replay took
+};
+
+/**
+ * @brief Re-drives the track manager and threat assessor from recorded scans
+ *
+ * Runs both on a VirtualClock of its own: each recorded scan is submitted at
+ * the time it was received, a track cycle runs every 1000 / updateRateHz ms
+ * and an assessment every assessmentIntervalMs of replay time, and at equal
+ * times scans go first, then the cycle, then the assessment. Nothing depends
+ * on the wall clock or on timers, so the same scans always give the same
+ * pictures and pictureDigest can be compared between builds.
+ *
+ * run() replays as fast as the CPU allows. start() paces the replay at
+ * timeScale times real time instead, for watching it on the display. While
+ * replaying the manager and assessor timers are stopped, the assessor's
+ * change throttle and the manager's merge pass time budget are off and the
+ * manager's tracks are cleared; their clocks, config and running state are
+ * restored afterwards.
+ */
+class ReplayEngine : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ReplayEngine(TrackManager* trackManager, ThreatAssessor* threatAssessor = nullptr,
+                          QObject* parent = nullptr);
+    ~ReplayEngine() override;
+
+    // Scans received in [startMs, endMs] from a DetectionRecorder directory;
+    // returns how many were loaded
+    int load(const QString& directory, qint64 startMs, qint64 endMs);
+    void setScans(const QVector<RecordedScan>& scans);
+    int scanCount() const { return m_scans.size(); }
+
+    // Replay time per real time for start(); 0 or less is as fast as possible
+    void setTimeScale(double scale) { m_timeScale = scale; }
+    double timeScale() const { return m_timeScale; }
+
+    // One CSV row per track per cycle; empty writes none
+    void setOutputPath(const QString& path) { m_outputPath = path; }
+
+    // Replays everything before returning
+    ReplaySummary run();
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_active; }
+
+    qint64 currentTimeMs() const { return m_clock.nowMs(); }
+    ReplaySummary summary() const { return m_summary; }
+
+signals:
+    void progress(qint64 replayMs, int scansReplayed);
+    void finished(const ReplaySummary& summary);
+
+private slots:
+    void tick();
+
+private:
+    static constexpr int TICK_MS = 20;
+
+    bool begin();
+    // Runs everything due up to untilMs; false once the replay is over
+    bool advanceTo(qint64 untilMs);
+    void finish();
+    void recordPicture();
+
+    TrackManager* m_trackManager;
+    ThreatAssessor* m_threatAssessor;
+    VirtualClock m_clock;
+    QTimer* m_timer;
+    QVector<RecordedScan> m_scans;
+    double m_timeScale = 1.0;
+    QString m_outputPath;
+
+    bool m_active = false;
+    int m_scanPos = 0;
+    qint64 m_nextCycleMs = 0;
+    qint64 m_nextAssessmentMs = 0;
+    int m_cycleMs = 100;
+    int m_assessmentMs = 500;
+    qint64 m_wallStartNs = 0;
+    qint64 m_paceStartNs = 0;           // Wall time start() began pacing from
+    ReplaySummary m_summary;
+    QList<QMetaObject::Connection> m_connections;
+
+    // Restored by finish()
+    const Clock* m_previousClock = nullptr;
+    TrackManagerConfig m_previousManagerConfig;
+    ThreatAssessorConfig m_previousAssessorConfig;
+    bool m_managerWasRunning = false;
+    bool m_assessorWasRunning = false;
+
+    std::unique_ptr<QFile> m_outputFile;
+    QTextStream m_output;
+};
+
+} // namespace CounterUAS
+
+#endif // REPLAYENGINE_H
@@ -5,29 +5,96 @@
 
 #include "simulators/SensorSimulator.h"
 #include "core/TrackManager.h"
+#include "core/FusionEngine.h"
+#include "core/CoverageService.h"
 #include "sensors/RadarSensor.h"
 #include "sensors/RFDetector.h"
 #include "sensors/CameraSystem.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/LocalTangentPlane.h"
 #include "utils/Logger.h"
+#include "utils/TimeUtils.h"
 #include <QDateTime>
-#include <QRandomGenerator>
+#include <QSet>
 #include <QtMath>
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QtConcurrent>
+#include <algorithm>
 
 namespace CounterUAS {
 
+namespace {
+
+// Stable across runs and platforms, unlike the seeded QHash hashing
+quint64 sensorStreamId(const QString& sensorId) {
+    quint64 hash = 0xCBF29CE484222325ULL;
+    for (const QChar c : sensorId) {
+        hash ^= c.unicode();
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+/**
+ * @brief Inputs and results of one sensor's scan
+ *
+ * Built and applied on the GUI thread; in between a scan task touches
+ * nothing but this and read-only simulator state, so scans of different
+ * sensors can run at once.
+ */
+struct SensorSimulator::SensorScan {
+    enum Kind { Radar, RF, Camera };
+    
+    struct RFHit {
+        SimulatedRFEmission emission;
+        GeoPosition estimatedPosition;
+        double normalizedSignal = 0.0;
+        double receivedPower = 0.0;
+    };
+    
+    struct CameraHit {
+        SimulatedVisualTarget target;
+        QRectF boundingBox;
+        double confidence = 0.0;
+    };
+    
+    Kind kind = Radar;
+    QString sensorId;
+    GeoPosition position;
+    double maxRange = 0.0;
+    double noiseFloor = -90.0;      // RF
+    double fieldOfView = 0.0;       // Camera
+    double azimuth = 0.0;
+    CoverageRasterPtr coverage;     // Radar and camera; RF is not line of sight
+    qint64 nowMs = 0;
+    FastRandom random;              // The sensor's stream, written back after the scan
+    
+    QVector<SensorDetection> plots;
+    QList<SimulatedRadarTarget> radarTargets;
+    QVector<RFHit> rfHits;
+    QVector<CameraHit> cameraHits;
+    int missed = 0;
+    int clutter = 0;
+    int falseAlarms = 0;
+};
+
 SensorSimulator::SensorSimulator(TrackManager* manager, QObject* parent)
     : QObject(parent)
     , m_trackManager(manager)
     , m_updateTimer(new QTimer(this))
     , m_detectionTimer(new QTimer(this))
+    , m_seed(FastRandom::entropySeed())
+    , m_random(m_seed, 1)
 {
     m_basePosition.latitude = 34.0522;
     m_basePosition.longitude = -118.2437;
     m_basePosition.altitude = 100.0;
+    m_radarTargets.setOrigin(m_basePosition);
     
     connect(m_updateTimer, &QTimer::timeout, this, &SensorSimulator::updateSimulation);
     connect(m_detectionTimer, &QTimer::timeout, this, &SensorSimulator::generateDetection);
@@ -43,6 +110,15 @@ void SensorSimulator::setTrackManager(TrackManager* manager) {
 
 void SensorSimulator::setBasePosition(const GeoPosition& pos) {
     m_basePosition = pos;
+    m_radarTargets.setOrigin(pos);
+}
+
+void SensorSimulator::setSeed(quint64 seed) {
+    m_seed = seed;
+    m_random.reseed(seed, 1);
+    for (auto it = m_sensorRandom.begin(); it != m_sensorRandom.end(); ++it) {
+        it.value().reseed(seed, sensorStreamId(it.key()));
+    }
 }
 
 void SensorSimulator::start() {
@@ -83,6 +159,7 @@ void SensorSimulator::registerRadar(RadarSensor* radar) {
     RadarSimState state;
     state.active = true;
     m_radarStates[id] = state;
+    addSensorStream(id);
     
     Logger::instance().info("SensorSimulator", "Registered Radar: " + id);
 }
@@ -96,6 +173,7 @@ void SensorSimulator::registerRFDetector(RFDetector* detector) {
     RFDetectorSimState state;
     state.active = true;
     m_rfDetectorStates[id] = state;
+    addSensorStream(id);
     
     Logger::instance().info("SensorSimulator", "Registered RF Detector: " + id);
 }
@@ -109,6 +187,7 @@ void SensorSimulator::registerCamera(CameraSystem* camera) {
     CameraSimState state;
     state.active = true;
     m_cameraStates[id] = state;
+    addSensorStream(id);
     
     Logger::instance().info("SensorSimulator", "Registered Camera: " + id);
 }
@@ -120,6 +199,7 @@ void SensorSimulator::unregisterSensor(const QString& sensorId) {
     m_rfDetectorStates.remove(sensorId);
     m_cameras.remove(sensorId);
     m_cameraStates.remove(sensorId);
+    m_sensorRandom.remove(sensorId);
 }
 
 void SensorSimulator::clearSensors() {
@@ -129,6 +209,11 @@ void SensorSimulator::clearSensors() {
     m_rfDetectorStates.clear();
     m_cameras.clear();
     m_cameraStates.clear();
+    m_sensorRandom.clear();
+}
+
+void SensorSimulator::addSensorStream(const QString& sensorId) {
+    m_sensorRandom.insert(sensorId, FastRandom(m_seed, sensorStreamId(sensorId)));
 }
 
 RadarSimState SensorSimulator::radarState(const QString& id) const {
@@ -144,7 +229,7 @@ CameraSimState SensorSimulator::cameraState(const QString& id) const {
 }
 
 void SensorSimulator::injectRadarTarget(const SimulatedRadarTarget& target) {
-    m_injectedRadarTargets.append(target);
+    m_radarTargets.add(target.id, target.position, target.velocity, target.rcs, target.trackQuality);
 }
 
 void SensorSimulator::injectRFEmission(const SimulatedRFEmission& emission) {
@@ -156,7 +241,7 @@ void SensorSimulator::injectVisualTarget(const SimulatedVisualTarget& target) {
 }
 
 void SensorSimulator::clearInjectedTargets() {
-    m_injectedRadarTargets.clear();
+    m_radarTargets.clear();
     m_injectedRFEmissions.clear();
     m_injectedVisualTargets.clear();
 }
@@ -184,7 +269,7 @@ void SensorSimulator::loadScenario(const QString& scenarioFile) {
         target.velocity.east = obj["velocityEast"].toDouble();
         target.velocity.down = obj["velocityDown"].toDouble();
         target.rcs = obj["rcs"].toDouble(0.1);
-        m_injectedRadarTargets.append(target);
+        injectRadarTarget(target);
     }
     
     // Load RF emissions
@@ -204,7 +289,7 @@ void SensorSimulator::loadScenario(const QString& scenarioFile) {
     
     Logger::instance().info("SensorSimulator", 
         QString("Loaded scenario: %1 radar targets, %2 RF emissions")
-            .arg(m_injectedRadarTargets.size())
+            .arg(m_radarTargets.size())
             .arg(m_injectedRFEmissions.size()));
 }
 
@@ -227,13 +312,8 @@ void SensorSimulator::updateRadarSimulation() {
     qint64 now = QDateTime::currentMSecsSinceEpoch();
     
     // Update injected targets
-    for (auto& target : m_injectedRadarTargets) {
-        target.position.latitude += (target.velocity.north * dt) / 111000.0;
-        target.position.longitude += (target.velocity.east * dt) / 
-            (111000.0 * std::cos(qDegreesToRadians(target.position.latitude)));
-        target.position.altitude -= target.velocity.down * dt;
-        target.lastUpdateTime = now;
-    }
+    m_radarTargets.propagate(dt);
+    m_radarTargetsUpdatedMs = now;
     
     // Update radar states
     for (auto it = m_radarStates.begin(); it != m_radarStates.end(); ++it) {
@@ -259,8 +339,8 @@ void SensorSimulator::updateRFDetectorSimulation() {
     for (auto& emission : m_injectedRFEmissions) {
         // Add some frequency drift in realistic mode
         if (m_realisticMode) {
-            emission.frequencyMHz += (QRandomGenerator::global()->generateDouble() - 0.5) * 0.1;
-            emission.signalStrengthDbm += (QRandomGenerator::global()->generateDouble() - 0.5) * 2.0;
+            emission.frequencyMHz += (m_random.uniform() - 0.5) * 0.1;
+            emission.signalStrengthDbm += (m_random.uniform() - 0.5) * 2.0;
         }
         emission.lastUpdateTime = now;
     }
@@ -271,10 +351,10 @@ void SensorSimulator::updateRFDetectorSimulation() {
         
         if (!state.active) continue;
         
-        // Update noise floor
+        // Update noise floor from the detector's own stream; hash order is not stable
         if (m_realisticMode) {
             state.noiseFloor = -90.0 + m_noiseLevel * 20.0 + 
-                (QRandomGenerator::global()->generateDouble() - 0.5) * 5.0;
+                (m_sensorRandom[id].uniform() - 0.5) * 5.0;
         }
         
         emit rfDetectorStateChanged(id, state);
@@ -307,24 +387,13 @@ void SensorSimulator::updateCameraSimulation() {
 void SensorSimulator::generateDetection() {
     if (!m_running || !m_trackManager) return;
     
-    // Generate detections from each sensor type
-    for (const QString& radarId : m_radars.keys()) {
-        simulateRadarScan(radarId);
-    }
-    
-    for (const QString& detectorId : m_rfDetectors.keys()) {
-        simulateRFScan(detectorId);
-    }
-    
-    for (const QString& cameraId : m_cameras.keys()) {
-        simulateCameraFrame(cameraId);
-    }
+    // Generate detections from each sensor
+    runSensorScans();
     
     // Occasionally spawn a new target if none exist
-    if (m_injectedRadarTargets.isEmpty() && 
-        QRandomGenerator::global()->generateDouble() < 0.1) {
+    if (m_radarTargets.isEmpty() && m_random.uniform() < 0.1) {
         SimulatedRadarTarget target = createDroneTarget();
-        m_injectedRadarTargets.append(target);
+        injectRadarTarget(target);
         
         // Also create associated RF emission
         SimulatedRFEmission emission = createDroneEmission(target.position);
@@ -344,19 +413,19 @@ void SensorSimulator::generateDetection() {
     }
     
     // Remove targets that are too far or have passed
-    m_injectedRadarTargets.erase(
-        std::remove_if(m_injectedRadarTargets.begin(), m_injectedRadarTargets.end(),
-            [this](const SimulatedRadarTarget& t) {
-                Track temp("temp");
-                temp.setPosition(m_basePosition);
-                double dist = temp.distanceTo(t.position);
-                return dist > 5000.0 || dist < 50.0;
-            }), m_injectedRadarTargets.end());
+    m_radarTargets.groundRanges(m_basePosition, m_ranges);
+    m_keep.resize(m_ranges.size());
+    for (int i = 0; i < m_ranges.size(); ++i) {
+        m_keep[i] = m_ranges[i] <= 5000.0 && m_ranges[i] >= 50.0;
+    }
+    m_radarTargets.compact(m_keep);
     
     // Clean up associated emissions and visual targets
+    if (m_injectedRFEmissions.isEmpty() && m_injectedVisualTargets.isEmpty()) return;
     QSet<QString> activeIds;
-    for (const auto& t : m_injectedRadarTargets) {
-        activeIds.insert(t.id);
+    activeIds.reserve(m_radarTargets.size());
+    for (int i = 0; i < m_radarTargets.size(); ++i) {
+        activeIds.insert(m_radarTargets.id(i));
     }
     
     m_injectedRFEmissions.erase(
@@ -372,174 +441,255 @@ void SensorSimulator::generateDetection() {
             }), m_injectedVisualTargets.end());
 }
 
-void SensorSimulator::simulateRadarScan(const QString& radarId) {
-    auto* radar = m_radars.value(radarId);
-    if (!radar) return;
+void SensorSimulator::runSensorScans() {
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    
+    // Sorted so the merge order, like each sensor's stream, is the same every run
+    QStringList radarIds = m_radars.keys();
+    QStringList detectorIds = m_rfDetectors.keys();
+    QStringList cameraIds = m_cameras.keys();
+    std::sort(radarIds.begin(), radarIds.end());
+    std::sort(detectorIds.begin(), detectorIds.end());
+    std::sort(cameraIds.begin(), cameraIds.end());
+    
+    QVector<SensorScan> scans;
+    scans.reserve(radarIds.size() + detectorIds.size() + cameraIds.size());
+    auto addScan = [&](SensorScan::Kind kind, const QString& id, SensorInterface* sensor) {
+        SensorScan scan;
+        scan.kind = kind;
+        scan.sensorId = id;
+        scan.position = sensor->position();
+        scan.maxRange = sensor->maxRange();
+        scan.nowMs = nowMs;
+        scan.random = m_sensorRandom.value(id, FastRandom(m_seed, sensorStreamId(id)));
+        if (m_coverage && kind != SensorScan::RF) {
+            scan.coverage = m_coverage->raster(id);
+            if (scan.coverage && !scan.coverage->isFor(scan.position)) scan.coverage.reset();
+        }
+        scans.append(scan);
+        return &scans.last();
+    };
+    for (const QString& id : radarIds) {
+        if (RadarSensor* radar = m_radars.value(id)) addScan(SensorScan::Radar, id, radar);
+    }
+    for (const QString& id : detectorIds) {
+        if (RFDetector* detector = m_rfDetectors.value(id)) {
+            addScan(SensorScan::RF, id, detector)->noiseFloor = m_rfDetectorStates.value(id).noiseFloor;
+        }
+    }
+    for (const QString& id : cameraIds) {
+        if (CameraSystem* camera = m_cameras.value(id)) {
+            SensorScan* scan = addScan(SensorScan::Camera, id, camera);
+            scan->fieldOfView = camera->fieldOfView();
+            scan->azimuth = camera->azimuth();
+        }
+    }
     
-    RadarSimState& state = m_radarStates[radarId];
-    auto* gen = QRandomGenerator::global();
+    auto runScan = [this](SensorScan& scan) {
+        switch (scan.kind) {
+        case SensorScan::Radar: scanRadar(scan); break;
+        case SensorScan::RF: scanRF(scan); break;
+        case SensorScan::Camera: scanCamera(scan); break;
+        }
+    };
+    if (m_parallelScans && scans.size() > 1) {
+        QtConcurrent::blockingMap(scans, runScan);
+    } else {
+        std::for_each(scans.begin(), scans.end(), runScan);
+    }
     
-    state.currentTargets.clear();
-    state.detectedTargets = 0;
+    // Merge back in sensor order, whichever scan finished first
+    for (SensorScan& scan : scans) {
+        m_sensorRandom[scan.sensorId] = scan.random;
+        switch (scan.kind) {
+        case SensorScan::Radar: applyRadarScan(scan); break;
+        case SensorScan::RF: applyRFScan(scan); break;
+        case SensorScan::Camera: applyCameraScan(scan); break;
+        }
+    }
+}
+
+void SensorSimulator::scanRadar(SensorScan& scan) const {
+    FastRandom& gen = scan.random;
     
-    GeoPosition radarPos = radar->position();
-    double maxRange = radar->maxRange();
+    // Range and detection probability for every target in one pass each
+    const int count = m_radarTargets.size();
+    QVector<double> ranges;
+    QVector<double> draws(count);
+    m_radarTargets.groundRanges(scan.position, ranges);
+    gen.fillUniform(draws.data(), count, 0.0, 1.0);
+    const double pdScale = m_realisticMode ? m_detectionProbability * (1.0 - m_noiseLevel * 0.5) : 1.0;
     
     // Process injected targets
-    for (const auto& target : m_injectedRadarTargets) {
-        Track temp("temp");
-        temp.setPosition(radarPos);
-        double range = temp.distanceTo(target.position);
-        
-        if (range > maxRange) continue;
+    for (int i = 0; i < count; ++i) {
+        const double range = ranges[i];
+        if (range > scan.maxRange) continue;
+        if (scan.coverage && !scan.coverage->canSee(m_radarTargets.position(i))) continue;
         
         // Calculate detection probability
-        double pd = calculateDetectionProbability(range, maxRange, target.rcs);
+        const double rcs = m_radarTargets.rcs(i);
+        const double pd = calculateDetectionProbability(range, scan.maxRange, rcs) * pdScale;
         
-        if (m_realisticMode) {
-            pd *= m_detectionProbability;
-            pd *= (1.0 - m_noiseLevel * 0.5);
+        if (draws[i] >= pd) {
+            scan.missed++;
+            continue;
         }
         
-        if (gen->generateDouble() < pd) {
-            // Detection successful
-            GeoPosition detectedPos = target.position;
-            VelocityVector detectedVel = target.velocity;
-            
-            // Add measurement noise
-            if (m_realisticMode) {
-                double rangeError = range * 0.01 * (gen->generateDouble() - 0.5);  // 1% range error
-                double azError = 0.5 * (gen->generateDouble() - 0.5);  // 0.5 deg azimuth error
-                
-                detectedPos.latitude += rangeError * 0.00001;
-                detectedPos.longitude += azError * 0.00001;
-                detectedPos.altitude += gen->generateDouble() * 10.0 - 5.0;
-                
-                detectedVel.north += (gen->generateDouble() - 0.5) * 2.0;
-                detectedVel.east += (gen->generateDouble() - 0.5) * 2.0;
-            }
-            
-            double quality = target.trackQuality;
-            if (m_realisticMode) {
-                quality *= (0.9 + gen->generateDouble() * 0.2);
-            }
-            
-            state.currentTargets.append(target);
-            state.detectedTargets++;
+        // Detection successful
+        GeoPosition detectedPos = m_radarTargets.position(i);
+        VelocityVector detectedVel = m_radarTargets.velocity(i);
+        
+        // Add measurement noise
+        if (m_realisticMode) {
+            double rangeError = range * 0.01 * (gen.uniform() - 0.5);  // 1% range error
+            double azError = 0.5 * (gen.uniform() - 0.5);  // 0.5 deg azimuth error
             
-            // Report to track manager
-            m_trackManager->processRadarDetection(detectedPos, detectedVel, quality,
-                                                  QDateTime::currentMSecsSinceEpoch());
+            detectedPos.latitude += rangeError * 0.00001;
+            detectedPos.longitude += azError * 0.00001;
+            detectedPos.altitude += gen.uniform() * 10.0 - 5.0;
             
-            emit radarDetection(radarId, detectedPos, detectedVel, quality);
-            m_stats.radarDetections++;
-            m_stats.totalDetections++;
-        } else {
-            m_stats.missedDetections++;
+            detectedVel.north += (gen.uniform() - 0.5) * 2.0;
+            detectedVel.east += (gen.uniform() - 0.5) * 2.0;
         }
+        
+        double quality = m_radarTargets.quality(i);
+        if (m_realisticMode) {
+            quality *= (0.9 + gen.uniform() * 0.2);
+        }
+        
+        SimulatedRadarTarget target;
+        target.id = m_radarTargets.id(i);
+        target.position = m_radarTargets.position(i);
+        target.velocity = m_radarTargets.velocity(i);
+        target.rcs = rcs;
+        target.trackQuality = m_radarTargets.quality(i);
+        target.lastUpdateTime = m_radarTargetsUpdatedMs;
+        scan.radarTargets.append(target);
+        
+        // Queue for joint association with the rest of this scan
+        SensorDetection plot;
+        plot.sensorId = scan.sensorId;
+        plot.position = detectedPos;
+        plot.velocity = detectedVel;
+        plot.signalStrength = rcs;
+        plot.confidence = quality;
+        plot.timestamp = scan.nowMs;
+        plot.sourceType = DetectionSource::Radar;
+        plot.ingestMonoNs = TimeUtils::monotonicNs();
+        scan.plots.append(plot);
     }
     
-    // Generate clutter
+    // Clutter returns are counted but never reported to the track manager
     if (m_clutterLevel > 0.0) {
-        generateClutter(radarId);
+        scan.clutter = static_cast<int>(m_clutterLevel * 10 * gen.uniform());
     }
-    
-    emit radarStateChanged(radarId, state);
 }
 
-void SensorSimulator::simulateRFScan(const QString& detectorId) {
-    auto* detector = m_rfDetectors.value(detectorId);
-    if (!detector) return;
+void SensorSimulator::applyRadarScan(SensorScan& scan) {
+    RadarSimState& state = m_radarStates[scan.sensorId];
+    state.currentTargets = scan.radarTargets;
+    state.detectedTargets = scan.radarTargets.size();
     
-    RFDetectorSimState& state = m_rfDetectorStates[detectorId];
-    auto* gen = QRandomGenerator::global();
+    for (const SensorDetection& plot : scan.plots) {
+        emit radarDetection(scan.sensorId, plot.position, plot.velocity, plot.confidence);
+    }
+    m_stats.radarDetections += scan.plots.size();
+    m_stats.totalDetections += scan.plots.size();
+    m_stats.missedDetections += scan.missed;
+    
+    // Report the whole scan to the track manager at once
+    if (m_fusionEngine) {
+        m_fusionEngine->submitBatch(scan.plots);
+    } else {
+        m_trackManager->processDetectionBatch(scan.plots);
+    }
     
-    state.currentEmissions.clear();
-    state.detectedEmissions = 0;
+    if (m_clutterLevel > 0.0) {
+        state.clutterReturns = scan.clutter;
+        m_stats.falseAlarms += scan.clutter;
+        emit clutterGenerated(scan.sensorId, scan.clutter);
+    }
     
-    GeoPosition detectorPos = detector->position();
-    double maxRange = detector->maxRange();
+    emit radarStateChanged(scan.sensorId, state);
+}
+
+void SensorSimulator::scanRF(SensorScan& scan) const {
+    FastRandom& gen = scan.random;
     
     // Process injected emissions
     for (const auto& emission : m_injectedRFEmissions) {
         if (!emission.isActive) continue;
         
-        Track temp("temp");
-        temp.setPosition(detectorPos);
-        double range = temp.distanceTo(emission.position);
+        double range = CoordinateUtils::haversineDistance(scan.position, emission.position);
         
-        if (range > maxRange) continue;
+        if (range > scan.maxRange) continue;
         
         // Calculate received signal strength
-        double pathLoss = 32.44 + 20.0 * std::log10(emission.frequencyMHz) + 
+        double pathLoss = 32.44 + 20.0 * std::log10(emission.frequencyMHz) +
                          20.0 * std::log10(range / 1000.0);
         double receivedPower = emission.signalStrengthDbm - pathLoss;
         
         // Check if above noise floor
-        if (receivedPower > state.noiseFloor + 10.0) {
-            state.currentEmissions.append(emission);
-            state.detectedEmissions++;
-            state.identifiedProtocols[emission.sourceId] = emission.protocol;
-            
+        if (receivedPower > scan.noiseFloor + 10.0) {
             // Estimate position (with error)
             GeoPosition estimatedPos = emission.position;
             if (m_realisticMode) {
                 double posError = range * 0.1;  // 10% range error for RF
-                estimatedPos.latitude += posError * 0.00001 * (gen->generateDouble() - 0.5);
-                estimatedPos.longitude += posError * 0.00001 * (gen->generateDouble() - 0.5);
+                estimatedPos.latitude += posError * 0.00001 * (gen.uniform() - 0.5);
+                estimatedPos.longitude += posError * 0.00001 * (gen.uniform() - 0.5);
             }
             
-            // Report to track manager - normalize signal strength to 0-1 range
-            double normalizedSignal = (receivedPower + 100.0) / 100.0;
-            m_trackManager->processRFDetection(estimatedPos, normalizedSignal,
-                                              QDateTime::currentMSecsSinceEpoch());
-            
-            emit rfDetection(detectorId, estimatedPos, emission.frequencyMHz, 
-                           receivedPower, emission.protocol);
-            m_stats.rfDetections++;
-            m_stats.totalDetections++;
+            SensorScan::RFHit hit;
+            hit.emission = emission;
+            hit.estimatedPosition = estimatedPos;
+            hit.normalizedSignal = (receivedPower + 100.0) / 100.0;  // 0-1 for the track manager
+            hit.receivedPower = receivedPower;
+            scan.rfHits.append(hit);
         }
     }
     
-    // Generate RF noise
-    if (m_noiseLevel > 0.0) {
-        generateRFNoise(detectorId);
+    // Occasionally generate a false RF detection
+    if (m_noiseLevel > 0.0 && gen.uniform() < m_noiseLevel * 0.1) {
+        scan.falseAlarms++;
     }
-    
-    emit rfDetectorStateChanged(detectorId, state);
 }
 
-void SensorSimulator::simulateCameraFrame(const QString& cameraId) {
-    auto* camera = m_cameras.value(cameraId);
-    if (!camera) return;
-    
-    CameraSimState& state = m_cameraStates[cameraId];
-    auto* gen = QRandomGenerator::global();
+void SensorSimulator::applyRFScan(SensorScan& scan) {
+    RFDetectorSimState& state = m_rfDetectorStates[scan.sensorId];
+    state.currentEmissions.clear();
+    state.detectedEmissions = scan.rfHits.size();
     
-    state.visibleTargets.clear();
-    state.detectedObjects = 0;
+    for (const SensorScan::RFHit& hit : scan.rfHits) {
+        state.currentEmissions.append(hit.emission);
+        state.identifiedProtocols[hit.emission.sourceId] = hit.emission.protocol;
+        
+        m_trackManager->processRFDetection(hit.estimatedPosition, hit.normalizedSignal, scan.nowMs);
+        
+        emit rfDetection(scan.sensorId, hit.estimatedPosition, hit.emission.frequencyMHz,
+                         hit.receivedPower, hit.emission.protocol, hit.emission.bandwidthMHz);
+    }
+    m_stats.rfDetections += scan.rfHits.size();
+    m_stats.totalDetections += scan.rfHits.size();
+    m_stats.falseAlarms += scan.falseAlarms;
     
-    GeoPosition cameraPos = camera->position();
-    double maxRange = camera->maxRange();
-    double fov = camera->fieldOfView();
-    double azimuth = camera->azimuth();
+    emit rfDetectorStateChanged(scan.sensorId, state);
+}
+
+void SensorSimulator::scanCamera(SensorScan& scan) const {
+    FastRandom& gen = scan.random;
+    const double fov = scan.fieldOfView;
+    const LocalTangentPlane frame(scan.position);
     
     // Process injected visual targets
     for (const auto& target : m_injectedVisualTargets) {
-        Track temp("temp");
-        temp.setPosition(cameraPos);
-        double range = temp.distanceTo(target.position);
+        const EnuVector offset = frame.toEnu(target.position);
+        double range = offset.range();
         
-        if (range > maxRange) continue;
+        if (range > scan.maxRange) continue;
+        if (scan.coverage && !scan.coverage->canSee(target.position)) continue;
         
         // Check if target is in field of view
-        double dLat = target.position.latitude - cameraPos.latitude;
-        double dLon = target.position.longitude - cameraPos.longitude;
-        double northOffset = dLat * 111000.0;
-        double eastOffset = dLon * 111000.0 * std::cos(qDegreesToRadians(cameraPos.latitude));
-        
-        double targetAzimuth = qRadiansToDegrees(std::atan2(eastOffset, northOffset));
-        double azDiff = targetAzimuth - azimuth;
+        double azDiff = offset.azimuthDeg() - scan.azimuth;
         while (azDiff > 180.0) azDiff -= 360.0;
         while (azDiff < -180.0) azDiff += 360.0;
         
@@ -554,51 +704,54 @@ void SensorSimulator::simulateCameraFrame(const QString& cameraId) {
             pd *= (1.0 - m_noiseLevel * 0.3);
         }
         
-        if (gen->generateDouble() < pd) {
+        if (gen.uniform() < pd) {
             // Calculate bounding box (normalized coordinates)
             double boxSize = std::min(0.3, angularSize * 500.0);
             double centerX = 0.5 + azDiff / fov;
             double centerY = 0.5;  // Simplified vertical positioning
             
-            QRectF bbox(centerX - boxSize/2, centerY - boxSize/2, boxSize, boxSize);
-            
-            state.visibleTargets.append(target);
-            state.detectedObjects++;
-            
-            // Report detection
-            double confidence = pd * (0.8 + gen->generateDouble() * 0.2);
-            
-            m_trackManager->processCameraDetection(cameraId, BoundingBox(), target.position,
-                                                   QDateTime::currentMSecsSinceEpoch());
-            
-            emit cameraDetection(cameraId, bbox, target.objectClass, confidence);
-            m_stats.cameraDetections++;
-            m_stats.totalDetections++;
+            SensorScan::CameraHit hit;
+            hit.target = target;
+            hit.boundingBox = QRectF(centerX - boxSize/2, centerY - boxSize/2, boxSize, boxSize);
+            hit.confidence = pd * (0.8 + gen.uniform() * 0.2);
+            scan.cameraHits.append(hit);
         }
     }
+}
+
+void SensorSimulator::applyCameraScan(SensorScan& scan) {
+    CameraSimState& state = m_cameraStates[scan.sensorId];
+    state.visibleTargets.clear();
+    state.detectedObjects = scan.cameraHits.size();
+    
+    for (const SensorScan::CameraHit& hit : scan.cameraHits) {
+        state.visibleTargets.append(hit.target);
+        
+        m_trackManager->processCameraDetection(scan.sensorId, BoundingBox(), hit.target.position,
+                                               scan.nowMs);
+        
+        emit cameraDetection(scan.sensorId, hit.boundingBox, hit.target.objectClass, hit.confidence);
+    }
+    m_stats.cameraDetections += scan.cameraHits.size();
+    m_stats.totalDetections += scan.cameraHits.size();
     
-    emit cameraStateChanged(cameraId, state);
+    emit cameraStateChanged(scan.sensorId, state);
 }
 
 GeoPosition SensorSimulator::generateRandomTargetPosition(double minRange, double maxRange) {
-    auto* gen = QRandomGenerator::global();
+    auto* gen = &m_random;
     
-    double range = minRange + gen->generateDouble() * (maxRange - minRange);
-    double bearing = gen->generateDouble() * 360.0;
+    double range = minRange + gen->uniform() * (maxRange - minRange);
+    double bearing = gen->uniform() * 360.0;
     double bearingRad = qDegreesToRadians(bearing);
     
-    GeoPosition pos;
-    pos.latitude = m_basePosition.latitude + (range * std::cos(bearingRad)) / 111000.0;
-    pos.longitude = m_basePosition.longitude + 
-                   (range * std::sin(bearingRad)) / 
-                   (111000.0 * std::cos(qDegreesToRadians(m_basePosition.latitude)));
-    pos.altitude = m_basePosition.altitude + 50.0 + gen->generateDouble() * 200.0;
-    
-    return pos;
+    return LocalTangentPlane(m_basePosition).toGeoLinear(
+        EnuVector{range * std::sin(bearingRad), range * std::cos(bearingRad),
+                  50.0 + gen->uniform() * 200.0});
 }
 
 VelocityVector SensorSimulator::generateTargetVelocity(const GeoPosition& pos, double speed) {
-    auto* gen = QRandomGenerator::global();
+    auto* gen = &m_random;
     
     // Calculate bearing toward base
     double dLat = m_basePosition.latitude - pos.latitude;
@@ -606,13 +759,13 @@ VelocityVector SensorSimulator::generateTargetVelocity(const GeoPosition& pos, d
     double bearing = qRadiansToDegrees(std::atan2(dLon, dLat));
     
     // Add some randomness to heading
-    bearing += (gen->generateDouble() * 40.0 - 20.0);
+    bearing += (gen->uniform() * 40.0 - 20.0);
     double bearingRad = qDegreesToRadians(bearing);
     
     VelocityVector vel;
     vel.north = speed * std::cos(bearingRad);
     vel.east = speed * std::sin(bearingRad);
-    vel.down = gen->generateDouble() * 2.0 - 1.0;
+    vel.down = gen->uniform() * 2.0 - 1.0;
     
     return vel;
 }
@@ -625,51 +778,18 @@ double SensorSimulator::calculateDetectionProbability(double range, double maxRa
     return qBound(0.0, rangeFactor * rcsFactor, 1.0);
 }
 
-void SensorSimulator::generateClutter(const QString& radarId) {
-    auto* gen = QRandomGenerator::global();
-    int clutterCount = static_cast<int>(m_clutterLevel * 10 * gen->generateDouble());
-    
-    RadarSimState& state = m_radarStates[radarId];
-    state.clutterReturns = clutterCount;
-    
-    for (int i = 0; i < clutterCount; i++) {
-        // Generate clutter at random positions (but not report to track manager)
-        GeoPosition clutterPos = generateRandomTargetPosition(100, 3000);
-        
-        SimulatedRadarTarget clutter;
-        clutter.id = QString("CLUTTER-%1").arg(i);
-        clutter.position = clutterPos;
-        clutter.rcs = 0.01;  // Small RCS
-        clutter.isClutter = true;
-        
-        // Clutter doesn't get reported to track manager
-        m_stats.falseAlarms++;
-    }
-    
-    emit clutterGenerated(radarId, clutterCount);
-}
-
-void SensorSimulator::generateRFNoise(const QString& detectorId) {
-    auto* gen = QRandomGenerator::global();
-    
-    // Occasionally generate a false RF detection
-    if (gen->generateDouble() < m_noiseLevel * 0.1) {
-        m_stats.falseAlarms++;
-    }
-}
-
 SimulatedRadarTarget SensorSimulator::createDroneTarget() {
-    auto* gen = QRandomGenerator::global();
+    auto* gen = &m_random;
     
     SimulatedRadarTarget target;
     target.id = QString("TGT-%1").arg(m_nextTargetId++, 4, 10, QChar('0'));
     target.position = generateRandomTargetPosition(1500, 3000);
     
-    double speed = 8.0 + gen->generateDouble() * 15.0;
+    double speed = 8.0 + gen->uniform() * 15.0;
     target.velocity = generateTargetVelocity(target.position, speed);
     
-    target.rcs = 0.05 + gen->generateDouble() * 0.15;  // 0.05-0.2 m²
-    target.trackQuality = 0.8 + gen->generateDouble() * 0.2;
+    target.rcs = 0.05 + gen->uniform() * 0.15;  // 0.05-0.2 m²
+    target.trackQuality = 0.8 + gen->uniform() * 0.2;
     target.isClutter = false;
     target.lastUpdateTime = QDateTime::currentMSecsSinceEpoch();
     
@@ -677,7 +797,7 @@ SimulatedRadarTarget SensorSimulator::createDroneTarget() {
 }
 
 SimulatedRFEmission SensorSimulator::createDroneEmission(const GeoPosition& pos) {
-    auto* gen = QRandomGenerator::global();
+    auto* gen = &m_random;
     
     SimulatedRFEmission emission;
     emission.sourceId = "";  // Will be set by caller
@@ -687,8 +807,8 @@ SimulatedRFEmission SensorSimulator::createDroneEmission(const GeoPosition& pos)
     QList<double> frequencies = {2400.0, 2450.0, 5200.0, 5500.0, 5800.0};
     emission.frequencyMHz = frequencies[gen->bounded(frequencies.size())];
     
-    emission.signalStrengthDbm = -50.0 - gen->generateDouble() * 20.0;
-    emission.bandwidthMHz = 10.0 + gen->generateDouble() * 30.0;
+    emission.signalStrengthDbm = -50.0 - gen->uniform() * 20.0;
+    emission.bandwidthMHz = 10.0 + gen->uniform() * 30.0;
     
     // Common protocols
     QList<QString> protocols = {"DJI_OcuSync", "DJI_Lightbridge", "FrSky", "Generic_2.4GHz"};
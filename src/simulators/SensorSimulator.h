@@ -17,13 +17,17 @@
 #include <QList>
 #include "core/Track.h"
 #include "sensors/SensorInterface.h"
+#include "simulators/TargetSwarm.h"
+#include "utils/FastRandom.h"
 
 namespace CounterUAS {
 
 class TrackManager;
+class FusionEngine;
 class RadarSensor;
 class RFDetector;
 class CameraSystem;
+class CoverageService;
 
 /**
  * @brief Simulated radar target for radar sensor
@@ -116,6 +120,9 @@ public:
     void setTrackManager(TrackManager* manager);
     TrackManager* trackManager() const { return m_trackManager; }
     
+    // Radar scans go through the engine's queue instead of straight to the manager
+    void setFusionEngine(FusionEngine* engine) { m_fusionEngine = engine; }
+    
     // Simulation control
     void start();
     void stop();
@@ -141,6 +148,17 @@ public:
     void setDetectionProbability(double prob) { m_detectionProbability = qBound(0.0, prob, 1.0); }
     double detectionProbability() const { return m_detectionProbability; }
     
+    // Same seed, same targets, detections and noise, serial or parallel
+    void setSeed(quint64 seed);
+    quint64 seed() const { return m_seed; }
+    
+    // Scan each sensor as its own task on the global thread pool
+    void setParallelScans(bool enable) { m_parallelScans = enable; }
+    bool parallelScans() const { return m_parallelScans; }
+    
+    // Radar and camera targets behind terrain go undetected; null for none
+    void setCoverageService(const CoverageService* coverage) { m_coverage = coverage; }
+    
     // Sensor registration
     void registerRadar(RadarSensor* radar);
     void registerRFDetector(RFDetector* detector);
@@ -156,6 +174,7 @@ public:
     
     // Target injection (for testing)
     void injectRadarTarget(const SimulatedRadarTarget& target);
+    int radarTargetCount() const { return m_radarTargets.size(); }
     void injectRFEmission(const SimulatedRFEmission& emission);
     void injectVisualTarget(const SimulatedVisualTarget& target);
     
@@ -185,7 +204,8 @@ signals:
     void radarDetection(const QString& sensorId, const GeoPosition& pos, 
                        const VelocityVector& vel, double quality);
     void rfDetection(const QString& sensorId, const GeoPosition& pos,
-                    double frequencyMHz, double signalDbm, const QString& protocol);
+                    double frequencyMHz, double signalDbm, const QString& protocol,
+                    double bandwidthMHz);
     void cameraDetection(const QString& sensorId, const QRectF& boundingBox,
                         const QString& objectClass, double confidence);
     
@@ -205,26 +225,37 @@ private:
     void updateRFDetectorSimulation();
     void updateCameraSimulation();
     
-    void simulateRadarScan(const QString& radarId);
-    void simulateRFScan(const QString& detectorId);
-    void simulateCameraFrame(const QString& cameraId);
+    // One sensor's scan: inputs copied on the GUI thread, results applied back on it
+    struct SensorScan;
+    void runSensorScans();
+    void scanRadar(SensorScan& scan) const;
+    void scanRF(SensorScan& scan) const;
+    void scanCamera(SensorScan& scan) const;
+    void applyRadarScan(SensorScan& scan);
+    void applyRFScan(SensorScan& scan);
+    void applyCameraScan(SensorScan& scan);
+    
+    void addSensorStream(const QString& sensorId);
     
     GeoPosition generateRandomTargetPosition(double minRange, double maxRange);
     VelocityVector generateTargetVelocity(const GeoPosition& pos, double speed);
-    double calculateDetectionProbability(double range, double maxRange, double rcs);
-    
-    void generateClutter(const QString& radarId);
-    void generateRFNoise(const QString& detectorId);
+    static double calculateDetectionProbability(double range, double maxRange, double rcs);
     
     SimulatedRadarTarget createDroneTarget();
     SimulatedRFEmission createDroneEmission(const GeoPosition& pos);
     
     TrackManager* m_trackManager = nullptr;
+    FusionEngine* m_fusionEngine = nullptr;
+    const CoverageService* m_coverage = nullptr;
     
     QTimer* m_updateTimer;
     QTimer* m_detectionTimer;
+    quint64 m_seed;
+    FastRandom m_random;                // Spawning and drift; stream 1 of m_seed
+    QHash<QString, FastRandom> m_sensorRandom;  // One stream per sensor
     int m_updateRateHz = 10;
     bool m_running = false;
+    bool m_parallelScans = false;
     
     GeoPosition m_basePosition;
     
@@ -245,7 +276,10 @@ private:
     QHash<QString, CameraSimState> m_cameraStates;
     
     // Injected targets
-    QList<SimulatedRadarTarget> m_injectedRadarTargets;
+    TargetSwarm m_radarTargets;
+    qint64 m_radarTargetsUpdatedMs = 0;
+    QVector<double> m_ranges;           // Per-target scratch for the range cull
+    QVector<quint8> m_keep;
     QList<SimulatedRFEmission> m_injectedRFEmissions;
     QList<SimulatedVisualTarget> m_injectedVisualTargets;
     
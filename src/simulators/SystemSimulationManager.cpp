@@ -8,9 +8,12 @@
 #include "simulators/SensorSimulator.h"
 #include "simulators/EffectorSimulator.h"
 #include "simulators/VideoSimulator.h"
+#include "simulators/RaidScript.h"
 #include "core/TrackManager.h"
 #include "core/ThreatAssessor.h"
 #include "core/EngagementManager.h"
+#include "core/CoverageService.h"
+#include "core/SensorResourceManager.h"
 #include "video/VideoStreamManager.h"
 #include "sensors/RadarSensor.h"
 #include "sensors/RFDetector.h"
@@ -19,10 +22,14 @@
 #include "effectors/KineticInterceptor.h"
 #include "effectors/DirectedEnergySystem.h"
 #include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QDateTime>
+#include <QtMath>
 
 namespace CounterUAS {
 
@@ -45,6 +52,9 @@ QJsonObject SimulationScenario::toJson() const {
     obj["minThreatLevel"] = minThreatLevel;
     obj["maxThreatLevel"] = maxThreatLevel;
     obj["hostileProbability"] = hostileProbability;
+    obj["seed"] = QString::number(seed);  // A JSON number would lose the low bits
+    obj["parallelSensorScans"] = parallelSensorScans;
+    if (!raidScript.isEmpty()) obj["raidScript"] = raidScript;
     return obj;
 }
 
@@ -67,6 +77,9 @@ SimulationScenario SimulationScenario::fromJson(const QJsonObject& obj) {
     s.minThreatLevel = obj["minThreatLevel"].toInt(1);
     s.maxThreatLevel = obj["maxThreatLevel"].toInt(5);
     s.hostileProbability = obj["hostileProbability"].toDouble(0.7);
+    s.seed = obj["seed"].toVariant().toULongLong();
+    s.parallelSensorScans = obj["parallelSensorScans"].toBool(false);
+    s.raidScript = obj["raidScript"].toString();
     return s;
 }
 
@@ -86,6 +99,11 @@ SystemSimulationManager::SystemSimulationManager(QObject* parent)
     m_statsTimer->setInterval(1000);  // Update stats every second
     connect(m_statsTimer, &QTimer::timeout, this, &SystemSimulationManager::updateStatistics);
     
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_elapsedMetric = registry.gauge("cuas_simulation_elapsed_seconds", "Time since the simulation started");
+    m_spawnedMetric = registry.counter("cuas_simulation_targets_spawned_total", "Simulated targets spawned");
+    m_detectionsMetric = registry.counter("cuas_simulation_detections_total", "Simulated sensor detections");
+    
     // Load default scenario
     loadDefaultScenario();
 }
@@ -125,6 +143,13 @@ void SystemSimulationManager::setVideoManager(VideoStreamManager* manager) {
     }
 }
 
+void SystemSimulationManager::setCoverageService(CoverageService* coverage) {
+    m_coverage = coverage;
+    if (m_sensorSimulator) {
+        m_sensorSimulator->setCoverageService(coverage);
+    }
+}
+
 void SystemSimulationManager::initializeSimulators() {
     if (!m_trackManager) return;
     
@@ -138,6 +163,7 @@ void SystemSimulationManager::initializeSimulators() {
     if (!m_sensorSimulator) {
         m_sensorSimulator = new SensorSimulator(m_trackManager, this);
         m_sensorSimulator->setBasePosition(m_basePosition);
+        m_sensorSimulator->setCoverageService(m_coverage);
     }
     
     // Create effector simulator
@@ -163,6 +189,20 @@ void SystemSimulationManager::connectSignals() {
         connect(m_trackManager, &TrackManager::trackDropped,
                 this, &SystemSimulationManager::onTrackDropped);
     }
+    
+    // Detected emissions feed the jamming channel plan
+    if (m_sensorSimulator) {
+        connect(m_sensorSimulator, &SensorSimulator::rfDetection, this,
+                [this](const QString&, const GeoPosition&, double frequencyMHz, double,
+                       const QString& protocol, double bandwidthMHz) {
+            if (!m_engagementManager) return;
+            JamEmission emission;
+            emission.emissionId = QString("%1@%2").arg(protocol).arg(qRound(frequencyMHz));
+            emission.centerMHz = frequencyMHz;
+            emission.bandwidthMHz = bandwidthMHz;
+            m_engagementManager->reportEmission(emission);
+        });
+    }
 }
 
 void SystemSimulationManager::start() {
@@ -178,16 +218,26 @@ void SystemSimulationManager::start() {
     if (m_sensorSimulator) {
         m_sensorSimulator->setClutterLevel(m_scenario.clutterLevel);
         m_sensorSimulator->setNoiseLevel(m_scenario.noiseLevel);
+        m_sensorSimulator->setParallelScans(m_scenario.parallelSensorScans);
+        if (m_scenario.seed != 0) m_sensorSimulator->setSeed(m_scenario.seed);
     }
     
     if (m_effectorSimulator) {
         m_effectorSimulator->setWeatherFactor(m_scenario.weatherFactor);
+        m_effectorSimulator->setTimeScale(m_timeScale);
+        if (m_scenario.seed != 0) m_effectorSimulator->setSeed(m_scenario.seed);
     }
     
     // Configure track simulator with scenario settings
     if (m_trackSimulator) {
         m_trackSimulator->setMaxTargets(m_scenario.maxTargets);
-        m_trackSimulator->setAutoSpawnEnabled(m_autoSpawnTargets);
+        if (m_scenario.seed != 0) m_trackSimulator->setSeed(m_scenario.seed);
+        
+        // A raid script replaces spawning and plays from its start each run
+        const bool scripted = !m_scenario.raidScript.isEmpty() &&
+                              m_trackSimulator->loadScript(m_scenario.raidScript);
+        if (!scripted) m_trackSimulator->unloadScript();
+        m_trackSimulator->setAutoSpawnEnabled(m_autoSpawnTargets && !scripted);
         // Convert spawn rate to interval (targets/sec -> msec between spawns)
         if (m_scenario.threatSpawnRate > 0) {
             int intervalMs = static_cast<int>(1000.0 / m_scenario.threatSpawnRate);
@@ -266,6 +316,7 @@ void SystemSimulationManager::reset() {
     // This prevents the track simulator from updating deleted tracks
     if (m_trackSimulator) {
         m_trackSimulator->clearTargets();
+        m_trackSimulator->unloadScript();
     }
     
     // Clear sensor simulator injected targets
@@ -322,6 +373,7 @@ void SystemSimulationManager::reset() {
 
 void SystemSimulationManager::setTimeScale(double scale) {
     m_timeScale = qBound(0.1, scale, 10.0);
+    if (m_effectorSimulator) m_effectorSimulator->setTimeScale(m_timeScale);
 }
 
 qint64 SystemSimulationManager::simulationTime() const {
@@ -338,8 +390,27 @@ void SystemSimulationManager::loadScenario(const QString& scenarioPath) {
         return;
     }
     
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    m_scenario = SimulationScenario::fromJson(doc.object());
+    if (RaidScriptReader::isRaidScript(scenarioPath)) {
+        // A bare raid script: its header is the scenario
+        RaidScriptReader script;
+        if (!script.open(scenarioPath)) {
+            emit error("Failed to read raid script " + scenarioPath + ": " + script.errorString());
+            return;
+        }
+        const RaidScriptHeader header = script.header();
+        m_scenario = SimulationScenario();
+        m_scenario.name = header.name;
+        m_scenario.description = header.description;
+        m_scenario.basePosition = header.basePosition;
+        m_scenario.durationMinutes = qCeil(header.durationSec / 60.0);
+        m_scenario.raidScript = scenarioPath;
+    } else {
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        m_scenario = SimulationScenario::fromJson(doc.object());
+        if (!m_scenario.raidScript.isEmpty()) {
+            m_scenario.raidScript = QFileInfo(scenarioPath).dir().absoluteFilePath(m_scenario.raidScript);
+        }
+    }
     m_basePosition = m_scenario.basePosition;
     
     if (m_trackSimulator) m_trackSimulator->setBasePosition(m_basePosition);
@@ -463,18 +534,38 @@ void SystemSimulationManager::registerRadar(RadarSensor* radar) {
     if (m_sensorSimulator) {
         m_sensorSimulator->registerRadar(radar);
     }
+    if (m_coverage) {
+        radar->setTerrain(m_coverage->terrain());
+        m_coverage->addSensor(radar);
+    }
+    if (m_sensorTasking) {
+        m_sensorTasking->addSensor(radar);
+    }
 }
 
 void SystemSimulationManager::registerRFDetector(RFDetector* detector) {
     if (m_sensorSimulator) {
         m_sensorSimulator->registerRFDetector(detector);
     }
+    if (m_coverage) {
+        m_coverage->addSensor(detector);
+    }
+    if (m_sensorTasking) {
+        m_sensorTasking->addSensor(detector);
+    }
 }
 
 void SystemSimulationManager::registerCamera(CameraSystem* camera) {
     if (m_sensorSimulator) {
         m_sensorSimulator->registerCamera(camera);
     }
+    if (m_coverage) {
+        camera->setTerrain(m_coverage->terrain());
+        m_coverage->addSensor(camera);
+    }
+    if (m_sensorTasking) {
+        m_sensorTasking->addSensor(camera);
+    }
 }
 
 void SystemSimulationManager::registerRFJammer(RFJammer* jammer) {
@@ -484,6 +575,9 @@ void SystemSimulationManager::registerRFJammer(RFJammer* jammer) {
     if (m_engagementManager) {
         m_engagementManager->registerEffector(jammer);
     }
+    if (m_coverage) {
+        m_coverage->addEffector(jammer);
+    }
 }
 
 void SystemSimulationManager::registerKineticInterceptor(KineticInterceptor* interceptor) {
@@ -493,6 +587,9 @@ void SystemSimulationManager::registerKineticInterceptor(KineticInterceptor* int
     if (m_engagementManager) {
         m_engagementManager->registerEffector(interceptor);
     }
+    if (m_coverage) {
+        m_coverage->addEffector(interceptor);
+    }
 }
 
 void SystemSimulationManager::registerDirectedEnergy(DirectedEnergySystem* de) {
@@ -502,6 +599,9 @@ void SystemSimulationManager::registerDirectedEnergy(DirectedEnergySystem* de) {
     if (m_engagementManager) {
         m_engagementManager->registerEffector(de);
     }
+    if (m_coverage) {
+        m_coverage->addEffector(de);
+    }
 }
 
 void SystemSimulationManager::createDefaultSensors() {
@@ -687,6 +787,10 @@ void SystemSimulationManager::updateStatistics() {
         m_stats.sensorDetections = sensorStats.totalDetections;
     }
     
+    m_elapsedMetric->set(m_stats.elapsedMs / 1000.0);
+    m_spawnedMetric->setTotal(static_cast<quint64>(m_stats.totalTargetsSpawned));
+    m_detectionsMetric->setTotal(static_cast<quint64>(m_stats.sensorDetections));
+    
     emit statisticsUpdated(m_stats);
 }
 
@@ -29,6 +29,8 @@ class SensorSimulator;
 class EffectorSimulator;
 class VideoSimulator;
 class VideoStreamManager;
+class CoverageService;
+class SensorResourceManager;
 
 // Forward declarations for sensor/effector types
 class RadarSensor;
@@ -37,6 +39,8 @@ class CameraSystem;
 class RFJammer;
 class KineticInterceptor;
 class DirectedEnergySystem;
+class MetricCounter;
+class MetricGauge;
 
 /**
  * @brief Scenario configuration
@@ -66,6 +70,13 @@ struct SimulationScenario {
     int maxThreatLevel = 5;
     double hostileProbability = 0.7;
     
+    // Reproducibility; seed 0 draws a fresh one each run
+    quint64 seed = 0;
+    bool parallelSensorScans = false;
+    
+    // Raid script to play instead of auto-spawning; relative to the scenario file
+    QString raidScript;
+    
     QJsonObject toJson() const;
     static SimulationScenario fromJson(const QJsonObject& obj);
 };
@@ -101,6 +112,11 @@ public:
     void setThreatAssessor(ThreatAssessor* assessor);
     void setEngagementManager(EngagementManager* manager);
     void setVideoManager(VideoStreamManager* manager);
+    // Registered sensors and effectors get terrain-masked coverage, and
+    // radars its terrain for their plot altitudes
+    void setCoverageService(CoverageService* coverage);
+    // Registered radars, RF detectors and cameras are tasked by it
+    void setSensorResourceManager(SensorResourceManager* manager) { m_sensorTasking = manager; }
     
     TrackManager* trackManager() const { return m_trackManager; }
     ThreatAssessor* threatAssessor() const { return m_threatAssessor; }
@@ -200,6 +216,8 @@ private:
     ThreatAssessor* m_threatAssessor = nullptr;
     EngagementManager* m_engagementManager = nullptr;
     VideoStreamManager* m_videoManager = nullptr;
+    CoverageService* m_coverage = nullptr;
+    SensorResourceManager* m_sensorTasking = nullptr;
     
     // Simulators
     TrackSimulator* m_trackSimulator = nullptr;
@@ -234,6 +252,11 @@ private:
     
     QTimer* m_updateTimer;
     QTimer* m_statsTimer;
+    
+    // Fleet monitoring series, refreshed with the statistics
+    MetricGauge* m_elapsedMetric = nullptr;
+    MetricCounter* m_spawnedMetric = nullptr;
+    MetricCounter* m_detectionsMetric = nullptr;
 };
 
 } // namespace CounterUAS
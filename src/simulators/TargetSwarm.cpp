@@ -0,0 +1,186 @@
+#include "simulators/TargetSwarm.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/FastRandom.h"
+#include <cmath>
+
+namespace CounterUAS {
+
+TargetSwarm::TargetSwarm(const GeoPosition& origin)
+    : m_origin(origin)
+    , m_metresPerDegLon(CoordinateUtils::degToMeterLon(origin.latitude))
+{
+}
+
+void TargetSwarm::setOrigin(const GeoPosition& origin) {
+    const double dNorth = (m_origin.latitude - origin.latitude) * CoordinateUtils::DEG_TO_M_LAT;
+    const double oldMetresPerDegLon = m_metresPerDegLon;
+    const double oldLongitude = m_origin.longitude;
+
+    m_origin = origin;
+    m_metresPerDegLon = CoordinateUtils::degToMeterLon(origin.latitude);
+
+    const int count = size();
+    double* north = m_north.data();
+    double* east = m_east.data();
+    for (int i = 0; i < count; ++i) {
+        north[i] += dNorth;
+        const double longitude = oldLongitude + east[i] / oldMetresPerDegLon;
+        east[i] = toEast(longitude);
+    }
+}
+
+void TargetSwarm::reserve(int count) {
+    m_id.reserve(count);
+    m_serial.reserve(count);
+    m_north.reserve(count);
+    m_east.reserve(count);
+    m_altitude.reserve(count);
+    m_velNorth.reserve(count);
+    m_velEast.reserve(count);
+    m_velDown.reserve(count);
+    m_rcs.reserve(count);
+    m_quality.reserve(count);
+    m_classification.reserve(count);
+}
+
+void TargetSwarm::clear() {
+    m_id.clear();
+    m_serial.clear();
+    m_north.clear();
+    m_east.clear();
+    m_altitude.clear();
+    m_velNorth.clear();
+    m_velEast.clear();
+    m_velDown.clear();
+    m_rcs.clear();
+    m_quality.clear();
+    m_classification.clear();
+}
+
+int TargetSwarm::add(const QString& id, const GeoPosition& position, const VelocityVector& velocity,
+                     double rcs, double quality, TrackClassification classification) {
+    m_id.append(id);
+    m_serial.append(m_nextSerial++);
+    m_north.append(toNorth(position.latitude));
+    m_east.append(toEast(position.longitude));
+    m_altitude.append(position.altitude);
+    m_velNorth.append(velocity.north);
+    m_velEast.append(velocity.east);
+    m_velDown.append(velocity.down);
+    m_rcs.append(static_cast<float>(rcs));
+    m_quality.append(static_cast<float>(quality));
+    m_classification.append(static_cast<quint8>(classification));
+    return m_id.size() - 1;
+}
+
+void TargetSwarm::propagate(double dtSec) {
+    const int count = size();
+    double* north = m_north.data();
+    double* east = m_east.data();
+    double* altitude = m_altitude.data();
+    const double* velNorth = m_velNorth.constData();
+    const double* velEast = m_velEast.constData();
+    const double* velDown = m_velDown.constData();
+    for (int i = 0; i < count; ++i) {
+        north[i] += velNorth[i] * dtSec;
+        east[i] += velEast[i] * dtSec;
+        altitude[i] -= velDown[i] * dtSec;
+    }
+}
+
+void TargetSwarm::jitter(FastRandom& random, double northHalfWidthM, double eastHalfWidthM) {
+    const int count = size();
+    m_scratch.resize(count * 2);
+    random.fillUniform(m_scratch.data(), count * 2, -1.0, 1.0);
+
+    const double* noise = m_scratch.constData();
+    double* north = m_north.data();
+    double* east = m_east.data();
+    for (int i = 0; i < count; ++i) {
+        north[i] += noise[2 * i] * northHalfWidthM;
+        east[i] += noise[2 * i + 1] * eastHalfWidthM;
+    }
+}
+
+void TargetSwarm::groundRanges(const GeoPosition& point, QVector<double>& rangesM) const {
+    const int count = size();
+    rangesM.resize(count);
+
+    const double pointNorth = toNorth(point.latitude);
+    const double pointEast = toEast(point.longitude);
+    const double* north = m_north.constData();
+    const double* east = m_east.constData();
+    double* out = rangesM.data();
+    for (int i = 0; i < count; ++i) {
+        const double dn = north[i] - pointNorth;
+        const double de = east[i] - pointEast;
+        out[i] = std::sqrt(dn * dn + de * de);
+    }
+}
+
+QStringList TargetSwarm::compact(const QVector<quint8>& keep) {
+    Q_ASSERT(keep.size() == size());
+    QStringList removed;
+    const int count = size();
+    int out = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!keep[i]) {
+            removed.append(m_id[i]);
+            continue;
+        }
+        if (out != i) {
+            m_id[out] = std::move(m_id[i]);
+            m_serial[out] = m_serial[i];
+            m_north[out] = m_north[i];
+            m_east[out] = m_east[i];
+            m_altitude[out] = m_altitude[i];
+            m_velNorth[out] = m_velNorth[i];
+            m_velEast[out] = m_velEast[i];
+            m_velDown[out] = m_velDown[i];
+            m_rcs[out] = m_rcs[i];
+            m_quality[out] = m_quality[i];
+            m_classification[out] = m_classification[i];
+        }
+        ++out;
+    }
+    if (out == count) return removed;
+
+    m_id.resize(out);
+    m_serial.resize(out);
+    m_north.resize(out);
+    m_east.resize(out);
+    m_altitude.resize(out);
+    m_velNorth.resize(out);
+    m_velEast.resize(out);
+    m_velDown.resize(out);
+    m_rcs.resize(out);
+    m_quality.resize(out);
+    m_classification.resize(out);
+    return removed;
+}
+
+GeoPosition TargetSwarm::position(int row) const {
+    GeoPosition pos;
+    pos.latitude = m_origin.latitude + m_north[row] / CoordinateUtils::DEG_TO_M_LAT;
+    pos.longitude = m_origin.longitude + m_east[row] / m_metresPerDegLon;
+    pos.altitude = m_altitude[row];
+    return pos;
+}
+
+VelocityVector TargetSwarm::velocity(int row) const {
+    VelocityVector vel;
+    vel.north = m_velNorth[row];
+    vel.east = m_velEast[row];
+    vel.down = m_velDown[row];
+    return vel;
+}
+
+double TargetSwarm::toNorth(double latitude) const {
+    return (latitude - m_origin.latitude) * CoordinateUtils::DEG_TO_M_LAT;
+}
+
+double TargetSwarm::toEast(double longitude) const {
+    return (longitude - m_origin.longitude) * m_metresPerDegLon;
+}
+
+} // namespace CounterUAS
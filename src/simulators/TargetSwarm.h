@@ -0,0 +1,91 @@
+#ifndef TARGETSWARM_H
+#define TARGETSWARM_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+class FastRandom;
+
+/**
+ * @brief Structure-of-arrays store of simulated targets
+ *
+ * Positions are kept in metres north and east of an origin (the simulated
+ * site) rather than in degrees, so propagation is three multiply-adds per
+ * target with no trig, and range from any point is one hypot. Each kernel
+ * is a single pass over contiguous columns the compiler can vectorise;
+ * degrees are only computed for the targets a caller reports. The flat
+ * earth is the same approximation the simulators always made, and is good
+ * to well under a metre over their 5 km.
+ *
+ * Row order is insertion order and survives compact(). Each row also has
+ * a serial, unique for the swarm's lifetime where ids need not be, which
+ * is what scoring against truth keys targets by. Not thread-safe.
+ */
+class TargetSwarm {
+public:
+    explicit TargetSwarm(const GeoPosition& origin = GeoPosition());
+
+    // Re-expresses the current targets in the new frame
+    void setOrigin(const GeoPosition& origin);
+    GeoPosition origin() const { return m_origin; }
+
+    int size() const { return m_id.size(); }
+    bool isEmpty() const { return m_id.isEmpty(); }
+    void reserve(int count);
+    void clear();
+
+    // Returns the new row; its serial is the next one
+    int add(const QString& id, const GeoPosition& position, const VelocityVector& velocity,
+            double rcs = 0.1, double quality = 0.9,
+            TrackClassification classification = TrackClassification::Pending);
+
+    // Batch kernels
+    void propagate(double dtSec);
+    // Uniform noise of up to the given half-widths on every horizontal position
+    void jitter(FastRandom& random, double northHalfWidthM, double eastHalfWidthM);
+    // Ground range of every row from point, resized to size()
+    void groundRanges(const GeoPosition& point, QVector<double>& rangesM) const;
+
+    // Removes the rows whose keep flag (one per row) is 0; returns their ids
+    QStringList compact(const QVector<quint8>& keep);
+
+    // Row access
+    QString id(int row) const { return m_id[row]; }
+    quint64 serial(int row) const { return m_serial[row]; }
+    GeoPosition position(int row) const;
+    VelocityVector velocity(int row) const;
+    double rcs(int row) const { return m_rcs[row]; }
+    double quality(int row) const { return m_quality[row]; }
+    TrackClassification classification(int row) const {
+        return static_cast<TrackClassification>(m_classification[row]);
+    }
+
+private:
+    double toNorth(double latitude) const;
+    double toEast(double longitude) const;
+
+    GeoPosition m_origin;
+    double m_metresPerDegLon;
+
+    QVector<QString> m_id;
+    QVector<quint64> m_serial;
+    quint64 m_nextSerial = 1;           // Not reset by clear()
+    QVector<double> m_north;            // Metres from the origin
+    QVector<double> m_east;
+    QVector<double> m_altitude;
+    QVector<double> m_velNorth;
+    QVector<double> m_velEast;
+    QVector<double> m_velDown;
+    QVector<float> m_rcs;
+    QVector<float> m_quality;
+    QVector<quint8> m_classification;
+    QVector<double> m_scratch;          // jitter()'s random draws
+};
+
+} // namespace CounterUAS
+
+#endif // TARGETSWARM_H
@@ -1,16 +1,21 @@
 #include "simulators/TrackSimulator.h"
 #include "core/TrackManager.h"
-#include <QRandomGenerator>
+#include "utils/Clock.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/LocalTangentPlane.h"
+#include "utils/Logger.h"
 #include <QtMath>
 
 namespace CounterUAS {
 
 TrackSimulator::TrackSimulator(TrackManager* manager, QObject* parent)
-    : QObject(parent), m_trackManager(manager),
+    : QObject(parent), m_trackManager(manager), m_clock(Clock::system()),
+      m_random(FastRandom::entropySeed()), m_sensorId("SIM-RADAR"),
       m_updateTimer(new QTimer(this)), m_spawnTimer(new QTimer(this)) {
     m_basePosition.latitude = 34.0522;
     m_basePosition.longitude = -118.2437;
     m_basePosition.altitude = 100.0;
+    m_swarm.setOrigin(m_basePosition);
     
     connect(m_updateTimer, &QTimer::timeout, this, &TrackSimulator::updateTargets);
     connect(m_spawnTimer, &QTimer::timeout, this, &TrackSimulator::spawnTarget);
@@ -29,6 +34,10 @@ void TrackSimulator::stop() {
     m_spawnTimer->stop();
 }
 
+void TrackSimulator::setClock(const Clock* clock) {
+    m_clock = clock ? clock : Clock::system();
+}
+
 void TrackSimulator::setAutoSpawnEnabled(bool enabled) {
     m_autoSpawnEnabled = enabled;
     if (m_updateTimer->isActive()) {
@@ -47,37 +56,95 @@ void TrackSimulator::setSpawnInterval(int msec) {
     }
 }
 
+void TrackSimulator::setBasePosition(const GeoPosition& pos) {
+    m_basePosition = pos;
+    m_swarm.setOrigin(pos);
+}
+
 void TrackSimulator::addTarget(const SimulatedTarget& target) {
-    if (m_targets.size() >= m_maxTargets) return;
-    m_targets.append(target);
+    if (m_swarm.size() >= m_maxTargets) return;
+    m_swarm.add(target.id, target.position, target.velocity, 0.1, 0.9, target.classification);
     emit targetInjected(target.id, target.position);
 }
 
 void TrackSimulator::clearTargets() {
-    for (const auto& target : m_targets) {
+    for (int i = 0; i < m_swarm.size(); ++i) {
+        emit targetRemoved(m_swarm.id(i));
+    }
+    m_swarm.clear();
+    for (const ScriptedTarget& target : m_scripted) {
+        emit targetRemoved(target.id);
+    }
+    m_scripted.clear();
+    m_scriptedSerials.clear();
+}
+
+int TrackSimulator::targetCount() const {
+    return m_swarm.size() + m_scripted.size();
+}
+
+void TrackSimulator::truth(QVector<TruthTarget>& out) const {
+    out.resize(m_swarm.size() + m_scripted.size());
+    int n = 0;
+    for (int i = 0; i < m_swarm.size(); ++i, ++n) {
+        TruthTarget& t = out[n];
+        t.serial = m_swarm.serial(i);
+        t.id = m_swarm.id(i);
+        t.position = m_swarm.position(i);
+        t.velocity = m_swarm.velocity(i);
+    }
+    for (int i = 0; i < m_scripted.size(); ++i, ++n) {
+        TruthTarget& t = out[n];
+        t.serial = m_scriptedSerials[i];
+        t.id = m_scripted[i].id;
+        t.position = m_scripted[i].positionAt(m_scriptTimeSec);
+        t.velocity = m_scripted[i].velocityAt(m_scriptTimeSec);
+    }
+}
+
+bool TrackSimulator::loadScript(const QString& path) {
+    unloadScript();
+    auto script = std::make_unique<RaidScriptReader>();
+    if (!script->open(path)) {
+        Logger::instance().error("TrackSimulator",
+            QString("Cannot play raid script %1: %2").arg(path, script->errorString()));
+        return false;
+    }
+    Logger::instance().info("TrackSimulator",
+        QString("Playing raid script %1 (%2 targets)")
+            .arg(script->header().name).arg(script->header().targetCount));
+    m_script = std::move(script);
+    m_scriptTimeSec = 0.0;
+    return true;
+}
+
+void TrackSimulator::unloadScript() {
+    for (const ScriptedTarget& target : m_scripted) {
         emit targetRemoved(target.id);
     }
-    m_targets.clear();
+    m_scripted.clear();
+    m_scriptedSerials.clear();
+    m_script.reset();
+    m_scriptTimeSec = 0.0;
+}
+
+bool TrackSimulator::scriptFinished() const {
+    return m_script && m_script->atEnd() && m_scripted.isEmpty();
 }
 
 QString TrackSimulator::injectTarget(const ManualTargetParams& params) {
-    if (m_targets.size() >= m_maxTargets) {
+    if (m_swarm.size() >= m_maxTargets) {
         return QString();  // At max capacity
     }
     
-    auto* gen = QRandomGenerator::global();
-    
     SimulatedTarget target;
-    target.id = QString("MAN-%1").arg(gen->bounded(10000));
+    target.id = QString("MAN-%1").arg(m_random.bounded(10000));
     
     // Calculate position from range and bearing
     double bearingRad = qDegreesToRadians(params.bearingDeg);
-    target.position.latitude = m_basePosition.latitude + 
-                               (params.rangeM * std::cos(bearingRad)) / 111000.0;
-    target.position.longitude = m_basePosition.longitude + 
-                                (params.rangeM * std::sin(bearingRad)) / 
-                                (111000.0 * std::cos(qDegreesToRadians(m_basePosition.latitude)));
-    target.position.altitude = m_basePosition.altitude + params.altitudeM;
+    target.position = LocalTangentPlane(m_basePosition).toGeoLinear(
+        EnuVector{params.rangeM * std::sin(bearingRad), params.rangeM * std::cos(bearingRad),
+                  params.altitudeM});
     
     // Calculate velocity from speed and heading
     double headingRad = qDegreesToRadians(params.headingDeg);
@@ -86,9 +153,8 @@ QString TrackSimulator::injectTarget(const ManualTargetParams& params) {
     target.velocity.down = -params.climbRateMps;  // Positive down = descending
     
     target.classification = params.classification;
-    target.active = true;
     
-    m_targets.append(target);
+    m_swarm.add(target.id, target.position, target.velocity, 0.1, 0.9, target.classification);
     emit targetInjected(target.id, target.position);
     
     return target.id;
@@ -97,80 +163,112 @@ QString TrackSimulator::injectTarget(const ManualTargetParams& params) {
 void TrackSimulator::updateTargets() {
     if (!m_trackManager) return;
     
-    double dt = 0.1;  // 100ms
-    QList<QString> removedIds;
+    m_trackManager->processDetectionBatch(advance(0.1));  // 100ms
+}
+
+QVector<SensorDetection> TrackSimulator::advance(double dt) {
+    m_swarm.propagate(dt);
+    // About a metre of position noise, as the 1e-5 degree jitter always was
+    m_swarm.jitter(m_random, 0.00001 * CoordinateUtils::DEG_TO_M_LAT,
+                   0.00001 * CoordinateUtils::degToMeterLon(m_basePosition.latitude));
+    m_swarm.groundRanges(m_basePosition, m_ranges);
     
-    for (auto& target : m_targets) {
-        if (!target.active) continue;
-        
-        // Update position
-        target.position.latitude += (target.velocity.north * dt) / 111000.0;
-        target.position.longitude += (target.velocity.east * dt) / 
-                                      (111000.0 * std::cos(qDegreesToRadians(target.position.latitude)));
-        target.position.altitude -= target.velocity.down * dt;
-        
-        // Add some noise
-        auto* gen = QRandomGenerator::global();
-        target.position.latitude += gen->generateDouble() * 0.00002 - 0.00001;
-        target.position.longitude += gen->generateDouble() * 0.00002 - 0.00001;
+    const int count = m_swarm.size();
+    const qint64 nowMs = m_clock->nowMs();
+    QVector<SensorDetection> plots(count);
+    m_keep.resize(count);
+    for (int i = 0; i < count; ++i) {
+        SensorDetection& det = plots[i];
+        det.sensorId = m_sensorId;
+        det.sourceType = DetectionSource::Radar;
+        det.position = m_swarm.position(i);
+        det.velocity = m_swarm.velocity(i);
+        det.confidence = 0.9;
+        det.timestamp = nowMs;
         
-        // Report to track manager
-        m_trackManager->processRadarDetection(target.position, target.velocity, 
-                                              0.9, QDateTime::currentMSecsSinceEpoch());
-        
-        // Check if target has passed through base or left range
-        Track tempTrack("temp");
-        tempTrack.setPosition(m_basePosition);
-        double dist = tempTrack.distanceTo(target.position);
-        
-        if (dist < 100.0 || dist > 5000.0) {
-            target.active = false;
-            removedIds.append(target.id);
-        }
+        // Passed through the base or left range
+        m_keep[i] = m_ranges[i] >= 100.0 && m_ranges[i] <= 5000.0;
     }
     
-    // Remove inactive targets and emit signals
-    m_targets.erase(std::remove_if(m_targets.begin(), m_targets.end(),
-        [](const SimulatedTarget& t) { return !t.active; }), m_targets.end());
-    
-    for (const QString& id : removedIds) {
+    for (const QString& id : m_swarm.compact(m_keep)) {
         emit targetRemoved(id);
     }
+    
+    if (m_script) {
+        advanceScript(dt, nowMs, plots);
+    }
+    return plots;
+}
+
+void TrackSimulator::advanceScript(double dt, qint64 nowMs, QVector<SensorDetection>& plots) {
+    m_scriptTimeSec += dt;
+    const int started = m_scripted.size();
+    m_script->readUntil(m_scriptTimeSec, m_scripted);
+    for (int i = started; i < m_scripted.size(); ++i) {
+        m_scriptedSerials.append(m_nextScriptedSerial++);
+        emit targetInjected(m_scripted[i].id, m_scripted[i].positionAt(m_scriptTimeSec));
+    }
+    
+    // Same 1e-5 degree jitter as the free-flying targets
+    int out = 0;
+    for (int i = 0; i < m_scripted.size(); ++i) {
+        const ScriptedTarget& target = m_scripted[i];
+        if (target.endSec() < m_scriptTimeSec) {
+            emit targetRemoved(target.id);
+            continue;
+        }
+        SensorDetection det;
+        det.sensorId = m_sensorId;
+        det.sourceType = DetectionSource::Radar;
+        det.position = target.positionAt(m_scriptTimeSec);
+        det.position.latitude += m_random.uniform(-0.00001, 0.00001);
+        det.position.longitude += m_random.uniform(-0.00001, 0.00001);
+        det.velocity = target.velocityAt(m_scriptTimeSec);
+        det.signalStrength = target.rcs;
+        det.confidence = 0.9;
+        det.timestamp = nowMs;
+        plots.append(det);
+        
+        if (out != i) {
+            m_scripted[out] = std::move(m_scripted[i]);
+            m_scriptedSerials[out] = m_scriptedSerials[i];
+        }
+        ++out;
+    }
+    m_scripted.resize(out);
+    m_scriptedSerials.resize(out);
 }
 
 void TrackSimulator::spawnTarget() {
     if (!m_autoSpawnEnabled) return;
-    if (m_targets.size() >= m_maxTargets) return;
+    if (m_swarm.size() >= m_maxTargets) return;
     
-    auto* gen = QRandomGenerator::global();
+    auto* gen = &m_random;
     
     SimulatedTarget target;
     target.id = QString("SIM-%1").arg(gen->bounded(10000));
     
     // Spawn at edge of range
-    double range = 2000.0 + gen->generateDouble() * 1000.0;
-    double bearing = gen->generateDouble() * 360.0;
+    double range = 2000.0 + gen->uniform() * 1000.0;
+    double bearing = gen->uniform() * 360.0;
     double bearingRad = qDegreesToRadians(bearing);
     
-    target.position.latitude = m_basePosition.latitude + (range * std::cos(bearingRad)) / 111000.0;
-    target.position.longitude = m_basePosition.longitude + 
-                                 (range * std::sin(bearingRad)) / 
-                                 (111000.0 * std::cos(qDegreesToRadians(m_basePosition.latitude)));
-    target.position.altitude = m_basePosition.altitude + 50.0 + gen->generateDouble() * 250.0;
+    target.position = LocalTangentPlane(m_basePosition).toGeoLinear(
+        EnuVector{range * std::sin(bearingRad), range * std::cos(bearingRad),
+                  50.0 + gen->uniform() * 250.0});
     
     // Velocity toward base
-    double speed = 8.0 + gen->generateDouble() * 12.0;
-    double velBearing = bearing + 180.0 + (gen->generateDouble() * 40.0 - 20.0);
+    double speed = 8.0 + gen->uniform() * 12.0;
+    double velBearing = bearing + 180.0 + (gen->uniform() * 40.0 - 20.0);
     
     target.velocity.north = speed * std::cos(qDegreesToRadians(velBearing));
     target.velocity.east = speed * std::sin(qDegreesToRadians(velBearing));
-    target.velocity.down = gen->generateDouble() * 2.0 - 1.0;
+    target.velocity.down = gen->uniform() * 2.0 - 1.0;
     
     target.classification = gen->bounded(100) < 70 ? 
                             TrackClassification::Hostile : TrackClassification::Pending;
-    target.active = true;
     
-    m_targets.append(target);
+    m_swarm.add(target.id, target.position, target.velocity, 0.1, 0.9, target.classification);
     emit targetInjected(target.id, target.position);
 }
 
@@ -4,9 +4,16 @@
 #include <QObject>
 #include <QTimer>
 #include <QList>
+#include <QVector>
+#include <memory>
 #include "core/Track.h"
+#include "sensors/SensorInterface.h"
+#include "simulators/RaidScript.h"
+#include "simulators/TargetSwarm.h"
+#include "utils/FastRandom.h"
 
 namespace CounterUAS {
+class Clock;
 class TrackManager;
 
 /**
@@ -30,19 +37,54 @@ struct SimulatedTarget {
     bool active = true;
 };
 
+/**
+ * @brief Where one simulated target really is, for scoring the tracker
+ */
+struct TruthTarget {
+    quint64 serial = 0;             // Unique over the simulator's lifetime; ids may repeat
+    QString id;
+    GeoPosition position;
+    VelocityVector velocity;
+};
+
 class TrackSimulator : public QObject {
     Q_OBJECT
 public:
     explicit TrackSimulator(TrackManager* manager, QObject* parent = nullptr);
     void start();
     void stop();
-    void setBasePosition(const GeoPosition& pos) { m_basePosition = pos; }
+    void setBasePosition(const GeoPosition& pos);
     GeoPosition basePosition() const { return m_basePosition; }
     
+    // Detection timestamps come from clock (the wall clock by default)
+    void setClock(const Clock* clock);
+    // Same seed, same targets and noise
+    void setSeed(quint64 seed) { m_random.reseed(seed); }
+    
+    // Moves every target dtSec and returns one radar plot per target,
+    // without reporting them; the timers report each as it is made.
+    // Targets that reach the base or leave range are removed
+    QVector<SensorDetection> advance(double dtSec);
+    
     // Target management
     void addTarget(const SimulatedTarget& target);
     void clearTargets();
-    int targetCount() const { return m_targets.size(); }
+    int targetCount() const;
+    // Every target as the last advance() left it. Free-flying targets are
+    // where their plots put them, scripted ones on their path without the
+    // plot noise
+    void truth(QVector<TruthTarget>& out) const;
+    
+    // Plays a raid script alongside any other targets: each scripted target
+    // appears at its start time, flies its waypoints and is removed at its
+    // end, read from disk as playback reaches it. Script time starts at 0
+    // and advances with advance(); false if the file cannot be read
+    bool loadScript(const QString& path);
+    void unloadScript();
+    bool scriptLoaded() const { return m_script != nullptr; }
+    double scriptTimeSec() const { return m_scriptTimeSec; }
+    // Every scripted target has been read and has ended
+    bool scriptFinished() const;
     
     // Manual target injection with parameters
     QString injectTarget(const ManualTargetParams& params);
@@ -57,20 +99,38 @@ public:
     void setMaxTargets(int max) { m_maxTargets = max; }
     int maxTargets() const { return m_maxTargets; }
     
+public slots:
+    void spawnTarget();
+    
 signals:
     void targetInjected(const QString& targetId, const GeoPosition& position);
     void targetRemoved(const QString& targetId);
     
 private slots:
     void updateTargets();
-    void spawnTarget();
     
 private:
+    // Above any swarm serial
+    static constexpr quint64 SCRIPTED_SERIAL_BASE = quint64(1) << 62;
+    
+    void advanceScript(double dt, qint64 nowMs, QVector<SensorDetection>& plots);
+    
     TrackManager* m_trackManager;
+    const Clock* m_clock;
+    FastRandom m_random;
+    const QString m_sensorId;
     QTimer* m_updateTimer;
     QTimer* m_spawnTimer;
     GeoPosition m_basePosition;
-    QList<SimulatedTarget> m_targets;
+    TargetSwarm m_swarm;
+    QVector<double> m_ranges;           // advance()'s scratch
+    QVector<quint8> m_keep;
+    
+    std::unique_ptr<RaidScriptReader> m_script;
+    QVector<ScriptedTarget> m_scripted;     // Started and not yet ended
+    QVector<quint64> m_scriptedSerials;     // One per m_scripted entry
+    quint64 m_nextScriptedSerial = SCRIPTED_SERIAL_BASE;
+    double m_scriptTimeSec = 0.0;
     
     bool m_autoSpawnEnabled = true;
     int m_spawnInterval = 5000;  // milliseconds
@@ -66,6 +66,7 @@ void VideoSimulator::stop() {
 void VideoSimulator::setResolution(int width, int height) {
     m_width = width;
     m_height = height;
+    m_legacyBackground = QImage();
 }
 
 void VideoSimulator::addSimulatedCamera(const SimulatedCamera& camera) {
@@ -169,7 +170,7 @@ void VideoSimulator::createSimulationSources() {
             camDef.streamUrl = "simulation://generated";
             camDef.hasPTZ = true;
             
-            m_videoManager->addStream(camDef);
+            m_videoManager->addExternalStream(camDef, source);
         }
         
         Logger::instance().info("VideoSimulator", 
@@ -206,12 +207,11 @@ void VideoSimulator::onSourceFrameReady(const QImage& frame, qint64 timestamp) {
     }
 }
 
-void VideoSimulator::generateFrame() {
-    // Legacy frame generation for backward compatibility
-    QImage frame(m_width, m_height, QImage::Format_RGB888);
-    frame.fill(QColor(30, 30, 40));
+void VideoSimulator::renderLegacyBackground() {
+    m_legacyBackground = QImage(m_width, m_height, QImage::Format_RGB888);
+    m_legacyBackground.fill(QColor(30, 30, 40));
     
-    QPainter painter(&frame);
+    QPainter painter(&m_legacyBackground);
     painter.setRenderHint(QPainter::Antialiasing);
     
     // Draw grid
@@ -236,6 +236,25 @@ void VideoSimulator::generateFrame() {
     painter.drawLine(cx, cy - 30, cx, cy - 10);
     painter.drawLine(cx, cy + 10, cx, cy + 30);
     
+    painter.end();
+}
+
+void VideoSimulator::generateFrame() {
+    // Legacy frame generation for backward compatibility
+    if (m_legacyBackground.isNull()) {
+        renderLegacyBackground();
+    }
+    QImage frame = m_framePool.acquireCopy(m_legacyBackground.constBits(),
+                                           m_width, m_height,
+                                           m_legacyBackground.bytesPerLine(),
+                                           QImage::Format_RGB888);
+    
+    QPainter painter(&frame);
+    painter.setRenderHint(QPainter::Antialiasing);
+    
+    int cx = m_width / 2;
+    int cy = m_height / 2;
+    
     // Draw simulated target (moving)
     double t = m_frameCount * 0.03;
     int targetX = cx + static_cast<int>(100 * std::sin(t));
@@ -6,6 +6,7 @@
 #include <QImage>
 #include <QHash>
 #include <QVector>
+#include "utils/FramePool.h"
 
 namespace CounterUAS {
 
@@ -80,6 +81,7 @@ private slots:
 private:
     void createSimulationSources();
     void destroySimulationSources();
+    void renderLegacyBackground();
     
     VideoStreamManager* m_videoManager = nullptr;
     QTimer* m_timer;
@@ -90,6 +92,10 @@ private:
     bool m_running = false;
     bool m_legacyMode = false;  // When true, uses simple frame generation
     
+    // Legacy frames: the static grid/horizon/crosshairs painted once
+    FramePool m_framePool;
+    QImage m_legacyBackground;
+    
     QVector<SimulatedCamera> m_cameraConfigs;
     QHash<QString, SimulationVideoSource*> m_sources;
 };
@@ -1,42 +1,40 @@
 #include "ui/AlertQueue.h"
+#include "ui/AlertQueueModel.h"
 #include "core/ThreatAssessor.h"
+#include <QListView>
 #include <QVBoxLayout>
-#include <QLabel>
 
 namespace CounterUAS {
 
 AlertQueue::AlertQueue(ThreatAssessor* assessor, QWidget* parent)
-    : QWidget(parent), m_assessor(assessor) {
+    : QWidget(parent)
+    , m_assessor(assessor)
+    , m_model(new AlertQueueModel(this))
+    , m_listView(new QListView(this))
+{
     QVBoxLayout* layout = new QVBoxLayout(this);
     layout->setContentsMargins(0, 0, 0, 0);
     
-    m_listWidget = new QListWidget(this);
-    layout->addWidget(m_listWidget);
+    m_listView->setModel(m_model);
+    m_listView->setUniformItemSizes(true);
+    m_listView->setLayoutMode(QListView::Batched);
+    m_listView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    layout->addWidget(m_listView);
     
     if (m_assessor) {
-        connect(m_assessor, &ThreatAssessor::newAlert, this, &AlertQueue::onNewAlert);
+        m_model->reset(m_assessor->alerts());
+        connect(m_assessor, &ThreatAssessor::newAlert, m_model, &AlertQueueModel::addAlert);
+        connect(m_assessor, &ThreatAssessor::alertAcknowledged, m_model, &AlertQueueModel::acknowledgeAlert);
+        connect(m_assessor, &ThreatAssessor::alertEvicted, m_model, &AlertQueueModel::evictAlert);
+        connect(m_assessor, &ThreatAssessor::alertsCleared, m_model, &AlertQueueModel::clear);
+        connect(m_assessor, &ThreatAssessor::alertsRestored, this, [this]() {
+            m_model->reset(m_assessor->alerts());
+        });
     }
     
-    connect(m_listWidget, &QListWidget::itemClicked, this, [this](QListWidgetItem* item) {
-        emit alertClicked(item->data(Qt::UserRole).toString());
+    connect(m_listView, &QListView::clicked, this, [this](const QModelIndex& index) {
+        emit alertClicked(index.data(AlertQueueModel::AlertIdRole).toString());
     });
 }
 
-void AlertQueue::onNewAlert(const ThreatAlert& alert) {
-    QListWidgetItem* item = new QListWidgetItem(alert.message);
-    item->setData(Qt::UserRole, alert.alertId);
-    
-    if (alert.threatLevel >= 4) {
-        item->setBackground(QColor(255, 100, 100));
-    } else if (alert.threatLevel >= 3) {
-        item->setBackground(QColor(255, 200, 100));
-    }
-    
-    m_listWidget->insertItem(0, item);
-    
-    while (m_listWidget->count() > 50) {
-        delete m_listWidget->takeItem(m_listWidget->count() - 1);
-    }
-}
-
 } // namespace CounterUAS
@@ -2,25 +2,37 @@
 #define ALERTQUEUE_H
 
 #include <QWidget>
-#include <QListWidget>
+
+class QListView;
 
 namespace CounterUAS {
 class ThreatAssessor;
+class AlertQueueModel;
 
+/**
+ * @brief Alert list kept in step with the assessor's alert store
+ *
+ * An AlertQueueModel applies the assessor's per-alert notifications (new,
+ * acknowledged, evicted, cleared) instead of re-reading the store; it is
+ * seeded from the store at construction and on a checkpoint restore only. The view has uniform row heights, so only
+ * the rows on screen are laid out and painted however many alerts the
+ * store holds.
+ */
 class AlertQueue : public QWidget {
     Q_OBJECT
 public:
     explicit AlertQueue(ThreatAssessor* assessor, QWidget* parent = nullptr);
     
+    AlertQueueModel* model() const { return m_model; }
+    
 signals:
+    // The newest alert of the clicked row
     void alertClicked(const QString& alertId);
     
-private slots:
-    void onNewAlert(const struct ThreatAlert& alert);
-    
 private:
     ThreatAssessor* m_assessor;
-    QListWidget* m_listWidget;
+    AlertQueueModel* m_model;
+    QListView* m_listView;
 };
 
 } // namespace CounterUAS
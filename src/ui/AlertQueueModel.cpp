@@ -0,0 +1,201 @@
+#include "ui/AlertQueueModel.h"
+#include <QBrush>
+#include <QColor>
+#include <algorithm>
+
+namespace CounterUAS {
+
+AlertQueueModel::AlertQueueModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int AlertQueueModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant AlertQueueModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+    const Row& row = m_rows[index.row()];
+
+    switch (role) {
+        case Qt::DisplayRole:
+            if (row.count > 1) {
+                return QString("%1 (%2%3)").arg(row.message).arg(QChar(0x00d7)).arg(row.count);
+            }
+            return row.message;
+        case Qt::ToolTipRole:
+            return QString("%1: %2 alert(s), %3 unacknowledged")
+                .arg(row.subject).arg(row.count).arg(row.unacknowledged);
+        case Qt::BackgroundRole:
+            if (row.unacknowledged == 0) return QVariant();
+            if (row.threatLevel >= 4) return QBrush(QColor(255, 100, 100));
+            if (row.threatLevel >= 3) return QBrush(QColor(255, 200, 100));
+            return QVariant();
+        case Qt::ForegroundRole:
+            return row.unacknowledged == 0 ? QVariant(QBrush(QColor(128, 128, 128))) : QVariant();
+        case AlertIdRole:
+            return row.alertId;
+        case SubjectRole:
+            return row.subject;
+        case TrackIdRole:
+            return row.trackId;
+        case CountRole:
+            return row.count;
+        case UnacknowledgedRole:
+            return row.unacknowledged;
+        case PriorityRole:
+            return priority(row);
+        default:
+            return QVariant();
+    }
+}
+
+QString AlertQueueModel::subjectOf(const ThreatAlert& alert) {
+    return alert.groupId != 0 ? ThreatAlertStore::groupSubject(alert.groupId) : alert.trackId;
+}
+
+void AlertQueueModel::reset(const QList<ThreatAlert>& alerts) {
+    beginResetModel();
+    m_rows.clear();
+    m_rowBySubject.clear();
+    m_alerts.clear();
+    for (const ThreatAlert& alert : alerts) {
+        if (m_alerts.contains(alert.alertId)) continue;
+        const QString subject = subjectOf(alert);
+        m_alerts.insert(alert.alertId, {subject, alert.acknowledged});
+
+        int rowIndex = rowOf(subject);
+        if (rowIndex < 0) {
+            rowIndex = m_rows.size();
+            m_rows.append(Row());
+            m_rows.last().subject = subject;
+            m_rowBySubject.insert(subject, rowIndex);
+        }
+        apply(m_rows[rowIndex], alert);
+    }
+    std::sort(m_rows.begin(), m_rows.end(), above);
+    reindex(0, m_rows.size() - 1);
+    endResetModel();
+}
+
+void AlertQueueModel::addAlert(const ThreatAlert& alert) {
+    if (m_alerts.contains(alert.alertId)) return;
+    const QString subject = subjectOf(alert);
+    m_alerts.insert(alert.alertId, {subject, alert.acknowledged});
+
+    const int rowIndex = rowOf(subject);
+    if (rowIndex < 0) {
+        Row row;
+        row.subject = subject;
+        apply(row, alert);
+        insertRow(row);
+        return;
+    }
+    apply(m_rows[rowIndex], alert);
+    reposition(rowIndex);
+}
+
+void AlertQueueModel::acknowledgeAlert(const QString& alertId) {
+    auto it = m_alerts.find(alertId);
+    if (it == m_alerts.end() || it->acknowledged) return;
+    it->acknowledged = true;
+
+    const int rowIndex = rowOf(it->subject);
+    if (rowIndex < 0) return;
+    --m_rows[rowIndex].unacknowledged;
+    reposition(rowIndex);
+}
+
+void AlertQueueModel::evictAlert(const QString& alertId) {
+    auto it = m_alerts.find(alertId);
+    if (it == m_alerts.end()) return;
+    const AlertRef ref = it.value();
+    m_alerts.erase(it);
+
+    const int rowIndex = rowOf(ref.subject);
+    if (rowIndex < 0) return;
+    Row& row = m_rows[rowIndex];
+    --row.count;
+    if (!ref.acknowledged) --row.unacknowledged;
+    if (row.count > 0) {
+        reposition(rowIndex);
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), rowIndex, rowIndex);
+    m_rowBySubject.remove(ref.subject);
+    m_rows.remove(rowIndex);
+    reindex(rowIndex, m_rows.size() - 1);
+    endRemoveRows();
+}
+
+void AlertQueueModel::clear() {
+    beginResetModel();
+    m_rows.clear();
+    m_rowBySubject.clear();
+    m_alerts.clear();
+    endResetModel();
+}
+
+bool AlertQueueModel::above(const Row& a, const Row& b) {
+    const int pa = priority(a);
+    const int pb = priority(b);
+    return pa != pb ? pa > pb : a.sequence > b.sequence;
+}
+
+void AlertQueueModel::apply(Row& row, const ThreatAlert& alert) {
+    row.trackId = alert.trackId;
+    row.alertId = alert.alertId;
+    row.message = alert.message;
+    row.threatLevel = alert.threatLevel;
+    row.sequence = ++m_sequence;
+    ++row.count;
+    if (!alert.acknowledged) ++row.unacknowledged;
+}
+
+int AlertQueueModel::placeFor(const Row& row, int skip) const {
+    // Binary search over the rows in order, as if the one at skip were gone
+    int low = 0;
+    int high = m_rows.size() - (skip >= 0 ? 1 : 0);
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        const Row& other = m_rows[skip >= 0 && mid >= skip ? mid + 1 : mid];
+        if (above(other, row)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void AlertQueueModel::insertRow(const Row& row) {
+    const int rowIndex = placeFor(row, -1);
+    beginInsertRows(QModelIndex(), rowIndex, rowIndex);
+    m_rows.insert(rowIndex, row);
+    reindex(rowIndex, m_rows.size() - 1);
+    endInsertRows();
+}
+
+void AlertQueueModel::reposition(int rowIndex) {
+    const int target = placeFor(m_rows[rowIndex], rowIndex);
+    if (target != rowIndex) {
+        // Qt counts the destination before the row is taken out
+        beginMoveRows(QModelIndex(), rowIndex, rowIndex, QModelIndex(),
+                      target > rowIndex ? target + 1 : target);
+        m_rows.move(rowIndex, target);
+        reindex(qMin(rowIndex, target), qMax(rowIndex, target));
+        endMoveRows();
+    }
+    const QModelIndex changed = index(target);
+    emit dataChanged(changed, changed);
+}
+
+void AlertQueueModel::reindex(int from, int to) {
+    for (int i = from; i <= to; ++i) {
+        m_rowBySubject[m_rows[i].subject] = i;
+    }
+}
+
+} // namespace CounterUAS
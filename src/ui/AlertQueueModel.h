@@ -0,0 +1,90 @@
+#ifndef ALERTQUEUEMODEL_H
+#define ALERTQUEUEMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include "core/ThreatAlertStore.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief The alert queue as a list, one row per alerting track or group
+ *
+ * Repeated alerts on a subject (a track, or a swarm group for group alerts,
+ * as ThreatAlertStore keys them) are collapsed into one row that shows the
+ * newest message and how many of the subject's alerts the store still
+ * holds. Rows are grouped by priority: subjects with unacknowledged alerts
+ * first, by the threat level of their newest alert, then the fully
+ * acknowledged ones; newest first within a group.
+ *
+ * The model is fed the assessor's deltas (add, acknowledge, evict, clear)
+ * and never re-reads the store. Each delta touches one row, which is moved
+ * to its place with a single beginMoveRows(), so the cost of an alert is
+ * bounded by the number of subjects on screen rather than by the alert rate,
+ * and a view with uniform row heights only asks for the rows it shows.
+ */
+class AlertQueueModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Role {
+        AlertIdRole = Qt::UserRole,    // Newest alert of the row
+        SubjectRole,
+        TrackIdRole,
+        CountRole,                     // Alerts of the subject still in the store
+        UnacknowledgedRole,
+        PriorityRole                   // Threat level while unacknowledged, else 0
+    };
+
+    explicit AlertQueueModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    // Oldest first, as ThreatAssessor::alerts() gives them
+    void reset(const QList<ThreatAlert>& alerts);
+    void addAlert(const ThreatAlert& alert);
+    void acknowledgeAlert(const QString& alertId);
+    void evictAlert(const QString& alertId);
+    void clear();
+
+    int rowOf(const QString& subject) const { return m_rowBySubject.value(subject, -1); }
+    int alertCount() const { return m_alerts.size(); }
+
+    static QString subjectOf(const ThreatAlert& alert);
+
+private:
+    struct Row {
+        QString subject;
+        QString trackId;
+        QString alertId;            // Newest
+        QString message;
+        int threatLevel = 0;
+        int count = 0;
+        int unacknowledged = 0;
+        quint64 sequence = 0;       // Arrival order of the newest alert
+    };
+    struct AlertRef {
+        QString subject;
+        bool acknowledged = false;
+    };
+
+    static int priority(const Row& row) { return row.unacknowledged > 0 ? qMax(1, row.threatLevel) : 0; }
+    static bool above(const Row& a, const Row& b);
+    void apply(Row& row, const ThreatAlert& alert);
+    int placeFor(const Row& row, int skip) const;
+    void insertRow(const Row& row);
+    void reposition(int rowIndex);
+    void reindex(int from, int to);
+
+    QVector<Row> m_rows;
+    QHash<QString, int> m_rowBySubject;
+    QHash<QString, AlertRef> m_alerts;     // By alert id
+    quint64 m_sequence = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // ALERTQUEUEMODEL_H
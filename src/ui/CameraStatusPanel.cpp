@@ -1,10 +1,39 @@
 #include "ui/CameraStatusPanel.h"
+#include "ui/UIFrameScheduler.h"
 #include "video/VideoStreamManager.h"
 #include <QVBoxLayout>
 #include <QHeaderView>
 
 namespace CounterUAS {
 
+namespace {
+
+QString statusText(VideoSourceStatus status) {
+    switch (status) {
+        case VideoSourceStatus::Disconnected: return "Disconnected";
+        case VideoSourceStatus::Connecting: return "Connecting";
+        case VideoSourceStatus::Connected: return "Connected";
+        case VideoSourceStatus::Streaming: return "Streaming";
+        case VideoSourceStatus::Paused: return "Paused";
+        case VideoSourceStatus::Error: return "Error";
+        case VideoSourceStatus::Reconnecting: return "Reconnecting";
+    }
+    return "Unknown";
+}
+
+QColor statusColor(VideoSourceStatus status) {
+    switch (status) {
+        case VideoSourceStatus::Streaming: return QColor(0, 200, 0);
+        case VideoSourceStatus::Connecting:
+        case VideoSourceStatus::Connected:
+        case VideoSourceStatus::Reconnecting: return QColor(255, 165, 0);
+        case VideoSourceStatus::Error: return QColor(255, 0, 0);
+        default: return QColor(128, 128, 128);
+    }
+}
+
+} // namespace
+
 CameraStatusPanel::CameraStatusPanel(VideoStreamManager* manager, QWidget* parent)
     : QWidget(parent), m_manager(manager) {
     QVBoxLayout* layout = new QVBoxLayout(this);
@@ -17,6 +46,93 @@ CameraStatusPanel::CameraStatusPanel(VideoStreamManager* manager, QWidget* paren
     m_table->verticalHeader()->hide();
     
     layout->addWidget(m_table);
+    
+    connect(&StatusBoard::instance(), &StatusBoard::published, this, &CameraStatusPanel::onBoardPublished);
+    onBoardPublished();
+}
+
+void CameraStatusPanel::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+    
+    if (m_frameScheduler) {
+        disconnect(&StatusBoard::instance(), &StatusBoard::published, this, &CameraStatusPanel::onBoardPublished);
+        m_frameScheduler->addClient(this, 2, [this](const UIFrame& frame) {
+            applyStatus(frame.status, frame.statusSince);
+        });
+        m_frameScheduler->setClientTriggers(this, FrameOnStatus, StatusBoard::kindBit(StatusKind::Camera));
+        m_statusSeen = 0;
+    } else {
+        connect(&StatusBoard::instance(), &StatusBoard::published, this, &CameraStatusPanel::onBoardPublished,
+                Qt::UniqueConnection);
+        onBoardPublished();
+    }
+}
+
+void CameraStatusPanel::onBoardPublished() {
+    const StatusBoard& board = StatusBoard::instance();
+    const quint64 version = board.version();
+    if (version == m_statusSeen) return;
+    applyStatus(board.changedSince(m_statusSeen, StatusBoard::kindBit(StatusKind::Camera)), m_statusSeen);
+    m_statusSeen = version;
+}
+
+void CameraStatusPanel::applyStatus(const QVector<StatusSnapshotPtr>& changed, quint64 sinceVersion) {
+    for (const StatusSnapshotPtr& status : changed) {
+        if (status->removed) {
+            removeRow(status->source);
+            continue;
+        }
+        
+        int row = m_rows.value(status->source, -1);
+        quint64 since = sinceVersion;
+        if (row < 0) {
+            row = m_table->rowCount();
+            m_table->insertRow(row);
+            for (int column = 0; column < m_table->columnCount(); ++column) {
+                m_table->setItem(row, column, new QTableWidgetItem());
+            }
+            m_rows.insert(status->source, row);
+            since = 0;  // Every field is new to the row
+        }
+        
+        if (status->changed("name", since)) {
+            m_table->item(row, 0)->setText(status->value("name").toString());
+        }
+        if (status->changed("status", since)) {
+            const auto sourceStatus = static_cast<VideoSourceStatus>(status->value("status").toInt());
+            m_table->item(row, 1)->setText(statusText(sourceStatus));
+            m_table->item(row, 1)->setForeground(statusColor(sourceStatus));
+        }
+        if (status->changed("fps", since)) {
+            m_table->item(row, 2)->setText(QString::number(status->value("fps").toDouble(), 'f', 1));
+        }
+        if (status->changed("width", since) || status->changed("height", since) || status->changed("profile", since)) {
+            m_table->item(row, 2)->setToolTip(QString("%1x%2, %3 stream")
+                                                  .arg(status->value("width").toInt())
+                                                  .arg(status->value("height").toInt())
+                                                  .arg(status->value("profile").toString()));
+        }
+        if (status->changed("recording", since)) {
+            const bool recording = status->value("recording").toBool();
+            m_table->item(row, 3)->setText(recording ? "REC" : "-");
+            m_table->item(row, 3)->setForeground(recording ? QColor(255, 0, 0) : QColor(128, 128, 128));
+        }
+    }
+}
+
+void CameraStatusPanel::removeRow(const QString& cameraId) {
+    const int row = m_rows.value(cameraId, -1);
+    if (row < 0) return;
+    m_table->removeRow(row);
+    m_rows.remove(cameraId);
+    for (auto it = m_rows.begin(); it != m_rows.end(); ++it) {
+        if (it.value() > row) {
+            it.value()--;
+        }
+    }
 }
 
 } // namespace CounterUAS
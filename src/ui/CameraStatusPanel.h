@@ -3,17 +3,39 @@
 
 #include <QWidget>
 #include <QTableWidget>
+#include <QHash>
+#include "utils/StatusBoard.h"
 
 namespace CounterUAS {
 class VideoStreamManager;
+class UIFrameScheduler;
+struct UIFrame;
 
+/**
+ * @brief One row per video stream, from the streams' StatusBoard snapshots
+ *
+ * Only the cells whose fields changed are rewritten. Without a frame
+ * scheduler it reads the board when the board says it changed.
+ */
 class CameraStatusPanel : public QWidget {
     Q_OBJECT
 public:
     explicit CameraStatusPanel(VideoStreamManager* manager, QWidget* parent = nullptr);
+    
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+    
+private slots:
+    void onBoardPublished();
+    
 private:
+    void applyStatus(const QVector<StatusSnapshotPtr>& changed, quint64 sinceVersion);
+    void removeRow(const QString& cameraId);
+    
     VideoStreamManager* m_manager;
+    UIFrameScheduler* m_frameScheduler = nullptr;
     QTableWidget* m_table;
+    QHash<QString, int> m_rows;         // cameraId -> row index
+    quint64 m_statusSeen = 0;           // Board version last read without a scheduler
 };
 
 } // namespace CounterUAS
@@ -1,5 +1,6 @@
 #include "ui/EffectorControlPanel.h"
 #include "core/EngagementManager.h"
+#include "ui/UIFrameScheduler.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
@@ -10,12 +11,18 @@ namespace CounterUAS {
 EffectorControlPanel::EffectorControlPanel(EngagementManager* manager, QWidget* parent)
     : QWidget(parent)
     , m_manager(manager)
-    , m_updateTimer(new QTimer(this))
 {
     setupUI();
     
-    connect(m_updateTimer, &QTimer::timeout, this, &EffectorControlPanel::updateEffectorStatus);
-    m_updateTimer->start(500);  // Update every 500ms
+    // Pushed by the effectors; the engage button also follows the selected track
+    if (m_manager) {
+        connect(m_manager, &EngagementManager::effectorEvent,
+                this, &EffectorControlPanel::onEffectorEvent);
+        connect(m_manager, &EngagementManager::trackSelected,
+                this, &EffectorControlPanel::updateSelectedEffector);
+        connect(m_manager, &EngagementManager::stateChanged,
+                this, &EffectorControlPanel::updateSelectedEffector);
+    }
     
     // Initial population
     refreshEffectorList();
@@ -91,6 +98,7 @@ void EffectorControlPanel::setupUI() {
 
 void EffectorControlPanel::refreshEffectorList() {
     m_effectorList->clear();
+    m_items.clear();
     
     if (!m_manager) return;
     
@@ -99,6 +107,7 @@ void EffectorControlPanel::refreshEffectorList() {
         item->setData(Qt::UserRole, effector->effectorId());
         updateEffectorItem(item, effector);
         m_effectorList->addItem(item);
+        m_items.insert(effector->effectorId(), item);
     }
 }
 
@@ -137,7 +146,7 @@ void EffectorControlPanel::onEffectorItemClicked(QListWidgetItem* item) {
         m_manager->selectEffector(m_selectedEffectorId);
         emit effectorSelected(m_selectedEffectorId);
         
-        updateEffectorStatus();
+        updateSelectedEffector();
     }
 }
 
@@ -172,18 +181,63 @@ void EffectorControlPanel::onDisengageClicked() {
     }
 }
 
-void EffectorControlPanel::updateEffectorStatus() {
+void EffectorControlPanel::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
     if (!m_manager) return;
     
-    // Update list items
-    for (int i = 0; i < m_effectorList->count(); i++) {
-        QListWidgetItem* item = m_effectorList->item(i);
-        QString effectorId = item->data(Qt::UserRole).toString();
-        auto* effector = m_manager->effector(effectorId);
-        if (effector) {
+    disconnect(m_manager, &EngagementManager::effectorEvent, this, &EffectorControlPanel::onEffectorEvent);
+    if (m_frameScheduler) {
+        m_frameScheduler->addClient(this, 10, [this](const UIFrame& frame) { onFrame(frame); });
+        m_frameScheduler->setClientTriggers(this, FrameOnStatus, StatusBoard::kindBit(StatusKind::Effector));
+    } else {
+        connect(m_manager, &EngagementManager::effectorEvent,
+                this, &EffectorControlPanel::onEffectorEvent);
+    }
+}
+
+void EffectorControlPanel::onFrame(const UIFrame& frame) {
+    if (!m_manager) return;
+    
+    bool selectedChanged = false;
+    for (const StatusSnapshotPtr& status : frame.status) {
+        if (status->removed) continue;
+        QListWidgetItem* item = m_items.value(status->source);
+        auto* effector = m_manager->effector(status->source);
+        if (!item && effector) {
+            // Registered since the list was built
+            refreshEffectorList();
+            updateSelectedEffector();
+            return;
+        }
+        if (item && effector && status->changed("status", frame.statusSince)) {
             updateEffectorItem(item, effector);
         }
+        selectedChanged |= status->source == m_selectedEffectorId;
+    }
+    if (selectedChanged) {
+        updateSelectedEffector();
     }
+}
+
+void EffectorControlPanel::onEffectorEvent(const EffectorEvent& event) {
+    if (!m_manager) return;
+    
+    // Only the effector that reported changed
+    QListWidgetItem* item = m_items.value(event.effectorId);
+    auto* effector = m_manager->effector(event.effectorId);
+    if (item && effector) {
+        updateEffectorItem(item, effector);
+    }
+    if (event.effectorId == m_selectedEffectorId) {
+        updateSelectedEffector();
+    }
+}
+
+void EffectorControlPanel::updateSelectedEffector() {
+    if (!m_manager) return;
     
     // Update selected effector detail
     if (!m_selectedEffectorId.isEmpty()) {
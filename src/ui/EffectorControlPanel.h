@@ -5,12 +5,14 @@
 #include <QListWidget>
 #include <QPushButton>
 #include <QLabel>
-#include <QTimer>
+#include <QHash>
 #include <QProgressBar>
 #include "effectors/EffectorInterface.h"
 
 namespace CounterUAS {
 class EngagementManager;
+class UIFrameScheduler;
+struct UIFrame;
 
 class EffectorControlPanel : public QWidget {
     Q_OBJECT
@@ -18,6 +20,9 @@ public:
     explicit EffectorControlPanel(EngagementManager* manager, QWidget* parent = nullptr);
     
     void refreshEffectorList();
+    // Takes effector status in the scheduler's frames, a burst of events
+    // at once, instead of on each of the manager's effectorEvent()s
+    void setFrameScheduler(UIFrameScheduler* scheduler);
     
 signals:
     void engageRequested(const QString& trackId);
@@ -27,15 +32,18 @@ private slots:
     void onEffectorItemClicked(QListWidgetItem* item);
     void onEngageClicked();
     void onDisengageClicked();
-    void updateEffectorStatus();
+    void onEffectorEvent(const EffectorEvent& event);
+    void updateSelectedEffector();
     
 private:
     void setupUI();
+    void onFrame(const UIFrame& frame);
     void updateEffectorItem(QListWidgetItem* item, EffectorInterface* effector);
     QColor statusToColor(EffectorStatus status);
     QString statusToString(EffectorStatus status);
     
     EngagementManager* m_manager;
+    UIFrameScheduler* m_frameScheduler = nullptr;
     QListWidget* m_effectorList;
     QPushButton* m_engageBtn;
     QPushButton* m_disengageBtn;
@@ -46,7 +54,8 @@ private:
     QProgressBar* m_readinessBar;
     QLabel* m_roundsLabel;
     
-    QTimer* m_updateTimer;
+    // Rows by effector id; refreshed as each effector's status changes
+    QHash<QString, QListWidgetItem*> m_items;
     QString m_selectedEffectorId;
 };
 
@@ -5,7 +5,8 @@
 
 namespace CounterUAS {
 
-EngagementDialog::EngagementDialog(const AuthorizationRequest& request, QWidget* parent)
+EngagementDialog::EngagementDialog(const AuthorizationRequest& request,
+                                   const QImage& thumbnail, QWidget* parent)
     : QDialog(parent), m_request(request) {
     setWindowTitle("Engagement Authorization");
     setModal(true);
@@ -17,8 +18,8 @@ EngagementDialog::EngagementDialog(const AuthorizationRequest& request, QWidget*
     m_videoLabel->setMinimumSize(320, 180);
     m_videoLabel->setStyleSheet("background-color: black;");
     m_videoLabel->setAlignment(Qt::AlignCenter);
-    if (!request.videoThumbnail.isNull()) {
-        m_videoLabel->setPixmap(QPixmap::fromImage(request.videoThumbnail));
+    if (!thumbnail.isNull()) {
+        m_videoLabel->setPixmap(QPixmap::fromImage(thumbnail));
     } else {
         m_videoLabel->setText("No Video");
     }
@@ -11,7 +11,9 @@ namespace CounterUAS {
 class EngagementDialog : public QDialog {
     Q_OBJECT
 public:
-    explicit EngagementDialog(const AuthorizationRequest& request, QWidget* parent = nullptr);
+    // The thumbnail comes from the manager's SnapshotStore by request.snapshotId
+    explicit EngagementDialog(const AuthorizationRequest& request,
+                              const QImage& thumbnail = QImage(), QWidget* parent = nullptr);
     
 signals:
     void authorized(const QString& operatorId);
@@ -0,0 +1,85 @@
+#include "ui/GeofenceOverlay.h"
+
+namespace CounterUAS {
+
+void GeofenceOverlay::setZones(const QList<GeofenceZone>& zones) {
+    m_zones.clear();
+
+    GeoPosition origin;
+    int vertexCount = 0;
+    for (const GeofenceZone& zone : zones) {
+        for (const GeoPosition& vertex : zone.vertices) {
+            origin.latitude += vertex.latitude;
+            origin.longitude += vertex.longitude;
+            ++vertexCount;
+        }
+    }
+    if (vertexCount == 0) return;
+    origin.latitude /= vertexCount;
+    origin.longitude /= vertexCount;
+    origin.altitude = 0.0;
+    m_frame.setOrigin(origin);
+
+    for (const GeofenceZone& zone : zones) {
+        if (zone.vertices.size() < 3) continue;
+        QPolygonF boundary;
+        boundary.reserve(zone.vertices.size());
+        for (const GeoPosition& vertex : zone.vertices) {
+            const EnuVector enu = m_frame.toEnuLinear(vertex);
+            boundary.append(QPointF(enu.east, enu.north));
+        }
+
+        ZonePath zonePath;
+        zonePath.name = zone.name.isEmpty() ? zone.id : zone.name;
+        zonePath.type = zone.type;
+        zonePath.path.addPolygon(boundary);
+        zonePath.path.closeSubpath();
+        zonePath.labelAnchor = zonePath.path.boundingRect().center();
+        m_zones.append(zonePath);
+    }
+}
+
+void GeofenceOverlay::draw(QPainter& painter, const QTransform& groundToScreen) const {
+    if (m_zones.isEmpty()) return;
+
+    painter.save();
+    const QTransform screen = painter.worldTransform();
+    painter.setWorldTransform(groundToScreen, true);
+
+    for (const ZonePath& zone : m_zones) {
+        QPen pen;
+        pen.setCosmetic(true);
+        switch (zone.type) {
+            case GeofenceType::NoFly:
+                pen.setColor(QColor(255, 60, 60, 200));
+                pen.setWidthF(2.0);
+                painter.setBrush(QColor(255, 60, 60, 35));
+                break;
+            case GeofenceType::Restricted:
+                pen.setColor(QColor(255, 150, 0, 180));
+                pen.setWidthF(2.0);
+                pen.setStyle(Qt::DashLine);
+                painter.setBrush(QColor(255, 150, 0, 25));
+                break;
+            case GeofenceType::Corridor:
+                pen.setColor(QColor(80, 200, 255, 160));
+                pen.setWidthF(1.5);
+                pen.setStyle(Qt::DashDotLine);
+                painter.setBrush(Qt::NoBrush);
+                break;
+        }
+        painter.setPen(pen);
+        painter.drawPath(zone.path);
+    }
+
+    // Labels stay upright and unscaled
+    painter.setWorldTransform(screen);
+    painter.setPen(QColor(230, 230, 230, 200));
+    for (const ZonePath& zone : m_zones) {
+        const QPointF anchor = groundToScreen.map(zone.labelAnchor);
+        painter.drawText(QRectF(anchor.x() - 80, anchor.y() - 10, 160, 20), Qt::AlignCenter, zone.name);
+    }
+    painter.restore();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,46 @@
+#ifndef GEOFENCEOVERLAY_H
+#define GEOFENCEOVERLAY_H
+
+#include <QList>
+#include <QPainter>
+#include <QPainterPath>
+#include <QTransform>
+#include <QVector>
+#include "core/GeofenceIndex.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Geofence outlines for the tactical displays
+ *
+ * Each zone's boundary is turned into a path once, in metres east and
+ * north of one tangent plane, when the zones change. A view change only
+ * alters the transform the paths are drawn through, and the pens are
+ * cosmetic, so redrawing costs the fill and stroke alone.
+ */
+class GeofenceOverlay {
+public:
+    void setZones(const QList<GeofenceZone>& zones);
+    bool isEmpty() const { return m_zones.isEmpty(); }
+    // The plane the paths are in
+    const LocalTangentPlane& frame() const { return m_frame; }
+
+    // groundToScreen maps metres in frame() to the painter's coordinates
+    void draw(QPainter& painter, const QTransform& groundToScreen) const;
+
+private:
+    struct ZonePath {
+        QString name;
+        GeofenceType type;
+        QPainterPath path;
+        QPointF labelAnchor;        // Metres, at the centre of the bounds
+    };
+
+    LocalTangentPlane m_frame;
+    QVector<ZonePath> m_zones;
+};
+
+} // namespace CounterUAS
+
+#endif // GEOFENCEOVERLAY_H
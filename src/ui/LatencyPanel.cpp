@@ -0,0 +1,123 @@
+#include "ui/LatencyPanel.h"
+#include "ui/UIFrameScheduler.h"
+#include "utils/PipelineLatency.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+
+namespace CounterUAS {
+
+LatencyPanel::LatencyPanel(QWidget* parent)
+    : QWidget(parent)
+    , m_refreshTimer(new QTimer(this))
+{
+    setupUI();
+
+    connect(m_refreshTimer, &QTimer::timeout, this, &LatencyPanel::refresh);
+    m_refreshTimer->start(1000);
+}
+
+void LatencyPanel::setupUI() {
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(5, 5, 5, 5);
+
+    QHBoxLayout* header = new QHBoxLayout();
+    QLabel* titleLabel = new QLabel("Pipeline Latency", this);
+    titleLabel->setStyleSheet("font-weight: bold; font-size: 12px;");
+    header->addWidget(titleLabel);
+    header->addStretch();
+    QPushButton* resetButton = new QPushButton("Reset", this);
+    connect(resetButton, &QPushButton::clicked, this, &LatencyPanel::onReset);
+    header->addWidget(resetButton);
+    layout->addLayout(header);
+
+    m_table = new QTableWidget(PipelineLatency::STAGE_COUNT, 6, this);
+    m_table->setHorizontalHeaderLabels({"Stage", "Samples", "p50", "p90", "p99", "Max"});
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setAlternatingRowColors(true);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    for (int row = 0; row < PipelineLatency::STAGE_COUNT; ++row) {
+        m_table->setItem(row, 0, new QTableWidgetItem(
+            PipelineLatency::stageName(static_cast<PipelineStage>(row))));
+        for (int column = 1; column < m_table->columnCount(); ++column) {
+            QTableWidgetItem* item = new QTableWidgetItem("-");
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_table->setItem(row, column, item);
+        }
+    }
+    m_table->item(static_cast<int>(PipelineStage::Receive), 0)->setToolTip(
+        "Sensor measurement time to socket read");
+    m_table->item(static_cast<int>(PipelineStage::Parse), 0)->setToolTip(
+        "Decoding one sensor message");
+    m_table->item(static_cast<int>(PipelineStage::EndToEnd), 0)->setToolTip(
+        "Sensor measurement time to the PPI paint showing it");
+    layout->addWidget(m_table);
+
+    m_budgetLabel = new QLabel(this);
+    layout->addWidget(m_budgetLabel);
+}
+
+void LatencyPanel::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+
+    if (m_frameScheduler) {
+        m_refreshTimer->stop();
+        m_frameScheduler->addClient(this, 1, [this](const UIFrame&) { refresh(); });
+    } else {
+        m_refreshTimer->start(1000);
+    }
+}
+
+void LatencyPanel::setBudgetMs(int budgetMs) {
+    m_budgetMs = qMax(1, budgetMs);
+    refresh();
+}
+
+void LatencyPanel::refresh() {
+    if (!isVisible()) return;  // A hidden tab picks up on its next tick
+
+    for (int row = 0; row < PipelineLatency::STAGE_COUNT; ++row) {
+        const LatencyHistogramSnapshot latency =
+            PipelineLatency::snapshot(static_cast<PipelineStage>(row));
+        const bool empty = latency.count == 0;
+        m_table->item(row, 1)->setText(QString::number(latency.count));
+        m_table->item(row, 2)->setText(empty ? "-" : formatUs(latency.percentileUs(0.50)));
+        m_table->item(row, 3)->setText(empty ? "-" : formatUs(latency.percentileUs(0.90)));
+        m_table->item(row, 4)->setText(empty ? "-" : formatUs(latency.percentileUs(0.99)));
+        m_table->item(row, 5)->setText(empty ? "-" : formatUs(latency.maxUs));
+    }
+
+    const LatencyHistogramSnapshot endToEnd = PipelineLatency::snapshot(PipelineStage::EndToEnd);
+    if (endToEnd.count == 0) {
+        m_budgetLabel->setText(QString("Detect to display: no samples (budget %1 ms)").arg(m_budgetMs));
+        m_budgetLabel->setStyleSheet(QString());
+        return;
+    }
+    const qint64 p99Us = endToEnd.percentileUs(0.99);
+    const bool within = p99Us <= m_budgetMs * 1000LL;
+    m_budgetLabel->setText(QString("Detect to display p99 %1 of %2 ms budget")
+                               .arg(formatUs(p99Us))
+                               .arg(m_budgetMs));
+    m_budgetLabel->setStyleSheet(within ? "color: rgb(0, 200, 0);" : "color: rgb(255, 0, 0);");
+}
+
+void LatencyPanel::onReset() {
+    PipelineLatency::reset();
+    refresh();
+}
+
+QString LatencyPanel::formatUs(qint64 us) {
+    if (us < 1000) {
+        return QString("%1 us").arg(us);
+    }
+    return QString("%1 ms").arg(us / 1000.0, 0, 'f', 1);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,50 @@
+#ifndef LATENCYPANEL_H
+#define LATENCYPANEL_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QLabel>
+#include <QTimer>
+
+namespace CounterUAS {
+
+class UIFrameScheduler;
+
+/**
+ * @brief Diagnostics panel showing PipelineLatency per stage
+ *
+ * One row per stage with its sample count and percentiles, and a summary
+ * line comparing the detect-to-display p99 against the latency budget.
+ */
+class LatencyPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_BUDGET_MS = 1000;
+
+    explicit LatencyPanel(QWidget* parent = nullptr);
+
+    // Refreshes on the scheduler's ticks instead of the panel's own timer
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+
+    void setBudgetMs(int budgetMs);
+    int budgetMs() const { return m_budgetMs; }
+
+private slots:
+    void refresh();
+    void onReset();
+
+private:
+    void setupUI();
+    static QString formatUs(qint64 us);
+
+    QTableWidget* m_table;
+    QLabel* m_budgetLabel;
+    QTimer* m_refreshTimer;
+    UIFrameScheduler* m_frameScheduler = nullptr;
+    int m_budgetMs = DEFAULT_BUDGET_MS;
+};
+
+} // namespace CounterUAS
+
+#endif // LATENCYPANEL_H
@@ -7,21 +7,51 @@
 #include "ui/TrackDetailPanel.h"
 #include "ui/SensorStatusPanel.h"
 #include "ui/CameraStatusPanel.h"
+#include "ui/LatencyPanel.h"
+#include "ui/MemoryPanel.h"
 #include "ui/EffectorControlPanel.h"
 #include "ui/AlertQueue.h"
+#include "ui/UIFrameScheduler.h"
 #include "ui/dialogs/SensorConfigDialog.h"
 #include "ui/dialogs/EffectorStatusDialog.h"
 #include "ui/dialogs/SimulationSettingsDialog.h"
 #include "ui/dialogs/RulesOfEngagementDialog.h"
 #include "ui/dialogs/RecordingSettingsDialog.h"
 #include "core/TrackManager.h"
+#include "core/FusionEngine.h"
 #include "core/ThreatAssessor.h"
 #include "core/EngagementManager.h"
+#include "core/CoverageService.h"
+#include "core/SensorResourceManager.h"
+#include "video/VideoDecoder.h"
 #include "video/VideoStreamManager.h"
+#include "video/VideoServiceClient.h"
+#include "video/VideoRestreamer.h"
+#include "network/WebViewerFeed.h"
+#include "network/AlertSync.h"
+#include "network/CoreClient.h"
+#include "network/NetworkManager.h"
+#include "video/RecordingStorage.h"
+#include "video/CaptureService.h"
+#include "video/TrackVideoIndex.h"
 #include "simulators/VideoSimulator.h"
 #include "simulators/SystemSimulationManager.h"
+#include "simulators/SensorSimulator.h"
+#include "simulators/RawCaptureReplayer.h"
+#include "sensors/CooperativeReceiver.h"
+#include "sensors/AsterixSensor.h"
+#include "sensors/RadarVideoSource.h"
 #include "config/ConfigManager.h"
+#include "config/DatabaseManager.h"
+#include "config/FusionCheckpointer.h"
+#include "config/TrackReplayer.h"
+#include "utils/FlightRecorder.h"
 #include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/OverloadController.h"
+#include "utils/RawCapture.h"
+#include "utils/TimeUtils.h"
+#include "utils/Trace.h"
 #include <QMenuBar>
 #include <QMenu>
 #include <QAction>
@@ -33,19 +63,24 @@
 #include <QInputDialog>
 #include <QSettings>
 #include <QToolButton>
+#include <QFile>
 #include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <limits>
 
 namespace CounterUAS {
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
-    , m_trackManager(new TrackManager(this))
+    , m_trackManager(new TrackManager)
+    , m_fusionEngine(new FusionEngine(m_trackManager, this))
     , m_threatAssessor(new ThreatAssessor(m_trackManager, this))
     , m_engagementManager(new EngagementManager(m_trackManager, this))
     , m_videoManager(new VideoStreamManager(this))
     , m_videoSimulator(new VideoSimulator(this))
     , m_simulationManager(new SystemSimulationManager(this))
-    , m_statusUpdateTimer(new QTimer(this))
 {
     setWindowTitle("Counter-UAS Command & Control System");
     setMinimumSize(1280, 720);
@@ -58,19 +93,73 @@ MainWindow::MainWindow(QWidget* parent)
     setupDockWidgets();
     setupConnections();
     initializeSubsystems();
-    setupVideoSimulation();
-    setupSimulationManager();
     setupPPIDisplay();
     
-    m_statusUpdateTimer->setInterval(1000);
-    connect(m_statusUpdateTimer, &QTimer::timeout, this, &MainWindow::updateStatusBar);
-    m_statusUpdateTimer->start();
+    setupFrameScheduler();
+    setupOverloadPolicy();
+    setupUpdateTiers();
+    setupFlightRecorderProbes();
+    
+    // Nothing to simulate until completeStartup()
+    m_startSimAction->setEnabled(false);
+    
+    m_firstTrackConnection = connect(m_trackManager, &TrackManager::trackCreated, this, [this]() {
+        disconnect(m_firstTrackConnection);
+        reportStartupMilestone("first track");
+    });
+    
+    Logger::instance().info("MainWindow", "Window shell initialized");
+}
+
+void MainWindow::completeStartup() {
+    if (m_startupComplete) return;
+    
+    setupVideoService();
+    setupCoreClient();
+    setupVideoSimulation();
+    setupRestreamer();
+    setupWebViewer();
+    setupRecordingStorage();
+    setupCaptureService();
+    setupTrackVideoIndex();
+    setupCoverage();
+    setupSensorTasking();
+    // A console of a core has no sensors or fusion of its own
+    if (!m_coreClient) {
+        setupSimulationManager();
+        setupCooperativeReceiver();
+        setupRawCapture();
+        setupAsterixFeed();
+        setupFusionEngine();
+    }
+    setupAlertSync();
+    setupEventJournal();
     
+    m_startupComplete = true;
+    m_startSimAction->setEnabled(!m_simulationRunning && !m_coreClient);
+    reportStartupMilestone("subsystems ready");
     Logger::instance().info("MainWindow", "Application initialized");
 }
 
+void MainWindow::reportStartupMilestone(const QString& name) {
+    if (m_startupNs == 0) return;
+    const qint64 elapsedMs = (TimeUtils::monotonicNs() - m_startupNs) / 1000000;
+    Logger::instance().info("Startup", QString("%1 after %2 ms").arg(name).arg(elapsedMs));
+    emit startupMilestone(name, elapsedMs);
+}
+
 MainWindow::~MainWindow() {
+    // Waits for a capture that is reading them
+    FlightRecorder::instance().clearProbes();
     stopSimulation();
+    
+    // A last checkpoint while everything it reads is still alive
+    if (m_checkpointer) m_checkpointer->stop();
+    
+    // Bring the manager back to this thread, then let it be deleted after
+    // every other child that still holds a pointer to it
+    m_fusionEngine->stop();
+    m_trackManager->setParent(this);
 }
 
 void MainWindow::setupUI() {
@@ -87,6 +176,13 @@ void MainWindow::setupUI() {
     
     // PPI Display widget
     m_ppiWidget = new PPIDisplayWidget(this);
+    const QString tileCacheDir = ConfigManager::instance().value("map/tileCacheDir", QString()).toString();
+    if (!tileCacheDir.isEmpty()) {
+        m_ppiWidget->setMapTileCacheDirectory(tileCacheDir);
+    }
+    for (const QString& pack : ConfigManager::instance().value("map/tilePacks", QStringList()).toStringList()) {
+        m_ppiWidget->addMapTilePack(pack);
+    }
     m_displayStack->addWidget(m_ppiWidget);
     
     // Start with PPI display as default
@@ -133,12 +229,15 @@ void MainWindow::setupUI() {
     m_statusThreatCount = new QLabel("Threats: 0", this);
     m_statusSimStatus = new QLabel("Simulation: Stopped", this);
     m_statusTime = new QLabel("", this);
+    m_statusLoad = new QLabel("Load: Normal", this);
     
     statusBar()->addWidget(m_statusTrackCount);
     statusBar()->addWidget(new QLabel(" | ", this));
     statusBar()->addWidget(m_statusThreatCount);
     statusBar()->addWidget(new QLabel(" | ", this));
     statusBar()->addWidget(m_statusSimStatus);
+    statusBar()->addWidget(new QLabel(" | ", this));
+    statusBar()->addWidget(m_statusLoad);
     statusBar()->addPermanentWidget(m_statusTime);
     
     statusBar()->showMessage("Ready");
@@ -171,6 +270,11 @@ void MainWindow::setupMenuBar() {
     simMenu->addAction("&Reset Simulation", this, &MainWindow::resetSimulation);
     simMenu->addSeparator();
     simMenu->addAction("Simulation &Settings...", this, &MainWindow::onSimulationSettings);
+    simMenu->addSeparator();
+    m_replayTracksAction = simMenu->addAction("Replay Last &Hour of Tracks");
+    m_replayTracksAction->setCheckable(true);
+    connect(m_replayTracksAction, &QAction::toggled, this, &MainWindow::onReplayTrackHistory);
+    simMenu->addAction("Replay Raw &Capture...", this, &MainWindow::onReplayRawCapture);
     
     // Sensors menu
     QMenu* sensorsMenu = menuBar->addMenu("&Sensors");
@@ -194,6 +298,12 @@ void MainWindow::setupMenuBar() {
     videoMenu->addSeparator();
     videoMenu->addAction("Take &Snapshot", this, &MainWindow::onTakeSnapshot, Qt::Key_F8);
     videoMenu->addAction("&Full Screen Video", this, &MainWindow::toggleFullScreenVideo, Qt::Key_F11);
+    QAction* compositedGridAction = videoMenu->addAction("&Composited Camera Grid");
+    compositedGridAction->setCheckable(true);
+    compositedGridAction->setEnabled(VideoDisplayWidget::openGLAvailable());
+    connect(compositedGridAction, &QAction::toggled, this, [this](bool composited) {
+        m_videoGridWidget->setComposited(composited);
+    });
     
     // Engage menu
     QMenu* engageMenu = menuBar->addMenu("&Engage");
@@ -216,6 +326,14 @@ void MainWindow::setupMenuBar() {
     // Help menu
     QMenu* helpMenu = menuBar->addMenu("&Help");
     helpMenu->addAction("&User Guide", this, &MainWindow::showHelp, Qt::Key_F1);
+    helpMenu->addSeparator();
+    QAction* recordTraceAction = helpMenu->addAction("&Record Performance Trace");
+    recordTraceAction->setCheckable(true);
+    connect(recordTraceAction, &QAction::toggled, this, &MainWindow::onRecordTrace);
+    QAction* saveTraceAction = helpMenu->addAction("Save Performance &Trace...", this, &MainWindow::onSaveTrace);
+    recordTraceAction->setEnabled(Trace::COMPILED_IN);
+    saveTraceAction->setEnabled(Trace::COMPILED_IN);
+    helpMenu->addSeparator();
     helpMenu->addAction("&About...", this, &MainWindow::showAbout);
 }
 
@@ -465,6 +583,37 @@ void MainWindow::setupPPIToolBar() {
         statusBar()->showMessage("PPI map cleared");
     });
 
+    QAction* loadTilePackAction = mapMenu->addAction("Load Tile Pack...");
+    loadTilePackAction->setToolTip("Serve map tiles from an MBTiles site pack");
+    connect(loadTilePackAction, &QAction::triggered, this, [this]() {
+        QString path = QFileDialog::getOpenFileName(
+            this, "Load Tile Pack", QString(), "MBTiles (*.mbtiles);;All Files (*)");
+        if (path.isEmpty()) {
+            return;
+        }
+        m_ppiWidget->addMapTilePack(path);
+        statusBar()->showMessage(QString("Tile pack added: %1").arg(QFileInfo(path).fileName()));
+    });
+
+    QAction* seedTilesAction = mapMenu->addAction("Seed Site Tiles");
+    seedTilesAction->setToolTip("Store the map tiles around the site for offline use");
+    connect(seedTilesAction, &QAction::triggered, this, [this]() {
+        const int zoom = m_ppiWidget->mapZoomLevel();
+        const int queued = m_ppiWidget->mapTileStore()->seedSite(
+            m_ppiWidget->center(), m_ppiWidget->rangeScale(), zoom - 2, zoom + 3);
+        if (queued < 0) {
+            QMessageBox::warning(this, "Seed Site Tiles", "The site area is too large to seed at these zoom levels.");
+            return;
+        }
+        statusBar()->showMessage(QString("Seeding %1 map tiles").arg(queued));
+    });
+    connect(m_ppiWidget->mapTileStore(), &MapTileStore::seedProgress, this, [this](int done, int total) {
+        statusBar()->showMessage(QString("Seeding map tiles: %1 of %2").arg(done).arg(total));
+    });
+    connect(m_ppiWidget->mapTileStore(), &MapTileStore::seedFinished, this, [this](int stored, int failed) {
+        statusBar()->showMessage(QString("Map tiles seeded: %1 stored, %2 failed").arg(stored).arg(failed), 5000);
+    });
+
     mapMenu->addSeparator();
 
     QAction* zoomMapInAction = mapMenu->addAction("Zoom Map In");
@@ -575,6 +724,18 @@ void MainWindow::setupDockWidgets() {
     m_cameraStatusDock->setWidget(m_cameraStatusPanel);
     tabifyDockWidget(m_sensorStatusDock, m_cameraStatusDock);
     
+    // Pipeline latency dock (bottom, tabbed with sensor status)
+    m_latencyDock = new QDockWidget("Pipeline Latency", this);
+    m_latencyPanel = new LatencyPanel(this);
+    m_latencyDock->setWidget(m_latencyPanel);
+    tabifyDockWidget(m_cameraStatusDock, m_latencyDock);
+    
+    // Memory accounting dock (bottom, tabbed with pipeline latency)
+    m_memoryDock = new QDockWidget("Memory", this);
+    m_memoryPanel = new MemoryPanel(this);
+    m_memoryDock->setWidget(m_memoryPanel);
+    tabifyDockWidget(m_latencyDock, m_memoryDock);
+    
     // Raise sensor status tab by default (track list is always visible beside it)
     m_sensorStatusDock->raise();
     
@@ -597,10 +758,14 @@ void MainWindow::setupConnections() {
             this, &MainWindow::onTrackSelected);
     connect(m_mapWidget, &MapWidget::trackSelected,
             this, &MainWindow::onTrackSelected);
-    
-    // Track updates
-    connect(m_trackManager, &TrackManager::trackUpdated,
-            m_mapWidget, &MapWidget::updateTrack);
+    // Box and lasso selections show on both views
+    connect(m_mapWidget, &MapWidget::tracksSelected,
+            m_ppiWidget, &PPIDisplayWidget::selectTracks);
+    connect(m_ppiWidget, &PPIDisplayWidget::tracksSelected,
+            m_mapWidget, &MapWidget::selectTracks);
+    
+    // Track updates (repaint once per published cycle, not once per track)
+    m_mapWidget->setTrackManager(m_trackManager);
     connect(m_trackManager, &TrackManager::trackCreated,
             m_mapWidget, &MapWidget::addTrack);
     connect(m_trackManager, &TrackManager::trackDropped,
@@ -611,6 +776,7 @@ void MainWindow::setupConnections() {
             this, &MainWindow::onAlertClicked);
     
     // Engagement
+    m_engagementManager->setThreatAssessor(m_threatAssessor);
     connect(m_effectorControlPanel, &EffectorControlPanel::engageRequested,
             this, &MainWindow::onEngageRequested);
     
@@ -672,6 +838,206 @@ void MainWindow::initializeSubsystems() {
     
     // Set reference position for track list range calculation
     m_trackListWidget->setReferencePosition(baseAsset.position);
+    
+    // Geofences the rules test, drawn on both tactical displays
+    connect(m_threatAssessor, &ThreatAssessor::geofencesChanged, this, [this]() {
+        const QList<GeofenceZone> zones = m_threatAssessor->geofences();
+        m_ppiWidget->setGeofenceZones(zones);
+        m_mapWidget->setGeofenceZones(zones);
+    });
+    const QString geofenceFile = ConfigManager::instance().value("threat/geofenceFile", QString()).toString();
+    if (!geofenceFile.isEmpty()) {
+        QFile file(geofenceFile);
+        if (file.open(QIODevice::ReadOnly)) {
+            QList<GeofenceZone> zones;
+            for (const QJsonValue& item : QJsonDocument::fromJson(file.readAll()).object()["geofences"].toArray()) {
+                zones.append(GeofenceZone::fromJson(item.toObject()));
+            }
+            m_threatAssessor->setGeofences(zones);
+            Logger::instance().info("MainWindow", QString("Loaded %1 geofences").arg(zones.size()));
+        } else {
+            Logger::instance().warning("MainWindow", "Geofences not loaded from " + geofenceFile);
+        }
+    }
+}
+
+void MainWindow::setupVideoService() {
+    // Cameras decoded by CounterUAS_VideoService survive a C2 restart
+    const QString serverName = ConfigManager::instance().value("videoService/serverName", QString()).toString();
+    if (serverName.isEmpty()) return;
+    
+    m_videoService = new VideoServiceClient(this);
+    m_videoManager->setVideoService(m_videoService);
+    m_videoService->connectToService(serverName);
+    
+    Logger::instance().info("MainWindow", "Cameras decoded by video service " + serverName);
+}
+
+void MainWindow::setupCoreClient() {
+    // Fusion, threat and engagement run in CounterUAS_Core, on this host or
+    // another, and every console shows the same picture
+    ConfigManager& cfg = ConfigManager::instance();
+    CoreClientConfig config;
+    config.sharedMemoryKey = cfg.value("core/sharedMemoryKey", QString()).toString();
+    const QString group = cfg.value("core/multicastGroup", QString()).toString();
+    if (config.sharedMemoryKey.isEmpty() && group.isEmpty()) return;
+    if (config.sharedMemoryKey.isEmpty()) {
+        config.multicast = true;
+        config.multicastGroup.group = QHostAddress(group);
+        config.multicastGroup.port = static_cast<quint16>(
+            cfg.value("core/multicastPort", config.multicastGroup.port).toUInt());
+    }
+    
+    m_coreClient = new CoreClient(this);
+    m_coreClient->setTrackManager(m_trackManager);
+    if (!m_coreClient->start(config)) {
+        // Falls back to fusing here
+        statusBar()->showMessage("Core unavailable: " + m_coreClient->errorString(), 5000);
+        delete m_coreClient;
+        m_coreClient = nullptr;
+        return;
+    }
+    
+    // The mirror's cycle publishes the pictures the displays draw
+    m_trackManager->start();
+    connect(m_coreClient, &CoreClient::attachedChanged, this, [this](bool attached) {
+        m_statusSimStatus->setText(attached ? "Core: Attached" : "Core: Waiting");
+    });
+    m_statusSimStatus->setText(m_coreClient->isAttached() ? "Core: Attached" : "Core: Waiting");
+    
+    Logger::instance().info("MainWindow", "Console of the C2 core");
+}
+
+void MainWindow::setupRestreamer() {
+    // Remote consoles watch the primary camera with its symbology burned in
+    ConfigManager& cfg = ConfigManager::instance();
+    const int port = cfg.value("restream/port", 0).toInt();
+    if (port <= 0) return;
+    
+    RestreamConfig config;
+    config.path = cfg.value("restream/path", config.path).toString();
+    config.codec = cfg.value("restream/codec", config.codec).toString();
+    config.hardwareEncoder = cfg.value("restream/hardwareEncoder", config.hardwareEncoder).toBool();
+    config.fps = cfg.value("restream/fps", config.fps).toDouble();
+    config.maxSubscribers = cfg.value("restream/maxSubscribers", config.maxSubscribers).toInt();
+    config.klvMetadata = cfg.value("restream/klvMetadata", config.klvMetadata).toBool();
+    
+    m_restreamer = new VideoRestreamer(this);
+    m_restreamer->setConfig(config);
+    m_restreamer->setVideoManager(m_videoManager);
+    m_restreamer->setOverlayRenderer(m_primaryVideoWidget->overlayRenderer());
+    if (!m_restreamer->start(static_cast<quint16>(port))) {
+        statusBar()->showMessage("Re-streaming unavailable: " + m_restreamer->errorString(), 5000);
+    }
+}
+
+void MainWindow::setupWebViewer() {
+    // Browsers follow the air picture over a WebSocket
+    ConfigManager& cfg = ConfigManager::instance();
+    const int port = cfg.value("webViewer/port", 0).toInt();
+    if (port <= 0) return;
+    
+    WebViewerConfig config;
+    config.path = cfg.value("webViewer/path", config.path).toString();
+    config.maxViewers = cfg.value("webViewer/maxViewers", config.maxViewers).toInt();
+    config.maxRateHz = cfg.value("webViewer/maxRateHz", config.maxRateHz).toDouble();
+    
+    m_webViewer = new WebViewerFeed(this);
+    m_webViewer->setConfig(config);
+    m_webViewer->setTrackManager(m_trackManager);
+    if (!m_webViewer->start(static_cast<quint16>(port))) {
+        statusBar()->showMessage("Web viewer feed unavailable: " + m_webViewer->errorString(), 5000);
+    }
+}
+
+void MainWindow::setupRecordingStorage() {
+    // Continuous recording rolls through preallocated segments under quotas
+    ConfigManager& cfg = ConfigManager::instance();
+    RecordingStorageConfig config;
+    config.directory = cfg.value("recording/directory", config.directory).toString();
+    config.segmentMegabytes = cfg.value("recording/segmentMegabytes", config.segmentMegabytes).toInt();
+    config.quotaMegabytes = cfg.value("recording/quotaGigabytes", 0).toLongLong() * 1024;
+    config.cameraQuotaMegabytes = cfg.value("recording/cameraQuotaGigabytes", 0).toLongLong() * 1024;
+    config.minFreeMegabytes = cfg.value("recording/minFreeMegabytes", config.minFreeMegabytes).toLongLong();
+    
+    m_recordingStorage = new RecordingStorage(this);
+    m_recordingStorage->setConfig(config);
+    if (!m_recordingStorage->open()) {
+        delete m_recordingStorage;
+        m_recordingStorage = nullptr;
+        return;
+    }
+    
+    // Signalled from the recorders' writer threads; the database is this thread's
+    connect(m_recordingStorage, &RecordingStorage::segmentFinished, this,
+            [](const QString& clipId, const QString& path, const QVariantMap& metadata) {
+                DatabaseManager::instance().saveVideoClipMetadata(clipId, path, metadata);
+            });
+    connect(m_recordingStorage, &RecordingStorage::segmentDeleted, this,
+            [](const QString& clipId, const QString&) {
+                DatabaseManager::instance().removeVideoClipMetadata(clipId);
+            });
+    m_videoManager->setRecordingStorage(m_recordingStorage);
+}
+
+void MainWindow::setupCaptureService() {
+    // Stills are encoded and written on the task pool; only the request is made here
+    ConfigManager& cfg = ConfigManager::instance();
+    CaptureConfig config;
+    config.directory = cfg.value("capture/directory", config.directory).toString();
+    config.format = cfg.value("capture/format", "jpeg").toString().compare("png", Qt::CaseInsensitive) == 0
+        ? CaptureFormat::Png : CaptureFormat::Jpeg;
+    config.jpegQuality = cfg.value("capture/jpegQuality", config.jpegQuality).toInt();
+    config.burstFrames = cfg.value("capture/burstFrames", config.burstFrames).toInt();
+    config.preRollFrames = cfg.value("capture/preRollFrames", config.preRollFrames).toInt();
+    
+    m_captureService = new CaptureService(this);
+    m_captureService->setConfig(config);
+    m_captureService->setStorage(m_recordingStorage);
+    m_captureService->setVideoManager(m_videoManager);
+    m_captureService->setPreRollCameras(QStringList{m_videoManager->primaryStreamId()});
+    connect(m_videoManager, &VideoStreamManager::primaryStreamChanged, m_captureService,
+            [this](const QString& cameraId) { m_captureService->setPreRollCameras(QStringList{cameraId}); });
+    
+    connect(m_captureService, &CaptureService::captureSaved, this, [this](const CaptureRecord& record) {
+        if (record.burstId.isEmpty()) statusBar()->showMessage("Snapshot saved: " + record.path, 5000);
+    });
+    connect(m_captureService, &CaptureService::captureFailed, this, [this](const QString&, const QString& error) {
+        statusBar()->showMessage("Snapshot failed: " + error, 5000);
+    });
+    
+    // Bursts around the moments an engagement is reviewed by
+    auto burst = [this](const QString& engagementId, const QString& label) {
+        CaptureTags tags;
+        tags.engagementId = engagementId;
+        tags.label = label;
+        if (const EngagementRecord* record = m_engagementManager->engagement(engagementId)) {
+            tags.trackId = record->trackId;
+        } else {
+            tags.trackId = m_engagementManager->selectedTrackId();
+        }
+        QString cameraId = m_videoManager->cameraForTrack(tags.trackId);
+        if (cameraId.isEmpty()) cameraId = m_videoManager->primaryStreamId();
+        m_captureService->burst(cameraId, tags);
+    };
+    connect(m_engagementManager, &EngagementManager::authorizationGranted, m_captureService,
+            [this, burst](const QString&) { burst(m_engagementManager->currentEngagementId(), "authorization"); });
+    connect(m_engagementManager, &EngagementManager::engagementStarted, m_captureService,
+            [burst](const QString& engagementId) { burst(engagementId, "execute"); });
+    connect(m_engagementManager, &EngagementManager::engagementCompleted, m_captureService,
+            [burst](const QString& engagementId, BDAResult) { burst(engagementId, "bda"); });
+}
+
+void MainWindow::setupTrackVideoIndex() {
+    // Where each track was recorded, kept as it happens; sightings of a
+    // segment go with it when storage evicts it
+    m_trackVideoIndex = new TrackVideoIndex(this);
+    m_trackVideoIndex->setVideoManager(m_videoManager);
+    m_trackVideoIndex->setTrackManager(m_trackManager);
+    connect(m_trackVideoIndex, &TrackVideoIndex::sightingsClosed, this,
+            [](const QVector<VideoSighting>& sightings) {
+                DatabaseManager::instance().saveVideoSightings(sightings);
+            });
 }
 
 void MainWindow::setupVideoSimulation() {
@@ -685,13 +1051,79 @@ void MainWindow::setupVideoSimulation() {
     connect(m_videoSimulator, &VideoSimulator::cameraFrameReady,
             this, &MainWindow::onSimulationCameraFrame);
     
-    // Connect video manager frame signals to grid widget
-    connect(m_videoManager, &VideoStreamManager::frameReady,
-            m_videoGridWidget, &VideoGridWidget::updateFrame);
+    // Grid tiles subscribe through the manager at their own size
+    m_videoGridWidget->setVideoManager(m_videoManager);
     
     Logger::instance().info("MainWindow", "Video simulation configured");
 }
 
+void MainWindow::setupCoverage() {
+    ConfigManager& cfg = ConfigManager::instance();
+    m_coverage = new CoverageService(this);
+    
+    CoverageServiceConfig config;
+    config.cacheDirectory = cfg.value("coverage/cacheDir", QString()).toString();
+    config.raster.azimuthBinDeg = cfg.value("coverage/azimuthBinDeg", config.raster.azimuthBinDeg).toDouble();
+    config.raster.rangeBinM = cfg.value("coverage/rangeBinM", config.raster.rangeBinM).toDouble();
+    m_coverage->setConfig(config);
+    
+    // DEM tiles for the wide area, a surveyed grid over them near the site;
+    // with neither the ground is flat and only the horizon masks
+    auto terrain = std::make_shared<TerrainModel>();
+    const QString demDirectory = cfg.value("terrain/demDirectory", QString()).toString();
+    if (!demDirectory.isEmpty()) {
+        auto dem = std::make_shared<DemTileStore>(demDirectory, cfg.value("terrain/demOpenTiles", 16).toInt());
+        if (dem->isEmpty()) {
+            Logger::instance().warning("MainWindow", "No DEM tiles in " + demDirectory);
+        } else {
+            terrain->setDemStore(dem);
+        }
+    }
+    const QString terrainFile = cfg.value("coverage/terrainFile", QString()).toString();
+    if (!terrainFile.isEmpty()) {
+        QString error;
+        if (!terrain->loadAsciiGrid(terrainFile, &error)) {
+            Logger::instance().warning("MainWindow",
+                QString("Terrain %1 not loaded: %2").arg(terrainFile, error));
+        }
+    }
+    m_coverage->setTerrain(terrain);
+    
+    // Sites are added, and built in the background, as devices register
+    m_simulationManager->setCoverageService(m_coverage);
+}
+
+void MainWindow::setupSensorTasking() {
+    const ConfigManager& cfg = ConfigManager::instance();
+    if (!cfg.value("sensorTasking/enabled", true).toBool()) return;
+    m_sensorTasking = new SensorResourceManager(this);
+    
+    SensorResourceConfig config;
+    config.planIntervalMs = cfg.value("sensorTasking/planIntervalMs", config.planIntervalMs).toInt();
+    config.maxRequests = cfg.value("sensorTasking/maxRequests", config.maxRequests).toInt();
+    config.minThreatLevel = cfg.value("sensorTasking/minThreatLevel", config.minThreatLevel).toInt();
+    config.impactTimeSec = cfg.value("sensorTasking/impactTimeSec", config.impactTimeSec).toDouble();
+    config.stickiness = cfg.value("sensorTasking/stickiness", config.stickiness).toDouble();
+    config.radarDwells = cfg.value("sensorTasking/radarDwells", config.radarDwells).toInt();
+    config.radarDwellMs = cfg.value("sensorTasking/radarDwellMs", config.radarDwellMs).toInt();
+    config.radarRevisitMs = cfg.value("sensorTasking/radarRevisitMs", config.radarRevisitMs).toInt();
+    config.radarCommandsPerSec = cfg.value("sensorTasking/radarCommandsPerSec", config.radarCommandsPerSec).toDouble();
+    config.rfCueHalfWidthDeg = cfg.value("sensorTasking/rfCueHalfWidthDeg", config.rfCueHalfWidthDeg).toDouble();
+    config.rfCueMs = cfg.value("sensorTasking/rfCueMs", config.rfCueMs).toInt();
+    config.rfCommandsPerSec = cfg.value("sensorTasking/rfCommandsPerSec", config.rfCommandsPerSec).toDouble();
+    // Off by default: the assessor already slews cameras onto the top threat
+    config.cueCameras = cfg.value("sensorTasking/cueCameras", false).toBool();
+    config.cameraHoldMs = cfg.value("sensorTasking/cameraHoldMs", config.cameraHoldMs).toInt();
+    config.cameraCommandsPerSec = cfg.value("sensorTasking/cameraCommandsPerSec",
+                                            config.cameraCommandsPerSec).toDouble();
+    m_sensorTasking->setConfig(config);
+    m_sensorTasking->setThreatAssessor(m_threatAssessor);
+    
+    // Sensors join as the simulation registers them
+    m_simulationManager->setSensorResourceManager(m_sensorTasking);
+    m_sensorTasking->start();
+}
+
 void MainWindow::setupSimulationManager() {
     // Configure simulation manager with all subsystems
     m_simulationManager->setTrackManager(m_trackManager);
@@ -724,31 +1156,431 @@ void MainWindow::setupPPIDisplay() {
     connect(m_ppiWidget, &PPIDisplayWidget::trackDoubleClicked,
             this, &MainWindow::onEngageRequested);
     
-    // Connect track manager to PPI widget
-    connect(m_trackManager, &TrackManager::trackUpdated,
-            m_ppiWidget, &PPIDisplayWidget::updateTrack);
+    // Connect track manager to PPI widget (state repaints come from the
+    // frame scheduler's ticks)
     connect(m_trackManager, &TrackManager::trackCreated,
             m_ppiWidget, &PPIDisplayWidget::addTrack);
     connect(m_trackManager, &TrackManager::trackDropped,
             m_ppiWidget, &PPIDisplayWidget::removeTrack);
     
+    // Raw radar video under the tracks, from an antenna at the PPI centre
+    ConfigManager& cfg = ConfigManager::instance();
+    const int videoPort = cfg.value("radarVideo/port", 0).toInt();
+    if (videoPort > 0) {
+        RadarVideoConfig video;
+        video.port = static_cast<quint16>(videoPort);
+        video.azimuthCount = cfg.value("radarVideo/azimuthCount", video.azimuthCount).toInt();
+        video.rangeBins = cfg.value("radarVideo/rangeBins", video.rangeBins).toInt();
+        video.maxRangeM = cfg.value("radarVideo/maxRangeM", video.maxRangeM).toDouble();
+        video.site = m_ppiWidget->center();
+        m_radarVideo = new RadarVideoSource(this);
+        m_radarVideo->setConfig(video);
+        if (m_radarVideo->start()) {
+            m_ppiWidget->setRadarVideo(m_radarVideo);
+        }
+    }
+    
     Logger::instance().info("MainWindow", "PPI display configured - linked with Map widget");
 }
 
+void MainWindow::setupAlertSync() {
+    // Alerts raised and acknowledged on any console show on every other.
+    // Peers are "host:port" UDP links; both ends bind the port, so each
+    // pair of consoles needs a port of its own, the same at both ends.
+    ConfigManager& cfg = ConfigManager::instance();
+    const QStringList peers = cfg.value("alertSync/peers", QStringList()).toStringList();
+    if (peers.isEmpty()) return;
+    
+    m_alertNetwork = new NetworkManager(this);
+    const QString nodeId = cfg.value("alertSync/nodeId", QSysInfo::machineHostName()).toString();
+    m_alertNetwork->setNodeId(nodeId);
+    m_alertSync = new AlertSync(m_alertNetwork, this);
+    m_alertSync->setNodeId(nodeId);
+    m_alertSync->setDigestInterval(cfg.value("alertSync/digestIntervalMs", m_alertSync->digestInterval()).toInt());
+    m_alertSync->setRelay(cfg.value("alertSync/relay", m_alertSync->relay()).toBool());
+    m_alertSync->attach(m_threatAssessor);
+    
+    for (const QString& peer : peers) {
+        const int colon = peer.lastIndexOf(':');
+        const int port = colon > 0 ? peer.mid(colon + 1).toInt() : 0;
+        if (port <= 0) {
+            Logger::instance().warning("MainWindow", "Alert sync peer without a port: " + peer);
+            continue;
+        }
+        ConnectionConfig config;
+        config.connectionId = "alert-sync-" + peer;
+        config.name = "Alert sync " + peer;
+        config.host = peer.left(colon);
+        config.port = port;
+        config.useTcp = false;
+        m_alertNetwork->connectTo(m_alertNetwork->addConnection(config));
+    }
+    Logger::instance().info("MainWindow", QString("Alert sync as %1 with %2 peers").arg(nodeId).arg(peers.size()));
+}
+
+void MainWindow::setupEventJournal() {
+    EventJournal* journal = DatabaseManager::instance().journal();
+    if (!journal) return;
+    
+    // Each handler costs one append into the mapped journal, no disk wait
+    connect(m_engagementManager, &EngagementManager::stateChanged, this, [this, journal](EngagementState state) {
+        JournalEvent event;
+        event.type = JournalEventType::EngagementState;
+        event.subjectId = m_engagementManager->currentEngagementId();
+        event.trackId = m_engagementManager->selectedTrackId();
+        event.actorId = m_engagementManager->selectedEffectorId();
+        event.code = static_cast<int>(state);
+        event.previousCode = m_journalEngagementState;
+        if (const EngagementRecord* record = m_engagementManager->currentEngagement()) {
+            event.position = record->targetPosition;
+        }
+        m_journalEngagementState = static_cast<int>(state);
+        journal->append(event);
+    });
+    auto authorization = [this, journal](int code, const QString& operatorId, const QString& reason) {
+        JournalEvent event;
+        event.type = JournalEventType::Authorization;
+        event.subjectId = m_engagementManager->currentEngagementId();
+        event.trackId = m_engagementManager->selectedTrackId();
+        event.actorId = operatorId;
+        event.code = code;
+        event.text = reason;
+        journal->append(event);
+    };
+    connect(m_engagementManager, &EngagementManager::authorizationGranted, this,
+            [authorization](const QString& operatorId) { authorization(1, operatorId, QString()); });
+    connect(m_engagementManager, &EngagementManager::authorizationDenied, this,
+            [authorization](const QString& reason) { authorization(0, QString(), reason); });
+    connect(m_engagementManager, &EngagementManager::authorizationTimeout, this,
+            [authorization]() { authorization(-1, QString(), "Timed out"); });
+    auto result = [this, journal](const QString& engagementId, BDAResult bda, const QString& text) {
+        JournalEvent event;
+        event.type = JournalEventType::EngagementResult;
+        event.subjectId = engagementId;
+        if (const EngagementRecord* record = m_engagementManager->engagement(engagementId)) {
+            event.trackId = record->trackId;
+            event.actorId = record->effectorId;
+            event.position = record->targetPosition;
+        }
+        event.code = static_cast<int>(bda);
+        event.text = text;
+        journal->append(event);
+    };
+    connect(m_engagementManager, &EngagementManager::engagementCompleted, this,
+            [result](const QString& engagementId, BDAResult bda) { result(engagementId, bda, QString()); });
+    connect(m_engagementManager, &EngagementManager::engagementAborted, this,
+            [result](const QString& engagementId, const QString& reason) {
+                result(engagementId, BDAResult::Unknown, "Aborted: " + reason);
+            });
+    connect(m_engagementManager, &EngagementManager::engagementFailed, this,
+            [result](const QString& engagementId, const QString& reason) {
+                result(engagementId, BDAResult::Unknown, "Failed: " + reason);
+            });
+    
+    connect(m_threatAssessor, &ThreatAssessor::newAlert, this, [journal](const ThreatAlert& alert) {
+        JournalEvent event;
+        event.type = JournalEventType::Alert;
+        event.subjectId = alert.alertId;
+        event.trackId = alert.trackId;
+        event.actorId = alert.ruleId;
+        event.code = alert.threatLevel;
+        event.text = alert.message;
+        event.timestampMs = alert.timestamp.toMSecsSinceEpoch();
+        journal->append(event);
+    });
+    connect(m_threatAssessor, &ThreatAssessor::alertAcknowledged, this, [this, journal](const QString& alertId) {
+        JournalEvent event;
+        event.type = JournalEventType::AlertAcknowledged;
+        event.subjectId = alertId;
+        if (const ThreatAlert* alert = m_threatAssessor->alert(alertId)) {
+            event.trackId = alert->trackId;
+            event.actorId = alert->acknowledgedBy;
+        }
+        journal->append(event);
+    });
+    
+    // Direct, so track events need not queue to this thread when the
+    // manager runs on the fusion thread; replayed tracks are already on record
+    auto trackEvent = [this, journal](JournalEventType type, const QString& trackId, int code) {
+        if (m_trackManager->isReplayMode()) return;
+        JournalEvent event;
+        event.type = type;
+        event.subjectId = trackId;
+        event.trackId = trackId;
+        event.code = code;
+        if (const Track* track = m_trackManager->track(trackId)) {
+            event.position = track->position();
+        }
+        journal->append(event);
+    };
+    connect(m_trackManager, &TrackManager::trackCreated, this,
+            [trackEvent](const QString& trackId) { trackEvent(JournalEventType::TrackCreated, trackId, 0); },
+            Qt::DirectConnection);
+    connect(m_trackManager, &TrackManager::trackDropped, this,
+            [trackEvent](const QString& trackId) { trackEvent(JournalEventType::TrackDropped, trackId, 0); },
+            Qt::DirectConnection);
+    connect(m_trackManager, &TrackManager::trackClassificationChanged, this,
+            [trackEvent](const QString& trackId, TrackClassification cls) {
+                trackEvent(JournalEventType::TrackClassified, trackId, static_cast<int>(cls));
+            }, Qt::DirectConnection);
+    // Batched assessments report their reclassifications together
+    connect(m_trackManager, &TrackManager::threatAssessmentsApplied, this,
+            [trackEvent](const QVector<TrackThreatUpdate>& updates) {
+                for (const TrackThreatUpdate& update : updates) {
+                    if (update.classification == TrackClassification::Unknown ||
+                        update.classification == update.previousClassification) continue;
+                    trackEvent(JournalEventType::TrackClassified, TrackManager::formatTrackId(update.handle),
+                               static_cast<int>(update.classification));
+                }
+            }, Qt::DirectConnection);
+}
+
+void MainWindow::setupFrameScheduler() {
+    // One clock and one track picture per display refresh for every view;
+    // hidden docks and a minimised window fall back to the idle rate
+    m_frameScheduler = new UIFrameScheduler(m_trackManager, this, this);
+    const ConfigKey<int> idleRefreshHz = ConfigManager::instance().key<int>("ui/idleRefreshHz", 2);
+    m_frameScheduler->setIdleRateHz(idleRefreshHz);
+    ConfigManager::instance().subscribe("ui/idleRefreshHz", this, [this, idleRefreshHz](const QStringList&) {
+        m_frameScheduler->setIdleRateHz(idleRefreshHz);
+    });
+    
+    m_ppiWidget->setFrameScheduler(m_frameScheduler);
+    m_mapWidget->setFrameScheduler(m_frameScheduler);
+    m_trackListWidget->setFrameScheduler(m_frameScheduler);
+    m_trackDetailPanel->setFrameScheduler(m_frameScheduler);
+    m_sensorStatusPanel->setFrameScheduler(m_frameScheduler);
+    m_cameraStatusPanel->setFrameScheduler(m_frameScheduler);
+    m_effectorControlPanel->setFrameScheduler(m_frameScheduler);
+    m_latencyPanel->setFrameScheduler(m_frameScheduler);
+    m_memoryPanel->setFrameScheduler(m_frameScheduler);
+    m_frameScheduler->addClient(statusBar(), 1, [this](const UIFrame& frame) { updateStatusBar(frame); });
+    m_frameScheduler->setClientTriggers(statusBar(), FrameOnTracks | FrameOnStatus,
+                                        StatusBoard::kindBit(StatusKind::System));
+    m_frameScheduler->addClient(m_statusTime, 1, [this](const UIFrame&) { updateStatusClock(); });
+    
+    m_frameScheduler->start();
+}
+
+void MainWindow::setupOverloadPolicy() {
+    // Each level keeps what the ones below it shed; the primary stream,
+    // threatening tracks and the displays' content are never shed
+    const ConfigManager& config = ConfigManager::instance();
+    const double secondaryVideoFps = config.value("overload/secondaryVideoFps", 5.0).toDouble();
+    const int lowThreatStride = config.value("overload/lowThreatStride", 4).toInt();
+    const int coarseDisplayHz = config.value("overload/coarseDisplayHz", 15).toInt();
+    
+    const auto apply = [this, secondaryVideoFps, lowThreatStride, coarseDisplayHz](OverloadLevel level) {
+        m_videoManager->setSecondaryFrameRateCap(level >= OverloadLevel::ReducedVideo ? secondaryVideoFps : 0.0);
+        m_videoManager->setDecodeShedding(level >= OverloadLevel::ReducedVideo);
+        m_threatAssessor->setLowThreatStride(level >= OverloadLevel::ReducedAssessment ? lowThreatStride : 1);
+        if (level >= OverloadLevel::SweepSuspended) {
+            m_ppiWidget->stopSweep();
+        } else if (m_ppiSweepAction->isChecked()) {
+            m_ppiWidget->startSweep();
+        }
+        m_frameScheduler->setRateCapHz(level >= OverloadLevel::CoarseDisplay ? coarseDisplayHz : 0);
+        
+        static const char* const names[OVERLOAD_LEVELS] = {
+            "Normal", "Reduced video", "Reduced assessment", "Sweep suspended", "Coarse display"};
+        m_statusLoad->setText(QString("Load: %1").arg(names[static_cast<int>(level)]));
+        m_statusLoad->setStyleSheet(level == OverloadLevel::Normal ? QString() : QString("color: #ffaa00;"));
+    };
+    connect(&OverloadController::instance(), &OverloadController::levelChanged, this,
+            [apply](OverloadLevel level, OverloadLevel) { apply(level); });
+    apply(OverloadController::instance().level());
+}
+
+void MainWindow::setupUpdateTiers() {
+    // The assessor sorts tracks into tiers; the manager refreshes each at its tier's rate
+    const ConfigManager& config = ConfigManager::instance();
+    
+    TrackManagerConfig trackConfig = m_trackManager->config();
+    trackConfig.tieredRates = config.value("trackManager/tieredRates", false).toBool();
+    trackConfig.priorityRateHz = config.value("trackManager/priorityRateHz", 25).toInt();
+    trackConfig.backgroundRateHz = config.value("trackManager/backgroundRateHz", 1).toInt();
+    m_trackManager->setConfig(trackConfig);
+    
+    ThreatAssessorConfig threatConfig = m_threatAssessor->config();
+    threatConfig.tieredRates = config.value("threatAssessor/tieredRates", false).toBool();
+    threatConfig.priorityAssessmentHz = config.value("threatAssessor/priorityAssessmentHz", 20).toInt();
+    threatConfig.backgroundAssessmentHz = config.value("threatAssessor/backgroundAssessmentHz", 1.0).toDouble();
+    threatConfig.priorityRangeM = config.value("threatAssessor/priorityRangeM", 1000.0).toDouble();
+    threatConfig.priorityImpactSec = config.value("threatAssessor/priorityImpactSec", 60.0).toDouble();
+    threatConfig.backgroundRangeM = config.value("threatAssessor/backgroundRangeM", 3000.0).toDouble();
+    m_threatAssessor->setConfig(threatConfig);
+}
+
+void MainWindow::setupFlightRecorderProbes() {
+    // Read on a pool thread just after the overrun, so only what is safe there
+    FlightRecorder& recorder = FlightRecorder::instance();
+    recorder.setProbe("tracks", [this]() { return double(m_trackManager->trackCount()); });
+    recorder.setProbe("streams", [this]() { return double(m_videoManager->activeStreamCount()); });
+    recorder.setProbe("fusionQueue", [this]() { return double(m_fusionEngine->statistics().queueDepth); });
+    recorder.setProbe("decodeQueue", []() { return double(VideoDecoder::queuedPackets()); });
+    
+    QVector<MetricGauge*> lanes;
+    for (const char* lane : {"critical", "normal", "bulk"}) {
+        lanes.append(MetricsRegistry::instance().gauge("cuas_network_queued_frames", "Frames waiting to send",
+                                                       {{"lane", lane}}));
+    }
+    recorder.setProbe("networkQueue", [lanes]() {
+        double queued = 0.0;
+        for (const MetricGauge* gauge : lanes) queued += gauge->value();
+        return queued;
+    });
+}
+
+void MainWindow::setupFusionEngine() {
+    FusionEngineConfig config;
+    config.threaded = ConfigManager::instance().value("fusion/threaded", false).toBool();
+    config.queueCapacity = ConfigManager::instance().value("fusion/queueCapacity", 256).toInt();
+    m_fusionEngine->setConfig(config);
+    
+    if (SensorSimulator* sensors = m_simulationManager->sensorSimulator()) {
+        sensors->setFusionEngine(m_fusionEngine);
+    }
+    
+    // Recorded for ReplayEngine, in the order fusion received them
+    m_fusionEngine->setScanTap([](const QVector<SensorDetection>& scan) {
+        DatabaseManager::instance().recordDetectionScan(scan);
+    });
+    
+    // Everything that configures the manager directly must run before this
+    setupCheckpointer();
+    m_fusionEngine->start();
+}
+
+void MainWindow::setupCooperativeReceiver() {
+    // ADS-B and Remote ID tag the tracks of aircraft and drones that say who they are
+    ConfigManager& cfg = ConfigManager::instance();
+    CooperativeReceiverConfig config;
+    config.adsbHost = cfg.value("cooperative/adsbHost", QString()).toString();
+    config.adsbPort = static_cast<quint16>(cfg.value("cooperative/adsbPort", config.adsbPort).toUInt());
+    config.adsbFormat = cfg.value("cooperative/adsbFormat", "beast").toString().compare("sbs", Qt::CaseInsensitive) == 0
+        ? CooperativeReceiverConfig::AdsbFormat::Sbs : CooperativeReceiverConfig::AdsbFormat::Beast;
+    config.remoteIdHost = cfg.value("cooperative/remoteIdHost", config.remoteIdHost).toString();
+    config.remoteIdPort = static_cast<quint16>(cfg.value("cooperative/remoteIdPort", 0).toUInt());
+    if (config.adsbHost.isEmpty() && config.remoteIdPort == 0) return;
+    
+    config.maxTargets = cfg.value("cooperative/maxTargets", config.maxTargets).toInt();
+    config.forwardIntervalMs = cfg.value("cooperative/forwardIntervalMs", config.forwardIntervalMs).toInt();
+    config.maxRangeM = cfg.value("cooperative/maxRangeM", config.maxRangeM).toDouble();
+    config.friendlyIds = cfg.value("cooperative/friendlyIds", QStringList()).toStringList();
+    
+    m_cooperative = new CooperativeReceiver("COOP-001", this);
+    m_cooperative->setName("ADS-B / Remote ID");
+    m_cooperative->setConfig(config);
+    m_cooperative->setPosition(m_simulationManager->basePosition());
+    m_fusionEngine->attachSensor(m_cooperative);
+    m_sensorStatusPanel->addSensor(m_cooperative->sensorId(), m_cooperative->name(), m_cooperative->sensorType());
+    m_cooperative->start();
+}
+
+void MainWindow::setupRawCapture() {
+    // The bytes the sensors read, for replay through their parsers
+    ConfigManager& cfg = ConfigManager::instance();
+    RawCaptureConfig config;
+    config.directory = cfg.value("capture/directory", QString()).toString();
+    if (config.directory.isEmpty()) return;
+    config.segmentMs = cfg.value("capture/segmentMs", config.segmentMs).toLongLong();
+    config.segmentBytes = cfg.value("capture/segmentBytes", config.segmentBytes).toLongLong();
+    config.maxQueuedBytes = cfg.value("capture/maxQueuedBytes", config.maxQueuedBytes).toLongLong();
+    
+    m_rawCapture = std::make_shared<RawCaptureRecorder>(config);
+    m_rawCapture->start();
+    // Simulated sensors read nothing, so only those with a connection record
+    for (SensorInterface* sensor : findChildren<SensorInterface*>()) {
+        sensor->setCapture(m_rawCapture);
+    }
+    Logger::instance().info("MainWindow", "Capturing raw sensor input to " + config.directory);
+}
+
+void MainWindow::setupAsterixFeed() {
+    // Plots and tracks of third-party radars and the air picture, over ASTERIX
+    ConfigManager& cfg = ConfigManager::instance();
+    AsterixSensorConfig config;
+    config.port = static_cast<quint16>(cfg.value("asterix/port", 0).toUInt());
+    if (config.port == 0) return;
+    
+    config.host = cfg.value("asterix/host", config.host).toString();
+    config.multicastGroup = cfg.value("asterix/multicastGroup", QString()).toString();
+    config.multicastInterface = cfg.value("asterix/multicastInterface", QString()).toString();
+    config.receiveBufferBytes = cfg.value("asterix/receiveBufferBytes", config.receiveBufferBytes).toInt();
+    config.acceptMonoradar = cfg.value("asterix/acceptMonoradar", config.acceptMonoradar).toBool();
+    config.acceptSystemTracks = cfg.value("asterix/acceptSystemTracks", config.acceptSystemTracks).toBool();
+    // "SAC/SIC" pairs
+    for (const QString& source : cfg.value("asterix/sources", QStringList()).toStringList()) {
+        const QStringList parts = source.split('/');
+        if (parts.size() != 2) continue;
+        config.sources.append(static_cast<quint16>((parts[0].toUInt() & 0xFF) << 8 | (parts[1].toUInt() & 0xFF)));
+    }
+    config.dropSimulated = cfg.value("asterix/dropSimulated", config.dropSimulated).toBool();
+    config.maxRangeM = cfg.value("asterix/maxRangeM", config.maxRangeM).toDouble();
+    config.groundElevationM = cfg.value("asterix/groundElevationM", config.groundElevationM).toDouble();
+    config.useSystemReference = cfg.value("asterix/referenceLatitude").isValid();
+    config.systemReference.latitude = cfg.value("asterix/referenceLatitude", 0.0).toDouble();
+    config.systemReference.longitude = cfg.value("asterix/referenceLongitude", 0.0).toDouble();
+    
+    GeoPosition site = m_simulationManager->basePosition();
+    site.latitude = cfg.value("asterix/radarLatitude", site.latitude).toDouble();
+    site.longitude = cfg.value("asterix/radarLongitude", site.longitude).toDouble();
+    site.altitude = cfg.value("asterix/radarHeightM", site.altitude).toDouble();
+    
+    m_asterix = new AsterixSensor("ASTERIX-001", this);
+    m_asterix->setName("ASTERIX");
+    m_asterix->setPosition(site);
+    m_asterix->setConfig(config);
+    if (m_coverage) {
+        m_asterix->setTerrain(m_coverage->terrain());
+    }
+    if (m_rawCapture) {
+        m_asterix->setCapture(m_rawCapture);
+    }
+    m_fusionEngine->attachSensor(m_asterix);
+    m_sensorStatusPanel->addSensor(m_asterix->sensorId(), m_asterix->name(), m_asterix->sensorType());
+    m_asterix->start();
+}
+
+void MainWindow::setupCheckpointer() {
+    ConfigManager& cfg = ConfigManager::instance();
+    FusionCheckpointConfig config;
+    config.path = cfg.value("checkpoint/path", QString()).toString();
+    if (config.path.isEmpty()) return;
+    config.intervalMs = cfg.value("checkpoint/intervalMs", config.intervalMs).toInt();
+    config.maxRestoreAgeMs = cfg.value("checkpoint/maxRestoreAgeMs", config.maxRestoreAgeMs).toLongLong();
+    config.syncToDisk = cfg.value("checkpoint/syncToDisk", config.syncToDisk).toBool();
+    
+    // The last run's picture goes in before the first scan does
+    m_checkpointer = new FusionCheckpointer(m_trackManager, m_threatAssessor, m_engagementManager, this);
+    m_checkpointer->setConfig(config);
+    if (m_checkpointer->restore().restored) {
+        reportStartupMilestone("checkpoint restored");
+    }
+    m_checkpointer->start();
+}
+
 void MainWindow::onSimulationVideoFrame(const QImage& frame, qint64 timestamp) {
     Q_UNUSED(timestamp)
     // Update primary video display with simulation frame
     m_primaryVideoWidget->updateFrame(frame);
+    if (!m_firstVideoFrameSeen) {
+        m_firstVideoFrameSeen = true;
+        reportStartupMilestone("first video frame");
+    }
 }
 
 void MainWindow::onSimulationCameraFrame(const QString& cameraId, const QImage& frame, qint64 timestamp) {
     Q_UNUSED(timestamp)
-    // Update video grid with camera-specific frame
-    m_videoGridWidget->updateFrame(cameraId, frame);
+    // The grid only takes frames directly when nothing manages the streams;
+    // otherwise its tiles get them scaled through VideoStreamManager
+    if (!m_videoManager->stream(cameraId)) {
+        m_videoGridWidget->updateFrame(cameraId, frame);
+    }
 }
 
 void MainWindow::startSimulation() {
-    if (m_simulationRunning) return;
+    if (m_simulationRunning || !m_startupComplete || m_coreClient) return;
     
     // Start simulation manager (coordinates all simulators)
     m_simulationManager->start();
@@ -772,8 +1604,10 @@ void MainWindow::startSimulation() {
     m_sensorStatusPanel->updateSensorStatus("SIM-DAY-001", "ONLINE");
     m_sensorStatusPanel->updateSensorStatus("SIM-NIGHT-001", "ONLINE");
     
-    // Start PPI sweep animation
-    m_ppiWidget->startSweep();
+    // Start PPI sweep animation, unless shed for load
+    if (OverloadController::instance().level() < OverloadLevel::SweepSuspended) {
+        m_ppiWidget->startSweep();
+    }
     m_ppiSweepAction->setChecked(true);
     m_ppiSweepAction->setText("Stop Sweep");
     
@@ -917,14 +1751,22 @@ void MainWindow::showHelp() {
                             "F11 - Full Screen Video");
 }
 
-void MainWindow::updateStatusBar() {
-    int trackCount = m_trackManager->trackCount();
-    auto metrics = m_threatAssessor->metrics();
+void MainWindow::updateStatusBar(const UIFrame& frame) {
+    if (frame.picture) {
+        m_statusTrackCount->setText(QString("Tracks: %1").arg(frame.picture->tracks.size()));
+    }
     
-    m_statusTrackCount->setText(QString("Tracks: %1").arg(trackCount));
-    m_statusThreatCount->setText(QString("Hostile: %1 | High Threat: %2")
-                                     .arg(metrics.hostileCount)
-                                     .arg(metrics.highThreatCount));
+    for (const StatusSnapshotPtr& status : frame.status) {
+        if (status->source != ThreatAssessor::STATUS_SOURCE) continue;
+        if (status->changed("hostile", frame.statusSince) || status->changed("highThreat", frame.statusSince)) {
+            m_statusThreatCount->setText(QString("Hostile: %1 | High Threat: %2")
+                                             .arg(status->value("hostile").toInt())
+                                             .arg(status->value("highThreat").toInt()));
+        }
+    }
+}
+
+void MainWindow::updateStatusClock() {
     m_statusTime->setText(QDateTime::currentDateTime().toString("hh:mm:ss"));
 }
 
@@ -947,19 +1789,15 @@ void MainWindow::onEngageRequested(const QString& trackId) {
 }
 
 void MainWindow::onCameraSlewRequested(const QString& trackId) {
-    Track* track = m_trackManager->track(trackId);
-    if (track) {
-        m_videoManager->slewNearestCamera(track->position());
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    if (const TrackSnapshot* track = picture->find(trackId)) {
+        m_videoManager->slewNearestCamera(track->position);
     }
 }
 
 void MainWindow::onAlertClicked(const QString& alertId) {
-    auto alerts = m_threatAssessor->alerts();
-    for (const auto& alert : alerts) {
-        if (alert.alertId == alertId) {
-            onTrackSelected(alert.trackId);
-            break;
-        }
+    if (const ThreatAlert* alert = m_threatAssessor->alert(alertId)) {
+        onTrackSelected(alert->trackId);
     }
 }
 
@@ -987,6 +1825,7 @@ void MainWindow::onSensorDiagnostics() {
 
 void MainWindow::onEffectorStatus() {
     EffectorStatusDialog dialog(m_engagementManager, this);
+    dialog.setFrameScheduler(m_frameScheduler);
     dialog.exec();
 }
 
@@ -1007,6 +1846,66 @@ void MainWindow::onSimulationSettings() {
     }
 }
 
+void MainWindow::onReplayTrackHistory(bool replay) {
+    if (!m_trackReplayer) {
+        m_trackReplayer = new TrackReplayer(m_trackManager, this);
+        connect(m_trackReplayer, &TrackReplayer::finished, this, [this]() {
+            statusBar()->showMessage("Track replay finished");
+        });
+        connect(m_trackReplayer, &TrackReplayer::activeChanged, m_replayTracksAction, &QAction::setChecked);
+    }
+    
+    if (!replay) {
+        m_trackReplayer->stop();
+        statusBar()->showMessage("Showing live tracks");
+        return;
+    }
+    if (m_trackReplayer->isActive()) return;
+    
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (m_trackReplayer->start(now - 3600000, now)) {
+        statusBar()->showMessage("Replaying the last hour of tracks");
+    } else {
+        m_replayTracksAction->setChecked(false);
+        statusBar()->showMessage("No track history to replay");
+    }
+}
+
+void MainWindow::onReplayRawCapture() {
+    if (m_rawReplayer && m_rawReplayer->isRunning()) {
+        m_rawReplayer->stop();
+        return;
+    }
+    
+    const QString directory = QFileDialog::getExistingDirectory(this, "Replay Raw Capture",
+        ConfigManager::instance().value("capture/directory", QString()).toString());
+    if (directory.isEmpty()) return;
+    
+    if (!m_rawReplayer) {
+        m_rawReplayer = new RawCaptureReplayer(this);
+        connect(m_rawReplayer, &RawCaptureReplayer::finished, this, [this](int packets) {
+            statusBar()->showMessage(QString("Raw capture replay finished after %1 packets").arg(packets));
+        });
+    }
+    
+    // Each sensor takes its own source's bytes, and only while disconnected
+    m_rawReplayer->clearSinks();
+    for (SensorInterface* sensor : findChildren<SensorInterface*>()) {
+        m_rawReplayer->setSink(sensor->sensorId(), [sensor](const QByteArray& data) {
+            sensor->replayRaw(data);
+        });
+    }
+    m_rawReplayer->setTimeScale(ConfigManager::instance().value("capture/replayTimeScale", 1.0).toDouble());
+    if (m_rawReplayer->load(directory, 0, std::numeric_limits<qint64>::max()) == 0) {
+        statusBar()->showMessage("No raw capture to replay in " + directory);
+        return;
+    }
+    m_rawReplayer->start();
+    statusBar()->showMessage(QString("Replaying %1 captured packets at %2x")
+                                 .arg(m_rawReplayer->packetCount())
+                                 .arg(m_rawReplayer->timeScale()));
+}
+
 void MainWindow::onAddCameraStream() {
     QString url = QInputDialog::getText(this, "Add Camera Stream",
         "Enter RTSP URL or device path:");
@@ -1032,17 +1931,42 @@ void MainWindow::onStopAllRecording() {
     statusBar()->showMessage("Stopped all recordings");
 }
 
+void MainWindow::onRecordTrace(bool record) {
+    if (record) Trace::clear();
+    // The flight recorder keeps tracing on while it runs
+    Trace::setEnabled(record || FlightRecorder::instance().isRunning());
+    statusBar()->showMessage(record ? "Recording performance trace" : "Performance trace stopped");
+}
+
+void MainWindow::onSaveTrace() {
+    QString path = QFileDialog::getSaveFileName(this, "Save Performance Trace",
+        QString("trace_%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
+        "Chrome Trace (*.json)");
+    if (path.isEmpty()) return;
+    
+    if (Trace::writeChromeTrace(path)) {
+        statusBar()->showMessage(QString("Trace saved: %1 (%2 events); open in ui.perfetto.dev")
+                                     .arg(path).arg(Trace::eventCount()));
+    } else {
+        QMessageBox::warning(this, "Performance Trace", "Could not write " + path);
+    }
+}
+
 void MainWindow::onTakeSnapshot() {
-    QString path = QFileDialog::getSaveFileName(this, "Save Snapshot",
-        QString("snapshot_%1.png").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
-        "PNG Images (*.png)");
-    if (!path.isEmpty()) {
-        QImage frame = m_primaryVideoWidget->currentFrame();
-        if (!frame.isNull()) {
-            frame.save(path);
-            statusBar()->showMessage("Snapshot saved: " + path);
-        }
+    if (!m_captureService) return;
+    
+    // The native frame when the stream has one, else what is on screen;
+    // captureSaved reports the path once it is written
+    CaptureTags tags;
+    tags.engagementId = m_engagementManager->currentEngagementId();
+    tags.trackId = m_engagementManager->selectedTrackId();
+    tags.label = "operator";
+    const QString cameraId = m_videoManager->primaryStreamId();
+    QString captureId = m_captureService->snapshot(cameraId, tags);
+    if (captureId.isEmpty()) {
+        captureId = m_captureService->snapshot(cameraId, m_primaryVideoWidget->currentVideoFrame(), tags);
     }
+    if (captureId.isEmpty()) statusBar()->showMessage("No frame to capture", 3000);
 }
 
 void MainWindow::onSaveLayout() {
@@ -1065,6 +1989,8 @@ void MainWindow::onResetLayout() {
     m_trackDetailDock->show();
     m_sensorStatusDock->show();
     m_cameraStatusDock->show();
+    m_latencyDock->show();
+    m_memoryDock->show();
     m_effectorDock->show();
     m_alertDock->show();
     statusBar()->showMessage("Layout reset to default");
@@ -1112,9 +2038,13 @@ void MainWindow::onPPIRangeChanged(double rangeM) {
 
 void MainWindow::onPPISweepToggle() {
     if (m_ppiSweepAction->isChecked()) {
-        m_ppiWidget->startSweep();
+        if (OverloadController::instance().level() < OverloadLevel::SweepSuspended) {
+            m_ppiWidget->startSweep();
+            statusBar()->showMessage("Radar sweep started");
+        } else {
+            statusBar()->showMessage("Radar sweep starts once load drops");
+        }
         m_ppiSweepAction->setText("Stop Sweep");
-        statusBar()->showMessage("Radar sweep started");
     } else {
         m_ppiWidget->stopSweep();
         m_ppiSweepAction->setText("Start Sweep");
@@ -13,6 +13,7 @@
 #include <QComboBox>
 #include <QToolButton>
 #include "core/Track.h"  // For GeoPosition
+#include <memory>
 
 namespace CounterUAS {
 
@@ -24,14 +25,37 @@ class TrackListWidget;
 class TrackDetailPanel;
 class SensorStatusPanel;
 class CameraStatusPanel;
+class LatencyPanel;
+class MemoryPanel;
 class EffectorControlPanel;
 class AlertQueue;
+class UIFrameScheduler;
+struct UIFrame;
 class TrackManager;
+class FusionEngine;
 class ThreatAssessor;
 class EngagementManager;
 class VideoStreamManager;
 class VideoSimulator;
+class VideoServiceClient;
+class CoreClient;
+class VideoRestreamer;
+class WebViewerFeed;
+class RecordingStorage;
+class CaptureService;
+class TrackVideoIndex;
 class SystemSimulationManager;
+class CoverageService;
+class SensorResourceManager;
+class CooperativeReceiver;
+class AsterixSensor;
+class RawCaptureRecorder;
+class RawCaptureReplayer;
+class TrackReplayer;
+class RadarVideoSource;
+class FusionCheckpointer;
+class NetworkManager;
+class AlertSync;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -48,6 +72,19 @@ public:
     VideoSimulator* videoSimulator() const { return m_videoSimulator; }
     SystemSimulationManager* simulationManager() const { return m_simulationManager; }
     
+    // The constructor only builds the window shell; this creates the
+    // simulated sensors, effectors and video and connects the journal.
+    // Call after show(), once DatabaseManager is initialized
+    void completeStartup();
+    bool isStartupComplete() const { return m_startupComplete; }
+    
+    // Milestones are timed from startNs (TimeUtils::monotonicNs())
+    void setStartupTime(qint64 startNs) { m_startupNs = startNs; }
+    void reportStartupMilestone(const QString& name);
+    
+signals:
+    void startupMilestone(const QString& name, qint64 elapsedMs);
+    
 public slots:
     // Simulation control
     void startSimulation();
@@ -66,7 +103,6 @@ public slots:
     void showHelp();
     
 private slots:
-    void updateStatusBar();
     void onTrackSelected(const QString& trackId);
     void onEngageRequested(const QString& trackId);
     void onCameraSlewRequested(const QString& trackId);
@@ -82,10 +118,14 @@ private slots:
     void onRulesOfEngagement();
     void onRecordingSettings();
     void onSimulationSettings();
+    void onReplayTrackHistory(bool replay);
+    void onReplayRawCapture();
     void onAddCameraStream();
     void onStartAllRecording();
     void onStopAllRecording();
     void onTakeSnapshot();
+    void onRecordTrace(bool record);
+    void onSaveTrace();
     
     // View menu
     void onSaveLayout();
@@ -112,18 +152,57 @@ private:
     void setupDockWidgets();
     void setupConnections();
     void initializeSubsystems();
+    void setupVideoService();
+    void setupCoreClient();
+    void setupRestreamer();
+    void setupWebViewer();
+    void setupRecordingStorage();
+    void setupCaptureService();
+    void setupTrackVideoIndex();
     void setupVideoSimulation();
+    void setupCoverage();
+    void setupSensorTasking();
     void setupSimulationManager();
     void setupPPIDisplay();
+    void setupFusionEngine();
+    void setupCooperativeReceiver();
+    void setupRawCapture();
+    void setupAsterixFeed();
+    void setupAlertSync();
+    void setupCheckpointer();
+    void setupFrameScheduler();
+    // Counts as tracks and the threat assessor's status change; the clock each second
+    void updateStatusBar(const UIFrame& frame);
+    void updateStatusClock();
+    void setupOverloadPolicy();
+    void setupUpdateTiers();
+    // What the flight recorder writes into a capture besides the trace
+    void setupFlightRecorderProbes();
+    void setupEventJournal();
     void createViewMenu(QMenu* viewMenu);
     
     // Core subsystems
-    TrackManager* m_trackManager;
+    TrackManager* m_trackManager;  // Unparented so FusionEngine can move it to its thread
+    FusionEngine* m_fusionEngine;
     ThreatAssessor* m_threatAssessor;
     EngagementManager* m_engagementManager;
     VideoStreamManager* m_videoManager;
     VideoSimulator* m_videoSimulator;
+    VideoServiceClient* m_videoService = nullptr;   // Only when videoService/serverName is set
+    CoreClient* m_coreClient = nullptr;             // Only when attached to a CounterUAS_Core
+    VideoRestreamer* m_restreamer = nullptr;        // Only when restream/port is set
+    WebViewerFeed* m_webViewer = nullptr;           // Only when webViewer/port is set
+    RecordingStorage* m_recordingStorage = nullptr; // Null if its directory cannot be made
+    CaptureService* m_captureService = nullptr;     // Built by setupCaptureService()
+    TrackVideoIndex* m_trackVideoIndex = nullptr;   // Built by setupTrackVideoIndex()
     SystemSimulationManager* m_simulationManager;
+    CoverageService* m_coverage = nullptr;          // Built by setupCoverage()
+    SensorResourceManager* m_sensorTasking = nullptr;   // Unless sensorTasking/enabled is off
+    CooperativeReceiver* m_cooperative = nullptr;   // Only when an ADS-B or Remote ID feed is set
+    AsterixSensor* m_asterix = nullptr;             // Only when asterix/port is set
+    NetworkManager* m_alertNetwork = nullptr;       // Only when alertSync/peers is set
+    AlertSync* m_alertSync = nullptr;
+    std::shared_ptr<RawCaptureRecorder> m_rawCapture;   // Only when capture/directory is set
     
     // UI Widgets
     MapWidget* m_mapWidget;
@@ -135,6 +214,8 @@ private:
     TrackDetailPanel* m_trackDetailPanel;
     SensorStatusPanel* m_sensorStatusPanel;
     CameraStatusPanel* m_cameraStatusPanel;
+    LatencyPanel* m_latencyPanel;
+    MemoryPanel* m_memoryPanel;
     EffectorControlPanel* m_effectorControlPanel;
     AlertQueue* m_alertQueue;
     
@@ -143,6 +224,8 @@ private:
     QDockWidget* m_trackDetailDock;
     QDockWidget* m_sensorStatusDock;
     QDockWidget* m_cameraStatusDock;
+    QDockWidget* m_latencyDock;
+    QDockWidget* m_memoryDock;
     QDockWidget* m_effectorDock;
     QDockWidget* m_alertDock;
     QDockWidget* m_videoDock;
@@ -152,7 +235,7 @@ private:
     QToolBar* m_mainToolBar;
     QToolBar* m_simulationToolBar;
     QToolBar* m_ppiToolBar;
-    QTimer* m_statusUpdateTimer;
+    UIFrameScheduler* m_frameScheduler = nullptr;   // Drives every track display
     
     // PPI controls
     QComboBox* m_displayModeCombo;
@@ -164,12 +247,23 @@ private:
     QLabel* m_statusThreatCount;
     QLabel* m_statusSimStatus;
     QLabel* m_statusTime;
+    QLabel* m_statusLoad;
     
     // Menu actions
     QAction* m_startSimAction;
     QAction* m_stopSimAction;
     QAction* m_pauseSimAction;
+    QAction* m_replayTracksAction;
     
+    TrackReplayer* m_trackReplayer = nullptr;   // Created on first replay
+    RawCaptureReplayer* m_rawReplayer = nullptr;    // Created on first raw replay
+    RadarVideoSource* m_radarVideo = nullptr;   // Only when radarVideo/port is set
+    FusionCheckpointer* m_checkpointer = nullptr;   // Only when checkpoint/path is set
+    int m_journalEngagementState = 0;           // Last EngagementState journalled
+    bool m_startupComplete = false;
+    qint64 m_startupNs = 0;
+    bool m_firstVideoFrameSeen = false;
+    QMetaObject::Connection m_firstTrackConnection;
     bool m_simulationRunning = false;
     bool m_simulationPaused = false;
 };
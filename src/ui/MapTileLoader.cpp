@@ -0,0 +1,368 @@
+#include "ui/MapTileLoader.h"
+#include "utils/Logger.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTimer>
+#include <QUrl>
+
+namespace CounterUAS {
+
+namespace {
+
+// MBTiles rows count up from the south
+int tmsRow(const MapTileKey& key) {
+    return (1 << key.zoom) - 1 - key.y;
+}
+
+QString connectionName(const void* owner, const QString& what) {
+    return QString("map-tiles-%1-%2").arg(quintptr(owner), 0, 16).arg(what);
+}
+
+} // namespace
+
+MapTileLoader::MapTileLoader(QObject* parent)
+    : QObject(parent)
+    , m_retryTimer(new QTimer(this))
+{
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &MapTileLoader::process);
+}
+
+MapTileLoader::~MapTileLoader() {
+    shutdown();
+}
+
+void MapTileLoader::setCacheDirectory(const QString& path) {
+    if (path == m_cacheDirectory) return;
+    m_cacheDirectory = path;
+    openCache();
+}
+
+void MapTileLoader::setUrlTemplate(const QString& urlTemplate) {
+    if (urlTemplate == m_urlTemplate) return;
+    m_urlTemplate = urlTemplate;
+    m_notFound.clear();
+    for (QList<MapTileKey>& queue : m_fetches) queue.clear();
+    openCache();
+}
+
+bool MapTileLoader::addTilePack(const QString& path) {
+    const QString name = connectionName(this, QString("pack%1").arg(m_packConnections.size()));
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(path);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (db.open() && db.tables().contains("tiles")) {
+            m_packConnections.append(name);
+            Logger::instance().info("MapTileLoader", "Tile pack: " + path);
+            schedule();
+            return true;
+        }
+        Logger::instance().warning("MapTileLoader", "Not an MBTiles pack: " + path);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    return false;
+}
+
+void MapTileLoader::setWanted(const QVector<MapTileKey>& visible, const QVector<MapTileKey>& prefetch) {
+    QSet<MapTileKey> queued;
+    auto enqueue = [&](const QVector<MapTileKey>& keys, MapTilePriority priority) {
+        QList<MapTileKey>& lookups = m_lookups[int(priority)];
+        lookups.clear();
+        m_fetches[int(priority)].clear();
+        for (const MapTileKey& key : keys) {
+            if (key.zoom < 0 || key.x < 0 || key.y < 0 || key.x >= (1 << key.zoom) || key.y >= (1 << key.zoom)) continue;
+            if (m_fetching.contains(key) || queued.contains(key)) continue;
+            queued.insert(key);
+            lookups.append(key);
+        }
+    };
+    enqueue(visible, MapTilePriority::Visible);
+    enqueue(prefetch, MapTilePriority::Prefetch);
+    schedule();
+}
+
+void MapTileLoader::seed(const QVector<MapTileKey>& keys) {
+    QList<MapTileKey>& lookups = m_lookups[int(MapTilePriority::Seed)];
+    for (const MapTileKey& key : keys) lookups.append(key);
+    m_seedTotal += keys.size();
+    schedule();
+}
+
+void MapTileLoader::cancelSeed() {
+    const int dropped = m_lookups[int(MapTilePriority::Seed)].size() + m_fetches[int(MapTilePriority::Seed)].size();
+    m_lookups[int(MapTilePriority::Seed)].clear();
+    m_fetches[int(MapTilePriority::Seed)].clear();
+    if (m_seedTotal == 0) return;
+    m_seedFailed += dropped;
+    m_seedDone += dropped;
+    reportSeed();
+}
+
+void MapTileLoader::shutdown() {
+    for (QList<MapTileKey>& queue : m_lookups) queue.clear();
+    for (QList<MapTileKey>& queue : m_fetches) queue.clear();
+    const QList<QNetworkReply*> replies = m_inFlight.keys();
+    m_inFlight.clear();
+    m_fetching.clear();
+    for (QNetworkReply* reply : replies) {
+        reply->abort();
+        reply->deleteLater();
+    }
+    delete m_network;
+    m_network = nullptr;
+    m_retryTimer->stop();
+
+    closeCache();
+    for (const QString& name : m_packConnections) {
+        QSqlDatabase::database(name, false).close();
+        QSqlDatabase::removeDatabase(name);
+    }
+    m_packConnections.clear();
+}
+
+QString MapTileLoader::tileUrl(const QString& urlTemplate, const MapTileKey& key) {
+    QString url = urlTemplate;
+    url.replace("{x}", QString::number(key.x));
+    url.replace("{y}", QString::number(key.y));
+    url.replace("{z}", QString::number(key.zoom));
+    return url;
+}
+
+void MapTileLoader::schedule() {
+    if (m_scheduled) return;
+    m_scheduled = true;
+    QTimer::singleShot(0, this, [this]() {
+        m_scheduled = false;
+        process();
+    });
+}
+
+void MapTileLoader::process() {
+    // Disk first, a few at a time so newer wants are not stuck behind these
+    int budget = LOOKUPS_PER_PASS;
+    for (int p = 0; p < PRIORITIES && budget > 0; ++p) {
+        const MapTilePriority priority = MapTilePriority(p);
+        QList<MapTileKey>& lookups = m_lookups[p];
+        while (!lookups.isEmpty() && budget > 0) {
+            const MapTileKey key = lookups.takeFirst();
+            --budget;
+            if (priority == MapTilePriority::Seed) {
+                if (readTile(key, nullptr)) {
+                    seedDone(true);
+                    continue;
+                }
+            } else {
+                QByteArray data;
+                if (readTile(key, &data) && decode(key, data)) continue;
+            }
+            if (m_urlTemplate.isEmpty() || m_notFound.contains(key)) {
+                if (priority == MapTilePriority::Seed) seedDone(false);
+                continue;
+            }
+            m_fetches[p].append(key);
+        }
+    }
+
+    // Then the server, unless it could not be reached a moment ago
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now < m_offlineUntilMs) {
+        if (!m_retryTimer->isActive()) m_retryTimer->start(int(m_offlineUntilMs - now));
+    } else {
+        for (int p = 0; p < PRIORITIES; ++p) {
+            while (!m_fetches[p].isEmpty() && m_inFlight.size() < MAX_FETCHES) {
+                startFetch(m_fetches[p].takeFirst(), MapTilePriority(p));
+            }
+        }
+    }
+
+    for (const QList<MapTileKey>& lookups : m_lookups) {
+        if (!lookups.isEmpty()) {
+            schedule();
+            break;
+        }
+    }
+}
+
+bool MapTileLoader::readTile(const MapTileKey& key, QByteArray* data) const {
+    QStringList connections = m_packConnections;
+    if (!m_cacheConnection.isEmpty()) connections.append(m_cacheConnection);
+
+    for (const QString& name : connections) {
+        QSqlQuery query(QSqlDatabase::database(name, false));
+        query.prepare(data ? "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?"
+                           : "SELECT 1 FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?");
+        query.addBindValue(key.zoom);
+        query.addBindValue(key.x);
+        query.addBindValue(tmsRow(key));
+        if (query.exec() && query.next()) {
+            if (data) *data = query.value(0).toByteArray();
+            return true;
+        }
+    }
+    return false;
+}
+
+void MapTileLoader::writeTile(const MapTileKey& key, const QByteArray& data) {
+    if (m_cacheConnection.isEmpty()) return;
+
+    QSqlQuery query(QSqlDatabase::database(m_cacheConnection, false));
+    query.prepare("INSERT OR REPLACE INTO tiles (zoom_level, tile_column, tile_row, tile_data) VALUES (?, ?, ?, ?)");
+    query.addBindValue(key.zoom);
+    query.addBindValue(key.x);
+    query.addBindValue(tmsRow(key));
+    query.addBindValue(data);
+    if (!query.exec()) {
+        Logger::instance().warning("MapTileLoader", "Tile not cached: " + query.lastError().text());
+    }
+}
+
+bool MapTileLoader::decode(const MapTileKey& key, const QByteArray& data) {
+    QImage image;
+    if (!image.loadFromData(data)) return false;
+
+    // The format QPixmap::fromImage() takes without converting
+    emit tileLoaded(key, image.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    return true;
+}
+
+void MapTileLoader::startFetch(const MapTileKey& key, MapTilePriority priority) {
+    if (m_fetching.contains(key)) {
+        if (priority == MapTilePriority::Seed) seedDone(true);    // Stored when that one lands
+        return;
+    }
+    if (!m_network) {
+        m_network = new QNetworkAccessManager(this);
+        connect(m_network, &QNetworkAccessManager::finished, this, &MapTileLoader::onFetchFinished);
+    }
+
+    QNetworkRequest request(QUrl(tileUrl(m_urlTemplate, key)));
+    request.setHeader(QNetworkRequest::UserAgentHeader, "CounterUAS-C2/1.0");
+    request.setTransferTimeout(10000);
+    m_inFlight.insert(m_network->get(request), qMakePair(key, priority));
+    m_fetching.insert(key);
+}
+
+void MapTileLoader::onFetchFinished(QNetworkReply* reply) {
+    reply->deleteLater();
+    auto it = m_inFlight.find(reply);
+    if (it == m_inFlight.end()) return;
+    const MapTileKey key = it->first;
+    const MapTilePriority priority = it->second;
+    m_inFlight.erase(it);
+    m_fetching.remove(key);
+
+    const QNetworkReply::NetworkError error = reply->error();
+    if (error == QNetworkReply::NoError) {
+        const QByteArray data = reply->readAll();
+        const bool valid = priority == MapTilePriority::Seed ? !QImage::fromData(data).isNull()
+                                                             : decode(key, data);
+        if (valid) writeTile(key, data);
+        if (priority == MapTilePriority::Seed) seedDone(valid);
+    } else if (error == QNetworkReply::ContentNotFoundError) {
+        m_notFound.insert(key);
+        if (priority == MapTilePriority::Seed) seedDone(false);
+    } else if (error < QNetworkReply::ProxyConnectionRefusedError && error != QNetworkReply::OperationCanceledError) {
+        // Connection level: hold the network back, and try this one again then
+        if (QDateTime::currentMSecsSinceEpoch() >= m_offlineUntilMs) {
+            Logger::instance().warning("MapTileLoader", "Tile server unreachable: " + reply->errorString());
+        }
+        m_offlineUntilMs = QDateTime::currentMSecsSinceEpoch() + OFFLINE_BACKOFF_MS;
+        m_fetches[int(priority)].prepend(key);
+    } else if (priority == MapTilePriority::Seed) {
+        seedDone(false);
+    }
+    schedule();
+}
+
+void MapTileLoader::seedDone(bool stored) {
+    if (m_seedTotal == 0) return;
+    ++m_seedDone;
+    if (stored) {
+        ++m_seedStored;
+    } else {
+        ++m_seedFailed;
+    }
+    reportSeed();
+}
+
+void MapTileLoader::reportSeed() {
+    if (m_seedDone % 64 == 0 || m_seedDone >= m_seedTotal) {
+        emit seedProgress(m_seedDone, m_seedTotal);
+    }
+    if (m_seedDone >= m_seedTotal) {
+        emit seedFinished(m_seedStored, m_seedFailed);
+        m_seedTotal = m_seedDone = m_seedStored = m_seedFailed = 0;
+    }
+}
+
+void MapTileLoader::openCache() {
+    closeCache();
+    if (m_cacheDirectory.isEmpty() || m_urlTemplate.isEmpty()) return;
+
+    // One file per tile source
+    QDir().mkpath(m_cacheDirectory);
+    const QByteArray digest = QCryptographicHash::hash(m_urlTemplate.toUtf8(), QCryptographicHash::Sha1).toHex().left(12);
+    const QString path = QDir(m_cacheDirectory).filePath(QString("tiles-%1.mbtiles").arg(QString::fromLatin1(digest)));
+
+    const QString name = connectionName(this, "cache");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            Logger::instance().warning("MapTileLoader", "Tile cache not opened: " + db.lastError().text());
+        } else {
+            QSqlQuery query(db);
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            query.exec("CREATE TABLE IF NOT EXISTS metadata (name TEXT, value TEXT)");
+            query.exec("CREATE TABLE IF NOT EXISTS tiles (zoom_level INTEGER, tile_column INTEGER, "
+                       "tile_row INTEGER, tile_data BLOB)");
+            const bool created = query.exec("CREATE UNIQUE INDEX IF NOT EXISTS tile_index "
+                                            "ON tiles (zoom_level, tile_column, tile_row)");
+
+            if (created && query.exec("SELECT COUNT(*) FROM metadata") && query.next() && query.value(0).toInt() == 0) {
+                const QString format = QFileInfo(QUrl(m_urlTemplate).path()).suffix().toLower();
+                const QList<QPair<QString, QString>> metadata = {
+                    {"name", m_urlTemplate},
+                    {"format", format == "jpg" || format == "jpeg" ? "jpg" : "png"},
+                    {"type", "baselayer"},
+                    {"version", "1.0"},
+                };
+                for (const auto& entry : metadata) {
+                    query.prepare("INSERT INTO metadata (name, value) VALUES (?, ?)");
+                    query.addBindValue(entry.first);
+                    query.addBindValue(entry.second);
+                    query.exec();
+                }
+            }
+            if (created) {
+                m_cacheConnection = name;
+                Logger::instance().info("MapTileLoader", "Tile cache: " + path);
+            } else {
+                Logger::instance().warning("MapTileLoader", "Tile cache not usable: " + query.lastError().text());
+                db.close();
+            }
+        }
+    }
+    if (m_cacheConnection.isEmpty()) QSqlDatabase::removeDatabase(name);
+    schedule();
+}
+
+void MapTileLoader::closeCache() {
+    if (m_cacheConnection.isEmpty()) return;
+    QSqlDatabase::database(m_cacheConnection, false).close();
+    QSqlDatabase::removeDatabase(m_cacheConnection);
+    m_cacheConnection.clear();
+}
+
+} // namespace CounterUAS
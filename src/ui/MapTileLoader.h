@@ -0,0 +1,133 @@
+#ifndef MAPTILELOADER_H
+#define MAPTILELOADER_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+namespace CounterUAS {
+
+/**
+ * @brief Map tile key for caching
+ */
+struct MapTileKey {
+    int x;
+    int y;
+    int zoom;
+
+    bool operator==(const MapTileKey& other) const {
+        return x == other.x && y == other.y && zoom == other.zoom;
+    }
+};
+
+inline size_t qHash(const MapTileKey& key, size_t seed = 0) {
+    return ::qHash(key.x, seed) ^ (::qHash(key.y, seed) << 1) ^ (::qHash(key.zoom, seed) << 2);
+}
+
+/**
+ * @brief Urgency of a tile request, most urgent first
+ */
+enum class MapTilePriority {
+    Visible,
+    Prefetch,
+    Seed                // Stored for offline use, not decoded
+};
+
+/**
+ * @brief Fetches, stores and decodes map tiles, on a thread of its own
+ *
+ * Tiles are looked up in the read-only site packs first, then in the
+ * cache for the current URL template, and fetched from the server only
+ * when neither has them; each fetched tile is written to the cache.
+ * Packs and cache are MBTiles files (SQLite, TMS row order), so a pack
+ * for a site can be produced by any MBTiles tool or by seed().
+ *
+ * Lookups run a few at a time, visible tiles before prefetched ones
+ * before seeded ones, so a new setWanted() is not stuck behind a long
+ * prefetch. At most MAX_FETCHES requests are in flight. A connection
+ * failure holds the network back for OFFLINE_BACKOFF_MS and the tiles
+ * wait for it, so a disconnected console serves what it has on disk
+ * without stalling on timeouts. Decoding happens here too, and only
+ * the QImage crosses to the GUI thread.
+ *
+ * Every method runs on the loader's thread; MapTileStore forwards them.
+ */
+class MapTileLoader : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_FETCHES = 4;
+    static constexpr int LOOKUPS_PER_PASS = 16;
+    static constexpr int OFFLINE_BACKOFF_MS = 30000;
+
+    explicit MapTileLoader(QObject* parent = nullptr);
+    ~MapTileLoader() override;
+
+    void setCacheDirectory(const QString& path);
+    // Empty serves from disk only
+    void setUrlTemplate(const QString& urlTemplate);
+    bool addTilePack(const QString& path);
+
+    // Replaces the visible and prefetch tiles waiting; fetches in flight finish
+    void setWanted(const QVector<MapTileKey>& visible, const QVector<MapTileKey>& prefetch);
+    void seed(const QVector<MapTileKey>& keys);
+    void cancelSeed();
+    void shutdown();
+
+    static QString tileUrl(const QString& urlTemplate, const MapTileKey& key);
+
+signals:
+    void tileLoaded(const CounterUAS::MapTileKey& key, const QImage& image);
+    void seedProgress(int done, int total);
+    void seedFinished(int stored, int failed);
+
+private:
+    static constexpr int PRIORITIES = 3;
+
+    void schedule();
+    void process();
+    // Packs, then the cache; data null only checks the tile is there
+    bool readTile(const MapTileKey& key, QByteArray* data) const;
+    void writeTile(const MapTileKey& key, const QByteArray& data);
+    bool decode(const MapTileKey& key, const QByteArray& data);
+    void startFetch(const MapTileKey& key, MapTilePriority priority);
+    void onFetchFinished(QNetworkReply* reply);
+    void seedDone(bool stored);
+    void reportSeed();
+    void openCache();
+    void closeCache();
+
+    QString m_cacheDirectory;
+    QString m_urlTemplate;
+    QString m_cacheConnection;              // Open when not empty
+    QStringList m_packConnections;
+    QNetworkAccessManager* m_network = nullptr;     // Made on first fetch, on this thread
+
+    QList<MapTileKey> m_lookups[PRIORITIES];        // Not yet looked for on disk
+    QList<MapTileKey> m_fetches[PRIORITIES];        // Not on disk
+    QHash<QNetworkReply*, QPair<MapTileKey, MapTilePriority>> m_inFlight;
+    QSet<MapTileKey> m_fetching;
+    QSet<MapTileKey> m_notFound;            // The server has no such tile
+    qint64 m_offlineUntilMs = 0;
+    QTimer* m_retryTimer;                   // Runs out with the backoff
+    bool m_scheduled = false;
+
+    int m_seedTotal = 0;
+    int m_seedDone = 0;
+    int m_seedStored = 0;
+    int m_seedFailed = 0;
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::MapTileKey)
+
+#endif // MAPTILELOADER_H
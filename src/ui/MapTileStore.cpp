@@ -0,0 +1,107 @@
+#include "ui/MapTileStore.h"
+#include "utils/CoordinateUtils.h"
+#include <QStandardPaths>
+#include <QThread>
+#include <QtMath>
+#include <cmath>
+
+namespace CounterUAS {
+
+MapTileStore::MapTileStore(QObject* parent)
+    : QObject(parent)
+    , m_thread(new QThread(this))
+    , m_loader(new MapTileLoader())
+{
+    qRegisterMetaType<MapTileKey>("CounterUAS::MapTileKey");
+
+    m_thread->setObjectName("map-tiles");
+    m_loader->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_loader, &QObject::deleteLater);
+    connect(m_loader, &MapTileLoader::tileLoaded, this, &MapTileStore::tileLoaded);
+    connect(m_loader, &MapTileLoader::seedProgress, this, &MapTileStore::seedProgress);
+    connect(m_loader, &MapTileLoader::seedFinished, this, &MapTileStore::seedFinished);
+    m_thread->start();
+
+    setCacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles");
+}
+
+MapTileStore::~MapTileStore() {
+    disconnect(m_loader, nullptr, this, nullptr);
+    QMetaObject::invokeMethod(m_loader, [loader = m_loader]() { loader->shutdown(); },
+                              Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();     // The loader is deleted on its thread's way out
+}
+
+void MapTileStore::setCacheDirectory(const QString& path) {
+    m_cacheDirectory = path;
+    QMetaObject::invokeMethod(m_loader, [loader = m_loader, path]() { loader->setCacheDirectory(path); });
+}
+
+void MapTileStore::setUrlTemplate(const QString& urlTemplate) {
+    QMetaObject::invokeMethod(m_loader, [loader = m_loader, urlTemplate]() { loader->setUrlTemplate(urlTemplate); });
+}
+
+void MapTileStore::addTilePack(const QString& path) {
+    QMetaObject::invokeMethod(m_loader, [loader = m_loader, path]() { loader->addTilePack(path); });
+}
+
+void MapTileStore::setWanted(const QVector<MapTileKey>& visible, const QVector<MapTileKey>& prefetch) {
+    QMetaObject::invokeMethod(m_loader, [loader = m_loader, visible, prefetch]() {
+        loader->setWanted(visible, prefetch);
+    });
+}
+
+int MapTileStore::seedSite(const GeoPosition& centre, double radiusM, int minZoom, int maxZoom) {
+    minZoom = qBound(0, minZoom, 19);
+    maxZoom = qBound(minZoom, maxZoom, 19);
+
+    // The square around the circle
+    const double dLat = radiusM / CoordinateUtils::DEG_TO_M_LAT;
+    const double dLon = radiusM / qMax(1.0, CoordinateUtils::degToMeterLon(centre.latitude));
+    GeoPosition northWest = centre;
+    northWest.latitude = qMin(85.0, centre.latitude + dLat);
+    northWest.longitude = qMax(-180.0, centre.longitude - dLon);
+    GeoPosition southEast = centre;
+    southEast.latitude = qMax(-85.0, centre.latitude - dLat);
+    southEast.longitude = qMin(179.9999, centre.longitude + dLon);
+
+    QVector<MapTileKey> keys;
+    for (int zoom = minZoom; zoom <= maxZoom; ++zoom) {
+        const MapTileKey a = tileAt(northWest, zoom);
+        const MapTileKey b = tileAt(southEast, zoom);
+        const qint64 count = qint64(b.x - a.x + 1) * (b.y - a.y + 1);
+        if (keys.size() + count > MAX_SEED_TILES) return -1;
+        for (int y = a.y; y <= b.y; ++y) {
+            for (int x = a.x; x <= b.x; ++x) {
+                keys.append({x, y, zoom});
+            }
+        }
+    }
+
+    QMetaObject::invokeMethod(m_loader, [loader = m_loader, keys]() { loader->seed(keys); });
+    return keys.size();
+}
+
+void MapTileStore::cancelSeed() {
+    QMetaObject::invokeMethod(m_loader, [loader = m_loader]() { loader->cancelSeed(); });
+}
+
+MapTileKey MapTileStore::tileAt(const GeoPosition& pos, int zoom) {
+    const double n = std::pow(2.0, zoom);
+    const double latRad = qDegreesToRadians(pos.latitude);
+    const int x = static_cast<int>((pos.longitude + 180.0) / 360.0 * n);
+    const int y = static_cast<int>((1.0 - std::asinh(std::tan(latRad)) / M_PI) / 2.0 * n);
+    return {x, y, zoom};
+}
+
+GeoPosition MapTileStore::tileOrigin(int x, int y, int zoom) {
+    const double n = std::pow(2.0, zoom);
+    GeoPosition pos;
+    pos.latitude = qRadiansToDegrees(std::atan(std::sinh(M_PI * (1.0 - 2.0 * y / n))));
+    pos.longitude = x / n * 360.0 - 180.0;
+    pos.altitude = 0;
+    return pos;
+}
+
+} // namespace CounterUAS
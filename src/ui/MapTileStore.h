@@ -0,0 +1,65 @@
+#ifndef MAPTILESTORE_H
+#define MAPTILESTORE_H
+
+#include <QObject>
+#include <QImage>
+#include <QVector>
+#include "core/Track.h"
+#include "ui/MapTileLoader.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief Persistent map tiles for a display, served from a loader thread
+ *
+ * The GUI-thread face of a MapTileLoader: every call is queued to the
+ * loader's thread and returns at once, and decoded tiles come back
+ * through tileLoaded(). Tiles persist in an MBTiles file per tile source
+ * under the cache directory, so a restarted console draws its map from
+ * disk; read-only site packs serve consoles that never see the server.
+ */
+class MapTileStore : public QObject {
+    Q_OBJECT
+
+public:
+    // Most tiles one seedSite() call queues; bulk downloads belong on
+    // servers that allow them
+    static constexpr int MAX_SEED_TILES = 50000;
+
+    explicit MapTileStore(QObject* parent = nullptr);
+    ~MapTileStore() override;
+
+    // Defaults to the application's cache location
+    void setCacheDirectory(const QString& path);
+    QString cacheDirectory() const { return m_cacheDirectory; }
+    void setUrlTemplate(const QString& urlTemplate);
+    void addTilePack(const QString& path);
+
+    // Replaces what was wanted before
+    void setWanted(const QVector<MapTileKey>& visible, const QVector<MapTileKey>& prefetch);
+
+    // Stores every tile within radiusM of centre at zooms minZoom to
+    // maxZoom for offline use; the number queued, or -1 over MAX_SEED_TILES
+    int seedSite(const GeoPosition& centre, double radiusM, int minZoom, int maxZoom);
+    void cancelSeed();
+
+    // Web Mercator tile containing pos, and the north-west corner of a tile
+    static MapTileKey tileAt(const GeoPosition& pos, int zoom);
+    static GeoPosition tileOrigin(int x, int y, int zoom);
+
+signals:
+    void tileLoaded(const CounterUAS::MapTileKey& key, const QImage& image);
+    void seedProgress(int done, int total);
+    void seedFinished(int stored, int failed);
+
+private:
+    QThread* m_thread;
+    MapTileLoader* m_loader;        // Lives on m_thread
+    QString m_cacheDirectory;
+};
+
+} // namespace CounterUAS
+
+#endif // MAPTILESTORE_H
@@ -1,8 +1,13 @@
 #include "ui/MapWidget.h"
+#include "core/TrackManager.h"
+#include "ui/UIFrameScheduler.h"
 #include "utils/CoordinateUtils.h"
+#include "utils/FlightRecorder.h"
+#include "utils/Trace.h"
 #include <QPainter>
 #include <QMouseEvent>
 #include <QWheelEvent>
+#include <QToolTip>
 #include <QtMath>
 #include <cmath>
 
@@ -18,30 +23,119 @@ MapWidget::MapWidget(QWidget* parent) : QWidget(parent) {
     
     // Initialize view range from default zoom
     m_viewRangeM = zoomToRangeScale(m_zoom);
+    
+    setTrackRenderBackend(TrackGLView::defaultBackend());
+}
+
+void MapWidget::setTrackManager(TrackManager* manager) {
+    if (m_trackManager) {
+        disconnect(m_trackManager, nullptr, this, nullptr);
+    }
+    
+    m_trackManager = manager;
+    
+    if (m_trackManager) {
+        if (!m_frameScheduler) {
+            connect(m_trackManager, &TrackManager::snapshotPublished, this, [this]() {
+                m_picture = m_trackManager->snapshot();
+                refreshTracks();
+            });
+        }
+        m_picture = m_trackManager->snapshot();
+    } else {
+        m_picture.reset();
+    }
+    refreshTracks();
+}
+
+void MapWidget::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+    setTrackManager(m_trackManager);
+    
+    if (m_frameScheduler) {
+        m_frameScheduler->addClient(this, 0, [this](const UIFrame& frame) {
+            if (!frame.picture || frame.picture == m_picture) return;
+            m_picture = frame.picture;
+            refreshTracks();
+        });
+        m_frameScheduler->setClientTriggers(this, FrameOnTracks);
+    }
+}
+
+void MapWidget::setTrackRenderBackend(TrackRenderBackend backend) {
+    if (backend == TrackRenderBackend::Auto) {
+        backend = TrackGLView::isSupported() ? TrackRenderBackend::OpenGL : TrackRenderBackend::Software;
+    }
+    if ((backend == TrackRenderBackend::OpenGL) == (m_trackGL != nullptr)) return;
+    
+    if (backend == TrackRenderBackend::OpenGL) {
+        m_trackGL = new TrackGLView(this);
+        m_trackGL->setGeometry(rect());
+        m_trackGL->setLabelFont(font());
+        m_trackGL->setTrailsVisible(false);
+        // A context too old for instancing falls back to painting
+        connect(m_trackGL, &TrackGLView::unavailable, this, [this]() {
+            setTrackRenderBackend(TrackRenderBackend::Software);
+        });
+        m_trackGL->show();
+    } else {
+        m_trackGL->deleteLater();
+        m_trackGL = nullptr;
+    }
+    refreshTracks();
+}
+
+TrackRenderBackend MapWidget::trackRenderBackend() const {
+    return m_trackGL ? TrackRenderBackend::OpenGL : TrackRenderBackend::Software;
+}
+
+void MapWidget::refreshTracks() {
+    CUAS_TRACE_SCOPE("ui", "MapWidget::refreshTracks");
+    aggregateTracks();
+    declutterLabels();
+    indexTracks();
+    if (m_trackGL) {
+        m_trackGL->setGlyphs(trackGlyphs());
+    }
+    update();
+}
+
+void MapWidget::setAggregateRange(double rangeM) {
+    m_aggregateRangeM = rangeM;
+    refreshTracks();
+}
+
+void MapWidget::setGeofenceZones(const QList<GeofenceZone>& zones) {
+    m_geofences.setZones(zones);
+    m_backgrounds.clear();
+    update();
 }
 
 void MapWidget::setCenter(const GeoPosition& pos) {
     m_center = pos;
     emit centerChanged(m_center);
-    update();
+    refreshTracks();
 }
 
 void MapWidget::setCenterSilent(const GeoPosition& pos) {
     m_center = pos;
-    update();
+    refreshTracks();
 }
 
 void MapWidget::setZoom(double zoom) {
     m_zoom = qBound(1.0, zoom, 20.0);
     m_viewRangeM = zoomToRangeScale(m_zoom);
     emit zoomChanged(m_zoom);
-    update();
+    refreshTracks();
 }
 
 void MapWidget::setZoomSilent(double zoom) {
     m_zoom = qBound(1.0, zoom, 20.0);
     m_viewRangeM = zoomToRangeScale(m_zoom);
-    update();
+    refreshTracks();
 }
 
 // Convert map zoom level (1-20) to range scale in meters
@@ -74,55 +168,105 @@ void MapWidget::pan(const QPointF& delta) {
     m_center.latitude += dLat;
     m_center.longitude += dLon;
     emit centerChanged(m_center);
-    update();
+    refreshTracks();
 }
 
 void MapWidget::selectTrack(const QString& trackId) {
+    // Re-selecting one of a box or lasso selection keeps the rest of it
+    const TrackSnapshot* track = m_picture ? m_picture->find(trackId) : nullptr;
+    if (!track || !m_selection.contains(track->handle)) {
+        m_selection.clear();
+    }
     m_selectedTrackId = trackId;
-    update();
+    refreshTracks();
+}
+
+void MapWidget::selectTracks(const QStringList& trackIds) {
+    m_selection.clear();
+    for (const QString& id : trackIds) {
+        if (const TrackSnapshot* track = m_picture ? m_picture->find(id) : nullptr) {
+            m_selection.insert(track->handle);
+        }
+    }
+    m_selectedTrackId = trackIds.value(0);
+    refreshTracks();
+}
+
+QStringList MapWidget::selectedTracks() const {
+    QStringList ids;
+    if (!m_selectedTrackId.isEmpty()) ids.append(m_selectedTrackId);
+    if (!m_picture) return ids;
+    for (TrackHandle handle : m_selection) {
+        const TrackSnapshot* track = m_picture->find(handle);
+        if (track && track->trackId != m_selectedTrackId) ids.append(track->trackId);
+    }
+    return ids;
 }
 
 void MapWidget::addTrack(const QString& trackId) {
     Q_UNUSED(trackId)
-    update();
+    refreshTracks();
 }
 
 void MapWidget::updateTrack(const QString& trackId) {
     Q_UNUSED(trackId)
-    update();
+    refreshTracks();
+}
+
+void MapWidget::updateTracks(const QStringList& trackIds) {
+    Q_UNUSED(trackIds)
+    refreshTracks();
 }
 
 void MapWidget::removeTrack(const QString& trackId) {
-    m_tracks.remove(trackId);
     if (m_selectedTrackId == trackId) {
         m_selectedTrackId.clear();
     }
-    update();
+    refreshTracks();
 }
 
 void MapWidget::clearTracks() {
-    m_tracks.clear();
+    m_picture.reset();
     m_selectedTrackId.clear();
-    update();
+    m_selection.clear();
+    refreshTracks();
+}
+
+bool MapWidget::event(QEvent* event) {
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent* help = static_cast<QHelpEvent*>(event);
+        if (const TrackSnapshot* track = trackAtPoint(help->pos())) {
+            QToolTip::showText(help->globalPos(),
+                               QString("%1\n%2\n%3 m/s  %4 m")
+                                   .arg(track->trackId, Track::classificationToString(track->classification))
+                                   .arg(track->velocity.speed(), 0, 'f', 0)
+                                   .arg(track->position.altitude, 0, 'f', 0),
+                               this);
+        } else {
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    return QWidget::event(event);
 }
 
 void MapWidget::paintEvent(QPaintEvent* event) {
     Q_UNUSED(event)
+    CUAS_TRACE_SCOPE("ui", "MapWidget::paintEvent");
+    FlightScope flightScope(FlightStage::Paint);
     
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    
-    // Background
-    painter.fillRect(rect(), QColor(30, 40, 50));
-    
-    // Draw grid
-    drawGrid(painter);
     
-    // Draw defended area
-    drawDefendedArea(painter);
+    // Fill, grid and defended area come from their cached layers
+    painter.drawPixmap(0, 0, backgroundLayer());
+    painter.drawPixmap(0, 0, defendedAreaLayer());
+    painter.setRenderHint(QPainter::Antialiasing);
     
-    // Draw tracks
-    drawTracks(painter);
+    // Draw tracks, unless the GL layer over this widget does
+    if (!m_trackGL) {
+        drawTracks(painter);
+    }
     
     // Draw center crosshair
     painter.setPen(QPen(Qt::white, 1));
@@ -131,6 +275,12 @@ void MapWidget::paintEvent(QPaintEvent* event) {
     painter.drawLine(cx - 10, cy, cx + 10, cy);
     painter.drawLine(cx, cy - 10, cx, cy + 10);
     
+    if (m_dragSelect != DragSelect::None && m_dragPath.size() > 1) {
+        painter.setPen(QPen(QColor(255, 255, 255, 200), 1, Qt::DashLine));
+        painter.setBrush(QColor(255, 255, 255, 30));
+        painter.drawPolygon(m_dragPath);
+    }
+    
     // Draw scale and info
     painter.setPen(Qt::white);
     QString rangeStr;
@@ -147,6 +297,26 @@ void MapWidget::paintEvent(QPaintEvent* event) {
 }
 
 void MapWidget::mousePressEvent(QMouseEvent* event) {
+    if (event->button() == Qt::LeftButton &&
+        (event->modifiers() & (Qt::ShiftModifier | Qt::ControlModifier))) {
+        m_dragSelect = (event->modifiers() & Qt::ShiftModifier) ? DragSelect::Box : DragSelect::Lasso;
+        m_dragPath = QPolygonF{QPointF(event->pos())};
+        event->accept();
+        return;
+    }
+    
+    // A track under the cursor is selected rather than dragged
+    if (event->button() == Qt::LeftButton) {
+        if (const TrackSnapshot* track = trackAtPoint(event->pos())) {
+            m_selectedTrackId = track->trackId;
+            m_selection.clear();
+            emit trackSelected(m_selectedTrackId);
+            refreshTracks();
+            event->accept();
+            return;
+        }
+    }
+    
     if (event->button() == Qt::LeftButton && m_panEnabled) {
         m_panning = true;
         m_lastPanPos = event->pos();
@@ -169,19 +339,77 @@ void MapWidget::mouseMoveEvent(QMouseEvent* event) {
         event->accept();
         return;
     }
+    if (m_dragSelect != DragSelect::None) {
+        const QRect before = dragBounds();
+        const QPointF pos = event->pos();
+        if (m_dragSelect == DragSelect::Box) {
+            const QPointF origin = m_dragPath.first();
+            m_dragPath = QPolygonF{origin, QPointF(pos.x(), origin.y()), pos, QPointF(origin.x(), pos.y())};
+        } else if (QLineF(m_dragPath.last(), pos).length() >= 3.0) {
+            m_dragPath.append(pos);
+        }
+        update(before.united(dragBounds()));
+        event->accept();
+        return;
+    }
     QWidget::mouseMoveEvent(event);
 }
 
 void MapWidget::mouseReleaseEvent(QMouseEvent* event) {
     if (m_panning && event->button() == Qt::LeftButton) {
         m_panning = false;
+        // Scrolled pixels carry the old centre's projection; draw the
+        // background afresh once the pan has ended
+        m_backgrounds.remove(qRound(m_zoom * 1000.0));
+        update();
         setCursor(Qt::ArrowCursor);
         event->accept();
         return;
     }
+    if (m_dragSelect != DragSelect::None && event->button() == Qt::LeftButton) {
+        const QRect bounds = dragBounds();
+        selectDragged();
+        m_dragSelect = DragSelect::None;
+        m_dragPath.clear();
+        update(bounds);
+        event->accept();
+        return;
+    }
     QWidget::mouseReleaseEvent(event);
 }
 
+void MapWidget::selectDragged() {
+    QVector<quint64> keys;
+    if (m_dragSelect == DragSelect::Box && m_dragPath.size() == 4) {
+        m_pickIndex.inRect(m_dragPath.boundingRect(), keys);
+    } else if (m_dragSelect == DragSelect::Lasso) {
+        m_pickIndex.inPolygon(m_dragPath, keys);
+    }
+    
+    m_selection.clear();
+    m_selectedTrackId.clear();
+    QStringList ids;
+    for (quint64 key : keys) {
+        const TrackSnapshot* track = m_picture ? m_picture->find(TrackHandle(key)) : nullptr;
+        if (!track) continue;
+        m_selection.insert(track->handle);
+        ids.append(track->trackId);
+    }
+    if (!ids.isEmpty()) {
+        m_selectedTrackId = ids.first();
+    }
+    refreshTracks();
+    
+    emit tracksSelected(ids);
+    if (!ids.isEmpty()) {
+        emit trackSelected(m_selectedTrackId);
+    }
+}
+
+QRect MapWidget::dragBounds() const {
+    return m_dragPath.boundingRect().toAlignedRect().adjusted(-2, -2, 2, 2);
+}
+
 void MapWidget::wheelEvent(QWheelEvent* event) {
     double delta = event->angleDelta().y() / 120.0;
     setZoom(m_zoom + delta * 0.5);
@@ -189,6 +417,10 @@ void MapWidget::wheelEvent(QWheelEvent* event) {
 
 void MapWidget::resizeEvent(QResizeEvent* event) {
     QWidget::resizeEvent(event);
+    if (m_trackGL) {
+        m_trackGL->setGeometry(rect());
+    }
+    refreshTracks();
 }
 
 double MapWidget::mapRadius() const {
@@ -210,6 +442,21 @@ QPointF MapWidget::geoToScreen(const GeoPosition& pos) const {
     return QPointF(width() / 2.0 + dx, height() / 2.0 + dy);
 }
 
+QTransform MapWidget::groundTransform(const LocalTangentPlane& frame) const {
+    // geoToScreen() is linear in latitude and longitude about m_center, so
+    // the frame's linear metres map through it as one affine transform
+    const QPointF offset = CoordinateUtils::geoToLocal(frame.origin(), m_center);
+    const double scale = mapRadius() / m_viewRangeM;
+    
+    QTransform transform;
+    transform.translate(width() / 2.0, height() / 2.0);
+    transform.scale(scale, -scale);
+    transform.translate(offset.x(), offset.y());
+    transform.scale(CoordinateUtils::degToMeterLon(m_center.latitude) / frame.metersPerDegreeLongitude(),
+                    CoordinateUtils::DEG_TO_M_LAT / frame.metersPerDegreeLatitude());
+    return transform;
+}
+
 GeoPosition MapWidget::screenToGeo(const QPointF& screen) const {
     // Scale: pixels per meter based on view range
     double scale = mapRadius() / m_viewRangeM;
@@ -262,7 +509,90 @@ void MapWidget::drawGrid(QPainter& painter) {
     }
 }
 
+void MapWidget::drawBackground(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "MapWidget::drawBackground");
+    painter.fillRect(rect(), QColor(30, 40, 50));
+    drawGrid(painter);
+    m_geofences.draw(painter, groundTransform(m_geofences.frame()));
+}
+
+const QPixmap& MapWidget::backgroundLayer() {
+    const int key = qRound(m_zoom * 1000.0);
+    const qreal dpr = devicePixelRatioF();
+    const QSize pixelSize = size() * dpr;
+    const QPointF viewCentre(width() / 2.0, height() / 2.0);
+    
+    BackgroundLayer* layer = m_backgrounds.object(key);
+    if (layer && layer->pixmap.size() == pixelSize &&
+        qAbs(layer->centre.latitude - m_center.latitude) < 1e-12 &&
+        qAbs(layer->centre.longitude - m_center.longitude) < 1e-12) {
+        return layer->pixmap;
+    }
+    
+    // Where the layer's centre falls on screen now
+    QPointF shift;
+    bool redraw = !layer || layer->pixmap.size() != pixelSize;
+    if (!redraw) {
+        shift = geoToScreen(layer->centre) - viewCentre;
+        redraw = qAbs(shift.x()) >= width() || qAbs(shift.y()) >= height();
+    }
+    
+    if (redraw) {
+        if (!layer) {
+            layer = new BackgroundLayer;
+            m_backgrounds.insert(key, layer);
+        }
+        layer->pixmap = QPixmap(pixelSize);
+        layer->pixmap.setDevicePixelRatio(dpr);
+        layer->centre = m_center;
+        QPainter painter(&layer->pixmap);
+        painter.setRenderHint(QPainter::Antialiasing);
+        drawBackground(painter);
+        return layer->pixmap;
+    }
+    
+    // Scroll by whole device pixels and draw only the strips exposed. The
+    // fraction left over stays in the layer's centre, so it does not build
+    // up over a long pan.
+    const QPoint step = (shift * dpr).toPoint();
+    if (step.isNull()) return layer->pixmap;
+    QRegion exposed;
+    layer->pixmap.scroll(step.x(), step.y(), layer->pixmap.rect(), &exposed);
+    const QPointF residual = shift - QPointF(step) / dpr;
+    
+    QRegion clip;
+    for (const QRect& rect : exposed) {
+        clip += QRectF(rect.x() / dpr, rect.y() / dpr, rect.width() / dpr, rect.height() / dpr)
+                    .toAlignedRect();
+    }
+    {
+        QPainter painter(&layer->pixmap);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setClipRegion(clip);
+        painter.translate(-residual);
+        drawBackground(painter);
+    }
+    layer->centre = screenToGeo(viewCentre + residual);
+    return layer->pixmap;
+}
+
+const QPixmap& MapWidget::defendedAreaLayer() {
+    const qreal dpr = devicePixelRatioF();
+    const QSize pixelSize = size() * dpr;
+    if (m_defendedArea.size() != pixelSize || m_defendedAreaRangeM != m_viewRangeM) {
+        m_defendedArea = QPixmap(pixelSize);
+        m_defendedArea.setDevicePixelRatio(dpr);
+        m_defendedArea.fill(Qt::transparent);
+        m_defendedAreaRangeM = m_viewRangeM;
+        QPainter painter(&m_defendedArea);
+        painter.setRenderHint(QPainter::Antialiasing);
+        drawDefendedArea(painter);
+    }
+    return m_defendedArea;
+}
+
 void MapWidget::drawDefendedArea(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "MapWidget::drawDefendedArea");
     // Draw defended area circles using proper pixel-per-meter scale
     QPointF centerPt = geoToScreen(m_center);
     double scale = mapRadius() / m_viewRangeM;  // pixels per meter
@@ -270,26 +600,28 @@ void MapWidget::drawDefendedArea(QPainter& painter) {
     // Critical zone (red) - 500m radius
     painter.setPen(QPen(QColor(255, 0, 0, 100), 2));
     painter.setBrush(QColor(255, 0, 0, 30));
-    double criticalRadius = 500.0 * scale;
+    double criticalRadius = CRITICAL_RADIUS_M * scale;
     painter.drawEllipse(centerPt, criticalRadius, criticalRadius);
     
     // Warning zone (yellow) - 1500m radius
     painter.setPen(QPen(QColor(255, 255, 0, 100), 2));
     painter.setBrush(QColor(255, 255, 0, 20));
-    double warningRadius = 1500.0 * scale;
+    double warningRadius = WARNING_RADIUS_M * scale;
     painter.drawEllipse(centerPt, warningRadius, warningRadius);
 }
 
 void MapWidget::drawTracks(QPainter& painter) {
-    for (auto it = m_tracks.begin(); it != m_tracks.end(); ++it) {
-        Track* track = it.value();
-        if (!track || track->state() == TrackState::Dropped) continue;
+    CUAS_TRACE_SCOPE("ui", "MapWidget::drawTracks");
+    if (!m_picture) return;
+    
+    for (const TrackSnapshot& track : m_picture->tracks) {
+        if (track.state == TrackState::Dropped || m_aggregated.contains(track.handle)) continue;
         
-        QPointF pos = geoToScreen(track->position());
-        QColor color = colorForClassification(track->classification());
+        QPointF pos = geoToScreen(track.position);
+        QColor color = colorForClassification(track.classification);
         
         // Draw track symbol
-        bool selected = (it.key() == m_selectedTrackId);
+        bool selected = isSelected(track);
         int size = selected ? 12 : 8;
         
         painter.setPen(QPen(color, selected ? 3 : 2));
@@ -304,7 +636,7 @@ void MapWidget::drawTracks(QPainter& painter) {
         painter.drawPolygon(diamond);
         
         // Draw velocity vector
-        VelocityVector vel = track->velocity();
+        VelocityVector vel = track.velocity;
         double speed = vel.speed();
         if (speed > 1.0) {
             double heading = vel.heading();
@@ -313,10 +645,233 @@ void MapWidget::drawTracks(QPainter& painter) {
             painter.drawLine(pos, QPointF(pos.x() + vx, pos.y() + vy));
         }
         
-        // Draw label
-        painter.setPen(Qt::white);
-        painter.drawText(pos.x() + size + 5, pos.y() + 4, track->trackId());
+        // Draw label where the declutter put it
+        const LabelPlacement label = m_declutter.placement(track.handle);
+        if (label.isVisible()) {
+            if (label.leader) {
+                painter.setPen(QPen(QColor(255, 255, 255, 160), 1));
+                painter.drawLine(LabelDeclutter::leaderLine(pos, label.rect, m_declutter.config().symbolRadius));
+            }
+            painter.setPen(Qt::white);
+            painter.drawStaticText(label.rect.topLeft(), m_labels.value(track.handle));
+        }
+    }
+    
+    for (const TrackAggregate& aggregate : m_aggregates) {
+        drawAggregate(painter, aggregate);
+    }
+    
+    for (const LabelCluster& cluster : m_declutter.clusters()) {
+        drawLabelCluster(painter, cluster);
+    }
+}
+
+void MapWidget::drawAggregate(QPainter& painter, const TrackAggregate& aggregate) {
+    const QColor color = colorForClassification(aggregate.classification);
+    const double size = aggregateSize(aggregate);
+    const QRectF rect(aggregate.position.x() - size, aggregate.position.y() - size, size * 2, size * 2);
+    
+    QColor fill = color;
+    fill.setAlphaF(0.4);
+    painter.setPen(QPen(color, 2));
+    painter.setBrush(fill);
+    painter.drawRect(rect);
+    painter.setPen(Qt::white);
+    painter.drawText(rect, Qt::AlignCenter, QString::number(aggregate.count));
+}
+
+double MapWidget::aggregateSize(const TrackAggregate& aggregate) const {
+    // Grows with the count, but stays inside its cell
+    return qMin(AGGREGATE_CELL_PX / 2.0, 8.0 + 2.0 * std::log2(double(aggregate.count)));
+}
+
+int MapWidget::threatRank(TrackClassification cls) {
+    switch (cls) {
+        case TrackClassification::Hostile:  return 4;
+        case TrackClassification::Pending:  return 3;
+        case TrackClassification::Unknown:  return 2;
+        case TrackClassification::Neutral:  return 1;
+        default:                            return 0;
+    }
+}
+
+void MapWidget::aggregateTracks() {
+    m_aggregates.clear();
+    m_aggregated.clear();
+    if (!m_picture || m_viewRangeM < m_aggregateRangeM) return;
+    
+    // Tracks inside the warning zone, the selected track and engaged tracks
+    // are always drawn on their own
+    const QPointF viewCentre(width() / 2.0, height() / 2.0);
+    const double keepClearPx = WARNING_RADIUS_M * mapRadius() / m_viewRangeM;
+    
+    QHash<quint64, QVector<int>> cells;
+    for (int i = 0; i < m_picture->tracks.size(); ++i) {
+        const TrackSnapshot& track = m_picture->tracks[i];
+        if (track.state == TrackState::Dropped || track.engaged) continue;
+        if (track.trackId == m_selectedTrackId) continue;
+        
+        const QPointF pos = geoToScreen(track.position);
+        if (QLineF(pos, viewCentre).length() <= keepClearPx) continue;
+        
+        const quint32 cx = quint32(qint32(std::floor(pos.x() / AGGREGATE_CELL_PX)));
+        const quint32 cy = quint32(qint32(std::floor(pos.y() / AGGREGATE_CELL_PX)));
+        cells[(quint64(cx) << 32) | cy].append(i);
+    }
+    
+    for (auto it = cells.constBegin(); it != cells.constEnd(); ++it) {
+        const QVector<int>& members = it.value();
+        if (members.size() < 2) continue;
+        
+        TrackAggregate aggregate;
+        QPointF sum;
+        for (int i : members) {
+            const TrackSnapshot& track = m_picture->tracks[i];
+            sum += geoToScreen(track.position);
+            if (threatRank(track.classification) > threatRank(aggregate.classification)) {
+                aggregate.classification = track.classification;
+            }
+            m_aggregated.insert(track.handle);
+        }
+        aggregate.count = members.size();
+        aggregate.position = sum / members.size();
+        m_aggregates.append(aggregate);
+    }
+}
+
+void MapWidget::drawLabelCluster(QPainter& painter, const LabelCluster& cluster) {
+    const QRectF rect = clusterGlyphRect(cluster);
+    painter.setPen(QPen(Qt::white, 1.5));
+    painter.setBrush(QColor(255, 255, 255, 100));
+    painter.drawEllipse(rect);
+    painter.drawText(rect, Qt::AlignCenter, QString::number(cluster.count));
+}
+
+QRectF MapWidget::clusterGlyphRect(const LabelCluster& cluster) const {
+    // Above and right of the swarm, clear of its symbols
+    const double r = qMax(9.0, QFontMetricsF(font()).horizontalAdvance(QString::number(cluster.count)) / 2.0 + 4.0);
+    const QPointF centre(cluster.bounds.right() + m_declutter.config().symbolRadius + r,
+                         cluster.bounds.top() - m_declutter.config().symbolRadius - r);
+    return QRectF(centre.x() - r, centre.y() - r, r * 2, r * 2);
+}
+
+void MapWidget::indexTracks() {
+    // Every track, also those drawn inside an aggregate, so a box or lasso
+    // over an aggregate takes its members
+    m_pickIndex.clear(rect());
+    if (m_picture) {
+        for (const TrackSnapshot& track : m_picture->tracks) {
+            if (track.state == TrackState::Dropped) continue;
+            m_pickIndex.insert(track.handle, geoToScreen(track.position));
+        }
+    }
+    m_pickIndex.build();
+}
+
+const TrackSnapshot* MapWidget::trackAtPoint(const QPointF& point) const {
+    quint64 key = 0;
+    if (!m_picture || !m_pickIndex.nearest(point, PICK_RADIUS_PX, &key)) return nullptr;
+    return m_picture->find(TrackHandle(key));
+}
+
+bool MapWidget::isSelected(const TrackSnapshot& track) const {
+    return track.trackId == m_selectedTrackId || m_selection.contains(track.handle);
+}
+
+void MapWidget::declutterLabels() {
+    QVector<LabelRequest> requests;
+    QHash<TrackHandle, QStaticText> labels;
+    if (m_picture) {
+        const double ascent = QFontMetricsF(font()).ascent();
+        for (const TrackSnapshot& track : m_picture->tracks) {
+            if (track.state == TrackState::Dropped || m_aggregated.contains(track.handle)) continue;
+            
+            QStaticText label = m_labels.value(track.handle);
+            if (label.text() != track.trackId) {
+                label = QStaticText(track.trackId);
+                label.setTextFormat(Qt::PlainText);
+                label.prepare(QTransform(), font());
+            }
+            labels.insert(track.handle, label);
+            
+            const bool selected = (track.trackId == m_selectedTrackId);
+            LabelRequest request;
+            request.key = track.handle;
+            request.anchor = geoToScreen(track.position);
+            request.size = label.size();
+            request.offset = QPointF((selected ? 12 : 8) + 5, 4 - ascent);
+            request.pinned = selected;
+            requests.append(request);
+        }
+    }
+    m_labels.swap(labels);
+    m_declutter.update(requests);
+}
+
+QVector<TrackGlyph> MapWidget::trackGlyphs() const {
+    QVector<TrackGlyph> glyphs;
+    if (!m_picture) return glyphs;
+    glyphs.reserve(m_picture->tracks.size() + m_declutter.clusters().size());
+    const double ascent = QFontMetricsF(font()).ascent();
+    
+    // The symbology drawTracks() paints
+    for (const TrackSnapshot& track : m_picture->tracks) {
+        if (track.state == TrackState::Dropped || m_aggregated.contains(track.handle)) continue;
+        
+        bool selected = isSelected(track);
+        TrackGlyph glyph;
+        glyph.position = geoToScreen(track.position);
+        glyph.color = colorForClassification(track.classification);
+        glyph.shape = TrackGlyphShape::Diamond;
+        glyph.size = selected ? 12 : 8;
+        glyph.lineWidth = selected ? 3 : 2;
+        
+        double speed = track.velocity.speed();
+        if (speed > 1.0) {
+            double heading = qDegreesToRadians(track.velocity.heading());
+            glyph.velocity = QPointF(std::sin(heading), -std::cos(heading)) * (speed * 0.5);
+            glyph.arrowHead = false;
+        }
+        
+        const LabelPlacement label = m_declutter.placement(track.handle);
+        if (label.isVisible()) {
+            glyph.label = track.trackId;
+            glyph.labelOffset = label.rect.topLeft() - glyph.position + QPointF(0.0, ascent);
+            glyph.labelColor = Qt::white;
+            if (label.leader) {
+                glyph.leader = LabelDeclutter::leaderLine(glyph.position, label.rect,
+                                                          m_declutter.config().symbolRadius);
+            }
+        }
+        glyphs.append(glyph);
+    }
+    
+    // The aggregate symbols drawAggregate() paints
+    for (const TrackAggregate& aggregate : m_aggregates) {
+        TrackGlyph glyph;
+        glyph.position = aggregate.position;
+        glyph.color = colorForClassification(aggregate.classification);
+        glyph.shape = TrackGlyphShape::Square;
+        glyph.size = float(aggregateSize(aggregate));
+        glyph.filled = true;
+        glyph.symbolText = QString::number(aggregate.count);
+        glyphs.append(glyph);
+    }
+    
+    // The count glyphs drawLabelCluster() paints
+    for (const LabelCluster& cluster : m_declutter.clusters()) {
+        const QRectF rect = clusterGlyphRect(cluster);
+        TrackGlyph glyph;
+        glyph.position = rect.center();
+        glyph.color = Qt::white;
+        glyph.shape = TrackGlyphShape::Circle;
+        glyph.size = float(rect.width() / 2.0);
+        glyph.lineWidth = 1.5f;
+        glyph.filled = true;
+        glyph.symbolText = QString::number(cluster.count);
+        glyphs.append(glyph);
     }
+    return glyphs;
 }
 
 QColor MapWidget::colorForClassification(TrackClassification cls) const {
@@ -2,12 +2,25 @@
 #define MAPWIDGET_H
 
 #include <QWidget>
+#include <QCache>
 #include <QHash>
+#include <QPixmap>
+#include <QSet>
+#include <QStringList>
 #include <QPainter>
+#include <QStaticText>
 #include "core/Track.h"
+#include "core/TrackSnapshot.h"
+#include "ui/GeofenceOverlay.h"
+#include "ui/TrackGLView.h"
+#include "utils/LabelDeclutter.h"
+#include "utils/ScreenPickIndex.h"
 
 namespace CounterUAS {
 
+class TrackManager;
+class UIFrameScheduler;
+
 class MapWidget : public QWidget {
     Q_OBJECT
     
@@ -26,8 +39,30 @@ public:
     static double zoomToRangeScale(double zoom);
     static double rangeScaleToZoom(double rangeM);
     
+    // Tracks are drawn from the manager's published pictures
+    void setTrackManager(TrackManager* manager);
+    
+    // Takes pictures from the scheduler's ticks instead of on every publish
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+    
+    // Where track symbology is drawn; Auto takes OpenGL where supported
+    void setTrackRenderBackend(TrackRenderBackend backend);
+    TrackRenderBackend trackRenderBackend() const;
+    
+    // Click selects a track; Shift-drag selects the tracks in a box and
+    // Ctrl-drag those in a lasso, the first of them also the selected track
     void selectTrack(const QString& trackId);
+    void selectTracks(const QStringList& trackIds);
     QString selectedTrack() const { return m_selectedTrackId; }
+    QStringList selectedTracks() const;
+    
+    // From this view range out, tracks beyond the warning zone that share
+    // a screen cell are drawn as one aggregate symbol
+    void setAggregateRange(double rangeM);
+    double aggregateRange() const { return m_aggregateRangeM; }
+    
+    // Restricted zones, no-fly areas and corridors, drawn with the background
+    void setGeofenceZones(const QList<GeofenceZone>& zones);
     
     // Pan controls
     void pan(const QPointF& delta);
@@ -37,16 +72,19 @@ public:
 public slots:
     void addTrack(const QString& trackId);
     void updateTrack(const QString& trackId);
+    void updateTracks(const QStringList& trackIds);
     void removeTrack(const QString& trackId);
     void clearTracks();
     
 signals:
     void trackSelected(const QString& trackId);
+    void tracksSelected(const QStringList& trackIds);
     void mapClicked(const GeoPosition& pos);
     void zoomChanged(double zoom);
     void centerChanged(const GeoPosition& pos);
     
 protected:
+    bool event(QEvent* event) override;
     void paintEvent(QPaintEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
@@ -55,11 +93,53 @@ protected:
     void resizeEvent(QResizeEvent* event) override;
     
 private:
+    static constexpr double AGGREGATE_CELL_PX = 40.0;
+    static constexpr double PICK_RADIUS_PX = 12.0;
+    static constexpr int BACKGROUND_LEVELS = 4;     // Zoom levels whose background is kept
+    static constexpr double CRITICAL_RADIUS_M = 500.0;
+    static constexpr double WARNING_RADIUS_M = 1500.0;
+    
+    /**
+     * @brief Tracks in one screen cell at wide view ranges, drawn as one symbol
+     */
+    struct TrackAggregate {
+        QPointF position;               // Mean screen position of its tracks
+        int count = 0;
+        TrackClassification classification = TrackClassification::Unknown;  // Most threatening
+    };
+    
+    /**
+     * @brief Fill and grid drawn for one zoom level
+     */
+    struct BackgroundLayer {
+        QPixmap pixmap;
+        GeoPosition centre;             // View centre the pixmap shows
+    };
+    
     double mapRadius() const;
     QPointF geoToScreen(const GeoPosition& pos) const;
+    // Metres in frame to screen pixels, as geoToScreen() projects
+    QTransform groundTransform(const LocalTangentPlane& frame) const;
     GeoPosition screenToGeo(const QPointF& screen) const;
     void drawGrid(QPainter& painter);
+    void drawBackground(QPainter& painter);
+    const QPixmap& backgroundLayer();
+    const QPixmap& defendedAreaLayer();
     void drawTracks(QPainter& painter);
+    void refreshTracks();
+    void aggregateTracks();
+    void drawAggregate(QPainter& painter, const TrackAggregate& aggregate);
+    double aggregateSize(const TrackAggregate& aggregate) const;
+    static int threatRank(TrackClassification cls);
+    void declutterLabels();
+    void indexTracks();
+    const TrackSnapshot* trackAtPoint(const QPointF& point) const;
+    bool isSelected(const TrackSnapshot& track) const;
+    void selectDragged();
+    QRect dragBounds() const;
+    QVector<TrackGlyph> trackGlyphs() const;
+    void drawLabelCluster(QPainter& painter, const LabelCluster& cluster);
+    QRectF clusterGlyphRect(const LabelCluster& cluster) const;
     void drawDefendedArea(QPainter& painter);
     QColor colorForClassification(TrackClassification cls) const;
     
@@ -67,12 +147,36 @@ private:
     double m_zoom = 15.0;
     double m_viewRangeM = 5000.0;  // View range in meters (linked with PPI range scale)
     QString m_selectedTrackId;
-    QHash<QString, Track*> m_tracks;
+    QSet<TrackHandle> m_selection;      // Box or lasso selected, with m_selectedTrackId
+    ScreenPickIndex m_pickIndex;        // Screen positions as of the last refresh
+    TrackManager* m_trackManager = nullptr;
+    TrackPicturePtr m_picture;  // Latest published track picture
+    UIFrameScheduler* m_frameScheduler = nullptr;
+    TrackGLView* m_trackGL = nullptr;
+    QHash<TrackHandle, QStaticText> m_labels;  // Laid out again only when the text changes
+    LabelDeclutter m_declutter;
+    
+    // Level of detail
+    double m_aggregateRangeM = 10000.0;
+    QVector<TrackAggregate> m_aggregates;
+    QSet<TrackHandle> m_aggregated;     // Drawn inside an aggregate rather than alone
+    
+    // Cached layers: the background scrolls with a pan and only the
+    // exposed strip is drawn; the defended area is fixed on the view centre
+    QCache<int, BackgroundLayer> m_backgrounds{BACKGROUND_LEVELS};
+    QPixmap m_defendedArea;
+    double m_defendedAreaRangeM = 0.0;
+    GeofenceOverlay m_geofences;
     
     // Pan state
     bool m_panEnabled = true;
     bool m_panning = false;
     QPointF m_lastPanPos;
+    
+    // Box or lasso drag
+    enum class DragSelect { None, Box, Lasso };
+    DragSelect m_dragSelect = DragSelect::None;
+    QPolygonF m_dragPath;
 };
 
 } // namespace CounterUAS
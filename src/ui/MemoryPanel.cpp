@@ -0,0 +1,114 @@
+#include "ui/MemoryPanel.h"
+#include "ui/UIFrameScheduler.h"
+#include "utils/MemoryAccounting.h"
+#include "utils/MemoryGovernor.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+
+namespace CounterUAS {
+
+MemoryPanel::MemoryPanel(QWidget* parent)
+    : QWidget(parent)
+    , m_refreshTimer(new QTimer(this))
+{
+    setupUI();
+
+    connect(m_refreshTimer, &QTimer::timeout, this, &MemoryPanel::refresh);
+    m_refreshTimer->start(1000);
+}
+
+void MemoryPanel::setupUI() {
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(5, 5, 5, 5);
+
+    QHBoxLayout* header = new QHBoxLayout();
+    QLabel* titleLabel = new QLabel("Memory", this);
+    titleLabel->setStyleSheet("font-weight: bold; font-size: 12px;");
+    header->addWidget(titleLabel);
+    header->addStretch();
+    QPushButton* resetButton = new QPushButton("Reset Peaks", this);
+    connect(resetButton, &QPushButton::clicked, this, &MemoryPanel::onResetPeaks);
+    header->addWidget(resetButton);
+    layout->addLayout(header);
+
+    m_table = new QTableWidget(MemoryAccounting::TAG_COUNT, 5, this);
+    m_table->setHorizontalHeaderLabels({"Subsystem", "Live", "Peak", "Allocs/s", "Allocations"});
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->setAlternatingRowColors(true);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    for (int row = 0; row < MemoryAccounting::TAG_COUNT; ++row) {
+        m_table->setItem(row, 0, new QTableWidgetItem(
+            MemoryAccounting::tagName(static_cast<MemoryTag>(row))));
+        for (int column = 1; column < m_table->columnCount(); ++column) {
+            QTableWidgetItem* item = new QTableWidgetItem("-");
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_table->setItem(row, column, item);
+        }
+    }
+    layout->addWidget(m_table);
+
+    m_summaryLabel = new QLabel(this);
+    layout->addWidget(m_summaryLabel);
+}
+
+void MemoryPanel::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+
+    if (m_frameScheduler) {
+        m_refreshTimer->stop();
+        m_frameScheduler->addClient(this, 1, [this](const UIFrame&) { refresh(); });
+    } else {
+        m_refreshTimer->start(1000);
+    }
+}
+
+void MemoryPanel::refresh() {
+    if (!isVisible()) return;  // A hidden tab picks up on its next tick
+
+    // Rates are the governor's, sampled on its poll
+    for (int row = 0; row < MemoryAccounting::TAG_COUNT; ++row) {
+        const MemoryTagStats stats = MemoryAccounting::stats(static_cast<MemoryTag>(row));
+        m_table->item(row, 1)->setText(formatBytes(stats.liveBytes));
+        m_table->item(row, 2)->setText(formatBytes(stats.peakBytes));
+        m_table->item(row, 3)->setText(QString::number(stats.allocationsPerSecond, 'f', 1));
+        m_table->item(row, 4)->setText(QString::number(stats.allocations));
+    }
+
+    const MemoryGovernor& governor = MemoryGovernor::instance();
+    const qint64 resident = governor.residentBytes();
+    const qint64 ceiling = governor.ceilingBytes();
+    const MemoryPressure pressure = governor.pressure();
+    QString text = QString("Accounted %1").arg(formatBytes(MemoryAccounting::totalLiveBytes()));
+    if (resident > 0) text += QString(" of %1 resident").arg(formatBytes(resident));
+    if (ceiling > 0) text += QString(", ceiling %1").arg(formatBytes(ceiling));
+    text += QString(", pressure %1").arg(MemoryGovernor::pressureKey(pressure));
+    m_summaryLabel->setText(text);
+    m_summaryLabel->setStyleSheet(pressure == MemoryPressure::Critical ? "color: rgb(255, 0, 0);"
+                                : pressure == MemoryPressure::Elevated ? "color: rgb(255, 165, 0);"
+                                                                       : QString());
+}
+
+void MemoryPanel::onResetPeaks() {
+    MemoryAccounting::resetPeaks();
+    refresh();
+}
+
+QString MemoryPanel::formatBytes(qint64 bytes) {
+    if (bytes < 1024) {
+        return QString("%1 B").arg(bytes);
+    }
+    if (bytes < 1024 * 1024) {
+        return QString("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QString("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,45 @@
+#ifndef MEMORYPANEL_H
+#define MEMORYPANEL_H
+
+#include <QWidget>
+#include <QTableWidget>
+#include <QLabel>
+#include <QTimer>
+
+namespace CounterUAS {
+
+class UIFrameScheduler;
+
+/**
+ * @brief Diagnostics panel showing MemoryAccounting per subsystem
+ *
+ * One row per tag with its live and peak bytes and allocation rate, and a
+ * summary line setting the accounted total against the resident size, the
+ * ceiling and the pressure the MemoryGovernor last saw.
+ */
+class MemoryPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit MemoryPanel(QWidget* parent = nullptr);
+
+    // Refreshes on the scheduler's ticks instead of the panel's own timer
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+
+private slots:
+    void refresh();
+    void onResetPeaks();
+
+private:
+    void setupUI();
+    static QString formatBytes(qint64 bytes);
+
+    QTableWidget* m_table;
+    QLabel* m_summaryLabel;
+    QTimer* m_refreshTimer;
+    UIFrameScheduler* m_frameScheduler = nullptr;
+};
+
+} // namespace CounterUAS
+
+#endif // MEMORYPANEL_H
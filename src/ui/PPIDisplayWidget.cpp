@@ -1,6 +1,13 @@
 #include "ui/PPIDisplayWidget.h"
 #include "core/TrackManager.h"
+#include "sensors/RadarVideoSource.h"
+#include "ui/UIFrameScheduler.h"
 #include "utils/CoordinateUtils.h"
+#include "utils/FlightRecorder.h"
+#include "utils/MemoryGovernor.h"
+#include "utils/PipelineLatency.h"
+#include "utils/TimeUtils.h"
+#include "utils/Trace.h"
 #include <QPainter>
 #include <QMouseEvent>
 #include <QWheelEvent>
@@ -8,15 +15,23 @@
 #include <QDateTime>
 #include <QUrlQuery>
 #include <QImageReader>
+#include <QToolTip>
+#include <algorithm>
 
 namespace CounterUAS {
 
+namespace {
+
+constexpr int TILE_CACHE_KIB = 64 * 1024;   // Decoded tiles at normal memory pressure
+
+} // namespace
+
 PPIDisplayWidget::PPIDisplayWidget(QWidget* parent)
     : QWidget(parent)
     , m_sweepTimer(new QTimer(this))
     , m_historyTimer(new QTimer(this))
-    , m_networkManager(new QNetworkAccessManager(this))
-    , m_tileCache(100)  // Cache up to 100 tiles
+    , m_tileStore(new MapTileStore(this))
+    , m_tileCache(TILE_CACHE_KIB)
 {
     setMinimumSize(400, 400);
     setMouseTracking(true);
@@ -25,9 +40,8 @@ PPIDisplayWidget::PPIDisplayWidget(QWidget* parent)
     m_center.latitude = 34.0522;
     m_center.longitude = -118.2437;
     m_center.altitude = 0;
-    
-    // Initialize sweep trail
-    m_sweepTrail.fill(0.0, SWEEP_TRAIL_LENGTH);
+    m_frame.setOrigin(m_center);
+    m_trailFrame.setOrigin(m_center);
     
     // Sweep timer - update at 60 FPS
     connect(m_sweepTimer, &QTimer::timeout, this, &PPIDisplayWidget::updateSweep);
@@ -38,21 +52,42 @@ PPIDisplayWidget::PPIDisplayWidget(QWidget* parent)
     m_historyTimer->setInterval(100);  // 10 Hz
     m_historyTimer->start();
     
-    // Network manager for map tiles
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, &PPIDisplayWidget::onMapTileReceived);
+    // Map tiles are decoded off the GUI thread
+    connect(m_tileStore, &MapTileStore::tileLoaded, this, &PPIDisplayWidget::onMapTileLoaded);
     
     // Default map tile URL (OpenStreetMap)
     m_mapTileUrlTemplate = "https://tile.openstreetmap.org/{z}/{x}/{y}.png";
+    m_tileStore->setUrlTemplate(m_mapTileUrlTemplate);
+    
+    // Under memory pressure fewer tiles stay decoded; the rest reload from the store.
+    // The governor polls from the GUI thread, so the probe can read the cache
+    m_memoryConsumer = MemoryGovernor::instance().registerConsumer(this, "ppi.tileCache", MemoryShedOrder::MapTiles, 0,
+        [this]() { return qint64(m_tileCache.totalCost()) * 1024; },
+        [this](MemoryPressure pressure) {
+            const int divisor = pressure == MemoryPressure::Critical ? 8
+                              : pressure == MemoryPressure::Elevated ? 2 : 1;
+            m_tileCache.setMaxCost(TILE_CACHE_KIB / divisor);
+            m_tileAccount.set(qint64(m_tileCache.totalCost()) * 1024);
+        });
+    
+    setTrackRenderBackend(TrackGLView::defaultBackend());
 }
 
 PPIDisplayWidget::~PPIDisplayWidget() {
+    MemoryGovernor::instance().unregisterConsumer(m_memoryConsumer);
     stopSweep();
+    // Joined while the widget can still take its last frameReady()
+    delete m_trackRenderer;
 }
 
 void PPIDisplayWidget::setCenter(const GeoPosition& pos) {
     m_center = pos;
+    m_frame.setOrigin(m_center);
+    if (m_trackHistory.isEmpty()) {
+        m_trailFrame.setOrigin(m_center);
+    }
     m_backgroundDirty = true;
+    m_trackLayerDirty = true;
     updateVisibleTiles();
     emit centerChanged(m_center);
     update();
@@ -60,7 +95,12 @@ void PPIDisplayWidget::setCenter(const GeoPosition& pos) {
 
 void PPIDisplayWidget::setCenterSilent(const GeoPosition& pos) {
     m_center = pos;
+    m_frame.setOrigin(m_center);
+    if (m_trackHistory.isEmpty()) {
+        m_trailFrame.setOrigin(m_center);
+    }
     m_backgroundDirty = true;
+    m_trackLayerDirty = true;
     updateVisibleTiles();
     update();
 }
@@ -68,6 +108,7 @@ void PPIDisplayWidget::setCenterSilent(const GeoPosition& pos) {
 void PPIDisplayWidget::setRangeScale(double rangeM) {
     m_rangeScaleM = qBound(100.0, rangeM, 50000.0);
     m_backgroundDirty = true;
+    m_trackLayerDirty = true;
     emit rangeScaleChanged(m_rangeScaleM);
     updateVisibleTiles();
     update();
@@ -76,6 +117,7 @@ void PPIDisplayWidget::setRangeScale(double rangeM) {
 void PPIDisplayWidget::setRangeScaleSilent(double rangeM) {
     m_rangeScaleM = qBound(100.0, rangeM, 50000.0);
     m_backgroundDirty = true;
+    m_trackLayerDirty = true;
     updateVisibleTiles();
     update();
 }
@@ -107,13 +149,11 @@ void PPIDisplayWidget::panView(const QPointF& deltaPixels) {
     double distanceY = deltaPixels.y() / scale;   // meters (y is inverted)
     
     // Convert meter offset to lat/lon
-    double dLat = distanceY / CoordinateUtils::DEG_TO_M_LAT;
-    double dLon = distanceX / CoordinateUtils::degToMeterLon(m_center.latitude);
-    
-    m_center.latitude += dLat;
-    m_center.longitude += dLon;
+    m_center = m_frame.toGeoLinear(EnuVector{distanceX, distanceY, 0.0});
+    m_frame.setOrigin(m_center);
     
     m_backgroundDirty = true;
+    m_trackLayerDirty = true;
     updateVisibleTiles();
     emit centerChanged(m_center);
     update();
@@ -123,6 +163,7 @@ void PPIDisplayWidget::setDisplayMode(PPIDisplayMode mode) {
     if (m_displayMode != mode) {
         m_displayMode = mode;
         m_backgroundDirty = true;
+        m_sweepWedgeDirty = true;
         
         // Adjust colors based on mode
         switch (mode) {
@@ -148,6 +189,8 @@ void PPIDisplayWidget::setDisplayMode(PPIDisplayMode mode) {
                 break;
         }
         
+        updateVisibleTiles();
+        updateGLSweep();
         emit displayModeChanged(mode);
         update();
     }
@@ -158,6 +201,7 @@ void PPIDisplayWidget::setSweepMode(PPISweepMode mode) {
     if (mode == PPISweepMode::None) {
         stopSweep();
     }
+    updateGLSweep();
     update();
 }
 
@@ -178,6 +222,7 @@ void PPIDisplayWidget::setRangeRingCount(int count) {
 
 void PPIDisplayWidget::setShowRangeLabels(bool show) {
     m_showRangeLabels = show;
+    m_backgroundDirty = true;
     update();
 }
 
@@ -189,6 +234,7 @@ void PPIDisplayWidget::setAzimuthDivisions(int divisions) {
 
 void PPIDisplayWidget::setShowAzimuthLabels(bool show) {
     m_showAzimuthLabels = show;
+    m_backgroundDirty = true;
     update();
 }
 
@@ -202,29 +248,218 @@ void PPIDisplayWidget::setTrackManager(TrackManager* manager) {
     if (m_trackManager) {
         connect(m_trackManager, &TrackManager::trackCreated,
                 this, &PPIDisplayWidget::addTrack);
-        connect(m_trackManager, &TrackManager::trackUpdated,
-                this, &PPIDisplayWidget::updateTrack);
         connect(m_trackManager, &TrackManager::trackDropped,
                 this, &PPIDisplayWidget::removeTrack);
+        if (!m_frameScheduler) {
+            connect(m_trackManager, &TrackManager::snapshotPublished,
+                    this, &PPIDisplayWidget::onSnapshotPublished);
+        }
+        m_picture = m_trackManager->snapshot();
+    } else {
+        m_picture.reset();
+    }
+    m_trackLayerDirty = true;
+    loadTrails();
+    update();
+}
+
+void PPIDisplayWidget::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+    setTrackManager(m_trackManager);
+    
+    if (m_frameScheduler) {
+        if (m_trackRenderer) {
+            m_trackRenderer->setMaxFps(m_frameScheduler->refreshRateHz());
+        }
+        m_sweepTimer->stop();
+        m_historyTimer->stop();
+        m_frameScheduler->addClient(this, 0, [this](const UIFrame& frame) { advanceFrame(frame); });
+        updateFrameTriggers();
+    } else {
+        m_historyTimer->start();
+        if (m_sweepRunning || m_radarVideo) {
+            m_sweepTimer->start();
+        }
+    }
+}
+
+void PPIDisplayWidget::advanceFrame(const UIFrame& frame) {
+    if (m_sweepRunning || m_radarVideo) {
+        advanceSweep(frame.intervalS);
+    }
+    
+    m_sinceHistoryS += frame.intervalS;
+    if (m_sinceHistoryS >= m_historyTimer->interval() / 1000.0) {
+        m_sinceHistoryS = 0.0;
+        updateTrackHistory();
+    }
+    
+    if (frame.picture && frame.picture != m_picture) {
+        applyPicture(frame.picture);
+    }
+}
+
+void PPIDisplayWidget::setTrackRenderBackend(TrackRenderBackend backend) {
+    if (backend == TrackRenderBackend::Auto) {
+        backend = TrackGLView::isSupported() ? TrackRenderBackend::OpenGL : TrackRenderBackend::Software;
+    }
+    if (backend == trackRenderBackend()) return;
+    
+    if (m_trackGL) {
+        m_trackGL->deleteLater();
+        m_trackGL = nullptr;
+    }
+    // Joins the worker; a frame it finished is dropped with it
+    delete m_trackRenderer;
+    m_trackRenderer = nullptr;
+    
+    if (backend == TrackRenderBackend::OpenGL) {
+        m_trackGL = new TrackGLView(this);
+        m_trackGL->setGeometry(rect());
+        m_trackGL->setLabelFont(trackLabelFont());
+        m_trackGL->setTrailWindow(m_trackHistorySeconds);
+        m_trackGL->setTrailsVisible(m_showTrackHistory);
+        m_trackGL->setRadarVideo(m_radarVideo);
+        m_trackGL->setRadarVideoTransform(groundTransform(m_radarSite));
+        updateGLSweep();
+        // A context too old for instancing falls back to painting
+        connect(m_trackGL, &TrackGLView::unavailable, this, [this]() {
+            setTrackRenderBackend(TrackRenderBackend::Software);
+        });
+        m_trackGL->show();
+        loadTrails();
+        m_trackLayer = QImage();
+    } else if (backend == TrackRenderBackend::Threaded) {
+        m_trackRenderer = new TrackLayerRenderer(this);
+        if (m_frameScheduler) {
+            m_trackRenderer->setMaxFps(m_frameScheduler->refreshRateHz());
+        }
+        connect(m_trackRenderer, &TrackLayerRenderer::frameReady,
+                this, &PPIDisplayWidget::onTrackLayerReady, Qt::QueuedConnection);
+    }
+    m_trackRegion = QRegion();
+    m_trackLayerDirty = true;
+    // The afterglow moves between the wedge and the GL view
+    m_sweepWedgeDirty = true;
+    update();
+}
+
+TrackRenderBackend PPIDisplayWidget::trackRenderBackend() const {
+    if (m_trackGL) return TrackRenderBackend::OpenGL;
+    return m_trackRenderer ? TrackRenderBackend::Threaded : TrackRenderBackend::Software;
+}
+
+void PPIDisplayWidget::setRadarVideo(RadarVideoSource* source) {
+    m_radarVideo = source ? source->ring() : nullptr;
+    m_radarSite = source ? source->site() : GeoPosition();
+    if (m_trackGL) {
+        m_trackGL->setRadarVideo(m_radarVideo);
+        m_trackGL->setRadarVideoTransform(groundTransform(m_radarSite));
+    }
+    // The video fades and the sweep follows it without the sweep running
+    if (m_radarVideo && !m_frameScheduler) {
+        m_sweepTimer->start();
+    } else if (!m_radarVideo && !m_sweepRunning) {
+        m_sweepTimer->stop();
+    }
+    updateFrameTriggers();
+}
+
+void PPIDisplayWidget::updateFrameTriggers() {
+    // An animated sweep needs every frame; a still scope only track changes
+    if (m_frameScheduler) {
+        m_frameScheduler->setClientTriggers(this, (m_sweepRunning || m_radarVideo) ? FrameEveryTick : FrameOnTracks);
+    }
+}
+
+void PPIDisplayWidget::loadTrails() {
+    if (!m_trackGL) return;
+    m_trackGL->clearTrails();
+    
+    // Each trail oldest first; the view fades them by age
+    QVector<TrackTrailSample> samples;
+    for (auto it = m_trackHistory.constBegin(); it != m_trackHistory.constEnd(); ++it) {
+        const TrackSnapshot* track = m_picture ? m_picture->find(it.key()) : nullptr;
+        const QColor color = colorForClassification(track ? track->classification : TrackClassification::Unknown);
+        const RingBuffer<TrackHistoryPoint>& history = it.value();
+        for (int i = 0; i < history.size(); ++i) {
+            samples.append({quint64(it.key()), history[i].position, history[i].timestamp, color});
+        }
     }
+    m_trackGL->appendTrailSamples(samples);
 }
 
 void PPIDisplayWidget::selectTrack(const QString& trackId) {
+    // Re-selecting one of a box or lasso selection keeps the rest of it
+    const TrackSnapshot* track = m_picture ? m_picture->find(trackId) : nullptr;
+    if (!track || !m_selection.contains(track->handle)) {
+        m_selection.clear();
+    }
     m_selectedTrackId = trackId;
+    refreshTracks();
+}
+
+void PPIDisplayWidget::selectTracks(const QStringList& trackIds) {
+    m_selection.clear();
+    for (const QString& id : trackIds) {
+        if (const TrackSnapshot* track = m_picture ? m_picture->find(id) : nullptr) {
+            m_selection.insert(track->handle);
+        }
+    }
+    m_selectedTrackId = trackIds.value(0);
+    refreshTracks();
+}
+
+QStringList PPIDisplayWidget::selectedTracks() const {
+    QStringList ids;
+    if (!m_selectedTrackId.isEmpty()) ids.append(m_selectedTrackId);
+    if (!m_picture) return ids;
+    for (TrackHandle handle : m_selection) {
+        const TrackSnapshot* track = m_picture->find(handle);
+        if (track && track->trackId != m_selectedTrackId) ids.append(track->trackId);
+    }
+    return ids;
+}
+
+void PPIDisplayWidget::setCollapseGroups(bool collapse) {
+    if (m_collapseGroups == collapse) return;
+    m_collapseGroups = collapse;
+    m_trackLayerDirty = true;
     update();
 }
 
 void PPIDisplayWidget::setShowTrackHistory(bool show) {
     m_showTrackHistory = show;
+    if (m_trackGL) {
+        m_trackGL->setTrailsVisible(show);
+    }
+    m_trackLayerDirty = true;
     update();
 }
 
 void PPIDisplayWidget::setTrackHistoryLength(int seconds) {
     m_trackHistorySeconds = qBound(5, seconds, 300);
+    
+    const int capacity = trailCapacity();
+    for (auto it = m_trackHistory.begin(); it != m_trackHistory.end(); ++it) {
+        it.value().setCapacity(capacity);
+    }
+    if (m_trackGL) {
+        m_trackGL->setTrailWindow(m_trackHistorySeconds);
+    }
+}
+
+int PPIDisplayWidget::trailCapacity() const {
+    // One point per published picture at the 10 Hz track cycle
+    return m_trackHistorySeconds * 10 + 1;
 }
 
 void PPIDisplayWidget::setDefendedAreaVisible(bool visible) {
     m_showDefendedArea = visible;
+    m_backgroundDirty = true;
     update();
 }
 
@@ -232,26 +467,49 @@ void PPIDisplayWidget::setDefendedAreaRadii(double criticalM, double warningM, d
     m_criticalRadiusM = criticalM;
     m_warningRadiusM = warningM;
     m_detectionRadiusM = detectionM;
+    m_backgroundDirty = true;
+    update();
+}
+
+void PPIDisplayWidget::setGeofenceZones(const QList<GeofenceZone>& zones) {
+    m_geofences.setZones(zones);
+    m_backgroundDirty = true;
     update();
 }
 
 void PPIDisplayWidget::setMapTileUrl(const QString& urlTemplate) {
     m_mapTileUrlTemplate = urlTemplate;
+    m_tileStore->setUrlTemplate(urlTemplate);
     m_tileCache.clear();
+    m_tileAccount.set(0);
+    m_backgroundDirty = true;
     updateVisibleTiles();
+    update();
 }
 
 void PPIDisplayWidget::setMapZoomLevel(int zoom) {
     m_mapZoomLevel = qBound(1, zoom, 19);
-    m_tileCache.clear();
+    m_backgroundDirty = true;
     updateVisibleTiles();
+    update();
 }
 
 void PPIDisplayWidget::setMapOpacity(double opacity) {
     m_mapOpacity = qBound(0.0, opacity, 1.0);
+    m_backgroundDirty = true;
     update();
 }
 
+void PPIDisplayWidget::setMapTileCacheDirectory(const QString& path) {
+    m_tileStore->setCacheDirectory(path);
+    updateVisibleTiles();
+}
+
+void PPIDisplayWidget::addMapTilePack(const QString& path) {
+    m_tileStore->addTilePack(path);
+    updateVisibleTiles();
+}
+
 bool PPIDisplayWidget::loadLocalMap(const QString& filePath) {
     QImageReader reader(filePath);
     reader.setAutoTransform(true);
@@ -269,7 +527,9 @@ bool PPIDisplayWidget::loadLocalMap(const QString& filePath) {
         setCursor(Qt::OpenHandCursor);
     }
     m_tileCache.clear();
-    m_pendingTiles.clear();
+    m_tileAccount.set(0);
+    updateVisibleTiles();
+    m_backgroundDirty = true;
     update();
     return true;
 }
@@ -281,6 +541,7 @@ void PPIDisplayWidget::clearLocalMap() {
     m_localMapBaseScale = 1.0;
     m_mapPanning = false;
     unsetCursor();
+    m_backgroundDirty = true;
     updateVisibleTiles();
     update();
 }
@@ -307,6 +568,7 @@ void PPIDisplayWidget::zoomLocalMap(double factor, const QPointF& anchor) {
 
     m_localMapScale = newScale;
     m_localMapOffset = newMapCenter - screenCenter();
+    m_backgroundDirty = true;
     update();
 }
 
@@ -315,6 +577,7 @@ void PPIDisplayWidget::panLocalMap(const QPointF& delta) {
         return;
     }
     m_localMapOffset += delta;
+    m_backgroundDirty = true;
     update();
 }
 
@@ -325,6 +588,7 @@ void PPIDisplayWidget::resetLocalMapView() {
     updateLocalMapBaseScale();
     m_localMapScale = m_localMapBaseScale;
     m_localMapOffset = QPointF(0.0, 0.0);
+    m_backgroundDirty = true;
     update();
 }
 
@@ -345,6 +609,8 @@ void PPIDisplayWidget::setBackgroundColor(const QColor& color) {
 
 void PPIDisplayWidget::setSweepColor(const QColor& color) {
     m_sweepColor = color;
+    m_sweepWedgeDirty = true;
+    updateGLSweep();
     update();
 }
 
@@ -360,99 +626,165 @@ void PPIDisplayWidget::setTrackColors(const QColor& hostile, const QColor& frien
     m_friendlyColor = friendly;
     m_unknownColor = unknown;
     m_neutralColor = neutral;
+    m_trackLayerDirty = true;
     update();
 }
 
 void PPIDisplayWidget::setNorthUp(bool northUp) {
     m_northUp = northUp;
+    m_backgroundDirty = true;
+    m_trackLayerDirty = true;
     update();
 }
 
 void PPIDisplayWidget::setHeading(double headingDeg) {
     m_heading = fmod(headingDeg + 360.0, 360.0);
     if (!m_northUp) {
+        m_backgroundDirty = true;
+        m_trackLayerDirty = true;
         update();
     }
 }
 
 void PPIDisplayWidget::addTrack(const QString& trackId) {
     if (m_trackManager) {
-        Track* track = m_trackManager->track(trackId);
-        if (track) {
-            m_tracks[trackId] = track;
-            m_trackHistory[trackId] = QList<TrackHistoryPoint>();
+        TrackHandle handle = m_trackManager->handleOf(trackId);
+        if (handle != INVALID_TRACK_HANDLE) {
+            m_trackHistory[handle] = RingBuffer<TrackHistoryPoint>(trailCapacity());
         }
     }
-    update();
+    refreshTracks();
 }
 
 void PPIDisplayWidget::updateTrack(const QString& trackId) {
-    if (m_trackManager && m_tracks.contains(trackId)) {
-        Track* track = m_tracks[trackId];
-        if (track) {
-            // Add to history
-            QPointF ppiPos = geoToPPI(track->position());
-            TrackHistoryPoint histPt;
-            histPt.position = ppiPos;
-            histPt.timestamp = QDateTime::currentMSecsSinceEpoch();
-            histPt.intensity = 1.0;
-            m_trackHistory[trackId].append(histPt);
-            
-            // Trim old history
-            qint64 cutoffTime = histPt.timestamp - (m_trackHistorySeconds * 1000);
-            while (!m_trackHistory[trackId].isEmpty() && 
-                   m_trackHistory[trackId].first().timestamp < cutoffTime) {
-                m_trackHistory[trackId].removeFirst();
-            }
+    // Track state is read from the published picture; history is sampled
+    // in onSnapshotPublished() so it stays consistent with what is drawn.
+    Q_UNUSED(trackId)
+    refreshTracks();
+}
+
+void PPIDisplayWidget::updateTracks(const QStringList& trackIds) {
+    Q_UNUSED(trackIds)
+    refreshTracks();
+}
+
+void PPIDisplayWidget::onSnapshotPublished() {
+    if (!m_trackManager) return;
+    applyPicture(m_trackManager->snapshot());
+}
+
+void PPIDisplayWidget::applyPicture(TrackPicturePtr picture) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::applyPicture");
+    m_picture = std::move(picture);
+    
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 cutoffTime = now - (m_trackHistorySeconds * 1000);
+    
+    QVector<TrackTrailSample> samples;
+    for (const TrackSnapshot& track : m_picture->tracks) {
+        RingBuffer<TrackHistoryPoint>& history = m_trackHistory[track.handle];
+        if (history.capacity() == 0) {
+            history.setCapacity(trailCapacity());
+        }
+        
+        const EnuVector enu = m_trailFrame.toEnu(track.position);
+        TrackHistoryPoint histPt;
+        histPt.position = QPointF(enu.east, enu.north);
+        histPt.timestamp = now;
+        history.append(histPt);
+        if (m_trackGL) {
+            samples.append({quint64(track.handle), histPt.position, now,
+                            colorForClassification(track.classification)});
+        }
+        
+        // Trim old history
+        while (!history.isEmpty() && history.first().timestamp < cutoffTime) {
+            history.removeFirst();
         }
     }
-    update();
+    
+    if (m_trackGL) {
+        m_trackGL->appendTrailSamples(samples);
+    }
+    refreshTracks();
 }
 
 void PPIDisplayWidget::removeTrack(const QString& trackId) {
-    m_tracks.remove(trackId);
-    m_trackHistory.remove(trackId);
+    // Dropped tracks stay registered until pruned, so the handle still resolves
+    if (m_trackManager) {
+        TrackHandle handle = m_trackManager->handleOf(trackId);
+        m_trackHistory.remove(handle);
+        m_selection.remove(handle);
+        if (m_trackGL) {
+            m_trackGL->removeTrail(quint64(handle));
+        }
+    }
     if (m_selectedTrackId == trackId) {
         m_selectedTrackId.clear();
     }
-    update();
+    refreshTracks();
 }
 
 void PPIDisplayWidget::clearTracks() {
-    m_tracks.clear();
+    m_picture.reset();
     m_trackHistory.clear();
+    m_trailFrame.setOrigin(m_center);
     m_selectedTrackId.clear();
+    m_selection.clear();
+    if (m_trackGL) {
+        m_trackGL->clearTrails();
+    }
+    m_trackLayerDirty = true;
     update();
 }
 
 void PPIDisplayWidget::startSweep() {
     if (!m_sweepRunning && m_sweepMode != PPISweepMode::None) {
         m_sweepRunning = true;
-        m_sweepTimer->start();
+        if (!m_frameScheduler) {
+            m_sweepTimer->start();
+        }
+        updateFrameTriggers();
     }
 }
 
 void PPIDisplayWidget::stopSweep() {
     m_sweepRunning = false;
-    m_sweepTimer->stop();
+    if (!m_radarVideo) {
+        m_sweepTimer->stop();
+    }
+    updateFrameTriggers();
 }
 
 void PPIDisplayWidget::resetSweep() {
     m_sweepAngle = 0.0;
-    m_sweepTrail.fill(0.0);
+    updateGLSweep();
     update();
 }
 
 void PPIDisplayWidget::refresh() {
     m_backgroundDirty = true;
+    m_sweepWedgeDirty = true;
+    m_trackLayerDirty = true;
     update();
 }
 
 void PPIDisplayWidget::updateSweep() {
-    // Calculate angle increment based on timer interval and sweep speed
-    double angleIncrement = m_sweepSpeed * (m_sweepTimer->interval() / 1000.0);
+    advanceSweep(m_sweepTimer->interval() / 1000.0);
+}
+
+void PPIDisplayWidget::advanceSweep(double seconds) {
+    // Angle increment from the elapsed time and sweep speed
+    double angleIncrement = m_sweepSpeed * seconds;
     
-    if (m_sweepMode == PPISweepMode::Rotating) {
+    if (m_radarVideo && QDateTime::currentMSecsSinceEpoch() - m_radarVideo->lastWriteMs() < VIDEO_SWEEP_TIMEOUT_MS) {
+        // The antenna's bearing, as of its latest spoke
+        m_sweepAngle = m_radarVideo->lastAzimuthDeg();
+    } else if (!m_sweepRunning) {
+        // Only the video is left to fade
+        if (m_trackGL) m_trackGL->update();
+        return;
+    } else if (m_sweepMode == PPISweepMode::Rotating) {
         m_sweepAngle = fmod(m_sweepAngle + angleIncrement, 360.0);
     } else if (m_sweepMode == PPISweepMode::Sector) {
         m_sweepAngle += angleIncrement;
@@ -461,42 +793,105 @@ void PPIDisplayWidget::updateSweep() {
         }
     }
     
-    // Update sweep trail (persistence effect)
-    for (int i = SWEEP_TRAIL_LENGTH - 1; i > 0; --i) {
-        m_sweepTrail[i] = m_sweepTrail[i - 1] * 0.95;  // Decay
-    }
-    m_sweepTrail[0] = m_sweepAngle;
-    
+    updateGLSweep();
     emit sweepAngleChanged(m_sweepAngle);
-    update();
+    
+    // Where the wedge was, where it is now, and the angle readout
+    const QRect bounds = sweepBounds();
+    update(QRegion(bounds).united(m_sweepBounds).united(scaleInfoRect()));
+    m_sweepBounds = bounds;
 }
 
 void PPIDisplayWidget::updateTrackHistory() {
     qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
     qint64 cutoffTime = currentTime - (m_trackHistorySeconds * 1000);
     
-    // Update intensity for fading effect
+    // Only expired points are touched; fading is done when drawing. Tracks
+    // in the picture are also trimmed as they are sampled, this catches
+    // the ones that stopped reporting.
     for (auto it = m_trackHistory.begin(); it != m_trackHistory.end(); ++it) {
-        QList<TrackHistoryPoint>& history = it.value();
-        for (TrackHistoryPoint& pt : history) {
-            double age = (currentTime - pt.timestamp) / 1000.0;
-            pt.intensity = qMax(0.0, 1.0 - (age / m_trackHistorySeconds));
-        }
-        
-        // Remove old points
+        RingBuffer<TrackHistoryPoint>& history = it.value();
         while (!history.isEmpty() && history.first().timestamp < cutoffTime) {
             history.removeFirst();
         }
     }
 }
 
+bool PPIDisplayWidget::event(QEvent* event) {
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent* help = static_cast<QHelpEvent*>(event);
+        if (const TrackSnapshot* track = trackAtPoint(help->pos())) {
+            QToolTip::showText(help->globalPos(), QString("%1\n%2").arg(trackLabelText(*track),
+                               Track::classificationToString(track->classification)), this);
+        } else {
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
+
 void PPIDisplayWidget::paintEvent(QPaintEvent* event) {
-    Q_UNUSED(event)
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::paintEvent");
+    FlightScope flightScope(FlightStage::Paint);
+    const qreal dpr = devicePixelRatioF();
+    const QSize layerSize = size() * dpr;
+    if (m_backgroundDirty || m_backgroundCache.size() != layerSize) {
+        renderStaticLayer();
+    }
+    // The worker's layer is shown at whatever size it has until a new one lands
+    if (m_trackLayerDirty || (!m_trackGL && !m_trackRenderer && m_trackLayer.size() != layerSize)) {
+        renderTrackLayer();
+    }
     
+    // Qt clips the painter to the update region; blit only its bounds
     QPainter painter(this);
+    const QRect area = event->rect();
+    const QRectF source(QPointF(area.topLeft()) * dpr, QSizeF(area.size()) * dpr);
+    painter.drawPixmap(QRectF(area), m_backgroundCache, source);
+    
+    if (m_sweepMode != PPISweepMode::None && m_displayMode != PPIDisplayMode::MapOnly &&
+        area.intersects(sweepBounds())) {
+        drawSweep(painter);
+    }
+    
+    if (!m_trackGL) {
+        painter.drawImage(QRectF(area), m_trackLayer, source);
+    }
+    
+    if (area.intersects(scaleInfoRect())) {
+        painter.setRenderHint(QPainter::Antialiasing);
+        drawScaleInfo(painter);
+    }
+    
+    if (m_dragSelect != DragSelect::None && m_dragPath.size() > 1) {
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(QPen(QColor(255, 255, 255, 200), 1, Qt::DashLine));
+        painter.setBrush(QColor(255, 255, 255, 30));
+        painter.drawPolygon(m_dragPath);
+    }
+    
+    // The first paint showing a newer plot closes its detect-to-display path
+    if (m_picture && PipelineLatency::recordNewest(PipelineStage::Display, m_picture->newestIngestNs,
+                                                   m_latencyIngestNs) &&
+        m_picture->newestReceiveLagUs >= 0) {
+        const qint64 sinceReadUs = (TimeUtils::monotonicNs() - m_picture->newestIngestNs) / 1000;
+        PipelineLatency::record(PipelineStage::EndToEnd, m_picture->newestReceiveLagUs + sinceReadUs);
+    }
+}
+
+void PPIDisplayWidget::renderStaticLayer() {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::renderStaticLayer");
+    const qreal dpr = devicePixelRatioF();
+    m_backgroundCache = QPixmap(size() * dpr);
+    m_backgroundCache.setDevicePixelRatio(dpr);
+    
+    // Off-screen painters start with the application font, not the widget's
+    QPainter painter(&m_backgroundCache);
     painter.setRenderHint(QPainter::Antialiasing);
+    painter.setFont(font());
     
-    // Draw layers in order
     drawBackground(painter);
     
     if (m_displayMode == PPIDisplayMode::MapOverlay || 
@@ -507,16 +902,325 @@ void PPIDisplayWidget::paintEvent(QPaintEvent* event) {
     drawRangeRings(painter);
     drawAzimuthLines(painter);
     drawDefendedArea(painter);
+    drawGeofences(painter);
+    drawNorthIndicator(painter);
+    drawCompassRose(painter);
     
-    if (m_sweepMode != PPISweepMode::None && m_displayMode != PPIDisplayMode::MapOnly) {
+    m_backgroundDirty = false;
+}
+
+void PPIDisplayWidget::renderSweepWedge() {
+    const double radius = ppiRadius();
+    const double span = SWEEP_TRAIL_SPAN_DEG;
+    
+    // Bearing 0 points up; the trail lies anticlockwise of it
+    const double margin = 4.0;
+    m_sweepWedgeRect = QRectF(QPointF(-radius * sin(qDegreesToRadians(span)) - margin, -radius - margin),
+                              QPointF(margin, margin));
+    
+    const qreal dpr = devicePixelRatioF();
+    m_sweepWedge = QPixmap((m_sweepWedgeRect.size() * dpr).toSize() + QSize(1, 1));
+    m_sweepWedge.setDevicePixelRatio(dpr);
+    m_sweepWedge.fill(Qt::transparent);
+    
+    QPainter painter(&m_sweepWedge);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-m_sweepWedgeRect.topLeft());
+    // TrackGLView draws the afterglow itself, over the video
+    if (!m_trackGL) {
         drawSweepTrail(painter);
-        drawSweep(painter);
     }
     
-    drawTracks(painter);
-    drawNorthIndicator(painter);
-    drawCompassRose(painter);
-    drawScaleInfo(painter);
+    // Draw sweep line
+    painter.setPen(QPen(m_sweepColor, 2));
+    painter.drawLine(QPointF(0.0, 0.0), QPointF(0.0, -radius));
+    
+    // Draw bright tip
+    painter.setPen(QPen(m_sweepColor.lighter(150), 4));
+    painter.drawPoint(QPointF(0.0, -radius));
+    
+    m_sweepWedgeDirty = false;
+}
+
+void PPIDisplayWidget::renderTrackLayer() {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::renderTrackLayer");
+    if (m_trackGL) {
+        m_trackGL->setGlyphs(trackGlyphs(layoutTracks()));
+        m_trackLayerDirty = false;
+        return;
+    }
+    if (m_trackRenderer) {
+        m_trackRenderer->submit(trackLayerFrame(layoutTracks()));
+        m_trackLayerDirty = false;
+        return;
+    }
+    
+    const qreal dpr = devicePixelRatioF();
+    if (m_trackLayer.size() != size() * dpr) {
+        m_trackLayer = QImage(size() * dpr, QImage::Format_ARGB32_Premultiplied);
+    }
+    m_trackLayer.setDevicePixelRatio(dpr);
+    m_trackLayer.fill(Qt::transparent);
+    
+    QPainter painter(&m_trackLayer);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setFont(font());
+    
+    m_trackRegion = QRegion();
+    for (const TrackItem& item : layoutTracks()) {
+        drawTrack(painter, *item.track, item.pos);
+        m_trackRegion += item.bounds;
+    }
+    for (const LabelCluster& cluster : m_declutter.clusters()) {
+        drawLabelCluster(painter, cluster);
+        m_trackRegion += clusterGlyphRect(cluster).toAlignedRect();
+    }
+    m_trackLayerDirty = false;
+}
+
+void PPIDisplayWidget::refreshTracks() {
+    if (m_trackGL && !m_trackLayerDirty) {
+        m_trackGL->setGlyphs(trackGlyphs(layoutTracks()));
+        update(scaleInfoRect());
+        return;
+    }
+    if (m_trackRenderer && !m_trackLayerDirty && isVisible()) {
+        // Repainted where the tracks were and are once the worker is done
+        m_trackRenderer->submit(trackLayerFrame(layoutTracks()));
+        update(scaleInfoRect());
+        return;
+    }
+    
+    // A full rebuild is already due, or will be when the widget is shown
+    if (m_trackLayerDirty || !isVisible() || m_trackLayer.size() != size() * devicePixelRatioF()) {
+        m_trackLayerDirty = true;
+        update();
+        return;
+    }
+    
+    const QVector<TrackItem> items = layoutTracks();
+    QRegion region;
+    for (const TrackItem& item : items) {
+        region += item.bounds;
+    }
+    QVector<QRect> clusterBounds;
+    for (const LabelCluster& cluster : m_declutter.clusters()) {
+        clusterBounds.append(clusterGlyphRect(cluster).toAlignedRect());
+        region += clusterBounds.last();
+    }
+    
+    // Tracks that moved off an area, or onto it, and what overlaps them
+    const QRegion dirty = region.united(m_trackRegion);
+    if (!dirty.isEmpty()) {
+        QPainter painter(&m_trackLayer);
+        painter.setClipRegion(dirty);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(dirty.boundingRect(), Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setFont(font());
+        for (const TrackItem& item : items) {
+            if (dirty.intersects(item.bounds)) {
+                drawTrack(painter, *item.track, item.pos);
+            }
+        }
+        for (int i = 0; i < clusterBounds.size(); ++i) {
+            if (dirty.intersects(clusterBounds[i])) {
+                drawLabelCluster(painter, m_declutter.clusters()[i]);
+            }
+        }
+    }
+    m_trackRegion = region;
+    
+    // The readout counts the tracks
+    update(dirty.united(scaleInfoRect()));
+}
+
+void PPIDisplayWidget::onTrackLayerReady() {
+    QRegion region;
+    if (!m_trackRenderer || !m_trackRenderer->takeFrame(m_trackLayer, region)) return;
+    
+    // Tracks that moved off an area, or onto it
+    update(region.united(m_trackRegion));
+    m_trackRegion = region;
+}
+
+QVector<PPIDisplayWidget::TrackItem> PPIDisplayWidget::layoutTracks() {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::layoutTracks");
+    // One projection for every trail point drawn this frame
+    m_trailToScreen = groundTransform(m_trailFrame.origin());
+    m_trailNowMs = QDateTime::currentMSecsSinceEpoch();
+    if (m_trackGL) {
+        m_trackGL->setTrailTransform(m_trailToScreen);
+        m_trackGL->setRadarVideoTransform(groundTransform(m_radarSite));
+        updateGLSweep();
+    }
+    
+    QVector<TrackItem> items;
+    if (!m_picture) {
+        m_pickIndex.clear(rect());
+        return items;
+    }
+    
+    const QPointF center = screenCenter();
+    const double radius = ppiRadius();
+    m_pickIndex.clear(rect());
+    
+    // Symbols are built before any item points at one
+    QSet<TrackHandle> collapsed;
+    collapseGroupSymbols(collapsed);
+    
+    auto place = [&](const TrackSnapshot& track) {
+        QPointF screenPos = center + geoToPPI(track.position);
+        
+        // Check if track is within display range
+        if (QLineF(center, screenPos).length() > radius) return;
+        
+        // Symbol with its selection and engagement rings, and the velocity
+        // vector of at most 30 px with its arrowhead
+        const double reach = 36.0;
+        QRectF bounds(screenPos.x() - reach, screenPos.y() - reach, reach * 2, reach * 2);
+        
+        if (m_showTrackHistory && !m_trackGL) {
+            auto it = m_trackHistory.constFind(track.handle);
+            if (it != m_trackHistory.constEnd()) {
+                const RingBuffer<TrackHistoryPoint>& history = it.value();
+                for (int i = 0; i < history.size(); ++i) {
+                    const QPointF pt = m_trailToScreen.map(history[i].position);
+                    bounds |= QRectF(pt.x() - 3, pt.y() - 3, 6, 6);
+                }
+            }
+        }
+        
+        items.append({&track, screenPos, bounds.toAlignedRect().adjusted(-2, -2, 2, 2)});
+        m_pickIndex.insert(track.handle, screenPos);
+    };
+    for (const TrackSnapshot& track : m_picture->tracks) {
+        if (track.state == TrackState::Dropped || collapsed.contains(track.handle)) continue;
+        place(track);
+    }
+    for (const TrackSnapshot& symbol : qAsConst(m_groupSymbols)) {
+        place(symbol);
+    }
+    m_pickIndex.build();
+    
+    // The labels and their leader lines, wherever the declutter puts them
+    declutterLabels(items);
+    return items;
+}
+
+QVector<TrackGlyph> PPIDisplayWidget::trackGlyphs(const QVector<TrackItem>& items) const {
+    QVector<TrackGlyph> glyphs;
+    const double rotationOffset = m_northUp ? 0.0 : -m_heading;
+    const double labelAscent = QFontMetricsF(trackLabelFont()).ascent();
+    glyphs.reserve(items.size() + m_declutter.clusters().size());
+    
+    // The symbology drawTrack() paints
+    for (const TrackItem& item : items) {
+        const TrackSnapshot& track = *item.track;
+        const QPointF screenPos = item.pos;
+        const bool selected = isSelected(track);
+        const QColor color = colorForClassification(track.classification);
+        
+        TrackGlyph glyph;
+        glyph.position = screenPos;
+        glyph.color = track.threatLevel >= 4 ? color.lighter(130) : color;
+        glyph.size = selected ? 14 : 10;
+        glyph.lineWidth = selected ? 3 : 2;
+        switch (track.classification) {
+            case TrackClassification::Hostile:
+                glyph.shape = TrackGlyphShape::Diamond;
+                glyph.filled = true;
+                break;
+            case TrackClassification::Friendly: glyph.shape = TrackGlyphShape::Circle; break;
+            case TrackClassification::Pending:
+                glyph.shape = TrackGlyphShape::Circle;
+                glyph.symbolText = QStringLiteral("?");
+                break;
+            default: glyph.shape = TrackGlyphShape::Square; break;
+        }
+        glyph.selected = selected;
+        glyph.engaged = track.engaged;
+        
+        double speed = track.velocity.speed();
+        if (speed >= 1.0) {
+            double angleRad = qDegreesToRadians(track.velocity.heading() + rotationOffset - 90.0);
+            double vectorLength = qMin(speed * 0.5, 30.0);
+            glyph.velocity = QPointF(cos(angleRad) * vectorLength, sin(angleRad) * vectorLength);
+        }
+        
+        const LabelPlacement label = m_declutter.placement(track.handle);
+        if (label.isVisible()) {
+            glyph.label = m_labels.value(track.handle).text;
+            glyph.labelOffset = label.rect.topLeft() - screenPos + QPointF(0.0, labelAscent);
+            glyph.labelColor = color.lighter(120);
+            if (label.leader) {
+                glyph.leader = LabelDeclutter::leaderLine(screenPos, label.rect,
+                                                          m_declutter.config().symbolRadius);
+            }
+        }
+        glyphs.append(glyph);
+    }
+    
+    // The count glyphs drawLabelCluster() paints
+    for (const LabelCluster& cluster : m_declutter.clusters()) {
+        const QRectF rect = clusterGlyphRect(cluster);
+        TrackGlyph glyph;
+        glyph.position = rect.center();
+        glyph.color = QColor(220, 220, 220);
+        glyph.shape = TrackGlyphShape::Circle;
+        glyph.size = float(rect.width() / 2.0);
+        glyph.lineWidth = 1.5f;
+        glyph.filled = true;
+        glyph.symbolText = QString::number(cluster.count);
+        glyphs.append(glyph);
+    }
+    return glyphs;
+}
+
+TrackLayerFrame PPIDisplayWidget::trackLayerFrame(const QVector<TrackItem>& items) const {
+    TrackLayerFrame frame;
+    frame.size = size();
+    frame.devicePixelRatio = devicePixelRatioF();
+    frame.labelFont = trackLabelFont();
+    frame.glyphs = trackGlyphs(items);
+    for (const TrackItem& item : items) {
+        frame.region += item.bounds;
+    }
+    for (const LabelCluster& cluster : m_declutter.clusters()) {
+        frame.region += clusterGlyphRect(cluster).toAlignedRect();
+    }
+    if (!m_showTrackHistory) return frame;
+    
+    // The trails drawTrackHistory() paints, projected and faded here
+    const double windowMs = m_trackHistorySeconds * 1000.0;
+    for (const TrackItem& item : items) {
+        auto it = m_trackHistory.constFind(item.track->handle);
+        if (it == m_trackHistory.constEnd() || it.value().size() < 2) continue;
+        
+        const RingBuffer<TrackHistoryPoint>& history = it.value();
+        TrackLayerTrail trail;
+        trail.color = colorForClassification(item.track->classification);
+        trail.points.reserve(history.size());
+        trail.intensity.reserve(history.size());
+        for (int i = 0; i < history.size(); ++i) {
+            trail.points.append(m_trailToScreen.map(history[i].position));
+            trail.intensity.append(float(qBound(0.0, 1.0 - (m_trailNowMs - history[i].timestamp) / windowMs, 1.0)));
+        }
+        frame.trails.append(trail);
+    }
+    return frame;
+}
+
+QRect PPIDisplayWidget::sweepBounds() {
+    if (m_sweepWedgeDirty) {
+        renderSweepWedge();
+    }
+    double rotationOffset = m_northUp ? 0.0 : -m_heading;
+    QTransform transform;
+    transform.translate(screenCenter().x(), screenCenter().y());
+    transform.rotate(m_sweepAngle + rotationOffset);
+    return transform.mapRect(m_sweepWedgeRect).toAlignedRect().adjusted(-1, -1, 1, 1);
 }
 
 void PPIDisplayWidget::mousePressEvent(QMouseEvent* event) {
@@ -538,12 +1242,26 @@ void PPIDisplayWidget::mousePressEvent(QMouseEvent* event) {
         return;
     }
 
+    if (event->button() == Qt::LeftButton &&
+        (event->modifiers() & (Qt::ShiftModifier | Qt::ControlModifier))) {
+        m_dragSelect = (event->modifiers() & Qt::ShiftModifier) ? DragSelect::Box : DragSelect::Lasso;
+        m_dragPath = QPolygonF{QPointF(event->pos())};
+        event->accept();
+        return;
+    }
+    
     if (event->button() == Qt::LeftButton) {
-        QString trackId = findTrackAtPoint(event->pos());
-        if (!trackId.isEmpty()) {
-            m_selectedTrackId = trackId;
-            emit trackSelected(trackId);
-            update();
+        if (const TrackSnapshot* track = trackAtPoint(event->pos())) {
+            if (isGroupSymbol(*track)) {
+                const QStringList members = groupMemberIds(*track);
+                selectTracks(members);
+                if (!members.isEmpty()) emit trackSelected(m_selectedTrackId);
+                return;
+            }
+            m_selectedTrackId = track->trackId;
+            m_selection.clear();
+            emit trackSelected(m_selectedTrackId);
+            refreshTracks();
         } else {
             // Convert to geo position
             QPointF ppiPos = event->pos() - screenCenter();
@@ -555,9 +1273,9 @@ void PPIDisplayWidget::mousePressEvent(QMouseEvent* event) {
 
 void PPIDisplayWidget::mouseDoubleClickEvent(QMouseEvent* event) {
     if (event->button() == Qt::LeftButton) {
-        QString trackId = findTrackAtPoint(event->pos());
-        if (!trackId.isEmpty()) {
-            emit trackDoubleClicked(trackId);
+        const TrackSnapshot* track = trackAtPoint(event->pos());
+        if (track && !isGroupSymbol(*track)) {
+            emit trackDoubleClicked(track->trackId);
         }
     }
 }
@@ -590,6 +1308,19 @@ void PPIDisplayWidget::mouseMoveEvent(QMouseEvent* event) {
         event->accept();
         return;
     }
+    if (m_dragSelect != DragSelect::None) {
+        const QRect before = dragBounds();
+        const QPointF pos = event->pos();
+        if (m_dragSelect == DragSelect::Box) {
+            const QPointF origin = m_dragPath.first();
+            m_dragPath = QPolygonF{origin, QPointF(pos.x(), origin.y()), pos, QPointF(origin.x(), pos.y())};
+        } else if (QLineF(m_dragPath.last(), pos).length() >= 3.0) {
+            m_dragPath.append(pos);
+        }
+        update(before.united(dragBounds()));
+        event->accept();
+        return;
+    }
     QWidget::mouseMoveEvent(event);
 }
 
@@ -606,12 +1337,71 @@ void PPIDisplayWidget::mouseReleaseEvent(QMouseEvent* event) {
         event->accept();
         return;
     }
+    if (m_dragSelect != DragSelect::None && event->button() == Qt::LeftButton) {
+        const QRect bounds = dragBounds();
+        selectDragged();
+        m_dragSelect = DragSelect::None;
+        m_dragPath.clear();
+        update(bounds);
+        event->accept();
+        return;
+    }
     QWidget::mouseReleaseEvent(event);
 }
 
+void PPIDisplayWidget::selectDragged() {
+    QVector<quint64> keys;
+    if (m_dragSelect == DragSelect::Box && m_dragPath.size() == 4) {
+        m_pickIndex.inRect(m_dragPath.boundingRect(), keys);
+    } else if (m_dragSelect == DragSelect::Lasso) {
+        m_pickIndex.inPolygon(m_dragPath, keys);
+    }
+    
+    m_selection.clear();
+    m_selectedTrackId.clear();
+    QStringList ids;
+    for (quint64 key : keys) {
+        if (TrackHandle(key) & GROUP_SYMBOL_BIT) {
+            // A collapsed group selects its members
+            const quint32 groupId = TrackHandle(key) & ~GROUP_SYMBOL_BIT;
+            const TrackGroup* group = m_picture ? m_picture->findGroup(groupId) : nullptr;
+            if (!group) continue;
+            for (TrackHandle member : group->members) {
+                if (const TrackSnapshot* track = m_picture->find(member)) {
+                    m_selection.insert(track->handle);
+                    ids.append(track->trackId);
+                }
+            }
+            continue;
+        }
+        const TrackSnapshot* track = m_picture ? m_picture->find(TrackHandle(key)) : nullptr;
+        if (!track) continue;
+        m_selection.insert(track->handle);
+        ids.append(track->trackId);
+    }
+    if (!ids.isEmpty()) {
+        m_selectedTrackId = ids.first();
+    }
+    refreshTracks();
+    
+    emit tracksSelected(ids);
+    if (!ids.isEmpty()) {
+        emit trackSelected(m_selectedTrackId);
+    }
+}
+
+QRect PPIDisplayWidget::dragBounds() const {
+    return m_dragPath.boundingRect().toAlignedRect().adjusted(-2, -2, 2, 2);
+}
+
 void PPIDisplayWidget::resizeEvent(QResizeEvent* event) {
     QWidget::resizeEvent(event);
     m_backgroundDirty = true;
+    m_sweepWedgeDirty = true;
+    m_trackLayerDirty = true;
+    if (m_trackGL) {
+        m_trackGL->setGeometry(rect());
+    }
     if (!m_localMap.isNull()) {
         double previousBase = m_localMapBaseScale;
         updateLocalMapBaseScale();
@@ -623,6 +1413,7 @@ void PPIDisplayWidget::resizeEvent(QResizeEvent* event) {
 }
 
 void PPIDisplayWidget::drawBackground(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawBackground");
     // Fill with background color
     painter.fillRect(rect(), m_backgroundColor);
     
@@ -649,6 +1440,7 @@ void PPIDisplayWidget::drawBackground(QPainter& painter) {
 }
 
 void PPIDisplayWidget::drawMapTiles(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawMapTiles");
     painter.setOpacity(m_mapOpacity);
 
     if (!m_localMap.isNull()) {
@@ -662,43 +1454,19 @@ void PPIDisplayWidget::drawMapTiles(QPainter& painter) {
         return;
     }
 
-    // Calculate visible tile range
-    QPointF center = screenCenter();
-    double radius = ppiRadius();
-    
-    // Get corner positions
-    double mPerPixel = m_rangeScaleM / radius;
-    
-    for (int dx = -2; dx <= 2; ++dx) {
-        for (int dy = -2; dy <= 2; ++dy) {
-            GeoPosition tileCenter;
-            tileCenter.latitude = m_center.latitude + (dy * 256 * mPerPixel / CoordinateUtils::DEG_TO_M_LAT);
-            tileCenter.longitude = m_center.longitude + (dx * 256 * mPerPixel / CoordinateUtils::degToMeterLon(m_center.latitude));
-            
-            MapTileKey key = geoToTile(tileCenter, m_mapZoomLevel);
-            
-            QPixmap* tile = m_tileCache.object(key);
-            if (tile) {
-                // Calculate tile screen position
-                double tileN = pow(2.0, m_mapZoomLevel);
-                double tileLatRad = atan(sinh(M_PI * (1 - 2 * key.y / tileN)));
-                double tileLat = qRadiansToDegrees(tileLatRad);
-                double tileLon = key.x / tileN * 360.0 - 180.0;
-                
-                GeoPosition tilePos;
-                tilePos.latitude = tileLat;
-                tilePos.longitude = tileLon;
-                tilePos.altitude = 0;
-                
-                QPointF screenPos = center + geoToPPI(tilePos);
-                
-                // Scale tile to match current view
-                double tileSize = 256.0 / mPerPixel * (CoordinateUtils::DEG_TO_M_LAT / pow(2.0, m_mapZoomLevel) * 360.0 / 256.0);
-                
-                painter.drawPixmap(QRectF(screenPos.x(), screenPos.y(), tileSize, tileSize), *tile, tile->rect());
-            } else if (!m_pendingTiles.contains(key)) {
-                requestMapTile(key.x, key.y, m_mapZoomLevel);
-            }
+    for (const MapTileKey& key : visibleTiles(m_mapZoomLevel, m_rangeScaleM)) {
+        const QRectF target = tileScreenRect(key);
+        if (QPixmap* tile = m_tileCache.object(key)) {
+            painter.drawPixmap(target, *tile, tile->rect());
+            continue;
+        }
+        
+        // Until it arrives, the quarter of the tile one zoom level out
+        const MapTileKey parent{key.x / 2, key.y / 2, key.zoom - 1};
+        if (QPixmap* tile = m_tileCache.object(parent)) {
+            const QSizeF half(tile->width() / 2.0, tile->height() / 2.0);
+            const QPointF corner((key.x % 2) * half.width(), (key.y % 2) * half.height());
+            painter.drawPixmap(target, *tile, QRectF(corner, half));
         }
     }
     
@@ -720,6 +1488,7 @@ void PPIDisplayWidget::drawLocalMap(QPainter& painter) {
 }
 
 void PPIDisplayWidget::drawRangeRings(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawRangeRings");
     QPointF center = screenCenter();
     double radius = ppiRadius();
     double ringSpacing = radius / m_rangeRingCount;
@@ -752,6 +1521,7 @@ void PPIDisplayWidget::drawRangeRings(QPainter& painter) {
 }
 
 void PPIDisplayWidget::drawAzimuthLines(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawAzimuthLines");
     QPointF center = screenCenter();
     double radius = ppiRadius();
     double angleStep = 360.0 / m_azimuthDivisions;
@@ -792,47 +1562,45 @@ void PPIDisplayWidget::drawAzimuthLines(QPainter& painter) {
 }
 
 void PPIDisplayWidget::drawSweep(QPainter& painter) {
-    QPointF center = screenCenter();
-    double radius = ppiRadius();
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawSweep");
+    if (m_sweepWedgeDirty) {
+        renderSweepWedge();
+    }
     
     double rotationOffset = m_northUp ? 0.0 : -m_heading;
-    double angleRad = qDegreesToRadians(m_sweepAngle + rotationOffset - 90.0);
     
-    double x = center.x() + cos(angleRad) * radius;
-    double y = center.y() + sin(angleRad) * radius;
-    
-    // Draw sweep line
-    painter.setPen(QPen(m_sweepColor, 2));
-    painter.drawLine(center, QPointF(x, y));
-    
-    // Draw bright tip
-    painter.setPen(QPen(m_sweepColor.lighter(150), 4));
-    painter.drawPoint(QPointF(x, y));
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.translate(screenCenter());
+    painter.rotate(m_sweepAngle + rotationOffset);
+    painter.drawPixmap(m_sweepWedgeRect.topLeft(), m_sweepWedge);
+    painter.restore();
 }
 
 void PPIDisplayWidget::drawSweepTrail(QPainter& painter) {
-    QPointF center = screenCenter();
-    double radius = ppiRadius();
-    double rotationOffset = m_northUp ? 0.0 : -m_heading;
-    
-    // Draw fade trail behind sweep
-    for (int i = 1; i < SWEEP_TRAIL_LENGTH; ++i) {
-        double trailAngle = m_sweepAngle - (i * 0.5);  // Trail behind sweep
-        double angleRad = qDegreesToRadians(trailAngle + rotationOffset - 90.0);
-        
-        double intensity = 1.0 - (static_cast<double>(i) / SWEEP_TRAIL_LENGTH);
-        QColor trailColor = m_sweepColor;
-        trailColor.setAlphaF(intensity * 0.3);
-        
-        double x = center.x() + cos(angleRad) * radius;
-        double y = center.y() + sin(angleRad) * radius;
-        
-        painter.setPen(QPen(trailColor, 1));
-        painter.drawLine(center, QPointF(x, y));
-    }
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawSweepTrail");
+    // Wedge coordinates: origin at the centre, sweep at bearing 0. Qt's
+    // angles run anticlockwise from 3 o'clock, so the sweep is at 90 and
+    // the trail fades from it anticlockwise.
+    const double radius = ppiRadius();
+    QColor head = m_sweepColor;
+    head.setAlphaF(m_sweepColor.alphaF() * 0.3);
+    QColor tail = m_sweepColor;
+    tail.setAlpha(0);
+    
+    QConicalGradient gradient(QPointF(0.0, 0.0), 90.0);
+    gradient.setColorAt(0.0, head);
+    gradient.setColorAt(SWEEP_TRAIL_SPAN_DEG / 360.0, tail);
+    gradient.setColorAt(1.0, tail);
+    
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(gradient);
+    painter.drawPie(QRectF(-radius, -radius, 2.0 * radius, 2.0 * radius), 90 * 16,
+                    static_cast<int>(SWEEP_TRAIL_SPAN_DEG * 16));
 }
 
 void PPIDisplayWidget::drawDefendedArea(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawDefendedArea");
     if (!m_showDefendedArea) return;
     
     QPointF center = screenCenter();
@@ -857,43 +1625,35 @@ void PPIDisplayWidget::drawDefendedArea(QPainter& painter) {
     painter.drawEllipse(center, detectionRadius, detectionRadius);
 }
 
-void PPIDisplayWidget::drawTracks(QPainter& painter) {
-    QPointF center = screenCenter();
+void PPIDisplayWidget::drawGeofences(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawGeofences");
+    // The paths are kept in metres; only the transform follows the view
+    m_geofences.draw(painter, groundTransform(m_geofences.frame().origin()));
+}
+
+void PPIDisplayWidget::drawTrack(QPainter& painter, const TrackSnapshot& track, const QPointF& pos) {
+    bool selected = isSelected(track);
     
-    for (auto it = m_tracks.begin(); it != m_tracks.end(); ++it) {
-        Track* track = it.value();
-        if (!track || track->state() == TrackState::Dropped) continue;
-        
-        QPointF ppiPos = geoToPPI(track->position());
-        QPointF screenPos = center + ppiPos;
-        
-        // Check if track is within display range
-        double distance = QLineF(center, screenPos).length();
-        if (distance > ppiRadius()) continue;
-        
-        bool selected = (it.key() == m_selectedTrackId);
-        
-        // Draw track history trail
-        if (m_showTrackHistory) {
-            drawTrackHistory(painter, track);
-        }
-        
-        // Draw velocity vector
-        drawVelocityVector(painter, track, screenPos);
-        
-        // Draw track symbol
-        drawTrackSymbol(painter, track, screenPos, selected);
-        
-        // Draw label
-        drawTrackLabel(painter, track, screenPos);
+    // Draw track history trail
+    if (m_showTrackHistory) {
+        drawTrackHistory(painter, track);
     }
+    
+    // Draw velocity vector
+    drawVelocityVector(painter, track, pos);
+    
+    // Draw track symbol
+    drawTrackSymbol(painter, track, pos, selected);
+    
+    // Draw label
+    drawTrackLabel(painter, track, pos);
 }
 
-void PPIDisplayWidget::drawTrackSymbol(QPainter& painter, Track* track, const QPointF& pos, bool selected) {
-    QColor color = colorForClassification(track->classification());
+void PPIDisplayWidget::drawTrackSymbol(QPainter& painter, const TrackSnapshot& track, const QPointF& pos, bool selected) {
+    QColor color = colorForClassification(track.classification);
     
     // Threat level affects intensity
-    if (track->threatLevel() >= 4) {
+    if (track.threatLevel >= 4) {
         color = color.lighter(130);
     }
     
@@ -904,7 +1664,7 @@ void PPIDisplayWidget::drawTrackSymbol(QPainter& painter, Track* track, const QP
     painter.setBrush(Qt::NoBrush);
     
     // Draw symbol based on classification
-    switch (track->classification()) {
+    switch (track.classification) {
         case TrackClassification::Hostile:
             // Filled diamond for hostile
             {
@@ -945,71 +1705,181 @@ void PPIDisplayWidget::drawTrackSymbol(QPainter& painter, Track* track, const QP
     }
     
     // Engagement indicator
-    if (track->isEngaged()) {
+    if (track.engaged) {
         painter.setPen(QPen(Qt::red, 2));
         painter.drawEllipse(pos, size + 8, size + 8);
     }
 }
 
-void PPIDisplayWidget::drawTrackHistory(QPainter& painter, Track* track) {
-    QString trackId = track->trackId();
-    if (!m_trackHistory.contains(trackId)) return;
+void PPIDisplayWidget::drawTrackHistory(QPainter& painter, const TrackSnapshot& track) {
+    auto it = m_trackHistory.constFind(track.handle);
+    if (it == m_trackHistory.constEnd()) return;
     
-    const QList<TrackHistoryPoint>& history = m_trackHistory[trackId];
+    const RingBuffer<TrackHistoryPoint>& history = it.value();
     if (history.size() < 2) return;
     
-    QColor color = colorForClassification(track->classification());
-    QPointF center = screenCenter();
+    QColor color = colorForClassification(track.classification);
+    const double windowMs = m_trackHistorySeconds * 1000.0;
+    auto intensity = [&](const TrackHistoryPoint& pt) {
+        return qBound(0.0, 1.0 - (m_trailNowMs - pt.timestamp) / windowMs, 1.0);
+    };
     
+    QPointF previous = m_trailToScreen.map(history[0].position);
     for (int i = 1; i < history.size(); ++i) {
-        const TrackHistoryPoint& pt1 = history[i - 1];
-        const TrackHistoryPoint& pt2 = history[i];
+        const QPointF current = m_trailToScreen.map(history[i].position);
         
         QColor lineColor = color;
-        lineColor.setAlphaF(pt1.intensity * 0.5);
+        lineColor.setAlphaF(intensity(history[i - 1]) * 0.5);
         
         painter.setPen(QPen(lineColor, 1));
-        painter.drawLine(center + pt1.position, center + pt2.position);
+        painter.drawLine(previous, current);
+        previous = current;
     }
     
     // Draw dots at history points
+    painter.setPen(Qt::NoPen);
     for (const TrackHistoryPoint& pt : history) {
         QColor dotColor = color;
-        dotColor.setAlphaF(pt.intensity * 0.7);
-        painter.setPen(Qt::NoPen);
+        dotColor.setAlphaF(intensity(pt) * 0.7);
         painter.setBrush(dotColor);
-        painter.drawEllipse(center + pt.position, 2, 2);
+        painter.drawEllipse(m_trailToScreen.map(pt.position), 2, 2);
+    }
+}
+
+QTransform PPIDisplayWidget::groundTransform(const GeoPosition& origin) const {
+    // Metres to screen pixels: shift to the display center, turn for
+    // heading-up, scale, and flip north to screen up. The shift between two
+    // nearby tangent planes is all that matters at display scale.
+    const EnuVector offset = m_frame.toEnu(origin);
+    const double scale = ppiRadius() / m_rangeScaleM;
+    const QPointF center = screenCenter();
+    
+    QTransform transform;
+    transform.translate(center.x(), center.y());
+    transform.scale(scale, -scale);
+    if (!m_northUp) {
+        transform.rotate(m_heading);
     }
+    transform.translate(offset.east, offset.north);
+    return transform;
+}
+
+void PPIDisplayWidget::updateGLSweep() {
+    if (!m_trackGL) return;
+    const bool visible = m_sweepMode != PPISweepMode::None && m_displayMode != PPIDisplayMode::MapOnly;
+    const double rotationOffset = m_northUp ? 0.0 : -m_heading;
+    m_trackGL->setSweep(screenCenter(), ppiRadius(), m_sweepAngle + rotationOffset,
+                        visible ? m_sweepColor : QColor(Qt::transparent));
+}
+
+void PPIDisplayWidget::drawTrackLabel(QPainter& painter, const TrackSnapshot& track, const QPointF& pos) {
+    const LabelPlacement placement = m_declutter.placement(track.handle);
+    auto label = m_labels.constFind(track.handle);
+    if (!placement.isVisible() || label == m_labels.constEnd()) return;
+    
+    QColor color = colorForClassification(track.classification).lighter(120);
+    
+    // Leader line back to a label pushed out of the crowd
+    if (placement.leader) {
+        QColor leaderColor = color;
+        leaderColor.setAlpha(160);
+        painter.setPen(QPen(leaderColor, 1));
+        painter.drawLine(LabelDeclutter::leaderLine(pos, placement.rect, m_declutter.config().symbolRadius));
+    }
+    
+    painter.setPen(color);
+    painter.setFont(trackLabelFont());
+    painter.drawStaticText(placement.rect.topLeft(), label->staticText);
+}
+
+void PPIDisplayWidget::drawLabelCluster(QPainter& painter, const LabelCluster& cluster) {
+    const QRectF rect = clusterGlyphRect(cluster);
+    const QColor color(220, 220, 220);
+    
+    painter.setPen(QPen(color, 1.5));
+    painter.setBrush(QColor(color.red(), color.green(), color.blue(), 100));
+    painter.drawEllipse(rect);
+    painter.setFont(trackLabelFont());
+    painter.drawText(rect, Qt::AlignCenter, QString::number(cluster.count));
 }
 
-void PPIDisplayWidget::drawTrackLabel(QPainter& painter, Track* track, const QPointF& pos) {
-    QColor color = colorForClassification(track->classification());
+void PPIDisplayWidget::declutterLabels(QVector<TrackItem>& items) {
+    QVector<LabelRequest> requests;
+    requests.reserve(items.size());
+    QHash<TrackHandle, TrackLabel> labels;
+    const QFont labelFont = trackLabelFont();
+    const double ascent = QFontMetricsF(labelFont).ascent();
     
-    QString label = track->trackId();
+    for (const TrackItem& item : items) {
+        const TrackSnapshot& track = *item.track;
+        
+        // Text layout is the expensive part of a label; redo it only when
+        // the text changes
+        TrackLabel label = m_labels.value(track.handle);
+        const QString text = trackLabelText(track);
+        if (label.text != text) {
+            label.text = text;
+            label.staticText = QStaticText(text);
+            label.staticText.setTextFormat(Qt::PlainText);
+            label.staticText.prepare(QTransform(), labelFont);
+        }
+        labels.insert(track.handle, label);
+        
+        LabelRequest request;
+        request.key = track.handle;
+        request.anchor = item.pos;
+        request.size = label.staticText.size();
+        request.offset = QPointF(15.0, 5.0 - ascent);
+        request.pinned = (track.trackId == m_selectedTrackId);
+        requests.append(request);
+    }
+    m_labels.swap(labels);
+    m_declutter.update(requests);
+    
+    for (TrackItem& item : items) {
+        const LabelPlacement placement = m_declutter.placement(item.track->handle);
+        if (placement.isVisible()) {
+            item.bounds |= placement.rect.toAlignedRect().adjusted(-2, -2, 2, 2);
+        }
+    }
+}
+
+QRectF PPIDisplayWidget::clusterGlyphRect(const LabelCluster& cluster) const {
+    // Above and right of the swarm, clear of its symbols
+    const QFontMetricsF metrics(trackLabelFont());
+    const double r = qMax(9.0, metrics.horizontalAdvance(QString::number(cluster.count)) / 2.0 + 4.0);
+    const QPointF centre(cluster.bounds.right() + m_declutter.config().symbolRadius + r,
+                         cluster.bounds.top() - m_declutter.config().symbolRadius - r);
+    return QRectF(centre.x() - r, centre.y() - r, r * 2, r * 2);
+}
+
+QFont PPIDisplayWidget::trackLabelFont() const {
+    QFont labelFont = font();
+    labelFont.setPointSize(8);
+    return labelFont;
+}
+
+QString PPIDisplayWidget::trackLabelText(const TrackSnapshot& track) const {
+    QString label = track.trackId;
     
     // Add speed if available
-    VelocityVector vel = track->velocity();
+    VelocityVector vel = track.velocity;
     double speed = vel.speed();
     if (speed > 1.0) {
         label += QString(" %1m/s").arg(speed, 0, 'f', 0);
     }
     
     // Add altitude
-    double alt = track->position().altitude;
+    double alt = track.position.altitude;
     if (alt > 0) {
         label += QString(" %1m").arg(alt, 0, 'f', 0);
     }
     
-    painter.setPen(color.lighter(120));
-    QFont font = painter.font();
-    font.setPointSize(8);
-    painter.setFont(font);
-    
-    painter.drawText(QPointF(pos.x() + 15, pos.y() + 5), label);
+    return label;
 }
 
-void PPIDisplayWidget::drawVelocityVector(QPainter& painter, Track* track, const QPointF& pos) {
-    VelocityVector vel = track->velocity();
+void PPIDisplayWidget::drawVelocityVector(QPainter& painter, const TrackSnapshot& track, const QPointF& pos) {
+    VelocityVector vel = track.velocity;
     double speed = vel.speed();
     
     if (speed < 1.0) return;
@@ -1024,7 +1894,7 @@ void PPIDisplayWidget::drawVelocityVector(QPainter& painter, Track* track, const
     double vx = cos(angleRad) * vectorLength;
     double vy = sin(angleRad) * vectorLength;
     
-    QColor color = colorForClassification(track->classification());
+    QColor color = colorForClassification(track.classification);
     painter.setPen(QPen(color, 2));
     painter.drawLine(pos, QPointF(pos.x() + vx, pos.y() + vy));
     
@@ -1046,6 +1916,7 @@ void PPIDisplayWidget::drawVelocityVector(QPainter& painter, Track* track, const
 }
 
 void PPIDisplayWidget::drawNorthIndicator(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawNorthIndicator");
     double rotationOffset = m_northUp ? 0.0 : -m_heading;
     double angleRad = qDegreesToRadians(rotationOffset - 90.0);  // North at top
     
@@ -1076,6 +1947,7 @@ void PPIDisplayWidget::drawNorthIndicator(QPainter& painter) {
 }
 
 void PPIDisplayWidget::drawCompassRose(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawCompassRose");
     // Draw small compass rose in corner
     QPointF roseCenter(width() - 50, height() - 50);
     double roseRadius = 30;
@@ -1118,6 +1990,7 @@ void PPIDisplayWidget::drawCompassRose(QPainter& painter) {
 }
 
 void PPIDisplayWidget::drawScaleInfo(QPainter& painter) {
+    CUAS_TRACE_SCOPE("ui", "PPIDisplayWidget::drawScaleInfo");
     // Draw info panel in bottom-left corner
     int padding = 10;
     int lineHeight = 16;
@@ -1149,9 +2022,11 @@ void PPIDisplayWidget::drawScaleInfo(QPainter& painter) {
     QString sweepStr = QString("Sweep: %1°").arg(static_cast<int>(m_sweepAngle));
     
     int trackCount = 0;
-    for (auto it = m_tracks.begin(); it != m_tracks.end(); ++it) {
-        if (it.value() && it.value()->state() != TrackState::Dropped) {
-            ++trackCount;
+    if (m_picture) {
+        for (const TrackSnapshot& track : m_picture->tracks) {
+            if (track.state != TrackState::Dropped) {
+                ++trackCount;
+            }
         }
     }
     QString trackStr = QString("Tracks: %1").arg(trackCount);
@@ -1159,6 +2034,7 @@ void PPIDisplayWidget::drawScaleInfo(QPainter& painter) {
     // Background for readability
     QRect infoBg(padding, height() - padding - lineHeight * 5, 180, lineHeight * 5);
     painter.fillRect(infoBg, QColor(0, 0, 0, 150));
+    painter.setClipRect(scaleInfoRect(), Qt::IntersectClip);
     
     int y = height() - padding - lineHeight * 4;
     painter.drawText(padding + 5, y, rangeStr);
@@ -1168,81 +2044,127 @@ void PPIDisplayWidget::drawScaleInfo(QPainter& painter) {
     painter.drawText(padding + 5, y + lineHeight * 4, trackStr);
 }
 
-void PPIDisplayWidget::requestMapTile(int x, int y, int zoom) {
-    MapTileKey key{x, y, zoom};
-    if (m_pendingTiles.contains(key)) return;
-    
-    m_pendingTiles.insert(key);
-    
-    QString url = getTileUrl(x, y, zoom);
-    QNetworkRequest request(url);
-    request.setAttribute(QNetworkRequest::User, QVariant::fromValue(key));
-    request.setHeader(QNetworkRequest::UserAgentHeader, "CounterUAS-C2/1.0");
-    
-    m_networkManager->get(request);
-}
-
-QString PPIDisplayWidget::getTileUrl(int x, int y, int zoom) const {
-    QString url = m_mapTileUrlTemplate;
-    url.replace("{x}", QString::number(x));
-    url.replace("{y}", QString::number(y));
-    url.replace("{z}", QString::number(zoom));
-    return url;
+QRect PPIDisplayWidget::scaleInfoRect() const {
+    // The panel, and the descenders of its last line below it
+    int padding = 10;
+    int lineHeight = 16;
+    return QRect(padding, height() - padding - lineHeight * 5, 180, lineHeight * 5 + padding);
 }
 
-MapTileKey PPIDisplayWidget::geoToTile(const GeoPosition& pos, int zoom) const {
-    double n = pow(2.0, zoom);
-    double latRad = qDegreesToRadians(pos.latitude);
-    
-    int x = static_cast<int>((pos.longitude + 180.0) / 360.0 * n);
-    int y = static_cast<int>((1.0 - asinh(tan(latRad)) / M_PI) / 2.0 * n);
+void PPIDisplayWidget::onMapTileLoaded(const MapTileKey& key, const QImage& image) {
+    m_tileCache.insert(key, new QPixmap(QPixmap::fromImage(image)), qMax(1, int(image.sizeInBytes() / 1024)));
+    m_tileAccount.set(qint64(m_tileCache.totalCost()) * 1024);
     
-    return {x, y, zoom};
+    // Drawn now, or standing in for a tile still on its way
+    if (key.zoom == m_mapZoomLevel || key.zoom == m_mapZoomLevel - 1) {
+        m_backgroundDirty = true;
+        update();
+    }
 }
 
-void PPIDisplayWidget::onMapTileReceived(QNetworkReply* reply) {
-    reply->deleteLater();
-    
-    QVariant keyVar = reply->request().attribute(QNetworkRequest::User);
-    MapTileKey key = keyVar.value<MapTileKey>();
-    m_pendingTiles.remove(key);
-    
-    if (reply->error() != QNetworkReply::NoError) {
-        return;
-    }
-    
-    QByteArray data = reply->readAll();
-    QPixmap* tile = new QPixmap();
-    if (tile->loadFromData(data)) {
-        m_tileCache.insert(key, tile);
-        update();
-    } else {
-        delete tile;
+QVector<MapTileKey> PPIDisplayWidget::visibleTiles(int zoom, double rangeM) const {
+    QVector<MapTileKey> keys;
+    if (zoom < 0) return keys;
+    
+    GeoPosition northWest = m_center;
+    northWest.latitude = qMin(85.0, m_center.latitude + rangeM / CoordinateUtils::DEG_TO_M_LAT);
+    northWest.longitude = m_center.longitude - rangeM / CoordinateUtils::degToMeterLon(m_center.latitude);
+    GeoPosition southEast = m_center;
+    southEast.latitude = qMax(-85.0, m_center.latitude - rangeM / CoordinateUtils::DEG_TO_M_LAT);
+    southEast.longitude = m_center.longitude + rangeM / CoordinateUtils::degToMeterLon(m_center.latitude);
+    
+    // A zoom level much finer than the range would want thousands of tiles;
+    // keep those nearest the centre
+    const int maxSide = 12;
+    const int tiles = 1 << zoom;
+    const MapTileKey centre = MapTileStore::tileAt(m_center, zoom);
+    const MapTileKey a = MapTileStore::tileAt(northWest, zoom);
+    const MapTileKey b = MapTileStore::tileAt(southEast, zoom);
+    const int x0 = qMax(qMax(0, a.x), centre.x - maxSide / 2);
+    const int x1 = qMin(qMin(tiles - 1, b.x), centre.x + maxSide / 2);
+    const int y0 = qMax(qMax(0, a.y), centre.y - maxSide / 2);
+    const int y1 = qMin(qMin(tiles - 1, b.y), centre.y + maxSide / 2);
+    
+    // Centre outwards, so the middle of the PPI fills first
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            keys.append({x, y, zoom});
+        }
     }
+    std::sort(keys.begin(), keys.end(), [&centre](const MapTileKey& l, const MapTileKey& r) {
+        return qMax(qAbs(l.x - centre.x), qAbs(l.y - centre.y)) < qMax(qAbs(r.x - centre.x), qAbs(r.y - centre.y));
+    });
+    return keys;
+}
+
+QRectF PPIDisplayWidget::tileScreenRect(const MapTileKey& key) const {
+    const QPointF center = screenCenter();
+    const QPointF topLeft = center + geoToPPI(MapTileStore::tileOrigin(key.x, key.y, key.zoom));
+    const QPointF bottomRight = center + geoToPPI(MapTileStore::tileOrigin(key.x + 1, key.y + 1, key.zoom));
+    return QRectF(topLeft, bottomRight).normalized();
 }
 
 void PPIDisplayWidget::updateVisibleTiles() {
-    if (m_displayMode != PPIDisplayMode::MapOverlay && 
-        m_displayMode != PPIDisplayMode::MapOnly) {
+    if ((m_displayMode != PPIDisplayMode::MapOverlay && m_displayMode != PPIDisplayMode::MapOnly) ||
+        !m_localMap.isNull() || m_mapTileUrlTemplate.isEmpty()) {
+        m_tileStore->setWanted({}, {});
         return;
     }
-
-    if (!m_localMap.isNull()) {
-        return;
+    
+    const int zoom = m_mapZoomLevel;
+    const QVector<MapTileKey> shown = visibleTiles(zoom, m_rangeScaleM);
+    QVector<MapTileKey> visible;
+    for (const MapTileKey& key : shown) {
+        if (!m_tileCache.contains(key)) visible.append(key);
     }
     
-    // Pre-fetch visible tiles
-    for (int dx = -2; dx <= 2; ++dx) {
-        for (int dy = -2; dy <= 2; ++dy) {
-            MapTileKey key = geoToTile(m_center, m_mapZoomLevel);
-            key.x += dx;
-            key.y += dy;
-            
-            if (!m_tileCache.contains(key) && !m_pendingTiles.contains(key)) {
-                requestMapTile(key.x, key.y, key.zoom);
+    QVector<MapTileKey> prefetch;
+    auto wantLater = [&](const MapTileKey& key) {
+        if (key.x >= 0 && key.y >= 0 && key.x < (1 << key.zoom) && key.y < (1 << key.zoom) &&
+            !m_tileCache.contains(key)) {
+            prefetch.append(key);
+        }
+    };
+    
+    // Two tiles deep on the sides the view is moving towards
+    const double n = std::pow(2.0, zoom);
+    const double latRad = qDegreesToRadians(m_center.latitude);
+    const QPointF tileCentre((m_center.longitude + 180.0) / 360.0 * n,
+                             (1.0 - std::asinh(std::tan(latRad)) / M_PI) / 2.0 * n);
+    const QPointF motion = m_lastTileZoom == zoom ? tileCentre - m_lastTileCentre : QPointF();
+    m_lastTileCentre = tileCentre;
+    m_lastTileZoom = zoom;
+    
+    if (!shown.isEmpty() && !motion.isNull()) {
+        int x0 = shown.first().x, x1 = x0, y0 = shown.first().y, y1 = y0;
+        for (const MapTileKey& key : shown) {
+            x0 = qMin(x0, key.x); x1 = qMax(x1, key.x);
+            y0 = qMin(y0, key.y); y1 = qMax(y1, key.y);
+        }
+        const int stepX = motion.x() > 0.01 ? 1 : motion.x() < -0.01 ? -1 : 0;
+        const int stepY = motion.y() > 0.01 ? 1 : motion.y() < -0.01 ? -1 : 0;
+        for (int i = 1; i <= 2; ++i) {
+            if (stepX != 0) {
+                const int x = stepX > 0 ? x1 + i : x0 - i;
+                for (int y = y0; y <= y1; ++y) wantLater({x, y, zoom});
+            }
+            if (stepY != 0) {
+                const int y = stepY > 0 ? y1 + i : y0 - i;
+                for (int x = x0; x <= x1; ++x) wantLater({x, y, zoom});
             }
         }
     }
+    
+    // A level out is a quarter as many tiles and stands in for missing
+    // ones; a level in covers the middle of the view
+    if (zoom > 1) {
+        for (const MapTileKey& key : visibleTiles(zoom - 1, m_rangeScaleM)) wantLater(key);
+    }
+    if (zoom < 19) {
+        for (const MapTileKey& key : visibleTiles(zoom + 1, m_rangeScaleM * 0.5)) wantLater(key);
+    }
+    
+    m_tileStore->setWanted(visible, prefetch);
 }
 
 void PPIDisplayWidget::updateLocalMapBaseScale() {
@@ -1265,34 +2187,38 @@ double PPIDisplayWidget::ppiRadius() const {
 }
 
 QPointF PPIDisplayWidget::geoToPPI(const GeoPosition& pos) const {
-    // Calculate distance and bearing from center
-    double distance = CoordinateUtils::haversineDistance(m_center, pos);
-    double bearing = CoordinateUtils::bearing(m_center, pos);
+    // Plan position in the center's tangent plane, turned for heading-up
+    const EnuVector enu = m_frame.toEnu(pos);
+    double east = enu.east;
+    double north = enu.north;
+    if (!m_northUp) {
+        const double rotationRad = qDegreesToRadians(-m_heading);
+        const double c = std::cos(rotationRad);
+        const double s = std::sin(rotationRad);
+        east = enu.east * c + enu.north * s;
+        north = enu.north * c - enu.east * s;
+    }
     
-    // Convert to PPI coordinates (polar to cartesian)
     double scale = ppiRadius() / m_rangeScaleM;
-    double ppiRange = distance * scale;
-    
-    double rotationOffset = m_northUp ? 0.0 : -m_heading;
-    double angleRad = qDegreesToRadians(bearing + rotationOffset - 90.0);  // -90 for top=north
-    
-    double x = ppiRange * cos(angleRad);
-    double y = ppiRange * sin(angleRad);
-    
-    return QPointF(x, y);
+    return QPointF(east * scale, -north * scale);  // Screen y grows downwards
 }
 
 GeoPosition PPIDisplayWidget::ppiToGeo(const QPointF& ppiPos) const {
-    double ppiRange = sqrt(ppiPos.x() * ppiPos.x() + ppiPos.y() * ppiPos.y());
-    double angleRad = atan2(ppiPos.y(), ppiPos.x());
-    
-    double rotationOffset = m_northUp ? 0.0 : -m_heading;
-    double bearing = qRadiansToDegrees(angleRad) + 90.0 - rotationOffset;  // +90 to convert back
-    
     double scale = ppiRadius() / m_rangeScaleM;
-    double distance = ppiRange / scale;
+    double east = ppiPos.x() / scale;
+    double north = -ppiPos.y() / scale;
+    if (!m_northUp) {
+        const double rotationRad = qDegreesToRadians(-m_heading);
+        const double c = std::cos(rotationRad);
+        const double s = std::sin(rotationRad);
+        const double screenEast = east;
+        east = screenEast * c - north * s;
+        north = screenEast * s + north * c;
+    }
     
-    return CoordinateUtils::positionFromBearingDistance(m_center, bearing, distance);
+    GeoPosition pos = m_frame.toGeo(EnuVector{east, north, 0.0});
+    pos.altitude = m_center.altitude;
+    return pos;
 }
 
 QPointF PPIDisplayWidget::polarToScreen(double rangeM, double azimuthDeg) const {
@@ -1329,23 +2255,77 @@ QColor PPIDisplayWidget::colorForThreatLevel(int level) const {
     }
 }
 
-QString PPIDisplayWidget::findTrackAtPoint(const QPointF& point) const {
-    QPointF center = screenCenter();
+const TrackSnapshot* PPIDisplayWidget::trackAtPoint(const QPointF& point) const {
+    quint64 key = 0;
+    if (!m_picture || !m_pickIndex.nearest(point, PICK_RADIUS_PX, &key)) return nullptr;
+    if (TrackHandle(key) & GROUP_SYMBOL_BIT) {
+        for (const TrackSnapshot& symbol : m_groupSymbols) {
+            if (symbol.handle == TrackHandle(key)) return &symbol;
+        }
+        return nullptr;
+    }
+    return m_picture->find(TrackHandle(key));
+}
+
+QStringList PPIDisplayWidget::groupMemberIds(const TrackSnapshot& symbol) const {
+    QStringList ids;
+    const TrackGroup* group = m_picture ? m_picture->findGroup(symbol.groupId) : nullptr;
+    if (!group) return ids;
+    for (TrackHandle member : group->members) {
+        if (const TrackSnapshot* track = m_picture->find(member)) ids.append(track->trackId);
+    }
+    return ids;
+}
+
+void PPIDisplayWidget::collapseGroupSymbols(QSet<TrackHandle>& collapsed) {
+    m_groupSymbols.clear();
+    if (!m_collapseGroups || !m_picture) return;
     
-    for (auto it = m_tracks.begin(); it != m_tracks.end(); ++it) {
-        Track* track = it.value();
-        if (!track || track->state() == TrackState::Dropped) continue;
+    // Most severe first, for the colour the symbol takes
+    auto severity = [](TrackClassification cls) {
+        switch (cls) {
+            case TrackClassification::Hostile: return 4;
+            case TrackClassification::Pending: return 3;
+            case TrackClassification::Unknown: return 2;
+            case TrackClassification::Neutral: return 1;
+            default: return 0;
+        }
+    };
+    const double pxPerM = ppiRadius() / m_rangeScaleM;
+    for (const TrackGroup& group : m_picture->groups) {
+        if (group.extentM * 2.0 * pxPerM >= GROUP_COLLAPSE_PX) continue;
         
-        QPointF ppiPos = geoToPPI(track->position());
-        QPointF screenPos = center + ppiPos;
+        TrackSnapshot symbol;
+        symbol.handle = GROUP_SYMBOL_BIT | group.groupId;
+        symbol.position = group.centroid;
+        symbol.velocity = group.velocity;
+        symbol.state = TrackState::Active;
+        symbol.classification = TrackClassification::Friendly;
+        symbol.threatLevel = 0;
+        symbol.groupId = group.groupId;
+        int members = 0;
+        for (TrackHandle handle : group.members) {
+            const TrackSnapshot* track = m_picture->find(handle);
+            if (!track || track->state == TrackState::Dropped) continue;
+            ++members;
+            if (severity(track->classification) > severity(symbol.classification)) {
+                symbol.classification = track->classification;
+            }
+            symbol.threatLevel = qMax(symbol.threatLevel, track->threatLevel);
+        }
+        if (members < 2) continue;
         
-        double distance = QLineF(point, screenPos).length();
-        if (distance < 15) {  // 15 pixel hit radius
-            return it.key();
+        symbol.groupSize = members;
+        symbol.trackId = QString("GRP-%1 (%2)").arg(group.groupId).arg(members);
+        for (TrackHandle handle : group.members) {
+            collapsed.insert(handle);
         }
+        m_groupSymbols.append(symbol);
     }
-    
-    return QString();
+}
+
+bool PPIDisplayWidget::isSelected(const TrackSnapshot& track) const {
+    return track.trackId == m_selectedTrackId || m_selection.contains(track.handle);
 }
 
 } // namespace CounterUAS
@@ -3,17 +3,35 @@
 
 #include <QWidget>
 #include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <QPainter>
 #include <QTimer>
 #include <QPixmap>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QImage>
+#include <QRegion>
+#include <QStaticText>
 #include <QCache>
 #include "core/Track.h"
+#include "core/TrackSnapshot.h"
+#include "ui/GeofenceOverlay.h"
+#include "ui/MapTileStore.h"
+#include "ui/TrackGLView.h"
+#include "ui/TrackLayerRenderer.h"
+#include "utils/LabelDeclutter.h"
+#include "utils/LocalTangentPlane.h"
+#include "utils/MemoryAccounting.h"
+#include "utils/RingBuffer.h"
+#include "utils/ScreenPickIndex.h"
+#include <memory>
 
 namespace CounterUAS {
 
+class RadarVideoRing;
+class RadarVideoSource;
 class TrackManager;
+class UIFrameScheduler;
+struct UIFrame;
 
 /**
  * @brief PPI Display modes
@@ -36,30 +54,16 @@ enum class PPISweepMode {
 
 /**
  * @brief Track history point for trail display
+ *
+ * Kept on the ground rather than on the screen, so a zoom, pan or heading
+ * change only alters how the trail is projected. Fading is worked out from
+ * the timestamp when the trail is drawn.
  */
 struct TrackHistoryPoint {
-    QPointF position;
+    QPointF position;   // East (x) and north (y) in metres, in the trail frame
     qint64 timestamp;
-    double intensity;   // For fading effect (0.0 - 1.0)
 };
 
-/**
- * @brief Map tile key for caching
- */
-struct MapTileKey {
-    int x;
-    int y;
-    int zoom;
-    
-    bool operator==(const MapTileKey& other) const {
-        return x == other.x && y == other.y && zoom == other.zoom;
-    }
-};
-
-inline size_t qHash(const MapTileKey& key, size_t seed = 0) {
-    return ::qHash(key.x, seed) ^ ::qHash(key.y, seed) ^ ::qHash(key.zoom, seed);
-}
-
 /**
  * @brief PPI (Plan Position Indicator) Display Widget
  * 
@@ -71,6 +75,26 @@ inline size_t qHash(const MapTileKey& key, size_t seed = 0) {
  * - Optional map tile overlay
  * - Track history trails
  * - Defended area visualization
+ * - Geofence outlines
+ *
+ * Painting composites three retained layers. The static layer (background,
+ * map, rings, azimuth lines, defended area, geofences, north indicator,
+ * compass) is
+ * rendered once per view change. The sweep and its trail are a wedge
+ * rendered once per radius and colour and drawn rotated, so a sweep step
+ * repaints only the area the wedge leaves and enters. Tracks have their own
+ * transparent layer, in which a new picture or selection repaints only the
+ * old and new extents of what is drawn. With the OpenGL track backend that
+ * layer is a TrackGLView over the widget instead, drawing every track's
+ * symbology in a few instanced draws. With the threaded backend the GUI
+ * thread only lays the tracks out and hit tests; a TrackLayerRenderer
+ * paints the layer from that layout on a worker, and the widget blits
+ * the newest finished one, so a heavy picture does not hold up input.
+ *
+ * Raw radar video (setRadarVideo()) is drawn only by the OpenGL backend,
+ * which scan-converts and fades it on the GPU together with the sweep's
+ * afterglow; the sweep then follows the antenna. The software backend
+ * shows no video.
  */
 class PPIDisplayWidget : public QWidget {
     Q_OBJECT
@@ -130,9 +154,28 @@ public:
     // Track manager connection
     void setTrackManager(TrackManager* manager);
     
-    // Track selection
+    // Sweep, trail fading and track pictures follow the scheduler's ticks
+    // rather than the widget's own timers
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+    
+    // Where track symbology is drawn; Auto takes OpenGL where supported
+    void setTrackRenderBackend(TrackRenderBackend backend);
+    TrackRenderBackend trackRenderBackend() const;
+    
+    // Raw video under the tracks, OpenGL backend only; nullptr detaches
+    void setRadarVideo(RadarVideoSource* source);
+    
+    // Track selection. Shift-drag selects the tracks in a box, Ctrl-drag
+    // those in a lasso; the first of them is also the selected track.
     void selectTrack(const QString& trackId);
     QString selectedTrack() const { return m_selectedTrackId; }
+    void selectTracks(const QStringList& trackIds);
+    QStringList selectedTracks() const;
+    
+    // Swarm groups drawn as one symbol while they span less than
+    // GROUP_COLLAPSE_PX; clicking it selects the members
+    void setCollapseGroups(bool collapse);
+    bool collapseGroups() const { return m_collapseGroups; }
     
     // Track history/trail
     void setShowTrackHistory(bool show);
@@ -143,12 +186,19 @@ public:
     void setDefendedAreaVisible(bool visible);
     void setDefendedAreaRadii(double criticalM, double warningM, double detectionM);
     
+    // Restricted zones, no-fly areas and corridors
+    void setGeofenceZones(const QList<GeofenceZone>& zones);
+    
     // Map tile configuration
     void setMapTileUrl(const QString& urlTemplate);
     void setMapZoomLevel(int zoom);
     int mapZoomLevel() const { return m_mapZoomLevel; }
     void setMapOpacity(double opacity);
     double mapOpacity() const { return m_mapOpacity; }
+    // Tiles persist on disk between sessions; site packs serve them offline
+    void setMapTileCacheDirectory(const QString& path);
+    void addMapTilePack(const QString& path);
+    MapTileStore* mapTileStore() const { return m_tileStore; }
 
     // Local map overlay (TIFF or other raster images)
     bool loadLocalMap(const QString& filePath);
@@ -181,6 +231,7 @@ public:
 public slots:
     void addTrack(const QString& trackId);
     void updateTrack(const QString& trackId);
+    void updateTracks(const QStringList& trackIds);
     void removeTrack(const QString& trackId);
     void clearTracks();
     
@@ -193,6 +244,7 @@ public slots:
     
 signals:
     void trackSelected(const QString& trackId);
+    void tracksSelected(const QStringList& trackIds);
     void trackDoubleClicked(const QString& trackId);
     void mapClicked(const GeoPosition& pos);
     void rangeScaleChanged(double rangeM);
@@ -201,6 +253,7 @@ signals:
     void displayModeChanged(PPIDisplayMode mode);
     
 protected:
+    bool event(QEvent* event) override;
     void paintEvent(QPaintEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseDoubleClickEvent(QMouseEvent* event) override;
@@ -211,10 +264,18 @@ protected:
     
 private slots:
     void updateSweep();
-    void onMapTileReceived(QNetworkReply* reply);
+    void onMapTileLoaded(const MapTileKey& key, const QImage& image);
     void updateTrackHistory();
+    int trailCapacity() const;
+    void onSnapshotPublished();
+    void onTrackLayerReady();
     
 private:
+    void advanceFrame(const UIFrame& frame);
+    void updateFrameTriggers();
+    void advanceSweep(double seconds);
+    void applyPicture(TrackPicturePtr picture);
+    
     // Rendering methods
     void drawBackground(QPainter& painter);
     void drawMapTiles(QPainter& painter);
@@ -224,20 +285,49 @@ private:
     void drawSweep(QPainter& painter);
     void drawSweepTrail(QPainter& painter);
     void drawDefendedArea(QPainter& painter);
-    void drawTracks(QPainter& painter);
-    void drawTrackSymbol(QPainter& painter, Track* track, const QPointF& pos, bool selected);
-    void drawTrackHistory(QPainter& painter, Track* track);
-    void drawTrackLabel(QPainter& painter, Track* track, const QPointF& pos);
-    void drawVelocityVector(QPainter& painter, Track* track, const QPointF& pos);
+    void drawGeofences(QPainter& painter);
+    void drawTrack(QPainter& painter, const TrackSnapshot& track, const QPointF& pos);
+    void drawTrackSymbol(QPainter& painter, const TrackSnapshot& track, const QPointF& pos, bool selected);
+    void drawTrackHistory(QPainter& painter, const TrackSnapshot& track);
+    // Metres east/north of origin to screen pixels
+    QTransform groundTransform(const GeoPosition& origin) const;
+    void updateGLSweep();
+    void drawTrackLabel(QPainter& painter, const TrackSnapshot& track, const QPointF& pos);
+    void drawLabelCluster(QPainter& painter, const LabelCluster& cluster);
+    void drawVelocityVector(QPainter& painter, const TrackSnapshot& track, const QPointF& pos);
     void drawNorthIndicator(QPainter& painter);
     void drawScaleInfo(QPainter& painter);
     void drawCompassRose(QPainter& painter);
     
+    // Layers
+    struct TrackItem {
+        const TrackSnapshot* track;
+        QPointF pos;
+        QRect bounds;       // Everything drawTrack() paints for it
+    };
+    void renderStaticLayer();
+    void renderSweepWedge();
+    void renderTrackLayer();
+    // Repaints the tracks' changed extents in the track layer
+    void refreshTracks();
+    // Tracks in range, with their labels placed
+    QVector<TrackItem> layoutTracks();
+    void declutterLabels(QVector<TrackItem>& items);
+    QVector<TrackGlyph> trackGlyphs(const QVector<TrackItem>& items) const;
+    TrackLayerFrame trackLayerFrame(const QVector<TrackItem>& items) const;
+    void loadTrails();
+    QString trackLabelText(const TrackSnapshot& track) const;
+    QFont trackLabelFont() const;
+    QRectF clusterGlyphRect(const LabelCluster& cluster) const;
+    QRect sweepBounds();
+    QRect scaleInfoRect() const;
+    
     // Map tile methods
-    void requestMapTile(int x, int y, int zoom);
-    QString getTileUrl(int x, int y, int zoom) const;
-    MapTileKey geoToTile(const GeoPosition& pos, int zoom) const;
-    QPointF tileToPixel(int tileX, int tileY, int zoom, const GeoPosition& topLeft) const;
+    // Covering the square around the PPI circle of radius rangeM
+    QVector<MapTileKey> visibleTiles(int zoom, double rangeM) const;
+    QRectF tileScreenRect(const MapTileKey& key) const;
+    // Asks for the visible tiles, and prefetches the next zoom levels and
+    // the tiles ahead of a pan
     void updateVisibleTiles();
     void updateLocalMapBaseScale();
     
@@ -246,15 +336,26 @@ private:
     double ppiRadius() const;
     QColor colorForClassification(TrackClassification cls) const;
     QColor colorForThreatLevel(int level) const;
-    QString findTrackAtPoint(const QPointF& point) const;
+    // From the symbols as last laid out
+    const TrackSnapshot* trackAtPoint(const QPointF& point) const;
+    // Group symbols stand in for their members with a handle of their own
+    static bool isGroupSymbol(const TrackSnapshot& track) { return track.handle & GROUP_SYMBOL_BIT; }
+    QStringList groupMemberIds(const TrackSnapshot& symbol) const;
+    // Collapsed groups into m_groupSymbols; their members into collapsed
+    void collapseGroupSymbols(QSet<TrackHandle>& collapsed);
+    bool isSelected(const TrackSnapshot& track) const;
+    void selectDragged();
+    QRect dragBounds() const;
     
     // Track manager
     TrackManager* m_trackManager = nullptr;
-    QHash<QString, Track*> m_tracks;
-    QHash<QString, QList<TrackHistoryPoint>> m_trackHistory;
+    TrackPicturePtr m_picture;  // Latest published track picture (never holds Track*)
+    qint64 m_latencyIngestNs = 0;  // Newest plot already counted in PipelineLatency
+    QHash<TrackHandle, RingBuffer<TrackHistoryPoint>> m_trackHistory;
     
     // Center position
     GeoPosition m_center;
+    LocalTangentPlane m_frame;  // Anchored at m_center, so geoToPPI is a rotation and scale
     
     // Display settings
     PPIDisplayMode m_displayMode = PPIDisplayMode::RadarOnly;
@@ -281,25 +382,41 @@ private:
     
     // Track selection
     QString m_selectedTrackId;
+    QSet<TrackHandle> m_selection;    // Box or lasso selected, with m_selectedTrackId
+    enum class DragSelect { None, Box, Lasso };
+    DragSelect m_dragSelect = DragSelect::None;
+    QPolygonF m_dragPath;             // Box corners or lasso points, widget coordinates
+    ScreenPickIndex m_pickIndex;      // Symbol positions of the last layout
+    bool m_collapseGroups = false;
+    QVector<TrackSnapshot> m_groupSymbols;  // Collapsed groups of the last layout
     
     // Track history
     bool m_showTrackHistory = true;
     int m_trackHistorySeconds = 30;
+    LocalTangentPlane m_trailFrame;   // Where history is kept; re-anchored only while it is empty
+    QTransform m_trailToScreen;       // groundTransform() of the trail frame as of the last layout
+    qint64 m_trailNowMs = 0;          // Fade reference as of the last layout
     QTimer* m_historyTimer;
+    UIFrameScheduler* m_frameScheduler = nullptr;
+    double m_sinceHistoryS = 0.0;     // Frame time since old history was last expired
     
     // Defended area
     bool m_showDefendedArea = true;
     double m_criticalRadiusM = 500.0;
     double m_warningRadiusM = 1500.0;
     double m_detectionRadiusM = 5000.0;
+    GeofenceOverlay m_geofences;
     
     // Map tiles
     QString m_mapTileUrlTemplate;
     int m_mapZoomLevel = 14;
     double m_mapOpacity = 0.5;
-    QNetworkAccessManager* m_networkManager;
-    QCache<MapTileKey, QPixmap> m_tileCache;
-    QSet<MapTileKey> m_pendingTiles;
+    MapTileStore* m_tileStore;
+    QCache<MapTileKey, QPixmap> m_tileCache;    // Cost in KiB
+    MemoryAccount m_tileAccount{MemoryTag::UiCaches};
+    quint64 m_memoryConsumer = 0;   // MemoryGovernor id for the tile cache
+    QPointF m_lastTileCentre;       // Fractional tile coordinates at m_lastTileZoom
+    int m_lastTileZoom = -1;
 
     // Local map overlay
     QPixmap m_localMap;
@@ -321,17 +438,37 @@ private:
     QColor m_neutralColor = Qt::gray;
     
     // Pre-rendered elements
-    QPixmap m_backgroundCache;
+    QPixmap m_backgroundCache;      // Static layer
     bool m_backgroundDirty = true;
-    
-    // Sweep trail (persistence effect)
-    static constexpr int SWEEP_TRAIL_LENGTH = 60;
-    QVector<double> m_sweepTrail;
+    QPixmap m_sweepWedge;           // Sweep at bearing 0, origin at the PPI centre
+    QRectF m_sweepWedgeRect;        // Its extent about the centre
+    bool m_sweepWedgeDirty = true;
+    QRect m_sweepBounds;            // Last painted, widget coordinates
+    QImage m_trackLayer;
+    QRegion m_trackRegion;          // What the track layer holds
+    bool m_trackLayerDirty = true;
+    TrackGLView* m_trackGL = nullptr;  // Replaces m_trackLayer when set
+    TrackLayerRenderer* m_trackRenderer = nullptr;  // Paints m_trackLayer off the GUI thread when set
+    std::shared_ptr<RadarVideoRing> m_radarVideo;
+    GeoPosition m_radarSite;
+    
+    // Track labels
+    struct TrackLabel {
+        QString text;
+        QStaticText staticText;     // Laid out again only when the text changes
+    };
+    QHash<TrackHandle, TrackLabel> m_labels;
+    LabelDeclutter m_declutter;
+    
+    static constexpr double PICK_RADIUS_PX = 15.0;
+    static constexpr double GROUP_COLLAPSE_PX = 48.0;     // Groups narrower than this draw as one symbol
+    static constexpr TrackHandle GROUP_SYMBOL_BIT = 0x80000000u;  // Above any track handle
+    static constexpr double SWEEP_TRAIL_SPAN_DEG = 30.0;  // Afterglow behind the sweep
+    static constexpr qint64 VIDEO_SWEEP_TIMEOUT_MS = 2000;  // Sweep follows video this fresh
 };
 
 } // namespace CounterUAS
 
-Q_DECLARE_METATYPE(CounterUAS::MapTileKey)
 Q_DECLARE_METATYPE(CounterUAS::PPIDisplayMode)
 Q_DECLARE_METATYPE(CounterUAS::PPISweepMode)
 
@@ -1,8 +1,11 @@
 #include "ui/SensorStatusPanel.h"
 #include "simulators/SensorSimulator.h"
+#include "ui/UIFrameScheduler.h"
 #include <QVBoxLayout>
 #include <QHeaderView>
 #include <QLabel>
+#include <algorithm>
+#include <iterator>
 
 namespace CounterUAS {
 
@@ -43,7 +46,9 @@ void SensorStatusPanel::setSensorSimulator(SensorSimulator* simulator) {
     m_simulator = simulator;
     
     if (m_simulator) {
-        m_refreshTimer->start(500);  // Refresh every 500ms
+        if (!m_frameScheduler) {
+            m_refreshTimer->start(500);  // Refresh every 500ms
+        }
         
         // Connect to simulator signals
         connect(m_simulator, &SensorSimulator::radarStateChanged, this, [this](const QString& id, const RadarSimState& state) {
@@ -81,6 +86,21 @@ void SensorStatusPanel::setSensorSimulator(SensorSimulator* simulator) {
     }
 }
 
+void SensorStatusPanel::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+    
+    if (m_frameScheduler) {
+        m_refreshTimer->stop();
+        m_frameScheduler->addClient(this, 2, [this](const UIFrame& frame) { onFrame(frame); });
+        m_frameScheduler->setClientTriggers(this, FrameOnStatus, StatusBoard::kindBit(StatusKind::Sensor));
+    } else if (m_simulator || !m_sensorRows.isEmpty()) {
+        m_refreshTimer->start(500);
+    }
+}
+
 void SensorStatusPanel::addSensor(const QString& id, const QString& name, const QString& type) {
     if (m_sensorRows.contains(id)) {
         return;  // Sensor already exists
@@ -106,6 +126,14 @@ void SensorStatusPanel::addSensor(const QString& id, const QString& name, const
     m_table->setItem(row, 4, detectionsItem);
     
     m_sensorRows[id] = row;
+    // A live sensor may have published before its row existed
+    if (StatusSnapshotPtr status = StatusBoard::instance().snapshot(id, StatusKind::Sensor)) {
+        applyStatus({status}, 0);
+    }
+    
+    if (!m_refreshTimer->isActive() && !m_frameScheduler) {
+        m_refreshTimer->start(500);
+    }
 }
 
 void SensorStatusPanel::removeSensor(const QString& id) {
@@ -145,8 +173,75 @@ void SensorStatusPanel::clearSensors() {
 }
 
 void SensorStatusPanel::refreshStatus() {
-    // This is called periodically to update any manual updates
-    // The main updates come from simulator signals
+    // Without a scheduler: what the board has had since the last refresh
+    const StatusBoard& board = StatusBoard::instance();
+    const quint64 version = board.version();
+    if (version == m_statusSeen) return;
+    applyStatus(board.changedSince(m_statusSeen, StatusBoard::kindBit(StatusKind::Sensor)), m_statusSeen);
+    m_statusSeen = version;
+}
+
+void SensorStatusPanel::onFrame(const UIFrame& frame) {
+    applyStatus(frame.status, frame.statusSince);
+}
+
+void SensorStatusPanel::applyStatus(const QVector<StatusSnapshotPtr>& changed, quint64 sinceVersion) {
+    // Simulated sensors publish nothing and keep the simulator's values
+    for (const StatusSnapshotPtr& status : changed) {
+        const int row = m_sensorRows.value(status->source, -1);
+        if (row < 0 || row >= m_table->rowCount() || status->removed) continue;
+        const auto changedField = [&](const char* field) { return status->changed(field, sinceVersion); };
+        
+        QTableWidgetItem* statusItem = m_table->item(row, 2);
+        if (statusItem && changedField("status")) {
+            const QString text = status->value("status").toString();
+            statusItem->setText(text);
+            statusItem->setForeground(statusToColor(text));
+        }
+        
+        QTableWidgetItem* signalItem = m_table->item(row, 3);
+        if (signalItem && changedField("signalQuality")) {
+            const double quality = status->value("signalQuality").toDouble();
+            signalItem->setText(QString("%1%").arg(static_cast<int>(quality * 100)));
+            signalItem->setForeground(healthToColor(quality));
+        }
+        
+        QTableWidgetItem* detectionsItem = m_table->item(row, 4);
+        if (detectionsItem && changedField("detections")) {
+            detectionsItem->setText(status->value("detections").toString());
+        }
+        static const char* const telemetryFields[] = {
+            "messagesPerSec", "kBytesPerSec", "dropped", "parseP50Us", "parseP99Us",
+            "queueDepth", "latencyMeanUs", "latencyMaxUs"
+        };
+        if (detectionsItem && std::any_of(std::begin(telemetryFields), std::end(telemetryFields), changedField)) {
+            detectionsItem->setToolTip(QString("%1 msg/s, %2 kB/s, %3 dropped\n"
+                                               "Parse p50 %4 us, p99 %5 us, %6 B queued\n"
+                                               "Detection to track %7 us mean, %8 us max")
+                                           .arg(status->value("messagesPerSec").toDouble(), 0, 'f', 1)
+                                           .arg(status->value("kBytesPerSec").toDouble(), 0, 'f', 1)
+                                           .arg(status->value("dropped").toULongLong())
+                                           .arg(status->value("parseP50Us").toLongLong())
+                                           .arg(status->value("parseP99Us").toLongLong())
+                                           .arg(status->value("queueDepth").toInt())
+                                           .arg(status->value("latencyMeanUs").toInt())
+                                           .arg(status->value("latencyMaxUs").toLongLong()));
+        }
+        
+        static const char* const clockFields[] = {
+            "clockState", "clockExchanges", "clockOffsetMs", "clockDriftPpm", "clockJitterMs", "clockSteps"
+        };
+        if (statusItem && std::any_of(std::begin(clockFields), std::end(clockFields), changedField)) {
+            statusItem->setToolTip(QString("Clock %1 from %2\n"
+                                           "Offset %3 ms, drift %4 ppm, jitter %5 ms, %6 steps")
+                                       .arg(status->value("clockState").toString())
+                                       .arg(status->value("clockExchanges").toBool() ? "exchanges" : "receive times")
+                                       .arg(status->value("clockOffsetMs").toDouble(), 0, 'f', 1)
+                                       .arg(status->value("clockDriftPpm").toDouble(), 0, 'f', 1)
+                                       .arg(status->value("clockJitterMs").toDouble(), 0, 'f', 1)
+                                       .arg(status->value("clockSteps").toULongLong()));
+        }
+    }
 }
 
 void SensorStatusPanel::onTableItemClicked(int row, int column) {
@@ -6,13 +6,20 @@
 #include <QTimer>
 #include <QHash>
 #include "sensors/SensorInterface.h"
+#include "utils/StatusBoard.h"
 
 namespace CounterUAS {
 
 class SensorSimulator;
+class UIFrameScheduler;
+struct UIFrame;
 
 /**
  * @brief Panel showing real-time sensor status
+ *
+ * Live sensors publish their status to the StatusBoard; the panel takes
+ * what changed in its frames and rewrites only the cells whose fields
+ * moved. Simulated sensors are updated from the simulator's signals.
  */
 class SensorStatusPanel : public QWidget {
     Q_OBJECT
@@ -22,6 +29,9 @@ public:
     
     void setSensorSimulator(SensorSimulator* simulator);
     
+    // Takes status in the scheduler's frames instead of on the panel's own timer
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+    
     void addSensor(const QString& id, const QString& name, const QString& type);
     void removeSensor(const QString& id);
     void updateSensorStatus(const QString& id, const QString& status);
@@ -40,12 +50,16 @@ private slots:
     
 private:
     void setupUI();
+    void onFrame(const UIFrame& frame);
+    void applyStatus(const QVector<StatusSnapshotPtr>& changed, quint64 sinceVersion);
     QColor statusToColor(const QString& status);
     QColor healthToColor(double signalQuality);
     
     QTableWidget* m_table;
     SensorSimulator* m_simulator = nullptr;
     QTimer* m_refreshTimer;
+    UIFrameScheduler* m_frameScheduler = nullptr;
+    quint64 m_statusSeen = 0;          // Board version refreshStatus() last read
     
     QHash<QString, int> m_sensorRows;  // sensorId -> row index
 };
@@ -1,4 +1,5 @@
 #include "ui/TrackDetailPanel.h"
+#include "ui/UIFrameScheduler.h"
 #include <QVBoxLayout>
 #include <QFormLayout>
 #include <QPushButton>
@@ -30,10 +31,10 @@ TrackDetailPanel::TrackDetailPanel(QWidget* parent) : QWidget(parent) {
     QPushButton* slewBtn = new QPushButton("Slew Camera");
     
     connect(engageBtn, &QPushButton::clicked, this, [this]() {
-        if (m_track) emit engageRequested(m_track->trackId());
+        if (Track* track = currentTrack()) emit engageRequested(track->trackId());
     });
     connect(slewBtn, &QPushButton::clicked, this, [this]() {
-        if (m_track) emit slewCameraRequested(m_track->trackId());
+        if (Track* track = currentTrack()) emit slewCameraRequested(track->trackId());
     });
     
     mainLayout->addWidget(engageBtn);
@@ -42,16 +43,42 @@ TrackDetailPanel::TrackDetailPanel(QWidget* parent) : QWidget(parent) {
 }
 
 void TrackDetailPanel::setTrack(Track* track) {
+    if (m_track) {
+        disconnect(m_track, nullptr, this, nullptr);
+    }
     m_track = track;
+    m_generation = track ? track->generation() : 0;
+    m_handle = track ? track->handle() : INVALID_TRACK_HANDLE;
     updateDisplay();
     
-    if (track) {
+    if (track && !m_frameScheduler) {
         connect(track, &Track::updated, this, &TrackDetailPanel::updateDisplay);
     }
 }
 
+void TrackDetailPanel::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+    if (m_track) {
+        disconnect(m_track, nullptr, this, nullptr);
+        if (!m_frameScheduler && currentTrack()) {
+            connect(m_track, &Track::updated, this, &TrackDetailPanel::updateDisplay);
+        }
+    }
+    if (m_frameScheduler) {
+        m_frameScheduler->addClient(this, 10, [this](const UIFrame& frame) { onFrame(frame); });
+        m_frameScheduler->setClientTriggers(this, FrameOnTracks);
+    }
+}
+
 void TrackDetailPanel::clear() {
+    if (m_track) {
+        disconnect(m_track, nullptr, this, nullptr);
+    }
     m_track = nullptr;
+    m_handle = INVALID_TRACK_HANDLE;
     m_idLabel->setText("-");
     m_classLabel->setText("-");
     m_posLabel->setText("-");
@@ -61,24 +88,41 @@ void TrackDetailPanel::clear() {
 }
 
 void TrackDetailPanel::updateDisplay() {
-    if (!m_track) return;
-    
-    m_idLabel->setText(m_track->trackId());
-    m_classLabel->setText(m_track->classificationString());
+    if (Track* track = currentTrack()) {
+        showSnapshot(TrackSnapshot::fromTrack(*track));
+    }
+}
+
+Track* TrackDetailPanel::currentTrack() const {
+    return m_track && m_track->generation() == m_generation ? m_track : nullptr;
+}
+
+void TrackDetailPanel::onFrame(const UIFrame& frame) {
+    // Only the shown track's own changes cost a relabel
+    if (m_handle == INVALID_TRACK_HANDLE || !frame.picture) return;
+    if (frame.changes.fieldsFor(m_handle) == TrackChangeNone) return;
+    if (const TrackSnapshot* track = frame.picture->find(m_handle)) {
+        showSnapshot(*track);
+    }
+}
+
+void TrackDetailPanel::showSnapshot(const TrackSnapshot& track) {
+    m_idLabel->setText(track.trackId);
+    m_classLabel->setText(Track::classificationToString(track.classification));
     
-    GeoPosition pos = m_track->position();
+    const GeoPosition& pos = track.position;
     m_posLabel->setText(QString("%1, %2, %3m")
                            .arg(pos.latitude, 0, 'f', 5)
                            .arg(pos.longitude, 0, 'f', 5)
                            .arg(pos.altitude, 0, 'f', 1));
     
-    VelocityVector vel = m_track->velocity();
+    const VelocityVector& vel = track.velocity;
     m_velLabel->setText(QString("%1 m/s @ %2°")
                            .arg(vel.speed(), 0, 'f', 1)
                            .arg(vel.heading(), 0, 'f', 0));
     
-    m_threatLabel->setText(QString::number(m_track->threatLevel()));
-    m_stateLabel->setText(m_track->stateString());
+    m_threatLabel->setText(QString::number(track.threatLevel));
+    m_stateLabel->setText(Track::stateToString(track.state));
 }
 
 } // namespace CounterUAS
@@ -4,9 +4,13 @@
 #include <QWidget>
 #include <QLabel>
 #include "core/Track.h"
+#include "core/TrackSnapshot.h"
 
 namespace CounterUAS {
 
+class UIFrameScheduler;
+struct UIFrame;
+
 class TrackDetailPanel : public QWidget {
     Q_OBJECT
     
@@ -15,14 +19,24 @@ public:
     void setTrack(Track* track);
     void clear();
     
+    // Refreshes from the scheduler's pictures instead of on every update
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+    
 signals:
     void engageRequested(const QString& trackId);
     void slewCameraRequested(const QString& trackId);
     
 private:
     void updateDisplay();
+    void onFrame(const UIFrame& frame);
+    void showSnapshot(const TrackSnapshot& track);
+    // The shown track, or null once its object was recycled for another
+    Track* currentTrack() const;
     
     Track* m_track = nullptr;
+    quint32 m_generation = 0;          // m_track's when it was set
+    TrackHandle m_handle = INVALID_TRACK_HANDLE;
+    UIFrameScheduler* m_frameScheduler = nullptr;
     QLabel* m_idLabel;
     QLabel* m_classLabel;
     QLabel* m_posLabel;
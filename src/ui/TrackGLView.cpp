@@ -0,0 +1,969 @@
+#include "ui/TrackGLView.h"
+#include <QDateTime>
+#include <QFontMetricsF>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QPainter>
+#include <QVector2D>
+#include <QtMath>
+#include <cmath>
+
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_PROGRAM_POINT_SIZE
+#define GL_PROGRAM_POINT_SIZE 0x8642
+#endif
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_R32F
+#define GL_R32F 0x822E
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+TrackRenderBackend s_defaultBackend = TrackRenderBackend::Auto;
+
+constexpr int PALETTE_WIDTH = 256;          // Slots per palette row
+constexpr int ATLAS_WIDTH = 256;            // Logical pixels
+constexpr int MIN_TRAIL_CAPACITY = 4096;    // Vertices
+constexpr float SWEEP_TRAIL_SPAN = float(M_PI / 6.0);  // Afterglow behind the sweep, radians
+constexpr float NEVER_WRITTEN = -1.0e6f;    // Row time of video the antenna has not swept yet
+
+const GLfloat QUAD[] = {
+    -1.0f, -1.0f,
+     1.0f, -1.0f,
+    -1.0f,  1.0f,
+     1.0f,  1.0f,
+};
+
+// Widget pixels, y down, to clip space
+const char* TO_CLIP =
+    "uniform vec2 viewport;\n"
+    "vec4 toClip(vec2 p) {\n"
+    "    return vec4(p.x / viewport.x * 2.0 - 1.0, 1.0 - p.y / viewport.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+const char* SYMBOL_VERTEX =
+    "in vec2 corner;\n"
+    "in vec4 instance;\n"       // x, y, size, line width
+    "in vec4 color;\n"
+    "in float flags;\n"
+    "out vec2 local;\n"
+    "out vec4 symbolColor;\n"
+    "flat out int symbolFlags;\n"
+    "flat out float symbolSize;\n"
+    "flat out float symbolWidth;\n"
+    "void main() {\n"
+    "    local = corner * (instance.z + 11.0);\n"
+    "    gl_Position = toClip(instance.xy + local);\n"
+    "    symbolColor = color;\n"
+    "    symbolFlags = int(flags + 0.5);\n"
+    "    symbolSize = instance.z;\n"
+    "    symbolWidth = instance.w;\n"
+    "}\n";
+
+// Distance to the outline, then the pen, fill and rings composited
+// front to back as premultiplied colour
+const char* SYMBOL_FRAGMENT =
+    "in vec2 local;\n"
+    "in vec4 symbolColor;\n"
+    "flat in int symbolFlags;\n"
+    "flat in float symbolSize;\n"
+    "flat in float symbolWidth;\n"
+    "uniform float pixel;\n"
+    "out vec4 fragColor;\n"
+    "float band(float d, float width) {\n"
+    "    return clamp((width * 0.5 + pixel * 0.5 - abs(d)) / pixel, 0.0, 1.0);\n"
+    "}\n"
+    "vec4 over(vec4 top, vec4 under) {\n"
+    "    return top + under * (1.0 - top.a);\n"
+    "}\n"
+    "vec4 paint(vec3 rgb, float alpha) {\n"
+    "    return vec4(rgb * alpha, alpha);\n"
+    "}\n"
+    "void main() {\n"
+    "    int shape = symbolFlags & 3;\n"
+    "    vec2 a = abs(local);\n"
+    "    float r = length(local);\n"
+    "    float d = shape == 0 ? (a.x + a.y - symbolSize) * 0.70710678\n"
+    "            : shape == 2 ? max(a.x, a.y) - symbolSize\n"
+    "            : r - symbolSize;\n"
+    "    vec4 c = vec4(0.0);\n"
+    "    if ((symbolFlags & 4) != 0) {\n"
+    "        c = paint(symbolColor.rgb, symbolColor.a * 0.392 * clamp(0.5 - d / pixel, 0.0, 1.0));\n"
+    "    }\n"
+    "    c = over(paint(symbolColor.rgb, symbolColor.a * band(d, symbolWidth)), c);\n"
+    "    if ((symbolFlags & 8) != 0) {\n"
+    "        float ring = symbolSize + 5.0;\n"
+    "        float dash = mod(atan(local.y, local.x) * ring, 6.0) < 4.0 ? 1.0 : 0.0;\n"
+    "        c = over(paint(vec3(1.0), dash * band(r - ring, 1.0)), c);\n"
+    "    }\n"
+    "    if ((symbolFlags & 16) != 0) {\n"
+    "        c = over(paint(vec3(1.0, 0.0, 0.0), band(r - symbolSize - 8.0, 2.0)), c);\n"
+    "    }\n"
+    "    if (c.a <= 0.0) discard;\n"
+    "    fragColor = c;\n"
+    "}\n";
+
+const char* TEXT_VERTEX =
+    "in vec2 corner;\n"
+    "in vec4 rect;\n"
+    "in vec4 uv;\n"
+    "in vec4 color;\n"
+    "out vec2 texCoord;\n"
+    "out vec4 textColor;\n"
+    "void main() {\n"
+    "    vec2 t = corner * 0.5 + 0.5;\n"
+    "    gl_Position = toClip(rect.xy + t * rect.zw);\n"
+    "    texCoord = mix(uv.xy, uv.zw, t);\n"
+    "    textColor = color;\n"
+    "}\n";
+
+const char* TEXT_FRAGMENT =
+    "in vec2 texCoord;\n"
+    "in vec4 textColor;\n"
+    "uniform sampler2D atlas;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    float coverage = texture(atlas, texCoord).a * textColor.a;\n"
+    "    fragColor = vec4(textColor.rgb * coverage, coverage);\n"
+    "}\n";
+
+const char* FLAT_VERTEX =
+    "in vec2 position;\n"
+    "in vec4 color;\n"
+    "out vec4 flatColor;\n"
+    "void main() {\n"
+    "    gl_Position = toClip(position);\n"
+    "    flatColor = color;\n"
+    "}\n";
+
+const char* FLAT_FRAGMENT =
+    "in vec4 flatColor;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragColor = vec4(flatColor.rgb * flatColor.a, flatColor.a);\n"
+    "}\n";
+
+// Colour from the trail's palette slot, faded with age
+const char* TRAIL_VERTEX =
+    "in vec2 position;\n"
+    "in float time;\n"
+    "in float slot;\n"
+    "uniform mat3 trailTransform;\n"
+    "uniform float now;\n"
+    "uniform float window;\n"
+    "uniform float alphaScale;\n"
+    "uniform float pointSize;\n"
+    "uniform sampler2D palette;\n"
+    "out vec4 trailColor;\n"
+    "void main() {\n"
+    "    int s = int(slot + 0.5);\n"
+    "    vec4 c = texelFetch(palette, ivec2(s % 256, s / 256), 0);\n"
+    "    float alpha = c.a * alphaScale * clamp(1.0 - (now - time) / window, 0.0, 1.0);\n"
+    "    trailColor = vec4(c.rgb * alpha, alpha);\n"
+    "    gl_Position = toClip((trailTransform * vec3(position, 1.0)).xy);\n"
+    "    gl_PointSize = pointSize;\n"
+    "}\n";
+
+const char* TRAIL_FRAGMENT =
+    "in vec4 trailColor;\n"
+    "uniform int roundPoints;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    if (roundPoints != 0) {\n"
+    "        vec2 q = gl_PointCoord * 2.0 - 1.0;\n"
+    "        if (dot(q, q) > 1.0) discard;\n"
+    "    }\n"
+    "    fragColor = trailColor;\n"
+    "}\n";
+
+// The quad covers the view; ground is interpolated exactly as the
+// transform is affine
+const char* VIDEO_VERTEX =
+    "in vec2 corner;\n"
+    "uniform mat3 screenToGround;\n"
+    "out vec2 screen;\n"
+    "out vec2 ground;\n"
+    "void main() {\n"
+    "    screen = vec2(corner.x * 0.5 + 0.5, 0.5 - corner.y * 0.5) * viewport;\n"
+    "    ground = (screenToGround * vec3(screen, 1.0)).xy;\n"
+    "    gl_Position = toClip(screen);\n"
+    "}\n";
+
+// Scan conversion: range and bearing of the pixel from the antenna pick
+// the polar sample, faded by the age of its row; then the sweep afterglow
+// over it, both premultiplied
+const char* VIDEO_FRAGMENT =
+    "in vec2 screen;\n"
+    "in vec2 ground;\n"
+    "uniform sampler2D video;\n"
+    "uniform highp sampler2D rowTimes;\n"
+    "uniform int hasVideo;\n"
+    "uniform float maxRange;\n"
+    "uniform float now;\n"
+    "uniform float persistence;\n"
+    "uniform float gain;\n"
+    "uniform vec4 videoColor;\n"
+    "uniform vec2 sweepCenter;\n"
+    "uniform float sweepRadius;\n"
+    "uniform float sweepAngle;\n"
+    "uniform float trailSpan;\n"
+    "uniform vec4 sweepColor;\n"
+    "out vec4 fragColor;\n"
+    "const float TWO_PI = 6.28318531;\n"
+    "void main() {\n"
+    "    vec2 d = screen - sweepCenter;\n"
+    "    if (dot(d, d) > sweepRadius * sweepRadius) discard;\n"
+    "    vec4 c = vec4(0.0);\n"
+    "    float range = length(ground);\n"
+    "    if (hasVideo != 0 && range < maxRange) {\n"
+    "        float turn = fract(atan(ground.x, ground.y) / TWO_PI + 1.0);\n"
+    "        int rows = textureSize(video, 0).y;\n"
+    "        int row = min(int(turn * float(rows)), rows - 1);\n"
+    "        float age = now - texelFetch(rowTimes, ivec2(row % 256, row / 256), 0).r;\n"
+    "        float echo = texture(video, vec2(range / maxRange, turn)).r;\n"
+    "        float a = videoColor.a * clamp(echo * gain, 0.0, 1.0) * exp(-max(age, 0.0) / persistence);\n"
+    "        c = vec4(videoColor.rgb * a, a);\n"
+    "    }\n"
+    "    if (sweepColor.a > 0.0) {\n"
+    "        float behind = mod(sweepAngle - atan(d.x, -d.y), TWO_PI);\n"
+    "        float a = sweepColor.a * 0.3 * max(0.0, 1.0 - behind / trailSpan);\n"
+    "        c = vec4(sweepColor.rgb * a, a) + c * (1.0 - a);\n"
+    "    }\n"
+    "    if (c.a <= 0.0) discard;\n"
+    "    fragColor = c;\n"
+    "}\n";
+
+bool contextSupported(const QOpenGLContext* ctx) {
+    const QPair<int, int> version = ctx->format().version();
+    return ctx->isOpenGLES() ? version >= qMakePair(3, 0) : version >= qMakePair(3, 3);
+}
+
+} // namespace
+
+TrackGLView::TrackGLView(QWidget* parent)
+    : QOpenGLWidget(parent)
+    , m_quad(QOpenGLBuffer::VertexBuffer)
+    , m_symbolBuffer(QOpenGLBuffer::VertexBuffer)
+    , m_textBuffer(QOpenGLBuffer::VertexBuffer)
+    , m_vectorBuffer(QOpenGLBuffer::VertexBuffer)
+    , m_trailBuffer(QOpenGLBuffer::VertexBuffer)
+{
+    // Composited over the parent's own painting, which keeps the mouse
+    setAttribute(Qt::WA_AlwaysStackOnTop);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    QSurfaceFormat surface = format();
+    surface.setAlphaBufferSize(8);
+    surface.setSamples(4);
+    setFormat(surface);
+
+    m_epochMs = QDateTime::currentMSecsSinceEpoch();
+    m_labelFont = font();
+    m_labelFont.setPointSize(8);
+}
+
+TrackGLView::~TrackGLView() {
+    releaseGL();
+}
+
+void TrackGLView::setDefaultBackend(TrackRenderBackend backend) {
+    s_defaultBackend = backend;
+}
+
+TrackRenderBackend TrackGLView::defaultBackend() {
+    return s_defaultBackend;
+}
+
+bool TrackGLView::isSupported() {
+    static const bool supported = []() {
+        QOpenGLContext probe;
+        return probe.create() && contextSupported(&probe);
+    }();
+    return supported;
+}
+
+void TrackGLView::setGlyphs(const QVector<TrackGlyph>& glyphs) {
+    m_glyphs = glyphs;
+    m_sceneDirty = true;
+    update();
+}
+
+void TrackGLView::setLabelFont(const QFont& font) {
+    m_labelFont = font;
+    m_atlasDirty = true;
+    update();
+}
+
+void TrackGLView::appendTrailSamples(const QVector<TrackTrailSample>& samples) {
+    for (const TrackTrailSample& sample : samples) {
+        Trail& trail = m_trails[sample.key];
+        if (trail.slot < 0) {
+            trail.slot = takeSlot();
+        }
+        const QRgb rgba = sample.color.rgba();
+        if (m_palette[trail.slot] != rgba) {
+            m_palette[trail.slot] = rgba;
+            m_paletteDirty = true;
+        }
+
+        const float time = secondsSinceEpoch(sample.timestampMs);
+        if (trail.hasLast) {
+            const float slot = float(trail.slot);
+            m_trailVertices.append({float(trail.last.x()), float(trail.last.y()), trail.lastTime, slot});
+            m_trailVertices.append({float(sample.position.x()), float(sample.position.y()), time, slot});
+        }
+        trail.last = sample.position;
+        trail.lastTime = time;
+        trail.hasLast = true;
+    }
+    update();
+}
+
+void TrackGLView::setTrailColor(quint64 key, const QColor& color) {
+    auto it = m_trails.find(key);
+    if (it == m_trails.end() || m_palette[it->slot] == color.rgba()) return;
+    m_palette[it->slot] = color.rgba();
+    m_paletteDirty = true;
+    update();
+}
+
+void TrackGLView::removeTrail(quint64 key) {
+    auto it = m_trails.find(key);
+    if (it == m_trails.end()) return;
+
+    // Hidden now; the slot is reused once none of its segments remain
+    m_palette[it->slot] = 0;
+    m_retiredSlots.append(qMakePair(it->slot, secondsSinceEpoch(QDateTime::currentMSecsSinceEpoch())));
+    m_trails.erase(it);
+    m_paletteDirty = true;
+    update();
+}
+
+void TrackGLView::clearTrails() {
+    m_trails.clear();
+    m_trailVertices.clear();
+    m_trailStart = 0;
+    m_trailReupload = true;
+    m_palette.clear();
+    m_retiredSlots.clear();
+    m_freeSlots.clear();
+    m_paletteDirty = true;
+    update();
+}
+
+void TrackGLView::setTrailTransform(const QTransform& toScreen) {
+    if (toScreen == m_trailTransform) return;
+    m_trailTransform = toScreen;
+    update();
+}
+
+void TrackGLView::setTrailWindow(int seconds) {
+    m_trailWindowSeconds = qMax(1, seconds);
+    update();
+}
+
+void TrackGLView::setTrailsVisible(bool visible) {
+    m_trailsVisible = visible;
+    update();
+}
+
+void TrackGLView::setRadarVideo(std::shared_ptr<const RadarVideoRing> ring) {
+    m_video = std::move(ring);
+    m_videoGeneration = 0;
+    update();
+}
+
+void TrackGLView::setRadarVideoTransform(const QTransform& groundToScreen) {
+    const QTransform inverse = groundToScreen.inverted();
+    if (inverse == m_screenToVideo) return;
+    m_screenToVideo = inverse;
+    update();
+}
+
+void TrackGLView::setRadarVideoStyle(const QColor& color, double persistenceS, double gain) {
+    m_videoColor = color;
+    m_videoPersistenceS = float(qMax(0.05, persistenceS));
+    m_videoGain = float(qMax(0.0, gain));
+    update();
+}
+
+void TrackGLView::setSweep(const QPointF& center, double radius, double screenAngleDeg, const QColor& color) {
+    m_sweepCenter = center;
+    m_sweepRadius = float(radius);
+    m_sweepAngle = float(qDegreesToRadians(screenAngleDeg));
+    m_sweepColor = color;
+    // Every frame: the afterglow turns and the video decays
+    update();
+}
+
+int TrackGLView::takeSlot() {
+    if (!m_freeSlots.isEmpty()) {
+        return m_freeSlots.takeLast();
+    }
+    m_palette.append(0);
+    m_paletteDirty = true;
+    return m_palette.size() - 1;
+}
+
+void TrackGLView::expireTrails(float now) {
+    const float cutoff = now - m_trailWindowSeconds;
+
+    // Appended in time order, so the expired are at the front; a segment
+    // appended out of order lingers until it gets there, faded out
+    while (m_trailStart < m_trailVertices.size() && m_trailVertices[m_trailStart + 1].time < cutoff) {
+        m_trailStart += 2;
+    }
+    if (m_trailStart > MIN_TRAIL_CAPACITY && m_trailStart * 2 > m_trailVertices.size()) {
+        m_trailVertices.remove(0, m_trailStart);
+        m_trailStart = 0;
+        m_trailReupload = true;
+    }
+
+    for (int i = m_retiredSlots.size() - 1; i >= 0; --i) {
+        if (m_retiredSlots[i].second < cutoff) {
+            m_freeSlots.append(m_retiredSlots[i].first);
+            m_retiredSlots.remove(i);
+        }
+    }
+}
+
+void TrackGLView::initializeGL() {
+    initializeOpenGLFunctions();
+    connect(context(), &QOpenGLContext::aboutToBeDestroyed,
+            this, &TrackGLView::releaseGL, Qt::UniqueConnection);
+
+    m_usable = false;
+    m_desktop = !context()->isOpenGLES();
+    if (!contextSupported(context()) || !buildPrograms()) {
+        if (!m_failed) {
+            m_failed = true;
+            // Queued, so the parent may delete this view from its slot
+            QMetaObject::invokeMethod(this, [this]() { emit unavailable(); }, Qt::QueuedConnection);
+        }
+        return;
+    }
+
+    m_vao.reset(new QOpenGLVertexArrayObject);
+    m_vao->create();
+
+    m_quad.create();
+    m_quad.bind();
+    m_quad.allocate(QUAD, sizeof(QUAD));
+    m_quad.release();
+    for (QOpenGLBuffer* buffer : {&m_symbolBuffer, &m_textBuffer, &m_vectorBuffer, &m_trailBuffer}) {
+        buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+        buffer->create();
+    }
+
+    GLuint textures[4];
+    glGenTextures(4, textures);
+    m_atlasTexture = textures[0];
+    m_paletteTexture = textures[1];
+    m_videoTexture = textures[2];
+    m_videoTimeTexture = textures[3];
+    for (GLuint texture : textures) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    // Echoes interpolate along range and across azimuth, which wraps at north
+    glBindTexture(GL_TEXTURE_2D, m_videoTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // A new context holds none of it
+    m_trailCapacity = 0;
+    m_trailReupload = true;
+    m_paletteRows = 0;
+    m_paletteDirty = true;
+    m_videoRows = 0;
+    m_videoBins = 0;
+    m_atlasDirty = true;
+    m_sceneDirty = true;
+    m_usable = true;
+}
+
+void TrackGLView::releaseGL() {
+    if (!m_symbolProgram && m_atlasTexture == 0) return;
+    makeCurrent();
+    if (m_atlasTexture != 0) {
+        const GLuint textures[4] = {m_atlasTexture, m_paletteTexture, m_videoTexture, m_videoTimeTexture};
+        glDeleteTextures(4, textures);
+        m_atlasTexture = 0;
+        m_paletteTexture = 0;
+        m_videoTexture = 0;
+        m_videoTimeTexture = 0;
+    }
+    for (QOpenGLBuffer* buffer : {&m_quad, &m_symbolBuffer, &m_textBuffer, &m_vectorBuffer, &m_trailBuffer}) {
+        buffer->destroy();
+    }
+    if (m_vao) m_vao->destroy();
+    m_vao.reset();
+    m_symbolProgram.reset();
+    m_textProgram.reset();
+    m_flatProgram.reset();
+    m_trailProgram.reset();
+    m_videoProgram.reset();
+    m_usable = false;
+    doneCurrent();
+}
+
+std::unique_ptr<QOpenGLShaderProgram> TrackGLView::buildProgram(const char* vertex, const char* fragment,
+                                                                const QVector<QByteArray>& attributes) {
+    const QByteArray header = m_desktop ? "#version 330\n"
+                                        : "#version 300 es\nprecision highp float;\nprecision highp int;\n";
+    std::unique_ptr<QOpenGLShaderProgram> program(new QOpenGLShaderProgram);
+    const bool ok =
+        program->addShaderFromSourceCode(QOpenGLShader::Vertex, header + TO_CLIP + vertex) &&
+        program->addShaderFromSourceCode(QOpenGLShader::Fragment, header + fragment);
+    for (int i = 0; i < attributes.size(); ++i) {
+        program->bindAttributeLocation(attributes[i].constData(), i);
+    }
+    if (!ok || !program->link()) {
+        qWarning("TrackGLView: shader build failed: %s", qPrintable(program->log()));
+        return nullptr;
+    }
+    return program;
+}
+
+bool TrackGLView::buildPrograms() {
+    m_symbolProgram = buildProgram(SYMBOL_VERTEX, SYMBOL_FRAGMENT, {"corner", "instance", "color", "flags"});
+    m_textProgram = buildProgram(TEXT_VERTEX, TEXT_FRAGMENT, {"corner", "rect", "uv", "color"});
+    m_flatProgram = buildProgram(FLAT_VERTEX, FLAT_FRAGMENT, {"position", "color"});
+    m_trailProgram = buildProgram(TRAIL_VERTEX, TRAIL_FRAGMENT, {"position", "time", "slot"});
+    m_videoProgram = buildProgram(VIDEO_VERTEX, VIDEO_FRAGMENT, {"corner"});
+    return m_symbolProgram && m_textProgram && m_flatProgram && m_trailProgram && m_videoProgram;
+}
+
+void TrackGLView::buildAtlas() {
+    const qreal dpr = devicePixelRatioF();
+    const QFontMetricsF metrics(m_labelFont, this);
+    const qreal cellHeight = std::ceil(metrics.height()) + 2.0;
+
+    // Printable ASCII: track ids, speeds and altitudes
+    struct Cell { QChar ch; QPointF at; qreal width; };
+    QVector<Cell> cells;
+    QPointF at(0.0, 0.0);
+    for (ushort code = 32; code < 127; ++code) {
+        const QChar ch(code);
+        const qreal width = std::ceil(metrics.horizontalAdvance(ch)) + 2.0;
+        if (at.x() + width > ATLAS_WIDTH) {
+            at = QPointF(0.0, at.y() + cellHeight);
+        }
+        cells.append({ch, at, width});
+        at.rx() += width;
+    }
+    const QSizeF logical(ATLAS_WIDTH, at.y() + cellHeight);
+
+    m_atlasImage = QImage((logical * dpr).toSize(), QImage::Format_RGBA8888_Premultiplied);
+    m_atlasImage.setDevicePixelRatio(dpr);
+    // Point sizes come out as they do on the widget
+    m_atlasImage.setDotsPerMeterX(qRound(logicalDpiX() / 0.0254));
+    m_atlasImage.setDotsPerMeterY(qRound(logicalDpiY() / 0.0254));
+    m_atlasImage.fill(Qt::transparent);
+
+    QPainter painter(&m_atlasImage);
+    painter.setFont(m_labelFont);
+    painter.setPen(Qt::white);
+    m_atlasGlyphs.clear();
+    for (const Cell& cell : cells) {
+        painter.drawText(cell.at + QPointF(1.0, 1.0 + metrics.ascent()), QString(cell.ch));
+        AtlasGlyph glyph;
+        glyph.uv = QRectF(cell.at.x() / logical.width(), cell.at.y() / logical.height(),
+                          cell.width / logical.width(), cellHeight / logical.height());
+        glyph.size = QSizeF(cell.width, cellHeight);
+        glyph.advance = float(metrics.horizontalAdvance(cell.ch));
+        m_atlasGlyphs.insert(cell.ch, glyph);
+    }
+    painter.end();
+
+    m_atlasAscent = float(metrics.ascent());
+    m_atlasDescent = float(metrics.descent());
+    m_atlasRatio = dpr;
+
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_atlasImage.width(), m_atlasImage.height(), 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, m_atlasImage.constBits());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_atlasDirty = false;
+}
+
+void TrackGLView::appendText(const QString& text, const QPointF& origin, const QColor& color, bool centred) {
+    const AtlasGlyph fallback = m_atlasGlyphs.value(QLatin1Char('?'));
+    QPointF pen = origin;
+    if (centred) {
+        float width = 0.0f;
+        for (const QChar& ch : text) width += m_atlasGlyphs.value(ch, fallback).advance;
+        pen += QPointF(-width / 2.0, (m_atlasAscent - m_atlasDescent) / 2.0);
+    }
+
+    for (const QChar& ch : text) {
+        const AtlasGlyph glyph = m_atlasGlyphs.value(ch, fallback);
+        if (ch != QLatin1Char(' ')) {
+            GlyphInstance instance;
+            instance.x = float(pen.x() - 1.0);
+            instance.y = float(pen.y() - m_atlasAscent - 1.0);
+            instance.w = float(glyph.size.width());
+            instance.h = float(glyph.size.height());
+            instance.u0 = float(glyph.uv.left());
+            instance.v0 = float(glyph.uv.top());
+            instance.u1 = float(glyph.uv.right());
+            instance.v1 = float(glyph.uv.bottom());
+            instance.r = quint8(color.red());
+            instance.g = quint8(color.green());
+            instance.b = quint8(color.blue());
+            instance.a = quint8(color.alpha());
+            m_text.append(instance);
+        }
+        pen.rx() += glyph.advance;
+    }
+}
+
+void TrackGLView::appendSegment(const QPointF& from, const QPointF& to, double width, const QColor& color) {
+    const double length = std::hypot(to.x() - from.x(), to.y() - from.y());
+    if (length <= 0.0) return;
+
+    // A quad width across
+    const QPointF dir = (to - from) / length;
+    const QPointF across = QPointF(-dir.y(), dir.x()) * (width / 2.0);
+    const QPointF corners[4] = {from - across, from + across, to - across, to + across};
+    const quint8 r = quint8(color.red()), g = quint8(color.green()), b = quint8(color.blue()), a = quint8(color.alpha());
+    for (int i : {0, 1, 2, 1, 3, 2}) {
+        m_vectors.append({float(corners[i].x()), float(corners[i].y()), r, g, b, a});
+    }
+}
+
+void TrackGLView::uploadScene() {
+    m_symbols.clear();
+    m_text.clear();
+    m_vectors.clear();
+    m_symbols.reserve(m_glyphs.size());
+
+    for (const TrackGlyph& glyph : m_glyphs) {
+        const QColor& c = glyph.color;
+        const quint8 r = quint8(c.red()), g = quint8(c.green()), b = quint8(c.blue()), a = quint8(c.alpha());
+        int flags = glyph.shape == TrackGlyphShape::Diamond ? 0
+                  : glyph.shape == TrackGlyphShape::Square ? 2 : 1;
+        if (glyph.filled) flags |= 4;
+        if (glyph.selected) flags |= 8;
+        if (glyph.engaged) flags |= 16;
+        m_symbols.append({float(glyph.position.x()), float(glyph.position.y()), glyph.size, glyph.lineWidth,
+                          r, g, b, a, float(flags)});
+
+        // Shaft the symbol's line width across, then the head
+        const double length = std::hypot(glyph.velocity.x(), glyph.velocity.y());
+        if (length > 0.0) {
+            const QPointF dir = glyph.velocity / length;
+            const QPointF tip = glyph.position + glyph.velocity;
+            appendSegment(glyph.position, tip, glyph.lineWidth, c);
+            if (glyph.arrowHead) {
+                const double angle = std::atan2(dir.y(), dir.x());
+                const double arrowSize = 6.0;
+                const double arrowAngle = M_PI / 6;
+                const QPointF head[3] = {
+                    tip,
+                    tip - QPointF(std::cos(angle - arrowAngle), std::sin(angle - arrowAngle)) * arrowSize,
+                    tip - QPointF(std::cos(angle + arrowAngle), std::sin(angle + arrowAngle)) * arrowSize,
+                };
+                for (const QPointF& p : head) {
+                    m_vectors.append({float(p.x()), float(p.y()), r, g, b, a});
+                }
+            }
+        }
+
+        const QColor labelColor = glyph.labelColor.isValid() ? glyph.labelColor : c;
+        if (!glyph.leader.isNull()) {
+            QColor leaderColor = labelColor;
+            leaderColor.setAlpha(leaderColor.alpha() * 160 / 255);
+            appendSegment(glyph.leader.p1(), glyph.leader.p2(), 1.0, leaderColor);
+        }
+        if (!glyph.symbolText.isEmpty()) {
+            appendText(glyph.symbolText, glyph.position, c, true);
+        }
+        if (!glyph.label.isEmpty()) {
+            appendText(glyph.label, glyph.position + glyph.labelOffset, labelColor);
+        }
+    }
+
+    m_symbolBuffer.bind();
+    m_symbolBuffer.allocate(m_symbols.constData(), int(m_symbols.size() * sizeof(SymbolInstance)));
+    m_textBuffer.bind();
+    m_textBuffer.allocate(m_text.constData(), int(m_text.size() * sizeof(GlyphInstance)));
+    m_vectorBuffer.bind();
+    m_vectorBuffer.allocate(m_vectors.constData(), int(m_vectors.size() * sizeof(FlatVertex)));
+    m_vectorBuffer.release();
+    m_sceneDirty = false;
+}
+
+void TrackGLView::uploadTrails() {
+    const int count = m_trailVertices.size();
+    const int stride = int(sizeof(TrailVertex));
+    m_trailBuffer.bind();
+    if (m_trailReupload || count > m_trailCapacity) {
+        m_trailCapacity = qMax(MIN_TRAIL_CAPACITY, count * 2);
+        m_trailBuffer.allocate(m_trailCapacity * stride);
+        m_trailBuffer.write(0, m_trailVertices.constData(), count * stride);
+        m_trailReupload = false;
+    } else if (count > m_trailUploaded) {
+        // Only what was appended since the last frame
+        m_trailBuffer.write(m_trailUploaded * stride, m_trailVertices.constData() + m_trailUploaded,
+                            (count - m_trailUploaded) * stride);
+    }
+    m_trailBuffer.release();
+    m_trailUploaded = count;
+}
+
+void TrackGLView::updatePalette() {
+    const int rows = qMax(1, (m_palette.size() + PALETTE_WIDTH - 1) / PALETTE_WIDTH);
+    QVector<quint8> texels(rows * PALETTE_WIDTH * 4, 0);
+    for (int i = 0; i < m_palette.size(); ++i) {
+        const QRgb rgba = m_palette[i];
+        texels[i * 4] = quint8(qRed(rgba));
+        texels[i * 4 + 1] = quint8(qGreen(rgba));
+        texels[i * 4 + 2] = quint8(qBlue(rgba));
+        texels[i * 4 + 3] = quint8(qAlpha(rgba));
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_paletteTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (rows != m_paletteRows) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, PALETTE_WIDTH, rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.constData());
+        m_paletteRows = rows;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PALETTE_WIDTH, rows, GL_RGBA, GL_UNSIGNED_BYTE, texels.constData());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_paletteDirty = false;
+}
+
+void TrackGLView::uploadVideo() {
+    const int rows = m_video->azimuthCount();
+    const int bins = m_video->rangeBins();
+    const int timeRows = (rows + PALETTE_WIDTH - 1) / PALETTE_WIDTH;
+    if (rows != m_videoRows || bins != m_videoBins) {
+        glBindTexture(GL_TEXTURE_2D, m_videoTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, bins, rows, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        m_videoRowTimes.fill(NEVER_WRITTEN, timeRows * PALETTE_WIDTH);
+        glBindTexture(GL_TEXTURE_2D, m_videoTimeTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, PALETTE_WIDTH, timeRows, 0, GL_RED, GL_FLOAT, nullptr);
+        m_videoRows = rows;
+        m_videoBins = bins;
+        m_videoGeneration = 0;
+    }
+    if (!m_video->changesSince(m_videoGeneration, m_videoUpdate)) return;
+    m_videoGeneration = m_videoUpdate.generation;
+
+    // One upload per run of consecutive rows: normally the sweep's last few
+    const QVector<int>& changed = m_videoUpdate.rows;
+    glBindTexture(GL_TEXTURE_2D, m_videoTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < changed.size();) {
+        int end = i + 1;
+        while (end < changed.size() && changed[end] == changed[end - 1] + 1) ++end;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, changed[i], bins, end - i, GL_RED, GL_UNSIGNED_BYTE,
+                        m_videoUpdate.samples.constData() + i * bins);
+        i = end;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    for (int i = 0; i < changed.size(); ++i) {
+        const qint64 ms = m_videoUpdate.rowTimeMs[i];
+        m_videoRowTimes[changed[i]] = ms > 0 ? secondsSinceEpoch(ms) : NEVER_WRITTEN;
+    }
+    glBindTexture(GL_TEXTURE_2D, m_videoTimeTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, PALETTE_WIDTH, timeRows, GL_RED, GL_FLOAT, m_videoRowTimes.constData());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TrackGLView::drawVideo(const QVector2D& viewport, float now) {
+    const bool hasVideo = m_video != nullptr;
+    if (hasVideo) uploadVideo();
+
+    m_videoProgram->bind();
+    m_videoProgram->setUniformValue("viewport", viewport);
+    m_videoProgram->setUniformValue("screenToGround", m_screenToVideo);
+    m_videoProgram->setUniformValue("hasVideo", hasVideo ? 1 : 0);
+    m_videoProgram->setUniformValue("maxRange", float(hasVideo ? m_video->maxRangeM() : 1.0));
+    m_videoProgram->setUniformValue("now", now);
+    m_videoProgram->setUniformValue("persistence", m_videoPersistenceS);
+    m_videoProgram->setUniformValue("gain", m_videoGain);
+    m_videoProgram->setUniformValue("videoColor", m_videoColor);
+    m_videoProgram->setUniformValue("sweepCenter", m_sweepCenter);
+    m_videoProgram->setUniformValue("sweepRadius", m_sweepRadius);
+    m_videoProgram->setUniformValue("sweepAngle", m_sweepAngle);
+    m_videoProgram->setUniformValue("trailSpan", SWEEP_TRAIL_SPAN);
+    m_videoProgram->setUniformValue("sweepColor", m_sweepColor);
+    m_videoProgram->setUniformValue("video", 0);
+    m_videoProgram->setUniformValue("rowTimes", 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_videoTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_videoTimeTexture);
+
+    m_quad.bind();
+    m_videoProgram->enableAttributeArray(0);
+    m_videoProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    m_videoProgram->disableAttributeArray(0);
+    m_quad.release();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_videoProgram->release();
+}
+
+void TrackGLView::paintGL() {
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!m_usable) return;
+
+    const qreal dpr = devicePixelRatioF();
+    if (m_atlasDirty || !qFuzzyCompare(m_atlasRatio, dpr)) {
+        buildAtlas();
+        m_sceneDirty = true;    // Label quads depend on the metrics
+    }
+    if (m_sceneDirty) uploadScene();
+
+    const float now = secondsSinceEpoch(QDateTime::currentMSecsSinceEpoch());
+    expireTrails(now);
+    if (m_paletteDirty) updatePalette();
+    uploadTrails();
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    QOpenGLVertexArrayObject::Binder vaoBinder(m_vao.get());
+    const QVector2D viewport(float(width()), float(height()));
+
+    // Video and the sweep afterglow under everything else
+    if (m_sweepRadius > 0.0f && (m_video || m_sweepColor.alpha() > 0)) {
+        drawVideo(viewport, now);
+    }
+
+    // Then trails: segments, then a dot at each newer end
+    const int segments = (m_trailVertices.size() - m_trailStart) / 2;
+    if (m_trailsVisible && segments > 0) {
+        const int stride = int(sizeof(TrailVertex));
+        m_trailProgram->bind();
+        m_trailProgram->setUniformValue("viewport", viewport);
+        m_trailProgram->setUniformValue("trailTransform", m_trailTransform);
+        m_trailProgram->setUniformValue("now", now);
+        m_trailProgram->setUniformValue("window", float(m_trailWindowSeconds));
+        m_trailProgram->setUniformValue("palette", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_paletteTexture);
+        m_trailBuffer.bind();
+        for (int i = 0; i < 3; ++i) m_trailProgram->enableAttributeArray(i);
+
+        m_trailProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2, stride);
+        m_trailProgram->setAttributeBuffer(1, GL_FLOAT, 8, 1, stride);
+        m_trailProgram->setAttributeBuffer(2, GL_FLOAT, 12, 1, stride);
+        m_trailProgram->setUniformValue("alphaScale", 0.5f);
+        m_trailProgram->setUniformValue("pointSize", 1.0f);
+        m_trailProgram->setUniformValue("roundPoints", 0);
+        glDrawArrays(GL_LINES, m_trailStart, segments * 2);
+
+        if (m_desktop) glEnable(GL_PROGRAM_POINT_SIZE);
+        m_trailProgram->setAttributeBuffer(0, GL_FLOAT, stride, 2, stride * 2);
+        m_trailProgram->setAttributeBuffer(1, GL_FLOAT, stride + 8, 1, stride * 2);
+        m_trailProgram->setAttributeBuffer(2, GL_FLOAT, stride + 12, 1, stride * 2);
+        m_trailProgram->setUniformValue("alphaScale", 0.7f);
+        m_trailProgram->setUniformValue("pointSize", float(4.0 * dpr));
+        m_trailProgram->setUniformValue("roundPoints", 1);
+        glDrawArrays(GL_POINTS, m_trailStart / 2, segments);
+        if (m_desktop) glDisable(GL_PROGRAM_POINT_SIZE);
+
+        for (int i = 0; i < 3; ++i) m_trailProgram->disableAttributeArray(i);
+        m_trailBuffer.release();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_trailProgram->release();
+    }
+
+    if (!m_vectors.isEmpty()) {
+        const int stride = int(sizeof(FlatVertex));
+        m_flatProgram->bind();
+        m_flatProgram->setUniformValue("viewport", viewport);
+        m_vectorBuffer.bind();
+        m_flatProgram->enableAttributeArray(0);
+        m_flatProgram->enableAttributeArray(1);
+        m_flatProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2, stride);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(8));
+        glDrawArrays(GL_TRIANGLES, 0, m_vectors.size());
+        m_flatProgram->disableAttributeArray(0);
+        m_flatProgram->disableAttributeArray(1);
+        m_vectorBuffer.release();
+        m_flatProgram->release();
+    }
+
+    // One quad per instance: the corner advances per vertex, the rest per instance
+    if (!m_symbols.isEmpty()) {
+        const int stride = int(sizeof(SymbolInstance));
+        m_symbolProgram->bind();
+        m_symbolProgram->setUniformValue("viewport", viewport);
+        m_symbolProgram->setUniformValue("pixel", float(1.0 / dpr));
+        m_quad.bind();
+        m_symbolProgram->enableAttributeArray(0);
+        m_symbolProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+        m_symbolBuffer.bind();
+        for (int i = 1; i < 4; ++i) {
+            m_symbolProgram->enableAttributeArray(i);
+            glVertexAttribDivisor(GLuint(i), 1);
+        }
+        m_symbolProgram->setAttributeBuffer(1, GL_FLOAT, 0, 4, stride);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(16));
+        m_symbolProgram->setAttributeBuffer(3, GL_FLOAT, 20, 1, stride);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_symbols.size());
+        for (int i = 0; i < 4; ++i) {
+            glVertexAttribDivisor(GLuint(i), 0);
+            m_symbolProgram->disableAttributeArray(i);
+        }
+        m_symbolBuffer.release();
+        m_symbolProgram->release();
+    }
+
+    if (!m_text.isEmpty()) {
+        const int stride = int(sizeof(GlyphInstance));
+        m_textProgram->bind();
+        m_textProgram->setUniformValue("viewport", viewport);
+        m_textProgram->setUniformValue("atlas", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+        m_quad.bind();
+        m_textProgram->enableAttributeArray(0);
+        m_textProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+        m_textBuffer.bind();
+        for (int i = 1; i < 4; ++i) {
+            m_textProgram->enableAttributeArray(i);
+            glVertexAttribDivisor(GLuint(i), 1);
+        }
+        m_textProgram->setAttributeBuffer(1, GL_FLOAT, 0, 4, stride);
+        m_textProgram->setAttributeBuffer(2, GL_FLOAT, 16, 4, stride);
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(32));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_text.size());
+        for (int i = 0; i < 4; ++i) {
+            glVertexAttribDivisor(GLuint(i), 0);
+            m_textProgram->disableAttributeArray(i);
+        }
+        m_textBuffer.release();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_textProgram->release();
+    }
+
+    glDisable(GL_BLEND);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,271 @@
+#ifndef TRACKGLVIEW_H
+#define TRACKGLVIEW_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLBuffer>
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QLineF>
+#include <QPointF>
+#include <QTransform>
+#include <QVector>
+#include <memory>
+
+#include "sensors/RadarVideoRing.h"
+
+class QOpenGLShaderProgram;
+class QOpenGLVertexArrayObject;
+
+namespace CounterUAS {
+
+/**
+ * @brief How a tactical display draws its track symbology
+ */
+enum class TrackRenderBackend {
+    Auto,       // OpenGL when the context supports instancing, otherwise Software
+    Software,   // QPainter
+    OpenGL,     // Instanced on the GPU through TrackGLView
+    Threaded    // QPainter on a worker thread (PPI only; other displays paint in software)
+};
+
+/**
+ * @brief Outline drawn for a track symbol
+ */
+enum class TrackGlyphShape {
+    Diamond,
+    Circle,
+    Square
+};
+
+/**
+ * @brief One track's symbol, velocity vector and label, in widget pixels
+ */
+struct TrackGlyph {
+    QPointF position;
+    QPointF velocity;               // Vector head relative to position; null draws none
+    QColor color;
+    TrackGlyphShape shape = TrackGlyphShape::Square;
+    float size = 10.0f;             // Half-extent
+    float lineWidth = 2.0f;
+    bool filled = false;            // Fill at 40% alpha
+    bool selected = false;          // Dashed white ring at size + 5
+    bool engaged = false;           // Red ring at size + 8
+    bool arrowHead = true;
+    QString symbolText;             // Centred on the symbol, e.g. "?" or a cluster's count
+    QString label;
+    QPointF labelOffset = QPointF(15.0, 5.0);   // Baseline start from position
+    QColor labelColor;
+    QLineF leader;                  // To a label pushed away from the symbol; null draws none
+};
+
+/**
+ * @brief One new point of a track's history trail
+ */
+struct TrackTrailSample {
+    quint64 key = 0;                // Identifies the trail, e.g. the track handle
+    QPointF position;               // In trail coordinates, mapped by the trail transform
+    qint64 timestampMs = 0;
+    QColor color;                   // The whole trail's colour from now on
+};
+
+/**
+ * @brief Transparent OpenGL layer drawing track symbology over a display
+ *
+ * Lies over its parent and takes no mouse input; the parent keeps hit
+ * testing and everything under the tracks. Symbols are one instanced
+ * draw of a quad per track, outlined in the fragment shader. Labels are
+ * one instanced draw of a quad per character from a glyph atlas rendered
+ * once per font. Velocity vectors and label leader lines are a triangle
+ * list.
+ *
+ * History trails are segments from each track's previous point to its
+ * new one, appended in time order to a vertex buffer of which only the
+ * new tail is uploaded. Each vertex carries its time, so fading is done
+ * by the shader, and its trail's slot in a colour table, so recolouring
+ * or removing a trail rewrites one texel rather than its segments.
+ * Segments older than the trail window fall off the front. Points stay
+ * in the caller's coordinates (e.g. metres on the ground) and reach the
+ * screen through setTrailTransform(), so a zoom or pan re-projects them
+ * without touching the buffer.
+ *
+ * Raw radar video is drawn under the trails by one full-view quad: the
+ * fragment shader turns each pixel into range and bearing from the
+ * antenna and samples a polar texture holding the ring's latest spoke
+ * per azimuth, so scan conversion costs nothing on the CPU and only the
+ * rows written since the last frame are uploaded. Each row's arrival time
+ * sits in a second texture and the echo fades with its age, as phosphor
+ * does until the antenna comes round again. The sweep's afterglow comes
+ * out of the same pass.
+ *
+ * Needs OpenGL 3.3 or OpenGL ES 3.0; on anything older unavailable() is
+ * emitted from the first paint and the parent should draw in software.
+ */
+class TrackGLView : public QOpenGLWidget, protected QOpenGLExtraFunctions {
+    Q_OBJECT
+
+public:
+    explicit TrackGLView(QWidget* parent = nullptr);
+    ~TrackGLView() override;
+
+    // Applies to displays created afterwards
+    static void setDefaultBackend(TrackRenderBackend backend);
+    static TrackRenderBackend defaultBackend();
+    static bool isSupported();
+
+    // Replaces every symbol, vector and label
+    void setGlyphs(const QVector<TrackGlyph>& glyphs);
+    void setLabelFont(const QFont& font);
+
+    void appendTrailSamples(const QVector<TrackTrailSample>& samples);
+    void setTrailColor(quint64 key, const QColor& color);
+    void removeTrail(quint64 key);
+    void clearTrails();
+    void setTrailTransform(const QTransform& toScreen);
+    void setTrailWindow(int seconds);
+    void setTrailsVisible(bool visible);
+
+    // Null removes the video
+    void setRadarVideo(std::shared_ptr<const RadarVideoRing> ring);
+    void setRadarVideoTransform(const QTransform& groundToScreen);  // Metres east/north of the antenna
+    void setRadarVideoStyle(const QColor& color, double persistenceS, double gain = 1.0);
+    // Afterglow behind the sweep at screenAngleDeg (clockwise from up),
+    // also the disc the video is clipped to; a transparent colour hides
+    // the afterglow only
+    void setSweep(const QPointF& center, double radius, double screenAngleDeg, const QColor& color);
+
+    int glyphCount() const { return m_glyphs.size(); }
+    int trailSegmentCount() const { return (m_trailVertices.size() - m_trailStart) / 2; }
+
+signals:
+    void unavailable();
+
+protected:
+    void initializeGL() override;
+    void paintGL() override;
+
+private:
+    struct SymbolInstance {
+        float x, y, size, lineWidth;
+        quint8 r, g, b, a;
+        float flags;                // Shape plus 4 filled, 8 selected, 16 engaged
+    };
+    struct GlyphInstance {
+        float x, y, w, h;           // Widget pixels
+        float u0, v0, u1, v1;
+        quint8 r, g, b, a;
+    };
+    struct FlatVertex {
+        float x, y;
+        quint8 r, g, b, a;
+    };
+    struct TrailVertex {
+        float x, y;
+        float time;                 // Seconds since m_epochMs
+        float slot;
+    };
+    struct AtlasGlyph {
+        QRectF uv;
+        QSizeF size;                // Logical pixels
+        float advance = 0.0f;
+    };
+    struct Trail {
+        int slot = -1;
+        QPointF last;
+        float lastTime = 0.0f;
+        bool hasLast = false;
+    };
+
+    void releaseGL();
+    bool buildPrograms();
+    std::unique_ptr<QOpenGLShaderProgram> buildProgram(const char* vertex, const char* fragment,
+                                                       const QVector<QByteArray>& attributes);
+    void buildAtlas();
+    void uploadScene();
+    void uploadTrails();
+    void uploadVideo();
+    void drawVideo(const QVector2D& viewport, float now);
+    void updatePalette();
+    void appendSegment(const QPointF& from, const QPointF& to, double width, const QColor& color);
+    int takeSlot();
+    void expireTrails(float now);
+    // From a baseline start, or centred on origin
+    void appendText(const QString& text, const QPointF& origin, const QColor& color, bool centred = false);
+    float secondsSinceEpoch(qint64 ms) const { return float((ms - m_epochMs) / 1000.0); }
+
+    bool m_usable = false;
+    bool m_failed = false;
+    qint64 m_epochMs = 0;
+
+    // Scene, rebuilt by setGlyphs()
+    QVector<TrackGlyph> m_glyphs;
+    QVector<SymbolInstance> m_symbols;
+    QVector<GlyphInstance> m_text;
+    QVector<FlatVertex> m_vectors;
+    bool m_sceneDirty = true;
+
+    // Label atlas
+    QFont m_labelFont;
+    QImage m_atlasImage;
+    QHash<QChar, AtlasGlyph> m_atlasGlyphs;
+    qreal m_atlasRatio = 0.0;
+    float m_atlasAscent = 0.0f;
+    float m_atlasDescent = 0.0f;
+    bool m_atlasDirty = true;
+
+    // Trails
+    QVector<TrailVertex> m_trailVertices;   // Segments, oldest first from m_trailStart
+    int m_trailStart = 0;
+    int m_trailUploaded = 0;                // Vertices the buffer holds
+    bool m_trailReupload = true;
+    QHash<quint64, Trail> m_trails;
+    QVector<QRgb> m_palette;                // By slot; transparent when unused
+    QVector<QPair<int, float>> m_retiredSlots;  // Free once their segments expire
+    QVector<int> m_freeSlots;
+    bool m_paletteDirty = true;
+    QTransform m_trailTransform;            // Trail coordinates to widget pixels
+    int m_trailWindowSeconds = 30;
+    bool m_trailsVisible = true;
+
+    // Radar video and sweep afterglow
+    std::shared_ptr<const RadarVideoRing> m_video;
+    RadarVideoRing::Update m_videoUpdate;   // Reused each frame
+    quint64 m_videoGeneration = 0;          // Of the rows the texture holds
+    QVector<float> m_videoRowTimes;         // Seconds since m_epochMs, by row
+    QTransform m_screenToVideo;
+    QColor m_videoColor = QColor(90, 255, 90);
+    float m_videoPersistenceS = 3.0f;
+    float m_videoGain = 1.0f;
+    QPointF m_sweepCenter;
+    float m_sweepRadius = 0.0f;
+    float m_sweepAngle = 0.0f;              // Radians
+    QColor m_sweepColor = QColor(Qt::transparent);
+
+    // GL objects
+    std::unique_ptr<QOpenGLShaderProgram> m_symbolProgram;
+    std::unique_ptr<QOpenGLShaderProgram> m_textProgram;
+    std::unique_ptr<QOpenGLShaderProgram> m_flatProgram;
+    std::unique_ptr<QOpenGLShaderProgram> m_trailProgram;
+    std::unique_ptr<QOpenGLShaderProgram> m_videoProgram;
+    std::unique_ptr<QOpenGLVertexArrayObject> m_vao;
+    QOpenGLBuffer m_quad;
+    QOpenGLBuffer m_symbolBuffer;
+    QOpenGLBuffer m_textBuffer;
+    QOpenGLBuffer m_vectorBuffer;
+    QOpenGLBuffer m_trailBuffer;
+    int m_trailCapacity = 0;                // Vertices allocated in m_trailBuffer
+    GLuint m_atlasTexture = 0;
+    GLuint m_paletteTexture = 0;
+    int m_paletteRows = 0;
+    GLuint m_videoTexture = 0;
+    GLuint m_videoTimeTexture = 0;
+    int m_videoRows = 0;                    // Geometry of m_videoTexture
+    int m_videoBins = 0;
+    bool m_desktop = true;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKGLVIEW_H
@@ -0,0 +1,245 @@
+#include "ui/TrackLayerRenderer.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
+#include <QElapsedTimer>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QThread>
+#include <QtMath>
+#include <cmath>
+
+namespace CounterUAS {
+
+TrackLayerRenderer::TrackLayerRenderer(QObject* parent)
+    : QObject(parent)
+{
+    m_thread = QThread::create([this]() { renderLoop(); });
+    m_thread->setObjectName("TrackLayerRenderer");
+    m_thread->start();
+}
+
+TrackLayerRenderer::~TrackLayerRenderer() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    m_thread->wait();
+    delete m_thread;
+}
+
+void TrackLayerRenderer::setMaxFps(int fps) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_maxFps = qBound(1, fps, 240);
+    }
+    m_wake.wakeAll();
+}
+
+int TrackLayerRenderer::maxFps() const {
+    QMutexLocker locker(&m_mutex);
+    return m_maxFps;
+}
+
+void TrackLayerRenderer::submit(TrackLayerFrame frame) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pending) ++m_stats.superseded;
+        m_next = std::move(frame);
+        m_pending = true;
+        ++m_stats.submitted;
+    }
+    m_wake.wakeAll();
+}
+
+bool TrackLayerRenderer::takeFrame(QImage& layer, QRegion& region) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_taken) return false;
+        // The GUI's old layer stays behind for the worker to paint over
+        layer.swap(m_finished);
+        region = m_finishedRegion;
+        m_taken = true;
+    }
+    m_wake.wakeAll();
+    return true;
+}
+
+TrackLayerRenderer::Stats TrackLayerRenderer::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void TrackLayerRenderer::renderLoop() {
+    ThreadPlacement::instance().enter(ThreadRole::Render);
+    QElapsedTimer sinceRender;
+
+    forever {
+        TrackLayerFrame frame;
+        QImage target;
+        qint64 intervalMs;
+        {
+            QMutexLocker locker(&m_mutex);
+            forever {
+                if (m_stopping) return;
+                intervalMs = 1000 / m_maxFps;
+                if (!m_pending || !m_taken) {
+                    m_wake.wait(&m_mutex);
+                    continue;
+                }
+                // Frames submitted while waiting out the interval replace this one
+                const qint64 waitMs = sinceRender.isValid() ? intervalMs - sinceRender.elapsed() : 0;
+                if (waitMs <= 0) break;
+                m_wake.wait(&m_mutex, ulong(waitMs));
+            }
+            frame = std::move(m_next);
+            m_next = TrackLayerFrame();
+            m_pending = false;
+            target = std::move(m_finished);
+            m_finished = QImage();
+        }
+
+        sinceRender.start();
+        const qint64 startNs = TimeUtils::monotonicNs();
+        render(frame, target);
+        const qint64 elapsedUs = (TimeUtils::monotonicNs() - startNs) / 1000;
+        ThreadPlacement::instance().reportCycle(ThreadRole::Render, elapsedUs, intervalMs * 1000);
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_finished = std::move(target);
+            m_finishedRegion = frame.region;
+            m_taken = false;
+            ++m_stats.rendered;
+            m_stats.lastRenderUs = elapsedUs;
+        }
+        emit frameReady();
+    }
+}
+
+void TrackLayerRenderer::render(const TrackLayerFrame& frame, QImage& target) {
+    const QSize pixels = frame.size * frame.devicePixelRatio;
+    if (target.size() != pixels || target.format() != QImage::Format_ARGB32_Premultiplied) {
+        target = QImage(pixels, QImage::Format_ARGB32_Premultiplied);
+    }
+    target.setDevicePixelRatio(frame.devicePixelRatio);
+    target.fill(Qt::transparent);
+    if (target.isNull()) return;
+
+    QPainter painter(&target);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setFont(frame.labelFont);
+    if (m_labelCacheFont != frame.labelFont) {
+        m_labelCache.clear();
+        m_labelCacheFont = frame.labelFont;
+    }
+
+    // Trails under every symbol, fading with age as drawTrackHistory() does
+    for (const TrackLayerTrail& trail : frame.trails) {
+        for (int i = 1; i < trail.points.size(); ++i) {
+            QColor lineColor = trail.color;
+            lineColor.setAlphaF(trail.intensity[i - 1] * 0.5);
+            painter.setPen(QPen(lineColor, 1));
+            painter.drawLine(trail.points[i - 1], trail.points[i]);
+        }
+        painter.setPen(Qt::NoPen);
+        for (int i = 0; i < trail.points.size(); ++i) {
+            QColor dotColor = trail.color;
+            dotColor.setAlphaF(trail.intensity[i] * 0.7);
+            painter.setBrush(dotColor);
+            painter.drawEllipse(trail.points[i], 2, 2);
+        }
+    }
+
+    const double ascent = QFontMetricsF(frame.labelFont).ascent();
+    QHash<QString, QStaticText> labels;
+    for (const TrackGlyph& glyph : frame.glyphs) {
+        drawGlyph(painter, glyph, ascent, labels);
+    }
+    m_labelCache.swap(labels);
+}
+
+void TrackLayerRenderer::drawGlyph(QPainter& painter, const TrackGlyph& glyph, double ascent,
+                                   QHash<QString, QStaticText>& labels) {
+    const QPointF pos = glyph.position;
+    const double size = glyph.size;
+
+    if (!glyph.velocity.isNull()) {
+        const QPointF head = pos + glyph.velocity;
+        painter.setPen(QPen(glyph.color, 2));
+        painter.drawLine(pos, head);
+        if (glyph.arrowHead) {
+            const double angle = std::atan2(glyph.velocity.y(), glyph.velocity.x());
+            const double arrowSize = 6.0;
+            const double arrowAngle = M_PI / 6;
+            QPolygonF arrow;
+            arrow << head
+                  << head - QPointF(arrowSize * std::cos(angle - arrowAngle), arrowSize * std::sin(angle - arrowAngle))
+                  << head - QPointF(arrowSize * std::cos(angle + arrowAngle), arrowSize * std::sin(angle + arrowAngle));
+            painter.setBrush(glyph.color);
+            painter.drawPolygon(arrow);
+        }
+    }
+
+    painter.setPen(QPen(glyph.color, glyph.lineWidth));
+    if (glyph.filled) {
+        painter.setBrush(QColor(glyph.color.red(), glyph.color.green(), glyph.color.blue(), 100));
+    } else {
+        painter.setBrush(Qt::NoBrush);
+    }
+    switch (glyph.shape) {
+        case TrackGlyphShape::Diamond: {
+            QPolygonF diamond;
+            diamond << QPointF(pos.x(), pos.y() - size)
+                    << QPointF(pos.x() + size, pos.y())
+                    << QPointF(pos.x(), pos.y() + size)
+                    << QPointF(pos.x() - size, pos.y());
+            painter.drawPolygon(diamond);
+            break;
+        }
+        case TrackGlyphShape::Circle:
+            painter.drawEllipse(pos, size, size);
+            break;
+        case TrackGlyphShape::Square:
+            painter.drawRect(QRectF(pos.x() - size, pos.y() - size, size * 2, size * 2));
+            break;
+    }
+    if (!glyph.symbolText.isEmpty()) {
+        painter.drawText(QRectF(pos.x() - size, pos.y() - size, size * 2, size * 2),
+                         Qt::AlignCenter, glyph.symbolText);
+    }
+
+    painter.setBrush(Qt::NoBrush);
+    if (glyph.selected) {
+        painter.setPen(QPen(Qt::white, 1, Qt::DashLine));
+        painter.drawEllipse(pos, size + 5, size + 5);
+    }
+    if (glyph.engaged) {
+        painter.setPen(QPen(Qt::red, 2));
+        painter.drawEllipse(pos, size + 8, size + 8);
+    }
+
+    if (glyph.label.isEmpty()) return;
+    if (!glyph.leader.isNull()) {
+        QColor leaderColor = glyph.labelColor;
+        leaderColor.setAlpha(160);
+        painter.setPen(QPen(leaderColor, 1));
+        painter.drawLine(glyph.leader);
+    }
+
+    // Text layout is the expensive part of a label; kept while the text is
+    auto label = labels.find(glyph.label);
+    if (label == labels.end()) {
+        QStaticText text = m_labelCache.value(glyph.label);
+        if (text.text() != glyph.label) {
+            text = QStaticText(glyph.label);
+            text.setTextFormat(Qt::PlainText);
+            text.prepare(QTransform(), painter.font());
+        }
+        label = labels.insert(glyph.label, text);
+    }
+    painter.setPen(glyph.labelColor);
+    painter.drawStaticText(pos + glyph.labelOffset - QPointF(0.0, ascent), *label);
+}
+
+} // namespace CounterUAS
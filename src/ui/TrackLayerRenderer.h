@@ -0,0 +1,119 @@
+#ifndef TRACKLAYERRENDERER_H
+#define TRACKLAYERRENDERER_H
+
+#include <QObject>
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QRegion>
+#include <QSize>
+#include <QStaticText>
+#include <QVector>
+#include <QWaitCondition>
+#include "ui/TrackGLView.h"
+
+class QPainter;
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief One track's history trail, in widget pixels
+ */
+struct TrackLayerTrail {
+    QColor color;
+    QVector<QPointF> points;        // Oldest first
+    QVector<float> intensity;       // Parallel to points: 1 new, 0 at the end of the window
+};
+
+/**
+ * @brief Everything a track layer shows, laid out on the GUI thread
+ */
+struct TrackLayerFrame {
+    QSize size;                     // Widget size; the image is this times the ratio
+    qreal devicePixelRatio = 1.0;
+    QFont labelFont;
+    QVector<TrackLayerTrail> trails;
+    QVector<TrackGlyph> glyphs;     // Drawn over every trail, in order
+    QRegion region;                 // What the glyphs and trails cover
+};
+
+/**
+ * @brief Paints a display's track layer on a thread of its own
+ *
+ * The GUI thread lays the tracks out (projection, declutter, picking
+ * index) and submits the result; the worker paints it with QPainter into
+ * a transparent image, the symbology PPIDisplayWidget's software backend
+ * draws, and emits frameReady(). Only the newest submitted frame is
+ * painted, at no more than maxFps, so a burst of pictures costs one
+ * render.
+ *
+ * The layer is double-buffered without copies: takeFrame() swaps the
+ * finished image with the one the GUI showed until then, which the worker
+ * paints next. Nothing is painted until the previous frame is taken,
+ * which keeps a hidden or busy widget from being rendered for.
+ *
+ * The worker enters ThreadRole::Render and reports each render's
+ * duration against the frame interval.
+ */
+class TrackLayerRenderer : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_MAX_FPS = 60;
+
+    explicit TrackLayerRenderer(QObject* parent = nullptr);
+    ~TrackLayerRenderer() override;
+
+    void setMaxFps(int fps);
+    int maxFps() const;
+
+    // Replaces any frame not yet started; returns at once
+    void submit(TrackLayerFrame frame);
+
+    // Swaps the newest finished layer into layer and gives back what it
+    // covers; false with both untouched when nothing new is finished
+    bool takeFrame(QImage& layer, QRegion& region);
+
+    struct Stats {
+        qint64 submitted = 0;
+        qint64 rendered = 0;
+        qint64 superseded = 0;      // Replaced before the worker reached them
+        qint64 lastRenderUs = 0;
+    };
+    Stats stats() const;
+
+signals:
+    // From the worker; connect queued
+    void frameReady();
+
+private:
+    void renderLoop();
+    void render(const TrackLayerFrame& frame, QImage& target);
+    // labels collects the prepared text this frame used, from m_labelCache
+    // where the text is unchanged
+    void drawGlyph(QPainter& painter, const TrackGlyph& glyph, double ascent,
+                   QHash<QString, QStaticText>& labels);
+
+    QThread* m_thread;
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+    int m_maxFps = DEFAULT_MAX_FPS;
+    bool m_pending = false;
+    TrackLayerFrame m_next;
+    bool m_taken = true;            // The last finished frame has gone to the GUI
+    QImage m_finished;              // Until taken; after, the image the worker paints next
+    QRegion m_finishedRegion;
+    Stats m_stats;
+
+    // Worker only
+    QHash<QString, QStaticText> m_labelCache;
+    QFont m_labelCacheFont;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKLAYERRENDERER_H
@@ -1,11 +1,12 @@
 #include "ui/TrackListWidget.h"
 #include "core/TrackManager.h"
+#include "core/TrackChangeThrottle.h"
+#include "ui/UIFrameScheduler.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
 #include <QVBoxLayout>
 #include <QHeaderView>
 #include <QLabel>
-#include <QBrush>
-#include <QtMath>
 
 namespace CounterUAS {
 
@@ -13,7 +14,8 @@ TrackListWidget::TrackListWidget(TrackManager* trackManager, QWidget* parent)
     : QWidget(parent)
     , m_trackManager(trackManager)
     , m_tableView(new QTableView(this))
-    , m_model(new QStandardItemModel(this))
+    , m_model(new TrackTableModel(this))
+    , m_proxy(new TrackTableProxyModel(this))
 {
     // Initialize default reference position (will be set by MainWindow)
     m_referencePosition.latitude = 0.0;
@@ -36,8 +38,10 @@ TrackListWidget::TrackListWidget(TrackManager* trackManager, QWidget* parent)
     
     layout->addWidget(m_tableView);
     
-    m_model->setHorizontalHeaderLabels({"ID", "Class", "Threat", "Range", "Azimuth", "Elevation", "Velocity", "Status"});
-    m_tableView->setModel(m_model);
+    m_proxy->setSourceModel(m_model);
+    m_tableView->setModel(m_proxy);
+    m_tableView->setSortingEnabled(true);
+    m_tableView->sortByColumn(TrackTableModel::ThreatColumn, Qt::DescendingOrder);
     m_tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_tableView->setSelectionMode(QAbstractItemView::SingleSelection);
     m_tableView->setAlternatingRowColors(true);
@@ -76,9 +80,9 @@ TrackListWidget::TrackListWidget(TrackManager* trackManager, QWidget* parent)
             this, &TrackListWidget::onSelectionChanged);
     
     if (m_trackManager) {
-        connect(m_trackManager, &TrackManager::trackCreated, this, &TrackListWidget::onTrackCreated);
-        connect(m_trackManager, &TrackManager::trackUpdated, this, &TrackListWidget::onTrackUpdated);
-        connect(m_trackManager, &TrackManager::trackDropped, this, &TrackListWidget::onTrackDropped);
+        m_changeThrottle = new TrackChangeThrottle(m_trackManager, m_updateRateHz, this);
+        connect(m_changeThrottle, &TrackChangeThrottle::tracksChanged, this, &TrackListWidget::onTracksChanged);
+        connect(m_trackManager, &TrackManager::trackHandleDropped, this, &TrackListWidget::onTrackDropped);
         Logger::instance().info("TrackListWidget", "Connected to TrackManager signals");
     } else {
         Logger::instance().warning("TrackListWidget", "No TrackManager provided");
@@ -87,286 +91,79 @@ TrackListWidget::TrackListWidget(TrackManager* trackManager, QWidget* parent)
 
 void TrackListWidget::setReferencePosition(const GeoPosition& pos) {
     m_referencePosition = pos;
-    
-    // Update range, azimuth, and elevation for all existing tracks
-    for (int i = 0; i < m_model->rowCount(); ++i) {
-        QString trackId = m_model->item(i, 0)->text();
-        Track* track = m_trackManager->track(trackId);
-        if (track) {
-            GeoPosition trackPos = track->position();
-            double range = track->distanceTo(m_referencePosition);
-            double azimuth = calculateAzimuth(m_referencePosition, trackPos);
-            double elevation = calculateElevation(m_referencePosition, trackPos);
-            m_model->item(i, 3)->setText(formatRange(range));
-            m_model->item(i, 4)->setText(formatAzimuth(azimuth));
-            m_model->item(i, 5)->setText(formatElevation(elevation));
-        }
-    }
+    m_model->setReferencePosition(pos);
 }
 
-QString TrackListWidget::formatRange(double rangeMeters) const {
-    if (rangeMeters < 1000.0) {
-        return QString("%1 m").arg(rangeMeters, 0, 'f', 0);
-    } else {
-        return QString("%1 km").arg(rangeMeters / 1000.0, 0, 'f', 2);
+void TrackListWidget::setUpdateRateHz(int hz) {
+    m_updateRateHz = hz;
+    if (m_changeThrottle) {
+        m_changeThrottle->setMaxRateHz(hz);
     }
-}
-
-QString TrackListWidget::formatAzimuth(double azimuthDegrees) const {
-    return QString("%1\u00B0").arg(azimuthDegrees, 0, 'f', 1);  // Unicode degree symbol
-}
-
-QString TrackListWidget::formatElevation(double elevationDegrees) const {
-    return QString("%1\u00B0").arg(elevationDegrees, 0, 'f', 1);  // Unicode degree symbol
-}
-
-QString TrackListWidget::formatVelocity(double velocityMps) const {
-    if (velocityMps < 1.0) {
-        return QString("%1 m/s").arg(velocityMps, 0, 'f', 2);
-    } else {
-        return QString("%1 m/s").arg(velocityMps, 0, 'f', 1);
+    if (m_frameScheduler) {
+        m_frameScheduler->setClientRate(this, hz);
     }
 }
 
-double TrackListWidget::calculateAzimuth(const GeoPosition& from, const GeoPosition& to) const {
-    // Calculate bearing from reference position to track
-    double lat1 = qDegreesToRadians(from.latitude);
-    double lat2 = qDegreesToRadians(to.latitude);
-    double dLon = qDegreesToRadians(to.longitude - from.longitude);
-    
-    double y = std::sin(dLon) * std::cos(lat2);
-    double x = std::cos(lat1) * std::sin(lat2) -
-               std::sin(lat1) * std::cos(lat2) * std::cos(dLon);
+void TrackListWidget::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+    if (!m_trackManager) return;
     
-    double bearing = qRadiansToDegrees(std::atan2(y, x));
-    if (bearing < 0) bearing += 360.0;
+    if (!m_frameScheduler) {
+        if (!m_changeThrottle) {
+            m_changeThrottle = new TrackChangeThrottle(m_trackManager, m_updateRateHz, this);
+            connect(m_changeThrottle, &TrackChangeThrottle::tracksChanged, this, &TrackListWidget::onTracksChanged);
+        }
+        return;
+    }
     
-    return bearing;
+    // The scheduler merges change sets per client, as the throttle did
+    delete m_changeThrottle;
+    m_changeThrottle = nullptr;
+    m_frameScheduler->addClient(this, m_updateRateHz, [this](const UIFrame& frame) {
+        if (frame.picture && !frame.changes.isEmpty()) {
+            m_model->applyChanges(frame.changes, *frame.picture);
+        }
+    });
+    m_frameScheduler->setClientTriggers(this, FrameOnTracks);
 }
 
-double TrackListWidget::calculateElevation(const GeoPosition& from, const GeoPosition& to) const {
-    // Calculate horizontal distance using Haversine formula
-    const double R = 6371000.0; // Earth radius in meters
-    
-    double lat1 = qDegreesToRadians(from.latitude);
-    double lat2 = qDegreesToRadians(to.latitude);
-    double dLat = lat2 - lat1;
-    double dLon = qDegreesToRadians(to.longitude - from.longitude);
-    
-    double a = std::sin(dLat/2) * std::sin(dLat/2) +
-               std::cos(lat1) * std::cos(lat2) *
-               std::sin(dLon/2) * std::sin(dLon/2);
-    double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1-a));
-    
-    double horizontalDist = R * c;
-    double verticalDist = to.altitude - from.altitude;
-    
-    // Calculate elevation angle (positive is above horizon, negative is below)
-    if (horizontalDist < 0.001) {  // Very close, avoid division by near-zero
-        return verticalDist > 0 ? 90.0 : (verticalDist < 0 ? -90.0 : 0.0);
-    }
-    
-    return qRadiansToDegrees(std::atan2(verticalDist, horizontalDist));
+void TrackListWidget::setResortIntervalMs(int ms) {
+    m_proxy->setResortIntervalMs(ms);
 }
 
-void TrackListWidget::onTrackCreated(const QString& trackId) {
-    Track* track = m_trackManager->track(trackId);
-    if (!track) {
-        Logger::instance().warning("TrackListWidget", 
-            QString("onTrackCreated: Track %1 not found").arg(trackId));
-        return;
-    }
-    
-    // Calculate range, azimuth, and elevation from reference position
-    GeoPosition trackPos = track->position();
-    double range = track->distanceTo(m_referencePosition);
-    double azimuth = calculateAzimuth(m_referencePosition, trackPos);
-    double elevation = calculateElevation(m_referencePosition, trackPos);
-    double velocity = track->velocity().speed();
-    
-    QList<QStandardItem*> row;
-    
-    // ID column
-    QStandardItem* idItem = new QStandardItem(trackId);
-    idItem->setData(trackId, Qt::UserRole);  // Store track ID for lookup
-    row << idItem;
-    
-    // Classification column with color coding
-    QStandardItem* classItem = new QStandardItem(track->classificationString());
-    TrackClassification cls = track->classification();
-    if (cls == TrackClassification::Hostile) {
-        classItem->setForeground(QColor(255, 80, 80));  // Red for hostile
-    } else if (cls == TrackClassification::Friendly) {
-        classItem->setForeground(QColor(80, 200, 80));  // Green for friendly
-    } else if (cls == TrackClassification::Neutral) {
-        classItem->setForeground(QColor(200, 200, 80)); // Yellow for neutral
-    } else {
-        classItem->setForeground(QColor(180, 180, 180)); // Gray for pending/unknown
-    }
-    row << classItem;
-    
-    // Threat level column with color coding
-    int threatLevel = track->threatLevel();
-    QStandardItem* threatItem = new QStandardItem(QString::number(threatLevel));
-    if (threatLevel >= 4) {
-        threatItem->setForeground(QColor(255, 50, 50));   // High threat - red
-        threatItem->setBackground(QColor(80, 20, 20));
-    } else if (threatLevel >= 3) {
-        threatItem->setForeground(QColor(255, 150, 50));  // Medium threat - orange
-    } else if (threatLevel >= 2) {
-        threatItem->setForeground(QColor(255, 255, 80));  // Low threat - yellow
-    } else {
-        threatItem->setForeground(QColor(150, 150, 150)); // Minimal threat - gray
-    }
-    threatItem->setTextAlignment(Qt::AlignCenter);
-    row << threatItem;
-    
-    // Range column
-    QStandardItem* rangeItem = new QStandardItem(formatRange(range));
-    rangeItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-    row << rangeItem;
-    
-    // Azimuth column
-    QStandardItem* azimuthItem = new QStandardItem(formatAzimuth(azimuth));
-    azimuthItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-    row << azimuthItem;
-    
-    // Elevation column
-    QStandardItem* elevationItem = new QStandardItem(formatElevation(elevation));
-    elevationItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-    row << elevationItem;
-    
-    // Velocity column
-    QStandardItem* velocityItem = new QStandardItem(formatVelocity(velocity));
-    velocityItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-    row << velocityItem;
-    
-    // Status column with color coding
-    QStandardItem* statusItem = new QStandardItem(track->stateString());
-    TrackState state = track->state();
-    if (state == TrackState::Active) {
-        statusItem->setForeground(QColor(80, 200, 80));   // Green for active
-    } else if (state == TrackState::Coasting) {
-        statusItem->setForeground(QColor(200, 200, 80)); // Yellow for coasting
-    } else if (state == TrackState::Initiated) {
-        statusItem->setForeground(QColor(100, 150, 255)); // Blue for initiated
-    } else {
-        statusItem->setForeground(QColor(120, 120, 120)); // Gray for dropped
-    }
-    row << statusItem;
-    
-    m_model->appendRow(row);
-    
-    Logger::instance().debug("TrackListWidget", 
-        QString("Added track %1 to list (Class: %2, Threat: %3, Range: %4, Az: %5, El: %6, Vel: %7)")
-            .arg(trackId)
-            .arg(track->classificationString())
-            .arg(threatLevel)
-            .arg(formatRange(range))
-            .arg(formatAzimuth(azimuth))
-            .arg(formatElevation(elevation))
-            .arg(formatVelocity(velocity)));
+void TrackListWidget::setMinimumThreatLevel(int level) {
+    m_proxy->setMinimumThreatLevel(level);
 }
 
-void TrackListWidget::onTrackUpdated(const QString& trackId) {
-    updateTrackRow(trackId);
+void TrackListWidget::setIdFilter(const QString& text) {
+    m_proxy->setFilterFixedString(text);
 }
 
-void TrackListWidget::onTrackDropped(const QString& trackId) {
-    int row = findTrackRow(trackId);
-    if (row >= 0) {
-        m_model->removeRow(row);
-    }
+void TrackListWidget::onTracksChanged(const TrackChangeSet& changes) {
+    CUAS_TRACE_SCOPE("ui", "TrackListWidget::onTracksChanged");
+    // Read from the published picture rather than the live Track objects,
+    // so rows are created here, once the track is visible in a snapshot.
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    m_model->applyChanges(changes, *picture);
+}
+
+void TrackListWidget::onTrackDropped(TrackHandle handle) {
+    m_model->removeTrack(handle);
 }
 
 void TrackListWidget::onSelectionChanged() {
     QModelIndexList selected = m_tableView->selectionModel()->selectedRows();
     if (!selected.isEmpty()) {
-        QString trackId = m_model->item(selected.first().row(), 0)->text();
-        emit trackSelected(trackId);
-    }
-}
-
-void TrackListWidget::updateTrackRow(const QString& trackId) {
-    int row = findTrackRow(trackId);
-    if (row < 0) return;
-    
-    Track* track = m_trackManager->track(trackId);
-    if (!track) return;
-    
-    // Calculate range, azimuth, elevation, and velocity from reference position
-    GeoPosition trackPos = track->position();
-    double range = track->distanceTo(m_referencePosition);
-    double azimuth = calculateAzimuth(m_referencePosition, trackPos);
-    double elevation = calculateElevation(m_referencePosition, trackPos);
-    double velocity = track->velocity().speed();
-    
-    // Update classification with color coding
-    QStandardItem* classItem = m_model->item(row, 1);
-    classItem->setText(track->classificationString());
-    TrackClassification cls = track->classification();
-    if (cls == TrackClassification::Hostile) {
-        classItem->setForeground(QColor(255, 80, 80));
-    } else if (cls == TrackClassification::Friendly) {
-        classItem->setForeground(QColor(80, 200, 80));
-    } else if (cls == TrackClassification::Neutral) {
-        classItem->setForeground(QColor(200, 200, 80));
-    } else {
-        classItem->setForeground(QColor(180, 180, 180));
-    }
-    
-    // Update threat level with color coding
-    int threatLevel = track->threatLevel();
-    QStandardItem* threatItem = m_model->item(row, 2);
-    threatItem->setText(QString::number(threatLevel));
-    if (threatLevel >= 4) {
-        threatItem->setForeground(QColor(255, 50, 50));
-        threatItem->setBackground(QColor(80, 20, 20));
-    } else if (threatLevel >= 3) {
-        threatItem->setForeground(QColor(255, 150, 50));
-        threatItem->setBackground(QBrush());  // Clear background
-    } else if (threatLevel >= 2) {
-        threatItem->setForeground(QColor(255, 255, 80));
-        threatItem->setBackground(QBrush());
-    } else {
-        threatItem->setForeground(QColor(150, 150, 150));
-        threatItem->setBackground(QBrush());
-    }
-    
-    // Update range
-    m_model->item(row, 3)->setText(formatRange(range));
-    
-    // Update azimuth
-    m_model->item(row, 4)->setText(formatAzimuth(azimuth));
-    
-    // Update elevation
-    m_model->item(row, 5)->setText(formatElevation(elevation));
-    
-    // Update velocity
-    m_model->item(row, 6)->setText(formatVelocity(velocity));
-    
-    // Update status with color coding
-    QStandardItem* statusItem = m_model->item(row, 7);
-    statusItem->setText(track->stateString());
-    TrackState state = track->state();
-    if (state == TrackState::Active) {
-        statusItem->setForeground(QColor(80, 200, 80));
-    } else if (state == TrackState::Coasting) {
-        statusItem->setForeground(QColor(200, 200, 80));
-    } else if (state == TrackState::Initiated) {
-        statusItem->setForeground(QColor(100, 150, 255));
-    } else {
-        statusItem->setForeground(QColor(120, 120, 120));
+        emit trackSelected(trackIdAt(selected.first()));
     }
 }
 
-int TrackListWidget::findTrackRow(const QString& trackId) {
-    for (int i = 0; i < m_model->rowCount(); ++i) {
-        if (m_model->item(i, 0)->text() == trackId) {
-            return i;
-        }
-    }
-    return -1;
+QString TrackListWidget::trackIdAt(const QModelIndex& proxyIndex) const {
+    const TrackSnapshot* track = m_model->trackAt(m_proxy->mapToSource(proxyIndex).row());
+    return track ? track->trackId : QString();
 }
 
 } // namespace CounterUAS
@@ -3,12 +3,16 @@
 
 #include <QWidget>
 #include <QTableView>
-#include <QStandardItemModel>
 #include "core/Track.h"
+#include "core/TrackHandle.h"
+#include "core/TrackChangeSet.h"
+#include "ui/TrackTableModel.h"
 
 namespace CounterUAS {
 
 class TrackManager;
+class TrackChangeThrottle;
+class UIFrameScheduler;
 
 class TrackListWidget : public QWidget {
     Q_OBJECT
@@ -20,29 +24,36 @@ public:
     void setReferencePosition(const GeoPosition& pos);
     GeoPosition referencePosition() const { return m_referencePosition; }
     
+    // Maximum rate at which changed rows are refreshed
+    void setUpdateRateHz(int hz);
+    
+    // Rows refresh on the scheduler's ticks instead of through a throttle
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+    
+    // Rows are re-sorted and re-filtered at most this often
+    void setResortIntervalMs(int ms);
+    void setMinimumThreatLevel(int level);
+    void setIdFilter(const QString& text);
+    
 signals:
     void trackSelected(const QString& trackId);
     void trackDoubleClicked(const QString& trackId);
     
 private slots:
-    void onTrackCreated(const QString& trackId);
-    void onTrackUpdated(const QString& trackId);
-    void onTrackDropped(const QString& trackId);
+    void onTracksChanged(const TrackChangeSet& changes);
+    void onTrackDropped(TrackHandle handle);
     void onSelectionChanged();
     
 private:
-    void updateTrackRow(const QString& trackId);
-    int findTrackRow(const QString& trackId);
-    QString formatRange(double rangeMeters) const;
-    QString formatAzimuth(double azimuthDegrees) const;
-    QString formatElevation(double elevationDegrees) const;
-    QString formatVelocity(double velocityMps) const;
-    double calculateAzimuth(const GeoPosition& from, const GeoPosition& to) const;
-    double calculateElevation(const GeoPosition& from, const GeoPosition& to) const;
+    QString trackIdAt(const QModelIndex& proxyIndex) const;
     
     TrackManager* m_trackManager;
+    TrackChangeThrottle* m_changeThrottle = nullptr;
+    UIFrameScheduler* m_frameScheduler = nullptr;
+    int m_updateRateHz = 4;
     QTableView* m_tableView;
-    QStandardItemModel* m_model;
+    TrackTableModel* m_model;
+    TrackTableProxyModel* m_proxy;
     GeoPosition m_referencePosition;  // Reference point for range calculation
 };
 
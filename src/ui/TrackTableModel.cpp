@@ -0,0 +1,286 @@
+#include "ui/TrackTableModel.h"
+#include <QBrush>
+#include <QColor>
+#include <QTimer>
+#include <QtMath>
+
+namespace CounterUAS {
+
+TrackTableModel::TrackTableModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int TrackTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int TrackTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TrackTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+    const Row& row = m_rows[index.row()];
+    const int column = index.column();
+
+    switch (role) {
+        case Qt::DisplayRole:
+            return displayData(row, column);
+        case Qt::ForegroundRole:
+            return foreground(row, column);
+        case Qt::BackgroundRole:
+            if (column == ThreatColumn && row.track.threatLevel >= 4) {
+                return QBrush(QColor(80, 20, 20));
+            }
+            return QVariant();
+        case Qt::TextAlignmentRole:
+            if (column == ThreatColumn) return int(Qt::AlignCenter);
+            if (column >= RangeColumn && column <= VelocityColumn) {
+                return int(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            return QVariant();
+        case HandleRole:
+            return row.track.handle;
+        case SortRole:
+            return sortData(row, column);
+        default:
+            return QVariant();
+    }
+}
+
+QVariant TrackTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const char* const headers[ColumnCount] = {
+        "ID", "Class", "Threat", "Range", "Azimuth", "Elevation", "Velocity", "Status"
+    };
+    return section >= 0 && section < ColumnCount ? QString(headers[section]) : QVariant();
+}
+
+void TrackTableModel::setReferencePosition(const GeoPosition& pos) {
+    m_reference.setOrigin(pos);
+    if (m_rows.isEmpty()) return;
+
+    for (Row& row : m_rows) {
+        updateGeometry(row);
+    }
+    emit dataChanged(index(0, RangeColumn), index(m_rows.size() - 1, ElevationColumn),
+                     {Qt::DisplayRole, SortRole});
+}
+
+void TrackTableModel::applyChanges(const TrackChangeSet& changes, const TrackPicture& picture) {
+    int firstChanged = m_rows.size();
+    int lastChanged = -1;
+    QVector<Row> added;
+
+    for (int i = 0; i < changes.size(); ++i) {
+        if (changes.fields[i] & TrackChangeDropped) continue;
+
+        const TrackSnapshot* track = picture.find(changes.handles[i]);
+        if (!track) continue;
+
+        const int rowIndex = rowOf(track->handle);
+        if (rowIndex < 0) {
+            Row row;
+            row.track = *track;
+            updateGeometry(row);
+            added.append(row);
+            continue;
+        }
+
+        Row& row = m_rows[rowIndex];
+        row.track = *track;
+        updateGeometry(row);
+        firstChanged = qMin(firstChanged, rowIndex);
+        lastChanged = qMax(lastChanged, rowIndex);
+    }
+
+    if (lastChanged >= 0) {
+        emit dataChanged(index(firstChanged, 0), index(lastChanged, ColumnCount - 1));
+    }
+
+    if (!added.isEmpty()) {
+        const int first = m_rows.size();
+        beginInsertRows(QModelIndex(), first, first + added.size() - 1);
+        for (const Row& row : added) {
+            m_rowByHandle.insert(row.track.handle, m_rows.size());
+            m_rows.append(row);
+        }
+        endInsertRows();
+    }
+}
+
+void TrackTableModel::removeTrack(TrackHandle handle) {
+    const int rowIndex = rowOf(handle);
+    if (rowIndex < 0) return;
+
+    beginRemoveRows(QModelIndex(), rowIndex, rowIndex);
+    m_rows.remove(rowIndex);
+    m_rowByHandle.remove(handle);
+    for (int i = rowIndex; i < m_rows.size(); ++i) {
+        m_rowByHandle[m_rows[i].track.handle] = i;
+    }
+    endRemoveRows();
+}
+
+void TrackTableModel::clear() {
+    if (m_rows.isEmpty()) return;
+    beginResetModel();
+    m_rows.clear();
+    m_rowByHandle.clear();
+    endResetModel();
+}
+
+const TrackSnapshot* TrackTableModel::trackAt(int row) const {
+    return row >= 0 && row < m_rows.size() ? &m_rows[row].track : nullptr;
+}
+
+void TrackTableModel::updateGeometry(Row& row) const {
+    const EnuVector enu = m_reference.toEnu(row.track.position);
+    row.range = enu.range();
+    row.azimuth = enu.azimuthDeg();
+    row.elevation = enu.elevationDeg();
+    row.speed = row.track.velocity.speed();
+}
+
+QVariant TrackTableModel::displayData(const Row& row, int column) const {
+    switch (column) {
+        case IdColumn:        return row.track.trackId;
+        case ClassColumn:     return Track::classificationToString(row.track.classification);
+        case ThreatColumn:    return QString::number(row.track.threatLevel);
+        case RangeColumn:     return formatRange(row.range);
+        case AzimuthColumn:   return formatAngle(row.azimuth);
+        case ElevationColumn: return formatAngle(row.elevation);
+        case VelocityColumn:  return formatVelocity(row.speed);
+        case StatusColumn:    return Track::stateToString(row.track.state);
+        default:              return QVariant();
+    }
+}
+
+QVariant TrackTableModel::sortData(const Row& row, int column) const {
+    switch (column) {
+        case ClassColumn:     return static_cast<int>(row.track.classification);
+        case ThreatColumn:    return row.track.threatLevel;
+        case RangeColumn:     return row.range;
+        case AzimuthColumn:   return row.azimuth;
+        case ElevationColumn: return row.elevation;
+        case VelocityColumn:  return row.speed;
+        case StatusColumn:    return static_cast<int>(row.track.state);
+        default:              return displayData(row, column);
+    }
+}
+
+QVariant TrackTableModel::foreground(const Row& row, int column) {
+    switch (column) {
+        case ClassColumn:
+            switch (row.track.classification) {
+                case TrackClassification::Hostile:  return QBrush(QColor(255, 80, 80));
+                case TrackClassification::Friendly: return QBrush(QColor(80, 200, 80));
+                case TrackClassification::Neutral:  return QBrush(QColor(200, 200, 80));
+                default:                            return QBrush(QColor(180, 180, 180));
+            }
+        case ThreatColumn:
+            if (row.track.threatLevel >= 4) return QBrush(QColor(255, 50, 50));
+            if (row.track.threatLevel >= 3) return QBrush(QColor(255, 150, 50));
+            if (row.track.threatLevel >= 2) return QBrush(QColor(255, 255, 80));
+            return QBrush(QColor(150, 150, 150));
+        case StatusColumn:
+            switch (row.track.state) {
+                case TrackState::Active:    return QBrush(QColor(80, 200, 80));
+                case TrackState::Coasting:  return QBrush(QColor(200, 200, 80));
+                case TrackState::Initiated: return QBrush(QColor(100, 150, 255));
+                default:                    return QBrush(QColor(120, 120, 120));
+            }
+        default:
+            return QVariant();
+    }
+}
+
+QString TrackTableModel::formatRange(double rangeMeters) {
+    if (rangeMeters < 1000.0) {
+        return QString("%1 m").arg(rangeMeters, 0, 'f', 0);
+    } else {
+        return QString("%1 km").arg(rangeMeters / 1000.0, 0, 'f', 2);
+    }
+}
+
+QString TrackTableModel::formatAngle(double degrees) {
+    return QString("%1\u00B0").arg(degrees, 0, 'f', 1);  // Unicode degree symbol
+}
+
+QString TrackTableModel::formatVelocity(double velocityMps) {
+    if (velocityMps < 1.0) {
+        return QString("%1 m/s").arg(velocityMps, 0, 'f', 2);
+    } else {
+        return QString("%1 m/s").arg(velocityMps, 0, 'f', 1);
+    }
+}
+
+double TrackTableModel::elevationAngle(const GeoPosition& from, const GeoPosition& to) {
+    // Positive is above the local horizontal at from, negative below
+    return LocalTangentPlane(from).toEnu(to).elevationDeg();
+}
+
+TrackTableProxyModel::TrackTableProxyModel(QObject* parent)
+    : QSortFilterProxyModel(parent)
+    , m_resortTimer(new QTimer(this))
+{
+    setDynamicSortFilter(false);
+    setSortRole(TrackTableModel::SortRole);
+    setFilterKeyColumn(TrackTableModel::IdColumn);
+    setFilterCaseSensitivity(Qt::CaseInsensitive);
+
+    m_resortTimer->setSingleShot(true);
+    m_resortTimer->setInterval(1000);
+    connect(m_resortTimer, &QTimer::timeout, this, &TrackTableProxyModel::resort);
+}
+
+void TrackTableProxyModel::setSourceModel(QAbstractItemModel* sourceModel) {
+    if (QAbstractItemModel* previous = this->sourceModel()) {
+        disconnect(previous, nullptr, this, nullptr);
+    }
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+    if (!sourceModel) return;
+
+    connect(sourceModel, &QAbstractItemModel::dataChanged, this, &TrackTableProxyModel::scheduleResort);
+    connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &TrackTableProxyModel::scheduleResort);
+}
+
+void TrackTableProxyModel::setResortIntervalMs(int ms) {
+    m_resortTimer->setInterval(qMax(0, ms));
+}
+
+int TrackTableProxyModel::resortIntervalMs() const {
+    return m_resortTimer->interval();
+}
+
+void TrackTableProxyModel::setMinimumThreatLevel(int level) {
+    if (m_minimumThreatLevel == level) return;
+    m_minimumThreatLevel = level;
+    invalidateFilter();
+}
+
+bool TrackTableProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const {
+    if (m_minimumThreatLevel > 0) {
+        const QModelIndex threat = sourceModel()->index(sourceRow, TrackTableModel::ThreatColumn, sourceParent);
+        if (threat.data(TrackTableModel::SortRole).toInt() < m_minimumThreatLevel) return false;
+    }
+    return QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent);
+}
+
+void TrackTableProxyModel::scheduleResort() {
+    // Changes during the interval are folded into the one pending pass
+    if (!m_resortTimer->isActive()) {
+        m_resortTimer->start();
+    }
+}
+
+void TrackTableProxyModel::resort() {
+    // Re-filters, then re-sorts on the current sort column; selections
+    // and persistent indexes follow their rows
+    invalidate();
+}
+
+} // namespace CounterUAS
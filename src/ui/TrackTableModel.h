@@ -0,0 +1,130 @@
+#ifndef TRACKTABLEMODEL_H
+#define TRACKTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QSortFilterProxyModel>
+#include <QHash>
+#include <QVector>
+#include "core/Track.h"
+#include "core/TrackHandle.h"
+#include "core/TrackChangeSet.h"
+#include "core/TrackSnapshot.h"
+#include "utils/LocalTangentPlane.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+/**
+ * @brief The track list as a table, one row per track snapshot
+ *
+ * Rows hold the snapshot the table last saw for each track, with range,
+ * azimuth and elevation from the reference position worked out when the
+ * row changes rather than on every paint. Text, colours and sort keys
+ * are derived in data(). A handle finds its row through a hash; rows are
+ * appended in arrival order and only a drop shifts the rows after it.
+ *
+ * applyChanges() takes one throttled change set and announces it with a
+ * single dataChanged() spanning the rows it touched, followed by one
+ * insertion for the tracks that are new.
+ */
+class TrackTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        IdColumn,
+        ClassColumn,
+        ThreatColumn,
+        RangeColumn,
+        AzimuthColumn,
+        ElevationColumn,
+        VelocityColumn,
+        StatusColumn,
+        ColumnCount
+    };
+
+    enum Role {
+        HandleRole = Qt::UserRole,     // TrackHandle of the row
+        SortRole                       // Numeric value to order the column by
+    };
+
+    explicit TrackTableModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void setReferencePosition(const GeoPosition& pos);
+
+    // Creates rows for new tracks and refreshes changed ones from picture
+    void applyChanges(const TrackChangeSet& changes, const TrackPicture& picture);
+    void removeTrack(TrackHandle handle);
+    void clear();
+
+    int rowOf(TrackHandle handle) const { return m_rowByHandle.value(handle, -1); }
+    const TrackSnapshot* trackAt(int row) const;
+
+    static QString formatRange(double rangeMeters);
+    static QString formatAngle(double degrees);
+    static QString formatVelocity(double velocityMps);
+    static double elevationAngle(const GeoPosition& from, const GeoPosition& to);
+
+private:
+    struct Row {
+        TrackSnapshot track;
+        double range = 0.0;
+        double azimuth = 0.0;
+        double elevation = 0.0;
+        double speed = 0.0;
+    };
+
+    void updateGeometry(Row& row) const;
+    QVariant displayData(const Row& row, int column) const;
+    QVariant sortData(const Row& row, int column) const;
+    static QVariant foreground(const Row& row, int column);
+
+    QVector<Row> m_rows;
+    QHash<TrackHandle, int> m_rowByHandle;
+    LocalTangentPlane m_reference;   // Range, azimuth and elevation are measured from its origin
+};
+
+/**
+ * @brief Sorting and filtering over a TrackTableModel, re-sorted at a fixed rate
+ *
+ * Dynamic sorting is off, so row updates arriving several times a second
+ * neither move rows under the operator's cursor nor cost a sort each.
+ * Changes in the source start a timer instead, and the order and filter
+ * are brought up to date once it runs out. New tracks show at the bottom
+ * until then. Clicking a header sorts at once.
+ */
+class TrackTableProxyModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+public:
+    explicit TrackTableProxyModel(QObject* parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+    void setResortIntervalMs(int ms);
+    int resortIntervalMs() const;
+
+    // Hides tracks below this threat level; 0 shows all
+    void setMinimumThreatLevel(int level);
+    int minimumThreatLevel() const { return m_minimumThreatLevel; }
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+
+private:
+    void scheduleResort();
+    void resort();
+
+    QTimer* m_resortTimer;
+    int m_minimumThreatLevel = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKTABLEMODEL_H
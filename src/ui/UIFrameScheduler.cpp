@@ -0,0 +1,254 @@
+#include "ui/UIFrameScheduler.h"
+#include "core/TrackManager.h"
+#include "utils/OverloadController.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
+#include <QDateTime>
+#include <QScreen>
+#include <QTimer>
+#include <algorithm>
+
+namespace CounterUAS {
+
+UIFrameScheduler::UIFrameScheduler(TrackManager* trackManager, QWidget* window, QObject* parent)
+    : QObject(parent)
+    , m_trackManager(trackManager)
+    , m_window(window)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &UIFrameScheduler::tick);
+
+    if (m_trackManager) {
+        connect(m_trackManager, &TrackManager::tracksChanged, this, &UIFrameScheduler::onTracksChanged);
+        m_picture = m_trackManager->snapshot();
+    }
+    connect(&StatusBoard::instance(), &StatusBoard::published, this, &UIFrameScheduler::onStatusPublished);
+    updateInterval();
+}
+
+void UIFrameScheduler::addClient(QWidget* widget, int maxRateHz, FrameCallback callback) {
+    if (!widget || !callback) return;
+    removeClient(widget);
+
+    Client client;
+    client.widget = widget;
+    client.callback = std::move(callback);
+    client.maxRateHz = qMax(0, maxRateHz);
+    client.lastFrameMs = QDateTime::currentMSecsSinceEpoch();
+    m_clients.append(client);
+
+    connect(widget, &QObject::destroyed, this, [this]() {
+        // The QPointer has cleared by now
+        m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(),
+                                       [](const Client& c) { return c.widget.isNull(); }),
+                        m_clients.end());
+    });
+    wake();
+}
+
+void UIFrameScheduler::removeClient(QWidget* widget) {
+    for (int i = 0; i < m_clients.size(); ++i) {
+        if (m_clients[i].widget == widget) {
+            disconnect(widget, &QObject::destroyed, this, nullptr);
+            m_clients.remove(i);
+            return;
+        }
+    }
+}
+
+void UIFrameScheduler::setClientRate(QWidget* widget, int maxRateHz) {
+    for (Client& client : m_clients) {
+        if (client.widget == widget) {
+            client.maxRateHz = qMax(0, maxRateHz);
+            wake();
+            return;
+        }
+    }
+}
+
+void UIFrameScheduler::setClientTriggers(QWidget* widget, quint8 triggers, quint32 statusKinds) {
+    for (Client& client : m_clients) {
+        if (client.widget == widget) {
+            client.triggers = triggers ? triggers : quint8(FrameEveryTick);
+            client.statusKinds = statusKinds;
+            // A first frame with everything of its kinds to populate from
+            client.statusSeen = 0;
+            client.status.clear();
+            client.primed = false;
+            wake();
+            return;
+        }
+    }
+}
+
+void UIFrameScheduler::setIdleRateHz(int hz) {
+    m_idleRateHz = qMax(1, hz);
+    updateInterval();
+    wake();
+}
+
+void UIFrameScheduler::setRateCapHz(int hz) {
+    m_rateCapHz = qMax(0, hz);
+    updateInterval();
+    wake();
+}
+
+void UIFrameScheduler::start() {
+    m_running = true;
+    updateInterval();
+    m_timer->start(m_activeIntervalMs);
+}
+
+void UIFrameScheduler::stop() {
+    m_running = false;
+    m_timer->stop();
+}
+
+bool UIFrameScheduler::isSleeping() const {
+    return m_running && (!m_timer->isActive() || m_timer->interval() > m_activeIntervalMs);
+}
+
+void UIFrameScheduler::onTracksChanged(const TrackChangeSet& changes) {
+    m_pending.merge(changes);
+    wake();
+}
+
+void UIFrameScheduler::onStatusPublished() {
+    wake();
+}
+
+void UIFrameScheduler::wake() {
+    if (m_running && isSleeping()) {
+        m_timer->start(m_activeIntervalMs);
+    }
+}
+
+void UIFrameScheduler::tick() {
+    const qint64 tickStartNs = TimeUtils::monotonicNs();
+    updateInterval();
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    ++m_frameIndex;
+
+    // One picture for every client this tick
+    if (m_trackManager) {
+        TrackPicturePtr latest = m_trackManager->snapshot();
+        if (!m_picture || latest->sequence != m_picture->sequence) {
+            m_picture = latest;
+        }
+    }
+
+    // Callbacks may add or remove clients, so index rather than iterate
+    const int clientCount = m_clients.size();
+    for (int i = 0; i < clientCount && i < m_clients.size(); ++i) {
+        Client& client = m_clients[i];
+        if (client.widget.isNull()) continue;
+
+        if (client.triggers & (FrameOnTracks | FrameEveryTick)) {
+            client.pending.merge(m_pending);
+        }
+        if (!isDue(client, now)) continue;
+        const quint64 statusSince = client.statusSeen;
+        if (!wantsFrame(client)) continue;
+
+        UIFrame frame;
+        frame.index = m_frameIndex;
+        frame.timestampMs = now;
+        frame.intervalS = (now - client.lastFrameMs) / 1000.0;
+        frame.picture = m_picture;
+        frame.changes = std::move(client.pending);
+        frame.status = std::move(client.status);
+        frame.statusSince = statusSince;
+        client.pending = TrackChangeSet();
+        client.status.clear();
+        client.lastFrameMs = now;
+        client.primed = true;
+
+        const FrameCallback callback = client.callback;   // Survives a removal from inside it
+        callback(frame);
+    }
+    m_pending.clear();
+    const qint64 tickUs = (TimeUtils::monotonicNs() - tickStartNs) / 1000;
+    ThreadPlacement::instance().reportCycle(ThreadRole::Render, tickUs, m_activeIntervalMs * 1000);
+    OverloadController::instance().reportStage(LoadStage::Render, tickUs, m_activeIntervalMs * 1000);
+    scheduleNext(now);
+}
+
+bool UIFrameScheduler::wantsFrame(Client& client) {
+    if (client.triggers & FrameOnStatus) {
+        const StatusBoard& board = StatusBoard::instance();
+        const quint64 version = board.version();
+        if (version > client.statusSeen) {
+            client.status = board.changedSince(client.statusSeen, client.statusKinds);
+            client.statusSeen = client.status.isEmpty() ? version : qMax(version, client.status.last()->version);
+        }
+    }
+    return !client.primed
+        || (client.triggers & FrameEveryTick)
+        || ((client.triggers & FrameOnTracks) && !client.pending.isEmpty())
+        || ((client.triggers & FrameOnStatus) && !client.status.isEmpty());
+}
+
+void UIFrameScheduler::scheduleNext(qint64 nowMs) {
+    if (!m_running) return;
+
+    // The soonest any client has something to be called for
+    const quint64 statusVersion = StatusBoard::instance().version();
+    qint64 nextMs = -1;
+    for (const Client& client : m_clients) {
+        if (client.widget.isNull()) continue;
+        const bool wants = !client.primed
+            || (client.triggers & FrameEveryTick)
+            || ((client.triggers & FrameOnTracks) && !client.pending.isEmpty())
+            || ((client.triggers & FrameOnStatus) && statusVersion > client.statusSeen);
+        if (!wants) continue;
+
+        const int hz = clientRateHz(client);
+        const qint64 dueMs = hz > 0 ? client.lastFrameMs + 1000 / hz : nowMs;
+        nextMs = nextMs < 0 ? dueMs : qMin(nextMs, dueMs);
+    }
+
+    if (nextMs < 0) {
+        m_timer->stop();                // Until a change wakes it
+        return;
+    }
+    const int delayMs = static_cast<int>(qBound<qint64>(m_activeIntervalMs, nextMs - nowMs, 60000));
+    if (!m_timer->isActive() || m_timer->interval() != delayMs) {
+        m_timer->start(delayMs);
+    }
+}
+
+void UIFrameScheduler::updateInterval() {
+    if (m_window) {
+        if (QScreen* screen = m_window->screen()) {
+            m_refreshRateHz = qBound(20, qRound(screen->refreshRate()), 240);
+        }
+    }
+    m_idle = m_window && (m_window->isMinimized() || !m_window->isVisible());
+
+    const int activeHz = m_rateCapHz > 0 ? qMin(m_refreshRateHz, m_rateCapHz) : m_refreshRateHz;
+    const int hz = m_idle ? m_idleRateHz : activeHz;
+    m_activeIntervalMs = qMax(1, 1000 / hz);
+}
+
+int UIFrameScheduler::clientRateHz(const Client& client) const {
+    int hz = client.maxRateHz;
+    const bool hidden = !client.widget->isVisible() || client.widget->visibleRegion().isEmpty();
+    if (hidden || m_idle) {
+        hz = hz > 0 ? qMin(hz, m_idleRateHz) : m_idleRateHz;
+    }
+    return hz;
+}
+
+bool UIFrameScheduler::isDue(const Client& client, qint64 nowMs) const {
+    const int hz = clientRateHz(client);
+    if (hz <= 0) return true;
+
+    // Half a tick of slack, so a 30 Hz client on a 60 Hz clock is not
+    // pushed back a whole tick by timer jitter
+    const qint64 periodMs = 1000 / hz;
+    return nowMs - client.lastFrameMs >= periodMs - m_activeIntervalMs / 2;
+}
+
+} // namespace CounterUAS
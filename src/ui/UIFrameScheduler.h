@@ -0,0 +1,153 @@
+#ifndef UIFRAMESCHEDULER_H
+#define UIFRAMESCHEDULER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <QWidget>
+#include <functional>
+#include "core/TrackChangeSet.h"
+#include "core/TrackSnapshot.h"
+#include "utils/StatusBoard.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+class TrackManager;
+
+/**
+ * @brief What one display refresh sees
+ *
+ * Every client in a tick gets the same picture. changes holds every track
+ * changed since that client's previous frame, so a client refreshed less
+ * often than the scheduler ticks still misses nothing.
+ */
+struct UIFrame {
+    quint64 index = 0;              // Scheduler tick
+    qint64 timestampMs = 0;
+    double intervalS = 0.0;         // Since this client's previous frame
+    TrackPicturePtr picture;        // Never null while a track manager is set
+    TrackChangeSet changes;
+    // Sources of the client's status kinds changed since its previous
+    // frame, and the board version it had seen by then
+    QVector<StatusSnapshotPtr> status;
+    quint64 statusSince = 0;
+};
+
+/**
+ * @brief What a client is called for
+ */
+enum FrameTrigger : quint8 {
+    FrameOnTracks = 0x1,            // Frames with track changes
+    FrameOnStatus = 0x2,            // Frames with status of its kinds
+    FrameEveryTick = 0x4            // Every frame it is due, for animation and sampling
+};
+
+/**
+ * @brief One clock for every track display in the main window
+ *
+ * Ticks at the refresh rate of the window's screen. Each tick takes the
+ * track picture once, if a newer one has been published, and hands it to
+ * every client that is due, with the change sets merged since that
+ * client's last frame. A client may ask for a lower rate than the
+ * display's; 0 means every tick.
+ *
+ * A client whose widget is hidden, e.g. a closed dock or a page of a
+ * stack not on show, is refreshed at no more than idleRateHz. While the
+ * window is minimised the whole scheduler ticks at idleRateHz.
+ *
+ * Clients are called every tick they are due unless they narrow their
+ * triggers: one that only redraws what changed asks for FrameOnTracks
+ * and FrameOnStatus, and is then called only for frames that carry
+ * changes for it, plus a first frame to populate from. Status comes from
+ * the StatusBoard, filtered to the kinds the client names. When no client
+ * has anything to be called for, the timer sleeps until the next sampling
+ * client is due, or until a track change or a status publication wakes
+ * it, so an idle console costs next to nothing.
+ */
+class UIFrameScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    using FrameCallback = std::function<void(const UIFrame&)>;
+
+    static constexpr int DEFAULT_REFRESH_HZ = 60;
+    static constexpr int DEFAULT_IDLE_HZ = 2;
+
+    UIFrameScheduler(TrackManager* trackManager, QWidget* window, QObject* parent = nullptr);
+
+    // The client is dropped when widget is destroyed
+    void addClient(QWidget* widget, int maxRateHz, FrameCallback callback);
+    void removeClient(QWidget* widget);
+    void setClientRate(QWidget* widget, int maxRateHz);
+    // FrameTrigger flags; statusKinds is a StatusBoard::kindBit() mask
+    void setClientTriggers(QWidget* widget, quint8 triggers, quint32 statusKinds = StatusBoard::ALL_KINDS);
+
+    void setIdleRateHz(int hz);
+    int idleRateHz() const { return m_idleRateHz; }
+
+    // Ceiling on the tick rate while shedding load, so each frame batches
+    // more changes; 0 ticks at the screen's rate
+    void setRateCapHz(int hz);
+    int rateCapHz() const { return m_rateCapHz; }
+    
+    // Of the screen the window is on, when ticking at full rate
+    int refreshRateHz() const { return m_refreshRateHz; }
+    bool isIdle() const { return m_idle; }
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; }
+    // Running, but with nothing due until woken
+    bool isSleeping() const;
+
+    quint64 frameIndex() const { return m_frameIndex; }
+    TrackPicturePtr picture() const { return m_picture; }
+
+private slots:
+    void onTracksChanged(const TrackChangeSet& changes);
+    void onStatusPublished();
+    void tick();
+
+private:
+    struct Client {
+        QPointer<QWidget> widget;
+        FrameCallback callback;
+        int maxRateHz = 0;
+        qint64 lastFrameMs = 0;
+        TrackChangeSet pending;
+        quint8 triggers = FrameEveryTick;
+        quint32 statusKinds = StatusBoard::ALL_KINDS;
+        quint64 statusSeen = 0;         // Board version of its last frame
+        QVector<StatusSnapshotPtr> status;
+        bool primed = false;            // Has had its first frame
+    };
+
+    void updateInterval();
+    int clientRateHz(const Client& client) const;
+    bool isDue(const Client& client, qint64 nowMs) const;
+    // Whether the client has a frame to be called for, once due
+    bool wantsFrame(Client& client);
+    // Tick again at the active rate, later, or not until woken
+    void scheduleNext(qint64 nowMs);
+    void wake();
+
+    TrackManager* m_trackManager;
+    QPointer<QWidget> m_window;
+    QTimer* m_timer;
+    int m_activeIntervalMs = 1000 / DEFAULT_REFRESH_HZ;
+    bool m_running = false;
+    QVector<Client> m_clients;
+    TrackChangeSet m_pending;           // Since the last tick
+    TrackPicturePtr m_picture;
+    quint64 m_frameIndex = 0;
+    int m_refreshRateHz = DEFAULT_REFRESH_HZ;
+    int m_idleRateHz = DEFAULT_IDLE_HZ;
+    int m_rateCapHz = 0;
+    bool m_idle = false;
+};
+
+} // namespace CounterUAS
+
+#endif // UIFRAMESCHEDULER_H
@@ -1,10 +1,18 @@
 #include "ui/VideoDisplayWidget.h"
 #include "video/VideoStreamManager.h"
+#include "video/VideoOverlayRenderer.h"
+#include <QDateTime>
+#include <QOpenGLContext>
 #include <QPainter>
 #include <QMouseEvent>
+#include <QVBoxLayout>
 
 namespace CounterUAS {
 
+namespace {
+VideoRenderBackend s_defaultBackend = VideoRenderBackend::Auto;
+}
+
 VideoDisplayWidget::VideoDisplayWidget(QWidget* parent)
     : QWidget(parent)
     , m_updateTimer(new QTimer(this))
@@ -12,44 +20,181 @@ VideoDisplayWidget::VideoDisplayWidget(QWidget* parent)
     setMinimumSize(320, 240);
     setStyleSheet("background-color: black;");
     
-    m_updateTimer->setInterval(33);  // ~30 fps
-    connect(m_updateTimer, &QTimer::timeout, this, [this]() {
-        update();
-    });
+    VideoRenderBackend backend = s_defaultBackend;
+    if (backend == VideoRenderBackend::Auto) {
+        backend = openGLAvailable() ? VideoRenderBackend::OpenGL : VideoRenderBackend::Software;
+    }
+    if (backend == VideoRenderBackend::OpenGL) {
+        // The surface takes no mouse input, so clicks still reach this widget
+        m_glView = new VideoGLView(this);
+        m_glView->setOverlayPainter([this](QPainter& painter, const QRect& frameRect) {
+            paintOverlay(painter, frameRect);
+        });
+        m_glView->setOverlayLayerSource([this]() { return overlayLayer(); });
+        QVBoxLayout* layout = new QVBoxLayout(this);
+        layout->setContentsMargins(0, 0, 0, 0);
+        layout->addWidget(m_glView);
+    }
+    
+    // Frames repaint as they arrive; this only keeps the overlay clock current
+    m_updateTimer->setInterval(1000);
+    connect(m_updateTimer, &QTimer::timeout, this, &VideoDisplayWidget::refresh);
+}
+
+VideoDisplayWidget::~VideoDisplayWidget() {
+    if (m_videoManager && m_subscription) {
+        m_videoManager->unsubscribeFrames(m_subscription);
+    }
+}
+
+void VideoDisplayWidget::setDefaultBackend(VideoRenderBackend backend) {
+    s_defaultBackend = backend;
+}
+
+VideoRenderBackend VideoDisplayWidget::defaultBackend() {
+    return s_defaultBackend;
+}
+
+bool VideoDisplayWidget::openGLAvailable() {
+    static const bool available = []() {
+        QOpenGLContext probe;
+        return probe.create();
+    }();
+    return available;
+}
+
+VideoRenderBackend VideoDisplayWidget::backend() const {
+    return m_glView ? VideoRenderBackend::OpenGL : VideoRenderBackend::Software;
 }
 
 void VideoDisplayWidget::setVideoManager(VideoStreamManager* manager) {
+    if (m_videoManager == manager) return;
+    if (m_videoManager && m_subscription) {
+        m_videoManager->unsubscribeFrames(m_subscription);
+    }
+    m_subscription = 0;
     m_videoManager = manager;
+    resubscribe();
 }
 
 void VideoDisplayWidget::setSource(const QString& sourceId) {
+    const bool changed = sourceId != m_sourceId;
     m_sourceId = sourceId;
+    if (changed) resubscribe();
     m_updateTimer->start();
+    refresh();
+}
+
+void VideoDisplayWidget::setMaxFps(double fps) {
+    m_maxFps = qMax(0.0, fps);
+    resubscribe();
+}
+
+void VideoDisplayWidget::resubscribe() {
+    if (!m_videoManager) return;
+    if (m_subscription) {
+        m_videoManager->unsubscribeFrames(m_subscription);
+        m_subscription = 0;
+    }
+    if (m_sourceId.isEmpty()) return;
+    
+    m_subscription = m_videoManager->subscribeFrames(
+        m_sourceId, this, deliveryPolicy(),
+        [this](const VideoFrame& frame, qint64 timestamp, const QSize& sourceSize) {
+            updateScaledVideoFrame(frame, sourceSize);
+            m_frameTimeMs = timestamp;
+        });
+}
+
+void VideoDisplayWidget::setOverlayRenderer(VideoOverlayRenderer* renderer) {
+    m_overlayRenderer = renderer;
+    m_overlayRevision = 0;
+    refresh();
 }
 
 void VideoDisplayWidget::updateFrame(const QImage& frame) {
+    updateVideoFrame(VideoFrame(frame));
+}
+
+VideoDeliveryPolicy VideoDisplayWidget::deliveryPolicy() const {
+    VideoDeliveryPolicy policy;
+    policy.targetSize = size();
+    policy.maxFps = m_maxFps;
+    return policy;
+}
+
+void VideoDisplayWidget::updateVideoFrame(const VideoFrame& frame) {
+    updateScaledVideoFrame(frame, frame.size());
+}
+
+void VideoDisplayWidget::updateScaledVideoFrame(const VideoFrame& frame, const QSize& sourceSize) {
     m_currentFrame = frame;
-    update();
+    m_frameTimeMs = 0;
+    m_sourceSize = sourceSize.isEmpty() ? frame.size() : sourceSize;
+    if (m_glView) {
+        m_glView->setFrame(frame);
+    } else {
+        m_scaledFrame = QImage();
+        update();
+    }
+}
+
+void VideoDisplayWidget::refresh() {
+    if (m_glView) {
+        m_glView->update();
+    } else {
+        update();
+    }
 }
 
 void VideoDisplayWidget::paintEvent(QPaintEvent* event) {
     Q_UNUSED(event)
+    if (m_glView) return;
     
     QPainter painter(this);
-    painter.setRenderHint(QPainter::SmoothPixmapTransform);
     
+    QRect frameRect = rect();
     if (!m_currentFrame.isNull()) {
-        QImage scaled = m_currentFrame.scaled(size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        int x = (width() - scaled.width()) / 2;
-        int y = (height() - scaled.height()) / 2;
-        painter.drawImage(x, y, scaled);
+        if (m_scaledFrame.isNull()) {
+            // Frames from the manager already fit; only a resize rescales them
+            const QSize fitted = m_currentFrame.size().scaled(size(), Qt::KeepAspectRatio);
+            m_scaledFrame = m_currentFrame.toImage();
+            if (fitted != m_scaledFrame.size()) {
+                m_scaledFrame = m_scaledFrame.scaled(fitted, Qt::IgnoreAspectRatio,
+                                                     Qt::SmoothTransformation);
+            }
+        }
+        frameRect = QRect((width() - m_scaledFrame.width()) / 2,
+                          (height() - m_scaledFrame.height()) / 2,
+                          m_scaledFrame.width(), m_scaledFrame.height());
+        painter.drawImage(frameRect.topLeft(), m_scaledFrame);
     } else {
         painter.fillRect(rect(), Qt::black);
+    }
+    
+    paintOverlay(painter, frameRect);
+}
+
+void VideoDisplayWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    m_scaledFrame = QImage();
+    
+    if (m_videoManager && m_subscription) {
+        m_videoManager->setDeliveryPolicy(m_subscription, deliveryPolicy());
+    }
+}
+
+void VideoDisplayWidget::paintOverlay(QPainter& painter, const QRect& frameRect) {
+    if (m_currentFrame.isNull()) {
         painter.setPen(Qt::gray);
         painter.drawText(rect(), Qt::AlignCenter, m_sourceId.isEmpty() ? "No Video Source" : m_sourceId);
+    } else if (m_overlayEnabled && m_overlayRenderer && !m_glView) {
+        // The GL view has already blended the layer
+        m_overlayRenderer->setFrameTime(m_frameTimeMs);
+        m_overlayRenderer->updateLayer(m_sourceSize);
+        painter.drawImage(frameRect, m_overlayRenderer->layer());
     }
     
-    // Draw overlay
     if (m_overlayEnabled) {
         painter.setPen(Qt::white);
         painter.drawText(10, 20, m_sourceId);
@@ -57,6 +202,18 @@ void VideoDisplayWidget::paintEvent(QPaintEvent* event) {
     }
 }
 
+VideoGLView::OverlayLayer VideoDisplayWidget::overlayLayer() {
+    VideoGLView::OverlayLayer layer;
+    if (m_currentFrame.isNull() || !m_overlayEnabled || !m_overlayRenderer) return layer;
+    
+    m_overlayRenderer->setFrameTime(m_frameTimeMs);
+    m_overlayRenderer->updateLayer(m_sourceSize);
+    layer.image = m_overlayRenderer->layer();
+    layer.changed = m_overlayRenderer->layerChangedSince(m_overlayRevision);
+    m_overlayRevision = m_overlayRenderer->layerRevision();
+    return layer;
+}
+
 void VideoDisplayWidget::mouseDoubleClickEvent(QMouseEvent* event) {
     Q_UNUSED(event)
     emit doubleClicked();
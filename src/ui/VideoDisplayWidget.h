@@ -3,29 +3,82 @@
 
 #include <QWidget>
 #include <QImage>
+#include <QPointer>
 #include <QTimer>
 
+#include "ui/VideoGLView.h"
+#include "utils/VideoFrame.h"
+
+class QPainter;
+
 namespace CounterUAS {
 
 class VideoStreamManager;
+class VideoOverlayRenderer;
+struct VideoDeliveryPolicy;
 
+/**
+ * @brief How a video tile draws its frames
+ */
+enum class VideoRenderBackend {
+    Auto,       // OpenGL when a context can be created, otherwise Software
+    Software,   // QPainter, scaling on the CPU
+    OpenGL      // Texture upload and GPU scaling through VideoGLView
+};
+
+/**
+ * @brief One video tile: the frame, letterboxed, with its overlay on top
+ *
+ * The backend is chosen at construction. With OpenGL the frame, YUV
+ * included, goes to the GPU in its native format and is scaled there, and
+ * the renderer's retained overlay layer is blended over it on the GPU,
+ * uploading only what changed; the software path converts to RGB and
+ * scales once per frame or resize rather than on every repaint, and draws
+ * the same layer over it.
+ *
+ * Given a VideoStreamManager, the tile subscribes to its source at its own
+ * size, so the manager's scaler thread sends it frames that already fit
+ * and nothing scales on the GUI thread.
+ */
 class VideoDisplayWidget : public QWidget {
     Q_OBJECT
     
 public:
     explicit VideoDisplayWidget(QWidget* parent = nullptr);
+    ~VideoDisplayWidget() override;
+    
+    // Applies to widgets created afterwards
+    static void setDefaultBackend(VideoRenderBackend backend);
+    static VideoRenderBackend defaultBackend();
+    static bool openGLAvailable();
     
+    VideoRenderBackend backend() const;
+    
+    // Frames then come from the manager, sized for this tile
     void setVideoManager(VideoStreamManager* manager);
     void setSource(const QString& sourceId);
     QString currentSource() const { return m_sourceId; }
     
+    // Caps delivery from the manager; 0 for the source's rate
+    void setMaxFps(double fps);
+    double maxFps() const { return m_maxFps; }
+    
     void setOverlayEnabled(bool enabled) { m_overlayEnabled = enabled; }
     bool overlayEnabled() const { return m_overlayEnabled; }
     
-    QImage currentFrame() const { return m_currentFrame; }
+    // RGB; a YUV frame is converted on each call
+    QImage currentFrame() const { return m_currentFrame.toImage(); }
+    VideoFrame currentVideoFrame() const { return m_currentFrame; }
+    
+    // Drawn in frame pixel coordinates over the video, never into the frame
+    void setOverlayRenderer(VideoOverlayRenderer* renderer);
+    VideoOverlayRenderer* overlayRenderer() const { return m_overlayRenderer; }
     
 public slots:
     void updateFrame(const QImage& frame);
+    void updateVideoFrame(const VideoFrame& frame);
+    // A frame scaled down from sourceSize; the overlay maps to sourceSize
+    void updateScaledVideoFrame(const VideoFrame& frame, const QSize& sourceSize);
     
 signals:
     void clicked();
@@ -33,14 +86,29 @@ signals:
     
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
     void mouseDoubleClickEvent(QMouseEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     
 private:
-    VideoStreamManager* m_videoManager = nullptr;
+    void paintOverlay(QPainter& painter, const QRect& frameRect);
+    VideoGLView::OverlayLayer overlayLayer();
+    void refresh();
+    void resubscribe();
+    VideoDeliveryPolicy deliveryPolicy() const;
+    
+    QPointer<VideoStreamManager> m_videoManager;
+    int m_subscription = 0;
+    double m_maxFps = 0.0;
     QString m_sourceId;
-    QImage m_currentFrame;
+    VideoFrame m_currentFrame;
+    QSize m_sourceSize;             // Overlay coordinates; m_currentFrame may be scaled down
+    qint64 m_frameTimeMs = 0;       // Capture time the overlay is aligned to; 0 for now
+    QImage m_scaledFrame;           // Software path: m_currentFrame as RGB, fitted to the widget
     bool m_overlayEnabled = true;
+    QPointer<VideoOverlayRenderer> m_overlayRenderer;
+    quint64 m_overlayRevision = 0;  // Layer revision the GL texture holds
+    VideoGLView* m_glView = nullptr;
     QTimer* m_updateTimer;
 };
 
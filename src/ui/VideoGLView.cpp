@@ -0,0 +1,137 @@
+#include "ui/VideoGLView.h"
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QPainter>
+
+namespace CounterUAS {
+
+VideoGLView::VideoGLView(QWidget* parent)
+    : QOpenGLWidget(parent)
+    , m_quad(QOpenGLBuffer::VertexBuffer)
+    , m_pbo{QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer),
+            QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer)}
+{
+    setMinimumSize(160, 120);
+}
+
+VideoGLView::~VideoGLView() {
+    releaseGL();
+}
+
+void VideoGLView::setFrame(const VideoFrame& frame) {
+    m_pending = frame;
+    m_hasPending = true;
+    m_frameSize = frame.size();
+    update();
+}
+
+QRect VideoGLView::frameRect() const {
+    if (m_frameSize.isEmpty()) return rect();
+    const QSize fitted = m_frameSize.scaled(size(), Qt::KeepAspectRatio);
+    return QRect((width() - fitted.width()) / 2, (height() - fitted.height()) / 2,
+                 fitted.width(), fitted.height());
+}
+
+void VideoGLView::initializeGL() {
+    initializeOpenGLFunctions();
+    connect(context(), &QOpenGLContext::aboutToBeDestroyed,
+            this, &VideoGLView::releaseGL, Qt::UniqueConnection);
+
+    const VideoTexture::Caps caps = VideoTexture::probe(context());
+    m_usePbo = caps.pixelBuffers;
+
+    m_program = VideoTexture::buildProgram(context());
+    if (!m_program) return;
+
+    m_vao.reset(new QOpenGLVertexArrayObject);
+    m_vao->create();    // Required by core profiles, optional elsewhere
+
+    m_quad.create();
+    m_quad.bind();
+    m_quad.allocate(VideoTexture::QUAD, sizeof(VideoTexture::QUAD));
+    m_quad.release();
+
+    if (m_usePbo) {
+        for (QOpenGLBuffer& pbo : m_pbo) {
+            pbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+            m_usePbo = pbo.create() && m_usePbo;
+        }
+    }
+
+    // A new context (reparenting recreates it) has empty textures; upload
+    // the last frame again
+    m_texture.create(this, caps);
+    m_hasPending = !m_pending.isNull();
+}
+
+void VideoGLView::paintGL() {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (m_hasPending && m_program) {
+        QOpenGLBuffer* staging = m_usePbo ? &m_pbo[m_nextPbo] : nullptr;
+        m_nextPbo ^= 1;
+        if (m_texture.upload(m_pending, staging)) ++m_framesUploaded;
+        m_hasPending = false;
+    }
+
+    const QRect target = frameRect();
+    if (m_program && m_texture.hasFrame()) {
+        const qreal dpr = devicePixelRatioF();
+        glViewport(qRound(target.x() * dpr),
+                   qRound((height() - target.y() - target.height()) * dpr),
+                   qRound(target.width() * dpr), qRound(target.height() * dpr));
+
+        m_program->bind();
+        m_texture.bindFrame(m_program.get());
+        drawQuad(m_texture.shaderMode());
+        m_texture.unbind();
+
+        // The layer covers the same rect, so the same quad blends it on
+        const OverlayLayer layer = m_overlayLayerSource ? m_overlayLayerSource() : OverlayLayer();
+        if (!layer.image.isNull() && m_texture.uploadOverlay(layer.image, layer.changed)) {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            m_texture.bindOverlay();
+            drawQuad(3);
+            glDisable(GL_BLEND);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_program->release();
+        glViewport(0, 0, qRound(width() * dpr), qRound(height() * dpr));
+    }
+
+    if (m_overlayPainter) {
+        QPainter painter(this);
+        m_overlayPainter(painter, target);
+    }
+}
+
+void VideoGLView::drawQuad(int shaderMode) {
+    m_program->setUniformValue("mode", shaderMode);
+    QOpenGLVertexArrayObject::Binder vaoBinder(m_vao.get());
+    m_quad.bind();
+    m_program->enableAttributeArray(0);
+    m_program->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    m_program->disableAttributeArray(0);
+    m_quad.release();
+}
+
+void VideoGLView::releaseGL() {
+    if (!m_program && !m_texture.isCreated()) return;
+    makeCurrent();
+    m_texture.destroy();
+    for (QOpenGLBuffer& pbo : m_pbo) {
+        pbo.destroy();
+    }
+    m_quad.destroy();
+    if (m_vao) m_vao->destroy();
+    m_vao.reset();
+    m_program.reset();
+    doneCurrent();
+}
+
+} // namespace CounterUAS
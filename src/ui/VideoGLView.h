@@ -0,0 +1,95 @@
+#ifndef VIDEOGLVIEW_H
+#define VIDEOGLVIEW_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QImage>
+#include <functional>
+#include <memory>
+
+#include "ui/VideoTexture.h"
+#include "utils/VideoFrame.h"
+
+class QOpenGLShaderProgram;
+class QOpenGLVertexArrayObject;
+class QPainter;
+
+namespace CounterUAS {
+
+/**
+ * @brief OpenGL surface that draws one video stream as a texture
+ *
+ * Each new frame is copied into one of two pixel unpack buffers, alternated
+ * and orphaned so the copy never waits for the driver to finish reading the
+ * previous frame, and the texture is updated from that buffer (VideoTexture
+ * does the uploads). Scaling and
+ * letterboxing happen on the GPU with a textured quad; 32-bit frames are
+ * sampled as BGRA so they need no CPU conversion, and YUV frames go up as
+ * their native planes and are converted to RGB in the fragment shader.
+ * The overlay comes as a transparent layer image in frame coordinates,
+ * kept in its own texture that only takes the rect that changed, and is
+ * blended over the frame by the same quad; anything else is painted with
+ * QPainter over the result. Neither touches the frame's pixels.
+ *
+ * Contexts without pixel buffers (OpenGL ES 2) upload straight from the
+ * image instead, and ones without single-channel textures (before OpenGL
+ * 3.0) take YUV frames converted on the CPU.
+ */
+class VideoGLView : public QOpenGLWidget, protected QOpenGLFunctions {
+    Q_OBJECT
+
+public:
+    // Paints the overlay; the painter maps frame pixels onto the drawn rect
+    using OverlayPainter = std::function<void(QPainter&, const QRect& frameRect)>;
+
+    /**
+     * @brief Overlay layer supplied once per paint
+     */
+    struct OverlayLayer {
+        QImage image;       // Premultiplied ARGB; null for no layer
+        QRect changed;      // Part of image differing from the last one supplied
+    };
+    using OverlayLayerSource = std::function<OverlayLayer()>;
+
+    explicit VideoGLView(QWidget* parent = nullptr);
+    ~VideoGLView() override;
+
+    void setFrame(const VideoFrame& frame);
+    void setOverlayPainter(OverlayPainter painter) { m_overlayPainter = std::move(painter); }
+    void setOverlayLayerSource(OverlayLayerSource source) { m_overlayLayerSource = std::move(source); }
+
+    // Where the frame is drawn, in widget coordinates
+    QRect frameRect() const;
+
+    quint64 framesUploaded() const { return m_framesUploaded; }
+    quint64 overlayBytesUploaded() const { return m_texture.overlayBytesUploaded(); }
+
+protected:
+    void initializeGL() override;
+    void paintGL() override;
+
+private:
+    void releaseGL();
+    void drawQuad(int shaderMode);
+
+    VideoFrame m_pending;
+    bool m_hasPending = false;
+    QSize m_frameSize;
+    OverlayPainter m_overlayPainter;
+    OverlayLayerSource m_overlayLayerSource;
+
+    std::unique_ptr<QOpenGLShaderProgram> m_program;
+    std::unique_ptr<QOpenGLVertexArrayObject> m_vao;
+    QOpenGLBuffer m_quad;
+    QOpenGLBuffer m_pbo[2];
+    int m_nextPbo = 0;
+    bool m_usePbo = false;
+
+    VideoTexture m_texture;
+    quint64 m_framesUploaded = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEOGLVIEW_H
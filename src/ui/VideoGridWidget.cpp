@@ -1,4 +1,6 @@
 #include "ui/VideoGridWidget.h"
+#include "ui/VideoWallView.h"
+#include "video/VideoStreamManager.h"
 #include <QLabel>
 
 namespace CounterUAS {
@@ -12,22 +14,71 @@ VideoGridWidget::VideoGridWidget(QWidget* parent) : QWidget(parent) {
     setupDayNightLayout();
 }
 
-void VideoGridWidget::setupDayNightLayout() {
-    // Clear existing layout
-    for (auto* w : m_widgets) {
-        m_layout->removeWidget(w);
-        delete w;
+void VideoGridWidget::clearTiles() {
+    // Tiles, the day/night containers and the wall all hang off the layout
+    while (QLayoutItem* item = m_layout->takeAt(0)) {
+        delete item->widget();
+        delete item;
     }
+    for (int c = 0; c < m_layout->columnCount(); ++c) m_layout->setColumnStretch(c, 0);
     m_widgets.clear();
     m_cameraWidgetMap.clear();
+    m_dayWidget = nullptr;
+    m_nightWidget = nullptr;
+    m_dayLabel = nullptr;
+    m_nightLabel = nullptr;
+    m_wall = nullptr;
+}
+
+void VideoGridWidget::createWall() {
+    m_wall = new VideoWallView(this);
+    m_wall->setVideoManager(m_videoManager);
+    m_wall->setGridSize(m_rows, m_cols);
+    connect(m_wall, &VideoWallView::tileClicked, this, [this](int tile) {
+        emit cameraSelected(m_wall->tileSource(tile));
+    });
+    m_layout->addWidget(m_wall, 0, 0);
+}
+
+bool VideoGridWidget::setComposited(bool composited) {
+    if (composited && !VideoDisplayWidget::openGLAvailable()) return false;
+    if (composited == m_composited) return true;
     
-    // Delete old labels if they exist
-    if (m_dayLabel) { delete m_dayLabel; m_dayLabel = nullptr; }
-    if (m_nightLabel) { delete m_nightLabel; m_nightLabel = nullptr; }
+    // Cameras keep their tile order across the rebuild
+    QStringList cameras;
+    if (m_wall) {
+        for (int i = 0; i < m_wall->tileCount(); ++i) cameras.append(m_wall->tileSource(i));
+    } else {
+        for (auto* w : m_widgets) cameras.append(w->currentSource());
+    }
     
+    m_composited = composited;
+    if (m_dayNightLayout) {
+        setupDayNightLayout();
+    } else {
+        setGridSize(m_rows, m_cols);
+    }
+    for (const QString& id : cameras) {
+        if (!id.isEmpty()) addCamera(id);
+    }
+    return true;
+}
+
+void VideoGridWidget::setupDayNightLayout() {
+    clearTiles();
+    m_dayNightLayout = true;
     m_rows = 1;
     m_cols = 2;
     
+    if (m_composited) {
+        createWall();
+        m_wall->setTileSource(0, "SIM-DAY-001");
+        m_wall->setTileLabel(0, "DAY CAMERA");
+        m_wall->setTileSource(1, "SIM-NIGHT-001");
+        m_wall->setTileLabel(1, "NIGHT CAMERA");
+        return;
+    }
+    
     // Style for camera labels
     QString labelStyle = "QLabel { color: white; background-color: rgba(0, 0, 0, 180); "
                         "padding: 4px 8px; font-weight: bold; font-size: 11px; "
@@ -47,6 +98,7 @@ void VideoGridWidget::setupDayNightLayout() {
     
     m_dayWidget = new VideoDisplayWidget(dayContainer);
     m_dayWidget->setMinimumSize(240, 180);
+    m_dayWidget->setVideoManager(m_videoManager);
     m_dayWidget->setSource("SIM-DAY-001");
     connect(m_dayWidget, &VideoDisplayWidget::clicked, this, [this]() {
         emit cameraSelected(m_dayWidget->currentSource());
@@ -67,6 +119,7 @@ void VideoGridWidget::setupDayNightLayout() {
     
     m_nightWidget = new VideoDisplayWidget(nightContainer);
     m_nightWidget->setMinimumSize(240, 180);
+    m_nightWidget->setVideoManager(m_videoManager);
     m_nightWidget->setSource("SIM-NIGHT-001");
     connect(m_nightWidget, &VideoDisplayWidget::clicked, this, [this]() {
         emit cameraSelected(m_nightWidget->currentSource());
@@ -88,23 +141,42 @@ void VideoGridWidget::setupDayNightLayout() {
     m_cameraWidgetMap["SIM-NIGHT-001"] = m_nightWidget;
 }
 
+void VideoGridWidget::setVideoManager(VideoStreamManager* manager) {
+    if (m_videoManager == manager) return;
+    if (m_videoManager) {
+        disconnect(m_videoManager, nullptr, this, nullptr);
+    }
+    m_videoManager = manager;
+    for (auto* w : m_widgets) {
+        w->setVideoManager(manager);
+    }
+    if (m_wall) m_wall->setVideoManager(manager);
+    if (!manager) return;
+    
+    connect(manager, &VideoStreamManager::streamAdded, this, &VideoGridWidget::addCamera);
+    connect(manager, &VideoStreamManager::streamRemoved, this, &VideoGridWidget::removeCamera);
+    for (const QString& id : manager->streamIds()) {
+        addCamera(id);
+    }
+}
+
 void VideoGridWidget::setGridSize(int rows, int cols) {
+    clearTiles();
+    m_dayNightLayout = false;
     m_rows = rows;
     m_cols = cols;
     
-    // Clear existing
-    for (auto* w : m_widgets) {
-        m_layout->removeWidget(w);
-        delete w;
+    if (m_composited) {
+        createWall();
+        return;
     }
-    m_widgets.clear();
-    m_cameraWidgetMap.clear();
     
     // Create new grid
     for (int r = 0; r < rows; ++r) {
         for (int c = 0; c < cols; ++c) {
             VideoDisplayWidget* widget = new VideoDisplayWidget(this);
             widget->setMinimumSize(160, 120);
+            widget->setVideoManager(m_videoManager);
             connect(widget, &VideoDisplayWidget::clicked, this, [this, widget]() {
                 emit cameraSelected(widget->currentSource());
             });
@@ -115,6 +187,13 @@ void VideoGridWidget::setGridSize(int rows, int cols) {
 }
 
 void VideoGridWidget::addCamera(const QString& cameraId) {
+    if (m_wall) {
+        if (m_wall->tileForSource(cameraId) >= 0) return;
+        const int tile = m_wall->tileForSource(QString());
+        if (tile >= 0) m_wall->setTileSource(tile, cameraId);
+        return;
+    }
+    
     // Check if camera already assigned
     if (m_cameraWidgetMap.contains(cameraId)) {
         return;
@@ -131,6 +210,11 @@ void VideoGridWidget::addCamera(const QString& cameraId) {
 }
 
 void VideoGridWidget::removeCamera(const QString& cameraId) {
+    if (m_wall) {
+        const int tile = m_wall->tileForSource(cameraId);
+        if (tile >= 0) m_wall->setTileSource(tile, QString());
+        return;
+    }
     if (m_cameraWidgetMap.contains(cameraId)) {
         VideoDisplayWidget* w = m_cameraWidgetMap.take(cameraId);
         if (w) {
@@ -140,6 +224,9 @@ void VideoGridWidget::removeCamera(const QString& cameraId) {
 }
 
 void VideoGridWidget::clearAllCameras() {
+    if (m_wall) {
+        for (int i = 0; i < m_wall->tileCount(); ++i) m_wall->setTileSource(i, QString());
+    }
     m_cameraWidgetMap.clear();
     for (auto* w : m_widgets) {
         w->setSource(QString());
@@ -151,10 +238,27 @@ VideoDisplayWidget* VideoGridWidget::widgetForCamera(const QString& cameraId) co
 }
 
 QStringList VideoGridWidget::cameraIds() const {
+    if (m_wall) {
+        QStringList ids;
+        for (int i = 0; i < m_wall->tileCount(); ++i) {
+            if (!m_wall->tileSource(i).isEmpty()) ids.append(m_wall->tileSource(i));
+        }
+        return ids;
+    }
     return m_cameraWidgetMap.keys();
 }
 
 void VideoGridWidget::updateFrame(const QString& cameraId, const QImage& frame) {
+    updateVideoFrame(cameraId, VideoFrame(frame));
+}
+
+void VideoGridWidget::updateVideoFrame(const QString& cameraId, const VideoFrame& frame) {
+    if (m_wall) {
+        addCamera(cameraId);
+        m_wall->setTileFrame(m_wall->tileForSource(cameraId), frame);
+        return;
+    }
+    
     // If camera is not yet assigned, try to add it
     if (!m_cameraWidgetMap.contains(cameraId)) {
         // Find first available widget
@@ -170,7 +274,7 @@ void VideoGridWidget::updateFrame(const QString& cameraId, const QImage& frame)
     // Update the frame
     VideoDisplayWidget* widget = m_cameraWidgetMap.value(cameraId, nullptr);
     if (widget) {
-        widget->updateFrame(frame);
+        widget->updateVideoFrame(frame);
     }
 }
 
@@ -8,16 +8,30 @@
 #include <QList>
 #include <QHash>
 #include <QImage>
+#include <QPointer>
 #include "ui/VideoDisplayWidget.h"
 
 namespace CounterUAS {
 
+class VideoWallView;
+
+/**
+ * @brief Camera tiles in a grid
+ *
+ * By default each tile is a VideoDisplayWidget. Composited, the whole grid
+ * is one VideoWallView instead: a single OpenGL surface, one paint for all
+ * tiles, with textures uploaded only for tiles that have a new frame. It
+ * needs OpenGL; without it the grid stays on widgets.
+ */
 class VideoGridWidget : public QWidget {
     Q_OBJECT
     
 public:
     explicit VideoGridWidget(QWidget* parent = nullptr);
     
+    // Tiles subscribe to their cameras at tile size; new streams fill free tiles
+    void setVideoManager(VideoStreamManager* manager);
+    
     void setGridSize(int rows, int cols);
     void addCamera(const QString& cameraId);
     void removeCamera(const QString& cameraId);
@@ -26,7 +40,12 @@ public:
     // Simplified Day/Night camera layout
     void setupDayNightLayout();
     
-    // Get widget for a specific camera
+    // Rebuilds the current layout either way; false if OpenGL is missing
+    bool setComposited(bool composited);
+    bool isComposited() const { return m_composited; }
+    VideoWallView* wallView() const { return m_wall; }
+    
+    // Get widget for a specific camera; none while composited
     VideoDisplayWidget* widgetForCamera(const QString& cameraId) const;
     
     // Get Day/Night camera widgets directly
@@ -39,11 +58,16 @@ public:
 public slots:
     // Update frame for a specific camera
     void updateFrame(const QString& cameraId, const QImage& frame);
+    void updateVideoFrame(const QString& cameraId, const VideoFrame& frame);
     
 signals:
     void cameraSelected(const QString& cameraId);
     
 private:
+    void clearTiles();
+    void createWall();
+    
+    QPointer<VideoStreamManager> m_videoManager;
     QGridLayout* m_layout;
     QList<VideoDisplayWidget*> m_widgets;
     QHash<QString, VideoDisplayWidget*> m_cameraWidgetMap;
@@ -55,6 +79,10 @@ private:
     VideoDisplayWidget* m_nightWidget = nullptr;
     QLabel* m_dayLabel = nullptr;
     QLabel* m_nightLabel = nullptr;
+    
+    VideoWallView* m_wall = nullptr;
+    bool m_composited = false;
+    bool m_dayNightLayout = false;
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,368 @@
+#include "ui/VideoTexture.h"
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <cstring>
+
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+#ifndef GL_UNSIGNED_INT_8_8_8_8_REV
+#define GL_UNSIGNED_INT_8_8_8_8_REV 0x8367
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_RGB8
+#define GL_RGB8 0x8051
+#endif
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_RG
+#define GL_RG 0x8227
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_RG8
+#define GL_RG8 0x822B
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+const char* VERTEX_SHADER =
+    "ATTRIBUTE vec2 position;\n"
+    "VARYING_OUT vec2 texCoord;\n"
+    "void main() {\n"
+    "    // Image rows are uploaded top first\n"
+    "    texCoord = vec2(position.x + 1.0, 1.0 - position.y) * 0.5;\n"
+    "    gl_Position = vec4(position, 0.0, 1.0);\n"
+    "}\n";
+
+// mode 0 samples RGB; 1 and 2 convert I420 and NV12 planes, BT.601 video
+// range; 3 passes the premultiplied overlay through for blending
+const char* FRAGMENT_SHADER =
+    "uniform sampler2D frame;\n"
+    "uniform sampler2D planeU;\n"
+    "uniform sampler2D planeV;\n"
+    "uniform int mode;\n"
+    "VARYING_IN vec2 texCoord;\n"
+    "void main() {\n"
+    "    if (mode == 3) {\n"
+    "        FRAG_COLOR = TEXTURE(frame, texCoord);\n"
+    "        return;\n"
+    "    }\n"
+    "    if (mode == 0) {\n"
+    "        FRAG_COLOR = vec4(TEXTURE(frame, texCoord).rgb, 1.0);\n"
+    "        return;\n"
+    "    }\n"
+    "    float y = 1.1644 * (TEXTURE(frame, texCoord).r - 0.0627);\n"
+    "    vec2 uv = mode == 1\n"
+    "        ? vec2(TEXTURE(planeU, texCoord).r, TEXTURE(planeV, texCoord).r)\n"
+    "        : TEXTURE(planeU, texCoord).rg;\n"
+    "    uv -= vec2(0.5);\n"
+    "    FRAG_COLOR = vec4(y + 1.5960 * uv.y,\n"
+    "                      y - 0.3918 * uv.x - 0.8130 * uv.y,\n"
+    "                      y + 2.0172 * uv.x, 1.0);\n"
+    "}\n";
+
+} // namespace
+
+// Full-viewport strip; the viewport itself does the letterboxing
+const float VideoTexture::QUAD[8] = {
+    -1.0f, -1.0f,
+     1.0f, -1.0f,
+    -1.0f,  1.0f,
+     1.0f,  1.0f,
+};
+
+VideoTexture::Caps VideoTexture::probe(QOpenGLContext* context) {
+    Caps caps;
+    caps.bgra = !context->isOpenGLES();
+    caps.pixelBuffers = !context->isOpenGLES() && context->format().version() >= qMakePair(2, 1);
+    caps.planar = !context->isOpenGLES() && context->format().version() >= qMakePair(3, 0);
+    return caps;
+}
+
+QByteArray VideoTexture::shaderHeader(QOpenGLContext* context) {
+    if (context->isOpenGLES()) {
+        return "#version 100\nprecision mediump float;\n"
+               "#define ATTRIBUTE attribute\n#define VARYING_OUT varying\n"
+               "#define VARYING_IN varying\n#define TEXTURE texture2D\n"
+               "#define FRAG_COLOR gl_FragColor\n";
+    }
+    if (context->format().profile() == QSurfaceFormat::CoreProfile) {
+        return "#version 150\n"
+               "#define ATTRIBUTE in\n#define VARYING_OUT out\n"
+               "#define VARYING_IN in\n#define TEXTURE texture\n"
+               "#define FRAG_COLOR fragColor\nout vec4 fragColor;\n";
+    }
+    return "#version 120\n"
+           "#define ATTRIBUTE attribute\n#define VARYING_OUT varying\n"
+           "#define VARYING_IN varying\n#define TEXTURE texture2D\n"
+           "#define FRAG_COLOR gl_FragColor\n";
+}
+
+std::unique_ptr<QOpenGLShaderProgram> VideoTexture::buildProgram(QOpenGLContext* context) {
+    const QByteArray header = shaderHeader(context);
+    std::unique_ptr<QOpenGLShaderProgram> program(new QOpenGLShaderProgram);
+    const bool ok =
+        program->addShaderFromSourceCode(QOpenGLShader::Vertex, header + VERTEX_SHADER) &&
+        program->addShaderFromSourceCode(QOpenGLShader::Fragment, header + FRAGMENT_SHADER);
+    program->bindAttributeLocation("position", 0);
+    if (!ok || !program->link()) {
+        qWarning("VideoTexture: shader build failed: %s", qPrintable(program->log()));
+        return nullptr;
+    }
+    return program;
+}
+
+void VideoTexture::create(QOpenGLFunctions* gl, const Caps& caps) {
+    destroy();
+    m_gl = gl;
+    m_caps = caps;
+
+    GLuint textures[4];
+    m_gl->glGenTextures(4, textures);
+    m_texture = textures[0];
+    m_chroma[0] = textures[1];
+    m_chroma[1] = textures[2];
+    m_overlayTexture = textures[3];
+    for (GLuint texture : textures) {
+        m_gl->glBindTexture(GL_TEXTURE_2D, texture);
+        m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        m_gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VideoTexture::destroy() {
+    if (m_texture != 0) {
+        const GLuint textures[4] = {m_texture, m_chroma[0], m_chroma[1], m_overlayTexture};
+        m_gl->glDeleteTextures(4, textures);
+    }
+    m_texture = 0;
+    m_chroma[0] = m_chroma[1] = 0;
+    m_overlayTexture = 0;
+    m_size = QSize();
+    m_layout = VideoPixelFormat::Invalid;
+    m_overlaySize = QSize();
+}
+
+bool VideoTexture::upload(const VideoFrame& frame, QOpenGLBuffer* staging) {
+    if (!isCreated() || frame.isNull()) return false;
+    if (frame.isYuv() && m_caps.planar) {
+        return uploadPlanes(frame, staging);
+    }
+    // RGB frames come back shared; YUV is converted here only without planar textures
+    return uploadImage(frame.toImage(), staging);
+}
+
+void VideoTexture::allocate(GLuint texture, GLint internalFormat, const QSize& size,
+                            GLenum format, GLenum type) {
+    m_gl->glBindTexture(GL_TEXTURE_2D, texture);
+    m_gl->glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size.width(), size.height(), 0,
+                       format, type, nullptr);
+}
+
+bool VideoTexture::uploadImage(const QImage& frame, QOpenGLBuffer* staging) {
+    QImage image = frame;
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    GLint internalFormat = GL_RGBA;
+    const bool bgra = m_caps.bgra;
+
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        if (bgra) {
+            // 0xAARRGGBB words, whatever the byte order
+            format = GL_BGRA;
+            type = GL_UNSIGNED_INT_8_8_8_8_REV;
+            internalFormat = GL_RGBA8;
+        } else {
+            image = image.convertToFormat(QImage::Format_RGBX8888);
+        }
+        break;
+    case QImage::Format_RGB888:
+        format = GL_RGB;
+        internalFormat = bgra ? GL_RGB8 : GL_RGB;
+        break;
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        internalFormat = bgra ? GL_RGBA8 : GL_RGBA;
+        break;
+    default:
+        image = image.convertToFormat(QImage::Format_RGBX8888);
+        internalFormat = bgra ? GL_RGBA8 : GL_RGBA;
+        break;
+    }
+    if (image.isNull()) return false;
+
+    // QImage pads every line to 32 bits, which is exactly GL's default unpack
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (m_layout != VideoPixelFormat::RGB32 || image.size() != m_size || format != m_format) {
+        allocate(m_texture, internalFormat, image.size(), format, type);
+        m_size = image.size();
+        m_format = format;
+        m_layout = VideoPixelFormat::RGB32;   // Any RGB layout
+    }
+    m_gl->glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    bool uploaded = false;
+    if (staging && m_caps.pixelBuffers) {
+        const int bytes = static_cast<int>(image.sizeInBytes());
+        staging->bind();
+        staging->allocate(bytes);   // Orphans the old storage instead of waiting on it
+        if (void* dst = staging->map(QOpenGLBuffer::WriteOnly)) {
+            std::memcpy(dst, image.constBits(), bytes);
+            uploaded = staging->unmap();
+            if (uploaded) {
+                m_gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(),
+                                      format, type, nullptr);
+            }
+        }
+        staging->release();
+    }
+    if (!uploaded) {
+        m_gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(),
+                              format, type, image.constBits());
+    }
+
+    m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+    m_shaderMode = 0;
+    return true;
+}
+
+bool VideoTexture::uploadPlanes(const VideoFrame& frame, QOpenGLBuffer* staging) {
+    const VideoPixelFormat layout = frame.pixelFormat();
+    const bool nv12 = layout == VideoPixelFormat::NV12;
+    const QSize chromaSize = frame.planeSize(1);
+
+    if (layout != m_layout || frame.size() != m_size) {
+        allocate(m_texture, GL_R8, frame.size(), GL_RED, GL_UNSIGNED_BYTE);
+        if (nv12) {
+            allocate(m_chroma[0], GL_RG8, chromaSize, GL_RG, GL_UNSIGNED_BYTE);
+        } else {
+            allocate(m_chroma[0], GL_R8, chromaSize, GL_RED, GL_UNSIGNED_BYTE);
+            allocate(m_chroma[1], GL_R8, chromaSize, GL_RED, GL_UNSIGNED_BYTE);
+        }
+        m_size = frame.size();
+        m_format = GL_RED;
+        m_layout = layout;
+    }
+
+    // The planes share one buffer, so one copy stages them all
+    const int last = frame.planeCount() - 1;
+    const uchar* base = frame.constBits(0);
+    const int bytes = static_cast<int>(frame.constBits(last) - base) +
+                      frame.bytesPerLine(last) * frame.planeSize(last).height();
+
+    bool staged = false;
+    if (staging && m_caps.pixelBuffers) {
+        staging->bind();
+        staging->allocate(bytes);
+        if (void* dst = staging->map(QOpenGLBuffer::WriteOnly)) {
+            std::memcpy(dst, base, bytes);
+            staged = staging->unmap();
+        }
+        if (!staged) staging->release();
+    }
+
+    // Strides come from the frame, not the width
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const GLuint textures[3] = {m_texture, m_chroma[0], m_chroma[1]};
+    for (int plane = 0; plane <= last; ++plane) {
+        const bool pairs = nv12 && plane == 1;
+        const QSize size = frame.planeSize(plane);
+        m_gl->glBindTexture(GL_TEXTURE_2D, textures[plane]);
+        m_gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.bytesPerLine(plane) / (pairs ? 2 : 1));
+        // With a bound buffer the pointer is an offset into it
+        const quintptr offset = static_cast<quintptr>(frame.constBits(plane) - base);
+        const void* pixels = staged ? reinterpret_cast<const void*>(offset)
+                                    : static_cast<const void*>(frame.constBits(plane));
+        m_gl->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.width(), size.height(),
+                              pairs ? GL_RG : GL_RED, GL_UNSIGNED_BYTE, pixels);
+    }
+    m_gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (staged) staging->release();
+
+    m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+    m_shaderMode = nv12 ? 2 : 1;
+    return true;
+}
+
+bool VideoTexture::uploadOverlay(const QImage& image, const QRect& layerChanged) {
+    if (!isCreated() || image.isNull()) return false;
+    const bool bgra = m_caps.bgra;
+    const GLenum format = bgra ? GL_BGRA : GL_RGBA;
+    const GLenum type = bgra ? GL_UNSIGNED_INT_8_8_8_8_REV : GL_UNSIGNED_BYTE;
+
+    QRect changed = layerChanged & image.rect();
+    if (image.size() != m_overlaySize) {
+        allocate(m_overlayTexture, bgra ? GL_RGBA8 : GL_RGBA, image.size(), format, type);
+        m_overlaySize = image.size();
+        changed = image.rect();
+    }
+    if (changed.isEmpty()) return true;
+
+    m_gl->glBindTexture(GL_TEXTURE_2D, m_overlayTexture);
+    m_gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (bgra && image.format() == QImage::Format_ARGB32_Premultiplied) {
+        // Only the changed rect, read in place at the layer's stride
+        m_gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, image.bytesPerLine() / 4);
+        m_gl->glTexSubImage2D(GL_TEXTURE_2D, 0, changed.x(), changed.y(),
+                              changed.width(), changed.height(), format, type,
+                              image.constScanLine(changed.y()) + changed.x() * 4);
+        m_gl->glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    } else {
+        const QImage part = image.copy(changed).convertToFormat(
+            bgra ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGBA8888_Premultiplied);
+        m_gl->glTexSubImage2D(GL_TEXTURE_2D, 0, changed.x(), changed.y(),
+                              changed.width(), changed.height(), format, type, part.constBits());
+    }
+    m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+    m_overlayBytesUploaded += static_cast<quint64>(changed.width()) * changed.height() * 4;
+    return true;
+}
+
+void VideoTexture::bindFrame(QOpenGLShaderProgram* program) {
+    m_gl->glActiveTexture(GL_TEXTURE0);
+    m_gl->glBindTexture(GL_TEXTURE_2D, m_texture);
+    program->setUniformValue("frame", 0);
+    if (m_shaderMode != 0) {
+        m_gl->glActiveTexture(GL_TEXTURE1);
+        m_gl->glBindTexture(GL_TEXTURE_2D, m_chroma[0]);
+        m_gl->glActiveTexture(GL_TEXTURE2);
+        m_gl->glBindTexture(GL_TEXTURE_2D, m_chroma[1]);
+        m_gl->glActiveTexture(GL_TEXTURE0);
+        program->setUniformValue("planeU", 1);
+        program->setUniformValue("planeV", 2);
+    }
+}
+
+void VideoTexture::bindOverlay() {
+    m_gl->glActiveTexture(GL_TEXTURE0);
+    m_gl->glBindTexture(GL_TEXTURE_2D, m_overlayTexture);
+}
+
+void VideoTexture::unbind() {
+    for (GLenum unit : {GL_TEXTURE2, GL_TEXTURE1, GL_TEXTURE0}) {
+        m_gl->glActiveTexture(unit);
+        m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+} // namespace CounterUAS
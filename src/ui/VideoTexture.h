@@ -0,0 +1,97 @@
+#ifndef VIDEOTEXTURE_H
+#define VIDEOTEXTURE_H
+
+#include <QImage>
+#include <QOpenGLFunctions>
+#include <QRect>
+#include <memory>
+
+#include "utils/VideoFrame.h"
+
+class QOpenGLBuffer;
+class QOpenGLContext;
+class QOpenGLShaderProgram;
+
+namespace CounterUAS {
+
+/**
+ * @brief One video frame and its overlay layer, held as GL textures
+ *
+ * The upload half of VideoGLView, shared with VideoWallView's tiles.
+ * 32-bit frames are sampled as BGRA, YUV frames go up as their native
+ * planes for the fragment shader to convert, and the overlay layer takes
+ * only the rect that changed. A staging pixel buffer, when given, is
+ * orphaned and filled so the upload never waits for the driver to finish
+ * reading the previous frame.
+ *
+ * Everything is called with the owning view's context current.
+ */
+class VideoTexture {
+public:
+    /**
+     * @brief What the current context can take
+     */
+    struct Caps {
+        bool bgra = false;          // 32-bit frames without conversion
+        bool pixelBuffers = false;
+        bool planar = false;        // Single-channel textures for YUV planes
+    };
+
+    static Caps probe(QOpenGLContext* context);
+
+    // The quad program: mode 0 RGB, 1 I420, 2 NV12, 3 the overlay layer.
+    // A full-viewport strip at attribute 0; the viewport places it. Null if
+    // the shaders do not build.
+    static std::unique_ptr<QOpenGLShaderProgram> buildProgram(QOpenGLContext* context);
+    // GLSL version and macros for this context, for other programs
+    static QByteArray shaderHeader(QOpenGLContext* context);
+    static const float QUAD[8];
+
+    VideoTexture() = default;
+    ~VideoTexture() = default;
+
+    VideoTexture(const VideoTexture&) = delete;
+    VideoTexture& operator=(const VideoTexture&) = delete;
+
+    void create(QOpenGLFunctions* gl, const Caps& caps);
+    void destroy();
+    bool isCreated() const { return m_texture != 0; }
+
+    // staging may be null
+    bool upload(const VideoFrame& frame, QOpenGLBuffer* staging);
+    bool uploadOverlay(const QImage& layer, const QRect& changed);
+
+    bool hasFrame() const { return m_size.isValid(); }
+    QSize frameSize() const { return m_size; }
+    int shaderMode() const { return m_shaderMode; }
+
+    // Frame planes on units 0-2, with the program's samplers set
+    void bindFrame(QOpenGLShaderProgram* program);
+    void bindOverlay();
+    void unbind();
+
+    quint64 overlayBytesUploaded() const { return m_overlayBytesUploaded; }
+
+private:
+    bool uploadImage(const QImage& frame, QOpenGLBuffer* staging);
+    bool uploadPlanes(const VideoFrame& frame, QOpenGLBuffer* staging);
+    void allocate(GLuint texture, GLint internalFormat, const QSize& size, GLenum format, GLenum type);
+
+    QOpenGLFunctions* m_gl = nullptr;
+    Caps m_caps;
+
+    GLuint m_texture = 0;          // RGB, or the luma plane
+    GLuint m_chroma[2] = {0, 0};   // U and V, or NV12's interleaved pair in the first
+    QSize m_size;
+    GLenum m_format = 0;
+    VideoPixelFormat m_layout = VideoPixelFormat::Invalid;
+    int m_shaderMode = 0;
+
+    GLuint m_overlayTexture = 0;   // Premultiplied RGBA
+    QSize m_overlaySize;
+    quint64 m_overlayBytesUploaded = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEOTEXTURE_H
@@ -0,0 +1,549 @@
+#include "ui/VideoWallView.h"
+#include "video/VideoStreamManager.h"
+#include "video/VideoOverlayRenderer.h"
+#include <QDateTime>
+#include <QFontMetricsF>
+#include <QMouseEvent>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QPainter>
+#include <QtMath>
+#include <cmath>
+
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+#ifndef GL_UNSIGNED_INT_8_8_8_8_REV
+#define GL_UNSIGNED_INT_8_8_8_8_REV 0x8367
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int FLOATS_PER_VERTEX = 8;   // position, atlas coordinate, premultiplied colour
+constexpr int FIRST_GLYPH = 32;
+
+const char* TEXT_VERTEX_SHADER =
+    "ATTRIBUTE vec2 position;\n"
+    "ATTRIBUTE vec2 atlasCoord;\n"
+    "ATTRIBUTE vec4 color;\n"
+    "VARYING_OUT vec2 texCoord;\n"
+    "VARYING_OUT vec4 tint;\n"
+    "void main() {\n"
+    "    texCoord = atlasCoord;\n"
+    "    tint = color;\n"
+    "    gl_Position = vec4(position, 0.0, 1.0);\n"
+    "}\n";
+
+// The atlas holds white coverage; the colour comes premultiplied
+const char* TEXT_FRAGMENT_SHADER =
+    "uniform sampler2D atlas;\n"
+    "VARYING_IN vec2 texCoord;\n"
+    "VARYING_IN vec4 tint;\n"
+    "void main() {\n"
+    "    FRAG_COLOR = tint * TEXTURE(atlas, texCoord).a;\n"
+    "}\n";
+
+} // namespace
+
+VideoWallView::VideoWallView(QWidget* parent)
+    : QOpenGLWidget(parent)
+    , m_clockTimer(new QTimer(this))
+    , m_quad(QOpenGLBuffer::VertexBuffer)
+    , m_textBuffer(QOpenGLBuffer::VertexBuffer)
+    , m_pbo{QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer),
+            QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer)}
+{
+    setMinimumSize(160, 120);
+    setGridSize(1, 1);
+
+    // Frames repaint as they arrive; this only keeps the captions' clock current
+    m_clockTimer->setInterval(1000);
+    connect(m_clockTimer, &QTimer::timeout, this, [this]() { update(); });
+    m_clockTimer->start();
+}
+
+VideoWallView::~VideoWallView() {
+    for (int i = 0; i < tileCount(); ++i) unsubscribe(i);
+    releaseGL();
+}
+
+void VideoWallView::setVideoManager(VideoStreamManager* manager) {
+    if (m_videoManager == manager) return;
+    for (int i = 0; i < tileCount(); ++i) unsubscribe(i);
+    m_videoManager = manager;
+    for (int i = 0; i < tileCount(); ++i) subscribe(i);
+}
+
+void VideoWallView::setGridSize(int rows, int cols) {
+    rows = qMax(1, rows);
+    cols = qMax(1, cols);
+    const int count = rows * cols;
+    for (int i = count; i < tileCount(); ++i) unsubscribe(i);
+
+    // Textures of dropped tiles go with the context current
+    if (count < tileCount() && context()) {
+        makeCurrent();
+        for (int i = count; i < tileCount(); ++i) m_tiles[i]->texture.destroy();
+        doneCurrent();
+    }
+    m_tiles.resize(count);
+    for (std::unique_ptr<Tile>& tile : m_tiles) {
+        if (!tile) tile.reset(new Tile);
+    }
+    m_rows = rows;
+    m_cols = cols;
+
+    // New tiles get textures on the next paint; every tile has a new size
+    for (int i = 0; i < tileCount(); ++i) subscribe(i);
+    update();
+}
+
+void VideoWallView::setTileSource(int tile, const QString& sourceId) {
+    if (tile < 0 || tile >= tileCount()) return;
+    Tile& t = *m_tiles[tile];
+    if (t.sourceId == sourceId) return;
+    unsubscribe(tile);
+    t.sourceId = sourceId;
+    t.pending = VideoFrame();
+    t.hasPending = false;
+    t.frameSize = QSize();
+    t.sourceSize = QSize();
+    subscribe(tile);
+    update();
+}
+
+QString VideoWallView::tileSource(int tile) const {
+    return tile >= 0 && tile < tileCount() ? m_tiles[tile]->sourceId : QString();
+}
+
+int VideoWallView::tileForSource(const QString& sourceId) const {
+    for (int i = 0; i < tileCount(); ++i) {
+        if (m_tiles[i]->sourceId == sourceId) return i;
+    }
+    return -1;
+}
+
+void VideoWallView::setTileLabel(int tile, const QString& label) {
+    if (tile < 0 || tile >= tileCount()) return;
+    m_tiles[tile]->label = label;
+    update();
+}
+
+QRect VideoWallView::tileRect(int tile) const {
+    if (tile < 0 || tile >= tileCount()) return QRect();
+    const int row = tile / m_cols;
+    const int col = tile % m_cols;
+    // Spacing between tiles only; the edges reach the widget's
+    const int x0 = col * (width() + TILE_SPACING) / m_cols;
+    const int x1 = (col + 1) * (width() + TILE_SPACING) / m_cols - TILE_SPACING;
+    const int y0 = row * (height() + TILE_SPACING) / m_rows;
+    const int y1 = (row + 1) * (height() + TILE_SPACING) / m_rows - TILE_SPACING;
+    return QRect(x0, y0, qMax(1, x1 - x0), qMax(1, y1 - y0));
+}
+
+int VideoWallView::tileAt(const QPoint& pos) const {
+    for (int i = 0; i < tileCount(); ++i) {
+        if (tileRect(i).contains(pos)) return i;
+    }
+    return -1;
+}
+
+QRect VideoWallView::frameRect(int tile) const {
+    const QRect cell = tileRect(tile);
+    const QSize frameSize = m_tiles[tile]->frameSize;
+    if (frameSize.isEmpty()) return cell;
+    const QSize fitted = frameSize.scaled(cell.size(), Qt::KeepAspectRatio);
+    return QRect(cell.x() + (cell.width() - fitted.width()) / 2,
+                 cell.y() + (cell.height() - fitted.height()) / 2,
+                 fitted.width(), fitted.height());
+}
+
+void VideoWallView::setMaxFps(double fps) {
+    m_maxFps = qMax(0.0, fps);
+    for (int i = 0; i < tileCount(); ++i) subscribe(i);
+}
+
+void VideoWallView::setOverlayEnabled(bool enabled) {
+    m_overlayEnabled = enabled;
+    update();
+}
+
+void VideoWallView::setOverlayRenderer(int tile, VideoOverlayRenderer* renderer) {
+    if (tile < 0 || tile >= tileCount()) return;
+    m_tiles[tile]->overlay = renderer;
+    m_tiles[tile]->overlayRevision = 0;
+    update();
+}
+
+void VideoWallView::setTileFrame(int tile, const VideoFrame& frame, const QSize& sourceSize) {
+    if (tile < 0 || tile >= tileCount() || frame.isNull()) return;
+    Tile& t = *m_tiles[tile];
+    // A frame not yet uploaded is simply replaced
+    t.pending = frame;
+    t.hasPending = true;
+    t.frameSize = frame.size();
+    t.sourceSize = sourceSize.isEmpty() ? frame.size() : sourceSize;
+    t.frameTimeMs = 0;
+    update();
+}
+
+void VideoWallView::subscribe(int tile) {
+    Tile& t = *m_tiles[tile];
+    if (!m_videoManager || t.sourceId.isEmpty()) return;
+
+    VideoDeliveryPolicy policy;
+    policy.targetSize = tileRect(tile).size();
+    policy.maxFps = m_maxFps;
+    if (t.subscription) {
+        m_videoManager->setDeliveryPolicy(t.subscription, policy);
+        return;
+    }
+    Tile* target = &t;
+    t.subscription = m_videoManager->subscribeFrames(
+        t.sourceId, this, policy,
+        [this, target](const VideoFrame& frame, qint64 timestamp, const QSize& sourceSize) {
+            // Tiles are only dropped after unsubscribing, which stops callbacks
+            target->pending = frame;
+            target->hasPending = true;
+            target->frameSize = frame.size();
+            target->sourceSize = sourceSize.isEmpty() ? frame.size() : sourceSize;
+            target->frameTimeMs = timestamp;
+            update();
+        });
+}
+
+void VideoWallView::unsubscribe(int tile) {
+    Tile& t = *m_tiles[tile];
+    if (m_videoManager && t.subscription) m_videoManager->unsubscribeFrames(t.subscription);
+    t.subscription = 0;
+}
+
+void VideoWallView::resizeEvent(QResizeEvent* event) {
+    QOpenGLWidget::resizeEvent(event);
+    for (int i = 0; i < tileCount(); ++i) subscribe(i);
+}
+
+void VideoWallView::mousePressEvent(QMouseEvent* event) {
+    const int tile = tileAt(event->pos());
+    if (tile >= 0) emit tileClicked(tile);
+    QOpenGLWidget::mousePressEvent(event);
+}
+
+void VideoWallView::mouseDoubleClickEvent(QMouseEvent* event) {
+    const int tile = tileAt(event->pos());
+    if (tile >= 0) emit tileDoubleClicked(tile);
+    QOpenGLWidget::mouseDoubleClickEvent(event);
+}
+
+void VideoWallView::initializeGL() {
+    initializeOpenGLFunctions();
+    connect(context(), &QOpenGLContext::aboutToBeDestroyed,
+            this, &VideoWallView::releaseGL, Qt::UniqueConnection);
+
+    m_caps = VideoTexture::probe(context());
+    m_usePbo = m_caps.pixelBuffers;
+    m_program = VideoTexture::buildProgram(context());
+    if (!m_program || !buildTextProgram()) {
+        m_program.reset();
+        return;
+    }
+
+    m_vao.reset(new QOpenGLVertexArrayObject);
+    m_vao->create();    // Required by core profiles, optional elsewhere
+
+    m_quad.create();
+    m_quad.bind();
+    m_quad.allocate(VideoTexture::QUAD, sizeof(VideoTexture::QUAD));
+    m_quad.release();
+    m_textBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    m_textBuffer.create();
+
+    if (m_usePbo) {
+        for (QOpenGLBuffer& pbo : m_pbo) {
+            pbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+            m_usePbo = pbo.create() && m_usePbo;
+        }
+    }
+
+    buildAtlas();
+
+    // A new context (reparenting recreates it) has no textures; every tile
+    // uploads its last frame again
+    for (std::unique_ptr<Tile>& tile : m_tiles) {
+        tile->hasPending = !tile->pending.isNull();
+        tile->overlayRevision = 0;
+    }
+}
+
+bool VideoWallView::buildTextProgram() {
+    const QByteArray header = VideoTexture::shaderHeader(context());
+    m_textProgram.reset(new QOpenGLShaderProgram);
+    const bool ok =
+        m_textProgram->addShaderFromSourceCode(QOpenGLShader::Vertex, header + TEXT_VERTEX_SHADER) &&
+        m_textProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, header + TEXT_FRAGMENT_SHADER);
+    m_textProgram->bindAttributeLocation("position", 0);
+    m_textProgram->bindAttributeLocation("atlasCoord", 1);
+    m_textProgram->bindAttributeLocation("color", 2);
+    if (!ok || !m_textProgram->link()) {
+        qWarning("VideoWallView: text shader build failed: %s", qPrintable(m_textProgram->log()));
+        m_textProgram.reset();
+        return false;
+    }
+    return true;
+}
+
+void VideoWallView::buildAtlas() {
+    // One row of printable ASCII at the screen's pixel density, and a
+    // solid cell at the end for caption backgrounds
+    const qreal dpr = devicePixelRatioF();
+    QFont atlasFont = font();
+    atlasFont.setPointSizeF(atlasFont.pointSizeF() * dpr);
+    const QFontMetricsF metrics(atlasFont);
+    const int cellHeight = qCeil(metrics.height()) + 2;
+    int atlasWidth = 4;
+    for (int c = FIRST_GLYPH; c < FIRST_GLYPH + 95; ++c) {
+        atlasWidth += qCeil(metrics.horizontalAdvance(QChar(c))) + 2;
+    }
+
+    QImage atlas(atlasWidth, cellHeight, QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+    {
+        QPainter painter(&atlas);
+        painter.setFont(atlasFont);
+        painter.setPen(Qt::white);
+        int x = 0;
+        for (int i = 0; i < 95; ++i) {
+            const QChar c(FIRST_GLYPH + i);
+            const qreal advance = metrics.horizontalAdvance(c);
+            const int cell = qCeil(advance) + 2;
+            painter.drawText(QPointF(x + 1, 1 + metrics.ascent()), QString(c));
+            Glyph& glyph = m_glyphs[i];
+            glyph.uv = QRectF(qreal(x) / atlasWidth, 0.0, qreal(cell) / atlasWidth, 1.0);
+            glyph.size = QSizeF(cell / dpr, cellHeight / dpr);
+            glyph.advance = advance / dpr;
+            x += cell;
+        }
+        painter.fillRect(QRect(atlasWidth - 4, 0, 4, cellHeight), Qt::white);
+    }
+    // The middle of the solid cell, clear of filtering at its edges
+    m_solidUv = QRectF((atlasWidth - 2.5) / atlasWidth, 0.25, 1.0 / atlasWidth, 0.5);
+    m_ascent = (1 + metrics.ascent()) / dpr;
+    m_lineHeight = cellHeight / dpr;
+
+    glGenTextures(1, &m_atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (m_caps.bgra) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas.width(), atlas.height(), 0,
+                     GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, atlas.constBits());
+    } else {
+        const QImage rgba = atlas.convertToFormat(QImage::Format_RGBA8888_Premultiplied);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, rgba.width(), rgba.height(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, rgba.constBits());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VideoWallView::paintGL() {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!m_program) return;
+    ++m_paints;
+
+    // Only tiles with a frame since the last paint upload
+    for (std::unique_ptr<Tile>& tile : m_tiles) {
+        if (!tile->texture.isCreated()) tile->texture.create(this, m_caps);
+        if (!tile->hasPending) continue;
+        QOpenGLBuffer* staging = m_usePbo ? &m_pbo[m_nextPbo] : nullptr;
+        m_nextPbo ^= 1;
+        if (tile->texture.upload(tile->pending, staging)) ++m_framesUploaded;
+        tile->hasPending = false;
+    }
+
+    const qreal dpr = devicePixelRatioF();
+    const auto setViewport = [this, dpr](const QRect& rect) {
+        glViewport(qRound(rect.x() * dpr), qRound((height() - rect.y() - rect.height()) * dpr),
+                   qRound(rect.width() * dpr), qRound(rect.height() * dpr));
+    };
+
+    m_program->bind();
+    for (int i = 0; i < tileCount(); ++i) {
+        VideoTexture& texture = m_tiles[i]->texture;
+        if (m_tiles[i]->frameSize.isEmpty() || !texture.hasFrame()) continue;
+        setViewport(frameRect(i));
+        texture.bindFrame(m_program.get());
+        drawQuad(texture.shaderMode());
+    }
+    if (!m_tiles.empty()) m_tiles.front()->texture.unbind();
+
+    // Overlay layers cover their tiles' frame rects, so the same quads blend them on
+    if (m_overlayEnabled) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        for (int i = 0; i < tileCount(); ++i) {
+            Tile& tile = *m_tiles[i];
+            if (!tile.overlay || tile.frameSize.isEmpty() || !tile.texture.hasFrame()) continue;
+            tile.overlay->setFrameTime(tile.frameTimeMs);
+            tile.overlay->updateLayer(tile.sourceSize);
+            const QImage& layer = tile.overlay->layer();
+            const QRect changed = tile.overlay->layerChangedSince(tile.overlayRevision);
+            tile.overlayRevision = tile.overlay->layerRevision();
+            if (layer.isNull() || !tile.texture.uploadOverlay(layer, changed)) continue;
+            setViewport(frameRect(i));
+            tile.texture.bindOverlay();
+            drawQuad(3);
+        }
+        glDisable(GL_BLEND);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_program->release();
+
+    glViewport(0, 0, qRound(width() * dpr), qRound(height() * dpr));
+    drawText();
+}
+
+void VideoWallView::drawQuad(int shaderMode) {
+    m_program->setUniformValue("mode", shaderMode);
+    QOpenGLVertexArrayObject::Binder vaoBinder(m_vao.get());
+    m_quad.bind();
+    m_program->enableAttributeArray(0);
+    m_program->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    m_program->disableAttributeArray(0);
+    m_quad.release();
+}
+
+void VideoWallView::addQuad(QVector<float>& vertices, const QRectF& rect, const QRectF& uv,
+                            const QColor& color) const {
+    // Widget pixels to clip space, two triangles
+    const float x0 = float(2.0 * rect.left() / width() - 1.0);
+    const float x1 = float(2.0 * rect.right() / width() - 1.0);
+    const float y0 = float(1.0 - 2.0 * rect.top() / height());
+    const float y1 = float(1.0 - 2.0 * rect.bottom() / height());
+    const float a = float(color.alphaF());
+    const float r = float(color.redF()) * a;
+    const float g = float(color.greenF()) * a;
+    const float b = float(color.blueF()) * a;
+    const float corners[6][4] = {
+        {x0, y0, float(uv.left()), float(uv.top())},
+        {x1, y0, float(uv.right()), float(uv.top())},
+        {x0, y1, float(uv.left()), float(uv.bottom())},
+        {x1, y0, float(uv.right()), float(uv.top())},
+        {x1, y1, float(uv.right()), float(uv.bottom())},
+        {x0, y1, float(uv.left()), float(uv.bottom())},
+    };
+    for (const auto& corner : corners) {
+        vertices << corner[0] << corner[1] << corner[2] << corner[3] << r << g << b << a;
+    }
+}
+
+qreal VideoWallView::textWidth(const QString& text) const {
+    qreal width = 0.0;
+    for (QChar c : text) {
+        const int index = c.unicode() - FIRST_GLYPH;
+        width += m_glyphs[index >= 0 && index < 95 ? index : '?' - FIRST_GLYPH].advance;
+    }
+    return width;
+}
+
+void VideoWallView::addText(QVector<float>& vertices, const QString& text, QPointF baseline,
+                            const QColor& color) const {
+    // Whole pixels keep the glyphs sharp
+    qreal x = std::round(baseline.x());
+    const qreal top = std::round(baseline.y() - m_ascent);
+    for (QChar c : text) {
+        int index = c.unicode() - FIRST_GLYPH;
+        if (index < 0 || index >= 95) index = '?' - FIRST_GLYPH;
+        const Glyph& glyph = m_glyphs[index];
+        if (c != QLatin1Char(' ')) {
+            addQuad(vertices, QRectF(QPointF(x - 1.0 / devicePixelRatioF(), top), glyph.size),
+                    glyph.uv, color);
+        }
+        x += glyph.advance;
+    }
+}
+
+void VideoWallView::drawText() {
+    if (!m_textProgram || m_atlasTexture == 0) return;
+
+    // Every caption of every tile, batched into one draw
+    QVector<float> vertices;
+    const QString clock = QDateTime::currentDateTime().toString("hh:mm:ss");
+    const QColor shade(0, 0, 0, 160);
+    for (int i = 0; i < tileCount(); ++i) {
+        const Tile& tile = *m_tiles[i];
+        const QRect cell = tileRect(i);
+        if (tile.frameSize.isEmpty()) {
+            const QString text = tile.sourceId.isEmpty() ? QStringLiteral("No Video Source") : tile.sourceId;
+            addText(vertices, text,
+                    QPointF(cell.center().x() - textWidth(text) / 2,
+                            cell.center().y() + m_ascent - m_lineHeight / 2),
+                    Qt::gray);
+            continue;
+        }
+        if (!m_overlayEnabled) continue;
+        const QString caption = tile.label.isEmpty() ? tile.sourceId : tile.label;
+        const QPointF top(cell.left() + 10, cell.top() + 20);
+        const QPointF bottom(cell.left() + 10, cell.bottom() - 10);
+        addQuad(vertices, QRectF(top.x() - 4, top.y() - m_ascent - 2, textWidth(caption) + 8,
+                                 m_lineHeight + 4), m_solidUv, shade);
+        addText(vertices, caption, top, Qt::white);
+        addText(vertices, clock, bottom, Qt::white);
+    }
+    if (vertices.isEmpty()) return;
+
+    m_textProgram->bind();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+    m_textProgram->setUniformValue("atlas", 0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    QOpenGLVertexArrayObject::Binder vaoBinder(m_vao.get());
+    m_textBuffer.bind();
+    m_textBuffer.allocate(vertices.constData(), vertices.size() * int(sizeof(float)));
+    const int stride = FLOATS_PER_VERTEX * int(sizeof(float));
+    for (int attribute = 0; attribute < 3; ++attribute) m_textProgram->enableAttributeArray(attribute);
+    m_textProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2, stride);
+    m_textProgram->setAttributeBuffer(1, GL_FLOAT, 2 * sizeof(float), 2, stride);
+    m_textProgram->setAttributeBuffer(2, GL_FLOAT, 4 * sizeof(float), 4, stride);
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / FLOATS_PER_VERTEX);
+    for (int attribute = 0; attribute < 3; ++attribute) m_textProgram->disableAttributeArray(attribute);
+    m_textBuffer.release();
+
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_textProgram->release();
+}
+
+void VideoWallView::releaseGL() {
+    if (!m_program && !m_textProgram && m_atlasTexture == 0) return;
+    makeCurrent();
+    for (std::unique_ptr<Tile>& tile : m_tiles) tile->texture.destroy();
+    if (m_atlasTexture != 0) {
+        glDeleteTextures(1, &m_atlasTexture);
+        m_atlasTexture = 0;
+    }
+    for (QOpenGLBuffer& pbo : m_pbo) {
+        pbo.destroy();
+    }
+    m_quad.destroy();
+    m_textBuffer.destroy();
+    if (m_vao) m_vao->destroy();
+    m_vao.reset();
+    m_program.reset();
+    m_textProgram.reset();
+    doneCurrent();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,155 @@
+#ifndef VIDEOWALLVIEW_H
+#define VIDEOWALLVIEW_H
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <QColor>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+#include "ui/VideoTexture.h"
+#include "utils/VideoFrame.h"
+
+class QOpenGLShaderProgram;
+class QOpenGLVertexArrayObject;
+
+namespace CounterUAS {
+
+class VideoStreamManager;
+class VideoOverlayRenderer;
+
+/**
+ * @brief Every tile of a video grid composited on one OpenGL surface
+ *
+ * Where a grid of VideoDisplayWidgets paints each tile in its own pass,
+ * this draws them all in one: each tile is a quad in its own viewport,
+ * with the frame's textures from VideoTexture, uploaded only when that
+ * tile has a new frame since the last paint, and its overlay layer
+ * blended over it from the rect that changed. Tile captions and the
+ * clock come from a glyph atlas built once per context, every glyph of
+ * every tile in one vertex buffer and one draw call.
+ *
+ * Tiles subscribe to their sources at tile size, so frames arrive already
+ * scaled by the manager's scaler thread; paints are coalesced by the
+ * surface, so a 4x4 wall of 30 fps cameras costs about one paint per
+ * display refresh rather than sixteen per frame period.
+ */
+class VideoWallView : public QOpenGLWidget, protected QOpenGLFunctions {
+    Q_OBJECT
+
+public:
+    static constexpr int TILE_SPACING = 4;
+
+    explicit VideoWallView(QWidget* parent = nullptr);
+    ~VideoWallView() override;
+
+    void setVideoManager(VideoStreamManager* manager);
+
+    // Tiles are numbered row-major; existing sources keep their tiles
+    void setGridSize(int rows, int cols);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int tileCount() const { return static_cast<int>(m_tiles.size()); }
+
+    void setTileSource(int tile, const QString& sourceId);
+    QString tileSource(int tile) const;
+    int tileForSource(const QString& sourceId) const;   // -1 if none
+    // Caption instead of the source id
+    void setTileLabel(int tile, const QString& label);
+
+    // Widget coordinates
+    QRect tileRect(int tile) const;
+    int tileAt(const QPoint& pos) const;
+
+    // Caps delivery from the manager; 0 for the source's rate
+    void setMaxFps(double fps);
+    void setOverlayEnabled(bool enabled);
+    bool overlayEnabled() const { return m_overlayEnabled; }
+    // Drawn in frame pixel coordinates over the tile's video
+    void setOverlayRenderer(int tile, VideoOverlayRenderer* renderer);
+
+    // A frame for a tile from outside the manager; sourceSize maps the overlay
+    void setTileFrame(int tile, const VideoFrame& frame, const QSize& sourceSize = QSize());
+
+    quint64 framesUploaded() const { return m_framesUploaded; }
+    quint64 paints() const { return m_paints; }
+
+signals:
+    void tileClicked(int tile);
+    void tileDoubleClicked(int tile);
+
+protected:
+    void initializeGL() override;
+    void paintGL() override;
+    void resizeEvent(QResizeEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+private:
+    struct Tile {
+        QString sourceId;
+        QString label;
+        int subscription = 0;
+        VideoFrame pending;
+        bool hasPending = false;
+        QSize frameSize;            // Of the last frame, for letterboxing
+        QSize sourceSize;           // Overlay coordinates
+        qint64 frameTimeMs = 0;     // Capture time the overlay is aligned to; 0 for now
+        VideoTexture texture;
+        QPointer<VideoOverlayRenderer> overlay;
+        quint64 overlayRevision = 0;
+    };
+
+    struct Glyph {
+        QRectF uv;
+        QSizeF size;                // Logical pixels
+        qreal advance = 0.0;
+    };
+
+    void subscribe(int tile);
+    void unsubscribe(int tile);
+    QRect frameRect(int tile) const;
+    bool buildTextProgram();
+    void buildAtlas();
+    void addQuad(QVector<float>& vertices, const QRectF& rect, const QRectF& uv, const QColor& color) const;
+    void addText(QVector<float>& vertices, const QString& text, QPointF baseline, const QColor& color) const;
+    qreal textWidth(const QString& text) const;
+    void drawQuad(int shaderMode);
+    void drawText();
+    void releaseGL();
+
+    QPointer<VideoStreamManager> m_videoManager;
+    std::vector<std::unique_ptr<Tile>> m_tiles;
+    int m_rows = 1;
+    int m_cols = 1;
+    double m_maxFps = 0.0;
+    bool m_overlayEnabled = true;
+    QTimer* m_clockTimer;
+
+    VideoTexture::Caps m_caps;
+    std::unique_ptr<QOpenGLShaderProgram> m_program;
+    std::unique_ptr<QOpenGLShaderProgram> m_textProgram;
+    std::unique_ptr<QOpenGLVertexArrayObject> m_vao;
+    QOpenGLBuffer m_quad;
+    QOpenGLBuffer m_textBuffer;
+    QOpenGLBuffer m_pbo[2];        // Shared by the tiles, alternated per upload
+    int m_nextPbo = 0;
+    bool m_usePbo = false;
+
+    GLuint m_atlasTexture = 0;
+    Glyph m_glyphs[95];            // Printable ASCII
+    QRectF m_solidUv;              // An opaque texel for backgrounds
+    qreal m_ascent = 0.0;
+    qreal m_lineHeight = 0.0;
+
+    quint64 m_framesUploaded = 0;
+    quint64 m_paints = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEOWALLVIEW_H
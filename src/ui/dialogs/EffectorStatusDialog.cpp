@@ -5,6 +5,7 @@
 
 #include "ui/dialogs/EffectorStatusDialog.h"
 #include "core/EngagementManager.h"
+#include "ui/UIFrameScheduler.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
@@ -17,15 +18,16 @@ namespace CounterUAS {
 EffectorStatusDialog::EffectorStatusDialog(EngagementManager* manager, QWidget* parent)
     : QDialog(parent)
     , m_manager(manager)
-    , m_refreshTimer(new QTimer(this))
 {
     setWindowTitle("Effector Status");
     setMinimumSize(800, 500);
     
     setupUI();
     
-    connect(m_refreshTimer, &QTimer::timeout, this, &EffectorStatusDialog::refreshStatus);
-    m_refreshTimer->start(500);  // Refresh every 500ms
+    if (m_manager) {
+        connect(m_manager, &EngagementManager::effectorEvent,
+                this, &EffectorStatusDialog::onEffectorEvent);
+    }
     
     refreshStatus();
 }
@@ -124,22 +126,101 @@ void EffectorStatusDialog::refreshStatus() {
     
     // Update table
     m_effectorTable->setRowCount(effectors.size());
+    m_rowByEffector.clear();
     
     for (int i = 0; i < effectors.size(); i++) {
         auto* eff = effectors[i];
         
         m_effectorTable->setItem(i, 0, new QTableWidgetItem(eff->effectorId()));
         m_effectorTable->setItem(i, 1, new QTableWidgetItem(eff->effectorType()));
-        
-        QString statusStr = statusToString(eff->status());
-        QTableWidgetItem* statusItem = new QTableWidgetItem(statusStr);
-        statusItem->setForeground(statusToColor(eff->status()));
-        m_effectorTable->setItem(i, 2, statusItem);
-        
-        QString readiness = QString("%1%").arg(eff->health().readiness * 100, 0, 'f', 0);
-        m_effectorTable->setItem(i, 3, new QTableWidgetItem(readiness));
+        m_effectorTable->setItem(i, 2, new QTableWidgetItem());
+        m_effectorTable->setItem(i, 3, new QTableWidgetItem());
+        updateRow(i, eff);
+        m_rowByEffector.insert(eff->effectorId(), i);
     }
     
+    updateDetail();
+}
+
+void EffectorStatusDialog::onEffectorEvent(const EffectorEvent& event) {
+    if (!m_manager) return;
+    
+    auto* eff = m_manager->effector(event.effectorId);
+    const int row = m_rowByEffector.value(event.effectorId, -1);
+    if (!eff || row < 0) {
+        // Registered since the table was built
+        refreshStatus();
+        return;
+    }
+    
+    updateRow(row, eff);
+    if (event.effectorId == m_selectedEffectorId) {
+        updateDetail();
+    }
+}
+
+void EffectorStatusDialog::setFrameScheduler(UIFrameScheduler* scheduler) {
+    if (m_frameScheduler) {
+        m_frameScheduler->removeClient(this);
+    }
+    m_frameScheduler = scheduler;
+    if (!m_manager) return;
+    
+    disconnect(m_manager, &EngagementManager::effectorEvent, this, &EffectorStatusDialog::onEffectorEvent);
+    if (m_frameScheduler) {
+        m_frameScheduler->addClient(this, 10, [this](const UIFrame& frame) { onFrame(frame); });
+        m_frameScheduler->setClientTriggers(this, FrameOnStatus, StatusBoard::kindBit(StatusKind::Effector));
+    } else {
+        connect(m_manager, &EngagementManager::effectorEvent,
+                this, &EffectorStatusDialog::onEffectorEvent);
+    }
+}
+
+void EffectorStatusDialog::onFrame(const UIFrame& frame) {
+    if (!m_manager) return;
+    
+    bool selectedChanged = false;
+    for (const StatusSnapshotPtr& status : frame.status) {
+        if (status->removed) continue;
+        auto* eff = m_manager->effector(status->source);
+        const int row = m_rowByEffector.value(status->source, -1);
+        if (!eff) continue;
+        if (row < 0) {
+            // Registered since the table was built
+            refreshStatus();
+            return;
+        }
+        
+        if (status->changed("status", frame.statusSince)) {
+            updateStatusCell(row, eff);
+        }
+        if (status->changed("readiness", frame.statusSince)) {
+            updateReadinessCell(row, eff);
+        }
+        selectedChanged |= status->source == m_selectedEffectorId;
+    }
+    if (selectedChanged) {
+        updateDetail();
+    }
+}
+
+void EffectorStatusDialog::updateRow(int row, EffectorInterface* eff) {
+    updateStatusCell(row, eff);
+    updateReadinessCell(row, eff);
+}
+
+void EffectorStatusDialog::updateStatusCell(int row, EffectorInterface* eff) {
+    QTableWidgetItem* statusItem = m_effectorTable->item(row, 2);
+    statusItem->setText(statusToString(eff->status()));
+    statusItem->setForeground(statusToColor(eff->status()));
+}
+
+void EffectorStatusDialog::updateReadinessCell(int row, EffectorInterface* eff) {
+    QString readiness = QString("%1%").arg(eff->health().readiness * 100, 0, 'f', 0);
+    m_effectorTable->item(row, 3)->setText(readiness);
+}
+
+void EffectorStatusDialog::updateDetail() {
     // Update detail panel if effector selected
     if (!m_selectedEffectorId.isEmpty()) {
         auto* eff = m_manager->effector(m_selectedEffectorId);
@@ -162,6 +243,16 @@ void EffectorStatusDialog::refreshStatus() {
             } else {
                 m_detailRoundsRemaining->setText("N/A");
             }
+            
+            // Controls follow the status as it is pushed
+            bool isOffline = eff->status() == EffectorStatus::Offline;
+            bool isReady = eff->status() == EffectorStatus::Ready;
+            bool isFault = eff->status() == EffectorStatus::Fault;
+            
+            m_initBtn->setEnabled(isOffline);
+            m_shutdownBtn->setEnabled(!isOffline);
+            m_resetBtn->setEnabled(isFault);
+            m_testBtn->setEnabled(isReady);
         }
     }
 }
@@ -177,18 +268,7 @@ void EffectorStatusDialog::onEffectorSelected(int row) {
     }
     
     m_selectedEffectorId = m_effectorTable->item(row, 0)->text();
-    
-    auto* eff = m_manager->effector(m_selectedEffectorId);
-    if (eff) {
-        bool isOffline = eff->status() == EffectorStatus::Offline;
-        bool isReady = eff->status() == EffectorStatus::Ready;
-        bool isFault = eff->status() == EffectorStatus::Fault;
-        
-        m_initBtn->setEnabled(isOffline);
-        m_shutdownBtn->setEnabled(!isOffline);
-        m_resetBtn->setEnabled(isFault);
-        m_testBtn->setEnabled(isReady);
-    }
+    updateDetail();
 }
 
 void EffectorStatusDialog::onInitialize() {
@@ -11,15 +11,22 @@
 #include <QProgressBar>
 #include <QLabel>
 #include <QPushButton>
-#include <QTimer>
+#include <QHash>
 #include "effectors/EffectorInterface.h"
 
 namespace CounterUAS {
 
 class EngagementManager;
+class UIFrameScheduler;
+struct UIFrame;
 
 /**
  * @brief Dialog for viewing effector status and control
+ *
+ * Rows follow the manager's effectorEvent(): each event redraws the row
+ * of the effector that sent it, and the details if it is the selected one.
+ * Given a frame scheduler, it takes the effectors' StatusBoard snapshots
+ * in its frames instead and rewrites only the cells whose fields changed.
  */
 class EffectorStatusDialog : public QDialog {
     Q_OBJECT
@@ -27,6 +34,8 @@ class EffectorStatusDialog : public QDialog {
 public:
     explicit EffectorStatusDialog(EngagementManager* manager, QWidget* parent = nullptr);
     
+    void setFrameScheduler(UIFrameScheduler* scheduler);
+    
 signals:
     void effectorInitializeRequested(const QString& effectorId);
     void effectorShutdownRequested(const QString& effectorId);
@@ -34,6 +43,7 @@ signals:
     
 private slots:
     void refreshStatus();
+    void onEffectorEvent(const EffectorEvent& event);
     void onEffectorSelected(int row);
     void onInitialize();
     void onShutdown();
@@ -42,10 +52,16 @@ private slots:
     
 private:
     void setupUI();
+    void onFrame(const UIFrame& frame);
+    void updateRow(int row, EffectorInterface* eff);
+    void updateStatusCell(int row, EffectorInterface* eff);
+    void updateReadinessCell(int row, EffectorInterface* eff);
+    void updateDetail();
     QString statusToString(EffectorStatus status);
     QColor statusToColor(EffectorStatus status);
     
     EngagementManager* m_manager;
+    UIFrameScheduler* m_frameScheduler = nullptr;
     
     QTableWidget* m_effectorTable;
     
@@ -65,7 +81,7 @@ private:
     QPushButton* m_resetBtn;
     QPushButton* m_testBtn;
     
-    QTimer* m_refreshTimer;
+    QHash<QString, int> m_rowByEffector;
     QString m_selectedEffectorId;
 };
 
@@ -0,0 +1,234 @@
+#include "utils/AssignmentSolver.h"
+#include "utils/TimeUtils.h"
+#include <algorithm>
+#include <limits>
+
+namespace CounterUAS {
+
+QVector<int> AssignmentSolver::solve(const QVector<double>& cost, int rows, int cols) {
+    QVector<int> result(rows, -1);
+    if (rows <= 0 || cols <= 0 || cost.size() < rows * cols) return result;
+
+    // With no more rows than columns every row can be matched as it is, so
+    // iterate rows x cols directly. Otherwise pad the columns to a square
+    // problem; dummy cells carry the forbidden cost so they are only chosen
+    // when nothing real is available.
+    const int n = std::max(rows, cols);
+    const int R = rows <= cols ? rows : n;
+    const int C = n;
+    auto at = [&](int r, int c) -> double {
+        if (r >= rows || c >= cols) return FORBIDDEN_COST;
+        return std::min(cost[r * cols + c], FORBIDDEN_COST);
+    };
+
+    // Shortest augmenting path formulation with row/column potentials.
+    // Arrays are 1-based; index 0 is the virtual source column.
+    const double INF = std::numeric_limits<double>::infinity();
+    QVector<double> u(R + 1, 0.0);
+    QVector<double> v(C + 1, 0.0);
+    QVector<int> match(C + 1, 0);   // match[col] = row
+    QVector<int> way(C + 1, 0);
+    QVector<double> minv(C + 1);
+    QVector<char> used(C + 1);
+
+    for (int i = 1; i <= R; ++i) {
+        match[0] = i;
+        int j0 = 0;
+        minv.fill(INF);
+        used.fill(0);
+
+        do {
+            used[j0] = 1;
+            int i0 = match[j0];
+            double delta = INF;
+            int j1 = 0;
+
+            for (int j = 1; j <= C; ++j) {
+                if (used[j]) continue;
+                double cur = at(i0 - 1, j - 1) - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+
+            for (int j = 0; j <= C; ++j) {
+                if (used[j]) {
+                    u[match[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (match[j0] != 0);
+
+        do {
+            int j1 = way[j0];
+            match[j0] = match[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    for (int j = 1; j <= C; ++j) {
+        if (match[j] == 0) continue;
+        int r = match[j] - 1;
+        int c = j - 1;
+        if (r < rows && c < cols && at(r, c) < FORBIDDEN_COST) {
+            result[r] = c;
+        }
+    }
+
+    return result;
+}
+
+QVector<int> AssignmentSolver::solveClustered(const QVector<QVector<QPair<int, double>>>& gated,
+                                              int cols) {
+    const int rows = gated.size();
+    QVector<int> result(rows, -1);
+    if (rows == 0 || cols <= 0) return result;
+
+    // Union-find over row nodes [0, rows) and column nodes [rows, rows + cols)
+    QVector<int> parent(rows + cols);
+    for (int i = 0; i < parent.size(); ++i) parent[i] = i;
+    auto find = [&parent](int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    };
+
+    for (int r = 0; r < rows; ++r) {
+        for (const auto& entry : gated[r]) {
+            if (entry.first < 0 || entry.first >= cols) continue;
+            int a = find(r);
+            int b = find(rows + entry.first);
+            if (a != b) parent[a] = b;
+        }
+    }
+
+    // Group rows by cluster root; rows without gates stay unassigned
+    QVector<QVector<int>> clusterRows(rows + cols);
+    for (int r = 0; r < rows; ++r) {
+        if (!gated[r].isEmpty()) clusterRows[find(r)].append(r);
+    }
+
+    QVector<int> localCol(cols, -1);
+    for (const QVector<int>& members : clusterRows) {
+        if (members.isEmpty()) continue;
+
+        // Single plot: take its cheapest gate directly
+        if (members.size() == 1) {
+            const int r = members.first();
+            double best = FORBIDDEN_COST;
+            for (const auto& entry : gated[r]) {
+                if (entry.second < best) {
+                    best = entry.second;
+                    result[r] = entry.first;
+                }
+            }
+            continue;
+        }
+
+        QVector<int> globalCol;
+        for (int r : members) {
+            for (const auto& entry : gated[r]) {
+                if (localCol[entry.first] < 0) {
+                    localCol[entry.first] = globalCol.size();
+                    globalCol.append(entry.first);
+                }
+            }
+        }
+
+        const int subRows = members.size();
+        const int subCols = globalCol.size();
+        QVector<double> cost(subRows * subCols, FORBIDDEN_COST);
+        for (int i = 0; i < subRows; ++i) {
+            for (const auto& entry : gated[members[i]]) {
+                double& cell = cost[i * subCols + localCol[entry.first]];
+                cell = std::min(cell, entry.second);
+            }
+        }
+
+        QVector<int> sub = solve(cost, subRows, subCols);
+        for (int i = 0; i < subRows; ++i) {
+            if (sub[i] >= 0) result[members[i]] = globalCol[sub[i]];
+        }
+        for (int c : globalCol) localCol[c] = -1;
+    }
+
+    return result;
+}
+
+QVector<AssignmentSolver::RankedAssignment> AssignmentSolver::solveKBest(
+        const QVector<double>& cost, int rows, int cols, int k,
+        const std::function<bool(const QVector<int>&)>& accept, qint64 deadlineNs) {
+    QVector<RankedAssignment> ranked;
+    if (rows <= 0 || rows > cols || k <= 0 || cost.size() < rows * cols) return ranked;
+
+    // A subproblem is the full matrix with some cells forbidden and rows
+    // [0, fixedRows) held to the column they had in its parent
+    struct Node {
+        QVector<double> cost;
+        QVector<int> assignment;
+        double total = 0.0;
+        int fixedRows = 0;
+    };
+    auto solveNode = [rows, cols](Node& node) {
+        node.assignment = solve(node.cost, rows, cols);
+        node.total = 0.0;
+        for (int r = 0; r < rows; ++r) {
+            if (node.assignment[r] < 0) return false;   // Only forbidden cells left for it
+            node.total += node.cost[r * cols + node.assignment[r]];
+        }
+        return true;
+    };
+
+    Node root;
+    root.cost = cost;
+    if (!solveNode(root)) return ranked;
+
+    // Open subproblems, kept sorted with the cheapest last
+    QVector<Node> open;
+    open.append(std::move(root));
+    int examined = 0;
+    while (!open.isEmpty() && ranked.size() < k && examined < 4 * k) {
+        Node node = open.takeLast();
+        ++examined;
+        if (!accept || accept(node.assignment)) {
+            ranked.append({node.assignment, node.total});
+        }
+        auto late = [deadlineNs]() { return deadlineNs > 0 && TimeUtils::monotonicNs() > deadlineNs; };
+        if (ranked.size() >= k || late()) break;
+
+        // Partition what is left of this subproblem: child i keeps the
+        // columns of free rows before row i and is denied row i's
+        for (int i = node.fixedRows; i < rows && !(i > node.fixedRows && late()); ++i) {
+            Node child;
+            child.cost = node.cost;
+            child.fixedRows = i;
+            for (int r = node.fixedRows; r < i; ++r) {
+                const int c = node.assignment[r];
+                for (int j = 0; j < cols; ++j) {
+                    if (j != c) child.cost[r * cols + j] = FORBIDDEN_COST;
+                }
+                for (int other = 0; other < rows; ++other) {
+                    if (other != r) child.cost[other * cols + c] = FORBIDDEN_COST;
+                }
+            }
+            child.cost[i * cols + node.assignment[i]] = FORBIDDEN_COST;
+            if (!solveNode(child)) continue;
+            auto at = std::lower_bound(open.begin(), open.end(), child.total,
+                                       [](const Node& n, double total) { return n.total > total; });
+            open.insert(at, std::move(child));
+        }
+    }
+    return ranked;
+}
+
+} // namespace CounterUAS
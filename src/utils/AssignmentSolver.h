@@ -0,0 +1,46 @@
+#ifndef ASSIGNMENTSOLVER_H
+#define ASSIGNMENTSOLVER_H
+
+#include <QVector>
+#include <QPair>
+#include <functional>
+
+namespace CounterUAS {
+
+/**
+ * @brief Optimal rectangular assignment (Hungarian / Munkres algorithm)
+ *
+ * Cost matrices are dense and row-major. Entries at or above
+ * FORBIDDEN_COST are treated as gated out and never returned as a match.
+ */
+class AssignmentSolver {
+public:
+    static constexpr double FORBIDDEN_COST = 1.0e9;
+
+    // Returns, for every row, the assigned column or -1 if unassigned.
+    // Runs in O(rows^2 * cols) when rows <= cols, else O(n^3) with n = rows.
+    static QVector<int> solve(const QVector<double>& cost, int rows, int cols);
+    
+    // Sparse form: gated[row] lists (column, cost) pairs. Rows and columns
+    // are split into independent clusters first, so cost grows with the
+    // largest cluster rather than with the whole scan.
+    static QVector<int> solveClustered(const QVector<QVector<QPair<int, double>>>& gated, int cols);
+    
+    struct RankedAssignment {
+        QVector<int> assignment;    // Column of every row
+        double cost = 0.0;
+    };
+    // Murty's k-best: up to k assignments of every row, cheapest first.
+    // Needs rows <= cols. accept, when set, vets each one as it is ranked;
+    // a rejected assignment does not count towards k, though those ranked
+    // after it are still searched. The cheapest is always ranked; after it,
+    // returns what it has once deadlineNs on TimeUtils::monotonicNs()
+    // passes (0 for none) or 4k assignments have been ranked.
+    static QVector<RankedAssignment> solveKBest(const QVector<double>& cost, int rows, int cols, int k,
+                                                const std::function<bool(const QVector<int>&)>& accept = nullptr,
+                                                qint64 deadlineNs = 0);
+};
+
+} // namespace CounterUAS
+
+#endif // ASSIGNMENTSOLVER_H
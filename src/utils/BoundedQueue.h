@@ -0,0 +1,106 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace CounterUAS {
+
+/**
+ * @brief Bounded lock-free multi-producer / multi-consumer queue
+ *
+ * A fixed ring of cells, each tagged with a sequence number that tells
+ * producers and consumers whether the cell is free or full for the current
+ * lap around the ring. tryPush() fails instead of blocking when the ring is
+ * full, so a stalled consumer can never back-pressure a socket reader.
+ * Capacity is rounded up to a power of two.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity = 1024)
+        : m_mask(roundUp(capacity) - 1)
+    {
+        m_cells.reset(new Cell[m_mask + 1]);
+        for (std::size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    bool tryPush(T value) {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[pos & m_mask];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& out) {
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[pos & m_mask];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.value = T();  // Don't pin payload memory for a whole lap
+                    cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Empty
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+    // Exact only while no push or pop is in flight
+    std::size_t sizeApprox() const {
+        std::size_t tail = m_enqueuePos.load(std::memory_order_relaxed);
+        std::size_t head = m_dequeuePos.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t roundUp(std::size_t n) {
+        std::size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+    alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
+};
+
+} // namespace CounterUAS
+
+#endif // BOUNDEDQUEUE_H
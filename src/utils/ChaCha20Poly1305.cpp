@@ -0,0 +1,249 @@
+#include "utils/ChaCha20Poly1305.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 SIGMA[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};   // "expand 32-byte k"
+constexpr quint32 LIMB = 0x3ffffff;
+
+inline quint32 rotl(quint32 v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+inline quint32 load32(const quint8* p) {
+    return qFromLittleEndian<quint32>(p);
+}
+
+inline void quarterRound(quint32* x, int a, int b, int c, int d) {
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+    x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+    x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+}
+
+void chachaRounds(const quint32* input, quint32* x) {
+    std::memcpy(x, input, 16 * sizeof(quint32));
+    for (int i = 0; i < 10; ++i) {
+        quarterRound(x, 0, 4, 8, 12);
+        quarterRound(x, 1, 5, 9, 13);
+        quarterRound(x, 2, 6, 10, 14);
+        quarterRound(x, 3, 7, 11, 15);
+        quarterRound(x, 0, 5, 10, 15);
+        quarterRound(x, 1, 6, 11, 12);
+        quarterRound(x, 2, 7, 8, 13);
+        quarterRound(x, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; ++i) {
+        x[i] += input[i];
+    }
+}
+
+// Poly1305 over h in 26-bit limbs, fed whole 16-byte blocks
+class Poly1305 {
+public:
+    explicit Poly1305(const quint8* key) {
+        m_r[0] = load32(key) & 0x3ffffff;
+        m_r[1] = (load32(key + 3) >> 2) & 0x3ffff03;
+        m_r[2] = (load32(key + 6) >> 4) & 0x3ffc0ff;
+        m_r[3] = (load32(key + 9) >> 6) & 0x3f03fff;
+        m_r[4] = (load32(key + 12) >> 8) & 0x00fffff;
+        for (int i = 0; i < 4; ++i) {
+            m_pad[i] = load32(key + 16 + 4 * i);
+        }
+    }
+
+    // Whole blocks of data, the tail zero padded as the AEAD pads it
+    void updatePadded(const quint8* data, int size) {
+        const int whole = size & ~15;
+        blocks(data, whole, 1u << 24);
+        if (whole < size) {
+            quint8 last[16] = {};
+            std::memcpy(last, data + whole, size - whole);
+            blocks(last, 16, 1u << 24);
+        }
+    }
+
+    // The plain MAC's tail: a 1 after the last byte in place of the high bit
+    void updateFinal(const quint8* data, int size) {
+        const int whole = size & ~15;
+        blocks(data, whole, 1u << 24);
+        if (whole < size) {
+            quint8 last[16] = {};
+            std::memcpy(last, data + whole, size - whole);
+            last[size - whole] = 1;
+            blocks(last, 16, 0);
+        }
+    }
+
+    void finish(quint8* tag) {
+        quint32 h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+        quint32 c = h1 >> 26; h1 &= LIMB;
+        h2 += c; c = h2 >> 26; h2 &= LIMB;
+        h3 += c; c = h3 >> 26; h3 &= LIMB;
+        h4 += c; c = h4 >> 26; h4 &= LIMB;
+        h0 += c * 5; c = h0 >> 26; h0 &= LIMB;
+        h1 += c;
+
+        // h - p, kept if it did not go negative
+        quint32 g0 = h0 + 5; c = g0 >> 26; g0 &= LIMB;
+        quint32 g1 = h1 + c; c = g1 >> 26; g1 &= LIMB;
+        quint32 g2 = h2 + c; c = g2 >> 26; g2 &= LIMB;
+        quint32 g3 = h3 + c; c = g3 >> 26; g3 &= LIMB;
+        quint32 g4 = h4 + c - (1u << 26);
+        quint32 mask = (g4 >> 31) - 1;
+        g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+        mask = ~mask;
+        h0 = (h0 & mask) | g0;
+        h1 = (h1 & mask) | g1;
+        h2 = (h2 & mask) | g2;
+        h3 = (h3 & mask) | g3;
+        h4 = (h4 & mask) | g4;
+
+        h0 = h0 | (h1 << 26);
+        h1 = (h1 >> 6) | (h2 << 20);
+        h2 = (h2 >> 12) | (h3 << 14);
+        h3 = (h3 >> 18) | (h4 << 8);
+
+        quint64 f = quint64(h0) + m_pad[0];
+        qToLittleEndian<quint32>(quint32(f), tag);
+        f = quint64(h1) + m_pad[1] + (f >> 32);
+        qToLittleEndian<quint32>(quint32(f), tag + 4);
+        f = quint64(h2) + m_pad[2] + (f >> 32);
+        qToLittleEndian<quint32>(quint32(f), tag + 8);
+        f = quint64(h3) + m_pad[3] + (f >> 32);
+        qToLittleEndian<quint32>(quint32(f), tag + 12);
+    }
+
+private:
+    void blocks(const quint8* m, int size, quint32 hibit) {
+        const quint32 r0 = m_r[0], r1 = m_r[1], r2 = m_r[2], r3 = m_r[3], r4 = m_r[4];
+        const quint32 s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+        quint32 h0 = m_h[0], h1 = m_h[1], h2 = m_h[2], h3 = m_h[3], h4 = m_h[4];
+
+        for (; size >= 16; m += 16, size -= 16) {
+            h0 += load32(m) & LIMB;
+            h1 += (load32(m + 3) >> 2) & LIMB;
+            h2 += (load32(m + 6) >> 4) & LIMB;
+            h3 += (load32(m + 9) >> 6) & LIMB;
+            h4 += (load32(m + 12) >> 8) | hibit;
+
+            const quint64 d0 = quint64(h0) * r0 + quint64(h1) * s4 + quint64(h2) * s3 +
+                               quint64(h3) * s2 + quint64(h4) * s1;
+            quint64 d1 = quint64(h0) * r1 + quint64(h1) * r0 + quint64(h2) * s4 +
+                         quint64(h3) * s3 + quint64(h4) * s2;
+            quint64 d2 = quint64(h0) * r2 + quint64(h1) * r1 + quint64(h2) * r0 +
+                         quint64(h3) * s4 + quint64(h4) * s3;
+            quint64 d3 = quint64(h0) * r3 + quint64(h1) * r2 + quint64(h2) * r1 +
+                         quint64(h3) * r0 + quint64(h4) * s4;
+            quint64 d4 = quint64(h0) * r4 + quint64(h1) * r3 + quint64(h2) * r2 +
+                         quint64(h3) * r1 + quint64(h4) * r0;
+
+            quint32 c = quint32(d0 >> 26); h0 = quint32(d0) & LIMB;
+            d1 += c; c = quint32(d1 >> 26); h1 = quint32(d1) & LIMB;
+            d2 += c; c = quint32(d2 >> 26); h2 = quint32(d2) & LIMB;
+            d3 += c; c = quint32(d3 >> 26); h3 = quint32(d3) & LIMB;
+            d4 += c; c = quint32(d4 >> 26); h4 = quint32(d4) & LIMB;
+            h0 += c * 5; c = h0 >> 26; h0 &= LIMB;
+            h1 += c;
+        }
+        m_h[0] = h0; m_h[1] = h1; m_h[2] = h2; m_h[3] = h3; m_h[4] = h4;
+    }
+
+    quint32 m_r[5];
+    quint32 m_h[5] = {};
+    quint32 m_pad[4];
+};
+
+} // namespace
+
+void ChaCha20Poly1305::setKey(const quint8* key) {
+    for (int i = 0; i < 8; ++i) {
+        m_key[i] = load32(key + 4 * i);
+    }
+}
+
+void ChaCha20Poly1305::seal(const quint8* nonce, const quint8* aad, int aadSize,
+                            quint8* data, int size, quint8* tag) const {
+    xorStream(m_key, 1, nonce, data, size);
+    authenticate(nonce, aad, aadSize, data, size, tag);
+}
+
+bool ChaCha20Poly1305::open(const quint8* nonce, const quint8* aad, int aadSize,
+                            quint8* data, int size, const quint8* tag) const {
+    quint8 expected[TAG_SIZE];
+    authenticate(nonce, aad, aadSize, data, size, expected);
+    quint8 difference = 0;
+    for (int i = 0; i < TAG_SIZE; ++i) {
+        difference |= expected[i] ^ tag[i];
+    }
+    if (difference != 0) return false;
+
+    xorStream(m_key, 1, nonce, data, size);
+    return true;
+}
+
+void ChaCha20Poly1305::chacha20(const quint8* key, quint32 counter, const quint8* nonce,
+                                quint8* data, int size) {
+    quint32 words[8];
+    for (int i = 0; i < 8; ++i) {
+        words[i] = load32(key + 4 * i);
+    }
+    xorStream(words, counter, nonce, data, size);
+}
+
+void ChaCha20Poly1305::poly1305(const quint8* key, const quint8* data, int size, quint8* tag) {
+    Poly1305 mac(key);
+    mac.updateFinal(data, size);
+    mac.finish(tag);
+}
+
+void ChaCha20Poly1305::xorStream(const quint32* key, quint32 counter, const quint8* nonce,
+                                 quint8* data, int size) {
+    quint32 state[16];
+    std::memcpy(state, SIGMA, sizeof(SIGMA));
+    std::memcpy(state + 4, key, 8 * sizeof(quint32));
+    state[12] = counter;
+    state[13] = load32(nonce);
+    state[14] = load32(nonce + 4);
+    state[15] = load32(nonce + 8);
+
+    quint32 block[16];
+    for (; size >= 64; data += 64, size -= 64) {
+        chachaRounds(state, block);
+        ++state[12];
+        for (int i = 0; i < 16; ++i) {
+            qToLittleEndian<quint32>(load32(data + 4 * i) ^ block[i], data + 4 * i);
+        }
+    }
+    if (size > 0) {
+        chachaRounds(state, block);
+        quint8 bytes[64];
+        for (int i = 0; i < 16; ++i) {
+            qToLittleEndian<quint32>(block[i], bytes + 4 * i);
+        }
+        for (int i = 0; i < size; ++i) {
+            data[i] ^= bytes[i];
+        }
+    }
+}
+
+void ChaCha20Poly1305::authenticate(const quint8* nonce, const quint8* aad, int aadSize,
+                                    const quint8* data, int size, quint8* tag) const {
+    // The one-time Poly1305 key is the first half of block 0
+    quint8 oneTimeKey[64] = {};
+    xorStream(m_key, 0, nonce, oneTimeKey, 64);
+
+    Poly1305 mac(oneTimeKey);
+    mac.updatePadded(aad, aadSize);
+    mac.updatePadded(data, size);
+    quint8 lengths[16];
+    qToLittleEndian<quint64>(quint64(aadSize), lengths);
+    qToLittleEndian<quint64>(quint64(size), lengths + 8);
+    mac.updatePadded(lengths, 16);
+    mac.finish(tag);
+}
+
+} // namespace CounterUAS
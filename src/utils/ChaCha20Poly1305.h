@@ -0,0 +1,54 @@
+#ifndef CHACHA20POLY1305_H
+#define CHACHA20POLY1305_H
+
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief ChaCha20-Poly1305 authenticated encryption (RFC 8439)
+ *
+ * Portable C++ with no library behind it: ChaCha20 needs only 32-bit adds,
+ * rotates and xors, so it runs at a few cycles per byte on any core without
+ * the AES instructions AES-GCM depends on for its speed, and Poly1305 is
+ * done in 26-bit limbs with 64-bit products. Encryption and decryption are
+ * in place. open() checks the tag, in constant time, before it decrypts
+ * anything, and leaves the data untouched when the tag does not match.
+ *
+ * A key must never seal two messages under one nonce; callers derive the
+ * nonce from a counter they do not reuse for the key's lifetime.
+ */
+class ChaCha20Poly1305 {
+public:
+    static constexpr int KEY_SIZE = 32;
+    static constexpr int NONCE_SIZE = 12;
+    static constexpr int TAG_SIZE = 16;
+
+    ChaCha20Poly1305() = default;
+    explicit ChaCha20Poly1305(const quint8* key) { setKey(key); }
+
+    void setKey(const quint8* key);
+
+    // Encrypts size bytes of data in place and writes the tag over aad and
+    // the ciphertext
+    void seal(const quint8* nonce, const quint8* aad, int aadSize,
+              quint8* data, int size, quint8* tag) const;
+    // False, with data unchanged, when tag does not authenticate it
+    bool open(const quint8* nonce, const quint8* aad, int aadSize,
+              quint8* data, int size, const quint8* tag) const;
+
+    // The primitives, for checking against the RFC's vectors
+    static void chacha20(const quint8* key, quint32 counter, const quint8* nonce, quint8* data, int size);
+    static void poly1305(const quint8* key, const quint8* data, int size, quint8* tag);
+
+private:
+    static void xorStream(const quint32* key, quint32 counter, const quint8* nonce, quint8* data, int size);
+    void authenticate(const quint8* nonce, const quint8* aad, int aadSize,
+                      const quint8* data, int size, quint8* tag) const;
+
+    quint32 m_key[8] = {};
+};
+
+} // namespace CounterUAS
+
+#endif // CHACHA20POLY1305_H
@@ -0,0 +1,16 @@
+#include "utils/Clock.h"
+
+namespace CounterUAS {
+
+SystemClock::SystemClock()
+    : m_epochMs(QDateTime::currentMSecsSinceEpoch())
+{
+    m_elapsed.start();
+}
+
+const Clock* Clock::system() {
+    static const SystemClock clock;
+    return &clock;
+}
+
+} // namespace CounterUAS
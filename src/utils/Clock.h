@@ -0,0 +1,69 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <atomic>
+
+namespace CounterUAS {
+
+/**
+ * @brief Source of "now" for the track picture and threat assessment
+ *
+ * Track, TrackManager and ThreatAssessor read time only through a Clock,
+ * so a replay can run them on recorded time instead of the wall clock.
+ * nowMs() may be called from any thread.
+ */
+class Clock {
+public:
+    virtual ~Clock() = default;
+
+    // ms since the epoch, UTC
+    virtual qint64 nowMs() const = 0;
+    QDateTime nowUtc() const { return QDateTime::fromMSecsSinceEpoch(nowMs(), Qt::UTC); }
+
+    // The wall clock; what everything uses unless given another
+    static const Clock* system();
+};
+
+/**
+ * @brief The wall clock, advanced by a steady clock
+ *
+ * The epoch time is read once and the elapsed time of a monotonic timer
+ * is added to it, so an NTP step or a manual change of the system time
+ * never makes track ages jump or run backwards. Over a session it drifts
+ * from the wall clock only by whatever the OS corrects in the wall clock.
+ */
+class SystemClock : public Clock {
+public:
+    SystemClock();
+
+    qint64 nowMs() const override { return m_epochMs + m_elapsed.elapsed(); }
+
+private:
+    qint64 m_epochMs;
+    QElapsedTimer m_elapsed;
+};
+
+/**
+ * @brief A clock that only moves when told to
+ *
+ * A replay sets it to each recorded event's time before dispatching the
+ * event, so results depend on the recording alone, however fast it runs.
+ */
+class VirtualClock : public Clock {
+public:
+    explicit VirtualClock(qint64 startMs = 0) : m_nowMs(startMs) {}
+
+    qint64 nowMs() const override { return m_nowMs.load(std::memory_order_acquire); }
+
+    void setTime(qint64 ms) { m_nowMs.store(ms, std::memory_order_release); }
+    void advance(qint64 ms) { m_nowMs.fetch_add(ms, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<qint64> m_nowMs;
+};
+
+} // namespace CounterUAS
+
+#endif // CLOCK_H
@@ -0,0 +1,205 @@
+#include "utils/ConnectionPool.h"
+#include "utils/Logger.h"
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <cmath>
+
+namespace CounterUAS {
+
+int BackoffPolicy::delayForAttempt(int attempt) const {
+    const double base = initialDelayMs * std::pow(qMax(1.0, multiplier), qMax(0, attempt - 1));
+    const double capped = qMin(base, static_cast<double>(maxDelayMs));
+    const double spread = qBound(0.0, jitter, 1.0);
+    const double factor = 1.0 - spread + 2.0 * spread * QRandomGenerator::global()->generateDouble();
+    return qMax(1, static_cast<int>(capped * factor));
+}
+
+// ManagedConnection
+
+ManagedConnection::ManagedConnection(QAbstractSocket* socket, const BackoffPolicy& policy)
+    : QObject(socket)
+    , m_socket(socket)
+    , m_policy(policy)
+    , m_retryTimer(new QTimer(this))
+    , m_timeoutTimer(new QTimer(this))
+{
+    m_retryTimer->setSingleShot(true);
+    m_timeoutTimer->setSingleShot(true);
+    QObject::connect(m_retryTimer, &QTimer::timeout, this, [this]() {
+        if (m_wanted && m_socket->state() == QAbstractSocket::UnconnectedState) {
+            connectNow();
+        }
+    });
+    QObject::connect(m_timeoutTimer, &QTimer::timeout, this, &ManagedConnection::onConnectTimeout);
+
+    QObject::connect(m_socket, &QAbstractSocket::connected, this, &ManagedConnection::onConnected);
+    QObject::connect(m_socket, &QAbstractSocket::disconnected, this, &ManagedConnection::onDisconnected);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    QObject::connect(m_socket, &QAbstractSocket::errorOccurred, this, &ManagedConnection::onError);
+#else
+    QObject::connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error),
+                     this, &ManagedConnection::onError);
+#endif
+
+    ConnectionPool::instance().add(this);
+}
+
+ManagedConnection::~ManagedConnection() {
+    ConnectionPool::instance().remove(this);
+}
+
+void ManagedConnection::setTarget(const QString& host, quint16 port) {
+    m_host = host;
+    m_port = port;
+}
+
+bool ManagedConnection::isConnected() const {
+    return m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+void ManagedConnection::open() {
+    m_wanted = true;
+    if (m_socket->state() != QAbstractSocket::UnconnectedState) return;  // Connected or in flight
+    if (m_retryTimer->isActive()) return;  // Backing off; the timer will try
+    connectNow();
+}
+
+void ManagedConnection::close() {
+    m_wanted = false;
+    m_attempt = 0;
+    m_retryTimer->stop();
+    m_timeoutTimer->stop();
+
+    if (m_socket->state() == QAbstractSocket::ConnectedState) {
+        m_socket->disconnectFromHost();
+    } else if (m_socket->state() != QAbstractSocket::UnconnectedState) {
+        m_socket->abort();
+    }
+}
+
+void ManagedConnection::connectNow() {
+    ++m_attempt;
+    emit attemptStarted(m_attempt);
+    m_timeoutTimer->start(m_policy.connectTimeoutMs);
+    m_socket->connectToHost(m_host, m_port);
+}
+
+void ManagedConnection::onConnected() {
+    m_timeoutTimer->stop();
+    m_retryTimer->stop();
+    m_attempt = 0;
+    ConnectionPool::instance().settle(this, true);
+}
+
+void ManagedConnection::onDisconnected() {
+    m_timeoutTimer->stop();
+    scheduleRetry("Disconnected");
+}
+
+void ManagedConnection::onError(QAbstractSocket::SocketError error) {
+    Q_UNUSED(error)
+    if (m_socket->state() == QAbstractSocket::ConnectedState) return;  // disconnected() follows
+    m_timeoutTimer->stop();
+    scheduleRetry(m_socket->errorString());
+}
+
+void ManagedConnection::onConnectTimeout() {
+    m_socket->abort();
+    scheduleRetry(QString("Connect timeout after %1 ms").arg(m_policy.connectTimeoutMs));
+}
+
+void ManagedConnection::scheduleRetry(const QString& reason) {
+    if (!m_wanted || m_retryTimer->isActive()) return;  // Closed, or already scheduled
+    ConnectionPool::instance().settle(this, false);
+
+    if (!m_policy.autoRetry) {
+        m_wanted = false;
+        emit gaveUp(reason);
+        return;
+    }
+
+    const int delayMs = m_policy.delayForAttempt(qMax(1, m_attempt));
+    m_retryTimer->start(delayMs);
+    Logger::instance().debug("ConnectionPool",
+        QString("%1:%2 %3; retry %4 in %5 ms")
+            .arg(m_host).arg(m_port).arg(reason).arg(m_attempt + 1).arg(delayMs));
+    emit retryScheduled(m_attempt, delayMs);
+}
+
+// ConnectionPool
+
+ConnectionPool& ConnectionPool::instance() {
+    static ConnectionPool pool;
+    return pool;
+}
+
+void ConnectionPool::add(ManagedConnection* connection) {
+    QMutexLocker locker(&m_mutex);
+    m_connections.append(connection);
+}
+
+void ConnectionPool::remove(ManagedConnection* connection) {
+    QMutexLocker locker(&m_mutex);
+    m_connections.removeAll(connection);
+    m_unsettled.removeAll(connection);
+}
+
+void ConnectionPool::openAll() {
+    QMutexLocker locker(&m_mutex);
+    m_unsettled.clear();
+    m_startupConnected = 0;
+    m_startupFailed = 0;
+
+    // Queued even on this thread: every open() lands in the same pass of
+    // its thread's event loop, and none runs under the lock
+    for (ManagedConnection* connection : m_connections) {
+        if (connection->isConnected()) continue;
+        m_unsettled.append(connection);
+        QMetaObject::invokeMethod(connection, "open", Qt::QueuedConnection);
+    }
+
+    Logger::instance().info("ConnectionPool",
+        QString("Opening %1 connection(s) in parallel").arg(m_unsettled.size()));
+}
+
+void ConnectionPool::closeAll() {
+    QMutexLocker locker(&m_mutex);
+    m_unsettled.clear();
+    for (ManagedConnection* connection : m_connections) {
+        QMetaObject::invokeMethod(connection, "close", Qt::QueuedConnection);
+    }
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.managed = m_connections.size();
+    for (ManagedConnection* connection : m_connections) {
+        if (connection->isConnected()) {
+            ++stats.connected;
+        } else if (connection->isWanted()) {
+            ++stats.pending;
+        }
+    }
+    return stats;
+}
+
+void ConnectionPool::settle(ManagedConnection* connection, bool connected) {
+    int connectedCount = 0;
+    int failedCount = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_unsettled.removeOne(connection)) return;
+        ++(connected ? m_startupConnected : m_startupFailed);
+        if (!m_unsettled.isEmpty()) return;
+        connectedCount = m_startupConnected;
+        failedCount = m_startupFailed;
+    }
+
+    Logger::instance().info("ConnectionPool",
+        QString("Startup settled: %1 connected, %2 unreachable").arg(connectedCount).arg(failedCount));
+    emit startupComplete(connectedCount, failedCount);
+}
+
+} // namespace CounterUAS
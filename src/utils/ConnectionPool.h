@@ -0,0 +1,133 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QObject>
+#include <QAbstractSocket>
+#include <QList>
+#include <QMutex>
+#include <QTimer>
+
+namespace CounterUAS {
+
+/**
+ * @brief Retry schedule for a managed connection
+ *
+ * Attempt n waits min(maxDelayMs, initialDelayMs * multiplier^(n-1)),
+ * scaled by a uniform factor in [1 - jitter, 1 + jitter] so that links
+ * lost together do not retry in lockstep.
+ */
+struct BackoffPolicy {
+    int initialDelayMs = 500;
+    int maxDelayMs = 30000;
+    double multiplier = 2.0;
+    double jitter = 0.2;
+    int connectTimeoutMs = 3000;   // An attempt still pending after this is aborted
+    bool autoRetry = true;         // false: give up after the first failure
+
+    int delayForAttempt(int attempt) const;
+};
+
+/**
+ * @brief Drives one TCP socket's connection without ever blocking
+ *
+ * open() issues connectToHost and returns at once. A connect timeout
+ * aborts a hung attempt, and failures and drops are retried on the backoff
+ * schedule until close(). The object is a child of its socket, so it runs
+ * on whatever thread the socket lives on and follows it through
+ * moveToThread. The owner keeps its own slots on the socket's signals.
+ */
+class ManagedConnection : public QObject {
+    Q_OBJECT
+
+public:
+    ManagedConnection(QAbstractSocket* socket, const BackoffPolicy& policy = BackoffPolicy());
+    ~ManagedConnection() override;
+
+    void setTarget(const QString& host, quint16 port);
+    void setPolicy(const BackoffPolicy& policy) { m_policy = policy; }
+
+    QString host() const { return m_host; }
+    quint16 port() const { return m_port; }
+    QAbstractSocket* socket() const { return m_socket; }
+
+    bool isWanted() const { return m_wanted; }
+    bool isConnected() const;
+    int attempts() const { return m_attempt; }
+
+public slots:
+    // Start or resume connecting; a no-op while connected or mid-attempt
+    void open();
+    // Stop retrying and drop the link without waiting for it to close
+    void close();
+
+signals:
+    void attemptStarted(int attempt);
+    void retryScheduled(int attempt, int delayMs);
+    void gaveUp(const QString& reason);
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onError(QAbstractSocket::SocketError error);
+    void onConnectTimeout();
+
+private:
+    void connectNow();
+    void scheduleRetry(const QString& reason);
+
+    QAbstractSocket* m_socket;
+    BackoffPolicy m_policy;
+    QString m_host;
+    quint16 m_port = 0;
+    bool m_wanted = false;
+    int m_attempt = 0;
+    QTimer* m_retryTimer;
+    QTimer* m_timeoutTimer;
+};
+
+/**
+ * @brief Registry of the process's managed connections
+ *
+ * Every ManagedConnection registers itself here. openAll() starts each one
+ * on its own thread in the same event-loop pass, so a startup with several
+ * sensors offline costs one connect timeout in total rather than one per
+ * sensor. startupComplete() fires once every connection opened that way
+ * has either connected or failed its first attempt.
+ */
+class ConnectionPool : public QObject {
+    Q_OBJECT
+
+public:
+    static ConnectionPool& instance();
+
+    void openAll();
+    void closeAll();
+
+    struct Stats {
+        int managed = 0;
+        int connected = 0;
+        int pending = 0;   // Wanted but not connected: connecting or backing off
+    };
+    Stats stats() const;
+
+signals:
+    void startupComplete(int connected, int failed);
+
+private:
+    friend class ManagedConnection;
+    ConnectionPool() = default;
+
+    void add(ManagedConnection* connection);
+    void remove(ManagedConnection* connection);
+    void settle(ManagedConnection* connection, bool connected);
+
+    mutable QMutex m_mutex;
+    QList<ManagedConnection*> m_connections;   // Each removes itself on destruction
+    QList<ManagedConnection*> m_unsettled;   // Opened by openAll, first attempt outstanding
+    int m_startupConnected = 0;
+    int m_startupFailed = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // CONNECTIONPOOL_H
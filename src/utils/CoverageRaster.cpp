@@ -0,0 +1,190 @@
+#include "utils/CoverageRaster.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 CACHE_MAGIC = 0x43555643;     // "CUVC"
+constexpr quint32 CACHE_VERSION = 1;
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+constexpr double RAD_TO_DEG = 180.0 / M_PI;
+
+} // namespace
+
+bool CoverageSite::operator==(const CoverageSite& o) const {
+    return siteId == o.siteId &&
+           position.latitude == o.position.latitude &&
+           position.longitude == o.position.longitude &&
+           position.altitude == o.position.altitude &&
+           minRangeM == o.minRangeM &&
+           maxRangeM == o.maxRangeM &&
+           fieldOfViewDeg == o.fieldOfViewDeg &&
+           headingDeg == o.headingDeg;
+}
+
+void CoverageRaster::setSite(const CoverageSite& site) {
+    m_site = site;
+    GeoPosition ground = site.position;
+    ground.altitude = 0.0;
+    m_plane.setOrigin(ground);
+}
+
+CoverageRasterPtr CoverageRaster::build(const CoverageSite& site, const TerrainModel& terrain,
+                                        const CoverageRasterConfig& config) {
+    std::shared_ptr<CoverageRaster> raster(new CoverageRaster);
+    raster->setSite(site);
+    raster->m_key = keyFor(site, terrain, config);
+
+    const double maxRange = qMax(1.0, site.maxRangeM);
+    raster->m_azimuthBins = qMax(1, int(std::ceil(360.0 / qMax(0.01, config.azimuthBinDeg))));
+    raster->m_azimuthBinDeg = 360.0 / raster->m_azimuthBins;
+    raster->m_rangeBinM = qMax(qMax(1.0, config.rangeBinM), maxRange / qMax(1, config.maxRangeBins));
+    raster->m_rangeBins = qMax(1, int(std::ceil(maxRange / raster->m_rangeBinM)));
+    raster->m_mask.resize(raster->m_azimuthBins * raster->m_rangeBins);
+
+    const double eye = terrain.elevationM(site.position.latitude, site.position.longitude) +
+                       site.position.altitude;
+    const double earthDiameter = 2.0 * config.refractionK * LocalTangentPlane::WGS84_A;
+
+    // Curvature drop at each range bin, the same for every azimuth
+    QVector<double> drop(raster->m_rangeBins);
+    for (int r = 0; r < raster->m_rangeBins; ++r) {
+        const double range = (r + 0.5) * raster->m_rangeBinM;
+        drop[r] = range * range / earthDiameter;
+    }
+
+    // One azimuth's ground samples, fetched from the terrain in one batch
+    QVector<double> latitudes(raster->m_rangeBins);
+    QVector<double> longitudes(raster->m_rangeBins);
+    QVector<double> heights(raster->m_rangeBins);
+
+    for (int a = 0; a < raster->m_azimuthBins; ++a) {
+        const double bearing = (a + 0.5) * raster->m_azimuthBinDeg * DEG_TO_RAD;
+        const double east = std::sin(bearing);
+        const double north = std::cos(bearing);
+        float* mask = raster->m_mask.data() + a * raster->m_rangeBins;
+
+        for (int r = 0; r < raster->m_rangeBins; ++r) {
+            const double range = (r + 0.5) * raster->m_rangeBinM;
+            EnuVector sample;
+            sample.east = east * range;
+            sample.north = north * range;
+            const GeoPosition ground = raster->m_plane.toGeoLinear(sample);
+            latitudes[r] = ground.latitude;
+            longitudes[r] = ground.longitude;
+        }
+        terrain.elevationsM(latitudes.constData(), longitudes.constData(), heights.data(), raster->m_rangeBins);
+
+        // Steepest tangent from the eye to the ground so far
+        double horizon = -std::numeric_limits<double>::infinity();
+        for (int r = 0; r < raster->m_rangeBins; ++r) {
+            const double range = (r + 0.5) * raster->m_rangeBinM;
+            const double height = heights[r];
+
+            // A target here must clear the ray grazing the highest ground before it
+            const double ray = eye + range * horizon + drop[r];
+            mask[r] = std::isfinite(ray) ? float(qMax(0.0, ray - height)) : 0.0f;
+            horizon = qMax(horizon, (height - drop[r] - eye) / range);
+        }
+    }
+    return raster;
+}
+
+bool CoverageRaster::isFor(const GeoPosition& position) const {
+    return position.latitude == m_site.position.latitude &&
+           position.longitude == m_site.position.longitude &&
+           position.altitude == m_site.position.altitude;
+}
+
+double CoverageRaster::maskHeightM(const GeoPosition& target) const {
+    const EnuVector enu = m_plane.toEnuLinear(target);
+    const double range = std::hypot(enu.east, enu.north);
+    if (range > m_site.maxRangeM || range < m_site.minRangeM || m_mask.isEmpty()) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double azimuth = std::atan2(enu.east, enu.north) * RAD_TO_DEG;
+    if (azimuth < 0.0) azimuth += 360.0;
+    if (m_site.fieldOfViewDeg < 360.0 &&
+        std::abs(std::remainder(azimuth - m_site.headingDeg, 360.0)) > m_site.fieldOfViewDeg / 2.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    const int a = qMin(int(azimuth / m_azimuthBinDeg), m_azimuthBins - 1);
+    const int r = qMin(int(range / m_rangeBinM), m_rangeBins - 1);
+    return cell(a, r);
+}
+
+bool CoverageRaster::canSee(const GeoPosition& target) const {
+    return target.altitude >= maskHeightM(target);
+}
+
+quint64 CoverageRaster::keyFor(const CoverageSite& site, const TerrainModel& terrain,
+                               const CoverageRasterConfig& config) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const double fields[] = {
+        site.position.latitude, site.position.longitude, site.position.altitude,
+        site.minRangeM, site.maxRangeM, site.fieldOfViewDeg, site.headingDeg,
+        config.azimuthBinDeg, config.rangeBinM, double(config.maxRangeBins), config.refractionK,
+        double(CACHE_VERSION)
+    };
+    const quint64 terrainKey = terrain.fingerprint();
+    hash.addData(reinterpret_cast<const char*>(fields), sizeof(fields));
+    hash.addData(reinterpret_cast<const char*>(&terrainKey), sizeof(terrainKey));
+    quint64 key = 0;
+    std::memcpy(&key, hash.result().constData(), sizeof(key));
+    return key;
+}
+
+bool CoverageRaster::save(const QString& path) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out << CACHE_MAGIC << CACHE_VERSION << m_key
+        << qint32(m_azimuthBins) << qint32(m_rangeBins) << m_rangeBinM;
+    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    out << m_mask;
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+CoverageRasterPtr CoverageRaster::load(const QString& path, const CoverageSite& site, quint64 key) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return nullptr;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 storedKey = 0;
+    qint32 azimuthBins = 0;
+    qint32 rangeBins = 0;
+    double rangeBinM = 0.0;
+    in >> magic >> version >> storedKey >> azimuthBins >> rangeBins >> rangeBinM;
+    if (in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION ||
+        storedKey != key || azimuthBins <= 0 || rangeBins <= 0 || !(rangeBinM > 0.0)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<CoverageRaster> raster(new CoverageRaster);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    in >> raster->m_mask;
+    if (in.status() != QDataStream::Ok || raster->m_mask.size() != azimuthBins * rangeBins) {
+        return nullptr;
+    }
+    raster->setSite(site);
+    raster->m_key = key;
+    raster->m_azimuthBins = azimuthBins;
+    raster->m_rangeBins = rangeBins;
+    raster->m_azimuthBinDeg = 360.0 / azimuthBins;
+    raster->m_rangeBinM = rangeBinM;
+    return raster;
+}
+
+} // namespace CounterUAS
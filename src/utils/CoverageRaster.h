@@ -0,0 +1,100 @@
+#ifndef COVERAGERASTER_H
+#define COVERAGERASTER_H
+
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "core/Track.h"
+#include "utils/LocalTangentPlane.h"
+#include "utils/TerrainModel.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief A sensor or effector as a line-of-sight origin
+ */
+struct CoverageSite {
+    QString siteId;
+    GeoPosition position;           // Altitude is the aperture's height above ground
+    double minRangeM = 0.0;
+    double maxRangeM = 5000.0;
+    double fieldOfViewDeg = 360.0;  // Centred on headingDeg; 360 all round or steerable
+    double headingDeg = 0.0;
+
+    bool operator==(const CoverageSite& o) const;
+    bool operator!=(const CoverageSite& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Resolution and propagation of a coverage raster
+ */
+struct CoverageRasterConfig {
+    double azimuthBinDeg = 0.5;
+    double rangeBinM = 25.0;
+    int maxRangeBins = 2000;            // Coarser range bins past maxRangeBins * rangeBinM
+    double refractionK = 4.0 / 3.0;     // Effective earth radius factor, standard atmosphere
+};
+
+class CoverageRaster;
+using CoverageRasterPtr = std::shared_ptr<const CoverageRaster>;
+
+/**
+ * @brief Viewshed of one site in range and azimuth
+ *
+ * Each cell holds the lowest height above ground at which a target in it is
+ * visible from the site. build() walks every azimuth outward from the site
+ * over the terrain, keeping the steepest elevation angle to the ground so
+ * far, with the earth's curvature under refraction taken off each sample;
+ * a cell's mask is the height of that ray over the cell's ground. Ranges
+ * are ground ranges in the site's tangent plane.
+ *
+ * After that, canSee() is a range, a bearing and one array read, whatever
+ * the terrain. Rasters are immutable and shared; any thread may read one.
+ */
+class CoverageRaster {
+public:
+    static CoverageRasterPtr build(const CoverageSite& site, const TerrainModel& terrain,
+                                   const CoverageRasterConfig& config = CoverageRasterConfig());
+
+    const CoverageSite& site() const { return m_site; }
+    // True while the site has not moved since the raster was built
+    bool isFor(const GeoPosition& position) const;
+
+    bool canSee(const GeoPosition& target) const;
+    // Lowest visible height above ground at the target's cell; infinity
+    // outside the range limits or the field of view
+    double maskHeightM(const GeoPosition& target) const;
+
+    int azimuthBins() const { return m_azimuthBins; }
+    int rangeBins() const { return m_rangeBins; }
+    double rangeBinM() const { return m_rangeBinM; }
+    float cell(int azimuthBin, int rangeBin) const { return m_mask[azimuthBin * m_rangeBins + rangeBin]; }
+
+    // Identifies what the raster was built from: site geometry, resolution
+    // and terrain. A cached raster is only good for the same key
+    static quint64 keyFor(const CoverageSite& site, const TerrainModel& terrain,
+                          const CoverageRasterConfig& config);
+    quint64 key() const { return m_key; }
+
+    bool save(const QString& path) const;
+    // The raster keyFor() gave key for site; null if the file is missing,
+    // unreadable or for another key
+    static CoverageRasterPtr load(const QString& path, const CoverageSite& site, quint64 key);
+
+private:
+    CoverageRaster() = default;
+    void setSite(const CoverageSite& site);
+
+    CoverageSite m_site;
+    LocalTangentPlane m_plane;          // At the site
+    double m_azimuthBinDeg = 1.0;
+    double m_rangeBinM = 1.0;
+    int m_azimuthBins = 0;
+    int m_rangeBins = 0;
+    QVector<float> m_mask;              // Azimuth-major, rangeBins per azimuth
+    quint64 m_key = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // COVERAGERASTER_H
@@ -0,0 +1,365 @@
+#include "utils/DatagramReceiver.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#if defined(Q_OS_LINUX)
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#else
+#include <QUdpSocket>
+#endif
+
+namespace CounterUAS {
+
+struct DatagramReceiver::Pool {
+    QMutex mutex;
+    std::vector<std::unique_ptr<DatagramBatch>> idle;
+    int outstanding = 0;        // Acquired and not yet back
+    int capacity = 8;
+    int batchSize = 64;
+    int slotBytes = 2048;
+    bool starved = false;       // Reading paused until a batch comes back
+    DatagramReceiver* receiver = nullptr;   // Null once stopped
+};
+
+struct DatagramReceiver::Socket {
+#if defined(Q_OS_LINUX)
+    int fd = -1;
+    QSocketNotifier* notifier = nullptr;
+    std::vector<mmsghdr> headers;
+    std::vector<iovec> iovs;
+    std::vector<char> control;   // CONTROL_BYTES per message, for the drop counter
+    static constexpr size_t CONTROL_BYTES = CMSG_SPACE(sizeof(quint32));
+
+    ~Socket() {
+        delete notifier;
+        if (fd >= 0) ::close(fd);
+    }
+#else
+    QUdpSocket* socket = nullptr;
+    ~Socket() { delete socket; }
+#endif
+};
+
+DatagramReceiver::DatagramReceiver(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<DatagramBatchPtr>("CounterUAS::DatagramBatchPtr");
+}
+
+DatagramReceiver::~DatagramReceiver() {
+    stop();
+}
+
+bool DatagramReceiver::start(const DatagramReceiverConfig& config) {
+    stop();
+    m_config = config;
+    m_config.batchSize = qBound(1, m_config.batchSize, 1024);
+    m_config.maxDatagramBytes = qBound(1, m_config.maxDatagramBytes, 65536);
+    m_config.poolBatches = qMax(1, m_config.poolBatches);
+
+    m_pool = std::make_shared<Pool>();
+    m_pool->capacity = m_config.poolBatches;
+    m_pool->batchSize = m_config.batchSize;
+    m_pool->slotBytes = m_config.maxDatagramBytes;
+    m_pool->receiver = this;
+    m_kernelDrops.store(0, std::memory_order_relaxed);
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("DatagramReceiver");
+    m_context = new QObject;
+    m_context->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    ThreadPlacement::instance().assign(m_thread, ThreadRole::SensorIO);
+    m_thread->start();
+
+    bool bound = false;
+    QMetaObject::invokeMethod(m_context, [this, &bound]() {
+        std::unique_ptr<Socket> socket(new Socket);
+#if defined(Q_OS_LINUX)
+        // Our own descriptor: QUdpSocket would stop notifying once read behind its back
+        const bool v6 = m_config.address.protocol() == QAbstractSocket::IPv6Protocol ||
+                        m_config.address == QHostAddress::Any;
+        socket->fd = ::socket(v6 ? AF_INET6 : AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (socket->fd < 0) {
+            m_error = QString::fromLocal8Bit(std::strerror(errno));
+            return;
+        }
+        const int one = 1;
+        const int zero = 0;
+        if (m_config.shareAddress) {
+            ::setsockopt(socket->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+        ::setsockopt(socket->fd, SOL_SOCKET, SO_RCVBUF, &m_config.receiveBufferBytes,
+                     sizeof(m_config.receiveBufferBytes));
+        ::setsockopt(socket->fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+
+        sockaddr_storage addr = {};
+        socklen_t addrLen = 0;
+        if (v6) {
+            if (m_config.address == QHostAddress::Any) {
+                ::setsockopt(socket->fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+            }
+            sockaddr_in6* in6 = reinterpret_cast<sockaddr_in6*>(&addr);
+            in6->sin6_family = AF_INET6;
+            in6->sin6_port = htons(m_config.port);
+            const Q_IPV6ADDR ip = m_config.address.toIPv6Address();
+            std::memcpy(&in6->sin6_addr, ip.c, sizeof(ip.c));
+            addrLen = sizeof(sockaddr_in6);
+        } else {
+            sockaddr_in* in4 = reinterpret_cast<sockaddr_in*>(&addr);
+            in4->sin_family = AF_INET;
+            in4->sin_port = htons(m_config.port);
+            in4->sin_addr.s_addr = htonl(m_config.address.toIPv4Address());
+            addrLen = sizeof(sockaddr_in);
+        }
+        if (::bind(socket->fd, reinterpret_cast<sockaddr*>(&addr), addrLen) != 0) {
+            m_error = QString::fromLocal8Bit(std::strerror(errno));
+            return;
+        }
+        addrLen = sizeof(addr);
+        if (::getsockname(socket->fd, reinterpret_cast<sockaddr*>(&addr), &addrLen) == 0) {
+            m_port = ntohs(v6 ? reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port
+                              : reinterpret_cast<sockaddr_in*>(&addr)->sin_port);
+        }
+        if (!m_config.multicastGroup.isNull()) {
+            int joined = -1;
+            if (m_config.multicastGroup.protocol() == QAbstractSocket::IPv6Protocol) {
+                ipv6_mreq request = {};
+                const Q_IPV6ADDR group = m_config.multicastGroup.toIPv6Address();
+                std::memcpy(&request.ipv6mr_multiaddr, group.c, sizeof(group.c));
+                joined = ::setsockopt(socket->fd, IPPROTO_IPV6, IPV6_JOIN_GROUP, &request, sizeof(request));
+            } else {
+                ip_mreq request = {};
+                request.imr_multiaddr.s_addr = htonl(m_config.multicastGroup.toIPv4Address());
+                request.imr_interface.s_addr = m_config.multicastInterface.isNull()
+                    ? htonl(INADDR_ANY) : htonl(m_config.multicastInterface.toIPv4Address());
+                joined = ::setsockopt(socket->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request));
+            }
+            if (joined != 0) {
+                m_error = QString::fromLocal8Bit(std::strerror(errno));
+                return;
+            }
+        }
+
+        socket->headers.resize(m_config.batchSize);
+        socket->iovs.resize(m_config.batchSize);
+        socket->control.resize(Socket::CONTROL_BYTES * m_config.batchSize);
+        socket->notifier = new QSocketNotifier(socket->fd, QSocketNotifier::Read);
+        connect(socket->notifier, &QSocketNotifier::activated, m_context, [this]() { readPending(); });
+#else
+        socket->socket = new QUdpSocket;
+        const QAbstractSocket::BindMode mode = m_config.shareAddress
+            ? QAbstractSocket::ShareAddress | QAbstractSocket::ReuseAddressHint
+            : QAbstractSocket::DefaultForPlatform;
+        if (!socket->socket->bind(m_config.address, m_config.port, mode)) {
+            m_error = socket->socket->errorString();
+            return;
+        }
+        socket->socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption,
+                                        m_config.receiveBufferBytes);
+        m_port = socket->socket->localPort();
+        if (!m_config.multicastGroup.isNull() && !socket->socket->joinMulticastGroup(m_config.multicastGroup)) {
+            m_error = socket->socket->errorString();
+            return;
+        }
+        connect(socket->socket, &QUdpSocket::readyRead, m_context, [this]() { readPending(); });
+#endif
+        m_socket = std::move(socket);
+        bound = true;
+    }, Qt::BlockingQueuedConnection);
+
+    if (!bound) {
+        Logger::instance().error("DatagramReceiver",
+                                 QString("Cannot bind %1:%2: %3")
+                                     .arg(m_config.address.toString()).arg(m_config.port).arg(m_error));
+        stop();
+        return false;
+    }
+    m_error.clear();
+    return true;
+}
+
+void DatagramReceiver::stop() {
+    if (!m_thread) return;
+
+    {
+        // Batches still downstream no longer wake the thread
+        QMutexLocker locker(&m_pool->mutex);
+        m_pool->receiver = nullptr;
+    }
+    // The socket closes on its own thread, before the thread ends
+    QMetaObject::invokeMethod(m_context, [this]() { m_socket.reset(); }, Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_context = nullptr;
+    m_pool.reset();
+    m_port = 0;
+}
+
+DatagramReceiver::Statistics DatagramReceiver::statistics() const {
+    Statistics stats;
+    stats.datagrams = m_datagrams.load(std::memory_order_relaxed);
+    stats.bytes = m_bytes.load(std::memory_order_relaxed);
+    stats.batches = m_batches.load(std::memory_order_relaxed);
+    stats.truncated = m_truncated.load(std::memory_order_relaxed);
+    stats.kernelDrops = m_kernelDrops.load(std::memory_order_relaxed);
+    stats.pauses = m_pauses.load(std::memory_order_relaxed);
+    return stats;
+}
+
+DatagramBatch* DatagramReceiver::acquire() {
+    std::unique_ptr<DatagramBatch> batch;
+    {
+        QMutexLocker locker(&m_pool->mutex);
+        if (!m_pool->idle.empty()) {
+            batch = std::move(m_pool->idle.back());
+            m_pool->idle.pop_back();
+        } else if (m_pool->outstanding >= m_pool->capacity) {
+            m_pool->starved = true;
+            return nullptr;
+        }
+        ++m_pool->outstanding;
+    }
+
+    if (!batch) {
+        batch.reset(new DatagramBatch);
+        batch->m_slab.resize(static_cast<size_t>(m_pool->slotBytes) * m_pool->batchSize);
+        batch->m_offsets.reserve(m_pool->batchSize);
+        batch->m_sizes.reserve(m_pool->batchSize);
+    }
+    batch->m_offsets.clear();
+    batch->m_sizes.clear();
+    batch->m_count = 0;
+    batch->m_bytes = 0;
+    batch->m_kernelDrops = m_kernelDrops.load(std::memory_order_relaxed);
+    return batch.release();
+}
+
+void DatagramReceiver::release(const std::weak_ptr<Pool>& pool, const DatagramBatch* batch) {
+    DatagramBatch* owned = const_cast<DatagramBatch*>(batch);
+    const std::shared_ptr<Pool> p = pool.lock();
+    if (!p) {
+        delete owned;
+        return;
+    }
+
+    QMutexLocker locker(&p->mutex);
+    --p->outstanding;
+    p->idle.emplace_back(owned);
+    if (p->starved && p->receiver) {
+        p->starved = false;
+        DatagramReceiver* receiver = p->receiver;
+        QMetaObject::invokeMethod(receiver->m_context, [receiver]() { receiver->resume(); },
+                                  Qt::QueuedConnection);
+    }
+}
+
+void DatagramReceiver::readPending() {
+    if (!m_socket) return;
+
+    // At most a pool's worth per wakeup, so stop() and resumes get a turn
+    for (int round = 0; round < m_config.poolBatches; ++round) {
+        DatagramBatch* batch = acquire();
+        if (!batch) {
+            m_pauses.fetch_add(1, std::memory_order_relaxed);
+#if defined(Q_OS_LINUX)
+            m_socket->notifier->setEnabled(false);
+#endif
+            return;
+        }
+
+        const int slot = m_config.maxDatagramBytes;
+        int received = 0;
+        bool more = false;
+#if defined(Q_OS_LINUX)
+        for (int i = 0; i < m_config.batchSize; ++i) {
+            iovec& iov = m_socket->iovs[i];
+            iov.iov_base = batch->m_slab.data() + static_cast<size_t>(i) * slot;
+            iov.iov_len = static_cast<size_t>(slot);
+            msghdr& hdr = m_socket->headers[i].msg_hdr;
+            std::memset(&hdr, 0, sizeof(hdr));
+            hdr.msg_iov = &iov;
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = m_socket->control.data() + Socket::CONTROL_BYTES * i;
+            hdr.msg_controllen = Socket::CONTROL_BYTES;
+        }
+        const int n = ::recvmmsg(m_socket->fd, m_socket->headers.data(),
+                                 static_cast<unsigned>(m_config.batchSize), MSG_DONTWAIT, nullptr);
+        for (int i = 0; i < n; ++i) {
+            msghdr& hdr = m_socket->headers[i].msg_hdr;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(&hdr, c)) {
+                if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+                    quint32 drops = 0;
+                    std::memcpy(&drops, CMSG_DATA(c), sizeof(drops));
+                    batch->m_kernelDrops = qMax<quint64>(batch->m_kernelDrops, drops);
+                }
+            }
+            if (hdr.msg_flags & MSG_TRUNC) {
+                m_truncated.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            batch->m_offsets.push_back(static_cast<size_t>(i) * slot);
+            batch->m_sizes.push_back(static_cast<int>(m_socket->headers[i].msg_len));
+            batch->m_bytes += m_socket->headers[i].msg_len;
+            ++received;
+        }
+        more = n == m_config.batchSize;
+        m_kernelDrops.store(batch->m_kernelDrops, std::memory_order_relaxed);
+#else
+        QUdpSocket* socket = m_socket->socket;
+        int slots = 0;
+        while (slots < m_config.batchSize && socket->hasPendingDatagrams()) {
+            const qint64 pending = socket->pendingDatagramSize();
+            char* dst = batch->m_slab.data() + static_cast<size_t>(slots) * slot;
+            if (pending > slot) {
+                socket->readDatagram(dst, 0);
+                m_truncated.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            const qint64 bytesRead = socket->readDatagram(dst, slot);
+            if (bytesRead < 0) break;
+            batch->m_offsets.push_back(static_cast<size_t>(slots) * slot);
+            batch->m_sizes.push_back(static_cast<int>(bytesRead));
+            batch->m_bytes += bytesRead;
+            ++slots;
+        }
+        received = slots;
+        more = socket->hasPendingDatagrams();
+#endif
+
+        // The last reference downstream returns the batch to the pool
+        batch->m_count = received;
+        const DatagramBatchPtr shared(batch, [pool = std::weak_ptr<Pool>(m_pool)](const DatagramBatch* b) {
+            release(pool, b);
+        });
+        if (received > 0) {
+            batch->m_receivedNs = TimeUtils::monotonicNs();
+            m_datagrams.fetch_add(received, std::memory_order_relaxed);
+            m_bytes.fetch_add(batch->m_bytes, std::memory_order_relaxed);
+            m_batches.fetch_add(1, std::memory_order_relaxed);
+            emit batchReady(shared);
+        }
+        if (!more) return;
+    }
+}
+
+void DatagramReceiver::resume() {
+    if (!m_socket) return;
+#if defined(Q_OS_LINUX)
+    m_socket->notifier->setEnabled(true);
+#endif
+    readPending();
+}
+
+} // namespace CounterUAS
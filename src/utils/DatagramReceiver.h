@@ -0,0 +1,132 @@
+#ifndef DATAGRAMRECEIVER_H
+#define DATAGRAMRECEIVER_H
+
+#include <QObject>
+#include <QHostAddress>
+#include <QMetaType>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief Socket and batching of a DatagramReceiver
+ */
+struct DatagramReceiverConfig {
+    QHostAddress address = QHostAddress::AnyIPv4;
+    quint16 port = 0;
+    bool shareAddress = false;
+    QHostAddress multicastGroup;    // Joined once bound, when set
+    QHostAddress multicastInterface; // Local IPv4 address to join on, Linux only; null for the default
+    int receiveBufferBytes = 4 * 1024 * 1024;   // Kernel socket buffer for bursts
+    int batchSize = 64;             // Datagrams per receive call, and at most per batch
+    int maxDatagramBytes = 2048;    // Longer datagrams are dropped as truncated
+    int poolBatches = 8;            // Batches downstream at once before reading pauses
+};
+
+/**
+ * @brief The datagrams of one receive, in one pooled buffer
+ *
+ * Read-only once handed out. The buffer goes back to its receiver's pool
+ * when the last reference is dropped, on whatever thread.
+ */
+class DatagramBatch {
+public:
+    int count() const { return m_count; }
+    const char* data(int index) const { return m_slab.data() + m_offsets[index]; }
+    int size(int index) const { return m_sizes[index]; }
+    qint64 bytes() const { return m_bytes; }
+    qint64 receivedNs() const { return m_receivedNs; }    // TimeUtils::monotonicNs() after the read
+    // The kernel's count of datagrams dropped on the socket for want of
+    // buffer since it was opened, as stamped on the latest datagram (so a
+    // burst of drops shows with the next datagram that gets through); 0
+    // where the platform does not report it
+    quint64 kernelDrops() const { return m_kernelDrops; }
+
+private:
+    friend class DatagramReceiver;
+
+    std::vector<char> m_slab;       // One maxDatagramBytes slot per datagram read
+    std::vector<size_t> m_offsets;
+    std::vector<int> m_sizes;
+    int m_count = 0;
+    qint64 m_bytes = 0;
+    qint64 m_receivedNs = 0;
+    quint64 m_kernelDrops = 0;
+};
+
+using DatagramBatchPtr = std::shared_ptr<const DatagramBatch>;
+
+/**
+ * @brief UDP reception on its own thread, a batch of datagrams at a time
+ *
+ * One system call takes up to batchSize datagrams (recvmmsg on Linux,
+ * with the kernel's per-socket drop counter alongside; a readDatagram
+ * loop elsewhere) into a batch from a small pool, and batchReady() hands
+ * the whole batch on. Connected from another thread, that is one queued
+ * call per batch rather than one readyRead and one allocation per
+ * datagram. When every pooled batch is still held downstream reading
+ * pauses, so a stalled consumer backs up into the kernel buffer, where the
+ * overflow shows in kernelDrops(), instead of into memory.
+ */
+class DatagramReceiver : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DatagramReceiver(QObject* parent = nullptr);
+    ~DatagramReceiver() override;
+
+    bool start(const DatagramReceiverConfig& config);
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+    quint16 port() const { return m_port; }
+    QString errorString() const { return m_error; }
+
+    struct Statistics {
+        quint64 datagrams = 0;
+        quint64 bytes = 0;
+        quint64 batches = 0;
+        quint64 truncated = 0;      // Over maxDatagramBytes, dropped
+        quint64 kernelDrops = 0;    // As DatagramBatch::kernelDrops()
+        quint64 pauses = 0;         // Times the pool ran dry
+    };
+    Statistics statistics() const;
+
+signals:
+    // Emitted on the receive thread
+    void batchReady(const CounterUAS::DatagramBatchPtr& batch);
+
+private:
+    struct Pool;
+    struct Socket;
+
+    void readPending();
+    void resume();
+    DatagramBatch* acquire();
+    static void release(const std::weak_ptr<Pool>& pool, const DatagramBatch* batch);
+
+    DatagramReceiverConfig m_config;
+    QThread* m_thread = nullptr;
+    QObject* m_context = nullptr;       // Lives on m_thread, parents the socket
+    std::unique_ptr<Socket> m_socket;   // Receive thread only once started
+    std::shared_ptr<Pool> m_pool;
+    quint16 m_port = 0;
+    QString m_error;
+
+    std::atomic<quint64> m_datagrams{0};
+    std::atomic<quint64> m_bytes{0};
+    std::atomic<quint64> m_batches{0};
+    std::atomic<quint64> m_truncated{0};
+    std::atomic<quint64> m_kernelDrops{0};
+    std::atomic<quint64> m_pauses{0};
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::DatagramBatchPtr)
+
+#endif // DATAGRAMRECEIVER_H
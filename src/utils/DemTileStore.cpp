@@ -0,0 +1,206 @@
+#include "utils/DemTileStore.h"
+#include "utils/Logger.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+struct DemTileStore::Tile {
+    QFile file;
+    const uchar* data = nullptr;
+    int posts = 0;
+    int southLatitude = 0;
+    int westLongitude = 0;
+
+    qint16 post(int column, int row) const {
+        return qFromBigEndian<qint16>(data + 2 * (qint64(row) * posts + column));
+    }
+
+    bool sample(double latitude, double longitude, double& elevation) const {
+        const int last = posts - 1;
+        const double u = (longitude - westLongitude) * last;
+        const double v = (southLatitude + 1 - latitude) * last;     // Rows run south from the north edge
+        const int column = qBound(0, int(u), last - 1);
+        const int row = qBound(0, int(v), last - 1);
+        const double fu = qBound(0.0, u - column, 1.0);
+        const double fv = qBound(0.0, v - row, 1.0);
+
+        const qint16 nw = post(column, row);
+        const qint16 ne = post(column + 1, row);
+        const qint16 sw = post(column, row + 1);
+        const qint16 se = post(column + 1, row + 1);
+        if (nw == VOID_POST || ne == VOID_POST || sw == VOID_POST || se == VOID_POST) return false;
+
+        const double north = nw + (ne - nw) * fu;
+        const double south = sw + (se - sw) * fu;
+        elevation = north + (south - north) * fv;
+        return true;
+    }
+};
+
+DemTileStore::DemTileStore(const QString& directory, int maxOpenTiles)
+    : m_directory(directory)
+    , m_maxOpenTiles(qMax(1, maxOpenTiles))
+{
+    static const QRegularExpression pattern("^([NS])(\\d{2})([EW])(\\d{3})\\.hgt$",
+                                            QRegularExpression::CaseInsensitiveOption);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const QFileInfoList entries = QDir(directory).entryInfoList({"*.hgt"}, QDir::Files, QDir::Name);
+    for (const QFileInfo& entry : entries) {
+        const QRegularExpressionMatch match = pattern.match(entry.fileName());
+        if (!match.hasMatch()) continue;
+        int latitude = match.captured(2).toInt();
+        int longitude = match.captured(4).toInt();
+        if (match.captured(1).compare("S", Qt::CaseInsensitive) == 0) latitude = -latitude;
+        if (match.captured(3).compare("W", Qt::CaseInsensitive) == 0) longitude = -longitude;
+        if (latitude < -90 || latitude > 89 || longitude < -180 || longitude > 179) continue;
+
+        m_tileNames.insert(tileKey(latitude, longitude), entry.absoluteFilePath());
+        hash.addData(entry.fileName().toUtf8());
+        const qint64 stamp[] = { entry.size(), entry.lastModified().toMSecsSinceEpoch() };
+        hash.addData(reinterpret_cast<const char*>(stamp), sizeof(stamp));
+    }
+    const QByteArray digest = hash.result();
+    std::memcpy(&m_fingerprint, digest.constData(), sizeof(m_fingerprint));
+}
+
+DemTileStore::~DemTileStore() = default;
+
+DemTileStore::TilePtr DemTileStore::tile(int key) const {
+    if (!m_tileNames.contains(key)) {
+        m_missingTiles.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_open.constFind(key);
+    if (it != m_open.constEnd()) {
+        if (m_recent.first() != key) {
+            m_recent.removeOne(key);
+            m_recent.prepend(key);
+        }
+        if (!*it) m_missingTiles.fetch_add(1, std::memory_order_relaxed);
+        return *it;
+    }
+
+    const TilePtr opened = openTile(key);
+    m_open.insert(key, opened);
+    m_recent.prepend(key);
+    while (m_recent.size() > m_maxOpenTiles) {
+        // Readers holding the tile keep it mapped until they let go
+        m_open.remove(m_recent.takeLast());
+        m_tileEvictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!opened) m_missingTiles.fetch_add(1, std::memory_order_relaxed);
+    return opened;
+}
+
+DemTileStore::TilePtr DemTileStore::openTile(int key) const {
+    const QString path = m_tileNames.value(key);
+    auto tile = std::make_shared<Tile>();
+    tile->file.setFileName(path);
+    tile->southLatitude = key / 360 - 90;
+    tile->westLongitude = key % 360 - 180;
+
+    if (!tile->file.open(QIODevice::ReadOnly)) {
+        Logger::instance().warning("DemTileStore", "Cannot open " + path + ": " + tile->file.errorString());
+        return nullptr;
+    }
+    const qint64 size = tile->file.size();
+    const int posts = int(std::lround(std::sqrt(size / 2.0)));
+    if (posts < 2 || 2 * qint64(posts) * posts != size) {
+        Logger::instance().warning("DemTileStore", "Not a square tile of 16-bit posts: " + path);
+        return nullptr;
+    }
+    tile->data = tile->file.map(0, size);
+    if (!tile->data) {
+        Logger::instance().warning("DemTileStore", "Cannot map " + path + ": " + tile->file.errorString());
+        return nullptr;
+    }
+    tile->posts = posts;
+    m_tileLoads.fetch_add(1, std::memory_order_relaxed);
+    return tile;
+}
+
+bool DemTileStore::elevationM(double latitude, double longitude, double& elevation) const {
+    const int south = int(std::floor(latitude));
+    const int west = int(std::floor(longitude));
+    if (south < -90 || south > 89 || west < -180 || west > 179) return false;
+    const TilePtr found = tile(tileKey(south, west));
+    return found && found->sample(latitude, longitude, elevation);
+}
+
+int DemTileStore::elevationsM(const double* latitudes, const double* longitudes, double* elevations,
+                              int count, double fallback) const {
+    int sampled = 0;
+    int currentKey = -1;
+    TilePtr current;
+    for (int i = 0; i < count; ++i) {
+        elevations[i] = fallback;
+        const int south = int(std::floor(latitudes[i]));
+        const int west = int(std::floor(longitudes[i]));
+        if (south < -90 || south > 89 || west < -180 || west > 179) continue;
+
+        // Neighbouring points share a tile; look it up once per run
+        const int key = tileKey(south, west);
+        if (key != currentKey) {
+            current = tile(key);
+            currentKey = key;
+        }
+        if (current && current->sample(latitudes[i], longitudes[i], elevations[i])) ++sampled;
+    }
+    return sampled;
+}
+
+int DemTileStore::elevationsM(const GeoPosition* positions, double* elevations, int count,
+                              double fallback) const {
+    QVector<double> latitudes(count);
+    QVector<double> longitudes(count);
+    for (int i = 0; i < count; ++i) {
+        latitudes[i] = positions[i].latitude;
+        longitudes[i] = positions[i].longitude;
+    }
+    return elevationsM(latitudes.constData(), longitudes.constData(), elevations, count, fallback);
+}
+
+DemTileStoreStats DemTileStore::stats() const {
+    DemTileStoreStats stats;
+    stats.tileLoads = m_tileLoads.load();
+    stats.tileEvictions = m_tileEvictions.load();
+    stats.missingTiles = m_missingTiles.load();
+    QMutexLocker locker(&m_mutex);
+    stats.openTiles = m_open.size();
+    return stats;
+}
+
+QString DemTileStore::tileName(int southLatitude, int westLongitude) {
+    return QString("%1%2%3%4.hgt")
+        .arg(QChar(southLatitude < 0 ? 'S' : 'N'))
+        .arg(std::abs(southLatitude), 2, 10, QLatin1Char('0'))
+        .arg(QChar(westLongitude < 0 ? 'W' : 'E'))
+        .arg(std::abs(westLongitude), 3, 10, QLatin1Char('0'));
+}
+
+bool DemTileStore::writeTile(const QString& path, int posts, const QVector<qint16>& heights) {
+    if (posts < 2 || heights.size() != posts * posts) return false;
+
+    QByteArray bytes(2 * heights.size(), Qt::Uninitialized);
+    uchar* out = reinterpret_cast<uchar*>(bytes.data());
+    for (int i = 0; i < heights.size(); ++i) {
+        qToBigEndian<qint16>(heights[i], out + 2 * i);
+    }
+
+    QSaveFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size() && file.commit();
+}
+
+} // namespace CounterUAS
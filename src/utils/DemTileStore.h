@@ -0,0 +1,98 @@
+#ifndef DEMTILESTORE_H
+#define DEMTILESTORE_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Tile cache counters
+ */
+struct DemTileStoreStats {
+    quint64 tileLoads = 0;          // Tiles opened and mapped
+    quint64 tileEvictions = 0;      // Mapped tiles dropped for newer ones
+    quint64 missingTiles = 0;       // Lookups of a tile not on disk or unreadable
+    int openTiles = 0;
+};
+
+/**
+ * @brief Ground elevation from a directory of memory-mapped DEM tiles
+ *
+ * Tiles are one degree square in the SRTM .hgt layout, named for their
+ * south-west corner (N51W001.hgt): n by n big-endian 16-bit posts in
+ * metres above mean sea level, rows from the north edge, -32768 for a
+ * void. SRTM1 (3601), SRTM3 (1201) and any other square post count are
+ * taken from the file size; DTED converts to it with
+ * `gdal_translate -of SRTMHGT`. A tile is mapped on first use and only the
+ * pages sampled are ever read; the most recently used maxOpenTiles stay
+ * mapped, older ones are unmapped.
+ *
+ * Samples are bilinear between posts. A point on a missing tile or next
+ * to a void has no elevation. The batch queries look a tile up once per
+ * run of points on it, so sampling a row of positions costs about the
+ * interpolation alone. Safe to query from any thread.
+ */
+class DemTileStore {
+public:
+    static constexpr qint16 VOID_POST = -32768;
+
+    explicit DemTileStore(const QString& directory, int maxOpenTiles = 16);
+    ~DemTileStore();
+
+    QString directory() const { return m_directory; }
+    bool isEmpty() const { return m_tileNames.isEmpty(); }
+    int tileCount() const { return m_tileNames.size(); }
+
+    // False where there is no elevation; elevation is left alone
+    bool elevationM(double latitude, double longitude, double& elevation) const;
+    // Points without one get fallback; returns how many had one
+    int elevationsM(const double* latitudes, const double* longitudes, double* elevations,
+                    int count, double fallback = 0.0) const;
+    int elevationsM(const GeoPosition* positions, double* elevations, int count,
+                    double fallback = 0.0) const;
+
+    // Of the tile files found when the store was made: names, sizes and times
+    quint64 fingerprint() const { return m_fingerprint; }
+    DemTileStoreStats stats() const;
+
+    static QString tileName(int southLatitude, int westLongitude);
+    // posts * posts heights, rows from the north; for preprocessing other
+    // sources into tiles
+    static bool writeTile(const QString& path, int posts, const QVector<qint16>& heights);
+
+private:
+    struct Tile;
+    using TilePtr = std::shared_ptr<const Tile>;
+
+    static int tileKey(int southLatitude, int westLongitude) {
+        return (southLatitude + 90) * 360 + (westLongitude + 180);
+    }
+    TilePtr tile(int key) const;
+    TilePtr openTile(int key) const;
+
+    QString m_directory;
+    int m_maxOpenTiles;
+    QHash<int, QString> m_tileNames;            // Tiles on disk by key, fixed at construction
+    quint64 m_fingerprint = 0;
+
+    mutable QMutex m_mutex;                     // The open tiles and their order
+    mutable QHash<int, TilePtr> m_open;         // Null for a tile that would not map
+    mutable QList<int> m_recent;                // Most recent first
+
+    mutable std::atomic<quint64> m_tileLoads{0};
+    mutable std::atomic<quint64> m_tileEvictions{0};
+    mutable std::atomic<quint64> m_missingTiles{0};
+};
+
+using DemTileStorePtr = std::shared_ptr<const DemTileStore>;
+
+} // namespace CounterUAS
+
+#endif // DEMTILESTORE_H
@@ -0,0 +1,115 @@
+#include "utils/EngagementEnvelope.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr double RAD_TO_DEG = 180.0 / M_PI;
+
+double clockwiseDeg(double fromDeg, double toDeg) {
+    const double d = std::fmod(toDeg - fromDeg, 360.0);
+    return d < 0.0 ? d + 360.0 : d;
+}
+
+} // namespace
+
+bool AzimuthSector::contains(double azimuthDeg) const {
+    return clockwiseDeg(fromDeg, azimuthDeg) <= clockwiseDeg(fromDeg, toDeg);
+}
+
+bool AzimuthSector::overlaps(double otherFromDeg, double otherToDeg) const {
+    // Two clockwise arcs meet when either holds the other's start
+    return contains(otherFromDeg) || AzimuthSector{otherFromDeg, otherToDeg}.contains(fromDeg);
+}
+
+bool EngagementLimits::operator==(const EngagementLimits& o) const {
+    if (minElevationDeg != o.minElevationDeg || maxElevationDeg != o.maxElevationDeg ||
+        noFireSectors.size() != o.noFireSectors.size()) {
+        return false;
+    }
+    for (int i = 0; i < noFireSectors.size(); ++i) {
+        if (noFireSectors[i].fromDeg != o.noFireSectors[i].fromDeg ||
+            noFireSectors[i].toDeg != o.noFireSectors[i].toDeg) {
+            return false;
+        }
+    }
+    return true;
+}
+
+EngagementEnvelopePtr EngagementEnvelope::build(const GeoPosition& origin, double minRangeM, double maxRangeM,
+                                                const EngagementLimits& limits, const Model& model,
+                                                const EngagementEnvelopeConfig& config) {
+    std::shared_ptr<EngagementEnvelope> envelope(new EngagementEnvelope);
+    envelope->m_origin = origin;
+    envelope->m_plane.setOrigin(origin);
+    envelope->m_minRangeM = qMax(0.0, minRangeM);
+    envelope->m_maxRangeM = qMax(envelope->m_minRangeM, maxRangeM);
+
+    const double maxRange = qMax(1.0, envelope->m_maxRangeM);
+    envelope->m_rangeBinM = qMax(1.0, config.rangeBinM);
+    envelope->m_rangeBins = qMax(1, int(std::ceil(maxRange / envelope->m_rangeBinM)));
+    envelope->m_azimuthBins = qMax(1, int(std::ceil(360.0 / qMax(0.01, config.azimuthBinDeg))));
+    envelope->m_azimuthBinDeg = 360.0 / envelope->m_azimuthBins;
+
+    // Elevation bins span the limits exactly, so only azimuth needs the conservative test
+    const double floorDeg = qBound(-90.0, limits.minElevationDeg, 90.0);
+    const double ceilingDeg = qBound(floorDeg, limits.maxElevationDeg, 90.0);
+    envelope->m_elevationFloorDeg = floorDeg;
+    envelope->m_elevationBins = qMax(1, int(std::ceil((ceilingDeg - floorDeg) / qMax(0.01, config.elevationBinDeg))));
+    envelope->m_elevationBinDeg = qMax(1e-6, (ceilingDeg - floorDeg) / envelope->m_elevationBins);
+
+    const int perRange = envelope->m_azimuthBins * envelope->m_elevationBins;
+    envelope->m_cells.resize(envelope->m_rangeBins * perRange);
+    if (!model) return envelope;
+
+    QVector<bool> noFire(envelope->m_azimuthBins, false);
+    for (int a = 0; a < envelope->m_azimuthBins; ++a) {
+        const double from = a * envelope->m_azimuthBinDeg;
+        const double to = from + envelope->m_azimuthBinDeg;
+        noFire[a] = std::any_of(limits.noFireSectors.cbegin(), limits.noFireSectors.cend(),
+                                [from, to](const AzimuthSector& sector) { return sector.overlaps(from, to); });
+    }
+
+    EnvelopeCell* cell = envelope->m_cells.data();
+    for (int r = 0; r < envelope->m_rangeBins; ++r) {
+        const double range = std::clamp((r + 0.5) * envelope->m_rangeBinM,
+                                        envelope->m_minRangeM, envelope->m_maxRangeM);
+        for (int a = 0; a < envelope->m_azimuthBins; ++a) {
+            const double azimuth = (a + 0.5) * envelope->m_azimuthBinDeg;
+            for (int e = 0; e < envelope->m_elevationBins; ++e, ++cell) {
+                if (noFire[a]) continue;
+                const double elevation = floorDeg + (e + 0.5) * envelope->m_elevationBinDeg;
+                EnvelopeCell value = model(range, azimuth, elevation);
+                if (!(value.pk > 0.0f)) value = EnvelopeCell();
+                *cell = value;
+            }
+        }
+    }
+    return envelope;
+}
+
+bool EngagementEnvelope::isFor(const GeoPosition& position) const {
+    return position.latitude == m_origin.latitude &&
+           position.longitude == m_origin.longitude &&
+           position.altitude == m_origin.altitude;
+}
+
+EnvelopeCell EngagementEnvelope::at(const EnuVector& local) const {
+    const double range = local.groundRange();
+    if (range < m_minRangeM || range > m_maxRangeM || m_cells.isEmpty()) return EnvelopeCell();
+
+    const double elevation = std::atan2(local.up, qMax(range, 1e-9)) * RAD_TO_DEG - m_elevationFloorDeg;
+    if (elevation < 0.0 || elevation > m_elevationBins * m_elevationBinDeg) return EnvelopeCell();
+
+    double azimuth = std::atan2(local.east, local.north) * RAD_TO_DEG;
+    if (azimuth < 0.0) azimuth += 360.0;
+
+    const int r = qMin(int(range / m_rangeBinM), m_rangeBins - 1);
+    const int a = qMin(int(azimuth / m_azimuthBinDeg), m_azimuthBins - 1);
+    const int e = qMin(int(elevation / m_elevationBinDeg), m_elevationBins - 1);
+    return m_cells[(r * m_azimuthBins + a) * m_elevationBins + e];
+}
+
+} // namespace CounterUAS
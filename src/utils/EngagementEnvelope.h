@@ -0,0 +1,119 @@
+#ifndef ENGAGEMENTENVELOPE_H
+#define ENGAGEMENTENVELOPE_H
+
+#include <QVector>
+#include <functional>
+#include <memory>
+#include "core/Track.h"
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Bearings an effector must not fire into, clockwise from fromDeg to toDeg
+ */
+struct AzimuthSector {
+    double fromDeg = 0.0;
+    double toDeg = 0.0;
+
+    bool contains(double azimuthDeg) const;
+    // Any part of [fromDeg, toDeg] of another span, clockwise
+    bool overlaps(double fromDeg, double toDeg) const;
+};
+
+/**
+ * @brief Geometry an effector may not engage in, whatever its weapon model says
+ */
+struct EngagementLimits {
+    double minElevationDeg = -10.0;
+    double maxElevationDeg = 90.0;
+    QVector<AzimuthSector> noFireSectors;
+
+    bool operator==(const EngagementLimits& o) const;
+    bool operator!=(const EngagementLimits& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Resolution of an engagement envelope
+ */
+struct EngagementEnvelopeConfig {
+    double rangeBinM = 50.0;
+    double azimuthBinDeg = 5.0;
+    double elevationBinDeg = 5.0;
+};
+
+/**
+ * @brief What an effector achieves against a target in one cell
+ */
+struct EnvelopeCell {
+    float pk = 0.0f;                // 0 where it cannot engage
+    float timeToEffectSec = 0.0f;   // Command to effect: fly-out, dwell, link loss
+
+    bool feasible() const { return pk > 0.0f; }
+};
+
+class EngagementEnvelope;
+using EngagementEnvelopePtr = std::shared_ptr<const EngagementEnvelope>;
+
+/**
+ * @brief An effector's Pk and time to effect in ground range, azimuth and elevation
+ *
+ * build() asks the effector's weapon model once per cell, at the cell's
+ * centre with its range clamped into [minRangeM, maxRangeM], and stores the
+ * answer. The elevation bins span the elevation limits, so anything above
+ * or below is infeasible. Cells any part of which lies inside a no-fire
+ * sector are stored as infeasible, so a bin straddling a sector's edge
+ * errs on the side of holding fire. Range is checked exactly on lookup,
+ * since the range limits are what operators quote.
+ *
+ * After that, feasibility and scoring against any target are a tangent
+ * plane conversion and one array read, however involved the model.
+ * Ranges are ground ranges and elevations angles above the effector's
+ * horizontal, in its tangent plane. Envelopes are immutable and shared;
+ * any thread may read one.
+ */
+class EngagementEnvelope {
+public:
+    // Ground range, azimuth and elevation from the effector to the cell centre
+    using Model = std::function<EnvelopeCell(double rangeM, double azimuthDeg, double elevationDeg)>;
+
+    static EngagementEnvelopePtr build(const GeoPosition& origin, double minRangeM, double maxRangeM,
+                                       const EngagementLimits& limits, const Model& model,
+                                       const EngagementEnvelopeConfig& config = EngagementEnvelopeConfig());
+
+    // True while the effector has not moved since the envelope was built
+    bool isFor(const GeoPosition& position) const;
+    GeoPosition origin() const { return m_origin; }
+
+    EnuVector toLocal(const GeoPosition& target) const { return m_plane.toEnuLinear(target); }
+    // Infeasible outside the range limits
+    EnvelopeCell at(const EnuVector& local) const;
+    EnvelopeCell at(const GeoPosition& target) const { return at(toLocal(target)); }
+
+    double minRangeM() const { return m_minRangeM; }
+    double maxRangeM() const { return m_maxRangeM; }
+    int rangeBins() const { return m_rangeBins; }
+    int azimuthBins() const { return m_azimuthBins; }
+    int elevationBins() const { return m_elevationBins; }
+    double elevationFloorDeg() const { return m_elevationFloorDeg; }
+
+private:
+    EngagementEnvelope() = default;
+
+    GeoPosition m_origin;
+    LocalTangentPlane m_plane;          // At the effector
+    double m_minRangeM = 0.0;
+    double m_maxRangeM = 0.0;
+    double m_rangeBinM = 1.0;
+    double m_azimuthBinDeg = 1.0;
+    double m_elevationBinDeg = 1.0;
+    double m_elevationFloorDeg = 0.0;   // Lower edge of the first elevation bin
+    int m_rangeBins = 0;
+    int m_azimuthBins = 0;
+    int m_elevationBins = 0;
+    QVector<EnvelopeCell> m_cells;      // Range-major, then azimuth, then elevation
+};
+
+} // namespace CounterUAS
+
+#endif // ENGAGEMENTENVELOPE_H
@@ -0,0 +1,78 @@
+#ifndef FASTRANDOM_H
+#define FASTRANDOM_H
+
+#include <QRandomGenerator>
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Small, fast, seedable random stream (xoshiro256**)
+ *
+ * For simulation, where QRandomGenerator::global() costs a lock-free but
+ * shared state update per call and cannot be replayed. Each owner keeps
+ * its own stream, so nothing is shared between threads; streams made from
+ * one seed with different stream numbers are independent, so a simulator
+ * can give each sensor its own and still reproduce the whole run from the
+ * seed. Not for anything security related.
+ */
+class FastRandom {
+public:
+    explicit FastRandom(quint64 seed = 1, quint64 stream = 0) { reseed(seed, stream); }
+
+    void reseed(quint64 seed, quint64 stream = 0) {
+        quint64 streamMix = stream;
+        quint64 x = seed ^ splitMix(streamMix);
+        for (quint64& word : m_state) {
+            word = splitMix(x);
+        }
+    }
+
+    // A seed from the system entropy source, for runs that need not repeat
+    static quint64 entropySeed() { return QRandomGenerator::system()->generate64(); }
+
+    quint64 next() {
+        const quint64 result = rotl(m_state[1] * 5, 7) * 9;
+        const quint64 t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+    // [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+    double uniform(double low, double high) { return low + (high - low) * uniform(); }
+
+    // [0, bound); the bias is below 2^-32
+    quint32 bounded(quint32 bound) {
+        return static_cast<quint32>(((next() >> 32) * bound) >> 32);
+    }
+
+    void fillUniform(double* out, int count, double low, double high) {
+        const double span = high - low;
+        for (int i = 0; i < count; ++i) {
+            out[i] = low + span * (static_cast<double>(next() >> 11) * 0x1.0p-53);
+        }
+    }
+
+private:
+    static quint64 rotl(quint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    // Advances x and returns the next SplitMix64 output
+    static quint64 splitMix(quint64& x) {
+        quint64 z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    quint64 m_state[4];
+};
+
+} // namespace CounterUAS
+
+#endif // FASTRANDOM_H
@@ -0,0 +1,212 @@
+#include "utils/FlightRecorder.h"
+#include "utils/Logger.h"
+#include "utils/TaskScheduler.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+
+namespace CounterUAS {
+
+FlightRecorder& FlightRecorder::instance() {
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+FlightRecorder::FlightRecorder(QObject* parent)
+    : QObject(parent)
+{
+    for (auto& budget : m_stageBudgetUs) budget = 0;
+    setConfig(FlightRecorderConfig());
+}
+
+FlightRecorder::~FlightRecorder() {
+    stop();
+    // The capture task holds this
+    while (m_capturing.load(std::memory_order_acquire)) {
+        QThread::msleep(1);
+    }
+}
+
+void FlightRecorder::setConfig(const FlightRecorderConfig& config) {
+    QMutexLocker locker(&m_mutex);
+    m_config = config;
+    m_config.windowMs = qMax(100, m_config.windowMs);
+    m_config.overrunFactor = qMax(1.0, m_config.overrunFactor);
+    m_config.cooldownMs = qMax(0, m_config.cooldownMs);
+    m_config.maxCaptures = qMax(1, m_config.maxCaptures);
+    m_overrunPercent.store(qRound(m_config.overrunFactor * 100.0), std::memory_order_relaxed);
+    m_cooldownNs.store(qint64(m_config.cooldownMs) * 1000000, std::memory_order_relaxed);
+    for (int s = 0; s < FLIGHT_STAGES; ++s) {
+        m_stageBudgetUs[s].store(qMax<qint64>(0, m_config.stageBudgetUs[s]), std::memory_order_relaxed);
+    }
+}
+
+FlightRecorderConfig FlightRecorder::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+void FlightRecorder::setProbe(const QString& name, Probe probe) {
+    QMutexLocker locker(&m_probeMutex);
+    for (auto& entry : m_probes) {
+        if (entry.first == name) {
+            entry.second = std::move(probe);
+            return;
+        }
+    }
+    m_probes.append(qMakePair(name, std::move(probe)));
+}
+
+void FlightRecorder::clearProbes() {
+    QMutexLocker locker(&m_probeMutex);
+    m_probes.clear();
+}
+
+void FlightRecorder::start() {
+    if (m_running.exchange(true, std::memory_order_relaxed)) return;
+    Trace::setEnabled(true);
+    Logger::instance().info("FlightRecorder", QString("Recording; overruns are captured to %1")
+                                                  .arg(captureDirectory()));
+}
+
+void FlightRecorder::stop() {
+    if (!m_running.exchange(false, std::memory_order_relaxed)) return;
+    Trace::setEnabled(false);
+}
+
+void FlightRecorder::reportCycle(FlightStage stage, qint64 elapsedUs, qint64 budgetUs) {
+    if (!m_running.load(std::memory_order_relaxed)) return;
+    const int s = static_cast<int>(stage);
+    const qint64 endNs = Trace::nowNs();
+    if (Trace::isEnabled()) {
+        Trace::record("cycle", stageKey(stage), endNs - elapsedUs * 1000, endNs);
+    }
+
+    if (budgetUs <= 0) budgetUs = m_stageBudgetUs[s].load(std::memory_order_relaxed);
+    if (budgetUs <= 0 || elapsedUs * 100 <= budgetUs * m_overrunPercent.load(std::memory_order_relaxed)) return;
+    m_overruns.fetch_add(1, std::memory_order_relaxed);
+
+    const qint64 lastNs = m_lastCaptureNs.load(std::memory_order_relaxed);
+    bool idle = false;
+    if ((lastNs != 0 && endNs - lastNs < m_cooldownNs.load(std::memory_order_relaxed)) ||
+        !m_capturing.compare_exchange_strong(idle, true, std::memory_order_acq_rel)) {
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_lastCaptureNs.store(endNs, std::memory_order_relaxed);
+
+    // Frozen until the capture is written, so the lead up survives it
+    Trace::setEnabled(false);
+    Overrun overrun;
+    overrun.stage = stage;
+    overrun.elapsedUs = elapsedUs;
+    overrun.budgetUs = budgetUs;
+    overrun.endNs = endNs;
+    overrun.wallMs = QDateTime::currentMSecsSinceEpoch();
+    TaskScheduler::instance().submit([this, overrun]() { capture(overrun); }, TaskPriority::Background);
+}
+
+void FlightRecorder::capture(const Overrun& overrun) {
+    const FlightRecorderConfig config = this->config();
+
+    QJsonObject args;
+    args.insert("stage", stageKey(overrun.stage));
+    args.insert("elapsedUs", overrun.elapsedUs);
+    args.insert("budgetUs", overrun.budgetUs);
+    QJsonObject counters;
+    {
+        QMutexLocker locker(&m_probeMutex);
+        for (const auto& entry : m_probes) {
+            const double value = entry.second();
+            args.insert(entry.first, value);
+            counters.insert(entry.first, value);
+        }
+    }
+
+    // On the overrun's own timeline, global so it shows over every thread
+    const qint64 pid = QCoreApplication::applicationPid();
+    const double tsUs = overrun.endNs / 1000.0;
+    QJsonObject instant{{"name", "overrun"}, {"cat", "flight-recorder"}, {"ph", "i"}, {"s", "g"},
+                        {"ts", tsUs}, {"pid", pid}, {"tid", 0}, {"args", args}};
+    QJsonObject counter{{"name", "state"}, {"cat", "flight-recorder"}, {"ph", "C"},
+                        {"ts", tsUs}, {"pid", pid}, {"tid", 0}, {"args", counters}};
+    const QByteArray json = Trace::toChromeJson(overrun.endNs - qint64(config.windowMs) * 1000000,
+        {QJsonDocument(instant).toJson(QJsonDocument::Compact),
+         QJsonDocument(counter).toJson(QJsonDocument::Compact)});
+    if (m_running.load(std::memory_order_relaxed)) Trace::setEnabled(true);
+
+    const QString directory = captureDirectory();
+    const QString path = QDir(directory).filePath(QString("overrun-%1-%2.json")
+        .arg(QDateTime::fromMSecsSinceEpoch(overrun.wallMs).toString("yyyyMMdd-hhmmss-zzz"))
+        .arg(stageKey(overrun.stage)));
+    bool written = QDir().mkpath(directory);
+    if (written) {
+        QSaveFile file(path);
+        written = file.open(QIODevice::WriteOnly) && file.write(json) == json.size() && file.commit();
+    }
+
+    if (!written) {
+        {
+            QMutexLocker locker(&m_mutex);
+            ++m_stats.failed;
+        }
+        Logger::instance().warning("FlightRecorder", QString("Could not write %1").arg(path));
+        m_capturing.store(false, std::memory_order_release);
+        return;
+    }
+
+    prune(directory, config.maxCaptures);
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_stats.captures;
+        m_stats.lastCapture = path;
+    }
+    Logger::instance().warning("FlightRecorder", QString("%1 took %2 ms against %3 ms; captured %4")
+        .arg(stageKey(overrun.stage))
+        .arg(overrun.elapsedUs / 1000.0, 0, 'f', 1)
+        .arg(overrun.budgetUs / 1000.0, 0, 'f', 1)
+        .arg(path));
+    emit captured(path, overrun.stage);
+    m_capturing.store(false, std::memory_order_release);
+}
+
+QString FlightRecorder::captureDirectory() const {
+    const QString directory = config().directory;
+    if (!directory.isEmpty()) return directory;
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/flight-recorder";
+}
+
+void FlightRecorder::prune(const QString& directory, int keep) const {
+    // Names start with the time, so they sort oldest first
+    QDir dir(directory);
+    const QStringList captures = dir.entryList({"overrun-*.json"}, QDir::Files, QDir::Name);
+    for (int i = 0; i < captures.size() - keep; ++i) {
+        dir.remove(captures.at(i));
+    }
+}
+
+FlightRecorder::Stats FlightRecorder::stats() const {
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.overruns = m_overruns.load(std::memory_order_relaxed);
+    stats.suppressed = m_suppressed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const char* FlightRecorder::stageKey(FlightStage stage) {
+    switch (stage) {
+    case FlightStage::TrackCycle: return "track_cycle";
+    case FlightStage::Assessment: return "assessment";
+    case FlightStage::Paint: return "paint";
+    case FlightStage::FrameDelivery: return "frame_delivery";
+    }
+    return "unknown";
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,158 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include "utils/Trace.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Work whose cycles the flight recorder times
+ */
+enum class FlightStage : quint8 {
+    TrackCycle = 0,     // TrackManager's processTrackCycle against 1000 / updateRateHz
+    Assessment,         // ThreatAssessor's cycle against assessmentIntervalMs
+    Paint,              // A display's paintEvent
+    FrameDelivery       // A video subscriber's frame callback on its thread
+};
+
+constexpr int FLIGHT_STAGES = 4;
+
+/**
+ * @brief When an overrun is captured, and where to
+ */
+struct FlightRecorderConfig {
+    QString directory;              // Empty for flight-recorder under the application's data directory
+    int windowMs = 5000;            // Trace kept in a capture, up to the overrun
+    double overrunFactor = 1.5;     // A cycle over its budget by this much is captured
+    int cooldownMs = 60000;         // After a capture, overruns are counted but not captured
+    int maxCaptures = 20;           // Files kept; the oldest go first
+    qint64 stageBudgetUs[FLIGHT_STAGES] = {0, 0, 50000, 20000};    // For stages reported without one
+};
+
+/**
+ * @brief Always-on trace with a capture on the first overrun
+ *
+ * While running, tracing stays on, so each thread's trace ring always
+ * holds its last few thousand events, and every timed cycle is recorded
+ * into it too, under the "cycle" category. A cycle is reported through
+ * reportCycle() or FlightScope, from any thread and without a lock; one
+ * over its budget by more than overrunFactor freezes tracing, so its lead
+ * up is not overwritten, and hands the capture to a background task. That
+ * task reads the probes (track count, stream count, queue depths),
+ * writes the last windowMs of trace in the Chrome format with the overrun
+ * and the probe values as an instant event, prunes the directory to
+ * maxCaptures files and resumes tracing.
+ *
+ * One capture at a time, and none within cooldownMs of the last, so a
+ * sustained overload leaves one file rather than a stream of them.
+ * Captures are logged and announced by captured(), emitted from the task.
+ * While nothing overruns the cost is the trace scopes' own and a clock read
+ * per reported cycle.
+ */
+class FlightRecorder : public QObject {
+    Q_OBJECT
+
+public:
+    // Called on a pool thread right after an overrun; must be thread-safe
+    using Probe = std::function<double()>;
+
+    static FlightRecorder& instance();
+
+    explicit FlightRecorder(QObject* parent = nullptr);
+    ~FlightRecorder() override;     // Waits for a capture being written
+
+    void setConfig(const FlightRecorderConfig& config);
+    FlightRecorderConfig config() const;
+
+    // Replaces a probe of the same name; clearProbes() waits for a capture reading them
+    void setProbe(const QString& name, Probe probe);
+    void clearProbes();
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_running.load(std::memory_order_relaxed); }
+    bool isCapturing() const { return m_capturing.load(std::memory_order_acquire); }
+
+    // From any thread, once per cycle; budgetUs 0 for the stage's configured budget
+    void reportCycle(FlightStage stage, qint64 elapsedUs, qint64 budgetUs = 0);
+
+    struct Stats {
+        quint64 overruns = 0;
+        quint64 captures = 0;
+        quint64 suppressed = 0;     // Overruns during a capture or its cooldown
+        quint64 failed = 0;         // Captures that could not be written
+        QString lastCapture;
+    };
+    Stats stats() const;
+
+    static const char* stageKey(FlightStage stage);
+
+signals:
+    void captured(const QString& path, FlightStage stage);
+
+private:
+    struct Overrun {
+        FlightStage stage = FlightStage::TrackCycle;
+        qint64 elapsedUs = 0;
+        qint64 budgetUs = 0;
+        qint64 endNs = 0;
+        qint64 wallMs = 0;
+    };
+
+    void capture(const Overrun& overrun);
+    QString captureDirectory() const;
+    void prune(const QString& directory, int keep) const;
+
+    mutable QMutex m_mutex;
+    FlightRecorderConfig m_config;
+    Stats m_stats;                  // Besides the atomics below
+
+    QMutex m_probeMutex;            // Held while a capture reads them
+    QVector<QPair<QString, Probe>> m_probes;
+
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_capturing{false};
+    std::atomic<int> m_overrunPercent{150};
+    std::atomic<qint64> m_cooldownNs{0};
+    std::atomic<qint64> m_lastCaptureNs{0};
+    std::atomic<qint64> m_stageBudgetUs[FLIGHT_STAGES];
+    std::atomic<quint64> m_overruns{0};
+    std::atomic<quint64> m_suppressed{0};
+};
+
+/**
+ * @brief Times the enclosing scope as one cycle of a stage
+ */
+class FlightScope {
+public:
+    explicit FlightScope(FlightStage stage, qint64 budgetUs = 0)
+        : m_stage(stage)
+        , m_budgetUs(budgetUs)
+        , m_beginNs(FlightRecorder::instance().isRunning() ? Trace::nowNs() : -1)
+    {
+    }
+
+    ~FlightScope() {
+        if (m_beginNs >= 0) {
+            FlightRecorder::instance().reportCycle(m_stage, (Trace::nowNs() - m_beginNs) / 1000, m_budgetUs);
+        }
+    }
+
+    FlightScope(const FlightScope&) = delete;
+    FlightScope& operator=(const FlightScope&) = delete;
+
+private:
+    FlightStage m_stage;
+    qint64 m_budgetUs;
+    qint64 m_beginNs;
+};
+
+} // namespace CounterUAS
+
+#endif // FLIGHTRECORDER_H
@@ -7,10 +7,14 @@ FrameBuffer::FrameBuffer(int capacity, QObject* parent)
     : QObject(parent), m_capacity(capacity) {}
 
 void FrameBuffer::push(const QImage& frame, qint64 timestamp) {
+    push(VideoFrame(frame), timestamp);
+}
+
+void FrameBuffer::push(const VideoFrame& frame, qint64 timestamp) {
     QMutexLocker locker(&m_mutex);
     
     BufferedFrame bf;
-    bf.image = frame;
+    bf.frame = frame;
     bf.timestamp = timestamp;
     bf.frameNumber = m_frameCounter++;
     
@@ -19,11 +23,12 @@ void FrameBuffer::push(const QImage& frame, qint64 timestamp) {
     while (m_buffer.size() > m_capacity) {
         m_buffer.dequeue();
     }
+    const bool full = m_buffer.size() >= m_capacity;
     
     locker.unlock();
     emit frameAvailable();
     
-    if (m_buffer.size() >= m_capacity) {
+    if (full) {
         emit bufferFull();
     }
 }
@@ -6,20 +6,29 @@
 #include <QMutex>
 #include <QQueue>
 
+#include "utils/VideoFrame.h"
+
 namespace CounterUAS {
 
 struct BufferedFrame {
-    QImage image;
-    qint64 timestamp;
-    int frameNumber;
+    VideoFrame frame;     // Native format; frame.toImage() for RGB
+    qint64 timestamp = 0;
+    int frameNumber = 0;
 };
 
+/**
+ * @brief Mutex-guarded frame queue that signals every push
+ *
+ * For GUI-side consumers driven by frameAvailable. Stages on their own
+ * threads should use FrameRing, which neither locks nor signals.
+ */
 class FrameBuffer : public QObject {
     Q_OBJECT
     
 public:
     explicit FrameBuffer(int capacity = 30, QObject* parent = nullptr);
     
+    void push(const VideoFrame& frame, qint64 timestamp);
     void push(const QImage& frame, qint64 timestamp);
     BufferedFrame pop();
     BufferedFrame peek() const;
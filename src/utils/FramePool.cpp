@@ -0,0 +1,107 @@
+#include "utils/FramePool.h"
+#include "utils/MemoryAccounting.h"
+#include <QMutexLocker>
+#include <cstring>
+
+namespace CounterUAS {
+
+FramePool::Lease::~Lease() {
+    if (data) {
+        MemoryAccounting::released(MemoryTag::VideoFrames, qint64(bytesPerLine) * shape.height);
+    }
+}
+
+FramePool::State::~State() {
+    qDeleteAll(idle);
+}
+
+FramePool::FramePool(int maxIdlePerShape)
+    : m_state(std::make_shared<State>())
+{
+    m_state->maxIdle = qMax(0, maxIdlePerShape);
+}
+
+FramePool::~FramePool() = default;
+
+QImage FramePool::acquire(const QSize& size, QImage::Format format) {
+    if (size.isEmpty() || format == QImage::Format_Invalid) return QImage();
+
+    Shape shape;
+    shape.width = size.width();
+    shape.height = size.height();
+    shape.format = format;
+
+    Lease* lease = nullptr;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        if (shape != m_state->current) {
+            qDeleteAll(m_state->idle);
+            m_state->idle.clear();
+            m_state->current = shape;
+        }
+        if (!m_state->idle.isEmpty()) {
+            lease = m_state->idle.takeLast();
+            ++m_state->stats.reused;
+        }
+        ++m_state->stats.outstanding;
+    }
+
+    if (!lease) {
+        // QImage's own line layout: 32-bit aligned rows
+        const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+        lease = new Lease;
+        lease->pool = m_state;
+        lease->shape = shape;
+        lease->bytesPerLine = ((shape.width * depth + 31) / 32) * 4;
+        lease->data.reset(new uchar[static_cast<size_t>(lease->bytesPerLine) * shape.height]);
+        MemoryAccounting::allocated(MemoryTag::VideoFrames, qint64(lease->bytesPerLine) * shape.height);
+
+        QMutexLocker locker(&m_state->mutex);
+        ++m_state->stats.allocated;
+    }
+
+    return QImage(lease->data.get(), shape.width, shape.height, lease->bytesPerLine,
+                  format, &FramePool::release, lease);
+}
+
+QImage FramePool::acquireCopy(const uchar* bits, int width, int height, int bytesPerLine,
+                              QImage::Format format) {
+    if (!bits) return QImage();
+    QImage frame = acquire(QSize(width, height), format);
+    if (frame.isNull()) return frame;
+
+    const int rowBytes = qMin(bytesPerLine, static_cast<int>(frame.bytesPerLine()));
+    uchar* dst = frame.bits();
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(dst + y * frame.bytesPerLine(), bits + y * bytesPerLine, rowBytes);
+    }
+    return frame;
+}
+
+FramePool::Stats FramePool::stats() const {
+    QMutexLocker locker(&m_state->mutex);
+    Stats stats = m_state->stats;
+    stats.idle = m_state->idle.size();
+    return stats;
+}
+
+void FramePool::trim() {
+    QMutexLocker locker(&m_state->mutex);
+    qDeleteAll(m_state->idle);
+    m_state->idle.clear();
+}
+
+void FramePool::release(void* info) {
+    Lease* lease = static_cast<Lease*>(info);
+    if (std::shared_ptr<State> state = lease->pool.lock()) {
+        QMutexLocker locker(&state->mutex);
+        --state->stats.outstanding;
+        if (lease->shape == state->current && state->idle.size() < state->maxIdle) {
+            state->idle.append(lease);
+            return;
+        }
+    }
+    delete lease;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,87 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+#include <memory>
+
+namespace CounterUAS {
+
+/**
+ * @brief Recycled pixel buffers for video frames
+ *
+ * acquire() hands out a QImage over a pooled buffer. QImage's implicit
+ * sharing then carries that one buffer from the decoder through the
+ * overlay, display, frame buffer and recorder without copying pixels; when
+ * the last reference is dropped, on whatever thread, the buffer returns to
+ * the pool for the next frame of the same size and format.
+ *
+ * Consumers must only read pooled frames. Writing to a frame that is also
+ * held elsewhere detaches it into an ordinary heap copy, which is correct
+ * but forfeits the saving.
+ *
+ * Only buffers for the most recently requested shape are kept, so a
+ * resolution change frees the old ones as they come back. Frames may
+ * outlive the pool; their buffers are then simply freed.
+ */
+class FramePool {
+public:
+    explicit FramePool(int maxIdlePerShape = 4);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Uninitialised pixels; a null image for an empty size or invalid format
+    QImage acquire(const QSize& size, QImage::Format format);
+
+    // For decoders whose mapped buffer goes away: one copy, into a pooled frame
+    QImage acquireCopy(const uchar* bits, int width, int height, int bytesPerLine,
+                       QImage::Format format);
+
+    struct Stats {
+        quint64 allocated = 0;   // Buffers created
+        quint64 reused = 0;      // Acquires served from idle buffers
+        int outstanding = 0;     // Frames still referenced
+        int idle = 0;
+    };
+    Stats stats() const;
+
+    void trim();   // Frees the idle buffers
+
+private:
+    struct Shape {
+        int width = 0;
+        int height = 0;
+        QImage::Format format = QImage::Format_Invalid;
+        bool operator==(const Shape& o) const {
+            return width == o.width && height == o.height && format == o.format;
+        }
+        bool operator!=(const Shape& o) const { return !(*this == o); }
+    };
+    struct State;
+    struct Lease {
+        std::weak_ptr<State> pool;
+        Shape shape;
+        int bytesPerLine = 0;
+        std::unique_ptr<uchar[]> data;
+        ~Lease();       // Accounted under MemoryTag::VideoFrames while it lives
+    };
+    struct State {
+        mutable QMutex mutex;
+        int maxIdle = 4;
+        Shape current;
+        QVector<Lease*> idle;
+        Stats stats;
+        ~State();
+    };
+
+    static void release(void* lease);
+
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace CounterUAS
+
+#endif // FRAMEPOOL_H
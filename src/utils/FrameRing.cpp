@@ -0,0 +1,110 @@
+#include "utils/FrameRing.h"
+#include <QMutexLocker>
+#include <QThread>
+
+namespace CounterUAS {
+
+FrameRing::FrameRing(int capacity, FrameRingPolicy policy)
+    : m_policy(policy)
+    , m_ring(policy == FrameRingPolicy::LatestOnly ? 2 : static_cast<std::size_t>(qMax(2, capacity)))
+{
+}
+
+int FrameRing::capacity() const {
+    return m_policy == FrameRingPolicy::LatestOnly ? 1 : static_cast<int>(m_ring.capacity());
+}
+
+bool FrameRing::push(const VideoFrame& frame, qint64 timestamp) {
+    BufferedFrame buffered;
+    buffered.frame = frame;
+    buffered.timestamp = timestamp;
+    buffered.frameNumber = m_frameCounter++;
+
+    switch (m_policy) {
+    case FrameRingPolicy::LatestOnly:
+        if (m_latest.publish(std::move(buffered))) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        break;
+    case FrameRingPolicy::Fifo:
+        if (!m_ring.tryPush(buffered)) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        break;
+    case FrameRingPolicy::DropOldest:
+        while (!m_ring.tryPush(buffered)) {
+            BufferedFrame evicted;
+            if (m_ring.tryPop(evicted)) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                // The consumer is mid-pop on the cell we need; it is ours shortly
+                QThread::yieldCurrentThread();
+            }
+        }
+        break;
+    }
+
+    m_pushed.fetch_add(1, std::memory_order_relaxed);
+    notifyConsumer();
+    return true;
+}
+
+bool FrameRing::tryPop(BufferedFrame& out) {
+    const bool popped = m_policy == FrameRingPolicy::LatestOnly ? m_latest.take(out)
+                                                                : m_ring.tryPop(out);
+    if (popped) m_popped.fetch_add(1, std::memory_order_relaxed);
+    return popped;
+}
+
+bool FrameRing::waitPop(BufferedFrame& out, int timeoutMs) {
+    if (tryPop(out)) return true;
+
+    QMutexLocker locker(&m_waitMutex);
+    m_sleeping.store(1, std::memory_order_relaxed);
+    // Re-checked under the flag: a push from here on sees it and wakes us
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool popped = tryPop(out);
+    if (!popped && !m_woken.exchange(false)) {
+        if (timeoutMs < 0) {
+            m_waitCondition.wait(&m_waitMutex);
+        } else {
+            m_waitCondition.wait(&m_waitMutex, static_cast<unsigned long>(timeoutMs));
+        }
+        m_woken.store(false);
+        popped = tryPop(out);
+    }
+    m_sleeping.store(0, std::memory_order_relaxed);
+    return popped;
+}
+
+void FrameRing::wakeConsumer() {
+    QMutexLocker locker(&m_waitMutex);
+    m_woken.store(true);
+    m_waitCondition.wakeAll();
+}
+
+int FrameRing::sizeApprox() const {
+    if (m_policy == FrameRingPolicy::LatestOnly) return m_latest.hasValue() ? 1 : 0;
+    return static_cast<int>(m_ring.sizeApprox());
+}
+
+FrameRingStats FrameRing::stats() const {
+    FrameRingStats stats;
+    stats.pushed = m_pushed.load(std::memory_order_relaxed);
+    stats.popped = m_popped.load(std::memory_order_relaxed);
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void FrameRing::notifyConsumer() {
+    // Pairs with the store in waitPop(): either the consumer's re-check sees
+    // this frame or this load sees the consumer asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed) == 0) return;
+    QMutexLocker locker(&m_waitMutex);
+    m_waitCondition.wakeOne();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,90 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+
+#include "utils/FrameBuffer.h"
+#include "utils/SpscRing.h"
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief What a FrameRing does with a frame when the consumer is behind
+ */
+enum class FrameRingPolicy {
+    Fifo,         // Keeps every frame; push() fails while full
+    DropOldest,   // Evicts the oldest queued frame to make room
+    LatestOnly    // Holds one frame; each push replaces the last
+};
+
+/**
+ * @brief Frame counters, safe to read from any thread
+ */
+struct FrameRingStats {
+    quint64 pushed = 0;
+    quint64 popped = 0;
+    quint64 rejected = 0;     // Fifo: full when pushed
+    quint64 dropped = 0;      // DropOldest evictions and LatestOnly replacements
+};
+
+/**
+ * @brief Lock-free frame hand-off between two pipeline stages
+ *
+ * The lock-free counterpart of FrameBuffer for capture, decode, overlay
+ * and record stages that each run on their own thread: exactly one
+ * producer thread calls push() and one consumer thread pops. Pushing and
+ * popping take no lock and emit nothing. A consumer that would rather
+ * sleep than poll calls waitPop(); the producer only touches the wait
+ * condition while a consumer is actually asleep, so a busy pipeline pays
+ * for one atomic load per frame.
+ */
+class FrameRing {
+public:
+    explicit FrameRing(int capacity = 8, FrameRingPolicy policy = FrameRingPolicy::DropOldest);
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    FrameRingPolicy policy() const { return m_policy; }
+    int capacity() const;
+
+    // Producer thread
+    bool push(const VideoFrame& frame, qint64 timestamp);
+
+    // Consumer thread
+    bool tryPop(BufferedFrame& out);
+    // False when it wakes with nothing queued: timeout, wakeConsumer() or
+    // a spurious wake. A negative timeout waits indefinitely.
+    bool waitPop(BufferedFrame& out, int timeoutMs = -1);
+
+    // Any thread: lets a waiting consumer return, e.g. to shut down
+    void wakeConsumer();
+
+    int sizeApprox() const;
+    FrameRingStats stats() const;
+
+private:
+    void notifyConsumer();
+
+    const FrameRingPolicy m_policy;
+    SpscRing<BufferedFrame> m_ring;
+    LatestSlot<BufferedFrame> m_latest;
+    int m_frameCounter = 0;   // Producer's
+
+    QMutex m_waitMutex;
+    QWaitCondition m_waitCondition;
+    std::atomic<int> m_sleeping{0};
+    std::atomic<bool> m_woken{false};
+
+    std::atomic<quint64> m_pushed{0};
+    std::atomic<quint64> m_popped{0};
+    std::atomic<quint64> m_rejected{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+} // namespace CounterUAS
+
+#endif // FRAMERING_H
@@ -0,0 +1,467 @@
+#include "utils/ImmFilterBank.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int N = ImmFilterBank::STATE_DIM;
+constexpr int AXIS_E = 0;
+constexpr int AXIS_N = 1;
+constexpr int AXIS_U = 2;
+constexpr int POS = 0;
+constexpr int VEL = 1;
+constexpr int ACC = 2;
+
+// Keeps the pinned acceleration states of CV/CT numerically positive
+constexpr double PINNED_ACCEL_VARIANCE = 1e-4;
+constexpr double MIN_MODE_PROBABILITY = 1e-6;
+
+inline int si(int axis, int deriv) { return axis * 3 + deriv; }
+
+// out = F * x
+void multiplyVector(const double* F, const double* x, double* out) {
+    for (int r = 0; r < N; ++r) {
+        double sum = 0.0;
+        for (int c = 0; c < N; ++c) {
+            sum += F[r * N + c] * x[c];
+        }
+        out[r] = sum;
+    }
+}
+
+// out = F * P * F^T + Q
+void propagateCovariance(const double* F, const double* P, const double* Q, double* out) {
+    double FP[N * N];
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            double sum = 0.0;
+            for (int k = 0; k < N; ++k) {
+                sum += F[r * N + k] * P[k * N + c];
+            }
+            FP[r * N + c] = sum;
+        }
+    }
+    for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+            double sum = 0.0;
+            for (int k = 0; k < N; ++k) {
+                sum += FP[r * N + k] * F[c * N + k];
+            }
+            out[r * N + c] = sum + Q[r * N + c];
+        }
+    }
+}
+
+void addWhiteAcceleration(double* Q, int axis, double q, double dt) {
+    const int p = si(axis, POS);
+    const int v = si(axis, VEL);
+    Q[p * N + p] += q * dt * dt * dt / 3.0;
+    Q[p * N + v] += q * dt * dt / 2.0;
+    Q[v * N + p] += q * dt * dt / 2.0;
+    Q[v * N + v] += q * dt;
+}
+
+} // namespace
+
+ImmFilterBank::ImmFilterBank()
+    : m_turnRateRadPerSec(15.0 * M_PI / 180.0)
+{
+    setSwitchProbability(0.05);
+}
+
+void ImmFilterBank::setTurnRate(double degPerSec) {
+    m_turnRateRadPerSec = degPerSec * M_PI / 180.0;
+}
+
+void ImmFilterBank::setSwitchProbability(double p) {
+    p = qBound(0.0, p, 1.0);
+    for (int i = 0; i < MODE_COUNT; ++i) {
+        for (int j = 0; j < MODE_COUNT; ++j) {
+            m_switch[i][j] = (i == j) ? 1.0 - p : p / (MODE_COUNT - 1);
+        }
+    }
+}
+
+void ImmFilterBank::setProcessNoise(double accelPsd, double jerkPsd) {
+    m_accelPsd = accelPsd;
+    m_jerkPsd = jerkPsd;
+}
+
+void ImmFilterBank::ensureCapacity(int slot) {
+    if (slot < m_active.size()) return;
+
+    const int size = slot + 1;
+    m_x.resize(size * MODE_COUNT * STATE_DIM);
+    m_P.resize(size * MODE_COUNT * COV_SIZE);
+    m_mu.resize(size * MODE_COUNT);
+    m_timestampMs.resize(size);
+    m_active.resize(size);
+}
+
+void ImmFilterBank::initialize(int slot, const EnuVector& position, qint64 timestampMs) {
+    if (slot < 0) return;
+    ensureCapacity(slot);
+
+    const double pos[3] = { position.east, position.north, position.up };
+    const double posVar = m_measurementSigmaM * m_measurementSigmaM;
+    const double velVar = m_initialVelocitySigma * m_initialVelocitySigma;
+
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        double* x = modeState(slot, mode);
+        double* P = modeCov(slot, mode);
+        std::fill(x, x + STATE_DIM, 0.0);
+        std::fill(P, P + COV_SIZE, 0.0);
+
+        const double accVar = mode == ModeConstantAcceleration
+            ? m_initialAccelerationSigma * m_initialAccelerationSigma : PINNED_ACCEL_VARIANCE;
+        for (int axis = 0; axis < 3; ++axis) {
+            x[si(axis, POS)] = pos[axis];
+            P[si(axis, POS) * N + si(axis, POS)] = posVar;
+            P[si(axis, VEL) * N + si(axis, VEL)] = velVar;
+            P[si(axis, ACC) * N + si(axis, ACC)] = accVar;
+        }
+
+        m_mu[slot * MODE_COUNT + mode] = 1.0 / MODE_COUNT;
+    }
+
+    m_timestampMs[slot] = timestampMs;
+    m_active[slot] = 1;
+}
+
+ImmFilterBank::SlotState ImmFilterBank::slotState(int slot) const {
+    SlotState saved;
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        std::memcpy(saved.state[mode], modeState(slot, mode), sizeof(saved.state[mode]));
+        std::memcpy(saved.cov[mode], modeCov(slot, mode), sizeof(saved.cov[mode]));
+        saved.probability[mode] = modeProbability(slot, mode);
+    }
+    saved.timestampMs = m_timestampMs[slot];
+    return saved;
+}
+
+void ImmFilterBank::restoreSlot(int slot, const SlotState& state) {
+    if (slot < 0) return;
+    ensureCapacity(slot);
+
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        std::memcpy(modeState(slot, mode), state.state[mode], sizeof(state.state[mode]));
+        std::memcpy(modeCov(slot, mode), state.cov[mode], sizeof(state.cov[mode]));
+        m_mu[slot * MODE_COUNT + mode] = state.probability[mode];
+    }
+    m_timestampMs[slot] = state.timestampMs;
+    m_active[slot] = 1;
+}
+
+void ImmFilterBank::release(int slot) {
+    if (isActive(slot)) {
+        m_active[slot] = 0;
+    }
+}
+
+void ImmFilterBank::clear() {
+    m_x.clear();
+    m_P.clear();
+    m_mu.clear();
+    m_timestampMs.clear();
+    m_active.clear();
+}
+
+void ImmFilterBank::buildTransition(int mode, double dt, double* F, double* Q) const {
+    std::fill(F, F + COV_SIZE, 0.0);
+    std::fill(Q, Q + COV_SIZE, 0.0);
+
+    if (mode == ModeConstantAcceleration) {
+        const double h = 0.5 * dt * dt;
+        const double q = m_jerkPsd;
+        const double d2 = dt * dt, d3 = d2 * dt, d4 = d3 * dt, d5 = d4 * dt;
+        const double qb[3][3] = {
+            { q * d5 / 20.0, q * d4 / 8.0, q * d3 / 6.0 },
+            { q * d4 / 8.0,  q * d3 / 3.0, q * d2 / 2.0 },
+            { q * d3 / 6.0,  q * d2 / 2.0, q * dt }
+        };
+        for (int axis = 0; axis < 3; ++axis) {
+            const int p = si(axis, POS), v = si(axis, VEL), a = si(axis, ACC);
+            F[p * N + p] = 1.0; F[p * N + v] = dt; F[p * N + a] = h;
+            F[v * N + v] = 1.0; F[v * N + a] = dt;
+            F[a * N + a] = 1.0;
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 3; ++j) {
+                    Q[si(axis, i) * N + si(axis, j)] = qb[i][j];
+                }
+            }
+        }
+        return;
+    }
+
+    // CV and CT drive acceleration to zero and share white-acceleration noise
+    for (int axis = 0; axis < 3; ++axis) {
+        const int p = si(axis, POS), v = si(axis, VEL), a = si(axis, ACC);
+        F[p * N + p] = 1.0;
+        F[p * N + v] = dt;
+        F[v * N + v] = 1.0;
+        Q[a * N + a] = PINNED_ACCEL_VARIANCE;
+        addWhiteAcceleration(Q, axis, m_accelPsd, dt);
+    }
+
+    if (mode == ModeTurnLeft || mode == ModeTurnRight) {
+        const double w = mode == ModeTurnLeft ? m_turnRateRadPerSec : -m_turnRateRadPerSec;
+        if (std::fabs(w * dt) > 1e-9) {
+            const double s = std::sin(w * dt);
+            const double c = std::cos(w * dt);
+            const int e = si(AXIS_E, POS), ve = si(AXIS_E, VEL);
+            const int n = si(AXIS_N, POS), vn = si(AXIS_N, VEL);
+
+            // Counter-clockwise rotation of the horizontal velocity for w > 0
+            F[e * N + ve] = s / w;
+            F[e * N + vn] = -(1.0 - c) / w;
+            F[ve * N + ve] = c;
+            F[ve * N + vn] = -s;
+            F[n * N + ve] = (1.0 - c) / w;
+            F[n * N + vn] = s / w;
+            F[vn * N + ve] = s;
+            F[vn * N + vn] = c;
+        }
+    }
+}
+
+void ImmFilterBank::mixAndPredict(int slot, double dt) {
+    double* mu = m_mu.data() + slot * MODE_COUNT;
+
+    // Predicted mode probabilities and mixing weights mu[i|j]
+    double cbar[MODE_COUNT];
+    double weight[MODE_COUNT][MODE_COUNT];
+    for (int j = 0; j < MODE_COUNT; ++j) {
+        cbar[j] = 0.0;
+        for (int i = 0; i < MODE_COUNT; ++i) {
+            cbar[j] += m_switch[i][j] * mu[i];
+        }
+        for (int i = 0; i < MODE_COUNT; ++i) {
+            weight[i][j] = cbar[j] > 0.0 ? m_switch[i][j] * mu[i] / cbar[j] : 0.0;
+        }
+    }
+
+    double mixedX[MODE_COUNT][N];
+    double mixedP[MODE_COUNT][N * N];
+    for (int j = 0; j < MODE_COUNT; ++j) {
+        double* x0 = mixedX[j];
+        double* P0 = mixedP[j];
+        std::fill(x0, x0 + N, 0.0);
+        std::fill(P0, P0 + N * N, 0.0);
+
+        for (int i = 0; i < MODE_COUNT; ++i) {
+            const double* xi = modeState(slot, i);
+            for (int k = 0; k < N; ++k) {
+                x0[k] += weight[i][j] * xi[k];
+            }
+        }
+        for (int i = 0; i < MODE_COUNT; ++i) {
+            const double w = weight[i][j];
+            if (w == 0.0) continue;
+            const double* xi = modeState(slot, i);
+            const double* Pi = m_P.constData() + (slot * MODE_COUNT + i) * COV_SIZE;
+            double d[N];
+            for (int k = 0; k < N; ++k) {
+                d[k] = xi[k] - x0[k];
+            }
+            for (int r = 0; r < N; ++r) {
+                for (int c = 0; c < N; ++c) {
+                    P0[r * N + c] += w * (Pi[r * N + c] + d[r] * d[c]);
+                }
+            }
+        }
+    }
+
+    double F[COV_SIZE];
+    double Q[COV_SIZE];
+    for (int j = 0; j < MODE_COUNT; ++j) {
+        buildTransition(j, dt, F, Q);
+        multiplyVector(F, mixedX[j], modeState(slot, j));
+        propagateCovariance(F, mixedP[j], Q, modeCov(slot, j));
+        mu[j] = cbar[j];
+    }
+}
+
+void ImmFilterBank::predictAll(qint64 nowMs) {
+    const int slots = m_active.size();
+    for (int s = 0; s < slots; ++s) {
+        if (!m_active[s]) continue;
+        const qint64 elapsed = nowMs - m_timestampMs[s];
+        if (elapsed <= 0) continue;
+        mixAndPredict(s, elapsed / 1000.0);
+        m_timestampMs[s] = nowMs;
+    }
+}
+
+void ImmFilterBank::update(int slot, const EnuVector& measurement, qint64 timestampMs) {
+    if (!isActive(slot)) return;
+
+    const qint64 elapsed = timestampMs - m_timestampMs[slot];
+    if (elapsed > 0) {
+        mixAndPredict(slot, elapsed / 1000.0);
+        m_timestampMs[slot] = timestampMs;
+    }
+
+    const int H[3] = { si(AXIS_E, POS), si(AXIS_N, POS), si(AXIS_U, POS) };
+    const double z[3] = { measurement.east, measurement.north, measurement.up };
+    const double r = m_measurementSigmaM * m_measurementSigmaM;
+
+    double logLikelihood[MODE_COUNT];
+    bool valid[MODE_COUNT];
+
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        double* x = modeState(slot, mode);
+        double* P = modeCov(slot, mode);
+
+        double S[3][3];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                S[i][j] = P[H[i] * N + H[j]] + (i == j ? r : 0.0);
+            }
+        }
+        const double det =
+            S[0][0] * (S[1][1] * S[2][2] - S[1][2] * S[2][1]) -
+            S[0][1] * (S[1][0] * S[2][2] - S[1][2] * S[2][0]) +
+            S[0][2] * (S[1][0] * S[2][1] - S[1][1] * S[2][0]);
+        valid[mode] = det > 1e-12;
+        if (!valid[mode]) {
+            logLikelihood[mode] = 0.0;
+            continue;
+        }
+
+        const double inv = 1.0 / det;
+        double Si[3][3];
+        Si[0][0] =  (S[1][1] * S[2][2] - S[1][2] * S[2][1]) * inv;
+        Si[0][1] = -(S[0][1] * S[2][2] - S[0][2] * S[2][1]) * inv;
+        Si[0][2] =  (S[0][1] * S[1][2] - S[0][2] * S[1][1]) * inv;
+        Si[1][0] = -(S[1][0] * S[2][2] - S[1][2] * S[2][0]) * inv;
+        Si[1][1] =  (S[0][0] * S[2][2] - S[0][2] * S[2][0]) * inv;
+        Si[1][2] = -(S[0][0] * S[1][2] - S[0][2] * S[1][0]) * inv;
+        Si[2][0] =  (S[1][0] * S[2][1] - S[1][1] * S[2][0]) * inv;
+        Si[2][1] = -(S[0][0] * S[2][1] - S[0][1] * S[2][0]) * inv;
+        Si[2][2] =  (S[0][0] * S[1][1] - S[0][1] * S[1][0]) * inv;
+
+        double y[3];
+        for (int i = 0; i < 3; ++i) {
+            y[i] = z[i] - x[H[i]];
+        }
+
+        double mahalanobis = 0.0;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                mahalanobis += y[i] * Si[i][j] * y[j];
+            }
+        }
+        logLikelihood[mode] = -0.5 * (mahalanobis + std::log(det) + 3.0 * std::log(2.0 * M_PI));
+
+        double PHt[N][3];
+        double K[N][3];
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                PHt[i][j] = P[i * N + H[j]];
+            }
+        }
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                K[i][j] = PHt[i][0] * Si[0][j] + PHt[i][1] * Si[1][j] + PHt[i][2] * Si[2][j];
+            }
+        }
+        for (int i = 0; i < N; ++i) {
+            x[i] += K[i][0] * y[0] + K[i][1] * y[1] + K[i][2] * y[2];
+        }
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < N; ++j) {
+                P[i * N + j] -= K[i][0] * PHt[j][0] + K[i][1] * PHt[j][1] + K[i][2] * PHt[j][2];
+            }
+        }
+        for (int i = 0; i < N; ++i) {
+            for (int j = i + 1; j < N; ++j) {
+                double avg = 0.5 * (P[i * N + j] + P[j * N + i]);
+                P[i * N + j] = avg;
+                P[j * N + i] = avg;
+            }
+        }
+    }
+
+    // Mode probability update in log space to avoid underflow
+    double maxLog = -1e300;
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        if (valid[mode]) maxLog = std::max(maxLog, logLikelihood[mode]);
+    }
+
+    double* mu = m_mu.data() + slot * MODE_COUNT;
+    double posterior[MODE_COUNT];
+    double total = 0.0;
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        posterior[mode] = valid[mode] ? mu[mode] * std::exp(logLikelihood[mode] - maxLog) : 0.0;
+        total += posterior[mode];
+    }
+    if (total <= 0.0) return;  // Keep the predicted probabilities
+
+    double floored = 0.0;
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        posterior[mode] = std::max(posterior[mode] / total, MIN_MODE_PROBABILITY);
+        floored += posterior[mode];
+    }
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        mu[mode] = posterior[mode] / floored;
+    }
+}
+
+double ImmFilterBank::combined(int slot, int stateIndex) const {
+    double value = 0.0;
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        value += modeProbability(slot, mode) * modeState(slot, mode)[stateIndex];
+    }
+    return value;
+}
+
+EnuVector ImmFilterBank::position(int slot) const {
+    EnuVector v;
+    v.east = combined(slot, si(AXIS_E, POS));
+    v.north = combined(slot, si(AXIS_N, POS));
+    v.up = combined(slot, si(AXIS_U, POS));
+    return v;
+}
+
+EnuVector ImmFilterBank::velocity(int slot) const {
+    EnuVector v;
+    v.east = combined(slot, si(AXIS_E, VEL));
+    v.north = combined(slot, si(AXIS_N, VEL));
+    v.up = combined(slot, si(AXIS_U, VEL));
+    return v;
+}
+
+double ImmFilterBank::covariance(int slot, int row, int col) const {
+    const double meanRow = combined(slot, row);
+    const double meanCol = combined(slot, col);
+    double value = 0.0;
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        const double* x = modeState(slot, mode);
+        value += modeProbability(slot, mode) *
+                 (modeCov(slot, mode)[row * N + col] + (x[row] - meanRow) * (x[col] - meanCol));
+    }
+    return value;
+}
+
+EnuVector ImmFilterBank::predictedPosition(int slot, qint64 deltaMs) const {
+    const double dt = deltaMs / 1000.0;
+    double F[COV_SIZE];
+    double Q[COV_SIZE];
+    double x[N];
+
+    EnuVector predicted;
+    for (int mode = 0; mode < MODE_COUNT; ++mode) {
+        buildTransition(mode, dt, F, Q);
+        multiplyVector(F, modeState(slot, mode), x);
+        const double w = modeProbability(slot, mode);
+        predicted.east += w * x[si(AXIS_E, POS)];
+        predicted.north += w * x[si(AXIS_N, POS)];
+        predicted.up += w * x[si(AXIS_U, POS)];
+    }
+    return predicted;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,105 @@
+#ifndef IMMFILTERBANK_H
+#define IMMFILTERBANK_H
+
+#include <QVector>
+#include <QtGlobal>
+#include "utils/KalmanFilterBank.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Interacting Multiple Model filter bank
+ *
+ * Every slot runs four mode-matched Kalman filters over the same 9-state
+ * ENU layout as KalmanFilterBank ([e, ve, ae, n, vn, an, u, vu, au]):
+ * constant velocity, constant acceleration, and a coordinated turn at
+ * +/- the configured turn rate. Each cycle mixes the mode estimates
+ * through a Markov switching matrix, runs the mode filters and reweights
+ * the mode probabilities by measurement likelihood.
+ *
+ * The accessors mirror KalmanFilterBank so TrackManager can use either.
+ * Per-slot storage is contiguous; not thread-safe.
+ */
+class ImmFilterBank {
+public:
+    enum Mode {
+        ModeConstantVelocity = 0,
+        ModeConstantAcceleration,
+        ModeTurnLeft,
+        ModeTurnRight,
+        MODE_COUNT
+    };
+
+    static constexpr int STATE_DIM = KalmanFilterBank::STATE_DIM;
+    static constexpr int COV_SIZE = KalmanFilterBank::COV_SIZE;
+
+    ImmFilterBank();
+
+    // Configuration
+    void setTurnRate(double degPerSec);
+    void setSwitchProbability(double p);   // Chance of leaving a mode per cycle
+    void setProcessNoise(double accelPsd, double jerkPsd);
+    void setMeasurementNoise(double sigmaM) { m_measurementSigmaM = sigmaM; }
+
+    // Slot management
+    void initialize(int slot, const EnuVector& position, qint64 timestampMs);
+    void release(int slot);
+    void clear();
+    bool isActive(int slot) const { return slot >= 0 && slot < m_active.size() && m_active[slot]; }
+    int capacity() const { return m_active.size(); }
+
+    // Coast every active slot to nowMs (mixing + mode prediction)
+    void predictAll(qint64 nowMs);
+
+    // Full IMM cycle with a position measurement
+    void update(int slot, const EnuVector& measurement, qint64 timestampMs);
+
+    // Combined (probability-weighted) estimate
+    EnuVector position(int slot) const;
+    EnuVector velocity(int slot) const;
+    EnuVector predictedPosition(int slot, qint64 deltaMs) const;
+    // Of the combined estimate: mode covariances plus the spread of the means
+    double covariance(int slot, int row, int col) const;
+    qint64 timestampMs(int slot) const { return m_timestampMs[slot]; }
+
+    double modeProbability(int slot, int mode) const { return m_mu[slot * MODE_COUNT + mode]; }
+
+    // Raw slot contents, for checkpoints; restoring activates the slot
+    struct SlotState {
+        double state[MODE_COUNT][STATE_DIM];
+        double cov[MODE_COUNT][COV_SIZE];
+        double probability[MODE_COUNT];
+        qint64 timestampMs = 0;
+    };
+    SlotState slotState(int slot) const;
+    void restoreSlot(int slot, const SlotState& state);
+
+private:
+    void ensureCapacity(int slot);
+    void mixAndPredict(int slot, double dt);
+    void buildTransition(int mode, double dt, double* F, double* Q) const;
+    double combined(int slot, int stateIndex) const;
+
+    double* modeState(int slot, int mode) { return m_x.data() + (slot * MODE_COUNT + mode) * STATE_DIM; }
+    const double* modeState(int slot, int mode) const { return m_x.constData() + (slot * MODE_COUNT + mode) * STATE_DIM; }
+    double* modeCov(int slot, int mode) { return m_P.data() + (slot * MODE_COUNT + mode) * COV_SIZE; }
+    const double* modeCov(int slot, int mode) const { return m_P.constData() + (slot * MODE_COUNT + mode) * COV_SIZE; }
+
+    QVector<double> m_x;          // MODE_COUNT * STATE_DIM per slot
+    QVector<double> m_P;          // MODE_COUNT * COV_SIZE per slot
+    QVector<double> m_mu;         // MODE_COUNT per slot
+    QVector<qint64> m_timestampMs;
+    QVector<quint8> m_active;
+
+    double m_switch[MODE_COUNT][MODE_COUNT];
+    double m_turnRateRadPerSec;
+    double m_accelPsd = 1.0;
+    double m_jerkPsd = 0.5;
+    double m_measurementSigmaM = 10.0;
+    double m_initialVelocitySigma = 50.0;
+    double m_initialAccelerationSigma = 10.0;
+};
+
+} // namespace CounterUAS
+
+#endif // IMMFILTERBANK_H
@@ -0,0 +1,174 @@
+#ifndef INTERVALTREE_H
+#define INTERVALTREE_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <algorithm>
+#include <utility>
+
+namespace CounterUAS {
+
+/**
+ * @brief Closed intervals [lo, hi] with overlap queries
+ *
+ * A treap ordered by lower bound, each node carrying the largest upper
+ * bound in its subtree, so a query skips every subtree that ends before
+ * it and everything right of the first node that starts after it: insert
+ * and remove are O(log n) expected, a query O(log n + matches). Nodes live
+ * in one vector and are recycled through a free list; a handle stays
+ * valid until its interval is removed. Not thread-safe.
+ */
+template<typename T>
+class IntervalTree {
+public:
+    using Handle = int;                 // -1 is never a valid handle
+
+    Handle insert(double lo, double hi, const T& value) {
+        Handle h;
+        if (!m_free.isEmpty()) {
+            h = m_free.takeLast();
+        } else {
+            h = m_nodes.size();
+            m_nodes.append(Node());
+        }
+        Node& n = m_nodes[h];
+        n.lo = std::min(lo, hi);
+        n.hi = std::max(lo, hi);
+        n.maxHi = n.hi;
+        n.priority = nextPriority();
+        n.left = n.right = -1;
+        n.value = value;
+        n.used = true;
+
+        Handle left, right;
+        split(m_root, n.lo, h, left, right);
+        m_root = merge(merge(left, h), right);
+        m_size++;
+        return h;
+    }
+
+    bool remove(Handle h) {
+        if (!contains(h)) return false;
+        Handle left, middle, right;
+        split(m_root, m_nodes[h].lo, h, left, right);
+        split(right, m_nodes[h].lo, h + 1, middle, right);    // middle is h alone
+        m_root = merge(left, right);
+
+        m_nodes[h].used = false;
+        m_nodes[h].value = T();
+        m_free.append(h);
+        m_size--;
+        return true;
+    }
+
+    bool contains(Handle h) const { return h >= 0 && h < m_nodes.size() && m_nodes[h].used; }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    void clear() {
+        m_nodes.clear();
+        m_free.clear();
+        m_root = -1;
+        m_size = 0;
+    }
+
+    double lo(Handle h) const { return m_nodes[h].lo; }
+    double hi(Handle h) const { return m_nodes[h].hi; }
+    const T& value(Handle h) const { return m_nodes[h].value; }
+    T& value(Handle h) { return m_nodes[h].value; }
+
+    // f(handle, value) for every interval meeting [lo, hi], by lower bound
+    template<typename F>
+    void forEachOverlapping(double lo, double hi, F&& f) const {
+        visit(m_root, lo, hi, f);
+    }
+
+    QVector<Handle> overlapping(double lo, double hi) const {
+        QVector<Handle> out;
+        forEachOverlapping(lo, hi, [&out](Handle h, const T&) { out.append(h); });
+        return out;
+    }
+
+private:
+    struct Node {
+        double lo = 0.0;
+        double hi = 0.0;
+        double maxHi = 0.0;
+        quint32 priority = 0;
+        Handle left = -1;
+        Handle right = -1;
+        T value = T();
+        bool used = false;
+    };
+
+    quint32 nextPriority() {
+        // xorshift32; only needs to be unpredictable against the input order
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    // Key order: (lo, handle)
+    bool before(Handle h, double lo, Handle key) const {
+        const Node& n = m_nodes[h];
+        return n.lo < lo || (n.lo == lo && h < key);
+    }
+
+    void update(Handle h) {
+        Node& n = m_nodes[h];
+        n.maxHi = n.hi;
+        if (n.left >= 0) n.maxHi = std::max(n.maxHi, m_nodes[n.left].maxHi);
+        if (n.right >= 0) n.maxHi = std::max(n.maxHi, m_nodes[n.right].maxHi);
+    }
+
+    // left gets keys before (lo, key), right the rest
+    void split(Handle h, double lo, Handle key, Handle& left, Handle& right) {
+        if (h < 0) {
+            left = right = -1;
+            return;
+        }
+        if (before(h, lo, key)) {
+            split(m_nodes[h].right, lo, key, m_nodes[h].right, right);
+            left = h;
+        } else {
+            split(m_nodes[h].left, lo, key, left, m_nodes[h].left);
+            right = h;
+        }
+        update(h);
+    }
+
+    Handle merge(Handle left, Handle right) {
+        if (left < 0) return right;
+        if (right < 0) return left;
+        if (m_nodes[left].priority > m_nodes[right].priority) {
+            m_nodes[left].right = merge(m_nodes[left].right, right);
+            update(left);
+            return left;
+        }
+        m_nodes[right].left = merge(left, m_nodes[right].left);
+        update(right);
+        return right;
+    }
+
+    template<typename F>
+    void visit(Handle h, double lo, double hi, F& f) const {
+        if (h < 0) return;
+        const Node& n = m_nodes[h];
+        if (n.maxHi < lo) return;
+        visit(n.left, lo, hi, f);
+        if (n.lo > hi) return;          // So does everything to the right
+        if (n.hi >= lo) f(h, n.value);
+        visit(n.right, lo, hi, f);
+    }
+
+    QVector<Node> m_nodes;
+    QVector<Handle> m_free;
+    Handle m_root = -1;
+    int m_size = 0;
+    quint32 m_seed = 2463534242u;
+};
+
+} // namespace CounterUAS
+
+#endif // INTERVALTREE_H
@@ -0,0 +1,493 @@
+#include "utils/JsonReader.h"
+#include <QtAlgorithms>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define JSON_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+inline bool isSpecial(uchar c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+// First quote, backslash or control byte at or after p; end if none
+const char* findSpecial(const char* p, const char* end) {
+#if defined(JSON_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                         _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        const uint mask = static_cast<uint>(_mm_movemask_epi8(hit));
+        if (mask != 0) return p + qCountTrailingZeroBits(mask);
+        p += 16;
+    }
+#elif defined(JSON_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x1f);
+    while (end - p >= 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        const uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)), vcleq_u8(v, control));
+        // A nibble per byte: the narrowing shift packs the 16 lanes into 64 bits
+        const quint64 bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (bits != 0) return p + (qCountTrailingZeroBits(bits) >> 2);
+        p += 16;
+    }
+#endif
+    while (p < end && !isSpecial(static_cast<uchar>(*p))) ++p;
+    return p;
+}
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Four hex digits at p, or -1
+int hexUnit(const char* p) {
+    int unit = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int digit = hexValue(p[i]);
+        if (digit < 0) return -1;
+        unit = (unit << 4) | digit;
+    }
+    return unit;
+}
+
+void appendUtf8(QByteArray& out, uint code) {
+    if (code < 0x80) {
+        out.append(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out.append(static_cast<char>(0xc0 | (code >> 6)));
+        out.append(static_cast<char>(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+        out.append(static_cast<char>(0xe0 | (code >> 12)));
+        out.append(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.append(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+        out.append(static_cast<char>(0xf0 | (code >> 18)));
+        out.append(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+        out.append(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+        out.append(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+}
+
+} // namespace
+
+JsonReader::JsonReader(const char* data, int size)
+    : m_begin(data)
+    , m_pos(data)
+    , m_end(data + size)
+{
+}
+
+JsonReader::JsonReader(const QByteArray& data)
+    : JsonReader(data.constData(), static_cast<int>(data.size()))
+{
+}
+
+bool JsonReader::fail() {
+    m_ok = false;
+    return false;
+}
+
+void JsonReader::skipSpace() {
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) ++m_pos;
+}
+
+bool JsonReader::atEnd() {
+    skipSpace();
+    return m_ok && m_pos == m_end;
+}
+
+JsonReader::Type JsonReader::peek() {
+    skipSpace();
+    if (!m_ok || m_pos == m_end) return Type::Invalid;
+    switch (*m_pos) {
+    case 'n': return Type::Null;
+    case 't':
+    case 'f': return Type::Bool;
+    case '"': return Type::String;
+    case '[': return Type::Array;
+    case '{': return Type::Object;
+    default:
+        return *m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9') ? Type::Number : Type::Invalid;
+    }
+}
+
+bool JsonReader::beginObject() {
+    if (peek() != Type::Object || m_depth == MAX_DEPTH) return fail();
+    ++m_pos;
+    m_first |= quint64(1) << m_depth++;
+    return true;
+}
+
+bool JsonReader::beginArray() {
+    if (peek() != Type::Array || m_depth == MAX_DEPTH) return fail();
+    ++m_pos;
+    m_first |= quint64(1) << m_depth++;
+    return true;
+}
+
+bool JsonReader::nextMember(char close) {
+    skipSpace();
+    if (!m_ok || m_depth == 0 || m_pos == m_end) return fail();
+
+    const quint64 bit = quint64(1) << (m_depth - 1);
+    if (*m_pos == close) {
+        ++m_pos;
+        --m_depth;
+        m_first &= ~bit;
+        return false;
+    }
+    if (m_first & bit) {
+        m_first &= ~bit;
+        return true;
+    }
+    if (*m_pos != ',') return fail();
+    ++m_pos;
+    return true;
+}
+
+bool JsonReader::nextKey() {
+    if (!nextMember('}')) return false;
+
+    skipSpace();
+    const char* start;
+    const char* end;
+    bool escaped;
+    if (!scanString(start, end, escaped)) return false;
+    if (escaped) {
+        if (!unescape(start, end, m_keyScratch)) return false;
+        m_key = m_keyScratch.constData();
+        m_keySize = static_cast<int>(m_keyScratch.size());
+    } else {
+        m_key = start;
+        m_keySize = static_cast<int>(end - start);
+    }
+
+    skipSpace();
+    if (m_pos == m_end || *m_pos != ':') return fail();
+    ++m_pos;
+    return true;
+}
+
+bool JsonReader::keyIs(const char* name) const {
+    const size_t size = std::strlen(name);
+    return size == static_cast<size_t>(m_keySize) && std::memcmp(m_key, name, size) == 0;
+}
+
+bool JsonReader::nextElement() {
+    return nextMember(']');
+}
+
+bool JsonReader::scanString(const char*& start, const char*& end, bool& escaped) {
+    if (m_pos == m_end || *m_pos != '"') return fail();
+    start = ++m_pos;
+    escaped = false;
+
+    for (;;) {
+        m_pos = findSpecial(m_pos, m_end);
+        if (m_pos == m_end) return fail();     // Unterminated
+        const char c = *m_pos;
+        if (c == '"') break;
+        if (c != '\\') return fail();          // Raw control character
+
+        // An escape: checked here, so skipped strings are held to it too
+        escaped = true;
+        if (m_end - m_pos < 2) return fail();
+        switch (m_pos[1]) {
+        case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+            m_pos += 2;
+            break;
+        case 'u':
+            if (m_end - m_pos < 6 || hexUnit(m_pos + 2) < 0) return fail();
+            m_pos += 6;
+            break;
+        default:
+            return fail();
+        }
+    }
+    end = m_pos++;
+    return true;
+}
+
+bool JsonReader::unescape(const char* start, const char* end, QByteArray& out) {
+    out.resize(0);
+    out.reserve(static_cast<int>(end - start));
+    const char* p = start;
+    while (p < end) {
+        const char* run = p;
+        while (p < end && *p != '\\') ++p;
+        out.append(run, static_cast<int>(p - run));
+        if (p == end) break;
+
+        const char code = p[1];
+        p += 2;
+        switch (code) {
+        case 'b': out.append('\b'); break;
+        case 'f': out.append('\f'); break;
+        case 'n': out.append('\n'); break;
+        case 'r': out.append('\r'); break;
+        case 't': out.append('\t'); break;
+        case 'u': {
+            uint unit = static_cast<uint>(hexUnit(p));
+            p += 4;
+            if (QChar::isHighSurrogate(unit) && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                const int low = hexUnit(p + 2);
+                if (low >= 0 && QChar::isLowSurrogate(static_cast<uint>(low))) {
+                    unit = QChar::surrogateToUcs4(static_cast<ushort>(unit), static_cast<ushort>(low));
+                    p += 6;
+                }
+            }
+            appendUtf8(out, QChar::isSurrogate(unit) ? 0xfffd : unit);   // Unpaired: replacement character
+            break;
+        }
+        default:
+            out.append(code);   // " \ and /
+            break;
+        }
+    }
+    return true;
+}
+
+bool JsonReader::scanNumber(const char*& start, bool& integer) {
+    start = m_pos;
+    const char* p = m_pos;
+    if (p < m_end && *p == '-') ++p;
+    if (p == m_end) return fail();
+    if (*p == '0') {
+        ++p;
+    } else if (*p >= '1' && *p <= '9') {
+        while (p < m_end && *p >= '0' && *p <= '9') ++p;
+    } else {
+        return fail();
+    }
+
+    integer = true;
+    if (p < m_end && *p == '.') {
+        integer = false;
+        const char* digits = ++p;
+        while (p < m_end && *p >= '0' && *p <= '9') ++p;
+        if (p == digits) return fail();
+    }
+    if (p < m_end && (*p == 'e' || *p == 'E')) {
+        integer = false;
+        ++p;
+        if (p < m_end && (*p == '+' || *p == '-')) ++p;
+        const char* digits = p;
+        while (p < m_end && *p >= '0' && *p <= '9') ++p;
+        if (p == digits) return fail();
+    }
+    m_pos = p;
+    return true;
+}
+
+bool JsonReader::readNull() {
+    skipSpace();
+    if (!m_ok || m_end - m_pos < 4 || std::memcmp(m_pos, "null", 4) != 0) return fail();
+    m_pos += 4;
+    return true;
+}
+
+bool JsonReader::readBool(bool& value) {
+    skipSpace();
+    if (!m_ok) return false;
+    if (m_end - m_pos >= 4 && std::memcmp(m_pos, "true", 4) == 0) {
+        value = true;
+        m_pos += 4;
+        return true;
+    }
+    if (m_end - m_pos >= 5 && std::memcmp(m_pos, "false", 5) == 0) {
+        value = false;
+        m_pos += 5;
+        return true;
+    }
+    return fail();
+}
+
+bool JsonReader::readDouble(double& value) {
+    if (peek() != Type::Number) return fail();
+    const char* start;
+    bool integer;
+    if (!scanNumber(start, integer)) return false;
+
+    // Integers of up to 15 digits are exact in a double: no conversion call
+    const bool negative = *start == '-';
+    const char* digits = start + (negative ? 1 : 0);
+    if (integer && m_pos - digits <= 15) {
+        qint64 number = 0;
+        for (const char* p = digits; p < m_pos; ++p) number = number * 10 + (*p - '0');
+        value = static_cast<double>(negative ? -number : number);
+        return true;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const std::from_chars_result parsed = std::from_chars(start, m_pos, value);
+    if (parsed.ec != std::errc() || parsed.ptr != m_pos) return fail();   // Out of a double's range
+#else
+    bool converted = false;
+    value = QByteArray::fromRawData(start, static_cast<int>(m_pos - start)).toDouble(&converted);
+    if (!converted) return fail();
+#endif
+    return true;
+}
+
+bool JsonReader::readString(QString& value) {
+    skipSpace();
+    if (!m_ok) return false;
+    const char* start;
+    const char* end;
+    bool escaped;
+    if (!scanString(start, end, escaped)) return false;
+    if (!escaped) {
+        value = QString::fromUtf8(start, static_cast<int>(end - start));
+        return true;
+    }
+    if (!unescape(start, end, m_scratch)) return false;
+    value = QString::fromUtf8(m_scratch);
+    return true;
+}
+
+bool JsonReader::readVariant(QVariant& value) {
+    switch (peek()) {
+    case Type::Null:
+        if (!readNull()) return false;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        value = QVariant::fromValue(nullptr);
+#else
+        value = QVariant();
+#endif
+        return true;
+    case Type::Bool: {
+        bool flag = false;
+        if (!readBool(flag)) return false;
+        value = flag;
+        return true;
+    }
+    case Type::Number: {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        // Qt 6 keeps integers that fit a qint64 as integers
+        const char* rewind = m_pos;
+        const char* start;
+        bool integer;
+        if (!scanNumber(start, integer)) return false;
+        if (integer) {
+            const bool negative = *start == '-';
+            const quint64 limit = negative ? quint64(std::numeric_limits<qint64>::max()) + 1
+                                           : quint64(std::numeric_limits<qint64>::max());
+            quint64 number = 0;
+            bool fits = true;
+            for (const char* p = start + (negative ? 1 : 0); p < m_pos && fits; ++p) {
+                const quint64 digit = static_cast<quint64>(*p - '0');
+                fits = number <= (limit - digit) / 10;
+                number = number * 10 + digit;
+            }
+            if (fits) {
+                value = negative ? static_cast<qlonglong>(0 - number) : static_cast<qlonglong>(number);
+                return true;
+            }
+        }
+        m_pos = rewind;
+#endif
+        double number = 0.0;
+        if (!readDouble(number)) return false;
+        value = number;
+        return true;
+    }
+    case Type::String: {
+        QString text;
+        if (!readString(text)) return false;
+        value = text;
+        return true;
+    }
+    case Type::Array: {
+        QVariantList list;
+        if (!readVariantList(list)) return false;
+        value = list;
+        return true;
+    }
+    case Type::Object: {
+        QVariantMap map;
+        if (!readVariantMap(map)) return false;
+        value = map;
+        return true;
+    }
+    default:
+        return fail();
+    }
+}
+
+bool JsonReader::readVariantMap(QVariantMap& map) {
+    if (!beginObject()) return false;
+    while (nextKey()) {
+        const QString name = key();     // Before a nested object's keys replace it
+        QVariant item;
+        if (!readVariant(item)) return false;
+        map.insert(name, item);
+    }
+    return m_ok;
+}
+
+bool JsonReader::readVariantList(QVariantList& list) {
+    if (!beginArray()) return false;
+    while (nextElement()) {
+        QVariant item;
+        if (!readVariant(item)) return false;
+        list.append(item);
+    }
+    return m_ok;
+}
+
+bool JsonReader::skipValue() {
+    switch (peek()) {
+    case Type::Null:
+        return readNull();
+    case Type::Bool: {
+        bool flag;
+        return readBool(flag);
+    }
+    case Type::Number: {
+        const char* start;
+        bool integer;
+        return scanNumber(start, integer);
+    }
+    case Type::String: {
+        const char* start;
+        const char* end;
+        bool escaped;
+        return scanString(start, end, escaped);
+    }
+    case Type::Array:
+        if (!beginArray()) return false;
+        while (nextElement()) {
+            if (!skipValue()) return false;
+        }
+        return m_ok;
+    case Type::Object:
+        if (!beginObject()) return false;
+        while (nextKey()) {
+            if (!skipValue()) return false;
+        }
+        return m_ok;
+    default:
+        return fail();
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,87 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Pull parser for inbound JSON, with no QJsonDocument in between
+ *
+ * The caller walks the document as it expects it: beginObject(), then
+ * nextKey() and one read or skipValue() per member until nextKey() returns
+ * false, and the same with beginArray() and nextElement(). Values are
+ * decoded straight from the input, which must outlive the reader; keys are
+ * compared as the raw UTF-8 between their quotes unless they hold escapes.
+ * Strings are scanned 16 bytes a step with SSE2 or NEON for the quote,
+ * backslash or control byte that ends a plain run.
+ *
+ * The grammar is RFC 8259's, held to strictly; nesting is limited to
+ * MAX_DEPTH. Any error, or a value of another type than the
+ * read asked for, stops the reader: ok() turns false and every later call
+ * fails. readVariant() gives what QJsonValue::toVariant gives.
+ */
+class JsonReader {
+public:
+    static constexpr int MAX_DEPTH = 64;
+
+    enum class Type : quint8 { Invalid, Null, Bool, Number, String, Array, Object };
+
+    JsonReader(const char* data, int size);
+    explicit JsonReader(const QByteArray& data);
+
+    bool ok() const { return m_ok; }
+    // Only whitespace is left
+    bool atEnd();
+    int offset() const { return static_cast<int>(m_pos - m_begin); }
+
+    // Of the next value, without reading it
+    Type peek();
+
+    bool beginObject();
+    // Positions on the next member's value; false at the end of the object
+    bool nextKey();
+    bool keyIs(const char* name) const;
+    QString key() const { return QString::fromUtf8(m_key, m_keySize); }
+
+    bool beginArray();
+    // Positions on the next element; false at the end of the array
+    bool nextElement();
+
+    bool readNull();
+    bool readBool(bool& value);
+    bool readDouble(double& value);
+    bool readString(QString& value);
+    bool readVariant(QVariant& value);
+    bool readVariantMap(QVariantMap& map);
+    bool skipValue();
+
+private:
+    bool fail();
+    void skipSpace();
+    bool nextMember(char close);
+    bool scanString(const char*& start, const char*& end, bool& escaped);
+    bool unescape(const char* start, const char* end, QByteArray& out);
+    bool scanNumber(const char*& start, bool& integer);
+    bool readVariantList(QVariantList& list);
+
+    const char* m_begin;
+    const char* m_pos;
+    const char* m_end;
+    bool m_ok = true;
+
+    int m_depth = 0;
+    quint64 m_first = 0;        // Per depth: nothing read yet at that level
+
+    const char* m_key = nullptr;
+    int m_keySize = 0;
+    QByteArray m_keyScratch;    // An escaped key, decoded
+    QByteArray m_scratch;
+};
+
+} // namespace CounterUAS
+
+#endif // JSONREADER_H
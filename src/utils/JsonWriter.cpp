@@ -0,0 +1,318 @@
+#include "utils/JsonWriter.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QLocale>
+#include <QStringList>
+#include <charconv>
+#include <cmath>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+} // namespace
+
+JsonWriter::JsonWriter()
+    : m_out(&m_own)
+{
+}
+
+JsonWriter::JsonWriter(QByteArray* out)
+    : m_out(out)
+{
+}
+
+void JsonWriter::clear() {
+    m_out->resize(0);   // Unlike clear(), keeps the allocation
+    m_comma = false;
+}
+
+inline void JsonWriter::separate() {
+    if (m_comma) m_out->append(',');
+}
+
+void JsonWriter::beginObject() {
+    separate();
+    m_out->append('{');
+    m_comma = false;
+}
+
+void JsonWriter::endObject() {
+    m_out->append('}');
+    m_comma = true;
+}
+
+void JsonWriter::beginArray() {
+    separate();
+    m_out->append('[');
+    m_comma = false;
+}
+
+void JsonWriter::endArray() {
+    m_out->append(']');
+    m_comma = true;
+}
+
+void JsonWriter::key(const char* name) {
+    separate();
+    m_out->append('"');
+    m_out->append(name);
+    m_out->append("\":", 2);
+    m_comma = false;
+}
+
+void JsonWriter::key(const QString& name) {
+    separate();
+    appendEscaped(name.constData(), static_cast<int>(name.size()));
+    m_out->append(':');
+    m_comma = false;
+}
+
+void JsonWriter::writeNull() {
+    separate();
+    m_out->append("null", 4);
+    m_comma = true;
+}
+
+void JsonWriter::writeBool(bool value) {
+    separate();
+    if (value) m_out->append("true", 4);
+    else m_out->append("false", 5);
+    m_comma = true;
+}
+
+void JsonWriter::writeInt(qint64 value) {
+    separate();
+    char digits[24];
+    const std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), value);
+    m_out->append(digits, static_cast<int>(end.ptr - digits));
+    m_comma = true;
+}
+
+void JsonWriter::writeDouble(double value) {
+    if (!std::isfinite(value)) {
+        writeNull();   // JSON has no NaN or infinity; QJsonDocument writes null too
+        return;
+    }
+    separate();
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    char digits[32];
+    const std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), value);
+    m_out->append(digits, static_cast<int>(end.ptr - digits));
+#else
+    m_out->append(QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+#endif
+    m_comma = true;
+}
+
+void JsonWriter::writeString(const QString& value) {
+    separate();
+    appendEscaped(value.constData(), static_cast<int>(value.size()));
+    m_comma = true;
+}
+
+void JsonWriter::appendEscaped(const QChar* text, int size) {
+    // Sized for the worst case, a \u00XX escape per unit, and cut back after
+    const int start = m_out->size();
+    m_out->resize(start + 2 + size * 6);
+    char* const base = m_out->data();
+    char* p = base + start;
+    *p++ = '"';
+
+    const ushort* unit = reinterpret_cast<const ushort*>(text);
+    const ushort* const end = unit + size;
+    while (unit < end) {
+        const uint c = *unit++;
+        if (c < 0x80) {
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                *p++ = static_cast<char>(c);
+                continue;
+            }
+            *p++ = '\\';
+            switch (c) {
+            case '"': *p++ = '"'; break;
+            case '\\': *p++ = '\\'; break;
+            case '\b': *p++ = 'b'; break;
+            case '\f': *p++ = 'f'; break;
+            case '\n': *p++ = 'n'; break;
+            case '\r': *p++ = 'r'; break;
+            case '\t': *p++ = 't'; break;
+            default:
+                *p++ = 'u';
+                *p++ = '0';
+                *p++ = '0';
+                *p++ = HEX_DIGITS[c >> 4];
+                *p++ = HEX_DIGITS[c & 0xf];
+                break;
+            }
+        } else if (c < 0x800) {
+            *p++ = static_cast<char>(0xc0 | (c >> 6));
+            *p++ = static_cast<char>(0x80 | (c & 0x3f));
+        } else if (QChar::isHighSurrogate(c) && unit < end && QChar::isLowSurrogate(*unit)) {
+            const uint code = QChar::surrogateToUcs4(static_cast<ushort>(c), *unit++);
+            *p++ = static_cast<char>(0xf0 | (code >> 18));
+            *p++ = static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            *p++ = static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            *p++ = static_cast<char>(0x80 | (code & 0x3f));
+        } else {
+            const uint code = QChar::isSurrogate(c) ? 0xfffd : c;   // Unpaired: replacement character
+            *p++ = static_cast<char>(0xe0 | (code >> 12));
+            *p++ = static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            *p++ = static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+    *p++ = '"';
+    m_out->resize(static_cast<int>(p - base));
+}
+
+void JsonWriter::writeDateTime(const QDateTime& value) {
+    if (!value.isValid()) {
+        separate();
+        m_out->append("\"\"", 2);
+        m_comma = true;
+    } else if (value.timeSpec() == Qt::LocalTime || value.timeSpec() == Qt::UTC) {
+        writeDateTime(value.toMSecsSinceEpoch(), value.timeSpec());
+    } else {
+        writeString(value.toString(Qt::ISODateWithMs));   // Offset suffixes vary; not cached
+    }
+}
+
+void JsonWriter::writeDateTime(qint64 msecsSinceEpoch, Qt::TimeSpec spec) {
+    separate();
+    appendDate(msecsSinceEpoch, spec);
+    m_comma = true;
+}
+
+void JsonWriter::appendDate(qint64 msecsSinceEpoch, Qt::TimeSpec spec) {
+    qint64 second = msecsSinceEpoch / 1000;
+    if (msecsSinceEpoch % 1000 < 0) --second;
+    const int millis = static_cast<int>(msecsSinceEpoch - second * 1000);
+
+    if (m_cachedMsPos < 0 || second != m_cachedSecond || spec != m_cachedSpec) {
+        // A local time's offset is whole seconds, so the rest of its text
+        // holds for the whole second
+        m_cachedDate = QDateTime::fromMSecsSinceEpoch(second * 1000, spec).toString(Qt::ISODateWithMs).toLatin1();
+        m_cachedMsPos = m_cachedDate.lastIndexOf('.') + 1;
+        m_cachedSecond = second;
+        m_cachedSpec = spec;
+        if (m_cachedMsPos <= 0 || m_cachedMsPos + 3 > m_cachedDate.size()) {
+            m_cachedMsPos = -1;  // Out of QDateTime's range: format it whole
+            m_out->append('"');
+            m_out->append(QDateTime::fromMSecsSinceEpoch(msecsSinceEpoch, spec).toString(Qt::ISODateWithMs).toLatin1());
+            m_out->append('"');
+            return;
+        }
+    }
+
+    const char* text = m_cachedDate.constData();
+    m_out->append('"');
+    m_out->append(text, m_cachedMsPos);
+    const char ms[3] = {static_cast<char>('0' + millis / 100), static_cast<char>('0' + millis / 10 % 10),
+                        static_cast<char>('0' + millis % 10)};
+    m_out->append(ms, 3);
+    m_out->append(text + m_cachedMsPos + 3, m_cachedDate.size() - m_cachedMsPos - 3);
+    m_out->append('"');
+}
+
+void JsonWriter::writeVariant(const QVariant& value) {
+    switch (value.userType()) {
+    case QMetaType::UnknownType:
+        writeNull();
+        break;
+    case QMetaType::Bool:
+        writeBool(value.toBool());
+        break;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+        writeInt(value.toLongLong());
+        break;
+    case QMetaType::ULongLong: {
+        const qulonglong number = value.toULongLong();
+        if (number <= static_cast<qulonglong>(std::numeric_limits<qint64>::max())) {
+            writeInt(static_cast<qint64>(number));
+        } else {
+            writeDouble(static_cast<double>(number));
+        }
+        break;
+    }
+    case QMetaType::Double:
+    case QMetaType::Float:
+        writeDouble(value.toDouble());
+        break;
+    case QMetaType::QString:
+        writeString(*static_cast<const QString*>(value.constData()));
+        break;
+    case QMetaType::QVariantMap:
+        writeVariantMap(*static_cast<const QVariantMap*>(value.constData()));
+        break;
+    case QMetaType::QVariantList: {
+        const QVariantList& list = *static_cast<const QVariantList*>(value.constData());
+        beginArray();
+        for (const QVariant& item : list) writeVariant(item);
+        endArray();
+        break;
+    }
+    case QMetaType::QStringList: {
+        const QStringList& list = *static_cast<const QStringList*>(value.constData());
+        beginArray();
+        for (const QString& item : list) writeString(item);
+        endArray();
+        break;
+    }
+    default:
+        // Byte arrays, hashes, URLs and the rest: as Qt converts them
+        writeJsonValue(QJsonValue::fromVariant(value));
+        break;
+    }
+}
+
+void JsonWriter::writeVariantMap(const QVariantMap& map) {
+    beginObject();
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        key(it.key());
+        writeVariant(it.value());
+    }
+    endObject();
+}
+
+void JsonWriter::writeJsonValue(const QJsonValue& value) {
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        writeBool(value.toBool());
+        break;
+    case QJsonValue::Double:
+        writeDouble(value.toDouble());
+        break;
+    case QJsonValue::String:
+        writeString(value.toString());
+        break;
+    case QJsonValue::Array: {
+        const QJsonArray array = value.toArray();
+        beginArray();
+        for (const QJsonValue& item : array) writeJsonValue(item);
+        endArray();
+        break;
+    }
+    case QJsonValue::Object: {
+        const QJsonObject object = value.toObject();
+        beginObject();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            key(it.key());
+            writeJsonValue(it.value());
+        }
+        endObject();
+        break;
+    }
+    default:
+        writeNull();
+        break;
+    }
+}
+
+} // namespace CounterUAS
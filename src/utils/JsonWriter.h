@@ -0,0 +1,84 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+#include <QtGlobal>
+
+class QDateTime;
+class QJsonValue;
+
+namespace CounterUAS {
+
+/**
+ * @brief Streaming compact JSON writer into a reusable buffer
+ *
+ * Appends the document as it is described, with no QJsonObject tree in
+ * between: each value is formatted straight into the buffer, which keeps
+ * its capacity across clear(), so a writer kept per exporter allocates only
+ * while its buffer grows. The output parses to the same QJsonDocument a
+ * toJson() tree gives; key order is the writer's rather than sorted.
+ *
+ * Commas and colons are the writer's; the caller puts a key() before each
+ * value inside an object and balances begin/end. Doubles are written in
+ * their shortest round-trip form and non-finite ones as null, as
+ * QJsonDocument does. Dates are ISO 8601 with milliseconds, as
+ * QDateTime::toString(Qt::ISODateWithMs) gives them; for local and UTC
+ * times the formatted second is cached, so a burst of records from the same
+ * second formats only its milliseconds. Not thread-safe.
+ */
+class JsonWriter {
+public:
+    JsonWriter();
+    // Appends to out, which must outlive the writer
+    explicit JsonWriter(QByteArray* out);
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    // Empties the buffer, keeping its capacity
+    void clear();
+    const QByteArray& buffer() const { return *m_out; }
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    // name is written as it is: ASCII that needs no escaping
+    void key(const char* name);
+    void key(const QString& name);
+
+    void writeNull();
+    void writeBool(bool value);
+    void writeInt(qint64 value);
+    void writeDouble(double value);
+    void writeString(const QString& value);
+    // "" when invalid, as QDateTime::toString gives
+    void writeDateTime(const QDateTime& value);
+    // Of msecs since the epoch, in local time or UTC; the cache's fast path
+    void writeDateTime(qint64 msecsSinceEpoch, Qt::TimeSpec spec = Qt::LocalTime);
+    // As QJsonValue::fromVariant would have it
+    void writeVariant(const QVariant& value);
+    void writeVariantMap(const QVariantMap& map);
+    void writeJsonValue(const QJsonValue& value);
+
+private:
+    void separate();
+    void appendEscaped(const QChar* text, int size);
+    void appendDate(qint64 msecsSinceEpoch, Qt::TimeSpec spec);
+
+    QByteArray m_own;
+    QByteArray* m_out;
+    bool m_comma = false;       // A value or a close came last at this level
+
+    qint64 m_cachedSecond = 0;
+    Qt::TimeSpec m_cachedSpec = Qt::LocalTime;
+    QByteArray m_cachedDate;    // Formatted, with ".000" at m_cachedMsPos
+    int m_cachedMsPos = -1;
+};
+
+} // namespace CounterUAS
+
+#endif // JSONWRITER_H
@@ -0,0 +1,440 @@
+#include "utils/KalmanFilterBank.h"
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+// Per-axis index of position / velocity / acceleration in the state vector
+constexpr int POS = 0;
+constexpr int VEL = 1;
+constexpr int ACC = 2;
+constexpr int AXES = 3;
+
+inline int stateIndex(int axis, int deriv) { return axis * 3 + deriv; }
+
+} // namespace
+
+void KalmanFilterBank::setProcessNoise(MotionModel model, double spectralDensity) {
+    if (model == MotionModel::ConstantAcceleration) {
+        m_caProcessNoise = spectralDensity;
+    } else {
+        m_cvProcessNoise = spectralDensity;
+    }
+}
+
+void KalmanFilterBank::setHistoryDepth(int depth) {
+    m_historyDepth = qMax(0, depth);
+    const int slots = m_active.size();
+    m_history = QVector<HistoryEntry>(slots * m_historyDepth);
+    m_historyStart = QVector<int>(slots, 0);
+    m_historyCount = QVector<int>(slots, 0);
+}
+
+void KalmanFilterBank::ensureCapacity(int slot) {
+    if (slot < m_active.size()) return;
+
+    const int size = slot + 1;
+    for (int i = 0; i < STATE_DIM; ++i) {
+        m_state[i].resize(size);
+    }
+    m_cov.resize(size * COV_SIZE);
+    m_timestampMs.resize(size);
+    m_model.resize(size);
+    m_active.resize(size);
+    m_history.resize(size * m_historyDepth);
+    m_historyStart.resize(size);
+    m_historyCount.resize(size);
+}
+
+void KalmanFilterBank::initialize(int slot, const EnuVector& position, qint64 timestampMs,
+                                  MotionModel model) {
+    if (slot < 0) return;
+    ensureCapacity(slot);
+
+    const double pos[AXES] = { position.east, position.north, position.up };
+    for (int axis = 0; axis < AXES; ++axis) {
+        m_state[stateIndex(axis, POS)][slot] = pos[axis];
+        m_state[stateIndex(axis, VEL)][slot] = 0.0;
+        m_state[stateIndex(axis, ACC)][slot] = 0.0;
+    }
+
+    double* P = m_cov.data() + slot * COV_SIZE;
+    for (int i = 0; i < COV_SIZE; ++i) {
+        P[i] = 0.0;
+    }
+
+    const double posVar = m_measurementSigmaM * m_measurementSigmaM;
+    const double velVar = m_initialVelocitySigma * m_initialVelocitySigma;
+    const double accVar = model == MotionModel::ConstantAcceleration
+        ? m_initialAccelerationSigma * m_initialAccelerationSigma : 0.0;
+    for (int axis = 0; axis < AXES; ++axis) {
+        int p = stateIndex(axis, POS);
+        int v = stateIndex(axis, VEL);
+        int a = stateIndex(axis, ACC);
+        P[p * STATE_DIM + p] = posVar;
+        P[v * STATE_DIM + v] = velVar;
+        P[a * STATE_DIM + a] = accVar;
+    }
+
+    m_timestampMs[slot] = timestampMs;
+    m_model[slot] = static_cast<quint8>(model);
+    m_active[slot] = 1;
+
+    // The initial state anchors the ring: a late plot can rewind to it
+    m_historyStart[slot] = 0;
+    m_historyCount[slot] = 0;
+    record(slot, nullptr);
+}
+
+KalmanFilterBank::SlotState KalmanFilterBank::slotState(int slot) const {
+    SlotState saved;
+    for (int i = 0; i < STATE_DIM; ++i) {
+        saved.state[i] = m_state[i][slot];
+    }
+    std::memcpy(saved.cov, m_cov.constData() + slot * COV_SIZE, sizeof(saved.cov));
+    saved.timestampMs = m_timestampMs[slot];
+    saved.model = static_cast<MotionModel>(m_model[slot]);
+    return saved;
+}
+
+void KalmanFilterBank::restoreSlot(int slot, const SlotState& state) {
+    if (slot < 0) return;
+    ensureCapacity(slot);
+
+    for (int i = 0; i < STATE_DIM; ++i) {
+        m_state[i][slot] = state.state[i];
+    }
+    std::memcpy(m_cov.data() + slot * COV_SIZE, state.cov, sizeof(state.cov));
+    m_timestampMs[slot] = state.timestampMs;
+    m_model[slot] = static_cast<quint8>(state.model);
+    m_active[slot] = 1;
+
+    m_historyStart[slot] = 0;
+    m_historyCount[slot] = 0;
+    record(slot, nullptr);
+}
+
+void KalmanFilterBank::release(int slot) {
+    if (isActive(slot)) {
+        m_active[slot] = 0;
+    }
+}
+
+void KalmanFilterBank::clear() {
+    for (int i = 0; i < STATE_DIM; ++i) {
+        m_state[i].clear();
+    }
+    m_cov.clear();
+    m_timestampMs.clear();
+    m_model.clear();
+    m_active.clear();
+    m_history.clear();
+    m_historyStart.clear();
+    m_historyCount.clear();
+}
+
+void KalmanFilterBank::predictAll(qint64 nowMs) {
+    const int slots = m_active.size();
+    if (slots == 0) return;
+
+    m_dt.resize(slots);
+    double* dt = m_dt.data();
+    const quint8* active = m_active.constData();
+    qint64* stamp = m_timestampMs.data();
+
+    for (int s = 0; s < slots; ++s) {
+        qint64 elapsed = nowMs - stamp[s];
+        dt[s] = (active[s] && elapsed > 0) ? elapsed / 1000.0 : 0.0;
+        if (dt[s] > 0.0) stamp[s] = nowMs;
+    }
+
+    // State propagation, one tight loop per axis over the state columns.
+    // Inactive slots carry dt == 0 and are left unchanged.
+    for (int axis = 0; axis < AXES; ++axis) {
+        double* p = m_state[stateIndex(axis, POS)].data();
+        double* v = m_state[stateIndex(axis, VEL)].data();
+        const double* a = m_state[stateIndex(axis, ACC)].constData();
+        for (int s = 0; s < slots; ++s) {
+            const double t = dt[s];
+            p[s] += v[s] * t + 0.5 * a[s] * t * t;
+            v[s] += a[s] * t;
+        }
+    }
+
+    for (int s = 0; s < slots; ++s) {
+        if (dt[s] > 0.0) {
+            predictCovariance(s, dt[s]);
+        }
+    }
+}
+
+void KalmanFilterBank::predictCovariance(int slot, double dt) {
+    double* P = m_cov.data() + slot * COV_SIZE;
+    const double h = 0.5 * dt * dt;
+
+    // F is block diagonal with the same 3x3 block per axis:
+    //   [1 dt h; 0 1 dt; 0 0 1]
+    // so F*P and (F*P)*F^T reduce to row/column combinations per axis.
+    for (int axis = 0; axis < AXES; ++axis) {
+        double* r0 = P + stateIndex(axis, POS) * STATE_DIM;
+        double* r1 = P + stateIndex(axis, VEL) * STATE_DIM;
+        const double* r2 = P + stateIndex(axis, ACC) * STATE_DIM;
+        for (int c = 0; c < STATE_DIM; ++c) {
+            r0[c] += dt * r1[c] + h * r2[c];
+            r1[c] += dt * r2[c];
+        }
+    }
+    for (int r = 0; r < STATE_DIM; ++r) {
+        double* row = P + r * STATE_DIM;
+        for (int axis = 0; axis < AXES; ++axis) {
+            const int c0 = stateIndex(axis, POS);
+            const int c1 = stateIndex(axis, VEL);
+            const int c2 = stateIndex(axis, ACC);
+            row[c0] += dt * row[c1] + h * row[c2];
+            row[c1] += dt * row[c2];
+        }
+    }
+
+    // Discrete process noise per axis
+    double q[3][3];
+    const double dt2 = dt * dt;
+    const double dt3 = dt2 * dt;
+    if (static_cast<MotionModel>(m_model[slot]) == MotionModel::ConstantAcceleration) {
+        // White jerk
+        const double qc = m_caProcessNoise;
+        const double dt4 = dt3 * dt;
+        const double dt5 = dt4 * dt;
+        q[0][0] = qc * dt5 / 20.0; q[0][1] = qc * dt4 / 8.0; q[0][2] = qc * dt3 / 6.0;
+        q[1][0] = q[0][1];         q[1][1] = qc * dt3 / 3.0; q[1][2] = qc * dt2 / 2.0;
+        q[2][0] = q[0][2];         q[2][1] = q[1][2];        q[2][2] = qc * dt;
+    } else {
+        // White acceleration; acceleration states stay pinned at zero
+        const double qc = m_cvProcessNoise;
+        q[0][0] = qc * dt3 / 3.0; q[0][1] = qc * dt2 / 2.0; q[0][2] = 0.0;
+        q[1][0] = q[0][1];        q[1][1] = qc * dt;        q[1][2] = 0.0;
+        q[2][0] = 0.0;            q[2][1] = 0.0;            q[2][2] = 0.0;
+    }
+    for (int axis = 0; axis < AXES; ++axis) {
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                P[stateIndex(axis, i) * STATE_DIM + stateIndex(axis, j)] += q[i][j];
+            }
+        }
+    }
+}
+
+KalmanFilterBank::UpdateResult KalmanFilterBank::update(int slot, const EnuVector& measurement,
+                                                         qint64 timestampMs) {
+    if (!isActive(slot)) return UpdateResult::Rejected;
+
+    const double z[AXES] = { measurement.east, measurement.north, measurement.up };
+    if (m_historyDepth > 0 && timestampMs < m_timestampMs[slot]) {
+        return replay(slot, z, timestampMs);
+    }
+
+    predictSlot(slot, timestampMs);
+    if (!fuse(slot, z)) return UpdateResult::Rejected;
+    record(slot, z);
+    return UpdateResult::Fused;
+}
+
+void KalmanFilterBank::predictSlot(int slot, qint64 timestampMs) {
+    // Bring the slot to the measurement time
+    qint64 elapsed = timestampMs - m_timestampMs[slot];
+    if (elapsed <= 0) return;
+
+    const double dt = elapsed / 1000.0;
+    for (int axis = 0; axis < AXES; ++axis) {
+        double& p = m_state[stateIndex(axis, POS)][slot];
+        double& v = m_state[stateIndex(axis, VEL)][slot];
+        const double a = m_state[stateIndex(axis, ACC)][slot];
+        p += v * dt + 0.5 * a * dt * dt;
+        v += a * dt;
+    }
+    predictCovariance(slot, dt);
+    m_timestampMs[slot] = timestampMs;
+}
+
+bool KalmanFilterBank::fuse(int slot, const double* z) {
+    double* P = m_cov.data() + slot * COV_SIZE;
+    const int H[AXES] = { stateIndex(0, POS), stateIndex(1, POS), stateIndex(2, POS) };
+    const double r = m_measurementSigmaM * m_measurementSigmaM;
+
+    // Innovation covariance S = H P H^T + R
+    double S[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            S[i][j] = P[H[i] * STATE_DIM + H[j]] + (i == j ? r : 0.0);
+        }
+    }
+
+    const double det =
+        S[0][0] * (S[1][1] * S[2][2] - S[1][2] * S[2][1]) -
+        S[0][1] * (S[1][0] * S[2][2] - S[1][2] * S[2][0]) +
+        S[0][2] * (S[1][0] * S[2][1] - S[1][1] * S[2][0]);
+    if (std::fabs(det) < 1e-12) return false;
+
+    const double inv = 1.0 / det;
+    double Si[3][3];
+    Si[0][0] =  (S[1][1] * S[2][2] - S[1][2] * S[2][1]) * inv;
+    Si[0][1] = -(S[0][1] * S[2][2] - S[0][2] * S[2][1]) * inv;
+    Si[0][2] =  (S[0][1] * S[1][2] - S[0][2] * S[1][1]) * inv;
+    Si[1][0] = -(S[1][0] * S[2][2] - S[1][2] * S[2][0]) * inv;
+    Si[1][1] =  (S[0][0] * S[2][2] - S[0][2] * S[2][0]) * inv;
+    Si[1][2] = -(S[0][0] * S[1][2] - S[0][2] * S[1][0]) * inv;
+    Si[2][0] =  (S[1][0] * S[2][1] - S[1][1] * S[2][0]) * inv;
+    Si[2][1] = -(S[0][0] * S[2][1] - S[0][1] * S[2][0]) * inv;
+    Si[2][2] =  (S[0][0] * S[1][1] - S[0][1] * S[1][0]) * inv;
+
+    // PHt = P H^T (9x3), K = PHt S^-1 (9x3)
+    double PHt[STATE_DIM][3];
+    double K[STATE_DIM][3];
+    for (int i = 0; i < STATE_DIM; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            PHt[i][j] = P[i * STATE_DIM + H[j]];
+        }
+    }
+    for (int i = 0; i < STATE_DIM; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            K[i][j] = PHt[i][0] * Si[0][j] + PHt[i][1] * Si[1][j] + PHt[i][2] * Si[2][j];
+        }
+    }
+
+    double y[3];
+    for (int i = 0; i < 3; ++i) {
+        y[i] = z[i] - m_state[H[i]][slot];
+    }
+    for (int i = 0; i < STATE_DIM; ++i) {
+        m_state[i][slot] += K[i][0] * y[0] + K[i][1] * y[1] + K[i][2] * y[2];
+    }
+
+    // P = P - K (H P), with H P = PHt^T by symmetry; then re-symmetrize
+    for (int i = 0; i < STATE_DIM; ++i) {
+        for (int j = 0; j < STATE_DIM; ++j) {
+            P[i * STATE_DIM + j] -= K[i][0] * PHt[j][0] + K[i][1] * PHt[j][1] + K[i][2] * PHt[j][2];
+        }
+    }
+    for (int i = 0; i < STATE_DIM; ++i) {
+        for (int j = i + 1; j < STATE_DIM; ++j) {
+            double avg = 0.5 * (P[i * STATE_DIM + j] + P[j * STATE_DIM + i]);
+            P[i * STATE_DIM + j] = avg;
+            P[j * STATE_DIM + i] = avg;
+        }
+    }
+    return true;
+}
+
+void KalmanFilterBank::record(int slot, const double* z) {
+    if (m_historyDepth == 0) return;
+
+    if (m_historyCount[slot] == m_historyDepth) {
+        m_historyStart[slot] = (m_historyStart[slot] + 1) % m_historyDepth;
+        --m_historyCount[slot];
+    }
+    HistoryEntry& entry = historyAt(slot, m_historyCount[slot]++);
+    entry.timestampMs = m_timestampMs[slot];
+    entry.hasMeasurement = z != nullptr;
+    for (int i = 0; i < AXES; ++i) {
+        entry.measurement[i] = z ? z[i] : 0.0;
+    }
+    for (int i = 0; i < STATE_DIM; ++i) {
+        entry.state[i] = m_state[i][slot];
+    }
+    std::memcpy(entry.cov, m_cov.constData() + slot * COV_SIZE, sizeof(entry.cov));
+}
+
+KalmanFilterBank::UpdateResult KalmanFilterBank::replay(int slot, const double* z,
+                                                         qint64 timestampMs) {
+    // Newest posterior at or before the measurement
+    const int count = m_historyCount[slot];
+    int base = count - 1;
+    while (base >= 0 && historyAt(slot, base).timestampMs > timestampMs) {
+        --base;
+    }
+    if (base < 0) return UpdateResult::TooOld;
+
+    // Set the later measurements aside; recording them again rewrites the ring
+    m_replay.clear();
+    for (int i = base + 1; i < count; ++i) {
+        m_replay.append(historyAt(slot, i));
+    }
+
+    const qint64 slotTimeMs = m_timestampMs[slot];
+    const HistoryEntry& from = historyAt(slot, base);
+    for (int i = 0; i < STATE_DIM; ++i) {
+        m_state[i][slot] = from.state[i];
+    }
+    std::memcpy(m_cov.data() + slot * COV_SIZE, from.cov, sizeof(from.cov));
+    m_timestampMs[slot] = from.timestampMs;
+    m_historyCount[slot] = base + 1;
+
+    predictSlot(slot, timestampMs);
+    const bool fused = fuse(slot, z);
+    if (fused) {
+        record(slot, z);
+    }
+    for (const HistoryEntry& entry : m_replay) {
+        predictSlot(slot, entry.timestampMs);
+        if (entry.hasMeasurement && fuse(slot, entry.measurement)) {
+            record(slot, entry.measurement);
+        }
+    }
+
+    // Back to where predictAll() had taken the slot
+    predictSlot(slot, slotTimeMs);
+    return fused ? UpdateResult::Replayed : UpdateResult::Rejected;
+}
+
+EnuVector KalmanFilterBank::position(int slot) const {
+    EnuVector v;
+    v.east = m_state[stateIndex(0, POS)][slot];
+    v.north = m_state[stateIndex(1, POS)][slot];
+    v.up = m_state[stateIndex(2, POS)][slot];
+    return v;
+}
+
+EnuVector KalmanFilterBank::velocity(int slot) const {
+    EnuVector v;
+    v.east = m_state[stateIndex(0, VEL)][slot];
+    v.north = m_state[stateIndex(1, VEL)][slot];
+    v.up = m_state[stateIndex(2, VEL)][slot];
+    return v;
+}
+
+EnuVector KalmanFilterBank::acceleration(int slot) const {
+    EnuVector v;
+    v.east = m_state[stateIndex(0, ACC)][slot];
+    v.north = m_state[stateIndex(1, ACC)][slot];
+    v.up = m_state[stateIndex(2, ACC)][slot];
+    return v;
+}
+
+EnuVector KalmanFilterBank::predictedPosition(int slot, qint64 deltaMs) const {
+    const double dt = deltaMs / 1000.0;
+    const EnuVector p = position(slot);
+    const EnuVector v = velocity(slot);
+    const EnuVector a = acceleration(slot);
+
+    EnuVector predicted;
+    predicted.east = p.east + v.east * dt + 0.5 * a.east * dt * dt;
+    predicted.north = p.north + v.north * dt + 0.5 * a.north * dt * dt;
+    predicted.up = p.up + v.up * dt + 0.5 * a.up * dt * dt;
+    return predicted;
+}
+
+double KalmanFilterBank::covariance(int slot, int row, int col) const {
+    return m_cov[slot * COV_SIZE + row * STATE_DIM + col];
+}
+
+double KalmanFilterBank::positionVariance(int slot) const {
+    double trace = 0.0;
+    for (int axis = 0; axis < AXES; ++axis) {
+        int p = stateIndex(axis, POS);
+        trace += covariance(slot, p, p);
+    }
+    return trace;
+}
+
+} // namespace CounterUAS
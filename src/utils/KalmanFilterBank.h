@@ -0,0 +1,140 @@
+#ifndef KALMANFILTERBANK_H
+#define KALMANFILTERBANK_H
+
+#include <QVector>
+#include <QtGlobal>
+#include "utils/LocalTangentPlane.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Motion model used by a filter slot
+ */
+enum class MotionModel : quint8 {
+    ConstantVelocity = 0,
+    ConstantAcceleration
+};
+
+/**
+ * @brief Bank of 3D ENU Kalman filters with full covariance
+ *
+ * Each slot holds a 9-state filter ordered per axis as
+ * [e, ve, ae, n, vn, an, u, vu, au] with a full 9x9 covariance. A constant
+ * velocity slot is the same filter with the acceleration states and their
+ * covariance pinned to zero, so both models share one code path.
+ *
+ * Slots are dense integers chosen by the caller (TrackManager uses its
+ * TrackTable rows). State is stored column-wise so predictAll() advances
+ * every active slot in a single pass over contiguous arrays. Not thread-safe.
+ *
+ * With a history depth, each slot also keeps a ring of its last updates
+ * (measurement plus posterior). A measurement older than the slot's time is
+ * fused by rewinding to the newest posterior before it and replaying the
+ * later measurements, so a late plot costs at most depth updates and lands
+ * where it was taken. Both motion models discretize continuous white noise
+ * exactly, so the replay matches the in-order result however many predicts
+ * ran in between.
+ */
+class KalmanFilterBank {
+public:
+    static constexpr int STATE_DIM = 9;
+    static constexpr int COV_SIZE = STATE_DIM * STATE_DIM;
+
+    enum class UpdateResult : quint8 {
+        Fused,          // In sequence (or no history): applied at the slot's time
+        Replayed,       // Out of sequence: rewound and replayed
+        TooOld,         // Older than the history; discarded
+        Rejected        // Inactive slot or singular innovation
+    };
+
+    KalmanFilterBank() = default;
+
+    // Noise configuration (applies to subsequent predicts/updates)
+    void setProcessNoise(MotionModel model, double spectralDensity);
+    void setMeasurementNoise(double sigmaM) { m_measurementSigmaM = sigmaM; }
+    double measurementNoise() const { return m_measurementSigmaM; }
+    
+    // Updates kept per slot for out-of-sequence measurements; 0 disables.
+    // Changing it discards every slot's history.
+    void setHistoryDepth(int depth);
+    int historyDepth() const { return m_historyDepth; }
+
+    // Slot management
+    void initialize(int slot, const EnuVector& position, qint64 timestampMs,
+                    MotionModel model = MotionModel::ConstantVelocity);
+    void release(int slot);
+    void clear();
+    bool isActive(int slot) const { return slot >= 0 && slot < m_active.size() && m_active[slot]; }
+    int capacity() const { return m_active.size(); }
+
+    // Advance every active slot to nowMs
+    void predictAll(qint64 nowMs);
+
+    // Predict the slot to timestampMs, then fuse a position measurement
+    UpdateResult update(int slot, const EnuVector& measurement, qint64 timestampMs);
+
+    // State access
+    EnuVector position(int slot) const;
+    EnuVector velocity(int slot) const;
+    EnuVector acceleration(int slot) const;
+    EnuVector predictedPosition(int slot, qint64 deltaMs) const;  // No state change
+    double covariance(int slot, int row, int col) const;
+    double positionVariance(int slot) const;  // Trace of the position block
+    MotionModel model(int slot) const { return static_cast<MotionModel>(m_model[slot]); }
+    qint64 timestampMs(int slot) const { return m_timestampMs[slot]; }
+
+    // Raw slot contents, for checkpoints. Restoring activates the slot
+    // with an empty late-plot history anchored at the restored state.
+    struct SlotState {
+        double state[STATE_DIM];
+        double cov[COV_SIZE];
+        qint64 timestampMs = 0;
+        MotionModel model = MotionModel::ConstantVelocity;
+    };
+    SlotState slotState(int slot) const;
+    void restoreSlot(int slot, const SlotState& state);
+
+private:
+    struct HistoryEntry {
+        qint64 timestampMs = 0;
+        bool hasMeasurement = false;   // False for the initial state
+        double measurement[3];
+        double state[STATE_DIM];
+        double cov[COV_SIZE];
+    };
+
+    void ensureCapacity(int slot);
+    void predictSlot(int slot, qint64 timestampMs);
+    void predictCovariance(int slot, double dt);
+    bool fuse(int slot, const double* z);
+    void record(int slot, const double* z);
+    UpdateResult replay(int slot, const double* z, qint64 timestampMs);
+    HistoryEntry& historyAt(int slot, int i) {
+        return m_history[slot * m_historyDepth + (m_historyStart[slot] + i) % m_historyDepth];
+    }
+
+    // State columns, one array per state element
+    QVector<double> m_state[STATE_DIM];
+    QVector<double> m_cov;          // COV_SIZE doubles per slot, row-major
+    QVector<qint64> m_timestampMs;
+    QVector<quint8> m_model;
+    QVector<quint8> m_active;
+
+    double m_cvProcessNoise = 1.0;   // White acceleration PSD (m^2/s^3)
+    double m_caProcessNoise = 0.5;   // White jerk PSD (m^2/s^5)
+    double m_measurementSigmaM = 10.0;
+    double m_initialVelocitySigma = 50.0;
+    double m_initialAccelerationSigma = 10.0;
+
+    QVector<double> m_dt;            // Scratch for predictAll
+    
+    int m_historyDepth = 0;
+    QVector<HistoryEntry> m_history; // m_historyDepth entries per slot, a ring each
+    QVector<int> m_historyStart;     // Oldest entry of each ring
+    QVector<int> m_historyCount;
+    QVector<HistoryEntry> m_replay;  // Scratch for replay
+};
+
+} // namespace CounterUAS
+
+#endif // KALMANFILTERBANK_H
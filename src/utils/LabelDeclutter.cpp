@@ -0,0 +1,216 @@
+#include "utils/LabelDeclutter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+void LabelDeclutter::setConfig(const LabelDeclutterConfig& config) {
+    m_config = config;
+    m_config.cellSize = std::max(m_config.cellSize, 1.0);
+    clear();
+}
+
+void LabelDeclutter::clear() {
+    m_entries.clear();
+    m_occupied.clear();
+    m_clusters.clear();
+    m_searched = 0;
+}
+
+LabelPlacement LabelDeclutter::placement(quint64 key) const {
+    LabelPlacement placement;
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) return placement;
+    placement.rect = it->rect;
+    placement.leader = it->leader;
+    return placement;
+}
+
+void LabelDeclutter::update(const QVector<LabelRequest>& requests) {
+    m_occupied.clear();
+    m_clusters.clear();
+    m_searched = 0;
+
+    // Symbols per cell, and every symbol kept clear
+    const double r = m_config.symbolRadius;
+    QHash<quint64, int> symbols;
+    for (const LabelRequest& request : requests) {
+        symbols[cellOf(request.anchor)]++;
+        occupy(QRectF(request.anchor.x() - r, request.anchor.y() - r, r * 2, r * 2));
+    }
+
+    QHash<quint64, Entry> next;
+    next.reserve(requests.size());
+    QHash<quint64, int> clusterOfCell;
+
+    auto collapse = [&](const LabelRequest& request, Entry& entry) {
+        entry.collapsed = true;
+        entry.leader = false;
+        entry.rect = QRectF();
+        const quint64 cell = cellOf(request.anchor);
+        auto it = clusterOfCell.find(cell);
+        if (it == clusterOfCell.end()) {
+            it = clusterOfCell.insert(cell, m_clusters.size());
+            m_clusters.append({QPointF(), QRectF(request.anchor, request.anchor), 0});
+        }
+        LabelCluster& cluster = m_clusters[it.value()];
+        const QPointF& a = request.anchor;
+        const QRectF& b = cluster.bounds;
+        cluster.bounds = QRectF(QPointF(std::min(b.left(), a.x()), std::min(b.top(), a.y())),
+                                QPointF(std::max(b.right(), a.x()), std::max(b.bottom(), a.y())));
+        cluster.centre += a;
+        cluster.count++;
+    };
+
+    // A label that has barely moved keeps its offset, unless something
+    // placed ahead of it now covers the spot
+    auto keep = [&](const LabelRequest& request, Entry& entry) {
+        auto prev = m_entries.constFind(request.key);
+        if (prev == m_entries.constEnd() || prev->collapsed || prev->size != request.size) return false;
+        if (QLineF(prev->placedAnchor, request.anchor).length() > m_config.moveThreshold) return false;
+        const QRectF rect(request.anchor + prev->offset, request.size);
+        if (collides(rect)) return false;
+        entry = prev.value();
+        entry.rect = rect;
+        occupy(rect);
+        return true;
+    };
+
+    auto place = [&](const LabelRequest& request, Entry& entry) {
+        ++m_searched;
+        entry.placedAnchor = request.anchor;
+        entry.size = request.size;
+        entry.collapsed = false;
+        if (search(request, entry)) {
+            entry.rect = QRectF(request.anchor + entry.offset, request.size);
+            occupy(entry.rect);
+        } else if (request.pinned) {
+            // Shown wherever it overlaps
+            entry.offset = request.offset;
+            entry.leader = false;
+            entry.rect = QRectF(request.anchor + entry.offset, request.size);
+            occupy(entry.rect);
+        } else {
+            collapse(request, entry);
+        }
+    };
+
+    // Pinned labels, then those kept, then those that need a search
+    QVector<int> unkept;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < requests.size(); ++i) {
+            const LabelRequest& request = requests[i];
+            if (request.pinned != (pass == 0)) continue;
+            Entry entry;
+            if (!request.pinned && symbols.value(cellOf(request.anchor)) >= m_config.clusterSize) {
+                collapse(request, entry);
+            } else if (!keep(request, entry)) {
+                if (request.pinned) place(request, entry);
+                else { unkept.append(i); continue; }
+            }
+            next.insert(request.key, entry);
+        }
+    }
+    for (int i : unkept) {
+        Entry entry;
+        place(requests[i], entry);
+        next.insert(requests[i].key, entry);
+    }
+
+    for (LabelCluster& cluster : m_clusters) {
+        cluster.centre /= cluster.count;
+    }
+    m_entries = std::move(next);
+}
+
+bool LabelDeclutter::search(const LabelRequest& request, Entry& entry) const {
+    const double w = request.size.width();
+    const double h = request.size.height();
+    const double r = m_config.symbolRadius;
+
+    // Beside the symbol: preferred, mirrored, above, below
+    const QPointF adjacent[4] = {
+        request.offset,
+        QPointF(-request.offset.x() - w, request.offset.y()),
+        QPointF(-w / 2.0, -r - h - 2.0),
+        QPointF(-w / 2.0, r + 2.0),
+    };
+    for (const QPointF& offset : adjacent) {
+        if (!collides(QRectF(request.anchor + offset, request.size))) {
+            entry.offset = offset;
+            entry.leader = false;
+            return true;
+        }
+    }
+
+    // Rings further out, nearest the preferred side first. The rect's
+    // edge facing the symbol sits on the ring
+    static const int angles[8] = {0, -45, 45, -90, 90, -135, 135, 180};
+    const double side = request.offset.x() < 0.0 ? -1.0 : 1.0;
+    for (int step = 1; step <= 3; ++step) {
+        const double distance = r + m_config.maxLeader * step / 3.0;
+        for (int angle : angles) {
+            const double rad = angle * M_PI / 180.0;
+            const double dx = std::cos(rad) * side;
+            const double dy = std::sin(rad);
+            const QPointF centre = request.anchor + QPointF(dx, dy) * distance;
+            const QPointF topLeft(centre.x() - w / 2.0 + dx * w / 2.0,
+                                  centre.y() - h / 2.0 + dy * h / 2.0);
+            if (!collides(QRectF(topLeft, request.size))) {
+                entry.offset = topLeft - request.anchor;
+                entry.leader = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+QLineF LabelDeclutter::leaderLine(const QPointF& anchor, const QRectF& rect, double clearance) {
+    const QPointF nearest(std::clamp(anchor.x(), rect.left(), rect.right()),
+                          std::clamp(anchor.y(), rect.top(), rect.bottom()));
+    const QPointF delta = nearest - anchor;
+    const double length = std::hypot(delta.x(), delta.y());
+    if (length <= clearance) return QLineF();
+    return QLineF(anchor + delta * (clearance / length), nearest);
+}
+
+quint64 LabelDeclutter::cellKey(int cx, int cy) {
+    return (quint64(quint32(cx)) << 32) | quint32(cy);
+}
+
+quint64 LabelDeclutter::cellOf(const QPointF& point) const {
+    return cellKey(int(std::floor(point.x() / m_config.cellSize)),
+                   int(std::floor(point.y() / m_config.cellSize)));
+}
+
+bool LabelDeclutter::collides(const QRectF& rect) const {
+    const int x0 = int(std::floor(rect.left() / m_config.cellSize));
+    const int x1 = int(std::floor(rect.right() / m_config.cellSize));
+    const int y0 = int(std::floor(rect.top() / m_config.cellSize));
+    const int y1 = int(std::floor(rect.bottom() / m_config.cellSize));
+    for (int cx = x0; cx <= x1; ++cx) {
+        for (int cy = y0; cy <= y1; ++cy) {
+            auto it = m_occupied.constFind(cellKey(cx, cy));
+            if (it == m_occupied.constEnd()) continue;
+            for (const QRectF& occupied : it.value()) {
+                if (occupied.intersects(rect)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+void LabelDeclutter::occupy(const QRectF& rect) {
+    const int x0 = int(std::floor(rect.left() / m_config.cellSize));
+    const int x1 = int(std::floor(rect.right() / m_config.cellSize));
+    const int y0 = int(std::floor(rect.top() / m_config.cellSize));
+    const int y1 = int(std::floor(rect.bottom() / m_config.cellSize));
+    for (int cx = x0; cx <= x1; ++cx) {
+        for (int cy = y0; cy <= y1; ++cy) {
+            m_occupied[cellKey(cx, cy)].append(rect);
+        }
+    }
+}
+
+} // namespace CounterUAS
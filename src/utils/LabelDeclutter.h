@@ -0,0 +1,117 @@
+#ifndef LABELDECLUTTER_H
+#define LABELDECLUTTER_H
+
+#include <QHash>
+#include <QLineF>
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <QVector>
+
+namespace CounterUAS {
+
+/**
+ * @brief Grid and thresholds of the label declutter pass, in screen pixels
+ */
+struct LabelDeclutterConfig {
+    double cellSize = 48.0;         // Grid hash cell side
+    int clusterSize = 6;            // Symbols in one cell from which its labels collapse
+    double moveThreshold = 2.0;     // Anchor movement before a label is placed again
+    double maxLeader = 60.0;        // Furthest a label is pushed out from its symbol
+    double symbolRadius = 12.0;     // Kept clear around every symbol
+};
+
+/**
+ * @brief One label to place: where its symbol is and how big its text is
+ */
+struct LabelRequest {
+    quint64 key = 0;                // Identifies the label across frames, e.g. the track handle
+    QPointF anchor;                 // Symbol centre
+    QSizeF size;                    // Text bounds
+    QPointF offset;                 // Preferred text top-left relative to anchor
+    bool pinned = false;            // Placed first and never collapsed, e.g. the selected track
+};
+
+/**
+ * @brief Where a label went
+ */
+struct LabelPlacement {
+    QRectF rect;                    // Text bounds; empty when collapsed into a cluster
+    bool leader = false;            // Pushed off its symbol; draw leaderLine()
+
+    bool isVisible() const { return !rect.isEmpty(); }
+};
+
+/**
+ * @brief Labels collapsed into one count glyph
+ */
+struct LabelCluster {
+    QPointF centre;                 // Mean anchor of the collapsed labels
+    QRectF bounds;                  // Spanned by their anchors
+    int count = 0;
+};
+
+/**
+ * @brief Screen-space label placement for crowded tactical displays
+ *
+ * Symbols are hashed into a grid of cellSize squares. A cell holding
+ * clusterSize symbols or more is a swarm: its labels collapse into one
+ * LabelCluster at their mean anchor, to be drawn as a count glyph.
+ * Every other label tries its preferred spot, the other sides of its
+ * symbol, then rings out to maxLeader with a leader line, keeping the
+ * first that overlaps no symbol and no label placed before it. Occupied
+ * rectangles are hashed into the same grid, so each test only looks at
+ * the cells it covers. A label with nowhere to go joins its cell's
+ * cluster.
+ *
+ * A label whose anchor has moved less than moveThreshold since it was
+ * placed, and whose size has not changed, keeps its offset without a
+ * search; it is placed ahead of the others, so labels do not jump about
+ * under tracks that are barely moving. Pinned labels go before either.
+ */
+class LabelDeclutter {
+public:
+    LabelDeclutter() = default;
+    explicit LabelDeclutter(const LabelDeclutterConfig& config) : m_config(config) {}
+
+    void setConfig(const LabelDeclutterConfig& config);
+    LabelDeclutterConfig config() const { return m_config; }
+
+    // One frame's labels; keys not in it are forgotten
+    void update(const QVector<LabelRequest>& requests);
+    void clear();
+
+    // Empty placement for keys not in the last update
+    LabelPlacement placement(quint64 key) const;
+    const QVector<LabelCluster>& clusters() const { return m_clusters; }
+    int searchedLastUpdate() const { return m_searched; }   // Rather than kept
+
+    // From clearance off the anchor to the nearest point of rect
+    static QLineF leaderLine(const QPointF& anchor, const QRectF& rect, double clearance);
+
+private:
+    struct Entry {
+        QPointF placedAnchor;       // Where the anchor was when last searched
+        QSizeF size;
+        QPointF offset;             // Text top-left relative to anchor
+        bool leader = false;
+        bool collapsed = false;
+        QRectF rect;
+    };
+
+    static quint64 cellKey(int cx, int cy);
+    quint64 cellOf(const QPointF& point) const;
+    bool collides(const QRectF& rect) const;
+    void occupy(const QRectF& rect);
+    bool search(const LabelRequest& request, Entry& entry) const;
+
+    LabelDeclutterConfig m_config;
+    QHash<quint64, Entry> m_entries;                // By label key
+    QHash<quint64, QVector<QRectF>> m_occupied;     // By grid cell, this update
+    QVector<LabelCluster> m_clusters;
+    int m_searched = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // LABELDECLUTTER_H
@@ -0,0 +1,106 @@
+#include "utils/LatencyHistogram.h"
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr qint64 MAX_TRACKABLE_US =
+    (static_cast<qint64>(LatencyHistogramSnapshot::SUB_BUCKETS) * 2 << LatencyHistogramSnapshot::MAX_SHIFT) - 1;
+
+int highestBit(quint64 v) {
+    int bit = 0;
+    while (v >>= 1) ++bit;
+    return bit;
+}
+
+} // namespace
+
+int LatencyHistogramSnapshot::bucketFor(qint64 us) {
+    // Octave by the highest set bit, step by the next SUB_BUCKET_BITS below it
+    if (us < 0) us = 0;
+    if (us > MAX_TRACKABLE_US) us = MAX_TRACKABLE_US;
+    const int shift = qMax(0, highestBit(static_cast<quint64>(us)) - SUB_BUCKET_BITS);
+    return shift * SUB_BUCKETS + static_cast<int>(us >> shift);
+}
+
+qint64 LatencyHistogramSnapshot::bucketLowerUs(int bucket) {
+    const int shift = qMax(0, bucket / SUB_BUCKETS - 1);
+    return static_cast<qint64>(bucket - shift * SUB_BUCKETS) << shift;
+}
+
+qint64 LatencyHistogramSnapshot::bucketUpperUs(int bucket) {
+    const int shift = qMax(0, bucket / SUB_BUCKETS - 1);
+    return bucketLowerUs(bucket) + (static_cast<qint64>(1) << shift) - 1;
+}
+
+qint64 LatencyHistogramSnapshot::percentileUs(double fraction) const {
+    // Ranked against the buckets themselves, which a racing snapshot keeps consistent
+    quint64 total = 0;
+    for (quint64 n : counts) total += n;
+    if (total == 0) return 0;
+
+    const double clamped = qBound(0.0, fraction, 1.0);
+    const quint64 rank = qMax<quint64>(1, static_cast<quint64>(std::ceil(clamped * total)));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return maxUs > 0 ? qMin(bucketUpperUs(i), maxUs) : bucketUpperUs(i);
+        }
+    }
+    return maxUs;
+}
+
+LatencyHistogramSnapshot LatencyHistogramSnapshot::since(const LatencyHistogramSnapshot& earlier) const {
+    LatencyHistogramSnapshot delta;
+    int highest = -1;
+    for (int i = 0; i < BUCKETS; ++i) {
+        delta.counts[i] = counts[i] >= earlier.counts[i] ? counts[i] - earlier.counts[i] : 0;
+        if (delta.counts[i] > 0) highest = i;
+    }
+    delta.count = count >= earlier.count ? count - earlier.count : 0;
+    delta.sumUs = sumUs >= earlier.sumUs ? sumUs - earlier.sumUs : 0;
+    // The interval's own maximum is not kept; its highest bucket bounds it
+    delta.maxUs = highest >= 0 ? qMin(bucketUpperUs(highest), maxUs) : 0;
+    return delta;
+}
+
+LatencyHistogram::LatencyHistogram() {
+    for (auto& bucket : m_counts) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(qint64 us) {
+    if (us < 0) us = 0;
+    m_counts[LatencyHistogramSnapshot::bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    m_sumUs.fetch_add(static_cast<quint64>(us), std::memory_order_relaxed);
+    qint64 seen = m_maxUs.load(std::memory_order_relaxed);
+    while (us > seen &&
+           !m_maxUs.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {
+    }
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyHistogramSnapshot LatencyHistogram::snapshot() const {
+    LatencyHistogramSnapshot snap;
+    snap.count = m_count.load(std::memory_order_relaxed);
+    snap.sumUs = m_sumUs.load(std::memory_order_relaxed);
+    snap.maxUs = m_maxUs.load(std::memory_order_relaxed);
+    for (int i = 0; i < BUCKETS; ++i) {
+        snap.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+    }
+    return snap;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_counts) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumUs.store(0, std::memory_order_relaxed);
+    m_maxUs.store(0, std::memory_order_relaxed);
+}
+
+} // namespace CounterUAS
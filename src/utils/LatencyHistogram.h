@@ -0,0 +1,67 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+#include <atomic>
+
+namespace CounterUAS {
+
+/**
+ * @brief Copy of a LatencyHistogram's counters at one instant
+ */
+struct LatencyHistogramSnapshot {
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_SHIFT = 22;                          // Up to 2^27 us, about two minutes
+    static constexpr int BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+    quint64 counts[BUCKETS] = {};
+    quint64 count = 0;
+    quint64 sumUs = 0;
+    qint64 maxUs = 0;
+
+    double meanUs() const { return count > 0 ? static_cast<double>(sumUs) / count : 0.0; }
+    // Highest value in the bucket holding the fraction-th sample, at most maxUs
+    qint64 percentileUs(double fraction) const;
+
+    // Samples recorded after earlier was taken
+    LatencyHistogramSnapshot since(const LatencyHistogramSnapshot& earlier) const;
+
+    static int bucketFor(qint64 us);
+    static qint64 bucketLowerUs(int bucket);
+    static qint64 bucketUpperUs(int bucket);
+};
+
+/**
+ * @brief Lock-free log-linear latency histogram in microseconds
+ *
+ * HDR-style buckets: values under 32 us are counted exactly, and every
+ * octave above is split into 16 linear steps, so a percentile is never off
+ * by more than 1/16 of its value. record() is a handful of relaxed atomic
+ * adds and may be called from any number of threads; snapshot() reads the
+ * counters without stopping them, so a snapshot taken under load can be a
+ * few samples out of step between its buckets and its totals.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int BUCKETS = LatencyHistogramSnapshot::BUCKETS;
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(qint64 us);
+    LatencyHistogramSnapshot snapshot() const;
+    void reset();
+
+private:
+    std::atomic<quint64> m_counts[BUCKETS];
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sumUs{0};
+    std::atomic<qint64> m_maxUs{0};
+};
+
+} // namespace CounterUAS
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,30 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Running latency counters in microseconds
+ */
+struct LatencyStats {
+    quint64 count = 0;
+    qint64 lastUs = 0;
+    qint64 maxUs = 0;
+    double meanUs = 0.0;
+
+    void record(qint64 us) {
+        if (us < 0) us = 0;
+        ++count;
+        lastUs = us;
+        maxUs = qMax(maxUs, us);
+        meanUs += (static_cast<double>(us) - meanUs) / static_cast<double>(count);
+    }
+
+    void reset() { *this = LatencyStats(); }
+};
+
+} // namespace CounterUAS
+
+#endif // LATENCYSTATS_H
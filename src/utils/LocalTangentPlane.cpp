@@ -0,0 +1,171 @@
+#include "utils/LocalTangentPlane.h"
+#include "core/Track.h"
+#include <QtMath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int GEODETIC_ITERATIONS = 2;  // Already under a micrometre below 100 km altitude
+
+inline double wrapDegrees180(double degrees) {
+    degrees = std::fmod(degrees + 180.0, 360.0);
+    if (degrees < 0.0) degrees += 360.0;
+    return degrees - 180.0;
+}
+
+} // namespace
+
+double EnuVector::azimuthDeg() const {
+    const double degrees = qRadiansToDegrees(std::atan2(east, north));
+    return degrees < 0.0 ? degrees + 360.0 : degrees;
+}
+
+double EnuVector::elevationDeg() const {
+    return qRadiansToDegrees(std::atan2(up, groundRange()));
+}
+
+LocalTangentPlane::LocalTangentPlane() {
+    setOrigin(GeoPosition());
+}
+
+LocalTangentPlane::LocalTangentPlane(const GeoPosition& origin) {
+    setOrigin(origin);
+}
+
+void LocalTangentPlane::setOrigin(const GeoPosition& origin) {
+    m_latDeg = origin.latitude;
+    m_lonDeg = origin.longitude;
+    m_alt = origin.altitude;
+
+    const double lat = qDegreesToRadians(m_latDeg);
+    const double lon = qDegreesToRadians(m_lonDeg);
+    m_sinLat = std::sin(lat);
+    m_cosLat = std::cos(lat);
+    m_sinLon = std::sin(lon);
+    m_cosLon = std::cos(lon);
+    m_originEcef = toEcef(origin);
+
+    const double w2 = 1.0 - WGS84_E2 * m_sinLat * m_sinLat;
+    const double primeVertical = WGS84_A / std::sqrt(w2);
+    const double meridian = WGS84_A * (1.0 - WGS84_E2) / (w2 * std::sqrt(w2));
+    m_metersPerRadLat = meridian + m_alt;
+    m_metersPerRadLon = qMax(1.0, (primeVertical + m_alt) * m_cosLat);
+}
+
+GeoPosition LocalTangentPlane::origin() const {
+    GeoPosition pos;
+    pos.latitude = m_latDeg;
+    pos.longitude = m_lonDeg;
+    pos.altitude = m_alt;
+    return pos;
+}
+
+EcefVector LocalTangentPlane::toEcef(const GeoPosition& pos) {
+    const double lat = qDegreesToRadians(pos.latitude);
+    const double lon = qDegreesToRadians(pos.longitude);
+    const double sinLat = std::sin(lat);
+    const double cosLat = std::cos(lat);
+    const double n = WGS84_A / std::sqrt(1.0 - WGS84_E2 * sinLat * sinLat);
+
+    EcefVector ecef;
+    ecef.x = (n + pos.altitude) * cosLat * std::cos(lon);
+    ecef.y = (n + pos.altitude) * cosLat * std::sin(lon);
+    ecef.z = (n * (1.0 - WGS84_E2) + pos.altitude) * sinLat;
+    return ecef;
+}
+
+GeoPosition LocalTangentPlane::fromEcef(const EcefVector& ecef) {
+    const double p = std::hypot(ecef.x, ecef.y);
+    double lat = std::atan2(ecef.z, p * (1.0 - WGS84_E2));
+    double height = 0.0;
+
+    for (int i = 0; i < GEODETIC_ITERATIONS; ++i) {
+        const double sinLat = std::sin(lat);
+        const double n = WGS84_A / std::sqrt(1.0 - WGS84_E2 * sinLat * sinLat);
+        // Stable at the poles, where p / cos(lat) is not
+        height = p * std::cos(lat) + (ecef.z + WGS84_E2 * n * sinLat) * sinLat - n;
+        lat = std::atan2(ecef.z, p * (1.0 - WGS84_E2 * n / (n + height)));
+    }
+
+    GeoPosition pos;
+    pos.latitude = qRadiansToDegrees(lat);
+    pos.longitude = qRadiansToDegrees(std::atan2(ecef.y, ecef.x));
+    pos.altitude = height;
+    return pos;
+}
+
+EnuVector LocalTangentPlane::ecefToEnu(const EcefVector& ecef) const {
+    const double dx = ecef.x - m_originEcef.x;
+    const double dy = ecef.y - m_originEcef.y;
+    const double dz = ecef.z - m_originEcef.z;
+
+    EnuVector enu;
+    enu.east = -m_sinLon * dx + m_cosLon * dy;
+    enu.north = -m_sinLat * m_cosLon * dx - m_sinLat * m_sinLon * dy + m_cosLat * dz;
+    enu.up = m_cosLat * m_cosLon * dx + m_cosLat * m_sinLon * dy + m_sinLat * dz;
+    return enu;
+}
+
+EcefVector LocalTangentPlane::enuToEcef(const EnuVector& enu) const {
+    EcefVector ecef;
+    ecef.x = m_originEcef.x - m_sinLon * enu.east - m_sinLat * m_cosLon * enu.north +
+             m_cosLat * m_cosLon * enu.up;
+    ecef.y = m_originEcef.y + m_cosLon * enu.east - m_sinLat * m_sinLon * enu.north +
+             m_cosLat * m_sinLon * enu.up;
+    ecef.z = m_originEcef.z + m_cosLat * enu.north + m_sinLat * enu.up;
+    return ecef;
+}
+
+EnuVector LocalTangentPlane::toEnu(const GeoPosition& pos) const {
+    return ecefToEnu(toEcef(pos));
+}
+
+GeoPosition LocalTangentPlane::toGeo(const EnuVector& enu) const {
+    return fromEcef(enuToEcef(enu));
+}
+
+EnuVector LocalTangentPlane::toEnuLinear(const GeoPosition& pos) const {
+    EnuVector enu;
+    enu.east = qDegreesToRadians(wrapDegrees180(pos.longitude - m_lonDeg)) * m_metersPerRadLon;
+    enu.north = qDegreesToRadians(pos.latitude - m_latDeg) * m_metersPerRadLat;
+    enu.up = pos.altitude - m_alt;
+    return enu;
+}
+
+GeoPosition LocalTangentPlane::toGeoLinear(const EnuVector& enu) const {
+    GeoPosition pos;
+    pos.latitude = m_latDeg + qRadiansToDegrees(enu.north / m_metersPerRadLat);
+    pos.longitude = wrapDegrees180(m_lonDeg + qRadiansToDegrees(enu.east / m_metersPerRadLon));
+    pos.altitude = m_alt + enu.up;
+    return pos;
+}
+
+void LocalTangentPlane::toEnu(const double* latitude, const double* longitude, const double* altitude,
+                              double* east, double* north, double* up, int count) const {
+    constexpr double degToRad = M_PI / 180.0;
+    for (int i = 0; i < count; ++i) {
+        const double lat = latitude[i] * degToRad;
+        const double lon = longitude[i] * degToRad;
+        const double sinLat = std::sin(lat);
+        const double cosLat = std::cos(lat);
+        const double n = WGS84_A / std::sqrt(1.0 - WGS84_E2 * sinLat * sinLat);
+        const double horizontal = (n + altitude[i]) * cosLat;
+
+        const double dx = horizontal * std::cos(lon) - m_originEcef.x;
+        const double dy = horizontal * std::sin(lon) - m_originEcef.y;
+        const double dz = (n * (1.0 - WGS84_E2) + altitude[i]) * sinLat - m_originEcef.z;
+
+        east[i] = -m_sinLon * dx + m_cosLon * dy;
+        north[i] = -m_sinLat * m_cosLon * dx - m_sinLat * m_sinLon * dy + m_cosLat * dz;
+        up[i] = m_cosLat * m_cosLon * dx + m_cosLat * m_sinLon * dy + m_sinLat * dz;
+    }
+}
+
+void LocalTangentPlane::toEnu(const GeoPosition* positions, EnuVector* out, int count) const {
+    for (int i = 0; i < count; ++i) {
+        out[i] = ecefToEnu(toEcef(positions[i]));
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,110 @@
+#ifndef LOCALTANGENTPLANE_H
+#define LOCALTANGENTPLANE_H
+
+#include <QtGlobal>
+#include <QtMath>
+
+namespace CounterUAS {
+
+struct GeoPosition;
+
+/**
+ * @brief Local East-North-Up vector in meters (or m/s, m/s^2)
+ */
+struct EnuVector {
+    double east = 0.0;
+    double north = 0.0;
+    double up = 0.0;
+
+    double range() const { return std::sqrt(east * east + north * north + up * up); }
+    double groundRange() const { return std::hypot(east, north); }
+    // Compass bearing of the vector, [0, 360)
+    double azimuthDeg() const;
+    // Above the local horizontal is positive
+    double elevationDeg() const;
+
+    // Straight-line distance between two points in the same frame
+    static double distance(const EnuVector& a, const EnuVector& b) {
+        const double de = b.east - a.east;
+        const double dn = b.north - a.north;
+        const double du = b.up - a.up;
+        return std::sqrt(de * de + dn * dn + du * du);
+    }
+};
+
+/**
+ * @brief Earth-centred Earth-fixed vector in meters
+ */
+struct EcefVector {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+};
+
+/**
+ * @brief WGS-84 East-North-Up frame anchored at a site
+ *
+ * The origin's trigonometry and ECEF position are computed once, so
+ * converting a position costs one sin/cos pair per angle and a rotation,
+ * and from then on distance, bearing and elevation between points in the
+ * frame are subtract-and-hypot. toEnu()/toGeo() are exact through ECEF;
+ * toEnuLinear()/toGeoLinear() are the first-order expansion about the
+ * origin (curvature ignored, under a metre of error within about 3 km),
+ * for hot paths such as sensor report conversion that used to scale
+ * degrees by a fixed 111 km.
+ *
+ * Altitudes are treated as heights above the ellipsoid. Copyable and
+ * immutable after setOrigin(), so any thread may convert through a shared
+ * frame.
+ */
+class LocalTangentPlane {
+public:
+    static constexpr double WGS84_A = 6378137.0;                  // Semi-major axis, m
+    static constexpr double WGS84_F = 1.0 / 298.257223563;        // Flattening
+    static constexpr double WGS84_E2 = WGS84_F * (2.0 - WGS84_F); // First eccentricity squared
+
+    LocalTangentPlane();
+    explicit LocalTangentPlane(const GeoPosition& origin);
+
+    void setOrigin(const GeoPosition& origin);
+    GeoPosition origin() const;
+
+    // Exact, through ECEF
+    EnuVector toEnu(const GeoPosition& pos) const;
+    GeoPosition toGeo(const EnuVector& enu) const;
+
+    // First order about the origin
+    EnuVector toEnuLinear(const GeoPosition& pos) const;
+    GeoPosition toGeoLinear(const EnuVector& enu) const;
+    double metersPerDegreeLatitude() const { return m_metersPerRadLat * (M_PI / 180.0); }
+    double metersPerDegreeLongitude() const { return m_metersPerRadLon * (M_PI / 180.0); }
+
+    // Exact batch conversion over parallel arrays (e.g. TrackTable
+    // columns); a branch-free loop the compiler can vectorize around the
+    // per-point sin/cos
+    void toEnu(const double* latitude, const double* longitude, const double* altitude,
+               double* east, double* north, double* up, int count) const;
+    void toEnu(const GeoPosition* positions, EnuVector* out, int count) const;
+
+    EcefVector enuToEcef(const EnuVector& enu) const;
+    EnuVector ecefToEnu(const EcefVector& ecef) const;
+
+    static EcefVector toEcef(const GeoPosition& pos);
+    static GeoPosition fromEcef(const EcefVector& ecef);
+
+private:
+    double m_latDeg = 0.0;
+    double m_lonDeg = 0.0;
+    double m_alt = 0.0;
+    double m_sinLat = 0.0;
+    double m_cosLat = 1.0;
+    double m_sinLon = 0.0;
+    double m_cosLon = 1.0;
+    EcefVector m_originEcef;
+    double m_metersPerRadLat = WGS84_A;   // Meridian radius of curvature plus height
+    double m_metersPerRadLon = WGS84_A;   // Prime vertical radius times cos(lat), plus height
+};
+
+} // namespace CounterUAS
+
+#endif // LOCALTANGENTPLANE_H
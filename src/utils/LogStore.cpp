@@ -0,0 +1,214 @@
+#include "utils/LogStore.h"
+#include "utils/MemoryAccounting.h"
+#include <algorithm>
+
+namespace CounterUAS {
+
+LogStore::LogStore(int capacity)
+    : m_capacity(qMax(0, capacity))
+{
+}
+
+LogStore::~LogStore() {
+    MemoryAccounting::released(MemoryTag::Logging, m_bytes, quint64(m_count));
+}
+
+void LogStore::setCapacity(int capacity) {
+    QWriteLocker locker(&m_lock);
+    capacity = qMax(0, capacity);
+    if (capacity == m_capacity) return;
+    
+    while (m_count > capacity) {
+        evictOldestLocked();
+    }
+    // Laid out from slot 0 again, so the ring can grow from its end
+    QVector<LogEntry> slots;
+    slots.reserve(m_count);
+    for (int i = 0; i < m_count; ++i) {
+        slots.append(std::move(m_slots[(m_head + i) % m_slots.size()]));
+    }
+    m_slots = std::move(slots);
+    m_head = 0;
+    m_capacity = capacity;
+}
+
+int LogStore::capacity() const {
+    QReadLocker locker(&m_lock);
+    return m_capacity;
+}
+
+int LogStore::size() const {
+    QReadLocker locker(&m_lock);
+    return m_count;
+}
+
+qint64 LogStore::memoryBytes() const {
+    QReadLocker locker(&m_lock);
+    return m_bytes;
+}
+
+quint64 LogStore::lastSequence() const {
+    QReadLocker locker(&m_lock);
+    return m_nextSequence - 1;
+}
+
+qint64 LogStore::entryBytes(const LogEntry& entry) {
+    return qint64(sizeof(LogEntry)) +
+           (entry.category.size() + entry.message.size() + entry.threadId.size()) * qint64(sizeof(QChar));
+}
+
+void LogStore::append(QList<LogEntry>& batch) {
+    QWriteLocker locker(&m_lock);
+    for (LogEntry& entry : batch) {
+        entry.sequence = m_nextSequence++;
+        entry.categoryId = internLocked(entry.category);
+        if (m_capacity == 0) continue;
+        
+        if (m_count == m_capacity) {
+            evictOldestLocked();
+        }
+        if (m_count == m_slots.size()) {
+            m_slots.append(entry);      // Still growing; m_head is 0
+        } else {
+            m_slots[(m_head + m_count) % m_slots.size()] = entry;
+        }
+        ++m_count;
+        
+        const int level = qBound(0, static_cast<int>(entry.level), LEVELS - 1);
+        m_byLevel[level].push_back(entry.sequence);
+        m_byCategory[entry.categoryId].push_back(entry.sequence);
+        const qint64 bytes = entryBytes(entry);
+        m_bytes += bytes;
+        MemoryAccounting::allocated(MemoryTag::Logging, bytes);
+    }
+}
+
+void LogStore::clear() {
+    QWriteLocker locker(&m_lock);
+    MemoryAccounting::released(MemoryTag::Logging, m_bytes, quint64(m_count));
+    m_slots.clear();
+    m_head = 0;
+    m_count = 0;
+    m_bytes = 0;
+    for (SequenceRing& ring : m_byLevel) {
+        ring.clear();
+    }
+    for (SequenceRing& ring : m_byCategory) {
+        ring.clear();
+    }
+}
+
+int LogStore::findCategory(const QString& category) const {
+    QReadLocker locker(&m_lock);
+    return m_categoryIds.value(category, -1);
+}
+
+QStringList LogStore::categories() const {
+    QReadLocker locker(&m_lock);
+    return m_categoryNames;
+}
+
+LogPage LogStore::readAfter(quint64 after, int maxEntries, int level, int categoryId) const {
+    QReadLocker locker(&m_lock);
+    
+    LogPage page;
+    page.cursor = after;
+    const quint64 first = m_nextSequence - m_count;
+    const quint64 last = m_nextSequence - 1;
+    if (after + 1 < first) {
+        page.missed = first - 1 - after;
+    }
+    if (level >= LEVELS || categoryId >= m_byCategory.size()) {
+        page.cursor = qMax(after, last);   // Nothing can match
+        return page;
+    }
+    if (maxEntries <= 0) return page;
+    
+    const SequenceRing* index = indexLocked(level, categoryId);
+    if (!index) {
+        quint64 sequence = qMax(after + 1, first);
+        for (; sequence <= last && page.entries.size() < maxEntries; ++sequence) {
+            page.entries.append(atLocked(sequence));
+        }
+        page.cursor = qMax(after, sequence - 1);
+        return page;
+    }
+    
+    // A level as well as a category walks the category's ring and checks
+    const bool checkLevel = level >= 0 && categoryId >= 0;
+    auto it = std::upper_bound(index->begin(), index->end(), after);
+    for (; it != index->end() && page.entries.size() < maxEntries; ++it) {
+        const LogEntry& entry = atLocked(*it);
+        page.cursor = *it;
+        if (checkLevel && static_cast<int>(entry.level) != level) continue;
+        page.entries.append(entry);
+    }
+    if (it == index->end()) {
+        page.cursor = qMax(after, last);   // Read up to the newest
+    }
+    return page;
+}
+
+QList<LogEntry> LogStore::recent(int count, int level, int categoryId) const {
+    QReadLocker locker(&m_lock);
+    
+    QList<LogEntry> result;
+    if (count <= 0 || level >= LEVELS || categoryId >= m_byCategory.size()) return result;
+    
+    const SequenceRing* index = indexLocked(level, categoryId);
+    if (!index) {
+        const int n = qMin(count, m_count);
+        for (quint64 sequence = m_nextSequence - n; sequence < m_nextSequence; ++sequence) {
+            result.append(atLocked(sequence));
+        }
+        return result;
+    }
+    
+    const bool checkLevel = level >= 0 && categoryId >= 0;
+    QVector<quint64> newest;
+    for (auto it = index->rbegin(); it != index->rend() && newest.size() < count; ++it) {
+        if (checkLevel && static_cast<int>(atLocked(*it).level) != level) continue;
+        newest.append(*it);
+    }
+    for (int i = newest.size() - 1; i >= 0; --i) {
+        result.append(atLocked(newest[i]));
+    }
+    return result;
+}
+
+int LogStore::internLocked(const QString& category) {
+    auto it = m_categoryIds.constFind(category);
+    if (it != m_categoryIds.constEnd()) return it.value();
+    
+    const int id = m_categoryNames.size();
+    m_categoryIds.insert(category, id);
+    m_categoryNames.append(category);
+    m_byCategory.append(SequenceRing());
+    return id;
+}
+
+const LogEntry& LogStore::atLocked(quint64 sequence) const {
+    const quint64 first = m_nextSequence - m_count;
+    return m_slots[static_cast<int>((m_head + (sequence - first)) % m_slots.size())];
+}
+
+const LogStore::SequenceRing* LogStore::indexLocked(int level, int categoryId) const {
+    if (categoryId >= 0) return &m_byCategory[categoryId];
+    if (level >= 0) return &m_byLevel[level];
+    return nullptr;
+}
+
+void LogStore::evictOldestLocked() {
+    LogEntry& oldest = m_slots[m_head];
+    // The oldest entry is at the front of both of its index rings
+    m_byLevel[qBound(0, static_cast<int>(oldest.level), LEVELS - 1)].pop_front();
+    m_byCategory[oldest.categoryId].pop_front();
+    const qint64 bytes = entryBytes(oldest);
+    m_bytes -= bytes;
+    MemoryAccounting::released(MemoryTag::Logging, bytes);
+    oldest = LogEntry();
+    m_head = (m_head + 1) % m_slots.size();
+    --m_count;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,121 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <deque>
+
+namespace CounterUAS {
+
+/**
+ * @brief Log level enum
+ */
+enum class LogLevel {
+    Debug = 0,
+    Info,
+    Warning,
+    Error,
+    Critical
+};
+
+/**
+ * @brief Log entry structure
+ */
+struct LogEntry {
+    QDateTime timestamp;
+    LogLevel level;
+    QString category;
+    QString message;
+    QString threadId;
+    quint64 sequence = 0;       // Store order from 1; 0 until stored
+    int categoryId = -1;        // Interned by the store
+};
+
+/**
+ * @brief One read of a LogStore through a cursor
+ */
+struct LogPage {
+    QList<LogEntry> entries;    // Oldest first
+    quint64 cursor = 0;         // Pass as `after` to carry on from here
+    quint64 missed = 0;         // Evicted between the old cursor and the oldest kept
+};
+
+/**
+ * @brief The logger's in-memory entries: a ring with index rings per level
+ * and per category
+ *
+ * Entries are numbered as they are stored, so a reader keeps a cursor, the
+ * last sequence it saw, and asks only for what came after it. Categories
+ * are interned on the way in and each has a ring of the sequences stored
+ * under it, as each level has. A filtered read binary-searches the index
+ * ring for its cursor and walks only the matching entries, with no string
+ * compares. When the ring is full the oldest entry goes, and with it the
+ * front of its level and category rings.
+ *
+ * A read-write lock guards the store and nothing else. Readers share it
+ * and copy at most the entries they asked for. A writer holds it only to
+ * append a batch, never while the logger formats or writes its sinks.
+ */
+class LogStore {
+public:
+    static constexpr int LEVELS = static_cast<int>(LogLevel::Critical) + 1;
+
+    explicit LogStore(int capacity = 10000);
+    ~LogStore();
+
+    LogStore(const LogStore&) = delete;
+    LogStore& operator=(const LogStore&) = delete;
+
+    // Shrinking drops the oldest entries
+    void setCapacity(int capacity);
+    int capacity() const;
+    int size() const;
+    qint64 memoryBytes() const;         // Also accounted under MemoryTag::Logging
+    quint64 lastSequence() const;       // 0 before anything was stored
+
+    // Stamps each entry's sequence and category id, then stores it
+    void append(QList<LogEntry>& batch);
+    void clear();
+
+    // -1 for a category never logged. Ids last the store's lifetime, clear() included
+    int findCategory(const QString& category) const;
+    QStringList categories() const;     // Indexed by id
+
+    // Up to maxEntries stored after sequence `after`, oldest first. level
+    // and categoryId narrow the read; -1 takes any
+    LogPage readAfter(quint64 after, int maxEntries, int level = -1, int categoryId = -1) const;
+    // The newest count entries that match, oldest first
+    QList<LogEntry> recent(int count, int level = -1, int categoryId = -1) const;
+
+    static qint64 entryBytes(const LogEntry& entry);
+
+private:
+    using SequenceRing = std::deque<quint64>;
+
+    int internLocked(const QString& category);
+    const LogEntry& atLocked(quint64 sequence) const;
+    const SequenceRing* indexLocked(int level, int categoryId) const;
+    void evictOldestLocked();
+
+    mutable QReadWriteLock m_lock;
+    QVector<LogEntry> m_slots;          // Grows to m_capacity, then wraps
+    int m_capacity;
+    int m_head = 0;                     // Oldest entry
+    int m_count = 0;
+    quint64 m_nextSequence = 1;
+    qint64 m_bytes = 0;
+
+    SequenceRing m_byLevel[LEVELS];
+    QVector<SequenceRing> m_byCategory; // By category id
+    QHash<QString, int> m_categoryIds;
+    QStringList m_categoryNames;
+};
+
+} // namespace CounterUAS
+
+#endif // LOGSTORE_H
@@ -3,6 +3,7 @@
 #include <QTextStream>
 #include <QThread>
 #include <iostream>
+#include <limits>
 
 namespace CounterUAS {
 
@@ -11,9 +12,13 @@ Logger& Logger::instance() {
     return instance;
 }
 
-Logger::Logger() {}
+Logger::Logger() {
+    qRegisterMetaType<LogEntry>("CounterUAS::LogEntry");
+    qRegisterMetaType<QList<LogEntry>>("QList<CounterUAS::LogEntry>");
+}
 
 Logger::~Logger() {
+    setAsync(false);
     if (m_logFile) {
         m_logFile->close();
         delete m_logFile;
@@ -62,81 +67,189 @@ void Logger::critical(const QString& category, const QString& message) {
 }
 
 void Logger::log(LogLevel level, const QString& category, const QString& message) {
-    if (level < m_minLevel) return;
+    if (!isEnabled(level)) return;
     
-    LogEntry entry;
-    entry.timestamp = QDateTime::currentDateTime();
-    entry.level = level;
-    entry.category = category;
-    entry.message = message;
-    entry.threadId = QString::number(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    const qint64 timestampMs = QDateTime::currentMSecsSinceEpoch();
+    const quintptr threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
     
-    {
-        QMutexLocker locker(&m_mutex);
-        
-        m_logs.append(entry);
-        while (m_logs.size() > m_maxEntries) {
-            m_logs.removeFirst();
+    if (m_async.load(std::memory_order_acquire)) {
+        StagedEntry staged;
+        staged.timestampMs = timestampMs;
+        staged.level = level;
+        staged.category = category;
+        staged.message = message;
+        staged.threadId = threadId;
+        if (!m_ring->tryPush(std::move(staged))) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            m_droppedTotal.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
-        
-        if (m_logToConsole) {
-            QString formatted = formatEntry(entry);
-            if (level >= LogLevel::Error) {
-                std::cerr << formatted.toStdString() << std::endl;
-            } else {
-                std::cout << formatted.toStdString() << std::endl;
-            }
-        }
-        
-        if (m_logToFile && m_logFile) {
-            writeToFile(entry);
+        if (level >= LogLevel::Error) {
+            m_wake.wakeOne();   // Get errors out without waiting for the interval
         }
+        return;
+    }
+    
+    // Anything staged just before async mode was turned off goes first
+    if (m_ring) {
+        drainStaged();
     }
     
-    emit logAdded(entry);
+    QList<LogEntry> batch;
+    batch.append(makeEntry(timestampMs, level, category, message, threadId));
+    writeBatch(batch);
+    emit logAdded(batch.first());
 }
 
-QList<LogEntry> Logger::recentLogs(int count) const {
-    QMutexLocker locker(&m_mutex);
+void Logger::setAsync(bool enable) {
+    if (enable == (m_writer != nullptr)) return;
     
-    if (count >= m_logs.size()) {
-        return m_logs;
+    if (enable) {
+        if (!m_ring) {
+            m_ring.reset(new BoundedQueue<StagedEntry>(static_cast<std::size_t>(m_ringCapacity)));
+        }
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            m_stopping = false;
+        }
+        m_writer = QThread::create([this]() { writerLoop(); });
+        m_writer->setObjectName("LogWriter");
+        m_writer->start(QThread::LowPriority);
+        m_async.store(true, std::memory_order_release);
+        return;
     }
     
-    return m_logs.mid(m_logs.size() - count);
+    m_async.store(false, std::memory_order_release);
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    m_writer->wait();
+    delete m_writer;
+    m_writer = nullptr;
+    drainStaged();
 }
 
-QList<LogEntry> Logger::logsByLevel(LogLevel level) const {
-    QMutexLocker locker(&m_mutex);
-    
-    QList<LogEntry> result;
-    for (const auto& entry : m_logs) {
-        if (entry.level == level) {
-            result.append(entry);
+void Logger::flush() {
+    if (m_ring) {
+        drainStaged();
+    }
+}
+
+void Logger::writerLoop() {
+    forever {
+        bool stopping;
+        {
+            QMutexLocker locker(&m_wakeMutex);
+            if (!m_stopping) {
+                m_wake.wait(&m_wakeMutex, WRITER_INTERVAL_MS);
+            }
+            stopping = m_stopping;
         }
+        drainStaged();
+        if (stopping) break;
     }
-    return result;
 }
 
-QList<LogEntry> Logger::logsByCategory(const QString& category) const {
+void Logger::drainStaged() {
+    QList<LogEntry> batch;
+    StagedEntry staged;
+    while (m_ring->tryPop(staged)) {
+        batch.append(makeEntry(staged.timestampMs, staged.level, staged.category,
+                               staged.message, staged.threadId));
+    }
+    
+    const quint64 dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        batch.append(makeEntry(QDateTime::currentMSecsSinceEpoch(), LogLevel::Warning, "Logger",
+                               QString("%1 entries dropped, staging ring full").arg(dropped),
+                               reinterpret_cast<quintptr>(QThread::currentThreadId())));
+    }
+    if (batch.isEmpty()) return;
+    
+    writeBatch(batch);
+    emit logsAdded(batch);
+}
+
+LogEntry Logger::makeEntry(qint64 timestampMs, LogLevel level, const QString& category,
+                           const QString& message, quintptr threadId) {
+    LogEntry entry;
+    entry.timestamp = QDateTime::fromMSecsSinceEpoch(timestampMs);
+    entry.level = level;
+    entry.category = category;
+    entry.message = message;
+    entry.threadId = QString::number(threadId);
+    return entry;
+}
+
+void Logger::writeBatch(QList<LogEntry>& batch) {
+    m_store.append(batch);   // Numbers the entries for the signals too
+    
     QMutexLocker locker(&m_mutex);
+    const bool toFile = m_logToFile && m_logFile && m_logFile->isOpen();
+    if (!m_logToConsole && !toFile) return;
     
-    QList<LogEntry> result;
-    for (const auto& entry : m_logs) {
-        if (entry.category == category) {
-            result.append(entry);
+    // One write and one flush per sink for the whole batch
+    QByteArray out;
+    QByteArray err;
+    QByteArray file;
+    for (const LogEntry& entry : batch) {
+        const QByteArray line = formatEntry(entry).toUtf8() + '\n';
+        if (m_logToConsole) {
+            (entry.level >= LogLevel::Error ? err : out) += line;
+        }
+        if (toFile) {
+            file += line;
         }
     }
-    return result;
+    if (!out.isEmpty()) {
+        std::cout.write(out.constData(), out.size());
+        std::cout.flush();
+    }
+    if (!err.isEmpty()) {
+        std::cerr.write(err.constData(), err.size());
+        std::cerr.flush();
+    }
+    if (!file.isEmpty()) {
+        m_logFile->write(file);
+        m_logFile->flush();
+    }
 }
 
-void Logger::clearLogs() {
-    QMutexLocker locker(&m_mutex);
-    m_logs.clear();
+QList<LogEntry> Logger::recentLogs(int count) const {
+    return m_store.recent(count);
+}
+
+QList<LogEntry> Logger::logsByLevel(LogLevel level) const {
+    return m_store.readAfter(0, std::numeric_limits<int>::max(), static_cast<int>(level)).entries;
+}
+
+QList<LogEntry> Logger::logsByCategory(const QString& category) const {
+    const int categoryId = m_store.findCategory(category);
+    if (categoryId < 0) return QList<LogEntry>();
+    return m_store.readAfter(0, std::numeric_limits<int>::max(), -1, categoryId).entries;
+}
+
+LogPage Logger::logsAfter(quint64 after, int maxEntries, int level, const QString& category) const {
+    int categoryId = -1;
+    if (!category.isEmpty()) {
+        // Taken first: a category logged for the first time after it only
+        // has entries past it
+        const quint64 last = m_store.lastSequence();
+        categoryId = m_store.findCategory(category);
+        if (categoryId < 0) {
+            LogPage page;
+            page.cursor = qMax(after, last);
+            return page;
+        }
+    }
+    return m_store.readAfter(after, maxEntries, level, categoryId);
 }
 
 bool Logger::exportToFile(const QString& path) const {
-    QMutexLocker locker(&m_mutex);
+    // A copy, so the file is written without holding up the loggers
+    const QList<LogEntry> entries = m_store.readAfter(0, std::numeric_limits<int>::max()).entries;
     
     QFile file(path);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -144,7 +257,7 @@ bool Logger::exportToFile(const QString& path) const {
     }
     
     QTextStream stream(&file);
-    for (const auto& entry : m_logs) {
+    for (const auto& entry : entries) {
         stream << formatEntry(entry) << "\n";
     }
     
@@ -152,14 +265,6 @@ bool Logger::exportToFile(const QString& path) const {
     return true;
 }
 
-void Logger::writeToFile(const LogEntry& entry) {
-    if (!m_logFile || !m_logFile->isOpen()) return;
-    
-    QTextStream stream(m_logFile);
-    stream << formatEntry(entry) << "\n";
-    stream.flush();
-}
-
 QString Logger::formatEntry(const LogEntry& entry) const {
     return QString("[%1] [%2] [%3] %4")
                .arg(entry.timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz"))
@@ -5,35 +5,51 @@
 #include <QString>
 #include <QFile>
 #include <QMutex>
+#include <QWaitCondition>
 #include <QDateTime>
 #include <QList>
+#include <atomic>
+#include <memory>
+#include "utils/BoundedQueue.h"
+#include "utils/LogStore.h"
 
-namespace CounterUAS {
+class QThread;
 
-/**
- * @brief Log level enum
- */
-enum class LogLevel {
-    Debug = 0,
-    Info,
-    Warning,
-    Error,
-    Critical
-};
+// Levels below this are compiled out of the CUAS_LOG_* macros, message
+// expression and all; 0 keeps Debug
+#ifndef CUAS_LOG_MIN_LEVEL
+#define CUAS_LOG_MIN_LEVEL 0
+#endif
 
-/**
- * @brief Log entry structure
- */
-struct LogEntry {
-    QDateTime timestamp;
-    LogLevel level;
-    QString category;
-    QString message;
-    QString threadId;
-};
+// Evaluate the message only when the level is compiled in and enabled
+#define CUAS_LOG(level, category, message) \
+    do { \
+        if (::CounterUAS::Logger::compiledIn(level) && \
+            ::CounterUAS::Logger::instance().isEnabled(level)) { \
+            ::CounterUAS::Logger::instance().log(level, category, message); \
+        } \
+    } while (false)
+#define CUAS_LOG_DEBUG(category, message) CUAS_LOG(::CounterUAS::LogLevel::Debug, category, message)
+#define CUAS_LOG_INFO(category, message) CUAS_LOG(::CounterUAS::LogLevel::Info, category, message)
+#define CUAS_LOG_WARNING(category, message) CUAS_LOG(::CounterUAS::LogLevel::Warning, category, message)
+#define CUAS_LOG_ERROR(category, message) CUAS_LOG(::CounterUAS::LogLevel::Error, category, message)
+
+namespace CounterUAS {
 
 /**
  * @brief Singleton logger class
+ *
+ * By default log() formats and writes the entry on the calling thread. In
+ * async mode it only stamps the entry and pushes it onto a lock-free ring;
+ * a writer thread of its own formats whatever has been staged, writes it
+ * to the console and file in one go and emits logsAdded() once per batch.
+ * A full ring drops entries rather than blocking the caller, and the
+ * writer reports how many were lost.
+ *
+ * The in-memory entries are a LogStore under its own lock, apart from the
+ * sinks. A viewer keeps the sequence of the last entry it has and calls
+ * logsAfter() for what is newer. That read copies at most the page asked
+ * for, and it never waits on a file or the console.
  */
 class Logger : public QObject {
     Q_OBJECT
@@ -41,13 +57,31 @@ class Logger : public QObject {
 public:
     static Logger& instance();
     
+    static constexpr bool compiledIn(LogLevel level) {
+        return static_cast<int>(level) >= CUAS_LOG_MIN_LEVEL;
+    }
+    
     // Configuration
-    void setLogLevel(LogLevel level) { m_minLevel = level; }
-    LogLevel logLevel() const { return m_minLevel; }
+    void setLogLevel(LogLevel level) { m_minLevel.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel logLevel() const { return static_cast<LogLevel>(m_minLevel.load(std::memory_order_relaxed)); }
+    bool isEnabled(LogLevel level) const {
+        return compiledIn(level) && static_cast<int>(level) >= m_minLevel.load(std::memory_order_relaxed);
+    }
+    
+    // Switch from one thread; turning it off writes what is staged first
+    void setAsync(bool enable);
+    bool isAsync() const { return m_async.load(std::memory_order_relaxed); }
+    void setAsyncCapacity(int entries) { m_ringCapacity = qMax(64, entries); }  // Before the first setAsync(true)
+    // Writes everything staged so far on the calling thread
+    void flush();
+    quint64 droppedCount() const { return m_droppedTotal.load(std::memory_order_relaxed); }
     
     void setLogToFile(bool enable, const QString& path = QString());
     void setLogToConsole(bool enable) { m_logToConsole = enable; }
-    void setMaxLogEntries(int count) { m_maxEntries = count; }
+    // Trims the in-memory entries at once; the log file is unaffected
+    void setMaxLogEntries(int count) { m_store.setCapacity(count); }
+    int maxLogEntries() const { return m_store.capacity(); }
+    qint64 memoryBytes() const { return m_store.memoryBytes(); }   // Of the in-memory entries
     
     // Logging methods
     void debug(const QString& category, const QString& message);
@@ -62,13 +96,22 @@ public:
     QList<LogEntry> recentLogs(int count = 100) const;
     QList<LogEntry> logsByLevel(LogLevel level) const;
     QList<LogEntry> logsByCategory(const QString& category) const;
-    void clearLogs();
+    // Up to maxEntries stored after sequence `after`, oldest first; level is
+    // a LogLevel as int and category a name, -1 and empty taking any
+    LogPage logsAfter(quint64 after, int maxEntries = 256, int level = -1,
+                      const QString& category = QString()) const;
+    quint64 lastLogSequence() const { return m_store.lastSequence(); }
+    const LogStore& logStore() const { return m_store; }
+    void clearLogs() { m_store.clear(); }
     
     // Export
     bool exportToFile(const QString& path) const;
     
 signals:
+    // Synchronous mode, from the logging thread
     void logAdded(const LogEntry& entry);
+    // Async mode, from the writer thread, oldest first
+    void logsAdded(const QList<LogEntry>& entries);
     
 private:
     Logger();
@@ -76,20 +119,46 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
     
-    void writeToFile(const LogEntry& entry);
+    // What log() stages in async mode; formatted on the writer thread
+    struct StagedEntry {
+        qint64 timestampMs = 0;
+        LogLevel level = LogLevel::Info;
+        QString category;
+        QString message;
+        quintptr threadId = 0;
+    };
+    static constexpr int WRITER_INTERVAL_MS = 50;
+    
+    static LogEntry makeEntry(qint64 timestampMs, LogLevel level, const QString& category,
+                              const QString& message, quintptr threadId);
+    void writerLoop();
+    void drainStaged();
+    void writeBatch(QList<LogEntry>& batch);
     QString formatEntry(const LogEntry& entry) const;
     QString levelString(LogLevel level) const;
     
-    mutable QMutex m_mutex;
-    QList<LogEntry> m_logs;
+    mutable QMutex m_mutex;             // The sinks
+    LogStore m_store;
+    
+    std::atomic<int> m_minLevel{static_cast<int>(LogLevel::Info)};
+    std::atomic<bool> m_async{false};
+    // Never freed once made, so a log() racing setAsync(false) stays safe
+    std::unique_ptr<BoundedQueue<StagedEntry>> m_ring;
+    int m_ringCapacity = 8192;
+    std::atomic<quint64> m_dropped{0};      // Since the writer last reported
+    std::atomic<quint64> m_droppedTotal{0};
+    QThread* m_writer = nullptr;
+    QMutex m_wakeMutex;                 // Guards m_stopping for the wait
+    QWaitCondition m_wake;
+    bool m_stopping = false;
     
-    LogLevel m_minLevel = LogLevel::Info;
     bool m_logToConsole = true;
     bool m_logToFile = false;
     QFile* m_logFile = nullptr;
-    int m_maxEntries = 10000;
 };
 
 } // namespace CounterUAS
 
+Q_DECLARE_METATYPE(CounterUAS::LogEntry)
+
 #endif // LOGGER_H
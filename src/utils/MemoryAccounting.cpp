@@ -0,0 +1,113 @@
+#include "utils/MemoryAccounting.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/TimeUtils.h"
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace CounterUAS {
+
+MemoryAccounting::Counters MemoryAccounting::s_counters[MemoryAccounting::TAG_COUNT];
+
+namespace {
+
+struct Sampler {
+    QMutex mutex;
+    qint64 lastNs = 0;
+    quint64 lastAllocations[MemoryAccounting::TAG_COUNT] = {};
+    bool exported = false;
+    MetricGauge* live[MemoryAccounting::TAG_COUNT] = {};
+    MetricGauge* peak[MemoryAccounting::TAG_COUNT] = {};
+    MetricGauge* rate[MemoryAccounting::TAG_COUNT] = {};
+    MetricCounter* allocations[MemoryAccounting::TAG_COUNT] = {};
+};
+
+Sampler& sampler() {
+    static Sampler s;
+    return s;
+}
+
+} // namespace
+
+qint64 MemoryAccounting::totalLiveBytes() {
+    qint64 total = 0;
+    for (const Counters& c : s_counters) {
+        total += c.live.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MemoryTagStats MemoryAccounting::stats(MemoryTag tag) {
+    const Counters& c = counters(tag);
+    MemoryTagStats stats;
+    stats.tag = tag;
+    stats.liveBytes = c.live.load(std::memory_order_relaxed);
+    stats.peakBytes = qMax(stats.liveBytes, c.peak.load(std::memory_order_relaxed));
+    stats.allocations = c.allocations.load(std::memory_order_relaxed);
+    stats.releases = c.releases.load(std::memory_order_relaxed);
+    stats.allocationsPerSecond = c.rate.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MemoryAccounting::sample() {
+    Sampler& s = sampler();
+    QMutexLocker locker(&s.mutex);
+
+    if (!s.exported) {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        for (int i = 0; i < TAG_COUNT; ++i) {
+            const MetricLabels labels = {{"subsystem", tagKey(static_cast<MemoryTag>(i))}};
+            s.live[i] = registry.gauge("cuas_memory_live_bytes", "Bytes a subsystem has allocated and not freed", labels);
+            s.peak[i] = registry.gauge("cuas_memory_peak_bytes", "Highest live bytes of a subsystem", labels);
+            s.rate[i] = registry.gauge("cuas_memory_allocation_rate", "Allocations per second of a subsystem", labels);
+            s.allocations[i] = registry.counter("cuas_memory_allocations_total", "Allocations by a subsystem", labels);
+        }
+        s.exported = true;
+    }
+
+    const qint64 nowNs = TimeUtils::monotonicNs();
+    const double seconds = s.lastNs > 0 ? (nowNs - s.lastNs) / 1e9 : 0.0;
+    s.lastNs = nowNs;
+
+    for (int i = 0; i < TAG_COUNT; ++i) {
+        const MemoryTagStats current = stats(static_cast<MemoryTag>(i));
+        if (seconds > 0.0) {
+            const double rate = (current.allocations - s.lastAllocations[i]) / seconds;
+            s_counters[i].rate.store(rate, std::memory_order_relaxed);
+            s.rate[i]->set(rate);
+        }
+        s.lastAllocations[i] = current.allocations;
+        s.live[i]->set(static_cast<double>(current.liveBytes));
+        s.peak[i]->set(static_cast<double>(current.peakBytes));
+        s.allocations[i]->setTotal(current.allocations);
+    }
+}
+
+void MemoryAccounting::resetPeaks() {
+    for (Counters& c : s_counters) {
+        c.peak.store(c.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+const char* MemoryAccounting::tagKey(MemoryTag tag) {
+    switch (tag) {
+    case MemoryTag::Tracks: return "tracks";
+    case MemoryTag::VideoFrames: return "video_frames";
+    case MemoryTag::NetworkBuffers: return "network_buffers";
+    case MemoryTag::Logging: return "logging";
+    case MemoryTag::UiCaches: return "ui_caches";
+    default: return "";
+    }
+}
+
+const char* MemoryAccounting::tagName(MemoryTag tag) {
+    switch (tag) {
+    case MemoryTag::Tracks: return "Tracks";
+    case MemoryTag::VideoFrames: return "Video frames";
+    case MemoryTag::NetworkBuffers: return "Network buffers";
+    case MemoryTag::Logging: return "Logging";
+    case MemoryTag::UiCaches: return "UI caches";
+    default: return "";
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,167 @@
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace CounterUAS {
+
+/**
+ * @brief Subsystems whose allocations are accounted separately
+ */
+enum class MemoryTag : quint8 {
+    Tracks = 0,         // Track slab chunks and position history
+    VideoFrames,        // Pooled frame buffers
+    NetworkBuffers,     // Receive rings and their scratch
+    Logging,            // In-memory log entries
+    UiCaches,           // Decoded map tiles and the like
+    Count
+};
+
+/**
+ * @brief One subsystem's accounting, as last read
+ */
+struct MemoryTagStats {
+    MemoryTag tag = MemoryTag::Tracks;
+    qint64 liveBytes = 0;
+    qint64 peakBytes = 0;               // Since start or resetPeaks()
+    quint64 allocations = 0;
+    quint64 releases = 0;
+    double allocationsPerSecond = 0.0;  // Over the last sample() interval
+};
+
+/**
+ * @brief Live bytes, peak and allocation rate per subsystem
+ *
+ * Subsystems report their own allocations under a tag: allocated() and
+ * released() for discrete blocks, a MemoryAccount for an owner whose size
+ * it already knows, or TaggedAllocator for standard containers. There is
+ * no global operator new hook, so only what is reported is counted, but
+ * what is reported costs two relaxed atomic adds on a cache line of its
+ * own per tag, and a compare-and-swap only when a new peak is set. That is
+ * cheap enough to leave on in production.
+ *
+ * sample() turns the allocation counts into rates and exports everything
+ * to the MetricsRegistry; the MemoryGovernor calls it on each poll and
+ * takes the accounted total as its resident size where the platform gives
+ * none.
+ */
+class MemoryAccounting {
+public:
+    static constexpr int TAG_COUNT = static_cast<int>(MemoryTag::Count);
+
+    static void allocated(MemoryTag tag, qint64 bytes, quint64 count = 1) noexcept {
+        Counters& c = counters(tag);
+        c.allocations.fetch_add(count, std::memory_order_relaxed);
+        const qint64 live = c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        qint64 peak = c.peak.load(std::memory_order_relaxed);
+        while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+    static void released(MemoryTag tag, qint64 bytes, quint64 count = 1) noexcept {
+        Counters& c = counters(tag);
+        c.releases.fetch_add(count, std::memory_order_relaxed);
+        c.live.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    static qint64 liveBytes(MemoryTag tag) { return counters(tag).live.load(std::memory_order_relaxed); }
+    static qint64 totalLiveBytes();
+    static MemoryTagStats stats(MemoryTag tag);
+
+    // Rates over the time since the previous call, and the metrics export.
+    // Any thread; concurrent calls are serialised
+    static void sample();
+    // Peaks restart from the live bytes
+    static void resetPeaks();
+
+    static const char* tagKey(MemoryTag tag);      // For metric labels
+    static const char* tagName(MemoryTag tag);     // For display
+
+private:
+    struct alignas(64) Counters {
+        std::atomic<qint64> live{0};
+        std::atomic<qint64> peak{0};
+        std::atomic<quint64> allocations{0};
+        std::atomic<quint64> releases{0};
+        std::atomic<double> rate{0.0};
+    };
+
+    static Counters& counters(MemoryTag tag) noexcept { return s_counters[static_cast<int>(tag)]; }
+
+    static Counters s_counters[TAG_COUNT];
+};
+
+/**
+ * @brief What one owner holds under a tag, kept up to date by the owner
+ *
+ * For owners that already know their size, a ring or a cache: set() moves
+ * the tag's live bytes by the difference and counts an allocation when the
+ * size grows. Not synchronised itself; one thread sets it, as the owner's
+ * size is written. A copy accounts the same bytes again, as a copied
+ * buffer would; destruction releases them.
+ */
+class MemoryAccount {
+public:
+    explicit MemoryAccount(MemoryTag tag) : m_tag(tag) {}
+    MemoryAccount(const MemoryAccount& other) : m_tag(other.m_tag) { set(other.m_bytes); }
+    MemoryAccount& operator=(const MemoryAccount& other) {
+        if (this != &other) {
+            set(0);
+            m_tag = other.m_tag;
+            set(other.m_bytes);
+        }
+        return *this;
+    }
+    ~MemoryAccount() { set(0); }
+
+    void set(qint64 bytes) {
+        if (bytes > m_bytes) {
+            MemoryAccounting::allocated(m_tag, bytes - m_bytes);
+        } else if (bytes < m_bytes) {
+            MemoryAccounting::released(m_tag, m_bytes - bytes, bytes == 0 ? 1 : 0);
+        }
+        m_bytes = bytes;
+    }
+    qint64 bytes() const { return m_bytes; }
+    MemoryTag tag() const { return m_tag; }
+
+private:
+    MemoryTag m_tag;
+    qint64 m_bytes = 0;
+};
+
+/**
+ * @brief Standard allocator that accounts each block under Tag
+ */
+template <typename T, MemoryTag Tag>
+struct TaggedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = TaggedAllocator<U, Tag>; };
+
+    TaggedAllocator() noexcept = default;
+    template <typename U>
+    TaggedAllocator(const TaggedAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+        MemoryAccounting::allocated(Tag, qint64(n * sizeof(T)));
+        return p;
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        MemoryAccounting::released(Tag, qint64(n * sizeof(T)));
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const TaggedAllocator<U, Tag>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const TaggedAllocator<U, Tag>&) const noexcept { return false; }
+};
+
+} // namespace CounterUAS
+
+#endif // MEMORYACCOUNTING_H
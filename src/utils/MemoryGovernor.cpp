@@ -0,0 +1,305 @@
+#include "utils/MemoryGovernor.h"
+#include "utils/Logger.h"
+#include "utils/MemoryAccounting.h"
+#include "utils/MetricsRegistry.h"
+#include <QFile>
+#include <QMutexLocker>
+#include <algorithm>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr qint64 MB = 1024 * 1024;
+
+#if defined(Q_OS_LINUX)
+// First number in a small /proc or /sys file; 0 if absent or not a number
+qint64 readNumber(const char* path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return 0;
+    bool ok = false;
+    const qint64 value = file.readAll().trimmed().split(' ').value(0).toLongLong(&ok);
+    return ok ? value : 0;
+}
+#endif
+
+} // namespace
+
+MemoryGovernor& MemoryGovernor::instance() {
+    static MemoryGovernor governor;
+    return governor;
+}
+
+MemoryGovernor::MemoryGovernor(QObject* parent)
+    : QObject(parent)
+    , m_detectedCeiling(detectCeiling())
+    , m_pollTimer(this, [this]() { poll(); })
+{
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_residentGauge = registry.gauge("cuas_memory_resident_bytes", "Resident size of the process");
+    m_ceilingGauge = registry.gauge("cuas_memory_ceiling_bytes", "Memory ceiling the governor sheds against");
+}
+
+MemoryGovernor::~MemoryGovernor() {
+    m_pollTimer.stop();
+    QMutexLocker locker(&m_mutex);
+    for (const Consumer& consumer : qAsConst(m_consumers)) {
+        QObject::disconnect(consumer.guard);
+    }
+}
+
+void MemoryGovernor::setConfig(const MemoryGovernorConfig& config) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_config = config;
+        m_config.lowWaterPercent = qMin(m_config.lowWaterPercent, m_config.highWaterPercent);
+        m_config.criticalPercent = qMax(m_config.criticalPercent, m_config.highWaterPercent);
+    }
+    m_pollTimer.setInterval(qMax(10, config.pollMs));
+}
+
+MemoryGovernorConfig MemoryGovernor::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+MemoryGovernor::ConsumerId MemoryGovernor::registerConsumer(QObject* context, const QString& name, int shedOrder,
+                                                            qint64 budgetBytes, UsageProbe usage,
+                                                            ShedFunction shed) {
+    if (!context) return 0;
+
+    Consumer consumer;
+    consumer.context = context;
+    consumer.name = name;
+    consumer.shedOrder = shedOrder;
+    consumer.budgetBytes = qMax<qint64>(0, budgetBytes);
+    consumer.usage = std::move(usage);
+    consumer.shed = std::move(shed);
+
+    QMutexLocker locker(&m_mutex);
+    const ConsumerId id = m_nextId++;
+    consumer.guard = QObject::connect(context, &QObject::destroyed, [this, id]() { unregisterConsumer(id); });
+    m_consumers.insert(id, std::move(consumer));
+    return id;
+}
+
+void MemoryGovernor::unregisterConsumer(ConsumerId id) {
+    QMetaObject::Connection guard;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_consumers.find(id);
+        if (it == m_consumers.end()) return;
+        guard = it->guard;
+        m_consumers.erase(it);
+    }
+    QObject::disconnect(guard);
+}
+
+void MemoryGovernor::start() {
+    m_pollTimer.setInterval(qMax(10, config().pollMs));
+    m_pollTimer.start();
+    Logger::instance().info("MemoryGovernor",
+        QString("Shedding against a ceiling of %1 MB").arg(ceilingBytes() / MB));
+}
+
+void MemoryGovernor::stop() {
+    m_pollTimer.stop();
+}
+
+void MemoryGovernor::setResidentProbe(UsageProbe probe) {
+    QMutexLocker locker(&m_mutex);
+    m_residentProbe = std::move(probe);
+}
+
+void MemoryGovernor::poll() {
+    MemoryPressure before;
+    MemoryPressure after = MemoryPressure::Normal;
+    qint64 resident = 0;
+    qint64 ceiling = 0;
+    MemoryAccounting::sample();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.polls++;
+
+        qint64 accounted = 0;
+        for (Consumer& consumer : m_consumers) {
+            consumer.usageBytes = consumer.usage ? qMax<qint64>(0, consumer.usage()) : 0;
+            accounted += consumer.usageBytes;
+        }
+        m_resident = m_residentProbe ? m_residentProbe() : processResident();
+        if (m_resident <= 0) m_resident = qMax(accounted, MemoryAccounting::totalLiveBytes());
+        resident = m_resident;
+
+        const QVector<ConsumerId> order = orderLocked();
+        const int n = order.size();
+        ceiling = m_config.ceilingBytes > 0 ? m_config.ceilingBytes : m_detectedCeiling;
+        if (ceiling > 0 && n > 0) {
+            const qint64 percent = resident * 100 / ceiling;
+            if (percent >= m_config.criticalPercent) {
+                m_depth = 2 * n;
+            } else if (percent >= m_config.highWaterPercent) {
+                m_depth++;
+            } else if (percent < m_config.lowWaterPercent) {
+                m_depth--;
+            }
+        } else {
+            m_depth = 0;
+        }
+        m_depth = qBound(0, m_depth, 2 * n);    // Consumers may have gone since
+
+        for (int i = 0; i < n; ++i) {
+            Consumer& consumer = m_consumers[order[i]];
+            MemoryPressure level = m_depth > n + i ? MemoryPressure::Critical
+                                 : m_depth > i     ? MemoryPressure::Elevated
+                                                   : MemoryPressure::Normal;
+            if (level == MemoryPressure::Normal && consumer.budgetBytes > 0 &&
+                consumer.usageBytes > consumer.budgetBytes) {
+                level = MemoryPressure::Elevated;
+            }
+            applyLocked(consumer, level);
+            after = qMax(after, level);
+        }
+        before = m_pressure;
+        m_pressure = after;
+        exportLocked();
+    }
+
+    if (after != before) {
+        const QString message = QString("Memory pressure %1: %2 of %3 MB resident")
+                                    .arg(pressureKey(after)).arg(resident / MB).arg(ceiling / MB);
+        if (after > before) {
+            Logger::instance().warning("MemoryGovernor", message);
+        } else {
+            Logger::instance().info("MemoryGovernor", message);
+        }
+        emit pressureChanged(after);
+    }
+}
+
+void MemoryGovernor::applyLocked(Consumer& consumer, MemoryPressure level) {
+    if (level == consumer.pressure) return;
+    if (level > consumer.pressure) {
+        m_stats.sheds++;
+    } else {
+        m_stats.restores++;
+    }
+    consumer.pressure = level;
+    if (!consumer.shed) return;
+
+    // Posted under m_mutex: the context cannot finish destruction meanwhile
+    ShedFunction shed = consumer.shed;
+    QMetaObject::invokeMethod(consumer.context, [shed, level]() { shed(level); }, Qt::QueuedConnection);
+}
+
+QVector<MemoryGovernor::ConsumerId> MemoryGovernor::orderLocked() const {
+    QVector<ConsumerId> order;
+    order.reserve(m_consumers.size());
+    for (auto it = m_consumers.constBegin(); it != m_consumers.constEnd(); ++it) {
+        order.append(it.key());
+    }
+    std::sort(order.begin(), order.end(), [this](ConsumerId a, ConsumerId b) {
+        const int orderA = m_consumers.constFind(a)->shedOrder;
+        const int orderB = m_consumers.constFind(b)->shedOrder;
+        return orderA != orderB ? orderA < orderB : a < b;
+    });
+    return order;
+}
+
+void MemoryGovernor::exportLocked() {
+    m_residentGauge->set(static_cast<double>(m_resident));
+    m_ceilingGauge->set(static_cast<double>(m_config.ceilingBytes > 0 ? m_config.ceilingBytes : m_detectedCeiling));
+
+    // Consumers sharing a name, one per camera say, are exported as one
+    QHash<QString, qint64> usage;
+    for (const Consumer& consumer : qAsConst(m_consumers)) {
+        usage[consumer.name] += consumer.usageBytes;
+    }
+    for (auto it = m_usageGauges.begin(); it != m_usageGauges.end(); ++it) {
+        if (!usage.contains(it.key())) it.value()->set(0.0);
+    }
+    for (auto it = usage.constBegin(); it != usage.constEnd(); ++it) {
+        MetricGauge*& gauge = m_usageGauges[it.key()];
+        if (!gauge) {
+            gauge = MetricsRegistry::instance().gauge("cuas_memory_consumer_bytes",
+                                                      "Memory held by a governed consumer",
+                                                      {{"consumer", it.key()}});
+        }
+        gauge->set(static_cast<double>(it.value()));
+    }
+}
+
+qint64 MemoryGovernor::residentBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_resident;
+}
+
+qint64 MemoryGovernor::ceilingBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config.ceilingBytes > 0 ? m_config.ceilingBytes : m_detectedCeiling;
+}
+
+MemoryPressure MemoryGovernor::pressure() const {
+    QMutexLocker locker(&m_mutex);
+    return m_pressure;
+}
+
+QVector<MemoryConsumerStatus> MemoryGovernor::consumers() const {
+    QMutexLocker locker(&m_mutex);
+    QVector<MemoryConsumerStatus> result;
+    for (ConsumerId id : orderLocked()) {
+        const Consumer& consumer = *m_consumers.constFind(id);
+        MemoryConsumerStatus status;
+        status.name = consumer.name;
+        status.shedOrder = consumer.shedOrder;
+        status.budgetBytes = consumer.budgetBytes;
+        status.usageBytes = consumer.usageBytes;
+        status.pressure = consumer.pressure;
+        result.append(status);
+    }
+    return result;
+}
+
+MemoryGovernor::Stats MemoryGovernor::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+const char* MemoryGovernor::pressureKey(MemoryPressure pressure) {
+    switch (pressure) {
+    case MemoryPressure::Normal: return "normal";
+    case MemoryPressure::Elevated: return "elevated";
+    case MemoryPressure::Critical: return "critical";
+    default: return "";
+    }
+}
+
+qint64 MemoryGovernor::detectCeiling() {
+#if defined(Q_OS_LINUX)
+    // A container's limit is the one the OOM killer enforces
+    qint64 ceiling = qint64(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+    for (const char* path : {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"}) {
+        const qint64 limit = readNumber(path);     // "max" reads as 0
+        if (limit > 0 && (ceiling <= 0 || limit < ceiling)) ceiling = limit;
+    }
+    return qMax<qint64>(0, ceiling);
+#else
+    return 0;
+#endif
+}
+
+qint64 MemoryGovernor::processResident() {
+#if defined(Q_OS_LINUX)
+    QFile file("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return 0;
+    const qint64 pages = file.readAll().split(' ').value(1).toLongLong();
+    return pages * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+} // namespace CounterUAS
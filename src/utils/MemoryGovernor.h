@@ -0,0 +1,165 @@
+#ifndef MEMORYGOVERNOR_H
+#define MEMORYGOVERNOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "utils/TimerService.h"
+
+namespace CounterUAS {
+
+class MetricGauge;
+
+/**
+ * @brief How hard a memory consumer is asked to economise
+ */
+enum class MemoryPressure : quint8 {
+    Normal = 0,         // Configured sizes
+    Elevated,           // Shed what is cheap to rebuild
+    Critical            // Keep only what the mission needs
+};
+
+// Where the built-in consumers come in the shed order, first to go first
+namespace MemoryShedOrder {
+constexpr int MapTiles = 10;        // Decoded PPI map tiles, reloaded from the tile store
+constexpr int Thumbnails = 20;      // Engagement snapshot thumbnails, recut from the JPEG
+constexpr int LogView = 30;         // In-memory log entries; the log file keeps them all
+constexpr int TrackHistory = 40;    // Track position history, which merging compares
+constexpr int PreBuffer = 50;       // Pre-event video, evidence once an event fires
+}
+
+/**
+ * @brief Memory ceiling and when to start and stop shedding
+ */
+struct MemoryGovernorConfig {
+    qint64 ceilingBytes = 0;        // 0: the cgroup limit, or else physical memory
+    int highWaterPercent = 85;      // Above it one more consumer sheds each poll
+    int lowWaterPercent = 75;       // Below it one consumer is restored each poll
+    int criticalPercent = 95;       // Above it every consumer goes critical at once
+    int pollMs = 1000;
+};
+
+/**
+ * @brief One registered consumer, as last polled
+ */
+struct MemoryConsumerStatus {
+    QString name;
+    int shedOrder = 0;
+    qint64 budgetBytes = 0;
+    qint64 usageBytes = 0;
+    MemoryPressure pressure = MemoryPressure::Normal;
+};
+
+/**
+ * @brief Process memory accounting and graceful degradation
+ *
+ * Subsystems that hold memory the process could do without register a
+ * consumer: a name, a shed order, a budget, a probe reporting the bytes
+ * they hold and a callback that applies a pressure level. Each poll samples
+ * MemoryAccounting and reads the resident size (/proc/self/statm on Linux,
+ * else the larger of the consumers' sum and the accounted total) against
+ * the ceiling. Above the high water mark the next consumer in shed
+ * order is stepped up one level, all of them to Elevated before any goes
+ * Critical; below the low water mark the last one stepped up is stepped
+ * back, so the process settles between the two marks instead of
+ * oscillating. Past the critical mark every consumer goes Critical at
+ * once. A consumer over its own budget is held at Elevated at least,
+ * whatever the process total.
+ *
+ * Callbacks run on the consumer's context thread, as TimerService posts
+ * them; destroying the context unregisters it. Probes run on the
+ * governor's thread under its lock, so they must be cheap and must not
+ * call back in; reading an atomic or taking the subsystem's own lock
+ * briefly is fine. A probe reading members outlives them until QObject's
+ * destructor runs, so an owner unregisters in its own destructor.
+ */
+class MemoryGovernor : public QObject {
+    Q_OBJECT
+
+public:
+    using ConsumerId = quint64;     // 0 is never a valid id
+    using UsageProbe = std::function<qint64()>;
+    using ShedFunction = std::function<void(MemoryPressure)>;
+
+    static MemoryGovernor& instance();
+
+    explicit MemoryGovernor(QObject* parent = nullptr);
+    ~MemoryGovernor() override;
+
+    // Restarts polling if it runs
+    void setConfig(const MemoryGovernorConfig& config);
+    MemoryGovernorConfig config() const;
+
+    // Lower shedOrder sheds first; budgetBytes 0 for none
+    ConsumerId registerConsumer(QObject* context, const QString& name, int shedOrder, qint64 budgetBytes,
+                                UsageProbe usage, ShedFunction shed);
+    void unregisterConsumer(ConsumerId id);
+
+    void start();
+    void stop();
+    // One evaluation; start() runs it every pollMs
+    void poll();
+
+    // Replaces the resident size measurement, for tests
+    void setResidentProbe(UsageProbe probe);
+
+    qint64 residentBytes() const;
+    qint64 ceilingBytes() const;    // After resolving 0; 0 when unknown, which disables shedding
+    MemoryPressure pressure() const;    // Highest level any consumer is held at
+    QVector<MemoryConsumerStatus> consumers() const;   // In shed order
+
+    struct Stats {
+        quint64 polls = 0;
+        quint64 sheds = 0;          // Consumer steps up
+        quint64 restores = 0;       // Consumer steps back
+    };
+    Stats stats() const;
+
+    static const char* pressureKey(MemoryPressure pressure);
+
+signals:
+    void pressureChanged(MemoryPressure pressure);
+
+private:
+    struct Consumer {
+        QObject* context = nullptr;
+        QString name;
+        int shedOrder = 0;
+        qint64 budgetBytes = 0;
+        UsageProbe usage;
+        ShedFunction shed;
+        qint64 usageBytes = 0;
+        MemoryPressure pressure = MemoryPressure::Normal;
+        QMetaObject::Connection guard;      // Unregisters on the context's destruction
+    };
+
+    static qint64 detectCeiling();
+    static qint64 processResident();
+    // Consumer ids by shed order, then registration order
+    QVector<ConsumerId> orderLocked() const;
+    void applyLocked(Consumer& consumer, MemoryPressure level);
+    void exportLocked();
+
+    mutable QMutex m_mutex;
+    MemoryGovernorConfig m_config;
+    qint64 m_detectedCeiling = 0;
+    QHash<ConsumerId, Consumer> m_consumers;
+    ConsumerId m_nextId = 1;
+    UsageProbe m_residentProbe;
+    qint64 m_resident = 0;
+    int m_depth = 0;                // Steps taken: consumer i is Elevated past i, Critical past n + i
+    MemoryPressure m_pressure = MemoryPressure::Normal;
+    Stats m_stats;
+    ServiceTimer m_pollTimer;
+
+    MetricGauge* m_residentGauge = nullptr;
+    MetricGauge* m_ceilingGauge = nullptr;
+    QHash<QString, MetricGauge*> m_usageGauges;
+};
+
+} // namespace CounterUAS
+
+#endif // MEMORYGOVERNOR_H
@@ -0,0 +1,185 @@
+#include "utils/MetricsRegistry.h"
+#include "utils/Logger.h"
+#include <QMutexLocker>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+const double SUMMARY_QUANTILES[] = {0.5, 0.9, 0.99};
+
+QByteArray formatValue(double value) {
+    if (std::isnan(value)) return QByteArrayLiteral("NaN");
+    if (std::isinf(value)) return value > 0 ? QByteArrayLiteral("+Inf") : QByteArrayLiteral("-Inf");
+    return QByteArray::number(value, 'g', 12);
+}
+
+QByteArray escapeHelp(const QString& help) {
+    QByteArray out;
+    for (char c : help.toUtf8()) {
+        if (c == '\\') out.append("\\\\");
+        else if (c == '\n') out.append("\\n");
+        else out.append(c);
+    }
+    return out;
+}
+
+void appendSample(QByteArray& out, const QByteArray& name, const QByteArray& labels,
+                  const QByteArray& extraLabel, const QByteArray& value) {
+    out.append(name);
+    if (!labels.isEmpty() || !extraLabel.isEmpty()) {
+        out.append('{').append(labels);
+        if (!labels.isEmpty() && !extraLabel.isEmpty()) out.append(',');
+        out.append(extraLabel).append('}');
+    }
+    out.append(' ').append(value).append('\n');
+}
+
+} // namespace
+
+void MetricGauge::add(double delta) {
+    double seen = m_value.load(std::memory_order_relaxed);
+    while (!m_value.compare_exchange_weak(seen, seen + delta, std::memory_order_relaxed)) {
+    }
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+QByteArray MetricsRegistry::renderLabels(const MetricLabels& labels) {
+    QByteArray out;
+    for (const auto& label : labels) {
+        if (!out.isEmpty()) out.append(',');
+        out.append(label.first.toUtf8()).append("=\"");
+        for (char c : label.second.toUtf8()) {
+            if (c == '\\' || c == '"') out.append('\\').append(c);
+            else if (c == '\n') out.append("\\n");
+            else out.append(c);
+        }
+        out.append('"');
+    }
+    return out;
+}
+
+MetricsRegistry::Series* MetricsRegistry::findOrCreateLocked(const QString& name, const QString& help,
+                                                             Type type, const MetricLabels& labels,
+                                                             bool* created) {
+    *created = false;
+    const QByteArray rendered = renderLabels(labels);
+
+    auto family = m_families.find(name);
+    if (family == m_families.end()) {
+        family = m_families.insert(name, Family());
+        family->type = type;
+        family->help = help;
+    } else if (family->type != type) {
+        CUAS_LOG_WARNING("MetricsRegistry", name + " is already registered as another type");
+        m_detached.emplace_back(new Series);
+        *created = true;
+        return m_detached.back().get();
+    }
+
+    for (const auto& series : family->series) {
+        if (series->labels == rendered) return series.get();
+    }
+    family->series.emplace_back(new Series);
+    Series* series = family->series.back().get();
+    series->labels = rendered;
+    *created = true;
+    return series;
+}
+
+MetricCounter* MetricsRegistry::counter(const QString& name, const QString& help, const MetricLabels& labels) {
+    QMutexLocker locker(&m_mutex);
+    bool created = false;
+    Series* series = findOrCreateLocked(name, help, Type::Counter, labels, &created);
+    if (created) series->counter.reset(new MetricCounter);
+    return series->counter.get();
+}
+
+MetricGauge* MetricsRegistry::gauge(const QString& name, const QString& help, const MetricLabels& labels) {
+    QMutexLocker locker(&m_mutex);
+    bool created = false;
+    Series* series = findOrCreateLocked(name, help, Type::Gauge, labels, &created);
+    if (created) series->gauge.reset(new MetricGauge);
+    return series->gauge.get();
+}
+
+LatencyHistogram* MetricsRegistry::histogram(const QString& name, const QString& help, const MetricLabels& labels) {
+    QMutexLocker locker(&m_mutex);
+    bool created = false;
+    Series* series = findOrCreateLocked(name, help, Type::Summary, labels, &created);
+    if (created) {
+        series->ownedHistogram.reset(new LatencyHistogram);
+        series->histogram = series->ownedHistogram.get();
+    }
+    // An external histogram under the same name and labels is read-only here
+    if (!series->ownedHistogram) {
+        m_detached.emplace_back(new Series);
+        m_detached.back()->ownedHistogram.reset(new LatencyHistogram);
+        return m_detached.back()->ownedHistogram.get();
+    }
+    return series->ownedHistogram.get();
+}
+
+void MetricsRegistry::addHistogram(const QString& name, const QString& help, const MetricLabels& labels,
+                                   const LatencyHistogram* histogram) {
+    if (!histogram) return;
+    QMutexLocker locker(&m_mutex);
+    bool created = false;
+    Series* series = findOrCreateLocked(name, help, Type::Summary, labels, &created);
+    if (created) series->histogram = histogram;
+}
+
+int MetricsRegistry::seriesCount() const {
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const Family& family : m_families) {
+        count += static_cast<int>(family.series.size());
+    }
+    return count;
+}
+
+QByteArray MetricsRegistry::toPrometheusText() const {
+    QMutexLocker locker(&m_mutex);
+    QByteArray out;
+    out.reserve(256 * m_families.size());
+
+    for (auto it = m_families.constBegin(); it != m_families.constEnd(); ++it) {
+        const QByteArray name = it.key().toUtf8();
+        const Family& family = it.value();
+        const char* type = family.type == Type::Counter ? "counter"
+                         : family.type == Type::Gauge ? "gauge" : "summary";
+        out.append("# HELP ").append(name).append(' ').append(escapeHelp(family.help)).append('\n');
+        out.append("# TYPE ").append(name).append(' ').append(type).append('\n');
+
+        for (const auto& series : family.series) {
+            switch (family.type) {
+            case Type::Counter:
+                appendSample(out, name, series->labels, QByteArray(),
+                             QByteArray::number(series->counter->value()));
+                break;
+            case Type::Gauge:
+                appendSample(out, name, series->labels, QByteArray(), formatValue(series->gauge->value()));
+                break;
+            case Type::Summary: {
+                const LatencyHistogramSnapshot snap = series->histogram->snapshot();
+                for (double q : SUMMARY_QUANTILES) {
+                    appendSample(out, name, series->labels,
+                                 "quantile=\"" + QByteArray::number(q) + '"',
+                                 formatValue(snap.percentileUs(q) / 1e6));
+                }
+                appendSample(out, name + "_sum", series->labels, QByteArray(), formatValue(snap.sumUs / 1e6));
+                appendSample(out, name + "_count", series->labels, QByteArray(), QByteArray::number(snap.count));
+                break;
+            }
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace CounterUAS
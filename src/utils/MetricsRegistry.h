@@ -0,0 +1,107 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "utils/LatencyHistogram.h"
+
+namespace CounterUAS {
+
+using MetricLabels = QList<QPair<QString, QString>>;
+
+/**
+ * @brief Monotonic count; any thread, one relaxed atomic per update
+ */
+class MetricCounter {
+public:
+    void add(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    // Mirrors a running total a subsystem already keeps
+    void setTotal(quint64 total) { m_value.store(total, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+/**
+ * @brief Value that goes up and down; any thread, lock-free
+ */
+class MetricGauge {
+public:
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(double delta);
+    double value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> m_value{0.0};
+};
+
+/**
+ * @brief Process-wide registry of named metrics for fleet monitoring
+ *
+ * Subsystems look their metrics up once, typically in their constructor,
+ * and keep the pointers: registering takes the registry lock, updating a
+ * metric never does. The same name and labels always return the same
+ * metric, which lives as long as the registry. Histograms record
+ * microseconds and are exported as Prometheus summaries in seconds.
+ *
+ * toPrometheusText() renders the Prometheus text exposition format; the
+ * MetricsExporter serves it over HTTP.
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // Never null. A name already registered as another type gets a metric
+    // that is not exported, and a warning is logged.
+    MetricCounter* counter(const QString& name, const QString& help, const MetricLabels& labels = {});
+    MetricGauge* gauge(const QString& name, const QString& help, const MetricLabels& labels = {});
+    LatencyHistogram* histogram(const QString& name, const QString& help, const MetricLabels& labels = {});
+
+    // Exports a histogram owned elsewhere, which must outlive the registry
+    void addHistogram(const QString& name, const QString& help, const MetricLabels& labels,
+                      const LatencyHistogram* histogram);
+
+    int seriesCount() const;
+    QByteArray toPrometheusText() const;
+
+private:
+    enum class Type { Counter, Gauge, Summary };
+
+    struct Series {
+        QByteArray labels;          // Rendered, without braces
+        std::unique_ptr<MetricCounter> counter;
+        std::unique_ptr<MetricGauge> gauge;
+        std::unique_ptr<LatencyHistogram> ownedHistogram;
+        const LatencyHistogram* histogram = nullptr;
+    };
+
+    struct Family {
+        Type type = Type::Counter;
+        QString help;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    Series* findOrCreateLocked(const QString& name, const QString& help, Type type,
+                               const MetricLabels& labels, bool* created);
+    static QByteArray renderLabels(const MetricLabels& labels);
+
+    mutable QMutex m_mutex;
+    QMap<QString, Family> m_families;                // Sorted, so the export is stable
+    std::vector<std::unique_ptr<Series>> m_detached; // Type conflicts, kept alive but not exported
+};
+
+} // namespace CounterUAS
+
+#endif // METRICSREGISTRY_H
@@ -0,0 +1,185 @@
+#include "utils/OverloadController.h"
+#include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include <QMutexLocker>
+#include <QStringList>
+
+namespace CounterUAS {
+
+OverloadController& OverloadController::instance() {
+    static OverloadController controller;
+    return controller;
+}
+
+OverloadController::OverloadController(QObject* parent)
+    : QObject(parent)
+    , m_windowTimer(this, [this]() { evaluate(); })
+{
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    m_levelGauge = registry.gauge("cuas_overload_level", "Load-shedding level, 0 for none");
+    m_escalationCounter = registry.counter("cuas_overload_transitions_total", "Load-shedding level changes",
+                                           {{"direction", "shed"}});
+    m_recoveryCounter = registry.counter("cuas_overload_transitions_total", "Load-shedding level changes",
+                                         {{"direction", "restore"}});
+    for (int s = 0; s < LOAD_STAGES; ++s) {
+        m_cycles[s] = 0;
+        m_overruns[s] = 0;
+        m_busyUs[s] = 0;
+        m_budgetUs[s] = 0;
+        m_utilizationGauges[s] = registry.gauge("cuas_overload_stage_utilization",
+                                                "Share of a stage's cycle budget spent over the last window",
+                                                {{"stage", stageKey(static_cast<LoadStage>(s))}});
+    }
+}
+
+OverloadController::~OverloadController() {
+    m_windowTimer.stop();
+}
+
+void OverloadController::setConfig(const OverloadConfig& config) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_config = config;
+        m_config.lowUtilization = qMin(m_config.lowUtilization, m_config.highUtilization);
+        m_config.escalateWindows = qMax(1, m_config.escalateWindows);
+        m_config.recoverWindows = qMax(1, m_config.recoverWindows);
+    }
+    m_windowTimer.setInterval(qMax(50, config.windowMs));
+}
+
+OverloadConfig OverloadController::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+void OverloadController::reportStage(LoadStage stage, qint64 elapsedUs, qint64 budgetUs) {
+    const int s = static_cast<int>(stage);
+    m_cycles[s].fetch_add(1, std::memory_order_relaxed);
+    m_busyUs[s].fetch_add(qMax<qint64>(0, elapsedUs), std::memory_order_relaxed);
+    if (budgetUs <= 0) return;
+    m_budgetUs[s].fetch_add(budgetUs, std::memory_order_relaxed);
+    if (elapsedUs > budgetUs) m_overruns[s].fetch_add(1, std::memory_order_relaxed);
+}
+
+void OverloadController::start() {
+    m_windowTimer.setInterval(qMax(50, config().windowMs));
+    m_windowTimer.start();
+}
+
+void OverloadController::stop() {
+    m_windowTimer.stop();
+}
+
+void OverloadController::evaluate() {
+    LoadStageStatus window[LOAD_STAGES];
+    for (int s = 0; s < LOAD_STAGES; ++s) {
+        window[s].cycles = m_cycles[s].exchange(0, std::memory_order_relaxed);
+        window[s].overruns = m_overruns[s].exchange(0, std::memory_order_relaxed);
+        const qint64 busyUs = m_busyUs[s].exchange(0, std::memory_order_relaxed);
+        const qint64 budgetUs = m_budgetUs[s].exchange(0, std::memory_order_relaxed);
+        window[s].utilization = budgetUs > 0 ? double(busyUs) / double(budgetUs) : 0.0;
+    }
+
+    OverloadLevel before;
+    OverloadLevel after;
+    QStringList hotStages;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.windows++;
+
+        bool hot = false;
+        bool calm = true;
+        for (int s = 0; s < LOAD_STAGES; ++s) {
+            m_status[s] = window[s];
+            m_utilizationGauges[s]->set(window[s].utilization);
+            if (window[s].cycles == 0) continue;    // An idle stage is calm
+
+            const double overrunShare = double(window[s].overruns) / double(window[s].cycles);
+            if (window[s].utilization >= m_config.highUtilization || overrunShare > m_config.overrunShare) {
+                hot = true;
+                hotStages.append(QString("%1 at %2% of budget, %3 of %4 cycles over")
+                                     .arg(stageKey(static_cast<LoadStage>(s)))
+                                     .arg(qRound(window[s].utilization * 100.0))
+                                     .arg(window[s].overruns).arg(window[s].cycles));
+            }
+            if (window[s].utilization >= m_config.lowUtilization || window[s].overruns > 0) {
+                calm = false;
+            }
+        }
+
+        if (hot) {
+            m_hotWindows++;
+            m_calmWindows = 0;
+        } else if (calm) {
+            m_calmWindows++;
+            m_hotWindows = 0;
+        } else {
+            m_hotWindows = 0;
+            m_calmWindows = 0;
+        }
+
+        before = m_level;
+        if (m_hotWindows >= m_config.escalateWindows && m_level != OverloadLevel::CoarseDisplay) {
+            m_level = static_cast<OverloadLevel>(static_cast<int>(m_level) + 1);
+            m_stats.escalations++;
+            m_escalationCounter->add();
+        } else if (m_calmWindows >= m_config.recoverWindows && m_level != OverloadLevel::Normal) {
+            m_level = static_cast<OverloadLevel>(static_cast<int>(m_level) - 1);
+            m_stats.recoveries++;
+            m_recoveryCounter->add();
+        }
+        after = m_level;
+        if (after != before) {
+            m_hotWindows = 0;
+            m_calmWindows = 0;
+        }
+        m_levelGauge->set(static_cast<double>(after));
+    }
+
+    if (after == before) return;
+    if (after > before) {
+        Logger::instance().warning("OverloadController",
+            QString("Shedding load, level %1: %2").arg(levelKey(after), hotStages.join("; ")));
+    } else {
+        Logger::instance().info("OverloadController",
+            QString("Load recovered, level %1").arg(levelKey(after)));
+    }
+    emit levelChanged(after, before);
+}
+
+OverloadLevel OverloadController::level() const {
+    QMutexLocker locker(&m_mutex);
+    return m_level;
+}
+
+LoadStageStatus OverloadController::stageStatus(LoadStage stage) const {
+    QMutexLocker locker(&m_mutex);
+    return m_status[static_cast<int>(stage)];
+}
+
+OverloadController::Stats OverloadController::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+const char* OverloadController::levelKey(OverloadLevel level) {
+    switch (level) {
+    case OverloadLevel::Normal: return "normal";
+    case OverloadLevel::ReducedVideo: return "reducedVideo";
+    case OverloadLevel::ReducedAssessment: return "reducedAssessment";
+    case OverloadLevel::SweepSuspended: return "sweepSuspended";
+    case OverloadLevel::CoarseDisplay: return "coarseDisplay";
+    default: return "";
+    }
+}
+
+const char* OverloadController::stageKey(LoadStage stage) {
+    switch (stage) {
+    case LoadStage::TrackCycle: return "trackCycle";
+    case LoadStage::Assessment: return "assessment";
+    case LoadStage::Render: return "render";
+    default: return "";
+    }
+}
+
+} // namespace CounterUAS
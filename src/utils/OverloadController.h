@@ -0,0 +1,138 @@
+#ifndef OVERLOADCONTROLLER_H
+#define OVERLOADCONTROLLER_H
+
+#include <QMutex>
+#include <QObject>
+#include <atomic>
+#include "utils/TimerService.h"
+
+namespace CounterUAS {
+
+class MetricCounter;
+class MetricGauge;
+
+/**
+ * @brief Periodic work whose cycle times the controller watches
+ */
+enum class LoadStage : quint8 {
+    TrackCycle = 0,     // TrackManager's processTrackCycle against 1000 / updateRateHz
+    Assessment,         // ThreatAssessor's cycle against assessmentIntervalMs
+    Render              // UIFrameScheduler's tick against its interval
+};
+
+constexpr int LOAD_STAGES = 3;
+
+/**
+ * @brief How much the console sheds; each level keeps those below it
+ */
+enum class OverloadLevel : quint8 {
+    Normal = 0,
+    ReducedVideo,       // Streams other than the primary delivered at a lower rate, decoding fewer pictures
+    ReducedAssessment,  // Low threat tracks assessed one cycle in several
+    SweepSuspended,     // PPI sweep animation stopped
+    CoarseDisplay       // Track displays refreshed at a lower rate, batching more changes
+};
+
+constexpr int OVERLOAD_LEVELS = 5;
+
+/**
+ * @brief When a window counts as overloaded and how fast levels move
+ */
+struct OverloadConfig {
+    int windowMs = 1000;            // One decision per window
+    double highUtilization = 0.9;   // Share of a stage's budget spent that makes a window hot
+    double lowUtilization = 0.6;    // Every stage below it, and none overrunning, makes it calm
+    double overrunShare = 0.1;      // Share of a stage's cycles over budget that makes it hot
+    int escalateWindows = 2;        // Consecutive hot windows before shedding one more level
+    int recoverWindows = 5;         // Consecutive calm windows before restoring one level
+};
+
+/**
+ * @brief One stage over the last window
+ */
+struct LoadStageStatus {
+    quint64 cycles = 0;
+    quint64 overruns = 0;
+    double utilization = 0.0;       // Time spent over time budgeted
+};
+
+/**
+ * @brief Process-wide CPU overload detection and load-shedding level
+ *
+ * The stages report each cycle's duration and budget through
+ * reportStage(), from any thread and without a lock. Once per window the
+ * controller adds them up: a window is hot when any stage spent more than
+ * highUtilization of its budget or overran in more than overrunShare of
+ * its cycles, calm when every stage stayed under lowUtilization without an
+ * overrun. escalateWindows hot windows in a row shed one more level;
+ * recoverWindows calm ones restore one. Between the two marks neither
+ * count advances, and each change starts both afresh, so a level has time
+ * to take effect before the next is decided.
+ *
+ * The controller only decides; what each level sheds is applied by whoever
+ * owns the work, on levelChanged(). Changes are logged and exported as
+ * cuas_overload_level. Create it on the GUI thread, before the reporting
+ * threads start, so its timer runs there.
+ */
+class OverloadController : public QObject {
+    Q_OBJECT
+
+public:
+    static OverloadController& instance();
+
+    explicit OverloadController(QObject* parent = nullptr);
+    ~OverloadController() override;
+
+    // Restarts evaluation if it runs
+    void setConfig(const OverloadConfig& config);
+    OverloadConfig config() const;
+
+    // From any thread, once per cycle; budgetUs 0 counts the cycle only
+    void reportStage(LoadStage stage, qint64 elapsedUs, qint64 budgetUs);
+
+    void start();
+    void stop();
+    // One window's decision; start() runs it every windowMs
+    void evaluate();
+
+    OverloadLevel level() const;
+    LoadStageStatus stageStatus(LoadStage stage) const;
+
+    struct Stats {
+        quint64 windows = 0;
+        quint64 escalations = 0;
+        quint64 recoveries = 0;
+    };
+    Stats stats() const;
+
+    static const char* levelKey(OverloadLevel level);
+    static const char* stageKey(LoadStage stage);
+
+signals:
+    void levelChanged(OverloadLevel level, OverloadLevel previous);
+
+private:
+    mutable QMutex m_mutex;
+    OverloadConfig m_config;
+    OverloadLevel m_level = OverloadLevel::Normal;
+    int m_hotWindows = 0;
+    int m_calmWindows = 0;
+    LoadStageStatus m_status[LOAD_STAGES];
+    Stats m_stats;
+    ServiceTimer m_windowTimer;
+
+    // Since the last window, taken by evaluate()
+    std::atomic<quint64> m_cycles[LOAD_STAGES];
+    std::atomic<quint64> m_overruns[LOAD_STAGES];
+    std::atomic<qint64> m_busyUs[LOAD_STAGES];
+    std::atomic<qint64> m_budgetUs[LOAD_STAGES];
+
+    MetricGauge* m_levelGauge = nullptr;
+    MetricGauge* m_utilizationGauges[LOAD_STAGES] = {};
+    MetricCounter* m_escalationCounter = nullptr;
+    MetricCounter* m_recoveryCounter = nullptr;
+};
+
+} // namespace CounterUAS
+
+#endif // OVERLOADCONTROLLER_H
@@ -0,0 +1,82 @@
+#include "utils/PipelineLatency.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/TimeUtils.h"
+
+namespace CounterUAS {
+
+namespace {
+
+LatencyHistogram* histograms() {
+    static LatencyHistogram stages[PipelineLatency::STAGE_COUNT];
+    return stages;
+}
+
+bool validStage(PipelineStage stage) {
+    return static_cast<int>(stage) >= 0 && stage < PipelineStage::Count;
+}
+
+} // namespace
+
+void PipelineLatency::record(PipelineStage stage, qint64 us) {
+    if (!validStage(stage)) return;
+    histograms()[static_cast<int>(stage)].record(us);
+}
+
+void PipelineLatency::recordSinceIngest(PipelineStage stage, qint64 ingestMonoNs) {
+    if (ingestMonoNs <= 0) return;
+    record(stage, (TimeUtils::monotonicNs() - ingestMonoNs) / 1000);
+}
+
+bool PipelineLatency::recordNewest(PipelineStage stage, qint64 ingestMonoNs, qint64& lastRecordedNs) {
+    if (ingestMonoNs <= lastRecordedNs) return false;
+    lastRecordedNs = ingestMonoNs;
+    recordSinceIngest(stage, ingestMonoNs);
+    return true;
+}
+
+LatencyHistogramSnapshot PipelineLatency::snapshot(PipelineStage stage) {
+    if (!validStage(stage)) return LatencyHistogramSnapshot();
+    return histograms()[static_cast<int>(stage)].snapshot();
+}
+
+void PipelineLatency::reset() {
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        histograms()[i].reset();
+    }
+}
+
+QString PipelineLatency::stageName(PipelineStage stage) {
+    switch (stage) {
+    case PipelineStage::Receive: return QStringLiteral("Receive");
+    case PipelineStage::Parse: return QStringLiteral("Parse");
+    case PipelineStage::Fusion: return QStringLiteral("Fusion");
+    case PipelineStage::ThreatAssessment: return QStringLiteral("Threat Assessment");
+    case PipelineStage::Display: return QStringLiteral("Display");
+    case PipelineStage::Publish: return QStringLiteral("Network Publish");
+    case PipelineStage::EndToEnd: return QStringLiteral("Detect to Display");
+    default: return QString();
+    }
+}
+
+const char* PipelineLatency::stageKey(PipelineStage stage) {
+    switch (stage) {
+    case PipelineStage::Receive: return "receive";
+    case PipelineStage::Parse: return "parse";
+    case PipelineStage::Fusion: return "fusion";
+    case PipelineStage::ThreatAssessment: return "threat";
+    case PipelineStage::Display: return "display";
+    case PipelineStage::Publish: return "publish";
+    case PipelineStage::EndToEnd: return "endToEnd";
+    default: return "";
+    }
+}
+
+void PipelineLatency::exportTo(MetricsRegistry& registry) {
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        registry.addHistogram("cuas_pipeline_latency_seconds", "Detect to display latency by pipeline stage",
+                              {{"stage", stageKey(static_cast<PipelineStage>(stage))}},
+                              &histograms()[stage]);
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,60 @@
+#ifndef PIPELINELATENCY_H
+#define PIPELINELATENCY_H
+
+#include <QString>
+#include "utils/LatencyHistogram.h"
+
+namespace CounterUAS {
+
+class MetricsRegistry;
+
+/**
+ * @brief Points on the detect-to-display path where latency is sampled
+ *
+ * Receive is how old a measurement was when its bytes were read off the
+ * socket, and Parse how long decoding one message took. Fusion through
+ * Publish are each measured from the socket read, so every stage includes
+ * the ones before it; EndToEnd runs from the sensor's measurement time to
+ * the display paint.
+ */
+enum class PipelineStage {
+    Receive = 0,        // Sensor measurement to socket read
+    Parse,              // One message decoded
+    Fusion,             // Socket read to track update
+    ThreatAssessment,   // Socket read to the assessment that saw it
+    Display,            // Socket read to the PPI paint that showed it
+    Publish,            // Socket read to the network picture update carrying it
+    EndToEnd,           // Sensor measurement to the PPI paint
+    Count
+};
+
+/**
+ * @brief Process-wide latency histograms, one per pipeline stage
+ *
+ * Any thread may record; recording is lock-free. The diagnostics panel and
+ * the network heartbeat read the snapshots.
+ */
+class PipelineLatency {
+public:
+    static constexpr int STAGE_COUNT = static_cast<int>(PipelineStage::Count);
+
+    static void record(PipelineStage stage, qint64 us);
+    // Age of a TimeUtils::monotonicNs() socket read stamp; 0 means no stamp
+    static void recordSinceIngest(PipelineStage stage, qint64 ingestMonoNs);
+    // For stages that see the same newest plot many times, e.g. repaints:
+    // records it only when newer than lastRecordedNs, which it then advances
+    static bool recordNewest(PipelineStage stage, qint64 ingestMonoNs, qint64& lastRecordedNs);
+
+    static LatencyHistogramSnapshot snapshot(PipelineStage stage);
+    static void reset();
+    // Adds every stage as cuas_pipeline_latency_seconds{stage="<stageKey>"}
+    static void exportTo(MetricsRegistry& registry);
+
+    static QString stageName(PipelineStage stage);
+    // Prefix of the stage's heartbeat fields, e.g. "fusion" for fusionP99Us
+    static const char* stageKey(PipelineStage stage);
+};
+
+} // namespace CounterUAS
+
+#endif // PIPELINELATENCY_H
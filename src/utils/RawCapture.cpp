@@ -0,0 +1,294 @@
+#include "utils/RawCapture.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QtEndian>
+#include <memory>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 CAPTURE_MAGIC = 0x50435543;       // "CUCP"
+constexpr quint32 CAPTURE_VERSION = 1;
+constexpr int CAPTURE_HEADER_BYTES = 24;            // magic, version, start, span
+constexpr int RECORD_HEADER_BYTES = 16;             // time ns, channel, flags, length
+constexpr quint16 FLAG_CHANNEL_DEFINITION = 0x0001; // Payload: kind(1), then the source in UTF-8
+constexpr quint32 MAX_RECORD_BYTES = 16 * 1024 * 1024;
+constexpr int WRITER_INTERVAL_MS = 20;
+
+QString segmentPath(const QString& directory, qint64 startMs) {
+    return QDir(directory).filePath(QString("capture-%1.ccap").arg(startMs));
+}
+
+qint64 floorDiv(qint64 value, qint64 divisor) {
+    qint64 q = value / divisor;
+    if (value % divisor != 0 && value < 0) --q;
+    return q;
+}
+
+void writeRecord(QFile& file, qint64 timeNs, quint16 channel, quint16 flags,
+                 const char* data, int size) {
+    uchar header[RECORD_HEADER_BYTES];
+    qToLittleEndian<qint64>(timeNs, header);
+    qToLittleEndian<quint16>(channel, header + 8);
+    qToLittleEndian<quint16>(flags, header + 10);
+    qToLittleEndian<quint32>(static_cast<quint32>(size), header + 12);
+    file.write(reinterpret_cast<const char*>(header), RECORD_HEADER_BYTES);
+    file.write(data, size);
+}
+
+} // namespace
+
+RawCaptureRecorder::RawCaptureRecorder(const RawCaptureConfig& config)
+    : m_config(config)
+    , m_queue(static_cast<std::size_t>(qMax(16, config.queueCapacity)))
+{
+    m_config.segmentMs = qMax<qint64>(1000, m_config.segmentMs);
+    m_config.segmentBytes = qMax<qint64>(64 * 1024, m_config.segmentBytes);
+    QDir().mkpath(m_config.directory);
+}
+
+RawCaptureRecorder::~RawCaptureRecorder() {
+    stop();
+}
+
+void RawCaptureRecorder::start() {
+    if (m_thread) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+    }
+    m_epochOffsetNs.store(QDateTime::currentMSecsSinceEpoch() * 1000000 - TimeUtils::monotonicNs(),
+                          std::memory_order_relaxed);
+    m_thread = QThread::create([this]() { writerLoop(); });
+    m_thread->setObjectName("RawCaptureRecorder");
+    m_thread->start();
+    m_accepting.store(true, std::memory_order_release);
+}
+
+void RawCaptureRecorder::stop() {
+    if (!m_thread) return;
+    m_accepting.store(false, std::memory_order_release);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+int RawCaptureRecorder::openChannel(const QString& source, RawCaptureKind kind) {
+    QMutexLocker locker(&m_channelMutex);
+    for (int i = 0; i < m_channels.size(); ++i) {
+        if (m_channels[i].kind == kind && m_channels[i].source == source) return i;
+    }
+    if (m_channels.size() >= 0xFFFF) return -1;
+    m_channels.append({source, kind});
+    return m_channels.size() - 1;
+}
+
+bool RawCaptureRecorder::record(int channel, const char* data, int size, qint64 receivedNs) {
+    if (!m_accepting.load(std::memory_order_acquire) || channel < 0 || size <= 0) return false;
+    if (static_cast<quint32>(size) > MAX_RECORD_BYTES ||
+        m_queuedBytes.load(std::memory_order_relaxed) + size > m_config.maxQueuedBytes) {
+        m_packetsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Queued packet;
+    packet.timeNs = (receivedNs > 0 ? receivedNs : TimeUtils::monotonicNs())
+                  + m_epochOffsetNs.load(std::memory_order_relaxed);
+    packet.channel = channel;
+    packet.data = QByteArray(data, size);
+    if (!m_queue.tryPush(std::move(packet))) {
+        m_packetsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_queuedBytes.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
+
+void RawCaptureRecorder::writerLoop() {
+    std::unique_ptr<QFile> file;
+    qint64 segmentStartMs = 0;          // Of the segment window the file is in
+    qint64 fileStartMs = 0;             // In the file's name
+    qint64 fileBytes = 0;
+    QVector<bool> defined;              // Channels whose definition the file has
+    QVector<Channel> channels;          // Copy of m_channels, refreshed for new ids
+
+    forever {
+        bool stopping;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_stopping) {
+                m_wake.wait(&m_mutex, WRITER_INTERVAL_MS);
+            }
+            stopping = m_stopping;
+        }
+
+        Queued packet;
+        while (m_queue.tryPop(packet)) {
+            m_queuedBytes.fetch_sub(packet.data.size(), std::memory_order_relaxed);
+
+            const qint64 packetMs = floorDiv(packet.timeNs, 1000000);
+            const qint64 windowMs = floorDiv(packetMs, m_config.segmentMs) * m_config.segmentMs;
+            if (!file || windowMs != segmentStartMs || fileBytes >= m_config.segmentBytes) {
+                // A segment rolled for size starts at its first packet, in the same window
+                const bool full = file && windowMs == segmentStartMs;
+                const qint64 startMs = full ? qMax(packetMs, fileStartMs + 1) : windowMs;
+                file.reset(new QFile(segmentPath(m_config.directory, startMs)));
+                segmentStartMs = windowMs;
+                fileStartMs = startMs;
+                defined.fill(false);
+                if (!file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+                    Logger::instance().error("RawCaptureRecorder", "Failed to open " + file->fileName() +
+                                             ": " + file->errorString());
+                    file.reset();
+                    m_packetsDropped.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (file->size() == 0) {
+                    uchar header[CAPTURE_HEADER_BYTES];
+                    qToLittleEndian<quint32>(CAPTURE_MAGIC, header);
+                    qToLittleEndian<quint32>(CAPTURE_VERSION, header + 4);
+                    qToLittleEndian<qint64>(startMs, header + 8);
+                    qToLittleEndian<qint64>(windowMs + m_config.segmentMs - startMs, header + 16);
+                    file->write(reinterpret_cast<const char*>(header), CAPTURE_HEADER_BYTES);
+                }
+                fileBytes = file->size();
+            }
+
+            // Each segment names its channels before their first packet in it
+            if (packet.channel >= channels.size()) {
+                QMutexLocker locker(&m_channelMutex);
+                channels = m_channels;
+            }
+            if (packet.channel >= channels.size()) continue;
+            if (defined.size() < channels.size()) defined.resize(channels.size());
+            if (!defined[packet.channel]) {
+                const Channel& channel = channels[packet.channel];
+                QByteArray definition;
+                definition.append(static_cast<char>(channel.kind));
+                definition.append(channel.source.toUtf8());
+                writeRecord(*file, packet.timeNs, static_cast<quint16>(packet.channel), FLAG_CHANNEL_DEFINITION,
+                            definition.constData(), definition.size());
+                fileBytes += RECORD_HEADER_BYTES + definition.size();
+                defined[packet.channel] = true;
+            }
+
+            writeRecord(*file, packet.timeNs, static_cast<quint16>(packet.channel), 0,
+                        packet.data.constData(), packet.data.size());
+            fileBytes += RECORD_HEADER_BYTES + packet.data.size();
+            m_packetsRecorded.fetch_add(1, std::memory_order_relaxed);
+            m_bytesRecorded.fetch_add(static_cast<quint64>(packet.data.size()), std::memory_order_relaxed);
+        }
+        if (file) {
+            file->flush();
+        }
+        if (stopping) break;
+    }
+}
+
+RawCaptureReader::RawCaptureReader(const QString& directory)
+    : m_directory(directory)
+{}
+
+qint64 RawCaptureReader::read(qint64 startMs, qint64 endMs, const Visitor& visit) const {
+    qint64 visited = 0;
+    const qint64 startNs = startMs * 1000000;
+    const qint64 endNs = endMs * 1000000 + 999999;
+    const QMap<qint64, QString> files = segments();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        if (it.key() > endMs) break;
+
+        QFile file(it.value());
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QByteArray header = file.read(CAPTURE_HEADER_BYTES);
+        if (header.size() < CAPTURE_HEADER_BYTES) continue;
+        const uchar* h = reinterpret_cast<const uchar*>(header.constData());
+        const quint32 version = qFromLittleEndian<quint32>(h + 4);
+        if (qFromLittleEndian<quint32>(h) != CAPTURE_MAGIC || version < 1 || version > CAPTURE_VERSION) {
+            Logger::instance().warning("RawCapture", "Not a raw capture: " + it.value());
+            continue;
+        }
+        const qint64 spanMs = qFromLittleEndian<qint64>(h + 16);
+        if (it.key() + spanMs <= startMs) continue;
+
+        QVector<RawCapturePacket> channels;     // Source and kind by channel id
+        RawCapturePacket packet;
+        forever {
+            const QByteArray recordHeader = file.read(RECORD_HEADER_BYTES);
+            if (recordHeader.size() < RECORD_HEADER_BYTES) break;
+            const uchar* r = reinterpret_cast<const uchar*>(recordHeader.constData());
+            const qint64 timeNs = qFromLittleEndian<qint64>(r);
+            const quint16 channel = qFromLittleEndian<quint16>(r + 8);
+            const quint16 flags = qFromLittleEndian<quint16>(r + 10);
+            const quint32 bytes = qFromLittleEndian<quint32>(r + 12);
+            if (bytes > MAX_RECORD_BYTES) break;
+            const QByteArray payload = file.read(bytes);
+            if (payload.size() < static_cast<int>(bytes)) break;    // Torn by a crash
+
+            if (flags & FLAG_CHANNEL_DEFINITION) {
+                if (payload.isEmpty()) continue;
+                if (channels.size() <= channel) channels.resize(channel + 1);
+                channels[channel].kind = static_cast<RawCaptureKind>(payload.at(0));
+                channels[channel].source = QString::fromUtf8(payload.constData() + 1, payload.size() - 1);
+                continue;
+            }
+            if (channel >= channels.size() || channels[channel].source.isEmpty()) continue;
+            if (timeNs < startNs || timeNs > endNs) continue;
+
+            packet.timeNs = timeNs;
+            packet.source = channels[channel].source;
+            packet.kind = channels[channel].kind;
+            packet.data = payload;
+            visit(packet);
+            ++visited;
+        }
+    }
+    return visited;
+}
+
+QVector<RawCapturePacket> RawCaptureReader::load(qint64 startMs, qint64 endMs) const {
+    QVector<RawCapturePacket> packets;
+    read(startMs, endMs, [&packets](const RawCapturePacket& packet) { packets.append(packet); });
+    return packets;
+}
+
+int RawCaptureReader::removeBefore(qint64 cutoffMs) const {
+    int removed = 0;
+    const QMap<qint64, QString> files = segments();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        QFile file(it.value());
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QByteArray header = file.read(CAPTURE_HEADER_BYTES);
+        file.close();
+        if (header.size() < CAPTURE_HEADER_BYTES) continue;
+        const qint64 spanMs = qFromLittleEndian<qint64>(reinterpret_cast<const uchar*>(header.constData()) + 16);
+        if (it.key() + spanMs <= cutoffMs && QFile::remove(it.value())) {
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+QMap<qint64, QString> RawCaptureReader::segments() const {
+    QMap<qint64, QString> files;
+    const QDir dir(m_directory);
+    const QStringList names = dir.entryList(QStringList() << "capture-*.ccap", QDir::Files);
+    for (const QString& name : names) {
+        bool ok = false;
+        const qint64 startMs = QFileInfo(name).completeBaseName().mid(8).toLongLong(&ok);
+        if (ok) files.insert(startMs, dir.filePath(name));
+    }
+    return files;
+}
+
+} // namespace CounterUAS
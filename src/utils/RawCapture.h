@@ -0,0 +1,149 @@
+#ifndef RAWCAPTURE_H
+#define RAWCAPTURE_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include "utils/BoundedQueue.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief How a captured input is framed, which replay must reproduce
+ */
+enum class RawCaptureKind : quint8 {
+    Stream = 1,         // Bytes of a TCP or serial stream as read; boundaries mean nothing
+    Datagram = 2        // One whole datagram per packet
+};
+
+/**
+ * @brief Where and how much a RawCaptureRecorder writes
+ */
+struct RawCaptureConfig {
+    QString directory;
+    qint64 segmentMs = 600000;                  // One file per this much receive time
+    qint64 segmentBytes = 256 * 1024 * 1024;    // Or sooner, once a file is this long
+    int queueCapacity = 16384;                  // Packets between the readers and the writer
+    qint64 maxQueuedBytes = 64 * 1024 * 1024;   // Payload queued before packets are dropped
+};
+
+/**
+ * @brief One input read, as captured
+ */
+struct RawCapturePacket {
+    qint64 timeNs = 0;          // Epoch ns on the C2 clock when it was read
+    QString source;             // Sensor or connection it was read by
+    RawCaptureKind kind = RawCaptureKind::Datagram;
+    QByteArray data;
+};
+
+/**
+ * @brief Tees the raw bytes sensors and links read into segmented capture files
+ *
+ * Fusion keeps only what the sensors made of their inputs; a capture keeps
+ * the inputs themselves, so a fault in a parser or the sensor adapters can
+ * be replayed exactly. Each reader opens a channel for its source once, then
+ * record()s every read on it: a lock-free push of a copy onto a bounded
+ * queue, which a writer thread of its own drains to disk. When the queue or
+ * its byte budget is full the packet is dropped and counted, so a slow disk
+ * never stalls ingest.
+ *
+ * The files are capture-<startMs>.ccap, pcap-like and little-endian: a
+ * 24-byte header of magic, version, start and span, then records of a
+ * 16-byte header (time ns, channel, flags, length) and the bytes. A record
+ * flagged as a channel definition names a channel's source and kind, and
+ * each segment defines a channel ahead of its first packet there, so every
+ * file replays on its own. A record torn by a crash ends its file on read.
+ *
+ * Receive times are TimeUtils::monotonicNs() stamps taken at the read, put
+ * on the epoch by an offset fixed at start(), so they stay ordered when the
+ * wall clock steps.
+ */
+class RawCaptureRecorder {
+public:
+    explicit RawCaptureRecorder(const RawCaptureConfig& config);
+    ~RawCaptureRecorder();
+
+    RawCaptureRecorder(const RawCaptureRecorder&) = delete;
+    RawCaptureRecorder& operator=(const RawCaptureRecorder&) = delete;
+
+    void start();
+    // Writes what is queued first
+    void stop();
+    bool isRunning() const { return m_accepting.load(std::memory_order_acquire); }
+
+    // Any thread, at setup: the same source and kind give the same channel
+    int openChannel(const QString& source, RawCaptureKind kind);
+
+    // Any thread; receivedNs is TimeUtils::monotonicNs() at the read, 0 for
+    // now. False when not running or the packet was dropped
+    bool record(int channel, const char* data, int size, qint64 receivedNs = 0);
+
+    quint64 packetsRecorded() const { return m_packetsRecorded.load(std::memory_order_relaxed); }
+    quint64 packetsDropped() const { return m_packetsDropped.load(std::memory_order_relaxed); }
+    quint64 bytesRecorded() const { return m_bytesRecorded.load(std::memory_order_relaxed); }
+
+private:
+    struct Queued {
+        qint64 timeNs = 0;
+        int channel = -1;
+        QByteArray data;
+    };
+
+    struct Channel {
+        QString source;
+        RawCaptureKind kind;
+    };
+
+    void writerLoop();
+
+    RawCaptureConfig m_config;
+    BoundedQueue<Queued> m_queue;
+    std::atomic<qint64> m_queuedBytes{0};
+    std::atomic<qint64> m_epochOffsetNs{0};     // Epoch minus monotonic, fixed at start()
+
+    QMutex m_channelMutex;                      // Guards m_channels
+    QVector<Channel> m_channels;
+
+    QThread* m_thread = nullptr;
+    QMutex m_mutex;                             // Guards m_stopping for the wait
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+    std::atomic<bool> m_accepting{false};
+    std::atomic<quint64> m_packetsRecorded{0};
+    std::atomic<quint64> m_packetsDropped{0};
+    std::atomic<quint64> m_bytesRecorded{0};
+};
+
+/**
+ * @brief Reads capture segments back, in the order the packets were written
+ */
+class RawCaptureReader {
+public:
+    using Visitor = std::function<void(const RawCapturePacket&)>;
+
+    explicit RawCaptureReader(const QString& directory);
+
+    // Packets read in [startMs, endMs] of epoch time; returns how many were visited
+    qint64 read(qint64 startMs, qint64 endMs, const Visitor& visit) const;
+    QVector<RawCapturePacket> load(qint64 startMs, qint64 endMs) const;
+
+    // Deletes segments that end at or before cutoffMs; returns how many
+    int removeBefore(qint64 cutoffMs) const;
+
+private:
+    QMap<qint64, QString> segments() const;     // Start time to path
+
+    QString m_directory;
+};
+
+} // namespace CounterUAS
+
+#endif // RAWCAPTURE_H
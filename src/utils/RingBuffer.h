@@ -0,0 +1,140 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <iterator>
+
+namespace CounterUAS {
+
+/**
+ * @brief Fixed-capacity circular buffer
+ *
+ * Storage is allocated once by setCapacity(); append() overwrites the
+ * oldest element when full, so the steady state does no allocation and no
+ * element shifting. Index 0 is always the oldest element. Not thread-safe;
+ * the owner provides locking.
+ */
+template <typename T>
+class RingBuffer {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator(const RingBuffer* buffer, int index) : m_buffer(buffer), m_index(index) {}
+
+        reference operator*() const { return m_buffer->at(m_index); }
+        pointer operator->() const { return &m_buffer->at(m_index); }
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator operator++(int) { const_iterator tmp = *this; ++m_index; return tmp; }
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        const RingBuffer* m_buffer;
+        int m_index;
+    };
+
+    explicit RingBuffer(int capacity = 0) { setCapacity(capacity); }
+
+    // Reallocates, keeping the newest elements that still fit
+    void setCapacity(int capacity) {
+        capacity = qMax(0, capacity);
+        if (capacity == m_data.size()) return;
+
+        QVector<T> data(capacity);
+        int keep = qMin(m_size, capacity);
+        for (int i = 0; i < keep; ++i) {
+            data[i] = at(m_size - keep + i);
+        }
+        m_data = data;
+        m_head = 0;
+        m_size = keep;
+    }
+
+    int capacity() const { return m_data.size(); }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    bool isFull() const { return m_size == m_data.size(); }
+
+    void append(const T& value) {
+        if (m_data.isEmpty()) return;
+
+        if (m_size < m_data.size()) {
+            m_data[physical(m_size)] = value;
+            m_size++;
+        } else {
+            m_data[m_head] = value;
+            m_head = (m_head + 1) % m_data.size();
+        }
+    }
+
+    void removeFirst() {
+        if (m_size == 0) return;
+        m_head = (m_head + 1) % m_data.size();
+        m_size--;
+    }
+
+    void clear() {
+        m_head = 0;
+        m_size = 0;
+    }
+
+    const T& at(int i) const { return m_data[physical(i)]; }
+    T& operator[](int i) { return m_data[physical(i)]; }
+    const T& operator[](int i) const { return at(i); }
+    const T& first() const { return at(0); }
+    const T& last() const { return at(m_size - 1); }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_size); }
+
+    // Contiguous views of the contents, oldest first: [first, first + firstCount)
+    // followed by [second, second + secondCount). secondCount is 0 unless wrapped.
+    struct Segments {
+        const T* first = nullptr;
+        int firstCount = 0;
+        const T* second = nullptr;
+        int secondCount = 0;
+    };
+
+    Segments segments() const {
+        Segments seg;
+        if (m_size == 0) return seg;
+
+        const T* base = m_data.constData();
+        int tail = m_data.size() - m_head;
+        seg.first = base + m_head;
+        seg.firstCount = qMin(m_size, tail);
+        if (m_size > tail) {
+            seg.second = base;
+            seg.secondCount = m_size - tail;
+        }
+        return seg;
+    }
+
+    QVector<T> toVector() const {
+        QVector<T> result;
+        result.reserve(m_size);
+        for (int i = 0; i < m_size; ++i) {
+            result.append(at(i));
+        }
+        return result;
+    }
+
+private:
+    int physical(int i) const { return (m_head + i) % m_data.size(); }
+
+    QVector<T> m_data;
+    int m_head = 0;
+    int m_size = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // RINGBUFFER_H
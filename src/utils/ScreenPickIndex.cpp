@@ -0,0 +1,119 @@
+#include "utils/ScreenPickIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+ScreenPickIndex::ScreenPickIndex(double cellSize)
+    : m_cellSize(std::max(cellSize, 1.0))
+{
+}
+
+void ScreenPickIndex::setCellSize(double cellSize) {
+    m_cellSize = std::max(cellSize, 1.0);
+}
+
+void ScreenPickIndex::clear(const QRectF& area) {
+    m_area = area.normalized();
+    m_columns = std::max(1, static_cast<int>(std::ceil(m_area.width() / m_cellSize)));
+    m_rows = std::max(1, static_cast<int>(std::ceil(m_area.height() / m_cellSize)));
+    m_keys.clear();
+    m_positions.clear();
+    m_order.clear();
+    m_cellStart.fill(0, m_columns * m_rows + 1);
+}
+
+void ScreenPickIndex::insert(quint64 key, const QPointF& position) {
+    m_keys.append(key);
+    m_positions.append(position);
+}
+
+int ScreenPickIndex::column(double x) const {
+    const double c = std::floor((x - m_area.left()) / m_cellSize);
+    return static_cast<int>(std::clamp(c, 0.0, double(m_columns - 1)));
+}
+
+int ScreenPickIndex::row(double y) const {
+    const double r = std::floor((y - m_area.top()) / m_cellSize);
+    return static_cast<int>(std::clamp(r, 0.0, double(m_rows - 1)));
+}
+
+void ScreenPickIndex::build() {
+    if (m_cellStart.isEmpty()) return;   // Never cleared
+
+    // Counting sort by cell: counts, then each cell's start, then fill
+    m_cellStart.fill(0);
+    QVector<int> cells(m_positions.size());
+    for (int i = 0; i < m_positions.size(); ++i) {
+        cells[i] = row(m_positions[i].y()) * m_columns + column(m_positions[i].x());
+        ++m_cellStart[cells[i] + 1];
+    }
+    for (int c = 1; c < m_cellStart.size(); ++c) {
+        m_cellStart[c] += m_cellStart[c - 1];
+    }
+    m_order.resize(m_positions.size());
+    QVector<int> next(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (int i = 0; i < m_positions.size(); ++i) {
+        m_order[next[cells[i]]++] = i;
+    }
+}
+
+bool ScreenPickIndex::nearest(const QPointF& position, double radius, quint64* key) const {
+    if (m_order.isEmpty()) return false;
+
+    int best = -1;
+    double bestSq = radius * radius;
+    for (int r = row(position.y() - radius); r <= row(position.y() + radius); ++r) {
+        for (int c = column(position.x() - radius); c <= column(position.x() + radius); ++c) {
+            const int cell = r * m_columns + c;
+            for (int j = m_cellStart[cell]; j < m_cellStart[cell + 1]; ++j) {
+                const int i = m_order[j];
+                const QPointF d = m_positions[i] - position;
+                const double distSq = d.x() * d.x() + d.y() * d.y();
+                // The earlier insertion wins a tie
+                if (distSq < bestSq || (distSq == bestSq && (best < 0 || i < best))) {
+                    bestSq = distSq;
+                    best = i;
+                }
+            }
+        }
+    }
+    if (best < 0) return false;
+    if (key) *key = m_keys[best];
+    return true;
+}
+
+template <typename Accept>
+void ScreenPickIndex::collect(const QRectF& bounds, Accept accept, QVector<quint64>& keys) const {
+    if (m_order.isEmpty()) return;
+
+    QVector<int> hits;
+    for (int r = row(bounds.top()); r <= row(bounds.bottom()); ++r) {
+        for (int c = column(bounds.left()); c <= column(bounds.right()); ++c) {
+            const int cell = r * m_columns + c;
+            for (int j = m_cellStart[cell]; j < m_cellStart[cell + 1]; ++j) {
+                if (accept(m_positions[m_order[j]])) hits.append(m_order[j]);
+            }
+        }
+    }
+    std::sort(hits.begin(), hits.end());
+    for (int i : hits) {
+        keys.append(m_keys[i]);
+    }
+}
+
+void ScreenPickIndex::inRect(const QRectF& rect, QVector<quint64>& keys) const {
+    const QRectF r = rect.normalized();
+    collect(r, [&r](const QPointF& p) {
+        return p.x() >= r.left() && p.x() <= r.right() && p.y() >= r.top() && p.y() <= r.bottom();
+    }, keys);
+}
+
+void ScreenPickIndex::inPolygon(const QPolygonF& polygon, QVector<quint64>& keys) const {
+    if (polygon.size() < 3) return;
+    collect(polygon.boundingRect(), [&polygon](const QPointF& p) {
+        return polygon.containsPoint(p, Qt::OddEvenFill);
+    }, keys);
+}
+
+} // namespace CounterUAS
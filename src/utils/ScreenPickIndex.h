@@ -0,0 +1,59 @@
+#ifndef SCREENPICKINDEX_H
+#define SCREENPICKINDEX_H
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
+namespace CounterUAS {
+
+/**
+ * @brief Screen positions of one frame's symbols, for picking under the mouse
+ *
+ * A dense grid of cellSize squares over the view, filled once per
+ * rendered frame from the positions the symbols were drawn at: clear(),
+ * insert() each, then build(). A click, hover or drag then looks only at
+ * the few cells under it instead of projecting every track again.
+ * Points off the view are kept in its edge cells, so queries still find
+ * symbols partly outside it.
+ */
+class ScreenPickIndex {
+public:
+    explicit ScreenPickIndex(double cellSize = 32.0);
+
+    void setCellSize(double cellSize);   // From the next clear()
+    double cellSize() const { return m_cellSize; }
+
+    void clear(const QRectF& area);
+    void insert(quint64 key, const QPointF& position);
+    void build();
+
+    int size() const { return m_keys.size(); }
+    bool isEmpty() const { return m_keys.isEmpty(); }
+
+    // Key of the point nearest to position within radius; false if none
+    bool nearest(const QPointF& position, double radius, quint64* key) const;
+    // Keys of the points inside, appended in insertion order
+    void inRect(const QRectF& rect, QVector<quint64>& keys) const;
+    void inPolygon(const QPolygonF& polygon, QVector<quint64>& keys) const;
+
+private:
+    int column(double x) const;
+    int row(double y) const;
+    template <typename Accept>
+    void collect(const QRectF& bounds, Accept accept, QVector<quint64>& keys) const;
+
+    double m_cellSize;
+    QRectF m_area;
+    int m_columns = 0;
+    int m_rows = 0;
+    QVector<quint64> m_keys;        // Insertion order
+    QVector<QPointF> m_positions;
+    QVector<int> m_cellStart;       // Into m_order by cell, and the end
+    QVector<int> m_order;           // Point indices grouped by cell
+};
+
+} // namespace CounterUAS
+
+#endif // SCREENPICKINDEX_H
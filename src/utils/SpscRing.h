@@ -0,0 +1,146 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace CounterUAS {
+
+/**
+ * @brief Bounded lock-free ring for one producer
+ *
+ * Cells carry sequence numbers as in BoundedQueue, but only one thread
+ * pushes, so a push is a plain check and two stores with no CAS. Pops
+ * claim with a CAS so the producer may pop too, which is how a drop-oldest
+ * producer makes room without waiting on its consumer. tryPush() leaves
+ * the value alone when the ring is full, so the caller can evict and retry.
+ * Capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity = 64)
+        : m_mask(roundUp(capacity) - 1)
+    {
+        m_cells.reset(new Cell[m_mask + 1]);
+        for (std::size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only; moves from value on success
+    bool tryPush(T& value) {
+        const std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell& cell = m_cells[pos & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != pos) return false;  // Full
+        cell.value = std::move(value);
+        cell.sequence.store(pos + 1, std::memory_order_release);
+        m_tail.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer, or the producer evicting
+    bool tryPop(T& out) {
+        std::size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = m_cells[pos & m_mask];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(cell.value);
+                    cell.value = T();  // Don't pin payload memory for a whole lap
+                    cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Empty
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+    // Exact only while no push or pop is in flight
+    std::size_t sizeApprox() const {
+        std::size_t tail = m_tail.load(std::memory_order_acquire);
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t roundUp(std::size_t n) {
+        std::size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    alignas(64) std::atomic<std::size_t> m_head{0};
+};
+
+/**
+ * @brief Wait-free single-value mailbox: the reader always gets the newest
+ *
+ * A triple buffer. The writer fills its back slot and swaps it into the
+ * middle; the reader swaps the middle out for its front slot when the
+ * middle holds something new. Neither side ever waits on the other, and a
+ * value the reader never took is simply replaced by the next publish().
+ * One writer thread and one reader thread.
+ */
+template<typename T>
+class LatestSlot {
+public:
+    LatestSlot() = default;
+
+    LatestSlot(const LatestSlot&) = delete;
+    LatestSlot& operator=(const LatestSlot&) = delete;
+
+    // Writer only; true if it replaced a value the reader had not taken
+    bool publish(T value) {
+        m_slots[m_back] = std::move(value);
+        const unsigned previous = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+        return (previous & FRESH) != 0;
+    }
+
+    // Reader only
+    bool take(T& out) {
+        if (!(m_middle.load(std::memory_order_acquire) & FRESH)) return false;
+        const unsigned previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        out = std::move(m_slots[m_front]);
+        m_slots[m_front] = T();
+        return true;
+    }
+
+    bool hasValue() const { return (m_middle.load(std::memory_order_acquire) & FRESH) != 0; }
+
+private:
+    static constexpr unsigned INDEX_MASK = 0x3;
+    static constexpr unsigned FRESH = 0x4;
+
+    T m_slots[3];
+    alignas(64) std::atomic<unsigned> m_middle{1};
+    alignas(64) unsigned m_back = 0;     // Writer's
+    alignas(64) unsigned m_front = 2;    // Reader's
+};
+
+} // namespace CounterUAS
+
+#endif // SPSCRING_H
@@ -0,0 +1,102 @@
+#include "utils/StatusBoard.h"
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace CounterUAS {
+
+StatusBoard& StatusBoard::instance() {
+    static StatusBoard board;
+    return board;
+}
+
+StatusBoard::StatusBoard(QObject* parent)
+    : QObject(parent)
+{
+    // Displays read it on the GUI thread, whichever thread publishes first
+    if (!parent && QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+bool StatusBoard::publish(const QString& source, StatusKind kind, const QVariantHash& fields) {
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, StatusSnapshotPtr>& snapshots = m_snapshots[static_cast<int>(kind)];
+        const StatusSnapshotPtr previous = snapshots.value(source);
+        const bool fresh = !previous || previous->removed;
+
+        std::shared_ptr<StatusSnapshot> next;
+        const quint64 version = m_version.load(std::memory_order_relaxed) + 1;
+        for (auto it = fields.constBegin(); it != fields.constEnd(); ++it) {
+            if (!fresh) {
+                auto old = previous->fields.constFind(it.key());
+                if (old != previous->fields.constEnd() && old.value() == it.value()) continue;
+            }
+            if (!next) {
+                next = fresh ? std::make_shared<StatusSnapshot>() : std::make_shared<StatusSnapshot>(*previous);
+                next->source = source;
+                next->kind = kind;
+                next->version = version;
+            }
+            next->fields.insert(it.key(), it.value());
+            next->fieldVersions.insert(it.key(), version);
+        }
+        if (!next) return false;
+
+        snapshots.insert(source, next);
+        m_version.store(version, std::memory_order_release);
+    }
+    notify();
+    return true;
+}
+
+void StatusBoard::remove(const QString& source, StatusKind kind) {
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, StatusSnapshotPtr>& snapshots = m_snapshots[static_cast<int>(kind)];
+        const StatusSnapshotPtr previous = snapshots.value(source);
+        if (!previous || previous->removed) return;
+
+        auto next = std::make_shared<StatusSnapshot>(*previous);
+        next->version = m_version.load(std::memory_order_relaxed) + 1;
+        next->removed = true;
+        snapshots.insert(source, next);
+        m_version.store(next->version, std::memory_order_release);
+    }
+    notify();
+}
+
+StatusSnapshotPtr StatusBoard::snapshot(const QString& source, StatusKind kind) const {
+    QMutexLocker locker(&m_mutex);
+    return m_snapshots[static_cast<int>(kind)].value(source);
+}
+
+QVector<StatusSnapshotPtr> StatusBoard::changedSince(quint64 sinceVersion, quint32 kindMask) const {
+    QVector<StatusSnapshotPtr> changed;
+    if (version() <= sinceVersion) return changed;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (int kind = 0; kind < static_cast<int>(StatusKind::Count); ++kind) {
+            if (!(kindMask & kindBit(static_cast<StatusKind>(kind)))) continue;
+            for (const StatusSnapshotPtr& snapshot : m_snapshots[kind]) {
+                if (snapshot->version > sinceVersion) changed.append(snapshot);
+            }
+        }
+    }
+    std::sort(changed.begin(), changed.end(), [](const StatusSnapshotPtr& a, const StatusSnapshotPtr& b) {
+        return a->version < b->version;
+    });
+    return changed;
+}
+
+void StatusBoard::notify() {
+    // One queued emission until it has run, however many publish meanwhile
+    if (m_notifyPending.exchange(true, std::memory_order_acq_rel)) return;
+    QMetaObject::invokeMethod(this, [this]() {
+        m_notifyPending.store(false, std::memory_order_release);
+        emit published(version());
+    }, Qt::QueuedConnection);
+}
+
+} // namespace CounterUAS
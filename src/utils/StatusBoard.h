@@ -0,0 +1,103 @@
+#ifndef STATUSBOARD_H
+#define STATUSBOARD_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+namespace CounterUAS {
+
+/**
+ * @brief What kind of source published a status
+ */
+enum class StatusKind : quint8 {
+    Sensor = 0,
+    Effector,
+    Camera,
+    System,         // Whole-picture summaries, e.g. the threat counts
+    Count
+};
+
+/**
+ * @brief One source's status as last published
+ *
+ * Immutable once on the board. Every field carries the board version it
+ * last changed at, so a reader that remembers the version it last saw
+ * redraws only what moved since.
+ */
+struct StatusSnapshot {
+    QString source;
+    StatusKind kind = StatusKind::System;
+    quint64 version = 0;                    // Board version of the latest change
+    bool removed = false;                   // Gone; the fields are its last
+    QVariantHash fields;
+    QHash<QString, quint64> fieldVersions;
+
+    QVariant value(const QString& field) const { return fields.value(field); }
+    bool changed(const QString& field, quint64 sinceVersion) const {
+        return fieldVersions.value(field, 0) > sinceVersion;
+    }
+};
+
+using StatusSnapshotPtr = std::shared_ptr<const StatusSnapshot>;
+
+/**
+ * @brief Versioned status snapshots that displays subscribe to
+ *
+ * Sources (sensors, effectors, cameras, the threat assessor) publish
+ * their status as named fields whenever they have it, from any thread.
+ * A source is named by its kind and id, so a camera's video stream and
+ * the camera's detector may share an id.
+ * A publication is merged into the source's snapshot, and only fields
+ * whose value differs from the one on the board count as a change: a
+ * source that republishes the same health every second leaves the board,
+ * and every display reading it, alone.
+ *
+ * Each change takes the next board version. Readers keep the version they
+ * last saw and ask for what changed since; the UIFrameScheduler does that
+ * for its clients and hands them the changed snapshots in their frames,
+ * and published() is what wakes it. It is emitted queued on the board's
+ * thread, once for any burst of publications.
+ */
+class StatusBoard : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr quint32 ALL_KINDS = 0xFFFFFFFFu;
+
+    static StatusBoard& instance();
+
+    explicit StatusBoard(QObject* parent = nullptr);
+
+    // True if any field changed
+    bool publish(const QString& source, StatusKind kind, const QVariantHash& fields);
+    // Leaves a removed snapshot, so readers see it go
+    void remove(const QString& source, StatusKind kind);
+
+    StatusSnapshotPtr snapshot(const QString& source, StatusKind kind) const;
+    // Of the kinds in kindMask, changed after sinceVersion; oldest first
+    QVector<StatusSnapshotPtr> changedSince(quint64 sinceVersion, quint32 kindMask = ALL_KINDS) const;
+    quint64 version() const { return m_version.load(std::memory_order_acquire); }
+
+    static quint32 kindBit(StatusKind kind) { return 1u << static_cast<int>(kind); }
+
+signals:
+    void published(quint64 version);
+
+private:
+    void notify();
+
+    mutable QMutex m_mutex;
+    QHash<QString, StatusSnapshotPtr> m_snapshots[static_cast<int>(StatusKind::Count)];   // By kind, then source
+    std::atomic<quint64> m_version{0};
+    std::atomic<bool> m_notifyPending{false};
+};
+
+} // namespace CounterUAS
+
+#endif // STATUSBOARD_H
@@ -0,0 +1,242 @@
+#include "utils/TaskScheduler.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/TimeUtils.h"
+#include <QMutexLocker>
+#include <QThread>
+
+namespace CounterUAS {
+
+namespace {
+
+// Set on a scheduler's worker threads, for submissions to stay local
+thread_local TaskScheduler* t_scheduler = nullptr;
+thread_local int t_workerIndex = -1;
+
+} // namespace
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler(qMax(2, QThread::idealThreadCount()));
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(int workers) {
+    for (int p = 0; p < TASK_PRIORITIES; ++p) {
+        m_submitted[p] = 0;
+        m_executed[p] = 0;
+    }
+    const int count = qMax(1, workers);
+    for (int i = 0; i < count; ++i) {
+        m_workers.emplace_back(new Worker);
+    }
+    for (int i = 0; i < count; ++i) {
+        QThread* thread = QThread::create([this, i]() { workerLoop(i); });
+        thread->setObjectName(QString("TaskWorker-%1").arg(i));
+        m_workers[i]->thread = thread;
+        thread->start();
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    for (auto& worker : m_workers) {
+        worker->thread->wait();
+        delete worker->thread;
+    }
+}
+
+void TaskScheduler::submit(Task task, TaskPriority priority) {
+    const int p = static_cast<int>(priority);
+    const int n = workerCount();
+    const int target = t_scheduler == this ? t_workerIndex
+                                           : static_cast<int>(m_nextWorker.fetch_add(1, std::memory_order_relaxed) % n);
+    {
+        Worker& worker = *m_workers[target];
+        QMutexLocker locker(&worker.mutex);
+        worker.queues[p].push_back(Item{std::move(task), TimeUtils::monotonicNs()});
+    }
+    m_submitted[p].fetch_add(1, std::memory_order_relaxed);
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    QMutexLocker locker(&m_sleepMutex);
+    m_wake.wakeOne();
+}
+
+bool TaskScheduler::runOne(TaskPriority lowest) {
+    Item item;
+    int priority = 0;
+    const int self = t_scheduler == this ? t_workerIndex : -1;
+    if (!take(self, static_cast<int>(lowest), item, priority)) return false;
+    m_helped.fetch_add(1, std::memory_order_relaxed);
+    execute(item, priority);
+    return true;
+}
+
+void TaskScheduler::workerLoop(int self) {
+    t_scheduler = this;
+    t_workerIndex = self;
+
+    Item item;
+    int priority = 0;
+    while (true) {
+        if (take(self, TASK_PRIORITIES - 1, item, priority)) {
+            execute(item, priority);
+            item = Item();
+            continue;
+        }
+        QMutexLocker locker(&m_sleepMutex);
+        if (m_queued.load(std::memory_order_acquire) > 0) continue;
+        if (m_stopping) break;
+        m_wake.wait(&m_sleepMutex);
+    }
+}
+
+bool TaskScheduler::take(int self, int lowest, Item& item, int& priority) {
+    if (m_queued.load(std::memory_order_acquire) == 0) return false;
+
+    const int n = workerCount();
+    const int start = self >= 0 ? self : static_cast<int>(m_nextWorker.load(std::memory_order_relaxed) % n);
+    for (int p = 0; p <= lowest; ++p) {
+        // Own work newest first; anyone else's oldest first
+        if (self >= 0) {
+            Worker& worker = *m_workers[self];
+            QMutexLocker locker(&worker.mutex);
+            std::deque<Item>& queue = worker.queues[p];
+            if (!queue.empty()) {
+                item = std::move(queue.back());
+                queue.pop_back();
+                priority = p;
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (int i = 0; i < n; ++i) {
+            const int victim = (start + i) % n;
+            if (victim == self) continue;
+            Worker& worker = *m_workers[victim];
+            QMutexLocker locker(&worker.mutex);
+            std::deque<Item>& queue = worker.queues[p];
+            if (!queue.empty()) {
+                item = std::move(queue.front());
+                queue.pop_front();
+                priority = p;
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                if (self >= 0) m_stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::execute(Item& item, int priority) {
+    m_latency[priority].record((TimeUtils::monotonicNs() - item.submittedNs) / 1000);
+    item.task();
+    m_executed[priority].fetch_add(1, std::memory_order_relaxed);
+}
+
+TaskScheduler::Stats TaskScheduler::stats() const {
+    Stats s;
+    for (int p = 0; p < TASK_PRIORITIES; ++p) {
+        s.submitted[p] = m_submitted[p].load(std::memory_order_relaxed);
+        s.executed[p] = m_executed[p].load(std::memory_order_relaxed);
+    }
+    s.stolen = m_stolen.load(std::memory_order_relaxed);
+    s.helped = m_helped.load(std::memory_order_relaxed);
+    return s;
+}
+
+LatencyHistogramSnapshot TaskScheduler::queueLatency(TaskPriority priority) const {
+    return m_latency[static_cast<int>(priority)].snapshot();
+}
+
+void TaskScheduler::exportTo(MetricsRegistry& registry) const {
+    for (int p = 0; p < TASK_PRIORITIES; ++p) {
+        registry.addHistogram("cuas_task_queue_seconds", "Time tasks wait for a scheduler worker by priority class",
+                              {{"priority", priorityKey(static_cast<TaskPriority>(p))}}, &m_latency[p]);
+    }
+}
+
+const char* TaskScheduler::priorityKey(TaskPriority priority) {
+    switch (priority) {
+    case TaskPriority::Realtime: return "realtime";
+    case TaskPriority::Interactive: return "interactive";
+    case TaskPriority::Background: return "background";
+    default: return "";
+    }
+}
+
+// TaskGraph
+
+TaskGraph::TaskGraph(TaskPriority priority, TaskScheduler* scheduler)
+    : m_scheduler(scheduler ? scheduler : &TaskScheduler::instance())
+    , m_priority(priority)
+{
+}
+
+TaskGraph::~TaskGraph() {
+    wait();
+}
+
+int TaskGraph::add(TaskScheduler::Task task) {
+    Node node;
+    node.task = std::move(task);
+    node.waiting.reset(new std::atomic<int>(0));
+    m_nodes.push_back(std::move(node));
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void TaskGraph::precede(int before, int after) {
+    m_nodes[before].successors.append(after);
+    m_nodes[after].prerequisites++;
+}
+
+void TaskGraph::clear() {
+    wait();
+    m_nodes.clear();
+}
+
+void TaskGraph::run() {
+    if (m_nodes.empty()) return;
+    m_remaining.store(static_cast<int>(m_nodes.size()), std::memory_order_release);
+    for (Node& node : m_nodes) {
+        node.waiting->store(node.prerequisites, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < static_cast<int>(m_nodes.size()); ++i) {
+        if (m_nodes[i].prerequisites == 0) submitNode(i);
+    }
+}
+
+void TaskGraph::wait() {
+    while (true) {
+        if (!isDone() && m_scheduler->runOne(m_priority)) continue;
+        // Concluded under the mutex, which the last node holds while it finishes
+        QMutexLocker locker(&m_mutex);
+        if (m_remaining.load(std::memory_order_acquire) == 0) return;
+        m_done.wait(&m_mutex, 1);
+    }
+}
+
+void TaskGraph::submitNode(int index) {
+    m_scheduler->submit([this, index]() {
+        m_nodes[index].task();
+        finishNode(index);
+    }, m_priority);
+}
+
+void TaskGraph::finishNode(int index) {
+    for (int successor : m_nodes[index].successors) {
+        if (m_nodes[successor].waiting->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            submitNode(successor);
+        }
+    }
+    QMutexLocker locker(&m_mutex);
+    if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_done.wakeAll();
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,158 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+#include <QtGlobal>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "utils/LatencyHistogram.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+class MetricsRegistry;
+
+/**
+ * @brief Priority class of a scheduled task, most urgent first
+ */
+enum class TaskPriority : quint8 {
+    Realtime = 0,       // Inside the track and assessment cycles
+    Interactive,        // Work a display is waiting on
+    Background          // Encoding, file and database I/O
+};
+
+constexpr int TASK_PRIORITIES = 3;
+
+/**
+ * @brief Shared work-stealing executor for short background tasks
+ *
+ * Each worker keeps one deque per priority. A worker's own submissions go
+ * on its deques and it takes the newest first, while it is cache-warm;
+ * other threads' submissions are dealt round robin. An idle worker takes
+ * the oldest task of the most urgent non-empty class from the other
+ * workers. Priority is strict across the pool: no Background task starts
+ * while a Realtime one is queued anywhere.
+ *
+ * For tasks that run briefly and return. Loops that own a device or a file
+ * for their lifetime (capture, writers, encoders) keep their own threads.
+ * queueLatency() histograms the time from submit to start per class.
+ */
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+
+    // The process-wide scheduler, one worker per core (at least two)
+    static TaskScheduler& instance();
+
+    explicit TaskScheduler(int workers);
+    ~TaskScheduler();   // Runs what is queued, then joins the workers
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void submit(Task task, TaskPriority priority = TaskPriority::Background);
+
+    // Runs one queued task of the given class or a more urgent one on the
+    // calling thread; false if there was none. Lets a waiting thread help.
+    bool runOne(TaskPriority lowest = TaskPriority::Background);
+
+    int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+    struct Stats {
+        quint64 submitted[TASK_PRIORITIES] = {};
+        quint64 executed[TASK_PRIORITIES] = {};
+        quint64 stolen = 0;             // Taken from another worker's deques
+        quint64 helped = 0;             // Run by a waiting thread through runOne()
+    };
+    Stats stats() const;
+    LatencyHistogramSnapshot queueLatency(TaskPriority priority) const;
+
+    // Exports the queue latencies, labelled by class; the registry must not outlive this
+    void exportTo(MetricsRegistry& registry) const;
+    static const char* priorityKey(TaskPriority priority);
+
+private:
+    struct Item {
+        Task task;
+        qint64 submittedNs = 0;
+    };
+
+    struct Worker {
+        QMutex mutex;
+        std::deque<Item> queues[TASK_PRIORITIES];
+        QThread* thread = nullptr;
+    };
+
+    void workerLoop(int self);
+    // From self's deques (newest) or another worker's (oldest); self -1 for a non-worker
+    bool take(int self, int lowest, Item& item, int& priority);
+    void execute(Item& item, int priority);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<int> m_queued{0};
+    std::atomic<unsigned> m_nextWorker{0};
+    QMutex m_sleepMutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;            // Under m_sleepMutex
+
+    std::atomic<quint64> m_submitted[TASK_PRIORITIES];
+    std::atomic<quint64> m_executed[TASK_PRIORITIES];
+    std::atomic<quint64> m_stolen{0};
+    std::atomic<quint64> m_helped{0};
+    LatencyHistogram m_latency[TASK_PRIORITIES];
+};
+
+/**
+ * @brief Tasks with dependencies, run on a TaskScheduler
+ *
+ * Nodes are added with add() and ordered with precede(); the graph must be
+ * acyclic. run() submits the nodes without prerequisites, and each node is
+ * submitted once its last prerequisite has finished. wait() returns when
+ * every node has; the waiting thread runs queued tasks of the graph's
+ * class or more urgent ones meanwhile, so waiting inside a task cannot
+ * starve the pool. A graph can be run again once waited for, and clear()
+ * empties it for reuse. The destructor waits.
+ */
+class TaskGraph {
+public:
+    explicit TaskGraph(TaskPriority priority = TaskPriority::Realtime, TaskScheduler* scheduler = nullptr);
+    ~TaskGraph();
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    int add(TaskScheduler::Task task);      // Node index
+    void precede(int before, int after);    // after starts once before has finished
+    void clear();
+    int size() const { return static_cast<int>(m_nodes.size()); }
+
+    void run();
+    void wait();
+    bool isDone() const { return m_remaining.load(std::memory_order_acquire) == 0; }
+
+private:
+    struct Node {
+        TaskScheduler::Task task;
+        QVector<int> successors;
+        int prerequisites = 0;
+        std::unique_ptr<std::atomic<int>> waiting;  // Prerequisites still running in this run
+    };
+
+    void submitNode(int index);
+    void finishNode(int index);
+
+    TaskScheduler* m_scheduler;
+    TaskPriority m_priority;
+    std::vector<Node> m_nodes;
+    std::atomic<int> m_remaining{0};
+    QMutex m_mutex;
+    QWaitCondition m_done;
+};
+
+} // namespace CounterUAS
+
+#endif // TASKSCHEDULER_H
@@ -0,0 +1,155 @@
+#include "utils/TerrainModel.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace CounterUAS {
+
+TerrainModel::TerrainModel(double baseElevationM)
+    : m_baseElevationM(baseElevationM)
+{
+    updateFingerprint();
+}
+
+void TerrainModel::setGrid(double southLatitude, double westLongitude, double cellDeg,
+                           int columns, int rows, const QVector<float>& heights) {
+    if (columns < 2 || rows < 2 || cellDeg <= 0.0 || heights.size() != columns * rows) {
+        m_heights.clear();
+        m_columns = m_rows = 0;
+    } else {
+        m_southLatitude = southLatitude;
+        m_westLongitude = westLongitude;
+        m_cellDeg = cellDeg;
+        m_columns = columns;
+        m_rows = rows;
+        m_heights = heights;
+    }
+    updateFingerprint();
+}
+
+bool TerrainModel::loadAsciiGrid(const QString& path, QString* error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    QTextStream in(&file);
+    int columns = 0;
+    int rows = 0;
+    double x = 0.0;
+    double y = 0.0;
+    double cell = 0.0;
+    double noData = -9999.0;
+    bool centred = false;
+    // Six header lines, any order, then the posts
+    for (int i = 0; i < 6; ++i) {
+        QString key;
+        in >> key;
+        key = key.toLower();
+        if (key == "ncols") in >> columns;
+        else if (key == "nrows") in >> rows;
+        else if (key == "xllcorner") in >> x;
+        else if (key == "yllcorner") in >> y;
+        else if (key == "xllcenter") { in >> x; centred = true; }
+        else if (key == "yllcenter") { in >> y; centred = true; }
+        else if (key == "cellsize") in >> cell;
+        else if (key == "nodata_value") in >> noData;
+        else {
+            if (error) *error = "Unexpected header field " + key;
+            return false;
+        }
+    }
+    if (columns < 2 || rows < 2 || cell <= 0.0) {
+        if (error) *error = "Bad grid header";
+        return false;
+    }
+
+    // Rows come north first; posts sit at cell centres
+    QVector<float> heights(columns * rows);
+    for (int row = rows - 1; row >= 0; --row) {
+        for (int column = 0; column < columns; ++column) {
+            double value = 0.0;
+            in >> value;
+            if (in.status() != QTextStream::Ok) {
+                if (error) *error = "Grid ends early";
+                return false;
+            }
+            heights[row * columns + column] = value == noData ? NO_DATA : float(value);
+        }
+    }
+
+    const double half = centred ? 0.0 : cell / 2.0;
+    setGrid(y + half, x + half, cell, columns, rows, heights);
+    return true;
+}
+
+float TerrainModel::post(int column, int row) const {
+    return m_heights[row * m_columns + column];
+}
+
+void TerrainModel::setDemStore(const DemTileStorePtr& store) {
+    m_dem = store;
+    updateFingerprint();
+}
+
+bool TerrainModel::gridElevation(double latitude, double longitude, double& elevation) const {
+    if (m_heights.isEmpty()) return false;
+
+    const double u = (longitude - m_westLongitude) / m_cellDeg;
+    const double v = (latitude - m_southLatitude) / m_cellDeg;
+    if (u < 0.0 || v < 0.0 || u > m_columns - 1 || v > m_rows - 1) return false;
+
+    const int column = qMin(int(u), m_columns - 2);
+    const int row = qMin(int(v), m_rows - 2);
+    const double fu = u - column;
+    const double fv = v - row;
+    const float sw = post(column, row);
+    const float se = post(column + 1, row);
+    const float nw = post(column, row + 1);
+    const float ne = post(column + 1, row + 1);
+    if (sw == NO_DATA || se == NO_DATA || nw == NO_DATA || ne == NO_DATA) return false;
+
+    const double south = sw + (se - sw) * fu;
+    const double north = nw + (ne - nw) * fu;
+    elevation = south + (north - south) * fv;
+    return true;
+}
+
+double TerrainModel::elevationM(double latitude, double longitude) const {
+    double elevation = m_baseElevationM;
+    if (gridElevation(latitude, longitude, elevation)) return elevation;
+    if (m_dem && m_dem->elevationM(latitude, longitude, elevation)) return elevation;
+    return m_baseElevationM;
+}
+
+void TerrainModel::elevationsM(const double* latitudes, const double* longitudes, double* elevations,
+                               int count) const {
+    // Tiles in one pass, then the grid over them where it has the point
+    if (m_dem) {
+        m_dem->elevationsM(latitudes, longitudes, elevations, count, m_baseElevationM);
+    } else {
+        std::fill(elevations, elevations + count, m_baseElevationM);
+    }
+    if (m_heights.isEmpty()) return;
+    for (int i = 0; i < count; ++i) {
+        gridElevation(latitudes[i], longitudes[i], elevations[i]);
+    }
+}
+
+void TerrainModel::updateFingerprint() {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const double header[] = { m_baseElevationM, m_southLatitude, m_westLongitude, m_cellDeg,
+                              double(m_columns), double(m_rows) };
+    hash.addData(reinterpret_cast<const char*>(header), sizeof(header));
+    hash.addData(reinterpret_cast<const char*>(m_heights.constData()), m_heights.size() * int(sizeof(float)));
+    const quint64 tiles = m_dem ? m_dem->fingerprint() : 0;
+    hash.addData(reinterpret_cast<const char*>(&tiles), sizeof(tiles));
+    const QByteArray digest = hash.result();
+    std::memcpy(&m_fingerprint, digest.constData(), sizeof(m_fingerprint));
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,76 @@
+#ifndef TERRAINMODEL_H
+#define TERRAINMODEL_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+#include "core/Track.h"
+#include "utils/DemTileStore.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Ground elevation over a regular latitude/longitude grid
+ *
+ * Heights above mean sea level are posted every cellDeg from the south-west
+ * corner, row 0 southernmost, and interpolated bilinearly between posts.
+ * Outside the grid, or on a missing post, a DEM tile store answers if one
+ * is set; where neither has the point the ground is flat at the base
+ * elevation. Immutable once shared, so any thread may read it.
+ */
+class TerrainModel {
+public:
+    static constexpr float NO_DATA = -32768.0f;
+
+    explicit TerrainModel(double baseElevationM = 0.0);
+
+    // heights holds columns * rows posts, row by row from the south; NO_DATA
+    // marks a missing one
+    void setGrid(double southLatitude, double westLongitude, double cellDeg,
+                 int columns, int rows, const QVector<float>& heights);
+    // ESRI ASCII grid (.asc), as GDAL exports DTED/SRTM tiles; cell sizes in degrees
+    bool loadAsciiGrid(const QString& path, QString* error = nullptr);
+
+    // Wide-area ground under the grid, such as SRTM tiles
+    void setDemStore(const DemTileStorePtr& store);
+    DemTileStorePtr demStore() const { return m_dem; }
+
+    double elevationM(double latitude, double longitude) const;
+    void elevationsM(const double* latitudes, const double* longitudes, double* elevations, int count) const;
+    double baseElevationM() const { return m_baseElevationM; }
+    bool hasGrid() const { return !m_heights.isEmpty(); }
+
+    // GeoPosition altitudes are above the ground under them
+    double toMslM(const GeoPosition& position) const {
+        return elevationM(position.latitude, position.longitude) + position.altitude;
+    }
+    double toAglM(double latitude, double longitude, double mslM) const {
+        return mslM - elevationM(latitude, longitude);
+    }
+
+    // Changes with the grid, the tiles and the base, for keying what was
+    // derived from it
+    quint64 fingerprint() const { return m_fingerprint; }
+
+private:
+    float post(int column, int row) const;
+    bool gridElevation(double latitude, double longitude, double& elevation) const;
+    void updateFingerprint();
+
+    double m_baseElevationM = 0.0;
+    double m_southLatitude = 0.0;
+    double m_westLongitude = 0.0;
+    double m_cellDeg = 1.0;
+    int m_columns = 0;
+    int m_rows = 0;
+    QVector<float> m_heights;
+    DemTileStorePtr m_dem;
+    quint64 m_fingerprint = 0;
+};
+
+using TerrainModelPtr = std::shared_ptr<const TerrainModel>;
+
+} // namespace CounterUAS
+
+#endif // TERRAINMODEL_H
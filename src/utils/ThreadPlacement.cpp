@@ -0,0 +1,187 @@
+#include "utils/ThreadPlacement.h"
+#include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include <QMutexLocker>
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+
+#if defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#endif
+
+namespace CounterUAS {
+
+ThreadPlacement& ThreadPlacement::instance() {
+    static ThreadPlacement placement;
+    return placement;
+}
+
+ThreadPlacement::ThreadPlacement() {
+    for (int r = 0; r < THREAD_ROLES; ++r) {
+        m_deadlineUs[r] = 0;
+        m_cycles[r] = 0;
+        m_missed[r] = 0;
+        m_worstUs[r] = 0;
+        const MetricLabels labels = {{"role", roleKey(static_cast<ThreadRole>(r))}};
+        m_missedMetric[r] = MetricsRegistry::instance().counter(
+            "cuas_thread_deadline_misses_total", "Role cycles that overran their deadline", labels);
+    }
+}
+
+void ThreadPlacement::setConfig(ThreadRole role, const ThreadRoleConfig& config) {
+    const int r = static_cast<int>(role);
+    QMutexLocker locker(&m_mutex);
+    m_configs[r] = config;
+    m_deadlineUs[r].store(qMax(0, config.deadlineUs), std::memory_order_relaxed);
+}
+
+ThreadRoleConfig ThreadPlacement::config(ThreadRole role) const {
+    QMutexLocker locker(&m_mutex);
+    return m_configs[static_cast<int>(role)];
+}
+
+QVector<int> ThreadPlacement::cpusLocked(int role) const {
+    if (!m_configs[role].cpus.isEmpty()) return m_configs[role].cpus;
+
+    QVector<int> reserved;
+    for (int r = 0; r < THREAD_ROLES; ++r) {
+        if (r != role && m_configs[r].isolated) reserved += m_configs[r].cpus;
+    }
+    if (reserved.isEmpty()) return {};
+
+    QVector<int> cpus;
+    const int count = QThread::idealThreadCount();
+    for (int cpu = 0; cpu < count; ++cpu) {
+        if (!reserved.contains(cpu)) cpus.append(cpu);
+    }
+    return cpus;    // Every core reserved leaves the thread unpinned
+}
+
+bool ThreadPlacement::enter(ThreadRole role) {
+    const int r = static_cast<int>(role);
+    QVector<int> cpus;
+    int priority = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        cpus = cpusLocked(r);
+        priority = qBound(0, m_configs[r].realtimePriority, 99);
+        m_threads[r]++;
+    }
+
+    bool placed = true;
+#if defined(Q_OS_LINUX)
+    if (!cpus.isEmpty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : qAsConst(cpus)) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        const int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            placed = false;
+            warnOnce(r, QString("Affinity for %1 refused: %2").arg(roleKey(role), strerror(err)));
+        }
+    }
+    if (priority > 0) {
+        sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            // Without CAP_SYS_NICE or an rtprio limit; the highest normal priority instead
+            placed = false;
+            QThread::currentThread()->setPriority(QThread::TimeCriticalPriority);
+            warnOnce(r, QString("SCHED_FIFO %1 for %2 refused (%3), running at normal policy")
+                     .arg(priority).arg(roleKey(role), strerror(err)));
+        }
+    }
+#else
+    // No affinity here; a real-time role gets the highest priority Qt offers
+    if (priority > 0) {
+        QThread::currentThread()->setPriority(QThread::TimeCriticalPriority);
+    }
+#endif
+
+    if (!placed) {
+        QMutexLocker locker(&m_mutex);
+        m_failures[r]++;
+    }
+    return placed;
+}
+
+void ThreadPlacement::assign(QThread* thread, ThreadRole role) {
+    QObject::connect(thread, &QThread::started, thread, [this, role]() { enter(role); },
+                     Qt::DirectConnection);
+}
+
+void ThreadPlacement::warnOnce(int role, const QString& message) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_warned[role]) return;
+        m_warned[role] = true;
+    }
+    Logger::instance().warning("ThreadPlacement", message);
+}
+
+void ThreadPlacement::reportCycle(ThreadRole role, qint64 elapsedUs, qint64 budgetUs) {
+    const int r = static_cast<int>(role);
+    m_cycles[r].fetch_add(1, std::memory_order_relaxed);
+
+    qint64 worst = m_worstUs[r].load(std::memory_order_relaxed);
+    while (elapsedUs > worst &&
+           !m_worstUs[r].compare_exchange_weak(worst, elapsedUs, std::memory_order_relaxed)) {
+    }
+
+    const qint64 deadline = m_deadlineUs[r].load(std::memory_order_relaxed);
+    const qint64 budget = deadline > 0 ? deadline : budgetUs;
+    if (budget > 0 && elapsedUs > budget) {
+        m_missed[r].fetch_add(1, std::memory_order_relaxed);
+        m_missedMetric[r]->add();
+    }
+}
+
+ThreadRoleStats ThreadPlacement::stats(ThreadRole role) const {
+    const int r = static_cast<int>(role);
+    ThreadRoleStats s;
+    {
+        QMutexLocker locker(&m_mutex);
+        s.threads = m_threads[r];
+        s.placementFailures = m_failures[r];
+    }
+    s.cycles = m_cycles[r].load(std::memory_order_relaxed);
+    s.missed = m_missed[r].load(std::memory_order_relaxed);
+    s.worstUs = m_worstUs[r].load(std::memory_order_relaxed);
+    return s;
+}
+
+const char* ThreadPlacement::roleKey(ThreadRole role) {
+    switch (role) {
+    case ThreadRole::Fusion: return "fusion";
+    case ThreadRole::SensorIO: return "sensorIo";
+    case ThreadRole::PtzControl: return "ptzControl";
+    case ThreadRole::VideoDecode: return "videoDecode";
+    case ThreadRole::Render: return "render";
+    default: return "";
+    }
+}
+
+QVector<int> ThreadPlacement::parseCpuList(const QString& text) {
+    QVector<int> cpus;
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts)) {
+        const QStringList range = part.trimmed().split('-');
+        bool okFirst = false;
+        bool okLast = false;
+        const int first = range.value(0).trimmed().toInt(&okFirst);
+        const int last = range.size() == 2 ? range.value(1).trimmed().toInt(&okLast) : first;
+        if (!okFirst || (range.size() == 2 && !okLast) || range.size() > 2) continue;
+        for (int cpu = qMax(0, first); cpu <= last; ++cpu) {
+            if (!cpus.contains(cpu)) cpus.append(cpu);
+        }
+    }
+    return cpus;
+}
+
+} // namespace CounterUAS
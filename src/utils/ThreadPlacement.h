@@ -0,0 +1,108 @@
+#ifndef THREADPLACEMENT_H
+#define THREADPLACEMENT_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+
+class QThread;
+
+namespace CounterUAS {
+
+class MetricCounter;
+
+/**
+ * @brief What a thread does, for placing it on the console's cores
+ */
+enum class ThreadRole : quint8 {
+    Fusion = 0,         // Track manager and detection drain
+    SensorIO,           // Sensor and network sockets, serial links and their parsing
+    PtzControl,         // Slew control loop
+    VideoDecode,        // Capture, decode and scaling of video
+    Render              // The GUI thread and offscreen display rendering
+};
+
+constexpr int THREAD_ROLES = 5;
+
+/**
+ * @brief Placement of one role's threads
+ */
+struct ThreadRoleConfig {
+    QVector<int> cpus;          // Cores to pin to; empty runs on any core no isolated role holds
+    bool isolated = false;      // Its cores are kept from every role without cpus of its own
+    int realtimePriority = 0;   // SCHED_FIFO priority 1-99 where permitted; 0 keeps the default policy
+    int deadlineUs = 0;         // Cycle budget for the miss count; 0 takes the caller's
+};
+
+/**
+ * @brief Per role placement and deadline counters
+ */
+struct ThreadRoleStats {
+    int threads = 0;            // Placed through enter()
+    int placementFailures = 0;  // Affinity or priority refused by the OS
+    quint64 cycles = 0;
+    quint64 missed = 0;         // Cycles over their budget
+    qint64 worstUs = 0;
+};
+
+/**
+ * @brief Process-wide thread placement by role
+ *
+ * Threads say what they are, first thing once running: enter() for a
+ * thread running a loop of its own, assign() before start() for a QThread
+ * with an event loop. Each is then pinned and prioritised as its role is
+ * configured; threads of roles without cores of their own are pinned off
+ * the isolated roles' cores, which keeps video decode off fusion's. A
+ * priority the OS refuses (no CAP_SYS_NICE or rtprio limit) is logged
+ * once per role and the thread runs at its default.
+ *
+ * The roles' periodic work reports each cycle's duration through
+ * reportCycle(), which counts those over budget, exported as
+ * cuas_thread_deadline_misses_total{role=...}. Placement is decided when a
+ * thread enters, so configure before the threads start.
+ */
+class ThreadPlacement {
+public:
+    static ThreadPlacement& instance();
+
+    void setConfig(ThreadRole role, const ThreadRoleConfig& config);
+    ThreadRoleConfig config(ThreadRole role) const;
+
+    // Places the calling thread; false if the OS refused part of it
+    bool enter(ThreadRole role);
+    void assign(QThread* thread, ThreadRole role);
+
+    // budgetUs is the cycle's natural period, used unless the role sets a deadline
+    void reportCycle(ThreadRole role, qint64 elapsedUs, qint64 budgetUs = 0);
+
+    ThreadRoleStats stats(ThreadRole role) const;
+
+    static const char* roleKey(ThreadRole role);
+    // "0-1,4" to {0, 1, 4}; malformed parts are skipped
+    static QVector<int> parseCpuList(const QString& text);
+
+private:
+    ThreadPlacement();
+
+    // Cores a thread of the role is pinned to; empty leaves it unpinned
+    QVector<int> cpusLocked(int role) const;
+    void warnOnce(int role, const QString& message);
+
+    mutable QMutex m_mutex;
+    ThreadRoleConfig m_configs[THREAD_ROLES];
+    bool m_warned[THREAD_ROLES] = {};
+    int m_threads[THREAD_ROLES] = {};
+    int m_failures[THREAD_ROLES] = {};
+
+    std::atomic<qint64> m_deadlineUs[THREAD_ROLES];
+    std::atomic<quint64> m_cycles[THREAD_ROLES];
+    std::atomic<quint64> m_missed[THREAD_ROLES];
+    std::atomic<qint64> m_worstUs[THREAD_ROLES];
+    MetricCounter* m_missedMetric[THREAD_ROLES] = {};
+};
+
+} // namespace CounterUAS
+
+#endif // THREADPLACEMENT_H
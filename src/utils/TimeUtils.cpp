@@ -1,4 +1,5 @@
 #include "utils/TimeUtils.h"
+#include <chrono>
 
 namespace CounterUAS {
 
@@ -41,4 +42,9 @@ QDateTime TimeUtils::fromZulu(const QString& zulu) {
     return QDateTime::fromString(zulu, "yyyyMMdd'T'HHmmss'Z'");
 }
 
+qint64 TimeUtils::monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 } // namespace CounterUAS
@@ -14,6 +14,9 @@ public:
     static qint64 parseTimestamp(const QString& str);
     static QString zuluTime();
     static QDateTime fromZulu(const QString& zulu);
+    
+    // Monotonic clock shared by all threads, for latency measurement only
+    static qint64 monotonicNs();
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,187 @@
+#include "utils/TimerService.h"
+#include "utils/TimeUtils.h"
+#include <QMutexLocker>
+#include <QThread>
+
+namespace CounterUAS {
+
+TimerService& TimerService::instance() {
+    static TimerService service;
+    return service;
+}
+
+TimerService::TimerService(int tickMs, int buckets)
+    : m_wheel(tickMs, buckets)
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("TimerService");
+    m_thread->start();
+}
+
+TimerService::~TimerService() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+qint64 TimerService::nowMs() {
+    return TimeUtils::monotonicNs() / 1000000;
+}
+
+TimerService::TimerId TimerService::schedule(QObject* context, int delayMs, std::function<void()> callback,
+                                             int intervalMs) {
+    if (!context || !callback) return 0;
+
+    Timer timer;
+    timer.context = context;
+    timer.state = std::make_shared<State>();
+    timer.state->callback = std::move(callback);
+    timer.intervalMs = qMax(0, intervalMs);
+    timer.dueMs = nowMs() + qMax(0, delayMs);
+
+    QMutexLocker locker(&m_mutex);
+    const TimerId id = m_nextId++;
+    timer.guard = QObject::connect(context, &QObject::destroyed, [this, id]() { cancel(id); });
+    timer.wheelId = m_wheel.schedule(timer.dueMs, id);
+    const qint64 dueMs = timer.dueMs;
+    m_timers.insert(id, std::move(timer));
+    m_stats.scheduled++;
+    if (m_sleepUntilMs < 0 || dueMs < m_sleepUntilMs) {
+        m_wake.wakeOne();
+    }
+    return id;
+}
+
+bool TimerService::cancel(TimerId id) {
+    QMetaObject::Connection guard;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_timers.find(id);
+        if (it == m_timers.end()) return false;
+        m_wheel.cancel(it->wheelId);
+        it->state->live.store(false, std::memory_order_release);
+        guard = it->guard;
+        m_timers.erase(it);
+    }
+    QObject::disconnect(guard);
+    return true;
+}
+
+bool TimerService::isPending(TimerId id) const {
+    QMutexLocker locker(&m_mutex);
+    return m_timers.contains(id);
+}
+
+int TimerService::pendingCount() const {
+    QMutexLocker locker(&m_mutex);
+    return m_timers.size();
+}
+
+TimerService::Stats TimerService::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void TimerService::run() {
+    QVector<quint64> expired;
+    QMutexLocker locker(&m_mutex);
+    while (!m_stopping) {
+        const qint64 now = nowMs();
+        expired.clear();
+        m_wheel.advance(now, expired);
+        for (quint64 id : qAsConst(expired)) {
+            fireLocked(id, now);
+        }
+
+        m_sleepUntilMs = m_wheel.nextDueMs();
+        if (m_sleepUntilMs < 0) {
+            m_wake.wait(&m_mutex);
+        } else {
+            m_wake.wait(&m_mutex, static_cast<unsigned long>(qMax<qint64>(1, m_sleepUntilMs - nowMs())));
+        }
+        m_stats.wakeups++;
+    }
+}
+
+void TimerService::fireLocked(TimerId id, qint64 now) {
+    auto it = m_timers.find(id);
+    if (it == m_timers.end()) return;     // Cancelled
+    Timer& timer = *it;
+    const bool oneShot = timer.intervalMs == 0;
+
+    // Posted under m_mutex: the context cannot finish destruction meanwhile,
+    // and ~QObject discards what is still queued for it
+    if (!timer.state->posted.exchange(true, std::memory_order_acq_rel)) {
+        std::shared_ptr<State> state = timer.state;
+        QMetaObject::invokeMethod(timer.context, [this, id, state, oneShot]() {
+            deliver(id, *state, oneShot);
+        }, Qt::QueuedConnection);
+        m_stats.fired++;
+    } else {
+        m_stats.coalesced++;
+    }
+
+    if (!oneShot) {
+        // On the original cadence; a service that fell behind skips what it missed
+        timer.dueMs += timer.intervalMs;
+        if (timer.dueMs <= now) {
+            timer.dueMs = now + timer.intervalMs;
+        }
+        timer.wheelId = m_wheel.schedule(timer.dueMs, id);
+    }
+}
+
+void TimerService::deliver(TimerId id, State& state, bool oneShot) {
+    state.posted.store(false, std::memory_order_release);
+    if (!state.live.load(std::memory_order_acquire)) return;
+    if (oneShot) {
+        cancel(id);     // Done before the callback, which may start it again
+    }
+    state.callback();
+}
+
+// ServiceTimer
+
+ServiceTimer::ServiceTimer(QObject* context, std::function<void()> callback, TimerService* service)
+    : m_service(service ? service : &TimerService::instance())
+    , m_context(context)
+    , m_callback(std::move(callback))
+{
+}
+
+void ServiceTimer::setInterval(int ms) {
+    m_intervalMs = qMax(0, ms);
+    if (isActive()) {
+        start();
+    }
+}
+
+void ServiceTimer::start() {
+    stop();
+    // A zero interval repeats every millisecond, the nearest the service
+    // comes to QTimer's every event loop pass
+    const int interval = m_singleShot ? 0 : qMax(1, m_intervalMs);
+    m_id = m_service->schedule(m_context, m_intervalMs, m_callback, interval);
+}
+
+void ServiceTimer::start(int ms) {
+    m_intervalMs = qMax(0, ms);
+    start();
+}
+
+void ServiceTimer::stop() {
+    if (m_id != 0) {
+        m_service->cancel(m_id);
+        m_id = 0;
+    }
+}
+
+bool ServiceTimer::isActive() const {
+    return m_id != 0 && m_service->isPending(m_id);
+}
+
+} // namespace CounterUAS
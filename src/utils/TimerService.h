@@ -0,0 +1,131 @@
+#ifndef TIMERSERVICE_H
+#define TIMERSERVICE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "utils/TimerWheel.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief Process-wide timers on one TimerWheel and one sleeping thread
+ *
+ * Subsystems schedule callbacks here instead of each owning QTimers. The
+ * service thread sleeps until the earliest deadline, then posts each due
+ * callback to its context object's thread, so the callback runs where a
+ * QTimer of that object would have fired. A periodic timer whose last
+ * callback is still waiting in a busy event loop is not posted again; it
+ * fires once when the loop gets to it, as a QTimer would. Destroying the
+ * context cancels its timers.
+ *
+ * schedule() and cancel() are O(1) and may be called from any thread
+ * while the context is alive; cancel() from the context's thread also
+ * drops a callback already posted.
+ */
+class TimerService {
+public:
+    using TimerId = quint64;    // 0 is never a valid id
+
+    static TimerService& instance();
+
+    explicit TimerService(int tickMs = 10, int buckets = 512);
+    ~TimerService();
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    // callback runs on context's thread once delayMs has passed, then every
+    // intervalMs if that is positive
+    TimerId schedule(QObject* context, int delayMs, std::function<void()> callback, int intervalMs = 0);
+    bool cancel(TimerId id);
+    bool isPending(TimerId id) const;   // Scheduled, or fired and not yet delivered
+    int pendingCount() const;
+
+    struct Stats {
+        quint64 scheduled = 0;
+        quint64 fired = 0;
+        quint64 coalesced = 0;          // Periodic firings folded into one still queued
+        quint64 wakeups = 0;
+    };
+    Stats stats() const;
+
+private:
+    struct State {
+        std::function<void()> callback;
+        std::atomic<bool> live{true};
+        std::atomic<bool> posted{false};
+    };
+
+    struct Timer {
+        QObject* context = nullptr;
+        std::shared_ptr<State> state;
+        int intervalMs = 0;
+        qint64 dueMs = 0;
+        TimerWheel::TimerId wheelId = 0;
+        QMetaObject::Connection guard;  // Cancels on the context's destruction
+    };
+
+    static qint64 nowMs();
+    void run();
+    void fireLocked(TimerId id, qint64 nowMs);
+    void deliver(TimerId id, State& state, bool oneShot);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    TimerWheel m_wheel;                 // Keys are TimerIds
+    QHash<TimerId, Timer> m_timers;
+    TimerId m_nextId = 1;
+    qint64 m_sleepUntilMs = -1;         // -1: asleep until something is scheduled
+    bool m_stopping = false;
+    QThread* m_thread = nullptr;
+    Stats m_stats;
+};
+
+/**
+ * @brief QTimer-shaped handle on a TimerService timer
+ *
+ * A drop-in for a QTimer member that calls one function: start(), stop(),
+ * setInterval() and setSingleShot() behave as QTimer's do, but the wakeup
+ * comes from the shared service. Stops when destroyed.
+ */
+class ServiceTimer {
+public:
+    ServiceTimer(QObject* context, std::function<void()> callback,
+                 TimerService* service = nullptr);
+    ~ServiceTimer() { stop(); }
+    ServiceTimer(const ServiceTimer&) = delete;
+    ServiceTimer& operator=(const ServiceTimer&) = delete;
+
+    // Takes effect from the next start(); without one, start() schedules nothing
+    void setCallback(std::function<void()> callback) { m_callback = std::move(callback); }
+
+    // Restarts a running timer, as QTimer does
+    void setInterval(int ms);
+    int interval() const { return m_intervalMs; }
+    void setSingleShot(bool singleShot) { m_singleShot = singleShot; }
+    bool isSingleShot() const { return m_singleShot; }
+
+    void start();
+    void start(int ms);
+    void stop();
+    bool isActive() const;
+
+private:
+    TimerService* m_service;
+    QObject* m_context;
+    std::function<void()> m_callback;
+    int m_intervalMs = 0;
+    bool m_singleShot = false;
+    TimerService::TimerId m_id = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // TIMERSERVICE_H
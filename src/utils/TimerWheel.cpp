@@ -0,0 +1,124 @@
+#include "utils/TimerWheel.h"
+#include <algorithm>
+
+namespace CounterUAS {
+
+TimerWheel::TimerWheel(int tickMs, int buckets)
+    : m_tickMs(qMax(1, tickMs))
+    , m_buckets(qMax(1, buckets))
+{
+}
+
+qint64 TimerWheel::tickOf(qint64 ms) const {
+    // Floor, for times before the epoch too
+    return ms >= 0 ? ms / m_tickMs : -1 - (-ms - 1) / m_tickMs;
+}
+
+int TimerWheel::bucketOf(qint64 tick) const {
+    const qint64 count = m_buckets.size();
+    return static_cast<int>(((tick % count) + count) % count);
+}
+
+TimerWheel::TimerId TimerWheel::schedule(qint64 dueMs, quint64 key) {
+    Entry entry;
+    entry.id = m_nextId++;
+    entry.dueMs = dueMs;
+    entry.key = key;
+
+    // Ticks already walked are not walked again; those go in the next one
+    qint64 tick = tickOf(dueMs);
+    if (m_started && tick <= m_doneTick) {
+        tick = m_doneTick + 1;
+    }
+
+    m_buckets[bucketOf(tick)].append(entry);
+    m_pending.insert(entry.id);
+    return entry.id;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    return m_pending.remove(id);
+}
+
+void TimerWheel::clear() {
+    for (QVector<Entry>& bucket : m_buckets) {
+        bucket.clear();
+    }
+    m_pending.clear();
+}
+
+int TimerWheel::advance(qint64 nowMs, QVector<quint64>& expired) {
+    const qint64 bucketCount = m_buckets.size();
+    const qint64 nowTick = tickOf(nowMs);
+
+    // The first call, or a jump past one revolution, visits every bucket once
+    qint64 first = nowTick - bucketCount + 1;
+    if (m_started) {
+        if (nowTick <= m_doneTick) return 0;
+        first = std::max(first, m_doneTick + 1);
+    }
+    m_started = true;
+
+    QVector<Entry> due;
+    for (qint64 tick = first; tick <= nowTick; ++tick) {
+        QVector<Entry>& bucket = m_buckets[bucketOf(tick)];
+        for (int i = 0; i < bucket.size();) {
+            const Entry& entry = bucket[i];
+            const bool live = m_pending.contains(entry.id);
+            if (live && entry.dueMs > nowMs) {
+                ++i;    // Later in this tick, or a later revolution
+                continue;
+            }
+            if (live) {
+                due.append(entry);
+                m_pending.remove(entry.id);
+            }
+            bucket[i] = bucket.last();
+            bucket.removeLast();
+        }
+    }
+
+    // The tick now falls in may still hold later entries; walk it again next time
+    m_doneTick = nowTick - 1;
+
+    std::sort(due.begin(), due.end(), [](const Entry& a, const Entry& b) {
+        return a.dueMs != b.dueMs ? a.dueMs < b.dueMs : a.id < b.id;
+    });
+    for (const Entry& entry : qAsConst(due)) {
+        expired.append(entry.key);
+    }
+    return due.size();
+}
+
+qint64 TimerWheel::nextDueMs() const {
+    if (m_pending.isEmpty()) return -1;
+
+    if (!m_started) {
+        qint64 earliest = -1;
+        for (const QVector<Entry>& bucket : m_buckets) {
+            for (const Entry& entry : bucket) {
+                if (m_pending.contains(entry.id) && (earliest < 0 || entry.dueMs < earliest)) {
+                    earliest = entry.dueMs;
+                }
+            }
+        }
+        return earliest;
+    }
+
+    // The first tick ahead holding a deadline of its own revolution, or an
+    // overdue one moved into it, has the earliest
+    const qint64 bucketCount = m_buckets.size();
+    for (qint64 tick = m_doneTick + 1; tick <= m_doneTick + bucketCount; ++tick) {
+        qint64 earliest = -1;
+        for (const Entry& entry : m_buckets[bucketOf(tick)]) {
+            if (tickOf(entry.dueMs) <= tick && m_pending.contains(entry.id) &&
+                (earliest < 0 || entry.dueMs < earliest)) {
+                earliest = entry.dueMs;
+            }
+        }
+        if (earliest >= 0) return earliest;
+    }
+    return (m_doneTick + bucketCount + 1) * m_tickMs;
+}
+
+} // namespace CounterUAS
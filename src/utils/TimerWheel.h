@@ -0,0 +1,65 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QSet>
+#include <QVector>
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Hashed timing wheel: many deadlines, one clock tick
+ *
+ * Deadlines are hashed into a ring of buckets by tick number; advance()
+ * walks the buckets from the last tick it saw to now and fires what is
+ * due, so scheduling and cancelling are O(1) and a tick costs only the
+ * entries in the buckets it passes. Deadlines more than one revolution out
+ * simply stay in their bucket until they are due. Cancelled entries are
+ * dropped lazily when their bucket comes round.
+ *
+ * Time is whatever the caller passes in, in ms; not thread-safe.
+ */
+class TimerWheel {
+public:
+    using TimerId = quint64;    // 0 is never a valid id
+
+    explicit TimerWheel(int tickMs = 100, int buckets = 256);
+
+    int tickMs() const { return m_tickMs; }
+
+    // Fires on the first advance() at or after dueMs; key is the caller's
+    TimerId schedule(qint64 dueMs, quint64 key);
+    bool cancel(TimerId id);
+    bool isPending(TimerId id) const { return m_pending.contains(id); }
+    int pendingCount() const { return m_pending.size(); }
+    void clear();
+
+    // Appends the keys of every timer due at or before nowMs, in due order
+    int advance(qint64 nowMs, QVector<quint64>& expired);
+
+    // No later than the earliest pending deadline, -1 with none pending: for
+    // sleeping until the next advance() has work. Looks one revolution ahead,
+    // so a wheel holding only farther deadlines answers a revolution out.
+    qint64 nextDueMs() const;
+
+private:
+    struct Entry {
+        TimerId id = 0;
+        qint64 dueMs = 0;
+        quint64 key = 0;
+    };
+
+    qint64 tickOf(qint64 ms) const;
+    int bucketOf(qint64 tick) const;
+
+    int m_tickMs;
+    QVector<QVector<Entry>> m_buckets;
+    QSet<TimerId> m_pending;
+    bool m_started = false;
+    qint64 m_doneTick = 0;              // Every tick up to here has been walked
+    TimerId m_nextId = 1;
+};
+
+} // namespace CounterUAS
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,247 @@
+#include "utils/Trace.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace CounterUAS {
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+constexpr quint64 RING_MASK = Trace::RING_EVENTS - 1;
+static_assert((Trace::RING_EVENTS & RING_MASK) == 0, "RING_EVENTS must be a power of two");
+
+// Rings of exited threads kept for the export; beyond this the oldest is reused
+constexpr int MAX_RETIRED_RINGS = 16;
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    qint64 beginNs;
+    qint64 endNs;
+};
+
+// Relaxed atomics: a reader may copy a slot its owner is overwriting, and
+// then discards it, so neither side needs anything stronger than a plain move
+struct TraceSlot {
+    std::atomic<const char*> category;
+    std::atomic<const char*> name;
+    std::atomic<qint64> beginNs;
+    std::atomic<qint64> endNs;
+};
+
+struct ThreadRing {
+    TraceSlot events[Trace::RING_EVENTS];
+    std::atomic<quint64> head{0};       // Events ever written; only the owner stores
+    quint64 floor = 0;                  // Dropped by clear(); under the registry lock
+    int tid = 0;
+    QString threadName;                 // Under the registry lock
+};
+
+struct Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    std::vector<ThreadRing*> retired;   // Oldest first
+    int nextTid = 1;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadRing* acquireRing() {
+    QString name = QThread::currentThread()->objectName();
+    if (name.isEmpty() && QCoreApplication::instance() &&
+        QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        name = "main";
+    }
+
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    ThreadRing* ring;
+    if (static_cast<int>(r.retired.size()) >= MAX_RETIRED_RINGS) {
+        ring = r.retired.front();
+        r.retired.erase(r.retired.begin());
+        ring->floor = ring->head.load(std::memory_order_relaxed);
+    } else {
+        r.rings.emplace_back(new ThreadRing);
+        ring = r.rings.back().get();
+    }
+    ring->tid = r.nextTid++;
+    ring->threadName = name.isEmpty() ? QString("thread %1").arg(ring->tid) : name;
+    return ring;
+}
+
+// Hands the ring back when its thread exits; its events stay exportable
+struct ThreadSlot {
+    ThreadRing* ring = nullptr;
+
+    ~ThreadSlot() {
+        if (!ring) return;
+        Registry& r = registry();
+        QMutexLocker locker(&r.mutex);
+        r.retired.push_back(ring);
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+ThreadRing* currentRing() {
+    if (!t_slot.ring) {
+        t_slot.ring = acquireRing();
+    }
+    return t_slot.ring;
+}
+
+// Events of one ring still intact after copying them out
+template<typename F>
+void forEachEvent(const ThreadRing& ring, F&& f) {
+    const quint64 head = ring.head.load(std::memory_order_acquire);
+    quint64 first = head > Trace::RING_EVENTS ? head - Trace::RING_EVENTS : 0;
+    first = qMax(first, ring.floor);
+
+    std::vector<TraceEvent> copy;
+    copy.reserve(head - first);
+    for (quint64 i = first; i < head; ++i) {
+        const TraceSlot& slot = ring.events[i & RING_MASK];
+        copy.push_back(TraceEvent{slot.category.load(std::memory_order_relaxed),
+                                  slot.name.load(std::memory_order_relaxed),
+                                  slot.beginNs.load(std::memory_order_relaxed),
+                                  slot.endNs.load(std::memory_order_relaxed)});
+    }
+
+    // The owner may have lapped the oldest slots while they were copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 now = ring.head.load(std::memory_order_relaxed);
+    const quint64 intact = now >= Trace::RING_EVENTS ? now - Trace::RING_EVENTS + 1 : 0;
+    for (quint64 i = qMax(first, intact); i < head; ++i) {
+        f(copy[i - first]);
+    }
+}
+
+void appendJsonString(QByteArray& out, const QByteArray& utf8) {
+    out.append('"');
+    for (char c : utf8) {
+        if (c == '"' || c == '\\') {
+            out.append('\\').append(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out.append("\\u00");
+            out.append("0123456789abcdef"[(c >> 4) & 0xF]);
+            out.append("0123456789abcdef"[c & 0xF]);
+        } else {
+            out.append(c);
+        }
+    }
+    out.append('"');
+}
+
+} // namespace
+
+void Trace::setEnabled(bool enable) {
+    s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+qint64 Trace::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char* category, const char* name, qint64 beginNs, qint64 endNs) {
+    ThreadRing* ring = currentRing();
+    const quint64 n = ring->head.load(std::memory_order_relaxed);
+    TraceSlot& slot = ring->events[n & RING_MASK];
+    slot.category.store(category, std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.beginNs.store(beginNs, std::memory_order_relaxed);
+    slot.endNs.store(endNs, std::memory_order_relaxed);
+    ring->head.store(n + 1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const QString& name) {
+    ThreadRing* ring = currentRing();
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    ring->threadName = name;
+}
+
+int Trace::eventCount() {
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    quint64 count = 0;
+    for (const auto& ring : r.rings) {
+        const quint64 head = ring->head.load(std::memory_order_acquire);
+        count += qMin<quint64>(head - qMin(head, ring->floor), RING_EVENTS);
+    }
+    return static_cast<int>(count);
+}
+
+void Trace::clear() {
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    for (const auto& ring : r.rings) {
+        ring->floor = ring->head.load(std::memory_order_acquire);
+    }
+}
+
+QByteArray Trace::toChromeJson() {
+    return toChromeJson(0, {});
+}
+
+QByteArray Trace::toChromeJson(qint64 sinceNs, const QList<QByteArray>& extraEvents) {
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+
+    QByteArray out;
+    out.reserve(4096 + static_cast<int>(r.rings.size()) * 1024);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) out.append(",\n");
+        first = false;
+    };
+
+    for (const auto& ring : r.rings) {
+        const QByteArray tid = QByteArray::number(ring->tid);
+        separator();
+        out.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":").append(pid);
+        out.append(",\"tid\":").append(tid).append(",\"args\":{\"name\":");
+        appendJsonString(out, ring->threadName.toUtf8());
+        out.append("}}");
+
+        forEachEvent(*ring, [&](const TraceEvent& e) {
+            if (e.endNs < sinceNs) return;
+            separator();
+            out.append("{\"name\":");
+            appendJsonString(out, QByteArray(e.name));
+            out.append(",\"cat\":");
+            appendJsonString(out, QByteArray(e.category));
+            out.append(",\"ph\":\"X\",\"ts\":").append(QByteArray::number(e.beginNs / 1000.0, 'f', 3));
+            out.append(",\"dur\":").append(QByteArray::number((e.endNs - e.beginNs) / 1000.0, 'f', 3));
+            out.append(",\"pid\":").append(pid).append(",\"tid\":").append(tid).append('}');
+        });
+    }
+    for (const QByteArray& event : extraEvents) {
+        separator();
+        out.append(event);
+    }
+    out.append("]}\n");
+    return out;
+}
+
+bool Trace::writeChromeTrace(const QString& path) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(toChromeJson());
+    return file.commit();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,98 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+
+namespace CounterUAS {
+
+/**
+ * @brief Low-overhead scoped tracing of the hot paths
+ *
+ * CUAS_TRACE_SCOPE("category", "name") records the enclosing scope as one
+ * complete event, steady-clock nanoseconds at entry and exit, into a ring
+ * owned by the calling thread: recording takes no lock and touches no
+ * memory another thread writes. Each ring keeps the last RING_EVENTS
+ * events. Names and categories are stored by pointer, so they must be
+ * string literals.
+ *
+ * Recording is off until setEnabled(true); while off a scope costs one
+ * relaxed load. Built without COUNTERUAS_TRACING the macro expands to
+ * nothing. toChromeJson() exports every ring in the Chrome trace event
+ * format, which chrome://tracing and ui.perfetto.dev both open.
+ */
+class Trace {
+public:
+    static constexpr int RING_EVENTS = 8192;        // Per thread; a power of two
+#ifdef COUNTERUAS_TRACING
+    static constexpr bool COMPILED_IN = true;
+#else
+    static constexpr bool COMPILED_IN = false;      // CUAS_TRACE_SCOPE records nothing
+#endif
+
+    static void setEnabled(bool enable);
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    static qint64 nowNs();
+    static void record(const char* category, const char* name, qint64 beginNs, qint64 endNs);
+    // Label for the calling thread in the export; defaults to its objectName()
+    static void setThreadName(const QString& name);
+
+    // Events held across all threads; clear() drops them
+    static int eventCount();
+    static void clear();
+
+    // Safe while other threads record; events older than a ring are lost
+    static QByteArray toChromeJson();
+    // Only events ending at or after sinceNs, followed by extraEvents, each
+    // one complete JSON event object
+    static QByteArray toChromeJson(qint64 sinceNs, const QList<QByteArray>& extraEvents);
+    static bool writeChromeTrace(const QString& path);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief RAII recorder behind CUAS_TRACE_SCOPE
+ */
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : m_category(category)
+        , m_name(name)
+        , m_beginNs(Trace::isEnabled() ? Trace::nowNs() : -1)
+    {
+    }
+
+    ~TraceScope() {
+        if (m_beginNs >= 0) {
+            Trace::record(m_category, m_name, m_beginNs, Trace::nowNs());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    qint64 m_beginNs;
+};
+
+} // namespace CounterUAS
+
+#define CUAS_TRACE_CONCAT_(a, b) a##b
+#define CUAS_TRACE_CONCAT(a, b) CUAS_TRACE_CONCAT_(a, b)
+
+#ifdef COUNTERUAS_TRACING
+#define CUAS_TRACE_SCOPE(category, name) \
+    ::CounterUAS::TraceScope CUAS_TRACE_CONCAT(cuasTraceScope, __LINE__)(category, name)
+#else
+#define CUAS_TRACE_SCOPE(category, name) static_cast<void>(0)
+#endif
+
+#endif // TRACE_H
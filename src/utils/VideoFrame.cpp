@@ -0,0 +1,171 @@
+#include "utils/VideoFrame.h"
+#include "utils/FramePool.h"
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+inline uchar clampByte(int v) {
+    return static_cast<uchar>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+inline QRgb yuvToRgb(int y, int u, int v) {
+    const int c = 298 * (y - 16);
+    const int d = u - 128;
+    const int e = v - 128;
+    return qRgb(clampByte((c + 409 * e + 128) >> 8),
+                clampByte((c - 100 * d - 208 * e + 128) >> 8),
+                clampByte((c + 516 * d + 128) >> 8));
+}
+
+} // namespace
+
+VideoFrame::VideoFrame(const QImage& image) {
+    if (image.isNull()) return;
+
+    m_format = fromImageFormat(image.format());
+    if (m_format == VideoPixelFormat::Invalid) {
+        m_format = VideoPixelFormat::RGB32;
+        m_storage = image.convertToFormat(QImage::Format_RGB32);
+    } else {
+        m_storage = image;
+    }
+    m_size = image.size();
+}
+
+VideoFrame VideoFrame::allocate(VideoPixelFormat format, const QSize& size, FramePool* pool) {
+    VideoFrame frame;
+    if (format == VideoPixelFormat::Invalid || size.isEmpty()) return frame;
+
+    QSize storageSize = size;
+    QImage::Format storageFormat = toImageFormat(format);
+    if (isYuv(format)) {
+        // Luma rows, then the chroma planes; the row stride covers both layouts
+        storageSize.setHeight(size.height() + (size.height() + 1) / 2);
+        storageFormat = QImage::Format_Grayscale8;
+    }
+
+    frame.m_storage = pool ? pool->acquire(storageSize, storageFormat)
+                           : QImage(storageSize, storageFormat);
+    if (frame.m_storage.isNull()) return VideoFrame();
+    frame.m_format = format;
+    frame.m_size = size;
+    return frame;
+}
+
+VideoFrame VideoFrame::fromPlanes(VideoPixelFormat format, const QSize& size,
+                                  const uchar* const* planes, const int* strides,
+                                  FramePool* pool) {
+    VideoFrame frame = allocate(format, size, pool);
+    if (frame.isNull()) return frame;
+
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        if (!planes[plane]) return VideoFrame();
+        const QSize samples = frame.planeSize(plane);
+        int rowBytes = samples.width();
+        if (format == VideoPixelFormat::NV12 && plane == 1) rowBytes *= 2;
+        else if (!isYuv(format)) rowBytes = samples.width() * frame.m_storage.depth() / 8;
+        rowBytes = qMin(rowBytes, strides[plane]);
+
+        uchar* dst = frame.bits(plane);
+        const int dstStride = frame.bytesPerLine(plane);
+        for (int y = 0; y < samples.height(); ++y) {
+            std::memcpy(dst + y * dstStride, planes[plane] + y * strides[plane], rowBytes);
+        }
+    }
+    return frame;
+}
+
+QSize VideoFrame::planeSize(int plane) const {
+    if (plane < 0 || plane >= planeCount()) return QSize();
+    if (plane == 0) return m_size;
+    return QSize((m_size.width() + 1) / 2, (m_size.height() + 1) / 2);
+}
+
+int VideoFrame::bytesPerLine(int plane) const {
+    if (plane < 0 || plane >= planeCount()) return 0;
+    const int stride = static_cast<int>(m_storage.bytesPerLine());
+    // QImage rows are 32-bit aligned, so halving keeps I420 chroma rows whole
+    return m_format == VideoPixelFormat::YUV420P && plane > 0 ? stride / 2 : stride;
+}
+
+int VideoFrame::planeOffset(int plane) const {
+    const int stride = static_cast<int>(m_storage.bytesPerLine());
+    if (plane == 0) return 0;
+    int offset = m_size.height() * stride;
+    if (plane == 2) offset += planeSize(1).height() * bytesPerLine(1);
+    return offset;
+}
+
+const uchar* VideoFrame::constBits(int plane) const {
+    if (plane < 0 || plane >= planeCount()) return nullptr;
+    return m_storage.constBits() + planeOffset(plane);
+}
+
+uchar* VideoFrame::bits(int plane) {
+    if (plane < 0 || plane >= planeCount()) return nullptr;
+    return m_storage.bits() + planeOffset(plane);
+}
+
+QImage VideoFrame::toImage() const {
+    if (!isYuv()) return m_storage;
+
+    const int w = width();
+    const int h = height();
+    QImage image(w, h, QImage::Format_RGB32);
+    const uchar* yPlane = constBits(0);
+    const int yStride = bytesPerLine(0);
+    const int cStride = bytesPerLine(1);
+
+    for (int y = 0; y < h; ++y) {
+        const uchar* yRow = yPlane + y * yStride;
+        QRgb* out = reinterpret_cast<QRgb*>(image.scanLine(y));
+        if (m_format == VideoPixelFormat::NV12) {
+            const uchar* uvRow = constBits(1) + (y / 2) * cStride;
+            for (int x = 0; x < w; ++x) {
+                out[x] = yuvToRgb(yRow[x], uvRow[(x / 2) * 2], uvRow[(x / 2) * 2 + 1]);
+            }
+        } else {
+            const uchar* uRow = constBits(1) + (y / 2) * cStride;
+            const uchar* vRow = constBits(2) + (y / 2) * cStride;
+            for (int x = 0; x < w; ++x) {
+                out[x] = yuvToRgb(yRow[x], uRow[x / 2], vRow[x / 2]);
+            }
+        }
+    }
+    return image;
+}
+
+bool VideoFrame::isYuv(VideoPixelFormat format) {
+    return format == VideoPixelFormat::YUV420P || format == VideoPixelFormat::NV12;
+}
+
+int VideoFrame::planeCount(VideoPixelFormat format) {
+    switch (format) {
+        case VideoPixelFormat::Invalid: return 0;
+        case VideoPixelFormat::YUV420P: return 3;
+        case VideoPixelFormat::NV12:    return 2;
+        default:                        return 1;
+    }
+}
+
+VideoPixelFormat VideoFrame::fromImageFormat(QImage::Format format) {
+    switch (format) {
+        case QImage::Format_RGB888: return VideoPixelFormat::RGB24;
+        case QImage::Format_RGB32:  return VideoPixelFormat::RGB32;
+        case QImage::Format_ARGB32: return VideoPixelFormat::ARGB32;
+        default:                    return VideoPixelFormat::Invalid;
+    }
+}
+
+QImage::Format VideoFrame::toImageFormat(VideoPixelFormat format) {
+    switch (format) {
+        case VideoPixelFormat::RGB24:  return QImage::Format_RGB888;
+        case VideoPixelFormat::RGB32:  return QImage::Format_RGB32;
+        case VideoPixelFormat::ARGB32: return QImage::Format_ARGB32;
+        default:                       return QImage::Format_Invalid;
+    }
+}
+
+} // namespace CounterUAS
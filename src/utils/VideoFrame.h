@@ -0,0 +1,85 @@
+#ifndef VIDEOFRAME_H
+#define VIDEOFRAME_H
+
+#include <QImage>
+#include <QMetaType>
+#include <QSize>
+
+namespace CounterUAS {
+
+class FramePool;
+
+/**
+ * @brief Pixel layouts a VideoFrame can carry
+ */
+enum class VideoPixelFormat {
+    Invalid = 0,
+    RGB24,      // QImage::Format_RGB888
+    RGB32,      // QImage::Format_RGB32, 0xffRRGGBB words
+    ARGB32,     // QImage::Format_ARGB32, not premultiplied
+    YUV420P,    // I420: Y, then quarter-size U and V planes
+    NV12        // Y, then one quarter-size plane of interleaved U/V
+};
+
+/**
+ * @brief Decoded video frame in its native pixel format
+ *
+ * Sources hand planar YUV from the decoder straight through; a consumer
+ * that needs RGB calls toImage() at its own edge, and RGB frames come back
+ * shared rather than converted. Copies are cheap: the planes live in one
+ * implicitly shared buffer (a pooled one when a FramePool is given), laid
+ * out as 8-bit rows of width() bytes, height() rows of luma followed by
+ * the chroma planes.
+ *
+ * Chroma planes are (width + 1) / 2 by (height + 1) / 2 samples; NV12's
+ * second plane stores each sample as a U, V byte pair.
+ */
+class VideoFrame {
+public:
+    VideoFrame() = default;
+
+    // Shares the image; formats other than the RGB ones above are converted
+    explicit VideoFrame(const QImage& image);
+
+    // Uninitialised planes
+    static VideoFrame allocate(VideoPixelFormat format, const QSize& size,
+                               FramePool* pool = nullptr);
+    // Copies planeCount(format) planes, each with its own stride
+    static VideoFrame fromPlanes(VideoPixelFormat format, const QSize& size,
+                                 const uchar* const* planes, const int* strides,
+                                 FramePool* pool = nullptr);
+
+    bool isNull() const { return m_format == VideoPixelFormat::Invalid; }
+    VideoPixelFormat pixelFormat() const { return m_format; }
+    QSize size() const { return m_size; }
+    int width() const { return m_size.width(); }
+    int height() const { return m_size.height(); }
+    bool isYuv() const { return isYuv(m_format); }
+
+    int planeCount() const { return planeCount(m_format); }
+    QSize planeSize(int plane) const;      // Samples, not bytes
+    int bytesPerLine(int plane) const;
+    const uchar* constBits(int plane = 0) const;
+    uchar* bits(int plane = 0);            // Detaches a shared frame
+
+    // RGB frames share their pixels; YUV ones convert (BT.601, video range)
+    QImage toImage() const;
+
+    static bool isYuv(VideoPixelFormat format);
+    static int planeCount(VideoPixelFormat format);
+    static VideoPixelFormat fromImageFormat(QImage::Format format);
+    static QImage::Format toImageFormat(VideoPixelFormat format);
+
+private:
+    int planeOffset(int plane) const;
+
+    QImage m_storage;     // The RGB image itself, or Grayscale8 rows carrying the planes
+    VideoPixelFormat m_format = VideoPixelFormat::Invalid;
+    QSize m_size;
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::VideoFrame)
+
+#endif // VIDEOFRAME_H
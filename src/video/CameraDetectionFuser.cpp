@@ -0,0 +1,286 @@
+#include "video/CameraDetectionFuser.h"
+#include "utils/TimeUtils.h"
+#include <QTimer>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+double dot(const EnuVector& a, const EnuVector& b) {
+    return a.east * b.east + a.north * b.north + a.up * b.up;
+}
+
+EnuVector minus(const EnuVector& a, const EnuVector& b) {
+    EnuVector d;
+    d.east = a.east - b.east;
+    d.north = a.north - b.north;
+    d.up = a.up - b.up;
+    return d;
+}
+
+EnuVector along(const EnuVector& origin, const EnuVector& direction, double distance) {
+    EnuVector p;
+    p.east = origin.east + direction.east * distance;
+    p.north = origin.north + direction.north * distance;
+    p.up = origin.up + direction.up * distance;
+    return p;
+}
+
+// Offset of point from the ray, at right angles to it
+EnuVector perpendicular(const EnuVector& point, const EnuVector& origin, const EnuVector& direction) {
+    const EnuVector offset = minus(point, origin);
+    return minus(offset, along(EnuVector(), direction, dot(offset, direction)));
+}
+
+} // namespace
+
+CameraDetectionFuser::CameraDetectionFuser(QObject* parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    connect(m_flushTimer, &QTimer::timeout, this, &CameraDetectionFuser::onFlushTimer);
+    setConfig(CameraDetectionFuserConfig());
+}
+
+CameraDetectionFuser::~CameraDetectionFuser() = default;
+
+void CameraDetectionFuser::setConfig(const CameraDetectionFuserConfig& config) {
+    m_config = config;
+    m_config.windowMs = qMax(1, config.windowMs);
+    m_config.minGateM = qMax(0.0, config.minGateM);
+    m_flushTimer->setInterval(qMax(10, m_config.windowMs / 4));
+}
+
+void CameraDetectionFuser::addSighting(const CameraSighting& sighting, qint64 nowMs) {
+    ++m_stats.sightingsIn;
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+    const EnuVector ray = direction(sighting.azimuthDeg, sighting.elevationDeg);
+
+    // The open group this ray meets most closely, among those without this camera
+    int best = -1;
+    double bestMiss = 0.0;
+    EnuVector bestOrigin;
+    for (int g = 0; g < m_groups.size(); ++g) {
+        const Group& group = m_groups[g];
+        if (nowMs - group.openedMs >= m_config.windowMs) continue;
+        if (qAbs(sighting.timestamp - group.sightings.first().timestamp) > m_config.windowMs) continue;
+        const bool seen = std::any_of(group.sightings.cbegin(), group.sightings.cend(),
+                                      [&sighting](const CameraSighting& s) { return s.cameraId == sighting.cameraId; });
+        if (seen) continue;
+
+        const EnuVector origin = group.frame.toEnu(sighting.mount);
+        const double miss = groupMiss(group, origin, ray);
+        if (miss >= 0.0 && (best < 0 || miss < bestMiss)) {
+            best = g;
+            bestMiss = miss;
+            bestOrigin = origin;
+        }
+    }
+
+    if (best >= 0) {
+        Group& group = m_groups[best];
+        group.sightings.append(sighting);
+        group.origins.append(bestOrigin);
+        group.directions.append(ray);
+        ++m_stats.sightingsMerged;
+        return;
+    }
+
+    Group group;
+    group.openedMs = nowMs;
+    group.frame.setOrigin(sighting.mount);
+    group.sightings.append(sighting);
+    group.origins.append(EnuVector());
+    group.directions.append(ray);
+    m_groups.append(group);
+}
+
+QVector<FusedCameraDetection> CameraDetectionFuser::flush(qint64 nowMs, bool force) {
+    QVector<FusedCameraDetection> out;
+    for (int g = 0; g < m_groups.size();) {
+        if (force || nowMs - m_groups[g].openedMs >= m_config.windowMs) {
+            out.append(close(m_groups[g]));
+            m_groups.remove(g);
+        } else {
+            ++g;
+        }
+    }
+    return out;
+}
+
+bool CameraDetectionFuser::triangulate(const QVector<Ray>& rays, GeoPosition& fix, double& residualM) const {
+    const int n = rays.size();
+    if (n < 2) return false;
+
+    const LocalTangentPlane frame(rays[0].origin);
+    QVector<EnuVector> origins(n);
+    QVector<EnuVector> directions(n);
+    for (int i = 0; i < n; ++i) {
+        origins[i] = frame.toEnu(rays[i].origin);
+        directions[i] = direction(rays[i].azimuthDeg, rays[i].elevationDeg);
+    }
+
+    // Side by side cameras see along one line and cannot range it
+    double widest = 0.0;
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            const double cosine = qBound(-1.0, dot(directions[i], directions[j]), 1.0);
+            widest = qMax(widest, std::sqrt(1.0 - cosine * cosine));
+        }
+    }
+    if (widest < std::sin(qDegreesToRadians(m_config.minCrossingAngleDeg))) return false;
+
+    // Minimise the weighted squared miss of every ray. The first pass weights
+    // them alike; the second by the inverse square of the range it found,
+    // as each camera's error is an angle.
+    EnuVector point;
+    QVector<double> ranges(n, 0.0);
+    for (int pass = 0; pass < 2; ++pass) {
+        double a[3][3] = {};
+        double b[3] = {};
+        for (int i = 0; i < n; ++i) {
+            const double range = qMax(50.0, ranges[i]);
+            const double w = pass == 0 ? 1.0 : 1.0 / (range * range);
+            const double d[3] = {directions[i].east, directions[i].north, directions[i].up};
+            const double o[3] = {origins[i].east, origins[i].north, origins[i].up};
+            // w * (I - d d^T), applied to the origin for b
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) {
+                    const double m = w * ((r == c ? 1.0 : 0.0) - d[r] * d[c]);
+                    a[r][c] += m;
+                    b[r] += m * o[c];
+                }
+            }
+        }
+
+        const double det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+                         - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+                         + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+        const double trace = a[0][0] + a[1][1] + a[2][2];
+        if (!(std::fabs(det) > 1e-12 * trace * trace * trace)) return false;
+        // Cramer's rule, a column at a time replaced by b
+        double solved[3];
+        for (int k = 0; k < 3; ++k) {
+            double m[3][3];
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 3; ++c) m[r][c] = c == k ? b[r] : a[r][c];
+            }
+            solved[k] = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                       - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                       + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) / det;
+        }
+        point.east = solved[0];
+        point.north = solved[1];
+        point.up = solved[2];
+
+        for (int i = 0; i < n; ++i) {
+            ranges[i] = dot(minus(point, origins[i]), directions[i]);
+        }
+    }
+
+    // In front of every camera, and within range of one
+    double nearest = HUGE_VAL;
+    for (int i = 0; i < n; ++i) {
+        if (ranges[i] <= 0.0) return false;
+        nearest = qMin(nearest, ranges[i]);
+    }
+    if (nearest > m_config.maxRangeM) return false;
+
+    double squaredMiss = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const EnuVector miss = perpendicular(point, origins[i], directions[i]);
+        squaredMiss += dot(miss, miss);
+    }
+    residualM = std::sqrt(squaredMiss / n);
+    fix = frame.toGeo(point);
+    return true;
+}
+
+void CameraDetectionFuser::onFlushTimer() {
+    const QVector<FusedCameraDetection> out = flush(TimeUtils::monotonicNs() / 1000000);
+    if (!out.isEmpty()) {
+        emit detectionsFused(out);
+    }
+    if (m_groups.isEmpty()) {
+        m_flushTimer->stop();
+    }
+}
+
+EnuVector CameraDetectionFuser::direction(double azimuthDeg, double elevationDeg) {
+    const double az = qDegreesToRadians(azimuthDeg);
+    const double el = qDegreesToRadians(elevationDeg);
+    EnuVector d;
+    d.east = std::cos(el) * std::sin(az);
+    d.north = std::cos(el) * std::cos(az);
+    d.up = std::sin(el);
+    return d;
+}
+
+double CameraDetectionFuser::groupMiss(const Group& group, const EnuVector& origin,
+                                       const EnuVector& direction) const {
+    const double gateTan = std::tan(qDegreesToRadians(m_config.bearingGateDeg));
+    double worst = 0.0;
+    for (int i = 0; i < group.origins.size(); ++i) {
+        // Closest approach of origin + t * direction and member + s * theirs
+        const EnuVector& theirs = group.directions[i];
+        const EnuVector w0 = minus(origin, group.origins[i]);
+        const double b = dot(direction, theirs);
+        const double d = dot(direction, w0);
+        const double e = dot(theirs, w0);
+        const double denom = 1.0 - b * b;
+        // Parallel rays meet only when they are one line, as from one mast
+        double t = 0.0;
+        double s = e;
+        if (denom > 1e-9) {
+            t = (b * e - d) / denom;
+            s = (e - b * d) / denom;
+            if (t <= 0.0 || s <= 0.0 || qMin(t, s) > m_config.maxRangeM) return -1.0;
+        }
+        const double miss = EnuVector::distance(along(origin, direction, t),
+                                                along(group.origins[i], theirs, s));
+        const double gate = qMax(m_config.minGateM, qMax(t, std::fabs(s)) * gateTan);
+        if (miss > gate) return -1.0;
+        worst = qMax(worst, miss);
+    }
+    return worst;
+}
+
+FusedCameraDetection CameraDetectionFuser::close(const Group& group) {
+    QVector<int> order(group.sightings.size());
+    for (int i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&group](int a, int b) {
+        return group.sightings[a].confidence > group.sightings[b].confidence;
+    });
+
+    FusedCameraDetection fused;
+    double missedBy = 1.0;      // Chance that every camera is wrong
+    QVector<Ray> rays;
+    for (int i : order) {
+        const CameraSighting& sighting = group.sightings[i];
+        fused.boxes.append(sighting.box);
+        fused.timestamp = qMax(fused.timestamp, sighting.timestamp);
+        missedBy *= 1.0 - qBound(0.0, sighting.confidence, 1.0);
+        Ray ray;
+        ray.origin = sighting.mount;
+        ray.azimuthDeg = sighting.azimuthDeg;
+        ray.elevationDeg = sighting.elevationDeg;
+        rays.append(ray);
+    }
+    fused.confidence = 1.0 - missedBy;
+
+    fused.triangulated = triangulate(rays, fused.position, fused.residualM);
+    if (fused.triangulated) {
+        ++m_stats.triangulated;
+    } else {
+        fused.position = group.sightings[order.first()].estimate;
+    }
+    ++m_stats.detectionsOut;
+    return fused;
+}
+
+} // namespace CounterUAS
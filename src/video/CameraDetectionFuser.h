@@ -0,0 +1,130 @@
+#ifndef CAMERADETECTIONFUSER_H
+#define CAMERADETECTIONFUSER_H
+
+#include <QObject>
+#include <QVector>
+#include "core/Track.h"
+#include "utils/LocalTangentPlane.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+/**
+ * @brief Cross-camera grouping and triangulation thresholds
+ */
+struct CameraDetectionFuserConfig {
+    int windowMs = 100;                 // Captures this close together are one moment
+    double bearingGateDeg = 1.0;        // Rays passing closer than this, seen from the camera, meet
+    double minGateM = 10.0;             // Floor under that gate close to the cameras
+    double minCrossingAngleDeg = 5.0;   // Widest pair of rays must cross this sharply for a fix
+    double maxRangeM = 3000.0;          // Rays meeting farther than this from every camera do not
+};
+
+/**
+ * @brief One camera's detection as a ray from its mount
+ */
+struct CameraSighting {
+    QString cameraId;
+    BoundingBox box;                // In the camera's frame, cameraId filled in
+    GeoPosition mount;
+    double azimuthDeg = 0.0;        // Ray through the box centre
+    double elevationDeg = 0.0;
+    GeoPosition estimate;           // Single-camera position, when no fix can be made
+    double confidence = 0.0;
+    qint64 timestamp = 0;           // Capture, Unix ms
+};
+
+/**
+ * @brief One object as seen by every camera that saw it
+ */
+struct FusedCameraDetection {
+    GeoPosition position;
+    bool triangulated = false;      // Else the most confident camera's estimate
+    double residualM = 0.0;         // RMS miss of the rays, when triangulated
+    double confidence = 0.0;
+    qint64 timestamp = 0;           // Latest capture
+    QVector<BoundingBox> boxes;     // One per camera, most confident first
+};
+
+/**
+ * @brief Merges detections of one object by several cameras
+ *
+ * Cameras covering the same airspace each report the object, each at a
+ * position guessed along its own ray, so the track manager would start
+ * a track per camera or hand one track back and forth between them. The
+ * fuser groups sightings from different cameras whose captures fall in
+ * one window and whose rays pass within the gate of each other, in front
+ * of both cameras. A closed group is one detection: positioned by the
+ * weighted least-squares crossing of its rays when they cross sharply
+ * enough (co-located cameras do not), and carrying every camera's box.
+ * A sighting no other camera shares passes through as a group of one.
+ *
+ * Groups close windowMs after they open, on a timer, or on flush().
+ */
+class CameraDetectionFuser : public QObject {
+    Q_OBJECT
+
+public:
+    struct Ray {
+        GeoPosition origin;
+        double azimuthDeg = 0.0;
+        double elevationDeg = 0.0;
+    };
+
+    explicit CameraDetectionFuser(QObject* parent = nullptr);
+    ~CameraDetectionFuser() override;
+
+    void setConfig(const CameraDetectionFuserConfig& config);
+    CameraDetectionFuserConfig config() const { return m_config; }
+
+    // Joins the open group the ray meets best, else opens one; nowMs on
+    // the clock flush() is given
+    void addSighting(const CameraSighting& sighting, qint64 nowMs);
+
+    // Closes every group whose window has ended (all, with force)
+    QVector<FusedCameraDetection> flush(qint64 nowMs, bool force = false);
+    int pendingGroups() const { return m_groups.size(); }
+
+    // Least-squares crossing of the rays in 3D. False when they are too
+    // near parallel or meet behind a camera; residualM is the RMS miss.
+    bool triangulate(const QVector<Ray>& rays, GeoPosition& fix, double& residualM) const;
+
+    struct Stats {
+        qint64 sightingsIn = 0;
+        qint64 detectionsOut = 0;
+        qint64 triangulated = 0;
+        qint64 sightingsMerged = 0;     // Into a group another camera opened
+    };
+    Stats stats() const { return m_stats; }
+
+signals:
+    void detectionsFused(const QVector<FusedCameraDetection>& detections);
+
+private slots:
+    void onFlushTimer();
+
+private:
+    struct Group {
+        qint64 openedMs = 0;
+        LocalTangentPlane frame;            // At the first sighting's mount
+        QVector<CameraSighting> sightings;  // One per camera
+        QVector<EnuVector> origins;         // Parallel to sightings
+        QVector<EnuVector> directions;
+    };
+
+    static EnuVector direction(double azimuthDeg, double elevationDeg);
+    // Worst miss of the ray against the group's rays, or a negative value
+    // where it misses the gate of any of them
+    double groupMiss(const Group& group, const EnuVector& origin, const EnuVector& direction) const;
+    FusedCameraDetection close(const Group& group);
+
+    CameraDetectionFuserConfig m_config;
+    QVector<Group> m_groups;
+    QTimer* m_flushTimer;
+    Stats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // CAMERADETECTIONFUSER_H
@@ -0,0 +1,166 @@
+#include "video/CameraScheduler.h"
+#include "video/SlewControlLoop.h"
+#include "utils/AssignmentSolver.h"
+#include "utils/CoordinateUtils.h"
+#include <QSet>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr double MAX_THREAT_LEVEL = 5.0;
+// Revisit intervals a confirmed track's score keeps growing over, so one
+// that is awkward to reach still gets its turn
+constexpr double MAX_OVERDUE = 4.0;
+
+} // namespace
+
+double CameraScheduler::slewTimeS(const TaskableCamera& camera, const GeoPosition& target) {
+    double pan = 0.0, tilt = 0.0;
+    SlewControlLoop::aimAngles(camera.mount, camera.headingDeg, target, pan, tilt);
+    const double panTime = std::abs(std::remainder(pan - camera.pan, 360.0)) / qMax(1e-3, camera.panSpeed);
+    const double tiltTime = std::abs(tilt - camera.tilt) / qMax(1e-3, camera.tiltSpeed);
+    return qMax(panTime, tiltTime);
+}
+
+double CameraScheduler::score(const TaskableCamera& camera, const TaskableThreat& threat, int rank,
+                              qint64 nowMs) const {
+    // Visibility: in range, in line of sight and within the tilt limits, better closer in
+    const double range = CoordinateUtils::haversineDistance(camera.mount, threat.position);
+    if (range > camera.maxRangeM) return 0.0;
+    if (camera.coverage && !camera.coverage->canSee(threat.position)) return 0.0;
+    double pan = 0.0, tilt = 0.0;
+    SlewControlLoop::aimAngles(camera.mount, camera.headingDeg, threat.position, pan, tilt);
+    if (tilt < m_config.minTiltDeg || tilt > m_config.maxTiltDeg) return 0.0;
+    const double visibility = 1.0 - 0.5 * range / qMax(1.0, camera.maxRangeM);
+
+    // Threat level first; queue rank breaks ties between equal levels
+    const double priority = qBound(1, threat.threatLevel, 5) / MAX_THREAT_LEVEL / (1.0 + 0.1 * rank);
+
+    // Confirmed tracks recover from being looked at over the revisit
+    // interval, and keep gaining while overdue
+    double revisit = 1.0;
+    if (threat.visuallyTracked && m_config.revisitMs > 0) {
+        auto seen = m_lastLookedAtMs.constFind(threat.trackId);
+        if (seen != m_lastLookedAtMs.constEnd()) {
+            const double overdue = qBound(0.0, double(nowMs - seen.value()) / m_config.revisitMs, MAX_OVERDUE);
+            revisit = m_config.confirmedWeight + (1.0 - m_config.confirmedWeight) * overdue;
+        }
+    }
+
+    // The bonus for staying put does not hold a camera on a lower threat
+    // level than one still waiting for a look
+    const bool current = m_assignments.value(camera.cameraId).trackId == threat.trackId;
+    const bool sticky = current && threat.threatLevel >= m_waitingLevel;
+    const double slew = slewTimeS(camera, threat.position) + (current ? 0.0 : m_config.settleS);
+    const double reach = 1.0 / (1.0 + slew / qMax(1e-3, m_config.slewTimeScaleS));
+
+    return priority * visibility * revisit * reach * (sticky ? m_config.stickiness : 1.0);
+}
+
+QHash<QString, QString> CameraScheduler::schedule(const QVector<TaskableCamera>& cameras,
+                                                  const QVector<TaskableThreat>& threats, qint64 nowMs) {
+    const int candidates = qMin(threats.size(), qMax(1, m_config.candidatesPerCamera) * cameras.size());
+    QSet<QString> assigned;
+    for (const Assignment& assignment : m_assignments) assigned.insert(assignment.trackId);
+
+    // Highest level of an unconfirmed track no camera is on; a confirmed
+    // track not seen before counts as one revisit interval overdue
+    QHash<QString, int> rankOf;
+    m_waitingLevel = 0;
+    for (int i = 0; i < candidates; ++i) {
+        const TaskableThreat& threat = threats[i];
+        rankOf.insert(threat.trackId, i);
+        if (!threat.visuallyTracked && !assigned.contains(threat.trackId)) {
+            m_waitingLevel = qMax(m_waitingLevel, threat.threatLevel);
+        }
+        if (!m_lastLookedAtMs.contains(threat.trackId)) {
+            m_lastLookedAtMs.insert(threat.trackId, nowMs - m_config.revisitMs);
+        }
+    }
+
+    // Cameras inside their dwell keep their track unless it went out of
+    // view or a higher threat level is waiting for a look
+    QHash<QString, QString> result;
+    QSet<QString> taken;
+    QVector<int> freeCameras;
+    for (int c = 0; c < cameras.size(); ++c) {
+        const TaskableCamera& camera = cameras[c];
+        auto current = m_assignments.constFind(camera.cameraId);
+        if (current != m_assignments.constEnd()) {
+            const int rank = rankOf.value(current->trackId, -1);
+            if (rank >= 0 && nowMs - current->sinceMs < m_config.minDwellMs &&
+                threats[rank].threatLevel >= m_waitingLevel &&
+                score(camera, threats[rank], rank, nowMs) > 0.0) {
+                result.insert(camera.cameraId, current->trackId);
+                taken.insert(current->trackId);
+                continue;
+            }
+        }
+        freeCameras.append(c);
+    }
+
+    QVector<int> open;
+    for (int i = 0; i < candidates; ++i) {
+        if (!taken.contains(threats[i].trackId)) open.append(i);
+    }
+
+    if (!freeCameras.isEmpty() && !open.isEmpty()) {
+        // Best total score, as costs below the best single score
+        QVector<double> scores(freeCameras.size() * open.size(), 0.0);
+        double best = 0.0;
+        for (int r = 0; r < freeCameras.size(); ++r) {
+            for (int k = 0; k < open.size(); ++k) {
+                const double s = score(cameras[freeCameras[r]], threats[open[k]], open[k], nowMs);
+                scores[r * open.size() + k] = s;
+                best = qMax(best, s);
+            }
+        }
+        QVector<double> costs(scores.size(), AssignmentSolver::FORBIDDEN_COST);
+        for (int i = 0; i < scores.size(); ++i) {
+            if (scores[i] > 0.0) costs[i] = best + 1.0 - scores[i];
+        }
+        const QVector<int> match = AssignmentSolver::solve(costs, freeCameras.size(), open.size());
+        for (int r = 0; r < freeCameras.size(); ++r) {
+            const QString& cameraId = cameras[freeCameras[r]].cameraId;
+            if (match[r] >= 0) result.insert(cameraId, threats[open[match[r]]].trackId);
+        }
+    }
+
+    // Becomes the current assignment; every camera on a track marks it seen
+    QHash<QString, Assignment> assignments;
+    for (const TaskableCamera& camera : cameras) {
+        const QString trackId = result.value(camera.cameraId);
+        if (!result.contains(camera.cameraId)) result.insert(camera.cameraId, QString());
+        if (trackId.isEmpty()) continue;
+        Assignment assignment = m_assignments.value(camera.cameraId);
+        if (assignment.trackId != trackId) {
+            assignment.trackId = trackId;
+            assignment.sinceMs = nowMs;
+        }
+        assignments.insert(camera.cameraId, assignment);
+        m_lastLookedAtMs.insert(trackId, nowMs);
+    }
+    m_assignments = assignments;
+
+    return result;
+}
+
+void CameraScheduler::forgetTrack(const QString& trackId) {
+    m_lastLookedAtMs.remove(trackId);
+    for (auto it = m_assignments.begin(); it != m_assignments.end();) {
+        if (it->trackId == trackId) {
+            it = m_assignments.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CameraScheduler::clear() {
+    m_assignments.clear();
+    m_lastLookedAtMs.clear();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,103 @@
+#ifndef CAMERASCHEDULER_H
+#define CAMERASCHEDULER_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "core/Track.h"
+#include "utils/CoverageRaster.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Weights and timings of camera tasking
+ */
+struct CameraTaskingConfig {
+    int candidatesPerCamera = 3;    // Threats considered per pass, highest first
+    double minTiltDeg = -10.0;      // Visible between these
+    double maxTiltDeg = 90.0;
+    double settleS = 0.5;           // Added to a slew onto a new track
+    double slewTimeScaleS = 2.0;    // A slew this long halves a camera's score
+    qint64 minDwellMs = 4000;       // A camera stays this long unless outranked
+    qint64 revisitMs = 15000;       // Confirmed tracks are looked at again after this
+    double confirmedWeight = 0.25;  // Score of a confirmed track just looked at
+    double stickiness = 1.5;        // Score multiplier for a camera's current track
+};
+
+/**
+ * @brief One PTZ camera available for tasking
+ */
+struct TaskableCamera {
+    QString cameraId;
+    GeoPosition mount;
+    double headingDeg = 0.0;        // Bearing of pan 0
+    double pan = 0.0;               // Where it points now
+    double tilt = 0.0;
+    double panSpeed = 50.0;         // degrees/second
+    double tiltSpeed = 30.0;
+    double maxRangeM = 3000.0;
+    CoverageRasterPtr coverage;     // Terrain masking at the mount; null for none
+};
+
+/**
+ * @brief One entry of the threat queue
+ */
+struct TaskableThreat {
+    QString trackId;
+    int threatLevel = 1;
+    GeoPosition position;
+    bool visuallyTracked = false;
+};
+
+/**
+ * @brief Assigns PTZ cameras to the threat queue
+ *
+ * Each pass scores every camera against the highest threats: threat level
+ * and queue rank, how well the camera sees the track (in range, within
+ * its tilt limits, not masked by terrain), and how long it takes to slew there from where it
+ * points now. The assignment with the best total goes through
+ * AssignmentSolver.
+ *
+ * Confirmed tracks are revisited round-robin: their score drops while a
+ * camera is on them and grows back over revisitMs and beyond, so idle
+ * cameras cycle through them. A camera keeps its current track at a
+ * bonus, and for minDwellMs outright, unless a higher threat level is
+ * waiting; scores that cross back and forth do not make it thrash.
+ */
+class CameraScheduler {
+public:
+    void setConfig(const CameraTaskingConfig& config) { m_config = config; }
+    CameraTaskingConfig config() const { return m_config; }
+
+    // Threats highest priority first. Returns every camera's track, empty
+    // for none; the result becomes the current assignment.
+    QHash<QString, QString> schedule(const QVector<TaskableCamera>& cameras,
+                                     const QVector<TaskableThreat>& threats, qint64 nowMs);
+
+    // 0 when the camera cannot see the track
+    double score(const TaskableCamera& camera, const TaskableThreat& threat, int rank,
+                 qint64 nowMs) const;
+
+    QString assignment(const QString& cameraId) const { return m_assignments.value(cameraId).trackId; }
+    void forgetTrack(const QString& trackId);
+    void forgetCamera(const QString& cameraId) { m_assignments.remove(cameraId); }
+    void clear();
+
+    // Camera time to point at target from where it is now, settling excluded
+    static double slewTimeS(const TaskableCamera& camera, const GeoPosition& target);
+
+private:
+    struct Assignment {
+        QString trackId;
+        qint64 sinceMs = 0;
+    };
+
+    CameraTaskingConfig m_config;
+    QHash<QString, Assignment> m_assignments;   // By camera
+    QHash<QString, qint64> m_lastLookedAtMs;    // By track
+    int m_waitingLevel = 0;                     // Of the last pass
+};
+
+} // namespace CounterUAS
+
+#endif // CAMERASCHEDULER_H
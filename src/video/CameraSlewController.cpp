@@ -1,28 +1,62 @@
 #include "video/CameraSlewController.h"
 #include "core/TrackManager.h"
+#include "core/TrackChangeThrottle.h"
+#include "core/ThreatAssessor.h"
+#include "core/CoverageService.h"
+#include "video/SlewControlLoop.h"
 #include "video/VideoStreamManager.h"
+#include "sensors/CameraModel.h"
+#include "utils/CoordinateUtils.h"
 #include "utils/Logger.h"
+#include <QtMath>
+#include <cmath>
 
 namespace CounterUAS {
 
+namespace {
+
+// Span assumed for a target's box when nothing measured it, and the least
+// box drawn at long range
+constexpr double TARGET_SPAN_M = 2.0;
+constexpr double MIN_BOX_PIXELS = 8.0;
+
+} // namespace
+
 CameraSlewController::CameraSlewController(QObject* parent)
     : QObject(parent)
-    , m_updateTimer(new QTimer(this))
+    , m_updateTimer(this, [this]() { updateTracking(); })
+    , m_loop(new SlewControlLoop(this))
+    , m_taskingTimer(this, [this]() { runTasking(); })
 {
-    m_updateTimer->setInterval(100);
-    connect(m_updateTimer, &QTimer::timeout, this, &CameraSlewController::updateTracking);
+    m_updateTimer.setInterval(100);
+    // Dwell and revisit times run out between threat changes
+    m_taskingTimer.setInterval(1000);
+    // Emitted on the loop thread, applied here where the PTZ sockets live
+    connect(m_loop, &SlewControlLoop::rateCommand, this, &CameraSlewController::onRateCommand,
+            Qt::QueuedConnection);
+}
+
+CameraSlewController::~CameraSlewController() {
+    m_loop->stop();
 }
 
 void CameraSlewController::setTrackManager(TrackManager* manager) {
     if (m_trackManager) {
         disconnect(m_trackManager, nullptr, this, nullptr);
     }
+    delete m_changeThrottle;
+    m_changeThrottle = nullptr;
     
     m_trackManager = manager;
     
     if (m_trackManager) {
-        connect(m_trackManager, &TrackManager::trackUpdated,
-                this, &CameraSlewController::onTrackUpdated);
+        // Re-slewing faster than the tracking timer only queues PTZ commands
+        m_changeThrottle = new TrackChangeThrottle(m_trackManager, 1000 / m_updateTimer.interval(), this);
+        connect(m_changeThrottle, &TrackChangeThrottle::tracksChanged,
+                this, &CameraSlewController::onTracksChanged);
+        // Priority tier tracks feed the predictive loop every track cycle
+        connect(m_trackManager, &TrackManager::tracksChanged,
+                this, &CameraSlewController::onPriorityTracksChanged);
         connect(m_trackManager, &TrackManager::trackDropped,
                 this, &CameraSlewController::onTrackDropped);
     }
@@ -32,9 +66,213 @@ void CameraSlewController::setVideoStreamManager(VideoStreamManager* manager) {
     m_videoManager = manager;
 }
 
+void CameraSlewController::setPTZController(const QString& cameraId, PTZController* controller,
+                                            const GeoPosition& mount, double headingDeg) {
+    removePTZController(cameraId);
+    if (!controller) return;
+    
+    m_ptzControllers[cameraId] = controller;
+    
+    const PTZConfig ptz = controller->config();
+    SlewControlLoop::CameraMount cameraMount;
+    cameraMount.position = mount;
+    cameraMount.headingDeg = headingDeg;
+    cameraMount.latencyMs = ptz.commandLatencyMs;
+    cameraMount.maxPanRate = ptz.panSpeed;
+    cameraMount.maxTiltRate = ptz.tiltSpeed;
+    m_loop->setCamera(cameraId, cameraMount, controller->currentPan(), controller->currentTilt());
+    
+    TaskableCamera& taskable = m_taskable[cameraId];
+    taskable.cameraId = cameraId;
+    taskable.mount = mount;
+    taskable.headingDeg = headingDeg;
+    taskable.panSpeed = ptz.panSpeed;
+    taskable.tiltSpeed = ptz.tiltSpeed;
+    
+    connect(controller, &PTZController::positionChanged, this,
+            [this, cameraId](double pan, double tilt, double) {
+                m_loop->setFeedback(cameraId, pan, tilt);
+                publishSensorMetadata(cameraId);
+            });
+    connect(controller, &QObject::destroyed, this,
+            [this, cameraId]() {
+                m_ptzControllers.remove(cameraId);
+                m_taskable.remove(cameraId);
+                m_scheduler.forgetCamera(cameraId);
+                m_loop->removeCamera(cameraId);
+            });
+    
+    // Already following something: switch it over to the loop
+    if (isPredictive(cameraId) && m_cameraTrackMap.contains(cameraId)) {
+        slewToTrack(cameraId, m_cameraTrackMap.value(cameraId));
+    }
+}
+
+void CameraSlewController::removePTZController(const QString& cameraId) {
+    PTZController* controller = m_ptzControllers.take(cameraId);
+    if (!controller) return;
+    
+    disconnect(controller, nullptr, this, nullptr);
+    if (m_loop->cameraState(cameraId).engaged) controller->stop();
+    m_loop->removeCamera(cameraId);
+    m_taskable.remove(cameraId);
+    m_scheduler.forgetCamera(cameraId);
+}
+
+void CameraSlewController::setCameraRange(const QString& cameraId, double maxRangeM) {
+    auto it = m_taskable.find(cameraId);
+    if (it != m_taskable.end()) it->maxRangeM = maxRangeM;
+}
+
+void CameraSlewController::setThreatAssessor(ThreatAssessor* assessor) {
+    if (m_threatAssessor) {
+        disconnect(m_threatAssessor, nullptr, this, nullptr);
+    }
+    m_threatAssessor = assessor;
+    if (m_threatAssessor) {
+        connect(m_threatAssessor, &ThreatAssessor::threatLevelChanged, this,
+                [this](const QString&, int, int) { requestTasking(); });
+    }
+    requestTasking();
+}
+
+void CameraSlewController::setAutoTasking(bool enable) {
+    if (m_autoTasking == enable) return;
+    m_autoTasking = enable;
+    
+    if (enable) {
+        m_taskingTimer.start();
+        requestTasking();
+    } else {
+        m_taskingTimer.stop();
+        // Scheduled cameras stand down; the operator's stay on their tracks
+        const QStringList cameras = m_cameraTrackMap.keys();
+        for (const QString& cameraId : cameras) {
+            if (!m_pinned.contains(cameraId)) endTracking(cameraId);
+        }
+        m_scheduler.clear();
+    }
+}
+
+void CameraSlewController::requestTasking() {
+    // Coalesces a burst of threat changes into one pass
+    if (!m_autoTasking || m_taskingPending) return;
+    m_taskingPending = true;
+    QTimer::singleShot(0, this, [this]() {
+        m_taskingPending = false;
+        runTasking();
+    });
+}
+
+void CameraSlewController::runTasking() {
+    if (!m_autoTasking || !m_threatAssessor || !m_trackManager) return;
+    
+    QVector<TaskableCamera> cameras;
+    for (auto it = m_taskable.cbegin(); it != m_taskable.cend(); ++it) {
+        if (m_pinned.contains(it.key())) continue;
+        PTZController* controller = m_ptzControllers.value(it.key());
+        if (!controller) continue;
+        TaskableCamera camera = it.value();
+        camera.pan = controller->currentPan();
+        camera.tilt = controller->currentTilt();
+        if (m_coverage) {
+            const CoverageRasterPtr coverage = m_coverage->raster(it.key());
+            if (coverage && coverage->isFor(camera.mount)) camera.coverage = coverage;
+        }
+        cameras.append(camera);
+    }
+    if (cameras.isEmpty()) return;
+    
+    // Only the head of the queue; tracks the operator is already on are skipped
+    QSet<QString> covered;
+    for (const QString& cameraId : m_pinned) covered.insert(m_cameraTrackMap.value(cameraId));
+    const int wanted = qMax(1, m_scheduler.config().candidatesPerCamera) * cameras.size() + covered.size();
+    QVector<TaskableThreat> threats;
+    for (const TrackSnapshot& track : m_threatAssessor->topThreats(wanted)) {
+        if (covered.contains(track.trackId) || track.state == TrackState::Dropped) continue;
+        TaskableThreat threat;
+        threat.trackId = track.trackId;
+        threat.threatLevel = track.threatLevel;
+        threat.position = track.position;
+        threat.visuallyTracked = track.visuallyTracked;
+        threats.append(threat);
+    }
+    
+    const QHash<QString, QString> tasks =
+        m_scheduler.schedule(cameras, threats, QDateTime::currentMSecsSinceEpoch());
+    for (auto it = tasks.cbegin(); it != tasks.cend(); ++it) {
+        if (m_cameraTrackMap.value(it.key()) == it.value()) continue;
+        if (it.value().isEmpty()) {
+            endTracking(it.key());
+        } else {
+            beginTracking(it.key(), it.value());
+        }
+        emit cameraTasked(it.key(), it.value());
+    }
+}
+
+void CameraSlewController::setSlewMode(SlewMode mode) {
+    if (m_mode == mode) return;
+    
+    m_mode = mode;
+    for (auto it = m_cameraTrackMap.begin(); it != m_cameraTrackMap.end(); ++it) {
+        if (!m_ptzControllers.contains(it.key())) continue;
+        if (mode == SlewMode::Predictive) {
+            slewToTrack(it.key(), it.value());
+        } else {
+            releaseLoop(it.key());
+        }
+    }
+    if (mode == SlewMode::Position) m_loop->stop();
+    
+    Logger::instance().info("CameraSlewController",
+                           mode == SlewMode::Predictive ? "Predictive slewing" : "Position slewing");
+}
+
+void CameraSlewController::setControlLoopConfig(const SlewLoopConfig& config) {
+    m_loop->setConfig(config);
+}
+
+bool CameraSlewController::isPredictive(const QString& cameraId) const {
+    return m_mode == SlewMode::Predictive && m_ptzControllers.contains(cameraId);
+}
+
+void CameraSlewController::feedLoop(const QString& cameraId, const TrackSnapshot& track, qint64 stateTimeMs) {
+    m_loop->setTarget(cameraId, track, stateTimeMs);
+    m_loop->start();
+}
+
+void CameraSlewController::releaseLoop(const QString& cameraId) {
+    m_loop->release(cameraId);
+    if (PTZController* controller = m_ptzControllers.value(cameraId)) {
+        controller->stop();
+    }
+}
+
+void CameraSlewController::onRateCommand(const QString& cameraId, double panRate, double tiltRate) {
+    PTZController* controller = m_ptzControllers.value(cameraId);
+    if (!controller) return;
+    
+    // A cycle queued before release() lands after it
+    if (!isPredictive(cameraId) || !m_loop->cameraState(cameraId).engaged) return;
+    controller->setPanTiltVelocity(panRate, tiltRate);
+}
+
 void CameraSlewController::slewToTrack(const QString& cameraId, const QString& trackId) {
     if (!m_trackManager) return;
     
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    if (const TrackSnapshot* track = picture->find(trackId)) {
+        if (isPredictive(cameraId)) {
+            feedLoop(cameraId, *track, picture->timestampMs);
+            emit slewStarted(cameraId, track->position);
+        } else {
+            slewToPosition(cameraId, track->position);
+        }
+        return;
+    }
+    
+    // Created since the last published picture
     Track* track = m_trackManager->track(trackId);
     if (!track) {
         Logger::instance().warning("CameraSlewController",
@@ -42,13 +280,24 @@ void CameraSlewController::slewToTrack(const QString& cameraId, const QString& t
         return;
     }
     
-    slewToPosition(cameraId, track->position());
+    if (isPredictive(cameraId)) {
+        feedLoop(cameraId, TrackSnapshot::fromTrack(*track), QDateTime::currentMSecsSinceEpoch());
+        emit slewStarted(cameraId, track->position());
+    } else {
+        slewToPosition(cameraId, track->position());
+    }
 }
 
 void CameraSlewController::startAutoTracking(const QString& cameraId, const QString& trackId) {
-    if (!m_trackManager) return;
+    if (!m_trackManager || !m_trackManager->track(trackId)) return;
     
-    Track* track = m_trackManager->track(trackId);
+    m_pinned.insert(cameraId);
+    m_scheduler.forgetCamera(cameraId);
+    beginTracking(cameraId, trackId);
+}
+
+void CameraSlewController::beginTracking(const QString& cameraId, const QString& trackId) {
+    Track* track = m_trackManager ? m_trackManager->track(trackId) : nullptr;
     if (!track) return;
     
     m_cameraTrackMap[cameraId] = trackId;
@@ -57,8 +306,8 @@ void CameraSlewController::startAutoTracking(const QString& cameraId, const QStr
     slewToTrack(cameraId, trackId);
     
     // Start update timer if not running
-    if (!m_updateTimer->isActive()) {
-        m_updateTimer->start();
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
     }
     
     Logger::instance().info("CameraSlewController",
@@ -70,13 +319,24 @@ void CameraSlewController::startAutoTracking(const QString& cameraId, const QStr
 }
 
 void CameraSlewController::stopAutoTracking(const QString& cameraId) {
+    const bool wasPinned = m_pinned.remove(cameraId);
+    endTracking(cameraId);
+    // Back in the pool
+    if (wasPinned) requestTasking();
+}
+
+void CameraSlewController::endTracking(const QString& cameraId) {
     if (!m_cameraTrackMap.contains(cameraId)) return;
     
     m_cameraTrackMap.remove(cameraId);
+    if (isPredictive(cameraId)) {
+        releaseLoop(cameraId);
+    }
     
     // Stop timer if no more tracking
     if (m_cameraTrackMap.isEmpty()) {
-        m_updateTimer->stop();
+        m_updateTimer.stop();
+        m_loop->stop();
     }
     
     Logger::instance().info("CameraSlewController",
@@ -107,18 +367,96 @@ QString CameraSlewController::trackedTrack(const QString& cameraId) const {
     return m_cameraTrackMap.value(cameraId);
 }
 
-void CameraSlewController::onTrackUpdated(const QString& trackId) {
-    // Update slew for any cameras tracking this track
+bool CameraSlewController::predictedBox(const QString& cameraId, const TrackSnapshot& track,
+                                        qint64 stateTimeMs, qint64 atMs, const QSize& frameSize,
+                                        const QSizeF& boxSize, QRectF& box) const {
+    PTZController* controller = m_ptzControllers.value(cameraId);
+    auto camera = m_taskable.constFind(cameraId);
+    if (!controller || camera == m_taskable.constEnd() || frameSize.isEmpty()) return false;
+    
+    CameraMount mount;
+    mount.position = camera->mount;
+    mount.headingDeg = camera->headingDeg;
+    CameraModel model;
+    model.setMount(mount);
+    model.setImageSize(frameSize);
+    model.setPointing(controller->currentPan(), controller->currentTilt(), controller->horizontalFov());
+    
+    QPointF centre;
+    if (!model.project(track.predictedPosition(qMax<qint64>(0, atMs - stateTimeMs)), centre)) return false;
+    box = QRectF(centre.x() - boxSize.width() / 2.0, centre.y() - boxSize.height() / 2.0,
+                 boxSize.width(), boxSize.height());
+    return true;
+}
+
+bool CameraSlewController::targetBox(const QString& cameraId, const TrackSnapshot& track,
+                                     qint64 stateTimeMs, qint64 atMs, const QSize& frameSize,
+                                     QRectF& box, double* rangeM) const {
+    PTZController* controller = m_ptzControllers.value(cameraId);
+    auto camera = m_taskable.constFind(cameraId);
+    if (!controller || camera == m_taskable.constEnd() || frameSize.isEmpty()) return false;
+    
+    const double range = qMax(1.0, CoordinateUtils::haversineDistance(camera->mount, track.position));
+    const double focal = frameSize.width() / 2.0 /
+                         std::tan(qDegreesToRadians(controller->horizontalFov()) / 2.0);
+    const double side = qMax(MIN_BOX_PIXELS, focal * TARGET_SPAN_M / range);
+    if (!predictedBox(cameraId, track, stateTimeMs, atMs, frameSize, QSizeF(side, side), box)) return false;
+    if (rangeM) *rangeM = range;
+    return true;
+}
+
+VideoOverlayRenderer::TrackProjector CameraSlewController::trackProjector(const QString& cameraId) const {
+    // The history has already brought the state to the frame's time
+    return [this, cameraId](const TrackSnapshot& state, qint64 timeMs, const QSize& frameSize,
+                            TrackOverlay& overlay) {
+        QRectF box;
+        double rangeM = 0.0;
+        if (!targetBox(cameraId, state, timeMs, timeMs, frameSize, box, &rangeM)) return false;
+        const QRect pixels = box.toAlignedRect();
+        overlay.boundingBox.x = pixels.x();
+        overlay.boundingBox.y = pixels.y();
+        overlay.boundingBox.width = pixels.width();
+        overlay.boundingBox.height = pixels.height();
+        overlay.distance = rangeM;
+        auto camera = m_taskable.constFind(cameraId);
+        if (camera != m_taskable.constEnd()) {
+            overlay.bearing = CoordinateUtils::bearing(camera->mount, state.position);
+        }
+        return true;
+    };
+}
+
+void CameraSlewController::onTracksChanged(const TrackChangeSet& changes) {
+    if (!m_trackManager || m_cameraTrackMap.isEmpty()) return;
+    
+    // Update slew for any cameras tracking a track that moved
+    TrackPicturePtr picture = m_trackManager->snapshot();
     for (auto it = m_cameraTrackMap.begin(); it != m_cameraTrackMap.end(); ++it) {
-        if (it.value() == trackId) {
-            Track* track = m_trackManager->track(trackId);
-            if (track) {
-                slewToPosition(it.key(), track->position());
+        const TrackSnapshot* track = picture->find(it.value());
+        if (track && (changes.fieldsFor(track->handle) & TrackChangeKinematics)) {
+            if (isPredictive(it.key())) {
+                feedLoop(it.key(), *track, picture->timestampMs);
+            } else {
+                slewToPosition(it.key(), track->position);
             }
         }
     }
 }
 
+void CameraSlewController::onPriorityTracksChanged(const TrackChangeSet& changes) {
+    if (!m_trackManager || m_cameraTrackMap.isEmpty() || m_mode != SlewMode::Predictive) return;
+    
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    for (auto it = m_cameraTrackMap.begin(); it != m_cameraTrackMap.end(); ++it) {
+        if (!isPredictive(it.key())) continue;
+        const TrackSnapshot* track = picture->find(it.value());
+        if (!track || !(changes.fieldsFor(track->handle) & TrackChangeKinematics)) continue;
+        if (m_trackManager->updateTier(track->handle) == TrackUpdateTier::Priority) {
+            feedLoop(it.key(), *track, picture->timestampMs);
+        }
+    }
+}
+
 void CameraSlewController::onTrackDropped(const QString& trackId) {
     // Stop tracking for any cameras following this track
     QStringList camerasToStop;
@@ -133,23 +471,78 @@ void CameraSlewController::onTrackDropped(const QString& trackId) {
     for (const QString& cameraId : camerasToStop) {
         stopAutoTracking(cameraId);
     }
+    
+    m_scheduler.forgetTrack(trackId);
+    requestTasking();
 }
 
 void CameraSlewController::updateTracking() {
     if (m_cameraTrackMap.isEmpty() || !m_trackManager) {
-        m_updateTimer->stop();
+        m_updateTimer.stop();
         return;
     }
     
     // Periodic update for all tracked cameras
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
     for (auto it = m_cameraTrackMap.begin(); it != m_cameraTrackMap.end(); ++it) {
-        Track* track = m_trackManager->track(it.value());
-        if (track && track->state() != TrackState::Dropped) {
-            // Use predicted position for smoother tracking
-            GeoPosition predicted = track->predictedPosition(100);  // 100ms ahead
+        const TrackSnapshot* track = picture->find(it.value());
+        if (track && track->state != TrackState::Dropped && isPredictive(it.key())) {
+            // The loop does its own extrapolation
+            feedLoop(it.key(), *track, picture->timestampMs);
+        } else if (track && track->state != TrackState::Dropped) {
+            // Use predicted position for smoother tracking; the picture may be
+            // up to one track cycle old, so extrapolate from its timestamp.
+            qint64 lead = 100 + qMax<qint64>(0, now - picture->timestampMs);
+            GeoPosition predicted = track->predictedPosition(lead);
             slewToPosition(it.key(), predicted);
         }
+        publishSensorMetadata(it.key());
+    }
+}
+
+void CameraSlewController::publishSensorMetadata(const QString& cameraId) {
+    PTZController* controller = m_ptzControllers.value(cameraId);
+    auto camera = m_taskable.constFind(cameraId);
+    if (!m_videoManager || !controller || camera == m_taskable.constEnd()) return;
+    
+    SensorMetadata metadata;
+    metadata.sensor = camera->mount;
+    metadata.platformHeadingDeg = camera->headingDeg;
+    metadata.sensorAzimuthDeg = controller->currentPan();
+    metadata.sensorElevationDeg = controller->currentTilt();
+    metadata.horizontalFovDeg = controller->horizontalFov();
+    
+    // Looking down, the boresight meets flat ground at the mount's height
+    const double depression = qDegreesToRadians(-controller->currentTilt());
+    if (depression > 0.0 && camera->mount.altitude > 0.0) {
+        metadata.frameCenter = CoordinateUtils::positionFromBearingDistance(
+            camera->mount, camera->headingDeg + controller->currentPan(),
+            camera->mount.altitude / std::tan(depression));
+        metadata.frameCenter.altitude = 0.0;
+        metadata.hasFrameCenter = true;
+    }
+    
+    // The followed track, boxed where the frame shows it now
+    VideoSource* stream = m_videoManager->stream(cameraId);
+    const QString trackId = m_cameraTrackMap.value(cameraId);
+    if (stream && m_trackManager && !trackId.isEmpty()) {
+        const VideoSourceStats stats = stream->stats();
+        const QSize frameSize(stats.width, stats.height);
+        TrackPicturePtr picture = m_trackManager->snapshot();
+        const TrackSnapshot* track = picture->find(trackId);
+        QRectF box;
+        if (track && targetBox(cameraId, *track, picture->timestampMs, QDateTime::currentMSecsSinceEpoch(),
+                               frameSize, box)) {
+            KlvTarget target;
+            target.id = track->handle;
+            target.box = QRectF(box.x() / frameSize.width(), box.y() / frameSize.height(),
+                                box.width() / frameSize.width(), box.height() / frameSize.height());
+            target.confidence = qRound(track->trackQuality * 100.0);
+            metadata.targets.append(target);
+        }
     }
+    m_videoManager->setSensorMetadata(cameraId, metadata);
 }
 
 } // namespace CounterUAS
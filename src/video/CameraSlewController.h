@@ -2,27 +2,84 @@
 #define CAMERASLEWCONTROLLER_H
 
 #include <QObject>
+#include <QRectF>
+#include <QSet>
+#include <QStringList>
 #include "core/Track.h"
+#include "core/TrackChangeSet.h"
+#include "core/TrackSnapshot.h"
+#include "video/CameraScheduler.h"
 #include "video/PTZController.h"
+#include "video/VideoOverlayRenderer.h"
 
 namespace CounterUAS {
 
+class CoverageService;
+class ThreatAssessor;
 class TrackManager;
 class VideoStreamManager;
+class TrackChangeThrottle;
+class SlewControlLoop;
+struct SlewLoopConfig;
+
+/**
+ * @brief How auto-tracking points a camera
+ */
+enum class SlewMode {
+    Position = 0,   // Absolute slews to the track's position every update
+    Predictive      // Rate control at the lead point, for cameras with a PTZ controller
+};
 
 /**
  * @brief Camera slew controller for automatic track following
+ *
+ * In predictive mode cameras registered with setPTZController() are
+ * handed to a SlewControlLoop, which commands continuous pan/tilt rates
+ * from its own timer thread; this class keeps it fed with the tracks'
+ * filtered states and the cameras' reported positions. Other cameras
+ * keep slewing to positions.
+ *
+ * Each PTZ camera's pointing, and the box of the track it follows, is
+ * published to the VideoStreamManager as its SensorMetadata whenever the
+ * camera reports a move and on every tracking update, for the KLV muxed
+ * into its recordings and re-stream.
+ *
+ * With auto-tasking on, a CameraScheduler shares those cameras out over
+ * the ThreatAssessor's queue, again whenever a threat level changes and
+ * at least once a second, passing over tracks a camera's coverage raster
+ * has behind terrain. Cameras the operator put on a track with
+ * startAutoTracking() are left alone until stopAutoTracking().
  */
 class CameraSlewController : public QObject {
     Q_OBJECT
     
 public:
     explicit CameraSlewController(QObject* parent = nullptr);
-    ~CameraSlewController() override = default;
+    ~CameraSlewController() override;
     
     void setTrackManager(TrackManager* manager);
     void setVideoStreamManager(VideoStreamManager* manager);
     
+    // A camera the predictive loop can drive; mount heading is the bearing of pan 0
+    void setPTZController(const QString& cameraId, PTZController* controller,
+                          const GeoPosition& mount, double headingDeg = 0.0);
+    void removePTZController(const QString& cameraId);
+    
+    void setSlewMode(SlewMode mode);
+    SlewMode slewMode() const { return m_mode; }
+    void setControlLoopConfig(const SlewLoopConfig& config);
+    SlewControlLoop* controlLoop() const { return m_loop; }
+    
+    // Camera tasking over the threat queue
+    void setThreatAssessor(ThreatAssessor* assessor);
+    void setAutoTasking(bool enable);
+    bool autoTasking() const { return m_autoTasking; }
+    void setTaskingConfig(const CameraTaskingConfig& config) { m_scheduler.setConfig(config); }
+    CameraTaskingConfig taskingConfig() const { return m_scheduler.config(); }
+    void setCameraRange(const QString& cameraId, double maxRangeM);
+    // Terrain masking for tasking, by camera ID; the service outlives the controller
+    void setCoverageService(const CoverageService* coverage) { m_coverage = coverage; }
+    
     // Auto-slew to track
     void slewToTrack(const QString& cameraId, const QString& trackId);
     void startAutoTracking(const QString& cameraId, const QString& trackId);
@@ -36,25 +93,66 @@ public:
     bool isTracking(const QString& cameraId) const;
     QString trackedTrack(const QString& cameraId) const;
     
+    // Where the track will appear in the camera's frame at atMs: a box of
+    // boxSize pixels centred on the track's state as of stateTimeMs,
+    // predicted forward and projected through the camera's current pan,
+    // tilt and field of view. False for cameras without a PTZ controller
+    // or tracks behind the image plane.
+    bool predictedBox(const QString& cameraId, const TrackSnapshot& track, qint64 stateTimeMs,
+                      qint64 atMs, const QSize& frameSize, const QSizeF& boxSize, QRectF& box) const;
+    // predictedBox() sized for a small drone at the track's range, which
+    // goes in rangeM when given
+    bool targetBox(const QString& cameraId, const TrackSnapshot& track, qint64 stateTimeMs,
+                   qint64 atMs, const QSize& frameSize, QRectF& box, double* rangeM = nullptr) const;
+    // Places frame-aligned overlay boxes for the camera by targetBox(); the
+    // controller outlives the renderer it is given to
+    VideoOverlayRenderer::TrackProjector trackProjector(const QString& cameraId) const;
+    
 signals:
     void slewStarted(const QString& cameraId, const GeoPosition& target);
     void slewComplete(const QString& cameraId);
     void trackingStarted(const QString& cameraId, const QString& trackId);
     void trackingStopped(const QString& cameraId);
     void trackLost(const QString& cameraId, const QString& trackId);
+    void cameraTasked(const QString& cameraId, const QString& trackId);  // Empty: stood down
     
 private slots:
-    void onTrackUpdated(const QString& trackId);
+    void onTracksChanged(const TrackChangeSet& changes);
+    void onPriorityTracksChanged(const TrackChangeSet& changes);
     void onTrackDropped(const QString& trackId);
     void updateTracking();
+    void onRateCommand(const QString& cameraId, double panRate, double tiltRate);
+    void runTasking();
     
 private:
+    void requestTasking();
+    void beginTracking(const QString& cameraId, const QString& trackId);
+    void endTracking(const QString& cameraId);
+    bool isPredictive(const QString& cameraId) const;
+    void feedLoop(const QString& cameraId, const TrackSnapshot& track, qint64 stateTimeMs);
+    void releaseLoop(const QString& cameraId);
+    void publishSensorMetadata(const QString& cameraId);
+    
+
     TrackManager* m_trackManager = nullptr;
+    const CoverageService* m_coverage = nullptr;
+    TrackChangeThrottle* m_changeThrottle = nullptr;
     VideoStreamManager* m_videoManager = nullptr;
     
     QHash<QString, QString> m_cameraTrackMap;  // cameraId -> trackId
     QHash<QString, PTZController*> m_ptzControllers;
-    QTimer* m_updateTimer;
+    ServiceTimer m_updateTimer;
+    
+    SlewMode m_mode = SlewMode::Position;
+    SlewControlLoop* m_loop;
+    
+    ThreatAssessor* m_threatAssessor = nullptr;
+    CameraScheduler m_scheduler;
+    QHash<QString, TaskableCamera> m_taskable;  // Cameras with a PTZ controller
+    QSet<QString> m_pinned;                     // Operator's choice, never re-tasked
+    ServiceTimer m_taskingTimer;
+    bool m_autoTasking = false;
+    bool m_taskingPending = false;
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,391 @@
+#include "video/CaptureService.h"
+#include "video/RecordingStorage.h"
+#include "video/VideoStreamManager.h"
+#include "utils/Logger.h"
+#include "utils/TaskScheduler.h"
+#include <QBuffer>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QMutexLocker>
+#include <QTimer>
+#include <algorithm>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int BURST_CHECK_MS = 250;
+const char* const STAMP_FORMAT = "yyyyMMdd'T'HHmmsszzz";
+
+} // namespace
+
+CaptureService::CaptureService(QObject* parent)
+    : QObject(parent)
+    , m_burstTimer(new QTimer(this))
+{
+    qRegisterMetaType<CaptureRecord>("CaptureRecord");
+    m_clock.start();
+    m_burstTimer->setInterval(BURST_CHECK_MS);
+    connect(m_burstTimer, &QTimer::timeout, this, &CaptureService::checkBurstTimeouts);
+}
+
+CaptureService::~CaptureService() {
+    waitForEncoding();
+}
+
+void CaptureService::setConfig(const CaptureConfig& config) {
+    QMutexLocker locker(&m_mutex);
+    const bool ringChanged = config.preRollFrames != m_config.preRollFrames;
+    m_config = config;
+    if (!ringChanged) return;
+    for (Camera& camera : m_cameras) {
+        camera.recent.clear();
+        camera.head = 0;
+    }
+}
+
+CaptureConfig CaptureService::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+void CaptureService::setVideoManager(VideoStreamManager* manager) {
+    if (!manager) return;
+    connect(manager, &VideoStreamManager::videoFrameReady, this,
+            [this](const QString& cameraId, const VideoFrame& frame) {
+                addFrame(cameraId, frame, QDateTime::currentMSecsSinceEpoch());
+            }, Qt::DirectConnection);
+}
+
+void CaptureService::setStorage(RecordingStorage* storage) {
+    QMutexLocker locker(&m_mutex);
+    m_storage = storage;
+}
+
+void CaptureService::setPreRollCameras(const QStringList& cameraIds) {
+    QMutexLocker locker(&m_mutex);
+    m_preRollCameras.clear();
+    for (const QString& cameraId : cameraIds) m_preRollCameras.insert(cameraId);
+    for (auto it = m_cameras.begin(); it != m_cameras.end(); ++it) {
+        it->preRoll = m_preRollCameras.contains(it.key());
+        if (!it->preRoll) {
+            it->recent.clear();     // Returns the buffers to the pool
+            it->head = 0;
+        }
+    }
+}
+
+void CaptureService::addFrame(const QString& cameraId, const VideoFrame& frame, qint64 timeMs) {
+    if (frame.isNull()) return;
+
+    QVector<QPair<QString, int>> closed;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_cameras.find(cameraId);
+        if (it == m_cameras.end()) {
+            it = m_cameras.insert(cameraId, Camera());
+            it->preRoll = m_preRollCameras.contains(cameraId);
+        }
+        Camera& camera = it.value();
+        const TimedFrame timed{frame, timeMs};
+        camera.latest = timed;
+
+        const int ringSize = m_config.preRollFrames;
+        if (camera.preRoll && ringSize > 0) {
+            if (camera.recent.size() < ringSize) {
+                camera.recent.append(timed);
+            } else {
+                camera.recent[camera.head] = timed;
+                camera.head = (camera.head + 1) % ringSize;
+            }
+        }
+
+        for (int i = 0; i < camera.bursts.size();) {
+            PendingBurst& burst = camera.bursts[i];
+            if (submitLocked(burstJob(burst, cameraId, timed))) burst.submitted++;
+            burst.lastFrameMs = m_clock.elapsed();
+            if (burst.next >= burst.size) {
+                closed.append(qMakePair(burst.burstId, burst.submitted));
+                camera.bursts.remove(i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // Bursts are tracked on the service's thread
+    for (const auto& burst : qAsConst(closed)) {
+        QMetaObject::invokeMethod(this, [this, burst]() {
+            closeBurst(burst.first, burst.second);
+        }, Qt::QueuedConnection);
+    }
+}
+
+QString CaptureService::snapshot(const QString& cameraId, const CaptureTags& tags) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_cameras.constFind(cameraId);
+    if (it == m_cameras.constEnd() || it->latest.frame.isNull()) return QString();
+
+    const TimedFrame latest = it->latest;
+    const Job job = makeJob(nextId(cameraId, latest.timeMs), cameraId, tags, latest);
+    return submitLocked(job) ? job.record.captureId : QString();
+}
+
+QString CaptureService::snapshot(const QString& cameraId, const VideoFrame& frame, const CaptureTags& tags) {
+    if (frame.isNull()) return QString();
+
+    QMutexLocker locker(&m_mutex);
+    const TimedFrame timed{frame, QDateTime::currentMSecsSinceEpoch()};
+    const Job job = makeJob(nextId(cameraId, timed.timeMs), cameraId, tags, timed);
+    return submitLocked(job) ? job.record.captureId : QString();
+}
+
+QString CaptureService::burst(const QString& cameraId, const CaptureTags& tags, int frames) {
+    QString burstId;
+    int submitted = 0;
+    bool complete = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_cameras.find(cameraId);
+        if (it == m_cameras.end() || it->latest.frame.isNull()) return QString();
+        Camera& camera = it.value();
+
+        PendingBurst burst;
+        burst.burstId = nextId(cameraId, camera.latest.timeMs);
+        burst.tags = tags;
+        burst.size = frames > 0 ? frames : qMax(1, m_config.burstFrames);
+
+        // The pre-roll ring ends with the latest frame; other cameras only
+        // have that one
+        QVector<TimedFrame> before;
+        if (camera.recent.isEmpty()) {
+            before.append(camera.latest);
+        } else {
+            const int count = camera.recent.size();
+            const int take = qMin(count, burst.size);
+            for (int i = count - take; i < count; ++i) {
+                before.append(camera.recent[(camera.head + i) % count]);
+            }
+        }
+
+        for (const TimedFrame& timed : qAsConst(before)) {
+            if (submitLocked(burstJob(burst, cameraId, timed))) burst.submitted++;
+        }
+        burst.lastFrameMs = m_clock.elapsed();
+
+        burstId = burst.burstId;
+        submitted = burst.submitted;
+        complete = burst.next >= burst.size;
+        if (!complete) camera.bursts.append(burst);
+    }
+
+    // Before any of its frames can finish: they are queued to this thread
+    m_bursts.insert(burstId, BurstProgress());
+    if (complete) {
+        closeBurst(burstId, submitted);
+    } else if (!m_burstTimer->isActive()) {
+        m_burstTimer->start();
+    }
+    return burstId;
+}
+
+QVector<CaptureRecord> CaptureService::capturesForEngagement(const QString& engagementId) const {
+    QVector<CaptureRecord> records;
+    for (int index : m_byEngagement.value(engagementId)) records.append(m_records[index]);
+    return records;
+}
+
+QVector<CaptureRecord> CaptureService::capturesForTrack(const QString& trackId) const {
+    QVector<CaptureRecord> records;
+    for (int index : m_byTrack.value(trackId)) records.append(m_records[index]);
+    return records;
+}
+
+QVector<CaptureRecord> CaptureService::burstCaptures(const QString& burstId) const {
+    QVector<CaptureRecord> records;
+    for (int index : m_byBurst.value(burstId)) records.append(m_records[index]);
+    std::sort(records.begin(), records.end(), [](const CaptureRecord& a, const CaptureRecord& b) {
+        return a.burstIndex < b.burstIndex;
+    });
+    return records;
+}
+
+CaptureRecord CaptureService::capture(const QString& captureId) const {
+    auto it = m_byId.constFind(captureId);
+    return it != m_byId.constEnd() ? m_records[it.value()] : CaptureRecord();
+}
+
+CaptureStats CaptureService::stats() const {
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void CaptureService::waitForEncoding() const {
+    QMutexLocker locker(&m_mutex);
+    while (m_stats.pending > 0) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+QString CaptureService::nextId(const QString& cameraId, qint64 timeMs) {
+    return QString("%1_%2_%3")
+        .arg(RecordingStorage::cameraKey(cameraId),
+             QDateTime::fromMSecsSinceEpoch(timeMs, Qt::UTC).toString(STAMP_FORMAT))
+        .arg(++m_sequence);
+}
+
+CaptureService::Job CaptureService::makeJob(const QString& captureId, const QString& cameraId,
+                                            const CaptureTags& tags, const TimedFrame& frame) const {
+    Job job;
+    job.record.captureId = captureId;
+    job.record.cameraId = cameraId;
+    job.record.tags = tags;
+    job.record.frameTimeMs = frame.timeMs;
+    job.record.size = frame.frame.size();
+    job.frame = frame.frame;            // Shares the pooled buffer
+    job.config = m_config;
+    job.storage = m_storage;
+    return job;
+}
+
+CaptureService::Job CaptureService::burstJob(PendingBurst& burst, const QString& cameraId,
+                                             const TimedFrame& frame) const {
+    const QString captureId = burst.burstId + QString("_%1").arg(burst.next, 2, 10, QChar('0'));
+    Job job = makeJob(captureId, cameraId, burst.tags, frame);
+    job.record.burstId = burst.burstId;
+    job.record.burstIndex = burst.next++;
+    job.record.burstSize = burst.size;
+    return job;
+}
+
+bool CaptureService::submitLocked(const Job& job) {
+    ++m_stats.requested;
+    if (m_stats.pending >= m_config.maxPendingEncodes) {
+        ++m_stats.dropped;
+        return false;
+    }
+    ++m_stats.pending;
+    TaskScheduler::instance().submit([this, job]() { encode(job); }, TaskPriority::Background);
+    return true;
+}
+
+void CaptureService::encode(const Job& job) {
+    CaptureRecord record = job.record;
+    QString error;
+
+    const bool jpeg = job.config.format == CaptureFormat::Jpeg;
+    const QImage image = job.frame.toImage();
+    QByteArray data;
+    if (image.isNull()) {
+        error = "Frame could not be converted";
+    } else {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, jpeg ? "JPEG" : "PNG", jpeg ? qBound(1, job.config.jpegQuality, 100) : -1)) {
+            error = "Encoding failed";
+        }
+    }
+
+    if (error.isEmpty()) {
+        const QString fileName = record.captureId + (jpeg ? ".jpg" : ".png");
+        if (job.storage) {
+            record.path = job.storage->writeCapture(record.cameraId, fileName, data);
+        } else {
+            const QDir dir(job.config.directory);
+            QFile file(dir.filePath(fileName));
+            if ((dir.exists() || dir.mkpath(".")) && file.open(QIODevice::WriteOnly) &&
+                file.write(data) == data.size()) {
+                record.path = file.fileName();
+            } else {
+                file.remove();
+            }
+        }
+        if (record.path.isEmpty()) {
+            error = "Write failed";
+        } else {
+            record.bytes = data.size();
+        }
+    }
+
+    QMetaObject::invokeMethod(this, [this, record, error]() { finish(record, error); }, Qt::QueuedConnection);
+
+    QMutexLocker locker(&m_mutex);
+    if (error.isEmpty()) {
+        ++m_stats.saved;
+    } else {
+        ++m_stats.failed;
+    }
+    --m_stats.pending;
+    m_idle.wakeAll();
+}
+
+void CaptureService::finish(const CaptureRecord& record, const QString& error) {
+    if (error.isEmpty()) {
+        const int index = m_records.size();
+        m_records.append(record);
+        m_byId.insert(record.captureId, index);
+        if (!record.tags.engagementId.isEmpty()) m_byEngagement[record.tags.engagementId].append(index);
+        if (!record.tags.trackId.isEmpty()) m_byTrack[record.tags.trackId].append(index);
+        if (!record.burstId.isEmpty()) m_byBurst[record.burstId].append(index);
+        emit captureSaved(record);
+    } else {
+        Logger::instance().warning("CaptureService", QString("Capture %1 failed: %2").arg(record.captureId, error));
+        emit captureFailed(record.captureId, error);
+    }
+
+    if (!record.burstId.isEmpty()) noteBurstFrame(record.burstId, error.isEmpty());
+}
+
+void CaptureService::noteBurstFrame(const QString& burstId, bool saved) {
+    auto it = m_bursts.find(burstId);
+    if (it == m_bursts.end()) return;
+    it->done++;
+    if (saved) it->saved++;
+    if (it->closed && it->done >= it->expected) {
+        const int count = it->saved;
+        m_bursts.erase(it);
+        emit burstCompleted(burstId, count);
+    }
+}
+
+void CaptureService::closeBurst(const QString& burstId, int taken) {
+    auto it = m_bursts.find(burstId);
+    if (it == m_bursts.end()) return;
+    it->expected = taken;
+    it->closed = true;
+    if (it->done >= it->expected) {
+        const int count = it->saved;
+        m_bursts.erase(it);
+        emit burstCompleted(burstId, count);
+    }
+}
+
+void CaptureService::checkBurstTimeouts() {
+    QVector<QPair<QString, int>> expired;
+    bool open = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        const qint64 now = m_clock.elapsed();
+        for (Camera& camera : m_cameras) {
+            for (int i = 0; i < camera.bursts.size();) {
+                const PendingBurst& burst = camera.bursts[i];
+                if (now - burst.lastFrameMs >= m_config.burstTimeoutMs) {
+                    expired.append(qMakePair(burst.burstId, burst.submitted));
+                    camera.bursts.remove(i);
+                } else {
+                    open = true;
+                    ++i;
+                }
+            }
+        }
+    }
+
+    for (const auto& burst : qAsConst(expired)) {
+        closeBurst(burst.first, burst.second);
+    }
+    if (!open) m_burstTimer->stop();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,217 @@
+#ifndef CAPTURESERVICE_H
+#define CAPTURESERVICE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+#include "utils/VideoFrame.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+class RecordingStorage;
+class VideoStreamManager;
+
+/**
+ * @brief Still image encoding
+ */
+enum class CaptureFormat {
+    Jpeg,
+    Png
+};
+
+/**
+ * @brief How stills are encoded and how bursts are taken
+ */
+struct CaptureConfig {
+    QString directory = "captures";     // Without a RecordingStorage
+    CaptureFormat format = CaptureFormat::Jpeg;
+    int jpegQuality = 90;
+    int burstFrames = 10;
+    int preRollFrames = 4;              // Of a burst, from before it was asked for
+    int burstTimeoutMs = 5000;          // A burst whose stream stalls ends short
+    int maxPendingEncodes = 64;         // Frames waiting for a worker; more are dropped
+};
+
+/**
+ * @brief What a capture is of, for the index
+ */
+struct CaptureTags {
+    QString engagementId;
+    QString trackId;
+    QString label;                      // "operator", "authorization", "execute", "bda"
+};
+
+/**
+ * @brief One still, once written
+ */
+struct CaptureRecord {
+    QString captureId;                  // Also the file's base name
+    QString burstId;                    // Empty for a single snapshot
+    int burstIndex = 0;
+    int burstSize = 1;
+    QString cameraId;
+    CaptureTags tags;
+    qint64 frameTimeMs = 0;             // UTC, when the frame arrived
+    QSize size;
+    QString path;
+    qint64 bytes = 0;
+};
+
+/**
+ * @brief Capture counters, safe to read from any thread
+ */
+struct CaptureStats {
+    quint64 requested = 0;              // Frames taken for a snapshot or a burst
+    quint64 saved = 0;
+    quint64 failed = 0;                 // Encode or write failures
+    quint64 dropped = 0;                // Over maxPendingEncodes
+    int pending = 0;                    // Waiting for or on a worker
+};
+
+/**
+ * @brief Operator snapshots and engagement bursts, encoded off the GUI thread
+ *
+ * Frames are taken by reference, as the streams deliver them: a capture
+ * holds the pooled VideoFrame, never a copy, until a Background task on
+ * the TaskScheduler has converted it to RGB, encoded it and written it,
+ * through the RecordingStorage when there is one. The caller only records
+ * the request, so nothing on the GUI thread waits on an encoder.
+ *
+ * A burst is taken around a moment: up to preRollFrames from before the
+ * request, for the pre-roll cameras, which keep that many recent frames;
+ * then the frames that follow, until burstFrames are taken or the stream
+ * has been quiet for burstTimeoutMs. Other cameras start from their latest
+ * frame, so only the cameras worth it hold a ring of pooled buffers.
+ *
+ * Written captures are indexed by engagement and by track, on the thread
+ * the service lives on, where captureSaved is emitted. addFrame() may be
+ * called from any thread.
+ */
+class CaptureService : public QObject {
+    Q_OBJECT
+
+public:
+    explicit CaptureService(QObject* parent = nullptr);
+    ~CaptureService() override;   // Waits for the encodes in flight
+
+    void setConfig(const CaptureConfig& config);
+    CaptureConfig config() const;
+
+    // Every stream's frames, connected directly on the streams' threads
+    void setVideoManager(VideoStreamManager* manager);
+    // Must outlive the service
+    void setStorage(RecordingStorage* storage);
+    void setPreRollCameras(const QStringList& cameraIds);
+
+    // Any thread, as the camera's frames arrive
+    void addFrame(const QString& cameraId, const VideoFrame& frame, qint64 timeMs);
+
+    // The camera's latest frame; returns the capture id, empty without one
+    QString snapshot(const QString& cameraId, const CaptureTags& tags = CaptureTags());
+    // A frame from elsewhere, such as a display's own copy
+    QString snapshot(const QString& cameraId, const VideoFrame& frame, const CaptureTags& tags = CaptureTags());
+    // On the service's thread. Returns the burst id, empty without a frame
+    // of the camera yet; frames <= 0 takes burstFrames
+    QString burst(const QString& cameraId, const CaptureTags& tags, int frames = 0);
+
+    // The index, oldest first
+    QVector<CaptureRecord> capturesForEngagement(const QString& engagementId) const;
+    QVector<CaptureRecord> capturesForTrack(const QString& trackId) const;
+    QVector<CaptureRecord> burstCaptures(const QString& burstId) const;
+    CaptureRecord capture(const QString& captureId) const;   // Empty captureId if unknown
+
+    CaptureStats stats() const;
+    void waitForEncoding() const;
+
+signals:
+    void captureSaved(const CaptureRecord& record);
+    void captureFailed(const QString& captureId, const QString& error);
+    // Every frame of the burst written or failed; saved may be short of its size
+    void burstCompleted(const QString& burstId, int saved);
+
+private:
+    struct TimedFrame {
+        VideoFrame frame;
+        qint64 timeMs = 0;
+    };
+
+    // Frames still to come, taken under m_mutex
+    struct PendingBurst {
+        QString burstId;
+        CaptureTags tags;
+        int size = 0;
+        int next = 0;                   // Index of the next frame taken
+        int submitted = 0;              // Of those, not dropped
+        qint64 lastFrameMs = 0;         // m_clock, for the timeout
+    };
+
+    struct Camera {
+        QVector<TimedFrame> recent;     // Pre-roll ring, oldest at head
+        int head = 0;
+        TimedFrame latest;
+        bool preRoll = false;
+        QVector<PendingBurst> bursts;
+    };
+
+    // Written on the service's thread only
+    struct BurstProgress {
+        int expected = 0;               // Frames taken; final once the burst is closed
+        int done = 0;
+        int saved = 0;
+        bool closed = false;
+    };
+
+    struct Job {
+        CaptureRecord record;
+        VideoFrame frame;
+        CaptureConfig config;
+        RecordingStorage* storage = nullptr;
+    };
+
+    QString nextId(const QString& cameraId, qint64 timeMs);
+    Job makeJob(const QString& captureId, const QString& cameraId, const CaptureTags& tags,
+                const TimedFrame& frame) const;
+    // The burst's next frame
+    Job burstJob(PendingBurst& burst, const QString& cameraId, const TimedFrame& frame) const;
+    // Under m_mutex: queues the frame for a worker, or drops it over the limit
+    bool submitLocked(const Job& job);
+    void encode(const Job& job);
+    void finish(const CaptureRecord& record, const QString& error);
+    void noteBurstFrame(const QString& burstId, bool saved);
+    void closeBurst(const QString& burstId, int taken);
+    void checkBurstTimeouts();
+
+    mutable QMutex m_mutex;
+    mutable QWaitCondition m_idle;
+    CaptureConfig m_config;
+    RecordingStorage* m_storage = nullptr;
+    QSet<QString> m_preRollCameras;
+    QHash<QString, Camera> m_cameras;
+    quint64 m_sequence = 0;
+    CaptureStats m_stats;
+    QElapsedTimer m_clock;
+
+    // Service thread
+    QVector<CaptureRecord> m_records;
+    QHash<QString, int> m_byId;
+    QHash<QString, QVector<int>> m_byEngagement;
+    QHash<QString, QVector<int>> m_byTrack;
+    QHash<QString, QVector<int>> m_byBurst;
+    QHash<QString, BurstProgress> m_bursts;
+    QTimer* m_burstTimer = nullptr;
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::CaptureRecord)
+
+#endif // CAPTURESERVICE_H
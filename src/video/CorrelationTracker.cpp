@@ -0,0 +1,268 @@
+#include "video/CorrelationTracker.h"
+#include <QtMath>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+// Half-width of the peak excluded from the sidelobe statistics
+constexpr int PEAK_EXCLUSION = 5;
+constexpr double MIN_WINDOW_SIDE = 16.0;
+
+int luma(const VideoFrame& frame, const uchar* bits, int stride, int x, int y) {
+    const uchar* line = bits + y * stride;
+    switch (frame.pixelFormat()) {
+    case VideoPixelFormat::RGB24: {
+        const uchar* p = line + 3 * x;
+        return (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8;
+    }
+    case VideoPixelFormat::RGB32:
+    case VideoPixelFormat::ARGB32: {
+        const quint32 word = reinterpret_cast<const quint32*>(line)[x];
+        return (77 * ((word >> 16) & 0xff) + 150 * ((word >> 8) & 0xff) + 29 * (word & 0xff)) >> 8;
+    }
+    default:
+        return line[x];    // YUV: the luma plane itself
+    }
+}
+
+} // namespace
+
+CorrelationTracker::CorrelationTracker(const CorrelationTrackerConfig& config)
+    : m_config(config)
+{
+    m_n = 16;
+    while (m_n < qBound(16, m_config.patchSize, 256)) m_n <<= 1;
+    m_config.patchSize = m_n;
+    const int n = m_n;
+
+    m_taper.resize(n);
+    for (int i = 0; i < n; ++i) {
+        m_taper[i] = float(0.5 * (1.0 - std::cos(2.0 * M_PI * (i + 0.5) / n)));
+    }
+    m_twiddles.resize(n / 2);
+    for (int k = 0; k < n / 2; ++k) {
+        m_twiddles[k] = std::polar(1.0f, float(-2.0 * M_PI * k / n));
+    }
+    int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    m_bitReverse.resize(n);
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        m_bitReverse[i] = r;
+    }
+
+    // A Gaussian peak at the window's centre
+    m_goal.resize(n * n);
+    const double c = n / 2;
+    const double s2 = 2.0 * m_config.sigma * m_config.sigma;
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            m_goal[y * n + x] = float(std::exp(-((x - c) * (x - c) + (y - c) * (y - c)) / s2));
+        }
+    }
+    fft(m_goal, false);
+}
+
+bool CorrelationTracker::init(const VideoFrame& frame, const QRectF& box) {
+    reset();
+    if (frame.isNull() || box.isEmpty()) return false;
+
+    m_boxSize = box.size();
+    m_centre = box.center();
+    m_windowSide = qMax(MIN_WINDOW_SIDE, qMax(box.width(), box.height()) * m_config.padding);
+
+    QVector<Complex> spectrum;
+    if (!sample(frame, m_centre, spectrum)) return false;
+    learn(spectrum, 1.0);
+    m_initialized = true;
+    return true;
+}
+
+bool CorrelationTracker::update(const VideoFrame& frame, const QRectF& predicted, QRectF& box) {
+    if (!m_initialized || frame.isNull()) return false;
+    const int n = m_n;
+
+    const QPointF searchCentre = predicted.isEmpty() ? m_centre : predicted.center();
+    QVector<Complex> response;
+    if (!sample(frame, searchCentre, response)) return false;
+    for (int i = 0; i < n * n; ++i) {
+        const Complex z = response[i];
+        const Complex h = m_numerator[i];
+        const float d = m_denominator[i];
+        response[i] = Complex((z.real() * h.real() - z.imag() * h.imag()) / d,
+                              (z.real() * h.imag() + z.imag() * h.real()) / d);
+    }
+    fft(response, true);
+
+    int peak = 0;
+    for (int i = 1; i < n * n; ++i) {
+        if (response[i].real() > response[peak].real()) peak = i;
+    }
+    const int px = peak % n;
+    const int py = peak / n;
+
+    // Peak against the rest of the response
+    double sum = 0.0, sumSq = 0.0;
+    int count = 0;
+    for (int y = 0; y < n; ++y) {
+        const int dy = qAbs(y - py);
+        for (int x = 0; x < n; ++x) {
+            if (dy <= PEAK_EXCLUSION && qAbs(x - px) <= PEAK_EXCLUSION) continue;
+            const double v = response[y * n + x].real();
+            sum += v;
+            sumSq += v * v;
+            ++count;
+        }
+    }
+    const double mean = sum / count;
+    const double sd = std::sqrt(qMax(0.0, sumSq / count - mean * mean));
+    m_psr = (response[peak].real() - mean) / qMax(1e-9, sd);
+    if (m_psr < m_config.minPeakToSidelobe) return false;
+
+    // Sub-pixel peak from a parabola through its neighbours
+    auto at = [&](int x, int y) { return double(response[((y + n) % n) * n + (x + n) % n].real()); };
+    auto vertex = [](double left, double centre, double right) {
+        const double d = left - 2.0 * centre + right;
+        return d < 0.0 ? qBound(-0.5, 0.5 * (left - right) / d, 0.5) : 0.0;
+    };
+    const double fx = px + vertex(at(px - 1, py), at(px, py), at(px + 1, py));
+    const double fy = py + vertex(at(px, py - 1), at(px, py), at(px, py + 1));
+    const double scale = m_windowSide / n;
+    m_centre = searchCentre + QPointF((fx - n / 2) * scale, (fy - n / 2) * scale);
+
+    QVector<Complex> spectrum;
+    if (sample(frame, m_centre, spectrum)) learn(spectrum, m_config.learningRate);
+    box = this->box();
+    return true;
+}
+
+void CorrelationTracker::reset() {
+    m_initialized = false;
+    m_numerator.clear();
+    m_denominator.clear();
+    m_psr = 0.0;
+}
+
+QRectF CorrelationTracker::box() const {
+    if (!m_initialized) return QRectF();
+    return QRectF(m_centre.x() - m_boxSize.width() / 2.0, m_centre.y() - m_boxSize.height() / 2.0,
+                  m_boxSize.width(), m_boxSize.height());
+}
+
+bool CorrelationTracker::sample(const VideoFrame& frame, const QPointF& centre,
+                                QVector<Complex>& spectrum) const {
+    const int n = m_n;
+    const int w = frame.width();
+    const int h = frame.height();
+    const double half = m_windowSide / 2.0;
+    if (centre.x() + half < 0.0 || centre.y() + half < 0.0 || centre.x() - half > w ||
+        centre.y() - half > h) {
+        return false;
+    }
+
+    // Bilinear taps per column, clamped to the frame edge
+    const double scale = m_windowSide / n;
+    QVector<int> x0(n), x1(n);
+    QVector<float> xf(n);
+    for (int i = 0; i < n; ++i) {
+        const double sx = centre.x() + (i + 0.5 - n / 2) * scale - 0.5;
+        const int base = int(std::floor(sx));
+        xf[i] = float(sx - base);
+        x0[i] = qBound(0, base, w - 1);
+        x1[i] = qBound(0, base + 1, w - 1);
+    }
+
+    const uchar* bits = frame.constBits(0);
+    const int stride = frame.bytesPerLine(0);
+    spectrum.resize(n * n);
+    double sum = 0.0, sumSq = 0.0;
+    for (int j = 0; j < n; ++j) {
+        const double sy = centre.y() + (j + 0.5 - n / 2) * scale - 0.5;
+        const int base = int(std::floor(sy));
+        const float yf = float(sy - base);
+        const int y0 = qBound(0, base, h - 1);
+        const int y1 = qBound(0, base + 1, h - 1);
+        for (int i = 0; i < n; ++i) {
+            const float top = luma(frame, bits, stride, x0[i], y0) * (1.0f - xf[i]) +
+                              luma(frame, bits, stride, x1[i], y0) * xf[i];
+            const float bottom = luma(frame, bits, stride, x0[i], y1) * (1.0f - xf[i]) +
+                                 luma(frame, bits, stride, x1[i], y1) * xf[i];
+            // Log compresses the contrast between sky and a dark target
+            const float v = std::log1p(top * (1.0f - yf) + bottom * yf);
+            spectrum[j * n + i] = v;
+            sum += v;
+            sumSq += double(v) * v;
+        }
+    }
+
+    const double mean = sum / (n * n);
+    const double sd = std::sqrt(qMax(0.0, sumSq / (n * n) - mean * mean)) + 1e-5;
+    for (int j = 0; j < n; ++j) {
+        for (int i = 0; i < n; ++i) {
+            Complex& v = spectrum[j * n + i];
+            v = float((v.real() - mean) / sd) * m_taper[i] * m_taper[j];
+        }
+    }
+    fft(spectrum, false);
+    return true;
+}
+
+void CorrelationTracker::learn(const QVector<Complex>& spectrum, double rate) {
+    const int size = m_n * m_n;
+    double power = 0.0;
+    for (const Complex& f : spectrum) power += std::norm(f);
+    const float epsilon = float(m_config.regularization * power / size);
+
+    if (m_numerator.size() != size) {
+        m_numerator.fill(Complex(), size);
+        m_denominator.fill(0.0f, size);
+        rate = 1.0;
+    }
+    const float r = float(rate);
+    for (int i = 0; i < size; ++i) {
+        const Complex& f = spectrum[i];
+        const Complex& g = m_goal[i];
+        const Complex gf(g.real() * f.real() + g.imag() * f.imag(), g.imag() * f.real() - g.real() * f.imag());
+        m_numerator[i] = r * gf + (1.0f - r) * m_numerator[i];
+        m_denominator[i] = r * (std::norm(f) + epsilon) + (1.0f - r) * m_denominator[i];
+    }
+}
+
+void CorrelationTracker::fft(QVector<Complex>& data, bool inverse) const {
+    const int n = m_n;
+    for (int row = 0; row < n; ++row) fftLine(data.data() + row * n, 1, inverse);
+    for (int column = 0; column < n; ++column) fftLine(data.data() + column, n, inverse);
+    if (inverse) {
+        const float norm = 1.0f / (n * n);
+        for (Complex& v : data) v *= norm;
+    }
+}
+
+void CorrelationTracker::fftLine(Complex* data, int stride, bool inverse) const {
+    const int n = m_n;
+    for (int i = 0; i < n; ++i) {
+        const int j = m_bitReverse[i];
+        if (i < j) std::swap(data[i * stride], data[j * stride]);
+    }
+    for (int length = 2; length <= n; length <<= 1) {
+        const int half = length / 2;
+        const int step = n / length;
+        for (int start = 0; start < n; start += length) {
+            for (int k = 0; k < half; ++k) {
+                const Complex w = inverse ? std::conj(m_twiddles[k * step]) : m_twiddles[k * step];
+                Complex& a = data[(start + k) * stride];
+                Complex& b = data[(start + k + half) * stride];
+                // Written out: std::complex's operator* checks for infinities
+                const Complex t(b.real() * w.real() - b.imag() * w.imag(),
+                                b.real() * w.imag() + b.imag() * w.real());
+                b = a - t;
+                a += t;
+            }
+        }
+    }
+}
+
+} // namespace CounterUAS
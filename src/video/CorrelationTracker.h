@@ -0,0 +1,81 @@
+#ifndef CORRELATIONTRACKER_H
+#define CORRELATIONTRACKER_H
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include <complex>
+
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Window and adaptation of a correlation tracker
+ */
+struct CorrelationTrackerConfig {
+    int patchSize = 32;             // Power of two; the search window is resampled to this
+    double padding = 2.5;           // Search window side over the box's longer side
+    double learningRate = 0.125;    // Weight of each new frame in the filter
+    double sigma = 2.0;             // Width of the desired peak, patch pixels
+    double regularization = 0.01;
+    double minPeakToSidelobe = 6.0; // Below this the target is lost
+};
+
+/**
+ * @brief Single-target correlation filter tracker (MOSSE) on the luma of a frame
+ *
+ * Learns a filter whose correlation with a square window around the target
+ * peaks at the target's centre, and adapts it every frame. update()
+ * searches a window centred on a predicted box, so a camera slewing under
+ * the target does not carry it out of the window. The box keeps the size
+ * it was initialised with; a detector run re-initialises it.
+ *
+ * Correlation runs in the frequency domain on a patchSize square whatever
+ * the box size: three 2-D FFTs per update.
+ */
+class CorrelationTracker {
+public:
+    explicit CorrelationTracker(const CorrelationTrackerConfig& config = CorrelationTrackerConfig());
+
+    // Box in frame pixels; false when it does not overlap the frame
+    bool init(const VideoFrame& frame, const QRectF& box);
+    // False when the response is too weak to trust; box and filter are
+    // then left as they were
+    bool update(const VideoFrame& frame, const QRectF& predicted, QRectF& box);
+    void reset();
+
+    bool isInitialized() const { return m_initialized; }
+    QRectF box() const;
+    double peakToSidelobe() const { return m_psr; }
+    CorrelationTrackerConfig config() const { return m_config; }
+
+private:
+    using Complex = std::complex<float>;
+
+    // Window of m_windowSide frame pixels around centre, as a normalised,
+    // tapered patch in the frequency domain
+    bool sample(const VideoFrame& frame, const QPointF& centre, QVector<Complex>& spectrum) const;
+    void fft(QVector<Complex>& data, bool inverse) const;
+    void fftLine(Complex* data, int stride, bool inverse) const;
+    void learn(const QVector<Complex>& spectrum, double rate);
+
+    CorrelationTrackerConfig m_config;
+    int m_n = 64;
+    QVector<float> m_taper;         // Hann window, one axis
+    QVector<Complex> m_twiddles;    // exp(-2 pi i k / n), k < n / 2
+    QVector<int> m_bitReverse;
+    QVector<Complex> m_goal;        // Spectrum of the desired response
+    QVector<Complex> m_numerator;
+    QVector<float> m_denominator;
+
+    bool m_initialized = false;
+    QPointF m_centre;
+    QSizeF m_boxSize;
+    double m_windowSide = 0.0;
+    double m_psr = 0.0;
+};
+
+} // namespace CounterUAS
+
+#endif // CORRELATIONTRACKER_H
@@ -1,6 +1,9 @@
 #include "video/FileVideoSource.h"
+#include "video/MatroskaReader.h"
 #include "video/RTSPVideoSource.h"  // For VideoFrameGrabber in Qt5
+#include "video/VideoDecoder.h"
 #include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QMediaContent>
@@ -35,7 +38,7 @@ FileVideoSource::FileVideoSource(const QString& sourceId, QObject* parent)
     QObject::connect(m_player, &QMediaPlayer::durationChanged,
             this, &FileVideoSource::onDurationChanged);
     
-    QObject::connect(m_frameTimer, &QTimer::timeout, this, &FileVideoSource::processFrame);
+    m_frameTimer.setCallback([this]() { processFrame(); });
 }
 
 FileVideoSource::~FileVideoSource() {
@@ -51,6 +54,19 @@ bool FileVideoSource::open(const QUrl& url) {
     
     setStatus(VideoSourceStatus::Connecting);
     
+    if (openIndexed(url.toLocalFile())) {
+        m_isOpen = true;
+        setStatus(VideoSourceStatus::Connected);
+        Logger::instance().info("FileVideoSource",
+                               QString("%1 replaying %2: %3 frames, %4 keyframes, index %5")
+                                   .arg(m_sourceId)
+                                   .arg(url.toLocalFile())
+                                   .arg(m_reader->packetCount())
+                                   .arg(m_reader->keyframeCount())
+                                   .arg(m_reader->indexFromSidecar() ? "from sidecar" : "built"));
+        return true;
+    }
+    
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     m_player->setSource(url);
 #else
@@ -70,6 +86,7 @@ void FileVideoSource::close() {
     if (!m_isOpen) return;
     
     stop();
+    closeIndexed();
     m_player->stop();
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     m_player->setSource(QUrl());
@@ -87,39 +104,281 @@ bool FileVideoSource::isOpen() const {
     return m_isOpen;
 }
 
+bool FileVideoSource::openIndexed(const QString& path) {
+    if (path.isEmpty()) return false;
+    
+    // Anything the reader or the decoders cannot take goes to QMediaPlayer
+    auto reader = std::make_unique<MatroskaReader>();
+    if (!reader->open(path) || reader->packetCount() == 0) return false;
+    
+    auto decoder = std::make_unique<VideoDecoder>();
+    const QString codec = MatroskaReader::decoderCodec(reader->codecId());
+    if (!decoder->initialize(codec)) {
+        Logger::instance().warning("FileVideoSource",
+                                  QString("%1: no decoder for %2, using the media player")
+                                      .arg(m_sourceId, codec));
+        return false;
+    }
+    
+    m_reader = std::move(reader);
+    m_replayDecoder = std::move(decoder);
+    m_duration = m_reader->durationMs();
+    m_stats.width = m_reader->frameSize().width();
+    m_stats.height = m_reader->frameSize().height();
+    if (m_reader->fps() > 0.0) setTargetFPS(m_reader->fps());
+    
+    {
+        QMutexLocker locker(&m_replayMutex);
+        m_decoded.clear();
+        m_nextPacket = m_reader->keyframeAtOrBefore(0);
+        ++m_replayGeneration;
+        m_scrubbing = m_playbackSpeed >= SCRUB_SPEED;
+        m_scrubStepMs = static_cast<qint64>(m_playbackSpeed * 1000.0 / m_targetFPS);
+        m_replayStopping = false;
+    }
+    m_clock.invalidate();
+    m_clockAnchorMs = 0;
+    m_replayPositionMs = 0;
+    
+    m_decodeThread = QThread::create([this]() { decodeAheadLoop(); });
+    ThreadPlacement::instance().assign(m_decodeThread, ThreadRole::VideoDecode);
+    m_decodeThread->start();
+    return true;
+}
+
+void FileVideoSource::closeIndexed() {
+    if (!m_reader) return;
+    
+    {
+        QMutexLocker locker(&m_replayMutex);
+        m_replayStopping = true;
+        m_replayWake.wakeAll();
+    }
+    m_decodeThread->wait();
+    delete m_decodeThread;
+    m_decodeThread = nullptr;
+    
+    m_replayDecoder->shutdown();
+    m_replayDecoder.reset();
+    m_reader.reset();
+    
+    QMutexLocker locker(&m_replayMutex);
+    m_decoded.clear();
+}
+
+void FileVideoSource::decodeAheadLoop() {
+    QByteArray packet;
+    forever {
+        int index = 0;
+        quint64 generation = 0;
+        {
+            QMutexLocker locker(&m_replayMutex);
+            m_decoding = false;
+            while (!m_replayStopping && (m_decoded.size() >= m_decodeAhead ||
+                                         m_nextPacket >= m_reader->packetCount())) {
+                m_replayWake.wait(&m_replayMutex);
+            }
+            if (m_replayStopping) break;
+            
+            index = m_nextPacket;
+            generation = m_replayGeneration;
+            m_decoding = true;
+            // Scrubbing skips to the next keyframe a shown frame's worth on
+            m_nextPacket = m_scrubbing
+                ? m_reader->keyframeAfter(index, m_reader->index()[index].timeMs + m_scrubStepMs)
+                : index + 1;
+        }
+        
+        QImage image;
+        if (m_reader->readPacket(index, packet)) {
+            image = m_replayDecoder->decode(packet);
+        }
+        
+        QMutexLocker locker(&m_replayMutex);
+        // A seek since makes this frame stale; a null one is still buffering
+        if (generation != m_replayGeneration || image.isNull()) continue;
+        m_decoded.enqueue({VideoFrame(image), m_reader->index()[index].timeMs});
+    }
+}
+
+void FileVideoSource::start() {
+    VideoSource::start();
+    if (!m_reader || !m_streaming) return;
+    
+    // Starting again after the end replays from the top
+    if (m_replayPositionMs >= m_duration && bufferedFrames() == 0) {
+        seekIndexed(0);
+    }
+    runClock(true);
+}
+
+void FileVideoSource::stop() {
+    VideoSource::stop();
+    if (m_reader) runClock(false);
+}
+
+void FileVideoSource::pause() {
+    VideoSource::pause();
+    if (m_reader) runClock(false);
+}
+
+void FileVideoSource::resume() {
+    const bool paused = m_status == VideoSourceStatus::Paused;
+    VideoSource::resume();
+    if (m_reader && paused) runClock(true);
+}
+
+qint64 FileVideoSource::replayClockMs() const {
+    if (!m_clock.isValid()) return m_clockAnchorMs;
+    return m_clockAnchorMs + static_cast<qint64>(m_clock.elapsed() * m_playbackSpeed);
+}
+
+void FileVideoSource::runClock(bool running) {
+    m_clockAnchorMs = replayClockMs();
+    if (running) {
+        m_clock.start();
+    } else {
+        m_clock.invalidate();
+    }
+}
+
 void FileVideoSource::setPlaybackSpeed(double speed) {
+    const qint64 now = replayClockMs();
     m_playbackSpeed = qBound(0.1, speed, 10.0);
-    m_player->setPlaybackRate(m_playbackSpeed);
+    if (!m_reader) {
+        m_player->setPlaybackRate(m_playbackSpeed);
+        return;
+    }
+    
+    // The clock carries on from where it is at the new rate
+    m_clockAnchorMs = now;
+    if (m_clock.isValid()) m_clock.start();
+    
+    const bool scrubbing = m_playbackSpeed >= SCRUB_SPEED;
+    bool changed = false;
+    {
+        QMutexLocker locker(&m_replayMutex);
+        changed = scrubbing != m_scrubbing;
+        m_scrubbing = scrubbing;
+        m_scrubStepMs = static_cast<qint64>(m_playbackSpeed * 1000.0 / m_targetFPS);
+    }
+    // Between keyframe-only and full decoding the queue holds the wrong
+    // frames, and normal decoding has to start on a keyframe
+    if (changed) seekIndexed(now);
 }
 
 void FileVideoSource::seek(qint64 positionMs) {
-    m_player->setPosition(positionMs);
+    if (m_reader) {
+        seekIndexed(positionMs);
+    } else {
+        m_player->setPosition(positionMs);
+    }
+}
+
+void FileVideoSource::seekIndexed(qint64 positionMs) {
+    positionMs = qBound<qint64>(0, positionMs, m_duration);
+    {
+        QMutexLocker locker(&m_replayMutex);
+        m_decoded.clear();
+        m_nextPacket = m_reader->keyframeAtOrBefore(positionMs);
+        ++m_replayGeneration;
+        m_replayWake.wakeAll();
+    }
+    // Frames between the keyframe and the target decode but are never due
+    m_clockAnchorMs = positionMs;
+    if (m_clock.isValid()) m_clock.start();
+    m_replayPositionMs = positionMs;
 }
 
 qint64 FileVideoSource::position() const {
-    return m_player->position();
+    return m_reader ? m_replayPositionMs : m_player->position();
 }
 
 qint64 FileVideoSource::duration() const {
     return m_duration;
 }
 
+void FileVideoSource::setDecodeAhead(int frames) {
+    QMutexLocker locker(&m_replayMutex);
+    m_decodeAhead = qMax(1, frames);
+    m_replayWake.wakeAll();
+}
+
+int FileVideoSource::decodeAhead() const {
+    QMutexLocker locker(&m_replayMutex);
+    return m_decodeAhead;
+}
+
+int FileVideoSource::bufferedFrames() const {
+    QMutexLocker locker(&m_replayMutex);
+    return m_decoded.size();
+}
+
+qint64 FileVideoSource::recordingStartUtcMs() const {
+    return m_reader ? m_reader->startTimeUtcMs() : 0;
+}
+
+void FileVideoSource::seekToUtc(qint64 utcMs) {
+    const qint64 start = recordingStartUtcMs();
+    if (start > 0) seek(utcMs - start);
+}
+
 void FileVideoSource::processFrame() {
-    // Frame processing handled by onVideoFrameChanged/onFrameAvailable
+    // QMediaPlayer frames arrive through onVideoFrameChanged/onFrameAvailable;
+    // indexed replay is paced here, its decoding done ahead on its own thread
+    if (!m_reader) return;
+    
+    const qint64 clock = replayClockMs();
+    ReplayFrame due;
+    bool haveFrame = false;
+    bool finished = false;
+    {
+        QMutexLocker locker(&m_replayMutex);
+        // Only the newest due frame is shown; the others are already late
+        while (!m_decoded.isEmpty() && m_decoded.head().timeMs <= clock) {
+            due = m_decoded.dequeue();
+            haveFrame = true;
+        }
+        if (haveFrame) m_replayWake.wakeOne();
+        finished = m_decoded.isEmpty() && !m_decoding &&
+                   m_nextPacket >= m_reader->packetCount() && clock >= m_duration;
+    }
+    
+    if (haveFrame) {
+        m_replayPositionMs = due.timeMs;
+        emitFrame(due.frame);
+        emit positionChanged(due.timeMs);
+        if (m_reader->startTimeUtcMs() > 0) {
+            emit replayTimeChanged(m_reader->startTimeUtcMs() + due.timeMs);
+        }
+    }
+    
+    if (finished) {
+        if (m_looping) {
+            seekIndexed(0);
+        } else {
+            m_replayPositionMs = m_duration;
+            stop();
+        }
+    }
 }
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 void FileVideoSource::onVideoFrameChanged(const QVideoFrame& frame) {
     if (!frame.isValid()) return;
     
+    // Planar YUV stays YUV; anything else is converted to RGB here
     QVideoFrame f = frame;
     f.map(QVideoFrame::ReadOnly);
     
-    QImage image = f.toImage();
+    VideoFrame planar = planarFrameFromMapped(f, &m_framePool);
+    QImage image = planar.isNull() ? f.toImage() : QImage();
     
     f.unmap();
     
-    if (!image.isNull()) {
+    if (!planar.isNull()) {
+        emitFrame(planar);
+    } else if (!image.isNull()) {
         emitFrame(image);
     }
 }
@@ -129,16 +388,25 @@ void FileVideoSource::onFrameAvailable(const QVideoFrame& frame) {
     
     QVideoFrame f = frame;
     if (f.map(QAbstractVideoBuffer::ReadOnly)) {
-        QImage image(f.bits(),
-                     f.width(),
-                     f.height(),
-                     f.bytesPerLine(),
-                     QVideoFrame::imageFormatFromPixelFormat(f.pixelFormat()));
+        // The mapping goes away with unmap(), so this is the one copy the
+        // frame gets; it lands in a recycled buffer, planar YUV as it is
+        VideoFrame planar = planarFrameFromMapped(f, &m_framePool);
+        if (!planar.isNull()) {
+            f.unmap();
+            emitFrame(planar);
+            return;
+        }
+        
+        QImage image = m_framePool.acquireCopy(f.bits(),
+                                               f.width(),
+                                               f.height(),
+                                               f.bytesPerLine(),
+                                               QVideoFrame::imageFormatFromPixelFormat(f.pixelFormat()));
+        f.unmap();
         
         if (!image.isNull()) {
-            emitFrame(image.copy());  // copy() because original data will be unmapped
+            emitFrame(image);
         }
-        f.unmap();
     }
 }
 #endif
@@ -2,8 +2,14 @@
 #define FILEVIDEOSOURCE_H
 
 #include "video/VideoSource.h"
+#include <QElapsedTimer>
 #include <QMediaPlayer>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
 #include <QtGlobal>
+#include <memory>
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
 #include <QVideoSink>
@@ -15,6 +21,9 @@
 
 namespace CounterUAS {
 
+class MatroskaReader;
+class VideoDecoder;
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 // Forward declaration - use the same VideoFrameGrabber from RTSPVideoSource
 class VideoFrameGrabber;
@@ -22,6 +31,18 @@ class VideoFrameGrabber;
 
 /**
  * @brief File-based video source for simulation and replay
+ *
+ * Matroska files, recordings included, replay through a packet index
+ * (MatroskaReader, kept in a sidecar next to the file) and a VideoDecoder:
+ * a decode-ahead thread fills a bounded queue from the index, and the frame
+ * timer only shows the newest frame due on the replay clock. Seeks start
+ * decoding from the keyframe at or before the target. At SCRUB_SPEED and
+ * above only keyframes are decoded, no closer together than one shown
+ * frame's worth of media, so fast replay costs no more than normal replay.
+ *
+ * Replay reports each shown frame's position, and its wall-clock time when
+ * the recording has one, so track replay from DatabaseManager can follow.
+ * Other files, or codecs no backend decodes, play through QMediaPlayer.
  */
 class FileVideoSource : public VideoSource {
     Q_OBJECT
@@ -30,6 +51,9 @@ public:
     explicit FileVideoSource(const QString& sourceId, QObject* parent = nullptr);
     ~FileVideoSource() override;
     
+    static constexpr double SCRUB_SPEED = 2.0;      // Keyframes only at and above
+    static constexpr int DEFAULT_DECODE_AHEAD = 8;  // Frames
+    
     QString sourceType() const override { return "FILE"; }
     
     // VideoSource implementation
@@ -37,6 +61,11 @@ public:
     void close() override;
     bool isOpen() const override;
     
+    void start() override;
+    void stop() override;
+    void pause() override;
+    void resume() override;
+    
     // Playback control
     void setLooping(bool loop) { m_looping = loop; }
     bool isLooping() const { return m_looping; }
@@ -48,6 +77,23 @@ public:
     qint64 position() const;
     qint64 duration() const;
     
+    // Indexed replay; false when QMediaPlayer plays the file
+    bool isIndexed() const { return m_reader != nullptr; }
+    bool isScrubbing() const { return isIndexed() && m_playbackSpeed >= SCRUB_SPEED; }
+    
+    void setDecodeAhead(int frames);
+    int decodeAhead() const;
+    int bufferedFrames() const;
+    
+    // Wall clock at the recording's time zero, ms since the epoch; 0 if unknown
+    qint64 recordingStartUtcMs() const;
+    void seekToUtc(qint64 utcMs);
+    
+signals:
+    void positionChanged(qint64 positionMs);
+    // Wall-clock time of the frame just shown, for recordings that have one
+    void replayTimeChanged(qint64 utcMs);
+    
 protected slots:
     void processFrame() override;
     
@@ -62,6 +108,18 @@ private slots:
     void onDurationChanged(qint64 duration);
     
 private:
+    struct ReplayFrame {
+        VideoFrame frame;
+        qint64 timeMs = 0;
+    };
+    
+    bool openIndexed(const QString& path);
+    void closeIndexed();
+    void decodeAheadLoop();
+    void seekIndexed(qint64 positionMs);
+    qint64 replayClockMs() const;
+    void runClock(bool running);
+    
     QMediaPlayer* m_player;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     QVideoSink* m_videoSink;
@@ -73,6 +131,29 @@ private:
     bool m_looping = true;
     double m_playbackSpeed = 1.0;
     qint64 m_duration = 0;
+    
+    // Indexed replay. The reader and decoder belong to the decode-ahead
+    // thread once it runs; the index itself is read-only.
+    std::unique_ptr<MatroskaReader> m_reader;
+    std::unique_ptr<VideoDecoder> m_replayDecoder;
+    QThread* m_decodeThread = nullptr;
+    
+    mutable QMutex m_replayMutex;
+    QWaitCondition m_replayWake;
+    QQueue<ReplayFrame> m_decoded;
+    int m_nextPacket = 0;
+    quint64 m_replayGeneration = 0;    // Bumped by seeks; older decodes are dropped
+    bool m_decoding = false;
+    bool m_scrubbing = false;
+    qint64 m_scrubStepMs = 0;
+    int m_decodeAhead = DEFAULT_DECODE_AHEAD;
+    bool m_replayStopping = false;
+    
+    // Replay clock, GUI thread only: media time is the anchor plus the
+    // elapsed wall time scaled by the speed while it runs
+    QElapsedTimer m_clock;
+    qint64 m_clockAnchorMs = 0;
+    qint64 m_replayPositionMs = 0;
 };
 
 } // namespace CounterUAS
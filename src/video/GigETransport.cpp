@@ -0,0 +1,255 @@
+#include "video/GigETransport.h"
+#include "utils/TimeUtils.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+struct Registration {
+    QString name;
+    int priority = 0;
+    GigETransportRegistry::Factory factory;
+};
+
+QMutex& registryMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+QVector<Registration>& registrations() {
+    static QVector<Registration> list = {
+        {QStringLiteral("simulated"), 0,
+         []() { return std::unique_ptr<GigETransport>(new SimulatedGigETransport); }},
+    };
+    return list;
+}
+
+} // namespace
+
+void GigETransportRegistry::registerTransport(const QString& name, int priority, Factory factory) {
+    if (name.isEmpty() || !factory) return;
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    auto it = std::find_if(list.begin(), list.end(),
+                           [&](const Registration& r) { return r.name == name; });
+    if (it != list.end()) list.erase(it);
+
+    Registration reg;
+    reg.name = name;
+    reg.priority = priority;
+    reg.factory = std::move(factory);
+    // Stable: among equal priorities the earlier registration wins
+    auto pos = std::find_if(list.begin(), list.end(),
+                            [&](const Registration& r) { return r.priority < priority; });
+    list.insert(pos, reg);
+}
+
+void GigETransportRegistry::unregisterTransport(const QString& name) {
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [&](const Registration& r) { return r.name == name; }),
+               list.end());
+}
+
+QStringList GigETransportRegistry::candidates() {
+    QMutexLocker locker(&registryMutex());
+    QStringList names;
+    for (const Registration& reg : registrations()) names.append(reg.name);
+    return names;
+}
+
+std::unique_ptr<GigETransport> GigETransportRegistry::create(const QString& name) {
+    Factory factory;
+    {
+        QMutexLocker locker(&registryMutex());
+        for (const Registration& reg : registrations()) {
+            if (reg.name == name) {
+                factory = reg.factory;
+                break;
+            }
+        }
+    }
+    return factory ? factory() : nullptr;
+}
+
+QStringList SimulatedGigETransport::devices() const {
+    return QStringList() << "GigE-Camera-001" << "GigE-Camera-002";
+}
+
+bool SimulatedGigETransport::open(const QString& deviceId) {
+    Q_UNUSED(deviceId)    // Any ID opens
+    return true;
+}
+
+void SimulatedGigETransport::close() {
+    stopAcquisition();
+    revokeBuffers();
+}
+
+int SimulatedGigETransport::negotiatePacketSize(int requested) {
+    // A camera steps GevSCPSPacketSize down until a test packet with the
+    // don't-fragment bit set gets through; here the path MTU is known
+    const int size = qMin(requested, m_pathMtu) & ~3;
+    if (size <= GVSP_OVERHEAD) return 0;
+    m_packetSize = size;
+    return size;
+}
+
+bool SimulatedGigETransport::setFeature(const QString& name, const QVariant& value) {
+    QMutexLocker locker(&m_mutex);
+    if (name == "AcquisitionFrameRate") {
+        m_frameRate = qBound(1.0, value.toDouble(), 1000.0);
+    } else if (name == "PixelFormat") {
+        if (m_acquiring) return false;
+        const QString format = value.toString();
+        if (format == "Mono8") m_bytesPerPixel = 1;
+        else if (format == "RGB8") m_bytesPerPixel = 3;
+        else if (format == "Mono16") m_bytesPerPixel = 2;
+        else return false;
+    } else if (name == "Width" || name == "Height") {
+        if (m_acquiring || value.toInt() <= 0) return false;
+        if (name == "Width") m_size.setWidth(value.toInt());
+        else m_size.setHeight(value.toInt());
+    } else if (name != "ExposureTime" && name != "Gain"
+               && name != "ExposureAuto" && name != "GainAuto") {
+        return false;
+    }
+    return true;
+}
+
+int SimulatedGigETransport::payloadSize() const {
+    return m_size.width() * m_size.height() * m_bytesPerPixel;
+}
+
+void SimulatedGigETransport::setPacketLoss(double rate, double resendRecovery) {
+    m_lossRate = qBound(0.0, rate, 1.0);
+    m_resendRecovery = qBound(0.0, resendRecovery, 1.0);
+}
+
+bool SimulatedGigETransport::announceBuffer(GigEBuffer* buffer) {
+    if (!buffer) return false;
+    QMutexLocker locker(&m_mutex);
+    if (m_acquiring) return false;
+    m_announced.append(buffer);
+    return true;
+}
+
+void SimulatedGigETransport::revokeBuffers() {
+    QMutexLocker locker(&m_mutex);
+    m_queue.clear();
+    m_announced.clear();
+}
+
+bool SimulatedGigETransport::startAcquisition() {
+    QMutexLocker locker(&m_mutex);
+    if (m_announced.isEmpty()) return false;
+    m_acquiring = true;
+    m_interrupted = false;
+    m_nextFrameNs = TimeUtils::monotonicNs();
+    return true;
+}
+
+void SimulatedGigETransport::stopAcquisition() {
+    QMutexLocker locker(&m_mutex);
+    m_acquiring = false;
+    m_queue.clear();
+    m_wake.wakeAll();
+}
+
+bool SimulatedGigETransport::queueBuffer(GigEBuffer* buffer) {
+    QMutexLocker locker(&m_mutex);
+    if (!buffer || !m_announced.contains(buffer) || !buffer->data
+        || buffer->capacity < payloadSize()) {
+        return false;
+    }
+    m_queue.enqueue(buffer);
+    return true;
+}
+
+GigEBuffer* SimulatedGigETransport::waitBuffer(int timeoutMs) {
+    QMutexLocker locker(&m_mutex);
+    const qint64 deadline = TimeUtils::monotonicNs() + qint64(qMax(0, timeoutMs)) * 1000000;
+
+    forever {
+        if (m_interrupted) {
+            m_interrupted = false;
+            return nullptr;
+        }
+        const qint64 now = TimeUtils::monotonicNs();
+        const qint64 periodNs = static_cast<qint64>(1e9 / m_frameRate);
+        if (m_acquiring) {
+            // Frames that found no queued buffer are lost whole
+            while (m_queue.isEmpty() && now >= m_nextFrameNs) {
+                ++m_blockId;
+                m_nextFrameNs += periodNs;
+            }
+            if (!m_queue.isEmpty() && now >= m_nextFrameNs) {
+                GigEBuffer* buffer = m_queue.dequeue();
+                buffer->blockId = ++m_blockId;
+                buffer->timestampNs = m_nextFrameNs;
+                m_nextFrameNs = qMax(m_nextFrameNs + periodNs, now - periodNs);
+                locker.unlock();
+                fill(buffer);
+                return buffer;
+            }
+        }
+        if (now >= deadline) return nullptr;
+
+        qint64 waitNs = deadline - now;
+        if (m_acquiring && !m_queue.isEmpty()) waitNs = qMin(waitNs, m_nextFrameNs - now);
+        m_wake.wait(&m_mutex, static_cast<unsigned long>(qMax<qint64>(1, waitNs / 1000000)));
+    }
+}
+
+void SimulatedGigETransport::interrupt() {
+    QMutexLocker locker(&m_mutex);
+    m_interrupted = true;
+    m_wake.wakeAll();
+}
+
+void SimulatedGigETransport::fill(GigEBuffer* buffer) {
+    // Only the capture thread gets here, with the buffer out of the queue
+    const int rowBytes = m_size.width() * m_bytesPerPixel;
+    const int payload = payloadSize();
+    const int shift = static_cast<int>(buffer->blockId * 4);
+    if (m_bytesPerPixel == 2) {
+        // 14-bit counts: a warm, slowly moving vertical gradient
+        quint16* samples = reinterpret_cast<quint16*>(buffer->data);
+        for (int y = 0; y < m_size.height(); ++y) {
+            std::fill_n(samples + y * m_size.width(), m_size.width(),
+                        quint16(6000 + ((y + shift) & 0x3ff) * 2));
+        }
+    } else {
+        for (int y = 0; y < m_size.height(); ++y) {
+            std::memset(buffer->data + y * rowBytes, (y + shift) & 0xff, rowBytes);
+        }
+    }
+
+    const int perPacket = m_packetSize - GVSP_OVERHEAD;
+    buffer->payloadSize = payload;
+    buffer->packetsExpected = (payload + perPacket - 1) / perPacket;
+    buffer->packetsResent = 0;
+    buffer->packetsMissing = 0;
+    if (m_lossRate > 0.0) {
+        const quint32 lossThreshold = static_cast<quint32>(m_lossRate * 4294967295.0);
+        const quint32 recoverThreshold = static_cast<quint32>(m_resendRecovery * 4294967295.0);
+        for (int i = 0; i < buffer->packetsExpected; ++i) {
+            m_rng ^= m_rng << 13;
+            m_rng ^= m_rng >> 17;
+            m_rng ^= m_rng << 5;
+            if (m_rng >= lossThreshold) continue;
+            m_rng ^= m_rng << 13;
+            m_rng ^= m_rng >> 17;
+            m_rng ^= m_rng << 5;
+            if (m_rng < recoverThreshold) ++buffer->packetsResent;
+            else ++buffer->packetsMissing;
+        }
+    }
+    buffer->complete = buffer->packetsMissing == 0;
+}
+
+} // namespace CounterUAS
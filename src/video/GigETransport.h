@@ -0,0 +1,162 @@
+#ifndef GIGETRANSPORT_H
+#define GIGETRANSPORT_H
+
+#include <QMutex>
+#include <QQueue>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
+
+namespace CounterUAS {
+
+/**
+ * @brief One user-allocated acquisition buffer handed to a GigE transport
+ *
+ * The source owns the memory. data is read when the buffer is queued, so
+ * a slot may point at a fresh frame each time round. The payload lands as
+ * packed rows; the transport fills in the rest when it hands it back.
+ */
+struct GigEBuffer {
+    int slot = -1;                 // Position in the announced set
+    uchar* data = nullptr;
+    int capacity = 0;              // Bytes
+
+    // Completion, filled by the transport
+    quint64 blockId = 0;           // GVSP block ID; gaps are frames lost whole
+    qint64 timestampNs = 0;        // Camera timestamp
+    int payloadSize = 0;
+    int packetsExpected = 0;
+    int packetsResent = 0;         // Recovered through PACKETRESEND
+    int packetsMissing = 0;        // Still missing at the frame timeout
+    bool complete = false;
+};
+
+/**
+ * @brief Stream channel to one GigE Vision camera
+ *
+ * Adapters for the camera SDKs (Aravis, Vimba, Spinnaker) implement this.
+ * open(), negotiatePacketSize() and announceBuffer() come from the
+ * source's thread with acquisition stopped, setFeature() from that thread
+ * at any time; queueBuffer() and waitBuffer() from the capture thread
+ * only; interrupt() from any thread.
+ */
+class GigETransport {
+public:
+    virtual ~GigETransport() = default;
+
+    virtual QString name() const = 0;
+    virtual QStringList devices() const = 0;
+
+    virtual bool open(const QString& deviceId) = 0;
+    virtual void close() = 0;
+    virtual QString errorString() const = 0;
+
+    // Largest stream packet size (GevSCPSPacketSize, IP headers included) at
+    // or below requested that reaches the host unfragmented; 0 on failure
+    virtual int negotiatePacketSize(int requested) = 0;
+
+    // GenICam feature by its SFNC name, e.g. ExposureTime (us), Gain (dB),
+    // ExposureAuto, GainAuto, PixelFormat ("Mono8", "RGB8", "Mono16")
+    virtual bool setFeature(const QString& name, const QVariant& value) = 0;
+
+    virtual QSize frameSize() const = 0;
+    virtual int payloadSize() const = 0;   // Bytes per packed frame
+
+    virtual bool announceBuffer(GigEBuffer* buffer) = 0;
+    virtual void revokeBuffers() = 0;      // Acquisition stopped
+
+    virtual bool startAcquisition() = 0;
+    virtual void stopAcquisition() = 0;    // Drops what is still queued
+
+    virtual bool queueBuffer(GigEBuffer* buffer) = 0;
+    // The next filled buffer, in block order; null on timeout or interrupt()
+    virtual GigEBuffer* waitBuffer(int timeoutMs) = 0;
+    virtual void interrupt() = 0;
+};
+
+/**
+ * @brief Process-wide list of GigE transports, best first
+ *
+ * SDK adapters register themselves above the simulated transport, which
+ * serves every device ID so a site without cameras still streams.
+ */
+class GigETransportRegistry {
+public:
+    using Factory = std::function<std::unique_ptr<GigETransport>()>;
+
+    static void registerTransport(const QString& name, int priority, Factory factory);
+    static void unregisterTransport(const QString& name);
+
+    static QStringList candidates();
+    static std::unique_ptr<GigETransport> create(const QString& name);
+};
+
+/**
+ * @brief Stand-in camera producing a moving test pattern
+ *
+ * Frames come at AcquisitionFrameRate, Width by Height. Each is split into packets of the
+ * negotiated size; packets are lost at the configured rate and a lost one
+ * comes back through a resend with the recovery probability, so the loss
+ * counters behave as on a congested link.
+ */
+class SimulatedGigETransport : public GigETransport {
+public:
+    QString name() const override { return QStringLiteral("simulated"); }
+    QStringList devices() const override;
+
+    bool open(const QString& deviceId) override;
+    void close() override;
+    QString errorString() const override { return QString(); }
+
+    int negotiatePacketSize(int requested) override;
+    bool setFeature(const QString& name, const QVariant& value) override;
+
+    QSize frameSize() const override { return m_size; }
+    int payloadSize() const override;
+
+    bool announceBuffer(GigEBuffer* buffer) override;
+    void revokeBuffers() override;
+
+    bool startAcquisition() override;
+    void stopAcquisition() override;
+
+    bool queueBuffer(GigEBuffer* buffer) override;
+    GigEBuffer* waitBuffer(int timeoutMs) override;
+    void interrupt() override;
+
+    // Link behaviour, set before acquisition starts
+    void setPathMtu(int bytes) { m_pathMtu = bytes; }
+    void setPacketLoss(double rate, double resendRecovery);
+
+    static constexpr int GVSP_OVERHEAD = 36;   // IP, UDP and GVSP headers
+
+private:
+    void fill(GigEBuffer* buffer);
+
+    QSize m_size = QSize(1920, 1080);
+    int m_bytesPerPixel = 1;
+    double m_frameRate = 30.0;
+    int m_pathMtu = 9000;
+    int m_packetSize = 1500;
+    double m_lossRate = 0.0;
+    double m_resendRecovery = 1.0;
+
+    QVector<GigEBuffer*> m_announced;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QQueue<GigEBuffer*> m_queue;
+    bool m_acquiring = false;
+    bool m_interrupted = false;
+    quint64 m_blockId = 0;
+    qint64 m_nextFrameNs = 0;
+    quint32 m_rng = 0x9e3779b9u;
+};
+
+} // namespace CounterUAS
+
+#endif // GIGETRANSPORT_H
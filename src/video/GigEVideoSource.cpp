@@ -1,16 +1,28 @@
 #include "video/GigEVideoSource.h"
 #include "utils/Logger.h"
-#include <QImage>
-#include <QRandomGenerator>
-#include <QPainter>
-#include <QFont>
+#include "utils/ThreadPlacement.h"
+#include <QMutexLocker>
+#include <cstring>
 
 namespace CounterUAS {
 
+namespace {
+
+// The camera's rows arrive packed; a frame's rows are 32-bit aligned. Rows
+// move down from the last, so none is overwritten before it has moved.
+void spreadRows(uchar* data, int rowBytes, int stride, int rows) {
+    if (stride == rowBytes) return;
+    for (int y = rows - 1; y > 0; --y) {
+        std::memmove(data + y * stride, data + y * rowBytes, rowBytes);
+    }
+}
+
+} // namespace
+
 GigEVideoSource::GigEVideoSource(const QString& sourceId, QObject* parent)
     : VideoSource(sourceId, parent)
 {
-    QObject::connect(m_frameTimer, &QTimer::timeout, this, &GigEVideoSource::processFrame);
+    // Frames are pushed by the capture thread; m_frameTimer stays idle
 }
 
 GigEVideoSource::~GigEVideoSource() {
@@ -19,15 +31,17 @@ GigEVideoSource::~GigEVideoSource() {
 
 void GigEVideoSource::setConfig(const GigEConfig& config) {
     m_config = config;
+    setThermalConfig(config.thermal);
+    if (m_transport) initializeCamera();
 }
 
 bool GigEVideoSource::open(const QUrl& url) {
     if (m_isOpen) {
         close();
     }
-    
+
     m_url = url;
-    
+
     // Extract device ID from URL if provided
     QString deviceId = url.path();
     if (deviceId.startsWith('/')) {
@@ -36,44 +50,59 @@ bool GigEVideoSource::open(const QUrl& url) {
     if (!deviceId.isEmpty()) {
         m_config.deviceId = deviceId;
     }
-    
+
     setStatus(VideoSourceStatus::Connecting);
-    
-    // In a real implementation, this would initialize the GigE SDK and connect to camera
-    // For simulation, we just mark as open
-    
+
     Logger::instance().info("GigEVideoSource",
                            QString("%1 opening device: %2")
                                .arg(m_sourceId)
                                .arg(m_config.deviceId));
-    
-    // Simulate successful connection
+
+    for (const QString& name : GigETransportRegistry::candidates()) {
+        std::unique_ptr<GigETransport> transport = GigETransportRegistry::create(name);
+        if (!transport) continue;
+        if (transport->open(m_config.deviceId)) {
+            m_transport = std::move(transport);
+            m_transportName = name;
+            break;
+        }
+        Logger::instance().warning("GigEVideoSource",
+                                   QString("%1: %2 cannot open %3: %4")
+                                       .arg(m_sourceId, name, m_config.deviceId,
+                                            transport->errorString()));
+    }
+    if (!m_transport) {
+        setError("No GigE transport can open device " + m_config.deviceId);
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_deliveryMutex);
+        m_counters = CaptureCounters();
+    }
+    initializeCamera();
+
     m_isOpen = true;
     setStatus(VideoSourceStatus::Connected);
-    
+
+    Logger::instance().info("GigEVideoSource",
+                           QString("%1 connected through %2").arg(m_sourceId, m_transportName));
     return true;
 }
 
 void GigEVideoSource::close() {
     if (!m_isOpen) return;
-    
+
     stop();
-    
-    // Stop capture thread
-    m_stopCapture = true;
-    if (m_captureThread) {
-        m_captureThread->quit();
-        m_captureThread->wait(1000);
-        delete m_captureThread;
-        m_captureThread = nullptr;
-    }
-    
-    // Clean up camera handle
-    m_cameraHandle = nullptr;
+
+    m_transport->close();
+    m_transport.reset();
+    m_transportName.clear();
+    m_framePool.trim();
     m_isOpen = false;
-    
+
     setStatus(VideoSourceStatus::Disconnected);
-    
+
     Logger::instance().info("GigEVideoSource", m_sourceId + " closed");
 }
 
@@ -81,71 +110,314 @@ bool GigEVideoSource::isOpen() const {
     return m_isOpen;
 }
 
+void GigEVideoSource::start() {
+    if (m_streaming) return;
+
+    VideoSource::start();
+    if (!m_streaming) return;
+    m_frameTimer.stop();
+
+    if (!startCapture()) {
+        setError("GigE acquisition failed to start: " + m_config.deviceId);
+    }
+}
+
+void GigEVideoSource::stop() {
+    stopCapture();
+    VideoSource::stop();
+}
+
+void GigEVideoSource::pause() {
+    if (!m_streaming) return;
+
+    stopCapture();
+    VideoSource::pause();
+}
+
+void GigEVideoSource::resume() {
+    if (m_status != VideoSourceStatus::Paused) return;
+
+    VideoSource::resume();
+    m_frameTimer.stop();
+
+    if (!startCapture()) {
+        setError("GigE acquisition failed to resume: " + m_config.deviceId);
+    }
+}
+
 void GigEVideoSource::setExposure(double ms) {
     m_config.exposureMs = qBound(0.01, ms, 1000.0);
-    // Would send command to camera here
+    if (m_transport) m_transport->setFeature("ExposureTime", m_config.exposureMs * 1000.0);
 }
 
 void GigEVideoSource::setGain(double db) {
     m_config.gainDb = qBound(0.0, db, 48.0);
-    // Would send command to camera here
+    if (m_transport) m_transport->setFeature("Gain", m_config.gainDb);
 }
 
 void GigEVideoSource::setAutoExposure(bool enable) {
     m_config.autoExposure = enable;
-    // Would send command to camera here
+    if (m_transport) m_transport->setFeature("ExposureAuto", enable ? "Continuous" : "Off");
 }
 
 void GigEVideoSource::setAutoGain(bool enable) {
     m_config.autoGain = enable;
-    // Would send command to camera here
+    if (m_transport) m_transport->setFeature("GainAuto", enable ? "Continuous" : "Off");
+}
+
+void GigEVideoSource::setThermalConfig(const ThermalConfig& config) {
+    m_config.thermal = config;
+    QMutexLocker locker(&m_deliveryMutex);
+    m_pendingThermal = config;
+    m_thermalChanged = true;
+}
+
+QString GigEVideoSource::transportName() const {
+    return m_transportName;
 }
 
 QStringList GigEVideoSource::availableDevices() {
-    // In a real implementation, this would enumerate GigE cameras
     QStringList devices;
-    devices << "GigE-Camera-001" << "GigE-Camera-002";
+    for (const QString& name : GigETransportRegistry::candidates()) {
+        std::unique_ptr<GigETransport> transport = GigETransportRegistry::create(name);
+        if (!transport) continue;
+        for (const QString& device : transport->devices()) {
+            if (!devices.contains(device)) devices.append(device);
+        }
+    }
     return devices;
 }
 
 void GigEVideoSource::processFrame() {
-    if (!m_isOpen || !m_streaming) return;
-    
-    // In a real implementation, this would grab frames from the camera
-    // For simulation, generate a test pattern
-    
-    int width = 1920;
-    int height = 1080;
-    
-    QImage frame(width, height, QImage::Format_RGB888);
-    frame.fill(Qt::darkGray);
-    
-    // Draw some test pattern
-    QPainter painter(&frame);
-    painter.setPen(Qt::white);
-    painter.setFont(QFont("Arial", 24));
-    
-    QString text = QString("GigE Camera: %1\nFrame: %2")
-                       .arg(m_config.deviceId)
-                       .arg(m_stats.framesReceived);
-    
-    painter.drawText(frame.rect(), Qt::AlignCenter, text);
-    
-    // Add timestamp
-    painter.setFont(QFont("Arial", 12));
-    painter.drawText(10, 30, QDateTime::currentDateTime().toString("hh:mm:ss.zzz"));
-    
-    painter.end();
-    
+    VideoFrame frame;
+    CaptureCounters counters;
+    {
+        QMutexLocker locker(&m_deliveryMutex);
+        frame = m_pendingFrame;
+        m_pendingFrame = VideoFrame();
+        m_deliveryQueued = false;
+        counters = m_counters;
+    }
+
+    m_stats.framesDropped = counters.framesDropped;
+    m_stats.framesIncomplete = counters.framesIncomplete;
+    m_stats.packetsReceived = counters.packetsReceived;
+    m_stats.packetsResent = counters.packetsResent;
+    m_stats.packetsMissing = counters.packetsMissing;
+
+    if (frame.isNull() || !m_streaming || m_status == VideoSourceStatus::Paused) return;
     emitFrame(frame);
 }
 
 void GigEVideoSource::initializeCamera() {
-    // Would initialize GigE camera here using SDK
+    m_transport->setFeature("ExposureAuto", m_config.autoExposure ? "Continuous" : "Off");
+    if (!m_config.autoExposure) {
+        m_transport->setFeature("ExposureTime", m_config.exposureMs * 1000.0);
+    }
+    m_transport->setFeature("GainAuto", m_config.autoGain ? "Continuous" : "Off");
+    if (!m_config.autoGain) {
+        m_transport->setFeature("Gain", m_config.gainDb);
+    }
+}
+
+bool GigEVideoSource::startCapture() {
+    if (!m_transport || m_captureThread) return m_captureThread != nullptr;
+
+    // Jumbo frames only pay off when every hop carries them, so the camera
+    // is asked for the configured size and steps down to what gets through
+    const int ceiling = m_config.jumboFrames ? MAX_JUMBO_PACKET_SIZE : STANDARD_PACKET_SIZE;
+    const int requested = qBound(MIN_PACKET_SIZE, m_config.packetSize, ceiling);
+    const int negotiated = m_transport->negotiatePacketSize(requested);
+    if (negotiated <= 0) {
+        Logger::instance().warning("GigEVideoSource",
+                                   m_sourceId + ": no stream packet size gets through");
+        return false;
+    }
+    if (negotiated < requested) {
+        Logger::instance().info("GigEVideoSource",
+                                QString("%1 packet size %2 negotiated down to %3")
+                                    .arg(m_sourceId).arg(requested).arg(negotiated));
+    }
+    m_stats.packetSize = negotiated;
+
+    const bool rgb = m_config.pixelFormat == 1;
+    m_radiometric = m_config.pixelFormat == 2;
+    const char* format = rgb ? "RGB8" : m_radiometric ? "Mono16" : "Mono8";
+    if (!m_transport->setFeature("PixelFormat", format)) {
+        Logger::instance().warning("GigEVideoSource",
+                                   m_sourceId + ": camera rejects the pixel format");
+        return false;
+    }
+    m_transport->setFeature("AcquisitionFrameRate", m_targetFPS);
+    m_pixelFormat = rgb ? VideoPixelFormat::RGB24 : VideoPixelFormat::YUV420P;
+    m_frameSize = m_transport->frameSize();
+    if (m_radiometric) {
+        QMutexLocker locker(&m_deliveryMutex);
+        m_thermal.setConfig(m_config.thermal);
+        m_thermal.reset();
+        m_thermalChanged = false;
+    }
+
+    const int count = qBound(2, m_config.frameBufferCount, 64);
+    m_buffers = QVector<GigEBuffer>(count);
+    m_slotFrames = QVector<VideoFrame>(count);
+    m_rawBuffers = QVector<QByteArray>(m_radiometric ? count : 0);
+    bool ok = true;
+    for (int i = 0; i < count && ok; ++i) {
+        m_buffers[i].slot = i;
+        ok = armSlot(i) && m_transport->announceBuffer(&m_buffers[i]);
+    }
+    ok = ok && m_transport->startAcquisition();
+    for (int i = 0; i < count && ok; ++i) {
+        ok = m_transport->queueBuffer(&m_buffers[i]);
+    }
+    if (!ok) {
+        m_transport->stopAcquisition();
+        m_transport->revokeBuffers();
+        m_buffers.clear();
+        m_slotFrames.clear();
+        m_rawBuffers.clear();
+        Logger::instance().warning("GigEVideoSource",
+                                   m_sourceId + ": camera refused the acquisition buffers");
+        return false;
+    }
+
+    m_stopCapture = false;
+    m_captureThread = QThread::create([this]() { captureLoop(); });
+    ThreadPlacement::instance().assign(m_captureThread, ThreadRole::VideoDecode);
+    m_captureThread->start(QThread::TimeCriticalPriority);
+
+    Logger::instance().info("GigEVideoSource",
+                            QString("%1 acquiring %2x%3 %4, %5 buffers, %6-byte packets")
+                                .arg(m_sourceId)
+                                .arg(m_frameSize.width()).arg(m_frameSize.height())
+                                .arg(format)
+                                .arg(count).arg(negotiated));
+    return true;
+}
+
+void GigEVideoSource::stopCapture() {
+    if (!m_captureThread) return;
+
+    m_stopCapture = true;
+    m_transport->interrupt();
+    m_captureThread->wait();
+    delete m_captureThread;
+    m_captureThread = nullptr;
+
+    m_transport->stopAcquisition();
+    m_transport->revokeBuffers();
+    m_buffers.clear();
+    m_slotFrames.clear();
+    m_rawBuffers.clear();
+
+    QMutexLocker locker(&m_deliveryMutex);
+    m_pendingFrame = VideoFrame();
+}
+
+bool GigEVideoSource::armSlot(int slot) {
+    if (m_radiometric) {
+        // Reused in place: the frame was made from it before it is requeued
+        QByteArray& raw = m_rawBuffers[slot];
+        raw.resize(m_frameSize.width() * m_frameSize.height() * 2);
+        m_buffers[slot].data = reinterpret_cast<uchar*>(raw.data());
+        m_buffers[slot].capacity = raw.size();
+        return !raw.isEmpty();
+    }
+
+    VideoFrame& frame = m_slotFrames[slot];
+    frame = VideoFrame::allocate(m_pixelFormat, m_frameSize, &m_framePool);
+    if (frame.isNull()) return false;
+
+    // Held only here, so bits() writes into the pooled buffer itself
+    GigEBuffer& buffer = m_buffers[slot];
+    buffer.data = frame.bits(0);
+    buffer.capacity = frame.bytesPerLine(0) * frame.height();
+    if (m_pixelFormat == VideoPixelFormat::YUV420P) {
+        std::memset(frame.bits(1), 128, frame.planeSize(1).height() * frame.bytesPerLine(1) * 2);
+    }
+    return true;
 }
 
 void GigEVideoSource::captureLoop() {
-    // Would run continuous capture loop in separate thread
+    const int timeoutMs = qMax(10, m_config.frameTimeoutMs);
+    const int rowBytes = m_frameSize.width() * (m_pixelFormat == VideoPixelFormat::RGB24 ? 3 : 1);
+    quint64 lastBlock = 0;
+    bool silent = false;
+
+    while (!m_stopCapture) {
+        GigEBuffer* buffer = m_transport->waitBuffer(timeoutMs);
+        if (!buffer) {
+            if (m_stopCapture) break;
+            if (!silent) {
+                silent = true;
+                QMetaObject::invokeMethod(this, [this, timeoutMs]() {
+                    if (m_streaming) setError(QString("No frames from camera for %1 ms").arg(timeoutMs));
+                }, Qt::QueuedConnection);
+            }
+            continue;
+        }
+        silent = false;
+
+        const int slot = buffer->slot;
+        VideoFrame frame = m_radiometric ? VideoFrame() : std::move(m_slotFrames[slot]);
+
+        CaptureCounters delta;
+        if (lastBlock != 0 && buffer->blockId > lastBlock + 1) {
+            delta.framesDropped += static_cast<qint64>(buffer->blockId - lastBlock - 1);
+        }
+        lastBlock = buffer->blockId;
+        delta.packetsReceived = buffer->packetsExpected - buffer->packetsMissing;
+        delta.packetsResent = buffer->packetsResent;
+        delta.packetsMissing = buffer->packetsMissing;
+
+        bool usable = buffer->complete && (m_radiometric || !frame.isNull());
+        if (!buffer->complete) {
+            ++delta.framesIncomplete;
+            ++delta.framesDropped;
+        }
+        if (usable && m_radiometric) {
+            frame = m_thermal.process(reinterpret_cast<const quint16*>(buffer->data),
+                                      m_frameSize.width() * 2, m_frameSize, &m_framePool);
+            usable = !frame.isNull();
+        } else if (usable) {
+            spreadRows(frame.bits(0), rowBytes, frame.bytesPerLine(0), frame.height());
+        }
+
+        // Back to the camera before anything else, over a fresh frame
+        if (!armSlot(slot) || !m_transport->queueBuffer(buffer)) {
+            Logger::instance().warning("GigEVideoSource",
+                                       QString("%1: buffer %2 could not be requeued")
+                                           .arg(m_sourceId).arg(slot));
+        }
+
+        bool queue = false;
+        ThermalConfig thermal;
+        bool thermalChanged = false;
+        {
+            QMutexLocker locker(&m_deliveryMutex);
+            if (m_thermalChanged) {
+                thermal = m_pendingThermal;
+                thermalChanged = true;
+                m_thermalChanged = false;
+            }
+            m_counters.framesDropped += delta.framesDropped;
+            m_counters.framesIncomplete += delta.framesIncomplete;
+            m_counters.packetsReceived += delta.packetsReceived;
+            m_counters.packetsResent += delta.packetsResent;
+            m_counters.packetsMissing += delta.packetsMissing;
+            if (usable) {
+                if (!m_pendingFrame.isNull()) ++m_counters.framesDropped;
+                m_pendingFrame = frame;
+            }
+            queue = !m_deliveryQueued;
+            m_deliveryQueued = true;
+        }
+        if (queue) {
+            QMetaObject::invokeMethod(this, "processFrame", Qt::QueuedConnection);
+        }
+        if (thermalChanged) m_thermal.setConfig(thermal);
+    }
 }
 
 } // namespace CounterUAS
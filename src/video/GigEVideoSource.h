@@ -2,7 +2,14 @@
 #define GIGEVIDEOSOURCE_H
 
 #include "video/VideoSource.h"
+#include "video/GigETransport.h"
+#include "video/ThermalProcessor.h"
+#include <QByteArray>
+#include <QMutex>
 #include <QThread>
+#include <QVector>
+#include <atomic>
+#include <memory>
 
 namespace CounterUAS {
 
@@ -11,60 +18,122 @@ namespace CounterUAS {
  */
 struct GigEConfig {
     QString deviceId;
-    int packetSize = 8192;
-    int frameBufferCount = 3;
+    int packetSize = 8192;           // Requested; negotiated down to what the path carries
+    bool jumboFrames = true;         // Off: never above the standard Ethernet MTU
+    int frameBufferCount = 3;        // Buffers announced to the camera
+    int frameTimeoutMs = 1000;       // Silence before the camera counts as lost
     double exposureMs = 10.0;
     double gainDb = 0.0;
     bool autoExposure = true;
     bool autoGain = true;
-    int pixelFormat = 0;  // 0 = mono8, 1 = rgb8, etc.
+    int pixelFormat = 0;  // 0 = mono8, 1 = rgb8, 2 = mono16 (radiometric thermal)
+    ThermalConfig thermal;           // Display mapping of mono16
 };
 
 /**
  * @brief GigE Vision camera video source
- * Note: Full implementation requires GigE Vision SDK (e.g., Aravis, Vimba)
+ *
+ * Streams through the first transport in GigETransportRegistry that opens
+ * the device. While streaming, a capture thread announces
+ * frameBufferCount frames from the source's FramePool to the transport
+ * and loops on its completions: each filled buffer is emitted as it is,
+ * and the slot is queued again over a fresh pooled frame, so pixels go
+ * from the NIC to the display without a copy. Mono8 frames travel as
+ * YUV420P with neutral chroma. Mono16 frames from radiometric thermal
+ * cameras land in raw buffers instead, and a ThermalProcessor on the
+ * capture thread maps each to a pooled display frame before its buffer
+ * goes back to the camera; with one thread per camera, several thermal
+ * streams are processed side by side.
+ *
+ * Incomplete frames are dropped and counted with their missing and resent
+ * packets in stats(). Frames reach the source's thread latest-first: one
+ * the GUI has not taken yet is replaced, and counted dropped.
  */
 class GigEVideoSource : public VideoSource {
     Q_OBJECT
-    
+
 public:
     explicit GigEVideoSource(const QString& sourceId, QObject* parent = nullptr);
     ~GigEVideoSource() override;
-    
+
     QString sourceType() const override { return "GigE"; }
-    
+
     // VideoSource implementation
     bool open(const QUrl& url) override;
     void close() override;
     bool isOpen() const override;
-    
-    // GigE-specific configuration
+
+    void start() override;
+    void stop() override;
+    void pause() override;
+    void resume() override;
+
+    // GigE-specific configuration; packet size and buffers apply at start()
     void setConfig(const GigEConfig& config);
     GigEConfig config() const { return m_config; }
-    
+
     // Camera control
     void setExposure(double ms);
     void setGain(double db);
     void setAutoExposure(bool enable);
     void setAutoGain(bool enable);
-    
+    // Applies from the next frame, while streaming too
+    void setThermalConfig(const ThermalConfig& config);
+
+    QString transportName() const;
+    int negotiatedPacketSize() const { return m_stats.packetSize; }
+
     // Device enumeration
     static QStringList availableDevices();
-    
+
+    static constexpr int STANDARD_PACKET_SIZE = 1500;
+    static constexpr int MAX_JUMBO_PACKET_SIZE = 9000;
+    static constexpr int MIN_PACKET_SIZE = 576;
+
 protected slots:
     void processFrame() override;
-    
+
 private:
+    struct CaptureCounters {
+        qint64 framesDropped = 0;
+        qint64 framesIncomplete = 0;
+        qint64 packetsReceived = 0;
+        qint64 packetsResent = 0;
+        qint64 packetsMissing = 0;
+    };
+
     void initializeCamera();
+    bool startCapture();
+    void stopCapture();
+    bool armSlot(int slot);
     void captureLoop();
-    
+
     GigEConfig m_config;
     bool m_isOpen = false;
-    
-    // Placeholder for actual GigE SDK objects
-    void* m_cameraHandle = nullptr;
+
+    std::unique_ptr<GigETransport> m_transport;
+    QString m_transportName;
+
+    // Announced buffers and the frames behind them; the capture thread's
+    // alone while it runs
+    QVector<GigEBuffer> m_buffers;
+    QVector<VideoFrame> m_slotFrames;
+    QVector<QByteArray> m_rawBuffers;   // Mono16 slots instead of frames
+    bool m_radiometric = false;
+    ThermalProcessor m_thermal;
+    VideoPixelFormat m_pixelFormat = VideoPixelFormat::YUV420P;
+    QSize m_frameSize;
+
     QThread* m_captureThread = nullptr;
-    bool m_stopCapture = false;
+    std::atomic<bool> m_stopCapture{false};
+
+    // Handed from the capture thread to processFrame()
+    QMutex m_deliveryMutex;
+    VideoFrame m_pendingFrame;
+    bool m_deliveryQueued = false;
+    CaptureCounters m_counters;
+    ThermalConfig m_pendingThermal;
+    bool m_thermalChanged = false;
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,299 @@
+#include "video/KlvEncoder.h"
+#include <QtEndian>
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int LENGTH_SIZE = 3;      // BER long form with two bytes, so it can be patched in place
+constexpr int VALUE_START = KlvEncoder::KEY_SIZE + LENGTH_SIZE;
+
+// ST 0903 VMTI local set and VTarget pack tags
+constexpr int VMTI_VERSION = 5;     // ST 0903.5
+constexpr int VMTI_TAG_VERSION = 4;
+constexpr int VMTI_TAG_TOTAL_TARGETS = 5;
+constexpr int VMTI_TAG_REPORTED_TARGETS = 6;
+constexpr int VMTI_TAG_FRAME_WIDTH = 8;
+constexpr int VMTI_TAG_FRAME_HEIGHT = 9;
+constexpr int VMTI_TAG_TARGET_SERIES = 101;
+constexpr int TARGET_TAG_CENTROID = 1;
+constexpr int TARGET_TAG_TOP_LEFT = 2;
+constexpr int TARGET_TAG_BOTTOM_RIGHT = 3;
+constexpr int TARGET_TAG_CONFIDENCE = 5;
+
+const uchar UNIVERSAL_KEY[KlvEncoder::KEY_SIZE] = {
+    0x06, 0x0E, 0x2B, 0x34, 0x02, 0x0B, 0x01, 0x01,
+    0x0E, 0x01, 0x03, 0x01, 0x01, 0x00, 0x00, 0x00
+};
+
+// The template's items in packet order, timestamp first as the standard asks
+struct Item {
+    int tag;
+    int size;
+};
+const Item ITEMS[] = {
+    {KlvEncoder::TAG_TIMESTAMP, 8},
+    {KlvEncoder::TAG_LS_VERSION, 1},
+    {KlvEncoder::TAG_PLATFORM_HEADING, 2},
+    {KlvEncoder::TAG_PLATFORM_PITCH, 2},
+    {KlvEncoder::TAG_PLATFORM_ROLL, 2},
+    {KlvEncoder::TAG_SENSOR_LATITUDE, 4},
+    {KlvEncoder::TAG_SENSOR_LONGITUDE, 4},
+    {KlvEncoder::TAG_SENSOR_ALTITUDE, 2},
+    {KlvEncoder::TAG_HORIZONTAL_FOV, 2},
+    {KlvEncoder::TAG_VERTICAL_FOV, 2},
+    {KlvEncoder::TAG_SENSOR_AZIMUTH, 4},
+    {KlvEncoder::TAG_SENSOR_ELEVATION, 4},
+    {KlvEncoder::TAG_SENSOR_ROLL, 4},
+    {KlvEncoder::TAG_FRAME_CENTER_LATITUDE, 4},
+    {KlvEncoder::TAG_FRAME_CENTER_LONGITUDE, 4},
+    {KlvEncoder::TAG_FRAME_CENTER_ELEVATION, 2},
+};
+
+constexpr double ALTITUDE_MIN = -900.0;
+constexpr double ALTITUDE_MAX = 19000.0;
+
+double wrap360(double degrees) {
+    const double wrapped = std::fmod(degrees, 360.0);
+    return wrapped < 0.0 ? wrapped + 360.0 : wrapped;
+}
+
+double wrap180(double degrees) {
+    return wrap360(degrees + 180.0) - 180.0;
+}
+
+// Unsigned mappings clamp to their range
+quint16 toUint16(double value, double min, double max) {
+    const double t = qBound(0.0, (value - min) / (max - min), 1.0);
+    return quint16(std::lround(t * 65535.0));
+}
+
+quint32 toUint32(double value, double min, double max) {
+    const double t = qBound(0.0, (value - min) / (max - min), 1.0);
+    return quint32(std::llround(t * 4294967295.0));
+}
+
+// Signed ones are symmetric; out of range, or not a number, is the error value
+qint16 toInt16(double value, double range) {
+    if (!(std::abs(value) <= range)) return std::numeric_limits<qint16>::min();
+    return qint16(std::lround(value / range * 32767.0));
+}
+
+qint32 toInt32(double value, double range) {
+    if (!(std::abs(value) <= range)) return std::numeric_limits<qint32>::min();
+    return qint32(std::llround(value / range * 2147483647.0));
+}
+
+template <typename T>
+void put(QByteArray& packet, int offset, T value) {
+    qToBigEndian<T>(value, reinterpret_cast<uchar*>(packet.data()) + offset);
+}
+
+void putLength(QByteArray& packet, int offset, int length) {
+    packet[offset] = char(0x82);
+    put<quint16>(packet, offset + 1, quint16(length));
+}
+
+void appendLengthPlaceholder(QByteArray& packet) {
+    packet.append(char(0x82));
+    packet.append(char(0));
+    packet.append(char(0));
+}
+
+void appendUint(QByteArray& packet, int tag, quint32 value, int size) {
+    packet.append(char(tag));
+    packet.append(char(size));
+    for (int shift = 8 * (size - 1); shift >= 0; shift -= 8) packet.append(char((value >> shift) & 0xFF));
+}
+
+void appendOid(QByteArray& packet, quint32 value) {
+    uchar groups[5];
+    int count = 0;
+    do {
+        groups[count++] = uchar(value & 0x7F);
+        value >>= 7;
+    } while (value);
+    while (count-- > 0) packet.append(char(groups[count] | (count > 0 ? 0x80 : 0)));
+}
+
+// ST 0903 pixel number: row-major from 1 at the top left
+quint32 pixelNumber(const QPointF& point, const QSize& frame) {
+    const int column = qBound(0, int(point.x() * frame.width()), frame.width() - 1);
+    const int row = qBound(0, int(point.y() * frame.height()), frame.height() - 1);
+    return quint32(row) * quint32(frame.width()) + quint32(column) + 1;
+}
+
+void appendVmti(QByteArray& packet, const QVector<KlvTarget>& targets, const QSize& frame) {
+    const int reported = qMin(targets.size(), KlvEncoder::MAX_TARGETS);
+
+    packet.append(char(KlvEncoder::TAG_VMTI));
+    const int setLength = packet.size();
+    appendLengthPlaceholder(packet);
+    const int setStart = packet.size();
+    appendUint(packet, VMTI_TAG_VERSION, VMTI_VERSION, 1);
+    appendUint(packet, VMTI_TAG_TOTAL_TARGETS, quint32(targets.size()), 2);
+    appendUint(packet, VMTI_TAG_REPORTED_TARGETS, quint32(reported), 2);
+    appendUint(packet, VMTI_TAG_FRAME_WIDTH, quint32(frame.width()), 2);
+    appendUint(packet, VMTI_TAG_FRAME_HEIGHT, quint32(frame.height()), 2);
+
+    packet.append(char(VMTI_TAG_TARGET_SERIES));
+    const int seriesLength = packet.size();
+    appendLengthPlaceholder(packet);
+    const int seriesStart = packet.size();
+    for (int i = 0; i < reported; ++i) {
+        const KlvTarget& target = targets.at(i);
+        const QRectF box = target.box.normalized();
+        // A pack is well under 128 bytes, so its length is one byte
+        const int packLength = packet.size();
+        packet.append(char(0));
+        const int packStart = packet.size();
+        appendOid(packet, target.id);
+        appendUint(packet, TARGET_TAG_CENTROID, pixelNumber(box.center(), frame), 4);
+        appendUint(packet, TARGET_TAG_TOP_LEFT, pixelNumber(box.topLeft(), frame), 4);
+        appendUint(packet, TARGET_TAG_BOTTOM_RIGHT, pixelNumber(box.bottomRight(), frame), 4);
+        if (target.confidence >= 0) {
+            appendUint(packet, TARGET_TAG_CONFIDENCE, quint32(qMin(target.confidence, 100)), 1);
+        }
+        packet[packLength] = char(packet.size() - packStart);
+    }
+    putLength(packet, seriesLength, packet.size() - seriesStart);
+    putLength(packet, setLength, packet.size() - setStart);
+}
+
+// Sum of the packet as big-endian 16-bit words, ST 0601's checksum
+quint16 checksum(const uchar* data, int size) {
+    quint16 sum = 0;
+    for (int i = 0; i < size; ++i) sum += quint16(data[i] << (8 * ((i + 1) % 2)));
+    return sum;
+}
+
+bool readBerLength(const uchar* data, int end, int& pos, int& length) {
+    if (pos >= end) return false;
+    const uchar first = data[pos++];
+    if (!(first & 0x80)) {
+        length = first;
+        return true;
+    }
+    const int bytes = first & 0x7F;
+    if (bytes == 0 || bytes > 4 || pos + bytes > end) return false;
+    qint64 value = 0;
+    for (int i = 0; i < bytes; ++i) value = (value << 8) | data[pos++];
+    if (value > end - pos) return false;
+    length = int(value);
+    return true;
+}
+
+bool readOid(const uchar* data, int end, int& pos, quint32& value) {
+    value = 0;
+    for (int i = 0; i < 5 && pos < end; ++i) {
+        const uchar byte = data[pos++];
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool readItems(const uchar* data, int pos, int end, QMap<int, QByteArray>& items) {
+    items.clear();
+    while (pos < end) {
+        quint32 tag = 0;
+        int length = 0;
+        if (!readOid(data, end, pos, tag) || !readBerLength(data, end, pos, length)) return false;
+        items.insert(int(tag), QByteArray(reinterpret_cast<const char*>(data) + pos, length));
+        pos += length;
+    }
+    return true;
+}
+
+} // namespace
+
+KlvEncoder::KlvEncoder() {
+    m_template = universalKey();
+    appendLengthPlaceholder(m_template);
+    for (const Item& item : ITEMS) {
+        m_template.append(char(item.tag));
+        m_template.append(char(item.size));
+        m_offsets[item.tag] = m_template.size();
+        m_template.append(QByteArray(item.size, '\0'));
+    }
+    m_template[m_offsets[TAG_LS_VERSION]] = char(LS_VERSION);
+    // Reserved so a resize to the template keeps the buffer for the VMTI set
+    m_packet.reserve(m_template.size() + 256);
+}
+
+const QByteArray& KlvEncoder::encode(const SensorMetadata& metadata, qint64 timestampMs, const QSize& frameSize) {
+    m_packet.resize(m_template.size());
+    std::memcpy(m_packet.data(), m_template.constData(), size_t(m_template.size()));
+
+    put<quint64>(m_packet, m_offsets[TAG_TIMESTAMP], quint64(qMax<qint64>(0, timestampMs)) * 1000);
+    put<quint16>(m_packet, m_offsets[TAG_PLATFORM_HEADING],
+                 toUint16(wrap360(metadata.platformHeadingDeg), 0.0, 360.0));
+    put<qint16>(m_packet, m_offsets[TAG_PLATFORM_PITCH], toInt16(metadata.platformPitchDeg, 20.0));
+    put<qint16>(m_packet, m_offsets[TAG_PLATFORM_ROLL], toInt16(metadata.platformRollDeg, 50.0));
+    put<qint32>(m_packet, m_offsets[TAG_SENSOR_LATITUDE], toInt32(metadata.sensor.latitude, 90.0));
+    put<qint32>(m_packet, m_offsets[TAG_SENSOR_LONGITUDE], toInt32(metadata.sensor.longitude, 180.0));
+    put<quint16>(m_packet, m_offsets[TAG_SENSOR_ALTITUDE],
+                 toUint16(metadata.sensor.altitude, ALTITUDE_MIN, ALTITUDE_MAX));
+
+    double verticalFov = metadata.verticalFovDeg;
+    if (verticalFov <= 0.0 && frameSize.width() > 0 && frameSize.height() > 0) {
+        const double halfWidth = std::tan(qDegreesToRadians(metadata.horizontalFovDeg) / 2.0);
+        verticalFov = qRadiansToDegrees(2.0 * std::atan(halfWidth * frameSize.height() / frameSize.width()));
+    }
+    put<quint16>(m_packet, m_offsets[TAG_HORIZONTAL_FOV], toUint16(metadata.horizontalFovDeg, 0.0, 180.0));
+    put<quint16>(m_packet, m_offsets[TAG_VERTICAL_FOV], toUint16(verticalFov, 0.0, 180.0));
+    put<quint32>(m_packet, m_offsets[TAG_SENSOR_AZIMUTH], toUint32(wrap360(metadata.sensorAzimuthDeg), 0.0, 360.0));
+    put<qint32>(m_packet, m_offsets[TAG_SENSOR_ELEVATION], toInt32(wrap180(metadata.sensorElevationDeg), 180.0));
+    put<quint32>(m_packet, m_offsets[TAG_SENSOR_ROLL], toUint32(wrap360(metadata.sensorRollDeg), 0.0, 360.0));
+
+    // Without a ground intersection the centre goes out as the error value
+    const bool center = metadata.hasFrameCenter && metadata.frameCenter.isValid();
+    put<qint32>(m_packet, m_offsets[TAG_FRAME_CENTER_LATITUDE],
+                center ? toInt32(metadata.frameCenter.latitude, 90.0) : std::numeric_limits<qint32>::min());
+    put<qint32>(m_packet, m_offsets[TAG_FRAME_CENTER_LONGITUDE],
+                center ? toInt32(metadata.frameCenter.longitude, 180.0) : std::numeric_limits<qint32>::min());
+    put<quint16>(m_packet, m_offsets[TAG_FRAME_CENTER_ELEVATION],
+                 center ? toUint16(metadata.frameCenter.altitude, ALTITUDE_MIN, ALTITUDE_MAX) : 0);
+
+    if (!metadata.targets.isEmpty() && frameSize.width() > 0 && frameSize.height() > 0) {
+        appendVmti(m_packet, metadata.targets, frameSize);
+    }
+
+    // The checksum covers everything up to its own value, its tag and length included
+    m_packet.append(char(TAG_CHECKSUM));
+    m_packet.append(char(2));
+    m_packet.append(char(0));
+    m_packet.append(char(0));
+    putLength(m_packet, KEY_SIZE, m_packet.size() - VALUE_START);
+    const int sumEnd = m_packet.size() - 2;
+    put<quint16>(m_packet, sumEnd, checksum(reinterpret_cast<const uchar*>(m_packet.constData()), sumEnd));
+    return m_packet;
+}
+
+QByteArray KlvEncoder::universalKey() {
+    return QByteArray(reinterpret_cast<const char*>(UNIVERSAL_KEY), KEY_SIZE);
+}
+
+bool KlvEncoder::parse(const QByteArray& packet, QMap<int, QByteArray>& items) {
+    items.clear();
+    const uchar* data = reinterpret_cast<const uchar*>(packet.constData());
+    const int size = packet.size();
+    if (size < KEY_SIZE + 1 + 4 || std::memcmp(data, UNIVERSAL_KEY, KEY_SIZE) != 0) return false;
+
+    int pos = KEY_SIZE;
+    int length = 0;
+    if (!readBerLength(data, size, pos, length) || pos + length != size || length < 4) return false;
+    if (data[size - 4] != TAG_CHECKSUM || data[size - 3] != 2) return false;
+    if (checksum(data, size - 2) != qFromBigEndian<quint16>(data + size - 2)) return false;
+    return readItems(data, pos, size, items);
+}
+
+bool KlvEncoder::parseItems(const QByteArray& set, QMap<int, QByteArray>& items) {
+    return readItems(reinterpret_cast<const uchar*>(set.constData()), 0, set.size(), items);
+}
+
+} // namespace CounterUAS
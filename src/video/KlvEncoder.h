@@ -0,0 +1,104 @@
+#ifndef KLVENCODER_H
+#define KLVENCODER_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QMetaType>
+#include <QRectF>
+#include <QSize>
+#include <QVector>
+#include "core/Track.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief A target box carried with a frame, MISB ST 0903 VMTI
+ */
+struct KlvTarget {
+    quint32 id = 0;             // From 1; stays with the target across frames
+    QRectF box;                 // Normalised to the frame, 0-1
+    int confidence = -1;        // 0-100; -1 to omit
+};
+
+/**
+ * @brief Where a camera was and where it looked for a frame
+ */
+struct SensorMetadata {
+    GeoPosition sensor;         // The camera's mount
+    double platformHeadingDeg = 0.0;   // True bearing of pan 0
+    double platformPitchDeg = 0.0;
+    double platformRollDeg = 0.0;
+    double sensorAzimuthDeg = 0.0;     // Relative to the platform
+    double sensorElevationDeg = 0.0;
+    double sensorRollDeg = 0.0;
+    double horizontalFovDeg = 0.0;
+    double verticalFovDeg = 0.0;       // 0 to take it from the frame's aspect
+    bool hasFrameCenter = false;
+    GeoPosition frameCenter;
+    QVector<KlvTarget> targets;
+};
+
+/**
+ * @brief MISB ST 0601 UAS Datalink Local Set, one packet per frame
+ *
+ * The packet is laid out once, in the constructor: the universal key, a
+ * fixed-width length, and every item with its tag and length, values
+ * zero. encode() copies that template, writes the values at their known
+ * offsets, appends the target boxes as an ST 0903 VMTI local set (tag 74)
+ * when there are any, and closes with the checksum, so the cost per frame
+ * is a copy and a few stores however the metadata changes, and nothing is
+ * allocated once the buffer has grown to fit.
+ *
+ * Values use the standard's integer mappings; angles and positions out of
+ * range are sent as its error values. Altitudes are the mount's as given,
+ * which CounterUAS keeps above ground.
+ */
+class KlvEncoder {
+public:
+    static constexpr int LS_VERSION = 17;        // ST 0601.17
+    static constexpr int KEY_SIZE = 16;
+    static constexpr int MAX_TARGETS = 64;
+
+    // Local set tags
+    static constexpr int TAG_CHECKSUM = 1;
+    static constexpr int TAG_TIMESTAMP = 2;
+    static constexpr int TAG_PLATFORM_HEADING = 5;
+    static constexpr int TAG_PLATFORM_PITCH = 6;
+    static constexpr int TAG_PLATFORM_ROLL = 7;
+    static constexpr int TAG_SENSOR_LATITUDE = 13;
+    static constexpr int TAG_SENSOR_LONGITUDE = 14;
+    static constexpr int TAG_SENSOR_ALTITUDE = 15;
+    static constexpr int TAG_HORIZONTAL_FOV = 16;
+    static constexpr int TAG_VERTICAL_FOV = 17;
+    static constexpr int TAG_SENSOR_AZIMUTH = 18;
+    static constexpr int TAG_SENSOR_ELEVATION = 19;
+    static constexpr int TAG_SENSOR_ROLL = 20;
+    static constexpr int TAG_FRAME_CENTER_LATITUDE = 23;
+    static constexpr int TAG_FRAME_CENTER_LONGITUDE = 24;
+    static constexpr int TAG_FRAME_CENTER_ELEVATION = 25;
+    static constexpr int TAG_LS_VERSION = 65;
+    static constexpr int TAG_VMTI = 74;
+
+    KlvEncoder();
+
+    // The packet for a frame captured at timestampMs (ms since the epoch);
+    // valid until the next call
+    const QByteArray& encode(const SensorMetadata& metadata, qint64 timestampMs, const QSize& frameSize);
+
+    static QByteArray universalKey();
+    // Items of a packet by tag; false unless the key, length and checksum hold
+    static bool parse(const QByteArray& packet, QMap<int, QByteArray>& items);
+    // Items of a bare local set, such as the VMTI item's value
+    static bool parseItems(const QByteArray& set, QMap<int, QByteArray>& items);
+
+private:
+    QByteArray m_template;
+    QByteArray m_packet;
+    int m_offsets[TAG_VMTI] = {};   // Value offset by tag, within the template
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::SensorMetadata)
+
+#endif // KLVENCODER_H
@@ -0,0 +1,426 @@
+#include "video/MatroskaReader.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint32 ID_EBML = 0x1A45DFA3;
+constexpr quint32 ID_SEGMENT = 0x18538067;
+constexpr quint32 ID_INFO = 0x1549A966;
+constexpr quint32 ID_TIMECODE_SCALE = 0x2AD7B1;
+constexpr quint32 ID_DURATION = 0x4489;
+constexpr quint32 ID_DATE_UTC = 0x4461;
+constexpr quint32 ID_TRACKS = 0x1654AE6B;
+constexpr quint32 ID_TRACK_ENTRY = 0xAE;
+constexpr quint32 ID_TRACK_NUMBER = 0xD7;
+constexpr quint32 ID_TRACK_TYPE = 0x83;
+constexpr quint32 ID_CODEC_ID = 0x86;
+constexpr quint32 ID_CODEC_PRIVATE = 0x63A2;
+constexpr quint32 ID_DEFAULT_DURATION = 0x23E383;
+constexpr quint32 ID_VIDEO = 0xE0;
+constexpr quint32 ID_PIXEL_WIDTH = 0xB0;
+constexpr quint32 ID_PIXEL_HEIGHT = 0xBA;
+constexpr quint32 ID_CLUSTER = 0x1F43B675;
+constexpr quint32 ID_TIMECODE = 0xE7;
+constexpr quint32 ID_SIMPLE_BLOCK = 0xA3;
+constexpr quint32 ID_BLOCK_GROUP = 0xA0;
+constexpr quint32 ID_BLOCK = 0xA1;
+constexpr quint32 ID_REFERENCE_BLOCK = 0xFB;
+
+constexpr quint64 TRACK_TYPE_VIDEO = 1;
+constexpr qint64 MATROSKA_EPOCH_MS = 978307200000LL;   // 2001-01-01T00:00:00Z
+constexpr quint8 FLAG_KEYFRAME = 0x80;
+constexpr quint8 FLAG_LACING = 0x06;
+
+constexpr quint32 SIDECAR_MAGIC = 0x43554958;   // "CUIX"
+constexpr quint32 SIDECAR_VERSION = 1;
+
+} // namespace
+
+bool MatroskaReader::open(const QString& path) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_fileSize = m_file.size();
+
+    Element header;
+    Element segment;
+    if (!readElement(0, header) || header.id != ID_EBML || header.size < 0 ||
+        !readElement(header.dataStart + header.size, segment) || segment.id != ID_SEGMENT) {
+        m_error = QStringLiteral("Not a Matroska file");
+        close();
+        return false;
+    }
+
+    const qint64 end = segment.size < 0 ? m_fileSize
+                                        : qMin(m_fileSize, segment.dataStart + segment.size);
+    bool clustersReached = false;
+    qint64 offset = segment.dataStart;
+    while (offset < end) {
+        Element element;
+        if (!readElement(offset, element)) break;
+        qint64 next = element.size < 0 ? end : element.dataStart + element.size;
+
+        if (element.id == ID_INFO) {
+            parseInfo(element);
+        } else if (element.id == ID_TRACKS) {
+            parseTracks(element);
+        } else if (element.id == ID_CLUSTER) {
+            // Headers come before the clusters; past here only blocks matter
+            if (!clustersReached) {
+                clustersReached = true;
+                if (m_videoTrack == 0) break;
+                if (loadSidecar()) {
+                    m_indexFromSidecar = true;
+                    break;
+                }
+            }
+            scanCluster(element, end, next);
+        }
+
+        if (next <= offset) break;
+        offset = next;
+    }
+
+    if (m_videoTrack == 0) {
+        m_error = QStringLiteral("No video track");
+        close();
+        return false;
+    }
+    finishIndex();
+    if (!m_indexFromSidecar) saveSidecar();
+    return true;
+}
+
+void MatroskaReader::close() {
+    m_file.close();
+    m_fileSize = 0;
+    m_codecId.clear();
+    m_codecPrivate.clear();
+    m_frameSize = QSize();
+    m_fps = 0.0;
+    m_videoTrack = 0;
+    m_timecodeScale = 1000000;
+    m_durationTicks = 0.0;
+    m_durationMs = 0;
+    m_startTimeUtcMs = 0;
+    m_index.clear();
+    m_keyframes.clear();
+    m_indexFromSidecar = false;
+}
+
+int MatroskaReader::keyframeAtOrBefore(qint64 timeMs) const {
+    if (m_keyframes.isEmpty()) return 0;
+    auto it = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), timeMs,
+        [this](qint64 time, int packet) { return time < m_index[packet].timeMs; });
+    return it == m_keyframes.cbegin() ? m_keyframes.first() : *(it - 1);
+}
+
+int MatroskaReader::keyframeAfter(int packet, qint64 timeMs) const {
+    auto it = std::upper_bound(m_keyframes.cbegin(), m_keyframes.cend(), packet);
+    it = std::lower_bound(it, m_keyframes.cend(), timeMs,
+        [this](int candidate, qint64 time) { return m_index[candidate].timeMs < time; });
+    return it == m_keyframes.cend() ? m_index.size() : *it;
+}
+
+bool MatroskaReader::readPacket(int packet, QByteArray& data) {
+    if (packet < 0 || packet >= m_index.size() || !m_file.isOpen()) return false;
+    const IndexEntry& entry = m_index[packet];
+    data.resize(entry.size);
+    return m_file.seek(entry.offset) && m_file.read(data.data(), entry.size) == entry.size;
+}
+
+QString MatroskaReader::decoderCodec(const QString& codecId) {
+    if (codecId == QLatin1String("V_MJPEG")) return QStringLiteral("MJPEG");
+    if (codecId == QLatin1String("V_MPEG4/ISO/AVC")) return QStringLiteral("H264");
+    if (codecId == QLatin1String("V_MPEGH/ISO/HEVC")) return QStringLiteral("H265");
+    return codecId.startsWith(QLatin1String("V_")) ? codecId.mid(2) : codecId;
+}
+
+bool MatroskaReader::readVint(qint64& offset, quint64& value, int& length, bool keepMarker) {
+    uchar bytes[8];
+    if (!m_file.seek(offset)) return false;
+    const qint64 got = m_file.read(reinterpret_cast<char*>(bytes), sizeof bytes);
+    if (got <= 0 || bytes[0] == 0) return false;
+
+    length = 1;
+    while (!(bytes[0] & (0x80 >> (length - 1)))) ++length;
+    if (length > got) return false;
+
+    value = keepMarker ? bytes[0] : (bytes[0] & (0xFF >> length));
+    for (int i = 1; i < length; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    offset += length;
+    return true;
+}
+
+bool MatroskaReader::readElement(qint64 offset, Element& element) {
+    quint64 id = 0;
+    quint64 size = 0;
+    int idLength = 0;
+    int sizeLength = 0;
+    if (!readVint(offset, id, idLength, true) || idLength > 4) return false;
+    if (!readVint(offset, size, sizeLength, false)) return false;
+
+    element.id = static_cast<quint32>(id);
+    element.idLength = idLength;
+    element.dataStart = offset;
+    // All value bits set means "unknown"
+    const quint64 unknown = (quint64(1) << (7 * sizeLength)) - 1;
+    element.size = size == unknown ? -1 : static_cast<qint64>(size);
+    return true;
+}
+
+bool MatroskaReader::readBytes(qint64 offset, int count, QByteArray& out) {
+    if (!m_file.seek(offset)) return false;
+    out = m_file.read(count);
+    return out.size() == count;
+}
+
+quint64 MatroskaReader::readUInt(const Element& element) {
+    QByteArray bytes;
+    if (element.size <= 0 || element.size > 8 ||
+        !readBytes(element.dataStart, static_cast<int>(element.size), bytes)) {
+        return 0;
+    }
+    quint64 value = 0;
+    for (char byte : bytes) {
+        value = (value << 8) | static_cast<quint8>(byte);
+    }
+    return value;
+}
+
+void MatroskaReader::forEachChild(const Element& parent,
+                                  const std::function<void(const Element&)>& visit) {
+    if (parent.size < 0) return;
+    const qint64 end = qMin(m_fileSize, parent.dataStart + parent.size);
+    qint64 offset = parent.dataStart;
+    while (offset < end) {
+        Element child;
+        if (!readElement(offset, child) || child.size < 0) return;
+        visit(child);
+        offset = child.dataStart + child.size;
+    }
+}
+
+void MatroskaReader::parseInfo(const Element& info) {
+    forEachChild(info, [this](const Element& child) {
+        QByteArray bytes;
+        switch (child.id) {
+        case ID_TIMECODE_SCALE:
+            m_timecodeScale = qMax<quint64>(1, readUInt(child));
+            break;
+        case ID_DURATION:
+            if (child.size == 4 && readBytes(child.dataStart, 4, bytes)) {
+                const quint32 bits = qFromBigEndian<quint32>(bytes.constData());
+                float value;
+                std::memcpy(&value, &bits, sizeof value);
+                m_durationTicks = value;
+            } else if (child.size == 8 && readBytes(child.dataStart, 8, bytes)) {
+                const quint64 bits = qFromBigEndian<quint64>(bytes.constData());
+                std::memcpy(&m_durationTicks, &bits, sizeof m_durationTicks);
+            }
+            break;
+        case ID_DATE_UTC:
+            if (child.size == 8 && readBytes(child.dataStart, 8, bytes)) {
+                const qint64 ns = qFromBigEndian<qint64>(bytes.constData());
+                m_startTimeUtcMs = MATROSKA_EPOCH_MS + ns / 1000000;
+            }
+            break;
+        default:
+            break;
+        }
+    });
+}
+
+void MatroskaReader::parseTracks(const Element& tracks) {
+    forEachChild(tracks, [this](const Element& entry) {
+        if (entry.id != ID_TRACK_ENTRY || m_videoTrack != 0) return;
+
+        quint64 number = 0;
+        quint64 type = 0;
+        quint64 defaultDurationNs = 0;
+        QString codecId;
+        QByteArray codecPrivate;
+        QSize size;
+        forEachChild(entry, [&](const Element& child) {
+            QByteArray bytes;
+            switch (child.id) {
+            case ID_TRACK_NUMBER: number = readUInt(child); break;
+            case ID_TRACK_TYPE: type = readUInt(child); break;
+            case ID_DEFAULT_DURATION: defaultDurationNs = readUInt(child); break;
+            case ID_CODEC_ID:
+                if (readBytes(child.dataStart, static_cast<int>(child.size), bytes)) {
+                    codecId = QString::fromUtf8(bytes).trimmed();
+                }
+                break;
+            case ID_CODEC_PRIVATE:
+                readBytes(child.dataStart, static_cast<int>(child.size), codecPrivate);
+                break;
+            case ID_VIDEO:
+                forEachChild(child, [&](const Element& video) {
+                    if (video.id == ID_PIXEL_WIDTH) size.setWidth(static_cast<int>(readUInt(video)));
+                    if (video.id == ID_PIXEL_HEIGHT) size.setHeight(static_cast<int>(readUInt(video)));
+                });
+                break;
+            default:
+                break;
+            }
+        });
+
+        if (type != TRACK_TYPE_VIDEO || number == 0) return;
+        m_videoTrack = number;
+        m_codecId = codecId;
+        m_codecPrivate = codecPrivate;
+        m_frameSize = size;
+        if (defaultDurationNs > 0) m_fps = 1e9 / defaultDurationNs;
+    });
+}
+
+void MatroskaReader::scanCluster(const Element& cluster, qint64 end, qint64& next) {
+    const qint64 clusterEnd = cluster.size < 0 ? end : qMin(end, cluster.dataStart + cluster.size);
+    qint64 clusterTime = 0;
+    qint64 offset = cluster.dataStart;
+
+    while (offset < clusterEnd) {
+        Element child;
+        if (!readElement(offset, child)) {
+            next = end;    // Cut short mid-header
+            return;
+        }
+        // Top-level IDs are four bytes, cluster children shorter
+        if (cluster.size < 0 && child.idLength == 4) break;
+        if (child.size < 0 || child.dataStart + child.size > m_fileSize) {
+            next = end;    // A block the writer never finished
+            return;
+        }
+
+        if (child.id == ID_TIMECODE) {
+            clusterTime = static_cast<qint64>(readUInt(child));
+        } else if (child.id == ID_SIMPLE_BLOCK) {
+            addBlock(child.dataStart, child.size, clusterTime, true, false);
+        } else if (child.id == ID_BLOCK_GROUP) {
+            Element block;
+            bool referenced = false;
+            forEachChild(child, [&](const Element& part) {
+                if (part.id == ID_BLOCK) block = part;
+                if (part.id == ID_REFERENCE_BLOCK) referenced = true;
+            });
+            if (block.id == ID_BLOCK) {
+                addBlock(block.dataStart, block.size, clusterTime, false, !referenced);
+            }
+        }
+        offset = child.dataStart + child.size;
+    }
+
+    if (cluster.size < 0) next = offset;
+}
+
+void MatroskaReader::addBlock(qint64 offset, qint64 size, qint64 clusterTime, bool simple,
+                              bool keyframe) {
+    const qint64 blockEnd = offset + size;
+    quint64 track = 0;
+    int length = 0;
+    if (!readVint(offset, track, length, false) || track != m_videoTrack) return;
+
+    QByteArray header;
+    if (!readBytes(offset, 3, header)) return;
+    const quint8 flags = static_cast<quint8>(header[2]);
+    if (flags & FLAG_LACING) return;
+
+    const qint16 relative = static_cast<qint16>((static_cast<quint8>(header[0]) << 8) |
+                                                static_cast<quint8>(header[1]));
+    IndexEntry entry;
+    entry.offset = offset + 3;
+    entry.size = static_cast<int>(blockEnd - entry.offset);
+    if (entry.size <= 0) return;
+    entry.timeMs = static_cast<qint64>((clusterTime + relative) * (m_timecodeScale / 1e6));
+    entry.keyframe = simple ? (flags & FLAG_KEYFRAME) != 0 : keyframe;
+    m_index.append(entry);
+}
+
+void MatroskaReader::finishIndex() {
+    m_keyframes.clear();
+    qint64 lastMs = 0;
+    for (int i = 0; i < m_index.size(); ++i) {
+        if (m_index[i].keyframe) m_keyframes.append(i);
+        lastMs = qMax(lastMs, m_index[i].timeMs);
+    }
+
+    // A recording that never closed has no duration written, and a copy
+    // cut short one longer than what is left
+    m_durationMs = static_cast<qint64>(m_durationTicks * (m_timecodeScale / 1e6));
+    if (m_durationMs <= 0 || (!m_index.isEmpty() && m_durationMs > lastMs)) m_durationMs = lastMs;
+
+    if (m_fps <= 0.0 && m_index.size() > 1 && lastMs > m_index.first().timeMs) {
+        m_fps = (m_index.size() - 1) * 1000.0 / (lastMs - m_index.first().timeMs);
+    }
+}
+
+bool MatroskaReader::loadSidecar() {
+    QFile file(indexPath(m_file.fileName()));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 fileSize = 0;
+    qint64 modifiedMs = 0;
+    quint64 track = 0;
+    qint32 count = 0;
+    in >> magic >> version >> fileSize >> modifiedMs >> track >> count;
+
+    // Stale once the recording changes, or if it indexes another track
+    const qint64 currentModifiedMs = QFileInfo(m_file).lastModified().toMSecsSinceEpoch();
+    if (in.status() != QDataStream::Ok || magic != SIDECAR_MAGIC || version != SIDECAR_VERSION ||
+        fileSize != m_fileSize || modifiedMs != currentModifiedMs || track != m_videoTrack ||
+        count < 0) {
+        return false;
+    }
+
+    QVector<IndexEntry> index;
+    index.reserve(count);
+    for (qint32 i = 0; i < count; ++i) {
+        IndexEntry entry;
+        qint32 size = 0;
+        in >> entry.offset >> size >> entry.timeMs >> entry.keyframe;
+        entry.size = size;
+        if (in.status() != QDataStream::Ok || entry.size <= 0 ||
+            entry.offset < 0 || entry.offset + entry.size > m_fileSize) {
+            return false;
+        }
+        index.append(entry);
+    }
+    m_index = std::move(index);
+    return true;
+}
+
+void MatroskaReader::saveSidecar() const {
+    // Best effort; replay media may well be read-only
+    QSaveFile file(indexPath(m_file.fileName()));
+    if (!file.open(QIODevice::WriteOnly)) return;
+
+    QDataStream out(&file);
+    out << SIDECAR_MAGIC << SIDECAR_VERSION << m_fileSize
+        << QFileInfo(m_file).lastModified().toMSecsSinceEpoch()
+        << m_videoTrack << static_cast<qint32>(m_index.size());
+    for (const IndexEntry& entry : m_index) {
+        out << entry.offset << static_cast<qint32>(entry.size) << entry.timeMs << entry.keyframe;
+    }
+    if (out.status() == QDataStream::Ok) {
+        file.commit();
+    }
+}
+
+} // namespace CounterUAS
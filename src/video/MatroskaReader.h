@@ -0,0 +1,112 @@
+#ifndef MATROSKAREADER_H
+#define MATROSKAREADER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+namespace CounterUAS {
+
+/**
+ * @brief Packet index and reader for one video track of a Matroska file
+ *
+ * open() reads the headers, then takes the packet index from the sidecar
+ * next to the file (indexPath()) when it matches the file's size and
+ * modification time, or scans the clusters for it and writes the sidecar
+ * for next time. The scan reads element headers only and seeks over the
+ * payloads; clusters of unknown size, as a recording cut short leaves
+ * them, end at the next top-level element.
+ *
+ * Entries are in file (decode) order. Only the video track is indexed;
+ * laced blocks are skipped. readPacket() is for one thread at a time.
+ */
+class MatroskaReader {
+public:
+    struct IndexEntry {
+        qint64 offset = 0;      // File offset of the payload
+        int size = 0;
+        qint64 timeMs = 0;      // From the file's time zero
+        bool keyframe = false;
+    };
+
+    MatroskaReader() = default;
+
+    MatroskaReader(const MatroskaReader&) = delete;
+    MatroskaReader& operator=(const MatroskaReader&) = delete;
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    QString codecId() const { return m_codecId; }
+    QByteArray codecPrivate() const { return m_codecPrivate; }
+    QSize frameSize() const { return m_frameSize; }
+    double fps() const { return m_fps; }
+    qint64 durationMs() const { return m_durationMs; }
+    qint64 startTimeUtcMs() const { return m_startTimeUtcMs; }   // 0 when not recorded
+
+    const QVector<IndexEntry>& index() const { return m_index; }
+    int packetCount() const { return m_index.size(); }
+    int keyframeCount() const { return m_keyframes.size(); }
+    bool indexFromSidecar() const { return m_indexFromSidecar; }
+
+    // Index of the last keyframe at or before timeMs, the first if none
+    int keyframeAtOrBefore(qint64 timeMs) const;
+    // Index of the first keyframe after packet with a time at or after timeMs
+    int keyframeAfter(int packet, qint64 timeMs) const;
+
+    bool readPacket(int packet, QByteArray& data);
+
+    QString path() const { return m_file.fileName(); }
+    QString errorString() const { return m_error; }
+
+    static QString indexPath(const QString& path) { return path + QStringLiteral(".idx"); }
+    // The VideoDecoder codec name for a Matroska CodecID
+    static QString decoderCodec(const QString& codecId);
+
+private:
+    struct Element {
+        quint32 id = 0;
+        qint64 dataStart = 0;
+        qint64 size = -1;       // -1 for unknown
+        int idLength = 0;
+    };
+
+    bool readElement(qint64 offset, Element& element);
+    bool readVint(qint64& offset, quint64& value, int& length, bool keepMarker);
+    bool readBytes(qint64 offset, int count, QByteArray& out);
+    quint64 readUInt(const Element& element);
+    void forEachChild(const Element& parent, const std::function<void(const Element&)>& visit);
+    void parseInfo(const Element& info);
+    void parseTracks(const Element& tracks);
+    void scanCluster(const Element& cluster, qint64 end, qint64& next);
+    void addBlock(qint64 offset, qint64 size, qint64 clusterTime, bool simple, bool keyframe);
+    bool loadSidecar();
+    void saveSidecar() const;
+    void finishIndex();
+
+    QFile m_file;
+    QString m_error;
+    qint64 m_fileSize = 0;
+
+    QString m_codecId;
+    QByteArray m_codecPrivate;
+    QSize m_frameSize;
+    double m_fps = 0.0;
+    quint64 m_videoTrack = 0;
+    quint64 m_timecodeScale = 1000000;   // Nanoseconds per tick
+    double m_durationTicks = 0.0;
+    qint64 m_durationMs = 0;
+    qint64 m_startTimeUtcMs = 0;
+
+    QVector<IndexEntry> m_index;
+    QVector<int> m_keyframes;            // Into m_index
+    bool m_indexFromSidecar = false;
+};
+
+} // namespace CounterUAS
+
+#endif // MATROSKAREADER_H
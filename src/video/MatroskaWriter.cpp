@@ -0,0 +1,429 @@
+#include "video/MatroskaWriter.h"
+#include <QtEndian>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <linux/falloc.h>
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+// Element IDs carry their own length marker and are written as is
+constexpr quint32 ID_EBML = 0x1A45DFA3;
+constexpr quint32 ID_EBML_VERSION = 0x4286;
+constexpr quint32 ID_EBML_READ_VERSION = 0x42F7;
+constexpr quint32 ID_EBML_MAX_ID_LENGTH = 0x42F2;
+constexpr quint32 ID_EBML_MAX_SIZE_LENGTH = 0x42F3;
+constexpr quint32 ID_DOC_TYPE = 0x4282;
+constexpr quint32 ID_DOC_TYPE_VERSION = 0x4287;
+constexpr quint32 ID_DOC_TYPE_READ_VERSION = 0x4285;
+constexpr quint32 ID_SEGMENT = 0x18538067;
+constexpr quint32 ID_INFO = 0x1549A966;
+constexpr quint32 ID_TIMECODE_SCALE = 0x2AD7B1;
+constexpr quint32 ID_DURATION = 0x4489;
+constexpr quint32 ID_DATE_UTC = 0x4461;
+constexpr quint32 ID_MUXING_APP = 0x4D80;
+constexpr quint32 ID_WRITING_APP = 0x5741;
+constexpr quint32 ID_TRACKS = 0x1654AE6B;
+constexpr quint32 ID_TRACK_ENTRY = 0xAE;
+constexpr quint32 ID_TRACK_NUMBER = 0xD7;
+constexpr quint32 ID_TRACK_UID = 0x73C5;
+constexpr quint32 ID_TRACK_TYPE = 0x83;
+constexpr quint32 ID_FLAG_LACING = 0x9C;
+constexpr quint32 ID_NAME = 0x536E;
+constexpr quint32 ID_CODEC_ID = 0x86;
+constexpr quint32 ID_CODEC_PRIVATE = 0x63A2;
+constexpr quint32 ID_DEFAULT_DURATION = 0x23E383;
+constexpr quint32 ID_VIDEO = 0xE0;
+constexpr quint32 ID_PIXEL_WIDTH = 0xB0;
+constexpr quint32 ID_PIXEL_HEIGHT = 0xBA;
+constexpr quint32 ID_CLUSTER = 0x1F43B675;
+constexpr quint32 ID_TIMECODE = 0xE7;
+constexpr quint32 ID_SIMPLE_BLOCK = 0xA3;
+constexpr quint32 ID_BLOCK_GROUP = 0xA0;
+constexpr quint32 ID_BLOCK = 0xA1;
+constexpr quint32 ID_BLOCK_DURATION = 0x9B;
+constexpr quint32 ID_VOID = 0xEC;
+
+constexpr quint64 TRACK_TYPE_VIDEO = 1;
+constexpr quint64 TRACK_TYPE_SUBTITLE = 0x11;
+constexpr quint64 TRACK_TYPE_METADATA = 0x21;
+constexpr qint64 CLUSTER_MIN_MS = 1000;
+constexpr qint64 CLUSTER_MAX_MS = 30000;    // Block times are signed 16-bit offsets
+constexpr qint64 MATROSKA_EPOCH_MS = 978307200000LL;   // 2001-01-01T00:00:00Z
+
+// The largest 8-byte size is reserved for "unknown"
+const char UNKNOWN_SIZE[8] = {'\x01', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF', '\xFF'};
+
+void appendId(QByteArray& out, quint32 id) {
+    bool started = false;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        const char byte = static_cast<char>((id >> shift) & 0xFF);
+        if (byte != 0 || started || shift == 0) {
+            out.append(byte);
+            started = true;
+        }
+    }
+}
+
+void appendSize(QByteArray& out, quint64 size) {
+    int length = 1;
+    // All-ones values are reserved at every length
+    while (length < 8 && size >= (quint64(1) << (7 * length)) - 1) ++length;
+    for (int i = length - 1; i >= 0; --i) {
+        quint8 byte = static_cast<quint8>((size >> (8 * i)) & 0xFF);
+        if (i == length - 1) byte |= static_cast<quint8>(0x80 >> (length - 1));
+        out.append(static_cast<char>(byte));
+    }
+}
+
+void appendElement(QByteArray& out, quint32 id, const QByteArray& payload) {
+    appendId(out, id);
+    appendSize(out, static_cast<quint64>(payload.size()));
+    out.append(payload);
+}
+
+void appendUInt(QByteArray& out, quint32 id, quint64 value) {
+    QByteArray payload;
+    int bytes = 1;
+    while (bytes < 8 && (value >> (8 * bytes)) != 0) ++bytes;
+    for (int i = bytes - 1; i >= 0; --i) {
+        payload.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+    appendElement(out, id, payload);
+}
+
+void appendDouble(QByteArray& out, quint32 id, double value) {
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    QByteArray payload(8, '\0');
+    qToBigEndian(bits, payload.data());
+    appendElement(out, id, payload);
+}
+
+void appendString(QByteArray& out, quint32 id, const QString& value) {
+    appendElement(out, id, value.toUtf8());
+}
+
+// An 8-byte size field: 0x01 marker then 56 bits of size
+void sizeField(char* field, qint64 size) {
+    field[0] = '\x01';
+    for (int i = 1; i < 8; ++i) {
+        field[i] = static_cast<char>((static_cast<quint64>(size) >> (8 * (7 - i))) & 0xFF);
+    }
+}
+
+// A recycled file reads as zeros afterwards, so a crash cannot leave its
+// old clusters after the new ones
+bool preallocate(QFile& file, qint64 bytes) {
+    if (file.size() > bytes && !file.resize(bytes)) return false;
+#if defined(Q_OS_LINUX)
+    // Zeroing a range only marks its extents unwritten; the blocks stay
+    // where they are. posix_fallocate() allocates them, where resize()
+    // would leave the file sparse
+    const qint64 old = file.size();
+    if (old > 0 && fallocate(file.handle(), FALLOC_FL_ZERO_RANGE, 0, old) != 0 && !file.resize(0)) {
+        return false;
+    }
+    return posix_fallocate(file.handle(), 0, bytes) == 0;
+#else
+    if (file.size() > 0 && !file.resize(0)) return false;
+    return file.resize(bytes);
+#endif
+}
+
+QByteArray blockHeader(quint64 track, qint64 relativeMs, quint8 flags) {
+    QByteArray header;
+    appendSize(header, track);
+    const qint16 offset = static_cast<qint16>(relativeMs);
+    header.append(static_cast<char>((offset >> 8) & 0xFF));
+    header.append(static_cast<char>(offset & 0xFF));
+    header.append(static_cast<char>(flags));
+    return header;
+}
+
+} // namespace
+
+MatroskaWriter::~MatroskaWriter() {
+    close();
+}
+
+bool MatroskaWriter::open(const QString& path, const TrackInfo& track) {
+    close();
+    m_track = track;
+    m_bytesWritten = 0;
+    m_reserved = 0;
+    m_buffer.clear();
+    m_clusterSizeOffset = -1;
+    m_keyClusterOffset = -1;
+    m_keyClusterTimeMs = 0;
+    m_firstTimeMs = -1;
+    m_lastTimeMs = 0;
+
+    // A reserved file is written over in place, so a recycled one keeps its
+    // blocks; whole-block writes need no second buffer in QFile
+    QIODevice::OpenMode mode = m_reserve > 0 ? QIODevice::ReadWrite
+                                             : QIODevice::WriteOnly | QIODevice::Truncate;
+    if (m_blockBytes > 0) mode |= QIODevice::Unbuffered;
+    m_file.setFileName(path);
+    if (!m_file.open(mode)) return false;
+    if (m_reserve > 0) {
+        if (preallocate(m_file, m_reserve)) {
+            m_reserved = m_reserve;
+        } else if (!m_file.resize(0)) {
+            m_file.close();
+            return false;
+        }
+    }
+    if (m_blockBytes > 0) m_buffer.reserve(2 * m_blockBytes);
+
+    QByteArray header;
+    QByteArray ebml;
+    appendUInt(ebml, ID_EBML_VERSION, 1);
+    appendUInt(ebml, ID_EBML_READ_VERSION, 1);
+    appendUInt(ebml, ID_EBML_MAX_ID_LENGTH, 4);
+    appendUInt(ebml, ID_EBML_MAX_SIZE_LENGTH, 8);
+    appendString(ebml, ID_DOC_TYPE, "matroska");
+    appendUInt(ebml, ID_DOC_TYPE_VERSION, 4);
+    appendUInt(ebml, ID_DOC_TYPE_READ_VERSION, 2);
+    appendElement(header, ID_EBML, ebml);
+
+    appendId(header, ID_SEGMENT);
+    m_segmentSizeOffset = header.size();
+    header.append(UNKNOWN_SIZE, sizeof UNKNOWN_SIZE);
+    m_segmentDataStart = header.size();
+
+    QByteArray info;
+    appendUInt(info, ID_TIMECODE_SCALE, 1000000);    // Block times in milliseconds
+    appendString(info, ID_MUXING_APP, "CounterUAS MatroskaWriter");
+    appendString(info, ID_WRITING_APP, "CounterUAS C2");
+    if (track.startTimeUtcMs > 0) {
+        // Signed nanoseconds from the Matroska epoch
+        const qint64 ns = (track.startTimeUtcMs - MATROSKA_EPOCH_MS) * 1000000;
+        QByteArray date(8, '\0');
+        qToBigEndian(ns, date.data());
+        appendElement(info, ID_DATE_UTC, date);
+    }
+    appendDouble(info, ID_DURATION, 0.0);
+    // The duration's payload is the last 8 bytes of the Info body
+    const qint64 infoStart = header.size();
+    appendElement(header, ID_INFO, info);
+    m_durationOffset = infoStart + (header.size() - infoStart) - 8;
+
+    QByteArray tracks;
+    QByteArray video;
+    appendUInt(video, ID_TRACK_NUMBER, VIDEO_TRACK);
+    appendUInt(video, ID_TRACK_UID, VIDEO_TRACK);
+    appendUInt(video, ID_TRACK_TYPE, TRACK_TYPE_VIDEO);
+    appendUInt(video, ID_FLAG_LACING, 0);
+    appendString(video, ID_CODEC_ID, track.codecId);
+    if (!track.codecPrivate.isEmpty()) {
+        appendElement(video, ID_CODEC_PRIVATE, track.codecPrivate);
+    }
+    if (track.fps > 0.0) {
+        appendUInt(video, ID_DEFAULT_DURATION, static_cast<quint64>(1e9 / track.fps));
+    }
+    QByteArray dimensions;
+    appendUInt(dimensions, ID_PIXEL_WIDTH, static_cast<quint64>(qMax(0, track.width)));
+    appendUInt(dimensions, ID_PIXEL_HEIGHT, static_cast<quint64>(qMax(0, track.height)));
+    appendElement(video, ID_VIDEO, dimensions);
+    appendElement(tracks, ID_TRACK_ENTRY, video);
+
+    if (track.metadataTrack) {
+        QByteArray metadata;
+        appendUInt(metadata, ID_TRACK_NUMBER, METADATA_TRACK);
+        appendUInt(metadata, ID_TRACK_UID, METADATA_TRACK);
+        appendUInt(metadata, ID_TRACK_TYPE, TRACK_TYPE_SUBTITLE);
+        appendUInt(metadata, ID_FLAG_LACING, 0);
+        appendString(metadata, ID_NAME, "metadata");
+        appendString(metadata, ID_CODEC_ID, "S_TEXT/UTF8");
+        appendElement(tracks, ID_TRACK_ENTRY, metadata);
+    }
+    if (track.klvTrack) {
+        QByteArray klv;
+        appendUInt(klv, ID_TRACK_NUMBER, KLV_TRACK);
+        appendUInt(klv, ID_TRACK_UID, KLV_TRACK);
+        appendUInt(klv, ID_TRACK_TYPE, TRACK_TYPE_METADATA);
+        appendUInt(klv, ID_FLAG_LACING, 0);
+        appendString(klv, ID_NAME, "klv");
+        appendString(klv, ID_CODEC_ID, "D_SMPTE336M");
+        appendElement(tracks, ID_TRACK_ENTRY, klv);
+    }
+    appendElement(header, ID_TRACKS, tracks);
+
+    if (!write(header)) {
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+void MatroskaWriter::close() {
+    if (!m_file.isOpen()) return;
+
+    finishCluster();
+
+    // What is left of the reservation becomes a Void element, so the
+    // segment runs to the end of the file
+    qint64 end = m_bytesWritten;
+    const qint64 spare = m_reserved - m_bytesWritten;
+    if (spare >= 2) {
+        QByteArray padding;
+        appendId(padding, ID_VOID);
+        if (spare >= 9) {
+            char field[8];
+            sizeField(field, spare - 9);
+            padding.append(field, sizeof field);
+        } else {
+            appendSize(padding, static_cast<quint64>(spare - 2));
+        }
+        if (write(padding)) end = m_reserved;
+    }
+    patchSize(m_segmentSizeOffset, end - m_segmentDataStart);
+
+    const double duration = static_cast<double>(m_lastTimeMs);
+    quint64 bits;
+    std::memcpy(&bits, &duration, sizeof bits);
+    char payload[8];
+    qToBigEndian(bits, payload);
+    overwrite(m_durationOffset, payload, sizeof payload);
+
+    flushBlocks(m_buffer.size());
+    if (m_file.size() > end) m_file.resize(end);    // A byte too few for a Void
+    m_file.close();
+    m_buffer.clear();
+}
+
+bool MatroskaWriter::writeVideo(const QByteArray& data, qint64 timeMs, bool keyframe) {
+    if (!isOpen()) return false;
+    const qint64 t = relativeTime(timeMs);
+
+    const qint64 sinceCluster = t - m_clusterTimeMs;
+    const bool needCluster = m_clusterSizeOffset < 0 || sinceCluster < 0 ||
+                             sinceCluster > CLUSTER_MAX_MS ||
+                             (keyframe && sinceCluster >= CLUSTER_MIN_MS);
+    if (needCluster && !startCluster(t)) return false;
+    if (keyframe && !m_clusterHasVideo) {
+        m_keyClusterOffset = m_clusterOffset;
+        m_keyClusterTimeMs = m_firstTimeMs + m_clusterTimeMs;
+    }
+    m_clusterHasVideo = true;
+
+    QByteArray block = blockHeader(VIDEO_TRACK, t - m_clusterTimeMs, keyframe ? 0x80 : 0x00);
+    block.append(data);
+    QByteArray element;
+    appendElement(element, ID_SIMPLE_BLOCK, block);
+    return write(element);
+}
+
+bool MatroskaWriter::writeMetadata(const QByteArray& text, qint64 timeMs, qint64 durationMs) {
+    if (!isOpen() || !m_track.metadataTrack) return false;
+    const qint64 t = relativeTime(timeMs);
+    if (!ensureCluster(t)) return false;
+
+    QByteArray block = blockHeader(METADATA_TRACK, t - m_clusterTimeMs, 0x00);
+    block.append(text);
+    QByteArray group;
+    appendElement(group, ID_BLOCK, block);
+    appendUInt(group, ID_BLOCK_DURATION, static_cast<quint64>(qMax<qint64>(1, durationMs)));
+    QByteArray element;
+    appendElement(element, ID_BLOCK_GROUP, group);
+    return write(element);
+}
+
+bool MatroskaWriter::writeKlv(const QByteArray& packet, qint64 timeMs) {
+    if (!isOpen() || !m_track.klvTrack) return false;
+    const qint64 t = relativeTime(timeMs);
+    if (!ensureCluster(t)) return false;
+
+    // Each packet stands alone, so every block is a keyframe
+    QByteArray block = blockHeader(KLV_TRACK, t - m_clusterTimeMs, 0x80);
+    block.append(packet);
+    QByteArray element;
+    appendElement(element, ID_SIMPLE_BLOCK, block);
+    return write(element);
+}
+
+// Blocks other than video start a cluster only when their time does not fit
+bool MatroskaWriter::ensureCluster(qint64 relativeMs) {
+    const qint64 sinceCluster = relativeMs - m_clusterTimeMs;
+    if (m_clusterSizeOffset >= 0 && sinceCluster >= 0 && sinceCluster <= CLUSTER_MAX_MS) return true;
+    return startCluster(relativeMs);
+}
+
+bool MatroskaWriter::write(const QByteArray& bytes) {
+    if (m_blockBytes <= 0) {
+        const qint64 written = m_file.write(bytes);
+        if (written != bytes.size()) return false;
+        m_bytesWritten += written;
+        return true;
+    }
+
+    // Whole blocks only, so every write starts and ends on a block boundary
+    m_buffer.append(bytes);
+    m_bytesWritten += bytes.size();
+    const int whole = m_buffer.size() / m_blockBytes * m_blockBytes;
+    return whole == 0 || flushBlocks(whole);
+}
+
+bool MatroskaWriter::flushBlocks(int bytes) {
+    if (bytes <= 0) return true;
+    const qint64 written = m_file.write(m_buffer.constData(), bytes);
+    if (written != bytes) return false;
+    m_buffer.remove(0, bytes);
+    return true;
+}
+
+void MatroskaWriter::overwrite(qint64 offset, const char* data, int size) {
+    // Patched in the buffer while it is still there, in the file before it
+    const qint64 buffered = m_bytesWritten - m_buffer.size();
+    const int inFile = static_cast<int>(qBound<qint64>(0, buffered - offset, size));
+    if (inFile > 0) {
+        m_file.seek(offset);
+        m_file.write(data, inFile);
+        m_file.seek(buffered);
+    }
+    if (inFile < size) {
+        std::memcpy(m_buffer.data() + (offset + inFile - buffered), data + inFile,
+                    static_cast<size_t>(size - inFile));
+    }
+}
+
+bool MatroskaWriter::startCluster(qint64 relativeMs) {
+    finishCluster();
+
+    QByteArray cluster;
+    m_clusterOffset = m_bytesWritten;
+    m_clusterHasVideo = false;
+    appendId(cluster, ID_CLUSTER);
+    m_clusterSizeOffset = m_bytesWritten + cluster.size();
+    cluster.append(UNKNOWN_SIZE, sizeof UNKNOWN_SIZE);
+    appendUInt(cluster, ID_TIMECODE, static_cast<quint64>(qMax<qint64>(0, relativeMs)));
+    m_clusterTimeMs = qMax<qint64>(0, relativeMs);
+    return write(cluster);
+}
+
+void MatroskaWriter::finishCluster() {
+    if (m_clusterSizeOffset < 0) return;
+    patchSize(m_clusterSizeOffset, m_bytesWritten - (m_clusterSizeOffset + 8));
+    m_clusterSizeOffset = -1;
+}
+
+void MatroskaWriter::patchSize(qint64 sizeOffset, qint64 size) {
+    // Keeps the 8-byte field
+    char field[8];
+    sizeField(field, size);
+    overwrite(sizeOffset, field, sizeof field);
+}
+
+qint64 MatroskaWriter::relativeTime(qint64 timeMs) {
+    if (m_firstTimeMs < 0) m_firstTimeMs = timeMs;
+    const qint64 t = qMax<qint64>(0, timeMs - m_firstTimeMs);
+    m_lastTimeMs = qMax(m_lastTimeMs, t);
+    return t;
+}
+
+} // namespace CounterUAS
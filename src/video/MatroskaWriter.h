@@ -0,0 +1,109 @@
+#ifndef MATROSKAWRITER_H
+#define MATROSKAWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace CounterUAS {
+
+/**
+ * @brief Minimal streaming Matroska (MKV) muxer
+ *
+ * Writes one video track and, optionally, a timed metadata track of UTF-8
+ * text blocks and a track of MISB ST 0601 KLV packets, one per frame. Elements are written as they arrive: the segment and each
+ * cluster start with an unknown size, which close() and the next cluster
+ * patch in, so a file cut short by a crash still plays up to its last
+ * cluster. Clusters start on keyframes at least a second apart. There is
+ * no cue index; players seek by scanning clusters.
+ *
+ * For continuous recording the file can be reserved up front: it is
+ * preallocated to its full size (a recycled file keeps its blocks) and
+ * close() turns the unused tail into a Void element, so the size on disk
+ * never changes and the extents stay contiguous. Writes can also go out
+ * in whole aligned blocks, the elements buffered until one fills and the
+ * size patches made in the buffer while they are still there; a crash
+ * then loses at most the last block, and with a reservation the file
+ * ends in zeros where the next cluster would have been.
+ *
+ * Times are milliseconds on any clock; the first frame is time zero.
+ */
+class MatroskaWriter {
+public:
+    struct TrackInfo {
+        QString codecId;            // Matroska CodecID, e.g. V_MJPEG, V_MPEG4/ISO/AVC
+        QByteArray codecPrivate;
+        int width = 0;
+        int height = 0;
+        double fps = 0.0;
+        bool metadataTrack = false;
+        bool klvTrack = false;
+        qint64 startTimeUtcMs = 0;  // Wall clock at time zero, ms since the epoch; 0 to omit
+    };
+
+    MatroskaWriter() = default;
+    ~MatroskaWriter();
+
+    MatroskaWriter(const MatroskaWriter&) = delete;
+    MatroskaWriter& operator=(const MatroskaWriter&) = delete;
+
+    // Before open(); 0 for either grows the file element by element
+    void setReserve(qint64 bytes) { m_reserve = qMax<qint64>(0, bytes); }
+    void setWriteBlockSize(int bytes) { m_blockBytes = qMax(0, bytes); }
+
+    bool open(const QString& path, const TrackInfo& track);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    bool writeVideo(const QByteArray& data, qint64 timeMs, bool keyframe);
+    bool writeMetadata(const QByteArray& text, qint64 timeMs, qint64 durationMs);
+    bool writeKlv(const QByteArray& packet, qint64 timeMs);
+
+    QString path() const { return m_file.fileName(); }
+    qint64 bytesWritten() const { return m_bytesWritten; }
+    qint64 reservedBytes() const { return m_reserved; }   // 0 if the reservation failed
+    qint64 durationMs() const { return m_lastTimeMs; }   // Of what has been written
+    // The latest cluster whose first video block is a keyframe, where a
+    // reader can start decoding: its file offset, -1 before the first, and
+    // the cluster's time on the caller's clock
+    qint64 keyClusterOffset() const { return m_keyClusterOffset; }
+    qint64 keyClusterTimeMs() const { return m_keyClusterTimeMs; }
+    QString errorString() const { return m_file.errorString(); }
+
+    static constexpr quint64 VIDEO_TRACK = 1;
+    static constexpr quint64 METADATA_TRACK = 2;
+    static constexpr quint64 KLV_TRACK = 3;
+
+private:
+    bool write(const QByteArray& bytes);
+    bool flushBlocks(int bytes);
+    void overwrite(qint64 offset, const char* data, int size);
+    bool startCluster(qint64 relativeMs);
+    void finishCluster();
+    void patchSize(qint64 sizeOffset, qint64 size);
+    qint64 relativeTime(qint64 timeMs);
+    bool ensureCluster(qint64 relativeMs);
+
+    QFile m_file;
+    TrackInfo m_track;
+    qint64 m_reserve = 0;
+    int m_blockBytes = 0;
+    qint64 m_reserved = 0;
+    QByteArray m_buffer;             // Not yet in the file; ends at m_bytesWritten
+    qint64 m_bytesWritten = 0;
+    qint64 m_segmentDataStart = 0;   // File offset of the segment's first child
+    qint64 m_segmentSizeOffset = 0;
+    qint64 m_durationOffset = 0;     // Info/Duration payload, patched on close
+    qint64 m_clusterOffset = 0;      // Of the open cluster's ID
+    qint64 m_clusterSizeOffset = -1;
+    qint64 m_clusterTimeMs = 0;
+    bool m_clusterHasVideo = false;
+    qint64 m_keyClusterOffset = -1;
+    qint64 m_keyClusterTimeMs = 0;
+    qint64 m_firstTimeMs = -1;
+    qint64 m_lastTimeMs = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // MATROSKAWRITER_H
@@ -0,0 +1,186 @@
+#include "video/MotionCueStage.h"
+#include "core/TrackManager.h"
+#include "utils/LocalTangentPlane.h"
+#include "utils/TimeUtils.h"
+#include "video/VideoStreamManager.h"
+#include <QElapsedTimer>
+#include <QtMath>
+
+namespace CounterUAS {
+
+namespace {
+
+// Angles of the box centre, linear across the field of view
+void cueAngles(const MotionCueCamera& camera, const QRect& box, const QSize& frameSize,
+               double& bearingDeg, double& elevationDeg) {
+    const double width = qMax(1, frameSize.width());
+    const double height = qMax(1, frameSize.height());
+    const double verticalFov = camera.verticalFovDeg > 0.0
+        ? camera.verticalFovDeg : camera.horizontalFovDeg * height / width;
+
+    const QPointF centre = QRectF(box).center();
+    bearingDeg = camera.headingDeg + (centre.x() / width - 0.5) * camera.horizontalFovDeg;
+    elevationDeg = camera.tiltDeg - (centre.y() / height - 0.5) * verticalFov;
+}
+
+} // namespace
+
+MotionCueStage::MotionCueStage(QObject* parent)
+    : QObject(parent)
+    , m_fuser(new CameraDetectionFuser(this))
+{
+    connect(m_fuser, &CameraDetectionFuser::detectionsFused, this, &MotionCueStage::onDetectionsFused);
+}
+
+MotionCueStage::~MotionCueStage() {
+    for (Camera& camera : m_cameras) unsubscribe(camera);
+}
+
+void MotionCueStage::setTrackManager(TrackManager* manager) {
+    m_trackManager = manager;
+}
+
+void MotionCueStage::setVideoStreamManager(VideoStreamManager* manager) {
+    for (Camera& camera : m_cameras) unsubscribe(camera);
+    m_videoManager = manager;
+    for (Camera& camera : m_cameras) subscribe(camera);
+}
+
+void MotionCueStage::setConfig(const MotionCueConfig& config) {
+    m_config = config;
+    m_fuser->setConfig(m_config.fusion);
+    // Detectors are sized by the config, and the delivery rate may change
+    for (Camera& camera : m_cameras) {
+        unsubscribe(camera);
+        camera.detector = MotionDetector(m_config.detector);
+        subscribe(camera);
+    }
+}
+
+void MotionCueStage::addCamera(const MotionCueCamera& camera) {
+    removeCamera(camera.cameraId);
+    Camera& added = m_cameras[camera.cameraId];
+    added.definition = camera;
+    added.detector = MotionDetector(m_config.detector);
+    subscribe(added);
+}
+
+void MotionCueStage::removeCamera(const QString& cameraId) {
+    auto it = m_cameras.find(cameraId);
+    if (it == m_cameras.end()) return;
+    unsubscribe(it.value());
+    m_cameras.erase(it);
+}
+
+MotionCueStats MotionCueStage::stats() const {
+    MotionCueStats stats = m_stats;
+    stats.cameras = m_cameras.size();
+    stats.fusedSightings = quint64(m_fuser->stats().sightingsMerged);
+    stats.processMeanUs = m_processLatency.meanUs;
+    stats.processMaxUs = double(m_processLatency.maxUs);
+    return stats;
+}
+
+void MotionCueStage::subscribe(Camera& camera) {
+    if (!m_videoManager || camera.subscriptionId) return;
+
+    // Native size and format: the detector reads the luma plane in place
+    VideoDeliveryPolicy policy;
+    policy.maxFps = m_config.maxFps;
+    policy.latestOnly = true;
+    const QString cameraId = camera.definition.cameraId;
+    camera.subscriptionId = m_videoManager->subscribeFrames(
+        cameraId, this, policy,
+        [this, cameraId](const VideoFrame& frame, qint64 timestamp, const QSize&) {
+            processFrame(cameraId, frame, timestamp);
+        });
+}
+
+void MotionCueStage::unsubscribe(Camera& camera) {
+    if (m_videoManager && camera.subscriptionId) m_videoManager->unsubscribeFrames(camera.subscriptionId);
+    camera.subscriptionId = 0;
+}
+
+void MotionCueStage::processFrame(const QString& cameraId, const VideoFrame& frame, qint64 timestamp) {
+    auto it = m_cameras.find(cameraId);
+    if (it == m_cameras.end() || frame.isNull()) return;
+    Camera& camera = it.value();
+    m_stats.frames++;
+    const qint64 frameNumber = ++camera.frameNumber;
+
+    QElapsedTimer timer;
+    timer.start();
+    camera.detector.process(frame, m_blobs);
+    m_processLatency.record(timer.nsecsElapsed() / 1000);
+    if (camera.detector.reseeded()) m_stats.reseeds++;
+    m_stats.blobs += m_blobs.size();
+
+    const MotionCueCamera definition = camera.definition;
+    const QSize size = frame.size();
+    const int cues = qMin(m_blobs.size(), qMax(0, m_config.maxCuesPerFrame));
+    for (int i = 0; i < cues; ++i) {
+        const MotionBlob& blob = m_blobs[i];
+
+        CameraDetection detection;
+        detection.cameraId = cameraId;
+        detection.boundingBox = QRectF(double(blob.box.x()) / size.width(),
+                                       double(blob.box.y()) / size.height(),
+                                       double(blob.box.width()) / size.width(),
+                                       double(blob.box.height()) / size.height());
+        // Filled share of the box: compact blobs over ragged clutter
+        detection.confidence = qBound(0.0, double(blob.area) / (blob.box.width() * blob.box.height()), 1.0);
+        detection.objectClass = QStringLiteral("motion");
+        detection.frameNumber = frameNumber;
+        detection.timestamp = timestamp;
+        emit cameraDetection(detection);
+
+        if (!m_trackManager) continue;
+        BoundingBox box;
+        box.x = blob.box.x();
+        box.y = blob.box.y();
+        box.width = blob.box.width();
+        box.height = blob.box.height();
+        box.cameraId = cameraId;
+        box.timestamp = timestamp;
+        if (m_config.fuseCameras) {
+            CameraSighting sighting;
+            sighting.cameraId = cameraId;
+            sighting.box = box;
+            sighting.mount = definition.mount;
+            cueAngles(definition, blob.box, size, sighting.azimuthDeg, sighting.elevationDeg);
+            sighting.estimate = cuePosition(definition, blob.box, size);
+            sighting.confidence = detection.confidence;
+            sighting.timestamp = timestamp;
+            m_fuser->addSighting(sighting, TimeUtils::monotonicNs() / 1000000);
+            continue;
+        }
+        m_trackManager->processCameraDetection(cameraId, box,
+                                               cuePosition(definition, blob.box, size), timestamp);
+        m_stats.cues++;
+    }
+}
+
+void MotionCueStage::onDetectionsFused(const QVector<FusedCameraDetection>& detections) {
+    if (!m_trackManager) return;
+    for (const FusedCameraDetection& fused : detections) {
+        m_trackManager->processCameraDetection(fused.boxes, fused.position, fused.timestamp);
+        m_stats.cues++;
+    }
+}
+
+GeoPosition MotionCueStage::cuePosition(const MotionCueCamera& camera, const QRect& box,
+                                        const QSize& frameSize) {
+    double bearing = 0.0;
+    double elevation = 0.0;
+    cueAngles(camera, box, frameSize, bearing, elevation);
+
+    const double az = qDegreesToRadians(bearing);
+    const double el = qDegreesToRadians(elevation);
+    EnuVector enu;
+    enu.east = camera.cueRangeM * std::cos(el) * std::sin(az);
+    enu.north = camera.cueRangeM * std::cos(el) * std::cos(az);
+    enu.up = camera.cueRangeM * std::sin(el);
+    return LocalTangentPlane(camera.mount).toGeoLinear(enu);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,134 @@
+#ifndef MOTIONCUESTAGE_H
+#define MOTIONCUESTAGE_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include "core/Track.h"
+#include "sensors/CameraSystem.h"
+#include "utils/LatencyStats.h"
+#include "video/CameraDetectionFuser.h"
+#include "video/MotionDetector.h"
+
+namespace CounterUAS {
+
+class TrackManager;
+class VideoStreamManager;
+
+/**
+ * @brief Where a fixed camera looks
+ */
+struct MotionCueCamera {
+    QString cameraId;
+    GeoPosition mount;
+    double headingDeg = 0.0;        // Bearing of the image centre
+    double tiltDeg = 0.0;           // Elevation of the image centre
+    double horizontalFovDeg = 60.0;
+    double verticalFovDeg = 0.0;    // 0: from the horizontal and the aspect
+    double cueRangeM = 1000.0;      // Assumed range along a blob's bearing
+};
+
+/**
+ * @brief Thresholds of motion cueing on fixed cameras
+ */
+struct MotionCueConfig {
+    MotionDetectorConfig detector;
+    int maxCuesPerFrame = 4;        // Largest blobs go to the track manager
+    double maxFps = 0.0;            // Frames looked at per camera, 0 for all
+    bool fuseCameras = false;       // Cameras with overlapping views cue one track per object
+    CameraDetectionFuserConfig fusion;
+};
+
+/**
+ * @brief Per-frame cost and outcomes of motion cueing
+ */
+struct MotionCueStats {
+    int cameras = 0;
+    quint64 frames = 0;
+    quint64 blobs = 0;
+    quint64 cues = 0;               // Given to the track manager
+    quint64 fusedSightings = 0;     // Merged into another camera's cue
+    quint64 reseeds = 0;            // Backgrounds restarted
+    double processMeanUs = 0.0;     // Per frame
+    double processMaxUs = 0.0;
+};
+
+/**
+ * @brief Cues tracks from motion seen by fixed cameras
+ *
+ * Runs a MotionDetector on every frame of each camera added, at the
+ * stream's native size and in its own pixel format, so a pooled YUV
+ * frame is read in place. The largest blobs of a frame are emitted as
+ * cameraDetection() and passed to TrackManager::processCameraDetection(),
+ * placed at cueRangeM along the blob centre's bearing and elevation:
+ * a blob near an existing camera track refreshes that track's box, any
+ * other starts a track that the threat assessor ranks and the camera
+ * scheduler can slew a PTZ camera onto.
+ *
+ * A fixed camera gives direction, not range; the position is a cue for
+ * other sensors and the PTZ cameras, not a fix. With fuseCameras, blobs
+ * go through a CameraDetectionFuser first: cameras seeing one object
+ * give one cue carrying every camera's box, placed where their rays
+ * cross, and reach the track manager up to the fusion window later.
+ *
+ * Frames arrive queued on the thread the stage lives on.
+ */
+class MotionCueStage : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MotionCueStage(QObject* parent = nullptr);
+    ~MotionCueStage() override;
+
+    void setTrackManager(TrackManager* manager);
+    void setVideoStreamManager(VideoStreamManager* manager);
+
+    void setConfig(const MotionCueConfig& config);
+    MotionCueConfig config() const { return m_config; }
+
+    void addCamera(const MotionCueCamera& camera);
+    void removeCamera(const QString& cameraId);
+    QList<QString> cameraIds() const { return m_cameras.keys(); }
+
+    MotionCueStats stats() const;
+    CameraDetectionFuser* fuser() const { return m_fuser; }
+
+    // One frame of cameraId captured at timestamp (Unix ms)
+    void processFrame(const QString& cameraId, const VideoFrame& frame, qint64 timestamp);
+
+    // Where the centre of box in a frame of frameSize is, at the cue range
+    static GeoPosition cuePosition(const MotionCueCamera& camera, const QRect& box,
+                                   const QSize& frameSize);
+
+signals:
+    void cameraDetection(const CameraDetection& detection);
+
+private slots:
+    void onDetectionsFused(const QVector<FusedCameraDetection>& detections);
+
+private:
+    struct Camera {
+        MotionCueCamera definition;
+        MotionDetector detector;
+        int subscriptionId = 0;
+        qint64 frameNumber = 0;
+    };
+
+    void subscribe(Camera& camera);
+    void unsubscribe(Camera& camera);
+
+    QPointer<TrackManager> m_trackManager;
+    QPointer<VideoStreamManager> m_videoManager;
+    CameraDetectionFuser* m_fuser;
+
+    MotionCueConfig m_config;
+    QHash<QString, Camera> m_cameras;
+    QVector<MotionBlob> m_blobs;
+    MotionCueStats m_stats;
+    LatencyStats m_processLatency;
+};
+
+} // namespace CounterUAS
+
+#endif // MOTIONCUESTAGE_H
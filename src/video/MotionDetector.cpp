@@ -0,0 +1,220 @@
+#include "video/MotionDetector.h"
+#include "video/MotionKernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+int rgbLuma(VideoPixelFormat format, const uchar* line, int x) {
+    if (format == VideoPixelFormat::RGB24) {
+        const uchar* p = line + 3 * x;
+        return (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8;
+    }
+    const quint32 word = reinterpret_cast<const quint32*>(line)[x];
+    return (77 * ((word >> 16) & 0xff) + 150 * ((word >> 8) & 0xff) + 29 * (word & 0xff)) >> 8;
+}
+
+} // namespace
+
+MotionDetector::MotionDetector(const MotionDetectorConfig& config)
+    : m_config(config)
+{
+    m_factor = 1;
+    while (m_factor < qBound(1, m_config.downscale, 16)) m_factor <<= 1;
+    m_config.downscale = m_factor;
+}
+
+void MotionDetector::reset() {
+    m_frameSize = QSize();
+    m_width = 0;
+    m_height = 0;
+    m_frames = 0;
+    m_changed = 0;
+}
+
+bool MotionDetector::process(const VideoFrame& frame, QVector<MotionBlob>& blobs) {
+    blobs.clear();
+    m_reseeded = false;
+    if (frame.isNull()) return false;
+
+    if (frame.size() != m_frameSize) {
+        m_frameSize = frame.size();
+        m_width = frame.width() / m_factor;
+        m_height = frame.height() / m_factor;
+        const int count = m_width * m_height;
+        m_luma.resize(count);
+        m_background.resize(count);
+        m_mask.fill(0, count);
+        m_scratch.resize((frame.width() / 2) * (frame.height() / 2) +
+                         (frame.width() / 4) * (frame.height() / 4));
+        m_frames = 0;
+    }
+    const int count = m_width * m_height;
+    if (count == 0) return false;
+
+    downscale(frame);
+    if (m_frames == 0) {
+        m_background = m_luma;
+        m_frames = 1;
+        m_reseeded = true;
+        return false;
+    }
+
+    ++m_frames;
+    const bool update = m_frames % quint64(qMax(1, m_config.backgroundInterval)) == 0;
+    m_changed = MotionKernels::subtract(m_luma.constData(), m_background.data(), m_mask.data(),
+                                        count, m_config.threshold, update);
+    if (m_changed > m_config.maxChangedFraction * count) {
+        // The whole view moved; start the background over from this frame
+        m_background = m_luma;
+        m_frames = 1;
+        m_reseeded = true;
+        return false;
+    }
+    if (m_frames <= quint64(qMax(0, m_config.warmupFrames))) return false;
+
+    if (m_changed > 0) findBlobs(blobs);
+    return true;
+}
+
+void MotionDetector::downscale(const VideoFrame& frame) {
+    if (!frame.isYuv()) {
+        reduceRgb(frame);
+        return;
+    }
+
+    const uchar* src = frame.constBits(0);
+    int stride = frame.bytesPerLine(0);
+    if (m_factor == 1) {
+        for (int y = 0; y < m_height; ++y) {
+            std::memcpy(m_luma.data() + y * m_width, src + y * stride, size_t(m_width));
+        }
+        return;
+    }
+
+    // Halve until the factor is reached, alternating between two scratch
+    // areas; the last halving lands in m_luma
+    uchar* areas[2] = {m_scratch.data(), m_scratch.data() + (frame.width() / 2) * (frame.height() / 2)};
+    int width = frame.width();
+    int height = frame.height();
+    int area = 0;
+    for (int step = m_factor; step > 1; step >>= 1) {
+        uchar* dst = step == 2 ? m_luma.data() : areas[area];
+        area ^= 1;
+        MotionKernels::halve(src, stride, width, height, dst, width / 2);
+        src = dst;
+        width /= 2;
+        height /= 2;
+        stride = width;
+    }
+}
+
+void MotionDetector::reduceRgb(const VideoFrame& frame) {
+    const VideoPixelFormat format = frame.pixelFormat();
+    const uchar* bits = frame.constBits(0);
+    const int stride = frame.bytesPerLine(0);
+    const int cell = m_factor * m_factor;
+    for (int y = 0; y < m_height; ++y) {
+        uchar* out = m_luma.data() + y * m_width;
+        for (int x = 0; x < m_width; ++x) {
+            int sum = 0;
+            for (int dy = 0; dy < m_factor; ++dy) {
+                const uchar* line = bits + (y * m_factor + dy) * stride;
+                for (int dx = 0; dx < m_factor; ++dx) sum += rgbLuma(format, line, x * m_factor + dx);
+            }
+            out[x] = uchar((sum + cell / 2) / cell);
+        }
+    }
+}
+
+int MotionDetector::root(int run) {
+    while (m_runs[run].parent != run) {
+        m_runs[run].parent = m_runs[m_runs[run].parent].parent;
+        run = m_runs[run].parent;
+    }
+    return run;
+}
+
+void MotionDetector::findBlobs(QVector<MotionBlob>& blobs) {
+    // Runs of changed pixels, joined to the runs above that touch them,
+    // diagonals included
+    m_runs.clear();
+    int previousBegin = 0;
+    int previousEnd = 0;
+    for (int y = 0; y < m_height; ++y) {
+        const uchar* row = m_mask.constData() + y * m_width;
+        const int rowBegin = m_runs.size();
+        int above = previousBegin;
+        int x = 0;
+        while (x < m_width) {
+            // Mostly still: skip eight at a time
+            while (x + 8 <= m_width) {
+                quint64 word;
+                std::memcpy(&word, row + x, sizeof(word));
+                if (word) break;
+                x += 8;
+            }
+            while (x < m_width && !row[x]) ++x;
+            if (x >= m_width) break;
+            const int start = x;
+            while (x < m_width && row[x]) ++x;
+
+            Run run;
+            run.y = y;
+            run.start = start;
+            run.end = x - 1;
+            run.parent = m_runs.size();
+            m_runs.append(run);
+            const int index = run.parent;
+
+            while (above < previousEnd && m_runs[above].end + 1 < start) ++above;
+            for (int q = above; q < previousEnd && m_runs[q].start <= run.end + 1; ++q) {
+                const int a = root(index);
+                const int b = root(q);
+                if (a != b) m_runs[qMax(a, b)].parent = qMin(a, b);
+            }
+        }
+        previousBegin = rowBegin;
+        previousEnd = m_runs.size();
+    }
+
+    m_extentOfRoot.fill(-1, m_runs.size());
+    m_extents.clear();
+    for (int i = 0; i < m_runs.size(); ++i) {
+        const Run& run = m_runs[i];
+        const int r = root(i);
+        if (m_extentOfRoot[r] < 0) {
+            m_extentOfRoot[r] = m_extents.size();
+            m_extents.append(Extent{run.start, run.y, run.end, run.y, 0});
+        }
+        Extent& extent = m_extents[m_extentOfRoot[r]];
+        extent.left = qMin(extent.left, run.start);
+        extent.right = qMax(extent.right, run.end);
+        extent.bottom = qMax(extent.bottom, run.y);
+        extent.area += run.end - run.start + 1;
+    }
+
+    const int minArea = qMax(1, m_config.minBlobArea);
+    auto kept = std::remove_if(m_extents.begin(), m_extents.end(),
+                               [minArea](const Extent& e) { return e.area < minArea; });
+    m_extents.erase(kept, m_extents.end());
+    std::sort(m_extents.begin(), m_extents.end(),
+              [](const Extent& a, const Extent& b) { return a.area > b.area; });
+
+    const QRect frameRect(QPoint(0, 0), m_frameSize);
+    const int limit = qMin(m_extents.size(), qMax(0, m_config.maxBlobs));
+    blobs.reserve(limit);
+    for (int i = 0; i < limit; ++i) {
+        const Extent& e = m_extents[i];
+        MotionBlob blob;
+        blob.box = QRect(e.left * m_factor, e.top * m_factor,
+                         (e.right - e.left + 1) * m_factor,
+                         (e.bottom - e.top + 1) * m_factor).intersected(frameRect);
+        blob.area = e.area * m_factor * m_factor;
+        blobs.append(blob);
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,107 @@
+#ifndef MOTIONDETECTOR_H
+#define MOTIONDETECTOR_H
+
+#include <QRect>
+#include <QVector>
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Tuning of motion detection on a fixed camera
+ */
+struct MotionDetectorConfig {
+    int downscale = 4;              // Power of two; 1080p becomes 480x270
+    int threshold = 20;             // Luma difference from the background
+    int minBlobArea = 3;            // Downscaled pixels; smaller is noise
+    int maxBlobs = 16;              // Largest first
+    double maxChangedFraction = 0.2; // More than this is the camera, not a target
+    int warmupFrames = 25;          // Background settling before any blob
+    int backgroundInterval = 2;     // Frames between background steps
+};
+
+/**
+ * @brief One region moving against the background
+ */
+struct MotionBlob {
+    QRect box;                      // Frame pixels
+    int area = 0;                   // Changed frame pixels, by the downscaled count
+};
+
+/**
+ * @brief Background subtraction on downscaled luma for one fixed camera
+ *
+ * Each frame's luma is box-averaged down by config.downscale, compared
+ * with a running approximate-median background, and the pixels further
+ * than the threshold from it are grouped into 8-connected blobs. The
+ * background steps one level toward every frame (every
+ * backgroundInterval frames), so lighting drift and swaying clutter are
+ * absorbed while anything that keeps moving is not; a target that stops
+ * fades into it within a second or so.
+ *
+ * YUV frames are read from their luma plane as they come from the pool,
+ * without conversion; RGB frames are reduced to luma on the way down.
+ * When more than maxChangedFraction of the image changes at once (an
+ * exposure step, the mount knocked) the background is reseeded from the
+ * frame and nothing is reported, as it is for a new frame size.
+ *
+ * The kernels are in MotionKernels; a 1080p frame costs some 0.1-0.2 ms.
+ */
+class MotionDetector {
+public:
+    explicit MotionDetector(const MotionDetectorConfig& config = MotionDetectorConfig());
+
+    MotionDetectorConfig config() const { return m_config; }
+
+    // Blobs of this frame, largest first; false while there is no
+    // settled background to compare against
+    bool process(const VideoFrame& frame, QVector<MotionBlob>& blobs);
+    void reset();
+
+    QSize maskSize() const { return QSize(m_width, m_height); }
+    const QVector<uchar>& mask() const { return m_mask; }
+    int changedPixels() const { return m_changed; }
+    bool reseeded() const { return m_reseeded; }
+
+private:
+    struct Run {
+        int y = 0;
+        int start = 0;              // First and last column
+        int end = 0;
+        int parent = 0;             // Union-find over runs
+    };
+    struct Extent {
+        int left = 0;
+        int top = 0;
+        int right = 0;
+        int bottom = 0;
+        int area = 0;
+    };
+
+    void downscale(const VideoFrame& frame);
+    void reduceRgb(const VideoFrame& frame);
+    void findBlobs(QVector<MotionBlob>& blobs);
+    int root(int run);
+
+    MotionDetectorConfig m_config;
+    int m_factor = 4;
+    int m_width = 0;                // Downscaled
+    int m_height = 0;
+    QSize m_frameSize;
+
+    QVector<uchar> m_luma;          // Downscaled frame
+    QVector<uchar> m_scratch;       // Intermediate halvings
+    QVector<uchar> m_background;
+    QVector<uchar> m_mask;
+    QVector<Run> m_runs;
+    QVector<int> m_extentOfRoot;
+    QVector<Extent> m_extents;
+
+    quint64 m_frames = 0;           // Since the background was seeded
+    int m_changed = 0;
+    bool m_reseeded = false;
+};
+
+} // namespace CounterUAS
+
+#endif // MOTIONDETECTOR_H
@@ -0,0 +1,265 @@
+#include "video/MotionKernels.h"
+#include <bitset>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOTION_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// Built for the AVX2 target alone; only called when the CPU reports it
+#define MOTION_AVX2 1
+#define MOTION_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MOTION_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace CounterUAS {
+namespace MotionKernels {
+
+namespace {
+
+using HalveFn = void (*)(const uchar*, int, int, int, uchar*, int);
+using SubtractFn = int (*)(const uchar*, uchar*, uchar*, int, int, bool);
+
+void halveRow(const uchar* r0, const uchar* r1, uchar* out, int from, int to) {
+    for (int x = from; x < to; ++x) {
+        const int even = (r0[2 * x] + r1[2 * x] + 1) >> 1;
+        const int odd = (r0[2 * x + 1] + r1[2 * x + 1] + 1) >> 1;
+        out[x] = uchar((even + odd + 1) >> 1);
+    }
+}
+
+int subtractRun(const uchar* frame, uchar* background, uchar* mask, int from, int to,
+                int threshold, bool update) {
+    threshold = qBound(0, threshold, 255);
+    int changed = 0;
+    for (int i = from; i < to; ++i) {
+        const int f = frame[i];
+        const int b = background[i];
+        const bool moved = (f > b ? f - b : b - f) > threshold;
+        mask[i] = moved ? 0xff : 0;
+        changed += moved;
+        if (update) background[i] = uchar(b + (f > b) - (f < b));
+    }
+    return changed;
+}
+
+int setBits(quint32 movemask) {
+    return int(std::bitset<32>(movemask).count());
+}
+
+#if defined(MOTION_SSE2)
+
+void halveSse2(const uchar* src, int srcStride, int width, int height, uchar* dst, int dstStride) {
+    const int outWidth = width / 2;
+    const __m128i low = _mm_set1_epi16(0x00ff);
+    for (int y = 0; y < height / 2; ++y) {
+        const uchar* r0 = src + 2 * y * srcStride;
+        const uchar* r1 = r0 + srcStride;
+        uchar* out = dst + y * dstStride;
+        int x = 0;
+        for (; x + 16 <= outWidth; x += 16) {
+            const __m128i v0 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * x)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * x)));
+            const __m128i v1 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + 2 * x + 16)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + 2 * x + 16)));
+            // Even columns are the low byte of each 16-bit lane, odd the high
+            const __m128i h0 = _mm_avg_epu16(_mm_and_si128(v0, low), _mm_srli_epi16(v0, 8));
+            const __m128i h1 = _mm_avg_epu16(_mm_and_si128(v1, low), _mm_srli_epi16(v1, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(h0, h1));
+        }
+        halveRow(r0, r1, out, x, outWidth);
+    }
+}
+
+int subtractSse2(const uchar* frame, uchar* background, uchar* mask, int count,
+                 int threshold, bool update) {
+    const __m128i limit = _mm_set1_epi8(char(qBound(0, threshold, 255)));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(-1);
+    const __m128i one = _mm_set1_epi8(1);
+    int changed = 0;
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(frame + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + i));
+        const __m128i above = _mm_subs_epu8(f, b);
+        const __m128i below = _mm_subs_epu8(b, f);
+        const __m128i diff = _mm_or_si128(above, below);
+        const __m128i moved = _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(diff, limit), zero), ones);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), moved);
+        changed += setBits(quint32(_mm_movemask_epi8(moved)));
+        if (update) {
+            const __m128i stepped = _mm_sub_epi8(_mm_add_epi8(b, _mm_min_epu8(above, one)),
+                                                 _mm_min_epu8(below, one));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(background + i), stepped);
+        }
+    }
+    return changed + subtractRun(frame, background, mask, i, count, threshold, update);
+}
+
+#endif // MOTION_SSE2
+
+#if defined(MOTION_AVX2)
+
+MOTION_AVX2_TARGET
+void halveAvx2(const uchar* src, int srcStride, int width, int height, uchar* dst, int dstStride) {
+    const int outWidth = width / 2;
+    const __m256i low = _mm256_set1_epi16(0x00ff);
+    for (int y = 0; y < height / 2; ++y) {
+        const uchar* r0 = src + 2 * y * srcStride;
+        const uchar* r1 = r0 + srcStride;
+        uchar* out = dst + y * dstStride;
+        int x = 0;
+        for (; x + 32 <= outWidth; x += 32) {
+            const __m256i v0 = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + 2 * x)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + 2 * x)));
+            const __m256i v1 = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(r0 + 2 * x + 32)),
+                                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r1 + 2 * x + 32)));
+            const __m256i h0 = _mm256_avg_epu16(_mm256_and_si256(v0, low), _mm256_srli_epi16(v0, 8));
+            const __m256i h1 = _mm256_avg_epu16(_mm256_and_si256(v1, low), _mm256_srli_epi16(v1, 8));
+            // The pack works per 128-bit lane; put the quarters back in order
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(h0, h1), 0xd8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), packed);
+        }
+        halveRow(r0, r1, out, x, outWidth);
+    }
+}
+
+MOTION_AVX2_TARGET
+int subtractAvx2(const uchar* frame, uchar* background, uchar* mask, int count,
+                 int threshold, bool update) {
+    const __m256i limit = _mm256_set1_epi8(char(qBound(0, threshold, 255)));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi8(-1);
+    const __m256i one = _mm256_set1_epi8(1);
+    int changed = 0;
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(frame + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(background + i));
+        const __m256i above = _mm256_subs_epu8(f, b);
+        const __m256i below = _mm256_subs_epu8(b, f);
+        const __m256i diff = _mm256_or_si256(above, below);
+        const __m256i moved = _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(diff, limit), zero), ones);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(mask + i), moved);
+        changed += setBits(quint32(_mm256_movemask_epi8(moved)));
+        if (update) {
+            const __m256i stepped = _mm256_sub_epi8(_mm256_add_epi8(b, _mm256_min_epu8(above, one)),
+                                                    _mm256_min_epu8(below, one));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(background + i), stepped);
+        }
+    }
+    return changed + subtractRun(frame, background, mask, i, count, threshold, update);
+}
+
+#endif // MOTION_AVX2
+
+#if defined(MOTION_NEON)
+
+void halveNeon(const uchar* src, int srcStride, int width, int height, uchar* dst, int dstStride) {
+    const int outWidth = width / 2;
+    for (int y = 0; y < height / 2; ++y) {
+        const uchar* r0 = src + 2 * y * srcStride;
+        const uchar* r1 = r0 + srcStride;
+        uchar* out = dst + y * dstStride;
+        int x = 0;
+        for (; x + 16 <= outWidth; x += 16) {
+            // De-interleaving loads split even and odd columns
+            const uint8x16x2_t a = vld2q_u8(r0 + 2 * x);
+            const uint8x16x2_t b = vld2q_u8(r1 + 2 * x);
+            const uint8x16_t even = vrhaddq_u8(a.val[0], b.val[0]);
+            const uint8x16_t odd = vrhaddq_u8(a.val[1], b.val[1]);
+            vst1q_u8(out + x, vrhaddq_u8(even, odd));
+        }
+        halveRow(r0, r1, out, x, outWidth);
+    }
+}
+
+int subtractNeon(const uchar* frame, uchar* background, uchar* mask, int count,
+                 int threshold, bool update) {
+    const uint8x16_t limit = vdupq_n_u8(uint8_t(qBound(0, threshold, 255)));
+    const uint8x16_t one = vdupq_n_u8(1);
+    int changed = 0;
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t f = vld1q_u8(frame + i);
+        const uint8x16_t b = vld1q_u8(background + i);
+        const uint8x16_t moved = vcgtq_u8(vabdq_u8(f, b), limit);
+        vst1q_u8(mask + i, moved);
+        changed += vaddlvq_u8(vshrq_n_u8(moved, 7));
+        if (update) {
+            const uint8x16_t up = vminq_u8(vqsubq_u8(f, b), one);
+            const uint8x16_t down = vminq_u8(vqsubq_u8(b, f), one);
+            vst1q_u8(background + i, vsubq_u8(vaddq_u8(b, up), down));
+        }
+    }
+    return changed + subtractRun(frame, background, mask, i, count, threshold, update);
+}
+
+#endif // MOTION_NEON
+
+struct Kernels {
+    HalveFn halve = halveScalar;
+    SubtractFn subtract = subtractScalar;
+    const char* name = "scalar";
+
+    Kernels() {
+#if defined(MOTION_AVX2)
+        if (__builtin_cpu_supports("avx2")) {
+            halve = halveAvx2;
+            subtract = subtractAvx2;
+            name = "avx2";
+            return;
+        }
+#endif
+#if defined(MOTION_SSE2)
+        halve = halveSse2;
+        subtract = subtractSse2;
+        name = "sse2";
+#elif defined(MOTION_NEON)
+        halve = halveNeon;
+        subtract = subtractNeon;
+        name = "neon";
+#endif
+    }
+};
+
+const Kernels& kernels() {
+    static const Kernels chosen;
+    return chosen;
+}
+
+} // namespace
+
+const char* instructionSet() {
+    return kernels().name;
+}
+
+void halve(const uchar* src, int srcStride, int width, int height, uchar* dst, int dstStride) {
+    kernels().halve(src, srcStride, width, height, dst, dstStride);
+}
+
+int subtract(const uchar* frame, uchar* background, uchar* mask, int count,
+             int threshold, bool update) {
+    return kernels().subtract(frame, background, mask, count, threshold, update);
+}
+
+void halveScalar(const uchar* src, int srcStride, int width, int height,
+                 uchar* dst, int dstStride) {
+    for (int y = 0; y < height / 2; ++y) {
+        const uchar* r0 = src + 2 * y * srcStride;
+        halveRow(r0, r0 + srcStride, dst + y * dstStride, 0, width / 2);
+    }
+}
+
+int subtractScalar(const uchar* frame, uchar* background, uchar* mask, int count,
+                   int threshold, bool update) {
+    return subtractRun(frame, background, mask, 0, count, threshold, update);
+}
+
+} // namespace MotionKernels
+} // namespace CounterUAS
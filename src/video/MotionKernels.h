@@ -0,0 +1,42 @@
+#ifndef MOTIONKERNELS_H
+#define MOTIONKERNELS_H
+
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief Vectorised inner loops of motion detection on 8-bit luma
+ *
+ * Each kernel is picked once, on first use, for the CPU the process runs
+ * on: AVX2 when the x86 CPU has it (GCC and Clang, whatever the build's
+ * -m flags), else SSE2, which every x86-64 CPU has; NEON on ARM; plain
+ * C++ elsewhere. Every path gives the same bytes as the scalar one.
+ */
+namespace MotionKernels {
+
+// "avx2", "sse2", "neon" or "scalar"
+const char* instructionSet();
+
+// dst (width / 2 x height / 2) is the 2x2 box average of src: the rows,
+// then the columns, each rounded up as _mm_avg_epu8 does
+void halve(const uchar* src, int srcStride, int width, int height,
+           uchar* dst, int dstStride);
+
+// For count pixels: mask is 0xff where |frame - background| > threshold,
+// else 0, and with update each background pixel steps 1 toward the frame
+// (the running approximate median). Returns the pixels set in mask.
+int subtract(const uchar* frame, uchar* background, uchar* mask, int count,
+             int threshold, bool update);
+
+// The portable versions, for checking the others against
+void halveScalar(const uchar* src, int srcStride, int width, int height,
+                 uchar* dst, int dstStride);
+int subtractScalar(const uchar* frame, uchar* background, uchar* mask, int count,
+                   int threshold, bool update);
+
+} // namespace MotionKernels
+
+} // namespace CounterUAS
+
+#endif // MOTIONKERNELS_H
@@ -0,0 +1,242 @@
+#include "video/OnvifPtzClient.h"
+#include <QList>
+#include <QtMath>
+
+namespace CounterUAS {
+
+namespace {
+
+QString envelope(const QString& body) {
+    return QStringLiteral(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<s:Envelope xmlns:s=\"http://www.w3.org/2003/05/soap-envelope\""
+        " xmlns:tptz=\"http://www.onvif.org/ver20/ptz/wsdl\""
+        " xmlns:tt=\"http://www.onvif.org/ver10/schema\">"
+        "<s:Body>%1</s:Body></s:Envelope>").arg(body);
+}
+
+// Value of attribute name="..." in the element starting at from
+bool attribute(const QByteArray& xml, int from, const char* name, double& value) {
+    const int end = xml.indexOf('>', from);
+    const int at = xml.indexOf(QByteArray(" ") + name + "=\"", from);
+    if (at < 0 || (end >= 0 && at > end)) return false;
+    const int start = at + static_cast<int>(qstrlen(name)) + 3;
+    const int close = xml.indexOf('"', start);
+    if (close < 0) return false;
+    bool ok = false;
+    value = xml.mid(start, close - start).toDouble(&ok);
+    return ok;
+}
+
+} // namespace
+
+void OnvifPtzClient::setTarget(const QString& host, int port, const QString& servicePath,
+                               const QString& profileToken, const QString& username,
+                               const QString& password) {
+    m_host = host;
+    m_port = port;
+    m_path = servicePath.startsWith('/') ? servicePath : '/' + servicePath;
+    m_profile = profileToken.toHtmlEscaped();
+    m_authorization = username.isEmpty() ? QByteArray()
+        : "Basic " + (username + ':' + password).toUtf8().toBase64();
+
+    const QString profile = "<tptz:ProfileToken>" + m_profile + "</tptz:ProfileToken>";
+    m_continuousMove = build("ContinuousMove",
+        "<tptz:ContinuousMove>" + profile +
+        "<tptz:Velocity><tt:PanTilt x=\"{}\" y=\"{}\"/></tptz:Velocity></tptz:ContinuousMove>");
+    m_continuousZoom = build("ContinuousMove",
+        "<tptz:ContinuousMove>" + profile +
+        "<tptz:Velocity><tt:Zoom x=\"{}\"/></tptz:Velocity></tptz:ContinuousMove>");
+    m_relativeMove = build("RelativeMove",
+        "<tptz:RelativeMove>" + profile +
+        "<tptz:Translation><tt:PanTilt x=\"{}\" y=\"{}\"/><tt:Zoom x=\"{}\"/></tptz:Translation>"
+        "</tptz:RelativeMove>");
+    m_absoluteMove = build("AbsoluteMove",
+        "<tptz:AbsoluteMove>" + profile +
+        "<tptz:Position><tt:PanTilt x=\"{}\" y=\"{}\"/><tt:Zoom x=\"{}\"/></tptz:Position>"
+        "</tptz:AbsoluteMove>");
+    m_absoluteZoom = build("AbsoluteMove",
+        "<tptz:AbsoluteMove>" + profile +
+        "<tptz:Position><tt:Zoom x=\"{}\"/></tptz:Position></tptz:AbsoluteMove>");
+    m_stop = build("Stop",
+        "<tptz:Stop>" + profile +
+        "<tptz:PanTilt>true</tptz:PanTilt><tptz:Zoom>true</tptz:Zoom></tptz:Stop>");
+    m_getStatus = build("GetStatus", "<tptz:GetStatus>" + profile + "</tptz:GetStatus>");
+}
+
+QByteArray OnvifPtzClient::request(const QString& action, const QString& body) const {
+    const QByteArray content = envelope(body).toUtf8();
+    QByteArray out;
+    out.reserve(content.size() + 384);
+    out += "POST " + m_path.toUtf8() + " HTTP/1.1\r\n";
+    out += "Host: " + m_host.toUtf8() + ':' + QByteArray::number(m_port) + "\r\n";
+    out += "Content-Type: application/soap+xml; charset=utf-8; "
+           "action=\"http://www.onvif.org/ver20/ptz/wsdl/" + action.toUtf8() + "\"\r\n";
+    out += "Connection: keep-alive\r\n";
+    if (!m_authorization.isEmpty()) out += "Authorization: " + m_authorization + "\r\n";
+    out += "Content-Length: " + QByteArray::number(content.size()) + "\r\n\r\n";
+    out += content;
+    return out;
+}
+
+OnvifPtzClient::Template OnvifPtzClient::build(const QString& action, const QString& body) const {
+    // Each mark becomes a zero of the fixed width, so the length is final
+    const QString zero = QStringLiteral("+0.000000");
+    QString filled = body;
+    filled.replace(QStringLiteral("{}"), zero);
+
+    Template t;
+    t.bytes = request(action, filled);
+    const int content = t.bytes.indexOf("\r\n\r\n") + 4;
+    for (int at = t.bytes.indexOf("=\"+0.000000\"", content); at >= 0;
+         at = t.bytes.indexOf("=\"+0.000000\"", at + VALUE_WIDTH)) {
+        t.fields.append(at + 2);
+    }
+    return t;
+}
+
+void OnvifPtzClient::write(Template& request, int field, double value, double min, double max) {
+    // Fixed point by hand: locale-free and without allocating
+    value = qBound(min, std::isfinite(value) ? value : 0.0, max);
+    const qint64 micros = qRound64(std::abs(value) * 1000000.0);
+    char* out = request.bytes.data() + request.fields[field];
+    out[0] = value < 0.0 && micros > 0 ? '-' : '+';
+    out[1] = static_cast<char>('0' + micros / 1000000);
+    out[2] = '.';
+    qint64 fraction = micros % 1000000;
+    for (int i = VALUE_WIDTH - 1; i >= 3; --i) {
+        out[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+}
+
+const QByteArray& OnvifPtzClient::continuousMove(double panVelocity, double tiltVelocity) {
+    write(m_continuousMove, 0, panVelocity, -1.0, 1.0);
+    write(m_continuousMove, 1, tiltVelocity, -1.0, 1.0);
+    return m_continuousMove.bytes;
+}
+
+const QByteArray& OnvifPtzClient::continuousZoom(double zoomVelocity) {
+    write(m_continuousZoom, 0, zoomVelocity, -1.0, 1.0);
+    return m_continuousZoom.bytes;
+}
+
+const QByteArray& OnvifPtzClient::relativeMove(double pan, double tilt, double zoom) {
+    write(m_relativeMove, 0, pan, -1.0, 1.0);
+    write(m_relativeMove, 1, tilt, -1.0, 1.0);
+    write(m_relativeMove, 2, zoom, -1.0, 1.0);
+    return m_relativeMove.bytes;
+}
+
+const QByteArray& OnvifPtzClient::absoluteMove(double pan, double tilt, double zoom) {
+    write(m_absoluteMove, 0, pan, -1.0, 1.0);
+    write(m_absoluteMove, 1, tilt, -1.0, 1.0);
+    write(m_absoluteMove, 2, zoom, 0.0, 1.0);
+    return m_absoluteMove.bytes;
+}
+
+const QByteArray& OnvifPtzClient::absoluteZoom(double zoom) {
+    write(m_absoluteZoom, 0, zoom, 0.0, 1.0);
+    return m_absoluteZoom.bytes;
+}
+
+QByteArray OnvifPtzClient::gotoPreset(int preset) const {
+    return request("GotoPreset",
+        "<tptz:GotoPreset><tptz:ProfileToken>" + m_profile + "</tptz:ProfileToken>"
+        "<tptz:PresetToken>" + QString::number(preset) + "</tptz:PresetToken></tptz:GotoPreset>");
+}
+
+QByteArray OnvifPtzClient::setPreset(int preset) const {
+    return request("SetPreset",
+        "<tptz:SetPreset><tptz:ProfileToken>" + m_profile + "</tptz:ProfileToken>"
+        "<tptz:PresetToken>" + QString::number(preset) + "</tptz:PresetToken></tptz:SetPreset>");
+}
+
+QByteArray OnvifPtzClient::removePreset(int preset) const {
+    return request("RemovePreset",
+        "<tptz:RemovePreset><tptz:ProfileToken>" + m_profile + "</tptz:ProfileToken>"
+        "<tptz:PresetToken>" + QString::number(preset) + "</tptz:PresetToken></tptz:RemovePreset>");
+}
+
+void OnvifPtzClient::feed(const QByteArray& data) {
+    m_input.append(data);
+}
+
+bool OnvifPtzClient::nextResponse(OnvifResponse& response) {
+    for (;;) {
+        const int headerEnd = m_input.indexOf("\r\n\r\n");
+        if (headerEnd < 0) return false;
+
+        const QList<QByteArray> lines = m_input.left(headerEnd).split('\n');
+        const QList<QByteArray> statusLine = lines.first().trimmed().split(' ');
+        const int status = statusLine.size() > 1 ? statusLine[1].toInt() : 0;
+        int contentLength = 0;
+        bool chunked = false;
+        bool keepAlive = !lines.first().startsWith("HTTP/1.0");
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon < 0) continue;
+            const QByteArray name = lines[i].left(colon).trimmed().toLower();
+            const QByteArray value = lines[i].mid(colon + 1).trimmed().toLower();
+            if (name == "content-length") contentLength = value.toInt();
+            else if (name == "transfer-encoding") chunked = value.contains("chunked");
+            else if (name == "connection") keepAlive = value != "close";
+        }
+
+        int end = headerEnd + 4;
+        QByteArray body;
+        if (chunked) {
+            for (;;) {
+                const int lineEnd = m_input.indexOf("\r\n", end);
+                if (lineEnd < 0) return false;
+                bool ok = false;
+                const int size = m_input.mid(end, lineEnd - end).split(';').first().trimmed().toInt(&ok, 16);
+                if (!ok) {
+                    // Not HTTP we can follow; start over with the next response
+                    m_input.clear();
+                    return false;
+                }
+                if (size == 0) {
+                    const int trailerEnd = m_input.indexOf("\r\n\r\n", lineEnd);
+                    if (trailerEnd < 0) return false;
+                    end = trailerEnd + 4;
+                    break;
+                }
+                if (m_input.size() < lineEnd + 2 + size + 2) return false;
+                body += m_input.mid(lineEnd + 2, size);
+                end = lineEnd + 2 + size + 2;
+            }
+        } else {
+            if (m_input.size() < end + contentLength) return false;
+            body = m_input.mid(end, contentLength);
+            end += contentLength;
+        }
+        m_input.remove(0, end);
+
+        // 100 Continue and the like precede the real answer
+        if (status >= 100 && status < 200) continue;
+
+        response.status = status;
+        response.body = body;
+        response.fault = status >= 400 || status == 0 || body.contains(":Fault>");
+        response.keepAlive = keepAlive;
+        return true;
+    }
+}
+
+bool OnvifPtzClient::parseStatus(const QByteArray& body, double& pan, double& tilt, double& zoom) {
+    const int position = body.indexOf(":Position>");
+    if (position < 0) return false;
+    const int panTilt = body.indexOf(":PanTilt ", position);
+    const int zoomAt = body.indexOf(":Zoom ", position);
+    bool found = false;
+    if (panTilt >= 0 && attribute(body, panTilt, "x", pan) && attribute(body, panTilt, "y", tilt)) {
+        found = true;
+    }
+    if (zoomAt >= 0 && attribute(body, zoomAt, "x", zoom)) {
+        found = true;
+    }
+    return found;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,94 @@
+#ifndef ONVIFPTZCLIENT_H
+#define ONVIFPTZCLIENT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+namespace CounterUAS {
+
+/**
+ * @brief A complete HTTP response to an ONVIF request
+ */
+struct OnvifResponse {
+    int status = 0;
+    QByteArray body;
+    bool fault = false;         // Error status or a SOAP Fault
+    bool keepAlive = true;      // false when the head closes after it
+};
+
+/**
+ * @brief ONVIF PTZ service requests and responses over one kept-alive connection
+ *
+ * The HTTP side of a PTZController on ONVIF: the controller keeps the
+ * TCP connection (HTTP/1.1, never closed by us), this builds what goes
+ * on it and splits what comes back into responses.
+ *
+ * The requests sent while tracking (ContinuousMove, RelativeMove,
+ * AbsoluteMove, Stop, GetStatus) are built once, headers included, when
+ * the target is set. Each value is a fixed-width field, so a command
+ * writes its numbers over the fields in place and the Content-Length
+ * never changes: no XML building or number formatting per command.
+ * Values are ONVIF's generic spaces, pan and tilt in [-1, 1] and zoom in
+ * [0, 1]. Preset requests are rare and built when asked for. HTTP Basic
+ * authentication.
+ */
+class OnvifPtzClient {
+public:
+    void setTarget(const QString& host, int port, const QString& servicePath,
+                   const QString& profileToken, const QString& username = QString(),
+                   const QString& password = QString());
+
+    // Valid until the same request is built again
+    const QByteArray& continuousMove(double panVelocity, double tiltVelocity);
+    const QByteArray& continuousZoom(double zoomVelocity);
+    const QByteArray& relativeMove(double pan, double tilt, double zoom);
+    const QByteArray& absoluteMove(double pan, double tilt, double zoom);
+    const QByteArray& absoluteZoom(double zoom);
+    const QByteArray& stop() const { return m_stop.bytes; }
+    const QByteArray& getStatus() const { return m_getStatus.bytes; }
+
+    QByteArray gotoPreset(int preset) const;
+    QByteArray setPreset(int preset) const;
+    QByteArray removePreset(int preset) const;
+
+    // Response reader; a response split across reads waits for the rest
+    void feed(const QByteArray& data);
+    bool nextResponse(OnvifResponse& response);
+    void clear() { m_input.clear(); }
+
+    // Position out of a GetStatusResponse, in the generic spaces
+    static bool parseStatus(const QByteArray& body, double& pan, double& tilt, double& zoom);
+
+    static constexpr int VALUE_WIDTH = 9;   // "+0.500000"
+
+private:
+    struct Template {
+        QByteArray bytes;
+        QVector<int> fields;    // Offset of each value
+    };
+
+    Template build(const QString& action, const QString& body) const;
+    QByteArray request(const QString& action, const QString& body) const;
+    static void write(Template& request, int field, double value, double min, double max);
+
+    QString m_host;
+    int m_port = 80;
+    QString m_path;
+    QString m_profile;
+    QByteArray m_authorization;
+
+    Template m_continuousMove;
+    Template m_continuousZoom;
+    Template m_relativeMove;
+    Template m_absoluteMove;
+    Template m_absoluteZoom;
+    Template m_stop;
+    Template m_getStatus;
+
+    QByteArray m_input;
+};
+
+} // namespace CounterUAS
+
+#endif // ONVIFPTZCLIENT_H
@@ -0,0 +1,92 @@
+#include "video/PTZCommandScheduler.h"
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+void PTZCommandScheduler::submitMotion() {
+    ++m_stats.submitted;
+    if (m_motionPending) ++m_stats.coalesced;
+    m_motionPending = true;
+}
+
+void PTZCommandScheduler::submitPriority(const QByteArray& command, bool dropsMotion) {
+    ++m_stats.submitted;
+    if (dropsMotion && m_motionPending) {
+        ++m_stats.coalesced;
+        m_motionPending = false;
+    }
+    m_priority.append(command);
+}
+
+void PTZCommandScheduler::submit(const QByteArray& command) {
+    ++m_stats.submitted;
+    m_ordered.append(command);
+}
+
+qint64 PTZCommandScheduler::minIntervalMs() const {
+    return m_config.commandRateHz > 0.0 ? qRound64(1000.0 / m_config.commandRateHz) : 0;
+}
+
+qint64 PTZCommandScheduler::nextDueMs(qint64 nowMs) const {
+    if (isEmpty()) return -1;
+
+    qint64 due = nowMs;
+    if (m_lastSentMs >= 0) due = qMax(due, m_lastSentMs + minIntervalMs());
+    if (m_sentMs >= 0 && m_priority.isEmpty()) due = qMax(due, m_sentMs + m_config.ackTimeoutMs);
+    return due;
+}
+
+bool PTZCommandScheduler::next(qint64 nowMs, QByteArray& command, Kind* kind) {
+    const qint64 due = nextDueMs(nowMs);
+    if (due < 0 || due > nowMs) return false;
+
+    if (m_sentMs >= 0 && nowMs - m_sentMs >= m_config.ackTimeoutMs) {
+        // No answer in time; nothing waits on it any longer
+        ++m_stats.ackTimeouts;
+    }
+    m_sentMs = -1;
+
+    Kind from;
+    if (!m_priority.isEmpty()) {
+        command = m_priority.takeFirst();
+        from = Kind::Priority;
+    } else if (!m_ordered.isEmpty()) {
+        command = m_ordered.takeFirst();
+        from = Kind::Ordered;
+    } else {
+        command.clear();
+        m_motionPending = false;
+        from = Kind::Motion;
+    }
+    if (kind) *kind = from;
+
+    ++m_stats.sent;
+    m_lastSentMs = nowMs;
+    if (m_config.awaitAck) m_sentMs = nowMs;
+    return true;
+}
+
+void PTZCommandScheduler::acknowledge(qint64 nowMs) {
+    if (m_sentMs < 0) return;
+
+    const qint64 latency = qMax<qint64>(0, nowMs - m_sentMs);
+    m_sentMs = -1;
+    ++m_stats.acknowledged;
+    m_stats.lastAckLatencyMs = latency;
+    m_stats.maxAckLatencyMs = qMax(m_stats.maxAckLatencyMs, latency);
+    m_stats.meanAckLatencyMs += (latency - m_stats.meanAckLatencyMs) / m_stats.acknowledged;
+}
+
+int PTZCommandScheduler::queued() const {
+    return m_priority.size() + m_ordered.size() + (m_motionPending ? 1 : 0);
+}
+
+void PTZCommandScheduler::clear() {
+    m_priority.clear();
+    m_ordered.clear();
+    m_motionPending = false;
+    m_lastSentMs = -1;
+    m_sentMs = -1;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,88 @@
+#ifndef PTZCOMMANDSCHEDULER_H
+#define PTZCOMMANDSCHEDULER_H
+
+#include <QByteArray>
+#include <QList>
+
+namespace CounterUAS {
+
+/**
+ * @brief Pacing of the commands sent to one PTZ head
+ */
+struct PTZCommandSchedulerConfig {
+    double commandRateHz = 10.0;    // Most commands the head takes per second
+    bool awaitAck = false;          // Hold the next command until the head answers
+    int ackTimeoutMs = 1000;        // Then give up waiting on it
+};
+
+/**
+ * @brief Per-head command queue between a PTZController and its socket
+ *
+ * Motion (absolute moves, rates, relative jogs) is a single pending flag,
+ * not a queue: next() reports when a move is due and the caller builds it
+ * then from its latest pan, tilt and zoom, so a head slower than its
+ * control loop is sent one merged, current command instead of working
+ * through a backlog of stale ones. Priority commands (stop, presets) go
+ * out before anything else, and a stop or a preset recall also drops the
+ * motion it overrides; other commands, such as position queries, keep
+ * their order between the two. At most commandRateHz commands go out per
+ * second, and with awaitAck only one is outstanding until the head
+ * answers it, which gives the command-to-ack latency; a priority command
+ * does not wait on an answer.
+ *
+ * Times are the caller's monotonic milliseconds.
+ */
+class PTZCommandScheduler {
+public:
+    enum class Kind { Motion, Priority, Ordered };
+
+    void setConfig(const PTZCommandSchedulerConfig& config) { m_config = config; }
+    PTZCommandSchedulerConfig config() const { return m_config; }
+
+    void submitMotion();
+    // dropsMotion for commands that supersede any move still pending
+    void submitPriority(const QByteArray& command, bool dropsMotion);
+    void submit(const QByteArray& command);
+
+    // The command due at nowMs, if any; kind tells which queue it came
+    // from, and for Motion the command is empty for the caller to build
+    bool next(qint64 nowMs, QByteArray& command, Kind* kind = nullptr);
+    // When next() will have one: nowMs or later, -1 with nothing queued
+    qint64 nextDueMs(qint64 nowMs) const;
+
+    // The head answered the oldest outstanding command
+    void acknowledge(qint64 nowMs);
+    bool awaitingAck() const { return m_sentMs >= 0; }
+
+    bool isEmpty() const { return m_priority.isEmpty() && m_ordered.isEmpty() && !m_motionPending; }
+    int queued() const;
+    void clear();
+
+    struct Statistics {
+        quint64 submitted = 0;
+        quint64 sent = 0;
+        quint64 coalesced = 0;      // Moves merged into a later one or dropped
+        quint64 acknowledged = 0;
+        quint64 ackTimeouts = 0;
+        qint64 lastAckLatencyMs = 0;
+        qint64 maxAckLatencyMs = 0;
+        double meanAckLatencyMs = 0.0;
+    };
+    Statistics statistics() const { return m_stats; }
+    void resetStatistics() { m_stats = Statistics(); }
+
+private:
+    qint64 minIntervalMs() const;
+
+    PTZCommandSchedulerConfig m_config;
+    QList<QByteArray> m_priority;
+    QList<QByteArray> m_ordered;
+    bool m_motionPending = false;
+    qint64 m_lastSentMs = -1;
+    qint64 m_sentMs = -1;           // Of the command awaiting its ack
+    Statistics m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // PTZCOMMANDSCHEDULER_H
@@ -1,12 +1,16 @@
 #include "video/PTZController.h"
 #include "utils/Logger.h"
+#include "utils/RawCapture.h"
+#include <cmath>
 
 namespace CounterUAS {
 
 PTZController::PTZController(QObject* parent)
     : QObject(parent)
     , m_socket(new QTcpSocket(this))
-    , m_positionTimer(new QTimer(this))
+    , m_connection(new ManagedConnection(m_socket))
+    , m_positionTimer(this, [this]() { updatePosition(); })
+    , m_commandTimer(this, [this]() { dispatchCommands(); })
 {
     QObject::connect(m_socket, &QTcpSocket::connected, this, &PTZController::onSocketConnected);
     QObject::connect(m_socket, &QTcpSocket::disconnected, this, &PTZController::onSocketDisconnected);
@@ -18,8 +22,9 @@ PTZController::PTZController(QObject* parent)
                      this, &PTZController::onSocketError);
 #endif
     
-    m_positionTimer->setInterval(100);
-    QObject::connect(m_positionTimer, &QTimer::timeout, this, &PTZController::updatePosition);
+    m_positionTimer.setInterval(100);
+    m_commandTimer.setSingleShot(true);
+    m_commandClock.start();
 }
 
 PTZController::~PTZController() {
@@ -28,124 +33,229 @@ PTZController::~PTZController() {
 
 void PTZController::setConfig(const PTZConfig& config) {
     m_config = config;
+    
+    BackoffPolicy policy;
+    policy.connectTimeoutMs = m_config.connectTimeoutMs;
+    m_connection->setPolicy(policy);
+    m_connection->setTarget(m_config.host, static_cast<quint16>(m_config.port));
+    m_onvif.setTarget(m_config.host, m_config.port, m_config.onvifServicePath,
+                      m_config.onvifProfileToken, m_config.username, m_config.password);
+    
+    PTZCommandSchedulerConfig pacing;
+    pacing.commandRateHz = m_config.commandRateHz;
+    pacing.awaitAck = m_config.protocol == PTZProtocol::ONVIF ||
+                      m_config.protocol == PTZProtocol::VISCA ||
+                      m_config.protocol == PTZProtocol::HTTP_CGI;
+    pacing.ackTimeoutMs = m_config.ackTimeoutMs;
+    m_commands.setConfig(pacing);
 }
 
 bool PTZController::connect() {
     if (m_connected) return true;
+    if (m_config.host.isEmpty()) return false;
     
-    m_socket->connectToHost(m_config.host, m_config.port);
-    return m_socket->waitForConnected(5000);
+    m_connection->open();
+    return true;
 }
 
 void PTZController::disconnect() {
-    m_positionTimer->stop();
-    if (m_socket->state() != QAbstractSocket::UnconnectedState) {
-        m_socket->disconnectFromHost();
-    }
+    m_positionTimer.stop();
+    m_commandTimer.stop();
+    m_commands.clear();
+    m_connection->close();
     m_connected = false;
 }
 
+void PTZController::beginAbsoluteMove() {
+    if (m_velocityMode) {
+        // The axes not being set stay where the rates left them
+        m_targetPan = m_currentPan;
+        m_targetTilt = m_currentTilt;
+    }
+    m_velocityMode = false;
+    m_panVelocity = 0.0;
+    m_tiltVelocity = 0.0;
+    m_lastVelocityCommand.clear();
+    m_velocityPending = false;
+    m_jogCommand.clear();
+    m_moving = true;
+    m_positionTimer.start();
+}
+
 void PTZController::setPan(double degrees) {
+    beginAbsoluteMove();
     m_targetPan = degrees;
-    m_moving = true;
-    m_positionTimer->start();
-    
-    // Send actual command based on protocol
-    switch (m_config.protocol) {
-        case PTZProtocol::Pelco_D:
-            sendCommand(buildPelcoCommand(0x00, 0x4B, 
-                static_cast<quint8>((static_cast<int>(degrees) >> 8) & 0xFF),
-                static_cast<quint8>(static_cast<int>(degrees) & 0xFF)));
-            break;
-        case PTZProtocol::ONVIF:
-            sendCommand(buildONVIFRequest("AbsoluteMove", 
-                QString("<Position><PanTilt x=\"%1\" y=\"%2\"/></Position>")
-                    .arg(degrees / 180.0).arg(m_currentTilt / 90.0).toUtf8()));
-            break;
-        default:
-            break;
-    }
+    m_panTiltPending = true;
+    sendMotion();
 }
 
 void PTZController::setTilt(double degrees) {
+    beginAbsoluteMove();
     m_targetTilt = degrees;
-    m_moving = true;
-    m_positionTimer->start();
-    
-    switch (m_config.protocol) {
-        case PTZProtocol::Pelco_D:
-            sendCommand(buildPelcoCommand(0x00, 0x4D,
-                static_cast<quint8>((static_cast<int>(degrees) >> 8) & 0xFF),
-                static_cast<quint8>(static_cast<int>(degrees) & 0xFF)));
-            break;
-        default:
-            break;
-    }
+    m_panTiltPending = true;
+    sendMotion();
 }
 
 void PTZController::setZoom(double level) {
+    // Also while moving at a rate, which keeps going
     m_targetZoom = level;
+    m_zoomPending = true;
     m_moving = true;
-    m_positionTimer->start();
+    if (!m_positionTimer.isActive()) m_positionTimer.start();
+    sendMotion();
 }
 
 void PTZController::setPTZ(double pan, double tilt, double zoom) {
+    beginAbsoluteMove();
     m_targetPan = pan;
     m_targetTilt = tilt;
     m_targetZoom = zoom;
-    m_moving = true;
-    m_positionTimer->start();
+    m_panTiltPending = true;
+    m_zoomPending = true;
+    sendMotion();
 }
 
 void PTZController::panLeft(double speed) {
-    quint8 speedByte = static_cast<quint8>(speed * 0x3F);
-    sendCommand(buildPelcoCommand(0x00, 0x04, speedByte, 0x00));
+    m_jogCommand = buildJog(0x04, -speed, 0.0, 0.0);
+    sendMotion();
 }
 
 void PTZController::panRight(double speed) {
-    quint8 speedByte = static_cast<quint8>(speed * 0x3F);
-    sendCommand(buildPelcoCommand(0x00, 0x02, speedByte, 0x00));
+    m_jogCommand = buildJog(0x02, speed, 0.0, 0.0);
+    sendMotion();
 }
 
 void PTZController::tiltUp(double speed) {
-    quint8 speedByte = static_cast<quint8>(speed * 0x3F);
-    sendCommand(buildPelcoCommand(0x00, 0x08, 0x00, speedByte));
+    m_jogCommand = buildJog(0x08, 0.0, speed, 0.0);
+    sendMotion();
 }
 
 void PTZController::tiltDown(double speed) {
-    quint8 speedByte = static_cast<quint8>(speed * 0x3F);
-    sendCommand(buildPelcoCommand(0x00, 0x10, 0x00, speedByte));
+    m_jogCommand = buildJog(0x10, 0.0, -speed, 0.0);
+    sendMotion();
 }
 
 void PTZController::zoomIn(double speed) {
-    Q_UNUSED(speed)
-    sendCommand(buildPelcoCommand(0x00, 0x20, 0x00, 0x00));
+    m_jogCommand = buildJog(0x20, 0.0, 0.0, speed);
+    sendMotion();
 }
 
 void PTZController::zoomOut(double speed) {
-    Q_UNUSED(speed)
-    sendCommand(buildPelcoCommand(0x00, 0x40, 0x00, 0x00));
+    m_jogCommand = buildJog(0x40, 0.0, 0.0, -speed);
+    sendMotion();
+}
+
+QByteArray PTZController::buildJog(quint8 pelcoCommand, double panSpeed, double tiltSpeed, double zoomSpeed) {
+    if (m_config.protocol == PTZProtocol::ONVIF) {
+        return zoomSpeed != 0.0 ? m_onvif.continuousZoom(zoomSpeed)
+                                : m_onvif.continuousMove(panSpeed, tiltSpeed);
+    }
+    // Pelco-D: pan speed in data 1, tilt speed in data 2, zoom has none
+    const quint8 panByte = static_cast<quint8>(std::abs(panSpeed) * 0x3F);
+    const quint8 tiltByte = static_cast<quint8>(std::abs(tiltSpeed) * 0x3F);
+    return buildPelcoCommand(0x00, pelcoCommand, panByte, tiltByte);
+}
+
+void PTZController::moveRelative(double panDegrees, double tiltDegrees, double zoomLevels) {
+    // An absolute move not sent yet takes the offset instead
+    const bool panTiltPending = m_panTiltPending;
+    const bool zoomPending = m_zoomPending;
+    beginAbsoluteMove();
+    m_targetPan += panDegrees;
+    m_targetTilt += tiltDegrees;
+    m_targetZoom = qMax(1.0, m_targetZoom + zoomLevels);
+    
+    if (m_config.protocol == PTZProtocol::ONVIF && !panTiltPending) {
+        m_relativePending = true;
+        m_relativePan += panDegrees;
+        m_relativeTilt += tiltDegrees;
+        if (!zoomPending) m_relativeZoom += zoomLevels;
+    } else {
+        m_panTiltPending = true;
+    }
+    if (zoomLevels != 0.0 && (zoomPending || m_config.protocol != PTZProtocol::ONVIF)) {
+        m_zoomPending = true;
+    }
+    sendMotion();
 }
 
 void PTZController::stop() {
-    sendCommand(buildPelcoCommand(0x00, 0x00, 0x00, 0x00));
+    clearPendingMotion();
+    sendPriority(m_config.protocol == PTZProtocol::ONVIF ? m_onvif.stop()
+                                                         : buildPelcoCommand(0x00, 0x00, 0x00, 0x00), true);
     m_moving = false;
-    m_positionTimer->stop();
+    m_velocityMode = false;
+    m_panVelocity = 0.0;
+    m_tiltVelocity = 0.0;
+    m_lastVelocityCommand.clear();
+    m_positionTimer.stop();
+}
+
+QByteArray PTZController::buildVelocityCommand(double panRate, double tiltRate) {
+    switch (m_config.protocol) {
+        case PTZProtocol::ONVIF: {
+            const double x = m_config.panSpeed > 0.0 ? panRate / m_config.panSpeed : 0.0;
+            const double y = m_config.tiltSpeed > 0.0 ? tiltRate / m_config.tiltSpeed : 0.0;
+            // Rounded as the Pelco speeds are, so repeats compare equal
+            return m_onvif.continuousMove(qRound(x * 1000.0) / 1000.0, qRound(y * 1000.0) / 1000.0);
+        }
+        default: {
+            // Pelco-D: direction bits in command 2, speeds 0x00-0x3F
+            const quint8 panByte = static_cast<quint8>(qRound(std::abs(panRate) / qMax(1e-6, m_config.panSpeed) * 0x3F));
+            const quint8 tiltByte = static_cast<quint8>(qRound(std::abs(tiltRate) / qMax(1e-6, m_config.tiltSpeed) * 0x3F));
+            quint8 cmd2 = 0x00;
+            if (panByte > 0) cmd2 |= panRate > 0 ? 0x02 : 0x04;
+            if (tiltByte > 0) cmd2 |= tiltRate > 0 ? 0x08 : 0x10;
+            return buildPelcoCommand(0x00, cmd2, panByte, tiltByte);
+        }
+    }
+}
+
+void PTZController::setPanTiltVelocity(double panRate, double tiltRate) {
+    panRate = qBound(-m_config.panSpeed, panRate, m_config.panSpeed);
+    tiltRate = qBound(-m_config.tiltSpeed, tiltRate, m_config.tiltSpeed);
+    
+    // Quantised to what the protocol carries before deciding it changed
+    const QByteArray command = buildVelocityCommand(panRate, tiltRate);
+    
+    if (!m_velocityMode) m_motionClock.start();
+    m_velocityMode = true;
+    m_moving = true;
+    m_panVelocity = panRate;
+    m_tiltVelocity = tiltRate;
+    m_panTiltPending = false;
+    m_relativePending = false;
+    m_relativePan = m_relativeTilt = m_relativeZoom = 0.0;
+    m_jogCommand.clear();
+    if (!m_positionTimer.isActive()) m_positionTimer.start();
+    
+    if (command != m_lastVelocityCommand) {
+        m_lastVelocityCommand = command;
+        m_velocityPending = true;
+        sendMotion();
+    }
 }
 
 void PTZController::goToPreset(int presetNumber) {
-    sendCommand(buildPelcoCommand(0x00, 0x07, 0x00, static_cast<quint8>(presetNumber)));
+    clearPendingMotion();
+    sendPriority(m_config.protocol == PTZProtocol::ONVIF
+                     ? m_onvif.gotoPreset(presetNumber)
+                     : buildPelcoCommand(0x00, 0x07, 0x00, static_cast<quint8>(presetNumber)), true);
 }
 
 void PTZController::setPreset(int presetNumber) {
-    sendCommand(buildPelcoCommand(0x00, 0x03, 0x00, static_cast<quint8>(presetNumber)));
+    sendPriority(m_config.protocol == PTZProtocol::ONVIF
+                     ? m_onvif.setPreset(presetNumber)
+                     : buildPelcoCommand(0x00, 0x03, 0x00, static_cast<quint8>(presetNumber)), false);
     if (!m_presets.contains(presetNumber)) {
         m_presets.append(presetNumber);
     }
 }
 
 void PTZController::clearPreset(int presetNumber) {
-    sendCommand(buildPelcoCommand(0x00, 0x05, 0x00, static_cast<quint8>(presetNumber)));
+    sendPriority(m_config.protocol == PTZProtocol::ONVIF
+                     ? m_onvif.removePreset(presetNumber)
+                     : buildPelcoCommand(0x00, 0x05, 0x00, static_cast<quint8>(presetNumber)), false);
     m_presets.removeAll(presetNumber);
 }
 
@@ -158,7 +268,8 @@ void PTZController::setHome() {
 }
 
 void PTZController::queryPosition() {
-    sendCommand(buildPelcoCommand(0x00, 0x51, 0x00, 0x00));
+    sendCommand(m_config.protocol == PTZProtocol::ONVIF ? m_onvif.getStatus()
+                                                        : buildPelcoCommand(0x00, 0x51, 0x00, 0x00));
 }
 
 void PTZController::onSocketConnected() {
@@ -169,15 +280,49 @@ void PTZController::onSocketConnected() {
 
 void PTZController::onSocketDisconnected() {
     m_connected = false;
+    m_commandTimer.stop();
+    m_commands.clear();
+    m_onvif.clear();
     Logger::instance().info("PTZController", "Disconnected");
     emit disconnected();
 }
 
+void PTZController::setCapture(const std::shared_ptr<RawCaptureRecorder>& recorder, const QString& source) {
+    m_capture = recorder;
+    m_captureChannel = recorder ? recorder->openChannel(source, RawCaptureKind::Stream) : -1;
+}
+
+bool PTZController::replayRaw(const QByteArray& data) {
+    if (m_connected) return false;
+    handleFeedback(data);
+    return true;
+}
+
 void PTZController::onSocketReadyRead() {
-    QByteArray data = m_socket->readAll();
-    
+    const QByteArray data = m_socket->readAll();
+    if (m_capture) m_capture->record(m_captureChannel, data.constData(), data.size());
+    handleFeedback(data);
+}
+
+void PTZController::handleFeedback(const QByteArray& data) {
     if (m_config.protocol == PTZProtocol::ONVIF) {
-        parseONVIFResponse(data);
+        // Each whole HTTP response acknowledges its request
+        m_onvif.feed(data);
+        OnvifResponse response;
+        bool answered = false;
+        while (m_onvif.nextResponse(response)) {
+            m_commands.acknowledge(m_commandClock.elapsed());
+            parseONVIFResponse(response);
+            answered = true;
+        }
+        if (answered) dispatchCommands();
+        return;
+    }
+    
+    // Any answer acknowledges the command outstanding
+    if (m_commands.awaitingAck()) {
+        m_commands.acknowledge(m_commandClock.elapsed());
+        dispatchCommands();
     }
     // Parse other protocol responses as needed
 }
@@ -191,6 +336,19 @@ void PTZController::updatePosition() {
     // Simulate PTZ movement
     double dt = 0.1;  // 100ms timer
     
+    if (m_velocityMode) {
+        // Integrated over the time actually elapsed; the timer is coarse
+        dt = m_motionClock.restart() / 1000.0;
+        m_currentPan = std::remainder(m_currentPan + m_panVelocity * dt, 360.0);
+        m_currentTilt = qBound(-90.0, m_currentTilt + m_tiltVelocity * dt, 90.0);
+        const double zoomStep = m_config.zoomSpeed * dt;
+        const double zoomDiff = m_targetZoom - m_currentZoom;
+        m_currentZoom = std::abs(zoomDiff) > zoomStep ? m_currentZoom + (zoomDiff > 0 ? zoomStep : -zoomStep)
+                                                      : m_targetZoom;
+        emit positionChanged(m_currentPan, m_currentTilt, m_currentZoom);
+        return;
+    }
+    
     double panDiff = m_targetPan - m_currentPan;
     double tiltDiff = m_targetTilt - m_currentTilt;
     double zoomDiff = m_targetZoom - m_currentZoom;
@@ -234,14 +392,111 @@ void PTZController::updatePosition() {
         std::abs(tiltDiff) <= 0.1 && 
         std::abs(zoomDiff) <= 0.01) {
         m_moving = false;
-        m_positionTimer->stop();
+        m_positionTimer.stop();
         emit movementComplete();
     }
 }
 
+void PTZController::sendMotion() {
+    if (!m_connected) {
+        clearPendingMotion();
+        return;
+    }
+    m_commands.submitMotion();
+    dispatchCommands();
+}
+
+void PTZController::sendPriority(const QByteArray& command, bool dropsMotion) {
+    if (!m_connected) return;
+    m_commands.submitPriority(command, dropsMotion);
+    dispatchCommands();
+}
+
 void PTZController::sendCommand(const QByteArray& command) {
     if (!m_connected) return;
-    m_socket->write(command);
+    m_commands.submit(command);
+    dispatchCommands();
+}
+
+void PTZController::dispatchCommands() {
+    const qint64 nowMs = m_commandClock.elapsed();
+    QByteArray command;
+    PTZCommandScheduler::Kind kind;
+    while (m_commands.next(nowMs, command, &kind)) {
+        if (kind == PTZCommandScheduler::Kind::Motion) {
+            command = buildMotionCommand();
+        }
+        if (!command.isEmpty()) {
+            m_socket->write(command);
+        }
+    }
+    
+    const qint64 dueMs = m_commands.nextDueMs(nowMs);
+    if (dueMs < 0) {
+        m_commandTimer.stop();
+    } else {
+        m_commandTimer.start(static_cast<int>(dueMs - nowMs));
+    }
+}
+
+void PTZController::clearPendingMotion() {
+    m_panTiltPending = false;
+    m_zoomPending = false;
+    m_velocityPending = false;
+    m_jogCommand.clear();
+    m_relativePending = false;
+    m_relativePan = m_relativeTilt = m_relativeZoom = 0.0;
+}
+
+double PTZController::onvifZoom(double level) const {
+    return m_config.maxZoom > 1.0 ? qBound(0.0, (level - 1.0) / (m_config.maxZoom - 1.0), 1.0) : 0.0;
+}
+
+QByteArray PTZController::buildMotionCommand() {
+    // Everything changed since the last motion command, at its latest value
+    const double zoom = onvifZoom(m_targetZoom);
+    QByteArray command;
+    
+    if (!m_jogCommand.isEmpty()) {
+        command += m_jogCommand;
+    } else if (m_velocityMode && m_velocityPending) {
+        command += m_lastVelocityCommand;
+    }
+    
+    const bool panTilt = m_panTiltPending && !m_velocityMode && m_jogCommand.isEmpty();
+    switch (m_config.protocol) {
+        case PTZProtocol::ONVIF:
+            if (panTilt) {
+                command += m_onvif.absoluteMove(m_targetPan / 180.0, m_targetTilt / 90.0, zoom);
+            } else if (m_relativePending) {
+                command += m_onvif.relativeMove(m_relativePan / 180.0, m_relativeTilt / 90.0,
+                                                m_config.maxZoom > 1.0 ? m_relativeZoom / (m_config.maxZoom - 1.0) : 0.0);
+            }
+            if (!panTilt && m_zoomPending) {
+                command += m_onvif.absoluteZoom(zoom);
+            }
+            break;
+        case PTZProtocol::Pelco_D:
+            if (panTilt) {
+                command += buildPelcoCommand(0x00, 0x4B,
+                    static_cast<quint8>((static_cast<int>(m_targetPan) >> 8) & 0xFF),
+                    static_cast<quint8>(static_cast<int>(m_targetPan) & 0xFF));
+                command += buildPelcoCommand(0x00, 0x4D,
+                    static_cast<quint8>((static_cast<int>(m_targetTilt) >> 8) & 0xFF),
+                    static_cast<quint8>(static_cast<int>(m_targetTilt) & 0xFF));
+            }
+            if (m_zoomPending) {
+                const int position = qRound(zoom * 0xFFFF);
+                command += buildPelcoCommand(0x00, 0x4F, static_cast<quint8>((position >> 8) & 0xFF),
+                                             static_cast<quint8>(position & 0xFF));
+            }
+            break;
+        default:
+            break;
+    }
+    
+    clearPendingMotion();
+    return command;
 }
 
 QByteArray PTZController::buildPelcoCommand(quint8 cmd1, quint8 cmd2, quint8 data1, quint8 data2) {
@@ -260,20 +515,22 @@ QByteArray PTZController::buildPelcoCommand(quint8 cmd1, quint8 cmd2, quint8 dat
     return cmd;
 }
 
-QByteArray PTZController::buildONVIFRequest(const QString& action, const QString& body) {
-    // Simplified ONVIF SOAP request
-    QString request = QString(
-        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
-        "<s:Envelope xmlns:s=\"http://www.w3.org/2003/05/soap-envelope\">"
-        "<s:Body><%1>%2</%1></s:Body>"
-        "</s:Envelope>").arg(action, body);
+void PTZController::parseONVIFResponse(const OnvifResponse& response) {
+    if (response.fault) {
+        emit error(QString("ONVIF request failed with HTTP %1").arg(response.status));
+        return;
+    }
     
-    return request.toUtf8();
-}
-
-void PTZController::parseONVIFResponse(const QByteArray& response) {
-    Q_UNUSED(response)
-    // Parse ONVIF XML response
+    // A GetStatus answer; the move responses carry no position
+    double pan = m_currentPan / 180.0;
+    double tilt = m_currentTilt / 90.0;
+    double zoom = onvifZoom(m_currentZoom);
+    if (OnvifPtzClient::parseStatus(response.body, pan, tilt, zoom)) {
+        m_currentPan = pan * 180.0;
+        m_currentTilt = tilt * 90.0;
+        m_currentZoom = 1.0 + zoom * qMax(0.0, m_config.maxZoom - 1.0);
+        emit positionChanged(m_currentPan, m_currentTilt, m_currentZoom);
+    }
 }
 
 } // namespace CounterUAS
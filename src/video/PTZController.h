@@ -2,8 +2,13 @@
 #define PTZCONTROLLER_H
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <QTcpSocket>
-#include <QTimer>
+#include <memory>
+#include "utils/ConnectionPool.h"
+#include "utils/TimerService.h"
+#include "video/OnvifPtzClient.h"
+#include "video/PTZCommandScheduler.h"
 
 namespace CounterUAS {
 
@@ -29,15 +34,37 @@ struct PTZConfig {
     QString username;
     QString password;
     int cameraAddress = 1;  // For Pelco protocols
+    QString onvifServicePath = "/onvif/ptz_service";
+    QString onvifProfileToken = "Profile_1";
+    int connectTimeoutMs = 5000;
     
     double panSpeed = 50.0;   // degrees/second
     double tiltSpeed = 30.0;  // degrees/second
     double zoomSpeed = 5.0;   // zoom levels/second
+    
+    // Command to motion, transport included; predictive slewing leads by it
+    int commandLatencyMs = 150;
+    
+    // Pacing; ONVIF, VISCA and HTTP heads answer each command, and the
+    // next waits for the answer up to ackTimeoutMs
+    double commandRateHz = 10.0;
+    int ackTimeoutMs = 1000;
+    
+    double horizontalFovDeg = 60.0;  // At zoom 1
+    double maxZoom = 20.0;           // Zoom level at the end of the head's range
 };
 
 /**
  * @brief PTZ controller for camera pan/tilt/zoom operations
+ *
+ * Commands go through a PTZCommandScheduler: pan, tilt, zoom and rate
+ * changes made between two sends go out as one command with the latest
+ * values, at the head's command rate, and stop and presets ahead of them.
+ * ONVIF heads are driven with SOAP over one kept-alive HTTP connection
+ * (OnvifPtzClient), each response acknowledging its request.
  */
+class RawCaptureRecorder;
+
 class PTZController : public QObject {
     Q_OBJECT
     
@@ -49,7 +76,8 @@ public:
     void setConfig(const PTZConfig& config);
     PTZConfig config() const { return m_config; }
     
-    // Connection
+    // Connection; connect() starts connecting and returns at once,
+    // connected() reports the outcome
     bool connect();
     void disconnect();
     bool isConnected() const { return m_connected; }
@@ -59,6 +87,8 @@ public:
     void setTilt(double degrees);
     void setZoom(double level);
     void setPTZ(double pan, double tilt, double zoom);
+    // From the current target; ONVIF RelativeMove, absolute elsewhere
+    void moveRelative(double panDegrees, double tiltDegrees, double zoomLevels = 0.0);
     
     // Relative movement
     void panLeft(double speed = 0.5);
@@ -69,6 +99,13 @@ public:
     void zoomOut(double speed = 0.5);
     void stop();
     
+    // Continuous pan/tilt in degrees/second, clamped to the configured
+    // speeds; runs until the next command. Repeating the same rates sends
+    // nothing, so a control loop may call this every cycle.
+    void setPanTiltVelocity(double panRate, double tiltRate);
+    double panVelocity() const { return m_panVelocity; }
+    double tiltVelocity() const { return m_tiltVelocity; }
+    
     // Presets
     void goToPreset(int presetNumber);
     void setPreset(int presetNumber);
@@ -84,6 +121,17 @@ public:
     double currentPan() const { return m_currentPan; }
     double currentTilt() const { return m_currentTilt; }
     double currentZoom() const { return m_currentZoom; }
+    double horizontalFov() const { return m_config.horizontalFovDeg / qMax(1.0, m_currentZoom); }
+    
+    // Sent, merged and acknowledged commands, and command-to-ack latency
+    PTZCommandScheduler::Statistics commandStatistics() const { return m_commands.statistics(); }
+    int queuedCommands() const { return m_commands.queued(); }
+    
+    // Tees the head's feedback into the recorder as stream source; null for none
+    void setCapture(const std::shared_ptr<RawCaptureRecorder>& recorder, const QString& source);
+    // Captured feedback handled as if just read; false while connected,
+    // where it would acknowledge commands the head never answered
+    bool replayRaw(const QByteArray& data);
     
 signals:
     void connected();
@@ -98,16 +146,34 @@ private slots:
     void onSocketReadyRead();
     void onSocketError(QAbstractSocket::SocketError error);
     void updatePosition();
+    void dispatchCommands();
     
 private:
+    void sendMotion();
+    void sendPriority(const QByteArray& command, bool dropsMotion);
     void sendCommand(const QByteArray& command);
+    void beginAbsoluteMove();
+    void clearPendingMotion();
+    QByteArray buildMotionCommand();
+    QByteArray buildVelocityCommand(double panRate, double tiltRate);
     QByteArray buildPelcoCommand(quint8 cmd1, quint8 cmd2, quint8 data1, quint8 data2);
-    QByteArray buildONVIFRequest(const QString& action, const QString& body);
-    void parseONVIFResponse(const QByteArray& response);
+    QByteArray buildJog(quint8 pelcoCommand, double panSpeed, double tiltSpeed, double zoomSpeed);
+    void handleFeedback(const QByteArray& data);
+    void parseONVIFResponse(const OnvifResponse& response);
+    double onvifZoom(double level) const;
     
     PTZConfig m_config;
     QTcpSocket* m_socket;
-    QTimer* m_positionTimer;
+    ManagedConnection* m_connection;
+    ServiceTimer m_positionTimer;
+    QElapsedTimer m_motionClock;
+    
+    PTZCommandScheduler m_commands;
+    ServiceTimer m_commandTimer;
+    QElapsedTimer m_commandClock;
+    OnvifPtzClient m_onvif;
+    std::shared_ptr<RawCaptureRecorder> m_capture;
+    int m_captureChannel = -1;
     
     bool m_connected = false;
     double m_currentPan = 0.0;
@@ -119,6 +185,22 @@ private:
     double m_targetZoom = 1.0;
     bool m_moving = false;
     
+    // Continuous mode; absolute moves leave it
+    bool m_velocityMode = false;
+    double m_panVelocity = 0.0;
+    double m_tiltVelocity = 0.0;
+    QByteArray m_lastVelocityCommand;
+    
+    // What the next motion command carries
+    bool m_panTiltPending = false;
+    bool m_zoomPending = false;
+    bool m_velocityPending = false;
+    QByteArray m_jogCommand;
+    bool m_relativePending = false;     // ONVIF only; summed since the last send
+    double m_relativePan = 0.0;
+    double m_relativeTilt = 0.0;
+    double m_relativeZoom = 0.0;
+    
     QList<int> m_presets;
 };
 
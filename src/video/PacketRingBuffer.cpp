@@ -0,0 +1,89 @@
+#include "video/PacketRingBuffer.h"
+#include <cstring>
+
+namespace CounterUAS {
+
+void PacketRingBuffer::setCapacity(int capacityBytes) {
+    clear();
+    m_bytes.assign(static_cast<size_t>(qMax(0, capacityBytes)), '\0');
+    m_bytes.shrink_to_fit();
+}
+
+bool PacketRingBuffer::push(const EncodedPacket& packet) {
+    const int size = packet.data.size();
+    if (size <= 0 || size > capacity()) return false;
+    if (m_entries.empty() && !packet.keyframe) return false;
+
+    // A later keyframe lets the oldest GOP go once the span is covered
+    if (packet.keyframe && m_maxSpanMs > 0) {
+        while (!m_entries.empty()) {
+            auto next = m_entries.begin() + 1;
+            while (next != m_entries.end() && !next->keyframe) ++next;
+            if (next == m_entries.end() || packet.timeMs - next->timeMs < m_maxSpanMs) break;
+            popGop();
+        }
+    }
+
+    int offset = reserve(size);
+    while (offset < 0) {
+        popGop();
+        if (m_entries.empty() && !packet.keyframe) return false;
+        offset = reserve(size);
+    }
+
+    std::memcpy(m_bytes.data() + offset, packet.data.constData(), static_cast<size_t>(size));
+    m_entries.push_back(Entry{offset, size, packet.timeMs, packet.keyframe});
+    m_used += size;
+    return true;
+}
+
+QVector<EncodedPacket> PacketRingBuffer::take() {
+    QVector<EncodedPacket> packets;
+    packets.reserve(static_cast<int>(m_entries.size()));
+    for (const Entry& entry : m_entries) {
+        EncodedPacket packet;
+        packet.data = QByteArray(m_bytes.data() + entry.offset, entry.size);
+        packet.timeMs = entry.timeMs;
+        packet.keyframe = entry.keyframe;
+        packets.append(std::move(packet));
+    }
+    clear();
+    return packets;
+}
+
+void PacketRingBuffer::clear() {
+    m_entries.clear();
+    m_used = 0;
+}
+
+qint64 PacketRingBuffer::spanMs() const {
+    if (m_entries.empty()) return 0;
+    return m_entries.back().timeMs - m_entries.front().timeMs;
+}
+
+int PacketRingBuffer::reserve(int size) {
+    const int cap = capacity();
+    if (m_entries.empty()) return size <= cap ? 0 : -1;
+
+    const int front = m_entries.front().offset;
+    const int end = m_entries.back().offset + m_entries.back().size;
+    if (front < end) {
+        // Held bytes are [front, end): free after them, else wrap to the start
+        if (cap - end >= size) return end;
+        if (front >= size) return 0;
+        return -1;
+    }
+    // Wrapped: held bytes are [front, cap) and [0, end)
+    return front - end >= size ? end : -1;
+}
+
+void PacketRingBuffer::popGop() {
+    if (m_entries.empty()) return;
+    do {
+        m_used -= m_entries.front().size;
+        m_entries.pop_front();
+        ++m_evicted;
+    } while (!m_entries.empty() && !m_entries.front().keyframe);
+}
+
+} // namespace CounterUAS
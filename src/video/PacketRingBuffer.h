@@ -0,0 +1,68 @@
+#ifndef PACKETRINGBUFFER_H
+#define PACKETRINGBUFFER_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <deque>
+#include <vector>
+
+#include "video/VideoEncoderBackend.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief Byte-bounded ring of encoded packets, always starting on a keyframe
+ *
+ * Packet bytes live in one block allocated by setCapacity(); each push
+ * copies into the free space after the newest packet, wrapping to the
+ * start, and evicts the oldest packets to make room. Eviction goes by
+ * whole GOPs: the ring never holds a packet whose keyframe is gone, so
+ * whatever take() returns decodes from its first packet. Not thread-safe;
+ * the owner provides locking.
+ */
+class PacketRingBuffer {
+public:
+    explicit PacketRingBuffer(int capacityBytes = 0) { setCapacity(capacityBytes); }
+
+    // Drops everything held
+    void setCapacity(int capacityBytes);
+    int capacity() const { return static_cast<int>(m_bytes.size()); }
+
+    // Oldest GOPs go once the rest still cover this much; 0 for no limit
+    void setMaxSpanMs(qint64 spanMs) { m_maxSpanMs = qMax<qint64>(0, spanMs); }
+
+    // False if the packet was not kept: larger than the ring, or waiting
+    // for a keyframe to start from
+    bool push(const EncodedPacket& packet);
+
+    // Everything held, oldest first; leaves the ring empty
+    QVector<EncodedPacket> take();
+    void clear();
+
+    bool isEmpty() const { return m_entries.empty(); }
+    int packetCount() const { return static_cast<int>(m_entries.size()); }
+    int bytesUsed() const { return m_used; }
+    qint64 spanMs() const;
+    quint64 evictedPackets() const { return m_evicted; }
+
+private:
+    struct Entry {
+        int offset = 0;
+        int size = 0;
+        qint64 timeMs = 0;
+        bool keyframe = false;
+    };
+
+    int reserve(int size);
+    void popGop();
+
+    std::vector<char> m_bytes;
+    std::deque<Entry> m_entries;
+    int m_used = 0;
+    qint64 m_maxSpanMs = 0;
+    quint64 m_evicted = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // PACKETRINGBUFFER_H
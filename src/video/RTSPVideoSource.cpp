@@ -1,6 +1,10 @@
 #include "video/RTSPVideoSource.h"
+#include "video/RtspClient.h"
+#include "video/VideoDecoder.h"
 #include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
 #include <QUrlQuery>
+#include <utility>
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QMediaContent>
@@ -8,6 +12,37 @@
 
 namespace CounterUAS {
 
+VideoFrame planarFrameFromMapped(const QVideoFrame& mapped, FramePool* pool) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const QVideoFrameFormat::PixelFormat format = mapped.pixelFormat();
+    const bool i420 = format == QVideoFrameFormat::Format_YUV420P;
+    const bool yv12 = format == QVideoFrameFormat::Format_YV12;
+    const bool nv12 = format == QVideoFrameFormat::Format_NV12;
+#else
+    const QVideoFrame::PixelFormat format = mapped.pixelFormat();
+    const bool i420 = format == QVideoFrame::Format_YUV420P;
+    const bool yv12 = format == QVideoFrame::Format_YV12;
+    const bool nv12 = format == QVideoFrame::Format_NV12;
+#endif
+    if (!i420 && !yv12 && !nv12) return VideoFrame();
+
+    const VideoPixelFormat layout = nv12 ? VideoPixelFormat::NV12 : VideoPixelFormat::YUV420P;
+    if (mapped.planeCount() != VideoFrame::planeCount(layout)) return VideoFrame();
+
+    const uchar* planes[3] = {nullptr, nullptr, nullptr};
+    int strides[3] = {0, 0, 0};
+    for (int i = 0; i < mapped.planeCount(); ++i) {
+        planes[i] = mapped.bits(i);
+        strides[i] = mapped.bytesPerLine(i);
+    }
+    if (yv12) {
+        // Same planes, V before U
+        std::swap(planes[1], planes[2]);
+        std::swap(strides[1], strides[2]);
+    }
+    return VideoFrame::fromPlanes(layout, mapped.size(), planes, strides, pool);
+}
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 // Qt5 VideoFrameGrabber implementation
 VideoFrameGrabber::VideoFrameGrabber(QObject* parent)
@@ -84,7 +119,7 @@ RTSPVideoSource::RTSPVideoSource(const QString& sourceId, QObject* parent)
 #endif
     
     // Connect frame timer
-    QObject::connect(m_frameTimer, &QTimer::timeout, this, &RTSPVideoSource::processFrame);
+    m_frameTimer.setCallback([this]() { processFrame(); });
 }
 
 RTSPVideoSource::~RTSPVideoSource() {
@@ -101,29 +136,120 @@ bool RTSPVideoSource::open(const QUrl& url) {
     }
     
     m_url = url;
-    QUrl streamUrl = buildStreamUrl(url);
-    
     setStatus(VideoSourceStatus::Connecting);
+    m_isOpen = true;
+    
+    if (m_config.lowLatencyMode && url.scheme().compare("rtsp", Qt::CaseInsensitive) == 0) {
+        openNative(url);
+    } else {
+        openPlayer(url);
+    }
+    return true;
+}
+
+void RTSPVideoSource::openPlayer(const QUrl& url) {
+    QUrl streamUrl = buildStreamUrl(url);
     
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     m_player->setSource(streamUrl);
 #else
     m_player->setMedia(QMediaContent(streamUrl));
 #endif
-    m_isOpen = true;
+    if (m_streaming) {
+        m_player->play();
+    }
     
     Logger::instance().info("RTSPVideoSource",
                            QString("%1 opening: %2")
                                .arg(m_sourceId)
                                .arg(streamUrl.toString(QUrl::RemovePassword)));
+}
+
+void RTSPVideoSource::openNative(const QUrl& url) {
+    m_rtpDecoder = new VideoDecoder(this);
+    // Two pictures of slack: a decoder that falls behind sheds, never queues
+    m_rtpDecoder->setQueueCapacity(2);
+    attachDecoder(m_rtpDecoder);
     
-    return true;
+    RtspClient::Options options;
+    options.useTcp = m_config.useTCP;
+    options.jitterBufferMs = m_config.jitterBufferMs;
+    options.timeoutMs = m_config.connectionTimeoutMs;
+    options.username = m_config.username;
+    options.password = m_config.password;
+    options.userAgent = m_config.userAgent;
+    
+    m_rtspThread = new QThread(this);
+    m_rtspThread->setObjectName(m_sourceId + "-rtsp");
+    m_rtspClient = new RtspClient();
+    m_rtspClient->setOptions(options);
+    
+    // Both run on the client's thread; the decoder is not fed from here
+    // until close() has stopped that thread
+    VideoDecoder* decoder = m_rtpDecoder;
+    m_rtspClient->setCodecCheck([decoder](const QString& codec) { return decoder->initialize(codec); });
+    m_rtspClient->setUnitSink([decoder](const QByteArray& unit, qint64 captureTimeMs) {
+        decoder->submit(unit, captureTimeMs);
+    });
+    m_rtspClient->moveToThread(m_rtspThread);
+    QObject::connect(m_rtspThread, &QThread::finished, m_rtspClient, &QObject::deleteLater);
+    
+    QObject::connect(m_rtspClient, &RtspClient::ready, this, [this](const QString& codec) {
+        m_codec = codec;
+        setStatus(VideoSourceStatus::Connected);
+        Logger::instance().info("RTSPVideoSource",
+                               QString("%1 native %2 ingest, %3 ms jitter buffer")
+                                   .arg(m_sourceId, codec)
+                                   .arg(m_config.jitterBufferMs));
+        if (m_streaming) {
+            QMetaObject::invokeMethod(m_rtspClient, "play", Qt::QueuedConnection);
+        }
+    });
+    QObject::connect(m_rtspClient, &RtspClient::playing, this, [this]() {
+        if (m_streaming) setStatus(VideoSourceStatus::Streaming);
+    });
+    QObject::connect(m_rtspClient, &RtspClient::unsupported, this, [this](const QString& reason) {
+        Logger::instance().info("RTSPVideoSource",
+                               m_sourceId + ": " + reason + ", playing through QMediaPlayer");
+        closeNative();
+        openPlayer(m_url);
+    });
+    QObject::connect(m_rtspClient, &RtspClient::failed, this, [this](const QString& reason) {
+        setError(reason);
+    });
+    
+    ThreadPlacement::instance().assign(m_rtspThread, ThreadRole::VideoDecode);
+    m_rtspThread->start();
+    QMetaObject::invokeMethod(m_rtspClient, "open", Qt::QueuedConnection, Q_ARG(QUrl, url));
+    
+    Logger::instance().info("RTSPVideoSource",
+                           QString("%1 opening (native): %2")
+                               .arg(m_sourceId)
+                               .arg(url.toString(QUrl::RemovePassword)));
+}
+
+void RTSPVideoSource::closeNative() {
+    if (!m_rtspClient) return;
+    
+    QObject::disconnect(m_rtspClient, nullptr, this, nullptr);
+    QMetaObject::invokeMethod(m_rtspClient, "shutdown", Qt::BlockingQueuedConnection);
+    m_rtspThread->quit();
+    m_rtspThread->wait();
+    delete m_rtspThread;
+    m_rtspThread = nullptr;
+    m_rtspClient = nullptr;     // Deleted on its thread's way out
+    
+    attachDecoder(nullptr);
+    delete m_rtpDecoder;
+    m_rtpDecoder = nullptr;
+    m_codec.clear();
 }
 
 void RTSPVideoSource::close() {
     if (!m_isOpen) return;
     
     stop();
+    closeNative();
     m_player->stop();
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     m_player->setSource(QUrl());
@@ -141,11 +267,47 @@ bool RTSPVideoSource::isOpen() const {
     return m_isOpen;
 }
 
+void RTSPVideoSource::start() {
+    if (m_streaming) return;
+    VideoSource::start();
+    if (!m_streaming) return;
+    
+    if (m_rtspClient) {
+        // Plays now if SETUP is done, else once ready() comes
+        QMetaObject::invokeMethod(m_rtspClient, "play", Qt::QueuedConnection);
+    } else {
+        m_player->play();
+    }
+}
+
+void RTSPVideoSource::stop() {
+    if (!m_streaming) return;
+    VideoSource::stop();
+    
+    if (m_rtspClient) {
+        QMetaObject::invokeMethod(m_rtspClient, "pause", Qt::QueuedConnection);
+    } else {
+        m_player->pause();
+    }
+}
+
+void RTSPVideoSource::collectStats() {
+    if (!m_rtspClient) return;
+    
+    const RtpReceiverStats rtp = m_rtspClient->stats();
+    m_stats.packetsReceived = static_cast<qint64>(rtp.packetsReceived);
+    m_stats.rtpPacketsLost = static_cast<qint64>(rtp.packetsLost);
+    m_stats.rtpPacketsLate = static_cast<qint64>(rtp.packetsLate);
+    m_stats.rtpJitterMs = rtp.jitterMs;
+    m_stats.jitterBufferMs = m_config.jitterBufferMs;
+}
+
 QSize RTSPVideoSource::resolution() const {
     return QSize(m_stats.width, m_stats.height);
 }
 
 QString RTSPVideoSource::codecName() const {
+    if (!m_codec.isEmpty()) return m_codec;
     // Could be extracted from media metadata
     return "H.264";
 }
@@ -179,7 +341,7 @@ void RTSPVideoSource::onMediaStatusChanged(QMediaPlayer::MediaStatus status) {
                                       m_sourceId + " end of media");
             if (m_autoReconnect) {
                 setStatus(VideoSourceStatus::Reconnecting);
-                m_reconnectTimer->start(m_reconnectIntervalMs);
+                m_reconnectTimer.start(m_reconnectIntervalMs);
             }
             break;
             
@@ -225,15 +387,18 @@ void RTSPVideoSource::onVideoFrameChanged(const QVideoFrame& frame) {
     
     m_lastFrame = frame;
     
-    // Convert to QImage
+    // Planar YUV stays YUV; anything else is converted to RGB here
     QVideoFrame f = frame;
     f.map(QVideoFrame::ReadOnly);
     
-    QImage image = f.toImage();
+    VideoFrame planar = planarFrameFromMapped(f, &m_framePool);
+    QImage image = planar.isNull() ? f.toImage() : QImage();
     
     f.unmap();
     
-    if (!image.isNull()) {
+    if (!planar.isNull()) {
+        emitFrame(planar);
+    } else if (!image.isNull()) {
         emitFrame(image);
     }
 }
@@ -273,16 +438,25 @@ void RTSPVideoSource::onFrameAvailable(const QVideoFrame& frame) {
     // Convert to QImage
     QVideoFrame f = frame;
     if (f.map(QAbstractVideoBuffer::ReadOnly)) {
-        QImage image(f.bits(),
-                     f.width(),
-                     f.height(),
-                     f.bytesPerLine(),
-                     QVideoFrame::imageFormatFromPixelFormat(f.pixelFormat()));
+        // The mapping goes away with unmap(), so this is the one copy the
+        // frame gets; it lands in a recycled buffer, planar YUV as it is
+        VideoFrame planar = planarFrameFromMapped(f, &m_framePool);
+        if (!planar.isNull()) {
+            f.unmap();
+            emitFrame(planar);
+            return;
+        }
+        
+        QImage image = m_framePool.acquireCopy(f.bits(),
+                                               f.width(),
+                                               f.height(),
+                                               f.bytesPerLine(),
+                                               QVideoFrame::imageFormatFromPixelFormat(f.pixelFormat()));
+        f.unmap();
         
         if (!image.isNull()) {
-            emitFrame(image.copy());  // copy() because original data will be unmapped
+            emitFrame(image);
         }
-        f.unmap();
     }
 }
 #endif
@@ -3,6 +3,7 @@
 
 #include "video/VideoSource.h"
 #include <QMediaPlayer>
+#include <QThread>
 #include <QtGlobal>
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -24,7 +25,10 @@ struct RTSPConfig {
     int connectionTimeoutMs = 5000;
     int bufferTimeMs = 200;
     bool useTCP = true;  // TCP vs UDP transport
+    // rtsp:// through the native RTP client and a VideoDecoder instead of
+    // QMediaPlayer, whenever a decoder backend takes the stream's codec
     bool lowLatencyMode = true;
+    int jitterBufferMs = 40;  // Longest a packet waits for reordering (native path)
     QString userAgent = "CounterUAS-C2/1.0";
 };
 
@@ -32,9 +36,25 @@ struct RTSPConfig {
 // Forward declaration for Qt5 video surface
 class VideoFrameGrabber;
 #endif
+class RtspClient;
+class VideoDecoder;
+
+/**
+ * @brief Natively planar decoder output as a VideoFrame
+ *
+ * Copies the planes of a mapped YUV 4:2:0 frame (I420, YV12 or NV12) into
+ * a pooled VideoFrame. Any other layout gives a null frame; the caller
+ * falls back to an RGB image. Shared by the Qt Multimedia sources.
+ */
+VideoFrame planarFrameFromMapped(const QVideoFrame& mapped, FramePool* pool);
 
 /**
  * @brief RTSP video source implementation using Qt Multimedia
+ *
+ * In low-latency mode an rtsp:// stream is received by RtspClient on a
+ * thread of its own and decoded by a VideoDecoder, so the only buffering
+ * is the configured jitter delay and frames carry their capture time.
+ * Streams no decoder backend takes are played through QMediaPlayer.
  */
 class RTSPVideoSource : public VideoSource {
     Q_OBJECT
@@ -49,6 +69,8 @@ public:
     bool open(const QUrl& url) override;
     void close() override;
     bool isOpen() const override;
+    void start() override;
+    void stop() override;
     
     // RTSP-specific configuration
     void setConfig(const RTSPConfig& config);
@@ -57,6 +79,10 @@ public:
     // Stream info
     QSize resolution() const;
     QString codecName() const;
+    bool isNativeIngest() const { return m_rtspClient != nullptr; }
+    
+protected:
+    void collectStats() override;
     
 protected slots:
     void processFrame() override;
@@ -76,6 +102,9 @@ private slots:
     
 private:
     QUrl buildStreamUrl(const QUrl& baseUrl);
+    void openPlayer(const QUrl& url);
+    void openNative(const QUrl& url);
+    void closeNative();
     
     QMediaPlayer* m_player;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -87,6 +116,12 @@ private:
     
     bool m_isOpen = false;
     QVideoFrame m_lastFrame;
+    
+    // Native ingest
+    QThread* m_rtspThread = nullptr;
+    RtspClient* m_rtspClient = nullptr;     // Lives on m_rtspThread
+    VideoDecoder* m_rtpDecoder = nullptr;
+    QString m_codec;
 };
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -0,0 +1,345 @@
+#include "video/RecordingStorage.h"
+#include "video/MatroskaReader.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStorageInfo>
+#include <algorithm>
+#include <limits>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr qint64 MEGABYTE = 1024 * 1024;
+const char* const STAMP_FORMAT = "yyyyMMdd'T'HHmmsszzz";
+
+QString segmentName(const QString& key, qint64 startMs) {
+    const QDateTime start = QDateTime::fromMSecsSinceEpoch(startMs, Qt::UTC);
+    return QString("%1_%2Z.mkv").arg(key, start.toString(STAMP_FORMAT));
+}
+
+// Start time from a segment's name; -1 for files this store did not name
+qint64 segmentStart(const QString& fileName) {
+    static const QRegularExpression pattern("_(\\d{8}T\\d{9})Z\\.mkv$");
+    const QRegularExpressionMatch match = pattern.match(fileName);
+    if (!match.hasMatch()) return -1;
+    QDateTime start = QDateTime::fromString(match.captured(1), STAMP_FORMAT);
+    if (!start.isValid()) return -1;
+    start.setTimeSpec(Qt::UTC);
+    return start.toMSecsSinceEpoch();
+}
+
+} // namespace
+
+RecordingStorage::RecordingStorage(QObject* parent)
+    : QObject(parent)
+{
+}
+
+RecordingStorage::~RecordingStorage() = default;
+
+void RecordingStorage::setConfig(const RecordingStorageConfig& config) {
+    QMutexLocker locker(&m_mutex);
+    m_config = config;
+    m_cameraQuotas.clear();
+    for (auto it = config.cameraQuotas.cbegin(); it != config.cameraQuotas.cend(); ++it) {
+        m_cameraQuotas.insert(cameraKey(it.key()), it.value() * MEGABYTE);
+    }
+}
+
+RecordingStorageConfig RecordingStorage::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+bool RecordingStorage::open() {
+    QMutexLocker locker(&m_mutex);
+    QDir root(m_config.directory);
+    if (!root.exists() && !root.mkpath(".")) {
+        Logger::instance().error("RecordingStorage",
+                                 "Cannot create recording directory: " + m_config.directory);
+        return false;
+    }
+
+    m_cameras.clear();
+    m_bytesUsed = 0;
+    const QStringList cameras = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& key : cameras) {
+        Segments segments;
+        const QFileInfoList files = QDir(root.filePath(key)).entryInfoList({"*.mkv"}, QDir::Files);
+        for (const QFileInfo& file : files) {
+            const qint64 startMs = segmentStart(file.fileName());
+            if (startMs < 0) continue;
+            Segment segment;
+            segment.cameraId = key;
+            segment.path = file.filePath();
+            segment.startMs = startMs;
+            segment.bytes = file.size();
+            segments.append(segment);
+        }
+        if (segments.isEmpty()) continue;
+        std::sort(segments.begin(), segments.end(),
+                  [](const Segment& a, const Segment& b) { return a.startMs < b.startMs; });
+        m_bytesUsed += usedBytes(segments);
+        m_cameras.insert(key, segments);
+    }
+
+    Logger::instance().info("RecordingStorage",
+                            QString("%1: %2 MB in %3 cameras' segments")
+                                .arg(root.absolutePath())
+                                .arg(m_bytesUsed / MEGABYTE)
+                                .arg(m_cameras.size()));
+    return true;
+}
+
+QString RecordingStorage::directory() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config.directory;
+}
+
+QString RecordingStorage::cameraDirectory(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    return QDir(m_config.directory).filePath(cameraKey(cameraId));
+}
+
+RecordingStorage::Allocation RecordingStorage::allocateSegment(const QString& cameraId, qint64 startUtcMs) {
+    Allocation allocation;
+    Segments victims;
+    QString recycled;
+    {
+        QMutexLocker locker(&m_mutex);
+        const QString key = cameraKey(cameraId);
+        const QDir dir(QDir(m_config.directory).filePath(key));
+        if (!dir.exists() && !dir.mkpath(".")) return allocation;
+
+        const qint64 need = qint64(qMax(0, m_config.segmentMegabytes)) * MEGABYTE;
+        bool overrun = false;
+
+        // The camera makes room in its own share first
+        const qint64 cameraQuota = cameraQuotaBytes(key);
+        while (!overrun && cameraQuota > 0 && usedBytes(m_cameras.value(key)) + need > cameraQuota) {
+            overrun = !evictOldest(key, victims);
+        }
+        const qint64 quota = m_config.quotaMegabytes * MEGABYTE;
+        while (!overrun && quota > 0 && m_bytesUsed + need > quota) {
+            overrun = !evictOldest(QString(), victims);
+        }
+        const QStorageInfo volume(dir.absolutePath());
+        const qint64 available = volume.isValid() ? volume.bytesAvailable() : -1;
+        const qint64 minFree = m_config.minFreeMegabytes * MEGABYTE;
+        if (available >= 0 && minFree > 0) {
+            qint64 freed = usedBytes(victims);
+            while (!overrun && available + freed - need < minFree) {
+                overrun = !evictOldest(QString(), victims);
+                if (!overrun) freed += victims.last().bytes;
+            }
+        }
+        m_stats.bytesAvailable = available;
+        if (overrun) {
+            ++m_stats.quotaOverruns;
+            Logger::instance().warning("RecordingStorage",
+                                       QString("No finished segment left to make room for %1").arg(cameraId));
+        }
+
+        // Names sort by start; a clash within the millisecond moves it on
+        qint64 startMs = startUtcMs;
+        QString path = dir.filePath(segmentName(key, startMs));
+        while (QFileInfo::exists(path) || find(path)) path = dir.filePath(segmentName(key, ++startMs));
+
+        Segment segment;
+        segment.cameraId = cameraId;
+        segment.path = path;
+        segment.startMs = startMs;
+        segment.bytes = need;
+        segment.open = true;
+        m_cameras[key].append(segment);
+        m_bytesUsed += need;
+        ++m_stats.segmentsAllocated;
+
+        allocation.path = path;
+        allocation.reserveBytes = need;
+        allocation.writeBlockBytes = qMax(0, m_config.writeBlockKilobytes) * 1024;
+        if (m_config.recycleSegments && need > 0 && !victims.isEmpty()) recycled = victims.first().path;
+    }
+
+    // The oldest victim's blocks become the new segment's
+    if (!recycled.isEmpty() && !QFile::rename(recycled, allocation.path)) recycled.clear();
+    removeFiles(victims, recycled);
+    return allocation;
+}
+
+void RecordingStorage::finishSegment(const QString& path, qint64 durationMs, qint64 dataBytes) {
+    QVariantMap metadata;
+    {
+        QMutexLocker locker(&m_mutex);
+        Segment* segment = find(path);
+        if (!segment) return;
+
+        const qint64 reserved = segment->bytes;
+        const qint64 bytes = QFileInfo(path).size();
+        m_bytesUsed += bytes - reserved;
+        segment->bytes = bytes;
+        segment->open = false;
+        // A reserved segment closes at exactly its reservation
+        if (reserved > 0 && bytes != reserved) ++m_stats.preallocationFailures;
+
+        metadata["cameraId"] = segment->cameraId;
+        metadata["startTime"] = segment->startMs;
+        metadata["duration"] = durationMs;
+        metadata["bytes"] = dataBytes;
+        metadata["fileBytes"] = bytes;
+    }
+    emit segmentFinished(QFileInfo(path).completeBaseName(), path, metadata);
+}
+
+void RecordingStorage::abandonSegment(const QString& path) {
+    {
+        QMutexLocker locker(&m_mutex);
+        const QString key = QFileInfo(path).dir().dirName();
+        auto it = m_cameras.find(key);
+        if (it == m_cameras.end()) return;
+        for (int i = 0; i < it->size(); ++i) {
+            if (it->at(i).path != path) continue;
+            m_bytesUsed -= it->at(i).bytes;
+            it->remove(i);
+            break;
+        }
+    }
+    QFile::remove(path);
+}
+
+qint64 RecordingStorage::cameraBytes(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    return usedBytes(m_cameras.value(cameraKey(cameraId)));
+}
+
+QStringList RecordingStorage::segments(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    QStringList paths;
+    for (const Segment& segment : m_cameras.value(cameraKey(cameraId))) paths.append(segment.path);
+    return paths;
+}
+
+QString RecordingStorage::writeCapture(const QString& cameraId, const QString& fileName,
+                                      const QByteArray& data) {
+    QString dirPath;
+    {
+        QMutexLocker locker(&m_mutex);
+        dirPath = QDir(QDir(m_config.directory).filePath(cameraKey(cameraId))).filePath("captures");
+    }
+    // Written outside the lock; the recorders' allocations do not wait on it
+    const QDir dir(dirPath);
+    if (!dir.exists() && !dir.mkpath(".")) return QString();
+    const QString path = dir.filePath(fileName);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        Logger::instance().warning("RecordingStorage", "Cannot write capture: " + path);
+        file.remove();
+        return QString();
+    }
+    file.close();
+
+    QMutexLocker locker(&m_mutex);
+    ++m_stats.captures;
+    m_stats.captureBytes += data.size();
+    return path;
+}
+
+RecordingStorageStats RecordingStorage::stats() const {
+    QMutexLocker locker(&m_mutex);
+    RecordingStorageStats stats = m_stats;
+    stats.bytesUsed = m_bytesUsed;
+    stats.cameras = 0;
+    for (const Segments& segments : m_cameras) {
+        if (segments.isEmpty()) continue;
+        ++stats.cameras;
+        stats.segments += segments.size();
+        for (const Segment& segment : segments) {
+            if (segment.open) ++stats.openSegments;
+        }
+    }
+    return stats;
+}
+
+QString RecordingStorage::cameraKey(const QString& cameraId) {
+    QString key = cameraId;
+    key.replace(QRegularExpression("[^A-Za-z0-9_-]"), "_");
+    return key.isEmpty() ? QStringLiteral("_") : key;
+}
+
+qint64 RecordingStorage::usedBytes(const Segments& segments) {
+    qint64 bytes = 0;
+    for (const Segment& segment : segments) bytes += segment.bytes;
+    return bytes;
+}
+
+qint64 RecordingStorage::cameraQuotaBytes(const QString& key) const {
+    return m_cameraQuotas.value(key, m_config.cameraQuotaMegabytes * MEGABYTE);
+}
+
+bool RecordingStorage::evictOldest(const QString& key, Segments& victims) {
+    // Open segments are the newest of their camera, so the first finished
+    // one is its oldest
+    auto firstFinished = [](const Segments& segments) {
+        for (int i = 0; i < segments.size(); ++i) {
+            if (!segments.at(i).open) return i;
+        }
+        return -1;
+    };
+
+    QString from = key;
+    int index = -1;
+    if (!key.isEmpty()) {
+        index = firstFinished(m_cameras.value(key));
+    } else {
+        qint64 oldest = std::numeric_limits<qint64>::max();
+        for (auto it = m_cameras.cbegin(); it != m_cameras.cend(); ++it) {
+            const int i = firstFinished(it.value());
+            if (i >= 0 && it->at(i).startMs < oldest) {
+                oldest = it->at(i).startMs;
+                from = it.key();
+                index = i;
+            }
+        }
+    }
+    if (index < 0) return false;
+
+    Segments& segments = m_cameras[from];
+    victims.append(segments.at(index));
+    segments.remove(index);
+    m_bytesUsed -= victims.last().bytes;
+    return true;
+}
+
+RecordingStorage::Segment* RecordingStorage::find(const QString& path) {
+    auto it = m_cameras.find(QFileInfo(path).dir().dirName());
+    if (it == m_cameras.end()) return nullptr;
+    for (Segment& segment : *it) {
+        if (segment.path == path) return &segment;
+    }
+    return nullptr;
+}
+
+void RecordingStorage::removeFiles(const Segments& victims, const QString& recycled) {
+    quint64 deleted = 0;
+    for (const Segment& victim : victims) {
+        if (victim.path != recycled && !QFile::remove(victim.path) && QFileInfo::exists(victim.path)) {
+            Logger::instance().warning("RecordingStorage", "Cannot delete segment: " + victim.path);
+            continue;
+        }
+        QFile::remove(MatroskaReader::indexPath(victim.path));
+        ++deleted;
+        emit segmentDeleted(QFileInfo(victim.path).completeBaseName(), victim.path);
+    }
+    if (victims.isEmpty()) return;
+
+    QMutexLocker locker(&m_mutex);
+    m_stats.segmentsDeleted += deleted;
+    if (!recycled.isEmpty()) ++m_stats.segmentsRecycled;
+}
+
+} // namespace CounterUAS
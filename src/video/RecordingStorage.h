@@ -0,0 +1,139 @@
+#ifndef RECORDINGSTORAGE_H
+#define RECORDINGSTORAGE_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+namespace CounterUAS {
+
+/**
+ * @brief Recording storage configuration
+ */
+struct RecordingStorageConfig {
+    QString directory = "recordings";   // One subdirectory per camera
+    int segmentMegabytes = 256;         // Preallocated per segment; 0 grows files as written
+    int writeBlockKilobytes = 1024;     // Aligned write size; 0 writes each element as muxed
+    qint64 quotaMegabytes = 0;          // All cameras together; 0 for none
+    qint64 cameraQuotaMegabytes = 0;    // Each camera not in cameraQuotas; 0 for none
+    QHash<QString, qint64> cameraQuotas;    // Megabytes by camera id
+    qint64 minFreeMegabytes = 2048;     // Kept free on the volume
+    bool recycleSegments = true;        // The next segment reuses an evicted file's blocks
+};
+
+/**
+ * @brief Storage counters, safe to read from any thread
+ */
+struct RecordingStorageStats {
+    qint64 bytesUsed = 0;               // On disk, open segments at their reservation
+    qint64 bytesAvailable = -1;         // On the volume at the last allocation
+    int cameras = 0;
+    int segments = 0;
+    int openSegments = 0;
+    quint64 segmentsAllocated = 0;
+    quint64 segmentsDeleted = 0;
+    quint64 segmentsRecycled = 0;
+    quint64 preallocationFailures = 0;
+    quint64 quotaOverruns = 0;          // Allocated with nothing left to evict
+    quint64 captures = 0;               // Stills written through writeCapture()
+    qint64 captureBytes = 0;
+};
+
+/**
+ * @brief Rolling store of continuous recordings under disk quotas
+ *
+ * Each camera records into its own directory as fixed-size segments,
+ * <camera>_<UTC start>.mkv, preallocated to segmentMegabytes so a day of
+ * sixteen streams does not interleave their blocks across the volume.
+ * Before a segment is handed out the quotas are settled: the camera's own
+ * first, then the global one and the free-space floor, each by evicting
+ * the oldest finished segments. With recycleSegments the first evicted
+ * file is renamed to the new segment rather than deleted, so at steady
+ * state the store writes over the same allocations and the load on the
+ * disk is one sequential stream per camera. Segments still being written
+ * are never evicted; if nothing else is left the allocation goes ahead
+ * and is counted as an overrun.
+ *
+ * Finished and evicted segments are signalled for the clip index kept in
+ * DatabaseManager. open() takes in what earlier runs left, so the quotas
+ * hold across restarts. Everything is safe from any thread, for the
+ * recorders' writer threads.
+ */
+class RecordingStorage : public QObject {
+    Q_OBJECT
+
+public:
+    struct Allocation {
+        QString path;               // Empty if the directory cannot be written
+        qint64 reserveBytes = 0;    // For MatroskaWriter::setReserve()
+        int writeBlockBytes = 0;
+    };
+
+    explicit RecordingStorage(QObject* parent = nullptr);
+    ~RecordingStorage() override;
+
+    // Before open()
+    void setConfig(const RecordingStorageConfig& config);
+    RecordingStorageConfig config() const;
+
+    // Creates the directory and indexes the segments already in it
+    bool open();
+    QString directory() const;
+    QString cameraDirectory(const QString& cameraId) const;
+
+    // A new segment for the camera, starting at startUtcMs; its file is
+    // created by the writer. finishSegment() once it is closed, or
+    // abandonSegment() if it never opened
+    Allocation allocateSegment(const QString& cameraId, qint64 startUtcMs);
+    void finishSegment(const QString& path, qint64 durationMs, qint64 dataBytes);
+    void abandonSegment(const QString& path);
+
+    // A still from CaptureService, into the camera's captures directory.
+    // Stills are evidence: outside the quotas and never evicted. Returns
+    // the path, empty if the file could not be written.
+    QString writeCapture(const QString& cameraId, const QString& fileName, const QByteArray& data);
+
+    qint64 cameraBytes(const QString& cameraId) const;
+    QStringList segments(const QString& cameraId) const;   // Oldest first
+    RecordingStorageStats stats() const;
+
+    // The camera id as a directory name
+    static QString cameraKey(const QString& cameraId);
+
+signals:
+    // From the thread that finished or allocated; clipId is the file's base name
+    void segmentFinished(const QString& clipId, const QString& path, const QVariantMap& metadata);
+    void segmentDeleted(const QString& clipId, const QString& path);
+
+private:
+    struct Segment {
+        QString cameraId;
+        QString path;
+        qint64 startMs = 0;
+        qint64 bytes = 0;
+        bool open = false;
+    };
+    using Segments = QVector<Segment>;
+
+    static qint64 usedBytes(const Segments& segments);
+    qint64 cameraQuotaBytes(const QString& key) const;
+    // Takes the oldest finished segment of one camera, or of any for an empty key
+    bool evictOldest(const QString& key, Segments& victims);
+    Segment* find(const QString& path);
+    void removeFiles(const Segments& victims, const QString& recycled);
+
+    mutable QMutex m_mutex;
+    RecordingStorageConfig m_config;
+    QHash<QString, qint64> m_cameraQuotas;  // Bytes by camera key
+    QHash<QString, Segments> m_cameras;     // Oldest first, by camera key
+    qint64 m_bytesUsed = 0;
+    RecordingStorageStats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // RECORDINGSTORAGE_H
@@ -0,0 +1,88 @@
+#include "video/RemoteVideoSource.h"
+#include "video/VideoServiceClient.h"
+#include "utils/Logger.h"
+
+namespace CounterUAS {
+
+RemoteVideoSource::RemoteVideoSource(const CameraDefinition& camera, VideoServiceClient* client,
+                                     QObject* parent)
+    : VideoSource(camera.cameraId, parent)
+    , m_camera(camera)
+    , m_client(client)
+{
+    connect(client, &VideoServiceClient::videoFrameReceived,
+            this, [this](const QString& cameraId, const VideoFrame& frame, qint64 timestampMs) {
+        if (cameraId == m_sourceId && m_streaming) emitFrame(frame, timestampMs);
+    });
+    connect(client, &VideoServiceClient::streamStatusChanged,
+            this, [this](const QString& cameraId, VideoSourceStatus status) {
+        if (cameraId == m_sourceId && m_open) setStatus(status);
+    });
+    connect(client, &VideoServiceClient::connectedChanged,
+            this, &RemoteVideoSource::onServiceConnected);
+}
+
+RemoteVideoSource::~RemoteVideoSource() {
+    close();
+}
+
+bool RemoteVideoSource::open(const QUrl& url) {
+    if (!m_client) {
+        setError("Video service gone");
+        return false;
+    }
+    if (url.isValid()) m_camera.streamUrl = url.toString();
+    m_url = QUrl(m_camera.streamUrl);
+    m_open = true;
+    m_client->addStream(m_camera);
+    setStatus(m_client->isConnected() ? VideoSourceStatus::Connecting : VideoSourceStatus::Reconnecting);
+    return true;
+}
+
+void RemoteVideoSource::close() {
+    if (!m_open) return;
+    stop();
+    m_open = false;
+    if (m_client) m_client->removeStream(m_sourceId);
+    setStatus(VideoSourceStatus::Disconnected);
+}
+
+void RemoteVideoSource::start() {
+    if (m_streaming) return;
+    if (!isOpen()) {
+        setError("Cannot start: source not open");
+        return;
+    }
+
+    // No frame timer: the service's frames drive emitFrame()
+    m_streaming = true;
+    m_statsTimer.start();
+    if (m_client) m_client->startStream(m_sourceId);
+    emit streamingChanged(true);
+}
+
+void RemoteVideoSource::stop() {
+    if (!m_streaming) return;
+
+    m_streaming = false;
+    m_statsTimer.stop();
+    if (m_client) m_client->stopStream(m_sourceId);
+    emit streamingChanged(false);
+}
+
+void RemoteVideoSource::onServiceConnected(bool connected) {
+    if (!m_open) return;
+    if (!connected) {
+        setStatus(VideoSourceStatus::Reconnecting);
+        return;
+    }
+
+    // A service that restarted has forgotten the stream; one that did not
+    // takes the request as a no-op
+    m_client->addStream(m_camera);
+    if (m_streaming) m_client->startStream(m_sourceId);
+    setStatus(m_client->streamStatus(m_sourceId));
+    Logger::instance().info("RemoteVideoSource", m_sourceId + " rejoined the video service");
+}
+
+} // namespace CounterUAS
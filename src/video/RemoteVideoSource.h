@@ -0,0 +1,52 @@
+#ifndef REMOTEVIDEOSOURCE_H
+#define REMOTEVIDEOSOURCE_H
+
+#include "video/VideoSource.h"
+#include "video/VideoStreamManager.h"
+#include <QPointer>
+
+namespace CounterUAS {
+
+class VideoServiceClient;
+
+/**
+ * @brief A camera decoded by the video service, as a local VideoSource
+ *
+ * open() asks the service for the stream and start()/stop() run it
+ * there; the frames the service publishes come back through the client
+ * and leave here as this source's own, so displays, the distributor and
+ * the camera panel cannot tell it from a source in the process. The
+ * status is the service's. When the service comes back after a restart
+ * the stream is asked for again, and started again if it was streaming.
+ */
+class RemoteVideoSource : public VideoSource {
+    Q_OBJECT
+
+public:
+    RemoteVideoSource(const CameraDefinition& camera, VideoServiceClient* client,
+                      QObject* parent = nullptr);
+    ~RemoteVideoSource() override;
+
+    QString sourceType() const override { return "REMOTE"; }
+
+    bool open(const QUrl& url) override;
+    void close() override;
+    bool isOpen() const override { return m_open; }
+
+    void start() override;
+    void stop() override;
+
+protected slots:
+    void processFrame() override {}   // Frames are pushed by the service
+
+private:
+    void onServiceConnected(bool connected);
+
+    CameraDefinition m_camera;
+    QPointer<VideoServiceClient> m_client;
+    bool m_open = false;
+};
+
+} // namespace CounterUAS
+
+#endif // REMOTEVIDEOSOURCE_H
@@ -0,0 +1,156 @@
+#include "video/RoiTrackingStage.h"
+#include "core/TrackManager.h"
+#include "video/CameraSlewController.h"
+#include "video/VideoStreamManager.h"
+#include <QElapsedTimer>
+#include <QSet>
+#include <algorithm>
+
+namespace CounterUAS {
+
+RoiTrackingStage::RoiTrackingStage(QObject* parent)
+    : QObject(parent)
+{
+}
+
+RoiTrackingStage::~RoiTrackingStage() {
+    if (m_videoManager && m_subscriptionId) m_videoManager->unsubscribeFrames(m_subscriptionId);
+}
+
+void RoiTrackingStage::setTrackManager(TrackManager* manager) {
+    m_trackManager = manager;
+    m_targets.clear();
+}
+
+void RoiTrackingStage::setSlewController(CameraSlewController* controller) {
+    m_slewController = controller;
+}
+
+void RoiTrackingStage::setVideoStreamManager(VideoStreamManager* manager) {
+    if (m_videoManager) {
+        disconnect(m_videoManager, nullptr, this, nullptr);
+        if (m_subscriptionId) m_videoManager->unsubscribeFrames(m_subscriptionId);
+    }
+    m_subscriptionId = 0;
+    m_videoManager = manager;
+    if (!m_videoManager) return;
+
+    connect(m_videoManager, &VideoStreamManager::primaryStreamChanged,
+            this, &RoiTrackingStage::onPrimaryStreamChanged);
+    onPrimaryStreamChanged(m_videoManager->primaryStreamId());
+}
+
+void RoiTrackingStage::setConfig(const RoiTrackingConfig& config) {
+    m_config = config;
+    m_targets.clear();    // Trackers are sized by the config
+}
+
+RoiTrackingStats RoiTrackingStage::stats() const {
+    RoiTrackingStats stats = m_stats;
+    stats.updateMeanUs = m_updateLatency.meanUs;
+    stats.updateMaxUs = double(m_updateLatency.maxUs);
+    return stats;
+}
+
+void RoiTrackingStage::onPrimaryStreamChanged(const QString& cameraId) {
+    if (m_videoManager && m_subscriptionId) m_videoManager->unsubscribeFrames(m_subscriptionId);
+    m_subscriptionId = 0;
+    m_targets.clear();
+    if (!m_videoManager || cameraId.isEmpty()) return;
+
+    // Native size, every frame the stage keeps up with
+    VideoDeliveryPolicy policy;
+    policy.latestOnly = true;
+    m_subscriptionId = m_videoManager->subscribeFrames(
+        cameraId, this, policy,
+        [this, cameraId](const VideoFrame& frame, qint64 timestamp, const QSize&) {
+            processFrame(cameraId, frame, timestamp);
+        });
+}
+
+void RoiTrackingStage::processFrame(const QString& cameraId, const VideoFrame& frame, qint64 timestamp) {
+    if (!m_trackManager || frame.isNull()) return;
+    m_stats.frames++;
+
+    // Tracks this camera sees, highest threat first
+    TrackPicturePtr picture = m_trackManager->snapshot();
+    QVector<const TrackSnapshot*> candidates;
+    for (const TrackSnapshot& track : picture->tracks) {
+        if (track.associatedCameraId == cameraId && track.state != TrackState::Dropped) {
+            candidates.append(&track);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const TrackSnapshot* a, const TrackSnapshot* b) { return a->threatLevel > b->threatLevel; });
+    if (candidates.size() > m_config.maxTracks) candidates.resize(qMax(0, m_config.maxTracks));
+
+    QSet<QString> followed;
+    for (const TrackSnapshot* track : candidates) {
+        const BoundingBox box = m_trackManager->trackBoundingBox(track->trackId);
+        if (!box.isValid()) continue;
+        followed.insert(track->trackId);
+
+        auto it = m_targets.find(track->trackId);
+        if (it == m_targets.end() || it->cameraId != cameraId) {
+            Target target{cameraId, CorrelationTracker(m_config.tracker), BoundingBox(), false};
+            it = m_targets.insert(track->trackId, target);
+        }
+        Target& target = it.value();
+
+        // Not the box written last: the detector has been over it since
+        if (!sameBox(box, target.written)) {
+            target.written = box;
+            target.lost = !target.tracker.init(frame, QRectF(box.x, box.y, box.width, box.height));
+            if (!target.lost) m_stats.initialised++;
+            continue;
+        }
+        if (target.lost) continue;
+
+        QElapsedTimer timer;
+        timer.start();
+        QRectF predicted = target.tracker.box();
+        if (m_slewController) {
+            m_slewController->predictedBox(cameraId, *track, picture->timestampMs, timestamp,
+                                           frame.size(), predicted.size(), predicted);
+        }
+        QRectF found;
+        const bool tracked = target.tracker.update(frame, predicted, found);
+        m_updateLatency.record(timer.nsecsElapsed() / 1000);
+
+        if (!tracked) {
+            target.lost = true;
+            m_stats.lost++;
+            emit targetLost(track->trackId);
+            continue;
+        }
+        BoundingBox updated;
+        updated.x = qRound(found.x());
+        updated.y = qRound(found.y());
+        updated.width = qRound(found.width());
+        updated.height = qRound(found.height());
+        updated.cameraId = cameraId;
+        updated.timestamp = timestamp;
+        m_trackManager->setTrackBoundingBox(track->trackId, updated);
+        target.written = updated;
+        m_stats.updates++;
+    }
+
+    // Tracks gone from this camera, or without a box any more
+    int active = 0;
+    for (auto it = m_targets.begin(); it != m_targets.end();) {
+        if (it->cameraId == cameraId && !followed.contains(it.key())) {
+            it = m_targets.erase(it);
+        } else {
+            if (!it->lost) ++active;
+            ++it;
+        }
+    }
+    m_stats.activeTracks = active;
+}
+
+bool RoiTrackingStage::sameBox(const BoundingBox& a, const BoundingBox& b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height &&
+           a.timestamp == b.timestamp && a.cameraId == b.cameraId;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,102 @@
+#ifndef ROITRACKINGSTAGE_H
+#define ROITRACKINGSTAGE_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include "core/Track.h"
+#include "utils/LatencyStats.h"
+#include "video/CorrelationTracker.h"
+
+namespace CounterUAS {
+
+class CameraSlewController;
+class TrackManager;
+class VideoStreamManager;
+
+/**
+ * @brief Which tracks the ROI stage follows
+ */
+struct RoiTrackingConfig {
+    CorrelationTrackerConfig tracker;
+    int maxTracks = 8;              // Highest threat levels first
+};
+
+/**
+ * @brief Per-frame cost and outcomes of ROI tracking
+ */
+struct RoiTrackingStats {
+    int activeTracks = 0;
+    quint64 frames = 0;
+    quint64 updates = 0;            // Boxes written to tracks
+    quint64 initialised = 0;        // From a detector's box
+    quint64 lost = 0;
+    double updateMeanUs = 0.0;      // Per track and frame
+    double updateMaxUs = 0.0;
+};
+
+/**
+ * @brief Follows tracks' boxes at frame rate between detector runs
+ *
+ * For every track on the primary stream with a bounding box, a
+ * CorrelationTracker is started from the box the detector last gave it
+ * and run on each frame in a window around the box's predicted position:
+ * from CameraSlewController when the camera has a PTZ controller, so
+ * the camera's own slewing is accounted for, or else where the tracker
+ * last found it. The box found is written back with setTrackBoundingBox().
+ *
+ * A new box from the detector restarts the track's tracker; a tracker
+ * that loses its target stops writing until then.
+ *
+ * Frames arrive queued on the thread the stage lives on.
+ */
+class RoiTrackingStage : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RoiTrackingStage(QObject* parent = nullptr);
+    ~RoiTrackingStage() override;
+
+    void setTrackManager(TrackManager* manager);
+    void setSlewController(CameraSlewController* controller);
+    // Follows the manager's primary stream
+    void setVideoStreamManager(VideoStreamManager* manager);
+
+    void setConfig(const RoiTrackingConfig& config);
+    RoiTrackingConfig config() const { return m_config; }
+    RoiTrackingStats stats() const;
+
+    // One frame of cameraId captured at timestamp (Unix ms)
+    void processFrame(const QString& cameraId, const VideoFrame& frame, qint64 timestamp);
+
+signals:
+    void targetLost(const QString& trackId);
+
+private slots:
+    void onPrimaryStreamChanged(const QString& cameraId);
+
+private:
+    struct Target {
+        QString cameraId;
+        CorrelationTracker tracker;
+        BoundingBox written;        // Last box this stage gave the track
+        bool lost = false;
+    };
+
+    static bool sameBox(const BoundingBox& a, const BoundingBox& b);
+
+    QPointer<TrackManager> m_trackManager;
+    QPointer<CameraSlewController> m_slewController;
+    QPointer<VideoStreamManager> m_videoManager;
+    int m_subscriptionId = 0;
+
+    RoiTrackingConfig m_config;
+    QHash<QString, Target> m_targets;   // By track
+    RoiTrackingStats m_stats;
+    LatencyStats m_updateLatency;
+};
+
+} // namespace CounterUAS
+
+#endif // ROITRACKINGSTAGE_H
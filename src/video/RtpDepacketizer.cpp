@@ -0,0 +1,370 @@
+#include "video/RtpDepacketizer.h"
+#include <QStringList>
+#include <QtEndian>
+
+namespace CounterUAS {
+
+namespace {
+
+const char START_CODE[4] = {0, 0, 0, 1};
+
+// RFC 2435 appendix A / ITU T.81 annex K, natural order
+const uchar LUMA_QUANTIZER[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,
+    12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,
+    14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77,
+    24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99
+};
+
+const uchar CHROMA_QUANTIZER[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+// Natural-order index of each zigzag position
+const uchar ZIGZAG[64] = {
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// ITU T.81 annex K.3 Huffman tables: code counts by length, then symbols
+const uchar LUMA_DC_CODELENS[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+const uchar LUMA_DC_SYMBOLS[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+const uchar LUMA_AC_CODELENS[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+const uchar LUMA_AC_SYMBOLS[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+const uchar CHROMA_DC_CODELENS[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+const uchar CHROMA_DC_SYMBOLS[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+const uchar CHROMA_AC_CODELENS[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+const uchar CHROMA_AC_SYMBOLS[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+void appendMarker(QByteArray& out, uchar marker, int length) {
+    out.append(char(0xff));
+    out.append(char(marker));
+    out.append(char(length >> 8));
+    out.append(char(length & 0xff));
+}
+
+void appendHuffman(QByteArray& out, int tableClassId, const uchar* codelens,
+                   const uchar* symbols, int symbolCount) {
+    appendMarker(out, 0xc4, 3 + 16 + symbolCount);
+    out.append(char(tableClassId));
+    out.append(reinterpret_cast<const char*>(codelens), 16);
+    out.append(reinterpret_cast<const char*>(symbols), symbolCount);
+}
+
+QString fmtpParameter(const QString& fmtp, const QString& name) {
+    for (const QString& part : fmtp.split(';', Qt::SkipEmptyParts)) {
+        const int eq = part.indexOf('=');
+        if (eq > 0 && part.left(eq).trimmed().compare(name, Qt::CaseInsensitive) == 0) {
+            return part.mid(eq + 1).trimmed();
+        }
+    }
+    return QString();
+}
+
+} // namespace
+
+std::unique_ptr<RtpDepacketizer> RtpDepacketizer::create(const QString& encoding,
+                                                         const QString& fmtp) {
+    const QString name = encoding.toUpper();
+    if (name == "H264") {
+        // Interleaved mode (2) reorders NAL units across pictures
+        if (fmtpParameter(fmtp, "packetization-mode").toInt() > 1) return nullptr;
+        return std::unique_ptr<RtpDepacketizer>(new H264RtpDepacketizer(fmtp));
+    }
+    if (name == "JPEG") {
+        return std::unique_ptr<RtpDepacketizer>(new JpegRtpDepacketizer);
+    }
+    return nullptr;
+}
+
+H264RtpDepacketizer::H264RtpDepacketizer(const QString& fmtp) {
+    const QString sets = fmtpParameter(fmtp, "sprop-parameter-sets");
+    for (const QString& set : sets.split(',', Qt::SkipEmptyParts)) {
+        const QByteArray nal = QByteArray::fromBase64(set.toLatin1());
+        if (nal.isEmpty()) continue;
+        m_parameterSets.append(START_CODE, 4);
+        m_parameterSets.append(nal);
+    }
+}
+
+void H264RtpDepacketizer::push(const RtpPacket& packet, QVector<RtpAccessUnit>& out) {
+    // A picture whose marker never came ends where the next one starts
+    if (!m_pending.isEmpty() && packet.timestamp != m_timestamp) {
+        m_inFragment = false;
+        finish(out);
+    }
+    m_timestamp = packet.timestamp;
+
+    const uchar* p = packet.payload();
+    const int n = packet.payloadSize;
+    const int type = p[0] & 0x1f;
+
+    if (type >= 1 && type <= 23) {
+        m_inFragment = false;
+        appendNal(p, n);
+    } else if (type == 24) {
+        // STAP-A: 16-bit sizes, each followed by its NAL unit
+        m_inFragment = false;
+        int offset = 1;
+        while (offset + 2 <= n) {
+            const int size = qFromBigEndian<quint16>(p + offset);
+            offset += 2;
+            if (size == 0 || offset + size > n) break;
+            appendNal(p + offset, size);
+            offset += size;
+        }
+    } else if (type == 28 && n > 2) {
+        // FU-A: the NAL header is rebuilt from the indicator and FU header
+        const uchar fu = p[1];
+        if (fu & 0x80) {
+            m_pending.append(START_CODE, 4);
+            m_pending.append(char((p[0] & 0xe0) | (fu & 0x1f)));
+            noteNalType(fu & 0x1f);
+            m_inFragment = true;
+        }
+        if (m_inFragment) {
+            m_pending.append(reinterpret_cast<const char*>(p + 2), n - 2);
+            if (fu & 0x40) m_inFragment = false;
+        }
+    }
+
+    if (packet.marker) {
+        m_inFragment = false;
+        finish(out);
+    }
+}
+
+void H264RtpDepacketizer::discard() {
+    if (!m_pending.isEmpty()) ++m_dropped;
+    m_pending.clear();
+    m_inFragment = false;
+    m_keyframe = false;
+    m_hasSps = false;
+}
+
+void H264RtpDepacketizer::appendNal(const uchar* nal, int size) {
+    if (size <= 0) return;
+    m_pending.append(START_CODE, 4);
+    m_pending.append(reinterpret_cast<const char*>(nal), size);
+    noteNalType(nal[0] & 0x1f);
+}
+
+void H264RtpDepacketizer::noteNalType(int type) {
+    if (type == 5) m_keyframe = true;
+    else if (type == 7) m_hasSps = true;
+}
+
+void H264RtpDepacketizer::finish(QVector<RtpAccessUnit>& out) {
+    if (!m_pending.isEmpty()) {
+        m_seenKeyframe = m_seenKeyframe || m_keyframe;
+        if (!m_seenKeyframe) {
+            ++m_dropped;
+        } else {
+            RtpAccessUnit unit;
+            if (m_keyframe && !m_hasSps) unit.data = m_parameterSets;
+            unit.data.append(m_pending);
+            unit.rtpTimestamp = m_timestamp;
+            unit.keyframe = m_keyframe;
+            out.append(unit);
+        }
+    }
+    m_pending.clear();
+    m_keyframe = false;
+    m_hasSps = false;
+}
+
+void JpegRtpDepacketizer::push(const RtpPacket& packet, QVector<RtpAccessUnit>& out) {
+    const uchar* p = packet.payload();
+    const int n = packet.payloadSize;
+    if (n < 8) return;
+
+    const int fragmentOffset = (p[1] << 16) | (p[2] << 8) | p[3];
+    int type = p[4];
+    const int q = p[5];
+    int pos = 8;
+
+    int restartInterval = 0;
+    if (type >= 64 && type <= 127) {
+        if (n < pos + 4) return;
+        restartInterval = qFromBigEndian<quint16>(p + pos);
+        type -= 64;
+        pos += 4;
+    }
+
+    if (fragmentOffset == 0) {
+        if (m_active) ++m_dropped;    // The previous picture never finished
+        m_active = false;
+        if (type > 1) return;
+
+        QByteArray tables;
+        if (q >= 128) {
+            // Quantisation table header; a length of 0 points at the cache
+            if (n < pos + 4) return;
+            const int precision = p[pos + 1];
+            const int length = qFromBigEndian<quint16>(p + pos + 2);
+            pos += 4;
+            if (length > 0) {
+                if (precision != 0 || length != 128 || n < pos + length) return;
+                tables = QByteArray(reinterpret_cast<const char*>(p + pos), length);
+                pos += length;
+                if (q < 255) {
+                    m_cachedTables = tables;
+                    m_cachedQ = q;
+                }
+            } else if (q == m_cachedQ) {
+                tables = m_cachedTables;
+            } else {
+                return;
+            }
+        } else {
+            tables = standardTables(q);
+        }
+
+        m_scan.clear();
+        m_tables = tables;
+        m_type = type;
+        m_width = p[6] * 8;
+        m_height = p[7] * 8;
+        m_restartInterval = restartInterval;
+        m_timestamp = packet.timestamp;
+        m_active = m_width > 0 && m_height > 0;
+    }
+
+    if (!m_active) return;
+    if (packet.timestamp != m_timestamp || fragmentOffset != m_scan.size()) {
+        discard();
+        return;
+    }
+    m_scan.append(reinterpret_cast<const char*>(p + pos), n - pos);
+
+    if (packet.marker) {
+        RtpAccessUnit unit;
+        unit.data = makeHeaders(m_type, m_width, m_height, m_tables, m_restartInterval);
+        unit.data.append(m_scan);
+        if (!m_scan.endsWith("\xff\xd9")) unit.data.append("\xff\xd9", 2);
+        unit.rtpTimestamp = m_timestamp;
+        unit.keyframe = true;
+        out.append(unit);
+        m_scan.clear();
+        m_active = false;
+    }
+}
+
+void JpegRtpDepacketizer::discard() {
+    if (m_active) ++m_dropped;
+    m_scan.clear();
+    m_active = false;
+}
+
+QByteArray JpegRtpDepacketizer::standardTables(int q) {
+    // RFC 2435 appendix A, the IJG quality scaling
+    const int factor = qBound(1, q, 99);
+    const int scale = factor < 50 ? 5000 / factor : 200 - factor * 2;
+
+    QByteArray tables(128, Qt::Uninitialized);
+    for (int i = 0; i < 64; ++i) {
+        const int luma = (LUMA_QUANTIZER[ZIGZAG[i]] * scale + 50) / 100;
+        const int chroma = (CHROMA_QUANTIZER[ZIGZAG[i]] * scale + 50) / 100;
+        tables[i] = char(qBound(1, luma, 255));
+        tables[64 + i] = char(qBound(1, chroma, 255));
+    }
+    return tables;
+}
+
+QByteArray JpegRtpDepacketizer::makeHeaders(int type, int width, int height,
+                                            const QByteArray& tables, int restartInterval) {
+    QByteArray out;
+    out.reserve(640);
+    out.append("\xff\xd8", 2);
+
+    // One DQT per table; a single table serves both when only 64 came
+    const int tableCount = tables.size() >= 128 ? 2 : 1;
+    for (int t = 0; t < tableCount; ++t) {
+        appendMarker(out, 0xdb, 67);
+        out.append(char(t));
+        out.append(tables.constData() + t * 64, 64);
+    }
+
+    if (restartInterval > 0) {
+        appendMarker(out, 0xdd, 4);
+        out.append(char(restartInterval >> 8));
+        out.append(char(restartInterval & 0xff));
+    }
+
+    // Baseline SOF0: luma sampled 2x1 (type 0) or 2x2 (type 1), chroma 1x1
+    appendMarker(out, 0xc0, 17);
+    out.append(char(8));
+    out.append(char(height >> 8));
+    out.append(char(height & 0xff));
+    out.append(char(width >> 8));
+    out.append(char(width & 0xff));
+    out.append(char(3));
+    out.append(char(1));
+    out.append(char(type == 0 ? 0x21 : 0x22));
+    out.append(char(0));
+    const char chromaTable = char(tableCount - 1);
+    out.append(char(2));
+    out.append(char(0x11));
+    out.append(chromaTable);
+    out.append(char(3));
+    out.append(char(0x11));
+    out.append(chromaTable);
+
+    appendHuffman(out, 0x00, LUMA_DC_CODELENS, LUMA_DC_SYMBOLS, sizeof(LUMA_DC_SYMBOLS));
+    appendHuffman(out, 0x10, LUMA_AC_CODELENS, LUMA_AC_SYMBOLS, sizeof(LUMA_AC_SYMBOLS));
+    appendHuffman(out, 0x01, CHROMA_DC_CODELENS, CHROMA_DC_SYMBOLS, sizeof(CHROMA_DC_SYMBOLS));
+    appendHuffman(out, 0x11, CHROMA_AC_CODELENS, CHROMA_AC_SYMBOLS, sizeof(CHROMA_AC_SYMBOLS));
+
+    // SOS: three components, luma on tables 0, chroma on tables 1
+    appendMarker(out, 0xda, 12);
+    out.append(char(3));
+    out.append(char(1));
+    out.append(char(0x00));
+    out.append(char(2));
+    out.append(char(0x11));
+    out.append(char(3));
+    out.append(char(0x11));
+    out.append(char(0));
+    out.append(char(63));
+    out.append(char(0));
+    return out;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,115 @@
+#ifndef RTPDEPACKETIZER_H
+#define RTPDEPACKETIZER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+#include "video/RtpStream.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief One compressed picture put back together from RTP packets
+ */
+struct RtpAccessUnit {
+    QByteArray data;            // As VideoDecoder::submit() takes it
+    quint32 rtpTimestamp = 0;
+    bool keyframe = false;
+};
+
+/**
+ * @brief Reassembles one payload format from in-sequence RTP packets
+ *
+ * Packets come from the jitter buffer in order. After a loss the owner
+ * calls discard(): the picture being assembled goes, and reassembly picks
+ * up at the next point a decoder can use.
+ */
+class RtpDepacketizer {
+public:
+    virtual ~RtpDepacketizer() = default;
+
+    // The VideoDecoder codec name
+    virtual QString codecName() const = 0;
+
+    // Completed pictures are appended to out
+    virtual void push(const RtpPacket& packet, QVector<RtpAccessUnit>& out) = 0;
+    virtual void discard() = 0;
+
+    quint64 unitsDropped() const { return m_dropped; }
+
+    // For the rtpmap encoding name of an SDP media section and its fmtp
+    // parameters; null for a payload format not handled here
+    static std::unique_ptr<RtpDepacketizer> create(const QString& encoding, const QString& fmtp);
+
+protected:
+    quint64 m_dropped = 0;
+};
+
+/**
+ * @brief H.264 over RTP, RFC 6184 non-interleaved mode, to Annex B
+ *
+ * Single NAL units, STAP-A and FU-A. The parameter sets from the fmtp
+ * sprop-parameter-sets go in front of every IDR picture that does not
+ * carry its own, and nothing is passed on before the first IDR. After a
+ * loss reassembly restarts at the next NAL unit; the decoder conceals the
+ * missing slices.
+ */
+class H264RtpDepacketizer : public RtpDepacketizer {
+public:
+    explicit H264RtpDepacketizer(const QString& fmtp = QString());
+
+    QString codecName() const override { return QStringLiteral("H264"); }
+    void push(const RtpPacket& packet, QVector<RtpAccessUnit>& out) override;
+    void discard() override;
+
+private:
+    void appendNal(const uchar* nal, int size);
+    void noteNalType(int type);
+    void finish(QVector<RtpAccessUnit>& out);
+
+    QByteArray m_parameterSets;     // Annex B SPS and PPS
+    QByteArray m_pending;
+    quint32 m_timestamp = 0;
+    bool m_inFragment = false;
+    bool m_keyframe = false;
+    bool m_hasSps = false;
+    bool m_seenKeyframe = false;
+};
+
+/**
+ * @brief Motion JPEG over RTP, RFC 2435, to whole JFIF images
+ *
+ * Rebuilds the headers the format leaves out: quantisation tables from
+ * the Q factor or the in-band table header, the standard Huffman tables,
+ * and restart intervals for types 64 to 127. Types 0 and 1 (4:2:2, 4:2:0)
+ * with 8-bit tables; every picture is a keyframe.
+ */
+class JpegRtpDepacketizer : public RtpDepacketizer {
+public:
+    QString codecName() const override { return QStringLiteral("MJPEG"); }
+    void push(const RtpPacket& packet, QVector<RtpAccessUnit>& out) override;
+    void discard() override;
+
+    // The two 64-entry tables, zigzag order, for a Q factor of 1 to 99
+    static QByteArray standardTables(int q);
+    static QByteArray makeHeaders(int type, int width, int height, const QByteArray& tables,
+                                  int restartInterval);
+
+private:
+    QByteArray m_scan;
+    QByteArray m_tables;
+    QByteArray m_cachedTables;      // In-band tables of the last Q of 128 to 254
+    int m_cachedQ = -1;
+    int m_type = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_restartInterval = 0;
+    quint32 m_timestamp = 0;
+    bool m_active = false;
+};
+
+} // namespace CounterUAS
+
+#endif // RTPDEPACKETIZER_H
@@ -0,0 +1,251 @@
+#include "video/RtpPacketizer.h"
+#include <QPair>
+#include <QtEndian>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int NAL_FU_A = 28;
+constexpr int JPEG_HEADER_SIZE = 8;
+constexpr int JPEG_RESTART_HEADER_SIZE = 4;
+constexpr int JPEG_TABLE_HEADER_SIZE = 4;
+constexpr int JPEG_MAX_SIDE = 2040;     // Eight pixels a unit in one byte
+
+using Nal = QPair<const char*, int>;
+
+// NAL units of an Annex B stream, start codes of three or four bytes
+QVector<Nal> splitAnnexB(const QByteArray& unit) {
+    QVector<Nal> nals;
+    const char* data = unit.constData();
+    const int n = unit.size();
+    int start = -1;
+    for (int i = 0; i + 2 < n; ++i) {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1) continue;
+        if (start >= 0) {
+            int end = i;
+            while (end > start && data[end - 1] == 0) --end;     // Zero byte of a four-byte code
+            if (end > start) nals.append({data + start, end - start});
+        }
+        start = i + 3;
+        i += 2;
+    }
+    if (start >= 0 && start < n) nals.append({data + start, n - start});
+    return nals;
+}
+
+QVector<Nal> splitLengthPrefixed(const QByteArray& unit, int lengthSize) {
+    QVector<Nal> nals;
+    const uchar* p = reinterpret_cast<const uchar*>(unit.constData());
+    int pos = 0;
+    while (pos + lengthSize <= unit.size()) {
+        int size = 0;
+        for (int i = 0; i < lengthSize; ++i) size = (size << 8) | p[pos + i];
+        pos += lengthSize;
+        if (size <= 0 || pos + size > unit.size()) break;
+        nals.append({unit.constData() + pos, size});
+        pos += size;
+    }
+    return nals;
+}
+
+} // namespace
+
+std::unique_ptr<RtpPacketizer> RtpPacketizer::create(const QString& codecId, const QByteArray& codecPrivate,
+                                                     int maxPayload) {
+    const QString id = codecId.toUpper();
+    if (id == "V_MPEG4/ISO/AVC" || id == "H264") {
+        return std::unique_ptr<RtpPacketizer>(new H264RtpPacketizer(codecPrivate, maxPayload));
+    }
+    if (id == "V_MJPEG" || id == "MJPEG" || id == "JPEG") {
+        return std::unique_ptr<RtpPacketizer>(new JpegRtpPacketizer(maxPayload));
+    }
+    return nullptr;
+}
+
+void RtpPacketizer::writeHeader(uchar* out, int payloadType, bool marker, quint16 sequence,
+                                quint32 timestamp, quint32 ssrc) {
+    out[0] = 0x80;
+    out[1] = static_cast<uchar>((payloadType & 0x7f) | (marker ? 0x80 : 0));
+    qToBigEndian<quint16>(sequence, out + 2);
+    qToBigEndian<quint32>(timestamp, out + 4);
+    qToBigEndian<quint32>(ssrc, out + 8);
+}
+
+H264RtpPacketizer::H264RtpPacketizer(const QByteArray& avcC, int maxPayload)
+    : m_maxPayload(qMax(64, maxPayload))
+{
+    // avcC: version, profile, compatibility, level, length size, then
+    // counted SPS and PPS with 16-bit sizes
+    const uchar* p = reinterpret_cast<const uchar*>(avcC.constData());
+    if (avcC.size() < 7 || p[0] != 1) return;
+    m_lengthSize = (p[4] & 3) + 1;
+    int pos = 5;
+    for (int set = 0; set < 2; ++set) {
+        if (pos >= avcC.size()) break;
+        const int count = set == 0 ? (p[pos] & 0x1f) : p[pos];
+        ++pos;
+        for (int i = 0; i < count && pos + 2 <= avcC.size(); ++i) {
+            const int size = qFromBigEndian<quint16>(p + pos);
+            pos += 2;
+            if (pos + size > avcC.size()) return;
+            if (i == 0) (set == 0 ? m_sps : m_pps) = avcC.mid(pos, size);
+            pos += size;
+        }
+    }
+}
+
+QString H264RtpPacketizer::fmtp() const {
+    QString params = QStringLiteral("packetization-mode=1");
+    if (m_sps.size() >= 4 && !m_pps.isEmpty()) {
+        params += ";profile-level-id=" + QString::fromLatin1(m_sps.mid(1, 3).toHex());
+        params += ";sprop-parameter-sets=" + QString::fromLatin1(m_sps.toBase64()) + ','
+                + QString::fromLatin1(m_pps.toBase64());
+    }
+    return params;
+}
+
+bool H264RtpPacketizer::packetize(const QByteArray& unit, bool keyframe, QVector<QByteArray>& payloads) {
+    Q_UNUSED(keyframe)
+    const QVector<Nal> nals = m_lengthSize > 0 ? splitLengthPrefixed(unit, m_lengthSize) : splitAnnexB(unit);
+    if (nals.isEmpty()) return false;
+
+    bool hasIdr = false, hasSps = false, hasPps = false;
+    for (const Nal& nal : nals) {
+        const int type = nal.first[0] & 0x1f;
+        if (type == 5) hasIdr = true;
+        if (type == 7) {
+            hasSps = true;
+            m_sps = QByteArray(nal.first, nal.second);
+        } else if (type == 8) {
+            hasPps = true;
+            m_pps = QByteArray(nal.first, nal.second);
+        }
+    }
+
+    const int before = payloads.size();
+    if (hasIdr && !(hasSps && hasPps) && !m_sps.isEmpty() && !m_pps.isEmpty()) {
+        addNal(m_sps.constData(), m_sps.size(), payloads);
+        addNal(m_pps.constData(), m_pps.size(), payloads);
+    }
+    for (const Nal& nal : nals) addNal(nal.first, nal.second, payloads);
+    return payloads.size() > before;
+}
+
+void H264RtpPacketizer::addNal(const char* nal, int size, QVector<QByteArray>& payloads) const {
+    if (size <= m_maxPayload) {
+        payloads.append(QByteArray(nal, size));
+        return;
+    }
+
+    // FU-A: the NAL header becomes the indicator and the FU header
+    const char indicator = char((nal[0] & 0xe0) | NAL_FU_A);
+    const int type = nal[0] & 0x1f;
+    const int chunk = m_maxPayload - 2;
+    for (int offset = 1; offset < size; offset += chunk) {
+        const int length = qMin(chunk, size - offset);
+        int fu = type;
+        if (offset == 1) fu |= 0x80;
+        if (offset + length >= size) fu |= 0x40;
+        QByteArray payload;
+        payload.reserve(2 + length);
+        payload.append(indicator);
+        payload.append(char(fu));
+        payload.append(nal + offset, length);
+        payloads.append(std::move(payload));
+    }
+}
+
+bool JpegRtpPacketizer::packetize(const QByteArray& unit, bool keyframe, QVector<QByteArray>& payloads) {
+    Q_UNUSED(keyframe)
+    const uchar* p = reinterpret_cast<const uchar*>(unit.constData());
+    const int n = unit.size();
+    if (n < 4 || p[0] != 0xff || p[1] != 0xd8) return false;
+
+    QByteArray tables[2];
+    int type = -1;
+    int width = 0, height = 0;
+    int restartInterval = 0;
+    int scan = -1;
+    int pos = 2;
+    while (pos + 4 <= n && scan < 0) {
+        if (p[pos] != 0xff) return false;
+        const int marker = p[pos + 1];
+        if (marker == 0xff) {
+            ++pos;                          // Fill byte
+            continue;
+        }
+        const int length = qFromBigEndian<quint16>(p + pos + 2);
+        const uchar* segment = p + pos + 4;
+        const int segmentSize = length - 2;
+        if (length < 2 || pos + 2 + length > n) return false;
+
+        if (marker == 0xdb) {
+            // 8-bit tables only, luma as 0 and chroma as 1
+            for (int i = 0; i + 65 <= segmentSize; i += 65) {
+                const int precision = segment[i] >> 4;
+                const int id = segment[i] & 0x0f;
+                if (precision != 0 || id > 1) return false;
+                tables[id] = QByteArray(reinterpret_cast<const char*>(segment + i + 1), 64);
+            }
+        } else if (marker == 0xc0) {
+            if (segmentSize < 15 || segment[0] != 8 || segment[5] != 3) return false;
+            height = qFromBigEndian<quint16>(segment + 1);
+            width = qFromBigEndian<quint16>(segment + 3);
+            const int lumaSampling = segment[7];
+            if (segment[10] != 0x11 || segment[13] != 0x11) return false;
+            if (segment[8] != 0 || segment[11] != 1 || segment[14] != 1) return false;
+            if (lumaSampling == 0x21) type = 0;
+            else if (lumaSampling == 0x22) type = 1;
+            else return false;
+        } else if (marker >= 0xc1 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc) {
+            return false;                   // Progressive, lossless or arithmetic
+        } else if (marker == 0xdd) {
+            if (segmentSize < 2) return false;
+            restartInterval = qFromBigEndian<quint16>(segment);
+        } else if (marker == 0xda) {
+            scan = pos + 2 + length;
+        }
+        pos += 2 + length;
+    }
+    if (scan < 0 || type < 0 || tables[0].isEmpty() || tables[1].isEmpty()) return false;
+    if (width <= 0 || height <= 0 || width > JPEG_MAX_SIDE || height > JPEG_MAX_SIDE) return false;
+
+    int scanEnd = n;
+    if (scanEnd - scan >= 2 && p[scanEnd - 2] == 0xff && p[scanEnd - 1] == 0xd9) scanEnd -= 2;
+
+    QByteArray header(JPEG_HEADER_SIZE, '\0');
+    header[4] = char(restartInterval > 0 ? type + 64 : type);
+    header[5] = char(255);                  // Tables in band
+    header[6] = char((width + 7) / 8);
+    header[7] = char((height + 7) / 8);
+    if (restartInterval > 0) {
+        QByteArray restart(JPEG_RESTART_HEADER_SIZE, '\0');
+        qToBigEndian<quint16>(quint16(restartInterval), reinterpret_cast<uchar*>(restart.data()));
+        restart[2] = char(0xff);            // First and last, count 0x3fff: whole scans only
+        restart[3] = char(0xff);
+        header += restart;
+    }
+    QByteArray tableHeader(JPEG_TABLE_HEADER_SIZE, '\0');
+    qToBigEndian<quint16>(128, reinterpret_cast<uchar*>(tableHeader.data()) + 2);
+    tableHeader += tables[0];
+    tableHeader += tables[1];
+
+    int offset = 0;
+    const int total = scanEnd - scan;
+    do {
+        QByteArray payload = header;
+        qToBigEndian<quint32>(quint32(offset), reinterpret_cast<uchar*>(payload.data()));
+        payload[0] = 0;                     // Type-specific; fragment offset is 24 bits
+        if (offset == 0) payload += tableHeader;
+        const int room = m_maxPayload - payload.size();
+        if (room <= 0) return false;
+        const int length = qMin(room, total - offset);
+        payload.append(reinterpret_cast<const char*>(p + scan + offset), length);
+        payloads.append(std::move(payload));
+        offset += length;
+    } while (offset < total);
+    return true;
+}
+
+} // namespace CounterUAS
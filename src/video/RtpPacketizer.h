@@ -0,0 +1,92 @@
+#ifndef RTPPACKETIZER_H
+#define RTPPACKETIZER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+namespace CounterUAS {
+
+/**
+ * @brief Splits one encoder's access units into RTP payloads
+ *
+ * The sending half of RtpDepacketizer. A picture is packetised once and
+ * the payloads shared by every receiver of it; each receiver puts its own
+ * RTP header in front with writeHeader(). The marker bit goes on the last
+ * payload of a picture.
+ */
+class RtpPacketizer {
+public:
+    static constexpr int RTP_HEADER_SIZE = 12;
+
+    virtual ~RtpPacketizer() = default;
+
+    // For the SDP media section
+    virtual int payloadType() const = 0;
+    virtual QString encodingName() const = 0;
+    virtual QString fmtp() const { return QString(); }
+
+    // Payloads of at most maxPayload bytes are appended; false if the
+    // unit is not something this format carries
+    virtual bool packetize(const QByteArray& unit, bool keyframe, QVector<QByteArray>& payloads) = 0;
+
+    // For an encoder's codec id (as VideoEncoderBackend::codecId()) and
+    // its codec private data; null for a codec not handled here
+    static std::unique_ptr<RtpPacketizer> create(const QString& codecId, const QByteArray& codecPrivate,
+                                                 int maxPayload = 1400);
+
+    static void writeHeader(uchar* out, int payloadType, bool marker, quint16 sequence,
+                            quint32 timestamp, quint32 ssrc);
+};
+
+/**
+ * @brief H.264 to RTP, RFC 6184 non-interleaved mode
+ *
+ * Takes Annex B units, or length-prefixed ones when given an avcC record.
+ * NAL units that fit go as they are and the rest as FU-A fragments. Every
+ * IDR picture is preceded by the parameter sets, from the unit itself or
+ * the last ones seen, so a receiver can start at any keyframe and a
+ * change of resolution needs no new SDP.
+ */
+class H264RtpPacketizer : public RtpPacketizer {
+public:
+    explicit H264RtpPacketizer(const QByteArray& avcC = QByteArray(), int maxPayload = 1400);
+
+    int payloadType() const override { return 96; }
+    QString encodingName() const override { return QStringLiteral("H264"); }
+    QString fmtp() const override;
+    bool packetize(const QByteArray& unit, bool keyframe, QVector<QByteArray>& payloads) override;
+
+private:
+    void addNal(const char* nal, int size, QVector<QByteArray>& payloads) const;
+
+    int m_maxPayload;
+    int m_lengthSize = 0;          // 0 for Annex B
+    QByteArray m_sps;
+    QByteArray m_pps;
+};
+
+/**
+ * @brief Baseline JFIF to RTP, RFC 2435
+ *
+ * The headers are stripped and their quantisation tables sent in band
+ * (Q 255) on the first packet of each picture. Takes the 4:2:2 and 4:2:0
+ * images an encoder with the standard Huffman tables writes, restart
+ * intervals included, up to 2040 pixels a side.
+ */
+class JpegRtpPacketizer : public RtpPacketizer {
+public:
+    explicit JpegRtpPacketizer(int maxPayload = 1400) : m_maxPayload(maxPayload) {}
+
+    int payloadType() const override { return 26; }
+    QString encodingName() const override { return QStringLiteral("JPEG"); }
+    bool packetize(const QByteArray& unit, bool keyframe, QVector<QByteArray>& payloads) override;
+
+private:
+    int m_maxPayload;
+};
+
+} // namespace CounterUAS
+
+#endif // RTPPACKETIZER_H
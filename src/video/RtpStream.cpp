@@ -0,0 +1,188 @@
+#include "video/RtpStream.h"
+#include <QtEndian>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr qint64 MAX_DROPOUT = 3000;     // RFC 3550 A.1: a jump further ahead is suspect
+constexpr qint64 MAX_MISORDER = 100;     // and so is one further behind
+constexpr quint64 NTP_UNIX_OFFSET = 2208988800ULL;
+
+quint16 be16(const uchar* p) { return qFromBigEndian<quint16>(p); }
+quint32 be32(const uchar* p) { return qFromBigEndian<quint32>(p); }
+
+} // namespace
+
+bool RtpPacket::parse(const QByteArray& datagram, RtpPacket& packet) {
+    const int length = datagram.size();
+    if (length < 12) return false;
+    const uchar* data = reinterpret_cast<const uchar*>(datagram.constData());
+    if ((data[0] >> 6) != 2) return false;
+
+    int offset = 12 + (data[0] & 0x0f) * 4;
+    if (data[0] & 0x10) {
+        if (offset + 4 > length) return false;
+        offset += 4 + be16(data + offset + 2) * 4;
+    }
+    int end = length;
+    if (data[0] & 0x20) {
+        end -= data[length - 1];
+    }
+    if (offset >= end) return false;
+
+    packet.datagram = datagram;
+    packet.payloadOffset = offset;
+    packet.payloadSize = end - offset;
+    packet.marker = (data[1] & 0x80) != 0;
+    packet.payloadType = data[1] & 0x7f;
+    packet.sequence = be16(data + 2);
+    packet.timestamp = be32(data + 4);
+    packet.ssrc = be32(data + 8);
+    return true;
+}
+
+RtpJitterBuffer::RtpJitterBuffer(int delayMs, int capacity)
+    : m_delayMs(qMax(0, delayMs))
+    , m_capacity(qMax(1, capacity))
+{
+}
+
+qint64 RtpJitterBuffer::extend(quint16 sequence) const {
+    if (!m_started) return sequence;
+    // The extension nearest the highest sequence number seen
+    qint64 candidate = (m_highest & ~qint64(0xffff)) | sequence;
+    if (candidate - m_highest > 0x8000) candidate -= 0x10000;
+    else if (m_highest - candidate > 0x8000) candidate += 0x10000;
+    return candidate;
+}
+
+void RtpJitterBuffer::push(const RtpPacket& packet, qint64 arrivalMs) {
+    ++m_stats.received;
+    qint64 ext = extend(packet.sequence);
+
+    if (!m_started) {
+        m_started = true;
+        m_highest = ext;
+        m_next = ext;
+    } else if (ext > m_highest + MAX_DROPOUT || ext < m_next - MAX_MISORDER) {
+        // A sender restart or a new SSRC: followed once a second packet agrees
+        if (m_probing && packet.sequence == m_probe) {
+            m_held.clear();
+            m_highest = m_next = ext = packet.sequence;
+            m_probing = false;
+        } else {
+            m_probe = static_cast<quint16>(packet.sequence + 1);
+            m_probing = true;
+            ++m_stats.late;
+            return;
+        }
+    }
+    m_probing = false;
+
+    if (ext < m_next) {
+        ++m_stats.late;
+        return;
+    }
+    if (m_held.contains(ext)) {
+        ++m_stats.duplicates;
+        return;
+    }
+    if (ext < m_highest) ++m_stats.reordered;
+    else m_highest = ext;
+
+    Held held;
+    held.packet = packet;
+    held.arrivalMs = arrivalMs;
+    m_held.insert(ext, held);
+}
+
+bool RtpJitterBuffer::pop(RtpPacket& packet, qint64 nowMs, int* lostBefore) {
+    if (lostBefore) *lostBefore = 0;
+    if (m_held.isEmpty()) return false;
+
+    auto head = m_held.begin();
+    if (head.key() != m_next && m_held.size() <= m_capacity) {
+        const qint64 deadline = nextDeadlineMs();
+        if (nowMs < deadline) return false;
+    }
+
+    const qint64 gap = head.key() - m_next;
+    m_stats.lost += static_cast<quint64>(gap);
+    if (lostBefore) *lostBefore = static_cast<int>(gap);
+
+    packet = head->packet;
+    m_next = head.key() + 1;
+    m_held.erase(head);
+    ++m_stats.released;
+    return true;
+}
+
+qint64 RtpJitterBuffer::nextDeadlineMs() const {
+    if (m_held.isEmpty()) return -1;
+    if (m_held.firstKey() == m_next) return 0;
+
+    // Nothing is held longer than the delay
+    qint64 oldest = m_held.first().arrivalMs;
+    for (const Held& held : m_held) oldest = qMin(oldest, held.arrivalMs);
+    return oldest + m_delayMs;
+}
+
+void RtpJitterBuffer::reset() {
+    m_held.clear();
+    m_started = false;
+    m_highest = 0;
+    m_next = 0;
+    m_probing = false;
+    m_stats = Stats();
+}
+
+bool RtcpSenderClock::onRtcp(const QByteArray& datagram) {
+    const uchar* data = reinterpret_cast<const uchar*>(datagram.constData());
+    int offset = 0;
+    while (offset + 4 <= datagram.size()) {
+        if ((data[offset] >> 6) != 2) return false;
+        const int bytes = (be16(data + offset + 2) + 1) * 4;
+        if (offset + bytes > datagram.size()) return false;
+        if (data[offset + 1] == 200 && bytes >= 28) {
+            m_ssrc = be32(data + offset + 4);
+            const quint64 ntp = (quint64(be32(data + offset + 8)) << 32) | be32(data + offset + 12);
+            onSenderReport(ntp, be32(data + offset + 16));
+            return true;
+        }
+        offset += bytes;
+    }
+    return false;
+}
+
+void RtcpSenderClock::onSenderReport(quint64 ntpTime, quint32 rtpTimestamp) {
+    m_reportUnixMs = ntpToUnixMs(ntpTime);
+    m_reportRtp = rtpTimestamp;
+    m_valid = true;
+}
+
+qint64 RtcpSenderClock::wallClockMs(quint32 rtpTimestamp) const {
+    if (!m_valid) return -1;
+    // Signed, so timestamps just before the report work too
+    const qint64 ticks = static_cast<qint32>(rtpTimestamp - m_reportRtp);
+    return m_reportUnixMs + ticks * 1000 / m_clockRate;
+}
+
+qint64 RtcpSenderClock::ntpToUnixMs(quint64 ntpTime) {
+    const qint64 seconds = static_cast<qint64>(ntpTime >> 32) - static_cast<qint64>(NTP_UNIX_OFFSET);
+    const qint64 fractionMs = static_cast<qint64>(((ntpTime & 0xffffffffULL) * 1000) >> 32);
+    return seconds * 1000 + fractionMs;
+}
+
+void RtpJitterEstimator::record(quint32 rtpTimestamp, qint64 arrivalUs) {
+    const quint32 arrival = static_cast<quint32>(arrivalUs * m_clockRate / 1000000);
+    const qint64 transit = static_cast<qint32>(arrival - rtpTimestamp);
+    if (m_started) {
+        const qint64 d = qAbs(static_cast<qint32>(transit - m_lastTransit));
+        m_jitter += (static_cast<double>(d) - m_jitter) / 16.0;
+    }
+    m_started = true;
+    m_lastTransit = transit;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,144 @@
+#ifndef RTPSTREAM_H
+#define RTPSTREAM_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QtGlobal>
+
+namespace CounterUAS {
+
+/**
+ * @brief One RTP packet (RFC 3550), sharing the datagram it came in
+ */
+struct RtpPacket {
+    QByteArray datagram;
+    int payloadOffset = 0;
+    int payloadSize = 0;
+    quint8 payloadType = 0;
+    bool marker = false;
+    quint16 sequence = 0;
+    quint32 timestamp = 0;
+    quint32 ssrc = 0;
+
+    const uchar* payload() const {
+        return reinterpret_cast<const uchar*>(datagram.constData()) + payloadOffset;
+    }
+
+    // False for anything that is not a well-formed version 2 packet
+    static bool parse(const QByteArray& datagram, RtpPacket& packet);
+};
+
+/**
+ * @brief Puts RTP packets back in sequence order, waiting a bounded time
+ *
+ * A packet is released as soon as it is the next one expected. No packet
+ * is held longer than the configured delay waiting for a gap ahead of it
+ * to fill, so the delay is the most reordering can add to latency; at 0 a
+ * gap is given up at once. Packets behind what was already released are
+ * late and dropped.
+ *
+ * Sequence numbers are extended across the 16-bit wrap. Times are any
+ * monotonic clock in milliseconds.
+ */
+class RtpJitterBuffer {
+public:
+    struct Stats {
+        quint64 received = 0;
+        quint64 released = 0;
+        quint64 lost = 0;           // Sequence numbers given up on
+        quint64 late = 0;
+        quint64 duplicates = 0;
+        quint64 reordered = 0;      // Arrived behind a later one, still in time
+    };
+
+    explicit RtpJitterBuffer(int delayMs = 40, int capacity = 512);
+
+    void setDelay(int ms) { m_delayMs = qMax(0, ms); }
+    int delay() const { return m_delayMs; }
+
+    void push(const RtpPacket& packet, qint64 arrivalMs);
+
+    // The next packet if it may go now; lostBefore is the gap skipped to it
+    bool pop(RtpPacket& packet, qint64 nowMs, int* lostBefore = nullptr);
+
+    // When pop() next has something to give up waiting for; -1 if nothing held
+    qint64 nextDeadlineMs() const;
+
+    int size() const { return m_held.size(); }
+    Stats stats() const { return m_stats; }
+    void reset();
+
+private:
+    struct Held {
+        RtpPacket packet;
+        qint64 arrivalMs = 0;
+    };
+
+    qint64 extend(quint16 sequence) const;
+
+    int m_delayMs;
+    int m_capacity;
+    bool m_started = false;
+    qint64 m_highest = 0;           // Extended sequence numbers
+    qint64 m_next = 0;
+    bool m_probing = false;
+    quint16 m_probe = 0;
+    QMap<qint64, Held> m_held;
+    Stats m_stats;
+};
+
+/**
+ * @brief Sender wall clock for RTP timestamps, from RTCP sender reports
+ *
+ * Each sender report pairs an NTP time with the RTP timestamp of the same
+ * instant; later timestamps are placed on the sender's clock from there.
+ * That is capture time when the camera stamps at the sensor and keeps NTP
+ * or PTP time, which is what latency is measured against.
+ */
+class RtcpSenderClock {
+public:
+    explicit RtcpSenderClock(int clockRate = 90000) : m_clockRate(qMax(1, clockRate)) {}
+
+    void setClockRate(int hz) { m_clockRate = qMax(1, hz); }
+
+    // Takes the first sender report of a compound RTCP packet; false if none
+    bool onRtcp(const QByteArray& datagram);
+    void onSenderReport(quint64 ntpTime, quint32 rtpTimestamp);
+
+    bool isValid() const { return m_valid; }
+    quint32 senderSsrc() const { return m_ssrc; }
+
+    // Unix milliseconds on the sender's clock; -1 before the first report
+    qint64 wallClockMs(quint32 rtpTimestamp) const;
+
+    static qint64 ntpToUnixMs(quint64 ntpTime);
+
+private:
+    int m_clockRate;
+    bool m_valid = false;
+    quint32 m_ssrc = 0;
+    qint64 m_reportUnixMs = 0;
+    quint32 m_reportRtp = 0;
+};
+
+/**
+ * @brief RFC 3550 interarrival jitter of one RTP stream
+ */
+class RtpJitterEstimator {
+public:
+    explicit RtpJitterEstimator(int clockRate = 90000) : m_clockRate(qMax(1, clockRate)) {}
+
+    void setClockRate(int hz) { m_clockRate = qMax(1, hz); }
+    void record(quint32 rtpTimestamp, qint64 arrivalUs);
+    double jitterMs() const { return m_jitter * 1000.0 / m_clockRate; }
+
+private:
+    int m_clockRate;
+    bool m_started = false;
+    qint64 m_lastTransit = 0;
+    double m_jitter = 0.0;          // In RTP timestamp units
+};
+
+} // namespace CounterUAS
+
+#endif // RTPSTREAM_H
@@ -0,0 +1,553 @@
+#include "video/RtspClient.h"
+#include "utils/Logger.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QMutexLocker>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtEndian>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int MAX_HEADER_BYTES = 64 * 1024;
+constexpr quint16 UDP_PORT_BASE = 50000;
+constexpr int UDP_PORT_ATTEMPTS = 64;
+constexpr int WATCHDOG_INTERVAL_MS = 500;
+
+QByteArray md5Hex(const QByteArray& data) {
+    return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+}
+
+// key="value" or key=value out of a list split on separator, quotes respected
+QByteArray parameter(const QByteArray& text, const QByteArray& key, char separator) {
+    int i = 0;
+    while (i < text.size()) {
+        const int start = i;
+        bool quoted = false;
+        for (; i < text.size() && (quoted || text.at(i) != separator); ++i) {
+            if (text.at(i) == '"') quoted = !quoted;
+        }
+        QByteArray part = text.mid(start, i - start).trimmed();
+        ++i;
+        const int eq = part.indexOf('=');
+        if (eq <= 0) continue;
+        QByteArray name = part.left(eq).trimmed().toLower();
+        const int space = name.lastIndexOf(' ');    // "Digest realm"
+        if (space >= 0) name = name.mid(space + 1);
+        if (name != key) continue;
+        QByteArray value = part.mid(eq + 1).trimmed();
+        if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"')) {
+            value = value.mid(1, value.size() - 2);
+        }
+        return value;
+    }
+    return QByteArray();
+}
+
+} // namespace
+
+RtspClient::RtspClient(QObject* parent)
+    : QObject(parent)
+    , m_socket(new QTcpSocket(this))
+    , m_keepAlive(new QTimer(this))
+    , m_watchdog(new QTimer(this))
+    , m_responseTimer(new QTimer(this))
+    , m_jitterTimer(new QTimer(this))
+{
+    connect(m_socket, &QTcpSocket::connected, this, &RtspClient::onConnected);
+    connect(m_socket, &QTcpSocket::readyRead, this, &RtspClient::onReadyRead);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    connect(m_socket, &QAbstractSocket::errorOccurred, this, &RtspClient::onSocketError);
+#else
+    connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error),
+            this, &RtspClient::onSocketError);
+#endif
+
+    connect(m_keepAlive, &QTimer::timeout, this, &RtspClient::onKeepAlive);
+    m_watchdog->setInterval(WATCHDOG_INTERVAL_MS);
+    connect(m_watchdog, &QTimer::timeout, this, &RtspClient::onWatchdog);
+    m_responseTimer->setSingleShot(true);
+    connect(m_responseTimer, &QTimer::timeout, this, &RtspClient::onResponseTimeout);
+    // Gaps are given up on to the millisecond; a coarse timer would add latency
+    m_jitterTimer->setSingleShot(true);
+    m_jitterTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_jitterTimer, &QTimer::timeout, this, &RtspClient::drain);
+}
+
+RtspClient::~RtspClient() = default;
+
+RtpReceiverStats RtspClient::stats() const {
+    QMutexLocker locker(&m_statsMutex);
+    return m_stats;
+}
+
+void RtspClient::open(const QUrl& url) {
+    stopAll();
+
+    m_url = url;
+    if (m_options.username.isEmpty() && !url.userName().isEmpty()) {
+        m_options.username = url.userName();
+        m_options.password = url.password();
+    }
+    m_url.setUserInfo(QString());
+    m_requestUri = m_url.toString();
+
+    m_jitter.setDelay(m_options.jitterBufferMs);
+    m_clock.start();
+    {
+        QMutexLocker locker(&m_statsMutex);
+        m_stats = RtpReceiverStats();
+        m_stats.transport = m_options.useTcp ? "TCP" : "UDP";
+    }
+
+    m_state = State::Connecting;
+    m_socket->connectToHost(m_url.host(), static_cast<quint16>(m_url.port(554)));
+    m_responseTimer->start(m_options.timeoutMs);
+}
+
+void RtspClient::play() {
+    if (m_state != State::Ready) return;
+    m_state = State::Starting;
+    Headers headers;
+    headers.append({"Range", "npt=0.000-"});
+    sendRequest("PLAY", m_requestUri, headers);
+}
+
+void RtspClient::pause() {
+    if (m_state != State::Playing && m_state != State::Starting) return;
+    m_state = State::Pausing;
+    sendRequest("PAUSE", m_requestUri);
+}
+
+void RtspClient::shutdown() {
+    if (!m_sessionId.isEmpty() && m_socket->state() == QAbstractSocket::ConnectedState) {
+        sendRequest("TEARDOWN", m_requestUri);
+        m_socket->flush();
+    }
+    stopAll();
+}
+
+void RtspClient::stopAll() {
+    m_keepAlive->stop();
+    m_watchdog->stop();
+    m_responseTimer->stop();
+    m_jitterTimer->stop();
+    m_socket->abort();
+    delete m_rtpSocket;
+    delete m_rtcpSocket;
+    m_rtpSocket = nullptr;
+    m_rtcpSocket = nullptr;
+
+    m_state = State::Idle;
+    m_readBuffer.clear();
+    m_sessionId.clear();
+    m_authRetried = false;
+    m_nonce.clear();
+    m_payloadType = -1;
+    m_depacketizer.reset();
+    m_jitter.reset();
+    m_senderClock = RtcpSenderClock();
+    m_jitterEstimate = RtpJitterEstimator();
+    m_units.clear();
+}
+
+void RtspClient::fail(const QString& reason) {
+    Logger::instance().warning("RtspClient", m_requestUri + ": " + reason);
+    stopAll();
+    emit failed(reason);
+}
+
+void RtspClient::onConnected() {
+    m_state = State::Describing;
+    Headers headers;
+    headers.append({"Accept", "application/sdp"});
+    sendRequest("DESCRIBE", m_requestUri, headers);
+}
+
+void RtspClient::onSocketError() {
+    if (m_state == State::Idle) return;
+    fail("RTSP connection: " + m_socket->errorString());
+}
+
+void RtspClient::onResponseTimeout() {
+    fail(QString("No RTSP response within %1 ms").arg(m_options.timeoutMs));
+}
+
+void RtspClient::onKeepAlive() {
+    // OPTIONS is the one method every server answers within a session
+    sendRequest("OPTIONS", m_requestUri);
+}
+
+void RtspClient::onWatchdog() {
+    if (m_state != State::Playing) return;
+    if (m_clock.elapsed() - m_lastPacketMs > m_options.timeoutMs) {
+        fail(QString("No RTP for %1 ms").arg(m_options.timeoutMs));
+    }
+}
+
+void RtspClient::sendRequest(const QByteArray& method, const QString& uri, const Headers& extra) {
+    m_lastMethod = method;
+    m_lastUri = uri;
+    m_lastHeaders = extra;
+
+    QByteArray request = method + ' ' + uri.toUtf8() + " RTSP/1.0\r\n";
+    request += "CSeq: " + QByteArray::number(++m_cseq) + "\r\n";
+    request += "User-Agent: " + m_options.userAgent.toUtf8() + "\r\n";
+    if (!m_sessionId.isEmpty()) request += "Session: " + m_sessionId + "\r\n";
+    const QByteArray auth = authorization(method, uri);
+    if (!auth.isEmpty()) request += "Authorization: " + auth + "\r\n";
+    for (const auto& h : extra) request += h.first + ": " + h.second + "\r\n";
+    request += "\r\n";
+
+    m_socket->write(request);
+    if (method != "TEARDOWN") m_responseTimer->start(m_options.timeoutMs);
+}
+
+void RtspClient::onReadyRead() {
+    m_readBuffer.append(m_socket->readAll());
+
+    // Consumed bytes are dropped once per read, not once per packet
+    int pos = 0;
+    while (pos < m_readBuffer.size()) {
+        if (m_readBuffer.at(pos) == '$') {
+            // Interleaved: '$', channel, 16-bit length, packet
+            if (m_readBuffer.size() - pos < 4) break;
+            const int channel = static_cast<uchar>(m_readBuffer.at(pos + 1));
+            const int length = qFromBigEndian<quint16>(m_readBuffer.constData() + pos + 2);
+            if (m_readBuffer.size() - pos < 4 + length) break;
+            const QByteArray packet = m_readBuffer.mid(pos + 4, length);
+            pos += 4 + length;
+            if (channel == m_rtpChannel) onRtp(packet);
+            else if (channel == m_rtpChannel + 1) onRtcp(packet);
+            continue;
+        }
+
+        const int end = m_readBuffer.indexOf("\r\n\r\n", pos);
+        if (end < 0) {
+            if (m_readBuffer.size() - pos > MAX_HEADER_BYTES) {
+                fail("Malformed RTSP response");
+                return;
+            }
+            break;
+        }
+        const QList<QByteArray> lines = m_readBuffer.mid(pos, end - pos).split('\n');
+        Headers headers;
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon <= 0) continue;
+            headers.append({lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed()});
+        }
+        const int contentLength = header(headers, "content-length").toInt();
+        if (m_readBuffer.size() < end + 4 + contentLength) break;
+        const QByteArray body = m_readBuffer.mid(end + 4, contentLength);
+        const QByteArray statusLine = lines.first().trimmed();
+        pos = end + 4 + contentLength;
+
+        // Requests from the server (ANNOUNCE, GET_PARAMETER) go unanswered
+        if (!statusLine.startsWith("RTSP/")) continue;
+        const QList<QByteArray> parts = statusLine.split(' ');
+        handleResponse(parts.value(1).toInt(), headers, body);
+        if (m_state == State::Idle) return;     // Failed or stopped; the buffer is gone
+    }
+    m_readBuffer.remove(0, pos);
+}
+
+void RtspClient::handleResponse(int status, const Headers& headers, const QByteArray& body) {
+    m_responseTimer->stop();
+
+    if (status == 401 && !m_authRetried && !m_options.username.isEmpty() && takeChallenge(headers)) {
+        m_authRetried = true;
+        sendRequest(m_lastMethod, m_lastUri, m_lastHeaders);
+        return;
+    }
+    if (m_lastMethod == "OPTIONS" || m_lastMethod == "TEARDOWN") return;
+    if (status != 200) {
+        fail(QString("%1 answered %2").arg(QString::fromLatin1(m_lastMethod)).arg(status));
+        return;
+    }
+    m_authRetried = false;
+
+    switch (m_state) {
+    case State::Describing:
+        handleDescribe(headers, body);
+        break;
+    case State::SettingUp:
+        handleSetup(headers);
+        break;
+    case State::Starting:
+        m_state = State::Playing;
+        m_lastPacketMs = m_clock.elapsed();
+        m_watchdog->start();
+        emit playing();
+        break;
+    case State::Pausing:
+        m_state = State::Ready;
+        m_watchdog->stop();
+        break;
+    default:
+        break;
+    }
+}
+
+void RtspClient::handleDescribe(const Headers& headers, const QByteArray& body) {
+    QString base = QString::fromUtf8(header(headers, "content-base"));
+    if (base.isEmpty()) base = QString::fromUtf8(header(headers, "content-location"));
+    if (base.isEmpty()) base = m_requestUri;
+    if (!parseSdp(body, base)) {
+        const QString reason = m_codec.isEmpty() ? QString("No video stream in the SDP")
+                                                 : "Unsupported RTP payload " + m_codec;
+        stopAll();
+        emit unsupported(reason);
+        return;
+    }
+    if (m_codecCheck && !m_codecCheck(m_depacketizer->codecName())) {
+        const QString reason = "No decoder for " + m_depacketizer->codecName();
+        stopAll();
+        emit unsupported(reason);
+        return;
+    }
+
+    Headers transport;
+    if (m_options.useTcp) {
+        m_rtpChannel = 0;
+        transport.append({"Transport", "RTP/AVP/TCP;unicast;interleaved=0-1"});
+    } else {
+        if (!bindUdpPorts()) {
+            fail("No free UDP port pair for RTP");
+            return;
+        }
+        transport.append({"Transport", QString("RTP/AVP;unicast;client_port=%1-%2")
+                                           .arg(m_rtpSocket->localPort())
+                                           .arg(m_rtcpSocket->localPort()).toLatin1()});
+    }
+    m_state = State::SettingUp;
+    sendRequest("SETUP", m_controlUri, transport);
+}
+
+void RtspClient::handleSetup(const Headers& headers) {
+    const QByteArray session = header(headers, "session");
+    const int semicolon = session.indexOf(';');
+    m_sessionId = semicolon < 0 ? session : session.left(semicolon).trimmed();
+    const int timeout = parameter(session.mid(semicolon + 1), "timeout", ';').toInt();
+    if (timeout > 0) m_sessionTimeoutS = timeout;
+
+    const QByteArray transport = header(headers, "transport");
+    const QByteArray interleaved = parameter(transport, "interleaved", ';');
+    if (m_options.useTcp && !interleaved.isEmpty()) {
+        m_rtpChannel = interleaved.split('-').first().toInt();
+    }
+
+    m_keepAlive->start(qMax(5, m_sessionTimeoutS / 2) * 1000);
+    m_state = State::Ready;
+    {
+        QMutexLocker locker(&m_statsMutex);
+        m_stats.codec = m_codec;
+    }
+    Logger::instance().info("RtspClient",
+                            QString("%1: %2 over %3, %4 ms jitter buffer")
+                                .arg(m_requestUri, m_codec,
+                                     m_options.useTcp ? QStringLiteral("TCP") : QStringLiteral("UDP"))
+                                .arg(m_options.jitterBufferMs));
+    emit ready(m_depacketizer->codecName());
+}
+
+bool RtspClient::parseSdp(const QByteArray& sdp, const QString& base) {
+    bool inVideo = false;
+    bool found = false;
+    QString encoding;
+    QString fmtp;
+    QString control;
+    m_codec.clear();
+
+    for (QByteArray line : sdp.split('\n')) {
+        line = line.trimmed();
+        if (line.startsWith("m=")) {
+            if (found && inVideo) break;    // The first video stream only
+            inVideo = line.startsWith("m=video ");
+            if (inVideo) {
+                const QList<QByteArray> fields = line.split(' ');
+                m_payloadType = fields.value(3).toInt();
+                found = true;
+            }
+            continue;
+        }
+        if (!inVideo) continue;
+        const QByteArray prefix = "a=rtpmap:" + QByteArray::number(m_payloadType) + ' ';
+        if (line.startsWith(prefix)) {
+            const QList<QByteArray> map = line.mid(prefix.size()).split('/');
+            encoding = QString::fromLatin1(map.value(0));
+            m_clockRate = map.value(1).toInt() > 0 ? map.value(1).toInt() : 90000;
+        } else if (line.startsWith("a=fmtp:" + QByteArray::number(m_payloadType) + ' ')) {
+            fmtp = QString::fromLatin1(line.mid(line.indexOf(' ') + 1));
+        } else if (line.startsWith("a=control:")) {
+            control = QString::fromUtf8(line.mid(10));
+        }
+    }
+    if (!found) return false;
+    // Static payload type 26 needs no rtpmap
+    if (encoding.isEmpty() && m_payloadType == 26) encoding = "JPEG";
+    m_codec = encoding;
+
+    m_depacketizer = RtpDepacketizer::create(encoding, fmtp);
+    if (!m_depacketizer) return false;
+    m_jitterEstimate.setClockRate(m_clockRate);
+    m_senderClock.setClockRate(m_clockRate);
+
+    if (control.isEmpty() || control == "*") {
+        m_controlUri = base;
+    } else if (control.startsWith("rtsp://", Qt::CaseInsensitive)) {
+        m_controlUri = control;
+    } else {
+        m_controlUri = base.endsWith('/') ? base + control : base + '/' + control;
+    }
+    return true;
+}
+
+bool RtspClient::bindUdpPorts() {
+    // RTP on an even port, RTCP on the next one up
+    const quint16 start = static_cast<quint16>(
+        UDP_PORT_BASE + 2 * QRandomGenerator::global()->bounded(1000));
+    for (int attempt = 0; attempt < UDP_PORT_ATTEMPTS; ++attempt) {
+        const quint16 port = static_cast<quint16>(start + 2 * attempt);
+        std::unique_ptr<QUdpSocket> rtp(new QUdpSocket(this));
+        std::unique_ptr<QUdpSocket> rtcp(new QUdpSocket(this));
+        if (!rtp->bind(QHostAddress::AnyIPv4, port) || !rtcp->bind(QHostAddress::AnyIPv4, port + 1)) {
+            continue;
+        }
+        // Room for a burst of a keyframe's packets between reads
+        rtp->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 4 * 1024 * 1024);
+        m_rtpSocket = rtp.release();
+        m_rtcpSocket = rtcp.release();
+        connect(m_rtpSocket, &QUdpSocket::readyRead, this, &RtspClient::onRtpReadyRead);
+        connect(m_rtcpSocket, &QUdpSocket::readyRead, this, &RtspClient::onRtcpReadyRead);
+        return true;
+    }
+    return false;
+}
+
+void RtspClient::onRtpReadyRead() {
+    while (m_rtpSocket && m_rtpSocket->hasPendingDatagrams()) {
+        onRtp(m_rtpSocket->receiveDatagram().data());
+    }
+}
+
+void RtspClient::onRtcpReadyRead() {
+    while (m_rtcpSocket && m_rtcpSocket->hasPendingDatagrams()) {
+        onRtcp(m_rtcpSocket->receiveDatagram().data());
+    }
+}
+
+void RtspClient::onRtp(const QByteArray& datagram) {
+    RtpPacket packet;
+    if (!RtpPacket::parse(datagram, packet) || packet.payloadType != m_payloadType) return;
+
+    const qint64 nowNs = m_clock.nsecsElapsed();
+    m_lastPacketMs = nowNs / 1000000;
+    m_jitterEstimate.record(packet.timestamp, nowNs / 1000);
+    m_jitter.push(packet, m_lastPacketMs);
+    drain();
+}
+
+void RtspClient::onRtcp(const QByteArray& datagram) {
+    if (m_senderClock.onRtcp(datagram)) {
+        QMutexLocker locker(&m_statsMutex);
+        m_stats.senderClock = true;
+    }
+}
+
+void RtspClient::drain() {
+    if (!m_depacketizer) return;
+
+    const qint64 now = m_clock.elapsed();
+    RtpPacket packet;
+    int lost = 0;
+    quint64 delivered = 0;
+    while (m_jitter.pop(packet, now, &lost)) {
+        if (lost > 0) m_depacketizer->discard();
+        m_units.clear();
+        m_depacketizer->push(packet, m_units);
+        for (const RtpAccessUnit& unit : m_units) {
+            qint64 captured = m_senderClock.wallClockMs(unit.rtpTimestamp);
+            if (captured < 0) captured = QDateTime::currentMSecsSinceEpoch();
+            if (m_sink) m_sink(unit.data, captured);
+            ++delivered;
+        }
+    }
+
+    const qint64 deadline = m_jitter.nextDeadlineMs();
+    if (deadline > now) {
+        m_jitterTimer->start(static_cast<int>(deadline - now));
+    } else {
+        m_jitterTimer->stop();
+    }
+
+    const RtpJitterBuffer::Stats jitter = m_jitter.stats();
+    QMutexLocker locker(&m_statsMutex);
+    m_stats.packetsReceived = jitter.received;
+    m_stats.packetsLost = jitter.lost;
+    m_stats.packetsLate = jitter.late;
+    m_stats.packetsReordered = jitter.reordered;
+    m_stats.unitsDelivered += delivered;
+    m_stats.unitsDropped = m_depacketizer->unitsDropped();
+    m_stats.jitterMs = m_jitterEstimate.jitterMs();
+}
+
+bool RtspClient::takeChallenge(const Headers& headers) {
+    // Digest when offered, Basic otherwise
+    QByteArray basic;
+    for (const auto& h : headers) {
+        if (h.first != "www-authenticate") continue;
+        if (h.second.startsWith("Digest")) {
+            m_digest = true;
+            m_realm = parameter(h.second, "realm", ',');
+            m_nonce = parameter(h.second, "nonce", ',');
+            m_opaque = parameter(h.second, "opaque", ',');
+            m_qopAuth = parameter(h.second, "qop", ',').split(',').contains("auth");
+            m_nonceCount = 0;
+            return !m_nonce.isEmpty();
+        }
+        if (h.second.startsWith("Basic")) basic = h.second;
+    }
+    if (basic.isEmpty()) return false;
+    m_digest = false;
+    m_nonce = "basic";
+    return true;
+}
+
+QByteArray RtspClient::authorization(const QByteArray& method, const QString& uri) const {
+    if (m_nonce.isEmpty()) return QByteArray();
+    const QByteArray user = m_options.username.toUtf8();
+    const QByteArray password = m_options.password.toUtf8();
+    if (!m_digest) return "Basic " + (user + ':' + password).toBase64();
+
+    const QByteArray ha1 = md5Hex(user + ':' + m_realm + ':' + password);
+    const QByteArray ha2 = md5Hex(method + ':' + uri.toUtf8());
+    QByteArray value = "Digest username=\"" + user + "\", realm=\"" + m_realm
+                     + "\", nonce=\"" + m_nonce + "\", uri=\"" + uri.toUtf8() + "\"";
+    if (m_qopAuth) {
+        const QByteArray nc = QByteArray::number(++m_nonceCount, 16).rightJustified(8, '0');
+        const QByteArray cnonce = QByteArray::number(QRandomGenerator::global()->generate(), 16);
+        const QByteArray response = md5Hex(ha1 + ':' + m_nonce + ':' + nc + ':' + cnonce + ":auth:" + ha2);
+        value += ", qop=auth, nc=" + nc + ", cnonce=\"" + cnonce + "\", response=\"" + response + "\"";
+    } else {
+        value += ", response=\"" + md5Hex(ha1 + ':' + m_nonce + ':' + ha2) + "\"";
+    }
+    if (!m_opaque.isEmpty()) value += ", opaque=\"" + m_opaque + "\"";
+    return value;
+}
+
+QByteArray RtspClient::header(const Headers& headers, const QByteArray& name) {
+    for (const auto& h : headers) {
+        if (h.first == name) return h.second;
+    }
+    return QByteArray();
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,177 @@
+#ifndef RTSPCLIENT_H
+#define RTSPCLIENT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <QUrl>
+#include <functional>
+#include <memory>
+
+#include "video/RtpDepacketizer.h"
+#include "video/RtpStream.h"
+
+class QTcpSocket;
+class QTimer;
+class QUdpSocket;
+
+namespace CounterUAS {
+
+/**
+ * @brief Counters of a native RTP session
+ */
+struct RtpReceiverStats {
+    QString codec;
+    QString transport;              // "TCP" (interleaved) or "UDP"
+    quint64 packetsReceived = 0;
+    quint64 packetsLost = 0;        // Gaps the jitter buffer gave up on
+    quint64 packetsLate = 0;        // Arrived after their place was released
+    quint64 packetsReordered = 0;
+    quint64 unitsDelivered = 0;
+    quint64 unitsDropped = 0;       // Pictures lost to gaps or waiting for a keyframe
+    double jitterMs = 0.0;          // RFC 3550 interarrival jitter
+    bool senderClock = false;       // Capture times come from RTCP sender reports
+};
+
+/**
+ * @brief RTSP 1.0 client feeding RTP video straight to a decoder
+ *
+ * Plays the first video stream of a camera's SDP over RTP, interleaved on
+ * the RTSP connection or over a UDP port pair, through a jitter buffer of
+ * a fixed, configurable delay. Pictures go to the unit sink as soon as
+ * they are complete, stamped with their capture time on the sender's
+ * clock once an RTCP sender report has been seen and with their arrival
+ * time until then.
+ *
+ * Lives on a thread of its own (moveToThread) so socket reads, reordering
+ * and depacketisation never wait on the GUI; the sink and the codec check
+ * run on that thread. Basic and Digest authentication.
+ */
+class RtspClient : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        bool useTcp = true;
+        int jitterBufferMs = 40;
+        int timeoutMs = 5000;           // For each request, and for RTP once playing
+        QString username;
+        QString password;
+        QString userAgent = "CounterUAS-C2/1.0";
+    };
+
+    using UnitSink = std::function<void(const QByteArray& unit, qint64 captureTimeMs)>;
+    // Whether something downstream can decode the codec; asked before SETUP
+    using CodecCheck = std::function<bool(const QString& codec)>;
+
+    explicit RtspClient(QObject* parent = nullptr);
+    ~RtspClient() override;
+
+    // Before open()
+    void setOptions(const Options& options) { m_options = options; }
+    void setUnitSink(UnitSink sink) { m_sink = std::move(sink); }
+    void setCodecCheck(CodecCheck check) { m_codecCheck = std::move(check); }
+
+    // Any thread
+    RtpReceiverStats stats() const;
+
+public slots:
+    void open(const QUrl& url);         // DESCRIBE and SETUP; ready() follows
+    void play();
+    void pause();
+    void shutdown();                    // TEARDOWN, then everything stops
+
+signals:
+    void ready(const QString& codec);
+    void playing();
+    void unsupported(const QString& reason);   // Connected, but nothing here takes the stream
+    void failed(const QString& reason);
+
+private slots:
+    void onConnected();
+    void onReadyRead();
+    void onSocketError();
+    void onRtpReadyRead();
+    void onRtcpReadyRead();
+    void onKeepAlive();
+    void onWatchdog();
+    void onResponseTimeout();
+    void drain();
+
+private:
+    enum class State { Idle, Connecting, Describing, SettingUp, Ready, Starting, Playing, Pausing };
+    using Headers = QList<QPair<QByteArray, QByteArray>>;
+
+    void sendRequest(const QByteArray& method, const QString& uri, const Headers& extra = Headers());
+    void handleResponse(int status, const Headers& headers, const QByteArray& body);
+    void handleDescribe(const Headers& headers, const QByteArray& body);
+    void handleSetup(const Headers& headers);
+    bool parseSdp(const QByteArray& sdp, const QString& base);
+    bool bindUdpPorts();
+    void onRtp(const QByteArray& datagram);
+    void onRtcp(const QByteArray& datagram);
+    void fail(const QString& reason);
+    void stopAll();
+
+    QByteArray authorization(const QByteArray& method, const QString& uri) const;
+    bool takeChallenge(const Headers& headers);
+    static QByteArray header(const Headers& headers, const QByteArray& name);
+
+    Options m_options;
+    UnitSink m_sink;
+    CodecCheck m_codecCheck;
+
+    QTcpSocket* m_socket = nullptr;
+    QUdpSocket* m_rtpSocket = nullptr;
+    QUdpSocket* m_rtcpSocket = nullptr;
+    QTimer* m_keepAlive = nullptr;
+    QTimer* m_watchdog = nullptr;
+    QTimer* m_responseTimer = nullptr;
+    QTimer* m_jitterTimer = nullptr;
+
+    State m_state = State::Idle;
+    QUrl m_url;                         // Without credentials
+    QString m_requestUri;
+    QByteArray m_readBuffer;
+    int m_cseq = 0;
+    QByteArray m_lastMethod;
+    QString m_lastUri;
+    Headers m_lastHeaders;
+    bool m_authRetried = false;
+
+    // Authentication challenge
+    bool m_digest = false;
+    QByteArray m_realm;
+    QByteArray m_nonce;
+    QByteArray m_opaque;
+    bool m_qopAuth = false;
+    mutable int m_nonceCount = 0;
+
+    // Session
+    QString m_controlUri;
+    QByteArray m_sessionId;
+    int m_sessionTimeoutS = 60;
+    int m_payloadType = -1;
+    int m_clockRate = 90000;
+    int m_rtpChannel = 0;
+    QString m_codec;
+    std::unique_ptr<RtpDepacketizer> m_depacketizer;
+
+    RtpJitterBuffer m_jitter;
+    RtpJitterEstimator m_jitterEstimate;
+    RtcpSenderClock m_senderClock;
+    QElapsedTimer m_clock;
+    qint64 m_lastPacketMs = 0;
+    QVector<RtpAccessUnit> m_units;
+
+    mutable QMutex m_statsMutex;
+    RtpReceiverStats m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // RTSPCLIENT_H
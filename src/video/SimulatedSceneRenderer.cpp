@@ -0,0 +1,417 @@
+#include "video/SimulatedSceneRenderer.h"
+#include "utils/FastRandom.h"
+#include <QPainter>
+#include <QtMath>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+const int RADAR_SIZE = 720;
+
+} // namespace
+
+SimulatedSceneRenderer::SimulatedSceneRenderer(FramePool& pool)
+    : m_pool(pool)
+{
+}
+
+QImage SimulatedSceneRenderer::render(const SimulatedSceneState& state) {
+    switch (state.scenarioType) {
+        case 1:
+            return renderThermal(state);
+        case 2:
+            return renderRadar(state);
+        default:
+            return renderEO(state);
+    }
+}
+
+QImage SimulatedSceneRenderer::frameFrom(const QImage& background, int x, int width) {
+    QImage frame = m_pool.acquire(QSize(width, background.height()), background.format());
+    const int bytesPerPixel = background.depth() / 8;
+    const int rowBytes = width * bytesPerPixel;
+    for (int y = 0; y < background.height(); ++y) {
+        std::memcpy(frame.scanLine(y), background.constScanLine(y) + x * bytesPerPixel, rowBytes);
+    }
+    return frame;
+}
+
+QImage SimulatedSceneRenderer::renderEO(const SimulatedSceneState& state) {
+    const int width = state.frameSize.width();
+    const int height = state.frameSize.height();
+    const int horizonY = height / 2 + 20;
+
+    if (m_eoBackground.size() != QSize(width + TERRAIN_PAN_PX, height)) {
+        // Wide enough to pan the terrain by up to TERRAIN_PAN_PX
+        m_eoBackground = QImage(width + TERRAIN_PAN_PX, height, QImage::Format_RGB888);
+        QPainter painter(&m_eoBackground);
+
+        // Sky gradient background
+        QLinearGradient skyGradient(0, 0, 0, height);
+        skyGradient.setColorAt(0.0, QColor(100, 140, 180));
+        skyGradient.setColorAt(0.4, QColor(150, 180, 210));
+        skyGradient.setColorAt(0.5, QColor(170, 200, 220));
+        skyGradient.setColorAt(0.6, QColor(100, 120, 80));
+        skyGradient.setColorAt(1.0, QColor(60, 80, 50));
+        painter.fillRect(m_eoBackground.rect(), skyGradient);
+
+        // Draw horizon line
+        painter.setPen(QPen(QColor(80, 100, 60), 2));
+        painter.drawLine(0, horizonY, m_eoBackground.width(), horizonY);
+
+        // Draw some terrain features, as they sit at pan 0 shifted right by
+        // TERRAIN_PAN_PX so the leftmost is whole
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(70, 90, 60, 100));
+        for (int i = 0; i < 5; i++) {
+            int x = (i * width / 4) + TERRAIN_PAN_PX;
+            int h = 30 + (i % 3) * 20;
+            painter.drawEllipse(x - 50, horizonY - h/2, 100, h);
+        }
+    }
+
+    const int pan = static_cast<int>(state.frameCount % TERRAIN_PAN_PX);
+    QImage frame = frameFrom(m_eoBackground, TERRAIN_PAN_PX - pan, width);
+    QPainter painter(&frame);
+
+    // Draw crosshairs
+    drawCrosshairs(painter, width / 2, height / 2);
+
+    // Draw target if visible
+    if (state.targetVisible) {
+        int targetX = width / 2 + static_cast<int>(150 * std::sin(state.targetPhase));
+        int targetY = height / 2 - 50 + static_cast<int>(30 * std::cos(state.targetPhase * 0.7));
+
+        drawTarget(painter, targetX, targetY);
+    }
+
+    // Draw telemetry overlay
+    if (state.showOverlay) {
+        drawTelemetry(painter, frame.size(), state);
+    }
+
+    painter.end();
+
+    return frame;
+}
+
+QImage SimulatedSceneRenderer::renderThermal(const SimulatedSceneState& state) {
+    const int width = state.frameSize.width();
+    const int height = state.frameSize.height();
+
+    if (m_thermalBackgrounds.isEmpty() || m_thermalBackgrounds.first().size() != state.frameSize) {
+        m_thermalBackgrounds.clear();
+        for (int field = 0; field < THERMAL_NOISE_FIELDS; ++field) {
+            QImage background(width, height, QImage::Format_RGB888);
+
+            // Dark thermal background with noise in 4x4 blocks
+            FastRandom random(field + 1);
+            QVector<quint8> noise(width / 4 + 1);
+            for (int y = 0; y < height; ++y) {
+                if (y % 4 == 0) {
+                    for (quint8& n : noise) n = static_cast<quint8>(random.bounded(20));
+                }
+                uchar* row = background.scanLine(y);
+                for (int x = 0; x < width; ++x) {
+                    const quint8 n = noise[x / 4];
+                    row[x * 3] = 20 + n;
+                    row[x * 3 + 1] = 20 + n;
+                    row[x * 3 + 2] = 25 + n;
+                }
+            }
+
+            QPainter painter(&background);
+
+            // Draw hot spots (buildings/vehicles)
+            painter.setBrush(QColor(150, 150, 100));
+            painter.setPen(Qt::NoPen);
+            painter.drawRect(100, height - 100, 80, 40);
+            painter.drawRect(width - 200, height - 120, 60, 50);
+
+            // Draw horizon
+            painter.setPen(QPen(QColor(60, 60, 50), 1));
+            painter.drawLine(0, height/2 + 30, width, height/2 + 30);
+            painter.end();
+
+            m_thermalBackgrounds.append(background);
+        }
+    }
+
+    QImage frame = frameFrom(m_thermalBackgrounds[state.frameCount % THERMAL_NOISE_FIELDS], 0, width);
+    QPainter painter(&frame);
+
+    // Draw crosshairs (white/hot)
+    painter.setPen(QPen(QColor(255, 255, 200), 2));
+    int cx = width / 2, cy = height / 2;
+    painter.drawLine(cx - 40, cy, cx - 15, cy);
+    painter.drawLine(cx + 15, cy, cx + 40, cy);
+    painter.drawLine(cx, cy - 40, cx, cy - 15);
+    painter.drawLine(cx, cy + 15, cx, cy + 40);
+
+    // Draw target (hot signature)
+    if (state.targetVisible) {
+        int targetX = width / 2 + static_cast<int>(120 * std::sin(state.targetPhase));
+        int targetY = height / 2 - 40 + static_cast<int>(25 * std::cos(state.targetPhase * 0.8));
+
+        // Hot core
+        QRadialGradient hotSpot(targetX, targetY, 40);
+        hotSpot.setColorAt(0, QColor(255, 255, 220));
+        hotSpot.setColorAt(0.3, QColor(255, 200, 100));
+        hotSpot.setColorAt(0.7, QColor(150, 100, 50));
+        hotSpot.setColorAt(1, QColor(40, 40, 30));
+        painter.setBrush(hotSpot);
+        painter.setPen(Qt::NoPen);
+        painter.drawEllipse(targetX - 30, targetY - 20, 60, 40);
+
+        // Target box
+        painter.setPen(QPen(QColor(255, 255, 200), 2));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(targetX - 35, targetY - 25, 70, 50);
+    }
+
+    // Draw telemetry
+    if (state.showOverlay) {
+        painter.setPen(QColor(200, 200, 150));
+        painter.setFont(QFont("Courier", 10));
+        painter.drawText(10, 20, QString("THERMAL IR  %1").arg(state.cameraName));
+        painter.drawText(10, 40, state.time.toString("yyyy-MM-dd hh:mm:ss.zzz"));
+        painter.drawText(10, height - 20, QString("WFOV  POLARITY: WHITE HOT"));
+        painter.drawText(width - 150, 20, QString("FRAME: %1").arg(state.frameCount));
+    }
+
+    painter.end();
+
+    return frame;
+}
+
+QImage SimulatedSceneRenderer::renderRadar(const SimulatedSceneState& state) {
+    const int width = RADAR_SIZE;
+    const int height = RADAR_SIZE;
+
+    int cx = width / 2;
+    int cy = height / 2;
+    int maxRadius = qMin(cx, cy) - 20;
+
+    if (m_radarBackground.isNull()) {
+        m_radarBackground = QImage(width, height, QImage::Format_RGB888);
+        m_radarBackground.fill(QColor(0, 20, 0));
+
+        QPainter painter(&m_radarBackground);
+        painter.setRenderHint(QPainter::Antialiasing);
+
+        // Draw range rings
+        painter.setPen(QPen(QColor(0, 80, 0), 1));
+        for (int r = maxRadius / 4; r <= maxRadius; r += maxRadius / 4) {
+            painter.drawEllipse(cx - r, cy - r, r * 2, r * 2);
+        }
+
+        // Draw bearing lines
+        for (int angle = 0; angle < 360; angle += 30) {
+            double rad = qDegreesToRadians(static_cast<double>(angle));
+            int x = cx + static_cast<int>(maxRadius * std::sin(rad));
+            int y = cy - static_cast<int>(maxRadius * std::cos(rad));
+            painter.drawLine(cx, cy, x, y);
+        }
+    }
+
+    QImage frame = frameFrom(m_radarBackground, 0, width);
+    QPainter painter(&frame);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // Draw sweep line
+    double sweepAngle = (state.frameCount * 3) % 360;
+    double sweepRad = qDegreesToRadians(sweepAngle);
+    int sweepX = cx + static_cast<int>(maxRadius * std::sin(sweepRad));
+    int sweepY = cy - static_cast<int>(maxRadius * std::cos(sweepRad));
+
+    // Sweep fade effect
+    painter.setPen(Qt::NoPen);
+    for (int fade = 30; fade >= 0; fade -= 5) {
+        double fadeAngle = sweepAngle - fade;
+        double fadeRad = qDegreesToRadians(fadeAngle);
+        int alpha = 255 - fade * 8;
+
+        QPolygon sweep;
+        sweep << QPoint(cx, cy);
+        for (int r = 0; r <= maxRadius; r += 10) {
+            int sx = cx + static_cast<int>(r * std::sin(fadeRad));
+            int sy = cy - static_cast<int>(r * std::cos(fadeRad));
+            sweep << QPoint(sx, sy);
+        }
+        painter.setBrush(QColor(0, 255, 0, alpha / 10));
+        painter.drawPolygon(sweep);
+    }
+
+    painter.setPen(QPen(QColor(0, 255, 0), 2));
+    painter.drawLine(cx, cy, sweepX, sweepY);
+
+    // Draw targets
+    if (state.targetVisible) {
+        const double phase = state.targetPhase;
+
+        // Primary target
+        double targetRange = 0.6 + 0.1 * std::sin(phase);
+        double targetBearing = 45 + 20 * std::sin(phase * 0.5);
+        double targetRad = qDegreesToRadians(targetBearing);
+        int targetX = cx + static_cast<int>(maxRadius * targetRange * std::sin(targetRad));
+        int targetY = cy - static_cast<int>(maxRadius * targetRange * std::cos(targetRad));
+
+        // Target blip
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(0, 255, 0, 200));
+        painter.drawEllipse(targetX - 6, targetY - 6, 12, 12);
+
+        // Target trail
+        painter.setPen(QPen(QColor(0, 200, 0, 100), 2));
+        for (int t = 1; t <= 5; t++) {
+            double trailPhase = phase - t * 0.1;
+            double trailRange = 0.6 + 0.1 * std::sin(trailPhase);
+            double trailBearing = 45 + 20 * std::sin(trailPhase * 0.5);
+            double trailRad = qDegreesToRadians(trailBearing);
+            int trailX = cx + static_cast<int>(maxRadius * trailRange * std::sin(trailRad));
+            int trailY = cy - static_cast<int>(maxRadius * trailRange * std::cos(trailRad));
+            painter.drawPoint(trailX, trailY);
+        }
+
+        // Target label
+        painter.setPen(QColor(0, 255, 0));
+        painter.setFont(QFont("Courier", 9));
+        painter.drawText(targetX + 10, targetY - 5, "TGT-001");
+        painter.drawText(targetX + 10, targetY + 10, QString("%1m").arg(static_cast<int>(targetRange * 2000)));
+    }
+
+    // Draw telemetry
+    painter.setPen(QColor(0, 200, 0));
+    painter.setFont(QFont("Courier", 10));
+    painter.drawText(10, 20, "RADAR DISPLAY");
+    painter.drawText(10, 40, state.time.toString("hh:mm:ss"));
+    painter.drawText(width - 100, 20, QString("AZ: %1").arg(static_cast<int>(sweepAngle)));
+    painter.drawText(10, height - 10, "RANGE: 2km");
+
+    painter.end();
+
+    return frame;
+}
+
+void SimulatedSceneRenderer::drawTarget(QPainter& painter, int x, int y) {
+    // Target box
+    painter.setPen(QPen(Qt::red, 2));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(x - 30, y - 20, 60, 40);
+
+    // Corner brackets
+    painter.drawLine(x - 35, y - 25, x - 35, y - 15);
+    painter.drawLine(x - 35, y - 25, x - 25, y - 25);
+
+    painter.drawLine(x + 35, y - 25, x + 35, y - 15);
+    painter.drawLine(x + 35, y - 25, x + 25, y - 25);
+
+    painter.drawLine(x - 35, y + 25, x - 35, y + 15);
+    painter.drawLine(x - 35, y + 25, x - 25, y + 25);
+
+    painter.drawLine(x + 35, y + 25, x + 35, y + 15);
+    painter.drawLine(x + 35, y + 25, x + 25, y + 25);
+
+    // Cross on target
+    painter.drawLine(x - 10, y, x + 10, y);
+    painter.drawLine(x, y - 10, x, y + 10);
+
+    // Target label
+    painter.setFont(QFont("Courier", 9, QFont::Bold));
+    painter.drawText(x + 40, y - 10, "TGT-001");
+    painter.drawText(x + 40, y + 5, "UAS");
+
+    // Simulated drone shape
+    painter.setBrush(QColor(60, 60, 60));
+    painter.setPen(QPen(QColor(40, 40, 40), 1));
+
+    // Body
+    painter.drawEllipse(x - 8, y - 4, 16, 8);
+
+    // Arms and rotors
+    painter.drawLine(x - 20, y - 12, x + 20, y + 12);
+    painter.drawLine(x - 20, y + 12, x + 20, y - 12);
+
+    // Draw rotor discs with animation effect
+    painter.setBrush(QColor(80, 80, 80, 150));
+    for (int i = 0; i < 4; i++) {
+        int rx = x + ((i < 2) ? -18 : 18);
+        int ry = y + ((i % 2 == 0) ? -10 : 10);
+        painter.drawEllipse(rx - 8, ry - 3, 16, 6);
+    }
+}
+
+void SimulatedSceneRenderer::drawCrosshairs(QPainter& painter, int cx, int cy) {
+    painter.setPen(QPen(Qt::green, 2));
+
+    // Outer crosshairs
+    painter.drawLine(cx - 50, cy, cx - 20, cy);
+    painter.drawLine(cx + 20, cy, cx + 50, cy);
+    painter.drawLine(cx, cy - 50, cx, cy - 20);
+    painter.drawLine(cx, cy + 20, cx, cy + 50);
+
+    // Center dot
+    painter.setBrush(Qt::green);
+    painter.drawEllipse(cx - 3, cy - 3, 6, 6);
+
+    // Range circles
+    painter.setBrush(Qt::NoBrush);
+    painter.setPen(QPen(Qt::green, 1, Qt::DashLine));
+    painter.drawEllipse(cx - 100, cy - 100, 200, 200);
+    painter.drawEllipse(cx - 200, cy - 200, 400, 400);
+}
+
+void SimulatedSceneRenderer::drawTelemetry(QPainter& painter, const QSize& size,
+                                           const SimulatedSceneState& state) {
+    int w = size.width();
+    int h = size.height();
+
+    painter.setPen(Qt::white);
+    painter.setFont(QFont("Courier", 10));
+
+    // Top left - timestamp and camera info
+    painter.drawText(10, 20, state.time.toString("yyyy-MM-dd hh:mm:ss.zzz"));
+    painter.drawText(10, 40, QString("CAM: %1").arg(state.cameraName));
+    painter.drawText(10, 60, QString("FRAME: %1").arg(state.frameCount));
+
+    // Top right - mode indicator
+    QString modeStr;
+    switch (state.scenarioType) {
+        case 0: modeStr = "EO/IR"; break;
+        case 1: modeStr = "THERMAL"; break;
+        case 2: modeStr = "RADAR"; break;
+        default: modeStr = "UNKNOWN"; break;
+    }
+    painter.drawText(w - 100, 20, modeStr);
+
+    // Bottom - simulated PTZ info
+    double azimuth = 180 + 30 * std::sin(state.targetPhase * 0.3);
+    double elevation = 5 + 10 * std::cos(state.targetPhase * 0.2);
+    double zoom = 1.0 + 0.5 * std::abs(std::sin(state.targetPhase * 0.1));
+
+    painter.drawText(10, h - 30, QString("AZ: %1%2  EL: %3%4  ZOOM: %5x")
+                                     .arg(azimuth, 0, 'f', 1)
+                                     .arg(QChar(0x00B0))
+                                     .arg(elevation, 0, 'f', 1)
+                                     .arg(QChar(0x00B0))
+                                     .arg(zoom, 0, 'f', 1));
+
+    // Simulated GPS position
+    painter.drawText(10, h - 10, QString("LAT: 34.0522N  LON: 118.2437W  ALT: 100m"));
+
+    // Recording indicator
+    if ((state.frameCount / 30) % 2 == 0) {
+        painter.setPen(Qt::red);
+        painter.setBrush(Qt::red);
+        painter.drawEllipse(w - 30, h - 25, 12, 12);
+        painter.drawText(w - 70, h - 15, "REC");
+    }
+
+    // Status bar
+    painter.setPen(QColor(0, 255, 0));
+    painter.drawText(w - 150, 40, "STATUS: TRACKING");
+}
+
+} // namespace CounterUAS
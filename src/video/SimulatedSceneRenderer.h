@@ -0,0 +1,73 @@
+#ifndef SIMULATEDSCENERENDERER_H
+#define SIMULATEDSCENERENDERER_H
+
+#include <QDateTime>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include "utils/FramePool.h"
+
+class QPainter;
+
+namespace CounterUAS {
+
+/**
+ * @brief Everything that changes between two simulated frames
+ */
+struct SimulatedSceneState {
+    int scenarioType = 0;           // 0=EO, 1=Thermal, 2=Radar
+    QString cameraName;
+    bool showOverlay = true;
+    bool targetVisible = true;
+    qint64 frameCount = 0;
+    double targetPhase = 0.0;
+    QDateTime time;                 // Shown in the telemetry
+    QSize frameSize{1280, 720};     // EO and thermal; radar stays square at 720
+};
+
+/**
+ * @brief Paints SimulationVideoSource's procedural scenes
+ *
+ * What never moves (sky and terrain, thermal noise and hot spots, range
+ * rings) is painted once into a cached background; a frame is that
+ * background copied row by row into a pooled buffer, with only the target,
+ * sweep, reticle and text painted over it. The noise cycles through a few
+ * pre-rendered fields rather than being drawn fresh.
+ *
+ * Touches nothing but its own caches and the pool, so it can run on a
+ * worker thread; one render at a time per renderer.
+ */
+class SimulatedSceneRenderer {
+public:
+    static constexpr int THERMAL_NOISE_FIELDS = 4;
+    static constexpr int TERRAIN_PAN_PX = 50;
+
+    explicit SimulatedSceneRenderer(FramePool& pool);
+
+    QImage render(const SimulatedSceneState& state);
+
+    // The EO telemetry block, also drawn over played-back image sequences
+    static void drawTelemetry(QPainter& painter, const QSize& size, const SimulatedSceneState& state);
+
+private:
+    QImage renderEO(const SimulatedSceneState& state);
+    QImage renderThermal(const SimulatedSceneState& state);
+    QImage renderRadar(const SimulatedSceneState& state);
+
+    // A pooled frame of background's height holding columns [x, x + width)
+    QImage frameFrom(const QImage& background, int x, int width);
+
+    static void drawTarget(QPainter& painter, int x, int y);
+    static void drawCrosshairs(QPainter& painter, int cx, int cy);
+
+    FramePool& m_pool;
+    QImage m_eoBackground;              // TERRAIN_PAN_PX wider than a frame
+    QVector<QImage> m_thermalBackgrounds;
+    QImage m_radarBackground;
+};
+
+} // namespace CounterUAS
+
+#endif // SIMULATEDSCENERENDERER_H
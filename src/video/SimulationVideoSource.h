@@ -2,8 +2,11 @@
 #define SIMULATIONVIDEOSOURCE_H
 
 #include "video/VideoSource.h"
+#include "video/SimulatedSceneRenderer.h"
 #include <QDir>
+#include <QMutex>
 #include <QStringList>
+#include <QWaitCondition>
 
 namespace CounterUAS {
 
@@ -15,6 +18,11 @@ namespace CounterUAS {
  * - Loading images from Qt resources
  * - Procedurally generated frames for UAS tracking simulation
  * - Customizable overlays and telemetry display
+ *
+ * Generated frames are painted on the global thread pool, one at a time;
+ * a tick that finds the previous frame still rendering is counted as dropped.
+ * Each is stamped with the tick that generated it as its capture time, so
+ * its latency downstream includes the render.
  */
 class SimulationVideoSource : public VideoSource {
     Q_OBJECT
@@ -56,6 +64,10 @@ public:
     void setShowOverlay(bool show) { m_showOverlay = show; }
     bool showOverlay() const { return m_showOverlay; }
     
+    // EO and thermal frames; 1280x720 unless set
+    void setFrameSize(const QSize& size);
+    QSize frameSize() const { return m_frameSize; }
+    
     // Target simulation
     void setTargetPosition(const QPointF& pos) { m_targetPos = pos; }
     QPointF targetPosition() const { return m_targetPos; }
@@ -66,15 +78,14 @@ public:
 protected slots:
     void processFrame() override;
     
+private slots:
+    void onFrameRendered(const QImage& frame, qint64 captureTimeMs);
+    
 private:
-    QImage generateFrame();
-    QImage generateUASTrackingFrame();
-    QImage generateThermalFrame();
-    QImage generateRadarFrame();
+    void renderGenerated();
+    void waitForRender();
+    SimulatedSceneState sceneState() const;
     void drawOverlay(QImage& frame);
-    void drawTarget(QPainter& painter, int x, int y);
-    void drawCrosshairs(QPainter& painter, int cx, int cy);
-    void drawTelemetry(QPainter& painter, const QSize& size);
     
     SimulationMode m_mode = SimulationMode::Generated;
     bool m_isOpen = false;
@@ -89,12 +100,19 @@ private:
     int m_scenarioType = 0;  // 0=EO, 1=Thermal, 2=Radar
     QString m_cameraName = "SIM-CAM-001";
     bool m_showOverlay = true;
+    QSize m_frameSize{1280, 720};
     qint64 m_frameCount = 0;
     
     // Target simulation
     QPointF m_targetPos{0.5, 0.5};  // Normalized position
     bool m_targetVisible = true;
     double m_targetPhase = 0.0;
+    
+    // Background rendering
+    SimulatedSceneRenderer m_renderer{m_framePool};
+    QMutex m_renderMutex;
+    QWaitCondition m_renderDone;
+    bool m_rendering = false;
 };
 
 } // namespace CounterUAS
@@ -0,0 +1,210 @@
+#include "video/SlewControlLoop.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <cmath>
+
+namespace CounterUAS {
+
+namespace {
+
+// Longest gap between cycles integrated as motion; beyond it the thread
+// was starved and the estimate waits for feedback instead
+constexpr double MAX_STEP_S = 0.5;
+constexpr double MAX_GAIN_LATENCY = 0.5;
+
+double wrap180(double degrees) {
+    return std::remainder(degrees, 360.0);
+}
+
+} // namespace
+
+SlewControlLoop::SlewControlLoop(QObject* parent)
+    : QObject(parent)
+{
+}
+
+SlewControlLoop::~SlewControlLoop() {
+    stop();
+}
+
+void SlewControlLoop::setConfig(const SlewLoopConfig& config) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_config = config;
+        m_config.rateHz = qBound(1, m_config.rateHz, 1000);
+        m_config.feedforwardSpanMs = qMax(1, m_config.feedforwardSpanMs);
+    }
+    if (isRunning()) {
+        // The timer's interval belongs to the loop thread
+        stop();
+        start();
+    }
+}
+
+SlewLoopConfig SlewControlLoop::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+void SlewControlLoop::setCamera(const QString& cameraId, const CameraMount& mount, double pan, double tilt) {
+    QMutexLocker locker(&m_mutex);
+    Camera& camera = m_cameras[cameraId];
+    camera.mount = mount;
+    camera.pan = pan;
+    camera.tilt = tilt;
+}
+
+void SlewControlLoop::removeCamera(const QString& cameraId) {
+    QMutexLocker locker(&m_mutex);
+    m_cameras.remove(cameraId);
+}
+
+bool SlewControlLoop::hasCamera(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    return m_cameras.contains(cameraId);
+}
+
+void SlewControlLoop::setTarget(const QString& cameraId, const TrackSnapshot& track, qint64 stateTimeMs) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_cameras.find(cameraId);
+    if (it == m_cameras.end()) return;
+    it->target = track;
+    it->stateTimeMs = stateTimeMs;
+    it->state.engaged = true;
+}
+
+void SlewControlLoop::release(const QString& cameraId) {
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_cameras.find(cameraId);
+        if (it == m_cameras.end() || !it->state.engaged) return;
+        it->state = CameraState();
+        it->lastStepMs = 0;
+    }
+    emit rateCommand(cameraId, 0.0, 0.0);
+}
+
+void SlewControlLoop::setFeedback(const QString& cameraId, double pan, double tilt) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_cameras.find(cameraId);
+    if (it == m_cameras.end()) return;
+    it->pan = pan;
+    it->tilt = tilt;
+}
+
+SlewControlLoop::CameraState SlewControlLoop::cameraState(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    return m_cameras.value(cameraId).state;
+}
+
+void SlewControlLoop::start() {
+    if (m_thread) return;
+
+    const int intervalMs = qMax(1, 1000 / config().rateHz);
+    m_thread = new QThread();
+    m_thread->setObjectName("SlewControlLoop");
+
+    // Timer and cycle both run on the loop thread
+    QTimer* timer = new QTimer();
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->setInterval(intervalMs);
+    timer->moveToThread(m_thread);
+    connect(m_thread, &QThread::started, timer, [timer]() { timer->start(); });
+    connect(timer, &QTimer::timeout, timer, [this, intervalMs]() {
+        const qint64 startNs = TimeUtils::monotonicNs();
+        step(QDateTime::currentMSecsSinceEpoch());
+        ThreadPlacement::instance().reportCycle(ThreadRole::PtzControl,
+                                                (TimeUtils::monotonicNs() - startNs) / 1000, intervalMs * 1000);
+    });
+    connect(m_thread, &QThread::finished, timer, &QObject::deleteLater);
+
+    ThreadPlacement::instance().assign(m_thread, ThreadRole::PtzControl);
+    m_thread->start(QThread::HighPriority);
+    Logger::instance().info("SlewControlLoop", QString("Running at %1 Hz").arg(1000 / intervalMs));
+}
+
+void SlewControlLoop::stop() {
+    if (!m_thread) return;
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+void SlewControlLoop::step(qint64 nowMs) {
+    struct Command {
+        QString cameraId;
+        double panRate;
+        double tiltRate;
+    };
+    QVector<Command> commands;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        const double spanS = m_config.feedforwardSpanMs / 1000.0;
+
+        for (auto it = m_cameras.begin(); it != m_cameras.end(); ++it) {
+            Camera& camera = it.value();
+            if (!camera.state.engaged) continue;
+
+            // Carry the estimate forward by what was commanded since the last cycle
+            if (camera.lastStepMs > 0) {
+                const double dt = (nowMs - camera.lastStepMs) / 1000.0;
+                if (dt > 0.0 && dt <= MAX_STEP_S) {
+                    camera.pan = wrap180(camera.pan + camera.state.panRate * dt);
+                    camera.tilt = qBound(-90.0, camera.tilt + camera.state.tiltRate * dt, 90.0);
+                }
+            }
+            camera.lastStepMs = nowMs;
+
+            // Where the track will be when this cycle's command takes hold
+            const CameraMount& mount = camera.mount;
+            const qint64 lead = qMax<qint64>(0, nowMs - camera.stateTimeMs) + mount.latencyMs;
+            double aimPan = 0.0, aimTilt = 0.0, nextPan = 0.0, nextTilt = 0.0;
+            aimAngles(mount.position, mount.headingDeg, camera.target.predictedPosition(lead), aimPan, aimTilt);
+            aimAngles(mount.position, mount.headingDeg,
+                      camera.target.predictedPosition(lead + m_config.feedforwardSpanMs), nextPan, nextTilt);
+            const double feedPan = wrap180(nextPan - aimPan) / spanS;
+            const double feedTilt = (nextTilt - aimTilt) / spanS;
+
+            // Where the camera will be by then: the rates in flight keep it moving
+            const double latencyS = mount.latencyMs / 1000.0;
+            const double panError = wrap180(aimPan - (camera.pan + camera.state.panRate * latencyS));
+            const double tiltError = aimTilt - (camera.tilt + camera.state.tiltRate * latencyS);
+
+            // Gain times latency above about one half rings; long latencies get less gain
+            const double gain = mount.latencyMs > 0 ? qMin(m_config.gain, MAX_GAIN_LATENCY / latencyS)
+                                                    : m_config.gain;
+            double panRate = feedPan;
+            double tiltRate = feedTilt;
+            if (std::abs(panError) > m_config.deadbandDeg) panRate += gain * panError;
+            if (std::abs(tiltError) > m_config.deadbandDeg) tiltRate += gain * tiltError;
+
+            camera.state.panRate = qBound(-mount.maxPanRate, panRate, mount.maxPanRate);
+            camera.state.tiltRate = qBound(-mount.maxTiltRate, tiltRate, mount.maxTiltRate);
+            camera.state.panErrorDeg = panError;
+            camera.state.tiltErrorDeg = tiltError;
+            commands.append({it.key(), camera.state.panRate, camera.state.tiltRate});
+        }
+    }
+
+    for (const Command& command : commands) {
+        emit rateCommand(command.cameraId, command.panRate, command.tiltRate);
+    }
+}
+
+void SlewControlLoop::aimAngles(const GeoPosition& mount, double headingDeg, const GeoPosition& target,
+                                double& pan, double& tilt) {
+    const double ground = CoordinateUtils::haversineDistance(mount, target);
+    pan = wrap180(CoordinateUtils::bearing(mount, target) - headingDeg);
+    tilt = qRadiansToDegrees(std::atan2(target.altitude - mount.altitude, ground));
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,110 @@
+#ifndef SLEWCONTROLLOOP_H
+#define SLEWCONTROLLOOP_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include "core/TrackSnapshot.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief Gains and rate of the predictive slew loop
+ */
+struct SlewLoopConfig {
+    int rateHz = 50;
+    double gain = 4.0;              // 1/s: degrees/second of correction per degree of error
+    double deadbandDeg = 0.05;      // Errors below this get feedforward only
+    int feedforwardSpanMs = 100;    // Line-of-sight rate is differenced over this
+};
+
+/**
+ * @brief Closed-loop rate control pointing PTZ cameras at moving tracks
+ *
+ * Each cycle aims every engaged camera at where its track will be once a
+ * command issued now takes effect: the track's filtered state is
+ * extrapolated over its age plus the camera's command latency. The
+ * commanded pan/tilt rates are the line-of-sight rate to that point plus
+ * a proportional correction of the pointing error, measured against the
+ * camera's reported position carried forward by the rates still in
+ * flight.
+ *
+ * Runs on a timer thread of its own at the configured rate; inputs may
+ * come from any thread. Rates go out through rateCommand(), for the
+ * receiver to pass to the PTZ controller on its own thread.
+ */
+class SlewControlLoop : public QObject {
+    Q_OBJECT
+
+public:
+    struct CameraMount {
+        GeoPosition position;
+        double headingDeg = 0.0;    // Bearing of pan 0
+        int latencyMs = 150;        // Command to motion
+        double maxPanRate = 50.0;   // degrees/second
+        double maxTiltRate = 30.0;
+    };
+
+    struct CameraState {
+        bool engaged = false;
+        double panRate = 0.0;       // Last commanded
+        double tiltRate = 0.0;
+        double panErrorDeg = 0.0;   // Last pointing error
+        double tiltErrorDeg = 0.0;
+    };
+
+    explicit SlewControlLoop(QObject* parent = nullptr);
+    ~SlewControlLoop() override;
+
+    void setConfig(const SlewLoopConfig& config);
+    SlewLoopConfig config() const;
+
+    // Any thread
+    void setCamera(const QString& cameraId, const CameraMount& mount, double pan, double tilt);
+    void removeCamera(const QString& cameraId);
+    bool hasCamera(const QString& cameraId) const;
+    // The track's state as of stateTimeMs (Unix ms); engages the camera
+    void setTarget(const QString& cameraId, const TrackSnapshot& track, qint64 stateTimeMs);
+    void release(const QString& cameraId);
+    void setFeedback(const QString& cameraId, double pan, double tilt);
+    CameraState cameraState(const QString& cameraId) const;
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+
+    // One cycle for every engaged camera at nowMs (Unix ms); the loop
+    // thread calls this, tests may drive it directly
+    void step(qint64 nowMs);
+
+    // Pan (from the mount heading, -180 to 180) and tilt (up from level)
+    // of target as seen from mount
+    static void aimAngles(const GeoPosition& mount, double headingDeg, const GeoPosition& target,
+                          double& pan, double& tilt);
+
+signals:
+    void rateCommand(const QString& cameraId, double panRate, double tiltRate);
+
+private:
+    struct Camera {
+        CameraMount mount;
+        CameraState state;
+        TrackSnapshot target;
+        qint64 stateTimeMs = 0;
+        double pan = 0.0;           // Estimated now: feedback plus commands since
+        double tilt = 0.0;
+        qint64 lastStepMs = 0;
+    };
+
+    mutable QMutex m_mutex;
+    SlewLoopConfig m_config;
+    QHash<QString, Camera> m_cameras;
+    QThread* m_thread = nullptr;
+};
+
+} // namespace CounterUAS
+
+#endif // SLEWCONTROLLOOP_H
@@ -0,0 +1,495 @@
+#include "video/ThermalProcessor.h"
+#include <QElapsedTimer>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define THERMAL_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define THERMAL_AVX2 1
+#define THERMAL_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define THERMAL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr int AGC_BIN_BITS = 12;
+
+// The window as integer steps: out = ((min(v - low, span) << shift) * multiplier) >> 16,
+// with shift as large as keeps span << shift in 16 bits, so multiplier
+// (255 * 65536 / (span << shift)) loses little precision
+struct WindowMap {
+    quint16 low = 0;
+    quint16 span = 1;
+    int shift = 0;
+    quint16 multiplier = 0;
+    uchar flip = 0;                 // 0xff inverts
+};
+
+using MapRowFn = void (*)(const quint16*, uchar*, int, const WindowMap&);
+
+void mapRun(const quint16* src, uchar* dst, int from, int to, const WindowMap& map) {
+    for (int i = from; i < to; ++i) {
+        const int d = qMin(src[i] > map.low ? src[i] - map.low : 0, int(map.span)) << map.shift;
+        dst[i] = uchar(((d * int(map.multiplier)) >> 16) ^ map.flip);
+    }
+}
+
+void mapRowScalar(const quint16* src, uchar* dst, int count, const WindowMap& map) {
+    mapRun(src, dst, 0, count, map);
+}
+
+// dst = upper * (256 - weight) + lower * weight, for a multiple of 16 levels
+using BlendFn = void (*)(const uchar*, const uchar*, int, quint16*, int);
+
+void blendScalar(const uchar* upper, const uchar* lower, int weight, quint16* dst, int count) {
+    for (int i = 0; i < count; ++i) dst[i] = quint16(upper[i] * (256 - weight) + lower[i] * weight);
+}
+
+#if defined(THERMAL_SSE2)
+
+void mapRowSse2(const quint16* src, uchar* dst, int count, const WindowMap& map) {
+    const __m128i low = _mm_set1_epi16(short(map.low));
+    const __m128i span = _mm_set1_epi16(short(map.span));
+    const __m128i multiplier = _mm_set1_epi16(short(map.multiplier));
+    const __m128i shift = _mm_cvtsi32_si128(map.shift);
+    const __m128i flip = _mm_set1_epi8(char(map.flip));
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), low);
+        __m128i b = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), low);
+        // Unsigned minimum without SSE4.1
+        a = _mm_sub_epi16(a, _mm_subs_epu16(a, span));
+        b = _mm_sub_epi16(b, _mm_subs_epu16(b, span));
+        a = _mm_mulhi_epu16(_mm_sll_epi16(a, shift), multiplier);
+        b = _mm_mulhi_epu16(_mm_sll_epi16(b, shift), multiplier);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(_mm_packus_epi16(a, b), flip));
+    }
+    mapRun(src, dst, i, count, map);
+}
+
+void blendSse2(const uchar* upper, const uchar* lower, int weight, quint16* dst, int count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i upperWeight = _mm_set1_epi16(short(256 - weight));
+    const __m128i lowerWeight = _mm_set1_epi16(short(weight));
+    for (int i = 0; i < count; i += 16) {
+        const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(upper + i));
+        const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lower + i));
+        // At most 255 * 256, so the low halves of the products are whole
+        const __m128i first = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(u, zero), upperWeight),
+                                            _mm_mullo_epi16(_mm_unpacklo_epi8(l, zero), lowerWeight));
+        const __m128i second = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(u, zero), upperWeight),
+                                             _mm_mullo_epi16(_mm_unpackhi_epi8(l, zero), lowerWeight));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), first);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), second);
+    }
+}
+
+#endif // THERMAL_SSE2
+
+#if defined(THERMAL_AVX2)
+
+THERMAL_AVX2_TARGET
+void mapRowAvx2(const quint16* src, uchar* dst, int count, const WindowMap& map) {
+    const __m256i low = _mm256_set1_epi16(short(map.low));
+    const __m256i span = _mm256_set1_epi16(short(map.span));
+    const __m256i multiplier = _mm256_set1_epi16(short(map.multiplier));
+    const __m128i shift = _mm_cvtsi32_si128(map.shift);
+    const __m256i flip = _mm256_set1_epi8(char(map.flip));
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_subs_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), low);
+        __m256i b = _mm256_subs_epu16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16)), low);
+        a = _mm256_mulhi_epu16(_mm256_sll_epi16(_mm256_min_epu16(a, span), shift), multiplier);
+        b = _mm256_mulhi_epu16(_mm256_sll_epi16(_mm256_min_epu16(b, span), shift), multiplier);
+        // The pack works per 128-bit lane; put the quarters back in order
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(packed, flip));
+    }
+    mapRun(src, dst, i, count, map);
+}
+
+THERMAL_AVX2_TARGET
+void blendAvx2(const uchar* upper, const uchar* lower, int weight, quint16* dst, int count) {
+    const __m256i upperWeight = _mm256_set1_epi16(short(256 - weight));
+    const __m256i lowerWeight = _mm256_set1_epi16(short(weight));
+    for (int i = 0; i < count; i += 16) {
+        const __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(upper + i)));
+        const __m256i l = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lower + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_add_epi16(_mm256_mullo_epi16(u, upperWeight),
+                                             _mm256_mullo_epi16(l, lowerWeight)));
+    }
+}
+
+#endif // THERMAL_AVX2
+
+#if defined(THERMAL_NEON)
+
+void mapRowNeon(const quint16* src, uchar* dst, int count, const WindowMap& map) {
+    const uint16x8_t low = vdupq_n_u16(map.low);
+    const uint16x8_t span = vdupq_n_u16(map.span);
+    const uint16x8_t multiplier = vdupq_n_u16(map.multiplier);
+    const int16x8_t shift = vdupq_n_s16(int16_t(map.shift));
+    const uint8x16_t flip = vdupq_n_u8(map.flip);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint16x8_t a = vshlq_u16(vminq_u16(vqsubq_u16(vld1q_u16(src + i), low), span), shift);
+        uint16x8_t b = vshlq_u16(vminq_u16(vqsubq_u16(vld1q_u16(src + i + 8), low), span), shift);
+        a = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(a), vget_low_u16(multiplier)), 16),
+                         vshrn_n_u32(vmull_high_u16(a, multiplier), 16));
+        b = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(b), vget_low_u16(multiplier)), 16),
+                         vshrn_n_u32(vmull_high_u16(b, multiplier), 16));
+        vst1q_u8(dst + i, veorq_u8(vcombine_u8(vmovn_u16(a), vmovn_u16(b)), flip));
+    }
+    mapRun(src, dst, i, count, map);
+}
+
+void blendNeon(const uchar* upper, const uchar* lower, int weight, quint16* dst, int count) {
+    const uint8x8_t upperWeight = vdup_n_u8(uint8_t(256 - weight > 255 ? 0 : 256 - weight));
+    const uint8x8_t lowerWeight = vdup_n_u8(uint8_t(weight > 255 ? 0 : weight));
+    for (int i = 0; i < count; i += 8) {
+        const uint8x8_t u = vld1_u8(upper + i);
+        const uint8x8_t l = vld1_u8(lower + i);
+        uint16x8_t sum;
+        // A weight of 256 does not fit the byte multiply: that side alone, shifted
+        if (weight == 0) sum = vshll_n_u8(u, 8);
+        else if (weight == 256) sum = vshll_n_u8(l, 8);
+        else sum = vmlal_u8(vmull_u8(u, upperWeight), l, lowerWeight);
+        vst1q_u16(dst + i, sum);
+    }
+}
+
+#endif // THERMAL_NEON
+
+struct Kernels {
+    MapRowFn mapRow = mapRowScalar;
+    BlendFn blend = blendScalar;
+    const char* name = "scalar";
+
+    Kernels() {
+#if defined(THERMAL_AVX2)
+        if (__builtin_cpu_supports("avx2")) {
+            mapRow = mapRowAvx2;
+            blend = blendAvx2;
+            name = "avx2";
+            return;
+        }
+#endif
+#if defined(THERMAL_SSE2)
+        mapRow = mapRowSse2;
+        blend = blendSse2;
+        name = "sse2";
+#elif defined(THERMAL_NEON)
+        mapRow = mapRowNeon;
+        blend = blendNeon;
+        name = "neon";
+#endif
+    }
+};
+
+const Kernels& kernels() {
+    static const Kernels chosen;
+    return chosen;
+}
+
+struct PaletteStop {
+    double at;
+    int r, g, b;
+};
+
+const PaletteStop IRONBOW[] = {
+    {0.00, 0, 0, 0}, {0.15, 30, 0, 110}, {0.35, 150, 0, 150}, {0.55, 225, 55, 30},
+    {0.75, 255, 155, 0}, {0.90, 255, 225, 80}, {1.00, 255, 255, 255},
+};
+
+const PaletteStop RAINBOW[] = {
+    {0.00, 0, 0, 150}, {0.25, 0, 150, 255}, {0.50, 0, 210, 60},
+    {0.75, 255, 220, 0}, {1.00, 255, 30, 0},
+};
+
+template <int N>
+void fillPalette(QVector<quint32>& palette, const PaletteStop (&stops)[N]) {
+    palette.resize(256);
+    int stop = 0;
+    for (int level = 0; level < 256; ++level) {
+        const double t = level / 255.0;
+        while (stop < N - 2 && t > stops[stop + 1].at) ++stop;
+        const PaletteStop& a = stops[stop];
+        const PaletteStop& b = stops[stop + 1];
+        const double f = qBound(0.0, (t - a.at) / (b.at - a.at), 1.0);
+        const int r = qRound(a.r + (b.r - a.r) * f);
+        const int g = qRound(a.g + (b.g - a.g) * f);
+        const int bl = qRound(a.b + (b.b - a.b) * f);
+        palette[level] = 0xff000000u | quint32(r) << 16 | quint32(g) << 8 | quint32(bl);
+    }
+}
+
+} // namespace
+
+ThermalProcessor::ThermalProcessor(const ThermalConfig& config) {
+    setConfig(config);
+}
+
+void ThermalProcessor::setConfig(const ThermalConfig& config) {
+    m_config = config;
+    m_config.bitDepth = qBound(8, m_config.bitDepth, 16);
+    m_config.tiles = qBound(1, m_config.tiles, 32);
+    m_layoutSize = QSize();
+    buildPalette();
+}
+
+void ThermalProcessor::reset() {
+    m_windowValid = false;
+}
+
+const char* ThermalProcessor::instructionSet() {
+    return kernels().name;
+}
+
+void ThermalProcessor::buildPalette() {
+    switch (m_config.palette) {
+    case ThermalPalette::Ironbow:
+        fillPalette(m_palette, IRONBOW);
+        break;
+    case ThermalPalette::Rainbow:
+        fillPalette(m_palette, RAINBOW);
+        break;
+    default:
+        m_palette.clear();
+        break;
+    }
+}
+
+VideoFrame ThermalProcessor::process(const quint16* raw, int stride, const QSize& size, FramePool* pool) {
+    if (!raw || size.isEmpty()) return VideoFrame();
+    QElapsedTimer timer;
+    timer.start();
+
+    updateWindow(raw, stride, size);
+    const bool colour = !m_palette.isEmpty();
+    const uchar flip = m_config.palette == ThermalPalette::BlackHot ? 0xff : 0;
+
+    VideoFrame frame = VideoFrame::allocate(colour ? VideoPixelFormat::RGB32 : VideoPixelFormat::YUV420P,
+                                            size, pool);
+    if (frame.isNull()) return frame;
+
+    // Grey palettes are the luma plane itself
+    uchar* grey = frame.bits(0);
+    int greyStride = frame.bytesPerLine(0);
+    if (colour) {
+        m_grey.resize(size.width() * size.height());
+        grey = m_grey.data();
+        greyStride = size.width();
+    }
+
+    mapWindow(raw, stride, size, grey, greyStride, m_config.localContrast ? 0 : flip);
+    if (m_config.localContrast) equalize(grey, greyStride, size, flip);
+
+    if (colour) {
+        const quint32* palette = m_palette.constData();
+        for (int y = 0; y < size.height(); ++y) {
+            const uchar* in = grey + y * greyStride;
+            quint32* out = reinterpret_cast<quint32*>(frame.bits(0) + y * frame.bytesPerLine(0));
+            for (int x = 0; x < size.width(); ++x) out[x] = palette[in[x]];
+        }
+    } else {
+        std::memset(frame.bits(1), 128, frame.planeSize(1).height() * frame.bytesPerLine(1) * 2);
+    }
+
+    m_latency.record(timer.nsecsElapsed() / 1000);
+    return frame;
+}
+
+void ThermalProcessor::updateWindow(const quint16* raw, int stride, const QSize& size) {
+    // Every second sample of every second row is plenty for the tails;
+    // four interleaved histograms keep neighbouring samples off each
+    // other's counters
+    const int shift = qMax(0, m_config.bitDepth - AGC_BIN_BITS);
+    const int bins = 1 << (m_config.bitDepth - shift);
+    m_histogram.fill(0, 4 * bins);
+    quint32* h = m_histogram.data();
+    const int top = bins - 1;
+    const int width = size.width();
+    quint32 total = 0;
+    for (int y = 0; y < size.height(); y += 2) {
+        const quint16* row = reinterpret_cast<const quint16*>(reinterpret_cast<const uchar*>(raw) + y * stride);
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            ++h[qMin(row[x] >> shift, top)];
+            ++h[bins + qMin(row[x + 2] >> shift, top)];
+            ++h[2 * bins + qMin(row[x + 4] >> shift, top)];
+            ++h[3 * bins + qMin(row[x + 6] >> shift, top)];
+        }
+        for (; x < width; x += 2) ++h[qMin(row[x] >> shift, top)];
+        total += quint32((width + 1) / 2);
+    }
+    for (int bin = 0; bin < bins; ++bin) h[bin] += h[bins + bin] + h[2 * bins + bin] + h[3 * bins + bin];
+
+    const double lowCount = total * qBound(0.0, m_config.clipLowPercent, 50.0) / 100.0;
+    const double highCount = total * (1.0 - qBound(0.0, m_config.clipHighPercent, 50.0) / 100.0);
+    int lowBin = 0;
+    int highBin = top;
+    quint64 cumulative = 0;
+    bool lowFound = false;
+    for (int bin = 0; bin < bins; ++bin) {
+        cumulative += h[bin];
+        if (!lowFound && cumulative > lowCount) {
+            lowBin = bin;
+            lowFound = true;
+        }
+        if (cumulative >= highCount) {
+            highBin = bin;
+            break;
+        }
+    }
+
+    double low = double(lowBin << shift);
+    double high = double(((highBin + 1) << shift) - 1);
+    const double maxValue = double((1 << m_config.bitDepth) - 1);
+    const double minSpan = qBound(1.0, double(m_config.minSpan), maxValue);
+    if (high - low < minSpan) {
+        const double centre = (low + high) / 2.0;
+        low = qBound(0.0, centre - minSpan / 2.0, maxValue - minSpan);
+        high = low + minSpan;
+    }
+
+    if (!m_windowValid) {
+        m_low = low;
+        m_high = high;
+        m_windowValid = true;
+    } else {
+        const double step = qBound(0.0, m_config.agcSmoothing, 1.0);
+        m_low += (low - m_low) * step;
+        m_high += (high - m_high) * step;
+    }
+}
+
+void ThermalProcessor::mapWindow(const quint16* raw, int stride, const QSize& size,
+                                 uchar* out, int outStride, uchar flip) {
+    WindowMap map;
+    map.low = quint16(qBound(0, qRound(m_low), 65535));
+    map.span = quint16(qBound(1, qRound(m_high) - int(map.low), 65535 - int(map.low)));
+    while ((int(map.span) << (map.shift + 1)) <= 65535) ++map.shift;
+    map.multiplier = quint16((255u * 65536u) / (quint32(map.span) << map.shift));
+    map.flip = flip;
+
+    const MapRowFn mapRow = kernels().mapRow;
+    for (int y = 0; y < size.height(); ++y) {
+        const quint16* row = reinterpret_cast<const quint16*>(reinterpret_cast<const uchar*>(raw) + y * stride);
+        mapRow(row, out + y * outStride, size.width(), map);
+    }
+}
+
+void ThermalProcessor::layoutTiles(const QSize& size) {
+    // No tile narrower than 8 pixels, and none left empty by rounding
+    const int across = qMin(m_config.tiles, qMax(1, size.width() / 8));
+    const int down = qMin(m_config.tiles, qMax(1, size.height() / 8));
+    m_tileWidth = (size.width() + across - 1) / across;
+    m_tileHeight = (size.height() + down - 1) / down;
+    m_tilesX = (size.width() + m_tileWidth - 1) / m_tileWidth;
+    m_tilesY = (size.height() + m_tileHeight - 1) / m_tileHeight;
+
+    // Each column's level blends the mappings of the two nearest tile centres
+    m_columnWeight.resize(size.width());
+    m_columnRuns.clear();
+    for (int x = 0; x < size.width(); ++x) {
+        const double f = (x + 0.5) / m_tileWidth - 0.5;
+        const int left = qBound(0, int(std::floor(f)), m_tilesX - 1);
+        const int right = qMin(left + 1, m_tilesX - 1);
+        m_columnWeight[x] = right == left ? 0 : qBound(0, qRound((f - left) * 256.0), 256);
+        if (m_columnRuns.isEmpty() || m_columnRuns.last().left != left * 256
+            || m_columnRuns.last().right != right * 256) {
+            m_columnRuns.append(ColumnRun{x, x, left * 256, right * 256});
+        }
+        m_columnRuns.last().end = x + 1;
+    }
+    m_tileHistograms.resize(m_tilesX * m_tilesY * 256);
+    m_tileLevels.resize(m_tilesX * m_tilesY * 256);
+    m_layoutSize = size;
+}
+
+void ThermalProcessor::equalize(uchar* image, int stride, const QSize& size, uchar flip) {
+    if (size != m_layoutSize) layoutTiles(size);
+    const int width = size.width();
+    const int height = size.height();
+
+    // Tile statistics from every second sample of every second row
+    m_tileHistograms.fill(0);
+    for (int y = 0; y < height; y += 2) {
+        const uchar* row = image + y * stride;
+        int* tileRow = m_tileHistograms.data() + (y / m_tileHeight) * m_tilesX * 256;
+        for (int tx = 0; tx < m_tilesX; ++tx) {
+            int* histogram = tileRow + tx * 256;
+            const int end = qMin(width, (tx + 1) * m_tileWidth);
+            for (int x = tx * m_tileWidth; x < end; x += 2) ++histogram[row[x]];
+        }
+    }
+
+    // Clip each tile's histogram, share out the excess, and map by its sum
+    for (int tile = 0; tile < m_tilesX * m_tilesY; ++tile) {
+        int* histogram = m_tileHistograms.data() + tile * 256;
+        uchar* levels = m_tileLevels.data() + tile * 256;
+        int samples = 0;
+        for (int level = 0; level < 256; ++level) samples += histogram[level];
+        if (samples == 0) continue;
+
+        const int limit = qMax(1, int(m_config.clipLimit * samples / 256.0));
+        int excess = 0;
+        for (int level = 0; level < 256; ++level) {
+            if (histogram[level] > limit) {
+                excess += histogram[level] - limit;
+                histogram[level] = limit;
+            }
+        }
+        const int each = excess / 256;
+        const int remainder = excess % 256;
+        const int every = remainder > 0 ? 256 / remainder : 0;
+        int sum = 0;
+        for (int level = 0; level < 256; ++level) {
+            sum += histogram[level] + each;
+            if (every && level % every == 0 && level / every < remainder) ++sum;
+            levels[level] = uchar(((sum * 255 + samples / 2) / samples) ^ flip);
+        }
+    }
+
+    // Per row, the two nearest tile rows' mappings are blended once, over
+    // 256 levels per tile column; each pixel then blends two columns
+    const int rowLength = m_tilesX * 256;
+    m_rowLevels.resize(rowLength);
+    quint16* blended = m_rowLevels.data();
+    const int* columnWeight = m_columnWeight.constData();
+    const BlendFn blend = kernels().blend;
+    for (int y = 0; y < height; ++y) {
+        const double f = (y + 0.5) / m_tileHeight - 0.5;
+        const int top = qBound(0, int(std::floor(f)), m_tilesY - 1);
+        const int bottom = qMin(top + 1, m_tilesY - 1);
+        const int wy = bottom == top ? 0 : qBound(0, qRound((f - top) * 256.0), 256);
+        const uchar* upper = m_tileLevels.constData() + top * rowLength;
+        const uchar* lower = m_tileLevels.constData() + bottom * rowLength;
+        blend(upper, lower, wy, blended, rowLength);
+
+        // Runs of columns between the same two tile centres share both tables
+        uchar* row = image + y * stride;
+        for (const ColumnRun& run : m_columnRuns) {
+            const quint16* left = blended + run.left;
+            const quint16* right = blended + run.right;
+            const int end = run.end;
+            for (int x = run.start; x < end; ++x) {
+                const int v = row[x];
+                const int wx = columnWeight[x];
+                row[x] = uchar((left[v] * (256 - wx) + right[v] * wx + 32768) >> 16);
+            }
+        }
+    }
+}
+
+} // namespace CounterUAS
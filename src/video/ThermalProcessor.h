@@ -0,0 +1,108 @@
+#ifndef THERMALPROCESSOR_H
+#define THERMALPROCESSOR_H
+
+#include <QVector>
+#include "utils/LatencyStats.h"
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+class FramePool;
+
+/**
+ * @brief How 8-bit display levels are coloured
+ */
+enum class ThermalPalette {
+    WhiteHot,       // YUV420P, neutral chroma
+    BlackHot,       // YUV420P, neutral chroma
+    Ironbow,        // RGB32
+    Rainbow         // RGB32
+};
+
+/**
+ * @brief Display mapping of a radiometric thermal stream
+ */
+struct ThermalConfig {
+    int bitDepth = 14;              // Significant bits of each sample
+    double clipLowPercent = 1.0;    // Histogram tails the AGC ignores
+    double clipHighPercent = 0.5;
+    double agcSmoothing = 0.1;      // Per-frame step of the AGC window; 1 for none
+    int minSpan = 64;               // Counts; a flat scene is not stretched into noise
+    bool localContrast = true;      // CLAHE after the AGC
+    int tiles = 8;                  // CLAHE grid, tiles by tiles
+    double clipLimit = 2.5;         // Of the mean bin count per tile
+    ThermalPalette palette = ThermalPalette::WhiteHot;
+};
+
+/**
+ * @brief 16-bit radiometric frames to display frames
+ *
+ * A global histogram AGC finds the window between the clipped tails of
+ * each frame's histogram (a quarter of the samples, in at most 4096 bins)
+ * and eases toward it, so a hot target entering the view does
+ * not make the scene pump. Samples are mapped through the window to 8
+ * bits by a vector kernel, selected at run time like MotionKernels'.
+ * Local contrast is then a CLAHE pass: clip-limited histograms per tile,
+ * with each pixel's level interpolated between the four nearest tiles'
+ * mappings, the vertical half of it once per row for all levels. Grey
+ * palettes fill the luma plane of a YUV420P frame, as Mono8 cameras do;
+ * colour palettes go through a 256-entry LUT to RGB32.
+ *
+ * No conversion through QImage; one processor per stream, called from
+ * the thread that receives the stream's frames.
+ */
+class ThermalProcessor {
+public:
+    explicit ThermalProcessor(const ThermalConfig& config = ThermalConfig());
+
+    void setConfig(const ThermalConfig& config);
+    ThermalConfig config() const { return m_config; }
+
+    // size samples of raw, stride bytes between rows
+    VideoFrame process(const quint16* raw, int stride, const QSize& size, FramePool* pool = nullptr);
+    void reset();                   // AGC window starts over
+
+    int windowLow() const { return qRound(m_low); }
+    int windowHigh() const { return qRound(m_high); }
+    const LatencyStats& latency() const { return m_latency; }
+
+    static const char* instructionSet();
+
+private:
+    struct ColumnRun {
+        int start = 0;
+        int end = 0;
+        int left = 0;               // Tiles either side, by 256 levels
+        int right = 0;
+    };
+
+    void updateWindow(const quint16* raw, int stride, const QSize& size);
+    void mapWindow(const quint16* raw, int stride, const QSize& size, uchar* out, int outStride, uchar flip);
+    void layoutTiles(const QSize& size);
+    void equalize(uchar* image, int stride, const QSize& size, uchar flip);
+    void buildPalette();
+
+    ThermalConfig m_config;
+    double m_low = 0.0;
+    double m_high = 0.0;
+    bool m_windowValid = false;
+
+    QVector<quint32> m_histogram;   // AGC bins
+    QVector<int> m_tileHistograms;  // 256 per tile
+    QVector<uchar> m_tileLevels;    // 256 per tile
+    QVector<quint16> m_rowLevels;   // One row's blend of two tile rows
+    QVector<ColumnRun> m_columnRuns;
+    QVector<int> m_columnWeight;    // Of the right tile, out of 256
+    QSize m_layoutSize;             // Frame size the tile layout is for
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    int m_tileWidth = 0;
+    int m_tileHeight = 0;
+    QVector<uchar> m_grey;          // Before a colour palette
+    QVector<quint32> m_palette;
+    LatencyStats m_latency;
+};
+
+} // namespace CounterUAS
+
+#endif // THERMALPROCESSOR_H
@@ -0,0 +1,118 @@
+#include "video/TrackVideoIndex.h"
+#include "video/VideoStreamManager.h"
+#include "core/TrackManager.h"
+#include <QFileInfo>
+#include <QTimer>
+
+namespace CounterUAS {
+
+TrackVideoIndex::TrackVideoIndex(QObject* parent)
+    : QObject(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setInterval(m_config.flushIntervalMs);
+    connect(m_flushTimer, &QTimer::timeout, this, [this]() { flush(); });
+    m_flushTimer->start();
+}
+
+TrackVideoIndex::~TrackVideoIndex() {
+    flush(true);
+}
+
+void TrackVideoIndex::setConfig(const TrackVideoIndexConfig& config) {
+    m_config = config;
+    m_flushTimer->setInterval(qMax(1, config.flushIntervalMs));
+}
+
+void TrackVideoIndex::setTrackManager(TrackManager* trackManager) {
+    if (m_trackManager) {
+        disconnect(m_trackManager, nullptr, this, nullptr);
+    }
+    m_trackManager = trackManager;
+    if (m_trackManager) {
+        connect(m_trackManager, &TrackManager::snapshotPublished, this, [this]() {
+            if (m_trackManager) update(*m_trackManager->snapshot());
+        });
+    }
+}
+
+void TrackVideoIndex::setVideoManager(VideoStreamManager* manager) {
+    m_positions = [manager](const QString& cameraId) { return manager->recordingPosition(cameraId); };
+}
+
+bool TrackVideoIndex::seen(const TrackSnapshot& track, qint64 nowMs) const {
+    if (!track.visuallyTracked || track.associatedCameraId.isEmpty()) return false;
+    if (track.state == TrackState::Dropped) return false;
+    // An operator's association has no box; the camera was put on the track
+    return track.boxTimestampMs == 0 || nowMs - track.boxTimestampMs <= m_config.maxBoxAgeMs;
+}
+
+void TrackVideoIndex::update(const TrackPicture& picture) {
+    if (!m_positions) return;
+    const qint64 now = picture.timestampMs;
+
+    // One position per camera and picture
+    m_pictureCameras.clear();
+    for (const TrackSnapshot& track : picture.tracks) {
+        if (!seen(track, now)) continue;
+
+        auto camera = m_pictureCameras.find(track.associatedCameraId);
+        if (camera == m_pictureCameras.end()) {
+            camera = m_pictureCameras.insert(track.associatedCameraId, m_positions(track.associatedCameraId));
+        }
+        const RecordingPosition& position = camera.value();
+        if (!position.isValid()) continue;
+
+        auto it = m_open.find(track.handle);
+        if (it != m_open.end() &&
+            (it->cameraId != track.associatedCameraId || it->path != position.segmentPath ||
+             now - it->endMs > m_config.gapMs || now - it->startMs >= m_config.maxSightingMs)) {
+            m_closed.append(it.value());
+            m_open.erase(it);
+            it = m_open.end();
+        }
+        if (it == m_open.end()) {
+            VideoSighting sighting;
+            sighting.trackId = track.trackId;
+            sighting.cameraId = track.associatedCameraId;
+            sighting.startMs = now;
+            sighting.path = position.segmentPath;
+            sighting.clipId = QFileInfo(position.segmentPath).completeBaseName();
+            sighting.byteOffset = position.byteOffset;
+            sighting.offsetTimeMs = position.timeMs;
+            it = m_open.insert(track.handle, sighting);
+        }
+        it->endMs = now;
+    }
+
+    // Gone from view, or from the picture
+    for (auto it = m_open.begin(); it != m_open.end();) {
+        if (now - it->endMs > m_config.gapMs) {
+            m_closed.append(it.value());
+            it = m_open.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TrackVideoIndex::flush(bool closeOpen) {
+    if (closeOpen) {
+        for (const VideoSighting& open : qAsConst(m_open)) m_closed.append(open);
+        m_open.clear();
+    }
+    if (m_closed.isEmpty()) return;
+    const QVector<VideoSighting> closed = m_closed;
+    m_closed.clear();
+    emit sightingsClosed(closed);
+}
+
+QVector<VideoSighting> TrackVideoIndex::sightingsForTrack(const QString& trackId) const {
+    QVector<VideoSighting> sightings;
+    for (const VideoSighting& open : m_open) {
+        if (open.trackId == trackId) sightings.append(open);
+    }
+    return sightings;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,87 @@
+#ifndef TRACKVIDEOINDEX_H
+#define TRACKVIDEOINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <functional>
+#include "core/TrackSnapshot.h"
+#include "video/VideoRecorder.h"
+
+class QTimer;
+
+namespace CounterUAS {
+
+class TrackManager;
+class VideoStreamManager;
+
+/**
+ * @brief When a track counts as seen, and how sightings are cut
+ */
+struct TrackVideoIndexConfig {
+    qint64 maxBoxAgeMs = 2000;          // A camera box older than this no longer counts
+    qint64 gapMs = 3000;                // Shorter gaps within a sighting are bridged
+    qint64 maxSightingMs = 10 * 60 * 1000;  // Longer sightings are split; at most DatabaseManager::MAX_SIGHTING_MS
+    int flushIntervalMs = 5000;         // Closed sightings are handed on at this rate
+};
+
+/**
+ * @brief Which recorded segments show each track, built as recording happens
+ *
+ * Once a track picture, every track a camera sees (visually tracked on its
+ * associated camera, with a recent box or none at all) extends its open
+ * sighting on that camera, which points at the segment being recorded and
+ * at the segment's latest keyframe cluster, where playback of the sighting
+ * can start. A sighting closes when the track has not been seen for gapMs,
+ * moves to another camera, or its camera rolls over to a new segment; one
+ * that reaches maxSightingMs is closed and a new one opened, which bounds
+ * how far before a window a query must look. Cameras not recording here
+ * give no sightings.
+ *
+ * Closed sightings are batched into sightingsClosed, for DatabaseManager to
+ * store; sightingsForTrack() gives the open ones. Lives on the GUI thread.
+ */
+class TrackVideoIndex : public QObject {
+    Q_OBJECT
+
+public:
+    // The camera's recording now
+    using PositionSource = std::function<RecordingPosition(const QString& cameraId)>;
+
+    explicit TrackVideoIndex(QObject* parent = nullptr);
+    ~TrackVideoIndex() override;   // Flushes the open sightings
+
+    void setConfig(const TrackVideoIndexConfig& config);
+    TrackVideoIndexConfig config() const { return m_config; }
+
+    void setTrackManager(TrackManager* trackManager);   // Each published picture
+    void setVideoManager(VideoStreamManager* manager);  // Its recordings' positions
+    void setPositionSource(const PositionSource& source) { m_positions = source; }
+
+    void update(const TrackPicture& picture);
+
+    // Hands on everything closed since the last flush; with closeOpen,
+    // every open sighting too, ended at its last sight
+    void flush(bool closeOpen = false);
+
+    QVector<VideoSighting> sightingsForTrack(const QString& trackId) const;   // Open ones
+    int openCount() const { return m_open.size(); }
+
+signals:
+    void sightingsClosed(const QVector<VideoSighting>& sightings);
+
+private:
+    bool seen(const TrackSnapshot& track, qint64 nowMs) const;
+
+    TrackVideoIndexConfig m_config;
+    TrackManager* m_trackManager = nullptr;
+    PositionSource m_positions;
+    QHash<TrackHandle, VideoSighting> m_open;   // endMs is the last sight
+    QVector<VideoSighting> m_closed;
+    QHash<QString, RecordingPosition> m_pictureCameras;   // update() scratch
+    QTimer* m_flushTimer = nullptr;
+};
+
+} // namespace CounterUAS
+
+#endif // TRACKVIDEOINDEX_H
@@ -1,11 +1,62 @@
 #include "video/VideoDecoder.h"
+#include "video/VideoDecoderBackend.h"
 #include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/TimeUtils.h"
 
 namespace CounterUAS {
 
+namespace {
+
+enum CodecFamily : quint8 { NotParsed = 0, H264, H265, StillImage };
+
+quint8 codecFamily(const QString& codecName) {
+    const QString codec = codecName.toUpper();
+    if (codec == QLatin1String("H264") || codec == QLatin1String("AVC")) return H264;
+    if (codec == QLatin1String("H265") || codec == QLatin1String("HEVC")) return H265;
+    if (codec == QLatin1String("MJPEG") || codec == QLatin1String("JPEG") ||
+        codec == QLatin1String("PNG")) return StillImage;
+    return NotParsed;
+}
+
+VideoPacketType packetType(quint8 family, const QByteArray& packet) {
+    if (family == StillImage) return VideoPacketType::Keyframe;
+    
+    // The first slice NAL unit after an Annex B start code decides
+    const uchar* p = reinterpret_cast<const uchar*>(packet.constData());
+    const int n = packet.size();
+    for (int i = 0; i + 3 < n; ++i) {
+        if (p[i] != 0 || p[i + 1] != 0 || p[i + 2] != 1) continue;
+        const uchar header = p[i + 3];
+        if (family == H264) {
+            const int nalType = header & 0x1f;
+            if (nalType == 5) return VideoPacketType::Keyframe;
+            if (nalType >= 1 && nalType <= 4) {
+                return (header & 0x60) ? VideoPacketType::Reference : VideoPacketType::NonReference;
+            }
+        } else {
+            const int nalType = (header >> 1) & 0x3f;
+            if (nalType >= 16 && nalType <= 23) return VideoPacketType::Keyframe;
+            if (nalType <= 31) {
+                // TRAIL_N, TSA_N, STSA_N, RADL_N, RASL_N and the reserved _N types
+                return nalType <= 14 && nalType % 2 == 0 ? VideoPacketType::NonReference
+                                                         : VideoPacketType::Reference;
+            }
+        }
+        i += 2;
+    }
+    return VideoPacketType::Reference;    // No slice; decoded, as something may need it
+}
+
+} // namespace
+
+std::atomic<int> VideoDecoder::s_queuedPackets{0};
+
 VideoDecoder::VideoDecoder(QObject* parent)
     : QObject(parent)
 {
+    qRegisterMetaType<VideoFrame>("VideoFrame");
 }
 
 VideoDecoder::~VideoDecoder() {
@@ -13,12 +64,41 @@ VideoDecoder::~VideoDecoder() {
 }
 
 bool VideoDecoder::initialize(const QString& codecName) {
+    shutdown();
     m_codecName = codecName;
+    m_codecFamily = codecFamily(codecName);
+    
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_awaitKeyframe = false;
+        m_submitted = 0;
+        m_skippedNonReference = 0;
+        m_skippedNonKey = 0;
+        m_skippedBacklog = 0;
+    }
+    {
+        QMutexLocker locker(&m_backendMutex);
+        m_stats = VideoDecodeStats();
+        m_consecutiveFailures = 0;
+        if (!openBackend(m_hwAccel)) {
+            locker.unlock();
+            emit error("No decoder backend for codec " + codecName);
+            return false;
+        }
+    }
     
-    // In a real implementation, this would initialize FFmpeg/GStreamer decoder
+    m_stopping = false;
+    m_worker = QThread::create([this]() { workerLoop(); });
+    ThreadPlacement::instance().assign(m_worker, ThreadRole::VideoDecode);
+    m_worker->start();
     
     m_initialized = true;
-    Logger::instance().info("VideoDecoder", "Initialized codec: " + codecName);
+    const VideoDecodeStats current = stats();
+    Logger::instance().info("VideoDecoder",
+                            QString("Initialized codec %1 on %2 (%3)")
+                                .arg(codecName, current.backend,
+                                     current.hardware ? "hardware" : "software"));
+    emit backendChanged(current.backend, current.hardware);
     
     return true;
 }
@@ -26,15 +106,44 @@ bool VideoDecoder::initialize(const QString& codecName) {
 void VideoDecoder::shutdown() {
     if (!m_initialized) return;
     
-    // Clean up decoder resources
+    stopWorker();
+    {
+        QMutexLocker locker(&m_backendMutex);
+        if (m_backend) m_backend->close();
+        m_backend.reset();
+    }
+    m_surfaces.trim();
     
     m_initialized = false;
     Logger::instance().info("VideoDecoder", "Shutdown");
 }
 
 void VideoDecoder::setHardwareAcceleration(bool enable) {
+    // Takes effect at the next initialize()
     m_hwAccel = enable;
-    // Would configure HW acceleration (VA-API, NVDEC, etc.)
+}
+
+void VideoDecoder::setQueueCapacity(int packets) {
+    QMutexLocker locker(&m_queueMutex);
+    m_queueCapacity = qMax(1, packets);
+}
+
+void VideoDecoder::setDecodeMode(VideoDecodeMode mode) {
+    QMutexLocker locker(&m_queueMutex);
+    m_mode = mode;
+}
+
+VideoDecodeMode VideoDecoder::decodeMode() const {
+    QMutexLocker locker(&m_queueMutex);
+    return m_mode;
+}
+
+bool VideoDecoder::classifyPacket(const QString& codecName, const QByteArray& packet,
+                                  VideoPacketType& type) {
+    const quint8 family = codecFamily(codecName);
+    if (family == NotParsed) return false;
+    type = packetType(family, packet);
+    return true;
 }
 
 QImage VideoDecoder::decode(const QByteArray& encodedData) {
@@ -43,14 +152,203 @@ QImage VideoDecoder::decode(const QByteArray& encodedData) {
         return QImage();
     }
     
-    // In a real implementation, decode the frame data
-    // For simulation, just return empty image
+    const qint64 startNs = TimeUtils::monotonicNs();
+    VideoFrame frame;
+    {
+        QMutexLocker locker(&m_backendMutex);
+        if (!decodeLocked(encodedData, frame)) return QImage();
+        if (!frame.isNull()) m_stats.latency.record((TimeUtils::monotonicNs() - startNs) / 1000);
+    }
+    
+    QImage image = frame.toImage();
+    emit frameDecoded(image);
+    return image;
+}
+
+bool VideoDecoder::submit(const QByteArray& packet, qint64 timestamp) {
+    if (!m_initialized) return false;
     
-    Q_UNUSED(encodedData)
+    Packet p;
+    p.data = packet;
+    p.timestamp = timestamp;
+    p.submittedNs = TimeUtils::monotonicNs();
+    if (m_codecFamily != NotParsed) p.type = packetType(m_codecFamily, packet);
     
-    QImage frame;
-    emit frameDecoded(frame);
-    return frame;
+    int dropped = 0;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        ++m_submitted;
+        if (skipOnSubmitLocked(p)) return true;
+        while (m_queue.size() >= m_queueCapacity) {
+            m_queue.dequeue();
+            ++dropped;
+        }
+        m_queue.enqueue(p);
+        s_queuedPackets.fetch_add(1 - dropped, std::memory_order_relaxed);
+    }
+    m_queueNotEmpty.wakeOne();
+    
+    if (dropped > 0) {
+        QMutexLocker locker(&m_backendMutex);
+        m_stats.dropped += dropped;
+    }
+    return true;
+}
+
+VideoDecodeStats VideoDecoder::stats() const {
+    VideoDecodeStats stats;
+    {
+        QMutexLocker locker(&m_backendMutex);
+        stats = m_stats;
+    }
+    QMutexLocker locker(&m_queueMutex);
+    stats.queueDepth = m_queue.size();
+    stats.mode = m_mode;
+    stats.submitted = m_submitted;
+    stats.skippedNonReference = m_skippedNonReference;
+    stats.skippedNonKey = m_skippedNonKey;
+    stats.skippedBacklog = m_skippedBacklog;
+    return stats;
+}
+
+bool VideoDecoder::skipOnSubmitLocked(const Packet& packet) {
+    if (m_codecFamily == NotParsed) return false;
+    
+    if (packet.type == VideoPacketType::Keyframe) {
+        m_awaitKeyframe = false;
+        return false;
+    }
+    if (packet.type == VideoPacketType::NonReference && m_mode >= VideoDecodeMode::SkipNonReference) {
+        ++m_skippedNonReference;
+        return true;
+    }
+    if (m_awaitKeyframe || m_mode == VideoDecodeMode::KeyframesOnly) {
+        // Everything up to the next keyframe may predict from what is skipped
+        m_awaitKeyframe = true;
+        ++m_skippedNonKey;
+        return true;
+    }
+    return false;
+}
+
+VideoDecoder::Packet VideoDecoder::takeLocked() {
+    const int depth = m_queue.size();
+    if (m_codecFamily != NotParsed && m_mode >= VideoDecodeMode::Newest) {
+        // Nothing ahead of a newer keyframe is needed to show it
+        for (int i = m_queue.size() - 1; i > 0; --i) {
+            if (m_queue.at(i).type != VideoPacketType::Keyframe) continue;
+            m_queue.erase(m_queue.begin(), m_queue.begin() + i);
+            m_skippedBacklog += static_cast<quint64>(i);
+            break;
+        }
+        while (m_queue.size() > 1 && m_queue.head().type == VideoPacketType::NonReference) {
+            m_queue.dequeue();
+            ++m_skippedNonReference;
+        }
+    }
+    Packet packet = m_queue.dequeue();
+    s_queuedPackets.fetch_sub(depth - m_queue.size(), std::memory_order_relaxed);
+    return packet;
+}
+
+bool VideoDecoder::openBackend(bool allowHardware) {
+    QStringList names = VideoDecoderRegistry::candidates(allowHardware);
+    if (!m_preferredBackend.isEmpty() && names.contains(m_preferredBackend)) {
+        names.removeAll(m_preferredBackend);
+        names.prepend(m_preferredBackend);
+    }
+    
+    for (const QString& name : names) {
+        std::unique_ptr<VideoDecoderBackend> backend = VideoDecoderRegistry::create(name);
+        if (backend && backend->open(m_codecName, &m_surfaces)) {
+            m_backend = std::move(backend);
+            m_stats.backend = m_backend->name();
+            m_stats.hardware = m_backend->isHardware();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VideoDecoder::decodeLocked(const QByteArray& packet, VideoFrame& frame) {
+    if (!m_backend) return false;
+    
+    if (m_backend->decode(packet, frame)) {
+        m_consecutiveFailures = 0;
+        if (!frame.isNull()) ++m_stats.decoded;
+        return true;
+    }
+    
+    ++m_stats.failed;
+    if (m_backend->isHardware() && ++m_consecutiveFailures >= FALLBACK_AFTER_FAILURES) {
+        const QString failed = m_backend->name();
+        m_backend->close();
+        m_backend.reset();
+        m_consecutiveFailures = 0;
+        
+        if (openBackend(false)) {
+            ++m_stats.fallbacks;
+            Logger::instance().warning("VideoDecoder",
+                                       QString("%1 failing on %2, falling back to %3")
+                                           .arg(failed, m_codecName, m_stats.backend));
+            // Queued to the decoder's thread when raised by the worker
+            QMetaObject::invokeMethod(this, [this, backend = m_stats.backend]() {
+                emit backendChanged(backend, false);
+            }, Qt::QueuedConnection);
+        } else {
+            m_stats.backend.clear();
+            m_stats.hardware = false;
+            QMetaObject::invokeMethod(this, [this, codec = m_codecName]() {
+                emit error("No software decoder for codec " + codec);
+            }, Qt::QueuedConnection);
+        }
+    }
+    return false;
+}
+
+void VideoDecoder::workerLoop() {
+    forever {
+        Packet packet;
+        {
+            QMutexLocker locker(&m_queueMutex);
+            while (m_queue.isEmpty() && !m_stopping) {
+                m_queueNotEmpty.wait(&m_queueMutex);
+            }
+            if (m_stopping) return;
+            packet = takeLocked();
+        }
+        
+        VideoFrame frame;
+        bool ok = false;
+        const qint64 decodeStartNs = TimeUtils::monotonicNs();
+        {
+            QMutexLocker locker(&m_backendMutex);
+            ok = decodeLocked(packet.data, frame);
+            if (ok && !frame.isNull()) {
+                m_stats.latency.record((TimeUtils::monotonicNs() - packet.submittedNs) / 1000);
+            }
+        }
+        // Decode has no period of its own; only a configured deadline counts misses
+        ThreadPlacement::instance().reportCycle(ThreadRole::VideoDecode,
+                                                (TimeUtils::monotonicNs() - decodeStartNs) / 1000);
+        if (ok && !frame.isNull()) {
+            emit videoFrameDecoded(frame, packet.timestamp);
+        }
+    }
+}
+
+void VideoDecoder::stopWorker() {
+    if (!m_worker) return;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_stopping = true;
+        s_queuedPackets.fetch_sub(m_queue.size(), std::memory_order_relaxed);
+        m_queue.clear();
+    }
+    m_queueNotEmpty.wakeAll();
+    m_worker->wait();
+    delete m_worker;
+    m_worker = nullptr;
 }
 
 } // namespace CounterUAS
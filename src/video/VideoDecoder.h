@@ -3,17 +3,92 @@
 
 #include <QObject>
 #include <QImage>
+#include <QMutex>
+#include <QQueue>
 #include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+
+#include "utils/FramePool.h"
+#include "utils/LatencyStats.h"
+#include "utils/VideoFrame.h"
 
 namespace CounterUAS {
 
+class VideoDecoderBackend;
+
+/**
+ * @brief What a compressed packet is to the pictures around it
+ */
+enum class VideoPacketType : quint8 {
+    Keyframe = 0,                  // Decodes on its own: IDR, IRAP, any still image
+    Reference,                     // Later pictures may predict from it
+    NonReference                   // Nothing predicts from it
+};
+
+/**
+ * @brief What a stream's decoder leaves undecoded to keep up
+ *
+ * Each mode skips what the one before it does, and more. Only packets of
+ * codecs classifyPacket() parses are skipped; any other codec decodes
+ * everything whatever the mode.
+ */
+enum class VideoDecodeMode : quint8 {
+    All = 0,                       // Every packet; a full queue sheds its oldest
+    Newest,                        // A backlog restarts at its latest keyframe and
+                                   // drops non-reference pictures with newer ones queued
+    SkipNonReference,              // No non-reference picture is decoded
+    KeyframesOnly                  // Afterwards decoding resumes at the next keyframe
+};
+
+/**
+ * @brief Decoder counters for one stream
+ */
+struct VideoDecodeStats {
+    QString backend;               // Active backend name, empty before initialize()
+    bool hardware = false;
+    VideoDecodeMode mode = VideoDecodeMode::All;
+    quint64 submitted = 0;
+    quint64 decoded = 0;
+    quint64 failed = 0;
+    quint64 dropped = 0;           // Oldest packets shed when the queue was full
+    quint64 skippedNonReference = 0;
+    quint64 skippedNonKey = 0;     // Keyframes only, or waiting for one after it
+    quint64 skippedBacklog = 0;    // Queued ahead of a newer keyframe
+    quint64 fallbacks = 0;         // Hardware backends abandoned for software
+    int queueDepth = 0;
+    LatencyStats latency;          // Submit to decoded frame, queueing included
+    
+    quint64 skipped() const { return skippedNonReference + skippedNonKey + skippedBacklog; }
+};
+
 /**
  * @brief Video decoder for custom frame processing
+ *
+ * initialize() walks VideoDecoderRegistry in preference order, skipping
+ * hardware backends unless hardware acceleration is enabled, and keeps the
+ * first one that opens the codec. A hardware backend that fails three
+ * packets in a row is dropped for the best software one, so a lost device
+ * costs a few frames rather than the stream.
+ *
+ * submit() queues packets for a worker thread, shedding the oldest when
+ * the queue is full so a slow decoder falls behind by frames, not by
+ * seconds; the frames come back through videoFrameDecoded. decode() is
+ * the synchronous path for callers that already own a thread.
+ *
+ * Under load a stream's decode mode skips the pictures it can do without:
+ * non-reference pictures as they are submitted, everything but keyframes
+ * for a thumbnail, and, at Newest and above, a backlog the worker finds
+ * behind a newer keyframe. Nothing that a decoded picture predicts from
+ * is skipped, so what is shown is never corrupted by the skipping.
  */
 class VideoDecoder : public QObject {
     Q_OBJECT
     
 public:
+    static constexpr int FALLBACK_AFTER_FAILURES = 3;
+    
     explicit VideoDecoder(QObject* parent = nullptr);
     ~VideoDecoder() override;
     
@@ -23,16 +98,81 @@ public:
     void setHardwareAcceleration(bool enable);
     bool hardwareAcceleration() const { return m_hwAccel; }
     
+    // Tried ahead of the registry order when it opens the codec
+    void setPreferredBackend(const QString& name) { m_preferredBackend = name; }
+    QString preferredBackend() const { return m_preferredBackend; }
+    
+    void setQueueCapacity(int packets);
+    int queueCapacity() const { return m_queueCapacity; }
+    
+    // Thread-safe; from the next packet submitted
+    void setDecodeMode(VideoDecodeMode mode);
+    VideoDecodeMode decodeMode() const;
+    
     QImage decode(const QByteArray& encodedData);
     
+    // Thread-safe; false if the decoder is not initialised
+    bool submit(const QByteArray& packet, qint64 timestamp);
+    
+    VideoDecodeStats stats() const;
+    // Packets waiting across every decoder; thread-safe and never waits on one
+    static int queuedPackets() { return s_queuedPackets.load(std::memory_order_relaxed); }
+    
+    // From the NAL headers of an Annex B H.264 or H.265 access unit; every
+    // still-image packet is a keyframe. False for a codec not parsed here.
+    static bool classifyPacket(const QString& codecName, const QByteArray& packet,
+                               VideoPacketType& type);
+    
 signals:
     void frameDecoded(const QImage& frame);
+    void videoFrameDecoded(const VideoFrame& frame, qint64 timestamp);
+    void backendChanged(const QString& backend, bool hardware);
     void error(const QString& message);
     
 private:
+    struct Packet {
+        QByteArray data;
+        qint64 timestamp = 0;
+        qint64 submittedNs = 0;
+        VideoPacketType type = VideoPacketType::Reference;
+    };
+    
+    bool openBackend(bool allowHardware);
+    bool decodeLocked(const QByteArray& packet, VideoFrame& frame);
+    bool skipOnSubmitLocked(const Packet& packet);
+    Packet takeLocked();
+    void workerLoop();
+    void stopWorker();
+    
     bool m_initialized = false;
     bool m_hwAccel = false;
     QString m_codecName;
+    QString m_preferredBackend;
+    int m_queueCapacity = 8;
+    quint8 m_codecFamily = 0;      // classifyPacket()'s parser for the codec; 0 for none
+    
+    FramePool m_surfaces;
+    
+    // Guards the backend and the stats; the worker decodes under it
+    mutable QMutex m_backendMutex;
+    std::unique_ptr<VideoDecoderBackend> m_backend;
+    int m_consecutiveFailures = 0;
+    VideoDecodeStats m_stats;
+    
+    mutable QMutex m_queueMutex;
+    QWaitCondition m_queueNotEmpty;
+    QQueue<Packet> m_queue;
+    VideoDecodeMode m_mode = VideoDecodeMode::All;
+    bool m_awaitKeyframe = false;  // A reference picture was skipped
+    // Kept here rather than in m_stats, so submit() never waits on a decode
+    quint64 m_submitted = 0;
+    quint64 m_skippedNonReference = 0;
+    quint64 m_skippedNonKey = 0;
+    quint64 m_skippedBacklog = 0;
+    bool m_stopping = false;
+    QThread* m_worker = nullptr;
+    
+    static std::atomic<int> s_queuedPackets;
 };
 
 } // namespace CounterUAS
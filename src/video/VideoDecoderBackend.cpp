@@ -0,0 +1,109 @@
+#include "video/VideoDecoderBackend.h"
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <algorithm>
+
+namespace CounterUAS {
+
+namespace {
+
+struct Registration {
+    QString name;
+    int priority = 0;
+    bool hardware = false;
+    VideoDecoderRegistry::Factory factory;
+};
+
+QMutex& registryMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+QVector<Registration>& registrations() {
+    static QVector<Registration> list = {
+        {QStringLiteral("image"), 0, false,
+         []() { return std::unique_ptr<VideoDecoderBackend>(new ImageDecoderBackend); }},
+    };
+    return list;
+}
+
+} // namespace
+
+void VideoDecoderRegistry::registerBackend(const QString& name, int priority, bool hardware,
+                                           Factory factory) {
+    if (name.isEmpty() || !factory) return;
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    auto it = std::find_if(list.begin(), list.end(),
+                           [&](const Registration& r) { return r.name == name; });
+    if (it != list.end()) list.erase(it);
+
+    Registration reg;
+    reg.name = name;
+    reg.priority = priority;
+    reg.hardware = hardware;
+    reg.factory = std::move(factory);
+    // Stable: among equal priorities the earlier registration wins
+    auto pos = std::find_if(list.begin(), list.end(),
+                            [&](const Registration& r) { return r.priority < priority; });
+    list.insert(pos, reg);
+}
+
+void VideoDecoderRegistry::unregisterBackend(const QString& name) {
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [&](const Registration& r) { return r.name == name; }),
+               list.end());
+}
+
+QStringList VideoDecoderRegistry::candidates(bool allowHardware) {
+    QMutexLocker locker(&registryMutex());
+    QStringList names;
+    for (const Registration& reg : registrations()) {
+        if (allowHardware || !reg.hardware) names.append(reg.name);
+    }
+    return names;
+}
+
+std::unique_ptr<VideoDecoderBackend> VideoDecoderRegistry::create(const QString& name) {
+    Factory factory;
+    {
+        QMutexLocker locker(&registryMutex());
+        for (const Registration& reg : registrations()) {
+            if (reg.name == name) {
+                factory = reg.factory;
+                break;
+            }
+        }
+    }
+    return factory ? factory() : nullptr;
+}
+
+bool ImageDecoderBackend::open(const QString& codecName, FramePool* surfaces) {
+    Q_UNUSED(surfaces)    // QImage allocates its own decode target
+    const QString codec = codecName.toLower();
+    if (codec == "mjpeg" || codec == "jpeg" || codec == "jpg") {
+        m_format = "JPG";
+    } else if (codec == "png") {
+        m_format = "PNG";
+    } else if (codec == "image") {
+        m_format.clear();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ImageDecoderBackend::decode(const QByteArray& packet, VideoFrame& frame) {
+    QImage image;
+    if (!image.loadFromData(packet, m_format.isEmpty() ? nullptr : m_format.constData())) {
+        return false;
+    }
+    frame = VideoFrame(image);
+    return true;
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,78 @@
+#ifndef VIDEODECODERBACKEND_H
+#define VIDEODECODERBACKEND_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <memory>
+
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+class FramePool;
+
+/**
+ * @brief One decoder implementation behind VideoDecoder
+ *
+ * Backends are created per stream and driven from a single thread at a
+ * time. A hardware backend keeps its decode surfaces to itself and
+ * downloads, or maps, into frames from the FramePool it is opened with,
+ * so the pool bounds what a stream holds on the host.
+ */
+class VideoDecoderBackend {
+public:
+    virtual ~VideoDecoderBackend() = default;
+
+    virtual QString name() const = 0;
+    virtual bool isHardware() const = 0;
+
+    // False when the codec or device is not available here
+    virtual bool open(const QString& codecName, FramePool* surfaces) = 0;
+    virtual void close() = 0;
+
+    // False on a decode error. A true return with a null frame means the
+    // backend is still buffering (reordering, first keyframe).
+    virtual bool decode(const QByteArray& packet, VideoFrame& frame) = 0;
+};
+
+/**
+ * @brief Process-wide list of decoder backends, best first
+ *
+ * Platform backends (VA-API, NVDEC, D3D11VA) register themselves under a
+ * higher priority than the software ones; VideoDecoder walks the list and
+ * takes the first that opens the stream's codec.
+ */
+class VideoDecoderRegistry {
+public:
+    using Factory = std::function<std::unique_ptr<VideoDecoderBackend>()>;
+
+    static void registerBackend(const QString& name, int priority, bool hardware,
+                                Factory factory);
+    static void unregisterBackend(const QString& name);
+
+    // Names in preference order; hardware ones only when allowed
+    static QStringList candidates(bool allowHardware);
+    static std::unique_ptr<VideoDecoderBackend> create(const QString& name);
+};
+
+/**
+ * @brief Software decode of still-image codecs (MJPEG, JPEG, PNG) with QImage
+ */
+class ImageDecoderBackend : public VideoDecoderBackend {
+public:
+    QString name() const override { return QStringLiteral("image"); }
+    bool isHardware() const override { return false; }
+
+    bool open(const QString& codecName, FramePool* surfaces) override;
+    void close() override {}
+    bool decode(const QByteArray& packet, VideoFrame& frame) override;
+
+private:
+    QByteArray m_format;    // QImageReader format name; empty to sniff
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEODECODERBACKEND_H
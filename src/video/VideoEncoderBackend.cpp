@@ -0,0 +1,104 @@
+#include "video/VideoEncoderBackend.h"
+#include <QBuffer>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace CounterUAS {
+
+namespace {
+
+struct Registration {
+    QString name;
+    int priority = 0;
+    bool hardware = false;
+    VideoEncoderRegistry::Factory factory;
+};
+
+QMutex& registryMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+QVector<Registration>& registrations() {
+    static QVector<Registration> list = {
+        {QStringLiteral("jpeg"), 0, false,
+         []() { return std::unique_ptr<VideoEncoderBackend>(new JpegEncoderBackend); }},
+    };
+    return list;
+}
+
+} // namespace
+
+void VideoEncoderRegistry::registerBackend(const QString& name, int priority, bool hardware,
+                                           Factory factory) {
+    if (name.isEmpty() || !factory) return;
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    auto it = std::find_if(list.begin(), list.end(),
+                           [&](const Registration& r) { return r.name == name; });
+    if (it != list.end()) list.erase(it);
+
+    Registration reg;
+    reg.name = name;
+    reg.priority = priority;
+    reg.hardware = hardware;
+    reg.factory = std::move(factory);
+    // Stable: among equal priorities the earlier registration wins
+    auto pos = std::find_if(list.begin(), list.end(),
+                            [&](const Registration& r) { return r.priority < priority; });
+    list.insert(pos, reg);
+}
+
+void VideoEncoderRegistry::unregisterBackend(const QString& name) {
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [&](const Registration& r) { return r.name == name; }),
+               list.end());
+}
+
+QStringList VideoEncoderRegistry::candidates(bool allowHardware) {
+    QMutexLocker locker(&registryMutex());
+    QStringList names;
+    for (const Registration& reg : registrations()) {
+        if (allowHardware || !reg.hardware) names.append(reg.name);
+    }
+    return names;
+}
+
+std::unique_ptr<VideoEncoderBackend> VideoEncoderRegistry::create(const QString& name) {
+    Factory factory;
+    {
+        QMutexLocker locker(&registryMutex());
+        for (const Registration& reg : registrations()) {
+            if (reg.name == name) {
+                factory = reg.factory;
+                break;
+            }
+        }
+    }
+    return factory ? factory() : nullptr;
+}
+
+bool JpegEncoderBackend::open(const VideoEncoderSettings& settings) {
+    const QString codec = settings.codec.toUpper();
+    if (codec != "MJPEG" && codec != "JPEG") return false;
+    m_quality = qBound(0, settings.quality, 100);
+    return true;
+}
+
+bool JpegEncoderBackend::encode(const VideoFrame& frame, qint64 timeMs,
+                                QVector<EncodedPacket>& packets) {
+    EncodedPacket packet;
+    QBuffer buffer(&packet.data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!frame.toImage().save(&buffer, "JPG", m_quality)) return false;
+    packet.timeMs = timeMs;
+    packet.keyframe = true;
+    packets.append(std::move(packet));
+    return true;
+}
+
+} // namespace CounterUAS
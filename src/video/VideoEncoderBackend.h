@@ -0,0 +1,112 @@
+#ifndef VIDEOENCODERBACKEND_H
+#define VIDEOENCODERBACKEND_H
+
+#include <QByteArray>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief What a recording or a live stream asks of its encoder
+ */
+struct VideoEncoderSettings {
+    QString codec = "H264";      // H264, H265, MJPEG
+    int bitrateKbps = 8000;
+    int quality = 80;            // 0-100, for codecs without rate control
+    double fps = 30.0;
+    QSize size;
+    int keyframeIntervalFrames = 30;
+    bool lowLatency = false;     // Live viewing: no B-frames, lookahead or frame buffering
+};
+
+/**
+ * @brief One compressed access unit
+ */
+struct EncodedPacket {
+    QByteArray data;
+    qint64 timeMs = 0;
+    bool keyframe = false;
+};
+
+/**
+ * @brief One encoder implementation behind VideoRecorder and VideoRestreamer
+ *
+ * Backends are created per recording segment or live stream and driven
+ * from the thread that created them only. Frames arrive in their native
+ * pixel format, so a hardware encoder can take YUV planes without
+ * conversion.
+ */
+class VideoEncoderBackend {
+public:
+    virtual ~VideoEncoderBackend() = default;
+
+    virtual QString name() const = 0;
+    virtual bool isHardware() const = 0;
+
+    // False when the codec or device is not available here
+    virtual bool open(const VideoEncoderSettings& settings) = 0;
+    virtual void close() = 0;
+
+    // Matroska CodecID and CodecPrivate of the open stream
+    virtual QString codecId() const = 0;
+    virtual QByteArray codecPrivate() const { return QByteArray(); }
+
+    // Appends zero or more packets; false on an encode error
+    virtual bool encode(const VideoFrame& frame, qint64 timeMs,
+                        QVector<EncodedPacket>& packets) = 0;
+    // Drains packets still held for reordering
+    virtual void flush(QVector<EncodedPacket>& packets) { Q_UNUSED(packets) }
+    // Makes the next frame encoded a keyframe, for a receiver joining a
+    // live stream; intra-only codecs have nothing to do
+    virtual void requestKeyframe() {}
+};
+
+/**
+ * @brief Process-wide list of encoder backends, best first
+ *
+ * Platform encoders (NVENC, VA-API, Quick Sync, Media Foundation)
+ * register themselves under a higher priority than the software ones;
+ * VideoRecorder takes the first that opens the configured codec.
+ */
+class VideoEncoderRegistry {
+public:
+    using Factory = std::function<std::unique_ptr<VideoEncoderBackend>()>;
+
+    static void registerBackend(const QString& name, int priority, bool hardware,
+                                Factory factory);
+    static void unregisterBackend(const QString& name);
+
+    // Names in preference order; hardware ones only when allowed
+    static QStringList candidates(bool allowHardware);
+    static std::unique_ptr<VideoEncoderBackend> create(const QString& name);
+};
+
+/**
+ * @brief Software Motion JPEG with QImage, every frame a keyframe
+ */
+class JpegEncoderBackend : public VideoEncoderBackend {
+public:
+    QString name() const override { return QStringLiteral("jpeg"); }
+    bool isHardware() const override { return false; }
+
+    bool open(const VideoEncoderSettings& settings) override;
+    void close() override {}
+
+    QString codecId() const override { return QStringLiteral("V_MJPEG"); }
+    bool encode(const VideoFrame& frame, qint64 timeMs,
+                QVector<EncodedPacket>& packets) override;
+
+private:
+    int m_quality = 80;
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEOENCODERBACKEND_H
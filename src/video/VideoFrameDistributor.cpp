@@ -0,0 +1,290 @@
+#include "video/VideoFrameDistributor.h"
+#include "utils/FlightRecorder.h"
+#include "utils/ThreadPlacement.h"
+#include <QImage>
+#include <QMetaObject>
+#include <QMutexLocker>
+
+namespace CounterUAS {
+
+namespace {
+
+// A frame this fraction of an interval early still counts as on time, so a
+// 30 fps source capped at 15 fps delivers every other frame despite jitter
+constexpr double RATE_TOLERANCE = 0.25;
+
+} // namespace
+
+VideoFrameDistributor::~VideoFrameDistributor() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        for (Subscription& subscription : m_subscriptions) {
+            subscription.mailbox->active = false;
+        }
+    }
+    m_jobReady.wakeAll();
+    if (m_scaler) {
+        m_scaler->wait();
+        delete m_scaler;
+    }
+}
+
+int VideoFrameDistributor::subscribe(const QString& streamId, QObject* context,
+                                     const VideoDeliveryPolicy& policy, FrameCallback callback) {
+    if (!context || !callback) return 0;
+
+    Subscription subscription;
+    subscription.streamId = streamId;
+    subscription.policy = policy;
+    subscription.mailbox = std::make_shared<Mailbox>();
+    subscription.mailbox->context = context;
+    subscription.mailbox->callback = std::move(callback);
+
+    QMutexLocker locker(&m_mutex);
+    const int id = m_nextId++;
+    m_subscriptions.insert(id, subscription);
+    return id;
+}
+
+void VideoFrameDistributor::unsubscribe(int subscriptionId) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_subscriptions.find(subscriptionId);
+    if (it == m_subscriptions.end()) return;
+    it->mailbox->active = false;
+    m_subscriptions.erase(it);
+}
+
+void VideoFrameDistributor::setPolicy(int subscriptionId, const VideoDeliveryPolicy& policy) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_subscriptions.find(subscriptionId);
+    if (it != m_subscriptions.end()) it->policy = policy;
+}
+
+void VideoFrameDistributor::setStreamRateCap(const QString& streamId, double maxFps) {
+    QMutexLocker locker(&m_mutex);
+    if (maxFps > 0.0) {
+        m_streamCaps.insert(streamId, maxFps);
+    } else {
+        m_streamCaps.remove(streamId);
+    }
+}
+
+double VideoFrameDistributor::streamRateCap(const QString& streamId) const {
+    QMutexLocker locker(&m_mutex);
+    return m_streamCaps.value(streamId, 0.0);
+}
+
+int VideoFrameDistributor::subscriberCount(const QString& streamId) const {
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const Subscription& subscription : m_subscriptions) {
+        if (subscription.streamId == streamId) ++count;
+    }
+    return count;
+}
+
+QSize VideoFrameDistributor::largestTargetSize(const QString& streamId) const {
+    QMutexLocker locker(&m_mutex);
+    QSize largest;
+    for (const Subscription& subscription : m_subscriptions) {
+        const QSize size = subscription.policy.targetSize;
+        if (subscription.streamId != streamId || !size.isValid() || size.isEmpty()) continue;
+        if (!subscription.mailbox->context) continue;
+        if (!largest.isValid() || qint64(size.width()) * size.height() >
+                                  qint64(largest.width()) * largest.height()) {
+            largest = size;
+        }
+    }
+    return largest;
+}
+
+bool VideoFrameDistributor::hasNativeSubscriber(const QString& streamId) const {
+    QMutexLocker locker(&m_mutex);
+    for (const Subscription& subscription : m_subscriptions) {
+        const QSize size = subscription.policy.targetSize;
+        if (subscription.streamId != streamId || !subscription.mailbox->context) continue;
+        if (!size.isValid() || size.isEmpty()) return true;
+    }
+    return false;
+}
+
+void VideoFrameDistributor::publish(const QString& streamId, const VideoFrame& frame,
+                                    qint64 timestamp) {
+    if (frame.isNull()) return;
+    m_published.fetch_add(1, std::memory_order_relaxed);
+
+    const QSize sourceSize = frame.size();
+    QVector<std::pair<std::shared_ptr<Mailbox>, bool>> native;
+    ScaleJob job;
+    {
+        QMutexLocker locker(&m_mutex);
+        const double streamCap = m_streamCaps.value(streamId, 0.0);
+        for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it) {
+            Subscription& subscription = it.value();
+            if (subscription.streamId != streamId) continue;
+            if (!dueLocked(subscription, timestamp, streamCap)) {
+                m_rateLimited.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            const QSize size = fittedSize(sourceSize, subscription.policy.targetSize);
+            if (size == sourceSize) {
+                native.append({subscription.mailbox, subscription.policy.latestOnly});
+            } else {
+                job.targets.append(Target{it.key(), size});
+            }
+        }
+
+        if (!job.targets.isEmpty()) {
+            job.frame = frame;
+            job.timestamp = timestamp;
+            if (m_jobs.contains(streamId)) {
+                m_scaleSkipped.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                m_jobOrder.enqueue(streamId);
+            }
+            m_jobs.insert(streamId, job);
+        }
+    }
+
+    for (const auto& entry : native) {
+        deliver(entry.first, entry.second, frame, timestamp, sourceSize);
+    }
+    if (!job.targets.isEmpty()) {
+        startScaler();
+        m_jobReady.wakeOne();
+    }
+}
+
+VideoDeliveryStats VideoFrameDistributor::stats() const {
+    VideoDeliveryStats stats;
+    stats.published = m_published.load(std::memory_order_relaxed);
+    stats.delivered = m_delivered.load(std::memory_order_relaxed);
+    stats.rateLimited = m_rateLimited.load(std::memory_order_relaxed);
+    stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    stats.scaled = m_scaled.load(std::memory_order_relaxed);
+    stats.scaleSkipped = m_scaleSkipped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+QSize VideoFrameDistributor::fittedSize(const QSize& frameSize, const QSize& targetSize) {
+    if (!targetSize.isValid() || targetSize.isEmpty()) return frameSize;
+    if (targetSize.width() >= frameSize.width() && targetSize.height() >= frameSize.height()) {
+        return frameSize;
+    }
+    return frameSize.scaled(targetSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+}
+
+bool VideoFrameDistributor::dueLocked(Subscription& subscription, qint64 timestamp, double streamCap) {
+    double maxFps = subscription.policy.maxFps;
+    if (streamCap > 0.0 && (maxFps <= 0.0 || streamCap < maxFps)) maxFps = streamCap;
+    if (maxFps <= 0.0) return true;
+
+    const double interval = 1000.0 / maxFps;
+    const double now = static_cast<double>(timestamp);
+    if (now + interval * RATE_TOLERANCE < subscription.nextDueMs) return false;
+
+    subscription.nextDueMs += interval;
+    // After a stall, or on the first frame, count from now instead of catching up
+    if (subscription.nextDueMs < now) subscription.nextDueMs = now + interval;
+    return true;
+}
+
+void VideoFrameDistributor::deliver(const std::shared_ptr<Mailbox>& mailbox, bool latestOnly,
+                                    const VideoFrame& frame, qint64 timestamp,
+                                    const QSize& sourceSize) {
+    QObject* context = mailbox->context.data();
+    if (!context || !mailbox->active) return;
+
+    if (!latestOnly) {
+        QMetaObject::invokeMethod(context, [mailbox, frame, timestamp, sourceSize]() {
+            FlightScope flightScope(FlightStage::FrameDelivery);
+            if (mailbox->active) mailbox->callback(frame, timestamp, sourceSize);
+        }, Qt::QueuedConnection);
+        m_delivered.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    {
+        QMutexLocker locker(&mailbox->mutex);
+        const bool posted = mailbox->pending;
+        mailbox->frame = frame;
+        mailbox->timestamp = timestamp;
+        mailbox->sourceSize = sourceSize;
+        mailbox->pending = true;
+        if (posted) {
+            // The queued call has not run yet; it picks this frame up instead
+            m_coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    QMetaObject::invokeMethod(context, [mailbox]() {
+        VideoFrame latest;
+        qint64 latestTimestamp = 0;
+        QSize latestSourceSize;
+        {
+            QMutexLocker locker(&mailbox->mutex);
+            latest = mailbox->frame;
+            latestTimestamp = mailbox->timestamp;
+            latestSourceSize = mailbox->sourceSize;
+            mailbox->frame = VideoFrame();
+            mailbox->pending = false;
+        }
+        FlightScope flightScope(FlightStage::FrameDelivery);
+        if (mailbox->active) mailbox->callback(latest, latestTimestamp, latestSourceSize);
+    }, Qt::QueuedConnection);
+    m_delivered.fetch_add(1, std::memory_order_relaxed);
+}
+
+void VideoFrameDistributor::startScaler() {
+    QMutexLocker locker(&m_mutex);
+    if (m_scaler || m_stopping) return;
+    m_scaler = QThread::create([this]() { scalerLoop(); });
+    m_scaler->setObjectName("VideoFrameScaler");
+    ThreadPlacement::instance().assign(m_scaler, ThreadRole::VideoDecode);
+    m_scaler->start();
+}
+
+void VideoFrameDistributor::scalerLoop() {
+    forever {
+        ScaleJob job;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_jobOrder.isEmpty() && !m_stopping) {
+                m_jobReady.wait(&m_mutex);
+            }
+            if (m_stopping) return;
+            job = m_jobs.take(m_jobOrder.dequeue());
+        }
+
+        const QSize sourceSize = job.frame.size();
+        const QImage image = job.frame.toImage();
+        QHash<quint64, VideoFrame> scaled;    // By packed size
+        for (const Target& target : job.targets) {
+            const quint64 key = (quint64(quint32(target.size.width())) << 32) |
+                                quint32(target.size.height());
+            if (scaled.contains(key)) continue;
+            scaled.insert(key, VideoFrame(image.scaled(target.size, Qt::IgnoreAspectRatio,
+                                                       Qt::SmoothTransformation)));
+            m_scaled.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        for (const Target& target : job.targets) {
+            std::shared_ptr<Mailbox> mailbox;
+            bool latestOnly = true;
+            {
+                QMutexLocker locker(&m_mutex);
+                auto it = m_subscriptions.constFind(target.subscriptionId);
+                if (it == m_subscriptions.constEnd()) continue;
+                mailbox = it->mailbox;
+                latestOnly = it->policy.latestOnly;
+            }
+            const quint64 key = (quint64(quint32(target.size.width())) << 32) |
+                                quint32(target.size.height());
+            deliver(mailbox, latestOnly, scaled.value(key), job.timestamp, sourceSize);
+        }
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,147 @@
+#ifndef VIDEOFRAMEDISTRIBUTOR_H
+#define VIDEOFRAMEDISTRIBUTOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QQueue>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "utils/VideoFrame.h"
+
+namespace CounterUAS {
+
+/**
+ * @brief How one subscriber wants a stream delivered
+ */
+struct VideoDeliveryPolicy {
+    QSize targetSize;           // Fitted inside, keeping aspect; invalid for native
+    double maxFps = 0.0;        // 0 for every frame
+    bool latestOnly = true;     // A busy subscriber gets the newest frame, not a backlog
+};
+
+/**
+ * @brief Delivery counters, safe to read from any thread
+ */
+struct VideoDeliveryStats {
+    quint64 published = 0;
+    quint64 delivered = 0;
+    quint64 rateLimited = 0;    // Skipped by a subscriber's maxFps
+    quint64 coalesced = 0;      // Replaced before a latest-only subscriber took them
+    quint64 scaled = 0;         // Scale operations, once per size per frame
+    quint64 scaleSkipped = 0;   // Frames replaced before the scaler reached them
+};
+
+/**
+ * @brief Fans one stream's frames out to subscribers under their own policies
+ *
+ * Each subscriber names a target size, a frame rate cap and whether it may
+ * skip frames. Frames bound for subscribers at native size are handed over
+ * as they are; the others go to a scaler thread that makes each distinct
+ * size once per frame, so two thumbnails of one camera cost one scale and
+ * no widget scales a full frame in its paint. The scaler keeps only the
+ * newest frame per stream, so a slow scale never builds a backlog.
+ *
+ * Callbacks run on the thread of the subscriber's context object, queued;
+ * they stop as soon as unsubscribe() returns or the context is destroyed.
+ */
+class VideoFrameDistributor {
+public:
+    // sourceSize is the frame's size before scaling, for mapping overlays
+    using FrameCallback =
+        std::function<void(const VideoFrame& frame, qint64 timestamp, const QSize& sourceSize)>;
+
+    VideoFrameDistributor() = default;
+    ~VideoFrameDistributor();
+
+    VideoFrameDistributor(const VideoFrameDistributor&) = delete;
+    VideoFrameDistributor& operator=(const VideoFrameDistributor&) = delete;
+
+    int subscribe(const QString& streamId, QObject* context, const VideoDeliveryPolicy& policy,
+                  FrameCallback callback);
+    void unsubscribe(int subscriptionId);
+    void setPolicy(int subscriptionId, const VideoDeliveryPolicy& policy);
+    int subscriberCount(const QString& streamId) const;
+    // Largest target size asked for by a live subscriber; invalid if only native ones
+    QSize largestTargetSize(const QString& streamId) const;
+    bool hasNativeSubscriber(const QString& streamId) const;
+
+    // Caps every subscriber of the stream at maxFps on top of its own
+    // policy, for shedding load; 0 lifts the cap
+    void setStreamRateCap(const QString& streamId, double maxFps);
+    double streamRateCap(const QString& streamId) const;
+
+    // From the stream's thread, once per frame
+    void publish(const QString& streamId, const VideoFrame& frame, qint64 timestamp);
+
+    VideoDeliveryStats stats() const;
+
+    // QSize::scaled with KeepAspectRatio, never up
+    static QSize fittedSize(const QSize& frameSize, const QSize& targetSize);
+
+private:
+    // Shared with callbacks already posted, so they outlive the subscription
+    struct Mailbox {
+        QPointer<QObject> context;
+        FrameCallback callback;
+        std::atomic<bool> active{true};
+        QMutex mutex;
+        VideoFrame frame;
+        qint64 timestamp = 0;
+        QSize sourceSize;
+        bool pending = false;
+    };
+
+    struct Subscription {
+        QString streamId;
+        VideoDeliveryPolicy policy;
+        double nextDueMs = 0.0;
+        std::shared_ptr<Mailbox> mailbox;
+    };
+
+    struct Target {
+        int subscriptionId = 0;
+        QSize size;
+    };
+
+    struct ScaleJob {
+        VideoFrame frame;
+        qint64 timestamp = 0;
+        QVector<Target> targets;
+    };
+
+    bool dueLocked(Subscription& subscription, qint64 timestamp, double streamCap);
+    void deliver(const std::shared_ptr<Mailbox>& mailbox, bool latestOnly, const VideoFrame& frame,
+                 qint64 timestamp, const QSize& sourceSize);
+    void startScaler();
+    void scalerLoop();
+
+    mutable QMutex m_mutex;
+    QHash<int, Subscription> m_subscriptions;
+    QHash<QString, double> m_streamCaps;
+    int m_nextId = 1;
+
+    QWaitCondition m_jobReady;
+    QHash<QString, ScaleJob> m_jobs;     // Newest per stream
+    QQueue<QString> m_jobOrder;
+    bool m_stopping = false;
+    QThread* m_scaler = nullptr;
+
+    std::atomic<quint64> m_published{0};
+    std::atomic<quint64> m_delivered{0};
+    std::atomic<quint64> m_rateLimited{0};
+    std::atomic<quint64> m_coalesced{0};
+    std::atomic<quint64> m_scaled{0};
+    std::atomic<quint64> m_scaleSkipped{0};
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEOFRAMEDISTRIBUTOR_H
@@ -1,5 +1,8 @@
 #include "video/VideoOverlayRenderer.h"
+#include "core/TrackStateHistory.h"
 #include <QDateTime>
+#include <QFontMetrics>
+#include <algorithm>
 
 namespace CounterUAS {
 
@@ -10,6 +13,7 @@ VideoOverlayRenderer::VideoOverlayRenderer(QObject* parent)
 
 void VideoOverlayRenderer::setStyle(const OverlayStyle& style) {
     m_style = style;
+    invalidateLayer();
 }
 
 void VideoOverlayRenderer::setTelemetry(const OverlayTelemetry& telemetry) {
@@ -18,6 +22,41 @@ void VideoOverlayRenderer::setTelemetry(const OverlayTelemetry& telemetry) {
 
 void VideoOverlayRenderer::setTrackOverlays(const QList<TrackOverlay>& tracks) {
     m_tracks = tracks;
+    pruneLabelCache();
+}
+
+void VideoOverlayRenderer::setTrackHistory(const TrackStateHistory* history, TrackProjector projector) {
+    m_history = projector ? history : nullptr;
+    m_projector = m_history ? std::move(projector) : TrackProjector();
+    clearTrackOverlays();
+}
+
+void VideoOverlayRenderer::alignTracks(const QSize& frameSize) {
+    const qint64 timeMs = m_frameTimeMs > 0 ? m_frameTimeMs : m_history->newestMs();
+    m_tracks.clear();
+    if (m_history->statesAt(timeMs, m_states)) {
+        for (const TrackSnapshot& state : m_states) {
+            TrackOverlay overlay;
+            overlay.trackId = state.trackId;
+            overlay.classification = state.classification;
+            overlay.threatLevel = state.threatLevel;
+            overlay.velocity = state.velocity;
+            overlay.isEngaged = state.engaged;
+            overlay.isSelected = state.trackId == m_selectedTrackId;
+            if (m_projector(state, timeMs, frameSize, overlay)) m_tracks.append(overlay);
+        }
+    }
+    pruneLabelCache();
+}
+
+void VideoOverlayRenderer::pruneLabelCache() {
+    // Keep the glyphs of tracks that are still there
+    for (auto it = m_labelCache.begin(); it != m_labelCache.end();) {
+        const QString& id = it.key();
+        const bool present = std::any_of(m_tracks.cbegin(), m_tracks.cend(),
+            [&id](const TrackOverlay& t) { return t.trackId == id; });
+        it = present ? std::next(it) : m_labelCache.erase(it);
+    }
 }
 
 void VideoOverlayRenderer::addTrackOverlay(const TrackOverlay& track) {
@@ -29,10 +68,12 @@ void VideoOverlayRenderer::addTrackOverlay(const TrackOverlay& track) {
 void VideoOverlayRenderer::removeTrackOverlay(const QString& trackId) {
     m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(),
         [&trackId](const TrackOverlay& t) { return t.trackId == trackId; }), m_tracks.end());
+    m_labelCache.remove(trackId);
 }
 
 void VideoOverlayRenderer::clearTrackOverlays() {
     m_tracks.clear();
+    m_labelCache.clear();
 }
 
 void VideoOverlayRenderer::setSelectedTrack(const QString& trackId) {
@@ -48,50 +89,219 @@ void VideoOverlayRenderer::clearDesignationPoint() {
     m_hasDesignation = false;
 }
 
+void VideoOverlayRenderer::invalidateLayer() {
+    m_labelCache.clear();
+    m_telemetryText = CachedText();
+    m_timestampText = CachedText();
+    m_recordingImage = QImage();
+    m_layerValid = false;
+}
+
 QImage VideoOverlayRenderer::renderOverlay(const QImage& frame) {
+    updateLayer(frame.size());
+    
     QImage result = frame.copy();
     QPainter painter(&result);
-    painter.setRenderHint(QPainter::Antialiasing);
-    
-    renderOverlay(&painter, frame.size());
-    
+    painter.drawImage(0, 0, m_layer);
     painter.end();
     return result;
 }
 
 void VideoOverlayRenderer::renderOverlay(QPainter* painter, const QSize& frameSize) {
-    // Draw track boxes
-    for (const TrackOverlay& track : m_tracks) {
-        drawTrackBox(painter, track, frameSize);
-        drawTrackLabel(painter, track, frameSize);
+    const QVector<SceneItem> scene = buildScene(frameSize);
+    for (const SceneItem& item : scene) {
+        drawItem(painter, item);
+    }
+}
+
+QRegion VideoOverlayRenderer::updateLayer(const QSize& frameSize) {
+    const QVector<SceneItem> scene = buildScene(frameSize);
+    const QRect frameRect(QPoint(0, 0), frameSize);
+    
+    QRegion dirty;
+    if (!m_layerValid || m_layer.size() != frameSize) {
+        m_layer = QImage(frameSize, QImage::Format_ARGB32_Premultiplied);
+        m_layer.fill(Qt::transparent);
+        m_drawn.clear();
+        m_layerValid = true;
+        dirty = frameRect;
+    }
+    
+    // An item that changed dirties where it was and where it is now
+    QHash<QString, SceneItem> drawn;
+    drawn.reserve(scene.size());
+    for (const SceneItem& item : scene) {
+        auto previous = m_drawn.constFind(item.id);
+        if (previous == m_drawn.constEnd()) {
+            dirty += item.bounds;
+        } else if (previous->key != item.key) {
+            dirty += previous->bounds;
+            dirty += item.bounds;
+        }
+        drawn.insert(item.id, item);
+    }
+    for (auto it = m_drawn.constBegin(); it != m_drawn.constEnd(); ++it) {
+        if (!drawn.contains(it.key())) dirty += it->bounds;
+    }
+    m_drawn = std::move(drawn);
+    
+    dirty &= frameRect;
+    if (dirty.isEmpty()) return dirty;
+    
+    QPainter painter(&m_layer);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (const QRect& rect : dirty) {
+        painter.fillRect(rect, Qt::transparent);
+    }
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setClipRegion(dirty);
+    
+    // Unchanged items under the cleared area are redrawn, in scene order
+    for (const SceneItem& item : scene) {
+        if (dirty.intersects(item.bounds)) drawItem(&painter, item);
+    }
+    painter.end();
+    
+    ++m_layerRevision;
+    m_layerHistory.append(dirty.boundingRect());
+    if (m_layerHistory.size() > LAYER_HISTORY) m_layerHistory.removeFirst();
+    return dirty;
+}
+
+QRect VideoOverlayRenderer::layerChangedSince(quint64 revision) const {
+    if (revision >= m_layerRevision) return QRect();
+    const quint64 behind = m_layerRevision - revision;
+    if (behind > static_cast<quint64>(m_layerHistory.size())) return m_layer.rect();
+    
+    QRect changed;
+    for (int i = m_layerHistory.size() - static_cast<int>(behind); i < m_layerHistory.size(); ++i) {
+        changed |= m_layerHistory[i];
+    }
+    return changed;
+}
+
+QVector<VideoOverlayRenderer::SceneItem> VideoOverlayRenderer::buildScene(const QSize& frameSize) {
+    if (m_history) alignTracks(frameSize);
+    
+    QVector<SceneItem> scene;
+    scene.reserve(m_tracks.size() + 4);
+    
+    for (int i = 0; i < m_tracks.size(); ++i) {
+        const TrackOverlay& track = m_tracks[i];
+        if (!track.boundingBox.isValid()) continue;
+        
+        const QRect box(static_cast<int>(track.boundingBox.x), static_cast<int>(track.boundingBox.y),
+                        static_cast<int>(track.boundingBox.width),
+                        static_cast<int>(track.boundingBox.height));
+        const bool selected = track.trackId == m_selectedTrackId;
+        const int lineWidth = m_style.boxLineWidth + (selected ? 2 : 0);
+        // Half the pen plus antialiasing, or the engaged rect 5 px outside
+        const int margin = qMax(lineWidth / 2 + 2, track.isEngaged ? 7 : 0);
+        
+        SceneItem item;
+        item.id = QStringLiteral("track:") + track.trackId;
+        item.kind = ItemKind::Track;
+        item.track = i;
+        item.bounds = box.adjusted(-margin, -margin, margin, margin);
+        
+        const QString label = trackLabel(track);
+        if (!label.isEmpty()) {
+            item.text = textImage(m_labelCache[track.trackId], label, m_style.labelFont);
+            // Above the box, or below it near the top edge
+            const int textHeight = item.text.height() - 4;
+            int baseline = box.y() - textHeight - 4;
+            if (baseline < 5) {
+                baseline = box.y() + box.height() + textHeight + 4;
+            }
+            item.pos = QPoint(box.x() - 2, baseline - textHeight);
+            item.bounds |= QRect(item.pos, item.text.size());
+        }
+        
+        item.key = QStringLiteral("%1,%2,%3,%4,%5,%6,%7|%8")
+                       .arg(box.x()).arg(box.y()).arg(box.width()).arg(box.height())
+                       .arg(static_cast<int>(track.classification))
+                       .arg(selected ? 1 : 0).arg(track.isEngaged ? 1 : 0)
+                       .arg(label);
+        scene.append(item);
     }
     
-    // Draw designation crosshairs
     if (m_hasDesignation) {
-        drawCrosshairs(painter, m_designationPoint, frameSize);
+        SceneItem item;
+        item.id = QStringLiteral("crosshairs");
+        item.kind = ItemKind::Crosshairs;
+        item.pos = QPoint(static_cast<int>(m_designationPoint.x() * frameSize.width()),
+                          static_cast<int>(m_designationPoint.y() * frameSize.height()));
+        const int reach = m_style.crosshairSize + 2;
+        item.bounds = QRect(item.pos - QPoint(reach, reach), QSize(2 * reach + 1, 2 * reach + 1));
+        item.key = QStringLiteral("%1,%2").arg(item.pos.x()).arg(item.pos.y());
+        scene.append(item);
     }
     
-    // Draw telemetry bar
     if (m_style.showCameraInfo) {
-        drawTelemetryBar(painter, frameSize);
+        const QString text = QString("%1  Az: %2°  El: %3°  Zoom: %4x")
+                                 .arg(m_telemetry.cameraName)
+                                 .arg(m_telemetry.azimuth, 0, 'f', 1)
+                                 .arg(m_telemetry.elevation, 0, 'f', 1)
+                                 .arg(m_telemetry.zoom, 0, 'f', 1);
+        SceneItem item;
+        item.id = QStringLiteral("telemetry");
+        item.kind = ItemKind::Telemetry;
+        item.text = textImage(m_telemetryText, text, m_style.telemetryFont);
+        // Bottom left, baseline 10 px up
+        item.pos = QPoint(8, frameSize.height() - 10 - (item.text.height() - 4));
+        item.bounds = QRect(item.pos, item.text.size());
+        item.key = text;
+        scene.append(item);
     }
     
-    // Draw recording indicator
     if (m_style.showRecordingIndicator && m_telemetry.recording) {
-        drawRecordingIndicator(painter, frameSize);
+        SceneItem item;
+        item.id = QStringLiteral("recording");
+        item.kind = ItemKind::Recording;
+        item.text = recordingImage();
+        item.pos = QPoint(frameSize.width() - 80, 25) + item.text.offset();
+        item.bounds = QRect(item.pos, item.text.size());
+        item.key = QStringLiteral("REC");
+        scene.append(item);
     }
     
-    // Draw timestamp
     if (m_style.showTimestamp) {
-        drawTimestamp(painter, frameSize);
+        const qint64 time = m_telemetry.timestamp != 0 ? m_telemetry.timestamp
+                                                       : QDateTime::currentMSecsSinceEpoch();
+        const QString text = QDateTime::fromMSecsSinceEpoch(time).toString("yyyy-MM-dd hh:mm:ss.zzz");
+        SceneItem item;
+        item.id = QStringLiteral("timestamp");
+        item.kind = ItemKind::Timestamp;
+        item.text = textImage(m_timestampText, text, m_style.telemetryFont);
+        // Bottom right, baseline 10 px up
+        item.pos = QPoint(frameSize.width() - item.text.width() - 8,
+                          frameSize.height() - 10 - (item.text.height() - 4));
+        item.bounds = QRect(item.pos, item.text.size());
+        item.key = text;
+        scene.append(item);
     }
+    
+    return scene;
 }
 
-void VideoOverlayRenderer::drawTrackBox(QPainter* painter, const TrackOverlay& track, 
-                                         const QSize& frameSize) {
-    if (!track.boundingBox.isValid()) return;
-    
-    // Convert normalized coordinates to pixel coordinates
+void VideoOverlayRenderer::drawItem(QPainter* painter, const SceneItem& item) {
+    switch (item.kind) {
+        case ItemKind::Track:
+            drawTrackBox(painter, m_tracks[item.track]);
+            break;
+        case ItemKind::Crosshairs:
+            drawCrosshairs(painter, item.pos);
+            return;
+        default:
+            break;
+    }
+    if (!item.text.isNull()) {
+        painter->drawImage(item.pos, item.text);
+    }
+}
+
+void VideoOverlayRenderer::drawTrackBox(QPainter* painter, const TrackOverlay& track) {
     int x = static_cast<int>(track.boundingBox.x);
     int y = static_cast<int>(track.boundingBox.y);
     int w = static_cast<int>(track.boundingBox.width);
@@ -143,12 +353,7 @@ void VideoOverlayRenderer::drawTrackBox(QPainter* painter, const TrackOverlay& t
     }
 }
 
-void VideoOverlayRenderer::drawTrackLabel(QPainter* painter, const TrackOverlay& track,
-                                           const QSize& frameSize) {
-    Q_UNUSED(frameSize)
-    
-    if (!track.boundingBox.isValid()) return;
-    
+QString VideoOverlayRenderer::trackLabel(const TrackOverlay& track) const {
     QStringList labelParts;
     
     if (m_style.showTrackIds) {
@@ -167,34 +372,12 @@ void VideoOverlayRenderer::drawTrackLabel(QPainter* painter, const TrackOverlay&
         labelParts << QString("%1m").arg(static_cast<int>(track.distance));
     }
     
-    if (labelParts.isEmpty()) return;
-    
-    QString label = labelParts.join(" | ");
-    
-    painter->setFont(m_style.labelFont);
-    QFontMetrics fm(m_style.labelFont);
-    QRect textRect = fm.boundingRect(label);
-    
-    int x = track.boundingBox.x;
-    int y = track.boundingBox.y - textRect.height() - 4;
-    
-    if (y < 5) {
-        y = track.boundingBox.y + track.boundingBox.height + textRect.height() + 4;
-    }
-    
-    // Draw background
-    QRect bgRect(x - 2, y - textRect.height(), textRect.width() + 4, textRect.height() + 4);
-    painter->fillRect(bgRect, m_style.textBackgroundColor);
-    
-    // Draw text
-    painter->setPen(m_style.textColor);
-    painter->drawText(x, y, label);
+    return labelParts.join(" | ");
 }
 
-void VideoOverlayRenderer::drawCrosshairs(QPainter* painter, const QPointF& point,
-                                           const QSize& frameSize) {
-    int x = static_cast<int>(point.x() * frameSize.width());
-    int y = static_cast<int>(point.y() * frameSize.height());
+void VideoOverlayRenderer::drawCrosshairs(QPainter* painter, const QPoint& center) {
+    int x = center.x();
+    int y = center.y();
     int size = m_style.crosshairSize;
     
     painter->setPen(QPen(m_style.crosshairColor, 2));
@@ -210,67 +393,53 @@ void VideoOverlayRenderer::drawCrosshairs(QPainter* painter, const QPointF& poin
     painter->drawEllipse(QPoint(x, y), 5, 5);
 }
 
-void VideoOverlayRenderer::drawTelemetryBar(QPainter* painter, const QSize& frameSize) {
-    QString telemetryText = QString("%1  Az: %2°  El: %3°  Zoom: %4x")
-                               .arg(m_telemetry.cameraName)
-                               .arg(m_telemetry.azimuth, 0, 'f', 1)
-                               .arg(m_telemetry.elevation, 0, 'f', 1)
-                               .arg(m_telemetry.zoom, 0, 'f', 1);
-    
-    painter->setFont(m_style.telemetryFont);
-    QFontMetrics fm(m_style.telemetryFont);
-    QRect textRect = fm.boundingRect(telemetryText);
-    
-    int x = 10;
-    int y = frameSize.height() - 10;
-    
-    // Draw background
-    QRect bgRect(x - 2, y - textRect.height(), textRect.width() + 4, textRect.height() + 4);
-    painter->fillRect(bgRect, m_style.textBackgroundColor);
-    
-    // Draw text
-    painter->setPen(m_style.textColor);
-    painter->drawText(x, y, telemetryText);
-}
-
-void VideoOverlayRenderer::drawRecordingIndicator(QPainter* painter, const QSize& frameSize) {
-    int x = frameSize.width() - 80;
-    int y = 25;
-    
-    // Draw red circle
-    painter->setPen(Qt::NoPen);
-    painter->setBrush(Qt::red);
-    painter->drawEllipse(QPoint(x, y), 8, 8);
-    
-    // Draw "REC" text
-    painter->setFont(m_style.labelFont);
-    painter->setPen(Qt::white);
-    painter->drawText(x + 15, y + 5, "REC");
+const QImage& VideoOverlayRenderer::textImage(CachedText& cache, const QString& text,
+                                              const QFont& font) {
+    if (cache.text == text && !cache.image.isNull()) return cache.image;
+    
+    // Background 2 px around the text, baseline at the font height
+    QFontMetrics fm(font);
+    QImage image(fm.horizontalAdvance(text) + 4, fm.height() + 4,
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(m_style.textBackgroundColor);
+    
+    QPainter painter(&image);
+    painter.setFont(font);
+    painter.setPen(m_style.textColor);
+    painter.drawText(2, fm.height(), text);
+    painter.end();
+    
+    cache.text = text;
+    cache.image = image;
+    return cache.image;
 }
 
-void VideoOverlayRenderer::drawTimestamp(QPainter* painter, const QSize& frameSize) {
-    QString timestamp = QDateTime::fromMSecsSinceEpoch(m_telemetry.timestamp)
-                            .toString("yyyy-MM-dd hh:mm:ss.zzz");
-    
-    if (m_telemetry.timestamp == 0) {
-        timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    }
-    
-    painter->setFont(m_style.telemetryFont);
-    painter->setPen(m_style.textColor);
+const QImage& VideoOverlayRenderer::recordingImage() {
+    if (!m_recordingImage.isNull()) return m_recordingImage;
     
-    QFontMetrics fm(m_style.telemetryFont);
-    int textWidth = fm.horizontalAdvance(timestamp);
-    
-    int x = frameSize.width() - textWidth - 10;
-    int y = frameSize.height() - 10;
+    // A dot of radius 8 with "REC" 15 px right of its centre; the offset
+    // places the image relative to the dot's centre
+    QFontMetrics fm(m_style.labelFont);
+    const int top = qMin(-10, 5 - fm.ascent());
+    const int bottom = qMax(10, 5 + fm.descent() + 1);
+    QImage image(25 + fm.horizontalAdvance("REC") + 2, bottom - top,
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
     
-    // Draw background
-    QRect bgRect(x - 2, y - fm.height(), textWidth + 4, fm.height() + 4);
-    painter->fillRect(bgRect, m_style.textBackgroundColor);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(10, -top);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(Qt::red);
+    painter.drawEllipse(QPoint(0, 0), 8, 8);
+    painter.setFont(m_style.labelFont);
+    painter.setPen(Qt::white);
+    painter.drawText(15, 5, "REC");
+    painter.end();
     
-    // Draw text
-    painter->drawText(x, y, timestamp);
+    image.setOffset(QPoint(-10, top));
+    m_recordingImage = image;
+    return m_recordingImage;
 }
 
 QColor VideoOverlayRenderer::colorForClassification(TrackClassification cls) const {
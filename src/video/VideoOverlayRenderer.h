@@ -6,10 +6,17 @@
 #include <QPainter>
 #include <QFont>
 #include <QColor>
+#include <QHash>
+#include <QRegion>
+#include <QVector>
+#include <functional>
 #include "core/Track.h"
+#include "core/TrackSnapshot.h"
 
 namespace CounterUAS {
 
+class TrackStateHistory;
+
 /**
  * @brief Overlay style configuration
  */
@@ -68,6 +75,21 @@ struct TrackOverlay {
 
 /**
  * @brief Video overlay renderer for drawing on video frames
+ *
+ * The overlay is kept as a scene of items (one per track, the crosshairs,
+ * the telemetry bar, the recording indicator and the timestamp), each with
+ * a content key and the frame pixels it covers. updateLayer() diffs the
+ * scene against the last one and repaints only the items whose key changed,
+ * plus whatever overlaps them, into a retained transparent layer. Text is
+ * rasterised once into cached glyph images and only rebuilt when it
+ * changes. Displays composite the layer over the frame (VideoGLView blends
+ * it on the GPU) so the frame itself is never painted into.
+ *
+ * With a TrackStateHistory the track boxes are aligned to the frame
+ * rather than set: each scene takes every track's state interpolated to
+ * the capture time given with setFrameTime() and places it through the
+ * projector, so with video a few hundred milliseconds behind the track
+ * picture the boxes sit on the targets instead of leading them.
  */
 class VideoOverlayRenderer : public QObject {
     Q_OBJECT
@@ -89,6 +111,16 @@ public:
     void removeTrackOverlay(const QString& trackId);
     void clearTrackOverlays();
     
+    // Frame-aligned tracks: the projector fills in the box and range of a
+    // track's state at timeMs, false to leave it out. While a history is
+    // set, setTrackOverlays() and the like are superseded. Both outlive
+    // the renderer or are cleared with nullptr first
+    using TrackProjector = std::function<bool(const TrackSnapshot& state, qint64 timeMs,
+                                              const QSize& frameSize, TrackOverlay& overlay)>;
+    void setTrackHistory(const TrackStateHistory* history, TrackProjector projector);
+    // Capture time of the frame the next layer goes over; 0 for the newest state
+    void setFrameTime(qint64 captureMs) { m_frameTimeMs = captureMs; }
+    
     // Selected track
     void setSelectedTrack(const QString& trackId);
     QString selectedTrack() const { return m_selectedTrackId; }
@@ -98,20 +130,59 @@ public:
     void clearDesignationPoint();
     bool hasDesignation() const { return m_hasDesignation; }
     
-    // Render overlay onto frame
+    // Render overlay onto frame. The QImage overload composites the layer
+    // onto a copy; the QPainter overload draws the scene immediately.
     QImage renderOverlay(const QImage& frame);
     void renderOverlay(QPainter* painter, const QSize& frameSize);
     
+    // Retained layer: premultiplied ARGB of frameSize, transparent where
+    // there is no overlay. Repaints what changed since the last call and
+    // returns that region, empty when nothing did.
+    QRegion updateLayer(const QSize& frameSize);
+    const QImage& layer() const { return m_layer; }
+    
+    // Bumped by every updateLayer() that repaints something
+    quint64 layerRevision() const { return m_layerRevision; }
+    // Bounds of everything repainted after revision, for consumers that
+    // upload the layer; the whole layer when revision is too old
+    QRect layerChangedSince(quint64 revision) const;
+    
 signals:
     void trackClicked(const QString& trackId);
     
 private:
-    void drawTrackBox(QPainter* painter, const TrackOverlay& track, const QSize& frameSize);
-    void drawTrackLabel(QPainter* painter, const TrackOverlay& track, const QSize& frameSize);
-    void drawCrosshairs(QPainter* painter, const QPointF& point, const QSize& frameSize);
-    void drawTelemetryBar(QPainter* painter, const QSize& frameSize);
-    void drawRecordingIndicator(QPainter* painter, const QSize& frameSize);
-    void drawTimestamp(QPainter* painter, const QSize& frameSize);
+    enum class ItemKind { Track, Crosshairs, Telemetry, Recording, Timestamp };
+    
+    struct SceneItem {
+        QString id;
+        ItemKind kind = ItemKind::Track;
+        QString key;        // Everything the item's pixels depend on
+        QRect bounds;       // Frame pixels it may touch
+        int track = -1;     // Index into m_tracks for this scene only
+        QImage text;        // Cached glyphs, drawn with their top left at pos
+        QPoint pos;         // Or the crosshairs' centre
+    };
+    
+    struct CachedText {
+        QString text;
+        QImage image;
+    };
+    
+    static constexpr int LAYER_HISTORY = 16;
+    
+    QVector<SceneItem> buildScene(const QSize& frameSize);
+    void alignTracks(const QSize& frameSize);
+    void pruneLabelCache();
+    void drawItem(QPainter* painter, const SceneItem& item);
+    void drawTrackBox(QPainter* painter, const TrackOverlay& track);
+    void drawCrosshairs(QPainter* painter, const QPoint& center);
+    void invalidateLayer();
+    
+    // Text on its background, rebuilt only when text differs from the cache
+    const QImage& textImage(CachedText& cache, const QString& text, const QFont& font);
+    const QImage& recordingImage();
+    
+    QString trackLabel(const TrackOverlay& track) const;
     
     QColor colorForClassification(TrackClassification cls) const;
     QString classificationLabel(TrackClassification cls) const;
@@ -120,10 +191,25 @@ private:
     OverlayStyle m_style;
     OverlayTelemetry m_telemetry;
     QList<TrackOverlay> m_tracks;
+    const TrackStateHistory* m_history = nullptr;
+    TrackProjector m_projector;
+    qint64 m_frameTimeMs = 0;
+    QVector<TrackSnapshot> m_states;            // Reused by alignTracks()
     QString m_selectedTrackId;
     
     bool m_hasDesignation = false;
     QPointF m_designationPoint;
+    
+    QHash<QString, CachedText> m_labelCache;    // By track id
+    CachedText m_telemetryText;
+    CachedText m_timestampText;
+    QImage m_recordingImage;
+    
+    QImage m_layer;
+    QHash<QString, SceneItem> m_drawn;          // What the layer holds, by item id
+    bool m_layerValid = false;
+    quint64 m_layerRevision = 0;
+    QVector<QRect> m_layerHistory;              // Changed bounds, newest last
 };
 
 } // namespace CounterUAS
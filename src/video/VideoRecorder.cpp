@@ -1,23 +1,82 @@
 #include "video/VideoRecorder.h"
+#include "video/MatroskaWriter.h"
+#include "video/RecordingStorage.h"
 #include "utils/Logger.h"
+#include "utils/MemoryGovernor.h"
+#include "utils/TimeUtils.h"
+#include "utils/Trace.h"
 #include <QDateTime>
 #include <QFileInfo>
 #include <QDir>
-#include <QBuffer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
 
 namespace CounterUAS {
 
+namespace {
+
+// How long a metadata block shows when recordings are not segmented
+constexpr qint64 METADATA_HOLD_MS = 3600 * 1000;
+
+// Left of a reserved segment when it rolls over, for the frames in flight
+constexpr qint64 MIN_RESERVE_HEADROOM = 256 * 1024;
+
+QByteArray metadataJson(const FrameMetadata& metadata, qint64 frameTimestamp) {
+    QJsonObject json;
+    json["timestamp"] = metadata.timestamp > 0 ? metadata.timestamp : frameTimestamp;
+    if (!metadata.trackId.isEmpty()) json["trackId"] = metadata.trackId;
+    if (!metadata.operatorNote.isEmpty()) json["operatorNote"] = metadata.operatorNote;
+    if (!metadata.customData.isEmpty()) {
+        json["custom"] = QJsonObject::fromVariantMap(metadata.customData);
+    }
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
 VideoRecorder::VideoRecorder(QObject* parent)
     : QObject(parent)
 {
+    setConfig(m_config);
+    
+    // Under memory pressure the pre-event ring is halved per level. Buffered
+    // video is evidence once an event fires, so it is shed last, and never
+    // while an event clip is being cut from it
+    m_memoryConsumer = MemoryGovernor::instance().registerConsumer(this, "video.preBuffer",
+        MemoryShedOrder::PreBuffer, 0,
+        [this]() { return qint64(m_preBufferCapacity.load(std::memory_order_relaxed)); },
+        [this](MemoryPressure pressure) {
+            m_preBufferShift = static_cast<int>(pressure);
+            if (!m_eventRecording && !m_eventClipOpen) {
+                setConfig(m_config);
+            }
+        });
 }
 
 VideoRecorder::~VideoRecorder() {
+    MemoryGovernor::instance().unregisterConsumer(m_memoryConsumer);
     stop();
+    stopWriter();
+    closeClip();
 }
 
 void VideoRecorder::setConfig(const RecorderConfig& config) {
+    stopWriter();
     m_config = config;
+    m_activeConfig = config;
+    resetPreBuffer();
+    m_preRing.setCapacity((qMax(0, config.preBufferMegabytes) * 1024 * 1024) >> m_preBufferShift);
+    m_preRing.setMaxSpanMs((qint64(qMax(0, config.preBufferSeconds)) * 1000) >> m_preBufferShift);
+    m_preBufferCapacity.store(m_preRing.capacity(), std::memory_order_relaxed);
+    startWriter();
+}
+
+void VideoRecorder::setStorage(RecordingStorage* storage, const QString& cameraId) {
+    stopWriter();
+    m_storage = storage;
+    m_cameraId = cameraId;
+    startWriter();
 }
 
 bool VideoRecorder::start(const QString& outputPath) {
@@ -25,8 +84,6 @@ bool VideoRecorder::start(const QString& outputPath) {
         stop();
     }
     
-    m_outputPath = outputPath;
-    
     // Ensure output directory exists
     QFileInfo fileInfo(outputPath);
     QDir dir = fileInfo.dir();
@@ -37,18 +94,26 @@ bool VideoRecorder::start(const QString& outputPath) {
         }
     }
     
-    // In a real implementation, initialize video encoder here
-    // For now, we just open a placeholder file
-    m_outputFile = new QFile(outputPath);
-    if (!m_outputFile->open(QIODevice::WriteOnly)) {
-        emit error("Failed to open output file: " + m_outputFile->errorString());
-        delete m_outputFile;
-        m_outputFile = nullptr;
-        return false;
+    stopWriter();
+    m_outputPath = outputPath;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_segmentPath.clear();
+        m_position = RecordingPosition();
+        m_encodeLatency = LatencyStats();
+        // The first segment carries whatever metadata is current
+        m_metadataPending = m_config.embedMetadata;
     }
+    m_framesWritten = 0;
+    m_framesDropped = 0;
+    m_encodeFailures = 0;
+    m_bytesWritten = 0;
+    m_segments = 0;
+    m_fallbackWarned = false;
+    m_activeConfig = m_config;
+    startWriter();
     
     m_recording = true;
-    m_frameCount = 0;
     m_startTime = QDateTime::currentMSecsSinceEpoch();
     
     Logger::instance().info("VideoRecorder",
@@ -61,34 +126,58 @@ bool VideoRecorder::start(const QString& outputPath) {
 void VideoRecorder::stop() {
     if (!m_recording) return;
     
+    const qint64 duration = recordedDuration();
     m_recording = false;
     
-    finalizeRecording();
-    
-    if (m_outputFile) {
-        m_outputFile->close();
-        delete m_outputFile;
-        m_outputFile = nullptr;
-    }
+    // The writer drains what is queued and closes the segment; the
+    // pre-event buffer picks up again with the next frame
+    stopWriter();
+    startWriter();
     
+    const RecorderStats current = stats();
     Logger::instance().info("VideoRecorder",
-                           QString("Stopped recording. Frames: %1, Duration: %2s")
-                               .arg(m_frameCount)
-                               .arg(recordedDuration() / 1000.0, 0, 'f', 1));
+                           QString("Stopped recording. Frames: %1, Dropped: %2, "
+                                   "Segments: %3, Duration: %4s")
+                               .arg(current.framesWritten)
+                               .arg(current.framesDropped)
+                               .arg(current.segments)
+                               .arg(duration / 1000.0, 0, 'f', 1));
     
     emit recordingChanged(false);
 }
 
+QString VideoRecorder::currentSegmentPath() const {
+    QMutexLocker locker(&m_mutex);
+    return m_segmentPath;
+}
+
+RecordingPosition VideoRecorder::recordingPosition() const {
+    QMutexLocker locker(&m_mutex);
+    return m_position;
+}
+
 qint64 VideoRecorder::recordedDuration() const {
     if (!m_recording) return 0;
     return QDateTime::currentMSecsSinceEpoch() - m_startTime;
 }
 
-qint64 VideoRecorder::fileSize() const {
-    if (m_outputFile) {
-        return m_outputFile->size();
+RecorderStats VideoRecorder::stats() const {
+    RecorderStats stats;
+    {
+        QMutexLocker locker(&m_mutex);
+        stats.encoderBackend = m_encoderName;
+        stats.hardwareEncoder = m_encoderHardware;
+        stats.queueDepth = m_frameQueue.size();
+        stats.encodeLatency = m_encodeLatency;
     }
-    return 0;
+    stats.framesWritten = m_framesWritten.load();
+    stats.framesDropped = m_framesDropped.load();
+    stats.encodeFailures = m_encodeFailures.load();
+    stats.segments = m_segments.load();
+    stats.bytesWritten = m_bytesWritten.load();
+    stats.preBufferBytes = m_preBufferBytes.load();
+    stats.preBufferMs = m_preBufferMs.load();
+    return stats;
 }
 
 void VideoRecorder::startEventRecording(const QString& eventId) {
@@ -97,11 +186,19 @@ void VideoRecorder::startEventRecording(const QString& eventId) {
     m_eventRecording = true;
     m_currentEventId = eventId;
     
-    // Copy pre-buffer frames to recording
-    QMutexLocker locker(&m_mutex);
-    while (!m_preBuffer.isEmpty()) {
-        auto frame = m_preBuffer.dequeue();
-        m_frameQueue.enqueue(frame);
+    if (m_recording) {
+        // Already on disk; the clip is the current segment
+        m_clipPath = currentSegmentPath();
+        if (m_clipPath.isEmpty()) m_clipPath = m_outputPath;
+    } else if (!m_eventClipOpen) {
+        // A clip still in its post-event buffer simply carries on
+        m_clipPath = eventClipPath(eventId);
+        m_eventClipOpen = true;
+        
+        QueuedFrame command;
+        command.action = QueuedFrame::Action::StartEvent;
+        command.clipPath = m_clipPath;
+        enqueue(command, false);
     }
     
     Logger::instance().info("VideoRecorder",
@@ -114,79 +211,492 @@ void VideoRecorder::stopEventRecording() {
     if (!m_eventRecording) return;
     
     m_eventRecording = false;
-    
-    QString clipPath = m_outputPath;  // Would create separate clip file
+    m_postBufferUntil = m_lastTimestamp + qint64(m_config.postBufferSeconds) * 1000;
     
     Logger::instance().info("VideoRecorder",
                            "Stopped event recording: " + m_currentEventId);
     
-    emit eventRecordingStopped(m_currentEventId, clipPath);
+    emit eventRecordingStopped(m_currentEventId, m_clipPath);
     m_currentEventId.clear();
 }
 
 void VideoRecorder::setMetadata(const FrameMetadata& metadata) {
+    QMutexLocker locker(&m_mutex);
     m_currentMetadata = metadata;
+    m_metadataPending = m_config.embedMetadata;
+}
+
+void VideoRecorder::setSensorMetadata(const SensorMetadata& metadata) {
+    QMutexLocker locker(&m_mutex);
+    m_currentSensor = metadata;
+    m_haveSensor = true;
 }
 
 void VideoRecorder::addFrame(const QImage& frame, qint64 timestamp) {
-    if (!m_recording && !m_eventRecording) {
-        // Add to pre-buffer for event recording
-        QMutexLocker locker(&m_mutex);
-        m_preBuffer.enqueue(qMakePair(frame, timestamp));
-        
-        // Trim pre-buffer
-        int maxPreBufferFrames = static_cast<int>(m_config.preBufferSeconds * m_config.fps);
-        while (m_preBuffer.size() > maxPreBufferFrames) {
-            m_preBuffer.dequeue();
-        }
-        return;
+    addVideoFrame(VideoFrame(frame), timestamp);
+}
+
+void VideoRecorder::addVideoFrame(const VideoFrame& frame, qint64 timestamp) {
+    if (frame.isNull()) return;
+    m_lastTimestamp = timestamp;
+    
+    if (m_eventClipOpen && !m_eventRecording && timestamp >= m_postBufferUntil) {
+        QueuedFrame command;
+        command.action = QueuedFrame::Action::EndEvent;
+        enqueue(command, false);
+        m_eventClipOpen = false;
     }
     
+    QueuedFrame queued;
+    if (m_recording) {
+        queued.action = QueuedFrame::Action::Segment;
+    } else if (m_eventClipOpen) {
+        queued.action = QueuedFrame::Action::EventClip;
+    } else if (m_config.preBufferSeconds > 0 && m_config.preBufferMegabytes > 0) {
+        queued.action = QueuedFrame::Action::PreBuffer;
+    } else {
+        return;
+    }
+    queued.frame = frame;
+    queued.timestamp = timestamp;
+    queued.queuedNs = TimeUtils::monotonicNs();
+    enqueue(queued, true);
+}
+
+void VideoRecorder::enqueue(QueuedFrame queued, bool bounded) {
     QMutexLocker locker(&m_mutex);
-    m_frameQueue.enqueue(qMakePair(frame, timestamp));
+    if (bounded && m_frameQueue.size() >= qMax(1, m_config.queueCapacity)) {
+        // Keep what is queued: dropping from the middle of the backlog would
+        // leave gaps the encoder has already committed to
+        m_framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
     
-    // Process queue
+    if (bounded && m_metadataPending) {
+        queued.hasMetadata = true;
+        queued.metadata = m_currentMetadata;
+        m_metadataPending = false;
+    }
+    if (bounded && m_haveSensor && m_config.embedKlv) {
+        queued.hasSensor = true;
+        queued.sensor = m_currentSensor;
+    }
+    m_frameQueue.enqueue(std::move(queued));
     locker.unlock();
-    processWriteQueue();
+    m_queueNotEmpty.wakeOne();
 }
 
-void VideoRecorder::processWriteQueue() {
-    QMutexLocker locker(&m_mutex);
+void VideoRecorder::startWriter() {
+    if (m_writerThread) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+    }
+    m_writerThread = QThread::create([this]() { writerLoop(); });
+    m_writerThread->setObjectName("VideoRecorderWriter");
+    m_writerThread->start();
+}
+
+void VideoRecorder::stopWriter() {
+    if (!m_writerThread) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+    }
+    m_queueNotEmpty.wakeAll();
+    m_writerThread->wait();
+    delete m_writerThread;
+    m_writerThread = nullptr;
+}
+
+QString VideoRecorder::eventClipPath(const QString& eventId) const {
+    QDir dir(m_config.eventDirectory);
+    if (m_config.eventDirectory.isEmpty()) {
+        dir = m_outputPath.isEmpty() ? QDir::current() : QFileInfo(m_outputPath).dir();
+    }
+    if (!dir.exists()) dir.mkpath(".");
     
-    while (!m_frameQueue.isEmpty()) {
-        auto framePair = m_frameQueue.dequeue();
-        locker.unlock();
+    QString id = eventId;
+    id.replace(QRegularExpression("[^A-Za-z0-9_-]"), "_");
+    return dir.filePath(QString("event_%1_%2.mkv")
+                            .arg(id, QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+}
+
+void VideoRecorder::writerLoop() {
+    forever {
+        QueuedFrame queued;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_frameQueue.isEmpty() && !m_stopping) {
+                m_queueNotEmpty.wait(&m_mutex);
+            }
+            if (m_frameQueue.isEmpty()) break;    // Stopping and drained
+            queued = m_frameQueue.dequeue();
+        }
+        
+        if (queued.hasMetadata) {
+            m_lastMetadata = queued.metadata;
+            m_haveMetadata = true;
+        }
         
-        writeFrame(framePair.first, framePair.second);
+        switch (queued.action) {
+        case QueuedFrame::Action::Segment:
+            writeFrame(queued);
+            break;
+        case QueuedFrame::Action::PreBuffer:
+            bufferFrame(queued);
+            break;
+        case QueuedFrame::Action::EventClip:
+            writeClipFrame(queued);
+            break;
+        case QueuedFrame::Action::StartEvent:
+            openClip(queued.clipPath);
+            break;
+        case QueuedFrame::Action::EndEvent:
+            closeClip();
+            break;
+        }
+    }
+    closeSegment();
+}
+
+void VideoRecorder::writeFrame(const QueuedFrame& queued) {
+    CUAS_TRACE_SCOPE("video", "VideoRecorder::writeFrame");
+    // Everything is reaching the disk; nothing to hold back for an event
+    if (m_preEncoder) resetPreBuffer();
+    
+    const QSize size = queued.frame.size();
+    const qint64 segmentMs = qint64(m_activeConfig.segmentSeconds) * 1000;
+    
+    const qint64 headroom = qMax<qint64>(MIN_RESERVE_HEADROOM, 4 * qint64(m_largestPacket));
+    const bool rollOver = m_writer &&
+        ((segmentMs > 0 && queued.timestamp - m_segmentStart >= segmentMs) ||
+         (m_segmentReserve > 0 && m_writer->bytesWritten() + headroom >= m_segmentReserve));
+    if (m_writer && (rollOver || size != m_encoderSize)) {
+        closeSegment();
+    }
+    bool newSegment = false;
+    if (!m_writer) {
+        if (!openSegment(size, queued.timestamp)) {
+            m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        newSegment = true;
+    }
+    
+    // A new segment repeats the metadata so it stands alone
+    if (queued.hasMetadata || newSegment) writeMetadata(*m_writer, queued.timestamp);
+    
+    m_packets.clear();
+    if (!m_encoder->encode(queued.frame, queued.timestamp, m_packets)) {
+        m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (mux(*m_writer)) {
+        writeKlv(*m_writer, queued);
+        frameWritten(queued);
+    }
+    
+    // Published once a cluster, for indexes that point into the recording
+    if (m_writer->keyClusterOffset() != m_keyClusterOffset) {
+        m_keyClusterOffset = m_writer->keyClusterOffset();
+        QMutexLocker locker(&m_mutex);
+        m_position.segmentPath = m_segmentPath;
+        m_position.byteOffset = m_keyClusterOffset;
+        m_position.timeMs = m_writer->keyClusterTimeMs();
+    }
+}
+
+void VideoRecorder::bufferFrame(const QueuedFrame& queued) {
+    const QSize size = queued.frame.size();
+    if (m_preEncoder && size != m_preEncoderSize) resetPreBuffer();
+    if (!m_preEncoder) {
+        m_preEncoder = createEncoder(size);
+        if (!m_preEncoder) return;
+        m_preEncoderSize = size;
+    }
+    
+    m_packets.clear();
+    if (!m_preEncoder->encode(queued.frame, queued.timestamp, m_packets)) {
+        m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    for (const EncodedPacket& packet : m_packets) {
+        m_preRing.push(packet);
+    }
+    m_preBufferBytes.store(m_preRing.bytesUsed());
+    m_preBufferMs.store(m_preRing.spanMs());
+}
+
+void VideoRecorder::writeClipFrame(const QueuedFrame& queued) {
+    const QSize size = queued.frame.size();
+    if (!m_clipWriter) {
+        if (m_pendingClipPath.isEmpty()) return;
         
-        locker.relock();
+        m_clipEncoder = createEncoder(size);
+        if (!m_clipEncoder) return;
+        m_clipSize = size;
+        openClip(m_pendingClipPath);
+        if (!m_clipWriter) return;
+    }
+    if (size != m_clipSize) {
+        // One clip is one stream; its encoder cannot change size midway
+        m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    
+    if (queued.hasMetadata) writeMetadata(*m_clipWriter, queued.timestamp);
+    
+    m_packets.clear();
+    if (!m_clipEncoder->encode(queued.frame, queued.timestamp, m_packets)) {
+        m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (mux(*m_clipWriter)) {
+        writeKlv(*m_clipWriter, queued);
+        frameWritten(queued);
     }
 }
 
-void VideoRecorder::writeFrame(const QImage& frame, qint64 timestamp) {
-    Q_UNUSED(timestamp)
+void VideoRecorder::openClip(const QString& path) {
+    if (m_clipWriter) closeClip();
     
-    if (!m_outputFile || !m_outputFile->isOpen()) return;
+    // The pre-event encoder carries on as the clip's, so the buffered GOPs
+    // and what follows are one stream
+    if (!m_clipEncoder && m_preEncoder && !m_preRing.isEmpty()) {
+        m_clipEncoder = std::move(m_preEncoder);
+        m_clipSize = m_preEncoderSize;
+    }
+    if (!m_clipEncoder) {
+        resetPreBuffer();
+        m_pendingClipPath = path;
+        return;
+    }
+    m_pendingClipPath.clear();
+    m_packets = m_preRing.take();
     
-    // In a real implementation, encode and write frame
-    // For simulation, just write raw image data
-    QByteArray data;
-    QBuffer buffer(&data);
-    buffer.open(QIODevice::WriteOnly);
-    frame.save(&buffer, "PNG");
+    MatroskaWriter::TrackInfo track;
+    track.codecId = m_clipEncoder->codecId();
+    track.codecPrivate = m_clipEncoder->codecPrivate();
+    track.width = m_clipSize.width();
+    track.height = m_clipSize.height();
+    track.fps = m_activeConfig.fps;
+    track.metadataTrack = m_activeConfig.embedMetadata;
+    track.klvTrack = m_activeConfig.embedKlv;
+    if (!m_packets.isEmpty()) track.startTimeUtcMs = m_packets.first().timeMs;
     
-    m_outputFile->write(data);
+    m_clipWriter.reset(new MatroskaWriter);
+    if (!m_clipWriter->open(path, track)) {
+        emit error("Failed to open event clip: " + m_clipWriter->errorString());
+        m_clipWriter.reset();
+        m_clipEncoder.reset();
+        resetPreBuffer();
+        return;
+    }
     
-    m_frameCount++;
-    emit frameRecorded(m_frameCount);
+    if (!m_packets.isEmpty()) writeMetadata(*m_clipWriter, m_packets.first().timeMs);
+    m_framesWritten.fetch_add(static_cast<quint64>(m_packets.size()), std::memory_order_relaxed);
+    mux(*m_clipWriter);
+    resetPreBuffer();
 }
 
-void VideoRecorder::initializeEncoder() {
-    // Would initialize video encoder (FFmpeg, GStreamer, etc.)
+void VideoRecorder::closeClip() {
+    m_pendingClipPath.clear();
+    if (!m_clipWriter) {
+        m_clipEncoder.reset();
+        return;
+    }
+    
+    m_packets.clear();
+    m_clipEncoder->flush(m_packets);
+    mux(*m_clipWriter);
+    m_clipEncoder->close();
+    m_clipEncoder.reset();
+    
+    m_clipWriter->close();
+    const QString path = m_clipWriter->path();
+    m_clipWriter.reset();
+    
+    emit segmentFinished(path);
 }
 
-void VideoRecorder::finalizeRecording() {
-    // Would finalize video encoding (write trailer, close codec)
+bool VideoRecorder::openSegment(const QSize& size, qint64 timestamp) {
+    m_encoder = createEncoder(size);
+    if (!m_encoder) return false;
+    m_encoderSize = size;
+    
+    const int index = m_segments.load() + 1;
+    RecordingStorage::Allocation allocation;
+    if (m_storage) {
+        allocation = m_storage->allocateSegment(m_cameraId, timestamp);
+        if (allocation.path.isEmpty()) {
+            emit error("No room for a segment in " + m_storage->cameraDirectory(m_cameraId));
+            m_encoder->close();
+            m_encoder.reset();
+            return false;
+        }
+    } else {
+        allocation.path = segmentPath(index);
+    }
+    const QString path = allocation.path;
+    
+    MatroskaWriter::TrackInfo track;
+    track.codecId = m_encoder->codecId();
+    track.codecPrivate = m_encoder->codecPrivate();
+    track.width = size.width();
+    track.height = size.height();
+    track.fps = m_activeConfig.fps;
+    track.metadataTrack = m_activeConfig.embedMetadata;
+    track.klvTrack = m_activeConfig.embedKlv;
+    track.startTimeUtcMs = timestamp;
+    
+    m_writer.reset(new MatroskaWriter);
+    m_writer->setReserve(allocation.reserveBytes);
+    m_writer->setWriteBlockSize(allocation.writeBlockBytes);
+    if (!m_writer->open(path, track)) {
+        emit error("Failed to open output file: " + m_writer->errorString());
+        if (m_storage) m_storage->abandonSegment(path);
+        m_writer.reset();
+        m_encoder->close();
+        m_encoder.reset();
+        return false;
+    }
+    
+    m_segments.store(index);
+    m_segmentStart = timestamp;
+    m_keyClusterOffset = -1;
+    m_segmentReserve = allocation.reserveBytes;
+    m_largestPacket = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_segmentPath = path;
+    }
+    return true;
+}
+
+void VideoRecorder::closeSegment() {
+    if (!m_writer) return;
+    
+    if (m_encoder) {
+        m_packets.clear();
+        m_encoder->flush(m_packets);
+        mux(*m_writer);
+        m_encoder->close();
+        m_encoder.reset();
+    }
+    
+    m_writer->close();
+    const QString path = m_writer->path();
+    if (m_storage) m_storage->finishSegment(path, m_writer->durationMs(), m_writer->bytesWritten());
+    m_writer.reset();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_position = RecordingPosition();
+    }
+    
+    emit segmentFinished(path);
+}
+
+void VideoRecorder::resetPreBuffer() {
+    if (m_preEncoder) {
+        m_preEncoder->close();
+        m_preEncoder.reset();
+    }
+    m_preRing.clear();
+    m_preBufferBytes.store(0);
+    m_preBufferMs.store(0);
+}
+
+std::unique_ptr<VideoEncoderBackend> VideoRecorder::createEncoder(const QSize& size) {
+    VideoEncoderSettings settings;
+    settings.codec = m_activeConfig.codec;
+    settings.bitrateKbps = m_activeConfig.bitrateMbps * 1000;
+    settings.quality = m_activeConfig.quality;
+    settings.fps = m_activeConfig.fps;
+    settings.size = size;
+    // A keyframe a second keeps clusters, segments and the pre-event
+    // buffer's GOPs short
+    settings.keyframeIntervalFrames = qMax(1, qRound(m_activeConfig.fps));
+    
+    const QStringList names = VideoEncoderRegistry::candidates(m_activeConfig.hardwareEncoder);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        for (const QString& name : names) {
+            std::unique_ptr<VideoEncoderBackend> backend = VideoEncoderRegistry::create(name);
+            if (backend && backend->open(settings)) {
+                QMutexLocker locker(&m_mutex);
+                m_encoderName = backend->name();
+                m_encoderHardware = backend->isHardware();
+                return backend;
+            }
+        }
+        if (settings.codec.compare("MJPEG", Qt::CaseInsensitive) == 0) break;
+        
+        if (!m_fallbackWarned) {
+            Logger::instance().warning("VideoRecorder",
+                                       QString("No encoder for %1; recording Motion JPEG")
+                                           .arg(settings.codec));
+            m_fallbackWarned = true;
+        }
+        settings.codec = "MJPEG";
+    }
+    
+    emit error("No video encoder available for " + m_activeConfig.codec);
+    return nullptr;
+}
+
+bool VideoRecorder::mux(MatroskaWriter& writer) {
+    const qint64 before = writer.bytesWritten();
+    bool ok = true;
+    for (const EncodedPacket& packet : m_packets) {
+        m_largestPacket = qMax(m_largestPacket, packet.data.size());
+        if (!writer.writeVideo(packet.data, packet.timeMs, packet.keyframe)) {
+            m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+            emit error("Failed to write recording: " + writer.errorString());
+            ok = false;
+            break;
+        }
+    }
+    m_packets.clear();
+    m_bytesWritten.fetch_add(writer.bytesWritten() - before, std::memory_order_relaxed);
+    return ok;
+}
+
+void VideoRecorder::writeMetadata(MatroskaWriter& writer, qint64 timestamp) {
+    if (!m_haveMetadata || !m_activeConfig.embedMetadata) return;
+    
+    const qint64 segmentMs = qint64(m_activeConfig.segmentSeconds) * 1000;
+    const qint64 before = writer.bytesWritten();
+    writer.writeMetadata(metadataJson(m_lastMetadata, timestamp), timestamp,
+                         segmentMs > 0 ? segmentMs : METADATA_HOLD_MS);
+    m_bytesWritten.fetch_add(writer.bytesWritten() - before, std::memory_order_relaxed);
+}
+
+void VideoRecorder::writeKlv(MatroskaWriter& writer, const QueuedFrame& queued) {
+    if (!queued.hasSensor || !m_activeConfig.embedKlv) return;
+    
+    const qint64 before = writer.bytesWritten();
+    writer.writeKlv(m_klv.encode(queued.sensor, queued.timestamp, queued.frame.size()), queued.timestamp);
+    m_bytesWritten.fetch_add(writer.bytesWritten() - before, std::memory_order_relaxed);
+}
+
+void VideoRecorder::frameWritten(const QueuedFrame& queued) {
+    const quint64 frameNumber = m_framesWritten.fetch_add(1, std::memory_order_relaxed) + 1;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_encodeLatency.record((TimeUtils::monotonicNs() - queued.queuedNs) / 1000);
+    }
+    emit frameRecorded(static_cast<qint64>(frameNumber));
+}
+
+QString VideoRecorder::segmentPath(int index) const {
+    if (m_activeConfig.segmentSeconds <= 0) return m_outputPath;
+    
+    const QFileInfo info(m_outputPath);
+    const QString suffix = info.suffix().isEmpty() ? QStringLiteral("mkv") : info.suffix();
+    return info.dir().filePath(QString("%1_%2.%3")
+                                   .arg(info.completeBaseName())
+                                   .arg(index, 4, 10, QChar('0'))
+                                   .arg(suffix));
 }
 
 } // namespace CounterUAS
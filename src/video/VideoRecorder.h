@@ -3,26 +3,41 @@
 
 #include <QObject>
 #include <QImage>
-#include <QFile>
 #include <QThread>
 #include <QMutex>
 #include <QQueue>
 #include <QWaitCondition>
 #include <QVariant>
+#include <atomic>
+#include <memory>
+
+#include "utils/LatencyStats.h"
+#include "utils/VideoFrame.h"
+#include "video/KlvEncoder.h"
+#include "video/PacketRingBuffer.h"
 
 namespace CounterUAS {
 
+class MatroskaWriter;
+class RecordingStorage;
+
 /**
  * @brief Video recording configuration
  */
 struct RecorderConfig {
-    QString codec = "H264";
+    QString codec = "H264";     // H264, H265 or MJPEG
     int quality = 80;           // 0-100
     int bitrateMbps = 8;
     double fps = 30.0;
-    bool embedMetadata = true;
-    int preBufferSeconds = 30;
+    bool embedMetadata = true;  // As a timed text track of JSON
+    bool embedKlv = true;       // Sensor metadata as a MISB ST 0601 track, a packet per frame
+    int preBufferSeconds = 30;  // 0 turns the pre-event buffer off
+    int preBufferMegabytes = 32;   // Encoded, per stream
     int postBufferSeconds = 30;
+    QString eventDirectory;     // Event clips; empty for the output path's
+    int segmentSeconds = 300;   // 0 writes one file
+    int queueCapacity = 90;     // Frames waiting for the writer
+    bool hardwareEncoder = true;
 };
 
 /**
@@ -35,8 +50,65 @@ struct FrameMetadata {
     QVariantMap customData;
 };
 
+/**
+ * @brief Recorder counters, safe to read from any thread
+ */
+struct RecorderStats {
+    QString encoderBackend;
+    bool hardwareEncoder = false;
+    quint64 framesWritten = 0;
+    quint64 framesDropped = 0;    // Queue full when they arrived
+    quint64 encodeFailures = 0;
+    int queueDepth = 0;
+    int segments = 0;
+    qint64 bytesWritten = 0;      // Segments and event clips
+    int preBufferBytes = 0;
+    qint64 preBufferMs = 0;
+    LatencyStats encodeLatency;   // Queue to muxed, microseconds
+};
+
+/**
+ * @brief Where a reader can start decoding a recorder's current segment
+ */
+struct RecordingPosition {
+    QString segmentPath;          // Empty while no segment is open
+    qint64 byteOffset = -1;       // Of its latest cluster starting on a keyframe
+    qint64 timeMs = 0;            // That cluster's first frame, UTC
+    
+    bool isValid() const { return !segmentPath.isEmpty() && byteOffset >= 0; }
+};
+
 /**
  * @brief Video recorder for saving video streams
+ *
+ * Frames are queued as they arrive and a dedicated writer thread encodes
+ * and muxes them, so the video pipeline never waits on the encoder or the
+ * disk. The queue is bounded; when the writer falls behind new frames are
+ * dropped and counted. Output is Matroska, split into segments of
+ * segmentSeconds named <base>_0001.mkv, <base>_0002.mkv, ..., each
+ * starting on a keyframe so it plays on its own. Metadata set with
+ * setMetadata() is written beside the video as a timed text track. The
+ * sensor metadata set with setSensorMetadata() goes with every frame
+ * queued after it, and the writer encodes it as a KLV packet muxed
+ * alongside the frame, so pointing and target boxes stay frame-accurate
+ * in the recording. Pre-event GOPs are buffered encoded and carry no KLV.
+ *
+ * While nothing is being recorded, frames are still encoded into a
+ * pre-event ring of at most preBufferMegabytes, evicted by whole GOPs so
+ * it always starts on a keyframe. startEventRecording() writes that ring
+ * into a new clip under eventDirectory and keeps the same encoder going,
+ * so the clip is one continuous stream from the oldest buffered keyframe
+ * to postBufferSeconds after stopEventRecording(). During a continuous
+ * recording, events simply refer to the current segment.
+ *
+ * With a RecordingStorage the segments come from it instead: preallocated
+ * files in the camera's directory, under its quotas, written in aligned
+ * blocks. A segment then also rolls over shortly before it fills its
+ * reservation, so its size on disk never changes.
+ *
+ * The encoder comes from VideoEncoderRegistry, hardware first when
+ * allowed. If nothing opens the configured codec the recorder falls back
+ * to Motion JPEG rather than lose the recording.
  */
 class VideoRecorder : public QObject {
     Q_OBJECT
@@ -46,10 +118,14 @@ public:
     explicit VideoRecorder(QObject* parent = nullptr);
     ~VideoRecorder() override;
     
-    // Configuration
+    // Configuration; restarts the pre-event buffer
     void setConfig(const RecorderConfig& config);
     RecorderConfig config() const { return m_config; }
     
+    // Segments from storage rather than the output path, which then only
+    // places event clips; before start(). The storage outlives the recorder
+    void setStorage(RecordingStorage* storage, const QString& cameraId);
+    
     // Recording control
     bool start(const QString& outputPath);
     void stop();
@@ -57,9 +133,12 @@ public:
     
     // Output
     QString outputPath() const { return m_outputPath; }
+    QString currentSegmentPath() const;
+    RecordingPosition recordingPosition() const;   // Any thread
     qint64 recordedDuration() const;
-    qint64 recordedFrameCount() const { return m_frameCount; }
-    qint64 fileSize() const;
+    qint64 recordedFrameCount() const { return static_cast<qint64>(m_framesWritten.load()); }
+    qint64 fileSize() const { return m_bytesWritten.load(); }   // All segments so far
+    RecorderStats stats() const;
     
     // Event-triggered recording
     void startEventRecording(const QString& eventId);
@@ -68,43 +147,118 @@ public:
     
     // Metadata
     void setMetadata(const FrameMetadata& metadata);
+    void setSensorMetadata(const SensorMetadata& metadata);
     
 signals:
     void recordingChanged(bool recording);
-    void frameRecorded(qint64 frameNumber);
+    void frameRecorded(qint64 frameNumber);       // From the writer thread
+    void segmentFinished(const QString& path);    // Segment or event clip, from the writer thread
     void error(const QString& message);
     void eventRecordingStarted(const QString& eventId);
     void eventRecordingStopped(const QString& eventId, const QString& clipPath);
     
 public slots:
     void addFrame(const QImage& frame, qint64 timestamp);
-    
-private slots:
-    void processWriteQueue();
+    void addVideoFrame(const VideoFrame& frame, qint64 timestamp);
     
 private:
-    void writeFrame(const QImage& frame, qint64 timestamp);
-    void initializeEncoder();
-    void finalizeRecording();
+    struct QueuedFrame {
+        enum class Action { Segment, PreBuffer, EventClip, StartEvent, EndEvent };
+        Action action = Action::Segment;
+        VideoFrame frame;
+        qint64 timestamp = 0;
+        qint64 queuedNs = 0;
+        bool hasMetadata = false;
+        FrameMetadata metadata;
+        bool hasSensor = false;
+        SensorMetadata sensor;
+        QString clipPath;           // StartEvent
+    };
+    
+    void enqueue(QueuedFrame queued, bool bounded);
+    void startWriter();
+    void stopWriter();
+    QString eventClipPath(const QString& eventId) const;
+    
+    // Writer thread
+    void writerLoop();
+    void writeFrame(const QueuedFrame& queued);
+    void bufferFrame(const QueuedFrame& queued);
+    void writeClipFrame(const QueuedFrame& queued);
+    void openClip(const QString& path);
+    void closeClip();
+    bool openSegment(const QSize& size, qint64 timestamp);
+    void closeSegment();
+    void resetPreBuffer();
+    std::unique_ptr<VideoEncoderBackend> createEncoder(const QSize& size);
+    bool mux(MatroskaWriter& writer);
+    void writeMetadata(MatroskaWriter& writer, qint64 timestamp);
+    void writeKlv(MatroskaWriter& writer, const QueuedFrame& queued);
+    void frameWritten(const QueuedFrame& queued);
+    QString segmentPath(int index) const;
     
     RecorderConfig m_config;
     QString m_outputPath;
+    RecordingStorage* m_storage = nullptr;
+    QString m_cameraId;
     
     bool m_recording = false;
     bool m_eventRecording = false;
+    bool m_eventClipOpen = false;     // Through the post-event buffer
     QString m_currentEventId;
-    qint64 m_frameCount = 0;
+    QString m_clipPath;
+    qint64 m_postBufferUntil = 0;
+    qint64 m_lastTimestamp = 0;
     qint64 m_startTime = 0;
     
-    QMutex m_mutex;
-    QQueue<QPair<QImage, qint64>> m_frameQueue;
-    QQueue<QPair<QImage, qint64>> m_preBuffer;
-    
+    mutable QMutex m_mutex;
+    QWaitCondition m_queueNotEmpty;
+    QQueue<QueuedFrame> m_frameQueue;
+    bool m_stopping = false;
     FrameMetadata m_currentMetadata;
+    bool m_metadataPending = false;   // Rides on the next queued frame
+    SensorMetadata m_currentSensor;
+    bool m_haveSensor = false;        // Rides on every queued frame
+    QString m_segmentPath;
+    RecordingPosition m_position;
+    QString m_encoderName;
+    bool m_encoderHardware = false;
+    LatencyStats m_encodeLatency;
+    
+    std::atomic<quint64> m_framesWritten{0};
+    std::atomic<quint64> m_framesDropped{0};
+    std::atomic<quint64> m_encodeFailures{0};
+    std::atomic<qint64> m_bytesWritten{0};
+    std::atomic<int> m_segments{0};
+    std::atomic<int> m_preBufferBytes{0};
+    std::atomic<qint64> m_preBufferMs{0};
+    std::atomic<int> m_preBufferCapacity{0};  // Allocated for the ring
+    int m_preBufferShift = 0;         // Memory pressure level, halving the ring per step
+    quint64 m_memoryConsumer = 0;     // MemoryGovernor id for the ring
     
-    // Placeholder for actual encoder
-    QFile* m_outputFile = nullptr;
+    // Owned by the writer thread while it runs; it is stopped around
+    // anything that changes them from outside
     QThread* m_writerThread = nullptr;
+    RecorderConfig m_activeConfig;
+    std::unique_ptr<VideoEncoderBackend> m_encoder;
+    std::unique_ptr<MatroskaWriter> m_writer;
+    QSize m_encoderSize;
+    qint64 m_segmentStart = 0;
+    qint64 m_segmentReserve = 0;
+    qint64 m_keyClusterOffset = -1;   // Last published in m_position
+    int m_largestPacket = 0;          // In the current segment
+    std::unique_ptr<VideoEncoderBackend> m_preEncoder;
+    QSize m_preEncoderSize;
+    PacketRingBuffer m_preRing;
+    std::unique_ptr<VideoEncoderBackend> m_clipEncoder;
+    std::unique_ptr<MatroskaWriter> m_clipWriter;
+    QString m_pendingClipPath;        // Opens with its first frame
+    QSize m_clipSize;
+    QVector<EncodedPacket> m_packets;
+    FrameMetadata m_lastMetadata;
+    bool m_haveMetadata = false;
+    KlvEncoder m_klv;
+    bool m_fallbackWarned = false;
 };
 
 } // namespace CounterUAS
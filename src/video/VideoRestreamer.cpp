@@ -0,0 +1,898 @@
+#include "video/VideoRestreamer.h"
+#include "video/RtpPacketizer.h"
+#include "video/VideoOverlayRenderer.h"
+#include "video/VideoStreamManager.h"
+#include "utils/Logger.h"
+#include "utils/TimeUtils.h"
+#include "utils/Trace.h"
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPair>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QUrl>
+#include <QtEndian>
+#include <cstring>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr quint64 NTP_UNIX_OFFSET = 2208988800ULL;
+constexpr int RTP_CLOCK_KHZ = 90;
+constexpr int SENDER_REPORT_SIZE = 28;
+constexpr int MJPEG_MAX_SIDE = 2032;        // RFC 2435's 2040, on the macroblock grid
+constexpr int KLV_PAYLOAD_TYPE = 97;
+constexpr int MIN_KLV_PAYLOAD = 64;
+
+qint64 nowMs() {
+    return TimeUtils::monotonicNs() / 1000000;
+}
+
+// On the 16-pixel macroblock grid, which 4:2:0 JPEG shares
+QSize rungSize(const RestreamRung& rung, const QSize& sourceSize, const QString& codec) {
+    const double scale = qBound(0.05, rung.scale, 1.0);
+    QSize size(qMax(16, qRound(sourceSize.width() * scale / 16.0) * 16),
+               qMax(16, qRound(sourceSize.height() * scale / 16.0) * 16));
+    if (codec.compare("MJPEG", Qt::CaseInsensitive) == 0 &&
+        (size.width() > MJPEG_MAX_SIDE || size.height() > MJPEG_MAX_SIDE)) {
+        size = size.scaled(MJPEG_MAX_SIDE, MJPEG_MAX_SIDE, Qt::KeepAspectRatio);
+        size = QSize(qMax(16, size.width() / 16 * 16), qMax(16, size.height() / 16 * 16));
+    }
+    return size;
+}
+
+using Headers = QList<QPair<QByteArray, QByteArray>>;
+
+QByteArray header(const Headers& headers, const QByteArray& name) {
+    for (const auto& h : headers) {
+        if (h.first == name) return h.second;
+    }
+    return QByteArray();
+}
+
+QByteArray rtspResponse(const char* status, const QByteArray& cseq, const QByteArray& headers,
+                        const QByteArray& body = QByteArray()) {
+    QByteArray out;
+    out.reserve(128 + headers.size() + body.size());
+    out.append("RTSP/1.0 ").append(status).append("\r\n");
+    out.append("CSeq: ").append(cseq).append("\r\n");
+    out.append("Server: CounterUAS-C2/1.0\r\n");
+    out.append(headers);
+    if (!body.isEmpty()) out.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+    out.append("\r\n");
+    out.append(body);
+    return out;
+}
+
+} // namespace
+
+VideoRestreamer::VideoRestreamer(QObject* parent)
+    : QObject(parent)
+{
+    for (int i = 0; i < MAX_RUNGS; ++i) {
+        m_rungDemand[i] = 0;
+        m_keyframeWanted[i] = false;
+    }
+}
+
+VideoRestreamer::~VideoRestreamer() {
+    setVideoManager(nullptr);
+    stop();
+}
+
+void VideoRestreamer::setConfig(const RestreamConfig& config) {
+    const bool running = isRunning();
+    if (running) stop();
+    m_config = config;
+    if (m_config.ladder.isEmpty()) m_config.ladder.append(RestreamRung());
+    if (m_config.ladder.size() > MAX_RUNGS) m_config.ladder.resize(MAX_RUNGS);
+    if (m_videoManager && m_subscription) {
+        VideoDeliveryPolicy policy;
+        policy.maxFps = m_config.fps;
+        m_videoManager->setDeliveryPolicy(m_subscription, policy);
+    }
+    if (running) start(m_requestedPort, m_address);
+}
+
+RestreamConfig VideoRestreamer::config() const {
+    return m_config;
+}
+
+bool VideoRestreamer::start(quint16 port, const QHostAddress& address) {
+    if (m_thread) return true;
+    m_requestedPort = port;
+    m_address = address;
+    for (int i = 0; i < MAX_RUNGS; ++i) {
+        m_rungDemand[i] = 0;
+        m_keyframeWanted[i] = false;
+    }
+
+    m_thread = new QThread(this);
+    m_thread->setObjectName("VideoRestreamer");
+    m_context = new QObject;
+    m_context->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread->start();
+
+    bool listening = false;
+    QMetaObject::invokeMethod(m_context, [this, port, address, &listening]() {
+        QTcpServer* server = new QTcpServer(m_context);
+        if (!server->listen(address, port)) {
+            m_error = server->errorString();
+            delete server;
+            return;
+        }
+        m_port = server->serverPort();
+        connect(server, &QTcpServer::newConnection, m_context, [this, server]() {
+            while (server->hasPendingConnections()) {
+                serve(server->nextPendingConnection());
+            }
+        });
+        listening = true;
+    }, Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        Logger::instance().error("VideoRestreamer",
+                                 QString("Cannot listen on port %1: %2").arg(port).arg(m_error));
+        stop();
+        return false;
+    }
+    m_error.clear();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = false;
+        m_hasPending = false;
+        m_codec.clear();
+        m_payloadType = -1;
+        m_encoderName.clear();
+        m_encoderHardware = false;
+    }
+    m_encoderThread = QThread::create([this]() { encoderLoop(); });
+    m_encoderThread->setObjectName("VideoRestreamerEncoder");
+    m_encoderThread->start();
+
+    Logger::instance().info("VideoRestreamer",
+                            QString("Re-streaming at rtsp://<host>:%1/%2").arg(m_port).arg(m_config.path));
+    return true;
+}
+
+void VideoRestreamer::stop() {
+    // The encoder first, so nothing is posted to the server once it goes
+    if (m_encoderThread) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stopping = true;
+            m_pendingFrame = VideoFrame();
+            m_pendingLayer = QImage();
+        }
+        m_frameReady.wakeAll();
+        m_encoderThread->wait();
+        delete m_encoderThread;
+        m_encoderThread = nullptr;
+    }
+    if (!m_thread) return;
+
+    // The server and any open connections go with the context
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_context = nullptr;
+    m_port = 0;
+
+    m_links.clear();
+    m_connections = 0;
+    m_klvSubscribers = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_linkStats.clear();
+    }
+    if (m_subscribers.exchange(0) > 0) emit subscribersChanged(0);
+}
+
+void VideoRestreamer::setVideoManager(VideoStreamManager* manager) {
+    if (m_videoManager) {
+        disconnect(m_videoManager, nullptr, this, nullptr);
+        if (m_subscription) m_videoManager->unsubscribeFrames(m_subscription);
+    }
+    m_subscription = 0;
+    m_videoManager = manager;
+    if (!manager) return;
+
+    connect(manager, &VideoStreamManager::primaryStreamChanged, this, &VideoRestreamer::follow);
+    connect(manager, &VideoStreamManager::sensorMetadataChanged, this,
+            [this](const QString& cameraId, const SensorMetadata& metadata) {
+                if (cameraId == m_followed) setSensorMetadata(metadata);
+            });
+    follow(manager->primaryStreamId());
+}
+
+void VideoRestreamer::follow(const QString& cameraId) {
+    if (m_videoManager && m_subscription) m_videoManager->unsubscribeFrames(m_subscription);
+    m_subscription = 0;
+    m_followed = cameraId;
+    {
+        // Another camera's pointing says nothing about this one's
+        QMutexLocker locker(&m_mutex);
+        m_hasSensor = false;
+    }
+    if (!m_videoManager || cameraId.isEmpty()) return;
+
+    // Native size: the top rung is the source's own resolution
+    VideoDeliveryPolicy policy;
+    policy.maxFps = m_config.fps;
+    m_subscription = m_videoManager->subscribeFrames(
+        cameraId, this, policy,
+        [this](const VideoFrame& frame, qint64 timestamp, const QSize&) { addVideoFrame(frame, timestamp); });
+}
+
+void VideoRestreamer::setOverlayRenderer(VideoOverlayRenderer* renderer) {
+    m_overlay = renderer;
+}
+
+int VideoRestreamer::subscriberCount() const {
+    return m_subscribers.load(std::memory_order_relaxed);
+}
+
+RestreamStats VideoRestreamer::stats() const {
+    RestreamStats s;
+    s.framesIn = m_framesIn.load(std::memory_order_relaxed);
+    s.framesCoalesced = m_framesCoalesced.load(std::memory_order_relaxed);
+    s.framesEncoded = m_framesEncoded.load(std::memory_order_relaxed);
+    s.encodeFailures = m_encodeFailures.load(std::memory_order_relaxed);
+    s.packetsSent = m_packetsSent.load(std::memory_order_relaxed);
+    s.bytesSent = m_bytesSent.load(std::memory_order_relaxed);
+    s.rungChanges = m_rungChanges.load(std::memory_order_relaxed);
+    s.klvPacketsSent = m_klvPacketsSent.load(std::memory_order_relaxed);
+    s.rungSubscribers.fill(0, m_config.ladder.size());
+
+    QMutexLocker locker(&m_mutex);
+    s.encoderBackend = m_encoderName;
+    s.hardwareEncoder = m_encoderHardware;
+    s.codec = m_codec;
+    s.links = m_linkStats;
+    s.encodeLatency = m_encodeLatency;
+    for (const RestreamLinkStats& link : s.links) {
+        if (link.rung >= 0 && link.rung < s.rungSubscribers.size()) ++s.rungSubscribers[link.rung];
+    }
+    return s;
+}
+
+void VideoRestreamer::addVideoFrame(const VideoFrame& frame, qint64 timestamp) {
+    if (frame.isNull() || !m_encoderThread) return;
+    m_framesIn.fetch_add(1, std::memory_order_relaxed);
+    // Nothing is composited or encoded for an empty room
+    if (m_connections.load(std::memory_order_relaxed) == 0) return;
+
+    // The layer is shared, not copied, until the renderer next repaints it
+    QImage layer;
+    if (m_config.burnInOverlay && m_overlay) {
+        m_overlay->setFrameTime(timestamp);
+        m_overlay->updateLayer(frame.size());
+        layer = m_overlay->layer();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_hasPending) m_framesCoalesced.fetch_add(1, std::memory_order_relaxed);
+        m_pendingFrame = frame;
+        m_pendingLayer = layer;
+        m_pendingTimestamp = timestamp;
+        m_hasPending = true;
+    }
+    m_frameReady.wakeOne();
+}
+
+void VideoRestreamer::setSensorMetadata(const SensorMetadata& metadata) {
+    QMutexLocker locker(&m_mutex);
+    m_sensor = metadata;
+    m_hasSensor = true;
+}
+
+// ---------------------------------------------------------------------------
+// Encoder thread
+
+void VideoRestreamer::encoderLoop() {
+    m_rungs.clear();
+    m_rungs.resize(m_config.ladder.size());
+    for (size_t i = 0; i < m_rungs.size(); ++i) m_rungs[i].settings = m_config.ladder[int(i)];
+
+    forever {
+        VideoFrame frame;
+        QImage layer;
+        qint64 timestamp = 0;
+        SensorMetadata sensor;
+        bool hasSensor = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasPending && !m_stopping) m_frameReady.wait(&m_mutex);
+            if (m_stopping) break;
+            frame = m_pendingFrame;
+            layer = m_pendingLayer;
+            timestamp = m_pendingTimestamp;
+            m_pendingFrame = VideoFrame();
+            m_pendingLayer = QImage();
+            m_hasPending = false;
+            hasSensor = m_hasSensor;
+            if (hasSensor) sensor = m_sensor;
+        }
+        encodeFrame(frame, layer, timestamp);
+        if (hasSensor && m_config.klvMetadata && m_klvSubscribers.load(std::memory_order_relaxed) > 0) {
+            encodeKlv(sensor, timestamp, frame.size());
+        }
+    }
+
+    for (Rung& rung : m_rungs) {
+        if (rung.encoder) rung.encoder->close();
+    }
+    m_rungs.clear();
+}
+
+void VideoRestreamer::encodeFrame(const VideoFrame& frame, const QImage& layer, qint64 timestamp) {
+    CUAS_TRACE_SCOPE("video", "VideoRestreamer::encodeFrame");
+    const qint64 startNs = TimeUtils::monotonicNs();
+
+    // The first rung settles the codec the SDP offers, watched or not
+    if (!m_rungs[0].encoder && !openRung(m_rungs[0], frame.size())) return;
+
+    QImage composed;
+    bool haveComposed = false;
+    bool encoded = false;
+    for (size_t i = 0; i < m_rungs.size(); ++i) {
+        if (m_rungDemand[i].load(std::memory_order_relaxed) <= 0) continue;
+        Rung& rung = m_rungs[i];
+        const QSize size = rungSize(rung.settings, frame.size(), m_codec);
+        if ((!rung.encoder || rung.size != size) && !openRung(rung, frame.size())) continue;
+
+        // A native-size rung without symbology takes the frame as it came,
+        // YUV planes and all; the rest share one composite
+        VideoFrame input = frame;
+        if (!layer.isNull() || size != frame.size()) {
+            if (!haveComposed) {
+                composed = frame.toImage().convertToFormat(QImage::Format_RGB32);
+                if (!layer.isNull()) {
+                    QPainter painter(&composed);
+                    painter.drawImage(composed.rect(), layer);
+                }
+                haveComposed = true;
+            }
+            input = VideoFrame(size == composed.size()
+                                   ? composed
+                                   : composed.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+        }
+
+        if (m_keyframeWanted[i].exchange(false)) rung.encoder->requestKeyframe();
+        m_packets.clear();
+        if (!rung.encoder->encode(input, timestamp, m_packets)) {
+            m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        m_framesEncoded.fetch_add(1, std::memory_order_relaxed);
+        encoded = true;
+
+        for (const EncodedPacket& packet : m_packets) {
+            QSharedPointer<Unit> unit(new Unit);
+            unit->rung = int(i);
+            unit->payloadType = rung.packetizer->payloadType();
+            unit->keyframe = packet.keyframe;
+            unit->captureMs = packet.timeMs;
+            unit->rtpTimestamp = static_cast<quint32>(static_cast<quint64>(packet.timeMs) * RTP_CLOCK_KHZ);
+            if (!rung.packetizer->packetize(packet.data, packet.keyframe, unit->payloads)) {
+                m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            UnitPtr shared = unit;
+            QMetaObject::invokeMethod(m_context, [this, shared]() { deliver(shared); }, Qt::QueuedConnection);
+        }
+    }
+
+    if (encoded) {
+        QMutexLocker locker(&m_mutex);
+        m_encodeLatency.record((TimeUtils::monotonicNs() - startNs) / 1000);
+    }
+}
+
+void VideoRestreamer::encodeKlv(const SensorMetadata& metadata, qint64 timestamp, const QSize& frameSize) {
+    const QByteArray& packet = m_klv.encode(metadata, timestamp, frameSize);
+
+    QSharedPointer<Unit> unit(new Unit);
+    unit->rung = -1;
+    unit->payloadType = KLV_PAYLOAD_TYPE;
+    unit->klv = true;
+    unit->keyframe = true;
+    unit->captureMs = timestamp;
+    unit->rtpTimestamp = static_cast<quint32>(static_cast<quint64>(timestamp) * RTP_CLOCK_KHZ);
+    // RFC 6597: the local set in order across packets, the marker on its last
+    const int maxPayload = qMax(MIN_KLV_PAYLOAD, m_config.maxPayloadBytes);
+    for (int offset = 0; offset < packet.size(); offset += maxPayload) {
+        unit->payloads.append(packet.mid(offset, maxPayload));
+    }
+    UnitPtr shared = unit;
+    QMetaObject::invokeMethod(m_context, [this, shared]() { deliver(shared); }, Qt::QueuedConnection);
+}
+
+bool VideoRestreamer::openRung(Rung& rung, const QSize& sourceSize) {
+    if (rung.encoder) rung.encoder->close();
+    rung.encoder.reset();
+    rung.packetizer.reset();
+
+    const bool first = m_codec.isEmpty();
+    VideoEncoderSettings settings;
+    settings.codec = first ? m_config.codec : m_codec;
+    settings.bitrateKbps = rung.settings.bitrateKbps;
+    settings.quality = rung.settings.quality;
+    settings.fps = m_config.fps;
+    settings.keyframeIntervalFrames = qMax(1, m_config.keyframeIntervalFrames);
+    settings.lowLatency = true;
+
+    // Every rung carries the codec the first settled on; only the first
+    // may fall back, before any console has been told
+    const QStringList names = VideoEncoderRegistry::candidates(m_config.hardwareEncoder);
+    std::unique_ptr<VideoEncoderBackend> backend;
+    for (int attempt = 0; attempt < 2 && !backend; ++attempt) {
+        if (settings.codec.compare("JPEG", Qt::CaseInsensitive) == 0) settings.codec = "MJPEG";
+        settings.size = rungSize(rung.settings, sourceSize, settings.codec);
+        for (const QString& name : names) {
+            std::unique_ptr<VideoEncoderBackend> candidate = VideoEncoderRegistry::create(name);
+            if (candidate && candidate->open(settings)) {
+                backend = std::move(candidate);
+                break;
+            }
+        }
+        if (backend || !first || settings.codec.compare("MJPEG", Qt::CaseInsensitive) == 0) break;
+        Logger::instance().warning("VideoRestreamer",
+                                   QString("No encoder for %1; re-streaming Motion JPEG").arg(settings.codec));
+        settings.codec = "MJPEG";
+    }
+    if (!backend) {
+        m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+        emit error("No video encoder available for " + settings.codec);
+        return false;
+    }
+
+    rung.packetizer = RtpPacketizer::create(backend->codecId(), backend->codecPrivate(),
+                                            m_config.maxPayloadBytes);
+    if (!rung.packetizer) {
+        backend->close();
+        m_encodeFailures.fetch_add(1, std::memory_order_relaxed);
+        emit error("No RTP payload format for " + backend->codecId());
+        return false;
+    }
+    rung.encoder = std::move(backend);
+    rung.size = settings.size;
+
+    if (first) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_codec = settings.codec;
+            m_encoderName = rung.encoder->name();
+            m_encoderHardware = rung.encoder->isHardware();
+            m_payloadType = rung.packetizer->payloadType();
+            m_encodingName = rung.packetizer->encodingName();
+            m_fmtp = rung.packetizer->fmtp();
+        }
+        Logger::instance().info("VideoRestreamer",
+                                QString("%1 from %2%3").arg(settings.codec, m_encoderName,
+                                                            m_encoderHardware ? " (hardware)" : ""));
+        QMetaObject::invokeMethod(m_context, [this]() { answerDeferred(); }, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Server thread
+
+void VideoRestreamer::serve(QTcpSocket* socket) {
+    // Pictures go out as soon as they are written
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    Link link;
+    link.socket = socket;
+    link.peer = QString("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+    m_links.insert(socket, link);
+    m_connections.fetch_add(1, std::memory_order_relaxed);
+
+    connect(socket, &QTcpSocket::readyRead, m_context, [this, socket]() { onReadyRead(socket); });
+    connect(socket, &QTcpSocket::disconnected, m_context, [this, socket]() {
+        dropLink(socket);
+        socket->deleteLater();
+    });
+}
+
+void VideoRestreamer::dropLink(QTcpSocket* socket) {
+    auto it = m_links.find(socket);
+    if (it == m_links.end()) return;
+    stopPlaying(*it);
+    m_links.erase(it);
+    m_connections.fetch_sub(1, std::memory_order_relaxed);
+    publishLinks();
+}
+
+void VideoRestreamer::onReadyRead(QTcpSocket* socket) {
+    auto it = m_links.find(socket);
+    if (it == m_links.end()) return;
+    Link& link = *it;
+    link.request.append(socket->readAll());
+
+    int pos = 0;
+    while (pos < link.request.size()) {
+        if (link.request.at(pos) == '$') {
+            // Interleaved RTCP from the console; TCP loses nothing to report
+            if (link.request.size() - pos < 4) break;
+            const int length = qFromBigEndian<quint16>(link.request.constData() + pos + 2);
+            if (link.request.size() - pos < 4 + length) break;
+            pos += 4 + length;
+            continue;
+        }
+        const int end = link.request.indexOf("\r\n\r\n", pos);
+        if (end < 0) {
+            if (link.request.size() - pos > MAX_REQUEST_BYTES) {
+                socket->abort();
+                return;
+            }
+            break;
+        }
+        int contentLength = 0;
+        for (const QByteArray& line : link.request.mid(pos, end - pos).split('\n')) {
+            if (line.toLower().startsWith("content-length:")) contentLength = line.mid(15).trimmed().toInt();
+        }
+        if (link.request.size() < end + 4 + contentLength) break;
+        const QByteArray request = link.request.mid(pos, end + 4 + contentLength - pos);
+        pos = end + 4 + contentLength;
+
+        const QByteArray response = respond(link, request);
+        if (!response.isEmpty()) socket->write(response);
+    }
+    link.request.remove(0, pos);
+}
+
+bool VideoRestreamer::pathMatches(const QByteArray& uri) const {
+    QString path = QUrl(QString::fromUtf8(uri)).path();
+    while (path.startsWith('/')) path.remove(0, 1);
+    while (path.endsWith('/')) path.chop(1);
+    return path == m_config.path || path.startsWith(m_config.path + '/');
+}
+
+QByteArray VideoRestreamer::respond(Link& link, const QByteArray& request) {
+    const QList<QByteArray> lines = request.left(request.indexOf("\r\n\r\n")).split('\n');
+    const QList<QByteArray> parts = lines.first().trimmed().split(' ');
+    Headers headers;
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines[i].indexOf(':');
+        if (colon <= 0) continue;
+        headers.append({lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed()});
+    }
+    const QByteArray cseq = header(headers, "cseq");
+    if (parts.size() < 3 || !parts[2].startsWith("RTSP/")) {
+        return rtspResponse("400 Bad Request", cseq, QByteArray());
+    }
+    const QByteArray& method = parts[0];
+    const QByteArray& uri = parts[1];
+
+    QByteArray session = header(headers, "session");
+    const int semicolon = session.indexOf(';');
+    if (semicolon >= 0) session = session.left(semicolon).trimmed();
+    const QByteArray sessionHeader = link.sessionId.isEmpty()
+        ? QByteArray()
+        : "Session: " + link.sessionId + ";timeout=" + QByteArray::number(SESSION_TIMEOUT_S) + "\r\n";
+
+    if (method == "OPTIONS") {
+        return rtspResponse("200 OK", cseq,
+                            "Public: OPTIONS, DESCRIBE, SETUP, PLAY, PAUSE, TEARDOWN, GET_PARAMETER\r\n");
+    }
+    if (method == "GET_PARAMETER" || method == "SET_PARAMETER") {
+        return rtspResponse("200 OK", cseq, sessionHeader);
+    }
+    if (!pathMatches(uri)) return rtspResponse("404 Not Found", cseq, QByteArray());
+
+    if (method == "DESCRIBE") {
+        const QByteArray sdp = describe(uri);
+        if (sdp.isEmpty()) {
+            // Answered once the first frame has opened the encoder
+            link.deferred = request;
+            return QByteArray();
+        }
+        QByteArray base = uri;
+        if (!base.endsWith('/')) base += '/';
+        return rtspResponse("200 OK", cseq,
+                            "Content-Type: application/sdp\r\nContent-Base: " + base + "\r\n", sdp);
+    }
+
+    if (method == "SETUP") {
+        const QByteArray transport = header(headers, "transport");
+        if (!transport.contains("RTP/AVP/TCP")) {
+            return rtspResponse("461 Unsupported Transport", cseq, QByteArray());
+        }
+        if (!link.sessionId.isEmpty() && session != link.sessionId) {
+            return rtspResponse("454 Session Not Found", cseq, QByteArray());
+        }
+        // Streams are counted when play starts, so the set is fixed by then
+        if (link.playing) {
+            return rtspResponse("455 Method Not Valid in This State", cseq, sessionHeader);
+        }
+        QRandomGenerator* random = QRandomGenerator::global();
+        if (link.sessionId.isEmpty()) {
+            int sessions = 0;
+            for (const Link& other : m_links) {
+                if (!other.sessionId.isEmpty()) ++sessions;
+            }
+            if (sessions >= m_config.maxSubscribers) {
+                return rtspResponse("453 Not Enough Bandwidth", cseq, QByteArray());
+            }
+            link.sessionId = QByteArray::number(random->generate64(), 16).rightJustified(16, '0');
+        }
+
+        // track2 is the KLV stream; anything else sets up the video
+        const bool klv = m_config.klvMetadata && uri.endsWith("track2");
+        Channel& channel = klv ? link.klv : link.video;
+        channel = Channel();
+        channel.ssrc = random->generate();
+        channel.sequence = static_cast<quint16>(random->generate());
+        channel.rtp = klv ? 2 : 0;
+        const int interleaved = transport.indexOf("interleaved=");
+        if (interleaved >= 0) {
+            channel.rtp = transport.mid(interleaved + 12).split('-').first().toInt();
+        }
+        const QByteArray reply = QString("Transport: RTP/AVP/TCP;unicast;interleaved=%1-%2;ssrc=%3\r\n"
+                                         "Session: %4;timeout=%5\r\n")
+                                     .arg(channel.rtp).arg(channel.rtp + 1)
+                                     .arg(channel.ssrc, 8, 16, QChar('0'))
+                                     .arg(QString::fromLatin1(link.sessionId)).arg(SESSION_TIMEOUT_S)
+                                     .toLatin1();
+        return rtspResponse("200 OK", cseq, reply);
+    }
+
+    if (link.sessionId.isEmpty() || session != link.sessionId) {
+        if (method == "PLAY" || method == "PAUSE" || method == "TEARDOWN") {
+            return rtspResponse("454 Session Not Found", cseq, QByteArray());
+        }
+        return rtspResponse("501 Not Implemented", cseq, QByteArray());
+    }
+
+    if (method == "PLAY") {
+        if (!link.playing) {
+            const qint64 now = nowMs();
+            link.playing = true;
+            link.rung = link.target = 0;
+            link.skipping = true;
+            link.holdMs = qMax(0, m_config.upgradeHoldMs);
+            link.clearSinceMs = now;
+            link.lastUpgradeMs = -1;
+            link.video.lastReportMs = -1;
+            link.klv.lastReportMs = -1;
+            m_rungDemand[0].fetch_add(1);
+            m_keyframeWanted[0] = true;
+            if (link.klv.rtp >= 0) m_klvSubscribers.fetch_add(1);
+            emit subscribersChanged(m_subscribers.fetch_add(1) + 1);
+            Logger::instance().info("VideoRestreamer", link.peer + " playing");
+            publishLinks();
+        }
+        return rtspResponse("200 OK", cseq, sessionHeader + "Range: npt=now-\r\n");
+    }
+    if (method == "PAUSE") {
+        stopPlaying(link);
+        return rtspResponse("200 OK", cseq, sessionHeader);
+    }
+    if (method == "TEARDOWN") {
+        stopPlaying(link);
+        link.sessionId.clear();
+        return rtspResponse("200 OK", cseq, QByteArray());
+    }
+    return rtspResponse("501 Not Implemented", cseq, sessionHeader);
+}
+
+QByteArray VideoRestreamer::describe(const QByteArray& uri) const {
+    int payloadType;
+    QString encoding, fmtp;
+    {
+        QMutexLocker locker(&m_mutex);
+        payloadType = m_payloadType;
+        encoding = m_encodingName;
+        fmtp = m_fmtp;
+    }
+    if (payloadType < 0) return QByteArray();
+
+    const QByteArray pt = QByteArray::number(payloadType);
+    QByteArray sdp;
+    sdp += "v=0\r\n";
+    sdp += "o=- " + QByteArray::number(QRandomGenerator::global()->generate()) + " 1 IN IP4 0.0.0.0\r\n";
+    sdp += "s=CounterUAS " + m_config.path.toUtf8() + "\r\n";
+    sdp += "i=" + uri + "\r\n";
+    sdp += "c=IN IP4 0.0.0.0\r\n";
+    sdp += "t=0 0\r\n";
+    sdp += "a=range:npt=now-\r\n";
+    sdp += "a=control:*\r\n";
+    sdp += "m=video 0 RTP/AVP " + pt + "\r\n";
+    sdp += "a=rtpmap:" + pt + ' ' + encoding.toLatin1() + "/90000\r\n";
+    if (!fmtp.isEmpty()) sdp += "a=fmtp:" + pt + ' ' + fmtp.toLatin1() + "\r\n";
+    sdp += "a=control:track1\r\n";
+    if (m_config.klvMetadata) {
+        const QByteArray klv = QByteArray::number(KLV_PAYLOAD_TYPE);
+        sdp += "m=application 0 RTP/AVP " + klv + "\r\n";
+        sdp += "a=rtpmap:" + klv + " smpte336m/90000\r\n";
+        sdp += "a=control:track2\r\n";
+    }
+    return sdp;
+}
+
+void VideoRestreamer::answerDeferred() {
+    for (Link& link : m_links) {
+        if (link.deferred.isEmpty()) continue;
+        const QByteArray request = link.deferred;
+        link.deferred.clear();
+        const QByteArray response = respond(link, request);
+        if (!response.isEmpty()) link.socket->write(response);
+    }
+}
+
+void VideoRestreamer::stopPlaying(Link& link) {
+    if (!link.playing) return;
+    m_rungDemand[link.rung].fetch_sub(1);
+    if (link.target != link.rung) m_rungDemand[link.target].fetch_sub(1);
+    link.target = link.rung;
+    link.playing = false;
+    if (link.klv.rtp >= 0) m_klvSubscribers.fetch_sub(1);
+    emit subscribersChanged(m_subscribers.fetch_sub(1) - 1);
+    publishLinks();
+}
+
+void VideoRestreamer::deliver(const UnitPtr& unit) {
+    const qint64 now = nowMs();
+    if (unit->klv) {
+        // Metadata goes with the pictures a link is being sent
+        for (Link& link : m_links) {
+            if (!link.playing || link.klv.rtp < 0 || link.skipping) continue;
+            sendPackets(link, link.klv, *unit, now);
+            m_klvPacketsSent.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    for (Link& link : m_links) {
+        if (!link.playing) continue;
+
+        // A switch of rung lands on the new rung's keyframe
+        if (link.target != link.rung && unit->rung == link.target && unit->keyframe) {
+            m_rungDemand[link.rung].fetch_sub(1);
+            link.rung = link.target;
+            link.skipping = false;
+            link.clearSinceMs = now;
+            m_rungChanges.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (unit->rung != link.rung) continue;
+
+        adapt(link, now);
+        if (link.skipping && !unit->keyframe) {
+            ++link.framesSkipped;
+            continue;
+        }
+        if (link.skipping && link.target != link.rung) {
+            // Congested; the keyframe to switch on is coming from the rung below
+            ++link.framesSkipped;
+            continue;
+        }
+        link.skipping = false;
+        send(link, *unit, now);
+    }
+    publishLinks();
+}
+
+void VideoRestreamer::adapt(Link& link, qint64 nowMs) {
+    const int rungs = m_config.ladder.size();
+    const qint64 backlog = link.socket->bytesToWrite();
+    const qint64 budget = qMax<qint64>(link.lastUnitBytes,
+                                       qint64(m_config.ladder[link.rung].bitrateKbps) * m_config.congestionMs / 8);
+
+    if (backlog > budget) {
+        // Congested: skip to a keyframe, and down a rung if there is one.
+        // Trouble soon after a step up means the link was not ready for it
+        link.skipping = true;
+        if (link.lastUpgradeMs >= 0 && nowMs - link.lastUpgradeMs < link.holdMs) {
+            link.holdMs = qMin(qMax(1, link.holdMs) * 2, MAX_UPGRADE_HOLD_MS);
+            link.lastUpgradeMs = -1;
+        }
+        if (link.target < link.rung) {
+            retarget(link, link.rung);
+        }
+        if (link.target == link.rung && link.rung + 1 < rungs) {
+            retarget(link, link.rung + 1);
+        }
+        link.clearSinceMs = nowMs;
+        return;
+    }
+
+    if (link.skipping) m_keyframeWanted[link.rung] = true;
+    if (backlog == 0 && link.target == link.rung && link.rung > 0 &&
+        nowMs - link.clearSinceMs >= link.holdMs) {
+        link.lastUpgradeMs = nowMs;
+        retarget(link, link.rung - 1);
+    }
+}
+
+void VideoRestreamer::retarget(Link& link, int rung) {
+    if (link.target != link.rung) m_rungDemand[link.target].fetch_sub(1);
+    link.target = rung;
+    if (rung != link.rung) {
+        m_rungDemand[rung].fetch_add(1);
+        m_keyframeWanted[rung] = true;
+    }
+}
+
+void VideoRestreamer::send(Link& link, const Unit& unit, qint64 nowMs) {
+    link.lastUnitBytes = sendPackets(link, link.video, unit, nowMs);
+    ++link.framesSent;
+}
+
+int VideoRestreamer::sendPackets(Link& link, Channel& channel, const Unit& unit, qint64 nowMs) {
+    if (channel.lastReportMs < 0 || nowMs - channel.lastReportMs >= SENDER_REPORT_INTERVAL_MS) {
+        sendReport(link, channel, unit);
+        channel.lastReportMs = nowMs;
+    }
+
+    // Every packet of the picture in one write: '$', channel, length, RTP
+    int total = 0;
+    for (const QByteArray& payload : unit.payloads) total += 4 + RtpPacketizer::RTP_HEADER_SIZE + payload.size();
+    QByteArray out(total, Qt::Uninitialized);
+    uchar* p = reinterpret_cast<uchar*>(out.data());
+    int payloadBytes = 0;
+    for (int i = 0; i < unit.payloads.size(); ++i) {
+        const QByteArray& payload = unit.payloads[i];
+        p[0] = '$';
+        p[1] = static_cast<uchar>(channel.rtp);
+        qToBigEndian<quint16>(quint16(RtpPacketizer::RTP_HEADER_SIZE + payload.size()), p + 2);
+        RtpPacketizer::writeHeader(p + 4, unit.payloadType, i == unit.payloads.size() - 1, channel.sequence++,
+                                   unit.rtpTimestamp, channel.ssrc);
+        memcpy(p + 4 + RtpPacketizer::RTP_HEADER_SIZE, payload.constData(), size_t(payload.size()));
+        p += 4 + RtpPacketizer::RTP_HEADER_SIZE + payload.size();
+        payloadBytes += payload.size();
+    }
+    link.socket->write(out);
+
+    channel.packetCount += quint32(unit.payloads.size());
+    channel.octetCount += quint32(payloadBytes);
+    m_packetsSent.fetch_add(quint64(unit.payloads.size()), std::memory_order_relaxed);
+    m_bytesSent.fetch_add(quint64(total), std::memory_order_relaxed);
+    return total;
+}
+
+void VideoRestreamer::sendReport(Link& link, Channel& channel, const Unit& unit) {
+    // RTCP sender report: this picture's RTP time was its capture time
+    QByteArray out(4 + SENDER_REPORT_SIZE, '\0');
+    uchar* p = reinterpret_cast<uchar*>(out.data());
+    p[0] = '$';
+    p[1] = static_cast<uchar>(channel.rtp + 1);
+    qToBigEndian<quint16>(SENDER_REPORT_SIZE, p + 2);
+    uchar* sr = p + 4;
+    sr[0] = 0x80;
+    sr[1] = 200;
+    qToBigEndian<quint16>(SENDER_REPORT_SIZE / 4 - 1, sr + 2);
+    qToBigEndian<quint32>(channel.ssrc, sr + 4);
+    const quint64 ms = static_cast<quint64>(qMax<qint64>(0, unit.captureMs));
+    const quint64 fraction = (((ms % 1000) << 32) + 999) / 1000;
+    qToBigEndian<quint64>(((ms / 1000 + NTP_UNIX_OFFSET) << 32) | fraction, sr + 8);
+    qToBigEndian<quint32>(unit.rtpTimestamp, sr + 16);
+    qToBigEndian<quint32>(channel.packetCount, sr + 20);
+    qToBigEndian<quint32>(channel.octetCount, sr + 24);
+    link.socket->write(out);
+}
+
+void VideoRestreamer::publishLinks() {
+    QVector<RestreamLinkStats> links;
+    links.reserve(m_links.size());
+    for (const Link& link : m_links) {
+        if (!link.playing) continue;
+        RestreamLinkStats s;
+        s.peer = link.peer;
+        s.rung = link.rung;
+        s.backlogBytes = link.socket->bytesToWrite();
+        s.framesSent = link.framesSent;
+        s.framesSkipped = link.framesSkipped;
+        links.append(s);
+    }
+    QMutexLocker locker(&m_mutex);
+    m_linkStats = std::move(links);
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,296 @@
+#ifndef VIDEORESTREAMER_H
+#define VIDEORESTREAMER_H
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QImage>
+#include <QMutex>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "utils/LatencyStats.h"
+#include "utils/VideoFrame.h"
+#include "video/KlvEncoder.h"
+#include "video/VideoEncoderBackend.h"
+
+class QThread;
+class QTcpSocket;
+
+namespace CounterUAS {
+
+class RtpPacketizer;
+class VideoOverlayRenderer;
+class VideoStreamManager;
+
+/**
+ * @brief One bitrate of the re-streamed picture
+ */
+struct RestreamRung {
+    int bitrateKbps = 4000;
+    double scale = 1.0;         // Of the source's width and height
+    int quality = 80;           // For Motion JPEG
+};
+
+/**
+ * @brief Re-streaming configuration
+ */
+struct RestreamConfig {
+    QString path = "primary";   // rtsp://host:port/<path>
+    QString codec = "H264";     // H264 or MJPEG
+    bool hardwareEncoder = true;
+    bool burnInOverlay = true;
+    bool klvMetadata = true;    // Offer the sensor metadata as a second, KLV stream
+    double fps = 15.0;
+    int keyframeIntervalFrames = 30;
+    // Best first; at most MAX_RUNGS
+    QVector<RestreamRung> ladder = {{4000, 1.0, 80}, {1500, 0.5, 70}, {500, 0.25, 60}};
+    int maxSubscribers = 16;
+    int maxPayloadBytes = 1400;
+    int congestionMs = 250;     // Unsent backlog, in time at the link's rung, that steps it down
+    int upgradeHoldMs = 10000;  // Uncongested time before a link tries the rung above
+};
+
+/**
+ * @brief One remote console's link
+ */
+struct RestreamLinkStats {
+    QString peer;
+    int rung = 0;
+    qint64 backlogBytes = 0;
+    quint64 framesSent = 0;
+    quint64 framesSkipped = 0;  // Dropped to a congested link until its next keyframe
+};
+
+/**
+ * @brief Re-streamer counters, safe to read from any thread
+ */
+struct RestreamStats {
+    QString encoderBackend;
+    bool hardwareEncoder = false;
+    QString codec;
+    quint64 framesIn = 0;
+    quint64 framesCoalesced = 0;    // Replaced while the encoder was busy
+    quint64 framesEncoded = 0;      // Summed over rungs
+    quint64 encodeFailures = 0;
+    quint64 packetsSent = 0;
+    quint64 bytesSent = 0;
+    quint64 rungChanges = 0;
+    quint64 klvPacketsSent = 0;     // KLV local sets, one per picture, summed over links
+    QVector<int> rungSubscribers;
+    QVector<RestreamLinkStats> links;
+    LatencyStats encodeLatency;     // Compositing, scaling and encoding of a frame, microseconds
+};
+
+/**
+ * @brief RTSP server re-streaming the primary camera with its symbology
+ *
+ * Frames of the followed stream have the overlay layer burned in and are
+ * encoded once per rung of a small bitrate ladder, on an encoder thread of
+ * their own, low-latency and hardware first. Each encoded picture is
+ * packetised once and the payloads shared by every console on that rung,
+ * so CPU grows with the rungs in use, never with the number of consoles;
+ * a rung nobody watches is not encoded, and nothing is while no one is
+ * connected. The encoder takes the newest frame when it comes free, so a
+ * slow encode lowers the frame rate rather than the latency.
+ *
+ * Consoles play rtsp://host:port/<path> over RTP interleaved on the RTSP
+ * connection. A link's unsent backlog is its congestion signal: past
+ * congestionMs at its rung it skips to the next keyframe and steps down a
+ * rung; after upgradeHoldMs clear it tries the rung above, the hold
+ * doubling each time a try fails. Switches happen on a keyframe of the
+ * new rung, asked for from the encoder so they are quick; every keyframe
+ * carries its parameter sets, so a console sees one continuous stream.
+ * RTCP sender reports stamp pictures with their capture time.
+ *
+ * With klvMetadata the SDP also offers the followed camera's sensor
+ * metadata as an RFC 6597 SMPTE 336M stream: one ST 0601 local set per
+ * encoded picture, encoded once whatever the number of consoles and
+ * carrying the picture's RTP timestamp, so a console that sets it up sees
+ * pointing and target boxes aligned to the frame. Target pixels are in
+ * the source's frame, which the VMTI set names, for any rung to scale.
+ *
+ * The server and its connections live on their own thread, like
+ * MetricsExporter's.
+ */
+class VideoRestreamer : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_RUNGS = 4;
+    static constexpr int SESSION_TIMEOUT_S = 60;
+    static constexpr int SENDER_REPORT_INTERVAL_MS = 1000;
+    static constexpr int MAX_REQUEST_BYTES = 8192;
+    static constexpr int MAX_UPGRADE_HOLD_MS = 120000;
+
+    explicit VideoRestreamer(QObject* parent = nullptr);
+    ~VideoRestreamer() override;
+
+    // Restarts a running server; consoles reconnect
+    void setConfig(const RestreamConfig& config);
+    RestreamConfig config() const;
+
+    // Port 0 binds any free port; port() then tells which
+    bool start(quint16 port, const QHostAddress& address = QHostAddress::Any);
+    void stop();
+    bool isRunning() const { return m_thread != nullptr; }
+    quint16 port() const { return m_port; }
+    QString errorString() const { return m_error; }
+
+    // Follows the manager's primary stream; frames can also come in through addVideoFrame()
+    void setVideoManager(VideoStreamManager* manager);
+    // Burned into every frame when burnInOverlay is set; lives on this object's thread
+    void setOverlayRenderer(VideoOverlayRenderer* renderer);
+
+    int subscriberCount() const;
+    RestreamStats stats() const;
+
+signals:
+    void subscribersChanged(int count);
+    void error(const QString& message);
+
+public slots:
+    void addVideoFrame(const VideoFrame& frame, qint64 timestamp);
+    // Taken with the next frame; the followed camera's come in from the manager
+    void setSensorMetadata(const SensorMetadata& metadata);
+
+private:
+    // One encoded picture, shared by the links of its rung
+    struct Unit {
+        int rung = 0;
+        int payloadType = 0;
+        bool klv = false;           // The metadata stream's, for every rung
+        bool keyframe = false;
+        quint32 rtpTimestamp = 0;
+        qint64 captureMs = 0;
+        QVector<QByteArray> payloads;
+    };
+    using UnitPtr = QSharedPointer<const Unit>;
+
+    // One RTP stream of a link, and its RTCP channel above it
+    struct Channel {
+        int rtp = -1;               // Interleaved channel; -1 until set up
+        quint32 ssrc = 0;
+        quint16 sequence = 0;
+        qint64 lastReportMs = -1;
+        quint32 packetCount = 0;
+        quint32 octetCount = 0;
+    };
+
+    struct Link {
+        QTcpSocket* socket = nullptr;
+        QString peer;
+        QByteArray request;
+        QByteArray deferred;        // DESCRIBE waiting for the codec to settle
+        QByteArray sessionId;
+        bool playing = false;
+        Channel video;
+        Channel klv;
+        int rung = 0;
+        int target = 0;             // Rung being switched to; rung when none
+        bool skipping = true;       // Waiting for a keyframe
+        qint64 clearSinceMs = 0;
+        qint64 lastUpgradeMs = -1;
+        int holdMs = 0;
+        int lastUnitBytes = 0;      // One picture in flight is not congestion
+        quint64 framesSent = 0;
+        quint64 framesSkipped = 0;
+    };
+
+    struct Rung {
+        RestreamRung settings;
+        std::unique_ptr<VideoEncoderBackend> encoder;
+        std::unique_ptr<RtpPacketizer> packetizer;
+        QSize size;
+    };
+
+    void follow(const QString& cameraId);
+
+    // Encoder thread
+    void encoderLoop();
+    void encodeFrame(const VideoFrame& frame, const QImage& layer, qint64 timestamp);
+    void encodeKlv(const SensorMetadata& metadata, qint64 timestamp, const QSize& frameSize);
+    bool openRung(Rung& rung, const QSize& sourceSize);
+
+    // Server thread
+    void serve(QTcpSocket* socket);
+    void onReadyRead(QTcpSocket* socket);
+    QByteArray respond(Link& link, const QByteArray& request);
+    QByteArray describe(const QByteArray& uri) const;
+    void answerDeferred();
+    void deliver(const UnitPtr& unit);
+    void send(Link& link, const Unit& unit, qint64 nowMs);
+    int sendPackets(Link& link, Channel& channel, const Unit& unit, qint64 nowMs);
+    void sendReport(Link& link, Channel& channel, const Unit& unit);
+    void adapt(Link& link, qint64 nowMs);
+    void retarget(Link& link, int rung);
+    void stopPlaying(Link& link);
+    void dropLink(QTcpSocket* socket);
+    void publishLinks();
+    bool pathMatches(const QByteArray& uri) const;
+
+    RestreamConfig m_config;        // Fixed while the threads run; both read it
+    QPointer<VideoStreamManager> m_videoManager;
+    QPointer<VideoOverlayRenderer> m_overlay;
+    int m_subscription = 0;
+    QString m_followed;
+
+    // Frame handed to the encoder; the newest replaces one not yet taken
+    mutable QMutex m_mutex;
+    QWaitCondition m_frameReady;
+    VideoFrame m_pendingFrame;
+    QImage m_pendingLayer;
+    qint64 m_pendingTimestamp = 0;
+    bool m_hasPending = false;
+    SensorMetadata m_sensor;        // Latest, taken with each frame
+    bool m_hasSensor = false;
+    bool m_stopping = false;
+    QThread* m_encoderThread = nullptr;
+
+    // Encoder thread; the codec, payload type and fmtp are published under m_mutex
+    std::vector<Rung> m_rungs;
+    QVector<EncodedPacket> m_packets;
+    QString m_codec;                // Settled when the first rung opens; all rungs share it
+    QString m_encoderName;
+    bool m_encoderHardware = false;
+    int m_payloadType = -1;
+    QString m_encodingName;
+    QString m_fmtp;
+    LatencyStats m_encodeLatency;   // Under m_mutex
+    KlvEncoder m_klv;
+
+    // Demand and keyframe requests from the server thread
+    std::atomic<int> m_rungDemand[MAX_RUNGS];
+    std::atomic<bool> m_keyframeWanted[MAX_RUNGS];
+
+    // Server thread
+    QThread* m_thread = nullptr;
+    QObject* m_context = nullptr;   // Lives on m_thread, parents the server and sockets
+    quint16 m_port = 0;
+    quint16 m_requestedPort = 0;    // For a restart
+    QHostAddress m_address;
+    QString m_error;
+    QHash<QTcpSocket*, Link> m_links;
+    std::atomic<int> m_connections{0};     // Frames go to the encoder only while there are some
+    std::atomic<int> m_subscribers{0};
+    std::atomic<int> m_klvSubscribers{0};      // KLV is encoded only while some play it
+    QVector<RestreamLinkStats> m_linkStats;     // Under m_mutex
+
+    std::atomic<quint64> m_framesIn{0};
+    std::atomic<quint64> m_framesCoalesced{0};
+    std::atomic<quint64> m_framesEncoded{0};
+    std::atomic<quint64> m_encodeFailures{0};
+    std::atomic<quint64> m_packetsSent{0};
+    std::atomic<quint64> m_bytesSent{0};
+    std::atomic<quint64> m_rungChanges{0};
+    std::atomic<quint64> m_klvPacketsSent{0};
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEORESTREAMER_H
@@ -0,0 +1,372 @@
+#include "video/VideoService.h"
+#include "config/CameraConfig.h"
+#include "video/PTZController.h"
+#include "video/VideoStreamManager.h"
+#include "utils/Logger.h"
+#include "utils/RawCapture.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+namespace CounterUAS {
+
+namespace {
+
+PTZProtocol ptzProtocolFromName(const QString& name) {
+    const QString n = name.toUpper().remove('_').remove('-');
+    if (n == "PELCOD") return PTZProtocol::Pelco_D;
+    if (n == "PELCOP") return PTZProtocol::Pelco_P;
+    if (n == "VISCA") return PTZProtocol::VISCA;
+    if (n == "HTTP" || n == "HTTPCGI" || n == "CGI") return PTZProtocol::HTTP_CGI;
+    return PTZProtocol::ONVIF;
+}
+
+} // namespace
+
+VideoService::VideoService(QObject* parent)
+    : QObject(parent)
+    , m_manager(new VideoStreamManager(this))
+    , m_publisher(new SharedMemoryPublisher(this))
+{
+    // Every native frame into the ring, on the manager's thread
+    connect(m_manager, &VideoStreamManager::videoFrameReady,
+            this, [this](const QString& cameraId, const VideoFrame& frame) {
+        VideoSource* source = m_manager->stream(cameraId);
+        m_publisher->publishVideoFrame(cameraId, frame,
+            source ? source->currentTimestamp() : QDateTime::currentMSecsSinceEpoch());
+    });
+    connect(m_manager, &VideoStreamManager::streamStatusChanged,
+            this, [this](const QString& cameraId, VideoSourceStatus status) {
+        Message msg = event(VideoServiceWire::EVENT_STREAM_STATUS, cameraId);
+        msg.payload["status"] = static_cast<int>(status);
+        broadcast(msg);
+    });
+    connect(m_manager, &VideoStreamManager::recordingStarted, this, [this](const QString& cameraId) {
+        broadcast(event(VideoServiceWire::EVENT_RECORDING_STARTED, cameraId));
+    });
+    connect(m_manager, &VideoStreamManager::recordingStopped, this, [this](const QString& cameraId) {
+        broadcast(event(VideoServiceWire::EVENT_RECORDING_STOPPED, cameraId));
+    });
+    connect(m_manager, &VideoStreamManager::cameraSlewing,
+            this, [this](const QString& cameraId, const GeoPosition& target) {
+        Message msg = event(VideoServiceWire::EVENT_SLEWING, cameraId);
+        msg.payload["latitude"] = target.latitude;
+        msg.payload["longitude"] = target.longitude;
+        msg.payload["altitude"] = target.altitude;
+        broadcast(msg);
+    });
+}
+
+VideoService::~VideoService() {
+    stop();
+}
+
+bool VideoService::start(const VideoServiceConfig& config) {
+    stop();
+    m_config = config;
+
+    SharedMemoryConfig shm = m_config.sharedMemory;
+    if (shm.key.isEmpty() || shm.key == SharedMemoryConfig().key) {
+        shm.key = m_config.serverName;
+    }
+    // Nothing but frames goes through this segment
+    shm.ringBytes = 0;
+    shm.trackCapacity = 1;
+    if (!m_publisher->start(shm)) {
+        m_error = m_publisher->errorString();
+        return false;
+    }
+
+    // A server name left by a crashed service would refuse the listen
+    QLocalServer::removeServer(m_config.serverName);
+    m_server = new QLocalServer(this);
+    if (!m_server->listen(m_config.serverName)) {
+        m_error = m_server->errorString();
+        Logger::instance().error("VideoService", "Failed to listen on " + m_config.serverName + ": " + m_error);
+        delete m_server;
+        m_server = nullptr;
+        m_publisher->stop();
+        return false;
+    }
+    connect(m_server, &QLocalServer::newConnection, this, &VideoService::onNewConnection);
+
+    if (m_config.runDetector) {
+        m_detector = new VisualDetector(this);
+        m_detector->setConfig(m_config.detector);
+        if (m_detector->start()) {
+            m_manager->setVisualDetector(m_detector);
+            connect(m_detector, &VisualDetector::cameraDetection,
+                    this, [this](const CameraDetection& detection) {
+                Message msg = event(VideoServiceWire::EVENT_DETECTION, detection.cameraId);
+                msg.payload["x"] = detection.boundingBox.x();
+                msg.payload["y"] = detection.boundingBox.y();
+                msg.payload["width"] = detection.boundingBox.width();
+                msg.payload["height"] = detection.boundingBox.height();
+                msg.payload["confidence"] = detection.confidence;
+                msg.payload["objectClass"] = detection.objectClass;
+                msg.payload["frameNumber"] = detection.frameNumber;
+                msg.payload["detectionTime"] = detection.timestamp;
+                broadcast(msg);
+            });
+        } else {
+            Logger::instance().warning("VideoService", "No detector backend opens " +
+                                       m_config.detector.model.path);
+            delete m_detector;
+            m_detector = nullptr;
+        }
+    }
+
+    if (!m_config.captureDirectory.isEmpty()) {
+        RawCaptureConfig capture;
+        capture.directory = m_config.captureDirectory;
+        m_capture = std::make_shared<RawCaptureRecorder>(capture);
+        m_capture->start();
+    }
+
+    m_error.clear();
+    Logger::instance().info("VideoService", "Serving video on " + m_config.serverName);
+    return true;
+}
+
+void VideoService::stop() {
+    if (!m_server) return;
+
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        it.key()->disconnect(this);
+        it.key()->disconnectFromServer();
+        it.key()->deleteLater();
+        delete it.value();
+    }
+    m_clients.clear();
+    delete m_server;
+    m_server = nullptr;
+
+    m_manager->removeAllStreams();
+    qDeleteAll(m_ptz);
+    m_ptz.clear();
+    if (m_capture) {
+        m_capture->stop();
+        m_capture.reset();
+    }
+    if (m_detector) {
+        m_manager->setVisualDetector(nullptr);
+        m_detector->stop();
+        delete m_detector;
+        m_detector = nullptr;
+    }
+    m_publisher->stop();
+}
+
+VideoService::Statistics VideoService::statistics() const {
+    Statistics stats;
+    stats.clients = m_clients.size();
+    stats.requests = m_requests;
+    stats.requestsFailed = m_requestsFailed;
+    stats.frames = m_publisher->stats();
+    return stats;
+}
+
+void VideoService::onNewConnection() {
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        m_clients.insert(socket, new FrameReader());
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            delete m_clients.take(socket);
+            socket->deleteLater();
+        });
+
+        Message hello = event(VideoServiceWire::EVENT_HELLO);
+        hello.payload["sharedMemoryKey"] = m_publisher->config().key;
+        QVariantList streams;
+        for (const VideoStreamManager::StreamStatus& status : m_manager->allStreamStatus()) {
+            QVariantMap stream;
+            stream["cameraId"] = status.cameraId;
+            stream["status"] = static_cast<int>(status.status);
+            stream["recording"] = status.recording;
+            streams.append(stream);
+        }
+        hello.payload["streams"] = streams;
+        send(socket, hello);
+    }
+}
+
+void VideoService::onReadyRead(QLocalSocket* socket) {
+    FrameReader* reader = m_clients.value(socket);
+    if (!reader) return;
+
+    while (socket->bytesAvailable() > 0) {
+        int available = 0;
+        char* region = reader->writeRegion(available);
+        const qint64 bytesRead = socket->read(region, available);
+        if (bytesRead <= 0) break;
+        reader->commit(static_cast<int>(bytesRead));
+    }
+
+    FrameHeader header;
+    const char* payload = nullptr;
+    while (m_clients.value(socket) == reader && reader->next(header, payload)) {
+        Message request;
+        if (m_protocol.decodePayload(header, payload, request)) {
+            handleRequest(socket, request);
+        }
+    }
+}
+
+void VideoService::handleRequest(QLocalSocket* socket, const Message& request) {
+    const QString op = request.payload.value("op").toString();
+    const QString cameraId = request.payload.value("cameraId").toString();
+    QString error;
+    bool ok = false;
+
+    if (request.type == MessageType::VideoConfig) {
+        ok = handleStreamOp(op, cameraId, request.payload, error);
+    } else if (request.type == MessageType::PTZCommand) {
+        ok = handleCameraOp(op, cameraId, request.payload, error);
+    } else {
+        error = QStringLiteral("Not a video service request");
+    }
+
+    ++m_requests;
+    if (!ok) ++m_requestsFailed;
+
+    Message reply = event(VideoServiceWire::EVENT_REPLY, cameraId);
+    reply.payload["requestId"] = request.payload.value("requestId");
+    reply.payload["ok"] = ok;
+    if (!ok) reply.payload["error"] = error;
+    if (m_clients.contains(socket)) send(socket, reply);
+}
+
+bool VideoService::handleStreamOp(const QString& op, const QString& cameraId, const QVariantMap& args,
+                                  QString& error) {
+    using namespace VideoServiceWire;
+
+    if (op == OP_ADD_STREAM) {
+        const CameraDefinition camera =
+            CameraConfig::fromJson(QJsonObject::fromVariantMap(args.value("camera").toMap()));
+        if (camera.cameraId.isEmpty()) {
+            error = QStringLiteral("Camera has no id");
+            return false;
+        }
+        // Adding a stream the service already runs is how a restarted GUI rejoins it
+        if (m_manager->stream(camera.cameraId)) return true;
+        if (m_manager->addStream(camera).isEmpty()) {
+            error = QStringLiteral("Cannot add stream");
+            return false;
+        }
+        if (camera.hasPTZ) addPtz(camera);
+        return true;
+    }
+
+    if (!m_manager->stream(cameraId)) {
+        error = QStringLiteral("Unknown camera: ") + cameraId;
+        return false;
+    }
+
+    if (op == OP_REMOVE_STREAM) {
+        m_manager->removeStream(cameraId);
+        delete m_ptz.take(cameraId);
+    } else if (op == OP_START_STREAM) {
+        m_manager->startStream(cameraId);
+    } else if (op == OP_STOP_STREAM) {
+        m_manager->stopStream(cameraId);
+    } else if (op == OP_START_RECORDING) {
+        QString path = args.value("path").toString();
+        if (path.isEmpty()) {
+            path = QString("%1_%2.mkv").arg(cameraId,
+                       QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+        }
+        path = QDir(m_config.recordingDir).absoluteFilePath(path);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        m_manager->startRecording(cameraId, path);
+    } else if (op == OP_STOP_RECORDING) {
+        m_manager->stopRecording(cameraId);
+    } else {
+        error = QStringLiteral("Unknown stream op: ") + op;
+        return false;
+    }
+    return true;
+}
+
+bool VideoService::handleCameraOp(const QString& op, const QString& cameraId, const QVariantMap& args,
+                                  QString& error) {
+    using namespace VideoServiceWire;
+
+    if (!m_manager->stream(cameraId)) {
+        error = QStringLiteral("Unknown camera: ") + cameraId;
+        return false;
+    }
+
+    if (op == OP_SLEW) {
+        GeoPosition target;
+        target.latitude = args.value("latitude").toDouble();
+        target.longitude = args.value("longitude").toDouble();
+        target.altitude = args.value("altitude").toDouble();
+        m_manager->slewCamera(cameraId, target);
+        return true;
+    }
+
+    PTZController* ptz = m_ptz.value(cameraId);
+    if (!ptz) {
+        error = QStringLiteral("Camera has no PTZ: ") + cameraId;
+        return false;
+    }
+    if (op == OP_SET_PTZ) {
+        ptz->setPTZ(args.value("pan").toDouble(), args.value("tilt").toDouble(),
+                    args.value("zoom", 1.0).toDouble());
+    } else if (op == OP_MOVE_PTZ) {
+        ptz->setPanTiltVelocity(args.value("panRate").toDouble(), args.value("tiltRate").toDouble());
+    } else if (op == OP_STOP_PTZ) {
+        ptz->stop();
+    } else if (op == OP_PRESET) {
+        ptz->goToPreset(args.value("preset").toInt());
+    } else {
+        error = QStringLiteral("Unknown camera op: ") + op;
+        return false;
+    }
+    return true;
+}
+
+void VideoService::addPtz(const CameraDefinition& camera) {
+    PTZConfig config;
+    config.protocol = ptzProtocolFromName(camera.ptzProtocol);
+    config.host = camera.ptzAddress;
+    config.port = camera.ptzPort;
+    config.username = camera.metadata.value("ptzUsername").toString();
+    config.password = camera.metadata.value("ptzPassword").toString();
+
+    PTZController* ptz = new PTZController(this);
+    ptz->setConfig(config);
+    if (m_capture) {
+        ptz->setCapture(m_capture, "ptz:" + camera.cameraId);
+    }
+    ptz->connect();
+    delete m_ptz.take(camera.cameraId);
+    m_ptz.insert(camera.cameraId, ptz);
+}
+
+Message VideoService::event(const QString& op, const QString& cameraId) const {
+    Message msg;
+    msg.type = MessageType::VideoStatus;
+    msg.timestamp = QDateTime::currentMSecsSinceEpoch();
+    msg.sourceId = m_config.serverName;
+    msg.payload["op"] = op;
+    if (!cameraId.isEmpty()) msg.payload["cameraId"] = cameraId;
+    return msg;
+}
+
+void VideoService::send(QLocalSocket* socket, const Message& message) {
+    socket->write(m_protocol.serialize(message, WireEncoding::Binary));
+}
+
+void VideoService::broadcast(const Message& message) {
+    if (m_clients.isEmpty()) return;
+    const QByteArray frame = m_protocol.serialize(message, WireEncoding::Binary);
+    for (auto it = m_clients.constBegin(); it != m_clients.constEnd(); ++it) {
+        it.key()->write(frame);
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,133 @@
+#ifndef VIDEOSERVICE_H
+#define VIDEOSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <memory>
+#include "network/FrameReader.h"
+#include "network/MessageProtocol.h"
+#include "network/SharedMemoryPublisher.h"
+#include "video/VisualDetector.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+namespace CounterUAS {
+
+class PTZController;
+class RawCaptureRecorder;
+class VideoStreamManager;
+struct CameraDefinition;
+
+/**
+ * @brief Settings of the headless video service
+ */
+struct VideoServiceConfig {
+    QString serverName = QStringLiteral("counteruas-video");   // Local socket for control
+    SharedMemoryConfig sharedMemory;    // Frames for the GUI; the key defaults to serverName
+    QString recordingDir = QStringLiteral("recordings");       // For relative recording paths
+    bool runDetector = false;
+    VisualDetectorConfig detector;
+    QString captureDirectory;           // Raw PTZ feedback; empty captures none
+};
+
+/**
+ * @brief Control channel between the video service and its clients
+ *
+ * Protocol frames over a local socket, binary encoded. A request is a
+ * VideoConfig message (stream and recording ops) or a PTZCommand message
+ * (camera ops) whose payload carries "op", a "requestId" and the
+ * arguments; the service answers each with a VideoStatus message
+ * {op: "reply", requestId, ok, error}. Everything else the service sends
+ * is a VideoStatus event: "hello" on connect with the shared-memory key
+ * and the streams, then "streamStatus", "recordingStarted",
+ * "recordingStopped", "slewing" and "detection" as they happen.
+ */
+namespace VideoServiceWire {
+constexpr const char* OP_ADD_STREAM = "addStream";          // camera: CameraConfig JSON
+constexpr const char* OP_REMOVE_STREAM = "removeStream";
+constexpr const char* OP_START_STREAM = "startStream";
+constexpr const char* OP_STOP_STREAM = "stopStream";
+constexpr const char* OP_START_RECORDING = "startRecording"; // path
+constexpr const char* OP_STOP_RECORDING = "stopRecording";
+constexpr const char* OP_SLEW = "slew";                     // latitude, longitude, altitude
+constexpr const char* OP_SET_PTZ = "setPTZ";                // pan, tilt, zoom
+constexpr const char* OP_MOVE_PTZ = "movePTZ";              // panRate, tiltRate, deg/s
+constexpr const char* OP_STOP_PTZ = "stopPTZ";
+constexpr const char* OP_PRESET = "preset";                 // preset
+
+constexpr const char* EVENT_REPLY = "reply";
+constexpr const char* EVENT_HELLO = "hello";                // sharedMemoryKey, streams
+constexpr const char* EVENT_STREAM_STATUS = "streamStatus"; // status: VideoSourceStatus
+constexpr const char* EVENT_RECORDING_STARTED = "recordingStarted";
+constexpr const char* EVENT_RECORDING_STOPPED = "recordingStopped";
+constexpr const char* EVENT_SLEWING = "slewing";            // latitude, longitude, altitude
+constexpr const char* EVENT_DETECTION = "detection";        // x, y, width, height, confidence, ...
+}
+
+/**
+ * @brief Hosts the video sources, recorders and detector outside the GUI
+ *
+ * Runs in its own process (CounterUAS_VideoService), so a decoder that
+ * stalls or crashes costs the operator video but never the C2. The
+ * service owns a VideoStreamManager and publishes every native frame into
+ * the video ring of a SharedMemoryPublisher, where any number of GUIs
+ * read it (see VideoServiceClient and RemoteVideoSource). Streams,
+ * recording and cameras are driven over the local control channel
+ * described in VideoServiceWire; streams outlive the clients, so a GUI
+ * that restarts finds them running.
+ */
+class VideoService : public QObject {
+    Q_OBJECT
+
+public:
+    explicit VideoService(QObject* parent = nullptr);
+    ~VideoService() override;
+
+    bool start(const VideoServiceConfig& config);
+    void stop();
+    bool isRunning() const { return m_server != nullptr; }
+    QString errorString() const { return m_error; }
+
+    VideoStreamManager* streamManager() const { return m_manager; }
+    SharedMemoryPublisher* publisher() const { return m_publisher; }
+
+    struct Statistics {
+        int clients = 0;
+        qint64 requests = 0;
+        qint64 requestsFailed = 0;
+        SharedMemoryPublisher::Stats frames;
+    };
+    Statistics statistics() const;
+
+private:
+    void onNewConnection();
+    void onReadyRead(QLocalSocket* socket);
+    void handleRequest(QLocalSocket* socket, const Message& request);
+    bool handleStreamOp(const QString& op, const QString& cameraId, const QVariantMap& args,
+                        QString& error);
+    bool handleCameraOp(const QString& op, const QString& cameraId, const QVariantMap& args,
+                        QString& error);
+    void addPtz(const CameraDefinition& camera);
+    Message event(const QString& op, const QString& cameraId = QString()) const;
+    void send(QLocalSocket* socket, const Message& message);
+    void broadcast(const Message& message);
+
+    VideoServiceConfig m_config;
+    VideoStreamManager* m_manager;
+    SharedMemoryPublisher* m_publisher;
+    VisualDetector* m_detector = nullptr;
+    QLocalServer* m_server = nullptr;
+    QHash<QLocalSocket*, FrameReader*> m_clients;
+    QHash<QString, PTZController*> m_ptz;
+    std::shared_ptr<RawCaptureRecorder> m_capture;
+    MessageProtocol m_protocol;
+    QString m_error;
+    qint64 m_requests = 0;
+    qint64 m_requestsFailed = 0;
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEOSERVICE_H
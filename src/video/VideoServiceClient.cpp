@@ -0,0 +1,241 @@
+#include "video/VideoServiceClient.h"
+#include "config/CameraConfig.h"
+#include "network/SharedMemorySubscriber.h"
+#include "video/VideoService.h"
+#include "utils/Logger.h"
+#include <QDateTime>
+#include <QLocalSocket>
+
+namespace CounterUAS {
+
+VideoServiceClient::VideoServiceClient(QObject* parent)
+    : QObject(parent)
+    , m_socket(new QLocalSocket(this))
+    , m_reconnectTimer(new QTimer(this))
+    , m_frames(new SharedMemorySubscriber(this))
+{
+    m_reconnectTimer->setInterval(1000);
+    connect(m_reconnectTimer, &QTimer::timeout, this, [this]() {
+        if (m_socket->state() == QLocalSocket::UnconnectedState) {
+            m_socket->connectToServer(m_serverName);
+        }
+    });
+    connect(m_socket, &QLocalSocket::connected, this, &VideoServiceClient::onConnected);
+    connect(m_socket, &QLocalSocket::disconnected, this, &VideoServiceClient::onDisconnected);
+    connect(m_socket, &QLocalSocket::readyRead, this, &VideoServiceClient::onReadyRead);
+    connect(m_frames, &SharedMemorySubscriber::videoFrameReceived,
+            this, &VideoServiceClient::videoFrameReceived);
+}
+
+VideoServiceClient::~VideoServiceClient() {
+    disconnectFromService();
+}
+
+void VideoServiceClient::connectToService(const QString& serverName) {
+    disconnectFromService();
+    m_serverName = serverName;
+    m_reconnectTimer->start();
+    m_socket->connectToServer(m_serverName);
+}
+
+void VideoServiceClient::disconnectFromService() {
+    m_reconnectTimer->stop();
+    m_socket->abort();
+    onDisconnected();
+}
+
+VideoSourceStatus VideoServiceClient::streamStatus(const QString& cameraId) const {
+    return m_status.value(cameraId, VideoSourceStatus::Disconnected);
+}
+
+VideoServiceClient::Statistics VideoServiceClient::statistics() const {
+    Statistics stats = m_stats;
+    const SharedMemorySubscriber::Stats frames = m_frames->stats();
+    stats.framesReceived = frames.videoFramesReceived;
+    stats.framesLost = frames.videoFramesLost;
+    return stats;
+}
+
+int VideoServiceClient::addStream(const CameraDefinition& camera) {
+    QVariantMap args;
+    args["camera"] = CameraConfig::toJson(camera).toVariantMap();
+    return request(MessageType::VideoConfig, VideoServiceWire::OP_ADD_STREAM, camera.cameraId, args);
+}
+
+int VideoServiceClient::removeStream(const QString& cameraId) {
+    return request(MessageType::VideoConfig, VideoServiceWire::OP_REMOVE_STREAM, cameraId);
+}
+
+int VideoServiceClient::startStream(const QString& cameraId) {
+    return request(MessageType::VideoConfig, VideoServiceWire::OP_START_STREAM, cameraId);
+}
+
+int VideoServiceClient::stopStream(const QString& cameraId) {
+    return request(MessageType::VideoConfig, VideoServiceWire::OP_STOP_STREAM, cameraId);
+}
+
+int VideoServiceClient::startRecording(const QString& cameraId, const QString& path) {
+    QVariantMap args;
+    if (!path.isEmpty()) args["path"] = path;
+    return request(MessageType::VideoConfig, VideoServiceWire::OP_START_RECORDING, cameraId, args);
+}
+
+int VideoServiceClient::stopRecording(const QString& cameraId) {
+    return request(MessageType::VideoConfig, VideoServiceWire::OP_STOP_RECORDING, cameraId);
+}
+
+int VideoServiceClient::slewCamera(const QString& cameraId, const GeoPosition& target) {
+    QVariantMap args;
+    args["latitude"] = target.latitude;
+    args["longitude"] = target.longitude;
+    args["altitude"] = target.altitude;
+    return request(MessageType::PTZCommand, VideoServiceWire::OP_SLEW, cameraId, args);
+}
+
+int VideoServiceClient::setPTZ(const QString& cameraId, double pan, double tilt, double zoom) {
+    QVariantMap args;
+    args["pan"] = pan;
+    args["tilt"] = tilt;
+    args["zoom"] = zoom;
+    return request(MessageType::PTZCommand, VideoServiceWire::OP_SET_PTZ, cameraId, args);
+}
+
+int VideoServiceClient::movePTZ(const QString& cameraId, double panRate, double tiltRate) {
+    QVariantMap args;
+    args["panRate"] = panRate;
+    args["tiltRate"] = tiltRate;
+    return request(MessageType::PTZCommand, VideoServiceWire::OP_MOVE_PTZ, cameraId, args);
+}
+
+int VideoServiceClient::stopPTZ(const QString& cameraId) {
+    return request(MessageType::PTZCommand, VideoServiceWire::OP_STOP_PTZ, cameraId);
+}
+
+int VideoServiceClient::goToPreset(const QString& cameraId, int preset) {
+    QVariantMap args;
+    args["preset"] = preset;
+    return request(MessageType::PTZCommand, VideoServiceWire::OP_PRESET, cameraId, args);
+}
+
+int VideoServiceClient::request(MessageType type, const QString& op, const QString& cameraId,
+                                const QVariantMap& args) {
+    const int requestId = m_nextRequestId++;
+    ++m_stats.requests;
+
+    if (!m_connected) {
+        ++m_stats.requestsFailed;
+        // After the caller has the id
+        QTimer::singleShot(0, this, [this, requestId]() {
+            emit requestFinished(requestId, false, QStringLiteral("Video service not connected"));
+        });
+        return requestId;
+    }
+
+    Message msg;
+    msg.type = type;
+    msg.timestamp = QDateTime::currentMSecsSinceEpoch();
+    msg.payload = args;
+    msg.payload["op"] = op;
+    msg.payload["requestId"] = requestId;
+    msg.payload["cameraId"] = cameraId;
+    m_socket->write(m_protocol.serialize(msg, WireEncoding::Binary));
+    return requestId;
+}
+
+void VideoServiceClient::onConnected() {
+    m_reader.clear();
+    ++m_stats.connects;
+    // Connected once the hello names the frames to attach to
+}
+
+void VideoServiceClient::onDisconnected() {
+    m_reader.clear();
+    m_frames->stop();
+    if (!m_connected) return;
+
+    m_connected = false;
+    m_status.clear();
+    m_recording.clear();
+    Logger::instance().warning("VideoServiceClient", "Lost video service " + m_serverName);
+    emit connectedChanged(false);
+}
+
+void VideoServiceClient::onReadyRead() {
+    while (m_socket->bytesAvailable() > 0) {
+        int available = 0;
+        char* region = m_reader.writeRegion(available);
+        const qint64 bytesRead = m_socket->read(region, available);
+        if (bytesRead <= 0) break;
+        m_reader.commit(static_cast<int>(bytesRead));
+    }
+
+    FrameHeader header;
+    const char* payload = nullptr;
+    while (m_reader.next(header, payload)) {
+        Message msg;
+        if (m_protocol.decodePayload(header, payload, msg) && msg.type == MessageType::VideoStatus) {
+            handleEvent(msg);
+        }
+    }
+}
+
+void VideoServiceClient::handleEvent(const Message& message) {
+    using namespace VideoServiceWire;
+    const QVariantMap& p = message.payload;
+    const QString op = p.value("op").toString();
+    const QString cameraId = p.value("cameraId").toString();
+
+    if (op == EVENT_REPLY) {
+        const bool ok = p.value("ok").toBool();
+        if (!ok) ++m_stats.requestsFailed;
+        emit requestFinished(p.value("requestId").toInt(), ok, p.value("error").toString());
+    } else if (op == EVENT_HELLO) {
+        SharedMemoryConfig frames;
+        frames.key = p.value("sharedMemoryKey").toString();
+        m_frames->start(frames);
+
+        m_status.clear();
+        m_recording.clear();
+        for (const QVariant& entry : p.value("streams").toList()) {
+            const QVariantMap stream = entry.toMap();
+            const QString id = stream.value("cameraId").toString();
+            m_status.insert(id, static_cast<VideoSourceStatus>(stream.value("status").toInt()));
+            if (stream.value("recording").toBool()) m_recording.insert(id);
+        }
+
+        m_connected = true;
+        Logger::instance().info("VideoServiceClient", "Connected to video service " + m_serverName);
+        emit connectedChanged(true);
+        for (auto it = m_status.constBegin(); it != m_status.constEnd(); ++it) {
+            emit streamStatusChanged(it.key(), it.value());
+        }
+    } else if (op == EVENT_STREAM_STATUS) {
+        const VideoSourceStatus status = static_cast<VideoSourceStatus>(p.value("status").toInt());
+        m_status.insert(cameraId, status);
+        emit streamStatusChanged(cameraId, status);
+    } else if (op == EVENT_RECORDING_STARTED) {
+        m_recording.insert(cameraId);
+        emit recordingStarted(cameraId);
+    } else if (op == EVENT_RECORDING_STOPPED) {
+        m_recording.remove(cameraId);
+        emit recordingStopped(cameraId);
+    } else if (op == EVENT_SLEWING) {
+        GeoPosition target;
+        target.latitude = p.value("latitude").toDouble();
+        target.longitude = p.value("longitude").toDouble();
+        target.altitude = p.value("altitude").toDouble();
+        emit cameraSlewing(cameraId, target);
+    } else if (op == EVENT_DETECTION) {
+        CameraDetection detection;
+        detection.cameraId = cameraId;
+        detection.boundingBox = QRectF(p.value("x").toDouble(), p.value("y").toDouble(),
+                                       p.value("width").toDouble(), p.value("height").toDouble());
+        detection.confidence = p.value("confidence").toDouble();
+        detection.objectClass = p.value("objectClass").toString();
+        detection.frameNumber = p.value("frameNumber").toLongLong();
+        detection.timestamp = p.value("detectionTime").toLongLong();
+        emit cameraDetection(detection);
+    }
+}
+
+} // namespace CounterUAS
@@ -0,0 +1,111 @@
+#ifndef VIDEOSERVICECLIENT_H
+#define VIDEOSERVICECLIENT_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include "core/Track.h"
+#include "network/FrameReader.h"
+#include "network/MessageProtocol.h"
+#include "sensors/CameraSystem.h"
+#include "utils/VideoFrame.h"
+#include "video/VideoSource.h"
+
+class QLocalSocket;
+
+namespace CounterUAS {
+
+class SharedMemorySubscriber;
+struct CameraDefinition;
+
+/**
+ * @brief The GUI's end of a VideoService
+ *
+ * Keeps a local socket to the service, reconnecting every
+ * reconnectIntervalMs while it is down, and attaches to the service's
+ * shared-memory frames once the service says hello. Requests return an
+ * id that requestFinished() reports on; a request made while the service
+ * is down fails at once.
+ *
+ * Frames arrive on videoFrameReceived(), copied out of the segment into
+ * pooled frames on this thread; RemoteVideoSource turns them back into a
+ * VideoSource for VideoStreamManager.
+ */
+class VideoServiceClient : public QObject {
+    Q_OBJECT
+
+public:
+    explicit VideoServiceClient(QObject* parent = nullptr);
+    ~VideoServiceClient() override;
+
+    void connectToService(const QString& serverName);
+    void disconnectFromService();
+    bool isConnected() const { return m_connected; }
+    QString serverName() const { return m_serverName; }
+
+    void setReconnectInterval(int ms) { m_reconnectTimer->setInterval(qMax(100, ms)); }
+
+    // Stream and recording control
+    int addStream(const CameraDefinition& camera);
+    int removeStream(const QString& cameraId);
+    int startStream(const QString& cameraId);
+    int stopStream(const QString& cameraId);
+    int startRecording(const QString& cameraId, const QString& path = QString());
+    int stopRecording(const QString& cameraId);
+
+    // Camera control
+    int slewCamera(const QString& cameraId, const GeoPosition& target);
+    int setPTZ(const QString& cameraId, double pan, double tilt, double zoom);
+    int movePTZ(const QString& cameraId, double panRate, double tiltRate);
+    int stopPTZ(const QString& cameraId);
+    int goToPreset(const QString& cameraId, int preset);
+
+    // As last reported by the service
+    VideoSourceStatus streamStatus(const QString& cameraId) const;
+    bool isRecording(const QString& cameraId) const { return m_recording.contains(cameraId); }
+
+    struct Statistics {
+        qint64 requests = 0;
+        qint64 requestsFailed = 0;
+        qint64 connects = 0;
+        qint64 framesReceived = 0;
+        qint64 framesLost = 0;
+    };
+    Statistics statistics() const;
+
+signals:
+    void connectedChanged(bool connected);
+    void requestFinished(int requestId, bool ok, const QString& error);
+    void videoFrameReceived(const QString& cameraId, const VideoFrame& frame, qint64 timestampMs);
+    void streamStatusChanged(const QString& cameraId, VideoSourceStatus status);
+    void recordingStarted(const QString& cameraId);
+    void recordingStopped(const QString& cameraId);
+    void cameraSlewing(const QString& cameraId, const GeoPosition& target);
+    void cameraDetection(const CameraDetection& detection);
+
+private:
+    int request(MessageType type, const QString& op, const QString& cameraId,
+                const QVariantMap& args = QVariantMap());
+    void onConnected();
+    void onDisconnected();
+    void onReadyRead();
+    void handleEvent(const Message& message);
+
+    QString m_serverName;
+    QLocalSocket* m_socket;
+    QTimer* m_reconnectTimer;
+    SharedMemorySubscriber* m_frames;
+    FrameReader m_reader;
+    MessageProtocol m_protocol;
+    bool m_connected = false;
+    int m_nextRequestId = 1;
+
+    QHash<QString, VideoSourceStatus> m_status;
+    QSet<QString> m_recording;
+    Statistics m_stats;
+};
+
+} // namespace CounterUAS
+
+#endif // VIDEOSERVICECLIENT_H
@@ -1,5 +1,9 @@
 #include "video/VideoSource.h"
+#include "video/VideoDecoder.h"
 #include "utils/Logger.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/Trace.h"
+#include <QMetaMethod>
 #include <QMutexLocker>
 #include <QDateTime>
 
@@ -8,15 +12,23 @@ namespace CounterUAS {
 VideoSource::VideoSource(const QString& sourceId, QObject* parent)
     : QObject(parent)
     , m_sourceId(sourceId)
-    , m_frameTimer(new QTimer(this))
-    , m_statsTimer(new QTimer(this))
-    , m_reconnectTimer(new QTimer(this))
+    , m_frameTimer(this, nullptr)
+    , m_statsTimer(this, [this]() { updateStats(); })
+    , m_reconnectTimer(this, [this]() { attemptReconnect(); })
+    , m_clock(std::make_unique<SensorClock>(sourceId))
 {
-    connect(m_statsTimer, &QTimer::timeout, this, &VideoSource::updateStats);
-    m_statsTimer->setInterval(1000);
+    qRegisterMetaType<VideoFrame>("VideoFrame");
     
-    m_reconnectTimer->setSingleShot(true);
-    connect(m_reconnectTimer, &QTimer::timeout, this, &VideoSource::attemptReconnect);
+    m_statsTimer.setInterval(1000);
+    m_reconnectTimer.setSingleShot(true);
+    
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    const MetricLabels source = {{"source", m_sourceId}};
+    m_framesMetric = registry.counter("cuas_video_frames_total", "Frames received", source);
+    m_droppedMetric = registry.counter("cuas_video_dropped_frames_total", "Frames dropped before display",
+                                       source);
+    m_fpsMetric = registry.gauge("cuas_video_fps", "Frames per second over the last second", source);
+    m_latencyMetric = registry.gauge("cuas_video_latency_seconds", "Mean capture to emit latency", source);
 }
 
 VideoSource::~VideoSource() {
@@ -34,8 +46,8 @@ void VideoSource::start() {
     }
     
     m_streaming = true;
-    m_frameTimer->start(static_cast<int>(1000.0 / m_targetFPS));
-    m_statsTimer->start();
+    m_frameTimer.start(static_cast<int>(1000.0 / m_targetFPS));
+    m_statsTimer.start();
     
     setStatus(VideoSourceStatus::Streaming);
     emit streamingChanged(true);
@@ -47,8 +59,8 @@ void VideoSource::stop() {
     if (!m_streaming) return;
     
     m_streaming = false;
-    m_frameTimer->stop();
-    m_statsTimer->stop();
+    m_frameTimer.stop();
+    m_statsTimer.stop();
     
     if (m_status == VideoSourceStatus::Streaming) {
         setStatus(VideoSourceStatus::Connected);
@@ -62,7 +74,7 @@ void VideoSource::stop() {
 void VideoSource::pause() {
     if (!m_streaming) return;
     
-    m_frameTimer->stop();
+    m_frameTimer.stop();
     setStatus(VideoSourceStatus::Paused);
     
     Logger::instance().info("VideoSource", m_sourceId + " paused");
@@ -71,13 +83,17 @@ void VideoSource::pause() {
 void VideoSource::resume() {
     if (m_status != VideoSourceStatus::Paused) return;
     
-    m_frameTimer->start();
+    m_frameTimer.start();
     setStatus(VideoSourceStatus::Streaming);
     
     Logger::instance().info("VideoSource", m_sourceId + " resumed");
 }
 
 QImage VideoSource::currentFrame() const {
+    return currentVideoFrame().toImage();
+}
+
+VideoFrame VideoSource::currentVideoFrame() const {
     QMutexLocker locker(&m_frameMutex);
     return m_currentFrame;
 }
@@ -85,7 +101,7 @@ QImage VideoSource::currentFrame() const {
 void VideoSource::setTargetFPS(double fps) {
     m_targetFPS = qBound(1.0, fps, 120.0);
     if (m_streaming) {
-        m_frameTimer->setInterval(static_cast<int>(1000.0 / m_targetFPS));
+        m_frameTimer.setInterval(static_cast<int>(1000.0 / m_targetFPS));
     }
 }
 
@@ -112,17 +128,33 @@ void VideoSource::setError(const QString& message) {
     // Attempt reconnection if enabled
     if (m_autoReconnect && m_streaming) {
         setStatus(VideoSourceStatus::Reconnecting);
-        m_reconnectTimer->start(m_reconnectIntervalMs);
+        m_reconnectTimer.start(m_reconnectIntervalMs);
     }
 }
 
 void VideoSource::emitFrame(const QImage& frame) {
+    emitFrame(VideoFrame(frame));
+}
+
+void VideoSource::emitFrame(const VideoFrame& frame) {
+    emitFrame(frame, 0);
+}
+
+void VideoSource::emitFrame(const VideoFrame& frame, qint64 captureTimeMs) {
+    CUAS_TRACE_SCOPE("video", "VideoSource::emitFrame");
     qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 timestamp = now;
+    if (captureTimeMs > 0) {
+        // Latency against the camera's own stamp, so a clock offset shows in it
+        m_captureLatency.record((now - captureTimeMs) * 1000);
+        m_clock->observe(captureTimeMs, now);
+        timestamp = m_clock->correct(captureTimeMs);
+    }
     
     {
         QMutexLocker locker(&m_frameMutex);
         m_currentFrame = frame;
-        m_currentTimestamp = now;
+        m_currentTimestamp = timestamp;
     }
     
     m_stats.framesReceived++;
@@ -130,11 +162,35 @@ void VideoSource::emitFrame(const QImage& frame) {
     m_stats.width = frame.width();
     m_stats.height = frame.height();
     
-    emit frameReady(frame, now);
+    emit videoFrameReady(frame, timestamp);
+    if (isSignalConnected(QMetaMethod::fromSignal(&VideoSource::frameReady))) {
+        emit frameReady(frame.toImage(), timestamp);
+    }
+}
+
+void VideoSource::attachDecoder(VideoDecoder* decoder) {
+    if (m_decoder) {
+        disconnect(m_decoder, &VideoDecoder::videoFrameDecoded, this, nullptr);
+    }
+    m_decoder = decoder;
+    m_packetsAtLastStats = 0;
+    if (decoder) {
+        decoder->setDecodeMode(m_decodeMode);
+        connect(decoder, &VideoDecoder::videoFrameDecoded, this,
+                [this](const VideoFrame& frame, qint64 timestamp) { emitFrame(frame, timestamp); });
+    }
+}
+
+void VideoSource::setDecodeMode(VideoDecodeMode mode) {
+    m_decodeMode = mode;
+    if (m_decoder) m_decoder->setDecodeMode(mode);
 }
 
 void VideoSource::updateStats() {
+    collectStats();
+    
     qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_clock->update(now);
     qint64 elapsed = now - m_lastStatsTime;
     
     if (elapsed > 0) {
@@ -142,14 +198,49 @@ void VideoSource::updateStats() {
         m_stats.fps = (framesDelta * 1000.0) / elapsed;
     }
     
+    if (m_decoder) {
+        const VideoDecodeStats decode = m_decoder->stats();
+        m_stats.decoderBackend = decode.backend;
+        m_stats.hardwareDecode = decode.hardware;
+        m_stats.decodeLatencyMs = decode.latency.meanUs / 1000.0;
+        m_stats.decodeLatencyMaxMs = decode.latency.maxUs / 1000.0;
+        m_stats.decodeFailures = static_cast<qint64>(decode.failed);
+        m_stats.decodeFallbacks = static_cast<qint64>(decode.fallbacks);
+        m_stats.decodeQueueDepth = decode.queueDepth;
+        m_stats.decodeMode = decode.mode;
+        // A re-initialised decoder counts from zero again
+        const quint64 packets = decode.submitted >= m_packetsAtLastStats
+            ? decode.submitted - m_packetsAtLastStats : decode.submitted;
+        if (elapsed > 0) m_stats.packetFps = (packets * 1000.0) / elapsed;
+        m_packetsAtLastStats = decode.submitted;
+        m_stats.decodeSkipped = static_cast<qint64>(decode.skipped());
+        m_stats.skippedNonReference = static_cast<qint64>(decode.skippedNonReference);
+        m_stats.skippedNonKey = static_cast<qint64>(decode.skippedNonKey);
+        m_stats.skippedBacklog = static_cast<qint64>(decode.skippedBacklog);
+        m_stats.framesDropped = static_cast<qint64>(decode.dropped + decode.skipped());
+    }
+    
     m_lastStatsTime = now;
     m_framesAtLastStats = m_stats.framesReceived;
     
-    // Calculate latency
-    if (m_stats.lastFrameTime > 0) {
+    // Calculate latency: end to end when frames say when they were taken,
+    // otherwise the age of the last frame
+    if (m_captureLatency.count > 0) {
+        m_stats.captureTimestamps = true;
+        m_stats.latencyMs = static_cast<qint64>(m_captureLatency.meanUs / 1000.0);
+        m_stats.latencyMaxMs = m_captureLatency.maxUs / 1000;
+        m_captureLatency.reset();
+    } else if (m_stats.lastFrameTime > 0) {
+        m_stats.captureTimestamps = false;
         m_stats.latencyMs = now - m_stats.lastFrameTime;
+        m_stats.latencyMaxMs = m_stats.latencyMs;
     }
     
+    m_framesMetric->setTotal(static_cast<quint64>(m_stats.framesReceived));
+    m_droppedMetric->setTotal(static_cast<quint64>(m_stats.framesDropped));
+    m_fpsMetric->set(m_stats.fps);
+    m_latencyMetric->set(m_stats.latencyMs / 1000.0);
+    
     emit statsUpdated(m_stats);
 }
 
@@ -165,7 +256,7 @@ void VideoSource::attemptReconnect() {
         }
     } else {
         // Retry
-        m_reconnectTimer->start(m_reconnectIntervalMs);
+        m_reconnectTimer.start(m_reconnectIntervalMs);
     }
 }
 
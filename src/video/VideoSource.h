@@ -4,11 +4,21 @@
 #include <QObject>
 #include <QImage>
 #include <QMutex>
-#include <QTimer>
+#include <QPointer>
 #include <QUrl>
 
+#include "sensors/SensorClock.h"
+#include "video/VideoDecoder.h"
+#include "utils/FramePool.h"
+#include "utils/LatencyStats.h"
+#include "utils/TimerService.h"
+#include "utils/VideoFrame.h"
+
 namespace CounterUAS {
 
+class MetricCounter;
+class MetricGauge;
+
 /**
  * @brief Video source status
  */
@@ -27,13 +37,43 @@ enum class VideoSourceStatus {
  */
 struct VideoSourceStats {
     qint64 framesReceived = 0;
-    qint64 framesDropped = 0;
-    double fps = 0.0;
+    qint64 framesDropped = 0;          // Shed or skipped by the decoder, for sources with one
+    double fps = 0.0;                  // Frames emitted, over the last second
     double bitrate = 0.0;
     int width = 0;
     int height = 0;
-    qint64 latencyMs = 0;
+    qint64 latencyMs = 0;              // Capture to emit, mean, when captureTimestamps
+    qint64 latencyMaxMs = 0;
     qint64 lastFrameTime = 0;
+    bool captureTimestamps = false;    // Frames carry their capture time
+    
+    // Filled when the source decodes through a VideoDecoder
+    QString decoderBackend;
+    bool hardwareDecode = false;
+    double decodeLatencyMs = 0.0;      // Mean, submit to decoded frame
+    double decodeLatencyMaxMs = 0.0;
+    qint64 decodeFailures = 0;
+    qint64 decodeFallbacks = 0;        // Hardware backends abandoned for software
+    int decodeQueueDepth = 0;
+    VideoDecodeMode decodeMode = VideoDecodeMode::All;
+    double packetFps = 0.0;            // Submitted to the decoder; fps is what it kept
+    qint64 decodeSkipped = 0;          // Left undecoded by the decode mode
+    qint64 skippedNonReference = 0;
+    qint64 skippedNonKey = 0;
+    qint64 skippedBacklog = 0;
+    
+    // Filled by sources that see the camera's stream packets (GigE Vision)
+    int packetSize = 0;                // Negotiated, IP headers included
+    qint64 packetsReceived = 0;
+    qint64 packetsResent = 0;          // Recovered by resend requests
+    qint64 packetsMissing = 0;         // Lost for good; their frames are dropped
+    qint64 framesIncomplete = 0;
+    
+    // Filled by the native RTP ingest path (RTSP low-latency mode)
+    qint64 rtpPacketsLost = 0;
+    qint64 rtpPacketsLate = 0;
+    double rtpJitterMs = 0.0;
+    int jitterBufferMs = 0;
 };
 
 /**
@@ -65,8 +105,9 @@ public:
     virtual void resume();
     bool isStreaming() const { return m_streaming; }
     
-    // Frame access
+    // Frame access. currentFrame() converts a YUV frame to RGB.
     QImage currentFrame() const;
+    VideoFrame currentVideoFrame() const;
     qint64 currentFrameNumber() const { return m_stats.framesReceived; }
     qint64 currentTimestamp() const { return m_currentTimestamp; }
     
@@ -88,7 +129,27 @@ public:
     void setReconnectInterval(int ms) { m_reconnectIntervalMs = ms; }
     int reconnectInterval() const { return m_reconnectIntervalMs; }
     
+    // Sources fed compressed packets decode through this; its frames are
+    // emitted as the source's own and its counters join stats(). A packet
+    // submitted with a non-zero timestamp gives its capture time, Unix ms.
+    void attachDecoder(VideoDecoder* decoder);
+    VideoDecoder* decoder() const { return m_decoder; }
+    
+    // What the decoder may skip under load; kept for a decoder attached later
+    void setDecodeMode(VideoDecodeMode mode);
+    VideoDecodeMode decodeMode() const { return m_decodeMode; }
+    
+    // The camera's clock against C2, fitted from capture times; frames are
+    // emitted with their capture times corrected by it
+    SensorClockHealthPtr clockHealth() const { return m_clock->health(); }
+    
+    // Buffers behind the frames this source emits
+    FramePool::Stats framePoolStats() const { return m_framePool.stats(); }
+    
 signals:
+    // Every frame in its native format. frameReady carries the same frame
+    // as RGB and is only converted for when something is connected to it.
+    void videoFrameReady(const VideoFrame& frame, qint64 timestamp);
     void frameReady(const QImage& frame, qint64 timestamp);
     void statusChanged(VideoSourceStatus status);
     void streamingChanged(bool streaming);
@@ -105,7 +166,14 @@ protected slots:
 protected:
     void setStatus(VideoSourceStatus status);
     void setError(const QString& message);
+    void emitFrame(const VideoFrame& frame);
     void emitFrame(const QImage& frame);
+    // Stamped with when the camera took it rather than when it got here
+    void emitFrame(const VideoFrame& frame, qint64 captureTimeMs);
+    
+    // Called by updateStats() before it publishes; sources copy in counters
+    // kept elsewhere
+    virtual void collectStats() {}
     
     QString m_sourceId;
     QUrl m_url;
@@ -113,13 +181,18 @@ protected:
     VideoSourceStats m_stats;
     QString m_errorString;
     
+    // Frames for emitFrame(); consumers share them by reference
+    FramePool m_framePool;
+    QPointer<VideoDecoder> m_decoder;
+    VideoDecodeMode m_decodeMode = VideoDecodeMode::All;
+    
     mutable QMutex m_frameMutex;
-    QImage m_currentFrame;
+    VideoFrame m_currentFrame;
     qint64 m_currentTimestamp = 0;
     
-    QTimer* m_frameTimer;
-    QTimer* m_statsTimer;
-    QTimer* m_reconnectTimer;
+    ServiceTimer m_frameTimer;         // Sources that poll for frames set its callback
+    ServiceTimer m_statsTimer;
+    ServiceTimer m_reconnectTimer;
     
     double m_targetFPS = 30.0;
     int m_bufferSize = 3;
@@ -129,6 +202,15 @@ protected:
     
     qint64 m_lastStatsTime = 0;
     qint64 m_framesAtLastStats = 0;
+    quint64 m_packetsAtLastStats = 0;
+    LatencyStats m_captureLatency;     // Microseconds, since the last stats update
+    std::unique_ptr<SensorClock> m_clock;
+    
+    // Fleet monitoring series labelled with the source id
+    MetricCounter* m_framesMetric = nullptr;
+    MetricCounter* m_droppedMetric = nullptr;
+    MetricGauge* m_fpsMetric = nullptr;
+    MetricGauge* m_latencyMetric = nullptr;
 };
 
 } // namespace CounterUAS
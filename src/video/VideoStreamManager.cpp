@@ -2,9 +2,20 @@
 #include "video/RTSPVideoSource.h"
 #include "video/GigEVideoSource.h"
 #include "video/FileVideoSource.h"
+#include "video/RemoteVideoSource.h"
 #include "video/VideoRecorder.h"
+#include "video/RecordingStorage.h"
+#include "video/VideoServiceClient.h"
+#include "video/VisualDetector.h"
+#include "utils/CoordinateUtils.h"
 #include "utils/Logger.h"
+#include "utils/StatusBoard.h"
+#include <QDateTime>
+#include <QDir>
+#include <QMetaMethod>
 #include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
 #include <cmath>
 
 namespace CounterUAS {
@@ -12,6 +23,14 @@ namespace CounterUAS {
 VideoStreamManager::VideoStreamManager(QObject* parent)
     : QObject(parent)
 {
+    // Every change a status display shows, whichever path made it
+    const auto publish = [this](const QString& cameraId) { publishStatus(cameraId); };
+    connect(this, &VideoStreamManager::streamAdded, this, publish);
+    connect(this, &VideoStreamManager::streamRemoved, this, publish);
+    connect(this, &VideoStreamManager::streamStatusChanged, this, publish);
+    connect(this, &VideoStreamManager::streamProfileChanged, this, publish);
+    connect(this, &VideoStreamManager::recordingStarted, this, publish);
+    connect(this, &VideoStreamManager::recordingStopped, this, publish);
 }
 
 VideoStreamManager::~VideoStreamManager() {
@@ -19,6 +38,16 @@ VideoStreamManager::~VideoStreamManager() {
 }
 
 QString VideoStreamManager::addStream(const CameraDefinition& camera) {
+    return registerStream(camera, nullptr, true);
+}
+
+QString VideoStreamManager::addExternalStream(const CameraDefinition& camera, VideoSource* source) {
+    if (!source) return QString();
+    return registerStream(camera, source, false);
+}
+
+QString VideoStreamManager::registerStream(const CameraDefinition& camera, VideoSource* source,
+                                           bool owned) {
     QMutexLocker locker(&m_mutex);
     
     if (m_streams.size() >= MAX_STREAMS) {
@@ -33,16 +62,25 @@ QString VideoStreamManager::addStream(const CameraDefinition& camera) {
         return camera.cameraId;
     }
     
-    VideoSource* source = createSource(camera);
+    if (owned) {
+        source = createSource(camera);
+    }
     if (!source) {
         return QString();
     }
     
     m_streams[camera.cameraId] = source;
+    if (!owned) {
+        m_externalStreams.insert(camera.cameraId);
+    }
     m_cameras[camera.cameraId] = camera;
+    if (owned && !camera.profiles.isEmpty() && !qobject_cast<RemoteVideoSource*>(source)) {
+        m_profiles.insert(camera.cameraId, ProfileState());
+    }
+    applySheddingLocked();
     
     // Connect signals
-    connect(source, &VideoSource::frameReady,
+    connect(source, &VideoSource::videoFrameReady,
             this, &VideoStreamManager::onStreamFrameReady);
     connect(source, &VideoSource::statusChanged,
             this, &VideoStreamManager::onStreamStatusChanged);
@@ -69,12 +107,24 @@ void VideoStreamManager::removeStream(const QString& cameraId) {
         m_recorders[cameraId]->stop();
         delete m_recorders.take(cameraId);
     }
+    m_remoteRecording.remove(cameraId);   // Closing the remote source ends it there
+    m_sensorMetadata.remove(cameraId);
     
-    source->stop();
-    source->close();
-    delete source;
+    if (m_externalStreams.remove(cameraId)) {
+        disconnect(source, nullptr, this, nullptr);
+    } else {
+        source->stop();
+        source->close();
+        delete source;
+    }
     
     m_cameras.remove(cameraId);
+    m_distributor.setStreamRateCap(cameraId, 0.0);
+    auto profile = m_profiles.find(cameraId);
+    if (profile != m_profiles.end()) {
+        dropStandby(profile.value());
+        m_profiles.erase(profile);
+    }
     
     // Clear track associations
     QStringList tracksToRemove;
@@ -92,6 +142,7 @@ void VideoStreamManager::removeStream(const QString& cameraId) {
         if (!m_streams.isEmpty()) {
             m_primaryStreamId = m_streams.keys().first();
         }
+        applySheddingLocked();
     }
     
     locker.unlock();
@@ -131,18 +182,29 @@ int VideoStreamManager::activeStreamCount() const {
 }
 
 void VideoStreamManager::startStream(const QString& cameraId) {
-    VideoSource* source = stream(cameraId);
+    // Stopped, a camera with profiles changes stream without a standby
+    selectProfile(cameraId);
+    
+    QMutexLocker locker(&m_mutex);
+    VideoSource* source = m_streams.value(cameraId);
     if (!source) return;
+    const CameraDefinition camera = m_cameras.value(cameraId);
+    const QString url = profileUrl(camera, m_profiles.value(cameraId).active);
+    locker.unlock();
     
     if (!source->isOpen()) {
-        CameraDefinition camera = m_cameras.value(cameraId);
-        source->open(QUrl(camera.streamUrl));
+        source->open(QUrl(url));
     }
     source->start();
 }
 
 void VideoStreamManager::stopStream(const QString& cameraId) {
-    VideoSource* source = stream(cameraId);
+    QMutexLocker locker(&m_mutex);
+    auto profile = m_profiles.find(cameraId);
+    if (profile != m_profiles.end()) dropStandby(profile.value());
+    VideoSource* source = m_streams.value(cameraId);
+    locker.unlock();
+    
     if (source) {
         source->stop();
     }
@@ -175,10 +237,12 @@ void VideoStreamManager::setPrimaryStream(const QString& cameraId) {
     
     if (m_streams.contains(cameraId) && m_primaryStreamId != cameraId) {
         m_primaryStreamId = cameraId;
+        applySheddingLocked();
         
         locker.unlock();
         
         emit primaryStreamChanged(cameraId);
+        updateProfiles();
     }
 }
 
@@ -186,12 +250,30 @@ VideoSource* VideoStreamManager::primaryStream() const {
     return stream(m_primaryStreamId);
 }
 
+QString VideoStreamManager::activeProfile(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    if (!m_streams.contains(cameraId)) return QString();
+    return profileName(m_cameras.value(cameraId), m_profiles.value(cameraId).active);
+}
+
 void VideoStreamManager::startRecording(const QString& cameraId, const QString& outputPath) {
+    startRecording(cameraId, outputPath, nullptr);
+}
+
+void VideoStreamManager::startRecording(const QString& cameraId, const QString& outputPath,
+                                        RecordingStorage* storage) {
     QMutexLocker locker(&m_mutex);
     
     VideoSource* source = m_streams.value(cameraId);
     if (!source) return;
     
+    // The service records its own native frames; recordingStarted follows its event
+    if (m_service && qobject_cast<RemoteVideoSource*>(source)) {
+        locker.unlock();
+        m_service->startRecording(cameraId, outputPath);
+        return;
+    }
+    
     if (m_recorders.contains(cameraId)) {
         m_recorders[cameraId]->stop();
         delete m_recorders[cameraId];
@@ -199,10 +281,12 @@ void VideoStreamManager::startRecording(const QString& cameraId, const QString&
     
     VideoRecorder* recorder = new VideoRecorder(this);
     m_recorders[cameraId] = recorder;
+    if (storage) recorder->setStorage(storage, cameraId);
+    if (m_sensorMetadata.contains(cameraId)) recorder->setSensorMetadata(m_sensorMetadata.value(cameraId));
     
     // Connect source to recorder
-    connect(source, &VideoSource::frameReady,
-            recorder, &VideoRecorder::addFrame);
+    connect(source, &VideoSource::videoFrameReady,
+            recorder, &VideoRecorder::addVideoFrame);
     
     recorder->start(outputPath);
     
@@ -214,11 +298,28 @@ void VideoStreamManager::startRecording(const QString& cameraId, const QString&
                                .arg(outputPath));
     
     emit recordingStarted(cameraId);
+    updateProfiles();
+}
+
+void VideoStreamManager::setSensorMetadata(const QString& cameraId, const SensorMetadata& metadata) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_streams.contains(cameraId)) return;
+        m_sensorMetadata[cameraId] = metadata;
+        if (VideoRecorder* recorder = m_recorders.value(cameraId)) recorder->setSensorMetadata(metadata);
+    }
+    emit sensorMetadataChanged(cameraId, metadata);
 }
 
 void VideoStreamManager::stopRecording(const QString& cameraId) {
     QMutexLocker locker(&m_mutex);
     
+    if (m_service && m_remoteRecording.contains(cameraId)) {
+        locker.unlock();
+        m_service->stopRecording(cameraId);
+        return;
+    }
+    
     VideoRecorder* recorder = m_recorders.take(cameraId);
     if (recorder) {
         recorder->stop();
@@ -230,13 +331,18 @@ void VideoStreamManager::stopRecording(const QString& cameraId) {
                                "Stopped recording: " + cameraId);
         
         emit recordingStopped(cameraId);
+        updateProfiles();
     }
 }
 
 void VideoStreamManager::startAllRecording(const QString& outputDir) {
     QList<QString> ids = streamIds();
     for (const QString& id : ids) {
-        QString path = QString("%1/%2_%3.mp4")
+        if (m_storage) {
+            startRecording(id, QDir(m_storage->cameraDirectory(id)).filePath(id + ".mkv"), m_storage);
+            continue;
+        }
+        QString path = QString("%1/%2_%3.mkv")
                            .arg(outputDir)
                            .arg(id)
                            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
@@ -253,10 +359,28 @@ void VideoStreamManager::stopAllRecording() {
 
 bool VideoStreamManager::isRecording(const QString& cameraId) const {
     QMutexLocker locker(&m_mutex);
-    return m_recorders.contains(cameraId);
+    return m_recorders.contains(cameraId) || m_remoteRecording.contains(cameraId);
+}
+
+RecordingPosition VideoStreamManager::recordingPosition(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    const VideoRecorder* recorder = m_recorders.value(cameraId);
+    return recorder ? recorder->recordingPosition() : RecordingPosition();
+}
+
+RecorderStats VideoStreamManager::recorderStats(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    const VideoRecorder* recorder = m_recorders.value(cameraId);
+    return recorder ? recorder->stats() : RecorderStats();
 }
 
 void VideoStreamManager::slewCamera(const QString& cameraId, const GeoPosition& target) {
+    if (m_service && qobject_cast<RemoteVideoSource*>(stream(cameraId))) {
+        // cameraSlewing follows the service's event
+        m_service->slewCamera(cameraId, target);
+        return;
+    }
+    
     // Would send PTZ command to camera
     emit cameraSlewing(cameraId, target);
     
@@ -283,13 +407,10 @@ QString VideoStreamManager::findNearestCamera(const GeoPosition& target) const {
     QString nearest;
     double minDist = std::numeric_limits<double>::max();
     
-    Track tempTrack("temp");
-    tempTrack.setPosition(target);
-    
     for (auto it = m_cameras.begin(); it != m_cameras.end(); ++it) {
         if (!it.value().hasPTZ) continue;
         
-        double dist = tempTrack.distanceTo(it.value().position);
+        double dist = CoordinateUtils::haversineDistance(target, it.value().position);
         if (dist < minDist) {
             minDist = dist;
             nearest = it.key();
@@ -319,14 +440,51 @@ QList<VideoStreamManager::StreamStatus> VideoStreamManager::allStreamStatus() co
         status.cameraId = it.key();
         status.status = it.value()->status();
         status.recording = m_recorders.contains(it.key());
-        status.fps = it.value()->stats().fps;
-        status.resolution = QSize(it.value()->stats().width, it.value()->stats().height);
+        const VideoSourceStats stats = it.value()->stats();
+        status.fps = stats.fps;
+        status.resolution = QSize(stats.width, stats.height);
+        status.profile = profileName(m_cameras.value(it.key()), m_profiles.value(it.key()).active);
+        status.decodeMode = it.value()->decodeMode();
+        status.packetFps = stats.packetFps;
+        status.framesSkipped = stats.decodeSkipped;
         result.append(status);
     }
     
     return result;
 }
 
+void VideoStreamManager::publishStatus(const QString& cameraId, bool fromFrame) {
+    QMutexLocker locker(&m_mutex);
+    VideoSource* source = m_streams.value(cameraId);
+    if (!source) {
+        m_statusPublishedMs.remove(cameraId);
+        locker.unlock();
+        StatusBoard::instance().remove(cameraId, StatusKind::Camera);
+        return;
+    }
+    
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    qint64& publishedMs = m_statusPublishedMs[cameraId];
+    if (fromFrame && nowMs - publishedMs < STATUS_INTERVAL_MS) return;
+    publishedMs = nowMs;
+    
+    const VideoSourceStats stats = source->stats();
+    const CameraDefinition camera = m_cameras.value(cameraId);
+    const QVariantHash fields{
+        {"name", camera.name.isEmpty() ? cameraId : camera.name},
+        {"status", static_cast<int>(source->status())},
+        {"recording", m_recorders.contains(cameraId) || m_remoteRecording.contains(cameraId)},
+        {"fps", std::round(stats.fps * 10.0) / 10.0},
+        {"width", stats.width},
+        {"height", stats.height},
+        {"profile", profileName(camera, m_profiles.value(cameraId).active)},
+        {"decodeMode", static_cast<int>(source->decodeMode())},
+        {"framesSkipped", stats.decodeSkipped}
+    };
+    locker.unlock();
+    StatusBoard::instance().publish(cameraId, StatusKind::Camera, fields);
+}
+
 void VideoStreamManager::onTrackUpdated(const QString& trackId, const GeoPosition& pos) {
     QString cameraId = cameraForTrack(trackId);
     if (!cameraId.isEmpty()) {
@@ -339,15 +497,287 @@ void VideoStreamManager::onTrackDropped(const QString& trackId) {
     m_trackCameraMap.remove(trackId);
 }
 
-void VideoStreamManager::onStreamFrameReady(const QImage& frame, qint64 timestamp) {
-    Q_UNUSED(timestamp)
+int VideoStreamManager::subscribeFrames(const QString& cameraId, QObject* receiver,
+                                        const VideoDeliveryPolicy& policy,
+                                        VideoFrameDistributor::FrameCallback callback) {
+    const int id = m_distributor.subscribe(cameraId, receiver, policy, std::move(callback));
+    updateProfiles();
+    return id;
+}
+
+void VideoStreamManager::unsubscribeFrames(int subscriptionId) {
+    m_distributor.unsubscribe(subscriptionId);
+    updateProfiles();
+}
+
+void VideoStreamManager::setDeliveryPolicy(int subscriptionId, const VideoDeliveryPolicy& policy) {
+    m_distributor.setPolicy(subscriptionId, policy);
+    updateProfiles();
+}
+
+void VideoStreamManager::setSecondaryFrameRateCap(double maxFps) {
+    QMutexLocker locker(&m_mutex);
+    m_secondaryRateCap = qMax(0.0, maxFps);
+    applySheddingLocked();
+}
+
+double VideoStreamManager::secondaryFrameRateCap() const {
+    QMutexLocker locker(&m_mutex);
+    return m_secondaryRateCap;
+}
+
+void VideoStreamManager::setDecodeShedding(bool enable) {
+    QMutexLocker locker(&m_mutex);
+    if (m_decodeShedding == enable) return;
+    m_decodeShedding = enable;
+    applySheddingLocked();
+}
+
+bool VideoStreamManager::decodeShedding() const {
+    QMutexLocker locker(&m_mutex);
+    return m_decodeShedding;
+}
+
+VideoDecodeMode VideoStreamManager::decodeMode(const QString& cameraId) const {
+    QMutexLocker locker(&m_mutex);
+    VideoSource* source = m_streams.value(cameraId);
+    return source ? source->decodeMode() : VideoDecodeMode::All;
+}
+
+VideoDecodeMode VideoStreamManager::decodeModeLocked(const QString& cameraId) const {
+    // What is watched closely or kept gets every frame it can keep up with
+    if (cameraId == m_primaryStreamId || m_recorders.contains(cameraId)) return VideoDecodeMode::Newest;
+    if (!m_decodeShedding) return VideoDecodeMode::All;
+    
+    const QSize demand = m_distributor.largestTargetSize(cameraId);
+    const bool thumbnail = demand.isValid() && demand.width() <= THUMBNAIL_MAX_WIDTH &&
+                           !m_distributor.hasNativeSubscriber(cameraId);
+    return thumbnail ? VideoDecodeMode::KeyframesOnly : VideoDecodeMode::SkipNonReference;
+}
+
+void VideoStreamManager::applySheddingLocked() {
+    for (auto it = m_streams.constBegin(); it != m_streams.constEnd(); ++it) {
+        const bool primary = it.key() == m_primaryStreamId;
+        m_distributor.setStreamRateCap(it.key(), primary ? 0.0 : m_secondaryRateCap);
+        it.value()->setDecodeMode(decodeModeLocked(it.key()));
+    }
+}
+
+void VideoStreamManager::setVisualDetector(VisualDetector* detector) {
+    m_detector = detector;
+}
+
+VisualDetector* VideoStreamManager::visualDetector() const {
+    return m_detector;
+}
+
+void VideoStreamManager::setVideoService(VideoServiceClient* service) {
+    if (m_service) disconnect(m_service, nullptr, this, nullptr);
+    m_service = service;
+    if (!service) return;
     
+    connect(service, &VideoServiceClient::recordingStarted, this, [this](const QString& cameraId) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_streams.contains(cameraId)) return;
+            m_remoteRecording.insert(cameraId);
+        }
+        emit recordingStarted(cameraId);
+    });
+    connect(service, &VideoServiceClient::recordingStopped, this, [this](const QString& cameraId) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_remoteRecording.remove(cameraId)) return;
+        }
+        emit recordingStopped(cameraId);
+    });
+    connect(service, &VideoServiceClient::cameraSlewing, this, &VideoStreamManager::cameraSlewing);
+    connect(service, &VideoServiceClient::connectedChanged, this, [this](bool connected) {
+        if (connected) return;
+        // The service's recordings are out of sight until it says hello again
+        QSet<QString> stopped;
+        {
+            QMutexLocker locker(&m_mutex);
+            stopped.swap(m_remoteRecording);
+        }
+        for (const QString& id : stopped) emit recordingStopped(id);
+    });
+}
+
+void VideoStreamManager::onStreamFrameReady(const VideoFrame& frame, qint64 timestamp) {
     VideoSource* source = qobject_cast<VideoSource*>(sender());
     if (source) {
-        emit frameReady(source->sourceId(), frame);
+        streamFrame(source, frame, timestamp);
     }
 }
 
+void VideoStreamManager::streamFrame(VideoSource* source, const VideoFrame& frame, qint64 timestamp) {
+    publishStatus(source->sourceId(), true);
+    m_distributor.publish(source->sourceId(), frame, timestamp);
+    if (m_detector) m_detector->submit(source->sourceId(), frame, timestamp);
+    emit videoFrameReady(source->sourceId(), frame);
+    if (isSignalConnected(QMetaMethod::fromSignal(&VideoStreamManager::frameReady))) {
+        emit frameReady(source->sourceId(), frame.toImage());
+    }
+}
+
+void VideoStreamManager::onStandbyFrameReady(const VideoFrame& frame, qint64 timestamp) {
+    VideoSource* standby = qobject_cast<VideoSource*>(sender());
+    if (!standby) return;
+    
+    QMutexLocker locker(&m_mutex);
+    const QString cameraId = standby->sourceId();
+    auto it = m_profiles.find(cameraId);
+    if (it == m_profiles.end() || it->standby != standby) return;
+    ProfileState& state = it.value();
+    
+    // Its first frame decoded from a keyframe: the standby takes over
+    VideoSource* previous = m_streams.value(cameraId);
+    disconnect(standby, nullptr, this, nullptr);
+    connect(standby, &VideoSource::videoFrameReady,
+            this, &VideoStreamManager::onStreamFrameReady);
+    connect(standby, &VideoSource::statusChanged,
+            this, &VideoStreamManager::onStreamStatusChanged);
+    VideoRecorder* recorder = m_recorders.value(cameraId);
+    if (recorder) {
+        connect(standby, &VideoSource::videoFrameReady,
+                recorder, &VideoRecorder::addVideoFrame);
+    }
+    m_streams[cameraId] = standby;
+    standby->setDecodeMode(decodeModeLocked(cameraId));
+    state.active = state.standbyProfile;
+    state.standby = nullptr;
+    state.standbyProfile = -1;
+    const QString profile = profileName(m_cameras.value(cameraId), state.active);
+    if (previous) {
+        disconnect(previous, nullptr, this, nullptr);
+        if (recorder) disconnect(previous, nullptr, recorder, nullptr);
+        previous->stop();
+        previous->close();
+        previous->deleteLater();
+    }
+    
+    locker.unlock();
+    
+    Logger::instance().info("VideoStreamManager",
+                           QString("%1 switched to the %2 stream").arg(cameraId, profile));
+    emit streamProfileChanged(cameraId, profile);
+    if (recorder) recorder->addVideoFrame(frame, timestamp);
+    streamFrame(standby, frame, timestamp);
+}
+
+int VideoStreamManager::chooseProfile(const CameraDefinition& camera, const QSize& demand, bool full) {
+    if (full || !demand.isValid() || demand.isEmpty()) return -1;
+    
+    // The smallest profile that fills the display without scaling up
+    int best = -1;
+    qint64 bestArea = 0;
+    for (int i = 0; i < camera.profiles.size(); ++i) {
+        const QSize resolution = camera.profiles[i].resolution;
+        if (resolution.isEmpty() || camera.profiles[i].streamUrl.isEmpty()) continue;
+        if (resolution.scaled(demand, Qt::KeepAspectRatio).width() > resolution.width()) continue;
+        const qint64 area = qint64(resolution.width()) * resolution.height();
+        if (best < 0 || area < bestArea) {
+            best = i;
+            bestArea = area;
+        }
+    }
+    return best;
+}
+
+QString VideoStreamManager::profileUrl(const CameraDefinition& camera, int profile) {
+    return profile >= 0 && profile < camera.profiles.size()
+        ? camera.profiles[profile].streamUrl : camera.streamUrl;
+}
+
+QString VideoStreamManager::profileName(const CameraDefinition& camera, int profile) {
+    if (profile < 0 || profile >= camera.profiles.size()) return QStringLiteral("main");
+    return camera.profiles[profile].name.isEmpty()
+        ? QString("profile%1").arg(profile + 1) : camera.profiles[profile].name;
+}
+
+void VideoStreamManager::updateProfiles() {
+    if (QThread::currentThread() != thread()) {
+        QMetaObject::invokeMethod(this, [this]() { updateProfiles(); }, Qt::QueuedConnection);
+        return;
+    }
+    QStringList ids;
+    {
+        QMutexLocker locker(&m_mutex);
+        ids = m_profiles.keys();
+    }
+    for (const QString& id : ids) selectProfile(id);
+    
+    // A subscriber or recorder come or gone may make a stream a thumbnail or no longer one
+    QMutexLocker locker(&m_mutex);
+    applySheddingLocked();
+}
+
+void VideoStreamManager::selectProfile(const QString& cameraId) {
+    const QSize demand = m_distributor.largestTargetSize(cameraId);
+    
+    QMutexLocker locker(&m_mutex);
+    auto it = m_profiles.find(cameraId);
+    VideoSource* source = m_streams.value(cameraId);
+    if (it == m_profiles.end() || !source) return;
+    ProfileState& state = it.value();
+    const CameraDefinition camera = m_cameras.value(cameraId);
+    const bool full = cameraId == m_primaryStreamId || m_recorders.contains(cameraId);
+    const int wanted = chooseProfile(camera, demand, full);
+    
+    if (wanted == state.active) {
+        dropStandby(state);
+        return;
+    }
+    if (!source->isStreaming()) {
+        // Nothing on screen to keep; the next start opens the wanted stream
+        dropStandby(state);
+        state.active = wanted;
+        if (source->isOpen()) source->close();
+        locker.unlock();
+        emit streamProfileChanged(cameraId, profileName(camera, wanted));
+        return;
+    }
+    if (state.standby && state.standbyProfile == wanted) return;
+    
+    dropStandby(state);
+    VideoSource* standby = createLocalSource(camera);
+    if (!standby) return;
+    standby->setTargetFPS(source->targetFPS());
+    standby->setDecodeMode(source->decodeMode());
+    state.standby = standby;
+    state.standbyProfile = wanted;
+    const quint64 generation = ++state.generation;
+    connect(standby, &VideoSource::videoFrameReady,
+            this, &VideoStreamManager::onStandbyFrameReady);
+    locker.unlock();
+    
+    // Both streams play until the standby's first frame
+    Logger::instance().info("VideoStreamManager",
+                           QString("%1 opening the %2 stream").arg(cameraId, profileName(camera, wanted)));
+    standby->open(QUrl(profileUrl(camera, wanted)));
+    standby->start();
+    QTimer::singleShot(PROFILE_SWITCH_TIMEOUT_MS, this, [this, cameraId, generation]() {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_profiles.find(cameraId);
+        if (it == m_profiles.end() || !it->standby || it->generation != generation) return;
+        dropStandby(it.value());
+        locker.unlock();
+        Logger::instance().warning("VideoStreamManager",
+                                  cameraId + ": no frame from the other stream, staying on this one");
+    });
+}
+
+void VideoStreamManager::dropStandby(ProfileState& state) {
+    if (!state.standby) return;
+    disconnect(state.standby, nullptr, this, nullptr);
+    state.standby->stop();
+    state.standby->close();
+    state.standby->deleteLater();
+    state.standby = nullptr;
+    state.standbyProfile = -1;
+}
+
 void VideoStreamManager::onStreamStatusChanged(VideoSourceStatus status) {
     VideoSource* source = qobject_cast<VideoSource*>(sender());
     if (source) {
@@ -356,12 +786,34 @@ void VideoStreamManager::onStreamStatusChanged(VideoSourceStatus status) {
 }
 
 VideoSource* VideoStreamManager::createSource(const CameraDefinition& camera) {
+    if (m_service) {
+        return new RemoteVideoSource(camera, m_service, this);
+    }
+    return createLocalSource(camera);
+}
+
+VideoSource* VideoStreamManager::createLocalSource(const CameraDefinition& camera) {
     VideoSource* source = nullptr;
     
     if (camera.sourceType == "RTSP" || camera.sourceType.isEmpty()) {
-        source = new RTSPVideoSource(camera.cameraId, this);
+        RTSPVideoSource* rtsp = new RTSPVideoSource(camera.cameraId, this);
+        RTSPConfig config = rtsp->config();
+        const QVariantMap& m = camera.metadata;
+        config.useTCP = m.value("transport", config.useTCP ? "tcp" : "udp").toString().toLower() != "udp";
+        config.lowLatencyMode = m.value("lowLatency", config.lowLatencyMode).toBool();
+        config.jitterBufferMs = m.value("jitterBufferMs", config.jitterBufferMs).toInt();
+        rtsp->setConfig(config);
+        source = rtsp;
     } else if (camera.sourceType == "GigE") {
-        source = new GigEVideoSource(camera.cameraId, this);
+        GigEVideoSource* gige = new GigEVideoSource(camera.cameraId, this);
+        GigEConfig config = gige->config();
+        const QVariantMap& m = camera.metadata;
+        config.packetSize = m.value("packetSize", config.packetSize).toInt();
+        config.jumboFrames = m.value("jumboFrames", config.jumboFrames).toBool();
+        config.frameBufferCount = m.value("frameBufferCount", config.frameBufferCount).toInt();
+        config.pixelFormat = m.value("pixelFormat", config.pixelFormat).toInt();
+        gige->setConfig(config);
+        source = gige;
     } else if (camera.sourceType == "FILE") {
         source = new FileVideoSource(camera.cameraId, this);
     } else {
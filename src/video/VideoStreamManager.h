@@ -4,7 +4,12 @@
 #include <QObject>
 #include <QHash>
 #include <QMutex>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
 #include "video/VideoSource.h"
+#include "video/VideoFrameDistributor.h"
+#include "video/KlvEncoder.h"
 #include "core/Track.h"
 
 namespace CounterUAS {
@@ -13,6 +18,20 @@ class RTSPVideoSource;
 class GigEVideoSource;
 class FileVideoSource;
 class VideoRecorder;
+struct RecordingPosition;
+struct RecorderStats;
+class RecordingStorage;
+class VideoServiceClient;
+class VisualDetector;
+
+/**
+ * @brief One of a camera's encodings, on its own URL
+ */
+struct StreamProfile {
+    QString name;               // "sub", "third", ...
+    QString streamUrl;
+    QSize resolution;           // As the camera encodes it
+};
 
 /**
  * @brief Camera definition for stream management
@@ -20,7 +39,8 @@ class VideoRecorder;
 struct CameraDefinition {
     QString cameraId;
     QString name;
-    QString streamUrl;
+    QString streamUrl;          // Main stream, full resolution
+    QVector<StreamProfile> profiles;  // Smaller streams of the same view
     QString sourceType;  // "RTSP", "GigE", "FILE", "USB"
     GeoPosition position;
     bool hasPTZ = false;
@@ -32,6 +52,30 @@ struct CameraDefinition {
 
 /**
  * @brief Video Stream Manager for multi-source video handling
+ *
+ * Displays subscribe to a stream with subscribeFrames() and a delivery
+ * policy (size, frame rate, latest-only), and get frames already scaled for
+ * them off the GUI thread. videoFrameReady still carries every native
+ * frame for consumers that need them all, such as recorders.
+ *
+ * With a video service set, streams added from then on are decoded in the
+ * service and arrive here as RemoteVideoSources; recording and slewing of
+ * those streams are forwarded to the service too.
+ *
+ * A camera with profiles is decoded from the smallest one that still fills
+ * the largest display subscribed to it, so grid tiles cost a substream
+ * decode. The primary stream, and any camera without sized subscribers,
+ * plays the main stream. A change of profile opens the new stream beside
+ * the playing one and cuts over on its first decoded frame, which a
+ * decoder only gives from a keyframe, so displays see no gap; subscribers
+ * at native size take whichever stream is playing. Streams decoded in the
+ * service, and external ones, keep the URL they were added with.
+ *
+ * Each stream's decoder is given a decode mode. The primary stream, and
+ * any being recorded, always prefer the newest frame: a backlog skips to
+ * its latest keyframe. With decode shedding on, the other streams skip
+ * non-reference pictures, and those only shown as thumbnails decode
+ * keyframes alone.
  */
 class VideoStreamManager : public QObject {
     Q_OBJECT
@@ -40,12 +84,17 @@ class VideoStreamManager : public QObject {
 public:
     static constexpr int MAX_STREAMS = 16;
     static constexpr int MAX_DISPLAY_STREAMS = 9;
+    static constexpr int PROFILE_SWITCH_TIMEOUT_MS = 5000;   // Standby stream without a frame
+    static constexpr int STATUS_INTERVAL_MS = 1000;          // Frame rate to the StatusBoard
+    static constexpr int THUMBNAIL_MAX_WIDTH = 320;          // Displays no wider are thumbnails
     
     explicit VideoStreamManager(QObject* parent = nullptr);
     ~VideoStreamManager() override;
     
     // Stream management
     QString addStream(const CameraDefinition& camera);
+    // A source owned elsewhere (simulation); never stopped or deleted here
+    QString addExternalStream(const CameraDefinition& camera, VideoSource* source);
     void removeStream(const QString& cameraId);
     void removeAllStreams();
     
@@ -64,17 +113,57 @@ public:
     // Frame access
     QImage currentFrame(const QString& cameraId) const;
     
+    // Per-subscriber delivery; the callback runs queued on receiver's thread
+    int subscribeFrames(const QString& cameraId, QObject* receiver,
+                        const VideoDeliveryPolicy& policy,
+                        VideoFrameDistributor::FrameCallback callback);
+    void unsubscribeFrames(int subscriptionId);
+    void setDeliveryPolicy(int subscriptionId, const VideoDeliveryPolicy& policy);
+    VideoDeliveryStats deliveryStats() const { return m_distributor.stats(); }
+    // Load shedding: every stream but the primary is delivered at no more
+    // than maxFps, whatever its subscribers ask for; 0 lifts the cap
+    void setSecondaryFrameRateCap(double maxFps);
+    double secondaryFrameRateCap() const;
+    // Load shedding in the decoders of every stream but the primary
+    void setDecodeShedding(bool enable);
+    bool decodeShedding() const;
+    VideoDecodeMode decodeMode(const QString& cameraId) const;
+    
+    // Every stream's frames also go to this detector, with their capture times
+    void setVisualDetector(VisualDetector* detector);
+    VisualDetector* visualDetector() const;
+    
+    // Decode new streams out of process; null decodes them here
+    void setVideoService(VideoServiceClient* service);
+    VideoServiceClient* videoService() const { return m_service; }
+    
     // Primary/selected stream
     void setPrimaryStream(const QString& cameraId);
     QString primaryStreamId() const { return m_primaryStreamId; }
     VideoSource* primaryStream() const;
     
+    // Name of the profile being decoded, "main" for streamUrl
+    QString activeProfile(const QString& cameraId) const;
+    
     // Recording
     void startRecording(const QString& cameraId, const QString& outputPath);
     void stopRecording(const QString& cameraId);
+    // With a recording storage, every camera records into its directory
+    // there, under its quotas, and outputDir is not used
     void startAllRecording(const QString& outputDir);
     void stopAllRecording();
     bool isRecording(const QString& cameraId) const;
+    // Where the camera's local recording can be read from now; invalid when
+    // it is not recording here (a service's recordings are its own)
+    RecordingPosition recordingPosition(const QString& cameraId) const;
+    // Counters of the camera's local recorder; all zero when it has none
+    RecorderStats recorderStats(const QString& cameraId) const;
+    void setRecordingStorage(RecordingStorage* storage) { m_storage = storage; }
+    RecordingStorage* recordingStorage() const { return m_storage; }
+    
+    // Where the camera points and what it tracks, for the KLV muxed into
+    // its recording and re-stream; from the GUI thread
+    void setSensorMetadata(const QString& cameraId, const SensorMetadata& metadata);
     
     // Camera slew
     void slewCamera(const QString& cameraId, const GeoPosition& target);
@@ -92,6 +181,10 @@ public:
         bool recording;
         double fps;
         QSize resolution;
+        QString profile;
+        VideoDecodeMode decodeMode;
+        double packetFps;           // Into the decoder; fps is what it kept
+        qint64 framesSkipped;       // By the decode mode
     };
     QList<StreamStatus> allStreamStatus() const;
     
@@ -99,32 +192,73 @@ signals:
     void streamAdded(const QString& cameraId);
     void streamRemoved(const QString& cameraId);
     void streamStatusChanged(const QString& cameraId, VideoSourceStatus status);
+    // As VideoSource: native frames, and RGB only when something listens
+    void videoFrameReady(const QString& cameraId, const VideoFrame& frame);
     void frameReady(const QString& cameraId, const QImage& frame);
     void primaryStreamChanged(const QString& cameraId);
+    void streamProfileChanged(const QString& cameraId, const QString& profile);
     void recordingStarted(const QString& cameraId);
     void recordingStopped(const QString& cameraId);
     void activeStreamCountChanged(int count);
     void cameraSlewing(const QString& cameraId, const GeoPosition& target);
     void cameraSlewComplete(const QString& cameraId);
+    void sensorMetadataChanged(const QString& cameraId, const SensorMetadata& metadata);
     
 public slots:
     void onTrackUpdated(const QString& trackId, const GeoPosition& pos);
     void onTrackDropped(const QString& trackId);
     
 private slots:
-    void onStreamFrameReady(const QImage& frame, qint64 timestamp);
+    void onStreamFrameReady(const VideoFrame& frame, qint64 timestamp);
     void onStreamStatusChanged(VideoSourceStatus status);
+    void onStandbyFrameReady(const VideoFrame& frame, qint64 timestamp);
     
 private:
+    // A change of profile in flight
+    struct ProfileState {
+        int active = -1;            // Index into profiles; -1 for the main stream
+        int standbyProfile = -1;
+        VideoSource* standby = nullptr;
+        quint64 generation = 0;     // Of the standby, for its timeout
+    };
+    
     VideoSource* createSource(const CameraDefinition& camera);
+    VideoSource* createLocalSource(const CameraDefinition& camera);
+    QString registerStream(const CameraDefinition& camera, VideoSource* source, bool owned);
+    
+    static int chooseProfile(const CameraDefinition& camera, const QSize& demand, bool full);
+    static QString profileUrl(const CameraDefinition& camera, int profile);
+    static QString profileName(const CameraDefinition& camera, int profile);
+    // From any thread; the profiles are changed on this object's thread
+    void updateProfiles();
+    void selectProfile(const QString& cameraId);
+    void dropStandby(ProfileState& state);
+    void streamFrame(VideoSource* source, const VideoFrame& frame, qint64 timestamp);
+    VideoDecodeMode decodeModeLocked(const QString& cameraId) const;
+    // Rate caps and decode modes, for the primary and the shedding now
+    void applySheddingLocked();
+    void startRecording(const QString& cameraId, const QString& outputPath, RecordingStorage* storage);
+    // The stream's status to the StatusBoard; fromFrame at most once a STATUS_INTERVAL_MS
+    void publishStatus(const QString& cameraId, bool fromFrame = false);
     
     mutable QMutex m_mutex;
     QHash<QString, VideoSource*> m_streams;
+    QSet<QString> m_externalStreams;
     QHash<QString, CameraDefinition> m_cameras;
     QHash<QString, VideoRecorder*> m_recorders;
     QHash<QString, QString> m_trackCameraMap;  // trackId -> cameraId
+    QHash<QString, SensorMetadata> m_sensorMetadata;   // Latest, for recorders started later
+    QHash<QString, ProfileState> m_profiles;   // Owned local streams with profiles
     
     QString m_primaryStreamId;
+    double m_secondaryRateCap = 0.0;
+    bool m_decodeShedding = false;
+    VideoFrameDistributor m_distributor;
+    QPointer<VisualDetector> m_detector;
+    QPointer<VideoServiceClient> m_service;
+    QPointer<RecordingStorage> m_storage;
+    QSet<QString> m_remoteRecording;   // As reported by the service
+    QHash<QString, qint64> m_statusPublishedMs;
 };
 
 } // namespace CounterUAS
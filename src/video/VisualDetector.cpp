@@ -0,0 +1,345 @@
+#include "video/VisualDetector.h"
+#include "utils/Logger.h"
+#include "utils/ThreadPlacement.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+namespace CounterUAS {
+
+namespace {
+
+constexpr qint64 STATS_INTERVAL_MS = 1000;
+
+struct Registration {
+    QString name;
+    int priority = 0;
+    bool hardware = false;
+    VisualDetectorRegistry::Factory factory;
+};
+
+QMutex& registryMutex() {
+    static QMutex mutex;
+    return mutex;
+}
+
+QVector<Registration>& registrations() {
+    static QVector<Registration> list;
+    return list;
+}
+
+} // namespace
+
+void VisualDetectorRegistry::registerBackend(const QString& name, int priority, bool hardware,
+                                             Factory factory) {
+    if (name.isEmpty() || !factory) return;
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    auto it = std::find_if(list.begin(), list.end(),
+                           [&](const Registration& r) { return r.name == name; });
+    if (it != list.end()) list.erase(it);
+
+    Registration reg;
+    reg.name = name;
+    reg.priority = priority;
+    reg.hardware = hardware;
+    reg.factory = std::move(factory);
+    // Stable: among equal priorities the earlier registration wins
+    auto pos = std::find_if(list.begin(), list.end(),
+                            [&](const Registration& r) { return r.priority < priority; });
+    list.insert(pos, reg);
+}
+
+void VisualDetectorRegistry::unregisterBackend(const QString& name) {
+    QMutexLocker locker(&registryMutex());
+    QVector<Registration>& list = registrations();
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [&](const Registration& r) { return r.name == name; }),
+               list.end());
+}
+
+QStringList VisualDetectorRegistry::candidates(bool allowHardware) {
+    QMutexLocker locker(&registryMutex());
+    QStringList names;
+    for (const Registration& reg : registrations()) {
+        if (allowHardware || !reg.hardware) names.append(reg.name);
+    }
+    return names;
+}
+
+std::unique_ptr<VisualDetectorBackend> VisualDetectorRegistry::create(const QString& name) {
+    Factory factory;
+    {
+        QMutexLocker locker(&registryMutex());
+        for (const Registration& reg : registrations()) {
+            if (reg.name == name) {
+                factory = reg.factory;
+                break;
+            }
+        }
+    }
+    return factory ? factory() : nullptr;
+}
+
+VisualDetector::VisualDetector(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<CameraDetection>("CameraDetection");
+    qRegisterMetaType<VisualDetectorStats>("VisualDetectorStats");
+}
+
+VisualDetector::~VisualDetector() {
+    stop();
+}
+
+void VisualDetector::setConfig(const VisualDetectorConfig& config) {
+    QMutexLocker locker(&m_mutex);
+    m_config = config;
+    m_config.frameStride = qMax(1, m_config.frameStride);
+    m_config.batchTimeoutMs = qMax(0, m_config.batchTimeoutMs);
+    m_config.model.maxBatch = qMax(1, m_config.model.maxBatch);
+}
+
+VisualDetectorConfig VisualDetector::config() const {
+    QMutexLocker locker(&m_mutex);
+    return m_config;
+}
+
+bool VisualDetector::start() {
+    if (isRunning()) return true;
+    const VisualDetectorConfig config = this->config();
+
+    const QStringList names = config.backend.isEmpty()
+        ? VisualDetectorRegistry::candidates(config.model.allowHardware)
+        : QStringList{config.backend};
+    std::unique_ptr<VisualDetectorBackend> backend;
+    for (const QString& name : names) {
+        backend = VisualDetectorRegistry::create(name);
+        if (backend && backend->open(config.model)) break;
+        backend.reset();
+    }
+    if (!backend) {
+        const QString message = QString("No inference backend loads model %1").arg(config.model.path);
+        Logger::instance().warning("VisualDetector", message);
+        emit error(message);
+        return false;
+    }
+
+    const QString model = config.model.name.isEmpty() ? config.model.path : config.model.name;
+    const QString backendName = backend->name();
+    const int maxBatch = qBound(1, backend->maxBatch(), config.model.maxBatch);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_maxBatch = maxBatch;
+        m_backend = std::move(backend);
+        m_stopping = false;
+        m_stats = VisualDetectorStats();
+        m_stats.model = model;
+        m_stats.backend = backendName;
+        m_inferLatency.reset();
+        m_captureLatency.reset();
+        m_batchedFrames = 0;
+        m_rateStartMs = QDateTime::currentMSecsSinceEpoch();
+        m_rateFrames = 0;
+        m_worker = QThread::create([this]() { workerLoop(); });
+    }
+    m_worker->setObjectName("VisualDetector");
+    ThreadPlacement::instance().assign(m_worker, ThreadRole::VideoDecode);
+    m_worker->start();
+
+    Logger::instance().info("VisualDetector",
+                            QString("%1 on %2, batches of up to %3, frame stride %4")
+                                .arg(model, backendName)
+                                .arg(maxBatch)
+                                .arg(config.frameStride));
+    return true;
+}
+
+void VisualDetector::stop() {
+    QThread* worker = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_worker) return;
+        worker = m_worker;
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    worker->wait();
+    delete worker;
+
+    QMutexLocker locker(&m_mutex);
+    m_worker = nullptr;
+    m_backend->close();
+    m_backend.reset();
+    m_pending.clear();    // Gives the frames back to their pools
+    m_order.clear();
+    m_frameCounts.clear();
+}
+
+bool VisualDetector::isRunning() const {
+    QMutexLocker locker(&m_mutex);
+    return m_worker != nullptr;
+}
+
+QString VisualDetector::backendName() const {
+    QMutexLocker locker(&m_mutex);
+    return m_backend ? m_backend->name() : QString();
+}
+
+void VisualDetector::submit(const QString& cameraId, const VideoFrame& frame, qint64 timestamp) {
+    if (frame.isNull()) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_worker || m_stopping) return;
+        m_stats.framesSubmitted++;
+
+        const qint64 frameNumber = ++m_frameCounts[cameraId];
+        if ((frameNumber - 1) % m_config.frameStride != 0) {
+            m_stats.framesSkipped++;
+            return;
+        }
+
+        // A camera keeps its place, and its deadline, when a newer frame
+        // replaces the one waiting
+        auto waiting = m_pending.find(cameraId);
+        if (waiting != m_pending.end()) {
+            m_stats.framesDropped++;
+            waiting->frame = frame;
+            waiting->timestamp = timestamp;
+            waiting->frameNumber = frameNumber;
+            return;
+        }
+        Pending pending;
+        pending.frame = frame;
+        pending.timestamp = timestamp;
+        pending.frameNumber = frameNumber;
+        pending.queuedMs = QDateTime::currentMSecsSinceEpoch();
+        m_pending.insert(cameraId, pending);
+        m_order.enqueue(cameraId);
+    }
+    m_wake.wakeOne();
+}
+
+VisualDetectorStats VisualDetector::stats() const {
+    QMutexLocker locker(&m_mutex);
+    VisualDetectorStats stats = m_stats;
+    stats.meanBatchSize = stats.batches > 0 ? double(m_batchedFrames) / stats.batches : 0.0;
+    stats.inferMeanMs = m_inferLatency.meanUs / 1000.0;
+    stats.inferMaxMs = m_inferLatency.maxUs / 1000.0;
+    stats.latencyMeanMs = m_captureLatency.meanUs / 1000.0;
+    stats.latencyMaxMs = m_captureLatency.maxUs / 1000.0;
+    return stats;
+}
+
+void VisualDetector::workerLoop() {
+    forever {
+        QStringList cameras;
+        QVector<Pending> batch;
+        {
+            QMutexLocker locker(&m_mutex);
+            // Until the batch is full or its oldest frame has waited long enough
+            while (!m_stopping) {
+                if (m_order.isEmpty()) {
+                    m_wake.wait(&m_mutex);
+                    continue;
+                }
+                if (m_order.size() >= m_maxBatch) break;
+                const qint64 waited = QDateTime::currentMSecsSinceEpoch() -
+                                      m_pending.value(m_order.head()).queuedMs;
+                if (waited >= m_config.batchTimeoutMs) break;
+                m_wake.wait(&m_mutex, static_cast<unsigned long>(m_config.batchTimeoutMs - waited));
+            }
+            if (m_stopping) return;
+            while (!m_order.isEmpty() && batch.size() < m_maxBatch) {
+                const QString cameraId = m_order.dequeue();
+                cameras.append(cameraId);
+                batch.append(m_pending.take(cameraId));
+            }
+        }
+
+        QVector<VideoFrame> frames;
+        frames.reserve(batch.size());
+        for (const Pending& pending : batch) frames.append(pending.frame);
+
+        QVector<QVector<ImageDetection>> results;
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = m_backend->infer(frames, results);
+        const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+        frames.clear();
+
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!ok) {
+                m_stats.errors++;
+            } else {
+                m_stats.batches++;
+                m_stats.framesInferred += batch.size();
+                m_batchedFrames += batch.size();
+                m_rateFrames += batch.size();
+                m_inferLatency.record(elapsedUs);
+            }
+        }
+        if (!ok) {
+            emit error(QString("%1 failed on a batch of %2").arg(backendName()).arg(batch.size()));
+            continue;
+        }
+
+        const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+        for (int i = 0; i < batch.size(); ++i) {
+            publish(cameras[i], batch[i], results.value(i), nowMs);
+        }
+        updateRate(nowMs);
+    }
+}
+
+void VisualDetector::publish(const QString& cameraId, const Pending& pending,
+                             const QVector<ImageDetection>& found, qint64 nowMs) {
+    double threshold = 0.0;
+    QStringList classes;
+    {
+        QMutexLocker locker(&m_mutex);
+        threshold = m_config.confidenceThreshold;
+        classes = m_config.classes;
+        if (pending.timestamp > 0) m_captureLatency.record((nowMs - pending.timestamp) * 1000);
+    }
+
+    const QRectF unit(0.0, 0.0, 1.0, 1.0);
+    int published = 0;
+    for (const ImageDetection& hit : found) {
+        if (hit.confidence < threshold) continue;
+        if (!classes.isEmpty() && !classes.contains(hit.objectClass)) continue;
+        const QRectF box = hit.box.intersected(unit);
+        if (box.isEmpty()) continue;
+
+        // No thumbnail: cropping would convert every YUV frame to RGB here
+        CameraDetection detection;
+        detection.cameraId = cameraId;
+        detection.boundingBox = box;
+        detection.confidence = hit.confidence;
+        detection.objectClass = hit.objectClass;
+        detection.frameNumber = pending.frameNumber;
+        detection.timestamp = pending.timestamp > 0 ? pending.timestamp : nowMs;
+        emit cameraDetection(detection);
+        ++published;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_stats.detections += published;
+}
+
+void VisualDetector::updateRate(qint64 nowMs) {
+    {
+        QMutexLocker locker(&m_mutex);
+        const qint64 span = nowMs - m_rateStartMs;
+        if (span < STATS_INTERVAL_MS) return;
+        m_stats.framesPerSecond = m_rateFrames * 1000.0 / span;
+        m_rateStartMs = nowMs;
+        m_rateFrames = 0;
+    }
+    emit statsUpdated(stats());
+}
+
+} // namespace CounterUAS
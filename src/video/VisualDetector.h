@@ -0,0 +1,201 @@
+#ifndef VISUALDETECTOR_H
+#define VISUALDETECTOR_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
+
+#include "sensors/CameraSystem.h"
+#include "utils/LatencyStats.h"
+#include "utils/VideoFrame.h"
+
+class QThread;
+
+namespace CounterUAS {
+
+/**
+ * @brief One object found in a frame
+ */
+struct ImageDetection {
+    QRectF box;                 // Normalized 0-1 coordinates of the frame
+    double confidence = 0.0;
+    QString objectClass;
+};
+
+/**
+ * @brief Model a detector backend loads
+ */
+struct DetectorModel {
+    QString name;               // Label for stats and logs
+    QString path;               // Model file: .onnx, .engine, .xml
+    QSize inputSize = QSize(640, 640);
+    int maxBatch = 8;
+    bool allowHardware = true;
+};
+
+/**
+ * @brief One inference runtime behind VisualDetector
+ *
+ * Driven from the detector's worker thread only. A backend takes frames
+ * as they come from the sources' frame pools, in their native pixel
+ * format, and does its own resize and tensor packing; a GPU backend
+ * uploads the planes and letterboxes on the device.
+ */
+class VisualDetectorBackend {
+public:
+    virtual ~VisualDetectorBackend() = default;
+
+    virtual QString name() const = 0;
+    virtual bool isHardware() const = 0;
+
+    // False when the runtime, device or model is not available here
+    virtual bool open(const DetectorModel& model) = 0;
+    virtual void close() = 0;
+    // Largest batch the opened model takes; fixed-shape engines may be smaller
+    virtual int maxBatch() const = 0;
+
+    // One result list per frame, in batch order; false on a runtime error
+    virtual bool infer(const QVector<VideoFrame>& batch, QVector<QVector<ImageDetection>>& results) = 0;
+};
+
+/**
+ * @brief Process-wide list of inference backends, best first
+ *
+ * Runtime integrations (TensorRT, OpenVINO, ONNX Runtime) register
+ * themselves when built in; VisualDetector takes the first that loads the
+ * model, or the one named in its config.
+ */
+class VisualDetectorRegistry {
+public:
+    using Factory = std::function<std::unique_ptr<VisualDetectorBackend>()>;
+
+    static void registerBackend(const QString& name, int priority, bool hardware,
+                                Factory factory);
+    static void unregisterBackend(const QString& name);
+
+    static QStringList candidates(bool allowHardware);
+    static std::unique_ptr<VisualDetectorBackend> create(const QString& name);
+};
+
+/**
+ * @brief How frames are batched and filtered
+ */
+struct VisualDetectorConfig {
+    DetectorModel model;
+    QString backend;                // Empty for the first that opens the model
+    int frameStride = 5;            // Infer every Nth frame of each camera
+    int batchTimeoutMs = 10;        // Longest a frame waits for its batch to fill
+    double confidenceThreshold = 0.5;
+    QStringList classes;            // Reported classes; empty for all
+};
+
+/**
+ * @brief Throughput and latency of one detector's model
+ */
+struct VisualDetectorStats {
+    QString model;
+    QString backend;
+    quint64 framesSubmitted = 0;
+    quint64 framesSkipped = 0;      // By the stride
+    quint64 framesDropped = 0;      // Replaced by a newer frame of the camera before inference
+    quint64 framesInferred = 0;
+    quint64 batches = 0;
+    quint64 detections = 0;
+    quint64 errors = 0;
+    double meanBatchSize = 0.0;
+    double inferMeanMs = 0.0;       // Per batch, in the backend
+    double inferMaxMs = 0.0;
+    double latencyMeanMs = 0.0;     // Capture to publish
+    double latencyMaxMs = 0.0;
+    double framesPerSecond = 0.0;   // Inferred, over the last interval
+};
+
+/**
+ * @brief On-board inference stage turning video frames into camera detections
+ *
+ * Frames are submitted from any thread, typically straight from
+ * VideoStreamManager::videoFrameReady, and are kept by reference to their
+ * pooled buffers rather than copied. Each camera is sampled at the
+ * configured stride and holds at most one frame waiting, so a model slower
+ * than the cameras drops stale frames instead of falling behind.
+ *
+ * A worker thread gathers the waiting frames of all cameras into one batch,
+ * running as soon as the batch is full or its oldest frame has waited
+ * batchTimeoutMs, and publishes what the model finds through
+ * cameraDetection(), stamped with the frame's capture time, for
+ * CameraSystem::reportDetection() and the track pipeline behind it.
+ */
+class VisualDetector : public QObject {
+    Q_OBJECT
+
+public:
+    explicit VisualDetector(QObject* parent = nullptr);
+    ~VisualDetector() override;
+
+    // Takes effect on the next start()
+    void setConfig(const VisualDetectorConfig& config);
+    VisualDetectorConfig config() const;
+
+    // False when no backend opens the model
+    bool start();
+    void stop();
+    bool isRunning() const;
+    QString backendName() const;
+
+    // Any thread; timestamp is the frame's capture time, Unix ms
+    void submit(const QString& cameraId, const VideoFrame& frame, qint64 timestamp);
+
+    VisualDetectorStats stats() const;
+
+signals:
+    void cameraDetection(const CameraDetection& detection);
+    void statsUpdated(const VisualDetectorStats& stats);
+    void error(const QString& message);
+
+private:
+    struct Pending {
+        VideoFrame frame;
+        qint64 timestamp = 0;
+        qint64 frameNumber = 0;
+        qint64 queuedMs = 0;
+    };
+
+    void workerLoop();
+    void publish(const QString& cameraId, const Pending& pending,
+                 const QVector<ImageDetection>& found, qint64 nowMs);
+    void updateRate(qint64 nowMs);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    VisualDetectorConfig m_config;
+    std::unique_ptr<VisualDetectorBackend> m_backend;
+    int m_maxBatch = 1;
+    QThread* m_worker = nullptr;
+    bool m_stopping = false;
+
+    QHash<QString, qint64> m_frameCounts;    // By camera, for the stride
+    QHash<QString, Pending> m_pending;       // Newest per camera
+    QQueue<QString> m_order;                 // Cameras with a frame waiting, oldest first
+
+    VisualDetectorStats m_stats;
+    LatencyStats m_inferLatency;
+    LatencyStats m_captureLatency;
+    quint64 m_batchedFrames = 0;
+    qint64 m_rateStartMs = 0;
+    quint64 m_rateFrames = 0;
+};
+
+} // namespace CounterUAS
+
+Q_DECLARE_METATYPE(CounterUAS::VisualDetectorStats)
+
+#endif // VISUALDETECTOR_H
@@ -0,0 +1,85 @@
+/**
+ * Counter-UAS C2 video service
+ *
+ * Decodes, records and runs the detector on the cameras outside the GUI, and
+ * hands the frames to any C2 on the host through shared memory:
+ *
+ *   CounterUAS_VideoService --cameras cameras.json
+ *   CounterUAS_VideoService --name site-video --model yolo.onnx --slots 16
+ *
+ * The C2 uses it when its videoService/serverName setting names the
+ * service; streams from --cameras start at once, the rest are added by the
+ * C2. The service keeps streaming and recording when the C2 exits.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QTextStream>
+#include "config/CameraConfig.h"
+#include "video/VideoService.h"
+#include "video/VideoStreamManager.h"
+#include "utils/Logger.h"
+
+using namespace CounterUAS;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("CounterUAS_VideoService");
+    app.setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless video service for the Counter-UAS C2.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption({"name", "Local server name the C2 connects to.", "name", "counteruas-video"});
+    parser.addOption({"shm-key", "Shared-memory key for the frames; defaults to the server name.", "key"});
+    parser.addOption({"cameras", "Camera configuration file whose streams start at once.", "file"});
+    parser.addOption({"recordings", "Directory for relative recording paths.", "dir", "recordings"});
+    parser.addOption({"model", "Run the visual detector with this model file.", "file"});
+    parser.addOption({"slots", "Frames buffered in shared memory.", "count"});
+    parser.addOption({"max-frame-bytes", "Largest frame shared memory takes.", "bytes"});
+    parser.addOption({"capture", "Capture the raw PTZ feedback into this directory.", "dir"});
+    parser.process(app);
+
+    Logger::instance().setLogToConsole(true);
+    QTextStream err(stderr);
+
+    VideoServiceConfig config;
+    config.serverName = parser.value("name");
+    config.sharedMemory.key = parser.value("shm-key");
+    config.recordingDir = parser.value("recordings");
+    config.captureDirectory = parser.value("capture");
+    if (parser.isSet("slots")) {
+        config.sharedMemory.videoSlots = qMax(2, parser.value("slots").toInt());
+    }
+    if (parser.isSet("max-frame-bytes")) {
+        config.sharedMemory.maxVideoFrameBytes = qMax(1, parser.value("max-frame-bytes").toInt());
+    }
+    if (parser.isSet("model")) {
+        config.runDetector = true;
+        config.detector.model.path = parser.value("model");
+        config.detector.model.name = QFileInfo(config.detector.model.path).baseName();
+    }
+
+    VideoService service;
+    if (!service.start(config)) {
+        err << "Video service failed to start: " << service.errorString() << "\n";
+        return 1;
+    }
+
+    if (parser.isSet("cameras")) {
+        CameraConfig cameras;
+        if (!cameras.loadFromFile(parser.value("cameras"))) {
+            err << "Cannot read cameras from " << parser.value("cameras") << "\n";
+            return 1;
+        }
+        for (const CameraDefinition& camera : cameras.cameras()) {
+            const QString id = service.streamManager()->addStream(camera);
+            if (!id.isEmpty()) service.streamManager()->startStream(id);
+        }
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,245 @@
+#include <QtTest>
+#include <QJsonDocument>
+#include "network/MessageProtocol.h"
+#include "utils/JsonReader.h"
+#include "utils/JsonWriter.h"
+
+using namespace CounterUAS;
+
+/**
+ * Frame encode and decode of a typical track update, in both encodings;
+ * the binary frame carries every field through the schema. The typed run
+ * builds the same update as a TrackUpdateBody and serializes it from its
+ * fields. The codec run sets the QJsonDocument tree against the streaming
+ * JsonWriter and JsonReader on the message's JSON alone.
+ */
+class BenchMessageProtocol : public QObject {
+    Q_OBJECT
+
+private slots:
+    void benchmarkSerialize_data();
+    void benchmarkSerialize();
+    void benchmarkSerializeTyped_data();
+    void benchmarkSerializeTyped();
+    void benchmarkDeserialize_data();
+    void benchmarkDeserialize();
+    void benchmarkCompression_data();
+    void benchmarkCompression();
+    void benchmarkJsonCodec_data();
+    void benchmarkJsonCodec();
+
+private:
+    static Message trackUpdate();
+    static TrackUpdateBody trackUpdateBody();
+};
+
+Message BenchMessageProtocol::trackUpdate() {
+    QVariantMap data;
+    data["latitude"] = 34.0522;
+    data["longitude"] = -118.2437;
+    data["altitude"] = 120.0;
+    data["velocityNorth"] = -12.5;
+    data["velocityEast"] = 4.0;
+    data["velocityDown"] = 0.5;
+    data["classification"] = 2;
+    data["threatLevel"] = 4;
+    data["state"] = 2;
+    data["classificationConfidence"] = 0.9;
+    data["trackQuality"] = 0.85;
+    data["engaged"] = false;
+    data["lastUpdateTime"] = 1700000000000LL;
+    Message message = MessageProtocol::createTrackUpdate("TRK-0042", data);
+    // Fixed, so the frame is the same every run
+    message.sequenceNumber = 1;
+    message.timestamp = 1700000000000LL;
+    return message;
+}
+
+TrackUpdateBody BenchMessageProtocol::trackUpdateBody() {
+    TrackUpdateBody body;
+    body.trackId = QStringLiteral("TRK-0042");
+    body.latitude = 34.0522;
+    body.longitude = -118.2437;
+    body.altitude = 120.0;
+    body.velocityNorth = -12.5;
+    body.velocityEast = 4.0;
+    body.velocityDown = 0.5;
+    body.classification = 2;
+    body.threatLevel = 4;
+    body.state = 2;
+    body.classificationConfidence = 0.9;
+    body.trackQuality = 0.85;
+    body.engaged = false;
+    body.lastUpdateTime = 1700000000000LL;
+    return body;
+}
+
+void BenchMessageProtocol::benchmarkSerialize_data() {
+    QTest::addColumn<int>("encoding");
+    QTest::newRow("json") << static_cast<int>(WireEncoding::Json);
+    QTest::newRow("binary") << static_cast<int>(WireEncoding::Binary);
+}
+
+void BenchMessageProtocol::benchmarkSerialize() {
+    QFETCH(int, encoding);
+
+    MessageProtocol protocol;
+    const Message message = trackUpdate();
+    QByteArray frame;
+    QBENCHMARK {
+        frame = protocol.serialize(message, static_cast<WireEncoding>(encoding));
+    }
+    QVERIFY(frame.size() > MessageProtocol::HEADER_SIZE);
+}
+
+void BenchMessageProtocol::benchmarkSerializeTyped_data() {
+    benchmarkSerialize_data();
+}
+
+void BenchMessageProtocol::benchmarkSerializeTyped() {
+    QFETCH(int, encoding);
+
+    // Construction counts, as building the map does in the map form
+    MessageProtocol protocol;
+    const TrackUpdateBody body = trackUpdateBody();
+    QByteArray frame;
+    QBENCHMARK {
+        TypedMessage message = MessageProtocol::createMessage(body);
+        frame = protocol.serialize(message, static_cast<WireEncoding>(encoding));
+    }
+
+    // Decodes to what the map form sends, less the two fields it leaves out
+    Message decoded;
+    QCOMPARE(protocol.deserialize(frame, decoded), frame.size());
+    QCOMPARE(decoded.type, MessageType::TrackUpdate);
+    const Message expected = trackUpdate();
+    for (auto it = expected.payload.constBegin(); it != expected.payload.constEnd(); ++it) {
+        QVERIFY2(decoded.payload.contains(it.key()), qPrintable(it.key()));
+        // Single precision on the wire where the schema says so
+        QCOMPARE(float(decoded.payload.value(it.key()).toDouble()), float(it.value().toDouble()));
+    }
+    QCOMPARE(decoded.payload.value("trackId").toString(), QString("TRK-0042"));
+    QCOMPARE(decoded.payload.size(), expected.payload.size() + 2);
+}
+
+void BenchMessageProtocol::benchmarkDeserialize_data() {
+    benchmarkSerialize_data();
+}
+
+void BenchMessageProtocol::benchmarkDeserialize() {
+    QFETCH(int, encoding);
+
+    MessageProtocol protocol;
+    const QByteArray frame = protocol.serialize(trackUpdate(), static_cast<WireEncoding>(encoding));
+    Message message;
+    int consumed = 0;
+    QBENCHMARK {
+        consumed = protocol.deserialize(frame, message);
+    }
+    QCOMPARE(consumed, frame.size());
+    QCOMPARE(message.type, MessageType::TrackUpdate);
+}
+
+void BenchMessageProtocol::benchmarkCompression_data() {
+    QTest::addColumn<int>("codec");
+    QTest::addColumn<bool>("dictionary");
+    QTest::newRow("zlib") << static_cast<int>(CompressionCodec::Zlib) << false;
+    QTest::newRow("lz4") << static_cast<int>(CompressionCodec::Lz4) << false;
+    QTest::newRow("zstd") << static_cast<int>(CompressionCodec::Zstd) << false;
+    QTest::newRow("zstd-dictionary") << static_cast<int>(CompressionCodec::Zstd) << true;
+}
+
+void BenchMessageProtocol::benchmarkCompression() {
+    QFETCH(int, codec);
+    QFETCH(bool, dictionary);
+    if (!MessageProtocol::isCodecSupported(static_cast<CompressionCodec>(codec))) {
+        QSKIP("Codec not built in");
+    }
+
+    // JSON track updates: short, and alike from one track to the next
+    MessageProtocol protocol;
+    QVector<QByteArray> frames;
+    for (int i = 0; i < 200; ++i) {
+        Message message = trackUpdate();
+        message.payload["trackId"] = QString("TRK-%1").arg(i, 4, 10, QChar('0'));
+        message.payload["latitude"] = 34.0522 + i * 1e-4;
+        message.payload["threatLevel"] = i % 5;
+        frames.append(protocol.serialize(message, WireEncoding::Json));
+    }
+    CompressionOptions options;
+    options.codec = static_cast<CompressionCodec>(codec);
+    options.minPayloadBytes = 0;
+    if (dictionary) {
+        options.dictionaryId = protocol.addDictionary(MessageProtocol::trainDictionary(frames, 4096));
+        QVERIFY(options.dictionaryId != 0);
+    }
+
+    CompressionStats stats;
+    QByteArray compressed;
+    QBENCHMARK {
+        compressed = protocol.compressFrame(frames[7], options, &stats);
+    }
+    QVERIFY(compressed.size() <= frames[7].size());
+    qDebug("%d -> %d bytes", frames[7].size(), compressed.size());
+
+    Message message;
+    QCOMPARE(protocol.deserialize(compressed, message), compressed.size());
+    QCOMPARE(message.payload.value("trackId").toString(), QString("TRK-0007"));
+}
+
+void BenchMessageProtocol::benchmarkJsonCodec_data() {
+    QTest::addColumn<bool>("stream");
+    QTest::addColumn<bool>("parse");
+    QTest::newRow("write-document") << false << false;
+    QTest::newRow("write-stream") << true << false;
+    QTest::newRow("parse-document") << false << true;
+    QTest::newRow("parse-stream") << true << true;
+}
+
+void BenchMessageProtocol::benchmarkJsonCodec() {
+    QFETCH(bool, stream);
+    QFETCH(bool, parse);
+
+    Message message = trackUpdate();
+    message.payload["note"] = QStringLiteral("climbing \"fast\" past the\tfence");
+    JsonWriter writer;
+    message.writeJson(writer);
+    const QByteArray json = writer.buffer();
+    // Same document either way, so the rows compare like with like
+    QCOMPARE(QJsonDocument::fromJson(json).object(), message.toJson());
+
+    Message decoded;
+    if (!parse && !stream) {
+        QByteArray out;
+        QBENCHMARK {
+            out = QJsonDocument(message.toJson()).toJson(QJsonDocument::Compact);
+        }
+        QVERIFY(!out.isEmpty());
+    } else if (!parse) {
+        QBENCHMARK {
+            writer.clear();
+            message.writeJson(writer);
+        }
+        QCOMPARE(writer.buffer(), json);
+    } else if (!stream) {
+        QBENCHMARK {
+            decoded = Message::fromJson(QJsonDocument::fromJson(json).object());
+        }
+    } else {
+        QBENCHMARK {
+            JsonReader reader(json);
+            QVERIFY(Message::readJson(reader, decoded));
+        }
+    }
+    if (parse) {
+        const Message expected = Message::fromJson(QJsonDocument::fromJson(json).object());
+        QCOMPARE(decoded.type, expected.type);
+        QCOMPARE(decoded.sequenceNumber, expected.sequenceNumber);
+        QCOMPARE(decoded.timestamp, expected.timestamp);
+        QCOMPARE(decoded.sourceId, expected.sourceId);
+        QCOMPARE(decoded.payload, expected.payload);
+    }
+}
+
+QTEST_MAIN(BenchMessageProtocol)
+#include "bench_message_protocol.moc"
@@ -0,0 +1,378 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include "core/TrackManager.h"
+#include "network/MessageProtocol.h"
+#include "network/NetworkManager.h"
+#include "network/TrackPictureSync.h"
+#include "utils/LatencyHistogram.h"
+
+using namespace CounterUAS;
+
+/**
+ * Wire cost and loopback performance of NetworkManager, to compare wire
+ * formats before changing them.
+ *
+ * benchmarkCodec times MessageProtocol alone: bytes, serialize and
+ * deserialize per message, for track updates, detections and alerts, small
+ * and with a 512-character note, JSON and binary, plain and compressed.
+ *
+ * benchmarkLoopback drives a NetworkManager against itself on 127.0.0.1:
+ * over TCP through an echo server, so every frame makes a round trip, and
+ * over UDP into its own receive port, one way. It keeps a window of
+ * messages in flight and reports updates per second, wire bytes per
+ * update and the send-to-receive latency. The delta rows send the same
+ * track picture through TrackPictureSync, 100 tracks a cycle, and count
+ * each track a delta carries as one update, so their lines compare with
+ * the track-small rows. Rows run CUAS_NET_SECONDS each, 2 by default.
+ */
+class BenchNetwork : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchmarkCodec_data();
+    void benchmarkCodec();
+    void benchmarkLoopback_data();
+    void benchmarkLoopback();
+
+private:
+    enum Kind { Track, Detection, Alert };
+
+    static Message makeMessage(int kind, bool large, qint64 index);
+    static QString kindName(int kind, bool large);
+    static CompressionOptions compression();
+
+    int m_seconds = 2;
+};
+
+void BenchNetwork::initTestCase() {
+    if (qEnvironmentVariableIsSet("CUAS_NET_SECONDS")) {
+        m_seconds = qMax(1, qEnvironmentVariableIntValue("CUAS_NET_SECONDS"));
+    }
+}
+
+Message BenchNetwork::makeMessage(int kind, bool large, qint64 index) {
+    // The id carries the index, so the receiver can find the send time
+    const QString id = QString("B%1").arg(index);
+    const QString note = QStringLiteral("Held on EO and radar, bearing steady, closing on the north fence. ")
+                             .repeated(8).left(512);
+    Message message;
+    if (kind == Alert) {
+        message = MessageProtocol::createAlert(id, 3, large ? note : QStringLiteral("Track entered warning zone"));
+    } else {
+        QVariantMap data;
+        data["latitude"] = 34.0522 + (index % 1000) * 1e-5;
+        data["longitude"] = -118.2437;
+        data["altitude"] = 120.0;
+        data["velocityNorth"] = -12.5;
+        data["velocityEast"] = 4.0;
+        data["velocityDown"] = 0.5;
+        if (kind == Track) {
+            data["classification"] = 2;
+            data["threatLevel"] = 4;
+            data["state"] = 2;
+            data["classificationConfidence"] = 0.9;
+            data["trackQuality"] = 0.85;
+            data["engaged"] = false;
+            data["lastUpdateTime"] = 1700000000000LL;
+            if (large) data["notes"] = note;
+            message = MessageProtocol::createTrackUpdate(id, data);
+        } else {
+            data["signalStrength"] = -62.0;
+            data["confidence"] = 0.8;
+            data["sourceType"] = 1;
+            data["detectionTime"] = 1700000000000LL;
+            data["trackId"] = id;
+            if (large) data["notes"] = note;
+            message = MessageProtocol::createSensorDetection("BENCH-RADAR", data);
+        }
+    }
+    return message;
+}
+
+QString BenchNetwork::kindName(int kind, bool large) {
+    static const char* const names[] = {"track", "detection", "alert"};
+    return QString("%1-%2").arg(names[kind], large ? "large" : "small");
+}
+
+CompressionOptions BenchNetwork::compression() {
+    // What a LAN link would use; payloads under minPayloadBytes stay plain
+    CompressionOptions options;
+    options.codec = MessageProtocol::isCodecSupported(CompressionCodec::Lz4) ? CompressionCodec::Lz4
+                                                                             : CompressionCodec::Zlib;
+    return options;
+}
+
+void BenchNetwork::benchmarkCodec_data() {
+    QTest::addColumn<int>("encoding");
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<bool>("large");
+    QTest::addColumn<bool>("compressed");
+    for (int encoding : {static_cast<int>(WireEncoding::Json), static_cast<int>(WireEncoding::Binary)}) {
+        for (int kind : {Track, Detection, Alert}) {
+            for (bool large : {false, true}) {
+                for (bool compressed : {false, true}) {
+                    const QString name = QString("%1-%2-%3")
+                        .arg(encoding == static_cast<int>(WireEncoding::Json) ? "json" : "binary")
+                        .arg(kindName(kind, large), compressed ? "compressed" : "plain");
+                    QTest::newRow(qPrintable(name)) << encoding << kind << large << compressed;
+                }
+            }
+        }
+    }
+}
+
+void BenchNetwork::benchmarkCodec() {
+    QFETCH(int, encoding);
+    QFETCH(int, kind);
+    QFETCH(bool, large);
+    QFETCH(bool, compressed);
+
+    MessageProtocol protocol;
+    if (compressed) protocol.setCompression(compression());
+
+    QVector<Message> messages;
+    for (int i = 0; i < 256; ++i) {
+        messages.append(makeMessage(kind, large, i));
+    }
+    QVector<QByteArray> frames(messages.size());
+
+    // Enough passes for the clock, as NetworkManager does them: one at a time
+    const int passes = 40;
+    QElapsedTimer timer;
+    timer.start();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < messages.size(); ++i) {
+            frames[i] = protocol.serialize(messages[i], static_cast<WireEncoding>(encoding));
+        }
+    }
+    const double serializeNs = static_cast<double>(timer.nsecsElapsed()) / (passes * messages.size());
+
+    qint64 bytes = 0;
+    for (const QByteArray& frame : qAsConst(frames)) {
+        bytes += frame.size();
+    }
+    Message decoded;
+    qint64 consumed = 0;
+    timer.restart();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const QByteArray& frame : qAsConst(frames)) {
+            consumed += protocol.deserialize(frame, decoded);
+        }
+    }
+    const double deserializeNs = static_cast<double>(timer.nsecsElapsed()) / (passes * frames.size());
+
+    QCOMPARE(consumed, bytes * passes);
+    QVERIFY(decoded.payload.contains(kind == Alert ? "alertId" : "trackId"));
+    qDebug("%.1f B/message, serialize %.0f ns, deserialize %.0f ns",
+           static_cast<double>(bytes) / frames.size(), serializeNs, deserializeNs);
+    QTest::setBenchmarkResult(serializeNs + deserializeNs, QTest::WalltimeNanoseconds);
+}
+
+void BenchNetwork::benchmarkLoopback_data() {
+    QTest::addColumn<bool>("tcp");
+    QTest::addColumn<QString>("encoding");
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<bool>("large");
+    QTest::addColumn<bool>("compressed");
+    for (bool tcp : {true, false}) {
+        for (const char* encoding : {"json", "binary"}) {
+            for (int kind : {Track, Detection, Alert}) {
+                for (bool large : {false, true}) {
+                    for (bool compressed : {false, true}) {
+                        const QString name = QString("%1-%2-%3-%4").arg(tcp ? "tcp" : "udp", encoding,
+                            kindName(kind, large), compressed ? "compressed" : "plain");
+                        QTest::newRow(qPrintable(name))
+                            << tcp << QString(encoding) << kind << large << compressed;
+                    }
+                }
+            }
+        }
+        for (bool compressed : {false, true}) {
+            const QString name = QString("%1-delta-%2-%3").arg(tcp ? "tcp" : "udp",
+                kindName(Track, false), compressed ? "compressed" : "plain");
+            QTest::newRow(qPrintable(name))
+                << tcp << QString("delta") << static_cast<int>(Track) << false << compressed;
+        }
+    }
+}
+
+void BenchNetwork::benchmarkLoopback() {
+    QFETCH(bool, tcp);
+    QFETCH(QString, encoding);
+    QFETCH(int, kind);
+    QFETCH(bool, large);
+    QFETCH(bool, compressed);
+    const bool delta = encoding == "delta";
+
+    // TCP: the peer sends every frame back, so the manager reads its own
+    QTcpServer echo;
+    connect(&echo, &QTcpServer::newConnection, &echo, [&echo]() {
+        while (QTcpSocket* peer = echo.nextPendingConnection()) {
+            connect(peer, &QTcpSocket::readyRead, peer, [peer]() { peer->write(peer->readAll()); });
+        }
+    });
+
+    ConnectionConfig config;
+    config.connectionId = "bench";
+    config.name = "bench";
+    config.host = "127.0.0.1";
+    config.useTcp = tcp;
+    config.autoReconnect = false;
+    config.wireEncoding = encoding == "json" ? WireEncoding::Json : WireEncoding::Binary;
+    if (compressed) config.compression = compression();
+    if (tcp) {
+        QVERIFY(echo.listen(QHostAddress::LocalHost));
+        config.port = echo.serverPort();
+    } else {
+        // UDP: the connection's receive port is the one it sends to
+        QUdpSocket probe;
+        QVERIFY(probe.bind(QHostAddress::LocalHost, 0));
+        config.port = probe.localPort();
+    }
+
+    NetworkManager network;
+    network.setNodeId("BENCH");
+    network.addConnection(config);
+
+    QElapsedTimer clock;
+    clock.start();
+    constexpr int RING = 65536;
+    QVector<qint64> sentNs(RING, 0);     // By message index, or by cycle for deltas
+    LatencyHistogram latency;
+    qint64 sent = 0;
+    qint64 received = 0;
+
+    // Wire bytes against what had been sent by then, as of the last bandwidth report
+    qint64 reportedBytes = 0;
+    qint64 reportedSent = 0;
+    connect(&network, &NetworkManager::bandwidthUpdated, this,
+            [&](const NetworkManager::BandwidthStats& stats) {
+        reportedBytes = stats.bytesSent;
+        reportedSent = sent;
+    });
+
+    // Delta rows: a mirrored picture, so every cycle is exactly the tracks given
+    constexpr int CYCLE_TRACKS = 100;
+    constexpr double ORIGIN_LON = -118.0;
+    constexpr double CYCLE_STEP_DEG = 1e-5;     // Longitude per cycle, well above the 1e-7 grid
+    TrackManager tracks;
+    TrackPictureSync sync(&network);
+    qint64 cycle = 0;
+    qint64 lastUpdateMs = 0;
+    QVector<TrackSnapshot> picture;
+    if (delta) {
+        tracks.setMirrorMode(true);
+        sync.setNodeId("BENCH");
+        sync.setKeyframeInterval(60000);
+        for (int i = 0; i < CYCLE_TRACKS; ++i) {
+            TrackSnapshot track;
+            track.trackId = QString("B%1").arg(i);
+            track.position = GeoPosition{34.0 + i * 1e-3, ORIGIN_LON, 120.0};
+            track.velocity.north = -12.5;
+            track.velocity.east = 4.0;
+            track.classification = TrackClassification::Hostile;
+            track.state = TrackState::Active;
+            track.threatLevel = 4;
+            track.classificationConfidence = 0.9;
+            track.trackQuality = 0.85;
+            picture.append(track);
+        }
+        connect(&sync, &TrackPictureSync::remoteTrackUpdated, this,
+                [&](const QString&, const TrackSnapshot& track) {
+            const qint64 index = qRound64((track.position.longitude - ORIGIN_LON) / CYCLE_STEP_DEG);
+            latency.record((clock.nsecsElapsed() - sentNs[index % RING]) / 1000);
+            received++;
+        });
+    } else {
+        const MessageType type = kind == Track ? MessageType::TrackUpdate
+                               : kind == Detection ? MessageType::SensorDetection : MessageType::Alert;
+        const QString idKey = kind == Alert ? "alertId" : "trackId";
+        connect(&network, &NetworkManager::messageReceived, this,
+                [&, type, idKey](const QString&, const Message& message) {
+            if (message.type != type) return;
+            const qint64 index = message.payload.value(idKey).toString().mid(1).toLongLong();
+            latency.record((clock.nsecsElapsed() - sentNs[index % RING]) / 1000);
+            received++;
+        });
+    }
+
+    const auto sendNext = [&]() {
+        if (!delta) {
+            sentNs[sent % RING] = clock.nsecsElapsed();
+            network.send("bench", makeMessage(kind, large, sent));
+            sent++;
+            return;
+        }
+        // Every track moves; the cycle is in the longitude it moves to
+        const double longitude = ORIGIN_LON + (cycle % RING) * CYCLE_STEP_DEG;
+        lastUpdateMs = qMax(lastUpdateMs + 1, QDateTime::currentMSecsSinceEpoch());
+        for (TrackSnapshot& track : picture) {
+            track.position.longitude = longitude;
+            track.lastUpdateMs = lastUpdateMs;
+        }
+        sentNs[cycle % RING] = clock.nsecsElapsed();
+        tracks.applyMirrorTracks(picture, QStringList(), lastUpdateMs);
+        sent += picture.size();
+        cycle++;
+    };
+
+    network.connectTo("bench");
+    QTRY_VERIFY_WITH_TIMEOUT(network.isConnected("bench"), 5000);
+    if (config.wireEncoding == WireEncoding::Binary) {
+        // Binary, and the codec, once the echoed heartbeat is read
+        QTRY_COMPARE(network.sendEncoding("bench"), WireEncoding::Binary);
+    } else {
+        QTest::qWait(200);
+    }
+    if (delta) sync.setTrackManager(&tracks);
+
+    // Sends keep a window in flight; UDP can lose it, so a stalled window is written off
+    const qint64 window = delta ? 4 * CYCLE_TRACKS : 256;
+    const qint64 stallNs = 200 * 1000000LL;
+    const qint64 startNs = clock.nsecsElapsed();
+    const qint64 endNs = startNs + m_seconds * 1000000000LL;
+    qint64 writtenOff = 0;
+    qint64 lastReceived = 0;
+    qint64 lastProgressNs = startNs;
+    while (clock.nsecsElapsed() < endNs) {
+        while (sent - received - writtenOff < window) {
+            sendNext();
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+        const qint64 now = clock.nsecsElapsed();
+        if (received != lastReceived) {
+            lastReceived = received;
+            lastProgressNs = now;
+        } else if (now - lastProgressNs > stallNs) {
+            writtenOff = sent - received;
+            lastProgressNs = now;
+        }
+    }
+    const double seconds = (clock.nsecsElapsed() - startNs) / 1e9;
+    const qint64 receivedInRun = received;
+
+    // What is still in flight comes in, or is lost
+    QTest::qWait(300);
+    const LatencyHistogramSnapshot loop = latency.snapshot();
+    const qint64 lost = qMax<qint64>(0, sent - received);
+    const double bytesPerUpdate = reportedSent > 0 ? static_cast<double>(reportedBytes) / reportedSent : 0.0;
+
+    if (delta) sync.setTrackManager(nullptr);
+    network.disconnectAll();
+
+    qDebug("%.0f updates/s, %.1f B/update, %s latency us: p50 %lld, p90 %lld, p99 %lld, max %lld; %lld of %lld lost",
+           receivedInRun / seconds, bytesPerUpdate, tcp ? "round-trip" : "one-way",
+           loop.percentileUs(0.50), loop.percentileUs(0.90), loop.percentileUs(0.99), loop.maxUs,
+           lost, sent);
+
+    QVERIFY(receivedInRun > 0);
+    if (tcp) QCOMPARE(lost, qint64(0));
+    QTest::setBenchmarkResult(loop.percentileUs(0.99) / 1000.0, QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(BenchNetwork)
+#include "bench_network.moc"
@@ -0,0 +1,70 @@
+#include <QtTest>
+#include <cmath>
+#include "core/ThreatAssessor.h"
+#include "core/TrackManager.h"
+
+using namespace CounterUAS;
+
+/**
+ * Full reassessment of the picture against the default rules and three
+ * defended assets, on a fixed layout of tracks closing on the base.
+ */
+class BenchThreatAssessor : public QObject {
+    Q_OBJECT
+
+private slots:
+    void benchmarkAssessAllTracks_data();
+    void benchmarkAssessAllTracks();
+};
+
+void BenchThreatAssessor::benchmarkAssessAllTracks_data() {
+    QTest::addColumn<int>("trackCount");
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("500") << 500;
+    QTest::newRow("1000") << 1000;
+}
+
+void BenchThreatAssessor::benchmarkAssessAllTracks() {
+    QFETCH(int, trackCount);
+
+    const GeoPosition base{34.0522, -118.2437, 100.0};
+    TrackManager manager;
+    TrackManagerConfig config;
+    config.maxTracks = trackCount + 100;
+    manager.setConfig(config);
+
+    ThreatAssessor assessor(&manager);
+    for (int i = 0; i < 3; ++i) {
+        DefendedAsset asset;
+        asset.id = QString("BENCH-ASSET-%1").arg(i);
+        asset.position = GeoPosition{base.latitude + 0.01 * i, base.longitude - 0.01 * i, base.altitude};
+        asset.criticalRadiusM = 500.0;
+        asset.warningRadiusM = 1500.0;
+        assessor.addDefendedAsset(asset);
+    }
+
+    // Rings from 0.5 to 5 km out, every track heading for the base
+    for (int i = 0; i < trackCount; ++i) {
+        const double bearing = 2.0 * M_PI * i / trackCount;
+        const double rangeDeg = 0.005 + 0.045 * (i % 10) / 10.0;
+        GeoPosition pos{base.latitude + rangeDeg * std::cos(bearing),
+                        base.longitude + rangeDeg * std::sin(bearing),
+                        base.altitude + 50.0 + (i % 7) * 20.0};
+        const QString trackId = manager.createTrack(pos, DetectionSource::Radar);
+        VelocityVector vel;
+        vel.north = -15.0 * std::cos(bearing);
+        vel.east = -15.0 * std::sin(bearing);
+        manager.updateTrackVelocity(trackId, vel);
+    }
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(manager.trackCount(), trackCount);
+
+    QBENCHMARK {
+        assessor.assessAllTracks();
+    }
+    QVERIFY(assessor.metrics().closestDistanceM > 0.0);
+}
+
+QTEST_MAIN(BenchThreatAssessor)
+#include "bench_threat_assessor.moc"
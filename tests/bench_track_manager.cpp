@@ -0,0 +1,270 @@
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QPointF>
+#include <cmath>
+#include "core/TrackManager.h"
+#include "core/Track.h"
+#include "sensors/SensorInterface.h"
+#include "utils/KalmanFilter.h"
+#include "utils/KalmanFilterBank.h"
+
+using namespace CounterUAS;
+
+/**
+ * Track cycle throughput at the sizing point: 500 simultaneous tracks must
+ * fit one full detection + lifecycle cycle inside the updateRateHz budget.
+ * The remaining cases time the hot paths under it on fixed inputs, so
+ * results from different commits compare directly.
+ */
+class BenchTrackManager : public QObject {
+    Q_OBJECT
+
+private slots:
+    void benchmarkCycle_data();
+    void benchmarkCycle();
+    void benchmarkLateMeasurement_data();
+    void benchmarkLateMeasurement();
+    void benchmarkCorrelation_data();
+    void benchmarkCorrelation();
+    void benchmarkRadarDetection_data();
+    void benchmarkRadarDetection();
+    void benchmarkKalmanUpdate();
+    void benchmarkDistance();
+
+private:
+    static QVector<SensorDetection> makeScan(int trackCount, int step);
+    static void runCycle(TrackManager& manager, const QVector<SensorDetection>& scan);
+};
+
+QVector<SensorDetection> BenchTrackManager::makeScan(int trackCount, int step) {
+    // Targets on a 1 km grid, each weaving on its own small circle
+    const GeoPosition origin{34.0, -118.0, 0.0};
+    QVector<SensorDetection> scan;
+    scan.reserve(trackCount);
+
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(trackCount))));
+    for (int i = 0; i < trackCount; ++i) {
+        const double phase = 0.1 * step + i;
+        SensorDetection det;
+        det.sensorId = "BENCH-RADAR";
+        det.sourceType = DetectionSource::Radar;
+        det.position.latitude = origin.latitude + (i / side) * 0.009 + 0.0002 * std::sin(phase);
+        det.position.longitude = origin.longitude + (i % side) * 0.011 + 0.0002 * std::cos(phase);
+        det.position.altitude = 100.0 + 5.0 * std::sin(phase);
+        det.velocity.north = 20.0 * std::cos(phase);
+        det.velocity.east = -20.0 * std::sin(phase);
+        det.confidence = 0.9;
+        det.timestamp = QDateTime::currentMSecsSinceEpoch();
+        scan.append(det);
+    }
+    return scan;
+}
+
+void BenchTrackManager::runCycle(TrackManager& manager, const QVector<SensorDetection>& scan) {
+    manager.processDetectionBatch(scan);
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+}
+
+void BenchTrackManager::benchmarkCycle_data() {
+    QTest::addColumn<bool>("imm");
+    QTest::newRow("single-model") << false;
+    QTest::newRow("imm") << true;
+}
+
+void BenchTrackManager::benchmarkCycle() {
+    QFETCH(bool, imm);
+
+    const int trackCount = 500;
+    TrackManager manager;
+    TrackManagerConfig config;
+    config.updateRateHz = 10;
+    config.maxTracks = trackCount + 100;
+    config.enableImmFilter = imm;
+    manager.setConfig(config);
+
+    // Warm up so every plot correlates to an existing track
+    runCycle(manager, makeScan(trackCount, 0));
+    QCOMPARE(manager.trackCount(), trackCount);
+
+    const int cycles = 20;
+    QElapsedTimer timer;
+    timer.start();
+    for (int step = 1; step <= cycles; ++step) {
+        runCycle(manager, makeScan(trackCount, step));
+    }
+    const double msPerCycle = static_cast<double>(timer.elapsed()) / cycles;
+    qDebug("%s: %.2f ms per cycle for %d tracks", imm ? "IMM" : "single-model",
+           msPerCycle, trackCount);
+
+    QCOMPARE(manager.trackCount(), trackCount);
+    QVERIFY2(msPerCycle < 1000.0 / config.updateRateHz,
+             qPrintable(QString("%1 ms per cycle exceeds the %2 Hz budget")
+                        .arg(msPerCycle).arg(config.updateRateHz)));
+
+    int step = cycles;
+    QBENCHMARK {
+        runCycle(manager, makeScan(trackCount, ++step));
+    }
+}
+
+void BenchTrackManager::benchmarkLateMeasurement_data() {
+    QTest::addColumn<int>("depth");
+    QTest::newRow("depth-4") << 4;
+    QTest::newRow("depth-8") << 8;
+    QTest::newRow("depth-16") << 16;
+}
+
+void BenchTrackManager::benchmarkLateMeasurement() {
+    // Worst case: every late plot rewinds to the oldest update and replays the
+    // whole ring, so the cost per plot is bounded by the depth, not the track age
+    QFETCH(int, depth);
+
+    const int slots = 500;
+    KalmanFilterBank bank;
+    bank.setHistoryDepth(depth);
+    for (int slot = 0; slot < slots; ++slot) {
+        bank.initialize(slot, EnuVector(), 0, MotionModel::ConstantAcceleration);
+    }
+
+    const int scans = 100;
+    for (int k = 1; k <= scans; ++k) {
+        bank.predictAll(k * 100);
+        for (int slot = 0; slot < slots; ++slot) {
+            EnuVector z;
+            z.east = 20.0 * k * 0.1 + slot;
+            z.north = 5.0 * std::sin(0.1 * k);
+            bank.update(slot, z, k * 100);
+        }
+    }
+
+    // Just after the oldest update still in each ring
+    const qint64 lateMs = (scans - depth + 1) * 100 + 50;
+    EnuVector z;
+    z.east = 20.0 * lateMs / 1000.0;
+
+    const int rounds = 20;
+    QElapsedTimer timer;
+    timer.start();
+    for (int round = 0; round < rounds; ++round) {
+        for (int slot = 0; slot < slots; ++slot) {
+            QCOMPARE(bank.update(slot, z, lateMs), KalmanFilterBank::UpdateResult::Replayed);
+        }
+    }
+    const double usPerPlot = timer.nsecsElapsed() / 1000.0 / (rounds * slots);
+    qDebug("depth %d: %.2f us per late plot", depth, usPerPlot);
+
+    QBENCHMARK {
+        for (int slot = 0; slot < slots; ++slot) {
+            bank.update(slot, z, lateMs);
+        }
+    }
+}
+
+void BenchTrackManager::benchmarkCorrelation_data() {
+    QTest::addColumn<int>("trackCount");
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("5000") << 5000;
+}
+
+void BenchTrackManager::benchmarkCorrelation() {
+    // One plot against an established picture: findCorrelatedTrack plus the
+    // update of the track it finds, through the public per-plot entry point
+    QFETCH(int, trackCount);
+
+    TrackManager manager;
+    TrackManagerConfig config;
+    config.maxTracks = trackCount + 100;
+    manager.setConfig(config);
+    const QVector<SensorDetection> scan = makeScan(trackCount, 0);
+    runCycle(manager, scan);
+    QCOMPARE(manager.trackCount(), trackCount);
+
+    int next = 0;
+    QBENCHMARK {
+        const SensorDetection& det = scan[next];
+        manager.processRadarDetection(det.position, det.velocity, det.confidence, det.timestamp);
+        next = (next + 1) % trackCount;
+    }
+
+    // Every plot found its track
+    QCOMPARE(manager.trackCount(), trackCount);
+}
+
+void BenchTrackManager::benchmarkRadarDetection_data() {
+    QTest::addColumn<bool>("batch");
+    QTest::newRow("per-plot") << false;
+    QTest::newRow("batch") << true;
+}
+
+void BenchTrackManager::benchmarkRadarDetection() {
+    // A full 500-plot scan per iteration, one call per plot or one batch
+    QFETCH(bool, batch);
+
+    const int trackCount = 500;
+    TrackManager manager;
+    TrackManagerConfig config;
+    config.maxTracks = trackCount + 100;
+    manager.setConfig(config);
+    runCycle(manager, makeScan(trackCount, 0));
+    QCOMPARE(manager.trackCount(), trackCount);
+
+    const QVector<SensorDetection> scan = makeScan(trackCount, 1);
+    QBENCHMARK {
+        if (batch) {
+            manager.processDetectionBatch(scan);
+        } else {
+            for (const SensorDetection& det : scan) {
+                manager.processRadarDetection(det.position, det.velocity, det.confidence,
+                                              det.timestamp);
+            }
+        }
+    }
+    QCOMPARE(manager.trackCount(), trackCount);
+}
+
+void BenchTrackManager::benchmarkKalmanUpdate() {
+    // 1000 predict + update steps of a target on a circle
+    KalmanFilter2D filter;
+    filter.initialize(0.0, 0.0);
+
+    const int steps = 1000;
+    QVector<QPointF> measurements;
+    measurements.reserve(steps);
+    for (int k = 0; k < steps; ++k) {
+        measurements.append(QPointF(500.0 * std::cos(0.01 * k), 500.0 * std::sin(0.01 * k)));
+    }
+
+    QBENCHMARK {
+        for (const QPointF& z : qAsConst(measurements)) {
+            filter.predict(0.1);
+            filter.update(z.x(), z.y());
+        }
+    }
+    QVERIFY(std::isfinite(filter.stateX()) && std::isfinite(filter.stateY()));
+}
+
+void BenchTrackManager::benchmarkDistance() {
+    // Haversine range from one track to 1000 points around it
+    Track track("BENCH-TRK");
+    track.setPosition(GeoPosition{34.0, -118.0, 100.0});
+
+    const int points = 1000;
+    QVector<GeoPosition> positions;
+    positions.reserve(points);
+    for (int i = 0; i < points; ++i) {
+        positions.append(GeoPosition{34.0 + 0.0001 * (i % 100), -118.0 + 0.0001 * (i / 100), 100.0});
+    }
+
+    double total = 0.0;
+    QBENCHMARK {
+        for (const GeoPosition& pos : qAsConst(positions)) {
+            total += track.distanceTo(pos);
+        }
+    }
+    QVERIFY(total > 0.0);
+}
+
+QTEST_MAIN(BenchTrackManager)
+#include "bench_track_manager.moc"
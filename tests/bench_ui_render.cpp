@@ -0,0 +1,376 @@
+#include <QtTest>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include "core/TrackManager.h"
+#include "sensors/SensorInterface.h"
+#include "ui/MapWidget.h"
+#include "ui/PPIDisplayWidget.h"
+#include "ui/TrackGLView.h"
+#include "ui/TrackListWidget.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/Trace.h"
+
+using namespace CounterUAS;
+
+namespace {
+
+// Heap allocations made while counting is on, by any thread
+std::atomic<bool> g_countAllocations{false};
+std::atomic<qint64> g_allocations{0};
+
+inline void countAllocation() {
+    if (g_countAllocations.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+// Qt's containers take their memory from malloc rather than new; glibc lets
+// the executable interpose the C allocator and forward to its own
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) noexcept {
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+}
+#else
+// Elsewhere only operator new is counted; the default delete frees it
+void* operator new(std::size_t size) {
+    countAllocation();
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+#endif
+
+/**
+ * Per-frame cost of the tactical displays, rendered offscreen through
+ * QWidget::render() at 1280x1024 with 100, 500 and 2000 tracks that carry
+ * history trails. Steady frames follow a moving picture, as the displays
+ * do between operator actions; cold frames also resize the widget, so
+ * every cached layer is drawn again, as after a pan or zoom.
+ *
+ * Each row reports milliseconds and heap allocations per frame, then the
+ * time per frame spent in every "ui" trace scope the widgets record
+ * (drawBackground, drawMapTiles, renderTrackLayer, drawSweepTrail...).
+ * Scope times are inclusive, and include taking each picture in, which
+ * happens on the track cycle rather than in render(). The widgets are
+ * never shown, so every new picture rebuilds the track layer in full.
+ */
+class BenchUiRender : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchmarkPPI_data();
+    void benchmarkPPI();
+    void benchmarkMap_data();
+    void benchmarkMap();
+    void benchmarkTrackList_data();
+    void benchmarkTrackList();
+
+private:
+    struct FrameCost {
+        double msPerFrame = 0.0;
+        double allocationsPerFrame = 0.0;
+        QVector<QPair<QString, double>> layerMs;    // Per frame, slowest first
+    };
+
+    static void addRows(bool withCold);
+    static void setUpManager(TrackManager& manager, int trackCount);
+    static QVector<SensorDetection> makeScan(int trackCount, int step);
+    static void runCycle(TrackManager& manager, int trackCount, int step);
+    static QVector<QPair<QString, double>> layerTimes(int frames);
+    template<typename Advance>
+    static FrameCost renderFrames(QWidget& widget, int frames, Advance advance);
+    static void report(const char* display, int trackCount, bool cold, const FrameCost& cost);
+
+    QTemporaryDir m_dir;
+    QString m_localMapPath;
+};
+
+namespace {
+
+const GeoPosition ORIGIN{34.0, -118.0, 0.0};
+constexpr double EXTENT_M = 24000.0;        // Side of the square the targets fill
+constexpr double RANGE_M = 17000.0;         // Covers the square to its corners
+const QSize FRAME_SIZE(1280, 1024);
+constexpr int WARMUP_CYCLES = 50;           // Five seconds of trail behind every track
+constexpr int FRAMES = 20;
+
+} // namespace
+
+void BenchUiRender::initTestCase() {
+    // Painted by QPainter into the image; nothing here has a GL context
+    TrackGLView::setDefaultBackend(TrackRenderBackend::Software);
+
+    // A site map for the PPI overlay, so drawMapTiles has pixels to blit
+    // without fetching any
+    QVERIFY(m_dir.isValid());
+    QImage map(2048, 2048, QImage::Format_RGB32);
+    map.fill(QColor(40, 52, 44));
+    QPainter painter(&map);
+    painter.setPen(QPen(QColor(90, 110, 95), 3));
+    for (int i = 0; i <= map.width(); i += 64) {
+        painter.drawLine(i, 0, map.width() - i, map.height());
+        painter.drawLine(0, i, map.width(), map.height() - i);
+    }
+    painter.end();
+    m_localMapPath = m_dir.filePath("site-map.png");
+    QVERIFY(map.save(m_localMapPath));
+
+    if (!Trace::COMPILED_IN) {
+        qWarning("Built without COUNTERUAS_TRACING; no per-layer times");
+    }
+}
+
+void BenchUiRender::addRows(bool withCold) {
+    QTest::addColumn<int>("trackCount");
+    QTest::addColumn<bool>("cold");
+    for (int trackCount : {100, 500, 2000}) {
+        QTest::newRow(qPrintable(QString("%1-tracks").arg(trackCount))) << trackCount << false;
+        if (withCold) {
+            QTest::newRow(qPrintable(QString("%1-tracks-cold").arg(trackCount))) << trackCount << true;
+        }
+    }
+}
+
+void BenchUiRender::setUpManager(TrackManager& manager, int trackCount) {
+    TrackManagerConfig config;
+    config.updateRateHz = 10;
+    config.maxTracks = trackCount + 100;
+    manager.setConfig(config);
+}
+
+QVector<SensorDetection> BenchUiRender::makeScan(int trackCount, int step) {
+    // Targets on a grid filling the square, each weaving on its own small
+    // circle, so every trail curves and every label moves
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(trackCount))));
+    const double spacingM = EXTENT_M / side;
+    const double degLat = 1.0 / CoordinateUtils::DEG_TO_M_LAT;
+    const double degLon = 1.0 / CoordinateUtils::degToMeterLon(ORIGIN.latitude);
+
+    QVector<SensorDetection> scan;
+    scan.reserve(trackCount);
+    for (int i = 0; i < trackCount; ++i) {
+        const double phase = 0.1 * step + i;
+        const double northM = ((i / side) + 0.5) * spacingM - EXTENT_M / 2.0 + 60.0 * std::sin(phase);
+        const double eastM = ((i % side) + 0.5) * spacingM - EXTENT_M / 2.0 + 60.0 * std::cos(phase);
+        SensorDetection det;
+        det.sensorId = "BENCH-RADAR";
+        det.sourceType = DetectionSource::Radar;
+        det.position.latitude = ORIGIN.latitude + northM * degLat;
+        det.position.longitude = ORIGIN.longitude + eastM * degLon;
+        det.position.altitude = 100.0 + 5.0 * std::sin(phase);
+        det.velocity.north = 60.0 * std::cos(phase);
+        det.velocity.east = -60.0 * std::sin(phase);
+        det.confidence = 0.9;
+        det.timestamp = QDateTime::currentMSecsSinceEpoch();
+        scan.append(det);
+    }
+    return scan;
+}
+
+void BenchUiRender::runCycle(TrackManager& manager, int trackCount, int step) {
+    manager.processDetectionBatch(makeScan(trackCount, step));
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+}
+
+QVector<QPair<QString, double>> BenchUiRender::layerTimes(int frames) {
+    QHash<QString, double> totals;
+    const QJsonArray events = QJsonDocument::fromJson(Trace::toChromeJson()).object()["traceEvents"].toArray();
+    for (const QJsonValue& value : events) {
+        const QJsonObject event = value.toObject();
+        if (event["cat"].toString() != QLatin1String("ui")) continue;
+        totals[event["name"].toString()] += event["dur"].toDouble() / 1000.0;
+    }
+
+    QVector<QPair<QString, double>> layers;
+    for (auto it = totals.cbegin(); it != totals.cend(); ++it) {
+        layers.append({it.key(), it.value() / frames});
+    }
+    std::sort(layers.begin(), layers.end(),
+              [](const QPair<QString, double>& a, const QPair<QString, double>& b) { return a.second > b.second; });
+    return layers;
+}
+
+template<typename Advance>
+BenchUiRender::FrameCost BenchUiRender::renderFrames(QWidget& widget, int frames, Advance advance) {
+    // Room for the cold frames' extra pixel
+    QImage image(FRAME_SIZE + QSize(1, 1), QImage::Format_ARGB32_Premultiplied);
+
+    // One frame first, so the trace ring and the layer caches exist
+    Trace::setEnabled(Trace::COMPILED_IN);
+    widget.render(&image);
+    Trace::clear();
+
+    qint64 renderNs = 0;
+    qint64 allocations = 0;
+    QElapsedTimer timer;
+    for (int frame = 0; frame < frames; ++frame) {
+        advance(frame);
+
+        g_allocations.store(0, std::memory_order_relaxed);
+        g_countAllocations.store(true, std::memory_order_relaxed);
+        timer.start();
+        widget.render(&image);
+        renderNs += timer.nsecsElapsed();
+        g_countAllocations.store(false, std::memory_order_relaxed);
+        allocations += g_allocations.load(std::memory_order_relaxed);
+    }
+    Trace::setEnabled(false);
+
+    FrameCost cost;
+    cost.msPerFrame = renderNs / 1.0e6 / frames;
+    cost.allocationsPerFrame = static_cast<double>(allocations) / frames;
+    cost.layerMs = layerTimes(frames);
+    Trace::clear();
+    return cost;
+}
+
+void BenchUiRender::report(const char* display, int trackCount, bool cold, const FrameCost& cost) {
+    qDebug("%s, %d tracks%s: %.2f ms and %.0f allocations per frame", display, trackCount,
+           cold ? " (cold)" : "", cost.msPerFrame, cost.allocationsPerFrame);
+    for (const auto& layer : cost.layerMs) {
+        qDebug("    %-36s %8.3f ms", qPrintable(layer.first), layer.second);
+    }
+    QTest::setBenchmarkResult(cost.msPerFrame, QTest::WalltimeMilliseconds);
+}
+
+void BenchUiRender::benchmarkPPI_data() {
+    addRows(true);
+}
+
+void BenchUiRender::benchmarkPPI() {
+    QFETCH(int, trackCount);
+    QFETCH(bool, cold);
+
+    TrackManager manager;
+    setUpManager(manager, trackCount);
+
+    // Map overlay under a rotating sweep: every layer the PPI has
+    PPIDisplayWidget ppi;
+    ppi.setTrackRenderBackend(TrackRenderBackend::Software);
+    ppi.setMapTileUrl(QString());
+    ppi.resize(FRAME_SIZE);
+    ppi.setCenterSilent(ORIGIN);
+    ppi.setRangeScaleSilent(RANGE_M);
+    QVERIFY(ppi.loadLocalMap(m_localMapPath));
+    ppi.setDisplayMode(PPIDisplayMode::MapOverlay);
+    ppi.setSweepMode(PPISweepMode::Rotating);
+    ppi.setDefendedAreaRadii(500.0, 1500.0, 15000.0);
+    ppi.setTrackManager(&manager);
+
+    for (int step = 0; step < WARMUP_CYCLES; ++step) {
+        runCycle(manager, trackCount, step);
+    }
+    QCOMPARE(manager.trackCount(), trackCount);
+
+    const FrameCost cost = renderFrames(ppi, FRAMES, [&](int frame) {
+        runCycle(manager, trackCount, WARMUP_CYCLES + frame);
+        if (cold) {
+            ppi.resize(FRAME_SIZE + QSize(frame % 2, frame % 2));
+        }
+    });
+    QCOMPARE(manager.trackCount(), trackCount);
+    report("PPI", trackCount, cold, cost);
+}
+
+void BenchUiRender::benchmarkMap_data() {
+    addRows(true);
+}
+
+void BenchUiRender::benchmarkMap() {
+    QFETCH(int, trackCount);
+    QFETCH(bool, cold);
+
+    TrackManager manager;
+    setUpManager(manager, trackCount);
+
+    MapWidget map;
+    map.setTrackRenderBackend(TrackRenderBackend::Software);
+    map.resize(FRAME_SIZE);
+    map.setCenterSilent(ORIGIN);
+    map.setZoomSilent(MapWidget::rangeScaleToZoom(RANGE_M));
+    map.setTrackManager(&manager);
+
+    for (int step = 0; step < WARMUP_CYCLES; ++step) {
+        runCycle(manager, trackCount, step);
+    }
+    QCOMPARE(manager.trackCount(), trackCount);
+
+    const FrameCost cost = renderFrames(map, FRAMES, [&](int frame) {
+        runCycle(manager, trackCount, WARMUP_CYCLES + frame);
+        if (cold) {
+            map.resize(FRAME_SIZE + QSize(frame % 2, frame % 2));
+        }
+    });
+    QCOMPARE(manager.trackCount(), trackCount);
+    report("Map", trackCount, cold, cost);
+}
+
+void BenchUiRender::benchmarkTrackList_data() {
+    addRows(false);
+}
+
+void BenchUiRender::benchmarkTrackList() {
+    QFETCH(int, trackCount);
+    QFETCH(bool, cold);
+
+    TrackManager manager;
+    setUpManager(manager, trackCount);
+
+    // Every change set straight into the model, none held for a later tick
+    TrackListWidget list(&manager);
+    list.setUpdateRateHz(0);
+    list.setReferencePosition(ORIGIN);
+    list.resize(FRAME_SIZE);
+
+    for (int step = 0; step < WARMUP_CYCLES; ++step) {
+        runCycle(manager, trackCount, step);
+    }
+    QCOMPARE(manager.trackCount(), trackCount);
+
+    const FrameCost cost = renderFrames(list, FRAMES, [&](int frame) {
+        runCycle(manager, trackCount, WARMUP_CYCLES + frame);
+    });
+    report("Track list", trackCount, cold, cost);
+}
+
+// Nothing is shown, so no display is needed either
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    BenchUiRender bench;
+    return QTest::qExec(&bench, argc, argv);
+}
+
+#include "bench_ui_render.moc"
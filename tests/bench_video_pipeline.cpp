@@ -0,0 +1,98 @@
+#include <QtTest>
+#include "utils/FrameBuffer.h"
+#include "utils/VideoFrame.h"
+#include "video/VideoOverlayRenderer.h"
+
+using namespace CounterUAS;
+
+/**
+ * Per-frame costs on the display path at 1280x720: queueing a frame
+ * through FrameBuffer, and compositing the overlay for a busy scene.
+ */
+class BenchVideoPipeline : public QObject {
+    Q_OBJECT
+
+private slots:
+    void benchmarkFrameBuffer();
+    void benchmarkRenderOverlay_data();
+    void benchmarkRenderOverlay();
+
+private:
+    static TrackOverlay trackOverlay(int index);
+};
+
+TrackOverlay BenchVideoPipeline::trackOverlay(int index) {
+    // Boxes on a grid across the frame, classes and threat levels cycling
+    TrackOverlay track;
+    track.trackId = QString("TRK-%1").arg(index, 4, 10, QChar('0'));
+    track.boundingBox = {40 + (index % 10) * 120, 40 + (index / 10) * 110, 60, 45, "BENCH-CAM", 0};
+    track.classification = static_cast<TrackClassification>(index % 4);
+    track.threatLevel = 1 + index % 5;
+    track.distance = 500.0 + 25.0 * index;
+    track.bearing = (index * 37) % 360;
+    return track;
+}
+
+void BenchVideoPipeline::benchmarkFrameBuffer() {
+    // A full buffer's worth pushed and drained per iteration
+    FrameBuffer buffer(30);
+    QImage image(1280, 720, QImage::Format_RGB888);
+    image.fill(Qt::darkGray);
+    const VideoFrame frame(image);
+
+    qint64 timestamp = 0;
+    QBENCHMARK {
+        for (int i = 0; i < buffer.capacity(); ++i) {
+            buffer.push(frame, ++timestamp);
+        }
+        while (!buffer.isEmpty()) {
+            buffer.pop();
+        }
+    }
+    QCOMPARE(buffer.count(), 0);
+}
+
+void BenchVideoPipeline::benchmarkRenderOverlay_data() {
+    // Static scenes hit the retained layer; moving ones repaint every box
+    QTest::addColumn<int>("trackCount");
+    QTest::addColumn<bool>("moving");
+    QTest::newRow("0-tracks") << 0 << false;
+    QTest::newRow("10-tracks") << 10 << false;
+    QTest::newRow("50-tracks") << 50 << false;
+    QTest::newRow("50-tracks-moving") << 50 << true;
+}
+
+void BenchVideoPipeline::benchmarkRenderOverlay() {
+    QFETCH(int, trackCount);
+    QFETCH(bool, moving);
+
+    VideoOverlayRenderer renderer;
+    QList<TrackOverlay> tracks;
+    for (int i = 0; i < trackCount; ++i) {
+        tracks.append(trackOverlay(i));
+    }
+    renderer.setTrackOverlays(tracks);
+    if (trackCount > 0) {
+        renderer.setSelectedTrack(tracks.first().trackId);
+    }
+
+    QImage frame(1280, 720, QImage::Format_RGB888);
+    frame.fill(Qt::black);
+
+    int step = 0;
+    QImage result;
+    QBENCHMARK {
+        if (moving) {
+            const int offset = (++step % 2) * 4;
+            for (TrackOverlay& track : tracks) {
+                track.boundingBox.x += offset - 2;
+            }
+            renderer.setTrackOverlays(tracks);
+        }
+        result = renderer.renderOverlay(frame);
+    }
+    QCOMPARE(result.size(), frame.size());
+}
+
+QTEST_MAIN(BenchVideoPipeline)
+#include "bench_video_pipeline.moc"
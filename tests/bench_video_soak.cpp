@@ -0,0 +1,291 @@
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "utils/LatencyHistogram.h"
+#include "video/FileVideoSource.h"
+#include "video/SimulationVideoSource.h"
+#include "video/VideoOverlayRenderer.h"
+#include "video/VideoRecorder.h"
+#include "video/VideoStreamManager.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace CounterUAS;
+
+/**
+ * Soak of the whole local video path: N streams through VideoStreamManager,
+ * each into a display sink that composites the overlay layer over a grid
+ * tile, as VideoDisplayWidget does, and into a VideoRecorder. Generated
+ * frames are stamped when their tick fires, so latency runs from
+ * generation to the composited tile.
+ *
+ * Every row reports end-to-end latency percentiles, frames dropped at each
+ * stage (the source's render, the distributor, the recorder's queue), CPU
+ * per stream and resident memory growth. Rows run CUAS_SOAK_SECONDS each,
+ * 3 by default; a 30-minute soak of one configuration is
+ *
+ *   CUAS_SOAK_SECONDS=1800 bench_video_soak benchmarkSoak:16x1080p30
+ *
+ * CUAS_SOAK_FILE plays that file through FileVideoSource on every stream
+ * instead, at its own size and rate. Recordings go under CUAS_SOAK_DIR,
+ * or the temp directory, and are removed after each row.
+ */
+class BenchVideoSoak : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchmarkSoak_data();
+    void benchmarkSoak();
+
+private:
+    // One grid tile of the video wall
+    struct Sink {
+        VideoOverlayRenderer overlay;
+        QImage tile;
+        quint64 displayed = 0;
+    };
+
+    struct Counters {
+        qint64 generated = 0;           // Emitted by the sources
+        qint64 sourceDropped = 0;       // Ticks that found the last frame still rendering
+        VideoDeliveryStats delivery;
+        quint64 recorded = 0;
+        quint64 recorderDropped = 0;
+        quint64 encodeFailures = 0;
+        quint64 displayed = 0;
+        qint64 cpuMs = 0;
+    };
+
+    Counters counters(const VideoStreamManager& manager, const std::vector<std::unique_ptr<Sink>>& sinks) const;
+    static void moveTracks(VideoOverlayRenderer& overlay, const QSize& frameSize, quint64 frame);
+    static qint64 processCpuMs();
+    static qint64 residentBytes();
+
+    int m_seconds = 3;
+    QString m_file;
+    QString m_recordRoot;
+    LatencyHistogram m_latency;         // Generation to composited tile, every stream
+};
+
+void BenchVideoSoak::initTestCase() {
+    if (qEnvironmentVariableIsSet("CUAS_SOAK_SECONDS")) {
+        m_seconds = qMax(2, qEnvironmentVariableIntValue("CUAS_SOAK_SECONDS"));
+    }
+    m_file = qEnvironmentVariable("CUAS_SOAK_FILE");
+    if (!m_file.isEmpty()) {
+        QVERIFY2(QFile::exists(m_file), qPrintable("No such file: " + m_file));
+    }
+    m_recordRoot = qEnvironmentVariable("CUAS_SOAK_DIR", QDir::tempPath());
+}
+
+void BenchVideoSoak::benchmarkSoak_data() {
+    QTest::addColumn<int>("streams");
+    QTest::addColumn<QSize>("frameSize");
+    QTest::addColumn<int>("fps");
+    const QSize hd(1920, 1080);
+    const QSize uhd(3840, 2160);
+    for (int streams : {1, 4, 16}) {
+        for (int fps : {30, 60}) {
+            QTest::newRow(qPrintable(QString("%1x1080p%2").arg(streams).arg(fps))) << streams << hd << fps;
+            QTest::newRow(qPrintable(QString("%1x4k%2").arg(streams).arg(fps))) << streams << uhd << fps;
+        }
+    }
+}
+
+void BenchVideoSoak::benchmarkSoak() {
+    QFETCH(int, streams);
+    QFETCH(QSize, frameSize);
+    QFETCH(int, fps);
+
+    QTemporaryDir recordings(QDir(m_recordRoot).filePath("cuas-soak-XXXXXX"));
+    QVERIFY(recordings.isValid());
+
+    // Declared first, so sources and tiles outlive the manager on a failed check
+    std::vector<std::unique_ptr<SimulationVideoSource>> generators;
+    std::vector<std::unique_ptr<Sink>> sinks;
+    VideoStreamManager manager;
+    for (int i = 0; i < streams; ++i) {
+        CameraDefinition camera;
+        camera.cameraId = QString("SOAK-%1").arg(i + 1, 2, 10, QChar('0'));
+        camera.name = camera.cameraId;
+        if (!m_file.isEmpty()) {
+            camera.sourceType = "FILE";
+            camera.streamUrl = QUrl::fromLocalFile(m_file).toString();
+            QCOMPARE(manager.addStream(camera), camera.cameraId);
+            if (auto* file = qobject_cast<FileVideoSource*>(manager.stream(camera.cameraId))) {
+                file->setLooping(true);
+            }
+            continue;
+        }
+        auto source = std::make_unique<SimulationVideoSource>(camera.cameraId);
+        source->setCameraName(camera.cameraId);
+        source->setFrameSize(frameSize);
+        source->setTargetFPS(fps);
+        QCOMPARE(manager.addExternalStream(camera, source.get()), camera.cameraId);
+        generators.push_back(std::move(source));
+    }
+
+    // A square wall of tiles on one 1080p monitor, each with its own overlay
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(streams))));
+    const QSize tileSize(1920 / side, 1080 / side);
+    QVector<int> subscriptions;
+    for (const QString& id : manager.streamIds()) {
+        sinks.push_back(std::make_unique<Sink>());
+        Sink* sink = sinks.back().get();
+        sink->tile = QImage(tileSize, QImage::Format_RGB32);
+
+        VideoDeliveryPolicy policy;
+        policy.targetSize = tileSize;
+        subscriptions.append(manager.subscribeFrames(id, this, policy,
+            [this, sink](const VideoFrame& frame, qint64 timestamp, const QSize& sourceSize) {
+                moveTracks(sink->overlay, sourceSize, sink->displayed);
+                QPainter painter(&sink->tile);
+                const QImage image = frame.toImage();
+                painter.drawImage(QPoint(0, 0), image);
+                sink->overlay.updateLayer(sourceSize);
+                painter.drawImage(QRect(QPoint(0, 0), image.size()), sink->overlay.layer());
+                painter.end();
+                m_latency.record((QDateTime::currentMSecsSinceEpoch() - timestamp) * 1000);
+                sink->displayed++;
+            }));
+    }
+
+    manager.startAllRecording(recordings.path());
+    manager.startAllStreams();
+
+    // The first second fills pools, caches and encoders; measured after it
+    QTest::qWait(1000);
+    const Counters start = counters(manager, sinks);
+    const LatencyHistogramSnapshot latencyStart = m_latency.snapshot();
+    const qint64 residentStart = residentBytes();
+    qint64 residentPeak = residentStart;
+
+    QElapsedTimer wall;
+    wall.start();
+    while (wall.elapsed() < m_seconds * 1000) {
+        QTest::qWait(1000);
+        residentPeak = qMax(residentPeak, residentBytes());
+    }
+    const double seconds = wall.elapsed() / 1000.0;
+    const Counters end = counters(manager, sinks);
+    const LatencyHistogramSnapshot latency = m_latency.snapshot().since(latencyStart);
+    const qint64 residentEnd = residentBytes();
+
+    manager.stopAllStreams();
+    for (int subscription : subscriptions) {
+        manager.unsubscribeFrames(subscription);
+    }
+    manager.stopAllRecording();
+    manager.removeAllStreams();
+
+    const qint64 generated = end.generated - start.generated;
+    const quint64 displayed = end.displayed - start.displayed;
+    const quint64 coalesced = (end.delivery.coalesced - start.delivery.coalesced) +
+                              (end.delivery.scaleSkipped - start.delivery.scaleSkipped);
+    const double cpuPerStream = 100.0 * (end.cpuMs - start.cpuMs) / (seconds * 1000.0) / streams;
+    const double minutes = seconds / 60.0;
+    const auto ms = [&latency](double fraction) { return latency.percentileUs(fraction) / 1000.0; };
+
+    qDebug("%d x %dx%d at %d fps, %.0f s: %.1f fps per stream shown", streams, frameSize.width(),
+           frameSize.height(), fps, seconds, displayed / seconds / streams);
+    qDebug("    latency ms: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f", ms(0.50), ms(0.90), ms(0.99),
+           latency.maxUs / 1000.0);
+    qDebug("    frames: %lld generated; dropped %lld at the source, %llu in delivery, %llu at the recorder"
+           " (%llu recorded, %llu encode failures)",
+           generated, end.sourceDropped - start.sourceDropped, coalesced,
+           end.recorderDropped - start.recorderDropped, end.recorded - start.recorded,
+           end.encodeFailures - start.encodeFailures);
+    qDebug("    cpu: %.1f%% of a core per stream", cpuPerStream);
+    if (residentStart > 0) {
+        qDebug("    resident MiB: %.1f at start, %.1f peak, %.1f at end (%+.2f per minute)",
+               residentStart / 1048576.0, residentPeak / 1048576.0, residentEnd / 1048576.0,
+               (residentEnd - residentStart) / 1048576.0 / minutes);
+    }
+
+    QVERIFY(generated > 0);
+    QVERIFY(displayed > 0);
+    QVERIFY(end.recorded > start.recorded);
+    QTest::setBenchmarkResult(ms(0.99), QTest::WalltimeMilliseconds);
+}
+
+BenchVideoSoak::Counters BenchVideoSoak::counters(const VideoStreamManager& manager,
+                                                  const std::vector<std::unique_ptr<Sink>>& sinks) const {
+    Counters counters;
+    for (const QString& id : manager.streamIds()) {
+        const VideoSourceStats source = manager.stream(id)->stats();
+        counters.generated += source.framesReceived;
+        counters.sourceDropped += source.framesDropped;
+        const RecorderStats recorder = manager.recorderStats(id);
+        counters.recorded += recorder.framesWritten;
+        counters.recorderDropped += recorder.framesDropped;
+        counters.encodeFailures += recorder.encodeFailures;
+    }
+    for (const auto& sink : sinks) {
+        counters.displayed += sink->displayed;
+    }
+    counters.delivery = manager.deliveryStats();
+    counters.cpuMs = processCpuMs();
+    return counters;
+}
+
+void BenchVideoSoak::moveTracks(VideoOverlayRenderer& overlay, const QSize& frameSize, quint64 frame) {
+    // Three targets drifting across the frame, so the layer repaints every frame
+    QList<TrackOverlay> tracks;
+    for (int i = 0; i < 3; ++i) {
+        TrackOverlay track;
+        track.trackId = QString("TRK-%1").arg(i + 1, 4, 10, QChar('0'));
+        track.boundingBox.width = frameSize.width() / 20;
+        track.boundingBox.height = frameSize.height() / 20;
+        track.boundingBox.x = static_cast<int>((frame * (2 + i) + i * frameSize.width() / 3) %
+                                               qMax(1, frameSize.width() - track.boundingBox.width));
+        track.boundingBox.y = frameSize.height() / 4 * (i + 1);
+        track.classification = static_cast<TrackClassification>(i % 4);
+        track.threatLevel = 3 + i % 3;
+        track.distance = 800.0 + 100.0 * i;
+        tracks.append(track);
+    }
+    overlay.setTrackOverlays(tracks);
+}
+
+qint64 BenchVideoSoak::processCpuMs() {
+#if defined(Q_OS_WIN)
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+    const auto ms = [](const FILETIME& t) {
+        return static_cast<qint64>((static_cast<quint64>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10000;
+    };
+    return ms(kernel) + ms(user);
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return (static_cast<qint64>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#else
+    return 0;
+#endif
+}
+
+qint64 BenchVideoSoak::residentBytes() {
+#if defined(Q_OS_LINUX)
+    QFile file("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return 0;
+    const qint64 pages = file.readAll().split(' ').value(1).toLongLong();
+    return pages * sysconf(_SC_PAGESIZE);
+#else
+    return 0;       // Growth is not reported
+#endif
+}
+
+QTEST_MAIN(BenchVideoSoak)
+#include "bench_video_soak.moc"
@@ -1,6 +1,20 @@
 #include <QtTest>
 #include "core/ThreatAssessor.h"
 #include "core/TrackManager.h"
+#include "core/ThreatRuleProgram.h"
+#include "core/DefendedAssetIndex.h"
+#include "core/GeofenceIndex.h"
+#include "core/ThreatPriorityQueue.h"
+#include "core/ClosestApproach.h"
+#include "core/ThreatAlertStore.h"
+#include "core/ReplicatedAlertLog.h"
+#include "core/SensorResourceManager.h"
+#include "sensors/RFDetector.h"
+#include "sensors/RadarSensor.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 using namespace CounterUAS;
 
@@ -14,6 +28,17 @@ private slots:
     void testThreatRules();
     void testThreatAssessment();
     void testAlerts();
+    void testCompiledRules();
+    void testIncrementalAssessment();
+    void testParallelAssessment();
+    void testTieredRates();
+    void testSensorTasking();
+    void testDefendedAssetIndex();
+    void testGeofences();
+    void testThreatQueue();
+    void testClosestApproach();
+    void testAlertStore();
+    void testReplicatedAlertLog();
     
 private:
     TrackManager* m_trackManager;
@@ -114,5 +139,837 @@ void TestThreatAssessor::testAlerts() {
     QCOMPARE(m_assessor->unacknowledgedAlerts().size(), 0);
 }
 
+void TestThreatAssessor::testCompiledRules() {
+    ThreatRule near;
+    near.id = "NEAR";
+    near.maxProximityM = 500.0;
+    near.setThreatLevel = 4;
+    near.forceClassification = TrackClassification::Hostile;
+    near.generateAlert = true;
+    
+    ThreatRule fastRf;
+    fastRf.id = "FAST-RF";
+    fastRf.minVelocityMps = 20.0;
+    fastRf.requiresRFDetection = true;
+    fastRf.threatLevelIncrease = 2;
+    
+    ThreatRule disabled = near;
+    disabled.id = "OFF";
+    disabled.enabled = false;
+    
+    ThreatRule noAction;
+    noAction.id = "NOOP";
+    noAction.minProximityM = 0.0;
+    
+    ThreatRuleProgram program;
+    program.compile({near, fastRf, disabled, noAction});
+    
+    // Unset (-1 / false) conditions and inert rules are compiled away
+    QCOMPARE(program.ruleCount(), 2);
+    QCOMPARE(program.conditionCount(), 3);
+    
+    QVector<ThreatRuleInput> inputs(3);
+    inputs[0].proximityM = 300.0;                 // Near: set to 4, then +2 if fast RF
+    inputs[0].speedMps = 25.0;
+    inputs[0].hasRF = true;
+    inputs[1].proximityM = 3000.0;                // Only fast RF
+    inputs[1].speedMps = 25.0;
+    inputs[1].hasRF = true;
+    inputs[1].threatLevel = 2;
+    inputs[2].proximityM = 3000.0;                // Nothing matches
+    inputs[2].speedMps = 25.0;
+    inputs[2].threatLevel = 2;
+    
+    QVector<ThreatRuleAlert> alerts;
+    program.evaluate(inputs, &alerts);
+    
+    QCOMPARE(inputs[0].threatLevel, 5);           // 4 + 2, clamped
+    QCOMPARE(inputs[0].classification, TrackClassification::Hostile);
+    QCOMPARE(inputs[1].threatLevel, 4);
+    QCOMPARE(inputs[1].classification, TrackClassification::Unknown);
+    QCOMPARE(inputs[2].threatLevel, 2);
+    QCOMPARE(alerts.size(), 1);
+    QCOMPARE(alerts.first().input, 0);
+    QCOMPARE(alerts.first().rule, 0);             // Index into the source list
+    
+    // Sizing point: 100+ rules against 500 tracks inside one assessment interval
+    QList<ThreatRule> ruleSet;
+    for (int i = 0; i < 120; ++i) {
+        ThreatRule rule;
+        rule.id = QString("ROE-%1").arg(i);
+        rule.minProximityM = (i % 10) * 200.0;
+        rule.maxProximityM = rule.minProximityM + 400.0;
+        rule.minVelocityMps = (i % 4) * 5.0;
+        rule.minHeadingToAssetDeg = 0.0;
+        rule.maxHeadingToAssetDeg = 45.0;
+        rule.threatLevelIncrease = 1;
+        ruleSet.append(rule);
+    }
+    program.compile(ruleSet);
+    
+    DefendedAssetIndex assets;
+    DefendedAsset asset;
+    asset.position = GeoPosition{34.0, -118.0, 0.0};
+    assets.rebuild(QList<DefendedAsset>{asset});
+    
+    QElapsedTimer timer;
+    timer.start();
+    QVector<ThreatRuleInput> batch(500);
+    for (int i = 0; i < batch.size(); ++i) {
+        GeoPosition pos{34.0 + (i % 25) * 0.001, -118.0 + (i / 25) * 0.001, 100.0};
+        VelocityVector vel;
+        vel.north = -10.0 - (i % 7);
+        const DefendedAssetFix fix = assets.nearest(pos, &vel);
+        batch[i].proximityM = fix.distanceM;
+        batch[i].speedMps = vel.speed();
+        batch[i].headingToAssetDeg = fix.headingOffsetDeg;
+    }
+    program.evaluate(batch, nullptr);
+    const qint64 elapsedMs = timer.elapsed();
+    
+    ThreatAssessorConfig config;
+    QVERIFY2(elapsedMs < config.assessmentIntervalMs,
+             qPrintable(QString("%1 ms for 120 rules x 500 tracks").arg(elapsedMs)));
+}
+
+void TestThreatAssessor::testIncrementalAssessment() {
+    TrackManager manager;
+    ThreatAssessor assessor(&manager);
+    ThreatAssessorConfig config;
+    config.incrementalAssessment = true;
+    config.maxChangeRateHz = 0;  // Deliver every change set
+    assessor.setConfig(config);
+    
+    DefendedAsset asset;
+    asset.id = "BASE-01";
+    asset.position = GeoPosition{34.0522, -118.2437, 100.0};
+    assessor.addDefendedAsset(asset);
+    
+    auto cycle = [&manager]() {
+        QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    };
+    auto assess = [&assessor]() {
+        QMetaObject::invokeMethod(&assessor, "performAssessmentCycle", Qt::DirectConnection);
+    };
+    
+    GeoPosition pos{34.0525, -118.2437, 100.0};  // Inside the critical radius
+    const QString trackId = manager.createTrack(pos, DetectionSource::Radar);
+    cycle();
+    assess();
+    QCOMPARE(manager.track(trackId)->threatLevel(), 5);
+    cycle();
+    QCOMPARE(assessor.metrics().highThreatCount, 1);
+    QCOMPARE(assessor.metrics().hostileCount, 1);
+    QCOMPARE(assessor.metrics().highestThreatTrackId, trackId);
+    QVERIFY(assessor.metrics().closestDistanceM > 0.0);
+    
+    QSignalSpy levelSpy(&assessor, &ThreatAssessor::threatLevelChanged);
+    
+    // Output-only changes update the metrics without a reassessment
+    manager.setTrackThreatLevel(trackId, 2);
+    cycle();
+    assess();
+    QCOMPARE(levelSpy.count(), 0);
+    QCOMPARE(assessor.metrics().highThreatCount, 0);
+    QCOMPARE(assessor.metrics().avgThreatLevel, 2.0);
+    
+    // An update below the thresholds is not re-evaluated
+    manager.updateTrack(trackId, pos);
+    cycle();
+    assess();
+    QCOMPARE(levelSpy.count(), 0);
+    
+    // Moving beyond reassessDistanceM is
+    pos.latitude += 0.0005;  // ~55 m
+    manager.updateTrack(trackId, pos);
+    cycle();
+    assess();
+    QCOMPARE(levelSpy.count(), 1);
+    QCOMPARE(manager.track(trackId)->threatLevel(), 5);
+    
+    manager.dropTrack(trackId);
+    cycle();
+    assess();
+    QCOMPARE(assessor.metrics().hostileCount, 0);
+    QCOMPARE(assessor.metrics().closestDistanceM, -1.0);
+}
+
+void TestThreatAssessor::testParallelAssessment() {
+    // The same tracks through a serial and a parallel assessor
+    TrackManagerConfig trackConfig;
+    trackConfig.maxTracks = 1000;
+    TrackManager serialManager;
+    TrackManager parallelManager;
+    serialManager.setConfig(trackConfig);
+    parallelManager.setConfig(trackConfig);
+    
+    ThreatAssessor serial(&serialManager);
+    ThreatAssessor parallel(&parallelManager);
+    ThreatAssessorConfig config;
+    config.maxChangeRateHz = 0;
+    serial.setConfig(config);
+    config.parallelAssessment = true;
+    config.parallelMinTracks = 64;
+    config.parallelChunkTracks = 50;
+    parallel.setConfig(config);
+    
+    DefendedAsset asset;
+    asset.id = "BASE-01";
+    asset.position = GeoPosition{34.0522, -118.2437, 100.0};
+    serial.addDefendedAsset(asset);
+    parallel.addDefendedAsset(asset);
+    
+    // A spiral out from the asset, through every radius band
+    QStringList trackIds;
+    for (int i = 0; i < 600; ++i) {
+        const double rangeDeg = 0.00005 * i;
+        const double angle = i * 0.7;
+        const GeoPosition pos{asset.position.latitude + rangeDeg * std::cos(angle),
+                              asset.position.longitude + rangeDeg * std::sin(angle), 100.0};
+        trackIds.append(serialManager.createTrack(pos, DetectionSource::Radar));
+        QCOMPARE(parallelManager.createTrack(pos, DetectionSource::Radar), trackIds.last());
+        if (i % 3 == 0) {
+            // Closing on the asset
+            const VelocityVector velocity{-20.0 * std::cos(angle), -20.0 * std::sin(angle), 0.0};
+            serialManager.updateTrackVelocity(trackIds.last(), velocity);
+            parallelManager.updateTrackVelocity(trackIds.last(), velocity);
+        }
+    }
+    QMetaObject::invokeMethod(&serialManager, "processTrackCycle", Qt::DirectConnection);
+    QMetaObject::invokeMethod(&parallelManager, "processTrackCycle", Qt::DirectConnection);
+    
+    QSignalSpy serialLevels(&serial, &ThreatAssessor::threatLevelChanged);
+    QSignalSpy parallelLevels(&parallel, &ThreatAssessor::threatLevelChanged);
+    QSignalSpy batches(&parallelManager, &TrackManager::threatAssessmentsApplied);
+    QSignalSpy perTrack(&parallelManager, &TrackManager::trackThreatLevelChanged);
+    serial.assessAllTracks();
+    parallel.assessAllTracks();
+    
+    QVERIFY(serialLevels.count() > 0);
+    QCOMPARE(parallelLevels.count(), serialLevels.count());
+    QCOMPARE(batches.count(), 1);
+    QCOMPARE(perTrack.count(), 0);
+    for (const QString& trackId : trackIds) {
+        QCOMPARE(parallelManager.track(trackId)->threatLevel(), serialManager.track(trackId)->threatLevel());
+        QCOMPARE(parallelManager.track(trackId)->classification(), serialManager.track(trackId)->classification());
+        QVERIFY(qAbs(parallel.closestApproach(trackId).timeToImpactSec -
+                     serial.closestApproach(trackId).timeToImpactSec) < 1e-6);
+    }
+    QCOMPARE(parallel.alerts().size(), serial.alerts().size());
+}
+
+void TestThreatAssessor::testTieredRates() {
+    TrackManager manager;
+    ThreatAssessor assessor(&manager);
+    ThreatAssessorConfig config;
+    config.tieredRates = true;
+    config.maxChangeRateHz = 0;
+    assessor.setConfig(config);
+    
+    DefendedAsset asset;
+    asset.id = "BASE-01";
+    asset.position = GeoPosition{34.0522, -118.2437, 100.0};
+    assessor.addDefendedAsset(asset);
+    
+    auto cycle = [&manager]() {
+        QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    };
+    auto assess = [&assessor]() {
+        QMetaObject::invokeMethod(&assessor, "performAssessmentCycle", Qt::DirectConnection);
+    };
+    
+    // North of the asset and stationary: critical, 2 km out and 11 km out
+    const TrackHandle inside = manager.handleOf(manager.createTrack(GeoPosition{34.0525, -118.2437, 100.0},
+                                                                    DetectionSource::Radar));
+    const TrackHandle middle = manager.handleOf(manager.createTrack(GeoPosition{34.0702, -118.2437, 100.0},
+                                                                    DetectionSource::Radar));
+    const QString farId = manager.createTrack(GeoPosition{34.1522, -118.2437, 100.0}, DetectionSource::Radar);
+    const TrackHandle far = manager.handleOf(farId);
+    cycle();
+    assess();
+    QCOMPARE(manager.updateTier(inside), TrackUpdateTier::Priority);
+    QCOMPARE(manager.updateTier(middle), TrackUpdateTier::Routine);
+    QCOMPARE(manager.updateTier(far), TrackUpdateTier::Background);
+    
+    // Tiers follow the assessment, here of a track declared hostile
+    manager.setTrackClassification(farId, TrackClassification::Hostile);
+    cycle();
+    assess();
+    assess();
+    QCOMPARE(manager.updateTier(far), TrackUpdateTier::Priority);
+    
+    // Leaving tiered rates puts every track back to Routine
+    config.tieredRates = false;
+    assessor.setConfig(config);
+    QCOMPARE(manager.updateTier(inside), TrackUpdateTier::Routine);
+    QCOMPARE(manager.updateTier(far), TrackUpdateTier::Routine);
+}
+
+void TestThreatAssessor::testSensorTasking() {
+    const GeoPosition base{34.0522, -118.2437, 100.0};
+    RadarSensor radar("RAD-1");
+    radar.setPosition(base);
+    RFDetector rf("RF-1");
+    rf.setPosition(base);
+    
+    SensorResourceManager tasking;
+    tasking.addSensor(&radar);
+    tasking.addSensor(&rf);
+    QCOMPARE(tasking.sensorIds().size(), 2);
+    
+    auto request = [](TrackHandle handle, double northM, double eastM, int level, double ttiSec, bool hasRF) {
+        SensorRequest r;
+        r.handle = handle;
+        r.position = GeoPosition{34.0522 + northM / 111000.0, -118.2437 + eastM / 91980.0, 100.0};
+        r.threatLevel = level;
+        r.timeToImpactSec = ttiSec;
+        r.hasRF = hasRF;
+        return r;
+    };
+    const SensorRequest a = request(1, 1000, 0, 5, 10.0, false);
+    const SensorRequest b = request(2, 0, 2000, 4, -1, false);
+    const SensorRequest c = request(3, 4000, 0, 3, -1, false);   // Beyond RF range
+    const SensorRequest d = request(4, 500, 0, 5, -1, true);     // Heard already
+    const SensorRequest e = request(5, 0, 1500, 5, 3.0, false);
+    
+    // The radar dwells on the top two; RF is cued to the top one it has not heard
+    const qint64 t0 = QDateTime::currentMSecsSinceEpoch();
+    QVector<SensorTask> issued = tasking.plan({b, c, d, a}, t0);
+    QCOMPARE(issued.size(), 3);
+    QVector<SensorTask> radarTasks = tasking.activeTasks("RAD-1");
+    QCOMPARE(radarTasks.size(), 2);
+    QCOMPARE(radarTasks[0].handle, a.handle);
+    QCOMPARE(radarTasks[1].handle, d.handle);
+    QCOMPARE(tasking.activeTasks("RF-1").first().handle, a.handle);
+    const RFCue cue = rf.cue();
+    QVERIFY(qAbs(cue.bearingDeg) < 1.0);
+    QCOMPARE(cue.untilMs, t0 + tasking.config().rfCueMs);
+    QVERIFY(cue.covers(5.0, t0));
+    QVERIFY(!cue.covers(90.0, t0));
+    
+    // Held tasks are not re-sent before they are due
+    QVERIFY(tasking.plan({a, b, c, d}, t0 + 100).isEmpty());
+    
+    // A slightly higher priority does not take RF from the track it holds
+    issued = tasking.plan({a, b, d, e}, t0 + 200);
+    QCOMPARE(tasking.activeTasks("RF-1").first().handle, a.handle);
+    QCOMPARE(issued.size(), 1);
+    QCOMPARE(issued.first().sensorId, QString("RAD-1"));
+    QCOMPARE(issued.first().handle, e.handle);
+    
+    // With a gone RF wants e, but has no token for it yet and stays on a
+    const quint64 limited = tasking.stats().rateLimited;
+    issued = tasking.plan({b, d, e}, t0 + 300);
+    QCOMPARE(issued.size(), 1);
+    QCOMPARE(issued.first().handle, d.handle);
+    QCOMPARE(tasking.stats().rateLimited, limited + 1);
+    QCOMPARE(tasking.activeTasks("RF-1").first().handle, a.handle);
+    
+    issued = tasking.plan({b, d, e}, t0 + 1100);
+    const auto rfTask = std::find_if(issued.cbegin(), issued.cend(), [](const SensorTask& task) {
+        return task.type == SensorTaskType::RFCue;
+    });
+    QVERIFY(rfTask != issued.cend());
+    QCOMPARE(rfTask->handle, e.handle);
+    QVERIFY(qAbs(rf.cue().bearingDeg - 90.0) < 1.0);
+    
+    // Destroyed sensors are forgotten
+    {
+        RFDetector second("RF-2");
+        second.setPosition(base);
+        tasking.addSensor(&second);
+        QCOMPARE(tasking.sensorIds().size(), 3);
+    }
+    tasking.plan({}, t0 + 1200);
+    QCOMPARE(tasking.sensorIds().size(), 2);
+}
+
+void TestThreatAssessor::testDefendedAssetIndex() {
+    // Tangent-plane range agrees with haversine at engagement distances
+    DefendedAsset base;
+    base.position = GeoPosition{34.0522, -118.2437, 100.0};
+    DefendedAssetIndex index;
+    index.rebuild(QList<DefendedAsset>{base});
+    QVERIFY(!index.hasTree());
+    
+    GeoPosition pos{34.0612, -118.2337, 100.0};
+    Track reference("ref");
+    reference.setPosition(pos);
+    const double haversine = reference.distanceTo(base.position);
+    QVERIFY(qAbs(index.nearestDistance(pos) - haversine) < haversine * 0.001);
+    
+    // Due-south track flying north is heading straight at the asset
+    VelocityVector vel;
+    vel.north = 15.0;
+    const DefendedAssetFix fix = index.nearest(GeoPosition{34.0422, -118.2437, 100.0}, &vel);
+    QCOMPARE(fix.asset, 0);
+    QVERIFY(fix.headingOffsetDeg < 1.0);
+    QVERIFY(qAbs(fix.distanceSqM2 - fix.distanceM * fix.distanceM) < 1.0);
+    
+    // The R-tree finds the same nearest range as a linear scan
+    QList<DefendedAsset> grid;
+    for (int i = 0; i < 60; ++i) {
+        DefendedAsset asset;
+        asset.id = QString("SITE-%1").arg(i);
+        asset.position = GeoPosition{34.0 + (i % 8) * 0.013, -118.0 + (i / 8) * 0.017, (i % 3) * 20.0};
+        grid.append(asset);
+    }
+    DefendedAssetIndex tree;
+    tree.rebuild(grid);
+    QVERIFY(tree.hasTree());
+    
+    for (int k = 0; k < 200; ++k) {
+        GeoPosition probe{33.99 + (k % 20) * 0.006, -118.01 + (k / 20) * 0.014, (k % 5) * 30.0};
+        double bestSq = std::numeric_limits<double>::max();
+        for (int i = 0; i < grid.size(); ++i) {
+            DefendedAssetIndex single;
+            single.rebuild(QList<DefendedAsset>{grid[i]});
+            const double dSq = single.nearest(probe).distanceSqM2;
+            bestSq = std::min(bestSq, dSq);
+        }
+        QVERIFY(qAbs(tree.nearest(probe).distanceM - std::sqrt(bestSq)) < 1.0);
+    }
+}
+
+void TestThreatAssessor::testGeofences() {
+    // A 2 km square restricted zone up to 150 m, and a many-sided zone
+    // tested against a plain scan of its edges
+    LocalTangentPlane site(GeoPosition{34.0522, -118.2437, 0.0});
+    GeofenceZone square;
+    square.id = "ZONE-SQ";
+    square.ceilingM = 150.0;
+    for (const EnuVector& corner : {EnuVector{-1000, -1000, 0}, EnuVector{1000, -1000, 0},
+                                    EnuVector{1000, 1000, 0}, EnuVector{-1000, 1000, 0}}) {
+        square.vertices.append(site.toGeoLinear(corner));
+    }
+    GeofenceZone star;
+    star.id = "ZONE-STAR";
+    star.type = GeofenceType::NoFly;
+    QVector<EnuVector> starCorners;
+    for (int i = 0; i < 200; ++i) {
+        const double angle = 2.0 * M_PI * i / 200;
+        const double radius = (i % 2) ? 600.0 : 900.0;
+        starCorners.append(EnuVector{4000.0 + radius * std::sin(angle), radius * std::cos(angle), 0.0});
+        star.vertices.append(site.toGeoLinear(starCorners.last()));
+    }
+    
+    GeofenceIndex index;
+    index.rebuild({square, star});
+    QCOMPARE(index.indexOf("ZONE-STAR"), 1);
+    QVERIFY(index.contains(0, site.toGeoLinear(EnuVector{0, 0, 100})));
+    QVERIFY(!index.contains(0, site.toGeoLinear(EnuVector{0, 0, 200})));   // Above the ceiling
+    QVERIFY(qAbs(index.signedDistanceM(0, site.toGeoLinear(EnuVector{0, 700, 50})) + 300.0) < 1.0);
+    QVERIFY(qAbs(index.signedDistanceM(0, site.toGeoLinear(EnuVector{1500, 0, 50})) - 500.0) < 1.0);
+    QVERIFY(std::isinf(index.signedDistanceM(0, site.toGeoLinear(EnuVector{1500, 0, 50}), 100.0)));
+    
+    for (int k = 0; k < 400; ++k) {
+        const EnuVector probe{3000.0 + (k % 20) * 100.0, -1000.0 + (k / 20) * 100.0, 50.0};
+        bool inside = false;
+        double nearest = std::numeric_limits<double>::max();
+        for (int i = 0; i < starCorners.size(); ++i) {
+            const EnuVector& a = starCorners[i];
+            const EnuVector& b = starCorners[(i + 1) % starCorners.size()];
+            if ((a.north > probe.north) != (b.north > probe.north) &&
+                a.east + (probe.north - a.north) * (b.east - a.east) / (b.north - a.north) > probe.east) {
+                inside = !inside;
+            }
+            const double dE = b.east - a.east;
+            const double dN = b.north - a.north;
+            const double t = qBound(0.0, ((probe.east - a.east) * dE + (probe.north - a.north) * dN) /
+                                         (dE * dE + dN * dN), 1.0);
+            nearest = std::min(nearest, std::hypot(a.east + t * dE - probe.east, a.north + t * dN - probe.north));
+        }
+        const GeoPosition pos = site.toGeoLinear(probe);
+        QCOMPARE(index.contains(1, pos), inside);
+        QVERIFY(qAbs(index.signedDistanceM(1, pos) - (inside ? -nearest : nearest)) < 1.0);
+    }
+    
+    // Rules: inside the square with a 200 m buffer, and outside the star
+    ThreatRule restricted;
+    restricted.id = "IN-SQ";
+    restricted.zoneId = "ZONE-SQ";
+    restricted.zoneMarginM = 200.0;
+    restricted.setThreatLevel = 4;
+    ThreatRule clear;
+    clear.id = "OUT-STAR";
+    clear.zoneId = "ZONE-STAR";
+    clear.requiresOutsideZone = true;
+    clear.threatLevelIncrease = 1;
+    ThreatRule unknown = restricted;
+    unknown.id = "IN-NONE";
+    unknown.zoneId = "ZONE-NONE";
+    
+    ThreatRuleProgram program;
+    program.compile({restricted, clear, unknown}, &index);
+    QCOMPARE(program.ruleCount(), 2);             // The unknown zone's rule is left out
+    QCOMPARE(program.zoneSlotCount(), 2);
+    QCOMPARE(program.zone(0), 0);
+    QVERIFY(program.zoneLimitM(0) > 200.0);
+    
+    const QVector<EnuVector> probes{{1150, 0, 50}, {1300, 0, 50}, {4000, 0, 50}};
+    QVector<double> distances(probes.size() * program.zoneSlotCount());
+    QVector<ThreatRuleInput> inputs(probes.size());
+    for (int i = 0; i < probes.size(); ++i) {
+        for (int s = 0; s < program.zoneSlotCount(); ++s) {
+            distances[i * 2 + s] = index.signedDistanceM(program.zone(s), site.toGeoLinear(probes[i]),
+                                                         program.zoneLimitM(s));
+        }
+        inputs[i].zoneDistancesM = distances.constData() + i * 2;
+    }
+    program.evaluate(inputs, nullptr);
+    QCOMPARE(inputs[0].threatLevel, 5);           // In the buffer and clear of the star
+    QCOMPARE(inputs[1].threatLevel, 2);
+    QCOMPARE(inputs[2].threatLevel, 1);           // Inside the star
+    
+    // Through the assessor, which resolves zone ids again when zones change
+    TrackManager manager;
+    ThreatAssessor assessor(&manager);
+    assessor.addRule(restricted);
+    const QString trackId = manager.createTrack(site.toGeoLinear(EnuVector{0, 0, 100}), DetectionSource::Radar);
+    assessor.assessTrack(trackId);
+    QVERIFY(manager.track(trackId)->threatLevel() < 4);
+    
+    QSignalSpy changed(&assessor, &ThreatAssessor::geofencesChanged);
+    assessor.addGeofence(square);
+    QCOMPARE(changed.count(), 1);
+    assessor.assessTrack(trackId);
+    QCOMPARE(manager.track(trackId)->threatLevel(), 4);
+    
+    const GeofenceZone restored = GeofenceZone::fromJson(square.toJson());
+    QCOMPARE(restored.vertices.size(), 4);
+    QCOMPARE(restored.ceilingM, 150.0);
+    QCOMPARE(ThreatRule::fromJson(restricted.toJson()).zoneMarginM, 200.0);
+}
+
+void TestThreatAssessor::testThreatQueue() {
+    // Heap order matches a full sort through inserts, re-keys and removals
+    ThreatPriorityQueue heap;
+    QHash<TrackHandle, ThreatPriorityQueue::Entry> reference;
+    quint32 seed = 12345;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for (int step = 0; step < 2000; ++step) {
+        ThreatPriorityQueue::Entry entry;
+        entry.handle = 1 + next() % 64;
+        if (next() % 4 == 0) {
+            heap.remove(entry.handle);
+            reference.remove(entry.handle);
+        } else {
+            entry.threatLevel = 1 + next() % 5;
+            entry.rangeM = next() % 5000;
+            heap.update(entry);
+            reference.insert(entry.handle, entry);
+        }
+        QCOMPARE(heap.size(), reference.size());
+    }
+    
+    QVector<ThreatPriorityQueue::Entry> expected;
+    for (const ThreatPriorityQueue::Entry& entry : reference) {
+        expected.append(entry);
+    }
+    std::sort(expected.begin(), expected.end(), &ThreatPriorityQueue::higherPriority);
+    QVector<ThreatPriorityQueue::Entry> visited;
+    heap.visitInOrder([&visited](const ThreatPriorityQueue::Entry& e) { visited.append(e); return false; });
+    QCOMPARE(visited.size(), expected.size());
+    for (int i = 0; i < expected.size(); ++i) {
+        QCOMPARE(visited[i].threatLevel, expected[i].threatLevel);
+        QCOMPARE(visited[i].rangeM, expected[i].rangeM);
+    }
+    QCOMPARE(heap.top().threatLevel, expected.first().threatLevel);
+    QCOMPARE(heap.top().rangeM, expected.first().rangeM);
+    
+    // The assessor keeps its queue current from change sets
+    TrackManager manager;
+    ThreatAssessor assessor(&manager);
+    ThreatAssessorConfig config;
+    config.maxChangeRateHz = 0;
+    config.incrementalAssessment = true;  // Levels only change when the test sets them
+    assessor.setConfig(config);
+    
+    DefendedAsset asset;
+    asset.id = "BASE-01";
+    asset.position = GeoPosition{34.0522, -118.2437, 100.0};
+    assessor.addDefendedAsset(asset);
+    
+    const QString nearId = manager.createTrack(GeoPosition{34.0540, -118.2437, 100.0}, DetectionSource::Radar);
+    const QString farId = manager.createTrack(GeoPosition{34.0700, -118.2437, 100.0}, DetectionSource::Radar);
+    const QString friendlyId = manager.createTrack(GeoPosition{34.0530, -118.2437, 100.0}, DetectionSource::Radar);
+    manager.setTrackClassification(nearId, TrackClassification::Hostile, 0.9);
+    manager.setTrackClassification(farId, TrackClassification::Pending, 0.5);
+    manager.setTrackClassification(friendlyId, TrackClassification::Friendly, 0.9);
+    manager.setTrackThreatLevel(nearId, 3);
+    manager.setTrackThreatLevel(farId, 3);
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    
+    QVector<TrackSnapshot> queue = assessor.threatQueueSnapshot();
+    QCOMPARE(queue.size(), 2);
+    QCOMPARE(queue[0].trackId, nearId);   // Same level, closer to the asset
+    QCOMPARE(queue[1].trackId, farId);
+    QCOMPARE(assessor.highestUnconfirmedThreat()->trackId(), nearId);
+    
+    manager.setTrackThreatLevel(farId, 5);
+    manager.associateCamera(nearId, "CAM-01");
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    queue = assessor.threatQueueSnapshot();
+    QCOMPARE(queue[0].trackId, farId);
+    
+    manager.setTrackThreatLevel(farId, 1);
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(assessor.threatQueue().first()->trackId(), nearId);
+    QCOMPARE(assessor.highestUnconfirmedThreat()->trackId(), farId);  // Near one is on camera
+    
+    manager.dropTrack(farId);
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(assessor.threatQueueSnapshot().size(), 1);
+    QVERIFY(assessor.highestUnconfirmedThreat() == nullptr);
+}
+
+void TestThreatAssessor::testClosestApproach() {
+    DefendedAsset base;
+    base.id = "BASE-01";
+    base.position = GeoPosition{34.0, -118.0, 0.0};
+    DefendedAssetIndex assets;
+    assets.rebuild(QList<DefendedAsset>{base});
+    ClosestApproachKernel kernel;
+    kernel.setAssets(assets);
+    
+    // Offsets in metres from the asset, in its own tangent plane
+    const double mLat = DefendedAssetIndex::METERS_PER_DEG_LAT;
+    const double mLon = assets.entry(0).metersPerDegLon;
+    auto at = [&](double east, double north) {
+        return GeoPosition{34.0 + north / mLat, -118.0 + east / mLon, 100.0};
+    };
+    
+    QVector<TrackSnapshot> tracks(3);
+    tracks[0].position = at(-1000.0, 0.0);    // Straight in at 10 m/s
+    tracks[0].velocity.east = 10.0;
+    tracks[1].position = at(-1000.0, 300.0);  // Crossing, passes 300 m off
+    tracks[1].velocity.east = 10.0;
+    tracks[2].position = at(0.0, 2000.0);     // Opening
+    tracks[2].velocity.north = 5.0;
+    
+    QVector<const TrackSnapshot*> batch;
+    for (const TrackSnapshot& t : tracks) batch.append(&t);
+    QVector<ClosestApproach> result;
+    kernel.compute(batch, result);
+    
+    QCOMPARE(result.size(), 3);
+    QCOMPARE(result[0].asset, 0);
+    QVERIFY(result[0].cpaDistanceM < 0.5);
+    QVERIFY(qAbs(result[0].timeToCpaSec - 100.0) < 0.01);
+    QVERIFY(qAbs(result[0].timeToImpactSec - 50.0) < 0.01);    // 500 m critical radius
+    QVERIFY(qAbs(result[1].cpaDistanceM - 300.0) < 0.5);
+    QVERIFY(qAbs(result[1].timeToImpactSec - 60.0) < 0.01);
+    QVERIFY(qAbs(result[2].cpaDistanceM - 2000.0) < 0.5);
+    QCOMPARE(result[2].timeToCpaSec, 0.0);
+    QCOMPARE(result[2].timeToImpactSec, -1.0);
+    
+    // Time-to-impact rule condition
+    ThreatRule imminent;
+    imminent.maxTimeToImpactSec = 55.0;
+    imminent.setThreatLevel = 5;
+    ThreatRuleProgram program;
+    program.compile(QList<ThreatRule>{imminent});
+    QVector<ThreatRuleInput> inputs(3);
+    for (int i = 0; i < 3; ++i) inputs[i].timeToImpactSec = result[i].timeToImpactSec;
+    program.evaluate(inputs, nullptr);
+    QCOMPARE(inputs[0].threatLevel, 5);
+    QCOMPARE(inputs[1].threatLevel, 1);
+    QCOMPARE(inputs[2].threatLevel, 1);
+    
+    // Swarm sizing: 16 assets against 2000 tracks, microseconds per track at most
+    QList<DefendedAsset> sites;
+    for (int a = 0; a < 16; ++a) {
+        DefendedAsset site;
+        site.position = GeoPosition{34.0 + a * 0.01, -118.0 + a * 0.01, 0.0};
+        sites.append(site);
+    }
+    assets.rebuild(sites);
+    kernel.setAssets(assets);
+    QVector<TrackSnapshot> swarm(2000);
+    QVector<const TrackSnapshot*> swarmBatch;
+    for (int i = 0; i < swarm.size(); ++i) {
+        swarm[i].position = GeoPosition{33.95 + (i % 100) * 0.002, -118.05 + (i / 100) * 0.01, 50.0};
+        swarm[i].velocity.east = (i % 7) - 3.0;
+        swarm[i].velocity.north = (i % 5) - 2.0;
+        swarmBatch.append(&swarm[i]);
+    }
+    QElapsedTimer timer;
+    timer.start();
+    for (int rep = 0; rep < 10; ++rep) {
+        kernel.compute(swarmBatch, result);
+    }
+    const double usPerTrack = timer.nsecsElapsed() / 1000.0 / (10.0 * swarm.size());
+    QVERIFY2(usPerTrack < 5.0, qPrintable(QString("%1 us per track").arg(usPerTrack)));
+}
+
+void TestThreatAssessor::testAlertStore() {
+    ThreatAlertStore store(4);
+    const QDateTime base = QDateTime::currentDateTimeUtc();
+    auto makeAlert = [&base](int n, const QString& trackId, const QString& ruleId) {
+        ThreatAlert alert;
+        alert.alertId = QString("ALERT-%1").arg(n);
+        alert.trackId = trackId;
+        alert.ruleId = ruleId;
+        alert.threatLevel = 3;
+        alert.timestamp = base.addSecs(n);
+        return alert;
+    };
+    
+    for (int n = 1; n <= 4; ++n) {
+        store.insert(makeAlert(n, QString("TRK-%1").arg(n), "RULE-001"));
+    }
+    QCOMPARE(store.size(), 4);
+    QCOMPARE(store.unacknowledgedCount(), 4);
+    
+    QVERIFY(store.acknowledge("ALERT-2", "OP1", base));
+    QVERIFY(!store.acknowledge("ALERT-2", "OP1", base));   // Already acknowledged
+    QVERIFY(store.find("ALERT-2")->acknowledged);
+    QCOMPARE(store.unacknowledgedCount(), 3);
+    
+    // Full: the oldest is evicted and reported
+    QString evicted;
+    store.insert(makeAlert(5, "TRK-5", "RULE-001"), &evicted);
+    QCOMPARE(evicted, QString("ALERT-1"));
+    QVERIFY(store.find("ALERT-1") == nullptr);
+    QCOMPARE(store.size(), 4);
+    
+    QList<ThreatAlert> pending = store.unacknowledged();
+    QCOMPARE(pending.size(), 3);
+    QCOMPARE(pending.first().alertId, QString("ALERT-3"));
+    QCOMPARE(pending.last().alertId, QString("ALERT-5"));
+    QCOMPARE(store.all().first().alertId, QString("ALERT-2"));
+    
+    // Suppression is per (track, rule), only while unacknowledged and inside the window
+    const qint64 t5 = base.addSecs(5).toMSecsSinceEpoch();
+    QVERIFY(store.isSuppressed("TRK-5", "RULE-001", t5 + 1000, 30000));
+    QVERIFY(!store.isSuppressed("TRK-5", "RULE-002", t5 + 1000, 30000));
+    QVERIFY(!store.isSuppressed("TRK-5", "RULE-001", t5 + 31000, 30000));
+    QVERIFY(!store.isSuppressed("TRK-2", "RULE-001", t5, 30000));  // Acknowledged
+    QVERIFY(!store.isSuppressed("TRK-1", "RULE-001", t5, 30000));  // Evicted
+    
+    QStringList trimmed;
+    store.setCapacity(2, &trimmed);
+    QCOMPARE(trimmed, QStringList({"ALERT-2", "ALERT-3"}));
+    QCOMPARE(store.unacknowledgedCount(), 2);
+    QVERIFY(store.find("ALERT-5") != nullptr);
+    
+    store.clear();
+    QVERIFY(store.isEmpty());
+    QCOMPARE(store.unacknowledgedCount(), 0);
+}
+
+void TestThreatAssessor::testReplicatedAlertLog() {
+    const QDateTime base = QDateTime::currentDateTimeUtc();
+    auto makeAlert = [&base](const QString& alertId, const QString& trackId, int second) {
+        ThreatAlert alert;
+        alert.alertId = alertId;
+        alert.trackId = trackId;
+        alert.ruleId = "RULE-001";
+        alert.threatLevel = 4;
+        alert.timestamp = base.addSecs(second);
+        return alert;
+    };
+    
+    // Two consoles raise the same threat before either hears of the other's
+    ReplicatedAlertLog a("A@1");
+    ReplicatedAlertLog b("B@1");
+    const AlertOp raiseA = a.raise(makeAlert("A-ALERT-000001", "TRK-1", 1));
+    const AlertOp raiseB = b.raise(makeAlert("B-ALERT-000001", "TRK-1", 2));
+    const AlertOp otherB = b.raise(makeAlert("B-ALERT-000002", "TRK-2", 3));
+    QCOMPARE(raiseA.sequence, quint64(1));
+    QCOMPARE(otherB.sequence, quint64(2));
+    QVERIFY(b.raise(makeAlert("B-ALERT-000001", "TRK-1", 2)).isNull());     // Already known
+    
+    // B's operator acknowledges B's copy; A's, raised earlier, is covered too
+    QVector<AlertChange> changes;
+    const AlertOp ackB = b.acknowledge("B-ALERT-000001", "OP-B", base.addSecs(5), &changes);
+    QCOMPARE(ackB.sequence, quint64(3));
+    QCOMPARE(changes.size(), 1);
+    QVERIFY(b.acknowledge("B-ALERT-000001", "OP-B", base.addSecs(6)).isNull());
+    
+    // A's operator acknowledges A's copy later, before B's ops arrive
+    const AlertOp ackA = a.acknowledge("A-ALERT-000001", "OP-A", base.addSecs(7));
+    QVERIFY(!ackA.isNull());
+    
+    // Ops out of their origin's order are refused until the gap fills
+    QCOMPARE(a.apply(ackB), ReplicatedAlertLog::ApplyResult::Gap);
+    changes.clear();
+    QCOMPARE(a.apply(raiseB, &changes), ReplicatedAlertLog::ApplyResult::Applied);
+    QCOMPARE(changes.size(), 1);
+    QCOMPARE(changes.first().kind, AlertChange::Kind::Raised);
+    QCOMPARE(changes.first().alert.acknowledgedBy, QString("OP-A"));   // Raised before A's acknowledgement
+    QCOMPARE(a.apply(raiseB), ReplicatedAlertLog::ApplyResult::Duplicate);
+    QCOMPARE(a.apply(raiseA), ReplicatedAlertLog::ApplyResult::Duplicate);     // Its own
+    QCOMPARE(a.apply(otherB), ReplicatedAlertLog::ApplyResult::Applied);
+    changes.clear();
+    QCOMPARE(a.apply(ackB, &changes), ReplicatedAlertLog::ApplyResult::Applied);
+    QVERIFY(changes.isEmpty());     // Both already acknowledged; only who did it first changes
+    
+    // B catches up from its digest of A
+    QVector<AlertOp> missing;
+    QVERIFY(a.opsSince(b.versions(), missing));
+    QCOMPARE(missing.size(), 2);
+    changes.clear();
+    for (const AlertOp& op : missing) {
+        QCOMPARE(b.apply(op, &changes), ReplicatedAlertLog::ApplyResult::Applied);
+    }
+    QCOMPARE(changes.size(), 1);
+    QVERIFY(changes.first().alert.acknowledged);    // Raised already covered by OP-B
+    
+    // Both agree, whatever order the acknowledgements came in: the earliest wins
+    QCOMPARE(a.versions(), b.versions());
+    for (const QString& id : {QString("A-ALERT-000001"), QString("B-ALERT-000001")}) {
+        QVERIFY(a.find(id)->acknowledged);
+        QCOMPARE(a.find(id)->acknowledgedBy, QString("OP-B"));
+        QCOMPARE(b.find(id)->acknowledgedBy, QString("OP-B"));
+        QCOMPARE(a.find(id)->acknowledgedTime, base.addSecs(5));
+    }
+    QVERIFY(!a.find("B-ALERT-000002")->acknowledged);
+    QVERIFY(!b.find("B-ALERT-000002")->acknowledged);
+    QVector<AlertOp> none;
+    QVERIFY(a.opsSince(b.versions(), none));
+    QVERIFY(none.isEmpty());
+    
+    // A console joining late gets the same state from the ops in any order
+    ReplicatedAlertLog c("C@1");
+    QCOMPARE(c.apply(ackA), ReplicatedAlertLog::ApplyResult::Gap);
+    QCOMPARE(c.apply(ackB), ReplicatedAlertLog::ApplyResult::Gap);
+    for (const AlertOp& op : {raiseB, otherB, ackB, raiseA, ackA}) {
+        QCOMPARE(c.apply(op), ReplicatedAlertLog::ApplyResult::Applied);
+    }
+    QCOMPARE(c.find("A-ALERT-000001")->acknowledgedBy, QString("OP-B"));
+    QCOMPARE(c.versions(), a.versions());
+    
+    // An alert raised after the acknowledgement is a new one
+    const AlertOp later = c.raise(makeAlert("C-ALERT-000001", "TRK-1", 9));
+    QVERIFY(!c.find("C-ALERT-000001")->acknowledged);
+    QCOMPARE(a.apply(later), ReplicatedAlertLog::ApplyResult::Applied);
+    QVERIFY(!a.find("C-ALERT-000001")->acknowledged);
+    
+    // A short log can no longer serve a newcomer; the whole state can
+    ReplicatedAlertLog trimmed("T@1", 500, 2);
+    for (int n = 1; n <= 4; ++n) {
+        trimmed.raise(makeAlert(QString("T-ALERT-%1").arg(n), QString("TRK-%1").arg(n), n));
+    }
+    trimmed.acknowledge("T-ALERT-2", "OP-T", base.addSecs(10));
+    ReplicatedAlertLog newcomer("N@1");
+    QVector<AlertOp> fromLog;
+    QVERIFY(!trimmed.opsSince(newcomer.versions(), fromLog));
+    changes.clear();
+    newcomer.merge(trimmed.state(), trimmed.versions(), &changes);
+    QCOMPARE(changes.size(), 5);    // Four raised, one of them then acknowledged
+    QCOMPARE(newcomer.size(), 4);
+    QVERIFY(newcomer.find("T-ALERT-2")->acknowledged);
+    QCOMPARE(newcomer.versions(), trimmed.versions());
+    newcomer.merge(trimmed.state(), trimmed.versions(), &changes);     // Idempotent
+    QCOMPARE(changes.size(), 5);
+    
+    // Capacity forgets the oldest alerts
+    newcomer.setCapacity(2);
+    QCOMPARE(newcomer.size(), 2);
+    QVERIFY(newcomer.find("T-ALERT-1") == nullptr);
+    QVERIFY(newcomer.find("T-ALERT-4") != nullptr);
+}
+
 QTEST_MAIN(TestThreatAssessor)
 #include "test_threat_assessor.moc"
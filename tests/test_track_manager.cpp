@@ -1,6 +1,87 @@
 #include <QtTest>
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
 #include "core/TrackManager.h"
 #include "core/Track.h"
+#include "core/TrackTable.h"
+#include "core/TrackSlab.h"
+#include "core/TrackChangeThrottle.h"
+#include "core/FusionEngine.h"
+#include "core/ShardedTrackManager.h"
+#include "core/DetectionMerger.h"
+#include "core/FusionPolicy.h"
+#include "core/TrackGroupIndex.h"
+#include "core/WeaponTargetAssigner.h"
+#include "core/SnapshotStore.h"
+#include "core/InterceptSolver.h"
+#include "core/TrackStateHistory.h"
+#include "core/TrackClassifier.h"
+#include "core/TrackFeatureBank.h"
+#include "core/TrackToTrackFusion.h"
+#include "core/CoverageService.h"
+#include "core/EngagementManager.h"
+#include "core/ThreatAlertStore.h"
+#include "utils/KalmanFilterBank.h"
+#include "utils/AssignmentSolver.h"
+#include "utils/BoundedQueue.h"
+#include "utils/ChaCha20Poly1305.h"
+#include "utils/CoverageRaster.h"
+#include "utils/DemTileStore.h"
+#include "utils/EngagementEnvelope.h"
+#include "utils/FastRandom.h"
+#include "utils/FlightRecorder.h"
+#include "utils/FramePool.h"
+#include "utils/FrameBuffer.h"
+#include "utils/FrameRing.h"
+#include "utils/IntervalTree.h"
+#include "utils/JsonReader.h"
+#include "utils/JsonWriter.h"
+#include "utils/LabelDeclutter.h"
+#include "utils/LatencyHistogram.h"
+#include "utils/LocalTangentPlane.h"
+#include "utils/MemoryAccounting.h"
+#include "utils/MemoryGovernor.h"
+#include "utils/OverloadController.h"
+#include "utils/MetricsRegistry.h"
+#include "utils/PipelineLatency.h"
+#include "utils/ScreenPickIndex.h"
+#include "utils/StatusBoard.h"
+#include "utils/TaskScheduler.h"
+#include "utils/TerrainModel.h"
+#include "utils/TimerWheel.h"
+#include "utils/TimerService.h"
+#include "utils/ThreadPlacement.h"
+#include "utils/Trace.h"
+#include "utils/VideoFrame.h"
+#include "utils/TimeUtils.h"
+#include "utils/Logger.h"
+#include "utils/LogStore.h"
+#include "utils/Clock.h"
+#include "sensors/SensorInterface.h"
+#include "sensors/RFBearingFuser.h"
+#include "sensors/AdsbDecoder.h"
+#include "sensors/AsterixDecoder.h"
+#include "sensors/AsterixSensor.h"
+#include "sensors/CameraModel.h"
+#include "sensors/CooperativeReceiver.h"
+#include "sensors/RadarSensor.h"
+#include "sensors/RadarVideoSource.h"
+#include "effectors/SpectrumPlanner.h"
+#include "effectors/DirectedEnergySystem.h"
+#include "effectors/KineticInterceptor.h"
+#include "simulators/FusionScorecard.h"
+#include "simulators/InterceptorFlights.h"
+#include "simulators/RawCaptureReplayer.h"
+#include "utils/CoordinateUtils.h"
 
 using namespace CounterUAS;
 
@@ -15,6 +96,78 @@ private slots:
     void testTrackCorrelation();
     void testTrackLifecycle();
     void testThreatLevel();
+    void testTracksInRadius();
+    void testDetectionBatch();
+    void testMultipleHypothesisAssociation();
+    void testTentativeInitiation();
+    void testRFBearingFusion();
+    void testSnapshot();
+    void testReplayMode();
+    void testMirrorMode();
+    void testVirtualClock();
+    void testStreamingJson();
+    void testTrackTable();
+    void testCorrelationScoring();
+    void testFusionPolicyGating();
+    void testTrackGroupIndex();
+    void testPositionHistoryRing();
+    void testKalmanFilterBank();
+    void testImmMode();
+    void testTrackHandles();
+    void testChangeSets();
+    void testBoundedQueue();
+    void testFastRandom();
+    void testAsyncLogger();
+    void testLogStoreCursor();
+    void testDetectionMerger();
+    void testSensorTelemetry();
+    void testRadarVideoRing();
+    void testFramePool();
+    void testVideoFrame();
+    void testFrameRing();
+    void testThreadedFusion();
+    void testShardedTrackManager();
+    void testRegionalFusion();
+    void testLabelDeclutter();
+    void testScreenPickIndex();
+    void testTrackToTrackFusion();
+    void testCheckpointRestore();
+    void testWeaponTargetAssignment();
+    void testTimerWheel();
+    void testTimerService();
+    void testThreadPlacement();
+    void testMemoryGovernor();
+    void testMemoryAccounting();
+    void testFusionScorecard();
+    void testSensorClock();
+    void testAsterixDecoder();
+    void testRawCapture();
+    void testCameraModel();
+    void testStatusBoard();
+    void testInterceptorFlights();
+    void testOverloadController();
+    void testSnapshotStore();
+    void testInterceptSolver();
+    void testIntervalTree();
+    void testSpectrumPlanner();
+    void testTrace();
+    void testFlightRecorder();
+    void testLatencyHistogram();
+    void testPipelineLatency();
+    void testMetricsRegistry();
+    void testLocalTangentPlane();
+    void testTrackStateHistory();
+    void testTrackClassifier();
+    void testCoverageRaster();
+    void testEngagementEnvelope();
+    void testEffectorTelemetry();
+    void testDemTileStore();
+    void testCooperativeReceiver();
+    void testAutoMerge();
+    void testTrackSlabRecycling();
+    void testTaskScheduler();
+    void testTieredRates();
+    void testChaCha20Poly1305();
     
 private:
     TrackManager* m_manager;
@@ -140,6 +293,4989 @@ void TestTrackManager::testThreatLevel() {
     
     m_manager->setTrackThreatLevel(trackId, -5);
     QCOMPARE(track->threatLevel(), 1);  // Should be minimum 1
+    
+    // Highest threat only considers hostile, live tracks
+    QVERIFY(m_manager->highestThreatTrack() == nullptr);
+    QString otherId = m_manager->createTrack(GeoPosition{34.06, -118.25, 100.0}, DetectionSource::Radar);
+    m_manager->setTrackClassification(trackId, TrackClassification::Hostile, 0.9);
+    m_manager->setTrackClassification(otherId, TrackClassification::Hostile, 0.9);
+    m_manager->setTrackThreatLevel(otherId, 3);
+    QCOMPARE(m_manager->highestThreatTrack()->trackId(), otherId);
+    
+    m_manager->setTrackThreatLevel(trackId, 5);
+    QCOMPARE(m_manager->highestThreatTrack()->trackId(), trackId);
+    
+    // A direct Track write is picked up by the next track cycle
+    m_manager->track(otherId)->setThreatLevel(5);
+    track->setThreatLevel(2);
+    QMetaObject::invokeMethod(m_manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(m_manager->highestThreatTrack()->trackId(), otherId);
+    
+    m_manager->dropTrack(otherId);
+    QCOMPARE(m_manager->highestThreatTrack()->trackId(), trackId);
+}
+
+void TestTrackManager::testTracksInRadius() {
+    m_manager->clearAllTracks();
+    
+    GeoPosition center;
+    center.latitude = 34.0522;
+    center.longitude = -118.2437;
+    center.altitude = 100.0;
+    
+    GeoPosition nearPos = center;
+    nearPos.latitude += 0.0009;   // ~100m north
+    
+    GeoPosition farPos = center;
+    farPos.longitude += 0.05;     // ~4.6km east
+    
+    QString nearId = m_manager->createTrack(nearPos, DetectionSource::Radar);
+    QString farId = m_manager->createTrack(farPos, DetectionSource::Radar);
+    
+    QList<Track*> inRadius = m_manager->tracksInRadius(center, 500.0);
+    QCOMPARE(inRadius.size(), 1);
+    QCOMPARE(inRadius.first()->trackId(), nearId);
+    
+    QCOMPARE(m_manager->tracksInRadius(center, 10000.0).size(), 2);
+    
+    // Caller-owned buffers are cleared and refilled in place
+    QVector<Track*> buffer;
+    m_manager->tracksInRadius(center, 10000.0, buffer);
+    QCOMPARE(buffer.size(), 2);
+    Track* const* storage = buffer.constData();
+    m_manager->tracksInRadius(center, 500.0, buffer);
+    QCOMPARE(buffer.size(), 1);
+    QCOMPARE(buffer.first()->trackId(), nearId);
+    QCOMPARE(buffer.constData(), storage);
+    m_manager->tracksByClassification(TrackClassification::Hostile, buffer);
+    QCOMPARE(buffer.size(), m_manager->hostileTracks().size());
+    
+    // Moving a track must move it between grid cells (the Kalman filter
+    // smooths the step, so query around wherever it actually landed)
+    m_manager->updateTrack(farId, center);
+    GeoPosition moved = m_manager->track(farId)->position();
+    QList<Track*> aroundMoved = m_manager->tracksInRadius(moved, 50.0);
+    QCOMPARE(aroundMoved.size(), 1);
+    QCOMPARE(aroundMoved.first()->trackId(), farId);
+    QVERIFY(m_manager->tracksInRadius(farPos, 50.0).isEmpty());
+    
+    // Dropped tracks leave the index
+    m_manager->dropTrack(nearId);
+    QVERIFY(m_manager->tracksInRadius(center, 500.0).isEmpty());
+}
+
+void TestTrackManager::testDetectionBatch() {
+    m_manager->clearAllTracks();
+    
+    GeoPosition posA;
+    posA.latitude = 34.0522;
+    posA.longitude = -118.2437;
+    posA.altitude = 100.0;
+    
+    GeoPosition posB = posA;
+    posB.longitude += 0.0006;     // ~55m east, inside the correlation gate
+    
+    auto makePlot = [](const GeoPosition& pos) {
+        SensorDetection det;
+        det.sensorId = "RADAR-TEST";
+        det.position = pos;
+        det.confidence = 0.9;
+        det.timestamp = QDateTime::currentMSecsSinceEpoch();
+        det.sourceType = DetectionSource::Radar;
+        return det;
+    };
+    
+    QSignalSpy batchSpy(m_manager, &TrackManager::tracksUpdated);
+    
+    // First scan initiates both tracks
+    m_manager->processDetectionBatch({makePlot(posA), makePlot(posB)});
+    QCOMPARE(m_manager->trackCount(), 2);
+    QCOMPARE(batchSpy.count(), 1);
+    QCOMPARE(batchSpy.takeFirst().at(0).toStringList().size(), 2);
+    
+    QList<Track*> nearA = m_manager->tracksInRadius(posA, 10.0);
+    QList<Track*> nearB = m_manager->tracksInRadius(posB, 10.0);
+    QCOMPARE(nearA.size(), 1);
+    QCOMPARE(nearB.size(), 1);
+    QString idA = nearA.first()->trackId();
+    QString idB = nearB.first()->trackId();
+    
+    // Both plots fall inside both gates; joint assignment must still keep
+    // one plot per track instead of piling both onto the closest one.
+    GeoPosition nextA = posA;
+    nextA.latitude += 0.00005;
+    GeoPosition nextB = posB;
+    nextB.latitude += 0.00005;
+    m_manager->processDetectionBatch({makePlot(nextB), makePlot(nextA)});
+    
+    QCOMPARE(m_manager->trackCount(), 2);
+    QCOMPARE(batchSpy.count(), 1);
+    QStringList updated = batchSpy.takeFirst().at(0).toStringList();
+    QCOMPARE(updated.size(), 2);
+    QVERIFY(updated.contains(idA));
+    QVERIFY(updated.contains(idB));
+    QCOMPARE(m_manager->track(idA)->state(), TrackState::Active);
+    QCOMPARE(m_manager->track(idB)->state(), TrackState::Active);
+    QVERIFY(m_manager->track(idA)->distanceTo(nextA) < m_manager->track(idA)->distanceTo(nextB));
+}
+
+void TestTrackManager::testMultipleHypothesisAssociation() {
+    // k-best ranks assignments cheapest first; of the six here they cost
+    // 5, 6, 6, 7, 9 and 11
+    const QVector<double> cost = {4, 1, 3,
+                                  2, 0, 5,
+                                  3, 2, 2};
+    QVector<AssignmentSolver::RankedAssignment> ranked = AssignmentSolver::solveKBest(cost, 3, 3, 4);
+    QCOMPARE(ranked.size(), 4);
+    QCOMPARE(ranked[0].assignment, AssignmentSolver::solve(cost, 3, 3));
+    QCOMPARE(ranked[0].cost, 5.0);
+    QCOMPARE(ranked[1].cost, 6.0);
+    QCOMPARE(ranked[2].cost, 6.0);
+    QCOMPARE(ranked[3].cost, 7.0);
+    QVERIFY(ranked[1].assignment != ranked[2].assignment);
+    // Rejected ones are passed over, not counted
+    ranked = AssignmentSolver::solveKBest(cost, 3, 3, 3,
+                                          [](const QVector<int>& a) { return a[0] != 1; });
+    QCOMPARE(ranked.size(), 3);
+    QCOMPARE(ranked[0].cost, 6.0);
+    QCOMPARE(ranked[2].cost, 7.0);
+    
+    const qint64 t0 = 1700000000000LL;
+    VirtualClock clock(t0);
+    TrackManager manager;
+    TrackManagerConfig config;
+    config.autoMerge = false;
+    config.associationMode = AssociationMode::Mht;
+    config.mhtBudgetUs = 0;
+    manager.setConfig(config);
+    manager.setClock(&clock);
+    
+    // Two targets cross, one heading north-east and one south-east; at
+    // scan 10 they are at the same point
+    const GeoPosition origin{34.0522, -118.2437, 100.0};
+    const double northStep = 10.0 / 111320.0;
+    const double eastStep = 10.0 / (111320.0 * std::cos(qDegreesToRadians(origin.latitude)));
+    auto target = [&](int scan, bool north) {
+        GeoPosition pos = origin;
+        pos.latitude += (north ? 1 : -1) * (scan - 10) * northStep;
+        pos.longitude += scan * eastStep;
+        return pos;
+    };
+    auto makePlot = [&](const GeoPosition& pos, bool north) {
+        SensorDetection det;
+        det.sensorId = "RADAR-TEST";
+        det.position = pos;
+        det.velocity.north = north ? 10.0 : -10.0;
+        det.velocity.east = 10.0;
+        det.confidence = 0.9;
+        det.timestamp = clock.nowMs();
+        det.sourceType = DetectionSource::Radar;
+        return det;
+    };
+    manager.processDetectionBatch({makePlot(target(0, true), true), makePlot(target(0, false), false)});
+    QCOMPARE(manager.trackCount(), 2);
+    const QString idNorth = manager.tracksInRadius(target(0, true), 10.0).first()->trackId();
+    const QString idSouth = manager.tracksInRadius(target(0, false), 10.0).first()->trackId();
+    for (int scan = 1; scan <= 20; ++scan) {
+        clock.advance(1000);
+        manager.processDetectionBatch({makePlot(target(scan, false), false), makePlot(target(scan, true), true)});
+    }
+    QCOMPARE(manager.trackCount(), 2);
+    QVERIFY(manager.track(idNorth)->distanceTo(target(20, true)) < 30.0);
+    QVERIFY(manager.track(idSouth)->distanceTo(target(20, false)) < 30.0);
+    TrackManager::Statistics stats = manager.statistics();
+    QVERIFY(stats.mhtClusters > 0);
+    QVERIFY(stats.mhtHypotheses >= stats.mhtClusters);
+    QCOMPARE(stats.mhtBudgetFallbacks, qint64(0));
+    
+    // Out of budget, the clusters still to solve are associated as GNN
+    TrackManager crowded;
+    config.mhtBudgetUs = 1;
+    crowded.setConfig(config);
+    crowded.setClock(&clock);
+    auto makeScan = [&](int scan) {
+        QVector<SensorDetection> plots;
+        for (int pair = 0; pair < 64; ++pair) {
+            for (bool north : {true, false}) {
+                SensorDetection det = makePlot(target(scan, north), north);
+                det.position.latitude += pair * 0.01;    // ~1 km between pairs
+                plots.append(det);
+            }
+        }
+        return plots;
+    };
+    for (int scan = 0; scan < 3; ++scan) {
+        crowded.processDetectionBatch(makeScan(scan));
+        clock.advance(1000);
+    }
+    QCOMPARE(crowded.trackCount(), 128);
+    stats = crowded.statistics();
+    QVERIFY(stats.mhtBudgetFallbacks > 0);
+    QCOMPARE(stats.correlationSuccessCount, 2 * 128);
+    
+    // Leaving Mht lets every open hypothesis go
+    config.associationMode = AssociationMode::Gnn;
+    manager.setConfig(config);
+    QCOMPARE(manager.statistics().mhtOpenTracks, 0);
+}
+
+void TestTrackManager::testTentativeInitiation() {
+    TrackManager manager;
+    TrackManagerConfig config;
+    config.correlationDistanceM = 100.0;
+    config.initiationHits = 2;     // 2-of-3
+    config.initiationScans = 3;
+    config.initiationScanMs = 100;
+    manager.setConfig(config);
+    
+    GeoPosition target;
+    target.latitude = 34.0522;
+    target.longitude = -118.2437;
+    target.altitude = 100.0;
+    
+    GeoPosition noise = target;
+    noise.longitude += 0.01;       // ~900m away, its own tentative
+    
+    auto makePlot = [](const GeoPosition& pos) {
+        SensorDetection det;
+        det.sensorId = "RADAR-TEST";
+        det.position = pos;
+        det.confidence = 0.9;
+        det.timestamp = QDateTime::currentMSecsSinceEpoch();
+        det.sourceType = DetectionSource::Radar;
+        return det;
+    };
+    
+    QSignalSpy createdSpy(&manager, &TrackManager::trackCreated);
+    
+    // First hits are held; a second plot in the same scan is not a second hit
+    manager.processDetectionBatch({makePlot(target), makePlot(noise)});
+    manager.processDetectionBatch({makePlot(target)});
+    QCOMPARE(manager.trackCount(), 0);
+    QCOMPARE(manager.tentativeCount(), 2);
+    QCOMPARE(createdSpy.count(), 0);
+    
+    // A hit in the next scan confirms the target as an active track
+    QTest::qWait(120);
+    GeoPosition moved = target;
+    moved.latitude += 0.0002;      // ~22m, inside the gate
+    manager.processDetectionBatch({makePlot(moved)});
+    QCOMPARE(manager.trackCount(), 1);
+    QCOMPARE(createdSpy.count(), 1);
+    Track* confirmed = manager.track(createdSpy.first().at(0).toString());
+    QVERIFY(confirmed != nullptr);
+    QCOMPARE(confirmed->state(), TrackState::Active);
+    QVERIFY(confirmed->hasSource(DetectionSource::Radar));
+    
+    // The lone noise plot runs out of opportunities and never becomes a track
+    QTest::qWait(250);
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(manager.tentativeCount(), 0);
+    QCOMPARE(manager.trackCount(), 1);
+    QCOMPARE(manager.statistics().totalTentativesConfirmed, qint64(1));
+    QCOMPARE(manager.statistics().totalTentativesExpired, qint64(1));
+}
+
+void TestTrackManager::testRFBearingFusion() {
+    RFBearingFuser fuser;
+    
+    GeoPosition emitter;
+    emitter.latitude = 34.0100;
+    emitter.longitude = -117.9900;
+    emitter.altitude = 150.0;
+    
+    auto makeBearing = [&emitter](const QString& sensorId, const GeoPosition& site,
+                                  double azimuthOffsetDeg) {
+        const double range = CoordinateUtils::haversineDistance(site, emitter);
+        SensorDetection det;
+        det.sensorId = sensorId;
+        det.position = site;       // Single-sensor estimate, deliberately poor
+        det.signalStrength = 0.5;
+        det.confidence = 0.7;
+        det.sourceType = DetectionSource::RFDetector;
+        setFixedString(det.info.rf.protocol, "DJI_OcuSync");
+        det.info.rf.frequencyMHz = 2437.0f;
+        det.info.rf.azimuthDeg = CoordinateUtils::bearing(site, emitter) + azimuthOffsetDeg;
+        det.info.rf.elevationDeg =
+            qRadiansToDegrees(std::atan2(emitter.altitude - site.altitude, range));
+        det.info.rf.bearingSigmaDeg = 2.0f;
+        det.info.rf.sensorLatitude = site.latitude;
+        det.info.rf.sensorLongitude = site.longitude;
+        det.info.rf.sensorAltitude = site.altitude;
+        return det;
+    };
+    
+    GeoPosition siteA{34.0000, -118.0000, 0.0};
+    GeoPosition siteB{34.0000, -117.9800, 0.0};
+    GeoPosition siteC{34.0200, -117.9900, 0.0};
+    
+    // Three detectors hear one emission; a fourth bearing on another band stays apart
+    fuser.addDetection(makeBearing("RF-A", siteA, 0.3), 1000);
+    fuser.addDetection(makeBearing("RF-B", siteB, -0.3), 1010);
+    fuser.addDetection(makeBearing("RF-C", siteC, 0.2), 1020);
+    SensorDetection otherBand = makeBearing("RF-A", siteA, 0.0);
+    otherBand.info.rf.frequencyMHz = 5800.0f;
+    fuser.addDetection(otherBand, 1030);
+    QCOMPARE(fuser.pendingBuckets(), 2);
+    QVERIFY(fuser.flush(1100).isEmpty());
+    
+    QVector<SensorDetection> out = fuser.flush(1300);
+    QCOMPARE(out.size(), 2);
+    const SensorDetection& fused =
+        out[0].info.rf.sensorCount > 0 ? out[0] : out[1];
+    QCOMPARE(fused.sourceType, DetectionSource::RFDetector);
+    QCOMPARE(int(fused.info.rf.sensorCount), 3);
+    QCOMPARE(fixedString(fused.info.rf.protocol), QString("DJI_OcuSync"));
+    QVERIFY(qAbs(fused.info.rf.frequencyMHz - 2437.0f) < 1e-3f);
+    QVERIFY(fused.metadata.isEmpty());
+    QVERIFY(CoordinateUtils::haversineDistance(fused.position, emitter) < 50.0);
+    QVERIFY(qAbs(fused.position.altitude - emitter.altitude) < 30.0);
+    QVERIFY(fused.confidence > 0.7);
+    
+    // Parallel bearings cannot be fixed; the bucket forwards one detection
+    GeoPosition siteD{34.0000, -117.9900, 0.0};
+    SensorDetection north = makeBearing("RF-A", siteA, 0.0);
+    SensorDetection alsoNorth = makeBearing("RF-D", siteD, 0.0);
+    north.info.rf.azimuthDeg = 0.0f;
+    alsoNorth.info.rf.azimuthDeg = 0.0f;
+    fuser.addDetection(north, 2000);
+    fuser.addDetection(alsoNorth, 2000);
+    out = fuser.flush(2000, true);
+    QCOMPARE(out.size(), 1);
+    QCOMPARE(int(out[0].info.rf.sensorCount), 0);
+    
+    RFBearingFuser::Stats stats = fuser.stats();
+    QCOMPARE(stats.fixes, qint64(1));
+    QCOMPARE(stats.bearingsFused, qint64(3));
+    QCOMPARE(stats.rejectedGeometry, qint64(1));
+}
+
+void TestTrackManager::testReplayMode() {
+    TrackManager manager;
+    TrackManagerConfig config = m_manager->config();
+    manager.setConfig(config);
+    
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    pos.altitude = 100.0;
+    manager.createTrack(pos, DetectionSource::Radar);
+    
+    // Entering replay clears live tracks and ignores sensor input
+    manager.setReplayMode(true);
+    QVERIFY(manager.isReplayMode());
+    QCOMPARE(manager.trackCount(), 0);
+    manager.processRadarDetection(pos, VelocityVector(), 0.9, QDateTime::currentMSecsSinceEpoch());
+    QCOMPARE(manager.trackCount(), 0);
+    
+    const qint64 t0 = 1700000000000LL;
+    TrackHistorySample first;
+    first.trackId = "TRK-0042";
+    first.timestamp = t0;
+    first.position = pos;
+    TrackHistorySample second = first;
+    second.timestamp = t0 + 1000;
+    second.position.latitude += 0.0001;     // ~11 m north in one second
+    
+    manager.applyReplaySamples({first, second}, t0 + 1000);
+    QCOMPARE(manager.trackCount(), 1);
+    Track* track = manager.track("TRK-0042");
+    QVERIFY(track != nullptr);
+    QCOMPARE(track->state(), TrackState::Active);
+    QCOMPARE(track->position().latitude, second.position.latitude);
+    QVERIFY(qAbs(track->velocity().north - 11.1) < 0.5);
+    QVERIFY(qAbs(track->velocity().east) < 0.1);
+    
+    // Pictures carry the replay time
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(manager.snapshot()->timestampMs, t0 + 1000);
+    QVERIFY(manager.snapshot()->find("TRK-0042") != nullptr);
+    
+    // Silence is measured on the replay clock, not the wall clock
+    manager.applyReplaySamples({}, t0 + 1000 + config.coastingTimeoutMs + 1);
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(track->state(), TrackState::Coasting);
+    
+    manager.setReplayMode(false);
+    QVERIFY(!manager.isReplayMode());
+    QCOMPARE(manager.trackCount(), 0);
+}
+
+void TestTrackManager::testMirrorMode() {
+    TrackManager core;
+    core.setConfig(m_manager->config());
+    TrackManager console;
+    console.setConfig(m_manager->config());
+    
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    pos.altitude = 100.0;
+    const QString first = core.createTrack(pos, DetectionSource::Radar);
+    const QString second = core.createTrack(CoordinateUtils::positionFromBearingDistance(pos, 90.0, 800.0),
+                                            DetectionSource::Radar);
+    core.setTrackThreatLevel(first, 5);
+    QMetaObject::invokeMethod(&core, "processTrackCycle", Qt::DirectConnection);
+    
+    // Sensor input is ignored by a mirror
+    console.setMirrorMode(true);
+    QVERIFY(console.isMirrorMode());
+    console.processRadarDetection(pos, VelocityVector(), 0.9, QDateTime::currentMSecsSinceEpoch());
+    QCOMPARE(console.trackCount(), 0);
+    
+    QSignalSpy highThreat(&console, &TrackManager::highThreatDetected);
+    QSignalSpy dropped(&console, &TrackManager::trackDropped);
+    console.applyMirrorPicture(core.snapshot());
+    QCOMPARE(console.trackCount(), 2);
+    QVERIFY(console.track(first) != nullptr);
+    QCOMPARE(console.track(first)->threatLevel(), 5);
+    QCOMPARE(highThreat.count(), 1);
+    
+    // The same picture again changes nothing
+    QMetaObject::invokeMethod(&console, "processTrackCycle", Qt::DirectConnection);
+    QSignalSpy changed(&console, &TrackManager::tracksChanged);
+    console.applyMirrorPicture(core.snapshot());
+    QMetaObject::invokeMethod(&console, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(changed.count(), 0);
+    QCOMPARE(console.snapshot()->timestampMs, core.snapshot()->timestampMs);
+    
+    // Nothing ages here: the picture decides the state
+    TrackSnapshot coasting = *core.snapshot()->find(second);
+    coasting.state = TrackState::Coasting;
+    coasting.lastUpdateMs -= 60000;
+    console.applyMirrorTracks({coasting}, {}, core.snapshot()->timestampMs + 60000);
+    QMetaObject::invokeMethod(&console, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(console.track(second)->state(), TrackState::Coasting);
+    QCOMPARE(console.track(first)->state(), core.track(first)->state());
+    
+    // A track left out of the picture is gone
+    core.dropTrack(second);
+    core.pruneDroppedTracks();
+    QMetaObject::invokeMethod(&core, "processTrackCycle", Qt::DirectConnection);
+    console.applyMirrorPicture(core.snapshot());
+    QCOMPARE(console.trackCount(), 1);
+    QCOMPARE(dropped.count(), 1);
+    QCOMPARE(dropped.first().first().toString(), second);
+    
+    console.setMirrorMode(false);
+    QCOMPARE(console.trackCount(), 0);
+}
+
+void TestTrackManager::testVirtualClock() {
+    const qint64 t0 = 1700000000000LL;
+    VirtualClock clock(t0);
+    TrackManager manager;
+    TrackManagerConfig config = m_manager->config();
+    manager.setConfig(config);
+    manager.setClock(&clock);
+    QCOMPARE(manager.clock()->nowMs(), t0);
+    
+    SensorDetection detection;
+    detection.sensorId = "RADAR-1";
+    detection.sourceType = DetectionSource::Radar;
+    detection.position.latitude = 34.0522;
+    detection.position.longitude = -118.2437;
+    detection.position.altitude = 100.0;
+    detection.confidence = 0.9;
+    detection.timestamp = t0;
+    manager.processDetectionBatch({detection});
+    QCOMPARE(manager.trackCount(), 1);
+    Track* track = manager.allTracks().first();
+    QCOMPARE(track->timeSinceUpdate(), 0LL);
+    
+    // Tracks age on the virtual clock only
+    manager.step();
+    QCOMPARE(manager.snapshot()->timestampMs, t0);
+    QVERIFY(track->state() != TrackState::Coasting);
+    
+    clock.advance(config.coastingTimeoutMs + 1);
+    QCOMPARE(track->timeSinceUpdate(), static_cast<qint64>(config.coastingTimeoutMs + 1));
+    manager.step();
+    QCOMPARE(track->state(), TrackState::Coasting);
+    QCOMPARE(manager.snapshot()->timestampMs, clock.nowMs());
+    
+    clock.advance(config.dropTimeoutMs);
+    manager.step();
+    QCOMPARE(manager.trackCount(), 0);
+    
+    manager.setClock(nullptr);
+    QCOMPARE(manager.clock(), Clock::system());
+    
+    // The system clock starts at wall time and never runs backwards
+    const qint64 systemNow = Clock::system()->nowMs();
+    QVERIFY(std::abs(systemNow - QDateTime::currentMSecsSinceEpoch()) < 1000);
+    QVERIFY(Clock::system()->nowMs() >= systemNow);
+    
+    // Timestamps are kept as clock ms and only formatted for JSON
+    Track stamped("CLK-0001");
+    stamped.setClock(&clock);
+    QCOMPARE(stamped.createdMs(), clock.nowMs());
+    QCOMPARE(stamped.timeSinceUpdate(clock.nowMs() + 250), 250LL);
+    Track* restored = Track::fromJson(stamped.toJson());
+    QCOMPARE(restored->createdMs(), stamped.createdMs());
+    QCOMPARE(restored->lastUpdateMs(), stamped.lastUpdateMs());
+    delete restored;
+}
+
+void TestTrackManager::testStreamingJson() {
+    // Each record streams the document its toJson() tree gives
+    Track track("JSON-0001");
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    pos.altitude = 120.25;
+    track.setPosition(pos);
+    VelocityVector vel;
+    vel.north = -12.5;
+    vel.east = 1.0 / 3.0;
+    track.setVelocity(vel);
+    track.setThreatLevel(4);
+    track.setClassificationConfidence(0.9);
+    track.setAssociatedCameraId(QString::fromUtf8("cam \"north\"\n\xc3\xa9"));
+    track.addDetectionSource(DetectionSource::Radar);
+    track.addDetectionSource(DetectionSource::Camera);
+    
+    JsonWriter writer;
+    track.writeJson(writer);
+    QCOMPARE(QJsonDocument::fromJson(writer.buffer()).object(), track.toJson());
+    
+    ThreatAlert alert;
+    alert.alertId = "ALT-1";
+    alert.trackId = "JSON-0001";
+    alert.ruleId = "rule\\1";
+    alert.groupId = 7;
+    alert.message = QString::fromUtf8("Inbound \xf0\x9f\x9a\x81 \t at 300 m");
+    alert.threatLevel = 5;
+    alert.timestamp = QDateTime::fromMSecsSinceEpoch(1700000000123LL);
+    alert.acknowledgedTime = QDateTime::fromMSecsSinceEpoch(1700000000999LL, Qt::UTC);
+    writer.clear();
+    alert.writeJson(writer);
+    QCOMPARE(QJsonDocument::fromJson(writer.buffer()).object(), alert.toJson());
+    alert.groupId = 0;
+    alert.acknowledgedTime = QDateTime();
+    writer.clear();
+    alert.writeJson(writer);
+    QCOMPARE(QJsonDocument::fromJson(writer.buffer()).object(), alert.toJson());
+    
+    EngagementRecord record;
+    record.engagementId = "ENG-1";
+    record.trackId = "JSON-0001";
+    record.startTime = QDateTime::fromMSecsSinceEpoch(1700000001005LL);
+    record.completionTime = QDateTime::fromMSecsSinceEpoch(1700000002000LL, Qt::UTC);
+    record.state = EngagementState::Authorized;
+    record.bdaResult = BDAResult::TargetMissed;
+    record.targetPosition = pos;
+    record.targetDistance = 1234.5;
+    record.notes = QString(QChar(0x01)) + "end";
+    writer.clear();
+    record.writeJson(writer);
+    QCOMPARE(QJsonDocument::fromJson(writer.buffer()).object(), record.toJson());
+    
+    // Non-finite doubles are null, as in QJsonDocument
+    writer.clear();
+    writer.beginArray();
+    writer.writeDouble(std::numeric_limits<double>::quiet_NaN());
+    writer.writeDouble(-0.5);
+    writer.endArray();
+    QCOMPARE(writer.buffer(), QByteArray("[null,-0.5]"));
+    
+    // The reader gives what QJsonValue::toVariant gives, escapes decoded
+    const QByteArray inbound = " {\"id\":\"R\\u00e9-\\ud83d\\ude81\", \"n\":[1, 2.5e3, -0.0, true, null],"
+                               " \"nested\":{\"a\":{\"b\":\"\\\"x\\/y\\\\\"}}, \"long\":\"0123456789abcdef0123\"} ";
+    JsonReader reader(inbound);
+    QVariant value;
+    QVERIFY(reader.readVariant(value));
+    QVERIFY(reader.atEnd());
+    QCOMPARE(value.toMap(), QJsonDocument::fromJson(inbound).object().toVariantMap());
+    
+    // Members are read or skipped in the order they come
+    JsonReader pull(inbound);
+    QVERIFY(pull.beginObject());
+    QString id;
+    double first = 0.0;
+    while (pull.nextKey()) {
+        if (pull.keyIs("id")) {
+            QVERIFY(pull.readString(id));
+        } else if (pull.keyIs("n")) {
+            QVERIFY(pull.beginArray());
+            QVERIFY(pull.nextElement());
+            QVERIFY(pull.readDouble(first));
+            while (pull.nextElement()) QVERIFY(pull.skipValue());
+        } else {
+            QVERIFY(pull.skipValue());
+        }
+    }
+    QVERIFY(pull.ok());
+    QCOMPARE(id, QString::fromUtf8("R\xc3\xa9-\xf0\x9f\x9a\x81"));
+    QCOMPARE(first, 1.0);
+    
+    // Malformed JSON stops the reader; numbers are held to RFC 8259
+    const char* malformed[] = {"{", "{\"a\":}", "[1,]", "{\"a\" 1}", "[01]", "[1.]", "[\"\\x\"]",
+                               "{\"a\":1,}", "[tru]", "[1e]", "\"open", "[1 2]", "{\"a\":1}x"};
+    for (const char* text : malformed) {
+        JsonReader bad(text, static_cast<int>(std::strlen(text)));
+        QVariant ignored;
+        QVERIFY2(!(bad.readVariant(ignored) && bad.atEnd()), text);
+    }
+    
+    // Nesting past MAX_DEPTH is refused
+    const QByteArray deep = QByteArray(JsonReader::MAX_DEPTH + 1, '[') + QByteArray(JsonReader::MAX_DEPTH + 1, ']');
+    JsonReader tooDeep(deep);
+    QVERIFY(!tooDeep.readVariant(value));
+}
+
+void TestTrackManager::testSnapshot() {
+    m_manager->clearAllTracks();
+    
+    TrackPicturePtr empty = m_manager->snapshot();
+    QVERIFY(empty != nullptr);
+    QCOMPARE(empty->tracks.size(), 0);
+    
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    pos.altitude = 100.0;
+    
+    QString trackId = m_manager->createTrack(pos, DetectionSource::Radar);
+    m_manager->setTrackThreatLevel(trackId, 3);
+    
+    // Nothing is visible to readers until the next track cycle publishes
+    QCOMPARE(m_manager->snapshot()->tracks.size(), 0);
+    
+    QSignalSpy publishedSpy(m_manager, &TrackManager::snapshotPublished);
+    QMetaObject::invokeMethod(m_manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(publishedSpy.count(), 1);
+    
+    TrackPicturePtr picture = m_manager->snapshot();
+    QVERIFY(picture->sequence > empty->sequence);
+    QCOMPARE(picture->tracks.size(), 1);
+    const TrackSnapshot* snap = picture->find(trackId);
+    QVERIFY(snap != nullptr);
+    QCOMPARE(snap->threatLevel, 3);
+    QCOMPARE(snap->classification, TrackClassification::Pending);
+    
+    // A held picture is immutable and outlives the tracks it describes
+    m_manager->clearAllTracks();
+    QCOMPARE(m_manager->snapshot()->tracks.size(), 0);
+    QCOMPARE(picture->tracks.size(), 1);
+    QCOMPARE(picture->find(trackId)->trackId, trackId);
+}
+
+void TestTrackManager::testTrackTable() {
+    TrackTable table;
+    int first = table.allocate();
+    int second = table.allocate();
+    QCOMPARE(table.liveCount(), 2);
+    
+    // Released rows are recycled before the table grows
+    table.release(first);
+    QVERIFY(!table.isLive(first));
+    QCOMPARE(table.allocate(), first);
+    QCOMPARE(table.capacity(), 2);
+    
+    // A bound track writes its setters through to the row
+    Track track("TBL-0001");
+    track.bindTable(&table, second);
+    GeoPosition pos;
+    pos.latitude = 34.05;
+    pos.longitude = -118.24;
+    track.setPosition(pos);
+    track.setState(TrackState::Active);
+    track.addDetectionSource(DetectionSource::RFDetector);
+    QCOMPARE(table.position(second).latitude, 34.05);
+    QCOMPARE(table.state(second), TrackState::Active);
+    QCOMPARE(table.sourceMask(second), TrackTable::sourceBit(DetectionSource::RFDetector));
+    
+    const qint64 now = table.lastUpdateMs(second);
+    table.setState(first, TrackState::Coasting);
+    table.setLastUpdateMs(first, now);
+    table.setCoastCount(first, 11);
+    
+    QVector<LifecycleTransition> transitions;
+    int coasting = table.lifecyclePass(now + 6000, 5000, 15000, 10, transitions);
+    QCOMPARE(coasting, 1);
+    QCOMPARE(transitions.size(), 2);
+    for (const LifecycleTransition& t : transitions) {
+        if (t.row == first) QCOMPARE(t.action, LifecycleAction::Drop);
+        else QCOMPARE(t.action, LifecycleAction::StartCoasting);
+    }
+    
+    // The indexes follow the setters, highest threat first, and a dropped
+    // row leaves them
+    QCOMPARE(table.stateCount(TrackState::Coasting), 1);
+    QCOMPARE(table.stateCount(TrackState::Active), 1);
+    track.setClassification(TrackClassification::Hostile);
+    track.setThreatLevel(4);
+    table.setClassification(first, TrackClassification::Hostile);
+    table.setThreatLevel(first, 2);
+    QCOMPARE(table.rowsWithClassification(TrackClassification::Hostile).size(), 2);
+    QVERIFY(table.rowsWithClassification(TrackClassification::Unknown).isEmpty());
+    QVector<int> byThreat;
+    table.rowsByThreatLevel(1, byThreat);
+    QCOMPARE(byThreat, (QVector<int>{second, first}));
+    byThreat.clear();
+    table.rowsByThreatLevel(3, byThreat);
+    QCOMPARE(byThreat, QVector<int>{second});
+    table.setState(first, TrackState::Dropped);
+    QCOMPARE(table.rowsWithClassification(TrackClassification::Hostile), QVector<int>{second});
+    QCOMPARE(table.stateCount(TrackState::Coasting), 0);
+    table.release(first);
+    QCOMPARE(table.stateCount(TrackState::Dropped), 0);
+    
+    track.unbindTable();
+}
+
+void TestTrackManager::testCorrelationScoring() {
+    TrackTable table;
+    table.setFrameOrigin(GeoPosition{34.0, -118.0, 0.0});
+    const qint64 now = 1000000;
+    CorrelationGate gate;
+    gate.distanceM = 100.0;
+    gate.velocityMps = 10.0;
+    gate.coastingTimeoutMs = 5000;
+    
+    // More rows than one block, some outside the gate, some stale, one dropped
+    QVector<int> rows;
+    for (int i = 0; i < 40; ++i) {
+        const int row = table.allocate();
+        table.setPosition(row, table.frame().toGeo(EnuVector{i * 5.0, -i * 3.0, double(i)}));
+        table.setVelocity(row, VelocityVector{i * 0.5, -1.0, 0.2 * i});
+        table.setLastUpdateMs(row, now - i * 400);
+        table.setState(row, i == 7 ? TrackState::Dropped : TrackState::Active);
+        rows.prepend(row);
+    }
+    
+    const EnuVector plot{2.0, -1.0, 0.5};
+    const VelocityVector vel{1.0, 2.0, 0.0};
+    auto reference = [&](int row) {
+        const double distance = EnuVector::distance(table.enuPosition(row), plot);
+        const VelocityVector v = table.velocity(row);
+        const double velDiff = std::sqrt(std::pow(v.north - vel.north, 2) +
+                                         std::pow(v.east - vel.east, 2) +
+                                         std::pow(v.down - vel.down, 2));
+        const double distanceScore = distance > gate.distanceM ? 0.0 : 1.0 - distance / gate.distanceM;
+        const double velocityScore = velDiff > gate.velocityMps ? 0.5 : 1.0 - velDiff / (2 * gate.velocityMps);
+        const qint64 age = now - table.lastUpdateMs(row);
+        const double timeScore = age > gate.coastingTimeoutMs
+            ? 0.3 : 1.0 - static_cast<double>(age) / gate.coastingTimeoutMs * 0.5;
+        return distanceScore * 0.5 + velocityScore * 0.3 + timeScore * 0.2;
+    };
+    
+    QVector<CorrelationCandidate> scores;
+    table.scoreCandidates(rows.constData(), rows.size(), plot, vel, now, gate, scores);
+    
+    QSet<int> scored;
+    for (const CorrelationCandidate& candidate : scores) {
+        const int row = rows[candidate.index];
+        scored.insert(row);
+        QVERIFY(table.state(row) != TrackState::Dropped);
+        QVERIFY(EnuVector::distance(table.enuPosition(row), plot) <= gate.distanceM);
+        QVERIFY(std::abs(candidate.score - reference(row)) < 1e-12);
+    }
+    
+    // Anything gated out could not have cleared the correlation threshold
+    int inside = 0;
+    for (int row : rows) {
+        const bool gated = EnuVector::distance(table.enuPosition(row), plot) <= gate.distanceM &&
+                           table.state(row) != TrackState::Dropped;
+        inside += gated;
+        QCOMPARE(scored.contains(row), gated);
+        if (!scored.contains(row) && table.state(row) != TrackState::Dropped) {
+            QVERIFY(reference(row) <= 0.5);
+        }
+    }
+    QCOMPARE(scores.size(), inside);
+    QVERIFY(inside > TrackTable::CORRELATION_BLOCK);
+    QVERIFY(inside < rows.size() - 1);
+}
+
+void TestTrackManager::testFusionPolicyGating() {
+    TrackTable table;
+    table.setFrameOrigin(GeoPosition{34.0, -118.0, 0.0});
+    const qint64 now = 1000000;
+    CorrelationGate gate;
+    gate.distanceM = 100.0;
+    
+    // A fast track 300 m due north of the plot, and one 300 m due east
+    QVector<int> rows;
+    for (const EnuVector& at : {EnuVector{0.0, 300.0, 0.0}, EnuVector{300.0, 0.0, 0.0}}) {
+        const int row = table.allocate();
+        table.setPosition(row, table.frame().toGeo(at));
+        table.setVelocity(row, VelocityVector{30.0, 0.0, 0.0});
+        table.setLastUpdateMs(row, now);
+        table.setState(row, TrackState::Active);
+        rows.append(row);
+    }
+    
+    // Due north on a direction-finding bearing: only the track along it gates
+    SensorDetection bearing;
+    bearing.sourceType = DetectionSource::RFDetector;
+    bearing.info.rf.bearingSigmaDeg = 3.0f;
+    gate.lineOfSight = RFFusionPolicy::lineOfSight(bearing);
+    QVERIFY(std::abs(gate.lineOfSight.north - 1.0) < 1e-12);
+    
+    QVector<CorrelationCandidate> scores;
+    table.scoreCandidates<RFFusionPolicy>(rows.constData(), rows.size(), EnuVector(),
+                                          VelocityVector(), now, gate, scores);
+    QCOMPARE(scores.size(), 1);
+    QCOMPARE(scores[0].index, 0);
+    // 300 m at a quarter is 75 m; no velocity measured, so none held against it
+    QVERIFY(std::abs(scores[0].score - (0.25 * 0.5 + 0.3 + 0.2)) < 1e-9);
+    
+    // A fix without a bearing gates as a point, as radar does
+    gate.lineOfSight = RFFusionPolicy::lineOfSight(SensorDetection());
+    scores.clear();
+    table.scoreCandidates<RFFusionPolicy>(rows.constData(), rows.size(), EnuVector(),
+                                          VelocityVector(), now, gate, scores);
+    QVERIFY(scores.isEmpty());
+    
+    // Radar holds the velocity miss against the track
+    const EnuVector near{0.0, 290.0, 0.0};
+    QVector<CorrelationCandidate> radar;
+    QVector<CorrelationCandidate> camera;
+    table.scoreCandidates<RadarFusionPolicy>(rows.constData(), rows.size(), near,
+                                             VelocityVector(), now, gate, radar);
+    table.scoreCandidates<CameraFusionPolicy>(rows.constData(), rows.size(), near,
+                                              VelocityVector(), now, gate, camera);
+    QCOMPARE(radar.size(), 1);
+    QCOMPARE(camera.size(), 1);
+    QVERIFY(std::abs(camera[0].score - radar[0].score - 0.15) < 1e-9);
+}
+
+void TestTrackManager::testTrackGroupIndex() {
+    const LocalTangentPlane frame(GeoPosition{34.0, -118.0, 0.0});
+    const VelocityVector cruise{0.0, 20.0, 0.0};
+    TrackGroupIndex index;
+    TrackGroupIndex::Changes changes;
+    
+    // A line of five 50 m apart, and 200 lone tracks a kilometre apart
+    for (int i = 0; i < 5; ++i) {
+        index.update(TrackHandle(1 + i), frame.toGeo(EnuVector{i * 50.0, 0.0, 100.0}), cruise);
+    }
+    for (int i = 0; i < 200; ++i) {
+        const EnuVector at{(i % 20) * 1000.0, 5000.0 + (i / 20) * 1000.0, 100.0};
+        index.update(TrackHandle(100 + i), frame.toGeo(at), cruise);
+    }
+    index.recluster(1000, changes);
+    QCOMPARE(index.groupCount(), 1);
+    QCOMPARE(changes.changed.size(), 1);
+    const quint32 id = changes.changed[0];
+    QCOMPARE(index.groupOf(3), id);
+    QCOMPARE(index.groupOf(100), 0u);
+    const TrackGroup* group = index.group(id);
+    QCOMPARE(group->members.size(), 5);
+    QVERIFY(std::abs(group->extentM - 100.0) < 0.5);
+    QVERIFY(std::abs(frame.toEnu(group->centroid).east - 100.0) < 0.5);
+    QCOMPARE(group->velocity.east, 20.0);
+    
+    // Nothing moved: nothing walked
+    index.recluster(1100, changes);
+    QVERIFY(changes.isEmpty());
+    QCOMPARE(index.lastVisited(), 0);
+    
+    // Within tolerance only the summary follows; a real move walks the
+    // group alone and keeps its id
+    index.update(1, frame.toGeo(EnuVector{5.0, 0.0, 100.0}), cruise);
+    index.recluster(1200, changes);
+    QCOMPARE(index.lastVisited(), 0);
+    QVERIFY(index.group(id)->extentM < 100.0);
+    index.update(1, frame.toGeo(EnuVector{-20.0, 0.0, 100.0}), cruise);
+    index.recluster(1300, changes);
+    QCOMPARE(index.groupOf(1), id);
+    QCOMPARE(index.lastVisited(), 5);
+    QCOMPARE(index.group(id)->formedMs, qint64(1000));
+    
+    // The tail flies off: the rest keeps the id, the tail leaves
+    index.update(4, frame.toGeo(EnuVector{150.0, 3000.0, 100.0}), cruise);
+    index.update(5, frame.toGeo(EnuVector{200.0, 3000.0, 100.0}), cruise);
+    index.recluster(1400, changes);
+    QCOMPARE(index.group(id)->members.size(), 3);
+    QCOMPARE(changes.left.size(), 2);
+    QCOMPARE(index.groupOf(4), 0u);
+    
+    // Too few left: dissolved
+    index.remove(2);
+    index.recluster(1500, changes);
+    QCOMPARE(changes.dissolved, QVector<quint32>{id});
+    QCOMPARE(index.groupCount(), 0);
+    QCOMPARE(index.groupOf(1), 0u);
+    
+    // One jammer covers a group through its lead; the rest stay open to
+    // point effectors
+    const GeoPosition base{34.0, -118.0, 0.0};
+    AssignmentEffector jammer;
+    jammer.effectorId = "JAM";
+    jammer.effectorType = "RF_JAMMER";
+    jammer.position = base;
+    jammer.channels = 2;
+    WeaponTargetAssigner assigner;
+    assigner.updateEffector(jammer);
+    for (int i = 0; i < 3; ++i) {
+        AssignmentThreat threat;
+        threat.trackId = QString("S%1").arg(i);
+        threat.position = frame.toGeo(EnuVector{i * 50.0, 400.0, 100.0});
+        threat.classification = TrackClassification::Hostile;
+        threat.threatLevel = i == 1 ? 5 : 4;
+        threat.groupId = 7;
+        threat.groupSize = 3;
+        assigner.updateThreat(threat);
+    }
+    const QVector<WeaponAssignment> plan = assigner.solve();
+    QCOMPARE(plan.size(), 1);
+    QCOMPARE(plan[0].trackId, QString("S1"));
+    
+    // Worth the whole group to the jammer
+    AssignmentThreat lone;
+    lone.trackId = "L1";
+    lone.position = frame.toGeo(EnuVector{50.0, 400.0, 100.0});
+    lone.classification = TrackClassification::Hostile;
+    lone.threatLevel = 5;
+    assigner.updateThreat(lone);
+    QVERIFY(std::abs(assigner.score("S1", "JAM") - 3.0 * assigner.score("L1", "JAM")) < 1e-9);
+}
+
+void TestTrackManager::testPositionHistoryRing() {
+    RingBuffer<int> ring(3);
+    for (int i = 1; i <= 5; ++i) {
+        ring.append(i);
+    }
+    QCOMPARE(ring.size(), 3);
+    QCOMPARE(ring.first(), 3);
+    QCOMPARE(ring.last(), 5);
+    
+    // Wrapped contents are exposed as two contiguous segments, oldest first
+    RingBuffer<int>::Segments seg = ring.segments();
+    QCOMPARE(seg.firstCount + seg.secondCount, 3);
+    QCOMPARE(seg.first[0], 3);
+    
+    // Track history capacity follows the manager's retention window
+    const TrackManagerConfig original = m_manager->config();
+    TrackManagerConfig config = original;
+    config.historyRetentionMs = 2000;
+    config.updateRateHz = 10;
+    m_manager->setConfig(config);
+    
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    QString trackId = m_manager->createTrack(pos, DetectionSource::Radar);
+    Track* t = m_manager->track(trackId);
+    QVERIFY(t != nullptr);
+    QCOMPARE(t->historyCapacity(), 20);
+    
+    for (int i = 0; i < 50; ++i) {
+        t->addPositionHistory(pos, i);
+    }
+    qint64 oldest = -1;
+    int visited = 0;
+    t->visitPositionHistory([&](const GeoPosition&, qint64 timestamp) {
+        if (visited++ == 0) oldest = timestamp;
+    });
+    QCOMPARE(visited, 20);
+    QCOMPARE(oldest, qint64(30));
+    QCOMPARE(t->positionHistory().size(), 20);
+    
+    m_manager->setConfig(original);
+}
+
+void TestTrackManager::testKalmanFilterBank() {
+    KalmanFilterBank bank;
+    bank.setMeasurementNoise(5.0);
+    
+    EnuVector start;
+    bank.initialize(0, start, 0, MotionModel::ConstantVelocity);
+    bank.initialize(1, start, 0, MotionModel::ConstantAcceleration);
+    QVERIFY(bank.isActive(0));
+    QVERIFY(bank.isActive(1));
+    
+    // Target flying east at 20 m/s while slot 1 also sees a 2 m/s^2 climb
+    for (int k = 1; k <= 40; ++k) {
+        const double t = k * 0.5;
+        const qint64 ms = static_cast<qint64>(t * 1000.0);
+        bank.predictAll(ms - 100);
+        
+        EnuVector cv;
+        cv.east = 20.0 * t;
+        bank.update(0, cv, ms);
+        
+        EnuVector ca = cv;
+        ca.up = 0.5 * 2.0 * t * t;
+        bank.update(1, ca, ms);
+    }
+    
+    QVERIFY(qAbs(bank.velocity(0).east - 20.0) < 1.0);
+    QVERIFY(qAbs(bank.acceleration(0).up) < 1e-9);  // CV keeps acceleration pinned
+    QVERIFY(qAbs(bank.acceleration(1).up - 2.0) < 0.3);
+    
+    // Coasting: covariance grows and extrapolation follows the motion model
+    double before = bank.positionVariance(0);
+    bank.predictAll(bank.timestampMs(0) + 1000);
+    QVERIFY(bank.positionVariance(0) > before);
+    EnuVector ahead = bank.predictedPosition(0, 1000);
+    QVERIFY(qAbs(ahead.east - bank.position(0).east - 20.0) < 1.0);
+    
+    bank.release(0);
+    QVERIFY(!bank.isActive(0));
+    
+    // A late plot replayed from history matches fusing it in order
+    KalmanFilterBank inOrder;
+    KalmanFilterBank late;
+    inOrder.setHistoryDepth(8);
+    late.setHistoryDepth(8);
+    inOrder.initialize(0, start, 0, MotionModel::ConstantAcceleration);
+    late.initialize(0, start, 0, MotionModel::ConstantAcceleration);
+    auto plot = [](int k) {
+        EnuVector z;
+        z.east = 10.0 * k + (k % 3);
+        z.north = -5.0 * k;
+        z.up = 0.25 * k * k;
+        return z;
+    };
+    for (int k = 1; k <= 6; ++k) {
+        inOrder.predictAll(k * 500 - 100);
+        inOrder.update(0, plot(k), k * 500);
+        if (k == 4) continue;  // Delayed until after the newest plot
+        late.predictAll(k * 500 - 100);
+        late.update(0, plot(k), k * 500);
+    }
+    QCOMPARE(late.update(0, plot(4), 2000), KalmanFilterBank::UpdateResult::Replayed);
+    QCOMPARE(late.timestampMs(0), inOrder.timestampMs(0));
+    QVERIFY(qAbs(late.position(0).east - inOrder.position(0).east) < 1e-6);
+    QVERIFY(qAbs(late.velocity(0).north - inOrder.velocity(0).north) < 1e-6);
+    QVERIFY(qAbs(late.positionVariance(0) - inOrder.positionVariance(0)) < 1e-6);
+    
+    // Older than the initial state: nothing to rewind to
+    QCOMPARE(late.update(0, plot(1), -100), KalmanFilterBank::UpdateResult::TooOld);
+}
+
+void TestTrackManager::testImmMode() {
+    const TrackManagerConfig original = m_manager->config();
+    TrackManagerConfig config = original;
+    config.enableImmFilter = true;
+    m_manager->setConfig(config);
+    
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    pos.altitude = 100.0;
+    QString trackId = m_manager->createTrack(pos, DetectionSource::RFDetector);
+    
+    for (int i = 0; i < 5; ++i) {
+        pos.latitude += 0.0001;
+        m_manager->updateTrack(trackId, pos);
+    }
+    
+    Track* t = m_manager->track(trackId);
+    QVERIFY(t != nullptr);
+    MotionModeProbabilities modes = t->modeProbabilities();
+    QVERIFY(qAbs(modes.constantVelocity + modes.constantAcceleration +
+                 modes.coordinatedTurn - 1.0) < 1e-6);
+    QVERIFY(modes.coordinatedTurn > 0.0);
+    
+    // Filter extrapolation stays near the filtered position for short leads
+    GeoPosition ahead = m_manager->predictedPosition(trackId, 100);
+    QVERIFY(qAbs(ahead.latitude - t->position().latitude) < 0.01);
+    
+    m_manager->setConfig(original);
+}
+
+void TestTrackManager::testTrackHandles() {
+    m_manager->clearAllTracks();
+    
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    pos.altitude = 100.0;
+    
+    QSignalSpy createdSpy(m_manager, &TrackManager::trackHandleCreated);
+    QSignalSpy droppedSpy(m_manager, &TrackManager::trackHandleDropped);
+    
+    QString trackId = m_manager->createTrack(pos, DetectionSource::Radar);
+    TrackHandle handle = m_manager->handleOf(trackId);
+    QVERIFY(handle != INVALID_TRACK_HANDLE);
+    QCOMPARE(createdSpy.count(), 1);
+    QCOMPARE(createdSpy.takeFirst().at(0).value<TrackHandle>(), handle);
+    
+    // The display id is derived from the handle and both resolve the same track
+    QCOMPARE(TrackManager::formatTrackId(handle), trackId);
+    Track* t = m_manager->track(handle);
+    QVERIFY(t != nullptr);
+    QCOMPARE(t, m_manager->track(trackId));
+    QCOMPARE(t->handle(), handle);
+    QCOMPARE(m_manager->handleOf("TRK-UNKNOWN"), INVALID_TRACK_HANDLE);
+    
+    QSignalSpy cycleSpy(m_manager, &TrackManager::tracksChanged);
+    QMetaObject::invokeMethod(m_manager, "processTrackCycle", Qt::DirectConnection);
+    QCOMPARE(cycleSpy.count(), 1);
+    QCOMPARE(cycleSpy.takeFirst().at(0).value<TrackChangeSet>().handles, QVector<TrackHandle>{handle});
+    
+    const TrackSnapshot* snap = m_manager->snapshot()->find(handle);
+    QVERIFY(snap != nullptr);
+    QCOMPARE(snap->trackId, trackId);
+    
+    // Handles are never reused, even after the track is pruned
+    m_manager->dropTrack(trackId);
+    QCOMPARE(droppedSpy.count(), 1);
+    m_manager->pruneDroppedTracks();
+    QVERIFY(m_manager->track(handle) == nullptr);
+    QString nextId = m_manager->createTrack(pos, DetectionSource::Radar);
+    QVERIFY(m_manager->handleOf(nextId) > handle);
+    
+    m_manager->clearAllTracks();
+}
+
+void TestTrackManager::testChangeSets() {
+    m_manager->clearAllTracks();
+    
+    GeoPosition pos;
+    pos.latitude = 34.0522;
+    pos.longitude = -118.2437;
+    pos.altitude = 100.0;
+    
+    QString idA = m_manager->createTrack(pos, DetectionSource::Radar);
+    pos.longitude += 0.01;
+    QString idB = m_manager->createTrack(pos, DetectionSource::Radar);
+    TrackHandle handleA = m_manager->handleOf(idA);
+    TrackHandle handleB = m_manager->handleOf(idB);
+    
+    QSignalSpy changedSpy(m_manager, &TrackManager::tracksChanged);
+    TrackChangeThrottle unthrottled(m_manager, 0);
+    TrackChangeThrottle slow(m_manager, 1);
+    QSignalSpy unthrottledSpy(&unthrottled, &TrackChangeThrottle::tracksChanged);
+    QSignalSpy slowSpy(&slow, &TrackChangeThrottle::tracksChanged);
+    
+    auto cycle = [this]() {
+        QMetaObject::invokeMethod(m_manager, "processTrackCycle", Qt::DirectConnection);
+    };
+    
+    // First cycle reports both new tracks, once each
+    cycle();
+    QCOMPARE(changedSpy.count(), 1);
+    TrackChangeSet first = changedSpy.takeFirst().at(0).value<TrackChangeSet>();
+    QCOMPARE(first.size(), 2);
+    QVERIFY(first.fieldsFor(handleA) & TrackChangeCreated);
+    QVERIFY(first.fieldsFor(handleB) & TrackChangeCreated);
+    QCOMPARE(first.sequence, m_manager->snapshot()->sequence);
+    
+    // Nothing changed, nothing emitted
+    cycle();
+    QCOMPARE(changedSpy.count(), 0);
+    
+    // Several updates to one track coalesce into a single entry
+    m_manager->updateTrack(idA, pos);
+    m_manager->updateTrack(idA, pos);
+    m_manager->setTrackThreatLevel(idA, 4);
+    cycle();
+    QCOMPARE(changedSpy.count(), 1);
+    TrackChangeSet second = changedSpy.takeFirst().at(0).value<TrackChangeSet>();
+    QCOMPARE(second.handles, QVector<TrackHandle>{handleA});
+    QVERIFY(second.fields.first() & TrackChangePosition);
+    QVERIFY(second.fields.first() & TrackChangeThreatLevel);
+    QVERIFY(!(second.fields.first() & TrackChangeCreated));
+    
+    // Rate 0 forwards each set; 1 Hz delivers the first and holds the rest
+    QCOMPARE(unthrottledSpy.count(), 2);
+    QCOMPARE(slowSpy.count(), 1);
+    QVERIFY(slow.hasPending());
+    
+    m_manager->dropTrack(idB);
+    cycle();
+    QCOMPARE(slowSpy.count(), 1);
+    slow.flush();
+    QCOMPARE(slowSpy.count(), 2);
+    TrackChangeSet merged = slowSpy.takeLast().at(0).value<TrackChangeSet>();
+    QCOMPARE(merged.size(), 2);
+    QVERIFY(merged.fieldsFor(handleA) & TrackChangePosition);
+    QVERIFY(merged.fieldsFor(handleB) & TrackChangeDropped);
+    
+    m_manager->clearAllTracks();
+}
+
+void TestTrackManager::testBoundedQueue() {
+    BoundedQueue<int> queue(3);
+    QCOMPARE(static_cast<int>(queue.capacity()), 4);  // Rounded to a power of two
+    
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(queue.tryPush(i));
+    }
+    QVERIFY(!queue.tryPush(4));  // Full: rejected, never blocks
+    QCOMPARE(static_cast<int>(queue.sizeApprox()), 4);
+    
+    int value = -1;
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(queue.tryPop(value));
+        QCOMPARE(value, i);
+    }
+    QVERIFY(!queue.tryPop(value));
+    
+    // Wraps around the ring
+    QVERIFY(queue.tryPush(7));
+    QVERIFY(queue.tryPop(value));
+    QCOMPARE(value, 7);
+}
+
+void TestTrackManager::testFastRandom() {
+    // Same seed and stream, same sequence
+    FastRandom a(42), b(42), other(42, 1);
+    bool streamsDiffer = false;
+    for (int i = 0; i < 100; ++i) {
+        const quint64 value = a.next();
+        QCOMPARE(b.next(), value);
+        streamsDiffer |= other.next() != value;
+    }
+    QVERIFY(streamsDiffer);
+    
+    a.reseed(7);
+    double sum = 0.0;
+    const int draws = 100000;
+    for (int i = 0; i < draws; ++i) {
+        const double u = a.uniform();
+        QVERIFY(u >= 0.0 && u < 1.0);
+        QVERIFY(a.bounded(10) < 10u);
+        sum += u;
+    }
+    QVERIFY(qAbs(sum / draws - 0.5) < 0.01);
+    
+    QVector<double> batch(1000);
+    a.fillUniform(batch.data(), batch.size(), -2.0, 3.0);
+    for (double v : batch) {
+        QVERIFY(v >= -2.0 && v < 3.0);
+    }
+}
+
+void TestTrackManager::testAsyncLogger() {
+    Logger& logger = Logger::instance();
+    const LogLevel previousLevel = logger.logLevel();
+    logger.setLogToConsole(false);
+    logger.setLogLevel(LogLevel::Info);
+    logger.clearLogs();
+    
+    // Disabled levels never evaluate the message
+    int evaluated = 0;
+    auto message = [&evaluated]() { ++evaluated; return QString("debug"); };
+    CUAS_LOG_DEBUG("Test", message());
+    QCOMPARE(evaluated, 0);
+    
+    std::atomic<int> batches{0};
+    std::atomic<int> delivered{0};
+    QMetaObject::Connection connection = connect(&logger, &Logger::logsAdded, this,
+        [&](const QList<LogEntry>& entries) {
+            batches.fetch_add(1);
+            delivered.fetch_add(entries.size());
+        }, Qt::DirectConnection);
+    
+    logger.setAsync(true);
+    QVERIFY(logger.isAsync());
+    const int threads = 4;
+    const int perThread = 250;
+    QList<QThread*> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.append(QThread::create([t]() {
+            for (int i = 0; i < perThread; ++i) {
+                CUAS_LOG_INFO("Test", QString("producer %1 entry %2").arg(t).arg(i));
+            }
+        }));
+        producers.last()->start();
+    }
+    for (QThread* producer : producers) {
+        QVERIFY(producer->wait(5000));
+        delete producer;
+    }
+    
+    // Turning async off writes everything that was staged
+    logger.setAsync(false);
+    disconnect(connection);
+    const int expected = threads * perThread - static_cast<int>(logger.droppedCount());
+    QVERIFY(delivered.load() >= expected);
+    QVERIFY(batches.load() < delivered.load());
+    
+    const QList<LogEntry> logs = logger.logsByCategory("Test");
+    QCOMPARE(logs.size(), expected);
+    QCOMPARE(logs.first().level, LogLevel::Info);
+    
+    // Back to writing on the calling thread
+    logger.info("Test", "sync");
+    QCOMPARE(logger.recentLogs(1).first().message, QString("sync"));
+    
+    logger.clearLogs();
+    logger.setLogLevel(previousLevel);
+    logger.setLogToConsole(true);
+}
+
+void TestTrackManager::testLogStoreCursor() {
+    LogStore store(5);
+    QList<LogEntry> batch;
+    for (int i = 0; i < 12; ++i) {
+        LogEntry entry;
+        entry.level = static_cast<LogLevel>(i % 3);
+        entry.category = i % 2 ? "Radar" : "Fusion";
+        entry.message = QString::number(i);
+        batch.append(entry);
+    }
+    store.append(batch);
+    QCOMPARE(batch.last().sequence, quint64(12));
+    QCOMPARE(store.size(), 5);
+    
+    // A reader that fell behind the ring is told how much it missed
+    LogPage page = store.readAfter(0, 100);
+    QCOMPARE(page.entries.size(), 5);
+    QCOMPARE(page.entries.first().sequence, quint64(8));
+    QCOMPARE(page.missed, quint64(7));
+    QCOMPARE(page.cursor, quint64(12));
+    
+    // Pages carry on from the cursor
+    page = store.readAfter(9, 2);
+    QCOMPARE(page.entries.size(), 2);
+    QCOMPARE(page.entries.first().sequence, quint64(10));
+    QCOMPARE(page.cursor, quint64(11));
+    page = store.readAfter(page.cursor, 2);
+    QCOMPARE(page.entries.size(), 1);
+    QCOMPARE(store.readAfter(page.cursor, 2).entries.size(), 0);
+    
+    // Indexed reads by category, level and both
+    const int radar = store.findCategory("Radar");
+    QVERIFY(radar >= 0);
+    QCOMPARE(store.findCategory("Video"), -1);
+    page = store.readAfter(0, 100, -1, radar);
+    QCOMPARE(page.entries.size(), 3);
+    for (const LogEntry& entry : page.entries) {
+        QCOMPARE(entry.category, QString("Radar"));
+        QCOMPARE(entry.categoryId, radar);
+    }
+    page = store.readAfter(8, 1, -1, radar);
+    QCOMPARE(page.entries.first().sequence, quint64(10));
+    QCOMPARE(page.cursor, quint64(10));
+    QCOMPARE(store.readAfter(0, 100, static_cast<int>(LogLevel::Info)).entries.size(), 2);
+    page = store.readAfter(0, 100, static_cast<int>(LogLevel::Info), radar);
+    QCOMPARE(page.entries.size(), 1);
+    QCOMPARE(page.cursor, quint64(12));
+    
+    const QList<LogEntry> newest = store.recent(2, -1, radar);
+    QCOMPARE(newest.size(), 2);
+    QCOMPARE(newest.first().sequence, quint64(10));
+    QCOMPARE(newest.last().sequence, quint64(12));
+    
+    // Capacity changes keep the newest; sequences and cursors survive a clear
+    store.setCapacity(3);
+    QCOMPARE(store.readAfter(0, 100).entries.first().sequence, quint64(10));
+    store.clear();
+    QCOMPARE(store.memoryBytes(), qint64(0));
+    page = store.readAfter(5, 10);
+    QVERIFY(page.entries.isEmpty());
+    QCOMPARE(page.cursor, quint64(12));
+    QCOMPARE(store.findCategory("Radar"), radar);
+    
+    // Through the logger: a viewer polls increments of one category
+    Logger& logger = Logger::instance();
+    logger.setLogToConsole(false);
+    const quint64 start = logger.lastLogSequence();
+    logger.warning("CursorTest", "first");
+    logger.info("Other", "skipped");
+    logger.warning("CursorTest", "second");
+    page = logger.logsAfter(start, 1, -1, "CursorTest");
+    QCOMPARE(page.entries.size(), 1);
+    QCOMPARE(page.entries.first().message, QString("first"));
+    page = logger.logsAfter(page.cursor, 10, static_cast<int>(LogLevel::Warning), "CursorTest");
+    QCOMPARE(page.entries.size(), 1);
+    QCOMPARE(page.entries.first().message, QString("second"));
+    QCOMPARE(page.cursor, logger.lastLogSequence());
+    QVERIFY(logger.logsAfter(start, 10, -1, "NeverLogged").entries.isEmpty());
+    logger.setLogToConsole(true);
+}
+
+void TestTrackManager::testDetectionMerger() {
+    DetectionMerger merger(100, 8);
+    
+    auto makeDetection = [](const QString& sensorId, qint64 timestamp) {
+        SensorDetection det;
+        det.sensorId = sensorId;
+        det.timestamp = timestamp;
+        det.sourceType = DetectionSource::Radar;
+        return det;
+    };
+    
+    // A slow camera reports a measurement older than the radar's
+    QVERIFY(merger.push(makeDetection("RADAR-1", 10000)));
+    QVERIFY(merger.push(makeDetection("RADAR-1", 10050)));
+    QVERIFY(merger.push(makeDetection("CAM-1", 10020)));
+    
+    // Nothing is released until it is older than the window
+    QVERIFY(merger.release(10090).isEmpty());
+    QCOMPARE(merger.buffered(), 3);
+    
+    QVector<SensorDetection> out = merger.release(10130);
+    QCOMPARE(out.size(), 2);
+    QCOMPARE(out[0].timestamp, qint64(10000));
+    QCOMPARE(out[1].timestamp, qint64(10020));
+    QCOMPARE(out[1].sensorId, QString("CAM-1"));
+    
+    // Behind the released window: counted late and released next
+    QVERIFY(merger.push(makeDetection("RF-1", 10010)));
+    out = merger.release(10140);
+    QCOMPARE(out.size(), 1);
+    QCOMPARE(out[0].sensorId, QString("RF-1"));
+    
+    // A clock far ahead is ordered by arrival instead of stalling the merge
+    QVERIFY(merger.push(makeDetection("RF-2", 99999999)));
+    out = merger.release(10300, true);
+    QCOMPARE(out.size(), 2);
+    QCOMPARE(out[0].timestamp, qint64(10050));
+    
+    DetectionMerger::Stats stats = merger.stats();
+    QCOMPARE(stats.pushed, quint64(5));
+    QCOMPARE(stats.released, quint64(5));
+    QCOMPARE(stats.reordered, quint64(1));
+    QCOMPARE(stats.late, quint64(1));
+    QCOMPARE(stats.retimed, quint64(1));
+    QCOMPARE(stats.buffered, 0);
+}
+
+void TestTrackManager::testSensorTelemetry() {
+    auto telemetry = std::make_shared<SensorTelemetry>("RADAR-TELEMETRY");
+    SensorTelemetry::registerTelemetry(telemetry);
+    QCOMPARE(SensorTelemetry::find("RADAR-TELEMETRY"), telemetry);
+    
+    telemetry->publish(1000);
+    for (int i = 0; i < 100; ++i) {
+        telemetry->recordRead(512);
+        telemetry->recordMessages();
+        telemetry->recordParseNs(i < 98 ? 3000 : 40000);   // 3 us, two 40 us outliers
+    }
+    telemetry->recordDetections(50);
+    telemetry->recordDropped(2);
+    telemetry->recordDetectionLatencyUs(100);
+    telemetry->recordDetectionLatencyUs(300);
+    telemetry->setQueueDepth(64);
+    
+    // Nothing is visible until the next publish
+    QCOMPARE(telemetry->snapshot()->totalMessages, quint64(0));
+    
+    telemetry->publish(3000);
+    SensorTelemetryPtr snap = telemetry->snapshot();
+    QCOMPARE(snap->totalBytes, quint64(51200));
+    QCOMPARE(snap->totalDropped, quint64(2));
+    QCOMPARE(snap->latest.messagesPerSec, 50.0);    // 100 over two seconds
+    QCOMPARE(snap->latest.detectionsPerSec, 25.0);
+    QCOMPARE(snap->latest.queueDepth, 64);
+    QCOMPARE(snap->latest.parseP50Us, qint64(4));   // [2, 4) us bucket
+    QCOMPARE(snap->latest.parseP99Us, qint64(64));  // [32, 64) us bucket
+    QCOMPARE(snap->latest.latencyMeanUs, 200.0);
+    QCOMPARE(snap->latest.latencyMaxUs, qint64(300));
+    QCOMPARE(snap->history.size(), 2);
+    
+    // A quiet second reports zero rates but keeps the totals
+    telemetry->publish(4000);
+    snap = telemetry->snapshot();
+    QCOMPARE(snap->latest.messagesPerSec, 0.0);
+    QCOMPARE(snap->latest.latencyMaxUs, qint64(0));
+    QCOMPARE(snap->detectionToTrack.maxUs, qint64(300));
+    QCOMPARE(snap->totalMessages, quint64(100));
+    
+    SensorTelemetry::unregisterTelemetry(telemetry.get());
+    QVERIFY(!SensorTelemetry::find("RADAR-TELEMETRY"));
+}
+
+void TestTrackManager::testRadarVideoRing() {
+    // 100 m bins over 1.6 km, from spokes of 50 m cells
+    QVector<quint8> samples(32, 0);
+    samples[5] = 200;
+    samples[10] = 90;
+    RadarSpoke spoke;
+    spoke.sequence = 7;
+    spoke.azimuthDeg = 67.5;
+    spoke.rangeCellM = 50.0;
+    spoke.timestampMs = 123456;
+    spoke.samples = samples.constData();
+    spoke.sampleCount = samples.size();
+    
+    // Two spokes in one datagram decode back in order
+    QByteArray datagram;
+    RadarSpokeCodec::encode(spoke, datagram);
+    spoke.sequence = 8;
+    RadarSpokeCodec::encode(spoke, datagram);
+    QCOMPARE(datagram.size(), 2 * (RadarSpokeCodec::HEADER_SIZE + 32));
+    RadarSpoke decoded;
+    const int consumed = RadarSpokeCodec::decode(datagram.constData(), datagram.size(), decoded);
+    QCOMPARE(consumed, RadarSpokeCodec::HEADER_SIZE + 32);
+    QCOMPARE(decoded.sequence, quint32(7));
+    QCOMPARE(decoded.azimuthDeg, 67.5);
+    QCOMPARE(decoded.rangeCellM, 50.0);
+    QCOMPARE(decoded.timestampMs, qint64(123456));
+    QCOMPARE(decoded.samples[5], quint8(200));
+    QCOMPARE(RadarSpokeCodec::decode(datagram.constData() + consumed, consumed, decoded), consumed);
+    QCOMPARE(decoded.sequence, quint32(8));
+    QCOMPARE(RadarSpokeCodec::decode(datagram.constData(), RadarSpokeCodec::HEADER_SIZE + 31, decoded), 0);
+    
+    // A reader from generation 0 gets the whole blank picture
+    RadarVideoRing ring(16, 16, 1600.0);
+    RadarVideoRing::Update update;
+    QVERIFY(ring.changesSince(0, update));
+    QCOMPARE(update.rows.size(), 16);
+    const quint64 blank = update.generation;
+    QVERIFY(!ring.changesSince(blank, update));
+    
+    spoke.azimuthDeg = 0.0;
+    ring.write(spoke, 1000);
+    QVERIFY(ring.changesSince(blank, update));
+    QCOMPARE(update.rows, QVector<int>{0});
+    QCOMPARE(update.rowTimeMs, QVector<qint64>{1000});
+    // Each bin keeps the peak of the two samples it covers
+    QCOMPARE(quint8(update.samples[2]), quint8(200));
+    QCOMPARE(quint8(update.samples[5]), quint8(90));
+    QCOMPARE(quint8(update.samples[3]), quint8(0));
+    
+    // Three rows on, the two the antenna passed are filled
+    const quint64 first = update.generation;
+    spoke.azimuthDeg = 67.5;
+    ring.write(spoke, 1100);
+    QVERIFY(ring.changesSince(first, update));
+    QCOMPARE(update.rows, (QVector<int>{1, 2, 3}));
+    QCOMPARE(update.samples.size(), 3 * 16);
+    QCOMPARE(ring.lastAzimuthDeg(), 67.5);
+    QCOMPARE(ring.lastWriteMs(), qint64(1100));
+    QCOMPARE(ring.spokesWritten(), quint64(2));
+    
+    // The source counts the spoke missing between sequences 9 and 11, and
+    // the trailing bytes that are no spoke
+    RadarVideoSource source;
+    QByteArray stream;
+    spoke.sequence = 9;
+    RadarSpokeCodec::encode(spoke, stream);
+    spoke.sequence = 11;
+    RadarSpokeCodec::encode(spoke, stream);
+    stream.append("xyz");
+    source.ingest(stream.constData(), stream.size());
+    const RadarVideoSource::Statistics stats = source.statistics();
+    QCOMPARE(stats.datagrams, quint64(1));
+    QCOMPARE(stats.spokes, quint64(2));
+    QCOMPARE(stats.spokesLost, quint64(1));
+    QCOMPARE(stats.malformed, quint64(1));
+    QCOMPARE(source.ring()->spokesWritten(), quint64(2));
+}
+
+void TestTrackManager::testFramePool() {
+    FramePool pool(2);
+    const QSize size(64, 48);
+    
+    const uchar* firstBits = nullptr;
+    {
+        QImage frame = pool.acquire(size, QImage::Format_RGB888);
+        QCOMPARE(frame.size(), size);
+        QCOMPARE(frame.format(), QImage::Format_RGB888);
+        frame.fill(Qt::red);
+        firstBits = frame.constBits();
+        
+        // Consumers share the pixels rather than copying them
+        QImage shared = frame;
+        QCOMPARE(shared.constBits(), firstBits);
+        QCOMPARE(pool.stats().outstanding, 1);
+    }
+    FramePool::Stats stats = pool.stats();
+    QCOMPARE(stats.outstanding, 0);
+    QCOMPARE(stats.idle, 1);
+    
+    // The released buffer serves the next frame of the same shape
+    QImage reused = pool.acquire(size, QImage::Format_RGB888);
+    QCOMPARE(reused.constBits(), firstBits);
+    QCOMPARE(pool.stats().reused, quint64(1));
+    QCOMPARE(pool.stats().allocated, quint64(1));
+    
+    // A copy lands in a pooled frame with the source's rows
+    QImage source(size, QImage::Format_RGB32);
+    source.fill(QColor(10, 20, 30));
+    QImage copied = pool.acquireCopy(source.constBits(), source.width(), source.height(),
+                                     source.bytesPerLine(), source.format());
+    QCOMPARE(copied.pixel(63, 47), source.pixel(63, 47));
+    QVERIFY(copied.constBits() != source.constBits());
+    
+    // A new shape retires the old one's buffers as they come back
+    reused = QImage();
+    QCOMPARE(pool.stats().idle, 0);
+    
+    QVERIFY(pool.acquire(QSize(), QImage::Format_RGB888).isNull());
+    
+    // Frames may outlive their pool
+    QImage survivor;
+    {
+        FramePool shortLived;
+        survivor = shortLived.acquire(size, QImage::Format_RGB888);
+        survivor.fill(Qt::blue);
+    }
+    QCOMPARE(survivor.pixelColor(0, 0), QColor(Qt::blue));
+}
+
+void TestTrackManager::testVideoFrame() {
+    // RGB frames wrap the image without copying it
+    QImage rgb(32, 16, QImage::Format_RGB888);
+    rgb.fill(QColor(200, 100, 50));
+    VideoFrame wrapped(rgb);
+    QCOMPARE(wrapped.pixelFormat(), VideoPixelFormat::RGB24);
+    QCOMPARE(wrapped.planeCount(), 1);
+    QCOMPARE(wrapped.constBits(0), rgb.constBits());
+    QCOMPARE(wrapped.toImage().constBits(), rgb.constBits());
+    
+    // I420 with odd dimensions and padded source strides
+    const QSize size(5, 3);
+    const int yStride = 8;
+    const int cStride = 4;
+    QByteArray y(yStride * 3, char(235));       // Video-range white...
+    QByteArray u(cStride * 2, char(128));
+    QByteArray v(cStride * 2, char(128));
+    y[0] = char(16);                            // ...with a black top-left pixel
+    const uchar* planes[3] = {reinterpret_cast<const uchar*>(y.constData()),
+                              reinterpret_cast<const uchar*>(u.constData()),
+                              reinterpret_cast<const uchar*>(v.constData())};
+    const int strides[3] = {yStride, cStride, cStride};
+    
+    FramePool pool;
+    VideoFrame i420 = VideoFrame::fromPlanes(VideoPixelFormat::YUV420P, size, planes, strides, &pool);
+    QVERIFY(i420.isYuv());
+    QCOMPARE(i420.planeCount(), 3);
+    QCOMPARE(i420.planeSize(1), QSize(3, 2));
+    QCOMPARE(int(i420.constBits(0)[0]), 16);
+    QCOMPARE(int(i420.constBits(0)[i420.bytesPerLine(0) * 2 + 4]), 235);
+    QCOMPARE(int(i420.constBits(2)[i420.bytesPerLine(2) + 2]), 128);
+    QCOMPARE(pool.stats().outstanding, 1);
+    
+    QImage converted = i420.toImage();
+    QCOMPARE(converted.size(), size);
+    QCOMPARE(converted.pixel(0, 0), qRgb(0, 0, 0));
+    QCOMPARE(converted.pixel(4, 2), qRgb(255, 255, 255));
+    
+    // NV12: a saturated red from interleaved chroma
+    QByteArray luma(4 * 2, char(81));
+    QByteArray uv(4, char(0));
+    uv[0] = char(90);
+    uv[1] = char(240);
+    uv[2] = char(90);
+    uv[3] = char(240);
+    const uchar* nvPlanes[2] = {reinterpret_cast<const uchar*>(luma.constData()),
+                                reinterpret_cast<const uchar*>(uv.constData())};
+    const int nvStrides[2] = {4, 4};
+    VideoFrame nv12 = VideoFrame::fromPlanes(VideoPixelFormat::NV12, QSize(4, 2), nvPlanes, nvStrides);
+    QCOMPARE(nv12.planeCount(), 2);
+    const QColor red = nv12.toImage().pixelColor(3, 1);
+    QVERIFY(red.red() > 250 && red.green() < 5 && red.blue() < 5);
+    
+    // Frames queue in their native format
+    FrameBuffer buffer(2);
+    buffer.push(i420, 1);
+    buffer.push(rgb, 2);
+    BufferedFrame first = buffer.pop();
+    QCOMPARE(first.frame.pixelFormat(), VideoPixelFormat::YUV420P);
+    QCOMPARE(first.frame.constBits(0), i420.constBits(0));
+    QCOMPARE(buffer.pop().frame.pixelFormat(), VideoPixelFormat::RGB24);
+}
+
+void TestTrackManager::testFrameRing() {
+    QImage image(8, 8, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    const VideoFrame frame(image);
+    BufferedFrame out;
+    
+    // FIFO keeps everything it accepts and refuses the rest
+    FrameRing fifo(4, FrameRingPolicy::Fifo);
+    QCOMPARE(fifo.capacity(), 4);
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(fifo.push(frame, i));
+    }
+    QVERIFY(!fifo.push(frame, 4));
+    QCOMPARE(fifo.stats().rejected, quint64(1));
+    QVERIFY(fifo.tryPop(out));
+    QCOMPARE(out.timestamp, qint64(0));
+    QCOMPARE(out.frame.constBits(0), frame.constBits(0));
+    
+    // Drop-oldest always takes the frame, keeping the newest
+    FrameRing dropOldest(4, FrameRingPolicy::DropOldest);
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(dropOldest.push(frame, i));
+    }
+    QCOMPARE(dropOldest.stats().dropped, quint64(6));
+    QVERIFY(dropOldest.tryPop(out));
+    QCOMPARE(out.timestamp, qint64(6));
+    QCOMPARE(out.frameNumber, 6);
+    
+    // Latest-only hands over the newest frame and nothing older
+    FrameRing latest(4, FrameRingPolicy::LatestOnly);
+    QCOMPARE(latest.capacity(), 1);
+    QVERIFY(!latest.tryPop(out));
+    for (int i = 0; i < 5; ++i) {
+        latest.push(frame, i);
+    }
+    QVERIFY(latest.tryPop(out));
+    QCOMPARE(out.timestamp, qint64(4));
+    QVERIFY(!latest.tryPop(out));
+    QCOMPARE(latest.stats().dropped, quint64(4));
+    
+    // A worker consumer sleeps in waitPop() and sees every frame in order
+    const int frames = 20000;
+    FrameRing ring(8, FrameRingPolicy::Fifo);
+    std::atomic<int> received{0};
+    std::atomic<bool> ordered{true};
+    QThread* consumer = QThread::create([&]() {
+        BufferedFrame item;
+        int expected = 0;
+        while (expected < frames) {
+            if (!ring.waitPop(item, 1000)) continue;
+            if (item.timestamp != expected) ordered = false;
+            ++expected;
+            ++received;
+        }
+    });
+    consumer->start();
+    for (int i = 0; i < frames; ++i) {
+        while (!ring.push(frame, i)) {
+            QThread::yieldCurrentThread();
+        }
+    }
+    QVERIFY(consumer->wait(10000));
+    delete consumer;
+    QCOMPARE(received.load(), frames);
+    QVERIFY(ordered.load());
+    
+    // wakeConsumer() releases a consumer waiting on an empty ring
+    FrameRing idle(2);
+    QThread* waiter = QThread::create([&]() { idle.waitPop(out); });
+    waiter->start();
+    QTest::qWait(20);
+    idle.wakeConsumer();
+    QVERIFY(waiter->wait(5000));
+    delete waiter;
+}
+
+void TestTrackManager::testThreadedFusion() {
+    // Unparented so the engine can move it to the fusion thread
+    TrackManager* manager = new TrackManager;
+    FusionEngine engine(manager);
+    FusionEngineConfig config;
+    config.threaded = true;
+    config.queueCapacity = 16;
+    engine.setConfig(config);
+    engine.start();
+    QVERIFY(engine.isThreaded());
+    QVERIFY(manager->thread() != QThread::currentThread());
+    
+    // Lifecycle calls are marshalled to the fusion thread
+    manager->start();
+    QVERIFY(manager->isRunning());
+    
+    QVector<SensorDetection> scan;
+    for (int i = 0; i < 3; ++i) {
+        SensorDetection det;
+        det.sensorId = "RADAR-TEST";
+        det.sourceType = DetectionSource::Radar;
+        det.position = GeoPosition{34.0 + i * 0.05, -118.0, 100.0};
+        det.confidence = 0.9;
+        det.timestamp = QDateTime::currentMSecsSinceEpoch();
+        det.ingestMonoNs = TimeUtils::monotonicNs();
+        scan.append(det);
+    }
+    QVERIFY(engine.submitBatch(scan));
+    QTRY_COMPARE(manager->trackCount(), 3);
+    
+    // The GUI side reads the published picture once a cycle has run
+    QTRY_COMPARE(manager->snapshot()->tracks.size(), 3);
+    
+    FusionEngine::Statistics stats = engine.statistics();
+    QCOMPARE(stats.scansEnqueued, quint64(1));
+    QCOMPARE(stats.scansProcessed, quint64(1));
+    QCOMPARE(stats.scansDropped, quint64(0));
+    QCOMPARE(stats.queueLatency.count, quint64(1));
+    QCOMPARE(stats.ingestToUpdate.count, quint64(3));
+    QVERIFY(stats.ingestToUpdate.maxUs >= stats.ingestToUpdate.lastUs);
+    
+    manager->stop();
+    engine.stop();
+    QCOMPARE(manager->thread(), QThread::currentThread());
+    QVERIFY(!manager->isRunning());
+    delete manager;
+}
+
+void TestTrackManager::testShardedTrackManager() {
+    ShardedTrackManagerConfig config;
+    config.shardCount = 2;
+    config.tileSizeM = 1000.0;
+    config.handoffMarginM = 100.0;
+    config.handoffIntervalMs = 60000;  // Swept by hand below
+    config.origin = GeoPosition{34.0, -118.0, 0.0};
+    config.tracks.enableKalmanFilter = false;
+    ShardedTrackManager sharded;
+    sharded.setConfig(config);
+    QCOMPARE(sharded.shardCount(), 2);
+    
+    // Centres of two tiles owned by different shards
+    const LocalTangentPlane grid(config.origin);
+    auto tileCentre = [&](int tx) {
+        GeoPosition pos = grid.toGeoLinear(EnuVector{tx * 1000.0 + 500.0, 500.0, 0.0});
+        pos.altitude = 100.0;
+        return pos;
+    };
+    const GeoPosition home = tileCentre(0);
+    GeoPosition away = tileCentre(1);
+    for (int tx = 2; sharded.tileOwner(away) == sharded.tileOwner(home); ++tx) {
+        away = tileCentre(tx);
+    }
+    const int homeShard = sharded.tileOwner(home);
+    const int awayShard = sharded.tileOwner(away);
+    
+    sharded.start();
+    auto plot = [](const GeoPosition& pos) {
+        SensorDetection det;
+        det.sensorId = "RADAR-TEST";
+        det.sourceType = DetectionSource::Radar;
+        det.position = pos;
+        det.confidence = 0.9;
+        det.timestamp = QDateTime::currentMSecsSinceEpoch();
+        return det;
+    };
+    QVERIFY(sharded.submitBatch({plot(home), plot(away)}));
+    QTRY_COMPARE(sharded.snapshot()->tracks.size(), 2);
+    QCOMPARE(sharded.shard(homeShard)->trackCount(), 1);
+    QCOMPARE(sharded.shard(awayShard)->trackCount(), 1);
+    
+    // Handles are unique across shards
+    TrackPicturePtr picture = sharded.snapshot();
+    QVERIFY(picture->tracks[0].handle != picture->tracks[1].handle);
+    QVERIFY(picture->find(picture->tracks[0].trackId));
+    
+    // A plot near a track is routed to the track's shard, not by its tile
+    const QString mover = sharded.shard(homeShard)->allTracks().first()->trackId();
+    QVERIFY(sharded.submit(plot(home)));
+    QCOMPARE(sharded.statistics().detectionsToTrackShard, quint64(1));
+    QCOMPARE(sharded.statistics().detectionsRouted, quint64(3));
+    
+    // Deep inside the other shard's tile the track is handed off, keeping its ID
+    sharded.shard(homeShard)->updateTrack(mover, away);
+    QTRY_VERIFY(CoordinateUtils::haversineDistance(sharded.snapshot()->find(mover)->position, away) < 1.0);
+    QCOMPARE(sharded.rebalance(), 1);
+    QCOMPARE(sharded.shard(homeShard)->trackCount(), 0);
+    QCOMPARE(sharded.shard(awayShard)->trackCount(), 2);
+    QVERIFY(sharded.shard(awayShard)->track(mover));
+    QTRY_COMPARE(sharded.snapshot()->tracks.size(), 2);
+    QVERIFY(sharded.snapshot()->find(mover));
+    QCOMPARE(sharded.rebalance(), 0);
+    QCOMPARE(sharded.statistics().handoffs, quint64(1));
+    
+    // One target first seen either side of an edge between two shards'
+    // tiles: the sweep brings the copies onto one shard for its merge pass
+    int edge = 10;
+    while (sharded.tileOwner(tileCentre(edge)) == sharded.tileOwner(tileCentre(edge + 1))) ++edge;
+    auto nearEdge = [&](double offsetM) {
+        GeoPosition pos = grid.toGeoLinear(EnuVector{(edge + 1) * 1000.0 + offsetM, 500.0, 0.0});
+        pos.altitude = 100.0;
+        return pos;
+    };
+    QVERIFY(sharded.submitBatch({plot(nearEdge(-20.0)), plot(nearEdge(20.0))}));
+    QTRY_COMPARE(sharded.snapshot()->tracks.size(), 4);
+    QCOMPARE(sharded.rebalance(), 1);
+    QCOMPARE(sharded.statistics().duplicatesGathered, quint64(1));
+    QCOMPARE(sharded.statistics().handoffs, quint64(1));
+    QTRY_COMPARE(sharded.snapshot()->tracks.size(), 4);
+    picture = sharded.snapshot();
+    QVector<int> shards;
+    for (const TrackSnapshot& t : picture->tracks) {
+        if (CoordinateUtils::haversineDistance(t.position, nearEdge(0.0)) > 50.0) continue;
+        for (int i = 0; i < sharded.shardCount(); ++i) {
+            if (sharded.shard(i)->track(t.trackId)) shards.append(i);
+        }
+    }
+    QCOMPARE(shards.size(), 2);
+    QCOMPARE(shards[0], shards[1]);
+    QCOMPARE(sharded.rebalance(), 0);
+    
+    sharded.stop();
+    QVERIFY(!sharded.isRunning());
+}
+
+void TestTrackManager::testRegionalFusion() {
+    m_manager->clearAllTracks();
+    const GeoPosition target{34.0522, -118.2437, 120.0};
+    auto report = [&](const QString& site, double eastM, TrackClassification cls, double confidence, int threat) {
+        TrackSnapshot track;
+        track.trackId = "TRK-0001";
+        track.position = target;
+        track.position.longitude += eastM / (111320.0 * std::cos(qDegreesToRadians(target.latitude)));
+        track.velocity.east = 12.0;
+        track.classification = cls;
+        track.classificationConfidence = confidence;
+        track.threatLevel = threat;
+        track.trackQuality = 0.7;
+        
+        SensorDetection plot;
+        plot.sensorId = "site:" + site;
+        plot.sourceType = DetectionSource::Combined;
+        plot.position = track.position;
+        plot.velocity = track.velocity;
+        plot.confidence = track.trackQuality;
+        plot.timestamp = QDateTime::currentMSecsSinceEpoch();
+        setFixedString(plot.info.combined.trackId, track.trackId);
+        plot.info.combined.classification = static_cast<qint8>(track.classification);
+        plot.info.combined.threatLevel = static_cast<quint8>(track.threatLevel);
+        plot.info.combined.classificationConfidence = static_cast<float>(track.classificationConfidence);
+        return plot;
+    };
+    
+    // Two sites report one drone: one track, with the firmer classification
+    m_manager->processDetectionBatch({report("SITE-1", 0.0, TrackClassification::Hostile, 0.6, 3)});
+    m_manager->processDetectionBatch({report("SITE-2", 15.0, TrackClassification::Unknown, 0.2, 4)});
+    QCOMPARE(m_manager->trackCount(), 1);
+    Track* track = m_manager->tracksInRadius(target, 100.0).first();
+    QVERIFY(track->hasSource(DetectionSource::Combined));
+    QCOMPARE(track->classification(), TrackClassification::Hostile);
+    QVERIFY(qAbs(track->classificationConfidence() - 0.6) < 1e-6);
+    QVERIFY(qAbs(track->velocity().east - 12.0) < 1e-9);
+    
+    // The less firm site can raise the threat; only a firm one lowers it
+    QCOMPARE(track->threatLevel(), 4);
+    m_manager->processDetectionBatch({report("SITE-1", 0.0, TrackClassification::Hostile, 0.6, 3)});
+    QCOMPARE(track->threatLevel(), 3);
+    
+    // An operator's classification stands
+    track->setClassification(TrackClassification::Friendly);
+    track->setClassificationConfidence(1.0);
+    m_manager->processDetectionBatch({report("SITE-1", 0.0, TrackClassification::Hostile, 0.9, 3)});
+    QCOMPARE(track->classification(), TrackClassification::Friendly);
+    m_manager->clearAllTracks();
+}
+
+void TestTrackManager::testLabelDeclutter() {
+    LabelDeclutter declutter;
+    auto request = [](quint64 key, const QPointF& anchor, bool pinned = false) {
+        LabelRequest r;
+        r.key = key;
+        r.anchor = anchor;
+        r.size = QSizeF(60, 12);
+        r.offset = QPointF(15, -6);
+        r.pinned = pinned;
+        return r;
+    };
+    
+    // A lone label takes its preferred spot
+    QVector<LabelRequest> requests{request(1, QPointF(100, 100))};
+    declutter.update(requests);
+    QCOMPARE(declutter.placement(1).rect, QRectF(115, 94, 60, 12));
+    QVERIFY(!declutter.placement(1).leader);
+    
+    // A neighbour's label goes elsewhere
+    requests.append(request(2, QPointF(100, 110)));
+    declutter.update(requests);
+    QVERIFY(declutter.placement(2).isVisible());
+    QVERIFY(!declutter.placement(1).rect.intersects(declutter.placement(2).rect));
+    
+    // Under the move threshold nothing is searched; over it the label is
+    requests[0].anchor = QPointF(101, 100);
+    declutter.update(requests);
+    QCOMPARE(declutter.searchedLastUpdate(), 0);
+    QCOMPARE(declutter.placement(1).rect.topLeft(), QPointF(116, 94));
+    requests[0].anchor = QPointF(110, 100);
+    declutter.update(requests);
+    QCOMPARE(declutter.searchedLastUpdate(), 1);
+    
+    // A crowded field: placed labels never overlap, the rest are counted
+    requests.clear();
+    for (int i = 0; i < 40; ++i) {
+        requests.append(request(100 + i, QPointF(50 + (i % 8) * 40, 50 + (i / 8) * 30)));
+    }
+    declutter.update(requests);
+    int visible = 0;
+    for (const LabelRequest& a : requests) {
+        const LabelPlacement pa = declutter.placement(a.key);
+        if (!pa.isVisible()) continue;
+        ++visible;
+        for (const LabelRequest& b : requests) {
+            if (b.key > a.key) QVERIFY(!pa.rect.intersects(declutter.placement(b.key).rect));
+        }
+    }
+    int collapsed = 0;
+    for (const LabelCluster& cluster : declutter.clusters()) collapsed += cluster.count;
+    QCOMPARE(visible + collapsed, 40);
+    QVERIFY(!declutter.placement(1).isVisible());   // Forgotten
+    
+    // A swarm in one cell collapses into a count, except the pinned label
+    requests.clear();
+    for (int i = 0; i < 10; ++i) {
+        requests.append(request(200 + i, QPointF(10 + i * 3, 10 + i * 3), i == 0));
+    }
+    declutter.update(requests);
+    QCOMPARE(declutter.clusters().size(), 1);
+    QCOMPARE(declutter.clusters().first().count, 9);
+    QCOMPARE(declutter.clusters().first().bounds, QRectF(QPointF(13, 13), QPointF(37, 37)));
+    QVERIFY(declutter.placement(200).isVisible());
+    
+    // Leader lines stop clear of the symbol
+    const QLineF leader = LabelDeclutter::leaderLine(QPointF(0, 0), QRectF(50, -5, 40, 10), 12);
+    QCOMPARE(leader.p1(), QPointF(12, 0));
+    QCOMPARE(leader.p2(), QPointF(50, 0));
+    QVERIFY(LabelDeclutter::leaderLine(QPointF(0, 0), QRectF(5, -5, 40, 10), 12).isNull());
+}
+
+void TestTrackManager::testScreenPickIndex() {
+    ScreenPickIndex index(32.0);
+    quint64 key = 0;
+    QVERIFY(!index.nearest(QPointF(10, 10), 15.0, &key));   // Never built
+    
+    index.clear(QRectF(0, 0, 200, 200));
+    index.insert(1, QPointF(50, 50));
+    index.insert(2, QPointF(60, 50));
+    index.insert(3, QPointF(150, 150));
+    index.insert(4, QPointF(210, 100));     // Off the view, kept in the edge cells
+    index.insert(5, QPointF(55, 50));       // On top of 1 and 2's midpoint
+    index.build();
+    QCOMPARE(index.size(), 5);
+    
+    QVERIFY(index.nearest(QPointF(52, 51), 15.0, &key));
+    QCOMPARE(key, quint64(1));
+    QVERIFY(index.nearest(QPointF(55, 50), 15.0, &key));
+    QCOMPARE(key, quint64(5));
+    // Across a cell boundary
+    QVERIFY(index.nearest(QPointF(140, 140), 15.0, &key));
+    QCOMPARE(key, quint64(3));
+    QVERIFY(index.nearest(QPointF(198, 100), 15.0, &key));
+    QCOMPARE(key, quint64(4));
+    QVERIFY(!index.nearest(QPointF(100, 100), 15.0, &key));
+    
+    // Equidistant points go to the one inserted first
+    index.clear(QRectF(0, 0, 200, 200));
+    index.insert(7, QPointF(40, 40));
+    index.insert(6, QPointF(20, 40));
+    index.build();
+    QVERIFY(index.nearest(QPointF(30, 40), 15.0, &key));
+    QCOMPARE(key, quint64(7));
+    
+    index.clear(QRectF(0, 0, 200, 200));
+    for (int i = 0; i < 10; ++i) {
+        index.insert(quint64(i), QPointF(10 + i * 20, 10 + i * 20));   // The diagonal
+    }
+    index.build();
+    
+    // Insertion order, whatever cells they came from
+    QVector<quint64> keys;
+    index.inRect(QRectF(QPointF(100, 100), QPointF(25, 25)), keys);
+    QCOMPARE(keys, (QVector<quint64>{1, 2, 3, 4}));
+    
+    // A lasso above the diagonal takes none of it, one across it some
+    keys.clear();
+    index.inPolygon(QPolygonF{QPointF(0, 0), QPointF(200, 0), QPointF(200, 180)}, keys);
+    QVERIFY(keys.isEmpty());
+    index.inPolygon(QPolygonF{QPointF(0, 80), QPointF(100, 0), QPointF(200, 200)}, keys);
+    QCOMPARE(keys, (QVector<quint64>{2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+void TestTrackManager::testWeaponTargetAssignment() {
+    const GeoPosition base{51.0, 0.0, 50.0};
+    auto threatAt = [&base](const QString& id, double rangeM, TrackClassification classification,
+                            int threatLevel) {
+        AssignmentThreat threat;
+        threat.trackId = id;
+        threat.position = CoordinateUtils::positionFromBearingDistance(base, 90.0, rangeM);
+        threat.classification = classification;
+        threat.threatLevel = threatLevel;
+        return threat;
+    };
+    auto effectorAt = [&base](const QString& id, const QString& type, double maxRange,
+                              double effectiveness) {
+        AssignmentEffector effector;
+        effector.effectorId = id;
+        effector.effectorType = type;
+        effector.position = base;
+        effector.maxRange = maxRange;
+        effector.effectiveness = effectiveness;
+        return effector;
+    };
+
+    WeaponTargetAssigner assigner;
+    assigner.updateEffector(effectorAt("KIN", "KINETIC", 5000.0, 0.9));
+    assigner.updateEffector(effectorAt("JAM", "RF_JAMMER", 1000.0, 0.7));
+
+    // Greedy would give the near track the interceptor and leave the far one
+    // unengaged; the optimum splits them
+    assigner.updateThreat(threatAt("T1", 800.0, TrackClassification::Hostile, 4));
+    assigner.updateThreat(threatAt("T2", 3000.0, TrackClassification::Hostile, 4));
+    QVector<WeaponAssignment> plan = assigner.solve();
+    QCOMPARE(plan.size(), 2);
+    QCOMPARE(plan[0].trackId, QString("T2"));
+    QCOMPARE(plan[0].effectorId, QString("KIN"));
+    QCOMPARE(plan[1].trackId, QString("T1"));
+    QCOMPARE(plan[1].effectorId, QString("JAM"));
+    QVERIFY(qAbs(plan[0].score - 4 * 0.9 * 0.9) < 0.01);
+
+    // ROE: never friendlies, unconfirmed tracks only with non-kinetic effectors
+    assigner.updateThreat(threatAt("T3", 500.0, TrackClassification::Pending, 5));
+    assigner.updateThreat(threatAt("T4", 500.0, TrackClassification::Friendly, 5));
+    assigner.updateThreat(threatAt("T5", 500.0, TrackClassification::Hostile, 2));
+    QCOMPARE(assigner.score("T3", "KIN"), 0.0);
+    QVERIFY(assigner.score("T3", "JAM") > 0.0);
+    QCOMPARE(assigner.score("T4", "JAM"), 0.0);
+    QCOMPARE(assigner.score("T5", "KIN"), 0.0);
+    plan = assigner.solve();
+    QCOMPARE(plan.size(), 2);
+    QCOMPARE(plan[0].trackId, QString("T3"));
+    QCOMPARE(plan[0].effectorId, QString("JAM"));
+
+    // Out of range and closing: waits for the envelope, scored by the wait
+    AssignmentThreat inbound = threatAt("T6", 7000.0, TrackClassification::Hostile, 4);
+    assigner.updateThreat(inbound);
+    QCOMPARE(assigner.score("T6", "KIN"), 0.0);
+    inbound.velocity.east = -50.0;
+    assigner.updateThreat(inbound);
+    plan = assigner.solve();
+    QCOMPARE(assigner.stats().lastRowsRescored, 1);
+    QVERIFY(assigner.score("T6", "KIN") > 0.0);
+    QVERIFY(assigner.score("T6", "KIN") < assigner.score("T2", "KIN"));
+
+    // A committed pairing holds its effector out of the solve
+    assigner.commit("T3", "JAM");
+    plan = assigner.solve();
+    QVERIFY(plan[0].committed);
+    QCOMPARE(plan[0].trackId, QString("T3"));
+    for (int i = 1; i < plan.size(); ++i) {
+        QVERIFY(plan[i].effectorId != "JAM");
+        QVERIFY(plan[i].trackId != "T3");
+    }
+    assigner.release("T3");
+    assigner.removeThreat("T3");
+    QCOMPARE(assigner.threatCount(), 5);
+    plan = assigner.solve();
+    QCOMPARE(plan.size(), 2);
+    QCOMPARE(plan[1].trackId, QString("T1"));
+
+    // Swarm: 200 threats x 20 effectors, every effector busy, never worse than greedy
+    assigner.clear();
+    FastRandom random(66);
+    for (int e = 0; e < 20; ++e) {
+        AssignmentEffector effector = effectorAt(QString("E%1").arg(e), "KINETIC",
+                                                 random.uniform(1500.0, 5000.0),
+                                                 random.uniform(0.5, 0.95));
+        effector.position = CoordinateUtils::positionFromBearingDistance(base, e * 18.0, 500.0);
+        assigner.updateEffector(effector);
+    }
+    for (int t = 0; t < 200; ++t) {
+        AssignmentThreat threat;
+        threat.trackId = QString("S%1").arg(t, 3, 10, QChar('0'));
+        threat.position = CoordinateUtils::positionFromBearingDistance(base, random.uniform(0.0, 360.0),
+                                                                      random.uniform(200.0, 4000.0));
+        threat.classification = TrackClassification::Hostile;
+        threat.threatLevel = 3 + static_cast<int>(random.bounded(3));
+        threat.timeToImpactSec = random.uniform(5.0, 120.0);
+        assigner.updateThreat(threat);
+    }
+    plan = assigner.solve();
+    QCOMPARE(plan.size(), 20);
+    QVERIFY(assigner.stats().lastSolveMs < 100.0);
+
+    double total = 0.0;
+    QSet<QString> tracksUsed;
+    for (const WeaponAssignment& a : plan) {
+        total += a.score;
+        QVERIFY(!tracksUsed.contains(a.trackId));
+        tracksUsed.insert(a.trackId);
+    }
+    double greedy = 0.0;
+    QSet<QString> greedyUsed;
+    for (int e = 0; e < 20; ++e) {
+        double best = 0.0;
+        QString bestTrack;
+        for (int t = 0; t < 200; ++t) {
+            const QString trackId = QString("S%1").arg(t, 3, 10, QChar('0'));
+            if (greedyUsed.contains(trackId)) continue;
+            const double s = assigner.score(trackId, QString("E%1").arg(e));
+            if (s > best) {
+                best = s;
+                bestTrack = trackId;
+            }
+        }
+        greedy += best;
+        greedyUsed.insert(bestTrack);
+    }
+    QVERIFY(total >= greedy - 1e-9);
+}
+
+void TestTrackManager::testTimerWheel() {
+    TimerWheel wheel(100, 8);
+    QVector<quint64> expired;
+
+    // Fires in due order, not scheduling order, and only once due
+    const TimerWheel::TimerId late = wheel.schedule(1250, 3);
+    wheel.schedule(1030, 1);
+    const TimerWheel::TimerId cancelled = wheel.schedule(1100, 2);
+    QVERIFY(late != 0);
+    QCOMPARE(wheel.pendingCount(), 3);
+    QCOMPARE(wheel.advance(1000, expired), 0);
+    QVERIFY(wheel.cancel(cancelled));
+    QVERIFY(!wheel.isPending(cancelled));
+    QCOMPARE(wheel.advance(1200, expired), 1);
+    QCOMPARE(expired, QVector<quint64>({1}));
+    QCOMPARE(wheel.advance(1249, expired), 0);
+    QCOMPARE(wheel.advance(1250, expired), 1);
+    QCOMPARE(expired.last(), quint64(3));
+    QCOMPARE(wheel.pendingCount(), 0);
+
+    // Due earlier in the tick already walked: the next advance
+    expired.clear();
+    wheel.schedule(1210, 4);
+    QCOMPARE(wheel.advance(1260, expired), 1);
+
+    // More than one revolution out: stays put until due
+    expired.clear();
+    wheel.schedule(1260 + 3000, 5);
+    wheel.schedule(1260 + 300, 6);
+    QCOMPARE(wheel.advance(1260 + 900, expired), 1);
+    QCOMPARE(expired, QVector<quint64>({6}));
+    QCOMPARE(wheel.advance(1260 + 2999, expired), 0);
+    QCOMPARE(wheel.advance(1260 + 3000, expired), 1);
+    QCOMPARE(expired.last(), quint64(5));
+
+    // A jump past several revolutions fires everything due, in order
+    expired.clear();
+    for (int i = 0; i < 100; ++i) {
+        wheel.schedule(5000 + (i * 37) % 2000, i);
+    }
+    QCOMPARE(wheel.advance(20000, expired), 100);
+    for (int i = 1; i < expired.size(); ++i) {
+        QVERIFY((expired[i - 1] * 37) % 2000 <= (expired[i] * 37) % 2000);
+    }
+    QCOMPARE(wheel.pendingCount(), 0);
+
+    // Next deadline for sleeping on: exact within a revolution, cancelled ones skipped
+    QCOMPARE(wheel.nextDueMs(), qint64(-1));
+    const TimerWheel::TimerId soon = wheel.schedule(20130, 7);
+    wheel.schedule(20450, 8);
+    QCOMPARE(wheel.nextDueMs(), qint64(20130));
+    wheel.cancel(soon);
+    QCOMPARE(wheel.nextDueMs(), qint64(20450));
+    wheel.clear();
+    wheel.schedule(20000 + 5000, 9);
+    QVERIFY(wheel.nextDueMs() > 20000 && wheel.nextDueMs() <= 25000);
+}
+
+void TestTrackManager::testTimerService() {
+    TimerService service(5, 64);
+    QObject context;
+    
+    // One-shots and periodics run on the context's thread, on time
+    int once = 0;
+    QThread* ranOn = nullptr;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    qint64 onceAtMs = -1;
+    const TimerService::TimerId oneShot = service.schedule(&context, 30, [&]() {
+        once++;
+        ranOn = QThread::currentThread();
+        onceAtMs = elapsed.elapsed();
+    });
+    int ticks = 0;
+    const TimerService::TimerId periodic = service.schedule(&context, 10, [&]() { ticks++; }, 10);
+    QVERIFY(service.isPending(oneShot));
+    QTRY_COMPARE(once, 1);
+    QCOMPARE(ranOn, QThread::currentThread());
+    QVERIFY(onceAtMs >= 29);   // Both clocks count whole milliseconds
+    QVERIFY(!service.isPending(oneShot));
+    QTRY_VERIFY(ticks >= 5);
+    QVERIFY(service.cancel(periodic));
+    QVERIFY(!service.cancel(periodic));
+    const int stopped = ticks;
+    QTest::qWait(50);
+    QCOMPARE(ticks, stopped);
+    QCOMPARE(once, 1);
+    
+    // A busy loop gets one pending callback, not a backlog
+    ticks = 0;
+    const TimerService::TimerId busy = service.schedule(&context, 1, [&]() { ticks++; }, 1);
+    QThread::msleep(50);
+    QCoreApplication::processEvents();
+    QVERIFY(ticks >= 1 && ticks <= 2);
+    QVERIFY(service.stats().coalesced > 0);
+    service.cancel(busy);
+    
+    // Destroying the context cancels its timers
+    std::unique_ptr<QObject> doomed(new QObject);
+    int orphaned = 0;
+    const TimerService::TimerId orphan = service.schedule(doomed.get(), 10, [&]() { orphaned++; }, 10);
+    doomed.reset();
+    QVERIFY(!service.isPending(orphan));
+    QTest::qWait(40);
+    QCOMPARE(orphaned, 0);
+    QCOMPARE(service.pendingCount(), 0);
+    
+    // The QTimer-shaped handle: restart, single shot, and stop on destruction
+    int fired = 0;
+    {
+        ServiceTimer timer(&context, [&]() { fired++; }, &service);
+        timer.setSingleShot(true);
+        timer.start(20);
+        QVERIFY(timer.isActive());
+        QTRY_COMPARE(fired, 1);
+        QVERIFY(!timer.isActive());
+        timer.setSingleShot(false);
+        timer.start(10);
+        timer.setInterval(5);
+        QCOMPARE(timer.interval(), 5);
+        QTRY_VERIFY(fired >= 3);
+        QCOMPARE(service.pendingCount(), 1);
+    }
+    QCOMPARE(service.pendingCount(), 0);
+}
+
+void TestTrackManager::testThreadPlacement() {
+    using Cpus = QVector<int>;
+    QCOMPARE(ThreadPlacement::parseCpuList("2-3,6"), Cpus({2, 3, 6}));
+    QCOMPARE(ThreadPlacement::parseCpuList(" 1 , 1-2,x,4-"), Cpus({1, 2}));
+    QVERIFY(ThreadPlacement::parseCpuList("").isEmpty());
+    
+    ThreadPlacement& placement = ThreadPlacement::instance();
+    const ThreadRoleConfig saved = placement.config(ThreadRole::PtzControl);
+    
+    // The caller's budget counts misses unless the role sets its own deadline
+    const ThreadRoleStats before = placement.stats(ThreadRole::PtzControl);
+    placement.reportCycle(ThreadRole::PtzControl, 900, 1000);
+    placement.reportCycle(ThreadRole::PtzControl, 1500, 1000);
+    placement.reportCycle(ThreadRole::PtzControl, 5000);
+    ThreadRoleConfig tight = saved;
+    tight.deadlineUs = 500;
+    placement.setConfig(ThreadRole::PtzControl, tight);
+    placement.reportCycle(ThreadRole::PtzControl, 900, 1000);
+    const ThreadRoleStats after = placement.stats(ThreadRole::PtzControl);
+    QCOMPARE(after.cycles - before.cycles, quint64(4));
+    QCOMPARE(after.missed - before.missed, quint64(2));
+    QVERIFY(after.worstUs >= 5000);
+    
+    // A thread placed on start; a refusal is counted, never fatal
+    ThreadRoleConfig pinned;
+    pinned.cpus = {0};
+    pinned.realtimePriority = 10;
+    placement.setConfig(ThreadRole::PtzControl, pinned);
+    std::atomic<bool> ran{false};
+    QThread* thread = QThread::create([&]() { ran = true; });
+    placement.assign(thread, ThreadRole::PtzControl);
+    thread->start();
+    QVERIFY(thread->wait(5000));
+    delete thread;
+    QVERIFY(ran);
+    const ThreadRoleStats placed = placement.stats(ThreadRole::PtzControl);
+    QCOMPARE(placed.threads - after.threads, 1);
+    QVERIFY(placed.placementFailures - after.placementFailures <= 1);
+    placement.setConfig(ThreadRole::PtzControl, saved);
+}
+
+void TestTrackManager::testMemoryGovernor() {
+    MemoryGovernor governor;
+    MemoryGovernorConfig config;
+    config.ceilingBytes = 1000;
+    governor.setConfig(config);
+    qint64 resident = 500;
+    governor.setResidentProbe([&]() { return resident; });
+    
+    // Two consumers, registered out of shed order
+    QObject lateContext;
+    QObject earlyContext;
+    MemoryPressure late = MemoryPressure::Normal;
+    MemoryPressure early = MemoryPressure::Normal;
+    qint64 earlyUsage = 100;
+    governor.registerConsumer(&lateContext, "late", 20, 0, []() { return qint64(50); },
+                              [&](MemoryPressure pressure) { late = pressure; });
+    const MemoryGovernor::ConsumerId earlyId = governor.registerConsumer(&earlyContext, "early", 10, 200,
+        [&]() { return earlyUsage; }, [&](MemoryPressure pressure) { early = pressure; });
+    
+    const auto pollAndDeliver = [&]() {
+        governor.poll();
+        QCoreApplication::processEvents();
+    };
+    pollAndDeliver();
+    QCOMPARE(governor.pressure(), MemoryPressure::Normal);
+    QCOMPARE(governor.consumers().first().name, QString("early"));
+    
+    // Above the high water mark one consumer steps up per poll, both to
+    // Elevated before either goes Critical
+    resident = 900;
+    pollAndDeliver();
+    QCOMPARE(early, MemoryPressure::Elevated);
+    QCOMPARE(late, MemoryPressure::Normal);
+    pollAndDeliver();
+    QCOMPARE(late, MemoryPressure::Elevated);
+    pollAndDeliver();
+    QCOMPARE(early, MemoryPressure::Critical);
+    QCOMPARE(late, MemoryPressure::Elevated);
+    
+    // Between the marks nothing moves; below the low one, last in is first out
+    resident = 800;
+    pollAndDeliver();
+    QCOMPARE(early, MemoryPressure::Critical);
+    resident = 600;
+    pollAndDeliver();
+    QCOMPARE(early, MemoryPressure::Elevated);
+    pollAndDeliver();
+    pollAndDeliver();
+    QCOMPARE(early, MemoryPressure::Normal);
+    QCOMPARE(late, MemoryPressure::Normal);
+    QCOMPARE(governor.pressure(), MemoryPressure::Normal);
+    
+    // Past the critical mark everything goes at once
+    resident = 990;
+    pollAndDeliver();
+    QCOMPARE(early, MemoryPressure::Critical);
+    QCOMPARE(late, MemoryPressure::Critical);
+    resident = 100;
+    for (int i = 0; i < 4; ++i) pollAndDeliver();
+    QCOMPARE(late, MemoryPressure::Normal);
+    
+    // A consumer over its own budget sheds whatever the process total
+    earlyUsage = 300;
+    pollAndDeliver();
+    QCOMPARE(early, MemoryPressure::Elevated);
+    QCOMPARE(late, MemoryPressure::Normal);
+    governor.unregisterConsumer(earlyId);
+    QCOMPARE(governor.consumers().size(), 1);
+    const MemoryGovernor::Stats stats = governor.stats();
+    QVERIFY(stats.sheds > 0 && stats.restores > 0);
+    
+    // Shed thumbnails are cut from the JPEG on demand
+    SnapshotStore store;
+    QImage frame(320, 240, QImage::Format_RGB32);
+    frame.fill(Qt::darkGreen);
+    const QString id = store.store(frame);
+    store.waitForEncoding();
+    const qint64 kept = store.memoryBytes();
+    store.setKeepThumbnails(false);
+    QVERIFY(store.memoryBytes() < kept);
+    QCOMPARE(store.memoryBytes(), store.encodedBytes());
+    QCOMPARE(store.thumbnail(id).width(), SnapshotStore::THUMBNAIL_WIDTH);
+}
+
+void TestTrackManager::testMemoryAccounting() {
+    // Tags no other part of this test binary reports under run quiet here
+    const MemoryTagStats frames = MemoryAccounting::stats(MemoryTag::VideoFrames);
+    {
+        FramePool pool(1);
+        QImage frame = pool.acquire(QSize(64, 32), QImage::Format_RGB32);
+        const qint64 bytes = qint64(frame.bytesPerLine()) * frame.height();
+        MemoryTagStats held = MemoryAccounting::stats(MemoryTag::VideoFrames);
+        QCOMPARE(held.liveBytes - frames.liveBytes, bytes);
+        QCOMPARE(held.allocations - frames.allocations, quint64(1));
+        QVERIFY(held.peakBytes >= held.liveBytes);
+        
+        // An idle buffer is still held; trimming frees it
+        frame = QImage();
+        QCOMPARE(MemoryAccounting::liveBytes(MemoryTag::VideoFrames) - frames.liveBytes, bytes);
+        pool.trim();
+    }
+    QCOMPARE(MemoryAccounting::liveBytes(MemoryTag::VideoFrames), frames.liveBytes);
+    
+    // An account moves the live bytes by what its owner reports
+    const MemoryTagStats caches = MemoryAccounting::stats(MemoryTag::UiCaches);
+    MemoryAccounting::resetPeaks();
+    {
+        MemoryAccount account(MemoryTag::UiCaches);
+        account.set(4000);
+        account.set(1000);
+        MemoryAccount copy(account);
+        QCOMPARE(MemoryAccounting::liveBytes(MemoryTag::UiCaches) - caches.liveBytes, qint64(2000));
+        const MemoryTagStats held = MemoryAccounting::stats(MemoryTag::UiCaches);
+        QCOMPARE(held.peakBytes - caches.liveBytes, qint64(4000));
+        QCOMPARE(held.allocations - caches.allocations, quint64(2));
+    }
+    QCOMPARE(MemoryAccounting::liveBytes(MemoryTag::UiCaches), caches.liveBytes);
+    
+    // Standard containers through the tagged allocator
+    const qint64 network = MemoryAccounting::liveBytes(MemoryTag::NetworkBuffers);
+    {
+        std::vector<quint32, TaggedAllocator<quint32, MemoryTag::NetworkBuffers>> buffer;
+        buffer.reserve(256);
+        QCOMPARE(MemoryAccounting::liveBytes(MemoryTag::NetworkBuffers) - network, qint64(256 * sizeof(quint32)));
+    }
+    QCOMPARE(MemoryAccounting::liveBytes(MemoryTag::NetworkBuffers), network);
+    
+    // Sampling exports every tag, and the governor falls back on the total
+    MemoryAccounting::sample();
+    const QByteArray text = MetricsRegistry::instance().toPrometheusText();
+    QVERIFY(text.contains("cuas_memory_live_bytes{subsystem=\"video_frames\"}"));
+    QVERIFY(text.contains("cuas_memory_allocations_total{subsystem=\"ui_caches\"}"));
+    QVERIFY(text.contains("cuas_memory_allocation_rate{subsystem=\"logging\"}"));
+    
+    MemoryAccount ballast(MemoryTag::UiCaches);
+    ballast.set(1 << 20);
+    MemoryGovernor governor;
+    governor.setResidentProbe([]() { return qint64(0); });
+    governor.poll();
+    QVERIFY(governor.residentBytes() >= qint64(1 << 20));
+}
+
+void TestTrackManager::testFusionScorecard() {
+    const GeoPosition origin{34.0, -118.0, 100.0};
+    const LocalTangentPlane frame(origin);
+    auto at = [&frame](double east, double north) { return frame.toGeoLinear(EnuVector{east, north, 100.0}); };
+    auto track = [&at](const char* id, double east, double north, bool confirmed) {
+        ScorecardTrack t;
+        t.trackId = id;
+        t.position = at(east, north);
+        t.confirmed = confirmed;
+        return t;
+    };
+    QVector<ScorecardTruth> truth(2);
+    truth[0].serial = 1;
+    truth[0].position = at(0.0, 0.0);
+    truth[1].serial = 2;
+    truth[1].position = at(500.0, 0.0);
+    
+    // c 100 m, p 2: one track 3 m off, one target missed
+    FusionScorecard scorecard(origin);
+    scorecard.score(0, truth, {track("T1", 3.0, 0.0, false)});
+    QVERIFY(qAbs(scorecard.lastOspaM() - std::sqrt((9.0 + 10000.0) / 2.0)) < 1e-3);
+    QVERIFY(qAbs(scorecard.lastGospaM() - std::sqrt(9.0 + 5000.0)) < 1e-3);
+    
+    // Both held, and a false track out of every gate
+    scorecard.score(200, truth, {track("T1", 0.0, 0.0, true), track("T2", 500.0, 4.0, false),
+                                 track("T9", 2000.0, 0.0, false)});
+    QVERIFY(qAbs(scorecard.lastOspaM() - std::sqrt((16.0 + 10000.0) / 3.0)) < 1e-3);
+    QVERIFY(qAbs(scorecard.lastGospaM() - std::sqrt(16.0 + 5000.0)) < 1e-3);
+    
+    // Target 1 changes track, target 2 loses its track and gets it back
+    scorecard.score(400, truth, {track("T3", 0.0, 1.0, true)});
+    scorecard.score(600, truth, {track("T3", 0.0, 0.0, true), track("T2", 500.0, 0.0, true)});
+    ScorecardReport report = scorecard.report();
+    QCOMPARE(report.samples, 4);
+    QCOMPARE(report.targets, 2);
+    QCOMPARE(report.idSwitches, 1);
+    QCOMPARE(report.fragmentations, 1);
+    QCOMPARE(report.confirmedTargets, 2);
+    QCOMPARE(report.p50TimeToConfirmMs, qint64(200));
+    QCOMPARE(report.maxTimeToConfirmMs, qint64(600));
+    QCOMPARE(report.meanMissed, 0.5);
+    
+    // Contended targets get the assignment that is cheapest overall
+    QVector<ScorecardTruth> close(2);
+    close[0].serial = 5;
+    close[0].position = at(0.0, 0.0);
+    close[1].serial = 6;
+    close[1].position = at(10.0, 0.0);
+    scorecard.score(800, close, {track("A", 9.0, 0.0, true), track("B", 1.0, 0.0, true)});
+    QVERIFY(qAbs(scorecard.lastOspaM() - 1.0) < 1e-6);
+    // The first two went when they left the truth; these are new
+    QCOMPARE(scorecard.report().targets, 4);
+    
+    scorecard.score(1000, {}, {});
+    QCOMPARE(scorecard.lastOspaM(), 0.0);
+    QVERIFY(report.toText().contains("1 id switches"));
+    QCOMPARE(report.toJson()["fragmentations"].toInt(), 1);
+}
+
+void TestTrackManager::testSensorClock() {
+    const qint64 startMs = 1700000000000;
+    quint32 seed = 7;
+    auto delayMs = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return 5 + qint64(seed >> 24) % 40;
+    };
+    
+    // Receive times only: the sensor is 1500 ms behind and 200 ppm slow
+    SensorClock clock("clock-test");
+    QCOMPARE(clock.correct(startMs), startMs);
+    QCOMPARE(clock.correct(0), qint64(0));
+    auto sensorAt = [&](qint64 c2Ms) { return c2Ms - 1500 - std::llround((c2Ms - startMs) * 200e-6); };
+    qint64 nowMs = startMs;
+    for (int second = 0; second < 60; ++second) {
+        for (int i = 0; i < 20; ++i) {
+            nowMs += 50;
+            clock.observe(sensorAt(nowMs), nowMs + delayMs());
+        }
+        clock.update(nowMs);
+        if (second == 0) {
+            QCOMPARE(clock.health()->state, SensorClockState::Acquiring);
+        }
+    }
+    SensorClockHealthPtr health = clock.health();
+    QCOMPARE(health->state, SensorClockState::Locked);
+    QVERIFY(!health->exchanges);
+    QCOMPARE(health->intervals, 60);
+    QVERIFY(qAbs(health->driftPpm - 200.0) < 50.0);
+    QVERIFY(health->jitterMs < 5.0);
+    // Late by about the least transport delay
+    const qint64 corrected = clock.correct(sensorAt(nowMs));
+    QVERIFY(corrected >= nowMs && corrected - nowMs < 15);
+    
+    // A reboot puts the sensor 10 s ahead; the window restarts from it
+    for (int i = 0; i < 20; ++i) {
+        nowMs += 50;
+        clock.observe(sensorAt(nowMs) + 10000, nowMs + delayMs());
+    }
+    clock.update(nowMs);
+    health = clock.health();
+    QCOMPARE(health->steps, quint64(1));
+    QCOMPARE(health->state, SensorClockState::Unstable);
+    QVERIFY(qAbs(clock.correct(sensorAt(nowMs) + 10000) - nowMs) < 50);
+    
+    // Silence past the holdover keeps the fit
+    nowMs += 10000;
+    clock.update(nowMs);
+    QCOMPARE(clock.health()->state, SensorClockState::Holdover);
+    
+    // Two-way exchanges over a symmetric path take the delay out; receive
+    // times alongside them are not used
+    SensorClock exchanged("clock-exchange");
+    nowMs = startMs;
+    for (int second = 0; second < 10; ++second) {
+        for (int i = 0; i < 10; ++i) {
+            nowMs += 100;
+            const qint64 oneWayMs = delayMs();
+            const qint64 t2 = nowMs + oneWayMs + 800;
+            exchanged.observeExchange(nowMs, t2, t2 + 2, nowMs + 2 * oneWayMs + 2);
+            exchanged.observe(nowMs + 800, nowMs + oneWayMs);
+        }
+        exchanged.update(nowMs);
+    }
+    health = exchanged.health();
+    QCOMPARE(health->state, SensorClockState::Locked);
+    QVERIFY(health->exchanges);
+    QVERIFY(qAbs(health->offsetMs + 800.0) < 1.0);
+    QVERIFY(health->roundTripMs >= 10.0 && health->roundTripMs < 20.0);
+    QVERIFY(qAbs(exchanged.correct(nowMs + 800) - nowMs) <= 1);
+}
+
+void TestTrackManager::testAsterixDecoder() {
+    QByteArray datagram;
+    auto put = [&datagram](std::initializer_list<int> bytes) {
+        for (int b : bytes) datagram.append(static_cast<char>(b));
+    };
+    auto put32 = [&datagram](qint32 value) {
+        for (int shift = 24; shift >= 0; shift -= 8) datagram.append(static_cast<char>((value >> shift) & 0xFF));
+    };
+    auto putCallsign = [&datagram](const char* text) {
+        quint64 bits = 0;
+        for (int i = 0; i < 8; ++i) {
+            const char c = text[i];
+            const int code = c >= 'A' && c <= 'Z' ? c - 'A' + 1 : c >= '0' && c <= '9' ? c - '0' + 48 : 32;
+            bits = (bits << 6) | quint64(code);
+        }
+        for (int shift = 40; shift >= 0; shift -= 8) datagram.append(static_cast<char>((bits >> shift) & 0xFF));
+    };
+    
+    // CAT-048: a full plot, then a record of only items the C2 skips
+    const int block048 = datagram.size();
+    put({48, 0, 0});
+    put({0xF7, 0x17, 0x0C});
+    put({0x12, 0x34});                  // 010 SAC/SIC
+    put({0x07, 0x08, 0x40});            // 140 3600.5 s
+    put({0x41, 0x00});                  // 020 SSR, extended
+    put({0x0A, 0x00, 0x40, 0x00});      // 040 10 NM at 90 degrees
+    put({0x00, 0x8C});                  // 090 FL35
+    put({0xA0, 0x05, 0xBA});            // 130 SRL, SAM -70 dBm
+    put({0x01, 0x23});                  // 161 track 0x123
+    put({0x01, 0x00, 0x80, 0x00});      // 200 256/16384 NM/s heading 180
+    put({0x80});                        // 170 tentative
+    put({0x00, 0x28});                  // 110 1000 ft
+    put({0x80, 0x03, 0xFB});            // 120 CAL -5 m/s
+    put({0x81, 0x20});
+    put({0x56, 0x78});                  // 010
+    put({0x02});                        // 250 Mode S data, two repetitions
+    for (int i = 0; i < 16; ++i) put({i});
+    datagram[block048 + 1] = static_cast<char>((datagram.size() - block048) >> 8);
+    datagram[block048 + 2] = static_cast<char>((datagram.size() - block048) & 0xFF);
+    
+    // CAT-062 with compound items partly and wholly skipped
+    const int block062 = datagram.size();
+    put({62, 0, 0});
+    put({0x9B, 0x1F, 0x24});
+    put({0x01, 0x02});                  // 010
+    put({0x54, 0x60, 0x00});            // 070 43200 s
+    put32(qint32(std::lround(51.5 * 33554432.0 / 180.0)));     // 105
+    put32(qint32(std::lround(-0.25 * 33554432.0 / 180.0)));
+    put({0x00, 0x28, 0xFF, 0xF0});      // 185 east 10 m/s, north -4 m/s
+    put({0xC8, 0xAB, 0xCD, 0xEF});      // 380 ADR, ID, TAS
+    putCallsign("TEST12  ");
+    put({0x01, 0x2C});
+    put({0x00, 0x42});                  // 040
+    put({0x03, 0x00});                  // 080 tentative
+    put({0x81, 0x80, 0x10, 0x20});      // 290 TRK, UAT
+    put({0x00, 0x50});                  // 136 FL20
+    put({0x00, 0x64});                  // 220 625 ft/min
+    datagram[block062 + 1] = static_cast<char>((datagram.size() - block062) >> 8);
+    datagram[block062 + 2] = static_cast<char>((datagram.size() - block062) & 0xFF);
+    
+    // A category not decoded, then a record cut short
+    put({34, 0, 5, 0xAA, 0xBB});
+    put({62, 0, 5, 0x80, 0x01});
+    
+    AsterixDecoder decoder;
+    QVector<AsterixRecord> records;
+    QCOMPARE(decoder.decode(datagram.constData(), datagram.size(),
+                            [&records](const AsterixRecord& record) { records.append(record); }), 3);
+    QCOMPARE(records.size(), 3);
+    QCOMPARE(decoder.stats().blocks, quint64(4));
+    QCOMPARE(decoder.stats().records, quint64(3));
+    QCOMPARE(decoder.stats().otherCategories, quint64(1));
+    QCOMPARE(decoder.stats().malformed, quint64(1));
+    
+    const AsterixRecord& plot = records[0];
+    QCOMPARE(int(plot.category), 48);
+    QCOMPARE(int(plot.sac), 0x12);
+    QCOMPARE(int(plot.sic), 0x34);
+    QCOMPARE(int(plot.reportType), 2);
+    QVERIFY(!plot.simulated && !plot.testTarget);
+    QVERIFY(plot.tentative);
+    QVERIFY(qAbs(plot.timeOfDaySec - 3600.5) < 1e-9);
+    QVERIFY(plot.has(AsterixField::Polar));
+    QVERIFY(qAbs(plot.rangeM - 18520.0) < 1e-6);
+    QVERIFY(qAbs(plot.azimuthDeg - 90.0) < 1e-9);
+    QVERIFY(qAbs(plot.flightLevel - 35.0) < 1e-9);
+    QVERIFY(qAbs(plot.amplitudeDbm + 70.0) < 1e-9);
+    QCOMPARE(plot.trackNumber, quint32(0x123));
+    QVERIFY(plot.has(AsterixField::Velocity));
+    QVERIFY(qAbs(plot.velocityNorthMps + 256.0 * 1852.0 / 16384.0) < 1e-6);
+    QVERIFY(qAbs(plot.velocityEastMps) < 1e-6);
+    QVERIFY(qAbs(plot.heightM - 304.8) < 1e-6);
+    QVERIFY(plot.has(AsterixField::Doppler));
+    QVERIFY(qAbs(plot.dopplerMps + 5.0) < 1e-9);
+    QVERIFY(!plot.has(AsterixField::Callsign));
+    
+    QCOMPARE(int(records[1].sac), 0x56);
+    QCOMPARE(records[1].fields, quint32(AsterixField::Source));
+    
+    const AsterixRecord& track = records[2];
+    QCOMPARE(int(track.category), 62);
+    QVERIFY(qAbs(track.timeOfDaySec - 43200.0) < 1e-9);
+    QVERIFY(track.has(AsterixField::Wgs84));
+    QVERIFY(qAbs(track.latitude - 51.5) < 1e-5);
+    QVERIFY(qAbs(track.longitude + 0.25) < 1e-5);
+    QVERIFY(qAbs(track.velocityEastMps - 10.0) < 1e-9);
+    QVERIFY(qAbs(track.velocityNorthMps + 4.0) < 1e-9);
+    QCOMPARE(track.aircraftAddress, quint32(0xABCDEF));
+    QCOMPARE(QString::fromLatin1(track.callsign), QString("TEST12"));
+    QCOMPARE(track.trackNumber, quint32(0x42));
+    QVERIFY(track.tentative && !track.simulated);
+    QVERIFY(qAbs(track.flightLevel - 20.0) < 1e-9);
+    QVERIFY(!track.has(AsterixField::Height));
+    QVERIFY(qAbs(track.climbMps - 625.0 * 0.3048 / 60.0) < 1e-9);
+    
+    // A spare field reference cannot be framed
+    AsterixRecord spare;
+    const uchar spareFrn[] = {0x40, 0x00};
+    QCOMPARE(decoder.decodeRecord(62, spareFrn, sizeof(spareFrn), spare), 0);
+    
+    // Time of day onto the day nearest the receive time, across midnight
+    const qint64 midnightMs = 1700006400000;           // 2023-11-15 00:00 UTC
+    QCOMPARE(AsterixSensor::timeOfDayToEpochMs(3600.5, midnightMs + 3600 * 1000),
+             midnightMs + 3600500);
+    QCOMPARE(AsterixSensor::timeOfDayToEpochMs(86399.0, midnightMs + 2000), midnightMs - 1000);
+    QCOMPARE(AsterixSensor::timeOfDayToEpochMs(1.0, midnightMs - 1000), midnightMs + 1000);
+}
+
+void TestTrackManager::testRawCapture() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    RawCaptureConfig config;
+    config.directory = dir.path();
+    config.segmentMs = 1000;
+    RawCaptureRecorder recorder(config);
+    const int radar = recorder.openChannel("RADAR-001", RawCaptureKind::Stream);
+    const int link = recorder.openChannel("network:peer", RawCaptureKind::Datagram);
+    QVERIFY(radar >= 0 && link >= 0 && radar != link);
+    QCOMPARE(recorder.openChannel("RADAR-001", RawCaptureKind::Stream), radar);
+    QVERIFY(!recorder.record(radar, "early", 5));     // Not started
+
+    // Three reads 1.2 s apart, so each lands in a segment of its own
+    recorder.start();
+    const qint64 baseNs = TimeUtils::monotonicNs() - 3000000000LL;
+    QVERIFY(recorder.record(radar, "\x55\xAA" "abc", 5, baseNs));
+    QVERIFY(recorder.record(link, "datagram-1", 10, baseNs + 1200000000LL));
+    QVERIFY(recorder.record(radar, "def", 3, baseNs + 2400000000LL));
+    QVERIFY(!recorder.record(-1, "x", 1));
+    recorder.stop();
+    QCOMPARE(recorder.packetsRecorded(), quint64(3));
+    QCOMPARE(recorder.bytesRecorded(), quint64(18));
+    QCOMPARE(recorder.packetsDropped(), quint64(0));
+    QVERIFY(QDir(dir.path()).entryList(QStringList() << "capture-*.ccap").size() >= 3);
+
+    RawCaptureReader reader(dir.path());
+    const QVector<RawCapturePacket> all = reader.load(0, std::numeric_limits<qint64>::max() / 2000000);
+    QCOMPARE(all.size(), 3);
+    QCOMPARE(all[0].source, QString("RADAR-001"));
+    QVERIFY(all[0].kind == RawCaptureKind::Stream);
+    QCOMPARE(all[0].data, QByteArray("\x55\xAA" "abc"));
+    QCOMPARE(all[1].source, QString("network:peer"));
+    QVERIFY(all[1].kind == RawCaptureKind::Datagram);
+    QCOMPARE(all[1].data, QByteArray("datagram-1"));
+    QCOMPARE(all[2].data, QByteArray("def"));
+    QCOMPARE(all[1].timeNs - all[0].timeNs, 1200000000LL);
+
+    // A window holding only the last read still knows its channel
+    const qint64 lastMs = all[2].timeNs / 1000000;
+    const QVector<RawCapturePacket> tail = reader.load(lastMs, lastMs);
+    QCOMPARE(tail.size(), 1);
+    QCOMPARE(tail[0].source, QString("RADAR-001"));
+
+    // Replayed in order to each source's sink, the scale held to 100x
+    RawCaptureReplayer replayer;
+    QVector<QByteArray> radarReads;
+    replayer.setSink("RADAR-001", [&radarReads](const QByteArray& data) { radarReads.append(data); });
+    replayer.setTimeScale(1000.0);
+    QCOMPARE(replayer.timeScale(), RawCaptureReplayer::MAX_TIME_SCALE);
+    QCOMPARE(replayer.load(dir.path(), 0, std::numeric_limits<qint64>::max() / 2000000), 3);
+    QSignalSpy finished(&replayer, &RawCaptureReplayer::finished);
+    replayer.start();
+    QVERIFY(replayer.isRunning());
+    QTRY_COMPARE(finished.count(), 1);
+    QCOMPARE(radarReads, QVector<QByteArray>() << QByteArray("\x55\xAA" "abc") << QByteArray("def"));
+    QCOMPARE(replayer.packetsUnrouted(), quint64(1));
+
+    // Segments that end before the cutoff go
+    QVERIFY(reader.removeBefore(lastMs) >= 2);
+    QCOMPARE(reader.load(0, std::numeric_limits<qint64>::max() / 2000000).size(), 1);
+}
+
+void TestTrackManager::testCameraModel() {
+    CameraMount mount;
+    mount.position = GeoPosition{51.0, -1.0, 20.0};
+    CameraModel model;
+    model.setMount(mount);
+    model.setImageSize(QSize(1920, 1080));
+    model.setPointing(0.0, -10.0, 60.0);
+    const double focal = 960.0 / std::tan(qDegreesToRadians(30.0));
+    QVERIFY(qAbs(model.focalLengthPx() - focal) < 1e-9);
+
+    // The optical centre looks along the pointing
+    const EnuVector centre = model.pixelRay(960.0, 540.0);
+    QVERIFY(qAbs(centre.east) < 1e-9);
+    QVERIFY(qAbs(centre.north - std::cos(qDegreesToRadians(10.0))) < 1e-9);
+    QVERIFY(qAbs(centre.up + std::sin(qDegreesToRadians(10.0))) < 1e-9);
+
+    // Pixel to ray and back, with and without lens distortion
+    for (double k1 : {0.0, -0.12}) {
+        CameraIntrinsics intrinsics;
+        intrinsics.k1 = k1;
+        intrinsics.k2 = k1 != 0.0 ? 0.02 : 0.0;
+        model.setIntrinsics(intrinsics);
+        QPointF pixel;
+        QVERIFY(model.projectEnu(model.pixelRay(300.0, 200.0), pixel));
+        QVERIFY(QLineF(pixel, QPointF(300.0, 200.0)).length() < 0.05);
+        QVERIFY(model.projectEnu(model.pixelRay(1800.0, 1000.0), pixel));
+        QVERIFY(QLineF(pixel, QPointF(1800.0, 1000.0)).length() < 0.05);
+    }
+    model.setIntrinsics(CameraIntrinsics());
+
+    // Flat ground: the centre ray comes down 20 m over its range
+    CameraFix fix;
+    model.locate(&centre, nullptr, nullptr, &fix, 1);
+    QCOMPARE(fix.source, CameraFixSource::Terrain);
+    QVERIFY(qAbs(fix.rangeM - 20.0 / std::sin(qDegreesToRadians(10.0))) < 1e-6);
+    QVERIFY(qAbs(fix.position.altitude) < 1e-6);
+    QPointF pixel;
+    QVERIFY(model.project(fix.position, pixel));
+    QVERIFY(QLineF(pixel, QPointF(960.0, 540.0)).length() < 0.01);
+    QVERIFY(!model.project(GeoPosition{50.99, -1.0, 20.0}, pixel));    // Behind
+
+    // The top of the frame looks above the horizon: a known range, else the assumed one
+    BoundingBox boxes[3];
+    boxes[0].x = 950; boxes[0].y = 530; boxes[0].width = 20; boxes[0].height = 20;
+    boxes[1].x = 950; boxes[1].y = 0; boxes[1].width = 20; boxes[1].height = 20;
+    boxes[2] = boxes[1];
+    const double known[3] = {0.0, 0.0, 300.0};
+    CameraFix fixes[3];
+    model.locate(boxes, known, 0.5, fixes, 3);
+    QCOMPARE(fixes[0].source, CameraFixSource::Terrain);
+    QCOMPARE(fixes[1].source, CameraFixSource::Assumed);
+    QVERIFY(qAbs(fixes[1].rangeM - 0.5 * focal / 20.0) < 1e-6);
+    QVERIFY(fixes[1].position.altitude > mount.position.altitude);
+    QCOMPARE(fixes[2].source, CameraFixSource::KnownRange);
+    QCOMPARE(fixes[2].rangeM, 300.0);
+    QVERIFY(qAbs(LocalTangentPlane(mount.position).toEnu(fixes[2].position).range() - 300.0) < 0.5);
+
+    // One pass gives what one call per box does
+    for (int i = 0; i < 3; ++i) {
+        CameraFix single;
+        model.locate(&boxes[i], &known[i], 0.5, &single, 1);
+        QCOMPARE(single.source, fixes[i].source);
+        QCOMPARE(single.rangeM, fixes[i].rangeM);
+        QCOMPARE(single.position.latitude, fixes[i].position.latitude);
+        QCOMPARE(single.position.longitude, fixes[i].position.longitude);
+    }
+    const GeoPosition positions[3] = {fixes[0].position, fixes[1].position, fixes[2].position};
+    QPointF pixels[3];
+    bool inFront[3];
+    QCOMPARE(model.project(positions, pixels, inFront, 3), 3);
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(inFront[i]);
+        QVERIFY(QLineF(pixels[i], QPointF(boxes[i].x + 10.0, boxes[i].y + 10.0)).length() < 0.01);
+    }
+
+    // A 30 m rise from 60 m out stops the centre ray short of the flat-ground range
+    const int columns = 200;
+    const int rows = 200;
+    QVector<float> heights(columns * rows, 0.0f);
+    for (int row = 25; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) heights[row * columns + column] = 30.0f;
+    }
+    auto rise = std::make_shared<TerrainModel>();
+    rise->setGrid(50.999, -1.01, 0.0000625, columns, rows, heights);
+    QVERIFY(qAbs(rise->elevationM(51.0, -1.0)) < 1e-6);
+    model.setTerrain(rise);
+    model.locate(&centre, nullptr, nullptr, &fix, 1);
+    QCOMPARE(fix.source, CameraFixSource::Terrain);
+    QVERIFY(fix.rangeM > 55.0 && fix.rangeM < 70.0);
+    QVERIFY(model.project(fix.position, pixel));
+    QVERIFY(QLineF(pixel, QPointF(960.0, 540.0)).length() < 0.01);
+
+    // The mount's heading turns pan zero
+    mount.headingDeg = 90.0;
+    model.setMount(mount);
+    model.setPointing(0.0, 0.0, 60.0);
+    const EnuVector east = model.pixelRay(960.0, 540.0);
+    QVERIFY(qAbs(east.east - 1.0) < 1e-9);
+    QVERIFY(qAbs(east.up) < 1e-9);
+}
+
+void TestTrackManager::testStatusBoard() {
+    StatusBoard board;
+    QSignalSpy published(&board, &StatusBoard::published);
+
+    QVERIFY(board.publish("RADAR-1", StatusKind::Sensor, {{"status", "Online"}, {"detections", 10}}));
+    const quint64 first = board.version();
+    QCOMPARE(first, quint64(1));
+
+    // The same values again change nothing
+    QVERIFY(!board.publish("RADAR-1", StatusKind::Sensor, {{"status", "Online"}, {"detections", 10}}));
+    QCOMPARE(board.version(), first);
+
+    // Only the field that moved takes the new version
+    QVERIFY(board.publish("RADAR-1", StatusKind::Sensor, {{"status", "Online"}, {"detections", 11}}));
+    StatusSnapshotPtr radar = board.snapshot("RADAR-1", StatusKind::Sensor);
+    QVERIFY(radar);
+    QCOMPARE(radar->version, quint64(2));
+    QVERIFY(radar->changed("detections", first));
+    QVERIFY(!radar->changed("status", first));
+    QVERIFY(radar->changed("status", 0));
+    QCOMPARE(radar->value("detections").toInt(), 11);
+
+    // A kind and an id name a source; readers filter by kind, oldest first
+    QVERIFY(board.publish("RADAR-1", StatusKind::Camera, {{"fps", 25.0}}));
+    QVERIFY(board.publish("JAMMER-1", StatusKind::Effector, {{"readiness", 100}}));
+    QCOMPARE(board.snapshot("RADAR-1", StatusKind::Sensor)->value("fps"), QVariant());
+    QVector<StatusSnapshotPtr> changed = board.changedSince(first);
+    QCOMPARE(changed.size(), 3);
+    QCOMPARE(changed[0]->kind, StatusKind::Sensor);
+    QCOMPARE(changed[1]->kind, StatusKind::Camera);
+    QCOMPARE(changed[2]->source, QString("JAMMER-1"));
+    changed = board.changedSince(0, StatusBoard::kindBit(StatusKind::Effector) | StatusBoard::kindBit(StatusKind::Camera));
+    QCOMPARE(changed.size(), 2);
+    QVERIFY(board.changedSince(board.version()).isEmpty());
+
+    // Removal leaves its last fields for readers to see it go
+    const quint64 beforeRemove = board.version();
+    board.remove("JAMMER-1", StatusKind::Effector);
+    board.remove("JAMMER-1", StatusKind::Effector);
+    QCOMPARE(board.version(), beforeRemove + 1);
+    changed = board.changedSince(beforeRemove);
+    QCOMPARE(changed.size(), 1);
+    QVERIFY(changed[0]->removed);
+    QCOMPARE(changed[0]->value("readiness").toInt(), 100);
+    // Publishing again brings it back with only its new fields
+    QVERIFY(board.publish("JAMMER-1", StatusKind::Effector, {{"status", 3}}));
+    StatusSnapshotPtr jammer = board.snapshot("JAMMER-1", StatusKind::Effector);
+    QVERIFY(!jammer->removed);
+    QVERIFY(!jammer->fields.contains("readiness"));
+
+    // Snapshots already handed out keep their values
+    QCOMPARE(radar->value("detections").toInt(), 11);
+
+    // One queued emission for the whole burst, with the latest version
+    QCOMPARE(published.count(), 0);
+    QCoreApplication::processEvents();
+    QCOMPARE(published.count(), 1);
+    QCOMPARE(published.last().at(0).toULongLong(), board.version());
+    QVERIFY(board.publish("RADAR-1", StatusKind::Sensor, {{"detections", 12}}));
+    QCoreApplication::processEvents();
+    QCOMPARE(published.count(), 2);
+}
+
+void TestTrackManager::testInterceptorFlights() {
+    const GeoPosition launcher{34.0, -118.0, 100.0};
+    const auto offset = [&](double northM, double eastM, double altitude) {
+        GeoPosition pos;
+        pos.latitude = launcher.latitude + northM / CoordinateUtils::DEG_TO_M_LAT;
+        pos.longitude = launcher.longitude + eastM / CoordinateUtils::degToMeterLon(launcher.latitude);
+        pos.altitude = altitude;
+        return pos;
+    };
+    const auto launches = [&](InterceptorFlights& flights) {
+        InterceptorLaunch still;
+        still.effectorId = "KINETIC-1";
+        still.launcher = launcher;
+        still.target = offset(1000.0, 0.0, 100.0);
+        still.speedMps = 100.0;
+        flights.launch(still);
+
+        InterceptorLaunch crossing = still;
+        crossing.effectorId = "KINETIC-2";
+        crossing.target = offset(600.0, -300.0, 150.0);
+        crossing.targetVelocity.east = 20.0;
+        crossing.speedMps = 150.0;
+        flights.launch(crossing);
+
+        InterceptorLaunch tooFar = still;
+        tooFar.effectorId = "KINETIC-3";
+        tooFar.target = offset(0.0, 2000.0, 100.0);
+        tooFar.maxFlightMs = 3000;
+        flights.launch(tooFar);
+    };
+
+    // Advanced at once or in ragged chunks, the same launches go the same way
+    InterceptorFlights once(42, 1000);
+    launches(once);
+    QCOMPARE(once.size(), 3);
+    QVector<InterceptorEvent> onceEvents;
+    once.advanceTo(1000 + 20000, onceEvents);
+
+    InterceptorFlights chunked(42, 1000);
+    launches(chunked);
+    const int row = chunked.row(2);
+    QCOMPARE(row, 1);
+    QCOMPARE(chunked.effectorId(row), QString("KINETIC-2"));
+    QVector<InterceptorEvent> chunkedEvents;
+    for (qint64 t = 1000; t < 1000 + 20000; t += 7) chunked.advanceTo(t, chunkedEvents);
+    chunked.advanceTo(1000 + 20000, chunkedEvents);
+
+    QCOMPARE(once.stepCount(), quint64(2000));
+    QCOMPARE(chunked.stepCount(), once.stepCount());
+    QVERIFY(once.isEmpty());
+    QVERIFY(chunked.isEmpty());
+    QCOMPARE(chunkedEvents.size(), onceEvents.size());
+    QCOMPARE(onceEvents.size(), 5);
+    for (int i = 0; i < onceEvents.size(); ++i) {
+        QVERIFY(chunkedEvents[i].type == onceEvents[i].type);
+        QCOMPARE(chunkedEvents[i].serial, onceEvents[i].serial);
+        QCOMPARE(chunkedEvents[i].timeMs, onceEvents[i].timeMs);
+        QCOMPARE(chunkedEvents[i].success, onceEvents[i].success);
+        QCOMPARE(chunkedEvents[i].position.latitude, onceEvents[i].position.latitude);
+    }
+
+    QHash<quint64, InterceptorEvent> complete;
+    for (const InterceptorEvent& event : onceEvents) {
+        QCOMPARE(event.timeMs % InterceptorFlights::STEP_MS, qint64(0));
+        if (event.type == InterceptorEvent::Type::Complete) complete.insert(event.serial, event);
+    }
+    QCOMPARE(complete.size(), 3);
+
+    // 1 km at 100 m/s arrives on the step that brings it into the kill radius
+    QVERIFY(qAbs(complete[1].timeMs - 1000 - 9950) <= 3 * InterceptorFlights::STEP_MS);
+    QVERIFY(!complete[1].timedOut);
+    QCOMPARE(complete[1].distanceM, 0.0);
+    // The crossing target is caught where it has flown to
+    QVERIFY(!complete[2].timedOut);
+    QVERIFY(complete[2].target.longitude > offset(600.0, -300.0, 150.0).longitude);
+    QVERIFY(complete[2].timeMs - 1000 < 5000);
+    // Out of energy short of 2 km, and never a kill
+    QVERIFY(complete[3].timedOut);
+    QVERIFY(!complete[3].success);
+    QCOMPARE(complete[3].timeMs, qint64(1000 + 3000));
+    QVERIFY(complete[3].distanceM > 1500.0);
+
+    // Every flight goes terminal exactly once, before it completes
+    int terminal = 0;
+    for (const InterceptorEvent& event : onceEvents) {
+        if (event.type == InterceptorEvent::Type::Terminal) {
+            ++terminal;
+            QVERIFY(event.timeMs <= complete[event.serial].timeMs);
+        }
+    }
+    QCOMPARE(terminal, 2);
+
+    // Completed rows go, and later rows are found where they moved to
+    InterceptorFlights mixed(7, 0);
+    InterceptorLaunch quick;
+    quick.effectorId = "KINETIC-1";
+    quick.launcher = launcher;
+    quick.target = offset(40.0, 0.0, 100.0);
+    mixed.launch(quick);
+    InterceptorLaunch slow = quick;
+    slow.effectorId = "KINETIC-2";
+    slow.target = offset(0.0, 800.0, 100.0);
+    const quint64 slowSerial = mixed.launch(slow);
+    QVector<InterceptorEvent> events;
+    mixed.advanceTo(1000, events);
+    QCOMPARE(mixed.size(), 1);
+    QCOMPARE(mixed.row(1), -1);
+    QCOMPARE(mixed.row(slowSerial), 0);
+    QVERIFY(qAbs(mixed.distanceM(0) - 700.0) < 2.0);
+    QVERIFY(qAbs(mixed.velocity(0).east - 100.0) < 1.0);
+    QVERIFY(!mixed.isTerminal(0));
+
+    // A reset drops every flight
+    mixed.reset(7, 0);
+    QVERIFY(mixed.isEmpty());
+    QCOMPARE(mixed.row(slowSerial), -1);
+    QCOMPARE(mixed.timeMs(), qint64(0));
+}
+
+void TestTrackManager::testOverloadController() {
+    OverloadController controller;
+    OverloadConfig config;
+    config.escalateWindows = 2;
+    config.recoverWindows = 3;
+    controller.setConfig(config);
+    int changes = 0;
+    connect(&controller, &OverloadController::levelChanged, this,
+            [&](OverloadLevel, OverloadLevel) { ++changes; });
+    
+    const auto window = [&](qint64 trackUs, qint64 assessmentUs) {
+        for (int i = 0; i < 10; ++i) controller.reportStage(LoadStage::TrackCycle, trackUs, 100000);
+        controller.reportStage(LoadStage::Assessment, assessmentUs, 500000);
+        controller.evaluate();
+    };
+    
+    // Comfortably inside budget nothing moves
+    window(20000, 100000);
+    window(20000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::Normal);
+    QCOMPARE(controller.stageStatus(LoadStage::TrackCycle).cycles, quint64(10));
+    QVERIFY(qAbs(controller.stageStatus(LoadStage::TrackCycle).utilization - 0.2) < 1e-9);
+    
+    // Every escalateWindows hot windows shed one level
+    window(120000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::Normal);
+    window(120000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::ReducedVideo);
+    QCOMPARE(controller.stageStatus(LoadStage::TrackCycle).overruns, quint64(10));
+    window(50000, 600000);      // One overrunning assessment cycle is hot too
+    window(50000, 600000);
+    QCOMPARE(controller.level(), OverloadLevel::ReducedAssessment);
+    for (int i = 0; i < 10; ++i) window(120000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::CoarseDisplay);
+    
+    // Between the marks neither count advances
+    for (int i = 0; i < 5; ++i) window(75000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::CoarseDisplay);
+    
+    // Calm windows restore one level per recoverWindows
+    window(20000, 100000);
+    window(20000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::CoarseDisplay);
+    window(20000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::SweepSuspended);
+    for (int i = 0; i < 9; ++i) window(20000, 100000);
+    QCOMPARE(controller.level(), OverloadLevel::Normal);
+    
+    // An idle window is calm, and no level steps past Normal
+    for (int i = 0; i < 4; ++i) controller.evaluate();
+    QCOMPARE(controller.level(), OverloadLevel::Normal);
+    QCOMPARE(controller.stageStatus(LoadStage::Render).cycles, quint64(0));
+    
+    const OverloadController::Stats stats = controller.stats();
+    QCOMPARE(stats.escalations, quint64(4));
+    QCOMPARE(stats.recoveries, quint64(4));
+    QCOMPARE(changes, 8);
+}
+
+void TestTrackManager::testSnapshotStore() {
+    SnapshotStore store;
+    QCOMPARE(store.store(QImage()), QString());
+
+    QImage frame(640, 480, QImage::Format_RGB32);
+    frame.fill(Qt::darkGreen);
+    const QString id = store.store(frame);
+    QVERIFY(!id.isEmpty());
+
+    // Held as given until encoded; readable meanwhile
+    QCOMPARE(store.image(id).size(), frame.size());
+    QVERIFY(store.thumbnail(id).width() <= SnapshotStore::THUMBNAIL_WIDTH);
+
+    // Same pixels, same id, one copy
+    QImage same = frame.copy();
+    QCOMPARE(store.store(same), id);
+    QCOMPARE(store.count(), 1);
+    same.setPixel(0, 0, qRgb(255, 0, 0));
+    const QString other = store.store(same);
+    QVERIFY(other != id);
+    QCOMPARE(store.count(), 2);
+
+    store.waitForEncoding();
+    QVERIFY(!store.jpeg(id).isEmpty());
+    QVERIFY(store.encodedBytes() < qint64(frame.sizeInBytes()));
+    QCOMPARE(store.thumbnail(id).size(), QSize(160, 120));
+    const QImage decoded = store.image(id);
+    QCOMPARE(decoded.size(), frame.size());
+    QVERIFY(qAbs(qGreen(decoded.pixel(320, 240)) - qGreen(frame.pixel(320, 240))) < 8);
+
+    // Dropped with its last reference
+    store.release(id);
+    QVERIFY(store.contains(id));
+    store.release(id);
+    QVERIFY(!store.contains(id));
+    QVERIFY(store.image(id).isNull());
+    store.release(other);
+    QCOMPARE(store.count(), 0);
+    QCOMPARE(store.encodedBytes(), qint64(0));
+}
+
+void TestTrackManager::testInterceptSolver() {
+    const GeoPosition launcher{51.0, 0.0, 20.0};
+    const InterceptSolver solver(InterceptorKinematics(), launcher);
+    auto targetAt = [&launcher](const QString& id, double northM, double northMps) {
+        InterceptTarget target;
+        target.trackId = id;
+        target.position = GeoPosition{launcher.latitude + northM / CoordinateUtils::DEG_TO_M_LAT,
+                                      launcher.longitude, launcher.altitude};
+        target.velocity.north = northMps;
+        return target;
+    };
+
+    // Hovering at 500 m: launch after the 2.5 s delay, 5 s at 100 m/s
+    InterceptSolution hover = solver.solve(targetAt("H", 500.0, 0.0));
+    QVERIFY(hover.feasible);
+    QVERIFY(qAbs(hover.launchInSec - 2.5) < 1e-6);
+    QVERIFY(qAbs(hover.timeOfFlightSec - 5.0) < 1e-6);
+    QVERIFY(qAbs(hover.timeToInterceptSec - 7.5) < 1e-6);
+    QVERIFY(hover.pk > 0.5 && hover.pk < 0.85);
+
+    // Inbound from 2 km at 50 m/s: reachable from t = 15 s, but only
+    // inside the 1000 m fly-out from t = 20 s, so the launch waits
+    QVector<InterceptSolution> batch = solver.solve(QVector<InterceptTarget>{
+        targetAt("IN", 2000.0, -50.0), targetAt("OUT", 800.0, 150.0), targetAt("H", 500.0, 0.0)});
+    QCOMPARE(batch.size(), 3);
+    QCOMPARE(batch[0].trackId, QString("IN"));
+    QVERIFY(batch[0].feasible);
+    QVERIFY(qAbs(batch[0].timeToInterceptSec - 20.0) < 1e-6);
+    QVERIFY(qAbs(batch[0].launchInSec - 10.0) < 1e-6);
+    QVERIFY(qAbs(batch[0].interceptRangeM - 1000.0) < 1e-3);
+    QVERIFY(qAbs(batch[0].interceptPoint.latitude -
+                 (launcher.latitude + 1000.0 / CoordinateUtils::DEG_TO_M_LAT)) < 1e-9);
+    QVERIFY(batch[0].pk < hover.pk);
+
+    // Faster than the interceptor and opening: never
+    QVERIFY(!batch[1].feasible);
+    QCOMPARE(batch[2].timeToInterceptSec, hover.timeToInterceptSec);
+
+    // A poorer track means a wider prediction error and a lower Pk
+    const InterceptSolution sharp = solver.solve(
+        InterceptSolver::target("Q", targetAt("Q", 900.0, -20.0).position, {-20.0, 0.0, 0.0}, 1.0));
+    const InterceptSolution vague = solver.solve(
+        InterceptSolver::target("Q", targetAt("Q", 900.0, -20.0).position, {-20.0, 0.0, 0.0}, 0.0));
+    QVERIFY(sharp.feasible && vague.feasible);
+    QVERIFY(vague.pk < sharp.pk);
+
+    // The assigner scores a fly-out effector on the solved intercept
+    WeaponTargetAssigner assigner;
+    AssignmentEffector interceptor;
+    interceptor.effectorId = "KIN";
+    interceptor.effectorType = "KINETIC";
+    interceptor.position = launcher;
+    interceptor.hasKinematics = true;
+    assigner.updateEffector(interceptor);
+    AssignmentThreat inbound;
+    inbound.trackId = "IN";
+    inbound.position = targetAt("IN", 2000.0, -50.0).position;
+    inbound.velocity.north = -50.0;
+    inbound.classification = TrackClassification::Hostile;
+    inbound.threatLevel = 4;
+    assigner.updateThreat(inbound);
+    const QVector<WeaponAssignment> plan = assigner.solve();
+    QCOMPARE(plan.size(), 1);
+    QVERIFY(qAbs(plan[0].timeToInterceptSec - 20.0) < 1e-6);
+    const InterceptSolution expected = solver.solve(
+        InterceptSolver::target("IN", inbound.position, inbound.velocity, inbound.trackQuality));
+    QVERIFY(qAbs(plan[0].pk - expected.pk) < 1e-9);
+}
+
+void TestTrackManager::testIntervalTree() {
+    IntervalTree<QString> tree;
+    const auto a = tree.insert(2400.0, 2420.0, "A");
+    const auto b = tree.insert(2410.0, 2415.0, "B");
+    const auto c = tree.insert(2500.0, 2480.0, "C");     // Bounds in either order
+    QCOMPARE(tree.size(), 3);
+    QCOMPARE(tree.lo(c), 2480.0);
+
+    // By lower bound, closed at both ends
+    QCOMPARE(tree.overlapping(2412.0, 2480.0), (QVector<int>{a, b, c}));
+    QCOMPARE(tree.overlapping(2420.0, 2420.0), QVector<int>{a});
+    QVERIFY(tree.overlapping(2421.0, 2479.0).isEmpty());
+
+    QVERIFY(tree.remove(a));
+    QVERIFY(!tree.remove(a));
+    QVERIFY(!tree.contains(a));
+    QCOMPARE(tree.overlapping(2400.0, 2412.0), QVector<int>{b});
+    QCOMPARE(tree.insert(2390.0, 2395.0, "D"), a);      // Node recycled
+    QCOMPARE(tree.value(a), QString("D"));
+
+    // Against a linear scan
+    IntervalTree<int> random;
+    QVector<QPair<double, double>> spans;
+    QVector<int> handles;
+    FastRandom rng(7);
+    for (int i = 0; i < 2000; ++i) {
+        if (!handles.isEmpty() && rng.uniform() < 0.3) {
+            const int k = static_cast<int>(rng.uniform() * handles.size()) % handles.size();
+            QVERIFY(random.remove(handles[k]));
+            handles.removeAt(k);
+            spans.removeAt(k);
+        } else {
+            const double lo = rng.uniform() * 1000.0;
+            const double hi = lo + rng.uniform() * 50.0;
+            handles.append(random.insert(lo, hi, i));
+            spans.append(qMakePair(lo, hi));
+        }
+        const double qlo = rng.uniform() * 1000.0;
+        const double qhi = qlo + rng.uniform() * 100.0;
+        int expected = 0;
+        for (const auto& span : qAsConst(spans)) {
+            if (span.first <= qhi && span.second >= qlo) expected++;
+        }
+        QCOMPARE(int(random.overlapping(qlo, qhi).size()), expected);
+    }
+    QCOMPARE(random.size(), int(handles.size()));
+}
+
+void TestTrackManager::testSpectrumPlanner() {
+    auto emission = [](const QString& id, double centerMHz, double bandwidthMHz,
+                       double weight = 1.0, qint64 seenMs = 0) {
+        JamEmission e;
+        e.emissionId = id;
+        e.centerMHz = centerMHz;
+        e.bandwidthMHz = bandwidthMHz;
+        e.weight = weight;
+        e.lastSeenMs = seenMs;
+        return e;
+    };
+    JammerSpectrum jammer;
+    jammer.jammerId = "J1";
+    jammer.minFrequencyMHz = 2400.0;
+    jammer.maxFrequencyMHz = 2500.0;
+    jammer.channels = 2;
+    jammer.channelBandwidthMHz = 20.0;
+
+    // Best single channel first would take B and C (6), then D (9); the
+    // optimum pairs A with B and C with D
+    SpectrumPlanner planner;
+    planner.updateEmission(emission("A", 2440.0, 2.0, 1.0));
+    planner.updateEmission(emission("B", 2455.0, 2.0, 3.0));
+    planner.updateEmission(emission("C", 2470.0, 2.0, 3.0));
+    planner.updateEmission(emission("D", 2480.0, 2.0, 3.0));
+    planner.setJammers(QVector<JammerSpectrum>{jammer});
+    QVector<JammerPlan> plans = planner.plan();
+    QCOMPARE(plans.size(), 1);
+    QCOMPARE(plans[0].coveredWeight, 10.0);
+    QCOMPARE(plans[0].centersMHz(), (QList<double>{2449.0, 2479.0}));
+    QCOMPARE(plans[0].channels[0].emissionIds, (QStringList{"A", "B"}));
+    QVERIFY(planner.uncovered().isEmpty());
+
+    // Wider than a channel, or outside the band: never covered
+    planner.updateEmission(emission("WIDE", 2420.0, 30.0, 5.0));
+    planner.updateEmission(emission("HIGH", 5800.0, 2.0, 5.0));
+    plans = planner.plan();
+    QCOMPARE(plans[0].coveredWeight, 10.0);
+    QCOMPARE(planner.uncovered(), (QStringList{"HIGH", "WIDE"}));
+
+    // Unchanged input keeps the plan; a re-report in place does too
+    const quint64 solved = planner.stats().jammersSolved;
+    planner.updateEmission(emission("A", 2440.0, 2.0, 1.0, 100));
+    planner.plan();
+    QCOMPARE(planner.stats().jammersSolved, solved);
+    QCOMPARE(planner.stats().jammersReused, quint64(2));
+
+    // One channel left: the heavier pair
+    jammer.channels = 1;
+    planner.setJammers(QVector<JammerSpectrum>{jammer});
+    plans = planner.plan();
+    QCOMPARE(planner.stats().jammersSolved, solved + 1);
+    QCOMPARE(plans[0].coveredWeight, 6.0);
+    QCOMPARE(plans[0].channels.size(), 1);
+
+    // A second jammer takes what the first leaves
+    JammerSpectrum second = jammer;
+    second.jammerId = "J2";
+    second.maxFrequencyMHz = 5900.0;
+    planner.setJammers(QVector<JammerSpectrum>{jammer, second});
+    plans = planner.plan();
+    QCOMPARE(plans.size(), 2);
+    QCOMPARE(plans[1].coveredWeight, 5.0);
+    QCOMPARE(plans[1].channels[0].emissionIds, QStringList{"HIGH"});
+    QCOMPARE(planner.planFor("J2").jammerId, QString("J2"));
+
+    // Emissions not seen since the cutoff drop out
+    QCOMPARE(planner.expire(50), 5);
+    QCOMPARE(planner.emissionCount(), 1);
+    plans = planner.plan();
+    QCOMPARE(plans[0].coveredWeight, 1.0);
+    QVERIFY(plans[1].channels.isEmpty());
+    QVERIFY(planner.removeEmission("A"));
+    QVERIFY(!planner.removeEmission("A"));
+}
+
+void TestTrackManager::testTrace() {
+    Trace::setEnabled(false);
+    Trace::clear();
+    {
+        TraceScope scope("test", "off");
+    }
+    QCOMPARE(Trace::eventCount(), 0);
+
+    Trace::setEnabled(true);
+    {
+        TraceScope outer("test", "outer");
+        TraceScope inner("test", "inner");
+    }
+    std::thread worker([]() {
+        Trace::setThreadName("trace-worker");
+        TraceScope scope("test", "worker");
+    });
+    worker.join();
+    QCOMPARE(Trace::eventCount(), 3);
+
+    // Chrome trace JSON: one complete event per scope, threads named
+    const QJsonDocument doc = QJsonDocument::fromJson(Trace::toChromeJson());
+    QVERIFY(doc.isObject());
+    QHash<QString, QJsonObject> events;
+    int workerTid = -1;
+    for (const QJsonValue& value : doc.object()["traceEvents"].toArray()) {
+        const QJsonObject event = value.toObject();
+        if (event["ph"].toString() == "X") {
+            events.insert(event["name"].toString(), event);
+        } else if (event["args"].toObject()["name"].toString() == "trace-worker") {
+            workerTid = event["tid"].toInt();
+        }
+    }
+    QCOMPARE(events.size(), 3);
+    QCOMPARE(events["outer"]["cat"].toString(), QString("test"));
+    QVERIFY(events["outer"]["ts"].toDouble() <= events["inner"]["ts"].toDouble());
+    QVERIFY(events["outer"]["ts"].toDouble() + events["outer"]["dur"].toDouble() >=
+            events["inner"]["ts"].toDouble() + events["inner"]["dur"].toDouble());
+    QCOMPARE(events["worker"]["tid"].toInt(), workerTid);
+    QVERIFY(events["outer"]["tid"].toInt() != workerTid);
+
+    // A ring keeps the latest RING_EVENTS
+    Trace::clear();
+    for (int i = 0; i < Trace::RING_EVENTS + 100; ++i) {
+        Trace::record("test", "wrap", i, i + 1);
+    }
+    QCOMPARE(Trace::eventCount(), Trace::RING_EVENTS);
+
+    Trace::setEnabled(false);
+    Trace::clear();
+}
+
+void TestTrackManager::testFlightRecorder() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    Trace::setEnabled(false);
+    Trace::clear();
+    
+    FlightRecorder recorder;
+    FlightRecorderConfig config;
+    config.directory = dir.path();
+    config.windowMs = 1000;
+    config.overrunFactor = 1.5;
+    config.maxCaptures = 2;
+    recorder.setConfig(config);
+    recorder.setProbe("tracks", []() { return 42.0; });
+    
+    // Nothing counts until it runs
+    recorder.reportCycle(FlightStage::TrackCycle, 500000, 100000);
+    QCOMPARE(recorder.stats().overruns, quint64(0));
+    
+    recorder.start();
+    QVERIFY(Trace::isEnabled());
+    const qint64 nowNs = Trace::nowNs();
+    Trace::record("test", "stale", nowNs - qint64(10) * 1000000000, nowNs - qint64(9) * 1000000000);
+    {
+        TraceScope scope("test", "lead-up");
+    }
+    // Over budget, but within overrunFactor of it
+    recorder.reportCycle(FlightStage::TrackCycle, 140000, 100000);
+    QCOMPARE(recorder.stats().overruns, quint64(0));
+    
+    recorder.reportCycle(FlightStage::TrackCycle, 200000, 100000);
+    QTRY_VERIFY(!recorder.isCapturing());
+    QCOMPARE(recorder.stats().captures, quint64(1));
+    QVERIFY(Trace::isEnabled());
+    
+    // The window up to the overrun, with the overrun and the probes
+    QFile file(recorder.stats().lastCapture);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(QFileInfo(file.fileName()).fileName().endsWith("-track_cycle.json"));
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    QSet<QString> names;
+    QJsonObject overrun;
+    for (const QJsonValue& value : doc.object()["traceEvents"].toArray()) {
+        const QJsonObject event = value.toObject();
+        names.insert(event["name"].toString());
+        if (event["name"].toString() == "overrun") overrun = event;
+    }
+    QVERIFY(names.contains("lead-up"));
+    QVERIFY(names.contains("track_cycle"));     // The cycles, as events of their own
+    QVERIFY(!names.contains("stale"));
+    QCOMPARE(overrun["ph"].toString(), QString("i"));
+    QCOMPARE(overrun["args"].toObject()["stage"].toString(), QString("track_cycle"));
+    QCOMPARE(overrun["args"].toObject()["budgetUs"].toInt(), 100000);
+    QCOMPARE(overrun["args"].toObject()["tracks"].toDouble(), 42.0);
+    
+    // One capture per cooldown
+    recorder.reportCycle(FlightStage::Assessment, 900000, 100000);
+    QCOMPARE(recorder.stats().overruns, quint64(2));
+    QCOMPARE(recorder.stats().suppressed, quint64(1));
+    
+    // Stages reported without a budget use the configured one; the oldest
+    // files go beyond maxCaptures
+    config.cooldownMs = 0;
+    recorder.setConfig(config);
+    for (int i = 0; i < 2; ++i) {
+        QTest::qWait(5);    // Apart in the file names
+        recorder.reportCycle(FlightStage::Paint, 80000);
+        QTRY_VERIFY(!recorder.isCapturing());
+    }
+    recorder.reportCycle(FlightStage::FrameDelivery, 25000);
+    QCOMPARE(recorder.stats().overruns, quint64(4));
+    QCOMPARE(recorder.stats().captures, quint64(3));
+    QCOMPARE(QDir(dir.path()).entryList({"overrun-*.json"}, QDir::Files).size(), 2);
+    QVERIFY(recorder.stats().lastCapture.endsWith("-paint.json"));
+    
+    recorder.stop();
+    QVERIFY(!Trace::isEnabled());
+    Trace::clear();
+}
+
+void TestTrackManager::testLatencyHistogram() {
+    // Exact below 32 us, then 16 steps per octave with contiguous buckets
+    QCOMPARE(LatencyHistogramSnapshot::bucketFor(0), 0);
+    QCOMPARE(LatencyHistogramSnapshot::bucketFor(31), 31);
+    QCOMPARE(LatencyHistogramSnapshot::bucketFor(32), 32);
+    QCOMPARE(LatencyHistogramSnapshot::bucketFor(33), 32);
+    QCOMPARE(LatencyHistogramSnapshot::bucketFor(-5), 0);
+    QCOMPARE(LatencyHistogramSnapshot::bucketFor(std::numeric_limits<qint64>::max()),
+             LatencyHistogramSnapshot::BUCKETS - 1);
+    for (int b = 1; b < LatencyHistogramSnapshot::BUCKETS; ++b) {
+        QCOMPARE(LatencyHistogramSnapshot::bucketLowerUs(b), LatencyHistogramSnapshot::bucketUpperUs(b - 1) + 1);
+        QCOMPARE(LatencyHistogramSnapshot::bucketFor(LatencyHistogramSnapshot::bucketLowerUs(b)), b);
+        QCOMPARE(LatencyHistogramSnapshot::bucketFor(LatencyHistogramSnapshot::bucketUpperUs(b)), b);
+        // Never wider than 1/16 of the values it holds
+        const qint64 width = LatencyHistogramSnapshot::bucketUpperUs(b) - LatencyHistogramSnapshot::bucketLowerUs(b) + 1;
+        QVERIFY(width * LatencyHistogramSnapshot::SUB_BUCKETS <= qMax<qint64>(LatencyHistogramSnapshot::SUB_BUCKETS, LatencyHistogramSnapshot::bucketLowerUs(b)));
+    }
+    
+    LatencyHistogram histogram;
+    QCOMPARE(histogram.snapshot().percentileUs(0.99), qint64(0));
+    for (qint64 us = 1; us <= 1000; ++us) {
+        histogram.record(us * 100);  // 100 us .. 100 ms
+    }
+    const LatencyHistogramSnapshot first = histogram.snapshot();
+    QCOMPARE(first.count, quint64(1000));
+    QCOMPARE(first.maxUs, qint64(100000));
+    QCOMPARE(first.meanUs(), 50050.0);
+    QVERIFY(qAbs(first.percentileUs(0.50) - 50000) <= 50000 / 16);
+    QVERIFY(qAbs(first.percentileUs(0.99) - 99000) <= 99000 / 16);
+    QVERIFY(first.percentileUs(0.99) >= first.percentileUs(0.50));
+    QCOMPARE(first.percentileUs(1.0), qint64(100000));  // Clamped to the maximum
+    
+    // An interval view holds only the later samples
+    histogram.record(5);
+    const LatencyHistogramSnapshot delta = histogram.snapshot().since(first);
+    QCOMPARE(delta.count, quint64(1));
+    QCOMPARE(delta.percentileUs(0.5), qint64(5));
+    QCOMPARE(delta.maxUs, qint64(5));
+    
+    // Lock-free recording from several threads loses nothing
+    histogram.reset();
+    QCOMPARE(histogram.snapshot().count, quint64(0));
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 4; ++w) {
+        writers.emplace_back([&histogram, w]() {
+            for (int i = 0; i < 10000; ++i) {
+                histogram.record(w * 1000 + i % 500);
+            }
+        });
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    const LatencyHistogramSnapshot total = histogram.snapshot();
+    QCOMPARE(total.count, quint64(40000));
+    quint64 bucketed = 0;
+    for (quint64 n : total.counts) bucketed += n;
+    QCOMPARE(bucketed, quint64(40000));
+    QCOMPARE(total.maxUs, qint64(3499));
+}
+
+void TestTrackManager::testPipelineLatency() {
+    PipelineLatency::reset();
+    
+    // A repainted picture counts its newest plot once
+    qint64 lastRecordedNs = 0;
+    const qint64 readNs = TimeUtils::monotonicNs();
+    QVERIFY(PipelineLatency::recordNewest(PipelineStage::Display, readNs, lastRecordedNs));
+    QVERIFY(!PipelineLatency::recordNewest(PipelineStage::Display, readNs, lastRecordedNs));
+    QVERIFY(!PipelineLatency::recordNewest(PipelineStage::Display, 0, lastRecordedNs));
+    QCOMPARE(PipelineLatency::snapshot(PipelineStage::Display).count, quint64(1));
+    
+    // Stamped plots fused in a batch date fusion and receive, and the
+    // picture carries the newest of them downstream
+    TrackManager manager;
+    const qint64 nowMs = manager.clock()->nowMs();
+    QVector<SensorDetection> scan;
+    for (int i = 0; i < 2; ++i) {
+        SensorDetection det;
+        det.sensorId = "RADAR-LATENCY";
+        det.sourceType = DetectionSource::Radar;
+        det.position = GeoPosition{34.2 + i * 0.05, -118.1, 100.0};
+        det.confidence = 0.9;
+        det.timestamp = nowMs - 40;
+        det.ingestMonoNs = TimeUtils::monotonicNs() - i * 1000000;
+        scan.append(det);
+    }
+    manager.processDetectionBatch(scan);
+    QCOMPARE(PipelineLatency::snapshot(PipelineStage::Fusion).count, quint64(2));
+    const LatencyHistogramSnapshot receive = PipelineLatency::snapshot(PipelineStage::Receive);
+    QCOMPARE(receive.count, quint64(2));
+    QVERIFY(receive.maxUs <= 40000);
+    
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    const TrackPicturePtr picture = manager.snapshot();
+    QCOMPARE(picture->newestIngestNs, scan[0].ingestMonoNs);
+    QVERIFY(picture->newestReceiveLagUs >= 0);
+    
+    // Plots on a foreign epoch still fuse but cannot date the receive stage
+    SensorDetection foreign = scan[0];
+    foreign.position = GeoPosition{34.5, -118.1, 100.0};
+    foreign.timestamp = 12345;
+    foreign.ingestMonoNs = TimeUtils::monotonicNs();
+    manager.processDetectionBatch({foreign});
+    QCOMPARE(PipelineLatency::snapshot(PipelineStage::Fusion).count, quint64(3));
+    QCOMPARE(PipelineLatency::snapshot(PipelineStage::Receive).count, quint64(2));
+    
+    PipelineLatency::reset();
+    QCOMPARE(PipelineLatency::snapshot(PipelineStage::Fusion).count, quint64(0));
+}
+
+void TestTrackManager::testMetricsRegistry() {
+    MetricsRegistry registry;
+    
+    // Same name and labels, same metric
+    MetricCounter* frames = registry.counter("cuas_frames_total", "Frames", {{"source", "cam1"}});
+    QCOMPARE(registry.counter("cuas_frames_total", "Frames", {{"source", "cam1"}}), frames);
+    MetricCounter* other = registry.counter("cuas_frames_total", "Frames", {{"source", "cam2"}});
+    QVERIFY(other != frames);
+    frames->add(3);
+    frames->add();
+    other->setTotal(10);
+    QCOMPARE(frames->value(), quint64(4));
+    
+    MetricGauge* depth = registry.gauge("cuas_depth", "Queue depth");
+    depth->set(2.5);
+    depth->add(-1.0);
+    QCOMPARE(depth->value(), 1.5);
+    
+    LatencyHistogram* cycle = registry.histogram("cuas_cycle_seconds", "Cycle time");
+    for (int i = 0; i < 100; ++i) cycle->record(1000);
+    
+    // A name reused as another type works but is not exported
+    MetricCounter* detached = registry.counter("cuas_depth", "Not a gauge");
+    QVERIFY(detached);
+    detached->add(7);
+    QCOMPARE(registry.seriesCount(), 4);
+    
+    // Label values are escaped
+    registry.gauge("cuas_label", "Escaping", {{"name", "a\"b\\c\nd"}})->set(1);
+    
+    const QByteArray text = registry.toPrometheusText();
+    QVERIFY(text.contains("# TYPE cuas_frames_total counter\n"));
+    QVERIFY(text.contains("cuas_frames_total{source=\"cam1\"} 4\n"));
+    QVERIFY(text.contains("cuas_frames_total{source=\"cam2\"} 10\n"));
+    QVERIFY(text.contains("# TYPE cuas_depth gauge\ncuas_depth 1.5\n"));
+    QVERIFY(text.contains("# TYPE cuas_cycle_seconds summary\n"));
+    QVERIFY(text.contains("cuas_cycle_seconds{quantile=\"0.5\"} 0.001\n"));
+    QVERIFY(text.contains("cuas_cycle_seconds_sum 0.1\n"));
+    QVERIFY(text.contains("cuas_cycle_seconds_count 100\n"));
+    QVERIFY(text.contains("cuas_label{name=\"a\\\"b\\\\c\\nd\"} 1\n"));
+    QVERIFY(!text.contains(" 7\n"));
+    
+    // A histogram owned elsewhere is exported with its labels
+    LatencyHistogram stage;
+    stage.record(2000);
+    registry.addHistogram("cuas_stage_seconds", "Stage", {{"stage", "fusion"}}, &stage);
+    QVERIFY(registry.toPrometheusText().contains("cuas_stage_seconds{stage=\"fusion\",quantile=\"0.99\"} 0.002\n"));
+    
+    // The track cycle refreshes the process-wide track gauges
+    TrackManager manager;
+    manager.createTrack(GeoPosition{34.0, -118.0, 100.0}, DetectionSource::Radar);
+    QMetaObject::invokeMethod(&manager, "processTrackCycle", Qt::DirectConnection);
+    MetricsRegistry& global = MetricsRegistry::instance();
+    QCOMPARE(global.gauge("cuas_tracks_active", QString())->value(),
+             double(manager.statistics().currentActiveCount));
+    QVERIFY(global.counter("cuas_tracks_created_total", QString())->value() >= 1);
+    QVERIFY(global.toPrometheusText().contains("# TYPE cuas_track_cycle_seconds summary\n"));
+}
+
+void TestTrackManager::testLocalTangentPlane() {
+    const GeoPosition site{34.0522, -118.2437, 120.0};
+    const LocalTangentPlane frame(site);
+    
+    // Exact round trip, including a point 20 km out and 3 km up
+    const GeoPosition far{34.2, -118.05, 3120.0};
+    const GeoPosition back = frame.toGeo(frame.toEnu(far));
+    QVERIFY(std::abs(back.latitude - far.latitude) < 1e-9);
+    QVERIFY(std::abs(back.longitude - far.longitude) < 1e-9);
+    QVERIFY(std::abs(back.altitude - far.altitude) < 1e-4);
+    const EnuVector originEnu = frame.toEnu(site);
+    QVERIFY(originEnu.range() < 1e-6);
+    
+    // Pole and antimeridian
+    const LocalTangentPlane pole(GeoPosition{89.9999, 179.9, 0.0});
+    const GeoPosition across{89.999, -179.9, 50.0};
+    const GeoPosition acrossBack = pole.toGeo(pole.toEnu(across));
+    QVERIFY(std::abs(acrossBack.latitude - across.latitude) < 1e-9);
+    QVERIFY(std::abs(acrossBack.longitude - across.longitude) < 1e-6);
+    
+    // Ground range agrees with the spherical haversine within its model error
+    const GeoPosition near = CoordinateUtils::positionFromBearingDistance(site, 60.0, 3000.0);
+    const EnuVector offset = frame.toEnu(GeoPosition{near.latitude, near.longitude, site.altitude});
+    QVERIFY(std::abs(offset.groundRange() - 3000.0) < 3000.0 * 0.005);
+    QVERIFY(std::abs(offset.azimuthDeg() - 60.0) < 0.5);
+    
+    // First-order conversion stays within a metre of exact at 3 km
+    const EnuVector linear = frame.toEnuLinear(near);
+    QVERIFY(EnuVector::distance(linear, frame.toEnu(near)) < 1.0);
+    const EnuVector step{1200.0, -2500.0, 80.0};
+    QVERIFY(EnuVector::distance(frame.toEnu(frame.toGeoLinear(step)), step) < 1.0);
+    QVERIFY(std::abs(frame.toEnuLinear(frame.toGeoLinear(step)).east - step.east) < 1e-6);
+    
+    // Azimuth and elevation
+    QCOMPARE(EnuVector{0.0, -10.0, 0.0}.azimuthDeg(), 180.0);
+    QCOMPARE(EnuVector{-10.0, 0.0, 0.0}.azimuthDeg(), 270.0);
+    QVERIFY(std::abs(EnuVector{100.0, 0.0, 100.0}.elevationDeg() - 45.0) < 1e-9);
+    
+    // Batch conversion matches the single-point path
+    std::vector<GeoPosition> points;
+    for (int i = 0; i < 37; ++i) {
+        points.push_back(GeoPosition{site.latitude + 0.001 * i, site.longitude - 0.002 * i, 10.0 * i});
+    }
+    std::vector<double> lat, lon, alt;
+    for (const GeoPosition& p : points) {
+        lat.push_back(p.latitude);
+        lon.push_back(p.longitude);
+        alt.push_back(p.altitude);
+    }
+    std::vector<double> east(points.size()), north(points.size()), up(points.size());
+    std::vector<EnuVector> batch(points.size());
+    frame.toEnu(lat.data(), lon.data(), alt.data(), east.data(), north.data(), up.data(),
+                int(points.size()));
+    frame.toEnu(points.data(), batch.data(), int(points.size()));
+    for (size_t i = 0; i < points.size(); ++i) {
+        const EnuVector single = frame.toEnu(points[i]);
+        QVERIFY(std::abs(east[i] - single.east) < 1e-6);
+        QVERIFY(std::abs(north[i] - single.north) < 1e-6);
+        QVERIFY(std::abs(up[i] - single.up) < 1e-6);
+        QVERIFY(EnuVector::distance(batch[i], single) < 1e-6);
+    }
+    
+    // The track table keeps ENU columns in step with its frame
+    TrackTable table;
+    const int row = table.allocate();
+    table.setPosition(row, far);
+    table.setFrameOrigin(site);
+    QVERIFY(EnuVector::distance(table.enuPosition(row), frame.toEnu(far)) < 1e-6);
+}
+
+void TestTrackManager::testTrackToTrackFusion() {
+    // Covariance intersection of crossed ellipses is tighter than either
+    // input and never tighter than the independent (Kalman) combination
+    const EnuVector a{0.0, 0.0, 10.0};
+    const EnuVector b{10.0, 0.0, 20.0};
+    PositionCovariance pa;
+    pa.ee = 100.0; pa.nn = 1.0; pa.uu = 4.0;
+    PositionCovariance pb;
+    pb.ee = 1.0; pb.nn = 100.0; pb.uu = 4.0;
+    EnuVector fused;
+    PositionCovariance fusedCov;
+    const double w = TrackToTrackFusion::covarianceIntersection(a, pa, b, pb, fused, fusedCov);
+    QVERIFY(std::abs(w - 0.5) < 1e-9);
+    QVERIFY(fusedCov.ee < pa.ee && fusedCov.nn < pb.nn);
+    QVERIFY(fusedCov.ee > 1.0 / (1.0 / pa.ee + 1.0 / pb.ee));
+    QVERIFY(std::abs(fused.east - 10.0 * 100.0 / 101.0) < 1e-6);
+    QVERIFY(std::abs(fused.up - 15.0) < 1e-9);
+
+    // A much better estimate takes the fusion over
+    PositionCovariance sharp;
+    sharp.ee = sharp.nn = sharp.uu = 1.0;
+    PositionCovariance loose;
+    loose.ee = loose.nn = loose.uu = 400.0;
+    QCOMPARE(TrackToTrackFusion::covarianceIntersection(a, sharp, b, loose, fused, fusedCov), 1.0);
+    QCOMPARE(fused.east, 0.0);
+    QVERIFY(TrackToTrackFusion::mahalanobisSquared(a, pa, b, pb) < 1.0);
+
+    // Three nodes see one drone; node B also has a second one far off
+    const GeoPosition site{34.0, -118.0, 100.0};
+    const LocalTangentPlane frame(site);
+    auto track = [&](const QString& id, double east, double north, double sigma) {
+        TrackSnapshot t;
+        t.trackId = id;
+        t.state = TrackState::Active;
+        t.position = frame.toGeoLinear(EnuVector{east, north, 50.0});
+        t.covariance.ee = t.covariance.nn = t.covariance.uu = sigma * sigma;
+        return t;
+    };
+
+    auto local = std::make_shared<TrackPicture>();
+    local->tracks.append(track("TRK-0007", 0.0, 0.0, 5.0));
+    local->tracks.last().threatLevel = 2;
+
+    TrackToTrackFusion fusion;
+    fusion.setNodeId("C2-B");
+    QSignalSpy updatedSpy(&fusion, &TrackToTrackFusion::systemTrackUpdated);
+    QSignalSpy droppedSpy(&fusion, &TrackToTrackFusion::systemTrackDropped);
+    fusion.setLocalPicture(local);
+    TrackSnapshot remote = track("TRK-0003", 6.0, -4.0, 5.0);
+    remote.threatLevel = 4;
+    fusion.updateRemoteTrack("C2-A", remote);
+    fusion.updateRemoteTrack("C2-C", track("TRK-0011", -3.0, 5.0, 8.0));
+    fusion.updateRemoteTrack("C2-A", track("TRK-0004", 3000.0, 0.0, 5.0));
+    // Node C has two tracks by the drone; only one may join it
+    fusion.updateRemoteTrack("C2-C", track("TRK-0012", 1.0, 1.0, 8.0));
+    fusion.fuse();
+
+    QCOMPARE(fusion.statistics().systemTracks, 3);
+    QCOMPARE(fusion.statistics().multiSourceTracks, 1);
+    const QString id = fusion.systemTrackIdFor("C2-B", "TRK-0007");
+    QCOMPARE(id, QString("C2-A/TRK-0003"));    // Smallest member names it
+    QCOMPARE(fusion.systemTrackIdFor("C2-A", "TRK-0003"), id);
+    QCOMPARE(fusion.systemTrackIdFor("C2-A", "TRK-0004"), QString("C2-A/TRK-0004"));
+    QCOMPARE(fusion.systemTrackIdFor("C2-C", "TRK-0012"), id);   // The closer of C's two
+    QCOMPARE(fusion.systemTrackIdFor("C2-C", "TRK-0011"), QString("C2-C/TRK-0011"));
+    QCOMPARE(updatedSpy.count(), 3);
+
+    SystemTrack drone;
+    for (const SystemTrack& system : fusion.systemTracks()) {
+        if (system.systemTrackId == id) drone = system;
+    }
+    QCOMPARE(drone.localTrackId, QString("TRK-0007"));
+    QCOMPARE(drone.fused.threatLevel, 4);
+    QVERIFY(drone.fused.covariance.ee <= 25.0 + 1e-9);   // Equal inputs add no certainty under CI
+    const EnuVector at = frame.toEnuLinear(drone.fused.position);
+    QVERIFY(at.groundRange() < 5.0);
+
+    // Another node fusing the same members names it the same
+    auto pictureA = std::make_shared<TrackPicture>();
+    pictureA->tracks.append(remote);
+    TrackToTrackFusion peer;
+    peer.setNodeId("C2-A");
+    peer.setLocalPicture(pictureA);
+    peer.updateRemoteTrack("C2-B", local->tracks.first());
+    peer.fuse();
+    QCOMPARE(peer.systemTrackIdFor("C2-B", "TRK-0007"), id);
+
+    // Nothing moved: no updates. Losing node A renames the drone after the
+    // smallest member left and drops A's lone track.
+    updatedSpy.clear();
+    fusion.fuse();
+    QCOMPARE(updatedSpy.count(), 0);
+    fusion.dropRemoteNode("C2-A");
+    fusion.fuse();
+    QVERIFY(fusion.systemTrackIdFor("C2-B", "TRK-0007") != id);
+    QCOMPARE(droppedSpy.count(), 2);
+    QCOMPARE(fusion.statistics().systemTracks, 2);
+}
+
+void TestTrackManager::testCheckpointRestore() {
+    const qint64 t0 = 1700000000000LL;
+    VirtualClock clock(t0);
+    TrackManagerConfig config = m_manager->config();   // Coast after 1 s, drop after 3 s
+    config.enableImmFilter = true;
+    TrackManager source;
+    source.setConfig(config);
+    source.setClock(&clock);
+    
+    GeoPosition base;
+    base.latitude = 34.0522;
+    base.longitude = -118.2437;
+    base.altitude = 100.0;
+    auto offset = [&base](double northM) {
+        GeoPosition pos = base;
+        pos.latitude += northM / 111000.0;
+        return pos;
+    };
+    
+    // Last updated at t0 + 2500 (fresh), t0 + 2000 (stale) and t0 (old)
+    const QString fresh = source.createTrack(offset(0.0), DetectionSource::Radar);
+    const QString stale = source.createTrack(offset(2000.0), DetectionSource::Radar);
+    const QString old = source.createTrack(offset(4000.0), DetectionSource::Radar);
+    for (int i = 1; i <= 5; ++i) {
+        clock.setTime(t0 + i * 500);
+        source.updateTrack(fresh, offset(i * 10.0));
+        if (i <= 4) source.updateTrack(stale, offset(2000.0 + i * 10.0));
+    }
+    source.setTrackThreatLevel(fresh, 4);
+    
+    QVector<QPair<TrackHandle, QByteArray>> tracks;
+    source.checkpointTracks(nullptr, tracks);
+    QCOMPARE(tracks.size(), 3);
+    const QByteArray state = source.checkpointState();
+    QVector<QByteArray> records;
+    QByteArray freshRecord;
+    for (const auto& track : tracks) {
+        QVERIFY(!track.second.isEmpty());
+        records.append(track.second);
+        if (track.first == source.track(fresh)->handle()) freshRecord = track.second;
+    }
+    
+    // Aged on restore: the stale track coasts and the old one is gone
+    clock.setTime(t0 + 3200);
+    TrackManager restored;
+    restored.setConfig(config);
+    restored.setClock(&clock);
+    QSignalSpy created(&restored, &TrackManager::trackCreated);
+    QCOMPARE(restored.restoreCheckpoint(state, records), 2);
+    QCOMPARE(created.count(), 2);
+    QVERIFY(restored.track(old) == nullptr);
+    QCOMPARE(restored.track(stale)->state(), TrackState::Coasting);
+    
+    Track* freshAfter = restored.track(fresh);
+    QVERIFY(freshAfter != nullptr);
+    QCOMPARE(freshAfter->state(), TrackState::Active);
+    QCOMPARE(freshAfter->handle(), source.track(fresh)->handle());
+    QCOMPARE(freshAfter->threatLevel(), 4);
+    QCOMPARE(freshAfter->lastUpdateMs(), t0 + 2500);
+    QCOMPARE(freshAfter->positionHistory().size(), source.track(fresh)->positionHistory().size());
+    const TrackSnapshot* freshSnapshot = restored.snapshot()->find(fresh);
+    QVERIFY(freshSnapshot && freshSnapshot->covariance.isValid());
+    
+    // Everything, filter slot included, comes back as it was saved
+    const QVector<TrackHandle> freshHandle{freshAfter->handle()};
+    restored.checkpointTracks(&freshHandle, tracks);
+    QCOMPARE(tracks.size(), 1);
+    QCOMPARE(tracks[0].second, freshRecord);
+    
+    // Ids continue after the restored ones, and a live picture is not overwritten
+    const QString next = restored.createTrack(offset(8000.0), DetectionSource::Radar);
+    QVERIFY(next != fresh && next != stale && next != old);
+    QCOMPARE(restored.restoreCheckpoint(state, records), -1);
+    
+    // A listed track that is gone comes back empty, which deletes its record
+    const QVector<TrackHandle> handles{source.track(old)->handle(), freshAfter->handle()};
+    restored.checkpointTracks(&handles, tracks);
+    QCOMPARE(tracks.size(), 2);
+    QVERIFY(tracks[0].second.isEmpty());
+    QVERIFY(!tracks[1].second.isEmpty());
+    
+    // An unreadable state leaves the manager empty
+    TrackManager corrupt;
+    corrupt.setConfig(config);
+    QCOMPARE(corrupt.restoreCheckpoint(QByteArray("junk"), records), -1);
+    QCOMPARE(corrupt.trackCount(), 0);
+}
+
+void TestTrackManager::testTrackStateHistory() {
+    // One track flying north at 10 m/s, a picture every 100 ms
+    auto picture = [](qint64 timeMs, double latitude, bool withTrack) {
+        auto p = std::make_shared<TrackPicture>();
+        p->timestampMs = timeMs;
+        if (withTrack) {
+            TrackSnapshot track;
+            track.trackId = "TRK-1";
+            track.handle = 1;
+            track.position = GeoPosition{latitude, 179.9999, 100.0};
+            track.velocity.north = 10.0;
+            p->tracks.append(track);
+            p->indexById.insert(track.trackId, 0);
+            p->indexByHandle.insert(track.handle, 0);
+        }
+        return TrackPicturePtr(p);
+    };
+    const double step = 1.0 / 111320.0;   // Degrees of latitude per metre, roughly
+
+    TrackStateHistory history(4);
+    QVector<TrackSnapshot> states;
+    QVERIFY(!history.statesAt(1000, states));
+
+    // Six pictures through a ring of four keeps the last four
+    for (int i = 0; i < 6; ++i) history.record(picture(1000 + i * 100, 51.0 + i * step, true));
+    history.record(picture(1200, 0.0, true));   // Not newer: ignored
+    QCOMPARE(history.size(), 4);
+    QCOMPARE(history.oldestMs(), qint64(1200));
+    QCOMPARE(history.newestMs(), qint64(1500));
+
+    QVERIFY(!history.statesAt(1199, states));
+    QVERIFY(states.isEmpty());
+
+    // Exactly on a picture, then between two
+    QVERIFY(history.statesAt(1300, states));
+    QCOMPARE(states.size(), 1);
+    QVERIFY(qAbs(states.first().position.latitude - (51.0 + 3 * step)) < 1e-9);
+    QVERIFY(history.statesAt(1425, states));
+    QVERIFY(qAbs(states.first().position.latitude - (51.0 + 4.25 * step)) < 1e-9);
+    QCOMPARE(states.first().trackId, QString("TRK-1"));
+
+    // Past the newest picture it flies on, 10 m/s for 200 ms
+    QVERIFY(history.statesAt(1700, states));
+    double north = CoordinateUtils::haversineDistance(GeoPosition{51.0 + 5 * step, 179.9999, 100.0},
+                                                      states.first().position);
+    QVERIFY(qAbs(north - 2.0) < 0.05);
+    // ...but not beyond the extrapolation limit
+    QVERIFY(history.statesAt(1500 + 10 * TrackStateHistory::MAX_EXTRAPOLATION_MS, states));
+    north = CoordinateUtils::haversineDistance(GeoPosition{51.0 + 5 * step, 179.9999, 100.0},
+                                               states.first().position);
+    QVERIFY(qAbs(north - 10.0) < 0.5);
+
+    // A track gone by the next picture is extrapolated, not dropped
+    history.record(picture(1600, 0.0, false));
+    QVERIFY(history.statesAt(1550, states));
+    QCOMPARE(states.size(), 1);
+    QVERIFY(history.statesAt(1600, states));
+    QVERIFY(states.isEmpty());
+
+    // Longitude interpolates the short way across the antimeridian
+    TrackStateHistory wrap;
+    TrackPicturePtr east = picture(0, 0.0, true);
+    auto west = std::make_shared<TrackPicture>(*picture(100, 0.0, true));
+    west->tracks[0].position.longitude = -179.9999;
+    wrap.record(east);
+    wrap.record(west);
+    QVERIFY(wrap.statesAt(50, states));
+    QVERIFY(qAbs(qAbs(states.first().position.longitude) - 180.0) < 1e-6);
+
+    history.clear();
+    QCOMPARE(history.size(), 0);
+    QVERIFY(!history.statesAt(1500, states));
+}
+
+void TestTrackManager::testTrackClassifier() {
+    auto velocity = [](double north, double east, double down) {
+        VelocityVector v;
+        v.north = north;
+        v.east = east;
+        v.down = down;
+        return v;
+    };
+
+    // Row 0 hovers, row 2 flies a 90 deg/s circle at 10 m/s, row 1 is unused
+    TrackFeatureBank bank;
+    bank.reset(0);
+    bank.reset(2);
+    for (int i = 0; i < 10; ++i) {
+        bank.observeMotion(0, i * 100, velocity(0.5, 0.0, i % 2 ? 1.0 : -1.0));
+        const double heading = qDegreesToRadians(9.0 * i);
+        bank.observeMotion(2, i * 100, velocity(10.0 * std::cos(heading), 10.0 * std::sin(heading), 0.0));
+    }
+    bank.observeRcs(0, 0.01);
+    bank.observeRcs(0, 0.01);
+    bank.observeRcs(0, -1.0);        // No return: ignored
+    bank.observeRf(0, "DJI_OcuSync");
+    bank.observeRf(0, "Generic_2.4GHz");
+    QCOMPARE(bank.observations(0), 10);
+    QCOMPARE(bank.observations(1), 0);
+
+    const int rows[] = {0, 2};
+    float features[2 * TRACK_FEATURE_COUNT];
+    bank.gather(rows, 2, features);
+    auto feature = [&](TrackFeature f, int i) { return features[f * 2 + i]; };
+    QVERIFY(qAbs(feature(FeatureMeanSpeed, 0) - 0.5f) < 1e-5f);
+    QVERIFY(qAbs(feature(FeatureMeanClimbRate, 0) - 1.0f) < 1e-5f);
+    QCOMPARE(feature(FeatureHoverRatio, 0), 1.0f);
+    QCOMPARE(feature(FeatureMeanTurnRate, 0), 0.0f);     // Too slow to hold a heading
+    QVERIFY(qAbs(feature(FeatureMeanLogRcs, 0) + 2.0f) < 1e-5f);
+    QCOMPARE(feature(FeatureRcsSeen, 0), 1.0f);
+    QVERIFY(qAbs(feature(FeatureRfRatio, 0) - 0.2f) < 1e-5f);
+    QCOMPARE(feature(FeatureUasLinkRatio, 0), 0.5f);
+    QVERIFY(qAbs(feature(FeatureMeanSpeed, 1) - 10.0f) < 1e-4f);
+    QVERIFY(feature(FeatureSpeedStdDev, 1) < 1e-4f);
+    QVERIFY(qAbs(feature(FeatureMeanTurnRate, 1) - 90.0f) < 1e-3f);
+    QVERIFY(feature(FeatureTurnRateStdDev, 1) < 1e-3f);
+    QCOMPARE(feature(FeatureHoverRatio, 1), 0.0f);
+    QCOMPARE(feature(FeatureRcsSeen, 1), 0.0f);
+
+    // A released row starts again from nothing
+    bank.release(0);
+    QCOMPARE(bank.observations(0), 0);
+
+    // The prior: a small hovering return on a DJI link against an airliner
+    TrackFeatureBank fleet;
+    fleet.reset(0);
+    fleet.reset(2);
+    for (int i = 0; i < 10; ++i) {
+        fleet.observeMotion(0, i * 100, velocity(1.0, 0.5, 0.0));
+        fleet.observeRcs(0, 0.02);
+        fleet.observeRf(0, "DJI_Lightbridge");
+        fleet.observeMotion(2, i * 100, velocity(80.0, 10.0, -5.0));
+        fleet.observeRcs(2, 100.0);
+    }
+    fleet.gather(rows, 2, features);
+    TrackClassifier classifier;
+    float probabilities[2];
+    classifier.predict(features, 2, probabilities);
+    QVERIFY(probabilities[0] > 0.8f);
+    QVERIFY(probabilities[1] < 0.2f);
+
+    // One track at a time gives what the batch did
+    for (int i = 0; i < 2; ++i) {
+        float single[TRACK_FEATURE_COUNT];
+        for (int f = 0; f < TRACK_FEATURE_COUNT; ++f) single[f] = features[f * 2 + i];
+        float probability = 0.0f;
+        classifier.predict(single, 1, &probability);
+        QVERIFY(qAbs(probability - probabilities[i]) < 1e-6f);
+    }
+
+    // Weights survive a JSON round trip; a malformed model is refused
+    bool ok = false;
+    const TrackClassifierModel loaded = TrackClassifierModel::fromJson(TrackClassifierModel::prior().toJson(), &ok);
+    QVERIFY(ok);
+    TrackClassifier reloaded;
+    QVERIFY(reloaded.setModel(loaded));
+    float again[2];
+    reloaded.predict(features, 2, again);
+    QVERIFY(qAbs(again[0] - probabilities[0]) < 1e-6f);
+    TrackClassifierModel broken = loaded;
+    broken.outputWeights.removeLast();
+    QVERIFY(!broken.isValid());
+    QVERIFY(!reloaded.setModel(broken));
+
+    // Through the manager: a track needs a few updates before it is scored
+    TrackManager manager;
+    const QString id = manager.createTrack(GeoPosition{51.0, -1.0, 100.0}, DetectionSource::Radar);
+    QCOMPARE(manager.classifyTracks(), 0);
+    for (int i = 1; i <= 6; ++i) {
+        manager.updateTrack(id, GeoPosition{51.0 + i * 1e-5, -1.0, 100.0});
+    }
+    QCOMPARE(manager.classifyTracks(), 1);
+    const double confidence = manager.track(id)->classificationConfidence();
+    QVERIFY(confidence > 0.0 && confidence <= 0.99);
+    QCOMPARE(manager.classifyTracks(), 0);        // Nothing moved since
+
+    // Classifications set outright are left alone
+    manager.setTrackClassification(id, TrackClassification::Hostile);
+    manager.updateTrack(id, GeoPosition{51.0, -1.0, 100.0});
+    QCOMPARE(manager.classifyTracks(), 0);
+    QCOMPARE(manager.track(id)->classificationConfidence(), 1.0);
+}
+
+void TestTrackManager::testCoverageRaster() {
+    CoverageSite site;
+    site.siteId = "RADAR-1";
+    site.position = GeoPosition{51.0, -1.0, 10.0};
+    site.maxRangeM = 30000.0;
+    const LocalTangentPlane plane(GeoPosition{51.0, -1.0, 0.0});
+    auto at = [&](double east, double north, double altitude) {
+        GeoPosition p = plane.toGeo(EnuVector{east, north, 0.0});
+        p.altitude = altitude;
+        return p;
+    };
+
+    // Flat ground: low targets are seen close in, not past the horizon
+    const TerrainModel flat;
+    const CoverageRasterPtr open = CoverageRaster::build(site, flat);
+    QVERIFY(open->isFor(site.position));
+    QVERIFY(open->canSee(at(1000.0, 0.0, 1.0)));
+    QVERIFY(open->canSee(at(0.0, -4000.0, 1.0)));
+    QVERIFY(!open->canSee(at(0.0, 25000.0, 1.0)));
+    QVERIFY(open->canSee(at(0.0, 25000.0, 100.0)));
+    QVERIFY(!open->canSee(at(0.0, 31000.0, 500.0)));       // Out of range
+
+    // A 100 m ridge 700 m east hides what is low behind it, not to the west
+    const int columns = 61;
+    const int rows = 41;
+    QVector<float> heights(columns * rows, 0.0f);
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 39; column <= 41; ++column) heights[row * columns + column] = 100.0f;
+    }
+    TerrainModel ridge;
+    ridge.setGrid(50.98, -1.03, 0.001, columns, rows, heights);
+    QVERIFY(ridge.hasGrid());
+    QVERIFY(ridge.fingerprint() != flat.fingerprint());
+    QVERIFY(qAbs(ridge.elevationM(51.0, -0.99) - 100.0) < 1e-3);
+    const CoverageRasterPtr masked = CoverageRaster::build(site, ridge);
+    QVERIFY(!masked->canSee(at(1400.0, 0.0, 10.0)));
+    QVERIFY(masked->canSee(at(1400.0, 0.0, 400.0)));
+    QVERIFY(masked->canSee(at(-1400.0, 0.0, 10.0)));
+    QVERIFY(masked->maskHeightM(at(1400.0, 0.0, 0.0)) > 100.0);
+
+    // A fixed sector and a blind zone close in
+    CoverageSite sector = site;
+    sector.headingDeg = 90.0;
+    sector.fieldOfViewDeg = 90.0;
+    sector.minRangeM = 200.0;
+    const CoverageRasterPtr east = CoverageRaster::build(sector, flat);
+    QVERIFY(east->canSee(at(500.0, 0.0, 50.0)));
+    QVERIFY(!east->canSee(at(0.0, 500.0, 50.0)));
+    QVERIFY(!east->canSee(at(100.0, 0.0, 50.0)));
+    GeoPosition moved = site.position;
+    moved.latitude += 0.001;
+    QVERIFY(!east->isFor(moved));
+
+    // Cached rasters come back cell for cell, and only for the same key
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("radar.cov");
+    QVERIFY(masked->save(path));
+    const quint64 key = CoverageRaster::keyFor(site, ridge, CoverageRasterConfig());
+    QCOMPARE(masked->key(), key);
+    QVERIFY(CoverageRaster::keyFor(site, flat, CoverageRasterConfig()) != key);
+    const CoverageRasterPtr loaded = CoverageRaster::load(path, site, key);
+    QVERIFY(loaded);
+    QCOMPARE(loaded->azimuthBins(), masked->azimuthBins());
+    QCOMPARE(loaded->rangeBins(), masked->rangeBins());
+    const int ridgeBin = masked->azimuthBins() / 4;
+    QCOMPARE(loaded->cell(ridgeBin, 56), masked->cell(ridgeBin, 56));
+    QVERIFY(!loaded->canSee(at(1400.0, 0.0, 10.0)));
+    QVERIFY(!CoverageRaster::load(path, site, key + 1));
+
+    // The service builds in the background, then reads its cache on a restart
+    CoverageServiceConfig config;
+    config.cacheDirectory = dir.filePath("coverage");
+    {
+        CoverageService service;
+        service.setConfig(config);
+        service.setTerrain(std::make_shared<TerrainModel>(ridge));
+        service.setSite(site);
+        QVERIFY(service.waitForBuilds(10000));
+        QVERIFY(service.raster(site.siteId));
+        QVERIFY(!service.canSee(site.siteId, at(1400.0, 0.0, 10.0)));
+        QVERIFY(!service.canSee("UNKNOWN", at(100.0, 0.0, 10.0)));
+        QCOMPARE(service.stats().built, quint64(1));
+    }
+    CoverageService restarted;
+    restarted.setConfig(config);
+    restarted.setTerrain(std::make_shared<TerrainModel>(ridge));
+    restarted.setSite(site);
+    QVERIFY(restarted.waitForBuilds(10000));
+    QCOMPARE(restarted.stats().loaded, quint64(1));
+    QCOMPARE(restarted.stats().built, quint64(0));
+    QVERIFY(restarted.canSee(site.siteId, at(-1400.0, 0.0, 10.0)));
+}
+
+void TestTrackManager::testEngagementEnvelope() {
+    const GeoPosition base{51.0, -1.0, 20.0};
+    const LocalTangentPlane plane(base);
+    auto at = [&plane](double east, double north, double up) {
+        return plane.toGeoLinear(EnuVector{east, north, up});
+    };
+
+    // The model is asked once per cell; limits and range are applied around it
+    EngagementLimits limits;
+    limits.minElevationDeg = 0.0;
+    limits.maxElevationDeg = 60.0;
+    limits.noFireSectors.append(AzimuthSector{80.0, 100.0});
+    int calls = 0;
+    const EngagementEnvelopePtr envelope = EngagementEnvelope::build(base, 100.0, 1000.0, limits,
+        [&calls](double rangeM, double, double) {
+            ++calls;
+            EnvelopeCell cell;
+            cell.pk = 0.5f;
+            cell.timeToEffectSec = static_cast<float>(rangeM / 100.0);
+            return cell;
+        });
+    QVERIFY(envelope->isFor(base));
+    QVERIFY(calls > 0 && calls < envelope->rangeBins() * envelope->azimuthBins() * envelope->elevationBins());
+    EnvelopeCell cell = envelope->at(at(0.0, 510.0, 50.0));
+    QVERIFY(cell.feasible());
+    QVERIFY(qAbs(cell.pk - 0.5f) < 1e-6f);
+    QVERIFY(qAbs(cell.timeToEffectSec - 5.25f) < 1e-3f);
+    QVERIFY(envelope->at(at(0.0, 990.0, 10.0)).feasible());
+    QVERIFY(!envelope->at(at(0.0, 1010.0, 10.0)).feasible());       // Out of range
+    QVERIFY(!envelope->at(at(0.0, 90.0, 10.0)).feasible());
+    QVERIFY(!envelope->at(at(0.0, 500.0, -20.0)).feasible());       // Below the horizon
+    QVERIFY(!envelope->at(at(0.0, 200.0, 500.0)).feasible());       // Above the elevation limit
+    QVERIFY(!envelope->at(at(510.0, 0.0, 10.0)).feasible());        // No-fire sector
+    QVERIFY(AzimuthSector({350.0, 10.0}).contains(5.0));
+    QVERIFY(!AzimuthSector({350.0, 10.0}).contains(20.0));
+
+    // A laser's dwell grows with range, and its envelope ends where the dwell outlasts an engagement
+    DirectedEnergySystem laser("DE-1");
+    laser.setPosition(base);
+    const EngagementEnvelopePtr beam = laser.envelope();
+    QCOMPARE(laser.envelope(), beam);
+    const EnvelopeCell nearBeam = beam->at(at(0.0, 300.0, 20.0));
+    const EnvelopeCell farBeam = beam->at(at(0.0, 900.0, 20.0));
+    QVERIFY(nearBeam.feasible() && farBeam.feasible());
+    QVERIFY(farBeam.timeToEffectSec > 2.0f * nearBeam.timeToEffectSec);
+    DESystemConfig laserConfig = laser.config();
+    laserConfig.maxEngagementTimeMs = 4000;
+    laser.setConfig(laserConfig);
+    QVERIFY(laser.envelope() != beam);
+    QVERIFY(laser.envelope()->at(at(0.0, 300.0, 20.0)).feasible());
+    QVERIFY(!laser.envelope()->at(at(0.0, 900.0, 20.0)).feasible());
+
+    // Limits and moving rebuild it
+    laser.setEngagementLimits(limits);
+    QVERIFY(!laser.envelope()->at(at(300.0, 0.0, 20.0)).feasible());
+    QVERIFY(laser.envelope()->at(at(-300.0, 0.0, 20.0)).feasible());
+    const GeoPosition moved = at(0.0, 100.0, 0.0);
+    laser.setPosition(moved);
+    QVERIFY(laser.envelope()->isFor(moved));
+
+    // An interceptor takes its fly-out to arrive, and cannot climb past its ceiling
+    KineticInterceptor interceptor("KIN-1");
+    interceptor.setPosition(base);
+    const EnvelopeCell nearShot = interceptor.envelope()->at(at(0.0, 300.0, 10.0));
+    const EnvelopeCell farShot = interceptor.envelope()->at(at(0.0, 900.0, 10.0));
+    QVERIFY(nearShot.feasible() && farShot.feasible());
+    QVERIFY(farShot.timeToEffectSec > nearShot.timeToEffectSec + 5.0f);
+    QVERIFY(!interceptor.envelope()->at(at(0.0, 1400.0, 10.0)).feasible());     // Past its flight time
+    QVERIFY(farShot.pk < nearShot.pk);
+    QVERIFY(!interceptor.envelope()->at(at(0.0, 1000.0, 600.0)).feasible());
+
+    // The assigner scores effectors with an envelope from it: nothing in a no-fire sector
+    WeaponTargetAssigner assigner;
+    AssignmentEffector effector;
+    effector.effectorId = "DE-1";
+    effector.effectorType = "DIRECTED_ENERGY";
+    effector.position = base;
+    effector.minRange = 100.0;
+    effector.maxRange = 1000.0;
+    effector.envelope = envelope;
+    assigner.updateEffector(effector);
+    AssignmentThreat north;
+    north.trackId = "T1";
+    north.position = at(0.0, 510.0, 50.0);
+    north.classification = TrackClassification::Hostile;
+    north.threatLevel = 4;
+    AssignmentThreat east = north;
+    east.trackId = "T2";
+    east.position = at(510.0, 0.0, 50.0);
+    assigner.updateThreat(north);
+    assigner.updateThreat(east);
+    QVERIFY(assigner.score("T1", "DE-1") > 0.0);
+    QCOMPARE(assigner.score("T2", "DE-1"), 0.0);
+    const QVector<WeaponAssignment> plan = assigner.solve();
+    QCOMPARE(plan.size(), 1);
+    QCOMPARE(plan[0].trackId, QString("T1"));
+    QVERIFY(qAbs(plan[0].pk - 0.5) < 1e-6);
+    QVERIFY(qAbs(plan[0].timeToInterceptSec - 5.25) < 1e-3);
+}
+
+void TestTrackManager::testEffectorTelemetry() {
+    const GeoPosition base{51.0, -1.0, 20.0};
+    const LocalTangentPlane plane(base);
+
+    DirectedEnergySystem laser("DE-T");
+    laser.setPosition(base);
+    DESystemConfig config = laser.config();
+    config.dwellTimeRequiredS = 0.05;
+    config.cooldownTimeMs = 50;
+    laser.setConfig(config);
+
+    QVector<EffectorEvent> events;
+    connect(&laser, &EffectorInterface::telemetry,
+            [&events](const EffectorEvent& event) { events.append(event); });
+
+    // Every status change is pushed with the health as of the change
+    laser.initialize();
+    QTRY_VERIFY_WITH_TIMEOUT(laser.isReady(), 5000);
+    QVERIFY(events.size() >= 2);
+    QCOMPARE(events.first().type, EffectorEventType::StatusChanged);
+    QCOMPARE(events.first().health.status, EffectorStatus::Initializing);
+    QCOMPARE(events.last().health.status, EffectorStatus::Ready);
+    QCOMPARE(events.last().effectorId, QString("DE-T"));
+    QVERIFY(events.last().timestampMs > 0);
+
+    // Callbacks run once at completion, unless removed or their context is gone
+    QObject owner;
+    QList<bool> outcomes;
+    laser.addCompletionCallback(&owner, [&outcomes](bool success) { outcomes.append(success); });
+    int stale = 0;
+    const quint64 removed = laser.addCompletionCallback(&owner, [&stale](bool) { ++stale; });
+    laser.removeCompletionCallback(removed);
+    auto* gone = new QObject;
+    laser.addCompletionCallback(gone, [&stale](bool) { ++stale; });
+    delete gone;
+
+    events.clear();
+    QVERIFY(laser.engage(plane.toGeoLinear(EnuVector{0.0, 550.0, 0.0})));
+    QTRY_COMPARE(outcomes.size(), 1);
+    QVERIFY(outcomes.first());
+    QCOMPARE(stale, 0);
+
+    // Started, complete, then the cooldown; completion pushed before the status moves on
+    QVector<EffectorEventType> types;
+    for (const EffectorEvent& event : qAsConst(events)) {
+        if (event.type != EffectorEventType::StatusChanged) types.append(event.type);
+    }
+    QCOMPARE(types, QVector<EffectorEventType>({EffectorEventType::EngagementStarted,
+                                                EffectorEventType::EngagementComplete}));
+    int complete = -1;
+    int cooldown = -1;
+    for (int i = 0; i < events.size(); ++i) {
+        if (events[i].type == EffectorEventType::EngagementComplete) complete = i;
+        if (events[i].health.status == EffectorStatus::Cooldown && cooldown < 0) cooldown = i;
+    }
+    QVERIFY(complete >= 0 && cooldown > complete);
+    QVERIFY(events[complete].success);
+
+    // Once only
+    QTRY_VERIFY(laser.isReady());
+    QVERIFY(laser.engage(plane.toGeoLinear(EnuVector{0.0, 550.0, 0.0})));
+    QTRY_VERIFY(laser.isReady());
+    QCOMPARE(outcomes.size(), 1);
+}
+
+void TestTrackManager::testDemTileStore() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QCOMPARE(DemTileStore::tileName(51, -2), QString("N51W002.hgt"));
+    QCOMPARE(DemTileStore::tileName(-1, 0), QString("S01E000.hgt"));
+
+    // West tile rises 10 m a post eastward, with a void in its north-west
+    // corner; the east tile is flat at 500 m
+    QVector<qint16> ramp(11 * 11);
+    for (int row = 0; row < 11; ++row) {
+        for (int column = 0; column < 11; ++column) ramp[row * 11 + column] = qint16(100 + 10 * column);
+    }
+    ramp[0] = DemTileStore::VOID_POST;
+    QVERIFY(DemTileStore::writeTile(dir.filePath(DemTileStore::tileName(51, -2)), 11, ramp));
+    QVERIFY(DemTileStore::writeTile(dir.filePath(DemTileStore::tileName(51, -1)), 11, QVector<qint16>(121, 500)));
+    QVERIFY(!DemTileStore::writeTile(dir.filePath("short.hgt"), 11, ramp.mid(1)));
+
+    DemTileStore store(dir.path(), 1);
+    QCOMPARE(store.tileCount(), 2);
+    double elevation = 0.0;
+    QVERIFY(store.elevationM(51.5, -1.5, elevation));
+    QVERIFY(qAbs(elevation - 150.0) < 1e-9);
+    QVERIFY(!store.elevationM(51.95, -1.95, elevation));   // Next to the void
+    QVERIFY(!store.elevationM(40.0, -1.5, elevation));     // No tile
+
+    // A batch across both tiles; with room for one, the first is unmapped
+    const double latitudes[] = { 51.5, 51.5, 51.5, 40.0 };
+    const double longitudes[] = { -1.75, -1.25, -0.5, -1.5 };
+    double elevations[4];
+    QCOMPARE(store.elevationsM(latitudes, longitudes, elevations, 4, -1.0), 3);
+    QVERIFY(qAbs(elevations[0] - 125.0) < 1e-9);
+    QVERIFY(qAbs(elevations[1] - 175.0) < 1e-9);
+    QVERIFY(qAbs(elevations[2] - 500.0) < 1e-9);
+    QCOMPARE(elevations[3], -1.0);
+    const DemTileStoreStats stats = store.stats();
+    QCOMPARE(stats.tileLoads, quint64(2));
+    QCOMPARE(stats.tileEvictions, quint64(1));
+    QCOMPARE(stats.openTiles, 1);
+
+    // Under a terrain model: the grid first, then the tiles, then the base
+    auto terrain = std::make_shared<TerrainModel>(5.0);
+    const quint64 flat = terrain->fingerprint();
+    terrain->setDemStore(std::make_shared<DemTileStore>(dir.path()));
+    QVERIFY(terrain->fingerprint() != flat);
+    QVERIFY(qAbs(terrain->elevationM(51.5, -1.75) - 125.0) < 1e-9);
+    QCOMPARE(terrain->elevationM(40.0, -1.5), 5.0);
+    terrain->setGrid(51.49, -1.26, 0.01, 3, 3, QVector<float>(9, 20.0f));
+    QVERIFY(qAbs(terrain->elevationM(51.5, -1.25) - 20.0) < 1e-9);
+    double batch[4];
+    terrain->elevationsM(latitudes, longitudes, batch, 4);
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(qAbs(batch[i] - terrain->elevationM(latitudes[i], longitudes[i])) < 1e-9);
+    }
+    QVERIFY(qAbs(terrain->toMslM(GeoPosition{51.5, -1.75, 30.0}) - 155.0) < 1e-9);
+    QVERIFY(qAbs(terrain->toAglM(51.5, -1.75, 155.0) - 30.0) < 1e-9);
+
+    // Radar plots over rising ground come out above the ground under them
+    RadarTrackReport report{};
+    report.rangeM = 1000.0f;
+    report.azimuthDeg = 90.0f;
+    RadarGeoConverter converter;
+    converter.setTerrain(terrain);
+    converter.setSite(GeoPosition{51.5, -1.75, 10.0});
+    GeoPosition plot;
+    VelocityVector velocity;
+    converter.convert(report, plot, velocity);
+    QVERIFY(qAbs(plot.altitude - 10.0) < 1e-3);
+    converter.toGroundLevel(&plot.latitude, &plot.longitude, &plot.altitude, 1);
+    const double expected = 10.0 + 125.0 - terrain->elevationM(plot.latitude, plot.longitude);
+    QVERIFY(expected < 10.0);
+    QVERIFY(qAbs(plot.altitude - expected) < 1e-9);
+    const GeoPosition direct = report.toGeoPosition(GeoPosition{51.5, -1.75, 10.0}, terrain.get());
+    QVERIFY(qAbs(direct.altitude - expected) < 0.01);
+}
+
+void TestTrackManager::testCooperativeReceiver() {
+    // Reference extended squitters: an even/odd airborne position pair at
+    // 38000 ft, a ground velocity and an identification
+    const QByteArray even = QByteArray::fromHex("8D40621D58C382D690C8AC2863A7");
+    const QByteArray odd = QByteArray::fromHex("8D40621D58C386435CC412692AD6");
+    const QByteArray velocity = QByteArray::fromHex("8D485020994409940838175B284F");
+    const QByteArray ident = QByteArray::fromHex("8D4840D6202CC371C32CE0576098");
+    auto bytes = [](const QByteArray& message) { return reinterpret_cast<const quint8*>(message.constData()); };
+
+    AdsbMessage message;
+    QVERIFY(AdsbDecoder::decodeModeS(bytes(even), 14, message));
+    QCOMPARE(message.icao, quint32(0x40621D));
+    QVERIFY(message.hasCpr && !message.cprOdd);
+    QVERIFY(qAbs(message.altitudeM - 38000 * 0.3048) < 1e-6);
+    double latitude = 0.0, longitude = 0.0;
+    QVERIFY(AdsbDecoder::decodeCprLocal(52.258, 3.918, false, message.cprLatitude, message.cprLongitude,
+                                        latitude, longitude));
+    QVERIFY(qAbs(latitude - 52.25720) < 1e-4);
+    QVERIFY(qAbs(longitude - 3.91937) < 1e-4);
+    QVERIFY(AdsbDecoder::decodeModeS(bytes(velocity), 14, message));
+    QVERIFY(message.hasVelocity);
+    QVERIFY(qAbs(message.velocity.speed() / 0.514444 - 159.2) < 0.1);
+    QVERIFY(qAbs(message.velocity.heading() - 182.88) < 0.01);
+    QVERIFY(qAbs(message.velocity.down * 60.0 / 0.3048 + 832.0) < 1e-6);
+    QVERIFY(AdsbDecoder::decodeModeS(bytes(ident), 14, message));
+    QCOMPARE(message.callsign, QString("KLM1023"));
+    QByteArray corrupt = ident;
+    corrupt[6] = char(corrupt[6] ^ 0x01);
+    QVERIFY(!AdsbDecoder::decodeModeS(bytes(corrupt), 14, message));
+
+    // Beast frames with a 0x1a in the timestamp, so escaped
+    auto beast = [](const QByteArray& message) {
+        QByteArray frame("\x1a\x33", 2);
+        const QByteArray body = QByteArray("\x00\x1a\x00\x00\x00\x01\x80", 7) + message;
+        for (char c : body) {
+            frame.append(c);
+            if (c == '\x1a') frame.append(c);
+        }
+        return frame;
+    };
+
+    VirtualClock clock(1000000);
+    CooperativeReceiver receiver("COOP-TEST");
+    receiver.setClock(&clock);
+    receiver.setPosition(GeoPosition{52.258, 3.918, 0.0});
+    CooperativeReceiverConfig config;
+    config.friendlyIds = QStringList{"40621d"};
+    receiver.setConfig(config);
+    QVector<SensorDetection> batch;
+    int batches = 0;
+    connect(&receiver, &SensorInterface::detectionBatch, this,
+            [&batch, &batches](const QVector<SensorDetection>& detections) {
+        batch = detections;
+        ++batches;
+    });
+
+    // Two receivers hear the same squitter; a stream split mid-frame
+    const QByteArray stream = beast(even) + beast(even) + beast(velocity);
+    receiver.ingestBeast(stream.constData(), 10);
+    receiver.ingestBeast(stream.constData() + 10, stream.size() - 10);
+    const QByteArray remoteId = R"({"id":"1581F5FJD","lat":52.259,"lon":3.917,"alt":120,"speed":10,"track":90,"vspeed":0,"rssi":-70})";
+    receiver.ingestRemoteId(remoteId.constData(), remoteId.size());
+    receiver.ingestRemoteId("not json", 8);
+
+    CooperativeReceiver::Stats stats = receiver.stats();
+    QCOMPARE(stats.messages, qint64(4));
+    QCOMPARE(stats.duplicates, qint64(1));
+    QCOMPARE(stats.ignored, qint64(1));
+    QCOMPARE(receiver.targetCount(), 3);
+
+    // The aircraft with only a velocity has no fix to forward
+    QCOMPARE(receiver.flushTargets(), 2);
+    QCOMPARE(batches, 1);
+    QCOMPARE(batch.size(), 2);
+    SensorDetection aircraft;
+    SensorDetection drone;
+    for (const SensorDetection& det : batch) {
+        QCOMPARE(det.sourceType, DetectionSource::Cooperative);
+        if (fixedString(det.info.cooperative.id) == "40621D") aircraft = det;
+        if (fixedString(det.info.cooperative.id) == "1581F5FJD") drone = det;
+    }
+    QCOMPARE(int(aircraft.info.cooperative.classification), int(TrackClassification::Friendly));
+    QCOMPARE(int(drone.info.cooperative.classification), int(TrackClassification::Neutral));
+    QVERIFY(aircraft.info.cooperative.adsb);
+    QVERIFY(!drone.info.cooperative.adsb);
+    QVERIFY(qAbs(aircraft.position.latitude - 52.25720) < 1e-4);
+    QVERIFY(qAbs(drone.position.altitude - 120.0) < 1e-9);
+    QVERIFY(qAbs(drone.velocity.east - 10.0) < 1e-9);
+
+    // Updates inside the forward interval are held and folded together
+    const QByteArray oddFrame = beast(odd);
+    const QByteArray evenFrame = beast(even);
+    receiver.ingestBeast(oddFrame.constData(), oddFrame.size());
+    clock.advance(600);
+    receiver.ingestBeast(evenFrame.constData(), evenFrame.size());
+    QCOMPARE(receiver.flushTargets(), 0);
+    clock.advance(500);
+    QCOMPARE(receiver.flushTargets(), 1);
+    QCOMPARE(receiver.stats().coalesced, qint64(1));
+
+    // A radar track at the aircraft's place takes on its identity
+    m_manager->clearAllTracks();
+    SensorDetection plot;
+    plot.sensorId = "RADAR-TEST";
+    plot.position = aircraft.position;
+    plot.position.longitude += 0.0002;      // ~14 m east
+    plot.confidence = 0.9;
+    plot.timestamp = QDateTime::currentMSecsSinceEpoch();
+    plot.sourceType = DetectionSource::Radar;
+    m_manager->processDetectionBatch({plot});
+    QCOMPARE(m_manager->trackCount(), 1);
+    m_manager->processDetectionBatch({aircraft});
+    QCOMPARE(m_manager->trackCount(), 1);
+    Track* track = m_manager->tracksInRadius(aircraft.position, 100.0).first();
+    QCOMPARE(track->classification(), TrackClassification::Friendly);
+    QVERIFY(track->hasSource(DetectionSource::Cooperative));
+    m_manager->clearAllTracks();
+
+    // Silent targets are forgotten
+    clock.advance(config.targetTimeoutMs + 1);
+    receiver.flushTargets();
+    QCOMPARE(receiver.targetCount(), 0);
+    QCOMPARE(receiver.stats().expired, qint64(3));
+}
+
+void TestTrackManager::testAutoMerge() {
+    const qint64 t0 = 1700000000000LL;
+    VirtualClock clock(t0);
+    TrackManager manager;
+    TrackManagerConfig config = m_manager->config();
+    config.dropTimeoutMs = 60000;
+    config.coastingTimeoutMs = 60000;
+    config.mergeBudgetUs = 0;
+    manager.setConfig(config);
+    manager.setClock(&clock);
+
+    // One drone seen by radar and, 15 m off, by RF; a second drone flies
+    // alongside 150 m away
+    GeoPosition radar{34.0522, -118.2437, 100.0};
+    auto offsetEast = [](GeoPosition pos, double metres) {
+        pos.longitude += metres / (111320.0 * std::cos(qDegreesToRadians(pos.latitude)));
+        return pos;
+    };
+    const QString radarId = manager.createTrack(radar, DetectionSource::Radar);
+    const QString rfId = manager.createTrack(offsetEast(radar, 15.0), DetectionSource::RFDetector);
+    const QString otherId = manager.createTrack(offsetEast(radar, 150.0), DetectionSource::Radar);
+
+    // Too little shared history to judge at first
+    manager.step();
+    QCOMPARE(manager.statistics().autoMerges, qint64(0));
+
+    for (int i = 0; i < 8; ++i) {
+        clock.advance(1000);
+        radar.latitude += 10.0 / 111320.0;
+        manager.updateTrack(radarId, radar);
+        manager.updateTrack(rfId, offsetEast(radar, 15.0));
+        manager.updateTrack(otherId, offsetEast(radar, 150.0));
+        manager.step();
+    }
+
+    const TrackManager::Statistics stats = manager.statistics();
+    QCOMPARE(stats.autoMerges, qint64(1));
+    QVERIFY(stats.mergePairsTested >= 3);
+    QVERIFY(stats.mergeSweeps > 0);
+    QCOMPARE(stats.mergeBudgetExhausted, qint64(0));
+    TrackPicturePtr picture = manager.snapshot();
+    QCOMPARE(picture->tracks.size(), 2);
+    QVERIFY(picture->find(radarId) && picture->find(otherId));
+    QVERIFY(!picture->find(rfId));
+    QVERIFY(manager.track(radarId)->hasSource(DetectionSource::RFDetector));
+
+    // A track the operator classified outright survives the merge
+    const QString manualId = manager.createTrack(offsetEast(radar, 150.0 + 12.0), DetectionSource::RFDetector);
+    manager.setTrackClassification(manualId, TrackClassification::Hostile, 1.0);
+    for (int i = 0; i < 8; ++i) {
+        clock.advance(1000);
+        radar.latitude += 10.0 / 111320.0;
+        manager.updateTrack(radarId, radar);
+        manager.updateTrack(otherId, offsetEast(radar, 150.0));
+        manager.updateTrack(manualId, offsetEast(radar, 162.0));
+        manager.step();
+    }
+    QCOMPARE(manager.statistics().autoMerges, qint64(2));
+    picture = manager.snapshot();
+    QVERIFY(picture->find(manualId) && !picture->find(otherId));
+}
+
+void TestTrackManager::testTrackSlabRecycling() {
+    TrackSlab slab;
+    Track* a = slab.acquire("A");
+    Track* b = slab.acquire("B");
+    Track* c = slab.acquire("C");
+    QCOMPARE(slab.capacity(), TrackSlab::SLOTS_PER_CHUNK);
+    slab.release(b);
+    QCOMPARE(slab.size(), 2);
+    QVERIFY(slab.live().contains(a) && slab.live().contains(c) && !slab.live().contains(b));
+    QCOMPARE(slab.acquire("D"), b);  // Last released, first reused
+    QCOMPARE(b->trackId(), QString("D"));
+    for (int i = 0; i < TrackSlab::SLOTS_PER_CHUNK; ++i) {
+        slab.acquire(QString::number(i));
+    }
+    QCOMPARE(slab.size(), 3 + TrackSlab::SLOTS_PER_CHUNK);
+    QCOMPARE(slab.capacity(), 2 * TrackSlab::SLOTS_PER_CHUNK);
+    slab.clear();
+    QCOMPARE(slab.size(), 0);
+    
+    // Through the manager: a dropped track's object comes back reset, under
+    // a new generation, without the old track's listeners
+    TrackManager manager;
+    GeoPosition pos{34.0522, -118.2437, 100.0};
+    const QString firstId = manager.createTrack(pos, DetectionSource::Radar);
+    Track* first = manager.track(firstId);
+    const quint32 generation = first->generation();
+    manager.setTrackClassification(firstId, TrackClassification::Hostile, 1.0);
+    first->setEngaged(true);
+    first->setAssociatedCameraId("CAM-1");
+    int updates = 0;
+    connect(first, &Track::updated, this, [&updates]() { ++updates; });
+    
+    manager.dropTrack(firstId);
+    manager.pruneDroppedTracks();
+    QVERIFY(!manager.track(firstId));
+    QVERIFY(first->generation() != generation);
+    
+    const QString secondId = manager.createTrack(pos, DetectionSource::RFDetector);
+    QVERIFY(secondId != firstId);
+    Track* second = manager.track(secondId);
+    QCOMPARE(second, first);
+    QCOMPARE(second->trackId(), secondId);
+    QCOMPARE(second->handle(), manager.handleOf(secondId));
+    QCOMPARE(second->classification(), TrackClassification::Pending);
+    QVERIFY(!second->isEngaged());
+    QVERIFY(second->associatedCameraId().isEmpty());
+    QCOMPARE(second->detectionSources().size(), 1);
+    QVERIFY(second->hasSource(DetectionSource::RFDetector));
+    updates = 0;
+    manager.updateTrack(secondId, pos);
+    QCOMPARE(updates, 0);
+    
+    // Live tracks are what the manager reports, across chunks
+    for (int i = 0; i < TrackSlab::SLOTS_PER_CHUNK + 10; ++i) {
+        pos.latitude += 0.01;
+        manager.createTrack(pos, DetectionSource::Radar);
+    }
+    QCOMPARE(manager.allTracks().size(), TrackSlab::SLOTS_PER_CHUNK + 11);
+    manager.step();
+    QCOMPARE(manager.snapshot()->tracks.size(), TrackSlab::SLOTS_PER_CHUNK + 11);
+    manager.clearAllTracks();
+    QCOMPARE(manager.trackCount(), 0);
+}
+
+void TestTrackManager::testTaskScheduler() {
+    TaskScheduler scheduler(3);
+    
+    // A diamond: the join starts only after both branches, run after run
+    std::atomic<int> root{0}, branches{0}, joinSaw{-1};
+    TaskGraph graph(TaskPriority::Realtime, &scheduler);
+    const int a = graph.add([&]() { root++; });
+    const int b = graph.add([&]() { if (root.load() == 1) branches++; });
+    const int c = graph.add([&]() { if (root.load() == 1) branches++; });
+    const int d = graph.add([&]() { joinSaw = branches.load(); });
+    graph.precede(a, b);
+    graph.precede(a, c);
+    graph.precede(b, d);
+    graph.precede(c, d);
+    for (int run = 0; run < 3; ++run) {
+        root = 0;
+        branches = 0;
+        joinSaw = -1;
+        graph.run();
+        graph.wait();
+        QVERIFY(graph.isDone());
+        QCOMPARE(joinSaw.load(), 2);
+    }
+    
+    // Waiting inside a task helps rather than deadlocking a one-worker pool
+    TaskScheduler single(1);
+    std::atomic<int> inner{0};
+    TaskGraph outer(TaskPriority::Interactive, &single);
+    outer.add([&]() {
+        TaskGraph nested(TaskPriority::Interactive, &single);
+        for (int i = 0; i < 8; ++i) nested.add([&]() { inner++; });
+        nested.run();
+        nested.wait();
+    });
+    outer.run();
+    outer.wait();
+    QCOMPARE(inner.load(), 8);
+    
+    // With the worker held, a later Realtime task still starts before an
+    // earlier Background one
+    QMutex gateMutex;
+    QWaitCondition gate;
+    bool held = true;
+    std::atomic<bool> blocking{false};
+    single.submit([&]() {
+        QMutexLocker locker(&gateMutex);
+        blocking = true;
+        while (held) gate.wait(&gateMutex);
+    }, TaskPriority::Background);
+    QTRY_VERIFY(blocking.load());
+    QMutex orderMutex;
+    QStringList order;
+    TaskGraph background(TaskPriority::Background, &single);
+    background.add([&]() { QMutexLocker locker(&orderMutex); order.append("background"); });
+    TaskGraph realtime(TaskPriority::Realtime, &single);
+    realtime.add([&]() { QMutexLocker locker(&orderMutex); order.append("realtime"); });
+    background.run();
+    realtime.run();
+    {
+        QMutexLocker locker(&gateMutex);
+        held = false;
+        gate.wakeAll();
+    }
+    realtime.wait();
+    background.wait();
+    QCOMPARE(order, QStringList({"realtime", "background"}));
+    
+    const TaskScheduler::Stats stats = single.stats();
+    QCOMPARE(stats.executed[int(TaskPriority::Interactive)], quint64(9));
+    QCOMPARE(stats.executed[int(TaskPriority::Background)], quint64(2));
+    QVERIFY(single.queueLatency(TaskPriority::Realtime).count >= 1);
+    QCOMPARE(QString(TaskScheduler::priorityKey(TaskPriority::Interactive)), QString("interactive"));
+    
+    // A batch gated on the scheduler associates exactly as a serial one
+    TrackManagerConfig config;
+    config.maxTracks = 1000;
+    config.autoMerge = false;
+    TrackManager serial;
+    config.parallelGatingMinPlots = 0;
+    serial.setConfig(config);
+    TrackManager parallel;
+    config.parallelGatingMinPlots = 1;
+    parallel.setConfig(config);
+    
+    auto makeScan = [](double drift) {
+        QVector<SensorDetection> scan;
+        for (int i = 0; i < 400; ++i) {
+            SensorDetection det;
+            det.sensorId = "RADAR-TEST";
+            det.position = GeoPosition{34.0 + (i / 20) * 0.01 + drift, -118.0 + (i % 20) * 0.01, 100.0};
+            det.confidence = 0.9;
+            det.timestamp = QDateTime::currentMSecsSinceEpoch();
+            det.sourceType = DetectionSource::Radar;
+            scan.append(det);
+        }
+        return scan;
+    };
+    QSignalSpy serialSpy(&serial, &TrackManager::tracksUpdated);
+    QSignalSpy parallelSpy(&parallel, &TrackManager::tracksUpdated);
+    serial.processDetectionBatch(makeScan(0.0));
+    parallel.processDetectionBatch(makeScan(0.0));
+    serial.processDetectionBatch(makeScan(0.0001));
+    parallel.processDetectionBatch(makeScan(0.0001));
+    QCOMPARE(parallel.trackCount(), 400);
+    QCOMPARE(parallel.trackCount(), serial.trackCount());
+    QCOMPARE(parallel.statistics().correlationSuccessCount, serial.statistics().correlationSuccessCount);
+    QCOMPARE(parallelSpy.count(), 2);
+    QCOMPARE(parallelSpy.last().at(0).toStringList().size(), 400);
+}
+
+void TestTrackManager::testTieredRates() {
+    const qint64 t0 = 1700000000000LL;
+    VirtualClock clock(t0);
+    TrackManager manager;
+    TrackManagerConfig config;
+    config.enableKalmanFilter = false;
+    config.autoMerge = false;
+    config.updateRateHz = 10;
+    config.tieredRates = true;
+    config.priorityRateHz = 25;
+    config.backgroundRateHz = 1;
+    manager.setConfig(config);
+    manager.setClock(&clock);
+    
+    TrackChangeSet reported;
+    connect(&manager, &TrackManager::tracksChanged, this,
+            [&reported](const TrackChangeSet& changes) { reported = changes; });
+    auto cycle = [&](qint64 advanceMs) {
+        reported = TrackChangeSet();
+        clock.advance(advanceMs);
+        manager.step();
+    };
+    
+    GeoPosition pos{34.0522, -118.2437, 100.0};
+    const QString idP = manager.createTrack(pos, DetectionSource::Radar);
+    pos.longitude += 0.02;
+    const QString idR = manager.createTrack(pos, DetectionSource::Radar);
+    pos.longitude += 0.02;
+    const QString idB = manager.createTrack(pos, DetectionSource::Radar);
+    const TrackHandle priority = manager.handleOf(idP);
+    const TrackHandle routine = manager.handleOf(idR);
+    const TrackHandle background = manager.handleOf(idB);
+    cycle(0);
+    QCOMPARE(reported.size(), 3);
+    
+    manager.setUpdateTiers({{priority, TrackUpdateTier::Priority}, {background, TrackUpdateTier::Background}});
+    QCOMPARE(manager.updateTier(priority), TrackUpdateTier::Priority);
+    QCOMPARE(manager.updateTier(routine), TrackUpdateTier::Routine);
+    QCOMPARE(manager.updateTier(INVALID_TRACK_HANDLE), TrackUpdateTier::Routine);
+    const double routineLat = manager.snapshot()->find(routine)->position.latitude;
+    
+    // Between routine cycles only the priority track is refreshed and reported
+    auto moveAll = [&](double dLat) {
+        for (const QString& id : {idP, idR, idB}) {
+            GeoPosition moved = manager.track(id)->position();
+            moved.latitude += dLat;
+            manager.updateTrack(id, moved);
+        }
+    };
+    moveAll(0.001);
+    cycle(40);
+    QCOMPARE(reported.size(), 1);
+    QVERIFY(reported.fieldsFor(priority) & TrackChangePosition);
+    TrackPicturePtr picture = manager.snapshot();
+    QCOMPARE(picture->find(priority)->position.latitude, manager.track(idP)->position().latitude);
+    QCOMPARE(picture->find(routine)->position.latitude, routineLat);
+    QCOMPARE(picture->tracks.size(), 3);
+    
+    // The routine cycle takes the rest, the background track's first report due
+    cycle(40);
+    QCOMPARE(reported.size(), 2);
+    QVERIFY(reported.fieldsFor(routine) & TrackChangePosition);
+    QVERIFY(reported.fieldsFor(background) & TrackChangePosition);
+    QCOMPARE(manager.snapshot()->find(routine)->position.latitude, manager.track(idR)->position().latitude);
+    
+    // Then the background track waits out its second
+    const double backgroundLat = manager.snapshot()->find(background)->position.latitude;
+    moveAll(0.001);
+    cycle(40);
+    QCOMPARE(reported.size(), 1);
+    moveAll(0.001);
+    cycle(80);
+    QCOMPARE(reported.size(), 2);
+    QCOMPARE(reported.fieldsFor(background), quint32(TrackChangeNone));
+    QCOMPARE(manager.snapshot()->find(background)->position.latitude, backgroundLat);
+    
+    // A threat level change goes out on the next cycle whatever the tier
+    manager.setTrackThreatLevel(idB, 3);
+    cycle(40);
+    QVERIFY(reported.fieldsFor(background) & TrackChangeThreatLevel);
+    QVERIFY(reported.fieldsFor(background) & TrackChangePosition);
+    QCOMPARE(manager.snapshot()->find(background)->threatLevel, 3);
+    
+    // A cycle short of the routine one with nothing due publishes nothing
+    const quint64 sequence = manager.snapshot()->sequence;
+    cycle(20);
+    QVERIFY(reported.isEmpty());
+    QCOMPARE(manager.snapshot()->sequence, sequence);
+}
+
+void TestTrackManager::testChaCha20Poly1305() {
+    // RFC 8439 section 2.8.2
+    quint8 key[ChaCha20Poly1305::KEY_SIZE];
+    for (int i = 0; i < ChaCha20Poly1305::KEY_SIZE; ++i) {
+        key[i] = quint8(0x80 + i);
+    }
+    const QByteArray nonce = QByteArray::fromHex("070000004041424344454647");
+    const QByteArray aad = QByteArray::fromHex("50515253c0c1c2c3c4c5c6c7");
+    const QByteArray plain("Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+                           "for the future, sunscreen would be it.");
+    const QByteArray cipher = QByteArray::fromHex(
+        "d31a8d34648e60db7b86afbc53ef7ec2a4aded51296e08fea9e2b5a736ee62d6"
+        "3dbea45e8ca9671282fafb69da92728b1a71de0a9e060b2905d6a5b67ecd3b36"
+        "92ddbd7f2d778b8c9803aee328091b58fab324e4fad675945585808b4831d7bc"
+        "3ff4def08e4b7a9de576d26586cec64b6116");
+    const QByteArray tag = QByteArray::fromHex("1ae10b594f09e26a7e902ecbd0600691");
+    auto bytes = [](const QByteArray& data) { return reinterpret_cast<const quint8*>(data.constData()); };
+    
+    const ChaCha20Poly1305 aead(key);
+    QByteArray data = plain;
+    QByteArray sealedTag(ChaCha20Poly1305::TAG_SIZE, '\0');
+    aead.seal(bytes(nonce), bytes(aad), aad.size(), reinterpret_cast<quint8*>(data.data()), data.size(),
+              reinterpret_cast<quint8*>(sealedTag.data()));
+    QCOMPARE(data, cipher);
+    QCOMPARE(sealedTag, tag);
+    
+    QVERIFY(aead.open(bytes(nonce), bytes(aad), aad.size(), reinterpret_cast<quint8*>(data.data()),
+                      data.size(), bytes(tag)));
+    QCOMPARE(data, plain);
+    
+    // Any altered byte fails, and leaves the ciphertext as it was
+    QByteArray forged = cipher;
+    forged[40] = char(forged[40] ^ 0x01);
+    const QByteArray before = forged;
+    QVERIFY(!aead.open(bytes(nonce), bytes(aad), aad.size(), reinterpret_cast<quint8*>(forged.data()),
+                       forged.size(), bytes(tag)));
+    QCOMPARE(forged, before);
+    QByteArray otherAad = aad;
+    otherAad[0] = char(otherAad[0] ^ 0x80);
+    data = cipher;
+    QVERIFY(!aead.open(bytes(nonce), bytes(otherAad), otherAad.size(), reinterpret_cast<quint8*>(data.data()),
+                       data.size(), bytes(tag)));
+    
+    // Section 2.5.2
+    const QByteArray macKey = QByteArray::fromHex(
+        "85d6be7857556d337f4452fe42d506a80103808afb0db2fd4abff6af4149f51b");
+    const QByteArray message("Cryptographic Forum Research Group");
+    QByteArray mac(ChaCha20Poly1305::TAG_SIZE, '\0');
+    ChaCha20Poly1305::poly1305(bytes(macKey), bytes(message), message.size(),
+                               reinterpret_cast<quint8*>(mac.data()));
+    QCOMPARE(mac, QByteArray::fromHex("a8061dc1305136c6c22b8baf0c0127a9"));
 }
 
 QTEST_MAIN(TestTrackManager)
@@ -1,7 +1,45 @@
 #include <QtTest>
+#include <QBuffer>
+#include <QSemaphore>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtEndian>
 #include "video/VideoStreamManager.h"
 #include "video/FileVideoSource.h"
+#include "video/GigEVideoSource.h"
+#include "video/KlvEncoder.h"
+#include "video/CameraDetectionFuser.h"
+#include "video/CaptureService.h"
+#include "video/CameraScheduler.h"
+#include "video/CameraSlewController.h"
+#include "video/CorrelationTracker.h"
+#include "video/MatroskaReader.h"
+#include "video/MatroskaWriter.h"
+#include "video/MotionCueStage.h"
+#include "video/MotionKernels.h"
 #include "video/VideoOverlayRenderer.h"
+#include "video/PacketRingBuffer.h"
+#include "video/OnvifPtzClient.h"
+#include "video/PTZCommandScheduler.h"
+#include "video/PTZController.h"
+#include "video/RecordingStorage.h"
+#include "video/RoiTrackingStage.h"
+#include "video/RtpDepacketizer.h"
+#include "video/RtpPacketizer.h"
+#include "video/RtspClient.h"
+#include "video/RtpStream.h"
+#include "video/SimulatedSceneRenderer.h"
+#include "video/SlewControlLoop.h"
+#include "video/ThermalProcessor.h"
+#include "video/TrackVideoIndex.h"
+#include "video/VideoDecoderBackend.h"
+#include "core/TrackManager.h"
+#include "utils/CoordinateUtils.h"
+#include "utils/LocalTangentPlane.h"
+#include "video/VideoFrameDistributor.h"
+#include "video/VideoRecorder.h"
+#include "video/VideoRestreamer.h"
+#include "video/VisualDetector.h"
 
 using namespace CounterUAS;
 
@@ -12,8 +50,32 @@ private slots:
     void initTestCase();
     void cleanupTestCase();
     void testStreamManager();
+    void testStreamProfiles();
     void testVideoOverlay();
+    void testOverlayLayerDirtyRegions();
     void testCameraDefinition();
+    void testPacketRingBuffer();
+    void testEventRecordingClip();
+    void testRecordingStorage();
+    void testCaptureService();
+    void testTrackVideoIndex();
+    void testKlvMetadata();
+    void testFrameDistributor();
+    void testIndexedFileReplay();
+    void testGigECaptureLoop();
+    void testRtpIngest();
+    void testDecodeShedding();
+    void testRestreamFanOut();
+    void testPredictiveSlewLoop();
+    void testPTZCommandScheduler();
+    void testOnvifPtzClient();
+    void testCameraScheduler();
+    void testVisualDetectorBatching();
+    void testRoiTracking();
+    void testMotionCueing();
+    void testCameraFusion();
+    void testThermalProcessing();
+    void testSimulatedSceneRendering();
     
 private:
     VideoStreamManager* m_manager;
@@ -48,6 +110,67 @@ void TestVideoPipeline::testStreamManager() {
     QCOMPARE(m_manager->activeStreamCount(), 0);
 }
 
+void TestVideoPipeline::testStreamProfiles() {
+    GigETransportRegistry::registerTransport("test-profiles", 100, []() {
+        auto transport = std::make_unique<SimulatedGigETransport>();
+        transport->setFeature("Width", 320);
+        transport->setFeature("Height", 240);
+        return std::unique_ptr<GigETransport>(std::move(transport));
+    });
+    
+    CameraDefinition camera;
+    camera.cameraId = "PROFILE-CAM";
+    camera.sourceType = "GigE";
+    camera.streamUrl = "gige:///main";
+    StreamProfile sub;
+    sub.name = "sub";
+    sub.streamUrl = "gige:///sub";
+    sub.resolution = QSize(640, 360);
+    camera.profiles.append(sub);
+    
+    VideoStreamManager manager;
+    QCOMPARE(manager.addStream(camera), camera.cameraId);
+    QCOMPARE(manager.activeProfile(camera.cameraId), QString("main"));
+    
+    // A grid tile needs only the substream, which is opened in the first place
+    QObject tile;
+    VideoDeliveryPolicy policy;
+    policy.targetSize = QSize(320, 180);
+    const int subscription = manager.subscribeFrames(camera.cameraId, &tile, policy,
+                                                     [](const VideoFrame&, qint64, const QSize&) {});
+    manager.startStream(camera.cameraId);
+    QCOMPARE(manager.activeProfile(camera.cameraId), QString("sub"));
+    
+    // Made primary, it cuts over to the main stream on the new stream's first frame
+    QSignalSpy frames(&manager, &VideoStreamManager::videoFrameReady);
+    QSignalSpy switched(&manager, &VideoStreamManager::streamProfileChanged);
+    VideoSource* substream = manager.stream(camera.cameraId);
+    manager.setPrimaryStream(camera.cameraId);
+    QCOMPARE(manager.activeProfile(camera.cameraId), QString("sub"));
+    QTRY_COMPARE_WITH_TIMEOUT(manager.activeProfile(camera.cameraId), QString("main"), 5000);
+    QCOMPARE(switched.count(), 1);
+    QCOMPARE(switched.first().at(1).toString(), QString("main"));
+    QVERIFY(manager.stream(camera.cameraId) != substream);
+    QVERIFY(manager.stream(camera.cameraId)->isStreaming());
+    QVERIFY(frames.count() > 0);
+    
+    // A tile larger than the substream needs the main stream too
+    camera.cameraId = "PROFILE-CAM-2";
+    manager.addStream(camera);
+    policy.targetSize = QSize(1280, 720);
+    const int large = manager.subscribeFrames(camera.cameraId, &tile, policy,
+                                              [](const VideoFrame&, qint64, const QSize&) {});
+    QCOMPARE(manager.activeProfile(camera.cameraId), QString("main"));
+    policy.targetSize = QSize(640, 480);
+    manager.setDeliveryPolicy(large, policy);
+    QCOMPARE(manager.activeProfile(camera.cameraId), QString("sub"));
+    
+    manager.unsubscribeFrames(large);
+    manager.unsubscribeFrames(subscription);
+    manager.removeAllStreams();
+    GigETransportRegistry::unregisterTransport("test-profiles");
+}
+
 void TestVideoPipeline::testVideoOverlay() {
     VideoOverlayRenderer renderer;
     
@@ -80,6 +203,60 @@ void TestVideoPipeline::testVideoOverlay() {
     QCOMPARE(result.size(), frame.size());
 }
 
+void TestVideoPipeline::testOverlayLayerDirtyRegions() {
+    VideoOverlayRenderer renderer;
+    
+    OverlayTelemetry telemetry;
+    telemetry.cameraName = "CAM-01";
+    telemetry.timestamp = 1700000000000;    // Fixed, so the clock stays clean
+    renderer.setTelemetry(telemetry);
+    
+    TrackOverlay track;
+    track.trackId = "TRK-0001";
+    track.boundingBox = {100, 100, 50, 50, "CAM-01", 0};
+    track.classification = TrackClassification::Hostile;
+    renderer.addTrackOverlay(track);
+    
+    const QSize frameSize(640, 480);
+    const QRect frameRect(QPoint(0, 0), frameSize);
+    
+    // The first update paints everything
+    QCOMPARE(renderer.updateLayer(frameSize).boundingRect(), frameRect);
+    QCOMPARE(renderer.layer().size(), frameSize);
+    QVERIFY(qAlpha(renderer.layer().pixel(100, 125)) > 0);
+    QCOMPARE(qAlpha(renderer.layer().pixel(320, 240)), 0);
+    const quint64 painted = renderer.layerRevision();
+    
+    // Nothing changed, nothing repainted
+    QVERIFY(renderer.updateLayer(frameSize).isEmpty());
+    QCOMPARE(renderer.layerRevision(), painted);
+    QVERIFY(renderer.layerChangedSince(painted).isEmpty());
+    
+    // Moving the track dirties its old and new places only
+    track.boundingBox = {300, 200, 50, 50, "CAM-01", 0};
+    renderer.addTrackOverlay(track);
+    const QRegion moved = renderer.updateLayer(frameSize);
+    QVERIFY(moved.contains(QPoint(100, 125)));
+    QVERIFY(moved.contains(QPoint(300, 225)));
+    QVERIFY(!moved.contains(QPoint(15, frameSize.height() - 12)));     // Telemetry bar
+    QCOMPARE(qAlpha(renderer.layer().pixel(100, 125)), 0);
+    QVERIFY(qAlpha(renderer.layer().pixel(300, 225)) > 0);
+    QCOMPARE(renderer.layerChangedSince(painted), moved.boundingRect());
+    QVERIFY(renderer.layerChangedSince(0).contains(frameRect));
+    
+    // Removing it clears what it covered
+    renderer.removeTrackOverlay("TRK-0001");
+    QVERIFY(!renderer.updateLayer(frameSize).isEmpty());
+    QCOMPARE(qAlpha(renderer.layer().pixel(300, 225)), 0);
+    
+    // The composited frame carries the layer without touching the source
+    QImage frame(frameSize, QImage::Format_RGB32);
+    frame.fill(Qt::black);
+    const QImage result = renderer.renderOverlay(frame);
+    QCOMPARE(result.size(), frameSize);
+    QCOMPARE(frame.pixel(15, frameSize.height() - 12), QColor(Qt::black).rgb());
+}
+
 void TestVideoPipeline::testCameraDefinition() {
     CameraDefinition camera;
     camera.cameraId = "CAM-001";
@@ -93,5 +270,1828 @@ void TestVideoPipeline::testCameraDefinition() {
     QVERIFY(camera.hasPTZ);
 }
 
+void TestVideoPipeline::testPacketRingBuffer() {
+    auto packet = [](int size, qint64 timeMs, bool keyframe) {
+        EncodedPacket p;
+        p.data = QByteArray(size, keyframe ? 'K' : 'P');
+        p.timeMs = timeMs;
+        p.keyframe = keyframe;
+        return p;
+    };
+    
+    PacketRingBuffer ring(1000);
+    
+    // Nothing decodes before the first keyframe
+    QVERIFY(!ring.push(packet(100, 0, false)));
+    QVERIFY(ring.isEmpty());
+    QVERIFY(!ring.push(packet(1001, 0, true)));
+    
+    // GOPs of one keyframe and three deltas, 400 bytes each
+    for (int gop = 0; gop < 5; ++gop) {
+        const qint64 t = gop * 100;
+        QVERIFY(ring.push(packet(100, t, true)));
+        for (int i = 1; i < 4; ++i) {
+            QVERIFY(ring.push(packet(100, t + i * 25, false)));
+        }
+        QVERIFY(ring.bytesUsed() <= ring.capacity());
+    }
+    
+    // Whole GOPs went to make room, so the oldest packet is a keyframe
+    QVERIFY(ring.evictedPackets() > 0);
+    QCOMPARE(ring.bytesUsed(), 800);
+    QVector<EncodedPacket> held = ring.take();
+    QCOMPARE(held.size(), 8);
+    QVERIFY(held.first().keyframe);
+    QCOMPARE(held.first().timeMs, qint64(300));
+    QCOMPARE(held.first().data, QByteArray(100, 'K'));
+    QCOMPARE(held.last().timeMs, qint64(475));
+    QVERIFY(ring.isEmpty());
+    
+    // A span limit drops GOPs the later ones already cover
+    PacketRingBuffer spanned(100000);
+    spanned.setMaxSpanMs(200);
+    for (int gop = 0; gop < 10; ++gop) {
+        spanned.push(packet(10, gop * 100, true));
+        spanned.push(packet(10, gop * 100 + 50, false));
+    }
+    QCOMPARE(spanned.spanMs(), qint64(250));
+    QVERIFY(spanned.take().first().keyframe);
+}
+
+void TestVideoPipeline::testEventRecordingClip() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    
+    VideoRecorder recorder;
+    RecorderConfig config;
+    config.codec = "MJPEG";
+    config.fps = 10.0;
+    config.preBufferSeconds = 1;
+    config.preBufferMegabytes = 1;
+    config.postBufferSeconds = 0;
+    config.eventDirectory = dir.path();
+    recorder.setConfig(config);
+    
+    QSignalSpy finished(&recorder, &VideoRecorder::segmentFinished);
+    
+    QImage image(64, 48, QImage::Format_RGB32);
+    image.fill(Qt::darkGreen);
+    qint64 t = 1000;
+    for (int i = 0; i < 30; ++i, t += 100) {
+        recorder.addFrame(image, t);
+    }
+    
+    QSignalSpy started(&recorder, &VideoRecorder::eventRecordingStarted);
+    recorder.startEventRecording("EVT-1");
+    QCOMPARE(started.count(), 1);
+    for (int i = 0; i < 5; ++i, t += 100) {
+        recorder.addFrame(image, t);
+    }
+    recorder.stopEventRecording();
+    recorder.addFrame(image, t);    // Past the post-event buffer
+    
+    QTRY_COMPARE(finished.count(), 1);
+    const QString clip = finished.first().first().toString();
+    QVERIFY(clip.startsWith(dir.path()));
+    QVERIFY(QFileInfo(clip).size() > 0);
+    
+    // The pre-event buffer held about a second, not all thirty frames
+    const qint64 frames = recorder.recordedFrameCount();
+    QVERIFY(frames >= 5);
+    QVERIFY(frames < 30);
+    QVERIFY(recorder.stats().bytesWritten > 0);
+}
+
+void TestVideoPipeline::testRecordingStorage() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const qint64 megabyte = 1024 * 1024;
+    
+    // A reserved file written in blocks keeps its size and reads back; the
+    // cluster sizes are patched in both the buffer and the file
+    MatroskaWriter::TrackInfo info;
+    info.codecId = "V_MJPEG";
+    info.width = 64;
+    info.height = 48;
+    info.fps = 10.0;
+    const QByteArray frame(20000, 'x');
+    const QString reservedPath = dir.filePath("reserved.mkv");
+    MatroskaWriter writer;
+    writer.setReserve(megabyte);
+    writer.setWriteBlockSize(512 * 1024);
+    QVERIFY(writer.open(reservedPath, info));
+    QCOMPARE(writer.reservedBytes(), megabyte);
+    for (int i = 0; i < 30; ++i) {
+        QVERIFY(writer.writeVideo(frame, i * 100, i % 10 == 0));
+    }
+    writer.close();
+    QCOMPARE(QFileInfo(reservedPath).size(), megabyte);
+    
+    MatroskaReader reader;
+    QVERIFY(reader.open(reservedPath));
+    QCOMPARE(reader.packetCount(), 30);
+    QCOMPARE(reader.keyframeCount(), 3);
+    QCOMPARE(reader.durationMs(), qint64(2900));
+    QByteArray packet;
+    QVERIFY(reader.readPacket(29, packet));
+    QCOMPARE(packet, frame);
+    reader.close();
+    
+    RecordingStorageConfig config;
+    config.directory = dir.filePath("store");
+    config.segmentMegabytes = 1;
+    config.cameraQuotaMegabytes = 3;
+    config.quotaMegabytes = 5;
+    config.minFreeMegabytes = 0;
+    RecordingStorage storage;
+    storage.setConfig(config);
+    QVERIFY(storage.open());
+    QSignalSpy finished(&storage, &RecordingStorage::segmentFinished);
+    QSignalSpy deleted(&storage, &RecordingStorage::segmentDeleted);
+    
+    auto record = [&](const QString& camera, qint64 startMs) {
+        const RecordingStorage::Allocation allocation = storage.allocateSegment(camera, startMs);
+        MatroskaWriter segment;
+        segment.setReserve(allocation.reserveBytes);
+        segment.setWriteBlockSize(allocation.writeBlockBytes);
+        if (!segment.open(allocation.path, info)) return QString();
+        segment.writeVideo(frame, startMs, true);
+        segment.close();
+        storage.finishSegment(allocation.path, segment.durationMs(), segment.bytesWritten());
+        return allocation.path;
+    };
+    
+    // The camera's quota rolls its oldest segment over into the fourth
+    const qint64 t0 = 1700000000000;
+    QStringList first;
+    for (int i = 0; i < 4; ++i) first.append(record("CAM-1", t0 + i * 1000));
+    QCOMPARE(storage.segments("CAM-1"), first.mid(1));
+    QVERIFY(!QFileInfo::exists(first.at(0)));
+    QCOMPARE(QFileInfo(first.at(3)).size(), megabyte);
+    QCOMPARE(storage.cameraBytes("CAM-1"), 3 * megabyte);
+    QCOMPARE(deleted.count(), 1);
+    QCOMPARE(finished.count(), 4);
+    const QVariantMap metadata = finished.last().at(2).toMap();
+    QCOMPARE(metadata.value("cameraId").toString(), QString("CAM-1"));
+    QCOMPARE(metadata.value("startTime").toLongLong(), t0 + 3000);
+    QCOMPARE(storage.stats().segmentsRecycled, quint64(1));
+    
+    // The global quota takes the oldest segment of any camera
+    for (int i = 0; i < 3; ++i) record("CAM-2", t0 + 10000 + i * 1000);
+    QCOMPARE(storage.segments("CAM-1"), first.mid(2));
+    QVERIFY(!QFileInfo::exists(first.at(1)));
+    QCOMPARE(storage.segments("CAM-2").size(), 3);
+    QCOMPARE(storage.stats().bytesUsed, 5 * megabyte);
+    QCOMPARE(storage.stats().preallocationFailures, quint64(0));
+    
+    // A restart finds the same segments
+    RecordingStorage reopened;
+    reopened.setConfig(config);
+    QVERIFY(reopened.open());
+    QCOMPARE(reopened.segments("CAM-1"), storage.segments("CAM-1"));
+    QCOMPARE(reopened.segments("CAM-2"), storage.segments("CAM-2"));
+    QCOMPARE(reopened.stats().bytesUsed, 5 * megabyte);
+    
+    // Segments still being written are never evicted
+    QStringList open;
+    for (int i = 0; i < 4; ++i) open.append(reopened.allocateSegment("CAM-3", t0 + 20000 + i * 1000).path);
+    QCOMPARE(reopened.stats().openSegments, 4);
+    QCOMPARE(reopened.stats().quotaOverruns, quint64(1));
+    QCOMPARE(reopened.segments("CAM-3"), open);
+    for (const QString& path : open) reopened.abandonSegment(path);
+    QCOMPARE(reopened.cameraBytes("CAM-3"), qint64(0));
+}
+
+void TestVideoPipeline::testCaptureService() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    RecordingStorageConfig storageConfig;
+    storageConfig.directory = dir.filePath("store");
+    storageConfig.minFreeMegabytes = 0;
+    RecordingStorage storage;
+    storage.setConfig(storageConfig);
+    QVERIFY(storage.open());
+    
+    CaptureConfig config;
+    config.burstFrames = 6;
+    config.preRollFrames = 3;
+    CaptureService service;
+    service.setConfig(config);
+    service.setStorage(&storage);
+    service.setPreRollCameras(QStringList{"EO-1"});
+    QSignalSpy saved(&service, &CaptureService::captureSaved);
+    QSignalSpy bursts(&service, &CaptureService::burstCompleted);
+    
+    auto frame = [](int shade) {
+        QImage image(64, 48, QImage::Format_RGB32);
+        image.fill(qRgb(shade, shade, shade));
+        return VideoFrame(image);
+    };
+    
+    // Nothing to capture before the camera's first frame
+    CaptureTags tags;
+    tags.engagementId = "ENG-1";
+    tags.trackId = "T-7";
+    QVERIFY(service.snapshot("EO-1", tags).isEmpty());
+    QVERIFY(service.burst("EO-1", tags).isEmpty());
+    
+    for (int i = 0; i < 5; ++i) {
+        service.addFrame("EO-1", frame(i * 10), 1000 + i * 100);
+    }
+    service.addFrame("IR-1", frame(200), 1450);
+    
+    // A snapshot of the latest frame, written by a worker under the camera
+    const QString snapshotId = service.snapshot("IR-1", tags);
+    QVERIFY(!snapshotId.isEmpty());
+    QTRY_COMPARE_WITH_TIMEOUT(saved.count(), 1, 5000);
+    CaptureRecord record = service.capture(snapshotId);
+    QCOMPARE(record.captureId, snapshotId);
+    QCOMPARE(record.cameraId, QString("IR-1"));
+    QCOMPARE(record.frameTimeMs, qint64(1450));
+    QCOMPARE(record.size, QSize(64, 48));
+    QVERIFY(record.path.startsWith(storage.cameraDirectory("IR-1")));
+    QCOMPARE(QFileInfo(record.path).size(), record.bytes);
+    QCOMPARE(QImage(record.path).size(), QSize(64, 48));
+    
+    // A burst takes the pre-roll frames, then the ones that follow
+    tags.label = "execute";
+    const QString burstId = service.burst("EO-1", tags);
+    QVERIFY(!burstId.isEmpty());
+    for (int i = 5; i < 10; ++i) {
+        service.addFrame("EO-1", frame(i * 10), 1000 + i * 100);
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(bursts.count(), 1, 5000);
+    QCOMPARE(bursts.at(0).at(0).toString(), burstId);
+    QCOMPARE(bursts.at(0).at(1).toInt(), 6);
+    const QVector<CaptureRecord> burst = service.burstCaptures(burstId);
+    QCOMPARE(burst.size(), 6);
+    for (int i = 0; i < burst.size(); ++i) {
+        QCOMPARE(burst[i].burstIndex, i);
+        QCOMPARE(burst[i].burstSize, 6);
+        QCOMPARE(burst[i].frameTimeMs, qint64(1200 + i * 100));   // Frames 2..7
+        QVERIFY(QFileInfo::exists(burst[i].path));
+    }
+    
+    // Indexed by engagement and track; a camera without pre-roll starts
+    // from its latest frame and a stalled burst is not waited on forever
+    QCOMPARE(service.capturesForEngagement("ENG-1").size(), 7);
+    QCOMPARE(service.capturesForTrack("T-7").size(), 7);
+    QVERIFY(service.capturesForEngagement("ENG-2").isEmpty());
+    
+    config.burstTimeoutMs = 100;
+    service.setConfig(config);
+    const QString shortBurst = service.burst("IR-1", tags, 4);
+    QVERIFY(!shortBurst.isEmpty());
+    QTRY_COMPARE_WITH_TIMEOUT(bursts.count(), 2, 5000);
+    QCOMPARE(bursts.at(1).at(1).toInt(), 1);
+    
+    service.waitForEncoding();
+    const CaptureStats stats = service.stats();
+    QCOMPARE(stats.saved, quint64(8));
+    QCOMPARE(stats.failed, quint64(0));
+    QCOMPARE(stats.pending, 0);
+    QCOMPARE(storage.stats().captures, quint64(8));
+}
+
+void TestVideoPipeline::testTrackVideoIndex() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    
+    // The writer points at the cluster each keyframe opened
+    MatroskaWriter::TrackInfo info;
+    info.codecId = "V_MJPEG";
+    info.width = 64;
+    info.height = 48;
+    info.fps = 10.0;
+    const QString path = dir.filePath("seg.mkv");
+    MatroskaWriter writer;
+    QVERIFY(writer.open(path, info));
+    QCOMPARE(writer.keyClusterOffset(), qint64(-1));
+    for (int i = 0; i < 25; ++i) {
+        QVERIFY(writer.writeVideo(QByteArray(500, char(i)), 5000 + i * 100, i % 10 == 0));
+    }
+    const qint64 offset = writer.keyClusterOffset();
+    QCOMPARE(writer.keyClusterTimeMs(), qint64(7000));
+    writer.close();
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.seek(offset));
+    QCOMPARE(file.read(4), QByteArray("\x1F\x43\xB6\x75", 4));   // Cluster ID
+    file.close();
+    MatroskaReader reader;
+    QVERIFY(reader.open(path));
+    QVERIFY(offset < reader.index().at(20).offset);
+    QVERIFY(offset > reader.index().at(19).offset);
+    reader.close();
+    
+    // Sightings follow the recording under the track, splitting where its
+    // camera rolls over to a new segment or it is lost for longer than the gap
+    QHash<QString, RecordingPosition> recording;
+    RecordingPosition position;
+    position.segmentPath = dir.filePath("EO-1/20260101T000000000.mkv");
+    position.byteOffset = 4096;
+    position.timeMs = 990;
+    recording.insert("EO-1", position);
+    
+    TrackVideoIndexConfig config;
+    config.gapMs = 1000;
+    config.maxBoxAgeMs = 500;
+    config.flushIntervalMs = 60000;
+    TrackVideoIndex index;
+    index.setConfig(config);
+    index.setPositionSource([&recording](const QString& cameraId) { return recording.value(cameraId); });
+    QVector<VideoSighting> stored;
+    connect(&index, &TrackVideoIndex::sightingsClosed, this,
+            [&stored](const QVector<VideoSighting>& sightings) { stored += sightings; });
+    
+    auto picture = [](qint64 nowMs, const QString& cameraId, qint64 boxMs) {
+        TrackPicture picture;
+        picture.timestampMs = nowMs;
+        TrackSnapshot track;
+        track.trackId = "TRK-0042";
+        track.handle = 42;
+        track.visuallyTracked = true;
+        track.associatedCameraId = cameraId;
+        track.boxTimestampMs = boxMs;
+        picture.tracks.append(track);
+        TrackSnapshot unseen;
+        unseen.trackId = "TRK-0043";
+        unseen.handle = 43;
+        picture.tracks.append(unseen);
+        return picture;
+    };
+    
+    for (qint64 t = 1000; t <= 2000; t += 250) index.update(picture(t, "EO-1", t));
+    QCOMPARE(index.openCount(), 1);
+    QCOMPARE(index.sightingsForTrack("TRK-0042").size(), 1);
+    QVERIFY(index.sightingsForTrack("TRK-0043").isEmpty());
+    
+    // Rolled over: the open sighting ends in the old segment
+    position.segmentPath = dir.filePath("EO-1/20260101T000002000.mkv");
+    position.byteOffset = 0;
+    position.timeMs = 2100;
+    recording.insert("EO-1", position);
+    for (qint64 t = 2250; t <= 3000; t += 250) index.update(picture(t, "EO-1", t));
+    
+    // The box goes stale: unseen past maxBoxAgeMs, closed once the gap has passed
+    for (qint64 t = 3250; t <= 5000; t += 250) index.update(picture(t, "EO-1", 3000));
+    QCOMPARE(index.openCount(), 0);
+    
+    // No recording on the camera, no sighting
+    for (qint64 t = 5250; t <= 6000; t += 250) index.update(picture(t, "IR-1", t));
+    QCOMPARE(index.openCount(), 0);
+    
+    index.flush();
+    QCOMPARE(stored.size(), 2);
+    QCOMPARE(stored[0].trackId, QString("TRK-0042"));
+    QCOMPARE(stored[0].cameraId, QString("EO-1"));
+    QCOMPARE(stored[0].startMs, qint64(1000));
+    QCOMPARE(stored[0].endMs, qint64(2000));
+    QCOMPARE(stored[0].clipId, QString("20260101T000000000"));
+    QCOMPARE(stored[0].byteOffset, qint64(4096));
+    QCOMPARE(stored[0].offsetTimeMs, qint64(990));
+    QCOMPARE(stored[1].startMs, qint64(2250));
+    QCOMPARE(stored[1].endMs, qint64(3500));
+    QCOMPARE(stored[1].clipId, QString("20260101T000002000"));
+    QCOMPARE(stored[1].byteOffset, qint64(0));
+}
+
+void TestVideoPipeline::testKlvMetadata() {
+    SensorMetadata sensor;
+    sensor.sensor.latitude = 51.5;
+    sensor.sensor.longitude = -0.12;
+    sensor.sensor.altitude = 30.0;
+    sensor.platformHeadingDeg = 90.0;
+    sensor.sensorAzimuthDeg = 45.0;
+    sensor.sensorElevationDeg = -10.0;
+    sensor.horizontalFovDeg = 30.0;
+    KlvTarget target;
+    target.id = 300;
+    target.box = QRectF(0.25, 0.25, 0.5, 0.5);
+    target.confidence = 80;
+    sensor.targets.append(target);
+    
+    // The local set reads back through its checksum
+    KlvEncoder encoder;
+    const qint64 t0 = 1700000000000;
+    const QByteArray packet = encoder.encode(sensor, t0, QSize(64, 48));
+    QVERIFY(packet.startsWith(KlvEncoder::universalKey()));
+    QMap<int, QByteArray> items;
+    QVERIFY(KlvEncoder::parse(packet, items));
+    auto value = [&items](int tag) { return reinterpret_cast<const uchar*>(items[tag].constData()); };
+    QCOMPARE(qFromBigEndian<quint64>(value(KlvEncoder::TAG_TIMESTAMP)), quint64(t0) * 1000);
+    QCOMPARE(int(value(KlvEncoder::TAG_LS_VERSION)[0]), KlvEncoder::LS_VERSION);
+    QCOMPARE(qRound(qFromBigEndian<quint16>(value(KlvEncoder::TAG_PLATFORM_HEADING)) * 360.0 / 65535.0), 90);
+    QCOMPARE(qRound(qFromBigEndian<qint32>(value(KlvEncoder::TAG_SENSOR_ELEVATION)) * 180.0 / 2147483647.0), -10);
+    // No ground point: the frame centre is the error value
+    QCOMPARE(qFromBigEndian<quint32>(value(KlvEncoder::TAG_FRAME_CENTER_LATITUDE)), 0x80000000u);
+    
+    // The box goes as ST 0903 pixel numbers: one pack, its id 300 as BER-OID
+    QMap<int, QByteArray> vmti;
+    QVERIFY(KlvEncoder::parseItems(items.value(KlvEncoder::TAG_VMTI), vmti));
+    QCOMPARE(qFromBigEndian<quint16>(vmti.value(8).constData()), quint16(64));
+    QCOMPARE(qFromBigEndian<quint16>(vmti.value(9).constData()), quint16(48));
+    const QByteArray series = vmti.value(101);
+    QCOMPARE(int(quint8(series.at(0))), series.size() - 1);
+    QCOMPARE(series.mid(1, 2), QByteArray("\x82\x2c", 2));
+    QMap<int, QByteArray> pack;
+    QVERIFY(KlvEncoder::parseItems(series.mid(3), pack));
+    QCOMPARE(qFromBigEndian<quint32>(pack.value(1).constData()), quint32(24 * 64 + 32 + 1));
+    QCOMPARE(qFromBigEndian<quint32>(pack.value(2).constData()), quint32(12 * 64 + 16 + 1));
+    QCOMPARE(qFromBigEndian<quint32>(pack.value(3).constData()), quint32(36 * 64 + 48 + 1));
+    QCOMPARE(int(quint8(pack.value(5).at(0))), 80);
+    
+    QByteArray corrupt = packet;
+    corrupt[KlvEncoder::KEY_SIZE + 8] = char(corrupt.at(KlvEncoder::KEY_SIZE + 8) ^ 1);
+    QVERIFY(!KlvEncoder::parse(corrupt, items));
+    
+    // A recording carries a packet beside every frame, on a track the
+    // video reader passes over
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    VideoRecorder recorder;
+    RecorderConfig config;
+    config.codec = "MJPEG";
+    config.fps = 10.0;
+    config.preBufferSeconds = 0;
+    config.segmentSeconds = 0;
+    recorder.setConfig(config);
+    recorder.setSensorMetadata(sensor);
+    const QString path = dir.filePath("klv.mkv");
+    QVERIFY(recorder.start(path));
+    QImage image(64, 48, QImage::Format_RGB32);
+    image.fill(Qt::darkGreen);
+    for (int i = 0; i < 10; ++i) recorder.addFrame(image, t0 + i * 100);
+    QTRY_COMPARE(recorder.recordedFrameCount(), qint64(10));
+    recorder.stop();
+    
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll().count(KlvEncoder::universalKey()), 10);
+    MatroskaReader reader;
+    QVERIFY(reader.open(path));
+    QCOMPARE(reader.packetCount(), 10);
+}
+
+void TestVideoPipeline::testFrameDistributor() {
+    QCOMPARE(VideoFrameDistributor::fittedSize(QSize(640, 480), QSize(320, 180)), QSize(240, 180));
+    QCOMPARE(VideoFrameDistributor::fittedSize(QSize(640, 480), QSize(1920, 1080)), QSize(640, 480));
+    QCOMPARE(VideoFrameDistributor::fittedSize(QSize(640, 480), QSize()), QSize(640, 480));
+    
+    VideoFrameDistributor distributor;
+    QObject receiver;
+    
+    int nativeCalls = 0;
+    qint64 nativeLast = -1;
+    VideoDeliveryPolicy native;
+    distributor.subscribe("CAM", &receiver, native,
+                          [&](const VideoFrame& frame, qint64 timestamp, const QSize&) {
+                              QCOMPARE(frame.size(), QSize(640, 480));
+                              ++nativeCalls;
+                              nativeLast = timestamp;
+                          });
+    
+    int cappedCalls = 0;
+    VideoDeliveryPolicy capped;
+    capped.maxFps = 10.0;
+    capped.latestOnly = false;
+    distributor.subscribe("CAM", &receiver, capped,
+                          [&](const VideoFrame&, qint64, const QSize&) { ++cappedCalls; });
+    
+    int thumbCalls = 0;
+    QSize thumbSize;
+    QSize thumbSource;
+    VideoDeliveryPolicy thumb;
+    thumb.targetSize = QSize(160, 160);
+    const int thumbId = distributor.subscribe(
+        "CAM", &receiver, thumb, [&](const VideoFrame& frame, qint64, const QSize& sourceSize) {
+            ++thumbCalls;
+            thumbSize = frame.size();
+            thumbSource = sourceSize;
+        });
+    QCOMPARE(distributor.subscriberCount("CAM"), 3);
+    
+    QImage image(640, 480, QImage::Format_RGB32);
+    image.fill(Qt::gray);
+    const VideoFrame frame(image);
+    for (int i = 0; i < 30; ++i) {
+        distributor.publish("CAM", frame, qint64(i) * 1000 / 30);
+    }
+    distributor.publish("OTHER", frame, 0);
+    
+    // Nothing ran while publishing, so the latest-only subscriber was
+    // handed one frame, the newest
+    QTRY_COMPARE(nativeCalls, 1);
+    QCOMPARE(nativeLast, qint64(29) * 1000 / 30);
+    QTRY_COMPARE(cappedCalls, 10);
+    QTRY_VERIFY(thumbCalls >= 1);
+    QCOMPARE(thumbSize, QSize(160, 120));
+    QCOMPARE(thumbSource, QSize(640, 480));
+    
+    const VideoDeliveryStats stats = distributor.stats();
+    QCOMPARE(stats.published, quint64(31));
+    QCOMPARE(stats.rateLimited, quint64(20));
+    QVERIFY(stats.coalesced >= 29);
+    QVERIFY(stats.scaled >= 1);
+    
+    // Unsubscribed callbacks stop, even with a frame already posted
+    distributor.unsubscribe(thumbId);
+    const int thumbBefore = thumbCalls;
+    distributor.publish("CAM", frame, 2000);
+    QTRY_COMPARE(nativeCalls, 2);
+    QCOMPARE(thumbCalls, thumbBefore);
+    
+    // A stream cap holds subscribers below their own rate, then lifts
+    QTRY_COMPARE(cappedCalls, 11);
+    distributor.setStreamRateCap("CAM", 5.0);
+    QCOMPARE(distributor.streamRateCap("CAM"), 5.0);
+    for (int i = 0; i < 29; ++i) {
+        distributor.publish("CAM", frame, 3000 + qint64(i) * 1000 / 30);
+    }
+    QTRY_COMPARE(cappedCalls, 16);
+    distributor.setStreamRateCap("CAM", 0.0);
+    QCOMPARE(distributor.streamRateCap("CAM"), 0.0);
+}
+
 QTEST_MAIN(TestVideoPipeline)
+void TestVideoPipeline::testIndexedFileReplay() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("replay.mkv");
+    const qint64 startUtc = 1700000000000;
+    
+    // Three seconds at 10 fps, every frame a JPEG keyframe
+    MatroskaWriter writer;
+    MatroskaWriter::TrackInfo info;
+    info.codecId = "V_MJPEG";
+    info.width = 64;
+    info.height = 48;
+    info.fps = 10.0;
+    info.startTimeUtcMs = startUtc;
+    QVERIFY(writer.open(path, info));
+    for (int i = 0; i < 30; ++i) {
+        QImage image(64, 48, QImage::Format_RGB32);
+        image.fill(QColor(i * 8, 0, 0));
+        QByteArray jpeg;
+        QBuffer buffer(&jpeg);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(image.save(&buffer, "JPG"));
+        QVERIFY(writer.writeVideo(jpeg, startUtc + i * 100, true));
+    }
+    writer.close();
+    
+    MatroskaReader reader;
+    QVERIFY(reader.open(path));
+    QCOMPARE(reader.packetCount(), 30);
+    QCOMPARE(reader.keyframeCount(), 30);
+    QCOMPARE(reader.durationMs(), qint64(2900));
+    QCOMPARE(reader.startTimeUtcMs(), startUtc);
+    QCOMPARE(reader.keyframeAtOrBefore(1550), 15);
+    QVERIFY(!reader.indexFromSidecar());
+    QVERIFY(QFileInfo::exists(MatroskaReader::indexPath(path)));
+    reader.close();
+    QVERIFY(reader.open(path));
+    QVERIFY(reader.indexFromSidecar());
+    QCOMPARE(reader.packetCount(), 30);
+    reader.close();
+    
+    FileVideoSource source("REPLAY-01");
+    QVERIFY(source.open(QUrl::fromLocalFile(path)));
+    QVERIFY(source.isIndexed());
+    QCOMPARE(source.duration(), qint64(2900));
+    QCOMPARE(source.recordingStartUtcMs(), startUtc);
+    QTRY_VERIFY(source.bufferedFrames() > 0);
+    QVERIFY(source.bufferedFrames() <= source.decodeAhead());
+    
+    // Replay starts at the seek target and reports the wall clock with it
+    QSignalSpy positions(&source, &FileVideoSource::positionChanged);
+    QSignalSpy replayTimes(&source, &FileVideoSource::replayTimeChanged);
+    source.seekToUtc(startUtc + 1500);
+    QCOMPARE(source.position(), qint64(1500));
+    source.start();
+    QTRY_VERIFY(positions.count() > 0);
+    const qint64 shown = positions.first().at(0).toLongLong();
+    QVERIFY(shown >= 1500 && shown < 2900);
+    QCOMPARE(replayTimes.first().at(0).toLongLong(), startUtc + shown);
+    
+    source.setPlaybackSpeed(4.0);
+    QVERIFY(source.isScrubbing());
+    source.setPlaybackSpeed(1.0);
+    QVERIFY(!source.isScrubbing());
+    
+    source.close();
+    QVERIFY(!source.isOpen());
+}
+
+void TestVideoPipeline::testGigECaptureLoop() {
+    // A lossy standard-MTU link in front of a small mono camera
+    GigETransportRegistry::registerTransport("test-lossy", 100, []() {
+        auto transport = std::make_unique<SimulatedGigETransport>();
+        transport->setPathMtu(1500);
+        transport->setPacketLoss(0.002, 0.5);
+        transport->setFeature("Width", 320);
+        transport->setFeature("Height", 240);
+        return std::unique_ptr<GigETransport>(std::move(transport));
+    });
+    
+    GigEVideoSource source("GIGE-01");
+    GigEConfig config;
+    config.packetSize = 8192;
+    config.jumboFrames = true;
+    config.frameBufferCount = 4;
+    source.setConfig(config);
+    QVERIFY(source.open(QUrl("gige:///GigE-Camera-001")));
+    QCOMPARE(source.transportName(), QString("test-lossy"));
+    
+    QSignalSpy frames(&source, &VideoSource::videoFrameReady);
+    source.setTargetFPS(60.0);
+    source.start();
+    QVERIFY(source.isStreaming());
+    QCOMPARE(source.negotiatedPacketSize(), 1500);
+    QTRY_VERIFY_WITH_TIMEOUT(frames.count() >= 20, 5000);
+    
+    const VideoFrame frame = frames.last().at(0).value<VideoFrame>();
+    QCOMPARE(frame.size(), QSize(320, 240));
+    QCOMPARE(frame.pixelFormat(), VideoPixelFormat::YUV420P);
+    QCOMPARE(int(frame.constBits(1)[0]), 128);
+    
+    // 53 packets a frame: some lost, some of those recovered
+    QTRY_VERIFY_WITH_TIMEOUT(source.stats().packetsResent > 0 && source.stats().packetsMissing > 0, 10000);
+    const VideoSourceStats stats = source.stats();
+    QVERIFY(stats.framesIncomplete > 0);
+    QVERIFY(stats.framesDropped >= stats.framesIncomplete);
+    QVERIFY(stats.packetsReceived > stats.packetsMissing);
+    
+    // Without jumbo frames the request itself stays at the Ethernet MTU
+    source.stop();
+    config.jumboFrames = false;
+    config.packetSize = 9000;
+    config.pixelFormat = 1;
+    source.setConfig(config);
+    frames.clear();
+    source.start();
+    QCOMPARE(source.negotiatedPacketSize(), GigEVideoSource::STANDARD_PACKET_SIZE);
+    QTRY_VERIFY(frames.count() > 0);
+    QCOMPARE(frames.last().at(0).value<VideoFrame>().pixelFormat(), VideoPixelFormat::RGB24);
+    
+    // Radiometric mono16 is mapped to display frames on the capture thread
+    source.stop();
+    config.pixelFormat = 2;
+    source.setConfig(config);
+    frames.clear();
+    source.start();
+    QTRY_VERIFY(frames.count() > 0);
+    QCOMPARE(frames.last().at(0).value<VideoFrame>().pixelFormat(), VideoPixelFormat::YUV420P);
+    QCOMPARE(frames.last().at(0).value<VideoFrame>().size(), QSize(320, 240));
+    
+    source.close();
+    QVERIFY(!source.isOpen());
+    GigETransportRegistry::unregisterTransport("test-lossy");
+}
+
+namespace {
+
+QByteArray rtpPacket(quint16 sequence, quint32 timestamp, bool marker, const QByteArray& payload,
+                     int payloadType = 96) {
+    QByteArray d(12, '\0');
+    d[0] = char(0x80);
+    d[1] = char((marker ? 0x80 : 0) | payloadType);
+    qToBigEndian<quint16>(sequence, reinterpret_cast<uchar*>(d.data()) + 2);
+    qToBigEndian<quint32>(timestamp, reinterpret_cast<uchar*>(d.data()) + 4);
+    d[11] = 1;
+    return d + payload;
+}
+
+RtpPacket parsed(const QByteArray& datagram) {
+    RtpPacket packet;
+    RtpPacket::parse(datagram, packet);
+    return packet;
+}
+
+} // namespace
+
+void TestVideoPipeline::testRtpIngest() {
+    // Jitter buffer: reordering across the wrap, a duplicate, a gap given
+    // up on after the delay, and the missing packet arriving too late
+    RtpJitterBuffer jitter(40);
+    for (quint16 seq : {quint16(65534), quint16(0), quint16(65535), quint16(2), quint16(0)}) {
+        jitter.push(parsed(rtpPacket(seq, 0, false, "x")), 0);
+    }
+    RtpPacket out;
+    int lost = 0;
+    QList<int> order;
+    while (jitter.pop(out, 5, &lost)) order.append(out.sequence);
+    QCOMPARE(order, QList<int>({65534, 65535, 0}));
+    QCOMPARE(jitter.nextDeadlineMs(), qint64(40));
+    QVERIFY(!jitter.pop(out, 39));
+    QVERIFY(jitter.pop(out, 40, &lost));
+    QCOMPARE(int(out.sequence), 2);
+    QCOMPARE(lost, 1);
+    jitter.push(parsed(rtpPacket(1, 0, false, "x")), 50);
+    const RtpJitterBuffer::Stats js = jitter.stats();
+    QCOMPARE(js.late, quint64(1));
+    QCOMPARE(js.duplicates, quint64(1));
+    QCOMPARE(js.reordered, quint64(1));
+    QCOMPARE(js.lost, quint64(1));
+    
+    // H.264: nothing before the first IDR, which gets the fmtp parameter
+    // sets, then STAP-A, then a loss in the middle of a fragmented picture
+    const QByteArray sps = QByteArray::fromBase64("Z0IAH5WoFAFuQA==");
+    const QByteArray pps = QByteArray::fromBase64("aM48gA==");
+    H264RtpDepacketizer h264("packetization-mode=1;sprop-parameter-sets=Z0IAH5WoFAFuQA==,aM48gA==");
+    QVector<RtpAccessUnit> units;
+    const QByteArray slice("\x41\x9a\x11\x22", 4);
+    h264.push(parsed(rtpPacket(1, 0, true, slice)), units);
+    QVERIFY(units.isEmpty());
+    
+    QByteArray idr(3000, '\x33');
+    idr[0] = 0x65;
+    const QByteArray fuStart = QByteArray("\x7c\x85", 2) + idr.mid(1, 1500);
+    const QByteArray fuEnd = QByteArray("\x7c\x45", 2) + idr.mid(1501);
+    h264.push(parsed(rtpPacket(2, 3000, false, fuStart)), units);
+    h264.push(parsed(rtpPacket(3, 3000, true, fuEnd)), units);
+    QCOMPARE(units.size(), 1);
+    QVERIFY(units[0].keyframe);
+    const QByteArray startCode("\0\0\0\1", 4);
+    QCOMPARE(units[0].data, startCode + sps + startCode + pps + startCode + idr);
+    
+    const QByteArray stap = QByteArray("\x18\0\4", 3) + slice + QByteArray("\0\4", 2) + slice;
+    h264.push(parsed(rtpPacket(4, 6000, true, stap)), units);
+    QCOMPARE(units.size(), 2);
+    QVERIFY(!units[1].keyframe);
+    QCOMPARE(units[1].data, startCode + slice + startCode + slice);
+    
+    h264.discard();
+    h264.push(parsed(rtpPacket(6, 9000, false, fuEnd)), units);
+    h264.push(parsed(rtpPacket(7, 12000, true, slice)), units);
+    QCOMPARE(units.size(), 3);
+    QCOMPARE(units[2].data, startCode + slice);
+    
+    // RTCP sender report: RTP time 9000 was Unix 1700000000.5 s
+    RtcpSenderClock clock(90000);
+    QCOMPARE(clock.wallClockMs(9000), qint64(-1));
+    QByteArray report(28, '\0');
+    report[0] = char(0x80);
+    report[1] = char(200);
+    report[3] = 6;
+    const quint64 ntp = (quint64(2208988800ULL + 1700000000ULL) << 32) | 0x80000000ULL;
+    qToBigEndian<quint64>(ntp, reinterpret_cast<uchar*>(report.data()) + 8);
+    qToBigEndian<quint32>(9000, reinterpret_cast<uchar*>(report.data()) + 16);
+    QVERIFY(clock.onRtcp(report));
+    QCOMPARE(clock.wallClockMs(9000 + 90), qint64(1700000000501LL));
+    QCOMPARE(clock.wallClockMs(0), qint64(1700000000400LL));
+    
+    // RFC 2435: a JPEG split into RTP packets, with the Q factor and then
+    // in-band tables, decodes to the same picture as the original
+    QImage picture(64, 48, QImage::Format_RGB32);
+    for (int y = 0; y < picture.height(); ++y) {
+        for (int x = 0; x < picture.width(); ++x) picture.setPixel(x, y, qRgb(x * 4, y * 5, (x * y) & 255));
+    }
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(picture.save(&buffer, "JPG", 75));
+    if (!jpeg.contains(QByteArray("\xff\xc0\x00\x11\x08\x00\x30\x00\x40\x03\x01\x22", 12))) {
+        QSKIP("JPEG writer does not produce baseline 4:2:0");
+    }
+    int scan = 2;
+    while (scan < jpeg.size() && uchar(jpeg[scan + 1]) != 0xda) {
+        scan += 2 + qFromBigEndian<quint16>(jpeg.constData() + scan + 2);
+    }
+    scan += 2 + qFromBigEndian<quint16>(jpeg.constData() + scan + 2);
+    const QByteArray body = jpeg.mid(scan);
+    const QImage reference = QImage::fromData(jpeg).convertToFormat(QImage::Format_RGB32);
+    
+    for (bool inBand : {false, true}) {
+        JpegRtpDepacketizer depacketizer;
+        QVector<RtpAccessUnit> pictures;
+        quint16 seq = 100;
+        for (int offset = 0; offset < body.size(); offset += 300) {
+            QByteArray header(8, '\0');
+            qToBigEndian<quint32>(quint32(offset), reinterpret_cast<uchar*>(header.data()));
+            header[0] = 0;
+            header[4] = 1;
+            header[5] = char(inBand ? 255 : 75);
+            header[6] = 64 / 8;
+            header[7] = 48 / 8;
+            if (inBand && offset == 0) {
+                header += QByteArray("\0\0\0\x80", 4) + JpegRtpDepacketizer::standardTables(75);
+            }
+            const bool last = offset + 300 >= body.size();
+            depacketizer.push(parsed(rtpPacket(seq++, 1234, last, header + body.mid(offset, 300), 26)),
+                              pictures);
+        }
+        QCOMPARE(pictures.size(), 1);
+        QVERIFY(pictures[0].keyframe);
+        QCOMPARE(QImage::fromData(pictures[0].data).convertToFormat(QImage::Format_RGB32), reference);
+    }
+}
+
+namespace {
+
+// Every decode waits for a permit, so a test can hold the worker and queue behind it
+class GatedDecoderBackend : public VideoDecoderBackend {
+public:
+    explicit GatedDecoderBackend(QSemaphore* gate) : m_gate(gate) {}
+
+    QString name() const override { return QStringLiteral("test-gated"); }
+    bool isHardware() const override { return false; }
+    bool open(const QString& codecName, FramePool*) override { return codecName == "H264"; }
+    void close() override {}
+    bool decode(const QByteArray&, VideoFrame& frame) override {
+        m_gate->acquire();
+        QImage image(8, 8, QImage::Format_RGB888);
+        image.fill(Qt::gray);
+        frame = VideoFrame(image);
+        return true;
+    }
+
+private:
+    QSemaphore* m_gate;
+};
+
+QByteArray annexB(std::initializer_list<uchar> header) {
+    QByteArray unit("\0\0\0\x01", 4);
+    for (uchar byte : header) unit.append(char(byte));
+    unit.append(char(0x88));
+    return unit;
+}
+
+} // namespace
+
+void TestVideoPipeline::testDecodeShedding() {
+    const QByteArray idr = annexB({0x67, 0x42}) + annexB({0x65});    // SPS, then the IDR slice
+    const QByteArray ref = annexB({0x09, 0xf0}) + annexB({0x41});    // Delimiter, nal_ref_idc 2
+    const QByteArray nonRef = annexB({0x01});                        // nal_ref_idc 0
+    
+    VideoPacketType type = VideoPacketType::Reference;
+    QVERIFY(VideoDecoder::classifyPacket("H264", idr, type));
+    QVERIFY(type == VideoPacketType::Keyframe);
+    QVERIFY(VideoDecoder::classifyPacket("H264", ref, type));
+    QVERIFY(type == VideoPacketType::Reference);
+    QVERIFY(VideoDecoder::classifyPacket("H264", nonRef, type));
+    QVERIFY(type == VideoPacketType::NonReference);
+    QVERIFY(VideoDecoder::classifyPacket("H265", annexB({19 << 1, 0x01}), type));   // IDR_W_RADL
+    QVERIFY(type == VideoPacketType::Keyframe);
+    QVERIFY(VideoDecoder::classifyPacket("H265", annexB({1 << 1, 0x01}), type));    // TRAIL_R
+    QVERIFY(type == VideoPacketType::Reference);
+    QVERIFY(VideoDecoder::classifyPacket("H265", annexB({0, 0x01}), type));         // TRAIL_N
+    QVERIFY(type == VideoPacketType::NonReference);
+    QVERIFY(VideoDecoder::classifyPacket("MJPEG", QByteArray("\xff\xd8", 2), type));
+    QVERIFY(type == VideoPacketType::Keyframe);
+    QVERIFY(!VideoDecoder::classifyPacket("VP8", ref, type));
+    
+    QSemaphore gate;
+    VideoDecoderRegistry::registerBackend("test-gated", 0, false,
+        [&gate]() { return std::unique_ptr<VideoDecoderBackend>(new GatedDecoderBackend(&gate)); });
+    {
+        VideoDecoder decoder;
+        decoder.setPreferredBackend("test-gated");
+        QVERIFY(decoder.initialize("H264"));
+        QList<qint64> shown;
+        connect(&decoder, &VideoDecoder::videoFrameDecoded, this,
+                [&shown](const VideoFrame&, qint64 timestamp) { shown.append(timestamp); });
+        
+        // Held on the first keyframe, the backlog behind it restarts at the
+        // latest one, and a non-reference picture with a newer one queued goes
+        decoder.setDecodeMode(VideoDecodeMode::Newest);
+        QVERIFY(decoder.submit(idr, 1));
+        QTRY_COMPARE(decoder.stats().queueDepth, 0);
+        decoder.submit(ref, 2);
+        decoder.submit(nonRef, 3);
+        decoder.submit(idr, 4);
+        decoder.submit(nonRef, 5);
+        decoder.submit(ref, 6);
+        QCOMPARE(decoder.stats().queueDepth, 5);
+        gate.release(1000);
+        QTRY_COMPARE(shown.size(), 3);
+        QCOMPARE(shown, QList<qint64>({1, 4, 6}));
+        VideoDecodeStats stats = decoder.stats();
+        QCOMPARE(stats.skippedBacklog, quint64(2));
+        QCOMPARE(stats.skippedNonReference, quint64(1));
+        QCOMPARE(stats.decoded, quint64(3));
+        
+        // Non-reference pictures never reach the queue
+        decoder.setDecodeMode(VideoDecodeMode::SkipNonReference);
+        decoder.submit(ref, 7);
+        decoder.submit(nonRef, 8);
+        decoder.submit(ref, 9);
+        QTRY_COMPARE(shown.size(), 5);
+        QCOMPARE(shown.mid(3), QList<qint64>({7, 9}));
+        
+        // Keyframes only; full decoding after it waits for the next keyframe,
+        // as the pictures until then predict from ones never decoded
+        decoder.setDecodeMode(VideoDecodeMode::KeyframesOnly);
+        decoder.submit(ref, 10);
+        decoder.submit(nonRef, 11);
+        decoder.submit(idr, 12);
+        decoder.submit(ref, 13);
+        decoder.setDecodeMode(VideoDecodeMode::All);
+        decoder.submit(ref, 14);
+        decoder.submit(nonRef, 15);
+        decoder.submit(idr, 16);
+        decoder.submit(ref, 17);
+        QTRY_COMPARE(shown.size(), 8);
+        QCOMPARE(shown.mid(5), QList<qint64>({12, 16, 17}));
+        stats = decoder.stats();
+        QVERIFY(stats.mode == VideoDecodeMode::All);
+        QCOMPARE(stats.submitted, quint64(17));
+        QCOMPARE(stats.skippedNonReference, quint64(3));
+        QCOMPARE(stats.skippedNonKey, quint64(4));
+        QCOMPARE(stats.skipped(), quint64(9));
+        QCOMPARE(stats.dropped, quint64(0));
+        decoder.shutdown();
+    }
+    VideoDecoderRegistry::unregisterBackend("test-gated");
+    
+    // The manager's choice per stream
+    VideoStreamManager manager;
+    CameraDefinition camera;
+    camera.sourceType = "FILE";
+    camera.streamUrl = "file:///dev/null";
+    camera.cameraId = "CAM-PRIMARY";
+    QCOMPARE(manager.addStream(camera), camera.cameraId);
+    camera.cameraId = "CAM-GRID";
+    QCOMPARE(manager.addStream(camera), camera.cameraId);
+    manager.setPrimaryStream("CAM-PRIMARY");
+    QVERIFY(manager.decodeMode("CAM-PRIMARY") == VideoDecodeMode::Newest);
+    QVERIFY(manager.decodeMode("CAM-GRID") == VideoDecodeMode::All);
+    
+    manager.setDecodeShedding(true);
+    QVERIFY(manager.decodeMode("CAM-PRIMARY") == VideoDecodeMode::Newest);
+    QVERIFY(manager.decodeMode("CAM-GRID") == VideoDecodeMode::SkipNonReference);
+    VideoDeliveryPolicy tile;
+    tile.targetSize = QSize(160, 120);
+    const int subscription = manager.subscribeFrames("CAM-GRID", this, tile,
+                                                     [](const VideoFrame&, qint64, const QSize&) {});
+    QVERIFY(manager.decodeMode("CAM-GRID") == VideoDecodeMode::KeyframesOnly);
+    VideoDeliveryPolicy full;
+    manager.setDeliveryPolicy(subscription, full);
+    QVERIFY(manager.decodeMode("CAM-GRID") == VideoDecodeMode::SkipNonReference);
+    
+    manager.setDecodeShedding(false);
+    QVERIFY(manager.decodeMode("CAM-GRID") == VideoDecodeMode::All);
+    manager.unsubscribeFrames(subscription);
+    manager.removeAllStreams();
+}
+
+void TestVideoPipeline::testRestreamFanOut() {
+    // H.264: a length-prefixed IDR too big for one packet goes as FU-A,
+    // behind the avcC parameter sets, and comes back as the same picture
+    const QByteArray sps = QByteArray::fromBase64("Z0IAH5WoFAFuQA==");
+    const QByteArray pps = QByteArray::fromBase64("aM48gA==");
+    QByteArray avcC("\x01\x42\x00\x1f\xff\xe1", 6);
+    avcC += char(0) + QByteArray(1, char(sps.size())) + sps + char(1) + char(0) + QByteArray(1, char(pps.size())) + pps;
+    H264RtpPacketizer h264(avcC, 1000);
+    QVERIFY(h264.fmtp().contains("sprop-parameter-sets=Z0IAH5WoFAFuQA==,aM48gA=="));
+    QByteArray idr(2500, '\x44');
+    idr[0] = 0x65;
+    QByteArray prefixed(4, '\0');
+    qToBigEndian<quint32>(quint32(idr.size()), reinterpret_cast<uchar*>(prefixed.data()));
+    QVector<QByteArray> payloads;
+    QVERIFY(h264.packetize(prefixed + idr, true, payloads));
+    QCOMPARE(payloads.size(), 5);
+    H264RtpDepacketizer h264In;
+    QVector<RtpAccessUnit> units;
+    for (int i = 0; i < payloads.size(); ++i) {
+        h264In.push(parsed(rtpPacket(quint16(i), 9000, i == payloads.size() - 1, payloads[i])), units);
+    }
+    QCOMPARE(units.size(), 1);
+    const QByteArray startCode("\0\0\0\1", 4);
+    QCOMPARE(units[0].data, startCode + sps + startCode + pps + startCode + idr);
+    
+    // Motion JPEG: headers stripped, tables in band, the same picture back
+    QImage picture(64, 48, QImage::Format_RGB32);
+    for (int y = 0; y < picture.height(); ++y) {
+        for (int x = 0; x < picture.width(); ++x) picture.setPixel(x, y, qRgb(x * 4, y * 5, (x * y) & 255));
+    }
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(picture.save(&buffer, "JPG", 80));
+    if (!jpeg.contains(QByteArray("\xff\xc0\x00\x11\x08\x00\x30\x00\x40\x03\x01\x22", 12))) {
+        QSKIP("JPEG writer does not produce baseline 4:2:0");
+    }
+    JpegRtpPacketizer jpegOut(300);
+    payloads.clear();
+    QVERIFY(jpegOut.packetize(jpeg, true, payloads));
+    QVERIFY(payloads.size() > 1);
+    JpegRtpDepacketizer jpegIn;
+    units.clear();
+    for (int i = 0; i < payloads.size(); ++i) {
+        QVERIFY(payloads[i].size() <= 300);
+        jpegIn.push(parsed(rtpPacket(quint16(i), 1234, i == payloads.size() - 1, payloads[i], 26)), units);
+    }
+    QCOMPARE(units.size(), 1);
+    QCOMPARE(QImage::fromData(units[0].data).convertToFormat(QImage::Format_RGB32),
+             QImage::fromData(jpeg).convertToFormat(QImage::Format_RGB32));
+    
+    // Two consoles on one rung: each picture is encoded once for both, and
+    // stamped through the sender reports with the time it was captured
+    RestreamConfig config;
+    config.codec = "MJPEG";
+    config.hardwareEncoder = false;
+    config.ladder = {{2000, 1.0, 80}, {500, 0.5, 60}};
+    VideoRestreamer restreamer;
+    restreamer.setConfig(config);
+    QVERIFY(restreamer.start(0, QHostAddress::LocalHost));
+    
+    RtspClient consoles[2];
+    QVector<QPair<QByteArray, qint64>> received[2];
+    for (int i = 0; i < 2; ++i) {
+        RtspClient::Options options;
+        options.jitterBufferMs = 0;
+        consoles[i].setOptions(options);
+        consoles[i].setUnitSink([&received, i](const QByteArray& unit, qint64 captureMs) {
+            received[i].append({unit, captureMs});
+        });
+        connect(&consoles[i], &RtspClient::ready, &consoles[i], &RtspClient::play);
+        consoles[i].open(QUrl(QString("rtsp://127.0.0.1:%1/primary").arg(restreamer.port())));
+    }
+    
+    QSet<qint64> pushed;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while ((received[0].size() < 5 || received[1].size() < 5) && elapsed.elapsed() < 10000) {
+        const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+        pushed.insert(timestamp);
+        restreamer.addVideoFrame(VideoFrame(picture), timestamp);
+        QTest::qWait(20);
+    }
+    QVERIFY(received[0].size() >= 5);
+    QVERIFY(received[1].size() >= 5);
+    
+    const RestreamStats stats = restreamer.stats();
+    QCOMPARE(stats.codec, QString("MJPEG"));
+    QCOMPARE(stats.links.size(), 2);
+    QCOMPARE(stats.rungSubscribers, QVector<int>({2, 0}));
+    QVERIFY(stats.framesEncoded <= stats.framesIn);
+    QCOMPARE(restreamer.subscriberCount(), 2);
+    for (int i = 0; i < 2; ++i) {
+        QVERIFY(consoles[i].stats().senderClock);
+        const QImage shown = QImage::fromData(received[i].last().first);
+        QCOMPARE(shown.size(), picture.size());
+        QVERIFY(pushed.contains(received[i].last().second));
+    }
+    
+    consoles[0].shutdown();
+    QTRY_COMPARE(restreamer.subscriberCount(), 1);
+    restreamer.stop();
+    QCOMPARE(restreamer.subscriberCount(), 0);
+}
+
+void TestVideoPipeline::testPredictiveSlewLoop() {
+    GeoPosition mount;
+    mount.latitude = 51.0;
+    mount.longitude = 0.0;
+    
+    double pan = 0.0, tilt = 0.0;
+    GeoPosition east = CoordinateUtils::positionFromBearingDistance(mount, 90.0, 500.0);
+    SlewControlLoop::aimAngles(mount, 0.0, east, pan, tilt);
+    QVERIFY(qAbs(pan - 90.0) < 0.01);
+    QVERIFY(qAbs(tilt) < 0.01);
+    SlewControlLoop::aimAngles(mount, 120.0, east, pan, tilt);
+    QVERIFY(qAbs(pan + 30.0) < 0.01);
+    
+    // A drone crossing at 30 m/s, 300 m out: about 5.7 deg/s of line of
+    // sight. The camera obeys each rate 150 ms after it is sent and reports
+    // its position at 10 Hz; tracks arrive at 5 Hz.
+    TrackSnapshot truth;
+    truth.position = CoordinateUtils::positionFromBearingDistance(mount, 0.0, 300.0);
+    truth.position.altitude = 50.0;
+    truth.velocity.east = 30.0;
+    truth.position = truth.predictedPosition(-10000);
+    
+    SlewControlLoop loop;
+    SlewControlLoop::CameraMount cameraMount;
+    cameraMount.position = mount;
+    cameraMount.latencyMs = 150;
+    loop.setCamera("ptz-1", cameraMount, -45.0, 0.0);
+    
+    QList<QPair<qint64, QPair<double, double>>> inFlight;
+    QObject::connect(&loop, &SlewControlLoop::rateCommand,
+                     [&](const QString&, double panRate, double tiltRate) {
+                         inFlight.append({0, {panRate, tiltRate}});
+                     });
+    
+    const qint64 t0 = 1700000000000LL;
+    double cameraPan = -45.0, cameraTilt = 0.0;
+    double panRate = 0.0, tiltRate = 0.0;
+    qint64 lastTrackMs = -1;
+    double worst = 0.0;
+    for (qint64 t = 0; t <= 20000; t += 20) {
+        while (!inFlight.isEmpty() && inFlight.first().first + 150 <= t) {
+            panRate = inFlight.first().second.first;
+            tiltRate = inFlight.first().second.second;
+            inFlight.removeFirst();
+        }
+        cameraPan += panRate * 0.02;
+        cameraTilt += tiltRate * 0.02;
+        if (lastTrackMs < 0 || t - lastTrackMs >= 200) {
+            lastTrackMs = t;
+            TrackSnapshot track = truth;
+            track.position = truth.predictedPosition(t);
+            loop.setTarget("ptz-1", track, t0 + t);
+        }
+        if (t % 100 == 0) loop.setFeedback("ptz-1", cameraPan, cameraTilt);
+        
+        const int queued = inFlight.size();
+        loop.step(t0 + t);
+        for (int i = queued; i < inFlight.size(); ++i) inFlight[i].first = t;
+        
+        if (t >= 5000) {
+            SlewControlLoop::aimAngles(mount, 0.0, truth.predictedPosition(t), pan, tilt);
+            worst = qMax(worst, qMax(qAbs(pan - cameraPan), qAbs(tilt - cameraTilt)));
+        }
+    }
+    // Chasing the current position instead lags by rate x latency, about 0.9 deg
+    QVERIFY2(worst < 0.1, qPrintable(QString::number(worst)));
+    QVERIFY(loop.cameraState("ptz-1").engaged);
+    QVERIFY(qAbs(loop.cameraState("ptz-1").panRate) > 1.0);
+    
+    loop.release("ptz-1");
+    QVERIFY(!loop.cameraState("ptz-1").engaged);
+    QCOMPARE(inFlight.last().second.first, 0.0);
+    
+    // Rates are clamped to the PTZ's speeds and integrated by its simulation
+    PTZController ptz;
+    PTZConfig config;
+    config.panSpeed = 20.0;
+    ptz.setConfig(config);
+    ptz.setPanTiltVelocity(100.0, 0.0);
+    QCOMPARE(ptz.panVelocity(), 20.0);
+    QTRY_VERIFY(ptz.currentPan() > 2.0);
+    ptz.stop();
+    QCOMPARE(ptz.panVelocity(), 0.0);
+}
+
+void TestVideoPipeline::testPTZCommandScheduler() {
+    PTZCommandScheduler scheduler;
+    PTZCommandSchedulerConfig config;
+    config.commandRateHz = 10.0;
+    config.awaitAck = true;
+    config.ackTimeoutMs = 500;
+    scheduler.setConfig(config);
+    
+    QByteArray command;
+    PTZCommandScheduler::Kind kind;
+    scheduler.submitMotion();
+    QVERIFY(scheduler.next(0, command, &kind));
+    QCOMPARE(kind, PTZCommandScheduler::Kind::Motion);
+    QVERIFY(scheduler.awaitingAck());
+    
+    // A burst of moves while waiting merges into one
+    for (int i = 0; i < 20; ++i) scheduler.submitMotion();
+    scheduler.submit("query");
+    QCOMPARE(scheduler.queued(), 2);
+    QVERIFY(!scheduler.next(50, command));
+    QCOMPARE(scheduler.nextDueMs(50), qint64(500));
+    
+    scheduler.acknowledge(80);
+    QCOMPARE(scheduler.statistics().lastAckLatencyMs, qint64(80));
+    // Still held to the command rate
+    QCOMPARE(scheduler.nextDueMs(80), qint64(100));
+    QVERIFY(scheduler.next(100, command, &kind));
+    QCOMPARE(kind, PTZCommandScheduler::Kind::Ordered);
+    QCOMPARE(command, QByteArray("query"));
+    
+    // A stop jumps the wait for the answer and drops the move it overrides
+    scheduler.submitPriority("stop", true);
+    QCOMPARE(scheduler.nextDueMs(150), qint64(200));
+    QVERIFY(scheduler.next(200, command, &kind));
+    QCOMPARE(kind, PTZCommandScheduler::Kind::Priority);
+    QCOMPARE(command, QByteArray("stop"));
+    QVERIFY(scheduler.isEmpty());
+    
+    // An unanswered command stops holding the queue after the timeout
+    scheduler.submitMotion();
+    QVERIFY(!scheduler.next(600, command));
+    QVERIFY(scheduler.next(700, command, &kind));
+    QCOMPARE(kind, PTZCommandScheduler::Kind::Motion);
+    
+    const PTZCommandScheduler::Statistics stats = scheduler.statistics();
+    QCOMPARE(stats.sent, quint64(4));
+    QCOMPARE(stats.coalesced, quint64(20));
+    QCOMPARE(stats.acknowledged, quint64(1));
+    QCOMPARE(stats.ackTimeouts, quint64(1));
+}
+
+void TestVideoPipeline::testOnvifPtzClient() {
+    OnvifPtzClient onvif;
+    onvif.setTarget("10.0.0.5", 80, "/onvif/ptz_service", "Profile_1", "admin", "secret");
+    
+    // Values are written in place; the request, and its length, stay the same size
+    const QByteArray first = onvif.continuousMove(0.5, -0.25);
+    QVERIFY(first.startsWith("POST /onvif/ptz_service HTTP/1.1\r\n"));
+    QVERIFY(first.contains("Authorization: Basic "));
+    QVERIFY(first.contains("<tt:PanTilt x=\"+0.500000\" y=\"-0.250000\"/>"));
+    const int bodyStart = first.indexOf("\r\n\r\n") + 4;
+    QVERIFY(first.contains("Content-Length: " + QByteArray::number(first.size() - bodyStart) + "\r\n"));
+    const QByteArray second = onvif.continuousMove(-3.0, 0.125);
+    QCOMPARE(second.size(), first.size());
+    QVERIFY(second.contains("x=\"-1.000000\" y=\"+0.125000\""));
+    QVERIFY(onvif.relativeMove(0.1, 0.0, 0.0).contains("<tptz:Translation>"));
+    
+    // Responses split across reads, one chunked, one a fault
+    const QByteArray status =
+        "<s:Envelope><s:Body><tptz:GetStatusResponse><tptz:PTZStatus><tt:Position>"
+        "<tt:PanTilt x=\"0.25\" y=\"-0.5\" space=\"generic\"/><tt:Zoom x=\"0.1\"/>"
+        "</tt:Position></tptz:PTZStatus></tptz:GetStatusResponse></s:Body></s:Envelope>";
+    const QByteArray stream =
+        "HTTP/1.1 200 OK\r\nContent-Length: " + QByteArray::number(status.size()) + "\r\n\r\n" + status +
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\n<ok/>\r\n0\r\n\r\n"
+        "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    OnvifResponse response;
+    QVector<OnvifResponse> responses;
+    for (int i = 0; i < stream.size(); i += 40) {
+        onvif.feed(stream.mid(i, 40));
+        while (onvif.nextResponse(response)) responses.append(response);
+    }
+    QCOMPARE(responses.size(), 3);
+    double pan = 0.0, tilt = 0.0, zoom = 0.0;
+    QVERIFY(OnvifPtzClient::parseStatus(responses[0].body, pan, tilt, zoom));
+    QCOMPARE(pan, 0.25);
+    QCOMPARE(tilt, -0.5);
+    QCOMPARE(zoom, 0.1);
+    QCOMPARE(responses[1].body, QByteArray("<ok/>"));
+    QVERIFY(responses[2].fault);
+    QVERIFY(!responses[2].keepAlive);
+}
+
+void TestVideoPipeline::testCameraScheduler() {
+    GeoPosition site;
+    site.latitude = 51.0;
+    site.longitude = 0.0;
+    
+    // Two cameras 2 km apart, each seeing 1.5 km around it
+    TaskableCamera west;
+    west.cameraId = "west";
+    west.mount = site;
+    west.maxRangeM = 1500.0;
+    TaskableCamera east = west;
+    east.cameraId = "east";
+    east.mount = CoordinateUtils::positionFromBearingDistance(site, 90.0, 2000.0);
+    
+    auto threatAt = [&](const QString& id, int level, double bearing, double range, bool confirmed) {
+        TaskableThreat threat;
+        threat.trackId = id;
+        threat.threatLevel = level;
+        threat.position = CoordinateUtils::positionFromBearingDistance(site, bearing, range);
+        threat.position.altitude = 100.0;
+        threat.visuallyTracked = confirmed;
+        return threat;
+    };
+    
+    CameraTaskingConfig config;
+    config.minDwellMs = 4000;
+    config.revisitMs = 10000;
+    CameraScheduler scheduler;
+    scheduler.setConfig(config);
+    
+    // The top threat only the east camera sees goes to it; the west camera
+    // takes the next one rather than idling
+    QVector<TaskableThreat> threats = {
+        threatAt("t1", 5, 90.0, 2500.0, false),
+        threatAt("t2", 4, 0.0, 800.0, false),
+        threatAt("t3", 2, 180.0, 600.0, false),
+    };
+    QCOMPARE(scheduler.score(west, threats[0], 0, 0), 0.0);
+    qint64 now = 0;
+    QHash<QString, QString> tasks = scheduler.schedule({west, east}, threats, now);
+    QCOMPARE(tasks.value("east"), QString("t1"));
+    QCOMPARE(tasks.value("west"), QString("t2"));
+    
+    // Within the dwell a small reshuffle of the queue moves nobody
+    std::swap(threats[1], threats[2]);
+    threats[1].threatLevel = 4;
+    now += 1000;
+    tasks = scheduler.schedule({west, east}, threats, now);
+    QCOMPARE(tasks.value("west"), QString("t2"));
+    
+    // A higher unconfirmed threat in view takes the camera at once
+    threats.prepend(threatAt("t4", 5, 0.0, 400.0, false));
+    threats[1].visuallyTracked = true;  // t1, confirmed meanwhile
+    now += 500;
+    tasks = scheduler.schedule({west, east}, threats, now);
+    QCOMPARE(tasks.value("west"), QString("t4"));
+    QCOMPARE(tasks.value("east"), QString("t1"));
+    
+    // Confirmed tracks are taken in turn by a camera with nothing better
+    threats = {
+        threatAt("a", 3, 270.0, 500.0, true),
+        threatAt("b", 3, 0.0, 500.0, true),
+        threatAt("c", 3, 180.0, 500.0, true),
+    };
+    scheduler.clear();
+    QSet<QString> visited;
+    for (int pass = 0; pass < 12; ++pass) {
+        now += 1000;
+        tasks = scheduler.schedule({west}, threats, now);
+        visited.insert(tasks.value("west"));
+    }
+    QCOMPARE(visited, QSet<QString>({"a", "b", "c"}));
+    
+    // Out of view of every camera: nothing is assigned
+    tasks = scheduler.schedule({west}, {threatAt("far", 5, 270.0, 5000.0, false)}, now + 1000);
+    QVERIFY(tasks.contains("west"));
+    QVERIFY(tasks.value("west").isEmpty());
+    
+    // Slew time follows the slower axis
+    TaskableCamera slow = west;
+    slow.panSpeed = 10.0;
+    QVERIFY(qAbs(CameraScheduler::slewTimeS(slow, threatAt("x", 1, 90.0, 500.0, false).position) - 9.0) < 0.1);
+}
+
+namespace {
+
+// Finds a drone whose confidence is the frame's first red value, plus a
+// bird and a weak drone for the filters to drop
+class FakeDetectorBackend : public VisualDetectorBackend {
+public:
+    QString name() const override { return QStringLiteral("test-batch"); }
+    bool isHardware() const override { return false; }
+    bool open(const DetectorModel& model) override { return model.path == "drone.onnx"; }
+    void close() override {}
+    int maxBatch() const override { return 4; }
+    bool infer(const QVector<VideoFrame>& batch, QVector<QVector<ImageDetection>>& results) override {
+        QThread::msleep(2);
+        for (const VideoFrame& frame : batch) {
+            const double confidence = frame.constBits(0)[0] / 255.0;
+            results.append(QVector<ImageDetection>{{QRectF(0.9, 0.9, 0.2, 0.2), confidence, "drone"},
+                                                    {QRectF(0.1, 0.1, 0.1, 0.1), 0.9, "bird"},
+                                                    {QRectF(0.5, 0.5, 0.1, 0.1), 0.2, "drone"}});
+        }
+        return true;
+    }
+};
+
+VideoFrame shadedFrame(int red) {
+    QImage image(64, 48, QImage::Format_RGB888);
+    image.fill(QColor(red, 0, 0));
+    return VideoFrame(image);
+}
+
+} // namespace
+
+void TestVideoPipeline::testVisualDetectorBatching() {
+    VisualDetector detector;
+    VisualDetectorConfig config;
+    config.model.path = "drone.onnx";
+    config.backend = "test-batch";
+    QVERIFY(!detector.start());    // Not registered yet
+
+    VisualDetectorRegistry::registerBackend("test-batch", 0, false,
+        []() { return std::unique_ptr<VisualDetectorBackend>(new FakeDetectorBackend); });
+    config.frameStride = 2;
+    config.batchTimeoutMs = 200;
+    config.classes = QStringList{"drone"};
+    detector.setConfig(config);
+    QVERIFY(detector.start());
+    QCOMPARE(detector.backendName(), QString("test-batch"));
+
+    QList<CameraDetection> found;
+    connect(&detector, &VisualDetector::cameraDetection, this,
+            [&found](const CameraDetection& detection) { found.append(detection); });
+
+    // Three cameras, four frames each: the stride takes frames 1 and 3, and
+    // frame 3 replaces frame 1 still waiting for the batch to fill
+    const qint64 captured = QDateTime::currentMSecsSinceEpoch() - 20;
+    const QStringList cameras = {"cam-a", "cam-b", "cam-c"};
+    for (int n = 1; n <= 4; ++n) {
+        for (const QString& camera : cameras) detector.submit(camera, shadedFrame(200), captured + n);
+    }
+    QTRY_COMPARE(found.size(), 3);
+    VisualDetectorStats stats = detector.stats();
+    QCOMPARE(stats.framesSubmitted, quint64(12));
+    QCOMPARE(stats.framesSkipped, quint64(6));
+    QCOMPARE(stats.framesDropped, quint64(3));
+    QCOMPARE(stats.framesInferred, quint64(3));
+    QCOMPARE(stats.batches, quint64(1));
+    QCOMPARE(stats.meanBatchSize, 3.0);
+    QVERIFY(stats.inferMeanMs >= 1.0);
+    QVERIFY(stats.latencyMeanMs >= 20.0);
+
+    QSet<QString> seen;
+    for (const CameraDetection& detection : found) {
+        seen.insert(detection.cameraId);
+        QCOMPARE(detection.objectClass, QString("drone"));
+        QCOMPARE(detection.frameNumber, qint64(3));
+        QCOMPARE(detection.timestamp, captured + 3);
+        QVERIFY(qAbs(detection.confidence - 200.0 / 255.0) < 1e-9);
+        QVERIFY(qAbs(detection.boundingBox.width() - 0.1) < 1e-9);     // Clipped to the frame
+    }
+    QCOMPARE(seen, QSet<QString>(cameras.begin(), cameras.end()));
+
+    // A full batch runs without waiting out the timeout; the backend caps it at four
+    config.batchTimeoutMs = 60000;
+    config.frameStride = 1;
+    detector.stop();
+    detector.setConfig(config);
+    QVERIFY(detector.start());
+    found.clear();
+    for (int i = 0; i < 5; ++i) detector.submit(QString("cam-%1").arg(i), shadedFrame(255), 0);
+    QTRY_COMPARE(found.size(), 4);
+    stats = detector.stats();
+    QCOMPARE(stats.batches, quint64(1));
+    QCOMPARE(stats.framesInferred, quint64(4));
+
+    // The fifth frame is still waiting; stopping does not wait it out
+    QElapsedTimer timer;
+    timer.start();
+    detector.stop();
+    QVERIFY(timer.elapsed() < 5000);
+    QVERIFY(!detector.isRunning());
+    VisualDetectorRegistry::unregisterBackend("test-batch");
+}
+
+namespace {
+
+// Textured background with a dark cross centred on (x, y), as YUV
+VideoFrame crossScene(double x, double y, bool withTarget = true) {
+    VideoFrame frame = VideoFrame::allocate(VideoPixelFormat::YUV420P, QSize(320, 240));
+    uchar* luma = frame.bits(0);
+    const int stride = frame.bytesPerLine(0);
+    quint32 seed = 777;
+    for (int row = 0; row < 240; ++row) {
+        for (int col = 0; col < 320; ++col) {
+            seed = seed * 1103515245u + 12345u;
+            luma[row * stride + col] = uchar(140 + ((seed >> 16) & 15) +
+                                             int(20 * std::sin(col * 0.05) * std::cos(row * 0.03)));
+        }
+    }
+    if (withTarget) {
+        const int cx = qRound(x), cy = qRound(y);
+        for (int dy = -8; dy < 8; ++dy) {
+            for (int dx = -12; dx < 12; ++dx) {
+                const int col = cx + dx, row = cy + dy;
+                if (col < 0 || col >= 320 || row < 0 || row >= 240) continue;
+                if (qAbs(dx) < 3 || qAbs(dy) < 3) luma[row * stride + col] = 30;
+            }
+        }
+    }
+    return frame;
+}
+
+} // namespace
+
+void TestVideoPipeline::testRoiTracking() {
+    // The tracker follows a target moving a few pixels a frame
+    CorrelationTracker tracker;
+    double x = 100.0, y = 120.0;
+    QVERIFY(tracker.init(crossScene(x, y), QRectF(x - 12, y - 8, 24, 16)));
+    QRectF box;
+    for (int frame = 0; frame < 30; ++frame) {
+        x += 3.0;
+        y += 1.0;
+        QVERIFY(tracker.update(crossScene(x, y), tracker.box(), box));
+        QVERIFY(QLineF(box.center(), QPointF(x, y)).length() < 2.0);
+    }
+    QVERIFY(tracker.peakToSidelobe() > 10.0);
+    const QRectF held = tracker.box();
+    QVERIFY(!tracker.update(crossScene(x, y, false), tracker.box(), box));
+    QCOMPARE(tracker.box(), held);
+
+    // A jump the window cannot see is found at the predicted box
+    CorrelationTracker jumping;
+    QVERIFY(jumping.init(crossScene(100, 120), QRectF(88, 112, 24, 16)));
+    QVERIFY(jumping.update(crossScene(160, 120), QRectF(148, 112, 24, 16), box));
+    QVERIFY(qAbs(box.center().x() - 160.0) < 1.5);
+
+    // The stage writes boxes back to the track between detector runs
+    TrackManager tracks;
+    GeoPosition site;
+    site.latitude = 51.0;
+    site.longitude = 0.0;
+    site.altitude = 50.0;
+    const QString trackId = tracks.createTrack(site, DetectionSource::Camera);
+    tracks.associateCamera(trackId, "cam");
+    BoundingBox detected;
+    detected.x = 88;
+    detected.y = 112;
+    detected.width = 24;
+    detected.height = 16;
+    detected.cameraId = "cam";
+    detected.timestamp = 1;
+    tracks.setTrackBoundingBox(trackId, detected);
+    QMetaObject::invokeMethod(&tracks, "processTrackCycle", Qt::DirectConnection);
+
+    RoiTrackingStage stage;
+    stage.setTrackManager(&tracks);
+    x = 100.0;
+    for (int frame = 0; frame < 10; ++frame, x += 4.0) {
+        stage.processFrame("cam", crossScene(x, 120.0), 1000 + frame);
+    }
+    BoundingBox followed = tracks.trackBoundingBox(trackId);
+    QVERIFY(qAbs(followed.x + followed.width / 2.0 - (x - 4.0)) <= 2.0);
+    QCOMPARE(followed.timestamp, qint64(1009));
+    RoiTrackingStats stats = stage.stats();
+    QCOMPARE(stats.initialised, quint64(1));
+    QCOMPARE(stats.updates, quint64(9));
+    QCOMPARE(stats.activeTracks, 1);
+    QVERIFY(stats.updateMeanUs > 0.0);
+
+    // A new detector box restarts the tracker from it
+    detected.x = 200;
+    detected.timestamp = 2;
+    tracks.setTrackBoundingBox(trackId, detected);
+    stage.processFrame("cam", crossScene(212.0, 120.0), 2000);
+    QCOMPARE(stage.stats().initialised, quint64(2));
+    stage.processFrame("cam", crossScene(212.0, 120.0, false), 2001);
+    QCOMPARE(stage.stats().lost, quint64(1));
+    QCOMPARE(stage.stats().activeTracks, 0);
+
+    // Predicted boxes project through the camera's pointing and field of view
+    PTZController ptz;
+    PTZConfig ptzConfig = ptz.config();
+    ptzConfig.horizontalFovDeg = 60.0;
+    ptz.setConfig(ptzConfig);
+    CameraSlewController slew;
+    slew.setPTZController("cam", &ptz, site, 0.0);
+    TrackSnapshot ahead;
+    ahead.position = CoordinateUtils::positionFromBearingDistance(site, 0.0, 1000.0);
+    ahead.position.altitude = site.altitude;
+    QRectF predicted;
+    QVERIFY(slew.predictedBox("cam", ahead, 0, 0, QSize(640, 480), QSizeF(20, 10), predicted));
+    QVERIFY(QLineF(predicted.center(), QPointF(320, 240)).length() < 0.5);
+    ahead.position = CoordinateUtils::positionFromBearingDistance(site, qRadiansToDegrees(std::atan(0.1)), 1000.0);
+    ahead.position.altitude = site.altitude;
+    QVERIFY(slew.predictedBox("cam", ahead, 0, 0, QSize(640, 480), QSizeF(20, 10), predicted));
+    const double focal = 320.0 / std::tan(qDegreesToRadians(30.0));
+    QVERIFY(qAbs(predicted.center().x() - (320.0 + 0.1 * focal)) < 1.0);
+    QVERIFY(!slew.predictedBox("other", ahead, 0, 0, QSize(640, 480), QSizeF(20, 10), predicted));
+}
+
+void TestVideoPipeline::testMotionCueing() {
+    // The vector kernels give the scalar result, tails included
+    quint32 seed = 99;
+    QVector<uchar> plane(67 * 9);
+    for (uchar& v : plane) {
+        seed = seed * 1103515245u + 12345u;
+        v = uchar(seed >> 16);
+    }
+    QVector<uchar> fast(33 * 4), exact(33 * 4);
+    MotionKernels::halve(plane.constData(), 67, 67, 9, fast.data(), 33);
+    MotionKernels::halveScalar(plane.constData(), 67, 67, 9, exact.data(), 33);
+    QCOMPARE(fast, exact);
+    QVector<uchar> background = plane.mid(1, 301), backgroundExact = background;
+    QVector<uchar> mask(301), maskExact(301);
+    QCOMPARE(MotionKernels::subtract(plane.constData(), background.data(), mask.data(), 301, 40, true),
+             MotionKernels::subtractScalar(plane.constData(), backgroundExact.data(), maskExact.data(),
+                                           301, 40, true));
+    QCOMPARE(mask, maskExact);
+    QCOMPARE(background, backgroundExact);
+
+    // A still scene settles into the background; a moving target is one blob
+    MotionDetector detector;
+    QVector<MotionBlob> blobs;
+    for (int frame = 0; frame < 30; ++frame) detector.process(crossScene(0, 0, false), blobs);
+    QVERIFY(blobs.isEmpty());
+    QCOMPARE(detector.maskSize(), QSize(80, 60));
+    double x = 100.0;
+    for (int frame = 0; frame < 8; ++frame, x += 6.0) {
+        QVERIFY(detector.process(crossScene(x, 120.0), blobs));
+        QCOMPARE(blobs.size(), 1);
+        const QPointF centre = QRectF(blobs.first().box).center();
+        QVERIFY(qAbs(centre.x() - x) <= 4.0);
+        QVERIFY(qAbs(centre.y() - 120.0) <= 4.0);
+    }
+
+    // A change over most of the view restarts the background instead
+    VideoFrame flash = VideoFrame::allocate(VideoPixelFormat::YUV420P, QSize(320, 240));
+    uchar* luma = flash.bits(0);
+    for (int row = 0; row < 240; ++row) std::fill_n(luma + row * flash.bytesPerLine(0), 320, uchar(250));
+    QVERIFY(!detector.process(flash, blobs));
+    QVERIFY(detector.reseeded());
+    QVERIFY(blobs.isEmpty());
+
+    // The stage cues a camera track along the blob's bearing
+    TrackManager tracks;
+    GeoPosition site;
+    site.latitude = 51.0;
+    site.longitude = 0.0;
+    site.altitude = 50.0;
+    MotionCueCamera camera;
+    camera.cameraId = "fixed";
+    camera.mount = site;
+    camera.headingDeg = 90.0;
+    camera.horizontalFovDeg = 60.0;
+    camera.cueRangeM = 1000.0;
+
+    MotionCueStage stage;
+    stage.setTrackManager(&tracks);
+    stage.addCamera(camera);
+    int detections = 0;
+    QString objectClass;
+    connect(&stage, &MotionCueStage::cameraDetection, this, [&](const CameraDetection& detection) {
+        ++detections;
+        objectClass = detection.objectClass;
+    });
+    for (int frame = 0; frame < 30; ++frame) stage.processFrame("fixed", crossScene(0, 0, false), frame);
+    QCOMPARE(detections, 0);
+    x = 100.0;
+    for (int frame = 0; frame < 8; ++frame, x += 2.0) {
+        stage.processFrame("fixed", crossScene(x, 120.0), 100 + frame);
+    }
+    QCOMPARE(detections, 8);
+    QCOMPARE(objectClass, QString("motion"));
+    QCOMPARE(tracks.trackCount(), 1);
+    Track* cued = tracks.allTracks().first();
+    QCOMPARE(cued->associatedCameraId(), QString("fixed"));
+    const EnuVector enu = LocalTangentPlane(site).toEnu(cued->position());
+    const double bearing = qRadiansToDegrees(std::atan2(enu.east, enu.north));
+    QVERIFY(qAbs(bearing - (90.0 + (100.0 / 320.0 - 0.5) * 60.0)) < 1.0);
+    QVERIFY(qAbs(enu.range() - 1000.0) < 5.0);
+    const MotionCueStats stats = stage.stats();
+    QCOMPARE(stats.cues, quint64(8));
+    QCOMPARE(stats.frames, quint64(38));
+    QVERIFY(stats.processMeanUs > 0.0);
+}
+
+void TestVideoPipeline::testCameraFusion() {
+    GeoPosition west;
+    west.latitude = 51.0;
+    west.longitude = 0.0;
+    west.altitude = 20.0;
+    const GeoPosition east = CoordinateUtils::positionFromBearingDistance(west, 90.0, 600.0);
+    const GeoPosition mast = west;
+    GeoPosition target = CoordinateUtils::positionFromBearingDistance(west, 45.0, 800.0);
+    target.altitude = 150.0;
+    auto sightingOf = [&](const QString& cameraId, const GeoPosition& mount, const GeoPosition& at,
+                          double confidence) {
+        const EnuVector enu = LocalTangentPlane(mount).toEnu(at);
+        CameraSighting sighting;
+        sighting.cameraId = cameraId;
+        sighting.box.cameraId = cameraId;
+        sighting.box.width = sighting.box.height = 8;
+        sighting.mount = mount;
+        sighting.azimuthDeg = enu.azimuthDeg();
+        sighting.elevationDeg = enu.elevationDeg();
+        sighting.estimate = LocalTangentPlane(mount).toGeo(EnuVector{enu.east * 1.5, enu.north * 1.5, enu.up * 1.5});
+        sighting.confidence = confidence;
+        sighting.timestamp = 1000;
+        return sighting;
+    };
+
+    // Two cameras far apart on one object give one fix where their rays cross
+    CameraDetectionFuser fuser;
+    fuser.addSighting(sightingOf("west", west, target, 0.6), 0);
+    fuser.addSighting(sightingOf("east", east, target, 0.8), 0);
+    GeoPosition elsewhere = CoordinateUtils::positionFromBearingDistance(west, 135.0, 700.0);
+    elsewhere.altitude = 100.0;
+    fuser.addSighting(sightingOf("east", east, elsewhere, 0.7), 0);
+    QCOMPARE(fuser.pendingGroups(), 2);
+    QVERIFY(fuser.flush(50).isEmpty());
+    QVector<FusedCameraDetection> fused = fuser.flush(100);
+    QCOMPARE(fused.size(), 2);
+    QCOMPARE(fused[0].boxes.size(), 2);
+    QCOMPARE(fused[0].boxes.first().cameraId, QString("east"));
+    QVERIFY(fused[0].triangulated);
+    QVERIFY(fused[0].residualM < 0.5);
+    QVERIFY(LocalTangentPlane(target).toEnu(fused[0].position).range() < 1.0);
+    QVERIFY(qAbs(fused[0].confidence - 0.92) < 1e-9);
+    QCOMPARE(fused[1].boxes.size(), 1);
+    QVERIFY(!fused[1].triangulated);
+    QCOMPARE(fused.first().timestamp, qint64(1000));
+
+    // Cameras on one mast still merge, but cannot range it; late captures do not
+    fuser.addSighting(sightingOf("west", west, target, 0.9), 0);
+    fuser.addSighting(sightingOf("mast", mast, target, 0.5), 0);
+    CameraSighting late = sightingOf("east", east, target, 0.5);
+    late.timestamp += 500;
+    fuser.addSighting(late, 0);
+    fused = fuser.flush(0, true);
+    QCOMPARE(fused.size(), 2);
+    QCOMPARE(fused[0].boxes.size(), 2);
+    QVERIFY(!fused[0].triangulated);
+    QCOMPARE(fused[0].position.latitude, sightingOf("west", west, target, 0.9).estimate.latitude);
+    QCOMPARE(fuser.stats().sightingsIn, qint64(6));
+    QCOMPARE(fuser.stats().sightingsMerged, qint64(2));
+    QCOMPARE(fuser.stats().triangulated, qint64(1));
+
+    // One track per object, kept by the camera that first followed it
+    TrackManager tracks;
+    QVector<BoundingBox> boxes;
+    for (const QString& id : {QString("east"), QString("west")}) {
+        BoundingBox box;
+        box.cameraId = id;
+        box.width = box.height = 8;
+        boxes.append(box);
+    }
+    tracks.processCameraDetection(boxes, target, 1000);
+    QCOMPARE(tracks.trackCount(), 1);
+    Track* cued = tracks.allTracks().first();
+    QCOMPARE(cued->associatedCameraId(), QString("east"));
+    boxes = {boxes[1], boxes[0]};
+    tracks.processCameraDetection(boxes, target, 1100);
+    QCOMPARE(tracks.trackCount(), 1);
+    QCOMPARE(cued->associatedCameraId(), QString("east"));
+}
+
+void TestVideoPipeline::testThermalProcessing() {
+    // A 14-bit scene near 7000 counts with a hot target at 12000
+    const QSize size(160, 128);
+    QVector<quint16> raw(size.width() * size.height());
+    quint32 seed = 7;
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            seed = seed * 1103515245u + 12345u;
+            const bool hot = x >= 70 && x < 90 && y >= 54 && y < 74;
+            raw[y * size.width() + x] = quint16((hot ? 12000 : 7000 + y * 4) + int((seed >> 16) & 15));
+        }
+    }
+    const int stride = size.width() * 2;
+
+    ThermalConfig config;
+    config.agcSmoothing = 1.0;
+    ThermalProcessor processor(config);
+    VideoFrame frame = processor.process(raw.constData(), stride, size);
+    QCOMPARE(frame.size(), size);
+    QCOMPARE(frame.pixelFormat(), VideoPixelFormat::YUV420P);
+    QCOMPARE(int(frame.constBits(1)[0]), 128);
+    QVERIFY(processor.windowLow() >= 7000 && processor.windowLow() < 7100);
+    QVERIFY(processor.windowHigh() > 7400 && processor.windowHigh() <= 12015);
+    const auto luma = [](const VideoFrame& f, int x, int y) {
+        return int(f.constBits(0)[y * f.bytesPerLine(0) + x]);
+    };
+    QVERIFY(luma(frame, 80, 64) > 200);
+    QVERIFY(luma(frame, 10, 10) < luma(frame, 80, 64));
+
+    // Black-hot inverts; a colour palette gives RGB32
+    config.palette = ThermalPalette::BlackHot;
+    config.localContrast = false;
+    processor.setConfig(config);
+    frame = processor.process(raw.constData(), stride, size);
+    QVERIFY(luma(frame, 80, 64) < 50);
+    QVERIFY(luma(frame, 10, 10) > luma(frame, 80, 64));
+    config.palette = ThermalPalette::Ironbow;
+    processor.setConfig(config);
+    frame = processor.process(raw.constData(), stride, size);
+    QCOMPARE(frame.pixelFormat(), VideoPixelFormat::RGB32);
+    QVERIFY(processor.latency().count == 3);
+
+    // The window eases toward a new scene instead of jumping
+    config.agcSmoothing = 0.1;
+    processor.setConfig(config);
+    const int before = processor.windowLow();
+    for (quint16& v : raw) v = quint16(v + 2000);
+    processor.process(raw.constData(), stride, size);
+    QVERIFY(processor.windowLow() > before);
+    QVERIFY(processor.windowLow() < before + 1000);
+}
+
+void TestVideoPipeline::testSimulatedSceneRendering() {
+    FramePool pool;
+    SimulatedSceneRenderer renderer(pool);
+    SimulatedSceneState state;
+    state.cameraName = "SIM-CAM-001";
+    state.frameCount = 7;
+    state.targetPhase = 1.2;
+    state.time = QDateTime(QDate(2024, 1, 1), QTime(12, 0));
+
+    // Each scenario renders at its own size, the same state to the same pixels
+    const QSize sizes[] = { QSize(1280, 720), QSize(1280, 720), QSize(720, 720) };
+    for (int type = 0; type < 3; ++type) {
+        state.scenarioType = type;
+        QImage first = renderer.render(state);
+        QCOMPARE(first.size(), sizes[type]);
+        QCOMPARE(first.format(), QImage::Format_RGB888);
+        QImage copy = first.copy();
+        first = QImage();
+        QCOMPARE(renderer.render(state), copy);
+    }
+
+    // Frames after the first come from recycled buffers
+    state.scenarioType = 0;
+    renderer.render(state);
+    const FramePool::Stats before = pool.stats();
+    for (int frame = 0; frame < 10; ++frame) {
+        state.frameCount++;
+        state.targetPhase += 0.05;
+        QVERIFY(!renderer.render(state).isNull());
+    }
+    const FramePool::Stats after = pool.stats();
+    QCOMPARE(after.allocated, before.allocated);
+    QCOMPARE(after.reused, before.reused + 10);
+    QCOMPARE(after.outstanding, 0);
+
+    // The terrain pans while the reticle stays put
+    state.targetVisible = false;
+    state.showOverlay = false;
+    state.frameCount = 0;
+    QImage still = renderer.render(state).copy();
+    state.frameCount = 10;
+    QImage panned = renderer.render(state);
+    QVERIFY(still != panned);
+    QCOMPARE(still.pixel(640, 360), panned.pixel(640, 360));
+
+    // The thermal noise cycles through its pre-rendered fields
+    state.scenarioType = 1;
+    state.frameCount = 0;
+    QImage field = renderer.render(state).copy();
+    state.frameCount = SimulatedSceneRenderer::THERMAL_NOISE_FIELDS;
+    QCOMPARE(renderer.render(state), field);
+    state.frameCount = 1;
+    QVERIFY(renderer.render(state) != field);
+}
+
 #include "test_video_pipeline.moc"